@@ -12,7 +12,9 @@
  */
 #include <ctype.h>
 #include <getopt.h>
+#include <math.h>
 #include <netinet/in.h>
+#include <pthread.h>
 #include <stdarg.h>
 #include <unistd.h>
 #include "arrow_ipc.h"
@@ -49,7 +51,9 @@ static const char  *output_filename = NULL;
 static FILE		   *output_filp = NULL;
 static bool			print_header = false;
 static char			csv_delimiter = ',';
-static char			current_context = 'n';
+static __thread char current_context = 'n';
+static const char  *current_tz_name = NULL;
+static int			num_threads = -1;			/* --threads */
 static int64_t		num_skip_rows = -1;			/* --offset */
 static int64_t		num_dump_rows = -1;			/* --limit */
 static const char  *create_table_name = NULL;	/* --create-table */
@@ -66,6 +70,8 @@ usage(void)
 		  "  --header       dump column names as csv header\n"
 		  "  --offset NUM   skip first NUM rows\n"
 		  "  --limit NUM    dump only NUM rows\n"
+		  "  -t|--threads=N number of threads to format rows\n"
+		  "                 (default: number of CPUs)\n"
 		  "\n"
 		  "  --create-table=TABLE_NAME  dump with CREATE TABLE statement\n"
 		  "  --tablespace=TABLESPACE    specify tablespace of the table, if any\n"
@@ -143,12 +149,233 @@ quote_ident(const char *ident)
 	return ident;
 }
 
+/*
+ * Output buffer of the current thread
+ *
+ * Worker threads format record batches into their own buffer, then the
+ * main thread writes out them in order of the source.
+ */
+static __thread SQLbuffer *output_buf = NULL;
+
+static inline void
+__out_putc(int c)
+{
+	if (output_buf->usage >= output_buf->length)
+		sql_buffer_expand(output_buf, output_buf->usage + 1);
+	output_buf->data[output_buf->usage++] = c;
+}
+
+static inline void
+__out_write(const char *str, size_t len)
+{
+	sql_buffer_append(output_buf, str, len);
+}
+
+static inline void
+__out_puts(const char *str)
+{
+	__out_write(str, strlen(str));
+}
+
+static void
+__out_printf(const char *fmt, ...)
+{
+	va_list		ap;
+	int			sz;
+
+	for (;;)
+	{
+		sql_buffer_expand(output_buf, output_buf->usage + 256);
+		va_start(ap, fmt);
+		sz = vsnprintf(output_buf->data + output_buf->usage,
+					   output_buf->length - output_buf->usage,
+					   fmt, ap);
+		va_end(ap);
+		if (sz < 0)
+			Elog("failed on vsnprintf: %m");
+		if (output_buf->usage + sz < output_buf->length)
+			break;
+		sql_buffer_expand(output_buf, output_buf->usage + sz + 1);
+	}
+	output_buf->usage += sz;
+}
+
+/* fast formatters, instead of printf */
+static inline void
+__out_uint64(uint64_t ival)
+{
+	char	buf[24];
+	char   *pos = buf + sizeof(buf);
+
+	do {
+		*--pos = '0' + (ival % 10);
+		ival /= 10;
+	} while (ival != 0);
+	__out_write(pos, buf + sizeof(buf) - pos);
+}
+
+static inline void
+__out_int64(int64_t ival)
+{
+	if (ival >= 0)
+		__out_uint64(ival);
+	else
+	{
+		__out_putc('-');
+		__out_uint64(-(uint64_t)ival);
+	}
+}
+
+/* zero-padded digits */
+static inline void
+__out_digits(uint32_t ival, int width)
+{
+	char	buf[16];
+	char   *pos = buf + width;
+
+	assert(width <= sizeof(buf));
+	while (pos > buf)
+	{
+		*--pos = '0' + (ival % 10);
+		ival /= 10;
+	}
+	__out_write(buf, width);
+}
+
+/*
+ * __civil_from_days - to year/month/day from the days since 1970-01-01
+ * (proleptic Gregorian calendar), without gmtime_r
+ */
+static inline void
+__civil_from_days(int64_t days, int *p_year, int *p_mon, int *p_day)
+{
+	int64_t		era, doe, yoe, doy, mp;
+
+	days += 719468;
+	era = (days >= 0 ? days : days - 146096) / 146097;
+	doe = days - era * 146097;
+	yoe = (doe - doe/1460 + doe/36524 - doe/146096) / 365;
+	doy = doe - (365*yoe + yoe/4 - yoe/100);
+	mp = (5*doy + 2) / 153;
+	*p_day = doy - (153*mp + 2) / 5 + 1;
+	*p_mon = (mp < 10 ? mp + 3 : mp - 9);
+	*p_year = yoe + era * 400 + (*p_mon <= 2 ? 1 : 0);
+}
+
+/* YYYY-MM-DD */
+static inline void
+__out_date(int year, int mon, int day)
+{
+	if (year >= 0 && year <= 9999)
+		__out_digits(year, 4);
+	else
+		__out_printf("%04d", year);
+	__out_putc('-');
+	__out_digits(mon, 2);
+	__out_putc('-');
+	__out_digits(day, 2);
+}
+
+/* HH:MI:SS */
+static inline void
+__out_time(uint32_t hour, uint32_t min, uint32_t sec)
+{
+	if (hour < 100)
+		__out_digits(hour, 2);
+	else
+		__out_uint64(hour);
+	__out_putc(':');
+	__out_digits(min, 2);
+	__out_putc(':');
+	__out_digits(sec, 2);
+}
+
+/*
+ * YYYY-MM-DD HH:MI:SS[.fraction] of the 'datum' in 1/'unit' seconds
+ * since the epoch
+ */
+static inline void
+__out_timestamp(int64_t datum, int64_t unit, int ndigits, bool localtime)
+{
+	int64_t		secs = datum / unit;
+	int64_t		frac = datum % unit;
+
+	if (frac < 0)
+	{
+		frac += unit;
+		secs--;
+	}
+	if (localtime)
+	{
+		time_t		t = secs;
+		struct tm	tm;
+
+		localtime_r(&t, &tm);
+		__out_date(tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday);
+		__out_putc(' ');
+		__out_time(tm.tm_hour, tm.tm_min, tm.tm_sec);
+	}
+	else
+	{
+		int64_t		days = secs / 86400;
+		int64_t		rem = secs % 86400;
+		int			year, mon, day;
+
+		if (rem < 0)
+		{
+			rem += 86400;
+			days--;
+		}
+		__civil_from_days(days, &year, &mon, &day);
+		__out_date(year, mon, day);
+		__out_putc(' ');
+		__out_time(rem / 3600, (rem / 60) % 60, rem % 60);
+	}
+	if (ndigits > 0)
+	{
+		__out_putc('.');
+		__out_digits(frac, ndigits);
+	}
+}
+
+/*
+ * __out_float8 - same as printf("%f")
+ *
+ * If the value is small enough, the value * 10^6 has at most 2^-13 of
+ * rounding error, so it is rounded to the nearest integer correctly unless
+ * it is very close to the half; elsewhere, it falls back to printf.
+ */
+static inline void
+__out_float8(double fval)
+{
+	double		scaled = fabs(fval * 1000000.0);
+
+	if (scaled < 1099511627776.0)		/* 2^40 */
+	{
+		uint64_t	ival = (uint64_t)scaled;
+		double		frac = scaled - (double)ival;
+
+		if (fabs(frac - 0.5) > (1.0 / 4096.0))
+		{
+			if (frac > 0.5)
+				ival++;
+			if (signbit(fval))
+				__out_putc('-');
+			__out_uint64(ival / 1000000);
+			__out_putc('.');
+			__out_digits(ival % 1000000, 6);
+			return;
+		}
+	}
+	__out_printf("%f", fval);
+}
+
 static void
 printNullDatum(void)
 {
 	/* print "null" only if List elements */
 	if (current_context == 'e')
-		fprintf(output_filp, "null");
+		__out_puts("null");
 }
 
 static void
@@ -252,7 +479,7 @@ static bool
 print_arrow_int8(ARROW_PRINT_DATUM_ARGS)
 {
 	ARROW_PRINT_DATUM_SETUP_INLINE(int8_t);
-	fprintf(output_filp, "%d", (int)datum);
+	__out_int64(datum);
 	return true;
 }
 
@@ -260,7 +487,7 @@ static bool
 print_arrow_uint8(ARROW_PRINT_DATUM_ARGS)
 {
 	ARROW_PRINT_DATUM_SETUP_INLINE(uint8_t);
-	fprintf(output_filp, "%u", (unsigned int)datum);
+	__out_uint64(datum);
 	return true;
 }
 
@@ -268,7 +495,7 @@ static bool
 print_arrow_int16(ARROW_PRINT_DATUM_ARGS)
 {
 	ARROW_PRINT_DATUM_SETUP_INLINE(int16_t);
-	fprintf(output_filp, "%d", (int)datum);
+	__out_int64(datum);
 	return true;
 }
 
@@ -276,7 +503,7 @@ static bool
 print_arrow_uint16(ARROW_PRINT_DATUM_ARGS)
 {
 	ARROW_PRINT_DATUM_SETUP_INLINE(uint16_t);
-	fprintf(output_filp, "%u", (unsigned int)datum);
+	__out_uint64(datum);
 	return true;
 }
 
@@ -284,7 +511,7 @@ static bool
 print_arrow_int32(ARROW_PRINT_DATUM_ARGS)
 {
 	ARROW_PRINT_DATUM_SETUP_INLINE(int32_t);
-	fprintf(output_filp, "%d", datum);
+	__out_int64(datum);
 	return true;
 }
 
@@ -292,7 +519,7 @@ static bool
 print_arrow_uint32(ARROW_PRINT_DATUM_ARGS)
 {
 	ARROW_PRINT_DATUM_SETUP_INLINE(uint32_t);
-	fprintf(output_filp, "%u", datum);
+	__out_uint64(datum);
 	return true;
 }
 
@@ -300,7 +527,7 @@ static bool
 print_arrow_int64(ARROW_PRINT_DATUM_ARGS)
 {
 	ARROW_PRINT_DATUM_SETUP_INLINE(int64_t);
-	fprintf(output_filp, "%ld", datum);
+	__out_int64(datum);
 	return true;
 }
 
@@ -308,7 +535,7 @@ static bool
 print_arrow_uint64(ARROW_PRINT_DATUM_ARGS)
 {
 	ARROW_PRINT_DATUM_SETUP_INLINE(uint64_t);
-	fprintf(output_filp, "%lu", datum);
+	__out_uint64(datum);
 	return true;
 }
 
@@ -316,7 +543,7 @@ static bool
 print_arrow_float2(ARROW_PRINT_DATUM_ARGS)
 {
 	ARROW_PRINT_DATUM_SETUP_INLINE(uint16_t);
-	fprintf(output_filp, "%f", fp16_to_fp64(datum));
+	__out_float8(fp16_to_fp64(datum));
 	return true;
 }
 
@@ -324,7 +551,7 @@ static bool
 print_arrow_float4(ARROW_PRINT_DATUM_ARGS)
 {
 	ARROW_PRINT_DATUM_SETUP_INLINE(float);
-	fprintf(output_filp, "%f", (double)datum);
+	__out_float8((double)datum);
 	return true;
 }
 
@@ -332,25 +559,26 @@ static bool
 print_arrow_float8(ARROW_PRINT_DATUM_ARGS)
 {
 	ARROW_PRINT_DATUM_SETUP_INLINE(double);
-	fprintf(output_filp, "%f", datum);
+	__out_float8(datum);
 	return true;
 }
 
 static bool
 __print_arrow_utf8_common(const char *addr, size_t sz, const char *quote)
 {
-	size_t	i;
+	const char *end = addr + sz;
+	const char *pos;
 
-	fprintf(output_filp, "%s", quote);
-	for (i=0; i < sz; i++)
+	__out_puts(quote);
+	while ((pos = memchr(addr, '"', end - addr)) != NULL)
 	{
-		int		c = (unsigned char)addr[i];
-
-		if (c == '"')
-			fputc('"', output_filp);
-		fputc(c, output_filp);
+		/* doubles the quotation mark */
+		__out_write(addr, pos - addr + 1);
+		__out_putc('"');
+		addr = pos + 1;
 	}
-	fprintf(output_filp, "%s", quote);
+	__out_write(addr, end - addr);
+	__out_puts(quote);
 	return true;
 }
 
@@ -382,17 +610,21 @@ static bool
 __print_arrow_binary_common(const char *addr, size_t sz, const char *quote)
 {
 	static const char hextbl[] = "0123456789abcdef";
+	char	   *pos;
 	size_t	i;
 
-	fprintf(output_filp, "%s\\x", quote);
+	__out_printf("%s\\x", quote);
+	sql_buffer_expand(output_buf, output_buf->usage + 2 * sz);
+	pos = output_buf->data + output_buf->usage;
 	for (i=0; i < sz; i++)
 	{
 		int		c = (unsigned char)addr[i];
 
-		fputc(hextbl[(c >> 4) & 0x0f], output_filp);
-		fputc(hextbl[(c & 0x0f)], output_filp);
+		*pos++ = hextbl[(c >> 4) & 0x0f];
+		*pos++ = hextbl[(c & 0x0f)];
 	}
-	fprintf(output_filp, "%s", quote);
+	output_buf->usage += 2 * sz;
+	__out_puts(quote);
 	return true;
 }
 
@@ -431,9 +663,9 @@ print_arrow_bool(ARROW_PRINT_DATUM_ARGS)
 		return false;
 
 	if ((bitmap[k] & mask) != 0)
-		fprintf(output_filp, "true");
+		__out_puts("true");
 	else
-		fprintf(output_filp, "false");
+		__out_puts("false");
 	return true;
 }
 
@@ -456,12 +688,12 @@ print_arrow_decimal128(ARROW_PRINT_DATUM_ARGS)
 	/* zero handling */
 	if (datum == 0)
 	{
-		fputc('0', output_filp);
+		__out_putc('0');
 		if (scale > 0)
 		{
-			fputc('.', output_filp);
+			__out_putc('.');
 			while (scale-- > 0)
-				fputc('0', output_filp);
+				__out_putc('0');
 		}
 		return true;
 	}
@@ -508,138 +740,111 @@ print_arrow_decimal128(ARROW_PRINT_DATUM_ARGS)
 
 	if (negative)
 		*--pos = '-';
-	fprintf(output_filp, "%s", pos);
+	__out_puts(pos);
 	return true;
 }
 
 static bool
 print_arrow_date_day(ARROW_PRINT_DATUM_ARGS)
 {
-	time_t		t;
-	struct tm	tm;
-	ARROW_PRINT_DATUM_SETUP_INLINE(uint32_t);
-	/* to seconds from the epoch */
-	t = (time_t)datum * 86400LL;
-	gmtime_r(&t, &tm);
-	fprintf(output_filp, "%s%04d-%02d-%02d%s",
-			quote,
-			tm.tm_year + 1900,
-			tm.tm_mon + 1,
-			tm.tm_mday,
-			quote);
+	int			year, mon, day;
+	ARROW_PRINT_DATUM_SETUP_INLINE(int32_t);
+
+	__civil_from_days(datum, &year, &mon, &day);
+	__out_puts(quote);
+	__out_date(year, mon, day);
+	__out_puts(quote);
 	return true;
 }
 
 static bool
 print_arrow_date_ms(ARROW_PRINT_DATUM_ARGS)
 {
-	time_t		t;
-	struct tm	tm;
-	uint32_t	msec;
-	ARROW_PRINT_DATUM_SETUP_INLINE(uint64_t);
+	ARROW_PRINT_DATUM_SETUP_INLINE(int64_t);
 
-	msec = datum % 1000;
-	t = datum / 1000;
-	gmtime_r(&t, &tm);
-	fprintf(output_filp, "%s%04d-%02d-%02d %02d:%02d:%02d.%03d%s",
-			quote,
-			tm.tm_year + 1900,
-			tm.tm_mon + 1,
-			tm.tm_mday,
-			tm.tm_hour,
-			tm.tm_min,
-			tm.tm_sec,
-			msec,
-			quote);
+	__out_puts(quote);
+	__out_timestamp(datum, 1000, 3, false);
+	__out_puts(quote);
 	return true;
 }
 
 static bool
 print_arrow_time_sec(ARROW_PRINT_DATUM_ARGS)
 {
-	uint32_t	min, sec;
 	ARROW_PRINT_DATUM_SETUP_INLINE(uint32_t);
 
-	sec = datum % 60;
-	datum /= 60;
-	min = datum % 60;
-	datum /= 60;
-	fprintf(output_filp, "%s%02u:%02u:%02u%s",
-			quote,
-			datum, min, sec,
-			quote);
+	__out_puts(quote);
+	__out_time(datum / 3600, (datum / 60) % 60, datum % 60);
+	__out_puts(quote);
 	return true;
 }
 
 static bool
 print_arrow_time_ms(ARROW_PRINT_DATUM_ARGS)
 {
-	uint32_t	min, sec, ms;
+	uint32_t	ms;
 	ARROW_PRINT_DATUM_SETUP_INLINE(uint32_t);
 
 	ms = datum % 1000;
 	datum /= 1000;
-	sec = datum % 60;
-	datum /= 60;
-	min = datum % 60;
-	datum /= 60;
-	fprintf(output_filp, "%s%02u:%02u:%02u.%03u%s",
-			quote,
-			datum, min, sec, ms,
-			quote);
+	__out_puts(quote);
+	__out_time(datum / 3600, (datum / 60) % 60, datum % 60);
+	__out_putc('.');
+	__out_digits(ms, 3);
+	__out_puts(quote);
 	return true;
 }
 
 static bool
 print_arrow_time_us(ARROW_PRINT_DATUM_ARGS)
 {
-	uint32_t	min, sec, us;
+	uint32_t	us;
 	ARROW_PRINT_DATUM_SETUP_INLINE(uint64_t);
 
 	us = datum % 1000000;
 	datum /= 1000000;
-	sec = datum % 60;
-	datum /= 60;
-	min = datum % 60;
-	datum /= 60;
-	fprintf(output_filp, "%s%02d:%02d:%02d.%06d%s",
-			quote,
-			(uint32_t)datum, min, sec, us,
-			quote);
+	__out_puts(quote);
+	__out_time((uint32_t)(datum / 3600), (datum / 60) % 60, datum % 60);
+	__out_putc('.');
+	__out_digits(us, 6);
+	__out_puts(quote);
 	return true;
 }
 
 static bool
 print_arrow_time_ns(ARROW_PRINT_DATUM_ARGS)
 {
-	uint32_t	min, sec, ns;
+	uint32_t	ns;
 	ARROW_PRINT_DATUM_SETUP_INLINE(uint64_t);
 
 	ns = datum % 1000000000;
 	datum /= 1000000000;
-	sec = datum % 60;
-	datum /= 60;
-	min = datum % 60;
-	datum /= 60;
-	fprintf(output_filp, "%s%02d:%02d:%02d.%09d%s",
-			quote,
-			(uint32_t)datum, min, sec, ns,
-			quote);
+	__out_puts(quote);
+	__out_time((uint32_t)(datum / 3600), (datum / 60) % 60, datum % 60);
+	__out_putc('.');
+	__out_digits(ns, 9);
+	__out_puts(quote);
 	return true;
 }
 
+/*
+ * __assign_timestamp_timezone
+ *
+ * It switches TZ only if the timezone is different from the current one.
+ * main() assigns it prior to launch the worker threads, and runs a single
+ * thread if multiple timezones are used, so the workers never call setenv.
+ */
 static bool
 __assign_timestamp_timezone(ArrowTypeTimestamp *timestamp)
 {
-	static const char  *current_tz_name = NULL;
-
 	if (!timestamp->timezone)
 		return false;
 	if (!current_tz_name || strcmp(current_tz_name, timestamp->timezone) != 0)
 	{
 		if (setenv("TZ", timestamp->timezone, 1) != 0)
 			Elog("failed on setenv('TZ'): %m");
-        current_tz_name = timestamp->timezone;
+		tzset();
+		current_tz_name = timestamp->timezone;
 	}
 	return true;
 }
@@ -647,112 +852,48 @@ __assign_timestamp_timezone(ArrowTypeTimestamp *timestamp)
 static bool
 print_arrow_timestamp_sec(ARROW_PRINT_DATUM_ARGS)
 {
-	time_t		t;
-	struct tm	tm;
-	ARROW_PRINT_DATUM_SETUP_INLINE(uint64_t);
+	ARROW_PRINT_DATUM_SETUP_INLINE(int64_t);
 
-	t = (time_t)datum;
-	if (!__assign_timestamp_timezone(&column->arrow_type.Timestamp))
-		gmtime_r(&t, &tm);
-	else
-		localtime_r(&t, &tm);
-	fprintf(output_filp,
-			"%s%04d-%02d-%02d %02d:%02d:%02d%s",
-			quote,
-			tm.tm_year + 1900,
-			tm.tm_mon + 1,
-			tm.tm_mday,
-			tm.tm_hour,
-			tm.tm_min,
-			tm.tm_sec,
-			quote);
+	__out_puts(quote);
+	__out_timestamp(datum, 1, 0,
+					__assign_timestamp_timezone(&column->arrow_type.Timestamp));
+	__out_puts(quote);
 	return true;
 }
 
 static bool
 print_arrow_timestamp_ms(ARROW_PRINT_DATUM_ARGS)
 {
-	time_t		t;
-	struct tm	tm;
-	uint32_t	ms;
-	ARROW_PRINT_DATUM_SETUP_INLINE(uint64_t);
+	ARROW_PRINT_DATUM_SETUP_INLINE(int64_t);
 
-	ms = datum % 1000;
-	datum /= 1000;
-	t = (time_t)datum;
-	if (!__assign_timestamp_timezone(&column->arrow_type.Timestamp))
-		gmtime_r(&t, &tm);
-	else
-		localtime_r(&t, &tm);
-	fprintf(output_filp,
-			"%s%04d-%02d-%02d %02d:%02d:%02d.%03u%s",
-			quote,
-			tm.tm_year + 1900,
-			tm.tm_mon + 1,
-			tm.tm_mday,
-			tm.tm_hour,
-			tm.tm_min,
-			tm.tm_sec,
-			ms,
-			quote);
+	__out_puts(quote);
+	__out_timestamp(datum, 1000, 3,
+					__assign_timestamp_timezone(&column->arrow_type.Timestamp));
+	__out_puts(quote);
 	return true;
 }
 
 static bool
 print_arrow_timestamp_us(ARROW_PRINT_DATUM_ARGS)
 {
-	time_t		t;
-	struct tm	tm;
-	uint32_t	us;
-	ARROW_PRINT_DATUM_SETUP_INLINE(uint64_t);
+	ARROW_PRINT_DATUM_SETUP_INLINE(int64_t);
 
-	us = datum % 1000000;
-	datum /= 1000000;
-	t = (time_t)datum;
-	if (!__assign_timestamp_timezone(&column->arrow_type.Timestamp))
-		gmtime_r(&t, &tm);
-	else
-		localtime_r(&t, &tm);
-	fprintf(output_filp,
-			"%s%04d-%02d-%02d %02d:%02d:%02d.%06u%s",
-			quote,
-			tm.tm_year + 1900,
-			tm.tm_mon + 1,
-			tm.tm_mday,
-			tm.tm_hour,
-			tm.tm_min,
-			tm.tm_sec,
-			us,
-			quote);
+	__out_puts(quote);
+	__out_timestamp(datum, 1000000, 6,
+					__assign_timestamp_timezone(&column->arrow_type.Timestamp));
+	__out_puts(quote);
 	return true;
 }
 
 static bool
 print_arrow_timestamp_ns(ARROW_PRINT_DATUM_ARGS)
 {
-	time_t		t;
-	struct tm	tm;
-	uint32_t	ns;
-	ARROW_PRINT_DATUM_SETUP_INLINE(uint64_t);
+	ARROW_PRINT_DATUM_SETUP_INLINE(int64_t);
 
-	ns = datum % 1000000000;
-	datum /= 1000000000;
-	t = (time_t)datum;
-	if (!__assign_timestamp_timezone(&column->arrow_type.Timestamp))
-		gmtime_r(&t, &tm);
-	else
-		localtime_r(&t, &tm);
-	fprintf(output_filp,
-			"%s%04d-%02d-%02d %02d:%02d:%02d.%09u%s",
-			quote,
-			tm.tm_year + 1900,
-			tm.tm_mon + 1,
-			tm.tm_mday,
-			tm.tm_hour,
-			tm.tm_min,
-			tm.tm_sec,
-			ns,
-			quote);
+	__out_puts(quote);
+	__out_timestamp(datum, 1000000000, 9,
+					__assign_timestamp_timezone(&column->arrow_type.Timestamp));
+	__out_puts(quote);
 	return true;
 }
 
@@ -770,20 +911,20 @@ print_arrow_interval_ym(ARROW_PRINT_DATUM_ARGS)
 	}
 	year = datum / 12;
 	mon = datum % 12;
-	fprintf(output_filp, "%s", quote);
+	__out_puts(quote);
 	if (year != 0 && mon != 0)
-		fprintf(output_filp, "%d %s %d %s",
+		__out_printf("%d %s %d %s",
 				year, (year > 1 ? "years" : "year"),
 				mon, (mon > 1 ? "months" : "month"));
 	else if (year != 0)
-		fprintf(output_filp, "%d %s",
+		__out_printf("%d %s",
 				year, (year > 1 ? "years" : "year"));
 	else
-		fprintf(output_filp, "%d %s",
+		__out_printf("%d %s",
 				mon, (mon > 1 ? "months" : "month"));
 	if (negative)
-		fprintf(output_filp, " ago");
-	fprintf(output_filp, "%s", quote);
+		__out_printf(" ago");
+	__out_puts(quote);
 	return true;
 }
 
@@ -809,24 +950,24 @@ print_arrow_interval_dt(ARROW_PRINT_DATUM_ARGS)
 	min = datum % 60;
 	datum /= 60;
 	hour = datum;
-	fprintf(output_filp, "%s", quote);
+	__out_puts(quote);
 	if (days != 0)
 	{
 		if (hour != 0 || min != 0 || sec != 0)
-			fprintf(output_filp, "%d %s %02d:%02d:%02d",
+			__out_printf("%d %s %02d:%02d:%02d",
 					days, (days > 1 ? "days" : "day"),
 					hour, min, sec);
 	}
 	else
 	{
-		fprintf(output_filp, "%02d:%02d:%02d",
+		__out_printf("%02d:%02d:%02d",
 				hour, min, sec);
 	}
 	if (msec != 0)
-		fprintf(output_filp, ".%03d", msec);
+		__out_printf(".%03d", msec);
 	if (negative)
-		fprintf(output_filp, " ago");
-	fprintf(output_filp, "%s", quote);
+		__out_printf(" ago");
+	__out_puts(quote);
 	return true;
 }
 
@@ -836,16 +977,16 @@ print_arrow_fixedsizebinary(ARROW_PRINT_DATUM_ARGS)
 	int32_t		i, width = column->arrow_type.FixedSizeBinary.byteWidth;
 	ARROW_PRINT_DATUM_SETUP_FIXEDSIZEBINARY(width);
 
-	fprintf(output_filp, "%s\\x", quote);
+	__out_printf("%s\\x", quote);
 	for (i=0; i < width; i++)
 	{
 		static const char *hextbl = "0123456789abcdef";
 		int		c = addr[i];
 
-		fputc(hextbl[(c >> 4) & 0x0f], output_filp);
-		fputc(hextbl[(c & 0x0f)], output_filp);
+		__out_putc(hextbl[(c >> 4) & 0x0f]);
+		__out_putc(hextbl[(c & 0x0f)]);
 	}
-	fprintf(output_filp, "%s", quote);
+	__out_puts(quote);
 	return true;
 }
 
@@ -855,8 +996,7 @@ print_arrow_macaddr(ARROW_PRINT_DATUM_ARGS)
 	int32_t		width = column->arrow_type.FixedSizeBinary.byteWidth;
 	ARROW_PRINT_DATUM_SETUP_FIXEDSIZEBINARY(width);
 	assert(width == 6);
-	fprintf(output_filp,
-			"%s%02x:%02x:%02x:%02x:%02x:%02x%s",
+	__out_printf("%s%02x:%02x:%02x:%02x:%02x:%02x%s",
 			quote,
 			(unsigned char)addr[0],
 			(unsigned char)addr[1],
@@ -874,8 +1014,7 @@ print_arrow_inet4(ARROW_PRINT_DATUM_ARGS)
 	int32_t		width = column->arrow_type.FixedSizeBinary.byteWidth;
 	ARROW_PRINT_DATUM_SETUP_FIXEDSIZEBINARY(width);
     assert(width == 4);
-	fprintf(output_filp,
-			"%s%u.%u.%u.%u%s",
+	__out_printf("%s%u.%u.%u.%u%s",
 			quote,
 			(unsigned char)addr[0],
 			(unsigned char)addr[1],
@@ -921,7 +1060,7 @@ print_arrow_inet6(ARROW_PRINT_DATUM_ARGS)
 	}
 
 	/* print out IPv6 */
-	fprintf(output_filp, "%s", quote);
+	__out_puts(quote);
 	for (i=0; i < 8; i++)
 	{
 		if (zero_base >= 0 &&
@@ -929,28 +1068,28 @@ print_arrow_inet6(ARROW_PRINT_DATUM_ARGS)
 			i <  zero_base + zero_len)
 		{
 			if (i == zero_base)
-				fputc(':', output_filp);
+				__out_putc(':');
 			continue;
 		}
 		if (i > 0)
-			fputc(':', output_filp);
+			__out_putc(':');
 		/* Is this address an encapsulated IPv4? */
 		if (i == 6 && zero_base == 0 && ((zero_len == 6) ||
 										 (zero_len == 7 && words[7] != 0x0001) ||
 										 (zero_len == 5 && words[5] == 0xffff)))
 		{
-			fprintf(output_filp, "%u.%u.%u.%u",
+			__out_printf("%u.%u.%u.%u",
 					(unsigned char)addr[12],
 					(unsigned char)addr[13],
 					(unsigned char)addr[14],
 					(unsigned char)addr[15]);
 			break;
 		}
-		fprintf(output_filp, "%x", words[i]);
+		__out_printf("%x", words[i]);
 	}
 	if (zero_base >= 0 && zero_base + zero_len == 8)
-		fputc(':', output_filp);
-	fprintf(output_filp, "%s", quote);
+		__out_putc(':');
+	__out_puts(quote);
 	return true;
 }
 
@@ -975,16 +1114,18 @@ print_arrow_list(ARROW_PRINT_DATUM_ARGS)
 	child = &column->children[0];
 	__buffers = buffers + (child->buffer_index -
 						   column->buffer_index);
-	fprintf(output_filp, "%s[", quote);
+	__out_puts(quote);
+	__out_putc('[');
 	current_context = 'e';
 	for (i=head; i < tail; i++)
 	{
 		if (i > head)
-			fprintf(output_filp, ",");
+			__out_putc(',');
 		printArrowDatum(child, __buffers, rb_chunk, i, "");
 	}
 	current_context = saved_context;
-	fprintf(output_filp, "%s]", quote);
+	__out_puts(quote);
+	__out_putc(']');
 	return true;
 }
 
@@ -994,7 +1135,8 @@ print_arrow_struct(ARROW_PRINT_DATUM_ARGS)
 	char		saved_context = current_context;
 	int			j;
 
-	fprintf(output_filp, "%s(", quote);
+	__out_puts(quote);
+	__out_putc('(');
 	current_context = 'e';
 	for (j=0; j < column->num_children; j++)
 	{
@@ -1002,11 +1144,12 @@ print_arrow_struct(ARROW_PRINT_DATUM_ARGS)
 		ArrowBuffer *__buffers = buffers + (child->buffer_index -
 											column->buffer_index);
 		if (j > 0)
-			fprintf(output_filp, "%c", csv_delimiter);
+			__out_putc(csv_delimiter);
 		printArrowDatum(child, __buffers, rb_chunk, index, "");
 	}
 	current_context = saved_context;
-	fprintf(output_filp, "%s)", quote);
+	__out_puts(quote);
+	__out_putc(')');
 	return true;
 }
 
@@ -1383,23 +1526,12 @@ printCreateTable(void)
 }
 
 static void
-printRecordBatch(ArrowRecordBatch *rbatch, const char *rb_chunk)
+printRecordBatch(ArrowRecordBatch *rbatch, const char *rb_chunk,
+				 int64_t row_start, int64_t row_end)
 {
 	int64_t		i, j;
 
-	/* consider --offset */
-	if (num_skip_rows < 0)
-		i = 0;
-	else
-	{
-		i = num_skip_rows;
-		if (num_skip_rows > rbatch->length)
-			num_skip_rows -= rbatch->length;
-		else
-			num_skip_rows = 0;
-	}
-
-	while (i < rbatch->length && num_dump_rows != 0)
+	for (i=row_start; i < row_end; i++)
 	{
 		for (j=0; j < arrow_num_columns; j++)
 		{
@@ -1407,7 +1539,7 @@ printRecordBatch(ArrowRecordBatch *rbatch, const char *rb_chunk)
 			ArrowBuffer	   *buffers;
 
 			if (j > 0)
-				fprintf(output_filp, "%c", csv_delimiter);
+				__out_putc(csv_delimiter);
 			if (j >= rbatch->_num_nodes)
 				printNullDatum();
 			else if (i >= rbatch->nodes[j].length)
@@ -1420,15 +1552,70 @@ printRecordBatch(ArrowRecordBatch *rbatch, const char *rb_chunk)
 				printArrowDatum(column, buffers, rb_chunk, i, "\"");
 			}
 		}
-		fprintf(output_filp, "\r\n");
-		i++;
-		if (num_dump_rows > 0)
-			num_dump_rows--;
+		__out_write("\r\n", 2);
+	}
+}
+
+/*
+ * dumpArrowTask
+ *
+ * A range of rows in a record batch to be formatted by a worker thread.
+ * Large record batches are split into multiple tasks, to bound the size
+ * of the per-task buffer and to balance the workers.
+ */
+#define DUMP_ROWS_PER_TASK		65536
+
+typedef struct
+{
+	ArrowRecordBatch *rbatch;
+	const char *rb_chunk;
+	int64_t		row_start;
+	int64_t		row_end;
+	bool		ready;
+	SQLbuffer	buf;
+} dumpArrowTask;
+
+static dumpArrowTask *dump_tasks = NULL;
+static int64_t		dump_num_tasks = 0;
+static int64_t		dump_next_task = 0;
+static int64_t		dump_done_tasks = 0;	/* already written out */
+static pthread_mutex_t dump_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t dump_cond = PTHREAD_COND_INITIALIZER;
+
+static void
+__addDumpArrowTask(ArrowRecordBatch *rbatch, const char *rb_chunk,
+				   int64_t row_start, int64_t row_end)
+{
+	static int64_t	dump_num_tasks_rooms = 0;
+
+	while (row_start < row_end)
+	{
+		dumpArrowTask *task;
+
+		if (dump_num_tasks >= dump_num_tasks_rooms)
+		{
+			dump_num_tasks_rooms = 2 * dump_num_tasks_rooms + 1000;
+			dump_tasks = repalloc(dump_tasks, sizeof(dumpArrowTask) *
+								  dump_num_tasks_rooms);
+		}
+		task = &dump_tasks[dump_num_tasks++];
+		memset(task, 0, sizeof(dumpArrowTask));
+		task->rbatch = rbatch;
+		task->rb_chunk = rb_chunk;
+		task->row_start = row_start;
+		task->row_end = (row_end - row_start > DUMP_ROWS_PER_TASK
+						 ? row_start + DUMP_ROWS_PER_TASK
+						 : row_end);
+		row_start = task->row_end;
 	}
 }
 
+/*
+ * setupArrowFileTasks - it maps the file, then adds the tasks with
+ * consideration of --offset and --limit
+ */
 static void
-dumpArrowFile(ArrowFileInfo *af_info, int fdesc)
+setupArrowFileTasks(ArrowFileInfo *af_info, int fdesc)
 {
 	static long	__PAGE_SIZE = -1;
 	size_t		file_sz = af_info->stat_buf.st_size;
@@ -1442,15 +1629,169 @@ dumpArrowFile(ArrowFileInfo *af_info, int fdesc)
 	mmap_head = mmap(NULL, mmap_sz, PROT_READ, MAP_SHARED, fdesc, 0);
 	if (mmap_head == MAP_FAILED)
 		Elog("failed on mmap: %m");
+	/* sequential scan on the file, except for the random order of tasks */
+	posix_madvise(mmap_head, mmap_sz, POSIX_MADV_SEQUENTIAL);
 	for (i=0; i < af_info->footer._num_recordBatches; i++)
 	{
 		ArrowBlock *block = &af_info->footer.recordBatches[i];
 		char	   *rb_chunk = (mmap_head + block->offset + block->metaDataLength);
 		ArrowRecordBatch *rbatch = &af_info->recordBatches[i].body.recordBatch;
+		int64_t		row_start = 0;
+		int64_t		row_end = rbatch->length;
+
+		/* consider --offset */
+		if (num_skip_rows > 0)
+		{
+			row_start = (num_skip_rows < rbatch->length
+						 ? num_skip_rows
+						 : rbatch->length);
+			num_skip_rows -= row_start;
+		}
+		/* consider --limit */
+		if (num_dump_rows >= 0)
+		{
+			if (row_end - row_start > num_dump_rows)
+				row_end = row_start + num_dump_rows;
+			num_dump_rows -= (row_end - row_start);
+		}
+		__addDumpArrowTask(rbatch, rb_chunk, row_start, row_end);
+	}
+	/* unmapped on exit */
+}
+
+static void
+execDumpArrowTask(dumpArrowTask *task)
+{
+	output_buf = &task->buf;
+	sql_buffer_expand(output_buf, 0);
+	printRecordBatch(task->rbatch, task->rb_chunk,
+					 task->row_start, task->row_end);
+	output_buf = NULL;
+}
+
+static void *
+dumpArrowWorkerMain(void *__priv)
+{
+	/* number of tasks formatted but not written yet */
+	int64_t		max_inflight = 4 * num_threads;
+
+	pthread_mutex_lock(&dump_mutex);
+	while (dump_next_task < dump_num_tasks)
+	{
+		dumpArrowTask *task;
+
+		if (dump_next_task >= dump_done_tasks + max_inflight)
+		{
+			pthread_cond_wait(&dump_cond, &dump_mutex);
+			continue;
+		}
+		task = &dump_tasks[dump_next_task++];
+		pthread_mutex_unlock(&dump_mutex);
+
+		execDumpArrowTask(task);
+
+		pthread_mutex_lock(&dump_mutex);
+		task->ready = true;
+		pthread_cond_broadcast(&dump_cond);
+	}
+	pthread_mutex_unlock(&dump_mutex);
+	return NULL;
+}
+
+static void
+__writeDumpArrowTask(dumpArrowTask *task)
+{
+	if (task->buf.usage > 0 &&
+		fwrite(task->buf.data, task->buf.usage, 1, output_filp) != 1)
+		Elog("failed on fwrite: %m");
+	pfree(task->buf.data);
+	task->buf.data = NULL;
+}
 
-		printRecordBatch(rbatch, rb_chunk);
+/*
+ * dumpArrowTasks - the worker threads format the tasks in parallel, and
+ * the main thread writes out them in order.
+ */
+static void
+dumpArrowTasks(void)
+{
+	pthread_t  *workers;
+	int64_t		i;
+	int			rv;
+
+	if (num_threads <= 1)
+	{
+		for (i=0; i < dump_num_tasks; i++)
+		{
+			execDumpArrowTask(&dump_tasks[i]);
+			__writeDumpArrowTask(&dump_tasks[i]);
+		}
+		return;
+	}
+
+	workers = alloca(sizeof(pthread_t) * num_threads);
+	for (i=0; i < num_threads; i++)
+	{
+		rv = pthread_create(&workers[i], NULL, dumpArrowWorkerMain, NULL);
+		if (rv != 0)
+			Elog("failed on pthread_create: %s", strerror(rv));
+	}
+	for (i=0; i < dump_num_tasks; i++)
+	{
+		dumpArrowTask *task = &dump_tasks[i];
+
+		pthread_mutex_lock(&dump_mutex);
+		while (!task->ready)
+			pthread_cond_wait(&dump_cond, &dump_mutex);
+		pthread_mutex_unlock(&dump_mutex);
+
+		__writeDumpArrowTask(task);
+
+		pthread_mutex_lock(&dump_mutex);
+		dump_done_tasks++;
+		pthread_cond_broadcast(&dump_cond);
+		pthread_mutex_unlock(&dump_mutex);
+	}
+	for (i=0; i < num_threads; i++)
+	{
+		rv = pthread_join(workers[i], NULL);
+		if (rv != 0)
+			Elog("failed on pthread_join: %s", strerror(rv));
 	}
-	munmap(mmap_head, mmap_sz);
+}
+
+/*
+ * setupTimezone - the worker threads must not switch TZ for each datum,
+ * so it assigns the timezone prior to launch them. If multiple timezones
+ * are used, it formats the tasks by single thread.
+ */
+static int
+__setupTimezone(arrowColumn *column)
+{
+	int		count = 0;
+
+	if (column->arrow_type.node.tag == ArrowNodeTag__Timestamp &&
+		column->arrow_type.Timestamp.timezone)
+	{
+		if (current_tz_name &&
+			strcmp(current_tz_name, column->arrow_type.Timestamp.timezone) != 0)
+			count++;
+		__assign_timestamp_timezone(&column->arrow_type.Timestamp);
+	}
+	for (int j=0; j < column->num_children; j++)
+		count += __setupTimezone(&column->children[j]);
+	return count;
+}
+
+static void
+setupTimezone(void)
+{
+	int		count = 0;
+
+	for (int j=0; j < arrow_num_columns; j++)
+		count += __setupTimezone(&arrow_columns[j]);
+	if (count > 0)
+		num_threads = 1;
 }
 
 int
@@ -1461,6 +1802,7 @@ main(int argc, char * const argv[])
 		{"header",       no_argument,       NULL, 1002},
 		{"offset",       required_argument, NULL, 1004},
 		{"limit",        required_argument, NULL, 1005},
+		{"threads",      required_argument, NULL, 't'},
 		/* CREATE TABLE & COPY FROM */
 		{"create-table", required_argument, NULL, 1200},
 		{"tablespace",   required_argument, NULL, 1201},
@@ -1471,7 +1813,7 @@ main(int argc, char * const argv[])
 	};
 	int		i, j, c;
 
-	while ((c = getopt_long(argc, argv, "o:h", long_options, NULL)) >= 0)
+	while ((c = getopt_long(argc, argv, "o:t:h", long_options, NULL)) >= 0)
 	{
 		switch (c)
 		{
@@ -1499,6 +1841,13 @@ main(int argc, char * const argv[])
 				if (num_dump_rows < 0)
 					Elog("--limit=%s is not a numeric value", optarg);
 				break;
+			case 't':	/* --threads */
+				if (num_threads >= 0)
+					Elog("-t|--threads was specified twice");
+				num_threads = atoi(optarg);
+				if (num_threads < 1)
+					Elog("-t|--threads=%s is not a valid number", optarg);
+				break;
 			case 1200:	/* --create-table */
 				if (create_table_name)
 					Elog("--create-table was specified twice");
@@ -1619,9 +1968,13 @@ main(int argc, char * const argv[])
 		}
 		fprintf(output_filp, "\r\n");
 	}
-	/* Dump Arrpw files */
+	/* Dump Arrow files */
+	if (num_threads < 0)
+		num_threads = sysconf(_SC_NPROCESSORS_ONLN);
+	setupTimezone();
 	for (i=0; i < arrow_num_files; i++)
-		dumpArrowFile(&arrow_files[i], arrow_fdescs[i]);
+		setupArrowFileTasks(&arrow_files[i], arrow_fdescs[i]);
+	dumpArrowTasks();
 	if (create_table_name && num_dump_rows != 0)
 		fprintf(output_filp, "\\.\r\n");
 	return 0;
@@ -0,0 +1 @@
+../src/arrow_pgsql.c
\ No newline at end of file
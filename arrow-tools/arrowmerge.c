@@ -0,0 +1,1161 @@
+/*
+ * arrowmerge.c
+ *
+ * A tool to merge/compact multiple Apache Arrow files with compatible
+ * schema into a single file with larger record batches.
+ * ----
+ * Copyright 2011-2023 (C) KaiGai Kohei <kaigai@kaigai.gr.jp>
+ * Copyright 2014-2023 (C) PG-Strom Developers Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the PostgreSQL License.
+ */
+#include <ctype.h>
+#include <getopt.h>
+#include <limits.h>
+#include <math.h>
+#include <strings.h>
+#include <unistd.h>
+#include "arrow_ipc.h"
+#include "float2.h"
+
+/*
+ * mergeSource - an input arrow file
+ */
+typedef struct
+{
+	const char	   *filename;
+	int				fdesc;
+	ArrowFileInfo	af_info;
+	char		   *mmap_head;
+	size_t			mmap_sz;
+	int				refcnt;		/* # of pending chunks + 1 while scan */
+	SQLstat		  **stats;		/* min/max stats of the columns, if any */
+} mergeSource;
+
+/*
+ * mergeChunk - a record batch in the input file
+ */
+typedef struct
+{
+	mergeSource	   *src;
+	int				rb_index;
+	ArrowBlock	   *block;
+	ArrowRecordBatch *rbatch;
+	const char	   *body;
+	int				node_index;		/* cursor of rbatch->nodes */
+	int				buffer_index;	/* cursor of rbatch->buffers */
+} mergeChunk;
+
+/*
+ * kind of the min/max statistics
+ */
+#define MERGE_STAT__NONE		0
+#define MERGE_STAT__INT			1
+#define MERGE_STAT__UINT		2
+#define MERGE_STAT__FLOAT16		3
+#define MERGE_STAT__FLOAT32		4
+#define MERGE_STAT__FLOAT64		5
+
+/* static variables */
+static const char  *output_filename = NULL;
+static size_t		batch_segment_sz = 0;
+static bool			shows_verbose = false;
+static bool			no_coalesce = false;
+static SQLtable	   *merge_table = NULL;
+static ArrowSchema *merge_schema = NULL;
+static int		   *merge_stat_kind = NULL;
+static bool			merge_coalesce_ok = true;
+static mergeChunk  *pending_chunks = NULL;
+static int			num_pending_chunks = 0;
+static size_t		pending_body_sz = 0;
+static long			num_copied_batches = 0;
+static long			num_merged_batches = 0;
+static long			num_source_batches = 0;
+
+/*
+ * __field_unitsz - width of the inline values, or -1 if not fixed-length
+ */
+static int
+__field_unitsz(ArrowType *t)
+{
+	switch (t->node.tag)
+	{
+		case ArrowNodeTag__Int:
+			return t->Int.bitWidth / 8;
+		case ArrowNodeTag__FloatingPoint:
+			switch (t->FloatingPoint.precision)
+			{
+				case ArrowPrecision__Half:
+					return sizeof(uint16_t);
+				case ArrowPrecision__Single:
+					return sizeof(float);
+				case ArrowPrecision__Double:
+					return sizeof(double);
+				default:
+					break;
+			}
+			break;
+		case ArrowNodeTag__Decimal:
+			return t->Decimal.bitWidth / 8;
+		case ArrowNodeTag__Date:
+			return (t->Date.unit == ArrowDateUnit__Day
+					? sizeof(int32_t)
+					: sizeof(int64_t));
+		case ArrowNodeTag__Time:
+			return t->Time.bitWidth / 8;
+		case ArrowNodeTag__Timestamp:
+			return sizeof(int64_t);
+		case ArrowNodeTag__Interval:
+			switch (t->Interval.unit)
+			{
+				case ArrowIntervalUnit__Year_Month:
+					return sizeof(int32_t);
+				case ArrowIntervalUnit__Day_Time:
+					return 2 * sizeof(int32_t);
+				case ArrowIntervalUnit__Month_Day_Nano:
+					return 2 * sizeof(int32_t) + sizeof(int64_t);
+				default:
+					break;
+			}
+			break;
+		case ArrowNodeTag__FixedSizeBinary:
+			return t->FixedSizeBinary.byteWidth;
+		default:
+			break;
+	}
+	return -1;
+}
+
+/*
+ * __field_stat_kind - kind of the min/max statistics we can re-compute
+ */
+static int
+__field_stat_kind(ArrowType *t, int *p_unitsz)
+{
+	int		unitsz = __field_unitsz(t);
+
+	*p_unitsz = unitsz;
+	switch (t->node.tag)
+	{
+		case ArrowNodeTag__Int:
+			return (t->Int.is_signed ? MERGE_STAT__INT : MERGE_STAT__UINT);
+		case ArrowNodeTag__FloatingPoint:
+			if (unitsz == sizeof(uint16_t))
+				return MERGE_STAT__FLOAT16;
+			if (unitsz == sizeof(float))
+				return MERGE_STAT__FLOAT32;
+			if (unitsz == sizeof(double))
+				return MERGE_STAT__FLOAT64;
+			break;
+		case ArrowNodeTag__Decimal:
+			if (unitsz == sizeof(int128_t))
+				return MERGE_STAT__INT;
+			break;
+		case ArrowNodeTag__Date:
+		case ArrowNodeTag__Time:
+		case ArrowNodeTag__Timestamp:
+			return MERGE_STAT__INT;
+		default:
+			break;
+	}
+	return MERGE_STAT__NONE;
+}
+
+/*
+ * write_merge_stat - all the embedded statistics are integer tokens
+ */
+static int
+write_merge_stat(SQLfield *attr, char *buf, size_t len,
+				 const SQLstat__datum *datum)
+{
+	int128_t	ival = datum->i128;
+	char		temp[64];
+	char	   *pos = temp + sizeof(temp) - 1;
+	bool		is_minus = false;
+
+	/* special case handling if INT128 min value */
+	if ((uint128_t)ival == ((uint128_t)1 << 127))
+		return snprintf(buf, len, "-170141183460469231731687303715884105728");
+	if (ival < 0)
+	{
+		is_minus = true;
+		ival = -ival;
+	}
+	*pos = '\0';
+	do {
+		int		dig = ival % 10;
+
+		*--pos = ('0' + dig);
+		ival /= 10;
+	} while (ival != 0);
+
+	return snprintf(buf, len, "%s%s", (is_minus ? "-" : ""), pos);
+}
+
+static bool
+__parse_stat_token(const char *tok, int len, int128_t *p_value)
+{
+	int128_t	ival = 0;
+	bool		is_minus = false;
+	int			i = 0;
+
+	while (i < len && isspace(tok[i]))
+		i++;
+	while (len > i && isspace(tok[len-1]))
+		len--;
+	if (i < len && tok[i] == '-')
+	{
+		is_minus = true;
+		i++;
+	}
+	if (i >= len)
+		return false;
+	for (; i < len; i++)
+	{
+		if (!isdigit(tok[i]))
+			return false;
+		ival = 10 * ival + (tok[i] - '0');
+	}
+	*p_value = (is_minus ? -ival : ival);
+	return true;
+}
+
+/*
+ * setupMergeStats - picks up embedded min/max statistics of the source
+ */
+static SQLstat *
+__setupMergeStatsField(ArrowField *field, int numRecordBatches)
+{
+	const char *min_tokens = NULL;
+	const char *max_tokens = NULL;
+	SQLstat	   *stats;
+	int			k;
+
+	for (k=0; k < field->_num_custom_metadata; k++)
+	{
+		ArrowKeyValue *kv = &field->custom_metadata[k];
+
+		if (strcmp(kv->key, "min_values") == 0)
+			min_tokens = kv->value;
+		else if (strcmp(kv->key, "max_values") == 0)
+			max_tokens = kv->value;
+	}
+	stats = palloc0(sizeof(SQLstat) * (numRecordBatches + 1));
+	if (!min_tokens || !max_tokens)
+		return stats;
+	for (k=0; k < numRecordBatches; k++)
+	{
+		const char *min_next = strchr(min_tokens, ',');
+		const char *max_next = strchr(max_tokens, ',');
+		int			min_len = (min_next ? min_next - min_tokens : strlen(min_tokens));
+		int			max_len = (max_next ? max_next - max_tokens : strlen(max_tokens));
+
+		if (__parse_stat_token(min_tokens, min_len, &stats[k].min.i128) &&
+			__parse_stat_token(max_tokens, max_len, &stats[k].max.i128))
+			stats[k].is_valid = true;
+		if (!min_next || !max_next)
+		{
+			if (k != numRecordBatches - 1)
+				memset(stats, 0, sizeof(SQLstat) * numRecordBatches);
+			break;
+		}
+		min_tokens = min_next + 1;
+		max_tokens = max_next + 1;
+	}
+	return stats;
+}
+
+static void
+setupMergeStats(mergeSource *src)
+{
+	ArrowFooter *footer = &src->af_info.footer;
+	int			j;
+
+	src->stats = palloc0(sizeof(SQLstat *) * merge_table->nfields);
+	for (j=0; j < merge_table->nfields; j++)
+	{
+		if (merge_stat_kind[j] == MERGE_STAT__NONE)
+			continue;
+		src->stats[j] = __setupMergeStatsField(&footer->schema.fields[j],
+											   footer->_num_recordBatches);
+	}
+}
+
+/*
+ * setupMergeTable - build SQLtable according to the first source file
+ */
+static bool
+__isStatCustomMetadata(const char *key)
+{
+	return (strcmp(key, "min_values") == 0 ||
+			strcmp(key, "max_values") == 0 ||
+			strncmp(key, "zonemap_", 8) == 0);
+}
+
+static void
+__setupMergeField(SQLtable *table, SQLfield *column, ArrowField *field)
+{
+	ArrowType  *t = &field->type;
+	int			j, k;
+
+	column->field_name = palloc(field->_name_len + 1);
+	memcpy(column->field_name, field->name, field->_name_len);
+	column->field_name[field->_name_len] = '\0';
+	column->arrow_type = field->type;
+	if (field->dictionary)
+		Elog("field '%s' is dictionary-encoded; not supported",
+			 column->field_name);
+	/* custom metadata, except for the statistics to be rebuilt */
+	if (field->_num_custom_metadata > 0)
+	{
+		column->customMetadata = palloc0(sizeof(ArrowKeyValue) *
+										 field->_num_custom_metadata);
+		for (k=0; k < field->_num_custom_metadata; k++)
+		{
+			ArrowKeyValue *kv = &field->custom_metadata[k];
+
+			if (!__isStatCustomMetadata(kv->key))
+				column->customMetadata[column->numCustomMetadata++] = *kv;
+		}
+	}
+	table->numFieldNodes++;
+	switch (t->node.tag)
+	{
+		case ArrowNodeTag__Int:
+		case ArrowNodeTag__FloatingPoint:
+		case ArrowNodeTag__Bool:
+		case ArrowNodeTag__Decimal:
+		case ArrowNodeTag__Date:
+		case ArrowNodeTag__Time:
+		case ArrowNodeTag__Timestamp:
+		case ArrowNodeTag__Interval:
+		case ArrowNodeTag__FixedSizeBinary:
+			if (t->node.tag != ArrowNodeTag__Bool && __field_unitsz(t) <= 0)
+				merge_coalesce_ok = false;
+			table->numBuffers += 2;
+			break;
+		case ArrowNodeTag__Utf8:
+		case ArrowNodeTag__Binary:
+		case ArrowNodeTag__LargeUtf8:
+		case ArrowNodeTag__LargeBinary:
+			table->numBuffers += 3;
+			break;
+		case ArrowNodeTag__List:
+		case ArrowNodeTag__LargeList:
+			if (field->_num_children != 1)
+				Elog("List field '%s' must have exactly one child",
+					 column->field_name);
+			table->numBuffers += 2;
+			column->element = palloc0(sizeof(SQLfield));
+			__setupMergeField(table, column->element, &field->children[0]);
+			break;
+		case ArrowNodeTag__Struct:
+			table->numBuffers += 1;
+			column->nfields = field->_num_children;
+			column->subfields = palloc0(sizeof(SQLfield) * column->nfields);
+			for (j=0; j < column->nfields; j++)
+				__setupMergeField(table, &column->subfields[j],
+								  &field->children[j]);
+			break;
+		default:
+			/*
+			 * record batches that contain any other types are copied as is,
+			 * so we need the children only to write out the schema.
+			 */
+			merge_coalesce_ok = false;
+			if (field->_num_children == 1)
+			{
+				column->element = palloc0(sizeof(SQLfield));
+				__setupMergeField(table, column->element, &field->children[0]);
+			}
+			else if (field->_num_children > 1)
+			{
+				column->nfields = field->_num_children;
+				column->subfields = palloc0(sizeof(SQLfield) * column->nfields);
+				for (j=0; j < column->nfields; j++)
+					__setupMergeField(table, &column->subfields[j],
+									  &field->children[j]);
+			}
+			break;
+	}
+}
+
+static void
+setupMergeTable(mergeSource *src, int fdesc)
+{
+	ArrowSchema *schema = &src->af_info.footer.schema;
+	SQLtable   *table;
+	int			j, unitsz;
+
+	table = palloc0(offsetof(SQLtable, columns[schema->_num_fields]));
+	table->filename = output_filename;
+	table->fdesc = fdesc;
+	table->segment_sz = batch_segment_sz;
+	table->nfields = schema->_num_fields;
+	table->customMetadata = schema->custom_metadata;
+	table->numCustomMetadata = schema->_num_custom_metadata;
+	merge_table = table;
+	merge_schema = schema;
+	merge_stat_kind = palloc0(sizeof(int) * table->nfields);
+	for (j=0; j < table->nfields; j++)
+	{
+		SQLfield   *column = &table->columns[j];
+		ArrowField *field = &schema->fields[j];
+		int			k, kind;
+
+		__setupMergeField(table, column, field);
+		/* keep the min/max statistics, if source file has them */
+		kind = __field_stat_kind(&field->type, &unitsz);
+		if (kind == MERGE_STAT__NONE)
+			continue;
+		for (k=0; k < field->_num_custom_metadata; k++)
+		{
+			if (strcmp(field->custom_metadata[k].key, "min_values") == 0)
+			{
+				merge_stat_kind[j] = kind;
+				column->stat_enabled = true;
+				column->write_stat = write_merge_stat;
+				table->has_statistics = true;
+				break;
+			}
+		}
+	}
+	/* output file header */
+	arrowFileWrite(table, "ARROW1\0\0", 8);
+	writeArrowSchema(table);
+}
+
+/*
+ * openMergeSource
+ */
+static mergeSource *
+openMergeSource(const char *filename, int fdesc_out)
+{
+	static long	__PAGE_SIZE = -1;
+	mergeSource *src = palloc0(sizeof(mergeSource));
+	ArrowFooter *footer;
+	struct stat	stat_out;
+	int			j;
+
+	src->filename = filename;
+	src->fdesc = open(filename, O_RDONLY);
+	if (src->fdesc < 0)
+		Elog("failed on open('%s'): %m", filename);
+	readArrowFileDesc(src->fdesc, &src->af_info);
+	src->af_info.filename = filename;
+	footer = &src->af_info.footer;
+	if (fstat(fdesc_out, &stat_out) != 0)
+		Elog("failed on fstat('%s'): %m", output_filename);
+	if (src->af_info.stat_buf.st_dev == stat_out.st_dev &&
+		src->af_info.stat_buf.st_ino == stat_out.st_ino)
+		Elog("input file '%s' is the output file", filename);
+	if (footer->_num_dictionaries > 0)
+		Elog("arrow file '%s' has dictionary batches; not supported",
+			 filename);
+	if (!merge_table)
+		setupMergeTable(src, fdesc_out);
+	else
+	{
+		ArrowSchema *schema = &footer->schema;
+
+		if (schema->_num_fields != merge_schema->_num_fields)
+			Elog("arrow file '%s' has different number of the fields",
+				 filename);
+		for (j=0; j < schema->_num_fields; j++)
+		{
+			if (!arrowFieldTypeIsEqual(&merge_schema->fields[j],
+									   &schema->fields[j]))
+				Elog("arrow file '%s' has incompatible field '%s'",
+					 filename, merge_table->columns[j].field_name);
+		}
+	}
+	setupMergeStats(src);
+
+	if (__PAGE_SIZE < 0)
+		__PAGE_SIZE = sysconf(_SC_PAGESIZE);
+	src->mmap_sz = TYPEALIGN(__PAGE_SIZE, src->af_info.stat_buf.st_size);
+	src->mmap_head = mmap(NULL, src->mmap_sz, PROT_READ, MAP_SHARED,
+						  src->fdesc, 0);
+	if (src->mmap_head == MAP_FAILED)
+		Elog("failed on mmap('%s'): %m", filename);
+	src->refcnt = 1;
+
+	return src;
+}
+
+static void
+releaseMergeSource(mergeSource *src)
+{
+	assert(src->refcnt > 0);
+	if (--src->refcnt == 0)
+	{
+		if (munmap(src->mmap_head, src->mmap_sz) != 0)
+			Elog("failed on munmap('%s'): %m", src->filename);
+		close(src->fdesc);
+	}
+}
+
+/*
+ * copyRecordBatchAsIs - the record batch is copied without any changes,
+ * because the offset of buffers are relative to the message body.
+ */
+static void
+copyRecordBatchAsIs(mergeChunk *chunk)
+{
+	mergeSource *src = chunk->src;
+	SQLtable   *table = merge_table;
+	ArrowBlock	block;
+	loff_t		off_in = chunk->block->offset;
+	loff_t		off_out = table->f_pos;
+	size_t		length = chunk->block->metaDataLength + chunk->block->bodyLength;
+	size_t		remain = length;
+	int			j, rb_index;
+
+	assert(table->f_pos == TYPEALIGN(8, table->f_pos));
+	if (chunk->block->offset + length > src->af_info.stat_buf.st_size)
+		Elog("record batch %d of '%s' is out of the file",
+			 chunk->rb_index, src->filename);
+	while (remain > 0)
+	{
+		ssize_t		nbytes = copy_file_range(src->fdesc, &off_in,
+											 table->fdesc, &off_out,
+											 remain, 0);
+		if (nbytes > 0)
+		{
+			remain -= nbytes;
+			continue;
+		}
+		if (nbytes < 0 && errno == EINTR)
+			continue;
+		if (nbytes == 0 ||
+			errno == EXDEV || errno == ENOSYS ||
+			errno == EINVAL || errno == EOPNOTSUPP)
+		{
+			/* fallback to write(2) from the mapped source */
+			table->f_pos = off_out;
+			arrowFileWrite(table, src->mmap_head + off_in, remain);
+			off_out = table->f_pos;
+			break;
+		}
+		Elog("failed on copy_file_range('%s' -> '%s'): %m",
+			 src->filename, table->filename);
+	}
+	table->f_pos = off_out;
+
+	initArrowNode(&block, Block);
+	block.offset = off_out - length;
+	block.metaDataLength = chunk->block->metaDataLength;
+	block.bodyLength = chunk->block->bodyLength;
+	rb_index = sql_table_append_record_batch(table, &block);
+	/* min/max statistics are also unchanged */
+	for (j=0; j < table->nfields; j++)
+	{
+		SQLfield   *column = &table->columns[j];
+		SQLstat	   *stat = (src->stats[j] ? &src->stats[j][chunk->rb_index] : NULL);
+
+		if (column->stat_enabled && stat && stat->is_valid)
+		{
+			SQLstat	   *item = palloc(sizeof(SQLstat));
+
+			memcpy(item, stat, sizeof(SQLstat));
+			item->rb_index = rb_index;
+			item->next = column->stat_list;
+			column->stat_list = item;
+		}
+	}
+	num_copied_batches++;
+}
+
+/*
+ * routines to concatenate the buffers of record batches
+ */
+static const char *
+__fetchChunkBuffer(mergeChunk *chunk, SQLfield *column, size_t required)
+{
+	ArrowRecordBatch *rbatch = chunk->rbatch;
+	ArrowBuffer *buffer;
+
+	if (chunk->buffer_index >= rbatch->_num_buffers)
+		Elog("record batch %d of '%s' has too short buffers",
+			 chunk->rb_index, chunk->src->filename);
+	buffer = &rbatch->buffers[chunk->buffer_index++];
+	if (buffer->length == 0 && required == 0)
+		return NULL;
+	if (buffer->offset < 0 || buffer->length < required ||
+		buffer->offset + buffer->length > chunk->block->bodyLength)
+		Elog("buffer of '%s' at record batch %d of '%s' is corrupted",
+			 column->field_name, chunk->rb_index, chunk->src->filename);
+	return chunk->body + buffer->offset;
+}
+
+/*
+ * __appendBitmap - appends nbits of the source bitmap (NULL means all-ones),
+ * then returns number of the cleared bits.
+ */
+static long
+__appendBitmap(SQLbuffer *buf, size_t dst_pos,
+			   const uint8_t *src, size_t src_pos, size_t nbits)
+{
+	size_t		usage = (dst_pos + nbits + 7) / 8;
+	uint8_t	   *dst;
+	size_t		i = 0, k;
+	long		nclears = 0;
+
+	sql_buffer_expand(buf, usage);
+	dst = (uint8_t *)buf->data;
+	if ((dst_pos & 7) == 0 && (src_pos & 7) == 0)
+	{
+		size_t	nbytes = nbits / 8;
+
+		if (!src)
+			memset(dst + dst_pos / 8, 0xff, nbytes);
+		else
+		{
+			memcpy(dst + dst_pos / 8, src + src_pos / 8, nbytes);
+			for (k=0; k < nbytes; k++)
+				nclears += 8 - __builtin_popcount(src[src_pos / 8 + k]);
+		}
+		i = nbytes * 8;
+	}
+	for (; i < nbits; i++)
+	{
+		size_t	d = dst_pos + i;
+		size_t	s = src_pos + i;
+
+		if (!src || (src[s >> 3] & (1 << (s & 7))) != 0)
+			dst[d >> 3] |= (1 << (d & 7));
+		else
+		{
+			dst[d >> 3] &= ~(1 << (d & 7));
+			nclears++;
+		}
+	}
+	if (buf->usage < usage)
+		buf->usage = usage;
+	return nclears;
+}
+
+static void
+__appendOffsets(SQLbuffer *buf, const char *offsets, bool is_large,
+				int64_t start, int64_t nitems, int64_t base)
+{
+	int64_t		head, i;
+
+	if (buf->usage == 0)
+		sql_buffer_append_zero(buf, is_large ? sizeof(int64_t) : sizeof(int32_t));
+	if (is_large)
+	{
+		const int64_t *values = (const int64_t *)offsets + start;
+
+		head = values[0];
+		for (i=1; i <= nitems; i++)
+		{
+			int64_t		ival = values[i] - head + base;
+
+			sql_buffer_append(buf, &ival, sizeof(int64_t));
+		}
+	}
+	else
+	{
+		const int32_t *values = (const int32_t *)offsets + start;
+
+		head = values[0];
+		for (i=1; i <= nitems; i++)
+		{
+			int64_t		ival = values[i] - head + base;
+			int32_t		__ival = ival;
+
+			if (ival > INT_MAX)
+				Elog("too large merged record batch; use smaller -s option");
+			sql_buffer_append(buf, &__ival, sizeof(int32_t));
+		}
+	}
+}
+
+static void
+__fetchOffsetRange(const char *offsets, bool is_large,
+				   int64_t start, int64_t nitems,
+				   int64_t *p_head, int64_t *p_tail)
+{
+	if (is_large)
+	{
+		*p_head = ((const int64_t *)offsets)[start];
+		*p_tail = ((const int64_t *)offsets)[start + nitems];
+	}
+	else
+	{
+		*p_head = ((const int32_t *)offsets)[start];
+		*p_tail = ((const int32_t *)offsets)[start + nitems];
+	}
+}
+
+static void
+appendFieldSlice(SQLfield *column, mergeChunk *chunk,
+				 int64_t start, int64_t nitems)
+{
+	ArrowRecordBatch *rbatch = chunk->rbatch;
+	ArrowFieldNode *fnode;
+	ArrowType  *t = &column->arrow_type;
+	const char *nullmap;
+	const char *values;
+	const char *extra;
+	bool		is_large = false;
+	int64_t		head, tail;
+	int			j, unitsz;
+
+	if (chunk->node_index >= rbatch->_num_nodes)
+		Elog("record batch %d of '%s' has too short field-nodes",
+			 chunk->rb_index, chunk->src->filename);
+	fnode = &rbatch->nodes[chunk->node_index++];
+	if (start + nitems > fnode->length)
+		Elog("field-node of '%s' at record batch %d of '%s' is corrupted",
+			 column->field_name, chunk->rb_index, chunk->src->filename);
+	/* nullmap */
+	nullmap = __fetchChunkBuffer(chunk, column, fnode->null_count == 0
+								 ? 0 : (start + nitems + 7) / 8);
+	if (fnode->null_count == 0)
+		nullmap = NULL;
+	column->nullcount += __appendBitmap(&column->nullmap, column->nitems,
+										(const uint8_t *)nullmap,
+										start, nitems);
+	switch (t->node.tag)
+	{
+		case ArrowNodeTag__Bool:
+			values = __fetchChunkBuffer(chunk, column, (start + nitems + 7) / 8);
+			if (nitems > 0)
+				__appendBitmap(&column->values, column->nitems,
+							   (const uint8_t *)values, start, nitems);
+			break;
+
+		case ArrowNodeTag__Int:
+		case ArrowNodeTag__FloatingPoint:
+		case ArrowNodeTag__Decimal:
+		case ArrowNodeTag__Date:
+		case ArrowNodeTag__Time:
+		case ArrowNodeTag__Timestamp:
+		case ArrowNodeTag__Interval:
+		case ArrowNodeTag__FixedSizeBinary:
+			unitsz = __field_unitsz(t);
+			values = __fetchChunkBuffer(chunk, column, unitsz * (start + nitems));
+			if (nitems > 0)
+				sql_buffer_append(&column->values,
+								  values + unitsz * start,
+								  unitsz * nitems);
+			break;
+
+		case ArrowNodeTag__LargeUtf8:
+		case ArrowNodeTag__LargeBinary:
+			is_large = true;
+		case ArrowNodeTag__Utf8:
+		case ArrowNodeTag__Binary:
+			unitsz = (is_large ? sizeof(int64_t) : sizeof(int32_t));
+			values = __fetchChunkBuffer(chunk, column, unitsz * (start + nitems + 1));
+			__fetchOffsetRange(values, is_large, start, nitems, &head, &tail);
+			extra = __fetchChunkBuffer(chunk, column, tail);
+			if (head < 0 || head > tail)
+				Elog("offset of '%s' at record batch %d of '%s' is corrupted",
+					 column->field_name, chunk->rb_index, chunk->src->filename);
+			if ((uint64_t)column->extra.usage + (tail - head) > UINT_MAX)
+				Elog("too large merged record batch; use smaller -s option");
+			__appendOffsets(&column->values, values, is_large,
+							start, nitems, column->extra.usage);
+			if (tail > head)
+				sql_buffer_append(&column->extra, extra + head, tail - head);
+			break;
+
+		case ArrowNodeTag__LargeList:
+			is_large = true;
+		case ArrowNodeTag__List:
+			unitsz = (is_large ? sizeof(int64_t) : sizeof(int32_t));
+			values = __fetchChunkBuffer(chunk, column, unitsz * (start + nitems + 1));
+			__fetchOffsetRange(values, is_large, start, nitems, &head, &tail);
+			if (head < 0 || head > tail)
+				Elog("offset of '%s' at record batch %d of '%s' is corrupted",
+					 column->field_name, chunk->rb_index, chunk->src->filename);
+			__appendOffsets(&column->values, values, is_large,
+							start, nitems, column->element->nitems);
+			appendFieldSlice(column->element, chunk, head, tail - head);
+			break;
+
+		case ArrowNodeTag__Struct:
+			for (j=0; j < column->nfields; j++)
+				appendFieldSlice(&column->subfields[j], chunk, start, nitems);
+			break;
+
+		default:
+			Elog("Bug? Arrow Type %s is not supported to merge",
+				 arrowNodeName(&t->node));
+	}
+	column->nitems += nitems;
+}
+
+/*
+ * computeFieldStat - min/max statistics of the merged record batch
+ */
+static inline double
+__stat_value_float(const char *addr, int kind, int128_t *p_bits)
+{
+	if (kind == MERGE_STAT__FLOAT16)
+	{
+		half_t		ival = *((const half_t *)addr);
+
+		*p_bits = ival;
+		return fp16_to_fp64(ival);
+	}
+	else if (kind == MERGE_STAT__FLOAT32)
+	{
+		union { int32_t ival; float fval; } temp;
+
+		temp.ival = *((const int32_t *)addr);
+		*p_bits = temp.ival;
+		return temp.fval;
+	}
+	else
+	{
+		union { int64_t ival; double fval; } temp;
+
+		temp.ival = *((const int64_t *)addr);
+		*p_bits = temp.ival;
+		return temp.fval;
+	}
+}
+
+static inline int128_t
+__stat_value_int(const char *addr, int kind, int unitsz)
+{
+	if (kind == MERGE_STAT__INT)
+	{
+		switch (unitsz)
+		{
+			case sizeof(int8_t):
+				return *((const int8_t *)addr);
+			case sizeof(int16_t):
+				return *((const int16_t *)addr);
+			case sizeof(int32_t):
+				return *((const int32_t *)addr);
+			case sizeof(int64_t):
+				return *((const int64_t *)addr);
+			default:
+				return *((const int128_t *)addr);
+		}
+	}
+	switch (unitsz)
+	{
+		case sizeof(uint8_t):
+			return *((const uint8_t *)addr);
+		case sizeof(uint16_t):
+			return *((const uint16_t *)addr);
+		case sizeof(uint32_t):
+			return *((const uint32_t *)addr);
+		default:
+			return *((const uint64_t *)addr);
+	}
+}
+
+static void
+computeFieldStat(SQLfield *column, int kind)
+{
+	SQLstat	   *stat = &column->stat_datum;
+	const uint8_t *nullmap = (const uint8_t *)column->nullmap.data;
+	const char *values = column->values.data;
+	double		fmin = 0.0, fmax = 0.0;
+	int			unitsz;
+	long		i;
+
+	__field_stat_kind(&column->arrow_type, &unitsz);
+	memset(stat, 0, sizeof(SQLstat));
+	for (i=0; i < column->nitems; i++)
+	{
+		const char *addr = values + unitsz * i;
+
+		if (column->nullcount > 0 &&
+			(nullmap[i >> 3] & (1 << (i & 7))) == 0)
+			continue;
+		if (kind == MERGE_STAT__INT || kind == MERGE_STAT__UINT)
+		{
+			int128_t	ival = __stat_value_int(addr, kind, unitsz);
+
+			if (!stat->is_valid || ival < stat->min.i128)
+				stat->min.i128 = ival;
+			if (!stat->is_valid || ival > stat->max.i128)
+				stat->max.i128 = ival;
+		}
+		else
+		{
+			int128_t	bits;
+			double		fval = __stat_value_float(addr, kind, &bits);
+
+			/* NaN is larger than any other values, like PostgreSQL */
+			if (!stat->is_valid ||
+				(isnan(fmin) ? !isnan(fval) : fval < fmin))
+			{
+				fmin = fval;
+				stat->min.i128 = bits;
+			}
+			if (!stat->is_valid ||
+				(!isnan(fmax) && (isnan(fval) || fval > fmax)))
+			{
+				fmax = fval;
+				stat->max.i128 = bits;
+			}
+		}
+		stat->is_valid = true;
+	}
+}
+
+/*
+ * flushPendingChunks
+ */
+static void
+flushPendingChunks(void)
+{
+	SQLtable   *table = merge_table;
+	int			i, j;
+
+	if (num_pending_chunks == 1)
+		copyRecordBatchAsIs(&pending_chunks[0]);
+	else if (num_pending_chunks > 1)
+	{
+		sql_table_clear(table);
+		for (i=0; i < num_pending_chunks; i++)
+		{
+			mergeChunk *chunk = &pending_chunks[i];
+
+			chunk->node_index = 0;
+			chunk->buffer_index = 0;
+			for (j=0; j < table->nfields; j++)
+				appendFieldSlice(&table->columns[j], chunk,
+								 0, chunk->rbatch->length);
+			table->nitems += chunk->rbatch->length;
+		}
+		for (j=0; j < table->nfields; j++)
+		{
+			SQLfield   *column = &table->columns[j];
+
+			if (column->stat_enabled)
+				computeFieldStat(column, merge_stat_kind[j]);
+		}
+		if (table->nitems > 0)
+			writeArrowRecordBatch(table);
+		num_merged_batches++;
+	}
+	for (i=0; i < num_pending_chunks; i++)
+		releaseMergeSource(pending_chunks[i].src);
+	num_pending_chunks = 0;
+	pending_body_sz = 0;
+}
+
+/*
+ * mergeArrowFile
+ */
+static void
+mergeArrowFile(mergeSource *src)
+{
+	ArrowFileInfo *af_info = &src->af_info;
+	int			i;
+
+	for (i=0; i < af_info->footer._num_recordBatches; i++)
+	{
+		ArrowBlock *block = &af_info->footer.recordBatches[i];
+		ArrowRecordBatch *rbatch = &af_info->recordBatches[i].body.recordBatch;
+		mergeChunk	chunk;
+
+		memset(&chunk, 0, sizeof(mergeChunk));
+		chunk.src = src;
+		chunk.rb_index = i;
+		chunk.block = block;
+		chunk.rbatch = rbatch;
+		chunk.body = src->mmap_head + block->offset + block->metaDataLength;
+		num_source_batches++;
+
+		if (no_coalesce ||
+			!merge_coalesce_ok ||
+			rbatch->compression != NULL ||
+			rbatch->_num_nodes != merge_table->numFieldNodes ||
+			rbatch->_num_buffers != merge_table->numBuffers ||
+			block->bodyLength >= batch_segment_sz / 2)
+		{
+			/* large or unsupported record batch shall be copied as is */
+			flushPendingChunks();
+			copyRecordBatchAsIs(&chunk);
+			continue;
+		}
+		if (pending_body_sz + block->bodyLength > batch_segment_sz)
+			flushPendingChunks();
+		if (!pending_chunks)
+			pending_chunks = palloc(sizeof(mergeChunk) * 64);
+		else if ((num_pending_chunks & 63) == 0)
+			pending_chunks = repalloc(pending_chunks, sizeof(mergeChunk) *
+									  (num_pending_chunks + 64));
+		pending_chunks[num_pending_chunks++] = chunk;
+		pending_body_sz += block->bodyLength;
+		src->refcnt++;
+	}
+}
+
+static size_t
+parse_size_value(const char *value, const char *label)
+{
+	const char *pos = value;
+
+	while (isdigit(*pos))
+		pos++;
+	if (*pos == '\0')
+		return atol(value);
+	else if (strcasecmp(pos, "k") == 0 ||
+			 strcasecmp(pos, "kb") == 0)
+		return atol(value) * (1UL << 10);
+	else if (strcasecmp(pos, "m") == 0 ||
+			 strcasecmp(pos, "mb") == 0)
+		return atol(value) * (1UL << 20);
+	else if (strcasecmp(pos, "g") == 0 ||
+			 strcasecmp(pos, "gb") == 0)
+		return atol(value) * (1UL << 30);
+	Elog("%s is not valid: %s", label, value);
+}
+
+static void
+usage(void)
+{
+	fputs("usage:  arrowmerge OPTIONS <file1> [<file2> ...]\n\n"
+		  "OPTIONS:\n"
+		  "  -o|--output=FILENAME  specify the output filename (mandatory)\n"
+		  "  -s|--segment-size=SIZE\n"
+		  "                 size of the merged record batches\n"
+		  "                 (default: 256MB)\n"
+		  "  --no-coalesce  copies all the record batches as is\n"
+		  "  -v|--verbose   shows the summary of the merge\n"
+		  "\n"
+		  "  --help         print this message.\n"
+		  "\n"
+		  "Record batches smaller than the half of the segment size are\n"
+		  "coalesced into larger ones, and min/max statistics embedded in\n"
+		  "the source files are rebuilt. The other record batches are copied\n"
+		  "as is.\n"
+		  "\n"
+		  "Report bugs to <pgstrom@heterodb.com>.\n",
+		  stderr);
+	exit(1);
+}
+
+int
+main(int argc, char * const argv[])
+{
+	static struct option long_options[] = {
+		{"output",       required_argument, NULL, 'o'},
+		{"segment-size", required_argument, NULL, 's'},
+		{"verbose",      no_argument,       NULL, 'v'},
+		{"no-coalesce",  no_argument,       NULL, 1001},
+		{"help",         no_argument,       NULL, 9999},
+		{NULL, 0, NULL, 0},
+	};
+	int			i, c, fdesc;
+
+	while ((c = getopt_long(argc, argv, "o:s:vh", long_options, NULL)) >= 0)
+	{
+		switch (c)
+		{
+			case 'o':	/* --output */
+				if (output_filename)
+					Elog("-o|--output was specified twice");
+				output_filename = optarg;
+				break;
+			case 's':	/* --segment-size */
+				if (batch_segment_sz != 0)
+					Elog("-s|--segment-size was specified twice");
+				batch_segment_sz = parse_size_value(optarg, "segment size");
+				break;
+			case 'v':	/* --verbose */
+				shows_verbose = true;
+				break;
+			case 1001:	/* --no-coalesce */
+				no_coalesce = true;
+				break;
+			case 'h':	/* --help */
+			default:
+				usage();
+				break;
+		}
+	}
+	if (!output_filename)
+		Elog("-o|--output must be specified");
+	if (optind >= argc)
+		Elog("no input arrow files given");
+	if (batch_segment_sz == 0)
+		batch_segment_sz = (1UL << 28);		/* 256MB in default */
+	else if (batch_segment_sz > UINT_MAX)
+		Elog("segment size is too large: %zu", batch_segment_sz);
+
+	fdesc = open(output_filename, O_RDWR | O_CREAT | O_TRUNC, 0666);
+	if (fdesc < 0)
+		Elog("failed on open('%s'): %m", output_filename);
+	for (i=optind; i < argc; i++)
+	{
+		mergeSource *src = openMergeSource(argv[i], fdesc);
+
+		mergeArrowFile(src);
+		releaseMergeSource(src);
+	}
+	flushPendingChunks();
+	writeArrowFooter(merge_table);
+	if (close(fdesc) != 0)
+		Elog("failed on close('%s'): %m", output_filename);
+	if (shows_verbose)
+		fprintf(stderr, "%d files, %ld record batches => "
+				"%d record batches (%ld merged, %ld copied)\n",
+				argc - optind, num_source_batches,
+				merge_table->numRecordBatches,
+				num_merged_batches, num_copied_batches);
+	return 0;
+}
+
+/*
+ * memory allocation handlers
+ */
+void *
+palloc(size_t sz)
+{
+	void   *ptr = malloc(sz);
+
+	if (!ptr)
+		Elog("out of memory");
+	return ptr;
+}
+
+void *
+palloc0(size_t sz)
+{
+	void   *ptr = malloc(sz);
+
+	if (!ptr)
+		Elog("out of memory");
+	memset(ptr, 0, sz);
+	return ptr;
+}
+
+char *
+pstrdup(const char *str)
+{
+	char   *ptr = strdup(str);
+
+	if (!ptr)
+		Elog("out of memory");
+	return ptr;
+}
+
+void *
+repalloc(void *old, size_t sz)
+{
+	char   *ptr = realloc(old, sz);
+
+	if (!ptr)
+		Elog("out of memory");
+	return ptr;
+}
+
+void
+pfree(void *ptr)
+{
+	free(ptr);
+}
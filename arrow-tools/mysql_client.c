@@ -859,8 +859,21 @@ mysql_setup_attribute(MYSQL *conn,
 typedef struct {
 	MYSQL	   *conn;
 	MYSQL_RES  *res;
+	bool		in_transaction;	/* transaction is already open */
+	bool		global_locked;	/* FLUSH TABLES WITH READ LOCK is held */
 } MYSTATE;
 
+/* mysql_thread_init() is called on the worker threads of --parallel */
+static __thread bool	mysql_thread_initialized = false;
+
+static void
+__mysql_exec_command(MYSQL *conn, const char *query)
+{
+	if (mysql_query(conn, query) != 0)
+		Elog("failed on mysql_query('%s'): %s",
+			 query, mysql_error(conn));
+}
+
 /*
  * sqldb_server_connect
  */
@@ -968,10 +981,14 @@ sqldb_begin_query(void *sqldb_state,
 	const char *query;
 
 	/* start transaction with read-only mode */
-	query = "START TRANSACTION READ ONLY";
-	if (mysql_query(conn, query) != 0)
-		Elog("failed on mysql_query('%s'): %s",
-			 query, mysql_error(conn));
+	if (!mystate->in_transaction)
+	{
+		query = "START TRANSACTION READ ONLY";
+		if (mysql_query(conn, query) != 0)
+			Elog("failed on mysql_query('%s'): %s",
+				 query, mysql_error(conn));
+		mystate->in_transaction = true;
+	}
 
 	/* exec SQL command  */
 	if (mysql_query(conn, sqldb_command) != 0)
@@ -1021,9 +1038,18 @@ sqldb_fetch_results(void *sqldb_state, SQLtable *table)
 	size_t		usage = 0;
 	int			j;
 
+	if (!mysql_thread_initialized && mysql_thread_init() == 0)
+		mysql_thread_initialized = true;
 	row = mysql_fetch_row(mystate->res);
 	if (!row)
+	{
+		if (mysql_thread_initialized)
+		{
+			mysql_thread_end();
+			mysql_thread_initialized = false;
+		}
 		return false;
+	}
 
 	row_sz = mysql_fetch_lengths(mystate->res);
 	for (j=0; j < table->nfields; j++)
@@ -1049,6 +1075,107 @@ sqldb_close_connection(void *sqldb_state)
 	mysql_close(mystate->conn);
 }
 
+/*
+ * __mysql_begin_consistent_snapshot
+ */
+static void
+__mysql_begin_consistent_snapshot(MYSTATE *mystate)
+{
+	assert(!mystate->in_transaction);
+	__mysql_exec_command(mystate->conn,
+						 "SET SESSION TRANSACTION ISOLATION LEVEL REPEATABLE READ");
+	__mysql_exec_command(mystate->conn,
+						 "START TRANSACTION WITH CONSISTENT SNAPSHOT, READ ONLY");
+	mystate->in_transaction = true;
+}
+
+/*
+ * sqldb_export_snapshot - acquire the global read lock, then begin
+ * a transaction with consistent snapshot.
+ *
+ * MySQL cannot share a snapshot between connections, so the other
+ * connections also begin their consistent snapshot by sqldb_import_snapshot()
+ * under the global read lock; no transactions can commit until
+ * sqldb_release_snapshot(), so all the connections see the same state.
+ * The returned string is just for the error message.
+ */
+char *
+sqldb_export_snapshot(void *sqldb_state)
+{
+	MYSTATE	   *mystate = (MYSTATE *)sqldb_state;
+	MYSQL	   *conn = mystate->conn;
+	const char *query = "FLUSH TABLES WITH READ LOCK";
+	char		snapshot[80];
+
+	if (mysql_query(conn, query) != 0)
+		Elog("failed on mysql_query('%s'): %s\n"
+			 "\n"
+			 "HINT: --parallel needs RELOAD privilege to acquire the global read lock\n",
+			 query, mysql_error(conn));
+	mystate->global_locked = true;
+	__mysql_begin_consistent_snapshot(mystate);
+
+	snprintf(snapshot, sizeof(snapshot), "connection-%lu",
+			 mysql_thread_id(conn));
+	return pstrdup(snapshot);
+}
+
+/*
+ * sqldb_import_snapshot - begin a transaction with consistent snapshot,
+ * while the global read lock is held by the exporter.
+ */
+void
+sqldb_import_snapshot(void *sqldb_state, const char *snapshot)
+{
+	MYSTATE	   *mystate = (MYSTATE *)sqldb_state;
+
+	__mysql_begin_consistent_snapshot(mystate);
+}
+
+/*
+ * sqldb_release_snapshot - release the global read lock of the exporter
+ */
+void
+sqldb_release_snapshot(void *sqldb_state)
+{
+	MYSTATE	   *mystate = (MYSTATE *)sqldb_state;
+
+	if (mystate->global_locked)
+	{
+		__mysql_exec_command(mystate->conn, "UNLOCK TABLES");
+		mystate->global_locked = false;
+	}
+}
+
+/*
+ * sqldb_exec_scalar - run a query that returns a single value
+ *
+ * It returns the value in text form, or NULL if it is NULL.
+ */
+char *
+sqldb_exec_scalar(void *sqldb_state, const char *query)
+{
+	MYSTATE	   *mystate = (MYSTATE *)sqldb_state;
+	MYSQL	   *conn = mystate->conn;
+	MYSQL_RES  *res;
+	MYSQL_ROW	row;
+	char	   *retval = NULL;
+
+	__mysql_exec_command(conn, query);
+	res = mysql_store_result(conn);
+	if (!res)
+		Elog("failed on mysql_store_result: %s", mysql_error(conn));
+	if (mysql_num_fields(res) != 1 ||
+		mysql_num_rows(res) != 1)
+		Elog("unexpected number of results by: %s", query);
+	row = mysql_fetch_row(res);
+	if (row[0] != NULL)
+		retval = pstrdup(row[0]);
+	mysql_free_result(res);
+
+	return retval;
+}
+
 /*
  * PG12 or later replaces XXprintf by pg_XXprintf
  */
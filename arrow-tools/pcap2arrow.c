@@ -9,14 +9,25 @@
 #include <fcntl.h>
 #include <getopt.h>
 #include <limits.h>
+#include <linux/bpf.h>
+#include <linux/ethtool.h>
+#include <linux/if_xdp.h>
+#include <linux/sockios.h>
+#include <net/if.h>
+#include <netpacket/packet.h>
 #include <pcap.h>		/* install libpcap-devel */
 #include <pfring.h>		/* install pfring; see https://packages.ntop.org/ */
+#include <poll.h>
 #include <pthread.h>
 #include <semaphore.h>
 #include <signal.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
 #include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/time.h>
 #include <sys/types.h>
 #include <unistd.h>
 #include "arrow_ipc.h"
@@ -45,13 +56,6 @@
 									 PCAP_PROTO__UDP_IPv4 |	\
 									 PCAP_PROTO__ICMP_IPv4)
 
-#define PCAP_SWITCH__NEVER			0
-#define PCAP_SWITCH__PER_MINUTE		1
-#define PCAP_SWITCH__PER_HOUR		2
-#define PCAP_SWITCH__PER_DAY		3
-#define PCAP_SWITCH__PER_WEEK		4
-#define PCAP_SWITCH__PER_MONTH		5
-
 /* command-line options */
 static char			   *input_devname = NULL;
 static char			   *output_filename = "/tmp/pcap_%i_%y%m%d_%H%M%S.arrow";
@@ -60,9 +64,13 @@ static int				num_threads = -1;
 static int				num_pcap_threads = -1;
 static char			   *bpf_filter_rule = NULL;
 static size_t			output_filesize_limit = ULONG_MAX;			/* No Limit */
+static int64_t			output_rotate_interval = 0;		/* usec; No rotation */
+static char			   *manifest_filename = NULL;
+static uint32_t			manifest_bloom_bits = 16384;
 static size_t			record_batch_threshold = (128UL << 20);		/* 128MB */
 static bool				force_overwrite = false;
 static bool				enable_direct_io = false;
+static bool				output_shmem = false;
 static bool				no_payload = false;
 static bool				composite_options = false;
 static int				print_stat_interval = -1;
@@ -75,6 +83,12 @@ static __thread uint32_t *current_interface_id = NULL;	/* for PCAP-NG */
 typedef struct
 {
 	int					refcnt;
+	int64_t				window_end;	/* usec; end of the --rotate window */
+	int64_t				ts_min;		/* usec; for --manifest */
+	int64_t				ts_max;
+	uint64_t			nitems;
+	uint64_t		   *bloom;		/* bloom filter of the 5-tuple */
+	ArrowShmemHeader   *shm_head;	/* for --shmem */
 	SQLtable			table;
 } arrowFileDesc;
 #define PCAP_SCHEMA_MAX_NFIELDS		50
@@ -88,6 +102,11 @@ static arrowFileDesc  **arrow_file_desc_array = NULL;
 static uint64_t			arrow_file_desc_selector = 0;
 static int				arrow_file_desc_nums = 1;
 
+/* static variables for --manifest */
+static int				manifest_fdesc = -1;
+static int				manifest_bloom_cindex[8];
+static int				manifest_bloom_nkeys = 0;
+
 /* static variables for worker threads */
 static pthread_mutex_t	arrow_workers_mutex;
 static pthread_cond_t	arrow_workers_cond;
@@ -100,6 +119,45 @@ static pfring		  **pfring_desc_array = NULL;
 static uint64_t			pfring_desc_selector = 0;
 static int				pfring_desc_nums = -1;
 
+/* static variables for AF_XDP capture mode */
+#ifndef AF_XDP
+#define AF_XDP				44
+#endif
+#ifndef SOL_XDP
+#define SOL_XDP				283
+#endif
+#define XDP_NUM_FRAMES		4096
+#define XDP_FRAME_SIZE		4096
+#define XDP_RX_BATCH_SZ		64
+
+typedef struct
+{
+	uint32_t		   *producer;
+	uint32_t		   *consumer;
+	uint32_t		   *flags;
+	void			   *ring;
+	uint32_t			mask;
+	void			   *mmap_addr;
+	size_t				mmap_sz;
+} xdpRing;
+
+typedef struct
+{
+	int					fdesc;
+	uint32_t			queue_id;
+	char			   *umem_area;
+	size_t				umem_sz;
+	xdpRing				fill;
+	xdpRing				comp;
+	xdpRing				rx;
+	pthread_mutex_t		lock;
+	uint64_t			recv_count;
+} xdpSocketDesc;
+
+static bool				use_af_xdp = false;
+static xdpSocketDesc   *xdp_desc_array = NULL;
+static uint64_t			xdp_desc_selector = 0;
+
 /* definitions for PCAP/PCAPNG file scan mode */
 #define PCAP_MAGIC_LE		0xd4c3b2a1U
 #define PCAP_MAGIC_BE		0xa1b2c3d4U
@@ -1384,10 +1442,9 @@ handlePacketPayload(SQLtable *chunk, const u_char *buf, size_t sz)
  * arrowOpenOutputFile
  */
 static arrowFileDesc *
-arrowOpenOutputFile(void)
+arrowOpenOutputFile(time_t tv)
 {
 	static int	output_file_seqno = 1;
-	time_t		tv = time(NULL);
 	struct tm	tm;
 	char	   *path, *pos;
 	int			off, sz = 256;
@@ -1486,11 +1543,22 @@ retry:
 	outfd = palloc0(offsetof(arrowFileDesc,
 							 table.columns[PCAP_SCHEMA_MAX_NFIELDS]));
 	outfd->refcnt = 0;
+	outfd->ts_min = INT64_MAX;
+	outfd->ts_max = INT64_MIN;
+	if (manifest_filename)
+		outfd->bloom = palloc0(manifest_bloom_bits / 8);
 	outfd->table.fdesc = fdesc;
 	outfd->table.filename = pstrdup(path);
 	arrowPcapSchemaInit(&outfd->table);
 
 	/* Write Header */
+	if (output_shmem)
+	{
+		outfd->shm_head = arrowShmemCreateSegment(&outfd->table,
+												  output_filesize_limit != ULONG_MAX
+												  ? output_filesize_limit : 0);
+		return outfd;
+	}
 	arrowFileWrite(&outfd->table, "ARROW1\0\0", 8);
 	writeArrowSchema(&outfd->table);
 
@@ -1507,6 +1575,80 @@ retry:
 	return outfd;
 }
 
+/*
+ * arrowOpenManifestFile
+ *
+ * The manifest file is shared by multiple pcap2arrow runs, so it writes
+ * the columns to be summarized on the head of the entries of this run.
+ */
+static void
+arrowOpenManifestFile(void)
+{
+	SQLtable   *chunk = arrow_chunks_array[0];
+	char		buf[1024];
+	size_t		off;
+	int			cindex[] = { arrow_cindex__src_addr,
+							 arrow_cindex__dst_addr,
+							 arrow_cindex__src_addr6,
+							 arrow_cindex__dst_addr6,
+							 arrow_cindex__src_port,
+							 arrow_cindex__dst_port,
+							 arrow_cindex__protocol };
+
+	manifest_fdesc = open(manifest_filename,
+						  O_WRONLY | O_CREAT | O_APPEND, 0644);
+	if (manifest_fdesc < 0)
+		Elog("failed to open('%s'): %m", manifest_filename);
+
+	off = snprintf(buf, sizeof(buf), "# timestamp=%s bloom=",
+				   chunk->columns[arrow_cindex__timestamp].field_name);
+	for (int i=0; i < sizeof(cindex) / sizeof(int); i++)
+	{
+		if (cindex[i] < 0)
+			continue;
+		off += snprintf(buf+off, sizeof(buf)-off, "%s%s",
+						manifest_bloom_nkeys > 0 ? "," : "",
+						chunk->columns[cindex[i]].field_name);
+		manifest_bloom_cindex[manifest_bloom_nkeys++] = cindex[i];
+	}
+	buf[off++] = '\n';
+	if (write(manifest_fdesc, buf, off) != off)
+		Elog("failed on write('%s'): %m", manifest_filename);
+}
+
+/*
+ * arrowManifestAppendEntry
+ *
+ * It appends an entry of the output file by a single write(2) call, so
+ * the concurrent writers with O_APPEND never break the lines.
+ */
+static void
+arrowManifestAppendEntry(arrowFileDesc *outfd)
+{
+	char	   *path = realpath(outfd->table.filename, NULL);
+	uint32_t	nwords = manifest_bloom_bits / 64;
+	size_t		sz, off;
+	char	   *buf;
+
+	if (!path)
+		Elog("failed on realpath('%s'): %m", outfd->table.filename);
+	sz = strlen(path) + 16 * nwords + 128;
+	buf = palloc(sz);
+	off = snprintf(buf, sz, "%s\t%ld\t%ld\t%lu\t%u\t",
+				   path,
+				   outfd->ts_min,
+				   outfd->ts_max,
+				   outfd->nitems,
+				   manifest_bloom_bits);
+	for (uint32_t i=0; i < nwords; i++)
+		off += snprintf(buf+off, sz-off, "%016lx", outfd->bloom[i]);
+	buf[off++] = '\n';
+	if (write(manifest_fdesc, buf, off) != off)
+		Elog("failed on write('%s'): %m", manifest_filename);
+	pfree(buf);
+	free(path);
+}
+
 /*
  * arrowCloseOutputFile
  */
@@ -1517,6 +1659,16 @@ arrowCloseOutputFile(arrowFileDesc *outfd)
 	{
 		if (unlink(outfd->table.filename) != 0)
 			Elog("failed on unlink('%s'): %m", outfd->table.filename);
+		if (outfd->shm_head)
+			arrowShmemClose(outfd->shm_head);
+	}
+	else if (outfd->shm_head)
+	{
+		/* shared memory segment has no footer, just closed */
+		arrowShmemCommit(outfd->shm_head, outfd->table.f_pos);
+		arrowShmemClose(outfd->shm_head);
+		if (manifest_fdesc >= 0)
+			arrowManifestAppendEntry(outfd);
 	}
 	else
 	{
@@ -1533,6 +1685,8 @@ arrowCloseOutputFile(arrowFileDesc *outfd)
 		if (lseek(outfd->table.fdesc, outfd->table.f_pos, SEEK_SET) < 0)
 			Elog("failed on lseek('%s'): %m", outfd->table.filename);
 		writeArrowFooter(&outfd->table);
+		if (manifest_fdesc >= 0)
+			arrowManifestAppendEntry(outfd);
 	}
 	close(outfd->table.fdesc);
 }
@@ -1590,6 +1744,112 @@ arrowFileDirectWriteIOV(SQLtable *chunk, size_t length)
 	chunk->__iov_cnt = 0;	/* rewind iovec */
 }
 
+/*
+ * arrowChunkTimestampRange
+ */
+static void
+arrowChunkTimestampRange(SQLtable *chunk, int64_t *p_ts_min, int64_t *p_ts_max)
+{
+	SQLfield   *column = &chunk->columns[arrow_cindex__timestamp];
+	int64_t	   *values = (int64_t *)column->values.data;
+	int64_t		ts_min = INT64_MAX;
+	int64_t		ts_max = INT64_MIN;
+
+	for (size_t i=0; i < column->nitems; i++)
+	{
+		if (column->nullcount > 0 &&
+			(column->nullmap.data[i>>3] & (1<<(i&7))) == 0)
+			continue;
+		if (values[i] < ts_min)
+			ts_min = values[i];
+		if (values[i] > ts_max)
+			ts_max = values[i];
+	}
+	*p_ts_min = ts_min;
+	*p_ts_max = ts_max;
+}
+
+/*
+ * arrowChunkUpdateBloom
+ *
+ * It builds the bloom filter of the 5-tuple on the chunk locally, then
+ * merges it to the output file; other threads may write the same file.
+ */
+static void
+arrowChunkUpdateBloom(SQLtable *chunk, uint64_t *bloom)
+{
+	static __thread uint64_t *local_bloom = NULL;
+	uint32_t	nwords = manifest_bloom_bits / 64;
+
+	if (!local_bloom)
+		local_bloom = palloc(sizeof(uint64_t) * nwords);
+	memset(local_bloom, 0, sizeof(uint64_t) * nwords);
+
+	for (int j=0; j < manifest_bloom_nkeys; j++)
+	{
+		SQLfield   *column = &chunk->columns[manifest_bloom_cindex[j]];
+		const char *values = column->values.data;
+
+		for (size_t i=0; i < column->nitems; i++)
+		{
+			uint64_t	hash;
+
+			if (column->nullcount > 0 &&
+				(column->nullmap.data[i>>3] & (1<<(i&7))) == 0)
+				continue;
+			if (column->arrow_type.node.tag == ArrowNodeTag__FixedSizeBinary)
+			{
+				int		width = column->arrow_type.FixedSizeBinary.byteWidth;
+
+				hash = arrowManifestHash(column->field_name,
+										 values + width * i, width);
+			}
+			else
+			{
+				int64_t	ival;
+
+				Assert(column->arrow_type.node.tag == ArrowNodeTag__Int &&
+					   !column->arrow_type.Int.is_signed);
+				if (column->arrow_type.Int.bitWidth == 8)
+					ival = ((uint8_t *)values)[i];
+				else
+					ival = ((uint16_t *)values)[i];
+				hash = arrowManifestHash(column->field_name,
+										 &ival, sizeof(int64_t));
+			}
+			for (int k=0; k < ARROW_MANIFEST_BLOOM_NHASHES; k++)
+			{
+				uint32_t	bit = arrowManifestBloomBit(hash, k, manifest_bloom_bits);
+
+				local_bloom[bit >> 6] |= (1UL << (bit & 63));
+			}
+		}
+	}
+	for (uint32_t i=0; i < nwords; i++)
+	{
+		if (local_bloom[i] != 0)
+			__atomic_fetch_or(&bloom[i], local_bloom[i], __ATOMIC_RELAXED);
+	}
+}
+
+/*
+ * __rotateWindowEnd
+ *
+ * The --rotate windows are aligned to the local time, like 00:00, 00:05, ...
+ */
+static int64_t
+__rotateWindowEnd(int64_t ts)
+{
+	time_t		tv = ts / 1000000L;
+	struct tm	tm;
+	int64_t		gmtoff;
+
+	localtime_r(&tv, &tm);
+	gmtoff = (int64_t)tm.tm_gmtoff * 1000000L;
+	return (((ts + gmtoff) / output_rotate_interval + 1) * output_rotate_interval
+			- gmtoff);
+}
+
 /*
  * arrowChunkWriteOut
  */
@@ -1601,6 +1861,8 @@ arrowChunkWriteOut(SQLtable *chunk)
 	size_t		meta_sz;
 	size_t		length;
 	int			f_index;
+	int64_t		ts_min = INT64_MAX;
+	int64_t		ts_max = INT64_MIN;
 	bool		close_file = false;
 
 	/*
@@ -1610,6 +1872,9 @@ arrowChunkWriteOut(SQLtable *chunk)
 	length = setupArrowRecordBatchIOV(chunk);
 	if (enable_direct_io)
 		length = DIRECT_IO_ALIGN(length);
+	/* packet timestamps for --rotate and --manifest */
+	if (output_rotate_interval > 0 || manifest_fdesc >= 0)
+		arrowChunkTimestampRange(chunk, &ts_min, &ts_max);
 
 	/*
 	 * attach file descriptor
@@ -1619,8 +1884,13 @@ arrowChunkWriteOut(SQLtable *chunk)
 	for (;;)
 	{
 		outfd = arrow_file_desc_array[f_index];
-		if (outfd->table.f_pos < output_filesize_limit)
+		if (outfd->table.f_pos < output_filesize_limit &&
+			(outfd->window_end == 0 || ts_min < outfd->window_end))
 		{
+			/* the first chunk determines the time window of the file */
+			if (output_rotate_interval > 0 &&
+				outfd->window_end == 0 && ts_min <= ts_max)
+				outfd->window_end = __rotateWindowEnd(ts_min);
 			/* Ok, [base ... base + usage) is reserved */
 			chunk->fdesc    = outfd->table.fdesc;
 			chunk->filename = outfd->table.filename;
@@ -1632,8 +1902,20 @@ arrowChunkWriteOut(SQLtable *chunk)
 		}
 		else
 		{
-			/* exceeds the limit, so switch the output file */
-			arrow_file_desc_array[f_index] = arrowOpenOutputFile();
+			time_t		tv = time(NULL);
+			int64_t		window_end = 0;
+
+			/*
+			 * exceeds the limit or the time window, so switch the output
+			 * file; it is named by the beginning of the next window.
+			 */
+			if (output_rotate_interval > 0 && ts_min <= ts_max)
+			{
+				window_end = __rotateWindowEnd(ts_min);
+				tv = (window_end - output_rotate_interval) / 1000000L;
+			}
+			arrow_file_desc_array[f_index] = arrowOpenOutputFile(tv);
+			arrow_file_desc_array[f_index]->window_end = window_end;
 			if (outfd->refcnt == 0)
 			{
 				pthreadMutexUnlock(&arrow_file_desc_locks[f_index]);
@@ -1644,6 +1926,9 @@ arrowChunkWriteOut(SQLtable *chunk)
 		}
 	}
 	pthreadMutexUnlock(&arrow_file_desc_locks[f_index]);
+	/* the file is never closed while refcnt > 0 */
+	if (outfd->bloom)
+		arrowChunkUpdateBloom(chunk, outfd->bloom);
 
 	/* ok, write out record batch (see writeArrowRecordBatch) */
 	Assert(chunk->__iov_cnt > 0 &&
@@ -1679,10 +1964,21 @@ arrowChunkWriteOut(SQLtable *chunk)
 		outfd->table.recordBatches = repalloc(outfd->table.recordBatches, length);
 	}
 	outfd->table.recordBatches[outfd->table.numRecordBatches++] = block;
+	outfd->nitems += chunk->nitems;
+	if (ts_min < outfd->ts_min)
+		outfd->ts_min = ts_min;
+	if (ts_max > outfd->ts_max)
+		outfd->ts_max = ts_max;
 
 	Assert(outfd->refcnt > 0);
-	if (--outfd->refcnt == 0 && arrow_file_desc_array[f_index] != outfd)
-		close_file = true;
+	if (--outfd->refcnt == 0)
+	{
+		/* all the reserved ranges are written, so publish them */
+		if (outfd->shm_head)
+			arrowShmemCommit(outfd->shm_head, outfd->table.f_pos);
+		if (arrow_file_desc_array[f_index] != outfd)
+			close_file = true;
+	}
 	pthreadMutexUnlock(&arrow_file_desc_locks[f_index]);
 	if (close_file)
 		arrowCloseOutputFile(outfd);
@@ -1991,6 +2287,70 @@ execCapturePackets(pfring *pd, SQLtable *chunk)
 	return 0;
 }
 
+/*
+ * execCapturePacketsXdp
+ *
+ * It consumes the RX ring of the AF_XDP socket, then returns the frames
+ * to the fill ring as soon as the packets are copied to the chunk buffer.
+ * Caller must hold xsk->lock, because the rings are single-consumer.
+ */
+static int
+execCapturePacketsXdp(xdpSocketDesc *xsk, SQLtable *chunk)
+{
+	sql_table_clear(chunk);
+
+	while (!do_shutdown)
+	{
+		struct pfring_pkthdr hdr;
+		struct pollfd pfd;
+		uint32_t	rx_prod, rx_cons;
+		uint32_t	fill_prod;
+		uint32_t	i, nitems;
+
+		rx_cons = *xsk->rx.consumer;
+		rx_prod = __atomic_load_n(xsk->rx.producer, __ATOMIC_ACQUIRE);
+		nitems = rx_prod - rx_cons;
+		if (nitems == 0)
+		{
+			pfd.fd = xsk->fdesc;
+			pfd.events = POLLIN;
+			pfd.revents = 0;
+			if (poll(&pfd, 1, 50) < 0 && errno != EINTR)
+				Elog("failed on poll(2) for AF_XDP socket: %m");
+			continue;
+		}
+		if (nitems > XDP_RX_BATCH_SZ)
+			nitems = XDP_RX_BATCH_SZ;
+		/* AF_XDP has no timestamp per packet, so capture time is used */
+		gettimeofday(&hdr.ts, NULL);
+		fill_prod = *xsk->fill.producer;
+		for (i=0; i < nitems; i++)
+		{
+			struct xdp_desc *desc = ((struct xdp_desc *)xsk->rx.ring +
+									 ((rx_cons + i) & xsk->rx.mask));
+			uint64_t	addr = desc->addr;
+
+			hdr.caplen = desc->len;
+			hdr.len = desc->len;
+			__execCaptureOnePacket(chunk, &hdr,
+								   (const u_char *)xsk->umem_area + addr);
+			/* the frame can be reused immediately */
+			((uint64_t *)xsk->fill.ring)[(fill_prod + i) & xsk->fill.mask]
+				= (addr & ~((uint64_t)XDP_FRAME_SIZE - 1));
+		}
+		__atomic_store_n(xsk->rx.consumer, rx_cons + nitems, __ATOMIC_RELEASE);
+		__atomic_store_n(xsk->fill.producer, fill_prod + nitems, __ATOMIC_RELEASE);
+		if ((*xsk->fill.flags & XDP_RING_NEED_WAKEUP) != 0)
+			recvfrom(xsk->fdesc, NULL, 0, MSG_DONTWAIT, NULL, NULL);
+		atomicAdd64(&xsk->recv_count, nitems);
+
+		if (chunk->usage >= record_batch_threshold)
+			return 1;	/* write out the buffer */
+	}
+	/* interrupted, thus chunk-buffer is partially filled up */
+	return 0;
+}
+
 /*
  * final_merge_pending_chunks
  */
@@ -2074,6 +2434,65 @@ pfring_worker_main(void *__arg)
 	return final_merge_pending_chunks(chunk);
 }
 
+/*
+ * xdp_worker_main
+ */
+static void *
+xdp_worker_main(void *__arg)
+{
+	SQLtable   *chunk;
+
+	/* assign worker-id of this thread */
+	worker_id = (long)__arg;
+	chunk = arrow_chunks_array[worker_id];
+
+	while (!do_shutdown)
+	{
+		int		status = -1;
+
+		if (sem_wait(&pcap_worker_sem) != 0)
+		{
+			if (errno == EINTR)
+				continue;
+			Elog("worker-%ld: failed on sem_wait: %m", worker_id);
+		}
+		/*
+		 * Ok, Go to packet capture on a queue not in use
+		 */
+		if (!do_shutdown)
+		{
+			xdpSocketDesc *xsk = NULL;
+			int			i, index;
+
+			index = atomicAdd64(&xdp_desc_selector, 1) % pfring_desc_nums;
+			for (i=0; i < pfring_desc_nums; i++)
+			{
+				xdpSocketDesc *temp = &xdp_desc_array[(index + i) % pfring_desc_nums];
+
+				if (pthread_mutex_trylock(&temp->lock) == 0)
+				{
+					xsk = temp;
+					break;
+				}
+			}
+			if (!xsk)
+			{
+				xsk = &xdp_desc_array[index];
+				pthreadMutexLock(&xsk->lock);
+			}
+			status = execCapturePacketsXdp(xsk, chunk);
+			Assert(status >= 0);
+			pthreadMutexUnlock(&xsk->lock);
+		}
+		if (sem_post(&pcap_worker_sem) != 0)
+			Elog("failed on sem_post: %m");
+
+		if (status > 0)
+			arrowChunkWriteOut(chunk);
+	}
+	return final_merge_pending_chunks(chunk);
+}
+
 /*
  * process_one_pcap_file
  */
@@ -2817,6 +3236,9 @@ usage(int status)
 		  "  -i|--input=DEVICE\n"
 		  "       specifies a network device to capture packet.\n"
 		  "     --num-queues=N_QUEUE : num of PF-RING queues.\n"
+		  "     --xdp : uses AF_XDP sockets instead of PF-RING.\n"
+		  "       --num-queues is number of RX queues of the device in this mode;\n"
+		  "       (default: all the RX queues)\n"
 		  "  -o|--output=<output file; with format>\n"
 		  "       filename format can contains:\n"
 		  "         %i : interface name\n"
@@ -2835,7 +3257,18 @@ usage(int status)
 		  "       opens multiple output files simultaneously (default: 1)\n"
 		  "     --chunk-size=SIZE : size of record batch (default: 128MB)\n"
 		  "     --direct-io : enables O_DIRECT for write-i/o\n"
+		  "     --shmem : writes out shared memory segments ('*.arrowshm' on\n"
+		  "       tmpfs) instead of Arrow files; arrow_fdw scans record batches\n"
+		  "       from the memory as soon as they are written.\n"
 		  "  -l|--limit=LIMIT : (default: no limit)\n"
+		  "     --rotate=INTERVAL\n"
+		  "       switches the output file per time window of the packets,\n"
+		  "       aligned to the local time; INTERVAL is seconds, or with\n"
+		  "       unit 's', 'm', 'h' or 'd' (e.g, '5m')\n"
+		  "     --manifest=FILE\n"
+		  "       appends the time range and bloom filter of the 5-tuple for\n"
+		  "       each output file; arrow_fdw can skip files using this.\n"
+		  "     --manifest-bloom=BITS : size of the bloom filter (default: 16384)\n"
 		  "  -p|--protocol=PROTO\n"
 		  "       PROTO is a comma separated string contains\n"
 		  "       the following tokens:\n"
@@ -2880,6 +3313,11 @@ parse_options(int argc, char *argv[])
 		{"parallel-write", required_argument, NULL, 1005},
 		{"composite-options", no_argument,    NULL, 1006},
 		{"interface-id",   no_argument,       NULL, 1007},
+		{"xdp",            no_argument,       NULL, 1008},
+		{"rotate",         required_argument, NULL, 1009},
+		{"manifest",       required_argument, NULL, 1010},
+		{"manifest-bloom", required_argument, NULL, 1011},
+		{"shmem",          no_argument,       NULL, 1012},
 		{"help",           no_argument,       NULL, 'h'},
 		{NULL, 0, NULL, 0}
 	};
@@ -3020,6 +3458,43 @@ parse_options(int argc, char *argv[])
 				enable_interface_id = true;
 				break;
 
+			case 1008:	/* --xdp */
+				use_af_xdp = true;
+				break;
+
+			case 1009:	/* --rotate */
+				output_rotate_interval = strtol(optarg, &pos, 10);
+				if (strcasecmp(pos, "m") == 0)
+					output_rotate_interval *= 60;
+				else if (strcasecmp(pos, "h") == 0)
+					output_rotate_interval *= 3600;
+				else if (strcasecmp(pos, "d") == 0)
+					output_rotate_interval *= 86400;
+				else if (*pos != '\0' && strcasecmp(pos, "s") != 0)
+					Elog("unknown unit '%s' in --rotate option", optarg);
+				if (output_rotate_interval <= 0)
+					Elog("invalid --rotate argument: %s", optarg);
+				output_rotate_interval *= 1000000L;
+				break;
+
+			case 1010:	/* --manifest */
+				manifest_filename = optarg;
+				break;
+
+			case 1011:	/* --manifest-bloom */
+				manifest_bloom_bits = strtol(optarg, &pos, 10);
+				if (*pos != '\0' ||
+					manifest_bloom_bits < 64 ||
+					manifest_bloom_bits > (1U << 24) ||
+					manifest_bloom_bits % 64 != 0)
+					Elog("invalid --manifest-bloom argument: %s (must be multiple of 64)",
+						 optarg);
+				break;
+
+			case 1012:	/* --shmem */
+				output_shmem = true;
+				break;
+
 			default:
 				usage(code == 'h' ? 0 : 1);
 				break;
@@ -3091,11 +3566,28 @@ parse_options(int argc, char *argv[])
 			}
 		}
 	}
+	if (output_shmem)
+	{
+		pos = strrchr(output_filename, '.');
+		if (!pos || strcmp(pos+1, ARROW_SHMEM_SUFFIX) != 0)
+			Elog("--shmem requires the output filename with '.%s' suffix",
+				 ARROW_SHMEM_SUFFIX);
+		if (enable_direct_io)
+			Elog("--shmem cannot be used with --direct-io");
+	}
 
 	/*
 	 * number of threads have different default; depending on the input
 	 */
-	if (input_devname)
+	if (input_devname && use_af_xdp)
+	{
+		/* --num-queues and --pcap-threads are fixed up by init_xdp_input */
+		if (num_threads < 0)
+			num_threads = 2 * NCPUS;
+		if (bpf_filter_rule)
+			Elog("-r|--rule cannot be used with --xdp");
+	}
+	else if (input_devname)
 	{
 		if (pfring_desc_nums < 0)
 			pfring_desc_nums = 4;
@@ -3112,11 +3604,56 @@ parse_options(int argc, char *argv[])
 			Elog("--pcap-threads cannot be used with PCAP input files");
 		if (pfring_desc_nums >= 0)
 			Elog("--num-queues cannot be used with PCAP input files");
+		if (use_af_xdp)
+			Elog("--xdp cannot be used with PCAP input files");
 		if (print_stat_interval > 0)
 			Elog("-s|--stat should be used with -i|--input=DEV option");
 	}
 }
 
+static void
+pfring_device_stats(uint64_t *p_recv_count, uint64_t *p_drop_count)
+{
+	pfring_stat	temp;
+	uint64_t	recv_count = 0;
+	uint64_t	drop_count = 0;
+	int			i;
+
+	for (i=0; i < pfring_desc_nums; i++)
+	{
+		pfring_stats(pfring_desc_array[i], &temp);
+		recv_count += temp.recv;
+		drop_count += temp.drop;
+	}
+	*p_recv_count = recv_count;
+	*p_drop_count = drop_count;
+}
+
+static void
+xdp_device_stats(uint64_t *p_recv_count, uint64_t *p_drop_count)
+{
+	uint64_t	recv_count = 0;
+	uint64_t	drop_count = 0;
+	int			i;
+
+	for (i=0; i < pfring_desc_nums; i++)
+	{
+		xdpSocketDesc *xsk = &xdp_desc_array[i];
+		struct xdp_statistics xstat;
+		socklen_t	optlen = sizeof(xstat);
+
+		recv_count += atomicRead64(&xsk->recv_count);
+		memset(&xstat, 0, sizeof(xstat));
+		if (getsockopt(xsk->fdesc, SOL_XDP, XDP_STATISTICS,
+					   &xstat, &optlen) == 0)
+			drop_count += (xstat.rx_dropped +
+						   xstat.rx_ring_full +
+						   xstat.rx_fill_ring_empty_descs);
+	}
+	*p_recv_count = recv_count;
+	*p_drop_count = drop_count;
+}
+
 static void
 pcap_print_stat(bool is_final_call)
 {
@@ -3127,7 +3664,8 @@ pcap_print_stat(bool is_final_call)
 	static uint64_t last_tcp_packet_count = 0;
 	static uint64_t last_udp_packet_count = 0;
 	static uint64_t last_icmp_packet_count = 0;
-	static pfring_stat last_pfring_stat = {0,0,0};
+	static uint64_t last_recv_count = 0;
+	static uint64_t last_drop_count = 0;
 	uint64_t curr_raw_packet_length = atomicRead64(&stat_raw_packet_length);
 	uint64_t curr_ip4_packet_count = atomicRead64(&stat_ip4_packet_count);
 	uint64_t curr_ip6_packet_count = atomicRead64(&stat_ip6_packet_count);
@@ -3135,21 +3673,18 @@ pcap_print_stat(bool is_final_call)
 	uint64_t curr_udp_packet_count = atomicRead64(&stat_udp_packet_count);
 	uint64_t curr_icmp_packet_count = atomicRead64(&stat_icmp_packet_count);
 	uint64_t diff_raw_packet_length;
-	pfring_stat	curr_pfring_stat, temp;
+	uint64_t	curr_recv_count;
+	uint64_t	curr_drop_count;
 	char		linebuf[1024];
 	char	   *pos = linebuf;
 	time_t		t = time(NULL);
 	struct tm	tm;
-	int			i;
 
 	localtime_r(&t, &tm);
-	pfring_stats(pfring_desc_array[0], &curr_pfring_stat);
-	for (i=1; i < pfring_desc_nums; i++)
-	{
-		pfring_stats(pfring_desc_array[i], &temp);
-		curr_pfring_stat.recv += temp.recv;
-		curr_pfring_stat.drop += temp.drop;
-	}
+	if (use_af_xdp)
+		xdp_device_stats(&curr_recv_count, &curr_drop_count);
+	else
+		pfring_device_stats(&curr_recv_count, &curr_drop_count);
 
 	if (is_final_call)
 	{
@@ -3157,8 +3692,8 @@ pcap_print_stat(bool is_final_call)
 			   "Recv packets: %lu\n"
 			   "Drop packets: %lu\n"
 			   "Total bytes: %lu\n",
-			   curr_pfring_stat.recv,
-			   curr_pfring_stat.drop,
+			   curr_recv_count,
+			   curr_drop_count,
 			   curr_raw_packet_length);
 		if ((protocol_mask & __PCAP_PROTO__IPv4) != 0)
 			printf("IPv4 packets: %lu\n", curr_ip4_packet_count);
@@ -3200,8 +3735,8 @@ pcap_print_stat(bool is_final_call)
 				   tm.tm_hour,
 				   tm.tm_min,
 				   tm.tm_sec,
-				   curr_pfring_stat.recv - last_pfring_stat.recv,
-				   curr_pfring_stat.drop - last_pfring_stat.drop);
+				   curr_recv_count - last_recv_count,
+				   curr_drop_count - last_drop_count);
 	diff_raw_packet_length = curr_raw_packet_length - last_raw_packet_length;
 	if (diff_raw_packet_length < 10000UL)
 		pos += sprintf(pos, "  % 8ldB", diff_raw_packet_length);
@@ -3238,7 +3773,8 @@ pcap_print_stat(bool is_final_call)
 	last_tcp_packet_count	= curr_tcp_packet_count;
 	last_udp_packet_count	= curr_udp_packet_count;
 	last_icmp_packet_count	= curr_icmp_packet_count;
-	last_pfring_stat		= curr_pfring_stat;
+	last_recv_count			= curr_recv_count;
+	last_drop_count			= curr_drop_count;
 }
 
 /*
@@ -3300,6 +3836,230 @@ init_pfring_input(void)
 	}
 }
 
+/*
+ * init_xdp_input - open the network device using AF_XDP sockets
+ *
+ * It binds an AF_XDP socket with its own UMEM for each RX queue, then
+ * attaches a tiny XDP program that redirects the packets to the socket
+ * of the receiving queue. The program is attached by BPF link, so it is
+ * detached automatically on exit of the process.
+ */
+static inline long
+__bpf_syscall(int cmd, union bpf_attr *attr)
+{
+	return syscall(__NR_bpf, cmd, attr, sizeof(union bpf_attr));
+}
+
+static int
+__xdp_get_num_queues(const char *devname)
+{
+	struct ethtool_channels ch;
+	struct ifreq ifr;
+	int			sockfd;
+	int			nqueues = 1;
+
+	sockfd = socket(AF_INET, SOCK_DGRAM, 0);
+	if (sockfd < 0)
+		Elog("failed on socket(2): %m");
+	memset(&ch, 0, sizeof(ch));
+	memset(&ifr, 0, sizeof(ifr));
+	ch.cmd = ETHTOOL_GCHANNELS;
+	strncpy(ifr.ifr_name, devname, IFNAMSIZ-1);
+	ifr.ifr_data = (void *)&ch;
+	if (ioctl(sockfd, SIOCETHTOOL, &ifr) == 0)
+	{
+		if (ch.combined_count + ch.rx_count > 0)
+			nqueues = ch.combined_count + ch.rx_count;
+	}
+	close(sockfd);
+
+	return nqueues;
+}
+
+static void
+__xdp_mmap_ring(xdpRing *ring, int fdesc, struct xdp_ring_offset *off,
+				size_t unitsz, uint32_t nitems, off_t pgoff)
+{
+	char	   *addr;
+
+	ring->mmap_sz = off->desc + unitsz * nitems;
+	addr = mmap(NULL, ring->mmap_sz, PROT_READ | PROT_WRITE,
+				MAP_SHARED | MAP_POPULATE, fdesc, pgoff);
+	if (addr == MAP_FAILED)
+		Elog("failed on mmap(2) for AF_XDP ring: %m");
+	ring->mmap_addr = addr;
+	ring->producer = (uint32_t *)(addr + off->producer);
+	ring->consumer = (uint32_t *)(addr + off->consumer);
+	ring->flags    = (uint32_t *)(addr + off->flags);
+	ring->ring     = (void *)(addr + off->desc);
+	ring->mask     = nitems - 1;
+}
+
+static void
+__xdp_open_socket(xdpSocketDesc *xsk, int ifindex, uint32_t queue_id)
+{
+	struct xdp_umem_reg umem_reg;
+	struct xdp_mmap_offsets off;
+	struct sockaddr_xdp sxdp;
+	socklen_t	optlen = sizeof(off);
+	uint32_t	nitems = XDP_NUM_FRAMES;
+	uint32_t	i;
+
+	xsk->queue_id = queue_id;
+	xsk->umem_sz = (size_t)XDP_NUM_FRAMES * XDP_FRAME_SIZE;
+	xsk->umem_area = mmap(NULL, xsk->umem_sz, PROT_READ | PROT_WRITE,
+						  MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
+	if (xsk->umem_area == MAP_FAILED)
+		Elog("failed on mmap(2) for AF_XDP UMEM: %m");
+	xsk->fdesc = socket(AF_XDP, SOCK_RAW, 0);
+	if (xsk->fdesc < 0)
+		Elog("failed on socket(AF_XDP): %m");
+	memset(&umem_reg, 0, sizeof(umem_reg));
+	umem_reg.addr = (uint64_t)xsk->umem_area;
+	umem_reg.len = xsk->umem_sz;
+	umem_reg.chunk_size = XDP_FRAME_SIZE;
+	umem_reg.headroom = 0;
+	if (setsockopt(xsk->fdesc, SOL_XDP, XDP_UMEM_REG,
+				   &umem_reg, sizeof(umem_reg)) != 0)
+		Elog("failed on setsockopt(XDP_UMEM_REG): %m");
+	if (setsockopt(xsk->fdesc, SOL_XDP, XDP_UMEM_FILL_RING,
+				   &nitems, sizeof(nitems)) != 0 ||
+		setsockopt(xsk->fdesc, SOL_XDP, XDP_UMEM_COMPLETION_RING,
+				   &nitems, sizeof(nitems)) != 0 ||
+		setsockopt(xsk->fdesc, SOL_XDP, XDP_RX_RING,
+				   &nitems, sizeof(nitems)) != 0)
+		Elog("failed on setsockopt for AF_XDP rings: %m");
+	if (getsockopt(xsk->fdesc, SOL_XDP, XDP_MMAP_OFFSETS, &off, &optlen) != 0)
+		Elog("failed on getsockopt(XDP_MMAP_OFFSETS): %m");
+	__xdp_mmap_ring(&xsk->fill, xsk->fdesc, &off.fr, sizeof(uint64_t),
+					nitems, XDP_UMEM_PGOFF_FILL_RING);
+	__xdp_mmap_ring(&xsk->comp, xsk->fdesc, &off.cr, sizeof(uint64_t),
+					nitems, XDP_UMEM_PGOFF_COMPLETION_RING);
+	__xdp_mmap_ring(&xsk->rx, xsk->fdesc, &off.rx, sizeof(struct xdp_desc),
+					nitems, XDP_PGOFF_RX_RING);
+	/* all the frames are given to the kernel first */
+	for (i=0; i < XDP_NUM_FRAMES; i++)
+		((uint64_t *)xsk->fill.ring)[i] = (uint64_t)i * XDP_FRAME_SIZE;
+	__atomic_store_n(xsk->fill.producer, XDP_NUM_FRAMES, __ATOMIC_RELEASE);
+
+	/* zero-copy mode, if the driver supports */
+	memset(&sxdp, 0, sizeof(sxdp));
+	sxdp.sxdp_family = AF_XDP;
+	sxdp.sxdp_ifindex = ifindex;
+	sxdp.sxdp_queue_id = queue_id;
+	sxdp.sxdp_flags = XDP_ZEROCOPY | XDP_USE_NEED_WAKEUP;
+	if (bind(xsk->fdesc, (struct sockaddr *)&sxdp, sizeof(sxdp)) != 0)
+	{
+		sxdp.sxdp_flags = XDP_COPY | XDP_USE_NEED_WAKEUP;
+		if (bind(xsk->fdesc, (struct sockaddr *)&sxdp, sizeof(sxdp)) != 0)
+			Elog("failed on bind(2) AF_XDP socket on %s queue-%u: %m",
+				 input_devname, queue_id);
+	}
+	pthreadMutexInit(&xsk->lock);
+}
+
+static void
+init_xdp_input(void)
+{
+	struct bpf_insn	insns[6];
+	union bpf_attr attr;
+	struct packet_mreq mreq;
+	int			ifindex;
+	int			packet_fd;
+	int			map_fd;
+	int			prog_fd;
+	int			link_fd;
+	uint32_t	i;
+
+	ifindex = if_nametoindex(input_devname);
+	if (ifindex == 0)
+		Elog("network device '%s' not found: %m", input_devname);
+	/* all the RX queues must be bound, to capture all the packets */
+	if (pfring_desc_nums < 0)
+		pfring_desc_nums = __xdp_get_num_queues(input_devname);
+	/* each RX ring is consumed by one thread at once */
+	if (num_pcap_threads < 0 || num_pcap_threads > pfring_desc_nums)
+		num_pcap_threads = pfring_desc_nums;
+	xdp_desc_array = palloc0(sizeof(xdpSocketDesc) * pfring_desc_nums);
+	for (i=0; i < pfring_desc_nums; i++)
+		__xdp_open_socket(&xdp_desc_array[i], ifindex, i);
+
+	/* queue-id -> AF_XDP socket map */
+	memset(&attr, 0, sizeof(attr));
+	attr.map_type = BPF_MAP_TYPE_XSKMAP;
+	attr.key_size = sizeof(uint32_t);
+	attr.value_size = sizeof(int);
+	attr.max_entries = pfring_desc_nums;
+	map_fd = __bpf_syscall(BPF_MAP_CREATE, &attr);
+	if (map_fd < 0)
+		Elog("failed on bpf(BPF_MAP_CREATE): %m");
+	for (i=0; i < pfring_desc_nums; i++)
+	{
+		int		sock_fd = xdp_desc_array[i].fdesc;
+
+		memset(&attr, 0, sizeof(attr));
+		attr.map_fd = map_fd;
+		attr.key = (uint64_t)&i;
+		attr.value = (uint64_t)&sock_fd;
+		if (__bpf_syscall(BPF_MAP_UPDATE_ELEM, &attr) != 0)
+			Elog("failed on bpf(BPF_MAP_UPDATE_ELEM): %m");
+	}
+
+	/*
+	 * return bpf_redirect_map(&xsks_map, ctx->rx_queue_index, XDP_PASS);
+	 *
+	 * packets on the queue without AF_XDP socket go to the network stack.
+	 */
+	memset(insns, 0, sizeof(insns));
+	insns[0].code = BPF_LDX | BPF_MEM | BPF_W;
+	insns[0].dst_reg = BPF_REG_2;
+	insns[0].src_reg = BPF_REG_1;
+	insns[0].off = offsetof(struct xdp_md, rx_queue_index);
+	insns[1].code = BPF_LD | BPF_DW | BPF_IMM;
+	insns[1].dst_reg = BPF_REG_1;
+	insns[1].src_reg = BPF_PSEUDO_MAP_FD;
+	insns[1].imm = map_fd;
+	/* insns[2] is the upper half of the 64bit immediate */
+	insns[3].code = BPF_ALU64 | BPF_MOV | BPF_K;
+	insns[3].dst_reg = BPF_REG_3;
+	insns[3].imm = XDP_PASS;
+	insns[4].code = BPF_JMP | BPF_CALL;
+	insns[4].imm = BPF_FUNC_redirect_map;
+	insns[5].code = BPF_JMP | BPF_EXIT;
+
+	memset(&attr, 0, sizeof(attr));
+	attr.prog_type = BPF_PROG_TYPE_XDP;
+	attr.insns = (uint64_t)insns;
+	attr.insn_cnt = sizeof(insns) / sizeof(struct bpf_insn);
+	attr.license = (uint64_t)"GPL";
+	strncpy(attr.prog_name, "pcap2arrow", sizeof(attr.prog_name) - 1);
+	prog_fd = __bpf_syscall(BPF_PROG_LOAD, &attr);
+	if (prog_fd < 0)
+		Elog("failed on bpf(BPF_PROG_LOAD): %m");
+
+	memset(&attr, 0, sizeof(attr));
+	attr.link_create.prog_fd = prog_fd;
+	attr.link_create.target_ifindex = ifindex;
+	attr.link_create.attach_type = BPF_XDP;
+	link_fd = __bpf_syscall(BPF_LINK_CREATE, &attr);
+	if (link_fd < 0)
+		Elog("failed on attach XDP program to %s: %m - "
+			 "another XDP program is attached, or kernel is older than v5.9?",
+			 input_devname);
+
+	/* promiscuous mode, reverted on exit */
+	packet_fd = socket(AF_PACKET, SOCK_RAW, 0);
+	if (packet_fd < 0)
+		Elog("failed on socket(AF_PACKET): %m");
+	memset(&mreq, 0, sizeof(mreq));
+	mreq.mr_ifindex = ifindex;
+	mreq.mr_type = PACKET_MR_PROMISC;
+	if (setsockopt(packet_fd, SOL_PACKET, PACKET_ADD_MEMBERSHIP,
+				   &mreq, sizeof(mreq)) != 0)
+		Elog("failed on setsockopt(PACKET_ADD_MEMBERSHIP): %m");
+	/* map_fd, prog_fd, link_fd and packet_fd are kept until exit */
+}
+
 int main(int argc, char *argv[])
 {
 	pthread_t  *workers;
@@ -3323,9 +4083,16 @@ int main(int argc, char *argv[])
 		chunk->fdesc = -1;
 		arrow_chunks_array[i] = chunk;
 	}
+	if (manifest_filename)
+		arrowOpenManifestFile();
 
 	if (input_devname)
-		init_pfring_input();
+	{
+		if (use_af_xdp)
+			init_xdp_input();
+		else
+			init_pfring_input();
+	}
 
 	/* open the output files, and related initialization */
 	arrow_file_desc_locks = palloc0(sizeof(pthread_mutex_t) * arrow_file_desc_nums);
@@ -3333,7 +4100,7 @@ int main(int argc, char *argv[])
 	for (i=0; i < arrow_file_desc_nums; i++)
 	{
 		pthreadMutexInit(&arrow_file_desc_locks[i]);
-		arrow_file_desc_array[i] = arrowOpenOutputFile();
+		arrow_file_desc_array[i] = arrowOpenOutputFile(time(NULL));
 	}
 
 	if (num_pcap_threads >= 0)
@@ -3354,14 +4121,14 @@ int main(int argc, char *argv[])
 	for (i=0; i < num_threads; i++)
 	{
 		rv = pthread_create(&workers[i], NULL,
-							input_devname ?
-							pfring_worker_main :
-							pcap_file_worker_main, (void *)i);
+							!input_devname ? pcap_file_worker_main :
+							use_af_xdp ? xdp_worker_main :
+							pfring_worker_main, (void *)i);
 		if (rv != 0)
 			Elog("failed on pthread_create: %s", strerror(rv));
 	}
 	/* print statistics */
-	if (pfring_desc_array && print_stat_interval > 0)
+	if (input_devname && print_stat_interval > 0)
 	{
 		sleep(print_stat_interval);
 		while (!do_shutdown)
@@ -8,10 +8,12 @@
  * it under the terms of the PostgreSQL License.
  */
 #include "sql2arrow.h"
+#include <endian.h>
 #include <limits.h>
 #include <libpq-fe.h>
 
 #define CURSOR_NAME		"curr_pg2arrow"
+#define PSTMT_DESC_NAME	"pstmt_pg2arrow_desc"
 static char	   *server_timezone = NULL;
 
 static void		pgsql_setup_composite_type(PGconn *conn,
@@ -44,12 +46,56 @@ typedef struct
 	const char	  **p_names;
 } PGSTATE_NL;
 
+/*
+ * PGSTATE_CLUSTER - state of --cluster-by
+ *
+ * The raw values of the fetched rows are buffered up to window_sz, then
+ * the rows are sorted by the cluster keys (Z-order if multiple keys) and
+ * put into the SQLtable in this order; so min/max statistics of the
+ * record-batches built from the window have narrower ranges.
+ */
+#define CLUSTER_KEY__SIGNED		1	/* int2/4/8, date, time, timestamp(tz) */
+#define CLUSTER_KEY__FLOAT		2	/* float4/8 */
+#define CLUSTER_KEY__BYTES		3	/* text, varchar, bpchar, bytea (prefix) */
+
+typedef struct
+{
+	uint64_t	zvalue;
+	uint32_t	offset;		/* offset of the row on the window */
+} PGSTATE_CLUSTER_ITEM;
+
+typedef struct
+{
+	int			nkeys;
+	int		   *key_index;		/* index of table->columns */
+	int		   *key_kind;		/* one of CLUSTER_KEY__* */
+	size_t		window_sz;		/* threshold of the window usage */
+	bool		filling;		/* true, if rows are buffered */
+	bool		end_of_scan;
+	SQLbuffer	rows;			/* (int32 length + value) x nfields per row */
+	uint32_t	nrows;
+	uint32_t	nrooms;
+	uint32_t   *row_offsets;	/* offset of the rows */
+	uint64_t   *row_keys;		/* order-preserving keys; nkeys x nrows */
+	PGSTATE_CLUSTER_ITEM *items;/* rows in the sorted order */
+	uint32_t	index;			/* next item to be put */
+} PGSTATE_CLUSTER;
+
 typedef struct
 {
 	PGconn	   *conn;
 	PGresult   *res;
 	uint32_t	nitems;
 	uint32_t	index;
+	bool		in_transaction;	/* transaction is already open */
+	/* if --copy is given */
+	bool		copy_mode;
+	bool		copy_header;	/* header of the copy stream is consumed */
+	char	   *copy_buf;		/* current CopyData message */
+	int			copy_len;
+	int			copy_pos;
+	/* if --cluster-by is given */
+	PGSTATE_CLUSTER *cluster;
 	/* if --nestloop is given */
 	uint32_t	n_depth;
 	PGSTATE_NL	nestloop[1];
@@ -379,6 +425,247 @@ pgsql_move_next(PGSTATE *pgstate, uint32_t *rows_index)
 	}
 }
 
+/*
+ * __pgsql_cluster_key - order-preserving 64bit key of the binary value
+ */
+static uint64_t
+__pgsql_cluster_key(int kind, const char *addr, int sz)
+{
+	uint64_t	key = 0;
+
+	if (!addr)
+		return 0;		/* NULLs first */
+	switch (kind)
+	{
+		case CLUSTER_KEY__SIGNED:
+			if (sz == sizeof(int16_t))
+			{
+				uint16_t	ival;
+
+				memcpy(&ival, addr, sizeof(uint16_t));
+				key = (uint64_t)((int64_t)((int16_t)be16toh(ival)));
+			}
+			else if (sz == sizeof(int32_t))
+			{
+				uint32_t	ival;
+
+				memcpy(&ival, addr, sizeof(uint32_t));
+				key = (uint64_t)((int64_t)((int32_t)be32toh(ival)));
+			}
+			else if (sz == sizeof(int64_t))
+			{
+				uint64_t	ival;
+
+				memcpy(&ival, addr, sizeof(uint64_t));
+				key = be64toh(ival);
+			}
+			else
+				Elog("unexpected length of the cluster key (%d)", sz);
+			return key ^ (1UL << 63);
+
+		case CLUSTER_KEY__FLOAT:
+			if (sz == sizeof(float))
+			{
+				uint32_t	ival;
+				float		fval;
+				double		dval;
+
+				memcpy(&ival, addr, sizeof(uint32_t));
+				ival = be32toh(ival);
+				memcpy(&fval, &ival, sizeof(float));
+				dval = fval;
+				memcpy(&key, &dval, sizeof(double));
+			}
+			else if (sz == sizeof(double))
+			{
+				memcpy(&key, addr, sizeof(uint64_t));
+				key = be64toh(key);
+			}
+			else
+				Elog("unexpected length of the cluster key (%d)", sz);
+			if ((key & (1UL << 63)) != 0)
+				return ~key;
+			return key | (1UL << 63);
+
+		case CLUSTER_KEY__BYTES:
+			memcpy(&key, addr, sz < sizeof(uint64_t) ? sz : sizeof(uint64_t));
+			return be64toh(key);
+
+		default:
+			Elog("unknown cluster key kind (%d)", kind);
+	}
+	return 0;
+}
+
+/*
+ * __pgsql_put_value
+ *
+ * It puts the value onto the SQLfield, or buffers it on the window of
+ * --cluster-by. index is the column index in the SQLtable.
+ */
+static size_t
+__pgsql_put_value(PGSTATE *pgstate, int index,
+				  SQLfield *column, const char *addr, int sz)
+{
+	PGSTATE_CLUSTER *cl = pgstate->cluster;
+	int32_t		len = (addr ? sz : -1);
+
+	if (!cl || !cl->filling)
+		return sql_field_put_value(column, addr, sz);
+
+	if (index == 0)
+	{
+		/* begin a new row */
+		if (cl->nrows >= cl->nrooms)
+		{
+			cl->nrooms = 2 * cl->nrooms + 10000;
+			cl->row_offsets = repalloc(cl->row_offsets,
+									   sizeof(uint32_t) * cl->nrooms);
+			cl->row_keys = repalloc(cl->row_keys,
+									sizeof(uint64_t) * cl->nkeys * cl->nrooms);
+		}
+		cl->row_offsets[cl->nrows] = cl->rows.usage;
+	}
+	sql_buffer_append(&cl->rows, &len, sizeof(int32_t));
+	if (addr)
+		sql_buffer_append(&cl->rows, addr, sz);
+	for (int k=0; k < cl->nkeys; k++)
+	{
+		if (cl->key_index[k] == index)
+			cl->row_keys[cl->nkeys * cl->nrows + k]
+				= __pgsql_cluster_key(cl->key_kind[k], addr, sz);
+	}
+	return 0;
+}
+
+static void
+__pgsql_put_row_end(PGSTATE *pgstate, SQLtable *table, size_t usage)
+{
+	PGSTATE_CLUSTER *cl = pgstate->cluster;
+
+	if (cl && cl->filling)
+		cl->nrows++;
+	else
+	{
+		table->usage = usage;
+		table->nitems++;
+	}
+}
+
+/*
+ * pgsql_copy_next
+ *
+ * It ensures the next tuple of the binary COPY stream on the copy_buf,
+ * or returns false if end of the stream. The backend sends a tuple per
+ * CopyData message (the file header is attached to the first one), so
+ * only one message is kept at once.
+ */
+static bool
+pgsql_copy_next(PGSTATE *pgstate)
+{
+	static const char copy_signature[11] = "PGCOPY\n\377\r\n\0";
+	PGconn	   *conn = pgstate->conn;
+	PGresult   *res;
+	int16_t		nfields;
+
+	for (;;)
+	{
+		if (pgstate->copy_pos >= pgstate->copy_len)
+		{
+			char   *buf = NULL;
+			int		len;
+
+			if (pgstate->copy_buf)
+				PQfreemem(pgstate->copy_buf);
+			pgstate->copy_buf = NULL;
+			pgstate->copy_len = 0;
+			pgstate->copy_pos = 0;
+
+			len = PQgetCopyData(conn, &buf, 0);
+			if (len == -1)
+				break;		/* end of the copy */
+			if (len < 0)
+				Elog("failed on PQgetCopyData: %s", PQerrorMessage(conn));
+			pgstate->copy_buf = buf;
+			pgstate->copy_len = len;
+		}
+		if (!pgstate->copy_header)
+		{
+			uint32_t	extlen;
+
+			if (pgstate->copy_len - pgstate->copy_pos < 19 ||
+				memcmp(pgstate->copy_buf + pgstate->copy_pos,
+					   copy_signature, sizeof(copy_signature)) != 0)
+				Elog("binary COPY stream has unexpected header");
+			memcpy(&extlen, pgstate->copy_buf + pgstate->copy_pos + 15,
+				   sizeof(uint32_t));
+			pgstate->copy_pos += 19 + be32toh(extlen);
+			pgstate->copy_header = true;
+			continue;
+		}
+		if (pgstate->copy_len - pgstate->copy_pos < sizeof(int16_t))
+			Elog("binary COPY stream is corrupted");
+		memcpy(&nfields, pgstate->copy_buf + pgstate->copy_pos,
+			   sizeof(int16_t));
+		if ((int16_t)be16toh(nfields) >= 0)
+			return true;	/* ok, a valid tuple */
+		/* file trailer; skip to the end of the copy */
+		pgstate->copy_pos = pgstate->copy_len;
+	}
+	/* no more tuples */
+	res = PQgetResult(conn);
+	if (PQresultStatus(res) != PGRES_COMMAND_OK)
+		Elog("SQL execution failed: %s", PQresultErrorMessage(res));
+	PQclear(res);
+	return false;
+}
+
+/*
+ * pgsql_copy_fetch_results
+ */
+static bool
+pgsql_copy_fetch_results(PGSTATE *pgstate, SQLtable *table)
+{
+	const char *pos;
+	const char *tail;
+	int16_t		nfields;
+	size_t		usage = 0;
+
+	if (!pgsql_copy_next(pgstate))
+		return false;		/* end of the scan */
+	pos = pgstate->copy_buf + pgstate->copy_pos;
+	tail = pgstate->copy_buf + pgstate->copy_len;
+	memcpy(&nfields, pos, sizeof(int16_t));
+	pos += sizeof(int16_t);
+	if (be16toh(nfields) != table->nfields)
+		Elog("binary COPY stream has unexpected number of fields (%d)",
+			 (int)be16toh(nfields));
+	for (int j=0; j < table->nfields; j++)
+	{
+		SQLfield   *column = &table->columns[j];
+		int32_t		sz;
+
+		if (tail - pos < sizeof(int32_t))
+			Elog("binary COPY stream is corrupted");
+		memcpy(&sz, pos, sizeof(int32_t));
+		pos += sizeof(int32_t);
+		sz = be32toh(sz);
+		if (sz < 0)
+			usage += __pgsql_put_value(pgstate, j, column, NULL, 0);
+		else
+		{
+			if (tail - pos < sz)
+				Elog("binary COPY stream is corrupted");
+			usage += __pgsql_put_value(pgstate, j, column, pos, sz);
+			pos += sz;
+		}
+	}
+	pgstate->copy_pos = pos - pgstate->copy_buf;
+	__pgsql_put_row_end(pgstate, table, usage);
+
+	return true;
+}
+
 /*
  * pgsql_create_dictionary
  */
@@ -1011,11 +1298,46 @@ sqldb_begin_query(void *sqldb_state,
 	PGresult   *res;
 	char	   *query;
 
-	/* begin read-only transaction */
-	res = PQexec(conn, "BEGIN READ ONLY");
-	if (PQresultStatus(res) != PGRES_COMMAND_OK)
-		Elog("unable to begin transaction: %s", PQresultErrorMessage(res));
-	PQclear(res);
+	/* begin read-only transaction, unless snapshot is shared */
+	if (!pgstate->in_transaction)
+	{
+		res = PQexec(conn, "BEGIN READ ONLY");
+		if (PQresultStatus(res) != PGRES_COMMAND_OK)
+			Elog("unable to begin transaction: %s", PQresultErrorMessage(res));
+		PQclear(res);
+		pgstate->in_transaction = true;
+	}
+
+	if (pgstate->copy_mode)
+	{
+		SQLtable   *table;
+
+		/* fetch the result types without execution */
+		res = PQprepare(conn, PSTMT_DESC_NAME, sqldb_command, 0, NULL);
+		if (PQresultStatus(res) != PGRES_COMMAND_OK)
+			Elog("failed on PQprepare: %s", PQresultErrorMessage(res));
+		PQclear(res);
+		res = PQdescribePrepared(conn, PSTMT_DESC_NAME);
+		if (PQresultStatus(res) != PGRES_COMMAND_OK)
+			Elog("failed on PQdescribePrepared: %s", PQresultErrorMessage(res));
+		pgstate->res = res;
+
+		/* start binary COPY stream */
+		query = palloc(strlen(sqldb_command) + 1024);
+		sprintf(query, "COPY (%s) TO STDOUT (FORMAT binary)", sqldb_command);
+		res = PQexec(conn, query);
+		if (PQresultStatus(res) != PGRES_COPY_OUT)
+			Elog("unable to start COPY: %s", PQresultErrorMessage(res));
+		PQclear(res);
+		pfree(query);
+
+		if (!pgsql_copy_next(pgstate))
+			return NULL;
+		table = pgsql_create_buffer(pgstate, af_info, dictionary_list);
+		PQclear(pgstate->res);
+		pgstate->res = NULL;
+		return table;
+	}
 
 	/* declare cursor */
 	query = palloc(strlen(sqldb_command) + 1024);
@@ -1032,6 +1354,318 @@ sqldb_begin_query(void *sqldb_state,
 	return pgsql_create_buffer(pgstate, af_info, dictionary_list);
 }
 
+/*
+ * sqldb_enable_copy_mode - fetch the results by binary COPY stream
+ *
+ * The results are parsed from the COPY TO STDOUT stream tuple by tuple,
+ * instead of materializing a PGresult of FETCH FORWARD on the client.
+ */
+void
+sqldb_enable_copy_mode(void *sqldb_state)
+{
+	PGSTATE	   *pgstate = sqldb_state;
+
+	if (pgstate->n_depth > 0)
+		Elog("--copy option cannot be used with --inner-join/--outer-join");
+	pgstate->copy_mode = true;
+}
+
+/*
+ * sqldb_export_snapshot - begin a transaction and export its snapshot
+ *
+ * It is used to share the snapshot with other connections by
+ * sqldb_import_snapshot(), for the parallel dump mode.
+ */
+char *
+sqldb_export_snapshot(void *sqldb_state)
+{
+	PGSTATE	   *pgstate = sqldb_state;
+	PGconn	   *conn = pgstate->conn;
+	PGresult   *res;
+	char	   *snapshot;
+
+	assert(!pgstate->in_transaction);
+	res = PQexec(conn, "BEGIN ISOLATION LEVEL REPEATABLE READ READ ONLY");
+	if (PQresultStatus(res) != PGRES_COMMAND_OK)
+		Elog("unable to begin transaction: %s", PQresultErrorMessage(res));
+	PQclear(res);
+	pgstate->in_transaction = true;
+
+	res = PQexec(conn, "SELECT pg_catalog.pg_export_snapshot()");
+	if (PQresultStatus(res) != PGRES_TUPLES_OK ||
+		PQntuples(res) != 1 ||
+		PQgetisnull(res, 0, 0))
+		Elog("failed on pg_export_snapshot(): %s", PQresultErrorMessage(res));
+	snapshot = pstrdup(PQgetvalue(res, 0, 0));
+	PQclear(res);
+
+	return snapshot;
+}
+
+/*
+ * sqldb_import_snapshot - begin a transaction with the exported snapshot
+ */
+void
+sqldb_import_snapshot(void *sqldb_state, const char *snapshot)
+{
+	PGSTATE	   *pgstate = sqldb_state;
+	PGconn	   *conn = pgstate->conn;
+	PGresult   *res;
+	char		query[200];
+
+	assert(!pgstate->in_transaction);
+	res = PQexec(conn, "BEGIN ISOLATION LEVEL REPEATABLE READ READ ONLY");
+	if (PQresultStatus(res) != PGRES_COMMAND_OK)
+		Elog("unable to begin transaction: %s", PQresultErrorMessage(res));
+	PQclear(res);
+	pgstate->in_transaction = true;
+
+	snprintf(query, sizeof(query), "SET TRANSACTION SNAPSHOT '%s'", snapshot);
+	res = PQexec(conn, query);
+	if (PQresultStatus(res) != PGRES_COMMAND_OK)
+		Elog("unable to import snapshot '%s': %s",
+			 snapshot, PQresultErrorMessage(res));
+	PQclear(res);
+}
+
+/*
+ * sqldb_release_snapshot - nothing to do on PostgreSQL; the exported
+ * snapshot is valid while the exporting transaction is open.
+ */
+void
+sqldb_release_snapshot(void *sqldb_state)
+{
+	/* nothing to do */
+}
+
+/*
+ * sqldb_exec_scalar - run a query that returns a single value
+ *
+ * It returns the value in text form, or NULL if it is NULL.
+ */
+char *
+sqldb_exec_scalar(void *sqldb_state, const char *query)
+{
+	PGSTATE	   *pgstate = sqldb_state;
+	PGresult   *res;
+	char	   *retval = NULL;
+
+	res = PQexec(pgstate->conn, query);
+	if (PQresultStatus(res) != PGRES_TUPLES_OK)
+		Elog("SQL execution failed: %s", PQresultErrorMessage(res));
+	if (PQntuples(res) != 1 || PQnfields(res) != 1)
+		Elog("unexpected number of results by: %s", query);
+	if (!PQgetisnull(res, 0, 0))
+		retval = pstrdup(PQgetvalue(res, 0, 0));
+	PQclear(res);
+
+	return retval;
+}
+
+/*
+ * sqldb_enable_cluster_mode - sort the results by the cluster keys
+ */
+void
+sqldb_enable_cluster_mode(void *sqldb_state,
+						  SQLtable *table,
+						  const char *cluster_keys,
+						  size_t window_sz)
+{
+	PGSTATE	   *pgstate = sqldb_state;
+	PGSTATE_CLUSTER *cl;
+	char	   *buffer = alloca(strlen(cluster_keys) + 1);
+	char	   *name, *pos;
+
+	if (window_sz == 0 || window_sz > (1UL << 31))
+		Elog("--cluster-window must be less than 2GB");
+	cl = palloc0(sizeof(PGSTATE_CLUSTER));
+	cl->key_index = palloc0(sizeof(int) * table->nfields);
+	cl->key_kind = palloc0(sizeof(int) * table->nfields);
+	cl->window_sz = window_sz;
+	sql_buffer_init(&cl->rows);
+
+	strcpy(buffer, cluster_keys);
+	for (name = strtok_r(buffer, ",", &pos);
+		 name != NULL;
+		 name = strtok_r(NULL, ",", &pos))
+	{
+		SQLfield   *column = NULL;
+		const char *typname;
+		int			j, kind;
+
+		while (*name == ' ' || *name == '\t')
+			name++;
+		for (j=strlen(name)-1; j >= 0 && (name[j] == ' ' || name[j] == '\t'); j--)
+			name[j] = '\0';
+		for (j=0; j < table->nfields; j++)
+		{
+			if (strcmp(table->columns[j].field_name, name) == 0)
+			{
+				column = &table->columns[j];
+				break;
+			}
+		}
+		if (!column)
+			Elog("field [%s], specified by --cluster-by, was not found", name);
+		if (cl->nkeys >= table->nfields)
+			Elog("too many --cluster-by keys");
+		typname = column->sql_type.pgsql.typname;
+		if (strcmp(column->sql_type.pgsql.typnamespace, "pg_catalog") != 0)
+			kind = 0;
+		else if (strcmp(typname, "int2") == 0 ||
+				 strcmp(typname, "int4") == 0 ||
+				 strcmp(typname, "int8") == 0 ||
+				 strcmp(typname, "date") == 0 ||
+				 strcmp(typname, "time") == 0 ||
+				 strcmp(typname, "timestamp") == 0 ||
+				 strcmp(typname, "timestamptz") == 0)
+			kind = CLUSTER_KEY__SIGNED;
+		else if (strcmp(typname, "float4") == 0 ||
+				 strcmp(typname, "float8") == 0)
+			kind = CLUSTER_KEY__FLOAT;
+		else if (strcmp(typname, "text") == 0 ||
+				 strcmp(typname, "varchar") == 0 ||
+				 strcmp(typname, "bpchar") == 0 ||
+				 strcmp(typname, "bytea") == 0)
+			kind = CLUSTER_KEY__BYTES;
+		else
+			kind = 0;
+		if (kind == 0)
+			Elog("field [%s; %s] is not supported for --cluster-by",
+				 name, typname);
+		cl->key_index[cl->nkeys] = j;
+		cl->key_kind[cl->nkeys] = kind;
+		cl->nkeys++;
+	}
+	if (cl->nkeys == 0)
+		Elog("no valid keys in --cluster-by");
+	pgstate->cluster = cl;
+}
+
+static int
+__pgsql_cluster_item_comp(const void *__a, const void *__b)
+{
+	const PGSTATE_CLUSTER_ITEM *a = __a;
+	const PGSTATE_CLUSTER_ITEM *b = __b;
+
+	if (a->zvalue != b->zvalue)
+		return (a->zvalue < b->zvalue ? -1 : 1);
+	return (a->offset < b->offset ? -1 : (a->offset > b->offset ? 1 : 0));
+}
+
+/*
+ * __pgsql_cluster_sort
+ *
+ * The keys are normalized to the range of the window, then interleaved
+ * bit by bit (Z-order) if multiple keys are given.
+ */
+static void
+__pgsql_cluster_sort(PGSTATE_CLUSTER *cl)
+{
+	int			nkeys = cl->nkeys;
+	uint64_t   *kmin = alloca(sizeof(uint64_t) * nkeys);
+	int		   *shift = alloca(sizeof(int) * nkeys);
+	int			nbits = 64 / nkeys;
+
+	if (cl->nrows == 0)
+		return;
+	for (int k=0; k < nkeys; k++)
+	{
+		uint64_t	__min = ~0UL;
+		uint64_t	__max = 0;
+
+		for (uint32_t i=0; i < cl->nrows; i++)
+		{
+			uint64_t	key = cl->row_keys[nkeys * i + k];
+
+			if (key < __min)
+				__min = key;
+			if (key > __max)
+				__max = key;
+		}
+		kmin[k] = __min;
+		shift[k] = (__max > __min ? __builtin_clzl(__max - __min) : 0);
+	}
+	cl->items = repalloc(cl->items, sizeof(PGSTATE_CLUSTER_ITEM) * cl->nrows);
+	for (uint32_t i=0; i < cl->nrows; i++)
+	{
+		uint64_t	zvalue = 0;
+
+		if (nkeys == 1)
+			zvalue = (cl->row_keys[i] - kmin[0]) << shift[0];
+		else
+		{
+			uint64_t   *norm = alloca(sizeof(uint64_t) * nkeys);
+
+			for (int k=0; k < nkeys; k++)
+				norm[k] = (cl->row_keys[nkeys * i + k] - kmin[k]) << shift[k];
+			for (int b=0; b < nbits; b++)
+			{
+				for (int k=0; k < nkeys; k++)
+					zvalue = (zvalue << 1) | ((norm[k] >> (63 - b)) & 1UL);
+			}
+		}
+		cl->items[i].zvalue = zvalue;
+		cl->items[i].offset = cl->row_offsets[i];
+	}
+	qsort(cl->items, cl->nrows, sizeof(PGSTATE_CLUSTER_ITEM),
+		  __pgsql_cluster_item_comp);
+}
+
+static bool		__pgsql_fetch_results(PGSTATE *pgstate, SQLtable *table);
+
+/*
+ * pgsql_cluster_fetch_results
+ */
+static bool
+pgsql_cluster_fetch_results(PGSTATE *pgstate, SQLtable *table)
+{
+	PGSTATE_CLUSTER *cl = pgstate->cluster;
+	const char *pos;
+	size_t		usage = 0;
+
+	while (cl->index >= cl->nrows)
+	{
+		if (cl->end_of_scan)
+			return false;
+		/* fill up the window by the next rows */
+		sql_buffer_clear(&cl->rows);
+		cl->nrows = 0;
+		cl->index = 0;
+		cl->filling = true;
+		while (cl->rows.usage < cl->window_sz)
+		{
+			if (!__pgsql_fetch_results(pgstate, table))
+			{
+				cl->end_of_scan = true;
+				break;
+			}
+		}
+		cl->filling = false;
+		__pgsql_cluster_sort(cl);
+	}
+	/* put the next row in the sorted order */
+	pos = cl->rows.data + cl->items[cl->index++].offset;
+	for (int j=0; j < table->nfields; j++)
+	{
+		int32_t		len;
+
+		memcpy(&len, pos, sizeof(int32_t));
+		pos += sizeof(int32_t);
+		if (len < 0)
+			usage += sql_field_put_value(&table->columns[j], NULL, 0);
+		else
+		{
+			usage += sql_field_put_value(&table->columns[j], pos, len);
+			pos += len;
+		}
+	}
+	table->usage = usage;
+	table->nitems++;
+
+	return true;
+}
+
 /*
  * sqldb_fetch_results
  */
@@ -1039,6 +1673,15 @@ bool
 sqldb_fetch_results(void *sqldb_state, SQLtable *table)
 {
 	PGSTATE	   *pgstate = sqldb_state;
+
+	if (pgstate->cluster)
+		return pgsql_cluster_fetch_results(pgstate, table);
+	return __pgsql_fetch_results(pgstate, table);
+}
+
+static bool
+__pgsql_fetch_results(PGSTATE *pgstate, SQLtable *table)
+{
 	PGresult   *res;
 	uint32_t   *rows_index;
 	uint32_t	index;
@@ -1046,6 +1689,9 @@ sqldb_fetch_results(void *sqldb_state, SQLtable *table)
 	int			i, j, ncols;
 	size_t		usage = 0;
 
+	if (pgstate->copy_mode)
+		return pgsql_copy_fetch_results(pgstate, table);
+
 	rows_index = alloca(sizeof(uint32_t) * (pgstate->n_depth + 1));
 	if (!pgsql_move_next(pgstate, rows_index))
 		return false;		/* end of the scan */
@@ -1082,12 +1728,10 @@ sqldb_fetch_results(void *sqldb_state, SQLtable *table)
 			addr = PQgetvalue(res, index, j);
 			sz = PQgetlength(res, index, j);
 		}
-		usage += sql_field_put_value(column, addr, sz);
+		usage += __pgsql_put_value(pgstate, i, column, addr, sz);
 	}
 	assert(depth == pgstate->n_depth);
-
-	table->usage = usage;
-	table->nitems++;
+	__pgsql_put_row_end(pgstate, table, usage);
 
 	return true;
 }
@@ -1109,12 +1753,20 @@ sqldb_close_connection(void *sqldb_state)
 		if (nl->res)
 			PQclear(nl->res);
 	}
-	/* close the cursor */
-	res = PQexec(conn, "CLOSE " CURSOR_NAME);
-	if (PQresultStatus(res) != PGRES_COMMAND_OK)
-		Elog("failed on close cursor '%s': %s", CURSOR_NAME,
-			 PQresultErrorMessage(res));
-	PQclear(res);
+	if (pgstate->copy_mode)
+	{
+		if (pgstate->copy_buf)
+			PQfreemem(pgstate->copy_buf);
+	}
+	else
+	{
+		/* close the cursor */
+		res = PQexec(conn, "CLOSE " CURSOR_NAME);
+		if (PQresultStatus(res) != PGRES_COMMAND_OK)
+			Elog("failed on close cursor '%s': %s", CURSOR_NAME,
+				 PQresultErrorMessage(res));
+		PQclear(res);
+	}
 	/* close the connection */
 	PQfinish(conn);
 }
@@ -12,7 +12,9 @@
 #include <ctype.h>
 #include <getopt.h>
 #include <limits.h>
+#include <pthread.h>
 #include <signal.h>
+#include <stdarg.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <strings.h>
@@ -29,9 +31,18 @@ static char	   *sqldb_password = NULL;
 static char	   *sqldb_database = NULL;
 static char	   *dump_arrow_filename = NULL;
 static char	   *stat_embedded_columns = NULL;
+static int		stat_zonemap_nrows = 0;
 static int		shows_progress = 0;
 static userConfigOption *sqldb_session_configs = NULL;
 static nestLoopOption *sqldb_nestloop_options = NULL;
+static char	   *sqldb_table_name = NULL;
+static int		num_parallel_workers = 0;
+static char	   *parallel_key_name = NULL;
+#ifdef __PG2ARROW__
+static int		sqldb_copy_mode = 0;
+static char	   *cluster_by_columns = NULL;
+static size_t	cluster_window_sz = 0;
+#endif
 
 /*
  * __trim
@@ -490,6 +501,8 @@ __enable_field_stats(SQLfield *field)
 	field->stat_enabled = retval;
 	memset(&field->stat_datum, 0, sizeof(SQLstat));
 	field->stat_list = NULL;
+	memset(&field->zone_datum, 0, sizeof(SQLstat));
+	field->zone_list = NULL;
 
 	if (field->element)
 	{
@@ -560,6 +573,27 @@ enable_embedded_stats(SQLtable *table)
 	}
 }
 
+static size_t
+parse_size_value(const char *value, const char *label)
+{
+	const char *pos = value;
+
+	while (isdigit(*pos))
+		pos++;
+	if (*pos == '\0')
+		return atol(value);
+	else if (strcasecmp(pos, "k") == 0 ||
+			 strcasecmp(pos, "kb") == 0)
+		return atol(value) * (1UL << 10);
+	else if (strcasecmp(pos, "m") == 0 ||
+			 strcasecmp(pos, "mb") == 0)
+		return atol(value) * (1UL << 20);
+	else if (strcasecmp(pos, "g") == 0 ||
+			 strcasecmp(pos, "gb") == 0)
+		return atol(value) * (1UL << 30);
+	Elog("%s is not valid: %s", label, value);
+}
+
 static void
 usage(void)
 {
@@ -577,6 +611,24 @@ usage(void)
 #ifdef __PG2ARROW__
 		  "      --inner-join=SUB_COMMAND\n"
 		  "      --outer-join=SUB_COMMAND\n"
+		  "      --cluster-by=COLUMNS\n"
+		  "                       sorts the results by the COLUMNS (comma-separated,\n"
+		  "                       Z-order if multiple) within the buffered window\n"
+		  "      --cluster-window=SIZE\n"
+		  "                       size of the window for --cluster-by\n"
+		  "                       (default: 4 times of the segment size)\n"
+		  "      --copy           fetches the results by binary COPY stream,\n"
+		  "                       instead of the cursor (no --inner/outer-join)\n"
+#endif
+		  "      --parallel=N     dumps the table (-t) using N connections in\n"
+		  "                       parallel, under the same snapshot\n"
+		  "      --parallel-key=COLUMN\n"
+		  "                       splits the table by the range of the integer\n"
+#ifdef __PG2ARROW__
+		  "                       COLUMN, instead of the ctid block ranges\n"
+#endif
+#ifdef __MYSQL2ARROW__
+		  "                       COLUMN (default: the integer primary key)\n"
 #endif
 		  "  -o, --output=FILENAME result file in Apache Arrow format\n"
 		  "      --append=FILENAME result Apache Arrow file to be appended\n"
@@ -585,6 +637,8 @@ usage(void)
 		  "  -S, --stat[=COLUMNS] embeds min/max statistics for each record batch\n"
 		  "                       COLUMNS is a comma-separated list of the target\n"
 		  "                       columns if partially enabled.\n"
+		  "      --zonemap=NROWS  embeds min/max statistics for every NROWS rows\n"
+		  "                       in addition to --stat, for the columns with stat\n"
 		  "\n"
 		  "Arrow format options:\n"
 		  "  -s, --segment-size=SIZE size of record batch for each\n"
@@ -638,6 +692,12 @@ parse_options(int argc, char * const argv[])
 		{"inner-join",   required_argument, NULL, 1004},
 		{"outer-join",   required_argument, NULL, 1005},
 		{"stat",         optional_argument, NULL, 'S'},
+		{"zonemap",      required_argument, NULL, 1006},
+		{"parallel",     required_argument, NULL, 1007},
+		{"parallel-key", required_argument, NULL, 1008},
+		{"copy",         no_argument,       NULL, 1009},
+		{"cluster-by",   required_argument, NULL, 1010},
+		{"cluster-window", required_argument, NULL, 1011},
 		{"help",         no_argument,       NULL, 9999},
 		{NULL, 0, NULL, 0},
 	};
@@ -645,7 +705,6 @@ parse_options(int argc, char * const argv[])
 	bool		meet_command = false;
 	bool		meet_table = false;
 	int			password_prompt = 0;
-	const char *pos;
 	userConfigOption *last_user_config = NULL;
 	nestLoopOption *last_nest_loop __attribute__((unused)) = NULL;
 
@@ -687,6 +746,7 @@ parse_options(int argc, char * const argv[])
 				if (!sqldb_command)
 					Elog("out of memory");
 				sprintf(sqldb_command, "SELECT * FROM %s", optarg);
+				sqldb_table_name = optarg;
 				break;
 
 			case 'o':
@@ -708,22 +768,7 @@ parse_options(int argc, char * const argv[])
 			case 's':
 				if (batch_segment_sz != 0)
 					Elog("-s option was supplied twice");
-				pos = optarg;
-				while (isdigit(*pos))
-					pos++;
-				if (*pos == '\0')
-					batch_segment_sz = atol(optarg);
-				else if (strcasecmp(pos, "k") == 0 ||
-						 strcasecmp(pos, "kb") == 0)
-					batch_segment_sz = atol(optarg) * (1UL << 10);
-				else if (strcasecmp(pos, "m") == 0 ||
-						 strcasecmp(pos, "mb") == 0)
-					batch_segment_sz = atol(optarg) * (1UL << 20);
-				else if (strcasecmp(pos, "g") == 0 ||
-						 strcasecmp(pos, "gb") == 0)
-					batch_segment_sz = atol(optarg) * (1UL << 30);
-				else
-					Elog("segment size is not valid: %s", optarg);
+				batch_segment_sz = parse_size_value(optarg, "segment size");
 				break;
 
 			case 'h':
@@ -821,6 +866,49 @@ parse_options(int argc, char * const argv[])
 						stat_embedded_columns = "*";
 				}
 				break;
+			case 1006:		/* --zonemap */
+				{
+					char   *end;
+					long	nrows = strtol(optarg, &end, 10);
+
+					if (*end != '\0' || nrows <= 0 || nrows > INT_MAX)
+						Elog("invalid --zonemap option: %s", optarg);
+					/* must be multiple of 64 for alignment of the null-bitmap */
+					stat_zonemap_nrows = TYPEALIGN(64, nrows);
+				}
+				break;
+			case 1007:		/* --parallel */
+				{
+					char   *end;
+					long	nworkers = strtol(optarg, &end, 10);
+
+					if (*end != '\0' || nworkers <= 0 || nworkers > 256)
+						Elog("invalid --parallel option: %s", optarg);
+					num_parallel_workers = nworkers;
+				}
+				break;
+			case 1008:		/* --parallel-key */
+				if (parallel_key_name)
+					Elog("--parallel-key option was supplied twice");
+				parallel_key_name = optarg;
+				break;
+#ifdef __PG2ARROW__
+			case 1009:		/* --copy */
+				if (sqldb_copy_mode)
+					Elog("--copy option was supplied twice");
+				sqldb_copy_mode = 1;
+				break;
+			case 1010:		/* --cluster-by */
+				if (cluster_by_columns)
+					Elog("--cluster-by option was supplied twice");
+				cluster_by_columns = optarg;
+				break;
+			case 1011:		/* --cluster-window */
+				if (cluster_window_sz != 0)
+					Elog("--cluster-window option was supplied twice");
+				cluster_window_sz = parse_size_value(optarg, "cluster window size");
+				break;
+#endif	/* __PG2ARROW__ */
 			case 9999:		/* --help */
 			default:
 				usage();
@@ -860,8 +948,457 @@ parse_options(int argc, char * const argv[])
 	}
 	if (!sqldb_command)
 		Elog("Neither -c nor -t options are supplied");
+	if (num_parallel_workers > 1 && !sqldb_table_name)
+		Elog("--parallel option must be used with -t");
+	if (parallel_key_name && num_parallel_workers <= 1)
+		Elog("--parallel-key option must be used with --parallel");
 	if (batch_segment_sz == 0)
 		batch_segment_sz = (1UL << 28);		/* 256MB in default */
+#ifdef __PG2ARROW__
+	if (cluster_window_sz != 0 && !cluster_by_columns)
+		Elog("--cluster-window option must be used with --cluster-by");
+	if (cluster_window_sz == 0)
+	{
+		cluster_window_sz = 4 * batch_segment_sz;
+		if (cluster_window_sz > (1UL << 31))
+			cluster_window_sz = (1UL << 31);
+	}
+#endif
+}
+
+/*
+ * setup_table_options
+ */
+static void
+setup_table_options(SQLtable *table)
+{
+	table->segment_sz = batch_segment_sz;
+	/* enables embedded min/max statistics, if any */
+	enable_embedded_stats(table);
+	if (stat_zonemap_nrows > 0)
+	{
+		if (!table->has_statistics)
+			Elog("--zonemap option must be used with --stat");
+		for (int j=0; j < table->nfields; j++)
+		{
+			SQLfield   *field = &table->columns[j];
+
+			/* only top-level fixed-length fields are supported */
+			if (field->stat_enabled && !field->element && field->nfields == 0)
+				field->zone_nrows = stat_zonemap_nrows;
+		}
+	}
+}
+
+/*
+ * setup_result_file
+ */
+static void
+setup_result_file(SQLtable *table, int append_fdesc, ArrowFileInfo *af_info)
+{
+	ArrowKeyValue  *kv;
+
+	/* save the SQL command as custom metadata */
+	kv = palloc0(sizeof(ArrowKeyValue));
+	initArrowNode(kv, KeyValue);
+	kv->key = "sql_command";
+	kv->_key_len = 11;
+	kv->value = sqldb_command;
+	kv->_value_len = strlen(sqldb_command);
+	table->customMetadata = kv;
+	table->numCustomMetadata = 1;
+
+	/* open & setup result file */
+	if (!append_filename)
+		setup_output_file(table, output_filename);
+	else
+	{
+		table->fdesc = append_fdesc;
+		table->filename = append_filename;
+		setup_append_file(table, af_info);
+	}
+	/* write out dictionary batch, if any */
+	writeArrowDictionaryBatches(table);
+}
+
+/*
+ * Parallel dump mode (--parallel=N)
+ *
+ * The first connection exports its snapshot, and the other connections
+ * import it, then each connection scans a part of the table (by ctid block
+ * ranges, or by --parallel-key ranges). The worker threads fetch and convert
+ * the results individually, and write out the record-batches onto the same
+ * result file under the lock; only the file I/O is serialized.
+ *
+ * MySQL has no exportable snapshot, so mysql_client.c opens the consistent
+ * snapshot on every connection under the global read lock, then releases
+ * the lock by sqldb_release_snapshot(). The table is split by the range of
+ * the integer primary key, if --parallel-key is not given.
+ */
+typedef struct
+{
+	void	   *sqldb_state;
+	char	   *sqldb_command;
+	SQLtable   *table;			/* NULL, if empty results */
+	pthread_t	thread;
+} parallelWorker;
+
+static SQLtable		   *parallel_file_table = NULL;	/* owner of the result file */
+static pthread_mutex_t	parallel_file_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static char *
+__build_parallel_command(const char *cond_fmt, ...)
+{
+	char	   *command = palloc(strlen(sqldb_table_name) + 1000);
+	char	   *pos;
+	va_list		ap;
+
+	pos = command + sprintf(command, "SELECT * FROM %s WHERE ", sqldb_table_name);
+	va_start(ap, cond_fmt);
+	vsprintf(pos, cond_fmt, ap);
+	va_end(ap);
+
+	return command;
+}
+
+#ifdef __MYSQL2ARROW__
+/*
+ * __lookup_primary_key - returns the column name of the primary key, if it
+ * consists of a single integer column.
+ */
+static char *
+__lookup_primary_key(void *sqldb_state)
+{
+	char		query[4096];
+	char		cond[2000];
+	const char *dot = strchr(sqldb_table_name, '.');
+	char	   *value;
+
+	if (dot)
+		snprintf(cond, sizeof(cond),
+				 "k.TABLE_SCHEMA = '%.*s' AND k.TABLE_NAME = '%s'",
+				 (int)(dot - sqldb_table_name), sqldb_table_name, dot + 1);
+	else
+		snprintf(cond, sizeof(cond),
+				 "k.TABLE_SCHEMA = DATABASE() AND k.TABLE_NAME = '%s'",
+				 sqldb_table_name);
+	snprintf(query, sizeof(query),
+			 "SELECT COUNT(*) FROM information_schema.KEY_COLUMN_USAGE k"
+			 " WHERE %s AND k.CONSTRAINT_NAME = 'PRIMARY'", cond);
+	value = sqldb_exec_scalar(sqldb_state, query);
+	if (!value || atol(value) != 1)
+		return NULL;
+	snprintf(query, sizeof(query),
+			 "SELECT k.COLUMN_NAME"
+			 "  FROM information_schema.KEY_COLUMN_USAGE k"
+			 "  JOIN information_schema.COLUMNS c"
+			 "    ON c.TABLE_SCHEMA = k.TABLE_SCHEMA"
+			 "   AND c.TABLE_NAME = k.TABLE_NAME"
+			 "   AND c.COLUMN_NAME = k.COLUMN_NAME"
+			 " WHERE %s AND k.CONSTRAINT_NAME = 'PRIMARY'"
+			 "   AND c.DATA_TYPE IN ('tinyint','smallint','mediumint',"
+			 "                       'int','bigint')", cond);
+	value = sqldb_exec_scalar(sqldb_state, query);
+	if (value)
+	{
+		char   *quoted = palloc(strlen(value) + 3);
+
+		sprintf(quoted, "`%s`", value);
+		value = quoted;
+	}
+	return value;
+}
+#endif	/* __MYSQL2ARROW__ */
+
+static void
+setup_parallel_commands(parallelWorker *workers, void *sqldb_state)
+{
+	char		query[4096];
+	char	   *value;
+	int			nworkers = num_parallel_workers;
+
+#ifdef __MYSQL2ARROW__
+	if (!parallel_key_name)
+	{
+		parallel_key_name = __lookup_primary_key(sqldb_state);
+		if (!parallel_key_name)
+			Elog("table '%s' has no single integer primary key, use --parallel-key",
+				 sqldb_table_name);
+	}
+#endif
+#ifdef __PG2ARROW__
+	if (!parallel_key_name)
+	{
+		/*
+		 * Split by ctid block ranges; TID range scan (PG14 or later) fetches
+		 * only the blocks in the range.  The relation size never shrinks
+		 * below the tuples visible in the snapshot, and the last worker has
+		 * no upper bound.
+		 */
+		int64_t		nblocks;
+		int64_t		unitsz;
+
+		snprintf(query, sizeof(query),
+				 "SELECT pg_catalog.pg_relation_size('%s'::regclass) /"
+				 " pg_catalog.current_setting('block_size')::bigint",
+				 sqldb_table_name);
+		value = sqldb_exec_scalar(sqldb_state, query);
+		nblocks = (value ? atol(value) : 0);
+		unitsz = (nblocks + nworkers - 1) / nworkers;
+		for (int k=0; k < nworkers; k++)
+		{
+			int64_t		lower = unitsz * k;
+			int64_t		upper = unitsz * (k + 1);
+
+			if (k == 0)
+				workers[k].sqldb_command =
+					__build_parallel_command("ctid < '(%ld,0)'::tid", upper);
+			else if (k == nworkers - 1)
+				workers[k].sqldb_command =
+					__build_parallel_command("ctid >= '(%ld,0)'::tid", lower);
+			else
+				workers[k].sqldb_command =
+					__build_parallel_command("ctid >= '(%ld,0)'::tid AND"
+											 " ctid < '(%ld,0)'::tid",
+											 lower, upper);
+		}
+		return;
+	}
+#endif	/* __PG2ARROW__ */
+	{
+		/*
+		 * Split by the range of the integer key; NULL keys are fetched by
+		 * the first worker.
+		 */
+		const char *key = parallel_key_name;
+		int64_t		kmin, kmax;
+		int128_t	unitsz;
+
+		snprintf(query, sizeof(query),
+#ifdef __PG2ARROW__
+				 "SELECT pg_catalog.min(%s)::bigint FROM %s",
+#else
+				 "SELECT CAST(MIN(%s) AS SIGNED) FROM %s",
+#endif
+				 key, sqldb_table_name);
+		value = sqldb_exec_scalar(sqldb_state, query);
+		if (!value)
+		{
+			/* no valid keys; the first worker fetches everything */
+			workers[0].sqldb_command = sqldb_command;
+			return;
+		}
+		kmin = atol(value);
+		snprintf(query, sizeof(query),
+#ifdef __PG2ARROW__
+				 "SELECT pg_catalog.max(%s)::bigint FROM %s",
+#else
+				 "SELECT CAST(MAX(%s) AS SIGNED) FROM %s",
+#endif
+				 key, sqldb_table_name);
+		value = sqldb_exec_scalar(sqldb_state, query);
+		kmax = (value ? atol(value) : kmin);
+		unitsz = ((int128_t)kmax - (int128_t)kmin) / nworkers + 1;
+		for (int k=0; k < nworkers; k++)
+		{
+			int64_t		lower = kmin + (int64_t)(unitsz * k);
+			int64_t		upper = kmin + (int64_t)(unitsz * (k + 1));
+
+			if ((int128_t)kmin + unitsz * k > (int128_t)kmax)
+				break;		/* no more ranges */
+			if (k == 0 && (int128_t)kmin + unitsz > (int128_t)kmax)
+			{
+				/* too narrow range to split */
+				workers[k].sqldb_command = sqldb_command;
+				break;
+			}
+			else if (k == 0)
+				workers[k].sqldb_command =
+					__build_parallel_command("%s < %ld OR %s IS NULL",
+											 key, upper, key);
+			else if (k == nworkers - 1 ||
+					 (int128_t)kmin + unitsz * (k + 1) > (int128_t)kmax)
+				workers[k].sqldb_command =
+					__build_parallel_command("%s >= %ld", key, lower);
+			else
+				workers[k].sqldb_command =
+					__build_parallel_command("%s >= %ld AND %s < %ld",
+											 key, lower, key, upper);
+		}
+	}
+}
+
+static void
+parallel_write_record_batch(SQLtable *table)
+{
+	SQLtable   *ftable = parallel_file_table;
+
+	pthread_mutex_lock(&parallel_file_lock);
+	if (table != ftable)
+	{
+		table->fdesc = ftable->fdesc;
+		table->filename = ftable->filename;
+		table->f_pos = ftable->f_pos;
+		table->recordBatches = ftable->recordBatches;
+		table->numRecordBatches = ftable->numRecordBatches;
+	}
+	writeArrowRecordBatch(table);
+	shows_record_batch_progress(table, table->nitems);
+	if (table != ftable)
+	{
+		ftable->f_pos = table->f_pos;
+		ftable->recordBatches = table->recordBatches;
+		ftable->numRecordBatches = table->numRecordBatches;
+	}
+	pthread_mutex_unlock(&parallel_file_lock);
+	sql_table_clear(table);
+}
+
+static void *
+parallel_worker_main(void *__priv)
+{
+	parallelWorker *pw = __priv;
+	SQLtable   *table = pw->table;
+
+	while (sqldb_fetch_results(pw->sqldb_state, table))
+	{
+		if (table->usage > batch_segment_sz)
+			parallel_write_record_batch(table);
+	}
+	if (table->nitems > 0)
+		parallel_write_record_batch(table);
+	return NULL;
+}
+
+static SQLstat *
+__merge_stat_list(SQLstat *dst, SQLstat *src)
+{
+	while (src)
+	{
+		SQLstat	   *next = src->next;
+
+		src->next = dst;
+		dst = src;
+		src = next;
+	}
+	return dst;
+}
+
+static int
+parallel_main(int append_fdesc, ArrowFileInfo *af_info,
+			  SQLdictionary *sql_dict_list)
+{
+	parallelWorker *workers;
+	int			nworkers = num_parallel_workers;
+	char	   *snapshot = NULL;
+
+	workers = palloc0(sizeof(parallelWorker) * nworkers);
+	/* open connections under the same snapshot */
+	for (int k=0; k < nworkers; k++)
+	{
+		workers[k].sqldb_state = sqldb_server_connect(sqldb_hostname,
+													  sqldb_port_num,
+													  sqldb_username,
+													  sqldb_password,
+													  sqldb_database,
+													  sqldb_session_configs,
+													  sqldb_nestloop_options);
+#ifdef __PG2ARROW__
+		if (sqldb_copy_mode)
+			sqldb_enable_copy_mode(workers[k].sqldb_state);
+#endif
+		if (k == 0)
+			snapshot = sqldb_export_snapshot(workers[k].sqldb_state);
+		else
+			sqldb_import_snapshot(workers[k].sqldb_state, snapshot);
+	}
+	sqldb_release_snapshot(workers[0].sqldb_state);
+	setup_parallel_commands(workers, workers[0].sqldb_state);
+	/*
+	 * begin SQL command execution; the dictionaries of enum types are shared
+	 * with the result file owner, so these are built one by one.
+	 */
+	for (int k=0; k < nworkers; k++)
+	{
+		parallelWorker *pw = &workers[k];
+
+		if (!pw->sqldb_command)
+			continue;
+		pw->table = sqldb_begin_query(pw->sqldb_state,
+									  pw->sqldb_command,
+									  append_filename ? af_info : NULL,
+									  parallel_file_table
+									  ? parallel_file_table->sql_dict_list
+									  : sql_dict_list);
+		if (!pw->table)
+			continue;
+		setup_table_options(pw->table);
+#ifdef __PG2ARROW__
+		if (cluster_by_columns)
+			sqldb_enable_cluster_mode(pw->sqldb_state, pw->table,
+									  cluster_by_columns,
+									  cluster_window_sz);
+#endif
+		if (!parallel_file_table)
+			parallel_file_table = pw->table;
+	}
+	if (!parallel_file_table)
+		Elog("Empty results by the query: %s", sqldb_command);
+	setup_result_file(parallel_file_table, append_fdesc, af_info);
+
+	/* launch the worker threads */
+	for (int k=0; k < nworkers; k++)
+	{
+		parallelWorker *pw = &workers[k];
+
+		if (!pw->table)
+			continue;
+		if ((errno = pthread_create(&pw->thread, NULL,
+									parallel_worker_main, pw)) != 0)
+			Elog("failed on pthread_create: %m");
+	}
+	for (int k=0; k < nworkers; k++)
+	{
+		parallelWorker *pw = &workers[k];
+
+		if (!pw->table)
+			continue;
+		if ((errno = pthread_join(pw->thread, NULL)) != 0)
+			Elog("failed on pthread_join: %m");
+	}
+	/* merge the min/max statistics into the file owner */
+	for (int k=0; k < nworkers; k++)
+	{
+		parallelWorker *pw = &workers[k];
+
+		if (pw->table && pw->table != parallel_file_table)
+		{
+			for (int j=0; j < parallel_file_table->nfields; j++)
+			{
+				SQLfield   *dst = &parallel_file_table->columns[j];
+				SQLfield   *src = &pw->table->columns[j];
+
+				dst->stat_list = __merge_stat_list(dst->stat_list,
+												   src->stat_list);
+				dst->zone_list = __merge_stat_list(dst->zone_list,
+												   src->zone_list);
+				src->stat_list = NULL;
+				src->zone_list = NULL;
+			}
+		}
+	}
+	/* write out footer portion */
+	writeArrowFooter(parallel_file_table);
+
+	/* cleanup */
+	for (int k=0; k < nworkers; k++)
+	{
+		if (workers[k].table)
+			sqldb_close_connection(workers[k].sqldb_state);
+	}
+	close(parallel_file_table->fdesc);
+
+	return 0;
 }
 
 /*
@@ -873,7 +1410,6 @@ int main(int argc, char * const argv[])
 	ArrowFileInfo	af_info;
 	void		   *sqldb_state;
 	SQLtable	   *table;
-	ArrowKeyValue  *kv;
 	SQLdictionary  *sql_dict_list = NULL;
 	
 	parse_options(argc, argv);
@@ -882,14 +1418,6 @@ int main(int argc, char * const argv[])
 	if (dump_arrow_filename)
 		return dumpArrowFile(dump_arrow_filename);
 
-	/* open connection */
-	sqldb_state = sqldb_server_connect(sqldb_hostname,
-									   sqldb_port_num,
-									   sqldb_username,
-									   sqldb_password,
-									   sqldb_database,
-									   sqldb_session_configs,
-									   sqldb_nestloop_options);
 	/* read the original arrow file, if --append mode */
 	if (append_filename)
 	{
@@ -899,6 +1427,21 @@ int main(int argc, char * const argv[])
 		readArrowFileDesc(append_fdesc, &af_info);
 		sql_dict_list = loadArrowDictionaryBatches(append_fdesc, &af_info);
 	}
+	/* special case if --parallel=N */
+	if (num_parallel_workers > 1)
+		return parallel_main(append_fdesc, &af_info, sql_dict_list);
+	/* open connection */
+	sqldb_state = sqldb_server_connect(sqldb_hostname,
+									   sqldb_port_num,
+									   sqldb_username,
+									   sqldb_password,
+									   sqldb_database,
+									   sqldb_session_configs,
+									   sqldb_nestloop_options);
+#ifdef __PG2ARROW__
+	if (sqldb_copy_mode)
+		sqldb_enable_copy_mode(sqldb_state);
+#endif
 	/* begin SQL command execution */
 	table = sqldb_begin_query(sqldb_state,
 							  sqldb_command,
@@ -906,32 +1449,15 @@ int main(int argc, char * const argv[])
 							  sql_dict_list);
 	if (!table)
 		Elog("Empty results by the query: %s", sqldb_command);
-	table->segment_sz = batch_segment_sz;
-	/* enables embedded min/max statistics, if any */
-	enable_embedded_stats(table);
-
-	/* save the SQL command as custom metadata */
-	kv = palloc0(sizeof(ArrowKeyValue));
-	initArrowNode(kv, KeyValue);
-	kv->key = "sql_command";
-	kv->_key_len = 11;
-	kv->value = sqldb_command;
-	kv->_value_len = strlen(sqldb_command);
-	table->customMetadata = kv;
-	table->numCustomMetadata = 1;
+	setup_table_options(table);
+#ifdef __PG2ARROW__
+	if (cluster_by_columns)
+		sqldb_enable_cluster_mode(sqldb_state, table,
+								  cluster_by_columns,
+								  cluster_window_sz);
+#endif
+	setup_result_file(table, append_fdesc, &af_info);
 
-	/* open & setup result file */
-	if (!append_filename)
-		setup_output_file(table, output_filename);
-	else
-	{
-		table->fdesc = append_fdesc;
-		table->filename = append_filename;
-		setup_append_file(table, &af_info);
-	}
-	/* write out dictionary batch, if any */
-	writeArrowDictionaryBatches(table);
-	
 	/* main loop to fetch and write result */
 	while (sqldb_fetch_results(sqldb_state, table))
 	{
@@ -39,6 +39,25 @@ sqldb_fetch_results(void *sqldb_state, SQLtable *table);
 extern void
 sqldb_close_connection(void *sqldb_state);
 
+/* only pg2arrow */
+extern void
+sqldb_enable_copy_mode(void *sqldb_state);
+extern void
+sqldb_enable_cluster_mode(void *sqldb_state,
+						  SQLtable *table,
+						  const char *cluster_keys,
+						  size_t window_sz);
+
+/* only --parallel mode */
+extern char *
+sqldb_export_snapshot(void *sqldb_state);
+extern void
+sqldb_import_snapshot(void *sqldb_state, const char *snapshot);
+extern void
+sqldb_release_snapshot(void *sqldb_state);
+extern char *
+sqldb_exec_scalar(void *sqldb_state, const char *query);
+
 /* misc functions */
 extern void	   *palloc(size_t sz);
 extern void	   *palloc0(size_t sz);
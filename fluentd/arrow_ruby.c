@@ -10,13 +10,18 @@
  * it under the terms of the PostgreSQL License.
  */
 #include <ruby.h>
+#include <ruby/thread.h>
 #include <ctype.h>
 #include <libgen.h>
+#include <pthread.h>
+#include <setjmp.h>
 #include <sys/file.h>
 #include "float2.h"
-#define Elog(fmt,...)							\
-	rb_raise(rb_eException, "%s:%d " fmt,		\
-			 __FILE__, __LINE__, ##__VA_ARGS__)
+static void __arrowFileElog(const char *filename, int lineno,
+							const char *fmt, ...)
+	__attribute__((format(printf, 3, 4), noreturn));
+#define Elog(fmt,...)										\
+	__arrowFileElog(__FILE__, __LINE__, fmt, ##__VA_ARGS__)
 #include "arrow_ipc.h"
 
 /*
@@ -26,6 +31,8 @@
 #define IP4ADDR_LEN		4
 #define IP6ADDR_LEN		16
 
+static void		arrowFileWriterStart(VALUE self);
+
 static inline char *
 trim_cstring(char *str)
 {
@@ -74,22 +81,62 @@ rb_puts(VALUE obj)
 	return rb_funcall(rb_mKernel, rb_intern("puts"), 1, obj);
 }
 
+/*
+ * error reporting
+ *
+ * Elog() raises a Ruby exception, however, the background writer thread
+ * (async mode) never touches the Ruby VM. It saves the error message and
+ * jumps back to the recovery point of the writer thread instead.
+ */
+#define ARROW_WRITER_ERRBUF_SZ		1024
+/* ruby.h replaces them by ruby_xxx, but we need %m support of glibc */
+#undef snprintf
+#undef vsnprintf
+static __thread jmp_buf	   *arrow_writer_jmpbuf = NULL;
+static __thread char	   *arrow_writer_errbuf = NULL;
+
+static void
+__arrowFileElog(const char *filename, int lineno, const char *fmt, ...)
+{
+	char		__buf[ARROW_WRITER_ERRBUF_SZ];
+	char	   *buf = (arrow_writer_errbuf ? arrow_writer_errbuf : __buf);
+	int			errno_saved = errno;
+	int			n;
+	va_list		ap;
+
+	n = snprintf(buf, ARROW_WRITER_ERRBUF_SZ, "%s:%d ", filename, lineno);
+	errno = errno_saved;
+	va_start(ap, fmt);
+	vsnprintf(buf + n, ARROW_WRITER_ERRBUF_SZ - n, fmt, ap);
+	va_end(ap);
+	if (arrow_writer_jmpbuf)
+		longjmp(*arrow_writer_jmpbuf, 1);
+	rb_raise(rb_eException, "%s", buf);
+}
+
 /*
  * memory allocation wrapper
+ *
+ * It uses plain malloc, not ruby_xmalloc, because the background writer
+ * thread allocates and releases the buffers without the GVL.
  */
 void *
 palloc(size_t sz)
 {
-	return ruby_xmalloc(sz);
+	void   *ptr = malloc(sz);
+
+	if (!ptr)
+		Elog("out of memory");
+	return ptr;
 }
 
 void *
 palloc0(size_t sz)
 {
-	void   *ptr = ruby_xmalloc(sz);
-
-	memset(ptr, 0, sz);
+	void   *ptr = calloc(1, sz);
 
+	if (!ptr)
+		Elog("out of memory");
 	return ptr;
 }
 
@@ -118,13 +165,17 @@ pstrdup_ruby(VALUE datum)
 void *
 repalloc(void *old, size_t sz)
 {
-	return ruby_xrealloc(old, sz);
+	void   *ptr = realloc(old, sz);
+
+	if (!ptr)
+		Elog("out of memory");
+	return ptr;
 }
 
 void
 pfree(void *ptr)
 {
-	ruby_xfree(ptr);
+	free(ptr);
 }
 
 /* ----------------------------------------------------------------
@@ -1569,6 +1620,9 @@ __arrowFileWriteParseParams(VALUE self,
 	VALUE		ts_column = Qnil;
 	VALUE		tag_column = Qnil;
 	long		f_threshold = 10000;
+	bool		async_mode = false;
+	long		queue_depth = 4;
+	bool		fsync_batch = false;
 	int			i, count;
 
 	if (CLASS_OF(__params) == rb_cHash)
@@ -1592,6 +1646,32 @@ __arrowFileWriteParseParams(VALUE self,
 			if (f_threshold < 16 || f_threshold > 1048576)
 				Elog("filesize_threshold must be [16...1048576]");
 		}
+
+		datum = rb_funcall(__params, rb_intern("fetch"), 2,
+						   rb_str_new_cstr("async"), Qnil);
+		if (datum != Qnil && datum != Qfalse)
+			async_mode = true;
+
+		datum = rb_funcall(__params, rb_intern("fetch"), 2,
+						   rb_str_new_cstr("queue_depth"), Qnil);
+		if (datum != Qnil)
+		{
+			datum = rb_funcall(datum, rb_intern("to_i"), 0);
+			queue_depth = NUM2LONG(datum);
+			if (queue_depth < 1 || queue_depth > 64)
+				Elog("queue_depth must be [1...64]");
+		}
+
+		datum = rb_funcall(__params, rb_intern("fetch"), 2,
+						   rb_str_new_cstr("fsync"), Qnil);
+		if (datum != Qnil)
+		{
+			datum = rb_funcall(datum, rb_intern("to_s"), 0);
+			if (strcmp(StringValueCStr(datum), "batch") == 0)
+				fsync_batch = true;
+			else if (strcmp(StringValueCStr(datum), "none") != 0)
+				Elog("fsync must be either of 'none' or 'batch'");
+		}
 	}
 	else if (__params != Qnil)
 		Elog("ArrowFileWrite: parameters must be Hash");
@@ -1624,6 +1704,9 @@ __arrowFileWriteParseParams(VALUE self,
 	}
 	rb_ivar_set(self, rb_intern("filesize_threshold"),
 				LONG2NUM(f_threshold << 20));
+	rb_ivar_set(self, rb_intern("async"), async_mode ? Qtrue : Qfalse);
+	rb_ivar_set(self, rb_intern("queue_depth"), LONG2NUM(queue_depth));
+	rb_ivar_set(self, rb_intern("fsync"), fsync_batch ? Qtrue : Qfalse);
 }
 
 static VALUE
@@ -1637,6 +1720,8 @@ rb_ArrowFileWrite__initialize(VALUE self,
 	__arrowFileWritePathnameValidator(self, __pathname);
 	__arrowFileWriteParseSchemaDefs(self, __schema_defs);
 	__arrowFileWriteParseParams(self, __params);
+	if (rb_ivar_get(self, rb_intern("async")) == Qtrue)
+		arrowFileWriterStart(self);
 
 	return self;
 }
@@ -1721,15 +1806,20 @@ arrowFileCloseFile(SQLtable *table)
 	}
 }
 
+/*
+ * arrowFileOpenFile
+ *
+ * It opens the destination file, then returns true if it is a new file.
+ * The pathname is not a Ruby object, because the background writer thread
+ * also calls this routine.
+ */
 static bool
-arrowFileOpenFile(VALUE self, SQLtable *table)
+arrowFileOpenFile(const char *str, uint32_t len, long threshold,
+				  SQLtable *table)
 {
-	VALUE		pathname = rb_ivar_get(self, rb_intern("pathname"));
-	VALUE		threshold = rb_ivar_get(self, rb_intern("filesize_threshold"));
-	const char *str;
 	char	   *buf = alloca(2000);
 	uint32_t	bufsz = 2000;
-	uint32_t	i, j, len;
+	uint32_t	i, j;
 	int			fdesc;
 	time_t		__time;
 	struct tm	tm;
@@ -1737,9 +1827,6 @@ arrowFileOpenFile(VALUE self, SQLtable *table)
 	__time = time(NULL);
 	localtime_r(&__time, &tm);
 
-	assert(CLASS_OF(pathname) == rb_cString);
-	str = RSTRING_PTR(pathname);
-	len = RSTRING_LEN(pathname);
 	for (i=0, j=0; i < len; i++)
 	{
 		int		c = str[i];
@@ -1811,7 +1898,7 @@ arrowFileOpenFile(VALUE self, SQLtable *table)
 		if (fstat(fdesc, &stat_buf) != 0)
 			Elog("failed on fstat('%s'): %m", buf);
 		/* check threshold */
-		if (stat_buf.st_size < NUM2LONG(threshold))
+		if (stat_buf.st_size < threshold)
 			return (stat_buf.st_size == 0);		/* true, if new file */
 		/* file rotation, then retry */
 		__arrowFileSwitchFile(table, &stat_buf);
@@ -1997,11 +2084,49 @@ arrowFileSetupAppend(SQLtable *table)
 	table->f_pos = offset;
 }
 
+/*
+ * arrowFileWriter - state of the background writer thread (async mode)
+ *
+ * writeChunk converts the chunk into the column buffers under the GVL, then
+ * hands over the SQLtable to the writer thread; it writes out the record
+ * batch with statistics and the footer, and optionally fsync, without the
+ * GVL. The results are reported to pollWriteResults by the chunk_id.
+ */
+typedef struct arrowFileWriteJob
+{
+	struct arrowFileWriteJob *next;
+	SQLtable   *table;			/* released by the writer thread */
+	char	   *chunk_id;		/* unique_id of the chunk, if any */
+	size_t		chunk_id_len;
+	char	   *errmsg;			/* error message, if failed */
+} arrowFileWriteJob;
+
+typedef struct
+{
+	pthread_mutex_t	lock;
+	pthread_cond_t	cond;
+	pthread_t		thread;
+	bool			thread_valid;
+	bool			shutdown;		/* no more jobs */
+	bool			interrupted;	/* by the unblocking function */
+	char		   *pathname;
+	uint32_t		pathname_len;
+	long			threshold;
+	bool			fsync_batch;
+	int				queue_depth;
+	int				num_pending;	/* number of the queued/running jobs */
+	arrowFileWriteJob *pending_head;
+	arrowFileWriteJob **pending_tail;
+	arrowFileWriteJob *results_head;
+	arrowFileWriteJob **results_tail;
+} arrowFileWriter;
+
 typedef struct
 {
 	VALUE		self;
 	VALUE		chunk;
 	SQLtable   *table;
+	arrowFileWriter *writer;	/* NULL, if sync mode */
 } WriteChunkArgs;
 
 static SQLtable *
@@ -2100,6 +2225,7 @@ __arrowFileReleaseTable(SQLtable *table)
 		if (column->customMetadata)
 			pfree(column->customMetadata);
 	}
+	pfree(table);
 }
 
 static VALUE
@@ -2136,11 +2262,303 @@ __arrowFileWriteRow(RB_BLOCK_CALL_FUNC_ARGLIST(__yield, __private))
 	return Qtrue;
 }
 
+/*
+ * arrowFileWriteOut
+ *
+ * It writes out the record batch and the footer onto the destination file.
+ * Both of writeChunk (sync mode) and the writer thread (async mode) call
+ * this routine, so it must not touch any Ruby objects.
+ */
+static void
+arrowFileWriteOut(SQLtable *table,
+				  const char *pathname, uint32_t pathname_len,
+				  long threshold, bool fsync_batch)
+{
+	/* open the destination file */
+	if (arrowFileOpenFile(pathname, pathname_len, threshold, table))
+		arrowFileSetupNewFile(table);
+	else
+		arrowFileSetupAppend(table);
+	/* write out a new record-batch */
+	writeArrowRecordBatch(table);
+	/* write out a new footer */
+	writeArrowFooter(table);
+	/* ensure the record-batch is durable, if fsync=batch */
+	if (fsync_batch && fsync(table->fdesc) != 0)
+		Elog("failed on fsync('%s'): %m", table->filename);
+	/* close the file, and unlock */
+	arrowFileCloseFile(table);
+}
+
+/* ----------------------------------------------------------------
+ *
+ * Routines related to the background writer thread (async mode)
+ *
+ * ----------------------------------------------------------------
+ */
+static void *
+arrowFileWriterMain(void *__priv)
+{
+	arrowFileWriter *writer = __priv;
+	char		errbuf[ARROW_WRITER_ERRBUF_SZ];
+	jmp_buf		jbuf;
+
+	arrow_writer_errbuf = errbuf;
+	arrow_writer_jmpbuf = &jbuf;
+
+	pthread_mutex_lock(&writer->lock);
+	for (;;)
+	{
+		arrowFileWriteJob *job = writer->pending_head;
+
+		if (!job)
+		{
+			if (writer->shutdown)
+				break;
+			pthread_cond_wait(&writer->cond, &writer->lock);
+			continue;
+		}
+		writer->pending_head = job->next;
+		if (!writer->pending_head)
+			writer->pending_tail = &writer->pending_head;
+		pthread_mutex_unlock(&writer->lock);
+
+		if (setjmp(jbuf) == 0)
+		{
+			arrowFileWriteOut(job->table,
+							  writer->pathname,
+							  writer->pathname_len,
+							  writer->threshold,
+							  writer->fsync_batch);
+		}
+		else
+		{
+			arrowFileCloseFile(job->table);
+			job->errmsg = strdup(errbuf);
+		}
+		__arrowFileReleaseTable(job->table);
+		job->table = NULL;
+
+		pthread_mutex_lock(&writer->lock);
+		job->next = NULL;
+		*writer->results_tail = job;
+		writer->results_tail = &job->next;
+		writer->num_pending--;
+		pthread_cond_broadcast(&writer->cond);
+	}
+	pthread_mutex_unlock(&writer->lock);
+
+	return NULL;
+}
+
+static void
+__arrowFileWriterFreeJob(arrowFileWriteJob *job)
+{
+	if (job->table)
+		__arrowFileReleaseTable(job->table);
+	if (job->chunk_id)
+		pfree(job->chunk_id);
+	if (job->errmsg)
+		free(job->errmsg);
+	pfree(job);
+}
+
+static void
+__arrowFileWriterStop(arrowFileWriter *writer)
+{
+	if (writer->thread_valid)
+	{
+		pthread_mutex_lock(&writer->lock);
+		writer->shutdown = true;
+		pthread_cond_broadcast(&writer->cond);
+		pthread_mutex_unlock(&writer->lock);
+
+		pthread_join(writer->thread, NULL);
+		writer->thread_valid = false;
+	}
+}
+
+static void
+arrowFileWriterFree(void *__priv)
+{
+	arrowFileWriter *writer = __priv;
+	arrowFileWriteJob *job;
+
+	/* pending jobs are written out prior to the termination */
+	__arrowFileWriterStop(writer);
+	while ((job = writer->results_head) != NULL)
+	{
+		writer->results_head = job->next;
+		__arrowFileWriterFreeJob(job);
+	}
+	pthread_cond_destroy(&writer->cond);
+	pthread_mutex_destroy(&writer->lock);
+	pfree(writer->pathname);
+	pfree(writer);
+}
+
+static const rb_data_type_t arrowFileWriterType = {
+	"ArrowFileWriter",
+	{ NULL, arrowFileWriterFree, NULL, },
+	NULL, NULL, 0,
+};
+
+static void
+arrowFileWriterStart(VALUE self)
+{
+	VALUE		pathname = rb_ivar_get(self, rb_intern("pathname"));
+	VALUE		threshold = rb_ivar_get(self, rb_intern("filesize_threshold"));
+	VALUE		queue_depth = rb_ivar_get(self, rb_intern("queue_depth"));
+	VALUE		fsync_batch = rb_ivar_get(self, rb_intern("fsync"));
+	arrowFileWriter *writer;
+	VALUE		obj;
+
+	assert(CLASS_OF(pathname) == rb_cString);
+	writer = palloc0(sizeof(arrowFileWriter));
+	pthread_mutex_init(&writer->lock, NULL);
+	pthread_cond_init(&writer->cond, NULL);
+	writer->pathname = pstrdup_ruby(pathname);
+	writer->pathname_len = RSTRING_LEN(pathname);
+	writer->threshold = NUM2LONG(threshold);
+	writer->fsync_batch = (fsync_batch == Qtrue);
+	writer->queue_depth = NUM2INT(queue_depth);
+	writer->pending_tail = &writer->pending_head;
+	writer->results_tail = &writer->results_head;
+	obj = TypedData_Wrap_Struct(rb_cObject, &arrowFileWriterType, writer);
+	rb_ivar_set(self, rb_intern("writer"), obj);
+
+	if ((errno = pthread_create(&writer->thread, NULL,
+								arrowFileWriterMain, writer)) != 0)
+		Elog("failed on pthread_create: %m");
+	writer->thread_valid = true;
+}
+
+static arrowFileWriter *
+arrowFileWriterLookup(VALUE self)
+{
+	VALUE		obj = rb_ivar_get(self, rb_intern("writer"));
+
+	if (obj == Qnil)
+		return NULL;
+	return (arrowFileWriter *)rb_check_typeddata(obj, &arrowFileWriterType);
+}
+
+/*
+ * arrowFileWriterWait
+ *
+ * It waits for the writer thread without the GVL, until the number of
+ * pending jobs gets 'max_pending' or less, or any results are ready if
+ * 'wait_results', or the 'deadline'.
+ */
+typedef struct
+{
+	arrowFileWriter *writer;
+	int			max_pending;
+	bool		wait_results;
+	struct timespec *deadline;
+} arrowFileWriterWaitArgs;
+
+static void *
+__arrowFileWriterWait(void *__priv)
+{
+	arrowFileWriterWaitArgs *wargs = __priv;
+	arrowFileWriter *writer = wargs->writer;
+
+	pthread_mutex_lock(&writer->lock);
+	while (writer->num_pending > wargs->max_pending &&
+		   !(wargs->wait_results && writer->results_head) &&
+		   !writer->interrupted)
+	{
+		if (!wargs->deadline)
+			pthread_cond_wait(&writer->cond, &writer->lock);
+		else if (pthread_cond_timedwait(&writer->cond,
+										&writer->lock,
+										wargs->deadline) == ETIMEDOUT)
+			break;
+	}
+	writer->interrupted = false;
+	pthread_mutex_unlock(&writer->lock);
+
+	return NULL;
+}
+
+static void
+__arrowFileWriterUnblock(void *__priv)
+{
+	arrowFileWriter *writer = __priv;
+
+	pthread_mutex_lock(&writer->lock);
+	writer->interrupted = true;
+	pthread_cond_broadcast(&writer->cond);
+	pthread_mutex_unlock(&writer->lock);
+}
+
+static void
+arrowFileWriterWait(arrowFileWriter *writer,
+					int max_pending,
+					bool wait_results,
+					struct timespec *deadline)
+{
+	arrowFileWriterWaitArgs wargs;
+
+	wargs.writer = writer;
+	wargs.max_pending = max_pending;
+	wargs.wait_results = wait_results;
+	wargs.deadline = deadline;
+	rb_thread_call_without_gvl(__arrowFileWriterWait, &wargs,
+							   __arrowFileWriterUnblock, writer);
+	/* raise an exception, if interrupted */
+	rb_thread_check_ints();
+}
+
+/*
+ * arrowFileWriterEnqueue
+ *
+ * It hands over the SQLtable to the writer thread, then waits for the room
+ * of the queue. The job is already owned by the writer thread, even if an
+ * interrupt raises an exception during the wait.
+ */
+static void
+arrowFileWriterEnqueue(arrowFileWriter *writer,
+					   SQLtable *table, VALUE chunk_id)
+{
+	arrowFileWriteJob *job = palloc0(sizeof(arrowFileWriteJob));
+	bool		queue_is_full;
+
+	if (chunk_id != Qnil)
+	{
+		job->chunk_id_len = RSTRING_LEN(chunk_id);
+		job->chunk_id = palloc(job->chunk_id_len);
+		memcpy(job->chunk_id, RSTRING_PTR(chunk_id), job->chunk_id_len);
+	}
+	job->table = table;
+
+	pthread_mutex_lock(&writer->lock);
+	if (writer->shutdown)
+	{
+		pthread_mutex_unlock(&writer->lock);
+		__arrowFileWriterFreeJob(job);
+		Elog("ArrowFileWrite is already closed");
+	}
+	*writer->pending_tail = job;
+	writer->pending_tail = &job->next;
+	writer->num_pending++;
+	queue_is_full = (writer->num_pending > writer->queue_depth);
+	pthread_cond_broadcast(&writer->cond);
+	pthread_mutex_unlock(&writer->lock);
+
+	if (queue_is_full)
+		arrowFileWriterWait(writer, writer->queue_depth, false, NULL);
+}
+
 static VALUE
 __arrowFileWriteChunk(VALUE __args)
 {
 	WriteChunkArgs *args = (WriteChunkArgs *)__args;
 	SQLtable   *table;
+	VALUE		pathname;
+	VALUE		threshold;
+	VALUE		fsync_batch;
 
 	/* setup SQLtable buffer */
 	args->table = table = __arrowFileCreateTable(args->self);
@@ -2151,32 +2569,45 @@ __arrowFileWriteChunk(VALUE __args)
 				  NULL,
 				  __arrowFileWriteRow,
 				  __args);
-	/* open the destination file */
-	if (arrowFileOpenFile(args->self, args->table))
-		arrowFileSetupNewFile(args->table);
-	else
-		arrowFileSetupAppend(args->table);
-	/* write out a new record-batch */
-	writeArrowRecordBatch(table);
-	/* write out a new footer */
-	writeArrowFooter(table);
-	/* close the file, and unlock */
-	arrowFileCloseFile(table);
+	/* async mode hands over the buffer to the writer thread */
+	if (args->writer)
+		return Qtrue;
 
+	pathname = rb_ivar_get(args->self, rb_intern("pathname"));
+	threshold = rb_ivar_get(args->self, rb_intern("filesize_threshold"));
+	fsync_batch = rb_ivar_get(args->self, rb_intern("fsync"));
+	assert(CLASS_OF(pathname) == rb_cString);
+	arrowFileWriteOut(table,
+					  RSTRING_PTR(pathname),
+					  RSTRING_LEN(pathname),
+					  NUM2LONG(threshold),
+					  fsync_batch == Qtrue);
 	return Qtrue;
 }
 
+/*
+ * writeChunk(chunk, chunk_id = nil)
+ *
+ * In async mode, it returns when the chunk is converted and queued; the
+ * result is reported to pollWriteResults with the chunk_id.
+ */
 static VALUE
-rb_ArrowFileWrite__writeChunk(VALUE self,
-							  VALUE chunk)
+rb_ArrowFileWrite__writeChunk(int argc, VALUE *argv, VALUE self)
 {
 	WriteChunkArgs args;
+	VALUE		chunk;
+	VALUE		chunk_id;
 	VALUE		retval;
 	int			status;
 
+	rb_scan_args(argc, argv, "11", &chunk, &chunk_id);
+	if (chunk_id != Qnil)
+		StringValue(chunk_id);
+
 	memset(&args, 0, sizeof(WriteChunkArgs));
 	args.self  = self;
 	args.chunk = chunk;
+	args.writer = arrowFileWriterLookup(self);
 
 	retval = rb_protect(__arrowFileWriteChunk, (VALUE)&args, &status);
 	if (status != 0)
@@ -2189,12 +2620,98 @@ rb_ArrowFileWrite__writeChunk(VALUE self,
 		}
 		rb_jump_tag(status);
 	}
+	if (args.writer)
+	{
+		/* the writer thread owns the buffer from now on */
+		arrowFileWriterEnqueue(args.writer, args.table, chunk_id);
+		return retval;
+	}
 	assert(args.table->fdesc < 0);
 	__arrowFileReleaseTable(args.table);
 
 	return retval;
 }
 
+/*
+ * pollWriteResults(timeout = nil)
+ *
+ * It returns an array of [chunk_id, error message or nil] for the chunks
+ * written out by the writer thread. It waits for the results up to the
+ * timeout seconds, if no results are ready yet.
+ */
+static VALUE
+rb_ArrowFileWrite__pollWriteResults(int argc, VALUE *argv, VALUE self)
+{
+	arrowFileWriter *writer = arrowFileWriterLookup(self);
+	arrowFileWriteJob *job;
+	VALUE		timeout;
+	VALUE		results;
+
+	rb_scan_args(argc, argv, "01", &timeout);
+	if (!writer)
+		Elog("ArrowFileWrite is not in async mode");
+	if (timeout != Qnil)
+	{
+		double		sec = NUM2DBL(timeout);
+
+		if (sec > 0.0)
+		{
+			struct timespec	deadline;
+
+			clock_gettime(CLOCK_REALTIME, &deadline);
+			deadline.tv_sec  += (time_t)sec;
+			deadline.tv_nsec += (long)((sec - floor(sec)) * 1000000000.0);
+			if (deadline.tv_nsec >= 1000000000L)
+			{
+				deadline.tv_sec++;
+				deadline.tv_nsec -= 1000000000L;
+			}
+			arrowFileWriterWait(writer, -1, true, &deadline);
+		}
+	}
+	pthread_mutex_lock(&writer->lock);
+	job = writer->results_head;
+	writer->results_head = NULL;
+	writer->results_tail = &writer->results_head;
+	pthread_mutex_unlock(&writer->lock);
+
+	results = rb_ary_new();
+	while (job)
+	{
+		arrowFileWriteJob *next = job->next;
+
+		rb_ary_push(results,
+					rb_assoc_new(job->chunk_id
+								 ? rb_str_new(job->chunk_id, job->chunk_id_len)
+								 : Qnil,
+								 job->errmsg
+								 ? rb_str_new_cstr(job->errmsg)
+								 : Qnil));
+		__arrowFileWriterFreeJob(job);
+		job = next;
+	}
+	return results;
+}
+
+/*
+ * close
+ *
+ * It waits for the pending chunks to be written out, then terminates the
+ * writer thread. The results are still available by pollWriteResults.
+ */
+static VALUE
+rb_ArrowFileWrite__close(VALUE self)
+{
+	arrowFileWriter *writer = arrowFileWriterLookup(self);
+
+	if (writer && writer->thread_valid)
+	{
+		arrowFileWriterWait(writer, 0, false, NULL);
+		__arrowFileWriterStop(writer);
+	}
+	return Qnil;
+}
+
 void
 Init_arrow_file_write(void)
 {
@@ -2202,5 +2719,8 @@ Init_arrow_file_write(void)
 
 	klass = rb_define_class("ArrowFileWrite",  rb_cObject);
 	rb_define_method(klass, "initialize", rb_ArrowFileWrite__initialize, 3);
-	rb_define_method(klass, "writeChunk", rb_ArrowFileWrite__writeChunk, 1);
+	rb_define_method(klass, "writeChunk", rb_ArrowFileWrite__writeChunk, -1);
+	rb_define_method(klass, "pollWriteResults",
+					 rb_ArrowFileWrite__pollWriteResults, -1);
+	rb_define_method(klass, "close", rb_ArrowFileWrite__close, 0);
 }
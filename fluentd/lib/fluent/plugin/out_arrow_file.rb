@@ -6,7 +6,7 @@ module Fluent
     class ArrowFileOutput < Fluent::Plugin::Output
       Fluent::Plugin.register_output("arrow_file", self)
 
-      helpers :inject, :compat_parameters
+      helpers :inject, :compat_parameters, :thread
 
       desc "The Path of the arrow file"
       config_param :path, :string
@@ -14,6 +14,12 @@ module Fluent
       config_param :ts_column, :string, default: NIL
       config_param :tag_column, :string, default: NIL
       config_param :filesize_threshold, :integer, default: 10000
+      desc "Write out record batches by the background writer thread"
+      config_param :async_write, :bool, default: false
+      desc "Number of converted chunks queued for the background writer"
+      config_param :async_queue_depth, :integer, default: 4
+      desc "fsync policy of the arrow file (none or batch)"
+      config_param :fsync, :enum, list: [:none, :batch], default: :none
 
       config_section :buffer do
         config_set_default :@type, 'memory'
@@ -25,6 +31,11 @@ module Fluent
       def prefer_buffered_processing
         true
       end
+
+      # async_write commits the chunk once the writer thread wrote it out
+      def prefer_delayed_commit
+        @async_write
+      end
   
       def multi_workers_ready?
         false
@@ -34,7 +45,37 @@ module Fluent
         compat_parameters_convert(conf, :buffer, :inject, default_chunk_key: "time")
         super
 
-        @af=ArrowFileWrite.new(@path,@schema_defs,{"ts_column" => @ts_column,"tag_column" => @tag_column,"filesize_threshold" => @filesize_threshold})
+        @af=ArrowFileWrite.new(@path,@schema_defs,{"ts_column" => @ts_column,"tag_column" => @tag_column,"filesize_threshold" => @filesize_threshold,"async" => @async_write,"queue_depth" => @async_queue_depth,"fsync" => @fsync.to_s})
+      end
+
+      def start
+        super
+        if @async_write
+          thread_create(:arrow_file_commit) do
+            while thread_current_running?
+              commit_write_results(1.0)
+            end
+          end
+        end
+      end
+
+      def shutdown
+        if @async_write
+          @af.close
+          commit_write_results(nil)
+        end
+        super
+      end
+
+      def commit_write_results(timeout)
+        @af.pollWriteResults(timeout).each do |chunk_id, errmsg|
+          if errmsg.nil?
+            commit_write(chunk_id)
+          else
+            log.warn "failed to write out chunk", chunk_id: dump_unique_id_hex(chunk_id), error: errmsg
+            rollback_write(chunk_id, update_retry: true)
+          end
+        end
       end
 
       def format(tag,time,record)
@@ -49,6 +90,10 @@ module Fluent
       def write(chunk)
         @af.writeChunk(chunk)
       end
+
+      def try_write(chunk)
+        @af.writeChunk(chunk, chunk.unique_id)
+      end
     end
   end
 end
@@ -48,6 +48,10 @@ PG_FUNCTION_INFO_V1(pgstrom_fsum_final_fp64_as_numeric);
 PG_FUNCTION_INFO_V1(pgstrom_favg_final_int);
 PG_FUNCTION_INFO_V1(pgstrom_favg_final_fp);
 PG_FUNCTION_INFO_V1(pgstrom_favg_final_num);
+PG_FUNCTION_INFO_V1(pgstrom_partial_sum_numeric);
+PG_FUNCTION_INFO_V1(pgstrom_fsum_trans_numeric);
+PG_FUNCTION_INFO_V1(pgstrom_fsum_final_numeric);
+PG_FUNCTION_INFO_V1(pgstrom_favg_final_numeric);
 
 PG_FUNCTION_INFO_V1(pgstrom_partial_variance);
 PG_FUNCTION_INFO_V1(pgstrom_stddev_trans);
@@ -75,6 +79,25 @@ PG_FUNCTION_INFO_V1(pgstrom_regr_sxx_final);
 PG_FUNCTION_INFO_V1(pgstrom_regr_sxy_final);
 PG_FUNCTION_INFO_V1(pgstrom_regr_syy_final);
 
+PG_FUNCTION_INFO_V1(pgstrom_partial_quantile);
+PG_FUNCTION_INFO_V1(pgstrom_pquantile_accum);
+PG_FUNCTION_INFO_V1(pgstrom_percentile_approx_trans);
+PG_FUNCTION_INFO_V1(pgstrom_percentile_approx_final);
+PG_FUNCTION_INFO_V1(pgstrom_partial_topk);
+PG_FUNCTION_INFO_V1(pgstrom_ptopk_accum);
+PG_FUNCTION_INFO_V1(pgstrom_top_k_trans);
+PG_FUNCTION_INFO_V1(pgstrom_top_k_final);
+PG_FUNCTION_INFO_V1(pgstrom_partial_array);
+PG_FUNCTION_INFO_V1(pgstrom_parray_accum);
+PG_FUNCTION_INFO_V1(pgstrom_pstring_accum);
+PG_FUNCTION_INFO_V1(pgstrom_array_agg_final);
+PG_FUNCTION_INFO_V1(pgstrom_string_agg_final);
+
+PG_FUNCTION_INFO_V1(pgstrom_hll_sketch_new);
+PG_FUNCTION_INFO_V1(pgstrom_hll_sketch_merge);
+PG_FUNCTION_INFO_V1(pgstrom_hll_count_final);
+PG_FUNCTION_INFO_V1(pgstrom_hll_sketch_histogram);
+
 /*
  * float8 validator
  */
@@ -487,6 +510,163 @@ pgstrom_favg_final_num(PG_FUNCTION_ARGS)
 	PG_RETURN_DATUM(DirectFunctionCall2(numeric_div, sum, n));
 }
 
+/*
+ * SUM(X),AVG(X) on NUMERIC by the exact 128bit fixed-point
+ */
+#define KAGG_NUMERIC_FIXED_POINT_LIMIT	\
+	((int128_t)1 << KAGG_NUMERIC_FIXED_POINT_BITS)
+
+PUBLIC_FUNCTION(Datum)
+pgstrom_partial_sum_numeric(PG_FUNCTION_ARGS)
+{
+	Datum		num = PG_GETARG_DATUM(0);
+	int32_t		scale = PG_GETARG_INT32(1);
+	kagg_state__psum_numeric_packed *r;
+	char	   *str, *pos;
+	bool		negative = false;
+	int			nfracs = -1;		/* -1 until the decimal point */
+	int128_t	ival = 0;
+
+	str = DatumGetCString(DirectFunctionCall1(numeric_out, num));
+	pos = str;
+	if (*pos == '-')
+	{
+		negative = true;
+		pos++;
+	}
+	else if (*pos == '+')
+		pos++;
+	if (!isdigit(*pos) && *pos != '.')
+		elog(ERROR, "numeric value '%s' is not supported by exact SUM/AVG", str);
+	for (; *pos != '\0'; pos++)
+	{
+		if (*pos == '.' && nfracs < 0)
+			nfracs = 0;
+		else if (!isdigit(*pos))
+			elog(ERROR, "numeric value '%s' is not supported by exact SUM/AVG", str);
+		else if (nfracs >= scale)
+		{
+			if (*pos != '0')
+				elog(ERROR, "numeric value '%s' exceeds the scale (%d)", str, scale);
+		}
+		else
+		{
+			ival = 10 * ival + (*pos - '0');
+			if (nfracs >= 0)
+				nfracs++;
+			if (ival >= KAGG_NUMERIC_FIXED_POINT_LIMIT)
+				elog(ERROR, "numeric value '%s' is out of range for exact SUM/AVG", str);
+		}
+	}
+	for (nfracs = Max(nfracs, 0); nfracs < scale; nfracs++)
+	{
+		ival *= 10;
+		if (ival >= KAGG_NUMERIC_FIXED_POINT_LIMIT)
+			elog(ERROR, "numeric value '%s' is out of range for exact SUM/AVG", str);
+	}
+	pfree(str);
+
+	r = palloc(sizeof(kagg_state__psum_numeric_packed));
+	r->nitems = 1;
+	r->scale = scale;
+	r->__padding__ = 0;
+	__kagg_psum_numeric_set(r, negative ? -ival : ival);
+	SET_VARSIZE(r, sizeof(kagg_state__psum_numeric_packed));
+
+	PG_RETURN_POINTER(r);
+}
+
+PUBLIC_FUNCTION(Datum)
+pgstrom_fsum_trans_numeric(PG_FUNCTION_ARGS)
+{
+	kagg_state__psum_numeric_packed *state;
+	kagg_state__psum_numeric_packed *arg;
+	MemoryContext	aggcxt;
+
+	if (!AggCheckCallContext(fcinfo, &aggcxt))
+		elog(ERROR, "aggregate function called in non-aggregate context");
+	if (PG_ARGISNULL(0))
+	{
+		if (PG_ARGISNULL(1))
+			PG_RETURN_NULL();
+		arg = (kagg_state__psum_numeric_packed *)PG_GETARG_BYTEA_P(1);
+		state = MemoryContextAlloc(aggcxt, sizeof(*state));
+		memcpy(state, arg, sizeof(*state));
+	}
+	else
+	{
+		state = (kagg_state__psum_numeric_packed *)PG_GETARG_BYTEA_P(0);
+		if (!PG_ARGISNULL(1))
+		{
+			arg = (kagg_state__psum_numeric_packed *)PG_GETARG_BYTEA_P(1);
+			if (arg->nitems > 0)
+			{
+				if (state->nitems > 0 && state->scale != arg->scale)
+					elog(ERROR, "exact numeric SUM/AVG: scale mismatch (%d, %d)",
+						 state->scale, arg->scale);
+				state->nitems += arg->nitems;
+				state->scale   = arg->scale;
+				__kagg_psum_numeric_set(state,
+										__kagg_psum_numeric_get(state) +
+										__kagg_psum_numeric_get(arg));
+			}
+		}
+	}
+	PG_RETURN_POINTER(state);
+}
+
+static Datum
+__kagg_psum_numeric_datum(const kagg_state__psum_numeric_packed *state)
+{
+	int128_t	sum = __kagg_psum_numeric_get(state);
+	unsigned __int128 uval = (sum < 0 ? -(unsigned __int128)sum
+								 : (unsigned __int128)sum);
+	char		temp[80];
+	char	   *pos = temp + sizeof(temp) - 1;
+	int			scale = state->scale;
+	int			i;
+
+	*pos = '\0';
+	for (i=0; uval != 0 || i <= scale; i++)
+	{
+		if (i == scale && scale > 0)
+			*--pos = '.';
+		*--pos = '0' + (int)(uval % 10);
+		uval /= 10;
+	}
+	if (sum < 0)
+		*--pos = '-';
+	return DirectFunctionCall3(numeric_in,
+							   CStringGetDatum(pos),
+							   ObjectIdGetDatum(InvalidOid),
+							   Int32GetDatum(-1));
+}
+
+PUBLIC_FUNCTION(Datum)
+pgstrom_fsum_final_numeric(PG_FUNCTION_ARGS)
+{
+	kagg_state__psum_numeric_packed *state
+		= (kagg_state__psum_numeric_packed *)PG_GETARG_BYTEA_P(0);
+	if (state->nitems == 0)
+		PG_RETURN_NULL();
+	PG_RETURN_DATUM(__kagg_psum_numeric_datum(state));
+}
+
+PUBLIC_FUNCTION(Datum)
+pgstrom_favg_final_numeric(PG_FUNCTION_ARGS)
+{
+	kagg_state__psum_numeric_packed *state;
+	Datum	n, sum;
+
+	state = (kagg_state__psum_numeric_packed *)PG_GETARG_BYTEA_P(0);
+	if (state->nitems == 0)
+		PG_RETURN_NULL();
+	n = DirectFunctionCall1(int4_numeric, Int32GetDatum(state->nitems));
+	sum = __kagg_psum_numeric_datum(state);
+
+	PG_RETURN_DATUM(DirectFunctionCall2(numeric_div, sum, n));
+}
+
 /*
  * STDDEV/VARIANCE
  */
@@ -828,7 +1008,687 @@ pgstrom_regr_syy_final(PG_FUNCTION_ARGS)
 	PG_RETURN_NULL();
 }
 
-#if 0
+/*
+ * PERCENTILE_APPROX
+ */
+static void
+__pquantile_init(kagg_state__pquantile_packed *r)
+{
+	memset(r, 0, sizeof(kagg_state__pquantile_packed));
+	r->fraction  = 0.5;
+	r->min_value = DBL_MAX;
+	r->max_value = -DBL_MAX;
+	SET_VARSIZE(r, sizeof(kagg_state__pquantile_packed));
+}
+
+static void
+__pquantile_update(kagg_state__pquantile_packed *r,
+				   float8_t xval, float8_t fraction)
+{
+	int		index = __kagg_qsketch_bucket_index(xval);
+
+	r->nitems++;
+	if (index < 0)
+		r->nlower++;
+	else
+		r->buckets[index]++;
+	r->min_value = Min(r->min_value, xval);
+	r->max_value = Max(r->max_value, xval);
+	r->fraction  = fraction;
+}
+
+PUBLIC_FUNCTION(Datum)
+pgstrom_partial_quantile(PG_FUNCTION_ARGS)
+{
+	kagg_state__pquantile_packed *r = palloc(sizeof(kagg_state__pquantile_packed));
+
+	__pquantile_init(r);
+	__pquantile_update(r, PG_GETARG_FLOAT8(0), PG_GETARG_FLOAT8(1));
+
+	PG_RETURN_POINTER(r);
+}
+
+PUBLIC_FUNCTION(Datum)
+pgstrom_pquantile_accum(PG_FUNCTION_ARGS)
+{
+	kagg_state__pquantile_packed *state;
+	kagg_state__pquantile_packed *arg;
+	MemoryContext	aggcxt;
+
+	if (!AggCheckCallContext(fcinfo, &aggcxt))
+		elog(ERROR, "aggregate function called in non-aggregate context");
+	if (PG_ARGISNULL(0))
+	{
+		if (PG_ARGISNULL(1))
+			PG_RETURN_NULL();
+		arg = (kagg_state__pquantile_packed *)PG_GETARG_BYTEA_P(1);
+		state = MemoryContextAlloc(aggcxt, sizeof(*state));
+		memcpy(state, arg, sizeof(*state));
+	}
+	else
+	{
+		state = (kagg_state__pquantile_packed *)PG_GETARG_BYTEA_P(0);
+		if (!PG_ARGISNULL(1))
+		{
+			arg = (kagg_state__pquantile_packed *)PG_GETARG_BYTEA_P(1);
+			if (arg->nitems > 0)
+			{
+				state->nitems += arg->nitems;
+				state->nlower += arg->nlower;
+				for (int k=0; k < KAGG_QSKETCH_NBUCKETS; k++)
+					state->buckets[k] += arg->buckets[k];
+				state->min_value = Min(state->min_value, arg->min_value);
+				state->max_value = Max(state->max_value, arg->max_value);
+				state->fraction  = arg->fraction;
+			}
+		}
+	}
+	PG_RETURN_POINTER(state);
+}
+
+PUBLIC_FUNCTION(Datum)
+pgstrom_percentile_approx_trans(PG_FUNCTION_ARGS)
+{
+	kagg_state__pquantile_packed *state;
+	MemoryContext	aggcxt;
+
+	if (!AggCheckCallContext(fcinfo, &aggcxt))
+		elog(ERROR, "aggregate function called in non-aggregate context");
+	if (PG_ARGISNULL(0))
+	{
+		state = MemoryContextAlloc(aggcxt, sizeof(*state));
+		__pquantile_init(state);
+	}
+	else
+		state = (kagg_state__pquantile_packed *)PG_GETARG_BYTEA_P(0);
+
+	if (!PG_ARGISNULL(1) && !PG_ARGISNULL(2))
+		__pquantile_update(state,
+						   PG_GETARG_FLOAT8(1),
+						   PG_GETARG_FLOAT8(2));
+	PG_RETURN_POINTER(state);
+}
+
+PUBLIC_FUNCTION(Datum)
+pgstrom_percentile_approx_final(PG_FUNCTION_ARGS)
+{
+	kagg_state__pquantile_packed *state
+		= (kagg_state__pquantile_packed *)PG_GETARG_BYTEA_P(0);
+	float8_t	rank;
+	float8_t	lower, upper, fval;
+	uint64_t	count;
+	uint64_t	cumulative;
+
+	if (state->nitems == 0)
+		PG_RETURN_NULL();
+	if (state->fraction < 0.0 || state->fraction > 1.0 ||
+		isnan(state->fraction))
+		ereport(ERROR,
+				(errcode(ERRCODE_NUMERIC_VALUE_OUT_OF_RANGE),
+				 errmsg("percentile value %g is not between 0 and 1",
+						state->fraction)));
+	if (state->fraction == 0.0)
+		PG_RETURN_FLOAT8(state->min_value);
+	if (state->fraction == 1.0)
+		PG_RETURN_FLOAT8(state->max_value);
+
+	/*
+	 * Walk on the histogram to find the bucket that contains the rank,
+	 * then interpolate the value linearly within the bucket.
+	 */
+	rank = state->fraction * (float8_t)(state->nitems - 1);
+	lower = state->min_value;
+	upper = Min(state->max_value, ldexp(1.0, KAGG_QSKETCH_MIN_EXPONENT));
+	count = state->nlower;
+	cumulative = 0;
+	if (rank >= (float8_t)count)
+	{
+		for (int k=0; k < KAGG_QSKETCH_NBUCKETS; k++)
+		{
+			int		expo = (k >> KAGG_QSKETCH_SUB_BITS) + KAGG_QSKETCH_MIN_EXPONENT;
+			int		sub  = (k & ((1 << KAGG_QSKETCH_SUB_BITS) - 1));
+
+			cumulative += count;
+			count = state->buckets[k];
+			if (rank < (float8_t)(cumulative + count))
+			{
+				lower = ldexp(1.0 + (float8_t)sub / (float8_t)(1 << KAGG_QSKETCH_SUB_BITS), expo);
+				if (k == KAGG_QSKETCH_NBUCKETS - 1)
+					upper = state->max_value;
+				else
+					upper = ldexp(1.0 + (float8_t)(sub+1) / (float8_t)(1 << KAGG_QSKETCH_SUB_BITS), expo);
+				break;
+			}
+		}
+	}
+	Assert(count > 0);
+	fval = lower + (upper - lower) * ((rank - (float8_t)cumulative + 0.5) / (float8_t)count);
+	fval = Max(fval, state->min_value);
+	fval = Min(fval, state->max_value);
+
+	PG_RETURN_FLOAT8(fval);
+}
+
+/*
+ * TOP_K
+ */
+static void
+__ptopk_init(kagg_state__ptopk_packed *r)
+{
+	memset(r, 0, sizeof(kagg_state__ptopk_packed));
+	SET_VARSIZE(r, sizeof(kagg_state__ptopk_packed));
+}
+
+static void
+__ptopk_insert(kagg_state__ptopk_packed *r, int k, uint64_t ival)
+{
+	int		min_index = 0;
+
+	if (k < 1 || k > KAGG_TOPK_MAX_K)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("top_k: k must be between 1 and %d", KAGG_TOPK_MAX_K)));
+	for (int i=1; i < k; i++)
+	{
+		if (r->slots[i] < r->slots[min_index])
+			min_index = i;
+	}
+	if (ival > r->slots[min_index])
+		r->slots[min_index] = ival;
+	r->k = k;
+}
+
+PUBLIC_FUNCTION(Datum)
+pgstrom_partial_topk(PG_FUNCTION_ARGS)
+{
+	kagg_state__ptopk_packed *r = palloc(sizeof(kagg_state__ptopk_packed));
+
+	__ptopk_init(r);
+	__ptopk_insert(r, PG_GETARG_INT32(1),
+				   __kagg_topk_encode(PG_GETARG_FLOAT8(0)));
+	r->nitems = 1;
+
+	PG_RETURN_POINTER(r);
+}
+
+PUBLIC_FUNCTION(Datum)
+pgstrom_ptopk_accum(PG_FUNCTION_ARGS)
+{
+	kagg_state__ptopk_packed *state;
+	kagg_state__ptopk_packed *arg;
+	MemoryContext	aggcxt;
+
+	if (!AggCheckCallContext(fcinfo, &aggcxt))
+		elog(ERROR, "aggregate function called in non-aggregate context");
+	if (PG_ARGISNULL(0))
+	{
+		if (PG_ARGISNULL(1))
+			PG_RETURN_NULL();
+		arg = (kagg_state__ptopk_packed *)PG_GETARG_BYTEA_P(1);
+		state = MemoryContextAlloc(aggcxt, sizeof(*state));
+		memcpy(state, arg, sizeof(*state));
+	}
+	else
+	{
+		state = (kagg_state__ptopk_packed *)PG_GETARG_BYTEA_P(0);
+		if (!PG_ARGISNULL(1))
+		{
+			arg = (kagg_state__ptopk_packed *)PG_GETARG_BYTEA_P(1);
+			if (arg->nitems > 0)
+			{
+				state->nitems += arg->nitems;
+				for (int i=0; i < arg->k; i++)
+				{
+					if (arg->slots[i] != 0)
+						__ptopk_insert(state, arg->k, arg->slots[i]);
+				}
+			}
+		}
+	}
+	PG_RETURN_POINTER(state);
+}
+
+PUBLIC_FUNCTION(Datum)
+pgstrom_top_k_trans(PG_FUNCTION_ARGS)
+{
+	kagg_state__ptopk_packed *state;
+	MemoryContext	aggcxt;
+
+	if (!AggCheckCallContext(fcinfo, &aggcxt))
+		elog(ERROR, "aggregate function called in non-aggregate context");
+	if (PG_ARGISNULL(0))
+	{
+		state = MemoryContextAlloc(aggcxt, sizeof(*state));
+		__ptopk_init(state);
+	}
+	else
+		state = (kagg_state__ptopk_packed *)PG_GETARG_BYTEA_P(0);
+
+	if (!PG_ARGISNULL(1) && !PG_ARGISNULL(2))
+	{
+		__ptopk_insert(state, PG_GETARG_INT32(2),
+					   __kagg_topk_encode(PG_GETARG_FLOAT8(1)));
+		state->nitems++;
+	}
+	PG_RETURN_POINTER(state);
+}
+
+static int
+__ptopk_slot_comp(const void *__a, const void *__b)
+{
+	uint64_t	a = *((const uint64_t *)__a);
+	uint64_t	b = *((const uint64_t *)__b);
+
+	/* descending order */
+	if (a > b)
+		return -1;
+	if (a < b)
+		return 1;
+	return 0;
+}
+
+PUBLIC_FUNCTION(Datum)
+pgstrom_top_k_final(PG_FUNCTION_ARGS)
+{
+	kagg_state__ptopk_packed *state
+		= (kagg_state__ptopk_packed *)PG_GETARG_BYTEA_P(0);
+	uint64_t	slots[KAGG_TOPK_MAX_K];
+	Datum		values[KAGG_TOPK_MAX_K];
+	int			nvalues = 0;
+
+	if (state->nitems == 0 || state->k < 1 || state->k > KAGG_TOPK_MAX_K)
+		PG_RETURN_NULL();
+	for (int i=0; i < state->k; i++)
+	{
+		if (state->slots[i] != 0)
+			slots[nvalues++] = state->slots[i];
+	}
+	qsort(slots, nvalues, sizeof(uint64_t), __ptopk_slot_comp);
+	for (int i=0; i < nvalues; i++)
+		values[i] = Float8GetDatum(__kagg_topk_decode(slots[i]));
+
+	PG_RETURN_POINTER(construct_array(values,
+									  nvalues,
+									  FLOAT8OID,
+									  sizeof(float8),
+									  FLOAT8PASSBYVAL,
+									  'd'));
+}
+
+/*
+ * ARRAY_AGG / STRING_AGG
+ *
+ * The partial state is a list of items in the heap format (see the
+ * kagg_state__parray_packed). The transition function expands the items
+ * to Datum arrays, then the final function sorts them by the sort-key
+ * (if ORDER BY is given), and build up the array or the string.
+ */
+typedef struct
+{
+	Oid			elem_type;
+	int16		elem_len;
+	bool		elem_byval;
+	char		elem_align;
+	Oid			key_type;
+	int16		key_len;
+	bool		key_byval;
+	Oid			sortop;			/* valid, if ORDER BY */
+	bool		nulls_first;
+	Oid			collation;
+	text	   *delimiter;		/* only string_agg */
+	uint32		nitems;
+	uint32		nrooms;
+	Datum	   *values;
+	bool	   *isnull;
+	Datum	   *keys;			/* NULL, if sorted by the values */
+	bool	   *knull;
+} parray_agg_state;
+
+static int32
+__parray_item_write(char *dest, Datum datum, int16 typlen, bool typbyval)
+{
+	if (typlen > 0)
+	{
+		if (dest)
+		{
+			if (typbyval)
+				store_att_byval(dest, datum, typlen);
+			else
+				memcpy(dest, DatumGetPointer(datum), typlen);
+		}
+		return typlen;
+	}
+	else if (typlen == -1)
+	{
+		struct varlena *vl = (struct varlena *)DatumGetPointer(datum);
+		int32		len = VARSIZE_ANY(vl);
+
+		Assert(!VARATT_IS_EXTERNAL(vl) && !VARATT_IS_COMPRESSED(vl));
+		if (dest)
+			memcpy(dest, vl, len);
+		return len;
+	}
+	elog(ERROR, "unexpected type length: %d", typlen);
+}
+
+static Datum
+__parray_item_read(MemoryContext memcxt, const char *addr, int32 len,
+				   int16 typlen, bool typbyval)
+{
+	char	   *temp;
+
+	if (typlen > 0 ? (len != typlen) : (len < VARHDRSZ_SHORT ||
+										len != VARSIZE_ANY(addr)))
+		elog(ERROR, "array_agg: corrupted partial state");
+	if (typbyval)
+	{
+		Datum		datum;
+
+		/* the partial state may not be aligned on the host */
+		memcpy(&datum, addr, len);
+		return fetch_att(&datum, true, typlen);
+	}
+	temp = MemoryContextAlloc(memcxt, len);
+	memcpy(temp, addr, len);
+	return PointerGetDatum(temp);
+}
+
+PUBLIC_FUNCTION(Datum)
+pgstrom_partial_array(PG_FUNCTION_ARGS)
+{
+	kagg_state__parray_packed *r = palloc0(sizeof(kagg_state__parray_packed));
+	kagg_parray_item *item = (kagg_parray_item *)r->data;
+	Datum		datum[2] = {0, 0};
+	int16		typlen[2] = {0, 0};
+	bool		typbyval[2] = {false, false};
+	int32		len[2];
+	size_t		sz;
+
+	/* -1 means NULL, and 0 means no sort-key */
+	for (int i=0; i < 2; i++)
+	{
+		len[i] = (i < PG_NARGS() ? -1 : 0);
+		if (i >= PG_NARGS() || PG_ARGISNULL(i))
+			continue;
+		get_typlenbyval(get_fn_expr_argtype(fcinfo->flinfo, i),
+						&typlen[i], &typbyval[i]);
+		datum[i] = PG_GETARG_DATUM(i);
+		if (typlen[i] == -1)
+			datum[i] = PointerGetDatum(PG_DETOAST_DATUM_PACKED(datum[i]));
+		len[i] = __parray_item_write(NULL, datum[i], typlen[i], typbyval[i]);
+	}
+	sz = KAGG_PARRAY_ITEM_SIZE(len[0], len[1]);
+	if (sz > KAGG_PARRAY_BUFSZ)
+		ereport(ERROR,
+				(errcode(ERRCODE_PROGRAM_LIMIT_EXCEEDED),
+				 errmsg("array_agg: too large item for the partial state (%zu bytes)", sz)));
+	item->vlen = len[0];
+	item->klen = len[1];
+	if (len[0] > 0)
+		__parray_item_write(item->payload, datum[0], typlen[0], typbyval[0]);
+	if (len[1] > 0)
+		__parray_item_write(item->payload + MAXALIGN(len[0]),
+							datum[1], typlen[1], typbyval[1]);
+	r->nitems = 1;
+	r->usage = sz;
+	SET_VARSIZE(r, sizeof(kagg_state__parray_packed));
+
+	PG_RETURN_POINTER(r);
+}
+
+static Datum
+__parray_accum_common(FunctionCallInfo fcinfo, bool is_string_agg)
+{
+	parray_agg_state *state;
+	MemoryContext	aggcxt;
+
+	if (!AggCheckCallContext(fcinfo, &aggcxt))
+		elog(ERROR, "aggregate function called in non-aggregate context");
+	if (PG_ARGISNULL(0))
+	{
+		state = MemoryContextAllocZero(aggcxt, sizeof(parray_agg_state));
+		/* array_agg takes a dummy argument of the element type */
+		if (is_string_agg)
+			state->elem_type = TEXTOID;
+		else
+			state->elem_type = get_fn_expr_argtype(fcinfo->flinfo, 2);
+		if (!OidIsValid(state->elem_type))
+			elog(ERROR, "could not determine input data type");
+		get_typlenbyvalalign(state->elem_type,
+							 &state->elem_len,
+							 &state->elem_byval,
+							 &state->elem_align);
+		if (!PG_ARGISNULL(3))
+			state->sortop = PG_GETARG_OID(3);
+		if (!PG_ARGISNULL(4))
+			state->nulls_first = PG_GETARG_BOOL(4);
+		state->collation = PG_GET_COLLATION();
+		if (OidIsValid(state->sortop))
+		{
+			Oid		rtype;
+
+			op_input_types(state->sortop, &state->key_type, &rtype);
+			get_typlenbyval(state->key_type,
+							&state->key_len,
+							&state->key_byval);
+		}
+		if (is_string_agg && !PG_ARGISNULL(2))
+		{
+			MemoryContext oldcxt = MemoryContextSwitchTo(aggcxt);
+
+			state->delimiter = PG_GETARG_TEXT_P_COPY(2);
+			MemoryContextSwitchTo(oldcxt);
+		}
+	}
+	else
+	{
+		state = (parray_agg_state *)PG_GETARG_POINTER(0);
+	}
+
+	if (!PG_ARGISNULL(1))
+	{
+		kagg_state__parray_packed *r = (kagg_state__parray_packed *)
+			PG_GETARG_BYTEA_P(1);
+		uint32		offset = 0;
+
+		if (VARSIZE(r) != sizeof(kagg_state__parray_packed) ||
+			r->usage > KAGG_PARRAY_BUFSZ)
+			elog(ERROR, "array_agg: corrupted partial state");
+		for (uint32 i=0; i < r->nitems; i++)
+		{
+			const kagg_parray_item *item;
+			uint32		index = state->nitems++;
+
+			if (offset + offsetof(kagg_parray_item, payload) > r->usage)
+				elog(ERROR, "array_agg: corrupted partial state");
+			item = (const kagg_parray_item *)(r->data + offset);
+			offset += KAGG_PARRAY_ITEM_SIZE(item->vlen, item->klen);
+			if (offset > r->usage)
+				elog(ERROR, "array_agg: corrupted partial state");
+			if (index >= state->nrooms)
+			{
+				uint32	nrooms = Max(2 * state->nrooms, 64);
+
+				if (!state->values)
+				{
+					state->values = MemoryContextAlloc(aggcxt, sizeof(Datum) * nrooms);
+					state->isnull = MemoryContextAlloc(aggcxt, sizeof(bool) * nrooms);
+				}
+				else
+				{
+					state->values = repalloc_huge(state->values, sizeof(Datum) * nrooms);
+					state->isnull = repalloc_huge(state->isnull, sizeof(bool) * nrooms);
+				}
+				if (item->klen != 0 || state->keys)
+				{
+					if (!state->keys)
+					{
+						state->keys = MemoryContextAllocZero(aggcxt, sizeof(Datum) * nrooms);
+						state->knull = MemoryContextAllocZero(aggcxt, sizeof(bool) * nrooms);
+					}
+					else
+					{
+						state->keys = repalloc_huge(state->keys, sizeof(Datum) * nrooms);
+						state->knull = repalloc_huge(state->knull, sizeof(bool) * nrooms);
+					}
+				}
+				state->nrooms = nrooms;
+			}
+			if ((item->klen != 0) != (state->keys != NULL) ||
+				(state->keys && !OidIsValid(state->key_type)))
+				elog(ERROR, "array_agg: corrupted partial state");
+			state->isnull[index] = (item->vlen < 0);
+			if (item->vlen >= 0)
+				state->values[index] = __parray_item_read(aggcxt,
+														  item->payload,
+														  item->vlen,
+														  state->elem_len,
+														  state->elem_byval);
+			if (state->keys)
+			{
+				state->knull[index] = (item->klen < 0);
+				if (item->klen > 0)
+					state->keys[index] = __parray_item_read(aggcxt,
+															item->payload +
+															MAXALIGN(Max(item->vlen, 0)),
+															item->klen,
+															state->key_len,
+															state->key_byval);
+			}
+		}
+	}
+	PG_RETURN_POINTER(state);
+}
+
+PUBLIC_FUNCTION(Datum)
+pgstrom_parray_accum(PG_FUNCTION_ARGS)
+{
+	return __parray_accum_common(fcinfo, false);
+}
+
+PUBLIC_FUNCTION(Datum)
+pgstrom_pstring_accum(PG_FUNCTION_ARGS)
+{
+	return __parray_accum_common(fcinfo, true);
+}
+
+typedef struct
+{
+	parray_agg_state *state;
+	SortSupport	ssup;
+} parray_sort_context;
+
+static int
+__parray_sort_comp(const void *__a, const void *__b, void *arg)
+{
+	parray_sort_context *pcxt = arg;
+	parray_agg_state *state = pcxt->state;
+	uint32		a = *((const uint32 *)__a);
+	uint32		b = *((const uint32 *)__b);
+
+	if (state->keys)
+		return ApplySortComparator(state->keys[a], state->knull[a],
+								   state->keys[b], state->knull[b],
+								   pcxt->ssup);
+	return ApplySortComparator(state->values[a], state->isnull[a],
+							   state->values[b], state->isnull[b],
+							   pcxt->ssup);
+}
+
+static void
+__parray_sort_items(parray_agg_state *state)
+{
+	SortSupportData	ssup;
+	parray_sort_context pcxt;
+	uint32	   *order;
+	Datum	   *values;
+	bool	   *isnull;
+
+	if (!OidIsValid(state->sortop) || state->nitems < 2)
+		return;
+	memset(&ssup, 0, sizeof(SortSupportData));
+	ssup.ssup_cxt = CurrentMemoryContext;
+	ssup.ssup_collation = state->collation;
+	ssup.ssup_nulls_first = state->nulls_first;
+	PrepareSortSupportFromOrderingOp(state->sortop, &ssup);
+	pcxt.state = state;
+	pcxt.ssup = &ssup;
+
+	order = palloc(sizeof(uint32) * state->nitems);
+	for (uint32 i=0; i < state->nitems; i++)
+		order[i] = i;
+	qsort_arg(order, state->nitems, sizeof(uint32),
+			  __parray_sort_comp, &pcxt);
+	values = palloc(sizeof(Datum) * state->nitems);
+	isnull = palloc(sizeof(bool) * state->nitems);
+	for (uint32 i=0; i < state->nitems; i++)
+	{
+		values[i] = state->values[order[i]];
+		isnull[i] = state->isnull[order[i]];
+	}
+	state->values = values;
+	state->isnull = isnull;
+	state->keys = NULL;
+	state->knull = NULL;
+	state->sortop = InvalidOid;		/* already sorted */
+	pfree(order);
+}
+
+PUBLIC_FUNCTION(Datum)
+pgstrom_array_agg_final(PG_FUNCTION_ARGS)
+{
+	parray_agg_state *state;
+	int			dims[1];
+	int			lbs[1];
+
+	if (PG_ARGISNULL(0))
+		PG_RETURN_NULL();
+	state = (parray_agg_state *)PG_GETARG_POINTER(0);
+	if (state->nitems == 0)
+		PG_RETURN_NULL();
+	__parray_sort_items(state);
+	dims[0] = state->nitems;
+	lbs[0] = 1;
+	PG_RETURN_POINTER(construct_md_array(state->values,
+										 state->isnull,
+										 1, dims, lbs,
+										 state->elem_type,
+										 state->elem_len,
+										 state->elem_byval,
+										 state->elem_align));
+}
+
+PUBLIC_FUNCTION(Datum)
+pgstrom_string_agg_final(PG_FUNCTION_ARGS)
+{
+	parray_agg_state *state;
+	StringInfoData buf;
+	bool		is_first = true;
+
+	if (PG_ARGISNULL(0))
+		PG_RETURN_NULL();
+	state = (parray_agg_state *)PG_GETARG_POINTER(0);
+	__parray_sort_items(state);
+	initStringInfo(&buf);
+	for (uint32 i=0; i < state->nitems; i++)
+	{
+		text   *t;
+
+		if (state->isnull[i])
+			continue;
+		if (!is_first && state->delimiter)
+			appendBinaryStringInfo(&buf,
+								   VARDATA_ANY(state->delimiter),
+								   VARSIZE_ANY_EXHDR(state->delimiter));
+		t = (text *)DatumGetPointer(state->values[i]);
+		appendBinaryStringInfo(&buf, VARDATA_ANY(t), VARSIZE_ANY_EXHDR(t));
+		is_first = false;
+	}
+	if (is_first)
+		PG_RETURN_NULL();
+	PG_RETURN_TEXT_P(cstring_to_text_with_len(buf.data, buf.len));
+}
+
 /*
  * ----------------------------------------------------------------
  *
@@ -1211,6 +2071,7 @@ pgstrom_hll_count_final(PG_FUNCTION_ARGS)
 	uint8	   *hll_regs;
 	uint32		nrooms;
 	uint32		index;
+	uint32		nzeros = 0;
 	double		divider = 0.0;
 	double		weight;
 	double		estimate;
@@ -1236,7 +2097,11 @@ pgstrom_hll_count_final(PG_FUNCTION_ARGS)
 	hll_regs = (uint8 *)VARDATA(hll_state);
 
 	for (index = 0; index < nrooms; index++)
+	{
 		divider += 1.0 / (double)(1UL << hll_regs[index]);
+		if (hll_regs[index] == 0)
+			nzeros++;
+	}
 	if (nrooms <= 16)
 		weight = 0.673;
 	else if (nrooms <= 32)
@@ -1247,6 +2112,9 @@ pgstrom_hll_count_final(PG_FUNCTION_ARGS)
 		weight = 0.7213 / (1.0 + 1.079 / (double)nrooms);
 
 	estimate = (weight * (double)nrooms * (double)nrooms) / divider;
+	/* small range correction (linear counting) */
+	if (estimate <= 2.5 * (double)nrooms && nzeros > 0)
+		estimate = (double)nrooms * log((double)nrooms / (double)nzeros);
 	PG_RETURN_INT64((int64)estimate);
 }
 
@@ -1294,4 +2162,3 @@ pgstrom_hll_sketch_histogram(PG_FUNCTION_ARGS)
 							 'i');
 	PG_RETURN_POINTER(result);
 }
-#endif
@@ -13,6 +13,15 @@
 #include "arrow_defs.h"
 #include "arrow_ipc.h"
 #include "xpu_numeric.h"
+#ifdef USE_LZ4
+#include <lz4frame.h>
+#endif
+#ifdef USE_ZSTD
+#include <zstd.h>
+#endif
+#include <sys/file.h>
+#include <sys/inotify.h>
+#include <sys/vfs.h>
 
 /*
  * min/max statistics datum
@@ -47,7 +56,15 @@ typedef struct RecordBatchFieldState
 	size_t		values_length;
 	off_t		extra_offset;
 	size_t		extra_length;
+	/* variadic data buffers, if BinaryView/Utf8View */
+	int			num_variadic;
+	off_t	   *variadic_offsets;
+	size_t	   *variadic_lengths;
 	MinMaxStatDatum stat_datum;
+	MinMaxStatDatum *zone_stats;	/* min/max statistics per zone, if any */
+	const ParquetColumnChunk *pq_chunk;	/* column chunk, if parquet */
+	/* hive-style partition key; stat_datum has the constant value */
+	bool		part_key;
 	/* sub-fields if any */
 	int			num_children;
 	struct RecordBatchFieldState *children;
@@ -60,6 +77,11 @@ typedef struct RecordBatchState
 	off_t		rb_offset;	/* offset from the head */
 	size_t		rb_length;	/* length of the entire RecordBatch */
 	int64		rb_nitems;	/* number of items */
+	bool		rb_compressed;	/* true, if BodyCompression is set */
+	ArrowCompressionType rb_codec;	/* valid only if rb_compressed */
+	bool		rb_parquet;	/* true, if row-group of parquet file */
+	uint32_t	zone_nrows;	/* number of rows per zone, if zone-map */
+	uint32_t	zone_nitems;	/* number of zones */
 	/* per column information */
 	int			nfields;
 	RecordBatchFieldState fields[FLEXIBLE_ARRAY_MEMBER];
@@ -73,9 +95,21 @@ typedef struct ArrowFileState
 	List	   *rb_list;	/* list of RecordBatchState */
 } ArrowFileState;
 
+/*
+ * arrowPartitionKey - hive-style partition key on the pathname.
+ * (e.g, /opt/data/dt=2026-10-01/region=eu/000001.arrow)
+ */
+typedef struct
+{
+	char	   *key;
+	char	   *value;		/* NULL, if __HIVE_DEFAULT_PARTITION__ */
+} arrowPartitionKey;
+
 /*
  * ArrowFdwState - executor state to run apache arrow
  */
+typedef struct arrowCpuBatch	arrowCpuBatch;
+
 typedef struct
 {
 	Bitmapset	   *stat_attrs;
@@ -86,21 +120,36 @@ typedef struct
 	ExprContext	   *econtext;
 } arrowStatsHint;
 
+typedef struct
+{
+	Bitmapset	   *filter_attrs;	/* columns referenced by filter_quals */
+	List		   *orig_quals;		/* for EXPLAIN */
+	ExprState	   *filter_quals;
+	ExprContext	   *econtext;
+	TupleTableSlot *filter_slot;
+	StringInfoData	filter_buffer;	/* buffer to load the filter columns */
+} arrowLateMaterialization;
+
 struct ArrowFdwState
 {
 	Bitmapset		   *referenced;		/* referenced columns */
 	arrowStatsHint	   *stats_hint;		/* min/max statistics, if any */
+	arrowLateMaterialization *late_mat;	/* late materialization, if any */
 	pg_atomic_uint32   *rbatch_index;
 	pg_atomic_uint32	__rbatch_index_local;	/* if single process */
 	pg_atomic_uint32   *rbatch_nload;
 	pg_atomic_uint32	__rbatch_nload_local;	/* if single process */
 	pg_atomic_uint32   *rbatch_nskip;
 	pg_atomic_uint32	__rbatch_nskip_local;	/* if single process */
+	pg_atomic_uint32   *rbatch_nlate;
+	pg_atomic_uint32	__rbatch_nlate_local;	/* if single process */
 	StringInfoData		chunk_buffer;	/* buffer to load record-batch */
 	File				curr_filp;		/* current arrow file to read */
-	kern_data_store	   *curr_kds;		/* current chunk to read */
-	uint32_t			curr_index;		/* current index on the chunk */
+	arrowCpuBatch	   *cpu_batch;		/* batch decoder for CPU scan */
 	List			   *af_states_list;	/* list of ArrowFileState */
+	bool				syncscan;		/* synchronized scan, if true */
+	uint32_t			rb_startpos;	/* start position of the scan */
+	RelationData		syncscan_rel;	/* pseudo relation for syncscan.c */
 	uint32_t			rb_nitems;		/* number of record-batches */
 	RecordBatchState   *rb_states[FLEXIBLE_ARRAY_MEMBER]; /* flatten RecordBatchState */
 };
@@ -142,6 +191,9 @@ struct arrowMetadataFieldCache
 	/* sub-fields if any */
 	int			num_children;
 	dlist_head	children;
+	/* variadic data buffers (by extra_offset/length) if any */
+	int			num_variadic;
+	dlist_head	variadics;
 	uint32_t	magic;
 };
 
@@ -157,6 +209,10 @@ struct arrowMetadataCache
 	off_t		rb_offset;	/* offset from the head */
 	size_t		rb_length;	/* length of the entire RecordBatch */
 	int64		rb_nitems;	/* number of items */
+	bool		rb_compressed;	/* true, if BodyCompression is set */
+	ArrowCompressionType rb_codec;	/* valid only if rb_compressed */
+	uint32_t	zone_nrows;	/* zone-map is not cached, but re-read from
+							 * the file footer if non-zero */
 	/* per column information */
 	int			nfields;
 	dlist_head	fields;		/* list of arrowMetadataFieldCache */
@@ -178,6 +234,25 @@ typedef struct
 	dlist_head	hash_slots[ARROW_METADATA_HASH_NSLOTS];
 } arrowMetadataCacheHead;
 
+/*
+ * arrowIncrementalFile - range of the record-batches of the file to be
+ * scanned on the refresh of incremental aggregates; the earlier ones were
+ * already merged to the result table, and the later ones were appended
+ * after the watermark was taken.
+ */
+typedef struct
+{
+	const char *filename;
+	int			rb_skip;		/* number of record-batches merged */
+	int			rb_count;		/* number of record-batches at the refresh */
+} arrowIncrementalFile;
+
+typedef struct
+{
+	Oid			frelid;			/* arrow_fdw foreign table */
+	List	   *files;			/* list of arrowIncrementalFile */
+} arrowIncrementalFilter;
+
 /*
  * Static variables
  */
@@ -187,7 +262,17 @@ static shmem_startup_hook_type shmem_startup_next = NULL;
 static arrowMetadataCacheHead *arrow_metadata_cache = NULL;
 static bool					arrow_fdw_enabled;	/* GUC */
 static bool					arrow_fdw_stats_hint_enabled;	/* GUC */
+static bool					arrow_fdw_late_materialization;	/* GUC */
 static int					arrow_metadata_cache_size_kb;	/* GUC */
+static char				   *arrow_metadata_cache_dir;	/* GUC */
+static int					arrow_dirwatch_max_dirs;	/* GUC */
+static int					arrow_record_batch_size_kb;	/* GUC */
+static bool					arrow_analyze_hll_ndistinct;	/* GUC */
+static int					arrow_object_prefetch_depth;	/* GUC */
+static int					arrow_io_merge_gap_kb;	/* GUC */
+static List				   *arrow_analyze_pending = NIL;
+static arrowIncrementalFilter *arrow_incremental_filter = NULL;
+static ProcessUtility_hook_type process_utility_next = NULL;
 
 /* ----------------------------------------------------------------
  *
@@ -294,6 +379,13 @@ __releaseMetadataFieldCache(arrowMetadataFieldCache *fcache)
 							  dlist_pop_head_node(&fcache->children));
 		__releaseMetadataFieldCache(__fcache);
 	}
+	while (!dlist_is_empty(&fcache->variadics))
+	{
+		arrowMetadataFieldCache	*__fcache
+			= dlist_container(arrowMetadataFieldCache, chain,
+							  dlist_pop_head_node(&fcache->variadics));
+		__releaseMetadataFieldCache(__fcache);
+	}
 	fcache->magic = ARROW_METADATA_CACHE_FREE_MAGIC;
 	dlist_push_tail(&arrow_metadata_cache->free_fcaches,
 					&fcache->chain);
@@ -677,7 +769,7 @@ __parseArrowFieldStatsBinary(arrowFieldStatsBinary *bstats,
 			case ArrowNodeTag__Int:
 			case ArrowNodeTag__FloatingPoint:
 				stat_values[index].min.datum = (Datum)__min;
-				stat_values[index].max.datum = (Datum)__min;
+				stat_values[index].max.datum = (Datum)__max;
 				break;
 
 			case ArrowNodeTag__Decimal:
@@ -889,6 +981,87 @@ applyArrowStatsBinary(RecordBatchState *rb_state, arrowStatsBinary *arrow_bstats
 	}
 }
 
+/*
+ * applyArrowZoneMaps
+ *
+ * It applies the zone-map (min/max statistics for each zone in a record-
+ * batch) on the RecordBatchStates. Only top-level fields are supported.
+ */
+static char *
+__fetchArrowZoneMapSegment(char **p_pos)
+{
+	char   *tok = *p_pos;
+	char   *end;
+
+	if (!tok)
+		return NULL;
+	end = strchr(tok, ';');
+	if (end)
+	{
+		*end = '\0';
+		*p_pos = end + 1;
+	}
+	else
+		*p_pos = NULL;
+	return tok;
+}
+
+static void
+applyArrowZoneMaps(const ArrowFooter *footer, List *rb_list)
+{
+	for (int j=0; j < footer->schema._num_fields; j++)
+	{
+		ArrowField *field = &footer->schema.fields[j];
+		char	   *min_pos = NULL;
+		char	   *max_pos = NULL;
+		long		zone_nrows = 0;
+		ListCell   *lc;
+
+		for (int k=0; k < field->_num_custom_metadata; k++)
+		{
+			ArrowKeyValue *kv = &field->custom_metadata[k];
+
+			if (strcmp(kv->key, "zonemap_nrows") == 0)
+				zone_nrows = atol(kv->value);
+			else if (strcmp(kv->key, "zonemap_min_values") == 0)
+				min_pos = pstrdup(kv->value);
+			else if (strcmp(kv->key, "zonemap_max_values") == 0)
+				max_pos = pstrdup(kv->value);
+		}
+		/* zone_nrows must be multiple of 64 for alignment of nullmap */
+		if (zone_nrows <= 0 || zone_nrows > INT_MAX ||
+			zone_nrows % 64 != 0 || !min_pos || !max_pos)
+			continue;
+
+		foreach (lc, rb_list)
+		{
+			RecordBatchState *rb_state = lfirst(lc);
+			RecordBatchFieldState *rb_field = &rb_state->fields[j];
+			arrowFieldStatsBinary bstats;
+			char	   *min_tokens = __fetchArrowZoneMapSegment(&min_pos);
+			char	   *max_tokens = __fetchArrowZoneMapSegment(&max_pos);
+			uint32_t	nzones;
+
+			if (!min_tokens || !max_tokens)
+				break;
+			if (rb_state->zone_nitems != 0 &&
+				rb_state->zone_nrows != zone_nrows)
+				continue;	/* not consistent with other fields */
+			nzones = (rb_state->rb_nitems + zone_nrows - 1) / zone_nrows;
+			memset(&bstats, 0, sizeof(arrowFieldStatsBinary));
+			bstats.nrooms = nzones;
+			if (nzones > 0 && __parseArrowFieldStatsBinary(&bstats, field,
+														   min_tokens,
+														   max_tokens))
+			{
+				rb_state->zone_nrows = zone_nrows;
+				rb_state->zone_nitems = nzones;
+				rb_field->zone_stats = bstats.stat_values;
+			}
+		}
+	}
+}
+
 /*
  * execInitArrowStatsHint / execCheckArrowStatsHint / execEndArrowStatsHint
  *
@@ -1081,8 +1254,9 @@ execInitArrowStatsHint(ScanState *ss, List *outer_quals, Bitmapset *stat_attrs)
 }
 
 static bool
-execCheckArrowStatsHint(arrowStatsHint *stats_hint,
-						RecordBatchState *rb_state)
+__execCheckArrowStatsHint(arrowStatsHint *stats_hint,
+						  RecordBatchState *rb_state,
+						  int zone_index)
 {
 	ExprContext	   *econtext = stats_hint->econtext;
 	TupleTableSlot *min_values = econtext->ecxt_innertuple;
@@ -1099,23 +1273,30 @@ execCheckArrowStatsHint(arrowStatsHint *stats_hint,
 		 anum = bms_next_member(stats_hint->load_attrs, anum))
 	{
 		RecordBatchFieldState *rb_field = &rb_state->fields[anum-1];
+		MinMaxStatDatum *stat_datum;
 
 		Assert(anum > 0 && anum <= rb_state->nfields);
-		if (!rb_field->stat_datum.isnull)
+		if (zone_index < 0)
+			stat_datum = &rb_field->stat_datum;
+		else if (rb_field->zone_stats)
+			stat_datum = &rb_field->zone_stats[zone_index];
+		else
+			continue;	/* no zone-map on this field */
+		if (!stat_datum->isnull)
 		{
 			min_values->tts_isnull[anum-1] = false;
 			max_values->tts_isnull[anum-1] = false;
 			if (rb_field->atttypid == NUMERICOID)
 			{
 				min_values->tts_values[anum-1]
-					= PointerGetDatum(&rb_field->stat_datum.min.numeric);
+					= PointerGetDatum(&stat_datum->min.numeric);
 				max_values->tts_values[anum-1]
-					= PointerGetDatum(&rb_field->stat_datum.max.numeric);
+					= PointerGetDatum(&stat_datum->max.numeric);
 			}
 			else
 			{
-				min_values->tts_values[anum-1] = rb_field->stat_datum.min.datum;
-				max_values->tts_values[anum-1] = rb_field->stat_datum.max.datum;
+				min_values->tts_values[anum-1] = stat_datum->min.datum;
+				max_values->tts_values[anum-1] = stat_datum->max.datum;
 			}
 		}
 	}
@@ -1127,6 +1308,54 @@ execCheckArrowStatsHint(arrowStatsHint *stats_hint,
 	return false;
 }
 
+static inline bool
+execCheckArrowStatsHint(arrowStatsHint *stats_hint,
+						RecordBatchState *rb_state)
+{
+	return __execCheckArrowStatsHint(stats_hint, rb_state, -1);
+}
+
+/*
+ * execCheckArrowZoneMapHint
+ *
+ * It picks up the range of rows to be loaded, according to the zone-map.
+ * Only a contiguous range of zones is supported, because we cannot assign
+ * multiple row-ranges on a KDS_FORMAT_ARROW. It returns false, if no zones
+ * need to be loaded.
+ */
+static bool
+execCheckArrowZoneMapHint(arrowStatsHint *stats_hint,
+						  RecordBatchState *rb_state,
+						  uint32_t *p_row_start,
+						  uint32_t *p_row_count)
+{
+	int64		zone_head = -1;
+	int64		zone_tail = -1;
+	int64		row_start;
+	int64		row_end;
+
+	*p_row_start = 0;
+	*p_row_count = rb_state->rb_nitems;
+	if (!stats_hint || rb_state->zone_nitems == 0)
+		return true;
+	for (int i=0; i < rb_state->zone_nitems; i++)
+	{
+		if (!__execCheckArrowStatsHint(stats_hint, rb_state, i))
+		{
+			if (zone_head < 0)
+				zone_head = i;
+			zone_tail = i;
+		}
+	}
+	if (zone_head < 0)
+		return false;
+	row_start = zone_head * rb_state->zone_nrows;
+	row_end = Min((zone_tail + 1) * rb_state->zone_nrows, rb_state->rb_nitems);
+	*p_row_start = row_start;
+	*p_row_count = row_end - row_start;
+	return true;
+}
+
 static void
 execEndArrowStatsHint(arrowStatsHint *stats_hint)
 {
@@ -1140,6 +1369,65 @@ execEndArrowStatsHint(arrowStatsHint *stats_hint)
 	FreeExprContext(econtext, true);
 }
 
+/*
+ * execInitArrowLateMaterialization
+ *
+ * It picks up the scan qualifiers that are safe to evaluate on the host
+ * twice, then sets up the filter columns to be loaded prior to the others.
+ */
+static arrowLateMaterialization *
+execInitArrowLateMaterialization(ScanState *ss, List *outer_quals,
+								 Bitmapset *referenced)
+{
+	Relation		relation = ss->ss_currentRelation;
+	TupleDesc		tupdesc = RelationGetDescr(relation);
+	Index			scanrelid = ((Scan *)ss->ps.plan)->scanrelid;
+	arrowLateMaterialization *late_mat;
+	Bitmapset	   *filter_attrs = NULL;
+	List		   *filter_quals = NIL;
+	ListCell	   *lc;
+	int				k;
+
+	foreach (lc, outer_quals)
+	{
+		Node	   *qual = lfirst(lc);
+		Bitmapset  *varattnos = NULL;
+
+		if (contain_volatile_functions(qual) ||
+			contain_subplans(qual))
+			continue;
+		pull_varattnos(qual, scanrelid, &varattnos);
+		/* system columns and whole-row references are not supported */
+		k = bms_next_member(varattnos, -1);
+		if (k < 0 || k <= -FirstLowInvalidHeapAttributeNumber)
+			continue;
+		filter_attrs = bms_add_members(filter_attrs, varattnos);
+		filter_quals = lappend(filter_quals, qual);
+	}
+	/* no benefit, if the filter columns are all we load */
+	if (filter_quals == NIL ||
+		bms_is_subset(referenced, filter_attrs))
+		return NULL;
+
+	late_mat = palloc0(sizeof(arrowLateMaterialization));
+	late_mat->filter_attrs = filter_attrs;
+	late_mat->orig_quals = filter_quals;
+	late_mat->filter_quals = ExecInitQual(filter_quals, &ss->ps);
+	late_mat->econtext = CreateExprContext(ss->ps.state);
+	late_mat->filter_slot = MakeSingleTupleTableSlot(tupdesc, &TTSOpsVirtual);
+	initStringInfo(&late_mat->filter_buffer);
+
+	return late_mat;
+}
+
+static void
+execEndArrowLateMaterialization(arrowLateMaterialization *late_mat)
+{
+	ExecDropSingleTupleTableSlot(late_mat->filter_slot);
+	FreeExprContext(late_mat->econtext, true);
+	pfree(late_mat->filter_buffer.data);
+}
+
 
 /* ----------------------------------------------------------------
  *
@@ -1185,6 +1473,24 @@ __buildRecordBatchFieldStateByCache(RecordBatchFieldState *rb_field,
 	{
 		Assert(dlist_is_empty(&fcache->children));
 	}
+	if (fcache->num_variadic > 0)
+	{
+		dlist_iter	iter;
+		int			k = 0;
+
+		rb_field->num_variadic = fcache->num_variadic;
+		rb_field->variadic_offsets = palloc(sizeof(off_t) * fcache->num_variadic);
+		rb_field->variadic_lengths = palloc(sizeof(size_t) * fcache->num_variadic);
+		dlist_foreach(iter, &fcache->variadics)
+		{
+			arrowMetadataFieldCache *__fcache
+				= dlist_container(arrowMetadataFieldCache, chain, iter.cur);
+			rb_field->variadic_offsets[k] = __fcache->extra_offset;
+			rb_field->variadic_lengths[k] = __fcache->extra_length;
+			k++;
+		}
+		Assert(k == rb_field->num_variadic);
+	}
 }
 
 static ArrowFileState *
@@ -1211,13 +1517,16 @@ __buildArrowFileStateByCache(const char *filename,
 		rb_state->rb_offset = mcache->rb_offset;
 		rb_state->rb_length = mcache->rb_length;
 		rb_state->rb_nitems = mcache->rb_nitems;
+		rb_state->rb_compressed = mcache->rb_compressed;
+		rb_state->rb_codec  = mcache->rb_codec;
+		rb_state->zone_nrows = mcache->zone_nrows;
 		rb_state->nfields   = mcache->nfields;
 		dlist_foreach(iter, &mcache->fields)
 		{
 			arrowMetadataFieldCache *fcache;
 
 			fcache = dlist_container(arrowMetadataFieldCache, chain, iter.cur);
-			if (p_stat_attrs && fcache->stat_datum.isnull)
+			if (p_stat_attrs && !fcache->stat_datum.isnull)
 				*p_stat_attrs = bms_add_member(*p_stat_attrs, j+1);
 			__buildRecordBatchFieldStateByCache(&rb_state->fields[j++], fcache);
 		}
@@ -1238,6 +1547,9 @@ typedef struct
 	ArrowBuffer	   *buffer_tail;
 	ArrowFieldNode *fnode_curr;
 	ArrowFieldNode *fnode_tail;
+	int64_t		   *variadic_curr;	/* variadicBufferCounts */
+	int64_t		   *variadic_tail;
+	bool			compressed;	/* buffers are compressed */
 } setupRecordBatchContext;
 
 static Oid
@@ -1535,6 +1847,18 @@ __arrowFieldTypeToPGType(const ArrowField *field,
 				type_oid = BYTEAOID;
 			break;
 
+		case ArrowNodeTag__Utf8View:
+			attopts.tag = ArrowType__Utf8View;
+			attopts.unitsz = sizeof(ArrowBinaryView);
+			type_oid = TEXTOID;
+			break;
+
+		case ArrowNodeTag__BinaryView:
+			attopts.tag = ArrowType__BinaryView;
+			attopts.unitsz = sizeof(ArrowBinaryView);
+			type_oid = BYTEAOID;
+			break;
+
 		case ArrowNodeTag__List:
 		case ArrowNodeTag__LargeList:
 			if (field->_num_children != 1)
@@ -1558,6 +1882,33 @@ __arrowFieldTypeToPGType(const ArrowField *field,
 			}
 			break;
 
+		case ArrowNodeTag__Map:
+			/*
+			 * Arrow::Map is physically List<entries: Struct<key, value>>,
+			 * so it is mapped to an array of the composite type that
+			 * consists of the key and value fields.
+			 */
+			if (field->_num_children != 1 ||
+				field->children[0].type.node.tag != ArrowNodeTag__Struct ||
+				field->children[0]._num_children != 2)
+				elog(ERROR, "Bug? Map of arrow type is corrupted");
+			else
+			{
+				Oid			__type_oid = InvalidOid;
+
+				attopts.tag = ArrowType__List;
+				attopts.unitsz = sizeof(uint32_t);
+				__arrowFieldTypeToPGType(&field->children[0],
+										 &__type_oid,
+										 NULL,
+										 NULL);
+				type_oid = get_array_type(__type_oid);
+				if (!OidIsValid(type_oid))
+					elog(ERROR, "arrow_fdw: no array type for '%s'",
+						 format_type_be(__type_oid));
+			}
+			break;
+
 		case ArrowNodeTag__Struct:
 			{
 				Oid	   *__type_oids;
@@ -1601,6 +1952,7 @@ __buildRecordBatchFieldState(setupRecordBatchContext *con,
 	ArrowBuffer	   *buffer_curr;
 	size_t			least_values_length = 0;
 	bool			has_extra_buffer = false;
+	bool			has_variadic_buffers = false;
 
 	if (con->fnode_curr >= con->fnode_tail)
 		elog(ERROR, "RecordBatch has less ArrowFieldNode than expected");
@@ -1639,16 +1991,25 @@ __buildRecordBatchFieldState(setupRecordBatchContext *con,
 			has_extra_buffer = true;
 			break;
 
+		case ArrowNodeTag__Utf8View:
+		case ArrowNodeTag__BinaryView:
+			least_values_length = rb_field->attopts.unitsz * rb_field->nitems;
+			has_variadic_buffers = true;
+			break;
+
 		case ArrowNodeTag__List:
         case ArrowNodeTag__LargeList:
-			if (depth > 0)
-				elog(ERROR, "nested array type is not supported");
+		case ArrowNodeTag__Map:
+			/*
+			 * List of List is already rejected by __arrowFieldTypeToPGType(),
+			 * because PostgreSQL has no array of array types. List of Struct,
+			 * Map or Struct of List are mapped to array of composite types or
+			 * composite types with array sub-fields.
+			 */
 			least_values_length = rb_field->attopts.unitsz * (rb_field->nitems + 1);
 			break;
 
 		case ArrowNodeTag__Struct:
-			if (depth > 0)
-				elog(ERROR, "nested composite type is not supported");
 			/* no values and extra buffer, only nullmap */
 			break;
 		default:
@@ -1663,7 +2024,8 @@ __buildRecordBatchFieldState(setupRecordBatchContext *con,
 	{
 		rb_field->nullmap_offset = buffer_curr->offset;
 		rb_field->nullmap_length = buffer_curr->length;
-		if (rb_field->nullmap_length < BITMAPLEN(rb_field->nitems))
+		if (!con->compressed &&
+			rb_field->nullmap_length < BITMAPLEN(rb_field->nitems))
 			elog(ERROR, "nullmap length is smaller than expected");
 		if (rb_field->nullmap_offset != MAXALIGN(rb_field->nullmap_offset))
 			elog(ERROR, "nullmap is not aligned well");
@@ -1677,12 +2039,54 @@ __buildRecordBatchFieldState(setupRecordBatchContext *con,
 			elog(ERROR, "RecordBatch has less buffers than expected");
 		rb_field->values_offset = buffer_curr->offset;
 		rb_field->values_length = buffer_curr->length;
-		if (rb_field->values_length < least_values_length)
+		if (!con->compressed &&
+			rb_field->values_length < least_values_length)
 			elog(ERROR, "values array is smaller than expected");
 		if (rb_field->values_offset != MAXALIGN(rb_field->values_offset))
 			elog(ERROR, "values array is not aligned well");
 	}
 
+	/*
+	 * setup variadic data buffers of BinaryView/Utf8View
+	 *
+	 * Its number is given by the variadicBufferCounts of the record-batch.
+	 * The buffers shall be loaded as a contiguous extra region (from the
+	 * head of the first buffer to the tail of the last buffer), then the
+	 * views are adjusted to the offset from the extra region if needed.
+	 */
+	if (has_variadic_buffers)
+	{
+		int64_t		nbuffers;
+
+		Assert(least_values_length > 0);
+		if (con->variadic_curr >= con->variadic_tail)
+			elog(ERROR, "RecordBatch has less variadicBufferCounts than expected");
+		nbuffers = *con->variadic_curr++;
+		if (nbuffers < 0 || nbuffers > con->buffer_tail - con->buffer_curr)
+			elog(ERROR, "RecordBatch has less buffers than expected");
+		if (nbuffers > 0)
+		{
+			rb_field->variadic_offsets = palloc(sizeof(off_t) * nbuffers);
+			rb_field->variadic_lengths = palloc(sizeof(size_t) * nbuffers);
+			for (int k=0; k < nbuffers; k++)
+			{
+				buffer_curr = con->buffer_curr++;
+				if (buffer_curr->offset != MAXALIGN(buffer_curr->offset))
+					elog(ERROR, "variadic buffer is not aligned well");
+				if (k > 0 && buffer_curr->offset < (rb_field->variadic_offsets[k-1] +
+													rb_field->variadic_lengths[k-1]))
+					elog(ERROR, "variadic buffers are not sequentially placed");
+				rb_field->variadic_offsets[k] = buffer_curr->offset;
+				rb_field->variadic_lengths[k] = buffer_curr->length;
+			}
+			rb_field->extra_offset = rb_field->variadic_offsets[0];
+			rb_field->extra_length = (rb_field->variadic_offsets[nbuffers-1] +
+									  rb_field->variadic_lengths[nbuffers-1] -
+									  rb_field->variadic_offsets[0]);
+		}
+		rb_field->num_variadic = nbuffers;
+	}
+
 	/* setup extra buffer */
 	if (has_extra_buffer)
 	{
@@ -1723,9 +2127,6 @@ __buildRecordBatchStateOne(ArrowSchema *schema,
 	RecordBatchState *rb_state;
 	int			nfields = schema->_num_fields;
 
-	if (rbatch->compression)
-		elog(ERROR, "arrow_fdw: right now, compressed record-batche is not supported");
-
 	rb_state = palloc0(offsetof(RecordBatchState, fields[nfields]));
 	rb_state->af_state = af_state;
 	rb_state->rb_index = rb_index;
@@ -1733,12 +2134,42 @@ __buildRecordBatchStateOne(ArrowSchema *schema,
 	rb_state->rb_length = block->bodyLength;
 	rb_state->rb_nitems = rbatch->length;
 	rb_state->nfields   = nfields;
+	if (rbatch->compression)
+	{
+		ArrowBodyCompression *compress = rbatch->compression;
+
+		if (compress->method != ArrowBodyCompressionMethod__BUFFER)
+			elog(ERROR, "arrow_fdw: unknown body compression method (%d) at '%s'",
+				 (int)compress->method, af_state->filename);
+		switch (compress->codec)
+		{
+#ifdef USE_LZ4
+			case ArrowCompressionType__LZ4_FRAME:
+				break;
+#endif
+#ifdef USE_ZSTD
+			case ArrowCompressionType__ZSTD:
+				break;
+#endif
+			default:
+				elog(ERROR, "arrow_fdw: compression codec (%s) is not supported at '%s'",
+					 compress->codec == ArrowCompressionType__LZ4_FRAME ? "LZ4_FRAME" :
+					 compress->codec == ArrowCompressionType__ZSTD ? "ZSTD" : "???",
+					 af_state->filename);
+		}
+		rb_state->rb_compressed = true;
+		rb_state->rb_codec = compress->codec;
+	}
 
 	memset(&con, 0, sizeof(setupRecordBatchContext));
+	con.compressed  = rb_state->rb_compressed;
 	con.buffer_curr = rbatch->buffers;
 	con.buffer_tail = rbatch->buffers + rbatch->_num_buffers;
 	con.fnode_curr  = rbatch->nodes;
 	con.fnode_tail  = rbatch->nodes + rbatch->_num_nodes;
+	con.variadic_curr = rbatch->variadicBufferCounts;
+	con.variadic_tail = (rbatch->variadicBufferCounts +
+						 rbatch->_num_variadicBufferCounts);
 	for (int j=0; j < nfields; j++)
 	{
 		RecordBatchFieldState *rb_field = &rb_state->fields[j];
@@ -1747,18 +2178,23 @@ __buildRecordBatchStateOne(ArrowSchema *schema,
 		__buildRecordBatchFieldState(&con, rb_field, field, 0);
 	}
 	if (con.buffer_curr != con.buffer_tail ||
-		con.fnode_curr  != con.fnode_tail)
+		con.fnode_curr  != con.fnode_tail ||
+		con.variadic_curr != con.variadic_tail)
 		elog(ERROR, "arrow_fdw: RecordBatch may be corrupted");
 	return rb_state;
 }
 
 /*
  * readArrowFile
+ *
+ * Parquet file is also acceptable; then, af_info has only the Arrow schema
+ * equivalent to the parquet schema, and pq_info (if any) has the row-groups.
  */
 static bool
-readArrowFile(const char *filename, ArrowFileInfo *af_info, bool missing_ok)
+__readArrowFile(const char *filename, ArrowFileInfo *af_info,
+				ParquetFileInfo *pq_info, bool missing_ok)
 {
-    File	filp = PathNameOpenFile(filename, O_RDONLY | PG_BINARY);
+	File	filp = PathNameOpenFile(filename, O_RDONLY | PG_BINARY);
 
 	if (filp < 0)
 	{
@@ -1768,6 +2204,32 @@ readArrowFile(const char *filename, ArrowFileInfo *af_info, bool missing_ok)
 				(errcode_for_file_access(),
 				 errmsg("could not open file \"%s\": %m", filename)));
 	}
+	if (fileIsParquet(FileGetRawDesc(filp)))
+	{
+		ParquetFileInfo	__pq_info;
+
+		if (!pq_info)
+			pq_info = &__pq_info;
+		readParquetFileDesc(FileGetRawDesc(filp), filename, pq_info);
+		FileClose(filp);
+
+		memset(af_info, 0, sizeof(ArrowFileInfo));
+		af_info->filename = filename;
+		memcpy(&af_info->stat_buf, &pq_info->stat_buf, sizeof(struct stat));
+		initArrowNode(&af_info->footer, Footer);
+		memcpy(&af_info->footer.schema, &pq_info->schema, sizeof(ArrowSchema));
+		af_info->footer._num_recordBatches = pq_info->num_row_groups;
+		return true;
+	}
+	else if (pq_info)
+		memset(pq_info, 0, sizeof(ParquetFileInfo));
+	/* footer may be rewritten by the concurrent INSERT on commit */
+	while (flock(FileGetRawDesc(filp), LOCK_SH) != 0)
+	{
+		if (errno != EINTR)
+			elog(ERROR, "failed on flock('%s'): %m", filename);
+		CHECK_FOR_INTERRUPTS();
+	}
 	readArrowFileDesc(FileGetRawDesc(filp), af_info);
 	FileClose(filp);
 	if (af_info->dictionaries != NULL)
@@ -1776,6 +2238,112 @@ readArrowFile(const char *filename, ArrowFileInfo *af_info, bool missing_ok)
 	return true;
 }
 
+static bool
+readArrowFile(const char *filename, ArrowFileInfo *af_info, bool missing_ok)
+{
+	return __readArrowFile(filename, af_info, NULL, missing_ok);
+}
+
+/*
+ * __buildArrowFileStateByParquet
+ *
+ * Each row-group of the parquet file is mapped on a RecordBatchState, and
+ * its column chunks are decoded by the backend on loading. Because parquet
+ * file has no fixed buffer layout to be kept on the metadata-cache, we
+ * always read the file footer.
+ */
+static ArrowFileState *
+__buildArrowFileStateByParquet(const char *filename, Bitmapset **p_stat_attrs)
+{
+	ArrowFileInfo	af_info;
+	ParquetFileInfo	pq_info;
+	ArrowFileState *af_state;
+	ArrowSchema	   *schema = &pq_info.schema;
+	arrowStatsBinary *arrow_bstats;
+
+	if (!__readArrowFile(filename, &af_info, &pq_info, true))
+	{
+		elog(DEBUG2, "file '%s' is missing: %m", filename);
+		return NULL;
+	}
+	af_state = palloc0(sizeof(ArrowFileState));
+	af_state->filename = pstrdup(filename);
+	memcpy(&af_state->stat_buf, &pq_info.stat_buf, sizeof(struct stat));
+
+	arrow_bstats = buildArrowStatsBinary(&af_info.footer, p_stat_attrs);
+	for (int i=0; i < pq_info.num_row_groups; i++)
+	{
+		ParquetRowGroup *pq_rgroup = &pq_info.row_groups[i];
+		RecordBatchState *rb_state;
+		int			nfields = schema->_num_fields;
+
+		if (pq_rgroup->num_rows <= 0)
+			continue;
+		if (pq_rgroup->num_rows >= UINT_MAX)
+			elog(ERROR, "arrow_fdw: row-group %d of '%s' has too many rows",
+				 i, filename);
+		rb_state = palloc0(offsetof(RecordBatchState, fields[nfields]));
+		rb_state->af_state = af_state;
+		rb_state->rb_index = i;
+		rb_state->rb_nitems = pq_rgroup->num_rows;
+		rb_state->rb_parquet = true;
+		rb_state->nfields = nfields;
+		for (int j=0; j < nfields; j++)
+		{
+			RecordBatchFieldState *rb_field = &rb_state->fields[j];
+			ParquetColumnChunk *pq_chunk = &pq_rgroup->columns[j];
+
+			rb_field->atttypid    = InvalidOid;
+			rb_field->atttypmod   = -1;
+			__arrowFieldTypeToPGType(&schema->fields[j],
+									 &rb_field->atttypid,
+									 &rb_field->atttypmod,
+									 &rb_field->attopts);
+			rb_field->nitems      = pq_rgroup->num_rows;
+			rb_field->null_count  = Max(pq_chunk->null_count, 0);
+			/* whole column chunk; to be decoded on loading */
+			rb_field->values_offset = pq_chunk->chunk_offset;
+			rb_field->values_length = pq_chunk->chunk_length;
+			rb_field->stat_datum.isnull = true;
+			rb_field->pq_chunk    = pq_chunk;
+			rb_state->rb_length  += pq_chunk->chunk_length;
+		}
+		if (arrow_bstats)
+			applyArrowStatsBinary(rb_state, arrow_bstats);
+		af_state->rb_list = lappend(af_state->rb_list, rb_state);
+	}
+	releaseArrowStatsBinary(arrow_bstats);
+
+	if (af_state->rb_list == NIL)
+	{
+		elog(DEBUG2, "parquet file '%s' contains no row-group", filename);
+		return NULL;
+	}
+	return af_state;
+}
+
+static bool
+__arrowFileIsParquet(const char *filename)
+{
+	int		fdesc = open(filename, O_RDONLY);
+	bool	retval;
+
+	if (fdesc < 0)
+		return false;
+	retval = fileIsParquet(fdesc);
+	close(fdesc);
+
+	return retval;
+}
+
+static bool
+__arrowFileIsShmem(const char *filename)
+{
+	const char *pos = strrchr(filename, '.');
+
+	return (pos && strcmp(pos+1, ARROW_SHMEM_SUFFIX) == 0);
+}
+
 static ArrowFileState *
 __buildArrowFileStateByFile(const char *filename, Bitmapset **p_stat_attrs)
 {
@@ -1812,10 +2380,41 @@ __buildArrowFileStateByFile(const char *filename, Bitmapset **p_stat_attrs)
 		af_state->rb_list = lappend(af_state->rb_list, rb_state);
 	}
 	releaseArrowStatsBinary(arrow_bstats);
+	if (p_stat_attrs)
+		applyArrowZoneMaps(&af_info.footer, af_state->rb_list);
 
 	return af_state;
 }
 
+/*
+ * __buildArrowFileStateByShmem
+ *
+ * Shared memory segment is visible to readers before its Schema message
+ * is committed by the producer, so it is skipped until the commit.
+ */
+static ArrowFileState *
+__buildArrowFileStateByShmem(const char *filename, Bitmapset **p_stat_attrs)
+{
+	ArrowShmemHeader shm_head;
+	int			fdesc = open(filename, O_RDONLY);
+	ssize_t		nbytes;
+
+	if (fdesc < 0)
+		return NULL;
+	nbytes = pread(fdesc, &shm_head, sizeof(ArrowShmemHeader), 0);
+	close(fdesc);
+	if (nbytes != sizeof(ArrowShmemHeader) ||
+		memcmp(shm_head.signature,
+			   ARROW_SHMEM_SIGNATURE,
+			   ARROW_SHMEM_SIGNATURE_SZ) != 0 ||
+		shm_head.committed <= ARROW_SHMEM_HEADER_SZ)
+	{
+		elog(DEBUG2, "shared memory segment '%s' is not ready", filename);
+		return NULL;
+	}
+	return __buildArrowFileStateByFile(filename, p_stat_attrs);
+}
+
 
 static arrowMetadataFieldCache *
 __buildArrowMetadataFieldCache(RecordBatchFieldState *rb_field)
@@ -1852,6 +2451,23 @@ __buildArrowMetadataFieldCache(RecordBatchFieldState *rb_field)
 		}
 		dlist_push_tail(&fcache->children, &__fcache->chain);
 	}
+	fcache->num_variadic = rb_field->num_variadic;
+	dlist_init(&fcache->variadics);
+	for (int k=0; k < rb_field->num_variadic; k++)
+	{
+		arrowMetadataFieldCache *__fcache = __allocMetadataFieldCache();
+
+		if (!__fcache)
+		{
+			__releaseMetadataFieldCache(fcache);
+			return NULL;
+		}
+		dlist_init(&__fcache->children);
+		dlist_init(&__fcache->variadics);
+		__fcache->extra_offset = rb_field->variadic_offsets[k];
+		__fcache->extra_length = rb_field->variadic_lengths[k];
+		dlist_push_tail(&fcache->variadics, &__fcache->chain);
+	}
 	return fcache;
 }
 
@@ -1886,6 +2502,9 @@ __buildArrowMetadataCacheNoLock(ArrowFileState *af_state)
 		mcache->rb_offset = rb_state->rb_offset;
 		mcache->rb_length = rb_state->rb_length;
 		mcache->rb_nitems = rb_state->rb_nitems;
+		mcache->rb_compressed = rb_state->rb_compressed;
+		mcache->rb_codec  = rb_state->rb_codec;
+		mcache->zone_nrows = rb_state->zone_nrows;
 		mcache->nfields   = rb_state->nfields;
 		dlist_init(&mcache->fields);
 		if (!mcache_head)
@@ -1917,2199 +2536,7500 @@ __buildArrowMetadataCacheNoLock(ArrowFileState *af_state)
 	SpinLockRelease(&arrow_metadata_cache->lru_lock);
 }
 
-static ArrowFileState *
-BuildArrowFileState(Relation frel, const char *filename, Bitmapset **p_stat_attrs)
+/*
+ * Metadata cache on the disk
+ *
+ * The shared metadata cache is lost on restart, and small for the workloads
+ * that have very large number of files. So, the metadata of the arrow files
+ * are also written to the disk (arrow_fdw.metadata_cache_dir) keyed by the
+ * device and inode number, then loaded by mmap(2) lazily, if the shared
+ * metadata cache has no entry. The entry is valid only if size and mtime
+ * of the arrow file are identical. Like the shared metadata cache, zone-map
+ * is not cached, and parquet files are out of the scope.
+ */
+#define ARROW_METADATA_DISK_MAGIC		(0x41524d43U)	/* 'ARMC' */
+#define ARROW_METADATA_DISK_VERSION		1
+
+typedef struct
 {
-	arrowMetadataCache *mcache;
-	ArrowFileState *af_state;
-	RecordBatchState *rb_state;
-	struct stat		stat_buf;
-	TupleDesc		tupdesc;
+	uint32_t	magic;
+	uint32_t	version;
+	uint64_t	length;				/* total length of the cache file */
+	uint64_t	st_dev;
+	uint64_t	st_ino;
+	uint64_t	st_size;
+	int64_t		st_mtime_sec;
+	int64_t		st_mtime_nsec;
+	uint32_t	num_rbatches;
+	/* followed by the arrowMetadataDiskBatch and the fields */
+} arrowMetadataDiskHead;
 
-	if (stat(filename, &stat_buf) != 0)
-		elog(ERROR, "failed on stat('%s'): %m", filename);
-	LWLockAcquire(&arrow_metadata_cache->mutex, LW_SHARED);
-	mcache = lookupArrowMetadataCache(&stat_buf, false);
-	if (mcache)
+typedef struct
+{
+	int			rb_index;
+	off_t		rb_offset;
+	size_t		rb_length;
+	int64		rb_nitems;
+	bool		rb_compressed;
+	ArrowCompressionType rb_codec;
+	uint32_t	zone_nrows;
+	int			nfields;
+	/* followed by the arrowMetadataDiskField in pre-order */
+} arrowMetadataDiskBatch;
+
+typedef struct
+{
+	Oid			atttypid;
+	int			atttypmod;
+	ArrowTypeOptions attopts;
+	int64		nitems;
+	int64		null_count;
+	off_t		nullmap_offset;
+	size_t		nullmap_length;
+	off_t		values_offset;
+	size_t		values_length;
+	off_t		extra_offset;
+	size_t		extra_length;
+	MinMaxStatDatum stat_datum;
+	int			num_children;
+} arrowMetadataDiskField;
+
+static char *
+__arrowMetadataDiskPath(const struct stat *stat_buf, bool create_dir)
+{
+	char	   *dir_name;
+
+	if (!arrow_metadata_cache_dir || *arrow_metadata_cache_dir == '\0')
+		return NULL;
+	dir_name = psprintf("%s/%02x", arrow_metadata_cache_dir,
+						(unsigned int)(stat_buf->st_ino & 0xff));
+	if (create_dir &&
+		((MakePGDirectory(arrow_metadata_cache_dir) != 0 && errno != EEXIST) ||
+		 (MakePGDirectory(dir_name) != 0 && errno != EEXIST)))
 	{
-		/* found a valid metadata-cache */
-		af_state = __buildArrowFileStateByCache(filename, mcache,
-												p_stat_attrs);
+		elog(LOG, "arrow_fdw: could not create directory \"%s\": %m", dir_name);
+		return NULL;
 	}
-	else
-	{
-		LWLockRelease(&arrow_metadata_cache->mutex);
+	return psprintf("%s/%lx-%lx.meta", dir_name,
+					(unsigned long)stat_buf->st_dev,
+					(unsigned long)stat_buf->st_ino);
+}
 
-		/* here is no valid metadata-cache, so build it from the raw file */
-		af_state = __buildArrowFileStateByFile(filename, p_stat_attrs);
-		if (!af_state)
-			return NULL;	/* file not found? */
+static bool
+__loadArrowMetadataDiskField(RecordBatchFieldState *rb_field,
+							 const char **p_pos, const char *end)
+{
+	const arrowMetadataDiskField *dfield = (const arrowMetadataDiskField *)*p_pos;
 
-		LWLockAcquire(&arrow_metadata_cache->mutex, LW_EXCLUSIVE);
-		mcache = lookupArrowMetadataCache(&af_state->stat_buf, true);
-		if (!mcache)
-			__buildArrowMetadataCacheNoLock(af_state);
+	if (*p_pos + sizeof(arrowMetadataDiskField) > end)
+		return false;
+	*p_pos += MAXALIGN(sizeof(arrowMetadataDiskField));
+	/* type of the field may be dropped */
+	if (dfield->atttypid >= FirstNormalObjectId &&
+		!SearchSysCacheExists1(TYPEOID, ObjectIdGetDatum(dfield->atttypid)))
+		return false;
+	rb_field->atttypid       = dfield->atttypid;
+	rb_field->atttypmod      = dfield->atttypmod;
+	rb_field->attopts        = dfield->attopts;
+	rb_field->nitems         = dfield->nitems;
+	rb_field->null_count     = dfield->null_count;
+	rb_field->nullmap_offset = dfield->nullmap_offset;
+	rb_field->nullmap_length = dfield->nullmap_length;
+	rb_field->values_offset  = dfield->values_offset;
+	rb_field->values_length  = dfield->values_length;
+	rb_field->extra_offset   = dfield->extra_offset;
+	rb_field->extra_length   = dfield->extra_length;
+	memcpy(&rb_field->stat_datum,
+		   &dfield->stat_datum, sizeof(MinMaxStatDatum));
+	if (dfield->num_children < 0)
+		return false;
+	if (dfield->num_children > 0)
+	{
+		rb_field->num_children = dfield->num_children;
+		rb_field->children = palloc0(sizeof(RecordBatchFieldState) *
+									 dfield->num_children);
+		for (int j=0; j < dfield->num_children; j++)
+		{
+			if (!__loadArrowMetadataDiskField(&rb_field->children[j],
+											  p_pos, end))
+				return false;
+		}
 	}
-	LWLockRelease(&arrow_metadata_cache->mutex);
+	return true;
+}
 
-	/* compatibility checks */
-	rb_state = linitial(af_state->rb_list);
-	tupdesc = RelationGetDescr(frel);
-	if (tupdesc->natts != rb_state->nfields)
-		elog(ERROR, "arrow_fdw: foreign table '%s' is not compatible to '%s'",
-			 RelationGetRelationName(frel), filename);
-	for (int j=0; j < tupdesc->natts; j++)
+static ArrowFileState *
+__buildArrowFileStateByDiskCache(const char *filename,
+								 struct stat *stat_buf,
+								 Bitmapset **p_stat_attrs)
+{
+	ArrowFileState *af_state = NULL;
+	const arrowMetadataDiskHead *dhead;
+	const char *pos, *end;
+	Bitmapset  *stat_attrs = NULL;
+	struct stat	disk_stat;
+	char	   *path;
+	char	   *mmap_addr;
+	size_t		mmap_sz;
+	int			fdesc;
+
+	path = __arrowMetadataDiskPath(stat_buf, false);
+	if (!path)
+		return NULL;
+	fdesc = OpenTransientFile(path, O_RDONLY | PG_BINARY);
+	if (fdesc < 0)
+		return NULL;	/* not cached yet */
+	if (fstat(fdesc, &disk_stat) != 0 ||
+		disk_stat.st_size < sizeof(arrowMetadataDiskHead))
 	{
-		Form_pg_attribute	attr = TupleDescAttr(tupdesc, j);
-		RecordBatchFieldState *rb_field = &rb_state->fields[j];
+		CloseTransientFile(fdesc);
+		return NULL;
+	}
+	mmap_sz = disk_stat.st_size;
+	mmap_addr = mmap(NULL, mmap_sz, PROT_READ, MAP_SHARED, fdesc, 0);
+	CloseTransientFile(fdesc);
+	if (mmap_addr == MAP_FAILED)
+		return NULL;
 
-		if (attr->atttypid != rb_field->atttypid)
-			elog(ERROR, "arrow_fdw: foreign table '%s' column '%s' (%s) is not compatible to the arrow field (%s) in the '%s'",
-				 RelationGetRelationName(frel),
-				 NameStr(attr->attname),
-				 format_type_be(attr->atttypid),
-				 format_type_be(rb_field->atttypid),
-				 filename);
+	dhead = (const arrowMetadataDiskHead *)mmap_addr;
+	if (dhead->magic != ARROW_METADATA_DISK_MAGIC ||
+		dhead->version != ARROW_METADATA_DISK_VERSION ||
+		dhead->length != mmap_sz ||
+		dhead->st_dev != stat_buf->st_dev ||
+		dhead->st_ino != stat_buf->st_ino ||
+		dhead->st_size != stat_buf->st_size ||
+		dhead->st_mtime_sec != stat_buf->st_mtim.tv_sec ||
+		dhead->st_mtime_nsec != stat_buf->st_mtim.tv_nsec ||
+		dhead->num_rbatches == 0)
+		goto out;	/* stale entry */
+
+	af_state = palloc0(sizeof(ArrowFileState));
+	af_state->filename = pstrdup(filename);
+	memcpy(&af_state->stat_buf, stat_buf, sizeof(struct stat));
+	pos = mmap_addr + MAXALIGN(sizeof(arrowMetadataDiskHead));
+	end = mmap_addr + mmap_sz;
+	for (uint32_t i=0; i < dhead->num_rbatches; i++)
+	{
+		const arrowMetadataDiskBatch *dbatch = (const arrowMetadataDiskBatch *)pos;
+		RecordBatchState *rb_state;
+
+		if (pos + sizeof(arrowMetadataDiskBatch) > end ||
+			dbatch->nfields <= 0)
+			goto corrupted;
+		pos += MAXALIGN(sizeof(arrowMetadataDiskBatch));
+		rb_state = palloc0(offsetof(RecordBatchState,
+									fields[dbatch->nfields]));
+		rb_state->af_state  = af_state;
+		rb_state->rb_index  = dbatch->rb_index;
+		rb_state->rb_offset = dbatch->rb_offset;
+		rb_state->rb_length = dbatch->rb_length;
+		rb_state->rb_nitems = dbatch->rb_nitems;
+		rb_state->rb_compressed = dbatch->rb_compressed;
+		rb_state->rb_codec  = dbatch->rb_codec;
+		rb_state->zone_nrows = dbatch->zone_nrows;
+		rb_state->nfields   = dbatch->nfields;
+		for (int j=0; j < rb_state->nfields; j++)
+		{
+			if (!__loadArrowMetadataDiskField(&rb_state->fields[j], &pos, end))
+				goto corrupted;
+			if (!rb_state->fields[j].stat_datum.isnull)
+				stat_attrs = bms_add_member(stat_attrs, j+1);
+		}
+		af_state->rb_list = lappend(af_state->rb_list, rb_state);
 	}
+	if (p_stat_attrs)
+		*p_stat_attrs = bms_add_members(*p_stat_attrs, stat_attrs);
+	goto out;
+
+corrupted:
+	elog(DEBUG1, "arrow_fdw: metadata cache \"%s\" is corrupted, so ignored", path);
+	af_state = NULL;
+out:
+	munmap(mmap_addr, mmap_sz);
 	return af_state;
 }
 
-/*
- * baseRelIsArrowFdw
- */
-bool
-baseRelIsArrowFdw(RelOptInfo *baserel)
+static void
+__appendMetadataDiskItem(StringInfo buf, const void *item, size_t sz)
 {
-	if ((baserel->reloptkind == RELOPT_BASEREL ||
-		 baserel->reloptkind == RELOPT_OTHER_MEMBER_REL) &&
-		baserel->rtekind == RTE_RELATION &&
-		OidIsValid(baserel->serverid) &&
-		baserel->fdwroutine &&
-		memcmp(baserel->fdwroutine,
-			   &pgstrom_arrow_fdw_routine,
-			   sizeof(FdwRoutine)) == 0)
-		return true;
+	appendBinaryStringInfo(buf, item, sz);
+	while (buf->len != MAXALIGN(buf->len))
+		appendStringInfoChar(buf, '\0');
+}
 
-	return false;
+static void
+__writeArrowMetadataDiskField(StringInfo buf, RecordBatchFieldState *rb_field)
+{
+	arrowMetadataDiskField dfield;
+
+	memset(&dfield, 0, sizeof(arrowMetadataDiskField));
+	dfield.atttypid       = rb_field->atttypid;
+	dfield.atttypmod      = rb_field->atttypmod;
+	dfield.attopts        = rb_field->attopts;
+	dfield.nitems         = rb_field->nitems;
+	dfield.null_count     = rb_field->null_count;
+	dfield.nullmap_offset = rb_field->nullmap_offset;
+	dfield.nullmap_length = rb_field->nullmap_length;
+	dfield.values_offset  = rb_field->values_offset;
+	dfield.values_length  = rb_field->values_length;
+	dfield.extra_offset   = rb_field->extra_offset;
+	dfield.extra_length   = rb_field->extra_length;
+	memcpy(&dfield.stat_datum,
+		   &rb_field->stat_datum, sizeof(MinMaxStatDatum));
+	dfield.num_children   = rb_field->num_children;
+	__appendMetadataDiskItem(buf, &dfield, sizeof(arrowMetadataDiskField));
+	for (int j=0; j < rb_field->num_children; j++)
+		__writeArrowMetadataDiskField(buf, &rb_field->children[j]);
 }
 
-/*
- * RelationIsArrowFdw
- */
-bool
-RelationIsArrowFdw(Relation frel)
+static void
+__writeArrowMetadataDiskCache(ArrowFileState *af_state)
 {
-	if (RelationGetForm(frel)->relkind == RELKIND_FOREIGN_TABLE)
+	arrowMetadataDiskHead *dhead;
+	StringInfoData buf;
+	ListCell   *lc;
+	char	   *path;
+	char	   *temp;
+	int			fdesc;
+	ssize_t		nbytes, sz;
+
+	if (af_state->rb_list == NIL)
+		return;
+	path = __arrowMetadataDiskPath(&af_state->stat_buf, true);
+	if (!path)
+		return;
+	initStringInfo(&buf);
+	enlargeStringInfo(&buf, sizeof(arrowMetadataDiskHead));
+	memset(buf.data, 0, sizeof(arrowMetadataDiskHead));
+	buf.len = MAXALIGN(sizeof(arrowMetadataDiskHead));
+	foreach (lc, af_state->rb_list)
 	{
-		FdwRoutine *routine = GetFdwRoutineForRelation(frel, false);
-
-		if (memcmp(routine, &pgstrom_arrow_fdw_routine, sizeof(FdwRoutine)) == 0)
-			return true;
+		RecordBatchState *rb_state = lfirst(lc);
+		arrowMetadataDiskBatch dbatch;
+
+		memset(&dbatch, 0, sizeof(arrowMetadataDiskBatch));
+		dbatch.rb_index  = rb_state->rb_index;
+		dbatch.rb_offset = rb_state->rb_offset;
+		dbatch.rb_length = rb_state->rb_length;
+		dbatch.rb_nitems = rb_state->rb_nitems;
+		dbatch.rb_compressed = rb_state->rb_compressed;
+		dbatch.rb_codec  = rb_state->rb_codec;
+		dbatch.zone_nrows = rb_state->zone_nrows;
+		dbatch.nfields   = rb_state->nfields;
+		__appendMetadataDiskItem(&buf, &dbatch, sizeof(arrowMetadataDiskBatch));
+		for (int j=0; j < rb_state->nfields; j++)
+			__writeArrowMetadataDiskField(&buf, &rb_state->fields[j]);
 	}
-	return false;
+	dhead = (arrowMetadataDiskHead *)buf.data;
+	dhead->magic = ARROW_METADATA_DISK_MAGIC;
+	dhead->version = ARROW_METADATA_DISK_VERSION;
+	dhead->length = buf.len;
+	dhead->st_dev = af_state->stat_buf.st_dev;
+	dhead->st_ino = af_state->stat_buf.st_ino;
+	dhead->st_size = af_state->stat_buf.st_size;
+	dhead->st_mtime_sec = af_state->stat_buf.st_mtim.tv_sec;
+	dhead->st_mtime_nsec = af_state->stat_buf.st_mtim.tv_nsec;
+	dhead->num_rbatches = list_length(af_state->rb_list);
+
+	/* write to the temporary file, then rename it atomically */
+	temp = psprintf("%s.%d.tmp", path, MyProcPid);
+	fdesc = OpenTransientFile(temp, O_WRONLY | O_CREAT | O_TRUNC | PG_BINARY);
+	if (fdesc < 0)
+	{
+		elog(LOG, "arrow_fdw: could not open file \"%s\": %m", temp);
+		goto out;
+	}
+	for (nbytes = 0; nbytes < buf.len; nbytes += sz)
+	{
+		sz = write(fdesc, buf.data + nbytes, buf.len - nbytes);
+		if (sz < 0 && errno == EINTR)
+			sz = 0;
+		else if (sz <= 0)
+		{
+			elog(LOG, "arrow_fdw: could not write file \"%s\": %m", temp);
+			CloseTransientFile(fdesc);
+			unlink(temp);
+			goto out;
+		}
+	}
+	CloseTransientFile(fdesc);
+	if (rename(temp, path) != 0)
+	{
+		elog(LOG, "arrow_fdw: could not rename file \"%s\" to \"%s\": %m",
+			 temp, path);
+		unlink(temp);
+	}
+out:
+	pfree(buf.data);
+	pfree(temp);
 }
 
 /*
- * GetOptimalGpusForArrowFdw
+ * Routines for hive-style partitioning
+ *
+ * When 'hive_partitioning' option is set, the key=value components of the
+ * directory path (e.g, /opt/data/dt=2026-10-01/region=eu/000001.arrow) are
+ * considered as the partition keys of the files. The foreign-table columns
+ * that are named by the partition keys are not a part of arrow files, but
+ * constant columns per file. It also allows to prune the files according to
+ * the scan qualifiers prior to read the file footers.
  */
-const Bitmapset *
-GetOptimalGpusForArrowFdw(PlannerInfo *root, RelOptInfo *baserel)
+#define HIVE_DEFAULT_PARTITION		"__HIVE_DEFAULT_PARTITION__"
+
+static inline int
+__hexdigit(int c)
 {
-	List	   *priv_list = (List *)baserel->fdw_private;
-	Bitmapset  *optimal_gpus = NULL;
+	if (c >= '0' && c <= '9')
+		return c - '0';
+	if (c >= 'a' && c <= 'f')
+		return c - 'a' + 10;
+	if (c >= 'A' && c <= 'F')
+		return c - 'A' + 10;
+	return -1;
+}
 
-	if (baseRelIsArrowFdw(baserel) &&
-		IsA(priv_list, List) && list_length(priv_list) == 2)
-	{
-		List	   *af_list = linitial(priv_list);
-		ListCell   *lc;
+static char *
+__arrowPartitionUrlDecode(const char *str, int len)
+{
+	char	   *result = palloc(len + 1);
+	char	   *pos = result;
 
-		foreach (lc, af_list)
+	for (int i=0; i < len; i++)
+	{
+		if (str[i] == '%' && i + 2 < len &&
+			__hexdigit(str[i+1]) >= 0 &&
+			__hexdigit(str[i+2]) >= 0)
 		{
-			ArrowFileState *af_state = lfirst(lc);
-			const Bitmapset *__optimal_gpus;
-
-			__optimal_gpus = GetOptimalGpuForFile(af_state->filename);
-			if (lc == list_head(af_list))
-				optimal_gpus = bms_copy(__optimal_gpus);
-			else
-				optimal_gpus = bms_intersect(optimal_gpus, __optimal_gpus);
+			*pos++ = (__hexdigit(str[i+1]) << 4) | __hexdigit(str[i+2]);
+			i += 2;
 		}
+		else
+			*pos++ = str[i];
 	}
-	return optimal_gpus;
+	*pos = '\0';
+	return result;
 }
 
 /*
- * GetOptimalDpuForArrowFdw
+ * __arrowFdwParsePartitionKeys
+ *
+ * It picks up the key=value components from the directory path of the file.
+ * The inner directory has priority, if a particular key appeared twice.
  */
-const DpuStorageEntry *
-GetOptimalDpuForArrowFdw(PlannerInfo *root, RelOptInfo *baserel)
+static List *
+__arrowFdwParsePartitionKeys(const char *filename)
 {
-	const DpuStorageEntry *ds_entry = NULL;
-	List	   *priv_list = (List *)baserel->fdw_private;
+	const char *tail = strrchr(filename, '/');
+	const char *pos = filename;
+	List	   *partition_keys = NIL;
 
-	if (baseRelIsArrowFdw(baserel) &&
-		IsA(priv_list, List) && list_length(priv_list) == 2)
+	if (!tail)
+		return NIL;
+	while (pos < tail)
 	{
-		List	   *af_list = linitial(priv_list);
-		ListCell   *lc;
+		const char *next = strchr(pos, '/');
+		const char *delim;
 
-		foreach (lc, af_list)
+		Assert(next != NULL);
+		delim = memchr(pos, '=', next - pos);
+		if (delim && delim > pos)
 		{
-			ArrowFileState *af_state = lfirst(lc);
-			const DpuStorageEntry *__ds_entry;
+			arrowPartitionKey *pkey = palloc0(sizeof(arrowPartitionKey));
 
-			__ds_entry = GetOptimalDpuForFile(af_state->filename, NULL);
-			if (lc == list_head(af_list))
-				ds_entry = __ds_entry;
-			else if (ds_entry && ds_entry != __ds_entry)
-				ds_entry = NULL;
+			pkey->key = __arrowPartitionUrlDecode(pos, delim - pos);
+			pkey->value = __arrowPartitionUrlDecode(delim + 1, next - (delim + 1));
+			if (strcmp(pkey->value, HIVE_DEFAULT_PARTITION) == 0)
+				pkey->value = NULL;
+			partition_keys = lappend(partition_keys, pkey);
 		}
+		pos = next + 1;
 	}
-	return ds_entry;
+	return partition_keys;
+}
+
+static arrowPartitionKey *
+__arrowFdwLookupPartitionKey(List *partition_keys, Form_pg_attribute attr)
+{
+	arrowPartitionKey *result = NULL;
+	ListCell   *lc;
+
+	if (attr->attisdropped)
+		return NULL;
+	foreach (lc, partition_keys)
+	{
+		arrowPartitionKey *pkey = lfirst(lc);
+
+		if (strcmp(pkey->key, NameStr(attr->attname)) == 0)
+			result = pkey;
+	}
+	return result;
+}
+
+static Datum
+__arrowFdwPartitionKeyDatum(Form_pg_attribute attr, const char *value)
+{
+	Oid			typinput;
+	Oid			typioparam;
+
+	getTypeInputInfo(attr->atttypid, &typinput, &typioparam);
+	return OidInputFunctionCall(typinput, (char *)value,
+								typioparam, attr->atttypmod);
 }
 
 /*
- * arrowFdwExtractFilesList
+ * __arrowFdwPartitionIsRefuted
+ *
+ * It checks whether the qualifiers that reference only partition keys are
+ * refuted by the partition keys of the file, or not.
  */
-static List *
-arrowFdwExtractFilesList(List *options_list,
-						 int *p_parallel_nworkers)
+typedef struct
+{
+	Index		relid;
+	int			natts;
+	Const	  **consts;		/* per attribute; NULL if not partition key */
+} arrowPartitionPruneContext;
+
+static Node *
+__arrowFdwPartitionPruneMutator(Node *node, arrowPartitionPruneContext *con)
 {
+	if (!node)
+		return NULL;
+	if (IsA(node, Var))
+	{
+		Var	   *var = (Var *)node;
+
+		if (var->varno == con->relid &&
+			var->varlevelsup == 0 &&
+			var->varattno > 0 &&
+			var->varattno <= con->natts &&
+			con->consts[var->varattno-1] != NULL)
+			return (Node *)copyObject(con->consts[var->varattno-1]);
+	}
+	return expression_tree_mutator(node, __arrowFdwPartitionPruneMutator, con);
+}
 
+static bool
+__arrowFdwPartitionIsRefuted(Relation frel, const char *filename,
+							 List *quals, Index relid)
+{
+	TupleDesc	tupdesc = RelationGetDescr(frel);
+	List	   *partition_keys;
+	arrowPartitionPruneContext con;
 	ListCell   *lc;
-	List	   *filesList = NIL;
-	char	   *dir_path = NULL;
-	char	   *dir_suffix = NULL;
-	int			parallel_nworkers = -1;
+	bool		has_partition_keys = false;
 
-	foreach (lc, options_list)
+	if (quals == NIL)
+		return false;
+	partition_keys = __arrowFdwParsePartitionKeys(filename);
+	if (partition_keys == NIL)
+		return false;
+
+	con.relid = relid;
+	con.natts = tupdesc->natts;
+	con.consts = palloc0(sizeof(Const *) * tupdesc->natts);
+	for (int j=0; j < tupdesc->natts; j++)
 	{
-		DefElem	   *defel = lfirst(lc);
+		Form_pg_attribute attr = TupleDescAttr(tupdesc, j);
+		arrowPartitionKey *pkey;
+		int16		typlen;
+		bool		typbyval;
 
-		Assert(IsA(defel->arg, String));
-		if (strcmp(defel->defname, "file") == 0)
+		pkey = __arrowFdwLookupPartitionKey(partition_keys, attr);
+		if (!pkey)
+			continue;
+		get_typlenbyval(attr->atttypid, &typlen, &typbyval);
+		con.consts[j] = makeConst(attr->atttypid,
+								  attr->atttypmod,
+								  attr->attcollation,
+								  typlen,
+								  (pkey->value != NULL
+								   ? __arrowFdwPartitionKeyDatum(attr, pkey->value)
+								   : (Datum) 0),
+								  (pkey->value == NULL),
+								  typbyval);
+		has_partition_keys = true;
+	}
+	if (!has_partition_keys)
+		return false;
+
+	foreach (lc, quals)
+	{
+		Node	   *clause = lfirst(lc);
+		Bitmapset  *varattnos = NULL;
+		int			k;
+
+		if (IsA(clause, RestrictInfo))
+			clause = (Node *)((RestrictInfo *)clause)->clause;
+		/* only the qualifiers that reference partition keys */
+		pull_varattnos(clause, relid, &varattnos);
+		if (bms_is_empty(varattnos) ||
+			contain_volatile_functions(clause))
+			continue;
+		for (k = bms_next_member(varattnos, -1);
+			 k >= 0;
+			 k = bms_next_member(varattnos, k))
 		{
-			char   *temp = strVal(defel->arg);
+			int		anum = k + FirstLowInvalidHeapAttributeNumber;
 
-			if (access(temp, R_OK) != 0)
-				elog(ERROR, "arrow_fdw: unable to access '%s': %m", temp);
-			filesList = lappend(filesList, makeString(pstrdup(temp)));
+			if (anum <= 0 || anum > con.natts || !con.consts[anum-1])
+				break;
 		}
-		else if (strcmp(defel->defname, "files") == 0)
-		{
-			char   *temp = pstrdup(strVal(defel->arg));
-			char   *saveptr;
-			char   *tok;
+		if (k >= 0)
+			continue;
+		clause = __arrowFdwPartitionPruneMutator(clause, &con);
+		clause = eval_const_expressions(NULL, clause);
+		if (IsA(clause, Const) &&
+			(((Const *)clause)->constisnull ||
+			 !DatumGetBool(((Const *)clause)->constvalue)))
+			return true;
+	}
+	return false;
+}
 
-			while ((tok = strtok_r(temp, ",", &saveptr)) != NULL)
-			{
-				tok = __trim(tok);
+/*
+ * Manifest of the Arrow files (see arrow_ipc.h)
+ *
+ * The 'manifest' option points a manifest file that summarizes the
+ * time range and bloom filter of the 5-tuple for each file, written by
+ * pcap2arrow --manifest. It allows to skip files prior to read their
+ * footer. The manifest is append-only, so the backend caches the entries
+ * and reads only the lines appended since the last time.
+ */
+typedef struct
+{
+	char		filename[MAXPGPATH];	/* hash key */
+	int64_t		ts_min;			/* PostgreSQL epoch */
+	int64_t		ts_max;
+	const char *ts_column;		/* shared with the header */
+	List	   *bloom_keys;		/* shared with the header */
+	uint32_t	bloom_bits;
+	uint64_t   *bloom;
+} arrowManifestEntry;
 
-				if (*tok != '/')
-					elog(ERROR, "arrow_fdw: file '%s' must be absolute path", tok);
-				if (access(tok, R_OK) != 0)
-					elog(ERROR, "arrow_fdw: unable to access '%s': %m", tok);
-				filesList = lappend(filesList, makeString(pstrdup(tok)));
-			}
-			pfree(temp);
-		}
-		else if (strcmp(defel->defname, "dir") == 0)
-		{
-			dir_path = strVal(defel->arg);
-			if (*dir_path != '/')
-				elog(ERROR, "arrow_fdw: dir '%s' must be absolute path", dir_path);
-		}
-		else if (strcmp(defel->defname, "suffix") == 0)
+typedef struct
+{
+	char		path[MAXPGPATH];	/* hash key */
+	dev_t		st_dev;
+	ino_t		st_ino;
+	off_t		offset;			/* next position to read */
+	MemoryContext memcxt;
+	HTAB	   *htab;
+	/* the latest header line */
+	const char *ts_column;
+	List	   *bloom_keys;
+} arrowManifestCache;
+
+static HTAB	   *arrow_manifest_cache_htab = NULL;
+
+static void
+__arrowFdwManifestParseHeader(arrowManifestCache *mcache, char *line)
+{
+	char	   *tok, *pos;
+
+	mcache->ts_column = NULL;
+	mcache->bloom_keys = NIL;
+	for (tok = strtok_r(line+1, " ", &pos);
+		 tok != NULL;
+		 tok = strtok_r(NULL, " ", &pos))
+	{
+		if (strncmp(tok, "timestamp=", 10) == 0)
+			mcache->ts_column = pstrdup(tok + 10);
+		else if (strncmp(tok, "bloom=", 6) == 0)
 		{
-			dir_suffix = strVal(defel->arg);
+			char   *key, *__pos;
+
+			for (key = strtok_r(tok + 6, ",", &__pos);
+				 key != NULL;
+				 key = strtok_r(NULL, ",", &__pos))
+				mcache->bloom_keys = lappend(mcache->bloom_keys, pstrdup(key));
 		}
-		else if (strcmp(defel->defname, "parallel_workers") == 0)
+	}
+}
+
+static bool
+__arrowFdwManifestParseEntry(arrowManifestCache *mcache, char *line)
+{
+	arrowManifestEntry *entry;
+	char	   *fields[6];
+	char	   *pos, *end;
+	int64_t		ts_min, ts_max;
+	uint32_t	bloom_bits;
+	uint32_t	nwords;
+	bool		found;
+
+	for (int i=0; i < 6; i++)
+	{
+		fields[i] = strtok_r(i == 0 ? line : NULL, "\t", &pos);
+		if (!fields[i])
+			return false;
+	}
+	if (strlen(fields[0]) >= MAXPGPATH)
+		return false;
+	ts_min = strtol(fields[1], &end, 10);
+	if (*end != '\0')
+		return false;
+	ts_max = strtol(fields[2], &end, 10);
+	if (*end != '\0')
+		return false;
+	bloom_bits = strtoul(fields[4], &end, 10);
+	if (*end != '\0' || bloom_bits == 0 || bloom_bits % 64 != 0)
+		return false;
+	nwords = bloom_bits / 64;
+	if (strlen(fields[5]) != 16 * nwords)
+		return false;
+
+	entry = hash_search(mcache->htab, fields[0], HASH_ENTER, &found);
+	if (found)
+		pfree(entry->bloom);
+	entry->ts_min = ts_min - ((POSTGRES_EPOCH_JDATE -
+							   UNIX_EPOCH_JDATE) * USECS_PER_DAY);
+	entry->ts_max = ts_max - ((POSTGRES_EPOCH_JDATE -
+							   UNIX_EPOCH_JDATE) * USECS_PER_DAY);
+	entry->ts_column = mcache->ts_column;
+	entry->bloom_keys = mcache->bloom_keys;
+	entry->bloom_bits = bloom_bits;
+	entry->bloom = palloc(sizeof(uint64_t) * nwords);
+	for (uint32_t i=0; i < nwords; i++)
+	{
+		char	temp[17];
+
+		memcpy(temp, fields[5] + 16 * i, 16);
+		temp[16] = '\0';
+		entry->bloom[i] = strtoull(temp, &end, 16);
+		if (*end != '\0')
 		{
-			if (parallel_nworkers >= 0)
-				elog(ERROR, "'parallel_workers' appeared twice");
-			parallel_nworkers = atoi(strVal(defel->arg));
+			/* broken bloom filter; never skip the file */
+			memset(entry->bloom, ~0, sizeof(uint64_t) * nwords);
+			break;
 		}
-		else
-			elog(ERROR, "arrow: unknown option (%s)", defel->defname);
 	}
-	if (dir_suffix && !dir_path)
-		elog(ERROR, "arrow: cannot use 'suffix' option without 'dir'");
+	return true;
+}
 
-	if (dir_path)
+static arrowManifestCache *
+arrowFdwLookupManifest(List *options_list)
+{
+	arrowManifestCache *mcache;
+	const char *path = NULL;
+	struct stat	st_buf;
+	ListCell   *lc;
+	bool		found;
+	int			fdesc;
+
+	foreach (lc, options_list)
 	{
-		struct dirent *dentry;
-		DIR	   *dir;
-		char   *temp;
+		DefElem	   *defel = lfirst(lc);
 
-		dir = AllocateDir(dir_path);
-		while ((dentry = ReadDir(dir, dir_path)) != NULL)
+		if (strcmp(defel->defname, "manifest") == 0)
+			path = strVal(defel->arg);
+	}
+	if (!path)
+		return NULL;
+	if (*path != '/')
+		elog(ERROR, "arrow_fdw: manifest '%s' must be absolute path", path);
+	if (strlen(path) >= MAXPGPATH)
+		elog(ERROR, "arrow_fdw: manifest path is too long");
+
+	fdesc = open(path, O_RDONLY);
+	if (fdesc < 0)
+		elog(ERROR, "arrow_fdw: failed to open manifest '%s': %m", path);
+	if (fstat(fdesc, &st_buf) != 0)
+	{
+		close(fdesc);
+		elog(ERROR, "failed on fstat('%s'): %m", path);
+	}
+
+	if (!arrow_manifest_cache_htab)
+	{
+		HASHCTL		hctl;
+
+		memset(&hctl, 0, sizeof(HASHCTL));
+		hctl.keysize = MAXPGPATH;
+		hctl.entrysize = sizeof(arrowManifestCache);
+		hctl.hcxt = CacheMemoryContext;
+		arrow_manifest_cache_htab = hash_create("Arrow_Fdw Manifest Cache",
+												32, &hctl,
+												HASH_ELEM | HASH_STRINGS | HASH_CONTEXT);
+	}
+	mcache = hash_search(arrow_manifest_cache_htab, path, HASH_ENTER, &found);
+	if (found &&
+		(mcache->st_dev != st_buf.st_dev ||
+		 mcache->st_ino != st_buf.st_ino ||
+		 mcache->offset > st_buf.st_size))
+	{
+		/* manifest file was replaced or truncated */
+		MemoryContextDelete(mcache->memcxt);
+		found = false;
+	}
+	if (!found)
+	{
+		HASHCTL		hctl;
+
+		mcache->st_dev = st_buf.st_dev;
+		mcache->st_ino = st_buf.st_ino;
+		mcache->offset = 0;
+		mcache->memcxt = AllocSetContextCreate(CacheMemoryContext,
+											   "Arrow_Fdw Manifest",
+											   ALLOCSET_DEFAULT_SIZES);
+		memset(&hctl, 0, sizeof(HASHCTL));
+		hctl.keysize = MAXPGPATH;
+		hctl.entrysize = sizeof(arrowManifestEntry);
+		hctl.hcxt = mcache->memcxt;
+		mcache->htab = hash_create("Arrow_Fdw Manifest Entries",
+								   1024, &hctl,
+								   HASH_ELEM | HASH_STRINGS | HASH_CONTEXT);
+		mcache->ts_column = NULL;
+		mcache->bloom_keys = NIL;
+	}
+
+	if (st_buf.st_size > mcache->offset)
+	{
+		MemoryContext oldcxt;
+		size_t		length = st_buf.st_size - mcache->offset;
+		size_t		nbytes = 0;
+		char	   *buffer = palloc(length + 1);
+		char	   *line, *next;
+
+		while (nbytes < length)
 		{
-			if (strcmp(dentry->d_name, ".") == 0 ||
-				strcmp(dentry->d_name, "..") == 0)
-				continue;
-			if (dir_suffix)
+			ssize_t	nr = pread(fdesc, buffer + nbytes, length - nbytes,
+							   mcache->offset + nbytes);
+			if (nr < 0)
 			{
-				char   *pos = strrchr(dentry->d_name, '.');
-
-				if (!pos || strcmp(pos+1, dir_suffix) != 0)
+				if (errno == EINTR)
 					continue;
+				close(fdesc);
+				elog(ERROR, "failed on pread('%s'): %m", path);
 			}
-			temp = psprintf("%s/%s", dir_path, dentry->d_name);
-			if (access(temp, R_OK) != 0)
-			{
-				elog(DEBUG1, "arrow_fdw: unable to read '%s', so skipped", temp);
-				continue;
-			}
-			filesList = lappend(filesList, makeString(temp));
+			if (nr == 0)
+				break;
+			nbytes += nr;
 		}
-		FreeDir(dir);
+		buffer[nbytes] = '\0';
+
+		/* only the complete lines; writer may be appending the last one */
+		oldcxt = MemoryContextSwitchTo(mcache->memcxt);
+		for (line = buffer; (next = strchr(line, '\n')) != NULL; line = next+1)
+		{
+			*next = '\0';
+			if (*line == '#')
+				__arrowFdwManifestParseHeader(mcache, line);
+			else if (*line != '\0' &&
+					 !__arrowFdwManifestParseEntry(mcache, line))
+				elog(DEBUG1, "arrow_fdw: manifest '%s' has a broken line at %lu",
+					 path, mcache->offset + (line - buffer));
+		}
+		MemoryContextSwitchTo(oldcxt);
+		mcache->offset += (line - buffer);
+		pfree(buffer);
 	}
+	close(fdesc);
 
-	if (p_parallel_nworkers)
-		*p_parallel_nworkers = parallel_nworkers;
-	return filesList;
+	return mcache;
 }
 
-/* ----------------------------------------------------------------
- *
- * arrowFdwLoadRecordBatch() and related routines
- *
- * it setup KDS (ARROW format) with IOvec according to RecordBatchState
- *
- * ----------------------------------------------------------------
- */
-
 /*
- * arrowFdwSetupIOvector
+ * __arrowFdwManifestIsRefuted
+ *
+ * It checks whether the simple qualifiers (Var OP Const) are refuted by
+ * the time range or the bloom filter of the file in the manifest.
  */
-typedef struct
+static const char *
+__arrowFdwManifestColumnName(Node *node, TupleDesc tupdesc, Index relid)
 {
-	off_t		rb_offset;
-	off_t		f_offset;
-	off_t		m_offset;
-	off_t		kds_head_sz;
-	int32_t		depth;
-	int32_t		io_index;
-	strom_io_chunk ioc[FLEXIBLE_ARRAY_MEMBER];
-} arrowFdwSetupIOContext;
+	Var		   *var;
 
-static void
-__setupIOvectorField(arrowFdwSetupIOContext *con,
-					 uint32_t chunk_align,
-					 off_t    chunk_offset,
-					 size_t   chunk_length,
-					 uint32_t *p_cmeta_offset,
-					 uint32_t *p_cmeta_length)
+	while (node && IsA(node, RelabelType))
+		node = (Node *)((RelabelType *)node)->arg;
+	if (!node || !IsA(node, Var))
+		return NULL;
+	var = (Var *)node;
+	if (var->varno != relid ||
+		var->varlevelsup != 0 ||
+		var->varattno <= 0 ||
+		var->varattno > tupdesc->natts)
+		return NULL;
+	return NameStr(TupleDescAttr(tupdesc, var->varattno-1)->attname);
+}
+
+static int
+__arrowFdwManifestStrategy(Oid opno, Oid type_oid)
 {
-	off_t		f_pos = con->rb_offset + chunk_offset;
-	off_t		f_gap;
-	off_t		f_base;
-	off_t		m_offset;
-	strom_io_chunk *ioc;
+	Oid			opclass = GetDefaultOpClass(type_oid, BTREE_AM_OID);
 
-	/*
-	 * Round up chunk_length to 64bit boundary.
-	 * Apache Arrow does not require the chunk_length is aligned to 64bit boundary,
-	 * chunk_offset must be aligned to 64bit (512bit recommended).
-	 * So, some extra bytes (up to -7bytes) may improve the potency of i/o chunk
-	 * consolication.
-	 */
+	if (!OidIsValid(opclass))
+		return InvalidStrategy;
+	return get_op_opfamily_strategy(opno, get_opclass_family(opclass));
+}
 
-	if (f_pos >= con->f_offset &&
-		(f_pos & ~PAGE_MASK) == (con->f_offset & ~PAGE_MASK))
+static bool
+__arrowFdwManifestBloomRefuted(arrowManifestEntry *entry,
+							   const char *colname,
+							   Oid type_oid, Datum value)
+{
+	const void *data;
+	size_t		sz;
+	int64_t		ival;
+	uint64_t	hash;
+	ListCell   *lc;
+
+	foreach (lc, entry->bloom_keys)
 	{
-		/*
-		 * we can consolidate the two i/o chunks, if file position of the next
-		 * chunk (f_pos) and the current file tail position (con->f_offset) locate
-		 * within the same file page, and gap bytes does not break alignment.
-		 */
-		f_gap = f_pos - con->f_offset;
-		m_offset = con->m_offset + f_gap;
+		if (strcmp(colname, lfirst(lc)) == 0)
+			break;
+	}
+	if (!lc)
+		return false;
 
-		if (m_offset == TYPEALIGN(chunk_align, con->m_offset))
-		{
-			/* put the gap bytes, if any */
-			if (f_gap > 0)
+	switch (type_oid)
+	{
+		case INT2OID:
+			ival = DatumGetInt16(value);
+			data = &ival;
+			sz = sizeof(int64_t);
+			break;
+		case INT4OID:
+			ival = DatumGetInt32(value);
+			data = &ival;
+			sz = sizeof(int64_t);
+			break;
+		case INT8OID:
+			ival = DatumGetInt64(value);
+			data = &ival;
+			sz = sizeof(int64_t);
+			break;
+		case INETOID:
 			{
-				con->m_offset += f_gap;
-				con->f_offset += f_gap;
+				inet   *ip = DatumGetInetPP(value);
+
+				if (ip_family(ip) == PGSQL_AF_INET && ip_bits(ip) == 32)
+					sz = 4;
+				else if (ip_family(ip) == PGSQL_AF_INET6 && ip_bits(ip) == 128)
+					sz = 16;
+				else
+					return false;
+				data = ip_addr(ip);
 			}
-			*p_cmeta_offset = __kds_packed(con->kds_head_sz +
-										   con->m_offset);
-			*p_cmeta_length = __kds_packed(MAXALIGN(chunk_length));
-			con->m_offset += chunk_length;
-			con->f_offset += chunk_length;
-			return;
-		}
+			break;
+		default:
+			return false;
 	}
-	/*
-	 * Elsewhere, we have to close the current i/o chunk once, then
-	 * restart a new i/o chunk to load the disjoin chunks.
-	 */
-	if (con->io_index < 0)
-		con->io_index = 0;		/* no current active i/o chunk */
-	else
+	hash = arrowManifestHash(colname, data, sz);
+	for (int k=0; k < ARROW_MANIFEST_BLOOM_NHASHES; k++)
 	{
-		off_t	f_tail = PAGE_ALIGN(con->f_offset);
+		uint32_t	bit = arrowManifestBloomBit(hash, k, entry->bloom_bits);
 
-		ioc = &con->ioc[con->io_index++];
-		ioc->nr_pages = (f_tail / PAGE_SIZE) - ioc->fchunk_id;
-		con->m_offset += (f_tail - con->f_offset);	/* padding bytes */
+		if ((entry->bloom[bit >> 6] & (1UL << (bit & 63))) == 0)
+			return true;
 	}
-
-	f_base = PAGE_ALIGN_DOWN(f_pos);
-	f_gap = f_pos - f_base;
-	m_offset = TYPEALIGN(chunk_align, con->m_offset + f_gap);
-
-	ioc = &con->ioc[con->io_index];
-	ioc->m_offset = m_offset - f_gap;
-	ioc->fchunk_id = f_base / PAGE_SIZE;
-
-	*p_cmeta_offset = __kds_packed(con->kds_head_sz + m_offset);
-	*p_cmeta_length = __kds_packed(MAXALIGN(chunk_length));
-	con->m_offset = m_offset + chunk_length;
-	con->f_offset = f_pos + chunk_length;
+	return false;
 }
 
-static void
-arrowFdwSetupIOvectorField(arrowFdwSetupIOContext *con,
-						   RecordBatchFieldState *rb_field,
-						   kern_data_store *kds,
-						   kern_colmeta *cmeta)
+static bool
+__arrowFdwManifestOpExprRefuted(arrowManifestEntry *entry, OpExpr *op,
+								TupleDesc tupdesc, Index relid)
 {
-	//int		index = cmeta - kds->colmeta;
+	const char *colname;
+	Const	   *con;
+	int			strategy;
+	bool		commuted = false;
+	Timestamp	tval;
 
-	if (rb_field->nullmap_length > 0)
+	if (list_length(op->args) != 2)
+		return false;
+	colname = __arrowFdwManifestColumnName(linitial(op->args), tupdesc, relid);
+	con = lsecond(op->args);
+	if (!colname)
 	{
-		Assert(rb_field->null_count > 0);
-		__setupIOvectorField(con,
-							 sizeof(int64_t),	/* 64bit alignment */
-							 rb_field->nullmap_offset,
-							 rb_field->nullmap_length,
-							 &cmeta->nullmap_offset,
-							 &cmeta->nullmap_length);
-		//elog(INFO, "D%d att[%d] nullmap=%lu,%lu m_offset=%lu f_offset=%lu", con->depth, index, rb_field->nullmap_offset, rb_field->nullmap_length, con->m_offset, con->f_offset);
+		colname = __arrowFdwManifestColumnName(lsecond(op->args), tupdesc, relid);
+		con = linitial(op->args);
+		commuted = true;
 	}
-	if (rb_field->values_length > 0)
+	if (!colname || !IsA(con, Const) || con->constisnull)
+		return false;
+	strategy = __arrowFdwManifestStrategy(op->opno, con->consttype);
+	if (strategy == InvalidStrategy)
+		return false;
+	if (strategy == BTEqualStrategyNumber &&
+		__arrowFdwManifestBloomRefuted(entry, colname,
+									   con->consttype,
+									   con->constvalue))
+		return true;
+
+	/* time range of the file */
+	if (!entry->ts_column ||
+		strcmp(colname, entry->ts_column) != 0 ||
+		(con->consttype != TIMESTAMPOID &&
+		 con->consttype != TIMESTAMPTZOID) ||
+		exprType(commuted ? lsecond(op->args) : linitial(op->args)) != con->consttype)
+		return false;
+	tval = DatumGetTimestamp(con->constvalue);
+	if (commuted)
 	{
-		__setupIOvectorField(con,
-							 rb_field->attopts.align,
-							 rb_field->values_offset,
-							 rb_field->values_length,
-							 &cmeta->values_offset,
-							 &cmeta->values_length);
-		//elog(INFO, "D%d att[%d] values=%lu,%lu m_offset=%lu f_offset=%lu", con->depth, index, rb_field->values_offset, rb_field->values_length, con->m_offset, con->f_offset);
+		if (strategy == BTLessStrategyNumber)
+			strategy = BTGreaterStrategyNumber;
+		else if (strategy == BTLessEqualStrategyNumber)
+			strategy = BTGreaterEqualStrategyNumber;
+		else if (strategy == BTGreaterStrategyNumber)
+			strategy = BTLessStrategyNumber;
+		else if (strategy == BTGreaterEqualStrategyNumber)
+			strategy = BTLessEqualStrategyNumber;
 	}
-	if (rb_field->extra_length > 0)
+	switch (strategy)
 	{
-		__setupIOvectorField(con,
-							 sizeof(int64_t),	/* 64bit alignment */
-							 rb_field->extra_offset,
-							 rb_field->extra_length,
-							 &cmeta->extra_offset,
-							 &cmeta->extra_length);
-		//elog(INFO, "D%d att[%d] extra=%lu,%lu m_offset=%lu f_offset=%lu", con->depth, index, rb_field->extra_offset, rb_field->extra_length, con->m_offset, con->f_offset);
+		case BTLessStrategyNumber:
+			return (entry->ts_min >= tval);
+		case BTLessEqualStrategyNumber:
+			return (entry->ts_min > tval);
+		case BTEqualStrategyNumber:
+			return (entry->ts_min > tval || entry->ts_max < tval);
+		case BTGreaterEqualStrategyNumber:
+			return (entry->ts_max < tval);
+		case BTGreaterStrategyNumber:
+			return (entry->ts_max <= tval);
+		default:
+			break;
 	}
+	return false;
+}
 
-	/* nested sub-fields if composite types */
-	if (cmeta->atttypkind == TYPE_KIND__ARRAY ||
-		cmeta->atttypkind == TYPE_KIND__COMPOSITE)
+static bool
+__arrowFdwManifestSAOPRefuted(arrowManifestEntry *entry, ScalarArrayOpExpr *saop,
+							  TupleDesc tupdesc, Index relid)
+{
+	const char *colname;
+	Const	   *con;
+	ArrayType  *arr;
+	Oid			elemtype;
+	int16		typlen;
+	bool		typbyval;
+	char		typalign;
+	Datum	   *elems;
+	bool	   *nulls;
+	int			nitems;
+
+	/* only 'col IN (...)' */
+	if (!saop->useOr || list_length(saop->args) != 2)
+		return false;
+	colname = __arrowFdwManifestColumnName(linitial(saop->args), tupdesc, relid);
+	con = lsecond(saop->args);
+	if (!colname || !IsA(con, Const) || con->constisnull)
+		return false;
+	arr = DatumGetArrayTypeP(con->constvalue);
+	elemtype = ARR_ELEMTYPE(arr);
+	if (__arrowFdwManifestStrategy(saop->opno, elemtype) != BTEqualStrategyNumber)
+		return false;
+	get_typlenbyvalalign(elemtype, &typlen, &typbyval, &typalign);
+	deconstruct_array(arr, elemtype, typlen, typbyval, typalign,
+					  &elems, &nulls, &nitems);
+	for (int i=0; i < nitems; i++)
 	{
-		kern_colmeta *subattr;
-		int		j;
+		if (!nulls[i] &&
+			!__arrowFdwManifestBloomRefuted(entry, colname,
+											elemtype, elems[i]))
+			return false;
+	}
+	return true;
+}
 
-		Assert(rb_field->num_children == cmeta->num_subattrs);
-		con->depth++;
-		for (j=0, subattr = &kds->colmeta[cmeta->idx_subattrs];
-			 j < cmeta->num_subattrs;
-			 j++, subattr++)
-		{
-			RecordBatchFieldState *child = &rb_field->children[j];
-
-			arrowFdwSetupIOvectorField(con, child, kds, subattr);
-		}
-		con->depth--;
-	}
-}
-
-static strom_io_vector *
-arrowFdwSetupIOvector(RecordBatchState *rb_state,
-					  Bitmapset *referenced,
-					  kern_data_store *kds)
+static bool
+__arrowFdwManifestIsRefuted(arrowManifestCache *mcache,
+							Relation frel, const char *filename,
+							List *quals, Index relid)
 {
-	arrowFdwSetupIOContext *con;
-	strom_io_vector *iovec;
-	unsigned int	nr_chunks = 0;
+	TupleDesc	tupdesc = RelationGetDescr(frel);
+	arrowManifestEntry *entry;
+	char		key[MAXPGPATH];
+	ListCell   *lc;
 
-	Assert(kds->format == KDS_FORMAT_ARROW &&
-		   kds->ncols <= kds->nr_colmeta &&
-		   kds->ncols == rb_state->nfields);
-	con = alloca(offsetof(arrowFdwSetupIOContext,
-						  ioc[3 * kds->nr_colmeta]));
-	con->rb_offset = rb_state->rb_offset;
-	con->f_offset  = ~0UL;	/* invalid offset */
-	con->m_offset  = 0;
-	con->kds_head_sz = KDS_HEAD_LENGTH(kds);
-	con->depth = 0;
-	con->io_index = -1;		/* invalid index */
-	for (int j=0; j < kds->ncols; j++)
-	{
-		RecordBatchFieldState *rb_field = &rb_state->fields[j];
-		kern_colmeta *cmeta = &kds->colmeta[j];
-		int			attidx = j + 1 - FirstLowInvalidHeapAttributeNumber;
+	if (quals == NIL || strlen(filename) >= MAXPGPATH)
+		return false;
+	strncpy(key, filename, MAXPGPATH);
+	entry = hash_search(mcache->htab, key, HASH_FIND, NULL);
+	if (!entry)
+		return false;	/* may be under writing */
 
-		if (bms_is_member(attidx, referenced) ||
-			bms_is_member(-FirstLowInvalidHeapAttributeNumber, referenced))
-			arrowFdwSetupIOvectorField(con, rb_field, kds, cmeta);
-		else
-			cmeta->atttypkind = TYPE_KIND__NULL;	/* unreferenced */
-	}
-	if (con->io_index >= 0)
+	foreach (lc, quals)
 	{
-		/* close the last I/O chunks */
-		strom_io_chunk *ioc = &con->ioc[con->io_index++];
-
-		ioc->nr_pages = (PAGE_ALIGN(con->f_offset) / PAGE_SIZE - ioc->fchunk_id);
-		con->m_offset += PAGE_SIZE * ioc->nr_pages;
-		nr_chunks = con->io_index;
-	}
-	kds->length = con->kds_head_sz + con->m_offset;
+		Node	   *clause = lfirst(lc);
 
-	iovec = palloc0(offsetof(strom_io_vector, ioc[nr_chunks]));
-	iovec->nr_chunks = nr_chunks;
-	if (iovec->nr_chunks > 0)
-		memcpy(iovec->ioc, con->ioc, sizeof(strom_io_chunk) * con->io_index);
-#if 0
-	/* for debug - dump the i/o vector */
-	{
-		elog(INFO, "nchunks = %d", iovec->nr_chunks);
-		for (int j=0; j < iovec->nr_chunks; j++)
+		if (IsA(clause, RestrictInfo))
+			clause = (Node *)((RestrictInfo *)clause)->clause;
+		if (IsA(clause, OpExpr))
 		{
-			strom_io_chunk *ioc = &iovec->ioc[j];
-
-			elog(INFO, "io[%d] [ m_offset=%lu, f_read=%lu...%lu, nr_pages=%u}",
-				 j,
-				 ioc->m_offset,
-				 ioc->fchunk_id * PAGE_SIZE,
-				 (ioc->fchunk_id + ioc->nr_pages) * PAGE_SIZE,
-				 ioc->nr_pages);
+			if (__arrowFdwManifestOpExprRefuted(entry, (OpExpr *)clause,
+												tupdesc, relid))
+				return true;
 		}
-
-		elog(INFO, "kds {length=%zu nitems=%u typeid=%u typmod=%u table_oid=%u}",
-			 kds->length, kds->nitems,
-			 kds->tdtypeid, kds->tdtypmod, kds->table_oid);
-		for (int j=0; j < kds->nr_colmeta; j++)
+		else if (IsA(clause, ScalarArrayOpExpr))
 		{
-			kern_colmeta *cmeta = &kds->colmeta[j];
-
-			elog(INFO, "%ccol[%d] nullmap=%lu,%lu values=%lu,%lu extra=%lu,%lu",
-				 j < kds->ncols ? ' ' : '*', j,
-				 __kds_unpack(cmeta->nullmap_offset),
-				 __kds_unpack(cmeta->nullmap_length),
-				 __kds_unpack(cmeta->values_offset),
-				 __kds_unpack(cmeta->values_length),
-				 __kds_unpack(cmeta->extra_offset),
-				 __kds_unpack(cmeta->extra_length));
+			if (__arrowFdwManifestSAOPRefuted(entry, (ScalarArrayOpExpr *)clause,
+											  tupdesc, relid))
+				return true;
 		}
 	}
-#endif
-	return iovec;
+	return false;
 }
 
 /*
- * arrowFdwLoadRecordBatch
+ * __arrowFdwAssignPartitionKeys
+ *
+ * It extends the RecordBatchStates according to the foreign-table definition,
+ * then assigns the partition keys as constant fields.
  */
 static void
-__arrowKdsAssignAttrOptions(kern_data_store *kds,
-							kern_colmeta *cmeta,
-							RecordBatchFieldState *rb_field)
+__arrowFdwSetupPartitionField(RecordBatchFieldState *rb_field,
+							  Form_pg_attribute attr,
+							  arrowPartitionKey *pkey,
+							  const char *filename)
 {
-	memcpy(&cmeta->attopts,
-		   &rb_field->attopts, sizeof(ArrowTypeOptions));
-	if (cmeta->atttypkind == TYPE_KIND__ARRAY)
+	ArrowField	field;
+	ArrowType  *t = &field.type;
+	Oid			type_oid;
+	int32_t		type_mod;
+
+	initArrowNode(&field, Field);
+	field.name = NameStr(attr->attname);
+	field._name_len = strlen(field.name);
+	field.nullable = true;
+	switch (attr->atttypid)
 	{
-		Assert(cmeta->idx_subattrs >= kds->ncols &&
-			   cmeta->num_subattrs == 1 &&
-			   cmeta->idx_subattrs + cmeta->num_subattrs <= kds->nr_colmeta &&
-			   rb_field->num_children == 1);
-		__arrowKdsAssignAttrOptions(kds,
-									&kds->colmeta[cmeta->idx_subattrs],
-									&rb_field->children[0]);
+		case INT2OID:
+		case INT4OID:
+		case INT8OID:
+			initArrowNode(&t->Int, Int);
+			t->Int.is_signed = true;
+			t->Int.bitWidth = (attr->atttypid == INT2OID ? 16 :
+							   attr->atttypid == INT4OID ? 32 : 64);
+			break;
+		case FLOAT4OID:
+		case FLOAT8OID:
+			initArrowNode(&t->FloatingPoint, FloatingPoint);
+			t->FloatingPoint.precision = (attr->atttypid == FLOAT4OID
+										  ? ArrowPrecision__Single
+										  : ArrowPrecision__Double);
+			break;
+		case DATEOID:
+			initArrowNode(&t->Date, Date);
+			t->Date.unit = ArrowDateUnit__Day;
+			break;
+		case TEXTOID:
+			initArrowNode(&t->Utf8, Utf8);
+			break;
+		default:
+			elog(ERROR, "arrow_fdw: partition key '%s' has unsupported type (%s) at '%s'",
+				 NameStr(attr->attname),
+				 format_type_be(attr->atttypid),
+				 filename);
 	}
-	else if (cmeta->atttypkind == TYPE_KIND__COMPOSITE)
+	memset(rb_field, 0, sizeof(RecordBatchFieldState));
+	__arrowFieldTypeToPGType(&field, &type_oid, &type_mod, &rb_field->attopts);
+	Assert(type_oid == attr->atttypid);
+	rb_field->atttypid = attr->atttypid;
+	rb_field->atttypmod = attr->atttypmod;
+	rb_field->part_key = true;
+	if (pkey->value)
 	{
-		Assert(cmeta->idx_subattrs >= kds->ncols &&
-			   cmeta->num_subattrs == rb_field->num_children &&
-			   cmeta->idx_subattrs + cmeta->num_subattrs <= kds->nr_colmeta);
-		for (int j=0; j < cmeta->num_subattrs; j++)
-		{
-			__arrowKdsAssignAttrOptions(kds,
-										&kds->colmeta[cmeta->idx_subattrs + j],
-										&rb_field->children[j]);
-		}
+		Datum	datum = __arrowFdwPartitionKeyDatum(attr, pkey->value);
+
+		rb_field->stat_datum.isnull = false;
+		rb_field->stat_datum.min.datum = datum;
+		rb_field->stat_datum.max.datum = datum;
+	}
+	else
+	{
+		rb_field->stat_datum.isnull = true;
 	}
 }
 
-static strom_io_vector *
-arrowFdwLoadRecordBatch(Relation relation,
-						Bitmapset *referenced,
-						RecordBatchState *rb_state,
-						StringInfo chunk_buffer)
+static void
+__arrowFdwAssignPartitionKeys(Relation frel,
+							  ArrowFileState *af_state,
+							  Bitmapset **p_stat_attrs)
 {
-	TupleDesc	tupdesc = RelationGetDescr(relation);
-	size_t		head_sz = estimate_kern_data_store(tupdesc);
-	kern_data_store *kds;
-
-	/* setup KDS and I/O-vector */
-	enlargeStringInfo(chunk_buffer, head_sz);
-	kds = (kern_data_store *)(chunk_buffer->data +
-							  chunk_buffer->len);
-	setup_kern_data_store(kds, tupdesc, 0, KDS_FORMAT_ARROW);
-	kds->nitems = rb_state->rb_nitems;
-	kds->table_oid = RelationGetRelid(relation);
-	Assert(kds->ncols == rb_state->nfields);
-	for (int j=0; j < kds->ncols; j++)
-		__arrowKdsAssignAttrOptions(kds,
-									&kds->colmeta[j],
-									&rb_state->fields[j]);
-	chunk_buffer->len += head_sz;
+	TupleDesc	tupdesc = RelationGetDescr(frel);
+	List	   *partition_keys;
+	RecordBatchFieldState *part_fields;
+	bool		has_partition_keys = false;
+	ListCell   *lc;
 
-	return arrowFdwSetupIOvector(rb_state, referenced, kds);
-}
+	partition_keys = __arrowFdwParsePartitionKeys(af_state->filename);
+	if (partition_keys == NIL)
+		return;
+	part_fields = palloc0(sizeof(RecordBatchFieldState) * tupdesc->natts);
+	for (int j=0; j < tupdesc->natts; j++)
+	{
+		Form_pg_attribute attr = TupleDescAttr(tupdesc, j);
+		arrowPartitionKey *pkey;
 
-static kern_data_store *
-arrowFdwFillupRecordBatch(Relation relation,
-						  Bitmapset *referenced,
-						  RecordBatchState *rb_state,
-						  StringInfo chunk_buffer)
-{
-	ArrowFileState	*af_state = rb_state->af_state;
-	kern_data_store	*kds;
-	strom_io_vector	*iovec;
-	char	   *base;
-	File		filp;
+		pkey = __arrowFdwLookupPartitionKey(partition_keys, attr);
+		if (!pkey)
+			continue;
+		__arrowFdwSetupPartitionField(&part_fields[j], attr, pkey,
+									  af_state->filename);
+		/* min/max statistics allows to skip record-batches at run-time */
+		if (p_stat_attrs)
+			*p_stat_attrs = bms_add_member(*p_stat_attrs, attr->attnum);
+		has_partition_keys = true;
+	}
+	if (!has_partition_keys)
+		return;
 
-	resetStringInfo(chunk_buffer);
-	iovec = arrowFdwLoadRecordBatch(relation,
-									referenced,
-									rb_state,
-									chunk_buffer);
-	kds = (kern_data_store *)chunk_buffer->data;
-	enlargeStringInfo(chunk_buffer, kds->length);
-	kds = (kern_data_store *)chunk_buffer->data;
-	filp = PathNameOpenFile(af_state->filename, O_RDONLY | PG_BINARY);
-	base = (char *)kds + KDS_HEAD_LENGTH(kds);
-	for (int i=0; i < iovec->nr_chunks; i++)
+	foreach (lc, af_state->rb_list)
 	{
-		strom_io_chunk *ioc = &iovec->ioc[i];
-		char	   *dest = base + ioc->m_offset;
-		off_t		f_pos = (size_t)ioc->fchunk_id * PAGE_SIZE;
-		size_t		len = (size_t)ioc->nr_pages * PAGE_SIZE;
-		ssize_t		sz;
+		RecordBatchState *rb_state = lfirst(lc);
+		RecordBatchState *rb_temp;
+		int			k = 0;
 
-		while (len > 0)
+		rb_temp = palloc0(offsetof(RecordBatchState, fields[tupdesc->natts]));
+		memcpy(rb_temp, rb_state, offsetof(RecordBatchState, fields));
+		rb_temp->nfields = tupdesc->natts;
+		for (int j=0; j < tupdesc->natts; j++)
 		{
-			CHECK_FOR_INTERRUPTS();
+			RecordBatchFieldState *rb_field = &rb_temp->fields[j];
 
-			sz = FileRead(filp, dest, len, f_pos,
-						  WAIT_EVENT_REORDER_BUFFER_READ);
-			if (sz > 0)
-			{
-				Assert(sz <= len);
-				dest  += sz;
-				f_pos += sz;
-				len   -= sz;
-			}
-			else if (sz == 0)
+			if (part_fields[j].part_key)
 			{
-				/*
-				 * Due to the page_sz alignment, we may try to read the file
-				 * over its tail. So, pread(2) may tell us unable to read
-				 * any more. The expected scenario happend only when remained
-				 * length is less than PAGE_SIZE.
-				 */
-				memset(dest, 0, len);
-				break;
+				memcpy(rb_field, &part_fields[j],
+					   sizeof(RecordBatchFieldState));
+				rb_field->nitems = rb_state->rb_nitems;
+				rb_field->null_count = (rb_field->stat_datum.isnull
+										? rb_state->rb_nitems : 0);
 			}
-			else if (errno != EINTR)
+			else
 			{
-				assert(false);
-				elog(ERROR, "failed on FileRead('%s', pos=%lu, len=%lu): %m",
-					 af_state->filename, f_pos, len);
+				if (k >= rb_state->nfields)
+					elog(ERROR, "arrow_fdw: foreign table '%s' is not compatible to '%s'",
+						 RelationGetRelationName(frel), af_state->filename);
+				memcpy(rb_field, &rb_state->fields[k++],
+					   sizeof(RecordBatchFieldState));
 			}
 		}
+		if (k != rb_state->nfields)
+			elog(ERROR, "arrow_fdw: foreign table '%s' is not compatible to '%s'",
+				 RelationGetRelationName(frel), af_state->filename);
+		lfirst(lc) = rb_temp;
+		pfree(rb_state);
 	}
-	chunk_buffer->len += kds->length;
-	FileClose(filp);
-
-	pfree(iovec);
-
-	return kds;
-}
-
-/*
- * ArrowGetForeignRelSize
- */
-static size_t
-__recordBatchFieldLength(RecordBatchFieldState *rb_field)
-{
-	size_t		len = 0;
-
-	if (rb_field->null_count > 0)
-		len += rb_field->nullmap_length;
-	len += (rb_field->values_length +
-			rb_field->extra_length);
-	for (int j=0; j < rb_field->num_children; j++)
-		len += __recordBatchFieldLength(&rb_field->children[j]);
-	return len;
 }
 
-static void
-ArrowGetForeignRelSize(PlannerInfo *root,
-					   RelOptInfo *baserel,
-					   Oid foreigntableid)
+static ArrowFileState *
+BuildArrowFileState(Relation frel, const char *filename,
+					bool hive_partitioning, Bitmapset **p_stat_attrs)
 {
-	ForeignTable   *ft = GetForeignTable(foreigntableid);
-	Relation		frel = table_open(foreigntableid, NoLock);
-	List		   *filesList;
-	List		   *results = NIL;
-	Bitmapset	   *referenced = NULL;
-	ListCell	   *lc1, *lc2;
-	size_t			totalLen = 0;
-	double			ntuples = 0.0;
-	int				parallel_nworkers;
+	arrowMetadataCache *mcache;
+	ArrowFileState *af_state;
+	RecordBatchState *rb_state;
+	struct stat		stat_buf;
+	TupleDesc		tupdesc;
+	bool			reload_zonemap = false;
 
-	/* columns to be referenced */
-	foreach (lc1, baserel->baserestrictinfo)
+	if (stat(filename, &stat_buf) != 0)
 	{
-		RestrictInfo   *rinfo = lfirst(lc1);
-
-		pull_varattnos((Node *)rinfo->clause, baserel->relid, &referenced);
+		/* spool segment of the stream may be removed concurrently */
+		if (errno == ENOENT)
+			return NULL;
+		elog(ERROR, "failed on stat('%s'): %m", filename);
 	}
-	referenced = pickup_outer_referenced(root, baserel, referenced);
-
-	/* read arrow-file metadta */
-	filesList = arrowFdwExtractFilesList(ft->options, &parallel_nworkers);
-	foreach (lc1, filesList)
+	if (__arrowFileIsParquet(filename))
 	{
-		ArrowFileState *af_state;
-		char	   *fname = strVal(lfirst(lc1));
-
-		af_state = BuildArrowFileState(frel, fname, NULL);
+		af_state = __buildArrowFileStateByParquet(filename, p_stat_attrs);
 		if (!af_state)
-			continue;
+			return NULL;
+		goto compatibility_checks;
+	}
+	if (__arrowFileIsShmem(filename))
+	{
+		/* shared memory segment grows without mtime updates, never cached */
+		af_state = __buildArrowFileStateByShmem(filename, p_stat_attrs);
+		if (!af_state)
+			return NULL;
+		goto compatibility_checks;
+	}
+	LWLockAcquire(&arrow_metadata_cache->mutex, LW_SHARED);
+	mcache = lookupArrowMetadataCache(&stat_buf, false);
+	if (mcache)
+	{
+		/* found a valid metadata-cache */
+		af_state = __buildArrowFileStateByCache(filename, mcache,
+												p_stat_attrs);
+		rb_state = linitial(af_state->rb_list);
+		reload_zonemap = (p_stat_attrs != NULL && rb_state->zone_nrows > 0);
+	}
+	else
+	{
+		LWLockRelease(&arrow_metadata_cache->mutex);
 
-		/*
-		 * Size calculation based the record-batch metadata
-		 */
-		foreach (lc2, af_state->rb_list)
+		/* here is no valid metadata-cache, so try the one on the disk */
+		af_state = __buildArrowFileStateByDiskCache(filename, &stat_buf,
+													p_stat_attrs);
+		if (af_state)
 		{
-			RecordBatchState *rb_state = lfirst(lc2);
-
-			/* whole-row reference? */
-			if (bms_is_member(-FirstLowInvalidHeapAttributeNumber, referenced))
-			{
-				totalLen += rb_state->rb_length;
-			}
-			else
-			{
-				int		j, k;
-
-				for (k = bms_next_member(referenced, -1);
-					 k >= 0;
-					 k = bms_next_member(referenced, k))
-				{
-					j = k + FirstLowInvalidHeapAttributeNumber;
-					if (j <= 0 || j > rb_state->nfields)
-						continue;
-					totalLen += __recordBatchFieldLength(&rb_state->fields[j-1]);
-				}
-			}
-			ntuples += rb_state->rb_nitems;
+			rb_state = linitial(af_state->rb_list);
+			reload_zonemap = (p_stat_attrs != NULL && rb_state->zone_nrows > 0);
+		}
+		else
+		{
+			/* elsewhere, build it from the raw file */
+			af_state = __buildArrowFileStateByFile(filename, p_stat_attrs);
+			if (!af_state)
+				return NULL;	/* file not found? */
+			__writeArrowMetadataDiskCache(af_state);
 		}
-		results = lappend(results, af_state);
-	}
-	table_close(frel, NoLock);
-
-	/* setup baserel */
-	baserel->rel_parallel_workers = parallel_nworkers;
-	baserel->fdw_private = list_make2(results, referenced);
-	baserel->pages = totalLen / BLCKSZ;
-	baserel->tuples = ntuples;
-	baserel->rows = ntuples *
-		clauselist_selectivity(root,
-							   baserel->baserestrictinfo,
-							   0,
-							   JOIN_INNER,
-							   NULL);
-}
-
-/*
- * cost_arrow_fdw_seqscan
- */
-static void
-cost_arrow_fdw_seqscan(Path *path,
-					   PlannerInfo *root,
-					   RelOptInfo *baserel,
-					   ParamPathInfo *param_info,
-					   int num_workers)
-{
-	Cost		startup_cost = 0.0;
-	Cost		disk_run_cost = 0.0;
-	Cost		cpu_run_cost = 0.0;
-	QualCost	qcost;
-	double		nrows;
-	double		spc_seq_page_cost;
-
-	if (param_info)
-		nrows = param_info->ppi_rows;
-	else
-		nrows = baserel->rows;
 
-	/* arrow_fdw.enabled */
-	if (!arrow_fdw_enabled)
-		startup_cost += disable_cost;
+		LWLockAcquire(&arrow_metadata_cache->mutex, LW_EXCLUSIVE);
+		mcache = lookupArrowMetadataCache(&af_state->stat_buf, true);
+		if (!mcache)
+			__buildArrowMetadataCacheNoLock(af_state);
+	}
+	LWLockRelease(&arrow_metadata_cache->mutex);
 
 	/*
-	 * Storage costs
-	 *
-	 * XXX - smaller number of columns to read shall have less disk cost
-	 * because of columnar format. Right now, we don't discount cost for
-	 * the pages not to be read.
+	 * zone-map is too large to keep on the shared metadata-cache, so we
+	 * read the file footer again if the record-batches have zone-map.
 	 */
-	get_tablespace_page_costs(baserel->reltablespace,
-							  NULL,
-							  &spc_seq_page_cost);
-	disk_run_cost = spc_seq_page_cost * baserel->pages;
-
-	/* CPU costs */
-	if (param_info)
+	if (reload_zonemap)
 	{
-		cost_qual_eval(&qcost, param_info->ppi_clauses, root);
-		qcost.startup += baserel->baserestrictcost.startup;
-        qcost.per_tuple += baserel->baserestrictcost.per_tuple;
-	}
-	else
-		qcost = baserel->baserestrictcost;
-	startup_cost += qcost.startup;
-	cpu_run_cost = (cpu_tuple_cost + qcost.per_tuple) * baserel->tuples;
+		ArrowFileInfo af_info;
 
-	/* tlist evaluation costs */
-	startup_cost += path->pathtarget->cost.startup;
-	cpu_run_cost += path->pathtarget->cost.per_tuple * path->rows;
+		if (readArrowFile(filename, &af_info, true))
+			applyArrowZoneMaps(&af_info.footer, af_state->rb_list);
+	}
 
-	/* adjust cost for CPU parallelism */
-	if (num_workers > 0)
+compatibility_checks:
+	rb_state = linitial(af_state->rb_list);
+	tupdesc = RelationGetDescr(frel);
+	if (hive_partitioning && tupdesc->natts > rb_state->nfields)
 	{
-		double		leader_contribution;
-		double		parallel_divisor = (double) num_workers;
-
-		/* see get_parallel_divisor() */
-		leader_contribution = 1.0 - (0.3 * (double)num_workers);
-		parallel_divisor += Max(leader_contribution, 0.0);
-
-		/* The CPU cost is divided among all the workers. */
-		cpu_run_cost /= parallel_divisor;
+		/* partition keys are not a part of the arrow file */
+		__arrowFdwAssignPartitionKeys(frel, af_state, p_stat_attrs);
+		rb_state = linitial(af_state->rb_list);
+	}
+	if (tupdesc->natts != rb_state->nfields)
+		elog(ERROR, "arrow_fdw: foreign table '%s' is not compatible to '%s'",
+			 RelationGetRelationName(frel), filename);
+	for (int j=0; j < tupdesc->natts; j++)
+	{
+		Form_pg_attribute	attr = TupleDescAttr(tupdesc, j);
+		RecordBatchFieldState *rb_field = &rb_state->fields[j];
 
-		/* Estimated row count per background worker process */
-		nrows = clamp_row_est(nrows / parallel_divisor);
+		if (attr->atttypid != rb_field->atttypid)
+			elog(ERROR, "arrow_fdw: foreign table '%s' column '%s' (%s) is not compatible to the arrow field (%s) in the '%s'",
+				 RelationGetRelationName(frel),
+				 NameStr(attr->attname),
+				 format_type_be(attr->atttypid),
+				 format_type_be(rb_field->atttypid),
+				 filename);
 	}
-	path->rows = nrows;
-	path->startup_cost = startup_cost;
-	path->total_cost = startup_cost + cpu_run_cost + disk_run_cost;
-	path->parallel_workers = num_workers;
+	return af_state;
 }
 
 /*
- * ArrowGetForeignPaths
+ * baseRelIsArrowFdw
  */
-static void
-ArrowGetForeignPaths(PlannerInfo *root,
-                     RelOptInfo *baserel,
-                     Oid foreigntableid)
+bool
+baseRelIsArrowFdw(RelOptInfo *baserel)
 {
-	ForeignPath	   *fpath;
-	ParamPathInfo  *param_info;
-	Relids			required_outer = baserel->lateral_relids;
+	if ((baserel->reloptkind == RELOPT_BASEREL ||
+		 baserel->reloptkind == RELOPT_OTHER_MEMBER_REL) &&
+		baserel->rtekind == RTE_RELATION &&
+		OidIsValid(baserel->serverid) &&
+		baserel->fdwroutine &&
+		memcmp(baserel->fdwroutine,
+			   &pgstrom_arrow_fdw_routine,
+			   sizeof(FdwRoutine)) == 0)
+		return true;
 
-	param_info = get_baserel_parampathinfo(root, baserel, required_outer);
-	fpath = create_foreignscan_path(root,
-									baserel,
-									NULL,	/* default pathtarget */
-									-1.0,	/* dummy */
-									-1.0,	/* dummy */
-									-1.0,	/* dummy */
-									NIL,	/* no pathkeys */
-									required_outer,
-									NULL,	/* no extra plan */
-									NIL);	/* no particular private */
-	cost_arrow_fdw_seqscan(&fpath->path,
-						   root,
-						   baserel,
-						   param_info, 0);
-	add_path(baserel, &fpath->path);
+	return false;
+}
 
-	if (baserel->consider_parallel)
+/*
+ * RelationIsArrowFdw
+ */
+bool
+RelationIsArrowFdw(Relation frel)
+{
+	if (RelationGetForm(frel)->relkind == RELKIND_FOREIGN_TABLE)
 	{
-		int		num_workers =
-			compute_parallel_worker(baserel,
-									baserel->pages, -1.0,
-									max_parallel_workers_per_gather);
-		if (num_workers == 0)
-			return;
+		FdwRoutine *routine = GetFdwRoutineForRelation(frel, false);
 
-		fpath = create_foreignscan_path(root,
-										baserel,
-										NULL,	/* default pathtarget */
-										-1.0,	/* dummy */
-										-1.0,	/* dummy */
-										-1.0,	/* dummy */
-										NIL,	/* no pathkeys */
-										required_outer,
-										NULL,	/* no extra plan */
-										NIL);	/* no particular private */
-		fpath->path.parallel_aware = true;
-		cost_arrow_fdw_seqscan(&fpath->path,
-							   root,
-							   baserel,
-							   param_info,
-							   num_workers);
-		add_partial_path(baserel, (Path *)fpath);
+		if (memcmp(routine, &pgstrom_arrow_fdw_routine, sizeof(FdwRoutine)) == 0)
+			return true;
 	}
+	return false;
 }
 
 /*
- * ArrowGetForeignPlan
+ * GetOptimalGpusForArrowFdw
  */
-static ForeignScan *
-ArrowGetForeignPlan(PlannerInfo *root,
-					RelOptInfo *baserel,
-					Oid foreigntableid,
-					ForeignPath *best_path,
-					List *tlist,
-					List *scan_clauses,
-					Plan *outer_plan)
+const Bitmapset *
+GetOptimalGpusForArrowFdw(PlannerInfo *root, RelOptInfo *baserel)
 {
-	Bitmapset  *referenced = lsecond(baserel->fdw_private);
-	List	   *ref_list = NIL;
-	int			k;
+	List	   *priv_list = (List *)baserel->fdw_private;
+	Bitmapset  *optimal_gpus = NULL;
 
-	for (k = bms_next_member(referenced, -1);
-		 k >= 0;
-		 k = bms_next_member(referenced, k))
+	if (baseRelIsArrowFdw(baserel) &&
+		IsA(priv_list, List) && list_length(priv_list) == 2)
 	{
-		ref_list = lappend_int(ref_list, k);
-	}
-	return make_foreignscan(tlist,
-							extract_actual_clauses(scan_clauses, false),
-							baserel->relid,
-							NIL,	/* no expressions to evaluate */
-							ref_list, /* list of referenced attnums */
-							NIL,	/* no custom tlist */
-							NIL,	/* no remote quals */
-							outer_plan);
+		List	   *af_list = linitial(priv_list);
+		ListCell   *lc;
+
+		foreach (lc, af_list)
+		{
+			ArrowFileState *af_state = lfirst(lc);
+			const Bitmapset *__optimal_gpus;
+
+			__optimal_gpus = GetOptimalGpuForFile(af_state->filename);
+			if (lc == list_head(af_list))
+				optimal_gpus = bms_copy(__optimal_gpus);
+			else
+				optimal_gpus = bms_intersect(optimal_gpus, __optimal_gpus);
+		}
+	}
+	return optimal_gpus;
 }
 
-/* ----------------------------------------------------------------
- *
- * Routines related to Arrow datum fetch
- *
- * ----------------------------------------------------------------
+/*
+ * GetOptimalDpuForArrowFdw
  */
-static void		pg_datum_arrow_ref(kern_data_store *kds,
-								   kern_colmeta *cmeta,
-								   size_t index,
-								   Datum *p_datum,
-								   bool *p_isnull);
-static Datum
-pg_varlena32_arrow_ref(kern_data_store *kds,
-					   kern_colmeta *cmeta,
-					   size_t index, bool *p_isnull)
+const DpuStorageEntry *
+GetOptimalDpuForArrowFdw(PlannerInfo *root, RelOptInfo *baserel)
 {
-	struct varlena *res = NULL;
-	const void *addr;
-	int			length;
+	const DpuStorageEntry *ds_entry = NULL;
+	List	   *priv_list = (List *)baserel->fdw_private;
 
-	addr = KDS_ARROW_REF_VARLENA32_DATUM(kds, cmeta, index, &length);
-	if (!addr)
-		*p_isnull = true;
-	else
+	if (baseRelIsArrowFdw(baserel) &&
+		IsA(priv_list, List) && list_length(priv_list) == 2)
 	{
-		*p_isnull = false;
-		res = palloc(VARHDRSZ + length);
-		memcpy(res->vl_dat, addr, length);
-		SET_VARSIZE(res, VARHDRSZ + length);
+		List	   *af_list = linitial(priv_list);
+		ListCell   *lc;
+
+		foreach (lc, af_list)
+		{
+			ArrowFileState *af_state = lfirst(lc);
+			const DpuStorageEntry *__ds_entry;
+
+			__ds_entry = GetOptimalDpuForFile(af_state->filename, NULL);
+			if (lc == list_head(af_list))
+				ds_entry = __ds_entry;
+			else if (ds_entry && ds_entry != __ds_entry)
+				ds_entry = NULL;
+		}
 	}
-	return PointerGetDatum(res);
+	return ds_entry;
 }
 
-static Datum
-pg_varlena64_arrow_ref(kern_data_store *kds,
-					   kern_colmeta *cmeta,
-					   size_t index, bool *p_isnull)
+/*
+ * __arrowFdwExpandDirectory
+ */
+static List *
+__arrowFdwExpandDirectory(List *filesList,
+						  const char *dir_path,
+						  const char *dir_suffix,
+						  bool hive_partitioning)
 {
-	struct varlena *res = NULL;
-	const void *addr;
-	int			length;
+	struct dirent *dentry;
+	DIR	   *dir;
+	char   *temp;
 
-	addr = KDS_ARROW_REF_VARLENA64_DATUM(kds, cmeta, index, &length);
-	if (!addr)
-		*p_isnull = true;
-	else
+	dir = AllocateDir(dir_path);
+	while ((dentry = ReadDir(dir, dir_path)) != NULL)
 	{
-		*p_isnull = false;
-		res = palloc(VARHDRSZ + length);
-		memcpy(res->vl_dat, addr, length);
-		SET_VARSIZE(res, VARHDRSZ + length);
+		if (strcmp(dentry->d_name, ".") == 0 ||
+			strcmp(dentry->d_name, "..") == 0)
+			continue;
+		/* hidden files (e.g, _SUCCESS or .crc) are not data files */
+		if (hive_partitioning &&
+			(dentry->d_name[0] == '.' || dentry->d_name[0] == '_'))
+			continue;
+		temp = psprintf("%s/%s", dir_path, dentry->d_name);
+		if (hive_partitioning && strchr(dentry->d_name, '=') != NULL)
+		{
+			struct stat	stat_buf;
+
+			/* walk down the key=value sub-directories */
+			if (stat(temp, &stat_buf) == 0 && S_ISDIR(stat_buf.st_mode))
+			{
+				filesList = __arrowFdwExpandDirectory(filesList,
+													  temp,
+													  dir_suffix,
+													  hive_partitioning);
+				pfree(temp);
+				continue;
+			}
+		}
+		if (dir_suffix)
+		{
+			char   *pos = strrchr(dentry->d_name, '.');
+
+			if (!pos || strcmp(pos+1, dir_suffix) != 0)
+			{
+				pfree(temp);
+				continue;
+			}
+		}
+		if (access(temp, R_OK) != 0)
+		{
+			elog(DEBUG1, "arrow_fdw: unable to read '%s', so skipped", temp);
+			continue;
+		}
+		filesList = lappend(filesList, makeString(temp));
 	}
-	return PointerGetDatum(res);
+	FreeDir(dir);
+
+	return filesList;
 }
 
-static Datum
-pg_bpchar_arrow_ref(kern_data_store *kds,
-					kern_colmeta *cmeta, size_t index)
+/*
+ * Directory watcher
+ *
+ * Expansion of the 'dir' option by readdir(3) for each query is expensive
+ * if directory has many files. So, a background worker watches the
+ * directories by inotify(7), and bumps the generation number of the slot
+ * on any changes. Backends reuse the files list cached locally as long as
+ * the generation number is not changed.
+ */
+#define ARROW_DIRWATCH_NAPTIME			1000	/* 1sec */
+#define ARROW_DIRWATCH_STATUS__FREE			0
+#define ARROW_DIRWATCH_STATUS__REQUESTED	1
+#define ARROW_DIRWATCH_STATUS__WATCHED		2
+#define ARROW_DIRWATCH_STATUS__FAILED		3
+#define ARROW_DIRWATCH_INOTIFY_MASK		(IN_CREATE | IN_DELETE | IN_ATTRIB |	\
+										 IN_MOVED_FROM | IN_MOVED_TO |		\
+										 IN_DELETE_SELF | IN_MOVE_SELF |	\
+										 IN_ONLYDIR)
+typedef struct
 {
-	char	   *values = ((char *)kds + __kds_unpack(cmeta->values_offset));
-	size_t		length = __kds_unpack(cmeta->values_length);
-	int32_t		unitsz = cmeta->attopts.fixed_size_binary.byteWidth;
-	struct varlena *res;
+	int			status;			/* one of ARROW_DIRWATCH_STATUS__* */
+	uint64_t	generation;		/* incremented on any changes */
+	bool		hive_partitioning;	/* also watch key=value sub-directories */
+	char		dir_path[MAXPGPATH];
+} arrowDirWatchSlot;
 
-	if (unitsz <= 0)
-		elog(ERROR, "CHAR(%d) is not expected", unitsz);
-	if (unitsz * index >= length)
-		elog(ERROR, "corruption? bpchar points out of range");
-	res = palloc(VARHDRSZ + unitsz);
-	memcpy((char *)res + VARHDRSZ, values + unitsz * index, unitsz);
-	SET_VARSIZE(res, VARHDRSZ + unitsz);
+typedef struct
+{
+	slock_t		lock;
+	Latch	   *worker_latch;
+	int			nslots;
+	arrowDirWatchSlot slots[FLEXIBLE_ARRAY_MEMBER];
+} arrowDirWatchHead;
 
-	return PointerGetDatum(res);
-}
+typedef struct
+{
+	char		dir_path[MAXPGPATH];
+	char		dir_suffix[NAMEDATALEN];
+	bool		hive_partitioning;
+} arrowDirWatchCacheKey;
 
-static Datum
-pg_bool_arrow_ref(kern_data_store *kds,
-				  kern_colmeta *cmeta, size_t index)
+typedef struct
 {
-	uint8_t	   *bitmap = (uint8_t *)kds + __kds_unpack(cmeta->values_offset);
-	size_t		length = __kds_unpack(cmeta->values_length);
-	bool		rv;
+	arrowDirWatchCacheKey key;
+	int			slot_id;
+	uint64_t	generation;
+	int			nfiles;
+	char	  **files;			/* allocated on CacheMemoryContext */
+} arrowDirWatchCacheEntry;
 
-	if (sizeof(uint8_t) * (index>>3) >= length)
-		elog(ERROR, "corruption? bool points out of range");
-	rv = ((bitmap[index>>3] & (1<<(index&7))) != 0);
-	return BoolGetDatum(rv);
+typedef struct
+{
+	int			wd;				/* watch descriptor */
+	int			slot_id;
+	bool		is_top;			/* true, if slot->dir_path itself */
+	bool		hive_partitioning;
+	char		dir_path[MAXPGPATH];
+} arrowDirWatchDesc;
+
+static arrowDirWatchHead *arrow_dirwatch_head = NULL;
+static HTAB	   *arrow_dirwatch_cache_htab = NULL;
+void	arrowFdwDirWatchWorkerMain(Datum arg);
+
+/*
+ * __arrowDirWatchLookupSlot
+ *
+ * It returns slot-id if the directory is watched, or -1. Elsewhere, it
+ * requests the background worker to watch the directory for the next time.
+ */
+static int
+__arrowDirWatchLookupSlot(const char *dir_path,
+						  bool hive_partitioning,
+						  uint64_t *p_generation)
+{
+	arrowDirWatchSlot *slot;
+	Latch	   *latch;
+	int			free_id = -1;
+	int			slot_id = -1;
+	bool		wakeup = false;
+
+	SpinLockAcquire(&arrow_dirwatch_head->lock);
+	for (int i=0; i < arrow_dirwatch_head->nslots; i++)
+	{
+		slot = &arrow_dirwatch_head->slots[i];
+		if (slot->status == ARROW_DIRWATCH_STATUS__FREE)
+		{
+			if (free_id < 0)
+				free_id = i;
+			continue;
+		}
+		if (strcmp(slot->dir_path, dir_path) != 0)
+			continue;
+		if (slot->status == ARROW_DIRWATCH_STATUS__WATCHED &&
+			(slot->hive_partitioning || !hive_partitioning))
+		{
+			*p_generation = slot->generation;
+			slot_id = i;
+		}
+		else
+		{
+			if (slot->status != ARROW_DIRWATCH_STATUS__REQUESTED)
+			{
+				slot->status = ARROW_DIRWATCH_STATUS__REQUESTED;
+				wakeup = true;
+			}
+			slot->hive_partitioning |= hive_partitioning;
+		}
+		goto out;
+	}
+	/* not watched yet, so request it */
+	if (free_id >= 0)
+	{
+		slot = &arrow_dirwatch_head->slots[free_id];
+		slot->status = ARROW_DIRWATCH_STATUS__REQUESTED;
+		slot->generation = 0;
+		slot->hive_partitioning = hive_partitioning;
+		strcpy(slot->dir_path, dir_path);
+		wakeup = true;
+	}
+out:
+	latch = arrow_dirwatch_head->worker_latch;
+	SpinLockRelease(&arrow_dirwatch_head->lock);
+	if (wakeup && latch)
+		SetLatch(latch);
+	return slot_id;
 }
 
-static Datum
-pg_simple_arrow_ref(kern_data_store *kds,
-					kern_colmeta *cmeta, size_t index)
+/*
+ * __arrowFdwExpandDirectoryWatched
+ */
+static List *
+__arrowFdwExpandDirectoryWatched(List *filesList,
+								 const char *dir_path,
+								 const char *dir_suffix,
+								 bool hive_partitioning)
 {
-	int32_t		unitsz = cmeta->attopts.unitsz;
-	char	   *values = (char *)kds + __kds_unpack(cmeta->values_offset);
-	size_t		length = __kds_unpack(cmeta->values_length);
-	Datum		retval = 0;
+	arrowDirWatchCacheKey key;
+	arrowDirWatchCacheEntry *entry;
+	uint64_t	generation;
+	int			slot_id;
+	int			nfiles_prev;
+	ListCell   *lc;
 
-	Assert(unitsz > 0 && unitsz <= sizeof(Datum));
-	if (unitsz * index >= length)
-		elog(ERROR, "corruption? simple int8 points out of range");
-	memcpy(&retval, values + unitsz * index, unitsz);
-	return retval;
+	if (!arrow_dirwatch_head ||
+		strlen(dir_path) >= MAXPGPATH ||
+		(dir_suffix && strlen(dir_suffix) >= NAMEDATALEN))
+		return __arrowFdwExpandDirectory(filesList,
+										 dir_path,
+										 dir_suffix,
+										 hive_partitioning);
+	slot_id = __arrowDirWatchLookupSlot(dir_path,
+										hive_partitioning,
+										&generation);
+	if (slot_id < 0)
+		return __arrowFdwExpandDirectory(filesList,
+										 dir_path,
+										 dir_suffix,
+										 hive_partitioning);
+	if (!arrow_dirwatch_cache_htab)
+	{
+		HASHCTL		hctl;
+
+		memset(&hctl, 0, sizeof(HASHCTL));
+		hctl.keysize = sizeof(arrowDirWatchCacheKey);
+		hctl.entrysize = sizeof(arrowDirWatchCacheEntry);
+		hctl.hcxt = CacheMemoryContext;
+		arrow_dirwatch_cache_htab = hash_create("Arrow_Fdw DirWatch Cache",
+												64, &hctl,
+												HASH_ELEM | HASH_BLOBS | HASH_CONTEXT);
+	}
+	memset(&key, 0, sizeof(arrowDirWatchCacheKey));
+	strcpy(key.dir_path, dir_path);
+	if (dir_suffix)
+		strcpy(key.dir_suffix, dir_suffix);
+	key.hive_partitioning = hive_partitioning;
+
+	entry = hash_search(arrow_dirwatch_cache_htab, &key, HASH_FIND, NULL);
+	if (entry &&
+		entry->slot_id == slot_id &&
+		entry->generation == generation)
+	{
+		for (int i=0; i < entry->nfiles; i++)
+			filesList = lappend(filesList, makeString(pstrdup(entry->files[i])));
+		return filesList;
+	}
+	/* no valid cache, so read the directory, then saves the result */
+	nfiles_prev = list_length(filesList);
+	filesList = __arrowFdwExpandDirectory(filesList,
+										  dir_path,
+										  dir_suffix,
+										  hive_partitioning);
+	if (!entry)
+	{
+		entry = hash_search(arrow_dirwatch_cache_htab, &key, HASH_ENTER, NULL);
+		entry->nfiles = 0;
+		entry->files = NULL;
+	}
+	for (int i=0; i < entry->nfiles; i++)
+		pfree(entry->files[i]);
+	if (entry->files)
+		pfree(entry->files);
+	entry->slot_id = slot_id;
+	entry->generation = generation;
+	entry->nfiles = 0;
+	entry->files = MemoryContextAlloc(CacheMemoryContext,
+									  sizeof(char *) * (list_length(filesList) -
+														nfiles_prev + 1));
+	for_each_from (lc, filesList, nfiles_prev)
+	{
+		entry->files[entry->nfiles++] = MemoryContextStrdup(CacheMemoryContext,
+															strVal(lfirst(lc)));
+	}
+	return filesList;
 }
 
-static Datum
-pg_numeric_arrow_ref(kern_data_store *kds,
-					 kern_colmeta *cmeta, size_t index)
+/*
+ * routines for the directory watcher worker
+ */
+static void
+__arrowDirWatchBumpSlot(int slot_id, bool is_failed)
 {
-	char	   *result = palloc0(sizeof(struct NumericData));
-	char	   *base = (char *)kds + __kds_unpack(cmeta->values_offset);
-	size_t		length = __kds_unpack(cmeta->values_length);
-	int			dscale = cmeta->attopts.decimal.scale;
-	int128_t	ival;
-
-	if (sizeof(int128_t) * index >= length)
-		elog(ERROR, "corruption? numeric points out of range");
-	ival = ((int128_t *)base)[index];
-	__xpu_numeric_to_varlena(result, dscale, ival);
+	arrowDirWatchSlot *slot = &arrow_dirwatch_head->slots[slot_id];
 
-	return PointerGetDatum(result);
+	SpinLockAcquire(&arrow_dirwatch_head->lock);
+	if (slot->status != ARROW_DIRWATCH_STATUS__FREE)
+	{
+		if (is_failed && slot->status == ARROW_DIRWATCH_STATUS__WATCHED)
+			slot->status = ARROW_DIRWATCH_STATUS__FAILED;
+		slot->generation++;
+	}
+	SpinLockRelease(&arrow_dirwatch_head->lock);
 }
 
-static Datum
-pg_date_arrow_ref(kern_data_store *kds,
-				  kern_colmeta *cmeta, size_t index)
+static bool
+__arrowDirWatchIsNetworkFs(const char *dir_path)
 {
-	char	   *base = (char *)kds + __kds_unpack(cmeta->values_offset);
-	size_t		length = __kds_unpack(cmeta->values_length);
-	DateADT		dt;
-
-	switch (cmeta->attopts.date.unit)
+	/*
+	 * inotify(7) cannot notice the changes by the remote hosts, so
+	 * it is not reliable on the network filesystems.
+	 */
+	static const long network_fs_magics[] = {
+		0x6969,			/* NFS */
+		0x517b,			/* SMB */
+		0xff534d42,		/* CIFS */
+		0xfe534d42,		/* SMB2 */
+		0x65735546,		/* FUSE */
+		0x00c36400,		/* CEPH */
+		0x0bd00bd0,		/* LUSTRE */
+		0x47504653,		/* GPFS */
+		0,
+	};
+	struct statfs fs_buf;
+
+	if (statfs(dir_path, &fs_buf) != 0)
+		return false;	/* inotify_add_watch() will report the error */
+	for (int i=0; network_fs_magics[i] != 0; i++)
 	{
-		case ArrowDateUnit__Day:
-			if (sizeof(uint32) * index >= length)
-				elog(ERROR, "corruption? Date[day] points out of range");
-			dt = ((uint32 *)base)[index];
-			break;
-		case ArrowDateUnit__MilliSecond:
-			if (sizeof(uint64) * index >= length)
-				elog(ERROR, "corruption? Date[ms] points out of range");
-			dt = ((uint64 *)base)[index] / 1000;
-			break;
-		default:
-			elog(ERROR, "Bug? unexpected unit of Date type");
+		if ((long)fs_buf.f_type == network_fs_magics[i])
+			return true;
 	}
-	/* convert UNIX epoch to PostgreSQL epoch */
-	dt -= (POSTGRES_EPOCH_JDATE - UNIX_EPOCH_JDATE);
-	return DateADTGetDatum(dt);
+	return false;
 }
 
-static Datum
-pg_time_arrow_ref(kern_data_store *kds,
-				  kern_colmeta *cmeta, size_t index)
+static bool
+__arrowDirWatchAddPath(int inotify_fd, HTAB *wd_htab,
+					   int slot_id, const char *dir_path,
+					   bool is_top, bool hive_partitioning)
 {
-	char	   *base = (char *)kds + __kds_unpack(cmeta->values_offset);
-	size_t		length = __kds_unpack(cmeta->values_length);
-	TimeADT		tm;
+	arrowDirWatchDesc *wdesc;
+	int			wd;
 
-	switch (cmeta->attopts.time.unit)
+	if (strlen(dir_path) >= MAXPGPATH)
+		return false;
+	if (__arrowDirWatchIsNetworkFs(dir_path))
 	{
-		case ArrowTimeUnit__Second:
-			if (sizeof(uint32) * index >= length)
-				elog(ERROR, "corruption? Time[sec] points out of range");
-			tm = ((uint32 *)base)[index] * 1000000L;
-			break;
-		case ArrowTimeUnit__MilliSecond:
-			if (sizeof(uint32) * index >= length)
-				elog(ERROR, "corruption? Time[ms] points out of range");
-			tm = ((uint32 *)base)[index] * 1000L;
-			break;
-		case ArrowTimeUnit__MicroSecond:
-			if (sizeof(uint64) * index >= length)
-				elog(ERROR, "corruption? Time[us] points out of range");
-			tm = ((uint64 *)base)[index];
-			break;
-		case ArrowTimeUnit__NanoSecond:
-			if (sizeof(uint64) * index >= length)
-				elog(ERROR, "corruption? Time[ns] points out of range");
-			tm = ((uint64 *)base)[index] / 1000L;
-			break;
-		default:
-			elog(ERROR, "Bug? unexpected unit of Time type");
-			break;
+		elog(LOG, "arrow_fdw: directory \"%s\" is on network filesystem, so not watched",
+			 dir_path);
+		return false;
 	}
-	return TimeADTGetDatum(tm);
+	wd = inotify_add_watch(inotify_fd, dir_path, ARROW_DIRWATCH_INOTIFY_MASK);
+	if (wd < 0)
+	{
+		elog(LOG, "arrow_fdw: could not watch directory \"%s\": %m", dir_path);
+		return false;
+	}
+	wdesc = hash_search(wd_htab, &wd, HASH_ENTER, NULL);
+	wdesc->slot_id = slot_id;
+	wdesc->is_top = is_top;
+	wdesc->hive_partitioning = hive_partitioning;
+	strcpy(wdesc->dir_path, dir_path);
+
+	if (hive_partitioning)
+	{
+		struct dirent *dentry;
+		DIR	   *dir;
+
+		/* also watch the key=value sub-directories */
+		dir = AllocateDir(dir_path);
+		while ((dentry = ReadDirExtended(dir, dir_path, LOG)) != NULL)
+		{
+			struct stat	stat_buf;
+			char   *temp;
+
+			if (dentry->d_name[0] == '.' ||
+				dentry->d_name[0] == '_' ||
+				strchr(dentry->d_name, '=') == NULL)
+				continue;
+			temp = psprintf("%s/%s", dir_path, dentry->d_name);
+			if (stat(temp, &stat_buf) == 0 && S_ISDIR(stat_buf.st_mode) &&
+				!__arrowDirWatchAddPath(inotify_fd, wd_htab,
+										slot_id, temp,
+										false, true))
+			{
+				pfree(temp);
+				FreeDir(dir);
+				return false;
+			}
+			pfree(temp);
+		}
+		FreeDir(dir);
+	}
+	return true;
 }
 
-static Datum
-pg_timestamp_arrow_ref(kern_data_store *kds,
-					   kern_colmeta *cmeta, size_t index)
+static void
+__arrowDirWatchAddRequested(int inotify_fd, HTAB *wd_htab)
 {
-	char	   *base = (char *)kds + __kds_unpack(cmeta->values_offset);
-	size_t		length = __kds_unpack(cmeta->values_length);
-	Timestamp	ts;
-
-	switch (cmeta->attopts.timestamp.unit)
+	for (int i=0; i < arrow_dirwatch_head->nslots; i++)
 	{
-		case ArrowTimeUnit__Second:
-			if (sizeof(uint64) * index >= length)
-				elog(ERROR, "corruption? Timestamp[sec] points out of range");
-			ts = ((uint64 *)base)[index] * 1000000UL;
-			break;
-		case ArrowTimeUnit__MilliSecond:
-			if (sizeof(uint64) * index >= length)
-				elog(ERROR, "corruption? Timestamp[ms] points out of range");
-			ts = ((uint64 *)base)[index] * 1000UL;
-			break;
-		case ArrowTimeUnit__MicroSecond:
-			if (sizeof(uint64) * index >= length)
-				elog(ERROR, "corruption? Timestamp[us] points out of range");
-			ts = ((uint64 *)base)[index];
-			break;
-		case ArrowTimeUnit__NanoSecond:
-			if (sizeof(uint64) * index >= length)
-				elog(ERROR, "corruption? Timestamp[ns] points out of range");
-			ts = ((uint64 *)base)[index] / 1000UL;
-			break;
-		default:
-			elog(ERROR, "Bug? unexpected unit of Timestamp type");
-			break;
+		arrowDirWatchSlot *slot = &arrow_dirwatch_head->slots[i];
+		char		dir_path[MAXPGPATH];
+		bool		hive_partitioning;
+		bool		status;
+
+		SpinLockAcquire(&arrow_dirwatch_head->lock);
+		if (slot->status != ARROW_DIRWATCH_STATUS__REQUESTED)
+		{
+			SpinLockRelease(&arrow_dirwatch_head->lock);
+			continue;
+		}
+		strcpy(dir_path, slot->dir_path);
+		hive_partitioning = slot->hive_partitioning;
+		SpinLockRelease(&arrow_dirwatch_head->lock);
+
+		status = __arrowDirWatchAddPath(inotify_fd, wd_htab, i, dir_path,
+										true, hive_partitioning);
+
+		SpinLockAcquire(&arrow_dirwatch_head->lock);
+		if (slot->status == ARROW_DIRWATCH_STATUS__REQUESTED &&
+			slot->hive_partitioning == hive_partitioning)
+		{
+			slot->status = (status
+							? ARROW_DIRWATCH_STATUS__WATCHED
+							: ARROW_DIRWATCH_STATUS__FAILED);
+			slot->generation++;
+		}
+		SpinLockRelease(&arrow_dirwatch_head->lock);
 	}
-	/* convert UNIX epoch to PostgreSQL epoch */
-	ts -= (POSTGRES_EPOCH_JDATE -
-		   UNIX_EPOCH_JDATE) * USECS_PER_DAY;
-	return TimestampGetDatum(ts);
 }
 
-static Datum
-pg_interval_arrow_ref(kern_data_store *kds,
-					  kern_colmeta *cmeta, size_t index)
+static void
+__arrowDirWatchReadEvents(int inotify_fd, HTAB *wd_htab)
 {
-	char	   *base = (char *)kds + __kds_unpack(cmeta->values_offset);
-	size_t		length = __kds_unpack(cmeta->values_length);
-	Interval   *iv = palloc0(sizeof(Interval));
+	char		buffer[8192]
+		__attribute__ ((aligned(__alignof__(struct inotify_event))));
+	ssize_t		nbytes;
 
-	switch (cmeta->attopts.interval.unit)
+	for (;;)
 	{
-		case ArrowIntervalUnit__Year_Month:
-			/* 32bit: number of months */
-			if (sizeof(uint32) * index >= length)
-				elog(ERROR, "corruption? Interval[Year/Month] points out of range");
-			iv->month = ((uint32 *)base)[index];
-			break;
-		case ArrowIntervalUnit__Day_Time:
-			/* 32bit+32bit: number of days and milliseconds */
-			if (2 * sizeof(uint32) * index >= length)
-				elog(ERROR, "corruption? Interval[Day/Time] points out of range");
-			iv->day  = ((int32 *)base)[2 * index];
-			iv->time = ((int32 *)base)[2 * index + 1] * 1000;
+		const struct inotify_event *ev;
+		const char *pos;
+
+		nbytes = read(inotify_fd, buffer, sizeof(buffer));
+		if (nbytes < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			if (errno == EAGAIN || errno == EWOULDBLOCK)
+				break;
+			elog(ERROR, "failed on read(inotify_fd): %m");
+		}
+		if (nbytes == 0)
 			break;
-		default:
-			elog(ERROR, "Bug? unexpected unit of Interval type");
+		for (pos = buffer; pos < buffer + nbytes;
+			 pos += sizeof(struct inotify_event) + ev->len)
+		{
+			arrowDirWatchDesc *wdesc;
+
+			ev = (const struct inotify_event *)pos;
+			if ((ev->mask & IN_Q_OVERFLOW) != 0)
+			{
+				/* some events are lost, so invalidate everything */
+				for (int i=0; i < arrow_dirwatch_head->nslots; i++)
+					__arrowDirWatchBumpSlot(i, false);
+				continue;
+			}
+			wdesc = hash_search(wd_htab, &ev->wd, HASH_FIND, NULL);
+			if (!wdesc)
+				continue;
+			if (wdesc->hive_partitioning &&
+				(ev->mask & IN_ISDIR) != 0 &&
+				(ev->mask & (IN_CREATE | IN_MOVED_TO)) != 0 &&
+				ev->len > 0 &&
+				ev->name[0] != '.' &&
+				ev->name[0] != '_' &&
+				strchr(ev->name, '=') != NULL)
+			{
+				char   *temp = psprintf("%s/%s", wdesc->dir_path, ev->name);
+
+				if (!__arrowDirWatchAddPath(inotify_fd, wd_htab,
+											wdesc->slot_id, temp,
+											false, true))
+				{
+					/* sub-directory is not watched, so we cannot cache */
+					__arrowDirWatchBumpSlot(wdesc->slot_id, true);
+				}
+				pfree(temp);
+			}
+			if ((ev->mask & (IN_DELETE_SELF | IN_MOVE_SELF)) != 0)
+			{
+				/* IN_IGNORED shall be delivered later */
+				inotify_rm_watch(inotify_fd, ev->wd);
+			}
+			__arrowDirWatchBumpSlot(wdesc->slot_id,
+									(wdesc->is_top &&
+									 (ev->mask & (IN_DELETE_SELF |
+												  IN_MOVE_SELF |
+												  IN_IGNORED)) != 0));
+			if ((ev->mask & IN_IGNORED) != 0)
+				hash_search(wd_htab, &ev->wd, HASH_REMOVE, NULL);
+		}
 	}
-	return PointerGetDatum(iv);
 }
 
-static Datum
-pg_macaddr_arrow_ref(kern_data_store *kds,
-					 kern_colmeta *cmeta, size_t index)
+static void
+__arrowDirWatchWorkerExit(int code, Datum arg)
 {
-	char   *base = (char *)kds + __kds_unpack(cmeta->values_offset);
-	size_t	length = __kds_unpack(cmeta->values_length);
-
-	if (cmeta->attopts.fixed_size_binary.byteWidth != sizeof(macaddr))
-		elog(ERROR, "Bug? wrong FixedSizeBinary::byteWidth(%d) for macaddr",
-			 cmeta->attopts.fixed_size_binary.byteWidth);
-	if (sizeof(macaddr) * index >= length)
-		elog(ERROR, "corruption? Binary[macaddr] points out of range");
+	/* backends must not trust the watched slots any more */
+	SpinLockAcquire(&arrow_dirwatch_head->lock);
+	arrow_dirwatch_head->worker_latch = NULL;
+	for (int i=0; i < arrow_dirwatch_head->nslots; i++)
+	{
+		arrowDirWatchSlot *slot = &arrow_dirwatch_head->slots[i];
 
-	return PointerGetDatum(base + sizeof(macaddr) * index);
+		if (slot->status != ARROW_DIRWATCH_STATUS__FREE)
+		{
+			slot->status = ARROW_DIRWATCH_STATUS__REQUESTED;
+			slot->generation++;
+		}
+	}
+	SpinLockRelease(&arrow_dirwatch_head->lock);
 }
 
-static Datum
-pg_inet_arrow_ref(kern_data_store *kds,
-				  kern_colmeta *cmeta, size_t index)
+/*
+ * arrowFdwDirWatchWorkerMain
+ */
+void
+arrowFdwDirWatchWorkerMain(Datum arg)
 {
-	char   *base = (char *)kds + __kds_unpack(cmeta->values_offset);
-	size_t	length = __kds_unpack(cmeta->values_length);
-	inet   *ip = palloc(sizeof(inet));
-
-	if (cmeta->attopts.fixed_size_binary.byteWidth == 4)
+	HASHCTL		hctl;
+	HTAB	   *wd_htab;
+	int			inotify_fd;
+
+	pqsignal(SIGTERM, die);
+	BackgroundWorkerUnblockSignals();
+
+	inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (inotify_fd < 0)
+		elog(ERROR, "failed on inotify_init1: %m");
+	memset(&hctl, 0, sizeof(HASHCTL));
+	hctl.keysize = sizeof(int);
+	hctl.entrysize = sizeof(arrowDirWatchDesc);
+	hctl.hcxt = TopMemoryContext;
+	wd_htab = hash_create("Arrow_Fdw DirWatch Descriptors", 1024, &hctl,
+						  HASH_ELEM | HASH_BLOBS | HASH_CONTEXT);
+
+	before_shmem_exit(__arrowDirWatchWorkerExit, 0);
+	SpinLockAcquire(&arrow_dirwatch_head->lock);
+	arrow_dirwatch_head->worker_latch = MyLatch;
+	for (int i=0; i < arrow_dirwatch_head->nslots; i++)
 	{
-		if (4 * index >= length)
-			elog(ERROR, "corruption? Binary[inet4] points out of range");
-		ip->inet_data.family = PGSQL_AF_INET;
-		ip->inet_data.bits = 32;
-		memcpy(ip->inet_data.ipaddr, base + 4 * index, 4);
+		arrowDirWatchSlot *slot = &arrow_dirwatch_head->slots[i];
+
+		if (slot->status != ARROW_DIRWATCH_STATUS__FREE)
+			slot->status = ARROW_DIRWATCH_STATUS__REQUESTED;
 	}
-	else if (cmeta->attopts.fixed_size_binary.byteWidth == 16)
+	SpinLockRelease(&arrow_dirwatch_head->lock);
+	elog(LOG, "arrow_fdw: directory watcher started");
+
+	for (;;)
 	{
-		if (16 * index >= length)
-			elog(ERROR, "corruption? Binary[inet6] points out of range");
-		ip->inet_data.family = PGSQL_AF_INET6;
-		ip->inet_data.bits = 128;
-		memcpy(ip->inet_data.ipaddr, base + 16 * index, 16);
+		ResetLatch(MyLatch);
+		CHECK_FOR_INTERRUPTS();
+
+		__arrowDirWatchAddRequested(inotify_fd, wd_htab);
+		__arrowDirWatchReadEvents(inotify_fd, wd_htab);
+
+		(void) WaitLatchOrSocket(MyLatch,
+								 WL_LATCH_SET |
+								 WL_SOCKET_READABLE |
+								 WL_TIMEOUT |
+								 WL_EXIT_ON_PM_DEATH,
+								 inotify_fd,
+								 ARROW_DIRWATCH_NAPTIME,
+								 PG_WAIT_EXTENSION);
 	}
-	else
-		elog(ERROR, "Bug? wrong FixedSizeBinary::byteWidth(%d) for inet",
-			 cmeta->attopts.fixed_size_binary.byteWidth);
+}
 
-	SET_INET_VARSIZE(ip);
-	return PointerGetDatum(ip);
+/*
+ * __arrowFdwWritableFileExists
+ *
+ * The file of writable foreign table is created on the first INSERT. Until
+ * then, it is considered as an empty table.
+ */
+static bool
+__arrowFdwWritableFileExists(const char *filename)
+{
+	struct stat	stat_buf;
+
+	if (stat(filename, &stat_buf) != 0)
+	{
+		if (errno == ENOENT)
+			return false;
+		elog(ERROR, "arrow_fdw: unable to access '%s': %m", filename);
+	}
+	return (stat_buf.st_size > 0);
 }
 
-static Datum
-pg_array_arrow_ref(kern_data_store *kds,
-				   kern_colmeta *smeta,
-				   uint32_t start, uint32_t end)
+/*
+ * __arrowFdwOpenObjStoreFile
+ *
+ * An object on the object storage (s3://...) is accessed via its local
+ * cache file. It fetches the signature and the footer to be read by
+ * readArrowFileDesc(), then returns the pathname of the cache file.
+ */
+static char *
+__arrowFdwOpenObjStoreFile(const char *url, bool writable)
 {
-	ArrayType  *res;
-	size_t		sz;
-	uint32_t	i, nitems = end - start;
-	bits8	   *nullmap = NULL;
-	size_t		usage, __usage;
+	const char *cache_path;
+	struct stat	stat_buf;
+	char		tail[sizeof(int32_t) + 6];	/* strlen("ARROW1") */
+	off_t		offsets[2];
+	size_t		lengths[2];
+	int32_t		footer_sz;
+	int			fdesc;
+
+	if (writable)
+		elog(ERROR, "arrow_fdw: '%s' on the object storage is not writable", url);
+	cache_path = pgstromObjStoreOpenObject(url);
+	if (stat(cache_path, &stat_buf) != 0)
+		elog(ERROR, "failed on stat('%s'): %m", cache_path);
+	if (stat_buf.st_size < 8 + sizeof(tail))
+		elog(ERROR, "arrow_fdw: '%s' is too small for Apache Arrow file", url);
+	offsets[0] = 0;
+	lengths[0] = 8;
+	offsets[1] = stat_buf.st_size - sizeof(tail);
+	lengths[1] = sizeof(tail);
+	pgstromObjStoreFetchRanges(cache_path, 2, offsets, lengths, true);
+
+	fdesc = OpenTransientFile(cache_path, O_RDONLY | PG_BINARY);
+	if (fdesc < 0)
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not open file \"%s\": %m", cache_path)));
+	if (pread(fdesc, tail, sizeof(tail), offsets[1]) != sizeof(tail))
+		elog(ERROR, "failed on pread('%s'): %m", cache_path);
+	CloseTransientFile(fdesc);
+	if (memcmp(tail + sizeof(int32_t), "ARROW1", 6) != 0)
+		elog(ERROR, "arrow_fdw: '%s' is not Apache Arrow file (parquet is not supported on the object storage)", url);
+	footer_sz = *((int32_t *)tail);
+	if (footer_sz <= 0 || footer_sz > offsets[1] - 8)
+		elog(ERROR, "arrow_fdw: '%s' has corrupted footer", url);
+	offsets[0] = offsets[1] - footer_sz;
+	lengths[0] = footer_sz;
+	pgstromObjStoreFetchRanges(cache_path, 1, offsets, lengths, true);
+
+	return pstrdup(cache_path);
+}
 
-	/* sanity checks */
-	if (start > end)
-		elog(ERROR, "Bug? array index has reversed order [%u..%u]", start, end);
+/*
+ * arrowFdwExtractFilesList
+ */
+static List *
+arrowFdwExtractFilesList(List *options_list,
+						 int *p_parallel_nworkers,
+						 bool *p_hive_partitioning)
+{
 
-	/* allocation of the result buffer */
-	if (smeta->nullmap_offset != 0)
-		sz = ARR_OVERHEAD_WITHNULLS(1, nitems);
-	else
-		sz = ARR_OVERHEAD_NONULLS(1);
+	ListCell   *lc;
+	List	   *filesList = NIL;
+	char	   *dir_path = NULL;
+	char	   *dir_suffix = NULL;
+	char	   *stream = NULL;
+	int			parallel_nworkers = -1;
+	bool		hive_partitioning = false;
+	bool		writable = false;
+	int			nfiles = 0;
 
-	if (smeta->attlen > 0)
-	{
-		sz += TYPEALIGN(smeta->attalign,
-						smeta->attlen) * nitems;
-	}
-	else if (smeta->attlen == -1)
+	/* 'writable' allows the file not to exist yet */
+	foreach (lc, options_list)
 	{
-		sz += 400;		/* tentative allocation */
-	}
-	else
-		elog(ERROR, "Bug? corrupted kernel column metadata");
+		DefElem	   *defel = lfirst(lc);
 
-	res = palloc0(sz);
-	res->ndim = 1;
-	if (smeta->nullmap_offset != 0)
-	{
-		res->dataoffset = ARR_OVERHEAD_WITHNULLS(1, nitems);
-		nullmap = ARR_NULLBITMAP(res);
+		if (strcmp(defel->defname, "writable") == 0 &&
+			!parse_bool(strVal(defel->arg), &writable))
+			elog(ERROR, "arrow_fdw: 'writable' must be boolean");
 	}
-	res->elemtype = smeta->atttypid;
-	ARR_DIMS(res)[0] = nitems;
-	ARR_LBOUND(res)[0] = 1;
-	usage = ARR_DATA_OFFSET(res);
-	for (i=0; i < nitems; i++)
+
+	foreach (lc, options_list)
 	{
-		Datum	datum;
-		bool	isnull;
+		DefElem	   *defel = lfirst(lc);
 
-		pg_datum_arrow_ref(kds, smeta, start+i, &datum, &isnull);
-		if (isnull)
-		{
-			if (!nullmap)
-				elog(ERROR, "Bug? element item should not be NULL");
-		}
-		else if (smeta->attlen > 0)
+		Assert(IsA(defel->arg, String));
+		if (strcmp(defel->defname, "file") == 0)
 		{
-			if (nullmap)
-				nullmap[i>>3] |= (1<<(i&7));
-			__usage = TYPEALIGN(smeta->attalign, usage);
-			while (__usage + smeta->attlen > sz)
+			char   *temp = strVal(defel->arg);
+
+			nfiles++;
+			if (pgstromObjStoreIsURL(temp))
 			{
-				sz += sz;
-				res = repalloc(res, sz);
+				filesList = lappend(filesList,
+									makeString(__arrowFdwOpenObjStoreFile(temp, writable)));
+				continue;
 			}
-			if (__usage > usage)
-				memset((char *)res + usage, 0, __usage - usage);
-			memcpy((char *)res + __usage, &datum, smeta->attlen);
-			usage = __usage + smeta->attlen;
+			if (writable && !__arrowFdwWritableFileExists(temp))
+				continue;
+			if (access(temp, R_OK) != 0)
+				elog(ERROR, "arrow_fdw: unable to access '%s': %m", temp);
+			filesList = lappend(filesList, makeString(pstrdup(temp)));
 		}
-		else if (smeta->attlen == -1)
+		else if (strcmp(defel->defname, "files") == 0)
 		{
-			int32_t		vl_len = VARSIZE(datum);
+			char   *temp = pstrdup(strVal(defel->arg));
+			char   *saveptr;
+			char   *tok;
 
-			if (nullmap)
-				nullmap[i>>3] |= (1<<(i&7));
-			__usage = TYPEALIGN(smeta->attalign, usage);
-			while (__usage + vl_len > sz)
+			for (tok = strtok_r(temp, ",", &saveptr);
+				 tok != NULL;
+				 tok = strtok_r(NULL, ",", &saveptr))
 			{
-				sz += sz;
-				res = repalloc(res, sz);
+				tok = __trim(tok);
+
+				if (pgstromObjStoreIsURL(tok))
+				{
+					nfiles++;
+					filesList = lappend(filesList,
+										makeString(__arrowFdwOpenObjStoreFile(tok, writable)));
+					continue;
+				}
+				if (*tok != '/')
+					elog(ERROR, "arrow_fdw: file '%s' must be absolute path", tok);
+				nfiles++;
+				if (writable && !__arrowFdwWritableFileExists(tok))
+					continue;
+				if (access(tok, R_OK) != 0)
+					elog(ERROR, "arrow_fdw: unable to access '%s': %m", tok);
+				filesList = lappend(filesList, makeString(pstrdup(tok)));
 			}
-			if (__usage > usage)
-				memset((char *)res + usage, 0, __usage - usage);
-			memcpy((char *)res + __usage, DatumGetPointer(datum), vl_len);
-			usage = __usage + vl_len;
+			pfree(temp);
+		}
+		else if (strcmp(defel->defname, "dir") == 0)
+		{
+			dir_path = strVal(defel->arg);
+			if (*dir_path != '/')
+				elog(ERROR, "arrow_fdw: dir '%s' must be absolute path", dir_path);
+		}
+		else if (strcmp(defel->defname, "suffix") == 0)
+		{
+			dir_suffix = strVal(defel->arg);
+		}
+		else if (strcmp(defel->defname, "stream") == 0)
+		{
+			stream = strVal(defel->arg);
+		}
+		else if (strcmp(defel->defname, "parallel_workers") == 0)
+		{
+			if (parallel_nworkers >= 0)
+				elog(ERROR, "'parallel_workers' appeared twice");
+			parallel_nworkers = atoi(strVal(defel->arg));
+		}
+		else if (strcmp(defel->defname, "hive_partitioning") == 0)
+		{
+			if (!parse_bool(strVal(defel->arg), &hive_partitioning))
+				elog(ERROR, "arrow_fdw: 'hive_partitioning' must be boolean");
+		}
+		else if (strcmp(defel->defname, "writable") == 0)
+		{
+			/* already checked */
+		}
+		else if (strcmp(defel->defname, "manifest") == 0)
+		{
+			/* see arrowFdwLookupManifest */
+		}
+		else
+			elog(ERROR, "arrow: unknown option (%s)", defel->defname);
+	}
+	if (dir_suffix && !dir_path)
+		elog(ERROR, "arrow: cannot use 'suffix' option without 'dir'");
+	if (writable && (dir_path || nfiles != 1))
+		elog(ERROR, "arrow_fdw: 'writable' option requires exactly one file");
+	if (stream)
+	{
+		if (dir_path || nfiles > 0 || writable || hive_partitioning)
+			elog(ERROR, "arrow_fdw: 'stream' option cannot be used with file, files, dir, writable or hive_partitioning");
+		const char *spool_dir = pgstromArrowStreamSpoolDir(stream);
 
-			pfree(DatumGetPointer(datum));
+		if (strncmp(stream, "shm:", 4) == 0)
+		{
+			/* shared memory segments, and the ones already spooled */
+			filesList = pgstromArrowStreamShmemFiles(filesList,
+													 stream,
+													 spool_dir);
 		}
 		else
-			elog(ERROR, "Bug? corrupted kernel column metadata");
+		{
+			/* record-batches received so far, in the spool segments */
+			filesList = __arrowFdwExpandDirectory(filesList,
+												  spool_dir,
+												  "arrows",
+												  false);
+		}
 	}
-	SET_VARSIZE(res, usage);
 
-	return PointerGetDatum(res);
+	if (dir_path)
+		filesList = __arrowFdwExpandDirectoryWatched(filesList,
+													 dir_path,
+													 dir_suffix,
+													 hive_partitioning);
+	if (p_parallel_nworkers)
+		*p_parallel_nworkers = parallel_nworkers;
+	if (p_hive_partitioning)
+		*p_hive_partitioning = hive_partitioning;
+	return filesList;
 }
 
+/* ----------------------------------------------------------------
+ *
+ * arrowFdwLoadRecordBatch() and related routines
+ *
+ * it setup KDS (ARROW format) with IOvec according to RecordBatchState
+ *
+ * ----------------------------------------------------------------
+ */
+
 /*
- * pg_datum_arrow_ref
+ * arrowFdwSetupIOvector
  */
+typedef struct
+{
+	off_t		rb_offset;
+	off_t		f_offset;
+	off_t		m_offset;
+	off_t		kds_head_sz;
+	int32_t		depth;
+	int32_t		io_index;
+	uint32_t	row_start;	/* first row to be loaded */
+	uint32_t	row_count;	/* number of rows to be loaded */
+	bool		row_range;	/* true, if partial range of rows */
+	strom_io_chunk ioc[FLEXIBLE_ARRAY_MEMBER];
+} arrowFdwSetupIOContext;
+
 static void
-pg_datum_arrow_ref(kern_data_store *kds,
-				   kern_colmeta *cmeta,
-				   size_t index,
-				   Datum *p_datum,
-				   bool *p_isnull)
+__setupIOvectorField(arrowFdwSetupIOContext *con,
+					 uint32_t chunk_align,
+					 off_t    chunk_offset,
+					 size_t   chunk_length,
+					 uint32_t *p_cmeta_offset,
+					 uint32_t *p_cmeta_length)
 {
-	Datum		datum = 0;
-	bool		isnull = false;
+	off_t		f_pos = con->rb_offset + chunk_offset;
+	off_t		f_gap;
+	off_t		f_base;
+	off_t		m_offset;
+	strom_io_chunk *ioc;
 
-	if (KDS_ARROW_CHECK_ISNULL(kds, cmeta, index))
-	{
-		isnull = true;
-		goto out;
-	}
+	/*
+	 * Round up chunk_length to 64bit boundary.
+	 * Apache Arrow does not require the chunk_length is aligned to 64bit boundary,
+	 * chunk_offset must be aligned to 64bit (512bit recommended).
+	 * So, some extra bytes (up to -7bytes) may improve the potency of i/o chunk
+	 * consolication.
+	 */
 
-	switch (cmeta->attopts.tag)
+	if (f_pos >= con->f_offset &&
+		((f_pos & ~PAGE_MASK) == (con->f_offset & ~PAGE_MASK) ||
+		 f_pos - con->f_offset <= (off_t)arrow_io_merge_gap_kb * 1024L))
 	{
-		case ArrowType__Int:
-		case ArrowType__FloatingPoint:
-			datum = pg_simple_arrow_ref(kds, cmeta, index);
-			break;
-		case ArrowType__Bool:
-			datum = pg_bool_arrow_ref(kds, cmeta, index);
-			break;
-		case ArrowType__Decimal:
-			datum = pg_numeric_arrow_ref(kds, cmeta, index);
-			break;
-		case ArrowType__Date:
-			datum = pg_date_arrow_ref(kds, cmeta, index);
-			break;
-		case ArrowType__Time:
-			datum = pg_time_arrow_ref(kds, cmeta, index);
-			break;
-		case ArrowType__Timestamp:
-			datum = pg_timestamp_arrow_ref(kds, cmeta, index);
-			break;
-		case ArrowType__Interval:
-			datum = pg_interval_arrow_ref(kds, cmeta, index);
-			break;
-		case ArrowType__Utf8:
-		case ArrowType__Binary:
-			datum = pg_varlena32_arrow_ref(kds, cmeta, index, &isnull);
-			break;
-		case ArrowType__LargeUtf8:
-		case ArrowType__LargeBinary:
-			datum = pg_varlena64_arrow_ref(kds, cmeta, index, &isnull);
-			break;
+		/*
+		 * we can consolidate the two i/o chunks, if file position of the next
+		 * chunk (f_pos) and the current file tail position (con->f_offset) locate
+		 * within the same file page, and gap bytes does not break alignment.
+		 * Also, short holes by the unreferenced columns are read together
+		 * (up to arrow_fdw.io_merge_gap), because a larger sequential read
+		 * is usually cheaper than multiple small DMA requests.
+		 */
+		f_gap = f_pos - con->f_offset;
+		m_offset = con->m_offset + f_gap;
 
-		case ArrowType__FixedSizeBinary:
-			switch (cmeta->atttypid)
+		if (m_offset == TYPEALIGN(chunk_align, con->m_offset))
+		{
+			/* put the gap bytes, if any */
+			if (f_gap > 0)
 			{
-				case MACADDROID:
-					datum = pg_macaddr_arrow_ref(kds, cmeta, index);
-					break;
-				case INETOID:
-					datum = pg_inet_arrow_ref(kds, cmeta, index);
-					break;
-				case BPCHAROID:
-					datum = pg_bpchar_arrow_ref(kds, cmeta, index);
-					break;
-				default:
-					elog(ERROR, "unknown FixedSizeBinary mapping");
-					break;
+				con->m_offset += f_gap;
+				con->f_offset += f_gap;
 			}
-			break;
-			
-		case ArrowType__List:
-			{
-				kern_colmeta   *smeta;
-				uint32_t	   *offset;
+			*p_cmeta_offset = __kds_packed(con->kds_head_sz +
+										   con->m_offset);
+			*p_cmeta_length = __kds_packed(MAXALIGN(chunk_length));
+			con->m_offset += chunk_length;
+			con->f_offset += chunk_length;
+			return;
+		}
+	}
+	/*
+	 * Elsewhere, we have to close the current i/o chunk once, then
+	 * restart a new i/o chunk to load the disjoin chunks.
+	 */
+	if (con->io_index < 0)
+		con->io_index = 0;		/* no current active i/o chunk */
+	else
+	{
+		off_t	f_tail = PAGE_ALIGN(con->f_offset);
 
-				if (cmeta->num_subattrs != 1 ||
-					cmeta->idx_subattrs < kds->ncols ||
-					cmeta->idx_subattrs >= kds->nr_colmeta)
-					elog(ERROR, "Bug? corrupted kernel column metadata");
-				if (sizeof(uint32_t) * (index+2) > __kds_unpack(cmeta->values_length))
-					elog(ERROR, "Bug? array index is out of range");
-				smeta = &kds->colmeta[cmeta->idx_subattrs];
-				offset = (uint32_t *)((char *)kds + __kds_unpack(cmeta->values_offset));
-				datum = pg_array_arrow_ref(kds, smeta,
-										   offset[index],
-										   offset[index+1]);
-				isnull = false;
-			}
-			break;
+		ioc = &con->ioc[con->io_index++];
+		ioc->nr_pages = (f_tail / PAGE_SIZE) - ioc->fchunk_id;
+		con->m_offset += (f_tail - con->f_offset);	/* padding bytes */
+	}
 
-		case ArrowType__LargeList:
-			{
-				kern_colmeta   *smeta;
-				uint64_t	   *offset;
+	f_base = PAGE_ALIGN_DOWN(f_pos);
+	f_gap = f_pos - f_base;
+	m_offset = TYPEALIGN(chunk_align, con->m_offset + f_gap);
 
-				if (cmeta->num_subattrs != 1 ||
-					cmeta->idx_subattrs < kds->ncols ||
-					cmeta->idx_subattrs >= kds->nr_colmeta)
-					elog(ERROR, "Bug? corrupted kernel column metadata");
-				if (sizeof(uint64_t) * (index+2) > __kds_unpack(cmeta->values_length))
-					elog(ERROR, "Bug? array index is out of range");
-				smeta = &kds->colmeta[cmeta->idx_subattrs];
-				offset = (uint64_t *)((char *)kds + __kds_unpack(cmeta->values_offset));
-				datum = pg_array_arrow_ref(kds, smeta,
-										   offset[index],
+	ioc = &con->ioc[con->io_index];
+	ioc->m_offset = m_offset - f_gap;
+	ioc->fchunk_id = f_base / PAGE_SIZE;
+
+	*p_cmeta_offset = __kds_packed(con->kds_head_sz + m_offset);
+	*p_cmeta_length = __kds_packed(MAXALIGN(chunk_length));
+	con->m_offset = m_offset + chunk_length;
+	con->f_offset = f_pos + chunk_length;
+}
+
+static void
+arrowFdwSetupIOvectorField(arrowFdwSetupIOContext *con,
+						   RecordBatchFieldState *rb_field,
+						   kern_data_store *kds,
+						   kern_colmeta *cmeta)
+{
+	//int		index = cmeta - kds->colmeta;
+	off_t		nullmap_offset = rb_field->nullmap_offset;
+	size_t		nullmap_length = rb_field->nullmap_length;
+	off_t		values_offset = rb_field->values_offset;
+	size_t		values_length = rb_field->values_length;
+
+	if (con->row_range)
+	{
+		/*
+		 * Only a part of rows shall be loaded, according to the zone-map.
+		 * row_start is always multiple of 64, so nullmap is also aligned.
+		 */
+		size_t		gap;
+
+		Assert(con->depth == 0 &&
+			   rb_field->attopts.unitsz > 0 &&
+			   rb_field->extra_length == 0 &&
+			   rb_field->num_children == 0 &&
+			   (con->row_start & 63) == 0);
+		if (nullmap_length > 0)
+		{
+			gap = Min(con->row_start / BITS_PER_BYTE, nullmap_length);
+			nullmap_offset += gap;
+			nullmap_length = Min(nullmap_length - gap,
+								 BITMAPLEN(con->row_count));
+		}
+		if (values_length > 0)
+		{
+			gap = Min((size_t)con->row_start * rb_field->attopts.unitsz,
+					  values_length);
+			values_offset += gap;
+			values_length = Min(values_length - gap,
+								(size_t)con->row_count * rb_field->attopts.unitsz);
+		}
+	}
+
+	if (nullmap_length > 0)
+	{
+		Assert(rb_field->null_count > 0);
+		__setupIOvectorField(con,
+							 sizeof(int64_t),	/* 64bit alignment */
+							 nullmap_offset,
+							 nullmap_length,
+							 &cmeta->nullmap_offset,
+							 &cmeta->nullmap_length);
+		//elog(INFO, "D%d att[%d] nullmap=%lu,%lu m_offset=%lu f_offset=%lu", con->depth, index, rb_field->nullmap_offset, rb_field->nullmap_length, con->m_offset, con->f_offset);
+	}
+	if (values_length > 0)
+	{
+		__setupIOvectorField(con,
+							 rb_field->attopts.align,
+							 values_offset,
+							 values_length,
+							 &cmeta->values_offset,
+							 &cmeta->values_length);
+		//elog(INFO, "D%d att[%d] values=%lu,%lu m_offset=%lu f_offset=%lu", con->depth, index, rb_field->values_offset, rb_field->values_length, con->m_offset, con->f_offset);
+	}
+	if (rb_field->extra_length > 0)
+	{
+		__setupIOvectorField(con,
+							 sizeof(int64_t),	/* 64bit alignment */
+							 rb_field->extra_offset,
+							 rb_field->extra_length,
+							 &cmeta->extra_offset,
+							 &cmeta->extra_length);
+		//elog(INFO, "D%d att[%d] extra=%lu,%lu m_offset=%lu f_offset=%lu", con->depth, index, rb_field->extra_offset, rb_field->extra_length, con->m_offset, con->f_offset);
+	}
+
+	/* nested sub-fields if composite types */
+	if (cmeta->atttypkind == TYPE_KIND__ARRAY ||
+		cmeta->atttypkind == TYPE_KIND__COMPOSITE)
+	{
+		kern_colmeta *subattr;
+		int		j;
+
+		Assert(rb_field->num_children == cmeta->num_subattrs);
+		con->depth++;
+		for (j=0, subattr = &kds->colmeta[cmeta->idx_subattrs];
+			 j < cmeta->num_subattrs;
+			 j++, subattr++)
+		{
+			RecordBatchFieldState *child = &rb_field->children[j];
+
+			arrowFdwSetupIOvectorField(con, child, kds, subattr);
+		}
+		con->depth--;
+	}
+}
+
+static strom_io_vector *
+arrowFdwSetupIOvector(RecordBatchState *rb_state,
+					  Bitmapset *referenced,
+					  kern_data_store *kds,
+					  uint32_t row_start,
+					  uint32_t row_count)
+{
+	arrowFdwSetupIOContext *con;
+	strom_io_vector *iovec;
+	unsigned int	nr_chunks = 0;
+
+	Assert(kds->format == KDS_FORMAT_ARROW &&
+		   kds->ncols <= kds->nr_colmeta &&
+		   kds->ncols == rb_state->nfields);
+	con = alloca(offsetof(arrowFdwSetupIOContext,
+						  ioc[3 * kds->nr_colmeta]));
+	con->rb_offset = rb_state->rb_offset;
+	con->f_offset  = ~0UL;	/* invalid offset */
+	con->m_offset  = 0;
+	con->kds_head_sz = KDS_HEAD_LENGTH(kds);
+	con->depth = 0;
+	con->io_index = -1;		/* invalid index */
+	con->row_start = row_start;
+	con->row_count = row_count;
+	con->row_range = (row_start > 0 || row_count < rb_state->rb_nitems);
+	for (int j=0; j < kds->ncols; j++)
+	{
+		RecordBatchFieldState *rb_field = &rb_state->fields[j];
+		kern_colmeta *cmeta = &kds->colmeta[j];
+		int			attidx = j + 1 - FirstLowInvalidHeapAttributeNumber;
+
+		if (rb_field->part_key)
+			continue;	/* see arrowFdwSetupPartitionKeys */
+		if (bms_is_member(attidx, referenced) ||
+			bms_is_member(-FirstLowInvalidHeapAttributeNumber, referenced))
+			arrowFdwSetupIOvectorField(con, rb_field, kds, cmeta);
+		else
+			cmeta->atttypkind = TYPE_KIND__NULL;	/* unreferenced */
+	}
+	if (con->io_index >= 0)
+	{
+		/* close the last I/O chunks */
+		strom_io_chunk *ioc = &con->ioc[con->io_index++];
+
+		ioc->nr_pages = (PAGE_ALIGN(con->f_offset) / PAGE_SIZE - ioc->fchunk_id);
+		con->m_offset += PAGE_SIZE * ioc->nr_pages;
+		nr_chunks = con->io_index;
+	}
+	kds->length = con->kds_head_sz + con->m_offset;
+
+	iovec = palloc0(offsetof(strom_io_vector, ioc[nr_chunks]));
+	iovec->nr_chunks = nr_chunks;
+	if (iovec->nr_chunks > 0)
+		memcpy(iovec->ioc, con->ioc, sizeof(strom_io_chunk) * con->io_index);
+#if 0
+	/* for debug - dump the i/o vector */
+	{
+		elog(INFO, "nchunks = %d", iovec->nr_chunks);
+		for (int j=0; j < iovec->nr_chunks; j++)
+		{
+			strom_io_chunk *ioc = &iovec->ioc[j];
+
+			elog(INFO, "io[%d] [ m_offset=%lu, f_read=%lu...%lu, nr_pages=%u}",
+				 j,
+				 ioc->m_offset,
+				 ioc->fchunk_id * PAGE_SIZE,
+				 (ioc->fchunk_id + ioc->nr_pages) * PAGE_SIZE,
+				 ioc->nr_pages);
+		}
+
+		elog(INFO, "kds {length=%zu nitems=%u typeid=%u typmod=%u table_oid=%u}",
+			 kds->length, kds->nitems,
+			 kds->tdtypeid, kds->tdtypmod, kds->table_oid);
+		for (int j=0; j < kds->nr_colmeta; j++)
+		{
+			kern_colmeta *cmeta = &kds->colmeta[j];
+
+			elog(INFO, "%ccol[%d] nullmap=%lu,%lu values=%lu,%lu extra=%lu,%lu",
+				 j < kds->ncols ? ' ' : '*', j,
+				 __kds_unpack(cmeta->nullmap_offset),
+				 __kds_unpack(cmeta->nullmap_length),
+				 __kds_unpack(cmeta->values_offset),
+				 __kds_unpack(cmeta->values_length),
+				 __kds_unpack(cmeta->extra_offset),
+				 __kds_unpack(cmeta->extra_length));
+		}
+	}
+#endif
+	return iovec;
+}
+
+/*
+ * arrowFdwLoadRecordBatch
+ */
+static void
+__arrowKdsAssignAttrOptions(kern_data_store *kds,
+							kern_colmeta *cmeta,
+							RecordBatchFieldState *rb_field)
+{
+	memcpy(&cmeta->attopts,
+		   &rb_field->attopts, sizeof(ArrowTypeOptions));
+	if (cmeta->atttypkind == TYPE_KIND__ARRAY)
+	{
+		Assert(cmeta->idx_subattrs >= kds->ncols &&
+			   cmeta->num_subattrs == 1 &&
+			   cmeta->idx_subattrs + cmeta->num_subattrs <= kds->nr_colmeta &&
+			   rb_field->num_children == 1);
+		__arrowKdsAssignAttrOptions(kds,
+									&kds->colmeta[cmeta->idx_subattrs],
+									&rb_field->children[0]);
+	}
+	else if (cmeta->atttypkind == TYPE_KIND__COMPOSITE)
+	{
+		Assert(cmeta->idx_subattrs >= kds->ncols &&
+			   cmeta->num_subattrs == rb_field->num_children &&
+			   cmeta->idx_subattrs + cmeta->num_subattrs <= kds->nr_colmeta);
+		for (int j=0; j < cmeta->num_subattrs; j++)
+		{
+			__arrowKdsAssignAttrOptions(kds,
+										&kds->colmeta[cmeta->idx_subattrs + j],
+										&rb_field->children[j]);
+		}
+	}
+}
+
+/*
+ * Routines to load the compressed record-batch
+ *
+ * When BodyCompression is set, each buffer is prefixed by its uncompressed
+ * length (int64; -1 means this buffer is not compressed actually), and
+ * followed by the LZ4 frame or ZSTD data. Because we cannot load such
+ * buffers to the device memory as is, the backend process reads and
+ * decompresses the referenced buffers, then builds KDS_FORMAT_ARROW with
+ * the uncompressed layout inline on the chunk_buffer.
+ */
+typedef struct
+{
+	RecordBatchState *rb_state;
+	File		filp;
+	StringInfo	chunk_buffer;
+	uint32_t	kds_offset;		/* offset of KDS on the chunk_buffer */
+	StringInfoData temp;		/* buffer to read the compressed data */
+} arrowFdwDecompressContext;
+
+/*
+ * __arrowFdwRewriteVariadicViews
+ *
+ * kern_colmeta has only one extra buffer, so BinaryView/Utf8View with
+ * multiple variadic buffers are loaded onto a contiguous extra region,
+ * then the out-of-line views are rewritten to the buffer_index=0 with
+ * the offset from the head of the extra region.
+ */
+static void
+__arrowFdwRewriteVariadicViews(kern_data_store *kds,
+							   kern_colmeta *cmeta,
+							   RecordBatchFieldState *rb_field,
+							   const off_t *bases)
+{
+	ArrowBinaryView *views;
+	size_t		nitems;
+
+	Assert(rb_field->attopts.tag == ArrowType__Utf8View ||
+		   rb_field->attopts.tag == ArrowType__BinaryView);
+	views = (ArrowBinaryView *)((char *)kds + __kds_unpack(cmeta->values_offset));
+	nitems = Min(rb_field->nitems,
+				 __kds_unpack(cmeta->values_length) / sizeof(ArrowBinaryView));
+	for (size_t i=0; i < nitems; i++)
+	{
+		ArrowBinaryView *view = &views[i];
+		int64_t		offset;
+
+		if (KDS_ARROW_CHECK_ISNULL(kds, cmeta, i) ||
+			view->length <= ARROW_VIEW_INLINE_MAXLEN)
+			continue;
+		if (view->u.ref.buffer_index < 0 ||
+			view->u.ref.buffer_index >= rb_field->num_variadic)
+			elog(ERROR, "arrow_fdw: view buffer_index (%d) is out of range",
+				 view->u.ref.buffer_index);
+		offset = (int64_t)view->u.ref.offset + bases[view->u.ref.buffer_index];
+		if (offset < 0 || offset > INT_MAX)
+			elog(ERROR, "arrow_fdw: variadic buffers of the view are too large");
+		view->u.ref.buffer_index = 0;
+		view->u.ref.offset = offset;
+	}
+}
+
+static bool
+__arrowFieldHasMultiVariadics(RecordBatchFieldState *rb_field)
+{
+	if (rb_field->num_variadic > 1)
+		return true;
+	for (int j=0; j < rb_field->num_children; j++)
+	{
+		if (__arrowFieldHasMultiVariadics(&rb_field->children[j]))
+			return true;
+	}
+	return false;
+}
+
+/*
+ * arrowFdwVariadicViewsReferenced
+ *
+ * It returns true, if any referenced BinaryView/Utf8View has multiple
+ * variadic buffers; its views must be rewritten on the host.
+ */
+static bool
+arrowFdwVariadicViewsReferenced(RecordBatchState *rb_state,
+								Bitmapset *referenced)
+{
+	for (int j=0; j < rb_state->nfields; j++)
+	{
+		int		attidx = j + 1 - FirstLowInvalidHeapAttributeNumber;
+
+		if ((bms_is_member(attidx, referenced) ||
+			 bms_is_member(-FirstLowInvalidHeapAttributeNumber, referenced)) &&
+			__arrowFieldHasMultiVariadics(&rb_state->fields[j]))
+			return true;
+	}
+	return false;
+}
+
+static void
+__arrowFdwNormalizeVariadicViews(kern_data_store *kds,
+								 kern_colmeta *cmeta,
+								 RecordBatchFieldState *rb_field)
+{
+	if (rb_field->num_variadic > 1)
+	{
+		off_t	   *bases = alloca(sizeof(off_t) * rb_field->num_variadic);
+
+		/* variadic buffers are loaded according to the file layout */
+		for (int k=0; k < rb_field->num_variadic; k++)
+			bases[k] = rb_field->variadic_offsets[k] - rb_field->variadic_offsets[0];
+		__arrowFdwRewriteVariadicViews(kds, cmeta, rb_field, bases);
+	}
+	if (cmeta->atttypkind == TYPE_KIND__ARRAY ||
+		cmeta->atttypkind == TYPE_KIND__COMPOSITE)
+	{
+		Assert(rb_field->num_children == cmeta->num_subattrs);
+		for (int j=0; j < rb_field->num_children; j++)
+			__arrowFdwNormalizeVariadicViews(kds,
+											 &kds->colmeta[cmeta->idx_subattrs + j],
+											 &rb_field->children[j]);
+	}
+}
+
+static void
+arrowFdwNormalizeVariadicViews(RecordBatchState *rb_state,
+							   Bitmapset *referenced,
+							   kern_data_store *kds)
+{
+	for (int j=0; j < rb_state->nfields; j++)
+	{
+		int		attidx = j + 1 - FirstLowInvalidHeapAttributeNumber;
+
+		if (rb_state->fields[j].part_key)
+			continue;
+		if (bms_is_member(attidx, referenced) ||
+			bms_is_member(-FirstLowInvalidHeapAttributeNumber, referenced))
+			__arrowFdwNormalizeVariadicViews(kds, &kds->colmeta[j],
+											 &rb_state->fields[j]);
+	}
+}
+
+static void
+__arrowFdwDecompressBuffer(arrowFdwDecompressContext *con,
+						   uint32_t chunk_align,
+						   off_t    chunk_offset,
+						   size_t   chunk_length,
+						   uint32_t *p_cmeta_offset,
+						   uint32_t *p_cmeta_length)
+{
+	RecordBatchState *rb_state = con->rb_state;
+	const char *filename = rb_state->af_state->filename;
+	StringInfo	chunk_buffer = con->chunk_buffer;
+	off_t		f_pos = rb_state->rb_offset + chunk_offset;
+	const char *src;
+	size_t		src_len;
+	char	   *dst;
+	int64_t		raw_len;
+	bool		is_raw = false;
+	size_t		m_offset;
+
+	if (chunk_length == 0)
+		return;
+	if (chunk_length < sizeof(int64_t))
+		elog(ERROR, "arrow_fdw: compressed buffer is too small at '%s'", filename);
+	/* read the compressed buffer */
+	resetStringInfo(&con->temp);
+	enlargeStringInfo(&con->temp, chunk_length);
+	while (con->temp.len < chunk_length)
+	{
+		ssize_t		sz;
+
+		CHECK_FOR_INTERRUPTS();
+
+		sz = FileRead(con->filp,
+					  con->temp.data + con->temp.len,
+					  chunk_length - con->temp.len,
+					  f_pos + con->temp.len,
+					  WAIT_EVENT_DATA_FILE_READ);
+		if (sz > 0)
+			con->temp.len += sz;
+		else if (sz == 0)
+			elog(ERROR, "arrow_fdw: unexpected EOF at '%s' (pos=%lu)",
+				 filename, f_pos + con->temp.len);
+		else if (errno != EINTR)
+			elog(ERROR, "failed on FileRead('%s', pos=%lu, len=%lu): %m",
+				 filename, f_pos + con->temp.len, chunk_length - con->temp.len);
+	}
+	memcpy(&raw_len, con->temp.data, sizeof(int64_t));
+	src = con->temp.data + sizeof(int64_t);
+	src_len = chunk_length - sizeof(int64_t);
+	if (raw_len < 0)
+	{
+		raw_len = src_len;		/* not compressed */
+		is_raw = true;
+	}
+	else if (raw_len >= UINT_MAX)
+		elog(ERROR, "arrow_fdw: uncompressed buffer is too large at '%s'", filename);
+
+	/* allocation of the destination */
+	chunk_align = Max(chunk_align, MAXIMUM_ALIGNOF);
+	m_offset = TYPEALIGN(chunk_align, chunk_buffer->len - con->kds_offset);
+	enlargeStringInfo(chunk_buffer, (m_offset + MAXALIGN(raw_len) -
+									 (chunk_buffer->len - con->kds_offset)));
+	memset(chunk_buffer->data + chunk_buffer->len, 0,
+		   m_offset - (chunk_buffer->len - con->kds_offset));
+	dst = chunk_buffer->data + con->kds_offset + m_offset;
+
+	if (is_raw)
+		memcpy(dst, src, src_len);
+	else if (rb_state->rb_codec == ArrowCompressionType__LZ4_FRAME)
+	{
+#ifdef USE_LZ4
+		LZ4F_decompressionContext_t dctx;
+		size_t		dst_pos = 0;
+		size_t		src_pos = 0;
+		size_t		rv;
+
+		rv = LZ4F_createDecompressionContext(&dctx, LZ4F_VERSION);
+		if (LZ4F_isError(rv))
+			elog(ERROR, "failed on LZ4F_createDecompressionContext: %s",
+				 LZ4F_getErrorName(rv));
+		do {
+			size_t	dst_sz = raw_len - dst_pos;
+			size_t	src_sz = src_len - src_pos;
+
+			rv = LZ4F_decompress(dctx,
+								 dst + dst_pos, &dst_sz,
+								 src + src_pos, &src_sz, NULL);
+			if (LZ4F_isError(rv))
+			{
+				LZ4F_freeDecompressionContext(dctx);
+				elog(ERROR, "arrow_fdw: failed on LZ4F_decompress at '%s': %s",
+					 filename, LZ4F_getErrorName(rv));
+			}
+			dst_pos += dst_sz;
+			src_pos += src_sz;
+			if (dst_sz == 0 && src_sz == 0)
+				break;		/* no progress */
+		} while (rv != 0 && src_pos < src_len);
+		LZ4F_freeDecompressionContext(dctx);
+		if (dst_pos != raw_len)
+			elog(ERROR, "arrow_fdw: LZ4 frame is broken at '%s' (expected %ld bytes, but %zu bytes)",
+				 filename, raw_len, dst_pos);
+#else
+		elog(ERROR, "arrow_fdw: LZ4_FRAME compression is not supported");
+#endif
+	}
+	else if (rb_state->rb_codec == ArrowCompressionType__ZSTD)
+	{
+#ifdef USE_ZSTD
+		size_t		rv = ZSTD_decompress(dst, raw_len, src, src_len);
+
+		if (ZSTD_isError(rv))
+			elog(ERROR, "arrow_fdw: failed on ZSTD_decompress at '%s': %s",
+				 filename, ZSTD_getErrorName(rv));
+		if (rv != raw_len)
+			elog(ERROR, "arrow_fdw: ZSTD data is broken at '%s' (expected %ld bytes, but %zu bytes)",
+				 filename, raw_len, rv);
+#else
+		elog(ERROR, "arrow_fdw: ZSTD compression is not supported");
+#endif
+	}
+	else
+		elog(ERROR, "Bug? unknown compression codec (%d)", (int)rb_state->rb_codec);
+	/* zero clear the padding area */
+	memset(dst + raw_len, 0, MAXALIGN(raw_len) - raw_len);
+	chunk_buffer->len = con->kds_offset + m_offset + MAXALIGN(raw_len);
+
+	*p_cmeta_offset = __kds_packed(m_offset);
+	*p_cmeta_length = __kds_packed(MAXALIGN(raw_len));
+}
+
+static void
+__arrowFdwDecompressField(arrowFdwDecompressContext *con,
+						  RecordBatchFieldState *rb_field,
+						  int cmeta_index)
+{
+	kern_colmeta *cmeta;
+	uint32_t	offset;
+	uint32_t	length;
+
+	/* NOTE: chunk_buffer may be expanded, so we re-compute the KDS */
+#define __KDS_CMETA(index)												\
+	(&((kern_data_store *)(con->chunk_buffer->data +					\
+						   con->kds_offset))->colmeta[(index)])
+	cmeta = __KDS_CMETA(cmeta_index);
+	if (rb_field->nullmap_length > 0)
+	{
+		Assert(rb_field->null_count > 0);
+		__arrowFdwDecompressBuffer(con,
+								   sizeof(int64_t),
+								   rb_field->nullmap_offset,
+								   rb_field->nullmap_length,
+								   &offset, &length);
+		cmeta = __KDS_CMETA(cmeta_index);
+		if (__kds_unpack(length) < BITMAPLEN(rb_field->nitems))
+			elog(ERROR, "nullmap length is smaller than expected");
+		cmeta->nullmap_offset = offset;
+		cmeta->nullmap_length = length;
+	}
+	if (rb_field->values_length > 0)
+	{
+		__arrowFdwDecompressBuffer(con,
+								   rb_field->attopts.align,
+								   rb_field->values_offset,
+								   rb_field->values_length,
+								   &offset, &length);
+		cmeta = __KDS_CMETA(cmeta_index);
+		cmeta->values_offset = offset;
+		cmeta->values_length = length;
+	}
+	if (rb_field->num_variadic > 0)
+	{
+		/*
+		 * variadic buffers of BinaryView/Utf8View are decompressed one by
+		 * one, then the views are adjusted to the offset from the head of
+		 * the first buffer.
+		 */
+		off_t	   *bases = alloca(sizeof(off_t) * rb_field->num_variadic);
+		size_t		extra_head = 0;
+		size_t		extra_tail = 0;
+
+		for (int k=0; k < rb_field->num_variadic; k++)
+		{
+			offset = length = 0;
+			__arrowFdwDecompressBuffer(con,
+									   sizeof(int64_t),
+									   rb_field->variadic_offsets[k],
+									   rb_field->variadic_lengths[k],
+									   &offset, &length);
+			if (length == 0)
+			{
+				bases[k] = 0;	/* empty buffer shall not be referenced */
+				continue;
+			}
+			if (extra_tail == 0)
+				extra_head = __kds_unpack(offset);
+			bases[k] = __kds_unpack(offset) - extra_head;
+			extra_tail = Max(extra_tail, __kds_unpack(offset) + __kds_unpack(length));
+		}
+		cmeta = __KDS_CMETA(cmeta_index);
+		cmeta->extra_offset = __kds_packed(extra_head);
+		cmeta->extra_length = __kds_packed(extra_tail - extra_head);
+		if (rb_field->num_variadic > 1)
+			__arrowFdwRewriteVariadicViews((kern_data_store *)
+										   (con->chunk_buffer->data +
+											con->kds_offset),
+										   cmeta, rb_field, bases);
+	}
+	else if (rb_field->extra_length > 0)
+	{
+		__arrowFdwDecompressBuffer(con,
+								   sizeof(int64_t),
+								   rb_field->extra_offset,
+								   rb_field->extra_length,
+								   &offset, &length);
+		cmeta = __KDS_CMETA(cmeta_index);
+		cmeta->extra_offset = offset;
+		cmeta->extra_length = length;
+	}
+
+	/* nested sub-fields if composite types */
+	if (cmeta->atttypkind == TYPE_KIND__ARRAY ||
+		cmeta->atttypkind == TYPE_KIND__COMPOSITE)
+	{
+		int		idx_subattrs = cmeta->idx_subattrs;
+
+		Assert(rb_field->num_children == cmeta->num_subattrs);
+		for (int j=0; j < rb_field->num_children; j++)
+			__arrowFdwDecompressField(con, &rb_field->children[j],
+									  idx_subattrs + j);
+	}
+#undef __KDS_CMETA
+}
+
+static void
+arrowFdwDecompressRecordBatch(RecordBatchState *rb_state,
+							  Bitmapset *referenced,
+							  StringInfo chunk_buffer,
+							  uint32_t kds_offset)
+{
+	arrowFdwDecompressContext con;
+	kern_data_store *kds;
+	int			ncols;
+
+	memset(&con, 0, sizeof(arrowFdwDecompressContext));
+	con.rb_state = rb_state;
+	con.chunk_buffer = chunk_buffer;
+	con.kds_offset = kds_offset;
+	con.filp = PathNameOpenFile(rb_state->af_state->filename,
+								O_RDONLY | PG_BINARY);
+	if (con.filp < 0)
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not open file \"%s\": %m",
+						rb_state->af_state->filename)));
+	initStringInfo(&con.temp);
+
+	kds = (kern_data_store *)(chunk_buffer->data + kds_offset);
+	Assert(kds->format == KDS_FORMAT_ARROW &&
+		   kds->ncols == rb_state->nfields);
+	ncols = kds->ncols;
+	for (int j=0; j < ncols; j++)
+	{
+		int		attidx = j + 1 - FirstLowInvalidHeapAttributeNumber;
+
+		if (rb_state->fields[j].part_key)
+			continue;	/* see arrowFdwSetupPartitionKeys */
+		if (bms_is_member(attidx, referenced) ||
+			bms_is_member(-FirstLowInvalidHeapAttributeNumber, referenced))
+			__arrowFdwDecompressField(&con, &rb_state->fields[j], j);
+		else
+		{
+			kds = (kern_data_store *)(chunk_buffer->data + kds_offset);
+			kds->colmeta[j].atttypkind = TYPE_KIND__NULL;	/* unreferenced */
+		}
+	}
+	kds = (kern_data_store *)(chunk_buffer->data + kds_offset);
+	kds->length = chunk_buffer->len - kds_offset;
+
+	pfree(con.temp.data);
+	FileClose(con.filp);
+}
+
+/*
+ * Routines to load the parquet row-group
+ *
+ * The column chunks of parquet consist of the encoded (and usually
+ * compressed) pages, so we cannot load them onto the device memory as is.
+ * Like the compressed record-batch, the backend process reads and decodes
+ * the column chunks of the referenced columns, then builds KDS_FORMAT_ARROW
+ * with the Arrow layout inline on the chunk_buffer.
+ */
+static void
+__arrowFdwInlineBuffer(StringInfo chunk_buffer,
+					   uint32_t kds_offset,
+					   uint32_t chunk_align,
+					   StringInfo buf,
+					   uint32_t *p_cmeta_offset,
+					   uint32_t *p_cmeta_length)
+{
+	size_t		m_offset;
+	char	   *dst;
+
+	chunk_align = Max(chunk_align, MAXIMUM_ALIGNOF);
+	m_offset = TYPEALIGN(chunk_align, chunk_buffer->len - kds_offset);
+	enlargeStringInfo(chunk_buffer, (m_offset + MAXALIGN(buf->len) -
+									 (chunk_buffer->len - kds_offset)));
+	memset(chunk_buffer->data + chunk_buffer->len, 0,
+		   m_offset - (chunk_buffer->len - kds_offset));
+	dst = chunk_buffer->data + kds_offset + m_offset;
+	memcpy(dst, buf->data, buf->len);
+	memset(dst + buf->len, 0, MAXALIGN(buf->len) - buf->len);
+	chunk_buffer->len = kds_offset + m_offset + MAXALIGN(buf->len);
+
+	*p_cmeta_offset = __kds_packed(m_offset);
+	*p_cmeta_length = __kds_packed(MAXALIGN(buf->len));
+}
+
+static void
+arrowFdwDecodeParquetRowGroup(RecordBatchState *rb_state,
+							  Bitmapset *referenced,
+							  StringInfo chunk_buffer,
+							  uint32_t kds_offset)
+{
+	const char *filename = rb_state->af_state->filename;
+	kern_data_store *kds;
+	StringInfoData raw;
+	StringInfoData nullmap;
+	StringInfoData values;
+	StringInfoData extra;
+	File		filp;
+
+	filp = PathNameOpenFile(filename, O_RDONLY | PG_BINARY);
+	if (filp < 0)
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not open file \"%s\": %m", filename)));
+	initStringInfo(&raw);
+	initStringInfo(&nullmap);
+	initStringInfo(&values);
+	initStringInfo(&extra);
+
+	kds = (kern_data_store *)(chunk_buffer->data + kds_offset);
+	Assert(kds->format == KDS_FORMAT_ARROW &&
+		   kds->ncols == rb_state->nfields);
+	for (int j=0; j < rb_state->nfields; j++)
+	{
+		RecordBatchFieldState *rb_field = &rb_state->fields[j];
+		int			attidx = j + 1 - FirstLowInvalidHeapAttributeNumber;
+		off_t		f_pos = rb_field->values_offset;
+		int64_t		null_count;
+		uint32_t	offset;
+		uint32_t	length;
+
+		if (rb_field->part_key)
+			continue;	/* see arrowFdwSetupPartitionKeys */
+		kds = (kern_data_store *)(chunk_buffer->data + kds_offset);
+		if (!bms_is_member(attidx, referenced) &&
+			!bms_is_member(-FirstLowInvalidHeapAttributeNumber, referenced))
+		{
+			kds->colmeta[j].atttypkind = TYPE_KIND__NULL;	/* unreferenced */
+			continue;
+		}
+		/* read the column chunk */
+		resetStringInfo(&raw);
+		enlargeStringInfo(&raw, rb_field->values_length);
+		while (raw.len < rb_field->values_length)
+		{
+			ssize_t		sz;
+
+			CHECK_FOR_INTERRUPTS();
+
+			sz = FileRead(filp,
+						  raw.data + raw.len,
+						  rb_field->values_length - raw.len,
+						  f_pos + raw.len,
+						  WAIT_EVENT_DATA_FILE_READ);
+			if (sz > 0)
+				raw.len += sz;
+			else if (sz == 0)
+				elog(ERROR, "arrow_fdw: unexpected EOF at '%s' (pos=%lu)",
+					 filename, f_pos + raw.len);
+			else if (errno != EINTR)
+				elog(ERROR, "failed on FileRead('%s', pos=%lu, len=%lu): %m",
+					 filename, f_pos + raw.len, rb_field->values_length - raw.len);
+		}
+		parquetDecodeColumnChunk(rb_field->pq_chunk,
+								 &rb_field->attopts,
+								 raw.data, raw.len,
+								 rb_state->rb_nitems,
+								 &nullmap,
+								 &values,
+								 &extra,
+								 &null_count,
+								 filename);
+		/* NOTE: chunk_buffer may be expanded, so we re-compute the KDS */
+		if (null_count > 0)
+		{
+			__arrowFdwInlineBuffer(chunk_buffer, kds_offset,
+								   sizeof(int64_t), &nullmap,
+								   &offset, &length);
+			kds = (kern_data_store *)(chunk_buffer->data + kds_offset);
+			kds->colmeta[j].nullmap_offset = offset;
+			kds->colmeta[j].nullmap_length = length;
+		}
+		if (values.len > 0)
+		{
+			__arrowFdwInlineBuffer(chunk_buffer, kds_offset,
+								   rb_field->attopts.align, &values,
+								   &offset, &length);
+			kds = (kern_data_store *)(chunk_buffer->data + kds_offset);
+			kds->colmeta[j].values_offset = offset;
+			kds->colmeta[j].values_length = length;
+		}
+		if (extra.len > 0)
+		{
+			__arrowFdwInlineBuffer(chunk_buffer, kds_offset,
+								   sizeof(int64_t), &extra,
+								   &offset, &length);
+			kds = (kern_data_store *)(chunk_buffer->data + kds_offset);
+			kds->colmeta[j].extra_offset = offset;
+			kds->colmeta[j].extra_length = length;
+		}
+	}
+	kds = (kern_data_store *)(chunk_buffer->data + kds_offset);
+	kds->length = chunk_buffer->len - kds_offset;
+
+	pfree(raw.data);
+	pfree(nullmap.data);
+	pfree(values.data);
+	pfree(extra.data);
+	FileClose(filp);
+}
+
+/*
+ * arrowFdwReadIOvector
+ *
+ * It reads the i/o chunks of the KDS (ARROW format) using the regular
+ * filesystem API, instead of GPU-Direct.
+ */
+static void
+arrowFdwReadIOvector(const char *filename,
+					 strom_io_vector *iovec,
+					 StringInfo chunk_buffer,
+					 uint32_t kds_offset)
+{
+	kern_data_store	*kds;
+	char	   *base;
+	File		filp;
+
+	kds = (kern_data_store *)(chunk_buffer->data + kds_offset);
+	enlargeStringInfo(chunk_buffer, kds->length);
+	kds = (kern_data_store *)(chunk_buffer->data + kds_offset);
+	filp = PathNameOpenFile(filename, O_RDONLY | PG_BINARY);
+	if (filp < 0)
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not open file \"%s\": %m", filename)));
+	base = (char *)kds + KDS_HEAD_LENGTH(kds);
+	for (int i=0; i < iovec->nr_chunks; i++)
+	{
+		strom_io_chunk *ioc = &iovec->ioc[i];
+		char	   *dest = base + ioc->m_offset;
+		off_t		f_pos = (size_t)ioc->fchunk_id * PAGE_SIZE;
+		size_t		len = (size_t)ioc->nr_pages * PAGE_SIZE;
+		ssize_t		sz;
+
+		while (len > 0)
+		{
+			CHECK_FOR_INTERRUPTS();
+
+			sz = FileRead(filp, dest, len, f_pos,
+						  WAIT_EVENT_DATA_FILE_READ);
+			if (sz > 0)
+			{
+				Assert(sz <= len);
+				dest  += sz;
+				f_pos += sz;
+				len   -= sz;
+			}
+			else if (sz == 0)
+			{
+				/*
+				 * Due to the page_sz alignment, we may try to read the file
+				 * over its tail. So, pread(2) may tell us unable to read
+				 * any more. The expected scenario happend only when remained
+				 * length is less than PAGE_SIZE.
+				 */
+				memset(dest, 0, len);
+				break;
+			}
+			else if (errno != EINTR)
+			{
+				assert(false);
+				elog(ERROR, "failed on FileRead('%s', pos=%lu, len=%lu): %m",
+					 filename, f_pos, len);
+			}
+		}
+	}
+	chunk_buffer->len = kds_offset + kds->length;
+	FileClose(filp);
+}
+
+/*
+ * Routines to setup the partition keys
+ *
+ * The partition keys are constant per file, so the backend process builds
+ * the values buffers of the referenced partition keys inline. Once a partition
+ * key is referenced, the KDS must be built inline on the chunk_buffer.
+ */
+static bool
+arrowFdwPartitionKeysReferenced(RecordBatchState *rb_state,
+								Bitmapset *referenced)
+{
+	for (int j=0; j < rb_state->nfields; j++)
+	{
+		int		attidx = j + 1 - FirstLowInvalidHeapAttributeNumber;
+
+		if (rb_state->fields[j].part_key &&
+			(bms_is_member(attidx, referenced) ||
+			 bms_is_member(-FirstLowInvalidHeapAttributeNumber, referenced)))
+			return true;
+	}
+	return false;
+}
+
+static void
+arrowFdwSetupPartitionKeys(RecordBatchState *rb_state,
+						   Bitmapset *referenced,
+						   StringInfo chunk_buffer,
+						   uint32_t kds_offset)
+{
+	kern_data_store *kds;
+	StringInfoData	values;
+	StringInfoData	extra;
+	uint32_t	nitems;
+	uint32_t	offset;
+	uint32_t	length;
+
+	initStringInfo(&values);
+	initStringInfo(&extra);
+	for (int j=0; j < rb_state->nfields; j++)
+	{
+		RecordBatchFieldState *rb_field = &rb_state->fields[j];
+		int			attidx = j + 1 - FirstLowInvalidHeapAttributeNumber;
+		bool		isnull = rb_field->stat_datum.isnull;
+		Datum		datum = rb_field->stat_datum.min.datum;
+
+		if (!rb_field->part_key)
+			continue;
+		kds = (kern_data_store *)(chunk_buffer->data + kds_offset);
+		if (!bms_is_member(attidx, referenced) &&
+			!bms_is_member(-FirstLowInvalidHeapAttributeNumber, referenced))
+		{
+			kds->colmeta[j].atttypkind = TYPE_KIND__NULL;	/* unreferenced */
+			continue;
+		}
+		/* KDS must be built inline */
+		Assert(chunk_buffer->len == kds_offset + kds->length);
+		nitems = kds->nitems;
+		resetStringInfo(&values);
+		resetStringInfo(&extra);
+		if (rb_field->attopts.tag == ArrowType__Utf8)
+		{
+			uint32_t	len = (isnull ? 0 : VARSIZE_ANY_EXHDR(datum));
+
+			if ((uint64_t)len * (uint64_t)nitems >= UINT32_MAX)
+				elog(ERROR, "arrow_fdw: partition key is too large at '%s'",
+					 rb_state->af_state->filename);
+			enlargeStringInfo(&values, sizeof(uint32_t) * (nitems + 1));
+			for (uint32_t i=0; i <= nitems; i++)
+				((uint32_t *)values.data)[i] = i * len;
+			values.len = sizeof(uint32_t) * (nitems + 1);
+			if (len > 0)
+			{
+				enlargeStringInfo(&extra, len * nitems);
+				for (uint32_t i=0; i < nitems; i++)
+					appendBinaryStringInfo(&extra, VARDATA_ANY(datum), len);
+			}
+		}
+		else
+		{
+			int		unitsz = rb_field->attopts.unitsz;
+			union {
+				int16	i16;
+				int32	i32;
+				int64	i64;
+				float4	fp32;
+				float8	fp64;
+			} temp;
+
+			Assert(unitsz > 0 && unitsz <= sizeof(temp));
+			memset(&temp, 0, sizeof(temp));
+			if (!isnull)
+			{
+				switch (rb_field->atttypid)
+				{
+					case INT2OID:
+						temp.i16 = DatumGetInt16(datum);
+						break;
+					case INT4OID:
+						temp.i32 = DatumGetInt32(datum);
+						break;
+					case INT8OID:
+						temp.i64 = DatumGetInt64(datum);
+						break;
+					case FLOAT4OID:
+						temp.fp32 = DatumGetFloat4(datum);
+						break;
+					case FLOAT8OID:
+						temp.fp64 = DatumGetFloat8(datum);
+						break;
+					case DATEOID:
+						/* PostgreSQL epoch to UNIX epoch */
+						temp.i32 = (DatumGetDateADT(datum) +
+									(POSTGRES_EPOCH_JDATE - UNIX_EPOCH_JDATE));
+						break;
+					default:
+						elog(ERROR, "Bug? unexpected partition key type (%s)",
+							 format_type_be(rb_field->atttypid));
+				}
+			}
+			enlargeStringInfo(&values, unitsz * nitems);
+			for (uint32_t i=0; i < nitems; i++)
+				appendBinaryStringInfo(&values, (char *)&temp, unitsz);
+		}
+		/* NOTE: chunk_buffer may be expanded, so we re-compute the KDS */
+		if (isnull)
+		{
+			StringInfoData	nullmap;
+
+			initStringInfo(&nullmap);
+			enlargeStringInfo(&nullmap, BITMAPLEN(nitems));
+			memset(nullmap.data, 0, BITMAPLEN(nitems));
+			nullmap.len = BITMAPLEN(nitems);
+			__arrowFdwInlineBuffer(chunk_buffer, kds_offset,
+								   sizeof(int64_t), &nullmap,
+								   &offset, &length);
+			kds = (kern_data_store *)(chunk_buffer->data + kds_offset);
+			kds->colmeta[j].nullmap_offset = offset;
+			kds->colmeta[j].nullmap_length = length;
+			pfree(nullmap.data);
+		}
+		if (values.len > 0)
+		{
+			__arrowFdwInlineBuffer(chunk_buffer, kds_offset,
+								   rb_field->attopts.align, &values,
+								   &offset, &length);
+			kds = (kern_data_store *)(chunk_buffer->data + kds_offset);
+			kds->colmeta[j].values_offset = offset;
+			kds->colmeta[j].values_length = length;
+		}
+		if (extra.len > 0)
+		{
+			__arrowFdwInlineBuffer(chunk_buffer, kds_offset,
+								   sizeof(int64_t), &extra,
+								   &offset, &length);
+			kds = (kern_data_store *)(chunk_buffer->data + kds_offset);
+			kds->colmeta[j].extra_offset = offset;
+			kds->colmeta[j].extra_length = length;
+		}
+		kds = (kern_data_store *)(chunk_buffer->data + kds_offset);
+		kds->length = chunk_buffer->len - kds_offset;
+	}
+	pfree(values.data);
+	pfree(extra.data);
+}
+
+/*
+ * arrowFdwObjStoreFetchRecordBatch
+ *
+ * If the record-batch is on the local cache of object storage, it fetches
+ * the buffers of the referenced columns (or, prefetches if !wait).
+ */
+typedef struct
+{
+	int			nitems;
+	int			nrooms;
+	off_t	   *offsets;
+	size_t	   *lengths;
+} arrowObjStoreRanges;
+
+static void
+__arrowObjStoreAddRange(arrowObjStoreRanges *ranges, off_t offset, size_t length)
+{
+	off_t		head = PAGE_ALIGN_DOWN(offset);
+	off_t		tail = PAGE_ALIGN(offset + length);
+
+	if (length == 0)
+		return;
+	if (ranges->nitems >= ranges->nrooms)
+	{
+		ranges->nrooms = 2 * ranges->nrooms + 20;
+		ranges->offsets = repalloc(ranges->offsets, sizeof(off_t) * ranges->nrooms);
+		ranges->lengths = repalloc(ranges->lengths, sizeof(size_t) * ranges->nrooms);
+	}
+	ranges->offsets[ranges->nitems] = head;
+	ranges->lengths[ranges->nitems] = tail - head;
+	ranges->nitems++;
+}
+
+static void
+__arrowObjStoreAddFieldRanges(arrowObjStoreRanges *ranges, off_t rb_offset,
+							  RecordBatchFieldState *rb_field)
+{
+	if (rb_field->null_count > 0)
+		__arrowObjStoreAddRange(ranges, rb_offset + rb_field->nullmap_offset,
+								rb_field->nullmap_length);
+	__arrowObjStoreAddRange(ranges, rb_offset + rb_field->values_offset,
+							rb_field->values_length);
+	__arrowObjStoreAddRange(ranges, rb_offset + rb_field->extra_offset,
+							rb_field->extra_length);
+	for (int j=0; j < rb_field->num_children; j++)
+		__arrowObjStoreAddFieldRanges(ranges, rb_offset, &rb_field->children[j]);
+}
+
+static void
+arrowFdwObjStoreFetchRecordBatch(RecordBatchState *rb_state,
+								 Bitmapset *referenced,
+								 bool wait)
+{
+	const char *filename = rb_state->af_state->filename;
+	arrowObjStoreRanges ranges;
+
+	if (!pgstromObjStoreIsCacheFile(filename))
+		return;
+	memset(&ranges, 0, sizeof(arrowObjStoreRanges));
+	ranges.nrooms = 20;
+	ranges.offsets = palloc(sizeof(off_t) * ranges.nrooms);
+	ranges.lengths = palloc(sizeof(size_t) * ranges.nrooms);
+	if (rb_state->rb_compressed)
+	{
+		/* decompression reads the whole record-batch */
+		__arrowObjStoreAddRange(&ranges, rb_state->rb_offset, rb_state->rb_length);
+	}
+	else
+	{
+		for (int j=0; j < rb_state->nfields; j++)
+		{
+			RecordBatchFieldState *rb_field = &rb_state->fields[j];
+			int		attidx = j + 1 - FirstLowInvalidHeapAttributeNumber;
+
+			if (rb_field->part_key)
+				continue;
+			if (bms_is_member(attidx, referenced) ||
+				bms_is_member(-FirstLowInvalidHeapAttributeNumber, referenced))
+				__arrowObjStoreAddFieldRanges(&ranges, rb_state->rb_offset, rb_field);
+		}
+	}
+	if (ranges.nitems > 0)
+		pgstromObjStoreFetchRanges(filename,
+								   ranges.nitems,
+								   ranges.offsets,
+								   ranges.lengths,
+								   wait);
+	pfree(ranges.offsets);
+	pfree(ranges.lengths);
+}
+
+static strom_io_vector *
+arrowFdwLoadRecordBatch(Relation relation,
+						Bitmapset *referenced,
+						RecordBatchState *rb_state,
+						StringInfo chunk_buffer,
+						uint32_t row_start,
+						uint32_t row_count)
+{
+	TupleDesc	tupdesc = RelationGetDescr(relation);
+	size_t		head_sz = estimate_kern_data_store(tupdesc);
+	kern_data_store *kds;
+	strom_io_vector *iovec;
+	uint32_t	kds_offset;
+
+	/* setup KDS and I/O-vector */
+	enlargeStringInfo(chunk_buffer, head_sz);
+	kds = (kern_data_store *)(chunk_buffer->data +
+							  chunk_buffer->len);
+	setup_kern_data_store(kds, tupdesc, 0, KDS_FORMAT_ARROW);
+	kds->nitems = row_count;
+	kds->table_oid = RelationGetRelid(relation);
+	Assert(kds->ncols == rb_state->nfields);
+	for (int j=0; j < kds->ncols; j++)
+		__arrowKdsAssignAttrOptions(kds,
+									&kds->colmeta[j],
+									&rb_state->fields[j]);
+	chunk_buffer->len += head_sz;
+
+	kds_offset = (char *)kds - chunk_buffer->data;
+	arrowFdwObjStoreFetchRecordBatch(rb_state, referenced, true);
+	if (rb_state->rb_parquet)
+	{
+		/* KDS is built inline, like the compressed record-batch */
+		Assert(row_start == 0 && row_count == rb_state->rb_nitems);
+		arrowFdwDecodeParquetRowGroup(rb_state,
+									  referenced,
+									  chunk_buffer,
+									  kds_offset);
+		arrowFdwSetupPartitionKeys(rb_state, referenced,
+								   chunk_buffer, kds_offset);
+		return palloc0(offsetof(strom_io_vector, ioc[0]));
+	}
+	if (rb_state->rb_compressed)
+	{
+		/* KDS is built inline, so no i/o chunks are needed */
+		Assert(row_start == 0 && row_count == rb_state->rb_nitems);
+		arrowFdwDecompressRecordBatch(rb_state,
+									  referenced,
+									  chunk_buffer,
+									  kds_offset);
+		arrowFdwSetupPartitionKeys(rb_state, referenced,
+								   chunk_buffer, kds_offset);
+		return palloc0(offsetof(strom_io_vector, ioc[0]));
+	}
+	iovec = arrowFdwSetupIOvector(rb_state, referenced, kds,
+								  row_start, row_count);
+	if (arrowFdwVariadicViewsReferenced(rb_state, referenced))
+	{
+		/*
+		 * Views with multiple variadic buffers are rewritten on the host,
+		 * so the referenced buffers are read to the chunk_buffer.
+		 */
+		arrowFdwReadIOvector(rb_state->af_state->filename, iovec,
+							 chunk_buffer, kds_offset);
+		pfree(iovec);
+		iovec = palloc0(offsetof(strom_io_vector, ioc[0]));
+		arrowFdwNormalizeVariadicViews(rb_state, referenced,
+									   (kern_data_store *)
+									   (chunk_buffer->data + kds_offset));
+	}
+	else if (arrowFdwPartitionKeysReferenced(rb_state, referenced))
+	{
+		/*
+		 * The constant values of the partition keys are built on the host,
+		 * so the referenced buffers are also read to the chunk_buffer.
+		 */
+		arrowFdwReadIOvector(rb_state->af_state->filename, iovec,
+							 chunk_buffer, kds_offset);
+		pfree(iovec);
+		iovec = palloc0(offsetof(strom_io_vector, ioc[0]));
+	}
+	arrowFdwSetupPartitionKeys(rb_state, referenced,
+							   chunk_buffer, kds_offset);
+	return iovec;
+}
+
+static kern_data_store *
+arrowFdwFillupRecordBatch(Relation relation,
+						  Bitmapset *referenced,
+						  RecordBatchState *rb_state,
+						  StringInfo chunk_buffer)
+{
+	strom_io_vector	*iovec;
+
+	resetStringInfo(chunk_buffer);
+	iovec = arrowFdwLoadRecordBatch(relation,
+									referenced,
+									rb_state,
+									chunk_buffer,
+									0, rb_state->rb_nitems);
+	if (iovec->nr_chunks > 0)
+		arrowFdwReadIOvector(rb_state->af_state->filename, iovec,
+							 chunk_buffer, 0);
+	/* elsewhere, already built inline on the chunk_buffer */
+	pfree(iovec);
+
+	return (kern_data_store *)chunk_buffer->data;
+}
+
+/*
+ * ArrowGetForeignRelSize
+ */
+static size_t
+__recordBatchFieldLength(RecordBatchFieldState *rb_field)
+{
+	size_t		len = 0;
+
+	if (rb_field->null_count > 0)
+		len += rb_field->nullmap_length;
+	len += (rb_field->values_length +
+			rb_field->extra_length);
+	for (int j=0; j < rb_field->num_children; j++)
+		len += __recordBatchFieldLength(&rb_field->children[j]);
+	return len;
+}
+
+static void
+ArrowGetForeignRelSize(PlannerInfo *root,
+					   RelOptInfo *baserel,
+					   Oid foreigntableid)
+{
+	ForeignTable   *ft = GetForeignTable(foreigntableid);
+	Relation		frel = table_open(foreigntableid, NoLock);
+	List		   *filesList;
+	List		   *results = NIL;
+	Bitmapset	   *referenced = NULL;
+	arrowManifestCache *manifest;
+	ListCell	   *lc1, *lc2;
+	size_t			totalLen = 0;
+	double			ntuples = 0.0;
+	int				parallel_nworkers;
+	bool			hive_partitioning;
+
+	/* columns to be referenced */
+	foreach (lc1, baserel->baserestrictinfo)
+	{
+		RestrictInfo   *rinfo = lfirst(lc1);
+
+		pull_varattnos((Node *)rinfo->clause, baserel->relid, &referenced);
+	}
+	referenced = pickup_outer_referenced(root, baserel, referenced);
+
+	/* read arrow-file metadta */
+	filesList = arrowFdwExtractFilesList(ft->options,
+										 &parallel_nworkers,
+										 &hive_partitioning);
+	manifest = arrowFdwLookupManifest(ft->options);
+	foreach (lc1, filesList)
+	{
+		ArrowFileState *af_state;
+		char	   *fname = strVal(lfirst(lc1));
+
+		/* partition pruning prior to read the file footer */
+		if (hive_partitioning &&
+			__arrowFdwPartitionIsRefuted(frel, fname,
+										 baserel->baserestrictinfo,
+										 baserel->relid))
+			continue;
+		if (manifest &&
+			__arrowFdwManifestIsRefuted(manifest, frel, fname,
+										baserel->baserestrictinfo,
+										baserel->relid))
+			continue;
+		af_state = BuildArrowFileState(frel, fname, hive_partitioning, NULL);
+		if (!af_state)
+			continue;
+
+		/*
+		 * Size calculation based the record-batch metadata
+		 */
+		foreach (lc2, af_state->rb_list)
+		{
+			RecordBatchState *rb_state = lfirst(lc2);
+
+			/* whole-row reference? */
+			if (bms_is_member(-FirstLowInvalidHeapAttributeNumber, referenced))
+			{
+				totalLen += rb_state->rb_length;
+			}
+			else
+			{
+				int		j, k;
+
+				for (k = bms_next_member(referenced, -1);
+					 k >= 0;
+					 k = bms_next_member(referenced, k))
+				{
+					j = k + FirstLowInvalidHeapAttributeNumber;
+					if (j <= 0 || j > rb_state->nfields)
+						continue;
+					totalLen += __recordBatchFieldLength(&rb_state->fields[j-1]);
+				}
+			}
+			ntuples += rb_state->rb_nitems;
+		}
+		results = lappend(results, af_state);
+	}
+	table_close(frel, NoLock);
+
+	/* setup baserel */
+	baserel->rel_parallel_workers = parallel_nworkers;
+	baserel->fdw_private = list_make2(results, referenced);
+	baserel->pages = totalLen / BLCKSZ;
+	baserel->tuples = ntuples;
+	baserel->rows = ntuples *
+		clauselist_selectivity(root,
+							   baserel->baserestrictinfo,
+							   0,
+							   JOIN_INNER,
+							   NULL);
+}
+
+/*
+ * cost_arrow_fdw_seqscan
+ */
+static void
+cost_arrow_fdw_seqscan(Path *path,
+					   PlannerInfo *root,
+					   RelOptInfo *baserel,
+					   ParamPathInfo *param_info,
+					   int num_workers)
+{
+	Cost		startup_cost = 0.0;
+	Cost		disk_run_cost = 0.0;
+	Cost		cpu_run_cost = 0.0;
+	QualCost	qcost;
+	double		nrows;
+	double		spc_seq_page_cost;
+
+	if (param_info)
+		nrows = param_info->ppi_rows;
+	else
+		nrows = baserel->rows;
+
+	/* arrow_fdw.enabled */
+	if (!arrow_fdw_enabled)
+		startup_cost += disable_cost;
+
+	/*
+	 * Storage costs
+	 *
+	 * XXX - smaller number of columns to read shall have less disk cost
+	 * because of columnar format. Right now, we don't discount cost for
+	 * the pages not to be read.
+	 */
+	get_tablespace_page_costs(baserel->reltablespace,
+							  NULL,
+							  &spc_seq_page_cost);
+	disk_run_cost = spc_seq_page_cost * baserel->pages;
+
+	/* CPU costs */
+	if (param_info)
+	{
+		cost_qual_eval(&qcost, param_info->ppi_clauses, root);
+		qcost.startup += baserel->baserestrictcost.startup;
+        qcost.per_tuple += baserel->baserestrictcost.per_tuple;
+	}
+	else
+		qcost = baserel->baserestrictcost;
+	startup_cost += qcost.startup;
+	cpu_run_cost = (cpu_tuple_cost + qcost.per_tuple) * baserel->tuples;
+
+	/* tlist evaluation costs */
+	startup_cost += path->pathtarget->cost.startup;
+	cpu_run_cost += path->pathtarget->cost.per_tuple * path->rows;
+
+	/* adjust cost for CPU parallelism */
+	if (num_workers > 0)
+	{
+		double		leader_contribution;
+		double		parallel_divisor = (double) num_workers;
+
+		/* see get_parallel_divisor() */
+		leader_contribution = 1.0 - (0.3 * (double)num_workers);
+		parallel_divisor += Max(leader_contribution, 0.0);
+
+		/* The CPU cost is divided among all the workers. */
+		cpu_run_cost /= parallel_divisor;
+
+		/* Estimated row count per background worker process */
+		nrows = clamp_row_est(nrows / parallel_divisor);
+	}
+	path->rows = nrows;
+	path->startup_cost = startup_cost;
+	path->total_cost = startup_cost + cpu_run_cost + disk_run_cost;
+	path->parallel_workers = num_workers;
+}
+
+/*
+ * ArrowGetForeignPaths
+ */
+static void
+ArrowGetForeignPaths(PlannerInfo *root,
+                     RelOptInfo *baserel,
+                     Oid foreigntableid)
+{
+	ForeignPath	   *fpath;
+	ParamPathInfo  *param_info;
+	Relids			required_outer = baserel->lateral_relids;
+
+	param_info = get_baserel_parampathinfo(root, baserel, required_outer);
+	fpath = create_foreignscan_path(root,
+									baserel,
+									NULL,	/* default pathtarget */
+									-1.0,	/* dummy */
+									-1.0,	/* dummy */
+									-1.0,	/* dummy */
+									NIL,	/* no pathkeys */
+									required_outer,
+									NULL,	/* no extra plan */
+									NIL);	/* no particular private */
+	cost_arrow_fdw_seqscan(&fpath->path,
+						   root,
+						   baserel,
+						   param_info, 0);
+	add_path(baserel, &fpath->path);
+
+	if (baserel->consider_parallel)
+	{
+		int		num_workers =
+			compute_parallel_worker(baserel,
+									baserel->pages, -1.0,
+									max_parallel_workers_per_gather);
+		if (num_workers == 0)
+			return;
+
+		fpath = create_foreignscan_path(root,
+										baserel,
+										NULL,	/* default pathtarget */
+										-1.0,	/* dummy */
+										-1.0,	/* dummy */
+										-1.0,	/* dummy */
+										NIL,	/* no pathkeys */
+										required_outer,
+										NULL,	/* no extra plan */
+										NIL);	/* no particular private */
+		fpath->path.parallel_aware = true;
+		cost_arrow_fdw_seqscan(&fpath->path,
+							   root,
+							   baserel,
+							   param_info,
+							   num_workers);
+		add_partial_path(baserel, (Path *)fpath);
+	}
+}
+
+/*
+ * ArrowGetForeignPlan
+ */
+static ForeignScan *
+ArrowGetForeignPlan(PlannerInfo *root,
+					RelOptInfo *baserel,
+					Oid foreigntableid,
+					ForeignPath *best_path,
+					List *tlist,
+					List *scan_clauses,
+					Plan *outer_plan)
+{
+	Bitmapset  *referenced = lsecond(baserel->fdw_private);
+	List	   *ref_list = NIL;
+	int			k;
+
+	for (k = bms_next_member(referenced, -1);
+		 k >= 0;
+		 k = bms_next_member(referenced, k))
+	{
+		ref_list = lappend_int(ref_list, k);
+	}
+	return make_foreignscan(tlist,
+							extract_actual_clauses(scan_clauses, false),
+							baserel->relid,
+							NIL,	/* no expressions to evaluate */
+							ref_list, /* list of referenced attnums */
+							NIL,	/* no custom tlist */
+							NIL,	/* no remote quals */
+							outer_plan);
+}
+
+/* ----------------------------------------------------------------
+ *
+ * Routines related to Arrow datum fetch
+ *
+ * ----------------------------------------------------------------
+ */
+static void		pg_datum_arrow_ref(kern_data_store *kds,
+								   kern_colmeta *cmeta,
+								   size_t index,
+								   Datum *p_datum,
+								   bool *p_isnull);
+static Datum
+pg_varlena32_arrow_ref(kern_data_store *kds,
+					   kern_colmeta *cmeta,
+					   size_t index, bool *p_isnull)
+{
+	struct varlena *res = NULL;
+	const void *addr;
+	int			length;
+
+	addr = KDS_ARROW_REF_VARLENA32_DATUM(kds, cmeta, index, &length);
+	if (!addr)
+		*p_isnull = true;
+	else
+	{
+		*p_isnull = false;
+		res = palloc(VARHDRSZ + length);
+		memcpy(res->vl_dat, addr, length);
+		SET_VARSIZE(res, VARHDRSZ + length);
+	}
+	return PointerGetDatum(res);
+}
+
+static Datum
+pg_varlena_view_arrow_ref(kern_data_store *kds,
+						  kern_colmeta *cmeta,
+						  size_t index, bool *p_isnull)
+{
+	struct varlena *res = NULL;
+	const void *addr;
+	int			length;
+
+	addr = KDS_ARROW_REF_VIEW_DATUM(kds, cmeta, index, &length);
+	if (!addr)
+		*p_isnull = true;
+	else
+	{
+		*p_isnull = false;
+		res = palloc(VARHDRSZ + length);
+		memcpy(res->vl_dat, addr, length);
+		SET_VARSIZE(res, VARHDRSZ + length);
+	}
+	return PointerGetDatum(res);
+}
+
+static Datum
+pg_varlena64_arrow_ref(kern_data_store *kds,
+					   kern_colmeta *cmeta,
+					   size_t index, bool *p_isnull)
+{
+	struct varlena *res = NULL;
+	const void *addr;
+	int			length;
+
+	addr = KDS_ARROW_REF_VARLENA64_DATUM(kds, cmeta, index, &length);
+	if (!addr)
+		*p_isnull = true;
+	else
+	{
+		*p_isnull = false;
+		res = palloc(VARHDRSZ + length);
+		memcpy(res->vl_dat, addr, length);
+		SET_VARSIZE(res, VARHDRSZ + length);
+	}
+	return PointerGetDatum(res);
+}
+
+static Datum
+pg_bpchar_arrow_ref(kern_data_store *kds,
+					kern_colmeta *cmeta, size_t index)
+{
+	char	   *values = ((char *)kds + __kds_unpack(cmeta->values_offset));
+	size_t		length = __kds_unpack(cmeta->values_length);
+	int32_t		unitsz = cmeta->attopts.fixed_size_binary.byteWidth;
+	struct varlena *res;
+
+	if (unitsz <= 0)
+		elog(ERROR, "CHAR(%d) is not expected", unitsz);
+	if (unitsz * index >= length)
+		elog(ERROR, "corruption? bpchar points out of range");
+	res = palloc(VARHDRSZ + unitsz);
+	memcpy((char *)res + VARHDRSZ, values + unitsz * index, unitsz);
+	SET_VARSIZE(res, VARHDRSZ + unitsz);
+
+	return PointerGetDatum(res);
+}
+
+static Datum
+pg_bool_arrow_ref(kern_data_store *kds,
+				  kern_colmeta *cmeta, size_t index)
+{
+	uint8_t	   *bitmap = (uint8_t *)kds + __kds_unpack(cmeta->values_offset);
+	size_t		length = __kds_unpack(cmeta->values_length);
+	bool		rv;
+
+	if (sizeof(uint8_t) * (index>>3) >= length)
+		elog(ERROR, "corruption? bool points out of range");
+	rv = ((bitmap[index>>3] & (1<<(index&7))) != 0);
+	return BoolGetDatum(rv);
+}
+
+static Datum
+pg_simple_arrow_ref(kern_data_store *kds,
+					kern_colmeta *cmeta, size_t index)
+{
+	int32_t		unitsz = cmeta->attopts.unitsz;
+	char	   *values = (char *)kds + __kds_unpack(cmeta->values_offset);
+	size_t		length = __kds_unpack(cmeta->values_length);
+	Datum		retval = 0;
+
+	Assert(unitsz > 0 && unitsz <= sizeof(Datum));
+	if (unitsz * index >= length)
+		elog(ERROR, "corruption? simple int8 points out of range");
+	memcpy(&retval, values + unitsz * index, unitsz);
+	return retval;
+}
+
+static Datum
+pg_numeric_arrow_ref(kern_data_store *kds,
+					 kern_colmeta *cmeta, size_t index)
+{
+	char	   *result = palloc0(sizeof(struct NumericData));
+	char	   *base = (char *)kds + __kds_unpack(cmeta->values_offset);
+	size_t		length = __kds_unpack(cmeta->values_length);
+	int			dscale = cmeta->attopts.decimal.scale;
+	int128_t	ival;
+
+	if (sizeof(int128_t) * index >= length)
+		elog(ERROR, "corruption? numeric points out of range");
+	ival = ((int128_t *)base)[index];
+	__xpu_numeric_to_varlena(result, dscale, ival);
+
+	return PointerGetDatum(result);
+}
+
+static Datum
+pg_date_arrow_ref(kern_data_store *kds,
+				  kern_colmeta *cmeta, size_t index)
+{
+	char	   *base = (char *)kds + __kds_unpack(cmeta->values_offset);
+	size_t		length = __kds_unpack(cmeta->values_length);
+	DateADT		dt;
+
+	switch (cmeta->attopts.date.unit)
+	{
+		case ArrowDateUnit__Day:
+			if (sizeof(uint32) * index >= length)
+				elog(ERROR, "corruption? Date[day] points out of range");
+			dt = ((uint32 *)base)[index];
+			break;
+		case ArrowDateUnit__MilliSecond:
+			if (sizeof(uint64) * index >= length)
+				elog(ERROR, "corruption? Date[ms] points out of range");
+			dt = ((uint64 *)base)[index] / 1000;
+			break;
+		default:
+			elog(ERROR, "Bug? unexpected unit of Date type");
+	}
+	/* convert UNIX epoch to PostgreSQL epoch */
+	dt -= (POSTGRES_EPOCH_JDATE - UNIX_EPOCH_JDATE);
+	return DateADTGetDatum(dt);
+}
+
+static Datum
+pg_time_arrow_ref(kern_data_store *kds,
+				  kern_colmeta *cmeta, size_t index)
+{
+	char	   *base = (char *)kds + __kds_unpack(cmeta->values_offset);
+	size_t		length = __kds_unpack(cmeta->values_length);
+	TimeADT		tm;
+
+	switch (cmeta->attopts.time.unit)
+	{
+		case ArrowTimeUnit__Second:
+			if (sizeof(uint32) * index >= length)
+				elog(ERROR, "corruption? Time[sec] points out of range");
+			tm = ((uint32 *)base)[index] * 1000000L;
+			break;
+		case ArrowTimeUnit__MilliSecond:
+			if (sizeof(uint32) * index >= length)
+				elog(ERROR, "corruption? Time[ms] points out of range");
+			tm = ((uint32 *)base)[index] * 1000L;
+			break;
+		case ArrowTimeUnit__MicroSecond:
+			if (sizeof(uint64) * index >= length)
+				elog(ERROR, "corruption? Time[us] points out of range");
+			tm = ((uint64 *)base)[index];
+			break;
+		case ArrowTimeUnit__NanoSecond:
+			if (sizeof(uint64) * index >= length)
+				elog(ERROR, "corruption? Time[ns] points out of range");
+			tm = ((uint64 *)base)[index] / 1000L;
+			break;
+		default:
+			elog(ERROR, "Bug? unexpected unit of Time type");
+			break;
+	}
+	return TimeADTGetDatum(tm);
+}
+
+static Datum
+pg_timestamp_arrow_ref(kern_data_store *kds,
+					   kern_colmeta *cmeta, size_t index)
+{
+	char	   *base = (char *)kds + __kds_unpack(cmeta->values_offset);
+	size_t		length = __kds_unpack(cmeta->values_length);
+	Timestamp	ts;
+
+	switch (cmeta->attopts.timestamp.unit)
+	{
+		case ArrowTimeUnit__Second:
+			if (sizeof(uint64) * index >= length)
+				elog(ERROR, "corruption? Timestamp[sec] points out of range");
+			ts = ((uint64 *)base)[index] * 1000000UL;
+			break;
+		case ArrowTimeUnit__MilliSecond:
+			if (sizeof(uint64) * index >= length)
+				elog(ERROR, "corruption? Timestamp[ms] points out of range");
+			ts = ((uint64 *)base)[index] * 1000UL;
+			break;
+		case ArrowTimeUnit__MicroSecond:
+			if (sizeof(uint64) * index >= length)
+				elog(ERROR, "corruption? Timestamp[us] points out of range");
+			ts = ((uint64 *)base)[index];
+			break;
+		case ArrowTimeUnit__NanoSecond:
+			if (sizeof(uint64) * index >= length)
+				elog(ERROR, "corruption? Timestamp[ns] points out of range");
+			ts = ((uint64 *)base)[index] / 1000UL;
+			break;
+		default:
+			elog(ERROR, "Bug? unexpected unit of Timestamp type");
+			break;
+	}
+	/* convert UNIX epoch to PostgreSQL epoch */
+	ts -= (POSTGRES_EPOCH_JDATE -
+		   UNIX_EPOCH_JDATE) * USECS_PER_DAY;
+	return TimestampGetDatum(ts);
+}
+
+static Datum
+pg_interval_arrow_ref(kern_data_store *kds,
+					  kern_colmeta *cmeta, size_t index)
+{
+	char	   *base = (char *)kds + __kds_unpack(cmeta->values_offset);
+	size_t		length = __kds_unpack(cmeta->values_length);
+	Interval   *iv = palloc0(sizeof(Interval));
+
+	switch (cmeta->attopts.interval.unit)
+	{
+		case ArrowIntervalUnit__Year_Month:
+			/* 32bit: number of months */
+			if (sizeof(uint32) * index >= length)
+				elog(ERROR, "corruption? Interval[Year/Month] points out of range");
+			iv->month = ((uint32 *)base)[index];
+			break;
+		case ArrowIntervalUnit__Day_Time:
+			/* 32bit+32bit: number of days and milliseconds */
+			if (2 * sizeof(uint32) * index >= length)
+				elog(ERROR, "corruption? Interval[Day/Time] points out of range");
+			iv->day  = ((int32 *)base)[2 * index];
+			iv->time = ((int32 *)base)[2 * index + 1] * 1000;
+			break;
+		default:
+			elog(ERROR, "Bug? unexpected unit of Interval type");
+	}
+	return PointerGetDatum(iv);
+}
+
+static Datum
+pg_macaddr_arrow_ref(kern_data_store *kds,
+					 kern_colmeta *cmeta, size_t index)
+{
+	char   *base = (char *)kds + __kds_unpack(cmeta->values_offset);
+	size_t	length = __kds_unpack(cmeta->values_length);
+
+	if (cmeta->attopts.fixed_size_binary.byteWidth != sizeof(macaddr))
+		elog(ERROR, "Bug? wrong FixedSizeBinary::byteWidth(%d) for macaddr",
+			 cmeta->attopts.fixed_size_binary.byteWidth);
+	if (sizeof(macaddr) * index >= length)
+		elog(ERROR, "corruption? Binary[macaddr] points out of range");
+
+	return PointerGetDatum(base + sizeof(macaddr) * index);
+}
+
+static Datum
+pg_inet_arrow_ref(kern_data_store *kds,
+				  kern_colmeta *cmeta, size_t index)
+{
+	char   *base = (char *)kds + __kds_unpack(cmeta->values_offset);
+	size_t	length = __kds_unpack(cmeta->values_length);
+	inet   *ip = palloc(sizeof(inet));
+
+	if (cmeta->attopts.fixed_size_binary.byteWidth == 4)
+	{
+		if (4 * index >= length)
+			elog(ERROR, "corruption? Binary[inet4] points out of range");
+		ip->inet_data.family = PGSQL_AF_INET;
+		ip->inet_data.bits = 32;
+		memcpy(ip->inet_data.ipaddr, base + 4 * index, 4);
+	}
+	else if (cmeta->attopts.fixed_size_binary.byteWidth == 16)
+	{
+		if (16 * index >= length)
+			elog(ERROR, "corruption? Binary[inet6] points out of range");
+		ip->inet_data.family = PGSQL_AF_INET6;
+		ip->inet_data.bits = 128;
+		memcpy(ip->inet_data.ipaddr, base + 16 * index, 16);
+	}
+	else
+		elog(ERROR, "Bug? wrong FixedSizeBinary::byteWidth(%d) for inet",
+			 cmeta->attopts.fixed_size_binary.byteWidth);
+
+	SET_INET_VARSIZE(ip);
+	return PointerGetDatum(ip);
+}
+
+static Datum
+pg_array_arrow_ref(kern_data_store *kds,
+				   kern_colmeta *smeta,
+				   uint32_t start, uint32_t end)
+{
+	ArrayType  *res;
+	size_t		sz;
+	uint32_t	i, nitems = end - start;
+	bits8	   *nullmap = NULL;
+	size_t		usage, __usage;
+
+	/* sanity checks */
+	if (start > end)
+		elog(ERROR, "Bug? array index has reversed order [%u..%u]", start, end);
+
+	/* allocation of the result buffer */
+	if (smeta->nullmap_offset != 0)
+		sz = ARR_OVERHEAD_WITHNULLS(1, nitems);
+	else
+		sz = ARR_OVERHEAD_NONULLS(1);
+
+	if (smeta->attlen > 0)
+	{
+		sz += TYPEALIGN(smeta->attalign,
+						smeta->attlen) * nitems;
+	}
+	else if (smeta->attlen == -1)
+	{
+		sz += 400;		/* tentative allocation */
+	}
+	else
+		elog(ERROR, "Bug? corrupted kernel column metadata");
+
+	res = palloc0(sz);
+	res->ndim = 1;
+	if (smeta->nullmap_offset != 0)
+	{
+		res->dataoffset = ARR_OVERHEAD_WITHNULLS(1, nitems);
+		nullmap = ARR_NULLBITMAP(res);
+	}
+	res->elemtype = smeta->atttypid;
+	ARR_DIMS(res)[0] = nitems;
+	ARR_LBOUND(res)[0] = 1;
+	usage = ARR_DATA_OFFSET(res);
+	for (i=0; i < nitems; i++)
+	{
+		Datum	datum;
+		bool	isnull;
+
+		pg_datum_arrow_ref(kds, smeta, start+i, &datum, &isnull);
+		if (isnull)
+		{
+			if (!nullmap)
+				elog(ERROR, "Bug? element item should not be NULL");
+		}
+		else if (smeta->attlen > 0)
+		{
+			if (nullmap)
+				nullmap[i>>3] |= (1<<(i&7));
+			__usage = TYPEALIGN(smeta->attalign, usage);
+			while (__usage + smeta->attlen > sz)
+			{
+				sz += sz;
+				res = repalloc(res, sz);
+			}
+			if (__usage > usage)
+				memset((char *)res + usage, 0, __usage - usage);
+			memcpy((char *)res + __usage, &datum, smeta->attlen);
+			usage = __usage + smeta->attlen;
+		}
+		else if (smeta->attlen == -1)
+		{
+			int32_t		vl_len = VARSIZE(datum);
+
+			if (nullmap)
+				nullmap[i>>3] |= (1<<(i&7));
+			__usage = TYPEALIGN(smeta->attalign, usage);
+			while (__usage + vl_len > sz)
+			{
+				sz += sz;
+				res = repalloc(res, sz);
+			}
+			if (__usage > usage)
+				memset((char *)res + usage, 0, __usage - usage);
+			memcpy((char *)res + __usage, DatumGetPointer(datum), vl_len);
+			usage = __usage + vl_len;
+
+			pfree(DatumGetPointer(datum));
+		}
+		else
+			elog(ERROR, "Bug? corrupted kernel column metadata");
+	}
+	SET_VARSIZE(res, usage);
+
+	return PointerGetDatum(res);
+}
+
+/*
+ * pg_datum_arrow_ref
+ */
+static void
+pg_datum_arrow_ref(kern_data_store *kds,
+				   kern_colmeta *cmeta,
+				   size_t index,
+				   Datum *p_datum,
+				   bool *p_isnull)
+{
+	Datum		datum = 0;
+	bool		isnull = false;
+
+	if (KDS_ARROW_CHECK_ISNULL(kds, cmeta, index))
+	{
+		isnull = true;
+		goto out;
+	}
+
+	switch (cmeta->attopts.tag)
+	{
+		case ArrowType__Int:
+		case ArrowType__FloatingPoint:
+			datum = pg_simple_arrow_ref(kds, cmeta, index);
+			break;
+		case ArrowType__Bool:
+			datum = pg_bool_arrow_ref(kds, cmeta, index);
+			break;
+		case ArrowType__Decimal:
+			datum = pg_numeric_arrow_ref(kds, cmeta, index);
+			break;
+		case ArrowType__Date:
+			datum = pg_date_arrow_ref(kds, cmeta, index);
+			break;
+		case ArrowType__Time:
+			datum = pg_time_arrow_ref(kds, cmeta, index);
+			break;
+		case ArrowType__Timestamp:
+			datum = pg_timestamp_arrow_ref(kds, cmeta, index);
+			break;
+		case ArrowType__Interval:
+			datum = pg_interval_arrow_ref(kds, cmeta, index);
+			break;
+		case ArrowType__Utf8:
+		case ArrowType__Binary:
+			datum = pg_varlena32_arrow_ref(kds, cmeta, index, &isnull);
+			break;
+		case ArrowType__LargeUtf8:
+		case ArrowType__LargeBinary:
+			datum = pg_varlena64_arrow_ref(kds, cmeta, index, &isnull);
+			break;
+		case ArrowType__Utf8View:
+		case ArrowType__BinaryView:
+			datum = pg_varlena_view_arrow_ref(kds, cmeta, index, &isnull);
+			break;
+
+		case ArrowType__FixedSizeBinary:
+			switch (cmeta->atttypid)
+			{
+				case MACADDROID:
+					datum = pg_macaddr_arrow_ref(kds, cmeta, index);
+					break;
+				case INETOID:
+					datum = pg_inet_arrow_ref(kds, cmeta, index);
+					break;
+				case BPCHAROID:
+					datum = pg_bpchar_arrow_ref(kds, cmeta, index);
+					break;
+				default:
+					elog(ERROR, "unknown FixedSizeBinary mapping");
+					break;
+			}
+			break;
+			
+		case ArrowType__List:
+			{
+				kern_colmeta   *smeta;
+				uint32_t	   *offset;
+
+				if (cmeta->num_subattrs != 1 ||
+					cmeta->idx_subattrs < kds->ncols ||
+					cmeta->idx_subattrs >= kds->nr_colmeta)
+					elog(ERROR, "Bug? corrupted kernel column metadata");
+				if (sizeof(uint32_t) * (index+2) > __kds_unpack(cmeta->values_length))
+					elog(ERROR, "Bug? array index is out of range");
+				smeta = &kds->colmeta[cmeta->idx_subattrs];
+				offset = (uint32_t *)((char *)kds + __kds_unpack(cmeta->values_offset));
+				datum = pg_array_arrow_ref(kds, smeta,
+										   offset[index],
+										   offset[index+1]);
+				isnull = false;
+			}
+			break;
+
+		case ArrowType__LargeList:
+			{
+				kern_colmeta   *smeta;
+				uint64_t	   *offset;
+
+				if (cmeta->num_subattrs != 1 ||
+					cmeta->idx_subattrs < kds->ncols ||
+					cmeta->idx_subattrs >= kds->nr_colmeta)
+					elog(ERROR, "Bug? corrupted kernel column metadata");
+				if (sizeof(uint64_t) * (index+2) > __kds_unpack(cmeta->values_length))
+					elog(ERROR, "Bug? array index is out of range");
+				smeta = &kds->colmeta[cmeta->idx_subattrs];
+				offset = (uint64_t *)((char *)kds + __kds_unpack(cmeta->values_offset));
+				datum = pg_array_arrow_ref(kds, smeta,
+										   offset[index],
 										   offset[index+1]);
 				isnull = false;
 			}
 			break;
 
-		case ArrowType__Struct:
-			{
-				TupleDesc	tupdesc = lookup_rowtype_tupdesc(cmeta->atttypid, -1);
-				Datum	   *sub_values = alloca(sizeof(Datum) * tupdesc->natts);
-				bool	   *sub_isnull = alloca(sizeof(bool)  * tupdesc->natts);
-				HeapTuple	htup;
+		case ArrowType__Struct:
+			{
+				TupleDesc	tupdesc = lookup_rowtype_tupdesc(cmeta->atttypid, -1);
+				Datum	   *sub_values = alloca(sizeof(Datum) * tupdesc->natts);
+				bool	   *sub_isnull = alloca(sizeof(bool)  * tupdesc->natts);
+				HeapTuple	htup;
+
+				if (tupdesc->natts != cmeta->num_subattrs)
+					elog(ERROR, "Struct definition is conrrupted?");
+				if (cmeta->idx_subattrs < kds->ncols ||
+					cmeta->idx_subattrs + cmeta->num_subattrs > kds->nr_colmeta)
+					elog(ERROR, "Bug? strange kernel column metadata");
+				for (int j=0; j < tupdesc->natts; j++)
+				{
+					kern_colmeta *sub_meta = &kds->colmeta[cmeta->idx_subattrs + j];
+
+					pg_datum_arrow_ref(kds, sub_meta, index,
+									   sub_values + j,
+									   sub_isnull + j);
+				}
+				htup = heap_form_tuple(tupdesc, sub_values, sub_isnull);
+
+				ReleaseTupleDesc(tupdesc);
+
+				datum = PointerGetDatum(htup->t_data);
+				isnull = false;
+			}
+			break;
+		default:
+			/* TODO: custom data type support here */
+			elog(ERROR, "arrow_fdw: unknown or unsupported type");
+	}
+out:
+	*p_datum  = datum;
+	*p_isnull = isnull;
+}
+
+/*
+ * KDS_fetch_tuple_arrow
+ */
+bool
+kds_arrow_fetch_tuple(TupleTableSlot *slot,
+					  kern_data_store *kds,
+					  size_t index,
+					  const Bitmapset *referenced)
+{
+	int		j, k;
+
+	if (index >= kds->nitems)
+		return false;
+	ExecStoreAllNullTuple(slot);
+	for (k = bms_next_member(referenced, -1);
+		 k >= 0;
+		 k = bms_next_member(referenced, k))
+	{
+		j = k + FirstLowInvalidHeapAttributeNumber - 1;
+		if (j < 0)
+			continue;
+		pg_datum_arrow_ref(kds,
+						   &kds->colmeta[j],
+						   index,
+						   slot->tts_values + j,
+						   slot->tts_isnull + j);
+	}
+	return true;
+}
+
+/* ----------------------------------------------------------------
+ *
+ * Batch decoder for the CPU scan path
+ *
+ * Rows are decoded column-by-column for a window of ARROW_CPU_BATCH_NROWS
+ * rows, then put on the virtual tuple slot one by one. The simple fixed-
+ * length types and variable-length binaries are decoded by tight loops,
+ * and the others fall back to pg_datum_arrow_ref() per row.
+ * If the record-batch is not compressed and all the referenced columns are
+ * available for the batch decoder, columns are decoded directly on the
+ * memory-mapped file, without loading the record-batch to the KDS.
+ *
+ * ----------------------------------------------------------------
+ */
+#define ARROW_CPU_BATCH_NROWS		1024	/* must be multiple of 8 */
+
+typedef struct
+{
+	const uint8_t *nullmap;		/* NULL, if no nulls */
+	size_t		nullmap_length;
+	const char *values;
+	size_t		values_length;
+	const char *extra;
+	size_t		extra_length;
+} arrowColumnView;
+
+struct arrowCpuBatch
+{
+	MemoryContext memcxt;		/* memory for the current window */
+	int			nattrs;			/* number of referenced columns */
+	int		   *attnums;		/* index of the referenced columns */
+	bool	   *fallback;		/* true, if pg_datum_arrow_ref() per row */
+	arrowColumnView *views;
+	RecordBatchState *rb_state;	/* current record-batch */
+	kern_data_store *kds;		/* valid, if loaded to the chunk_buffer */
+	ArrowFileState *mmap_af_state;	/* file currently mapped */
+	char	   *mmap_addr;
+	size_t		mmap_size;
+	uint32_t	nitems;			/* number of rows in the record-batch */
+	uint32_t	row_base;		/* first row of the current window */
+	uint32_t	row_count;		/* number of rows in the current window */
+	uint32_t	row_index;		/* next row in the current window */
+	Datum	   *values;			/* [nattrs * ARROW_CPU_BATCH_NROWS] */
+	bool	   *isnull;			/* [nattrs * ARROW_CPU_BATCH_NROWS] */
+};
+
+/*
+ * __nullmap_expand_table - 8 'isnull' flags for each byte of nullmap
+ */
+static uint64_t	__nullmap_expand_table[256];
+static bool		__nullmap_expand_table_ready = false;
+
+static void
+__arrowCpuExpandNullmap(bool *isnull,
+						const arrowColumnView *view,
+						uint32_t row_base,
+						uint32_t row_count)
+{
+	uint32_t	nbytes = (row_count + 7) / 8;
+	uint32_t	base = row_base / 8;
+
+	Assert(row_base % 8 == 0);
+	if (!view->nullmap)
+	{
+		memset(isnull, 0, sizeof(bool) * row_count);
+		return;
+	}
+	if (!__nullmap_expand_table_ready)
+	{
+		for (int b=0; b < 256; b++)
+		{
+			uint64_t	v = 0;
+
+			for (int k=0; k < 8; k++)
+			{
+				if ((b & (1<<k)) == 0)
+					v |= (1UL << (8 * k));
+			}
+			__nullmap_expand_table[b] = v;
+		}
+		__nullmap_expand_table_ready = true;
+	}
+	for (uint32_t i=0; i < nbytes; i++)
+	{
+		/* out of the nullmap is considered as NULL, like KDS_ARROW_CHECK_ISNULL */
+		uint8_t		b = (base + i < view->nullmap_length
+						 ? view->nullmap[base + i] : 0);
+
+		memcpy(isnull + 8 * i, &__nullmap_expand_table[b], sizeof(uint64_t));
+	}
+}
+
+static bool
+__arrowCpuBatchIsSupported(const ArrowTypeOptions *attopts)
+{
+	switch (attopts->tag)
+	{
+		case ArrowType__Int:
+		case ArrowType__FloatingPoint:
+		case ArrowType__Bool:
+		case ArrowType__Date:
+		case ArrowType__Time:
+		case ArrowType__Timestamp:
+		case ArrowType__Utf8:
+		case ArrowType__Binary:
+			return true;
+		default:
+			break;
+	}
+	return false;
+}
+
+#define __ARROW_CPU_CHECK_LENGTH(view,unitsz,nrows,label)				\
+	do {																\
+		if ((size_t)(unitsz) * (nrows) > (view)->values_length)			\
+			elog(ERROR, "corruption? %s points out of range", (label));	\
+	} while(0)
+
+static void
+__arrowCpuDecodeSimple(Datum *dst, const arrowColumnView *view,
+					   const ArrowTypeOptions *attopts,
+					   uint32_t row_base, uint32_t row_count)
+{
+	int			unitsz = attopts->unitsz;
+
+	__ARROW_CPU_CHECK_LENGTH(view, unitsz, row_base + row_count, "simple");
+	switch (unitsz)
+	{
+		case sizeof(uint8_t):
+			{
+				const uint8_t *src = (const uint8_t *)view->values + row_base;
+
+				for (uint32_t i=0; i < row_count; i++)
+					dst[i] = (Datum)src[i];
+			}
+			break;
+		case sizeof(uint16_t):
+			{
+				const uint16_t *src = (const uint16_t *)view->values + row_base;
+
+				for (uint32_t i=0; i < row_count; i++)
+					dst[i] = (Datum)src[i];
+			}
+			break;
+		case sizeof(uint32_t):
+			{
+				const uint32_t *src = (const uint32_t *)view->values + row_base;
+
+				for (uint32_t i=0; i < row_count; i++)
+					dst[i] = (Datum)src[i];
+			}
+			break;
+		case sizeof(uint64_t):
+			{
+				const uint64_t *src = (const uint64_t *)view->values + row_base;
+
+				for (uint32_t i=0; i < row_count; i++)
+					dst[i] = (Datum)src[i];
+			}
+			break;
+		default:
+			elog(ERROR, "Bug? unexpected unit size of simple type (%d)", unitsz);
+	}
+}
+
+static void
+__arrowCpuDecodeBool(Datum *dst, const arrowColumnView *view,
+					 uint32_t row_base, uint32_t row_count)
+{
+	const uint8_t *bitmap = (const uint8_t *)view->values;
+
+	if ((row_base + row_count + 7) / 8 > view->values_length)
+		elog(ERROR, "corruption? bool points out of range");
+	for (uint32_t i=0; i < row_count; i++)
+	{
+		uint32_t	k = row_base + i;
+
+		dst[i] = BoolGetDatum(((bitmap[k>>3] >> (k & 7)) & 1) != 0);
+	}
+}
+
+static void
+__arrowCpuDecodeDate(Datum *dst, const arrowColumnView *view,
+					 const ArrowTypeOptions *attopts,
+					 uint32_t row_base, uint32_t row_count)
+{
+	const DateADT epoch_diff = (POSTGRES_EPOCH_JDATE - UNIX_EPOCH_JDATE);
+
+	switch (attopts->date.unit)
+	{
+		case ArrowDateUnit__Day:
+			{
+				const uint32 *src = (const uint32 *)view->values + row_base;
+
+				__ARROW_CPU_CHECK_LENGTH(view, sizeof(uint32), row_base + row_count,
+										 "Date[day]");
+				for (uint32_t i=0; i < row_count; i++)
+					dst[i] = DateADTGetDatum((DateADT)src[i] - epoch_diff);
+			}
+			break;
+		case ArrowDateUnit__MilliSecond:
+			{
+				const uint64 *src = (const uint64 *)view->values + row_base;
+
+				__ARROW_CPU_CHECK_LENGTH(view, sizeof(uint64), row_base + row_count,
+										 "Date[ms]");
+				for (uint32_t i=0; i < row_count; i++)
+					dst[i] = DateADTGetDatum((DateADT)(src[i] / 1000) - epoch_diff);
+			}
+			break;
+		default:
+			elog(ERROR, "Bug? unexpected unit of Date type");
+	}
+}
+
+static void
+__arrowCpuDecodeTime(Datum *dst, const arrowColumnView *view,
+					 const ArrowTypeOptions *attopts,
+					 uint32_t row_base, uint32_t row_count)
+{
+	switch (attopts->time.unit)
+	{
+		case ArrowTimeUnit__Second:
+		case ArrowTimeUnit__MilliSecond:
+			{
+				const uint32 *src = (const uint32 *)view->values + row_base;
+				int64_t		scale = (attopts->time.unit == ArrowTimeUnit__Second
+									 ? 1000000L : 1000L);
+
+				__ARROW_CPU_CHECK_LENGTH(view, sizeof(uint32), row_base + row_count,
+										 "Time");
+				for (uint32_t i=0; i < row_count; i++)
+					dst[i] = TimeADTGetDatum((TimeADT)src[i] * scale);
+			}
+			break;
+		case ArrowTimeUnit__MicroSecond:
+		case ArrowTimeUnit__NanoSecond:
+			{
+				const uint64 *src = (const uint64 *)view->values + row_base;
+				int64_t		scale = (attopts->time.unit == ArrowTimeUnit__NanoSecond
+									 ? 1000L : 1L);
+
+				__ARROW_CPU_CHECK_LENGTH(view, sizeof(uint64), row_base + row_count,
+										 "Time");
+				for (uint32_t i=0; i < row_count; i++)
+					dst[i] = TimeADTGetDatum((TimeADT)(src[i] / scale));
+			}
+			break;
+		default:
+			elog(ERROR, "Bug? unexpected unit of Time type");
+	}
+}
+
+static void
+__arrowCpuDecodeTimestamp(Datum *dst, const arrowColumnView *view,
+						  const ArrowTypeOptions *attopts,
+						  uint32_t row_base, uint32_t row_count)
+{
+	const uint64 *src = (const uint64 *)view->values + row_base;
+	const Timestamp epoch_diff = ((POSTGRES_EPOCH_JDATE -
+								   UNIX_EPOCH_JDATE) * USECS_PER_DAY);
+
+	__ARROW_CPU_CHECK_LENGTH(view, sizeof(uint64), row_base + row_count,
+							 "Timestamp");
+	switch (attopts->timestamp.unit)
+	{
+		case ArrowTimeUnit__Second:
+			for (uint32_t i=0; i < row_count; i++)
+				dst[i] = TimestampGetDatum((Timestamp)(src[i] * 1000000UL) - epoch_diff);
+			break;
+		case ArrowTimeUnit__MilliSecond:
+			for (uint32_t i=0; i < row_count; i++)
+				dst[i] = TimestampGetDatum((Timestamp)(src[i] * 1000UL) - epoch_diff);
+			break;
+		case ArrowTimeUnit__MicroSecond:
+			for (uint32_t i=0; i < row_count; i++)
+				dst[i] = TimestampGetDatum((Timestamp)src[i] - epoch_diff);
+			break;
+		case ArrowTimeUnit__NanoSecond:
+			for (uint32_t i=0; i < row_count; i++)
+				dst[i] = TimestampGetDatum((Timestamp)(src[i] / 1000UL) - epoch_diff);
+			break;
+		default:
+			elog(ERROR, "Bug? unexpected unit of Timestamp type");
+	}
+}
+
+/*
+ * __arrowCpuDecodeVarlena
+ *
+ * It converts the offset array to the pointers of varlena datum, built on
+ * a single buffer for the whole window.
+ */
+static void
+__arrowCpuDecodeVarlena(Datum *dst, bool *isnull,
+						const arrowColumnView *view,
+						uint32_t row_base, uint32_t row_count)
+{
+	const uint32_t *offset = (const uint32_t *)view->values + row_base;
+	size_t		total_sz = 0;
+	char	   *pos;
+
+	if (sizeof(uint32_t) * (row_base + row_count + 1) > view->values_length)
+		elog(ERROR, "corruption? varlena points out of range");
+	for (uint32_t i=0; i < row_count; i++)
+	{
+		if (isnull[i])
+			continue;
+		if (offset[i] > offset[i+1] ||
+			offset[i+1] > view->extra_length ||
+			offset[i+1] - offset[i] > VARATT_MAX)
+			isnull[i] = true;	/* same as pg_varlena32_arrow_ref */
+		else
+			total_sz += INTALIGN(VARHDRSZ + offset[i+1] - offset[i]);
+	}
+	pos = palloc(total_sz + 1);
+	for (uint32_t i=0; i < row_count; i++)
+	{
+		uint32_t	len;
+
+		if (isnull[i])
+			continue;
+		len = offset[i+1] - offset[i];
+		memcpy(pos + VARHDRSZ, view->extra + offset[i], len);
+		SET_VARSIZE(pos, VARHDRSZ + len);
+		dst[i] = PointerGetDatum(pos);
+		pos += INTALIGN(VARHDRSZ + len);
+	}
+}
+
+/*
+ * __arrowCpuBatchDecodeWindow
+ */
+static void
+__arrowCpuBatchDecodeWindow(arrowCpuBatch *cpu_batch)
+{
+	RecordBatchState *rb_state = cpu_batch->rb_state;
+	kern_data_store *kds = cpu_batch->kds;
+	uint32_t	row_base = cpu_batch->row_base;
+	uint32_t	row_count;
+	MemoryContext oldcxt;
+
+	row_count = Min(cpu_batch->nitems - row_base, ARROW_CPU_BATCH_NROWS);
+	MemoryContextReset(cpu_batch->memcxt);
+	oldcxt = MemoryContextSwitchTo(cpu_batch->memcxt);
+	for (int k=0; k < cpu_batch->nattrs; k++)
+	{
+		int			j = cpu_batch->attnums[k];
+		Datum	   *values = cpu_batch->values + k * ARROW_CPU_BATCH_NROWS;
+		bool	   *isnull = cpu_batch->isnull + k * ARROW_CPU_BATCH_NROWS;
+		const arrowColumnView *view = &cpu_batch->views[k];
+		const ArrowTypeOptions *attopts;
+
+		if (cpu_batch->fallback[k])
+		{
+			Assert(kds != NULL);
+			for (uint32_t i=0; i < row_count; i++)
+				pg_datum_arrow_ref(kds, &kds->colmeta[j],
+								   row_base + i,
+								   values + i,
+								   isnull + i);
+			continue;
+		}
+		attopts = (kds ? &kds->colmeta[j].attopts : &rb_state->fields[j].attopts);
+		__arrowCpuExpandNullmap(isnull, view, row_base, row_count);
+		switch (attopts->tag)
+		{
+			case ArrowType__Int:
+			case ArrowType__FloatingPoint:
+				__arrowCpuDecodeSimple(values, view, attopts, row_base, row_count);
+				break;
+			case ArrowType__Bool:
+				__arrowCpuDecodeBool(values, view, row_base, row_count);
+				break;
+			case ArrowType__Date:
+				__arrowCpuDecodeDate(values, view, attopts, row_base, row_count);
+				break;
+			case ArrowType__Time:
+				__arrowCpuDecodeTime(values, view, attopts, row_base, row_count);
+				break;
+			case ArrowType__Timestamp:
+				__arrowCpuDecodeTimestamp(values, view, attopts, row_base, row_count);
+				break;
+			case ArrowType__Utf8:
+			case ArrowType__Binary:
+				__arrowCpuDecodeVarlena(values, isnull, view, row_base, row_count);
+				break;
+			default:
+				elog(ERROR, "Bug? unexpected type for the batch decoder");
+		}
+	}
+	MemoryContextSwitchTo(oldcxt);
+	cpu_batch->row_count = row_count;
+	cpu_batch->row_index = 0;
+}
+
+/*
+ * __arrowCpuBatchMapFile
+ */
+static bool
+__arrowCpuBatchMapFile(arrowCpuBatch *cpu_batch, ArrowFileState *af_state)
+{
+	size_t		mmap_size = af_state->stat_buf.st_size;
+	char	   *mmap_addr;
+	int			fdesc;
+
+	if (cpu_batch->mmap_af_state == af_state)
+		return (cpu_batch->mmap_addr != NULL);
+	if (cpu_batch->mmap_addr)
+	{
+		if (munmap(cpu_batch->mmap_addr, cpu_batch->mmap_size) != 0)
+			elog(WARNING, "failed on munmap: %m");
+		cpu_batch->mmap_addr = NULL;
+		cpu_batch->mmap_size = 0;
+	}
+	cpu_batch->mmap_af_state = af_state;
+	if (mmap_size == 0)
+		return false;
+	fdesc = OpenTransientFile(af_state->filename, O_RDONLY | PG_BINARY);
+	if (fdesc < 0)
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not open file \"%s\": %m", af_state->filename)));
+	mmap_addr = mmap(NULL, mmap_size, PROT_READ, MAP_SHARED, fdesc, 0);
+	CloseTransientFile(fdesc);
+	if (mmap_addr == MAP_FAILED)
+	{
+		/* the record-batch is read to the KDS instead */
+		elog(DEBUG2, "arrow_fdw: failed on mmap('%s'): %m", af_state->filename);
+		return false;
+	}
+	cpu_batch->mmap_addr = mmap_addr;
+	cpu_batch->mmap_size = mmap_size;
+	return true;
+}
+
+/*
+ * __arrowCpuBatchSetupViewByMmap
+ */
+static bool
+__arrowCpuBatchSetupViewByMmap(arrowCpuBatch *cpu_batch,
+							   RecordBatchState *rb_state,
+							   Bitmapset *referenced)
+{
+	const char *base;
+
+	if (rb_state->rb_compressed ||
+		rb_state->rb_parquet ||
+		arrowFdwPartitionKeysReferenced(rb_state, referenced))
+		return false;
+	for (int k=0; k < cpu_batch->nattrs; k++)
+	{
+		RecordBatchFieldState *rb_field = &rb_state->fields[cpu_batch->attnums[k]];
+
+		if (!__arrowCpuBatchIsSupported(&rb_field->attopts))
+			return false;
+	}
+	arrowFdwObjStoreFetchRecordBatch(rb_state, referenced, true);
+	if (!__arrowCpuBatchMapFile(cpu_batch, rb_state->af_state))
+		return false;
+	if (rb_state->rb_offset + rb_state->rb_length > cpu_batch->mmap_size)
+		elog(ERROR, "arrow_fdw: record-batch %d of '%s' is out of the file",
+			 rb_state->rb_index, rb_state->af_state->filename);
+	base = cpu_batch->mmap_addr + rb_state->rb_offset;
+	posix_madvise((void *)TYPEALIGN_DOWN(PAGE_SIZE, (uintptr_t)base),
+				  rb_state->rb_length + ((uintptr_t)base & (PAGE_SIZE-1)),
+				  POSIX_MADV_WILLNEED);
+	for (int k=0; k < cpu_batch->nattrs; k++)
+	{
+		RecordBatchFieldState *rb_field = &rb_state->fields[cpu_batch->attnums[k]];
+		arrowColumnView *view = &cpu_batch->views[k];
+
+		memset(view, 0, sizeof(arrowColumnView));
+		if (rb_field->null_count > 0 && rb_field->nullmap_length > 0)
+		{
+			view->nullmap = (const uint8_t *)(base + rb_field->nullmap_offset);
+			view->nullmap_length = rb_field->nullmap_length;
+		}
+		view->values = base + rb_field->values_offset;
+		view->values_length = rb_field->values_length;
+		view->extra = base + rb_field->extra_offset;
+		view->extra_length = rb_field->extra_length;
+		cpu_batch->fallback[k] = false;
+	}
+	cpu_batch->kds = NULL;
+	return true;
+}
+
+/*
+ * __arrowCpuBatchSetupViewByKds
+ */
+static void
+__arrowCpuBatchSetupViewByKds(arrowCpuBatch *cpu_batch,
+							  kern_data_store *kds)
+{
+	for (int k=0; k < cpu_batch->nattrs; k++)
+	{
+		kern_colmeta *cmeta = &kds->colmeta[cpu_batch->attnums[k]];
+		arrowColumnView *view = &cpu_batch->views[k];
+
+		memset(view, 0, sizeof(arrowColumnView));
+		if (cmeta->nullmap_offset)
+		{
+			view->nullmap = (const uint8_t *)kds + __kds_unpack(cmeta->nullmap_offset);
+			view->nullmap_length = __kds_unpack(cmeta->nullmap_length);
+		}
+		if (cmeta->values_offset)
+		{
+			view->values = (const char *)kds + __kds_unpack(cmeta->values_offset);
+			view->values_length = __kds_unpack(cmeta->values_length);
+		}
+		if (cmeta->extra_offset)
+		{
+			view->extra = (const char *)kds + __kds_unpack(cmeta->extra_offset);
+			view->extra_length = __kds_unpack(cmeta->extra_length);
+		}
+		cpu_batch->fallback[k] = !__arrowCpuBatchIsSupported(&cmeta->attopts);
+	}
+	cpu_batch->kds = kds;
+}
+
+/*
+ * __arrowCpuBatchCreate
+ */
+static arrowCpuBatch *
+__arrowCpuBatchCreate(ArrowFdwState *arrow_state, TupleDesc tupdesc)
+{
+	arrowCpuBatch *cpu_batch = palloc0(sizeof(arrowCpuBatch));
+	int			nattrs = 0;
+	int			k;
+
+	cpu_batch->attnums = palloc0(sizeof(int) * tupdesc->natts);
+	for (k = bms_next_member(arrow_state->referenced, -1);
+		 k >= 0;
+		 k = bms_next_member(arrow_state->referenced, k))
+	{
+		int		j = k + FirstLowInvalidHeapAttributeNumber - 1;
+
+		if (j >= 0 && j < tupdesc->natts)
+			cpu_batch->attnums[nattrs++] = j;
+	}
+	cpu_batch->nattrs = nattrs;
+	cpu_batch->fallback = palloc0(sizeof(bool) * Max(nattrs, 1));
+	cpu_batch->views = palloc0(sizeof(arrowColumnView) * Max(nattrs, 1));
+	cpu_batch->values = palloc0(sizeof(Datum) * ARROW_CPU_BATCH_NROWS * Max(nattrs, 1));
+	cpu_batch->isnull = palloc0(sizeof(bool)  * ARROW_CPU_BATCH_NROWS * Max(nattrs, 1));
+	cpu_batch->memcxt = AllocSetContextCreate(CurrentMemoryContext,
+											  "Arrow_Fdw CPU Batch",
+											  ALLOCSET_DEFAULT_SIZES);
+	return cpu_batch;
+}
+
+/*
+ * __arrowCpuBatchRelease
+ */
+static void
+__arrowCpuBatchRelease(arrowCpuBatch *cpu_batch)
+{
+	if (cpu_batch->mmap_addr &&
+		munmap(cpu_batch->mmap_addr, cpu_batch->mmap_size) != 0)
+		elog(WARNING, "failed on munmap: %m");
+	cpu_batch->mmap_addr = NULL;
+	cpu_batch->mmap_size = 0;
+	cpu_batch->mmap_af_state = NULL;
+	cpu_batch->rb_state = NULL;
+	cpu_batch->kds = NULL;
+	cpu_batch->nitems = 0;
+	cpu_batch->row_base = 0;
+	cpu_batch->row_count = 0;
+	cpu_batch->row_index = 0;
+}
+
+/*
+ * __arrowCpuBatchFetchTuple
+ */
+static void
+__arrowCpuBatchFetchTuple(arrowCpuBatch *cpu_batch, TupleTableSlot *slot)
+{
+	uint32_t	i = cpu_batch->row_index++;
+
+	Assert(i < cpu_batch->row_count);
+	ExecStoreAllNullTuple(slot);
+	for (int k=0; k < cpu_batch->nattrs; k++)
+	{
+		int		j = cpu_batch->attnums[k];
+
+		slot->tts_values[j] = cpu_batch->values[k * ARROW_CPU_BATCH_NROWS + i];
+		slot->tts_isnull[j] = cpu_batch->isnull[k * ARROW_CPU_BATCH_NROWS + i];
+	}
+}
+
+/* ----------------------------------------------------------------
+ *
+ * Executor callbacks
+ *
+ * ----------------------------------------------------------------
+ */
+
+/*
+ * __arrowIncrementalLookupFile
+ */
+static arrowIncrementalFile *
+__arrowIncrementalLookupFile(List *files, const char *filename)
+{
+	ListCell   *lc;
+
+	foreach (lc, files)
+	{
+		arrowIncrementalFile *incr = lfirst(lc);
+
+		if (strcmp(incr->filename, filename) == 0)
+			return incr;
+	}
+	return NULL;
+}
+
+/*
+ * __arrowFdwExecInit
+ */
+static ArrowFdwState *
+__arrowFdwExecInit(ScanState *ss,
+				   List *outer_quals,
+				   const Bitmapset *outer_refs,
+				   const Bitmapset **p_optimal_gpus,
+				   const DpuStorageEntry **p_ds_entry)
+{
+	Relation		frel = ss->ss_currentRelation;
+	TupleDesc		tupdesc = RelationGetDescr(frel);
+	ForeignTable   *ft = GetForeignTable(RelationGetRelid(frel));
+	Bitmapset	   *referenced = NULL;
+	Bitmapset	   *stat_attrs = NULL;
+	Bitmapset	   *optimal_gpus = NULL;
+	const DpuStorageEntry *ds_entry = NULL;
+	bool			whole_row_ref = false;
+	bool			hive_partitioning;
+	List		   *filesList;
+	arrowManifestCache *manifest;
+	List		   *af_states_list = NIL;
+	uint32_t		rb_nrooms = 0;
+	uint32_t		rb_nitems = 0;
+	ArrowFdwState *arrow_state;
+	ListCell	   *lc1, *lc2;
+
+	Assert(RelationIsArrowFdw(frel));
+	/* expand 'referenced' if it has whole-row reference */
+	if (bms_is_member(-FirstLowInvalidHeapAttributeNumber, outer_refs))
+		whole_row_ref = true;
+	for (int j=0; j < tupdesc->natts; j++)
+	{
+		Form_pg_attribute attr = TupleDescAttr(tupdesc, j);
+		int		k = attr->attnum - FirstLowInvalidHeapAttributeNumber;
+
+		if (attr->attisdropped)
+			continue;
+		if (whole_row_ref || bms_is_member(k, outer_refs))
+			referenced = bms_add_member(referenced, k);
+	}
+
+	/* setup ArrowFileState */
+	filesList = arrowFdwExtractFilesList(ft->options, NULL,
+										 &hive_partitioning);
+	manifest = arrowFdwLookupManifest(ft->options);
+	foreach (lc1, filesList)
+	{
+		char	   *fname = strVal(lfirst(lc1));
+		ArrowFileState *af_state;
+		arrowIncrementalFile *incr = NULL;
+
+		if (arrow_incremental_filter &&
+			arrow_incremental_filter->frelid == RelationGetRelid(frel))
+		{
+			/* refresh of the incremental aggregate; only new record-batches */
+			incr = __arrowIncrementalLookupFile(arrow_incremental_filter->files,
+												fname);
+			if (!incr)
+				continue;
+		}
+		if (hive_partitioning &&
+			__arrowFdwPartitionIsRefuted(frel, fname, outer_quals,
+										 ((Scan *)ss->ps.plan)->scanrelid))
+			continue;
+		if (manifest &&
+			__arrowFdwManifestIsRefuted(manifest, frel, fname, outer_quals,
+										((Scan *)ss->ps.plan)->scanrelid))
+			continue;
+		af_state = BuildArrowFileState(frel, fname,
+									   hive_partitioning,
+									   &stat_attrs);
+		if (af_state && incr)
+		{
+			af_state->rb_list = list_truncate(list_copy_tail(af_state->rb_list,
+															 incr->rb_skip),
+											  incr->rb_count - incr->rb_skip);
+		}
+		if (af_state)
+		{
+			rb_nrooms += list_length(af_state->rb_list);
+			if (p_optimal_gpus)
+			{
+				const Bitmapset  *__optimal_gpus = GetOptimalGpuForFile(fname);
+
+				if (af_states_list == NIL)
+					optimal_gpus = bms_copy(__optimal_gpus);
+				else
+					optimal_gpus = bms_intersect(optimal_gpus, __optimal_gpus);
+			}
+			if (p_ds_entry)
+			{
+				const DpuStorageEntry *ds_temp;
+
+				if (af_states_list == NIL)
+					ds_entry = GetOptimalDpuForFile(fname, &af_state->dpu_path);
+				else if (ds_entry)
+				{
+					ds_temp = GetOptimalDpuForFile(fname, &af_state->dpu_path);
+					if (!DpuStorageEntryIsEqual(ds_entry, ds_temp))
+						ds_entry = NULL;
+				}
+			}
+			af_states_list = lappend(af_states_list, af_state);
+		}
+	}
+
+	/* setup ArrowFdwState */
+	arrow_state = palloc0(offsetof(ArrowFdwState, rb_states[rb_nrooms]));
+	arrow_state->referenced = referenced;
+	if (arrow_fdw_stats_hint_enabled)
+		arrow_state->stats_hint = execInitArrowStatsHint(ss, outer_quals, stat_attrs);
+	if (arrow_fdw_late_materialization)
+		arrow_state->late_mat = execInitArrowLateMaterialization(ss, outer_quals,
+																 referenced);
+	arrow_state->rbatch_index = &arrow_state->__rbatch_index_local;
+	arrow_state->rbatch_nload = &arrow_state->__rbatch_nload_local;
+	arrow_state->rbatch_nskip = &arrow_state->__rbatch_nskip_local;
+	arrow_state->rbatch_nlate = &arrow_state->__rbatch_nlate_local;
+	initStringInfo(&arrow_state->chunk_buffer);
+	arrow_state->curr_filp  = -1;
+	arrow_state->cpu_batch  = NULL;	/* set up on demand */
+	arrow_state->af_states_list = af_states_list;
+	foreach (lc1, af_states_list)
+	{
+		ArrowFileState *af_state = lfirst(lc1);
+
+		foreach (lc2, af_state->rb_list)
+		{
+			RecordBatchState *rb_state = lfirst(lc2);
+
+			arrow_state->rb_states[rb_nitems++] = rb_state;
+		}
+	}
+	Assert(rb_nrooms == rb_nitems);
+	arrow_state->rb_nitems = rb_nitems;
+	/*
+	 * Concurrent scans on the same arrow files start at the record-batch
+	 * where the other one is currently reading, like synchronized heap
+	 * scan, so GPU service can share the extents already loaded on the
+	 * device memory (see gpuSharedScanBuffer).
+	 * Foreign tables have no relfilenode, so syncscan.c identifies the
+	 * scan by the pseudo file locator with invalid tablespace.
+	 */
+	if (synchronize_seqscans && rb_nitems > 1)
+	{
+		RelFileLocator *rlocator = &RelationFileLocator(&arrow_state->syncscan_rel);
+
+		RelFileLocatorSpcOid(*rlocator)    = InvalidOid;
+		RelFileLocatorDbOid(*rlocator)     = MyDatabaseId;
+		RelFileLocatorRelNumber(*rlocator) = RelationGetRelid(frel);
+		arrow_state->syncscan = true;
+		arrow_state->rb_startpos = ss_get_location(&arrow_state->syncscan_rel,
+												   rb_nitems);
+	}
+
+	if (p_optimal_gpus)
+		*p_optimal_gpus = optimal_gpus;
+	if (p_ds_entry)
+		*p_ds_entry = ds_entry;
+
+	return arrow_state;
+}
+
+/*
+ * pgstromArrowFdwExecInit
+ */
+bool
+pgstromArrowFdwExecInit(pgstromTaskState *pts,
+						List *outer_quals,
+						const Bitmapset *outer_refs)
+{
+	Relation		frel = pts->css.ss.ss_currentRelation;
+	ArrowFdwState  *arrow_state = NULL;
+
+	if (RelationIsArrowFdw(frel))
+	{
+		arrow_state = __arrowFdwExecInit(&pts->css.ss,
+										 outer_quals,
+										 outer_refs,
+										 (pts->xpu_task_flags & DEVKIND__NVIDIA_GPU) != 0
+											? &pts->optimal_gpus : NULL,
+										 (pts->xpu_task_flags & DEVKIND__NVIDIA_DPU) != 0
+											? &pts->ds_entry : NULL);
+	}
+	pts->arrow_state = arrow_state;
+	return (pts->arrow_state != NULL);
+}
+
+/*
+ * ArrowBeginForeignScan
+ */
+static void
+ArrowBeginForeignScan(ForeignScanState *node, int eflags)
+{
+	ForeignScan	   *fscan = (ForeignScan *)node->ss.ps.plan;
+	Bitmapset	   *referenced = NULL;
+	ListCell	   *lc;
+
+	foreach (lc, fscan->fdw_private)
+	{
+		int		k = lfirst_int(lc);
+
+		referenced = bms_add_member(referenced, k);
+	}
+	node->fdw_state = __arrowFdwExecInit(&node->ss,
+										 fscan->scan.plan.qual,
+										 referenced,
+										 NULL,	/* no GPU */
+										 NULL);	/* no DPU */
+}
+
+/*
+ * ExecArrowScanChunk
+ */
+static inline RecordBatchState *
+__arrowFdwNextRecordBatch(ArrowFdwState *arrow_state)
+{
+	RecordBatchState *rb_state;
+	uint32_t	rb_count;
+	uint32_t	rb_index;
+
+retry:
+	rb_count = pg_atomic_fetch_add_u32(arrow_state->rbatch_index, 1);
+	if (rb_count >= arrow_state->rb_nitems)
+		return NULL;	/* no more chunks to load */
+	rb_index = (rb_count + arrow_state->rb_startpos) % arrow_state->rb_nitems;
+	if (arrow_state->syncscan)
+		ss_report_location(&arrow_state->syncscan_rel, rb_index);
+	rb_state = arrow_state->rb_states[rb_index];
+	if (arrow_state->stats_hint)
+	{
+		if (execCheckArrowStatsHint(arrow_state->stats_hint, rb_state))
+		{
+			pg_atomic_fetch_add_u32(arrow_state->rbatch_nskip, 1);
+			goto retry;
+		}
+		pg_atomic_fetch_add_u32(arrow_state->rbatch_nload, 1);
+	}
+	/* prefetch the upcoming record-batches, if on the object storage */
+	for (int k=1; k <= arrow_object_prefetch_depth; k++)
+	{
+		if (rb_count + k >= arrow_state->rb_nitems)
+			break;
+		arrowFdwObjStoreFetchRecordBatch(arrow_state->rb_states[(rb_index + k) %
+																arrow_state->rb_nitems],
+										 arrow_state->referenced, false);
+	}
+	return rb_state;
+}
+
+/*
+ * __arrowFdwRowRangeIsAvailable
+ *
+ * A partial range of rows can be loaded, only if all the referenced columns
+ * are fixed-length and top-level ones.
+ */
+static bool
+__arrowFdwRowRangeIsAvailable(ArrowFdwState *arrow_state,
+							  RecordBatchState *rb_state)
+{
+	Bitmapset  *referenced = arrow_state->referenced;
+	bool		whole_row;
+	int			attidx;
+
+	if (rb_state->rb_compressed ||
+		rb_state->rb_parquet)
+		return false;
+	/* system columns depend on the row-index in the record-batch */
+	attidx = bms_next_member(referenced, -1);
+	if (attidx >= 0 && attidx < -FirstLowInvalidHeapAttributeNumber)
+		return false;
+	whole_row = bms_is_member(-FirstLowInvalidHeapAttributeNumber, referenced);
+	for (int j=0; j < rb_state->nfields; j++)
+	{
+		RecordBatchFieldState *rb_field = &rb_state->fields[j];
+
+		attidx = j + 1 - FirstLowInvalidHeapAttributeNumber;
+		if (!whole_row && !bms_is_member(attidx, referenced))
+			continue;
+		if (rb_field->attopts.unitsz <= 0 ||
+			rb_field->extra_length > 0 ||
+			rb_field->num_children > 0)
+			return false;
+		switch (rb_field->attopts.tag)
+		{
+			case ArrowType__Utf8:
+			case ArrowType__LargeUtf8:
+			case ArrowType__Binary:
+			case ArrowType__LargeBinary:
+			case ArrowType__Utf8View:
+			case ArrowType__BinaryView:
+			case ArrowType__List:
+			case ArrowType__LargeList:
+			case ArrowType__Struct:
+				return false;	/* variable-length */
+			default:
+				break;
+		}
+	}
+	return true;
+}
+
+/*
+ * __arrowFdwZoneMapRowRange
+ *
+ * It narrows the range of rows to be loaded using the zone-map, if possible.
+ * It returns false if the whole record-batch can be skipped.
+ */
+static bool
+__arrowFdwZoneMapRowRange(ArrowFdwState *arrow_state,
+						  RecordBatchState *rb_state,
+						  uint32_t *p_row_start,
+						  uint32_t *p_row_count)
+{
+	*p_row_start = 0;
+	*p_row_count = rb_state->rb_nitems;
+	if (!arrow_state->stats_hint ||
+		rb_state->zone_nitems == 0 ||
+		!__arrowFdwRowRangeIsAvailable(arrow_state, rb_state))
+		return true;
+	if (!execCheckArrowZoneMapHint(arrow_state->stats_hint, rb_state,
+								   p_row_start, p_row_count))
+	{
+		/* __arrowFdwNextRecordBatch already counted it as loaded */
+		pg_atomic_fetch_sub_u32(arrow_state->rbatch_nload, 1);
+		pg_atomic_fetch_add_u32(arrow_state->rbatch_nskip, 1);
+		return false;
+	}
+	return true;
+}
+
+/*
+ * __arrowFdwLateMaterialization
+ *
+ * It loads only the columns referenced by the scan qualifiers, then evaluates
+ * them on the host. If no rows survive, the record-batch is skipped without
+ * loading the remaining columns; elsewhere, it narrows the range of rows to
+ * be loaded by the first and the last survivors, if possible.
+ */
+static bool
+__arrowFdwLateMaterialization(ArrowFdwState *arrow_state,
+							  Relation frel,
+							  RecordBatchState *rb_state,
+							  uint32_t *p_row_start,
+							  uint32_t *p_row_count)
+{
+	arrowLateMaterialization *late_mat = arrow_state->late_mat;
+	ExprContext	   *econtext;
+	kern_data_store *kds;
+	uint32_t		row_end;
+	int64			row_head = -1;
+	int64			row_tail = -1;
+
+	if (!late_mat)
+		return true;
+	econtext = late_mat->econtext;
+	kds = arrowFdwFillupRecordBatch(frel,
+									late_mat->filter_attrs,
+									rb_state,
+									&late_mat->filter_buffer);
+	row_end = Min(*p_row_start + *p_row_count, kds->nitems);
+	for (uint32_t i = *p_row_start; i < row_end; i++)
+	{
+		if ((i & 0xffffU) == 0)
+			CHECK_FOR_INTERRUPTS();
+		ResetExprContext(econtext);
+		kds_arrow_fetch_tuple(late_mat->filter_slot, kds, i,
+							  late_mat->filter_attrs);
+		econtext->ecxt_scantuple = late_mat->filter_slot;
+		if (ExecQual(late_mat->filter_quals, econtext))
+		{
+			if (row_head < 0)
+				row_head = i;
+			row_tail = i;
+		}
+	}
+	if (row_head < 0)
+	{
+		/* __arrowFdwNextRecordBatch may count it as loaded */
+		if (arrow_state->stats_hint)
+			pg_atomic_fetch_sub_u32(arrow_state->rbatch_nload, 1);
+		pg_atomic_fetch_add_u32(arrow_state->rbatch_nlate, 1);
+		return false;
+	}
+	if (__arrowFdwRowRangeIsAvailable(arrow_state, rb_state))
+	{
+		*p_row_start = row_head;
+		*p_row_count = row_tail - row_head + 1;
+	}
+	return true;
+}
+
+/*
+ * pgstromScanChunkArrowFdw
+ */
+XpuCommand *
+pgstromScanChunkArrowFdw(pgstromTaskState *pts,
+						 struct iovec *xcmd_iov, int *xcmd_iovcnt)
+{
+	ArrowFdwState  *arrow_state = pts->arrow_state;
+	StringInfo		chunk_buffer = &arrow_state->chunk_buffer;
+	RecordBatchState *rb_state;
+	ArrowFileState *af_state;
+	strom_io_vector *iovec;
+	XpuCommand	   *xcmd;
+	uint32_t		kds_src_offset;
+	uint32_t		kds_src_iovec;
+	uint32_t		kds_src_pathname;
+	uint32_t		row_start;
+	uint32_t		row_count;
+
+	do {
+		rb_state = __arrowFdwNextRecordBatch(arrow_state);
+		if (!rb_state)
+		{
+			pts->scan_done = true;
+			return NULL;
+		}
+	} while (!__arrowFdwZoneMapRowRange(arrow_state, rb_state,
+										&row_start, &row_count) ||
+			 !__arrowFdwLateMaterialization(arrow_state,
+											pts->css.ss.ss_currentRelation,
+											rb_state,
+											&row_start, &row_count));
+	af_state = rb_state->af_state;
+	if (rb_state->rb_compressed && pts->ds_entry)
+		elog(ERROR, "arrow_fdw: compressed record-batch is not supported on DPU ('%s')",
+			 af_state->filename);
+	if (rb_state->rb_parquet && pts->ds_entry)
+		elog(ERROR, "arrow_fdw: parquet file is not supported on DPU ('%s')",
+			 af_state->filename);
+	if (pts->ds_entry &&
+		arrowFdwPartitionKeysReferenced(rb_state, arrow_state->referenced))
+		elog(ERROR, "arrow_fdw: partition keys are not supported on DPU ('%s')",
+			 af_state->filename);
+	if (pts->ds_entry &&
+		arrowFdwVariadicViewsReferenced(rb_state, arrow_state->referenced))
+		elog(ERROR, "arrow_fdw: views with multiple variadic buffers are not supported on DPU ('%s')",
+			 af_state->filename);
+
+	/* XpuCommand header */
+	resetStringInfo(chunk_buffer);
+	appendBinaryStringInfo(chunk_buffer,
+						   pts->xcmd_buf.data,
+						   pts->xcmd_buf.len);
+	/* kds_src + iovec */
+	kds_src_offset = chunk_buffer->len;
+	iovec = arrowFdwLoadRecordBatch(pts->css.ss.ss_currentRelation,
+									arrow_state->referenced,
+									rb_state,
+									chunk_buffer,
+									row_start,
+									row_count);
+	kds_src_iovec = __appendBinaryStringInfo(chunk_buffer,
+											 iovec,
+											 offsetof(strom_io_vector,
+													  ioc[iovec->nr_chunks]));
+	/* arrow filename */
+	kds_src_pathname = chunk_buffer->len;
+	if (!pts->ds_entry)
+		appendStringInfoString(chunk_buffer, af_state->filename);
+	else
+		appendStringInfoString(chunk_buffer, af_state->dpu_path);
+	appendStringInfoChar(chunk_buffer, '\0');
+
+	/* assign offset of XpuCommand */
+	xcmd = (XpuCommand *)chunk_buffer->data;
+	xcmd->length = chunk_buffer->len;
+	xcmd->u.task.kds_src_pathname = kds_src_pathname;
+	xcmd->u.task.kds_src_iovec    = kds_src_iovec;
+	xcmd->u.task.kds_src_offset   = kds_src_offset;
+
+	xcmd_iov->iov_base = xcmd;
+	xcmd_iov->iov_len  = xcmd->length;
+	*xcmd_iovcnt = 1;
+
+	return xcmd;
+}
+
+/*
+ * ArrowIterateForeignScan
+ */
+static TupleTableSlot *
+ArrowIterateForeignScan(ForeignScanState *node)
+{
+	ArrowFdwState *arrow_state = node->fdw_state;
+	TupleTableSlot *slot = node->ss.ss_ScanTupleSlot;
+	Relation	frel = node->ss.ss_currentRelation;
+	arrowCpuBatch *cpu_batch = arrow_state->cpu_batch;
+
+	if (!cpu_batch)
+	{
+		cpu_batch = __arrowCpuBatchCreate(arrow_state, RelationGetDescr(frel));
+		arrow_state->cpu_batch = cpu_batch;
+	}
+	while (cpu_batch->row_index >= cpu_batch->row_count)
+	{
+		RecordBatchState *rb_state;
+		uint32_t	row_start = 0;
+		uint32_t	row_count;
+
+		/* next window of the current record-batch */
+		if (cpu_batch->rb_state &&
+			cpu_batch->row_base + cpu_batch->row_count < cpu_batch->nitems)
+		{
+			cpu_batch->row_base += cpu_batch->row_count;
+			__arrowCpuBatchDecodeWindow(cpu_batch);
+			continue;
+		}
+		cpu_batch->rb_state = NULL;
+		rb_state = __arrowFdwNextRecordBatch(arrow_state);
+		if (!rb_state)
+			return NULL;
+		/* record-batch is decoded as a whole, so only skips the record-batch */
+		row_count = rb_state->rb_nitems;
+		if (!__arrowFdwLateMaterialization(arrow_state, frel, rb_state,
+										   &row_start, &row_count))
+			continue;
+		if (!__arrowCpuBatchSetupViewByMmap(cpu_batch, rb_state,
+											arrow_state->referenced))
+		{
+			kern_data_store *kds
+				= arrowFdwFillupRecordBatch(frel,
+											arrow_state->referenced,
+											rb_state,
+											&arrow_state->chunk_buffer);
+			__arrowCpuBatchSetupViewByKds(cpu_batch, kds);
+		}
+		cpu_batch->rb_state = rb_state;
+		cpu_batch->nitems = (cpu_batch->kds
+							 ? cpu_batch->kds->nitems
+							 : rb_state->rb_nitems);
+		cpu_batch->row_base = 0;
+		cpu_batch->row_count = 0;
+		cpu_batch->row_index = 0;
+		if (cpu_batch->nitems > 0)
+			__arrowCpuBatchDecodeWindow(cpu_batch);
+	}
+	__arrowCpuBatchFetchTuple(cpu_batch, slot);
+	return slot;
+}
+
+/*
+ * pgstromArrowFdwFileSignature
+ *
+ * It returns the signature of the arrow files to be scanned, based on the
+ * current inode, size and mtime.
+ */
+bool
+pgstromArrowFdwFileSignature(ArrowFdwState *arrow_state,
+							 uint64_t *p_signature)
+{
+	uint64_t	signature = 0;
+	ListCell   *lc;
+
+	foreach (lc, arrow_state->af_states_list)
+	{
+		ArrowFileState *af_state = lfirst(lc);
+		struct stat	stat_buf;
+		uint64_t	keys[6];
+
+		if (stat(af_state->filename, &stat_buf) != 0)
+			return false;
+		keys[0] = stat_buf.st_dev;
+		keys[1] = stat_buf.st_ino;
+		keys[2] = stat_buf.st_size;
+		keys[3] = stat_buf.st_mtim.tv_sec;
+		keys[4] = stat_buf.st_mtim.tv_nsec;
+		/* partial scan on the refresh of incremental aggregates */
+		keys[5] = list_length(af_state->rb_list);
+		if (af_state->rb_list != NIL)
+		{
+			RecordBatchState *rb_state = linitial(af_state->rb_list);
+
+			keys[5] |= ((uint64_t)rb_state->rb_index << 32);
+		}
+		signature = hash_combine64(signature,
+								   hash_bytes_extended((const unsigned char *)keys,
+													   sizeof(keys), 0));
+	}
+	*p_signature = (signature != 0 ? signature : 1);
+	return true;
+}
+
+/*
+ * ArrowReScanForeignScan
+ */
+void
+pgstromArrowFdwExecReset(ArrowFdwState *arrow_state)
+{
+	pg_atomic_write_u32(arrow_state->rbatch_index, 0);
+	/* NOTE: KDS is on the chunk_buffer, so never pfree() it here */
+	if (arrow_state->cpu_batch)
+		__arrowCpuBatchRelease(arrow_state->cpu_batch);
+}
+
+static void
+ArrowReScanForeignScan(ForeignScanState *node)
+{
+	pgstromArrowFdwExecReset(node->fdw_state);
+}
+
+/*
+ * ExecEndArrowScan
+ */
+void
+pgstromArrowFdwExecEnd(ArrowFdwState *arrow_state)
+{
+	if (arrow_state->curr_filp >= 0)
+		FileClose(arrow_state->curr_filp);
+	if (arrow_state->cpu_batch)
+		__arrowCpuBatchRelease(arrow_state->cpu_batch);
+	if (arrow_state->stats_hint)
+		execEndArrowStatsHint(arrow_state->stats_hint);
+	if (arrow_state->late_mat)
+		execEndArrowLateMaterialization(arrow_state->late_mat);
+}
+
+static void
+ArrowEndForeignScan(ForeignScanState *node)
+{
+	pgstromArrowFdwExecEnd(node->fdw_state);
+}
+
+/*
+ * ArrowIsForeignScanParallelSafe
+ */
+static bool
+ArrowIsForeignScanParallelSafe(PlannerInfo *root,
+							   RelOptInfo *rel,
+							   RangeTblEntry *rte)
+{
+	return true;
+}
+
+/*
+ * ArrowEstimateDSMForeignScan
+ */
+static Size
+ArrowEstimateDSMForeignScan(ForeignScanState *node,
+							ParallelContext *pcxt)
+{
+	return offsetof(pgstromSharedState, inners);
+}
+
+/*
+ * ArrowInitializeDSMForeignScan
+ */
+void
+pgstromArrowFdwInitDSM(ArrowFdwState *arrow_state,
+					   pgstromSharedState *ps_state)
+{
+	arrow_state->rbatch_index = &ps_state->arrow_rbatch_index;
+	arrow_state->rbatch_nload = &ps_state->arrow_rbatch_nload;
+	arrow_state->rbatch_nskip = &ps_state->arrow_rbatch_nskip;
+	arrow_state->rbatch_nlate = &ps_state->arrow_rbatch_nlate;
+	/* parallel scan shares the position counter, so never synchronized */
+	arrow_state->syncscan = false;
+	arrow_state->rb_startpos = 0;
+}
+
+static void
+ArrowInitializeDSMForeignScan(ForeignScanState *node,
+                              ParallelContext *pcxt,
+                              void *coordinate)
+{
+	pgstromSharedState *ps_state = (pgstromSharedState *)coordinate;
+
+	memset(ps_state, 0, offsetof(pgstromSharedState, inners));
+	pgstromArrowFdwInitDSM(node->fdw_state, ps_state);
+}
+
+/*
+ * ArrowInitializeWorkerForeignScan
+ */
+void
+pgstromArrowFdwAttachDSM(ArrowFdwState *arrow_state,
+						 pgstromSharedState *ps_state)
+{
+	arrow_state->rbatch_index = &ps_state->arrow_rbatch_index;
+	arrow_state->rbatch_nload = &ps_state->arrow_rbatch_nload;
+	arrow_state->rbatch_nskip = &ps_state->arrow_rbatch_nskip;
+	arrow_state->rbatch_nlate = &ps_state->arrow_rbatch_nlate;
+	arrow_state->syncscan = false;
+	arrow_state->rb_startpos = 0;
+}
+
+static void
+ArrowInitializeWorkerForeignScan(ForeignScanState *node,
+								 shm_toc *toc,
+								 void *coordinate)
+{
+	pgstromSharedState *ps_state = (pgstromSharedState *)coordinate;
+
+	pgstromArrowFdwAttachDSM(node->fdw_state, ps_state);
+}
+
+/*
+ * ArrowShutdownForeignScan
+ */
+void
+pgstromArrowFdwShutdown(ArrowFdwState *arrow_state)
+{
+	uint32		temp;
+
+	temp = pg_atomic_read_u32(arrow_state->rbatch_index);
+	pg_atomic_write_u32(&arrow_state->__rbatch_index_local, temp);
+	arrow_state->rbatch_index = &arrow_state->__rbatch_index_local;
+
+	temp = pg_atomic_read_u32(arrow_state->rbatch_nload);
+	pg_atomic_write_u32(&arrow_state->__rbatch_nload_local, temp);
+	arrow_state->rbatch_nload = &arrow_state->__rbatch_nload_local;
+
+	temp = pg_atomic_read_u32(arrow_state->rbatch_nskip);
+	pg_atomic_write_u32(&arrow_state->__rbatch_nskip_local, temp);
+	arrow_state->rbatch_nskip = &arrow_state->__rbatch_nskip_local;
+
+	temp = pg_atomic_read_u32(arrow_state->rbatch_nlate);
+	pg_atomic_write_u32(&arrow_state->__rbatch_nlate_local, temp);
+	arrow_state->rbatch_nlate = &arrow_state->__rbatch_nlate_local;
+}
+
+static void
+ArrowShutdownForeignScan(ForeignScanState *node)
+{
+	pgstromArrowFdwShutdown(node->fdw_state);
+}
+
+/*
+ * ArrowExplainForeignScan
+ */
+void
+pgstromArrowFdwExplain(ArrowFdwState *arrow_state,
+					   Relation frel,
+					   ExplainState *es,
+					   List *dcontext)
+{
+	TupleDesc	tupdesc = RelationGetDescr(frel);
+	size_t	   *chunk_sz;
+	ListCell   *lc1, *lc2;
+	int			fcount = 0;
+	int			j, k;
+	char		label[100];
+	StringInfoData	buf;
+
+	initStringInfo(&buf);
+	/* shows referenced columns */
+	for (k = bms_next_member(arrow_state->referenced, -1);
+		 k >= 0;
+		 k = bms_next_member(arrow_state->referenced, k))
+	{
+		j = k + FirstLowInvalidHeapAttributeNumber;
+
+		if (j > 0)
+		{
+			Form_pg_attribute attr = TupleDescAttr(tupdesc, j-1);
+			const char	   *attname = NameStr(attr->attname);
+
+			if (buf.len > 0)
+				appendStringInfoString(&buf, ", ");
+			appendStringInfoString(&buf, quote_identifier(attname));
+		}
+	}
+	ExplainPropertyText("referenced", buf.data, es);
+
+	/* shows stats hint if any */
+	if (arrow_state->stats_hint)
+	{
+		arrowStatsHint *stats_hint = arrow_state->stats_hint;
+
+		resetStringInfo(&buf);
+		foreach (lc1, stats_hint->orig_quals)
+		{
+			Node   *qual = lfirst(lc1);
+			char   *temp;
+
+			temp = deparse_expression(qual, dcontext, es->verbose, false);
+			if (buf.len > 0)
+				appendStringInfoString(&buf, ", ");
+			appendStringInfoString(&buf, temp);
+			pfree(temp);
+		}
+		if (es->analyze)
+			appendStringInfo(&buf, "  [loaded: %u, skipped: %u]",
+							 pg_atomic_read_u32(arrow_state->rbatch_nload),
+							 pg_atomic_read_u32(arrow_state->rbatch_nskip));
+		ExplainPropertyText("Stats-Hint", buf.data, es);
+	}
+
+	/* shows late materialization if any */
+	if (arrow_state->late_mat)
+	{
+		arrowLateMaterialization *late_mat = arrow_state->late_mat;
+
+		resetStringInfo(&buf);
+		foreach (lc1, late_mat->orig_quals)
+		{
+			Node   *qual = lfirst(lc1);
+			char   *temp;
+
+			temp = deparse_expression(qual, dcontext, es->verbose, false);
+			if (buf.len > 0)
+				appendStringInfoString(&buf, ", ");
+			appendStringInfoString(&buf, temp);
+			pfree(temp);
+		}
+		if (es->analyze)
+			appendStringInfo(&buf, "  [skipped: %u]",
+							 pg_atomic_read_u32(arrow_state->rbatch_nlate));
+		ExplainPropertyText("Late-Materialization", buf.data, es);
+	}
 
-				if (tupdesc->natts != cmeta->num_subattrs)
-					elog(ERROR, "Struct definition is conrrupted?");
-				if (cmeta->idx_subattrs < kds->ncols ||
-					cmeta->idx_subattrs + cmeta->num_subattrs > kds->nr_colmeta)
-					elog(ERROR, "Bug? strange kernel column metadata");
-				for (int j=0; j < tupdesc->natts; j++)
-				{
-					kern_colmeta *sub_meta = &kds->colmeta[cmeta->idx_subattrs + j];
+	/* shows files on behalf of the foreign table */
+	chunk_sz = alloca(sizeof(size_t) * tupdesc->natts);
+	memset(chunk_sz, 0, sizeof(size_t) * tupdesc->natts);
+	foreach (lc1, arrow_state->af_states_list)
+	{
+		ArrowFileState *af_state = lfirst(lc1);
+		size_t		total_sz = af_state->stat_buf.st_size;
+		size_t		read_sz = 0;
+		size_t		sz;
 
-					pg_datum_arrow_ref(kds, sub_meta, index,
-									   sub_values + j,
-									   sub_isnull + j);
+		foreach (lc2, af_state->rb_list)
+		{
+			RecordBatchState *rb_state = lfirst(lc2);
+
+			if (bms_is_member(-FirstLowInvalidHeapAttributeNumber,
+							  arrow_state->referenced))
+			{
+				/* whole-row reference */
+				read_sz += rb_state->rb_length;
+			}
+			else
+			{
+				for (k = bms_next_member(arrow_state->referenced, -1);
+					 k >= 0;
+					 k = bms_next_member(arrow_state->referenced, k))
+				{
+					j = k + FirstLowInvalidHeapAttributeNumber - 1;
+					if (j < 0 || j >=  tupdesc->natts)
+						continue;
+					sz = __recordBatchFieldLength(&rb_state->fields[j]);
+					read_sz += sz;
+					chunk_sz[j] += sz;
 				}
-				htup = heap_form_tuple(tupdesc, sub_values, sub_isnull);
+			}
+		}
 
-				ReleaseTupleDesc(tupdesc);
+		/* file size and read size */
+		if (es->format == EXPLAIN_FORMAT_TEXT)
+		{
+			resetStringInfo(&buf);
+			appendStringInfo(&buf, "%s (read: %s, size: %s)",
+							 af_state->filename,
+							 format_bytesz(read_sz),
+							 format_bytesz(total_sz));
+			snprintf(label, sizeof(label), "file%d", fcount);
+			ExplainPropertyText(label, buf.data, es);
+		}
+		else
+		{
+			snprintf(label, sizeof(label), "file%d", fcount);
+			ExplainPropertyText(label, af_state->filename, es);
 
-				datum = PointerGetDatum(htup->t_data);
-				isnull = false;
-			}
-			break;
-		default:
-			/* TODO: custom data type support here */
-			elog(ERROR, "arrow_fdw: unknown or unsupported type");
+			snprintf(label, sizeof(label), "file%d-read", fcount);
+			ExplainPropertyText(label, format_bytesz(read_sz), es);
+
+			snprintf(label, sizeof(label), "file%d-size", fcount);
+			ExplainPropertyText(label, format_bytesz(total_sz), es);
+		}
+		fcount++;
 	}
-out:
-	*p_datum  = datum;
-	*p_isnull = isnull;
+
+	/* read-size per column (only verbose mode) */
+	if (es->verbose && arrow_state->rb_nitems > 0 &&
+		!bms_is_member(-FirstLowInvalidHeapAttributeNumber,
+					   arrow_state->referenced))
+	{
+		resetStringInfo(&buf);
+		for (k = bms_next_member(arrow_state->referenced, -1);
+			 k >= 0;
+			 k = bms_next_member(arrow_state->referenced, k))
+		{
+			Form_pg_attribute attr;
+
+			j = k + FirstLowInvalidHeapAttributeNumber - 1;
+			if (j < 0 || j >= tupdesc->natts)
+				continue;
+			attr = TupleDescAttr(tupdesc, j);
+			snprintf(label, sizeof(label), "  %s", NameStr(attr->attname));
+			ExplainPropertyText(label, format_bytesz(chunk_sz[j]), es);
+		}
+	}
+	pfree(buf.data);
+}
+
+static void
+ArrowExplainForeignScan(ForeignScanState *node, ExplainState *es)
+{
+	Relation		frel = node->ss.ss_currentRelation;
+	List		   *dcontext;
+
+	dcontext = set_deparse_context_plan(es->deparse_cxt,
+										node->ss.ps.plan,
+										NULL);
+	pgstromArrowFdwExplain(node->fdw_state, frel, es, dcontext);
 }
 
 /*
- * KDS_fetch_tuple_arrow
+ * ArrowAnalyzeForeignTable
  */
-bool
-kds_arrow_fetch_tuple(TupleTableSlot *slot,
-					  kern_data_store *kds,
-					  size_t index,
-					  const Bitmapset *referenced)
+static int
+RecordBatchAcquireSampleRows(Relation relation,
+							 RecordBatchState *rb_state,
+							 HeapTuple *rows,
+							 int nsamples)
 {
-	int		j, k;
+	TupleDesc		tupdesc = RelationGetDescr(relation);
+	kern_data_store *kds;
+	Bitmapset	   *referenced = NULL;
+	StringInfoData	buffer;
+	Datum		   *values;
+	bool		   *isnull;
+	int				count;
+	uint32_t		index;
 
-	if (index >= kds->nitems)
-		return false;
-	ExecStoreAllNullTuple(slot);
-	for (k = bms_next_member(referenced, -1);
-		 k >= 0;
-		 k = bms_next_member(referenced, k))
+	/* ANALYZE needs to fetch all the attributes */
+	referenced = bms_make_singleton(-FirstLowInvalidHeapAttributeNumber);
+	initStringInfo(&buffer);
+	kds = arrowFdwFillupRecordBatch(relation,
+									referenced,
+									rb_state,
+									&buffer);
+	values = alloca(sizeof(Datum) * tupdesc->natts);
+	isnull = alloca(sizeof(bool)  * tupdesc->natts);
+	for (count = 0; count < nsamples; count++)
 	{
-		j = k + FirstLowInvalidHeapAttributeNumber - 1;
-		if (j < 0)
-			continue;
-		pg_datum_arrow_ref(kds,
-						   &kds->colmeta[j],
-						   index,
-						   slot->tts_values + j,
-						   slot->tts_isnull + j);
+		/* fetch a row randomly */
+		index = (double)kds->nitems * drand48();
+		Assert(index < kds->nitems);
+
+		for (int j=0; j < kds->ncols; j++)
+		{
+			kern_colmeta   *cmeta = &kds->colmeta[j];
+
+			pg_datum_arrow_ref(kds,
+							   cmeta,
+							   index,
+							   values + j,
+							   isnull + j);
+		}
+		rows[count] = heap_form_tuple(tupdesc, values, isnull);
 	}
-	return true;
-}
+	pfree(buffer.data);
 
-/* ----------------------------------------------------------------
- *
- * Executor callbacks
- *
- * ----------------------------------------------------------------
- */
+	return count;
+}
 
-/*
- * __arrowFdwExecInit
- */
-static ArrowFdwState *
-__arrowFdwExecInit(ScanState *ss,
-				   List *outer_quals,
-				   const Bitmapset *outer_refs,
-				   const Bitmapset **p_optimal_gpus,
-				   const DpuStorageEntry **p_ds_entry)
+static int
+ArrowAcquireSampleRows(Relation relation,
+					   int elevel,
+					   HeapTuple *rows,
+					   int nrooms,
+					   double *p_totalrows,
+					   double *p_totaldeadrows)
 {
-	Relation		frel = ss->ss_currentRelation;
-	TupleDesc		tupdesc = RelationGetDescr(frel);
-	ForeignTable   *ft = GetForeignTable(RelationGetRelid(frel));
-	Bitmapset	   *referenced = NULL;
-	Bitmapset	   *stat_attrs = NULL;
-	Bitmapset	   *optimal_gpus = NULL;
-	const DpuStorageEntry *ds_entry = NULL;
-	bool			whole_row_ref = false;
+	ForeignTable   *ft = GetForeignTable(RelationGetRelid(relation));
 	List		   *filesList;
-	List		   *af_states_list = NIL;
-	uint32_t		rb_nrooms = 0;
-	uint32_t		rb_nitems = 0;
-	ArrowFdwState *arrow_state;
+	List		   *rb_state_list = NIL;
 	ListCell	   *lc1, *lc2;
+	int64			total_nrows = 0;
+	int64			count_nrows = 0;
+	int				nsamples_min = nrooms / 100;
+	int				nitems = 0;
+	bool			hive_partitioning;
+	MemoryContext	oldcxt;
 
-	Assert(RelationIsArrowFdw(frel));
-	/* expand 'referenced' if it has whole-row reference */
-	if (bms_is_member(-FirstLowInvalidHeapAttributeNumber, outer_refs))
-		whole_row_ref = true;
-	for (int j=0; j < tupdesc->natts; j++)
+	filesList = arrowFdwExtractFilesList(ft->options, NULL,
+										 &hive_partitioning);
+	foreach (lc1, filesList)
 	{
-		Form_pg_attribute attr = TupleDescAttr(tupdesc, j);
-		int		k = attr->attnum - FirstLowInvalidHeapAttributeNumber;
+		ArrowFileState *af_state;
+		char	   *fname = strVal(lfirst(lc1));
 
-		if (attr->attisdropped)
+		af_state = BuildArrowFileState(relation, fname,
+									   hive_partitioning, NULL);
+		if (!af_state)
 			continue;
-		if (whole_row_ref || bms_is_member(k, outer_refs))
-			referenced = bms_add_member(referenced, k);
+		foreach (lc2, af_state->rb_list)
+		{
+			RecordBatchState *rb_state = lfirst(lc2);
+
+			if (rb_state->rb_nitems == 0)
+				continue;	/* not reasonable to sample, skipped */
+			total_nrows += rb_state->rb_nitems;
+			rb_state_list = lappend(rb_state_list, rb_state);
+		}
 	}
+	nrooms = Min(nrooms, total_nrows);
 
-	/* setup ArrowFileState */
-	filesList = arrowFdwExtractFilesList(ft->options, NULL);
-	foreach (lc1, filesList)
+	/* fetch samples for each record-batch */
+	foreach (lc1, rb_state_list)
 	{
-		char	   *fname = strVal(lfirst(lc1));
-		ArrowFileState *af_state;
+		RecordBatchState *rb_state = lfirst(lc1);
+		int			nsamples;
 
-		af_state = BuildArrowFileState(frel, fname, &stat_attrs);
-		if (af_state)
-		{
-			rb_nrooms += list_length(af_state->rb_list);
-			if (p_optimal_gpus)
-			{
-				const Bitmapset  *__optimal_gpus = GetOptimalGpuForFile(fname);
+		count_nrows += rb_state->rb_nitems;
+		nsamples = (double)nrooms * ((double)count_nrows /
+									 (double)total_nrows) - nitems;
+		if (nitems + nsamples > nrooms)
+			nsamples = nrooms - nitems;
+		if (nsamples > nsamples_min)
+			nitems += RecordBatchAcquireSampleRows(relation,
+												   rb_state,
+												   rows + nitems,
+												   nsamples);
+	}
+	*p_totalrows = total_nrows;
+	*p_totaldeadrows = 0.0;
 
-				if (af_states_list == NIL)
-					optimal_gpus = bms_copy(__optimal_gpus);
-				else
-					optimal_gpus = bms_intersect(optimal_gpus, __optimal_gpus);
-			}
-			if (p_ds_entry)
-			{
-				const DpuStorageEntry *ds_temp;
+	/* pg_statistic shall be adjusted at the end of ANALYZE */
+	oldcxt = MemoryContextSwitchTo(TopMemoryContext);
+	arrow_analyze_pending = list_append_unique_oid(arrow_analyze_pending,
+												   RelationGetRelid(relation));
+	MemoryContextSwitchTo(oldcxt);
 
-				if (af_states_list == NIL)
-					ds_entry = GetOptimalDpuForFile(fname, &af_state->dpu_path);
-				else if (ds_entry)
-				{
-					ds_temp = GetOptimalDpuForFile(fname, &af_state->dpu_path);
-					if (!DpuStorageEntryIsEqual(ds_entry, ds_temp))
-						ds_entry = NULL;
-				}
-			}
-			af_states_list = lappend(af_states_list, af_state);
-		}
-	}
+	return nitems;
+}
 
-	/* setup ArrowFdwState */
-	arrow_state = palloc0(offsetof(ArrowFdwState, rb_states[rb_nrooms]));
-	arrow_state->referenced = referenced;
-	if (arrow_fdw_stats_hint_enabled)
-		arrow_state->stats_hint = execInitArrowStatsHint(ss, outer_quals, stat_attrs);
-	arrow_state->rbatch_index = &arrow_state->__rbatch_index_local;
-	arrow_state->rbatch_nload = &arrow_state->__rbatch_nload_local;
-	arrow_state->rbatch_nskip = &arrow_state->__rbatch_nskip_local;
-	initStringInfo(&arrow_state->chunk_buffer);
-	arrow_state->curr_filp  = -1;
-	arrow_state->curr_kds   = NULL;
-	arrow_state->curr_index = 0;
-	arrow_state->af_states_list = af_states_list;
-	foreach (lc1, af_states_list)
+/*
+ * ArrowAnalyzeForeignTable
+ */
+static bool
+ArrowAnalyzeForeignTable(Relation frel,
+						 AcquireSampleRowsFunc *p_sample_rows_func,
+						 BlockNumber *p_totalpages)
+{
+	ForeignTable   *ft = GetForeignTable(RelationGetRelid(frel));
+	List		   *filesList = arrowFdwExtractFilesList(ft->options, NULL, NULL);
+	ListCell	   *lc;
+	size_t			totalpages = 0;
+
+	foreach (lc, filesList)
 	{
-		ArrowFileState *af_state = lfirst(lc1);
+		const char	   *fname = strVal(lfirst(lc));
+		struct stat		stat_buf;
 
-		foreach (lc2, af_state->rb_list)
+		if (stat(fname, &stat_buf) != 0)
 		{
-			RecordBatchState *rb_state = lfirst(lc2);
-
-			arrow_state->rb_states[rb_nitems++] = rb_state;
+			elog(NOTICE, "failed on stat('%s') on behalf of '%s', skipped",
+				 fname, get_rel_name(ft->relid));
+			continue;
 		}
+		totalpages += (stat_buf.st_size + BLCKSZ - 1) / BLCKSZ;
 	}
-	Assert(rb_nrooms == rb_nitems);
-	arrow_state->rb_nitems = rb_nitems;
+	if (totalpages > MaxBlockNumber)
+		totalpages = MaxBlockNumber;
 
-	if (p_optimal_gpus)
-		*p_optimal_gpus = optimal_gpus;
-	if (p_ds_entry)
-		*p_ds_entry = ds_entry;
+	*p_sample_rows_func = ArrowAcquireSampleRows;
+	*p_totalpages = totalpages;
 
-	return arrow_state;
+	return true;
 }
 
 /*
- * pgstromArrowFdwExecInit
+ * ANALYZE post-processing
+ *
+ * ANALYZE builds pg_statistic from the sampled rows, so null fraction,
+ * ndistinct and histogram bounds are often inaccurate on large arrow files.
+ * Once ANALYZE completes, they are adjusted by the metadata embedded in
+ * the arrow files (null_count and min_values/max_values), and by the
+ * ndistinct estimated with pgstrom.hll_count() over the whole columns,
+ * which shall be run by GpuPreAgg if GPU is available.
  */
-bool
-pgstromArrowFdwExecInit(pgstromTaskState *pts,
-						List *outer_quals,
-						const Bitmapset *outer_refs)
+typedef struct
 {
-	Relation		frel = pts->css.ss.ss_currentRelation;
-	ArrowFdwState  *arrow_state = NULL;
+	int64		null_count;
+	bool		minmax_valid;	/* false, if any record-batch has no stats */
+	bool		minmax_found;
+	Datum		min_datum;
+	Datum		max_datum;
+	double		ndistinct;		/* estimated by HLL, or 0.0 */
+	TypeCacheEntry *tcache;
+} arrowAnalyzeAttrState;
 
-	if (RelationIsArrowFdw(frel))
+static void
+__arrowAnalyzeMergeMinMax(arrowAnalyzeAttrState *aa_state,
+						  Form_pg_attribute attr,
+						  RecordBatchFieldState *rb_field)
+{
+	MinMaxStatDatum *stat_datum = &rb_field->stat_datum;
+	Datum		min_datum;
+	Datum		max_datum;
+
+	if (!aa_state->minmax_valid)
+		return;
+	if (stat_datum->isnull ||
+		rb_field->atttypid != attr->atttypid ||
+		!aa_state->tcache ||
+		!OidIsValid(aa_state->tcache->cmp_proc_finfo.fn_oid))
 	{
-		arrow_state = __arrowFdwExecInit(&pts->css.ss,
-										 outer_quals,
-										 outer_refs,
-										 (pts->xpu_task_flags & DEVKIND__NVIDIA_GPU) != 0
-											? &pts->optimal_gpus : NULL,
-										 (pts->xpu_task_flags & DEVKIND__NVIDIA_DPU) != 0
-											? &pts->ds_entry : NULL);
+		aa_state->minmax_valid = false;
+		return;
+	}
+	if (rb_field->atttypid == NUMERICOID)
+	{
+		min_datum = PointerGetDatum(&stat_datum->min.numeric);
+		max_datum = PointerGetDatum(&stat_datum->max.numeric);
+	}
+	else
+	{
+		min_datum = stat_datum->min.datum;
+		max_datum = stat_datum->max.datum;
+	}
+	if (!aa_state->minmax_found)
+	{
+		aa_state->min_datum = min_datum;
+		aa_state->max_datum = max_datum;
+		aa_state->minmax_found = true;
+	}
+	else
+	{
+		FmgrInfo   *cmp_fn = &aa_state->tcache->cmp_proc_finfo;
+
+		if (DatumGetInt32(FunctionCall2Coll(cmp_fn, attr->attcollation,
+											min_datum,
+											aa_state->min_datum)) < 0)
+			aa_state->min_datum = min_datum;
+		if (DatumGetInt32(FunctionCall2Coll(cmp_fn, attr->attcollation,
+											max_datum,
+											aa_state->max_datum)) > 0)
+			aa_state->max_datum = max_datum;
 	}
-	pts->arrow_state = arrow_state;
-	return (pts->arrow_state != NULL);
 }
 
 /*
- * ArrowBeginForeignScan
+ * __arrowAnalyzeHllNDistinct
  */
 static void
-ArrowBeginForeignScan(ForeignScanState *node, int eflags)
+__arrowAnalyzeHllNDistinct(Relation frel, arrowAnalyzeAttrState *aa_states)
 {
-	ForeignScan	   *fscan = (ForeignScan *)node->ss.ps.plan;
-	Bitmapset	   *referenced = NULL;
-	ListCell	   *lc;
+	TupleDesc	tupdesc = RelationGetDescr(frel);
+	List	   *func_name = list_make2(makeString("pgstrom"),
+									   makeString("hll_count"));
+	int		   *anums = alloca(sizeof(int) * tupdesc->natts);
+	int			nitems = 0;
+	StringInfoData buf;
 
-	foreach (lc, fscan->fdw_private)
+	initStringInfo(&buf);
+	appendStringInfoString(&buf, "SELECT ");
+	for (int j=0; j < tupdesc->natts; j++)
 	{
-		int		k = lfirst_int(lc);
+		Form_pg_attribute attr = TupleDescAttr(tupdesc, j);
+		Oid			type_oid;
 
-		referenced = bms_add_member(referenced, k);
+		if (attr->attisdropped)
+			continue;
+		type_oid = getBaseType(attr->atttypid);
+		if (!OidIsValid(LookupFuncName(func_name, 1, &type_oid, true)))
+			continue;
+		appendStringInfo(&buf, "%spgstrom.hll_count(%s)",
+						 nitems > 0 ? ", " : "",
+						 quote_identifier(NameStr(attr->attname)));
+		anums[nitems++] = j;
 	}
-	node->fdw_state = __arrowFdwExecInit(&node->ss,
-										 fscan->scan.plan.qual,
-										 referenced,
-										 NULL,	/* no GPU */
-										 NULL);	/* no DPU */
+	if (nitems == 0)
+		return;
+	appendStringInfo(&buf, " FROM ONLY %s",
+					 quote_qualified_identifier(get_namespace_name(RelationGetNamespace(frel)),
+												RelationGetRelationName(frel)));
+	if (SPI_connect() != SPI_OK_CONNECT)
+		elog(ERROR, "failed on SPI_connect");
+	if (SPI_execute(buf.data, false, 1) != SPI_OK_SELECT ||
+		SPI_processed != 1)
+		elog(ERROR, "arrow_fdw: failed on SPI_execute('%s')", buf.data);
+	for (int k=0; k < nitems; k++)
+	{
+		Datum	datum;
+		bool	isnull;
+
+		datum = SPI_getbinval(SPI_tuptable->vals[0],
+							  SPI_tuptable->tupdesc,
+							  k+1, &isnull);
+		if (!isnull)
+			aa_states[anums[k]].ndistinct = (double)DatumGetInt64(datum);
+	}
+	SPI_finish();
+	pfree(buf.data);
 }
 
 /*
- * ExecArrowScanChunk
+ * __arrowAnalyzeUpdateStatistic
  */
-static inline RecordBatchState *
-__arrowFdwNextRecordBatch(ArrowFdwState *arrow_state)
+static void
+__arrowAnalyzeUpdateStatistic(Relation frel, Relation srel,
+							  Form_pg_attribute attr,
+							  arrowAnalyzeAttrState *aa_state,
+							  int64 total_nrows)
 {
-	RecordBatchState *rb_state;
-	uint32_t	rb_index;
+	Datum		values[Natts_pg_statistic];
+	bool		nulls[Natts_pg_statistic];
+	bool		replaces[Natts_pg_statistic];
+	Form_pg_statistic stat;
+	AttributeOpts *aopt;
+	HeapTuple	htup;
+	HeapTuple	newtup;
+
+	htup = SearchSysCache3(STATRELATTINH,
+						   ObjectIdGetDatum(RelationGetRelid(frel)),
+						   Int16GetDatum(attr->attnum),
+						   BoolGetDatum(false));
+	if (!HeapTupleIsValid(htup))
+		return;		/* ANALYZE skipped this column */
+	stat = (Form_pg_statistic) GETSTRUCT(htup);
+	memset(values, 0, sizeof(values));
+	memset(nulls, 0, sizeof(nulls));
+	memset(replaces, 0, sizeof(replaces));
 
-retry:
-	rb_index = pg_atomic_fetch_add_u32(arrow_state->rbatch_index, 1);
-	if (rb_index >= arrow_state->rb_nitems)
-		return NULL;	/* no more chunks to load */
-	rb_state = arrow_state->rb_states[rb_index];
-	if (arrow_state->stats_hint)
+	/* exact null fraction */
+	values[Anum_pg_statistic_stanullfrac - 1]
+		= Float4GetDatum((double)aa_state->null_count / (double)total_nrows);
+	replaces[Anum_pg_statistic_stanullfrac - 1] = true;
+
+	/* ndistinct, unless user gives n_distinct attribute option */
+	aopt = get_attribute_options(RelationGetRelid(frel), attr->attnum);
+	if (aa_state->ndistinct > 0.0 && (!aopt || aopt->n_distinct == 0.0))
 	{
-		if (execCheckArrowStatsHint(arrow_state->stats_hint, rb_state))
+		double	nonnull_nrows = (double)(total_nrows - aa_state->null_count);
+		double	ndistinct = Min(aa_state->ndistinct, nonnull_nrows);
+		double	stadistinct;
+
+		/* same rule with compute_distinct_stats() */
+		if (ndistinct > 0.1 * (double)total_nrows)
+			stadistinct = Max(-(ndistinct / (double)total_nrows), -1.0);
+		else
+			stadistinct = floor(ndistinct + 0.5);
+		values[Anum_pg_statistic_stadistinct - 1] = Float4GetDatum(stadistinct);
+		replaces[Anum_pg_statistic_stadistinct - 1] = true;
+	}
+
+	/* histogram bounds by the exact min/max values */
+	if (aa_state->minmax_valid && aa_state->minmax_found)
+	{
+		for (int k=0; k < STATISTIC_NUM_SLOTS; k++)
 		{
-			pg_atomic_fetch_add_u32(arrow_state->rbatch_nskip, 1);
-			goto retry;
+			ArrayType  *arr;
+			Datum	   *elems;
+			Datum		datum;
+			bool		isnull;
+			int			nelems;
+			int16		typlen;
+			bool		typbyval;
+			char		typalign;
+
+			if ((&stat->stakind1)[k] != STATISTIC_KIND_HISTOGRAM)
+				continue;
+			datum = SysCacheGetAttr(STATRELATTINH, htup,
+									Anum_pg_statistic_stavalues1 + k,
+									&isnull);
+			if (isnull)
+				continue;
+			arr = DatumGetArrayTypeP(datum);
+			if (ARR_ELEMTYPE(arr) != attr->atttypid)
+				continue;
+			get_typlenbyvalalign(ARR_ELEMTYPE(arr), &typlen, &typbyval, &typalign);
+			deconstruct_array(arr, ARR_ELEMTYPE(arr),
+							  typlen, typbyval, typalign,
+							  &elems, NULL, &nelems);
+			if (nelems < 2)
+				continue;
+			elems[0] = aa_state->min_datum;
+			elems[nelems-1] = aa_state->max_datum;
+			arr = construct_array(elems, nelems, ARR_ELEMTYPE(arr),
+								  typlen, typbyval, typalign);
+			values[Anum_pg_statistic_stavalues1 + k - 1] = PointerGetDatum(arr);
+			replaces[Anum_pg_statistic_stavalues1 + k - 1] = true;
 		}
-		pg_atomic_fetch_add_u32(arrow_state->rbatch_nload, 1);
 	}
-	return rb_state;
+	newtup = heap_modify_tuple(htup, RelationGetDescr(srel),
+							   values, nulls, replaces);
+	CatalogTupleUpdate(srel, &newtup->t_self, newtup);
+	heap_freetuple(newtup);
+	ReleaseSysCache(htup);
 }
 
 /*
- * pgstromScanChunkArrowFdw
+ * __arrowAnalyzeAdjustStatistics
  */
-XpuCommand *
-pgstromScanChunkArrowFdw(pgstromTaskState *pts,
-						 struct iovec *xcmd_iov, int *xcmd_iovcnt)
+static void
+__arrowAnalyzeAdjustStatistics(Oid frelid)
 {
-	ArrowFdwState  *arrow_state = pts->arrow_state;
-	StringInfo		chunk_buffer = &arrow_state->chunk_buffer;
-	RecordBatchState *rb_state;
-	ArrowFileState *af_state;
-	strom_io_vector *iovec;
-	XpuCommand	   *xcmd;
-	uint32_t		kds_src_offset;
-	uint32_t		kds_src_iovec;
-	uint32_t		kds_src_pathname;
+	Relation	frel;
+	Relation	srel;
+	TupleDesc	tupdesc;
+	ForeignTable *ft;
+	arrowAnalyzeAttrState *aa_states;
+	List	   *filesList;
+	ListCell   *lc1, *lc2;
+	int64		total_nrows = 0;
+	bool		hive_partitioning;
 
-	rb_state = __arrowFdwNextRecordBatch(arrow_state);
-	if (!rb_state)
+	frel = try_relation_open(frelid, AccessShareLock);
+	if (!frel)
+		return;		/* concurrently dropped */
+	if (!RelationIsArrowFdw(frel))
 	{
-		pts->scan_done = true;
-		return NULL;
+		relation_close(frel, AccessShareLock);
+		return;
 	}
-	af_state = rb_state->af_state;
+	tupdesc = RelationGetDescr(frel);
+	ft = GetForeignTable(frelid);
+	aa_states = palloc0(sizeof(arrowAnalyzeAttrState) * tupdesc->natts);
+	for (int j=0; j < tupdesc->natts; j++)
+	{
+		Form_pg_attribute attr = TupleDescAttr(tupdesc, j);
 
-	/* XpuCommand header */
-	resetStringInfo(chunk_buffer);
-	appendBinaryStringInfo(chunk_buffer,
-						   pts->xcmd_buf.data,
-						   pts->xcmd_buf.len);
-	/* kds_src + iovec */
-	kds_src_offset = chunk_buffer->len;
-	iovec = arrowFdwLoadRecordBatch(pts->css.ss.ss_currentRelation,
-									arrow_state->referenced,
-									rb_state,
-									chunk_buffer);
-	kds_src_iovec = __appendBinaryStringInfo(chunk_buffer,
-											 iovec,
-											 offsetof(strom_io_vector,
-													  ioc[iovec->nr_chunks]));
-	/* arrow filename */
-	kds_src_pathname = chunk_buffer->len;
-	if (!pts->ds_entry)
-		appendStringInfoString(chunk_buffer, af_state->filename);
-	else
-		appendStringInfoString(chunk_buffer, af_state->dpu_path);
-	appendStringInfoChar(chunk_buffer, '\0');
+		aa_states[j].minmax_valid = true;
+		if (!attr->attisdropped)
+			aa_states[j].tcache = lookup_type_cache(attr->atttypid,
+													TYPECACHE_CMP_PROC_FINFO);
+	}
+	filesList = arrowFdwExtractFilesList(ft->options, NULL,
+										 &hive_partitioning);
+	foreach (lc1, filesList)
+	{
+		const char *fname = strVal(lfirst(lc1));
+		ArrowFileState *af_state;
 
-	/* assign offset of XpuCommand */
-	xcmd = (XpuCommand *)chunk_buffer->data;
-	xcmd->length = chunk_buffer->len;
-	xcmd->u.task.kds_src_pathname = kds_src_pathname;
-	xcmd->u.task.kds_src_iovec    = kds_src_iovec;
-	xcmd->u.task.kds_src_offset   = kds_src_offset;
+		af_state = BuildArrowFileState(frel, fname, hive_partitioning, NULL);
+		if (!af_state)
+			continue;
+		foreach (lc2, af_state->rb_list)
+		{
+			RecordBatchState *rb_state = lfirst(lc2);
+			int		nfields = Min(rb_state->nfields, tupdesc->natts);
 
-	xcmd_iov->iov_base = xcmd;
-	xcmd_iov->iov_len  = xcmd->length;
-	*xcmd_iovcnt = 1;
+			total_nrows += rb_state->rb_nitems;
+			for (int j=0; j < nfields; j++)
+			{
+				Form_pg_attribute attr = TupleDescAttr(tupdesc, j);
+				RecordBatchFieldState *rb_field = &rb_state->fields[j];
 
-	return xcmd;
+				if (attr->attisdropped)
+					continue;
+				aa_states[j].null_count += rb_field->null_count;
+				if (rb_field->null_count < rb_state->rb_nitems)
+					__arrowAnalyzeMergeMinMax(&aa_states[j], attr, rb_field);
+			}
+		}
+	}
+	if (total_nrows > 0)
+	{
+		if (arrow_analyze_hll_ndistinct)
+			__arrowAnalyzeHllNDistinct(frel, aa_states);
+		srel = table_open(StatisticRelationId, RowExclusiveLock);
+		for (int j=0; j < tupdesc->natts; j++)
+		{
+			Form_pg_attribute attr = TupleDescAttr(tupdesc, j);
+
+			if (!attr->attisdropped)
+				__arrowAnalyzeUpdateStatistic(frel, srel, attr,
+											  &aa_states[j],
+											  total_nrows);
+		}
+		table_close(srel, RowExclusiveLock);
+		CommandCounterIncrement();
+	}
+	relation_close(frel, AccessShareLock);
 }
 
 /*
- * ArrowIterateForeignScan
+ * arrowFdwProcessUtility
  */
-static TupleTableSlot *
-ArrowIterateForeignScan(ForeignScanState *node)
+static void
+arrowFdwProcessUtility(PlannedStmt *pstmt,
+					   const char *queryString,
+					   bool readOnlyTree,
+					   ProcessUtilityContext context,
+					   ParamListInfo params,
+					   QueryEnvironment *queryEnv,
+					   DestReceiver *dest,
+					   QueryCompletion *qc)
 {
-	ArrowFdwState *arrow_state = node->fdw_state;
-	TupleTableSlot *slot = node->ss.ss_ScanTupleSlot;
-	kern_data_store *kds;
+	Node	   *parsetree = pstmt->utilityStmt;
+	bool		is_analyze = IsA(parsetree, VacuumStmt);
 
-	while ((kds = arrow_state->curr_kds) == NULL ||
-		   arrow_state->curr_index >= kds->nitems)
+	if (is_analyze)
 	{
-		RecordBatchState *rb_state;
+		list_free(arrow_analyze_pending);
+		arrow_analyze_pending = NIL;
+	}
+	if (process_utility_next)
+		process_utility_next(pstmt, queryString, readOnlyTree,
+							 context, params, queryEnv, dest, qc);
+	else
+		standard_ProcessUtility(pstmt, queryString, readOnlyTree,
+								context, params, queryEnv, dest, qc);
+	if (is_analyze && arrow_analyze_pending != NIL)
+	{
+		List	   *pending = arrow_analyze_pending;
+		ListCell   *lc;
 
-		arrow_state->curr_index = 0;
-		arrow_state->curr_kds = NULL;
-		rb_state = __arrowFdwNextRecordBatch(arrow_state);
-		if (!rb_state)
-			return NULL;
-		arrow_state->curr_kds
-			= arrowFdwFillupRecordBatch(node->ss.ss_currentRelation,
-										arrow_state->referenced,
-										rb_state,
-										&arrow_state->chunk_buffer);
-	}
-	Assert(kds && arrow_state->curr_index < kds->nitems);
-	if (kds_arrow_fetch_tuple(slot, kds,
-							  arrow_state->curr_index++,
-							  arrow_state->referenced))
-		return slot;
-	return NULL;
+		arrow_analyze_pending = NIL;
+		PG_TRY();
+		{
+			foreach (lc, pending)
+				__arrowAnalyzeAdjustStatistics(lfirst_oid(lc));
+		}
+		PG_FINALLY();
+		{
+			list_free(pending);
+		}
+		PG_END_TRY();
+	}
 }
 
-/*
- * ArrowReScanForeignScan
+/* ----------------------------------------------------------------
+ *
+ * Routines for INSERT / COPY FROM
+ *
+ * Rows are buffered on the SQLtable, then written out to a temporary file
+ * per record-batch. At the pre-commit, these record-batches are copied to
+ * the destination arrow file over the current footer, then the new footer
+ * is written. Until this point, the destination file is never modified,
+ * so concurrent readers (including the current transaction) see the
+ * previous image. The original footer is kept as undo log, and written
+ * back if the transaction gets aborted.
+ *
+ * ----------------------------------------------------------------
  */
-void
-pgstromArrowFdwExecReset(ArrowFdwState *arrow_state)
-{
-	pg_atomic_write_u32(arrow_state->rbatch_index, 0);
-	if (arrow_state->curr_kds)
-		pfree(arrow_state->curr_kds);
-	arrow_state->curr_kds = NULL;
-	arrow_state->curr_index = 0;
-}
-
-static void
-ArrowReScanForeignScan(ForeignScanState *node)
+typedef struct
 {
-	pgstromArrowFdwExecReset(node->fdw_state);
-}
+	char	   *filename;		/* destination arrow file */
+	Oid			frelid;			/* foreign table being written */
+	MemoryContext memcxt;		/* memory context of the buffer */
+	SQLtable   *table;			/* buffer of the rows */
+	int			spill_fdesc;	/* temporary file for the record-batches */
+	int			fdesc;			/* destination file during commit */
+	bool		file_created;	/* destination file is newly created */
+	bool		undo_valid;		/* undo log is valid */
+	off_t		undo_offset;	/* original footer position */
+	size_t		undo_length;	/* original footer length */
+	char	   *undo_backup;	/* original footer image */
+} arrowWriteState;
+
+static List		   *arrow_write_states = NIL;
+static MemoryContext arrow_write_memcxt = NULL;
+static uint32_t		arrow_write_spill_count = 0;
 
 /*
- * ExecEndArrowScan
+ * arrowFdwGetWritableFile
  */
-void
-pgstromArrowFdwExecEnd(ArrowFdwState *arrow_state)
+static const char *
+arrowFdwGetWritableFile(Relation frel)
 {
-	if (arrow_state->curr_filp >= 0)
-		FileClose(arrow_state->curr_filp);
-	if (arrow_state->stats_hint)
-		execEndArrowStatsHint(arrow_state->stats_hint);
-}
+	ForeignTable *ft = GetForeignTable(RelationGetRelid(frel));
+	const char *filename = NULL;
+	bool		writable = false;
+	ListCell   *lc;
 
-static void
-ArrowEndForeignScan(ForeignScanState *node)
-{
-	pgstromArrowFdwExecEnd(node->fdw_state);
+	foreach (lc, ft->options)
+	{
+		DefElem	   *defel = lfirst(lc);
+
+		if (strcmp(defel->defname, "writable") == 0)
+			writable = defGetBoolean(defel);
+		else if (strcmp(defel->defname, "file") == 0 ||
+				 strcmp(defel->defname, "files") == 0)
+			filename = __trim(pstrdup(strVal(defel->arg)));
+	}
+	if (!writable || !filename)
+		elog(ERROR, "arrow_fdw: foreign table '%s' is not writable",
+			 RelationGetRelationName(frel));
+	return filename;
 }
 
 /*
- * ArrowIsForeignScanParallelSafe
+ * __arrowFdwSetupSQLField
  */
-static bool
-ArrowIsForeignScanParallelSafe(PlannerInfo *root,
-							   RelOptInfo *rel,
-							   RangeTblEntry *rte)
+static void
+__arrowFdwSetupSQLField(SQLtable *table,
+						SQLfield *column,
+						const char *attname,
+						Oid atttypid,
+						int atttypmod,
+						ArrowField *arrow_field)
 {
-	return true;
+	HeapTuple	htup;
+	Form_pg_type typ;
+	Oid			typelem = InvalidOid;
+	Oid			ext_oid;
+	char	   *extname = NULL;
+	char	   *extschema = NULL;
+
+	atttypid = getBaseTypeAndTypmod(atttypid, &atttypmod);
+	htup = SearchSysCache1(TYPEOID, ObjectIdGetDatum(atttypid));
+	if (!HeapTupleIsValid(htup))
+		elog(ERROR, "cache lookup failed for type %u", atttypid);
+	typ = (Form_pg_type) GETSTRUCT(htup);
+	if (typ->typtype == TYPTYPE_ENUM)
+		elog(ERROR, "arrow_fdw: enum type of '%s' is not writable", attname);
+	if (IsTrueArrayType(typ))
+		typelem = typ->typelem;
+	ext_oid = getExtensionOfObject(TypeRelationId, atttypid);
+	if (OidIsValid(ext_oid))
+	{
+		extname = get_extension_name(ext_oid);
+		extschema = get_namespace_name(get_extension_schema(ext_oid));
+	}
+	table->numFieldNodes++;
+	table->numBuffers += assignArrowTypePgSQL(column,
+											  attname,
+											  atttypid,
+											  atttypmod,
+											  NameStr(typ->typname),
+											  get_namespace_name(typ->typnamespace),
+											  typ->typlen,
+											  typ->typbyval,
+											  typ->typtype,
+											  typ->typalign,
+											  typ->typrelid,
+											  typelem,
+											  pg_get_timezone_name(session_timezone),
+											  extname,
+											  extschema,
+											  arrow_field);
+	if (OidIsValid(typ->typrelid))
+	{
+		TupleDesc	tupdesc = lookup_rowtype_tupdesc(atttypid, -1);
+
+		if (arrow_field && arrow_field->_num_children != tupdesc->natts)
+			elog(ERROR, "arrow_fdw: number of sub-fields of '%s' mismatch", attname);
+		column->nfields = tupdesc->natts;
+		column->subfields = palloc0(sizeof(SQLfield) * tupdesc->natts);
+		for (int j=0; j < tupdesc->natts; j++)
+		{
+			Form_pg_attribute attr = TupleDescAttr(tupdesc, j);
+
+			if (attr->attisdropped)
+				elog(ERROR, "arrow_fdw: composite type of '%s' has dropped attributes",
+					 attname);
+			__arrowFdwSetupSQLField(table,
+									&column->subfields[j],
+									NameStr(attr->attname),
+									attr->atttypid,
+									attr->atttypmod,
+									arrow_field ? &arrow_field->children[j] : NULL);
+		}
+		ReleaseTupleDesc(tupdesc);
+	}
+	else if (OidIsValid(typelem))
+	{
+		if (arrow_field && arrow_field->_num_children != 1)
+			elog(ERROR, "arrow_fdw: array element of '%s' mismatch", attname);
+		column->element = palloc0(sizeof(SQLfield));
+		__arrowFdwSetupSQLField(table,
+								column->element,
+								get_type_name(typelem),
+								typelem,
+								atttypmod,
+								arrow_field ? &arrow_field->children[0] : NULL);
+	}
+	ReleaseSysCache(htup);
 }
 
 /*
- * ArrowEstimateDSMForeignScan
+ * __arrowFdwSetupSQLTable
  */
-static Size
-ArrowEstimateDSMForeignScan(ForeignScanState *node,
-							ParallelContext *pcxt)
+static SQLtable *
+__arrowFdwSetupSQLTable(TupleDesc tupdesc, const char *relname,
+						const char *filename, ArrowFileInfo *af_info)
 {
-	return offsetof(pgstromSharedState, inners);
+	SQLtable   *table;
+
+	if (af_info && af_info->footer.schema._num_fields != tupdesc->natts)
+		elog(ERROR, "arrow_fdw: file '%s' has %d fields, but foreign table '%s' has %d columns",
+			 filename,
+			 af_info->footer.schema._num_fields,
+			 relname,
+			 tupdesc->natts);
+	table = palloc0(offsetof(SQLtable, columns[tupdesc->natts]));
+	table->filename = filename;
+	table->fdesc = -1;
+	table->segment_sz = (size_t)arrow_record_batch_size_kb << 10;
+	table->nfields = tupdesc->natts;
+	for (int j=0; j < tupdesc->natts; j++)
+	{
+		Form_pg_attribute attr = TupleDescAttr(tupdesc, j);
+		SQLfield   *column = &table->columns[j];
+		ArrowField *arrow_field = NULL;
+
+		if (attr->attisdropped)
+			elog(ERROR, "arrow_fdw: foreign table '%s' with dropped columns is not writable",
+				 relname);
+		if (af_info)
+			arrow_field = &af_info->footer.schema.fields[j];
+		__arrowFdwSetupSQLField(table, column,
+								NameStr(attr->attname),
+								attr->atttypid,
+								attr->atttypmod,
+								arrow_field);
+		/* min/max statistics are embedded on the top-level columns */
+		if (column->write_stat)
+		{
+			column->stat_enabled = true;
+			table->has_statistics = true;
+		}
+		/* inherit the zone-map configuration */
+		if (arrow_field && column->stat_enabled &&
+			!column->element && column->nfields == 0)
+		{
+			for (int k=0; k < arrow_field->_num_custom_metadata; k++)
+			{
+				ArrowKeyValue *kv = &arrow_field->custom_metadata[k];
+
+				if (strcmp(kv->key, "zonemap_nrows") == 0)
+					column->zone_nrows = Max(atoi(kv->value), 0);
+			}
+		}
+	}
+	return table;
 }
 
 /*
- * ArrowInitializeDSMForeignScan
+ * __arrowFdwLookupWriteState
  */
-void
-pgstromArrowFdwInitDSM(ArrowFdwState *arrow_state,
-					   pgstromSharedState *ps_state)
+static arrowWriteState *
+__arrowFdwLookupWriteState(Relation frel)
 {
-	arrow_state->rbatch_index = &ps_state->arrow_rbatch_index;
-	arrow_state->rbatch_nload = &ps_state->arrow_rbatch_nload;
-	arrow_state->rbatch_nskip = &ps_state->arrow_rbatch_nskip;
+	const char *filename = arrowFdwGetWritableFile(frel);
+	arrowWriteState *wstate;
+	ArrowFileInfo af_info;
+	MemoryContext oldcxt;
+	ListCell   *lc;
+	bool		file_exists = false;
+
+	/*
+	 * sub-transaction cannot discard the rows buffered, so it is checked
+	 * on every insert, even if the write-state is already registered by
+	 * the rows inserted prior to the SAVEPOINT.
+	 */
+	if (GetCurrentTransactionNestLevel() > 1)
+		elog(ERROR, "arrow_fdw: unable to write '%s' inside of sub-transaction",
+			 filename);
+	foreach (lc, arrow_write_states)
+	{
+		wstate = lfirst(lc);
+		if (strcmp(wstate->filename, filename) == 0)
+		{
+			if (wstate->frelid != RelationGetRelid(frel))
+				elog(ERROR, "arrow_fdw: file '%s' is already written via another foreign table in this transaction",
+					 filename);
+			return wstate;
+		}
+	}
+	if (!arrow_write_memcxt)
+		arrow_write_memcxt = AllocSetContextCreate(TopTransactionContext,
+												   "Arrow_Fdw Write Buffer",
+												   ALLOCSET_DEFAULT_SIZES);
+	oldcxt = MemoryContextSwitchTo(arrow_write_memcxt);
+	if (__arrowFdwWritableFileExists(filename))
+	{
+		if (__arrowFileIsParquet(filename))
+			elog(ERROR, "arrow_fdw: parquet file '%s' is not writable", filename);
+		file_exists = readArrowFile(filename, &af_info, false);
+	}
+	wstate = palloc0(sizeof(arrowWriteState));
+	wstate->filename = pstrdup(filename);
+	wstate->frelid = RelationGetRelid(frel);
+	wstate->memcxt = arrow_write_memcxt;
+	wstate->table = __arrowFdwSetupSQLTable(RelationGetDescr(frel),
+											RelationGetRelationName(frel),
+											wstate->filename,
+											file_exists ? &af_info : NULL);
+	wstate->spill_fdesc = -1;
+	wstate->fdesc = -1;
+	arrow_write_states = lappend(arrow_write_states, wstate);
+	MemoryContextSwitchTo(oldcxt);
+
+	return wstate;
 }
 
+/*
+ * __arrowFdwFlushRecordBatch
+ *
+ * It writes out the buffered rows to the temporary file as a record-batch.
+ */
 static void
-ArrowInitializeDSMForeignScan(ForeignScanState *node,
-                              ParallelContext *pcxt,
-                              void *coordinate)
+__arrowFdwFlushRecordBatch(arrowWriteState *wstate)
 {
-	pgstromSharedState *ps_state = (pgstromSharedState *)coordinate;
+	SQLtable   *table = wstate->table;
 
-	memset(ps_state, 0, offsetof(pgstromSharedState, inners));
-	pgstromArrowFdwInitDSM(node->fdw_state, ps_state);
+	if (table->nitems == 0)
+		return;
+	if (wstate->spill_fdesc < 0)
+	{
+		char	   *dir_name = psprintf("base/%s", PG_TEMP_FILES_DIR);
+		char	   *spill_name;
+
+		if (MakePGDirectory(dir_name) != 0 && errno != EEXIST)
+			ereport(ERROR,
+					(errcode_for_file_access(),
+					 errmsg("could not create directory \"%s\": %m", dir_name)));
+		spill_name = psprintf("%s/%sarrow_fdw.%d.%u",
+							  dir_name, PG_TEMP_FILE_PREFIX,
+							  MyProcPid, arrow_write_spill_count++);
+		wstate->spill_fdesc = OpenTransientFile(spill_name,
+												O_RDWR | O_CREAT | O_TRUNC | PG_BINARY);
+		if (wstate->spill_fdesc < 0)
+			ereport(ERROR,
+					(errcode_for_file_access(),
+					 errmsg("could not create file \"%s\": %m", spill_name)));
+		/* nobody else has to see the temporary file */
+		unlink(spill_name);
+		table->f_pos = 0;
+	}
+	table->fdesc = wstate->spill_fdesc;
+	writeArrowRecordBatch(table);
+	sql_table_clear(table);
 }
 
 /*
- * ArrowInitializeWorkerForeignScan
+ * __arrowFdwWriteTuple
  */
-void
-pgstromArrowFdwAttachDSM(ArrowFdwState *arrow_state,
-						 pgstromSharedState *ps_state)
-{
-	arrow_state->rbatch_index = &ps_state->arrow_rbatch_index;
-	arrow_state->rbatch_nload = &ps_state->arrow_rbatch_nload;
-	arrow_state->rbatch_nskip = &ps_state->arrow_rbatch_nskip;
-}
-
 static void
-ArrowInitializeWorkerForeignScan(ForeignScanState *node,
-								 shm_toc *toc,
-								 void *coordinate)
+__arrowFdwWriteTuple(arrowWriteState *wstate, TupleTableSlot *slot)
 {
-	pgstromSharedState *ps_state = (pgstromSharedState *)coordinate;
+	TupleDesc	tupdesc = slot->tts_tupleDescriptor;
+	SQLtable   *table = wstate->table;
+	MemoryContext oldcxt;
+	size_t		usage = 0;
 
-	pgstromArrowFdwAttachDSM(node->fdw_state, ps_state);
+	slot_getallattrs(slot);
+	for (int j=0; j < table->nfields; j++)
+	{
+		Form_pg_attribute attr = TupleDescAttr(tupdesc, j);
+		SQLfield   *column = &table->columns[j];
+		Datum		datum = slot->tts_values[j];
+		const char *addr;
+		int			sz;
+
+		if (slot->tts_isnull[j])
+		{
+			addr = NULL;
+			sz = 0;
+		}
+		else if (attr->attbyval)
+		{
+			addr = (const char *)&slot->tts_values[j];
+			sz = attr->attlen;
+		}
+		else if (attr->attlen > 0)
+		{
+			addr = DatumGetPointer(datum);
+			sz = attr->attlen;
+		}
+		else if (attr->attlen == -1)
+		{
+			struct varlena *vl = (struct varlena *)DatumGetPointer(datum);
+
+			/* array / composite handler expects 4B varlena header */
+			if (column->element || column->subfields)
+			{
+				vl = pg_detoast_datum(vl);
+				addr = VARDATA(vl);
+				sz = VARSIZE(vl) - VARHDRSZ;
+			}
+			else
+			{
+				vl = pg_detoast_datum_packed(vl);
+				addr = VARDATA_ANY(vl);
+				sz = VARSIZE_ANY_EXHDR(vl);
+			}
+		}
+		else
+			elog(ERROR, "arrow_fdw: unable to write attribute '%s' (typlen=%d)",
+				 NameStr(attr->attname), attr->attlen);
+
+		oldcxt = MemoryContextSwitchTo(wstate->memcxt);
+		usage += sql_field_put_value(column, addr, sz);
+		MemoryContextSwitchTo(oldcxt);
+	}
+	table->nitems++;
+	table->usage = usage;
+	if (table->usage >= table->segment_sz)
+	{
+		oldcxt = MemoryContextSwitchTo(wstate->memcxt);
+		__arrowFdwFlushRecordBatch(wstate);
+		MemoryContextSwitchTo(oldcxt);
+	}
 }
 
 /*
- * ArrowShutdownForeignScan
+ * __arrowFdwRestoreFieldStats
+ *
+ * It restores the min/max statistics (and zone-map) of the record-batches
+ * already in the file, because the new footer is built from the SQLfield.
  */
-void
-pgstromArrowFdwShutdown(ArrowFdwState *arrow_state)
+static List *
+__arrowFdwSplitStatString(const char *str, int delim)
 {
-	uint32		temp;
-
-	temp = pg_atomic_read_u32(arrow_state->rbatch_index);
-	pg_atomic_write_u32(&arrow_state->__rbatch_index_local, temp);
-	arrow_state->rbatch_index = &arrow_state->__rbatch_index_local;
+	List	   *result = NIL;
+	const char *pos;
 
-	temp = pg_atomic_read_u32(arrow_state->rbatch_nload);
-	pg_atomic_write_u32(&arrow_state->__rbatch_nload_local, temp);
-	arrow_state->rbatch_nload = &arrow_state->__rbatch_nload_local;
+	for (;;)
+	{
+		pos = strchr(str, delim);
+		if (!pos)
+		{
+			result = lappend(result, pstrdup(str));
+			break;
+		}
+		result = lappend(result, pnstrdup(str, pos - str));
+		str = pos + 1;
+	}
+	return result;
+}
 
-	temp = pg_atomic_read_u32(arrow_state->rbatch_nskip);
-	pg_atomic_write_u32(&arrow_state->__rbatch_nskip_local, temp);
-	arrow_state->rbatch_nskip = &arrow_state->__rbatch_nskip_local;
+static bool
+__arrowFdwParseStatDatum(SQLfield *column, const char *tok,
+						 SQLstat__datum *datum)
+{
+	ArrowType  *t = &column->arrow_type;
+	bool		isnull = false;
+	int128_t	ival;
 
+	tok = __trim((char *)tok);
+	if (strcmp(tok, "null") == 0)
+		return false;
+	ival = __atoi128(tok, &isnull);
+	if (isnull)
+		return false;
+	memset(datum, 0, sizeof(SQLstat__datum));
+	switch (t->node.tag)
+	{
+		case ArrowNodeTag__Int:
+			switch (t->Int.bitWidth)
+			{
+				case 8:  datum->i8  = ival; break;
+				case 16: datum->i16 = ival; break;
+				case 32: datum->i32 = ival; break;
+				case 64: datum->i64 = ival; break;
+				default: return false;
+			}
+			break;
+		case ArrowNodeTag__FloatingPoint:
+			switch (t->FloatingPoint.precision)
+			{
+				case ArrowPrecision__Half:
+					datum->f32 = fp16_to_fp32((half_t)ival);
+					break;
+				case ArrowPrecision__Single:
+					datum->i32 = ival;
+					break;
+				case ArrowPrecision__Double:
+					datum->i64 = ival;
+					break;
+				default:
+					return false;
+			}
+			break;
+		case ArrowNodeTag__Decimal:
+			datum->i128 = ival;
+			break;
+		case ArrowNodeTag__Date:
+			if (t->Date.unit == ArrowDateUnit__Day)
+				datum->i32 = ival;
+			else
+				datum->i64 = ival;
+			break;
+		case ArrowNodeTag__Time:
+			if (t->Time.bitWidth == 32)
+				datum->i32 = ival;
+			else
+				datum->i64 = ival;
+			break;
+		case ArrowNodeTag__Timestamp:
+			datum->i64 = ival;
+			break;
+		default:
+			return false;
+	}
+	return true;
 }
 
-static void
-ArrowShutdownForeignScan(ForeignScanState *node)
+static SQLstat *
+__arrowFdwMakeSQLstat(SQLfield *column, int rb_index, int zone_index,
+					  const char *min_tok, const char *max_tok)
 {
-	pgstromArrowFdwShutdown(node->fdw_state);
+	SQLstat	   *stat = palloc0(sizeof(SQLstat));
+
+	stat->rb_index = rb_index;
+	stat->zone_index = zone_index;
+	stat->is_valid = (__arrowFdwParseStatDatum(column, min_tok, &stat->min) &&
+					  __arrowFdwParseStatDatum(column, max_tok, &stat->max));
+	return stat;
 }
 
-/*
- * ArrowExplainForeignScan
- */
-void
-pgstromArrowFdwExplain(ArrowFdwState *arrow_state,
-					   Relation frel,
-					   ExplainState *es,
-					   List *dcontext)
+static void
+__arrowFdwRestoreFieldStats(SQLfield *column, ArrowField *field,
+							int num_old_batches)
 {
-	TupleDesc	tupdesc = RelationGetDescr(frel);
-	size_t	   *chunk_sz;
-	ListCell   *lc1, *lc2;
-	int			fcount = 0;
-	int			j, k;
-	char		label[100];
-	StringInfoData	buf;
-
-	initStringInfo(&buf);
-	/* shows referenced columns */
-	for (k = bms_next_member(arrow_state->referenced, -1);
-		 k >= 0;
-		 k = bms_next_member(arrow_state->referenced, k))
+	const char *min_values = NULL;
+	const char *max_values = NULL;
+	const char *zone_min_values = NULL;
+	const char *zone_max_values = NULL;
+	int			zone_nrows = 0;
+	ArrowKeyValue *kv_array = NULL;
+	int			kv_nitems = 0;
+
+	if (field->_num_custom_metadata > 0)
+		kv_array = palloc0(sizeof(ArrowKeyValue) * field->_num_custom_metadata);
+	for (int k=0; k < field->_num_custom_metadata; k++)
 	{
-		j = k + FirstLowInvalidHeapAttributeNumber;
-
-		if (j > 0)
-		{
-			Form_pg_attribute attr = TupleDescAttr(tupdesc, j-1);
-			const char	   *attname = NameStr(attr->attname);
+		ArrowKeyValue *kv = &field->custom_metadata[k];
 
-			if (buf.len > 0)
-				appendStringInfoString(&buf, ", ");
-			appendStringInfoString(&buf, quote_identifier(attname));
-		}
+		if (strcmp(kv->key, "min_values") == 0)
+			min_values = kv->value;
+		else if (strcmp(kv->key, "max_values") == 0)
+			max_values = kv->value;
+		else if (strcmp(kv->key, "zonemap_nrows") == 0)
+			zone_nrows = atoi(kv->value);
+		else if (strcmp(kv->key, "zonemap_min_values") == 0)
+			zone_min_values = kv->value;
+		else if (strcmp(kv->key, "zonemap_max_values") == 0)
+			zone_max_values = kv->value;
+		else
+			memcpy(&kv_array[kv_nitems++], kv, sizeof(ArrowKeyValue));
 	}
-	ExplainPropertyText("referenced", buf.data, es);
+	/* custom metadata other than the statistics (e.g, pg_type hint) */
+	column->customMetadata = kv_array;
+	column->numCustomMetadata = kv_nitems;
+	if (!column->stat_enabled || num_old_batches == 0)
+		return;
 
-	/* shows stats hint if any */
-	if (arrow_state->stats_hint)
+	if (min_values && max_values)
 	{
-		arrowStatsHint *stats_hint = arrow_state->stats_hint;
+		List	   *min_list = __arrowFdwSplitStatString(min_values, ',');
+		List	   *max_list = __arrowFdwSplitStatString(max_values, ',');
 
-		resetStringInfo(&buf);
-		foreach (lc1, stats_hint->orig_quals)
+		if (list_length(min_list) == num_old_batches &&
+			list_length(max_list) == num_old_batches)
 		{
-			Node   *qual = lfirst(lc1);
-			char   *temp;
-
-			temp = deparse_expression(qual, dcontext, es->verbose, false);
-			if (buf.len > 0)
-				appendStringInfoString(&buf, ", ");
-			appendStringInfoString(&buf, temp);
-			pfree(temp);
+			for (int i=0; i < num_old_batches; i++)
+			{
+				SQLstat	   *stat = __arrowFdwMakeSQLstat(column, i, 0,
+														 list_nth(min_list, i),
+														 list_nth(max_list, i));
+				stat->next = column->stat_list;
+				column->stat_list = stat;
+			}
 		}
-		if (es->analyze)
-			appendStringInfo(&buf, "  [loaded: %u, skipped: %u]",
-							 pg_atomic_read_u32(arrow_state->rbatch_nload),
-							 pg_atomic_read_u32(arrow_state->rbatch_nskip));
-		ExplainPropertyText("Stats-Hint", buf.data, es);
 	}
-
-	/* shows files on behalf of the foreign table */
-	chunk_sz = alloca(sizeof(size_t) * tupdesc->natts);
-	memset(chunk_sz, 0, sizeof(size_t) * tupdesc->natts);
-	foreach (lc1, arrow_state->af_states_list)
+	if (column->zone_nrows > 0 &&
+		column->zone_nrows == zone_nrows &&
+		zone_min_values && zone_max_values)
 	{
-		ArrowFileState *af_state = lfirst(lc1);
-		size_t		total_sz = af_state->stat_buf.st_size;
-		size_t		read_sz = 0;
-		size_t		sz;
+		List	   *min_list = __arrowFdwSplitStatString(zone_min_values, ';');
+		List	   *max_list = __arrowFdwSplitStatString(zone_max_values, ';');
 
-		foreach (lc2, af_state->rb_list)
+		if (list_length(min_list) == num_old_batches &&
+			list_length(max_list) == num_old_batches)
 		{
-			RecordBatchState *rb_state = lfirst(lc2);
-
-			if (bms_is_member(-FirstLowInvalidHeapAttributeNumber,
-							  arrow_state->referenced))
-			{
-				/* whole-row reference */
-				read_sz += rb_state->rb_length;
-			}
-			else
+			for (int i=0; i < num_old_batches; i++)
 			{
-				for (k = bms_next_member(arrow_state->referenced, -1);
-					 k >= 0;
-					 k = bms_next_member(arrow_state->referenced, k))
+				List   *zmin_list = __arrowFdwSplitStatString(list_nth(min_list, i), ',');
+				List   *zmax_list = __arrowFdwSplitStatString(list_nth(max_list, i), ',');
+
+				if (list_length(zmin_list) != list_length(zmax_list))
+					continue;
+				for (int z=0; z < list_length(zmin_list); z++)
 				{
-					j = k + FirstLowInvalidHeapAttributeNumber - 1;
-					if (j < 0 || j >=  tupdesc->natts)
-						continue;
-					sz = __recordBatchFieldLength(&rb_state->fields[j]);
-					read_sz += sz;
-					chunk_sz[j] += sz;
+					SQLstat	   *stat = __arrowFdwMakeSQLstat(column, i, z,
+															 list_nth(zmin_list, z),
+															 list_nth(zmax_list, z));
+					stat->next = column->zone_list;
+					column->zone_list = stat;
 				}
 			}
 		}
-
-		/* file size and read size */
-		if (es->format == EXPLAIN_FORMAT_TEXT)
-		{
-			resetStringInfo(&buf);
-			appendStringInfo(&buf, "%s (read: %s, size: %s)",
-							 af_state->filename,
-							 format_bytesz(read_sz),
-							 format_bytesz(total_sz));
-			snprintf(label, sizeof(label), "file%d", fcount);
-			ExplainPropertyText(label, buf.data, es);
-		}
-		else
-		{
-			snprintf(label, sizeof(label), "file%d", fcount);
-			ExplainPropertyText(label, af_state->filename, es);
-
-			snprintf(label, sizeof(label), "file%d-read", fcount);
-			ExplainPropertyText(label, format_bytesz(read_sz), es);
-
-			snprintf(label, sizeof(label), "file%d-size", fcount);
-			ExplainPropertyText(label, format_bytesz(total_sz), es);
-		}
-		fcount++;
 	}
+}
 
-	/* read-size per column (only verbose mode) */
-	if (es->verbose && arrow_state->rb_nitems > 0 &&
-		!bms_is_member(-FirstLowInvalidHeapAttributeNumber,
-					   arrow_state->referenced))
+/*
+ * __arrowFdwWriteStateCommit
+ */
+static void
+__arrowFdwCopySpillFile(arrowWriteState *wstate, off_t length)
+{
+	SQLtable   *table = wstate->table;
+	char	   *buffer = palloc(BLCKSZ * 32);
+	off_t		offset = 0;
+
+	while (offset < length)
 	{
-		resetStringInfo(&buf);
-		for (k = bms_next_member(arrow_state->referenced, -1);
-			 k >= 0;
-			 k = bms_next_member(arrow_state->referenced, k))
+		ssize_t	nbytes = pread(wstate->spill_fdesc, buffer,
+							   Min(BLCKSZ * 32, length - offset), offset);
+		if (nbytes < 0)
 		{
-			Form_pg_attribute attr;
-
-			j = k + FirstLowInvalidHeapAttributeNumber - 1;
-			if (j < 0 || j >= tupdesc->natts)
+			if (errno == EINTR)
 				continue;
-			attr = TupleDescAttr(tupdesc, j);
-			snprintf(label, sizeof(label), "  %s", NameStr(attr->attname));
-			ExplainPropertyText(label, format_bytesz(chunk_sz[j]), es);
+			elog(ERROR, "failed on pread('temporary file'): %m");
 		}
+		if (nbytes == 0)
+			elog(ERROR, "unexpected EOF on the temporary file");
+		arrowFileWrite(table, buffer, nbytes);
+		offset += nbytes;
 	}
-	pfree(buf.data);
+	pfree(buffer);
 }
 
 static void
-ArrowExplainForeignScan(ForeignScanState *node, ExplainState *es)
+__arrowFdwWriteStateCommit(arrowWriteState *wstate)
 {
-	Relation		frel = node->ss.ss_currentRelation;
-	List		   *dcontext;
+	SQLtable   *table = wstate->table;
+	ArrowBlock *new_batches;
+	int			num_new_batches;
+	int			num_old_batches = 0;
+	off_t		spill_length;
+	off_t		base;
+	struct stat	stat_buf;
 
-	dcontext = set_deparse_context_plan(es->deparse_cxt,
-										node->ss.ps.plan,
-										NULL);
-	pgstromArrowFdwExplain(node->fdw_state, frel, es, dcontext);
+	__arrowFdwFlushRecordBatch(wstate);
+	if (table->numRecordBatches == 0)
+		return;		/* nothing to write */
+	new_batches = table->recordBatches;
+	num_new_batches = table->numRecordBatches;
+	spill_length = table->f_pos;
+	table->recordBatches = NULL;
+	table->numRecordBatches = 0;
+
+	/* open the destination file, and lock it exclusively */
+	wstate->fdesc = OpenTransientFile(wstate->filename, O_RDWR | PG_BINARY);
+	if (wstate->fdesc < 0 && errno == ENOENT)
+	{
+		wstate->fdesc = OpenTransientFile(wstate->filename,
+										  O_RDWR | O_CREAT | O_EXCL | PG_BINARY);
+		wstate->file_created = (wstate->fdesc >= 0);
+	}
+	if (wstate->fdesc < 0)
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not open file \"%s\": %m", wstate->filename)));
+	while (flock(wstate->fdesc, LOCK_EX) != 0)
+	{
+		if (errno != EINTR)
+			elog(ERROR, "failed on flock('%s'): %m", wstate->filename);
+		CHECK_FOR_INTERRUPTS();
+	}
+	if (fstat(wstate->fdesc, &stat_buf) != 0)
+		elog(ERROR, "failed on fstat('%s'): %m", wstate->filename);
+	table->fdesc = wstate->fdesc;
+	table->filename = wstate->filename;
+
+	if (stat_buf.st_size == 0)
+	{
+		SQLstat	  **saved = alloca(sizeof(SQLstat *) * 2 * table->nfields);
+
+		wstate->undo_offset = 0;
+		wstate->undo_length = 0;
+		wstate->undo_valid = true;
+		/* Schema shall be written without statistics */
+		for (int j=0; j < table->nfields; j++)
+		{
+			saved[2*j]   = table->columns[j].stat_list;
+			saved[2*j+1] = table->columns[j].zone_list;
+			table->columns[j].stat_list = NULL;
+			table->columns[j].zone_list = NULL;
+		}
+		table->f_pos = 0;
+		arrowFileWrite(table, "ARROW1\0\0", 8);
+		writeArrowSchema(table);
+		for (int j=0; j < table->nfields; j++)
+		{
+			table->columns[j].stat_list = saved[2*j];
+			table->columns[j].zone_list = saved[2*j+1];
+		}
+	}
+	else
+	{
+		ArrowFileInfo af_info;
+		ArrowSchema *schema;
+		char		tail[sizeof(int32_t) + 6];	/* strlen("ARROW1") */
+		off_t		offset;
+		size_t		length;
+
+		/* the file might be updated after BeginForeignModify */
+		if (lseek(wstate->fdesc, 0, SEEK_SET) != 0)
+			elog(ERROR, "failed on lseek('%s'): %m", wstate->filename);
+		readArrowFileDesc(wstate->fdesc, &af_info);
+		schema = &af_info.footer.schema;
+		if (schema->_num_fields != table->nfields)
+			elog(ERROR, "arrow_fdw: file '%s' has incompatible schema",
+				 wstate->filename);
+		for (int j=0; j < table->nfields; j++)
+		{
+			if (schema->fields[j].type.node.tag != table->columns[j].arrow_type.node.tag)
+				elog(ERROR, "arrow_fdw: field '%s' of file '%s' has incompatible type",
+					 table->columns[j].field_name, wstate->filename);
+		}
+		if (af_info.footer._num_dictionaries > 0)
+			elog(ERROR, "arrow_fdw: file '%s' has DictionaryBatch, not writable",
+				 wstate->filename);
+
+		/* save the current footer as undo log */
+		offset = stat_buf.st_size - sizeof(tail);
+		if (pread(wstate->fdesc, tail, sizeof(tail), offset) != sizeof(tail))
+			elog(ERROR, "failed on pread('%s'): %m", wstate->filename);
+		offset -= *((uint32_t *)tail);
+		if (offset < 0 || offset >= stat_buf.st_size)
+			elog(ERROR, "arrow_fdw: file '%s' has corrupted footer", wstate->filename);
+		length = stat_buf.st_size - offset;
+		wstate->undo_backup = palloc(length);
+		if (pread(wstate->fdesc, wstate->undo_backup, length, offset) != length)
+			elog(ERROR, "failed on pread('%s'): %m", wstate->filename);
+		wstate->undo_offset = offset;
+		wstate->undo_length = length;
+		wstate->undo_valid = true;
+
+		/* record-batches and statistics already in the file */
+		num_old_batches = af_info.footer._num_recordBatches;
+		for (int j=0; j < table->nfields; j++)
+		{
+			SQLfield   *column = &table->columns[j];
+
+			for (SQLstat *curr = column->stat_list; curr; curr = curr->next)
+				curr->rb_index += num_old_batches;
+			for (SQLstat *curr = column->zone_list; curr; curr = curr->next)
+				curr->rb_index += num_old_batches;
+			__arrowFdwRestoreFieldStats(column, &schema->fields[j],
+										num_old_batches);
+		}
+		for (int i=0; i < num_old_batches; i++)
+			sql_table_append_record_batch(table, &af_info.footer.recordBatches[i]);
+		table->customMetadata = schema->custom_metadata;
+		table->numCustomMetadata = schema->_num_custom_metadata;
+		table->f_pos = offset;
+	}
+	/* copy the new record-batches, then write out the new footer */
+	base = table->f_pos;
+	__arrowFdwCopySpillFile(wstate, spill_length);
+	for (int i=0; i < num_new_batches; i++)
+	{
+		new_batches[i].offset += base;
+		sql_table_append_record_batch(table, &new_batches[i]);
+	}
+	writeArrowFooter(table);
+	if (pg_fsync(wstate->fdesc) != 0)
+		ereport(data_sync_elevel(ERROR),
+				(errcode_for_file_access(),
+				 errmsg("could not fsync file \"%s\": %m", wstate->filename)));
 }
 
 /*
- * ArrowAnalyzeForeignTable
+ * __arrowFdwWriteStateRelease
  */
-static int
-RecordBatchAcquireSampleRows(Relation relation,
-							 RecordBatchState *rb_state,
-							 HeapTuple *rows,
-							 int nsamples)
+static void
+__arrowFdwWriteStateRelease(arrowWriteState *wstate, bool is_abort)
 {
-	TupleDesc		tupdesc = RelationGetDescr(relation);
-	kern_data_store *kds;
-	Bitmapset	   *referenced = NULL;
-	StringInfoData	buffer;
-	Datum		   *values;
-	bool		   *isnull;
-	int				count;
-	uint32_t		index;
-
-	/* ANALYZE needs to fetch all the attributes */
-	referenced = bms_make_singleton(-FirstLowInvalidHeapAttributeNumber);
-	initStringInfo(&buffer);
-	kds = arrowFdwFillupRecordBatch(relation,
-									referenced,
-									rb_state,
-									&buffer);
-	values = alloca(sizeof(Datum) * tupdesc->natts);
-	isnull = alloca(sizeof(bool)  * tupdesc->natts);
-	for (count = 0; count < nsamples; count++)
+	if (wstate->fdesc >= 0 && is_abort && wstate->undo_valid)
 	{
-		/* fetch a row randomly */
-		index = (double)kds->nitems * drand48();
-		Assert(index < kds->nitems);
+		off_t		offset = 0;
+		ssize_t		nbytes;
 
-		for (int j=0; j < kds->ncols; j++)
+		/* apply the undo log */
+		while (offset < wstate->undo_length)
 		{
-			kern_colmeta   *cmeta = &kds->colmeta[j];
-
-			pg_datum_arrow_ref(kds,
-							   cmeta,
-							   index,
-							   values + j,
-							   isnull + j);
+			nbytes = pwrite(wstate->fdesc,
+							wstate->undo_backup + offset,
+							wstate->undo_length - offset,
+							wstate->undo_offset + offset);
+			if (nbytes <= 0)
+			{
+				if (nbytes < 0 && errno == EINTR)
+					continue;
+				elog(WARNING, "arrow_fdw: failed on restore the footer of '%s': %m",
+					 wstate->filename);
+				break;
+			}
+			offset += nbytes;
 		}
-		rows[count] = heap_form_tuple(tupdesc, values, isnull);
+		if (ftruncate(wstate->fdesc, wstate->undo_offset +
+								  wstate->undo_length) != 0)
+			elog(WARNING, "arrow_fdw: failed on ftruncate('%s'): %m",
+				 wstate->filename);
+		if (wstate->file_created && unlink(wstate->filename) != 0)
+			elog(WARNING, "arrow_fdw: failed on unlink('%s'): %m",
+				 wstate->filename);
 	}
-	pfree(buffer.data);
-
-	return count;
+	else if (wstate->fdesc >= 0 && is_abort && wstate->file_created)
+	{
+		if (unlink(wstate->filename) != 0)
+			elog(WARNING, "arrow_fdw: failed on unlink('%s'): %m",
+				 wstate->filename);
+	}
+	/* flock(2) is released on close */
+	if (wstate->fdesc >= 0)
+		CloseTransientFile(wstate->fdesc);
+	if (wstate->spill_fdesc >= 0)
+		CloseTransientFile(wstate->spill_fdesc);
+	wstate->fdesc = -1;
+	wstate->spill_fdesc = -1;
 }
 
-static int
-ArrowAcquireSampleRows(Relation relation,
-					   int elevel,
-					   HeapTuple *rows,
-					   int nrooms,
-					   double *p_totalrows,
-					   double *p_totaldeadrows)
+/*
+ * arrowFdwXactCallback
+ */
+static void
+arrowFdwXactCallback(XactEvent event, void *arg)
 {
-	ForeignTable   *ft = GetForeignTable(RelationGetRelid(relation));
-	List		   *filesList = arrowFdwExtractFilesList(ft->options, NULL);
-	List		   *rb_state_list = NIL;
-	ListCell	   *lc1, *lc2;
-	int64			total_nrows = 0;
-	int64			count_nrows = 0;
-	int				nsamples_min = nrooms / 100;
-	int				nitems = 0;
+	ListCell   *lc;
 
-	foreach (lc1, filesList)
+	if (arrow_write_states == NIL)
+		return;
+	switch (event)
 	{
-		ArrowFileState *af_state;
-		char	   *fname = strVal(lfirst(lc1));
-
-		af_state = BuildArrowFileState(relation, fname, NULL);
-		if (!af_state)
-			continue;
-		foreach (lc2, af_state->rb_list)
-		{
-			RecordBatchState *rb_state = lfirst(lc2);
+		case XACT_EVENT_PRE_COMMIT:
+			foreach (lc, arrow_write_states)
+			{
+				arrowWriteState *wstate = lfirst(lc);
+				MemoryContext oldcxt = MemoryContextSwitchTo(arrow_write_memcxt);
 
-			if (rb_state->rb_nitems == 0)
-				continue;	/* not reasonable to sample, skipped */
-			total_nrows += rb_state->rb_nitems;
-			rb_state_list = lappend(rb_state_list, rb_state);
-		}
+				__arrowFdwWriteStateCommit(wstate);
+				MemoryContextSwitchTo(oldcxt);
+			}
+			break;
+		case XACT_EVENT_PRE_PREPARE:
+			elog(ERROR, "arrow_fdw: cannot PREPARE a transaction that wrote arrow files");
+			break;
+		case XACT_EVENT_COMMIT:
+		case XACT_EVENT_ABORT:
+			foreach (lc, arrow_write_states)
+			{
+				__arrowFdwWriteStateRelease(lfirst(lc),
+											event == XACT_EVENT_ABORT);
+			}
+			/* memory context is released with TopTransactionContext */
+			arrow_write_states = NIL;
+			arrow_write_memcxt = NULL;
+			break;
+		default:
+			break;
 	}
-	nrooms = Min(nrooms, total_nrows);
+}
 
-	/* fetch samples for each record-batch */
-	foreach (lc1, rb_state_list)
+/*
+ * pgstrom_arrow_export_query
+ *
+ * It runs the query on the server side, then writes out the results to
+ * a new arrow file, using the same writer with INSERT on arrow_fdw; so the
+ * file has the min/max statistics if the column types support them.
+ * Unlike INSERT, the record-batches are written to the destination file
+ * directly, without the spill file and the undo log, because nobody else
+ * refers the new file. The file is removed on errors.
+ * GpuScan/GpuJoin write back their results in the columnar format during
+ * the export, if all the attributes are fixed-length.
+ */
+PG_FUNCTION_INFO_V1(pgstrom_arrow_export_query);
+PUBLIC_FUNCTION(Datum)
+pgstrom_arrow_export_query(PG_FUNCTION_ARGS)
+{
+	char	   *query = text_to_cstring(PG_GETARG_TEXT_PP(0));
+	char	   *filename = text_to_cstring(PG_GETARG_TEXT_PP(1));
+	bool		overwrite = PG_GETARG_BOOL(2);
+	arrowWriteState wstate;
+	SQLtable   *table;
+	TupleTableSlot *slot;
+	SPIPlanPtr	plan;
+	Portal		portal;
+	MemoryContext oldcxt;
+	int			nestlevel;
+	int			fdesc;
+	uint64_t	nrows = 0;
+
+	if (!superuser())
+		ereport(ERROR,
+				(errcode(ERRCODE_INSUFFICIENT_PRIVILEGE),
+				 errmsg("only superuser can export arrow files")));
+	if (!is_absolute_path(filename))
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_NAME),
+				 errmsg("relative path not allowed for arrow export")));
+	fdesc = OpenTransientFilePerm(filename,
+								  O_WRONLY | O_CREAT | PG_BINARY |
+								  (overwrite ? O_TRUNC : O_EXCL),
+								  S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+	if (fdesc < 0)
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not create file \"%s\": %m", filename)));
+	memset(&wstate, 0, sizeof(arrowWriteState));
+	wstate.filename = filename;
+	wstate.frelid = InvalidOid;
+	wstate.memcxt = AllocSetContextCreate(CurrentMemoryContext,
+										  "Arrow Export Buffer",
+										  ALLOCSET_DEFAULT_SIZES);
+	wstate.spill_fdesc = fdesc;	/* record-batches are written directly */
+	wstate.fdesc = fdesc;
+
+	/* the device results are written back in columnar, if possible */
+	nestlevel = NewGUCNestLevel();
+	(void) set_config_option("pg_strom.gpu_columnar_results", "on",
+							 PGC_USERSET, PGC_S_SESSION,
+							 GUC_ACTION_SAVE, true, 0, false);
+	PG_TRY();
 	{
-		RecordBatchState *rb_state = lfirst(lc1);
-		int			nsamples;
-
-		count_nrows += rb_state->rb_nitems;
-		nsamples = (double)nrooms * ((double)count_nrows /
-									 (double)total_nrows) - nitems;
-		if (nitems + nsamples > nrooms)
-			nsamples = nrooms - nitems;
-		if (nsamples > nsamples_min)
-			nitems += RecordBatchAcquireSampleRows(relation,
-												   rb_state,
-												   rows + nitems,
-												   nsamples);
+		if (SPI_connect() != SPI_OK_CONNECT)
+			elog(ERROR, "failed on SPI_connect");
+		plan = SPI_prepare(query, 0, NULL);
+		if (!plan)
+			elog(ERROR, "failed on SPI_prepare('%s'): %s",
+				 query, SPI_result_code_string(SPI_result));
+		if (!SPI_is_cursor_plan(plan))
+			elog(ERROR, "arrow export: query must return rows");
+		portal = SPI_cursor_open(NULL, plan, NULL, NULL, true);
+
+		/* setup the SQLtable, then write out the header and schema */
+		oldcxt = MemoryContextSwitchTo(wstate.memcxt);
+		table = __arrowFdwSetupSQLTable(portal->tupDesc,
+										"query result",
+										filename, NULL);
+		table->fdesc = fdesc;
+		table->f_pos = 0;
+		arrowFileWrite(table, "ARROW1\0\0", 8);
+		writeArrowSchema(table);
+		wstate.table = table;
+		slot = MakeSingleTupleTableSlot(portal->tupDesc, &TTSOpsHeapTuple);
+		MemoryContextSwitchTo(oldcxt);
+
+		for (;;)
+		{
+			SPI_cursor_fetch(portal, true, 10000);
+			if (SPI_processed == 0)
+				break;
+			for (uint64 i=0; i < SPI_processed; i++)
+			{
+				ExecStoreHeapTuple(SPI_tuptable->vals[i], slot, false);
+				__arrowFdwWriteTuple(&wstate, slot);
+				ExecClearTuple(slot);
+			}
+			nrows += SPI_processed;
+			SPI_freetuptable(SPI_tuptable);
+			CHECK_FOR_INTERRUPTS();
+		}
+		SPI_cursor_close(portal);
+		ExecDropSingleTupleTableSlot(slot);
+
+		/* write out the last record-batch and the footer */
+		oldcxt = MemoryContextSwitchTo(wstate.memcxt);
+		__arrowFdwFlushRecordBatch(&wstate);
+		writeArrowFooter(table);
+		MemoryContextSwitchTo(oldcxt);
+		if (pg_fsync(fdesc) != 0)
+			ereport(data_sync_elevel(ERROR),
+					(errcode_for_file_access(),
+					 errmsg("could not fsync file \"%s\": %m", filename)));
+		SPI_finish();
 	}
-	*p_totalrows = total_nrows;
-	*p_totaldeadrows = 0.0;
+	PG_CATCH();
+	{
+		/* do not leave the incomplete file */
+		if (unlink(filename) != 0 && errno != ENOENT)
+			elog(WARNING, "failed on unlink('%s'): %m", filename);
+		PG_RE_THROW();
+	}
+	PG_END_TRY();
+	AtEOXact_GUC(true, nestlevel);
+	CloseTransientFile(fdesc);
+	MemoryContextDelete(wstate.memcxt);
 
-	return nitems;
+	PG_RETURN_INT64(nrows);
 }
 
 /*
- * ArrowAnalyzeForeignTable
+ * ArrowIsForeignRelUpdatable
  */
-static bool
-ArrowAnalyzeForeignTable(Relation frel,
-						 AcquireSampleRowsFunc *p_sample_rows_func,
-						 BlockNumber *p_totalpages)
+static int
+ArrowIsForeignRelUpdatable(Relation frel)
 {
-	ForeignTable   *ft = GetForeignTable(RelationGetRelid(frel));
-	List		   *filesList = arrowFdwExtractFilesList(ft->options, NULL);
-	ListCell	   *lc;
-	size_t			totalpages = 0;
+	ForeignTable *ft = GetForeignTable(RelationGetRelid(frel));
+	ListCell   *lc;
 
-	foreach (lc, filesList)
+	foreach (lc, ft->options)
 	{
-		const char	   *fname = strVal(lfirst(lc));
-		struct stat		stat_buf;
+		DefElem	   *defel = lfirst(lc);
 
-		if (stat(fname, &stat_buf) != 0)
-		{
-			elog(NOTICE, "failed on stat('%s') on behalf of '%s', skipped",
-				 fname, get_rel_name(ft->relid));
-			continue;
-		}
-		totalpages += (stat_buf.st_size + BLCKSZ - 1) / BLCKSZ;
+		if (strcmp(defel->defname, "writable") == 0 &&
+			defGetBoolean(defel))
+			return (1 << CMD_INSERT);
 	}
-	if (totalpages > MaxBlockNumber)
-		totalpages = MaxBlockNumber;
+	return 0;
+}
 
-	*p_sample_rows_func = ArrowAcquireSampleRows;
-	*p_totalpages = totalpages;
+/*
+ * ArrowBeginForeignModify
+ */
+static void
+ArrowBeginForeignModify(ModifyTableState *mtstate,
+						ResultRelInfo *rrinfo,
+						List *fdw_private,
+						int subplan_index,
+						int eflags)
+{
+	if ((eflags & EXEC_FLAG_EXPLAIN_ONLY) != 0)
+		return;
+	if (mtstate->operation != CMD_INSERT)
+		elog(ERROR, "arrow_fdw: only INSERT is supported");
+	rrinfo->ri_FdwState = __arrowFdwLookupWriteState(rrinfo->ri_RelationDesc);
+}
 
-	return true;
+/*
+ * ArrowExecForeignInsert
+ */
+static TupleTableSlot *
+ArrowExecForeignInsert(EState *estate,
+					   ResultRelInfo *rrinfo,
+					   TupleTableSlot *slot,
+					   TupleTableSlot *planSlot)
+{
+	__arrowFdwWriteTuple(rrinfo->ri_FdwState, slot);
+	return slot;
+}
+
+/*
+ * ArrowExecForeignBatchInsert
+ */
+static TupleTableSlot **
+ArrowExecForeignBatchInsert(EState *estate,
+							ResultRelInfo *rrinfo,
+							TupleTableSlot **slots,
+							TupleTableSlot **planSlots,
+							int *numSlots)
+{
+	for (int i=0; i < *numSlots; i++)
+		__arrowFdwWriteTuple(rrinfo->ri_FdwState, slots[i]);
+	return slots;
+}
+
+/*
+ * ArrowGetForeignModifyBatchSize
+ */
+static int
+ArrowGetForeignModifyBatchSize(ResultRelInfo *rrinfo)
+{
+	/* same restriction with postgres_fdw */
+	if (rrinfo->ri_projectReturning != NULL ||
+		(rrinfo->ri_TrigDesc &&
+		 (rrinfo->ri_TrigDesc->trig_insert_before_row ||
+		  rrinfo->ri_TrigDesc->trig_insert_after_row)))
+		return 1;
+	return 1000;
+}
+
+/*
+ * ArrowEndForeignModify
+ */
+static void
+ArrowEndForeignModify(EState *estate, ResultRelInfo *rrinfo)
+{
+	/* buffered rows are written out at the pre-commit */
+}
+
+/*
+ * ArrowBeginForeignInsert
+ */
+static void
+ArrowBeginForeignInsert(ModifyTableState *mtstate,
+						ResultRelInfo *rrinfo)
+{
+	rrinfo->ri_FdwState = __arrowFdwLookupWriteState(rrinfo->ri_RelationDesc);
+}
+
+/*
+ * ArrowEndForeignInsert
+ */
+static void
+ArrowEndForeignInsert(EState *estate, ResultRelInfo *rrinfo)
+{
+	/* buffered rows are written out at the pre-commit */
 }
 
 /*
@@ -4120,8 +10040,10 @@ ArrowImportForeignSchema(ImportForeignSchemaStmt *stmt, Oid serverOid)
 {
 	ArrowSchema	schema;
 	List	   *filesList;
+	List	   *partition_keys = NIL;
 	ListCell   *lc;
 	int			j;
+	bool		hive_partitioning;
 	StringInfoData	cmd;
 
 	/* sanity checks */
@@ -4139,7 +10061,8 @@ ArrowImportForeignSchema(ImportForeignSchemaStmt *stmt, Oid serverOid)
 			elog(ERROR, "arrow_fdw: Bug? unknown list-type");
 			break;
 	}
-	filesList = arrowFdwExtractFilesList(stmt->options, NULL);
+	filesList = arrowFdwExtractFilesList(stmt->options, NULL,
+										 &hive_partitioning);
 	if (filesList == NIL)
 		ereport(ERROR,
 				(errmsg("No valid apache arrow files are specified"),
@@ -4156,6 +10079,8 @@ ArrowImportForeignSchema(ImportForeignSchemaStmt *stmt, Oid serverOid)
 		if (lc == list_head(filesList))
 		{
 			copyArrowNode(&schema.node, &af_info.footer.schema.node);
+			if (hive_partitioning)
+				partition_keys = __arrowFdwParsePartitionKeys(fname);
 		}
 		else
 		{
@@ -4217,6 +10142,14 @@ ArrowImportForeignSchema(ImportForeignSchemaStmt *stmt, Oid serverOid)
 		}
 		ReleaseSysCache(htup);
 	}
+	/* partition keys are imported as text columns */
+	foreach (lc, partition_keys)
+	{
+		arrowPartitionKey *pkey = lfirst(lc);
+
+		appendStringInfo(&cmd, ",\n  %s pg_catalog.text",
+						 quote_identifier(pkey->key));
+	}
 	appendStringInfo(&cmd,
 					 "\n"
 					 ") SERVER %s\n"
@@ -4416,6 +10349,592 @@ pgstrom_arrow_fdw_import_file(PG_FUNCTION_ARGS)
 	PG_RETURN_VOID();
 }
 
+/* ----------------------------------------------------------------
+ *
+ * Incremental aggregates on arrow_fdw
+ *
+ * An aggregate query on the arrow_fdw foreign table is registered with its
+ * result table, and the number of record-batches already merged for each
+ * file (watermark). pgstrom.arrow_incremental_refresh() scans only the
+ * record-batches appended after the watermark, by GpuPreAgg as usual, then
+ * merges the new groups into the result table.
+ * The merge is limited to the aggregate functions whose final results can
+ * be combined by themselves (count, sum, min, max, ...); e.g, avg() shall
+ * be kept as sum() and count().
+ *
+ * ----------------------------------------------------------------
+ */
+
+/*
+ * __arrowIncrementalMergeOp
+ */
+static const char *
+__arrowIncrementalMergeOp(Aggref *aggref)
+{
+	static struct {
+		const char *aggname;
+		const char *merge_op;
+	} merge_catalog[] = {
+		{"count",    "sum"},
+		{"sum",      "sum"},
+		{"min",      "min"},
+		{"max",      "max"},
+		{"bool_and", "and"},
+		{"every",    "and"},
+		{"bool_or",  "or"},
+		{"bit_and",  "bit_and"},
+		{"bit_or",   "bit_or"},
+		{NULL, NULL},
+	};
+	const char *aggname;
+
+	if (get_func_namespace(aggref->aggfnoid) != PG_CATALOG_NAMESPACE ||
+		aggref->aggkind != AGGKIND_NORMAL ||
+		aggref->aggdistinct != NIL)
+		return NULL;
+	aggname = get_func_name(aggref->aggfnoid);
+	for (int i=0; merge_catalog[i].aggname; i++)
+	{
+		if (strcmp(aggname, merge_catalog[i].aggname) == 0)
+			return merge_catalog[i].merge_op;
+	}
+	return NULL;
+}
+
+/*
+ * __arrowIncrementalMergeExpr
+ */
+static void
+__arrowIncrementalMergeExpr(StringInfo buf, const char *merge_op,
+							const char *cname)
+{
+	const char *oper;
+
+	if (strcmp(merge_op, "min") == 0 ||
+		strcmp(merge_op, "max") == 0)
+	{
+		/* LEAST/GREATEST ignore NULLs, as min/max doing */
+		appendStringInfo(buf, "%s(__r.%s, __d.%s)",
+						 strcmp(merge_op, "min") == 0 ? "LEAST" : "GREATEST",
+						 cname, cname);
+		return;
+	}
+	if (strcmp(merge_op, "sum") == 0)
+		oper = "+";
+	else if (strcmp(merge_op, "and") == 0)
+		oper = "AND";
+	else if (strcmp(merge_op, "or") == 0)
+		oper = "OR";
+	else if (strcmp(merge_op, "bit_and") == 0)
+		oper = "&";
+	else if (strcmp(merge_op, "bit_or") == 0)
+		oper = "|";
+	else
+		elog(ERROR, "unknown merge operation of incremental aggregate: %s",
+			 merge_op);
+	appendStringInfo(buf,
+					 "CASE WHEN __r.%s IS NULL THEN __d.%s"
+					 " WHEN __d.%s IS NULL THEN __r.%s"
+					 " ELSE __r.%s %s __d.%s END",
+					 cname, cname,
+					 cname, cname,
+					 cname, oper, cname);
+}
+
+/*
+ * __arrowIncrementalMergeQuery
+ *
+ * It builds the query to merge the new groups (__d) into the result table
+ * (__r); existing groups are updated, then the other ones are inserted.
+ */
+static char *
+__arrowIncrementalMergeQuery(Relation arel, const char *agg_query,
+							 Datum *merge_ops, int num_merge_ops)
+{
+	TupleDesc	tupdesc = RelationGetDescr(arel);
+	const char *relname;
+	const char **cnames;
+	StringInfoData buf;
+	StringInfoData cond;
+	int			ncols = 0;
+	int			nkeys = 0;
+	int			naggs = 0;
+
+	relname = quote_qualified_identifier(get_namespace_name(RelationGetNamespace(arel)),
+										 RelationGetRelationName(arel));
+	cnames = alloca(sizeof(char *) * (tupdesc->natts + 1));
+	for (int j=0; j < tupdesc->natts; j++)
+	{
+		Form_pg_attribute attr = TupleDescAttr(tupdesc, j);
+
+		if (!attr->attisdropped)
+			cnames[ncols++] = quote_identifier(NameStr(attr->attname));
+	}
+	if (ncols != num_merge_ops)
+		elog(ERROR, "result table %s of the incremental aggregate has %d columns, but %d expected",
+			 relname, ncols, num_merge_ops);
+
+	initStringInfo(&buf);
+	initStringInfo(&cond);
+	appendStringInfo(&buf, "WITH __d(");
+	for (int j=0; j < ncols; j++)
+		appendStringInfo(&buf, "%s%s", j > 0 ? ", " : "", cnames[j]);
+	appendStringInfo(&buf, ") AS (%s),\n"
+					 "     __u AS (UPDATE %s __r SET ",
+					 agg_query, relname);
+	for (int j=0; j < ncols; j++)
+	{
+		const char *merge_op = TextDatumGetCString(merge_ops[j]);
+
+		if (strcmp(merge_op, "key") == 0)
+		{
+			appendStringInfo(&cond, "%s__r.%s IS NOT DISTINCT FROM __d.%s",
+							 nkeys++ > 0 ? " AND " : "",
+							 cnames[j], cnames[j]);
+		}
+		else
+		{
+			appendStringInfo(&buf, "%s%s = ",
+							 naggs++ > 0 ? ", " : "", cnames[j]);
+			__arrowIncrementalMergeExpr(&buf, merge_op, cnames[j]);
+		}
+	}
+	appendStringInfo(&buf, " FROM __d");
+	if (nkeys > 0)
+		appendStringInfo(&buf, " WHERE %s", cond.data);
+	appendStringInfo(&buf, " RETURNING __d.*)\n"
+					 "INSERT INTO %s SELECT * FROM __d"
+					 " WHERE NOT EXISTS (SELECT 1 FROM __u",
+					 relname);
+	if (nkeys > 0)
+	{
+		/* same condition, but on __u instead of __r */
+		resetStringInfo(&cond);
+		nkeys = 0;
+		for (int j=0; j < ncols; j++)
+		{
+			if (strcmp(TextDatumGetCString(merge_ops[j]), "key") == 0)
+				appendStringInfo(&cond, "%s__u.%s IS NOT DISTINCT FROM __d.%s",
+								 nkeys++ > 0 ? " AND " : "",
+								 cnames[j], cnames[j]);
+		}
+		appendStringInfo(&buf, " WHERE %s", cond.data);
+	}
+	appendStringInfo(&buf, ")");
+	pfree(cond.data);
+
+	return buf.data;
+}
+
+/*
+ * pgstrom_arrow_incremental_create
+ *
+ * pgstrom.arrow_incremental_create(text relname, text query, text schema)
+ *
+ * It is superuser only (also _refresh and _drop), because the bookkeeping
+ * tables are shared by all the users; privileges are checked prior to any
+ * updates, not by the SPI in the halfway.
+ */
+PG_FUNCTION_INFO_V1(pgstrom_arrow_incremental_create);
+PUBLIC_FUNCTION(Datum)
+pgstrom_arrow_incremental_create(PG_FUNCTION_ARGS)
+{
+	char	   *relname;
+	char	   *query;
+	char	   *namespace_name = NULL;
+	List	   *raw_list;
+	Query	   *qry;
+	RangeTblRef *rtr;
+	RangeTblEntry *rte;
+	Relation	frel;
+	List	   *merge_ops = NIL;
+	int			nkeys = 0;
+	int			naggs = 0;
+	Datum	   *merge_values;
+	Oid			agg_relid;
+	Oid			spi_types[4] = {REGCLASSOID, REGCLASSOID, TEXTOID, TEXTARRAYOID};
+	Datum		spi_values[4];
+	StringInfoData buf;
+	ListCell   *lc;
+
+	if (!superuser())
+		ereport(ERROR,
+				(errcode(ERRCODE_INSUFFICIENT_PRIVILEGE),
+				 errmsg("only superuser can create incremental aggregates")));
+	if (PG_ARGISNULL(0))
+		elog(ERROR, "result table name is not supplied");
+	relname = text_to_cstring(PG_GETARG_TEXT_PP(0));
+	if (PG_ARGISNULL(1))
+		elog(ERROR, "aggregate query is not supplied");
+	query = text_to_cstring(PG_GETARG_TEXT_PP(1));
+	if (!PG_ARGISNULL(2))
+		namespace_name = text_to_cstring(PG_GETARG_TEXT_PP(2));
+	/* the query is embedded as a sub-query on the refresh */
+	for (int k = strlen(query) - 1; k >= 0; k--)
+	{
+		if (!isspace((unsigned char)query[k]) && query[k] != ';')
+			break;
+		query[k] = '\0';
+	}
+
+	/* check the aggregate query */
+	raw_list = pg_parse_query(query);
+	if (list_length(raw_list) != 1)
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("incremental aggregate must be a single SELECT statement")));
+	qry = parse_analyze_fixedparams(linitial_node(RawStmt, raw_list),
+									query, NULL, 0, NULL);
+	if (qry->commandType != CMD_SELECT ||
+		qry->utilityStmt != NULL ||
+		qry->setOperations != NULL ||
+		qry->cteList != NIL)
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("incremental aggregate must be a simple SELECT statement")));
+	if (!qry->hasAggs ||
+		qry->hasWindowFuncs ||
+		qry->hasTargetSRFs ||
+		qry->hasSubLinks ||
+		qry->groupingSets != NIL ||
+		qry->havingQual != NULL ||
+		qry->distinctClause != NIL ||
+		qry->sortClause != NIL ||
+		qry->limitCount != NULL ||
+		qry->limitOffset != NULL)
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("incremental aggregate must be a plain GROUP BY query"),
+				 errdetail("window functions, sub-queries, grouping sets, HAVING, DISTINCT, ORDER BY and LIMIT are not supported")));
+	if (list_length(qry->jointree->fromlist) != 1 ||
+		!IsA(linitial(qry->jointree->fromlist), RangeTblRef))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("incremental aggregate must scan a single arrow_fdw foreign table")));
+	rtr = linitial(qry->jointree->fromlist);
+	rte = rt_fetch(rtr->rtindex, qry->rtable);
+	if (rte->rtekind != RTE_RELATION ||
+		rte->relkind != RELKIND_FOREIGN_TABLE)
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("incremental aggregate must scan a single arrow_fdw foreign table")));
+	frel = table_open(rte->relid, AccessShareLock);
+	if (!RelationIsArrowFdw(frel))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("foreign table \"%s\" is not managed by arrow_fdw",
+						RelationGetRelationName(frel))));
+	table_close(frel, NoLock);
+
+	foreach (lc, qry->targetList)
+	{
+		TargetEntry *tle = lfirst(lc);
+		const char *merge_op;
+
+		if (tle->resjunk)
+			continue;
+		if (tle->ressortgroupref != 0 &&
+			get_sortgroupref_clause_noerr(tle->ressortgroupref,
+										  qry->groupClause) != NULL)
+		{
+			merge_op = "key";
+			nkeys++;
+		}
+		else if (IsA(tle->expr, Aggref))
+		{
+			merge_op = __arrowIncrementalMergeOp((Aggref *)tle->expr);
+			if (!merge_op)
+				ereport(ERROR,
+						(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+						 errmsg("aggregate function %s cannot be merged incrementally",
+								format_procedure(((Aggref *)tle->expr)->aggfnoid)),
+						 errhint("count, sum, min, max, bool_and, bool_or, bit_and and bit_or without DISTINCT are supported; e.g, avg(x) can be kept as sum(x) and count(x).")));
+			naggs++;
+		}
+		else
+			ereport(ERROR,
+					(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+					 errmsg("column %d of the incremental aggregate must be a grouping key or an aggregate function",
+							tle->resno)));
+		merge_ops = lappend(merge_ops, makeString(pstrdup(merge_op)));
+	}
+	if (nkeys != list_length(qry->groupClause))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("all the grouping keys must be in the target-list of the incremental aggregate")));
+	if (naggs == 0)
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("incremental aggregate needs at least one aggregate function")));
+
+	/* create the result table, then register it */
+	merge_values = palloc(sizeof(Datum) * list_length(merge_ops));
+	foreach (lc, merge_ops)
+		merge_values[foreach_current_index(lc)] = CStringGetTextDatum(strVal(lfirst(lc)));
+
+	initStringInfo(&buf);
+	appendStringInfo(&buf, "CREATE TABLE %s AS %s WITH NO DATA",
+					 quote_qualified_identifier(namespace_name, relname),
+					 query);
+	if (SPI_connect() != SPI_OK_CONNECT)
+		elog(ERROR, "failed on SPI_connect");
+	if (SPI_execute(buf.data, false, 0) != SPI_OK_UTILITY)
+		elog(ERROR, "failed on SPI_execute('%s')", buf.data);
+	agg_relid = RangeVarGetRelid(makeRangeVar(namespace_name, relname, -1),
+								 NoLock, false);
+	spi_values[0] = ObjectIdGetDatum(agg_relid);
+	spi_values[1] = ObjectIdGetDatum(rte->relid);
+	spi_values[2] = CStringGetTextDatum(query);
+	spi_values[3] = PointerGetDatum(construct_array(merge_values,
+													list_length(merge_ops),
+													TEXTOID, -1, false,
+													TYPALIGN_INT));
+	if (SPI_execute_with_args("INSERT INTO pgstrom.arrow_incremental_aggs"
+							  "(agg_relid, ftable, agg_query, agg_merge)"
+							  " VALUES ($1, $2, $3, $4)",
+							  4, spi_types, spi_values, NULL,
+							  false, 0) != SPI_OK_INSERT)
+		elog(ERROR, "failed on SPI_execute_with_args");
+	SPI_finish();
+
+	PG_RETURN_OID(agg_relid);
+}
+
+/*
+ * pgstrom_arrow_incremental_refresh
+ *
+ * pgstrom.arrow_incremental_refresh(regclass)
+ *
+ * It returns the number of record-batches newly merged.
+ */
+PG_FUNCTION_INFO_V1(pgstrom_arrow_incremental_refresh);
+PUBLIC_FUNCTION(Datum)
+pgstrom_arrow_incremental_refresh(PG_FUNCTION_ARGS)
+{
+	Oid			agg_relid = PG_GETARG_OID(0);
+	Oid			spi_types[3] = {REGCLASSOID, TEXTARRAYOID, INT4ARRAYOID};
+	Datum		spi_values[3];
+	HeapTuple	tuple;
+	TupleDesc	tupdesc;
+	Datum		datum;
+	bool		isnull;
+	Oid			frelid;
+	char	   *agg_query;
+	ArrayType  *agg_merge;
+	Datum	   *merge_ops;
+	int			num_merge_ops;
+	List	   *watermark = NIL;
+	arrowIncrementalFilter filter;
+	Relation	frel;
+	Relation	arel;
+	ForeignTable *ft;
+	List	   *filesList;
+	bool		hive_partitioning;
+	Datum	   *fnames;
+	Datum	   *nbatches;
+	int			nfiles = 0;
+	int64		nitems = 0;
+	ListCell   *lc;
+
+	if (!superuser())
+		ereport(ERROR,
+				(errcode(ERRCODE_INSUFFICIENT_PRIVILEGE),
+				 errmsg("only superuser can refresh incremental aggregates")));
+	/* concurrent refreshes on the same aggregate are serialized */
+	LockRelationOid(agg_relid, ShareRowExclusiveLock);
+
+	if (SPI_connect() != SPI_OK_CONNECT)
+		elog(ERROR, "failed on SPI_connect");
+	spi_values[0] = ObjectIdGetDatum(agg_relid);
+	if (SPI_execute_with_args("SELECT ftable, agg_query, agg_merge"
+							  "  FROM pgstrom.arrow_incremental_aggs"
+							  " WHERE agg_relid = $1",
+							  1, spi_types, spi_values, NULL,
+							  true, 0) != SPI_OK_SELECT)
+		elog(ERROR, "failed on SPI_execute_with_args");
+	if (SPI_processed != 1)
+		ereport(ERROR,
+				(errcode(ERRCODE_UNDEFINED_OBJECT),
+				 errmsg("relation \"%s\" is not an incremental aggregate",
+						get_rel_name(agg_relid))));
+	tuple = SPI_tuptable->vals[0];
+	tupdesc = SPI_tuptable->tupdesc;
+	datum = SPI_getbinval(tuple, tupdesc, 1, &isnull);
+	frelid = DatumGetObjectId(datum);
+	datum = SPI_getbinval(tuple, tupdesc, 2, &isnull);
+	agg_query = TextDatumGetCString(datum);
+	datum = SPI_getbinval(tuple, tupdesc, 3, &isnull);
+	agg_merge = DatumGetArrayTypeP(datum);
+	deconstruct_array(agg_merge, TEXTOID, -1, false, TYPALIGN_INT,
+					  &merge_ops, NULL, &num_merge_ops);
+
+	/* watermark of the files */
+	if (SPI_execute_with_args("SELECT filename, nbatches"
+							  "  FROM pgstrom.arrow_incremental_files"
+							  " WHERE agg_relid = $1",
+							  1, spi_types, spi_values, NULL,
+							  true, 0) != SPI_OK_SELECT)
+		elog(ERROR, "failed on SPI_execute_with_args");
+	for (uint64 i=0; i < SPI_processed; i++)
+	{
+		arrowIncrementalFile *incr = palloc0(sizeof(arrowIncrementalFile));
+
+		tuple = SPI_tuptable->vals[i];
+		tupdesc = SPI_tuptable->tupdesc;
+		datum = SPI_getbinval(tuple, tupdesc, 1, &isnull);
+		incr->filename = TextDatumGetCString(datum);
+		datum = SPI_getbinval(tuple, tupdesc, 2, &isnull);
+		incr->rb_skip = DatumGetInt32(datum);
+		watermark = lappend(watermark, incr);
+	}
+
+	/* pick up the record-batches appended after the watermark */
+	memset(&filter, 0, sizeof(arrowIncrementalFilter));
+	filter.frelid = frelid;
+	frel = table_open(frelid, AccessShareLock);
+	ft = GetForeignTable(frelid);
+	filesList = arrowFdwExtractFilesList(ft->options, NULL,
+										 &hive_partitioning);
+	fnames = palloc(sizeof(Datum) * (list_length(filesList) + 1));
+	nbatches = palloc(sizeof(Datum) * (list_length(filesList) + 1));
+	foreach (lc, filesList)
+	{
+		char	   *fname = strVal(lfirst(lc));
+		ArrowFileState *af_state;
+		arrowIncrementalFile *incr;
+		arrowIncrementalFile *prev;
+
+		af_state = BuildArrowFileState(frel, fname, hive_partitioning, NULL);
+		if (!af_state)
+			continue;
+		incr = palloc0(sizeof(arrowIncrementalFile));
+		incr->filename = fname;
+		incr->rb_count = list_length(af_state->rb_list);
+		prev = __arrowIncrementalLookupFile(watermark, fname);
+		if (prev)
+		{
+			if (incr->rb_count < prev->rb_skip)
+				ereport(ERROR,
+						(errcode(ERRCODE_OBJECT_NOT_IN_PREREQUISITE_STATE),
+						 errmsg("arrow file '%s' has %d record-batches, but %d were already aggregated",
+								fname, incr->rb_count, prev->rb_skip),
+						 errhint("Only appending files or record-batches is allowed on the incremental aggregate; re-create it to aggregate the modified files.")));
+			incr->rb_skip = prev->rb_skip;
+		}
+		if (incr->rb_skip < incr->rb_count)
+		{
+			filter.files = lappend(filter.files, incr);
+			nitems += (incr->rb_count - incr->rb_skip);
+		}
+		fnames[nfiles] = CStringGetTextDatum(fname);
+		nbatches[nfiles] = Int32GetDatum(incr->rb_count);
+		nfiles++;
+	}
+	table_close(frel, AccessShareLock);
+
+	if (filter.files != NIL)
+	{
+		char	   *merge_query;
+		int			nestlevel;
+
+		arel = table_open(agg_relid, NoLock);
+		merge_query = __arrowIncrementalMergeQuery(arel, agg_query,
+												   merge_ops, num_merge_ops);
+		table_close(arel, NoLock);
+
+		/*
+		 * parallel workers set up the arrow_fdw scan by themselves,
+		 * so they never see the filter of the leader.
+		 */
+		nestlevel = NewGUCNestLevel();
+		(void) set_config_option("max_parallel_workers_per_gather", "0",
+								 PGC_USERSET, PGC_S_SESSION,
+								 GUC_ACTION_SAVE, true, 0, false);
+		arrow_incremental_filter = &filter;
+		PG_TRY();
+		{
+			if (SPI_execute(merge_query, false, 0) != SPI_OK_INSERT)
+				elog(ERROR, "failed on SPI_execute('%s')", merge_query);
+		}
+		PG_FINALLY();
+		{
+			arrow_incremental_filter = NULL;
+		}
+		PG_END_TRY();
+		AtEOXact_GUC(true, nestlevel);
+	}
+
+	/*
+	 * update the watermark; files removed from the directory are also
+	 * removed, but their groups are kept on the result table.
+	 */
+	spi_values[1] = PointerGetDatum(construct_array(fnames, nfiles,
+													TEXTOID, -1, false,
+													TYPALIGN_INT));
+	spi_values[2] = PointerGetDatum(construct_array(nbatches, nfiles,
+													INT4OID, sizeof(int32),
+													true, TYPALIGN_INT));
+	if (SPI_execute_with_args("DELETE FROM pgstrom.arrow_incremental_files"
+							  " WHERE agg_relid = $1",
+							  1, spi_types, spi_values, NULL,
+							  false, 0) != SPI_OK_DELETE)
+		elog(ERROR, "failed on SPI_execute_with_args");
+	if (SPI_execute_with_args("INSERT INTO pgstrom.arrow_incremental_files"
+							  "(agg_relid, filename, nbatches)"
+							  " SELECT $1, f, n FROM unnest($2, $3) AS x(f, n)",
+							  3, spi_types, spi_values, NULL,
+							  false, 0) != SPI_OK_INSERT)
+		elog(ERROR, "failed on SPI_execute_with_args");
+	SPI_finish();
+
+	PG_RETURN_INT64(nitems);
+}
+
+/*
+ * pgstrom_arrow_incremental_drop
+ *
+ * pgstrom.arrow_incremental_drop(regclass)
+ */
+PG_FUNCTION_INFO_V1(pgstrom_arrow_incremental_drop);
+PUBLIC_FUNCTION(Datum)
+pgstrom_arrow_incremental_drop(PG_FUNCTION_ARGS)
+{
+	Oid			agg_relid = PG_GETARG_OID(0);
+	Oid			spi_types[1] = {REGCLASSOID};
+	Datum		spi_values[1];
+	char	   *relname;
+
+	if (!superuser())
+		ereport(ERROR,
+				(errcode(ERRCODE_INSUFFICIENT_PRIVILEGE),
+				 errmsg("only superuser can drop incremental aggregates")));
+	relname = quote_qualified_identifier(get_namespace_name(get_rel_namespace(agg_relid)),
+										 get_rel_name(agg_relid));
+	if (SPI_connect() != SPI_OK_CONNECT)
+		elog(ERROR, "failed on SPI_connect");
+	spi_values[0] = ObjectIdGetDatum(agg_relid);
+	if (SPI_execute_with_args("DELETE FROM pgstrom.arrow_incremental_aggs"
+							  " WHERE agg_relid = $1",
+							  1, spi_types, spi_values, NULL,
+							  false, 0) != SPI_OK_DELETE)
+		elog(ERROR, "failed on SPI_execute_with_args");
+	if (SPI_processed != 1)
+		ereport(ERROR,
+				(errcode(ERRCODE_UNDEFINED_OBJECT),
+				 errmsg("relation %s is not an incremental aggregate", relname)));
+	if (SPI_execute_with_args("DELETE FROM pgstrom.arrow_incremental_files"
+							  " WHERE agg_relid = $1",
+							  1, spi_types, spi_values, NULL,
+							  false, 0) != SPI_OK_DELETE)
+		elog(ERROR, "failed on SPI_execute_with_args");
+	if (SPI_execute(psprintf("DROP TABLE %s", relname),
+					false, 0) != SPI_OK_UTILITY)
+		elog(ERROR, "failed on SPI_execute");
+	SPI_finish();
+
+	PG_RETURN_VOID();
+}
+
 /*
  * handler of Arrow_Fdw
  */
@@ -4438,9 +10957,10 @@ pgstrom_arrow_fdw_validator(PG_FUNCTION_ARGS)
 
 	if (catalog == ForeignTableRelationId)
 	{
-		List	   *filesList = arrowFdwExtractFilesList(options, NULL);
+		List	   *filesList = arrowFdwExtractFilesList(options, NULL, NULL);
 		ListCell   *lc;
 
+		(void) arrowFdwLookupManifest(options);	/* check the manifest */
 		foreach (lc, filesList)
 		{
 			const char *fname = strVal(lfirst(lc));
@@ -4530,13 +11050,16 @@ pgstrom_arrow_fdw_precheck_schema(PG_FUNCTION_ARGS)
 	if (check_schema_compatibility)
 	{
 		ForeignTable *ft = GetForeignTable(RelationGetRelid(frel));
-		List	   *filesList = arrowFdwExtractFilesList(ft->options, NULL);
+		List	   *filesList;
+		bool		hive_partitioning;
 
+		filesList = arrowFdwExtractFilesList(ft->options, NULL,
+											 &hive_partitioning);
 		foreach (lc, filesList)
 		{
 			const char *fname = strVal(lfirst(lc));
 
-			(void)BuildArrowFileState(frel, fname, NULL);
+			(void)BuildArrowFileState(frel, fname, hive_partitioning, NULL);
 		}
 	}
 	if (frel)
@@ -4557,6 +11080,9 @@ pgstrom_request_arrow_fdw(void)
 	sz = TYPEALIGN(ARROW_METADATA_BLOCKSZ,
 				   (size_t)arrow_metadata_cache_size_kb << 10);
 	RequestAddinShmemSpace(MAXALIGN(sizeof(arrowMetadataCacheHead)) + sz);
+	if (arrow_dirwatch_max_dirs > 0)
+		RequestAddinShmemSpace(MAXALIGN(offsetof(arrowDirWatchHead,
+												 slots[arrow_dirwatch_max_dirs])));
 }
 
 /*
@@ -4602,6 +11128,17 @@ pgstrom_startup_arrow_fdw(void)
 
 		buffer += ARROW_METADATA_BLOCKSZ;
 	}
+
+	/* directory watcher */
+	if (arrow_dirwatch_max_dirs > 0)
+	{
+		sz = offsetof(arrowDirWatchHead, slots[arrow_dirwatch_max_dirs]);
+		arrow_dirwatch_head = ShmemInitStruct("arrowDirWatch", MAXALIGN(sz), &found);
+		Assert(!found);
+		memset(arrow_dirwatch_head, 0, sz);
+		SpinLockInit(&arrow_dirwatch_head->lock);
+		arrow_dirwatch_head->nslots = arrow_dirwatch_max_dirs;
+	}
 }
 
 /*
@@ -4633,6 +11170,15 @@ pgstrom_init_arrow_fdw(void)
 	//r->ReInitializeDSMForeignScan	= ArrowReInitializeDSMForeignScan;
 	r->InitializeWorkerForeignScan	= ArrowInitializeWorkerForeignScan;
 	r->ShutdownForeignScan			= ArrowShutdownForeignScan;
+	/* INSERT / COPY FROM support */
+	r->IsForeignRelUpdatable		= ArrowIsForeignRelUpdatable;
+	r->BeginForeignModify			= ArrowBeginForeignModify;
+	r->ExecForeignInsert			= ArrowExecForeignInsert;
+	r->ExecForeignBatchInsert		= ArrowExecForeignBatchInsert;
+	r->GetForeignModifyBatchSize	= ArrowGetForeignModifyBatchSize;
+	r->EndForeignModify				= ArrowEndForeignModify;
+	r->BeginForeignInsert			= ArrowBeginForeignInsert;
+	r->EndForeignInsert				= ArrowEndForeignInsert;
 	/* IMPORT FOREIGN SCHEMA support */
 	r->ImportForeignSchema			= ArrowImportForeignSchema;
 
@@ -4658,6 +11204,17 @@ pgstrom_init_arrow_fdw(void)
 							 PGC_USERSET,
                              GUC_NOT_IN_SAMPLE,
                              NULL, NULL, NULL);
+	/*
+	 * Turn on/off late materialization
+	 */
+	DefineCustomBoolVariable("arrow_fdw.late_materialization",
+							 "Enables to load the filter columns first, then the remaining columns only for the record-batches with survivors",
+							 NULL,
+							 &arrow_fdw_late_materialization,
+							 false,
+							 PGC_USERSET,
+							 GUC_NOT_IN_SAMPLE,
+							 NULL, NULL, NULL);
 	/*
 	 * Configurations for arrow_fdw metadata cache
 	 */
@@ -4671,11 +11228,101 @@ pgstrom_init_arrow_fdw(void)
 							PGC_POSTMASTER,
 							GUC_NOT_IN_SAMPLE | GUC_UNIT_KB,
 							NULL, NULL, NULL);
+	DefineCustomStringVariable("arrow_fdw.metadata_cache_dir",
+							   "directory of the persistent metadata cache for arrow files (empty to disable)",
+							   NULL,
+							   &arrow_metadata_cache_dir,
+							   "pg_strom_arrow_metadata",
+							   PGC_SUSET,
+							   GUC_NOT_IN_SAMPLE,
+							   NULL, NULL, NULL);
+	/*
+	 * Number of record-batches to be prefetched from the object storage
+	 */
+	DefineCustomIntVariable("arrow_fdw.object_prefetch_depth",
+							"Number of record-batches to be prefetched from the object storage",
+							NULL,
+							&arrow_object_prefetch_depth,
+							2,
+							0,
+							64,
+							PGC_USERSET,
+							GUC_NOT_IN_SAMPLE,
+							NULL, NULL, NULL);
+	/*
+	 * ANALYZE estimates ndistinct by HLL over the whole columns
+	 */
+	DefineCustomBoolVariable("arrow_fdw.analyze_hll_ndistinct",
+							 "Enables ndistinct estimation by HLL on ANALYZE",
+							 NULL,
+							 &arrow_analyze_hll_ndistinct,
+							 true,
+							 PGC_USERSET,
+							 GUC_NOT_IN_SAMPLE,
+							 NULL, NULL, NULL);
+	/*
+	 * Size of record-batch written by INSERT / COPY FROM
+	 */
+	DefineCustomIntVariable("arrow_fdw.record_batch_size",
+							"size of record-batch written by INSERT or COPY FROM",
+							NULL,
+							&arrow_record_batch_size_kb,
+							256 * 1024,		/* 256MB */
+							4 * 1024,		/* 4MB */
+							512 * 1024,		/* 512MB */
+							PGC_USERSET,
+							GUC_NOT_IN_SAMPLE | GUC_UNIT_KB,
+							NULL, NULL, NULL);
+	DefineCustomIntVariable("arrow_fdw.io_merge_gap",
+							"max length of the unused hole to merge i/o chunks",
+							NULL,
+							&arrow_io_merge_gap_kb,
+							256,		/* 256kB */
+							0,
+							64 * 1024,	/* 64MB */
+							PGC_USERSET,
+							GUC_NOT_IN_SAMPLE | GUC_UNIT_KB,
+							NULL, NULL, NULL);
+	/*
+	 * Configurations for the directory watcher
+	 */
+	DefineCustomIntVariable("arrow_fdw.dirwatch_max_dirs",
+							"max number of directories watched for the files list cache (0 to disable)",
+							NULL,
+							&arrow_dirwatch_max_dirs,
+							64,
+							0,
+							10000,
+							PGC_POSTMASTER,
+							GUC_NOT_IN_SAMPLE,
+							NULL, NULL, NULL);
+	if (arrow_dirwatch_max_dirs > 0)
+	{
+		BackgroundWorker worker;
+
+		memset(&worker, 0, sizeof(BackgroundWorker));
+		snprintf(worker.bgw_name, sizeof(worker.bgw_name),
+				 "Arrow_Fdw Directory Watcher");
+		worker.bgw_flags = BGWORKER_SHMEM_ACCESS;
+		worker.bgw_start_time = BgWorkerStart_PostmasterStart;
+		worker.bgw_restart_time = 5;
+		snprintf(worker.bgw_library_name, BGW_MAXLEN,
+				 "$libdir/pg_strom");
+		snprintf(worker.bgw_function_name, BGW_MAXLEN,
+				 "arrowFdwDirWatchWorkerMain");
+		worker.bgw_main_arg = 0;
+		RegisterBackgroundWorker(&worker);
+	}
 	/* shared memory size */
 	shmem_request_next = shmem_request_hook;
 	shmem_request_hook = pgstrom_request_arrow_fdw;
 	shmem_startup_next = shmem_startup_hook;
 	shmem_startup_hook = pgstrom_startup_arrow_fdw;
+	/* post-processing of ANALYZE */
+	process_utility_next = ProcessUtility_hook;
+	ProcessUtility_hook = arrowFdwProcessUtility;
+	/* transaction callback to write out the buffered rows */
+	RegisterXactCallback(arrowFdwXactCallback, NULL);
 }
 
 
@@ -131,6 +131,7 @@ struct SQLstat
 {
 	SQLstat		   *next;
 	int				rb_index;	/* record-batch index */
+	int				zone_index;	/* zone index in the record-batch, if zone-map */
 	bool			is_valid;	/* true, if min/max is not NULL */
 	SQLstat__datum	min;
 	SQLstat__datum	max;
@@ -161,15 +162,25 @@ struct SQLfield
 	bool		stat_enabled;
 	SQLstat		stat_datum;
 	SQLstat	   *stat_list;
+	/* min/max statistics for each zone (optional) */
+	int			zone_nrows;		/* number of rows per zone, or 0 */
+	SQLstat		zone_datum;
+	SQLstat	   *zone_list;
 	/* custom metadata(optional) */
 	ArrowKeyValue *customMetadata;
 	int			numCustomMetadata;
 };
 
+extern void		saveArrowZoneStats(SQLfield *column);
+
 static inline size_t
 sql_field_put_value(SQLfield *column, const char *addr, int sz)
 {
-	return (column->__curr_usage__ = column->put_value(column, addr, sz));
+	column->__curr_usage__ = column->put_value(column, addr, sz);
+	if (column->zone_nrows > 0 &&
+		column->nitems % column->zone_nrows == 0)
+		saveArrowZoneStats(column);
+	return column->__curr_usage__;
 }
 
 #ifndef FLEXIBLE_ARRAY_MEMBER
@@ -243,6 +254,9 @@ extern void		__initArrowNode(ArrowNode *node, ArrowNodeTag tag);
 extern char	   *dumpArrowNode(ArrowNode *node);
 extern void		copyArrowNode(ArrowNode *dest, const ArrowNode *src);
 extern void		readArrowFileDesc(int fdesc, ArrowFileInfo *af_info);
+extern ssize_t	readArrowStreamMessage(const char *buf, size_t buf_sz,
+									   ArrowMessage *message,
+									   int32_t *p_meta_sz);
 extern bool		arrowFieldTypeIsEqual(ArrowField *a, ArrowField *b);
 extern const char *arrowNodeName(ArrowNode *node);
 
@@ -479,4 +493,91 @@ sql_table_append_record_batch(SQLtable *table, ArrowBlock *block)
 
 	return index;
 }
+
+/*
+ * Manifest of the Arrow files
+ *
+ * pcap2arrow --manifest=FILE appends a line for each output file on close,
+ * tab-separated:
+ *   <path> <min timestamp> <max timestamp> <nitems> <bloom bits> <bloom>
+ * The timestamps are microseconds from the Unix epoch, and <bloom> is the
+ * bloom filter in hex, as an array of 64bit words. A line that begins with
+ * '#' declares the columns summarized by the following lines, like:
+ *   # timestamp=timestamp bloom=src_addr,dst_addr,src_port,dst_port
+ * Integer keys are hashed as int64_t, and the others as their raw bytes.
+ */
+#define ARROW_MANIFEST_BLOOM_NHASHES	3
+
+static inline uint64_t
+arrowManifestHash(const char *colname, const void *data, size_t sz)
+{
+	const unsigned char *pos;
+	uint64_t	hash = 14695981039346656037UL;	/* FNV-1a */
+
+	for (pos = (const unsigned char *)colname; ; pos++)
+	{
+		hash = (hash ^ *pos) * 1099511628211UL;
+		if (*pos == '\0')
+			break;
+	}
+	for (pos = data; sz > 0; pos++, sz--)
+		hash = (hash ^ *pos) * 1099511628211UL;
+	return hash;
+}
+
+static inline uint32_t
+arrowManifestBloomBit(uint64_t hash, int k, uint32_t nbits)
+{
+	uint32_t	h1 = (uint32_t)(hash & 0xffffffffU);
+	uint32_t	h2 = (uint32_t)(hash >> 32) | 1U;
+
+	return (h1 + (uint32_t)k * h2) % nbits;
+}
+
+/*
+ * Shared memory segment of the Arrow IPC stream
+ *
+ * A producer publishes the record-batches through a file on tmpfs (like
+ * /dev/shm) named '*.arrowshm', to be scanned by arrow_fdw without any
+ * copies. The segment begins with ArrowShmemHeader on the first
+ * ARROW_SHMEM_HEADER_SZ bytes, then the messages of the Arrow IPC stream
+ * (Schema, then RecordBatches) follow. The producer appends a message,
+ * then advances 'committed' (end of the last complete message) by the
+ * release store, and readers never look at the bytes beyond 'committed',
+ * so no locks are needed. The segment is never updated once it is closed.
+ */
+#define ARROW_SHMEM_SIGNATURE		"ARROWSHM"
+#define ARROW_SHMEM_SIGNATURE_SZ	8
+#define ARROW_SHMEM_VERSION			1
+#define ARROW_SHMEM_HEADER_SZ		4096
+#define ARROW_SHMEM_SUFFIX			"arrowshm"
+#define ARROW_SHMEM_FLAG__CLOSED	0x0001U
+
+typedef struct
+{
+	char		signature[ARROW_SHMEM_SIGNATURE_SZ];
+	uint32_t	version;
+	uint32_t	flags;			/* ARROW_SHMEM_FLAG__* */
+	uint64_t	segment_sz;		/* expected size of the segment, or 0 */
+	uint64_t	committed;		/* end offset of the committed messages */
+	int32_t		producer_pid;
+} ArrowShmemHeader;
+
+static inline uint64_t
+arrowShmemCommitted(const ArrowShmemHeader *shm_head)
+{
+	return __atomic_load_n(&shm_head->committed, __ATOMIC_ACQUIRE);
+}
+
+static inline bool
+arrowShmemIsClosed(const ArrowShmemHeader *shm_head)
+{
+	return (__atomic_load_n(&shm_head->flags, __ATOMIC_ACQUIRE) &
+			ARROW_SHMEM_FLAG__CLOSED) != 0;
+}
+
+extern ArrowShmemHeader *arrowShmemCreateSegment(SQLtable *table,
+												 size_t segment_sz);
+extern void		arrowShmemCommit(ArrowShmemHeader *shm_head, size_t committed);
+extern void		arrowShmemClose(ArrowShmemHeader *shm_head);
 #endif	/* ARROW_IPC_H */
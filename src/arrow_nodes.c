@@ -44,6 +44,8 @@ __dumpArrowNodeSimple(SQLbuffer *buf, ArrowNode *node)
 #define __dumpArrowTypeLargeBinary	__dumpArrowNodeSimple
 #define __dumpArrowTypeLargeUtf8	__dumpArrowNodeSimple
 #define __dumpArrowTypeLargeList	__dumpArrowNodeSimple
+#define __dumpArrowTypeBinaryView	__dumpArrowNodeSimple
+#define __dumpArrowTypeUtf8View		__dumpArrowNodeSimple
 
 static inline const char *
 ArrowPrecisionAsCstring(ArrowPrecision prec)
@@ -416,6 +418,16 @@ __dumpArrowRecordBatch(SQLbuffer *buf, ArrowNode *node)
 			sql_buffer_printf(buf, ", ");
 		__dumpArrowNode(buf, (ArrowNode *)&r->buffers[i]);
 	}
+	if (r->_num_variadicBufferCounts > 0)
+	{
+		sql_buffer_printf(buf, "], variadicBufferCounts=[");
+		for (i=0; i < r->_num_variadicBufferCounts; i++)
+		{
+			if (i > 0)
+				sql_buffer_printf(buf, ", ");
+			sql_buffer_printf(buf, "%ld", r->variadicBufferCounts[i]);
+		}
+	}
 	sql_buffer_printf(buf,"]}");
 }
 
@@ -590,6 +602,8 @@ __copyArrowNode(ArrowNode *dest, const ArrowNode *src)
 #define __copyArrowTypeLargeBinary	__copyArrowNode
 #define __copyArrowTypeLargeUtf8	__copyArrowNode
 #define __copyArrowTypeLargeList	__copyArrowNode
+#define __copyArrowTypeBinaryView	__copyArrowNode
+#define __copyArrowTypeUtf8View		__copyArrowNode
 
 static void
 __copyArrowTypeInt(ArrowTypeInt *dest, const ArrowTypeInt *src)
@@ -776,6 +790,16 @@ __copyArrowRecordBatch(ArrowRecordBatch *dest, const ArrowRecordBatch *src)
 	COPY_SCALAR(length);
 	COPY_VECTOR(nodes, ArrowFieldNode);
 	COPY_VECTOR(buffers, ArrowBuffer);
+	if (src->_num_variadicBufferCounts == 0)
+		dest->variadicBufferCounts = NULL;
+	else
+	{
+		dest->variadicBufferCounts = palloc(sizeof(int64_t) *
+											src->_num_variadicBufferCounts);
+		memcpy(dest->variadicBufferCounts, src->variadicBufferCounts,
+			   sizeof(int64_t) * src->_num_variadicBufferCounts);
+	}
+	COPY_SCALAR(_num_variadicBufferCounts);
 }
 
 static void
@@ -962,6 +986,12 @@ arrowNodeName(ArrowNode *node)
 		case ArrowNodeTag__LargeList:
 			return "Arrow::LargeList";
 
+		case ArrowNodeTag__BinaryView:
+			return "Arrow::BinaryView";
+
+		case ArrowNodeTag__Utf8View:
+			return "Arrow::Utf8View";
+
 		case ArrowNodeTag__KeyValue:
 			return "Arrow::KeyValue";
 
@@ -1163,6 +1193,8 @@ __initArrowNode(ArrowNode *node, ArrowNodeTag tag)
 		CASE_ARROW_TYPE_NODE(LargeBinary);
 		CASE_ARROW_TYPE_NODE(LargeUtf8);
 		CASE_ARROW_TYPE_NODE(LargeList);
+		CASE_ARROW_TYPE_NODE(BinaryView);
+		CASE_ARROW_TYPE_NODE(Utf8View);
 
 		CASE_ARROW_NODE(KeyValue);
 		CASE_ARROW_NODE(DictionaryEncoding);
@@ -1601,6 +1633,12 @@ readArrowType(ArrowType *type, int type_tag, const char *type_pos)
 		case ArrowType__LargeList:
 			INIT_ARROW_TYPE_NODE(type, LargeList);
 			break;
+		case ArrowType__BinaryView:
+			INIT_ARROW_TYPE_NODE(type, BinaryView);
+			break;
+		case ArrowType__Utf8View:
+			INIT_ARROW_TYPE_NODE(type, Utf8View);
+			break;
 		default:
 			printf("no suitable ArrowType__* tag for the code = %d", type_tag);
 			break;
@@ -1825,6 +1863,16 @@ readArrowRecordBatch(ArrowRecordBatch *rbatch, const char *pos)
 		rbatch->compression = palloc0(sizeof(ArrowBodyCompression));
 		readArrowBodyCompression(rbatch->compression, next);
 	}
+
+	/* (optional) variadicBufferCounts: [long] */
+	next = (const char *)fetchVector(&t, 4, &nitems);
+	if (nitems > 0)
+	{
+		rbatch->variadicBufferCounts = palloc0(sizeof(int64_t) * nitems);
+		for (i=0; i < nitems; i++)
+			rbatch->variadicBufferCounts[i] = ((const int64_t *)next)[i];
+	}
+	rbatch->_num_variadicBufferCounts = nitems;
 }
 
 static void
@@ -1959,6 +2007,147 @@ readArrowFooter(ArrowFooter *node, const char *pos)
 	}
 #endif
 
+/*
+ * readArrowStreamMessage - read a message of the Arrow IPC streaming format
+ *
+ * It returns the length of the whole message including the body, 0 if the
+ * buffer does not have the whole message yet, or -1 on the end-of-stream
+ * marker. *p_meta_sz is the length of the metadata including its prefix,
+ * like ArrowBlock->metaDataLength.
+ */
+ssize_t
+readArrowStreamMessage(const char *buf, size_t buf_sz,
+					   ArrowMessage *message, int32_t *p_meta_sz)
+{
+	const int32_t  *ival = (const int32_t *)buf;
+	const int32_t  *headOffset;
+	int32_t			metaLength;
+	size_t			prefix_sz;
+	size_t			total_sz;
+
+	if (buf_sz < sizeof(int32_t))
+		return 0;
+	if (*ival == 0xffffffff)
+	{
+		if (buf_sz < 2 * sizeof(int32_t))
+			return 0;
+		metaLength = ival[1];
+		prefix_sz = 2 * sizeof(int32_t);
+	}
+	else
+	{
+		/* Older format prior to Arrow v0.15 */
+		metaLength = ival[0];
+		prefix_sz = sizeof(int32_t);
+	}
+	if (metaLength == 0)
+		return -1;		/* end-of-stream */
+	if (metaLength < 0)
+		Elog("corrupted metadata length (%d) in Arrow IPC stream", metaLength);
+	if (buf_sz < prefix_sz + metaLength)
+		return 0;
+	headOffset = (const int32_t *)(buf + prefix_sz);
+	readArrowMessage(message, (const char *)headOffset + *headOffset);
+	total_sz = prefix_sz + metaLength + message->bodyLength;
+	if (buf_sz < total_sz)
+		return 0;
+	if (p_meta_sz)
+		*p_meta_sz = prefix_sz + metaLength;
+	return total_sz;
+}
+
+/*
+ * __readArrowStreamFileDesc
+ *
+ * A file in the Arrow IPC streaming format has no footer, so it walks on
+ * the messages from the head, then builds an equivalent footer. Incomplete
+ * message at the tail (may be under writing) is ignored.
+ * The messages are in [base, file_sz), and the offset of the blocks are
+ * still relative to the head of the file.
+ */
+static void *
+__repallocArrowArray(void *ptr, size_t unitsz, int nrooms)
+{
+	if (!ptr)
+		return palloc(unitsz * nrooms);
+	return repalloc(ptr, unitsz * nrooms);
+}
+
+static void
+__readArrowStreamFileDesc(const char *mmap_head, size_t base, size_t file_sz,
+						  ArrowFileInfo *af_info)
+{
+	ArrowFooter	   *footer = &af_info->footer;
+	ArrowMessage	message;
+	size_t			offset = base;
+	ssize_t			length;
+	int32_t			meta_sz;
+	int				nrooms_rb = 0;
+	int				nrooms_dict = 0;
+
+	if (base >= file_sz)
+		Elog("Arrow IPC stream has no Schema message");
+	length = readArrowStreamMessage(mmap_head + base, file_sz - base,
+									&message, &meta_sz);
+	if (length <= 0 || !ArrowNodeIs(&message.body, Schema))
+		Elog("Arrow IPC stream must begin with a Schema message");
+	INIT_ARROW_NODE(footer, Footer);
+	footer->version = message.version;
+	memcpy(&footer->schema, &message.body.schema, sizeof(ArrowSchema));
+	offset += length;
+
+	while (offset < file_sz)
+	{
+		ArrowBlock	   *b;
+
+		length = readArrowStreamMessage(mmap_head + offset,
+										file_sz - offset,
+										&message, &meta_sz);
+		if (length <= 0)
+			break;	/* end-of-stream, or incomplete message */
+		if (ArrowNodeIs(&message.body, RecordBatch))
+		{
+			if (footer->_num_recordBatches >= nrooms_rb)
+			{
+				nrooms_rb = 2 * nrooms_rb + 20;
+				footer->recordBatches = __repallocArrowArray(footer->recordBatches,
+															 sizeof(ArrowBlock),
+															 nrooms_rb);
+				af_info->recordBatches = __repallocArrowArray(af_info->recordBatches,
+															  sizeof(ArrowMessage),
+															  nrooms_rb);
+			}
+			b = &footer->recordBatches[footer->_num_recordBatches];
+			memcpy(&af_info->recordBatches[footer->_num_recordBatches++],
+				   &message, sizeof(ArrowMessage));
+		}
+		else if (ArrowNodeIs(&message.body, DictionaryBatch))
+		{
+			if (footer->_num_dictionaries >= nrooms_dict)
+			{
+				nrooms_dict = 2 * nrooms_dict + 20;
+				footer->dictionaries = __repallocArrowArray(footer->dictionaries,
+															sizeof(ArrowBlock),
+															nrooms_dict);
+				af_info->dictionaries = __repallocArrowArray(af_info->dictionaries,
+															 sizeof(ArrowMessage),
+															 nrooms_dict);
+			}
+			b = &footer->dictionaries[footer->_num_dictionaries];
+			memcpy(&af_info->dictionaries[footer->_num_dictionaries++],
+				   &message, sizeof(ArrowMessage));
+		}
+		else
+			Elog("Arrow IPC stream has unexpected %s message",
+				 arrowNodeName(&message.body.node));
+		INIT_ARROW_NODE(b, Block);
+		b->offset = offset;
+		b->metaDataLength = meta_sz;
+		b->bodyLength = message.bodyLength;
+		offset += length;
+	}
+}
+
 void
 readArrowFileDesc(int fdesc, ArrowFileInfo *af_info)
 {
@@ -1986,6 +2175,31 @@ readArrowFileDesc(int fdesc, ArrowFileInfo *af_info)
 	/* check signature */
 	PG_TRY();
 	{
+		if (file_sz >= sizeof(int32_t) &&
+			*((int32_t *)mmap_head) == 0xffffffff)
+		{
+			/* Arrow IPC streaming format, begins with the continuation token */
+			__readArrowStreamFileDesc(mmap_head, 0, file_sz, af_info);
+			goto out;
+		}
+		if (file_sz >= ARROW_SHMEM_HEADER_SZ &&
+			memcmp(mmap_head,
+				   ARROW_SHMEM_SIGNATURE,
+				   ARROW_SHMEM_SIGNATURE_SZ) == 0)
+		{
+			/* shared memory segment; only committed messages are valid */
+			const ArrowShmemHeader *shm_head = (const ArrowShmemHeader *)mmap_head;
+			uint64_t	committed = arrowShmemCommitted(shm_head);
+
+			if (shm_head->version != ARROW_SHMEM_VERSION)
+				Elog("unsupported version (%u) of Arrow shared memory segment",
+					 shm_head->version);
+			if (committed > file_sz)
+				committed = file_sz;
+			__readArrowStreamFileDesc(mmap_head, ARROW_SHMEM_HEADER_SZ,
+									  committed, af_info);
+			goto out;
+		}
 		if (memcmp(mmap_head,
 				   ARROW_FILE_HEAD_SIGNATURE,
 				   ARROW_FILE_HEAD_SIGNATURE_SZ) != 0 ||
@@ -2060,6 +2274,7 @@ readArrowFileDesc(int fdesc, ArrowFileInfo *af_info)
 				readArrowMessage(m, pos);
 			}
 		}
+	out:
 		munmap(mmap_head, mmap_sz);
 	}
 	PG_FINALLY();
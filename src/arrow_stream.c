@@ -0,0 +1,1115 @@
+/*
+ * arrow_stream.c
+ *
+ * Receiver of the Arrow IPC streaming format for arrow_fdw.
+ *
+ * A foreign table with the 'stream' option scans the record-batches that
+ * have been received from a FIFO or a socket so far. The background worker
+ * receives the messages, then writes them out on the spool segments; each
+ * of them is a valid file of the Arrow IPC streaming format that begins
+ * with the Schema message. Segments are rotated for each
+ * (arrow_fdw.stream_buffer_size / ARROW_STREAM_NSEGMENTS) bytes and the
+ * oldest one is removed, so the spool works as a bounded ring buffer.
+ * Put arrow_fdw.stream_spool_dir on tmpfs to keep it in-memory.
+ *
+ * The 'shm:' source is a directory of the shared memory segments (see
+ * ArrowShmemHeader in arrow_ipc.h) that producers write directly. Queries
+ * scan the segments on the memory as is, and the background worker copies
+ * the committed messages into the spool files asynchronously; once the
+ * segment is closed and spooled, it may be removed from the shared memory
+ * to keep arrow_fdw.stream_buffer_size, then the spool file is scanned
+ * instead. The spool files of the 'shm:' source are never removed.
+ * ----
+ * Copyright 2011-2023 (C) KaiGai Kohei <kaigai@kaigai.gr.jp>
+ * Copyright 2014-2023 (C) PG-Strom Developers Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the PostgreSQL License.
+ */
+#include "pg_strom.h"
+#include <dirent.h>
+#include <netdb.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "arrow_ipc.h"
+
+#define ARROW_STREAM_NAPTIME			100		/* 100ms */
+#define ARROW_STREAM_NSEGMENTS			8
+#define ARROW_STREAM_SEGMENT_SUFFIX		"arrows"
+#define ARROW_STREAM_STATUS__FREE		0
+#define ARROW_STREAM_STATUS__REQUESTED	1
+#define ARROW_STREAM_STATUS__RECEIVING	2
+#define ARROW_STREAM_STATUS__FAILED		3
+#define ARROW_STREAM_SOURCE__FIFO		1
+#define ARROW_STREAM_SOURCE__UNIX		2
+#define ARROW_STREAM_SOURCE__TCP		3
+#define ARROW_STREAM_SOURCE__SHMEM		4
+
+typedef struct
+{
+	int			status;			/* one of ARROW_STREAM_STATUS__* */
+	uint64_t	nbatches;		/* number of record-batches received */
+	char		source[MAXPGPATH];
+} arrowStreamSlot;
+
+typedef struct
+{
+	slock_t		lock;
+	Latch	   *worker_latch;
+	int			nslots;
+	arrowStreamSlot slots[FLEXIBLE_ARRAY_MEMBER];
+} arrowStreamHead;
+
+/*
+ * arrowStreamReceiver - worker local state for each slot
+ */
+typedef struct
+{
+	bool		active;
+	int			kind;			/* one of ARROW_STREAM_SOURCE__* */
+	int			listen_fd;		/* socket to accept, or -1 */
+	int			conn_fd;		/* FIFO or connected socket, or -1 */
+	int			dummy_fd;		/* writer side of FIFO to avoid EOF */
+	char	   *buffer;			/* receive buffer */
+	size_t		buffer_len;
+	size_t		buffer_sz;
+	char	   *schema;			/* the last Schema message */
+	size_t		schema_len;
+	int			seg_fd;			/* current spool segment, or -1 */
+	size_t		seg_len;
+	uint64_t	seg_id;
+	char		spool_dir[MAXPGPATH];
+	char		shm_dir[MAXPGPATH];	/* for 'shm:' */
+} arrowStreamReceiver;
+
+/*
+ * arrowStreamShmemSeg - shared memory segment of 'shm:' source
+ */
+typedef struct
+{
+	char	   *name;
+	size_t		length;
+	struct timespec mtime;
+	bool		evictable;		/* closed and already spooled */
+} arrowStreamShmemSeg;
+
+/* static variables */
+static shmem_request_hook_type shmem_request_next = NULL;
+static shmem_startup_hook_type shmem_startup_next = NULL;
+static arrowStreamHead *arrow_stream_head = NULL;
+static int		arrow_stream_max_sources;		/* GUC */
+static int		arrow_stream_buffer_size_mb;	/* GUC */
+static char	   *arrow_stream_spool_dir = NULL;	/* GUC */
+static MemoryContext arrow_stream_memcxt = NULL;	/* per message */
+void	arrowFdwStreamWorkerMain(Datum arg);
+
+/*
+ * __arrowStreamParseSource
+ *
+ * 'fifo:<path>', 'unix:<path>', 'tcp:[<host>]:<port>' or 'shm:<dir>'
+ */
+static int
+__arrowStreamParseSource(const char *source, char **p_addr, char **p_port)
+{
+	const char *pos;
+
+	if (strncmp(source, "fifo:", 5) == 0 ||
+		strncmp(source, "unix:", 5) == 0)
+	{
+		if (source[5] != '/')
+			elog(ERROR, "arrow_fdw: stream '%s' must be absolute path", source);
+		if (strlen(source + 5) >= sizeof(((struct sockaddr_un *)0)->sun_path))
+			elog(ERROR, "arrow_fdw: stream '%s' is too long", source);
+		if (p_addr)
+			*p_addr = pstrdup(source + 5);
+		return (source[0] == 'f'
+				? ARROW_STREAM_SOURCE__FIFO
+				: ARROW_STREAM_SOURCE__UNIX);
+	}
+	if (strncmp(source, "tcp:", 4) == 0)
+	{
+		pos = strrchr(source + 4, ':');
+		if (!pos || pos[1] == '\0' || strspn(pos + 1, "0123456789") != strlen(pos + 1))
+			elog(ERROR, "arrow_fdw: stream '%s' must be 'tcp:[<host>]:<port>'", source);
+		if (p_addr)
+			*p_addr = (pos > source + 4
+					   ? pnstrdup(source + 4, pos - (source + 4))
+					   : NULL);
+		if (p_port)
+			*p_port = pstrdup(pos + 1);
+		return ARROW_STREAM_SOURCE__TCP;
+	}
+	if (strncmp(source, "shm:", 4) == 0)
+	{
+		if (source[4] != '/')
+			elog(ERROR, "arrow_fdw: stream '%s' must be absolute path", source);
+		if (p_addr)
+			*p_addr = pstrdup(source + 4);
+		return ARROW_STREAM_SOURCE__SHMEM;
+	}
+	if (strncmp(source, "kafka:", 6) == 0)
+		elog(ERROR, "arrow_fdw: Kafka is not supported as stream source, bridge the topic to 'fifo:' or 'tcp:' (e.g. kcat -C)");
+	elog(ERROR, "arrow_fdw: unknown stream source '%s'", source);
+}
+
+static void
+__arrowStreamSpoolDir(char *spool_dir, const char *source)
+{
+	snprintf(spool_dir, MAXPGPATH, "%s/%08x",
+			 arrow_stream_spool_dir,
+			 hash_bytes((const unsigned char *)source, strlen(source)));
+}
+
+/*
+ * pgstromArrowStreamSpoolDir
+ *
+ * It returns the spool directory of the stream source, and requests the
+ * background worker to receive the stream if not yet.
+ */
+const char *
+pgstromArrowStreamSpoolDir(const char *source)
+{
+	char	   *spool_dir = palloc(MAXPGPATH);
+	Latch	   *latch;
+	int			free_id = -1;
+	bool		found = false;
+	bool		wakeup = false;
+
+	(void) __arrowStreamParseSource(source, NULL, NULL);
+	if (!arrow_stream_head)
+		elog(ERROR, "arrow_fdw: stream receiver is disabled (arrow_fdw.stream_max_sources = 0)");
+	if (strlen(source) >= MAXPGPATH)
+		elog(ERROR, "arrow_fdw: stream '%s' is too long", source);
+
+	SpinLockAcquire(&arrow_stream_head->lock);
+	for (int i=0; i < arrow_stream_head->nslots; i++)
+	{
+		arrowStreamSlot *slot = &arrow_stream_head->slots[i];
+
+		if (slot->status == ARROW_STREAM_STATUS__FREE)
+		{
+			if (free_id < 0)
+				free_id = i;
+		}
+		else if (strcmp(slot->source, source) == 0)
+		{
+			/* retry the source once failed */
+			if (slot->status == ARROW_STREAM_STATUS__FAILED)
+			{
+				slot->status = ARROW_STREAM_STATUS__REQUESTED;
+				wakeup = true;
+			}
+			found = true;
+			break;
+		}
+	}
+	if (!found)
+	{
+		if (free_id < 0)
+		{
+			SpinLockRelease(&arrow_stream_head->lock);
+			elog(ERROR, "arrow_fdw: too many stream sources (arrow_fdw.stream_max_sources = %d)",
+				 arrow_stream_max_sources);
+		}
+		else
+		{
+			arrowStreamSlot *slot = &arrow_stream_head->slots[free_id];
+
+			slot->status = ARROW_STREAM_STATUS__REQUESTED;
+			slot->nbatches = 0;
+			strcpy(slot->source, source);
+			wakeup = true;
+		}
+	}
+	latch = arrow_stream_head->worker_latch;
+	SpinLockRelease(&arrow_stream_head->lock);
+	if (wakeup && latch)
+		SetLatch(latch);
+
+	__arrowStreamSpoolDir(spool_dir, source);
+	if (pg_mkdir_p(spool_dir, pg_dir_create_mode) != 0 && errno != EEXIST)
+		elog(ERROR, "arrow_fdw: could not create directory '%s': %m", spool_dir);
+	return spool_dir;
+}
+
+/*
+ * __arrowStreamSegmentNames
+ *
+ * It returns the names of the files with the suffix, without the suffix.
+ */
+static List *
+__arrowStreamSegmentNames(const char *dir_path, const char *suffix)
+{
+	List	   *names = NIL;
+	DIR		   *dir;
+	struct dirent *dentry;
+
+	dir = AllocateDir(dir_path);
+	if (!dir)
+		return NIL;
+	while ((dentry = ReadDir(dir, dir_path)) != NULL)
+	{
+		const char *pos = strrchr(dentry->d_name, '.');
+
+		if (!pos || strcmp(pos+1, suffix) != 0)
+			continue;
+		names = lappend(names, pnstrdup(dentry->d_name,
+										pos - dentry->d_name));
+	}
+	FreeDir(dir);
+
+	return names;
+}
+
+/*
+ * pgstromArrowStreamShmemFiles
+ *
+ * It appends the segments of the 'shm:' source to the filesList. Segments
+ * still on the shared memory are scanned from the memory, and the spooled
+ * copies are scanned only if the segment has been already removed.
+ */
+List *
+pgstromArrowStreamShmemFiles(List *filesList,
+							 const char *source,
+							 const char *spool_dir)
+{
+	char	   *shm_dir;
+	List	   *shm_names;
+	List	   *spool_names;
+	ListCell   *lc;
+
+	if (__arrowStreamParseSource(source, &shm_dir, NULL) != ARROW_STREAM_SOURCE__SHMEM)
+		elog(ERROR, "Bug? stream '%s' is not shared memory segments", source);
+	shm_names = __arrowStreamSegmentNames(shm_dir, ARROW_SHMEM_SUFFIX);
+	spool_names = __arrowStreamSegmentNames(spool_dir, ARROW_STREAM_SEGMENT_SUFFIX);
+	foreach (lc, spool_names)
+	{
+		char   *name = lfirst(lc);
+		ListCell *cell;
+
+		foreach (cell, shm_names)
+		{
+			if (strcmp(name, lfirst(cell)) == 0)
+				break;
+		}
+		if (!cell)
+			filesList = lappend(filesList,
+								makeString(psprintf("%s/%s.%s", spool_dir, name,
+													ARROW_STREAM_SEGMENT_SUFFIX)));
+	}
+	foreach (lc, shm_names)
+	{
+		char   *name = lfirst(lc);
+
+		filesList = lappend(filesList,
+							makeString(psprintf("%s/%s.%s", shm_dir, name,
+												ARROW_SHMEM_SUFFIX)));
+	}
+	return filesList;
+}
+
+/*
+ * routines for the stream receiver worker
+ */
+static void
+__arrowStreamSetStatus(int slot_id, int status)
+{
+	arrowStreamSlot *slot = &arrow_stream_head->slots[slot_id];
+
+	SpinLockAcquire(&arrow_stream_head->lock);
+	if (slot->status != ARROW_STREAM_STATUS__FREE)
+		slot->status = status;
+	SpinLockRelease(&arrow_stream_head->lock);
+}
+
+static void
+__arrowStreamCloseSegment(arrowStreamReceiver *recv)
+{
+	if (recv->seg_fd >= 0)
+		close(recv->seg_fd);
+	recv->seg_fd = -1;
+	recv->seg_len = 0;
+}
+
+static void
+__arrowStreamResetConnection(arrowStreamReceiver *recv)
+{
+	if (recv->kind != ARROW_STREAM_SOURCE__FIFO && recv->conn_fd >= 0)
+	{
+		close(recv->conn_fd);
+		recv->conn_fd = -1;
+	}
+	/* incomplete message is discarded, and the next stream begins with its schema */
+	recv->buffer_len = 0;
+	if (recv->schema)
+		pfree(recv->schema);
+	recv->schema = NULL;
+	recv->schema_len = 0;
+	__arrowStreamCloseSegment(recv);
+}
+
+static void
+__arrowStreamWriteAll(int fdesc, const char *buf, size_t len, const char *fname)
+{
+	while (len > 0)
+	{
+		ssize_t	nbytes = write(fdesc, buf, len);
+
+		if (nbytes < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			elog(ERROR, "failed on write('%s'): %m", fname);
+		}
+		buf += nbytes;
+		len -= nbytes;
+	}
+}
+
+static int
+__arrowStreamCompareNames(const void *__a, const void *__b)
+{
+	return strcmp(*((char * const *)__a), *((char * const *)__b));
+}
+
+/*
+ * __arrowStreamEvictSegments - removes the oldest segments out of the ring
+ */
+static void
+__arrowStreamEvictSegments(arrowStreamReceiver *recv)
+{
+	DIR		   *dir;
+	struct dirent *dentry;
+	char	  **names;
+	int			nitems = 0;
+	int			nrooms = 2 * ARROW_STREAM_NSEGMENTS;
+
+	dir = AllocateDir(recv->spool_dir);
+	if (!dir)
+		return;
+	names = palloc(sizeof(char *) * nrooms);
+	while ((dentry = ReadDir(dir, recv->spool_dir)) != NULL)
+	{
+		const char *pos = strrchr(dentry->d_name, '.');
+
+		if (!pos || strcmp(pos+1, ARROW_STREAM_SEGMENT_SUFFIX) != 0)
+			continue;
+		if (nitems >= nrooms)
+		{
+			nrooms += nrooms;
+			names = repalloc(names, sizeof(char *) * nrooms);
+		}
+		names[nitems++] = pstrdup(dentry->d_name);
+	}
+	FreeDir(dir);
+
+	/* segment names are zero-padded sequential numbers */
+	qsort(names, nitems, sizeof(char *), __arrowStreamCompareNames);
+	for (int i=0; i < nitems - ARROW_STREAM_NSEGMENTS; i++)
+	{
+		char	path[MAXPGPATH];
+
+		snprintf(path, MAXPGPATH, "%s/%s", recv->spool_dir, names[i]);
+		if (unlink(path) != 0 && errno != ENOENT)
+			elog(LOG, "arrow_fdw: failed on unlink('%s'): %m", path);
+	}
+}
+
+/*
+ * __arrowStreamOpenSegment
+ *
+ * It creates a new spool segment with the last Schema message; the segment
+ * becomes visible by rename(2) only after the schema is written.
+ */
+static void
+__arrowStreamOpenSegment(arrowStreamReceiver *recv)
+{
+	char		tmp_path[MAXPGPATH];
+	char		seg_path[MAXPGPATH];
+	uint64_t	seg_id = (uint64_t) GetCurrentTimestamp();
+
+	__arrowStreamCloseSegment(recv);
+	recv->seg_id = Max(recv->seg_id + 1, seg_id);
+	snprintf(tmp_path, MAXPGPATH, "%s/%016lx.tmp",
+			 recv->spool_dir, recv->seg_id);
+	snprintf(seg_path, MAXPGPATH, "%s/%016lx.%s",
+			 recv->spool_dir, recv->seg_id, ARROW_STREAM_SEGMENT_SUFFIX);
+	recv->seg_fd = open(tmp_path, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC,
+						pg_file_create_mode);
+	if (recv->seg_fd < 0)
+		elog(ERROR, "failed on open('%s'): %m", tmp_path);
+	__arrowStreamWriteAll(recv->seg_fd, recv->schema, recv->schema_len, tmp_path);
+	if (rename(tmp_path, seg_path) != 0)
+		elog(ERROR, "failed on rename('%s' -> '%s'): %m", tmp_path, seg_path);
+	recv->seg_len = recv->schema_len;
+
+	__arrowStreamEvictSegments(recv);
+}
+
+/*
+ * __arrowStreamProcessBuffer - writes out the received messages
+ */
+static void
+__arrowStreamProcessBuffer(int slot_id, arrowStreamReceiver *recv)
+{
+	size_t		seg_limit = ((size_t)arrow_stream_buffer_size_mb << 20) / ARROW_STREAM_NSEGMENTS;
+	size_t		pos = 0;
+
+	while (pos < recv->buffer_len)
+	{
+		const char *curr = recv->buffer + pos;
+		ArrowMessage message;
+		ssize_t		length;
+		int32_t		meta_sz;
+
+		length = readArrowStreamMessage(curr, recv->buffer_len - pos,
+										&message, &meta_sz);
+		if (length == 0)
+			break;		/* incomplete message */
+		if (length < 0)
+		{
+			/* end-of-stream; the next stream shall begin with Schema */
+			pos += (*((int32_t *)curr) == 0xffffffff ? 8 : 4);
+			if (recv->schema)
+				pfree(recv->schema);
+			recv->schema = NULL;
+			recv->schema_len = 0;
+			__arrowStreamCloseSegment(recv);
+			continue;
+		}
+		if (length > seg_limit)
+			elog(ERROR, "arrow_fdw: message (%zu bytes) is larger than the spool segment", length);
+
+		if (ArrowNodeIs(&message.body, Schema))
+		{
+			if (recv->schema)
+				pfree(recv->schema);
+			recv->schema = MemoryContextAlloc(TopMemoryContext, length);
+			memcpy(recv->schema, curr, length);
+			recv->schema_len = length;
+			/* the next record-batch opens a new segment */
+			__arrowStreamCloseSegment(recv);
+		}
+		else if (ArrowNodeIs(&message.body, RecordBatch))
+		{
+			if (!recv->schema)
+				elog(ERROR, "arrow_fdw: RecordBatch message arrived prior to Schema");
+			if (recv->seg_fd < 0 || recv->seg_len + length > seg_limit)
+				__arrowStreamOpenSegment(recv);
+			__arrowStreamWriteAll(recv->seg_fd, curr, length, recv->spool_dir);
+			recv->seg_len += length;
+
+			SpinLockAcquire(&arrow_stream_head->lock);
+			arrow_stream_head->slots[slot_id].nbatches++;
+			SpinLockRelease(&arrow_stream_head->lock);
+		}
+		else
+		{
+			elog(ERROR, "arrow_fdw: %s message is not supported on stream",
+				 arrowNodeName(&message.body.node));
+		}
+		pos += length;
+	}
+	if (recv->buffer_len - pos > seg_limit)
+		elog(ERROR, "arrow_fdw: message is larger than the spool segment");
+	/* remaining fraction */
+	if (pos > 0)
+	{
+		memmove(recv->buffer, recv->buffer + pos, recv->buffer_len - pos);
+		recv->buffer_len -= pos;
+	}
+}
+
+/*
+ * __arrowStreamSpoolShmemOne
+ *
+ * It copies the messages newly committed on the segment into the spool
+ * file, and returns true if the segment is valid. The spool file is the
+ * segment without the header, so it is a valid Arrow IPC stream, and its
+ * length tells how much of the segment is already spooled.
+ */
+static bool
+__arrowStreamSpoolShmemOne(arrowStreamReceiver *recv, arrowStreamShmemSeg *seg)
+{
+	char		shm_path[MAXPGPATH];
+	char		spool_path[MAXPGPATH];
+	ArrowShmemHeader shm_head;
+	struct stat	stat_buf;
+	int			shm_fd;
+	int			spool_fd = -1;
+	size_t		committed;
+	size_t		offset;
+	bool		closed;
+	bool		retval = false;
+
+	snprintf(shm_path, MAXPGPATH, "%s/%s.%s",
+			 recv->shm_dir, seg->name, ARROW_SHMEM_SUFFIX);
+	snprintf(spool_path, MAXPGPATH, "%s/%s.%s",
+			 recv->spool_dir, seg->name, ARROW_STREAM_SEGMENT_SUFFIX);
+	shm_fd = open(shm_path, O_RDONLY | O_CLOEXEC);
+	if (shm_fd < 0)
+		return false;	/* removed concurrently */
+	if (fstat(shm_fd, &stat_buf) != 0 ||
+		pread(shm_fd, &shm_head, sizeof(ArrowShmemHeader), 0) != sizeof(ArrowShmemHeader) ||
+		memcmp(shm_head.signature,
+			   ARROW_SHMEM_SIGNATURE,
+			   ARROW_SHMEM_SIGNATURE_SZ) != 0 ||
+		shm_head.committed <= ARROW_SHMEM_HEADER_SZ)
+		goto out;		/* not ready yet */
+	/* the segment of the producer crashed is never updated also */
+	closed = ((shm_head.flags & ARROW_SHMEM_FLAG__CLOSED) != 0 ||
+			  (kill(shm_head.producer_pid, 0) != 0 && errno == ESRCH));
+	committed = Min(shm_head.committed, stat_buf.st_size);
+	seg->length = stat_buf.st_size;
+	seg->mtime = stat_buf.st_mtim;
+	retval = true;
+
+	spool_fd = open(spool_path, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC,
+					pg_file_create_mode);
+	if (spool_fd < 0 || fstat(spool_fd, &stat_buf) != 0)
+	{
+		elog(LOG, "arrow_fdw: failed on open('%s'): %m", spool_path);
+		goto out;
+	}
+	offset = ARROW_SHMEM_HEADER_SZ + stat_buf.st_size;
+	if (offset > committed)
+	{
+		elog(LOG, "arrow_fdw: spool file '%s' is longer than the segment", spool_path);
+		goto out;
+	}
+	if (offset < committed)
+	{
+		while (offset < committed)
+		{
+			ssize_t	nbytes = pread(shm_fd, recv->buffer,
+								   Min(recv->buffer_sz, committed - offset),
+								   offset);
+			char   *pos = recv->buffer;
+
+			if (nbytes <= 0)
+			{
+				if (nbytes < 0 && errno == EINTR)
+					continue;
+				elog(LOG, "arrow_fdw: failed on pread('%s'): %m", shm_path);
+				goto out;
+			}
+			offset += nbytes;
+			while (nbytes > 0)
+			{
+				ssize_t	rv = write(spool_fd, pos, nbytes);
+
+				if (rv < 0)
+				{
+					if (errno == EINTR)
+						continue;
+					elog(LOG, "arrow_fdw: failed on write('%s'): %m", spool_path);
+					goto out;
+				}
+				pos += rv;
+				nbytes -= rv;
+			}
+		}
+		if (pg_fdatasync(spool_fd) != 0)
+		{
+			elog(LOG, "arrow_fdw: failed on fdatasync('%s'): %m", spool_path);
+			goto out;
+		}
+	}
+	seg->evictable = (closed && offset == committed);
+out:
+	if (spool_fd >= 0)
+		close(spool_fd);
+	close(shm_fd);
+	return retval;
+}
+
+static int
+__arrowStreamCompareShmemSegs(const void *__a, const void *__b)
+{
+	const arrowStreamShmemSeg *a = __a;
+	const arrowStreamShmemSeg *b = __b;
+
+	if (a->mtime.tv_sec != b->mtime.tv_sec)
+		return (a->mtime.tv_sec < b->mtime.tv_sec ? -1 : 1);
+	if (a->mtime.tv_nsec != b->mtime.tv_nsec)
+		return (a->mtime.tv_nsec < b->mtime.tv_nsec ? -1 : 1);
+	return strcmp(a->name, b->name);
+}
+
+/*
+ * __arrowStreamSpoolShmem
+ *
+ * It spools the segments of the 'shm:' source, then removes the older
+ * segments already spooled out of the shared memory, if they consume
+ * more than arrow_fdw.stream_buffer_size.
+ */
+static void
+__arrowStreamSpoolShmem(arrowStreamReceiver *recv)
+{
+	size_t		limit = ((size_t)arrow_stream_buffer_size_mb << 20);
+	size_t		total_sz = 0;
+	List	   *names;
+	arrowStreamShmemSeg *segs;
+	int			nitems = 0;
+	MemoryContext memcxt;
+	ListCell   *lc;
+
+	memcxt = MemoryContextSwitchTo(arrow_stream_memcxt);
+	names = __arrowStreamSegmentNames(recv->shm_dir, ARROW_SHMEM_SUFFIX);
+	segs = palloc0(sizeof(arrowStreamShmemSeg) * (list_length(names) + 1));
+	foreach (lc, names)
+	{
+		arrowStreamShmemSeg *seg = &segs[nitems];
+
+		seg->name = lfirst(lc);
+		if (__arrowStreamSpoolShmemOne(recv, seg))
+		{
+			total_sz += seg->length;
+			nitems++;
+		}
+	}
+	qsort(segs, nitems, sizeof(arrowStreamShmemSeg),
+		  __arrowStreamCompareShmemSegs);
+	for (int i=0; i < nitems && total_sz > limit; i++)
+	{
+		char	path[MAXPGPATH];
+
+		if (!segs[i].evictable)
+			continue;
+		snprintf(path, MAXPGPATH, "%s/%s.%s",
+				 recv->shm_dir, segs[i].name, ARROW_SHMEM_SUFFIX);
+		if (unlink(path) != 0 && errno != ENOENT)
+			elog(LOG, "arrow_fdw: failed on unlink('%s'): %m", path);
+		total_sz -= segs[i].length;
+	}
+	MemoryContextSwitchTo(memcxt);
+	MemoryContextReset(arrow_stream_memcxt);
+}
+
+/*
+ * __arrowStreamReceive - reads the connection, then process the messages
+ */
+static void
+__arrowStreamReceive(int slot_id, arrowStreamReceiver *recv)
+{
+	MemoryContext	memcxt = CurrentMemoryContext;
+	ssize_t			nbytes;
+
+	if (recv->buffer_len == recv->buffer_sz)
+	{
+		recv->buffer_sz = Max(2 * recv->buffer_sz, 1UL << 20);
+		recv->buffer = repalloc_huge(recv->buffer, recv->buffer_sz);
+	}
+	nbytes = read(recv->conn_fd,
+				  recv->buffer + recv->buffer_len,
+				  recv->buffer_sz - recv->buffer_len);
+	if (nbytes < 0)
+	{
+		if (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK)
+			return;
+		elog(LOG, "arrow_fdw: failed on read from stream '%s': %m",
+			 arrow_stream_head->slots[slot_id].source);
+		__arrowStreamResetConnection(recv);
+		return;
+	}
+	if (nbytes == 0)
+	{
+		/* peer closed the connection */
+		__arrowStreamResetConnection(recv);
+		return;
+	}
+	recv->buffer_len += nbytes;
+
+	PG_TRY();
+	{
+		MemoryContextSwitchTo(arrow_stream_memcxt);
+		__arrowStreamProcessBuffer(slot_id, recv);
+		MemoryContextSwitchTo(memcxt);
+	}
+	PG_CATCH();
+	{
+		/* broken stream drops the connection, but the worker continues */
+		MemoryContextSwitchTo(memcxt);
+		EmitErrorReport();
+		FlushErrorState();
+		__arrowStreamResetConnection(recv);
+	}
+	PG_END_TRY();
+	MemoryContextReset(arrow_stream_memcxt);
+}
+
+static void
+__arrowStreamAccept(int slot_id, arrowStreamReceiver *recv)
+{
+	int		fdesc = accept4(recv->listen_fd, NULL, NULL,
+							SOCK_NONBLOCK | SOCK_CLOEXEC);
+	if (fdesc < 0)
+	{
+		if (errno != EINTR && errno != EAGAIN && errno != EWOULDBLOCK)
+			elog(LOG, "arrow_fdw: failed on accept at stream '%s': %m",
+				 arrow_stream_head->slots[slot_id].source);
+		return;
+	}
+	/* one producer at a time, others wait in the backlog */
+	__arrowStreamResetConnection(recv);
+	recv->conn_fd = fdesc;
+}
+
+/*
+ * __arrowStreamOpenSource
+ */
+static bool
+__arrowStreamOpenSource(arrowStreamReceiver *recv, const char *source)
+{
+	char	   *addr = NULL;
+	char	   *port = NULL;
+	int			fdesc = -1;
+
+	recv->kind = __arrowStreamParseSource(source, &addr, &port);
+	if (recv->kind == ARROW_STREAM_SOURCE__SHMEM)
+	{
+		struct stat	stat_buf;
+
+		/* segments are created by the producers */
+		if (stat(addr, &stat_buf) != 0 || !S_ISDIR(stat_buf.st_mode))
+		{
+			elog(LOG, "arrow_fdw: '%s' is not a directory: %m", addr);
+			return false;
+		}
+		strlcpy(recv->shm_dir, addr, MAXPGPATH);
+	}
+	else if (recv->kind == ARROW_STREAM_SOURCE__FIFO)
+	{
+		if (mkfifo(addr, 0600) != 0 && errno != EEXIST)
+		{
+			elog(LOG, "arrow_fdw: failed on mkfifo('%s'): %m", addr);
+			return false;
+		}
+		recv->conn_fd = open(addr, O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+		if (recv->conn_fd < 0)
+		{
+			elog(LOG, "arrow_fdw: failed on open('%s'): %m", addr);
+			return false;
+		}
+		/* holds the writer side to avoid EOF when producers are gone */
+		recv->dummy_fd = open(addr, O_WRONLY | O_NONBLOCK | O_CLOEXEC);
+	}
+	else if (recv->kind == ARROW_STREAM_SOURCE__UNIX)
+	{
+		struct sockaddr_un un;
+
+		memset(&un, 0, sizeof(un));
+		un.sun_family = AF_UNIX;
+		strcpy(un.sun_path, addr);
+		fdesc = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+		if (fdesc < 0)
+		{
+			elog(LOG, "arrow_fdw: failed on socket(2): %m");
+			return false;
+		}
+		(void) unlink(addr);	/* stale socket file */
+		if (bind(fdesc, (struct sockaddr *)&un, sizeof(un)) != 0 ||
+			listen(fdesc, 8) != 0)
+		{
+			elog(LOG, "arrow_fdw: failed on bind/listen at '%s': %m", addr);
+			close(fdesc);
+			return false;
+		}
+		recv->listen_fd = fdesc;
+	}
+	else
+	{
+		struct addrinfo hints;
+		struct addrinfo *res;
+		int		rc, one = 1;
+
+		memset(&hints, 0, sizeof(hints));
+		hints.ai_family = AF_UNSPEC;
+		hints.ai_socktype = SOCK_STREAM;
+		hints.ai_flags = AI_PASSIVE;
+		rc = getaddrinfo(addr, port, &hints, &res);
+		if (rc != 0)
+		{
+			elog(LOG, "arrow_fdw: failed on getaddrinfo('%s'): %s",
+				 source, gai_strerror(rc));
+			return false;
+		}
+		fdesc = socket(res->ai_family,
+					   res->ai_socktype | SOCK_NONBLOCK | SOCK_CLOEXEC,
+					   res->ai_protocol);
+		if (fdesc < 0 ||
+			setsockopt(fdesc, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one)) != 0 ||
+			bind(fdesc, res->ai_addr, res->ai_addrlen) != 0 ||
+			listen(fdesc, 8) != 0)
+		{
+			elog(LOG, "arrow_fdw: failed on bind/listen at '%s': %m", source);
+			if (fdesc >= 0)
+				close(fdesc);
+			freeaddrinfo(res);
+			return false;
+		}
+		freeaddrinfo(res);
+		recv->listen_fd = fdesc;
+	}
+	__arrowStreamSpoolDir(recv->spool_dir, source);
+	if (pg_mkdir_p(recv->spool_dir, pg_dir_create_mode) != 0 && errno != EEXIST)
+	{
+		elog(LOG, "arrow_fdw: could not create directory '%s': %m", recv->spool_dir);
+		return false;
+	}
+	return true;
+}
+
+static void
+__arrowStreamCloseSource(arrowStreamReceiver *recv)
+{
+	__arrowStreamResetConnection(recv);
+	if (recv->conn_fd >= 0)
+		close(recv->conn_fd);
+	if (recv->dummy_fd >= 0)
+		close(recv->dummy_fd);
+	if (recv->listen_fd >= 0)
+		close(recv->listen_fd);
+	recv->conn_fd = -1;
+	recv->dummy_fd = -1;
+	recv->listen_fd = -1;
+	recv->active = false;
+}
+
+static void
+__arrowStreamAddRequested(arrowStreamReceiver *receivers)
+{
+	for (int i=0; i < arrow_stream_head->nslots; i++)
+	{
+		arrowStreamSlot *slot = &arrow_stream_head->slots[i];
+		arrowStreamReceiver *recv = &receivers[i];
+		char	source[MAXPGPATH];
+
+		SpinLockAcquire(&arrow_stream_head->lock);
+		if (slot->status != ARROW_STREAM_STATUS__REQUESTED)
+		{
+			SpinLockRelease(&arrow_stream_head->lock);
+			continue;
+		}
+		strcpy(source, slot->source);
+		SpinLockRelease(&arrow_stream_head->lock);
+
+		if (recv->active)
+			__arrowStreamCloseSource(recv);
+		recv->active = true;
+		if (__arrowStreamOpenSource(recv, source))
+		{
+			__arrowStreamSetStatus(i, ARROW_STREAM_STATUS__RECEIVING);
+			elog(LOG, "arrow_fdw: stream receiver started on '%s'", source);
+		}
+		else
+		{
+			__arrowStreamCloseSource(recv);
+			__arrowStreamSetStatus(i, ARROW_STREAM_STATUS__FAILED);
+		}
+	}
+}
+
+static void
+__arrowStreamWorkerExit(int code, Datum arg)
+{
+	/* sources shall be opened again by the next worker */
+	SpinLockAcquire(&arrow_stream_head->lock);
+	arrow_stream_head->worker_latch = NULL;
+	for (int i=0; i < arrow_stream_head->nslots; i++)
+	{
+		arrowStreamSlot *slot = &arrow_stream_head->slots[i];
+
+		if (slot->status != ARROW_STREAM_STATUS__FREE)
+			slot->status = ARROW_STREAM_STATUS__REQUESTED;
+	}
+	SpinLockRelease(&arrow_stream_head->lock);
+}
+
+/*
+ * arrowFdwStreamWorkerMain
+ */
+void
+arrowFdwStreamWorkerMain(Datum arg)
+{
+	arrowStreamReceiver *receivers;
+	struct pollfd *pfds;
+	int		   *pfds_slot;
+
+	pqsignal(SIGTERM, die);
+	BackgroundWorkerUnblockSignals();
+
+	receivers = MemoryContextAllocZero(TopMemoryContext,
+									   sizeof(arrowStreamReceiver) *
+									   arrow_stream_head->nslots);
+	for (int i=0; i < arrow_stream_head->nslots; i++)
+	{
+		arrowStreamReceiver *recv = &receivers[i];
+
+		recv->listen_fd = -1;
+		recv->conn_fd = -1;
+		recv->dummy_fd = -1;
+		recv->seg_fd = -1;
+		recv->buffer_sz = 1UL << 20;
+		recv->buffer = MemoryContextAllocHuge(TopMemoryContext, recv->buffer_sz);
+	}
+	pfds = MemoryContextAlloc(TopMemoryContext,
+							  sizeof(struct pollfd) * arrow_stream_head->nslots);
+	pfds_slot = MemoryContextAlloc(TopMemoryContext,
+								   sizeof(int) * arrow_stream_head->nslots);
+	arrow_stream_memcxt = AllocSetContextCreate(TopMemoryContext,
+												"Arrow_Fdw Stream Receiver",
+												ALLOCSET_DEFAULT_SIZES);
+
+	before_shmem_exit(__arrowStreamWorkerExit, 0);
+	SpinLockAcquire(&arrow_stream_head->lock);
+	arrow_stream_head->worker_latch = MyLatch;
+	SpinLockRelease(&arrow_stream_head->lock);
+	elog(LOG, "arrow_fdw: stream receiver started");
+
+	for (;;)
+	{
+		int		nfds = 0;
+		bool	has_shmem = false;
+
+		ResetLatch(MyLatch);
+		CHECK_FOR_INTERRUPTS();
+		if (!PostmasterIsAlive())
+			proc_exit(1);
+
+		__arrowStreamAddRequested(receivers);
+		for (int i=0; i < arrow_stream_head->nslots; i++)
+		{
+			arrowStreamReceiver *recv = &receivers[i];
+
+			if (!recv->active)
+				continue;
+			if (recv->kind == ARROW_STREAM_SOURCE__SHMEM)
+			{
+				__arrowStreamSpoolShmem(recv);
+				has_shmem = true;
+				continue;
+			}
+			pfds[nfds].fd = (recv->conn_fd >= 0 ? recv->conn_fd : recv->listen_fd);
+			pfds[nfds].events = POLLIN;
+			pfds[nfds].revents = 0;
+			pfds_slot[nfds] = i;
+			nfds++;
+		}
+		if (poll(pfds, nfds, ARROW_STREAM_NAPTIME) <= 0)
+		{
+			if (nfds == 0)
+				(void) WaitLatch(MyLatch,
+								 WL_LATCH_SET |
+								 WL_TIMEOUT |
+								 WL_EXIT_ON_PM_DEATH,
+								 has_shmem
+								 ? ARROW_STREAM_NAPTIME
+								 : ARROW_STREAM_NAPTIME * 10,
+								 PG_WAIT_EXTENSION);
+			continue;
+		}
+		for (int k=0; k < nfds; k++)
+		{
+			arrowStreamReceiver *recv = &receivers[pfds_slot[k]];
+
+			if ((pfds[k].revents & (POLLIN | POLLHUP | POLLERR)) == 0)
+				continue;
+			if (recv->conn_fd >= 0)
+				__arrowStreamReceive(pfds_slot[k], recv);
+			else
+				__arrowStreamAccept(pfds_slot[k], recv);
+		}
+	}
+}
+
+/*
+ * pgstrom_request_arrow_stream
+ */
+static void
+pgstrom_request_arrow_stream(void)
+{
+	if (shmem_request_next)
+		shmem_request_next();
+	RequestAddinShmemSpace(MAXALIGN(offsetof(arrowStreamHead,
+											 slots[arrow_stream_max_sources])));
+}
+
+/*
+ * pgstrom_startup_arrow_stream
+ */
+static void
+pgstrom_startup_arrow_stream(void)
+{
+	size_t	sz = offsetof(arrowStreamHead, slots[arrow_stream_max_sources]);
+	bool	found;
+
+	if (shmem_startup_next)
+		(*shmem_startup_next)();
+
+	arrow_stream_head = ShmemInitStruct("arrowStreamHead", MAXALIGN(sz), &found);
+	Assert(!found);
+	memset(arrow_stream_head, 0, sz);
+	SpinLockInit(&arrow_stream_head->lock);
+	arrow_stream_head->nslots = arrow_stream_max_sources;
+}
+
+/*
+ * pgstrom_init_arrow_stream
+ */
+void
+pgstrom_init_arrow_stream(void)
+{
+	BackgroundWorker worker;
+
+	DefineCustomIntVariable("arrow_fdw.stream_max_sources",
+							"max number of stream sources received concurrently (0 to disable)",
+							NULL,
+							&arrow_stream_max_sources,
+							16,
+							0,
+							1000,
+							PGC_POSTMASTER,
+							GUC_NOT_IN_SAMPLE,
+							NULL, NULL, NULL);
+	DefineCustomIntVariable("arrow_fdw.stream_buffer_size",
+							"size of the spool ring for each stream source",
+							NULL,
+							&arrow_stream_buffer_size_mb,
+							1024,		/* 1GB */
+							64,			/* 64MB */
+							INT_MAX,
+							PGC_SIGHUP,
+							GUC_NOT_IN_SAMPLE | GUC_UNIT_MB,
+							NULL, NULL, NULL);
+	DefineCustomStringVariable("arrow_fdw.stream_spool_dir",
+							   "directory of the spool segments of the stream sources",
+							   NULL,
+							   &arrow_stream_spool_dir,
+							   "pg_strom_stream",
+							   PGC_POSTMASTER,
+							   GUC_NOT_IN_SAMPLE,
+							   NULL, NULL, NULL);
+	if (arrow_stream_max_sources == 0)
+		return;
+
+	memset(&worker, 0, sizeof(BackgroundWorker));
+	snprintf(worker.bgw_name, sizeof(worker.bgw_name),
+			 "Arrow_Fdw Stream Receiver");
+	worker.bgw_flags = BGWORKER_SHMEM_ACCESS;
+	worker.bgw_start_time = BgWorkerStart_PostmasterStart;
+	worker.bgw_restart_time = 5;
+	snprintf(worker.bgw_library_name, BGW_MAXLEN,
+			 "$libdir/pg_strom");
+	snprintf(worker.bgw_function_name, BGW_MAXLEN,
+			 "arrowFdwStreamWorkerMain");
+	worker.bgw_main_arg = 0;
+	RegisterBackgroundWorker(&worker);
+
+	/* shared memory size */
+	shmem_request_next = shmem_request_hook;
+	shmem_request_hook = pgstrom_request_arrow_stream;
+	shmem_startup_next = shmem_startup_hook;
+	shmem_startup_hook = pgstrom_startup_arrow_stream;
+}
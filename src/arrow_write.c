@@ -520,6 +520,14 @@ createArrowType(ArrowType *node, ArrowTypeTag *p_type_tag)
 			tag = ArrowType__Binary;
 			buf = createArrowTypeSimple();
 			break;
+		case ArrowNodeTag__Utf8View:
+			tag = ArrowType__Utf8View;
+			buf = createArrowTypeSimple();
+			break;
+		case ArrowNodeTag__BinaryView:
+			tag = ArrowType__BinaryView;
+			buf = createArrowTypeSimple();
+			break;
 		case ArrowNodeTag__Bool:
 			tag = ArrowType__Bool;
 			buf = createArrowTypeSimple();
@@ -763,7 +771,9 @@ createArrowRecordBatch(ArrowRecordBatch *node)
 {
 	FBTableBuf *buf;
 
-	if (node->compression)
+	if (node->_num_variadicBufferCounts > 0)
+		buf = allocFBTableBuf(5);
+	else if (node->compression)
 		buf = allocFBTableBuf(4);
 	else
 		buf = allocFBTableBuf(3);
@@ -781,6 +791,17 @@ createArrowRecordBatch(ArrowRecordBatch *node)
 		FBTableBuf *sub = createArrowBodyCompression(node->compression);
 		addBufferOffset(buf, 3, sub);
 	}
+	if (node->_num_variadicBufferCounts > 0)
+	{
+		int		nitems = node->_num_variadicBufferCounts;
+		size_t	sz = sizeof(int32_t) + sizeof(int64_t) * nitems;
+		char   *temp = alloca(sz);
+
+		*((int32_t *)temp) = nitems;
+		for (int i=0; i < nitems; i++)
+			((int64_t *)(temp + sizeof(int32_t)))[i] = node->variadicBufferCounts[i];
+		__addBufferBinary(buf, 4, temp, sz, sizeof(int32_t));
+	}
 	return makeBufferFlatten(buf);
 }
 
@@ -1180,6 +1201,127 @@ __setupArrowFieldStat(ArrowKeyValue *customMetadata,
 	}
 }
 
+/*
+ * __setupArrowFieldZoneMap
+ *
+ * zone-map is written as: "zonemap_nrows" for the number of rows per zone,
+ * and "zonemap_min_values"/"zonemap_max_values" that are the list of
+ * record-batches separated by ';', and the list of zones separated by ','.
+ */
+static int
+__compareArrowZoneStats(const void *__a, const void *__b)
+{
+	const SQLstat  *a = *((const SQLstat **)__a);
+	const SQLstat  *b = *((const SQLstat **)__b);
+
+	if (a->rb_index != b->rb_index)
+		return (a->rb_index < b->rb_index ? -1 : 1);
+	if (a->zone_index != b->zone_index)
+		return (a->zone_index < b->zone_index ? -1 : 1);
+	return 0;
+}
+
+static void
+__setupArrowFieldZoneMap(ArrowKeyValue *customMetadata,
+						 SQLfield *column, int numRecordBatches)
+{
+	static const char *zone_names[] = {"zonemap_min_values","zonemap_max_values"};
+	SQLstat	  **zone_array;
+	SQLstat	   *curr;
+	ArrowKeyValue *kv;
+	char		temp[64];
+	int			i, k, nitems = 0;
+
+	/* sort the zone-stats by rb_index/zone_index */
+	for (curr = column->zone_list; curr; curr = curr->next)
+	{
+		if (curr->rb_index < 0 || curr->rb_index >= numRecordBatches)
+			Elog("zone-map info at [%s] is out of range (%d of %d)",
+				 column->field_name, curr->rb_index, numRecordBatches);
+		nitems++;
+	}
+	zone_array = palloc(sizeof(SQLstat *) * (nitems + 1));
+	for (curr = column->zone_list, i=0; curr; curr = curr->next)
+		zone_array[i++] = curr;
+	if (nitems > 1)
+		qsort(zone_array, nitems, sizeof(SQLstat *), __compareArrowZoneStats);
+
+	/* zonemap_nrows */
+	kv = &customMetadata[0];
+	snprintf(temp, sizeof(temp), "%d", column->zone_nrows);
+	initArrowNode(kv, KeyValue);
+	kv->key = pstrdup("zonemap_nrows");
+	kv->_key_len = strlen(kv->key);
+	kv->value = pstrdup(temp);
+	kv->_value_len = strlen(kv->value);
+
+	/* zonemap_min_values / zonemap_max_values */
+	for (k=0; k < 2; k++)
+	{
+		int		len = 1024;
+		int		off = 0;
+		int		index = 0;
+		char   *buf = palloc(len);
+
+		kv = &customMetadata[k+1];
+		for (i=0; i < numRecordBatches; i++)
+		{
+			bool	is_first = true;
+
+			if (i > 0)
+				buf[off++] = ';';
+			while (index < nitems && zone_array[index]->rb_index == i)
+			{
+				SQLstat__datum *st_datum;
+
+				curr = zone_array[index++];
+				st_datum = (k == 0 ? &curr->min : &curr->max);
+				if (off + 100 >= len)
+				{
+					len += len;
+					buf = repalloc(buf, len);
+				}
+				if (!is_first)
+					buf[off++] = ',';
+				is_first = false;
+				if (!curr->is_valid)
+				{
+					off += snprintf(buf+off, len-off, "null");
+					continue;
+				}
+				for (;;)
+				{
+					int		nbytes;
+
+					nbytes = column->write_stat(column, buf+off, len-off, st_datum);
+					if (nbytes < 0)
+						Elog("failed on write %s of %s (rb_index=%d)",
+							 zone_names[k], column->field_name, i);
+					if (off + nbytes < len)
+					{
+						off += nbytes;
+						break;
+					}
+					len += len;
+					buf = repalloc(buf, len);
+				}
+			}
+			if (off + 100 >= len)
+			{
+				len += len;
+				buf = repalloc(buf, len);
+			}
+		}
+		buf[off] = '\0';
+		initArrowNode(kv, KeyValue);
+		kv->key = pstrdup(zone_names[k]);
+		kv->_key_len = strlen(kv->key);
+		kv->value = buf;
+		kv->_value_len = off;
+	}
+	pfree(zone_array);
+}
+
 static void
 setupArrowField(ArrowField *field, SQLtable *table, SQLfield *column)
 {
@@ -1217,17 +1359,33 @@ setupArrowField(ArrowField *field, SQLtable *table, SQLfield *column)
 	/* min/max statistics */
 	if (column->stat_enabled)
 	{
-		size_t		sz = sizeof(ArrowKeyValue) * (numCustomMetadata + 2);
+		ArrowKeyValue *temp = palloc0(sizeof(ArrowKeyValue) * (numCustomMetadata + 2));
 
-		if (!customMetadata)
-			customMetadata = palloc0(sz);
-		else
-			customMetadata = repalloc(customMetadata, sz);
+		/*
+		 * column->customMetadata must be kept as is, because this routine
+		 * shall be called twice for the Schema and the Footer.
+		 */
+		if (numCustomMetadata > 0)
+			memcpy(temp, customMetadata, sizeof(ArrowKeyValue) * numCustomMetadata);
+		customMetadata = temp;
 
 		__setupArrowFieldStat(customMetadata + numCustomMetadata,
 							  column, table->numRecordBatches);
 		numCustomMetadata += 2;
 	}
+	/* zone-map statistics */
+	if (column->stat_enabled && column->zone_nrows > 0)
+	{
+		ArrowKeyValue *temp = palloc0(sizeof(ArrowKeyValue) * (numCustomMetadata + 3));
+
+		if (numCustomMetadata > 0)
+			memcpy(temp, customMetadata, sizeof(ArrowKeyValue) * numCustomMetadata);
+		customMetadata = temp;
+
+		__setupArrowFieldZoneMap(customMetadata + numCustomMetadata,
+								 column, table->numRecordBatches);
+		numCustomMetadata += 3;
+	}
 	/* custom metadata, if any */
 	field->_num_custom_metadata = numCustomMetadata;
 	field->custom_metadata = customMetadata;
@@ -1653,6 +1811,28 @@ __saveArrowRecordBatchStats(int rb_index, SQLfield *field)
 	}
 }
 
+/*
+ * saveArrowZoneStats
+ *
+ * It saves the min/max statistics of the current zone, then reset it.
+ * rb_index shall be assigned on writeArrowRecordBatch().
+ */
+void
+saveArrowZoneStats(SQLfield *field)
+{
+	SQLstat	   *item = palloc(sizeof(SQLstat));
+
+	assert(field->zone_nrows > 0 && field->nitems > 0);
+	memcpy(item, &field->zone_datum, sizeof(SQLstat));
+	item->rb_index = -1;
+	item->zone_index = (field->nitems - 1) / field->zone_nrows;
+	item->next = field->zone_list;
+	field->zone_list = item;
+
+	/* reset statistics */
+	memset(&field->zone_datum, 0, sizeof(SQLstat));
+}
+
 int
 writeArrowRecordBatch(SQLtable *table)
 {
@@ -1682,6 +1862,18 @@ writeArrowRecordBatch(SQLtable *table)
 
 			if (field->stat_enabled)
 				__saveArrowRecordBatchStats(rb_index, field);
+			if (field->zone_nrows > 0)
+			{
+				SQLstat	   *curr;
+
+				/* the last zone, if not filled up */
+				if (field->nitems % field->zone_nrows != 0)
+					saveArrowZoneStats(field);
+				for (curr = field->zone_list;
+					 curr && curr->rb_index < 0;
+					 curr = curr->next)
+					curr->rb_index = rb_index;
+			}
 		}
 	}
 	return rb_index;
@@ -1726,3 +1918,66 @@ writeArrowFooter(SQLtable *table)
 	/* serialization */
 	return writeFlatBufferFooter(table, &footer);
 }
+
+/* ----------------------------------------------------------------
+ * Routines for the shared memory segment (see arrow_ipc.h)
+ * ---------------------------------------------------------------- */
+
+/*
+ * arrowShmemCreateSegment
+ *
+ * It sets up the header of the shared memory segment on the file just
+ * created (table->fdesc), then writes and commits the Schema message.
+ * The following record-batches are written by writeArrowRecordBatch()
+ * as usual, and become visible to the readers on arrowShmemCommit().
+ */
+ArrowShmemHeader *
+arrowShmemCreateSegment(SQLtable *table, size_t segment_sz)
+{
+	ArrowShmemHeader *shm_head;
+
+	if (ftruncate(table->fdesc, ARROW_SHMEM_HEADER_SZ) != 0)
+		Elog("failed on ftruncate('%s'): %m", table->filename);
+	shm_head = mmap(NULL, ARROW_SHMEM_HEADER_SZ,
+					PROT_READ | PROT_WRITE,
+					MAP_SHARED,
+					table->fdesc, 0);
+	if (shm_head == MAP_FAILED)
+		Elog("failed on mmap('%s'): %m", table->filename);
+	shm_head->version = ARROW_SHMEM_VERSION;
+	shm_head->flags = 0;
+	shm_head->segment_sz = segment_sz;
+	shm_head->committed = 0;
+	shm_head->producer_pid = getpid();
+	memcpy(shm_head->signature,
+		   ARROW_SHMEM_SIGNATURE,
+		   ARROW_SHMEM_SIGNATURE_SZ);
+
+	table->f_pos = ARROW_SHMEM_HEADER_SZ;
+	writeArrowSchema(table);
+	arrowShmemCommit(shm_head, table->f_pos);
+
+	return shm_head;
+}
+
+/*
+ * arrowShmemCommit - publishes the messages written before 'committed'
+ */
+void
+arrowShmemCommit(ArrowShmemHeader *shm_head, size_t committed)
+{
+	assert(committed >= shm_head->committed);
+	__atomic_store_n(&shm_head->committed, committed, __ATOMIC_RELEASE);
+}
+
+/*
+ * arrowShmemClose - marks the segment closed; no more updates
+ */
+void
+arrowShmemClose(ArrowShmemHeader *shm_head)
+{
+	__atomic_or_fetch(&shm_head->flags,
+					  ARROW_SHMEM_FLAG__CLOSED,
+					  __ATOMIC_RELEASE);
+	munmap(shm_head, ARROW_SHMEM_HEADER_SZ);
+}
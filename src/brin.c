@@ -1,7 +1,7 @@
 /*
  * brin.c
  *
- * Routines to support BRIN index
+ * Routines to support BRIN index, and B-tree index by the bitmap
  * ----
  * Copyright 2011-2023 (C) KaiGai Kohei <kaigai@kaigai.gr.jp>
  * Copyright 2014-2023 (C) PG-Strom Developers Team
@@ -22,6 +22,60 @@ typedef struct
 } IndexClauseSet;
 
 static bool		pgstrom_enable_brin;
+static bool		pgstrom_enable_btree_bitmap;
+
+/*
+ * BRIN operator classes that need special handling; see brin_bloom.c
+ * for the default false-positive rate of the bloom opclasses.
+ */
+#define BRIN_OPCLASS__MINMAX		0
+#define BRIN_OPCLASS__BLOOM			1
+#define BRIN_OPCLASS__MINMAX_MULTI	2
+#define BRIN_BLOOM_FALSE_POSITIVE_RATE	0.01
+
+static int
+__brinIndexColumnOpclass(IndexOptInfo *index, int indexcol)
+{
+	Oid		consistent;
+
+	if (index->relam != BRIN_AM_OID)
+		return BRIN_OPCLASS__MINMAX;
+	consistent = get_opfamily_proc(index->opfamily[indexcol],
+								   index->opcintype[indexcol],
+								   index->opcintype[indexcol],
+								   BRIN_PROCNUM_CONSISTENT);
+	switch (consistent)
+	{
+		case F_BRIN_BLOOM_CONSISTENT:
+			return BRIN_OPCLASS__BLOOM;
+		case F_BRIN_MINMAX_MULTI_CONSISTENT:
+			return BRIN_OPCLASS__MINMAX_MULTI;
+		default:
+			break;
+	}
+	return BRIN_OPCLASS__MINMAX;
+}
+
+/*
+ * __brinBloomOperatorIsSafe
+ *
+ * The bloom opclasses hash the scan key argument using the hash function
+ * of the indexed type, so cross-type operators are not safe to use.
+ */
+static bool
+__brinBloomOperatorIsSafe(IndexOptInfo *index, int indexcol, Oid opno)
+{
+	int		strategy;
+	Oid		lefttype;
+	Oid		righttype;
+
+	if (!OidIsValid(opno))
+		return false;
+	get_op_opfamily_properties(opno, index->opfamily[indexcol], false,
+							   &strategy, &lefttype, &righttype);
+	return (lefttype == index->opcintype[indexcol] &&
+			righttype == index->opcintype[indexcol]);
+}
 
 /*
  * simple_match_clause_to_indexcol
@@ -70,13 +124,22 @@ simple_match_clause_to_indexcol(IndexOptInfo *index,
 		!bms_is_member(index_relid, right_relids) &&
 		!contain_volatile_functions(rightop) &&
 		op_in_opfamily(expr_op, opfamily))
+	{
+		if (__brinIndexColumnOpclass(index, indexcol) == BRIN_OPCLASS__BLOOM)
+			return __brinBloomOperatorIsSafe(index, indexcol, expr_op);
 		return true;
+	}
 
 	if (match_index_to_operand(rightop, indexcol, index) &&
 		!bms_is_member(index_relid, left_relids) &&
 		!contain_volatile_functions(leftop) &&
 		op_in_opfamily(get_commutator(expr_op), opfamily))
+	{
+		if (__brinIndexColumnOpclass(index, indexcol) == BRIN_OPCLASS__BLOOM)
+			return __brinBloomOperatorIsSafe(index, indexcol,
+											 get_commutator(expr_op));
 		return true;
+	}
 
 	return false;
 }
@@ -141,20 +204,28 @@ estimateBrinIndexScanNBlocks(PlannerInfo *root,
 	Relation		indexRel;
 	BrinStatsData	statsData;
 	List		   *indexQuals = NIL;
+	List		   *minmaxQuals = NIL;
 	ListCell	   *lc;
 	int				icol;
 	Selectivity		qualSelectivity;
 	Selectivity		indexSelectivity;
+	Selectivity		bloomSelectivity = 1.0;
 	double			indexCorrelation = 0.0;
 	double			indexRanges;
 	double			minimalRanges;
 	double			estimatedRanges;
+	double			tuplesPerRange;
 
 	/* Obtain some data from the index itself. */
 	indexRel = index_open(index->indexoid, AccessShareLock);
 	brinGetStats(indexRel, &statsData);
 	index_close(indexRel, AccessShareLock);
 
+	indexRanges = ceil((double) baserel->pages / statsData.pagesPerRange);
+	if (indexRanges < 1.0)
+		indexRanges = 1.0;
+	tuplesPerRange = Max(baserel->tuples / indexRanges, 1.0);
+
 	/* Get selectivity of the index qualifiers */
 	icol = 1;
 	foreach (lc, index->indextlist)
@@ -170,6 +241,28 @@ estimateBrinIndexScanNBlocks(PlannerInfo *root,
 			indexQuals = lappend(indexQuals, rinfo);
 		}
 
+		/*
+		 * Bloom summaries are not sensitive to the physical correlation,
+		 * so a range is fetched if any tuple within the range matches,
+		 * or a false-positive of the bloom filter.
+		 */
+		if (clauseset->indexclauses[icol-1] != NIL &&
+			__brinIndexColumnOpclass(index, icol-1) == BRIN_OPCLASS__BLOOM)
+		{
+			Selectivity	sel = clauselist_selectivity(root,
+													 clauseset->indexclauses[icol-1],
+													 baserel->relid,
+													 JOIN_INNER,
+													 NULL);
+			sel = 1.0 - pow(1.0 - Min(sel, 1.0), tuplesPerRange);
+			sel += BRIN_BLOOM_FALSE_POSITIVE_RATE;
+			bloomSelectivity *= Min(sel, 1.0);
+			icol++;
+			continue;
+		}
+		minmaxQuals = list_concat(minmaxQuals,
+								  clauseset->indexclauses[icol-1]);
+
 		if (IsA(tle->expr, Var))
 		{
 			Var	   *var = (Var *) tle->expr;
@@ -238,24 +331,26 @@ estimateBrinIndexScanNBlocks(PlannerInfo *root,
 
 		icol++;
 	}
-	qualSelectivity = clauselist_selectivity(root,
-											 indexQuals,
-											 baserel->relid,
-											 JOIN_INNER,
-											 NULL);
-
 	/* estimate number of blocks to read */
-	indexRanges = ceil((double) baserel->pages / statsData.pagesPerRange);
-	if (indexRanges < 1.0)
-		indexRanges = 1.0;
-	minimalRanges = ceil(indexRanges * qualSelectivity);
-
-	//elog(INFO, "strom: qualSelectivity=%.6f indexRanges=%.6f minimalRanges=%.6f indexCorrelation=%.6f", qualSelectivity, indexRanges, minimalRanges, indexCorrelation);
-
-	if (indexCorrelation < 1.0e-10)
+	if (minmaxQuals == NIL)
 		estimatedRanges = indexRanges;
 	else
-		estimatedRanges = Min(minimalRanges / indexCorrelation, indexRanges);
+	{
+		qualSelectivity = clauselist_selectivity(root,
+												 minmaxQuals,
+												 baserel->relid,
+												 JOIN_INNER,
+												 NULL);
+		minimalRanges = ceil(indexRanges * qualSelectivity);
+
+		//elog(INFO, "strom: qualSelectivity=%.6f indexRanges=%.6f minimalRanges=%.6f indexCorrelation=%.6f", qualSelectivity, indexRanges, minimalRanges, indexCorrelation);
+
+		if (indexCorrelation < 1.0e-10)
+			estimatedRanges = indexRanges;
+		else
+			estimatedRanges = Min(minimalRanges / indexCorrelation, indexRanges);
+	}
+	estimatedRanges *= bloomSelectivity;
 
 	indexSelectivity = estimatedRanges / indexRanges;
 	if (indexSelectivity < 0.0)
@@ -270,6 +365,44 @@ estimateBrinIndexScanNBlocks(PlannerInfo *root,
 	return (int64_t)(indexSelectivity * (double) baserel->pages);
 }
 
+/*
+ * estimateBtreeIndexScanNBlocks
+ *
+ * B-tree index is scanned into a TIDBitmap, then the blocks in the bitmap
+ * are loaded; see compute_bitmap_pages at optimizer/path/costsize.c
+ */
+static int64_t
+estimateBtreeIndexScanNBlocks(PlannerInfo *root,
+							  RelOptInfo *baserel,
+							  IndexOptInfo *index,
+							  IndexClauseSet *clauseset,
+							  List **p_indexQuals)
+{
+	List		   *indexQuals = NIL;
+	Selectivity		indexSelectivity;
+	double			tuples_fetched;
+	double			pages_fetched;
+	double			T = Max((double)baserel->pages, 1.0);
+
+	/* B-tree index scan needs the key of the leading column */
+	if (clauseset->indexclauses[0] == NIL)
+		return INT64_MAX;
+	for (int icol=0; icol < index->nkeycolumns; icol++)
+		indexQuals = list_concat(indexQuals, clauseset->indexclauses[icol]);
+	indexSelectivity = clauselist_selectivity(root,
+											  indexQuals,
+											  baserel->relid,
+											  JOIN_INNER,
+											  NULL);
+	tuples_fetched = clamp_row_est(indexSelectivity * baserel->tuples);
+	pages_fetched = (2.0 * T * tuples_fetched) / (2.0 * T + tuples_fetched);
+	pages_fetched = ceil(Min(pages_fetched, T));
+
+	if (p_indexQuals)
+		*p_indexQuals = indexQuals;
+	return (int64_t)pages_fetched;
+}
+
 /*
  * extract_index_conditions
  */
@@ -349,7 +482,8 @@ pgstromTryFindBrinIndex(PlannerInfo *root,
 	List		   *indexQuals = NIL;
 	ListCell	   *cell;
 
-	if (!pgstrom_enable_brin || baserel->indexlist == NIL)
+	if ((!pgstrom_enable_brin && !pgstrom_enable_btree_bitmap) ||
+		baserel->indexlist == NIL)
 		return NULL;
 
 	foreach (cell, baserel->indexlist)
@@ -367,9 +501,13 @@ pgstromTryFindBrinIndex(PlannerInfo *root,
         if (index->indpred != NIL && !index->predOK)
             continue;
 
-        /* Only BRIN-indexes are now supported */
-        if (index->relam != BRIN_AM_OID)
-            continue;
+		/* Only BRIN-indexes and B-tree indexes are now supported */
+		if (index->relam == BRIN_AM_OID
+			? !pgstrom_enable_brin
+			: (index->relam != BTREE_AM_OID ||
+			   !index->amhasgetbitmap ||
+			   !pgstrom_enable_btree_bitmap))
+			continue;
 
         /* see match_clauses_to_index */
         memset(&clauseset, 0, sizeof(IndexClauseSet));
@@ -382,14 +520,20 @@ pgstromTryFindBrinIndex(PlannerInfo *root,
         if (!clauseset.nonempty)
             continue;
 
-        /*
-         * In case when multiple BRIN-indexes are configured,
-         * the one with minimal selectivity is the best choice.
-         */
-        nblocks = estimateBrinIndexScanNBlocks(root, baserel,
-											   index,
-											   &clauseset,
-											   &temp);
+		/*
+		 * In case when multiple indexes are configured,
+		 * the one with minimal selectivity is the best choice.
+		 */
+		if (index->relam == BRIN_AM_OID)
+			nblocks = estimateBrinIndexScanNBlocks(root, baserel,
+												   index,
+												   &clauseset,
+												   &temp);
+		else
+			nblocks = estimateBtreeIndexScanNBlocks(root, baserel,
+													index,
+													&clauseset,
+													&temp);
 		if (indexNBlocks > nblocks)
 		{
 			indexOpt = index;
@@ -424,13 +568,28 @@ cost_brin_bitmap_build(PlannerInfo *root,
 	double			spc_seq_page_cost;
 	ListCell	   *lc;
 
+	get_tablespace_page_costs(indexOpt->reltablespace,
+							  &spc_rand_page_cost,
+							  &spc_seq_page_cost);
+	if (indexOpt->relam != BRIN_AM_OID)
+	{
+		/* B-tree index scan to build the TIDBitmap */
+		Selectivity	sel = clauselist_selectivity(root,
+												 indexQuals,
+												 baserel->relid,
+												 JOIN_INNER,
+												 NULL);
+		QualCost	qcost;
+
+		index_nitems = clamp_row_est(sel * baserel->tuples);
+		cost_qual_eval(&qcost, indexQuals, root);
+		return (spc_rand_page_cost * ceil(sel * indexOpt->pages) +
+				(cpu_index_tuple_cost + qcost.per_tuple) * index_nitems);
+	}
 	indexRel = index_open(indexOpt->indexoid, AccessShareLock);
 	brinGetStats(indexRel, &statsData);
 	index_close(indexRel, AccessShareLock);
 
-	get_tablespace_page_costs(indexOpt->reltablespace,
-							  &spc_rand_page_cost,
-							  &spc_seq_page_cost);
 	index_build_cost = spc_rand_page_cost * statsData.revmapNumPages;
 	index_nitems = ceil(baserel->pages / (double)statsData.pagesPerRange);
 	foreach (lc, indexQuals)
@@ -446,19 +605,42 @@ cost_brin_bitmap_build(PlannerInfo *root,
 }
 
 
+/*
+ * BrinIndexResults
+ *
+ * BRIN summaries are evaluated per batch of BRIN_EVAL_BATCH_NRANGES
+ * ranges, on demand of the scan, so the first chunk is loaded without
+ * waiting for the evaluation of the entire revmap. Any processes that
+ * reached a batch not evaluated yet, evaluate it by themselves, and
+ * the other processes are also available to run the lookahead batches.
+ *
+ * B-tree index is scanned into a TIDBitmap at once, by the first process
+ * that reached the scan, so the results have only one batch; its ranges
+ * are individual blocks (pagesPerRange == 1).
+ */
+#define BRIN_EVAL_BATCH_NRANGES		256
+
+#define BRIN_BATCH__NOT_YET			0
+#define BRIN_BATCH__RUNNING			1
+#define BRIN_BATCH__DONE			2
+#define BRIN_BATCH__FAILED			3
+
 typedef struct
 {
-	volatile int	build_status;
-	slock_t			lock;	/* once 'build_status' is set, no need to take
-							 * this lock again. */
-	pg_atomic_uint32 index;
-	uint32_t		nitems;
-	BlockNumber		chunks[FLEXIBLE_ARRAY_MEMBER];
+	pg_atomic_uint32 index;		/* next range to be fetched */
+	uint32_t		nchunks;
+	uint32_t		nbatches;
+	pg_atomic_uint32 batches[FLEXIBLE_ARRAY_MEMBER];
+	/* bool matched[nchunks] shall be here */
 } BrinIndexResults;
 
+#define BRIN_INDEX_RESULTS_MATCHED(br_results)					\
+	((bool *)&(br_results)->batches[(br_results)->nbatches])
+
 struct BrinIndexState
 {
 	Relation		index_rel;
+	bool			is_bitmap;		/* B-tree index by the TIDBitmap */
 	List		   *index_quals;
 	BlockNumber		nblocks;
 	BlockNumber		nchunks;
@@ -472,11 +654,38 @@ struct BrinIndexState
 	bool			RuntimeKeysIsReady;
 	ExprContext	   *RuntimeExprContext;
 	BrinIndexResults *brinResults;
+	/* per-process state to evaluate the summaries; see bringetbitmap() */
+	bool			evalIsReady;
+	FmgrInfo	   *consistentFn;
+	ScanKey		  **keys;
+	ScanKey		  **nullkeys;
+	int			   *nkeys;
+	int			   *nnullkeys;
+	BrinMemTuple   *dtup;
+	Buffer			buffer;
+	MemoryContext	per_range_cxt;
 	uint32_t		curr_chunk_id;
 	uint32_t		curr_block_id;
 	TBMIterateResult tbmres;	/* must be tail */
 };
 
+static inline uint32_t
+__BrinIndexNumBatches(BrinIndexState *br_state)
+{
+	if (br_state->is_bitmap)
+		return 1;
+	return (br_state->nchunks + BRIN_EVAL_BATCH_NRANGES - 1) / BRIN_EVAL_BATCH_NRANGES;
+}
+
+static inline Size
+__BrinIndexResultsLength(BrinIndexState *br_state)
+{
+	uint32_t	nbatches = __BrinIndexNumBatches(br_state);
+
+	return MAXALIGN(offsetof(BrinIndexResults, batches[nbatches]) +
+					sizeof(bool) * br_state->nchunks);
+}
+
 /*
  * BrinIndexExecBegin
  */
@@ -506,10 +715,18 @@ pgstromBrinIndexExecBegin(pgstromTaskState *pts,
 	lockmode = exec_rt_fetch(scanrelid, estate)->rellockmode;
 	br_state->index_rel = index_open(index_oid, lockmode);
 	br_state->index_quals = copyObject(index_quals);
-	br_state->brinRevmap = brinRevmapInitialize(br_state->index_rel,
-												&br_state->pagesPerRange,
-												estate->es_snapshot);
-	br_state->brinDesc = brin_build_desc(br_state->index_rel); 
+	if (br_state->index_rel->rd_rel->relam != BRIN_AM_OID)
+	{
+		br_state->is_bitmap = true;
+		br_state->pagesPerRange = 1;
+	}
+	else
+	{
+		br_state->brinRevmap = brinRevmapInitialize(br_state->index_rel,
+													&br_state->pagesPerRange,
+													estate->es_snapshot);
+		br_state->brinDesc = brin_build_desc(br_state->index_rel);
+	}
 	br_state->nblocks = RelationGetNumberOfBlocks(relation);
 	br_state->nchunks = (br_state->nblocks +
 						 br_state->pagesPerRange - 1) / br_state->pagesPerRange;
@@ -545,15 +762,11 @@ pgstromBrinIndexExecBegin(pgstromTaskState *pts,
 }
 
 /*
- * BrinIndexExecReset
+ * __BrinIndexEvalRuntimeKeys
  */
-void
-pgstromBrinIndexExecReset(pgstromTaskState *pts)
+static void
+__BrinIndexEvalRuntimeKeys(BrinIndexState *br_state)
 {
-	/* See, ExecReScanBitmapIndexScan */
-	BrinIndexState *br_state = pts->br_state;
-	BrinIndexResults *br_results = br_state->brinResults;
-
 	if (br_state->NumRuntimeKeys != 0)
 	{
 		ExprContext	*econtext = br_state->RuntimeExprContext;
@@ -563,14 +776,32 @@ pgstromBrinIndexExecReset(pgstromTaskState *pts)
 								 br_state->RuntimeKeys,
 								 br_state->NumRuntimeKeys);
 	}
-	br_state->RuntimeKeysIsReady = false;
+	br_state->RuntimeKeysIsReady = true;
+}
+
+/*
+ * BrinIndexExecReset
+ */
+void
+pgstromBrinIndexExecReset(pgstromTaskState *pts)
+{
+	/* See, ExecReScanBitmapIndexScan */
+	BrinIndexState *br_state = pts->br_state;
+	BrinIndexResults *br_results = br_state->brinResults;
+
+	__BrinIndexEvalRuntimeKeys(br_state);
 
 	br_state->curr_chunk_id = 0;
 	br_state->curr_block_id = UINT_MAX;
 
-	br_results->build_status = 0;
-	br_results->nitems   = 0;
-	pg_atomic_init_u32(&br_results->index, 0);
+	if (br_results)
+	{
+		uint32_t	i;
+
+		pg_atomic_write_u32(&br_results->index, 0);
+		for (i=0; i < br_results->nbatches; i++)
+			pg_atomic_write_u32(&br_results->batches[i], BRIN_BATCH__NOT_YET);
+	}
 }
 
 /*
@@ -624,37 +855,25 @@ check_null_keys(BrinValues *bval, ScanKey *nullkeys, int nnullkeys)
 }
 
 /*
- * __BrinIndexExecBuildResults
+ * __BrinIndexSetupEval
  */
 static void
-__BrinIndexExecBuildResults(pgstromTaskState *pts)
+__BrinIndexSetupEval(pgstromTaskState *pts)
 {
 	/* see bringetbitmap() */
-	pgstromSharedState *ps_state = pts->ps_state;
 	EState		   *estate = pts->css.ss.ps.state;
 	BrinIndexState *br_state = pts->br_state;
-	BrinIndexResults *br_results = br_state->brinResults;
-	BrinDesc	   *bdesc = br_state->brinDesc;
-	TupleDesc		bd_tupdesc = bdesc->bd_tupdesc;
-	Buffer			buffer = InvalidBuffer;
-	FmgrInfo	   *consistentFn;
+	TupleDesc		bd_tupdesc = br_state->brinDesc->bd_tupdesc;
 	MemoryContext	oldcxt;
-	MemoryContext	per_range_cxt;
-	BrinMemTuple   *dtup;
-	ScanKey		  **keys;
-	ScanKey		  **nullkeys;
-	int			   *nkeys;
-	int			   *nnullkeys;
 	int				j, keyno;
-	uint32_t		chunk_id;
 
+	oldcxt = MemoryContextSwitchTo(estate->es_query_cxt);
 	/*
 	 * Make room for the consistent support procedures of indexed columns.  We
 	 * don't look them up here; we do that lazily the first time we see a scan
 	 * key reference each of them.  We rely on zeroing fn_oid to InvalidOid.
 	 */
-	consistentFn = alloca(sizeof(FmgrInfo) * bd_tupdesc->natts);
-	memset(consistentFn, 0, sizeof(FmgrInfo) * bd_tupdesc->natts);
+	br_state->consistentFn = palloc0(sizeof(FmgrInfo) * bd_tupdesc->natts);
 
 	/*
 	 * Make room for per-attribute lists of scan keys that we'll pass to the
@@ -662,17 +881,15 @@ __BrinIndexExecBuildResults(pgstromTaskState *pts)
 	 * keys, so we allocate space for all attributes. That may use more memory
 	 * but it's probably cheaper than determining which attributes are used.
 	 */
-	keys = alloca(sizeof(ScanKey *) * bd_tupdesc->natts);
-	nullkeys = alloca(sizeof(ScanKey *) * bd_tupdesc->natts);
-	nkeys = alloca(sizeof(int) * bd_tupdesc->natts);
-	nnullkeys = alloca(sizeof(int) * bd_tupdesc->natts);
+	br_state->keys = palloc(sizeof(ScanKey *) * bd_tupdesc->natts);
+	br_state->nullkeys = palloc(sizeof(ScanKey *) * bd_tupdesc->natts);
+	br_state->nkeys = palloc0(sizeof(int) * bd_tupdesc->natts);
+	br_state->nnullkeys = palloc0(sizeof(int) * bd_tupdesc->natts);
 	for (j=0; j < bd_tupdesc->natts; j++)
 	{
-		keys[j] = alloca(sizeof(ScanKey) * br_state->NumScanKeys);
-		nullkeys[j] = alloca(sizeof(ScanKey) * br_state->NumScanKeys);
+		br_state->keys[j] = palloc(sizeof(ScanKey) * br_state->NumScanKeys);
+		br_state->nullkeys[j] = palloc(sizeof(ScanKey) * br_state->NumScanKeys);
 	}
-	memset(nkeys, 0, sizeof(int) * bd_tupdesc->natts);
-	memset(nnullkeys, 0, sizeof(int) * bd_tupdesc->natts);
 
 	/* Preprocess the scan keys - split them into per-attribute arrays. */
 	for (keyno=0; keyno < br_state->NumScanKeys; keyno++)
@@ -686,200 +903,356 @@ __BrinIndexExecBuildResults(pgstromTaskState *pts)
 												   keyattno - 1)->attcollation));
 
 		/* First time we see this index attribute, so init as needed. */
-		if (consistentFn[keyattno-1].fn_oid == InvalidOid)
+		if (br_state->consistentFn[keyattno-1].fn_oid == InvalidOid)
 		{
 			FmgrInfo   *tmp;
 
-			Assert(nkeys[keyattno-1] == 0 &&
-				   nnullkeys[keyattno-1] == 0);
+			Assert(br_state->nkeys[keyattno-1] == 0 &&
+				   br_state->nnullkeys[keyattno-1] == 0);
 			tmp = index_getprocinfo(br_state->index_rel, keyattno,
 									BRIN_PROCNUM_CONSISTENT);
-			fmgr_info_copy(&consistentFn[keyattno-1], tmp,
+			fmgr_info_copy(&br_state->consistentFn[keyattno-1], tmp,
 						   CurrentMemoryContext);
 		}
 
 		/* Add key to the proper per-attribute array. */
 		if (key->sk_flags & SK_ISNULL)
 		{
-			int		idx = nnullkeys[keyattno-1]++;
-			
-			nullkeys[keyattno-1][idx] = key;
+			int		idx = br_state->nnullkeys[keyattno-1]++;
+
+			br_state->nullkeys[keyattno-1][idx] = key;
 		}
 		else
 		{
-			int		idx = nkeys[keyattno-1]++;
+			int		idx = br_state->nkeys[keyattno-1]++;
 
-			keys[keyattno-1][idx] = key;
+			br_state->keys[keyattno-1][idx] = key;
 		}
 	}
-	/* allocate an initial in-memory tuple, out of the per-range memcxt */
-	dtup = brin_new_memtuple(bdesc);
+	/* allocate an initial in-memory tuple */
+	br_state->dtup = brin_new_memtuple(br_state->brinDesc);
+
+	/* setup a per-range memory context */
+	br_state->per_range_cxt = AllocSetContextCreate(estate->es_query_cxt,
+													"BRIN-index evaluation working",
+													ALLOCSET_DEFAULT_SIZES);
+	MemoryContextSwitchTo(oldcxt);
+
+	br_state->evalIsReady = true;
+}
 
-	/* setup and switch a per-range memory context */
-	per_range_cxt = AllocSetContextCreate(CurrentMemoryContext,
-										  "__ExecBuildBrinIndexResults working",
-										  ALLOCSET_DEFAULT_SIZES);
-	oldcxt = MemoryContextSwitchTo(per_range_cxt);
+/*
+ * __BrinIndexCheckRange
+ *
+ * It compares the scan keys with the summary values stored for the range.
+ */
+static bool
+__BrinIndexCheckRange(pgstromTaskState *pts, uint32_t chunk_id)
+{
+	EState		   *estate = pts->css.ss.ps.state;
+	BrinIndexState *br_state = pts->br_state;
+	BrinDesc	   *bdesc = br_state->brinDesc;
+	TupleDesc		bd_tupdesc = bdesc->bd_tupdesc;
+	BrinTuple	   *__btup;
+	BrinTuple	   *btup = NULL;
+	Size			btupsz = 0;
+	BrinMemTuple   *dtup;
+	OffsetNumber	off;
+	Size			size;
+	int				j, keyno;
+	bool			addrange = true;
+
+	__btup = brinGetTupleForHeapBlock(br_state->brinRevmap,
+									  chunk_id * br_state->pagesPerRange,
+									  &br_state->buffer,
+									  &off,
+									  &size,
+									  BUFFER_LOCK_SHARE,
+									  estate->es_snapshot);
+	if (!__btup)
+		return true;
+	btup = brin_copy_tuple(__btup, size, btup, &btupsz);
+	LockBuffer(br_state->buffer, BUFFER_LOCK_UNLOCK);
 
+	dtup = brin_deform_tuple(bdesc, btup, br_state->dtup);
+	if (dtup->bt_placeholder)
+		return true;
 	/*
-	 * Now scan the revmap.  We start by querying for heap page 0,
-	 * incrementing by the number of pages per range; this gives us a full
-	 * view of the table.
+	 * If scan keys are matched, the page range must be added to the
+	 * results.  We initially assume the range needs to be added; in
+	 * particular this serves the case where there are no keys.
 	 */
-	br_results->nitems = 0;
-	for (chunk_id = 0; chunk_id < br_state->nchunks; chunk_id++)
+	for (j=0; j < bd_tupdesc->natts; j++)
 	{
-		BrinTuple  *__btup;
-		BrinTuple  *btup = NULL;
-		Size		btupsz = 0;
-		OffsetNumber off;
-		Size		size;
-		bool		addrange = true;
-
-		CHECK_FOR_INTERRUPTS();
-
-		MemoryContextResetAndDeleteChildren(per_range_cxt);
-
-		__btup = brinGetTupleForHeapBlock(br_state->brinRevmap,
-										  chunk_id * br_state->pagesPerRange,
-										  &buffer,
-										  &off,
-										  &size,
-										  BUFFER_LOCK_SHARE,
-										  estate->es_snapshot);
-		if (!__btup)
-			goto skip;
-		btup = brin_copy_tuple(__btup, size, btup, &btupsz);
-		LockBuffer(buffer, BUFFER_LOCK_UNLOCK);
-
-		dtup = brin_deform_tuple(bdesc, btup, dtup);
-		if (dtup->bt_placeholder)
-			goto skip;
+		FmgrInfo   *consistentFn = &br_state->consistentFn[j];
+		ScanKey	   *keys = br_state->keys[j];
+		int			nkeys = br_state->nkeys[j];
+		int			nnullkeys = br_state->nnullkeys[j];
+		BrinValues *bval;
+		Datum		add;
+		Oid			collation;
+
 		/*
-		 * Compare scan keys with summary values stored for the range.
-		 * If scan keys are matched, the page range must be added to
-		 * the bitmap.  We initially assume the range needs to be
-		 * added; in particular this serves the case where there are
-		 * no keys.
+		 * skip attributes without any scan keys (both regular and
+		 * IS [NOT] NULL)
 		 */
-		for (j=0; j < bd_tupdesc->natts; j++)
-		{
-			BrinValues *bval;
-			Datum		add;
-			Oid			collation;
-
-			 /*
-			  * skip attributes without any scan keys (both regular and
-			  * IS [NOT] NULL)
-			  */
-			if (nkeys[j] == 0 && nnullkeys[j] == 0)
-				continue;
+		if (nkeys == 0 && nnullkeys == 0)
+			continue;
 
-			bval = &dtup->bt_columns[j];
+		bval = &dtup->bt_columns[j];
 
-			/*
-			  * First check if there are any IS [NOT] NULL scan keys,
-			  * and if we're violating them. In that case we can
-			  * terminate early, without invoking the support function.
-			  */
-			if (bdesc->bd_info[j]->oi_regular_nulls &&
-				!check_null_keys(bval, nullkeys[j], nnullkeys[j]))
-			{
-				addrange = false;
-				break;
-			}
+		/*
+		 * First check if there are any IS [NOT] NULL scan keys,
+		 * and if we're violating them. In that case we can
+		 * terminate early, without invoking the support function.
+		 */
+		if (bdesc->bd_info[j]->oi_regular_nulls &&
+			!check_null_keys(bval, br_state->nullkeys[j], nnullkeys))
+			return false;
 
-			/*
-			 * So either there are no IS [NOT] NULL keys, or all
-			 * passed. If there are no regular scan keys, we're done -
-			 * the page range matches. If there are regular keys, but
-			 * the page range is marked as 'all nulls' it can't
-			 * possibly pass (we're assuming the operators are
-			 * strict).
-			 */
-			if (!nkeys[j])
-				continue;
-			Assert(nkeys[j] > 0 && nkeys[j] <= br_state->NumScanKeys);
+		/*
+		 * So either there are no IS [NOT] NULL keys, or all
+		 * passed. If there are no regular scan keys, we're done -
+		 * the page range matches. If there are regular keys, but
+		 * the page range is marked as 'all nulls' it can't
+		 * possibly pass (we're assuming the operators are
+		 * strict).
+		 */
+		if (nkeys == 0)
+			continue;
+		Assert(nkeys > 0 && nkeys <= br_state->NumScanKeys);
 
-			/* If it is all nulls, it cannot possibly be consistent. */
-			if (bval->bv_allnulls)
-			{
-				addrange = false;
-				break;
-			}
+		/* If it is all nulls, it cannot possibly be consistent. */
+		if (bval->bv_allnulls)
+			return false;
 
-			
-			/*
-			 * Collation from the first key (has to be the same for
-			 * all keys for the same attribute).
-			 */
-			collation = keys[j][0]->sk_collation;
+		/*
+		 * Collation from the first key (has to be the same for
+		 * all keys for the same attribute).
+		 */
+		collation = keys[0]->sk_collation;
 
+		/*
+		 * Check whether the scan key is consistent with the page
+		 * range values; if so, have the pages in the range added
+		 * to the output bitmap.
+		 */
+		if (consistentFn->fn_nargs >= 4)
+		{
+			/* Check all keys at once */
+			add = FunctionCall4Coll(consistentFn,
+									collation,
+									PointerGetDatum(bdesc),
+									PointerGetDatum(bval),
+									PointerGetDatum(keys),
+									Int32GetDatum(nkeys));
+			addrange = DatumGetBool(add);
+		}
+		else
+		{
 			/*
-			 * Check whether the scan key is consistent with the page
-			 * range values; if so, have the pages in the range added
-			 * to the output bitmap.
+			 * Check keys one by one
+			 *
+			 * When there are multiple scan keys, failure to meet
+			 * the criteria for a single one of them is enough to
+			 * discard the range as a whole, so break out of the
+			 * loop as soon as a false return value is obtained.
 			 */
-			if (consistentFn[j].fn_nargs >= 4)
+			for (keyno = 0; keyno < nkeys; keyno++)
 			{
-				/* Check all keys at once */
-				add = FunctionCall4Coll(&consistentFn[j],
-										collation,
+				add = FunctionCall3Coll(consistentFn,
+										keys[keyno]->sk_collation,
 										PointerGetDatum(bdesc),
 										PointerGetDatum(bval),
-										PointerGetDatum(keys[j]),
-										Int32GetDatum(nkeys[j]));
+										PointerGetDatum(keys[keyno]));
 				addrange = DatumGetBool(add);
-			}
-			else
-			{
-				/*
-				 * Check keys one by one
-				 *
-				 * When there are multiple scan keys, failure to meet
-				 * the criteria for a single one of them is enough to
-				 * discard the range as a whole, so break out of the
-				 * loop as soon as a false return value is obtained.
-				 */
-				for (keyno = 0; keyno < nkeys[j]; keyno++)
-				{
-					add = FunctionCall3Coll(&consistentFn[j],
-											keys[j][keyno]->sk_collation,
-											PointerGetDatum(bdesc),
-											PointerGetDatum(bval),
-											PointerGetDatum(keys[j][keyno]));
-					addrange = DatumGetBool(add);
-					if (!addrange)
-						break;
-				}
+				if (!addrange)
+					break;
 			}
 		}
-	skip:
-		if (addrange)
+		if (!addrange)
+			return false;
+	}
+	return true;
+}
+
+/*
+ * __BrinIndexBuildBitmap
+ *
+ * It scans the B-tree index into a TIDBitmap (see MultiExecBitmapIndexScan),
+ * then marks the blocks in the bitmap. Tuples in the blocks are rechecked
+ * by the scan qualifiers on the device, so lossy pages are also fine.
+ */
+static uint32_t
+__BrinIndexBuildBitmap(pgstromTaskState *pts, bool *matched)
+{
+	EState		   *estate = pts->css.ss.ps.state;
+	BrinIndexState *br_state = pts->br_state;
+	IndexScanDesc	iscan;
+	TIDBitmap	   *tbm;
+	TBMIterator	   *iter;
+	TBMIterateResult *tbmres;
+	uint32_t		nfetched = 0;
+
+	memset(matched, 0, sizeof(bool) * br_state->nchunks);
+	tbm = tbm_create(work_mem * 1024L, NULL);
+	iscan = index_beginscan_bitmap(br_state->index_rel,
+								   estate->es_snapshot,
+								   br_state->NumScanKeys);
+	index_rescan(iscan,
+				 br_state->ScanKeys,
+				 br_state->NumScanKeys,
+				 NULL, 0);
+	index_getbitmap(iscan, tbm);
+	index_endscan(iscan);
+
+	iter = tbm_begin_iterate(tbm);
+	while ((tbmres = tbm_iterate(iter)) != NULL)
+	{
+		if (tbmres->blockno < br_state->nchunks &&
+			!matched[tbmres->blockno])
 		{
-			int		idx = br_results->nitems++;
+			matched[tbmres->blockno] = true;
+			nfetched++;
+		}
+	}
+	tbm_end_iterate(iter);
+	tbm_free(tbm);
+
+	return nfetched;
+}
 
-			br_results->chunks[idx] = chunk_id;
+/*
+ * __BrinIndexRunBatch
+ *
+ * The caller must have the batch in BRIN_BATCH__RUNNING state.
+ */
+static void
+__BrinIndexRunBatch(pgstromTaskState *pts, uint32_t batch_id)
+{
+	pgstromSharedState *ps_state = pts->ps_state;
+	BrinIndexState *br_state = pts->br_state;
+	BrinIndexResults *br_results = br_state->brinResults;
+	bool		   *matched = BRIN_INDEX_RESULTS_MATCHED(br_results);
+	uint32_t		chunk_id = batch_id * BRIN_EVAL_BATCH_NRANGES;
+	uint32_t		chunk_end = Min(chunk_id + BRIN_EVAL_BATCH_NRANGES,
+									br_results->nchunks);
+	uint32_t		nfetched = 0;
+
+	if (br_state->is_bitmap)
+	{
+		Assert(batch_id == 0);
+		chunk_end = br_results->nchunks;
+	}
+	PG_TRY();
+	{
+		MemoryContext	oldcxt;
+
+		if (br_state->is_bitmap)
+			nfetched = __BrinIndexBuildBitmap(pts, matched);
+		else
+		{
+			if (!br_state->evalIsReady)
+				__BrinIndexSetupEval(pts);
+			oldcxt = MemoryContextSwitchTo(br_state->per_range_cxt);
+			while (chunk_id < chunk_end)
+			{
+				CHECK_FOR_INTERRUPTS();
+
+				MemoryContextReset(br_state->per_range_cxt);
+				matched[chunk_id] = __BrinIndexCheckRange(pts, chunk_id);
+				if (matched[chunk_id])
+					nfetched++;
+				chunk_id++;
+			}
+			MemoryContextSwitchTo(oldcxt);
 		}
 	}
+	PG_CATCH();
+	{
+		pg_atomic_write_u32(&br_results->batches[batch_id],
+							BRIN_BATCH__FAILED);
+		PG_RE_THROW();
+	}
+	PG_END_TRY();
 	/* update statistics */
-	pg_atomic_fetch_add_u32(&ps_state->brin_index_fetched, br_results->nitems);
+	pg_atomic_fetch_add_u32(&ps_state->brin_index_fetched, nfetched);
 	pg_atomic_fetch_add_u32(&ps_state->brin_index_skipped,
-							br_state->nchunks - br_results->nitems);
-	MemoryContextSwitchTo(oldcxt);
-	MemoryContextDelete(per_range_cxt);
+							chunk_end - batch_id * BRIN_EVAL_BATCH_NRANGES - nfetched);
+	pg_write_barrier();
+	pg_atomic_write_u32(&br_results->batches[batch_id], BRIN_BATCH__DONE);
+}
+
+/*
+ * __BrinIndexTryRunBatch
+ */
+static inline bool
+__BrinIndexTryRunBatch(pgstromTaskState *pts, uint32_t batch_id)
+{
+	BrinIndexResults *br_results = pts->br_state->brinResults;
+	uint32_t	expected = BRIN_BATCH__NOT_YET;
+
+	if (pg_atomic_read_u32(&br_results->batches[batch_id]) == BRIN_BATCH__NOT_YET &&
+		pg_atomic_compare_exchange_u32(&br_results->batches[batch_id],
+									   &expected,
+									   BRIN_BATCH__RUNNING))
+	{
+		__BrinIndexRunBatch(pts, batch_id);
+		return true;
+	}
+	return false;
+}
+
+/*
+ * __BrinIndexWaitForBatch
+ */
+static void
+__BrinIndexWaitForBatch(pgstromTaskState *pts, uint32_t batch_id)
+{
+	BrinIndexResults *br_results = pts->br_state->brinResults;
+
+	for (;;)
+	{
+		uint32_t	status = pg_atomic_read_u32(&br_results->batches[batch_id]);
+		uint32_t	i, lookahead;
 
-	if (buffer != InvalidBuffer)
-		ReleaseBuffer(buffer);
-	pg_memory_barrier();
-	br_results->build_status = 1;
+		if (status == BRIN_BATCH__DONE)
+			break;
+		if (status == BRIN_BATCH__FAILED)
+			elog(ERROR, "failed on BRIN-index evaluation by other workers");
+		if (status == BRIN_BATCH__NOT_YET)
+		{
+			__BrinIndexTryRunBatch(pts, batch_id);
+			continue;
+		}
+		/*
+		 * Other process is evaluating the batch now, so we also run one of
+		 * the following batches in the meantime, or wait for a short while.
+		 */
+		lookahead = Min(batch_id + 8, br_results->nbatches);
+		for (i = batch_id + 1; i < lookahead; i++)
+		{
+			if (__BrinIndexTryRunBatch(pts, i))
+				break;
+		}
+		if (i >= lookahead)
+		{
+			CHECK_FOR_INTERRUPTS();
+			pg_usleep(100L);
+		}
+	}
+	pg_read_barrier();
 }
 
-static inline BrinIndexResults *
-__BrinIndexGetResults(pgstromTaskState *pts)
+/*
+ * __BrinIndexNextRange
+ */
+static bool
+__BrinIndexNextRange(pgstromTaskState *pts, uint32_t *p_chunk_id)
 {
 	BrinIndexState *br_state = pts->br_state;
 	BrinIndexResults *br_results;
+	uint32_t		chunk_id;
 
 	/*
 	 * At the first call of pgstromBrinIndexNextXXXX() at the single process
@@ -888,49 +1261,34 @@ __BrinIndexGetResults(pgstromTaskState *pts)
 	 */
 	if (!br_state->brinResults)
 		pgstromBrinIndexInitDSM(pts, NULL);
-
-	if (br_state->NumRuntimeKeys != 0 &&
-		!br_state->RuntimeKeysIsReady)
-		pgstromBrinIndexExecReset(pts);
+	if (!br_state->RuntimeKeysIsReady)
+		__BrinIndexEvalRuntimeKeys(br_state);
 
 	br_results = br_state->brinResults;
-	if (br_results->build_status <= 0)
+	for (;;)
 	{
-		SpinLockAcquire(&br_results->lock);
-		PG_TRY();
-		{
-			if (br_results->build_status == 0)
-				__BrinIndexExecBuildResults(pts);
-			else if (br_results->build_status < 0)
-				elog(ERROR, "failed on __BrinIndexExecBuildResults by other workers");
-		}
-		PG_CATCH();
-		{
-			br_results->build_status = -1;
-			SpinLockRelease(&br_results->lock);
-			PG_RE_THROW();
-		}
-		PG_END_TRY();
-		Assert(br_results->build_status > 0);
-		SpinLockRelease(&br_results->lock);
+		chunk_id = pg_atomic_fetch_add_u32(&br_results->index, 1);
+		if (chunk_id >= br_results->nchunks)
+			return false;
+		__BrinIndexWaitForBatch(pts, (br_state->is_bitmap
+									  ? 0 : chunk_id / BRIN_EVAL_BATCH_NRANGES));
+		if (BRIN_INDEX_RESULTS_MATCHED(br_results)[chunk_id])
+			break;
 	}
-	return br_results;
+	*p_chunk_id = chunk_id;
+	return true;
 }
 
 TBMIterateResult *
 pgstromBrinIndexNextBlock(pgstromTaskState *pts)
 {
 	BrinIndexState *br_state = pts->br_state;
-	BrinIndexResults *br_results = __BrinIndexGetResults(pts);
-	uint32_t		index;
 	BlockNumber		blockno;
 
 	if (br_state->curr_block_id >= br_state->pagesPerRange)
 	{
-		index = pg_atomic_fetch_add_u32(&br_results->index, 1);
-		if (index >= br_results->nitems)
+		if (!__BrinIndexNextRange(pts, &br_state->curr_chunk_id))
 			return NULL;
-		br_state->curr_chunk_id = br_results->chunks[index];
 		br_state->curr_block_id = 0;
 	}
 	blockno = (br_state->curr_chunk_id * br_state->pagesPerRange +
@@ -948,15 +1306,13 @@ bool
 pgstromBrinIndexNextChunk(pgstromTaskState *pts)
 {
 	BrinIndexState *br_state = pts->br_state;
-	BrinIndexResults *br_results = __BrinIndexGetResults(pts);
-	uint32_t		index;
+	uint32_t		chunk_id;
 
-	index = pg_atomic_fetch_add_u32(&br_results->index, 1);
-	if (index < br_results->nitems)
+	if (__BrinIndexNextRange(pts, &chunk_id))
 	{
 		BlockNumber	pagesPerRange = br_state->pagesPerRange;
 
-		pts->curr_block_num  = br_results->chunks[index] * pagesPerRange;
+		pts->curr_block_num  = chunk_id * pagesPerRange;
 		pts->curr_block_tail = pts->curr_block_num + pagesPerRange;
 		if (pts->curr_block_num >= br_state->nblocks)
 			return false;
@@ -972,6 +1328,8 @@ pgstromBrinIndexExecEnd(pgstromTaskState *pts)
 {
 	BrinIndexState *br_state = pts->br_state;
 
+	if (BufferIsValid(br_state->buffer))
+		ReleaseBuffer(br_state->buffer);
 	if (br_state->brinRevmap)
 		brinRevmapTerminate(br_state->brinRevmap);
 	if (br_state->brinDesc)
@@ -985,7 +1343,7 @@ pgstromBrinIndexEstimateDSM(pgstromTaskState *pts)
 {
 	BrinIndexState *br_state = pts->br_state;
 
-	return MAXALIGN(offsetof(BrinIndexResults, chunks[br_state->nchunks]));
+	return __BrinIndexResultsLength(br_state);
 }
 
 Size
@@ -993,10 +1351,9 @@ pgstromBrinIndexInitDSM(pgstromTaskState *pts, char *dsm_addr)
 {
 	BrinIndexState *br_state = pts->br_state;
 	BrinIndexResults *br_results;
-	Size		dsm_len = 0;
+	Size		dsm_len = __BrinIndexResultsLength(br_state);
+	uint32_t	i;
 
-	dsm_len = MAXALIGN(offsetof(BrinIndexResults,
-								chunks[br_state->nchunks]));
 	if (dsm_addr)
 		br_results = (BrinIndexResults *)dsm_addr;
 	else
@@ -1005,8 +1362,12 @@ pgstromBrinIndexInitDSM(pgstromTaskState *pts, char *dsm_addr)
 
 		br_results = MemoryContextAlloc(estate->es_query_cxt, dsm_len);
 	}
-	memset(br_results, 0, offsetof(BrinIndexResults, chunks));
-	SpinLockInit(&br_results->lock);
+	memset(br_results, 0, dsm_len);
+	pg_atomic_init_u32(&br_results->index, 0);
+	br_results->nchunks = br_state->nchunks;
+	br_results->nbatches = __BrinIndexNumBatches(br_state);
+	for (i=0; i < br_results->nbatches; i++)
+		pg_atomic_init_u32(&br_results->batches[i], BRIN_BATCH__NOT_YET);
 
 	br_state->brinResults = br_results;
 
@@ -1019,8 +1380,7 @@ pgstromBrinIndexAttachDSM(pgstromTaskState *pts, char *dsm_addr)
 	BrinIndexState *br_state = pts->br_state;
 
 	br_state->brinResults = (BrinIndexResults *)dsm_addr;
-	return MAXALIGN(offsetof(BrinIndexResults,
-							 chunks[br_state->nchunks]));
+	return __BrinIndexResultsLength(br_state);
 }
 
 void
@@ -1051,25 +1411,39 @@ pgstromBrinIndexExplain(pgstromTaskState *pts,
 			appendStringInfoString(&buf, ", ");
 		appendStringInfoString(&buf, temp);
 	}
-	ExplainPropertyText("Brin Quals", buf.data, es);
+	if (!brin_state->is_bitmap)
+		ExplainPropertyText("Brin Quals", buf.data, es);
+	else
+	{
+		appendStringInfo(&buf, " on %s",
+						 RelationGetRelationName(brin_state->index_rel));
+		ExplainPropertyText("Bitmap Index Quals", buf.data, es);
+	}
 
 	if (es->analyze)
 	{
+		/* B-tree bitmap counts the blocks, instead of the ranges */
 		if (es->format == EXPLAIN_FORMAT_TEXT)
 		{
 			resetStringInfo(&buf);
 			appendStringInfo(&buf, "fetched=%u, skipped=%u",
 							 pg_atomic_read_u32(&ps_state->brin_index_fetched),
 							 pg_atomic_read_u32(&ps_state->brin_index_skipped));
-			ExplainPropertyText("Brin Stats", buf.data, es);
+			ExplainPropertyText(brin_state->is_bitmap
+								? "Bitmap Index Stats"
+								: "Brin Stats", buf.data, es);
 		}
 		else
 		{
 			count = pg_atomic_read_u32(&ps_state->brin_index_fetched);
-			ExplainPropertyInteger("Brin Stats Fetched", NULL, count, es);
+			ExplainPropertyInteger(brin_state->is_bitmap
+								   ? "Bitmap Index Stats Fetched"
+								   : "Brin Stats Fetched", NULL, count, es);
 
 			count = pg_atomic_read_u32(&ps_state->brin_index_skipped);
-			ExplainPropertyInteger("Brin Stats Skipped", NULL, count, es);
+			ExplainPropertyInteger(brin_state->is_bitmap
+								   ? "Bitmap Index Stats Skipped"
+								   : "Brin Stats Skipped", NULL, count, es);
 		}
 	}
 	pfree(buf.data);
@@ -1087,4 +1461,13 @@ pgstrom_init_brin(void)
 							 PGC_USERSET,
 							 GUC_NOT_IN_SAMPLE,
 							 NULL, NULL, NULL);
+	/* pg_strom.enable_btree_bitmap */
+	DefineCustomBoolVariable("pg_strom.enable_btree_bitmap",
+							 "Enables to use B-tree index to pick up the blocks to be loaded",
+							 NULL,
+							 &pgstrom_enable_btree_bitmap,
+							 true,
+							 PGC_USERSET,
+							 GUC_NOT_IN_SAMPLE,
+							 NULL, NULL, NULL);
 }
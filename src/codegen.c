@@ -18,11 +18,17 @@ static MemoryContext	devinfo_memcxt = NULL;
 static List	   *devtype_info_slot[DEVTYPE_INFO_NSLOTS];
 static List	   *devfunc_info_slot[DEVFUNC_INFO_NSLOTS];
 static List	   *devfunc_code_slot[DEVFUNC_INFO_NSLOTS];	/* by FuncOpCode */
+static bool		pgstrom_enable_codegen_cse = true;		/* GUC */
+static bool		pgstrom_enable_adaptive_quals = true;	/* GUC */
+static bool		pgstrom_enable_gpu_collation = true;	/* GUC */
+static Oid		__device_functions_relid = UINT_MAX;
+static List	   *devcoll_weights_list = NIL;
 
 /* -------- static declarations -------- */
 #define TYPE_OPCODE(NAME,EXTENSION,FLAGS)								\
 	static uint32_t devtype_##NAME##_hash(bool isnull, Datum value);
 #include "xpu_opcodes.h"
+static uint32_t	devtype_array_hash(bool isnull, Datum value);
 
 #define TYPE_OPCODE(NAME,EXTENSION,FLAGS)			\
 	{ EXTENSION, #NAME,	TypeOpCode__##NAME,			\
@@ -274,6 +280,47 @@ build_composite_devtype_info(TypeCacheEntry *tcache, const char *ext_name)
 	return dtype;
 }
 
+/*
+ * __devtype_array_is_binary_comparable
+ *
+ * The device hash and equality of array (xpu_array_datum_hash, array_eq)
+ * work on the binary image of the elements; so, they are only available
+ * if equality of the element type is identical to the binary equality.
+ * (e.g, float8 and numeric are not, because -0 = 0 or 1.0 = 1.00)
+ */
+static bool
+__devtype_array_is_binary_comparable(devtype_info *dtype, Oid coll_id)
+{
+	devtype_info *elem = dtype->type_element;
+
+	if (dtype->type_code != TypeOpCode__array || !elem)
+		return false;
+	switch (elem->type_code)
+	{
+		case TypeOpCode__bool:
+		case TypeOpCode__int1:
+		case TypeOpCode__int2:
+		case TypeOpCode__int4:
+		case TypeOpCode__int8:
+		case TypeOpCode__date:
+		case TypeOpCode__time:
+		case TypeOpCode__timestamp:
+		case TypeOpCode__timestamptz:
+		case TypeOpCode__money:
+		case TypeOpCode__uuid:
+		case TypeOpCode__macaddr:
+		case TypeOpCode__bytea:
+			return true;
+		case TypeOpCode__text:
+			/* non-deterministic collation is not binary comparable */
+			return (!OidIsValid(coll_id) ||
+					get_collation_isdeterministic(coll_id));
+		default:
+			break;
+	}
+	return false;
+}
+
 /*
  * build_array_devtype_info
  */
@@ -302,8 +349,9 @@ build_array_devtype_info(TypeCacheEntry *tcache, const char *ext_name)
 	dtype->type_namespace = get_type_namespace(tcache->type_id);
 	dtype->type_sizeof = sizeof(xpu_array_t);
 	dtype->type_alignof = __alignof__(xpu_array_t);
-	dtype->type_hashfunc = NULL; //devtype_array_hash;
 	dtype->type_element = elem;
+	if (__devtype_array_is_binary_comparable(dtype, InvalidOid))
+		dtype->type_hashfunc = devtype_array_hash;
 	/* type equality functions */
 	dtype->type_eqfunc = get_opcode(tcache->eq_opr);
 	dtype->type_cmpfunc = tcache->cmp_proc;
@@ -860,6 +908,52 @@ devtype_cube_hash(bool isnull, Datum value)
 	return hash_any((unsigned char *)VARDATA_ANY(value), VARSIZE_ANY_EXHDR(value));
 }
 
+/*
+ * devtype_array_hash
+ *
+ * It must be consistent with xpu_array_datum_hash; the hash value is built
+ * from the dimension info, positions of the null elements (only if any),
+ * and the binary image of the not-null elements.
+ */
+static uint32_t
+devtype_array_hash(bool isnull, Datum value)
+{
+	ArrayType  *ar;
+	int			ndim;
+	int			nitems;
+	bits8	   *nullmap;
+	char	   *dataptr;
+	uint32_t	hash;
+
+	if (isnull)
+		return 0;
+	ar = DatumGetArrayTypeP(value);
+	ndim = ARR_NDIM(ar);
+	nitems = ArrayGetNItems(ndim, ARR_DIMS(ar));
+	nullmap = ARR_NULLBITMAP(ar);
+	if (nullmap)
+	{
+		int		i;
+
+		for (i=0; i < nitems; i++)
+		{
+			if ((nullmap[i>>3] & (1<<(i & 7))) == 0)
+				break;
+		}
+		if (i == nitems)
+			nullmap = NULL;		/* no null elements actually */
+	}
+	dataptr = ARR_DATA_PTR(ar);
+
+	hash = hash_any((unsigned char *)ARR_DIMS(ar), sizeof(int) * 2 * ndim) ^ ndim;
+	if (nullmap)
+		hash = ((hash << 1) | (hash >> 31)) ^
+			hash_any((unsigned char *)nullmap, BITMAPLEN(nitems));
+	hash = ((hash << 1) | (hash >> 31)) ^
+		hash_any((unsigned char *)dataptr, ((char *)ar + VARSIZE(ar)) - dataptr);
+	return hash;
+}
+
 /*
  * Built-in device functions/operators
  */
@@ -879,6 +973,91 @@ static struct {
 	{NULL,NULL,0,FuncOpCode__Invalid,0,NULL}
 };
 
+/*
+ * User-defined device functions
+ *
+ * pgstrom.device_functions associates the CUDA C device function with
+ * the SQL function. The device function is compiled with the xpucode by
+ * NVRTC on the GPU service, and the SQL function itself is the CPU
+ * implementation for the CPU fallback.
+ */
+#define Natts_device_functions					4
+#define Anum_device_functions_func_oid			1
+#define Anum_device_functions_func_symbol		2
+#define Anum_device_functions_func_cost			3
+#define Anum_device_functions_func_source		4
+
+static Oid
+get_device_functions_relid(void)
+{
+	if (__device_functions_relid == UINT_MAX)
+	{
+		Oid		namespace_oid = get_namespace_oid("pgstrom", true);
+
+		__device_functions_relid = InvalidOid;
+		if (OidIsValid(namespace_oid))
+			__device_functions_relid = get_relname_relid("device_functions",
+														 namespace_oid);
+	}
+	return __device_functions_relid;
+}
+
+static devfunc_info *
+pgstrom_user_devfunc_build(Oid func_oid,
+						   devtype_info *dtype_rettype,
+						   int func_nargs,
+						   devtype_info **dtype_argtypes)
+{
+	Oid			relid = get_device_functions_relid();
+	Relation	rel;
+	ScanKeyData	skey;
+	SysScanDesc	sscan;
+	HeapTuple	tuple;
+	devfunc_info *dfunc = NULL;
+
+	if (!OidIsValid(relid) || !func_strict(func_oid))
+		return NULL;
+	rel = table_open(relid, AccessShareLock);
+	ScanKeyInit(&skey,
+				Anum_device_functions_func_oid,
+				BTEqualStrategyNumber, F_OIDEQ,
+				ObjectIdGetDatum(func_oid));
+	sscan = systable_beginscan(rel, InvalidOid, false, NULL, 1, &skey);
+	tuple = systable_getnext(sscan);
+	if (HeapTupleIsValid(tuple))
+	{
+		Datum		values[Natts_device_functions];
+		bool		isnull[Natts_device_functions];
+
+		heap_deform_tuple(tuple, RelationGetDescr(rel), values, isnull);
+		if (!isnull[Anum_device_functions_func_symbol - 1] &&
+			!isnull[Anum_device_functions_func_cost - 1] &&
+			!isnull[Anum_device_functions_func_source - 1])
+		{
+			MemoryContext oldcxt = MemoryContextSwitchTo(devinfo_memcxt);
+
+			dfunc = palloc0(offsetof(devfunc_info,
+									 func_argtypes[func_nargs]));
+			dfunc->func_code = FuncOpCode__UserDefinedFunc;
+			dfunc->func_name = get_func_name(func_oid);
+			dfunc->func_oid = func_oid;
+			dfunc->func_rettype = dtype_rettype;
+			dfunc->func_flags = DEVKIND__NVIDIA_GPU | DEVFUNC__USER_DEFINED;
+			dfunc->func_cost = DatumGetInt32(values[Anum_device_functions_func_cost - 1]);
+			dfunc->func_symbol = TextDatumGetCString(values[Anum_device_functions_func_symbol - 1]);
+			dfunc->func_source = TextDatumGetCString(values[Anum_device_functions_func_source - 1]);
+			dfunc->func_nargs = func_nargs;
+			memcpy(dfunc->func_argtypes, dtype_argtypes,
+				   sizeof(devtype_info *) * func_nargs);
+			MemoryContextSwitchTo(oldcxt);
+		}
+	}
+	systable_endscan(sscan);
+	table_close(rel, AccessShareLock);
+
+	return dfunc;
+}
+
 static devfunc_info *
 pgstrom_devfunc_build(Oid func_oid, int func_nargs, Oid *func_argtypes)
 {
@@ -912,7 +1091,7 @@ pgstrom_devfunc_build(Oid func_oid, int func_nargs, Oid *func_argtypes)
 	/* we expect built-in functions are in pg_catalog namespace */
 	fextension = get_extension_name_by_object(ProcedureRelationId, func_oid);
 	if (!fextension && fnamespace != PG_CATALOG_NAMESPACE)
-		goto bailout;
+		goto user_devfunc;
 
 	for (i=0; devfunc_catalog[i].func_name != NULL; i++)
 	{
@@ -985,6 +1164,12 @@ pgstrom_devfunc_build(Oid func_oid, int func_nargs, Oid *func_argtypes)
 			break;
 		}
 	}
+user_devfunc:
+	if (!dfunc)
+		dfunc = pgstrom_user_devfunc_build(func_oid,
+										   dtype_rettype,
+										   func_nargs,
+										   dtype_argtypes);
 bailout:
 	pfree(buf.data);
 	return dfunc;
@@ -1063,7 +1248,9 @@ __pgstrom_devfunc_lookup(Oid func_oid,
 	dfunc->hash = hash;
 	devfunc_info_slot[i] = lappend_cxt(devinfo_memcxt,
 									   devfunc_info_slot[i], dfunc);
-	if (!dfunc->func_is_negative)
+	/* user-defined device functions share the opcode */
+	if (!dfunc->func_is_negative &&
+		dfunc->func_code != FuncOpCode__UserDefinedFunc)
 	{
 		hash = hash_any((unsigned char *)&dfunc->func_code, sizeof(FuncOpCode));
 		i = hash % DEVFUNC_INFO_NSLOTS;
@@ -1103,6 +1290,179 @@ pgstrom_devfunc_lookup(Oid func_oid,
 	return __pgstrom_devfunc_lookup(func_oid, nargs, argtypes, func_collid);
 }
 
+/*
+ * Collation weight table support
+ *
+ * The locale aware device functions (text_lt, bpcharge, ...) can run with
+ * a non-C collation if it can be modelled by kern_collate_weights.
+ * We sort the printable ASCII characters by the real collation, then group
+ * the neighbours that have the same primary weight. The model is validated
+ * towards varstr_cmp() on the short string combinations, and characters
+ * involved in the mismatch (contractions, ignorable characters, ...) are
+ * removed from the table; they shall be handled by CPU fallback.
+ */
+typedef struct
+{
+	Oid			coll_oid;
+	bool		coll_valid;
+	kern_collate_weights weights;
+} devcoll_weights_info;
+
+static int
+__devcoll_qsort_comp(const void *a, const void *b, void *arg)
+{
+	return varstr_cmp((const char *)a, 1,
+					  (const char *)b, 1, *((Oid *)arg));
+}
+
+static bool
+__devcoll_check_model(Oid coll_oid,
+					  const kern_collate_weights *cw,
+					  const char *s1, int len1,
+					  const char *s2, int len2)
+{
+	int		comp;
+	int		model;
+
+	comp = varstr_cmp(s1, len1, s2, len2, coll_oid);
+	if (!__collate_weight_comp(cw, &model, s1, len1, s2, len2))
+		return false;
+	return ((comp < 0 && model < 0) ||
+			(comp > 0 && model > 0) ||
+			(comp == 0 && model == 0));
+}
+
+static bool
+__devcoll_build_weights(Oid coll_oid, kern_collate_weights *cw)
+{
+	char	chars[KERN_COLLATE_NCHARS];
+	int		nerrs[KERN_COLLATE_NCHARS];
+	int		nchars = 0;
+	int		nloops;
+	int		i, j, c;
+
+	for (c = ' '; c <= '~'; c++)
+		chars[nchars++] = c;
+	qsort_arg(chars, nchars, sizeof(char), __devcoll_qsort_comp, &coll_oid);
+
+	for (nloops=0; nloops < 8 && nchars > 0; nloops++)
+	{
+		uint8_t	pweight = 1;
+		uint8_t	tweight = 1;
+		int		max_errs = 0;
+
+		/* assign the primary/tertiary weights */
+		memset(cw, 0, sizeof(kern_collate_weights));
+		for (i=0; i < nchars; i++)
+		{
+			if (i > 0)
+			{
+				char	s1[2] = { chars[i-1], 'b' };
+				char	s2[2] = { chars[i],   'a' };
+
+				/*
+				 * chars[i-1] and chars[i] have the same primary weight,
+				 * if the difference is weaker than the one of 'a' and 'b'.
+				 */
+				if (varstr_cmp(s1, 2, s2, 2, coll_oid) <= 0)
+				{
+					pweight++;
+					tweight = 1;
+				}
+			}
+			cw->primary[(uint8_t)chars[i]] = pweight;
+			cw->tertiary[(uint8_t)chars[i]] = tweight++;
+		}
+		/* validation towards the real collation */
+		memset(nerrs, 0, sizeof(nerrs));
+		for (i=0; i < nchars; i++)
+		{
+			for (j=0; j < nchars; j++)
+			{
+				char	x = chars[i];
+				char	y = chars[j];
+				char	xy[2] = { x, y };
+				char	yx[2] = { y, x };
+				char	xa[2] = { x, 'a' };
+				char	yb[2] = { y, 'b' };
+
+				if (!__devcoll_check_model(coll_oid, cw, &x, 1, &y, 1) ||
+					!__devcoll_check_model(coll_oid, cw, xy, 2, yx, 2) ||
+					!__devcoll_check_model(coll_oid, cw, xy, 2, &x, 1) ||
+					!__devcoll_check_model(coll_oid, cw, xy, 2, &y, 1) ||
+					!__devcoll_check_model(coll_oid, cw, xa, 2, yb, 2))
+				{
+					nerrs[i]++;
+					nerrs[j]++;
+				}
+			}
+		}
+		for (i=0; i < nchars; i++)
+			max_errs = Max(max_errs, nerrs[i]);
+		if (max_errs == 0)
+		{
+			/*
+			 * The model is sufficient, if it still covers the alphanumeric
+			 * characters; elsewhere, most of strings will go to the CPU
+			 * fallback.
+			 */
+			for (c=0; c < KERN_COLLATE_NCHARS; c++)
+			{
+				if (isalnum(c) && cw->primary[c] == 0)
+					return false;
+			}
+			return true;
+		}
+		/* remove the characters that cause the mismatch */
+		for (i=0, j=0; i < nchars; i++)
+		{
+			if (2 * nerrs[i] < max_errs)
+				chars[j++] = chars[i];
+		}
+		nchars = j;
+	}
+	return false;
+}
+
+/*
+ * pgstrom_devcoll_weights_lookup
+ *
+ * It returns the weight table of the supplied collation, or NULL if it is
+ * C collation or cannot be modelled by the weight table.
+ */
+static const kern_collate_weights *
+pgstrom_devcoll_weights_lookup(Oid coll_oid)
+{
+	devcoll_weights_info *dcoll;
+	kern_collate_weights weights;
+	bool		coll_valid = false;
+	ListCell   *lc;
+
+	if (!pgstrom_enable_gpu_collation ||
+		!OidIsValid(coll_oid) ||
+		lc_collate_is_c(coll_oid))
+		return NULL;
+	foreach (lc, devcoll_weights_list)
+	{
+		dcoll = lfirst(lc);
+		if (dcoll->coll_oid == coll_oid)
+			return (dcoll->coll_valid ? &dcoll->weights : NULL);
+	}
+	/* non-deterministic collation never compare the strings by binary */
+	memset(&weights, 0, sizeof(kern_collate_weights));
+	if (get_collation_isdeterministic(coll_oid))
+		coll_valid = __devcoll_build_weights(coll_oid, &weights);
+
+	dcoll = MemoryContextAllocZero(devinfo_memcxt,
+								   sizeof(devcoll_weights_info));
+	dcoll->coll_oid = coll_oid;
+	dcoll->coll_valid = coll_valid;
+	memcpy(&dcoll->weights, &weights, sizeof(kern_collate_weights));
+	devcoll_weights_list = lappend_cxt(devinfo_memcxt,
+									   devcoll_weights_list, dcoll);
+	return (coll_valid ? &dcoll->weights : NULL);
+}
+
 static devfunc_info *
 devfunc_lookup_by_opcode(FuncOpCode func_code)
 {
@@ -1128,6 +1488,9 @@ devfunc_lookup_by_opcode(FuncOpCode func_code)
 devfunc_info *
 devtype_lookup_equal_func(devtype_info *dtype, Oid coll_id)
 {
+	if (dtype->type_code == TypeOpCode__array &&
+		!__devtype_array_is_binary_comparable(dtype, coll_id))
+		return NULL;
 	if (OidIsValid(dtype->type_eqfunc))
 	{
 		Oid		argtypes[2];
@@ -1494,150 +1857,735 @@ codegen_var_expression(codegen_context *context,
 	return 0;
 }
 
+/*
+ * codegen_regex_expression
+ *
+ * Regular expression operators take a constant pattern; it is compiled to
+ * DFA and embedded to the kern_expression, then only the string argument
+ * is evaluated on the device.
+ */
 static int
-__codegen_func_expression(codegen_context *context,
-						  StringInfo buf,
-						  int curr_depth,
-						  Oid func_oid,
-						  List *func_args,
-						  Oid func_collid)
+codegen_regex_expression(codegen_context *context,
+						 StringInfo buf,
+						 int curr_depth,
+						 devfunc_info *dfunc,
+						 List *func_args,
+						 Oid func_collid,
+						 bool icase)
 {
-	devfunc_info   *dfunc;
-	devtype_info   *dtype;
-	kern_expression	kexp;
-	int				pos = -1;
-	ListCell	   *lc;
-
-	dfunc = pgstrom_devfunc_lookup(func_oid, func_args, func_collid);
-	if (!dfunc ||
-		(dfunc->func_flags & context->required_flags) != context->required_flags)
-		__Elog("function %s is not supported on the target device",
-			   format_procedure(func_oid));
-	dtype = dfunc->func_rettype;
-	context->device_cost += dfunc->func_cost;
-
-	memset(&kexp, 0, sizeof(kexp));
-	kexp.exptype = dtype->type_code;
-	kexp.expflags = context->kexp_flags;
-	kexp.opcode = dfunc->func_code;
-	kexp.nr_args = list_length(func_args);
-	kexp.args_offset = SizeOfKernExpr(0);
+	Expr	   *str_arg;
+	Expr	   *pat_arg;
+	text	   *pattern;
+	kern_expression *kexp;
+	const char *errmsg = NULL;
+	int			pos = -1;
+
+	if (list_length(func_args) != 2)
+		__Elog("unexpected number of arguments for %s", dfunc->func_name);
+	str_arg = linitial(func_args);
+	pat_arg = lsecond(func_args);
+	while (IsA(pat_arg, RelabelType))
+		pat_arg = ((RelabelType *)pat_arg)->arg;
+	if (!IsA(pat_arg, Const) || ((Const *)pat_arg)->constisnull)
+		__Elog("regular expression pattern must be a non-null constant");
+	if (OidIsValid(func_collid) && !get_collation_isdeterministic(func_collid))
+		__Elog("nondeterministic collations are not supported for regular expressions");
+
+	pattern = DatumGetTextPP(((Const *)pat_arg)->constvalue);
+	kexp = pgstrom_regex_build_dfa(VARDATA_ANY(pattern),
+								   VARSIZE_ANY_EXHDR(pattern),
+								   icase, &errmsg);
+	if (!kexp)
+		__Elog("regular expression pattern is not supported on the device: %s",
+			   errmsg);
+	kexp->exptype = dfunc->func_rettype->type_code;
+	kexp->expflags = context->kexp_flags;
+	kexp->opcode = dfunc->func_code;
+	kexp->nr_args = 1;
 	if (buf)
-		pos = __appendBinaryStringInfo(buf, &kexp, SizeOfKernExpr(0));
-	foreach (lc, func_args)
-	{
-		Expr   *arg = lfirst(lc);
-
-		if (codegen_expression_walker(context, buf, curr_depth, arg) < 0)
-			return -1;
-	}
+		pos = __appendBinaryStringInfo(buf, kexp, kexp->args_offset);
+	pfree(kexp);
+	if (codegen_expression_walker(context, buf, curr_depth, str_arg) < 0)
+		return -1;
 	if (buf)
 		__appendKernExpMagicAndLength(buf, pos);
 	return 0;
 }
 
+/*
+ * codegen_jsonpath_expression
+ *
+ * jsonb_path_exists() / jsonb_path_match() and @? / @@ operators take
+ * a constant jsonpath; it is compiled to a small program and embedded to
+ * the kern_expression, then only the jsonb argument is evaluated on the
+ * device. Strict mode, variables, item methods, arithmetic operators and
+ * so on are not supported, so CPU evaluates them.
+ */
+#define JSONPATH_MAX_NEST		8
+
+typedef struct
+{
+	kern_jsonpath_item items[KJSP_MAX_ITEMS];
+	int			nitems;
+	StringInfoData consts;
+	const char *errmsg;
+} jsonpath_compile_state;
+
 static int
-codegen_func_expression(codegen_context *context,
-						StringInfo buf, int curr_depth,
-						FuncExpr *func)
+__jsonpath_unsupported(jsonpath_compile_state *jcs, const char *errmsg)
 {
-	return __codegen_func_expression(context,
-									 buf,
-									 curr_depth,
-									 func->funcid,
-									 func->args,
-									 func->inputcollid);
+	if (!jcs->errmsg)
+		jcs->errmsg = errmsg;
+	return -1;
 }
 
 static int
-codegen_oper_expression(codegen_context *context,
-						StringInfo buf, int curr_depth,
-						OpExpr *oper)
+__jsonpath_alloc_item(jsonpath_compile_state *jcs, int type)
 {
-	return __codegen_func_expression(context,
-									 buf,
-									 curr_depth,
-									 get_opcode(oper->opno),
-									 oper->args,
-									 oper->inputcollid);
+	kern_jsonpath_item *jpi;
+
+	if (jcs->nitems >= KJSP_MAX_ITEMS)
+		return __jsonpath_unsupported(jcs, "too complicated jsonpath");
+	jpi = &jcs->items[jcs->nitems];
+	memset(jpi, 0, sizeof(kern_jsonpath_item));
+	jpi->type = type;
+	jpi->next = -1;
+	jpi->arg1 = -1;
+	jpi->arg2 = -1;
+	return jcs->nitems++;
 }
 
-static int
-codegen_distinct_expression(codegen_context *context,
-							StringInfo buf, int curr_depth,
-							DistinctExpr *expr)
+static uint32_t
+__jsonpath_append_const(jsonpath_compile_state *jcs, const void *data, int len)
 {
-	kern_expression	kexp;
-	int		pos = -1;
+	uint32_t	offset;
 
-	Assert(exprType((Node *)expr) == BOOLOID);
-	memset(&kexp, 0, sizeof(kexp));
-	kexp.exptype = TypeOpCode__bool;
-	kexp.expflags = context->kexp_flags;
-	kexp.opcode = FuncOpCode__DistinctFrom;
-	kexp.nr_args = 1;
-	kexp.args_offset = SizeOfKernExpr(0);
-	if (buf)
-		pos = __appendBinaryStringInfo(buf, &kexp, SizeOfKernExpr(0));
-	if (codegen_oper_expression(context, buf, curr_depth, expr) < 0)
-		return -1;
-	if (buf)
-		__appendKernExpMagicAndLength(buf, pos);
-	return 0;
+	while (jcs->consts.len != MAXALIGN(jcs->consts.len))
+		appendStringInfoChar(&jcs->consts, '\0');
+	offset = jcs->consts.len;
+	appendBinaryStringInfo(&jcs->consts, data, len);
+	return offset;
 }
 
+static int	__jsonpath_compile_pred(jsonpath_compile_state *jcs,
+									JsonPathItem *v, bool in_filter, int nest);
+
 static int
-codegen_bool_expression(codegen_context *context,
-						StringInfo buf, int curr_depth,
-						BoolExpr *b)
+__jsonpath_compile_path(jsonpath_compile_state *jcs,
+						JsonPathItem *v, bool in_filter, int nest)
 {
-	kern_expression	kexp;
-	int				pos = -1;
-	ListCell	   *lc;
+	JsonPathItem curr = *v;
+	JsonPathItem next;
+	int			head = -1;
+	int			prev = -1;
 
-	memset(&kexp, 0, sizeof(kexp));
-	switch (b->boolop)
-	{
-		case AND_EXPR:
-			kexp.opcode = FuncOpCode__BoolExpr_And;
-			kexp.nr_args = list_length(b->args);
-			if (kexp.nr_args < 2)
-				__Elog("BoolExpr(AND) must have 2 or more arguments");
-			break;
-		case OR_EXPR:
-			kexp.opcode = FuncOpCode__BoolExpr_Or;
-			kexp.nr_args = list_length(b->args);
-			if (kexp.nr_args < 2)
-				__Elog("BoolExpr(OR) must have 2 or more arguments");
-			break;
-		case NOT_EXPR:
-			kexp.opcode = FuncOpCode__BoolExpr_Not;
-			kexp.nr_args = list_length(b->args);
-			if (kexp.nr_args != 1)
-				__Elog("BoolExpr(OR) must not have multiple arguments");
-			break;
-		default:
-			__Elog("BoolExpr has unknown bool operation (%d)", (int)b->boolop);
-	}
-	kexp.exptype = TypeOpCode__bool;
-	kexp.expflags = context->kexp_flags;
-	kexp.args_offset = SizeOfKernExpr(0);
-	if (buf)
-		pos = __appendBinaryStringInfo(buf, &kexp, SizeOfKernExpr(0));
-	foreach (lc, b->args)
+	for (;;)
 	{
-		Expr   *arg = lfirst(lc);
-
-		if (codegen_expression_walker(context, buf, curr_depth, arg) < 0)
-			return -1;
-	}
-	if (buf)
-		__appendKernExpMagicAndLength(buf, pos);
-	return 0;
-}
+		int		index;
 
-static int
-codegen_nulltest_expression(codegen_context *context,
+		if (prev < 0
+			? (curr.type != jpiRoot && (curr.type != jpiCurrent || !in_filter))
+			: (curr.type == jpiRoot || curr.type == jpiCurrent))
+			return __jsonpath_unsupported(jcs, "jsonpath must begin with $ or @");
+		switch (curr.type)
+		{
+			case jpiRoot:
+				index = __jsonpath_alloc_item(jcs, KJSP_ITEM__ROOT);
+				break;
+			case jpiCurrent:
+				index = __jsonpath_alloc_item(jcs, KJSP_ITEM__CURRENT);
+				break;
+			case jpiKey:
+				{
+					int32	keylen;
+					char   *key = jspGetString(&curr, &keylen);
+
+					index = __jsonpath_alloc_item(jcs, KJSP_ITEM__KEY);
+					if (index >= 0)
+					{
+						jcs->items[index].offset = __jsonpath_append_const(jcs, key, keylen);
+						jcs->items[index].length = keylen;
+					}
+				}
+				break;
+			case jpiAnyKey:
+				index = __jsonpath_alloc_item(jcs, KJSP_ITEM__ANY_KEY);
+				break;
+			case jpiAnyArray:
+				index = __jsonpath_alloc_item(jcs, KJSP_ITEM__ANY_ARRAY);
+				break;
+			case jpiIndexArray:
+				{
+					JsonPathItem from, to;
+					char	   *str;
+
+					if (curr.content.array.nelems != 1 ||
+						jspGetArraySubscript(&curr, &from, &to, 0) ||
+						from.type != jpiNumeric ||
+						jspHasNext(&from))
+						return __jsonpath_unsupported(jcs, "only a constant array subscript is supported");
+					str = DatumGetCString(DirectFunctionCall1(numeric_out,
+															  NumericGetDatum(jspGetNumeric(&from))));
+					if (strlen(str) == 0 || strlen(str) > 9 ||
+						strspn(str, "0123456789") != strlen(str))
+						return __jsonpath_unsupported(jcs, "array subscript must be a non-negative integer");
+					index = __jsonpath_alloc_item(jcs, KJSP_ITEM__INDEX_ARRAY);
+					if (index >= 0)
+						jcs->items[index].ival = atoi(str);
+				}
+				break;
+			case jpiFilter:
+				{
+					JsonPathItem arg;
+					int			pred;
+
+					if (nest >= JSONPATH_MAX_NEST)
+						return __jsonpath_unsupported(jcs, "too deeply nested jsonpath filters");
+					jspGetArg(&curr, &arg);
+					pred = __jsonpath_compile_pred(jcs, &arg, true, nest+1);
+					if (pred < 0)
+						return -1;
+					index = __jsonpath_alloc_item(jcs, KJSP_ITEM__FILTER);
+					if (index >= 0)
+						jcs->items[index].arg1 = pred;
+				}
+				break;
+			default:
+				return __jsonpath_unsupported(jcs, "unsupported jsonpath accessor");
+		}
+		if (index < 0)
+			return -1;
+		if (prev < 0)
+			head = index;
+		else
+			jcs->items[prev].next = index;
+		prev = index;
+
+		if (!jspGetNext(&curr, &next))
+			break;
+		curr = next;
+	}
+	return head;
+}
+
+static int
+__jsonpath_compile_pred(jsonpath_compile_state *jcs,
+						JsonPathItem *v, bool in_filter, int nest)
+{
+	JsonPathItem larg, rarg;
+	JsonPathItem *path_arg, *const_arg;
+	kern_jsonpath_item *jpi;
+	int			lpos, rpos;
+	int			cmp_op;
+	int			index;
+
+	if (jspHasNext(v))
+		return __jsonpath_unsupported(jcs, "unsupported jsonpath accessor on predicate");
+	switch (v->type)
+	{
+		case jpiAnd:
+		case jpiOr:
+			jspGetLeftArg(v, &larg);
+			jspGetRightArg(v, &rarg);
+			lpos = __jsonpath_compile_pred(jcs, &larg, in_filter, nest);
+			if (lpos < 0)
+				return -1;
+			rpos = __jsonpath_compile_pred(jcs, &rarg, in_filter, nest);
+			if (rpos < 0)
+				return -1;
+			index = __jsonpath_alloc_item(jcs, (v->type == jpiAnd
+												? KJSP_ITEM__AND
+												: KJSP_ITEM__OR));
+			if (index >= 0)
+			{
+				jcs->items[index].arg1 = lpos;
+				jcs->items[index].arg2 = rpos;
+			}
+			return index;
+
+		case jpiNot:
+		case jpiIsUnknown:
+			jspGetArg(v, &larg);
+			lpos = __jsonpath_compile_pred(jcs, &larg, in_filter, nest);
+			if (lpos < 0)
+				return -1;
+			index = __jsonpath_alloc_item(jcs, (v->type == jpiNot
+												? KJSP_ITEM__NOT
+												: KJSP_ITEM__IS_UNKNOWN));
+			if (index >= 0)
+				jcs->items[index].arg1 = lpos;
+			return index;
+
+		case jpiExists:
+			jspGetArg(v, &larg);
+			lpos = __jsonpath_compile_path(jcs, &larg, in_filter, nest);
+			if (lpos < 0)
+				return -1;
+			index = __jsonpath_alloc_item(jcs, KJSP_ITEM__EXISTS);
+			if (index >= 0)
+				jcs->items[index].arg1 = lpos;
+			return index;
+
+		case jpiEqual:			cmp_op = KJSP_CMP__EQ; break;
+		case jpiNotEqual:		cmp_op = KJSP_CMP__NE; break;
+		case jpiLess:			cmp_op = KJSP_CMP__LT; break;
+		case jpiLessOrEqual:	cmp_op = KJSP_CMP__LE; break;
+		case jpiGreater:		cmp_op = KJSP_CMP__GT; break;
+		case jpiGreaterOrEqual:	cmp_op = KJSP_CMP__GE; break;
+		default:
+			return __jsonpath_unsupported(jcs, "unsupported jsonpath predicate");
+	}
+	/* comparison between a path and a constant */
+	jspGetLeftArg(v, &larg);
+	jspGetRightArg(v, &rarg);
+#define __JSONPATH_IS_CONST(x)										(((x)->type == jpiNull || (x)->type == jpiBool ||				  (x)->type == jpiNumeric || (x)->type == jpiString) &&			 !jspHasNext(x))
+	if (__JSONPATH_IS_CONST(&rarg) && !__JSONPATH_IS_CONST(&larg))
+	{
+		path_arg = &larg;
+		const_arg = &rarg;
+	}
+	else if (__JSONPATH_IS_CONST(&larg) && !__JSONPATH_IS_CONST(&rarg))
+	{
+		path_arg = &rarg;
+		const_arg = &larg;
+	}
+	else
+		return __jsonpath_unsupported(jcs, "jsonpath comparison must be between a path and a constant");
+#undef __JSONPATH_IS_CONST
+	lpos = __jsonpath_compile_path(jcs, path_arg, in_filter, nest);
+	if (lpos < 0)
+		return -1;
+	index = __jsonpath_alloc_item(jcs, KJSP_ITEM__COMPARE);
+	if (index < 0)
+		return -1;
+	jpi = &jcs->items[index];
+	jpi->cmp_op = cmp_op;
+	jpi->cmp_swap = (const_arg == &larg);
+	jpi->arg1 = lpos;
+	switch (const_arg->type)
+	{
+		case jpiNull:
+			jpi->cmp_kind = KJSP_VALUE__NULL;
+			break;
+		case jpiBool:
+			jpi->cmp_kind = (jspGetBool(const_arg)
+							 ? KJSP_VALUE__TRUE
+							 : KJSP_VALUE__FALSE);
+			break;
+		case jpiNumeric:
+			{
+				Numeric		num = jspGetNumeric(const_arg);
+
+				jpi->cmp_kind = KJSP_VALUE__NUMERIC;
+				jpi->offset = __jsonpath_append_const(jcs, num, VARSIZE(num));
+				jpi->length = VARSIZE(num);
+			}
+			break;
+		case jpiString:
+			{
+				int32	len;
+				char   *str = jspGetString(const_arg, &len);
+
+				/* ordering of strings by binary comparison */
+				if (cmp_op != KJSP_CMP__EQ &&
+					cmp_op != KJSP_CMP__NE &&
+					GetDatabaseEncoding() != PG_UTF8 &&
+					GetDatabaseEncoding() != PG_SQL_ASCII)
+					return __jsonpath_unsupported(jcs, "string comparison needs encoding conversion");
+				jpi = &jcs->items[index];
+				jpi->cmp_kind = KJSP_VALUE__STRING;
+				jpi->offset = __jsonpath_append_const(jcs, str, len);
+				jpi->length = len;
+			}
+			break;
+		default:
+			return __jsonpath_unsupported(jcs, "unsupported jsonpath constant");
+	}
+	return index;
+}
+
+static int
+codegen_jsonpath_expression(codegen_context *context,
+							StringInfo buf,
+							int curr_depth,
+							Oid func_oid,
+							List *func_args)
+{
+	jsonpath_compile_state jcs;
+	JsonPath   *jsp;
+	JsonPathItem v;
+	Expr	   *json_arg;
+	Const	   *path_arg;
+	bool		is_match = (func_oid == F_JSONB_PATH_MATCH ||
+							func_oid == F_JSONB_PATH_MATCH_OPR);
+	kern_expression *kexp;
+	size_t		items_sz;
+	size_t		sz;
+	int			top;
+	int			pos = -1;
+
+	if (list_length(func_args) == 4)
+	{
+		Const	   *vars = lthird(func_args);
+		Const	   *silent = lfourth(func_args);
+
+		/* jsonpath variables must be an object, even if unused */
+		if (!IsA(vars, Const) || vars->constisnull ||
+			!JB_ROOT_IS_OBJECT(DatumGetJsonbP(vars->constvalue)) ||
+			!IsA(silent, Const) || silent->constisnull)
+			__Elog("jsonpath variables and silent flag must be constant");
+	}
+	else if (list_length(func_args) != 2)
+		__Elog("unexpected number of arguments for %s",
+			   format_procedure(func_oid));
+	json_arg = linitial(func_args);
+	path_arg = lsecond(func_args);
+	if (exprType((Node *)json_arg) != JSONBOID ||
+		!IsA(path_arg, Const) || path_arg->constisnull)
+		__Elog("jsonpath must be a non-null constant");
+
+	jsp = DatumGetJsonPathP(path_arg->constvalue);
+	if ((jsp->header & JSONPATH_LAX) == 0)
+		__Elog("strict mode jsonpath is not supported on the device");
+	memset(&jcs, 0, sizeof(jsonpath_compile_state));
+	initStringInfo(&jcs.consts);
+	jspInit(&v, jsp);
+	if (is_match)
+		top = __jsonpath_compile_pred(&jcs, &v, false, 0);
+	else
+		top = __jsonpath_compile_path(&jcs, &v, false, 0);
+	if (top < 0)
+		__Elog("jsonpath is not supported on the device: %s", jcs.errmsg);
+
+	/* constants are located next to the items */
+	items_sz = MAXALIGN(sizeof(kern_jsonpath_item) * jcs.nitems);
+	for (int i=0; i < jcs.nitems; i++)
+	{
+		kern_jsonpath_item *jpi = &jcs.items[i];
+
+		if (jpi->type == KJSP_ITEM__KEY ||
+			(jpi->type == KJSP_ITEM__COMPARE &&
+			 (jpi->cmp_kind == KJSP_VALUE__NUMERIC ||
+			  jpi->cmp_kind == KJSP_VALUE__STRING)))
+			jpi->offset += items_sz;
+	}
+	sz = MAXALIGN(offsetof(kern_expression, u.jsonpath.data) +
+				  items_sz + jcs.consts.len);
+	kexp = palloc0(sz);
+	kexp->exptype     = TypeOpCode__bool;
+	kexp->expflags    = context->kexp_flags;
+	kexp->opcode      = (is_match
+						 ? FuncOpCode__jsonb_path_match_prog
+						 : FuncOpCode__jsonb_path_exists_prog);
+	kexp->nr_args     = 1;
+	kexp->args_offset = sz;
+	kexp->u.jsonpath.nitems = jcs.nitems;
+	kexp->u.jsonpath.top = top;
+	memcpy(kexp->u.jsonpath.data, jcs.items,
+		   sizeof(kern_jsonpath_item) * jcs.nitems);
+	memcpy(kexp->u.jsonpath.data + items_sz, jcs.consts.data, jcs.consts.len);
+	context->device_cost += 100 + 10 * jcs.nitems;
+	if (buf)
+		pos = __appendBinaryStringInfo(buf, kexp, sz);
+	pfree(kexp);
+	pfree(jcs.consts.data);
+	if (codegen_expression_walker(context, buf, curr_depth, json_arg) < 0)
+		return -1;
+	if (buf)
+		__appendKernExpMagicAndLength(buf, pos);
+	return 0;
+}
+
+/*
+ * __devfunc_ascii_case_mapping_is_safe
+ *
+ * lower() and upper() convert ASCII characters only on the device (text with
+ * non-ASCII characters is processed by CPU-fallback). Case mapping of ASCII
+ * characters is common to any locales except for Turkish and Azerbaijani,
+ * that have the dotted and dotless 'i'.
+ */
+static bool
+__devfunc_ascii_case_mapping_is_safe(Oid collid)
+{
+	const char *lc_name;
+
+	if (!OidIsValid(collid) || lc_ctype_is_c(collid))
+		return true;
+	if (collid == DEFAULT_COLLATION_OID)
+		lc_name = setlocale(LC_CTYPE, NULL);
+	else
+		lc_name = get_collation_name(collid);
+	if (!lc_name)
+		return false;
+	if (pg_strncasecmp(lc_name, "tr", 2) == 0 ||
+		pg_strncasecmp(lc_name, "az", 2) == 0)
+		return false;
+	return true;
+}
+
+/*
+ * codegen_user_devfunc_expression
+ *
+ * The symbol and source of the user-defined device function are embedded
+ * in the kern_expression, then the JIT compiler on the GPU service emits
+ * them into the module.
+ */
+static int
+codegen_user_devfunc_expression(codegen_context *context,
+								StringInfo buf,
+								int curr_depth,
+								devfunc_info *dfunc,
+								List *func_args)
+{
+	kern_expression *kexp;
+	size_t		symbol_len = strlen(dfunc->func_symbol);
+	size_t		source_len = strlen(dfunc->func_source);
+	size_t		head_sz;
+	int			pos = -1;
+	ListCell   *lc;
+
+	head_sz = MAXALIGN(offsetof(kern_expression, u.udf.data) +
+					   symbol_len + source_len + 2);
+	kexp = palloc0(head_sz);
+	kexp->exptype = dfunc->func_rettype->type_code;
+	kexp->expflags = context->kexp_flags;
+	kexp->opcode = dfunc->func_code;
+	kexp->nr_args = list_length(func_args);
+	kexp->args_offset = head_sz;
+	kexp->u.udf.func_oid = dfunc->func_oid;
+	kexp->u.udf.source_len = source_len;
+	memcpy(kexp->u.udf.data, dfunc->func_symbol, symbol_len);
+	memcpy(kexp->u.udf.data + symbol_len + 1, dfunc->func_source, source_len);
+	if (buf)
+		pos = __appendBinaryStringInfo(buf, kexp, head_sz);
+	pfree(kexp);
+	foreach (lc, func_args)
+	{
+		Expr   *arg = lfirst(lc);
+
+		if (codegen_expression_walker(context, buf, curr_depth, arg) < 0)
+			return -1;
+	}
+	if (buf)
+		__appendKernExpMagicAndLength(buf, pos);
+	/* GPU service has to build the JIT module for the session */
+	context->extra_flags |= DEVFUNC__USER_DEFINED;
+	return 0;
+}
+
+static int
+__codegen_func_expression(codegen_context *context,
+						  StringInfo buf,
+						  int curr_depth,
+						  Oid func_oid,
+						  List *func_args,
+						  Oid func_collid)
+{
+	devfunc_info   *dfunc;
+	devtype_info   *dtype;
+	kern_expression	kexp;
+	const kern_collate_weights *cweights = NULL;
+	int				pos = -1;
+	ListCell	   *lc;
+
+	/* jsonpath is not a device type, but compiled to the device program */
+	if (func_oid == F_JSONB_PATH_EXISTS ||
+		func_oid == F_JSONB_PATH_EXISTS_OPR ||
+		func_oid == F_JSONB_PATH_MATCH ||
+		func_oid == F_JSONB_PATH_MATCH_OPR)
+		return codegen_jsonpath_expression(context, buf, curr_depth,
+										   func_oid, func_args);
+
+	dfunc = pgstrom_devfunc_lookup(func_oid, func_args, func_collid);
+	if (!dfunc)
+	{
+		/* locale aware function with non-C collation? */
+		cweights = pgstrom_devcoll_weights_lookup(func_collid);
+		if (cweights)
+		{
+			dfunc = pgstrom_devfunc_lookup(func_oid, func_args, InvalidOid);
+			if (dfunc && (dfunc->func_flags & DEVFUNC__LOCALE_AWARE) == 0)
+				dfunc = NULL;
+		}
+	}
+	if (!dfunc ||
+		(dfunc->func_flags & context->required_flags) != context->required_flags)
+		__Elog("function %s is not supported on the target device",
+			   format_procedure(func_oid));
+	dtype = dfunc->func_rettype;
+	context->device_cost += dfunc->func_cost;
+
+	switch (dfunc->func_code)
+	{
+		case FuncOpCode__UserDefinedFunc:
+			return codegen_user_devfunc_expression(context, buf, curr_depth,
+												   dfunc, func_args);
+		case FuncOpCode__textregexeq:
+		case FuncOpCode__textregexne:
+		case FuncOpCode__regexp_like:
+			return codegen_regex_expression(context, buf, curr_depth, dfunc,
+											func_args, func_collid, false);
+		case FuncOpCode__texticregexeq:
+		case FuncOpCode__texticregexne:
+			return codegen_regex_expression(context, buf, curr_depth, dfunc,
+											func_args, func_collid, true);
+		case FuncOpCode__lower:
+		case FuncOpCode__upper:
+			if (!__devfunc_ascii_case_mapping_is_safe(func_collid))
+				__Elog("function %s is not supported on the collation '%s'",
+					   format_procedure(func_oid),
+					   get_collation_name(func_collid));
+			/* fall through */
+		case FuncOpCode__array_eq:
+		case FuncOpCode__array_ne:
+			if (!__devtype_array_is_binary_comparable(dfunc->func_argtypes[0],
+													  func_collid) ||
+				!__devtype_array_is_binary_comparable(dfunc->func_argtypes[1],
+													  func_collid))
+				__Elog("function %s is not supported on the array of %s",
+					   format_procedure(func_oid),
+					   format_type_be(exprType(linitial(func_args))));
+			break;
+		case FuncOpCode__textcat:
+		case FuncOpCode__concat:
+		case FuncOpCode__replace:
+		case FuncOpCode__network_host:
+		case FuncOpCode__network_show:
+			/* these functions build the result on the kcxt buffer */
+			context->extra_bufsz = Max(context->extra_bufsz,
+									   pgstrom_gpu_detoast_buffer_kb * 1024);
+			break;
+		default:
+			break;
+	}
+	memset(&kexp, 0, sizeof(kexp));
+	kexp.exptype = dtype->type_code;
+	kexp.expflags = context->kexp_flags;
+	kexp.opcode = dfunc->func_code;
+	kexp.nr_args = list_length(func_args);
+	kexp.args_offset = SizeOfKernExpr(0);
+	if (cweights)
+	{
+		kexp.expflags |= KEXP_FLAG__COLLATE_WEIGHTS;
+		memcpy(&kexp.u.coll.weights, cweights, sizeof(kern_collate_weights));
+		kexp.args_offset = offsetof(kern_expression, u.coll.data);
+	}
+	if (buf)
+		pos = __appendBinaryStringInfo(buf, &kexp, kexp.args_offset);
+	foreach (lc, func_args)
+	{
+		Expr   *arg = lfirst(lc);
+
+		if (codegen_expression_walker(context, buf, curr_depth, arg) < 0)
+			return -1;
+	}
+	if (buf)
+		__appendKernExpMagicAndLength(buf, pos);
+	return 0;
+}
+
+static int
+codegen_func_expression(codegen_context *context,
+						StringInfo buf, int curr_depth,
+						FuncExpr *func)
+{
+	return __codegen_func_expression(context,
+									 buf,
+									 curr_depth,
+									 func->funcid,
+									 func->args,
+									 func->inputcollid);
+}
+
+static int
+codegen_oper_expression(codegen_context *context,
+						StringInfo buf, int curr_depth,
+						OpExpr *oper)
+{
+	return __codegen_func_expression(context,
+									 buf,
+									 curr_depth,
+									 get_opcode(oper->opno),
+									 oper->args,
+									 oper->inputcollid);
+}
+
+static int
+codegen_distinct_expression(codegen_context *context,
+							StringInfo buf, int curr_depth,
+							DistinctExpr *expr)
+{
+	kern_expression	kexp;
+	int		pos = -1;
+
+	Assert(exprType((Node *)expr) == BOOLOID);
+	memset(&kexp, 0, sizeof(kexp));
+	kexp.exptype = TypeOpCode__bool;
+	kexp.expflags = context->kexp_flags;
+	kexp.opcode = FuncOpCode__DistinctFrom;
+	kexp.nr_args = 1;
+	kexp.args_offset = SizeOfKernExpr(0);
+	if (buf)
+		pos = __appendBinaryStringInfo(buf, &kexp, SizeOfKernExpr(0));
+	if (codegen_oper_expression(context, buf, curr_depth, expr) < 0)
+		return -1;
+	if (buf)
+		__appendKernExpMagicAndLength(buf, pos);
+	return 0;
+}
+
+static int
+codegen_bool_expression(codegen_context *context,
+						StringInfo buf, int curr_depth,
+						BoolExpr *b)
+{
+	kern_expression	kexp;
+	int				pos = -1;
+	ListCell	   *lc;
+
+	memset(&kexp, 0, sizeof(kexp));
+	switch (b->boolop)
+	{
+		case AND_EXPR:
+			kexp.opcode = FuncOpCode__BoolExpr_And;
+			kexp.nr_args = list_length(b->args);
+			if (kexp.nr_args < 2)
+				__Elog("BoolExpr(AND) must have 2 or more arguments");
+			break;
+		case OR_EXPR:
+			kexp.opcode = FuncOpCode__BoolExpr_Or;
+			kexp.nr_args = list_length(b->args);
+			if (kexp.nr_args < 2)
+				__Elog("BoolExpr(OR) must have 2 or more arguments");
+			break;
+		case NOT_EXPR:
+			kexp.opcode = FuncOpCode__BoolExpr_Not;
+			kexp.nr_args = list_length(b->args);
+			if (kexp.nr_args != 1)
+				__Elog("BoolExpr(OR) must not have multiple arguments");
+			break;
+		default:
+			__Elog("BoolExpr has unknown bool operation (%d)", (int)b->boolop);
+	}
+	kexp.exptype = TypeOpCode__bool;
+	kexp.expflags = context->kexp_flags;
+	kexp.args_offset = SizeOfKernExpr(0);
+	if (buf)
+		pos = __appendBinaryStringInfo(buf, &kexp, SizeOfKernExpr(0));
+	foreach (lc, b->args)
+	{
+		Expr   *arg = lfirst(lc);
+
+		if (codegen_expression_walker(context, buf, curr_depth, arg) < 0)
+			return -1;
+	}
+	if (buf)
+		__appendKernExpMagicAndLength(buf, pos);
+	return 0;
+}
+
+static int
+codegen_nulltest_expression(codegen_context *context,
 							StringInfo buf, int curr_depth,
 							NullTest *nt)
 {
@@ -1702,17 +2650,78 @@ codegen_booleantest_expression(codegen_context *context,
 			__Elog("BooleanTest has unknown BoolTestType (%d)",
 				   (int)bt->booltesttype);
 	}
-	kexp.exptype = TypeOpCode__bool;
-	kexp.expflags = context->kexp_flags;
-	kexp.nr_args = 1;
-	kexp.args_offset = SizeOfKernExpr(0);
-	if (buf)
-		pos = __appendBinaryStringInfo(buf, &kexp, SizeOfKernExpr(0));
-	if (codegen_expression_walker(context, buf, curr_depth, bt->arg) < 0)
-		return -1;
-	if (buf)
-		__appendKernExpMagicAndLength(buf, pos);
-	return 0;
+	kexp.exptype = TypeOpCode__bool;
+	kexp.expflags = context->kexp_flags;
+	kexp.nr_args = 1;
+	kexp.args_offset = SizeOfKernExpr(0);
+	if (buf)
+		pos = __appendBinaryStringInfo(buf, &kexp, SizeOfKernExpr(0));
+	if (codegen_expression_walker(context, buf, curr_depth, bt->arg) < 0)
+		return -1;
+	if (buf)
+		__appendKernExpMagicAndLength(buf, pos);
+	return 0;
+}
+
+/*
+ * CoerceViaIO from text, if the device can parse the canonical form of the
+ * result type; the device function raises CPU-fallback on the other forms.
+ */
+static int
+codegen_coerceviaio_from_text(codegen_context *context,
+							  StringInfo buf, int curr_depth,
+							  CoerceViaIO *cvio)
+{
+	static struct {
+		const char *type_name;
+		FuncOpCode	opcode;
+	} text_cast_catalog[] = {
+		{"int2",      FuncOpCode__text_to_int2},
+		{"int4",      FuncOpCode__text_to_int4},
+		{"int8",      FuncOpCode__text_to_int8},
+		{"float4",    FuncOpCode__text_to_float4},
+		{"float8",    FuncOpCode__text_to_float8},
+		{"numeric",   FuncOpCode__text_to_numeric},
+		{"date",      FuncOpCode__text_to_date},
+		{"timestamp", FuncOpCode__text_to_timestamp},
+		{"uuid",      FuncOpCode__text_to_uuid},
+		{NULL,        FuncOpCode__Invalid},
+	};
+	Oid			source_type = exprType((Node *)cvio->arg);
+	devtype_info *dtype;
+	kern_expression kexp;
+	int			pos = -1;
+
+	if (source_type != TEXTOID && source_type != VARCHAROID)
+		__Elog("Not a supported CoerceViaIO: %s", nodeToString(cvio));
+	dtype = pgstrom_devtype_lookup(cvio->resulttype);
+	if (!dtype ||
+		dtype->type_extension != NULL ||
+		dtype->type_namespace != PG_CATALOG_NAMESPACE)
+		__Elog("Not a supported CoerceViaIO: %s", nodeToString(cvio));
+
+	memset(&kexp, 0, sizeof(kexp));
+	for (int i=0; text_cast_catalog[i].type_name != NULL; i++)
+	{
+		if (strcmp(dtype->type_name, text_cast_catalog[i].type_name) == 0)
+		{
+			kexp.opcode = text_cast_catalog[i].opcode;
+			kexp.exptype = dtype->type_code;
+			kexp.expflags = context->kexp_flags;
+			kexp.nr_args = 1;
+			kexp.args_offset = SizeOfKernExpr(0);
+			if (buf)
+				pos = __appendBinaryStringInfo(buf, &kexp, SizeOfKernExpr(0));
+			if (codegen_expression_walker(context, buf, curr_depth,
+										  cvio->arg) < 0)
+				return -1;
+			if (buf)
+				__appendKernExpMagicAndLength(buf, pos);
+			return 0;
+		}
+	}
+	__Elog("Not a supported CoerceViaIO: %s", nodeToString(cvio));
+	return -1;
 }
 
 /*
@@ -1821,7 +2830,7 @@ codegen_coerceviaio_expression(codegen_context *context,
 			__Elog("Not expected arguments of %s", format_procedure(func_oid));
 	}
 	else
-		__Elog("Not a supported CoerceViaIO: %s", nodeToString(cvio));
+		return codegen_coerceviaio_from_text(context, buf, curr_depth, cvio);
 
 	dtype = pgstrom_devtype_lookup(cvio->resulttype);
 	if (!dtype)
@@ -1860,8 +2869,8 @@ codegen_coerceviaio_expression(codegen_context *context,
 			return 0;
 		}
 	}
-	__Elog("Not a supported CoerceViaIO: %s", nodeToString(cvio));
-	return -1;
+	/* elsewhere, extract the jsonb element as text, then parse it */
+	return codegen_coerceviaio_from_text(context, buf, curr_depth, cvio);
 }
 
 /*
@@ -1987,6 +2996,81 @@ codegen_relabel_expression(codegen_context *context,
 	return codegen_expression_walker(context, buf, curr_depth, relabel->arg);
 }
 
+/*
+ * codegen_fieldselect_expression
+ *
+ * It supports reference to the sub-field of composite value, including
+ * Arrow::Struct columns (and Struct elements of Arrow::List / Map).
+ * PostgreSQL composite datum is walked on the device by the attribute
+ * descriptors of the leading fields embedded in the kern_expression.
+ */
+static int
+codegen_fieldselect_expression(codegen_context *context,
+							   StringInfo buf, int curr_depth,
+							   FieldSelect *fselect)
+{
+	devtype_info   *dtype;
+	devtype_info   *rtype;
+	TupleDesc		tupdesc;
+	Oid				type_oid = exprType((Node *)fselect->arg);
+	int				fieldnum = fselect->fieldnum;
+	kern_expression *kexp;
+	size_t			sz;
+	int				pos = -1;
+
+	dtype = pgstrom_devtype_lookup(type_oid);
+	if (!dtype || dtype->type_code != TypeOpCode__composite)
+		__Elog("device type '%s' is not supported",
+			   format_type_be(type_oid));
+	rtype = pgstrom_devtype_lookup(fselect->resulttype);
+	if (!rtype)
+		__Elog("device type '%s' is not supported",
+			   format_type_be(fselect->resulttype));
+	tupdesc = lookup_rowtype_tupdesc(type_oid, exprTypmod((Node *)fselect->arg));
+	if (fieldnum < 1 || fieldnum > tupdesc->natts ||
+		TupleDescAttr(tupdesc, fieldnum-1)->attisdropped ||
+		TupleDescAttr(tupdesc, fieldnum-1)->atttypid != fselect->resulttype)
+	{
+		ReleaseTupleDesc(tupdesc);
+		__Elog("FieldSelect refers unexpected sub-field (%d) of '%s'",
+			   fieldnum, format_type_be(type_oid));
+	}
+	sz = MAXALIGN(offsetof(kern_expression, u.fsel.attrs[fieldnum]));
+	kexp = alloca(sz);
+	memset(kexp, 0, sz);
+	kexp->exptype     = rtype->type_code;
+	kexp->expflags    = context->kexp_flags;
+	kexp->opcode      = FuncOpCode__FieldSelectExpr;
+	kexp->nr_args     = 1;
+	kexp->args_offset = sz;
+	kexp->u.fsel.fieldnum = fieldnum - 1;
+	kexp->u.fsel.nattrs = fieldnum;
+	for (int j=0; j < fieldnum; j++)
+	{
+		Form_pg_attribute attr = TupleDescAttr(tupdesc, j);
+
+		if (attr->attlen == 0 || attr->attlen < -1)
+		{
+			ReleaseTupleDesc(tupdesc);
+			__Elog("sub-field '%s' of '%s' has unsupported length (%d)",
+				   NameStr(attr->attname),
+				   format_type_be(type_oid), attr->attlen);
+		}
+		kexp->u.fsel.attrs[j].attlen   = attr->attlen;
+		kexp->u.fsel.attrs[j].attalign = typealign_get_width(attr->attalign);
+		kexp->u.fsel.attrs[j].attbyval = attr->attbyval;
+	}
+	ReleaseTupleDesc(tupdesc);
+
+	if (buf)
+		pos = __appendBinaryStringInfo(buf, kexp, sz);
+	if (codegen_expression_walker(context, buf, curr_depth, fselect->arg) < 0)
+		return -1;
+	if (buf)
+		__appendKernExpMagicAndLength(buf, pos);
+	return 0;
+}
+
 /*
  * codegen_casewhen_expression
  */
@@ -2094,6 +3178,134 @@ codegen_casewhen_expression(codegen_context *context,
 	return 0;
 }
 
+/*
+ * __codegen_scalar_array_op_sorted
+ *
+ * 'SCALAR = ANY(constant integer array)' with many elements (e.g, IN-list
+ * of thousands IDs generated by applications) is evaluated by binary search
+ * on the sorted unique values, instead of the comparator call on every
+ * array element for each row. It returns 1 if not applicable.
+ */
+#define SAOP_SORTED_MIN_NITEMS		16
+
+static int
+__saop_sorted_int64_comp(const void *__a, const void *__b)
+{
+	int64_t		a = *((const int64_t *)__a);
+	int64_t		b = *((const int64_t *)__b);
+
+	if (a < b)
+		return -1;
+	if (a > b)
+		return 1;
+	return 0;
+}
+
+static int
+__codegen_scalar_array_op_sorted(codegen_context *context,
+								 StringInfo buf, int curr_depth,
+								 ScalarArrayOpExpr *sa_op,
+								 Expr *expr_a, Expr *expr_s,
+								 devtype_info *dtype_s,
+								 devtype_info *dtype_e,
+								 Oid func_oid)
+{
+	Const		   *con = (Const *)expr_a;
+	TypeCacheEntry *tcache;
+	ArrayType	   *array;
+	Datum		   *elems;
+	bool		   *nulls;
+	int				nelems;
+	int				nitems = 0;
+	bool			has_nulls = false;
+	int64_t		   *values;
+	kern_expression *kexp;
+	size_t			sz;
+	int				pos = -1;
+
+	if (!sa_op->useOr ||
+		!IsA(con, Const) || con->constisnull ||
+		dtype_s->type_oid != dtype_e->type_oid ||
+		(dtype_s->type_code != TypeOpCode__int1 &&
+		 dtype_s->type_code != TypeOpCode__int2 &&
+		 dtype_s->type_code != TypeOpCode__int4 &&
+		 dtype_s->type_code != TypeOpCode__int8))
+		return 1;
+	/* comparator must be the equality operator of the integer type */
+	tcache = lookup_type_cache(dtype_s->type_oid, TYPECACHE_EQ_OPR);
+	if (!OidIsValid(tcache->eq_opr) ||
+		get_opcode(tcache->eq_opr) != func_oid)
+		return 1;
+	array = DatumGetArrayTypeP(con->constvalue);
+	if (ARR_ELEMTYPE(array) != dtype_e->type_oid ||
+		ArrayGetNItems(ARR_NDIM(array), ARR_DIMS(array)) < SAOP_SORTED_MIN_NITEMS)
+		return 1;
+	if (!buf)
+		return 0;
+
+	deconstruct_array(array,
+					  dtype_e->type_oid,
+					  dtype_e->type_length,
+					  dtype_e->type_byval,
+					  dtype_e->type_align,
+					  &elems, &nulls, &nelems);
+	values = palloc(sizeof(int64_t) * Max(nelems, 1));
+	for (int i=0; i < nelems; i++)
+	{
+		if (nulls[i])
+		{
+			has_nulls = true;
+			continue;
+		}
+		switch (dtype_e->type_code)
+		{
+			case TypeOpCode__int1:
+				values[nitems++] = (int64_t)DatumGetChar(elems[i]);
+				break;
+			case TypeOpCode__int2:
+				values[nitems++] = (int64_t)DatumGetInt16(elems[i]);
+				break;
+			case TypeOpCode__int4:
+				values[nitems++] = (int64_t)DatumGetInt32(elems[i]);
+				break;
+			default:
+				values[nitems++] = DatumGetInt64(elems[i]);
+				break;
+		}
+	}
+	if (nitems > 1)
+	{
+		int		j = 0;
+
+		qsort(values, nitems, sizeof(int64_t), __saop_sorted_int64_comp);
+		for (int i=1; i < nitems; i++)
+		{
+			if (values[i] != values[j])
+				values[++j] = values[i];
+		}
+		nitems = j + 1;
+	}
+	sz = MAXALIGN(offsetof(kern_expression, u.saop_sorted.values) +
+				  sizeof(int64_t) * nitems);
+	kexp = palloc0(sz);
+	kexp->exptype     = TypeOpCode__bool;
+	kexp->expflags    = context->kexp_flags;
+	kexp->opcode      = FuncOpCode__ScalarArrayOpSortedAny;
+	kexp->nr_args     = 1;
+	kexp->args_offset = sz;
+	kexp->u.saop_sorted.nitems = nitems;
+	kexp->u.saop_sorted.has_nulls = has_nulls;
+	memcpy(kexp->u.saop_sorted.values, values, sizeof(int64_t) * nitems);
+	pos = __appendBinaryStringInfo(buf, kexp, sz);
+	pfree(kexp);
+	pfree(values);
+	/* 1st arg - scalar expression to be probed */
+	if (codegen_expression_walker(context, buf, curr_depth, expr_s) < 0)
+		return -1;
+	__appendKernExpMagicAndLength(buf, pos);
+	return 0;
+}
+
 /*
  * codegen_scalar_array_op_expression
  */
@@ -2167,6 +3379,16 @@ codegen_scalar_array_op_expression(codegen_context *context,
 		dfunc->func_nargs != 2)
 		__Elog("function %s is not a binary boolean function",
 			   format_procedure(func_oid));
+	/* IN-list of constant integers, if possible */
+	{
+		int		status = __codegen_scalar_array_op_sorted(context, buf,
+														  curr_depth, sa_op,
+														  expr_a, expr_s,
+														  dtype_s, dtype_e,
+														  func_oid);
+		if (status <= 0)
+			return status;
+	}
 	/* allocation of kvar-slot for the temporary element variables */
 	kvdef = palloc0(sizeof(codegen_kvar_defitem));
 	kvdef->kv_slot_id = list_length(context->kvars_deflist);
@@ -2260,75 +3482,347 @@ is_expression_equals_tlist(codegen_context *context, Expr *expr,
 	int16_t		kv_type_length;
 	int32_t		kv_kvec_sizeof;
 
-	if (IsA(expr, Var))
+	if (IsA(expr, Var))
+	{
+		Var	   *var = (Var *)expr;
+
+		if (var->varno == context->scan_relid)
+		{
+			depth = 0;
+			resno = var->varattno;
+			Assert(resno != InvalidAttrNumber);
+			goto found;
+		}
+	}
+
+	for (depth = 1; depth <= context->num_rels; depth++)
+	{
+		PathTarget *target = context->pd[depth].inner_target;
+
+		resno = 1;
+		foreach (lc, target->exprs)
+		{
+			if (equal(expr, lfirst(lc)))
+				goto found;
+			resno++;
+		}
+	}
+	return NULL;	/* not found */
+found:
+	foreach (lc, context->kvars_deflist)
+	{
+		kvdef = lfirst(lc);
+
+		if (kvdef->kv_depth == depth &&
+			kvdef->kv_resno == resno)
+		{
+			Assert(equal(expr, kvdef->kv_expr));
+			kvdef->kv_maxref = Max(kvdef->kv_maxref, curr_depth);
+			return kvdef;
+		}
+	}
+
+	kv_type_oid = exprType((Node *)expr);
+	if (!__assign_codegen_kvar_defitem_type_params(kv_type_oid,
+												   &kv_type_code,
+												   &kv_type_byval,
+												   &kv_type_align,
+												   &kv_type_length,
+												   &kv_kvec_sizeof,
+												   allows_host_only_vars))
+		return NULL;
+
+	/* attach new one */
+	kvdef = palloc0(sizeof(codegen_kvar_defitem));
+	kvdef->kv_slot_id     = list_length(context->kvars_deflist);
+	kvdef->kv_depth       = depth;
+	kvdef->kv_resno       = resno;
+	kvdef->kv_maxref      = curr_depth;
+	kvdef->kv_offset      = context->kvecs_usage;
+	kvdef->kv_type_oid    = kv_type_oid;
+	kvdef->kv_type_code   = kv_type_code;
+	kvdef->kv_typbyval    = kv_type_byval;
+	kvdef->kv_typalign    = kv_type_align;
+	kvdef->kv_typlen      = kv_type_length;
+	kvdef->kv_kvec_sizeof = kv_kvec_sizeof;
+	kvdef->kv_expr        = expr;
+	__assign_codegen_kvar_defitem_subfields(kvdef);
+	context->kvecs_usage += KVEC_ALIGN(kvdef->kv_kvec_sizeof);
+	context->kvars_deflist = lappend(context->kvars_deflist, kvdef);
+
+	return kvdef;
+}
+
+/*
+ * Common sub-expression elimination
+ *
+ * A set of top-level expressions (units) like projection, grouping-keys
+ * or scan-qualifiers are evaluated in order on the device side. When a
+ * sub-expression is evaluated unconditionally in a unit, and appears
+ * again in the later units, we save the result of the first occurrence
+ * on the kvars-slot using SaveExpr, then the later occurrences just
+ * reference the kvars-slot using VarExpr.
+ * Sub-expressions under CASE, COALESCE, AND/OR and so on are not saved
+ * because these can be skipped by short-circuit evaluation.
+ */
+typedef struct
+{
+	Expr	   *cse_expr;		/* common sub-expression */
+	Expr	   *first_expr;		/* the first occurrence to be saved */
+	Expr	   *first_unit;		/* top-level expression of 'first_expr' */
+	int			cse_nrefs;		/* # of references from the later units */
+	codegen_kvar_defitem *kvdef;	/* kvars-slot to save the result */
+} codegen_cse_entry;
+
+typedef struct
+{
+	codegen_context *context;
+	List	   *cse_entries;
+	Expr	   *curr_unit;
+	bool		unconditional;
+} codegen_cse_collect_context;
+
+static codegen_cse_entry *
+__codegen_cse_lookup_entry(List *cse_entries, Expr *expr)
+{
+	ListCell   *lc;
+
+	foreach (lc, cse_entries)
+	{
+		codegen_cse_entry *cse = lfirst(lc);
+
+		if (equal(expr, cse->cse_expr))
+			return cse;
+	}
+	return NULL;
+}
+
+static bool
+__codegen_cse_is_candidate(codegen_context *context, Expr *expr)
+{
+	Expr	   *__expr = expr;
+	TypeOpCode	kv_type_code;
+	bool		kv_type_byval;
+	int8_t		kv_type_align;
+	int16_t		kv_type_length;
+
+	while (IsA(__expr, RelabelType))
+		__expr = ((RelabelType *)__expr)->arg;
+	/* simple references are not worth to save */
+	if (IsA(__expr, Var) ||
+		IsA(__expr, Const) ||
+		IsA(__expr, Param))
+		return false;
+	/* expressions already loaded from the inner relations */
+	for (int depth=1; depth <= context->num_rels; depth++)
+	{
+		PathTarget *target = context->pd[depth].inner_target;
+
+		if (list_member(target->exprs, expr))
+			return false;
+	}
+	if (contain_volatile_functions((Node *)expr))
+		return false;
+	return __assign_codegen_kvar_defitem_type_params(exprType((Node *)expr),
+													 &kv_type_code,
+													 &kv_type_byval,
+													 &kv_type_align,
+													 &kv_type_length,
+													 NULL,
+													 false);
+}
+
+static bool
+__codegen_cse_collect_walker(Node *node, codegen_cse_collect_context *cxt)
+{
+	bool		unconditional = cxt->unconditional;
+	bool		retval;
+
+	if (!node)
+		return false;
+	if (__codegen_cse_is_candidate(cxt->context, (Expr *)node))
+	{
+		codegen_cse_entry *cse;
+
+		cse = __codegen_cse_lookup_entry(cxt->cse_entries, (Expr *)node);
+		if (cse)
+		{
+			/* sub-expressions shall not be evaluated at the later units */
+			if (cse->first_unit != cxt->curr_unit)
+			{
+				cse->cse_nrefs++;
+				return false;
+			}
+		}
+		else if (cxt->unconditional)
+		{
+			cse = palloc0(sizeof(codegen_cse_entry));
+			cse->cse_expr   = (Expr *)node;
+			cse->first_expr = (Expr *)node;
+			cse->first_unit = cxt->curr_unit;
+			cxt->cse_entries = lappend(cxt->cse_entries, cse);
+		}
+	}
+	/* sub-expressions that may be skipped by short-circuit evaluation */
+	if ((IsA(node, BoolExpr) && ((BoolExpr *)node)->boolop != NOT_EXPR) ||
+		IsA(node, CaseExpr) ||
+		IsA(node, CoalesceExpr) ||
+		IsA(node, MinMaxExpr) ||
+		IsA(node, ScalarArrayOpExpr))
+		cxt->unconditional = false;
+	retval = expression_tree_walker(node, __codegen_cse_collect_walker, cxt);
+	cxt->unconditional = unconditional;
+
+	return retval;
+}
+
+/*
+ * codegen_cse_begin / codegen_cse_end
+ *
+ * It collects the common sub-expressions on the supplied units, and
+ * enables codegen_expression_walker() to save / reference them.
+ */
+static void
+codegen_cse_begin(codegen_context *context, List *cse_units)
+{
+	codegen_cse_collect_context cxt;
+	List	   *cse_entries = NIL;
+	ListCell   *lc;
+
+	Assert(context->cse_entries == NIL);
+	if (!pgstrom_enable_codegen_cse || list_length(cse_units) < 2)
+		return;
+	memset(&cxt, 0, sizeof(cxt));
+	cxt.context = context;
+	foreach (lc, cse_units)
+	{
+		cxt.curr_unit = lfirst(lc);
+		cxt.unconditional = true;
+		__codegen_cse_collect_walker((Node *)cxt.curr_unit, &cxt);
+	}
+	/* only sub-expressions referenced by the later units */
+	foreach (lc, cxt.cse_entries)
+	{
+		codegen_cse_entry *cse = lfirst(lc);
+
+		if (cse->cse_nrefs > 0)
+			cse_entries = lappend(cse_entries, cse);
+		else
+			pfree(cse);
+	}
+	list_free(cxt.cse_entries);
+
+	context->cse_units = cse_units;
+	context->cse_entries = cse_entries;
+	context->cse_curr_unit = NULL;
+}
+
+static void
+codegen_cse_end(codegen_context *context)
+{
+	list_free_deep(context->cse_entries);
+	context->cse_units = NIL;
+	context->cse_entries = NIL;
+	context->cse_curr_unit = NULL;
+}
+
+/*
+ * codegen_cse_is_saved
+ *
+ * It checks whether the kvars-slot is already saved by the previous units.
+ */
+static bool
+codegen_cse_is_saved(codegen_context *context,
+					 codegen_kvar_defitem *kvdef,
+					 Expr *unit)
+{
+	ListCell   *lc;
+
+	foreach (lc, context->cse_entries)
 	{
-		Var	   *var = (Var *)expr;
+		codegen_cse_entry *cse = lfirst(lc);
 
-		if (var->varno == context->scan_relid)
-		{
-			depth = 0;
-			resno = var->varattno;
-			Assert(resno != InvalidAttrNumber);
-			goto found;
-		}
+		if (cse->kvdef == kvdef && cse->first_unit != unit)
+			return true;
 	}
+	return false;
+}
 
-	for (depth = 1; depth <= context->num_rels; depth++)
-	{
-		PathTarget *target = context->pd[depth].inner_target;
+/*
+ * codegen_cse_assign_kvdef
+ *
+ * It assigns the kvars-slot to be saved by the caller, if the top-level
+ * expression is the first occurrence of the common sub-expression.
+ */
+static void
+codegen_cse_assign_kvdef(codegen_context *context,
+						 codegen_kvar_defitem *kvdef,
+						 Expr *expr)
+{
+	codegen_cse_entry *cse = __codegen_cse_lookup_entry(context->cse_entries, expr);
 
-		resno = 1;
-		foreach (lc, target->exprs)
-		{
-			if (equal(expr, lfirst(lc)))
-				goto found;
-			resno++;
-		}
-	}
-	return NULL;	/* not found */
-found:
-	foreach (lc, context->kvars_deflist)
-	{
-		kvdef = lfirst(lc);
+	if (cse && cse->first_expr == expr && !cse->kvdef)
+		cse->kvdef = kvdef;
+}
 
-		if (kvdef->kv_depth == depth &&
-			kvdef->kv_resno == resno)
-		{
-			Assert(equal(expr, kvdef->kv_expr));
-			kvdef->kv_maxref = Max(kvdef->kv_maxref, curr_depth);
-			return kvdef;
-		}
-	}
+static int
+codegen_cse_expression(codegen_context *context,
+					   StringInfo buf, int curr_depth,
+					   Expr *expr)
+{
+	codegen_cse_entry *cse;
+	codegen_kvar_defitem *kvdef;
+	kern_expression	kexp;
+	Oid			kv_type_oid;
+	int			pos;
 
-	kv_type_oid = exprType((Node *)expr);
-	if (!__assign_codegen_kvar_defitem_type_params(kv_type_oid,
-												   &kv_type_code,
-												   &kv_type_byval,
-												   &kv_type_align,
-												   &kv_type_length,
-												   &kv_kvec_sizeof,
-												   allows_host_only_vars))
-		return NULL;
+	if (list_member_ptr(context->cse_units, expr))
+		context->cse_curr_unit = expr;
+	cse = __codegen_cse_lookup_entry(context->cse_entries, expr);
+	if (!cse)
+		return 1;		/* not a common sub-expression */
+	/* already saved by the previous unit */
+	if (cse->kvdef && cse->first_unit != context->cse_curr_unit)
+		return codegen_var_expression(context, buf, curr_depth, cse->kvdef);
+	/* elsewhere, save the first occurrence on the kvars-slot */
+	if (cse->first_expr != expr || cse->kvdef)
+		return 1;
 
-	/* attach new one */
+	kv_type_oid = exprType((Node *)expr);
 	kvdef = palloc0(sizeof(codegen_kvar_defitem));
-	kvdef->kv_slot_id     = list_length(context->kvars_deflist);
-	kvdef->kv_depth       = depth;
-	kvdef->kv_resno       = resno;
-	kvdef->kv_maxref      = curr_depth;
-	kvdef->kv_offset      = context->kvecs_usage;
-	kvdef->kv_type_oid    = kv_type_oid;
-	kvdef->kv_type_code   = kv_type_code;
-	kvdef->kv_typbyval    = kv_type_byval;
-	kvdef->kv_typalign    = kv_type_align;
-	kvdef->kv_typlen      = kv_type_length;
-	kvdef->kv_kvec_sizeof = kv_kvec_sizeof;
-	kvdef->kv_expr        = expr;
+	kvdef->kv_slot_id   = list_length(context->kvars_deflist);
+	kvdef->kv_depth     = -1;
+	kvdef->kv_resno     = InvalidAttrNumber;
+	kvdef->kv_maxref    = curr_depth;
+	kvdef->kv_offset    = -1;
+	kvdef->kv_type_oid  = kv_type_oid;
+	if (!__assign_codegen_kvar_defitem_type_params(kv_type_oid,
+												   &kvdef->kv_type_code,
+												   &kvdef->kv_typbyval,
+												   &kvdef->kv_typalign,
+												   &kvdef->kv_typlen,
+												   NULL,
+												   false))
+		__Elog("type %s is not device supported", format_type_be(kv_type_oid));
+	kvdef->kv_expr      = expr;
 	__assign_codegen_kvar_defitem_subfields(kvdef);
-	context->kvecs_usage += KVEC_ALIGN(kvdef->kv_kvec_sizeof);
 	context->kvars_deflist = lappend(context->kvars_deflist, kvdef);
+	cse->kvdef = kvdef;
 
-	return kvdef;
+	memset(&kexp, 0, sizeof(kexp));
+	kexp.exptype  = kvdef->kv_type_code;
+	kexp.expflags = context->kexp_flags;
+	kexp.opcode   = FuncOpCode__SaveExpr;
+	kexp.nr_args  = 1;
+	kexp.args_offset = MAXALIGN(offsetof(kern_expression,
+										 u.save.data));
+	kexp.u.save.sv_slot_id = kvdef->kv_slot_id;
+	pos = __appendBinaryStringInfo(buf, &kexp, kexp.args_offset);
+	if (codegen_expression_walker(context, buf, curr_depth, expr) < 0)
+		return -1;
+	__appendKernExpMagicAndLength(buf, pos);
+
+	return 0;
 }
 
 static int
@@ -2344,6 +3838,14 @@ codegen_expression_walker(codegen_context *context,
 	kvdef = is_expression_equals_tlist(context, expr, curr_depth, false);
 	if (kvdef)
 		return codegen_var_expression(context, buf, curr_depth, kvdef);
+	/* check common sub-expressions */
+	if (buf && context->cse_entries != NIL)
+	{
+		int		retval = codegen_cse_expression(context, buf, curr_depth, expr);
+
+		if (retval <= 0)
+			return retval;
+	}
 
 	switch (nodeTag(expr))
 	{
@@ -2389,6 +3891,9 @@ codegen_expression_walker(codegen_context *context,
 		case T_ScalarArrayOpExpr:
 			return codegen_scalar_array_op_expression(context, buf, curr_depth,
 													  (ScalarArrayOpExpr *)expr);
+		case T_FieldSelect:
+			return codegen_fieldselect_expression(context, buf, curr_depth,
+												  (FieldSelect *)expr);
 		case T_CoerceToDomain:
 		default:
 			__Elog("not a supported expression type: %s", nodeToString(expr));
@@ -2464,6 +3969,7 @@ codegen_build_packed_kvars_load(codegen_context *context, pgstromPlanInfo *pp_in
 	kern_expression *karg;
 	StringInfoData buf;
 	size_t		sz;
+	ListCell   *lc;
 
 	sz = MAXALIGN(offsetof(kern_expression,
 						   u.pack.offset[context->kvecs_ndims + 1]));
@@ -2475,6 +3981,19 @@ codegen_build_packed_kvars_load(codegen_context *context, pgstromPlanInfo *pp_in
 	kexp->args_offset = sz;
 	kexp->u.pack.npacked = context->kvecs_ndims;
 
+	/*
+	 * toastable varlena may be inline compressed; the device code expands
+	 * them on the kcxt buffer, so it needs to be large enough.
+	 */
+	foreach (lc, context->kvars_deflist)
+	{
+		codegen_kvar_defitem *kvdef = lfirst(lc);
+
+		if (kvdef->kv_typlen == -1 &&
+			get_typstorage(kvdef->kv_type_oid) != TYPSTORAGE_PLAIN)
+			context->extra_bufsz = Max(context->extra_bufsz,
+									   pgstrom_gpu_detoast_buffer_kb * 1024);
+	}
 	initStringInfo(&buf);
 	buf.len = sz;
 	for (int depth=0; depth <= context->kvecs_ndims; depth++)
@@ -2616,6 +4135,48 @@ codegen_build_packed_kvars_move(codegen_context *context, pgstromPlanInfo *pp_in
 	pfree(buf.data);
 }
 
+/*
+ * codegen_build_adaptive_quals
+ *
+ * It builds BoolExpr(AND) of the scan-quals with KEXP_FLAG__ADAPTIVE_ORDER.
+ * GPU-service tracks the pass rate of each qualifier, then reorders them
+ * at run-time. The static cost of each qualifier is also saved.
+ */
+static int
+codegen_build_adaptive_quals(codegen_context *context,
+							 StringInfo buf,
+							 List *dev_quals)
+{
+	kern_expression kexp;
+	int			nquals = 0;
+	int			pos;
+	ListCell   *lc;
+
+	Assert(list_length(dev_quals) >= 2 &&
+		   list_length(dev_quals) <= KERN_ADAPTIVE_QUALS_MAX);
+	memset(&kexp, 0, sizeof(kexp));
+	kexp.exptype  = TypeOpCode__bool;
+	kexp.expflags = (context->kexp_flags | KEXP_FLAG__ADAPTIVE_ORDER);
+	kexp.opcode   = FuncOpCode__BoolExpr_And;
+	kexp.nr_args  = list_length(dev_quals);
+	kexp.args_offset = MAXALIGN(offsetof(kern_expression, u.aqual.data));
+	pos = __appendBinaryStringInfo(buf, &kexp, kexp.args_offset);
+	foreach (lc, dev_quals)
+	{
+		Expr	   *qual = lfirst(lc);
+		uint32_t	device_cost = context->device_cost;
+		kern_expression *__kexp;
+
+		if (codegen_expression_walker(context, buf, 0, qual) < 0)
+			return -1;
+		__kexp = (kern_expression *)(buf->data + pos);
+		__kexp->u.aqual.cost[nquals++] = context->device_cost - device_cost;
+	}
+	__appendKernExpMagicAndLength(buf, pos);
+
+	return 0;
+}
+
 /*
  * codegen_build_scan_quals
  */
@@ -2626,6 +4187,7 @@ codegen_build_scan_quals(codegen_context *context, List *dev_quals)
 	bytea	   *xpucode = NULL;
 	Expr	   *expr;
 	int			saved_depth = context->curr_depth;
+	int			status;
 
 	Assert(context->elevel >= ERROR);
 	if (dev_quals == NIL)
@@ -2637,12 +4199,27 @@ codegen_build_scan_quals(codegen_context *context, List *dev_quals)
 
 	initStringInfo(&buf);
 	context->curr_depth = 0;
-	if (codegen_expression_walker(context, &buf, 0, expr) == 0)
+	/* qualifiers are evaluated in order by BoolExpr(AND) */
+	codegen_cse_begin(context, dev_quals);
+	/*
+	 * Saved common sub-expressions assume the qualifiers are evaluated in
+	 * order, so we cannot reorder them at run-time.
+	 */
+	if (pgstrom_enable_adaptive_quals &&
+		(context->required_flags & DEVKIND__NVIDIA_GPU) != 0 &&
+		list_length(dev_quals) >= 2 &&
+		list_length(dev_quals) <= KERN_ADAPTIVE_QUALS_MAX &&
+		context->cse_entries == NIL)
+		status = codegen_build_adaptive_quals(context, &buf, dev_quals);
+	else
+		status = codegen_expression_walker(context, &buf, 0, expr);
+	if (status == 0)
 	{
 		xpucode = palloc(VARHDRSZ+buf.len);
 		memcpy(xpucode->vl_dat, buf.data, buf.len);
 		SET_VARSIZE(xpucode, VARHDRSZ+buf.len);
 	}
+	codegen_cse_end(context);
 	pfree(buf.data);
 	context->curr_depth = saved_depth;
 
@@ -2714,6 +4291,7 @@ __try_inject_projection_expression(codegen_context *context,
 	 * Setup VarExpr / SaveExpr expression
 	 */
 found:
+	codegen_cse_assign_kvdef(context, kvdef, expr);
 	memset(&kexp, 0, sizeof(kexp));
 	kexp.exptype  = kvdef->kv_type_code;
 	kexp.expflags = context->kexp_flags;
@@ -2739,6 +4317,12 @@ try_inject_projection_expression(codegen_context *context,
 	int		pos = buf->len;
 
 	kvdef = __try_inject_projection_expression(context, buf, expr);
+	/* revert expression if already saved as common sub-expression */
+	if (codegen_cse_is_saved(context, kvdef, expr))
+	{
+		buf->len = pos;
+		goto bailout;
+	}
 	for (int i=0; i < kexp_proj->u.proj.nattrs; i++)
 	{
 		uint16_t	proj_slot_id = kexp_proj->u.proj.slot_id[i];
@@ -2767,6 +4351,7 @@ codegen_build_projection(codegen_context *context)
 	bool		meet_resjunk = false;
 	int			nattrs = 0;
 	int			sz;
+	List	   *cse_units = NIL;
 	ListCell   *lc;
 
 	/* count nattrs */
@@ -2782,7 +4367,10 @@ codegen_build_projection(codegen_context *context)
 		else if (meet_resjunk)
 			elog(ERROR, "Bug? a valid TLE after junk TLEs");
 		else
+		{
+			cse_units = lappend(cse_units, tle->expr);
 			nattrs++;
+		}
 	}
 	sz = MAXALIGN(offsetof(kern_expression, u.proj.slot_id[nattrs]));
 	kexp = alloca(sz);
@@ -2790,6 +4378,7 @@ codegen_build_projection(codegen_context *context)
 
 	initStringInfo(&buf);
 	buf.len = sz;
+	codegen_cse_begin(context, cse_units);
 	foreach (lc, context->tlist_dev)
 	{
 		TargetEntry	*tle = lfirst(lc);
@@ -2803,6 +4392,8 @@ codegen_build_projection(codegen_context *context)
 												 tle->expr);
 		kexp->u.proj.slot_id[kexp->u.proj.nattrs++] = kvdef->kv_slot_id;
 	}
+	codegen_cse_end(context);
+	list_free(cse_units);
 	Assert(nattrs == kexp->u.proj.nattrs);
 	kexp->exptype = TypeOpCode__int4;
 	kexp->expflags = context->kexp_flags;
@@ -2821,6 +4412,96 @@ codegen_build_projection(codegen_context *context)
 	return xpucode;
 }
 
+/*
+ * codegen_build_dpu_prefilter
+ *
+ * It builds the XPU code for the DPU that pre-filters the outer relation
+ * of GPU tasks. The DPU returns the survived rows in the layout of the base
+ * relation, then the host relays them to the GPU as KDS_FORMAT_ROW chunks.
+ * If the rows cannot be relayed, the pre-filter shall be disabled.
+ */
+void
+codegen_build_dpu_prefilter(PlannerInfo *root, pgstromPlanInfo *pp_info)
+{
+	RangeTblEntry  *rte = root->simple_rte_array[pp_info->scan_relid];
+	pgstromPlanInfo *pp_dpu;
+	codegen_context *context;
+	CustomPath	   *dummy;
+	Relation		rel;
+	TupleDesc		tupdesc;
+	List		   *tlist_dev = NIL;
+	int				j;
+
+	if (pp_info->dpu_prefilter_quals == NIL)
+		return;
+	/* system columns and whole-row reference are not relayed */
+	j = bms_next_member(pp_info->outer_refs, -1);
+	if (j >= 0 && j + FirstLowInvalidHeapAttributeNumber <= 0)
+		goto bailout;
+
+	rel = table_open(rte->relid, NoLock);
+	tupdesc = RelationGetDescr(rel);
+	for (j=0; j < tupdesc->natts; j++)
+	{
+		Form_pg_attribute attr = TupleDescAttr(tupdesc, j);
+		Expr	   *expr;
+
+		if (!attr->attisdropped &&
+			bms_is_member(attr->attnum - FirstLowInvalidHeapAttributeNumber,
+						  pp_info->outer_refs))
+		{
+			expr = (Expr *)makeVar(pp_info->scan_relid,
+								   attr->attnum,
+								   attr->atttypid,
+								   attr->atttypmod,
+								   attr->attcollation,
+								   0);
+			if (!pgstrom_xpu_expression(expr, DEVKIND__NVIDIA_DPU,
+										pp_info->scan_relid, NIL, NULL))
+				break;
+		}
+		else if (!attr->attisdropped &&
+				 pgstrom_devtype_lookup(attr->atttypid) != NULL)
+		{
+			expr = (Expr *)makeNullConst(attr->atttypid,
+										 attr->atttypmod,
+										 attr->attcollation);
+		}
+		else
+		{
+			expr = (Expr *)makeNullConst(INT4OID, -1, InvalidOid);
+		}
+		tlist_dev = lappend(tlist_dev, makeTargetEntry(expr, j+1, NULL, false));
+	}
+	table_close(rel, NoLock);
+	if (j < tupdesc->natts)
+		goto bailout;
+
+	/* XPU code for the DPU scan */
+	pp_dpu = palloc0(offsetof(pgstromPlanInfo, inners));
+	pp_dpu->xpu_task_flags = TASK_KIND__DPUSCAN;
+	pp_dpu->scan_relid = pp_info->scan_relid;
+	dummy = makeNode(CustomPath);
+	context = create_codegen_context(dummy, pp_dpu);
+	pp_info->kexp_dpu_prefilter_quals
+		= codegen_build_scan_quals(context, pp_info->dpu_prefilter_quals);
+	context->tlist_dev = tlist_dev;
+	pp_info->kexp_dpu_prefilter_projection = codegen_build_projection(context);
+	codegen_build_packed_kvars_load(context, pp_dpu);
+	codegen_build_packed_kvars_move(context, pp_dpu);
+	pp_info->kexp_dpu_prefilter_load_vars = pp_dpu->kexp_load_vars_packed;
+	pp_info->kexp_dpu_prefilter_move_vars = pp_dpu->kexp_move_vars_packed;
+	pp_info->dpu_prefilter_kvars_deflist = context->kvars_deflist;
+	pp_info->dpu_prefilter_extra_bufsz = context->extra_bufsz;
+	pp_info->used_params = list_concat_unique(pp_info->used_params,
+											  context->used_params);
+	return;
+
+bailout:
+	pp_info->dpu_prefilter_quals = NIL;
+	pp_info->dpu_prefilter_nrows = 0.0;
+}
+
 /*
  * __codegen_build_joinquals
  */
@@ -3238,6 +4919,7 @@ codegen_build_groupby_keyhash(codegen_context *context,
 {
 	StringInfoData buf;
 	List		   *groupby_key_items = NIL;
+	List		   *cse_units = NIL;
 	kern_expression	kexp;
 	char		   *xpucode;
 	ListCell	   *lc1, *lc2;
@@ -3246,10 +4928,21 @@ codegen_build_groupby_keyhash(codegen_context *context,
 	 * Add variable slots to reference grouping-keys from the input and
 	 * kds_final buffer.
 	 */
+	forboth (lc1, context->tlist_dev,
+			 lc2, pp_info->groupby_actions)
+	{
+		TargetEntry *tle = lfirst(lc1);
+
+		if (lfirst_int(lc2) == KAGG_ACTION__VREF)
+			cse_units = lappend(cse_units, tle->expr);
+	}
+	codegen_cse_begin(context, cse_units);
+
 	initStringInfo(&buf);
 	memset(&kexp, 0, sizeof(kexp));
 	kexp.exptype = TypeOpCode__int4;
-	kexp.expflags = context->kexp_flags;
+	/* grouping keys are hashed only on the device */
+	kexp.expflags = (context->kexp_flags | KEXP_FLAG__FAST_HASH);
 	kexp.opcode = FuncOpCode__HashValue;
 	kexp.nr_args = 0;
 	kexp.args_offset = MAXALIGN(SizeOfKernExpr(0));
@@ -3270,6 +4963,8 @@ codegen_build_groupby_keyhash(codegen_context *context,
 			kexp.nr_args++;
 		}
 	}
+	codegen_cse_end(context);
+	list_free(cse_units);
 
 	if (groupby_key_items != NIL)
 	{
@@ -3474,6 +5169,12 @@ try_inject_groupby_expression(codegen_context *context,
 
 	Assert(kexp_pagg->opcode == FuncOpCode__AggFuncs);
 	kvdef = __try_inject_projection_expression(context, buf, expr);
+	/* revert expression if already saved as common sub-expression */
+	if (codegen_cse_is_saved(context, kvdef, expr))
+	{
+		buf->len = pos;
+		goto bailout;
+	}
 	for (int i=0; i < kexp_pagg->u.pagg.nattrs; i++)
 	{
 		const kern_aggregate_desc *desc = &kexp_pagg->u.pagg.desc[i];
@@ -3502,9 +5203,25 @@ __codegen_build_groupby_actions(codegen_context *context,
 	int			nattrs = list_length(pp_info->groupby_actions);
 	size_t		head_sz = MAXALIGN(offsetof(kern_expression, u.pagg.desc[nattrs]));
 	bytea	   *xpucode;
+	List	   *cse_units = NIL;
 	ListCell   *lc1, *lc2;
 	kern_expression *kexp;
 
+	/* SaveExpr arguments are evaluated in order, prior to the actions */
+	forboth (lc1, context->tlist_dev,
+			 lc2, pp_info->groupby_actions)
+	{
+		TargetEntry *tle = lfirst(lc1);
+		int			action = lfirst_int(lc2);
+
+		if (action == KAGG_ACTION__VREF ||
+			action == KAGG_ACTION__VREF_NOKEY)
+			cse_units = lappend(cse_units, tle->expr);
+		else
+			cse_units = list_concat(cse_units, ((FuncExpr *)tle->expr)->args);
+	}
+	codegen_cse_begin(context, cse_units);
+
 	kexp = alloca(head_sz);
 	memset(kexp, 0, head_sz);
 	kexp->exptype = TypeOpCode__int4;
@@ -3557,6 +5274,8 @@ __codegen_build_groupby_actions(codegen_context *context,
 		}
 		kexp->u.pagg.nattrs++;
 	}
+	codegen_cse_end(context);
+	list_free(cse_units);
 	memcpy(buf.data, kexp, head_sz);
 	__appendKernExpMagicAndLength(&buf, 0);
 
@@ -3953,6 +5672,17 @@ __xpucode_aggfuncs_cstring(StringInfo buf,
 								 __get_expression_cstring(css, dcontext,
 														  desc->arg0_slot_id));
 				break;
+			case KAGG_ACTION__PSUM_NUMERIC:
+			case KAGG_ACTION__PAVG_NUMERIC:
+				appendStringInfo(buf, "%s::numeric[slot=%d, expr='%s', scale=%s]",
+								 desc->action == KAGG_ACTION__PSUM_NUMERIC
+								 ? "psum" : "pavg",
+								 desc->arg0_slot_id,
+								 __get_expression_cstring(css, dcontext,
+														  desc->arg0_slot_id),
+								 __get_expression_cstring(css, dcontext,
+														  desc->arg1_slot_id));
+				break;
 			case KAGG_ACTION__STDDEV:
 				appendStringInfo(buf, "stddev[slot=%d, expr='%s']",
 								 desc->arg0_slot_id,
@@ -3968,6 +5698,39 @@ __xpucode_aggfuncs_cstring(StringInfo buf,
 								 __get_expression_cstring(css, dcontext,
 														  desc->arg1_slot_id));
 				break;
+			case KAGG_ACTION__PTOPK:
+				appendStringInfo(buf, "ptopk[slot0=%d, expr0='%s', slot1=%d, expr1='%s']",
+								 desc->arg0_slot_id,
+								 __get_expression_cstring(css, dcontext,
+														  desc->arg0_slot_id),
+								 desc->arg1_slot_id,
+								 __get_expression_cstring(css, dcontext,
+														  desc->arg1_slot_id));
+				break;
+			case KAGG_ACTION__PQUANTILE:
+				appendStringInfo(buf, "pquantile[slot0=%d, expr0='%s', slot1=%d, expr1='%s']",
+								 desc->arg0_slot_id,
+								 __get_expression_cstring(css, dcontext,
+														  desc->arg0_slot_id),
+								 desc->arg1_slot_id,
+								 __get_expression_cstring(css, dcontext,
+														  desc->arg1_slot_id));
+				break;
+			case KAGG_ACTION__PARRAY:
+				appendStringInfo(buf, "parray[slot=%d, expr='%s']",
+								 desc->arg0_slot_id,
+								 __get_expression_cstring(css, dcontext,
+														  desc->arg0_slot_id));
+				break;
+			case KAGG_ACTION__PARRAY_KEY:
+				appendStringInfo(buf, "parray[slot0=%d, expr0='%s', slot1=%d, key='%s']",
+								 desc->arg0_slot_id,
+								 __get_expression_cstring(css, dcontext,
+														  desc->arg0_slot_id),
+								 desc->arg1_slot_id,
+								 __get_expression_cstring(css, dcontext,
+														  desc->arg1_slot_id));
+				break;
 			default:
 				appendStringInfo(buf, "unknown[slot0=%d, expr0='%s', slot1=%d, expr1='%s']",
 								 desc->arg0_slot_id,
@@ -4029,7 +5792,10 @@ __xpucode_to_cstring(StringInfo buf,
 			__xpucode_gisteval_cstring(buf, kexp, css, es, dcontext);
 			break;
 		case FuncOpCode__HashValue:
-			appendStringInfo(buf, "{HashValue");
+			if ((kexp->expflags & KEXP_FLAG__FAST_HASH) != 0)
+				appendStringInfo(buf, "{HashValue(fast)");
+			else
+				appendStringInfo(buf, "{HashValue");
 			break;
 		case FuncOpCode__JoinQuals:
 			appendStringInfo(buf, "{JoinQuals: ");
@@ -4075,7 +5841,10 @@ __xpucode_to_cstring(StringInfo buf,
 			appendStringInfo(buf, "}");
 			return;
 		case FuncOpCode__BoolExpr_And:
-			appendStringInfo(buf, "{Bool::AND");
+			if ((kexp->expflags & KEXP_FLAG__ADAPTIVE_ORDER) != 0)
+				appendStringInfo(buf, "{Bool::AND(adaptive)");
+			else
+				appendStringInfo(buf, "{Bool::AND");
 			break;
 		case FuncOpCode__BoolExpr_Or:
 			appendStringInfo(buf, "{Bool::OR");
@@ -4180,6 +5949,26 @@ __xpucode_to_cstring(StringInfo buf,
 			appendStringInfoChar(buf, '>');
 			break;
 
+		case FuncOpCode__ScalarArrayOpSortedAny:
+			Assert(kexp->nr_args == 1);
+			appendStringInfo(buf, "{ScalarArrayOpSortedAny: nitems=%u%s",
+							 kexp->u.saop_sorted.nitems,
+							 kexp->u.saop_sorted.has_nulls ? ", has_nulls" : "");
+			break;
+
+		case FuncOpCode__FieldSelectExpr:
+			Assert(kexp->nr_args == 1);
+			appendStringInfo(buf, "{FieldSelect::%s: field=%u",
+							 devtype_get_name_by_opcode(kexp->exptype),
+							 kexp->u.fsel.fieldnum + 1);
+			break;
+
+		case FuncOpCode__UserDefinedFunc:
+			appendStringInfo(buf, "{UserFunc(%s)::%s",
+							 devtype_get_name_by_opcode(kexp->exptype),
+							 kexp->u.udf.data);
+			break;
+
 		default:
 			{
 				static struct {
@@ -4200,6 +5989,22 @@ __xpucode_to_cstring(StringInfo buf,
 					appendStringInfo(buf, "{Func(%s)::%s",
 									 dname,
                                      dfunc->func_name);
+					if ((kexp->expflags & KEXP_FLAG__COLLATE_WEIGHTS) != 0)
+						appendStringInfo(buf, "(collate)");
+					switch (kexp->opcode)
+					{
+						case FuncOpCode__textregexeq:
+						case FuncOpCode__textregexne:
+						case FuncOpCode__texticregexeq:
+						case FuncOpCode__texticregexne:
+						case FuncOpCode__regexp_like:
+							appendStringInfo(buf, "(dfa: nstates=%u, nclasses=%u)",
+											 kexp->u.regex.nstates,
+											 kexp->u.regex.nclasses);
+							break;
+						default:
+							break;
+					}
 				}
 				else
 				{
@@ -4433,10 +6238,157 @@ pgstrom_devcache_invalidator(Datum arg, int cacheid, uint32 hashvalue)
 	memset(devtype_info_slot, 0, sizeof(List *) * DEVTYPE_INFO_NSLOTS);
 	memset(devfunc_info_slot, 0, sizeof(List *) * DEVFUNC_INFO_NSLOTS);
 	memset(devfunc_code_slot, 0, sizeof(List *) * DEVFUNC_INFO_NSLOTS);
+	devcoll_weights_list = NIL;
 
 	__type_oid_cache_int1	= UINT_MAX;
 	__type_oid_cache_float2	= UINT_MAX;
 	__type_oid_cache_cube	= UINT_MAX;
+	__device_functions_relid = UINT_MAX;
+}
+
+static void
+pgstrom_devcache_relcache_invalidator(Datum arg, Oid relid)
+{
+	if (!OidIsValid(relid) ||
+		(__device_functions_relid != UINT_MAX &&
+		 __device_functions_relid == relid))
+		pgstrom_devcache_invalidator(arg, 0, 0);
+}
+
+/*
+ * pgstrom_define_device_function
+ *
+ * pgstrom.define_device_function(regprocedure, symbol text,
+ *                                source text, cost int)
+ */
+PG_FUNCTION_INFO_V1(pgstrom_define_device_function);
+PUBLIC_FUNCTION(Datum)
+pgstrom_define_device_function(PG_FUNCTION_ARGS)
+{
+	Oid			func_oid = PG_GETARG_OID(0);
+	char	   *symbol = text_to_cstring(PG_GETARG_TEXT_PP(1));
+	char	   *source = text_to_cstring(PG_GETARG_TEXT_PP(2));
+	int32		cost = PG_GETARG_INT32(3);
+	Oid			relid;
+	Oid			rettype;
+	Oid		   *argtypes;
+	int			nargs;
+	TypeOpCode	rettype_code;
+	TypeOpCode *argtypes_code;
+	devtype_info *dtype;
+	Oid			spi_types[4] = {REGPROCEDUREOID, TEXTOID, TEXTOID, INT4OID};
+	Datum		spi_values[4];
+	char		emsg[2048];
+
+	if (!superuser())
+		ereport(ERROR,
+				(errcode(ERRCODE_INSUFFICIENT_PRIVILEGE),
+				 errmsg("only superuser can define device functions")));
+	if (cost < 1)
+		elog(ERROR, "cost of device function must be positive");
+	if (!symbol[0] ||
+		strspn(symbol, "abcdefghijklmnopqrstuvwxyz"
+			   "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
+			   "0123456789_") != strlen(symbol) ||
+		isdigit((unsigned char)symbol[0]))
+		elog(ERROR, "device function symbol '%s' is not a valid identifier",
+			 symbol);
+	relid = get_device_functions_relid();
+	if (!OidIsValid(relid))
+		elog(ERROR, "pgstrom.device_functions was not found");
+	if (!func_strict(func_oid))
+		elog(ERROR, "function %s must be STRICT to run on the device",
+			 format_procedure(func_oid));
+	if (get_func_prokind(func_oid) != PROKIND_FUNCTION ||
+		get_func_retset(func_oid))
+		elog(ERROR, "function %s must be a scalar function",
+			 format_procedure(func_oid));
+
+	/* check the device types of the result and arguments */
+	rettype = get_func_signature(func_oid, &argtypes, &nargs);
+	dtype = pgstrom_devtype_lookup(rettype);
+	if (!dtype)
+		elog(ERROR, "result type %s is not a device type",
+			 format_type_be(rettype));
+	rettype_code = dtype->type_code;
+	argtypes_code = alloca(sizeof(TypeOpCode) * (nargs + 1));
+	for (int i=0; i < nargs; i++)
+	{
+		dtype = pgstrom_devtype_lookup(argtypes[i]);
+		if (!dtype)
+			elog(ERROR, "argument type %s is not a device type",
+				 format_type_be(argtypes[i]));
+		argtypes_code[i] = dtype->type_code;
+	}
+	if (!gpuJitValidateUserFunc(symbol, source,
+								rettype_code,
+								nargs, argtypes_code,
+								emsg, sizeof(emsg)))
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_FUNCTION_DEFINITION),
+				 errmsg("device function %s is not valid",
+						format_procedure(func_oid)),
+				 errdetail("%s", emsg)));
+
+	if (SPI_connect() != SPI_OK_CONNECT)
+		elog(ERROR, "failed on SPI_connect");
+	spi_values[0] = ObjectIdGetDatum(func_oid);
+	spi_values[1] = CStringGetTextDatum(symbol);
+	spi_values[2] = CStringGetTextDatum(source);
+	spi_values[3] = Int32GetDatum(cost);
+	if (SPI_execute_with_args("INSERT INTO pgstrom.device_functions"
+							  "(func_oid, func_symbol, func_source, func_cost)"
+							  " VALUES ($1, $2, $3, $4)"
+							  " ON CONFLICT (func_oid) DO UPDATE"
+							  "   SET func_symbol = EXCLUDED.func_symbol,"
+							  "       func_source = EXCLUDED.func_source,"
+							  "       func_cost   = EXCLUDED.func_cost",
+							  4, spi_types, spi_values, NULL,
+							  false, 0) != SPI_OK_INSERT)
+		elog(ERROR, "failed on SPI_execute_with_args");
+	SPI_finish();
+	/* other backends have to rebuild the devfunc cache */
+	CacheInvalidateRelcacheByRelid(relid);
+
+	PG_RETURN_VOID();
+}
+
+/*
+ * pgstrom_drop_device_function
+ *
+ * pgstrom.drop_device_function(regprocedure)
+ */
+PG_FUNCTION_INFO_V1(pgstrom_drop_device_function);
+PUBLIC_FUNCTION(Datum)
+pgstrom_drop_device_function(PG_FUNCTION_ARGS)
+{
+	Oid			func_oid = PG_GETARG_OID(0);
+	Oid			relid;
+	Oid			spi_types[1] = {REGPROCEDUREOID};
+	Datum		spi_values[1];
+	bool		found;
+
+	if (!superuser())
+		ereport(ERROR,
+				(errcode(ERRCODE_INSUFFICIENT_PRIVILEGE),
+				 errmsg("only superuser can drop device functions")));
+	relid = get_device_functions_relid();
+	if (!OidIsValid(relid))
+		elog(ERROR, "pgstrom.device_functions was not found");
+
+	if (SPI_connect() != SPI_OK_CONNECT)
+		elog(ERROR, "failed on SPI_connect");
+	spi_values[0] = ObjectIdGetDatum(func_oid);
+	if (SPI_execute_with_args("DELETE FROM pgstrom.device_functions"
+							  " WHERE func_oid = $1",
+							  1, spi_types, spi_values, NULL,
+							  false, 0) != SPI_OK_DELETE)
+		elog(ERROR, "failed on SPI_execute_with_args");
+	found = (SPI_processed > 0);
+	SPI_finish();
+	CacheInvalidateRelcacheByRelid(relid);
+
+	PG_RETURN_BOOL(found);
 }
 
 void
@@ -4448,4 +6400,34 @@ pgstrom_init_codegen(void)
 	pgstrom_devcache_invalidator(0, 0, 0);
 	CacheRegisterSyscacheCallback(TYPEOID, pgstrom_devcache_invalidator, 0);
 	CacheRegisterSyscacheCallback(PROCOID, pgstrom_devcache_invalidator, 0);
+	CacheRegisterSyscacheCallback(COLLOID, pgstrom_devcache_invalidator, 0);
+	CacheRegisterRelcacheCallback(pgstrom_devcache_relcache_invalidator, 0);
+
+	/* turn on/off adaptive reordering of scan-quals */
+	DefineCustomBoolVariable("pg_strom.enable_adaptive_quals",
+							 "Enables run-time reordering of scan-quals by the observed pass rate",
+							 NULL,
+							 &pgstrom_enable_adaptive_quals,
+							 true,
+							 PGC_USERSET,
+							 GUC_NOT_IN_SAMPLE,
+							 NULL, NULL, NULL);
+	/* turn on/off non-C collation support on the device */
+	DefineCustomBoolVariable("pg_strom.enable_gpu_collation",
+							 "Enables string comparison with non-C collation by the weight table",
+							 NULL,
+							 &pgstrom_enable_gpu_collation,
+							 true,
+							 PGC_USERSET,
+							 GUC_NOT_IN_SAMPLE,
+							 NULL, NULL, NULL);
+	/* turn on/off common sub-expression elimination */
+	DefineCustomBoolVariable("pg_strom.enable_codegen_cse",
+							 "Enables common sub-expression elimination on the device code generation",
+							 NULL,
+							 &pgstrom_enable_codegen_cse,
+							 true,
+							 PGC_USERSET,
+							 GUC_NOT_IN_SAMPLE,
+							 NULL, NULL, NULL);
 }
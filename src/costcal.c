@@ -0,0 +1,945 @@
+/*
+ * costcal.c
+ *
+ * Self-calibration of the GPU/DPU cost parameters.
+ *
+ * pg_strom.gpu_*_cost and pg_strom.dpu_*_cost are static parameters, even
+ * though the actual cost of the device tasks depends on the hardware
+ * generation. Once pg_strom.cost_calibration is enabled, queries that
+ * contain GPU/DPU nodes are instrumented, then the estimated cost and the
+ * actual time of each node are accumulated per device on the shared memory.
+ * The ratio of the actual time to the estimated cost, compared to the same
+ * ratio of the CPU sequential scans as reference, tells us how far the
+ * device cost parameters are off. Recommendations are shown by the
+ * pgstrom.cost_calibration_recommend view, and the 'auto' mode applies
+ * them on the planner. The calibrated values are not persistent, and begin
+ * from the configured ones again after the restart.
+ * ----
+ * Copyright 2011-2023 (C) KaiGai Kohei <kaigai@kaigai.gr.jp>
+ * Copyright 2014-2023 (C) PG-Strom Developers Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the PostgreSQL License.
+ */
+#include "pg_strom.h"
+
+#define COSTCAL_MODE__OFF			0
+#define COSTCAL_MODE__RECOMMEND		1
+#define COSTCAL_MODE__AUTO			2
+
+#define COSTCAL_DECAY				0.995	/* weight of the older samples */
+#define COSTCAL_MIN_EST_COST		1000.0	/* too small nodes are noisy */
+#define COSTCAL_MIN_FACTOR			0.1
+#define COSTCAL_MAX_FACTOR			10.0
+#define COSTCAL_REPORT_THRESHOLD	0.2		/* deviation to be logged */
+#define COSTCAL_REPORT_INTERVAL		(600 * USECS_PER_SEC)	/* 10min */
+
+typedef struct
+{
+	uint64_t	nsamples;		/* number of the samples */
+	double		weight;			/* decayed number of the samples */
+	/* estimated costs are normalized by the factor applied on planning */
+	double		est_startup;	/* estimated startup cost */
+	double		act_startup;	/* actual startup time [ms] */
+	double		est_run;		/* estimated run cost */
+	double		act_run;		/* actual run time [ms] */
+	double		est_rows;		/* estimated number of rows */
+	double		act_rows;		/* actual number of rows */
+	double		nchunks;		/* number of chunks processed by xPU */
+	double		io_bytes;		/* amount of I/O to read the relation */
+	double		kernel_ms;		/* time of kernel execution [ms] */
+	TimestampTz	last_update;
+	TimestampTz	last_report;
+} costCalibrationSlot;
+
+/*
+ * slots[0] is the CPU reference, then GPUs and DPUs follow
+ */
+typedef struct
+{
+	slock_t		lock;
+	int			num_gpus;
+	int			num_dpus;
+	TimestampTz	stats_reset;
+	costCalibrationSlot slots[FLEXIBLE_ARRAY_MEMBER];
+} costCalibrationHead;
+
+#define COSTCAL_NUM_SLOTS(num_gpus,num_dpus)	(1 + (num_gpus) + (num_dpus))
+#define COSTCAL_NUM_PARAMS		4	/* setup, tuple, operator and page cost */
+
+/* child nodes to be excluded from the cost/time of the parent */
+typedef struct
+{
+	double		est_total;
+	double		act_total;
+	int			nchilds;
+} costCalibrationChilds;
+
+/* state of pgstrom.cost_calibration_recommend() */
+typedef struct
+{
+	costCalibrationHead *snap;
+	int			index;		/* slot_id * COSTCAL_NUM_PARAMS + param_id */
+} costCalibrationRecommendState;
+
+/* factors applied on the current planning */
+typedef struct
+{
+	double		gpu_setup;
+	double		gpu_run;
+	double		dpu_setup;
+	double		dpu_run;
+} costCalibrationFactors;
+
+/* static variables */
+static shmem_request_hook_type shmem_request_next = NULL;
+static shmem_startup_hook_type shmem_startup_next = NULL;
+static planner_hook_type	planner_hook_next = NULL;
+static ExecutorStart_hook_type executor_start_next = NULL;
+static ExecutorEnd_hook_type executor_end_next = NULL;
+static costCalibrationHead *costcal_head = NULL;
+static int		pgstrom_cost_calibration;				/* GUC */
+static int		pgstrom_cost_calibration_min_samples;	/* GUC */
+static double	pgstrom_cost_calibration_sample_rate;	/* GUC */
+static bool		costcal_factors_applied = false;
+static costCalibrationFactors costcal_curr_factors = {1.0, 1.0, 1.0, 1.0};
+
+/*
+ * __costCalibrationMergeSlot
+ */
+static void
+__costCalibrationMergeSlot(costCalibrationSlot *dst,
+						   const costCalibrationSlot *src)
+{
+	dst->nsamples    += src->nsamples;
+	dst->weight      += src->weight;
+	dst->est_startup += src->est_startup;
+	dst->act_startup += src->act_startup;
+	dst->est_run     += src->est_run;
+	dst->act_run     += src->act_run;
+	dst->est_rows    += src->est_rows;
+	dst->act_rows    += src->act_rows;
+	dst->nchunks     += src->nchunks;
+	dst->io_bytes    += src->io_bytes;
+	dst->kernel_ms   += src->kernel_ms;
+	dst->last_update  = Max(dst->last_update, src->last_update);
+}
+
+/*
+ * __costCalibrationComputeFactors
+ *
+ * It returns the ratio of the (time / cost) of the device to the CPU
+ * reference, for the startup and run portion individually.
+ */
+static bool
+__costCalibrationComputeFactors(const costCalibrationSlot *cpu,
+								const costCalibrationSlot *slot,
+								double *p_setup_factor,
+								double *p_run_factor)
+{
+	double		ref;
+	double		setup_factor = 1.0;
+	double		run_factor = 1.0;
+
+	if (cpu->nsamples < pgstrom_cost_calibration_min_samples ||
+		slot->nsamples < pgstrom_cost_calibration_min_samples ||
+		cpu->est_run <= 0.0 || cpu->act_run <= 0.0)
+		return false;
+	/* milliseconds per cost unit on CPU */
+	ref = cpu->act_run / cpu->est_run;
+	if (slot->est_startup > 0.0 && slot->act_startup > 0.0)
+		setup_factor = (slot->act_startup / slot->est_startup) / ref;
+	if (slot->est_run > 0.0 && slot->act_run > 0.0)
+		run_factor = (slot->act_run / slot->est_run) / ref;
+	*p_setup_factor = Min(Max(setup_factor, COSTCAL_MIN_FACTOR), COSTCAL_MAX_FACTOR);
+	*p_run_factor   = Min(Max(run_factor,   COSTCAL_MIN_FACTOR), COSTCAL_MAX_FACTOR);
+	return true;
+}
+
+/*
+ * __costCalibrationDevKindFactors - factors for all the GPUs or DPUs
+ */
+static void
+__costCalibrationDevKindFactors(costCalibrationFactors *factors)
+{
+	costCalibrationSlot	cpu;
+	costCalibrationSlot	gpu;
+	costCalibrationSlot	dpu;
+	int			num_gpus = costcal_head->num_gpus;
+	int			num_dpus = costcal_head->num_dpus;
+
+	memset(&gpu, 0, sizeof(costCalibrationSlot));
+	memset(&dpu, 0, sizeof(costCalibrationSlot));
+	SpinLockAcquire(&costcal_head->lock);
+	memcpy(&cpu, &costcal_head->slots[0], sizeof(costCalibrationSlot));
+	for (int i=0; i < num_gpus; i++)
+		__costCalibrationMergeSlot(&gpu, &costcal_head->slots[1 + i]);
+	for (int i=0; i < num_dpus; i++)
+		__costCalibrationMergeSlot(&dpu, &costcal_head->slots[1 + num_gpus + i]);
+	SpinLockRelease(&costcal_head->lock);
+
+	factors->gpu_setup = factors->gpu_run = 1.0;
+	factors->dpu_setup = factors->dpu_run = 1.0;
+	__costCalibrationComputeFactors(&cpu, &gpu,
+									&factors->gpu_setup,
+									&factors->gpu_run);
+	__costCalibrationComputeFactors(&cpu, &dpu,
+									&factors->dpu_setup,
+									&factors->dpu_run);
+}
+
+/*
+ * pgstromCostCalibrationFactors
+ *
+ * It returns the factors applied on the current planning, to normalize the
+ * estimated cost of the sample on the executor end.
+ */
+void
+pgstromCostCalibrationFactors(uint32_t xpu_task_flags,
+							  double *p_setup_factor,
+							  double *p_run_factor)
+{
+	*p_setup_factor = 1.0;
+	*p_run_factor   = 1.0;
+	if (!costcal_factors_applied)
+		return;
+	if ((xpu_task_flags & DEVKIND__ANY) == DEVKIND__NVIDIA_GPU)
+	{
+		*p_setup_factor = costcal_curr_factors.gpu_setup;
+		*p_run_factor   = costcal_curr_factors.gpu_run;
+	}
+	else if ((xpu_task_flags & DEVKIND__ANY) == DEVKIND__NVIDIA_DPU)
+	{
+		*p_setup_factor = costcal_curr_factors.dpu_setup;
+		*p_run_factor   = costcal_curr_factors.dpu_run;
+	}
+}
+
+/*
+ * pgstrom_cost_calibration_planner
+ *
+ * In 'auto' mode, the cost parameters are multiplied by the calibrated
+ * factors during the planning. The GUC variables by themselves are not
+ * changed, so SHOW command still displays the configured values.
+ */
+static PlannedStmt *
+pgstrom_cost_calibration_planner(Query *parse,
+								 const char *query_string,
+								 int cursorOptions,
+								 ParamListInfo boundParams)
+{
+	PlannedStmt *pstmt;
+	double		saved_gpu_setup_cost    = pgstrom_gpu_setup_cost;
+	double		saved_gpu_tuple_cost    = pgstrom_gpu_tuple_cost;
+	double		saved_gpu_operator_cost = pgstrom_gpu_operator_cost;
+	double		saved_gpu_direct_seq_page_cost = pgstrom_gpu_direct_seq_page_cost;
+	double		saved_dpu_setup_cost    = pgstrom_dpu_setup_cost;
+	double		saved_dpu_tuple_cost    = pgstrom_dpu_tuple_cost;
+	double		saved_dpu_operator_cost = pgstrom_dpu_operator_cost;
+	double		saved_dpu_seq_page_cost = pgstrom_dpu_seq_page_cost;
+
+	/* already applied, if nested planning */
+	if (pgstrom_cost_calibration != COSTCAL_MODE__AUTO ||
+		!costcal_head || costcal_factors_applied)
+		return planner_hook_next(parse,
+								 query_string,
+								 cursorOptions,
+								 boundParams);
+
+	__costCalibrationDevKindFactors(&costcal_curr_factors);
+	PG_TRY();
+	{
+		costcal_factors_applied = true;
+		pgstrom_gpu_setup_cost    *= costcal_curr_factors.gpu_setup;
+		pgstrom_gpu_tuple_cost    *= costcal_curr_factors.gpu_run;
+		pgstrom_gpu_operator_cost *= costcal_curr_factors.gpu_run;
+		pgstrom_gpu_direct_seq_page_cost *= costcal_curr_factors.gpu_run;
+		pgstrom_dpu_setup_cost    *= costcal_curr_factors.dpu_setup;
+		pgstrom_dpu_tuple_cost    *= costcal_curr_factors.dpu_run;
+		pgstrom_dpu_operator_cost *= costcal_curr_factors.dpu_run;
+		pgstrom_dpu_seq_page_cost *= costcal_curr_factors.dpu_run;
+
+		pstmt = planner_hook_next(parse,
+								  query_string,
+								  cursorOptions,
+								  boundParams);
+	}
+	PG_FINALLY();
+	{
+		pgstrom_gpu_setup_cost    = saved_gpu_setup_cost;
+		pgstrom_gpu_tuple_cost    = saved_gpu_tuple_cost;
+		pgstrom_gpu_operator_cost = saved_gpu_operator_cost;
+		pgstrom_gpu_direct_seq_page_cost = saved_gpu_direct_seq_page_cost;
+		pgstrom_dpu_setup_cost    = saved_dpu_setup_cost;
+		pgstrom_dpu_tuple_cost    = saved_dpu_tuple_cost;
+		pgstrom_dpu_operator_cost = saved_dpu_operator_cost;
+		pgstrom_dpu_seq_page_cost = saved_dpu_seq_page_cost;
+		costcal_factors_applied = false;
+	}
+	PG_END_TRY();
+
+	return pstmt;
+}
+
+/*
+ * __planHasXpuNodes
+ */
+static bool
+__planHasXpuNodes(Plan *plan)
+{
+	ListCell   *lc;
+
+	if (!plan)
+		return false;
+	switch (nodeTag(plan))
+	{
+		case T_CustomScan:
+			{
+				CustomScan *cscan = (CustomScan *)plan;
+				const char *name = cscan->methods->CustomName;
+
+				if (strncmp(name, "Gpu", 3) == 0 ||
+					strncmp(name, "Dpu", 3) == 0)
+					return true;
+				foreach (lc, cscan->custom_plans)
+				{
+					if (__planHasXpuNodes(lfirst(lc)))
+						return true;
+				}
+			}
+			break;
+		case T_Append:
+			foreach (lc, ((Append *)plan)->appendplans)
+			{
+				if (__planHasXpuNodes(lfirst(lc)))
+					return true;
+			}
+			break;
+		case T_MergeAppend:
+			foreach (lc, ((MergeAppend *)plan)->mergeplans)
+			{
+				if (__planHasXpuNodes(lfirst(lc)))
+					return true;
+			}
+			break;
+		case T_SubqueryScan:
+			if (__planHasXpuNodes(((SubqueryScan *)plan)->subplan))
+				return true;
+			break;
+		default:
+			break;
+	}
+	return (__planHasXpuNodes(plan->lefttree) ||
+			__planHasXpuNodes(plan->righttree));
+}
+
+/*
+ * pgstrom_cost_calibration_executor_start
+ *
+ * Queries that contain GPU/DPU nodes are always instrumented, and the other
+ * ones are sampled to collect the CPU reference.
+ */
+static void
+pgstrom_cost_calibration_executor_start(QueryDesc *queryDesc, int eflags)
+{
+	if (pgstrom_cost_calibration != COSTCAL_MODE__OFF &&
+		costcal_head &&
+		!IsParallelWorker() &&
+		(eflags & EXEC_FLAG_EXPLAIN_ONLY) == 0 &&
+		(queryDesc->instrument_options & INSTRUMENT_TIMER) == 0)
+	{
+		PlannedStmt *pstmt = queryDesc->plannedstmt;
+		bool		has_xpu = __planHasXpuNodes(pstmt->planTree);
+		ListCell   *lc;
+
+		foreach (lc, pstmt->subplans)
+		{
+			if (has_xpu)
+				break;
+			has_xpu = __planHasXpuNodes(lfirst(lc));
+		}
+		if (has_xpu ||
+			(double)random() / (double)RAND_MAX < pgstrom_cost_calibration_sample_rate)
+			queryDesc->instrument_options |= (INSTRUMENT_TIMER | INSTRUMENT_ROWS);
+	}
+	if (executor_start_next)
+		executor_start_next(queryDesc, eflags);
+	else
+		standard_ExecutorStart(queryDesc, eflags);
+}
+
+/*
+ * __costCalibrationChildWalker
+ */
+static bool
+__costCalibrationChildWalker(PlanState *ps, void *context)
+{
+	costCalibrationChilds *childs = context;
+	Instrumentation *instr = ps->instrument;
+	double		nloops = 1.0;
+
+	if (instr)
+	{
+		InstrEndLoop(instr);
+		childs->act_total += 1000.0 * instr->total;
+		nloops = Max(instr->nloops, 1.0);
+	}
+	childs->est_total += ps->plan->total_cost * nloops;
+	childs->nchilds++;
+	return false;
+}
+
+/*
+ * __costCalibrationAddSample
+ */
+static void
+__costCalibrationAddSample(int slot_id, const costCalibrationSlot *sample)
+{
+	costCalibrationSlot *slot = &costcal_head->slots[slot_id];
+	TimestampTz	now = GetCurrentTimestamp();
+	double		setup_factor = 1.0;
+	double		run_factor = 1.0;
+	costCalibrationSlot	cpu;
+	costCalibrationSlot	curr;
+	bool		report = false;
+
+	SpinLockAcquire(&costcal_head->lock);
+	slot->nsamples++;
+	slot->weight      = slot->weight      * COSTCAL_DECAY + 1.0;
+	slot->est_startup = slot->est_startup * COSTCAL_DECAY + sample->est_startup;
+	slot->act_startup = slot->act_startup * COSTCAL_DECAY + sample->act_startup;
+	slot->est_run     = slot->est_run     * COSTCAL_DECAY + sample->est_run;
+	slot->act_run     = slot->act_run     * COSTCAL_DECAY + sample->act_run;
+	slot->est_rows    = slot->est_rows    * COSTCAL_DECAY + sample->est_rows;
+	slot->act_rows    = slot->act_rows    * COSTCAL_DECAY + sample->act_rows;
+	slot->nchunks     = slot->nchunks     * COSTCAL_DECAY + sample->nchunks;
+	slot->io_bytes    = slot->io_bytes    * COSTCAL_DECAY + sample->io_bytes;
+	slot->kernel_ms   = slot->kernel_ms   * COSTCAL_DECAY + sample->kernel_ms;
+	slot->last_update = now;
+	if (slot_id > 0 &&
+		pgstrom_cost_calibration == COSTCAL_MODE__RECOMMEND &&
+		slot->last_report + COSTCAL_REPORT_INTERVAL <= now)
+	{
+		memcpy(&cpu, &costcal_head->slots[0], sizeof(costCalibrationSlot));
+		memcpy(&curr, slot, sizeof(costCalibrationSlot));
+		if (__costCalibrationComputeFactors(&cpu, &curr,
+											&setup_factor,
+											&run_factor) &&
+			(fabs(setup_factor - 1.0) > COSTCAL_REPORT_THRESHOLD ||
+			 fabs(run_factor - 1.0) > COSTCAL_REPORT_THRESHOLD))
+		{
+			slot->last_report = now;
+			report = true;
+		}
+	}
+	SpinLockRelease(&costcal_head->lock);
+
+	if (report)
+	{
+		bool		is_gpu = (slot_id <= costcal_head->num_gpus);
+		int			dev_id = (is_gpu
+							  ? gpuDevAttrs[slot_id - 1].DEV_ID
+							  : slot_id - 1 - costcal_head->num_gpus);
+
+		elog(LOG, "pg_strom: cost calibration of %s%d recommends the setup cost x%.2f and the run cost x%.2f (see pgstrom.cost_calibration_recommend)",
+			 is_gpu ? "GPU" : "DPU", dev_id, setup_factor, run_factor);
+	}
+}
+
+/*
+ * __costCalibrationCollectWalker
+ */
+static bool
+__costCalibrationCollectWalker(PlanState *ps, void *context)
+{
+	Plan	   *plan = ps->plan;
+	Instrumentation *instr = ps->instrument;
+	costCalibrationChilds childs;
+	costCalibrationSlot sample;
+	double		nloops;
+	double		act_total;
+	double		est_total;
+	int			slot_id = -1;
+
+	memset(&childs, 0, sizeof(costCalibrationChilds));
+	planstate_tree_walker(ps, __costCalibrationChildWalker, &childs);
+	if (!instr)
+		goto out;
+	InstrEndLoop(instr);
+	if (instr->nloops <= 0.0)
+		goto out;
+	nloops = instr->nloops;
+	memset(&sample, 0, sizeof(costCalibrationSlot));
+
+	/* exclusive time and cost of this node, per loop */
+	act_total = Max(1000.0 * instr->total - childs.act_total, 0.0) / nloops;
+	est_total = Max(plan->total_cost - childs.est_total / nloops, 0.0);
+	if (est_total < COSTCAL_MIN_EST_COST)
+		goto out;
+	sample.est_rows = plan->plan_rows;
+	sample.act_rows = instr->ntuples / nloops;
+
+	if (IsA(ps, CustomScanState) &&
+		((CustomScanState *)ps)->methods->ExecCustomScan == pgstromExecTaskState)
+	{
+		pgstromTaskState   *pts = (pgstromTaskState *)ps;
+		pgstromSharedState *ps_state = pts->ps_state;
+		pgstromPlanInfo	   *pp_info = pts->pp_info;
+		int			dindex = pgstromTaskStateDeviceIndex(pts);
+		double		act_startup;
+		double		est_startup;
+
+		if ((pts->xpu_task_flags & DEVKIND__ANY) == DEVKIND__NVIDIA_GPU)
+		{
+			if (dindex >= 0 && dindex < costcal_head->num_gpus)
+				slot_id = 1 + dindex;
+		}
+		else if ((pts->xpu_task_flags & DEVKIND__ANY) == DEVKIND__NVIDIA_DPU)
+		{
+			if (dindex >= 0 && dindex < costcal_head->num_dpus)
+				slot_id = 1 + costcal_head->num_gpus + dindex;
+		}
+		if (slot_id < 0 || !ps_state)
+			goto out;
+		/*
+		 * inner relations of the join are loaded on the startup, so they
+		 * are already excluded from the startup cost/time.
+		 */
+		act_startup = Min(Max(1000.0 * instr->startup - childs.act_total, 0.0) / nloops,
+						  act_total);
+		est_startup = Min(Max(plan->startup_cost - childs.est_total / nloops, 0.0),
+						  est_total);
+		sample.est_startup = est_startup / Max(pp_info->cost_setup_factor, COSTCAL_MIN_FACTOR);
+		sample.act_startup = act_startup;
+		sample.est_run = (est_total - est_startup) / Max(pp_info->cost_run_factor, COSTCAL_MIN_FACTOR);
+		sample.act_run = act_total - act_startup;
+		sample.nchunks = (double)pg_atomic_read_u64(&ps_state->result_nchunks) / nloops;
+		sample.io_bytes = (double)BLCKSZ *
+			(double)(pg_atomic_read_u64(&ps_state->npages_direct_read) +
+					 pg_atomic_read_u64(&ps_state->npages_vfs_read) +
+					 pg_atomic_read_u64(&ps_state->npages_buffer_read)) / nloops;
+		sample.kernel_ms = (double)pg_atomic_read_u64(&ps_state->time_kernel_usec) / (1000.0 * nloops);
+	}
+	else if (IsA(ps, SeqScanState) && childs.nchilds == 0)
+	{
+		/* plain CPU scan without any sub-plans is the reference */
+		slot_id = 0;
+		sample.est_run = est_total;
+		sample.act_run = act_total;
+		sample.io_bytes = (double)BLCKSZ * (double)((SeqScanState *)ps)->ss.ss_currentRelation->rd_rel->relpages;
+	}
+	if (slot_id >= 0)
+		__costCalibrationAddSample(slot_id, &sample);
+out:
+	return planstate_tree_walker(ps, __costCalibrationCollectWalker, context);
+}
+
+/*
+ * pgstrom_cost_calibration_executor_end
+ */
+static void
+pgstrom_cost_calibration_executor_end(QueryDesc *queryDesc)
+{
+	if (pgstrom_cost_calibration != COSTCAL_MODE__OFF &&
+		costcal_head &&
+		!IsParallelWorker() &&
+		queryDesc->planstate &&
+		(queryDesc->instrument_options & INSTRUMENT_TIMER) != 0)
+	{
+		__costCalibrationCollectWalker(queryDesc->planstate, NULL);
+	}
+	if (executor_end_next)
+		executor_end_next(queryDesc);
+	else
+		standard_ExecutorEnd(queryDesc);
+}
+
+/*
+ * __costCalibrationSlotLabel
+ */
+static char *
+__costCalibrationSlotLabel(int slot_id, int num_gpus)
+{
+	if (slot_id == 0)
+		return pstrdup("CPU");
+	if (slot_id <= num_gpus)
+		return psprintf("GPU%d", gpuDevAttrs[slot_id - 1].DEV_ID);
+	return psprintf("DPU%d", slot_id - 1 - num_gpus);
+}
+
+/*
+ * __costCalibrationSnapshot
+ */
+static costCalibrationHead *
+__costCalibrationSnapshot(void)
+{
+	costCalibrationHead *snap;
+	size_t		sz;
+
+	if (!costcal_head)
+		return NULL;
+	sz = offsetof(costCalibrationHead,
+				  slots[COSTCAL_NUM_SLOTS(costcal_head->num_gpus,
+										  costcal_head->num_dpus)]);
+	snap = palloc(sz);
+	SpinLockAcquire(&costcal_head->lock);
+	memcpy(snap, costcal_head, sz);
+	SpinLockRelease(&costcal_head->lock);
+
+	return snap;
+}
+
+/*
+ * pgstrom_cost_calibration_info
+ */
+PG_FUNCTION_INFO_V1(pgstrom_cost_calibration_info);
+PUBLIC_FUNCTION(Datum)
+pgstrom_cost_calibration_info(PG_FUNCTION_ARGS)
+{
+	FuncCallContext *fncxt;
+	costCalibrationHead *snap;
+	costCalibrationSlot *slot;
+	Datum		values[16];
+	bool		isnull[16];
+	HeapTuple	tuple;
+	int			slot_id;
+	double		setup_factor;
+	double		run_factor;
+
+	if (SRF_IS_FIRSTCALL())
+	{
+		TupleDesc		tupdesc;
+		MemoryContext	oldcxt;
+
+		fncxt = SRF_FIRSTCALL_INIT();
+		oldcxt = MemoryContextSwitchTo(fncxt->multi_call_memory_ctx);
+
+		tupdesc = CreateTemplateTupleDesc(16);
+		TupleDescInitEntry(tupdesc,  1, "device",
+						   TEXTOID, -1, 0);
+		TupleDescInitEntry(tupdesc,  2, "nsamples",
+						   INT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc,  3, "est_rows",
+						   FLOAT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc,  4, "actual_rows",
+						   FLOAT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc,  5, "nchunks",
+						   FLOAT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc,  6, "io_bytes",
+						   FLOAT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc,  7, "kernel_time",
+						   FLOAT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc,  8, "est_startup_cost",
+						   FLOAT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc,  9, "actual_startup_time",
+						   FLOAT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc, 10, "est_run_cost",
+						   FLOAT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc, 11, "actual_run_time",
+						   FLOAT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc, 12, "setup_factor",
+						   FLOAT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc, 13, "run_factor",
+						   FLOAT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc, 14, "last_update",
+						   TIMESTAMPTZOID, -1, 0);
+		TupleDescInitEntry(tupdesc, 15, "last_report",
+						   TIMESTAMPTZOID, -1, 0);
+		TupleDescInitEntry(tupdesc, 16, "stats_reset",
+						   TIMESTAMPTZOID, -1, 0);
+		fncxt->tuple_desc = BlessTupleDesc(tupdesc);
+		fncxt->user_fctx = __costCalibrationSnapshot();
+
+		MemoryContextSwitchTo(oldcxt);
+	}
+	fncxt = SRF_PERCALL_SETUP();
+	snap = fncxt->user_fctx;
+	slot_id = fncxt->call_cntr;
+	if (!snap || slot_id >= COSTCAL_NUM_SLOTS(snap->num_gpus,
+											  snap->num_dpus))
+		SRF_RETURN_DONE(fncxt);
+	slot = &snap->slots[slot_id];
+
+	/* values are the weighted average of the decayed samples */
+	memset(isnull, 0, sizeof(isnull));
+	values[0] = CStringGetTextDatum(__costCalibrationSlotLabel(slot_id,
+															   snap->num_gpus));
+	values[1] = Int64GetDatum(slot->nsamples);
+	if (slot->weight > 0.0)
+	{
+		values[2]  = Float8GetDatum(slot->est_rows    / slot->weight);
+		values[3]  = Float8GetDatum(slot->act_rows    / slot->weight);
+		values[4]  = Float8GetDatum(slot->nchunks     / slot->weight);
+		values[5]  = Float8GetDatum(slot->io_bytes    / slot->weight);
+		values[6]  = Float8GetDatum(slot->kernel_ms   / slot->weight);
+		values[7]  = Float8GetDatum(slot->est_startup / slot->weight);
+		values[8]  = Float8GetDatum(slot->act_startup / slot->weight);
+		values[9]  = Float8GetDatum(slot->est_run     / slot->weight);
+		values[10] = Float8GetDatum(slot->act_run     / slot->weight);
+	}
+	else
+	{
+		for (int j=2; j <= 10; j++)
+			isnull[j] = true;
+	}
+	if (slot_id > 0 &&
+		__costCalibrationComputeFactors(&snap->slots[0], slot,
+										&setup_factor,
+										&run_factor))
+	{
+		values[11] = Float8GetDatum(setup_factor);
+		values[12] = Float8GetDatum(run_factor);
+	}
+	else
+	{
+		isnull[11] = true;
+		isnull[12] = true;
+	}
+	if (slot->last_update != 0)
+		values[13] = TimestampTzGetDatum(slot->last_update);
+	else
+		isnull[13] = true;
+	if (slot->last_report != 0)
+		values[14] = TimestampTzGetDatum(slot->last_report);
+	else
+		isnull[14] = true;
+	values[15] = TimestampTzGetDatum(snap->stats_reset);
+
+	tuple = heap_form_tuple(fncxt->tuple_desc, values, isnull);
+
+	SRF_RETURN_NEXT(fncxt, HeapTupleGetDatum(tuple));
+}
+
+/*
+ * pgstrom_cost_calibration_recommend
+ */
+PG_FUNCTION_INFO_V1(pgstrom_cost_calibration_recommend);
+PUBLIC_FUNCTION(Datum)
+pgstrom_cost_calibration_recommend(PG_FUNCTION_ARGS)
+{
+	static const char *gpu_params[COSTCAL_NUM_PARAMS] = {
+		"pg_strom.gpu_setup_cost",
+		"pg_strom.gpu_tuple_cost",
+		"pg_strom.gpu_operator_cost",
+		"pg_strom.gpu_direct_seq_page_cost",
+	};
+	static const char *dpu_params[COSTCAL_NUM_PARAMS] = {
+		"pg_strom.dpu_setup_cost",
+		"pg_strom.dpu_tuple_cost",
+		"pg_strom.dpu_operator_cost",
+		"pg_strom.dpu_seq_page_cost",
+	};
+	FuncCallContext *fncxt;
+	costCalibrationRecommendState *state;
+	costCalibrationHead *snap;
+	Datum		values[5];
+	bool		isnull[5];
+	HeapTuple	tuple;
+	int			slot_id;
+	int			param_id;
+	double		setup_factor;
+	double		run_factor;
+	double		setting;
+	bool		is_gpu;
+
+	if (SRF_IS_FIRSTCALL())
+	{
+		TupleDesc		tupdesc;
+		MemoryContext	oldcxt;
+
+		fncxt = SRF_FIRSTCALL_INIT();
+		oldcxt = MemoryContextSwitchTo(fncxt->multi_call_memory_ctx);
+
+		tupdesc = CreateTemplateTupleDesc(5);
+		TupleDescInitEntry(tupdesc, 1, "device",
+						   TEXTOID, -1, 0);
+		TupleDescInitEntry(tupdesc, 2, "name",
+						   TEXTOID, -1, 0);
+		TupleDescInitEntry(tupdesc, 3, "setting",
+						   FLOAT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc, 4, "recommended",
+						   FLOAT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc, 5, "nsamples",
+						   INT8OID, -1, 0);
+		fncxt->tuple_desc = BlessTupleDesc(tupdesc);
+		state = palloc0(sizeof(costCalibrationRecommendState));
+		state->snap = __costCalibrationSnapshot();
+		state->index = COSTCAL_NUM_PARAMS;	/* skip the CPU */
+		fncxt->user_fctx = state;
+
+		MemoryContextSwitchTo(oldcxt);
+	}
+	fncxt = SRF_PERCALL_SETUP();
+	state = fncxt->user_fctx;
+	snap = state->snap;
+	if (!snap)
+		SRF_RETURN_DONE(fncxt);
+	/* skip the devices that have no recommendation yet */
+	for (;;)
+	{
+		slot_id = state->index / COSTCAL_NUM_PARAMS;
+		param_id = state->index % COSTCAL_NUM_PARAMS;
+		if (slot_id >= COSTCAL_NUM_SLOTS(snap->num_gpus,
+										 snap->num_dpus))
+			SRF_RETURN_DONE(fncxt);
+		if (__costCalibrationComputeFactors(&snap->slots[0],
+											&snap->slots[slot_id],
+											&setup_factor,
+											&run_factor))
+			break;
+		state->index += COSTCAL_NUM_PARAMS - param_id;
+	}
+	state->index++;
+
+	is_gpu = (slot_id <= snap->num_gpus);
+	switch (param_id)
+	{
+		case 0:
+			setting = (is_gpu ? pgstrom_gpu_setup_cost : pgstrom_dpu_setup_cost);
+			break;
+		case 1:
+			setting = (is_gpu ? pgstrom_gpu_tuple_cost : pgstrom_dpu_tuple_cost);
+			break;
+		case 2:
+			setting = (is_gpu ? pgstrom_gpu_operator_cost : pgstrom_dpu_operator_cost);
+			break;
+		default:
+			setting = (is_gpu ? pgstrom_gpu_direct_seq_page_cost : pgstrom_dpu_seq_page_cost);
+			break;
+	}
+	memset(isnull, 0, sizeof(isnull));
+	values[0] = CStringGetTextDatum(__costCalibrationSlotLabel(slot_id,
+															   snap->num_gpus));
+	values[1] = CStringGetTextDatum(is_gpu
+									? gpu_params[param_id]
+									: dpu_params[param_id]);
+	values[2] = Float8GetDatum(setting);
+	values[3] = Float8GetDatum(setting * (param_id == 0
+										  ? setup_factor
+										  : run_factor));
+	values[4] = Int64GetDatum(snap->slots[slot_id].nsamples);
+
+	tuple = heap_form_tuple(fncxt->tuple_desc, values, isnull);
+
+	SRF_RETURN_NEXT(fncxt, HeapTupleGetDatum(tuple));
+}
+
+/*
+ * pgstrom_cost_calibration_reset
+ */
+PG_FUNCTION_INFO_V1(pgstrom_cost_calibration_reset);
+PUBLIC_FUNCTION(Datum)
+pgstrom_cost_calibration_reset(PG_FUNCTION_ARGS)
+{
+	int			nslots;
+
+	if (!superuser())
+		ereport(ERROR,
+				(errcode(ERRCODE_INSUFFICIENT_PRIVILEGE),
+				 errmsg("only superuser can reset the cost calibration")));
+	if (costcal_head)
+	{
+		nslots = COSTCAL_NUM_SLOTS(costcal_head->num_gpus,
+								   costcal_head->num_dpus);
+		SpinLockAcquire(&costcal_head->lock);
+		memset(costcal_head->slots, 0, sizeof(costCalibrationSlot) * nslots);
+		costcal_head->stats_reset = GetCurrentTimestamp();
+		SpinLockRelease(&costcal_head->lock);
+	}
+	PG_RETURN_VOID();
+}
+
+/*
+ * pgstrom_request_cost_calibration
+ */
+static void
+pgstrom_request_cost_calibration(void)
+{
+	int			nslots = COSTCAL_NUM_SLOTS(numGpuDevAttrs,
+										   DpuStorageEntryCount());
+
+	if (shmem_request_next)
+		shmem_request_next();
+	RequestAddinShmemSpace(MAXALIGN(offsetof(costCalibrationHead,
+											 slots[nslots])));
+}
+
+/*
+ * pgstrom_startup_cost_calibration
+ */
+static void
+pgstrom_startup_cost_calibration(void)
+{
+	int			num_gpus = numGpuDevAttrs;
+	int			num_dpus = DpuStorageEntryCount();
+	size_t		sz = offsetof(costCalibrationHead,
+							  slots[COSTCAL_NUM_SLOTS(num_gpus, num_dpus)]);
+	bool		found;
+
+	if (shmem_startup_next)
+		(*shmem_startup_next)();
+
+	costcal_head = ShmemInitStruct("costCalibrationHead", MAXALIGN(sz), &found);
+	Assert(!found);
+	memset(costcal_head, 0, sz);
+	SpinLockInit(&costcal_head->lock);
+	costcal_head->num_gpus = num_gpus;
+	costcal_head->num_dpus = num_dpus;
+	costcal_head->stats_reset = GetCurrentTimestamp();
+}
+
+/*
+ * pgstrom_init_cost_calibration
+ */
+void
+pgstrom_init_cost_calibration(void)
+{
+	static struct config_enum_entry __cost_calibration_options[] = {
+		{"off",			COSTCAL_MODE__OFF,			false},
+		{"recommend",	COSTCAL_MODE__RECOMMEND,	false},
+		{"auto",		COSTCAL_MODE__AUTO,			false},
+		{NULL, 0, false},
+	};
+
+	DefineCustomEnumVariable("pg_strom.cost_calibration",
+							 "Self-calibration of the GPU/DPU cost parameters",
+							 "'recommend' collects the estimated and actual cost of GPU/DPU nodes, and 'auto' also applies the calibrated values on planning",
+							 &pgstrom_cost_calibration,
+							 COSTCAL_MODE__OFF,
+							 __cost_calibration_options,
+							 PGC_SUSET,
+							 GUC_NOT_IN_SAMPLE,
+							 NULL, NULL, NULL);
+	DefineCustomIntVariable("pg_strom.cost_calibration_min_samples",
+							"Minimum number of samples to calibrate the cost parameters",
+							NULL,
+							&pgstrom_cost_calibration_min_samples,
+							20,
+							1,
+							INT_MAX,
+							PGC_SUSET,
+							GUC_NOT_IN_SAMPLE,
+							NULL, NULL, NULL);
+	DefineCustomRealVariable("pg_strom.cost_calibration_sample_rate",
+							 "Ratio of the CPU-only queries to be sampled as reference of the cost calibration",
+							 NULL,
+							 &pgstrom_cost_calibration_sample_rate,
+							 0.01,
+							 0.0,
+							 1.0,
+							 PGC_SUSET,
+							 GUC_NOT_IN_SAMPLE,
+							 NULL, NULL, NULL);
+	/* shared memory size */
+	shmem_request_next = shmem_request_hook;
+	shmem_request_hook = pgstrom_request_cost_calibration;
+	shmem_startup_next = shmem_startup_hook;
+	shmem_startup_hook = pgstrom_startup_cost_calibration;
+	/* planner and executor hooks */
+	planner_hook_next = (planner_hook ? planner_hook : standard_planner);
+	planner_hook = pgstrom_cost_calibration_planner;
+	executor_start_next = ExecutorStart_hook;
+	ExecutorStart_hook = pgstrom_cost_calibration_executor_start;
+	executor_end_next = ExecutorEnd_hook;
+	ExecutorEnd_hook = pgstrom_cost_calibration_executor_end;
+}
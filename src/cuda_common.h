@@ -120,6 +120,12 @@ typedef struct {
 	uint32_t		n_rels;			/* >0, if JOIN is involved */
 	uint32_t		groupby_prepfn_bufsz;
 	uint32_t		groupby_prepfn_nbufs;
+	uint32_t		inner_part_id;	/* current partition of grace hash-join */
+	uint32_t		right_outer_depth; /* >0, if the kernel emits unmatched
+										* inner tuples of RIGHT/FULL OUTER
+										* JOIN at this depth */
+	uint32_t		join_prefilter_mask; /* depths whose bloom-filter is
+										  * applied at the first depth */
 	/* suspend/resume support */
 	bool			resume_context;
 	uint32_t		suspend_count;
@@ -127,6 +133,11 @@ typedef struct {
 	uint32_t		nitems_raw;		/* nitems in the raw data chunk */
 	uint32_t		nitems_in;		/* nitems after the scan_quals */
 	uint32_t		nitems_out;		/* nitems of final results */
+	/* adaptive reordering of scan-quals */
+	uint32_t		scan_quals_nquals;	/* 0, if not adaptive */
+	uint64_t		scan_quals_order;	/* see kern_context */
+	uint32_t		scan_quals_nevals[KERN_ADAPTIVE_QUALS_MAX];
+	uint32_t		scan_quals_npassed[KERN_ADAPTIVE_QUALS_MAX];
 	struct {
 		uint32_t	nitems_gist;	/* nitems picked up by GiST index */
 		uint32_t	nitems_out;		/* nitems after this depth */
@@ -320,5 +331,11 @@ kern_gpujoin_main(kern_session_info *session,
 				  kern_data_store *kds_src,
 				  kern_data_extra *kds_extra,
 				  kern_data_store *kds_dst);
+KERNEL_FUNCTION(void)
+kern_gpusort_bitonic_step(kern_session_info *session,
+						  kern_gputask *kgtask,
+						  kern_data_store *kds_dst,
+						  uint32_t unitsz,
+						  bool reversing);
 
 #endif	/* CUDA_COMMON_H */
@@ -32,6 +32,8 @@ execGpuJoinNestLoop(kern_context *kcxt,
 	uint32_t	wr_pos;
 	uint32_t	count;
 	bool		left_outer = kmrels->chunks[depth-1].left_outer;
+	bool		semi_join = kmrels->chunks[depth-1].semi_join;
+	bool		anti_join = kmrels->chunks[depth-1].anti_join;
 	bool		tuple_is_valid = false;
 
 	if (WARP_WRITE_POS(wp,depth) >= WARP_READ_POS(wp,depth) + get_local_size())
@@ -44,7 +46,8 @@ execGpuJoinNestLoop(kern_context *kcxt,
 	}
 
 	if (__syncthreads_count(l_state < kds_heap->nitems) == 0 &&
-		(!left_outer || __syncthreads_count(l_state != UINT_MAX) == 0))
+		((!left_outer && !anti_join) ||
+		 __syncthreads_count(l_state != UINT_MAX) == 0))
 	{
 		/*
 		 * OK, all the threads in this block reached to end of the inner
@@ -83,7 +86,7 @@ execGpuJoinNestLoop(kern_context *kcxt,
 	rd_pos = WARP_READ_POS(wp,depth-1) + get_local_id();
 	kcxt->kvecs_curr_id = (rd_pos % KVEC_UNITSZ);
 	kcxt->kvecs_curr_buffer = src_kvecs_buffer;
-	if (rd_pos < WARP_WRITE_POS(wp,depth-1))
+	if (rd_pos < WARP_WRITE_POS(wp,depth-1) && l_state != UINT_MAX)
 	{
 		uint32_t	index = l_state++;
 
@@ -112,10 +115,21 @@ execGpuJoinNestLoop(kern_context *kcxt,
 				assert(tupitem->rowid < kds_heap->nitems);
 				oj_map[tupitem->rowid] = true;
 			}
+			if (anti_join && matched)
+			{
+				/* ANTI JOIN never emits the outer tuple once matched */
+				tuple_is_valid = false;
+				l_state = UINT_MAX;
+			}
+			else if (semi_join && tuple_is_valid)
+			{
+				/* SEMI JOIN emits the outer tuple on the first match only */
+				l_state = UINT_MAX;
+			}
 		}
-		else if (left_outer && index >= kds_heap->nitems && !matched)
+		else if ((left_outer || anti_join) && !matched)
 		{
-			/* fill up NULL fields, if FULL/LEFT OUTER JOIN */
+			/* fill up NULL fields, if FULL/LEFT OUTER or ANTI JOIN */
 			kexp = SESSION_KEXP_LOAD_VARS(kcxt->session, depth);
 			ExecLoadVarsHeapTuple(kcxt, kexp, depth, kds_heap, NULL);
 			tuple_is_valid = true;
@@ -159,6 +173,100 @@ execGpuJoinNestLoop(kern_context *kcxt,
 	return depth;
 }
 
+/*
+ * __execGpuJoinBloomPreFilter
+ *
+ * It checks the bloom-filter of the later depths using the hash-value
+ * computed by the base relation only, then returns false if the outer
+ * tuple never match at any of these depths.
+ */
+STATIC_FUNCTION(bool)
+__execGpuJoinBloomPreFilter(kern_context *kcxt,
+							kern_multirels *kmrels,
+							uint32_t prefilter_mask)
+{
+	for (int k=2; (prefilter_mask >> k) != 0; k++)
+	{
+		const kern_expression *kexp;
+		uint32_t   *bloom;
+		xpu_int4_t	hash;
+
+		if ((prefilter_mask & (1U << k)) == 0)
+			continue;
+		assert(k <= kmrels->num_rels);
+		bloom = KERN_MULTIRELS_BLOOM_FILTER(kmrels, k-1);
+		kexp = SESSION_KEXP_HASH_VALUE(kcxt->session, k);
+		if (!bloom || !kexp || kmrels->chunks[k-1].num_parts > 1)
+			continue;
+		if (!EXEC_KERN_EXPRESSION(kcxt, kexp, &hash))
+			return true;	/* error shall be checked by the caller */
+		if (!XPU_DATUM_ISNULL(&hash) &&
+			!kern_bloom_filter_check(bloom,
+									 kmrels->chunks[k-1].bloom_nbits,
+									 hash.value))
+			return false;
+	}
+	return true;
+}
+
+/*
+ * __execGpuJoinRangeJoinKey
+ *
+ * It normalizes the join-key to int64; used by the range-join and by
+ * the hash-join with direct-address map.
+ */
+STATIC_FUNCTION(bool)
+__execGpuJoinRangeJoinKey(kern_context *kcxt,
+						  const kern_expression *kexp,
+						  int64_t *p_key,
+						  bool *p_isnull)
+{
+	const kern_expression *karg = KEXP_FIRST_ARG(kexp);
+	union {
+		xpu_int2_t		i2;
+		xpu_int4_t		i4;
+		xpu_int8_t		i8;
+		xpu_date_t		date;
+		xpu_timestamp_t	ts;
+		xpu_timestamptz_t tstz;
+	} datum;
+
+	assert(kexp->nr_args == 1 && karg != NULL);
+	if (!EXEC_KERN_EXPRESSION(kcxt, karg, &datum))
+		return false;
+	if (XPU_DATUM_ISNULL(&datum.i8))
+	{
+		*p_isnull = true;
+		return true;
+	}
+	switch (karg->exptype)
+	{
+		case TypeOpCode__int2:
+			*p_key = datum.i2.value;
+			break;
+		case TypeOpCode__int4:
+			*p_key = datum.i4.value;
+			break;
+		case TypeOpCode__int8:
+			*p_key = datum.i8.value;
+			break;
+		case TypeOpCode__date:
+			*p_key = datum.date.value;
+			break;
+		case TypeOpCode__timestamp:
+			*p_key = datum.ts.value;
+			break;
+		case TypeOpCode__timestamptz:
+			*p_key = datum.tstz.value;
+			break;
+		default:
+			STROM_ELOG(kcxt, "unsupported range-join key type");
+			return false;
+	}
+	*p_isnull = false;
+	return true;
+}
+
 /*
  * GPU Hash-Join
  */
@@ -167,13 +275,22 @@ execGpuJoinHashJoin(kern_context *kcxt,
 					kern_warp_context *wp,
 					kern_multirels *kmrels,
 					int			depth,
+					uint32_t	part_id,
+					uint32_t	prefilter_mask,
 					char	   *src_kvecs_buffer,
 					char	   *dst_kvecs_buffer,
 					uint32_t   &l_state,
 					bool	   &matched)
 {
-	kern_data_store *kds_hash = KERN_MULTIRELS_INNER_KDS(kmrels, depth-1);
+	kern_data_store *kds_hash = KERN_MULTIRELS_INNER_PART_KDS(kmrels, depth-1, part_id);
+	uint32_t	num_parts = kmrels->chunks[depth-1].num_parts;
 	bool	   *oj_map = KERN_MULTIRELS_OUTER_JOIN_MAP(kmrels, depth-1);
+	uint32_t   *bloom = KERN_MULTIRELS_BLOOM_FILTER(kmrels, depth-1);
+	kern_hash_bucket *hbucket = KERN_MULTIRELS_HASH_BUCKET(kmrels, depth-1);
+	kern_direct_map *dmap = KERN_MULTIRELS_DIRECT_MAP(kmrels, depth-1);
+	uint32_t	hpos = 0;
+	bool		semi_join = kmrels->chunks[depth-1].semi_join;
+	bool		anti_join = kmrels->chunks[depth-1].anti_join;
 	kern_expression *kexp = NULL;
 	kern_hashitem *khitem = NULL;
 	uint32_t	rd_pos;
@@ -239,7 +356,23 @@ execGpuJoinHashJoin(kern_context *kcxt,
 	if (l_state == 0)
 	{
 		/* pick up the first item from the hash-slot */
-		if (rd_pos < wr_pos)
+		if (rd_pos < wr_pos && prefilter_mask != 0 &&
+			!__execGpuJoinBloomPreFilter(kcxt, kmrels, prefilter_mask))
+		{
+			/* never match at the later depths */
+			l_state = UINT_MAX;
+		}
+		else if (rd_pos < wr_pos && dmap)
+		{
+			int64_t		key;
+			bool		isnull;
+
+			/* direct-address map needs neither hash value nor bloom-filter */
+			kexp = SESSION_KEXP_HASH_VALUE(kcxt->session, depth);
+			if (__execGpuJoinRangeJoinKey(kcxt, kexp, &key, &isnull) && !isnull)
+				khitem = KDS_DIRECT_MAP_LOOKUP(kds_hash, dmap, key, &hpos);
+		}
+		else if (rd_pos < wr_pos)
 		{
 			xpu_int4_t	hash;
 
@@ -247,9 +380,28 @@ execGpuJoinHashJoin(kern_context *kcxt,
 			if (EXEC_KERN_EXPRESSION(kcxt, kexp, &hash))
 			{
 				assert(!XPU_DATUM_ISNULL(&hash));
-				for (khitem = KDS_HASH_FIRST_ITEM(kds_hash, hash.value);
-					 khitem != NULL && khitem->hash != hash.value;
-					 khitem = KDS_HASH_NEXT_ITEM(kds_hash, khitem->next));
+				/*
+				 * In case of grace hash-join, outer tuples that belong to
+				 * other partitions never match in this round.
+				 * Also, bloom-filter (if any) tells us the outer tuple
+				 * never match without walking on the hash-slot.
+				 */
+				if ((num_parts <= 1 ||
+					 KERN_HASH_PARTITION_ID(hash.value, num_parts) == part_id) &&
+					(!bloom || kern_bloom_filter_check(bloom,
+													   kmrels->chunks[depth-1].bloom_nbits,
+													   hash.value)))
+				{
+					if (hbucket)
+						khitem = KDS_HASH_BUCKET_LOOKUP(kds_hash, hbucket,
+														hash.value, &hpos);
+					else
+					{
+						for (khitem = KDS_HASH_FIRST_ITEM(kds_hash, hash.value);
+							 khitem != NULL && khitem->hash != hash.value;
+							 khitem = KDS_HASH_NEXT_ITEM(kds_hash, khitem->next));
+					}
+				}
 			}
 		}
 		else
@@ -257,6 +409,25 @@ execGpuJoinHashJoin(kern_context *kcxt,
 			l_state = UINT_MAX;
 		}
 	}
+	else if (l_state != UINT_MAX && dmap)
+	{
+		/* pick up the next one with the identical key, if any */
+		int64_t		key;
+		bool		isnull;
+
+		hpos = l_state;
+		kexp = SESSION_KEXP_HASH_VALUE(kcxt->session, depth);
+		if (__execGpuJoinRangeJoinKey(kcxt, kexp, &key, &isnull) && !isnull)
+			khitem = KDS_DIRECT_MAP_LOOKUP(kds_hash, dmap, key, &hpos);
+	}
+	else if (l_state != UINT_MAX && hbucket)
+	{
+		/* pick up the next one from the hash-bucket, if any */
+		uint32_t	hash_value = KERN_HASH_BUCKET_HASHES(hbucket)[l_state-1];
+
+		hpos = l_state;
+		khitem = KDS_HASH_BUCKET_LOOKUP(kds_hash, hbucket, hash_value, &hpos);
+	}
 	else if (l_state != UINT_MAX)
 	{
 		/* pick up the next one if any */
@@ -292,11 +463,25 @@ execGpuJoinHashJoin(kern_context *kcxt,
 			assert(khitem->t.rowid < kds_hash->nitems);
 			oj_map[khitem->t.rowid] = true;
 		}
-		l_state = __kds_packed((char *)khitem - (char *)kds_hash);
+		if (anti_join && matched)
+		{
+			/* ANTI JOIN never emits the outer tuple once matched */
+			tuple_is_valid = false;
+			l_state = UINT_MAX;
+		}
+		else if (semi_join && tuple_is_valid)
+		{
+			/* SEMI JOIN emits the outer tuple on the first match only */
+			l_state = UINT_MAX;
+		}
+		else if (hbucket || dmap)
+			l_state = hpos + 1;
+		else
+			l_state = __kds_packed((char *)khitem - (char *)kds_hash);
 	}
 	else
 	{
-		if (kmrels->chunks[depth-1].left_outer &&
+		if ((kmrels->chunks[depth-1].left_outer || anti_join) &&
 			l_state != UINT_MAX && !matched)
 		{
 			/* load NULL values on the inner portion */
@@ -335,6 +520,190 @@ execGpuJoinHashJoin(kern_context *kcxt,
 	return depth;
 }
 
+/*
+ * GPU Range-Join
+ */
+STATIC_FUNCTION(int)
+execGpuJoinRangeJoin(kern_context *kcxt,
+					 kern_warp_context *wp,
+					 kern_multirels *kmrels,
+					 int		depth,
+					 char	   *src_kvecs_buffer,
+					 char	   *dst_kvecs_buffer,
+					 uint32_t  &l_state,
+					 bool	   &matched)
+{
+	kern_data_store *kds_heap = KERN_MULTIRELS_INNER_KDS(kmrels, depth-1);
+	kern_range_index *ridx = KERN_MULTIRELS_RANGE_INDEX(kmrels, depth-1);
+	bool	   *oj_map = KERN_MULTIRELS_OUTER_JOIN_MAP(kmrels, depth-1);
+	bool		semi_join = kmrels->chunks[depth-1].semi_join;
+	bool		anti_join = kmrels->chunks[depth-1].anti_join;
+	kern_expression *kexp = NULL;
+	kern_tupitem *tupitem = NULL;
+	uint32_t	rpos = 0;
+	uint32_t	rd_pos;
+	uint32_t	wr_pos;
+	uint32_t	count;
+	bool		tuple_is_valid = false;
+
+	if (WARP_WRITE_POS(wp,depth) >= WARP_READ_POS(wp,depth) + get_local_size())
+	{
+		/*
+		 * Next depth already keeps blockSize or more pending tuples,
+		 * so wipe out these tuples first.
+		 */
+		return depth+1;
+	}
+
+	if (__syncthreads_count(l_state != UINT_MAX) == 0)
+	{
+		/*
+		 * OK, all the threads in this block reached to the end of the
+		 * candidates on the range-index. See execGpuJoinHashJoin().
+		 */
+		if (get_local_id() == 0)
+			WARP_READ_POS(wp,depth-1) = Min(WARP_READ_POS(wp,depth-1) + get_local_size(),
+											WARP_WRITE_POS(wp,depth-1));
+		__syncthreads();
+		l_state = 0;
+		matched = false;
+		if (wp->scan_done < depth)
+		{
+			/*
+			 * The previous depth still may generate the source tuple.
+			 */
+			if (WARP_WRITE_POS(wp,depth-1) < WARP_READ_POS(wp,depth-1) + get_local_size())
+				return depth-1;
+		}
+		else
+		{
+			assert(wp->scan_done == depth);
+			if (WARP_READ_POS(wp,depth-1) >= WARP_WRITE_POS(wp,depth-1))
+			{
+				if (get_local_id() == 0)
+					wp->scan_done = depth+1;
+				return depth+1;
+			}
+		}
+	}
+	wr_pos = WARP_WRITE_POS(wp,depth-1);
+	rd_pos = WARP_READ_POS(wp,depth-1) + get_local_id();
+	kcxt->kvecs_curr_id = (rd_pos % KVEC_UNITSZ);
+	kcxt->kvecs_curr_buffer = src_kvecs_buffer;
+
+	if (rd_pos < wr_pos && l_state != UINT_MAX)
+	{
+		int64_t		key;
+		bool		isnull;
+
+		/*
+		 * l_state is the position of the last candidate + 1, or 0 at the
+		 * first call. The candidates are walked on backward from the last
+		 * item whose lower bound is less than or equal to the outer key.
+		 */
+		kexp = SESSION_KEXP_HASH_VALUE(kcxt->session, depth);
+		if (__execGpuJoinRangeJoinKey(kcxt, kexp, &key, &isnull) && !isnull)
+		{
+			const int64_t  *upper = KERN_RANGE_INDEX_UPPER(ridx);
+			const int64_t  *upper_max = KERN_RANGE_INDEX_UPPER_MAX(ridx);
+
+			rpos = (l_state == 0
+					? KERN_RANGE_INDEX_SEARCH(ridx, key)
+					: l_state - 1);
+			while (rpos > 0 && upper_max[rpos-1] >= key)
+			{
+				rpos--;
+				if (upper[rpos] >= key)
+				{
+					tupitem = KDS_GET_TUPITEM(kds_heap, KERN_RANGE_INDEX_ROWIDS(ridx)[rpos]);
+					break;
+				}
+			}
+		}
+	}
+	else
+	{
+		l_state = UINT_MAX;
+	}
+	/* error checks */
+	if (__syncthreads_count(kcxt->errcode != ERRCODE_STROM_SUCCESS) > 0)
+		return -1;
+
+	if (tupitem)
+	{
+		xpu_int4_t	status;
+
+		kexp = SESSION_KEXP_LOAD_VARS(kcxt->session, depth);
+		ExecLoadVarsHeapTuple(kcxt, kexp, depth, kds_heap, &tupitem->htup);
+		kexp = SESSION_KEXP_JOIN_QUALS(kcxt->session, depth);
+		if (EXEC_KERN_EXPRESSION(kcxt, kexp, &status))
+		{
+			assert(!XPU_DATUM_ISNULL(&status));
+			if (status.value > 0)
+				tuple_is_valid = true;
+			if (status.value != 0)
+				matched = true;
+		}
+		if (oj_map && matched)
+		{
+			assert(tupitem->rowid < kds_heap->nitems);
+			oj_map[tupitem->rowid] = true;
+		}
+		if (anti_join && matched)
+		{
+			/* ANTI JOIN never emits the outer tuple once matched */
+			tuple_is_valid = false;
+			l_state = UINT_MAX;
+		}
+		else if (semi_join && tuple_is_valid)
+		{
+			/* SEMI JOIN emits the outer tuple on the first match only */
+			l_state = UINT_MAX;
+		}
+		else
+			l_state = rpos + 1;
+	}
+	else
+	{
+		if ((kmrels->chunks[depth-1].left_outer || anti_join) &&
+			l_state != UINT_MAX && !matched)
+		{
+			/* load NULL values on the inner portion */
+			kexp = SESSION_KEXP_LOAD_VARS(kcxt->session, depth);
+			ExecLoadVarsHeapTuple(kcxt, kexp, depth, kds_heap, NULL);
+			tuple_is_valid = true;
+		}
+		l_state = UINT_MAX;
+	}
+	/* error checks */
+	if (__syncthreads_count(kcxt->errcode != ERRCODE_STROM_SUCCESS) > 0)
+		return -1;
+	/* save the result on the destination buffer */
+	wr_pos = WARP_WRITE_POS(wp,depth);
+	wr_pos += pgstrom_stair_sum_binary(tuple_is_valid, &count);
+	if (get_local_id() == 0)
+		WARP_WRITE_POS(wp,depth) += count;
+
+	if (tuple_is_valid)
+	{
+		const kern_expression  *kexp_move
+			= SESSION_KEXP_MOVE_VARS(kcxt->session, depth);
+		if (!ExecMoveKernelVariables(kcxt,
+									 kexp_move,
+									 dst_kvecs_buffer,
+									 (wr_pos % KVEC_UNITSZ)))
+		{
+			assert(kcxt->errcode != ERRCODE_STROM_SUCCESS);
+		}
+	}
+	/* error checks */
+	if (__syncthreads_count(kcxt->errcode != ERRCODE_STROM_SUCCESS) > 0)
+		return -1;
+	if (WARP_WRITE_POS(wp,depth) >= WARP_READ_POS(wp,depth) + get_local_size())
+		return depth+1;
+	return depth;
+}
+
 /*
  * gpujoin_prep_gistindex
  */
@@ -392,6 +761,89 @@ gpujoin_prep_gistindex(kern_multirels *kmrels, int depth)
 	}
 }
 
+/*
+ * gpujoin_prep_hashbucket
+ *
+ * It builds the hash-bucket of the inner hash table from the hash-slot
+ * that are already linked by the inner preloading. It consists of three
+ * phases; (0) counts the number of items for each hash-slot, (1) prefix
+ * sum of the counters by a single thread block, then (2) each thread
+ * walks on the hash-slot and puts the items sorted by the hash value.
+ */
+KERNEL_FUNCTION(void)
+gpujoin_prep_hashbucket(kern_multirels *kmrels, int depth, int phase)
+{
+	kern_data_store *kds_hash = KERN_MULTIRELS_INNER_KDS(kmrels, depth-1);
+	kern_hash_bucket *hbucket = KERN_MULTIRELS_HASH_BUCKET(kmrels, depth-1);
+	uint32_t		nslots = hbucket->nslots;
+	uint32_t	   *hashes = KERN_HASH_BUCKET_HASHES(hbucket);
+	uint32_t	   *items = KERN_HASH_BUCKET_ITEMS(hbucket);
+	kern_hashitem  *khitem;
+
+	assert(kds_hash && kds_hash->format == KDS_FORMAT_HASH &&
+		   nslots == kds_hash->hash_nslots);
+	if (phase == 0)
+	{
+		for (uint32_t k = get_global_id(); k < nslots; k += get_global_size())
+		{
+			uint32_t	count = 0;
+
+			for (khitem = KDS_HASH_FIRST_ITEM(kds_hash, k);
+				 khitem != NULL;
+				 khitem = KDS_HASH_NEXT_ITEM(kds_hash, khitem->next))
+				count++;
+			hbucket->start[k] = count;
+		}
+	}
+	else if (phase == 1)
+	{
+		uint32_t	base = 0;
+
+		/* launched with a single thread block */
+		assert(get_num_groups() == 1);
+		for (uint32_t k_base = 0; k_base <= nslots; k_base += get_local_size())
+		{
+			uint32_t	k = k_base + get_local_id();
+			uint32_t	count = (k < nslots ? hbucket->start[k] : 0);
+			uint32_t	total;
+			uint32_t	pos;
+
+			pos = pgstrom_stair_sum_uint32(count, &total);
+			if (k <= nslots)
+				hbucket->start[k] = base + pos - count;
+			base += total;
+		}
+	}
+	else
+	{
+		for (uint32_t k = get_global_id(); k < nslots; k += get_global_size())
+		{
+			uint32_t	head = hbucket->start[k];
+			uint32_t	hpos = head;
+
+			/* insertion sort; items are usually a few in a hash-slot */
+			for (khitem = KDS_HASH_FIRST_ITEM(kds_hash, k);
+				 khitem != NULL;
+				 khitem = KDS_HASH_NEXT_ITEM(kds_hash, khitem->next))
+			{
+				uint32_t	hash = khitem->hash;
+				uint32_t	j = hpos++;
+
+				assert(hpos <= hbucket->start[k+1]);
+				while (j > head && hashes[j-1] > hash)
+				{
+					hashes[j] = hashes[j-1];
+					items[j] = items[j-1];
+					j--;
+				}
+				hashes[j] = hash;
+				items[j] = __kds_packed((char *)kds_hash +
+										kds_hash->length - (char *)khitem);
+			}
+		}
+	}
+}
+
 /*
  * GiST-INDEX-JOIN
  */
@@ -584,6 +1036,92 @@ execGpuJoinGiSTJoin(kern_context *kcxt,
 	return depth;
 }
 
+/*
+ * RIGHT/FULL OUTER JOIN (unmatched inner tuples)
+ *
+ * It works as a source of the depth, instead of the outer relation scan.
+ * Inner tuples that are not marked on the outer-join-map are loaded with
+ * NULLs on the outer portion, then written to the kvecs buffer of this
+ * depth; the next depths and projection process them as usual.
+ */
+STATIC_FUNCTION(int)
+execGpuJoinRightOuter(kern_context *kcxt,
+					  kern_warp_context *wp,
+					  kern_multirels *kmrels,
+					  int		depth,
+					  char	   *null_kvecs_buffer,
+					  char	   *dst_kvecs_buffer)
+{
+	kern_data_store *kds_in = KERN_MULTIRELS_INNER_KDS(kmrels, depth-1);
+	bool	   *oj_map = KERN_MULTIRELS_OUTER_JOIN_MAP(kmrels, depth-1);
+	kern_tupitem *tupitem = NULL;
+	uint32_t	count;
+	uint32_t	index;
+	uint32_t	wr_pos;
+
+	assert(oj_map != NULL);
+	if (wp->scan_done > depth ||
+		WARP_WRITE_POS(wp,depth) >= WARP_READ_POS(wp,depth) + get_local_size())
+		return depth+1;
+
+	/* kvecs buffer of the outer portion is all NULLs */
+	kcxt->kvecs_curr_buffer = null_kvecs_buffer;
+	kcxt->kvecs_curr_id = 0;
+
+	/* compute the next row-index */
+	count = wp->smx_row_count;
+	__syncthreads();
+	if (get_local_id() == 0)
+		wp->smx_row_count++;
+	index = get_global_size() * count + get_global_base();
+	if (index >= kds_in->nitems)
+	{
+		if (get_local_id() == 0)
+			wp->scan_done = depth+1;
+		__syncthreads();
+		return depth+1;
+	}
+	index += get_local_id();
+
+	/* fetch the inner tuple never matched */
+	if (index < kds_in->nitems && !oj_map[index])
+	{
+		tupitem = KDS_GET_TUPITEM(kds_in, index);
+		if (tupitem)
+		{
+			const kern_expression *kexp_load
+				= SESSION_KEXP_LOAD_VARS(kcxt->session, depth);
+			ExecLoadVarsHeapTuple(kcxt, kexp_load, depth, kds_in, &tupitem->htup);
+		}
+	}
+	/* error checks */
+	if (__syncthreads_count(kcxt->errcode != ERRCODE_STROM_SUCCESS) > 0)
+		return -1;
+	/* save the result on the destination buffer */
+	wr_pos = WARP_WRITE_POS(wp,depth);
+	wr_pos += pgstrom_stair_sum_binary(tupitem != NULL, &count);
+	if (get_local_id() == 0)
+		WARP_WRITE_POS(wp,depth) += count;
+	if (tupitem != NULL)
+	{
+		const kern_expression *kexp_move
+			= SESSION_KEXP_MOVE_VARS(kcxt->session, depth);
+		if (!ExecMoveKernelVariables(kcxt,
+									 kexp_move,
+									 dst_kvecs_buffer,
+									 (wr_pos % KVEC_UNITSZ)))
+		{
+			assert(kcxt->errcode != ERRCODE_STROM_SUCCESS);
+		}
+	}
+	/* error checks */
+	if (__syncthreads_count(kcxt->errcode != ERRCODE_STROM_SUCCESS) > 0)
+		return -1;
+	if (WARP_WRITE_POS(wp,depth) >= WARP_READ_POS(wp,depth) + get_local_size())
+		return depth+1;
+	return depth;
+}
+
 /*
  * GPU Projection
  */
@@ -629,11 +1167,34 @@ execGpuJoinProjection(kern_context *kcxt,
 	if (__syncthreads_count(kcxt->errcode != ERRCODE_STROM_SUCCESS) > 0)
 		return -1;
 	/* allocation of the destination buffer */
-	assert(kds_dst->format == KDS_FORMAT_ROW &&
+	assert((kds_dst->format == KDS_FORMAT_ROW ||
+			kds_dst->format == KDS_FORMAT_COLUMN) &&
 		   tupsz == MAXALIGN(tupsz));
 	row_id = pgstrom_stair_sum_binary(tupsz > 0, &count);
 	offset = pgstrom_stair_sum_uint32(tupsz, &total_sz);
-	if (get_local_id() == 0)
+	if (kds_dst->format == KDS_FORMAT_COLUMN)
+	{
+		/* columnar results; only row-ids are reserved */
+		if (get_local_id() == 0)
+		{
+			uint32_t	oldval, curval, newval;
+
+			curval = kds_dst->nitems;
+			do {
+				newval = oldval = curval;
+				newval += count;
+				if (newval > kds_dst->column_nrooms)
+				{
+					try_suspend = true;
+					break;
+				}
+			} while ((curval = atomicCAS(&kds_dst->nitems,
+										 oldval,
+										 newval)) != oldval);
+			base_rowid = oldval;
+		}
+	}
+	else if (get_local_id() == 0)
 	{
 		union {
 			struct {
@@ -669,7 +1230,14 @@ execGpuJoinProjection(kern_context *kcxt,
 		return -1;
 	}
 	/* write out the tuple */
-	if (tupsz > 0)
+	if (tupsz > 0 && kds_dst->format == KDS_FORMAT_COLUMN)
+	{
+		kern_form_column_item(kcxt,
+							  kexp_projection,
+							  kds_dst,
+							  row_id + base_rowid);
+	}
+	else if (tupsz > 0)
 	{
 		kern_tupitem   *tupitem;
 
@@ -732,6 +1300,8 @@ kern_gpujoin_main(kern_session_info *session,
 		   kgtask->n_rels       == n_rels);
 	/* setup execution context */
 	INIT_KERNEL_CONTEXT(kcxt, session);
+	kcxt->scan_quals_order = kgtask->scan_quals_order;
+	kcxt->kmrels = kmrels;
 	wp_base_sz = __KERN_WARP_CONTEXT_BASESZ(kgtask->kvecs_ndims);
 	wp = (kern_warp_context *)SHARED_WORKMEM(0);
 	INIT_KERN_GPUTASK_SUBFIELDS(kgtask,
@@ -762,6 +1332,22 @@ kern_gpujoin_main(kern_session_info *session,
 			l_state[d * get_global_size() + get_global_id()] = 0;
 			matched[d * get_global_size() + get_global_id()] = false;
 		}
+		/*
+		 * RIGHT/FULL OUTER JOIN starts from the depth of the outer-join,
+		 * and the kvecs buffer of the previous depth is filled by NULLs
+		 * (every kvec_datum_t begins with isnull[] array).
+		 */
+		if (kgtask->right_outer_depth > 0)
+		{
+			char   *null_kvecs_buffer = __KVEC_BUFFER(kgtask->right_outer_depth-1);
+
+			assert(kgtask->right_outer_depth <= n_rels);
+			for (int i=get_local_id(); i < kcxt->kvecs_bufsz; i += get_local_size())
+				null_kvecs_buffer[i] = true;
+			if (get_local_id() == 0)
+				wp->scan_done = kgtask->right_outer_depth;
+			depth = kgtask->right_outer_depth;
+		}
 	}
 	__syncthreads();
 #define __L_STATE(__depth)						\
@@ -784,6 +1370,15 @@ kern_gpujoin_main(kern_session_info *session,
 										  SESSION_KEXP_MOVE_VARS(session, 0),
 										  __KVEC_BUFFER(0));
 		}
+		else if (depth == kgtask->right_outer_depth)
+		{
+			/* LOAD UNMATCHED INNER TUPLES OF RIGHT/FULL OUTER JOIN */
+			depth = execGpuJoinRightOuter(kcxt, wp,
+										  kmrels,
+										  depth,
+										  __KVEC_BUFFER(depth-1),
+										  __KVEC_BUFFER(depth));
+		}
 		else if (depth > n_rels)
 		{
 			bool	try_suspend = false;
@@ -815,6 +1410,17 @@ kern_gpujoin_main(kern_session_info *session,
 				assert(depth < 0);
 			}
 		}
+		else if (kmrels->chunks[depth-1].range_offset != 0)
+		{
+			/* RANGE-JOIN */
+			depth = execGpuJoinRangeJoin(kcxt, wp,
+										 kmrels,
+										 depth,
+										 __KVEC_BUFFER(depth-1),
+										 __KVEC_BUFFER(depth),
+										 __L_STATE(depth),	/* call by reference */
+										 __MATCHED(depth));	/* call by reference */
+		}
 		else if (kmrels->chunks[depth-1].is_nestloop)
 		{
 			/* NEST-LOOP */
@@ -854,6 +1460,8 @@ kern_gpujoin_main(kern_session_info *session,
 			depth = execGpuJoinHashJoin(kcxt, wp,
 										kmrels,
 										depth,
+										kgtask->inner_part_id,
+										(depth == 1 ? kgtask->join_prefilter_mask : 0),
 										__KVEC_BUFFER(depth-1),
 										__KVEC_BUFFER(depth),
 										__L_STATE(depth),	/* call by reference */
@@ -877,7 +1485,9 @@ kern_gpujoin_main(kern_session_info *session,
 		if (depth < 0 && WARP_READ_POS(wp,n_rels) >= WARP_WRITE_POS(wp,n_rels))
 		{
 			/* number of raw-tuples fetched from the heap block */
-			if (kds_src->format == KDS_FORMAT_BLOCK)
+			if (!kds_src)
+				;	/* RIGHT/FULL OUTER JOIN has no source buffer */
+			else if (kds_src->format == KDS_FORMAT_BLOCK)
 				atomicAdd(&kgtask->nitems_raw, wp->lp_wr_pos);
 			else if (get_global_id() == 0)
 				atomicAdd(&kgtask->nitems_raw, kds_src->nitems);
@@ -904,5 +1514,22 @@ kern_gpujoin_main(kern_session_info *session,
 		wp->depth = depth;
 		memcpy(wp_saved, wp, wp_base_sz);
 	}
+	/* pass rate of the scan-quals, if adaptive */
+	for (int i=0; i < kgtask->scan_quals_nquals; i++)
+	{
+		uint32_t	nevals = kcxt->scan_quals_nevals[i];
+		uint32_t	npassed = kcxt->scan_quals_npassed[i];
+
+		for (int mask=1; mask < warpSize; mask <<= 1)
+		{
+			nevals  += __shfl_xor_sync(__activemask(), nevals, mask);
+			npassed += __shfl_xor_sync(__activemask(), npassed, mask);
+		}
+		if (LaneId() == 0 && nevals > 0)
+		{
+			atomicAdd(&kgtask->scan_quals_nevals[i], nevals);
+			atomicAdd(&kgtask->scan_quals_npassed[i], npassed);
+		}
+	}
 	STROM_WRITEBACK_ERROR_STATUS(&kgtask->kerror, kcxt);
 }
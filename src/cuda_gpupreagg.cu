@@ -161,6 +161,17 @@ __writeOutOneTuplePreAgg(kern_context *kcxt,
 				t_infomask |= HEAP_HASVARWIDTH;
 				break;
 
+			case KAGG_ACTION__PSUM_NUMERIC:
+			case KAGG_ACTION__PAVG_NUMERIC:
+				nbytes = sizeof(kagg_state__psum_numeric_packed);
+				if (buffer)
+				{
+					memset(buffer, 0, sizeof(kagg_state__psum_numeric_packed));
+					SET_VARSIZE(buffer, sizeof(kagg_state__psum_numeric_packed));
+				}
+				t_infomask |= HEAP_HASVARWIDTH;
+				break;
+
 			case KAGG_ACTION__STDDEV:
 				nbytes = sizeof(kagg_state__stddev_packed);
 				if (buffer)
@@ -181,6 +192,44 @@ __writeOutOneTuplePreAgg(kern_context *kcxt,
 				t_infomask |= HEAP_HASVARWIDTH;
 				break;
 
+			case KAGG_ACTION__PQUANTILE:
+				nbytes = sizeof(kagg_state__pquantile_packed);
+				if (buffer)
+				{
+					kagg_state__pquantile_packed *r =
+						(kagg_state__pquantile_packed *)buffer;
+
+					memset(r, 0, sizeof(kagg_state__pquantile_packed));
+					r->fraction  = 0.5;
+					r->min_value = DBL_MAX;
+					r->max_value = -DBL_MAX;
+					SET_VARSIZE(r, sizeof(kagg_state__pquantile_packed));
+				}
+				t_infomask |= HEAP_HASVARWIDTH;
+				break;
+
+			case KAGG_ACTION__PTOPK:
+				nbytes = sizeof(kagg_state__ptopk_packed);
+				if (buffer)
+				{
+					memset(buffer, 0, sizeof(kagg_state__ptopk_packed));
+					SET_VARSIZE(buffer, sizeof(kagg_state__ptopk_packed));
+				}
+				t_infomask |= HEAP_HASVARWIDTH;
+				break;
+
+			case KAGG_ACTION__PARRAY:
+			case KAGG_ACTION__PARRAY_KEY:
+				nbytes = sizeof(kagg_state__parray_packed);
+				if (buffer)
+				{
+					/* data[] is not referenced beyond the usage */
+					memset(buffer, 0, offsetof(kagg_state__parray_packed, data));
+					SET_VARSIZE(buffer, sizeof(kagg_state__parray_packed));
+				}
+				t_infomask |= HEAP_HASVARWIDTH;
+				break;
+
 			default:
 				STROM_ELOG(kcxt, "unknown xpuPreAgg action");
 				return -1;
@@ -642,6 +691,133 @@ __update_nogroups__psum_fp(kern_context *kcxt,
 		}
 	}
 }
+/*
+ * __kagg_numeric_to_fixed_point
+ *
+ * It transforms the numeric datum to the fixed-point integer on the scale.
+ * Unlike CPU, GpuPreAgg has no way to continue the aggregation once an error
+ * happen, so out of range values are reported as an error.
+ */
+STATIC_FUNCTION(bool)
+__kagg_numeric_to_fixed_point(kern_context *kcxt,
+							  xpu_numeric_t *num,
+							  int scale,
+							  int128_t *p_ival)
+{
+	const int128_t	bound = ((int128_t)1 << KAGG_NUMERIC_FIXED_POINT_BITS);
+	int128_t		ival;
+
+	if (num->kind == XPU_NUMERIC_KIND__VARLENA)
+	{
+		const char *errmsg = __xpu_numeric_from_varlena(num, num->u.vl_addr);
+
+		if (errmsg)
+		{
+			STROM_ELOG(kcxt, errmsg);
+			return false;
+		}
+	}
+	if (num->kind != XPU_NUMERIC_KIND__VALID)
+	{
+		STROM_ELOG(kcxt, "NaN or Infinity is not supported by the exact numeric sum");
+		return false;
+	}
+	/* values from Arrow::Decimal are not normalized, so may have trailing zeros */
+	if (num->weight > scale)
+		set_normalized_numeric(num, num->u.value, num->weight);
+	if (num->weight > scale)
+	{
+		STROM_ELOG(kcxt, "numeric value has more digits than the scale of the exact numeric sum");
+		return false;
+	}
+	ival = num->u.value;
+	for (int k = num->weight; k < scale; k++)
+	{
+		if (ival >= bound / 10 || ival <= -bound / 10)
+			goto out_of_range;
+		ival *= 10;
+	}
+	if (ival >= bound || ival <= -bound)
+		goto out_of_range;
+	*p_ival = ival;
+	return true;
+
+out_of_range:
+	STROM_ELOG(kcxt, "numeric value is out of range of the exact numeric sum");
+	return false;
+}
+
+/*
+ * __atomic_add_psum_numeric
+ *
+ * It adds 128bit integer by a pair of 64bit atomic operations. The carry
+ * from the lower word is determined by the old value of each atomic add,
+ * so it is consistent even if concurrent threads update the same sum.
+ */
+INLINE_FUNCTION(void)
+__atomic_add_psum_numeric(kagg_state__psum_numeric_packed *r, int128_t ival)
+{
+	uint64_t	lo = (uint64_t)ival;
+	int64_t		hi = (int64_t)(ival >> 64);
+	uint64_t	oldval;
+
+	oldval = __atomic_add_uint64(&r->sum_lo, lo);
+	if (oldval + lo < oldval)
+		hi++;
+	if (hi != 0)
+		__atomic_add_int64(&r->sum_hi, hi);
+}
+
+/*
+ * __update_nogroups__psum_numeric
+ */
+INLINE_FUNCTION(void)
+__update_nogroups__psum_numeric(kern_context *kcxt,
+								char *buffer,
+								kern_colmeta *cmeta,
+								kern_aggregate_desc *desc,
+								bool source_is_valid)
+{
+	kagg_state__psum_numeric_packed *r =
+		(kagg_state__psum_numeric_packed *)buffer;
+	int128_t	ival;
+	int			count;
+
+	if (source_is_valid)
+	{
+		xpu_numeric_t  *xdatum = (xpu_numeric_t *)
+			kcxt->kvars_slot[desc->arg0_slot_id];
+		xpu_int4_t	   *sdatum = (xpu_int4_t *)
+			kcxt->kvars_slot[desc->arg1_slot_id];
+
+		if (XPU_DATUM_ISNULL(xdatum) || XPU_DATUM_ISNULL(sdatum))
+			source_is_valid = false;
+		else
+		{
+			assert(xdatum->expr_ops == &xpu_numeric_ops &&
+				   sdatum->expr_ops == &xpu_int4_ops);
+			if (!__kagg_numeric_to_fixed_point(kcxt, xdatum,
+											   sdatum->value, &ival))
+				source_is_valid = false;
+			else
+			{
+				/* 128bit sum shall be updated by each thread */
+				__atomic_add_psum_numeric(r, ival);
+				/* scale is a constant */
+				r->scale = sdatum->value;
+			}
+		}
+	}
+	count = __syncthreads_count(source_is_valid);
+	if (count > 0 && get_local_id() == 0)
+	{
+		if (__isShared(r))
+			r->nitems += count;
+		else
+			__atomic_add_uint32(&r->nitems, count);
+	}
+}
+
 /*
  * __update_nogroups__pstddev
  */
@@ -766,6 +942,230 @@ __update_nogroups__pcovar(kern_context *kcxt,
 	}
 }
 
+/*
+ * __update_nogroups__pquantile
+ */
+INLINE_FUNCTION(void)
+__update_nogroups__pquantile(kern_context *kcxt,
+							 char *buffer,
+							 kern_colmeta *cmeta,
+							 kern_aggregate_desc *desc,
+							 bool source_is_valid)
+{
+	kagg_state__pquantile_packed *r =
+		(kagg_state__pquantile_packed *)buffer;
+	float8_t	xval = 0.0;
+	float8_t	fraction = 0.0;
+	int			count;
+
+	if (source_is_valid)
+	{
+		xpu_float8_t   *xdatum = (xpu_float8_t *)
+			kcxt->kvars_slot[desc->arg0_slot_id];
+		xpu_float8_t   *fdatum = (xpu_float8_t *)
+			kcxt->kvars_slot[desc->arg1_slot_id];
+
+		if (!XPU_DATUM_ISNULL(xdatum) && !XPU_DATUM_ISNULL(fdatum))
+		{
+			assert(xdatum->expr_ops == &xpu_float8_ops &&
+				   fdatum->expr_ops == &xpu_float8_ops);
+			xval = xdatum->value;
+			fraction = fdatum->value;
+		}
+		else
+		{
+			source_is_valid = false;
+		}
+	}
+	/* histogram shall be updated by each thread */
+	if (source_is_valid)
+	{
+		int		index = __kagg_qsketch_bucket_index(xval);
+
+		if (index < 0)
+			__atomic_add_uint32(&r->nlower, 1);
+		else
+			__atomic_add_uint32(&r->buckets[index], 1);
+		__atomic_min_fp64(&r->min_value, xval);
+		__atomic_max_fp64(&r->max_value, xval);
+		/* fraction is usually a constant */
+		r->fraction = fraction;
+	}
+	count = __syncthreads_count(source_is_valid);
+	if (count > 0 && get_local_id() == 0)
+	{
+		if (__isShared(r))
+			r->nitems += count;
+		else
+			__atomic_add_uint32(&r->nitems, count);
+	}
+}
+
+/*
+ * __atomic_insert_ptopk
+ *
+ * It replaces the minimum slot by the new value, if larger. A failure of
+ * compare-and-swap means someone else updated the slot, so retry.
+ */
+INLINE_FUNCTION(void)
+__atomic_insert_ptopk(kagg_state__ptopk_packed *r, int k, uint64_t ival)
+{
+	for (;;)
+	{
+		uint64_t	min_value = __volatileRead(&r->slots[0]);
+		int			min_index = 0;
+
+		for (int i=1; i < k; i++)
+		{
+			uint64_t	curr = __volatileRead(&r->slots[i]);
+
+			if (curr < min_value)
+			{
+				min_value = curr;
+				min_index = i;
+			}
+		}
+		if (ival <= min_value)
+			break;
+		if (__atomic_cas_uint64(&r->slots[min_index],
+								min_value, ival) == min_value)
+			break;
+	}
+}
+
+INLINE_FUNCTION(bool)
+__fetch_ptopk_args(kern_context *kcxt,
+				   const kern_aggregate_desc *desc,
+				   uint64_t *p_ival, int *p_k)
+{
+	xpu_float8_t   *xdatum = (xpu_float8_t *)
+		kcxt->kvars_slot[desc->arg0_slot_id];
+	xpu_int4_t	   *kdatum = (xpu_int4_t *)
+		kcxt->kvars_slot[desc->arg1_slot_id];
+
+	if (XPU_DATUM_ISNULL(xdatum) || XPU_DATUM_ISNULL(kdatum))
+		return false;
+	assert(xdatum->expr_ops == &xpu_float8_ops &&
+		   kdatum->expr_ops == &xpu_int4_ops);
+	if (kdatum->value < 1 || kdatum->value > KAGG_TOPK_MAX_K)
+	{
+		STROM_ELOG(kcxt, "top_k: k is out of range");
+		return false;
+	}
+	*p_ival = __kagg_topk_encode(xdatum->value);
+	*p_k = kdatum->value;
+	return true;
+}
+
+/*
+ * __update_nogroups__ptopk
+ */
+INLINE_FUNCTION(void)
+__update_nogroups__ptopk(kern_context *kcxt,
+						 char *buffer,
+						 kern_colmeta *cmeta,
+						 kern_aggregate_desc *desc,
+						 bool source_is_valid)
+{
+	kagg_state__ptopk_packed *r =
+		(kagg_state__ptopk_packed *)buffer;
+	uint64_t	ival;
+	int			k;
+	int			count;
+
+	if (source_is_valid)
+		source_is_valid = __fetch_ptopk_args(kcxt, desc, &ival, &k);
+	/* slots shall be updated by each thread */
+	if (source_is_valid)
+	{
+		/* k is usually a constant */
+		r->k = k;
+		__atomic_insert_ptopk(r, k, ival);
+	}
+	count = __syncthreads_count(source_is_valid);
+	if (count > 0 && get_local_id() == 0)
+	{
+		if (__isShared(r))
+			r->nitems += count;
+		else
+			__atomic_add_uint32(&r->nitems, count);
+	}
+}
+
+/*
+ * __atomic_append_parray
+ *
+ * It reserves the space for a new item by atomic-add, then writes out the
+ * value (and the sort-key, if any) in the heap format. Only the simple base
+ * types are pushed down by the planner, so xpu_datum_write() does not need
+ * the destination colmeta.
+ */
+INLINE_FUNCTION(void)
+__atomic_append_parray(kern_context *kcxt,
+					   kagg_state__parray_packed *r,
+					   const xpu_datum_t *xdatum,
+					   const xpu_datum_t *kdatum)
+{
+	kagg_parray_item *item;
+	int32_t		vlen = -1;
+	int32_t		klen = 0;
+	uint32_t	sz, pos;
+
+	if (!XPU_DATUM_ISNULL(xdatum))
+	{
+		vlen = xdatum->expr_ops->xpu_datum_write(kcxt, NULL, NULL, xdatum);
+		if (vlen < 0)
+			return;
+	}
+	if (kdatum)
+	{
+		klen = -1;
+		if (!XPU_DATUM_ISNULL(kdatum))
+		{
+			klen = kdatum->expr_ops->xpu_datum_write(kcxt, NULL, NULL, kdatum);
+			if (klen < 0)
+				return;
+		}
+	}
+	sz = KAGG_PARRAY_ITEM_SIZE(vlen, klen);
+	pos = __atomic_add_uint32(&r->usage, sz);
+	if (pos + sz > KAGG_PARRAY_BUFSZ)
+	{
+		STROM_ELOG(kcxt, "array_agg: too many items per group for the partial state");
+		return;
+	}
+	item = (kagg_parray_item *)(r->data + pos);
+	item->vlen = vlen;
+	item->klen = klen;
+	if (vlen > 0)
+		xdatum->expr_ops->xpu_datum_write(kcxt, item->payload, NULL, xdatum);
+	if (klen > 0)
+		kdatum->expr_ops->xpu_datum_write(kcxt, item->payload + MAXALIGN(vlen),
+										  NULL, kdatum);
+	__atomic_add_uint32(&r->nitems, 1);
+}
+
+/*
+ * __update_nogroups__parray
+ */
+INLINE_FUNCTION(void)
+__update_nogroups__parray(kern_context *kcxt,
+						  char *buffer,
+						  kern_colmeta *cmeta,
+						  kern_aggregate_desc *desc,
+						  bool source_is_valid)
+{
+	/* items are appended by each thread */
+	if (source_is_valid)
+	{
+		__atomic_append_parray(kcxt,
+							   (kagg_state__parray_packed *)buffer,
+							   kcxt->kvars_slot[desc->arg0_slot_id],
+							   desc->action == KAGG_ACTION__PARRAY_KEY
+							   ? kcxt->kvars_slot[desc->arg1_slot_id] : NULL);
+	}
+}
+
 /*
  * __updateOneTupleNoGroups
  */
@@ -864,6 +1264,12 @@ __updateOneTupleNoGroups(kern_context *kcxt,
 										   cmeta, desc,
 										   source_is_valid);
 				break;
+			case KAGG_ACTION__PAVG_NUMERIC:
+			case KAGG_ACTION__PSUM_NUMERIC:
+				__update_nogroups__psum_numeric(kcxt, buffer,
+												cmeta, desc,
+												source_is_valid);
+				break;
 			case KAGG_ACTION__STDDEV:
 				__update_nogroups__pstddev(kcxt, buffer,
 										   cmeta, desc,
@@ -874,6 +1280,22 @@ __updateOneTupleNoGroups(kern_context *kcxt,
 										  cmeta, desc,
 										  source_is_valid);
 				break;
+			case KAGG_ACTION__PTOPK:
+				__update_nogroups__ptopk(kcxt, buffer,
+										 cmeta, desc,
+										 source_is_valid);
+				break;
+			case KAGG_ACTION__PQUANTILE:
+				__update_nogroups__pquantile(kcxt, buffer,
+											 cmeta, desc,
+											 source_is_valid);
+				break;
+			case KAGG_ACTION__PARRAY:
+			case KAGG_ACTION__PARRAY_KEY:
+				__update_nogroups__parray(kcxt, buffer,
+										  cmeta, desc,
+										  source_is_valid);
+				break;
 			default:
 				/*
 				 * No more partial aggregation exists after grouping-keys
@@ -909,7 +1331,7 @@ __insertOneTupleNoGroups(kern_context *kcxt,
 									 kexp_groupby_actions);
 	assert(tupsz > 0);
 	required = MAXALIGN(offsetof(kern_tupitem, htup) + tupsz);
-	assert(required < 1000);
+	assert(required < BLCKSZ);
 	total_sz = (KDS_HEAD_LENGTH(kds_final) +
 				MAXALIGN(sizeof(uint32_t)) +
 				required + __kds_unpack(kds_final->usage));
@@ -1098,6 +1520,104 @@ __insertOneTupleGroupBy(kern_context *kcxt,
 	return hitem;
 }
 
+/*
+ * __compareOneTupleGroupBy
+ */
+STATIC_FUNCTION(bool)
+__compareOneTupleGroupBy(kern_context *kcxt,
+						 kern_data_store *kds_final,
+						 kern_hashitem *hitem,
+						 kern_expression *kexp_groupby_keyload,
+						 kern_expression *kexp_groupby_keycomp)
+{
+	bool		saved_compare_nulls = kcxt->kmode_compare_nulls;
+	bool		retval = false;
+	xpu_bool_t	status;
+
+	kcxt->kmode_compare_nulls = true;
+	ExecLoadVarsHeapTuple(kcxt, kexp_groupby_keyload,
+						  -2,
+						  kds_final,
+						  &hitem->t.htup);
+	if (EXEC_KERN_EXPRESSION(kcxt, kexp_groupby_keycomp, &status))
+	{
+		if (!XPU_DATUM_ISNULL(&status) && status.value)
+			retval = true;
+	}
+	kcxt->kmode_compare_nulls = saved_compare_nulls;
+	return retval;
+}
+
+/*
+ * __lookupGroupByKeyDict
+ *
+ * It tries to find out the group by the grouping-key dictionary on the
+ * shared memory, prior to the hash-chain walk on the global memory.
+ * Low-to-mid cardinality groups (e.g, text keys of country or device type)
+ * are usually found here, so the global hash-slot is not touched.
+ */
+STATIC_FUNCTION(kern_hashitem *)
+__lookupGroupByKeyDict(kern_context *kcxt,
+					   kern_data_store *kds_final,
+					   uint32_t hash,
+					   kern_expression *kexp_groupby_keyload,
+					   kern_expression *kexp_groupby_keycomp)
+{
+	uint32_t	mask = kcxt->groupby_keydict_nslots - 1;
+
+	for (uint32_t i=0; i <= mask; i++)
+	{
+		uint64_t	ival = __volatileRead(&kcxt->groupby_keydict[(hash + i) & mask]);
+		uint32_t	rowid;
+		uint32_t	offset;
+		kern_hashitem *hitem;
+
+		if (ival == 0)
+			break;		/* not found */
+		if ((uint32_t)(ival >> 32) != hash)
+			continue;
+		rowid = (uint32_t)(ival & 0xffffffffU) - 1;
+		offset = __volatileRead(KDS_GET_ROWINDEX(kds_final) + rowid);
+		hitem = (kern_hashitem *)((char *)kds_final
+								  + kds_final->length
+								  - __kds_unpack(offset)
+								  - offsetof(kern_hashitem, t));
+		assert(hitem->t.rowid == rowid);
+		if (__compareOneTupleGroupBy(kcxt, kds_final, hitem,
+									 kexp_groupby_keyload,
+									 kexp_groupby_keycomp))
+			return hitem;
+	}
+	return NULL;
+}
+
+/*
+ * __insertGroupByKeyDict
+ */
+STATIC_FUNCTION(void)
+__insertGroupByKeyDict(kern_context *kcxt,
+					   uint32_t hash,
+					   uint32_t rowid)
+{
+	uint32_t	mask = kcxt->groupby_keydict_nslots - 1;
+	uint64_t	ival = (((uint64_t)hash << 32) | (uint64_t)(rowid + 1));
+
+	for (uint32_t i=0; i <= mask; i++)
+	{
+		uint64_t   *slot = &kcxt->groupby_keydict[(hash + i) & mask];
+		uint64_t	oldval = __volatileRead(slot);
+
+		if (oldval == ival)
+			break;		/* already registered */
+		if (oldval == 0)
+		{
+			oldval = __atomic_cas_uint64(slot, 0, ival);
+			if (oldval == 0 || oldval == ival)
+				break;
+		}
+	}
+}
+
 /*
  * __update_groupby__nrows_any
  */
@@ -1292,6 +1812,37 @@ __update_groupby__psum_fp(kern_context *kcxt,
 	return sizeof(kagg_state__psum_fp_packed);
 }
 
+INLINE_FUNCTION(int)
+__update_groupby__psum_numeric(kern_context *kcxt,
+							   char *buffer,
+							   const kern_colmeta *cmeta,
+							   const kern_aggregate_desc *desc)
+{
+	xpu_numeric_t  *xdatum = (xpu_numeric_t *)
+		kcxt->kvars_slot[desc->arg0_slot_id];
+	xpu_int4_t	   *sdatum = (xpu_int4_t *)
+		kcxt->kvars_slot[desc->arg1_slot_id];
+
+	if (!XPU_DATUM_ISNULL(xdatum) && !XPU_DATUM_ISNULL(sdatum))
+	{
+		kagg_state__psum_numeric_packed *r =
+			(kagg_state__psum_numeric_packed *)buffer;
+		int128_t	ival;
+
+		assert(xdatum->expr_ops == &xpu_numeric_ops &&
+			   sdatum->expr_ops == &xpu_int4_ops);
+		if (__kagg_numeric_to_fixed_point(kcxt, xdatum,
+										  sdatum->value, &ival))
+		{
+			__atomic_add_uint32(&r->nitems, 1);
+			__atomic_add_psum_numeric(r, ival);
+			/* scale is a constant */
+			r->scale = sdatum->value;
+		}
+	}
+	return sizeof(kagg_state__psum_numeric_packed);
+}
+
 INLINE_FUNCTION(int)
 __update_groupby__pstddev(kern_context *kcxt,
 						  char *buffer,
@@ -1342,6 +1893,75 @@ __update_groupby__pcovar(kern_context *kcxt,
 	return sizeof(kagg_state__covar_packed);
 }
 
+INLINE_FUNCTION(int)
+__update_groupby__pquantile(kern_context *kcxt,
+							char *buffer,
+							const kern_colmeta *cmeta,
+							const kern_aggregate_desc *desc)
+{
+	xpu_float8_t   *xdatum = (xpu_float8_t *)
+		kcxt->kvars_slot[desc->arg0_slot_id];
+	xpu_float8_t   *fdatum = (xpu_float8_t *)
+		kcxt->kvars_slot[desc->arg1_slot_id];
+
+	if (!XPU_DATUM_ISNULL(xdatum) && !XPU_DATUM_ISNULL(fdatum))
+	{
+		kagg_state__pquantile_packed *r =
+			(kagg_state__pquantile_packed *)buffer;
+		float8_t	xval = xdatum->value;
+		int			index = __kagg_qsketch_bucket_index(xval);
+
+		assert(xdatum->expr_ops == &xpu_float8_ops &&
+			   fdatum->expr_ops == &xpu_float8_ops);
+		__atomic_add_uint32(&r->nitems, 1);
+		if (index < 0)
+			__atomic_add_uint32(&r->nlower, 1);
+		else
+			__atomic_add_uint32(&r->buckets[index], 1);
+		__atomic_min_fp64(&r->min_value, xval);
+		__atomic_max_fp64(&r->max_value, xval);
+		/* fraction is usually a constant */
+		r->fraction = fdatum->value;
+	}
+	return sizeof(kagg_state__pquantile_packed);
+}
+
+INLINE_FUNCTION(int)
+__update_groupby__ptopk(kern_context *kcxt,
+						char *buffer,
+						const kern_colmeta *cmeta,
+						const kern_aggregate_desc *desc)
+{
+	uint64_t	ival;
+	int			k;
+
+	if (__fetch_ptopk_args(kcxt, desc, &ival, &k))
+	{
+		kagg_state__ptopk_packed *r =
+			(kagg_state__ptopk_packed *)buffer;
+
+		__atomic_add_uint32(&r->nitems, 1);
+		/* k is usually a constant */
+		r->k = k;
+		__atomic_insert_ptopk(r, k, ival);
+	}
+	return sizeof(kagg_state__ptopk_packed);
+}
+
+INLINE_FUNCTION(int)
+__update_groupby__parray(kern_context *kcxt,
+						 char *buffer,
+						 const kern_colmeta *cmeta,
+						 const kern_aggregate_desc *desc)
+{
+	__atomic_append_parray(kcxt,
+						   (kagg_state__parray_packed *)buffer,
+						   kcxt->kvars_slot[desc->arg0_slot_id],
+						   desc->action == KAGG_ACTION__PARRAY_KEY
+						   ? kcxt->kvars_slot[desc->arg1_slot_id] : NULL);
+	return sizeof(kagg_state__parray_packed);
+}
+
 /*
  * __updateOneTupleGroupBy
  */
@@ -1413,12 +2033,26 @@ __updateOneTupleGroupBy(kern_context *kcxt,
 			case KAGG_ACTION__PSUM_FP:
 				curr += __update_groupby__psum_fp(kcxt, curr, cmeta, desc);
 				break;
+			case KAGG_ACTION__PAVG_NUMERIC:
+			case KAGG_ACTION__PSUM_NUMERIC:
+				curr += __update_groupby__psum_numeric(kcxt, curr, cmeta, desc);
+				break;
 			case KAGG_ACTION__STDDEV:
 				curr += __update_groupby__pstddev(kcxt, curr, cmeta, desc);
 				break;
 			case KAGG_ACTION__COVAR:
 				curr += __update_groupby__pcovar(kcxt, curr, cmeta, desc);
 				break;
+			case KAGG_ACTION__PQUANTILE:
+				curr += __update_groupby__pquantile(kcxt, curr, cmeta, desc);
+				break;
+			case KAGG_ACTION__PTOPK:
+				curr += __update_groupby__ptopk(kcxt, curr, cmeta, desc);
+				break;
+			case KAGG_ACTION__PARRAY:
+			case KAGG_ACTION__PARRAY_KEY:
+				curr += __update_groupby__parray(kcxt, curr, cmeta, desc);
+				break;
 			default:
 				/*
 				 * No more partial aggregation exists after grouping-keys
@@ -1430,6 +2064,225 @@ bailout:
 	assert(curr == groupby_prepfn_buffer + kcxt->groupby_prepfn_bufsz);
 }
 
+/*
+ * __updateOneTupleGroupByWarp
+ *
+ * In case of low-cardinality GROUP BY, threads in a warp often update the
+ * same grouping tuple. If all the partial aggregations are additive (count
+ * and sum), the warp sums up the values of the peer threads that have the
+ * same grouping tuple, then only the leader thread updates the buffer.
+ * It must be called by all the threads in the warp (hitem == NULL if thread
+ * has no valid source row), and returns false if
+ * the partial aggregations are not additive or the planner estimated many
+ * groups; then the caller updates the grouping tuple for each thread.
+ * 'has_runs' means the warp has runs of the same grouping keys on the
+ * sorted-run mode, so the peer threads exist regardless of the estimation.
+ */
+#define GPUPREAGG_WARP_AGGREGATE_MAX_NGROUPS	4096
+
+STATIC_FUNCTION(bool)
+__updateOneTupleGroupByWarp(kern_context *kcxt,
+							kern_data_store *kds_final,
+							kern_hashitem *hitem,
+							char *groupby_prepfn_buffer,
+							const kern_expression *kexp_groupby_actions,
+							bool has_runs)
+{
+	uint32_t	mask = __activemask();
+	uint32_t	peers = 0;
+	uint64_t	key = (uint64_t)((uintptr_t)hitem);
+	char	   *curr;
+
+	if (!has_runs &&
+		kcxt->session->groupby_ngroups_estimation > GPUPREAGG_WARP_AGGREGATE_MAX_NGROUPS)
+		return false;
+	for (int j=0; j < kexp_groupby_actions->u.pagg.nattrs; j++)
+	{
+		switch (kexp_groupby_actions->u.pagg.desc[j].action)
+		{
+			case KAGG_ACTION__NROWS_ANY:
+			case KAGG_ACTION__NROWS_COND:
+			case KAGG_ACTION__PAVG_INT:
+			case KAGG_ACTION__PSUM_INT:
+			case KAGG_ACTION__PAVG_FP:
+			case KAGG_ACTION__PSUM_FP:
+				break;
+			case KAGG_ACTION__PMIN_INT32:
+			case KAGG_ACTION__PMIN_INT64:
+			case KAGG_ACTION__PMAX_INT32:
+			case KAGG_ACTION__PMAX_INT64:
+			case KAGG_ACTION__PMIN_FP64:
+			case KAGG_ACTION__PMAX_FP64:
+			case KAGG_ACTION__STDDEV:
+			case KAGG_ACTION__COVAR:
+			case KAGG_ACTION__PQUANTILE:
+			case KAGG_ACTION__PTOPK:
+			case KAGG_ACTION__PARRAY:
+			case KAGG_ACTION__PARRAY_KEY:
+			case KAGG_ACTION__PSUM_NUMERIC:
+			case KAGG_ACTION__PAVG_NUMERIC:
+				return false;
+			default:
+				/* grouping-keys */
+				goto out;
+		}
+	}
+out:
+	/* pick up the peer threads that have the same grouping tuple */
+	for (int lane=0; lane < warpSize; lane++)
+	{
+		if ((mask & (1U << lane)) != 0 &&
+			__shfl_sync(mask, key, lane) == key)
+			peers |= (1U << lane);
+	}
+	if (hitem && !groupby_prepfn_buffer)
+	{
+		HeapTupleHeaderData *htup = &hitem->t.htup;
+		int			nattrs = (htup->t_infomask2 & HEAP_NATTS_MASK);
+		bool		heap_hasnull = ((htup->t_infomask & HEAP_HASNULL) != 0);
+		uint32_t	t_hoff;
+
+		t_hoff = offsetof(HeapTupleHeaderData, t_bits);
+		if (heap_hasnull)
+			t_hoff += BITMAPLEN(nattrs);
+		t_hoff = MAXALIGN(t_hoff);
+		groupby_prepfn_buffer = (char *)htup + t_hoff;
+	}
+	curr = groupby_prepfn_buffer;
+	for (int j=0; j < kexp_groupby_actions->u.pagg.nattrs; j++)
+	{
+		const kern_aggregate_desc *desc = &kexp_groupby_actions->u.pagg.desc[j];
+		const kern_colmeta *cmeta = &kds_final->colmeta[j];
+		uint32_t	nitems = 0;
+		int64_t		ival = 0;
+		float8_t	fval = 0.0;
+
+		if (!hitem)
+			;
+		else if (cmeta->attlen > 0)
+			curr = (char *)TYPEALIGN(cmeta->attalign, curr);
+		else if (!VARATT_NOT_PAD_BYTE(curr))
+			curr = (char *)TYPEALIGN(cmeta->attalign, curr);
+
+		/* contribution of this thread */
+		switch (desc->action)
+		{
+			case KAGG_ACTION__NROWS_ANY:
+				nitems = (hitem ? 1 : 0);
+				break;
+			case KAGG_ACTION__NROWS_COND:
+				if (hitem && !XPU_DATUM_ISNULL(kcxt->kvars_slot[desc->arg0_slot_id]))
+					nitems = 1;
+				break;
+			case KAGG_ACTION__PAVG_INT:
+			case KAGG_ACTION__PSUM_INT:
+				if (hitem)
+				{
+					xpu_int8_t *xdatum = (xpu_int8_t *)
+						kcxt->kvars_slot[desc->arg0_slot_id];
+					if (!XPU_DATUM_ISNULL(xdatum))
+					{
+						nitems = 1;
+						ival = xdatum->value;
+					}
+				}
+				break;
+			case KAGG_ACTION__PAVG_FP:
+			case KAGG_ACTION__PSUM_FP:
+				if (hitem)
+				{
+					xpu_float8_t *xdatum = (xpu_float8_t *)
+						kcxt->kvars_slot[desc->arg0_slot_id];
+					if (!XPU_DATUM_ISNULL(xdatum))
+					{
+						nitems = 1;
+						fval = xdatum->value;
+					}
+				}
+				break;
+			default:
+				goto bailout;
+		}
+		/*
+		 * sum up the peer threads; all the threads in the warp walks on
+		 * the same path, because __shfl_sync() with various members is
+		 * not safe in divergence on the older devices.
+		 */
+		{
+			uint32_t	__nitems = 0;
+			int64_t		__ival = 0;
+			float8_t	__fval = 0.0;
+
+			for (int lane=0; lane < warpSize; lane++)
+			{
+				uint32_t	n;
+				int64_t		iv;
+				float8_t	fv;
+
+				if ((mask & (1U << lane)) == 0)
+					continue;
+				n  = __shfl_sync(mask, nitems, lane);
+				iv = __shfl_sync(mask, ival, lane);
+				fv = __shfl_sync(mask, fval, lane);
+				if ((peers & (1U << lane)) != 0)
+				{
+					__nitems += n;
+					__ival   += iv;
+					__fval   += fv;
+				}
+			}
+			nitems = __nitems;
+			ival = __ival;
+			fval = __fval;
+		}
+		/* only the leader thread updates the buffer */
+		if (hitem && LaneId() == __ffs(peers) - 1 && nitems > 0)
+		{
+			switch (desc->action)
+			{
+				case KAGG_ACTION__NROWS_ANY:
+				case KAGG_ACTION__NROWS_COND:
+					__atomic_add_uint64((uint64_t *)curr, nitems);
+					break;
+				case KAGG_ACTION__PAVG_INT:
+				case KAGG_ACTION__PSUM_INT:
+					{
+						kagg_state__psum_int_packed *r =
+							(kagg_state__psum_int_packed *)curr;
+						__atomic_add_uint32(&r->nitems, nitems);
+						__atomic_add_int64(&r->sum, ival);
+					}
+					break;
+				default:
+					{
+						kagg_state__psum_fp_packed *r =
+							(kagg_state__psum_fp_packed *)curr;
+						__atomic_add_uint32(&r->nitems, nitems);
+						__atomic_add_fp64(&r->sum, fval);
+					}
+					break;
+			}
+		}
+		switch (desc->action)
+		{
+			case KAGG_ACTION__NROWS_ANY:
+			case KAGG_ACTION__NROWS_COND:
+				curr += sizeof(uint64_t);
+				break;
+			case KAGG_ACTION__PAVG_INT:
+			case KAGG_ACTION__PSUM_INT:
+				curr += sizeof(kagg_state__psum_int_packed);
+				break;
+			default:
+				curr += sizeof(kagg_state__psum_fp_packed);
+				break;
+		}
+	}
+bailout:
+	assert(!hitem || curr == groupby_prepfn_buffer + kcxt->groupby_prepfn_bufsz);
+	return true;
+}
+
 STATIC_FUNCTION(int)
 __execGpuPreAggGroupBy(kern_context *kcxt,
 					   kern_data_store *kds_final,
@@ -1442,6 +2295,10 @@ __execGpuPreAggGroupBy(kern_context *kcxt,
 {
 	kern_hashitem *hitem = NULL;
 	xpu_int4_t	hash;
+	bool		need_lookup;
+	bool		run_follower = false;
+	bool		has_runs = false;
+	uint32_t	run_head = LaneId();
 
 	assert(kds_final->format == KDS_FORMAT_HASH);
 	/*
@@ -1455,18 +2312,55 @@ __execGpuPreAggGroupBy(kern_context *kcxt,
 	}
 	if (__syncthreads_count(kcxt->errcode != ERRCODE_STROM_SUCCESS) > 0)
 		return false;
+	need_lookup = !XPU_DATUM_ISNULL(&hash);
+
+	/*
+	 * sorted-run mode - if the outer rows are clustered by the grouping keys
+	 * (e.g, time-ordered Arrow files), the neighbor threads in a warp likely
+	 * have the same grouping keys. Only the head thread of a run (lanes with
+	 * the same hash in a row) walks on the hash table, then the followers
+	 * take the grouping tuple of the head, if the keys are identical.
+	 */
+	if (kcxt->session->groupby_sorted_run)
+	{
+		uint32_t	mask = __activemask();
+		uint32_t	lane_id = LaneId();
+		uint32_t	prev_hash = __shfl_up_sync(mask, hash.value, 1);
+		int			prev_valid = __shfl_up_sync(mask, (int)need_lookup, 1);
+		uint32_t	heads;
+
+		run_follower = (lane_id > 0 &&
+						(mask & (1U << (lane_id - 1))) != 0 &&
+						need_lookup &&
+						prev_valid &&
+						prev_hash == hash.value);
+		heads = __ballot_sync(mask, !run_follower);
+		has_runs = (heads != mask);
+		/* the nearest head thread at or below this lane */
+		run_head = 31 - __clz(heads & ((2U << lane_id) - 1));
+		if (run_follower)
+			need_lookup = false;
+	}
+
+	/*
+	 * lookup the grouping-key dictionary on the shared memory first
+	 */
+	if (kcxt->groupby_keydict && need_lookup)
+		hitem = __lookupGroupByKeyDict(kcxt, kds_final, hash.value,
+									   kexp_groupby_keyload,
+									   kexp_groupby_keycomp);
 
 	/*
 	 * lookup the destination grouping tuple. if not found, create a new one.
 	 */
+lookup_again:
 	do {
-		if (!XPU_DATUM_ISNULL(&hash) && !hitem)
+		if (need_lookup && !hitem)
 		{
 			uint32_t   *hslot = KDS_GET_HASHSLOT(kds_final, hash.value);
 			uint32_t	hoffset;
 			uint32_t	saved;
 			bool		has_lock = false;
-			xpu_bool_t	status;
 
 			hoffset = __volatileRead(hslot);
 		try_again:
@@ -1474,23 +2368,11 @@ __execGpuPreAggGroupBy(kern_context *kcxt,
 				 hitem != NULL;
 				 hitem = KDS_HASH_NEXT_ITEM(kds_final, hitem->next))
 			{
-				bool	saved_compare_nulls = kcxt->kmode_compare_nulls;
-
-				if (hitem->hash != hash.value)
-					continue;
-
-				kcxt->kmode_compare_nulls = true;
-				ExecLoadVarsHeapTuple(kcxt, kexp_groupby_keyload,
-									  -2,
-									  kds_final,
-									  &hitem->t.htup);
-				if (EXEC_KERN_EXPRESSION(kcxt, kexp_groupby_keycomp, &status))
-				{
-					kcxt->kmode_compare_nulls = saved_compare_nulls;
-					if (!XPU_DATUM_ISNULL(&status) && status.value)
-						break;
-				}
-				kcxt->kmode_compare_nulls = saved_compare_nulls;
+				if (hitem->hash == hash.value &&
+					__compareOneTupleGroupBy(kcxt, kds_final, hitem,
+											 kexp_groupby_keyload,
+											 kexp_groupby_keycomp))
+					break;
 			}
 
 			if (!hitem)
@@ -1538,6 +2420,11 @@ __execGpuPreAggGroupBy(kern_context *kcxt,
 				/* unlock */
 				__atomic_write_uint32(hslot, saved);
 			}
+			/* register the group to the dictionary, if prepfn buffer exists */
+			if (hitem &&
+				kcxt->groupby_keydict &&
+				hitem->t.rowid < kcxt->groupby_prepfn_nbufs)
+				__insertGroupByKeyDict(kcxt, hash.value, hitem->t.rowid);
 		}
 		/* suspend the kernel? */
 		if (__syncthreads_count(*p_try_suspend) > 0)
@@ -1546,25 +2433,58 @@ __execGpuPreAggGroupBy(kern_context *kcxt,
 		if (__syncthreads_count(kcxt->errcode != ERRCODE_STROM_SUCCESS) > 0)
 			return false;
 		/* retry, if any threads are not ready yet */
-	} while (__syncthreads_count(!XPU_DATUM_ISNULL(&hash) && !hitem) > 0);
+	} while (__syncthreads_count(need_lookup && !hitem) > 0);
+
+	/*
+	 * sorted-run mode - the followers take the grouping tuple of the head.
+	 * If hash value is conflicted, they walk on the hash table by themselves.
+	 */
+	if (__syncthreads_count(run_follower) > 0)
+	{
+		kern_hashitem *head_hitem = (kern_hashitem *)
+			__shfl_sync(__activemask(), (uint64_t)((uintptr_t)hitem), run_head);
+
+		if (run_follower)
+		{
+			if (head_hitem &&
+				head_hitem->hash == hash.value &&
+				__compareOneTupleGroupBy(kcxt, kds_final, head_hitem,
+										 kexp_groupby_keyload,
+										 kexp_groupby_keycomp))
+				hitem = head_hitem;
+			else
+				need_lookup = true;
+			run_follower = false;
+		}
+		if (__syncthreads_count(kcxt->errcode != ERRCODE_STROM_SUCCESS) > 0)
+			return false;
+		goto lookup_again;
+	}
 
 	/*
 	 * update the partial aggregation
 	 */
-	if (hitem)
 	{
 		char   *prepfn_buffer = NULL;
 
-		if (kcxt->groupby_prepfn_buffer &&
+		if (hitem &&
+			kcxt->groupby_prepfn_buffer &&
 			hitem->t.rowid < kcxt->groupby_prepfn_nbufs)
 		{
 			prepfn_buffer = kcxt->groupby_prepfn_buffer
 				+ hitem->t.rowid * kcxt->groupby_prepfn_bufsz;
 		}
-		__updateOneTupleGroupBy(kcxt, kds_final,
-								&hitem->t.htup,
-								prepfn_buffer,
-								kexp_groupby_actions);
+		if (!__updateOneTupleGroupByWarp(kcxt, kds_final,
+										 hitem,
+										 prepfn_buffer,
+										 kexp_groupby_actions,
+										 has_runs) && hitem)
+		{
+			__updateOneTupleGroupBy(kcxt, kds_final,
+									&hitem->t.htup,
+									prepfn_buffer,
+									kexp_groupby_actions);
+		}
 	}
 	return true;
 }
@@ -1651,6 +2571,13 @@ __setupGpuPreAggGroupByBufferOne(kern_context *kcxt,
 				pos += sizeof(kagg_state__psum_fp_packed);
 				break;
 
+			case KAGG_ACTION__PSUM_NUMERIC:
+			case KAGG_ACTION__PAVG_NUMERIC:
+				memset(pos, 0, sizeof(kagg_state__psum_numeric_packed));
+				SET_VARSIZE(pos, sizeof(kagg_state__psum_numeric_packed));
+				pos += sizeof(kagg_state__psum_numeric_packed);
+				break;
+
 			case KAGG_ACTION__STDDEV:
 				memset(pos, 0, sizeof(kagg_state__stddev_packed));
 				SET_VARSIZE(pos, sizeof(kagg_state__stddev_packed));
@@ -1663,6 +2590,33 @@ __setupGpuPreAggGroupByBufferOne(kern_context *kcxt,
 				pos += sizeof(kagg_state__covar_packed);
 				break;
 
+			case KAGG_ACTION__PQUANTILE:
+				{
+					kagg_state__pquantile_packed *r =
+						(kagg_state__pquantile_packed *)pos;
+
+					memset(r, 0, sizeof(kagg_state__pquantile_packed));
+					r->fraction  = 0.5;
+					r->min_value = DBL_MAX;
+					r->max_value = -DBL_MAX;
+					SET_VARSIZE(r, sizeof(kagg_state__pquantile_packed));
+					pos += sizeof(kagg_state__pquantile_packed);
+				}
+				break;
+
+			case KAGG_ACTION__PTOPK:
+				memset(pos, 0, sizeof(kagg_state__ptopk_packed));
+				SET_VARSIZE(pos, sizeof(kagg_state__ptopk_packed));
+				pos += sizeof(kagg_state__ptopk_packed);
+				break;
+
+			case KAGG_ACTION__PARRAY:
+			case KAGG_ACTION__PARRAY_KEY:
+				memset(pos, 0, offsetof(kagg_state__parray_packed, data));
+				SET_VARSIZE(pos, sizeof(kagg_state__parray_packed));
+				pos += sizeof(kagg_state__parray_packed);
+				break;
+
 			default:
 				/* no more prep-function should exist after the keyref */
 				goto bailout;
@@ -1691,6 +2645,8 @@ setupGpuPreAggGroupByBuffer(kern_context *kcxt,
 		{
 			uint32_t		index;
 
+			uint32_t		nslots;
+
 			kcxt->groupby_prepfn_bufsz = kgtask->groupby_prepfn_bufsz;
 			kcxt->groupby_prepfn_nbufs = kgtask->groupby_prepfn_nbufs;
 			kcxt->groupby_prepfn_buffer = groupby_prepfn_buffer;
@@ -1703,6 +2659,24 @@ setupGpuPreAggGroupByBuffer(kern_context *kcxt,
 							   kcxt->groupby_prepfn_bufsz * index);
 				__setupGpuPreAggGroupByBufferOne(kcxt, kexp_actions, pos);
 			}
+			/*
+			 * grouping-key dictionary next to the prepfn buffer; the number
+			 * of slots is rounded down to the power of 2.
+			 */
+			nslots = KAGG_KEYDICT_SLOTS_PER_BUFFER * kgtask->groupby_prepfn_nbufs;
+			nslots = (1U << (31 - __clz(nslots)));
+			kcxt->groupby_keydict_nslots = nslots;
+			kcxt->groupby_keydict = (uint64_t *)
+				(kcxt->groupby_prepfn_buffer +
+				 kcxt->groupby_prepfn_bufsz * kgtask->groupby_prepfn_nbufs);
+			assert((uintptr_t)kcxt->groupby_keydict ==
+				   MAXALIGN(kcxt->groupby_keydict));
+			for (index = get_local_id();
+				 index < nslots;
+				 index += get_local_size())
+			{
+				kcxt->groupby_keydict[index] = 0;
+			}
 		}
 		else
 		{
@@ -1846,6 +2820,23 @@ __mergeGpuPreAggGroupByBufferOne(kern_context *kcxt,
 				}
 				break;
 
+			case KAGG_ACTION__PSUM_NUMERIC:
+			case KAGG_ACTION__PAVG_NUMERIC:
+				{
+					const kagg_state__psum_numeric_packed *s =
+						(const kagg_state__psum_numeric_packed *)pos;
+					kagg_state__psum_numeric_packed *r =
+						(kagg_state__psum_numeric_packed *)((char *)htup + t_hoff);
+					if (s->nitems > 0)
+					{
+						__atomic_add_uint32(&r->nitems, s->nitems);
+						__atomic_add_psum_numeric(r, __kagg_psum_numeric_get(s));
+						r->scale = s->scale;
+					}
+					nbytes = sizeof(kagg_state__psum_numeric_packed);
+				}
+				break;
+
 			case KAGG_ACTION__STDDEV:
 				{
 					const kagg_state__stddev_packed *s =
@@ -1881,6 +2872,73 @@ __mergeGpuPreAggGroupByBufferOne(kern_context *kcxt,
 				}
 				break;
 
+			case KAGG_ACTION__PQUANTILE:
+				{
+					const kagg_state__pquantile_packed *s =
+						(const kagg_state__pquantile_packed *)pos;
+					kagg_state__pquantile_packed *r =
+						(kagg_state__pquantile_packed *)((char *)htup + t_hoff);
+					if (s->nitems > 0)
+					{
+						__atomic_add_uint32(&r->nitems, s->nitems);
+						if (s->nlower > 0)
+							__atomic_add_uint32(&r->nlower, s->nlower);
+						for (int k=0; k < KAGG_QSKETCH_NBUCKETS; k++)
+						{
+							if (s->buckets[k] > 0)
+								__atomic_add_uint32(&r->buckets[k], s->buckets[k]);
+						}
+						__atomic_min_fp64(&r->min_value, s->min_value);
+						__atomic_max_fp64(&r->max_value, s->max_value);
+						r->fraction = s->fraction;
+					}
+					nbytes = sizeof(kagg_state__pquantile_packed);
+				}
+				break;
+
+			case KAGG_ACTION__PTOPK:
+				{
+					const kagg_state__ptopk_packed *s =
+						(const kagg_state__ptopk_packed *)pos;
+					kagg_state__ptopk_packed *r =
+						(kagg_state__ptopk_packed *)((char *)htup + t_hoff);
+					if (s->nitems > 0)
+					{
+						__atomic_add_uint32(&r->nitems, s->nitems);
+						r->k = s->k;
+						for (int i=0; i < s->k; i++)
+						{
+							if (s->slots[i] != 0)
+								__atomic_insert_ptopk(r, s->k, s->slots[i]);
+						}
+					}
+					nbytes = sizeof(kagg_state__ptopk_packed);
+				}
+				break;
+
+			case KAGG_ACTION__PARRAY:
+			case KAGG_ACTION__PARRAY_KEY:
+				{
+					const kagg_state__parray_packed *s =
+						(const kagg_state__parray_packed *)pos;
+					kagg_state__parray_packed *r =
+						(kagg_state__parray_packed *)((char *)htup + t_hoff);
+					if (s->nitems > 0 && s->usage <= KAGG_PARRAY_BUFSZ)
+					{
+						uint32_t	offset = __atomic_add_uint32(&r->usage, s->usage);
+
+						if (offset + s->usage > KAGG_PARRAY_BUFSZ)
+							STROM_ELOG(kcxt, "array_agg: too many items per group for the partial state");
+						else
+						{
+							memcpy(r->data + offset, s->data, s->usage);
+							__atomic_add_uint32(&r->nitems, s->nitems);
+						}
+					}
+					nbytes = sizeof(kagg_state__parray_packed);
+				}
+				break;
+
 			default:
 				goto bailout;
 		}
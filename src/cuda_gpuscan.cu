@@ -348,22 +348,47 @@ __gpuscan_load_source_block(kern_context *kcxt,
 	{
 		PageHeaderData *pg_page = KDS_BLOCK_PGPAGE(kds_src, block_id);
 		BlockNumber		block_nr = KDS_BLOCK_BLCKNR(kds_src, block_id);
-		uint32_t		nitems = PageGetMaxOffsetNumber(pg_page);
+		uint32_t		nitems;
 		uint32_t		index;
 
+		/* padding blocks to merge the P2P DMA requests have no items */
+		if (block_nr == InvalidBlockNumber)
+			nitems = 0;
+		else
+			nitems = PageGetMaxOffsetNumber(pg_page);
 		index = wp->lp_count * warpSize + LaneId();
-		if (index < PageGetMaxOffsetNumber(pg_page))
+		if (index < nitems)
 		{
 			ItemIdData *lpp = &pg_page->pd_linp[index];
 
 			assert((char *)lpp < (char *)pg_page + BLCKSZ);
-			if (ItemIdIsNormal(lpp))
+			if (ItemIdIsNormal(lpp) &&
+				pgstrom_tablesample_check(kcxt->session->tablesample_method,
+										  kcxt->session->tablesample_seed,
+										  kcxt->session->tablesample_threshold,
+										  block_nr, index + 1))
 			{
 				htup = (HeapTupleHeaderData *)PageGetItem(pg_page, lpp);
-				/* for ctid system column reference */
-				htup->t_ctid.ip_blkid.bi_hi = (uint16_t)(block_nr >> 16);
-				htup->t_ctid.ip_blkid.bi_lo = (uint16_t)(block_nr & 0xffffU);
-				htup->t_ctid.ip_posid = index + 1;
+				/*
+				 * pages not all-visible are checked using the snapshot
+				 * shipped by the host (see pgstromBuildSessionXactSnapshot)
+				 */
+				if ((pg_page->pd_flags & PD_ALL_VISIBLE) == 0)
+				{
+					int		status = HeapTupleSatisfiesMVCCOnDevice(kcxt->session, htup);
+
+					if (status < 0)
+						STROM_CPU_FALLBACK(kcxt, "tuple visibility is not decidable on the device");
+					if (status <= 0)
+						htup = NULL;
+				}
+				if (htup)
+				{
+					/* for ctid system column reference */
+					htup->t_ctid.ip_blkid.bi_hi = (uint16_t)(block_nr >> 16);
+					htup->t_ctid.ip_blkid.bi_lo = (uint16_t)(block_nr & 0xffffU);
+					htup->t_ctid.ip_posid = index + 1;
+				}
 			}
 		}
 		has_next_lp_items = (index + warpSize < nitems);
@@ -529,24 +554,69 @@ __gpuscan_load_source_column(kern_context *kcxt,
 							 const kern_expression *kexp_move_vars,
 							 char *dst_kvecs_buffer)
 {
+	const kern_session_info *session = kcxt->session;
+	const kern_colmeta *hcmeta = NULL;
 	uint32_t	count;
 	uint32_t	index;
 	uint32_t	wr_pos;
 	bool		is_valid = false;
 
+	/* point lookup by the hash-index, if available */
+	if (session->gcache_lookup_attnum > 0 &&
+		session->gcache_lookup_attnum <= kds_src->ncols)
+	{
+		hcmeta = &kds_src->colmeta[session->gcache_lookup_attnum - 1];
+		if (hcmeta->hindex_nslots == 0 || hcmeta->hindex_invalid)
+			hcmeta = NULL;
+	}
 	/* fetch next blockSize tuples */
 	count = wp->smx_row_count;
 	__syncthreads();
 	if (get_local_id() == 0)
 		wp->smx_row_count++;
-	index = get_global_size() * count + get_global_base();
-	if (index >= kds_src->nitems)
+	if (hcmeta)
 	{
-		if (get_local_id() == 0)
-			wp->scan_done = 1;
-		return 1;
+		/*
+		 * Entries with the same hash value are always located within
+		 * the GCACHE_HINDEX_MAX_PROBES slots from the hash slot, so
+		 * the first thread-block walks on them. Hash collision is not
+		 * a problem, because scan_quals checks the key again.
+		 */
+		const uint64_t *slots = (const uint64_t *)
+			((const char *)kds_src + __kds_unpack(hcmeta->hindex_offset));
+		uint32_t	hash = session->gcache_lookup_hash;
+		uint32_t	limit = Min(hcmeta->hindex_nslots, GCACHE_HINDEX_MAX_PROBES);
+		uint32_t	pos = get_local_size() * count;
+
+		if (get_global_base() != 0 || pos >= limit)
+		{
+			if (get_local_id() == 0)
+				wp->scan_done = 1;
+			return 1;
+		}
+		pos += get_local_id();
+		index = UINT_MAX;
+		if (pos < limit)
+		{
+			uint64_t	entry = slots[(hash + pos) % hcmeta->hindex_nslots];
+
+			if (entry != GCACHE_HINDEX_EMPTY &&
+				entry != GCACHE_HINDEX_TOMBSTONE &&
+				(uint32_t)(entry >> 32) == hash)
+				index = (uint32_t)(entry & 0xffffffffU) - 1;
+		}
+	}
+	else
+	{
+		index = get_global_size() * count + get_global_base();
+		if (index >= kds_src->nitems)
+		{
+			if (get_local_id() == 0)
+				wp->scan_done = 1;
+			return 1;
+		}
+		index += get_local_id();
 	}
-	index += get_local_id();
 
 	/*
 	 * fetch the outer tuple to scan
@@ -730,6 +800,379 @@ gpucache_assign_update_owner(kern_context *kcxt,
 	}
 }
 
+/*
+ * __gpucache_hindex_insert
+ *
+ * It registers the rowid on the hash-index, and removes the older entry
+ * of the same rowid (if reused) to avoid duplicated results.
+ */
+STATIC_FUNCTION(void)
+__gpucache_hindex_insert(kern_data_store *kds,
+						 kern_colmeta *cmeta,
+						 uint32_t hash,
+						 uint32_t rowid)
+{
+	uint64_t   *slots = (uint64_t *)
+		((char *)kds + __kds_unpack(cmeta->hindex_offset));
+	uint32_t   *rowpos = (uint32_t *)
+		((char *)kds + __kds_unpack(cmeta->hindex_rowpos));
+	uint64_t	newval = (((uint64_t)hash << 32) | (uint64_t)(rowid + 1));
+	uint32_t	pos;
+
+	pos = rowpos[rowid];
+	if (pos > 0)
+	{
+		uint64_t	oldval = __volatileRead(&slots[pos-1]);
+
+		if ((oldval & 0xffffffffUL) == (uint64_t)(rowid + 1))
+			__atomic_cas_uint64(&slots[pos-1], oldval,
+								GCACHE_HINDEX_TOMBSTONE);
+		rowpos[rowid] = 0;
+	}
+
+	for (int loop=0; loop < GCACHE_HINDEX_MAX_PROBES; loop++)
+	{
+		uint64_t	curval;
+
+		pos = (hash + loop) % cmeta->hindex_nslots;
+		curval = __volatileRead(&slots[pos]);
+		while (curval == GCACHE_HINDEX_EMPTY ||
+			   curval == GCACHE_HINDEX_TOMBSTONE)
+		{
+			uint64_t	oldval = __atomic_cas_uint64(&slots[pos], curval, newval);
+
+			if (oldval == curval)
+			{
+				rowpos[rowid] = pos + 1;
+				return;
+			}
+			curval = oldval;
+		}
+	}
+	/* too long probing, so hash-index is no longer available */
+	cmeta->hindex_invalid = 1;
+}
+
+/*
+ * __gpucache_store_bitpack_value
+ *
+ * It writes a fixed-length integer value as a difference from the base
+ * value of the frame-of-reference encoding.
+ */
+STATIC_FUNCTION(bool)
+__gpucache_store_bitpack_value(kern_context *kcxt,
+							   kern_colmeta *cmeta,
+							   char *base,
+							   uint32_t rowid,
+							   const char *addr)
+{
+	int64_t		ival;
+	int64_t		enc_base;
+	int64_t		delta;
+
+	switch (cmeta->attlen)
+	{
+		case sizeof(int16_t):
+			ival = *((const int16_t *)addr);
+			break;
+		case sizeof(int32_t):
+			ival = *((const int32_t *)addr);
+			break;
+		case sizeof(int64_t):
+			ival = *((const int64_t *)addr);
+			break;
+		default:
+			STROM_ELOG(kcxt, "gpucache: unexpected length of bitpacked column");
+			return false;
+	}
+	/* the first value written determines the base of the column */
+	enc_base = __volatileRead(&cmeta->enc_base);
+	if (enc_base == KDS_COLUMN_ENC_BASE__UNSET)
+	{
+		int64_t		newval = (ival != KDS_COLUMN_ENC_BASE__UNSET ? ival : ival+1);
+
+		enc_base = (int64_t)
+			__atomic_cas_uint64((uint64_t *)&cmeta->enc_base,
+								(uint64_t)KDS_COLUMN_ENC_BASE__UNSET,
+								(uint64_t)newval);
+		if (enc_base == KDS_COLUMN_ENC_BASE__UNSET)
+			enc_base = newval;
+	}
+	delta = (int64_t)((uint64_t)ival - (uint64_t)enc_base);
+	if (((ival ^ enc_base) & (ival ^ delta)) < 0)
+		goto out_of_range;
+
+	switch (cmeta->enc_unitsz)
+	{
+		case sizeof(int8_t):
+			if (delta < SCHAR_MIN || delta > SCHAR_MAX)
+				goto out_of_range;
+			((int8_t *)base)[rowid] = delta;
+			break;
+		case sizeof(int16_t):
+			if (delta < SHRT_MIN || delta > SHRT_MAX)
+				goto out_of_range;
+			((int16_t *)base)[rowid] = delta;
+			break;
+		case sizeof(int32_t):
+			if (delta < INT_MIN || delta > INT_MAX)
+				goto out_of_range;
+			((int32_t *)base)[rowid] = delta;
+			break;
+		default:
+			STROM_ELOG(kcxt, "gpucache: unexpected unit size of bitpacked column");
+			return false;
+	}
+	return true;
+
+out_of_range:
+	STROM_ELOG(kcxt, "gpucache: value out of range of bitpacked column");
+	return false;
+}
+
+/*
+ * __gpucache_dict_insert_value
+ *
+ * It looks up the dictionary of the varlena column, then returns the packed
+ * offset of the same value if already registered. Elsewhere, it copies the
+ * value to the extra buffer and registers it on the dictionary.
+ * Once the dictionary is saturated, the value is copied to the extra buffer
+ * but not registered. 0 shall be returned if extra buffer has no space.
+ */
+#define GCACHE_DICT_MAX_PROBES		64
+
+STATIC_FUNCTION(uint32_t)
+__gpucache_dict_insert_value(const kern_colmeta *cmeta,
+							 kern_data_extra *extra,
+							 const char *vl_pos,
+							 uint32_t vl_len)
+{
+	uint32_t   *slots = (uint32_t *)
+		((char *)extra + __kds_unpack(cmeta->dict_offset));
+	uint32_t	hash = pg_hash_any(vl_pos, vl_len);
+	uint32_t	vl_off = 0;
+
+	assert(cmeta->col_encoding == KDS_COLUMN_ENCODING__DICT &&
+		   cmeta->dict_nslots > 0);
+	for (int loop=0; loop < GCACHE_DICT_MAX_PROBES; loop++)
+	{
+		uint32_t   *slot = &slots[(hash + loop) % cmeta->dict_nslots];
+		uint32_t	curr = __volatileRead(slot);
+		const char *vl_cur;
+
+		if (curr == 0)
+		{
+			if (vl_off == 0)
+			{
+				uint64_t	off = __atomic_add_uint64(&extra->usage,
+													  MAXALIGN(vl_len));
+				if (off + vl_len > extra->length)
+					return 0;	/* no space */
+				memcpy((char *)extra + off, vl_pos, vl_len);
+				vl_off = __kds_packed(off);
+				__threadfence();
+			}
+			curr = __atomic_cas_uint32(slot, 0, vl_off);
+			if (curr == 0)
+				return vl_off;	/* registered */
+		}
+		vl_cur = (const char *)extra + __kds_unpack(curr);
+		if (VARSIZE_ANY(vl_cur) == vl_len &&
+			__memcmp(vl_cur, vl_pos, vl_len) == 0)
+		{
+			/* someone registered the same value concurrently */
+			if (vl_off != 0)
+				__atomic_add_uint64(&extra->deadspace, MAXALIGN(vl_len));
+			return curr;
+		}
+	}
+	/* dictionary is saturated, so store it as a plain value */
+	if (vl_off == 0)
+	{
+		uint64_t	off = __atomic_add_uint64(&extra->usage,
+											  MAXALIGN(vl_len));
+		if (off + vl_len > extra->length)
+			return 0;	/* no space */
+		memcpy((char *)extra + off, vl_pos, vl_len);
+		vl_off = __kds_packed(off);
+	}
+	return vl_off;
+}
+
+/*
+ * Maintained aggregation
+ *
+ * A row is accumulated to the aggregation slot while it is committed and
+ * not committed-deleted. @agg_counted bitmap tracks whether the row is
+ * already accumulated, so the state transition by INS/DEL/XACT logs adds
+ * or subtracts the row exactly once.
+ */
+STATIC_FUNCTION(kern_colmeta *)
+__gpucache_agg_colmeta(kern_data_store *kds)
+{
+	for (int j=0; j < kds->ncols; j++)
+	{
+		kern_colmeta   *cmeta = &kds->colmeta[j];
+
+		if (cmeta->agg_nslots > 0)
+			return (cmeta->agg_invalid ? NULL : cmeta);
+	}
+	return NULL;
+}
+
+STATIC_FUNCTION(bool)
+__gpucache_agg_fetch_value(const kern_data_store *kds,
+						   const kern_colmeta *cmeta,
+						   uint32_t rowid,
+						   bool is_float,
+						   int64_t *p_ival,
+						   float8_t *p_fval)
+{
+	const char *base;
+
+	if (cmeta->nullmap_offset != 0)
+	{
+		const uint32_t *nullmap = (const uint32_t *)
+			((const char *)kds + __kds_unpack(cmeta->nullmap_offset));
+
+		if ((nullmap[rowid>>5] & (1U<<(rowid&31))) == 0)
+			return false;
+	}
+	base = (const char *)kds + __kds_unpack(cmeta->values_offset);
+	if (cmeta->col_encoding == KDS_COLUMN_ENCODING__BITPACK)
+		*p_ival = KDS_COLUMN_BITPACK_DECODE(cmeta, base, rowid);
+	else if (is_float)
+	{
+		if (cmeta->attlen == sizeof(float4_t))
+			*p_fval = ((const float4_t *)base)[rowid];
+		else
+			*p_fval = ((const float8_t *)base)[rowid];
+	}
+	else
+	{
+		switch (cmeta->attlen)
+		{
+			case sizeof(int8_t):
+				*p_ival = ((const int8_t *)base)[rowid];
+				break;
+			case sizeof(int16_t):
+				*p_ival = ((const int16_t *)base)[rowid];
+				break;
+			case sizeof(int32_t):
+				*p_ival = ((const int32_t *)base)[rowid];
+				break;
+			default:
+				*p_ival = ((const int64_t *)base)[rowid];
+				break;
+		}
+	}
+	return true;
+}
+
+STATIC_FUNCTION(void)
+__gpucache_agg_accum(kern_data_store *kds,
+					 kern_colmeta *kcmeta,
+					 uint32_t rowid, int64_t sign)
+{
+	kern_gpucache_aggslot *slots = (kern_gpucache_aggslot *)
+		((char *)kds + __kds_unpack(kcmeta->agg_offset));
+	kern_gpucache_aggslot *slot = NULL;
+	int64_t		key = 0;
+	bool		key_isnull;
+	uint32_t	hash;
+
+	key_isnull = !__gpucache_agg_fetch_value(kds, kcmeta, rowid, false,
+											 &key, NULL);
+	hash = (key_isnull ? 0 : pg_hash_any(&key, sizeof(int64_t)));
+	for (uint32_t loop=0; loop < kcmeta->agg_nslots; loop++)
+	{
+		uint32_t	curr;
+
+		slot = &slots[(hash + loop) % kcmeta->agg_nslots];
+		curr = __volatileRead(&slot->state);
+		if (curr == GCACHE_AGGSLOT__EMPTY)
+		{
+			curr = __atomic_cas_uint32(&slot->state,
+									   GCACHE_AGGSLOT__EMPTY,
+									   GCACHE_AGGSLOT__LOCKED);
+			if (curr == GCACHE_AGGSLOT__EMPTY)
+			{
+				slot->key = key;
+				__threadfence();
+				__atomic_write_uint32(&slot->state,
+									  key_isnull
+									  ? GCACHE_AGGSLOT__VALID_NULL
+									  : GCACHE_AGGSLOT__VALID);
+				break;
+			}
+		}
+		while (curr == GCACHE_AGGSLOT__LOCKED)
+			curr = __volatileRead(&slot->state);
+		if (key_isnull
+			? curr == GCACHE_AGGSLOT__VALID_NULL
+			: (curr == GCACHE_AGGSLOT__VALID && slot->key == key))
+			break;
+		slot = NULL;
+	}
+	if (!slot)
+	{
+		/* hash slots are exhausted */
+		kcmeta->agg_invalid = 1;
+		return;
+	}
+	__atomic_add_int64(&slot->nrows, sign);
+	if (kcmeta->agg_value_anum > 0)
+	{
+		const kern_colmeta *vcmeta = &kds->colmeta[kcmeta->agg_value_anum - 1];
+		int64_t		ival;
+		float8_t	fval;
+
+		if (__gpucache_agg_fetch_value(kds, vcmeta, rowid,
+									   kcmeta->agg_value_float,
+									   &ival, &fval))
+		{
+			__atomic_add_int64(&slot->nvalues, sign);
+			if (kcmeta->agg_value_float)
+				__atomic_add_fp64(&slot->sum.fval, (float8_t)sign * fval);
+			else
+				__atomic_add_int64(&slot->sum.ival, sign * ival);
+		}
+	}
+}
+
+/*
+ * __gpucache_agg_refresh - accumulate/retract the row by its visibility
+ */
+STATIC_FUNCTION(void)
+__gpucache_agg_refresh(kern_data_store *kds,
+					   const GpuCacheSysattr *sysattr,
+					   uint32_t rowid, bool forget)
+{
+	kern_colmeta *kcmeta = __gpucache_agg_colmeta(kds);
+	uint32_t   *counted;
+	uint32_t	mask = (1U << (rowid & 31));
+	bool		want;
+	bool		has;
+
+	if (!kcmeta)
+		return;
+	counted = (uint32_t *)((char *)kds + __kds_unpack(kcmeta->agg_counted));
+	has = ((counted[rowid>>5] & mask) != 0);
+	want = (!forget &&
+			sysattr->xmin == FrozenTransactionId &&
+			sysattr->xmax != FrozenTransactionId);
+	if (want && !has)
+	{
+		__gpucache_agg_accum(kds, kcmeta, rowid, 1);
+		__atomic_or_uint32(&counted[rowid>>5], mask);
+	}
+	else if (!want && has)
+	{
+		__gpucache_agg_accum(kds, kcmeta, rowid, -1);
+		__atomic_and_uint32(&counted[rowid>>5], ~mask);
+	}
+}
+
 STATIC_FUNCTION(bool)
 __gpucache_apply_insert_log(kern_context *kcxt,
 							kern_data_store *kds,
@@ -742,10 +1185,12 @@ __gpucache_apply_insert_log(kern_context *kcxt,
 	bool		heap_hasnull = ((htup->t_infomask & HEAP_HASNULL) != 0);
 	uint32_t	offset = htup->t_hoff;
 	int			j, ncols = Min(kds->ncols, (htup->t_infomask2 & HEAP_NATTS_MASK));
+	kern_colmeta *hcmeta = NULL;
+	uint32_t	hindex_hash = 0;
 
 	for (j=0; j < ncols; j++)
 	{
-		const kern_colmeta *cmeta = &kds->colmeta[j];
+		kern_colmeta *cmeta = &kds->colmeta[j];
 		char	   *base;
 
 		if (cmeta->nullmap_offset != 0)
@@ -774,7 +1219,22 @@ __gpucache_apply_insert_log(kern_context *kcxt,
 
 		assert(cmeta->values_offset != 0);
 		base = (char *)kds + __kds_unpack(cmeta->values_offset);
-		if (cmeta->attlen > 0)
+		if (cmeta->attlen > 0 && cmeta->hindex_nslots > 0)
+		{
+			hcmeta = cmeta;
+			hindex_hash = pg_hash_any((char *)htup +
+									  TYPEALIGN(cmeta->attalign, offset),
+									  cmeta->attlen);
+		}
+		if (cmeta->col_encoding == KDS_COLUMN_ENCODING__BITPACK)
+		{
+			offset = TYPEALIGN(cmeta->attalign, offset);
+			if (!__gpucache_store_bitpack_value(kcxt, cmeta, base, rowid,
+												(char *)htup + offset))
+				return false;
+			offset += cmeta->attlen;
+		}
+		else if (cmeta->attlen > 0)
 		{
 			offset = TYPEALIGN(cmeta->attalign, offset);
 			memcpy(base + cmeta->attlen * rowid,
@@ -793,6 +1253,32 @@ __gpucache_apply_insert_log(kern_context *kcxt,
 				offset = TYPEALIGN(cmeta->attalign, offset);
 			vl_pos = (char *)htup + offset;
 			vl_len = VARSIZE_ANY(vl_pos);
+			if (cmeta->hindex_nslots > 0)
+			{
+				/* hash-index works on the raw bytes of the value */
+				if (VARATT_IS_COMPRESSED(vl_pos) || VARATT_IS_EXTERNAL(vl_pos))
+					cmeta->hindex_invalid = 1;
+				else
+				{
+					hcmeta = cmeta;
+					hindex_hash = pg_hash_any(VARDATA_ANY(vl_pos),
+											  VARSIZE_ANY_EXHDR(vl_pos));
+				}
+			}
+			if (cmeta->col_encoding == KDS_COLUMN_ENCODING__DICT)
+			{
+				vl_off = __gpucache_dict_insert_value(cmeta, extra,
+													  vl_pos, vl_len);
+				if (vl_off == 0)
+				{
+					STROM_EREPORT(kcxt, ERRCODE_BUFFER_NO_SPACE,
+								  "gpucache: extra buffer has no space");
+					return false;
+				}
+				((uint32_t *)base)[rowid] = vl_off;
+				offset += vl_len;
+				continue;
+			}
 			vl_off = __atomic_add_uint64(&extra->usage, MAXALIGN(vl_len));
 			if (vl_off + vl_len > extra->length)
 			{
@@ -807,6 +1293,8 @@ __gpucache_apply_insert_log(kern_context *kcxt,
 			offset += vl_len;
 		}
 	}
+	if (hcmeta)
+		__gpucache_hindex_insert(kds, hcmeta, hindex_hash, rowid);
 	sysattr->xmin = htup->t_choice.t_heap.t_xmin;
 	sysattr->xmax = htup->t_choice.t_heap.t_xmax;
 	memcpy(&sysattr->ctid, &htup->t_ctid, sizeof(ItemPointerData));
@@ -845,7 +1333,10 @@ gpucache_apply_update_logs(kern_context *kcxt,
 			sysattr = kds_column_get_sysattr(kds, i_log->rowid);
 			if (sysattr->owner == owner_id)
 			{
+				/* retract the older row on the rowid, prior to overwrite */
+				__gpucache_agg_refresh(kds, sysattr, i_log->rowid, true);
 				__gpucache_apply_insert_log(kcxt, kds, extra, sysattr, i_log);
+				__gpucache_agg_refresh(kds, sysattr, i_log->rowid, false);
 				if (rowid_max == UINT_MAX || rowid_max < i_log->rowid)
 					rowid_max = i_log->rowid;
 			}
@@ -917,6 +1408,9 @@ __gpucache_count_deadspace(kern_data_store *kds,
 			if (cmeta->attlen > 0)
 				continue;
 			assert(cmeta->attlen == -1);
+			/* dictionary entries may be shared by other rows */
+			if (cmeta->col_encoding == KDS_COLUMN_ENCODING__DICT)
+				continue;
 			if (!KDS_COLUMN_ITEM_ISNULL(kds, cmeta, rowid))
 			{
 				uint32_t   *base = (uint32_t *)
@@ -969,6 +1463,7 @@ gpucache_apply_xact_logs(kern_context *kcxt,
 					sysattr->xmin = FrozenTransactionId;
 					if (rowid_max == UINT_MAX || rowid_max < tx_log->rowid)
 						rowid_max = tx_log->rowid;
+					__gpucache_agg_refresh(kds, sysattr, tx_log->rowid, false);
 				}
 				break;
 			case GCACHE_TX_LOG__COMMIT_DEL:
@@ -978,6 +1473,7 @@ gpucache_apply_xact_logs(kern_context *kcxt,
 					sysattr->xmax = FrozenTransactionId;
 					if (rowid_max == UINT_MAX || rowid_max < tx_log->rowid)
 						rowid_max = tx_log->rowid;
+					__gpucache_agg_refresh(kds, sysattr, tx_log->rowid, false);
 					sz = __gpucache_count_deadspace(kds, extra, tx_log->rowid);
 					if (sz > 0)
 						__atomic_add_uint64(&smx_deadspace, sz);
@@ -1061,10 +1557,20 @@ kern_gpucache_apply_redo(kern_gpucache_redolog *gcache_redo,
 	STROM_WRITEBACK_ERROR_STATUS(&gcache_redo->kerror, &kcxt);
 }
 
+/*
+ * kern_gpucache_compaction
+ *
+ * It copies the varlena values referenced by the main buffer from the
+ * OLD extra buffer to the NEW one. The main buffer is never modified
+ * here, because concurrent scans can still reference the OLD extra buffer;
+ * the new offsets are written to the 'new_values' array (nitems x number
+ * of varlena columns), then the caller swaps them later.
+ */
 KERNEL_FUNCTION(void)
 kern_gpucache_compaction(kern_data_store *kds,
 						 kern_data_extra *extra_src,
-						 kern_data_extra *extra_dst)
+						 kern_data_extra *extra_dst,
+						 uint32_t *new_values)
 {
 	uint32_t	index;
 
@@ -1072,6 +1578,8 @@ kern_gpucache_compaction(kern_data_store *kds,
 		 index < kds->nitems;
 		 index += get_global_size())
 	{
+		uint32_t   *values_dst = new_values;
+
 		for (int j=0; j < kds->ncols; j++)
 		{
 			kern_colmeta   *cmeta = &kds->colmeta[j];
@@ -1082,25 +1590,38 @@ kern_gpucache_compaction(kern_data_store *kds,
 
 			if (cmeta->attlen >= 0)
 				continue;
+			values = (uint32_t *)
+				((char *)kds + __kds_unpack(cmeta->values_offset));
 			if (cmeta->nullmap_offset != 0)
 			{
 				uint8_t	   *nullmap = (uint8_t *)
 					((char *)kds + __kds_unpack(cmeta->nullmap_offset));
 
 				if (att_isnull(index, nullmap))
-					continue;
+				{
+					values_dst[index] = values[index];
+					goto next;
+				}
 			}
-			values = (uint32_t *)
-				((char *)kds + __kds_unpack(cmeta->values_offset));
 			vl_src = ((char *)extra_src + __kds_unpack(values[index]));
 			vl_len = VARSIZE_ANY(vl_src);
-
+			if (cmeta->col_encoding == KDS_COLUMN_ENCODING__DICT)
+			{
+				/* rebuild the dictionary on the NEW extra buffer */
+				values_dst[index] = __gpucache_dict_insert_value(cmeta,
+																 extra_dst,
+																 vl_src,
+																 vl_len);
+				goto next;
+			}
 			offset = __atomic_add_uint64(&extra_dst->usage, MAXALIGN(vl_len));
 			if (offset + vl_len <= extra_dst->length)
 			{
 				memcpy((char *)extra_dst + offset, vl_src, vl_len);
-				values[index] = __kds_packed(offset);
+				values_dst[index] = __kds_packed(offset);
 			}
+		next:
+			values_dst += kds->nitems;
 		}
 	}
 }
@@ -0,0 +1,175 @@
+/*
+ * cuda_gpusort.cu
+ *
+ * Device implementation of GpuSort (top-K on the destination buffer)
+ * ----
+ * Copyright 2011-2023 (C) KaiGai Kohei <kaigai@kaigai.gr.jp>
+ * Copyright 2014-2023 (C) PG-Strom Developers Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the PostgreSQL License.
+ */
+#include "cuda_common.h"
+
+/*
+ * __gpusort_fetch_datum
+ *
+ * It extracts the sort key from the tuple on the kds_dst (KDS_FORMAT_ROW).
+ */
+STATIC_FUNCTION(bool)
+__gpusort_fetch_datum(kern_context *kcxt,
+					  const kern_data_store *kds,
+					  const kern_tupitem *tupitem,
+					  const kern_sortkey_desc *skey,
+					  xpu_datum_t *xdatum)
+{
+	const HeapTupleHeaderData *htup = &tupitem->htup;
+	uint32_t	offset = htup->t_hoff;
+	int			ncols = Min(htup->t_infomask2 & HEAP_NATTS_MASK, kds->ncols);
+	bool		heap_hasnull = ((htup->t_infomask & HEAP_HASNULL) != 0);
+	const char *addr = NULL;
+
+	if (skey->key_resno < 1 || skey->key_resno > ncols)
+		goto out;
+	if (heap_hasnull && att_isnull(skey->key_resno-1, htup->t_bits))
+		goto out;
+	/* try attcacheoff shortcut, if available */
+	if (!heap_hasnull &&
+		kds->colmeta[skey->key_resno-1].attcacheoff >= 0)
+	{
+		addr = ((char *)htup + htup->t_hoff +
+				kds->colmeta[skey->key_resno-1].attcacheoff);
+		goto out;
+	}
+	/* extract slow path */
+	for (int resno=1; resno <= skey->key_resno; resno++)
+	{
+		const kern_colmeta *cmeta = &kds->colmeta[resno-1];
+
+		if (heap_hasnull && att_isnull(resno-1, htup->t_bits))
+			continue;
+		if (cmeta->attlen > 0)
+			offset = TYPEALIGN(cmeta->attalign, offset);
+		else if (!VARATT_NOT_PAD_BYTE((char *)htup + offset))
+			offset = TYPEALIGN(cmeta->attalign, offset);
+		addr = ((char *)htup + offset);
+		if (cmeta->attlen > 0)
+			offset += cmeta->attlen;
+		else
+			offset += VARSIZE_ANY(addr);
+	}
+out:
+	if (!addr)
+	{
+		xdatum->expr_ops = NULL;
+		return true;
+	}
+	return skey->key_ops->xpu_datum_heap_read(kcxt, addr, xdatum);
+}
+
+/*
+ * __gpusort_compare
+ *
+ * It returns negative, zero or positive value according to the sort keys.
+ * Once an error gets reported, the result is meaningless; caller shall
+ * check kcxt->errcode.
+ */
+STATIC_FUNCTION(int)
+__gpusort_compare(kern_context *kcxt,
+				  kern_data_store *kds,
+				  uint32_t index_a,
+				  uint32_t index_b,
+				  xpu_datum_t *xdatum_a,
+				  xpu_datum_t *xdatum_b)
+{
+	const kern_session_info *session = kcxt->session;
+	const kern_sortkey_desc *skey = SESSION_GPUSORT_KEYDESC(session);
+	const kern_tupitem *tupitem_a = KDS_GET_TUPITEM(kds, index_a);
+	const kern_tupitem *tupitem_b = KDS_GET_TUPITEM(kds, index_b);
+
+	for (int i=0; i < session->gpusort_nkeys; i++, skey++)
+	{
+		int		comp;
+
+		if (!__gpusort_fetch_datum(kcxt, kds, tupitem_a, skey, xdatum_a) ||
+			!__gpusort_fetch_datum(kcxt, kds, tupitem_b, skey, xdatum_b))
+			return 0;
+		if (XPU_DATUM_ISNULL(xdatum_a) && XPU_DATUM_ISNULL(xdatum_b))
+			continue;
+		if (XPU_DATUM_ISNULL(xdatum_a))
+			return (skey->key_nulls_first ? -1 : 1);
+		if (XPU_DATUM_ISNULL(xdatum_b))
+			return (skey->key_nulls_first ? 1 : -1);
+		if (!skey->key_ops->xpu_datum_comp(kcxt, &comp, xdatum_a, xdatum_b))
+			return 0;
+		if (comp != 0)
+			return (skey->key_desc ? -comp : comp);
+		kcxt_reset(kcxt);
+	}
+	return 0;
+}
+
+/*
+ * kern_gpusort_bitonic_step
+ *
+ * A step of the bitonic-sorting on the row-index of kds_dst.
+ * The host code launches this kernel with unitsz = 2, 4, 8, ... and
+ * the sub-steps for each; the first step of each unit compares the
+ * mirrored positions (reversing = true), so it works with nitems that
+ * is not power of 2. Items beyond the nitems are considered as +infinity,
+ * thus, never swapped.
+ */
+KERNEL_FUNCTION(void)
+kern_gpusort_bitonic_step(kern_session_info *session,
+						  kern_gputask *kgtask,
+						  kern_data_store *kds_dst,
+						  uint32_t unitsz,
+						  bool reversing)
+{
+	kern_context   *kcxt;
+	const kern_sortkey_desc *skey;
+	xpu_datum_t	   *xdatum_a;
+	xpu_datum_t	   *xdatum_b;
+	uint32_t	   *row_index = KDS_GET_ROWINDEX(kds_dst);
+	uint32_t		nitems = kds_dst->nitems;
+	uint32_t		half = unitsz / 2;
+	uint32_t		sz = 0;
+
+	assert(session->gpusort_nkeys > 0 &&
+		   kds_dst->format == KDS_FORMAT_ROW &&
+		   unitsz >= 2 && (unitsz & (unitsz - 1)) == 0);
+	INIT_KERNEL_CONTEXT(kcxt, session);
+	skey = SESSION_GPUSORT_KEYDESC(session);
+	for (int i=0; i < session->gpusort_nkeys; i++)
+		sz = Max(sz, skey[i].key_ops->xpu_type_sizeof);
+	xdatum_a = (xpu_datum_t *)alloca(sz);
+	xdatum_b = (xpu_datum_t *)alloca(sz);
+
+	for (uint32_t id = get_global_id();
+		 id < TYPEALIGN(unitsz, nitems) / 2;
+		 id += get_global_size())
+	{
+		uint32_t	base = (id / half) * unitsz;
+		uint32_t	x = base + (id % half);
+		uint32_t	y;
+
+		if (reversing)
+			y = base + unitsz - 1 - (id % half);
+		else
+			y = x + half;
+		if (y >= nitems)
+			continue;
+		if (__gpusort_compare(kcxt, kds_dst, x, y,
+							  xdatum_a, xdatum_b) > 0)
+		{
+			uint32_t	temp = row_index[x];
+
+			row_index[x] = row_index[y];
+			row_index[y] = temp;
+		}
+		if (kcxt->errcode != ERRCODE_STROM_SUCCESS)
+			break;
+		kcxt_reset(kcxt);
+	}
+	STROM_WRITEBACK_ERROR_STATUS(&kgtask->kerror, kcxt);
+}
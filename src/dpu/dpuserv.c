@@ -12,6 +12,7 @@
 #include "dpuserv.h"
 
 struct groupby_final_buffer;
+struct dpuRdmaState;
 
 #define PEER_ADDR_LEN	80
 typedef struct
@@ -26,6 +27,7 @@ typedef struct
 	pthread_mutex_t		mutex;	/* mutex to write the socket */
 	int					sockfd;	/* connection to PG-backend */
 	pthread_t			worker;	/* receiver thread */
+	struct dpuRdmaState *rdma;	/* RDMA transport of the results, if any */
 	char				peer_addr[PEER_ADDR_LEN];
 } dpuClient;
 
@@ -33,14 +35,19 @@ static char			   *dpuserv_listen_addr = NULL;
 static long				dpuserv_listen_port = -1;
 static char			   *dpuserv_base_directory = NULL;
 static long				dpuserv_num_workers = -1;
+static long				dpuserv_split_pieces = -1;
 static char			   *dpuserv_identifier = NULL;
 static const char	   *dpuserv_logfile = NULL;
 static bool				verbose = false;
+static char			   *dpuserv_rdma_device = NULL;
+static long				dpuserv_rdma_gid_index = -1;
+static long				dpuserv_cache_size_mb = -1;
 static pthread_mutex_t	dpu_client_mutex;
 static dlist_head		dpu_client_list;
-static pthread_mutex_t	dpu_command_mutex;
+static pthread_mutex_t	dpu_command_mutex;	/* only for idle workers */
 static pthread_cond_t	dpu_command_cond;
-static dlist_head		dpu_command_list;
+static uint32_t			dpu_command_pending = 0;	/* atomic */
+static uint32_t			dpu_command_next_queue = 0;	/* atomic */
 static volatile bool	got_sigterm = false;
 static xpu_type_hash_table *dpuserv_type_htable = NULL;
 static xpu_func_hash_table *dpuserv_func_htable = NULL;
@@ -62,6 +69,8 @@ struct dpuTaskExecState
 	uint32_t		nitems_raw;		/* nitems in the raw data chunk */
 	uint32_t		nitems_in;		/* nitems after the scan_quals */
 	uint32_t		nitems_out;		/* nitems of final results */
+	uint32_t		npages_cache_hit;	/* pages found on the block cache */
+	uint32_t		npages_storage_read; /* pages read from the storage */
 	uint32_t		num_rels;		/* >0, if JOIN */
 	struct {
 		uint32_t	nitems_gist;	/* nitems picked up by GiST index */
@@ -70,6 +79,71 @@ struct dpuTaskExecState
 };
 typedef struct dpuTaskExecState		dpuTaskExecState;
 
+/*
+ * dpuWorkItem / dpuWorkerQueue
+ *
+ * Every worker thread has its own deque of the work items. The commands
+ * received from the clients are distributed to the queues in round-robin,
+ * and a worker pops the items from the head of its own queue first, then
+ * steals the items from the tail of the other queues once it goes empty.
+ * A work item is either a command from the client, or a piece of the
+ * XpuTaskExec command split into multiple row ranges.
+ */
+struct dpuTaskSplit;
+
+typedef struct
+{
+	dlist_node		chain;
+	XpuCommand	   *xcmd;		/* a command from the client, or NULL */
+	struct dpuTaskSplit *split;	/* a split task, if xcmd == NULL */
+	uint32_t		pindex;		/* index of the piece in the split task */
+} dpuWorkItem;
+
+/* dpuWorkItem is co-allocated just after the XpuCommand */
+#define XCMD_GET_WORK_ITEM(xcmd)								\
+	((dpuWorkItem *)((char *)(xcmd) + MAXALIGN((xcmd)->length)))
+
+typedef struct
+{
+	pthread_mutex_t	mutex;
+	dlist_head		items;
+} dpuWorkerQueue;
+
+static dpuWorkerQueue  *dpu_worker_queues = NULL;
+
+/*
+ * dpuTaskSplit
+ *
+ * An XpuTaskExec command with a large data chunk is split into multiple
+ * row (or block) ranges, then processed by several workers concurrently.
+ * Each piece has its own dpuTaskExecState; the pieces are merged into one
+ * response when all of them are completed. Note that GROUP BY results are
+ * accumulated on the groupby_final_buffer of the session under its own
+ * locks, so only the projection results and statistics need to be merged.
+ */
+typedef struct
+{
+	dpuWorkItem		item;
+	uint32_t		start;
+	uint32_t		end;
+	dpuTaskExecState *dtes;
+} dpuTaskPiece;
+
+typedef struct dpuTaskSplit
+{
+	dpuClient	   *dclient;
+	kern_data_store *kds_src;
+	pthread_mutex_t	mutex;
+	pthread_cond_t	cond;
+	uint32_t		nremains;	/* protected by the mutex */
+	bool			failed;		/* atomic */
+	uint32_t		npieces;
+	dpuTaskPiece	pieces[1];
+} dpuTaskSplit;
+
+#define DPUSERV_SPLIT_MIN_BLOCKS	32		/* 256kB of heap blocks */
+#define DPUSERV_SPLIT_MIN_ROWS		65536
+
 
 
 /*
@@ -118,6 +192,515 @@ __dpuClientWriteBack(dpuClient *dclient, struct iovec *iov, int iovcnt)
 	pthreadMutexUnlock(&dclient->mutex);
 }
 
+/*
+ * RDMA transport of the results
+ *
+ * If the backend requested by XpuCommandTag__RdmaSetup, the responses are
+ * written to the result ring buffer of the backend using RDMA WRITE, then
+ * only its offset is sent by the socket (XpuCommandTag__RingResponse).
+ * The local head of the ring is also written to the backend to release
+ * the items, and the tail is fetched by RDMA READ when the ring looks full.
+ * Any failure on the RDMA transport disables it; the results are sent by
+ * the socket as usual.
+ */
+#ifdef HAVE_IBVERBS
+#define DPUSERV_RDMA_STAGING_SZ		(PGSTROM_CHUNK_SIZE + (4UL << 20))
+
+typedef struct dpuRdmaState
+{
+	pthread_mutex_t		mutex;
+	bool				broken;
+	struct ibv_context *ctx;
+	struct ibv_pd	   *pd;
+	struct ibv_cq	   *cq;
+	struct ibv_qp	   *qp;
+	struct ibv_mr	   *staging_mr;
+	char			   *staging;	/* source buffer of RDMA WRITE */
+	struct ibv_mr	   *scratch_mr;
+	uint64_t		   *scratch;	/* [0] tail, [1] head, [2..3] padding */
+	kern_rdma_params	remote;
+	uint64_t			head;		/* local copy of the ring head */
+	uint64_t			tail;		/* cached value of the ring tail */
+} dpuRdmaState;
+
+static void
+__dpuRdmaStateRelease(dpuRdmaState *rdma)
+{
+	if (rdma->qp)
+		ibv_destroy_qp(rdma->qp);
+	if (rdma->staging_mr)
+		ibv_dereg_mr(rdma->staging_mr);
+	if (rdma->scratch_mr)
+		ibv_dereg_mr(rdma->scratch_mr);
+	if (rdma->cq)
+		ibv_destroy_cq(rdma->cq);
+	if (rdma->pd)
+		ibv_dealloc_pd(rdma->pd);
+	if (rdma->ctx)
+		ibv_close_device(rdma->ctx);
+	if (rdma->staging)
+		free(rdma->staging);
+	if (rdma->scratch)
+		free(rdma->scratch);
+	pthread_mutex_destroy(&rdma->mutex);
+	free(rdma);
+}
+
+static dpuRdmaState *
+__dpuRdmaStateCreate(dpuClient *dclient,
+					 const kern_rdma_params *remote,
+					 kern_rdma_params *local)
+{
+	dpuRdmaState *rdma;
+	struct ibv_device **dev_list;
+	struct ibv_port_attr port_attr;
+	struct ibv_qp_init_attr qp_init;
+	struct ibv_qp_attr attr;
+	union ibv_gid gid;
+	int			num_devs;
+
+	rdma = calloc(1, sizeof(dpuRdmaState));
+	if (!rdma)
+		return NULL;
+	pthreadMutexInit(&rdma->mutex);
+	memcpy(&rdma->remote, remote, sizeof(kern_rdma_params));
+
+	dev_list = ibv_get_device_list(&num_devs);
+	if (dev_list)
+	{
+		for (int i=0; i < num_devs; i++)
+		{
+			if (strcmp(dpuserv_rdma_device, "auto") == 0 ||
+				strcmp(dpuserv_rdma_device, ibv_get_device_name(dev_list[i])) == 0)
+			{
+				rdma->ctx = ibv_open_device(dev_list[i]);
+				break;
+			}
+		}
+		ibv_free_device_list(dev_list);
+	}
+	if (!rdma->ctx ||
+		ibv_query_port(rdma->ctx, 1, &port_attr) != 0 ||
+		ibv_query_gid(rdma->ctx, 1, dpuserv_rdma_gid_index, &gid) != 0)
+		goto error;
+	if (!(rdma->pd = ibv_alloc_pd(rdma->ctx)) ||
+		!(rdma->cq = ibv_create_cq(rdma->ctx, 16, NULL, NULL, 0)))
+		goto error;
+	rdma->staging = malloc(DPUSERV_RDMA_STAGING_SZ);
+	rdma->scratch = calloc(4, sizeof(uint64_t));
+	if (!rdma->staging || !rdma->scratch)
+		goto error;
+	rdma->staging_mr = ibv_reg_mr(rdma->pd, rdma->staging,
+								  DPUSERV_RDMA_STAGING_SZ,
+								  IBV_ACCESS_LOCAL_WRITE);
+	rdma->scratch_mr = ibv_reg_mr(rdma->pd, rdma->scratch,
+								  4 * sizeof(uint64_t),
+								  IBV_ACCESS_LOCAL_WRITE);
+	if (!rdma->staging_mr || !rdma->scratch_mr)
+		goto error;
+	memset(&qp_init, 0, sizeof(qp_init));
+	qp_init.send_cq = rdma->cq;
+	qp_init.recv_cq = rdma->cq;
+	qp_init.qp_type = IBV_QPT_RC;
+	qp_init.sq_sig_all = 0;
+	qp_init.cap.max_send_wr = 16;
+	qp_init.cap.max_recv_wr = 1;
+	qp_init.cap.max_send_sge = 1;
+	qp_init.cap.max_recv_sge = 1;
+	if (!(rdma->qp = ibv_create_qp(rdma->pd, &qp_init)))
+		goto error;
+
+	/* INIT -> RTR -> RTS */
+	memset(&attr, 0, sizeof(attr));
+	attr.qp_state = IBV_QPS_INIT;
+	attr.port_num = 1;
+	attr.qp_access_flags = IBV_ACCESS_LOCAL_WRITE;
+	if (ibv_modify_qp(rdma->qp, &attr,
+					  IBV_QP_STATE |
+					  IBV_QP_PKEY_INDEX |
+					  IBV_QP_PORT |
+					  IBV_QP_ACCESS_FLAGS) != 0)
+		goto error;
+	local->qp_num = rdma->qp->qp_num;
+	local->psn = (random() & 0xffffffU);
+	local->lid = port_attr.lid;
+	local->mtu = port_attr.active_mtu;
+	local->gid_index = dpuserv_rdma_gid_index;
+	memcpy(local->gid, gid.raw, 16);
+
+	memset(&attr, 0, sizeof(attr));
+	attr.qp_state = IBV_QPS_RTR;
+	attr.path_mtu = Min(local->mtu, remote->mtu);
+	attr.dest_qp_num = remote->qp_num;
+	attr.rq_psn = remote->psn;
+	attr.max_dest_rd_atomic = 1;
+	attr.min_rnr_timer = 12;
+	attr.ah_attr.dlid = remote->lid;
+	attr.ah_attr.port_num = 1;
+	attr.ah_attr.is_global = 1;
+	memcpy(attr.ah_attr.grh.dgid.raw, remote->gid, 16);
+	attr.ah_attr.grh.sgid_index = local->gid_index;
+	attr.ah_attr.grh.hop_limit = 64;
+	if (ibv_modify_qp(rdma->qp, &attr,
+					  IBV_QP_STATE |
+					  IBV_QP_AV |
+					  IBV_QP_PATH_MTU |
+					  IBV_QP_DEST_QPN |
+					  IBV_QP_RQ_PSN |
+					  IBV_QP_MAX_DEST_RD_ATOMIC |
+					  IBV_QP_MIN_RNR_TIMER) != 0)
+		goto error;
+	memset(&attr, 0, sizeof(attr));
+	attr.qp_state = IBV_QPS_RTS;
+	attr.timeout = 14;
+	attr.retry_cnt = 7;
+	attr.rnr_retry = 7;
+	attr.sq_psn = local->psn;
+	attr.max_rd_atomic = 1;
+	if (ibv_modify_qp(rdma->qp, &attr,
+					  IBV_QP_STATE |
+					  IBV_QP_TIMEOUT |
+					  IBV_QP_RETRY_CNT |
+					  IBV_QP_RNR_RETRY |
+					  IBV_QP_SQ_PSN |
+					  IBV_QP_MAX_QP_RD_ATOMIC) != 0)
+		goto error;
+	return rdma;
+
+error:
+	fprintf(stderr, "[%s] unable to setup RDMA transport: %m\n",
+			dclient->peer_addr);
+	__dpuRdmaStateRelease(rdma);
+	memset(local, 0, sizeof(kern_rdma_params));
+	return NULL;
+}
+
+/*
+ * __dpuRdmaPostSync - posts the work-requests, then waits for completion
+ * of the last one (signaled). Work requests on RC queue-pair are executed
+ * in order, so it also ensures the completion of the preceding ones.
+ */
+static bool
+__dpuRdmaPostSync(dpuRdmaState *rdma, struct ibv_send_wr *wr_list, int nwr)
+{
+	struct ibv_send_wr *bad_wr;
+	struct ibv_wc	wc;
+	int				rv;
+
+	for (int i=0; i < nwr; i++)
+	{
+		wr_list[i].wr_id = i;
+		wr_list[i].next = (i+1 < nwr ? &wr_list[i+1] : NULL);
+		wr_list[i].send_flags = (i+1 < nwr ? 0 : IBV_SEND_SIGNALED);
+	}
+	if (ibv_post_send(rdma->qp, wr_list, &bad_wr) != 0)
+		return false;
+	do {
+		rv = ibv_poll_cq(rdma->cq, 1, &wc);
+	} while (rv == 0);
+	return (rv > 0 && wc.status == IBV_WC_SUCCESS);
+}
+
+static inline void
+__dpuRdmaSetupWR(struct ibv_send_wr *wr, struct ibv_sge *sge,
+				 enum ibv_wr_opcode opcode,
+				 void *laddr, uint32_t length, uint32_t lkey,
+				 uint64_t raddr, uint32_t rkey)
+{
+	memset(wr, 0, sizeof(struct ibv_send_wr));
+	sge->addr   = (uint64_t)laddr;
+	sge->length = length;
+	sge->lkey   = lkey;
+	wr->sg_list = sge;
+	wr->num_sge = 1;
+	wr->opcode  = opcode;
+	wr->wr.rdma.remote_addr = raddr;
+	wr->wr.rdma.rkey = rkey;
+}
+
+static bool
+__dpuClientWriteBackRdma(dpuClient *dclient,
+						 struct iovec *iov_array, int iovcnt,
+						 size_t resp_sz)
+{
+	dpuRdmaState   *rdma = dclient->rdma;
+	kern_rdma_params *remote = &rdma->remote;
+	struct ibv_send_wr wr[3];
+	struct ibv_sge	sge[3];
+	int				nwr = 0;
+	uint64_t		ring_data = remote->ring_addr + remote->ring_data_offset;
+	uint64_t		pos, padding = 0;
+	size_t			required;
+	char		   *dst;
+	XpuCommand		resp;
+	struct iovec	iov;
+
+	required = TYPEALIGN(remote->ring_align,
+						 remote->ring_item_headsz + resp_sz);
+	if (required > remote->ring_nbytes / 2 ||
+		required > DPUSERV_RDMA_STAGING_SZ)
+		return false;
+
+	pthreadMutexLock(&rdma->mutex);
+	if (rdma->broken)
+		goto bailout;
+	pos = rdma->head % remote->ring_nbytes;
+	if (pos + required > remote->ring_nbytes)
+		padding = remote->ring_nbytes - pos;
+	if (remote->ring_nbytes - (rdma->head - rdma->tail) < padding + required)
+	{
+		/* fetch the latest tail of the ring buffer */
+		__dpuRdmaSetupWR(&wr[0], &sge[0], IBV_WR_RDMA_READ,
+						 &rdma->scratch[0], sizeof(uint64_t),
+						 rdma->scratch_mr->lkey,
+						 remote->ring_addr + remote->ring_tail_offset,
+						 remote->ring_rkey);
+		if (!__dpuRdmaPostSync(rdma, wr, 1))
+			goto broken;
+		rdma->tail = rdma->scratch[0];
+		if (remote->ring_nbytes - (rdma->head - rdma->tail) < padding + required)
+			goto bailout;	/* ring buffer is full, so use the socket */
+	}
+	/* padding item at the end of the ring buffer, if any */
+	if (padding > 0)
+	{
+		rdma->scratch[2] = padding;		/* xpuResultRingItem.length */
+		rdma->scratch[3] = 1;			/* xpuResultRingItem.released */
+		__dpuRdmaSetupWR(&wr[nwr], &sge[nwr], IBV_WR_RDMA_WRITE,
+						 &rdma->scratch[2], 2 * sizeof(uint64_t),
+						 rdma->scratch_mr->lkey,
+						 ring_data + pos,
+						 remote->ring_rkey);
+		nwr++;
+		pos = 0;
+	}
+	/* the response item */
+	memset(rdma->staging, 0, remote->ring_item_headsz);
+	((uint64_t *)rdma->staging)[0] = required;	/* xpuResultRingItem.length */
+	dst = rdma->staging + remote->ring_item_headsz;
+	for (int i=0; i < iovcnt; i++)
+	{
+		memcpy(dst, iov_array[i].iov_base, iov_array[i].iov_len);
+		dst += iov_array[i].iov_len;
+	}
+	__dpuRdmaSetupWR(&wr[nwr], &sge[nwr], IBV_WR_RDMA_WRITE,
+					 rdma->staging, remote->ring_item_headsz + resp_sz,
+					 rdma->staging_mr->lkey,
+					 ring_data + pos,
+					 remote->ring_rkey);
+	nwr++;
+	/* move the head forward */
+	rdma->scratch[1] = rdma->head + padding + required;
+	__dpuRdmaSetupWR(&wr[nwr], &sge[nwr], IBV_WR_RDMA_WRITE,
+					 &rdma->scratch[1], sizeof(uint64_t),
+					 rdma->scratch_mr->lkey,
+					 remote->ring_addr + remote->ring_head_offset,
+					 remote->ring_rkey);
+	nwr++;
+	if (!__dpuRdmaPostSync(rdma, wr, nwr))
+		goto broken;
+	rdma->head += padding + required;
+	pthreadMutexUnlock(&rdma->mutex);
+
+	/* send the offset of the response */
+	memset(&resp, 0, offsetof(XpuCommand, u.ring_offset));
+	resp.magic = XpuCommandMagicNumber;
+	resp.tag   = XpuCommandTag__RingResponse;
+	resp.length = offsetof(XpuCommand, u.ring_offset) + sizeof(uint64_t);
+	resp.u.ring_offset = pos;
+	iov.iov_base = &resp;
+	iov.iov_len  = resp.length;
+	__dpuClientWriteBack(dclient, &iov, 1);
+	return true;
+
+broken:
+	fprintf(stderr, "[%s] RDMA transport is broken, use the socket instead\n",
+			dclient->peer_addr);
+	rdma->broken = true;
+bailout:
+	pthreadMutexUnlock(&rdma->mutex);
+	return false;
+}
+
+/*
+ * dpuservHandleRdmaSetup
+ */
+static void
+dpuservHandleRdmaSetup(dpuClient *dclient, XpuCommand *xcmd)
+{
+	XpuCommand	resp;
+	struct iovec iov;
+
+	memset(&resp, 0, sizeof(XpuCommand));
+	resp.magic = XpuCommandMagicNumber;
+	resp.tag   = XpuCommandTag__RdmaSetup;
+	resp.length = offsetof(XpuCommand, u.rdma) + sizeof(kern_rdma_params);
+	if (dpuserv_rdma_device && !dclient->rdma)
+		dclient->rdma = __dpuRdmaStateCreate(dclient, &xcmd->u.rdma,
+											 &resp.u.rdma);
+	iov.iov_base = &resp;
+	iov.iov_len  = resp.length;
+	__dpuClientWriteBack(dclient, &iov, 1);
+}
+#endif	/* HAVE_IBVERBS */
+
+/*
+ * __dpuClientCompressResults
+ *
+ * It compresses the kds_dst array of the response (the iovec items from
+ * the chunks_offset) using the codec offered by the session, then replaces
+ * them by the compressed buffer. Small or poorly compressible results are
+ * sent as is. The caller must release *p_cbuf after the write-back.
+ */
+#define DPUSERV_COMPRESS_MIN_SZ		(64UL << 10)
+
+static int
+__dpuClientCompressResults(dpuClient *dclient, XpuCommand *resp,
+						   struct iovec *iov_array, int iovcnt,
+						   void **p_cbuf)
+{
+	uint32_t	codec = dclient->session->xpu_result_codec;
+	char	   *cbuf = NULL;
+	size_t		cbuf_sz = 0;
+	size_t		raw_sz = 0;
+	size_t		off = 0;
+	int			first = -1;
+
+	*p_cbuf = NULL;
+	if (codec == XPU_RESULT_CODEC__NONE ||
+		resp->u.results.chunks_nitems == 0)
+		return iovcnt;
+	for (int i=0; i < iovcnt; i++)
+	{
+		if (off == resp->u.results.chunks_offset && first < 0)
+			first = i;
+		if (first >= 0)
+			raw_sz += iov_array[i].iov_len;
+		off += iov_array[i].iov_len;
+	}
+	if (first < 1 || raw_sz < DPUSERV_COMPRESS_MIN_SZ)
+		return iovcnt;
+
+	switch (codec)
+	{
+#ifdef USE_LZ4
+		case XPU_RESULT_CODEC__LZ4:
+			{
+				LZ4F_cctx  *cctx;
+				LZ4F_preferences_t prefs;
+				size_t		cbuf_cap = LZ4F_HEADER_SIZE_MAX;
+				size_t		rv;
+
+				memset(&prefs, 0, sizeof(LZ4F_preferences_t));
+				prefs.frameInfo.blockSizeID = LZ4F_max4MB;
+				prefs.frameInfo.contentSize = raw_sz;
+				for (int i=first; i < iovcnt; i++)
+					cbuf_cap += LZ4F_compressBound(iov_array[i].iov_len, &prefs);
+				if (LZ4F_isError(LZ4F_createCompressionContext(&cctx, LZ4F_VERSION)))
+					return iovcnt;
+				cbuf = malloc(cbuf_cap);
+				if (!cbuf)
+				{
+					LZ4F_freeCompressionContext(cctx);
+					return iovcnt;
+				}
+				rv = LZ4F_compressBegin(cctx, cbuf, cbuf_cap, &prefs);
+				if (!LZ4F_isError(rv))
+				{
+					cbuf_sz = rv;
+					for (int i=first; i < iovcnt; i++)
+					{
+						rv = LZ4F_compressUpdate(cctx,
+												 cbuf + cbuf_sz,
+												 cbuf_cap - cbuf_sz,
+												 iov_array[i].iov_base,
+												 iov_array[i].iov_len, NULL);
+						if (LZ4F_isError(rv))
+							break;
+						cbuf_sz += rv;
+					}
+				}
+				if (!LZ4F_isError(rv))
+					rv = LZ4F_compressEnd(cctx,
+										  cbuf + cbuf_sz,
+										  cbuf_cap - cbuf_sz, NULL);
+				LZ4F_freeCompressionContext(cctx);
+				if (LZ4F_isError(rv))
+				{
+					fprintf(stderr, "[%s] failed on LZ4 compression: %s\n",
+							dclient->peer_addr, LZ4F_getErrorName(rv));
+					free(cbuf);
+					return iovcnt;
+				}
+				cbuf_sz += rv;
+			}
+			break;
+#endif
+#ifdef USE_ZSTD
+		case XPU_RESULT_CODEC__ZSTD:
+			{
+				ZSTD_CCtx  *cctx = ZSTD_createCCtx();
+				ZSTD_outBuffer out;
+				size_t		rv = 0;
+
+				if (!cctx)
+					return iovcnt;
+				out.size = ZSTD_compressBound(raw_sz);
+				out.pos  = 0;
+				out.dst  = cbuf = malloc(out.size);
+				if (!cbuf)
+				{
+					ZSTD_freeCCtx(cctx);
+					return iovcnt;
+				}
+				/* DPU cores are weak, so prefer the speed to the ratio */
+				ZSTD_CCtx_setParameter(cctx, ZSTD_c_compressionLevel, 1);
+				ZSTD_CCtx_setPledgedSrcSize(cctx, raw_sz);
+				for (int i=first; i < iovcnt && !ZSTD_isError(rv); i++)
+				{
+					ZSTD_inBuffer in = { iov_array[i].iov_base,
+										 iov_array[i].iov_len, 0 };
+					ZSTD_EndDirective mode = (i+1 < iovcnt
+											  ? ZSTD_e_continue
+											  : ZSTD_e_end);
+					do {
+						rv = ZSTD_compressStream2(cctx, &out, &in, mode);
+						if (ZSTD_isError(rv))
+							break;
+					} while (mode == ZSTD_e_end ? rv != 0 : in.pos < in.size);
+				}
+				ZSTD_freeCCtx(cctx);
+				if (ZSTD_isError(rv))
+				{
+					fprintf(stderr, "[%s] failed on ZSTD compression: %s\n",
+							dclient->peer_addr, ZSTD_getErrorName(rv));
+					free(cbuf);
+					return iovcnt;
+				}
+				cbuf_sz = out.pos;
+			}
+			break;
+#endif
+		default:
+			/* not supported by this build, so send it as is */
+			return iovcnt;
+	}
+	/* no benefit unless it saves 1/8 at least */
+	if (cbuf_sz >= raw_sz - raw_sz / 8)
+	{
+		free(cbuf);
+		return iovcnt;
+	}
+	resp->u.results.chunks_codec = codec;
+	resp->u.results.chunks_rawsz = raw_sz;
+	resp->length = resp->u.results.chunks_offset + cbuf_sz;
+	iov_array[first].iov_base = cbuf;
+	iov_array[first].iov_len  = cbuf_sz;
+	*p_cbuf = cbuf;
+
+	return first + 1;
+}
+
 static void
 dpuClientWriteBack(dpuClient *dclient,
 				   dpuTaskExecState *dtes)
@@ -127,6 +710,7 @@ dpuClientWriteBack(dpuClient *dclient,
 	struct iovec   *iov;
 	int				iovcnt = 0;
 	int				resp_sz;
+	void		   *cbuf;
 
 	/* Xcmd for the response */
 	resp_sz = MAXALIGN(offsetof(XpuCommand, u.results.stats[dtes->num_rels]));
@@ -137,6 +721,8 @@ dpuClientWriteBack(dpuClient *dclient,
 	resp->u.results.chunks_offset = resp_sz;
 	resp->u.results.chunks_nitems = dtes->kds_dst_nitems;
 	resp->u.results.nitems_raw = dtes->nitems_raw;
+	resp->u.results.npages_vfs_read = dtes->npages_storage_read;
+	resp->u.results.npages_dpucache_hit = dtes->npages_cache_hit;
 	resp->u.results.nitems_in  = dtes->nitems_in;
 	resp->u.results.nitems_out = dtes->nitems_out;
 	resp->u.results.num_rels   = dtes->num_rels;
@@ -183,7 +769,19 @@ dpuClientWriteBack(dpuClient *dclient,
 		resp_sz += kds->length;
 	}
 	resp->length = resp_sz;
+	iovcnt = __dpuClientCompressResults(dclient, resp, iov_array, iovcnt, &cbuf);
+#ifdef HAVE_IBVERBS
+	if (dclient->rdma &&
+		__dpuClientWriteBackRdma(dclient, iov_array, iovcnt, resp->length))
+	{
+		if (cbuf)
+			free(cbuf);
+		return;
+	}
+#endif
 	__dpuClientWriteBack(dclient, iov_array, iovcnt);
+	if (cbuf)
+		free(cbuf);
 }
 
 /*
@@ -248,6 +846,7 @@ struct groupby_final_buffer
 typedef struct groupby_final_buffer		groupby_final_buffer;
 
 static pthread_mutex_t	groupby_final_buffer_lock;
+static pthread_mutex_t	dpu_gist_prep_mutex;
 #define GROUPBY_FINAL_BUFFER_HASHSZ		200
 static dlist_head		groupby_final_buffer_hash[GROUPBY_FINAL_BUFFER_HASHSZ];
 
@@ -368,6 +967,7 @@ dpuServMapSessionBuffers(dpuClient *dclient, kern_session_info *session)
 		}
 		dclient->kmrels = mmap_addr;
 		dclient->kmrels_sz = mmap_sz;
+		__dpuServPrepGiSTIndex(dclient->kmrels);
 	}
 
 	if (session->groupby_kds_final)
@@ -378,6 +978,73 @@ dpuServMapSessionBuffers(dpuClient *dclient, kern_session_info *session)
 	return true;
 }
 
+/*
+ * __dpuServPrepGiSTIndex
+ *
+ * It replaces the ctid of the GiST leaf items by the offset of the inner
+ * tuple on the kds_hash, as gpujoin_prep_gistindex doing on GPU. Because
+ * the inner buffer is shared by the sessions of the same join, the items
+ * already prepared (ip_posid == InvalidOffsetNumber) are skipped.
+ */
+static void
+__dpuServPrepGiSTIndex(kern_multirels *kmrels)
+{
+	pthreadMutexLock(&dpu_gist_prep_mutex);
+	for (int depth=1; depth <= kmrels->num_rels; depth++)
+	{
+		kern_data_store *kds_hash;
+		kern_data_store *kds_gist;
+
+		if (kmrels->chunks[depth-1].gist_offset == 0)
+			continue;
+		kds_hash = KERN_MULTIRELS_INNER_KDS(kmrels, depth-1);
+		kds_gist = KERN_MULTIRELS_GIST_INDEX(kmrels, depth-1);
+		assert(kds_hash && kds_hash->format == KDS_FORMAT_HASH &&
+			   kds_gist && kds_gist->format == KDS_FORMAT_BLOCK);
+		for (uint32_t block_nr=0; block_nr < kds_gist->nitems; block_nr++)
+		{
+			PageHeaderData *gist_page = KDS_BLOCK_PGPAGE(kds_gist, block_nr);
+			OffsetNumber	i, maxoff;
+
+			if (!GistPageIsLeaf(gist_page))
+				continue;
+			maxoff = PageGetMaxOffsetNumber(gist_page);
+			for (i=0; i < maxoff; i++)
+			{
+				ItemIdData	   *lpp = PageGetItemId(gist_page, i+1);
+				IndexTupleData *itup;
+				kern_hashitem  *khitem;
+				uint32_t		hash, t_off;
+
+				if (ItemIdIsDead(lpp))
+					continue;
+				itup = (IndexTupleData *)PageGetItem(gist_page, lpp);
+				if (itup->t_tid.ip_posid == InvalidOffsetNumber)
+					continue;	/* already prepared */
+				hash = pg_hash_any(&itup->t_tid, sizeof(ItemPointerData));
+				for (khitem = KDS_HASH_FIRST_ITEM(kds_hash, hash);
+					 khitem != NULL;
+					 khitem = KDS_HASH_NEXT_ITEM(kds_hash, khitem->next))
+				{
+					if (ItemPointerEquals(&khitem->t.htup.t_ctid, &itup->t_tid))
+					{
+						t_off = __kds_packed((char *)&khitem->t.htup -
+											 (char *)kds_hash);
+						itup->t_tid.ip_blkid.bi_hi = (t_off >> 16);
+						itup->t_tid.ip_blkid.bi_lo = (t_off & 0x0000ffffU);
+						itup->t_tid.ip_posid = InvalidOffsetNumber;
+						break;
+					}
+				}
+				/* invalidate this leaf item, if not exist on kds_hash */
+				if (!khitem)
+					lpp->lp_flags = LP_DEAD;
+			}
+		}
+	}
+	pthreadMutexUnlock(&dpu_gist_prep_mutex);
+}
+
 static void
 dpuServUnmapSessionBuffers(dpuClient *dclient)
 {
@@ -599,6 +1266,211 @@ dpuservHandleOpenSession(dpuClient *dclient, XpuCommand *xcmd)
 	return true;
 }
 
+/*
+ * DPU block cache
+ *
+ * It keeps the recently read file segments (DPU_CACHE_UNIT_SZ aligned) in
+ * the LRU order, up to the -c|--cache-size option. A segment is identified
+ * by the device/inode, mtime and size of the file, and its offset; so, any
+ * modification of the file makes the segments invisible, then they are
+ * evicted eventually.
+ * An entry is referenced by the reader during memcpy, and evicted entries
+ * are released when the last reference is gone.
+ */
+#define DPU_CACHE_UNIT_SZ		(128UL << 10)	/* multiple of PAGE_SIZE */
+#define DPU_CACHE_HASH_NSLOTS	8192
+
+typedef struct
+{
+	dev_t		st_dev;
+	ino_t		st_ino;
+	off_t		st_size;
+	int64_t		mtime_sec;
+	int64_t		mtime_nsec;
+	off_t		offset;
+} dpuCacheKey;
+
+typedef struct
+{
+	dlist_node	hash_chain;
+	dlist_node	lru_chain;
+	dpuCacheKey	key;
+	uint32_t	hash;
+	int			refcnt;
+	bool		is_cached;		/* linked to the hash-slot and LRU list */
+} dpuCacheEntry;
+
+/* data of the segment; page aligned for O_DIRECT */
+#define DPU_CACHE_ENTRY_DATA(entry)		((char *)(entry) + PAGE_SIZE)
+
+static pthread_mutex_t	dpu_cache_mutex;
+static dlist_head		dpu_cache_hash[DPU_CACHE_HASH_NSLOTS];
+static dlist_head		dpu_cache_lru;
+static size_t			dpu_cache_usage = 0;
+static size_t			dpu_cache_limit = 0;
+
+static void
+__dpuCacheSetupKey(dpuCacheKey *key, const struct stat *st_buf, off_t offset)
+{
+	memset(key, 0, sizeof(dpuCacheKey));
+	key->st_dev = st_buf->st_dev;
+	key->st_ino = st_buf->st_ino;
+	key->st_size = st_buf->st_size;
+	key->mtime_sec = st_buf->st_mtim.tv_sec;
+	key->mtime_nsec = st_buf->st_mtim.tv_nsec;
+	key->offset = offset;
+}
+
+static dpuCacheEntry *
+__dpuCacheLookup(const dpuCacheKey *key, uint32_t hash)
+{
+	dpuCacheEntry *entry;
+	dlist_iter	iter;
+
+	pthreadMutexLock(&dpu_cache_mutex);
+	dlist_foreach(iter, &dpu_cache_hash[hash % DPU_CACHE_HASH_NSLOTS])
+	{
+		entry = dlist_container(dpuCacheEntry, hash_chain, iter.cur);
+		if (entry->hash == hash &&
+			memcmp(&entry->key, key, sizeof(dpuCacheKey)) == 0)
+		{
+			entry->refcnt++;
+			dlist_delete(&entry->lru_chain);
+			dlist_push_head(&dpu_cache_lru, &entry->lru_chain);
+			pthreadMutexUnlock(&dpu_cache_mutex);
+			return entry;
+		}
+	}
+	pthreadMutexUnlock(&dpu_cache_mutex);
+	return NULL;
+}
+
+static void
+__dpuCacheInsert(dpuCacheEntry *entry)
+{
+	dlist_head *hslot = &dpu_cache_hash[entry->hash % DPU_CACHE_HASH_NSLOTS];
+	dlist_iter	iter;
+
+	pthreadMutexLock(&dpu_cache_mutex);
+	dlist_foreach(iter, hslot)
+	{
+		dpuCacheEntry *temp = dlist_container(dpuCacheEntry,
+											  hash_chain, iter.cur);
+		if (temp->hash == entry->hash &&
+			memcmp(&temp->key, &entry->key, sizeof(dpuCacheKey)) == 0)
+		{
+			/* someone already cached the same segment concurrently */
+			pthreadMutexUnlock(&dpu_cache_mutex);
+			return;
+		}
+	}
+	dlist_push_head(hslot, &entry->hash_chain);
+	dlist_push_head(&dpu_cache_lru, &entry->lru_chain);
+	entry->is_cached = true;
+	dpu_cache_usage += DPU_CACHE_UNIT_SZ;
+
+	/* evict the least recently used segments */
+	while (dpu_cache_usage > dpu_cache_limit &&
+		   !dlist_is_empty(&dpu_cache_lru))
+	{
+		dpuCacheEntry *victim = dlist_container(dpuCacheEntry, lru_chain,
+												dlist_pop_tail_node(&dpu_cache_lru));
+		dlist_delete(&victim->hash_chain);
+		victim->is_cached = false;
+		dpu_cache_usage -= DPU_CACHE_UNIT_SZ;
+		if (victim->refcnt == 0)
+			free(victim);
+	}
+	pthreadMutexUnlock(&dpu_cache_mutex);
+}
+
+static void
+__dpuCacheRelease(dpuCacheEntry *entry)
+{
+	pthreadMutexLock(&dpu_cache_mutex);
+	assert(entry->refcnt > 0);
+	if (--entry->refcnt == 0 && !entry->is_cached)
+		free(entry);
+	pthreadMutexUnlock(&dpu_cache_mutex);
+}
+
+/*
+ * __dpuservReadChunkCached
+ *
+ * It reads the range of the file segment by segment, using the block cache.
+ */
+static bool
+__dpuservReadChunkCached(dpuClient *dclient,
+						 dpuTaskExecState *dtes,
+						 int fdesc, const char *pathname,
+						 const struct stat *st_buf,
+						 char *dest, off_t offset, size_t length)
+{
+	while (length > 0)
+	{
+		off_t		base = TYPEALIGN_DOWN(DPU_CACHE_UNIT_SZ, offset);
+		size_t		shift = offset - base;
+		size_t		sz = Min(length, DPU_CACHE_UNIT_SZ - shift);
+		dpuCacheKey	key;
+		uint32_t	hash;
+		dpuCacheEntry *entry;
+
+		__dpuCacheSetupKey(&key, st_buf, base);
+		hash = pg_hash_any(&key, sizeof(dpuCacheKey));
+		entry = __dpuCacheLookup(&key, hash);
+		if (entry)
+			dtes->npages_cache_hit += sz / PAGE_SIZE;
+		else
+		{
+			char	   *data;
+			size_t		pos = 0;
+			ssize_t		nbytes;
+
+			if (posix_memalign((void **)&entry, PAGE_SIZE,
+							   PAGE_SIZE + DPU_CACHE_UNIT_SZ) != 0)
+			{
+				dpuClientElog(dclient, "out of memory: %m");
+				return false;
+			}
+			memset(entry, 0, sizeof(dpuCacheEntry));
+			memcpy(&entry->key, &key, sizeof(dpuCacheKey));
+			entry->hash = hash;
+			entry->refcnt = 1;
+			data = DPU_CACHE_ENTRY_DATA(entry);
+			while (pos < DPU_CACHE_UNIT_SZ)
+			{
+				nbytes = pread(fdesc, data + pos,
+							   DPU_CACHE_UNIT_SZ - pos, base + pos);
+				if (nbytes > 0)
+					pos += nbytes;
+				else if (nbytes == 0)
+				{
+					/* tail of the file */
+					memset(data + pos, 0, DPU_CACHE_UNIT_SZ - pos);
+					break;
+				}
+				else if (errno != EINTR)
+				{
+					dpuClientElog(dclient, "failed on pread('%s', %ld, %ld) = %ld: %m",
+								  pathname, DPU_CACHE_UNIT_SZ - pos,
+								  base + pos, nbytes);
+					free(entry);
+					return false;
+				}
+			}
+			dtes->npages_storage_read += PAGE_ALIGN(pos) / PAGE_SIZE;
+			__dpuCacheInsert(entry);
+		}
+		memcpy(dest, DPU_CACHE_ENTRY_DATA(entry) + shift, sz);
+		__dpuCacheRelease(entry);
+
+		dest   += sz;
+		offset += sz;
+		length -= sz;
+	}
+	return true;
+}
+
 /*
  * dpuservLoadKdsBlock
  *
@@ -606,6 +1478,7 @@ dpuservHandleOpenSession(dpuClient *dclient, XpuCommand *xcmd)
  */
 static kern_data_store *
 __dpuservLoadKdsCommon(dpuClient *dclient,
+					   dpuTaskExecState *dtes,
 					   const kern_data_store *kds_head,
 					   size_t preload_sz,
 					   const char *pathname,
@@ -616,6 +1489,8 @@ __dpuservLoadKdsCommon(dpuClient *dclient,
 	char	   *data;
 	char	   *end		__attribute__((unused));
 	int			fdesc;
+	struct stat	st_buf;
+	bool		use_cache = false;
 
 	fdesc = open(pathname, O_RDONLY | O_DIRECT | O_NOATIME);
 	if (fdesc < 0)
@@ -623,6 +1498,8 @@ __dpuservLoadKdsCommon(dpuClient *dclient,
 		dpuClientElog(dclient, "failed on open('%s'): %m", pathname);
 		return NULL;
 	}
+	if (dpu_cache_limit > 0 && fstat(fdesc, &st_buf) == 0)
+		use_cache = true;
 
 	data = malloc(kds_head->length + 2 * PAGE_SIZE);
 	if (!data)
@@ -655,6 +1532,18 @@ __dpuservLoadKdsCommon(dpuClient *dclient,
 			ssize_t		nbytes;
 
 			assert(dest + length <= end);
+			if (use_cache)
+			{
+				if (!__dpuservReadChunkCached(dclient, dtes, fdesc, pathname,
+											  &st_buf, dest, offset, length))
+				{
+					free(data);
+					close(fdesc);
+					return NULL;
+				}
+				continue;
+			}
+			dtes->npages_storage_read += ioc->nr_pages;
 			while (length > 0)
 			{
 				nbytes = pread(fdesc, dest, length, offset);
@@ -694,6 +1583,7 @@ __dpuservLoadKdsCommon(dpuClient *dclient,
 
 static kern_data_store *
 dpuservLoadKdsBlock(dpuClient *dclient,
+					dpuTaskExecState *dtes,
 					const kern_data_store *kds_head,
 					const char *pathname,
 					const strom_io_vector *kds_iovec,
@@ -702,6 +1592,7 @@ dpuservLoadKdsBlock(dpuClient *dclient,
 	Assert(kds_head->format == KDS_FORMAT_BLOCK &&
 		   kds_head->block_nloaded == 0);
 	return __dpuservLoadKdsCommon(dclient,
+								  dtes,
 								  kds_head,
 								  kds_head->block_offset,
 								  pathname,
@@ -711,6 +1602,7 @@ dpuservLoadKdsBlock(dpuClient *dclient,
 
 static kern_data_store *
 dpuservLoadKdsArrow(dpuClient *dclient,
+					dpuTaskExecState *dtes,
 					const kern_data_store *kds_head,
 					const char *pathname,
 					const strom_io_vector *kds_iovec,
@@ -718,6 +1610,7 @@ dpuservLoadKdsArrow(dpuClient *dclient,
 {
 	Assert(kds_head->format == KDS_FORMAT_ARROW);
 	return __dpuservLoadKdsCommon(dclient,
+								  dtes,
 								  kds_head,
 								  KDS_HEAD_LENGTH(kds_head),
 								  pathname,
@@ -1923,10 +2816,10 @@ __handleDpuTaskExecGroupByPreAgg(dpuClient *dclient,
  * ----------------------------------------------------------------
  */
 static bool
-__handleDpuTaskExecHashJoin(dpuClient *dclient,
-							dpuTaskExecState *dtes,
-							kern_context *kcxt,
-							int depth);
+__handleDpuTaskExecNextDepth(dpuClient *dclient,
+							 dpuTaskExecState *dtes,
+							 kern_context *kcxt,
+							 int depth);
 
 static bool
 __handleDpuTaskExecNestLoop(dpuClient *dclient,
@@ -1960,21 +2853,8 @@ __handleDpuTaskExecNestLoop(dpuClient *dclient,
 		assert(!XPU_DATUM_ISNULL(&status));
 		if (status.value > 0)
 		{
-			if (depth >= kmrels->num_rels)
-			{
-				if (!dtes->handleDpuTaskFinalDepth(dclient, dtes, kcxt))
-					return false;
-			}
-			else if (kmrels->chunks[depth].is_nestloop)
-			{
-				if (!__handleDpuTaskExecNestLoop(dclient, dtes, kcxt, depth+1))
-					return false;
-			}
-			else
-			{
-				if (!__handleDpuTaskExecHashJoin(dclient, dtes, kcxt, depth+1))
-					return false;
-			}
+			if (!__handleDpuTaskExecNextDepth(dclient, dtes, kcxt, depth+1))
+				return false;
 		}
 		if (status.value != 0)
 		{
@@ -1988,21 +2868,8 @@ __handleDpuTaskExecNestLoop(dpuClient *dclient,
 	{
 		ExecLoadVarsHeapTuple(kcxt, kexp_load_vars, depth,
 							  kds_heap, NULL);
-		if (depth >= kmrels->num_rels)
-		{
-			if (!dtes->handleDpuTaskFinalDepth(dclient, dtes, kcxt))
-				return false;
-		}
-		else if (kmrels->chunks[depth].is_nestloop)
-		{
-			if (!__handleDpuTaskExecNestLoop(dclient, dtes, kcxt, depth+1))
-				return false;
-		}
-		else
-		{
-			if (!__handleDpuTaskExecHashJoin(dclient, dtes, kcxt, depth+1))
-				return false;
-		}
+		if (!__handleDpuTaskExecNextDepth(dclient, dtes, kcxt, depth+1))
+			return false;
 	}
 	return true;
 }
@@ -2044,21 +2911,8 @@ __handleDpuTaskExecHashJoin(dpuClient *dclient,
 		assert(!XPU_DATUM_ISNULL(&status));
 		if (status.value > 0)
 		{
-			if (depth >= kmrels->num_rels)
-			{
-				if (!dtes->handleDpuTaskFinalDepth(dclient, dtes, kcxt))
-					return false;
-			}
-			else if (kmrels->chunks[depth].is_nestloop)
-			{
-				if (!__handleDpuTaskExecNestLoop(dclient, dtes, kcxt, depth+1))
-					return false;
-			}
-			else
-			{
-				if (!__handleDpuTaskExecHashJoin(dclient, dtes, kcxt, depth+1))
-					return false;
-			}
+			if (!__handleDpuTaskExecNextDepth(dclient, dtes, kcxt, depth+1))
+				return false;
 		}
 		if (status.value != 0)
 		{
@@ -2072,29 +2926,124 @@ __handleDpuTaskExecHashJoin(dpuClient *dclient,
 	{
 		ExecLoadVarsHeapTuple(kcxt, kexp_load_vars, depth,
 							  kds_hash, NULL);
-		if (depth >= kmrels->num_rels)
+		if (!__handleDpuTaskExecNextDepth(dclient, dtes, kcxt, depth+1))
+			return false;
+	}
+	return true;
+}
+
+/*
+ * GiST-INDEX-JOIN
+ *
+ * It walks on the GiST index pages that are shipped with the inner buffer,
+ * using ExecGiSTIndexGetNext() as GPU doing, then runs the join-quals on
+ * the inner tuples picked up by the index-quals.
+ */
+static bool
+__handleDpuTaskExecGiSTJoin(dpuClient *dclient,
+							dpuTaskExecState *dtes,
+							kern_context *kcxt,
+							int depth)
+{
+	kern_session_info  *session = dclient->session;
+	kern_multirels	   *kmrels = dclient->kmrels;
+	kern_data_store	   *kds_hash = KERN_MULTIRELS_INNER_KDS(kmrels, depth-1);
+	kern_data_store	   *kds_gist = KERN_MULTIRELS_GIST_INDEX(kmrels, depth-1);
+	bool			   *oj_map = KERN_MULTIRELS_OUTER_JOIN_MAP(kmrels, depth-1);
+	kern_expression	   *kexp_load_vars = SESSION_KEXP_JOIN_LOAD_VARS(session,depth-1);
+	kern_expression	   *kexp_join_quals = SESSION_KEXP_JOIN_QUALS(session,depth-1);
+	kern_expression	   *kexp_gist = SESSION_KEXP_GIST_EVALS(session,depth-1);
+	uint32_t			slot_id;
+	uint32_t			l_state = 0;
+	xpu_int4_t			status;
+	bool				matched = false;
+
+	assert(kds_hash && kds_hash->format == KDS_FORMAT_HASH &&
+		   kds_gist && kds_gist->format == KDS_FORMAT_BLOCK &&
+		   kexp_gist && kexp_gist->opcode == FuncOpCode__GiSTEval);
+	slot_id = kexp_gist->u.gist.htup_slot_id;
+	for (;;)
+	{
+		const xpu_internal_t *ivar;
+		HeapTupleHeaderData *htup;
+		kern_hashitem  *khitem;
+
+		l_state = ExecGiSTIndexGetNext(kcxt,
+									   kds_hash,
+									   kds_gist,
+									   kexp_gist,
+									   l_state);
+		if (l_state == UINT_MAX)
 		{
-			if (!dtes->handleDpuTaskFinalDepth(dclient, dtes, kcxt))
+			if (kcxt->errcode != ERRCODE_STROM_SUCCESS)
 				return false;
+			break;
 		}
-		else if (kmrels->chunks[depth].is_nestloop)
+		dtes->stats[depth-1].nitems_gist++;
+		/* fetch the inner tuple picked up by the index */
+		ivar = (const xpu_internal_t *)kcxt->kvars_slot[slot_id];
+		htup = (HeapTupleHeaderData *)ivar->value;
+		assert((char *)htup >= (char *)kds_hash &&
+			   (char *)htup <  (char *)kds_hash + kds_hash->length);
+		khitem = (kern_hashitem *)((char *)htup - offsetof(kern_hashitem, t.htup));
+		ExecLoadVarsHeapTuple(kcxt, kexp_load_vars, depth,
+							  kds_hash, htup);
+		kcxt_reset(kcxt);
+		if (!EXEC_KERN_EXPRESSION(kcxt, kexp_join_quals, &status))
+			return false;
+		assert(!XPU_DATUM_ISNULL(&status));
+		if (status.value > 0)
 		{
-			if (!__handleDpuTaskExecNestLoop(dclient, dtes, kcxt, depth+1))
+			if (!__handleDpuTaskExecNextDepth(dclient, dtes, kcxt, depth+1))
 				return false;
 		}
-		else
+		if (status.value != 0)
 		{
-			if (!__handleDpuTaskExecHashJoin(dclient, dtes, kcxt, depth+1))
-				return false;
+			matched = true;
+			if (oj_map)
+				oj_map[khitem->t.rowid] = true;
 		}
 	}
+	/* LEFT OUTER if needed */
+	if (kmrels->chunks[depth-1].left_outer && !matched)
+	{
+		ExecLoadVarsHeapTuple(kcxt, kexp_load_vars, depth,
+							  kds_hash, NULL);
+		if (!__handleDpuTaskExecNextDepth(dclient, dtes, kcxt, depth+1))
+			return false;
+	}
 	return true;
 }
 
+/*
+ * __handleDpuTaskExecNextDepth
+ *
+ * It runs the join at the 'depth', or the final-depth handler if all the
+ * inner relations are already joined.
+ */
+static bool
+__handleDpuTaskExecNextDepth(dpuClient *dclient,
+							 dpuTaskExecState *dtes,
+							 kern_context *kcxt,
+							 int depth)
+{
+	kern_multirels	   *kmrels = dclient->kmrels;
+
+	if (!kmrels || depth > kmrels->num_rels)
+		return dtes->handleDpuTaskFinalDepth(dclient, dtes, kcxt);
+	if (kmrels->chunks[depth-1].is_nestloop)
+		return __handleDpuTaskExecNestLoop(dclient, dtes, kcxt, depth);
+	if (kmrels->chunks[depth-1].gist_offset != 0)
+		return __handleDpuTaskExecGiSTJoin(dclient, dtes, kcxt, depth);
+	return __handleDpuTaskExecHashJoin(dclient, dtes, kcxt, depth);
+}
+
 static bool
 __handleDpuScanExecBlock(dpuClient *dclient,
 						 dpuTaskExecState *dtes,
-						 kern_data_store *kds_src)
+						 kern_data_store *kds_src,
+						 uint32_t block_start,
+						 uint32_t block_end)
 {
 	kern_session_info  *session = dclient->session;
 	kern_multirels	   *kmrels = dclient->kmrels;
@@ -2109,7 +3058,8 @@ __handleDpuScanExecBlock(dpuClient *dclient,
 	INIT_KERNEL_CONTEXT(kcxt, session);
 	kcxt->kvars_slot = (kern_variable *)alloca(kcxt->kvars_nbytes);
 	kcxt->kvars_class = (int *)(kcxt->kvars_slot + kcxt->kvars_nslots);
-	for (block_index = 0; block_index < kds_src->nitems; block_index++)
+	assert(block_start <= block_end && block_end <= kds_src->nitems);
+	for (block_index = block_start; block_index < block_end; block_index++)
 	{
 		PageHeaderData *page = KDS_BLOCK_PGPAGE(kds_src, block_index);
 		uint32_t		lp_nitems = PageGetMaxOffsetNumber(page);
@@ -2132,23 +3082,8 @@ __handleDpuScanExecBlock(dpuClient *dclient,
 									 htup))
 			{
 				dtes->nitems_in++;
-				if (!kmrels)
-				{
-					if (!dtes->handleDpuTaskFinalDepth(dclient, dtes, kcxt))
-						return false;
-				}
-				else if (kmrels->chunks[0].is_nestloop)
-				{
-					/* NEST-LOOP */
-					if (!__handleDpuTaskExecNestLoop(dclient, dtes, kcxt, 1))
-						return false;
-				}
-				else
-				{
-					/* HASH-JOIN */
-					if (!__handleDpuTaskExecHashJoin(dclient, dtes, kcxt, 1))
-						return false;
-				}
+				if (!__handleDpuTaskExecNextDepth(dclient, dtes, kcxt, 1))
+					return false;
 			}
 			else if (kcxt->errcode != ERRCODE_STROM_SUCCESS)
 			{
@@ -2165,10 +3100,605 @@ __handleDpuScanExecBlock(dpuClient *dclient,
 	return true;
 }
 
+/*
+ * Vectorized pre-filter of the scan quals
+ *
+ * The kern_expression interpreter evaluates the scan quals row-by-row.
+ * It is flexible, but too expensive to filter out the rows by simple
+ * predicates on the Arm cores. So, we pick up the conjuncts of the form
+ * <fixed-width column> <op> <constant> from the scan quals, then evaluate
+ * them on the Arrow values array in batch, using NEON intrinsics if any.
+ * When dpuserv runs on the x86_64 host as a CPU-only xPU service (no GPU
+ * installed, like a read replica), AVX2 or AVX-512 kernels are chosen at
+ * the startup time according to the CPU capability.
+ * Rows rejected by the pre-filter never match the scan quals, and the
+ * survivors are evaluated by the interpreter as usual; so it is no matter
+ * if a qual is not supported by the pre-filter.
+ */
+#define DPU_VEC_BATCH_NROWS		2048
+#define DPU_VEC_MAX_QUALS		16
+
+typedef enum
+{
+	DPU_VEC_TYPE__INT16,
+	DPU_VEC_TYPE__INT32,
+	DPU_VEC_TYPE__INT64,
+	DPU_VEC_TYPE__FLOAT32,
+	DPU_VEC_TYPE__FLOAT64,
+} dpuVecType;
+
+typedef enum
+{
+	DPU_VEC_OP__EQ,
+	DPU_VEC_OP__NE,
+	DPU_VEC_OP__LT,
+	DPU_VEC_OP__LE,
+	DPU_VEC_OP__GT,
+	DPU_VEC_OP__GE,
+} dpuVecOp;
+
+typedef struct
+{
+	const kern_colmeta *cmeta;
+	dpuVecType	vtype;
+	dpuVecOp	vop;
+	union {
+		int64_t	ival;
+		double	fval;
+	} c;
+} dpuVecQual;
+
+static bool
+__lookupDpuVecOperator(FuncOpCode opcode, dpuVecType *p_vtype, dpuVecOp *p_vop)
+{
+	switch (opcode)
+	{
+#define __DPU_VEC_OPERATOR(NAME,VTYPE,OP)				\
+		case FuncOpCode__##NAME:						\
+			*p_vtype = DPU_VEC_TYPE__##VTYPE;			\
+			*p_vop   = DPU_VEC_OP__##OP;				\
+			return true
+#define __DPU_VEC_OPERATORS(PREFIX,VTYPE)				\
+		__DPU_VEC_OPERATOR(PREFIX##eq, VTYPE, EQ);		\
+		__DPU_VEC_OPERATOR(PREFIX##ne, VTYPE, NE);		\
+		__DPU_VEC_OPERATOR(PREFIX##lt, VTYPE, LT);		\
+		__DPU_VEC_OPERATOR(PREFIX##le, VTYPE, LE);		\
+		__DPU_VEC_OPERATOR(PREFIX##gt, VTYPE, GT);		\
+		__DPU_VEC_OPERATOR(PREFIX##ge, VTYPE, GE)
+		__DPU_VEC_OPERATORS(int2,   INT16);
+		__DPU_VEC_OPERATORS(int4,   INT32);
+		__DPU_VEC_OPERATORS(int8,   INT64);
+		__DPU_VEC_OPERATORS(float4, FLOAT32);
+		__DPU_VEC_OPERATORS(float8, FLOAT64);
+#undef __DPU_VEC_OPERATORS
+#undef __DPU_VEC_OPERATOR
+		default:
+			break;
+	}
+	return false;
+}
+
+static bool
+__setupDpuVecQualOne(const kern_expression *kexp,
+					 const kern_expression *kexp_load_vars,
+					 const kern_data_store *kds,
+					 dpuVecQual *vqual)
+{
+	const kern_expression *karg1;
+	const kern_expression *karg2;
+	const kern_colmeta *cmeta = NULL;
+	const char *cval;
+	dpuVecType	vtype;
+	dpuVecOp	vop;
+	int			unitsz;
+
+	if (kexp->nr_args != 2 ||
+		!__lookupDpuVecOperator(kexp->opcode, &vtype, &vop))
+		return false;
+	karg1 = KEXP_FIRST_ARG(kexp);
+	karg2 = KEXP_NEXT_ARG(karg1);
+	if (karg1->opcode == FuncOpCode__ConstExpr &&
+		karg2->opcode == FuncOpCode__VarExpr)
+	{
+		/* CONST <op> VAR, then commute the operator */
+		const kern_expression *temp = karg1;
+
+		karg1 = karg2;
+		karg2 = temp;
+		switch (vop)
+		{
+			case DPU_VEC_OP__LT: vop = DPU_VEC_OP__GT; break;
+			case DPU_VEC_OP__LE: vop = DPU_VEC_OP__GE; break;
+			case DPU_VEC_OP__GT: vop = DPU_VEC_OP__LT; break;
+			case DPU_VEC_OP__GE: vop = DPU_VEC_OP__LE; break;
+			default: break;
+		}
+	}
+	if (karg1->opcode != FuncOpCode__VarExpr ||
+		karg2->opcode != FuncOpCode__ConstExpr ||
+		karg2->u.c.const_isnull)
+		return false;
+	/* lookup the source column of the variable */
+	for (int i=0; i < kexp_load_vars->u.load.nitems; i++)
+	{
+		const kern_varload_desc *vl_desc = &kexp_load_vars->u.load.desc[i];
+
+		if (vl_desc->vl_slot_id == karg1->u.v.var_slot_id)
+		{
+			if (vl_desc->vl_resno > 0 && vl_desc->vl_resno <= kds->ncols)
+				cmeta = &kds->colmeta[vl_desc->vl_resno - 1];
+			break;
+		}
+	}
+	if (!cmeta || cmeta->values_offset == 0 || cmeta->extra_offset != 0)
+		return false;
+	/* only plain values array of the Arrow fixed-width types */
+	cval = karg2->u.c.const_value;
+	switch (vtype)
+	{
+		case DPU_VEC_TYPE__INT16:
+		case DPU_VEC_TYPE__INT32:
+		case DPU_VEC_TYPE__INT64:
+			unitsz = (vtype == DPU_VEC_TYPE__INT16 ? sizeof(int16_t) :
+					  vtype == DPU_VEC_TYPE__INT32 ? sizeof(int32_t) : sizeof(int64_t));
+			if (cmeta->attopts.tag != ArrowType__Int ||
+				!cmeta->attopts.integer.is_signed ||
+				cmeta->attopts.integer.bitWidth != 8 * unitsz)
+				return false;
+			vqual->c.ival = (vtype == DPU_VEC_TYPE__INT16 ? *((const int16_t *)cval) :
+							 vtype == DPU_VEC_TYPE__INT32 ? *((const int32_t *)cval) :
+							 *((const int64_t *)cval));
+			break;
+		case DPU_VEC_TYPE__FLOAT32:
+		case DPU_VEC_TYPE__FLOAT64:
+			unitsz = (vtype == DPU_VEC_TYPE__FLOAT32 ? sizeof(float) : sizeof(double));
+			if (cmeta->attopts.tag != ArrowType__FloatingPoint ||
+				cmeta->attopts.floating_point.precision !=
+				(vtype == DPU_VEC_TYPE__FLOAT32
+				 ? ArrowPrecision__Single
+				 : ArrowPrecision__Double))
+				return false;
+			vqual->c.fval = (vtype == DPU_VEC_TYPE__FLOAT32
+							 ? *((const float *)cval)
+							 : *((const double *)cval));
+			/* PostgreSQL's NaN semantics are not IEEE754's, skip it */
+			if (isnan(vqual->c.fval))
+				return false;
+			break;
+		default:
+			return false;
+	}
+	if ((uint64_t)unitsz * kds->nitems > __kds_unpack(cmeta->values_length))
+		return false;
+	vqual->cmeta = cmeta;
+	vqual->vtype = vtype;
+	vqual->vop   = vop;
+	return true;
+}
+
+static int
+__setupDpuVecQuals(const kern_expression *kexp_scan_quals,
+				   const kern_expression *kexp_load_vars,
+				   const kern_data_store *kds,
+				   dpuVecQual *vquals)
+{
+	const kern_expression *karg;
+	int		nvquals = 0;
+
+	if (!kexp_scan_quals || !kexp_load_vars)
+		return 0;
+	if (kexp_scan_quals->opcode != FuncOpCode__BoolExpr_And)
+		return (__setupDpuVecQualOne(kexp_scan_quals,
+									 kexp_load_vars,
+									 kds, vquals) ? 1 : 0);
+	karg = KEXP_FIRST_ARG(kexp_scan_quals);
+	for (int i=0; i < kexp_scan_quals->nr_args &&
+			 nvquals < DPU_VEC_MAX_QUALS; i++, karg = KEXP_NEXT_ARG(karg))
+	{
+		if (__setupDpuVecQualOne(karg, kexp_load_vars, kds, &vquals[nvquals]))
+			nvquals++;
+	}
+	return nvquals;
+}
+
+/*
+ * generic (auto-vectorizable) comparison loops
+ */
+#define __DPU_VEC_COMPARE_LOOP(TYPE,EXPR)						\
+	do {														\
+		for (uint32_t i=start; i < nrows; i++)					\
+		{														\
+			TYPE	v = values[i];								\
+			mask[i] &= (EXPR);									\
+		}														\
+	} while(0)
+
+#define __DPU_VEC_COMPARE_TEMPLATE(NAME,TYPE,NANCHECK)				\
+static void															\
+__dpuVecCompare_##NAME(const TYPE *values, TYPE c, dpuVecOp vop,	\
+					   uint8_t *mask, uint32_t start, uint32_t nrows) \
+{																	\
+	switch (vop)													\
+	{																\
+		case DPU_VEC_OP__EQ:										\
+			__DPU_VEC_COMPARE_LOOP(TYPE, (v == c) | NANCHECK(v));	\
+			break;													\
+		case DPU_VEC_OP__NE:										\
+			__DPU_VEC_COMPARE_LOOP(TYPE, (v != c) | NANCHECK(v));	\
+			break;													\
+		case DPU_VEC_OP__LT:										\
+			__DPU_VEC_COMPARE_LOOP(TYPE, (v <  c) | NANCHECK(v));	\
+			break;													\
+		case DPU_VEC_OP__LE:										\
+			__DPU_VEC_COMPARE_LOOP(TYPE, (v <= c) | NANCHECK(v));	\
+			break;													\
+		case DPU_VEC_OP__GT:										\
+			__DPU_VEC_COMPARE_LOOP(TYPE, (v >  c) | NANCHECK(v));	\
+			break;													\
+		case DPU_VEC_OP__GE:										\
+			__DPU_VEC_COMPARE_LOOP(TYPE, (v >= c) | NANCHECK(v));	\
+			break;													\
+	}																\
+}
+/* NaN is not decidable by the IEEE754 comparison, so leave it */
+#define __DPU_VEC_NO_NANCHECK(v)		0
+#define __DPU_VEC_NANCHECK(v)			((v) != (v))
+__DPU_VEC_COMPARE_TEMPLATE(int16, int16_t, __DPU_VEC_NO_NANCHECK)
+__DPU_VEC_COMPARE_TEMPLATE(int32, int32_t, __DPU_VEC_NO_NANCHECK)
+__DPU_VEC_COMPARE_TEMPLATE(int64, int64_t, __DPU_VEC_NO_NANCHECK)
+__DPU_VEC_COMPARE_TEMPLATE(float32, float, __DPU_VEC_NANCHECK)
+__DPU_VEC_COMPARE_TEMPLATE(float64, double, __DPU_VEC_NANCHECK)
+
+#if defined(__ARM_NEON)
+/*
+ * NEON version for 4x 32bit-lanes; the most usual width of the columns
+ */
+static inline void
+__dpuVecStoreMask4(uint8_t *mask, uint32x4_t r)
+{
+	uint16x4_t	r16 = vmovn_u32(r);
+	uint8x8_t	r8 = vmovn_u16(vcombine_u16(r16, r16));
+	uint32_t	bits = vget_lane_u32(vreinterpret_u32_u8(r8), 0) & 0x01010101U;
+	uint32_t	curr;
+
+	memcpy(&curr, mask, sizeof(uint32_t));
+	curr &= bits;
+	memcpy(mask, &curr, sizeof(uint32_t));
+}
+
+static uint32_t
+__dpuVecCompareNeon_int32(const int32_t *values, int32_t c, dpuVecOp vop,
+						  uint8_t *mask, uint32_t start, uint32_t nrows)
+{
+	int32x4_t	cv = vdupq_n_s32(c);
+	uint32_t	i;
+
+	for (i=start; i + 4 <= nrows; i += 4)
+	{
+		int32x4_t	v = vld1q_s32(values + i);
+		uint32x4_t	r;
+
+		switch (vop)
+		{
+			case DPU_VEC_OP__EQ: r = vceqq_s32(v, cv); break;
+			case DPU_VEC_OP__NE: r = vmvnq_u32(vceqq_s32(v, cv)); break;
+			case DPU_VEC_OP__LT: r = vcltq_s32(v, cv); break;
+			case DPU_VEC_OP__LE: r = vcleq_s32(v, cv); break;
+			case DPU_VEC_OP__GT: r = vcgtq_s32(v, cv); break;
+			default:             r = vcgeq_s32(v, cv); break;
+		}
+		__dpuVecStoreMask4(mask + i, r);
+	}
+	return i;
+}
+
+static uint32_t
+__dpuVecCompareNeon_float32(const float *values, float c, dpuVecOp vop,
+							uint8_t *mask, uint32_t start, uint32_t nrows)
+{
+	float32x4_t	cv = vdupq_n_f32(c);
+	uint32_t	i;
+
+	for (i=start; i + 4 <= nrows; i += 4)
+	{
+		float32x4_t	v = vld1q_f32(values + i);
+		uint32x4_t	r;
+
+		switch (vop)
+		{
+			case DPU_VEC_OP__EQ: r = vceqq_f32(v, cv); break;
+			case DPU_VEC_OP__NE: r = vmvnq_u32(vceqq_f32(v, cv)); break;
+			case DPU_VEC_OP__LT: r = vcltq_f32(v, cv); break;
+			case DPU_VEC_OP__LE: r = vcleq_f32(v, cv); break;
+			case DPU_VEC_OP__GT: r = vcgtq_f32(v, cv); break;
+			default:             r = vcgeq_f32(v, cv); break;
+		}
+		/* NaN lanes are not decidable here */
+		r = vorrq_u32(r, vmvnq_u32(vceqq_f32(v, v)));
+		__dpuVecStoreMask4(mask + i, r);
+	}
+	return i;
+}
+#endif	/* __ARM_NEON */
+
+#if defined(__x86_64__)
+/*
+ * AVX2 / AVX-512 version for 8x / 16x 32bit-lanes
+ *
+ * These kernels are built with the function-level target attribute, so
+ * the binary still runs on the older CPUs; dpuVecSetupSimdKernels() picks
+ * up the best ones at the startup time.
+ */
+typedef uint32_t (*dpuVecSimdInt32Func)(const int32_t *values, int32_t c,
+										dpuVecOp vop, uint8_t *mask,
+										uint32_t start, uint32_t nrows);
+typedef uint32_t (*dpuVecSimdFloat32Func)(const float *values, float c,
+										  dpuVecOp vop, uint8_t *mask,
+										  uint32_t start, uint32_t nrows);
+static dpuVecSimdInt32Func		__dpuVecCompareSimd_int32 = NULL;
+static dpuVecSimdFloat32Func	__dpuVecCompareSimd_float32 = NULL;
+
+__attribute__((target("avx2")))
+static inline void
+__dpuVecStoreMask8(uint8_t *mask, __m256i r)
+{
+	__m128i		r16 = _mm_packs_epi32(_mm256_castsi256_si128(r),
+									  _mm256_extracti128_si256(r, 1));
+	__m128i		r8 = _mm_and_si128(_mm_packs_epi16(r16, r16),
+								   _mm_set1_epi8(1));
+	uint64_t	bits = (uint64_t)_mm_cvtsi128_si64(r8);
+	uint64_t	curr;
+
+	memcpy(&curr, mask, sizeof(uint64_t));
+	curr &= bits;
+	memcpy(mask, &curr, sizeof(uint64_t));
+}
+
+__attribute__((target("avx2")))
+static uint32_t
+__dpuVecCompareAvx2_int32(const int32_t *values, int32_t c, dpuVecOp vop,
+						  uint8_t *mask, uint32_t start, uint32_t nrows)
+{
+	__m256i		cv = _mm256_set1_epi32(c);
+	__m256i		ones = _mm256_set1_epi32(-1);
+	uint32_t	i;
+
+	for (i=start; i + 8 <= nrows; i += 8)
+	{
+		__m256i		v = _mm256_loadu_si256((const __m256i *)(values + i));
+		__m256i		r;
+
+		switch (vop)
+		{
+			case DPU_VEC_OP__EQ:
+				r = _mm256_cmpeq_epi32(v, cv);
+				break;
+			case DPU_VEC_OP__NE:
+				r = _mm256_xor_si256(_mm256_cmpeq_epi32(v, cv), ones);
+				break;
+			case DPU_VEC_OP__LT:
+				r = _mm256_cmpgt_epi32(cv, v);
+				break;
+			case DPU_VEC_OP__LE:
+				r = _mm256_xor_si256(_mm256_cmpgt_epi32(v, cv), ones);
+				break;
+			case DPU_VEC_OP__GT:
+				r = _mm256_cmpgt_epi32(v, cv);
+				break;
+			default:
+				r = _mm256_xor_si256(_mm256_cmpgt_epi32(cv, v), ones);
+				break;
+		}
+		__dpuVecStoreMask8(mask + i, r);
+	}
+	return i;
+}
+
+__attribute__((target("avx2")))
+static uint32_t
+__dpuVecCompareAvx2_float32(const float *values, float c, dpuVecOp vop,
+							uint8_t *mask, uint32_t start, uint32_t nrows)
+{
+	__m256		cv = _mm256_set1_ps(c);
+	uint32_t	i;
+
+	for (i=start; i + 8 <= nrows; i += 8)
+	{
+		__m256		v = _mm256_loadu_ps(values + i);
+		__m256		r;
+
+		/* unordered predicates keep the NaN lanes, as the generic loop */
+		switch (vop)
+		{
+			case DPU_VEC_OP__EQ: r = _mm256_cmp_ps(v, cv, _CMP_EQ_UQ);  break;
+			case DPU_VEC_OP__NE: r = _mm256_cmp_ps(v, cv, _CMP_NEQ_UQ); break;
+			case DPU_VEC_OP__LT: r = _mm256_cmp_ps(v, cv, _CMP_NGE_UQ); break;
+			case DPU_VEC_OP__LE: r = _mm256_cmp_ps(v, cv, _CMP_NGT_UQ); break;
+			case DPU_VEC_OP__GT: r = _mm256_cmp_ps(v, cv, _CMP_NLE_UQ); break;
+			default:             r = _mm256_cmp_ps(v, cv, _CMP_NLT_UQ); break;
+		}
+		__dpuVecStoreMask8(mask + i, _mm256_castps_si256(r));
+	}
+	return i;
+}
+
+__attribute__((target("avx512f")))
+static inline void
+__dpuVecStoreMask16(uint8_t *mask, __mmask16 k)
+{
+	__m128i		bits = _mm512_cvtepi32_epi8(_mm512_maskz_mov_epi32(k, _mm512_set1_epi32(1)));
+	__m128i		curr = _mm_loadu_si128((const __m128i *)mask);
+
+	_mm_storeu_si128((__m128i *)mask, _mm_and_si128(curr, bits));
+}
+
+__attribute__((target("avx512f")))
+static uint32_t
+__dpuVecCompareAvx512_int32(const int32_t *values, int32_t c, dpuVecOp vop,
+							uint8_t *mask, uint32_t start, uint32_t nrows)
+{
+	__m512i		cv = _mm512_set1_epi32(c);
+	uint32_t	i;
+
+	for (i=start; i + 16 <= nrows; i += 16)
+	{
+		__m512i		v = _mm512_loadu_si512((const void *)(values + i));
+		__mmask16	k;
+
+		switch (vop)
+		{
+			case DPU_VEC_OP__EQ: k = _mm512_cmp_epi32_mask(v, cv, _MM_CMPINT_EQ);  break;
+			case DPU_VEC_OP__NE: k = _mm512_cmp_epi32_mask(v, cv, _MM_CMPINT_NE);  break;
+			case DPU_VEC_OP__LT: k = _mm512_cmp_epi32_mask(v, cv, _MM_CMPINT_LT);  break;
+			case DPU_VEC_OP__LE: k = _mm512_cmp_epi32_mask(v, cv, _MM_CMPINT_LE);  break;
+			case DPU_VEC_OP__GT: k = _mm512_cmp_epi32_mask(v, cv, _MM_CMPINT_NLE); break;
+			default:             k = _mm512_cmp_epi32_mask(v, cv, _MM_CMPINT_NLT); break;
+		}
+		__dpuVecStoreMask16(mask + i, k);
+	}
+	return i;
+}
+
+__attribute__((target("avx512f")))
+static uint32_t
+__dpuVecCompareAvx512_float32(const float *values, float c, dpuVecOp vop,
+							  uint8_t *mask, uint32_t start, uint32_t nrows)
+{
+	__m512		cv = _mm512_set1_ps(c);
+	uint32_t	i;
+
+	for (i=start; i + 16 <= nrows; i += 16)
+	{
+		__m512		v = _mm512_loadu_ps(values + i);
+		__mmask16	k;
+
+		switch (vop)
+		{
+			case DPU_VEC_OP__EQ: k = _mm512_cmp_ps_mask(v, cv, _CMP_EQ_UQ);  break;
+			case DPU_VEC_OP__NE: k = _mm512_cmp_ps_mask(v, cv, _CMP_NEQ_UQ); break;
+			case DPU_VEC_OP__LT: k = _mm512_cmp_ps_mask(v, cv, _CMP_NGE_UQ); break;
+			case DPU_VEC_OP__LE: k = _mm512_cmp_ps_mask(v, cv, _CMP_NGT_UQ); break;
+			case DPU_VEC_OP__GT: k = _mm512_cmp_ps_mask(v, cv, _CMP_NLE_UQ); break;
+			default:             k = _mm512_cmp_ps_mask(v, cv, _CMP_NLT_UQ); break;
+		}
+		__dpuVecStoreMask16(mask + i, k);
+	}
+	return i;
+}
+#endif	/* __x86_64__ */
+
+/*
+ * dpuVecSetupSimdKernels
+ */
+static void
+dpuVecSetupSimdKernels(void)
+{
+	const char *simd_name = "generic";
+#if defined(__ARM_NEON)
+	simd_name = "NEON";
+#elif defined(__x86_64__)
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx512f"))
+	{
+		__dpuVecCompareSimd_int32   = __dpuVecCompareAvx512_int32;
+		__dpuVecCompareSimd_float32 = __dpuVecCompareAvx512_float32;
+		simd_name = "AVX-512";
+	}
+	else if (__builtin_cpu_supports("avx2"))
+	{
+		__dpuVecCompareSimd_int32   = __dpuVecCompareAvx2_int32;
+		__dpuVecCompareSimd_float32 = __dpuVecCompareAvx2_float32;
+		simd_name = "AVX2";
+	}
+#endif
+	if (verbose)
+		fprintf(stderr, "[info] vectorized pre-filter uses %s kernels\n",
+				simd_name);
+}
+
+/*
+ * __dpuVecEvalQuals - evaluates the pre-filter on rows [base, base+nrows)
+ */
+static void
+__dpuVecEvalQuals(const kern_data_store *kds,
+				  const dpuVecQual *vquals, int nvquals,
+				  uint32_t base, uint32_t nrows, uint8_t *mask)
+{
+	memset(mask, 1, nrows);
+	for (int k=0; k < nvquals; k++)
+	{
+		const dpuVecQual   *vqual = &vquals[k];
+		const kern_colmeta *cmeta = vqual->cmeta;
+		const char		   *values = ((const char *)kds +
+									  __kds_unpack(cmeta->values_offset));
+		uint32_t			start = 0;
+
+		switch (vqual->vtype)
+		{
+			case DPU_VEC_TYPE__INT16:
+				__dpuVecCompare_int16((const int16_t *)values + base,
+									  (int16_t)vqual->c.ival,
+									  vqual->vop, mask, 0, nrows);
+				break;
+			case DPU_VEC_TYPE__INT32:
+#if defined(__ARM_NEON)
+				start = __dpuVecCompareNeon_int32((const int32_t *)values + base,
+												  (int32_t)vqual->c.ival,
+												  vqual->vop, mask, 0, nrows);
+#elif defined(__x86_64__)
+				if (__dpuVecCompareSimd_int32)
+					start = __dpuVecCompareSimd_int32((const int32_t *)values + base,
+													  (int32_t)vqual->c.ival,
+													  vqual->vop, mask, 0, nrows);
+#endif
+				__dpuVecCompare_int32((const int32_t *)values + base,
+									  (int32_t)vqual->c.ival,
+									  vqual->vop, mask, start, nrows);
+				break;
+			case DPU_VEC_TYPE__INT64:
+				__dpuVecCompare_int64((const int64_t *)values + base,
+									  vqual->c.ival,
+									  vqual->vop, mask, 0, nrows);
+				break;
+			case DPU_VEC_TYPE__FLOAT32:
+#if defined(__ARM_NEON)
+				start = __dpuVecCompareNeon_float32((const float *)values + base,
+													(float)vqual->c.fval,
+													vqual->vop, mask, 0, nrows);
+#elif defined(__x86_64__)
+				if (__dpuVecCompareSimd_float32)
+					start = __dpuVecCompareSimd_float32((const float *)values + base,
+														(float)vqual->c.fval,
+														vqual->vop, mask, 0, nrows);
+#endif
+				__dpuVecCompare_float32((const float *)values + base,
+										(float)vqual->c.fval,
+										vqual->vop, mask, start, nrows);
+				break;
+			case DPU_VEC_TYPE__FLOAT64:
+				__dpuVecCompare_float64((const double *)values + base,
+										vqual->c.fval,
+										vqual->vop, mask, 0, nrows);
+				break;
+		}
+		/* NULL never satisfies the comparison */
+		if (cmeta->nullmap_offset)
+		{
+			for (uint32_t i=0; i < nrows; i++)
+			{
+				if (mask[i] && KDS_ARROW_CHECK_ISNULL(kds, cmeta, base + i))
+					mask[i] = 0;
+			}
+		}
+	}
+}
+
 static bool
 __handleDpuScanExecArrow(dpuClient *dclient,
 						 dpuTaskExecState *dtes,
-						 kern_data_store *kds_src)
+						 kern_data_store *kds_src,
+						 uint32_t row_start,
+						 uint32_t row_end)
 {
 	kern_session_info  *session = dclient->session;
 	kern_multirels	   *kmrels = dclient->kmrels;
@@ -2176,6 +3706,9 @@ __handleDpuScanExecArrow(dpuClient *dclient,
 	kern_expression	   *kexp_scan_quals = SESSION_KEXP_SCAN_QUALS(session);
 	kern_context	   *kcxt;
 	uint32_t			kds_index;
+	dpuVecQual			vquals[DPU_VEC_MAX_QUALS];
+	int					nvquals;
+	uint8_t			   *vmask = NULL;
 
 	assert(kds_src->format == KDS_FORMAT_ARROW &&
 		   kexp_load_vars->opcode == FuncOpCode__LoadVars &&
@@ -2183,8 +3716,24 @@ __handleDpuScanExecArrow(dpuClient *dclient,
 	INIT_KERNEL_CONTEXT(kcxt, session);
 	kcxt->kvars_slot = (kern_variable *)alloca(kcxt->kvars_nbytes);
 	kcxt->kvars_class = (int *)(kcxt->kvars_slot + kcxt->kvars_nslots);
-	for (kds_index = 0; kds_index < kds_src->nitems; kds_index++)
+	assert(row_start <= row_end && row_end <= kds_src->nitems);
+	nvquals = __setupDpuVecQuals(kexp_scan_quals, kexp_load_vars,
+								 kds_src, vquals);
+	if (nvquals > 0)
+		vmask = alloca(DPU_VEC_BATCH_NROWS);
+	for (kds_index = row_start; kds_index < row_end; kds_index++)
 	{
+		if (vmask)
+		{
+			uint32_t	voffset = (kds_index - row_start) % DPU_VEC_BATCH_NROWS;
+
+			if (voffset == 0)
+				__dpuVecEvalQuals(kds_src, vquals, nvquals, kds_index,
+								  Min(row_end - kds_index, DPU_VEC_BATCH_NROWS),
+								  vmask);
+			if (!vmask[voffset])
+				continue;
+		}
 		kcxt_reset(kcxt);
 		if (ExecLoadVarsOuterArrow(kcxt,
 								   kexp_load_vars,
@@ -2193,23 +3742,8 @@ __handleDpuScanExecArrow(dpuClient *dclient,
 								   kds_index))
 		{
 			dtes->nitems_in++;
-			if (!kmrels)
-			{
-				if (!dtes->handleDpuTaskFinalDepth(dclient, dtes, kcxt))
-					return false;
-			}
-			else if (kmrels->chunks[0].is_nestloop)
-			{
-				/* NEST-LOOP */
-				if (!__handleDpuTaskExecNestLoop(dclient, dtes, kcxt, 1))
-					return false;
-			}
-			else
-			{
-				/* HASH-JOIN */
-				if (!__handleDpuTaskExecHashJoin(dclient, dtes, kcxt, 1))
-					return false;
-			}
+			if (!__handleDpuTaskExecNextDepth(dclient, dtes, kcxt, 1))
+				return false;
 		}
 		else if (kcxt->errcode != ERRCODE_STROM_SUCCESS)
 		{
@@ -2222,15 +3756,270 @@ __handleDpuScanExecArrow(dpuClient *dclient,
 			return false;
 		}
 	}
-	dtes->nitems_raw += kds_src->nitems;
+	dtes->nitems_raw += (row_end - row_start);
 	return true;
 }
 
+static inline bool
+__handleDpuScanExecRange(dpuClient *dclient,
+						 dpuTaskExecState *dtes,
+						 kern_data_store *kds_src,
+						 uint32_t start, uint32_t end)
+{
+	if (kds_src->format == KDS_FORMAT_BLOCK)
+		return __handleDpuScanExecBlock(dclient, dtes, kds_src, start, end);
+	assert(kds_src->format == KDS_FORMAT_ARROW);
+	return __handleDpuScanExecArrow(dclient, dtes, kds_src, start, end);
+}
+
+/*
+ * dpuWorkerQueuePush / dpuWorkerQueuePop
+ */
+static void
+dpuWorkerQueuePush(long worker_id, dpuWorkItem *item, bool at_head)
+{
+	dpuWorkerQueue *wqueue = &dpu_worker_queues[worker_id];
+
+	pthreadMutexLock(&wqueue->mutex);
+	if (at_head)
+		dlist_push_head(&wqueue->items, &item->chain);
+	else
+		dlist_push_tail(&wqueue->items, &item->chain);
+	pthreadMutexUnlock(&wqueue->mutex);
+	__atomic_add_fetch(&dpu_command_pending, 1, __ATOMIC_SEQ_CST);
+}
+
+static void
+dpuWorkerQueueWakeup(bool broadcast)
+{
+	pthreadMutexLock(&dpu_command_mutex);
+	if (broadcast)
+		pthreadCondBroadcast(&dpu_command_cond);
+	else
+		pthreadCondSignal(&dpu_command_cond);
+	pthreadMutexUnlock(&dpu_command_mutex);
+}
+
+static dpuWorkItem *
+__dpuWorkerQueuePop(dpuWorkerQueue *wqueue, bool from_head)
+{
+	dlist_node *dnode = NULL;
+
+	/* quick check without the lock */
+	if (dlist_is_empty(&wqueue->items))
+		return NULL;
+	pthreadMutexLock(&wqueue->mutex);
+	if (!dlist_is_empty(&wqueue->items))
+	{
+		if (from_head)
+			dnode = dlist_pop_head_node(&wqueue->items);
+		else
+			dnode = dlist_pop_tail_node(&wqueue->items);
+	}
+	pthreadMutexUnlock(&wqueue->mutex);
+	if (!dnode)
+		return NULL;
+	__atomic_sub_fetch(&dpu_command_pending, 1, __ATOMIC_SEQ_CST);
+	return dlist_container(dpuWorkItem, chain, dnode);
+}
+
+static dpuWorkItem *
+dpuWorkerQueuePop(long worker_id)
+{
+	dpuWorkItem *item;
+
+	/* own queue first */
+	item = __dpuWorkerQueuePop(&dpu_worker_queues[worker_id], true);
+	if (item)
+		return item;
+	/* elsewhere, try to steal an item from the other workers */
+	for (long k=1; k < dpuserv_num_workers; k++)
+	{
+		long	victim = (worker_id + k) % dpuserv_num_workers;
+
+		item = __dpuWorkerQueuePop(&dpu_worker_queues[victim], false);
+		if (item)
+			return item;
+	}
+	return NULL;
+}
+
+/*
+ * __dpuservRunTaskPiece
+ */
+static void
+__dpuservRunTaskPiece(dpuTaskSplit *split, uint32_t pindex)
+{
+	dpuTaskPiece   *piece = &split->pieces[pindex];
+
+	if (!__atomic_load_n(&split->failed, __ATOMIC_SEQ_CST))
+	{
+		if (!__handleDpuScanExecRange(split->dclient,
+									  piece->dtes,
+									  split->kds_src,
+									  piece->start,
+									  piece->end))
+			__atomic_store_n(&split->failed, true, __ATOMIC_SEQ_CST);
+	}
+	pthreadMutexLock(&split->mutex);
+	assert(split->nremains > 0);
+	if (--split->nremains == 0)
+		pthreadCondBroadcast(&split->cond);
+	pthreadMutexUnlock(&split->mutex);
+}
+
+/*
+ * __dpuservMergeTaskPieces
+ */
+static bool
+__dpuservMergeTaskPieces(dpuTaskSplit *split, dpuTaskExecState *dtes)
+{
+	uint32_t	nitems = 0;
+	bool		failed = split->failed;
+
+	for (int i=0; i < split->npieces; i++)
+		nitems += split->pieces[i].dtes->kds_dst_nitems;
+	if (!failed && nitems > 0)
+	{
+		dtes->kds_dst_array = malloc(sizeof(kern_data_store *) * nitems);
+		if (!dtes->kds_dst_array)
+		{
+			dpuClientElog(split->dclient, "out of memory");
+			failed = true;
+		}
+		else
+			dtes->kds_dst_nrooms = nitems;
+	}
+	for (int i=0; i < split->npieces; i++)
+	{
+		dpuTaskExecState *__dtes = split->pieces[i].dtes;
+
+		for (int j=0; j < __dtes->kds_dst_nitems; j++)
+		{
+			if (failed)
+				free(__dtes->kds_dst_array[j]);
+			else
+				dtes->kds_dst_array[dtes->kds_dst_nitems++] = __dtes->kds_dst_array[j];
+		}
+		if (__dtes->kds_dst_array)
+			free(__dtes->kds_dst_array);
+		dtes->nitems_raw += __dtes->nitems_raw;
+		dtes->nitems_in  += __dtes->nitems_in;
+		dtes->nitems_out += __dtes->nitems_out;
+		for (int j=0; j < dtes->num_rels; j++)
+		{
+			dtes->stats[j].nitems_gist += __dtes->stats[j].nitems_gist;
+			dtes->stats[j].nitems_out  += __dtes->stats[j].nitems_out;
+		}
+	}
+	return !failed;
+}
+
+/*
+ * __dpuservExecTaskSplit
+ *
+ * It runs the scan on the supplied kds_src; split to multiple pieces
+ * to be processed by the other (idle) workers, if it is large enough.
+ */
+static bool
+__dpuservExecTaskSplit(dpuClient *dclient,
+					   dpuTaskExecState *dtes,
+					   kern_data_store *kds_src,
+					   long worker_id)
+{
+	dpuWorkerQueue *wqueue = &dpu_worker_queues[worker_id];
+	dpuTaskSplit   *split;
+	char		   *dtes_buf;
+	size_t			dtes_sz;
+	uint32_t		unitsz;
+	uint32_t		npieces;
+	uint32_t	   *pindex_array;
+	uint32_t		pindex_count = 0;
+	dlist_mutable_iter iter;
+	bool			retval;
+
+	unitsz = (kds_src->format == KDS_FORMAT_BLOCK
+			  ? DPUSERV_SPLIT_MIN_BLOCKS
+			  : DPUSERV_SPLIT_MIN_ROWS);
+	npieces = Min(dpuserv_split_pieces, kds_src->nitems / unitsz);
+	if (npieces <= 1)
+		goto no_split;
+	dtes_sz = MAXALIGN(offsetof(dpuTaskExecState, stats[dtes->num_rels]));
+	split = calloc(1, offsetof(dpuTaskSplit, pieces[npieces]) +
+				   dtes_sz * npieces);
+	if (!split)
+		goto no_split;
+	split->dclient = dclient;
+	split->kds_src = kds_src;
+	pthreadMutexInit(&split->mutex);
+	pthreadCondInit(&split->cond);
+	split->nremains = npieces;
+	split->failed = false;
+	split->npieces = npieces;
+	dtes_buf = (char *)&split->pieces[npieces];
+	for (uint32_t i=0; i < npieces; i++)
+	{
+		dpuTaskPiece   *piece = &split->pieces[i];
+
+		piece->item.split = split;
+		piece->item.pindex = i;
+		piece->start = ((uint64_t)kds_src->nitems * i) / npieces;
+		piece->end   = ((uint64_t)kds_src->nitems * (i+1)) / npieces;
+		piece->dtes  = (dpuTaskExecState *)(dtes_buf + dtes_sz * i);
+		memset(piece->dtes, 0, dtes_sz);
+		piece->dtes->kds_dst_head = dtes->kds_dst_head;
+		piece->dtes->num_rels = dtes->num_rels;
+		piece->dtes->handleDpuTaskFinalDepth = dtes->handleDpuTaskFinalDepth;
+	}
+	/* pieces are stolen by the idle workers from the tail */
+	for (uint32_t i=npieces-1; i > 0; i--)
+		dpuWorkerQueuePush(worker_id, &split->pieces[i].item, true);
+	dpuWorkerQueueWakeup(true);
+
+	/* run the first piece by itself */
+	__dpuservRunTaskPiece(split, 0);
+
+	/* take back the pieces not stolen yet */
+	pindex_array = alloca(sizeof(uint32_t) * npieces);
+	pthreadMutexLock(&wqueue->mutex);
+	dlist_foreach_modify(iter, &wqueue->items)
+	{
+		dpuWorkItem *item = dlist_container(dpuWorkItem, chain, iter.cur);
+
+		if (item->split == split)
+		{
+			dlist_delete(&item->chain);
+			pindex_array[pindex_count++] = item->pindex;
+		}
+	}
+	pthreadMutexUnlock(&wqueue->mutex);
+	if (pindex_count > 0)
+		__atomic_sub_fetch(&dpu_command_pending, pindex_count, __ATOMIC_SEQ_CST);
+	for (uint32_t i=0; i < pindex_count; i++)
+		__dpuservRunTaskPiece(split, pindex_array[i]);
+
+	/* wait for completion of the stolen pieces */
+	pthreadMutexLock(&split->mutex);
+	while (split->nremains > 0)
+		pthreadCondWait(&split->cond, &split->mutex);
+	pthreadMutexUnlock(&split->mutex);
+
+	retval = __dpuservMergeTaskPieces(split, dtes);
+	pthread_cond_destroy(&split->cond);
+	pthread_mutex_destroy(&split->mutex);
+	free(split);
+	return retval;
+
+no_split:
+	return __handleDpuScanExecRange(dclient, dtes, kds_src,
+									0, kds_src->nitems);
+}
+
 /*
  * dpuservHandleDpuTaskExec
  */
 static void
-dpuservHandleDpuTaskExec(dpuClient *dclient, XpuCommand *xcmd)
+dpuservHandleDpuTaskExec(dpuClient *dclient, XpuCommand *xcmd, long worker_id)
 {
 	kern_session_info  *session = dclient->session;
 	dpuTaskExecState   *dtes;
@@ -2283,13 +4072,14 @@ dpuservHandleDpuTaskExec(dpuClient *dclient, XpuCommand *xcmd)
 		char   *base_addr;
 
 		kds_src = dpuservLoadKdsBlock(dclient,
+									  dtes,
 									  kds_src_head,
 									  kds_src_pathname,
 									  kds_src_iovec,
 									  &base_addr);
 		if (kds_src)
 		{
-			if (__handleDpuScanExecBlock(dclient, dtes, kds_src))
+			if (__dpuservExecTaskSplit(dclient, dtes, kds_src, worker_id))
 				dpuClientWriteBack(dclient, dtes);
 			free(base_addr);
 		}
@@ -2299,13 +4089,14 @@ dpuservHandleDpuTaskExec(dpuClient *dclient, XpuCommand *xcmd)
 		char   *base_addr;
 
 		kds_src = dpuservLoadKdsArrow(dclient,
+									  dtes,
 									  kds_src_head,
 									  kds_src_pathname,
 									  kds_src_iovec,
 									  &base_addr);
 		if (kds_src)
 		{
-			if (__handleDpuScanExecArrow(dclient, dtes, kds_src))
+			if (__dpuservExecTaskSplit(dclient, dtes, kds_src, worker_id))
 				dpuClientWriteBack(dclient, dtes);
 			free(base_addr);
 		}
@@ -2338,6 +4129,7 @@ dpuservHandleDpuTaskFinal(dpuClient *dclient, XpuCommand *xcmd)
 	int				iovcnt = 0;
 	bool			gf_buf_locked = false;
 	size_t			resp_sz;
+	void		   *cbuf;
 
 	/* iovec allocation */
 	iovec_array = alloca(sizeof(struct iovec) *
@@ -2452,7 +4244,10 @@ dpuservHandleDpuTaskFinal(dpuClient *dclient, XpuCommand *xcmd)
 		resp_sz += kds_final->length;
 	}
 	resp.length = resp_sz;
+	iovcnt = __dpuClientCompressResults(dclient, &resp, iovec_array, iovcnt, &cbuf);
 	__dpuClientWriteBack(dclient, iovec_array, iovcnt);
+	if (cbuf)
+		free(cbuf);
 
 	if (gf_buf_locked)
 		pthreadRWLockUnlock(&gf_buf->kds_final_rwlock);
@@ -2497,6 +4292,10 @@ putDpuClient(dpuClient *dclient, int count)
 			free(xcmd);
 		}
 		dpuServUnmapSessionBuffers(dclient);
+#ifdef HAVE_IBVERBS
+		if (dclient->rdma)
+			__dpuRdmaStateRelease(dclient->rdma);
+#endif
 		close(dclient->sockfd);
 		free(dclient);
 	}
@@ -2512,15 +4311,19 @@ dpuservDpuWorkerMain(void *__priv)
 
 	if (verbose)
 		fprintf(stderr, "[worker-%lu] DPU service worker start.\n", worker_id);
-	pthreadMutexLock(&dpu_command_mutex);
 	while (!got_sigterm)
 	{
-		if (!dlist_is_empty(&dpu_command_list))
+		dpuWorkItem	   *item = dpuWorkerQueuePop(worker_id);
+
+		if (item && !item->xcmd)
 		{
-			dlist_node	   *dnode = dlist_pop_head_node(&dpu_command_list);
-			XpuCommand	   *xcmd = dlist_container(XpuCommand, chain, dnode);
+			/* a piece of the split XpuTaskExec */
+			__dpuservRunTaskPiece(item->split, item->pindex);
+		}
+		else if (item)
+		{
+			XpuCommand	   *xcmd = item->xcmd;
 			dpuClient	   *dclient;
-			pthreadMutexUnlock(&dpu_command_mutex);
 
 			dclient = xcmd->priv;
 			/*
@@ -2542,7 +4345,7 @@ dpuservDpuWorkerMain(void *__priv)
 									(xcmd != NULL ? "failed" : "ok"));
 						break;
 					case XpuCommandTag__XpuTaskExec:
-						dpuservHandleDpuTaskExec(dclient, xcmd);
+						dpuservHandleDpuTaskExec(dclient, xcmd, worker_id);
 						if (verbose)
 							fprintf(stderr, "[DPU-%ld@%s] CMD=XpuTaskExec\n",
 									worker_id, dclient->peer_addr);
@@ -2553,6 +4356,15 @@ dpuservDpuWorkerMain(void *__priv)
 							fprintf(stderr, "[DPU-%ld@%s] CMD=XpuTaskFinal\n",
 									worker_id, dclient->peer_addr);
 						break;
+#ifdef HAVE_IBVERBS
+					case XpuCommandTag__RdmaSetup:
+						dpuservHandleRdmaSetup(dclient, xcmd);
+						if (verbose)
+							fprintf(stderr, "[DPU-%ld@%s] CMD=RdmaSetup ... %s\n",
+									worker_id, dclient->peer_addr,
+									dclient->rdma ? "ok" : "not available");
+						break;
+#endif
 					default:
 						fprintf(stderr, "[DPU-%ld@%s] unknown xPU command (tag=%u, len=%ld)\n",
 								worker_id, dclient->peer_addr,
@@ -2563,15 +4375,17 @@ dpuservDpuWorkerMain(void *__priv)
 			if (xcmd)
 				free(xcmd);
 			putDpuClient(dclient, 2);
-			pthreadMutexLock(&dpu_command_mutex);
 		}
 		else
 		{
-			pthreadCondWait(&dpu_command_cond,
-							&dpu_command_mutex);
+			pthreadMutexLock(&dpu_command_mutex);
+			if (!got_sigterm &&
+				__atomic_load_n(&dpu_command_pending, __ATOMIC_SEQ_CST) == 0)
+				pthreadCondWait(&dpu_command_cond,
+								&dpu_command_mutex);
+			pthreadMutexUnlock(&dpu_command_mutex);
 		}
 	}
-	pthreadMutexUnlock(&dpu_command_mutex);
 	if (verbose)
 		fprintf(stderr, "[worker-%lu] DPU service worker terminated.\n", worker_id);
 	return NULL;
@@ -2583,13 +4397,16 @@ dpuservDpuWorkerMain(void *__priv)
 static void *
 __dpuServAllocCommand(void *__priv, size_t sz)
 {
-	return malloc(sz);
+	/* see XCMD_GET_WORK_ITEM */
+	return malloc(MAXALIGN(sz) + sizeof(dpuWorkItem));
 }
 
 static void
 __dpuServAttachCommand(void *__priv, XpuCommand *xcmd)
 {
 	dpuClient  *dclient = (dpuClient *)__priv;
+	dpuWorkItem *item;
+	long		worker_id;
 
 	getDpuClient(dclient, 2);
 	xcmd->priv = dclient;
@@ -2599,10 +4416,13 @@ __dpuServAttachCommand(void *__priv, XpuCommand *xcmd)
 				dclient->peer_addr,
 				xcmd->tag, xcmd->length);
 
-	pthreadMutexLock(&dpu_command_mutex);
-	dlist_push_tail(&dpu_command_list, &xcmd->chain);
-	pthreadCondSignal(&dpu_command_cond);
-	pthreadMutexUnlock(&dpu_command_mutex);
+	item = XCMD_GET_WORK_ITEM(xcmd);
+	memset(item, 0, sizeof(dpuWorkItem));
+	item->xcmd = xcmd;
+	worker_id = (__atomic_fetch_add(&dpu_command_next_queue, 1, __ATOMIC_SEQ_CST)
+				 % dpuserv_num_workers);
+	dpuWorkerQueuePush(worker_id, item, false);
+	dpuWorkerQueueWakeup(false);
 }
 
 TEMPLATE_XPU_CONNECT_RECEIVE_COMMANDS(__dpuServ)
@@ -2680,6 +4500,14 @@ dpuserv_main(struct sockaddr *addr, socklen_t addr_len)
 	signal(SIGPIPE, SIG_IGN);
 
 	/* start worker threads */
+	dpu_worker_queues = calloc(dpuserv_num_workers, sizeof(dpuWorkerQueue));
+	if (!dpu_worker_queues)
+		__Elog("out of memory");
+	for (long i=0; i < dpuserv_num_workers; i++)
+	{
+		pthreadMutexInit(&dpu_worker_queues[i].mutex);
+		dlist_init(&dpu_worker_queues[i].items);
+	}
 	dpuserv_workers = alloca(sizeof(pthread_t) * dpuserv_num_workers);
 	for (long i=0; i < dpuserv_num_workers; i++)
 	{
@@ -2836,6 +4664,10 @@ main(int argc, char *argv[])
 		{"port",       required_argument, 0, 'p'},
 		{"directory",  required_argument, 0, 'd'},
 		{"nworkers",   required_argument, 0, 'n'},
+		{"split",      required_argument, 0, 's'},
+		{"cache-size", required_argument, 0, 'c'},
+		{"rdma-device", required_argument, 0, 'r'},
+		{"rdma-gid-index", required_argument, 0, 'g'},
 		{"identifier", required_argument, 0, 'i'},
 		{"log",        required_argument, 0, 'l'},
 		{"verbose",    no_argument,       0, 'v'},
@@ -2850,12 +4682,11 @@ main(int argc, char *argv[])
 	dlist_init(&dpu_client_list);
 	pthreadMutexInit(&dpu_command_mutex);
 	pthreadCondInit(&dpu_command_cond);
-	dlist_init(&dpu_command_list);
 
 	/* parse command line options */
 	for (;;)
 	{
-		int		c = getopt_long(argc, argv, "a:p:d:n:i:l:vh",
+		int		c = getopt_long(argc, argv, "a:p:d:n:s:c:r:g:i:l:vh",
 								command_options, NULL);
 		char   *end;
 
@@ -2896,6 +4727,46 @@ main(int argc, char *argv[])
 						   dpuserv_num_workers);
 				break;
 
+			case 's':
+				if (dpuserv_split_pieces > 0)
+					__Elog("-s|--split option was given twice");
+				dpuserv_split_pieces = strtol(optarg, &end, 10);
+				if (*optarg == '\0' || *end != '\0')
+					__Elog("number of split pieces [%s] is not valid", optarg);
+				if (dpuserv_split_pieces < 1)
+					__Elog("number of split pieces %ld is out of range",
+						   dpuserv_split_pieces);
+				break;
+
+			case 'c':
+				if (dpuserv_cache_size_mb >= 0)
+					__Elog("-c|--cache-size option was given twice");
+				dpuserv_cache_size_mb = strtol(optarg, &end, 10);
+				if (*optarg == '\0' || *end != '\0')
+					__Elog("block cache size [%s] is not valid", optarg);
+				if (dpuserv_cache_size_mb < 0)
+					__Elog("block cache size %ldMB is out of range",
+						   dpuserv_cache_size_mb);
+				break;
+
+			case 'r':
+				if (dpuserv_rdma_device)
+					__Elog("-r|--rdma-device option was given twice");
+#ifndef HAVE_IBVERBS
+				__Elog("dpuserv is not built with libibverbs");
+#endif
+				dpuserv_rdma_device = optarg;
+				break;
+
+			case 'g':
+				if (dpuserv_rdma_gid_index >= 0)
+					__Elog("-g|--rdma-gid-index option was given twice");
+				dpuserv_rdma_gid_index = strtol(optarg, &end, 10);
+				if (*optarg == '\0' || *end != '\0' ||
+					dpuserv_rdma_gid_index < 0 || dpuserv_rdma_gid_index > 255)
+					__Elog("RDMA GID index [%s] is not valid", optarg);
+				break;
+
 			case 'i':
 				if (dpuserv_identifier)
 					__Elog("-i|--identifier option was given twice");
@@ -2917,6 +4788,10 @@ main(int argc, char *argv[])
 					  "\t-p|--port=PORT           listen port (default: 6543)\n"
 					  "\t-d|--directory=DIR       tablespace base (default: .)\n"
 					  "\t-n|--nworkers=N_WORKERS  number of workers (default: auto)\n"
+					  "\t-s|--split=N_PIECES      max pieces per data chunk (default: auto)\n"
+					  "\t-c|--cache-size=SIZE_MB  size of the block cache (default: 0, disabled)\n"
+					  "\t-r|--rdma-device=NAME    RDMA device to write back results ('auto' or name)\n"
+					  "\t-g|--rdma-gid-index=N    GID index of the RDMA device port (default: 0)\n"
 					  "\t-i|--identifier=IDENT    security identifier\n"
 					  "\t-v|--verbose             verbose output\n"
 					  "\t-h|--help                shows this message\n",
@@ -2931,6 +4806,11 @@ main(int argc, char *argv[])
 		dpuserv_base_directory = ".";
 	if (dpuserv_num_workers < 0)
 		dpuserv_num_workers = Max(4 * sysconf(_SC_NPROCESSORS_ONLN), 20);
+	if (dpuserv_rdma_gid_index < 0)
+		dpuserv_rdma_gid_index = 0;
+	if (dpuserv_split_pieces < 0)
+		dpuserv_split_pieces = Max(sysconf(_SC_NPROCESSORS_ONLN), 1);
+	dpuserv_split_pieces = Min(dpuserv_split_pieces, dpuserv_num_workers);
 	if (dpuserv_logfile)
 	{
 		FILE   *stdlog;
@@ -2941,6 +4821,7 @@ main(int argc, char *argv[])
 		fclose(stderr);
 		stderr = stdlog;
 	}
+	dpuVecSetupSimdKernels();
 
 	/* change the current working directory */
 	if (chdir(dpuserv_base_directory) != 0)
@@ -2981,6 +4862,13 @@ main(int argc, char *argv[])
 	__setupDevFuncLinkageTable(2 * FuncOpCode__BuiltInMax + 100);
 
 	pthreadMutexInit(&groupby_final_buffer_lock);
+	pthreadMutexInit(&dpu_gist_prep_mutex);
+	pthreadMutexInit(&dpu_cache_mutex);
+	for (int i=0; i < DPU_CACHE_HASH_NSLOTS; i++)
+		dlist_init(&dpu_cache_hash[i]);
+	dlist_init(&dpu_cache_lru);
+	if (dpuserv_cache_size_mb > 0)
+		dpu_cache_limit = (size_t)dpuserv_cache_size_mb << 20;
 	for (int i=0; i < GROUPBY_FINAL_BUFFER_HASHSZ; i++)
 		dlist_init(&groupby_final_buffer_hash[i]);
 
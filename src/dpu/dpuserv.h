@@ -32,6 +32,22 @@
 #include <sys/uio.h>
 #include <netdb.h>
 #include <arpa/inet.h>
+#include <math.h>
+#ifdef USE_LZ4
+#include <lz4frame.h>
+#endif
+#ifdef USE_ZSTD
+#include <zstd.h>
+#endif
+#ifdef HAVE_IBVERBS
+#include <infiniband/verbs.h>
+#endif
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
 #include "xpu_common.h"
 #include "float2.h"
 #include "heterodb_extra.h"
@@ -73,6 +89,20 @@ typedef struct dlist_iter
 		 (iter).cur != (iter).end;										\
 		 (iter).cur = (iter).cur->next)
 
+typedef struct dlist_mutable_iter
+{
+	dlist_node *cur;	/* current element */
+	dlist_node *next;	/* next node we'll iterate to */
+	dlist_node *end;	/* last node we'll iterate to */
+} dlist_mutable_iter;
+
+#define dlist_foreach_modify(iter, lhead)								\
+	for ((iter).end = &(lhead)->head,									\
+		 (iter).cur = (iter).end->next ? (iter).end->next : (iter).end,	\
+		 (iter).next = (iter).cur->next;								\
+		 (iter).cur != (iter).end;										\
+		 (iter).cur = (iter).next, (iter).next = (iter).cur->next)
+
 static inline void
 dlist_init(dlist_head *head)
 {
@@ -95,6 +125,15 @@ dlist_push_tail(dlist_head *head, dlist_node *node)
 	head->head.prev = node;
 }
 
+static inline void
+dlist_push_head(dlist_head *head, dlist_node *node)
+{
+	node->next = head->head.next;
+	node->prev = &head->head;
+	node->next->prev = node;
+	head->head.next = node;
+}
+
 static inline void
 dlist_delete(dlist_node *node)
 {
@@ -114,6 +153,17 @@ dlist_pop_head_node(dlist_head *head)
 	return node;
 }
 
+static inline dlist_node *
+dlist_pop_tail_node(dlist_head *head)
+{
+	dlist_node *node;
+
+	Assert(!dlist_is_empty(head));
+	node = head->head.prev;
+	dlist_delete(node);
+	return node;
+}
+
 /*
  * thin wrapper of mutex functions
  */
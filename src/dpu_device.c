@@ -11,9 +11,16 @@
  */
 #include "pg_strom.h"
 #include <netdb.h>
+#ifdef HAVE_IBVERBS
+#include <infiniband/verbs.h>
+#endif
 
 static char	   *pgstrom_dpu_endpoint_list;	/* GUC */
 static int		pgstrom_dpu_endpoint_default_port;	/* GUC */
+static char	   *pgstrom_dpu_rdma_device;	/* GUC */
+static int		pgstrom_dpu_rdma_gid_index;	/* GUC */
+static int		pgstrom_dpu_rdma_ring_size_mb;	/* GUC */
+int				pgstrom_dpu_result_codec;		/* GUC */
 #define PGSTROM_DPU_ENDPOINT_DEFAULT_PORT	6543
 #define DEFAULT_DPU_SETUP_COST		(100 * DEFAULT_SEQ_PAGE_COST)
 #define DEFAULT_DPU_OPERATOR_COST	(1.2 * DEFAULT_CPU_OPERATOR_COST)
@@ -25,6 +32,7 @@ double		pgstrom_dpu_operator_cost = DEFAULT_DPU_OPERATOR_COST;	/* GUC */
 double		pgstrom_dpu_seq_page_cost = DEFAULT_DPU_SEQ_PAGE_COST;	/* GUC */
 double		pgstrom_dpu_tuple_cost    = DEFAULT_DPU_TUPLE_COST;		/* GUC */
 bool		pgstrom_dpu_handle_cached_pages = false;	/* GUC */
+bool		pgstrom_enable_dpu_prefilter = true;		/* GUC */
 
 struct DpuStorageEntry
 {
@@ -301,6 +309,253 @@ DpuStorageEntryCount(void)
 	return (dpu_storage_master_array ? dpu_storage_master_array->nitems : 0);
 }
 
+/*
+ * RDMA transport of the results
+ *
+ * Once a session is opened, the backend optionally connects an RC queue-
+ * pair to the DPU service, and registers a private result ring buffer as
+ * a memory region. Then, the DPU service writes back the responses on the
+ * result ring using RDMA WRITE, and sends only its offset by the socket
+ * (XpuCommandTag__RingResponse), as the GPU service doing with the shared
+ * memory ring. The TCP socket is still used as the control channel, and
+ * any responses that cannot be written back by RDMA are sent by the socket.
+ */
+#ifdef HAVE_IBVERBS
+typedef struct
+{
+	struct ibv_context *ctx;
+	struct ibv_pd  *pd;
+	struct ibv_cq  *cq;
+	struct ibv_qp  *qp;
+	struct ibv_mr  *mr;
+} DpuRdmaContext;
+
+static void
+__dpuRdmaContextRelease(void *arg)
+{
+	DpuRdmaContext *rctx = arg;
+
+	if (rctx->mr)
+		ibv_dereg_mr(rctx->mr);
+	if (rctx->qp)
+		ibv_destroy_qp(rctx->qp);
+	if (rctx->cq)
+		ibv_destroy_cq(rctx->cq);
+	if (rctx->pd)
+		ibv_dealloc_pd(rctx->pd);
+	if (rctx->ctx)
+		ibv_close_device(rctx->ctx);
+	free(rctx);
+}
+
+static struct ibv_context *
+__dpuRdmaOpenDevice(const char *devname)
+{
+	struct ibv_device **dev_list;
+	struct ibv_context *ctx = NULL;
+	int			num_devs;
+
+	dev_list = ibv_get_device_list(&num_devs);
+	if (!dev_list)
+	{
+		elog(LOG, "failed on ibv_get_device_list: %m");
+		return NULL;
+	}
+	for (int i=0; i < num_devs; i++)
+	{
+		if (strcmp(devname, "auto") == 0 ||
+			strcmp(devname, ibv_get_device_name(dev_list[i])) == 0)
+		{
+			ctx = ibv_open_device(dev_list[i]);
+			if (!ctx)
+				elog(LOG, "failed on ibv_open_device('%s'): %m",
+					 ibv_get_device_name(dev_list[i]));
+			break;
+		}
+	}
+	ibv_free_device_list(dev_list);
+	return ctx;
+}
+
+static bool
+__dpuRdmaConnectQP(struct ibv_qp *qp, const kern_rdma_params *local,
+				   const kern_rdma_params *remote)
+{
+	struct ibv_qp_attr attr;
+
+	memset(&attr, 0, sizeof(attr));
+	attr.qp_state = IBV_QPS_RTR;
+	attr.path_mtu = Min(local->mtu, remote->mtu);
+	attr.dest_qp_num = remote->qp_num;
+	attr.rq_psn = remote->psn;
+	attr.max_dest_rd_atomic = 1;
+	attr.min_rnr_timer = 12;
+	attr.ah_attr.dlid = remote->lid;
+	attr.ah_attr.port_num = 1;
+	attr.ah_attr.is_global = 1;
+	memcpy(attr.ah_attr.grh.dgid.raw, remote->gid, 16);
+	attr.ah_attr.grh.sgid_index = local->gid_index;
+	attr.ah_attr.grh.hop_limit = 64;
+	if (ibv_modify_qp(qp, &attr,
+					  IBV_QP_STATE |
+					  IBV_QP_AV |
+					  IBV_QP_PATH_MTU |
+					  IBV_QP_DEST_QPN |
+					  IBV_QP_RQ_PSN |
+					  IBV_QP_MAX_DEST_RD_ATOMIC |
+					  IBV_QP_MIN_RNR_TIMER) != 0)
+	{
+		elog(LOG, "failed on ibv_modify_qp(RTR): %m");
+		return false;
+	}
+	memset(&attr, 0, sizeof(attr));
+	attr.qp_state = IBV_QPS_RTS;
+	attr.timeout = 14;
+	attr.retry_cnt = 7;
+	attr.rnr_retry = 7;
+	attr.sq_psn = local->psn;
+	attr.max_rd_atomic = 1;
+	if (ibv_modify_qp(qp, &attr,
+					  IBV_QP_STATE |
+					  IBV_QP_TIMEOUT |
+					  IBV_QP_RETRY_CNT |
+					  IBV_QP_RNR_RETRY |
+					  IBV_QP_SQ_PSN |
+					  IBV_QP_MAX_QP_RD_ATOMIC) != 0)
+	{
+		elog(LOG, "failed on ibv_modify_qp(RTS): %m");
+		return false;
+	}
+	return true;
+}
+
+static void
+__dpuClientSetupRdma(pgstromTaskState *pts, XpuConnection *conn,
+					 const char *devname)
+{
+	DpuRdmaContext *rctx;
+	struct ibv_port_attr port_attr;
+	struct ibv_qp_init_attr qp_init;
+	struct ibv_qp_attr attr;
+	union ibv_gid gid;
+	xpuResultRing *ring;
+	XpuCommand	xcmd;
+	XpuCommand *resp;
+	kern_rdma_params *local = &xcmd.u.rdma;
+
+	rctx = calloc(1, sizeof(DpuRdmaContext));
+	if (!rctx)
+		return;
+	ring = xpuClientSetupPrivateResultRing(conn,
+										   (size_t)pgstrom_dpu_rdma_ring_size_mb << 20,
+										   __dpuRdmaContextRelease, rctx);
+	if (!ring)
+	{
+		free(rctx);
+		return;
+	}
+	/* rctx shall be released on xpuClientCloseSession from here */
+	rctx->ctx = __dpuRdmaOpenDevice(pgstrom_dpu_rdma_device);
+	if (!rctx->ctx)
+		return;
+	if (ibv_query_port(rctx->ctx, 1, &port_attr) != 0 ||
+		ibv_query_gid(rctx->ctx, 1, pgstrom_dpu_rdma_gid_index, &gid) != 0)
+	{
+		elog(LOG, "failed on ibv_query_port/gid: %m");
+		return;
+	}
+	rctx->pd = ibv_alloc_pd(rctx->ctx);
+	if (!rctx->pd)
+	{
+		elog(LOG, "failed on ibv_alloc_pd: %m");
+		return;
+	}
+	rctx->cq = ibv_create_cq(rctx->ctx, 4, NULL, NULL, 0);
+	if (!rctx->cq)
+	{
+		elog(LOG, "failed on ibv_create_cq: %m");
+		return;
+	}
+	rctx->mr = ibv_reg_mr(rctx->pd, ring, offsetof(xpuResultRing, data[ring->nbytes]),
+						  IBV_ACCESS_LOCAL_WRITE |
+						  IBV_ACCESS_REMOTE_WRITE |
+						  IBV_ACCESS_REMOTE_READ);
+	if (!rctx->mr)
+	{
+		elog(LOG, "failed on ibv_reg_mr: %m");
+		return;
+	}
+	memset(&qp_init, 0, sizeof(qp_init));
+	qp_init.send_cq = rctx->cq;
+	qp_init.recv_cq = rctx->cq;
+	qp_init.qp_type = IBV_QPT_RC;
+	qp_init.cap.max_send_wr = 1;
+	qp_init.cap.max_recv_wr = 1;
+	qp_init.cap.max_send_sge = 1;
+	qp_init.cap.max_recv_sge = 1;
+	rctx->qp = ibv_create_qp(rctx->pd, &qp_init);
+	if (!rctx->qp)
+	{
+		elog(LOG, "failed on ibv_create_qp: %m");
+		return;
+	}
+	memset(&attr, 0, sizeof(attr));
+	attr.qp_state = IBV_QPS_INIT;
+	attr.pkey_index = 0;
+	attr.port_num = 1;
+	attr.qp_access_flags = (IBV_ACCESS_LOCAL_WRITE |
+							IBV_ACCESS_REMOTE_WRITE |
+							IBV_ACCESS_REMOTE_READ);
+	if (ibv_modify_qp(rctx->qp, &attr,
+					  IBV_QP_STATE |
+					  IBV_QP_PKEY_INDEX |
+					  IBV_QP_PORT |
+					  IBV_QP_ACCESS_FLAGS) != 0)
+	{
+		elog(LOG, "failed on ibv_modify_qp(INIT): %m");
+		return;
+	}
+
+	/* send the RdmaSetup command, then wait for the response */
+	memset(&xcmd, 0, sizeof(XpuCommand));
+	xcmd.magic = XpuCommandMagicNumber;
+	xcmd.tag   = XpuCommandTag__RdmaSetup;
+	xcmd.length = offsetof(XpuCommand, u.rdma) + sizeof(kern_rdma_params);
+	local->qp_num = rctx->qp->qp_num;
+	local->psn = (random() & 0xffffffU);
+	local->lid = port_attr.lid;
+	local->mtu = port_attr.active_mtu;
+	local->gid_index = pgstrom_dpu_rdma_gid_index;
+	memcpy(local->gid, gid.raw, 16);
+	local->ring_addr = (uint64_t)ring;
+	local->ring_rkey = rctx->mr->rkey;
+	local->ring_head_offset = offsetof(xpuResultRing, head);
+	local->ring_tail_offset = offsetof(xpuResultRing, tail);
+	local->ring_data_offset = offsetof(xpuResultRing, data);
+	local->ring_nbytes = ring->nbytes;
+	local->ring_item_headsz = offsetof(xpuResultRingItem, data);
+	local->ring_align = XPU_RESULT_RING_ALIGN;
+	xpuClientSendCommand(conn, &xcmd);
+
+	resp = xpuClientWaitResponse(pts);
+	if (!resp)
+		elog(ERROR, "Bug? %s:RdmaSetup response is missing", devname);
+	if (resp->tag != XpuCommandTag__RdmaSetup)
+		elog(ERROR, "%s:RdmaSetup failed - %s (%s:%d %s)",
+			 devname,
+			 resp->u.error.message,
+			 resp->u.error.filename,
+			 resp->u.error.lineno,
+			 resp->u.error.funcname);
+	if (resp->u.rdma.qp_num == 0)
+		elog(DEBUG1, "DPU service has no RDMA capability, use TCP instead");
+	else if (__dpuRdmaConnectQP(rctx->qp, local, &resp->u.rdma))
+		elog(DEBUG1, "RDMA connection established (qp=%u, remote qp=%u)",
+			 local->qp_num, resp->u.rdma.qp_num);
+	xpuClientPutResponse(resp);
+}
+#endif	/* HAVE_IBVERBS */
+
 /*
  * DpuClientOpenSession 
  */
@@ -327,7 +582,12 @@ DpuClientOpenSession(pgstromTaskState *pts,
 	}
 	snprintf(namebuf, sizeof(namebuf), "DPU-%u", ds_entry->endpoint_id);
 
-	__xpuClientOpenSession(pts, session, sockfd, namebuf, ds_entry->endpoint_id);
+	__xpuClientOpenSession(pts, session, sockfd, namebuf, ds_entry->endpoint_id,
+						   0, 0, false);
+#ifdef HAVE_IBVERBS
+	if (pgstrom_dpu_rdma_device && *pgstrom_dpu_rdma_device != '\0')
+		__dpuClientSetupRdma(pts, pts->conns[pts->num_conns - 1], namebuf);
+#endif
 }
 
 /*
@@ -494,6 +754,81 @@ pgstrom_dpu_operator_ratio(void)
 	return (pgstrom_dpu_operator_cost == 1.0 ? 0.0 : disable_cost);
 }
 
+/*
+ * pgstromTryDpuPreFilter
+ *
+ * It checks whether the DPU attached to the storage of the base relation
+ * can pre-filter the outer rows of GPU tasks. If available, it returns the
+ * qualifiers to be evaluated on the DPU, with the estimated cost of the
+ * outer scan and number of rows to be relayed to the GPU.
+ */
+List *
+pgstromTryDpuPreFilter(PlannerInfo *root,
+					   RelOptInfo *baserel,
+					   List *dev_quals,
+					   double parallel_divisor,
+					   Cost *p_startup_cost,
+					   Cost *p_run_cost,
+					   double *p_nrows)
+{
+	RangeTblEntry *rte = root->simple_rte_array[baserel->relid];
+	List	   *dpu_quals = NIL;
+	ListCell   *lc;
+	double		spc_seq_page_cost;
+	double		spc_rand_page_cost;
+	double		avg_seq_page_cost;
+	double		nrows;
+	QualCost	qcost;
+	Cost		run_cost;
+
+	if (!pgstrom_enable_dpu_prefilter ||
+		rte->relkind == RELKIND_FOREIGN_TABLE ||
+		!GetOptimalDpuForBaseRel(root, baserel))
+		return NIL;
+	foreach (lc, dev_quals)
+	{
+		RestrictInfo *rinfo = lfirst(lc);
+
+		if (pgstrom_xpu_expression(rinfo->clause,
+								   DEVKIND__NVIDIA_DPU,
+								   baserel->relid,
+								   NIL,
+								   NULL))
+			dpu_quals = lappend(dpu_quals, rinfo);
+	}
+	if (dpu_quals == NIL)
+		return NIL;
+
+	/* cost for DPU scan */
+	get_tablespace_page_costs(baserel->reltablespace,
+							  &spc_rand_page_cost,
+							  &spc_seq_page_cost);
+	avg_seq_page_cost = (spc_seq_page_cost * (1.0 - baserel->allvisfrac) +
+						 pgstrom_dpu_seq_page_cost * baserel->allvisfrac);
+	run_cost = avg_seq_page_cost * baserel->pages / parallel_divisor;
+	cost_qual_eval(&qcost, dpu_quals, root);
+	*p_startup_cost = pgstrom_dpu_setup_cost + qcost.startup;
+	run_cost += (qcost.per_tuple * pgstrom_dpu_operator_ratio() *
+				 baserel->tuples / parallel_divisor);
+	nrows = baserel->tuples * clauselist_selectivity(root,
+													 dpu_quals,
+													 baserel->relid,
+													 JOIN_INNER,
+													 NULL);
+	/* cost to relay the rows (DPU-->Host-->GPU) */
+	run_cost += ((pgstrom_dpu_tuple_cost +
+				  cpu_tuple_cost +
+				  pgstrom_gpu_tuple_cost) * nrows / parallel_divisor);
+	/* GPU evaluates the entire dev_quals again on the relayed rows */
+	cost_qual_eval(&qcost, dev_quals, root);
+	run_cost += (qcost.per_tuple * pgstrom_gpu_operator_ratio() *
+				 nrows / parallel_divisor);
+
+	*p_run_cost = run_cost;
+	*p_nrows = nrows;
+	return extract_actual_clauses(dpu_quals, false);
+}
+
 /*
  * pgstrom_init_dpu_options
  */
@@ -544,6 +879,15 @@ pgstrom_init_dpu_options(void)
 							 PGC_USERSET,
 							 GUC_NOT_IN_SAMPLE,
 							 NULL, NULL, NULL);
+	/* pre-filter of the outer relation by DPU for GPU tasks */
+	DefineCustomBoolVariable("pg_strom.enable_dpu_prefilter",
+							 "Enables DPU pre-filter of the outer relation for GPU tasks",
+							 NULL,
+							 &pgstrom_enable_dpu_prefilter,
+							 true,
+							 PGC_USERSET,
+							 GUC_NOT_IN_SAMPLE,
+							 NULL, NULL, NULL);
 	/* control whether DPU handles cached pages */
 	DefineCustomBoolVariable("pg_strom.dpu_handle_cached_pages",
 							 "Control whether DPUs handles cached clean pages",
@@ -561,6 +905,17 @@ pgstrom_init_dpu_options(void)
 bool
 pgstrom_init_dpu_device(void)
 {
+	static struct config_enum_entry __dpu_result_codec_options[] = {
+		{"none",	XPU_RESULT_CODEC__NONE,	false},
+#ifdef USE_LZ4
+		{"lz4",		XPU_RESULT_CODEC__LZ4,	false},
+#endif
+#ifdef USE_ZSTD
+		{"zstd",	XPU_RESULT_CODEC__ZSTD,	false},
+#endif
+		{NULL, 0, false}
+	};
+
 	/*
 	 * format:
 	 * <host/ipaddr>[;<port>]=<pathname>[, ...]
@@ -583,6 +938,43 @@ pgstrom_init_dpu_device(void)
 							PGC_POSTMASTER,
 							GUC_NOT_IN_SAMPLE,
 							NULL, NULL, NULL);
+	DefineCustomStringVariable("pg_strom.dpu_rdma_device",
+							   "RDMA device to receive the results from DPU ('auto' or device name)",
+							   "TCP sockets are used if not set",
+							   &pgstrom_dpu_rdma_device,
+							   NULL,
+							   PGC_SUSET,
+							   GUC_NOT_IN_SAMPLE,
+							   NULL, NULL, NULL);
+	DefineCustomIntVariable("pg_strom.dpu_rdma_gid_index",
+							"GID index of the RDMA device port",
+							NULL,
+							&pgstrom_dpu_rdma_gid_index,
+							0,
+							0,
+							255,
+							PGC_SUSET,
+							GUC_NOT_IN_SAMPLE,
+							NULL, NULL, NULL);
+	DefineCustomIntVariable("pg_strom.dpu_rdma_ring_size",
+							"Size of the result ring buffer written by RDMA",
+							NULL,
+							&pgstrom_dpu_rdma_ring_size_mb,
+							256,		/* 256MB */
+							16,			/* 16MB */
+							4096,		/* 4GB */
+							PGC_SUSET,
+							GUC_NOT_IN_SAMPLE | GUC_UNIT_MB,
+							NULL, NULL, NULL);
+	DefineCustomEnumVariable("pg_strom.dpu_result_compression",
+							 "Compression of the results sent from DPU",
+							 "DPU service sends the results uncompressed if it does not support the codec",
+							 &pgstrom_dpu_result_codec,
+							 XPU_RESULT_CODEC__NONE,
+							 __dpu_result_codec_options,
+							 PGC_USERSET,
+							 GUC_NOT_IN_SAMPLE,
+							 NULL, NULL, NULL);
 
 	if (parse_dpu_endpoint_list())
 	{
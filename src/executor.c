@@ -11,6 +11,12 @@
  */
 #include "pg_strom.h"
 #include "cuda_common.h"
+#ifdef USE_LZ4
+#include <lz4frame.h>
+#endif
+#ifdef USE_ZSTD
+#include <zstd.h>
+#endif
 
 /*
  * XpuConnection
@@ -31,6 +37,22 @@ struct XpuConnection
 	dlist_head		ready_cmds_list;	/* ready, but not fetched yet  */
 	dlist_head		active_cmds_list;	/* currently in-use */
 	kern_errorbuf	errorbuf;
+	/* shared memory ring buffer to send commands, if any */
+	xpuCommandRing *cmd_ring;
+	size_t			cmd_ring_sz;	/* mmap size of cmd_ring */
+	uint32_t		cmd_ring_handle;
+	bool			cmd_ring_linked; /* shm file is not unlinked yet */
+	bool			cmd_ring_active; /* server side already mapped it */
+	/* shared memory ring buffer to receive results, if any */
+	xpuResultRing  *resp_ring;
+	size_t			resp_ring_sz;	/* mmap size of resp_ring */
+	uint32_t		resp_ring_handle;
+	bool			resp_ring_linked; /* shm file is not unlinked yet */
+	/* callback to release the resources on the private result ring */
+	void		  (*resp_ring_release_cb)(void *arg);
+	void		   *resp_ring_release_arg;
+	/* true, if the service can reset the session for the next query */
+	bool			poolable;
 };
 
 /* see xact.c */
@@ -39,6 +61,22 @@ extern TransactionId   *ParallelCurrentXids;
 
 /* static variables */
 static dlist_head		xpu_connections_list;
+static dlist_head		xpu_idle_connections_list;	/* pooled connections */
+static int				xpu_idle_connections_count = 0;
+static int				pgstrom_cpu_fallback_tiny_input;	/* GUC */
+static int				pgstrom_gpu_session_pool_size;		/* GUC */
+static int				pgstrom_async_append_prefetch;		/* GUC */
+static bool				pgstrom_explain_gpudirect_io;		/* GUC */
+static bool				pgstrom_gpu_columnar_results;		/* GUC */
+static int				pgstrom_gpujoin_preload_prefetch;	/* GUC */
+static bool				pgstrom_enable_cpu_fallback_jit;	/* GUC */
+static int				pgstrom_log_min_duration_profile;	/* GUC */
+
+static void		__execInitAsyncAppendGroup(pgstromTaskState *pts, EState *estate);
+static bool		__pgstromExecTaskOpenConnection(pgstromTaskState *pts);
+static size_t	__setupTaskStateResultBuffer(pgstromTaskState *pts,
+											 kern_data_store *kds,
+											 TupleDesc tupdesc_dst);
 
 /*
  * Worker thread to receive response messages
@@ -54,6 +92,29 @@ __xpuConnectAttachCommand(void *__priv, XpuCommand *xcmd)
 {
 	XpuConnection *conn = __priv;
 
+	if (xcmd->tag == XpuCommandTag__RingResponse)
+	{
+		xpuResultRing *ring = conn->resp_ring;
+		uint64_t	offset = xcmd->u.ring_offset;
+		xpuResultRingItem *item;
+
+		/*
+		 * The GPU service already wrote back the response on the result
+		 * ring buffer, so we pick up the XpuCommand on the ring instead.
+		 */
+		free(xcmd);
+		if (!ring || offset + offsetof(xpuResultRingItem,
+									   data) >= ring->nbytes)
+		{
+			fprintf(stderr, "[%s; %s:%d] invalid result ring offset (%lu)\n",
+					conn->devname, __FILE_NAME__, __LINE__, (unsigned long)offset);
+			return;
+		}
+		pg_read_barrier();
+		item = (xpuResultRingItem *)(ring->data + offset);
+		xcmd = (XpuCommand *)item->data;
+		Assert(xcmd->magic == XpuCommandMagicNumber);
+	}
 	xcmd->priv = conn;
 	pthreadMutexLock(&conn->mutex);
 	Assert(conn->num_running_cmds > 0);
@@ -70,7 +131,8 @@ __xpuConnectAttachCommand(void *__priv, XpuCommand *xcmd)
 	else
 	{
 		Assert(xcmd->tag == XpuCommandTag__Success ||
-			   xcmd->tag == XpuCommandTag__CPUFallback);
+			   xcmd->tag == XpuCommandTag__CPUFallback ||
+			   xcmd->tag == XpuCommandTag__RdmaSetup);
 		dlist_push_tail(&conn->ready_cmds_list, &xcmd->chain);
 		conn->num_ready_cmds++;
 	}
@@ -133,6 +195,267 @@ __xpuConnectSessionWorker(void *__priv)
 	return NULL;
 }
 
+/*
+ * Shared memory ring buffers to send commands / to receive results
+ */
+static void *
+__xpuClientCreateRingSegment(size_t mmap_sz, bool is_result_ring,
+							 int cuda_dindex, uint32_t *p_handle)
+{
+	static uint	my_random_seed = 0;
+	void	   *addr;
+	uint32_t	handle;
+	char		namebuf[100];
+	int			fdesc;
+
+	if (my_random_seed == 0)
+		my_random_seed = (uint)MyProcPid ^ 0xdeadbeafU;
+	do {
+		handle = rand_r(&my_random_seed);
+		if (handle == 0)
+			continue;
+		if (is_result_ring)
+			XPU_RESULT_RING_NAME(namebuf, handle);
+		else
+			XPU_COMMAND_RING_NAME(namebuf, handle);
+		fdesc = shm_open(namebuf, O_RDWR | O_CREAT | O_EXCL, 0600);
+		if (fdesc < 0 && errno != EEXIST)
+		{
+			elog(LOG, "failed on shm_open('%s'): %m", namebuf);
+			return NULL;	/* socket is used instead */
+		}
+	} while (fdesc < 0);
+
+	if (ftruncate(fdesc, mmap_sz) != 0)
+	{
+		elog(LOG, "failed on ftruncate('%s', %zu): %m", namebuf, mmap_sz);
+		close(fdesc);
+		shm_unlink(namebuf);
+		return NULL;
+	}
+	addr = mmap(NULL, mmap_sz,
+				PROT_READ | PROT_WRITE,
+				MAP_SHARED,
+				fdesc, 0);
+	close(fdesc);
+	if (addr == MAP_FAILED)
+	{
+		elog(LOG, "failed on mmap('%s', %zu): %m", namebuf, mmap_sz);
+		shm_unlink(namebuf);
+		return NULL;
+	}
+	/* pages are not allocated yet, so put them on the node of GPU */
+	gpuDevBindNumaMemory(addr, mmap_sz, cuda_dindex);
+	__shmemAdviseHugePages(addr, mmap_sz);
+	*p_handle = handle;
+	return addr;
+}
+
+static void
+__xpuClientCreateCommandRing(XpuConnection *conn, size_t cmd_ring_sz)
+{
+	xpuCommandRing *ring;
+	size_t		mmap_sz = __shmemAlignSize(offsetof(xpuCommandRing,
+													data[cmd_ring_sz]));
+	uint32_t	handle;
+
+	ring = __xpuClientCreateRingSegment(mmap_sz, false,
+										conn->dev_index, &handle);
+	if (!ring)
+		return;
+	ring->nbytes = mmap_sz - offsetof(xpuCommandRing, data);
+	pg_atomic_init_u64(&ring->head, 0);
+	pg_atomic_init_u64(&ring->tail, 0);
+	pg_atomic_init_u32(&ring->consumer_waiting, 0);
+
+	conn->cmd_ring = ring;
+	conn->cmd_ring_sz = mmap_sz;
+	conn->cmd_ring_handle = handle;
+	conn->cmd_ring_linked = true;
+}
+
+static void
+__xpuClientCreateResultRing(XpuConnection *conn, size_t resp_ring_sz)
+{
+	xpuResultRing *ring;
+	size_t		mmap_sz = __shmemAlignSize(offsetof(xpuResultRing,
+													data[resp_ring_sz]));
+	uint32_t	handle;
+
+	ring = __xpuClientCreateRingSegment(mmap_sz, true,
+										conn->dev_index, &handle);
+	if (!ring)
+		return;
+	ring->nbytes = TYPEALIGN_DOWN(XPU_RESULT_RING_ALIGN,
+								  mmap_sz - offsetof(xpuResultRing, data));
+	pg_atomic_init_u64(&ring->head, 0);
+	pg_atomic_init_u64(&ring->tail, 0);
+
+	conn->resp_ring = ring;
+	conn->resp_ring_sz = mmap_sz;
+	conn->resp_ring_handle = handle;
+	conn->resp_ring_linked = true;
+}
+
+/*
+ * xpuClientSetupPrivateResultRing
+ *
+ * It allocates a result ring buffer on the private memory of the backend.
+ * It is not visible to the local GPU service, but a remote service can
+ * write back the responses over the network, like RDMA WRITE.
+ * The release_cb is called prior to unmap of the ring buffer.
+ */
+xpuResultRing *
+xpuClientSetupPrivateResultRing(XpuConnection *conn,
+								size_t resp_ring_sz,
+								void (*release_cb)(void *arg),
+								void *release_arg)
+{
+	xpuResultRing *ring;
+	size_t		mmap_sz = PAGE_ALIGN(offsetof(xpuResultRing,
+											  data[resp_ring_sz]));
+
+	if (conn->resp_ring)
+		return NULL;	/* already has a result ring */
+	ring = mmap(NULL, mmap_sz,
+				PROT_READ | PROT_WRITE,
+				MAP_PRIVATE | MAP_ANONYMOUS,
+				-1, 0);
+	if (ring == MAP_FAILED)
+	{
+		elog(LOG, "failed on mmap(%zu) for the result ring: %m", mmap_sz);
+		return NULL;
+	}
+	ring->nbytes = TYPEALIGN_DOWN(XPU_RESULT_RING_ALIGN,
+								  mmap_sz - offsetof(xpuResultRing, data));
+	pg_atomic_init_u64(&ring->head, 0);
+	pg_atomic_init_u64(&ring->tail, 0);
+
+	conn->resp_ring = ring;
+	conn->resp_ring_sz = mmap_sz;
+	conn->resp_ring_handle = 0;
+	conn->resp_ring_linked = false;
+	conn->resp_ring_release_cb = release_cb;
+	conn->resp_ring_release_arg = release_arg;
+
+	return ring;
+}
+
+static void
+__xpuClientUnlinkRings(XpuConnection *conn)
+{
+	char	namebuf[100];
+
+	if (conn->cmd_ring_linked)
+	{
+		XPU_COMMAND_RING_NAME(namebuf, conn->cmd_ring_handle);
+		if (shm_unlink(namebuf) != 0)
+			elog(LOG, "failed on shm_unlink('%s'): %m", namebuf);
+		conn->cmd_ring_linked = false;
+	}
+	if (conn->resp_ring_linked)
+	{
+		XPU_RESULT_RING_NAME(namebuf, conn->resp_ring_handle);
+		if (shm_unlink(namebuf) != 0)
+			elog(LOG, "failed on shm_unlink('%s'): %m", namebuf);
+		conn->resp_ring_linked = false;
+	}
+}
+
+/*
+ * __xpuClientWaitCommandRing
+ *
+ * It waits for the consumer to release the ring buffer until 'required'
+ * bytes are available. The consumer never sleeps unless the ring is empty,
+ * so it shall be released soon.
+ */
+static void
+__xpuClientWaitCommandRing(XpuConnection *conn, size_t required)
+{
+	xpuCommandRing *ring = conn->cmd_ring;
+
+	for (;;)
+	{
+		uint64_t	head = pg_atomic_read_u64(&ring->head);
+		uint64_t	tail = pg_atomic_read_u64(&ring->tail);
+
+		if (ring->nbytes - (head - tail) >= required)
+			break;
+		if (conn->terminated != 0)
+			elog(ERROR, "%s: GPU service connection is closed", conn->devname);
+		CHECK_FOR_INTERRUPTS();
+		pg_usleep(20L);
+	}
+	pg_read_barrier();
+}
+
+/*
+ * __xpuClientSendCommandRing
+ *
+ * It writes the command on the ring buffer, if it fits. Elsewhere, it waits
+ * for the ring buffer getting empty to keep the order of the commands, then
+ * returns false to tell the caller to use the socket.
+ */
+static bool
+__xpuClientSendCommandRing(XpuConnection *conn, struct iovec *iov, int iovcnt)
+{
+	xpuCommandRing *ring = conn->cmd_ring;
+	uint64_t	head;
+	size_t		len = 0;
+
+	for (int i=0; i < iovcnt; i++)
+		len += iov[i].iov_len;
+	if (len > ring->nbytes)
+	{
+		__xpuClientWaitCommandRing(conn, ring->nbytes);
+		return false;
+	}
+	__xpuClientWaitCommandRing(conn, len);
+
+	head = pg_atomic_read_u64(&ring->head);
+	for (int i=0; i < iovcnt; i++)
+	{
+		__xpuCommandRingCopy(ring, head, NULL,
+							 iov[i].iov_base,
+							 iov[i].iov_len, true);
+		head += iov[i].iov_len;
+	}
+	pg_write_barrier();
+	pg_atomic_write_u64(&ring->head, head);
+	pg_memory_barrier();
+
+	/* ring the doorbell, if consumer is sleeping */
+	if (pg_atomic_read_u32(&ring->consumer_waiting) != 0 &&
+		pg_atomic_exchange_u32(&ring->consumer_waiting, 0) != 0)
+	{
+		XpuCommand	doorbell;
+		const char *buf = (const char *)&doorbell;
+		size_t		sz = offsetof(XpuCommand, u);
+		ssize_t		nbytes;
+
+		memset(&doorbell, 0, sz);
+		doorbell.magic = XpuCommandMagicNumber;
+		doorbell.tag = XpuCommandTag__RingDoorbell;
+		doorbell.length = sz;
+		while (sz > 0)
+		{
+			nbytes = write(conn->sockfd, buf, sz);
+			if (nbytes > 0)
+			{
+				buf += nbytes;
+				sz -= nbytes;
+			}
+			else if (nbytes == 0)
+				elog(ERROR, "unable to send xPU command to the service");
+			else if (errno == EINTR)
+				CHECK_FOR_INTERRUPTS();
+			else
+				elog(ERROR, "failed on write(2): %m");
+		}
+	}
+	return true;
+}
+
 /*
  * xpuClientSendCommand
  */
@@ -148,6 +471,16 @@ xpuClientSendCommand(XpuConnection *conn, const XpuCommand *xcmd)
 	conn->num_running_cmds++;
 	pthreadMutexUnlock(&conn->mutex);
 
+	if (conn->cmd_ring_active)
+	{
+		struct iovec	iov;
+
+		iov.iov_base = (void *)xcmd;
+		iov.iov_len  = xcmd->length;
+		if (__xpuClientSendCommandRing(conn, &iov, 1))
+			return;
+	}
+
 	while (len > 0)
 	{
 		nbytes = write(sockfd, buf, len);
@@ -179,6 +512,10 @@ xpuClientSendCommandIOV(XpuConnection *conn, struct iovec *iov, int iovcnt)
 	conn->num_running_cmds++;
 	pthreadMutexUnlock(&conn->mutex);
 
+	if (conn->cmd_ring_active &&
+		__xpuClientSendCommandRing(conn, iov, iovcnt))
+		return;
+
 	while (iovcnt > 0)
 	{
 		nbytes = writev(sockfd, iov, iovcnt);
@@ -208,6 +545,46 @@ xpuClientSendCommandIOV(XpuConnection *conn, struct iovec *iov, int iovcnt)
 	}
 }
 
+/*
+ * __xpuClientFreeResponse
+ *
+ * It releases the response XpuCommand. If it is on the result ring buffer,
+ * the item is marked as released, then the tail of the ring buffer is moved
+ * forward across the released items, to allow the GPU service to reuse.
+ */
+static void
+__xpuClientFreeResponse(XpuConnection *conn, XpuCommand *xcmd)
+{
+	xpuResultRing *ring = conn->resp_ring;
+	xpuResultRingItem *item;
+	uint64_t	head;
+	uint64_t	tail;
+
+	if (!ring ||
+		(char *)xcmd <  ring->data ||
+		(char *)xcmd >= ring->data + ring->nbytes)
+	{
+		free(xcmd);
+		return;
+	}
+	item = (xpuResultRingItem *)((char *)xcmd -
+								 offsetof(xpuResultRingItem, data));
+	item->released = 1;
+
+	head = pg_atomic_read_u64(&ring->head);
+	tail = pg_atomic_read_u64(&ring->tail);
+	pg_read_barrier();
+	while (tail < head)
+	{
+		item = (xpuResultRingItem *)(ring->data + tail % ring->nbytes);
+		if (!item->released)
+			break;
+		tail += item->length;
+	}
+	pg_memory_barrier();
+	pg_atomic_write_u64(&ring->tail, tail);
+}
+
 /*
  * xpuClientPutResponse
  */
@@ -219,41 +596,182 @@ xpuClientPutResponse(XpuCommand *xcmd)
 	pthreadMutexLock(&conn->mutex);
 	dlist_delete(&xcmd->chain);
 	pthreadMutexUnlock(&conn->mutex);
-	free(xcmd);
+	__xpuClientFreeResponse(conn, xcmd);
 }
 
 /*
- * xpuClientCloseSession
+ * __xpuClientReleaseSessionRings
  */
-void
-xpuClientCloseSession(XpuConnection *conn)
+static void
+__xpuClientReleaseSessionRings(XpuConnection *conn)
 {
 	XpuCommand *xcmd;
 	dlist_node *dnode;
 
-	/* ensure termination of worker thread */
-	close(conn->sockfd);
-	conn->sockfd = -1;
-	pg_memory_barrier();
-	pthread_kill(conn->worker, SIGPOLL);
-	pthread_join(conn->worker, NULL);
+	__xpuClientUnlinkRings(conn);
+	if (conn->cmd_ring)
+	{
+		if (munmap(conn->cmd_ring, conn->cmd_ring_sz) != 0)
+			elog(LOG, "failed on munmap(%p, %zu): %m",
+				 conn->cmd_ring, conn->cmd_ring_sz);
+	}
+	conn->cmd_ring = NULL;
+	conn->cmd_ring_sz = 0;
+	conn->cmd_ring_handle = 0;
+	conn->cmd_ring_active = false;
 
 	while (!dlist_is_empty(&conn->ready_cmds_list))
 	{
 		dnode = dlist_pop_head_node(&conn->ready_cmds_list);
 		xcmd = dlist_container(XpuCommand, chain, dnode);
-		free(xcmd);
+		__xpuClientFreeResponse(conn, xcmd);
 	}
 	while (!dlist_is_empty(&conn->active_cmds_list))
 	{
 		dnode = dlist_pop_head_node(&conn->active_cmds_list);
 		xcmd = dlist_container(XpuCommand, chain, dnode);
-		free(xcmd);
+		__xpuClientFreeResponse(conn, xcmd);
+	}
+	conn->num_ready_cmds = 0;
+	if (conn->resp_ring_release_cb)
+		conn->resp_ring_release_cb(conn->resp_ring_release_arg);
+	if (conn->resp_ring)
+	{
+		if (munmap(conn->resp_ring, conn->resp_ring_sz) != 0)
+			elog(LOG, "failed on munmap(%p, %zu): %m",
+				 conn->resp_ring, conn->resp_ring_sz);
 	}
+	conn->resp_ring = NULL;
+	conn->resp_ring_sz = 0;
+	conn->resp_ring_handle = 0;
+	conn->resp_ring_release_cb = NULL;
+	conn->resp_ring_release_arg = NULL;
+}
+
+/*
+ * __xpuClientCloseConnection
+ */
+static void
+__xpuClientCloseConnection(XpuConnection *conn)
+{
+	/* ensure termination of worker thread */
+	close(conn->sockfd);
+	conn->sockfd = -1;
+	pg_memory_barrier();
+	pthread_kill(conn->worker, SIGPOLL);
+	pthread_join(conn->worker, NULL);
+
+	__xpuClientReleaseSessionRings(conn);
 	dlist_delete(&conn->chain);
 	free(conn);
 }
 
+/*
+ * __xpuClientReleaseToPool
+ *
+ * It asks the service to reset the session, then keeps the connection
+ * (and the gpuClient on the service side) for the next query. If the
+ * connection is not clean, it returns false to close the connection.
+ */
+static bool
+__xpuClientReleaseToPool(XpuConnection *conn)
+{
+	XpuCommand	xcmd;
+	XpuCommand *resp = NULL;
+	const char *buf = (const char *)&xcmd;
+	size_t		len = offsetof(XpuCommand, u);
+	ssize_t		nbytes;
+	int			status;
+
+	if (!conn->poolable ||
+		pgstrom_gpu_session_pool_size <= 0)
+		return false;
+	pthreadMutexLock(&conn->mutex);
+	if (conn->terminated != 0 ||
+		conn->num_running_cmds > 0 ||
+		conn->errorbuf.errcode != ERRCODE_STROM_SUCCESS)
+	{
+		pthreadMutexUnlock(&conn->mutex);
+		return false;
+	}
+	conn->num_running_cmds++;
+	pthreadMutexUnlock(&conn->mutex);
+	/* discard the responses not released yet */
+	__xpuClientReleaseSessionRings(conn);
+
+	/* sent by the socket, because the service unmaps the ring buffers */
+	memset(&xcmd, 0, len);
+	xcmd.magic = XpuCommandMagicNumber;
+	xcmd.tag = XpuCommandTag__CloseSession;
+	xcmd.length = len;
+	while (len > 0)
+	{
+		nbytes = write(conn->sockfd, buf, len);
+		if (nbytes > 0)
+		{
+			buf += nbytes;
+			len -= nbytes;
+		}
+		else if (nbytes < 0 && errno == EINTR)
+			continue;
+		else
+			return false;
+	}
+	/* wait for the response; 5sec at most */
+	for (int loop=0; loop < 50; loop++)
+	{
+		bool	terminated;
+
+		pthreadMutexLock(&conn->mutex);
+		if (!dlist_is_empty(&conn->ready_cmds_list))
+		{
+			resp = dlist_container(XpuCommand, chain,
+								   dlist_pop_head_node(&conn->ready_cmds_list));
+			conn->num_ready_cmds--;
+		}
+		terminated = (conn->terminated != 0);
+		pthreadMutexUnlock(&conn->mutex);
+		if (resp || terminated)
+			break;
+		(void) WaitLatch(MyLatch,
+						 WL_LATCH_SET | WL_TIMEOUT | WL_EXIT_ON_PM_DEATH,
+						 100L,
+						 PG_WAIT_EXTENSION);
+		ResetLatch(MyLatch);
+	}
+	if (!resp)
+		return false;
+	status = resp->tag;
+	__xpuClientFreeResponse(conn, resp);
+	if (status != XpuCommandTag__Success)
+		return false;
+
+	/* shrink the pool, if needed */
+	while (xpu_idle_connections_count >= pgstrom_gpu_session_pool_size)
+	{
+		XpuConnection *__conn = dlist_container(XpuConnection, chain,
+												dlist_tail_node(&xpu_idle_connections_list));
+		__xpuClientCloseConnection(__conn);
+		xpu_idle_connections_count--;
+	}
+	dlist_delete(&conn->chain);
+	conn->resowner = NULL;
+	dlist_push_head(&xpu_idle_connections_list, &conn->chain);
+	xpu_idle_connections_count++;
+
+	return true;
+}
+
+/*
+ * xpuClientCloseSession
+ */
+void
+xpuClientCloseSession(XpuConnection *conn)
+{
+	if (!__xpuClientReleaseToPool(conn))
+		__xpuClientCloseConnection(conn);
+}
+
 /*
  * xpuclientCleanupConnections
  */
@@ -277,7 +795,7 @@ xpuclientCleanupConnections(ResourceReleasePhase phase,
 			if (isCommit)
 				elog(LOG, "Bug? GPU connection %d is not closed on ExecEnd",
 					 conn->sockfd);
-			xpuClientCloseSession(conn);
+			__xpuClientCloseConnection(conn);
 		}
 	}
 }
@@ -525,6 +1043,44 @@ __build_session_lconvert(kern_session_info *session)
 	session->session_currency_frac_digits = lconvert->frac_digits;
 }
 
+static void
+__build_session_gpusort_keydesc(pgstromTaskState *pts,
+								kern_session_info *session,
+								StringInfo buf)
+{
+	pgstromPlanInfo *pp_info = pts->pp_info;
+	CustomScan *cscan = (CustomScan *)pts->css.ss.ps.plan;
+	int			nkeys = list_length(pp_info->gpusort_resnos);
+	kern_sortkey_desc *skey_desc;
+	ListCell   *lc1, *lc2, *lc3;
+	int			i = 0;
+
+	skey_desc = alloca(sizeof(kern_sortkey_desc) * nkeys);
+	memset(skey_desc, 0, sizeof(kern_sortkey_desc) * nkeys);
+	forthree (lc1, pp_info->gpusort_resnos,
+			  lc2, pp_info->gpusort_descending,
+			  lc3, pp_info->gpusort_nulls_first)
+	{
+		AttrNumber	resno = lfirst_int(lc1);
+		TargetEntry *tle = list_nth(cscan->custom_scan_tlist, resno - 1);
+		Oid			type_oid = exprType((Node *)tle->expr);
+		devtype_info *dtype = pgstrom_devtype_lookup(type_oid);
+
+		if (!dtype)
+			elog(ERROR, "device type '%s' is not supported",
+				 format_type_be(type_oid));
+		skey_desc[i].key_type_code = dtype->type_code;
+		skey_desc[i].key_resno = resno;
+		skey_desc[i].key_desc = (lfirst_int(lc2) != 0);
+		skey_desc[i].key_nulls_first = (lfirst_int(lc3) != 0);
+		i++;
+	}
+	session->gpusort_keydesc = __appendBinaryStringInfo(buf, skey_desc,
+														sizeof(kern_sortkey_desc) * nkeys);
+	session->gpusort_nkeys = nkeys;
+	session->gpusort_limit = (uint64_t)ceil(pp_info->gpusort_limit);
+}
+
 const XpuCommand *
 pgstromBuildSessionInfo(pgstromTaskState *pts,
 						uint32_t join_inner_handle,
@@ -540,14 +1096,20 @@ pgstromBuildSessionInfo(pgstromTaskState *pts,
 	XpuCommand	   *xcmd;
 	StringInfoData	buf;
 	bytea		   *xpucode;
+	uint32_t		xpucode_head;
 
 	initStringInfo(&buf);
 	session_sz = offsetof(kern_session_info, poffset[nparams]);
 	session = alloca(session_sz);
 	memset(session, 0, session_sz);
 	__appendZeroStringInfo(&buf, session_sz);
-	if (param_info)
-		__build_session_param_info(pts, session, &buf);
+
+	/*
+	 * The portion below depends on the plan only, so it is identical for
+	 * each execution of prepared statements. The GPU service caches this
+	 * portion with device pointers already resolved, keyed by the signature.
+	 */
+	xpucode_head = buf.len;
 	if (pp_info->kvars_deflist != NIL)
 		__build_session_kvars_defs(pts, session, &buf);
 	if (pp_info->kexp_load_vars_packed)
@@ -638,6 +1200,20 @@ pgstromBuildSessionInfo(pgstromTaskState *pts,
 									 VARDATA(xpucode),
 									 VARSIZE(xpucode) - VARHDRSZ);
 	}
+	if (pp_info->gpusort_resnos != NIL)
+		__build_session_gpusort_keydesc(pts, session, &buf);
+	if (buf.len > xpucode_head)
+	{
+		session->xpucode_cache_head = xpucode_head;
+		session->xpucode_cache_length = buf.len - xpucode_head;
+		session->xpucode_signature =
+			hash_bytes_extended((unsigned char *)buf.data + xpucode_head,
+								buf.len - xpucode_head,
+								nparams);
+	}
+	/* executor parameters */
+	if (param_info)
+		__build_session_param_info(pts, session, &buf);
 	if (groupby_tdesc_final)
 	{
 		size_t		sz = estimate_kern_data_store(groupby_tdesc_final);
@@ -659,22 +1235,70 @@ pgstromBuildSessionInfo(pgstromTaskState *pts,
 		session->groupby_kds_final = __appendBinaryStringInfo(&buf, kds_temp, sz);
 		session->groupby_prepfn_bufsz = pp_info->groupby_prepfn_bufsz;
 		session->groupby_ngroups_estimation = pts->css.ss.ps.plan->plan_rows;
+		session->groupby_sorted_run = (format == KDS_FORMAT_HASH &&
+									   pgstrom_enable_gpupreagg_sorted_run);
+		/* partial groups shall not be flushed, if complete groups mode */
+		if (format == KDS_FORMAT_HASH && !pp_info->groupby_complete)
+			session->groupby_kds_final_limit =
+				(uint64_t)pgstrom_gpupreagg_max_final_buffer_size << 10;
 	}
 	/* other database session information */
 	session->query_plan_id = ps_state->query_plan_id;
+	session->scan_limit = (uint64_t)pp_info->scan_limit;
+	session->tablesample_method = pts->tablesample_method;
+	session->tablesample_seed = pts->tablesample_seed;
+	session->tablesample_threshold = pts->tablesample_threshold;
+	if (pts->gcache_desc && pp_info->gpu_cache_lookup_key)
+	{
+		ExprState  *estate = ExecInitExpr(pp_info->gpu_cache_lookup_key,
+										  &pts->css.ss.ps);
+		Datum		key;
+		bool		isnull;
+		int			attnum;
+		uint32_t	hash;
+
+		key = ExecEvalExpr(estate, econtext, &isnull);
+		if (pgstromGpuCacheLookupKeyHash(pts, key, isnull, &attnum, &hash))
+		{
+			session->gcache_lookup_attnum = attnum;
+			session->gcache_lookup_hash = hash;
+		}
+	}
 	session->kcxt_kvecs_bufsz = pp_info->kvecs_bufsz;
 	session->kcxt_kvecs_ndims = pp_info->kvecs_ndims;
 	session->kcxt_extra_bufsz = pp_info->extra_bufsz;
 	session->xpu_task_flags = pts->xpu_task_flags;
+	/* user-defined device functions exist only in the JIT module */
+	session->xpucode_use_jit = ((pts->xpu_task_flags & DEVKIND__NVIDIA_GPU) != 0 &&
+								(pgstrom_enable_gpu_jit ||
+								 (pp_info->extra_flags & DEVFUNC__USER_DEFINED) != 0));
+	session->xpu_task_priority = pgstrom_gpu_task_priority;
+	session->quota_database_oid = MyDatabaseId;
+	session->quota_role_oid = GetSessionUserId();
+	session->quota_memory_limit = (uint64_t)pgstrom_gpu_quota_memory_kb << 10;
+	session->quota_tasks_limit = pgstrom_gpu_quota_tasks;
+	session->quota_action = pgstrom_gpu_quota_action;
+	session->quota_wait_timeout = pgstrom_gpu_quota_wait_timeout;
+	if ((pts->xpu_task_flags & DEVKIND__NVIDIA_DPU) != 0)
+		session->xpu_result_codec = pgstrom_dpu_result_codec;
 	session->hostEpochTimestamp = SetEpochTimestamp();
 	session->xactStartTimestamp = GetCurrentTransactionStartTimestamp();
 	session->session_xact_state = __build_session_xact_state(&buf);
+	session->session_xact_snapshot = pgstromBuildSessionXactSnapshot(pts, &buf);
 	session->session_timezone = __build_session_timezone(&buf);
 	session->session_encode = __build_session_encode(&buf);
 	__build_session_lconvert(session);
 	session->pgsql_port_number = PostPortNumber;
 	session->pgsql_plan_node_id = pts->css.ss.ps.plan->plan_node_id;
 	session->join_inner_handle = join_inner_handle;
+	session->join_inner_signature = ps_state->preload_cache_signature;
+	session->join_inner_deferred = pts->inner_deferred;
+	session->join_right_outer_on_device = pts->right_outer_on_device;
+	for (int i=0; i < pp_info->num_rels; i++)
+	{
+		if (pp_info->inners[i].bloom_prefilter)
+			session->join_bloom_prefilter |= (1U << (i+1));
+	}
 	memcpy(buf.data, session, session_sz);
 
 	/* setup XpuCommand */
@@ -696,50 +1320,172 @@ static bool
 pgstromTaskStateBeginScan(pgstromTaskState *pts)
 {
 	pgstromSharedState *ps_state = pts->ps_state;
-	XpuConnection  *conn = pts->conn;
 	uint32_t		curval, newval;
 
-	Assert(conn != NULL);
+	Assert(pts->conn != NULL && pts->num_conns > 0);
+	/*
+	 * In case of grace hash-join, a process that joins to the scan later
+	 * must start from the current inner partition. Thus, we need to
+	 * increment the task control under the preload_mutex; to avoid race
+	 * condition with pgstromTaskStateNextInnerPart().
+	 */
+	if (pts->num_inner_parts > 1)
+		SpinLockAcquire(&ps_state->preload_mutex);
 	curval = pg_atomic_read_u32(&ps_state->parallel_task_control);
 	do {
 		if ((curval & 1) != 0)
+		{
+			if (pts->num_inner_parts > 1)
+				SpinLockRelease(&ps_state->preload_mutex);
 			return false;
+		}
 		newval = curval + 2;
 	} while (!pg_atomic_compare_exchange_u32(&ps_state->parallel_task_control,
 											 &curval, newval));
-	pg_atomic_fetch_add_u32(&pts->rjoin_devs_count[conn->dev_index], 1);
+	if (pts->num_inner_parts > 1)
+	{
+		pts->curr_inner_part = ps_state->inner_part_id;
+		SpinLockRelease(&ps_state->preload_mutex);
+		((XpuCommand *)pts->xcmd_buf.data)->u.task.inner_part_id = pts->curr_inner_part;
+	}
+	for (int i=0; i < pts->num_conns; i++)
+		pg_atomic_fetch_add_u32(&pts->rjoin_devs_count[pts->conns[i]->dev_index], 1);
 	return true;
 }
 
 /*
- * pgstromTaskStateEndScan
+ * pgstromTaskStateNextInnerPart
+ *
+ * In case of grace hash-join, it moves the scan to the next inner partition
+ * once all the concurrent processes consumed the current one; then, the
+ * outer relation is scanned again from the head.
+ * It returns false if no more partitions remain.
  */
 static bool
-pgstromTaskStateEndScan(pgstromTaskState *pts, kern_final_task *kfin)
+pgstromTaskStateNextInnerPart(pgstromTaskState *pts)
 {
 	pgstromSharedState *ps_state = pts->ps_state;
-	XpuConnection  *conn = pts->conn;
-	uint32_t		curval, newval;
+	TableScanDesc scan = pts->css.ss.ss_currentScanDesc;
+	uint32_t	part_id = pts->curr_inner_part;
+	uint32_t	nprocs;
 
-	Assert(conn != NULL);
-	memset(kfin, 0, sizeof(kern_final_task));
-	curval = pg_atomic_read_u32(&ps_state->parallel_task_control);
-	do {
-		Assert(curval >= 2);
-		newval = ((curval - 2) | 1);
-	} while (!pg_atomic_compare_exchange_u32(&ps_state->parallel_task_control,
-											 &curval, newval));
-	if (newval == 1)
-		kfin->final_plan_node = true;
+	if (pts->num_inner_parts <= 1 || part_id + 1 >= pts->num_inner_parts)
+		return false;
 
-	if (pg_atomic_sub_fetch_u32(&pts->rjoin_devs_count[conn->dev_index], 1) == 0)
-		kfin->final_this_device = true;
+	SpinLockAcquire(&ps_state->preload_mutex);
+	Assert(ps_state->inner_part_id == part_id);
+	nprocs = (pg_atomic_read_u32(&ps_state->parallel_task_control) >> 1);
+	if (++ps_state->inner_part_nwaits >= nprocs)
+	{
+		/* the last process rewinds the (parallel) outer scan */
+		if (ps_state->ss_handle != DSM_HANDLE_INVALID)
+		{
+			Relation	rel = pts->css.ss.ss_currentRelation;
+			ParallelTableScanDesc pscan = (ParallelTableScanDesc)
+				((char *)ps_state + ps_state->parallel_scan_desc_offset);
+			table_parallelscan_reinitialize(rel, pscan);
+		}
+		ps_state->inner_part_nwaits = 0;
+		ps_state->inner_part_id = part_id + 1;
+		ConditionVariableBroadcast(&ps_state->preload_cond);
+	}
+	else
+	{
+		ConditionVariablePrepareToSleep(&ps_state->preload_cond);
+		while (ps_state->inner_part_id == part_id)
+		{
+			SpinLockRelease(&ps_state->preload_mutex);
+			ConditionVariableSleep(&ps_state->preload_cond,
+								   PG_WAIT_EXTENSION);
+			SpinLockAcquire(&ps_state->preload_mutex);
+		}
+		ConditionVariableCancelSleep();
+	}
+	Assert(ps_state->inner_part_id == part_id + 1);
+	SpinLockRelease(&ps_state->preload_mutex);
+
+	elog(DEBUG2, "GpuJoin: inner partition %u of %u begins",
+		 part_id + 1, pts->num_inner_parts);
+	table_rescan(scan, NULL);
+	pts->curr_inner_part = part_id + 1;
+	pts->curr_block_num  = 0;
+	pts->curr_block_tail = 0;
+	pts->scan_done = false;
+	((XpuCommand *)pts->xcmd_buf.data)->u.task.inner_part_id = pts->curr_inner_part;
 
-	return (kfin->final_plan_node | kfin->final_this_device);
+	return true;
 }
 
 /*
- * pgstromTaskStateResetScan
+ * pgstromTaskStateEndScan
+ *
+ * It returns true, if this process is the last one of the plan node.
+ */
+static bool
+pgstromTaskStateEndScan(pgstromTaskState *pts)
+{
+	pgstromSharedState *ps_state = pts->ps_state;
+	uint32_t		curval, newval;
+
+	curval = pg_atomic_read_u32(&ps_state->parallel_task_control);
+	do {
+		Assert(curval >= 2);
+		newval = ((curval - 2) | 1);
+	} while (!pg_atomic_compare_exchange_u32(&ps_state->parallel_task_control,
+											 &curval, newval));
+	return (newval == 1);
+}
+
+/*
+ * pgstromTaskStateEndDevice
+ *
+ * It returns true, if this connection is the last one of the device.
+ */
+static bool
+pgstromTaskStateEndDevice(pgstromTaskState *pts, XpuConnection *conn)
+{
+	return (pg_atomic_sub_fetch_u32(&pts->rjoin_devs_count[conn->dev_index], 1) == 0);
+}
+
+/*
+ * pgstromTaskStateSendFinalChunks
+ *
+ * It sends the final chunk to the connections that are the last one of
+ * the device. In multi-GPU mode, final_plan_node is sent later, once all
+ * the per-device final tasks are completed; because right-outer-join
+ * needs the outer-join-map merged by all the devices.
+ */
+static void
+pgstromTaskStateSendFinalChunks(pgstromTaskState *pts)
+{
+	bool		final_plan_node = pgstromTaskStateEndScan(pts);
+	struct iovec xcmd_iov[10];
+	int			xcmd_iovcnt;
+
+	for (int i=0; i < pts->num_conns; i++)
+	{
+		XpuConnection *conn = pts->conns[i];
+		kern_final_task kfin;
+		XpuCommand *xcmd;
+
+		memset(&kfin, 0, sizeof(kern_final_task));
+		kfin.final_this_device = pgstromTaskStateEndDevice(pts, conn);
+		if (pts->num_conns == 1)
+			kfin.final_plan_node = final_plan_node;
+		if (pts->cb_final_chunk &&
+			(kfin.final_plan_node || kfin.final_this_device))
+		{
+			xcmd = pts->cb_final_chunk(pts, &kfin, xcmd_iov, &xcmd_iovcnt);
+			if (xcmd)
+				xpuClientSendCommandIOV(conn, xcmd_iov, xcmd_iovcnt);
+		}
+	}
+	if (pts->num_conns > 1 && final_plan_node && pts->cb_final_chunk)
+		pts->final_plan_pending = true;
+}
+
+/*
+ * pgstromTaskStateResetScan
  */
 static void
 pgstromTaskStateResetScan(pgstromTaskState *pts)
@@ -757,6 +1503,10 @@ pgstromTaskStateResetScan(pgstromTaskState *pts)
 
 	pg_atomic_write_u32(&ps_state->parallel_task_control, 0);
 	pg_atomic_write_u32(pts->rjoin_exit_count, 0);
+	ps_state->inner_part_id = 0;
+	ps_state->inner_part_nwaits = 0;
+	pts->curr_inner_part = 0;
+	pts->scan_nitems_out = 0;
 	for (int i=0; i < num_devs; i++)
 		pg_atomic_write_u32(pts->rjoin_devs_count + i, 0);
 	if (ps_state->ss_handle == DSM_HANDLE_INVALID)
@@ -785,8 +1535,12 @@ __updateStatsXpuCommand(pgstromTaskState *pts, const XpuCommand *xcmd)
 								xcmd->u.results.npages_direct_read);
 		pg_atomic_fetch_add_u64(&ps_state->npages_vfs_read,
 								xcmd->u.results.npages_vfs_read);
-		pg_atomic_fetch_add_u64(&ps_state->source_ntuples_raw,
-								xcmd->u.results.nitems_raw);
+		pg_atomic_fetch_add_u64(&ps_state->npages_dpucache_hit,
+								xcmd->u.results.npages_dpucache_hit);
+		/* raw tuples are already counted by the DPU pre-filter, if any */
+		if (!pts->dpu_prefilter)
+			pg_atomic_fetch_add_u64(&ps_state->source_ntuples_raw,
+									xcmd->u.results.nitems_raw);
 		pg_atomic_fetch_add_u64(&ps_state->source_ntuples_in,
 								xcmd->u.results.nitems_in);
 		for (int i=0; i < n_rels; i++)
@@ -797,6 +1551,57 @@ __updateStatsXpuCommand(pgstromTaskState *pts, const XpuCommand *xcmd)
 									xcmd->u.results.stats[i].nitems_out);
 		}
 		pg_atomic_fetch_add_u64(&ps_state->result_ntuples, xcmd->u.results.nitems_out);
+		pg_atomic_fetch_add_u64(&ps_state->result_nchunks, 1);
+		pts->scan_nitems_out += xcmd->u.results.nitems_out;
+		pg_atomic_fetch_add_u64(&ps_state->time_load_usec,
+								xcmd->u.results.usec_load);
+		pg_atomic_fetch_add_u64(&ps_state->time_kernel_usec,
+								xcmd->u.results.usec_kernel);
+		pg_atomic_fetch_add_u64(&ps_state->time_writeback_usec,
+								xcmd->u.results.usec_writeback);
+		if (xcmd->u.results.gpudirect_nr_ios > 0)
+		{
+			uint64_t	curr_max = pg_atomic_read_u64(&ps_state->gpudirect_usec_max);
+
+			pg_atomic_fetch_add_u64(&ps_state->gpudirect_nr_ios,
+									xcmd->u.results.gpudirect_nr_ios);
+			pg_atomic_fetch_add_u64(&ps_state->gpudirect_usec_io,
+									xcmd->u.results.gpudirect_usec_io);
+			while (curr_max < xcmd->u.results.gpudirect_usec_max)
+			{
+				if (pg_atomic_compare_exchange_u64(&ps_state->gpudirect_usec_max,
+												   &curr_max,
+												   xcmd->u.results.gpudirect_usec_max))
+					break;
+			}
+			for (int k=0; k < GPUDIRECT_IO_HIST_NBUCKETS; k++)
+				pg_atomic_fetch_add_u64(&ps_state->gpudirect_io_hist[k],
+										xcmd->u.results.gpudirect_io_hist[k]);
+		}
+		if (xcmd->u.results.kernel_block_sz > 0)
+		{
+			pg_atomic_write_u32(&ps_state->kernel_grid_sz,
+								xcmd->u.results.kernel_grid_sz);
+			pg_atomic_write_u32(&ps_state->kernel_block_sz,
+								xcmd->u.results.kernel_block_sz);
+			pg_atomic_write_u32(&ps_state->kernel_shmem_sz,
+								xcmd->u.results.kernel_shmem_sz);
+		}
+		if (xcmd->u.results.scan_quals_nquals > 0)
+		{
+			int		nquals = Min(xcmd->u.results.scan_quals_nquals,
+								 KERN_ADAPTIVE_QUALS_MAX);
+
+			pg_atomic_write_u64(&ps_state->scan_quals_order,
+								xcmd->u.results.scan_quals_order);
+			for (int i=0; i < nquals; i++)
+			{
+				pg_atomic_fetch_add_u64(&ps_state->scan_quals_nevals[i],
+										xcmd->u.results.scan_quals_nevals[i]);
+				pg_atomic_fetch_add_u64(&ps_state->scan_quals_npassed[i],
+										xcmd->u.results.scan_quals_npassed[i]);
+			}
+		}
 	}
 	else if (xcmd->tag == XpuCommandTag__CPUFallback)
 	{
@@ -806,6 +1611,62 @@ __updateStatsXpuCommand(pgstromTaskState *pts, const XpuCommand *xcmd)
 								xcmd->u.fallback.npages_direct_read);
 		pg_atomic_fetch_add_u64(&ps_state->npages_vfs_read,
 								xcmd->u.fallback.npages_vfs_read);
+		pg_atomic_fetch_add_u64(&ps_state->fallback_nchunks, 1);
+	}
+}
+
+/*
+ * __updateStatsDpuPreFilter
+ *
+ * Statistics of the DPU pre-filter; source of the GPU tasks.
+ */
+static void
+__updateStatsDpuPreFilter(pgstromTaskState *pts_dpu, const XpuCommand *xcmd)
+{
+	pgstromSharedState *ps_state = pts_dpu->ps_state;
+
+	if (xcmd->tag == XpuCommandTag__Success)
+	{
+		pg_atomic_fetch_add_u64(&ps_state->npages_direct_read,
+								xcmd->u.results.npages_direct_read);
+		pg_atomic_fetch_add_u64(&ps_state->npages_vfs_read,
+								xcmd->u.results.npages_vfs_read);
+		pg_atomic_fetch_add_u64(&ps_state->npages_dpucache_hit,
+								xcmd->u.results.npages_dpucache_hit);
+		pg_atomic_fetch_add_u64(&ps_state->source_ntuples_raw,
+								xcmd->u.results.nitems_raw);
+		pg_atomic_fetch_add_u64(&ps_state->dpu_prefilter_nitems,
+								xcmd->u.results.nitems_out);
+	}
+	else if (xcmd->tag == XpuCommandTag__CPUFallback)
+	{
+		pg_atomic_fetch_add_u64(&ps_state->npages_direct_read,
+								xcmd->u.fallback.npages_direct_read);
+		pg_atomic_fetch_add_u64(&ps_state->npages_vfs_read,
+								xcmd->u.fallback.npages_vfs_read);
+	}
+}
+
+/*
+ * __xpuConnectRaiseErrorIfAny
+ *
+ * MEMO: caller must hold 'conn->mutex'; it is released on error
+ */
+static void
+__xpuConnectRaiseErrorIfAny(XpuConnection *conn)
+{
+	if (conn->errorbuf.errcode != ERRCODE_STROM_SUCCESS)
+	{
+		pthreadMutexUnlock(&conn->mutex);
+		ereport(ERROR,
+				(errcode(conn->errorbuf.errcode),
+				 errmsg("%s:%d  %s",
+						conn->errorbuf.filename,
+						conn->errorbuf.lineno,
+						conn->errorbuf.message),
+				 errhint("device at %s, function at %s",
+						 conn->devname,
+						 conn->errorbuf.funcname)));
 	}
 }
 
@@ -829,65 +1690,178 @@ __pickupNextXpuCommand(XpuConnection *conn)
 	return xcmd;
 }
 
+/*
+ * __decompressXpuCommand
+ *
+ * The DPU service may compress the kds_dst array of the response, if the
+ * session offered the codec. It expands the array on a new buffer, then
+ * replaces the original response on the active commands list.
+ */
+static XpuCommand *
+__decompressXpuCommand(XpuConnection *conn, XpuCommand *xcmd)
+{
+	XpuCommand *resp;
+	const char *src;
+	size_t		src_len;
+	char	   *dst;
+	size_t		dst_len;
+	size_t		head_sz;
+
+	if (xcmd->tag != XpuCommandTag__Success ||
+		xcmd->u.results.chunks_codec == XPU_RESULT_CODEC__NONE)
+		return xcmd;
+
+	head_sz = xcmd->u.results.chunks_offset;
+	src = (const char *)xcmd + head_sz;
+	src_len = xcmd->length - head_sz;
+	dst_len = xcmd->u.results.chunks_rawsz;
+	resp = malloc(head_sz + dst_len);
+	if (!resp)
+		elog(ERROR, "out of memory");
+	memcpy(resp, xcmd, head_sz);
+	dst = (char *)resp + head_sz;
+
+	switch (xcmd->u.results.chunks_codec)
+	{
+#ifdef USE_LZ4
+		case XPU_RESULT_CODEC__LZ4:
+			{
+				LZ4F_decompressionContext_t dctx;
+				size_t		src_pos = 0;
+				size_t		dst_pos = 0;
+				size_t		rv;
+
+				rv = LZ4F_createDecompressionContext(&dctx, LZ4F_VERSION);
+				if (LZ4F_isError(rv))
+				{
+					free(resp);
+					elog(ERROR, "failed on LZ4F_createDecompressionContext: %s",
+						 LZ4F_getErrorName(rv));
+				}
+				while (src_pos < src_len)
+				{
+					size_t	__src_len = src_len - src_pos;
+					size_t	__dst_len = dst_len - dst_pos;
+
+					rv = LZ4F_decompress(dctx,
+										 dst + dst_pos, &__dst_len,
+										 src + src_pos, &__src_len,
+										 NULL);
+					if (LZ4F_isError(rv))
+					{
+						LZ4F_freeDecompressionContext(dctx);
+						free(resp);
+						elog(ERROR, "%s: failed on LZ4F_decompress: %s",
+							 conn->devname, LZ4F_getErrorName(rv));
+					}
+					src_pos += __src_len;
+					dst_pos += __dst_len;
+					if (rv == 0 || (__src_len == 0 && __dst_len == 0))
+						break;
+				}
+				LZ4F_freeDecompressionContext(dctx);
+				if (dst_pos != dst_len)
+				{
+					free(resp);
+					elog(ERROR, "%s: LZ4 frame of the results is broken (expected %zu bytes, but %zu bytes)",
+						 conn->devname, dst_len, dst_pos);
+				}
+			}
+			break;
+#endif
+#ifdef USE_ZSTD
+		case XPU_RESULT_CODEC__ZSTD:
+			{
+				size_t	rv = ZSTD_decompress(dst, dst_len, src, src_len);
+
+				if (ZSTD_isError(rv) || rv != dst_len)
+				{
+					free(resp);
+					elog(ERROR, "%s: failed on ZSTD_decompress of the results: %s",
+						 conn->devname,
+						 ZSTD_isError(rv) ? ZSTD_getErrorName(rv) : "length mismatch");
+				}
+			}
+			break;
+#endif
+		default:
+			free(resp);
+			elog(ERROR, "%s: unsupported compression of the results (codec=%u)",
+				 conn->devname, xcmd->u.results.chunks_codec);
+	}
+	resp->length = head_sz + dst_len;
+	resp->u.results.chunks_codec = XPU_RESULT_CODEC__NONE;
+	resp->u.results.chunks_rawsz = 0;
+
+	pthreadMutexLock(&conn->mutex);
+	dlist_insert_after(&xcmd->chain, &resp->chain);
+	dlist_delete(&xcmd->chain);
+	pthreadMutexUnlock(&conn->mutex);
+	__xpuClientFreeResponse(conn, xcmd);
+
+	return resp;
+}
+
 static XpuCommand *
 __waitAndFetchNextXpuCommand(pgstromTaskState *pts, bool try_final_callback)
 {
-	XpuConnection  *conn = pts->conn;
 	XpuCommand	   *xcmd;
-	struct iovec	xcmd_iov[10];
-	int				xcmd_iovcnt;
 	int				ev;
 
-	pthreadMutexLock(&conn->mutex);
 	for (;;)
 	{
-		ResetLatch(MyLatch);
+		int		num_running_cmds = 0;
 
-		/* device error checks */
-		if (conn->errorbuf.errcode != ERRCODE_STROM_SUCCESS)
+		ResetLatch(MyLatch);
+		for (int i=0; i < pts->num_conns; i++)
 		{
-			pthreadMutexUnlock(&conn->mutex);
-			ereport(ERROR,
-					(errcode(conn->errorbuf.errcode),
-					 errmsg("%s:%d  %s",
-							conn->errorbuf.filename,
-							conn->errorbuf.lineno,
-							conn->errorbuf.message),
-					 errhint("device at %s, function at %s",
-							 conn->devname,
-							 conn->errorbuf.funcname)));
+			XpuConnection  *conn = pts->conns[i];
 
-		}
-		if (!dlist_is_empty(&conn->ready_cmds_list))
-		{
-			/* ok, ready commands we have */
-			break;
-		}
-		else if (conn->num_running_cmds > 0)
-		{
-			/* wait for the running commands */
+			pthreadMutexLock(&conn->mutex);
+			/* device error checks */
+			__xpuConnectRaiseErrorIfAny(conn);
+			if (!dlist_is_empty(&conn->ready_cmds_list))
+			{
+				/* ok, ready commands we have */
+				xcmd = __pickupNextXpuCommand(conn);
+				pthreadMutexUnlock(&conn->mutex);
+				xcmd = __decompressXpuCommand(conn, xcmd);
+				__updateStatsXpuCommand(pts, xcmd);
+				return xcmd;
+			}
+			num_running_cmds += conn->num_running_cmds;
 			pthreadMutexUnlock(&conn->mutex);
 		}
-		else
+
+		if (num_running_cmds == 0)
 		{
-			pthreadMutexUnlock(&conn->mutex);
+			/* grace hash-join; move to the next inner partition, if any */
+			if (try_final_callback && pgstromTaskStateNextInnerPart(pts))
+				return NULL;
 			if (!pts->final_done)
 			{
-				kern_final_task	kfin;
-
 				pts->final_done = true;
-				if (try_final_callback &&
-					pgstromTaskStateEndScan(pts, &kfin) &&
-					pts->cb_final_chunk != NULL)
+				if (try_final_callback)
 				{
-					xcmd = pts->cb_final_chunk(pts, &kfin, xcmd_iov, &xcmd_iovcnt);
-					if (xcmd)
-					{
-						xpuClientSendCommandIOV(conn, xcmd_iov, xcmd_iovcnt);
-						continue;
-					}
+					pgstromTaskStateSendFinalChunks(pts);
+					continue;
 				}
 			}
+			else if (pts->final_plan_pending)
+			{
+				kern_final_task	kfin;
+				struct iovec	xcmd_iov[10];
+				int				xcmd_iovcnt;
+
+				/* all the per-device final tasks are already done */
+				pts->final_plan_pending = false;
+				memset(&kfin, 0, sizeof(kern_final_task));
+				kfin.final_plan_node = true;
+				xcmd = pts->cb_final_chunk(pts, &kfin, xcmd_iov, &xcmd_iovcnt);
+				if (xcmd)
+					xpuClientSendCommandIOV(pts->conn, xcmd_iov, xcmd_iovcnt);
+				continue;
+			}
 			return NULL;
 		}
 		CHECK_FOR_INTERRUPTS();
@@ -902,80 +1876,108 @@ __waitAndFetchNextXpuCommand(pgstromTaskState *pts, bool try_final_callback)
 			ereport(FATAL,
 					(errcode(ERRCODE_ADMIN_SHUTDOWN),
 					 errmsg("Unexpected Postmaster dead")));
-		pthreadMutexLock(&conn->mutex);
 	}
-	xcmd = __pickupNextXpuCommand(conn);
-	pthreadMutexUnlock(&conn->mutex);
-	__updateStatsXpuCommand(pts, xcmd);
-	return xcmd;
+}
+
+/*
+ * xpuClientWaitResponse
+ *
+ * It waits for the response of the control command sent by the caller.
+ */
+XpuCommand *
+xpuClientWaitResponse(pgstromTaskState *pts)
+{
+	return __waitAndFetchNextXpuCommand(pts, false);
 }
 
 static XpuCommand *
 __fetchNextXpuCommand(pgstromTaskState *pts)
 {
-	XpuConnection  *conn = pts->conn;
 	XpuCommand	   *xcmd;
 	struct iovec	xcmd_iov[10];
 	int				xcmd_iovcnt;
 	int				ev;
 	int				max_async_tasks = pgstrom_max_async_tasks();
 
+	/* GPU service reads ahead the record-batches beyond the running tasks */
+	if (pts->arrow_state && !pts->ds_entry)
+		max_async_tasks += pgstrom_arrow_readahead_threads;
+retry:
 	while (!pts->scan_done)
 	{
+		XpuConnection  *conn_send = NULL;
+		XpuConnection  *conn_ready = NULL;
+		int				num_running_cmds = 0;
+
 		CHECK_FOR_INTERRUPTS();
 
-		pthreadMutexLock(&conn->mutex);
-		/* device error checks */
-		if (conn->errorbuf.errcode != ERRCODE_STROM_SUCCESS)
+		ResetLatch(MyLatch);
+		for (int i=0; i < pts->num_conns; i++)
 		{
+			XpuConnection  *conn = pts->conns[i];
+
+			pthreadMutexLock(&conn->mutex);
+			/* device error checks */
+			__xpuConnectRaiseErrorIfAny(conn);
+			if ((conn->num_running_cmds + conn->num_ready_cmds) < max_async_tasks &&
+				(dlist_is_empty(&conn->ready_cmds_list) ||
+				 conn->num_running_cmds < max_async_tasks / 2))
+			{
+				/*
+				 * xPU service still has margin to enqueue new commands.
+				 * If we have no ready commands or number of running commands
+				 * are less than pg_strom.max_async_tasks/2, we try to load
+				 * the next chunk and enqueue this command.
+				 * In multi-GPU mode, the least busy device is chosen.
+				 */
+				if (!conn_send ||
+					conn->num_running_cmds < conn_send->num_running_cmds)
+					conn_send = conn;
+			}
+			else if (!conn_ready && !dlist_is_empty(&conn->ready_cmds_list))
+				conn_ready = conn;
+			num_running_cmds += conn->num_running_cmds;
 			pthreadMutexUnlock(&conn->mutex);
-			ereport(ERROR,
-					(errcode(conn->errorbuf.errcode),
-					 errmsg("%s:%d  %s",
-							conn->errorbuf.filename,
-							conn->errorbuf.lineno,
-							conn->errorbuf.message),
-					 errhint("device at %s, function at %s",
-							 conn->devname,
-							 conn->errorbuf.funcname)));
 		}
 
-		if ((conn->num_running_cmds + conn->num_ready_cmds) < max_async_tasks &&
-			(dlist_is_empty(&conn->ready_cmds_list) ||
-			 conn->num_running_cmds < max_async_tasks / 2))
+		if (conn_send &&
+			pts->pp_info->scan_limit > 0.0 &&
+			pts->scan_nitems_out >= (uint64_t)pts->pp_info->scan_limit)
 		{
 			/*
-			 * xPU service still has margin to enqueue new commands.
-			 * If we have no ready commands or number of running commands
-			 * are less than pg_strom.max_async_tasks/2, we try to load
-			 * the next chunk and enqueue this command.
+			 * The upper LIMIT clause shall be satisfied with the rows
+			 * already returned, so we don't need to load the next chunk.
 			 */
-			pthreadMutexUnlock(&conn->mutex);
+			pts->scan_done = true;
+			break;
+		}
+		if (conn_send)
+		{
 			xcmd = pts->cb_next_chunk(pts, xcmd_iov, &xcmd_iovcnt);
 			if (!xcmd)
 			{
 				Assert(pts->scan_done);
 				break;
 			}
-			xpuClientSendCommandIOV(conn, xcmd_iov, xcmd_iovcnt);
+			xpuClientSendCommandIOV(conn_send, xcmd_iov, xcmd_iovcnt);
 		}
-		else if (!dlist_is_empty(&conn->ready_cmds_list))
+		else if (conn_ready)
 		{
-			xcmd = __pickupNextXpuCommand(conn);
-			pthreadMutexUnlock(&conn->mutex);
+			/* only this thread removes the ready commands */
+			pthreadMutexLock(&conn_ready->mutex);
+			xcmd = __pickupNextXpuCommand(conn_ready);
+			pthreadMutexUnlock(&conn_ready->mutex);
+			xcmd = __decompressXpuCommand(conn_ready, xcmd);
 			__updateStatsXpuCommand(pts, xcmd);
 			return xcmd;
 		}
-		else if (conn->num_running_cmds > 0)
+		else if (num_running_cmds > 0)
 		{
 			/*
 			 * This block means we already runs enough number of concurrent
 			 * tasks, but none of them are already finished.
 			 * So, let's wait for the response.
 			 */
-			ResetLatch(MyLatch);
-			pthreadMutexUnlock(&conn->mutex);
-
 			ev = WaitLatch(MyLatch,
 						   WL_LATCH_SET |
 						   WL_TIMEOUT |
@@ -992,11 +1994,49 @@ __fetchNextXpuCommand(pgstromTaskState *pts)
 			/*
 			 * Unfortunately, we touched the threshold. Take a short wait
 			 */
-			pthreadMutexUnlock(&conn->mutex);
 			pg_usleep(20000L);		/* 20ms */
 		}
 	}
-	return __waitAndFetchNextXpuCommand(pts, true);
+	xcmd = __waitAndFetchNextXpuCommand(pts, true);
+	if (!xcmd && !pts->scan_done)
+		goto retry;		/* restart the scan for the next inner partition */
+	return xcmd;
+}
+
+/*
+ * __pgstromScanNextColumnTuple
+ *
+ * It stores the columnar result on the slot as a virtual tuple. The values
+ * of pass-by-reference types points the response buffer, like heap-tuples
+ * of the row results.
+ */
+static TupleTableSlot *
+__pgstromScanNextColumnTuple(TupleTableSlot *slot,
+							 kern_data_store *kds, uint32_t index)
+{
+	ExecClearTuple(slot);
+	Assert(kds->ncols == slot->tts_tupleDescriptor->natts);
+	for (int j=0; j < kds->ncols; j++)
+	{
+		const kern_colmeta *cmeta = &kds->colmeta[j];
+
+		if (KDS_COLUMN_ITEM_ISNULL(kds, cmeta, index))
+		{
+			slot->tts_values[j] = 0;
+			slot->tts_isnull[j] = true;
+		}
+		else
+		{
+			const char *addr = ((const char *)kds +
+								__kds_unpack(cmeta->values_offset) +
+								(size_t)cmeta->attlen * index);
+
+			slot->tts_values[j] = fetch_att(addr, cmeta->attbyval,
+											cmeta->attlen);
+			slot->tts_isnull[j] = false;
+		}
+	}
+	return ExecStoreVirtualTuple(slot);
 }
 
 /*
@@ -1012,7 +2052,11 @@ pgstromScanNextTuple(pgstromTaskState *pts)
 		kern_data_store *kds = pts->curr_kds;
 		int64_t		index = pts->curr_index++;
 
-		if (index < kds->nitems)
+		if (index < kds->nitems && kds->format == KDS_FORMAT_COLUMN)
+		{
+			return __pgstromScanNextColumnTuple(slot, kds, index);
+		}
+		else if (index < kds->nitems)
 		{
 			kern_tupitem   *tupitem = KDS_GET_TUPITEM(kds, index);
 
@@ -1042,19 +2086,40 @@ pgstromExecFinalChunk(pgstromTaskState *pts,
 					  struct iovec *xcmd_iov, int *xcmd_iovcnt)
 {
 	XpuCommand	   *xcmd;
+	TupleDesc		tupdesc_dst = NULL;
+	size_t			off = offsetof(XpuCommand, u.fin.data);
+	size_t			bufsz = off;
 
-	pts->xcmd_buf.len = offsetof(XpuCommand, u.fin.data);
-	enlargeStringInfo(&pts->xcmd_buf, 0);
+	/*
+	 * RIGHT/FULL OUTER JOIN completed on the device needs the header of
+	 * the destination buffer
+	 */
+	if (kfin->final_plan_node && pts->right_outer_on_device)
+	{
+		tupdesc_dst = pts->css.ss.ss_ScanTupleSlot->tts_tupleDescriptor;
+		bufsz += estimate_kern_data_store(tupdesc_dst);
+	}
+	pts->xcmd_buf.len = 0;
+	enlargeStringInfo(&pts->xcmd_buf, bufsz);
 
 	xcmd = (XpuCommand *)pts->xcmd_buf.data;
 	memset(xcmd, 0, sizeof(XpuCommand));
 	xcmd->magic  = XpuCommandMagicNumber;
 	xcmd->tag    = XpuCommandTag__XpuTaskFinal;
-	xcmd->length = offsetof(XpuCommand, u.fin.data);
 	memcpy(&xcmd->u.fin, kfin, sizeof(kern_final_task));
+	if (tupdesc_dst)
+	{
+		kern_data_store *kds = (kern_data_store *)((char *)xcmd + off);
+
+		xcmd->u.fin.kds_dst_offset = off;
+		off += __setupTaskStateResultBuffer(pts, kds, tupdesc_dst);
+	}
+	Assert(off <= bufsz);
+	xcmd->length = off;
+	pts->xcmd_buf.len = off;
 
 	xcmd_iov[0].iov_base = xcmd;
-	xcmd_iov[0].iov_len  = offsetof(XpuCommand, u.fin.data);
+	xcmd_iov[0].iov_len  = off;
 	*xcmd_iovcnt = 1;
 
 	return xcmd;
@@ -1124,8 +2189,23 @@ ExecFallbackBlockDataStore(pgstromTaskState *pts,
 	{
 		PageHeaderData *pg_page = KDS_BLOCK_PGPAGE(kds, i);
 		BlockNumber		block_nr = KDS_BLOCK_BLCKNR(kds, i);
-		uint32_t		ntuples = PageGetMaxOffsetNumber((Page)pg_page);
+		uint32_t		ntuples;
+
+		/* padding blocks to merge GPU-Direct I/O; see relscan.c */
+		if (block_nr == InvalidBlockNumber)
+			continue;
+		ntuples = PageGetMaxOffsetNumber((Page)pg_page);
 
+		/*
+		 * Pages read by the direct reader without all-visible flag were
+		 * checked by the device-side MVCC logic, so tuples in the page
+		 * must be re-checked by the CPU using the shared buffer.
+		 */
+		if (!PageIsAllVisible((Page)pg_page))
+		{
+			pgstromRelScanFallbackBlock(pts, block_nr);
+			continue;
+		}
 		for (uint32_t k=0; k < ntuples; k++)
 		{
 			ItemIdData	   *lpp = &pg_page->pd_linp[k];
@@ -1137,6 +2217,9 @@ ExecFallbackBlockDataStore(pgstromTaskState *pts,
 				tuple.t_self.ip_blkid.bi_hi = (uint16_t)(block_nr >> 16);
 				tuple.t_self.ip_blkid.bi_lo = (uint16_t)(block_nr & 0xffffU);
 				tuple.t_self.ip_posid = k+1;
+				/* tuples not sampled by the TABLESAMPLE clause */
+				if (pgstromTableSampleSkipTuple(pts, &tuple.t_self))
+					continue;
 				tuple.t_tableOid = kds->table_oid;
 				tuple.t_data = (HeapTupleHeader)PageGetItem((Page)pg_page, lpp);
 
@@ -1191,6 +2274,89 @@ ExecFallbackArrowDataStore(pgstromTaskState *pts,
 	}
 }
 
+/*
+ * __columnarResultsAvailable
+ *
+ * GpuScan/GpuJoin can write back the results in KDS_FORMAT_COLUMN, if all
+ * the attributes are fixed-length. It saves DtoH bytes of the tuple header
+ * and the alignment paddings, and the heap-tuple formation on the device.
+ * GpuPreAgg (final buffer), GpuSort (sort on the heap-tuples) and DPU
+ * (row format only) still use KDS_FORMAT_ROW.
+ */
+static bool
+__columnarResultsAvailable(pgstromTaskState *pts, TupleDesc tupdesc_dst)
+{
+	pgstromPlanInfo *pp_info = pts->pp_info;
+
+	if (!pgstrom_gpu_columnar_results ||
+		(pts->xpu_task_flags & DEVKIND__NVIDIA_GPU) == 0 ||
+		(pts->xpu_task_flags & DEVTASK__PREAGG) != 0 ||
+		pp_info->gpusort_resnos != NIL ||
+		tupdesc_dst->natts == 0)
+		return false;
+	for (int j=0; j < tupdesc_dst->natts; j++)
+	{
+		Form_pg_attribute attr = TupleDescAttr(tupdesc_dst, j);
+
+		if (attr->attlen <= 0)
+			return false;
+	}
+	return true;
+}
+
+/*
+ * __setupTaskStateResultBuffer
+ *
+ * It sets up the header of the destination buffer, and returns its length.
+ * In case of columnar results, the layout of nullmap and values array is
+ * determined here for the buffer the GPU service allocates; that is
+ * (KDS_HEAD_LENGTH + PGSTROM_CHUNK_SIZE) bytes.
+ */
+static size_t
+__setupTaskStateResultBuffer(pgstromTaskState *pts,
+							 kern_data_store *kds,
+							 TupleDesc tupdesc_dst)
+{
+	size_t		head_sz;
+	size_t		unitsz = 0;
+	size_t		off;
+	uint32_t	nrooms;
+
+	if (!pts->columnar_results)
+		return setup_kern_data_store(kds, tupdesc_dst, 0, KDS_FORMAT_ROW);
+
+	setup_kern_data_store(kds, tupdesc_dst, 0, KDS_FORMAT_COLUMN);
+	/* the result buffer has no GpuCache system attribute */
+	kds->nr_colmeta = kds->ncols;
+	head_sz = KDS_HEAD_LENGTH(kds);
+	for (int j=0; j < kds->ncols; j++)
+		unitsz += kds->colmeta[j].attlen;
+	/* (attlen * nrooms) bytes and nrooms bits per column, with paddings */
+	nrooms = ((PGSTROM_CHUNK_SIZE - 2 * MAXIMUM_ALIGNOF * kds->ncols) *
+			  BITS_PER_BYTE) / (BITS_PER_BYTE * unitsz + kds->ncols);
+	off = head_sz;
+	for (int j=0; j < kds->ncols; j++)
+	{
+		kern_colmeta *cmeta = &kds->colmeta[j];
+		size_t		sz;
+
+		sz = MAXALIGN(BITMAPLEN(nrooms));
+		cmeta->nullmap_offset = __kds_packed(off);
+		cmeta->nullmap_length = __kds_packed(sz);
+		off += sz;
+
+		sz = MAXALIGN((size_t)cmeta->attlen * nrooms);
+		cmeta->values_offset = __kds_packed(off);
+		cmeta->values_length = __kds_packed(sz);
+		off += sz;
+	}
+	kds->column_nrooms = nrooms;
+	kds->length = head_sz + PGSTROM_CHUNK_SIZE;
+	Assert(off <= kds->length);
+
+	return head_sz;
+}
+
 /*
  * __setupTaskStateRequestBuffer
  */
@@ -1229,7 +2395,7 @@ __setupTaskStateRequestBuffer(pgstromTaskState *pts,
 	{
 		xcmd->u.task.kds_dst_offset = off;
 		kds  = (kern_data_store *)((char *)xcmd + off);
-		off += setup_kern_data_store(kds, tdesc_dst, 0, KDS_FORMAT_ROW);
+		off += __setupTaskStateResultBuffer(pts, kds, tdesc_dst);
 	}
 	if (tdesc_src)
 	{
@@ -1313,13 +2479,85 @@ __fixup_fallback_projection(Node *node, void *__data)
 }
 
 /*
- * fixup_fallback_join_inner_keys
+ * __execFallbackJitBegin / __execFallbackJitEnd
+ *
+ * The planner decides es_jit_flags by the total cost of the plan, but it
+ * does not know the CPU fallback; Gpu* nodes usually have small cost, so
+ * the fallback expressions are interpreted even if a large number of rows
+ * are re-run on the CPU. Here we estimate the worst-case cost of the CPU
+ * fallback (all the scanned tuples go through the fallback quals and
+ * projection), and temporarily turn on the JIT flags while the fallback
+ * ExprStates are initialized.
+ * LLVM compiles the expression on its first evaluation, so it costs
+ * nothing unless rows actually fall back.
  */
-static void
-__execInitTaskStateCpuFallback(pgstromTaskState *pts)
+static bool
+__count_fallback_expr_nodes(Node *node, int *p_count)
+{
+	if (!node)
+		return false;
+	(*p_count)++;
+	return expression_tree_walker(node, __count_fallback_expr_nodes, p_count);
+}
+
+static int
+__execFallbackJitBegin(pgstromTaskState *pts)
 {
 	pgstromPlanInfo *pp_info = pts->pp_info;
-	CustomScan *cscan = (CustomScan *)pts->css.ss.ps.plan;
+	EState	   *estate = pts->css.ss.ps.state;
+	int			saved_flags = estate->es_jit_flags;
+	int			count = 0;
+	Cost		fallback_cost;
+
+	if (!pgstrom_enable_cpu_fallback_jit ||
+		!jit_enabled ||
+		jit_above_cost < 0.0 ||
+		pgstrom_cpu_fallback_elevel >= ERROR ||
+		(saved_flags & PGJIT_PERFORM) != 0)
+		return saved_flags;
+
+	__count_fallback_expr_nodes((Node *)pp_info->scan_quals_fallback, &count);
+	__count_fallback_expr_nodes((Node *)pp_info->fallback_tlist, &count);
+	for (int i=0; i < pp_info->num_rels; i++)
+	{
+		pgstromPlanInnerInfo *pp_inner = &pp_info->inners[i];
+
+		__count_fallback_expr_nodes((Node *)pp_inner->join_quals_fallback, &count);
+		__count_fallback_expr_nodes((Node *)pp_inner->other_quals_fallback, &count);
+	}
+	fallback_cost = pp_info->scan_tuples * (cpu_tuple_cost +
+											cpu_operator_cost * count);
+	if (fallback_cost > jit_above_cost)
+	{
+		int		jit_flags = PGJIT_PERFORM | PGJIT_EXPR;
+
+		if (jit_tuple_deforming)
+			jit_flags |= PGJIT_DEFORM;
+		if (jit_optimize_above_cost >= 0.0 &&
+			fallback_cost > jit_optimize_above_cost)
+			jit_flags |= PGJIT_OPT3;
+		if (jit_inline_above_cost >= 0.0 &&
+			fallback_cost > jit_inline_above_cost)
+			jit_flags |= PGJIT_INLINE;
+		estate->es_jit_flags |= jit_flags;
+	}
+	return saved_flags;
+}
+
+static void
+__execFallbackJitEnd(pgstromTaskState *pts, int saved_flags)
+{
+	pts->css.ss.ps.state->es_jit_flags = saved_flags;
+}
+
+/*
+ * fixup_fallback_join_inner_keys
+ */
+static void
+__execInitTaskStateCpuFallback(pgstromTaskState *pts)
+{
+	pgstromPlanInfo *pp_info = pts->pp_info;
+	CustomScan *cscan = (CustomScan *)pts->css.ss.ps.plan;
 	Relation	rel = pts->css.ss.ss_currentRelation;
 	TupleDesc	fallback_tdesc;
 	List	   *cscan_tlist = NIL;
@@ -1401,6 +2639,91 @@ __execInitTaskStateCpuFallback(pgstromTaskState *pts)
 								fallback_tdesc);
 }
 
+/*
+ * __execFallbackDpuPreFilter
+ *
+ * The tuples fallen back during the DPU pre-filter are kept as is, then
+ * relayed to the GPU; that evaluates the entire scan-quals again.
+ */
+static bool
+__execFallbackDpuPreFilter(pgstromTaskState *pts_dpu, HeapTuple tuple)
+{
+	pgstromStoreFallbackTuple(pts_dpu, tuple);
+	return true;
+}
+
+/*
+ * __execInitDpuPreFilter
+ *
+ * It sets up the task-state of the DPU pre-filter of the outer relation.
+ * It shares the relation scan and the shared-state with the GPU task,
+ * then runs DpuScan on the DPU attached to the storage.
+ */
+static bool
+__execInitDpuPreFilter(pgstromTaskState *pts, TupleDesc tupdesc_src)
+{
+	pgstromPlanInfo *pp_info = pts->pp_info;
+	pgstromPlanInfo *pp_dpu;
+	pgstromTaskState *pts_dpu;
+	Relation	rel = pts->css.ss.ss_currentRelation;
+	const DpuStorageEntry *ds_entry;
+	const char *kds_pathname = pts->kds_pathname;
+
+	if ((pts->xpu_task_flags & DEVKIND__NVIDIA_GPU) == 0 ||
+		pp_info->kexp_dpu_prefilter_projection == NULL)
+		return false;
+	ds_entry = GetOptimalDpuForRelation(rel, &kds_pathname);
+	if (!ds_entry)
+		return false;
+
+	pp_dpu = palloc0(offsetof(pgstromPlanInfo, inners));
+	pp_dpu->xpu_task_flags = TASK_KIND__DPUSCAN;
+	pp_dpu->gpu_cache_dindex = -1;
+	pp_dpu->ds_entry = ds_entry;
+	pp_dpu->outer_refs = pp_info->outer_refs;
+	pp_dpu->used_params = pp_info->used_params;
+	pp_dpu->scan_relid = pp_info->scan_relid;
+	pp_dpu->scan_quals = pp_info->dpu_prefilter_quals;
+	pp_dpu->scan_tuples = pp_info->scan_tuples;
+	pp_dpu->scan_rows = pp_info->dpu_prefilter_nrows;
+	pp_dpu->kexp_load_vars_packed = pp_info->kexp_dpu_prefilter_load_vars;
+	pp_dpu->kexp_move_vars_packed = pp_info->kexp_dpu_prefilter_move_vars;
+	pp_dpu->kexp_scan_quals = pp_info->kexp_dpu_prefilter_quals;
+	pp_dpu->kexp_projection = pp_info->kexp_dpu_prefilter_projection;
+	pp_dpu->kvars_deflist = pp_info->dpu_prefilter_kvars_deflist;
+	pp_dpu->extra_bufsz = pp_info->dpu_prefilter_extra_bufsz;
+
+	pts_dpu = palloc0(offsetof(pgstromTaskState, inners));
+	memcpy(pts_dpu, pts, offsetof(pgstromTaskState, inners));
+	pts_dpu->xpu_task_flags = TASK_KIND__DPUSCAN;
+	pts_dpu->optimal_gpus = NULL;
+	pts_dpu->ds_entry = ds_entry;
+	pts_dpu->kds_pathname = kds_pathname;
+	pts_dpu->conn = NULL;
+	pts_dpu->num_conns = 0;
+	pts_dpu->conns = NULL;
+	pts_dpu->pp_info = pp_dpu;
+	pts_dpu->dpu_prefilter = NULL;
+	pts_dpu->curr_resp = NULL;
+	pts_dpu->fallback_tuples = NULL;
+	pts_dpu->fallback_buffer = NULL;
+	pts_dpu->fallback_store = NULL;
+	/* the relayed tuples are stored on the base_slot of the GPU task */
+	pts_dpu->css.ss.ss_ScanTupleSlot = pts->base_slot;
+	pts_dpu->cb_next_tuple = NULL;
+	pts_dpu->cb_next_chunk = pgstromRelScanChunkDirect;
+	pts_dpu->cb_final_chunk = NULL;
+	pts_dpu->cb_cpu_fallback = __execFallbackDpuPreFilter;
+	pts_dpu->num_rels = 0;
+	__setupTaskStateRequestBuffer(pts_dpu,
+								  tupdesc_src,
+								  tupdesc_src,
+								  KDS_FORMAT_BLOCK);
+	pts->dpu_prefilter = pts_dpu;
+
+	return true;
+}
+
 /*
  * pgstromExecInitTaskState
  */
@@ -1414,6 +2737,7 @@ pgstromExecInitTaskState(CustomScanState *node, EState *estate, int eflags)
 	TupleDesc	tupdesc_src = RelationGetDescr(rel);
 	TupleDesc	tupdesc_dst;
 	int			depth_index = 0;
+	int			jit_saved_flags;
 	bool		has_right_outer = false;
 	ListCell   *lc;
 
@@ -1446,8 +2770,17 @@ pgstromExecInitTaskState(CustomScanState *node, EState *estate, int eflags)
 								  pp_info->brin_index_oid,
 								  pp_info->brin_index_conds,
 								  pp_info->brin_index_quals);
+		/* setup zone map if any */
+		if (!pts->gcache_desc)
+			pgstromZoneMapExecBegin(pts);
 		if ((pts->xpu_task_flags & DEVKIND__NVIDIA_GPU) != 0)
-			pts->optimal_gpus = GetOptimalGpuForRelation(rel);
+		{
+			/* GpuCache is resident on a particular device (and replicas) */
+			if (pts->gcache_desc)
+				pts->optimal_gpus = getGpuCacheDescDevices(pts->gcache_desc);
+			else
+				pts->optimal_gpus = GetOptimalGpuForRelation(rel);
+		}
 		if ((pts->xpu_task_flags & DEVKIND__NVIDIA_DPU) != 0)
 			pts->ds_entry = GetOptimalDpuForRelation(rel, &kds_pathname);
 		pts->kds_pathname = kds_pathname;
@@ -1479,11 +2812,18 @@ pgstromExecInitTaskState(CustomScanState *node, EState *estate, int eflags)
 	ExecInitScanTupleSlot(estate, &pts->css.ss, tupdesc_dst,
 						  &TTSOpsHeapTuple);
 	ExecAssignScanProjectionInfoWithVarno(&pts->css.ss, INDEX_VAR);
+	pts->columnar_results = __columnarResultsAvailable(pts, tupdesc_dst);
 
 	/*
 	 * Initialize the CPU Fallback stuff
+	 *
+	 * Fallback tuples are processed in batches on the fallback buffer, so
+	 * JIT compiled quals/projection (and tuple deforming on the fixed slot
+	 * ops) are worthwhile if the expected volume is large enough.
 	 */
+	jit_saved_flags = __execFallbackJitBegin(pts);
 	__execInitTaskStateCpuFallback(pts);
+	__execFallbackJitEnd(pts, jit_saved_flags);
 	
 	/*
 	 * init inner relations
@@ -1500,10 +2840,16 @@ pgstromExecInitTaskState(CustomScanState *node, EState *estate, int eflags)
 		istate->econtext = CreateExprContext(estate);
 		istate->depth = depth_index + 1;
 		istate->join_type = pp_inner->join_type;
+		istate->inner_nparts = pp_inner->inner_nparts;
+		if (pp_inner->inner_nparts > 1)
+			pts->num_inner_parts = Max(pts->num_inner_parts,
+									   pp_inner->inner_nparts);
+		jit_saved_flags = __execFallbackJitBegin(pts);
 		istate->join_quals = ExecInitQual(pp_inner->join_quals_fallback,
 										  &pts->css.ss.ps);
 		istate->other_quals = ExecInitQual(pp_inner->other_quals_fallback,
 										   &pts->css.ss.ps);
+		__execFallbackJitEnd(pts, jit_saved_flags);
 		if (pp_inner->join_type == JOIN_FULL ||
 			pp_inner->join_type == JOIN_RIGHT)
 			has_right_outer = true;
@@ -1539,6 +2885,82 @@ pgstromExecInitTaskState(CustomScanState *node, EState *estate, int eflags)
 			istate->hash_inner_funcs = lappend(istate->hash_inner_funcs,
 											   dtype->type_hashfunc);
 		}
+		/* grid-join computes the cell numbers from the inner geometry */
+		if (pp_inner->grid_cell_size > 0.0)
+		{
+			Node	   *inner_key = linitial(pp_inner->hash_inner_keys_fallback);
+			Oid			geom_type = exprType(inner_key);
+			Oid			box3d_type;
+			Oid			func_oid;
+			char	   *nsp_name;
+			devtype_info *dtype;
+			const char *extent_fnames[4] = {"st_xmin", "st_ymin",
+											"st_xmax", "st_ymax"};
+
+			Assert(list_length(pp_inner->hash_inner_keys_fallback) == 1);
+			nsp_name = get_namespace_name(get_type_namespace(geom_type));
+			if (!nsp_name)
+				elog(ERROR, "cache lookup failed for namespace of type %u",
+					 geom_type);
+			func_oid = LookupFuncName(list_make2(makeString(nsp_name),
+												 makeString("box3d")),
+									  1, &geom_type, false);
+			fmgr_info(func_oid, &istate->grid_fn_box3d);
+			box3d_type = get_func_rettype(func_oid);
+			for (int k=0; k < 4; k++)
+			{
+				func_oid = LookupFuncName(list_make2(makeString(nsp_name),
+													 makeString((char *)extent_fnames[k])),
+										  1, &box3d_type, false);
+				fmgr_info(func_oid, &istate->grid_fn_extent[k]);
+			}
+			dtype = pgstrom_devtype_lookup(FLOAT8OID);
+			if (!dtype)
+				elog(ERROR, "failed on lookup device type of float8");
+			list_free(istate->hash_inner_funcs);
+			istate->hash_inner_funcs = list_make2(dtype->type_hashfunc,
+												  dtype->type_hashfunc);
+			istate->grid_cell_size = pp_inner->grid_cell_size;
+			istate->grid_expand = pp_inner->grid_expand;
+		}
+		/*
+		 * single integer hash-key is a candidate of the direct-address map;
+		 * see __execGpuJoinRangeJoinKey() for the key types on the device.
+		 */
+		if (list_length(pp_inner->hash_outer_keys_fallback) == 1 &&
+			list_length(pp_inner->hash_inner_keys_fallback) == 1 &&
+			pp_inner->grid_cell_size <= 0.0 &&
+			pp_inner->inner_nparts <= 1)
+		{
+			Oid		outer_type = exprType(linitial(pp_inner->hash_outer_keys_fallback));
+			Oid		inner_type = exprType(linitial(pp_inner->hash_inner_keys_fallback));
+
+			if ((outer_type == INT2OID ||
+				 outer_type == INT4OID ||
+				 outer_type == INT8OID ||
+				 outer_type == DATEOID) &&
+				(inner_type == INT2OID ||
+				 inner_type == INT4OID ||
+				 inner_type == INT8OID ||
+				 inner_type == DATEOID))
+				istate->direct_key_type = inner_type;
+		}
+		/* range-join evaluates the inner bounds on the range-index build */
+		foreach (cell, pp_inner->range_inner_keys_fallback)
+		{
+			Node	   *inner_key = (Node *)lfirst(cell);
+			ExprState  *es;
+
+			es = ExecInitExpr((Expr *)inner_key, &pts->css.ss.ps);
+			istate->range_inner_keys = lappend(istate->range_inner_keys, es);
+			istate->range_inner_types = lappend_oid(istate->range_inner_types,
+													exprType(inner_key));
+		}
+		/* polygon-index evaluates the inner geometry on the preloading */
+		if (pp_inner->polygon_inner_key_fallback)
+			istate->polygon_inner_key =
+				ExecInitExpr(pp_inner->polygon_inner_key_fallback,
+							 &pts->css.ss.ps);
 
 		if (OidIsValid(pp_inner->gist_index_oid))
 		{
@@ -1574,6 +2996,16 @@ pgstromExecInitTaskState(CustomScanState *node, EState *estate, int eflags)
 									  tupdesc_dst,
 									  KDS_FORMAT_COLUMN);
 	}
+	else if (pp_info->dpu_prefilter_quals != NIL &&	/* DPU pre-filter */
+			 __execInitDpuPreFilter(pts, tupdesc_src))
+	{
+		pts->cb_next_chunk = pgstromRelScanChunkDpuRelay;
+		pts->cb_next_tuple = pgstromScanNextTuple;
+		__setupTaskStateRequestBuffer(pts,
+									  tupdesc_src,
+									  tupdesc_dst,
+									  KDS_FORMAT_ROW);
+	}
 	else if (!bms_is_empty(pts->optimal_gpus) ||	/* GPU-Direct SQL */
 			 pts->ds_entry)							/* DPU Storage */
 	{
@@ -1584,6 +3016,15 @@ pgstromExecInitTaskState(CustomScanState *node, EState *estate, int eflags)
 									  tupdesc_dst,
 									  KDS_FORMAT_BLOCK);
 	}
+	else if (pgstromRelScanUringAvailable(pts))	/* io_uring reader */
+	{
+		pts->cb_next_chunk = pgstromRelScanChunkUring;
+		pts->cb_next_tuple = pgstromScanNextTuple;
+		__setupTaskStateRequestBuffer(pts,
+									  tupdesc_src,
+									  tupdesc_dst,
+									  KDS_FORMAT_BLOCK);
+	}
 	else						/* Slow normal heap storage */
 	{
 		pts->cb_next_chunk = pgstromRelScanChunkNormal;
@@ -1604,7 +3045,10 @@ pgstromExecInitTaskState(CustomScanState *node, EState *estate, int eflags)
 	else if ((pts->xpu_task_flags & DEVTASK__JOIN) != 0)
 	{
 		if (has_right_outer)
+		{
 			pts->cb_final_chunk = pgstromExecFinalChunk;
+			pts->right_outer_on_device = GpuJoinRightOuterOnDevice(pts);
+		}
 		else
 			pts->cb_final_chunk = pgstromExecFinalChunkDummy;
 		pts->cb_cpu_fallback = ExecFallbackCpuJoin;
@@ -1618,6 +3062,197 @@ pgstromExecInitTaskState(CustomScanState *node, EState *estate, int eflags)
 		elog(ERROR, "Bug? unknown DEVTASK");
 	/* other fields init */
 	pts->curr_vm_buffer = InvalidBuffer;
+	/* siblings under the Append node, if any */
+	__execInitAsyncAppendGroup(pts, estate);
+}
+
+/*
+ * gpuSortMergeState
+ *
+ * State of the GpuSort without LIMIT (input of window functions). Every
+ * destination chunk is already sorted on the device, so the backend merges
+ * them by the binary-heap. CPU fallback tuples (and chunks that were not
+ * sorted due to device errors) are sorted by the tuplesort, then merged
+ * as one more sorted run.
+ */
+typedef struct
+{
+	kern_data_store *kds;		/* NULL, if fallback_sort */
+	uint32_t	index;
+	HeapTupleData htup;
+	Datum	   *values;
+	bool	   *isnull;
+} gpuSortMergeCursor;
+
+typedef struct gpuSortMergeState
+{
+	List	   *results;		/* copy of the XpuCommand (Success) */
+	TupleDesc	tupdesc;
+	int			nkeys;
+	SortSupport	ssup;
+	Tuplesortstate *fallback_sort;
+	TupleTableSlot *fallback_slot;
+	int			ncursors;
+	gpuSortMergeCursor *cursors;
+	gpuSortMergeCursor *curr;	/* the last one returned */
+	binaryheap *heap;			/* NULL during the fetch of results */
+} gpuSortMergeState;
+
+/*
+ * __fetchNextDpuPreFilterCommand
+ *
+ * It is a simplified version of __fetchNextXpuCommand for the DPU
+ * pre-filter, that has only one connection and no final chunks.
+ */
+static XpuCommand *
+__fetchNextDpuPreFilterCommand(pgstromTaskState *pts_dpu)
+{
+	XpuConnection  *conn = pts_dpu->conn;
+	XpuCommand	   *xcmd;
+	struct iovec	xcmd_iov[10];
+	int				xcmd_iovcnt;
+	int				ev;
+	int				max_async_tasks = pgstrom_max_async_tasks();
+
+	for (;;)
+	{
+		CHECK_FOR_INTERRUPTS();
+
+		ResetLatch(MyLatch);
+		pthreadMutexLock(&conn->mutex);
+		/* device error checks */
+		__xpuConnectRaiseErrorIfAny(conn);
+		if (!pts_dpu->scan_done &&
+			(conn->num_running_cmds + conn->num_ready_cmds) < max_async_tasks &&
+			(dlist_is_empty(&conn->ready_cmds_list) ||
+			 conn->num_running_cmds < max_async_tasks / 2))
+		{
+			pthreadMutexUnlock(&conn->mutex);
+			xcmd = pts_dpu->cb_next_chunk(pts_dpu, xcmd_iov, &xcmd_iovcnt);
+			if (xcmd)
+				xpuClientSendCommandIOV(conn, xcmd_iov, xcmd_iovcnt);
+			else
+				Assert(pts_dpu->scan_done);
+			continue;
+		}
+		if (!dlist_is_empty(&conn->ready_cmds_list))
+		{
+			xcmd = __pickupNextXpuCommand(conn);
+			pthreadMutexUnlock(&conn->mutex);
+			xcmd = __decompressXpuCommand(conn, xcmd);
+			__updateStatsDpuPreFilter(pts_dpu, xcmd);
+			return xcmd;
+		}
+		if (pts_dpu->scan_done && conn->num_running_cmds == 0)
+		{
+			pthreadMutexUnlock(&conn->mutex);
+			return NULL;
+		}
+		pthreadMutexUnlock(&conn->mutex);
+
+		ev = WaitLatch(MyLatch,
+					   WL_LATCH_SET |
+					   WL_TIMEOUT |
+					   WL_POSTMASTER_DEATH,
+					   1000L,
+					   PG_WAIT_EXTENSION);
+		if (ev & WL_POSTMASTER_DEATH)
+			ereport(FATAL,
+					(errcode(ERRCODE_ADMIN_SHUTDOWN),
+					 errmsg("Unexpected Postmaster dead")));
+	}
+}
+
+/*
+ * pgstromDpuPreFilterNextTuple
+ *
+ * It fetches the next tuple pre-filtered by the DPU, to be relayed to the
+ * GPU. The tuples fallen back to CPU are also relayed as is, because GPU
+ * evaluates the entire scan-quals again.
+ */
+bool
+pgstromDpuPreFilterNextTuple(pgstromTaskState *pts, TupleTableSlot *slot)
+{
+	pgstromTaskState *pts_dpu = pts->dpu_prefilter;
+	XpuCommand	   *resp;
+	instr_time		tv_fallback;
+	instr_time		tv_curr;
+
+	Assert(pts_dpu != NULL && pts_dpu->css.ss.ss_ScanTupleSlot == slot);
+	for (;;)
+	{
+		if (pgstromFetchFallbackTuple(pts_dpu))
+			return true;
+		resp = pts_dpu->curr_resp;
+		if (resp)
+		{
+			kern_data_store *kds = pts_dpu->curr_kds;
+
+			if (pts_dpu->curr_index < kds->nitems)
+			{
+				kern_tupitem *tupitem = KDS_GET_TUPITEM(kds, pts_dpu->curr_index++);
+
+				pts_dpu->curr_htup.t_len = tupitem->t_len;
+				ItemPointerCopy(&tupitem->htup.t_ctid,
+								&pts_dpu->curr_htup.t_self);
+				pts_dpu->curr_htup.t_tableOid = kds->table_oid;
+				pts_dpu->curr_htup.t_data = &tupitem->htup;
+				ExecStoreHeapTuple(&pts_dpu->curr_htup, slot, false);
+				return true;
+			}
+			if (++pts_dpu->curr_chunk < resp->u.results.chunks_nitems)
+			{
+				pts_dpu->curr_kds = (kern_data_store *)((char *)kds + kds->length);
+				pts_dpu->curr_index = 0;
+				continue;
+			}
+			xpuClientPutResponse(resp);
+			pts_dpu->curr_resp = NULL;
+		}
+
+		resp = __fetchNextDpuPreFilterCommand(pts_dpu);
+		if (!resp)
+			return (pgstromFetchFallbackTuple(pts_dpu) != NULL);
+		switch (resp->tag)
+		{
+			case XpuCommandTag__Success:
+				if (resp->u.results.chunks_nitems == 0)
+				{
+					xpuClientPutResponse(resp);
+					break;
+				}
+				pts_dpu->curr_resp = resp;
+				pts_dpu->curr_kds = (kern_data_store *)
+					((char *)resp + resp->u.results.chunks_offset);
+				pts_dpu->curr_chunk = 0;
+				pts_dpu->curr_index = 0;
+				break;
+
+			case XpuCommandTag__CPUFallback:
+				elog(pgstrom_cpu_fallback_elevel,
+					 "(%s:%d) CPU fallback due to %s [%s]",
+					 resp->u.fallback.error.filename,
+					 resp->u.fallback.error.lineno,
+					 resp->u.fallback.error.message,
+					 resp->u.fallback.error.funcname);
+				INSTR_TIME_SET_CURRENT(tv_fallback);
+				if (resp->u.fallback.kds_src.format == KDS_FORMAT_BLOCK)
+					ExecFallbackBlockDataStore(pts_dpu, &resp->u.fallback.kds_src);
+				else
+					elog(ERROR, "DPU pre-filter received unexpected KDS format (%c)",
+						 resp->u.fallback.kds_src.format);
+				INSTR_TIME_SET_CURRENT(tv_curr);
+				INSTR_TIME_SUBTRACT(tv_curr, tv_fallback);
+				pg_atomic_fetch_add_u64(&pts_dpu->ps_state->time_fallback_usec,
+										INSTR_TIME_GET_MICROSEC(tv_curr));
+				xpuClientPutResponse(resp);
+				break;
+
+			default:
+				elog(ERROR, "unknown response tag: %u", resp->tag);
+				break;
+		}
+	}
 }
 
 /*
@@ -1628,6 +3263,8 @@ pgstromExecScanAccess(pgstromTaskState *pts)
 {
 	TupleTableSlot *slot;
 	XpuCommand	   *resp;
+	instr_time		tv_fallback;
+	instr_time		tv_curr;
 
 	slot = pgstromFetchFallbackTuple(pts);
 	if (slot)
@@ -1647,10 +3284,25 @@ pgstromExecScanAccess(pgstromTaskState *pts)
 			case XpuCommandTag__Success:
 				if (resp->u.results.ojmap_offset != 0)
 					ExecFallbackCpuJoinOuterJoinMap(pts, resp);
-				if (resp->u.results.final_plan_node)
+				if (resp->u.results.final_plan_node &&
+					!resp->u.results.final_right_outer)
 					ExecFallbackCpuJoinRightOuter(pts);
 				if (resp->u.results.chunks_nitems == 0)
 					goto next_chunks;
+				if (pts->gpusort_merge && !pts->gpusort_merge->heap)
+				{
+					/*
+					 * GpuSort (full-sort) keeps the sorted chunks until the
+					 * end of the scan, so copies them out from the result
+					 * ring buffer not to block the GPU service.
+					 */
+					XpuCommand *temp = palloc(resp->length);
+
+					memcpy(temp, resp, resp->length);
+					pts->gpusort_merge->results =
+						lappend(pts->gpusort_merge->results, temp);
+					goto next_chunks;
+				}
 				pts->curr_kds = (kern_data_store *)
 					((char *)resp + resp->u.results.chunks_offset);
 				pts->curr_chunk = 0;
@@ -1664,6 +3316,7 @@ pgstromExecScanAccess(pgstromTaskState *pts)
 					 resp->u.fallback.error.lineno,
 					 resp->u.fallback.error.message,
 					 resp->u.fallback.error.funcname);
+				INSTR_TIME_SET_CURRENT(tv_fallback);
 				switch (resp->u.fallback.kds_src.format)
 				{
 					case KDS_FORMAT_ROW:
@@ -1683,6 +3336,10 @@ pgstromExecScanAccess(pgstromTaskState *pts)
 							 resp->u.fallback.kds_src.format);
 						break;
 				}
+				INSTR_TIME_SET_CURRENT(tv_curr);
+				INSTR_TIME_SUBTRACT(tv_curr, tv_fallback);
+				pg_atomic_fetch_add_u64(&pts->ps_state->time_fallback_usec,
+										INSTR_TIME_GET_MICROSEC(tv_curr));
 				goto next_chunks;
 
 			default:
@@ -1694,6 +3351,340 @@ pgstromExecScanAccess(pgstromTaskState *pts)
 	return slot;
 }
 
+static void
+__gpusortMergeFetchKeys(gpuSortMergeState *ms,
+						kern_data_store *kds, uint32_t index,
+						HeapTuple htup, Datum *values, bool *isnull)
+{
+	kern_tupitem *tupitem = KDS_GET_TUPITEM(kds, index);
+
+	htup->t_len = tupitem->t_len;
+	memcpy(&htup->t_self, &tupitem->htup.t_ctid, sizeof(ItemPointerData));
+	htup->t_data = &tupitem->htup;
+	for (int j=0; j < ms->nkeys; j++)
+		values[j] = heap_getattr(htup, ms->ssup[j].ssup_attno,
+								 ms->tupdesc, &isnull[j]);
+}
+
+static int
+__gpusortMergeCompareKeys(gpuSortMergeState *ms,
+						  Datum *values_a, bool *isnull_a,
+						  Datum *values_b, bool *isnull_b)
+{
+	for (int j=0; j < ms->nkeys; j++)
+	{
+		int		comp = ApplySortComparator(values_a[j], isnull_a[j],
+										   values_b[j], isnull_b[j],
+										   &ms->ssup[j]);
+		if (comp != 0)
+			return comp;
+	}
+	return 0;
+}
+
+static bool
+__gpusortMergeCursorNext(gpuSortMergeState *ms, gpuSortMergeCursor *cur)
+{
+	if (cur->kds)
+	{
+		if (cur->index >= cur->kds->nitems)
+			return false;
+		__gpusortMergeFetchKeys(ms, cur->kds, cur->index++,
+								&cur->htup, cur->values, cur->isnull);
+	}
+	else
+	{
+		TupleTableSlot *slot = ms->fallback_slot;
+
+		if (!tuplesort_gettupleslot(ms->fallback_sort, true, false, slot, NULL))
+			return false;
+		for (int j=0; j < ms->nkeys; j++)
+			cur->values[j] = slot_getattr(slot, ms->ssup[j].ssup_attno,
+										  &cur->isnull[j]);
+	}
+	return true;
+}
+
+/* binaryheap is max-heap, so it inverts the comparison */
+static int
+__gpusortMergeHeapCompare(Datum a, Datum b, void *arg)
+{
+	gpuSortMergeCursor *cur_a = (gpuSortMergeCursor *)DatumGetPointer(a);
+	gpuSortMergeCursor *cur_b = (gpuSortMergeCursor *)DatumGetPointer(b);
+
+	return -__gpusortMergeCompareKeys((gpuSortMergeState *)arg,
+									  cur_a->values, cur_a->isnull,
+									  cur_b->values, cur_b->isnull);
+}
+
+/*
+ * __gpusortMergeCheckSorted
+ *
+ * The device sorting is not fatal even if any errors, so the backend process
+ * validates whether the chunk is actually sorted prior to the merge.
+ */
+static bool
+__gpusortMergeCheckSorted(gpuSortMergeState *ms, kern_data_store *kds)
+{
+	HeapTupleData htup;
+	Datum	   *values = alloca(sizeof(Datum) * 2 * ms->nkeys);
+	bool	   *isnull = alloca(sizeof(bool) * 2 * ms->nkeys);
+	int			curr = 0;
+
+	for (uint32_t i=0; i < kds->nitems; i++)
+	{
+		int		prev = (curr == 0 ? ms->nkeys : 0);
+
+		__gpusortMergeFetchKeys(ms, kds, i, &htup,
+								values + curr, isnull + curr);
+		if (i > 0 && __gpusortMergeCompareKeys(ms,
+											   values + prev, isnull + prev,
+											   values + curr, isnull + curr) > 0)
+			return false;
+		curr = prev;
+	}
+	return true;
+}
+
+static void
+__gpusortMergeRelease(pgstromTaskState *pts)
+{
+	gpuSortMergeState *ms = pts->gpusort_merge;
+
+	if (ms)
+	{
+		if (ms->fallback_sort)
+			tuplesort_end(ms->fallback_sort);
+		if (ms->fallback_slot)
+			ExecDropSingleTupleTableSlot(ms->fallback_slot);
+		list_free_deep(ms->results);
+		pts->gpusort_merge = NULL;
+	}
+}
+
+/*
+ * pgstromExecGpuSortMerge
+ */
+static TupleTableSlot *
+pgstromExecGpuSortMerge(pgstromTaskState *pts)
+{
+	pgstromPlanInfo *pp_info = pts->pp_info;
+	gpuSortMergeState *ms = pts->gpusort_merge;
+	gpuSortMergeCursor *cur;
+	TupleTableSlot *slot;
+
+	if (!ms)
+	{
+		TupleDesc	tupdesc = pts->css.ss.ss_ScanTupleSlot->tts_tupleDescriptor;
+		int			nkeys = list_length(pp_info->gpusort_resnos);
+		AttrNumber *attnums = alloca(sizeof(AttrNumber) * nkeys);
+		Oid		   *sortops = alloca(sizeof(Oid) * nkeys);
+		Oid		   *collations = alloca(sizeof(Oid) * nkeys);
+		bool	   *nulls_first = alloca(sizeof(bool) * nkeys);
+		ListCell   *lc1, *lc2, *lc3, *lc4;
+		ListCell   *lc;
+		int			i = 0;
+
+		ms = palloc0(sizeof(gpuSortMergeState));
+		ms->tupdesc = tupdesc;
+		ms->nkeys = nkeys;
+		ms->ssup = palloc0(sizeof(SortSupportData) * nkeys);
+		forfour (lc1, pp_info->gpusort_resnos,
+				 lc2, pp_info->gpusort_sortops,
+				 lc3, pp_info->gpusort_collations,
+				 lc4, pp_info->gpusort_nulls_first)
+		{
+			SortSupport	ssup = &ms->ssup[i];
+
+			attnums[i] = lfirst_int(lc1);
+			sortops[i] = lfirst_oid(lc2);
+			collations[i] = lfirst_oid(lc3);
+			nulls_first[i] = (lfirst_int(lc4) != 0);
+
+			ssup->ssup_cxt = CurrentMemoryContext;
+			ssup->ssup_collation = collations[i];
+			ssup->ssup_nulls_first = nulls_first[i];
+			ssup->ssup_attno = attnums[i];
+			ssup->abbreviate = false;
+			PrepareSortSupportFromOrderingOp(sortops[i], ssup);
+			i++;
+		}
+		ms->fallback_sort = tuplesort_begin_heap(tupdesc,
+												 nkeys,
+												 attnums,
+												 sortops,
+												 collations,
+												 nulls_first,
+												 work_mem,
+												 NULL,
+												 TUPLESORT_NONE);
+		ms->fallback_slot = MakeSingleTupleTableSlot(tupdesc,
+													 &TTSOpsMinimalTuple);
+		pts->gpusort_merge = ms;
+
+		/*
+		 * Fetch all the results; pgstromExecScanAccess() keeps the sorted
+		 * chunks on ms->results, and returns only CPU fallback tuples.
+		 */
+		while (!TupIsNull(slot = pgstromExecScanAccess(pts)))
+		{
+			CHECK_FOR_INTERRUPTS();
+			tuplesort_puttupleslot(ms->fallback_sort, slot);
+		}
+
+		/* setup the merge cursors */
+		ms->ncursors = 1;
+		foreach (lc, ms->results)
+		{
+			XpuCommand *resp = lfirst(lc);
+
+			ms->ncursors += resp->u.results.chunks_nitems;
+		}
+		ms->cursors = palloc0(sizeof(gpuSortMergeCursor) * ms->ncursors);
+		i = 0;
+		foreach (lc, ms->results)
+		{
+			XpuCommand *resp = lfirst(lc);
+			kern_data_store *kds = (kern_data_store *)
+				((char *)resp + resp->u.results.chunks_offset);
+
+			for (int k=0; k < resp->u.results.chunks_nitems; k++)
+			{
+				CHECK_FOR_INTERRUPTS();
+				if (__gpusortMergeCheckSorted(ms, kds))
+					ms->cursors[i++].kds = kds;
+				else
+				{
+					/* sort it again on the host */
+					TupleTableSlot *ss_slot = pts->css.ss.ss_ScanTupleSlot;
+					HeapTupleData htup;
+
+					for (uint32_t j=0; j < kds->nitems; j++)
+					{
+						kern_tupitem *tupitem = KDS_GET_TUPITEM(kds, j);
+
+						htup.t_len = tupitem->t_len;
+						memcpy(&htup.t_self, &tupitem->htup.t_ctid,
+							   sizeof(ItemPointerData));
+						htup.t_data = &tupitem->htup;
+						ExecStoreHeapTuple(&htup, ss_slot, false);
+						tuplesort_puttupleslot(ms->fallback_sort, ss_slot);
+					}
+				}
+				kds = (kern_data_store *)((char *)kds + kds->length);
+			}
+		}
+		tuplesort_performsort(ms->fallback_sort);
+		/* the last cursor is the fallback_sort */
+		ms->ncursors = i + 1;
+		ms->heap = binaryheap_allocate(ms->ncursors,
+									   __gpusortMergeHeapCompare,
+									   ms);
+		for (i=0; i < ms->ncursors; i++)
+		{
+			cur = &ms->cursors[i];
+			if (i == ms->ncursors - 1)
+				cur->kds = NULL;
+			cur->values = palloc(sizeof(Datum) * nkeys);
+			cur->isnull = palloc(sizeof(bool) * nkeys);
+			if (__gpusortMergeCursorNext(ms, cur))
+				binaryheap_add_unordered(ms->heap, PointerGetDatum(cur));
+		}
+		binaryheap_build(ms->heap);
+	}
+	else if (ms->curr)
+	{
+		/* move forward the cursor that returned the last tuple */
+		if (__gpusortMergeCursorNext(ms, ms->curr))
+			binaryheap_replace_first(ms->heap, PointerGetDatum(ms->curr));
+		else
+			(void)binaryheap_remove_first(ms->heap);
+		ms->curr = NULL;
+	}
+
+	if (binaryheap_empty(ms->heap))
+		return NULL;
+	cur = (gpuSortMergeCursor *)DatumGetPointer(binaryheap_first(ms->heap));
+	ms->curr = cur;
+	if (!cur->kds)
+	{
+		slot = ms->fallback_slot;
+		slot_getallattrs(slot);
+		return slot;
+	}
+	pts->curr_htup = cur->htup;
+	slot = ExecStoreHeapTuple(&pts->curr_htup,
+							  pts->css.ss.ss_ScanTupleSlot,
+							  false);
+	slot_getallattrs(slot);
+	return slot;
+}
+
+/*
+ * pgstromExecGpuSortAccess
+ *
+ * It fetches all the results (top-K items of each chunk, if GpuSort) from
+ * the device, then merges them using the bounded tuplesort.
+ * If no limit (input of window functions), it merges the sorted chunks.
+ */
+static TupleTableSlot *
+pgstromExecGpuSortAccess(pgstromTaskState *pts)
+{
+	pgstromPlanInfo *pp_info = pts->pp_info;
+	TupleTableSlot *slot;
+
+	if (pp_info->gpusort_limit <= 0.0)
+		return pgstromExecGpuSortMerge(pts);
+	if (!pts->gpusort_state)
+	{
+		TupleDesc	tupdesc = pts->css.ss.ss_ScanTupleSlot->tts_tupleDescriptor;
+		int			nkeys = list_length(pp_info->gpusort_resnos);
+		AttrNumber *attnums = alloca(sizeof(AttrNumber) * nkeys);
+		Oid		   *sortops = alloca(sizeof(Oid) * nkeys);
+		Oid		   *collations = alloca(sizeof(Oid) * nkeys);
+		bool	   *nulls_first = alloca(sizeof(bool) * nkeys);
+		ListCell   *lc1, *lc2, *lc3, *lc4;
+		int			i = 0;
+
+		forfour (lc1, pp_info->gpusort_resnos,
+				 lc2, pp_info->gpusort_sortops,
+				 lc3, pp_info->gpusort_collations,
+				 lc4, pp_info->gpusort_nulls_first)
+		{
+			attnums[i] = lfirst_int(lc1);
+			sortops[i] = lfirst_oid(lc2);
+			collations[i] = lfirst_oid(lc3);
+			nulls_first[i] = (lfirst_int(lc4) != 0);
+			i++;
+		}
+		pts->gpusort_state = tuplesort_begin_heap(tupdesc,
+												  nkeys,
+												  attnums,
+												  sortops,
+												  collations,
+												  nulls_first,
+												  work_mem,
+												  NULL,
+												  TUPLESORT_NONE);
+		tuplesort_set_bound(pts->gpusort_state,
+							(int64)ceil(pp_info->gpusort_limit));
+		while (!TupIsNull(slot = pgstromExecScanAccess(pts)))
+		{
+			CHECK_FOR_INTERRUPTS();
+			tuplesort_puttupleslot(pts->gpusort_state, slot);
+		}
+		tuplesort_performsort(pts->gpusort_state);
+		if (!pts->gpusort_slot)
+			pts->gpusort_slot = MakeSingleTupleTableSlot(tupdesc,
+														 &TTSOpsMinimalTuple);
+	}
+	slot = pts->gpusort_slot;
+	if (!tuplesort_gettupleslot(pts->gpusort_state, true, false, slot, NULL))
+		return NULL;
+	slot_getallattrs(slot);
+	return slot;
+}
+
 /*
  * pgstromExecScanReCheck
  */
@@ -1773,9 +3764,364 @@ pgstromExecScanReCheck(pgstromTaskState *pts, EPQState *epqstate)
 		elog(ERROR, "RowMark on CustomScan(%s) is not implemented yet",
 			 pts->css.methods->CustomName);
 	}
+	if (pts->cpu_tiny_input)
+		return pgstromFetchFallbackTuple(pts);
 	return pgstromExecScanAccess(pts);
 }
 
+/*
+ * __pgstromExecTaskTinyInput
+ *
+ * It tries to process the whole outer relation by the CPU fallback routine,
+ * if it has only a few rows that does not pay the cost to open the session
+ * of the GPU/DPU service. It returns false if the relation turned out not
+ * to be tiny; then, the xPU continues to scan the rest of the relation.
+ */
+static bool
+__pgstromExecTaskTinyInput(pgstromTaskState *pts)
+{
+	Relation	relation = pts->css.ss.ss_currentRelation;
+	EState	   *estate = pts->css.ss.ps.state;
+	TableScanDesc scan;
+	uint64_t	nrows = 0;
+	int			threshold = pgstrom_cpu_fallback_tiny_input;
+
+	/*
+	 * Right now, only simple GpuScan/DpuScan on the heap relation are
+	 * the candidate. CPU fallback of JOIN still needs the inner buffer
+	 * preloaded, and PreAgg has no CPU fallback.
+	 */
+	if (threshold <= 0 ||
+		!relation ||
+		pts->num_rels > 0 ||
+		(pts->xpu_task_flags & DEVTASK__MASK) != DEVTASK__SCAN ||
+		pts->arrow_state ||
+		pts->gcache_desc ||
+		pts->br_state ||
+		pts->dpu_prefilter ||
+		pts->pp_info->gpusort_resnos != NIL)
+		return false;
+
+	/*
+	 * Direct (or io_uring) block reader has its own block cursor, so we
+	 * cannot peek the heap then hand over the rest of the relation.
+	 * In this case, we decide by the physical size of the relation.
+	 */
+	if (pts->cb_next_chunk != pgstromRelScanChunkNormal)
+	{
+		BlockNumber	nblocks = RelationGetNumberOfBlocks(relation);
+		double		density;
+
+		if (relation->rd_rel->relpages > 0 &&
+			relation->rd_rel->reltuples >= 0.0)
+			density = (relation->rd_rel->reltuples /
+					   (double)relation->rd_rel->relpages);
+		else
+			density = (double)MaxHeapTuplesPerPage;
+		if ((double)nblocks * density > (double)threshold)
+			return false;
+	}
+	/* attach pgstromSharedState, if none */
+	if (!pts->ps_state)
+		pgstromSharedStateInitDSM(&pts->css, NULL, NULL);
+	scan = pts->css.ss.ss_currentScanDesc;
+	while (table_scan_getnextslot(scan, estate->es_direction, pts->base_slot))
+	{
+		HeapTuple	tuple;
+		bool		should_free;
+
+		CHECK_FOR_INTERRUPTS();
+
+		tuple = ExecFetchSlotHeapTuple(pts->base_slot, false, &should_free);
+		pts->cb_cpu_fallback(pts, tuple);
+		if (should_free)
+			pfree(tuple);
+		if (++nrows > (uint64_t)threshold &&
+			pts->cb_next_chunk == pgstromRelScanChunkNormal)
+		{
+			/* not tiny; xPU continues the scan from the next row */
+			ExecClearTuple(pts->base_slot);
+			pg_atomic_fetch_add_u64(&pts->ps_state->source_ntuples_raw, nrows);
+			return false;
+		}
+	}
+	ExecClearTuple(pts->base_slot);
+	pg_atomic_fetch_add_u64(&pts->ps_state->source_ntuples_raw, nrows);
+	pts->scan_done = true;
+
+	return true;
+}
+
+/*
+ * xpuAsyncAppendGroup
+ *
+ * PostgreSQL runs the asynchronous Append only for the ForeignScan children,
+ * so the executor runs Gpu* children one by one. Instead, when a child under
+ * the (non-parallel) Append starts, it also opens the sessions of the next
+ * siblings and submits their first chunks, so these siblings make progress
+ * on the device while the Append is consuming the current child.
+ */
+typedef struct xpuAsyncAppendGroup
+{
+	List	   *members;		/* child plans of the Append */
+	pgstromTaskState **tasks;	/* array of the initialized tasks */
+} xpuAsyncAppendGroup;
+
+typedef struct
+{
+	EState	   *estate;
+	List	   *groups;			/* list of xpuAsyncAppendGroup */
+	MemoryContextCallback mcb;
+} xpuAsyncAppendCache;
+
+static xpuAsyncAppendCache *xpu_async_append_cache = NULL;
+
+static void
+__cleanupAsyncAppendCache(void *arg)
+{
+	if (xpu_async_append_cache == arg)
+		xpu_async_append_cache = NULL;
+}
+
+static void
+__collectAsyncAppendGroups(Plan *plan, List **p_groups)
+{
+	ListCell   *lc;
+
+	if (!plan)
+		return;
+	switch (nodeTag(plan))
+	{
+		case T_Append:
+			{
+				Append *aplan = (Append *)plan;
+
+				if (!aplan->plan.parallel_aware &&
+					!aplan->part_prune_info &&
+					list_length(aplan->appendplans) > 1)
+				{
+					xpuAsyncAppendGroup *group = palloc0(sizeof(xpuAsyncAppendGroup));
+					int		nitems = list_length(aplan->appendplans);
+
+					group->members = aplan->appendplans;
+					group->tasks = palloc0(sizeof(pgstromTaskState *) * nitems);
+					*p_groups = lappend(*p_groups, group);
+				}
+				foreach (lc, aplan->appendplans)
+					__collectAsyncAppendGroups(lfirst(lc), p_groups);
+			}
+			break;
+		case T_MergeAppend:
+			foreach (lc, ((MergeAppend *)plan)->mergeplans)
+				__collectAsyncAppendGroups(lfirst(lc), p_groups);
+			break;
+		case T_SubqueryScan:
+			__collectAsyncAppendGroups(((SubqueryScan *)plan)->subplan, p_groups);
+			break;
+		case T_CustomScan:
+			foreach (lc, ((CustomScan *)plan)->custom_plans)
+				__collectAsyncAppendGroups(lfirst(lc), p_groups);
+			break;
+		default:
+			break;
+	}
+	__collectAsyncAppendGroups(plan->lefttree, p_groups);
+	__collectAsyncAppendGroups(plan->righttree, p_groups);
+}
+
+static void
+__execInitAsyncAppendGroup(pgstromTaskState *pts, EState *estate)
+{
+	xpuAsyncAppendCache *cache = xpu_async_append_cache;
+	Plan	   *plan = pts->css.ss.ps.plan;
+	ListCell   *lc1, *lc2;
+
+	pts->async_group = NULL;
+	if (pgstrom_async_append_prefetch <= 0 ||
+		plan->parallel_aware ||
+		pts->dpu_prefilter ||
+		!estate->es_plannedstmt)
+		return;
+	if (!cache || cache->estate != estate)
+	{
+		MemoryContext oldcxt = MemoryContextSwitchTo(estate->es_query_cxt);
+
+		cache = palloc0(sizeof(xpuAsyncAppendCache));
+		cache->estate = estate;
+		__collectAsyncAppendGroups(estate->es_plannedstmt->planTree,
+								   &cache->groups);
+		foreach (lc1, estate->es_plannedstmt->subplans)
+			__collectAsyncAppendGroups(lfirst(lc1), &cache->groups);
+		cache->mcb.func = __cleanupAsyncAppendCache;
+		cache->mcb.arg = cache;
+		MemoryContextRegisterResetCallback(estate->es_query_cxt, &cache->mcb);
+		MemoryContextSwitchTo(oldcxt);
+
+		xpu_async_append_cache = cache;
+	}
+
+	foreach (lc1, cache->groups)
+	{
+		xpuAsyncAppendGroup *group = lfirst(lc1);
+
+		foreach (lc2, group->members)
+		{
+			if (lfirst(lc2) == plan)
+			{
+				group->tasks[foreach_current_index(lc2)] = pts;
+				pts->async_group = group;
+				return;
+			}
+		}
+	}
+}
+
+/*
+ * __pgstromExecTaskPrefetchChunks
+ *
+ * It submits the chunks to the device as long as the connections have margin
+ * to enqueue (and up to 'max_chunks' if positive), but does not wait for
+ * the responses.
+ */
+static void
+__pgstromExecTaskPrefetchChunks(pgstromTaskState *pts, int max_chunks)
+{
+	struct iovec	xcmd_iov[10];
+	int				xcmd_iovcnt;
+	int				max_async_tasks = pgstrom_max_async_tasks();
+	int				count = 0;
+
+	for (int i=0; i < pts->num_conns && !pts->scan_done; i++)
+	{
+		XpuConnection  *conn = pts->conns[i];
+
+		for (;;)
+		{
+			XpuCommand *xcmd;
+			bool		has_margin;
+
+			if (max_chunks > 0 && count >= max_chunks)
+				return;
+
+			pthreadMutexLock(&conn->mutex);
+			__xpuConnectRaiseErrorIfAny(conn);
+			has_margin = ((conn->num_running_cmds +
+						   conn->num_ready_cmds) < max_async_tasks / 2);
+			pthreadMutexUnlock(&conn->mutex);
+			if (!has_margin || pts->scan_done)
+				break;
+			if (pts->pp_info->scan_limit > 0.0)
+				break;		/* LIMIT may be satisfied by the prior siblings */
+			xcmd = pts->cb_next_chunk(pts, xcmd_iov, &xcmd_iovcnt);
+			if (!xcmd)
+			{
+				Assert(pts->scan_done);
+				break;
+			}
+			xpuClientSendCommandIOV(conn, xcmd_iov, xcmd_iovcnt);
+			count++;
+		}
+	}
+}
+
+/*
+ * __pgstromExecTaskKickSiblings
+ */
+static void
+__pgstromExecTaskKickSiblings(pgstromTaskState *pts)
+{
+	xpuAsyncAppendGroup *group = pts->async_group;
+	int			nitems = list_length(group->members);
+	int			curr = -1;
+	int			count = 0;
+
+	for (int i=0; i < nitems; i++)
+	{
+		if (group->tasks[i] == pts)
+		{
+			curr = i;
+			break;
+		}
+	}
+	Assert(curr >= 0);
+	for (int i=curr+1; i < nitems && count < pgstrom_async_append_prefetch; i++)
+	{
+		pgstromTaskState *sibling = group->tasks[i];
+
+		if (!sibling)
+			continue;	/* not a PG-Strom task */
+		count++;
+		if (sibling->conn || sibling->cpu_tiny_input)
+			continue;	/* already started */
+		pgstromTableSampleBegin(sibling);
+		if (__pgstromExecTaskTinyInput(sibling))
+			sibling->cpu_tiny_input = true;
+		else if (__pgstromExecTaskOpenConnection(sibling))
+			__pgstromExecTaskPrefetchChunks(sibling, 0);
+		sibling->async_started = true;
+	}
+}
+
+/*
+ * __xpuClientAttachInnerBuffer
+ *
+ * It informs the inner buffer to the session opened prior to the inner
+ * preloading. It has no response, so it is sent on the socket without
+ * the count of running commands.
+ */
+static void
+__xpuClientAttachInnerBuffer(XpuConnection *conn,
+							 uint32_t inner_handle,
+							 uint64_t inner_signature)
+{
+	XpuCommand	xcmd;
+	const char *buf = (const char *)&xcmd;
+	size_t		len = offsetof(XpuCommand, u.inner) + sizeof(kern_inner_attach);
+	ssize_t		nbytes;
+
+	memset(&xcmd, 0, len);
+	xcmd.magic = XpuCommandMagicNumber;
+	xcmd.tag = XpuCommandTag__AttachInnerBuffer;
+	xcmd.length = len;
+	xcmd.u.inner.join_inner_handle = inner_handle;
+	xcmd.u.inner.join_inner_signature = inner_signature;
+	while (len > 0)
+	{
+		nbytes = write(conn->sockfd, buf, len);
+		if (nbytes > 0)
+		{
+			buf += nbytes;
+			len -= nbytes;
+		}
+		else if (nbytes == 0)
+			elog(ERROR, "unable to send xPU command to the service");
+		else if (errno == EINTR)
+			CHECK_FOR_INTERRUPTS();
+		else
+			elog(ERROR, "failed on write(2): %m");
+	}
+}
+
+/*
+ * __pgstromExecTaskDeferInnerPreload
+ *
+ * GpuJoin with GPU-Direct SQL can open the session prior to the inner
+ * preloading, then the GPU service loads the first outer chunks onto the
+ * device during the (often long) preloading. Grace hash-join rescans the
+ * outer relation per inner partition, so it is not a candidate.
+ */
+static bool
+__pgstromExecTaskDeferInnerPreload(pgstromTaskState *pts)
+{
+	return (pgstrom_gpujoin_preload_prefetch > 0 &&
+			pts->num_rels > 0 &&
+			pts->num_inner_parts <= 1 &&
+			(pts->xpu_task_flags & DEVKIND__NVIDIA_GPU) != 0 &&
+			!pts->dpu_prefilter &&
+			(pts->cb_next_chunk == pgstromRelScanChunkDirect ||
+			 pts->cb_next_chunk == pgstromScanChunkArrowFdw));
+}
+
 /*
  * __pgstromExecTaskOpenConnection
  */
@@ -1790,7 +4136,8 @@ __pgstromExecTaskOpenConnection(pgstromTaskState *pts)
 	if (!pts->ps_state)
 		pgstromSharedStateInitDSM(&pts->css, NULL, NULL);
 	/* preload inner buffer, if any */
-	if (pts->num_rels > 0)
+	pts->inner_deferred = __pgstromExecTaskDeferInnerPreload(pts);
+	if (pts->num_rels > 0 && !pts->inner_deferred)
 	{
 		inner_handle = GpuJoinInnerPreload(pts);
 		if (inner_handle == 0)
@@ -1817,6 +4164,36 @@ __pgstromExecTaskOpenConnection(pgstromTaskState *pts)
 	{
 		elog(ERROR, "Bug? unknown PG-Strom task kind: %08x", pts->xpu_task_flags);
 	}
+	/* open the session of the DPU pre-filter, if any */
+	if (pts->dpu_prefilter)
+	{
+		pgstromTaskState *pts_dpu = pts->dpu_prefilter;
+
+		pts_dpu->ps_state = pts->ps_state;
+		pts_dpu->css.ss.ss_currentScanDesc = pts->css.ss.ss_currentScanDesc;
+		session = pgstromBuildSessionInfo(pts_dpu, 0, NULL);
+		DpuClientOpenSession(pts_dpu, session);
+	}
+	/*
+	 * Preload the inner buffer with the outer chunks in-flight, then
+	 * attach the inner buffer to the session. It has to be attached even
+	 * if the scan is already terminated, because the GPU service holds
+	 * the chunks until the attachment.
+	 */
+	if (pts->inner_deferred)
+	{
+		bool		scan_begun = pgstromTaskStateBeginScan(pts);
+
+		if (scan_begun)
+			__pgstromExecTaskPrefetchChunks(pts, pgstrom_gpujoin_preload_prefetch);
+		inner_handle = GpuJoinInnerPreload(pts);
+		for (int i=0; i < pts->num_conns; i++)
+			__xpuClientAttachInnerBuffer(pts->conns[i], inner_handle,
+										 pts->ps_state->preload_cache_signature);
+		if (inner_handle == 0)
+			pts->scan_done = true;
+		return (scan_begun && inner_handle != 0);
+	}
 	/* update the scan/join control variables */
 	if (!pgstromTaskStateBeginScan(pts))
 		return false;
@@ -1837,11 +4214,35 @@ pgstromExecTaskState(CustomScanState *node)
 	ProjectionInfo *proj_info = node->ss.ps.ps_ProjInfo;
 	TupleTableSlot *slot;
 
-	if (!pts->conn)
+	/* replay the cached result, if any */
+	if (!pts->rc_checked)
+	{
+		pts->rc_checked = true;
+		if (!estate->es_epq_active)
+			pts->rc_state = pgstromResultCacheBegin(pts);
+	}
+	if (pgstromResultCacheIsHit(pts->rc_state))
+		return pgstromResultCacheFetch(pts->rc_state,
+									   proj_info
+									   ? node->ss.ps.ps_ResultTupleSlot
+									   : node->ss.ss_ScanTupleSlot);
+
+	if (!pts->conn && !pts->cpu_tiny_input)
 	{
-		if (!__pgstromExecTaskOpenConnection(pts))
+		if (pts->async_started)
+			return NULL;	/* sibling already tried, but nothing to do */
+		pgstromTableSampleBegin(pts);
+		if (__pgstromExecTaskTinyInput(pts))
+			pts->cpu_tiny_input = true;
+		else if (!__pgstromExecTaskOpenConnection(pts))
 			return NULL;
-		Assert(pts->conn);
+		Assert(pts->conn || pts->cpu_tiny_input);
+	}
+	/* let the next siblings under the Append start on the device */
+	if (pts->async_group && !pts->async_kicked && !estate->es_epq_active)
+	{
+		pts->async_kicked = true;
+		__pgstromExecTaskKickSiblings(pts);
 	}
 
 	/*
@@ -1863,7 +4264,12 @@ pgstromExecTaskState(CustomScanState *node)
 
 	for (;;)
 	{
-		slot = pgstromExecScanAccess(pts);
+		if (pts->cpu_tiny_input)
+			slot = pgstromFetchFallbackTuple(pts);
+		else if (pts->pp_info->gpusort_resnos != NIL)
+			slot = pgstromExecGpuSortAccess(pts);
+		else
+			slot = pgstromExecScanAccess(pts);
 		if (TupIsNull(slot))
 			break;
 		/* check whether the current tuple satisfies the qual-clause */
@@ -1873,14 +4279,102 @@ pgstromExecTaskState(CustomScanState *node)
 		if (!host_quals || ExecQual(host_quals, econtext))
 		{
 			if (proj_info)
-				return ExecProject(proj_info);
+				slot = ExecProject(proj_info);
+			if (pts->rc_state)
+				pgstromResultCacheAppend(pts->rc_state, slot);
 			return slot;
 		}
 		InstrCountFiltered1(pts, 1);
 	}
+	if (pts->rc_state)
+		pgstromResultCacheFinish(pts->rc_state, pts);
 	return NULL;
 }
 
+/*
+ * pgstromTaskStateDeviceIndex - device of the primary connection, or -1
+ */
+int
+pgstromTaskStateDeviceIndex(pgstromTaskState *pts)
+{
+	return (pts->conn ? pts->conn->dev_index : -1);
+}
+
+/*
+ * __pgstromLogTaskStateProfile
+ *
+ * It logs the compact profile of the Gpu* node, if the statement runs longer
+ * than pg_strom.log_min_duration_profile, to catch GPU contention or CPU
+ * fallback storms after the fact. The counters are already collected by
+ * __updateStatsXpuCommand(), so only the elapsed time is checked here.
+ */
+static void
+__pgstromLogTaskStateProfile(pgstromTaskState *pts)
+{
+	pgstromSharedState *ps_state = pts->ps_state;
+	Relation	rel = pts->css.ss.ss_currentRelation;
+	TimestampTz	start_ts = GetCurrentStatementStartTimestamp();
+	TimestampTz	curr_ts;
+	uint64		inner_usage = 0;
+	StringInfoData buf;
+
+	if (pgstrom_log_min_duration_profile < 0 ||
+		!ps_state ||
+		IsParallelWorker())
+		return;
+	curr_ts = GetCurrentTimestamp();
+	if (!TimestampDifferenceExceeds(start_ts, curr_ts,
+									pgstrom_log_min_duration_profile))
+		return;
+
+	initStringInfo(&buf);
+	appendStringInfo(&buf, "%s", pts->css.methods->CustomName);
+	if (rel)
+		appendStringInfo(&buf, " on %s", RelationGetRelationName(rel));
+	appendStringInfo(&buf, " (node_id=%d, duration: %.3f ms):",
+					 pts->css.ss.ps.plan->plan_node_id,
+					 (double)(curr_ts - start_ts) / 1000.0);
+	if (pts->num_conns > 0)
+	{
+		appendStringInfo(&buf, " device=");
+		for (int i=0; i < pts->num_conns; i++)
+			appendStringInfo(&buf, "%s%s", (i > 0 ? "," : ""),
+							 pts->conns[i]->devname);
+	}
+	else if (pts->cpu_tiny_input)
+		appendStringInfo(&buf, " device=CPU(tiny-input)");
+	appendStringInfo(&buf, " chunks=%lu fallback=%lu",
+					 pg_atomic_read_u64(&ps_state->result_nchunks),
+					 pg_atomic_read_u64(&ps_state->fallback_nchunks));
+	appendStringInfo(&buf, " read[direct=%luKB vfs=%luKB buffer=%luKB]",
+					 pg_atomic_read_u64(&ps_state->npages_direct_read) * PAGE_SIZE / 1024,
+					 pg_atomic_read_u64(&ps_state->npages_vfs_read) * PAGE_SIZE / 1024,
+					 pg_atomic_read_u64(&ps_state->npages_buffer_read) * PAGE_SIZE / 1024);
+	/* number of tuples for each depth */
+	appendStringInfo(&buf, " nitems=%lu->%lu",
+					 pg_atomic_read_u64(&ps_state->source_ntuples_raw),
+					 pg_atomic_read_u64(&ps_state->source_ntuples_in));
+	for (int i=0; i < ps_state->num_rels; i++)
+	{
+		appendStringInfo(&buf, "->%lu",
+						 pg_atomic_read_u64(&ps_state->inners[i].stats_join));
+		inner_usage += pg_atomic_read_u64(&ps_state->inners[i].inner_usage);
+	}
+	appendStringInfo(&buf, "->%lu",
+					 pg_atomic_read_u64(&ps_state->result_ntuples));
+	appendStringInfo(&buf, " time[load=%.3fms kernel=%.3fms writeback=%.3fms fallback=%.3fms]",
+					 (double)pg_atomic_read_u64(&ps_state->time_load_usec) / 1000.0,
+					 (double)pg_atomic_read_u64(&ps_state->time_kernel_usec) / 1000.0,
+					 (double)pg_atomic_read_u64(&ps_state->time_writeback_usec) / 1000.0,
+					 (double)pg_atomic_read_u64(&ps_state->time_fallback_usec) / 1000.0);
+	if (ps_state->num_rels > 0)
+		appendStringInfo(&buf, " inner-buffer=%luKB", inner_usage / 1024);
+	ereport(LOG,
+			(errmsg("pg-strom profile: %s", buf.data),
+			 errhidecontext(true)));
+	pfree(buf.data);
+}
+
 /*
  * pgstromExecEndTaskState
  */
@@ -1891,10 +4385,26 @@ pgstromExecEndTaskState(CustomScanState *node)
 	pgstromSharedState *ps_state = pts->ps_state;
 	ListCell   *lc;
 
+	__pgstromLogTaskStateProfile(pts);
 	if (pts->curr_vm_buffer != InvalidBuffer)
 		ReleaseBuffer(pts->curr_vm_buffer);
-	if (pts->conn)
-		xpuClientCloseSession(pts->conn);
+	for (int i=0; i < pts->num_conns; i++)
+		xpuClientCloseSession(pts->conns[i]);
+	pgstromResultCacheEnd(pts->rc_state);
+	pts->rc_state = NULL;
+	if (pts->dpu_prefilter)
+	{
+		pgstromTaskState *pts_dpu = pts->dpu_prefilter;
+
+		if (pts_dpu->curr_vm_buffer != InvalidBuffer)
+			ReleaseBuffer(pts_dpu->curr_vm_buffer);
+		for (int i=0; i < pts_dpu->num_conns; i++)
+			xpuClientCloseSession(pts_dpu->conns[i]);
+		if (pts_dpu->fallback_store)
+			tuplestore_end(pts_dpu->fallback_store);
+		if (pts_dpu->fallback_store_slot)
+			ExecDropSingleTupleTableSlot(pts_dpu->fallback_store_slot);
+	}
 	if (pts->br_state)
 		pgstromBrinIndexExecEnd(pts);
 	if (pts->gcache_desc)
@@ -1903,6 +4413,15 @@ pgstromExecEndTaskState(CustomScanState *node)
 		pgstromArrowFdwExecEnd(pts->arrow_state);
 	if (pts->base_slot)
 		ExecDropSingleTupleTableSlot(pts->base_slot);
+	if (pts->gpusort_state)
+		tuplesort_end(pts->gpusort_state);
+	if (pts->gpusort_slot)
+		ExecDropSingleTupleTableSlot(pts->gpusort_slot);
+	__gpusortMergeRelease(pts);
+	if (pts->fallback_store)
+		tuplestore_end(pts->fallback_store);
+	if (pts->fallback_store_slot)
+		ExecDropSingleTupleTableSlot(pts->fallback_store_slot);
 	if (pts->css.ss.ss_currentScanDesc)
 		table_endscan(pts->css.ss.ss_currentScanDesc);
 	for (int i=0; i < pts->num_rels; i++)
@@ -1916,8 +4435,8 @@ pgstromExecEndTaskState(CustomScanState *node)
 		__munmapShmem(pts->h_kmrels);
 	if (!IsParallelWorker())
 	{
-		if (ps_state && ps_state->preload_shmem_handle != 0)
-			__shmemDrop(ps_state->preload_shmem_handle);
+		if (ps_state)
+			GpuJoinInnerCacheRelease(pts, ps_state);
 	}
 	foreach (lc, pts->css.custom_ps)
 		ExecEndNode((PlanState *) lfirst(lc));
@@ -1931,12 +4450,53 @@ pgstromExecResetTaskState(CustomScanState *node)
 {
 	pgstromTaskState *pts = (pgstromTaskState *) node;
 
-	if (pts->conn)
+	for (int i=0; i < pts->num_conns; i++)
+		xpuClientCloseSession(pts->conns[i]);
+	pts->conn = NULL;
+	pts->num_conns = 0;
+	pts->final_plan_pending = false;
+	pts->cpu_tiny_input = false;
+	pts->async_kicked = false;
+	pts->async_started = false;
+	pts->scan_done = false;
+	/* TABLESAMPLE arguments are evaluated again, like SampleScan */
+	pts->tablesample_ready = false;
+	/* result cache is not used on rescan */
+	pgstromResultCacheEnd(pts->rc_state);
+	pts->rc_state = NULL;
+	pts->rc_checked = true;
+	if (pts->dpu_prefilter)
 	{
-		xpuClientCloseSession(pts->conn);
-		pts->conn = NULL;
+		pgstromTaskState *pts_dpu = pts->dpu_prefilter;
+
+		if (pts_dpu->curr_resp)
+			xpuClientPutResponse(pts_dpu->curr_resp);
+		pts_dpu->curr_resp = NULL;
+		for (int i=0; i < pts_dpu->num_conns; i++)
+			xpuClientCloseSession(pts_dpu->conns[i]);
+		pts_dpu->conn = NULL;
+		pts_dpu->num_conns = 0;
+		pts_dpu->scan_done = false;
+		pts_dpu->curr_block_num = 0;
+		pts_dpu->fallback_index = 0;
+		pts_dpu->fallback_nitems = 0;
+		pts_dpu->fallback_usage = 0;
+		if (pts_dpu->fallback_store)
+			tuplestore_clear(pts_dpu->fallback_store);
 	}
 	pgstromTaskStateResetScan(pts);
+	if (pts->gpusort_state)
+	{
+		tuplesort_end(pts->gpusort_state);
+		pts->gpusort_state = NULL;
+	}
+	__gpusortMergeRelease(pts);
+	/* discard the pending fallback tuples */
+	pts->fallback_index = 0;
+	pts->fallback_nitems = 0;
+	pts->fallback_usage = 0;
+	if (pts->fallback_store)
+		tuplestore_clear(pts->fallback_store);
 	if (pts->br_state)
 		pgstromBrinIndexExecReset(pts);
 	if (pts->arrow_state)
@@ -2055,7 +4615,7 @@ pgstromSharedStateInitDSM(CustomScanState *node,
 	ps_state->num_rels = num_rels;
 	ConditionVariableInit(&ps_state->preload_cond);
 	SpinLockInit(&ps_state->preload_mutex);
-	if (num_rels > 0)
+	if (num_rels > 0 && !GpuJoinInnerCacheLookup(pts, ps_state))
 		ps_state->preload_shmem_handle = __shmemCreate(pts->ds_entry);
 	pts->ps_state = ps_state;
 	pts->css.ss.ss_currentScanDesc = scan;
@@ -2171,15 +4731,19 @@ pgstromGpuDirectExplain(pgstromTaskState *pts,
 	}
 	else
 	{
-		XpuConnection  *conn = pts->conn;
 		uint64			count;
 		int				pos;
 
 		appendStringInfo(&buf, "%s (", (bms_is_empty(pts->optimal_gpus)
 										? "disabled"
 										: "enabled"));
-		if (!pgstrom_regression_test_mode)
-			appendStringInfo(&buf, "%s; ", conn->devname);
+		if (!pgstrom_regression_test_mode && pts->num_conns > 0)
+		{
+			for (int i=0; i < pts->num_conns; i++)
+				appendStringInfo(&buf, "%s%s", (i > 0 ? ", " : ""),
+								 pts->conns[i]->devname);
+			appendStringInfo(&buf, "; ");
+		}
 		pos = buf.len;
 
 		count = pg_atomic_read_u64(&ps_state->npages_buffer_read);
@@ -2205,6 +4769,48 @@ pgstromGpuDirectExplain(pgstromTaskState *pts,
 	}
 	ExplainPropertyText("GPU-Direct SQL", buf.data, es);
 
+	/* latency and throughput of GPU-Direct reads, if required */
+	if (es->analyze && ps_state && pgstrom_explain_gpudirect_io)
+	{
+		uint64		nr_ios = pg_atomic_read_u64(&ps_state->gpudirect_nr_ios);
+		uint64		usec_io = pg_atomic_read_u64(&ps_state->gpudirect_usec_io);
+		uint64		nr_bytes;
+
+		if (nr_ios > 0)
+		{
+			nr_bytes = (pg_atomic_read_u64(&ps_state->npages_direct_read) +
+						pg_atomic_read_u64(&ps_state->npages_vfs_read)) * PAGE_SIZE;
+			resetStringInfo(&buf);
+			appendStringInfo(&buf, "nr_ios=%lu, avg=%.3fms, max=%.3fms",
+							 nr_ios,
+							 (double)usec_io / (1000.0 * (double)nr_ios),
+							 (double)pg_atomic_read_u64(&ps_state->gpudirect_usec_max) / 1000.0);
+			if (usec_io > 0)
+				appendStringInfo(&buf, ", throughput=%.1fMB/s",
+								 (double)nr_bytes / (double)usec_io);
+			ExplainPropertyText("GPU-Direct I/O", buf.data, es);
+
+			resetStringInfo(&buf);
+			for (int k=0; k < GPUDIRECT_IO_HIST_NBUCKETS; k++)
+			{
+				uint64	count = pg_atomic_read_u64(&ps_state->gpudirect_io_hist[k]);
+				uint64	upper = GPUDIRECT_IO_HIST_UPPER(k);
+
+				if (count == 0)
+					continue;
+				if (buf.len > 0)
+					appendStringInfo(&buf, ", ");
+				if (k == GPUDIRECT_IO_HIST_NBUCKETS - 1)
+					appendStringInfo(&buf, ">=%lums: %lu",
+									 GPUDIRECT_IO_HIST_UPPER(k - 1) / 1000, count);
+				else if (upper < 1000)
+					appendStringInfo(&buf, "<%luus: %lu", upper, count);
+				else
+					appendStringInfo(&buf, "<%lums: %lu", upper / 1000, count);
+			}
+			ExplainPropertyText("GPU-Direct I/O Latency", buf.data, es);
+		}
+	}
 	pfree(buf.data);
 }
 
@@ -2258,6 +4864,71 @@ pgstromExplainTaskState(CustomScanState *node,
 			 "%s Projection", xpu_label);
 	ExplainPropertyText(label, buf.data, es);
 
+	/* xPU Sort (top-K) */
+	if (pp_info->gpusort_resnos != NIL)
+	{
+		ListCell   *lc1, *lc2, *lc3;
+
+		resetStringInfo(&buf);
+		forthree (lc1, pp_info->gpusort_resnos,
+				  lc2, pp_info->gpusort_descending,
+				  lc3, pp_info->gpusort_nulls_first)
+		{
+			TargetEntry *tle = list_nth(cscan->custom_scan_tlist,
+										lfirst_int(lc1) - 1);
+			bool	sort_desc = (lfirst_int(lc2) != 0);
+			bool	nulls_first = (lfirst_int(lc3) != 0);
+
+			str = deparse_expression((Node *)tle->expr, dcontext, verbose, true);
+			if (buf.len > 0)
+				appendStringInfoString(&buf, ", ");
+			appendStringInfoString(&buf, str);
+			if (sort_desc)
+				appendStringInfoString(&buf, " DESC");
+			if (nulls_first != sort_desc)
+				appendStringInfoString(&buf, nulls_first
+									   ? " NULLS FIRST"
+									   : " NULLS LAST");
+		}
+		if (pp_info->gpusort_limit > 0.0)
+			appendStringInfo(&buf, " [top-K: %.0f]", pp_info->gpusort_limit);
+		else
+			appendStringInfoString(&buf, " [merge]");
+		snprintf(label, sizeof(label), "%s Sort Keys", xpu_label);
+		ExplainPropertyText(label, buf.data, es);
+	}
+	/* LIMIT clause */
+	if (pp_info->scan_limit > 0.0)
+	{
+		snprintf(label, sizeof(label), "%s Scan Limit", xpu_label);
+		ExplainPropertyFloat(label, NULL, pp_info->scan_limit, 0, es);
+	}
+	/* TABLESAMPLE clause */
+	if (pp_info->tablesample_method != TABLESAMPLE_METHOD__NONE)
+	{
+		resetStringInfo(&buf);
+		appendStringInfoString(&buf, (pp_info->tablesample_method ==
+									  TABLESAMPLE_METHOD__SYSTEM
+									  ? "system" : "bernoulli"));
+		foreach (lc, pp_info->tablesample_args)
+		{
+			str = deparse_expression(lfirst(lc), dcontext, verbose, false);
+			appendStringInfo(&buf, "%s%s",
+							 foreach_current_index(lc) == 0 ? " (" : ", ",
+							 str);
+		}
+		if (pp_info->tablesample_args != NIL)
+			appendStringInfoChar(&buf, ')');
+		if (pp_info->tablesample_repeatable)
+		{
+			str = deparse_expression((Node *)pp_info->tablesample_repeatable,
+									 dcontext, verbose, false);
+			appendStringInfo(&buf, " REPEATABLE (%s)", str);
+		}
+		snprintf(label, sizeof(label), "%s Sampling", xpu_label);
+		ExplainPropertyText(label, buf.data, es);
+	}
+
 	/* xPU Scan Quals */
 	if (ps_state)
 		stat_ntuples = pg_atomic_read_u64(&ps_state->source_ntuples_in);
@@ -2293,7 +4964,72 @@ pgstromExplainTaskState(CustomScanState *node,
 		}
 		snprintf(label, sizeof(label), "%s Scan Quals", xpu_label);
 		ExplainPropertyText(label, buf.data, es);
+
+		/* the final order of adaptive scan-quals, if any */
+		if (es->analyze && ps_state &&
+			list_length(scan_quals) <= KERN_ADAPTIVE_QUALS_MAX &&
+			pg_atomic_read_u64(&ps_state->scan_quals_order) != 0)
+		{
+			uint64_t	order = pg_atomic_read_u64(&ps_state->scan_quals_order);
+
+			resetStringInfo(&buf);
+			for (int k=0; k < list_length(scan_quals); k++)
+			{
+				int			i = (order >> (4 * k)) & 0x0fU;
+				uint64_t	nevals;
+				uint64_t	npassed;
+
+				if (i >= list_length(scan_quals))
+					break;
+				nevals = pg_atomic_read_u64(&ps_state->scan_quals_nevals[i]);
+				npassed = pg_atomic_read_u64(&ps_state->scan_quals_npassed[i]);
+				str = deparse_expression(list_nth(scan_quals, i),
+										 dcontext, verbose, true);
+				if (buf.len > 0)
+					appendStringInfoString(&buf, ", ");
+				appendStringInfo(&buf, "%s [exec: %lu -> %lu]",
+								 str, nevals, npassed);
+			}
+			snprintf(label, sizeof(label), "%s Scan Quals Order", xpu_label);
+			ExplainPropertyText(label, buf.data, es);
+		}
+	}
+
+	/* DPU Pre-Filter */
+	if (pts->dpu_prefilter)
+	{
+		List   *dpu_quals = pp_info->dpu_prefilter_quals;
+		Expr   *expr;
+
+		resetStringInfo(&buf);
+		if (list_length(dpu_quals) > 1)
+			expr = make_andclause(dpu_quals);
+		else
+			expr = linitial(dpu_quals);
+		str = deparse_expression((Node *)expr, dcontext, verbose, true);
+		appendStringInfoString(&buf, str);
+		if (!es->analyze || !ps_state)
+		{
+			appendStringInfo(&buf, " [rows: %.0f -> %.0f]",
+							 pp_info->scan_tuples,
+							 pp_info->dpu_prefilter_nrows);
+		}
+		else
+		{
+			appendStringInfo(&buf, " [plan: %.0f -> %.0f, exec: %lu -> %lu]",
+							 pp_info->scan_tuples,
+							 pp_info->dpu_prefilter_nrows,
+							 pg_atomic_read_u64(&ps_state->source_ntuples_raw),
+							 pg_atomic_read_u64(&ps_state->dpu_prefilter_nitems));
+		}
+		ExplainPropertyText("DPU Pre-Filter", buf.data, es);
 	}
+	if (es->analyze && pts->cpu_tiny_input)
+		ExplainPropertyText("Tiny Input", "processed by CPU", es);
+	if (es->analyze && pgstromResultCacheIsHit(pts->rc_state))
+		ExplainPropertyText("Result Cache", "hit", es);
+	if (es->verbose && pts->columnar_results)
+		ExplainPropertyText("Result Format", "columnar", es);
 
 	/* xPU JOIN */
 	ntuples = pp_info->scan_rows;
@@ -2387,6 +5123,21 @@ pgstromExplainTaskState(CustomScanState *node,
 					appendStringInfoString(&buf, ", ");
 				appendStringInfoString(&buf, str);
 			}
+			if (pp_inner->grid_cell_size > 0.0)
+				appendStringInfo(&buf, " (grid: cell=%g, expand=%g)",
+								 pp_inner->grid_cell_size,
+								 pp_inner->grid_expand);
+			if (pp_inner->inner_nparts > 1)
+				appendStringInfo(&buf, " (%d partitions)", pp_inner->inner_nparts);
+			if (es->analyze && ps_state &&
+				pg_atomic_read_u64(&ps_state->inners[i].skew_nkeys) > 0)
+				appendStringInfo(&buf, " [skew: %lu heavy keys, max %lu dups]",
+								 pg_atomic_read_u64(&ps_state->inners[i].skew_nkeys),
+								 pg_atomic_read_u64(&ps_state->inners[i].skew_max_dups));
+			if (es->analyze && ps_state &&
+				pg_atomic_read_u64(&ps_state->inners[i].dmap_nslots) > 0)
+				appendStringInfo(&buf, " [direct map: %lu slots]",
+								 pg_atomic_read_u64(&ps_state->inners[i].dmap_nslots));
 			snprintf(label, sizeof(label),
 					 "%s Inner Hash [%d]", xpu_label, i+1);
 			ExplainPropertyText(label, buf.data, es);
@@ -2412,6 +5163,30 @@ pgstromExplainTaskState(CustomScanState *node,
 					 "%s GiST Join [%d]", xpu_label, i+1);
 			ExplainPropertyText(label, buf.data, es);
 		}
+		if (pp_inner->range_outer_keys != NIL)
+		{
+			resetStringInfo(&buf);
+			str = deparse_expression(linitial(pp_inner->range_outer_keys),
+									 dcontext, verbose, true);
+			appendStringInfo(&buf, "%s in [", str);
+			str = deparse_expression(linitial(pp_inner->range_inner_keys),
+									 dcontext, verbose, true);
+			appendStringInfo(&buf, "%s, ", str);
+			str = deparse_expression(lsecond(pp_inner->range_inner_keys),
+									 dcontext, verbose, true);
+			appendStringInfo(&buf, "%s]", str);
+			snprintf(label, sizeof(label),
+					 "%s Range Join [%d]", xpu_label, i+1);
+			ExplainPropertyText(label, buf.data, es);
+		}
+		if (pp_inner->polygon_inner_key)
+		{
+			str = deparse_expression((Node *)pp_inner->polygon_inner_key,
+									 dcontext, verbose, false);
+			snprintf(label, sizeof(label),
+					 "%s Polygon Index [%d]", xpu_label, i+1);
+			ExplainPropertyText(label, str, es);
+		}
 	}
 
 	/*
@@ -2429,6 +5204,11 @@ pgstromExplainTaskState(CustomScanState *node,
 		/* GPU-Cache */
 		pgstromGpuCacheExplain(pts, es, dcontext);
 	}
+	else if (pts->dpu_prefilter)
+	{
+		/* DPU-Entry of the pre-filter */
+		explainDpuStorageEntry(pts->dpu_prefilter->ds_entry, es);
+	}
 	else if (!bms_is_empty(pts->optimal_gpus))
 	{
 		/* GPU-Direct */
@@ -2438,14 +5218,61 @@ pgstromExplainTaskState(CustomScanState *node,
 	{
 		/* DPU-Entry */
 		explainDpuStorageEntry(pts->ds_entry, es);
+		if (es->analyze && ps_state && !pgstrom_regression_test_mode)
+		{
+			uint64_t	nhits = pg_atomic_read_u64(&ps_state->npages_dpucache_hit);
+			uint64_t	nreads = pg_atomic_read_u64(&ps_state->npages_vfs_read);
+
+			if (nhits + nreads > 0)
+			{
+				resetStringInfo(&buf);
+				appendStringInfo(&buf, "hit=%lu, read=%lu",
+								 nhits / PAGES_PER_BLOCK,
+								 nreads / PAGES_PER_BLOCK);
+				ExplainPropertyText("DPU Block Cache", buf.data, es);
+			}
+		}
 	}
 	else
 	{
 		/* Normal Heap Storage */
 	}
+	/* Time breakdown of GPU tasks */
+	if ((pts->xpu_task_flags & DEVKIND__NVIDIA_GPU) != 0 &&
+		es->analyze && es->timing && ps_state &&
+		!pgstrom_regression_test_mode)
+	{
+		resetStringInfo(&buf);
+		appendStringInfo(&buf, "load: %.3fms, kernel: %.3fms, writeback: %.3fms",
+						 (double)pg_atomic_read_u64(&ps_state->time_load_usec) / 1000.0,
+						 (double)pg_atomic_read_u64(&ps_state->time_kernel_usec) / 1000.0,
+						 (double)pg_atomic_read_u64(&ps_state->time_writeback_usec) / 1000.0);
+		if (pg_atomic_read_u64(&ps_state->time_fallback_usec) > 0)
+			appendStringInfo(&buf, ", fallback: %.3fms",
+							 (double)pg_atomic_read_u64(&ps_state->time_fallback_usec) / 1000.0);
+		snprintf(label, sizeof(label), "%s Time", xpu_label);
+		ExplainPropertyText(label, buf.data, es);
+	}
+	/* Kernel geometry chosen by the GPU service */
+	if ((pts->xpu_task_flags & DEVKIND__NVIDIA_GPU) != 0 &&
+		es->analyze && es->verbose && ps_state &&
+		pg_atomic_read_u32(&ps_state->kernel_block_sz) > 0 &&
+		!pgstrom_regression_test_mode)
+	{
+		resetStringInfo(&buf);
+		appendStringInfo(&buf, "grid: %u, block: %u, shmem: %u",
+						 pg_atomic_read_u32(&ps_state->kernel_grid_sz),
+						 pg_atomic_read_u32(&ps_state->kernel_block_sz),
+						 pg_atomic_read_u32(&ps_state->kernel_shmem_sz));
+		snprintf(label, sizeof(label), "%s Kernel Geometry", xpu_label);
+		ExplainPropertyText(label, buf.data, es);
+	}
 	/* State of BRIN-index */
 	if (pts->br_state)
 		pgstromBrinIndexExplain(pts, dcontext, es);
+	/* State of zone map */
+	if (pts->zm_state)
+		pgstromZoneMapExplain(pts, es);
 
 	/*
 	 * Dump the XPU code (only if verbose)
@@ -2494,6 +5321,123 @@ pgstromExplainTaskState(CustomScanState *node,
 	pfree(buf.data);
 }
 
+/*
+ * __xpuClientAttachConnection
+ */
+static void
+__xpuClientAttachConnection(pgstromTaskState *pts, XpuConnection *conn)
+{
+	if (!pts->conns)
+		pts->conns = MemoryContextAllocZero(pts->css.ss.ps.state->es_query_cxt,
+											sizeof(XpuConnection *) *
+											Max(numGpuDevAttrs, 1));
+	else if (pts->num_conns >= Max(numGpuDevAttrs, 1))
+		elog(ERROR, "Bug? too much connections for a session");
+	pts->conns[pts->num_conns++] = conn;
+	if (!pts->conn)
+		pts->conn = conn;	/* primary connection */
+}
+
+/*
+ * __xpuClientSetupSession
+ */
+static void
+__xpuClientSetupSession(pgstromTaskState *pts,
+						XpuConnection *conn,
+						const XpuCommand *session,
+						size_t cmd_ring_sz,
+						size_t resp_ring_sz)
+{
+	XpuCommand	   *resp;
+
+	/*
+	 * Setup the command / result ring buffers, if any
+	 */
+	if (cmd_ring_sz > 0)
+		__xpuClientCreateCommandRing(conn, cmd_ring_sz);
+	if (resp_ring_sz > 0)
+		__xpuClientCreateResultRing(conn, resp_ring_sz);
+
+	/*
+	 * Initialize the new session
+	 */
+	Assert(session->tag == XpuCommandTag__OpenSession);
+	if (!conn->cmd_ring && !conn->resp_ring)
+		xpuClientSendCommand(conn, session);
+	else
+	{
+		XpuCommand *temp = palloc(session->length);
+
+		memcpy(temp, session, session->length);
+		if (conn->cmd_ring)
+			temp->u.session.xcmd_ring_handle = conn->cmd_ring_handle;
+		if (conn->resp_ring)
+			temp->u.session.xresp_ring_handle = conn->resp_ring_handle;
+		xpuClientSendCommand(conn, temp);
+		pfree(temp);
+	}
+	resp = __waitAndFetchNextXpuCommand(pts, false);
+	if (!resp)
+		elog(ERROR, "Bug? %s:OpenSession response is missing", conn->devname);
+	if (resp->tag != XpuCommandTag__Success)
+		elog(ERROR, "%s:OpenSession failed - %s (%s:%d %s)",
+			 conn->devname,
+			 resp->u.error.message,
+			 resp->u.error.filename,
+			 resp->u.error.lineno,
+			 resp->u.error.funcname);
+	xpuClientPutResponse(resp);
+
+	/*
+	 * Once OpenSession is done, the GPU service already mapped the command
+	 * and result ring buffers, so we don't need the shared memory files
+	 * any more.
+	 */
+	__xpuClientUnlinkRings(conn);
+	if (conn->cmd_ring)
+		conn->cmd_ring_active = true;
+}
+
+/*
+ * xpuClientReuseIdleConnection
+ *
+ * It opens a new session on the idle connection to the 'devname' kept by
+ * the former query, if any.
+ */
+bool
+xpuClientReuseIdleConnection(pgstromTaskState *pts,
+							 const XpuCommand *session,
+							 const char *devname,
+							 size_t cmd_ring_sz,
+							 size_t resp_ring_sz)
+{
+	dlist_mutable_iter iter;
+
+	dlist_foreach_modify(iter, &xpu_idle_connections_list)
+	{
+		XpuConnection *conn = dlist_container(XpuConnection,
+											  chain, iter.cur);
+		if (conn->terminated != 0)
+		{
+			/* the service closed the connection */
+			__xpuClientCloseConnection(conn);
+			xpu_idle_connections_count--;
+			continue;
+		}
+		if (strcmp(conn->devname, devname) != 0)
+			continue;
+		dlist_delete(&conn->chain);
+		xpu_idle_connections_count--;
+		conn->resowner = CurrentResourceOwner;
+		dlist_push_tail(&xpu_connections_list, &conn->chain);
+		__xpuClientAttachConnection(pts, conn);
+		__xpuClientSetupSession(pts, conn, session,
+								cmd_ring_sz, resp_ring_sz);
+		return true;
+	}
+	return false;
+}
+
 /*
  * __xpuClientOpenSession
  */
@@ -2502,13 +5446,14 @@ __xpuClientOpenSession(pgstromTaskState *pts,
 					   const XpuCommand *session,
 					   pgsocket sockfd,
 					   const char *devname,
-					   int dev_index)
+					   int dev_index,
+					   size_t cmd_ring_sz,
+					   size_t resp_ring_sz,
+					   bool poolable)
 {
 	XpuConnection  *conn;
-	XpuCommand	   *resp;
 	int				rv;
 
-	Assert(!pts->conn);
 	conn = calloc(1, sizeof(XpuConnection));
 	if (!conn)
 	{
@@ -2525,8 +5470,9 @@ __xpuClientOpenSession(pgstromTaskState *pts,
 	conn->num_ready_cmds = 0;
 	dlist_init(&conn->ready_cmds_list);
 	dlist_init(&conn->active_cmds_list);
+	conn->poolable = poolable;
 	dlist_push_tail(&xpu_connections_list, &conn->chain);
-	pts->conn = conn;
+	__xpuClientAttachConnection(pts, conn);
 
 	/*
 	 * Ok, sockfd and conn shall be automatically released on ereport()
@@ -2536,22 +5482,327 @@ __xpuClientOpenSession(pgstromTaskState *pts,
 							 __xpuConnectSessionWorker, conn)) != 0)
 		elog(ERROR, "failed on pthread_create: %s", strerror(rv));
 
-	/*
-	 * Initialize the new session
-	 */
-	Assert(session->tag == XpuCommandTag__OpenSession);
-	xpuClientSendCommand(conn, session);
-	resp = __waitAndFetchNextXpuCommand(pts, false);
-	if (!resp)
-		elog(ERROR, "Bug? %s:OpenSession response is missing", conn->devname);
-	if (resp->tag != XpuCommandTag__Success)
-		elog(ERROR, "%s:OpenSession failed - %s (%s:%d %s)",
-			 conn->devname,
-			 resp->u.error.message,
-			 resp->u.error.filename,
-			 resp->u.error.lineno,
-			 resp->u.error.funcname);
-	xpuClientPutResponse(resp);
+	__xpuClientSetupSession(pts, conn, session, cmd_ring_sz, resp_ring_sz);
+}
+
+/* ----------------------------------------------------------------
+ *
+ * Batched execution of parameterized queries
+ *
+ * pgstrom.batch_query(query, params) runs the query once for all the
+ * parameter sets. The parameter rows are attached as a VALUES relation,
+ * and the $N references are replaced by its columns, so the outer table
+ * is scanned once by GpuJoin/GpuPreAgg, instead of N scans with tiny
+ * kernels. The result rows are tagged by the 1-origin index of the
+ * parameter set; it is prepended to GROUP BY and ORDER BY of the query.
+ *
+ * ----------------------------------------------------------------
+ */
+typedef struct
+{
+	Index		rtindex;		/* VALUES relation of the parameter sets */
+	int			num_params;
+	int			sublevels_up;
+	bool		replaced;
+} batchQueryContext;
+
+static Node *
+__batch_query_param_mutator(Node *node, batchQueryContext *con)
+{
+	if (!node)
+		return NULL;
+	if (IsA(node, Param))
+	{
+		Param  *param = (Param *)node;
+
+		if (param->paramkind == PARAM_EXTERN &&
+			param->paramid >= 1 &&
+			param->paramid <= con->num_params)
+		{
+			con->replaced = true;
+			return (Node *)makeVar(con->rtindex,
+								   param->paramid + 1,	/* next to batch_id */
+								   param->paramtype,
+								   param->paramtypmod,
+								   param->paramcollid,
+								   con->sublevels_up);
+		}
+	}
+	else if (IsA(node, Query))
+	{
+		Query  *result;
+
+		con->sublevels_up++;
+		result = query_tree_mutator((Query *)node,
+									__batch_query_param_mutator,
+									con, 0);
+		con->sublevels_up--;
+		return (Node *)result;
+	}
+	return expression_tree_mutator(node, __batch_query_param_mutator, con);
+}
+
+/*
+ * __batch_query_values_rte
+ */
+static RangeTblEntry *
+__batch_query_values_rte(ArrayType *params, Oid *param_types, int num_params)
+{
+	RangeTblEntry *rte = makeNode(RangeTblEntry);
+	List	   *colnames = NIL;
+	List	   *values_lists = NIL;
+	Datum	   *elems;
+	bool	   *nulls;
+	int			nelems;
+	int			nrows;
+
+	if ((ARR_NDIM(params) != 2 &&
+		 !(ARR_NDIM(params) == 1 && num_params == 1)) ||
+		(ARR_NDIM(params) == 2 && ARR_DIMS(params)[1] != num_params))
+		ereport(ERROR,
+				(errcode(ERRCODE_ARRAY_SUBSCRIPT_ERROR),
+				 errmsg("parameter sets must be a 2-dimensional array of %d columns",
+						num_params)));
+	nrows = ARR_DIMS(params)[0];
+	deconstruct_array(params, TEXTOID, -1, false, TYPALIGN_INT,
+					  &elems, &nulls, &nelems);
+	Assert(nelems == nrows * num_params);
+
+	rte->rtekind = RTE_VALUES;
+	rte->coltypes = list_make1_oid(INT4OID);
+	rte->coltypmods = list_make1_int(-1);
+	rte->colcollations = list_make1_oid(InvalidOid);
+	colnames = list_make1(makeString("batch_id"));
+	for (int k=0; k < num_params; k++)
+	{
+		rte->coltypes = lappend_oid(rte->coltypes, param_types[k]);
+		rte->coltypmods = lappend_int(rte->coltypmods, -1);
+		rte->colcollations = lappend_oid(rte->colcollations,
+										 get_typcollation(param_types[k]));
+		colnames = lappend(colnames, makeString(psprintf("p%d", k+1)));
+	}
+	for (int i=0; i < nrows; i++)
+	{
+		List   *vlist = list_make1(makeConst(INT4OID, -1, InvalidOid,
+											 sizeof(int32),
+											 Int32GetDatum(i+1),
+											 false, true));
+		for (int k=0; k < num_params; k++)
+		{
+			int		index = i * num_params + k;
+			Oid		typinput;
+			Oid		typioparam;
+			int16	typlen;
+			bool	typbyval;
+			Datum	value = 0;
+
+			getTypeInputInfo(param_types[k], &typinput, &typioparam);
+			get_typlenbyval(param_types[k], &typlen, &typbyval);
+			if (!nulls[index])
+				value = OidInputFunctionCall(typinput,
+											 TextDatumGetCString(elems[index]),
+											 typioparam, -1);
+			vlist = lappend(vlist, makeConst(param_types[k], -1,
+											 get_typcollation(param_types[k]),
+											 typlen, value,
+											 nulls[index], typbyval));
+		}
+		values_lists = lappend(values_lists, vlist);
+	}
+	rte->values_lists = values_lists;
+	rte->alias = makeAlias("__batch_params", NIL);
+	rte->eref = makeAlias("__batch_params", colnames);
+	rte->lateral = false;
+	rte->inh = false;
+	rte->inFromCl = true;
+
+	return rte;
+}
+
+/*
+ * __batch_query_rewrite
+ */
+static Query *
+__batch_query_rewrite(Query *qry, ArrayType *params,
+					  Oid *param_types, int num_params)
+{
+	batchQueryContext con;
+	TargetEntry *tle;
+	SortGroupClause *sgc;
+	RangeTblRef *rtr;
+	List	   *tlist = NIL;
+	Index		sortgroupref = 0;
+	Oid			sortop;
+	Oid			eqop;
+	bool		hashable;
+	ListCell   *lc;
+
+	if (qry->commandType != CMD_SELECT ||
+		qry->utilityStmt != NULL ||
+		qry->setOperations != NULL ||
+		qry->cteList != NIL)
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("batch query must be a simple SELECT statement")));
+	if (qry->hasWindowFuncs ||
+		qry->groupingSets != NIL ||
+		qry->distinctClause != NIL ||
+		qry->limitCount != NULL ||
+		qry->limitOffset != NULL ||
+		qry->rowMarks != NIL)
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("batch query does not support window functions, grouping sets, DISTINCT, LIMIT and FOR UPDATE/SHARE")));
+
+	/* replace $N by the columns of the parameter sets */
+	memset(&con, 0, sizeof(batchQueryContext));
+	con.rtindex = list_length(qry->rtable) + 1;
+	con.num_params = num_params;
+	foreach (lc, qry->rtable)
+	{
+		RangeTblEntry *rte = lfirst(lc);
+
+		if (rte->rtekind == RTE_SUBQUERY)
+		{
+			con.replaced = false;
+			rte->subquery = (Query *)
+				__batch_query_param_mutator((Node *)rte->subquery, &con);
+			/* sub-query in FROM has to refer the parameter sets */
+			if (con.replaced)
+				rte->lateral = true;
+		}
+	}
+	qry = query_tree_mutator(qry, __batch_query_param_mutator, &con,
+							 QTW_IGNORE_RT_SUBQUERIES);
+	qry->rtable = lappend(qry->rtable,
+						  __batch_query_values_rte(params, param_types,
+												   num_params));
+	rtr = makeNode(RangeTblRef);
+	rtr->rtindex = con.rtindex;
+	qry->jointree->fromlist = lappend(qry->jointree->fromlist, rtr);
+
+	/* batch_id as the first column, and the first GROUP BY / ORDER BY key */
+	foreach (lc, qry->targetList)
+	{
+		tle = lfirst(lc);
+		sortgroupref = Max(sortgroupref, tle->ressortgroupref);
+	}
+	sortgroupref++;
+	tle = makeTargetEntry((Expr *)makeVar(con.rtindex, 1, INT4OID, -1,
+										  InvalidOid, 0),
+						  1, pstrdup("batch_id"), false);
+	tle->ressortgroupref = sortgroupref;
+	tlist = list_make1(tle);
+	foreach (lc, qry->targetList)
+	{
+		tle = flatCopyTargetEntry(lfirst(lc));
+		tle->resno = list_length(tlist) + 1;
+		tlist = lappend(tlist, tle);
+	}
+	qry->targetList = tlist;
+
+	get_sort_group_operators(INT4OID, true, true, false,
+							 &sortop, &eqop, NULL, &hashable);
+	sgc = makeNode(SortGroupClause);
+	sgc->tleSortGroupRef = sortgroupref;
+	sgc->eqop = eqop;
+	sgc->sortop = sortop;
+	sgc->nulls_first = false;
+	sgc->hashable = hashable;
+	if (qry->hasAggs || qry->groupClause != NIL)
+		qry->groupClause = lcons(sgc, qry->groupClause);
+	if (qry->sortClause != NIL)
+		qry->sortClause = lcons(copyObject(sgc), qry->sortClause);
+
+	return qry;
+}
+
+/*
+ * pgstrom_batch_query
+ *
+ * pgstrom.batch_query(text query, text[] params)
+ */
+PG_FUNCTION_INFO_V1(pgstrom_batch_query);
+PUBLIC_FUNCTION(Datum)
+pgstrom_batch_query(PG_FUNCTION_ARGS)
+{
+	char	   *query = text_to_cstring(PG_GETARG_TEXT_PP(0));
+	ArrayType  *params = PG_GETARG_ARRAYTYPE_P(1);
+	ReturnSetInfo *rsinfo = (ReturnSetInfo *) fcinfo->resultinfo;
+	List	   *raw_list;
+	List	   *qry_list;
+	Query	   *qry;
+	Oid		   *param_types = NULL;
+	int			num_params = 0;
+	PlannedStmt *pstmt;
+	QueryDesc  *qdesc;
+	DestReceiver *dest;
+	TupleDesc	tupdesc;
+
+	InitMaterializedSRF(fcinfo, 0);
+
+	raw_list = pg_parse_query(query);
+	if (list_length(raw_list) != 1)
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("batch query must be a single SELECT statement")));
+	qry = parse_analyze_varparams(linitial_node(RawStmt, raw_list), query,
+								  &param_types, &num_params, NULL);
+	if (num_params == 0)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("batch query has no parameter references")));
+	for (int k=0; k < num_params; k++)
+	{
+		if (!OidIsValid(param_types[k]) || param_types[k] == UNKNOWNOID)
+			ereport(ERROR,
+					(errcode(ERRCODE_INDETERMINATE_DATATYPE),
+					 errmsg("could not determine data type of parameter $%d", k+1)));
+	}
+	qry = __batch_query_rewrite(qry, params, param_types, num_params);
+	qry_list = QueryRewrite(qry);
+	if (list_length(qry_list) != 1)
+		elog(ERROR, "batch query was rewritten to multiple queries");
+	pstmt = pg_plan_query(linitial(qry_list), query,
+						  CURSOR_OPT_PARALLEL_OK, NULL);
+
+	dest = CreateDestReceiver(DestTuplestore);
+	SetTuplestoreDestReceiverParams(dest,
+									rsinfo->setResult,
+									rsinfo->econtext->ecxt_per_query_memory,
+									false, NULL, NULL);
+	qdesc = CreateQueryDesc(pstmt, query,
+							GetActiveSnapshot(),
+							InvalidSnapshot,
+							dest, NULL, NULL, 0);
+	ExecutorStart(qdesc, 0);
+	/* query result must match the column definition list */
+	tupdesc = qdesc->tupDesc;
+	if (tupdesc->natts != rsinfo->setDesc->natts)
+		ereport(ERROR,
+				(errcode(ERRCODE_DATATYPE_MISMATCH),
+				 errmsg("batch query returns %d columns (batch_id and %d), but %d expected",
+						tupdesc->natts, tupdesc->natts - 1,
+						rsinfo->setDesc->natts)));
+	for (int j=0; j < tupdesc->natts; j++)
+	{
+		Oid		atttypid = TupleDescAttr(tupdesc, j)->atttypid;
+		Oid		exptypid = TupleDescAttr(rsinfo->setDesc, j)->atttypid;
+
+		if (atttypid != exptypid)
+			ereport(ERROR,
+					(errcode(ERRCODE_DATATYPE_MISMATCH),
+					 errmsg("column %d of the batch query is %s, but %s expected",
+							j+1, format_type_be(atttypid),
+							format_type_be(exptypid))));
+	}
+	ExecutorRun(qdesc, ForwardScanDirection, 0, true);
+	ExecutorFinish(qdesc);
+	ExecutorEnd(qdesc);
+	FreeQueryDesc(qdesc);
+	dest->rDestroy(dest);
+
+	return (Datum) 0;
 }
 
 /*
@@ -2560,6 +5811,89 @@ __xpuClientOpenSession(pgstromTaskState *pts,
 void
 pgstrom_init_executor(void)
 {
+	/* turn on/off cpu fallback without xPU session for tiny inputs */
+	DefineCustomIntVariable("pg_strom.cpu_fallback_tiny_input",
+							"Max number of rows processed by CPU without opening the GPU/DPU session",
+							NULL,
+							&pgstrom_cpu_fallback_tiny_input,
+							1000,
+							0,
+							INT_MAX,
+							PGC_USERSET,
+							GUC_NOT_IN_SAMPLE,
+							NULL, NULL, NULL);
+	/* number of idle GPU connections kept for the next query */
+	DefineCustomIntVariable("pg_strom.gpu_session_pool_size",
+							"Max number of idle GPU service connections kept per backend",
+							NULL,
+							&pgstrom_gpu_session_pool_size,
+							4,
+							0,
+							64,
+							PGC_USERSET,
+							GUC_NOT_IN_SAMPLE,
+							NULL, NULL, NULL);
+	/* number of siblings under Append started in advance */
+	DefineCustomIntVariable("pg_strom.async_append_prefetch",
+							"Number of Gpu* siblings under Append that start on the device in advance",
+							NULL,
+							&pgstrom_async_append_prefetch,
+							2,
+							0,
+							64,
+							PGC_USERSET,
+							GUC_NOT_IN_SAMPLE,
+							NULL, NULL, NULL);
+	/* latency histogram of GPU-Direct reads on EXPLAIN ANALYZE */
+	DefineCustomBoolVariable("pg_strom.explain_gpudirect_io",
+							 "Shows latency histogram and throughput of GPU-Direct reads on EXPLAIN ANALYZE",
+							 NULL,
+							 &pgstrom_explain_gpudirect_io,
+							 false,
+							 PGC_USERSET,
+							 GUC_NOT_IN_SAMPLE,
+							 NULL, NULL, NULL);
+	/* number of outer chunks sent during the inner preloading */
+	DefineCustomIntVariable("pg_strom.gpujoin_preload_prefetch",
+							"Number of outer chunks GPU loads during the inner preloading of GpuJoin",
+							NULL,
+							&pgstrom_gpujoin_preload_prefetch,
+							4,
+							0,
+							256,
+							PGC_USERSET,
+							GUC_NOT_IN_SAMPLE,
+							NULL, NULL, NULL);
+	/* LLVM JIT for the CPU fallback expressions */
+	DefineCustomBoolVariable("pg_strom.enable_cpu_fallback_jit",
+							 "Enables JIT compile of CPU fallback expressions, if expected fallback cost exceeds jit_above_cost",
+							 NULL,
+							 &pgstrom_enable_cpu_fallback_jit,
+							 true,
+							 PGC_USERSET,
+							 GUC_NOT_IN_SAMPLE,
+							 NULL, NULL, NULL);
+	/* columnar writeback of GpuScan/GpuJoin results */
+	DefineCustomBoolVariable("pg_strom.gpu_columnar_results",
+							 "Writes back GpuScan/GpuJoin results in columnar format, if all the attributes are fixed-length",
+							 NULL,
+							 &pgstrom_gpu_columnar_results,
+							 false,
+							 PGC_USERSET,
+							 GUC_NOT_IN_SAMPLE,
+							 NULL, NULL, NULL);
+	/* per-node profile of the slow queries */
+	DefineCustomIntVariable("pg_strom.log_min_duration_profile",
+							"Logs the profile of Gpu*/Dpu* nodes of the statements running longer than this",
+							"-1 disables, 0 logs all of them",
+							&pgstrom_log_min_duration_profile,
+							-1,
+							-1,
+							INT_MAX,
+							PGC_SUSET,
+							GUC_NOT_IN_SAMPLE | GUC_UNIT_MS,
+							NULL, NULL, NULL);
 	dlist_init(&xpu_connections_list);
+	dlist_init(&xpu_idle_connections_list);
 	RegisterResourceReleaseCallback(xpuclientCleanupConnections, NULL);
 }
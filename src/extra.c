@@ -19,6 +19,7 @@
 static int		gpudirect_driver_kind;
 static __thread void   *gpudirect_vfs_dma_buffer = NULL;
 static __thread size_t	gpudirect_vfs_dma_buffer_sz = 0UL;
+static __thread gpuDirectIOCounter *gpudirect_io_counter = NULL;
 
 /*
  * heterodbExtraModuleInfo
@@ -465,7 +466,7 @@ error_0:
 }
 
 /*
- * gpuDirectFileReadIOV
+ * __gpuDirectFileReadIOV
  */
 static int	(*p_cufile__read_file_iov_v3)(
 	const char *pathname,
@@ -492,14 +493,14 @@ static int	(*p_vfs_fallback__read_file_iov)(
 	uint32_t *p_npages_direct_read,
 	uint32_t *p_npages_vfs_read) = NULL;
 
-bool
-gpuDirectFileReadIOV(const char *pathname,
-					 CUdeviceptr m_segment,
-					 off_t m_offset,
-					 unsigned long iomap_handle,
-					 const strom_io_vector *iovec,
-					 uint32_t *p_npages_direct_read,
-					 uint32_t *p_npages_vfs_read)
+static bool
+__gpuDirectFileReadIOV(const char *pathname,
+					   CUdeviceptr m_segment,
+					   off_t m_offset,
+					   unsigned long iomap_handle,
+					   const strom_io_vector *iovec,
+					   uint32_t *p_npages_direct_read,
+					   uint32_t *p_npages_vfs_read)
 {
 	switch (gpudirect_driver_kind)
 	{
@@ -554,7 +555,7 @@ gpuDirectFileReadIOV(const char *pathname,
 }
 
 /*
- * gpuDirectFileReadAsyncIOV
+ * __gpuDirectFileReadAsyncIOV
  */
 static int	(*p_cufile__read_file_async_iov_v3)(
 	const char *pathname,
@@ -566,16 +567,16 @@ static int	(*p_cufile__read_file_async_iov_v3)(
 	uint32_t *p_npages_direct_read,
 	uint32_t *p_npages_vfs_read) = NULL;
 
-bool
-gpuDirectFileReadAsyncIOV(const char *pathname,
-						  CUdeviceptr m_segment,
-						  off_t m_offset,
-						  unsigned long iomap_handle,
-						  const strom_io_vector *iovec,
-						  CUstream cuda_stream,
-						  uint32_t *p_error_code_async,
-						  uint32_t *p_npages_direct_read,
-						  uint32_t *p_npages_vfs_read)
+static bool
+__gpuDirectFileReadAsyncIOV(const char *pathname,
+							CUdeviceptr m_segment,
+							off_t m_offset,
+							unsigned long iomap_handle,
+							const strom_io_vector *iovec,
+							CUstream cuda_stream,
+							uint32_t *p_error_code_async,
+							uint32_t *p_npages_direct_read,
+							uint32_t *p_npages_vfs_read)
 {
 	switch (gpudirect_driver_kind)
 	{
@@ -631,6 +632,159 @@ gpuDirectFileReadAsyncIOV(const char *pathname,
 								 p_npages_vfs_read);
 }
 
+/*
+ * gpuDirectSetIOCounter / gpuDirectGetIOCounter
+ *
+ * The GPU service threads install the per-task counter of GPU-Direct reads
+ * while they load the source buffer; the reads by this thread are also
+ * accumulated to the counter. NULL stops accumulation.
+ */
+void
+gpuDirectSetIOCounter(gpuDirectIOCounter *counter)
+{
+	gpudirect_io_counter = counter;
+}
+
+gpuDirectIOCounter *
+gpuDirectGetIOCounter(void)
+{
+	return gpudirect_io_counter;
+}
+
+/*
+ * __gpuDirectIODriverIndex - GPUDIRECT_IO_DRIVER__* actually used
+ */
+static int
+__gpuDirectIODriverIndex(void)
+{
+	if (gpudirect_driver_kind == GPUDIRECT_DRIVER__CUFILE &&
+		p_cufile__read_file_iov_v3)
+		return GPUDIRECT_IO_DRIVER__CUFILE;
+	if (gpudirect_driver_kind == GPUDIRECT_DRIVER__NVME_STROM &&
+		p_nvme_strom__read_file_iov)
+		return GPUDIRECT_IO_DRIVER__NVME_STROM;
+	/* vfs driver, or fallback by the regular filesystem */
+	return GPUDIRECT_IO_DRIVER__VFS;
+}
+
+/*
+ * __gpuDirectIOUpdateStats
+ */
+static void
+__gpuDirectIOUpdateStats(const char *pathname,
+						 const struct timespec *ts_begin,
+						 uint32_t npages_direct_read,
+						 uint32_t npages_vfs_read)
+{
+	gpuDirectIOCounter *counter = gpudirect_io_counter;
+	struct timespec	ts_end;
+	struct stat		stat_buf;
+	uint64_t		usec;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts_end);
+	usec = ((ts_end.tv_sec  - ts_begin->tv_sec) * 1000000L +
+			(ts_end.tv_nsec - ts_begin->tv_nsec) / 1000L);
+	if (stat(pathname, &stat_buf) == 0)
+		gpuDirectIOUpdateStats(stat_buf.st_dev,
+							   __gpuDirectIODriverIndex(),
+							   (uint64_t)(npages_direct_read +
+										  npages_vfs_read) * PAGE_SIZE,
+							   usec);
+	if (counter)
+	{
+		uint32_t	curr_max;
+
+		/* striped reads may update the counter concurrently */
+		__atomic_fetch_add(&counter->nr_ios, 1, __ATOMIC_RELAXED);
+		__atomic_fetch_add(&counter->usec_io, (uint32_t)usec, __ATOMIC_RELAXED);
+		__atomic_fetch_add(&counter->hist[gpuDirectIOHistBucket(usec)], 1,
+						   __ATOMIC_RELAXED);
+		curr_max = __atomic_load_n(&counter->usec_max, __ATOMIC_RELAXED);
+		while (curr_max < usec &&
+			   !__atomic_compare_exchange_n(&counter->usec_max, &curr_max,
+											(uint32_t)usec, false,
+											__ATOMIC_RELAXED,
+											__ATOMIC_RELAXED));
+	}
+}
+
+/*
+ * gpuDirectFileReadIOV
+ */
+bool
+gpuDirectFileReadIOV(const char *pathname,
+					 CUdeviceptr m_segment,
+					 off_t m_offset,
+					 unsigned long iomap_handle,
+					 const strom_io_vector *iovec,
+					 uint32_t *p_npages_direct_read,
+					 uint32_t *p_npages_vfs_read)
+{
+	struct timespec	ts_begin;
+	uint32_t	npages_direct_read = 0;
+	uint32_t	npages_vfs_read = 0;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts_begin);
+	if (!__gpuDirectFileReadIOV(pathname,
+								m_segment,
+								m_offset,
+								iomap_handle,
+								iovec,
+								&npages_direct_read,
+								&npages_vfs_read))
+		return false;
+	__gpuDirectIOUpdateStats(pathname, &ts_begin,
+							 npages_direct_read,
+							 npages_vfs_read);
+	if (p_npages_direct_read)
+		*p_npages_direct_read = npages_direct_read;
+	if (p_npages_vfs_read)
+		*p_npages_vfs_read = npages_vfs_read;
+	return true;
+}
+
+/*
+ * gpuDirectFileReadAsyncIOV
+ *
+ * Note that the latency of asynchronous reads is the time to submit the
+ * requests to the stream, not the time to complete them.
+ */
+bool
+gpuDirectFileReadAsyncIOV(const char *pathname,
+						  CUdeviceptr m_segment,
+						  off_t m_offset,
+						  unsigned long iomap_handle,
+						  const strom_io_vector *iovec,
+						  CUstream cuda_stream,
+						  uint32_t *p_error_code_async,
+						  uint32_t *p_npages_direct_read,
+						  uint32_t *p_npages_vfs_read)
+{
+	struct timespec	ts_begin;
+	uint32_t	npages_direct_read = 0;
+	uint32_t	npages_vfs_read = 0;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts_begin);
+	if (!__gpuDirectFileReadAsyncIOV(pathname,
+									 m_segment,
+									 m_offset,
+									 iomap_handle,
+									 iovec,
+									 cuda_stream,
+									 p_error_code_async,
+									 &npages_direct_read,
+									 &npages_vfs_read))
+		return false;
+	__gpuDirectIOUpdateStats(pathname, &ts_begin,
+							 npages_direct_read,
+							 npages_vfs_read);
+	if (p_npages_direct_read)
+		*p_npages_direct_read = npages_direct_read;
+	if (p_npages_vfs_read)
+		*p_npages_vfs_read = npages_vfs_read;
+	return true;
+}
+
 /*
  * gpuDirectGetProperty
  */
@@ -681,6 +835,19 @@ gpuDirectCleanUpOnThreadTerminate(void)
 	}
 }
 
+/*
+ * gpuDirectHasNativeDriver
+ *
+ * It returns true if the reads are processed by GPU-Direct driver, not by
+ * the VFS fallback using the host DMA buffer.
+ */
+bool
+gpuDirectHasNativeDriver(void)
+{
+	return (gpudirect_driver_kind == GPUDIRECT_DRIVER__CUFILE ||
+			gpudirect_driver_kind == GPUDIRECT_DRIVER__NVME_STROM);
+}
+
 /*
  * gpuDirectIsSupported
  */
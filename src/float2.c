@@ -1165,3 +1165,116 @@ pgstrom_float2_sum(PG_FUNCTION_ARGS)
 	}
 	PG_RETURN_FLOAT8(newval);
 }
+
+/*
+ * float vector (float2[] / float4[]) distance functions
+ */
+static float4
+__float_vector_common(FunctionCallInfo fcinfo, bool is_half, bool l2_distance,
+					  float4 *p_xx, float4 *p_yy)
+{
+	ArrayType  *a = PG_GETARG_ARRAYTYPE_P(0);
+	ArrayType  *b = PG_GETARG_ARRAYTYPE_P(1);
+	int			x_nitems, y_nitems;
+	float4		sum = 0.0;
+	float4		xx = 0.0;
+	float4		yy = 0.0;
+
+	if (ARR_HASNULL(a) || ARR_HASNULL(b))
+		ereport(ERROR,
+				(errcode(ERRCODE_NULL_VALUE_NOT_ALLOWED),
+				 errmsg("float vector must not contain nulls")));
+	x_nitems = ArrayGetNItems(ARR_NDIM(a), ARR_DIMS(a));
+	y_nitems = ArrayGetNItems(ARR_NDIM(b), ARR_DIMS(b));
+	if (x_nitems != y_nitems)
+		ereport(ERROR,
+				(errcode(ERRCODE_DATA_EXCEPTION),
+				 errmsg("different float vector dimensions %d and %d",
+						x_nitems, y_nitems)));
+	for (int i=0; i < x_nitems; i++)
+	{
+		float4	fx, fy;
+
+		if (is_half)
+		{
+			fx = fp16_to_fp32(((float2_t *)ARR_DATA_PTR(a))[i]);
+			fy = fp16_to_fp32(((float2_t *)ARR_DATA_PTR(b))[i]);
+		}
+		else
+		{
+			fx = ((float4 *)ARR_DATA_PTR(a))[i];
+			fy = ((float4 *)ARR_DATA_PTR(b))[i];
+		}
+		if (l2_distance)
+			sum += (fx - fy) * (fx - fy);
+		else
+		{
+			sum += fx * fy;
+			xx += fx * fx;
+			yy += fy * fy;
+		}
+	}
+	if (p_xx)
+		*p_xx = xx;
+	if (p_yy)
+		*p_yy = yy;
+	return sum;
+}
+
+static float4
+__float_vector_cosine_distance(FunctionCallInfo fcinfo, bool is_half)
+{
+	float4		xy, xx, yy;
+	float4		cosine;
+
+	xy = __float_vector_common(fcinfo, is_half, false, &xx, &yy);
+	cosine = xy / sqrtf(xx * yy);
+	/* keep in range, for rounding errors */
+	if (cosine > 1.0)
+		cosine = 1.0;
+	else if (cosine < -1.0)
+		cosine = -1.0;
+	return 1.0 - cosine;
+}
+
+PG_FUNCTION_INFO_V1(pgstrom_float2_dot_product);
+PUBLIC_FUNCTION(Datum)
+pgstrom_float2_dot_product(PG_FUNCTION_ARGS)
+{
+	PG_RETURN_FLOAT4(__float_vector_common(fcinfo, true, false, NULL, NULL));
+}
+
+PG_FUNCTION_INFO_V1(pgstrom_float2_l2_distance);
+PUBLIC_FUNCTION(Datum)
+pgstrom_float2_l2_distance(PG_FUNCTION_ARGS)
+{
+	PG_RETURN_FLOAT4(sqrtf(__float_vector_common(fcinfo, true, true, NULL, NULL)));
+}
+
+PG_FUNCTION_INFO_V1(pgstrom_float2_cosine_distance);
+PUBLIC_FUNCTION(Datum)
+pgstrom_float2_cosine_distance(PG_FUNCTION_ARGS)
+{
+	PG_RETURN_FLOAT4(__float_vector_cosine_distance(fcinfo, true));
+}
+
+PG_FUNCTION_INFO_V1(pgstrom_float4_dot_product);
+PUBLIC_FUNCTION(Datum)
+pgstrom_float4_dot_product(PG_FUNCTION_ARGS)
+{
+	PG_RETURN_FLOAT4(__float_vector_common(fcinfo, false, false, NULL, NULL));
+}
+
+PG_FUNCTION_INFO_V1(pgstrom_float4_l2_distance);
+PUBLIC_FUNCTION(Datum)
+pgstrom_float4_l2_distance(PG_FUNCTION_ARGS)
+{
+	PG_RETURN_FLOAT4(sqrtf(__float_vector_common(fcinfo, false, true, NULL, NULL)));
+}
+
+PG_FUNCTION_INFO_V1(pgstrom_float4_cosine_distance);
+PUBLIC_FUNCTION(Datum)
+pgstrom_float4_cosine_distance(PG_FUNCTION_ARGS)
+{
+	PG_RETURN_FLOAT4(__float_vector_cosine_distance(fcinfo, false));
+}
@@ -0,0 +1,569 @@
+/*
+ * gpu_analyze.c
+ *
+ * Full-scan ANALYZE of the large heap tables using GPU
+ *
+ * ANALYZE builds pg_statistic from the sampled rows (300 x statistics
+ * target), so null fraction, ndistinct and MCVs are often inaccurate on
+ * the large tables with skewed values. If pg_strom.enable_gpu_analyze is
+ * enabled, once ANALYZE of the tables given by the command completes,
+ * the aggregate queries below are run over the whole tables; they are
+ * usually GpuPreAgg that loads the heap blocks by GPU-Direct SQL.
+ *
+ *  - exact null fraction by count(*) and count(COLUMN)
+ *  - ndistinct estimated by pgstrom.hll_count(COLUMN)
+ *  - exact MCVs and their frequencies by GROUP BY COLUMN, only if the
+ *    ndistinct is small enough to build the hash table on GPU.
+ *  - histogram bounds of numeric types by pgstrom.percentile_approx()
+ *    on the values except for the MCVs.
+ *
+ * The number of MCVs and histogram bounds are kept, and the other slots
+ * (like correlation) are still what ANALYZE built by the sampling.
+ * ----
+ * Copyright 2011-2023 (C) KaiGai Kohei <kaigai@kaigai.gr.jp>
+ * Copyright 2014-2023 (C) PG-Strom Developers Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the PostgreSQL License.
+ */
+#include "pg_strom.h"
+
+/* static variables */
+static ProcessUtility_hook_type process_utility_next = NULL;
+static bool		pgstrom_enable_gpu_analyze;				/* GUC */
+static int		pgstrom_gpu_analyze_min_size_mb;		/* GUC */
+static int		pgstrom_gpu_analyze_mcv_max_groups;		/* GUC */
+
+typedef struct
+{
+	Form_pg_attribute attr;
+	bool		has_hll;
+	int64		nonnull_count;
+	double		ndistinct;		/* estimated by HLL, or 0.0 */
+} gpuAnalyzeAttrState;
+
+/*
+ * __gpuAnalyzeRelationName
+ */
+static const char *
+__gpuAnalyzeRelationName(Relation rel)
+{
+	return quote_qualified_identifier(get_namespace_name(RelationGetNamespace(rel)),
+									  RelationGetRelationName(rel));
+}
+
+/*
+ * __gpuAnalyzeExecQuery
+ */
+static void
+__gpuAnalyzeExecQuery(const char *query, long tcount)
+{
+	int		rc;
+
+	elog(DEBUG1, "gpu_analyze: %s", query);
+	rc = SPI_execute(query, false, tcount);
+	if (rc != SPI_OK_SELECT)
+		elog(ERROR, "gpu_analyze: failed on SPI_execute('%s'): %s",
+			 query, SPI_result_code_string(rc));
+}
+
+/*
+ * __gpuAnalyzeScanColumns
+ *
+ * null count and ndistinct of all the columns by a single scan
+ */
+static int64
+__gpuAnalyzeScanColumns(Relation rel, gpuAnalyzeAttrState *ga_states, int nitems)
+{
+	StringInfoData buf;
+	int64		total_nrows;
+	int			anum = 2;
+	Datum		datum;
+	bool		isnull;
+
+	initStringInfo(&buf);
+	appendStringInfoString(&buf, "SELECT count(*)");
+	for (int k=0; k < nitems; k++)
+	{
+		const char *cname = quote_identifier(NameStr(ga_states[k].attr->attname));
+
+		appendStringInfo(&buf, ", count(%s)", cname);
+		if (ga_states[k].has_hll)
+			appendStringInfo(&buf, ", pgstrom.hll_count(%s)", cname);
+	}
+	appendStringInfo(&buf, " FROM ONLY %s", __gpuAnalyzeRelationName(rel));
+	__gpuAnalyzeExecQuery(buf.data, 1);
+	if (SPI_processed != 1)
+		elog(ERROR, "gpu_analyze: query returned %lu rows", (unsigned long)SPI_processed);
+
+	datum = SPI_getbinval(SPI_tuptable->vals[0],
+						  SPI_tuptable->tupdesc, 1, &isnull);
+	total_nrows = (isnull ? 0 : DatumGetInt64(datum));
+	for (int k=0; k < nitems; k++)
+	{
+		gpuAnalyzeAttrState *ga = &ga_states[k];
+
+		datum = SPI_getbinval(SPI_tuptable->vals[0],
+							  SPI_tuptable->tupdesc, anum++, &isnull);
+		ga->nonnull_count = (isnull ? 0 : DatumGetInt64(datum));
+		if (ga->has_hll)
+		{
+			datum = SPI_getbinval(SPI_tuptable->vals[0],
+								  SPI_tuptable->tupdesc, anum++, &isnull);
+			if (!isnull)
+				ga->ndistinct = (double)DatumGetInt64(datum);
+		}
+	}
+	pfree(buf.data);
+
+	return total_nrows;
+}
+
+/*
+ * __gpuAnalyzeBuildMCVs
+ *
+ * It replaces the sampled MCVs by the exact most common values over the
+ * whole table, and returns the MCV array to be excluded from histogram.
+ */
+static ArrayType *
+__gpuAnalyzeBuildMCVs(Relation rel, gpuAnalyzeAttrState *ga,
+					  HeapTuple htup, int slot,
+					  int64 total_nrows,
+					  Datum *values, bool *replaces)
+{
+	Form_pg_attribute attr = ga->attr;
+	const char *cname = quote_identifier(NameStr(attr->attname));
+	ArrayType  *arr;
+	Datum		datum;
+	bool		isnull;
+	int			nelems;
+	int16		typlen;
+	bool		typbyval;
+	char		typalign;
+	Datum	   *mcv_values;
+	Datum	   *mcv_freqs;
+	int			nmcvs = 0;
+	StringInfoData buf;
+
+	datum = SysCacheGetAttr(STATRELATTINH, htup,
+							Anum_pg_statistic_stavalues1 + slot,
+							&isnull);
+	if (isnull)
+		return NULL;
+	arr = DatumGetArrayTypeP(datum);
+	if (ARR_ELEMTYPE(arr) != attr->atttypid)
+		return NULL;
+	nelems = ArrayGetNItems(ARR_NDIM(arr), ARR_DIMS(arr));
+	/* GROUP BY is not reasonable on the values like unique keys */
+	if (!ga->has_hll ||
+		ga->ndistinct <= 0.0 ||
+		ga->ndistinct > (double)pgstrom_gpu_analyze_mcv_max_groups ||
+		nelems < 1)
+		return arr;
+
+	initStringInfo(&buf);
+	appendStringInfo(&buf,
+					 "SELECT %s, count(*) FROM ONLY %s"
+					 " WHERE %s IS NOT NULL"
+					 " GROUP BY 1 ORDER BY 2 DESC LIMIT %d",
+					 cname,
+					 __gpuAnalyzeRelationName(rel),
+					 cname,
+					 nelems);
+	__gpuAnalyzeExecQuery(buf.data, nelems);
+
+	mcv_values = palloc(sizeof(Datum) * (SPI_processed + 1));
+	mcv_freqs  = palloc(sizeof(Datum) * (SPI_processed + 1));
+	for (uint64 i=0; i < SPI_processed; i++)
+	{
+		HeapTuple	tuple = SPI_tuptable->vals[i];
+		TupleDesc	tupdesc = SPI_tuptable->tupdesc;
+		int64		count;
+
+		datum = SPI_getbinval(tuple, tupdesc, 2, &isnull);
+		count = (isnull ? 0 : DatumGetInt64(datum));
+		/* same rule with compute_distinct_stats(); no singleton */
+		if (count <= 1)
+			break;
+		mcv_values[nmcvs] = SPI_getbinval(tuple, tupdesc, 1, &isnull);
+		if (isnull)
+			continue;
+		mcv_freqs[nmcvs] = Float4GetDatum((double)count / (double)total_nrows);
+		nmcvs++;
+	}
+	if (nmcvs == 0)
+		return arr;		/* keep the sampled MCVs */
+
+	get_typlenbyvalalign(attr->atttypid, &typlen, &typbyval, &typalign);
+	arr = construct_array(mcv_values, nmcvs, attr->atttypid,
+						  typlen, typbyval, typalign);
+	values[Anum_pg_statistic_stavalues1 + slot - 1] = PointerGetDatum(arr);
+	replaces[Anum_pg_statistic_stavalues1 + slot - 1] = true;
+	values[Anum_pg_statistic_stanumbers1 + slot - 1]
+		= PointerGetDatum(construct_array(mcv_freqs, nmcvs, FLOAT4OID,
+										  sizeof(float4), FLOAT4PASSBYVAL,
+										  TYPALIGN_INT));
+	replaces[Anum_pg_statistic_stanumbers1 + slot - 1] = true;
+	pfree(buf.data);
+
+	return arr;
+}
+
+/*
+ * __gpuAnalyzeBuildHistogram
+ *
+ * It replaces the sampled histogram bounds of numeric types by the
+ * percentiles over the whole table. pgstrom.percentile_approx() works
+ * on float8, so the other numeric types are cast to/from float8.
+ */
+static void
+__gpuAnalyzeBuildHistogram(Relation rel, gpuAnalyzeAttrState *ga,
+						   HeapTuple htup, int slot,
+						   ArrayType *mcv_arr,
+						   Datum *values, bool *replaces)
+{
+	Form_pg_attribute attr = ga->attr;
+	const char *cname = quote_identifier(NameStr(attr->attname));
+	const char *tname;
+	ArrayType  *arr;
+	Datum		datum;
+	bool		isnull;
+	int			nelems;
+	int16		typlen;
+	bool		typbyval;
+	char		typalign;
+	Datum	   *hist_values;
+	StringInfoData buf;
+
+	switch (getBaseType(attr->atttypid))
+	{
+		case INT2OID:
+		case INT4OID:
+		case INT8OID:
+		case FLOAT4OID:
+		case FLOAT8OID:
+		case NUMERICOID:
+			break;
+		default:
+			return;
+	}
+	datum = SysCacheGetAttr(STATRELATTINH, htup,
+							Anum_pg_statistic_stavalues1 + slot,
+							&isnull);
+	if (isnull)
+		return;
+	arr = DatumGetArrayTypeP(datum);
+	if (ARR_ELEMTYPE(arr) != attr->atttypid)
+		return;
+	nelems = ArrayGetNItems(ARR_NDIM(arr), ARR_DIMS(arr));
+	if (nelems < 2)
+		return;
+
+	tname = format_type_be_qualified(attr->atttypid);
+	initStringInfo(&buf);
+	appendStringInfoString(&buf, "SELECT ");
+	for (int i=0; i < nelems; i++)
+	{
+		appendStringInfo(&buf, "%spgstrom.percentile_approx(%s::float8, %.8f)::%s",
+						 i > 0 ? ", " : "",
+						 cname,
+						 (double)i / (double)(nelems - 1),
+						 tname);
+	}
+	appendStringInfo(&buf, " FROM ONLY %s WHERE %s IS NOT NULL",
+					 __gpuAnalyzeRelationName(rel), cname);
+	if (mcv_arr)
+	{
+		Oid		array_type = get_array_type(ARR_ELEMTYPE(mcv_arr));
+		Oid		typoutput;
+		bool	typisvarlena;
+
+		getTypeOutputInfo(array_type, &typoutput, &typisvarlena);
+		appendStringInfo(&buf, " AND NOT %s = ANY(%s::%s)",
+						 cname,
+						 quote_literal_cstr(OidOutputFunctionCall(typoutput,
+																  PointerGetDatum(mcv_arr))),
+						 format_type_be_qualified(array_type));
+	}
+	__gpuAnalyzeExecQuery(buf.data, 1);
+	if (SPI_processed != 1)
+		return;
+
+	hist_values = palloc(sizeof(Datum) * nelems);
+	for (int i=0; i < nelems; i++)
+	{
+		hist_values[i] = SPI_getbinval(SPI_tuptable->vals[0],
+									   SPI_tuptable->tupdesc,
+									   i+1, &isnull);
+		if (isnull)
+			return;		/* all the values are MCVs */
+	}
+	get_typlenbyvalalign(attr->atttypid, &typlen, &typbyval, &typalign);
+	arr = construct_array(hist_values, nelems, attr->atttypid,
+						  typlen, typbyval, typalign);
+	values[Anum_pg_statistic_stavalues1 + slot - 1] = PointerGetDatum(arr);
+	replaces[Anum_pg_statistic_stavalues1 + slot - 1] = true;
+	pfree(buf.data);
+}
+
+/*
+ * __gpuAnalyzeUpdateStatistic
+ */
+static void
+__gpuAnalyzeUpdateStatistic(Relation rel, Relation srel,
+							gpuAnalyzeAttrState *ga,
+							int64 total_nrows)
+{
+	Form_pg_attribute attr = ga->attr;
+	Datum		values[Natts_pg_statistic];
+	bool		nulls[Natts_pg_statistic];
+	bool		replaces[Natts_pg_statistic];
+	Form_pg_statistic stat;
+	AttributeOpts *aopt;
+	ArrayType  *mcv_arr = NULL;
+	HeapTuple	htup;
+	HeapTuple	newtup;
+
+	htup = SearchSysCache3(STATRELATTINH,
+						   ObjectIdGetDatum(RelationGetRelid(rel)),
+						   Int16GetDatum(attr->attnum),
+						   BoolGetDatum(false));
+	if (!HeapTupleIsValid(htup))
+		return;		/* ANALYZE skipped this column */
+	stat = (Form_pg_statistic) GETSTRUCT(htup);
+	memset(values, 0, sizeof(values));
+	memset(nulls, 0, sizeof(nulls));
+	memset(replaces, 0, sizeof(replaces));
+
+	/* exact null fraction */
+	values[Anum_pg_statistic_stanullfrac - 1]
+		= Float4GetDatum((double)(total_nrows - ga->nonnull_count) /
+						 (double)total_nrows);
+	replaces[Anum_pg_statistic_stanullfrac - 1] = true;
+
+	/* ndistinct, unless user gives n_distinct attribute option */
+	aopt = get_attribute_options(RelationGetRelid(rel), attr->attnum);
+	if (ga->ndistinct > 0.0 && (!aopt || aopt->n_distinct == 0.0))
+	{
+		double	ndistinct = Min(ga->ndistinct, (double)ga->nonnull_count);
+		double	stadistinct;
+
+		/* same rule with compute_distinct_stats() */
+		if (ndistinct > 0.1 * (double)total_nrows)
+			stadistinct = Max(-(ndistinct / (double)total_nrows), -1.0);
+		else
+			stadistinct = floor(ndistinct + 0.5);
+		values[Anum_pg_statistic_stadistinct - 1] = Float4GetDatum(stadistinct);
+		replaces[Anum_pg_statistic_stadistinct - 1] = true;
+	}
+
+	/* MCVs prior to the histogram, because it excludes the MCVs */
+	for (int k=0; k < STATISTIC_NUM_SLOTS; k++)
+	{
+		if ((&stat->stakind1)[k] == STATISTIC_KIND_MCV)
+			mcv_arr = __gpuAnalyzeBuildMCVs(rel, ga, htup, k,
+											total_nrows,
+											values, replaces);
+	}
+	for (int k=0; k < STATISTIC_NUM_SLOTS; k++)
+	{
+		if ((&stat->stakind1)[k] == STATISTIC_KIND_HISTOGRAM)
+			__gpuAnalyzeBuildHistogram(rel, ga, htup, k, mcv_arr,
+									   values, replaces);
+	}
+	newtup = heap_modify_tuple(htup, RelationGetDescr(srel),
+							   values, nulls, replaces);
+	CatalogTupleUpdate(srel, &newtup->t_self, newtup);
+	heap_freetuple(newtup);
+	ReleaseSysCache(htup);
+}
+
+/*
+ * __gpuAnalyzeAdjustStatistics
+ */
+static void
+__gpuAnalyzeAdjustStatistics(Oid relid, List *va_cols)
+{
+	Relation	rel;
+	Relation	srel;
+	TupleDesc	tupdesc;
+	List	   *func_name = list_make2(makeString("pgstrom"),
+									   makeString("hll_count"));
+	gpuAnalyzeAttrState *ga_states;
+	int			nitems = 0;
+	int64		total_nrows;
+	double		rel_size;
+
+	rel = try_relation_open(relid, AccessShareLock);
+	if (!rel)
+		return;		/* concurrently dropped */
+	if ((rel->rd_rel->relkind != RELKIND_RELATION &&
+		 rel->rd_rel->relkind != RELKIND_MATVIEW) ||
+		!pg_class_ownercheck(relid, GetUserId()))
+	{
+		/* ANALYZE already reported the permission error */
+		relation_close(rel, AccessShareLock);
+		return;
+	}
+	/* small tables are fine with the sampling */
+	rel_size = (double)RelationGetNumberOfBlocks(rel) * (double)BLCKSZ;
+	if (rel_size < (double)pgstrom_gpu_analyze_min_size_mb * 1048576.0)
+	{
+		relation_close(rel, AccessShareLock);
+		return;
+	}
+	tupdesc = RelationGetDescr(rel);
+	ga_states = palloc0(sizeof(gpuAnalyzeAttrState) * tupdesc->natts);
+	for (int j=0; j < tupdesc->natts; j++)
+	{
+		Form_pg_attribute attr = TupleDescAttr(tupdesc, j);
+		gpuAnalyzeAttrState *ga = &ga_states[nitems];
+		Oid			type_oid;
+
+		if (attr->attisdropped)
+			continue;
+		if (va_cols != NIL)
+		{
+			ListCell   *lc;
+
+			foreach (lc, va_cols)
+			{
+				if (strcmp(strVal(lfirst(lc)), NameStr(attr->attname)) == 0)
+					break;
+			}
+			if (!lc)
+				continue;
+		}
+		if (!SearchSysCacheExists3(STATRELATTINH,
+								   ObjectIdGetDatum(relid),
+								   Int16GetDatum(attr->attnum),
+								   BoolGetDatum(false)))
+			continue;	/* ANALYZE skipped this column */
+		type_oid = getBaseType(attr->atttypid);
+		ga->attr = attr;
+		ga->has_hll = OidIsValid(LookupFuncName(func_name, 1, &type_oid, true));
+		nitems++;
+	}
+	if (nitems == 0)
+	{
+		relation_close(rel, AccessShareLock);
+		return;
+	}
+
+	if (SPI_connect() != SPI_OK_CONNECT)
+		elog(ERROR, "failed on SPI_connect");
+	total_nrows = __gpuAnalyzeScanColumns(rel, ga_states, nitems);
+	if (total_nrows > 0)
+	{
+		srel = table_open(StatisticRelationId, RowExclusiveLock);
+		for (int k=0; k < nitems; k++)
+			__gpuAnalyzeUpdateStatistic(rel, srel, &ga_states[k], total_nrows);
+		table_close(srel, RowExclusiveLock);
+	}
+	SPI_finish();
+	CommandCounterIncrement();
+	relation_close(rel, AccessShareLock);
+}
+
+/*
+ * __gpuAnalyzeIsAnalyzeCommand
+ */
+static bool
+__gpuAnalyzeIsAnalyzeCommand(VacuumStmt *vstmt)
+{
+	ListCell   *lc;
+
+	if (!vstmt->is_vacuumcmd)
+		return true;
+	foreach (lc, vstmt->options)
+	{
+		DefElem	   *defel = lfirst(lc);
+
+		if (strcmp(defel->defname, "analyze") == 0)
+			return defGetBoolean(defel);
+	}
+	return false;
+}
+
+/*
+ * gpuAnalyzeProcessUtility
+ *
+ * Only the tables given by the command are adjusted; ANALYZE without
+ * the table names does not scan the whole database on GPU.
+ */
+static void
+gpuAnalyzeProcessUtility(PlannedStmt *pstmt,
+						 const char *queryString,
+						 bool readOnlyTree,
+						 ProcessUtilityContext context,
+						 ParamListInfo params,
+						 QueryEnvironment *queryEnv,
+						 DestReceiver *dest,
+						 QueryCompletion *qc)
+{
+	Node	   *parsetree = pstmt->utilityStmt;
+	List	   *vrels = NIL;
+	ListCell   *lc;
+
+	if (pgstrom_enable_gpu_analyze &&
+		IsA(parsetree, VacuumStmt) &&
+		__gpuAnalyzeIsAnalyzeCommand((VacuumStmt *)parsetree))
+		vrels = ((VacuumStmt *)parsetree)->rels;
+
+	if (process_utility_next)
+		process_utility_next(pstmt, queryString, readOnlyTree,
+							 context, params, queryEnv, dest, qc);
+	else
+		standard_ProcessUtility(pstmt, queryString, readOnlyTree,
+								context, params, queryEnv, dest, qc);
+
+	foreach (lc, vrels)
+	{
+		VacuumRelation *vrel = lfirst(lc);
+		Oid			relid = vrel->oid;
+
+		if (!OidIsValid(relid) && vrel->relation)
+			relid = RangeVarGetRelid(vrel->relation, NoLock, true);
+		if (OidIsValid(relid))
+			__gpuAnalyzeAdjustStatistics(relid, vrel->va_cols);
+	}
+}
+
+/*
+ * pgstrom_init_gpu_analyze
+ */
+void
+pgstrom_init_gpu_analyze(void)
+{
+	DefineCustomBoolVariable("pg_strom.enable_gpu_analyze",
+							 "Enables full-scan ANALYZE of the large tables on GPU",
+							 NULL,
+							 &pgstrom_enable_gpu_analyze,
+							 false,
+							 PGC_USERSET,
+							 GUC_NOT_IN_SAMPLE,
+							 NULL, NULL, NULL);
+	DefineCustomIntVariable("pg_strom.gpu_analyze_min_size",
+							"Minimum size of the tables to be analyzed on GPU",
+							NULL,
+							&pgstrom_gpu_analyze_min_size_mb,
+							1024,		/* 1GB */
+							0,
+							INT_MAX,
+							PGC_USERSET,
+							GUC_NOT_IN_SAMPLE | GUC_UNIT_MB,
+							NULL, NULL, NULL);
+	DefineCustomIntVariable("pg_strom.gpu_analyze_mcv_max_groups",
+							"Max ndistinct of the column to build exact MCVs by GROUP BY",
+							NULL,
+							&pgstrom_gpu_analyze_mcv_max_groups,
+							1000000,
+							0,
+							INT_MAX,
+							PGC_USERSET,
+							GUC_NOT_IN_SAMPLE,
+							NULL, NULL, NULL);
+	/* post-processing of ANALYZE */
+	process_utility_next = ProcessUtility_hook;
+	ProcessUtility_hook = gpuAnalyzeProcessUtility;
+}
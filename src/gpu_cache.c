@@ -19,6 +19,8 @@
 #define GCACHE_CONTROL_CMD__APPLY_REDO		'A'
 #define GCACHE_CONTROL_CMD__COMPACTION		'C'
 #define GCACHE_CONTROL_CMD__DROP_UNLOAD		'D'
+#define GCACHE_CONTROL_CMD__LOAD_SNAPSHOT	'S'
+#define GCACHE_CONTROL_CMD__FETCH_AGGREGATE	'F'
 #define GCACHE_CONTROL_CMD__ERRORBUF_SIZE	120
 
 typedef struct
@@ -59,25 +61,71 @@ typedef struct
 {
 	Oid			tg_sync_row;
 	int			cuda_dindex;
+#define GCACHE_DEVICE_PLACEMENT__FIXED		0	/* gpu_device_id=<ID> */
+#define GCACHE_DEVICE_PLACEMENT__ROUNDROBIN	1	/* gpu_device_id=roundrobin */
+#define GCACHE_DEVICE_PLACEMENT__HASH		2	/* gpu_device_id=hash */
+	int			device_placement;
+	uint64		replica_mask;	/* bitmap of cuda_dindex for replicas */
 	int32		gpu_sync_interval;
 	size_t		gpu_sync_threshold;
 	int64		max_num_rows;
 	int64		rowid_hash_nslots;
 	size_t		redo_buffer_size;
+#define GCACHE_SYNC_MODE__TRIGGER	0	/* REDO logs by row triggers */
+#define GCACHE_SYNC_MODE__WAL		1	/* REDO logs by WAL sync worker */
+	int			sync_mode;
+#define GCACHE_COLUMN_ENCODING_MAXLEN	256
+	char		column_encoding[GCACHE_COLUMN_ENCODING_MAXLEN];
+	NameData	hash_index;		/* column name of the hash-index, if any */
+#define GCACHE_AGGREGATE_MAXLEN		(2 * NAMEDATALEN)
+	char		aggregate[GCACHE_AGGREGATE_MAXLEN];	/* <key>[:<value>] */
 } GpuCacheOptions;
 
+/* number of groups of the maintained aggregation */
+#define GCACHE_AGG_NSLOTS			(1U<<16)
+#define GCACHE_AGG_BUFFER_SIZE(gc_options)								\
+	((gc_options)->aggregate[0] != '\0'									\
+	 ? PAGE_ALIGN(sizeof(kern_gpucache_aggslot) * GCACHE_AGG_NSLOTS)	\
+	 : 0)
+
 INLINE_FUNCTION(bool)
 GpuCacheOptionsEqual(const GpuCacheOptions *a, const GpuCacheOptions *b)
 {
 	return (a->tg_sync_row        == b->tg_sync_row &&
 			a->cuda_dindex        == b->cuda_dindex &&
+			a->device_placement   == b->device_placement &&
+			a->replica_mask       == b->replica_mask &&
 			a->gpu_sync_interval  == b->gpu_sync_interval &&
 			a->gpu_sync_threshold == b->gpu_sync_threshold &&
 			a->max_num_rows       == b->max_num_rows &&
 			a->rowid_hash_nslots  == b->rowid_hash_nslots &&
-			a->redo_buffer_size   == b->redo_buffer_size);
+			a->redo_buffer_size   == b->redo_buffer_size &&
+			a->sync_mode          == b->sync_mode &&
+			strcmp(a->column_encoding, b->column_encoding) == 0 &&
+			strcmp(NameStr(a->hash_index), NameStr(b->hash_index)) == 0 &&
+			strcmp(a->aggregate, b->aggregate) == 0);
 }
 
+/*
+ * GpuCacheRowIdPart - a partition of the rowid-map
+ *
+ * The hash slot 'hindex' is protected by the partition (hindex % NPARTS),
+ * and the partition 'p' keeps the free rowids where (rowid % NPARTS) == p.
+ * So, concurrent writers rarely contend on the same lock. Only one partition
+ * lock is held at once, except for the whole reset/rebuild (ascending order).
+ */
+#define GCACHE_ROWID_NPARTS			64
+
+typedef struct
+{
+	pthread_mutex_t	mutex;
+	uint32_t		next_free;
+	uint32_t		num_free;
+	char			__padding__[PG_CACHE_LINE_SIZE
+								- sizeof(pthread_mutex_t)
+								- 2 * sizeof(uint32_t)];
+} GpuCacheRowIdPart;
+
 /*
  * GpuCacheSharedState (shared structure; dynamic memory mapped)
  */
@@ -88,6 +136,7 @@ typedef struct
 	char			table_name[NAMEDATALEN];	/* for debug */
 	uint64_t		rowid_map_offset;
 	uint64_t		redo_buffer_offset;
+	uint64_t		agg_buffer_offset;	/* copy of the maintained aggregation */
 
 	/* GpuCache configuration parameters */
 	GpuCacheOptions	gc_options;
@@ -107,19 +156,38 @@ typedef struct
 	pg_atomic_uint64 gcache_extra_usage;	/* used in extra buffer (incl dead space) */
 	pg_atomic_uint64 gcache_extra_dead;		/* dead space in extra buffer */
 
+	/* eviction to the host memory, by pg_strom.gpucache_device_budget */
+	pg_atomic_uint32 gcache_evicted;		/* preferred location is host */
+	pg_atomic_uint64 gcache_evict_count;
+	pg_atomic_uint64 gcache_restore_count;
+
+	/* progress of the initial loading */
+	pg_atomic_uint64 initload_nblocks_total;
+	pg_atomic_uint64 initload_nblocks_done;
+
 	/* rowid-map propertoes */
-	pthread_mutex_t	rowid_mutex;
-	uint32_t		rowid_next_free;
-	uint32_t		rowid_num_free;
+	GpuCacheRowIdPart rowid_parts[GCACHE_ROWID_NPARTS];
 
-	/* redo buffer properties */
+	/*
+	 * redo buffer properties
+	 *
+	 * The writers reserve [redo_reserve_pos, +length) under the redo_mutex,
+	 * copy the log without the lock, then publish it by redo_write_pos in
+	 * the order of reservation (see __gpuCacheAppendLog). Everything prior
+	 * to redo_write_pos is visible to the GPU service.
+	 */
 	pthread_mutex_t	redo_mutex;
+	pthread_cond_t	redo_cond;		/* wakes up the writers to publish */
 	uint64_t		redo_write_timestamp;
 	uint64_t		redo_write_nitems;
+	uint64_t		redo_reserve_pos;
 	uint64_t		redo_write_pos;
 	uint64_t		redo_read_nitems;
 	uint64_t		redo_read_pos;
 	uint64_t		redo_sync_pos;
+	uint64_t		redo_apply_timestamp;	/* last application of REDO logs */
+	bool			snapshot_valid;	/* on-disk snapshot is up-to-date */
+	bool			agg_invalid;	/* aggregation slots are exhausted */
 
 	/* schema definitions (KDS_FORMAT_COLUMN) */
 	size_t			kds_extra_sz;
@@ -131,6 +199,34 @@ typedef struct
 			 ".gpucache_p%u_d%u_r%u.%09lx.buf",							\
 			 PostPortNumber, (datOid), (relOid), (signature))
 
+/*
+ * GpuCacheSnapshotHead
+ *
+ * On-disk snapshot of the device buffers, written by GpuService when all the
+ * REDO logs are applied and no in-progress transactions are in the buffer.
+ * It is valid only until the next REDO log is appended; the backend removes
+ * the file prior to the update.
+ */
+typedef struct
+{
+	char			magic[8];	/* = "GCSNAP01" */
+	uint64_t		system_identifier;
+	GpuCacheIdent	ident;
+	GpuCacheOptions	gc_options;
+	TimestampTz		timestamp;
+	uint64_t		main_size;
+	uint64_t		extra_size;
+	uint64_t		extra_usage;
+	uint64_t		extra_dead;
+} GpuCacheSnapshotHead;
+
+#define GpuCacheSnapshotName(nameBuf,nameLen,ident)						\
+	snprintf((nameBuf), (nameLen),										\
+			 "%s/gpucache_p%u_d%u_r%u.%09lx.snap",						\
+			 pgstrom_gpucache_snapshot_dir, PostPortNumber,			\
+			 (ident)->database_oid, (ident)->table_oid,					\
+			 (ident)->signature)
+
 /*
  * GpuCacheRowIdItem
  */
@@ -163,7 +259,7 @@ gpuCacheRowIdItemArray(GpuCacheSharedState *gc_sstate)
 /*
  * GpuCacheLocalMapping
  */
-typedef struct
+typedef struct GpuCacheLocalMapping
 {
 	dlist_node		chain;
 	GpuCacheIdent	ident;
@@ -176,8 +272,30 @@ typedef struct
 	CUdeviceptr		gcache_extra_devptr;
 	ssize_t			gcache_main_size;
 	ssize_t			gcache_extra_size;
+	uint64_t		gcache_version;	/* incremented on buffer updates */
+	TimestampTz		gcache_last_access;	/* last scan, for LRU eviction */
+	/* read-only replicas on the other devices (gpu_replicas option) */
+	struct GpuCacheLocalMapping *primary;	/* back-link, if replica */
+	struct GpuCacheLocalMapping **replicas;	/* indexed by cuda_dindex */
+	int				replica_dindex;	/* device of the replica */
 } GpuCacheLocalMapping;
 
+/*
+ * Kernel functions to apply REDO logs, per device; set up by the GpuCache
+ * manager, and used by GpuService workers for merge-on-read and replicas.
+ */
+typedef struct
+{
+	CUcontext	cuda_context;
+	CUfunction	f_gcache_apply_redo;
+	CUfunction	f_gcache_compaction;
+} GpuCacheDeviceFuncs;
+
+static GpuCacheDeviceFuncs *gcache_device_funcs = NULL;	/* GpuService only */
+
+/* max number of retries of the concurrent compaction */
+#define GCACHE_COMPACTION_MAX_RETRY		4
+
 /*
  * GpuCacheDesc (GpuCache Descriptor per backend)
  */
@@ -203,6 +321,13 @@ typedef struct
 /* --- static variables --- */
 static char	   *pgstrom_gpucache_auto_preload;		/* GUC */
 static bool		pgstrom_enable_gpucache;			/* GUC */
+static char	   *pgstrom_gpucache_snapshot_dir;		/* GUC */
+static int		pgstrom_gpucache_snapshot_interval;	/* GUC */
+static int		pgstrom_gpucache_device_budget;		/* GUC */
+static int		pgstrom_gpucache_initload_workers;	/* GUC */
+static char	   *pgstrom_gpucache_wal_sync_databases;	/* GUC */
+static bool		gcache_walsync_worker = false;
+static HTAB	   *gcache_walsync_xacts_htab = NULL;
 static GpuCacheSharedHead *gcache_shared_head = NULL;
 static HTAB	   *gcache_descriptors_htab = NULL;
 static HTAB	   *gcache_signatures_htab = NULL;
@@ -215,7 +340,16 @@ static bool		__gpuCacheAppendLog(GpuCacheDesc *gc_desc,
 									GCacheTxLogCommon *tx_log);
 static void		gpuCacheInvokeDropUnload(const GpuCacheDesc *gc_desc,
 										 bool is_async);
+static void		__gpucacheAdviseLocation(CUdeviceptr m_buffer, size_t length,
+										 CUdevice location, bool prefetch);
+static void		__gpucacheReleaseReplicaBuffer(struct GpuCacheLocalMapping *replica);
+static void		__gpuCacheInvokeBackgroundCommand(const GpuCacheIdent *ident,
+												  int cuda_dindex,
+												  bool is_async,
+												  int command,
+												  uint64 end_pos);
 void	gpuCacheStartupPreloader(Datum arg);
+void	gpuCacheWalSyncWorkerMain(Datum arg);
 
 /*
  * gpucache_sync_trigger_function_oid
@@ -252,6 +386,63 @@ gpucache_sync_trigger_function_oid(void)
 	return __gpucache_sync_trigger_function_oid;
 }
 
+/*
+ * __parseColumnEncodingItem
+ *
+ * It parses an item of the 'column_encoding' option in the form of
+ * <column name>:<encoding>, then returns one of KDS_COLUMN_ENCODING__*,
+ * or -1 on syntax error. The item shall be destructed.
+ */
+static int
+__parseColumnEncodingItem(char *item, char **p_attname, int *p_enc_unitsz)
+{
+	char	   *enc = strrchr(item, ':');
+
+	if (!enc || enc == item)
+		return -1;
+	*enc++ = '\0';
+	*p_attname = item;
+	*p_enc_unitsz = 0;
+	if (strcmp(enc, "dict") == 0)
+		return KDS_COLUMN_ENCODING__DICT;
+	if (strcmp(enc, "for8") == 0)
+		*p_enc_unitsz = sizeof(int8);
+	else if (strcmp(enc, "for16") == 0)
+		*p_enc_unitsz = sizeof(int16);
+	else if (strcmp(enc, "for32") == 0)
+		*p_enc_unitsz = sizeof(int32);
+	else
+		return -1;
+	return KDS_COLUMN_ENCODING__BITPACK;
+}
+
+/*
+ * __lookupColumnEncoding
+ */
+static int
+__lookupColumnEncoding(const GpuCacheOptions *gc_options,
+					   const char *attname, int *p_enc_unitsz)
+{
+	char	   *config, *item, *saved;
+
+	if (gc_options->column_encoding[0] == '\0')
+		return KDS_COLUMN_ENCODING__PLAIN;
+	config = alloca(strlen(gc_options->column_encoding) + 1);
+	strcpy(config, gc_options->column_encoding);
+	for (item = strtok_r(config, " ", &saved);
+		 item != NULL;
+		 item = strtok_r(NULL,   " ", &saved))
+	{
+		char   *name;
+		int		encoding;
+
+		encoding = __parseColumnEncodingItem(item, &name, p_enc_unitsz);
+		if (encoding >= 0 && strcmp(name, attname) == 0)
+			return encoding;
+	}
+	return KDS_COLUMN_ENCODING__PLAIN;
+}
+
 /*
  * parseSyncTriggerOptions
  */
@@ -259,11 +450,17 @@ static bool
 __parseSyncTriggerOptions(const char *__config, GpuCacheOptions *gc_options)
 {
 	int			cuda_dindex = 0;				/* default: GPU0 */
+	int			device_placement = GCACHE_DEVICE_PLACEMENT__FIXED;
 	int			gpu_sync_interval = 5000000L;	/* default: 5sec = 5000000us */
 	ssize_t		gpu_sync_threshold = -1;		/* default: auto */
 	int64		max_num_rows = (10UL << 20);	/* default: 10M rows */
 	int64		rowid_hash_nslots = -1;			/* default: auto */
 	ssize_t		redo_buffer_size = (160UL << 20);	/* default: 160MB */
+	int			sync_mode = GCACHE_SYNC_MODE__TRIGGER;
+	char	   *column_encoding = NULL;
+	char	   *hash_index = NULL;
+	char	   *aggregate = NULL;
+	uint64		replica_mask = 0;
 	char	   *config;
 	char	   *key, *value;
 	char	   *saved;
@@ -293,6 +490,20 @@ __parseSyncTriggerOptions(const char *__config, GpuCacheOptions *gc_options)
 			int		i, gpu_device_id;
 			char   *end;
 
+			/* partitions are distributed over the GPUs, if any */
+			if (strcmp(value, "roundrobin") == 0)
+			{
+				device_placement = GCACHE_DEVICE_PLACEMENT__ROUNDROBIN;
+				cuda_dindex = 0;
+				continue;
+			}
+			if (strcmp(value, "hash") == 0)
+			{
+				device_placement = GCACHE_DEVICE_PLACEMENT__HASH;
+				cuda_dindex = 0;
+				continue;
+			}
+			device_placement = GCACHE_DEVICE_PLACEMENT__FIXED;
 			gpu_device_id = strtol(value, &end, 10);
 			if (*end != '\0')
 			{
@@ -391,6 +602,99 @@ __parseSyncTriggerOptions(const char *__config, GpuCacheOptions *gc_options)
 				return false;
 			}
 		}
+		else if (strcmp(key, "sync_mode") == 0)
+		{
+			if (strcmp(value, "trigger") == 0)
+				sync_mode = GCACHE_SYNC_MODE__TRIGGER;
+			else if (strcmp(value, "wal") == 0)
+				sync_mode = GCACHE_SYNC_MODE__WAL;
+			else
+			{
+				elog(WARNING, "gpucache: invalid option [%s]=[%s]",
+					 key, value);
+				return false;
+			}
+		}
+		else if (strcmp(key, "column_encoding") == 0)
+		{
+			char   *temp, *item, *saved2;
+
+			if (strlen(value) >= GCACHE_COLUMN_ENCODING_MAXLEN)
+			{
+				elog(WARNING, "gpucache: 'column_encoding' too long");
+				return false;
+			}
+			temp = alloca(strlen(value) + 1);
+			strcpy(temp, value);
+			for (item = strtok_r(temp, " ", &saved2);
+				 item != NULL;
+				 item = strtok_r(NULL, " ", &saved2))
+			{
+				char   *name;
+				int		enc_unitsz;
+
+				if (__parseColumnEncodingItem(item, &name, &enc_unitsz) < 0)
+				{
+					elog(WARNING, "gpucache: invalid option [%s]=[%s]",
+						 key, value);
+					return false;
+				}
+			}
+			column_encoding = value;
+		}
+		else if (strcmp(key, "hash_index") == 0)
+		{
+			if (strlen(value) >= NAMEDATALEN)
+			{
+				elog(WARNING, "gpucache: invalid option [%s]=[%s]",
+					 key, value);
+				return false;
+			}
+			hash_index = value;
+		}
+		else if (strcmp(key, "gpu_replicas") == 0)
+		{
+			char   *tok, *pos;
+
+			/* colon separated list of GPU_ID */
+			for (tok = strtok_r(value, ":", &pos);
+				 tok != NULL;
+				 tok = strtok_r(NULL, ":", &pos))
+			{
+				char   *end;
+				int		gpu_device_id = strtol(__trim(tok), &end, 10);
+				int		k;
+
+				if (*end != '\0')
+				{
+					elog(WARNING, "gpucache: invalid option [%s]=[%s]",
+						 key, value);
+					return false;
+				}
+				for (k=0; k < numGpuDevAttrs; k++)
+				{
+					if (gpuDevAttrs[k].DEV_ID == gpu_device_id)
+						break;
+				}
+				if (k >= numGpuDevAttrs || k >= 64)
+				{
+					elog(WARNING, "gpucache: gpu_replicas (%d) not found",
+						 gpu_device_id);
+					return false;
+				}
+				replica_mask |= (1UL << k);
+			}
+		}
+		else if (strcmp(key, "aggregate") == 0)
+		{
+			if (strlen(value) >= GCACHE_AGGREGATE_MAXLEN)
+			{
+				elog(WARNING, "gpucache: invalid option [%s]=[%s]",
+					 key, value);
+				return false;
+			}
+			aggregate = value;
+		}
 		else
 		{
 			elog(WARNING, "gpucache: unknown option [%s]=[%s]", key, value);
@@ -409,15 +713,69 @@ out:
 		if (rowid_hash_nslots < 0)
 			rowid_hash_nslots = (max_num_rows + max_num_rows / 5);
 		gc_options->cuda_dindex       = cuda_dindex;
+		gc_options->device_placement  = device_placement;
 		gc_options->gpu_sync_interval = gpu_sync_interval;
 		gc_options->gpu_sync_threshold = gpu_sync_threshold;
 		gc_options->max_num_rows      = max_num_rows;
 		gc_options->rowid_hash_nslots = rowid_hash_nslots;
 		gc_options->redo_buffer_size  = redo_buffer_size;
+		gc_options->sync_mode         = sync_mode;
+		memset(gc_options->column_encoding, 0, GCACHE_COLUMN_ENCODING_MAXLEN);
+		if (column_encoding)
+			strcpy(gc_options->column_encoding, column_encoding);
+		memset(&gc_options->hash_index, 0, sizeof(NameData));
+		if (hash_index)
+			strcpy(NameStr(gc_options->hash_index), hash_index);
+		gc_options->replica_mask      = replica_mask;
+		memset(gc_options->aggregate, 0, GCACHE_AGGREGATE_MAXLEN);
+		if (aggregate)
+			strcpy(gc_options->aggregate, aggregate);
 	}
 	return true;
 }
 
+/*
+ * __resolveGpuCacheDevicePlacement
+ *
+ * Row triggers declared on a partitioned table are cloned to the partitions,
+ * including the ones attached later, so each partition has its own GpuCache
+ * with the same options. gpu_device_id=roundrobin or hash distributes these
+ * partitions over the GPU devices; roundrobin follows the order of partition
+ * creation (OID), and hash uses the partition name.
+ */
+static void
+__resolveGpuCacheDevicePlacement(Oid table_oid,
+								 const char *relname,
+								 bool relispartition,
+								 GpuCacheOptions *gc_options)
+{
+	if (gc_options->device_placement == GCACHE_DEVICE_PLACEMENT__FIXED ||
+		numGpuDevAttrs <= 1)
+		return;
+	if (gc_options->device_placement == GCACHE_DEVICE_PLACEMENT__HASH)
+	{
+		uint32	hash = hash_any((const unsigned char *)relname,
+								strlen(relname));
+		gc_options->cuda_dindex = hash % numGpuDevAttrs;
+	}
+	else if (relispartition)
+	{
+		Oid			parent_oid = get_partition_parent(table_oid, false);
+		List	   *children = find_inheritance_children(parent_oid, NoLock);
+		ListCell   *lc;
+		int			index = 0;
+
+		foreach (lc, children)
+		{
+			if (lfirst_oid(lc) == table_oid)
+				break;
+			index++;
+		}
+		list_free(children);
+		gc_options->cuda_dindex = index % numGpuDevAttrs;
+	}
+}
+
 /* ------------------------------------------------------------
  *
  * Routines to manage the table signature
@@ -511,6 +869,10 @@ __gpuCacheTableSignature(Relation rel, GpuCacheTableSignatureCache *entry)
 	}
 	if (!OidIsValid(sig->gc_options.tg_sync_row))
 		goto no_gpu_cache;		/* no row sync trigger */
+	__resolveGpuCacheDevicePlacement(RelationGetRelid(rel),
+									 RelationGetRelationName(rel),
+									 rd_rel->relispartition,
+									 &sig->gc_options);
 
 	/* pg_attribute related */
 	for (j=0; j < natts; j++)
@@ -649,6 +1011,11 @@ __gpuCacheTableSignatureSnapshot(HeapTuple pg_class_tuple,
 	systable_endscan(sscan);
 	table_close(srel, AccessShareLock);
 
+	__resolveGpuCacheDevicePlacement(table_oid,
+									 NameStr(pg_class->relname),
+									 pg_class->relispartition,
+									 &sig->gc_options);
+
 	/* pg_attribute */
 	srel = table_open(AttributeRelationId, AccessShareLock);
 	ScanKeyInit(&skey[0],
@@ -752,13 +1119,131 @@ __gpuCacheSharedMappingHashSlot(Oid database_oid,
 	return &gcache_shared_mapping_slot[hash % GCACHE_SHARED_MAPPING_NSLOTS];
 }
 
+/*
+ * __gpuCacheHashIndexTypeSupported
+ *
+ * hash-index works on the raw bytes of the values, so only the data types
+ * whose equality is identical to the binary comparison are supported.
+ */
+static bool
+__gpuCacheHashIndexTypeSupported(Form_pg_attribute attr)
+{
+	switch (attr->atttypid)
+	{
+		case INT2OID:
+		case INT4OID:
+		case INT8OID:
+		case OIDOID:
+		case DATEOID:
+		case TIMEOID:
+		case TIMESTAMPOID:
+		case TIMESTAMPTZOID:
+		case UUIDOID:
+			return true;
+		case TEXTOID:
+		case VARCHAROID:
+			return (!OidIsValid(attr->attcollation) ||
+					get_collation_isdeterministic(attr->attcollation));
+		default:
+			break;
+	}
+	return false;
+}
+
+/*
+ * __setup_gpucache_aggregate
+ *
+ * aggregate=<key>[:<value>] option maintains count(*), count(value) and
+ * sum(value) grouped by the key column on the device, according to the
+ * REDO logs. Only integer keys and numeric values are supported.
+ */
+static size_t
+__setup_gpucache_aggregate(kern_data_store *kds_head,
+						   Relation rel,
+						   const GpuCacheOptions *gc_options,
+						   uint32_t nrooms,
+						   size_t off)
+{
+	TupleDesc	tupdesc = RelationGetDescr(rel);
+	char	   *kname = pstrdup(gc_options->aggregate);
+	char	   *vname = strchr(kname, ':');
+	AttrNumber	kanum;
+	AttrNumber	vanum = InvalidAttrNumber;
+	bool		value_float = false;
+	kern_colmeta *cmeta;
+
+	if (vname)
+		*vname++ = '\0';
+	kanum = get_attnum(RelationGetRelid(rel), __trim(kname));
+	if (kanum <= 0 || kanum > tupdesc->natts)
+	{
+		elog(WARNING, "gpucache: aggregate key '%s' not found on %s",
+			 kname, RelationGetRelationName(rel));
+		return off;
+	}
+	switch (TupleDescAttr(tupdesc, kanum-1)->atttypid)
+	{
+		case INT2OID:
+		case INT4OID:
+		case INT8OID:
+		case DATEOID:
+			break;
+		default:
+			elog(WARNING, "gpucache: aggregate key '%s' must be integer or date",
+				 kname);
+			return off;
+	}
+	if (vname)
+	{
+		vanum = get_attnum(RelationGetRelid(rel), __trim(vname));
+		if (vanum <= 0 || vanum > tupdesc->natts)
+		{
+			elog(WARNING, "gpucache: aggregate value '%s' not found on %s",
+				 vname, RelationGetRelationName(rel));
+			return off;
+		}
+		switch (TupleDescAttr(tupdesc, vanum-1)->atttypid)
+		{
+			case INT2OID:
+			case INT4OID:
+			case INT8OID:
+				break;
+			case FLOAT4OID:
+			case FLOAT8OID:
+				value_float = true;
+				break;
+			default:
+				elog(WARNING, "gpucache: aggregate value '%s' must be integer or floating-point",
+					 vname);
+				return off;
+		}
+	}
+	cmeta = &kds_head->colmeta[kanum-1];
+	cmeta->agg_nslots = GCACHE_AGG_NSLOTS;
+	cmeta->agg_value_anum = vanum;
+	cmeta->agg_value_float = value_float;
+	cmeta->agg_offset = __kds_packed(off);
+	off += MAXALIGN(sizeof(kern_gpucache_aggslot) * GCACHE_AGG_NSLOTS);
+	cmeta->agg_counted = __kds_packed(off);
+	off += MAXALIGN(BITMAPLEN(nrooms));
+
+	return off;
+}
+
 /*
  * __setup_kern_data_store_column
+ *
+ * NOTE: varlena columns with dictionary encoding put their hash slots at
+ * the head of the extra buffer, so dict_offset is an offset from the extra
+ * buffer, not the kds.
  */
+#define GCACHE_DICT_MAX_NSLOTS		(1U<<20)
+
 static void
 __setup_kern_data_store_column(kern_data_store *kds_head,
 							   size_t *p_extra_sz,
 							   Relation rel,
+							   const GpuCacheOptions *gc_options,
 							   uint32_t nrooms)
 {
 	TupleDesc	tupdesc = RelationGetDescr(rel);
@@ -766,6 +1251,9 @@ __setup_kern_data_store_column(kern_data_store *kds_head,
 	size_t		sz, off;
 	size_t		unitsz;
 	size_t		extra_sz = 0;
+	size_t		dict_off = MAXALIGN(offsetof(kern_data_extra, data));
+	int			encoding;
+	int			enc_unitsz;
 
 	setup_kern_data_store(kds_head, tupdesc, 0, KDS_FORMAT_COLUMN);
 	kds_head->table_oid = RelationGetRelid(rel);
@@ -786,10 +1274,38 @@ __setup_kern_data_store_column(kern_data_store *kds_head,
 			off += sz;
 		}
 
+		encoding = __lookupColumnEncoding(gc_options,
+										  NameStr(attr->attname),
+										  &enc_unitsz);
 		if (attr->attlen > 0)
 		{
 			unitsz = att_align_nominal(attr->attlen,
 									   attr->attalign);
+			if (encoding == KDS_COLUMN_ENCODING__BITPACK)
+			{
+				if ((attr->atttypid == INT2OID ||
+					 attr->atttypid == INT4OID ||
+					 attr->atttypid == INT8OID ||
+					 attr->atttypid == DATEOID ||
+					 attr->atttypid == TIMEOID ||
+					 attr->atttypid == TIMESTAMPOID ||
+					 attr->atttypid == TIMESTAMPTZOID) &&
+					enc_unitsz < attr->attlen)
+				{
+					cmeta->col_encoding = KDS_COLUMN_ENCODING__BITPACK;
+					cmeta->enc_unitsz = enc_unitsz;
+					cmeta->enc_base = KDS_COLUMN_ENC_BASE__UNSET;
+					unitsz = enc_unitsz;
+				}
+				else
+					elog(WARNING, "gpucache: frame-of-reference encoding is not applicable to %s.%s",
+						 RelationGetRelationName(rel),
+						 NameStr(attr->attname));
+			}
+			else if (encoding == KDS_COLUMN_ENCODING__DICT)
+				elog(WARNING, "gpucache: dictionary encoding is not applicable to fixed-length column %s.%s",
+					 RelationGetRelationName(rel),
+					 NameStr(attr->attname));
 			sz = MAXALIGN(unitsz * nrooms);
 			cmeta->values_offset = __kds_packed(off);
 			cmeta->values_length = __kds_packed(sz);
@@ -804,6 +1320,18 @@ __setup_kern_data_store_column(kern_data_store *kds_head,
 			unitsz = get_typavgwidth(attr->atttypid,
 									 attr->atttypmod);
 			extra_sz += MAXALIGN(unitsz) * nrooms;
+			if (encoding == KDS_COLUMN_ENCODING__DICT)
+			{
+				cmeta->col_encoding = KDS_COLUMN_ENCODING__DICT;
+				cmeta->dict_offset = __kds_packed(dict_off);
+				cmeta->dict_nslots = Min(nrooms + nrooms / 4,
+										 GCACHE_DICT_MAX_NSLOTS);
+				dict_off += MAXALIGN(sizeof(uint32) * cmeta->dict_nslots);
+			}
+			else if (encoding == KDS_COLUMN_ENCODING__BITPACK)
+				elog(WARNING, "gpucache: frame-of-reference encoding is not applicable to %s.%s",
+					 RelationGetRelationName(rel),
+					 NameStr(attr->attname));
 		}
 		else
 		{
@@ -819,6 +1347,39 @@ __setup_kern_data_store_column(kern_data_store *kds_head,
 	cmeta->values_offset = __kds_packed(off);
 	cmeta->values_length = __kds_packed(sz);
 	off += sz;
+
+	/* hash-index, if any */
+	if (NameStr(gc_options->hash_index)[0] != '\0')
+	{
+		AttrNumber	anum = get_attnum(RelationGetRelid(rel),
+									  NameStr(gc_options->hash_index));
+
+		if (anum <= 0 || anum > tupdesc->natts)
+			elog(WARNING, "gpucache: hash_index column '%s' not found on %s",
+				 NameStr(gc_options->hash_index),
+				 RelationGetRelationName(rel));
+		else if (!__gpuCacheHashIndexTypeSupported(TupleDescAttr(tupdesc, anum-1)))
+			elog(WARNING, "gpucache: hash_index is not supported on %s.%s",
+				 RelationGetRelationName(rel),
+				 NameStr(gc_options->hash_index));
+		else
+		{
+			cmeta = &kds_head->colmeta[anum-1];
+			/* 50% load factor */
+			cmeta->hindex_nslots = Max(2 * nrooms, GCACHE_HINDEX_MAX_PROBES);
+			sz = MAXALIGN(sizeof(uint64) * cmeta->hindex_nslots);
+			cmeta->hindex_offset = __kds_packed(off);
+			off += sz;
+			sz = MAXALIGN(sizeof(uint32) * nrooms);
+			cmeta->hindex_rowpos = __kds_packed(off);
+			off += sz;
+		}
+	}
+
+	/* maintained aggregation, if any */
+	if (gc_options->aggregate[0] != '\0')
+		off = __setup_gpucache_aggregate(kds_head, rel, gc_options,
+										 nrooms, off);
 	kds_head->length = off;
 
 	/* varlena buffer size */
@@ -826,7 +1387,8 @@ __setup_kern_data_store_column(kern_data_store *kds_head,
 	{
 		/* 25% margin */
 		extra_sz += extra_sz / 4;
-		extra_sz += offsetof(kern_data_extra, data);
+		/* header and dictionary slots, if any */
+		extra_sz += dict_off;
 	}
 	*p_extra_sz = extra_sz;
 }
@@ -888,6 +1450,7 @@ __openGpuCacheSharedState(Oid database_oid,
 				 namebuf, stat_buf.st_size);
 		goto bailout;
 	}
+	__shmemAdviseHugePages(gc_sstate, stat_buf.st_size);
 	/*
 	 * wait for completion of the initial setup
 	 */
@@ -936,8 +1499,14 @@ __openGpuCacheSharedState(Oid database_oid,
 		snprintf(errbuf, errbuf_sz, "GpuCacheSharedState validation error");
 		goto bailout;
 	}
-	off += gc_sstate->gc_options.redo_buffer_size;
-	if (off != stat_buf.st_size)
+	off += PAGE_ALIGN(gc_sstate->gc_options.redo_buffer_size);
+	if (off != gc_sstate->agg_buffer_offset)
+	{
+		snprintf(errbuf, errbuf_sz, "GpuCacheSharedState validation error");
+		goto bailout;
+	}
+	off += GCACHE_AGG_BUFFER_SIZE(&gc_sstate->gc_options);
+	if (__shmemAlignSize(off) != stat_buf.st_size)
 	{
 		snprintf(errbuf, errbuf_sz,
 				 "GpuCacheSharedState validation error");
@@ -980,35 +1549,96 @@ bailout:
 }
 
 /*
- * __resetGpuCacheSharedState
+ * __lockGpuCacheRowIdMap / __unlockGpuCacheRowIdMap
+ *
+ * It locks all the partitions of the rowid-map, for the entire reset.
  */
 static void
-__resetGpuCacheSharedState(GpuCacheSharedState *gc_sstate)
+__lockGpuCacheRowIdMap(GpuCacheSharedState *gc_sstate)
+{
+	for (int p=0; p < GCACHE_ROWID_NPARTS; p++)
+		pthreadMutexLock(&gc_sstate->rowid_parts[p].mutex);
+}
+
+static void
+__unlockGpuCacheRowIdMap(GpuCacheSharedState *gc_sstate)
+{
+	for (int p=GCACHE_ROWID_NPARTS; p-- > 0; )
+		pthreadMutexUnlock(&gc_sstate->rowid_parts[p].mutex);
+}
+
+/*
+ * __gpuCacheRowIdNumFree
+ */
+static uint64_t
+__gpuCacheRowIdNumFree(GpuCacheSharedState *gc_sstate)
+{
+	uint64_t	num_free = 0;
+
+	/* just for information, so no locks */
+	for (int p=0; p < GCACHE_ROWID_NPARTS; p++)
+		num_free += (volatile uint32_t)gc_sstate->rowid_parts[p].num_free;
+	return num_free;
+}
+
+/*
+ * __resetGpuCacheRowIdMap
+ */
+static void
+__resetGpuCacheRowIdMap(GpuCacheSharedState *gc_sstate)
 {
 	uint32_t   *rowid_hslot = gpuCacheRowIdHashSlot(gc_sstate);
 	GpuCacheRowIdItem *rowid_items = gpuCacheRowIdItemArray(gc_sstate);
 	uint32_t	rowid_nslots = gc_sstate->gc_options.rowid_hash_nslots;
 	uint32_t	rowid_nrooms = gc_sstate->gc_options.max_num_rows;
 
-	/* reset rowid-map */
-	pthreadMutexLock(&gc_sstate->rowid_mutex);
+	__lockGpuCacheRowIdMap(gc_sstate);
 	for (uint32_t i=0; i < rowid_nslots; i++)
 		rowid_hslot[i] = UINT_MAX;
-	for (uint32_t i=1; i < rowid_nrooms; i++)
-		rowid_items[i-1].next = i;
-	rowid_items[rowid_nrooms-1].next = UINT_MAX;	/* terminator */
-	gc_sstate->rowid_next_free = 0;
-	gc_sstate->rowid_num_free = rowid_nrooms;
-	pthreadMutexUnlock(&gc_sstate->rowid_mutex);
+	for (uint32_t i=0; i < rowid_nrooms; i++)
+	{
+		if (i + GCACHE_ROWID_NPARTS < rowid_nrooms)
+			rowid_items[i].next = i + GCACHE_ROWID_NPARTS;
+		else
+			rowid_items[i].next = UINT_MAX;		/* terminator */
+	}
+	for (uint32_t p=0; p < GCACHE_ROWID_NPARTS; p++)
+	{
+		GpuCacheRowIdPart *part = &gc_sstate->rowid_parts[p];
+
+		if (p < rowid_nrooms)
+		{
+			part->next_free = p;
+			part->num_free = (rowid_nrooms - p - 1) / GCACHE_ROWID_NPARTS + 1;
+		}
+		else
+		{
+			part->next_free = UINT_MAX;
+			part->num_free = 0;
+		}
+	}
+	__unlockGpuCacheRowIdMap(gc_sstate);
+}
+
+/*
+ * __resetGpuCacheSharedState
+ */
+static void
+__resetGpuCacheSharedState(GpuCacheSharedState *gc_sstate)
+{
+	/* reset rowid-map */
+	__resetGpuCacheRowIdMap(gc_sstate);
 
 	/* reset redo-log-buffer */
 	pthreadMutexLock(&gc_sstate->redo_mutex);
 	gc_sstate->redo_write_timestamp = GetCurrentTimestamp();
 	gc_sstate->redo_write_nitems = 0;
+	gc_sstate->redo_reserve_pos = 0;
     gc_sstate->redo_write_pos = 0;
     gc_sstate->redo_read_nitems = 0;
     gc_sstate->redo_read_pos = 0;
     gc_sstate->redo_sync_pos = 0;
+	gc_sstate->redo_apply_timestamp = GetCurrentTimestamp();
 	pthreadMutexUnlock(&gc_sstate->redo_mutex);
 
 	/* make this GpuCache available again */
@@ -1027,6 +1657,7 @@ __createGpuCacheSharedState(Relation rel,
 	int			fdesc = -1;
 	size_t		rowid_map_offset;
 	size_t		redo_buffer_offset;
+	size_t		agg_buffer_offset;
 	size_t		mmap_sz;
 	char		namebuf[MAXPGPATH];
 	dlist_head *hslot;
@@ -1045,6 +1676,9 @@ __createGpuCacheSharedState(Relation rel,
 						  sizeof(GpuCacheRowIdItem) * gc_options->max_num_rows);
 	redo_buffer_offset = mmap_sz;
 	mmap_sz += PAGE_ALIGN(gc_options->redo_buffer_size);
+	agg_buffer_offset = mmap_sz;
+	mmap_sz += GCACHE_AGG_BUFFER_SIZE(gc_options);
+	mmap_sz = __shmemAlignSize(mmap_sz);
 
 	fdesc = shm_open(namebuf, O_RDWR | O_CREAT | O_EXCL | O_TRUNC, 0600);
 	if (fdesc < 0)
@@ -1072,6 +1706,7 @@ __createGpuCacheSharedState(Relation rel,
 						 fdesc, 0);
 		if (gc_sstate == MAP_FAILED)
 			elog(ERROR, "failed on mmap('%s',%zu): %m", namebuf, mmap_sz);
+		__shmemAdviseHugePages(gc_sstate, mmap_sz);
 		memset(gc_sstate, 0, offsetof(GpuCacheSharedState, kds_head));
 		memcpy(gc_sstate->magic, "GpuCache", 8);
 		gc_sstate->ident.database_oid = MyDatabaseId;
@@ -1080,12 +1715,16 @@ __createGpuCacheSharedState(Relation rel,
 		strncpy(gc_sstate->table_name, RelationGetRelationName(rel), NAMEDATALEN);
 		gc_sstate->rowid_map_offset = rowid_map_offset;
 		gc_sstate->redo_buffer_offset = redo_buffer_offset;
+		gc_sstate->agg_buffer_offset = agg_buffer_offset;
 		memcpy(&gc_sstate->gc_options, gc_options, sizeof(GpuCacheOptions));
-		pthreadMutexInitShared(&gc_sstate->rowid_mutex);
+		for (int p=0; p < GCACHE_ROWID_NPARTS; p++)
+			pthreadMutexInitShared(&gc_sstate->rowid_parts[p].mutex);
 		pthreadMutexInitShared(&gc_sstate->redo_mutex);
+		pthreadCondInitShared(&gc_sstate->redo_cond);
 		__setup_kern_data_store_column(&gc_sstate->kds_head,
 									   &gc_sstate->kds_extra_sz,
 									   rel,
+									   gc_options,
 									   gc_options->max_num_rows);
 		__resetGpuCacheSharedState(gc_sstate);
 
@@ -1228,6 +1867,20 @@ __removeGpuCacheLocalMapping(GpuCacheLocalMapping *gc_lmap)
 				__FUNCTION__,
 				gc_lmap->gcache_main_devptr,
 				gc_lmap->gcache_extra_devptr);
+	if (gc_lmap->replicas)
+	{
+		for (int k=0; k < numGpuDevAttrs; k++)
+		{
+			GpuCacheLocalMapping *replica = gc_lmap->replicas[k];
+
+			if (replica)
+			{
+				__gpucacheReleaseReplicaBuffer(replica);
+				free(replica);
+			}
+		}
+		free(gc_lmap->replicas);
+	}
 	free(gc_lmap);
 }
 
@@ -1288,85 +1941,214 @@ getGpuCacheDescIdent(const GpuCacheDesc *gc_desc)
 	return &gc_desc->ident;
 }
 
-/* ------------------------------------------------------------
- *
- * Routines to manage RowId
+/*
+ * getGpuCacheDescDevices
  *
- * ------------------------------------------------------------
+ * It returns the set of devices where the GpuCache (and its replicas) are
+ * resident on.
  */
-static uint32_t
-__allocGpuCacheRowId(GpuCacheLocalMapping *gc_lmap, const ItemPointer ctid)
+Bitmapset *
+getGpuCacheDescDevices(const GpuCacheDesc *gc_desc)
 {
-	GpuCacheSharedState *gc_sstate = gc_lmap->gc_sstate;
-	uint32_t   *hslot = gpuCacheRowIdHashSlot(gc_sstate);
-	GpuCacheRowIdItem *rowitems = gpuCacheRowIdItemArray(gc_sstate);
-	uint32_t	hash, hindex;
-	uint32_t	rowid;
+	Bitmapset  *devs = bms_make_singleton(gc_desc->gc_options.cuda_dindex);
 
-	hash = hash_bytes((unsigned char *)ctid, sizeof(ItemPointerData));
-	hindex = (hash % gc_sstate->gc_options.rowid_hash_nslots);
-
-	pthreadMutexLock(&gc_sstate->rowid_mutex);
-	rowid = gc_sstate->rowid_next_free;
-	if (rowid < gc_sstate->gc_options.max_num_rows)
+	for (int k=0; k < numGpuDevAttrs && k < 64; k++)
 	{
-		GpuCacheRowIdItem *ritem = &rowitems[rowid];
-
-		ItemPointerCopy(ctid, &ritem->ctid);
-		gc_sstate->rowid_next_free = ritem->next;
-		ritem->next = hslot[hindex];
-		hslot[hindex] = rowid;
-		Assert(gc_sstate->rowid_num_free > 0);
-		gc_sstate->rowid_num_free--;
+		if ((gc_desc->gc_options.replica_mask & (1UL << k)) != 0)
+			devs = bms_add_member(devs, k);
 	}
-	else
-	{
-		uint32_t	phase;
+	return devs;
+}
 
-		Assert(rowid == UINT_MAX);
-		phase = pg_atomic_exchange_u32(&gc_sstate->phase,
-									   GCACHE_PHASE__IS_CORRUPTED);
-		if (phase != GCACHE_PHASE__IS_CORRUPTED)
-			elog(WARNING, "gpucache: rowid exceeds max_num_rows (%lu), so it is now switched to 'corrupted' state",
-				 gc_sstate->gc_options.max_num_rows);
-	}
-	pthreadMutexUnlock(&gc_sstate->rowid_mutex);
+/* ------------------------------------------------------------
+ *
+ * Routines to manage on-disk snapshot
+ *
+ * ------------------------------------------------------------
+ */
 
-	return rowid;
+/*
+ * __gpuCacheUnlinkSnapshot
+ *
+ * It removes the snapshot file durably, and returns errno on failure.
+ * Note that it is also called by GpuService, so never raise an error.
+ */
+static int
+__gpuCacheUnlinkSnapshot(const GpuCacheIdent *ident)
+{
+	char		namebuf[MAXPGPATH];
+	int			fdesc;
+
+	if (!pgstrom_gpucache_snapshot_dir)
+		return 0;
+	GpuCacheSnapshotName(namebuf, MAXPGPATH, ident);
+	if (unlink(namebuf) != 0)
+		return (errno == ENOENT ? 0 : errno);
+	fdesc = open(pgstrom_gpucache_snapshot_dir, O_RDONLY);
+	if (fdesc >= 0)
+	{
+		fsync(fdesc);
+		close(fdesc);
+	}
+	return 0;
+}
+
+/*
+ * __gpuCacheInvalidateSnapshotNoLock
+ *
+ * NOTE: caller must hold gc_sstate->redo_mutex
+ */
+static void
+__gpuCacheInvalidateSnapshotNoLock(GpuCacheSharedState *gc_sstate)
+{
+	if (gc_sstate->snapshot_valid)
+	{
+		int		errcode = __gpuCacheUnlinkSnapshot(&gc_sstate->ident);
+
+		/* keep the flag on failure, to retry on the next update */
+		if (errcode == 0)
+			gc_sstate->snapshot_valid = false;
+		else
+			fprintf(stderr, "gpucache: failed to remove snapshot of '%s': %s\n",
+					gc_sstate->table_name, strerror(errcode));
+	}
+}
+
+static void
+__gpuCacheInvalidateSnapshot(GpuCacheSharedState *gc_sstate)
+{
+	pthreadMutexLock(&gc_sstate->redo_mutex);
+	__gpuCacheInvalidateSnapshotNoLock(gc_sstate);
+	pthreadMutexUnlock(&gc_sstate->redo_mutex);
 }
 
+/* ------------------------------------------------------------
+ *
+ * Routines to manage RowId
+ *
+ * ------------------------------------------------------------
+ */
+/*
+ * __popGpuCacheRowIdFreeList
+ *
+ * It picks up a free rowid from the partition 'p' first, then steals from
+ * the other partitions if empty. Returns UINT_MAX if no free rowid.
+ */
 static uint32_t
-__lookupGpuCacheRowId(GpuCacheLocalMapping *gc_lmap, const ItemPointer ctid)
+__popGpuCacheRowIdFreeList(GpuCacheSharedState *gc_sstate, uint32_t p)
+{
+	GpuCacheRowIdItem *rowitems = gpuCacheRowIdItemArray(gc_sstate);
+
+	for (int k=0; k < GCACHE_ROWID_NPARTS; k++)
+	{
+		GpuCacheRowIdPart *part = &gc_sstate->rowid_parts[(p + k) % GCACHE_ROWID_NPARTS];
+		uint32_t	rowid;
+
+		pthreadMutexLock(&part->mutex);
+		rowid = part->next_free;
+		if (rowid < gc_sstate->gc_options.max_num_rows)
+		{
+			part->next_free = rowitems[rowid].next;
+			Assert(part->num_free > 0);
+			part->num_free--;
+			pthreadMutexUnlock(&part->mutex);
+			return rowid;
+		}
+		pthreadMutexUnlock(&part->mutex);
+	}
+	return UINT_MAX;
+}
+
+static uint32_t
+__allocGpuCacheRowId(GpuCacheLocalMapping *gc_lmap, const ItemPointer ctid)
 {
 	GpuCacheSharedState *gc_sstate = gc_lmap->gc_sstate;
 	uint32_t   *hslot = gpuCacheRowIdHashSlot(gc_sstate);
 	GpuCacheRowIdItem *rowitems = gpuCacheRowIdItemArray(gc_sstate);
-	uint32_t	hash, rowid;
-	uint32_t	phase;
+	GpuCacheRowIdPart *part;
+	uint32_t	hash, hindex;
+	uint32_t	rowid;
 
-	phase = pg_atomic_read_u32(&gc_sstate->phase);
-	if (phase == GCACHE_PHASE__IS_CORRUPTED)
-		return UINT_MAX;
+	hash = hash_bytes((unsigned char *)ctid, sizeof(ItemPointerData));
+	hindex = (hash % gc_sstate->gc_options.rowid_hash_nslots);
+	part = &gc_sstate->rowid_parts[hindex % GCACHE_ROWID_NPARTS];
+
+	rowid = __popGpuCacheRowIdFreeList(gc_sstate, hindex % GCACHE_ROWID_NPARTS);
+	if (rowid < gc_sstate->gc_options.max_num_rows)
+	{
+		GpuCacheRowIdItem *ritem = &rowitems[rowid];
+
+		pthreadMutexLock(&part->mutex);
+		ItemPointerCopy(ctid, &ritem->ctid);
+		ritem->next = hslot[hindex];
+		hslot[hindex] = rowid;
+		pthreadMutexUnlock(&part->mutex);
+	}
+	else
+	{
+		uint32_t	phase;
+
+		Assert(rowid == UINT_MAX);
+		phase = pg_atomic_exchange_u32(&gc_sstate->phase,
+									   GCACHE_PHASE__IS_CORRUPTED);
+		if (phase != GCACHE_PHASE__IS_CORRUPTED)
+			elog(WARNING, "gpucache: rowid exceeds max_num_rows (%lu), so it is now switched to 'corrupted' state",
+				 gc_sstate->gc_options.max_num_rows);
+		/* the heap is now ahead of the cache, without any REDO log */
+		__gpuCacheInvalidateSnapshot(gc_sstate);
+	}
+	return rowid;
+}
+
+/*
+ * __findGpuCacheRowId - returns UINT_MAX if ctid is not cached
+ */
+static uint32_t
+__findGpuCacheRowId(GpuCacheLocalMapping *gc_lmap, const ItemPointer ctid)
+{
+	GpuCacheSharedState *gc_sstate = gc_lmap->gc_sstate;
+	uint32_t   *hslot = gpuCacheRowIdHashSlot(gc_sstate);
+	GpuCacheRowIdItem *rowitems = gpuCacheRowIdItemArray(gc_sstate);
+	GpuCacheRowIdPart *part;
+	uint32_t	hash, hindex, rowid;
 
 	/* Lookup the hash slot */
 	hash = hash_bytes((unsigned char *)ctid, sizeof(ItemPointerData));
-	pthreadMutexLock(&gc_sstate->rowid_mutex);
-	rowid = hslot[hash % gc_sstate->gc_options.rowid_hash_nslots];
+	hindex = (hash % gc_sstate->gc_options.rowid_hash_nslots);
+	part = &gc_sstate->rowid_parts[hindex % GCACHE_ROWID_NPARTS];
+	pthreadMutexLock(&part->mutex);
+	rowid = hslot[hindex];
 	while (rowid < gc_sstate->gc_options.max_num_rows)
 	{
 		GpuCacheRowIdItem *ritem = &rowitems[rowid];
 
 		if (ItemPointerEquals(&ritem->ctid, ctid))
-		{
-			pthreadMutexUnlock(&gc_sstate->rowid_mutex);
-			return rowid;
-		}
+			break;
 		rowid = ritem->next;
 	}
-	pthreadMutexUnlock(&gc_sstate->rowid_mutex);
+	pthreadMutexUnlock(&part->mutex);
+
+	return (rowid < gc_sstate->gc_options.max_num_rows ? rowid : UINT_MAX);
+}
+
+static uint32_t
+__lookupGpuCacheRowId(GpuCacheLocalMapping *gc_lmap, const ItemPointer ctid)
+{
+	GpuCacheSharedState *gc_sstate = gc_lmap->gc_sstate;
+	uint32_t	rowid;
+	uint32_t	phase;
+
+	phase = pg_atomic_read_u32(&gc_sstate->phase);
+	if (phase == GCACHE_PHASE__IS_CORRUPTED)
+		return UINT_MAX;
+
+	rowid = __findGpuCacheRowId(gc_lmap, ctid);
+	if (rowid != UINT_MAX)
+		return rowid;
 	/* not found */
 	phase = pg_atomic_exchange_u32(&gc_sstate->phase,
 								   GCACHE_PHASE__IS_CORRUPTED);
+	__gpuCacheInvalidateSnapshot(gc_sstate);
 	if (phase != GCACHE_PHASE__IS_CORRUPTED)
 		elog(WARNING, "gpucache: no rowid was assigned to ctid(%u,%u), so it is now switched to 'corrupted' state",
 			 (uint32_t)ctid->ip_blkid.bi_hi << 16 |
@@ -1381,14 +2163,17 @@ __removeGpuCacheRowId(GpuCacheLocalMapping *gc_lmap, const ItemPointer ctid)
 	GpuCacheSharedState *gc_sstate = gc_lmap->gc_sstate;
 	uint32_t   *hslot = gpuCacheRowIdHashSlot(gc_sstate);
 	GpuCacheRowIdItem *rowitems = gpuCacheRowIdItemArray(gc_sstate);
-	uint32_t	hash, rowid;
+	GpuCacheRowIdPart *part;
+	uint32_t	hash, hindex, rowid;
 	uint32_t   *prev;
 	bool		found = false;
 
 	hash = hash_bytes((unsigned char *)ctid, sizeof(ItemPointerData));
+	hindex = (hash % gc_sstate->gc_options.rowid_hash_nslots);
+	part = &gc_sstate->rowid_parts[hindex % GCACHE_ROWID_NPARTS];
 
-	pthreadMutexLock(&gc_sstate->rowid_mutex);
-	prev = &hslot[hash % gc_sstate->gc_options.rowid_hash_nslots];
+	pthreadMutexLock(&part->mutex);
+	prev = &hslot[hindex];
 	for (rowid = *prev;
 		 rowid < gc_sstate->gc_options.max_num_rows;
 		 rowid = *prev)
@@ -1398,19 +2183,25 @@ __removeGpuCacheRowId(GpuCacheLocalMapping *gc_lmap, const ItemPointer ctid)
 		if (ItemPointerEquals(&ritem->ctid, ctid))
 		{
 			*prev = ritem->next;
-
-			ritem->next = gc_sstate->rowid_next_free;
-			gc_sstate->rowid_next_free = rowid;
 			ItemPointerSetInvalid(&ritem->ctid);
-			gc_sstate->rowid_num_free++;
 			found = true;
 			break;
 		}
 		prev = &ritem->next;
 	}
-	pthreadMutexUnlock(&gc_sstate->rowid_mutex);
+	pthreadMutexUnlock(&part->mutex);
 
-	if (!found)
+	if (found)
+	{
+		/* back to the free-list of the partition that owns the rowid */
+		part = &gc_sstate->rowid_parts[rowid % GCACHE_ROWID_NPARTS];
+		pthreadMutexLock(&part->mutex);
+		rowitems[rowid].next = part->next_free;
+		part->next_free = rowid;
+		part->num_free++;
+		pthreadMutexUnlock(&part->mutex);
+	}
+	else
 		elog(WARNING, "Bug? no rowid for ctid(%u,%u) is not assigned yet",
 			 (uint32_t)ctid->ip_blkid.bi_hi << 16 |
 			 (uint32_t)ctid->ip_blkid.bi_lo,
@@ -1538,6 +2329,60 @@ lookupGpuCacheDesc(Relation rel)
 	return gc_desc;
 }
 
+/*
+ * __gpuCacheWriteXactLogs
+ *
+ * It writes out COMMIT/ABORT logs for the array of PendingCtidItem
+ */
+static void
+__gpuCacheWriteXactLogs(GpuCacheDesc *gc_desc,
+						const char *pos, uint32_t nitems,
+						bool normal_commit)
+{
+	for (uint32_t i=0; i < nitems; i++, pos += sizeof(PendingCtidItem))
+	{
+		PendingCtidItem	   *pitem = (PendingCtidItem *)pos;
+		GCacheTxLogXact		tx_log;
+
+		if (pitem->tag == 'I')
+		{
+			if (normal_commit)
+			{
+				tx_log.type = GCACHE_TX_LOG__COMMIT_INS;
+			}
+			else
+			{
+				tx_log.type = GCACHE_TX_LOG__ABORT_INS;
+				__removeGpuCacheRowId(gc_desc->gc_lmap, &pitem->ctid);
+			}
+			tx_log.length = sizeof(GCacheTxLogXact);
+			tx_log.rowid = pitem->rowid;
+		}
+		else if (pitem->tag == 'D')
+		{
+			if (normal_commit)
+			{
+				tx_log.type = GCACHE_TX_LOG__COMMIT_DEL;
+				__removeGpuCacheRowId(gc_desc->gc_lmap, &pitem->ctid);
+			}
+			else
+			{
+				tx_log.type = GCACHE_TX_LOG__ABORT_DEL;
+			}
+			tx_log.length = sizeof(GCacheTxLogXact);
+			tx_log.rowid = pitem->rowid;
+		}
+		else
+		{
+			elog(WARNING, "Bug? unexpected PendingCtidItem tag '%c'",
+				 pitem->tag);
+			continue;
+		}
+		if (!__gpuCacheAppendLog(gc_desc, (GCacheTxLogCommon *)&tx_log))
+			elog(WARNING, "Bug? unable to write out GpuCache Log");
+	}
+}
+
 static void
 releaseGpuCacheDesc(GpuCacheDesc *gc_desc, bool normal_commit)
 {
@@ -1555,57 +2400,20 @@ releaseGpuCacheDesc(GpuCacheDesc *gc_desc, bool normal_commit)
 								gc_desc->ident.table_oid,
 								gc_desc->ident.signature);
 		shm_unlink(namebuf);
+		/* also remove the on-disk snapshot */
+		errno = __gpuCacheUnlinkSnapshot(&gc_desc->ident);
+		if (errno != 0)
+			elog(WARNING, "gpucache: failed to remove snapshot: %m");
 
 		if (gc_desc->gc_lmap)
 			putGpuCacheLocalMapping(gc_desc->gc_lmap);
 	}
 	else if (gc_desc->gc_lmap)
 	{
-		const char *pos = gc_desc->buf.data;
-
-		for (uint32_t i=0; i < gc_desc->nitems; i++)
-		{
-			PendingCtidItem	   *pitem = (PendingCtidItem *)pos;
-			GCacheTxLogXact		tx_log;
-
-			if (pitem->tag == 'I')
-			{
-				if (normal_commit)
-				{
-					tx_log.type = GCACHE_TX_LOG__COMMIT_INS;
-				}
-				else
-				{
-					tx_log.type = GCACHE_TX_LOG__ABORT_INS;
-					__removeGpuCacheRowId(gc_desc->gc_lmap, &pitem->ctid);
-				}
-				tx_log.length = sizeof(GCacheTxLogXact);
-				tx_log.rowid = pitem->rowid;
-			}
-			else if (pitem->tag == 'D')
-			{
-				if (normal_commit)
-				{
-					tx_log.type = GCACHE_TX_LOG__COMMIT_DEL;
-					__removeGpuCacheRowId(gc_desc->gc_lmap, &pitem->ctid);
-				}
-				else
-				{
-					tx_log.type = GCACHE_TX_LOG__ABORT_DEL;
-				}
-				tx_log.length = sizeof(GCacheTxLogXact);
-				tx_log.rowid = pitem->rowid;
-			}
-			else
-			{
-				elog(WARNING, "Bug? unexpected PendingCtidItem tag '%c'",
-					 pitem->tag);
-				continue;
-			}
-			if (!__gpuCacheAppendLog(gc_desc, (GCacheTxLogCommon *)&tx_log))
-				elog(WARNING, "Bug? unable to write out GpuCache Log");
-			pos += sizeof(PendingCtidItem);
-		}
+		__gpuCacheWriteXactLogs(gc_desc,
+								gc_desc->buf.data,
+								gc_desc->nitems,
+								normal_commit);
 		putGpuCacheLocalMapping(gc_desc->gc_lmap);
 	}
 	/* cleanup itself */
@@ -1880,20 +2688,135 @@ __gpuCacheInitLoadTrackCtid(GpuCacheDesc *gc_desc,
 }
 
 /*
- * __initialLoadGpuCache - entrypoint of the initial loading
+ * Parallel initial loading
+ *
+ * Workers scan the table by the parallel block-based scan, then write out
+ * the INSERT logs to the REDO buffer as like the serial loading doing.
+ * Only the leader can track the rows touched by the current transaction on
+ * its GpuCacheDesc, so workers send them back to the leader via shm_mq.
+ */
+#define GCACHE_INITLOAD_KEY_SHARED		UINT64CONST(0xE000000000000001)
+#define GCACHE_INITLOAD_KEY_PSCAN		UINT64CONST(0xE000000000000002)
+#define GCACHE_INITLOAD_KEY_MQUEUE		UINT64CONST(0xE000000000000003)
+#define GCACHE_INITLOAD_MQUEUE_SIZE		(64 * 1024)
+#define GCACHE_INITLOAD_MIN_NBLOCKS		8192
+
+typedef struct
+{
+	Oid				table_oid;
+	GpuCacheIdent	ident;
+	GpuCacheOptions	gc_options;
+} GpuCacheInitLoadShared;
+
+typedef struct
+{
+	TransactionId	xid;
+	uint32_t		rowid;
+	char			tag;
+	ItemPointerData	ctid;
+} GpuCacheInitLoadCtid;
+
+typedef struct
+{
+	int				nqueues;
+	shm_mq_handle  *mqueues[FLEXIBLE_ARRAY_MEMBER];	/* NULL, if detached */
+} GpuCacheInitLoadReceiver;
+
+/*
+ * __initialLoadGpuCacheDrain
+ *
+ * It fetches the pending ctid items from the workers, then returns true if
+ * all the workers are already detached.
+ */
+static bool
+__initialLoadGpuCacheDrain(GpuCacheDesc *gc_desc,
+						   GpuCacheInitLoadReceiver *recv)
+{
+	bool		all_detached = true;
+
+	for (int i=0; i < recv->nqueues; i++)
+	{
+		shm_mq_handle *mqh = recv->mqueues[i];
+
+		while (mqh)
+		{
+			GpuCacheInitLoadCtid *citem;
+			Size		nbytes;
+			void	   *data;
+			shm_mq_result rv;
+
+			rv = shm_mq_receive(mqh, &nbytes, &data, true);
+			if (rv == SHM_MQ_WOULD_BLOCK)
+			{
+				all_detached = false;
+				break;
+			}
+			if (rv == SHM_MQ_DETACHED)
+			{
+				recv->mqueues[i] = NULL;
+				break;
+			}
+			Assert(rv == SHM_MQ_SUCCESS);
+			if (nbytes != sizeof(GpuCacheInitLoadCtid))
+				elog(ERROR, "gpucache: corrupted initial loading message");
+			citem = (GpuCacheInitLoadCtid *)data;
+			__gpuCacheInitLoadTrackCtid(gc_desc, citem->xid, citem->tag,
+										citem->rowid, &citem->ctid);
+		}
+	}
+	return all_detached;
+}
+
+/*
+ * __initialLoadGpuCacheTrackCtid
  */
 static void
-__initialLoadGpuCache(GpuCacheDesc *gc_desc, Relation rel)
+__initialLoadGpuCacheTrackCtid(GpuCacheDesc *gc_desc,
+							   shm_mq_handle *mqh,
+							   TransactionId xid,
+							   char tag,
+							   uint32_t rowid,
+							   ItemPointer ctid)
+{
+	if (!mqh)
+		__gpuCacheInitLoadTrackCtid(gc_desc, xid, tag, rowid, ctid);
+	else
+	{
+		GpuCacheInitLoadCtid citem;
+
+		memset(&citem, 0, sizeof(GpuCacheInitLoadCtid));
+		citem.xid   = xid;
+		citem.rowid = rowid;
+		citem.tag   = tag;
+		ItemPointerCopy(ctid, &citem.ctid);
+		if (shm_mq_send(mqh, sizeof(GpuCacheInitLoadCtid),
+						&citem, false, true) != SHM_MQ_SUCCESS)
+			elog(ERROR, "gpucache: leader process has gone");
+	}
+}
+
+/*
+ * __initialLoadGpuCacheScan
+ *
+ * It scans the table (or a part of the table on parallel scan) and write out
+ * the INSERT logs. 'mqh' is valid only in the parallel workers, and 'recv'
+ * is valid only in the leader process of the parallel loading.
+ */
+static void
+__initialLoadGpuCacheScan(GpuCacheDesc *gc_desc,
+						  Relation rel,
+						  TableScanDesc hscan,
+						  shm_mq_handle *mqh,
+						  GpuCacheInitLoadReceiver *recv)
 {
-	TableScanDesc	hscan;
+	GpuCacheSharedState *gc_sstate = gc_desc->gc_lmap->gc_sstate;
 	HeapTuple		scantup;
 	HeapTuple		tuple;
+	BlockNumber		curr_block = InvalidBlockNumber;
+	uint64_t		ntuples = 0;
 	size_t			item_sz = 2048;
 	GCacheTxLogInsert *item = alloca(item_sz);
 
-	Assert(gc_desc->gc_lmap != NULL);
-
-	hscan = table_beginscan(rel, SnapshotAny, 0, NULL);
 	while ((scantup = heap_getnext(hscan, ForwardScanDirection)) != NULL)
 	{
 		TransactionId	gcache_xmin;
@@ -1903,6 +2826,16 @@ __initialLoadGpuCache(GpuCacheDesc *gc_desc, Relation rel)
 
 		CHECK_FOR_INTERRUPTS();
 
+		/* progress report */
+		if (curr_block != ItemPointerGetBlockNumber(&scantup->t_self))
+		{
+			curr_block = ItemPointerGetBlockNumber(&scantup->t_self);
+			pg_atomic_fetch_add_u64(&gc_sstate->initload_nblocks_done, 1);
+		}
+		/* leader also receives the messages from the workers */
+		if (recv && (++ntuples % 4096) == 0)
+			__initialLoadGpuCacheDrain(gc_desc, recv);
+
 		if (!__initialLoadGpuCacheVisibilityCheck(scantup,
 												  &gcache_xmin,
 												  &gcache_xmax))
@@ -1921,11 +2854,11 @@ __initialLoadGpuCache(GpuCacheDesc *gc_desc, Relation rel)
 		PG_TRY();
 		{
 			if (TransactionIdIsNormal(gcache_xmin))
-				__gpuCacheInitLoadTrackCtid(gc_desc, gcache_xmin,
-											'I', rowid, &tuple->t_self);
+				__initialLoadGpuCacheTrackCtid(gc_desc, mqh, gcache_xmin,
+											   'I', rowid, &tuple->t_self);
 			if (TransactionIdIsNormal(gcache_xmax))
-				__gpuCacheInitLoadTrackCtid(gc_desc, gcache_xmax,
-											'D', rowid, &tuple->t_self);
+				__initialLoadGpuCacheTrackCtid(gc_desc, mqh, gcache_xmax,
+											   'D', rowid, &tuple->t_self);
 
 			item->type = GCACHE_TX_LOG__INSERT;
 			item->length = sz;
@@ -1945,35 +2878,267 @@ __initialLoadGpuCache(GpuCacheDesc *gc_desc, Relation rel)
 		}
 		PG_END_TRY();
 	}
-	table_endscan(hscan);
 }
 
-static bool
-initialLoadGpuCache(GpuCacheDesc *gc_desc, Relation rel)
+/*
+ * pgstrom_gpucache_initload_worker - entrypoint of the parallel workers
+ */
+PUBLIC_FUNCTION(void)
+pgstrom_gpucache_initload_worker(dsm_segment *seg, shm_toc *toc)
 {
-	GpuCacheSharedState *gc_sstate;
+	GpuCacheInitLoadShared *shared;
+	ParallelTableScanDesc pscan;
+	char	   *mqueues;
+	shm_mq	   *mq;
+	shm_mq_handle *mqh;
+	GpuCacheDesc gc_desc;
+	TableScanDesc hscan;
+	Relation	rel;
 
-	if (!gc_desc->gc_lmap)
+	shared = shm_toc_lookup(toc, GCACHE_INITLOAD_KEY_SHARED, false);
+	pscan = shm_toc_lookup(toc, GCACHE_INITLOAD_KEY_PSCAN, false);
+	mqueues = shm_toc_lookup(toc, GCACHE_INITLOAD_KEY_MQUEUE, false);
+	mq = (shm_mq *)(mqueues + ParallelWorkerNumber * GCACHE_INITLOAD_MQUEUE_SIZE);
+	shm_mq_set_sender(mq, MyProc);
+	mqh = shm_mq_attach(mq, seg, NULL);
+
+	/* a pseudo GpuCacheDesc; only ident, options and mapping are valid */
+	memset(&gc_desc, 0, sizeof(GpuCacheDesc));
+	memcpy(&gc_desc.ident, &shared->ident, sizeof(GpuCacheIdent));
+	memcpy(&gc_desc.gc_options, &shared->gc_options, sizeof(GpuCacheOptions));
+	gc_desc.gc_lmap = getGpuCacheLocalMappingIfExist(shared->ident.database_oid,
+													 shared->ident.table_oid,
+													 shared->ident.signature);
+	if (!gc_desc.gc_lmap)
+		elog(ERROR, "gpucache: shared memory segment of '%s' not found",
+			 get_rel_name(shared->table_oid));
+	PG_TRY();
 	{
-		GpuCacheOptions gc_options;
-		uint64_t	signature;
-
-		signature = gpuCacheTableSignature(rel, &gc_options);
-		Assert(gc_desc->ident.signature == signature);
-		gc_desc->gc_lmap = getGpuCacheLocalMapping(rel, signature, &gc_options);
+		rel = table_open(shared->table_oid, AccessShareLock);
+		hscan = table_beginscan_parallel(rel, pscan);
+		__initialLoadGpuCacheScan(&gc_desc, rel, hscan, mqh, NULL);
+		table_endscan(hscan);
+		table_close(rel, AccessShareLock);
 	}
-	gc_sstate = gc_desc->gc_lmap->gc_sstate;
-	for (;;)
+	PG_CATCH();
 	{
-		uint32_t	phase = GCACHE_PHASE__IS_EMPTY;
+		putGpuCacheLocalMapping(gc_desc.gc_lmap);
+		PG_RE_THROW();
+	}
+	PG_END_TRY();
+	putGpuCacheLocalMapping(gc_desc.gc_lmap);
+	shm_mq_detach(mqh);
+}
 
-		if (pg_atomic_compare_exchange_u32(&gc_sstate->phase,
-										   &phase,
-										   GCACHE_PHASE__IS_LOADING))
+/*
+ * __initialLoadGpuCacheParallel
+ */
+static bool
+__initialLoadGpuCacheParallel(GpuCacheDesc *gc_desc, Relation rel, int nworkers)
+{
+	ParallelContext *pcxt;
+	GpuCacheInitLoadShared *shared;
+	GpuCacheInitLoadReceiver *recv;
+	ParallelTableScanDesc pscan;
+	TableScanDesc hscan;
+	Size		pscan_sz;
+	char	   *mqueues;
+
+	EnterParallelMode();
+	pcxt = CreateParallelContext("$libdir/pg_strom",
+								 "pgstrom_gpucache_initload_worker",
+								 nworkers);
+	pscan_sz = table_parallelscan_estimate(rel, SnapshotAny);
+	shm_toc_estimate_chunk(&pcxt->estimator, sizeof(GpuCacheInitLoadShared));
+	shm_toc_estimate_chunk(&pcxt->estimator, pscan_sz);
+	shm_toc_estimate_chunk(&pcxt->estimator,
+						   GCACHE_INITLOAD_MQUEUE_SIZE * pcxt->nworkers);
+	shm_toc_estimate_keys(&pcxt->estimator, 3);
+	InitializeParallelDSM(pcxt);
+	if (!pcxt->seg)
+	{
+		/* no dynamic shared memory; fall back to the serial loading */
+		DestroyParallelContext(pcxt);
+		ExitParallelMode();
+		return false;
+	}
+	shared = shm_toc_allocate(pcxt->toc, sizeof(GpuCacheInitLoadShared));
+	shared->table_oid = RelationGetRelid(rel);
+	memcpy(&shared->ident, &gc_desc->ident, sizeof(GpuCacheIdent));
+	memcpy(&shared->gc_options, &gc_desc->gc_options, sizeof(GpuCacheOptions));
+	shm_toc_insert(pcxt->toc, GCACHE_INITLOAD_KEY_SHARED, shared);
+
+	pscan = shm_toc_allocate(pcxt->toc, pscan_sz);
+	table_parallelscan_initialize(rel, pscan, SnapshotAny);
+	shm_toc_insert(pcxt->toc, GCACHE_INITLOAD_KEY_PSCAN, pscan);
+
+	mqueues = shm_toc_allocate(pcxt->toc,
+							   GCACHE_INITLOAD_MQUEUE_SIZE * pcxt->nworkers);
+	shm_toc_insert(pcxt->toc, GCACHE_INITLOAD_KEY_MQUEUE, mqueues);
+	recv = palloc0(offsetof(GpuCacheInitLoadReceiver,
+							mqueues[pcxt->nworkers]));
+	for (int i=0; i < pcxt->nworkers; i++)
+	{
+		shm_mq *mq = shm_mq_create(mqueues + i * GCACHE_INITLOAD_MQUEUE_SIZE,
+								   GCACHE_INITLOAD_MQUEUE_SIZE);
+		shm_mq_set_receiver(mq, MyProc);
+		recv->mqueues[i] = shm_mq_attach(mq, pcxt->seg, NULL);
+	}
+	LaunchParallelWorkers(pcxt);
+	recv->nqueues = pcxt->nworkers_launched;
+	for (int i=0; i < pcxt->nworkers_launched; i++)
+		shm_mq_set_handle(recv->mqueues[i], pcxt->worker[i].bgwhandle);
+	elog(DEBUG1, "gpucache: initial loading of '%s' by %d workers",
+		 RelationGetRelationName(rel), pcxt->nworkers_launched);
+
+	/* leader also participates in the scan */
+	hscan = table_beginscan_parallel(rel, pscan);
+	__initialLoadGpuCacheScan(gc_desc, rel, hscan, NULL, recv);
+	table_endscan(hscan);
+
+	/* wait for completion of the workers */
+	while (!__initialLoadGpuCacheDrain(gc_desc, recv))
+	{
+		(void) WaitLatch(MyLatch,
+						 WL_LATCH_SET | WL_TIMEOUT | WL_EXIT_ON_PM_DEATH,
+						 10L,
+						 PG_WAIT_EXTENSION);
+		ResetLatch(MyLatch);
+		CHECK_FOR_INTERRUPTS();
+	}
+	WaitForParallelWorkersToFinish(pcxt);
+	DestroyParallelContext(pcxt);
+	ExitParallelMode();
+	pfree(recv);
+
+	return true;
+}
+
+/*
+ * __initialLoadGpuCache - entrypoint of the initial loading
+ */
+static void
+__initialLoadGpuCache(GpuCacheDesc *gc_desc, Relation rel)
+{
+	GpuCacheSharedState *gc_sstate;
+	BlockNumber	nblocks = RelationGetNumberOfBlocks(rel);
+	int			nworkers = pgstrom_gpucache_initload_workers;
+	TableScanDesc hscan;
+
+	Assert(gc_desc->gc_lmap != NULL);
+	gc_sstate = gc_desc->gc_lmap->gc_sstate;
+	pg_atomic_write_u64(&gc_sstate->initload_nblocks_total, nblocks);
+	pg_atomic_write_u64(&gc_sstate->initload_nblocks_done, 0);
+
+	/* parallel initial loading, if table is large enough */
+	if (nworkers > 0 &&
+		nblocks >= GCACHE_INITLOAD_MIN_NBLOCKS &&
+		IsUnderPostmaster &&
+		!IsInParallelMode())
+	{
+		nworkers = Min(nworkers, nblocks / GCACHE_INITLOAD_MIN_NBLOCKS);
+		if (__initialLoadGpuCacheParallel(gc_desc, rel, nworkers))
+			return;
+	}
+	hscan = table_beginscan(rel, SnapshotAny, 0, NULL);
+	__initialLoadGpuCacheScan(gc_desc, rel, hscan, NULL, NULL);
+	table_endscan(hscan);
+}
+
+/*
+ * __gpuCacheRestoreSnapshot
+ *
+ * It tries to restore the device buffer from the on-disk snapshot, instead of
+ * the heap scan. Any errors are not fatal; caller falls back to the regular
+ * initial loading.
+ */
+static bool
+__gpuCacheRestoreSnapshot(GpuCacheDesc *gc_desc, Relation rel)
+{
+	char		namebuf[MAXPGPATH];
+	struct stat	stat_buf;
+	MemoryContext memcxt = CurrentMemoryContext;
+	bool		retval = false;
+
+	if (!pgstrom_gpucache_snapshot_dir)
+		return false;
+	GpuCacheSnapshotName(namebuf, MAXPGPATH, &gc_desc->ident);
+	if (stat(namebuf, &stat_buf) != 0)
+	{
+		if (errno != ENOENT)
+			elog(LOG, "gpucache: failed on stat('%s'): %m", namebuf);
+		return false;
+	}
+
+	PG_TRY();
+	{
+		__gpuCacheInvokeBackgroundCommand(&gc_desc->ident,
+										  gc_desc->gc_options.cuda_dindex,
+										  false,
+										  GCACHE_CONTROL_CMD__LOAD_SNAPSHOT,
+										  0);
+		retval = true;
+	}
+	PG_CATCH();
+	{
+		ErrorData  *edata;
+
+		MemoryContextSwitchTo(memcxt);
+		edata = CopyErrorData();
+		if (edata->sqlerrcode == ERRCODE_QUERY_CANCELED ||
+			edata->elevel > ERROR)
+			PG_RE_THROW();
+		FlushErrorState();
+
+		elog(LOG, "gpucache: unable to restore '%s' from the snapshot: %s",
+			 RelationGetRelationName(rel), edata->message);
+		FreeErrorData(edata);
+	}
+	PG_END_TRY();
+
+	if (retval)
+		elog(LOG, "gpucache: '%s' was restored from the snapshot (nitems=%lu)",
+			 RelationGetRelationName(rel),
+			 pg_atomic_read_u64(&gc_desc->gc_lmap->gc_sstate->gcache_main_nitems));
+	return retval;
+}
+
+static bool
+initialLoadGpuCache(GpuCacheDesc *gc_desc, Relation rel)
+{
+	GpuCacheSharedState *gc_sstate;
+
+	if (!gc_desc->gc_lmap)
+	{
+		GpuCacheOptions gc_options;
+		uint64_t	signature;
+
+		signature = gpuCacheTableSignature(rel, &gc_options);
+		Assert(gc_desc->ident.signature == signature);
+		gc_desc->gc_lmap = getGpuCacheLocalMapping(rel, signature, &gc_options);
+	}
+	gc_sstate = gc_desc->gc_lmap->gc_sstate;
+	/*
+	 * GpuCache with sync_mode=wal has to be built by the WAL sync worker,
+	 * because the REDO logs are written out from the position of the WAL
+	 * that is consumed at the time.
+	 */
+	if (gc_desc->gc_options.sync_mode == GCACHE_SYNC_MODE__WAL &&
+		!gcache_walsync_worker)
+		return (pg_atomic_read_u32(&gc_sstate->phase) == GCACHE_PHASE__IS_READY);
+	for (;;)
+	{
+		uint32_t	phase = GCACHE_PHASE__IS_EMPTY;
+
+		if (pg_atomic_compare_exchange_u32(&gc_sstate->phase,
+										   &phase,
+										   GCACHE_PHASE__IS_LOADING))
 		{
 			PG_TRY();
 			{
-				__initialLoadGpuCache(gc_desc, rel);
+				if (gc_desc->gc_options.sync_mode == GCACHE_SYNC_MODE__WAL ||
+					!__gpuCacheRestoreSnapshot(gc_desc, rel))
+					__initialLoadGpuCache(gc_desc, rel);
 			}
 			PG_CATCH();
 			{
@@ -2023,6 +3188,9 @@ baseRelHasGpuCache(PlannerInfo *root, RelOptInfo *baserel)
 	RangeTblEntry *rte = root->simple_rte_array[baserel->relid];
 	int		cuda_dindex = -1;
 
+	/* GpuCache is kept by the local GPU service */
+	if (gpuServiceIsRemote())
+		return -1;
 	if (rte->rtekind == RTE_RELATION &&
 		(baserel->reloptkind == RELOPT_BASEREL ||
 		 baserel->reloptkind == RELOPT_OTHER_MEMBER_REL))
@@ -2052,6 +3220,131 @@ baseRelHasGpuCache(PlannerInfo *root, RelOptInfo *baserel)
 	return (pgstrom_enable_gpucache ? cuda_dindex : -1);
 }
 
+/*
+ * baseRelGpuCacheLookupKey
+ *
+ * It picks up the key of the point lookup by the hash-index of GpuCache,
+ * from the device qualifiers in the form of (<key> = <Const or Param>).
+ */
+Expr *
+baseRelGpuCacheLookupKey(PlannerInfo *root, RelOptInfo *baserel,
+						 List *dev_quals, RestrictInfo **p_rinfo)
+{
+	RangeTblEntry *rte = root->simple_rte_array[baserel->relid];
+	GpuCacheOptions gc_options;
+	Relation	rel;
+	AttrNumber	anum = InvalidAttrNumber;
+	Oid			atttypid = InvalidOid;
+	Oid			eq_opr;
+	ListCell   *lc;
+
+	if (!pgstrom_enable_gpucache || rte->rtekind != RTE_RELATION)
+		return NULL;
+	rel = table_open(rte->relid, NoLock);
+	if (gpuCacheTableSignature(rel, &gc_options) != 0UL &&
+		NameStr(gc_options.hash_index)[0] != '\0')
+	{
+		anum = get_attnum(RelationGetRelid(rel),
+						  NameStr(gc_options.hash_index));
+		if (anum > 0 && anum <= RelationGetNumberOfAttributes(rel))
+		{
+			Form_pg_attribute attr = TupleDescAttr(RelationGetDescr(rel), anum-1);
+
+			if (__gpuCacheHashIndexTypeSupported(attr))
+				atttypid = attr->atttypid;
+		}
+	}
+	table_close(rel, NoLock);
+	if (!OidIsValid(atttypid))
+		return NULL;
+	eq_opr = lookup_type_cache(atttypid, TYPECACHE_EQ_OPR)->eq_opr;
+
+	foreach (lc, dev_quals)
+	{
+		RestrictInfo *rinfo = lfirst(lc);
+		OpExpr	   *op = (OpExpr *)rinfo->clause;
+
+		if (!IsA(op, OpExpr) || op->opno != eq_opr ||
+			list_length(op->args) != 2)
+			continue;
+		if (OidIsValid(op->inputcollid) &&
+			!get_collation_isdeterministic(op->inputcollid))
+			continue;
+		for (int k=0; k < 2; k++)
+		{
+			Node   *key = list_nth(op->args, k);
+			Node   *val = list_nth(op->args, 1-k);
+			Var	   *var;
+
+			while (IsA(key, RelabelType))
+				key = (Node *)((RelabelType *)key)->arg;
+			if (!IsA(key, Var))
+				continue;
+			var = (Var *)key;
+			if (var->varno != baserel->relid ||
+				var->varattno != anum ||
+				var->varlevelsup != 0)
+				continue;
+			if (IsA(val, Const) ||
+				(IsA(val, Param) &&
+				 ((Param *)val)->paramkind == PARAM_EXTERN))
+			{
+				if (p_rinfo)
+					*p_rinfo = rinfo;
+				return (Expr *)copyObject(val);
+			}
+		}
+	}
+	return NULL;
+}
+
+/*
+ * pgstromGpuCacheLookupKeyHash
+ *
+ * It computes the hash value of the lookup key, as like the device code
+ * doing on the raw bytes of the values.
+ */
+bool
+pgstromGpuCacheLookupKeyHash(pgstromTaskState *pts,
+							 Datum key, bool isnull,
+							 int *p_attnum, uint32_t *p_hash)
+{
+	GpuCacheDesc *gc_desc = pts->gcache_desc;
+	Relation	rel = pts->css.ss.ss_currentRelation;
+	Form_pg_attribute attr;
+	AttrNumber	anum;
+
+	if (!gc_desc || !rel || isnull ||
+		NameStr(gc_desc->gc_options.hash_index)[0] == '\0')
+		return false;
+	anum = get_attnum(RelationGetRelid(rel),
+					  NameStr(gc_desc->gc_options.hash_index));
+	if (anum <= 0 || anum > RelationGetNumberOfAttributes(rel))
+		return false;
+	attr = TupleDescAttr(RelationGetDescr(rel), anum-1);
+	if (attr->attlen > 0)
+	{
+		char   *buf = alloca(attr->attlen);
+
+		if (attr->attbyval)
+			store_att_byval(buf, key, attr->attlen);
+		else
+			memcpy(buf, DatumGetPointer(key), attr->attlen);
+		*p_hash = hash_any((unsigned char *)buf, attr->attlen);
+	}
+	else if (attr->attlen == -1)
+	{
+		struct varlena *vl = pg_detoast_datum_packed((struct varlena *)
+													 DatumGetPointer(key));
+		*p_hash = hash_any((unsigned char *)VARDATA_ANY(vl),
+						   VARSIZE_ANY_EXHDR(vl));
+	}
+	else
+		return false;
+	*p_attnum = anum;
+	return true;
+}
+
 /*
  * RelationHasGpuCache
  */
@@ -2212,6 +3505,10 @@ gpuCacheInvokeDropUnload(const GpuCacheDesc *gc_desc, bool is_async)
 
 /*
  * __gpuCacheAppendLog
+ *
+ * The REDO log buffer is shared by all the writer sessions, so the critical
+ * section is only the reservation of the space and the publication; the log
+ * is copied to the reserved space without the lock.
  */
 static bool
 __gpuCacheAppendLog(GpuCacheDesc *gc_desc, GCacheTxLogCommon *tx_log)
@@ -2219,14 +3516,18 @@ __gpuCacheAppendLog(GpuCacheDesc *gc_desc, GCacheTxLogCommon *tx_log)
 	GpuCacheSharedState *gc_sstate = gc_desc->gc_lmap->gc_sstate;
 	char	   *redo_buffer = gpuCacheRedoLogBuffer(gc_sstate);
 	size_t		buffer_sz = gc_sstate->gc_options.redo_buffer_size;
+	const char *pos = (const char *)tx_log;
+	size_t		remain = tx_log->length;
+	uint64_t	start_pos;
+	uint64_t	sync_pos = 0;
+	bool		sync_required = false;
 	bool		append_done = false;
 
 	Assert(tx_log->length == MAXALIGN(tx_log->length));
-	while (!append_done)
+	for (;;)
 	{
 		size_t		usage;
 		uint32_t	phase;
-		uint64_t	sync_pos;
 
 		/*
 		 * Once GPU buffer is marked to 'corrupted', any following REDO-logs
@@ -2239,57 +3540,130 @@ __gpuCacheAppendLog(GpuCacheDesc *gc_desc, GCacheTxLogCommon *tx_log)
 			   phase == GCACHE_PHASE__IS_READY);
 
 		pthreadMutexLock(&gc_sstate->redo_mutex);
-		Assert(gc_sstate->redo_write_pos >= gc_sstate->redo_read_pos &&
-			   gc_sstate->redo_write_pos <= gc_sstate->redo_read_pos + buffer_sz &&
+		Assert(gc_sstate->redo_reserve_pos >= gc_sstate->redo_write_pos &&
+			   gc_sstate->redo_write_pos >= gc_sstate->redo_read_pos &&
+			   gc_sstate->redo_reserve_pos <= gc_sstate->redo_read_pos + buffer_sz &&
 			   gc_sstate->redo_sync_pos <= gc_sstate->redo_write_pos);
-		usage = gc_sstate->redo_write_pos - gc_sstate->redo_read_pos;
-
+		usage = gc_sstate->redo_reserve_pos - gc_sstate->redo_read_pos;
 		/* buffer has enough space? */
 		if (usage + tx_log->length <= buffer_sz)
 		{
-			const char *pos = (const char *)tx_log;
-			size_t		remain = tx_log->length;
-			size_t		offset;
-			size_t		nbytes;
-
-			while (remain > 0)
-			{
-				offset = gc_sstate->redo_write_pos % buffer_sz;
-				if (offset + remain > buffer_sz)
-					nbytes = buffer_sz - offset;
-				else
-					nbytes = remain;
-				memcpy(redo_buffer + offset, pos, nbytes);
-				gc_sstate->redo_write_pos += nbytes;
-				pos += nbytes;
-				remain -= nbytes;
-			}
-			gc_sstate->redo_write_nitems++;
-			gc_sstate->redo_write_timestamp = GetCurrentTimestamp();
-			append_done = true;
+			start_pos = gc_sstate->redo_reserve_pos;
+			gc_sstate->redo_reserve_pos += tx_log->length;
+			/* on-disk snapshot shall be outdated by this log */
+			__gpuCacheInvalidateSnapshotNoLock(gc_sstate);
+			pthreadMutexUnlock(&gc_sstate->redo_mutex);
+			break;
 		}
 		/*
-		 * check whether the REDO log buffer usage exceeds the threshold of
-		 * the synchronization.
+		 * Elsewhere, kick the GPU service to apply the published REDO logs,
+		 * then wait for the buffer space.
 		 */
-		if (gc_sstate->redo_write_pos >= (gc_sstate->redo_sync_pos +
-										  gc_sstate->gc_options.gpu_sync_threshold))
+		if (gc_sstate->redo_sync_pos < gc_sstate->redo_write_pos)
 		{
 			sync_pos = gc_sstate->redo_sync_pos = gc_sstate->redo_write_pos;
 			pthreadMutexUnlock(&gc_sstate->redo_mutex);
-			gpuCacheInvokeApplyRedo(gc_desc, sync_pos, append_done);
+			gpuCacheInvokeApplyRedo(gc_desc, sync_pos, false);
 		}
 		else
 		{
 			pthreadMutexUnlock(&gc_sstate->redo_mutex);
 		}
+		pg_usleep(2000L);	/* 2ms */
+	}
+
+	/* copy the REDO log to the reserved space */
+	for (uint64_t curr_pos = start_pos; remain > 0; )
+	{
+		size_t		offset = curr_pos % buffer_sz;
+		size_t		nbytes = Min(remain, buffer_sz - offset);
+
+		memcpy(redo_buffer + offset, pos, nbytes);
+		curr_pos += nbytes;
+		pos += nbytes;
+		remain -= nbytes;
+	}
 
-		if (!append_done)
-			pg_usleep(2000L);	/* 2ms */
+	/*
+	 * Publish the REDO log in the order of reservation, because the GPU
+	 * service applies the logs prior to redo_write_pos. The writer must
+	 * not be interrupted here, or the following writers would wait for the
+	 * publication forever. If the buffer is reset in the meantime, this log
+	 * is just discarded.
+	 */
+	pthreadMutexLock(&gc_sstate->redo_mutex);
+	while (gc_sstate->redo_write_pos < start_pos &&
+		   gc_sstate->redo_reserve_pos >= start_pos + tx_log->length)
+	{
+		pthreadCondWaitTimeout(&gc_sstate->redo_cond,
+							   &gc_sstate->redo_mutex, 100L);
+	}
+	if (gc_sstate->redo_write_pos == start_pos)
+	{
+		gc_sstate->redo_write_pos += tx_log->length;
+		gc_sstate->redo_write_nitems++;
+		gc_sstate->redo_write_timestamp = GetCurrentTimestamp();
+		append_done = true;
+		pthreadCondBroadcast(&gc_sstate->redo_cond);
+		/*
+		 * check whether the REDO log buffer usage exceeds the threshold of
+		 * the synchronization.
+		 */
+		if (gc_sstate->redo_write_pos >= (gc_sstate->redo_sync_pos +
+										  gc_sstate->gc_options.gpu_sync_threshold))
+		{
+			sync_pos = gc_sstate->redo_sync_pos = gc_sstate->redo_write_pos;
+			sync_required = true;
+		}
 	}
+	pthreadMutexUnlock(&gc_sstate->redo_mutex);
+	if (sync_required)
+		gpuCacheInvokeApplyRedo(gc_desc, sync_pos, true);
+
 	return append_done;
 }
 
+/*
+ * __gpuCacheWriteInsertLog
+ */
+static void
+__gpuCacheWriteInsertLog(GpuCacheDesc *gc_desc, HeapTuple tuple,
+						 uint32_t rowid, TransactionId xid)
+{
+	GCacheTxLogInsert  *item;
+	size_t		sz;
+
+	sz = MAXALIGN(offsetof(GCacheTxLogInsert, htup) + tuple->t_len);
+	item = alloca(sz);
+	item->type = GCACHE_TX_LOG__INSERT;
+	item->length = sz;
+	item->rowid = rowid;
+	memcpy(&item->htup, tuple->t_data, tuple->t_len);
+	HeapTupleHeaderSetXmin(&item->htup, xid);
+	HeapTupleHeaderSetXmax(&item->htup, InvalidTransactionId);
+	HeapTupleHeaderSetCmin(&item->htup, InvalidCommandId);
+
+	__gpuCacheAppendLog(gc_desc, (GCacheTxLogCommon *)item);
+}
+
+/*
+ * __gpuCacheWriteDeleteLog
+ */
+static void
+__gpuCacheWriteDeleteLog(GpuCacheDesc *gc_desc, ItemPointer ctid,
+						 uint32_t rowid, TransactionId xid)
+{
+	GCacheTxLogDelete item;
+
+	item.type = GCACHE_TX_LOG__DELETE;
+	item.length = MAXALIGN(sizeof(GCacheTxLogDelete));
+	item.xid = xid;
+	item.rowid = rowid;
+	memcpy(&item.ctid, ctid, sizeof(ItemPointerData));
+
+	__gpuCacheAppendLog(gc_desc, (GCacheTxLogCommon *)&item);
+}
+
 /*
  * __gpuCacheInsertLog
  */
@@ -2297,7 +3671,6 @@ static void
 __gpuCacheInsertLog(HeapTuple tuple, GpuCacheDesc *gc_desc)
 {
 	uint32_t	rowid;
-	size_t		sz;
 
 	if (!gc_desc->gc_lmap)
 		elog(ERROR, "Bug? unable to add GpuCacheLog");
@@ -2306,7 +3679,6 @@ __gpuCacheInsertLog(HeapTuple tuple, GpuCacheDesc *gc_desc)
 		return;
 	PG_TRY();
 	{
-		GCacheTxLogInsert  *item;
 		PendingCtidItem		pitem;
 
 		/* track rowid not committed yet */
@@ -2318,17 +3690,8 @@ __gpuCacheInsertLog(HeapTuple tuple, GpuCacheDesc *gc_desc)
 		gc_desc->nitems++;
 
 		/* INSERT Log */
-		sz = MAXALIGN(offsetof(GCacheTxLogInsert, htup) + tuple->t_len);
-		item = alloca(sz);
-		item->type = GCACHE_TX_LOG__INSERT;
-		item->length = sz;
-		item->rowid = rowid;
-		memcpy(&item->htup, tuple->t_data, tuple->t_len);
-		HeapTupleHeaderSetXmin(&item->htup, GetCurrentTransactionId());
-		HeapTupleHeaderSetXmax(&item->htup, InvalidTransactionId);
-		HeapTupleHeaderSetCmin(&item->htup, InvalidCommandId);
-
-		__gpuCacheAppendLog(gc_desc, (GCacheTxLogCommon *)item);
+		__gpuCacheWriteInsertLog(gc_desc, tuple, rowid,
+								 GetCurrentTransactionId());
 	}
 	PG_CATCH();
 	{
@@ -2344,7 +3707,6 @@ __gpuCacheInsertLog(HeapTuple tuple, GpuCacheDesc *gc_desc)
 static void
 __gpuCacheDeleteLog(HeapTuple tuple, GpuCacheDesc *gc_desc)
 {
-	GCacheTxLogDelete item;
 	PendingCtidItem	pitem;
 	uint32_t	rowid;
 
@@ -2363,13 +3725,8 @@ __gpuCacheDeleteLog(HeapTuple tuple, GpuCacheDesc *gc_desc)
 	gc_desc->nitems++;
 
 	/* DELETE Log */
-	item.type = GCACHE_TX_LOG__DELETE;
-	item.length = MAXALIGN(sizeof(GCacheTxLogDelete));
-	item.xid = GetCurrentTransactionId();
-	item.rowid = rowid;
-	memcpy(&item.ctid, &tuple->t_self, sizeof(ItemPointerData));
-
-	__gpuCacheAppendLog(gc_desc, (GCacheTxLogCommon *)&item);
+	__gpuCacheWriteDeleteLog(gc_desc, &tuple->t_self, rowid,
+							 GetCurrentTransactionId());
 }
 
 /*
@@ -2416,10 +3773,15 @@ pgstrom_gpucache_sync_trigger(PG_FUNCTION_ARGS)
 	if (TRIGGER_FIRED_FOR_ROW(trigdata->tg_event))
 	{
 		GpuCacheDesc   *gc_desc;
+		GpuCacheOptions	gc_options;
 
 		if (!TRIGGER_FIRED_AFTER(trigdata->tg_event))
 			elog(ERROR, "%s: must be declared as AFTER ROW trigger",
 				 trigdata->tg_trigger->tgname);
+		/* sync_mode=wal; GpuCache WAL sync worker shall handle the change */
+		if (gpuCacheTableSignature(trigdata->tg_relation, &gc_options) != 0 &&
+			gc_options.sync_mode == GCACHE_SYNC_MODE__WAL)
+			goto bailout;
 
 		gc_desc = lookupGpuCacheDesc(trigdata->tg_relation);
 		if (!gc_desc)
@@ -2495,6 +3857,129 @@ pgstrom_gpucache_apply_redo(PG_FUNCTION_ARGS)
 	PG_RETURN_VOID();
 }
 
+/*
+ * pgstrom_gpucache_aggregate
+ */
+typedef struct
+{
+	kern_gpucache_aggslot *slots;
+	uint32_t	nslots;
+	uint32_t	index;
+	bool		has_value;
+	bool		value_float;
+} GpuCacheAggregateState;
+
+PG_FUNCTION_INFO_V1(pgstrom_gpucache_aggregate);
+PUBLIC_FUNCTION(Datum)
+pgstrom_gpucache_aggregate(PG_FUNCTION_ARGS)
+{
+	FuncCallContext *fncxt;
+	GpuCacheAggregateState *state;
+	Datum		values[4];
+	bool		isnull[4];
+	HeapTuple	tuple;
+
+	if (SRF_IS_FIRSTCALL())
+	{
+		Oid			table_oid = PG_GETARG_OID(0);
+		Relation	rel;
+		GpuCacheDesc *gc_desc;
+		GpuCacheSharedState *gc_sstate;
+		const kern_colmeta *cmeta = NULL;
+		TupleDesc	tupdesc;
+		MemoryContext oldcxt;
+
+		fncxt = SRF_FIRSTCALL_INIT();
+		oldcxt = MemoryContextSwitchTo(fncxt->multi_call_memory_ctx);
+		if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+			elog(ERROR, "return type must be a row type");
+		fncxt->tuple_desc = BlessTupleDesc(tupdesc);
+
+		rel = table_open(table_oid, RowExclusiveLock);
+		gc_desc = lookupGpuCacheDesc(rel);
+		if (!gc_desc || !initialLoadGpuCache(gc_desc, rel))
+			ereport(ERROR,
+					(errcode(ERRCODE_OBJECT_NOT_IN_PREREQUISITE_STATE),
+					 errmsg("relation \"%s\" has no available GpuCache",
+							RelationGetRelationName(rel))));
+		gc_sstate = gc_desc->gc_lmap->gc_sstate;
+		for (int j=0; j < gc_sstate->kds_head.ncols; j++)
+		{
+			if (gc_sstate->kds_head.colmeta[j].agg_nslots > 0)
+			{
+				cmeta = &gc_sstate->kds_head.colmeta[j];
+				break;
+			}
+		}
+		if (!cmeta)
+			ereport(ERROR,
+					(errcode(ERRCODE_OBJECT_NOT_IN_PREREQUISITE_STATE),
+					 errmsg("GpuCache of \"%s\" has no maintained aggregation",
+							RelationGetRelationName(rel)),
+					 errhint("add 'aggregate=<key>[:<value>]' to the options of the gpucache_sync_trigger")));
+		/* apply the pending REDO logs, then fetch the aggregation */
+		pthreadMutexLock(&gc_sstate->redo_mutex);
+		gc_sstate->redo_sync_pos = gc_sstate->redo_write_pos;
+		pthreadMutexUnlock(&gc_sstate->redo_mutex);
+		__gpuCacheInvokeBackgroundCommand(&gc_desc->ident,
+										  gc_desc->gc_options.cuda_dindex,
+										  false,
+										  GCACHE_CONTROL_CMD__FETCH_AGGREGATE,
+										  0);
+		state = palloc0(sizeof(GpuCacheAggregateState));
+		state->nslots = cmeta->agg_nslots;
+		state->slots = palloc(sizeof(kern_gpucache_aggslot) * state->nslots);
+		state->has_value = (cmeta->agg_value_anum > 0);
+		state->value_float = cmeta->agg_value_float;
+		pthreadMutexLock(&gc_sstate->redo_mutex);
+		memcpy(state->slots,
+			   (char *)gc_sstate + gc_sstate->agg_buffer_offset,
+			   sizeof(kern_gpucache_aggslot) * state->nslots);
+		if (gc_sstate->agg_invalid)
+		{
+			pthreadMutexUnlock(&gc_sstate->redo_mutex);
+			ereport(ERROR,
+					(errcode(ERRCODE_PROGRAM_LIMIT_EXCEEDED),
+					 errmsg("maintained aggregation of \"%s\" has too many groups (max: %u)",
+							RelationGetRelationName(rel), GCACHE_AGG_NSLOTS),
+					 errhint("try pgstrom.gpucache_recovery() after the option change")));
+		}
+		pthreadMutexUnlock(&gc_sstate->redo_mutex);
+		table_close(rel, RowExclusiveLock);
+
+		fncxt->user_fctx = state;
+		MemoryContextSwitchTo(oldcxt);
+	}
+	fncxt = SRF_PERCALL_SETUP();
+	state = (GpuCacheAggregateState *)fncxt->user_fctx;
+	while (state->index < state->nslots)
+	{
+		kern_gpucache_aggslot *slot = &state->slots[state->index++];
+
+		if ((slot->state != GCACHE_AGGSLOT__VALID &&
+			 slot->state != GCACHE_AGGSLOT__VALID_NULL) || slot->nrows <= 0)
+			continue;
+		memset(isnull, 0, sizeof(isnull));
+		if (slot->state == GCACHE_AGGSLOT__VALID)
+			values[0] = Int64GetDatum(slot->key);
+		else
+			isnull[0] = true;
+		values[1] = Int64GetDatum(slot->nrows);
+		values[2] = Int64GetDatum(slot->nvalues);
+		if (!state->has_value || slot->nvalues <= 0)
+			isnull[3] = true;
+		else if (state->value_float)
+			values[3] = DirectFunctionCall1(float8_numeric,
+											Float8GetDatum(slot->sum.fval));
+		else
+			values[3] = DirectFunctionCall1(int8_numeric,
+											Int64GetDatum(slot->sum.ival));
+		tuple = heap_form_tuple(fncxt->tuple_desc, values, isnull);
+		SRF_RETURN_NEXT(fncxt, HeapTupleGetDatum(tuple));
+	}
+	SRF_RETURN_DONE(fncxt);
+}
+
 /*
  * pgstrom_gpucache_compaction
  */
@@ -2601,6 +4086,27 @@ pgstromGpuCacheExecInit(pgstromTaskState *pts)
 			 RelationGetRelationName(rel));
 		return NULL;
 	}
+	/* sync_mode=wal; only available once WAL sync worker built it */
+	if (gc_options.sync_mode == GCACHE_SYNC_MODE__WAL)
+	{
+		GpuCacheLocalMapping *gc_lmap;
+		uint32_t	phase = GCACHE_PHASE__IS_EMPTY;
+
+		gc_lmap = getGpuCacheLocalMappingIfExist(MyDatabaseId,
+												 RelationGetRelid(rel),
+												 signature);
+		if (gc_lmap)
+		{
+			phase = pg_atomic_read_u32(&gc_lmap->gc_sstate->phase);
+			putGpuCacheLocalMapping(gc_lmap);
+		}
+		if (phase != GCACHE_PHASE__IS_READY)
+		{
+			elog(DEBUG2, "gpucache: table '%s' is not synchronized by WAL sync worker yet",
+				 RelationGetRelationName(rel));
+			return NULL;
+		}
+	}
 	return lookupGpuCacheDesc(rel);
 }
 
@@ -2621,12 +4127,22 @@ pgstromScanChunkGpuCache(pgstromTaskState *pts,
 	{
 		GpuCacheSharedState *gc_sstate = gc_desc->gc_lmap->gc_sstate;
 		uint64_t	write_pos;
-		uint64_t	sync_pos = ULONG_MAX;
 
+		/*
+		 * Pending REDO logs are applied by GpuService prior to the scan
+		 * (merge-on-read), so we don't need to kick the GpuCache manager
+		 * here. All we need to do is to mark the position of the logs
+		 * this scan needs to see.
+		 * If REDO logs could not be applied correctly, GpuCache shall be
+		 * moved to 'corrupted' state during execution. This execution will
+		 * fail because no data-store is kept in the GPU devices.
+		 * However, next execution (by retry) will use heap storage like
+		 * as a fallback.
+		 */
 		pthreadMutexLock(&gc_sstate->redo_mutex);
 		write_pos = gc_sstate->redo_write_pos;
 		if (gc_sstate->redo_sync_pos < gc_sstate->redo_write_pos)
-			sync_pos = gc_sstate->redo_sync_pos = gc_sstate->redo_write_pos;
+			gc_sstate->redo_sync_pos = gc_sstate->redo_write_pos;
 		pthreadMutexUnlock(&gc_sstate->redo_mutex);
 
 		/* is the target table empty? */
@@ -2635,18 +4151,6 @@ pgstromScanChunkGpuCache(pgstromTaskState *pts,
 			pts->scan_done = true;
 			return NULL;
 		}
-		/* force to apply pending REDO logs, if any */
-		if (sync_pos != ULONG_MAX)
-		{
-			/*
-			 * If REDO logs could not be applied correctly, GpuCache shall be
-			 * moved to 'corrupted' state during execution. This execution will
-			 * fail because no data-store is kept in the GPU devices.
-			 * However, next execution (by retry) will use heap storage like
-			 * as a fallback.
-			 */
-			gpuCacheInvokeApplyRedo(gc_desc, sync_pos, true);
-		}
 		xcmd = (XpuCommand *)pts->xcmd_buf.data;
 		Assert(xcmd->length == pts->xcmd_buf.len);
 		xcmd_iov->iov_base = pts->xcmd_buf.data;
@@ -3108,6 +4612,37 @@ gpuCacheSubXactCallback(SubXactEvent event,
  * ------------------------------------------------------------
  */
 
+/*
+ * __gpucacheInitExtraBuffer
+ *
+ * It initializes the header of the extra buffer, and clears the hash slots
+ * of the dictionary encoded columns in front of the varlena values.
+ */
+static void
+__gpucacheInitExtraBuffer(const kern_data_store *kds_head,
+						  kern_data_extra *kds_extra,
+						  size_t length)
+{
+	size_t		usage = MAXALIGN(offsetof(kern_data_extra, data));
+
+	for (int j=0; j < kds_head->ncols; j++)
+	{
+		const kern_colmeta *cmeta = &kds_head->colmeta[j];
+
+		if (cmeta->col_encoding == KDS_COLUMN_ENCODING__DICT)
+		{
+			size_t	tail = (__kds_unpack(cmeta->dict_offset) +
+							MAXALIGN(sizeof(uint32_t) * cmeta->dict_nslots));
+			usage = Max(usage, tail);
+		}
+	}
+	Assert(usage <= length);
+	kds_extra->length = length;
+	kds_extra->usage = usage;
+	kds_extra->deadspace = 0;
+	memset(kds_extra->data, 0, usage - offsetof(kern_data_extra, data));
+}
+
 /*
  * __gpucacheAllocDeviceMemory
  *
@@ -3137,6 +4672,30 @@ __gpucacheAllocDeviceMemory(GpuCacheLocalMapping *gc_lmap,
 	memcpy((void *)gcache_main_devptr,
 		   &gc_sstate->kds_head,
 		   KDS_HEAD_LENGTH(&gc_sstate->kds_head));
+	/* clear the hash-index, if any */
+	for (int j=0; j < gc_sstate->kds_head.ncols; j++)
+	{
+		const kern_colmeta *cmeta = &gc_sstate->kds_head.colmeta[j];
+
+		if (cmeta->hindex_nslots == 0)
+			continue;
+		memset((char *)gcache_main_devptr + __kds_unpack(cmeta->hindex_offset), 0,
+			   sizeof(uint64_t) * cmeta->hindex_nslots);
+		memset((char *)gcache_main_devptr + __kds_unpack(cmeta->hindex_rowpos), 0,
+			   sizeof(uint32_t) * gc_sstate->kds_head.column_nrooms);
+	}
+	/* clear the maintained aggregation, if any */
+	for (int j=0; j < gc_sstate->kds_head.ncols; j++)
+	{
+		const kern_colmeta *cmeta = &gc_sstate->kds_head.colmeta[j];
+
+		if (cmeta->agg_nslots == 0)
+			continue;
+		memset((char *)gcache_main_devptr + __kds_unpack(cmeta->agg_offset), 0,
+			   sizeof(kern_gpucache_aggslot) * cmeta->agg_nslots);
+		memset((char *)gcache_main_devptr + __kds_unpack(cmeta->agg_counted), 0,
+			   BITMAPLEN(gc_sstate->kds_head.column_nrooms));
+	}
 
 	if (gcache_extra_size > 0)
 	{
@@ -3153,13 +4712,16 @@ __gpucacheAllocDeviceMemory(GpuCacheLocalMapping *gc_lmap,
 			return ENOMEM;
 		}
 		kds_extra = (kern_data_extra *)gcache_extra_devptr;
-		kds_extra->length = gcache_extra_size;
-		kds_extra->usage = offsetof(kern_data_extra, data);
+		__gpucacheInitExtraBuffer(&gc_sstate->kds_head,
+								  kds_extra, gcache_extra_size);
 	}
 	gc_lmap->gcache_main_devptr = gcache_main_devptr;
 	gc_lmap->gcache_extra_devptr = gcache_extra_devptr;
+	gc_lmap->gcache_version++;
 	gc_lmap->gcache_main_size = gcache_main_size;
 	gc_lmap->gcache_extra_size = gcache_extra_size;
+	gc_lmap->gcache_last_access = GetCurrentTimestamp();
+	pg_atomic_write_u32(&gc_sstate->gcache_evicted, 0);
 	pg_atomic_write_u64(&gc_sstate->gcache_main_size, gcache_main_size);
 	pg_atomic_write_u64(&gc_sstate->gcache_extra_size, gcache_extra_size);
 #if 1
@@ -3173,6 +4735,248 @@ __gpucacheAllocDeviceMemory(GpuCacheLocalMapping *gc_lmap,
 	return 0;
 }
 
+/*
+ * Read-only replicas of GpuCache
+ *
+ * gpu_replicas option makes copies of the GpuCache on the other devices,
+ * to distribute the scan workloads. A replica is built by the copy of the
+ * primary buffers on the first scan on the device, then REDO logs are
+ * applied to the replicas also, next to the primary one.
+ * If something wrong on the replica, we just release it; the next scan
+ * will rebuild the replica from the primary again.
+ * Lock order is always primary -> replica.
+ */
+static void
+__gpucacheReleaseReplicaBuffer(GpuCacheLocalMapping *replica)
+{
+	CUresult	rc;
+
+	if (replica->gcache_main_devptr != 0UL)
+	{
+		rc = cuMemFree(replica->gcache_main_devptr);
+		if (rc != CUDA_SUCCESS)
+			fprintf(stderr, "failed on cuMemFree: %s\n", cuStrError(rc));
+		replica->gcache_main_devptr = 0UL;
+		replica->gcache_main_size = 0;
+	}
+	if (replica->gcache_extra_devptr != 0UL)
+	{
+		rc = cuMemFree(replica->gcache_extra_devptr);
+		if (rc != CUDA_SUCCESS)
+			fprintf(stderr, "failed on cuMemFree: %s\n", cuStrError(rc));
+		replica->gcache_extra_devptr = 0UL;
+		replica->gcache_extra_size = 0;
+	}
+	replica->gcache_version++;
+}
+
+/*
+ * __gpucacheReleaseReplicas
+ *
+ * NOTE: caller must hold the exclusive lock of the primary
+ */
+static void
+__gpucacheReleaseReplicas(GpuCacheLocalMapping *gc_lmap)
+{
+	if (!gc_lmap->replicas)
+		return;
+	for (int k=0; k < numGpuDevAttrs; k++)
+	{
+		GpuCacheLocalMapping *replica = gc_lmap->replicas[k];
+
+		if (replica)
+		{
+			pthreadRWLockWriteLock(&replica->gcache_rwlock);
+			__gpucacheReleaseReplicaBuffer(replica);
+			pthreadRWLockUnlock(&replica->gcache_rwlock);
+		}
+	}
+}
+
+/*
+ * __gpucacheSetupReplica
+ *
+ * NOTE: caller must hold the exclusive lock of the primary
+ */
+static GpuCacheLocalMapping *
+__gpucacheSetupReplica(GpuCacheLocalMapping *gc_lmap, int cuda_dindex,
+					   char *errbuf, size_t errbuf_sz)
+{
+	GpuCacheLocalMapping *replica;
+	GpuCacheDeviceFuncs *dfuncs;
+	CUdevice	cuda_device;
+	CUresult	rc;
+
+	if (!gcache_device_funcs ||
+		!(dfuncs = &gcache_device_funcs[cuda_dindex])->cuda_context)
+	{
+		snprintf(errbuf, errbuf_sz, "GPU%d is not ready", cuda_dindex);
+		return NULL;
+	}
+	if (!gc_lmap->replicas)
+	{
+		gc_lmap->replicas = calloc(numGpuDevAttrs, sizeof(GpuCacheLocalMapping *));
+		if (!gc_lmap->replicas)
+		{
+			snprintf(errbuf, errbuf_sz, "out of memory");
+			return NULL;
+		}
+	}
+	replica = gc_lmap->replicas[cuda_dindex];
+	if (!replica)
+	{
+		replica = calloc(1, sizeof(GpuCacheLocalMapping));
+		if (!replica)
+		{
+			snprintf(errbuf, errbuf_sz, "out of memory");
+			return NULL;
+		}
+		memcpy(&replica->ident, &gc_lmap->ident, sizeof(GpuCacheIdent));
+		replica->gc_sstate = gc_lmap->gc_sstate;
+		replica->primary = gc_lmap;
+		replica->replica_dindex = cuda_dindex;
+		pthreadRWLockInit(&replica->gcache_rwlock);
+		gc_lmap->replicas[cuda_dindex] = replica;
+	}
+
+	pthreadRWLockWriteLock(&replica->gcache_rwlock);
+	if (replica->gcache_main_devptr != 0UL)
+		goto out;	/* already built */
+	rc = cuCtxPushCurrent(dfuncs->cuda_context);
+	if (rc != CUDA_SUCCESS)
+	{
+		snprintf(errbuf, errbuf_sz, "failed on cuCtxPushCurrent: %s",
+				 cuStrError(rc));
+		goto error_0;
+	}
+	rc = cuMemAllocManaged(&replica->gcache_main_devptr,
+						   gc_lmap->gcache_main_size,
+						   CU_MEM_ATTACH_GLOBAL);
+	if (rc != CUDA_SUCCESS)
+		goto error_1;
+	replica->gcache_main_size = gc_lmap->gcache_main_size;
+	rc = cuMemcpy(replica->gcache_main_devptr,
+				  gc_lmap->gcache_main_devptr,
+				  gc_lmap->gcache_main_size);
+	if (rc != CUDA_SUCCESS)
+		goto error_1;
+	if (gc_lmap->gcache_extra_devptr != 0UL)
+	{
+		rc = cuMemAllocManaged(&replica->gcache_extra_devptr,
+							   gc_lmap->gcache_extra_size,
+							   CU_MEM_ATTACH_GLOBAL);
+		if (rc != CUDA_SUCCESS)
+			goto error_1;
+		replica->gcache_extra_size = gc_lmap->gcache_extra_size;
+		rc = cuMemcpy(replica->gcache_extra_devptr,
+					  gc_lmap->gcache_extra_devptr,
+					  gc_lmap->gcache_extra_size);
+		if (rc != CUDA_SUCCESS)
+			goto error_1;
+	}
+	if (cuCtxGetDevice(&cuda_device) == CUDA_SUCCESS)
+	{
+		__gpucacheAdviseLocation(replica->gcache_main_devptr,
+								 replica->gcache_main_size,
+								 cuda_device, true);
+		__gpucacheAdviseLocation(replica->gcache_extra_devptr,
+								 replica->gcache_extra_size,
+								 cuda_device, true);
+	}
+	rc = cuStreamSynchronize(CU_STREAM_PER_THREAD);
+	if (rc != CUDA_SUCCESS)
+		goto error_1;
+	cuCtxPopCurrent(NULL);
+	replica->gcache_version++;
+	fprintf(stderr, "gpucache: table '%s' was replicated to GPU%d\n",
+			gc_lmap->gc_sstate->table_name, cuda_dindex);
+out:
+	pthreadRWLockUnlock(&replica->gcache_rwlock);
+	return replica;
+
+error_1:
+	snprintf(errbuf, errbuf_sz, "unable to build replica on GPU%d: %s",
+			 cuda_dindex, cuStrError(rc));
+	__gpucacheReleaseReplicaBuffer(replica);
+	cuCtxPopCurrent(NULL);
+error_0:
+	pthreadRWLockUnlock(&replica->gcache_rwlock);
+	return NULL;
+}
+
+/*
+ * __gpucacheApplyRedoReplicas
+ *
+ * It applies the REDO logs (already applied to the primary) to the replicas.
+ * NOTE: caller must hold the exclusive lock of the primary
+ */
+static void
+__gpucacheApplyRedoReplicas(GpuCacheLocalMapping *gc_lmap,
+							CUdeviceptr m_gcache_redo)
+{
+	kern_gpucache_redolog *gcache_redo = (kern_gpucache_redolog *)m_gcache_redo;
+
+	if (!gc_lmap->replicas || !gcache_device_funcs)
+		return;
+	for (int k=0; k < numGpuDevAttrs; k++)
+	{
+		GpuCacheLocalMapping *replica = gc_lmap->replicas[k];
+		GpuCacheDeviceFuncs *dfuncs = &gcache_device_funcs[k];
+		int			grid_sz, block_sz;
+		unsigned int shmem_sz;
+		void	   *kern_args[4];
+		CUresult	rc;
+
+		if (!replica)
+			continue;
+		pthreadRWLockWriteLock(&replica->gcache_rwlock);
+		if (replica->gcache_main_devptr == 0UL)
+			goto skip;
+		if (!dfuncs->cuda_context ||
+			cuCtxPushCurrent(dfuncs->cuda_context) != CUDA_SUCCESS)
+		{
+			__gpucacheReleaseReplicaBuffer(replica);
+			goto skip;
+		}
+		memset(&gcache_redo->kerror, 0, sizeof(kern_errorbuf));
+		rc = gpuOptimalBlockSize(&grid_sz,
+								 &block_sz,
+								 &shmem_sz,
+								 dfuncs->f_gcache_apply_redo,
+								 0, 0);
+		for (uint32_t phase = 1; rc == CUDA_SUCCESS && phase <= 6; phase++)
+		{
+			kern_args[0] = &m_gcache_redo;
+			kern_args[1] = &replica->gcache_main_devptr;
+			kern_args[2] = &replica->gcache_extra_devptr;
+			kern_args[3] = &phase;
+
+			rc = cuLaunchKernel(dfuncs->f_gcache_apply_redo,
+								grid_sz, 1, 1,
+								block_sz, 1, 1,
+								shmem_sz,
+								CU_STREAM_LEGACY,
+								kern_args,
+								NULL);
+		}
+		if (rc == CUDA_SUCCESS)
+			rc = cuStreamSynchronize(CU_STREAM_LEGACY);
+		if (rc != CUDA_SUCCESS ||
+			gcache_redo->kerror.errcode != ERRCODE_STROM_SUCCESS)
+		{
+			/* rebuild the replica on the next scan */
+			fprintf(stderr, "gpucache: replica of '%s' on GPU%d is released (%s)\n",
+					gc_lmap->gc_sstate->table_name, k,
+					rc != CUDA_SUCCESS ? cuStrError(rc) : gcache_redo->kerror.message);
+			__gpucacheReleaseReplicaBuffer(replica);
+		}
+		replica->gcache_version++;
+		cuCtxPopCurrent(NULL);
+	skip:
+		pthreadRWLockUnlock(&replica->gcache_rwlock);
+	}
+}
+
 /*
  * __gpucacheMarkAsCorrupted
  */
@@ -3182,6 +4986,8 @@ __gpucacheMarkAsCorrupted(GpuCacheLocalMapping *gc_lmap)
 	GpuCacheSharedState *gc_sstate = gc_lmap->gc_sstate;
 
 	pg_atomic_write_u32(&gc_sstate->phase, GCACHE_PHASE__IS_CORRUPTED);
+	gc_lmap->gcache_version++;
+	__gpucacheReleaseReplicas(gc_lmap);
 	if (gc_lmap->gcache_main_devptr != 0)
 	{
 		cuMemFree(gc_lmap->gcache_main_devptr);
@@ -3209,21 +5015,55 @@ __gpucacheMarkAsCorrupted(GpuCacheLocalMapping *gc_lmap)
 
 /*
  * GCACHE_CONTROL_CMD__COMPACTION
+ *
+ * The compaction builds a new extra buffer and the new offsets of varlena
+ * values without modification of the main buffer, under the shared lock
+ * of gcache_rwlock; so concurrent scans can run on the OLD extra buffer.
+ * Then, it writes back the new offsets and swaps the extra buffer under
+ * the exclusive lock, if no redo-log was applied in the meantime.
  */
 static int
-__gpucacheExecCompactionKernel(GpuCacheControlCommand *cmd,
-							   GpuCacheLocalMapping *gc_lmap,
-							   CUfunction f_gcache_compaction,
-							   size_t gcache_extra_size)
+__gpucacheBuildCompactedExtra(GpuCacheControlCommand *cmd,
+							  GpuCacheLocalMapping *gc_lmap,
+							  CUfunction f_gcache_compaction,
+							  size_t gcache_extra_size,
+							  CUdeviceptr *p_kds_extra,
+							  size_t *p_kds_extra_sz,
+							  CUdeviceptr *p_new_values)
 {
 	GpuCacheSharedState *gc_sstate = gc_lmap->gc_sstate;
 	kern_data_extra *kds_extra;
 	CUdeviceptr	m_kds_extra = 0UL;
+	CUdeviceptr	m_new_values = 0UL;
+	uint32_t	nitems;
+	int			nvarlena = 0;
 	int			grid_sz, block_sz;
 	unsigned int shmem_sz;
 	void	   *kern_args[4];
 	CUresult	rc;
 
+	for (int j=0; j < gc_sstate->kds_head.ncols; j++)
+	{
+		if (gc_sstate->kds_head.colmeta[j].attlen < 0)
+			nvarlena++;
+	}
+	/* concurrent scans may be running, so don't touch the managed memory */
+	rc = cuMemcpyDtoH(&nitems, gc_lmap->gcache_main_devptr +
+					  offsetof(kern_data_store, nitems), sizeof(uint32_t));
+	if (rc != CUDA_SUCCESS)
+	{
+		snprintf(cmd->errbuf, sizeof(cmd->errbuf),
+				 "failed on cuMemcpyDtoH: %s", cuStrError(rc));
+		return EIO;
+	}
+	rc = cuMemAlloc(&m_new_values, sizeof(uint32_t) *
+					Max((size_t)nitems * nvarlena, 1));
+	if (rc != CUDA_SUCCESS)
+	{
+		snprintf(cmd->errbuf, sizeof(cmd->errbuf),
+				 "failed on cuMemAlloc: %s", cuStrError(rc));
+		return ENOMEM;
+	}
 	if (gcache_extra_size < gc_lmap->gcache_extra_size)
 		gcache_extra_size = gc_lmap->gcache_extra_size;
 retry:
@@ -3234,11 +5074,12 @@ retry:
 	{
 		snprintf(cmd->errbuf, sizeof(cmd->errbuf),
 				 "failed on cuMemAllocManaged: %s", cuStrError(rc));
+		cuMemFree(m_new_values);
 		return ENOMEM;
 	}
 	kds_extra = (kern_data_extra *)m_kds_extra;
-	kds_extra->length = gcache_extra_size;
-	kds_extra->usage = offsetof(kern_data_extra, data);
+	__gpucacheInitExtraBuffer(&gc_sstate->kds_head,
+							  kds_extra, gcache_extra_size);
 
 	rc = gpuOptimalBlockSize(&grid_sz,
 							 &block_sz,
@@ -3254,6 +5095,7 @@ retry:
 	kern_args[0] = &gc_lmap->gcache_main_devptr;
 	kern_args[1] = &gc_lmap->gcache_extra_devptr;	/* OLD extra */
 	kern_args[2] = &m_kds_extra;					/* NEW extra */
+	kern_args[3] = &m_new_values;					/* NEW offsets */
 	rc = cuLaunchKernel(f_gcache_compaction,
 						grid_sz, 1, 1,
 						block_sz, 1, 1,
@@ -3281,6 +5123,56 @@ retry:
 		m_kds_extra = 0UL;
 		goto retry;
 	}
+	*p_kds_extra    = m_kds_extra;
+	*p_kds_extra_sz = gcache_extra_size;
+	*p_new_values   = m_new_values;
+	return 0;
+
+bailout:
+	if (m_kds_extra != 0)
+		cuMemFree(m_kds_extra);
+	cuMemFree(m_new_values);
+	return EIO;
+}
+
+/*
+ * NOTE: must be called under the exclusive lock of gcache_rwlock
+ */
+static int
+__gpucacheSwapCompactedExtra(GpuCacheControlCommand *cmd,
+							 GpuCacheLocalMapping *gc_lmap,
+							 CUdeviceptr m_kds_extra,
+							 size_t gcache_extra_size,
+							 CUdeviceptr m_new_values)
+{
+	GpuCacheSharedState *gc_sstate = gc_lmap->gc_sstate;
+	kern_data_store *kds = (kern_data_store *)gc_lmap->gcache_main_devptr;
+	uint32_t	nitems = kds->nitems;
+	size_t		offset = 0;
+	CUresult	rc;
+
+	/* write back the new offsets of varlena columns */
+	for (int j=0; j < gc_sstate->kds_head.ncols; j++)
+	{
+		const kern_colmeta *cmeta = &gc_sstate->kds_head.colmeta[j];
+
+		if (cmeta->attlen >= 0)
+			continue;
+		rc = cuMemcpyDtoD(gc_lmap->gcache_main_devptr +
+						  __kds_unpack(cmeta->values_offset),
+						  m_new_values + offset,
+						  sizeof(uint32_t) * nitems);
+		if (rc != CUDA_SUCCESS)
+		{
+			snprintf(cmd->errbuf, sizeof(cmd->errbuf),
+					 "failed on cuMemcpyDtoD: %s", cuStrError(rc));
+			cuMemFree(m_kds_extra);
+			cuMemFree(m_new_values);
+			return EIO;
+		}
+		offset += sizeof(uint32_t) * nitems;
+	}
+	cuMemFree(m_new_values);
 #if 1
 	fprintf(stderr, "%s: extra %p (%lu) --> %p (%lu)\n",
 			__FUNCTION__,
@@ -3293,13 +5185,39 @@ retry:
 	cuMemFree(gc_lmap->gcache_extra_devptr);
 	gc_lmap->gcache_extra_devptr = m_kds_extra;
 	gc_lmap->gcache_extra_size   = gcache_extra_size;
+	if (pg_atomic_read_u32(&gc_sstate->gcache_evicted) != 0)
+		__gpucacheAdviseLocation(m_kds_extra, gcache_extra_size,
+								 CU_DEVICE_CPU, false);
+	gc_lmap->gcache_version++;
 	pg_atomic_write_u64(&gc_sstate->gcache_extra_size, gcache_extra_size);
 	return 0;
+}
 
-bailout:
-	if (m_kds_extra != 0)
-		cuMemFree(m_kds_extra);
-	return EIO;
+/*
+ * NOTE: must be called under the exclusive lock of gcache_rwlock
+ */
+static int
+__gpucacheExecCompactionKernel(GpuCacheControlCommand *cmd,
+							   GpuCacheLocalMapping *gc_lmap,
+							   CUfunction f_gcache_compaction,
+							   size_t gcache_extra_size)
+{
+	CUdeviceptr	m_kds_extra;
+	CUdeviceptr	m_new_values;
+	int			status;
+
+	status = __gpucacheBuildCompactedExtra(cmd, gc_lmap,
+										   f_gcache_compaction,
+										   gcache_extra_size,
+										   &m_kds_extra,
+										   &gcache_extra_size,
+										   &m_new_values);
+	if (status == 0)
+		status = __gpucacheSwapCompactedExtra(cmd, gc_lmap,
+											  m_kds_extra,
+											  gcache_extra_size,
+											  m_new_values);
+	return status;
 }
 
 static int
@@ -3307,7 +5225,11 @@ __gpucacheExecCompaction(GpuCacheControlCommand *cmd,
 						 CUfunction f_gcache_compaction)
 {
 	GpuCacheLocalMapping *gc_lmap;
-	int		status = 0;
+	CUdeviceptr	m_kds_extra;
+	CUdeviceptr	m_new_values;
+	size_t		gcache_extra_size;
+	uint64_t	gcache_version;
+	int			status = 0;
 
 	gc_lmap = getGpuCacheLocalMappingIfExist(cmd->ident.database_oid,
 											 cmd->ident.table_oid,
@@ -3321,8 +5243,47 @@ __gpucacheExecCompaction(GpuCacheControlCommand *cmd,
 				 cmd->ident.signature);
 		return EEXIST;
 	}
+
+	for (int loop=0; loop < GCACHE_COMPACTION_MAX_RETRY; loop++)
+	{
+		/* build a new extra buffer, concurrently with scans */
+		pthreadRWLockReadLock(&gc_lmap->gcache_rwlock);
+		if (gc_lmap->gcache_main_devptr == 0UL ||
+			gc_lmap->gcache_extra_devptr == 0UL)
+		{
+			pthreadRWLockUnlock(&gc_lmap->gcache_rwlock);
+			goto out;
+		}
+		gcache_version = gc_lmap->gcache_version;
+		status = __gpucacheBuildCompactedExtra(cmd, gc_lmap,
+											   f_gcache_compaction,
+											   gc_lmap->gcache_extra_size,
+											   &m_kds_extra,
+											   &gcache_extra_size,
+											   &m_new_values);
+		pthreadRWLockUnlock(&gc_lmap->gcache_rwlock);
+		if (status != 0)
+			goto out;
+
+		/* swap the extra buffer, if no redo-log was applied in the meantime */
+		pthreadRWLockWriteLock(&gc_lmap->gcache_rwlock);
+		if (gc_lmap->gcache_version == gcache_version)
+		{
+			status = __gpucacheSwapCompactedExtra(cmd, gc_lmap,
+												  m_kds_extra,
+												  gcache_extra_size,
+												  m_new_values);
+			pthreadRWLockUnlock(&gc_lmap->gcache_rwlock);
+			goto out;
+		}
+		pthreadRWLockUnlock(&gc_lmap->gcache_rwlock);
+		cuMemFree(m_kds_extra);
+		cuMemFree(m_new_values);
+	}
+	/* give up the concurrent compaction, then run it exclusively */
 	pthreadRWLockWriteLock(&gc_lmap->gcache_rwlock);
-	if (gc_lmap->gcache_main_devptr != 0UL)
+	if (gc_lmap->gcache_main_devptr != 0UL &&
+		gc_lmap->gcache_extra_devptr != 0UL)
 	{
 		status = __gpucacheExecCompactionKernel(cmd,
 												gc_lmap,
@@ -3330,6 +5291,8 @@ __gpucacheExecCompaction(GpuCacheControlCommand *cmd,
 												gc_lmap->gcache_extra_size);
 	}
 	pthreadRWLockUnlock(&gc_lmap->gcache_rwlock);
+out:
+	putGpuCacheLocalMapping(gc_lmap);
 	return status;
 }
 
@@ -3364,8 +5327,13 @@ __gpucacheExecApplyRedoKernel(GpuCacheControlCommand *cmd,
 	head_pos = gc_sstate->redo_read_pos;
 	tail_pos = gc_sstate->redo_write_pos;
 	nitems  = (gc_sstate->redo_write_nitems - gc_sstate->redo_read_nitems);
+	gc_sstate->redo_apply_timestamp = GetCurrentTimestamp();
 	pthreadMutexUnlock(&gc_sstate->redo_mutex);
 
+	/* already applied by the concurrent request */
+	if (nitems == 0)
+		return 0;
+
 	/* alloc kern_gpucache_redolog */
 	length = (MAXALIGN(offsetof(kern_gpucache_redolog,
 								redo_items[nitems])) +
@@ -3511,6 +5479,7 @@ retry:
 				pg_atomic_read_u64(&gc_sstate->gcache_extra_usage),
 				pg_atomic_read_u64(&gc_sstate->gcache_extra_dead));
 #endif
+		__gpucacheApplyRedoReplicas(gc_lmap, m_gcache_redo);
 		status = 0;		/* success */
 	}
 bailout:
@@ -3543,6 +5512,7 @@ __gpucacheExecApplyRedo(GpuCacheControlCommand *cmd,
 	}
 
 	pthreadRWLockWriteLock(&gc_lmap->gcache_rwlock);
+	gc_lmap->gcache_version++;
 	if (gc_lmap->gcache_main_devptr == 0UL)
 	{
 		status = __gpucacheAllocDeviceMemory(gc_lmap,
@@ -3562,6 +5532,80 @@ bailout:
 	return status;
 }
 
+/*
+ * GCACHE_CONTROL_CMD__FETCH_AGGREGATE
+ */
+static int
+__gpucacheExecFetchAggregate(GpuCacheControlCommand *cmd,
+							 CUfunction f_gcache_apply_redo,
+							 CUfunction f_gcache_compaction)
+{
+	GpuCacheLocalMapping *gc_lmap;
+	GpuCacheSharedState *gc_sstate;
+	kern_data_store *kds;
+	const kern_colmeta *cmeta = NULL;
+	int			status = 0;
+
+	gc_lmap = getGpuCacheLocalMappingIfExist(cmd->ident.database_oid,
+											 cmd->ident.table_oid,
+											 cmd->ident.signature);
+	if (!gc_lmap)
+	{
+		snprintf(cmd->errbuf, sizeof(cmd->errbuf),
+				 "shared memory segment (dat=%u,rel=%u,sig=%09lx) not found",
+				 cmd->ident.database_oid,
+				 cmd->ident.table_oid,
+				 cmd->ident.signature);
+		return EEXIST;
+	}
+	gc_sstate = gc_lmap->gc_sstate;
+
+	pthreadRWLockWriteLock(&gc_lmap->gcache_rwlock);
+	if (gc_lmap->gcache_main_devptr == 0UL)
+	{
+		status = __gpucacheAllocDeviceMemory(gc_lmap,
+											 cmd->errbuf,
+											 sizeof(cmd->errbuf));
+		if (status)
+			goto bailout;
+	}
+	/* apply the pending REDO logs first */
+	gc_lmap->gcache_version++;
+	status = __gpucacheExecApplyRedoKernel(cmd, gc_lmap,
+										   f_gcache_apply_redo,
+										   f_gcache_compaction);
+	if (status)
+		goto bailout;
+
+	kds = (kern_data_store *)gc_lmap->gcache_main_devptr;
+	for (int j=0; j < kds->ncols; j++)
+	{
+		if (kds->colmeta[j].agg_nslots > 0)
+		{
+			cmeta = &kds->colmeta[j];
+			break;
+		}
+	}
+	if (!cmeta || gc_sstate->agg_buffer_offset == 0)
+	{
+		snprintf(cmd->errbuf, sizeof(cmd->errbuf),
+				 "no maintained aggregation on the GpuCache");
+		status = EINVAL;
+		goto bailout;
+	}
+	/* copy the aggregation slots to the shared memory segment */
+	pthreadMutexLock(&gc_sstate->redo_mutex);
+	memcpy((char *)gc_sstate + gc_sstate->agg_buffer_offset,
+		   (char *)kds + __kds_unpack(cmeta->agg_offset),
+		   sizeof(kern_gpucache_aggslot) * cmeta->agg_nslots);
+	gc_sstate->agg_invalid = (cmeta->agg_invalid != 0);
+	pthreadMutexUnlock(&gc_sstate->redo_mutex);
+bailout:
+	pthreadRWLockUnlock(&gc_lmap->gcache_rwlock);
+	putGpuCacheLocalMapping(gc_lmap);
+	return status;
+}
+
 /*
  * GCACHE_CONTROL_CMD__DROP_UNLOAD
  */
@@ -3590,481 +5634,2243 @@ __gpucacheExecDropUnload(GpuCacheControlCommand *cmd)
 }
 
 /*
- * gpucacheManagerEventLoop
+ * __gpucacheGetSysattr - host side version of kds_column_get_sysattr
  */
-void
-gpucacheManagerEventLoop(int cuda_dindex,
-						 CUcontext cuda_context,
-						 CUmodule cuda_module)
+static inline GpuCacheSysattr *
+__gpucacheGetSysattr(kern_data_store *kds, uint32_t rowid)
 {
-	pthread_mutex_t *cmd_mutex = &gcache_shared_head->gcache_cmd_mutex;
-	pthread_cond_t *cmd_cond = &gcache_shared_head->gpus[cuda_dindex].cond;
-	dlist_head	   *cmd_queue = &gcache_shared_head->gpus[cuda_dindex].queue;
-	CUfunction		f_gcache_apply_redo;
-	CUfunction		f_gcache_compaction;
-	CUresult		rc;
-	GpuCacheControlCommand *cmd;
+	kern_colmeta *cmeta = &kds->colmeta[kds->nr_colmeta - 1];
 
-	rc = cuModuleGetFunction(&f_gcache_apply_redo,
-							 cuda_module,
-							 "kern_gpucache_apply_redo");
-	if (rc != CUDA_SUCCESS)
-	{
-		fprintf(stderr, "gpucache: unable to lookup gpucache_apply_redo\n");
-		return;
-	}
-	rc = cuModuleGetFunction(&f_gcache_compaction,
-							 cuda_module,
-							 "kern_gpucache_compaction");
-	if (rc != CUDA_SUCCESS)
+	Assert(cmeta->attlen == sizeof(GpuCacheSysattr) &&
+		   rowid < kds->column_nrooms);
+	return (GpuCacheSysattr *)((char *)kds + __kds_unpack(cmeta->values_offset)) + rowid;
+}
+
+/*
+ * __gpucacheRebuildRowIdMap
+ *
+ * It reconstructs the rowid-map from the system attributes in the device
+ * buffer; every live row has frozen xmin and no committed xmax.
+ */
+static void
+__gpucacheRebuildRowIdMap(GpuCacheLocalMapping *gc_lmap)
+{
+	GpuCacheSharedState *gc_sstate = gc_lmap->gc_sstate;
+	kern_data_store *kds = (kern_data_store *)gc_lmap->gcache_main_devptr;
+	uint32_t   *hslot = gpuCacheRowIdHashSlot(gc_sstate);
+	GpuCacheRowIdItem *rowitems = gpuCacheRowIdItemArray(gc_sstate);
+	uint32_t	nslots = gc_sstate->gc_options.rowid_hash_nslots;
+	uint32_t	nrooms = gc_sstate->gc_options.max_num_rows;
+
+	__lockGpuCacheRowIdMap(gc_sstate);
+	for (uint32_t i=0; i < nslots; i++)
+		hslot[i] = UINT_MAX;
+	for (int p=0; p < GCACHE_ROWID_NPARTS; p++)
 	{
-		fprintf(stderr, "gpucache: unable to lookup gpucache_compaction\n");
+		gc_sstate->rowid_parts[p].next_free = UINT_MAX;
+		gc_sstate->rowid_parts[p].num_free = 0;
+	}
+	/* walk on the rowid backward, to keep the free-list ascending order */
+	for (uint32_t rowid = nrooms; rowid-- > 0; )
+	{
+		GpuCacheRowIdItem *ritem = &rowitems[rowid];
+		GpuCacheSysattr *sysattr = NULL;
+
+		if (rowid < kds->nitems)
+			sysattr = __gpucacheGetSysattr(kds, rowid);
+		if (sysattr &&
+			sysattr->xmin == FrozenTransactionId &&
+			sysattr->xmax != FrozenTransactionId)
+		{
+			uint32_t	hash = hash_bytes((unsigned char *)&sysattr->ctid,
+										  sizeof(ItemPointerData));
+			uint32_t	hindex = hash % nslots;
+
+			ItemPointerCopy(&sysattr->ctid, &ritem->ctid);
+			ritem->next = hslot[hindex];
+			hslot[hindex] = rowid;
+		}
+		else
+		{
+			GpuCacheRowIdPart *part = &gc_sstate->rowid_parts[rowid % GCACHE_ROWID_NPARTS];
+
+			ItemPointerSetInvalid(&ritem->ctid);
+			ritem->next = part->next_free;
+			part->next_free = rowid;
+			part->num_free++;
+		}
+	}
+	__unlockGpuCacheRowIdMap(gc_sstate);
+}
+
+/*
+ * GCACHE_CONTROL_CMD__LOAD_SNAPSHOT
+ */
+static int
+__readSnapshotFile(int fdesc, void *buf, size_t len, off_t off)
+{
+	while (len > 0)
+	{
+		ssize_t	nbytes = pread(fdesc, buf, len, off);
+
+		if (nbytes < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			return errno;
+		}
+		if (nbytes == 0)
+			return EIO;		/* unexpected EOF */
+		buf = (char *)buf + nbytes;
+		len -= nbytes;
+		off += nbytes;
+	}
+	return 0;
+}
+
+static int
+__gpucacheExecLoadSnapshot(GpuCacheControlCommand *cmd)
+{
+	GpuCacheLocalMapping *gc_lmap;
+	GpuCacheSharedState *gc_sstate;
+	GpuCacheSnapshotHead shead;
+	kern_data_store *kds;
+	kern_data_extra *extra;
+	char		namebuf[MAXPGPATH];
+	struct stat	stat_buf;
+	int			fdesc = -1;
+	int			status;
+	CUresult	rc;
+
+	gc_lmap = getGpuCacheLocalMappingIfExist(cmd->ident.database_oid,
+											 cmd->ident.table_oid,
+											 cmd->ident.signature);
+	if (!gc_lmap)
+	{
+		snprintf(cmd->errbuf, sizeof(cmd->errbuf),
+				 "shared memory segment (dat=%u,rel=%u,sig=%09lx) not found",
+				 cmd->ident.database_oid,
+				 cmd->ident.table_oid,
+				 cmd->ident.signature);
+		return EEXIST;
+	}
+	gc_sstate = gc_lmap->gc_sstate;
+
+	pthreadRWLockWriteLock(&gc_lmap->gcache_rwlock);
+	if (gc_lmap->gcache_main_devptr != 0UL)
+	{
+		snprintf(cmd->errbuf, sizeof(cmd->errbuf),
+				 "device buffer is already allocated");
+		status = EEXIST;
+		goto bailout;
+	}
+	GpuCacheSnapshotName(namebuf, MAXPGPATH, &cmd->ident);
+	fdesc = open(namebuf, O_RDONLY);
+	if (fdesc < 0 || fstat(fdesc, &stat_buf) != 0)
+	{
+		status = errno;
+		snprintf(cmd->errbuf, sizeof(cmd->errbuf),
+				 "failed on open('%s'): %s", namebuf, strerror(status));
+		goto bailout;
+	}
+	status = __readSnapshotFile(fdesc, &shead, sizeof(shead), 0);
+	if (status)
+	{
+		snprintf(cmd->errbuf, sizeof(cmd->errbuf),
+				 "failed on read('%s'): %s", namebuf, strerror(status));
+		goto bailout;
+	}
+	if (memcmp(shead.magic, "GCSNAP01", 8) != 0 ||
+		shead.system_identifier != GetSystemIdentifier() ||
+		!GpuCacheIdentEqual(&shead.ident, &gc_sstate->ident) ||
+		!GpuCacheOptionsEqual(&shead.gc_options, &gc_sstate->gc_options) ||
+		shead.main_size != gc_sstate->kds_head.length ||
+		shead.extra_usage > shead.extra_size ||
+		(shead.extra_size == 0) != (gc_sstate->kds_extra_sz == 0) ||
+		stat_buf.st_size != (sizeof(GpuCacheSnapshotHead) +
+							 shead.main_size +
+							 shead.extra_usage))
+	{
+		snprintf(cmd->errbuf, sizeof(cmd->errbuf),
+				 "snapshot '%s' does not match the GpuCache", namebuf);
+		status = EINVAL;
+		goto bailout;
+	}
+	/* allocation of the device buffer */
+	status = __gpucacheAllocDeviceMemory(gc_lmap,
+										 cmd->errbuf,
+										 sizeof(cmd->errbuf));
+	if (status)
+		goto bailout;
+	if (shead.extra_size != gc_lmap->gcache_extra_size)
+	{
+		/* extra buffer might be expanded on the compaction */
+		CUdeviceptr	m_extra;
+
+		rc = cuMemAllocManaged(&m_extra, shead.extra_size,
+							   CU_MEM_ATTACH_GLOBAL);
+		if (rc != CUDA_SUCCESS)
+		{
+			snprintf(cmd->errbuf, sizeof(cmd->errbuf),
+					 "failed on cuMemAllocManaged: %s", cuStrError(rc));
+			status = ENOMEM;
+			goto bailout;
+		}
+		cuMemFree(gc_lmap->gcache_extra_devptr);
+		gc_lmap->gcache_extra_devptr = m_extra;
+		gc_lmap->gcache_extra_size = shead.extra_size;
+		pg_atomic_write_u64(&gc_sstate->gcache_extra_size, shead.extra_size);
+	}
+	/* read the device buffer from the snapshot */
+	kds = (kern_data_store *)gc_lmap->gcache_main_devptr;
+	extra = (kern_data_extra *)gc_lmap->gcache_extra_devptr;
+	status = __readSnapshotFile(fdesc, kds, shead.main_size,
+								sizeof(GpuCacheSnapshotHead));
+	if (status == 0 && extra)
+		status = __readSnapshotFile(fdesc, extra, shead.extra_usage,
+									sizeof(GpuCacheSnapshotHead) +
+									shead.main_size);
+	if (status)
+	{
+		snprintf(cmd->errbuf, sizeof(cmd->errbuf),
+				 "failed on read('%s'): %s", namebuf, strerror(status));
+		goto bailout;
+	}
+	if (kds->length != gc_sstate->kds_head.length ||
+		kds->column_nrooms != gc_sstate->kds_head.column_nrooms ||
+		kds->nr_colmeta != gc_sstate->kds_head.nr_colmeta ||
+		kds->nitems > kds->column_nrooms ||
+		memcmp(kds->colmeta, gc_sstate->kds_head.colmeta,
+			   sizeof(kern_colmeta) * kds->nr_colmeta) != 0 ||
+		(extra && (extra->length != shead.extra_size ||
+				   extra->usage  != shead.extra_usage)))
+	{
+		snprintf(cmd->errbuf, sizeof(cmd->errbuf),
+				 "snapshot '%s' has inconsistent buffer", namebuf);
+		status = EINVAL;
+		goto bailout;
+	}
+	__gpucacheRebuildRowIdMap(gc_lmap);
+	gc_lmap->gcache_version++;
+	pg_atomic_write_u64(&gc_sstate->gcache_main_nitems, kds->nitems);
+	pg_atomic_write_u64(&gc_sstate->gcache_extra_usage, shead.extra_usage);
+	pg_atomic_write_u64(&gc_sstate->gcache_extra_dead, shead.extra_dead);
+	/* the snapshot file is still consistent with the device buffer */
+	pthreadMutexLock(&gc_sstate->redo_mutex);
+	gc_sstate->snapshot_valid = true;
+	pthreadMutexUnlock(&gc_sstate->redo_mutex);
+bailout:
+	if (status)
+	{
+		/* release the device buffer, then rollback to the empty state */
+		if (gc_lmap->gcache_main_devptr != 0UL)
+		{
+			cuMemFree(gc_lmap->gcache_main_devptr);
+			gc_lmap->gcache_main_devptr = 0UL;
+			gc_lmap->gcache_main_size = 0;
+		}
+		if (gc_lmap->gcache_extra_devptr != 0UL)
+		{
+			cuMemFree(gc_lmap->gcache_extra_devptr);
+			gc_lmap->gcache_extra_devptr = 0UL;
+			gc_lmap->gcache_extra_size = 0;
+		}
+		pg_atomic_write_u64(&gc_sstate->gcache_main_size, 0);
+		pg_atomic_write_u64(&gc_sstate->gcache_extra_size, 0);
+		__resetGpuCacheRowIdMap(gc_sstate);
+		/* the snapshot is useless any more */
+		if (status != EEXIST)
+			__gpuCacheUnlinkSnapshot(&cmd->ident);
+	}
+	if (fdesc >= 0)
+		close(fdesc);
+	pthreadRWLockUnlock(&gc_lmap->gcache_rwlock);
+	putGpuCacheLocalMapping(gc_lmap);
+	return status;
+}
+
+/*
+ * __gpucacheWriteSnapshot
+ *
+ * NOTE: caller must hold the shared lock of gcache_rwlock
+ */
+static int
+__writeSnapshotFile(int fdesc, const void *buf, size_t len)
+{
+	while (len > 0)
+	{
+		ssize_t	nbytes = write(fdesc, buf, len);
+
+		if (nbytes < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			return errno;
+		}
+		buf = (const char *)buf + nbytes;
+		len -= nbytes;
+	}
+	return 0;
+}
+
+static void
+__gpucacheWriteSnapshot(GpuCacheLocalMapping *gc_lmap)
+{
+	GpuCacheSharedState *gc_sstate = gc_lmap->gc_sstate;
+	kern_data_store *kds = (kern_data_store *)gc_lmap->gcache_main_devptr;
+	kern_data_extra *extra = (kern_data_extra *)gc_lmap->gcache_extra_devptr;
+	GpuCacheSnapshotHead shead;
+	char		namebuf[MAXPGPATH];
+	char		tempbuf[MAXPGPATH];
+	uint64_t	write_pos;
+	int			fdesc = -1;
+	int			status = 0;
+
+	if (pg_atomic_read_u32(&gc_sstate->phase) != GCACHE_PHASE__IS_READY)
+		return;
+	/* all the REDO logs must be already applied */
+	pthreadMutexLock(&gc_sstate->redo_mutex);
+	write_pos = gc_sstate->redo_write_pos;
+	if (gc_sstate->snapshot_valid ||
+		gc_sstate->redo_read_pos != write_pos)
+	{
+		pthreadMutexUnlock(&gc_sstate->redo_mutex);
 		return;
 	}
-	
-	pthreadMutexLock(cmd_mutex);
-	while (!gpuServiceGoingTerminate())
+	pthreadMutexUnlock(&gc_sstate->redo_mutex);
+
+	/*
+	 * in-progress transactions are not restorable, because backends
+	 * that shall write the COMMIT/ABORT logs are gone after restart.
+	 */
+	for (uint32_t rowid=0; rowid < kds->nitems; rowid++)
 	{
-		int		status;
+		GpuCacheSysattr *sysattr = __gpucacheGetSysattr(kds, rowid);
 
-		if (dlist_is_empty(cmd_queue))
+		if (TransactionIdIsNormal(sysattr->xmin) ||
+			TransactionIdIsNormal(sysattr->xmax))
+			return;
+	}
+
+	memset(&shead, 0, sizeof(GpuCacheSnapshotHead));
+	memcpy(shead.magic, "GCSNAP01", 8);
+	shead.system_identifier = GetSystemIdentifier();
+	memcpy(&shead.ident, &gc_sstate->ident, sizeof(GpuCacheIdent));
+	memcpy(&shead.gc_options, &gc_sstate->gc_options, sizeof(GpuCacheOptions));
+	shead.timestamp   = GetCurrentTimestamp();
+	shead.main_size   = kds->length;
+	shead.extra_size  = (extra ? extra->length : 0);
+	shead.extra_usage = (extra ? extra->usage : 0);
+	shead.extra_dead  = (extra ? extra->deadspace : 0);
+
+	if (mkdir(pgstrom_gpucache_snapshot_dir, 0700) != 0 && errno != EEXIST)
+	{
+		fprintf(stderr, "gpucache: failed on mkdir('%s'): %m\n",
+				pgstrom_gpucache_snapshot_dir);
+		return;
+	}
+	GpuCacheSnapshotName(namebuf, MAXPGPATH, &gc_sstate->ident);
+	snprintf(tempbuf, MAXPGPATH, "%s.tmp", namebuf);
+	fdesc = open(tempbuf, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+	if (fdesc < 0)
+	{
+		fprintf(stderr, "gpucache: failed on open('%s'): %m\n", tempbuf);
+		return;
+	}
+	status = __writeSnapshotFile(fdesc, &shead, sizeof(GpuCacheSnapshotHead));
+	if (status == 0)
+		status = __writeSnapshotFile(fdesc, kds, shead.main_size);
+	if (status == 0 && extra)
+		status = __writeSnapshotFile(fdesc, extra, shead.extra_usage);
+	if (status == 0 && fsync(fdesc) != 0)
+		status = errno;
+	close(fdesc);
+	if (status)
+	{
+		fprintf(stderr, "gpucache: failed to write snapshot '%s': %s\n",
+				tempbuf, strerror(status));
+		unlink(tempbuf);
+		return;
+	}
+
+	/* make the snapshot visible, if nobody updated the GpuCache meanwhile */
+	pthreadMutexLock(&gc_sstate->redo_mutex);
+	if (gc_sstate->redo_write_pos == write_pos &&
+		pg_atomic_read_u32(&gc_sstate->phase) == GCACHE_PHASE__IS_READY &&
+		rename(tempbuf, namebuf) == 0)
+	{
+		fdesc = open(pgstrom_gpucache_snapshot_dir, O_RDONLY);
+		if (fdesc >= 0)
 		{
-			if (!pthreadCondWaitTimeout(cmd_cond, cmd_mutex, 5000L))
-			{
-				/* timeout -> add some maintenance work here*/
-			}
-			continue;
+			fsync(fdesc);
+			close(fdesc);
 		}
-		/* fetch a command */
-		cmd = dlist_container(GpuCacheControlCommand, chain,
-							  dlist_pop_head_node(cmd_queue));
-		dlist_delete(&cmd->chain);
-		memset(&cmd->chain, 0, sizeof(dlist_node));
-		pthreadMutexUnlock(cmd_mutex);
+		gc_sstate->snapshot_valid = true;
+	}
+	else
+	{
+		unlink(tempbuf);
+	}
+	pthreadMutexUnlock(&gc_sstate->redo_mutex);
+#ifdef GPUCACHE_DEBUG_MESSAGE
+	fprintf(stderr, "gpucache: snapshot of '%s' (nitems=%u) %s\n",
+			gc_sstate->table_name, kds->nitems,
+			gc_sstate->snapshot_valid ? "written" : "discarded");
+#endif
+}
 
-		switch (cmd->command)
+/*
+ * __gpucacheTakeSnapshots
+ *
+ * It writes out the snapshot of every GpuCache on the device, if updated.
+ */
+static void
+__gpucacheTakeSnapshots(int cuda_dindex)
+{
+	GpuCacheLocalMapping **gc_lmap_array;
+	int			nitems = 0;
+	int			nrooms = 0;
+
+	pthreadMutexLock(&gcache_shared_mapping_lock);
+	for (int i=0; i < GCACHE_SHARED_MAPPING_NSLOTS; i++)
+	{
+		dlist_iter	iter;
+
+		dlist_foreach(iter, &gcache_shared_mapping_slot[i])
+			nrooms++;
+	}
+	gc_lmap_array = (nrooms > 0 ? malloc(sizeof(GpuCacheLocalMapping *) * nrooms) : NULL);
+	for (int i=0; gc_lmap_array && i < GCACHE_SHARED_MAPPING_NSLOTS; i++)
+	{
+		dlist_iter	iter;
+
+		dlist_foreach(iter, &gcache_shared_mapping_slot[i])
 		{
-			case GCACHE_CONTROL_CMD__APPLY_REDO:
-				status = __gpucacheExecApplyRedo(cmd,
-												 f_gcache_apply_redo,
-												 f_gcache_compaction);
-				break;
-			case GCACHE_CONTROL_CMD__COMPACTION:
-				status = __gpucacheExecCompaction(cmd, f_gcache_compaction);
-				break;
-			case GCACHE_CONTROL_CMD__DROP_UNLOAD:
-				status = __gpucacheExecDropUnload(cmd);
-				break;
-			default:
-				status = EINVAL;
-				snprintf(cmd->errbuf, sizeof(cmd->errbuf),
-						 "gpucache: unknown command ('%c')",
-						 cmd->command);
-				break;
+			GpuCacheLocalMapping *gc_lmap
+				= dlist_container(GpuCacheLocalMapping, chain, iter.cur);
+
+			if (gc_lmap->gc_sstate->gc_options.cuda_dindex == cuda_dindex &&
+				gc_lmap->gcache_main_devptr != 0UL)
+			{
+				gc_lmap->refcnt += 2;
+				gc_lmap_array[nitems++] = gc_lmap;
+			}
 		}
-		pthreadMutexLock(cmd_mutex);
-		cmd->errcode = status;
-		if (cmd->backend)
-			SetLatch(cmd->backend);
-		else
-			dlist_push_head(&gcache_shared_head->gcache_free_cmds, &cmd->chain);
 	}
-	/* returns the pending commands immediately */
-	while (!dlist_is_empty(cmd_queue))
+	pthreadMutexUnlock(&gcache_shared_mapping_lock);
+
+	for (int i=0; i < nitems; i++)
+	{
+		GpuCacheLocalMapping *gc_lmap = gc_lmap_array[i];
+
+		pthreadRWLockReadLock(&gc_lmap->gcache_rwlock);
+		if (gc_lmap->gcache_main_devptr != 0UL)
+			__gpucacheWriteSnapshot(gc_lmap);
+		pthreadRWLockUnlock(&gc_lmap->gcache_rwlock);
+		putGpuCacheLocalMapping(gc_lmap);
+	}
+	if (gc_lmap_array)
+		free(gc_lmap_array);
+}
+
+/* ------------------------------------------------------------
+ *
+ * Eviction of cold GpuCache to the host memory
+ *
+ * GpuCache buffers are managed memory, so we don't need to copy them by
+ * ourselves. Once the total size of the GpuCache resident on a device
+ * exceeds pg_strom.gpucache_device_budget, the least recently scanned
+ * ones are moved to the host memory (preferred location = CPU), but still
+ * mapped to the device; GPU kernels can scan them over PCIe, and apply
+ * REDO logs as usual. The next scan brings the buffers back to the device.
+ *
+ * ------------------------------------------------------------
+ */
+static void
+__gpucacheAdviseLocation(CUdeviceptr m_buffer, size_t length,
+						 CUdevice location, bool prefetch)
+{
+	CUdevice	cuda_device;
+	CUresult	rc;
+
+	if (m_buffer == 0UL || length == 0)
+		return;
+	rc = cuCtxGetDevice(&cuda_device);
+	if (rc != CUDA_SUCCESS)
+	{
+		fprintf(stderr, "failed on cuCtxGetDevice: %s\n", cuStrError(rc));
+		return;
+	}
+	rc = cuMemAdvise(m_buffer, length,
+					 CU_MEM_ADVISE_SET_PREFERRED_LOCATION, location);
+	if (rc != CUDA_SUCCESS)
+		fprintf(stderr, "failed on cuMemAdvise: %s\n", cuStrError(rc));
+	/* keep the buffer mapped to the device, even if it is on the host */
+	rc = cuMemAdvise(m_buffer, length,
+					 CU_MEM_ADVISE_SET_ACCESSED_BY, cuda_device);
+	if (rc != CUDA_SUCCESS)
+		fprintf(stderr, "failed on cuMemAdvise: %s\n", cuStrError(rc));
+	if (prefetch)
+	{
+		rc = cuMemPrefetchAsync(m_buffer, length, location,
+								CU_STREAM_PER_THREAD);
+		if (rc != CUDA_SUCCESS)
+			fprintf(stderr, "failed on cuMemPrefetchAsync: %s\n",
+					cuStrError(rc));
+	}
+}
+
+/*
+ * __gpucacheTouchDeviceBuffer
+ *
+ * NOTE: must be called under the shared lock of gcache_rwlock
+ */
+static void
+__gpucacheTouchDeviceBuffer(GpuCacheLocalMapping *gc_lmap)
+{
+	GpuCacheSharedState *gc_sstate = gc_lmap->gc_sstate;
+	CUdevice	cuda_device;
+
+	gc_lmap->gcache_last_access = GetCurrentTimestamp();
+	if (pg_atomic_read_u32(&gc_sstate->gcache_evicted) != 0 &&
+		pg_atomic_exchange_u32(&gc_sstate->gcache_evicted, 0) != 0 &&
+		cuCtxGetDevice(&cuda_device) == CUDA_SUCCESS)
+	{
+		__gpucacheAdviseLocation(gc_lmap->gcache_main_devptr,
+								 gc_lmap->gcache_main_size,
+								 cuda_device, true);
+		__gpucacheAdviseLocation(gc_lmap->gcache_extra_devptr,
+								 gc_lmap->gcache_extra_size,
+								 cuda_device, true);
+		pg_atomic_fetch_add_u64(&gc_sstate->gcache_restore_count, 1);
+	}
+}
+
+static int
+__gpucacheLastAccessComp(const void *__a, const void *__b)
+{
+	const GpuCacheLocalMapping *a = *((const GpuCacheLocalMapping **)__a);
+	const GpuCacheLocalMapping *b = *((const GpuCacheLocalMapping **)__b);
+
+	if (a->gcache_last_access < b->gcache_last_access)
+		return -1;
+	if (a->gcache_last_access > b->gcache_last_access)
+		return 1;
+	return 0;
+}
+
+/*
+ * __gpucacheEnforceDeviceBudget
+ */
+static void
+__gpucacheEnforceDeviceBudget(int cuda_dindex)
+{
+	GpuCacheLocalMapping **gc_lmap_array;
+	size_t		budget = ((size_t)pgstrom_gpucache_device_budget << 20);
+	size_t		total_sz = 0;
+	int			nitems = 0;
+	int			nrooms = 0;
+
+	if (budget == 0)
+		return;		/* unlimited */
+	pthreadMutexLock(&gcache_shared_mapping_lock);
+	for (int i=0; i < GCACHE_SHARED_MAPPING_NSLOTS; i++)
+	{
+		dlist_iter	iter;
+
+		dlist_foreach(iter, &gcache_shared_mapping_slot[i])
+			nrooms++;
+	}
+	gc_lmap_array = (nrooms > 0 ? malloc(sizeof(GpuCacheLocalMapping *) * nrooms) : NULL);
+	for (int i=0; gc_lmap_array && i < GCACHE_SHARED_MAPPING_NSLOTS; i++)
+	{
+		dlist_iter	iter;
+
+		dlist_foreach(iter, &gcache_shared_mapping_slot[i])
+		{
+			GpuCacheLocalMapping *gc_lmap
+				= dlist_container(GpuCacheLocalMapping, chain, iter.cur);
+			GpuCacheSharedState *gc_sstate = gc_lmap->gc_sstate;
+
+			if (gc_sstate->gc_options.cuda_dindex == cuda_dindex &&
+				gc_lmap->gcache_main_devptr != 0UL &&
+				pg_atomic_read_u32(&gc_sstate->gcache_evicted) == 0)
+			{
+				total_sz += (gc_lmap->gcache_main_size +
+							 gc_lmap->gcache_extra_size);
+				gc_lmap->refcnt += 2;
+				gc_lmap_array[nitems++] = gc_lmap;
+			}
+		}
+	}
+	pthreadMutexUnlock(&gcache_shared_mapping_lock);
+
+	if (nitems > 1)
+		qsort(gc_lmap_array, nitems, sizeof(GpuCacheLocalMapping *),
+			  __gpucacheLastAccessComp);
+	for (int i=0; i < nitems; i++)
+	{
+		GpuCacheLocalMapping *gc_lmap = gc_lmap_array[i];
+		GpuCacheSharedState *gc_sstate = gc_lmap->gc_sstate;
+
+		/* the most recently scanned one is never evicted */
+		if (total_sz > budget && i < nitems - 1)
+		{
+			/* wait for completion of the concurrent scans */
+			pthreadRWLockWriteLock(&gc_lmap->gcache_rwlock);
+			if (gc_lmap->gcache_main_devptr != 0UL &&
+				pg_atomic_exchange_u32(&gc_sstate->gcache_evicted, 1) == 0)
+			{
+				__gpucacheAdviseLocation(gc_lmap->gcache_main_devptr,
+										 gc_lmap->gcache_main_size,
+										 CU_DEVICE_CPU, true);
+				__gpucacheAdviseLocation(gc_lmap->gcache_extra_devptr,
+										 gc_lmap->gcache_extra_size,
+										 CU_DEVICE_CPU, true);
+				cuStreamSynchronize(CU_STREAM_PER_THREAD);
+				pg_atomic_fetch_add_u64(&gc_sstate->gcache_evict_count, 1);
+				total_sz -= (gc_lmap->gcache_main_size +
+							 gc_lmap->gcache_extra_size);
+				fprintf(stderr, "gpucache: table '%s' was evicted to the host memory\n",
+						gc_sstate->table_name);
+			}
+			pthreadRWLockUnlock(&gc_lmap->gcache_rwlock);
+		}
+		putGpuCacheLocalMapping(gc_lmap);
+	}
+	if (gc_lmap_array)
+		free(gc_lmap_array);
+}
+
+/*
+ * __gpucacheApplyRedoOnRead
+ *
+ * It applies the REDO logs the scan needs to see, if GpuCache manager still
+ * not apply them. The caller must hold the exclusive lock on gcache_rwlock.
+ */
+static int
+__gpucacheApplyRedoOnRead(GpuCacheLocalMapping *gc_lmap,
+						  char *errbuf, size_t errbuf_sz)
+{
+	GpuCacheSharedState *gc_sstate = gc_lmap->gc_sstate;
+	GpuCacheDeviceFuncs *dfuncs;
+	GpuCacheControlCommand cmd;
+	int			status;
+
+	if (!gcache_device_funcs)
+		return 0;
+	dfuncs = &gcache_device_funcs[gc_sstate->gc_options.cuda_dindex];
+	if (!dfuncs->cuda_context ||
+		!dfuncs->f_gcache_apply_redo ||
+		!dfuncs->f_gcache_compaction)
+		return 0;
+
+	memset(&cmd, 0, offsetof(GpuCacheControlCommand, errbuf));
+	memcpy(&cmd.ident, &gc_lmap->ident, sizeof(GpuCacheIdent));
+	cmd.command = GCACHE_CONTROL_CMD__APPLY_REDO;
+	cmd.errbuf[0] = '\0';
+	/* kernels must run on the device of the primary buffer */
+	if (cuCtxPushCurrent(dfuncs->cuda_context) != CUDA_SUCCESS)
+		return 0;
+	gc_lmap->gcache_version++;
+	status = __gpucacheExecApplyRedoKernel(&cmd, gc_lmap,
+										   dfuncs->f_gcache_apply_redo,
+										   dfuncs->f_gcache_compaction);
+	cuCtxPopCurrent(NULL);
+	if (status)
+		strncpy(errbuf, cmd.errbuf, errbuf_sz);
+	return status;
+}
+
+/*
+ * __gpucacheApplyRedoOnInterval
+ *
+ * It applies the REDO logs retained longer than gpu_sync_interval, even if
+ * the buffer usage does not reach the gpu_sync_threshold.
+ */
+static void
+__gpucacheApplyRedoOnInterval(int cuda_dindex,
+							  CUfunction f_gcache_apply_redo,
+							  CUfunction f_gcache_compaction)
+{
+	GpuCacheLocalMapping **gc_lmap_array;
+	TimestampTz	now = GetCurrentTimestamp();
+	int			nitems = 0;
+	int			nrooms = 0;
+
+	pthreadMutexLock(&gcache_shared_mapping_lock);
+	for (int i=0; i < GCACHE_SHARED_MAPPING_NSLOTS; i++)
+	{
+		dlist_iter	iter;
+
+		dlist_foreach(iter, &gcache_shared_mapping_slot[i])
+			nrooms++;
+	}
+	gc_lmap_array = (nrooms > 0 ? malloc(sizeof(GpuCacheLocalMapping *) * nrooms) : NULL);
+	for (int i=0; gc_lmap_array && i < GCACHE_SHARED_MAPPING_NSLOTS; i++)
+	{
+		dlist_iter	iter;
+
+		dlist_foreach(iter, &gcache_shared_mapping_slot[i])
+		{
+			GpuCacheLocalMapping *gc_lmap
+				= dlist_container(GpuCacheLocalMapping, chain, iter.cur);
+			GpuCacheSharedState *gc_sstate = gc_lmap->gc_sstate;
+			bool		pending;
+
+			if (gc_sstate->gc_options.cuda_dindex != cuda_dindex ||
+				gc_lmap->gcache_main_devptr == 0UL ||
+				pg_atomic_read_u32(&gc_sstate->phase) != GCACHE_PHASE__IS_READY)
+				continue;
+			pthreadMutexLock(&gc_sstate->redo_mutex);
+			pending = (gc_sstate->redo_read_pos < gc_sstate->redo_write_pos &&
+					   TimestampDifferenceExceeds(gc_sstate->redo_apply_timestamp, now,
+												  gc_sstate->gc_options.gpu_sync_interval / 1000));
+			pthreadMutexUnlock(&gc_sstate->redo_mutex);
+			if (pending)
+			{
+				gc_lmap->refcnt += 2;
+				gc_lmap_array[nitems++] = gc_lmap;
+			}
+		}
+	}
+	pthreadMutexUnlock(&gcache_shared_mapping_lock);
+
+	for (int i=0; i < nitems; i++)
+	{
+		GpuCacheLocalMapping *gc_lmap = gc_lmap_array[i];
+		GpuCacheControlCommand cmd;
+
+		memset(&cmd, 0, sizeof(GpuCacheControlCommand));
+		memcpy(&cmd.ident, &gc_lmap->ident, sizeof(GpuCacheIdent));
+		cmd.command = GCACHE_CONTROL_CMD__APPLY_REDO;
+		pthreadRWLockWriteLock(&gc_lmap->gcache_rwlock);
+		if (gc_lmap->gcache_main_devptr != 0UL)
+		{
+			gc_lmap->gcache_version++;
+			if (__gpucacheExecApplyRedoKernel(&cmd, gc_lmap,
+											  f_gcache_apply_redo,
+											  f_gcache_compaction) != 0)
+				fprintf(stderr, "gpucache: %s\n", cmd.errbuf);
+		}
+		pthreadRWLockUnlock(&gc_lmap->gcache_rwlock);
+		putGpuCacheLocalMapping(gc_lmap);
+	}
+	if (gc_lmap_array)
+		free(gc_lmap_array);
+}
+
+/*
+ * __gpucacheMergeApplyRedoCommands
+ *
+ * It detaches the APPLY_REDO commands for the same GpuCache from the queue,
+ * because a kernel invocation applies all the REDO logs written until then.
+ */
+static void
+__gpucacheMergeApplyRedoCommands(dlist_head *cmd_queue,
+								 GpuCacheControlCommand *cmd,
+								 dlist_head *merged)
+{
+	dlist_mutable_iter iter;
+
+	dlist_foreach_modify(iter, cmd_queue)
+	{
+		GpuCacheControlCommand *__cmd
+			= dlist_container(GpuCacheControlCommand, chain, iter.cur);
+
+		if (__cmd->command == GCACHE_CONTROL_CMD__APPLY_REDO &&
+			memcmp(&__cmd->ident, &cmd->ident, sizeof(GpuCacheIdent)) == 0)
+		{
+			dlist_delete(&__cmd->chain);
+			dlist_push_tail(merged, &__cmd->chain);
+		}
+	}
+}
+
+/*
+ * gpucacheManagerEventLoop
+ */
+void
+gpucacheManagerEventLoop(int cuda_dindex,
+						 CUcontext cuda_context,
+						 CUmodule cuda_module)
+{
+	pthread_mutex_t *cmd_mutex = &gcache_shared_head->gcache_cmd_mutex;
+	pthread_cond_t *cmd_cond = &gcache_shared_head->gpus[cuda_dindex].cond;
+	dlist_head	   *cmd_queue = &gcache_shared_head->gpus[cuda_dindex].queue;
+	CUfunction		f_gcache_apply_redo;
+	CUfunction		f_gcache_compaction;
+	CUresult		rc;
+	uint64_t		tv_trace;
+	TimestampTz		tv_snapshot = GetCurrentTimestamp();
+	GpuCacheControlCommand *cmd;
+
+	rc = cuModuleGetFunction(&f_gcache_apply_redo,
+							 cuda_module,
+							 "kern_gpucache_apply_redo");
+	if (rc != CUDA_SUCCESS)
+	{
+		fprintf(stderr, "gpucache: unable to lookup gpucache_apply_redo\n");
+		return;
+	}
+	rc = cuModuleGetFunction(&f_gcache_compaction,
+							 cuda_module,
+							 "kern_gpucache_compaction");
+	if (rc != CUDA_SUCCESS)
+	{
+		fprintf(stderr, "gpucache: unable to lookup gpucache_compaction\n");
+		return;
+	}
+	pthreadMutexLock(cmd_mutex);
+	if (!gcache_device_funcs)
+		gcache_device_funcs = calloc(numGpuDevAttrs, sizeof(GpuCacheDeviceFuncs));
+	if (gcache_device_funcs)
+	{
+		gcache_device_funcs[cuda_dindex].f_gcache_apply_redo = f_gcache_apply_redo;
+		gcache_device_funcs[cuda_dindex].f_gcache_compaction = f_gcache_compaction;
+		gcache_device_funcs[cuda_dindex].cuda_context = cuda_context;
+	}
+
+	while (!gpuServiceGoingTerminate())
+	{
+		dlist_head	merged;
+		int			status;
+
+		if (pgstrom_gpucache_snapshot_dir &&
+			pgstrom_gpucache_snapshot_interval > 0 &&
+			TimestampDifferenceExceeds(tv_snapshot, GetCurrentTimestamp(),
+									   1000 * pgstrom_gpucache_snapshot_interval))
+		{
+			pthreadMutexUnlock(cmd_mutex);
+			__gpucacheTakeSnapshots(cuda_dindex);
+			tv_snapshot = GetCurrentTimestamp();
+			pthreadMutexLock(cmd_mutex);
+			continue;
+		}
+		if (dlist_is_empty(cmd_queue))
+		{
+			if (!pthreadCondWaitTimeout(cmd_cond, cmd_mutex, 1000L))
+			{
+				/* timeout -> add some maintenance work here*/
+				pthreadMutexUnlock(cmd_mutex);
+				__gpucacheApplyRedoOnInterval(cuda_dindex,
+											  f_gcache_apply_redo,
+											  f_gcache_compaction);
+				__gpucacheEnforceDeviceBudget(cuda_dindex);
+				pthreadMutexLock(cmd_mutex);
+			}
+			continue;
+		}
+		/* fetch a command */
+		cmd = dlist_container(GpuCacheControlCommand, chain,
+							  dlist_pop_head_node(cmd_queue));
+		dlist_delete(&cmd->chain);
+		memset(&cmd->chain, 0, sizeof(dlist_node));
+		dlist_init(&merged);
+		if (cmd->command == GCACHE_CONTROL_CMD__APPLY_REDO)
+			__gpucacheMergeApplyRedoCommands(cmd_queue, cmd, &merged);
+		pthreadMutexUnlock(cmd_mutex);
+
+		tv_trace = gpuservTraceBegin();
+		switch (cmd->command)
+		{
+			case GCACHE_CONTROL_CMD__APPLY_REDO:
+				status = __gpucacheExecApplyRedo(cmd,
+												 f_gcache_apply_redo,
+												 f_gcache_compaction);
+				gpuservTraceEnd("gpucache", "apply redo", tv_trace);
+				break;
+			case GCACHE_CONTROL_CMD__COMPACTION:
+				status = __gpucacheExecCompaction(cmd, f_gcache_compaction);
+				gpuservTraceEnd("gpucache", "compaction", tv_trace);
+				break;
+			case GCACHE_CONTROL_CMD__DROP_UNLOAD:
+				status = __gpucacheExecDropUnload(cmd);
+				gpuservTraceEnd("gpucache", "drop unload", tv_trace);
+				break;
+			case GCACHE_CONTROL_CMD__LOAD_SNAPSHOT:
+				status = __gpucacheExecLoadSnapshot(cmd);
+				gpuservTraceEnd("gpucache", "load snapshot", tv_trace);
+				break;
+			case GCACHE_CONTROL_CMD__FETCH_AGGREGATE:
+				status = __gpucacheExecFetchAggregate(cmd,
+													  f_gcache_apply_redo,
+													  f_gcache_compaction);
+				gpuservTraceEnd("gpucache", "fetch aggregate", tv_trace);
+				break;
+			default:
+				status = EINVAL;
+				snprintf(cmd->errbuf, sizeof(cmd->errbuf),
+						 "gpucache: unknown command ('%c')",
+						 cmd->command);
+				break;
+		}
+		pthreadMutexLock(cmd_mutex);
+		/* the merged commands also complete with the same status */
+		while (!dlist_is_empty(&merged))
+		{
+			GpuCacheControlCommand *__cmd
+				= dlist_container(GpuCacheControlCommand, chain,
+								  dlist_pop_head_node(&merged));
+			memset(&__cmd->chain, 0, sizeof(dlist_node));
+			if (status)
+				strcpy(__cmd->errbuf, cmd->errbuf);
+			__cmd->errcode = status;
+			if (__cmd->backend)
+				SetLatch(__cmd->backend);
+			else
+				dlist_push_head(&gcache_shared_head->gcache_free_cmds, &__cmd->chain);
+		}
+		cmd->errcode = status;
+		if (cmd->backend)
+			SetLatch(cmd->backend);
+		else
+			dlist_push_head(&gcache_shared_head->gcache_free_cmds, &cmd->chain);
+	}
+	/* final snapshot for the fast restart */
+	if (pgstrom_gpucache_snapshot_dir)
+	{
+		pthreadMutexUnlock(cmd_mutex);
+		__gpucacheTakeSnapshots(cuda_dindex);
+		pthreadMutexLock(cmd_mutex);
+	}
+	/* returns the pending commands immediately */
+	while (!dlist_is_empty(cmd_queue))
+	{
+		cmd = dlist_container(GpuCacheControlCommand, chain,
+							  dlist_pop_head_node(cmd_queue));
+		dlist_delete(&cmd->chain);
+		memset(&cmd->chain, 0, sizeof(dlist_node));
+		snprintf(cmd->errbuf, sizeof(cmd->errbuf),
+				 "GpuService is now shutting down...");
+		cmd->errcode = EBUSY;
+		if (cmd->backend)
+			SetLatch(cmd->backend);
+		else
+			dlist_push_head(&gcache_shared_head->gcache_free_cmds, &cmd->chain);
+	}
+	pthreadMutexUnlock(cmd_mutex);
+}
+
+/*
+ * gpucacheManagerWakeUp
+ */
+void
+gpucacheManagerWakeUp(int cuda_dindex)
+{
+	if (cuda_dindex >= 0 && cuda_dindex < numGpuDevAttrs)
+	{
+		pthreadCondBroadcast(&gcache_shared_head->gpus[cuda_dindex].cond);
+	}
+	else
+	{
+		/* wakeup all */
+		for (int i=0; i < cuda_dindex; i++)
+			pthreadCondBroadcast(&gcache_shared_head->gpus[i].cond);
+	}
+}
+
+/*
+ * __gpucacheHasUnappliedRedo
+ */
+static bool
+__gpucacheHasUnappliedRedo(GpuCacheSharedState *gc_sstate)
+{
+	bool		pending;
+
+	pthreadMutexLock(&gc_sstate->redo_mutex);
+	pending = (gc_sstate->redo_read_pos < gc_sstate->redo_sync_pos);
+	pthreadMutexUnlock(&gc_sstate->redo_mutex);
+
+	return pending;
+}
+
+/*
+ * gpuCacheGetDeviceBuffer
+ */
+void *
+gpuCacheGetDeviceBuffer(const GpuCacheIdent *ident,
+						int cuda_dindex,
+						CUdeviceptr *p_gcache_main_devptr,
+						CUdeviceptr *p_gcache_extra_devptr,
+						char *errbuf, size_t errbuf_sz)
+{
+	GpuCacheLocalMapping *gc_lmap;
+	GpuCacheLocalMapping *replica = NULL;
+	uint64		replica_mask;
+	bool		has_exclusive = false;
+
+	gc_lmap = getGpuCacheLocalMappingIfExist(ident->database_oid,
+											 ident->table_oid,
+											 ident->signature);
+	if (!gc_lmap)
+		return NULL;
+	pthreadRWLockReadLock(&gc_lmap->gcache_rwlock);
+retry:
+	if (gc_lmap->gcache_main_devptr == 0UL)
+	{
+		if (!has_exclusive)
+		{
+			pthreadRWLockUnlock(&gc_lmap->gcache_rwlock);
+			has_exclusive = true;
+			pthreadRWLockWriteLock(&gc_lmap->gcache_rwlock);
+			goto retry;
+		}
+		if (__gpucacheAllocDeviceMemory(gc_lmap,
+										errbuf, errbuf_sz) != 0)
+		{
+			pthreadRWLockUnlock(&gc_lmap->gcache_rwlock);
+			putGpuCacheLocalMapping(gc_lmap);
+			return NULL;
+		}
+	}
+	/* merge-on-read, if REDO logs to be visible are not applied yet */
+	if (__gpucacheHasUnappliedRedo(gc_lmap->gc_sstate))
+	{
+		if (!has_exclusive)
+		{
+			pthreadRWLockUnlock(&gc_lmap->gcache_rwlock);
+			has_exclusive = true;
+			pthreadRWLockWriteLock(&gc_lmap->gcache_rwlock);
+			goto retry;
+		}
+		if (__gpucacheApplyRedoOnRead(gc_lmap, errbuf, errbuf_sz) != 0)
+		{
+			pthreadRWLockUnlock(&gc_lmap->gcache_rwlock);
+			putGpuCacheLocalMapping(gc_lmap);
+			return NULL;
+		}
+	}
+	__gpucacheTouchDeviceBuffer(gc_lmap);
+	/* read-only replica on the device, if any */
+	replica_mask = gc_lmap->gc_sstate->gc_options.replica_mask;
+	if (cuda_dindex >= 0 && cuda_dindex < 64 &&
+		cuda_dindex != gc_lmap->gc_sstate->gc_options.cuda_dindex &&
+		(replica_mask & (1UL << cuda_dindex)) != 0)
+	{
+		if (gc_lmap->replicas)
+			replica = gc_lmap->replicas[cuda_dindex];
+		if (!replica || replica->gcache_main_devptr == 0UL)
+		{
+			if (!has_exclusive)
+			{
+				pthreadRWLockUnlock(&gc_lmap->gcache_rwlock);
+				has_exclusive = true;
+				pthreadRWLockWriteLock(&gc_lmap->gcache_rwlock);
+				goto retry;
+			}
+			replica = __gpucacheSetupReplica(gc_lmap, cuda_dindex,
+											 errbuf, errbuf_sz);
+			if (!replica)
+				fprintf(stderr, "gpucache: %s, use the primary buffer\n", errbuf);
+		}
+	}
+	if (replica)
+	{
+		pthreadRWLockReadLock(&replica->gcache_rwlock);
+		if (replica->gcache_main_devptr != 0UL)
+		{
+			pthreadRWLockUnlock(&gc_lmap->gcache_rwlock);
+			*p_gcache_main_devptr  = replica->gcache_main_devptr;
+			*p_gcache_extra_devptr = replica->gcache_extra_devptr;
+			return replica;
+		}
+		pthreadRWLockUnlock(&replica->gcache_rwlock);
+	}
+	/* ok, valid result */
+	*p_gcache_main_devptr  = gc_lmap->gcache_main_devptr;
+	*p_gcache_extra_devptr = gc_lmap->gcache_extra_devptr;
+	return gc_lmap;
+}
+
+/*
+ * gpuCachePutDeviceBuffer
+ */
+void
+gpuCachePutDeviceBuffer(void *__gc_lmap)
+{
+	GpuCacheLocalMapping *gc_lmap = (GpuCacheLocalMapping *)__gc_lmap;
+
+	pthreadRWLockUnlock(&gc_lmap->gcache_rwlock);
+	/* replica shares the reference counter of the primary */
+	putGpuCacheLocalMapping(gc_lmap->primary ? gc_lmap->primary : gc_lmap);
+}
+
+/* ------------------------------------------------------------
+ *
+ * pg_strom.gpucache_auto_preload configuration
+ *
+ * ------------------------------------------------------------
+ */
+typedef struct
+{
+	char   *database_name;
+	char   *schema_name;
+	char   *table_name;
+} GpuCacheAutoPreloadEntry;
+
+static GpuCacheAutoPreloadEntry *gpucache_auto_preload_entries = NULL;
+static int		gpucache_auto_preload_num_entries = 0;
+
+/*
+ * __gpuCacheAutoPreloadEntryComp
+ */
+static int
+__gpuCacheAutoPreloadEntryComp(const void *__x, const void *__y)
+{
+	const GpuCacheAutoPreloadEntry *x = __x;
+	const GpuCacheAutoPreloadEntry *y = __y;
+	int		comp;
+
+	comp = strcmp(x->database_name, y->database_name);
+	if (comp == 0)
+	{
+		comp = strcmp(x->schema_name, y->schema_name);
+		if (comp == 0)
+			comp = strcmp(x->table_name, y->table_name);
+	}
+	return comp;
+}
+
+/*
+ * __parseGpuCacheAutoPreload
+ */
+static void
+__parseGpuCacheAutoPreload(const char *__config)
+{
+	char	   *config;
+	char	   *token;
+	int			nitems = 0;
+	int			nrooms = 0;
+
+	config = alloca(strlen(__config) + 1);
+	strcpy(config, __config);
+	config = __trim(config);
+
+	/* special case - auto preloading */
+	if (strcmp(config, "*") == 0)
+		return;
+
+	for (token = strtok(config, ",");
+		 token != NULL;
+		 token = strtok(NULL,   ","))
+	{
+		GpuCacheAutoPreloadEntry *entry;
+		char   *database_name = __trim(token);
+		char   *schema_name;
+		char   *table_name;
+		char   *pos;
+
+		pos = strchr(database_name, '.');
+		if (!pos)
+			elog(ERROR, "pgstrom.gpucache_auto_preload syntax error [%s]",
+				 pgstrom_gpucache_auto_preload);
+		*pos++ = '\0';
+		schema_name = __trim(pos);
+
+		pos = strchr(schema_name, '.');
+		if (!pos)
+			elog(ERROR, "pgstrom.gpucache_auto_preload syntax error [%s]",
+				 pgstrom_gpucache_auto_preload);
+		*pos++ = '\0';
+		table_name = __trim(pos);
+
+		if (nitems >= nrooms)
+		{
+			nrooms = 2 * nrooms + 20;
+			gpucache_auto_preload_entries
+				= realloc(gpucache_auto_preload_entries,
+						  sizeof(GpuCacheAutoPreloadEntry) * nrooms);
+			if (!gpucache_auto_preload_entries)
+				elog(ERROR, "out of memory");
+		}
+		entry = &gpucache_auto_preload_entries[nitems++];
+		entry->database_name = strdup(database_name);
+		entry->schema_name = strdup(schema_name);
+		entry->table_name = strdup(table_name);
+		if (!entry->database_name ||
+			!entry->schema_name ||
+			!entry->table_name)
+			elog(ERROR, "out of memory");
+	}
+	gpucache_auto_preload_num_entries = nitems;
+
+	/* sort by database_name */
+	if (gpucache_auto_preload_num_entries > 0)
+	{
+		qsort(gpucache_auto_preload_entries,
+			  gpucache_auto_preload_num_entries,
+			  sizeof(GpuCacheAutoPreloadEntry),
+			  __gpuCacheAutoPreloadEntryComp);
+	}
+}
+
+/*
+ * __gpuCacheAutoPreloadConnectDatabaseAny
+ */
+static int
+__gpuCacheAutoPreloadConnectDatabaseAny(int32 *p_start, int32 *p_end)
+{
+	char	   *database_name;
+	Relation	srel;
+	SysScanDesc	sscan;
+    ScanKeyData	skey;
+	int			nkeys;
+	HeapTuple	tuple;
+	int			nitems = 0;
+	int			nrooms = 0;
+	int			exit_code = 1;	/* restart again */
+
+	if (gcache_shared_head->gcache_auto_preload_count++ == 0)
+	{
+		database_name = "template1";
+		nkeys = 0;
+	}
+	else
+	{
+		database_name = NameStr(gcache_shared_head->gcache_auto_preload_dbname);
+
+		ScanKeyInit(&skey,
+					Anum_pg_database_datname,
+					BTGreaterStrategyNumber, F_NAMEGT,
+					CStringGetDatum(database_name));
+		nkeys = 1;
+	}
+
+	PG_TRY();
+	{
+		BackgroundWorkerInitializeConnection(database_name, NULL, 0);
+	}
+	PG_CATCH();
+	{
+		ErrorData	   *edata;
+
+		MemoryContextSwitchTo(TopMemoryContext);
+		edata = CopyErrorData();
+
+		elog(LOG, "failed to connect database [%s], stop preloading - %s (%s:%d)",
+			 database_name,
+			 edata->message,
+			 edata->filename,
+			 edata->lineno);
+		proc_exit(0);	/* stop to restart bgworker any more */
+	}
+	PG_END_TRY();
+	StartTransactionCommand();
+	PushActiveSnapshot(GetTransactionSnapshot());
+	srel = table_open(DatabaseRelationId, AccessShareLock);
+	sscan = systable_beginscan(srel,
+							   DatabaseNameIndexId,
+							   true,
+							   NULL,
+							   nkeys, &skey);
+	while ((tuple = systable_getnext(sscan)) != NULL)
+	{
+		Form_pg_database dat = (Form_pg_database) GETSTRUCT(tuple);
+
+		if (!dat->datistemplate && dat->datallowconn)
+		{
+			/* save the next database */
+			memcpy(&gcache_shared_head->gcache_auto_preload_dbname,
+				   &dat->datname,
+				   sizeof(NameData));
+			break;
+		}
+	}
+	if (!HeapTupleIsValid(tuple))
+		exit_code = 0;	/* stop preloading */
+	systable_endscan(sscan);
+	table_close(srel, AccessShareLock);
+
+	/* build gpucache_auto_preload_entries on this database */
+	database_name = get_database_name(MyDatabaseId);
+	srel = table_open(RelationRelationId, AccessShareLock);
+	sscan = systable_beginscan(srel, InvalidOid, false, NULL, 0, NULL);
+	while ((tuple = systable_getnext(sscan)) != NULL)
+	{
+		GpuCacheAutoPreloadEntry *entry;
+		Form_pg_class	pg_class = (Form_pg_class) GETSTRUCT(tuple);
+		Oid				namespace_oid = pg_class->relnamespace;
+
+		if (namespace_oid == PG_CATALOG_NAMESPACE)
+			continue;
+		if (__gpuCacheTableSignatureSnapshot(tuple, NULL, NULL) == 0)
+			continue;
+
+		while (nitems >= nrooms)
+		{
+			nrooms = 2 * nrooms + 20;
+			gpucache_auto_preload_entries
+				= realloc(gpucache_auto_preload_entries,
+						  sizeof(GpuCacheAutoPreloadEntry) * nrooms);
+			if (!gpucache_auto_preload_entries)
+				elog(ERROR, "out of memory");
+		}
+		entry = &gpucache_auto_preload_entries[nitems++];
+        entry->database_name = strdup(database_name);
+		entry->schema_name = strdup(get_namespace_name(namespace_oid));
+		entry->table_name = strdup(NameStr(pg_class->relname));
+	}
+	gpucache_auto_preload_num_entries = nitems;
+
+	systable_endscan(sscan);
+	table_close(srel, AccessShareLock);
+
+	PopActiveSnapshot();
+	CommitTransactionCommand();
+	
+	*p_start = 0;
+	*p_end   = nitems;
+
+	return exit_code;
+}
+
+/*
+ * gpuCacheAutoPreloadDatabaseName
+ */
+static int
+gpuCacheAutoPreloadConnectDatabase(int32 *p_start, int32 *p_end)
+{
+	GpuCacheAutoPreloadEntry *entry;
+	const char *database_name;
+	int32		start;
+	int32		curr;
+
+	if (!gpucache_auto_preload_entries)
+		return __gpuCacheAutoPreloadConnectDatabaseAny(p_start, p_end);
+
+	start = curr = gcache_shared_head->gcache_auto_preload_count;
+	if (start >= gpucache_auto_preload_num_entries)
+		proc_exit(0);	/* no more preloading */
+
+	database_name = gpucache_auto_preload_entries[start].database_name;
+	while (curr < gpucache_auto_preload_num_entries)
+	{
+		entry = &gpucache_auto_preload_entries[curr];
+
+		if (strcmp(database_name, entry->database_name) != 0)
+			break;
+	}
+	gcache_shared_head->gcache_auto_preload_count = curr;
+
+	BackgroundWorkerInitializeConnection(database_name, NULL, 0);
+
+	*p_start = start;
+	*p_end   = curr;
+
+	return (curr >= gpucache_auto_preload_num_entries ? 0 : 1);
+}
+
+/*
+ * gpuCacheStartupPreloader
+ */
+void
+gpuCacheStartupPreloader(Datum arg)
+{
+	int32		start;
+	int32		end;
+	int32		index;
+	int			exit_code;
+
+	BackgroundWorkerUnblockSignals();
+
+	exit_code = gpuCacheAutoPreloadConnectDatabase(&start, &end);
+	StartTransactionCommand();
+	GetCurrentTransactionId();
+	for (index=start; index < end; index++)
+	{
+		GpuCacheAutoPreloadEntry *entry = &gpucache_auto_preload_entries[index];
+		GpuCacheDesc   *gc_desc;
+		RangeVar		rvar;
+		Relation		rel;
+
+		memset(&rvar, 0, sizeof(RangeVar));
+		rvar.type = T_RangeVar;
+		rvar.schemaname = entry->schema_name;
+		rvar.relname = entry->table_name;
+
+		rel = table_openrv(&rvar, AccessShareLock);
+		gc_desc = lookupGpuCacheDesc(rel);
+		initialLoadGpuCache(gc_desc, rel);
+		table_close(rel, NoLock);
+
+		elog(LOG, "gpucache: auto preload '%s.%s' (DB: %s)",
+			 entry->schema_name,
+			 entry->table_name,
+			 entry->database_name);
+	}
+	CommitTransactionCommand();
+
+	proc_exit(exit_code);
+}
+
+/* ------------------------------------------------------------
+ *
+ * GpuCache WAL Sync worker
+ *
+ * GpuCache configured with 'sync_mode=wal' is not synchronized by the row
+ * triggers. Instead, a background worker per database reads the WAL records
+ * through a temporary physical replication slot, then writes out the REDO
+ * logs on behalf of the transactions, so row-level DML does not pay the cost
+ * of GpuCache maintenance. In exchange, GpuCache becomes eventually
+ * consistent; committed changes get visible a little later.
+ * Because the worker cannot see the WAL records prior to its startup,
+ * these GpuCaches are reset and rebuilt by the worker itself at the startup.
+ *
+ * ------------------------------------------------------------
+ */
+#define GCACHE_WALSYNC_BATCH_NRECORDS	10000
+#define GCACHE_WALSYNC_NAPTIME			100L	/* 100ms */
+#define GCACHE_WALSYNC_SCAN_INTERVAL	10000	/* 10sec */
+
+typedef struct
+{
+	GpuCacheIdent	ident;
+	uint32_t		nitems;
+	StringInfoData	buf;		/* array of PendingCtidItem */
+} GpuCacheWalSyncTable;
+
+typedef struct
+{
+	TransactionId	xid;		/* hash key */
+	List		   *tables;		/* list of GpuCacheWalSyncTable */
+} GpuCacheWalSyncXact;
+
+/*
+ * __gpuCacheWalSyncSetupDesc
+ *
+ * GpuCacheDesc is per-transaction state of the backend. WAL sync worker
+ * writes out REDO logs on behalf of other transactions, so it uses
+ * a temporary descriptor that is not registered to the hash table.
+ */
+static void
+__gpuCacheWalSyncSetupDesc(GpuCacheDesc *gc_desc,
+						   GpuCacheLocalMapping *gc_lmap)
+{
+	memset(gc_desc, 0, sizeof(GpuCacheDesc));
+	memcpy(&gc_desc->ident, &gc_lmap->ident, sizeof(GpuCacheIdent));
+	gc_desc->xid = InvalidTransactionId;
+	memcpy(&gc_desc->gc_options, &gc_lmap->gc_sstate->gc_options,
+		   sizeof(GpuCacheOptions));
+	gc_desc->gc_lmap = gc_lmap;
+}
+
+/*
+ * __gpuCacheWalSyncWaitForRunningXacts
+ *
+ * Initial loading by the WAL sync worker must wait for completion of the
+ * concurrent transactions, because their WAL records may be already consumed
+ * prior to the GpuCache construction.
+ */
+static void
+__gpuCacheWalSyncWaitForRunningXacts(void)
+{
+	Snapshot	snapshot = GetLatestSnapshot();
+	TransactionId *xids;
+	uint32		nxids = snapshot->xcnt;
+
+	xids = palloc(sizeof(TransactionId) * (nxids + 1));
+	memcpy(xids, snapshot->xip, sizeof(TransactionId) * nxids);
+	for (uint32 i=0; i < nxids; i++)
 	{
-		cmd = dlist_container(GpuCacheControlCommand, chain,
-							  dlist_pop_head_node(cmd_queue));
-		dlist_delete(&cmd->chain);
-		memset(&cmd->chain, 0, sizeof(dlist_node));
-		snprintf(cmd->errbuf, sizeof(cmd->errbuf),
-				 "GpuService is now shutting down...");
-		cmd->errcode = EBUSY;
-		if (cmd->backend)
-			SetLatch(cmd->backend);
-		else
-			dlist_push_head(&gcache_shared_head->gcache_free_cmds, &cmd->chain);
+		if (!TransactionIdIsCurrentTransactionId(xids[i]))
+			XactLockTableWait(xids[i], NULL, NULL, XLTW_None);
 	}
-	pthreadMutexUnlock(cmd_mutex);
+	pfree(xids);
 }
 
 /*
- * gpucacheManagerWakeUp
+ * __gpuCacheWalSyncLoad
  */
-void
-gpucacheManagerWakeUp(int cuda_dindex)
+static void
+__gpuCacheWalSyncLoad(Relation rel)
 {
-	if (cuda_dindex >= 0 && cuda_dindex < numGpuDevAttrs)
+	GpuCacheDesc   *gc_desc;
+
+	__gpuCacheWalSyncWaitForRunningXacts();
+	gc_desc = lookupGpuCacheDesc(rel);
+	if (gc_desc && initialLoadGpuCache(gc_desc, rel))
+		elog(LOG, "gpucache: '%s' is loaded by WAL sync worker (nitems=%lu)",
+			 RelationGetRelationName(rel),
+			 pg_atomic_read_u64(&gc_desc->gc_lmap->gc_sstate->gcache_main_nitems));
+}
+
+/*
+ * __gpuCacheWalSyncResetCache
+ */
+static void
+__gpuCacheWalSyncResetCache(GpuCacheDesc *gc_desc)
+{
+	GpuCacheSharedState *gc_sstate = gc_desc->gc_lmap->gc_sstate;
+	uint32_t	phase;
+
+	if (pg_atomic_read_u32(&gc_sstate->phase) == GCACHE_PHASE__IS_EMPTY)
+		return;
+	/* any backends shall not use the outdated GpuCache no longer */
+	pg_atomic_write_u32(&gc_sstate->phase, GCACHE_PHASE__IS_CORRUPTED);
+	gpuCacheInvokeDropUnload(gc_desc, false);
+	phase = GCACHE_PHASE__IS_CORRUPTED;
+	if (pg_atomic_compare_exchange_u32(&gc_sstate->phase,
+									   &phase, UINT_MAX))
+		__resetGpuCacheSharedState(gc_sstate);
+}
+
+/*
+ * __gpuCacheWalSyncScanTables
+ *
+ * It walks on the tables with sync_mode=wal in this database, then builds
+ * GpuCache if not loaded yet. If 'reset_caches', existing GpuCache is reset
+ * prior to the loading.
+ */
+static void
+__gpuCacheWalSyncScanTables(bool reset_caches)
+{
+	Oid			tgfoid = gpucache_sync_trigger_function_oid();
+	Relation	trig_rel;
+	SysScanDesc	sscan;
+	HeapTuple	tuple;
+	List	   *relids = NIL;
+	ListCell   *lc;
+
+	if (!OidIsValid(tgfoid))
+		return;		/* pg_strom is not installed */
+
+	trig_rel = table_open(TriggerRelationId, AccessShareLock);
+	sscan = systable_beginscan(trig_rel, InvalidOid, false, NULL, 0, NULL);
+	while (HeapTupleIsValid(tuple = systable_getnext(sscan)))
 	{
-		pthreadCondBroadcast(&gcache_shared_head->gpus[cuda_dindex].cond);
+		Form_pg_trigger	tgform = (Form_pg_trigger) GETSTRUCT(tuple);
+
+		if (tgform->tgfoid == tgfoid)
+			relids = list_append_unique_oid(relids, tgform->tgrelid);
 	}
-	else
+	systable_endscan(sscan);
+	table_close(trig_rel, AccessShareLock);
+
+	foreach (lc, relids)
 	{
-		/* wakeup all */
-		for (int i=0; i < cuda_dindex; i++)
-			pthreadCondBroadcast(&gcache_shared_head->gpus[i].cond);
+		Oid			table_oid = lfirst_oid(lc);
+		GpuCacheOptions gc_options;
+		GpuCacheLocalMapping *gc_lmap;
+		uint32_t	phase = GCACHE_PHASE__IS_EMPTY;
+		uint64_t	signature;
+		Relation	rel;
+
+		rel = try_table_open(table_oid, AccessShareLock);
+		if (!rel)
+			continue;
+		signature = gpuCacheTableSignature(rel, &gc_options);
+		if (signature != 0 &&
+			gc_options.sync_mode == GCACHE_SYNC_MODE__WAL)
+		{
+			gc_lmap = getGpuCacheLocalMappingIfExist(MyDatabaseId,
+													 table_oid,
+													 signature);
+			if (gc_lmap)
+			{
+				if (reset_caches)
+				{
+					GpuCacheDesc	gc_temp;
+
+					__gpuCacheWalSyncSetupDesc(&gc_temp, gc_lmap);
+					__gpuCacheWalSyncResetCache(&gc_temp);
+				}
+				phase = pg_atomic_read_u32(&gc_lmap->gc_sstate->phase);
+				putGpuCacheLocalMapping(gc_lmap);
+			}
+			if (phase == GCACHE_PHASE__IS_EMPTY)
+				__gpuCacheWalSyncLoad(rel);
+		}
+		table_close(rel, AccessShareLock);
 	}
+	list_free(relids);
 }
 
 /*
- * gpuCacheGetDeviceBuffer
+ * __gpuCacheWalSyncOpenRelation
+ *
+ * It opens the relation of the WAL record, if it is GpuCache with
+ * sync_mode=wal and ready to apply the changes.
  */
-void *
-gpuCacheGetDeviceBuffer(const GpuCacheIdent *ident,
-						CUdeviceptr *p_gcache_main_devptr,
-						CUdeviceptr *p_gcache_extra_devptr,
-						char *errbuf, size_t errbuf_sz)
+static Relation
+__gpuCacheWalSyncOpenRelation(XLogReaderState *record,
+							  BlockNumber *p_blkno,
+							  GpuCacheDesc *gc_desc)
 {
+	RelFileLocator	rlocator;
+	ForkNumber		forknum;
+	BlockNumber		blkno;
+	GpuCacheOptions	gc_options;
 	GpuCacheLocalMapping *gc_lmap;
-	bool		has_exclusive = false;
+	uint64_t		signature;
+	Oid				table_oid;
+	Relation		rel;
 
-	gc_lmap = getGpuCacheLocalMappingIfExist(ident->database_oid,
-											 ident->table_oid,
-											 ident->signature);
-	if (!gc_lmap)
+	if (!XLogRecGetBlockTagExtended(record, 0,
+									&rlocator, &forknum, &blkno, NULL) ||
+		forknum != MAIN_FORKNUM ||
+		RelFileLocatorDbOid(rlocator) != MyDatabaseId)
 		return NULL;
-	pthreadRWLockReadLock(&gc_lmap->gcache_rwlock);
-retry:
-	if (gc_lmap->gcache_main_devptr == 0UL)
+	table_oid = RelidByRelfilenumber(RelFileLocatorSpcOid(rlocator),
+									 RelFileLocatorRelNumber(rlocator));
+	if (!OidIsValid(table_oid))
+		return NULL;
+	/* quick check without locks, because most of tables have no GpuCache */
+	rel = RelationIdGetRelation(table_oid);
+	if (!RelationIsValid(rel))
+		return NULL;
+	signature = gpuCacheTableSignature(rel, &gc_options);
+	RelationClose(rel);
+	if (signature == 0 || gc_options.sync_mode != GCACHE_SYNC_MODE__WAL)
+		return NULL;
+
+	rel = try_table_open(table_oid, AccessShareLock);
+	if (!rel)
+		return NULL;
+	signature = gpuCacheTableSignature(rel, &gc_options);
+	if (signature == 0 || gc_options.sync_mode != GCACHE_SYNC_MODE__WAL)
+		goto skip;
+	gc_lmap = getGpuCacheLocalMappingIfExist(MyDatabaseId,
+											 table_oid,
+											 signature);
+	if (!gc_lmap ||
+		pg_atomic_read_u32(&gc_lmap->gc_sstate->phase) == GCACHE_PHASE__IS_EMPTY)
 	{
-		if (!has_exclusive)
-		{
-			pthreadRWLockUnlock(&gc_lmap->gcache_rwlock);
-			has_exclusive = true;
-			pthreadRWLockWriteLock(&gc_lmap->gcache_rwlock);
-			goto retry;
-		}
-		if (__gpucacheAllocDeviceMemory(gc_lmap,
-										errbuf, errbuf_sz) != 0)
-		{
-			pthreadRWLockUnlock(&gc_lmap->gcache_rwlock);
+		if (gc_lmap)
 			putGpuCacheLocalMapping(gc_lmap);
-			return NULL;
-		}
+		__gpuCacheWalSyncLoad(rel);
+		gc_lmap = getGpuCacheLocalMappingIfExist(MyDatabaseId,
+												 table_oid,
+												 signature);
+		if (!gc_lmap)
+			goto skip;
 	}
-	/* ok, valid result */
-	*p_gcache_main_devptr  = gc_lmap->gcache_main_devptr;
-	*p_gcache_extra_devptr = gc_lmap->gcache_extra_devptr;
-	return gc_lmap;
+	if (pg_atomic_read_u32(&gc_lmap->gc_sstate->phase) != GCACHE_PHASE__IS_READY)
+	{
+		putGpuCacheLocalMapping(gc_lmap);
+		goto skip;
+	}
+	__gpuCacheWalSyncSetupDesc(gc_desc, gc_lmap);
+	*p_blkno = blkno;
+
+	return rel;
+
+skip:
+	table_close(rel, AccessShareLock);
+	return NULL;
 }
 
 /*
- * gpuCachePutDeviceBuffer
+ * __gpuCacheWalSyncCloseRelation
  */
-void
-gpuCachePutDeviceBuffer(void *__gc_lmap)
+static void
+__gpuCacheWalSyncCloseRelation(Relation rel, GpuCacheDesc *gc_desc)
 {
-	GpuCacheLocalMapping *gc_lmap = (GpuCacheLocalMapping *)__gc_lmap;
+	putGpuCacheLocalMapping(gc_desc->gc_lmap);
+	table_close(rel, AccessShareLock);
+}
 
-	pthreadRWLockUnlock(&gc_lmap->gcache_rwlock);
-	putGpuCacheLocalMapping(gc_lmap);
+/*
+ * __gpuCacheWalSyncCorrupted
+ */
+static void
+__gpuCacheWalSyncCorrupted(Relation rel, GpuCacheDesc *gc_desc,
+						   const char *reason)
+{
+	GpuCacheSharedState *gc_sstate = gc_desc->gc_lmap->gc_sstate;
+
+	if (pg_atomic_exchange_u32(&gc_sstate->phase,
+							   GCACHE_PHASE__IS_CORRUPTED) != GCACHE_PHASE__IS_CORRUPTED)
+		elog(WARNING, "gpucache: %s on '%s', so it is now switched to 'corrupted' state",
+			 reason, RelationGetRelationName(rel));
+	__gpuCacheInvalidateSnapshot(gc_sstate);
 }
 
-/* ------------------------------------------------------------
- *
- * pg_strom.gpucache_auto_preload configuration
+/*
+ * __gpuCacheWalSyncMakeTuple
  *
- * ------------------------------------------------------------
+ * It reconstructs HeapTuple from xl_heap_header and the tuple body in WAL,
+ * like DecodeXLogTuple doing.
  */
-typedef struct
+static HeapTuple
+__gpuCacheWalSyncMakeTuple(Relation rel,
+						   BlockNumber blkno, OffsetNumber offnum,
+						   uint16 t_infomask2, uint16 t_infomask, uint8 t_hoff,
+						   const char *data, Size datalen)
 {
-	char   *database_name;
-	char   *schema_name;
-	char   *table_name;
-} GpuCacheAutoPreloadEntry;
+	HeapTuple		tuple;
+	HeapTupleHeader	htup;
+
+	tuple = palloc0(HEAPTUPLESIZE + SizeofHeapTupleHeader + datalen);
+	tuple->t_len = SizeofHeapTupleHeader + datalen;
+	ItemPointerSet(&tuple->t_self, blkno, offnum);
+	tuple->t_tableOid = RelationGetRelid(rel);
+	tuple->t_data = htup = (HeapTupleHeader)((char *)tuple + HEAPTUPLESIZE);
+	htup->t_infomask2 = t_infomask2;
+	htup->t_infomask  = t_infomask;
+	htup->t_hoff      = t_hoff;
+	memcpy((char *)htup + SizeofHeapTupleHeader, data, datalen);
 
-static GpuCacheAutoPreloadEntry *gpucache_auto_preload_entries = NULL;
-static int		gpucache_auto_preload_num_entries = 0;
+	return tuple;
+}
+
+static HeapTuple
+__gpuCacheWalSyncDecodeTuple(Relation rel,
+							 BlockNumber blkno, OffsetNumber offnum,
+							 const char *data, Size len)
+{
+	xl_heap_header	xlhdr;
+
+	if (len < SizeOfHeapHeader)
+		return NULL;
+	memcpy(&xlhdr, data, SizeOfHeapHeader);
+	return __gpuCacheWalSyncMakeTuple(rel, blkno, offnum,
+									  xlhdr.t_infomask2,
+									  xlhdr.t_infomask,
+									  xlhdr.t_hoff,
+									  data + SizeOfHeapHeader,
+									  len - SizeOfHeapHeader);
+}
 
 /*
- * __gpuCacheAutoPreloadEntryComp
+ * __gpuCacheWalSyncTrackItem
  */
-static int
-__gpuCacheAutoPreloadEntryComp(const void *__x, const void *__y)
+static void
+__gpuCacheWalSyncTrackItem(GpuCacheDesc *gc_desc, TransactionId xid,
+						   uint32_t rowid, char tag, ItemPointer ctid)
 {
-	const GpuCacheAutoPreloadEntry *x = __x;
-	const GpuCacheAutoPreloadEntry *y = __y;
-	int		comp;
+	GpuCacheWalSyncXact *wxact;
+	GpuCacheWalSyncTable *wtable = NULL;
+	PendingCtidItem	pitem;
+	MemoryContext	oldcxt;
+	ListCell	   *lc;
+	bool			found;
 
-	comp = strcmp(x->database_name, y->database_name);
-	if (comp == 0)
+	wxact = hash_search(gcache_walsync_xacts_htab,
+						&xid, HASH_ENTER, &found);
+	if (!found)
+		wxact->tables = NIL;
+	foreach (lc, wxact->tables)
 	{
-		comp = strcmp(x->schema_name, y->schema_name);
-		if (comp == 0)
-			comp = strcmp(x->table_name, y->table_name);
+		GpuCacheWalSyncTable *temp = lfirst(lc);
+
+		if (GpuCacheIdentEqual(&temp->ident, &gc_desc->ident))
+		{
+			wtable = temp;
+			break;
+		}
 	}
-	return comp;
+	oldcxt = MemoryContextSwitchTo(TopMemoryContext);
+	if (!wtable)
+	{
+		wtable = palloc0(sizeof(GpuCacheWalSyncTable));
+		memcpy(&wtable->ident, &gc_desc->ident, sizeof(GpuCacheIdent));
+		initStringInfo(&wtable->buf);
+		wxact->tables = lappend(wxact->tables, wtable);
+	}
+	pitem.rowid = rowid;
+	pitem.tag = tag;
+	ItemPointerCopy(ctid, &pitem.ctid);
+	appendBinaryStringInfo(&wtable->buf, (char *)&pitem,
+						   sizeof(PendingCtidItem));
+	wtable->nitems++;
+	MemoryContextSwitchTo(oldcxt);
 }
 
 /*
- * __parseGpuCacheAutoPreload
+ * __gpuCacheWalSyncInsert
  */
 static void
-__parseGpuCacheAutoPreload(const char *__config)
+__gpuCacheWalSyncInsert(GpuCacheDesc *gc_desc, Relation rel,
+						TransactionId xid, HeapTuple tuple)
 {
-	char	   *config;
-	char	   *token;
-	int			nitems = 0;
-	int			nrooms = 0;
-
-	config = alloca(strlen(__config) + 1);
-	strcpy(config, __config);
-	config = __trim(config);
+	HeapTuple	htup = tuple;
+	uint32_t	rowid;
 
-	/* special case - auto preloading */
-	if (strcmp(config, "*") == 0)
+	/* already loaded by the initial loading */
+	if (__findGpuCacheRowId(gc_desc->gc_lmap, &tuple->t_self) != UINT_MAX)
 		return;
-
-	for (token = strtok(config, ",");
-		 token != NULL;
-		 token = strtok(NULL,   ","))
+	if (HeapTupleHasExternal(tuple))
 	{
-		GpuCacheAutoPreloadEntry *entry;
-		char   *database_name = __trim(token);
-		char   *schema_name;
-		char   *table_name;
-		char   *pos;
-
-		pos = strchr(database_name, '.');
-		if (!pos)
-			elog(ERROR, "pgstrom.gpucache_auto_preload syntax error [%s]",
-				 pgstrom_gpucache_auto_preload);
-		*pos++ = '\0';
-		schema_name = __trim(pos);
-
-		pos = strchr(schema_name, '.');
-		if (!pos)
-			elog(ERROR, "pgstrom.gpucache_auto_preload syntax error [%s]",
-				 pgstrom_gpucache_auto_preload);
-		*pos++ = '\0';
-		table_name = __trim(pos);
+		MemoryContext	memcxt = CurrentMemoryContext;
+		ResourceOwner	owner = CurrentResourceOwner;
 
-		if (nitems >= nrooms)
+		/*
+		 * Toast values might be already removed, if the tuple was deleted
+		 * and vacuumed later. It is harmless to skip the tuple at that case,
+		 * because the WAL records to delete the tuple will come later.
+		 */
+		BeginInternalSubTransaction(NULL);
+		MemoryContextSwitchTo(memcxt);
+		PG_TRY();
 		{
-			nrooms = 2 * nrooms + 20;
-			gpucache_auto_preload_entries
-				= realloc(gpucache_auto_preload_entries,
-						  sizeof(GpuCacheAutoPreloadEntry) * nrooms);
-			if (!gpucache_auto_preload_entries)
-				elog(ERROR, "out of memory");
+			htup = __makeFlattenHeapTuple(rel, tuple);
+			ReleaseCurrentSubTransaction();
+			MemoryContextSwitchTo(memcxt);
+			CurrentResourceOwner = owner;
 		}
-		entry = &gpucache_auto_preload_entries[nitems++];
-		entry->database_name = strdup(database_name);
-		entry->schema_name = strdup(schema_name);
-		entry->table_name = strdup(table_name);
-		if (!entry->database_name ||
-			!entry->schema_name ||
-			!entry->table_name)
-			elog(ERROR, "out of memory");
+		PG_CATCH();
+		{
+			ErrorData  *edata;
+
+			MemoryContextSwitchTo(memcxt);
+			edata = CopyErrorData();
+			FlushErrorState();
+			RollbackAndReleaseCurrentSubTransaction();
+			MemoryContextSwitchTo(memcxt);
+			CurrentResourceOwner = owner;
+			if (edata->sqlerrcode == ERRCODE_QUERY_CANCELED)
+				ReThrowError(edata);
+			elog(DEBUG1, "gpucache: unable to flatten ctid(%u,%u) of '%s', skipped: %s",
+				 ItemPointerGetBlockNumber(&tuple->t_self),
+				 ItemPointerGetOffsetNumber(&tuple->t_self),
+				 RelationGetRelationName(rel),
+				 edata->message);
+			FreeErrorData(edata);
+			return;
+		}
+		PG_END_TRY();
 	}
-	gpucache_auto_preload_num_entries = nitems;
-
-	/* sort by database_name */
-	if (gpucache_auto_preload_num_entries > 0)
+	rowid = __allocGpuCacheRowId(gc_desc->gc_lmap, &htup->t_self);
+	if (rowid != UINT_MAX)
 	{
-		qsort(gpucache_auto_preload_entries,
-			  gpucache_auto_preload_num_entries,
-			  sizeof(GpuCacheAutoPreloadEntry),
-			  __gpuCacheAutoPreloadEntryComp);
+		__gpuCacheWalSyncTrackItem(gc_desc, xid, rowid, 'I', &htup->t_self);
+		__gpuCacheWriteInsertLog(gc_desc, htup, rowid, xid);
 	}
+	if (htup != tuple)
+		pfree(htup);
+}
+
+/*
+ * __gpuCacheWalSyncDelete
+ */
+static void
+__gpuCacheWalSyncDelete(GpuCacheDesc *gc_desc,
+						TransactionId xid, ItemPointer ctid)
+{
+	uint32_t	rowid;
+
+	/* not loaded, because the deletion was already committed */
+	rowid = __findGpuCacheRowId(gc_desc->gc_lmap, ctid);
+	if (rowid == UINT_MAX)
+		return;
+	__gpuCacheWalSyncTrackItem(gc_desc, xid, rowid, 'D', ctid);
+	__gpuCacheWriteDeleteLog(gc_desc, ctid, rowid, xid);
 }
 
 /*
- * __gpuCacheAutoPreloadConnectDatabaseAny
+ * __gpuCacheWalSyncHeapRecord
  */
-static int
-__gpuCacheAutoPreloadConnectDatabaseAny(int32 *p_start, int32 *p_end)
+static void
+__gpuCacheWalSyncHeapRecord(XLogReaderState *record)
 {
-	char	   *database_name;
-	Relation	srel;
-	SysScanDesc	sscan;
-    ScanKeyData	skey;
-	int			nkeys;
+	uint8		info = (XLogRecGetInfo(record) & XLOG_HEAP_OPMASK);
+	TransactionId xid = XLogRecGetXid(record);
+	GpuCacheDesc gc_temp;
+	Relation	rel;
+	BlockNumber	blkno;
 	HeapTuple	tuple;
-	int			nitems = 0;
-	int			nrooms = 0;
-	int			exit_code = 1;	/* restart again */
-
-	if (gcache_shared_head->gcache_auto_preload_count++ == 0)
-	{
-		database_name = "template1";
-		nkeys = 0;
+	ItemPointerData	ctid;
+	char	   *data;
+	Size		datalen;
+
+	if (info == XLOG_HEAP_INSERT)
+	{
+		xl_heap_insert *xlrec = (xl_heap_insert *)XLogRecGetData(record);
+
+		if ((xlrec->flags & XLH_INSERT_CONTAINS_NEW_TUPLE) == 0)
+			return;
+		rel = __gpuCacheWalSyncOpenRelation(record, &blkno, &gc_temp);
+		if (!rel)
+			return;
+		data = XLogRecGetBlockData(record, 0, &datalen);
+		tuple = __gpuCacheWalSyncDecodeTuple(rel, blkno, xlrec->offnum,
+											 data, datalen);
+		if (tuple)
+		{
+			__gpuCacheWalSyncInsert(&gc_temp, rel, xid, tuple);
+			pfree(tuple);
+		}
+		else
+			__gpuCacheWalSyncCorrupted(rel, &gc_temp, "broken INSERT record");
+		__gpuCacheWalSyncCloseRelation(rel, &gc_temp);
 	}
-	else
+	else if (info == XLOG_HEAP_DELETE)
 	{
-		database_name = NameStr(gcache_shared_head->gcache_auto_preload_dbname);
-
-		ScanKeyInit(&skey,
-					Anum_pg_database_datname,
-					BTGreaterStrategyNumber, F_NAMEGT,
-					CStringGetDatum(database_name));
-		nkeys = 1;
-	}
+		xl_heap_delete *xlrec = (xl_heap_delete *)XLogRecGetData(record);
 
-	PG_TRY();
-	{
-		BackgroundWorkerInitializeConnection(database_name, NULL, 0);
+		rel = __gpuCacheWalSyncOpenRelation(record, &blkno, &gc_temp);
+		if (!rel)
+			return;
+		ItemPointerSet(&ctid, blkno, xlrec->offnum);
+		__gpuCacheWalSyncDelete(&gc_temp, xid, &ctid);
+		__gpuCacheWalSyncCloseRelation(rel, &gc_temp);
 	}
-	PG_CATCH();
+	else if (info == XLOG_HEAP_UPDATE ||
+			 info == XLOG_HEAP_HOT_UPDATE)
 	{
-		ErrorData	   *edata;
+		xl_heap_update *xlrec = (xl_heap_update *)XLogRecGetData(record);
+		BlockNumber	old_blkno;
 
-		MemoryContextSwitchTo(TopMemoryContext);
-		edata = CopyErrorData();
+		rel = __gpuCacheWalSyncOpenRelation(record, &blkno, &gc_temp);
+		if (!rel)
+			return;
+		/* block-1 is the old page, if not identical with the new one */
+		if (!XLogRecGetBlockTagExtended(record, 1, NULL, NULL,
+										&old_blkno, NULL))
+			old_blkno = blkno;
+		ItemPointerSet(&ctid, old_blkno, xlrec->old_offnum);
+		__gpuCacheWalSyncDelete(&gc_temp, xid, &ctid);
 
-		elog(LOG, "failed to connect database [%s], stop preloading - %s (%s:%d)",
-			 database_name,
-			 edata->message,
-			 edata->filename,
-			 edata->lineno);
-		proc_exit(0);	/* stop to restart bgworker any more */
+		/*
+		 * prefix/suffix compression is never used when wal_level=logical,
+		 * so the new tuple should be logged as is.
+		 */
+		tuple = NULL;
+		if ((xlrec->flags & XLH_UPDATE_CONTAINS_NEW_TUPLE) != 0 &&
+			(xlrec->flags & (XLH_UPDATE_PREFIX_FROM_OLD |
+							 XLH_UPDATE_SUFFIX_FROM_OLD)) == 0)
+		{
+			data = XLogRecGetBlockData(record, 0, &datalen);
+			tuple = __gpuCacheWalSyncDecodeTuple(rel, blkno,
+												 xlrec->new_offnum,
+												 data, datalen);
+		}
+		if (tuple)
+		{
+			__gpuCacheWalSyncInsert(&gc_temp, rel, xid, tuple);
+			pfree(tuple);
+		}
+		else
+			__gpuCacheWalSyncCorrupted(rel, &gc_temp, "UPDATE record without new tuple");
+		__gpuCacheWalSyncCloseRelation(rel, &gc_temp);
 	}
-	PG_END_TRY();
-	StartTransactionCommand();
-	PushActiveSnapshot(GetTransactionSnapshot());
-	srel = table_open(DatabaseRelationId, AccessShareLock);
-	sscan = systable_beginscan(srel,
-							   DatabaseNameIndexId,
-							   true,
-							   NULL,
-							   nkeys, &skey);
-	while ((tuple = systable_getnext(sscan)) != NULL)
+}
+
+/*
+ * __gpuCacheWalSyncMultiInsert
+ */
+static void
+__gpuCacheWalSyncMultiInsert(XLogReaderState *record)
+{
+	xl_heap_multi_insert *xlrec = (xl_heap_multi_insert *)XLogRecGetData(record);
+	bool		isinit = ((XLogRecGetInfo(record) & XLOG_HEAP_INIT_PAGE) != 0);
+	TransactionId xid = XLogRecGetXid(record);
+	GpuCacheDesc gc_temp;
+	Relation	rel;
+	BlockNumber	blkno;
+	char	   *data;
+	char	   *tail;
+	Size		datalen;
+
+	if ((xlrec->flags & XLH_INSERT_CONTAINS_NEW_TUPLE) == 0)
+		return;
+	rel = __gpuCacheWalSyncOpenRelation(record, &blkno, &gc_temp);
+	if (!rel)
+		return;
+	data = XLogRecGetBlockData(record, 0, &datalen);
+	tail = data + datalen;
+	for (int i=0; i < xlrec->ntuples; i++)
 	{
-		Form_pg_database dat = (Form_pg_database) GETSTRUCT(tuple);
+		xl_multi_insert_tuple *xlhdr;
+		OffsetNumber	offnum;
+		HeapTuple		tuple;
 
-		if (!dat->datistemplate && dat->datallowconn)
+		xlhdr = (xl_multi_insert_tuple *)SHORTALIGN(data);
+		data = (char *)xlhdr + SizeOfMultiInsertTuple;
+		if (data + xlhdr->datalen > tail)
 		{
-			/* save the next database */
-			memcpy(&gcache_shared_head->gcache_auto_preload_dbname,
-				   &dat->datname,
-				   sizeof(NameData));
+			__gpuCacheWalSyncCorrupted(rel, &gc_temp, "broken MULTI_INSERT record");
 			break;
 		}
-	}
-	if (!HeapTupleIsValid(tuple))
-		exit_code = 0;	/* stop preloading */
-	systable_endscan(sscan);
-	table_close(srel, AccessShareLock);
+		offnum = (isinit ? FirstOffsetNumber + i : xlrec->offsets[i]);
+		tuple = __gpuCacheWalSyncMakeTuple(rel, blkno, offnum,
+										   xlhdr->t_infomask2,
+										   xlhdr->t_infomask,
+										   xlhdr->t_hoff,
+										   data, xlhdr->datalen);
+		__gpuCacheWalSyncInsert(&gc_temp, rel, xid, tuple);
+		pfree(tuple);
+		data += xlhdr->datalen;
+	}
+	__gpuCacheWalSyncCloseRelation(rel, &gc_temp);
+}
 
-	/* build gpucache_auto_preload_entries on this database */
-	database_name = get_database_name(MyDatabaseId);
-	srel = table_open(RelationRelationId, AccessShareLock);
-	sscan = systable_beginscan(srel, InvalidOid, false, NULL, 0, NULL);
-	while ((tuple = systable_getnext(sscan)) != NULL)
-	{
-		GpuCacheAutoPreloadEntry *entry;
-		Form_pg_class	pg_class = (Form_pg_class) GETSTRUCT(tuple);
-		Oid				namespace_oid = pg_class->relnamespace;
+/*
+ * __gpuCacheWalSyncXactEnd
+ */
+static void
+__gpuCacheWalSyncXactEnd(TransactionId xid, bool normal_commit)
+{
+	GpuCacheWalSyncXact *wxact;
+	ListCell   *lc;
 
-		if (namespace_oid == PG_CATALOG_NAMESPACE)
-			continue;
-		if (__gpuCacheTableSignatureSnapshot(tuple, NULL, NULL) == 0)
-			continue;
+	wxact = hash_search(gcache_walsync_xacts_htab,
+						&xid, HASH_FIND, NULL);
+	if (!wxact)
+		return;
+	foreach (lc, wxact->tables)
+	{
+		GpuCacheWalSyncTable *wtable = lfirst(lc);
+		GpuCacheLocalMapping *gc_lmap;
 
-		while (nitems >= nrooms)
+		gc_lmap = getGpuCacheLocalMappingIfExist(wtable->ident.database_oid,
+												 wtable->ident.table_oid,
+												 wtable->ident.signature);
+		if (gc_lmap)
 		{
-			nrooms = 2 * nrooms + 20;
-			gpucache_auto_preload_entries
-				= realloc(gpucache_auto_preload_entries,
-						  sizeof(GpuCacheAutoPreloadEntry) * nrooms);
-			if (!gpucache_auto_preload_entries)
-				elog(ERROR, "out of memory");
+			GpuCacheDesc	gc_temp;
+
+			if (pg_atomic_read_u32(&gc_lmap->gc_sstate->phase) == GCACHE_PHASE__IS_READY)
+			{
+				__gpuCacheWalSyncSetupDesc(&gc_temp, gc_lmap);
+				__gpuCacheWriteXactLogs(&gc_temp,
+										wtable->buf.data,
+										wtable->nitems,
+										normal_commit);
+			}
+			putGpuCacheLocalMapping(gc_lmap);
 		}
-		entry = &gpucache_auto_preload_entries[nitems++];
-        entry->database_name = strdup(database_name);
-		entry->schema_name = strdup(get_namespace_name(namespace_oid));
-		entry->table_name = strdup(NameStr(pg_class->relname));
+		pfree(wtable->buf.data);
+		pfree(wtable);
 	}
-	gpucache_auto_preload_num_entries = nitems;
-
-	systable_endscan(sscan);
-	table_close(srel, AccessShareLock);
-
-	PopActiveSnapshot();
-	CommitTransactionCommand();
-	
-	*p_start = 0;
-	*p_end   = nitems;
-
-	return exit_code;
+	list_free(wxact->tables);
+	hash_search(gcache_walsync_xacts_htab,
+				&xid, HASH_REMOVE, NULL);
 }
 
 /*
- * gpuCacheAutoPreloadDatabaseName
+ * __gpuCacheWalSyncXactRecord
  */
-static int
-gpuCacheAutoPreloadConnectDatabase(int32 *p_start, int32 *p_end)
+static void
+__gpuCacheWalSyncXactRecord(XLogReaderState *record)
 {
-	GpuCacheAutoPreloadEntry *entry;
-	const char *database_name;
-	int32		start;
-	int32		curr;
-
-	if (!gpucache_auto_preload_entries)
-		return __gpuCacheAutoPreloadConnectDatabaseAny(p_start, p_end);
-
-	start = curr = gcache_shared_head->gcache_auto_preload_count;
-	if (start >= gpucache_auto_preload_num_entries)
-		proc_exit(0);	/* no more preloading */
+	uint8		info = (XLogRecGetInfo(record) & XLOG_XACT_OPMASK);
+	TransactionId xid = XLogRecGetXid(record);
+	TransactionId *subxacts;
+	int			nsubxacts;
+	bool		normal_commit;
 
-	database_name = gpucache_auto_preload_entries[start].database_name;
-	while (curr < gpucache_auto_preload_num_entries)
+	if (hash_get_num_entries(gcache_walsync_xacts_htab) == 0)
+		return;
+	if (info == XLOG_XACT_COMMIT ||
+		info == XLOG_XACT_COMMIT_PREPARED)
+	{
+		xl_xact_parsed_commit parsed;
+
+		ParseCommitRecord(XLogRecGetInfo(record),
+						  (xl_xact_commit *)XLogRecGetData(record),
+						  &parsed);
+		if (info == XLOG_XACT_COMMIT_PREPARED)
+			xid = parsed.twophase_xid;
+		subxacts = parsed.subxacts;
+		nsubxacts = parsed.nsubxacts;
+		normal_commit = true;
+	}
+	else if (info == XLOG_XACT_ABORT ||
+			 info == XLOG_XACT_ABORT_PREPARED)
+	{
+		xl_xact_parsed_abort parsed;
+
+		ParseAbortRecord(XLogRecGetInfo(record),
+						 (xl_xact_abort *)XLogRecGetData(record),
+						 &parsed);
+		if (info == XLOG_XACT_ABORT_PREPARED)
+			xid = parsed.twophase_xid;
+		subxacts = parsed.subxacts;
+		nsubxacts = parsed.nsubxacts;
+		normal_commit = false;
+	}
+	else
 	{
-		entry = &gpucache_auto_preload_entries[curr];
-
-		if (strcmp(database_name, entry->database_name) != 0)
-			break;
+		return;
 	}
-	gcache_shared_head->gcache_auto_preload_count = curr;
-
-	BackgroundWorkerInitializeConnection(database_name, NULL, 0);
+	for (int i=0; i < nsubxacts; i++)
+		__gpuCacheWalSyncXactEnd(subxacts[i], normal_commit);
+	__gpuCacheWalSyncXactEnd(xid, normal_commit);
+}
 
-	*p_start = start;
-	*p_end   = curr;
+/*
+ * __gpuCacheWalSyncAdvanceSlot
+ */
+static void
+__gpuCacheWalSyncAdvanceSlot(XLogRecPtr lsn)
+{
+	ReplicationSlot *slot = MyReplicationSlot;
 
-	return (curr >= gpucache_auto_preload_num_entries ? 0 : 1);
+	if (slot->data.restart_lsn >= lsn)
+		return;
+	SpinLockAcquire(&slot->mutex);
+	slot->data.restart_lsn = lsn;
+	SpinLockRelease(&slot->mutex);
+	ReplicationSlotsComputeRequiredLSN();
 }
 
 /*
- * gpuCacheStartupPreloader
+ * gpuCacheWalSyncWorkerMain
  */
 void
-gpuCacheStartupPreloader(Datum arg)
+gpuCacheWalSyncWorkerMain(Datum arg)
 {
-	int32		start;
-	int32		end;
-	int32		index;
-	int			exit_code;
+	int			index = DatumGetInt32(arg);
+	char	   *rawnames;
+	List	   *dbnames;
+	char	   *database_name;
+	char		slot_name[NAMEDATALEN];
+	ReadLocalXLogPageNoWaitPrivate *private_data;
+	XLogReaderState *reader;
+	XLogRecPtr	start_lsn;
+	XLogRecPtr	next_lsn;
+	TimestampTz	last_scan;
+	HASHCTL		hctl;
 
+	pqsignal(SIGTERM, die);
 	BackgroundWorkerUnblockSignals();
 
-	exit_code = gpuCacheAutoPreloadConnectDatabase(&start, &end);
+	rawnames = pstrdup(pgstrom_gpucache_wal_sync_databases);
+	if (!SplitIdentifierString(rawnames, ',', &dbnames) ||
+		index < 0 || index >= list_length(dbnames))
+		elog(ERROR, "Bug? pg_strom.gpucache_wal_sync_databases is broken");
+	database_name = list_nth(dbnames, index);
+	BackgroundWorkerInitializeConnection(database_name, NULL, 0);
+	if (wal_level < WAL_LEVEL_LOGICAL)
+	{
+		elog(LOG, "gpucache: WAL sync worker requires wal_level = logical");
+		proc_exit(0);
+	}
+	gcache_walsync_worker = true;
+
+	/* setup a temporary replication slot to retain WAL */
+	CheckSlotRequirements();
+	snprintf(slot_name, sizeof(slot_name),
+			 "pgstrom_gpucache_%u", MyDatabaseId);
+	ReplicationSlotCreate(slot_name, false, RS_TEMPORARY, false);
+	ReplicationSlotReserveWal();
+	start_lsn = MyReplicationSlot->data.restart_lsn;
+
+	memset(&hctl, 0, sizeof(HASHCTL));
+	hctl.keysize = sizeof(TransactionId);
+	hctl.entrysize = sizeof(GpuCacheWalSyncXact);
+	hctl.hcxt = TopMemoryContext;
+	gcache_walsync_xacts_htab = hash_create("GpuCache WAL Sync Xacts", 1024, &hctl,
+											HASH_ELEM | HASH_BLOBS | HASH_CONTEXT);
+	/*
+	 * GpuCache with sync_mode=wal built prior to the slot might miss some
+	 * WAL records, so reset and rebuild them.
+	 */
 	StartTransactionCommand();
-	GetCurrentTransactionId();
-	for (index=start; index < end; index++)
+	PushActiveSnapshot(GetTransactionSnapshot());
+	__gpuCacheWalSyncScanTables(true);
+	PopActiveSnapshot();
+	CommitTransactionCommand();
+	last_scan = GetCurrentTimestamp();
+
+	private_data = palloc0(sizeof(ReadLocalXLogPageNoWaitPrivate));
+	reader = XLogReaderAllocate(wal_segment_size, NULL,
+								XL_ROUTINE(.page_read = &read_local_xlog_page_no_wait,
+										   .segment_open = &wal_segment_open,
+										   .segment_close = &wal_segment_close),
+								private_data);
+	if (!reader)
+		ereport(ERROR,
+				(errcode(ERRCODE_OUT_OF_MEMORY),
+				 errmsg("out of memory"),
+				 errdetail("Failed while allocating a WAL reading processor.")));
+	for (;;)
 	{
-		GpuCacheAutoPreloadEntry *entry = &gpucache_auto_preload_entries[index];
-		GpuCacheDesc   *gc_desc;
-		RangeVar		rvar;
-		Relation		rel;
+		next_lsn = XLogFindNextRecord(reader, start_lsn);
+		if (!XLogRecPtrIsInvalid(next_lsn))
+			break;
+		if (!private_data->end_of_wal)
+			elog(ERROR, "gpucache: could not find a valid WAL record after %X/%X",
+				 LSN_FORMAT_ARGS(start_lsn));
+		private_data->end_of_wal = false;
+		(void) WaitLatch(MyLatch,
+						 WL_LATCH_SET | WL_TIMEOUT | WL_EXIT_ON_PM_DEATH,
+						 GCACHE_WALSYNC_NAPTIME,
+						 PG_WAIT_EXTENSION);
+		ResetLatch(MyLatch);
+		CHECK_FOR_INTERRUPTS();
+	}
+	XLogBeginRead(reader, next_lsn);
+	elog(LOG, "gpucache: WAL sync worker started on database '%s' at %X/%X",
+		 database_name, LSN_FORMAT_ARGS(next_lsn));
 
-		memset(&rvar, 0, sizeof(RangeVar));
-		rvar.type = T_RangeVar;
-		rvar.schemaname = entry->schema_name;
-		rvar.relname = entry->table_name;
+	for (;;)
+	{
+		int		nrecords = 0;
 
-		rel = table_openrv(&rvar, AccessShareLock);
-		gc_desc = lookupGpuCacheDesc(rel);
-		initialLoadGpuCache(gc_desc, rel);
-		table_close(rel, NoLock);
+		CHECK_FOR_INTERRUPTS();
 
-		elog(LOG, "gpucache: auto preload '%s.%s' (DB: %s)",
-			 entry->schema_name,
-			 entry->table_name,
-			 entry->database_name);
-	}
-	CommitTransactionCommand();
+		StartTransactionCommand();
+		PushActiveSnapshot(GetTransactionSnapshot());
+		while (nrecords < GCACHE_WALSYNC_BATCH_NRECORDS)
+		{
+			XLogRecord *xlrec;
+			char	   *errormsg;
 
-	proc_exit(exit_code);
+			xlrec = XLogReadRecord(reader, &errormsg);
+			if (!xlrec)
+			{
+				if (!private_data->end_of_wal)
+				{
+					if (errormsg)
+						elog(ERROR, "gpucache: could not read WAL at %X/%X: %s",
+							 LSN_FORMAT_ARGS(next_lsn), errormsg);
+					elog(ERROR, "gpucache: could not read WAL at %X/%X",
+						 LSN_FORMAT_ARGS(next_lsn));
+				}
+				/* reached to the end of WAL, retry from the next record */
+				private_data->end_of_wal = false;
+				XLogBeginRead(reader, next_lsn);
+				break;
+			}
+
+			switch (XLogRecGetRmid(reader))
+			{
+				case RM_HEAP_ID:
+					__gpuCacheWalSyncHeapRecord(reader);
+					break;
+				case RM_HEAP2_ID:
+					if ((XLogRecGetInfo(reader) & XLOG_HEAP_OPMASK) == XLOG_HEAP2_MULTI_INSERT)
+						__gpuCacheWalSyncMultiInsert(reader);
+					break;
+				case RM_XACT_ID:
+					__gpuCacheWalSyncXactRecord(reader);
+					break;
+				default:
+					break;
+			}
+			next_lsn = reader->EndRecPtr;
+			nrecords++;
+		}
+		PopActiveSnapshot();
+		CommitTransactionCommand();
+
+		/* WAL prior to the next record is no longer needed */
+		__gpuCacheWalSyncAdvanceSlot(next_lsn);
+
+		if (nrecords == 0)
+		{
+			/* load GpuCache configured or recovered recently */
+			if (TimestampDifferenceExceeds(last_scan,
+										   GetCurrentTimestamp(),
+										   GCACHE_WALSYNC_SCAN_INTERVAL))
+			{
+				StartTransactionCommand();
+				PushActiveSnapshot(GetTransactionSnapshot());
+				__gpuCacheWalSyncScanTables(false);
+				PopActiveSnapshot();
+				CommitTransactionCommand();
+				last_scan = GetCurrentTimestamp();
+			}
+			(void) WaitLatch(MyLatch,
+							 WL_LATCH_SET | WL_TIMEOUT | WL_EXIT_ON_PM_DEATH,
+							 GCACHE_WALSYNC_NAPTIME,
+							 PG_WAIT_EXTENSION);
+			ResetLatch(MyLatch);
+		}
+	}
 }
 
 /* ------------------------------------------------------------
@@ -4142,10 +7948,11 @@ pgstrom_gpucache_info(PG_FUNCTION_ARGS)
 	GpuCacheSharedState *gc_sstate;
 	FuncCallContext *fncxt;
 	List	   *info_list;
-	Datum		values[20];
-	bool		isnull[20];
+	Datum		values[25];
+	bool		isnull[25];
 	HeapTuple	tuple;
 	uint32_t	phase;
+	uint64_t	num_free;
 	char	   *str;
 
 	if (SRF_IS_FIRSTCALL())
@@ -4155,7 +7962,7 @@ pgstrom_gpucache_info(PG_FUNCTION_ARGS)
 
 		fncxt = SRF_FIRSTCALL_INIT();
 		oldcxt = MemoryContextSwitchTo(fncxt->multi_call_memory_ctx);
-		tupdesc = CreateTemplateTupleDesc(20);
+		tupdesc = CreateTemplateTupleDesc(25);
 		TupleDescInitEntry(tupdesc,  1, "database_oid",
 						   OIDOID, -1, 0);
 		TupleDescInitEntry(tupdesc,  2, "database_name",
@@ -4194,7 +8001,17 @@ pgstrom_gpucache_info(PG_FUNCTION_ARGS)
 						   INT8OID, -1, 0);
 		TupleDescInitEntry(tupdesc, 19, "redo_sync_pos",
 						   INT8OID, -1, 0);
-		TupleDescInitEntry(tupdesc, 20, "config_options",
+		TupleDescInitEntry(tupdesc, 20, "initload_blocks_done",
+						   INT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc, 21, "initload_blocks_total",
+						   INT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc, 22, "gpu_resident",
+						   BOOLOID, -1, 0);
+		TupleDescInitEntry(tupdesc, 23, "evict_count",
+						   INT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc, 24, "restore_count",
+						   INT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc, 25, "config_options",
 						   TEXTOID, -1, 0);
 		fncxt->tuple_desc = BlessTupleDesc(tupdesc);
 		fncxt->user_fctx = __pgstrom_gpucache_info();
@@ -4229,9 +8046,9 @@ pgstrom_gpucache_info(PG_FUNCTION_ARGS)
 	else
 		str = psprintf("unknown-%u", phase);
 	values[5] = CStringGetTextDatum(str);
-	values[6] = Int64GetDatum(gc_sstate->gc_options.max_num_rows -
-							  gc_sstate->rowid_num_free);
-	values[7] = Int64GetDatum(gc_sstate->rowid_num_free);
+	num_free = __gpuCacheRowIdNumFree(gc_sstate);
+	values[6] = Int64GetDatum(gc_sstate->gc_options.max_num_rows - num_free);
+	values[7] = Int64GetDatum(num_free);
 	values[8] = Int64GetDatum(pg_atomic_read_u64(&gc_sstate->gcache_main_size));
 	values[9] = Int64GetDatum(pg_atomic_read_u64(&gc_sstate->gcache_main_nitems));
 	values[10] = Int64GetDatum(pg_atomic_read_u64(&gc_sstate->gcache_extra_size));
@@ -4243,6 +8060,11 @@ pgstrom_gpucache_info(PG_FUNCTION_ARGS)
 	values[16] = Int64GetDatum(gc_sstate->redo_read_nitems);
 	values[17] = Int64GetDatum(gc_sstate->redo_read_pos);
 	values[18] = Int64GetDatum(gc_sstate->redo_sync_pos);
+	values[19] = Int64GetDatum(pg_atomic_read_u64(&gc_sstate->initload_nblocks_done));
+	values[20] = Int64GetDatum(pg_atomic_read_u64(&gc_sstate->initload_nblocks_total));
+	values[21] = BoolGetDatum(pg_atomic_read_u32(&gc_sstate->gcache_evicted) == 0);
+	values[22] = Int64GetDatum(pg_atomic_read_u64(&gc_sstate->gcache_evict_count));
+	values[23] = Int64GetDatum(pg_atomic_read_u64(&gc_sstate->gcache_restore_count));
 	if (gc_sstate->gc_options.cuda_dindex >= 0 &&
 		gc_sstate->gc_options.cuda_dindex < numGpuDevAttrs)
 	{
@@ -4256,11 +8078,11 @@ pgstrom_gpucache_info(PG_FUNCTION_ARGS)
 					   gc_sstate->gc_options.redo_buffer_size,
 					   gc_sstate->gc_options.gpu_sync_interval,
 					   gc_sstate->gc_options.gpu_sync_threshold);
-		values[19] = CStringGetTextDatum(str);
+		values[24] = CStringGetTextDatum(str);
 	}
 	else
 	{
-		isnull[19] = true;
+		isnull[24] = true;
 	}
 	tuple = heap_form_tuple(fncxt->tuple_desc, values, isnull);
 	SRF_RETURN_NEXT(fncxt, HeapTupleGetDatum(tuple));
@@ -4376,6 +8198,57 @@ pgstrom_init_gpu_cache(void)
 							 PGC_USERSET,
 							 GUC_NOT_IN_SAMPLE,
 							 NULL, NULL, NULL);
+	/* GUC: pg_strom.gpucache_initial_load_workers */
+	DefineCustomIntVariable("pg_strom.gpucache_initial_load_workers",
+							"max number of parallel workers for GpuCache initial loading",
+							NULL,
+							&pgstrom_gpucache_initload_workers,
+							4,
+							0,
+							MAX_PARALLEL_WORKER_LIMIT,
+							PGC_SUSET,
+							GUC_NOT_IN_SAMPLE,
+							NULL, NULL, NULL);
+	/* GUC: pg_strom.gpucache_snapshot_dir */
+	DefineCustomStringVariable("pg_strom.gpucache_snapshot_dir",
+							   "directory to save GpuCache snapshot for the fast restart",
+							   "Must be dedicated to this instance; never share it with replicas or backups",
+							   &pgstrom_gpucache_snapshot_dir,
+							   NULL,
+							   PGC_POSTMASTER,
+							   GUC_NOT_IN_SAMPLE,
+							   NULL, NULL, NULL);
+	/* GUC: pg_strom.gpucache_snapshot_interval */
+	DefineCustomIntVariable("pg_strom.gpucache_snapshot_interval",
+							"interval to write out GpuCache snapshot, if updated",
+							NULL,
+							&pgstrom_gpucache_snapshot_interval,
+							300,
+							0,
+							INT_MAX / 1000,
+							PGC_POSTMASTER,
+							GUC_NOT_IN_SAMPLE | GUC_UNIT_S,
+							NULL, NULL, NULL);
+	/* GUC: pg_strom.gpucache_device_budget */
+	DefineCustomIntVariable("pg_strom.gpucache_device_budget",
+							"total size of GpuCache resident on a GPU device",
+							"Least recently scanned GpuCache is evicted to the host memory, if exceeded. 0 means unlimited.",
+							&pgstrom_gpucache_device_budget,
+							0,
+							0,
+							INT_MAX,
+							PGC_POSTMASTER,
+							GUC_NOT_IN_SAMPLE | GUC_UNIT_MB,
+							NULL, NULL, NULL);
+	/* GUC: pg_strom.gpucache_wal_sync_databases */
+	DefineCustomStringVariable("pg_strom.gpucache_wal_sync_databases",
+							   "list of databases where GpuCache WAL sync worker runs",
+							   "GpuCache with sync_mode=wal option is synchronized by the worker, instead of the row triggers. It requires wal_level = logical.",
+							   &pgstrom_gpucache_wal_sync_databases,
+							   NULL,
+							   PGC_POSTMASTER,
+							   GUC_NOT_IN_SAMPLE | GUC_LIST_INPUT,
+							   NULL, NULL, NULL);
 	/* setup local hash tables */
 	memset(&hctl, 0, sizeof(HASHCTL));
 	hctl.keysize = offsetof(GpuCacheDesc, xid) + sizeof(TransactionId);
@@ -4398,7 +8271,7 @@ pgstrom_init_gpu_cache(void)
 	/*
 	 * Background worke to load GPU Store on startup
 	 */
-	if (pgstrom_gpucache_auto_preload)
+	if (pgstrom_gpucache_auto_preload && !gpuServiceIsRemote())
 	{
 		BackgroundWorker worker;
 
@@ -4419,6 +8292,38 @@ pgstrom_init_gpu_cache(void)
 		RegisterBackgroundWorker(&worker);
 	}
 
+	/*
+	 * Background workers to synchronize GpuCache by WAL decoding
+	 */
+	if (pgstrom_gpucache_wal_sync_databases && !gpuServiceIsRemote())
+	{
+		char	   *rawnames = pstrdup(pgstrom_gpucache_wal_sync_databases);
+		List	   *dbnames;
+		ListCell   *lc;
+		int			index = 0;
+
+		if (!SplitIdentifierString(rawnames, ',', &dbnames))
+			elog(ERROR, "pg_strom.gpucache_wal_sync_databases: invalid list syntax");
+		foreach (lc, dbnames)
+		{
+			BackgroundWorker worker;
+
+			memset(&worker, 0, sizeof(BackgroundWorker));
+			snprintf(worker.bgw_name, sizeof(worker.bgw_name),
+					 "GPUCache WAL Sync [%s]", (char *)lfirst(lc));
+			worker.bgw_flags = (BGWORKER_SHMEM_ACCESS |
+								BGWORKER_BACKEND_DATABASE_CONNECTION);
+			worker.bgw_start_time = BgWorkerStart_RecoveryFinished;
+			worker.bgw_restart_time = 5;
+			snprintf(worker.bgw_library_name, BGW_MAXLEN,
+					 "$libdir/pg_strom");
+			snprintf(worker.bgw_function_name, BGW_MAXLEN,
+					 "gpuCacheWalSyncWorkerMain");
+			worker.bgw_main_arg = Int32GetDatum(index++);
+			RegisterBackgroundWorker(&worker);
+		}
+	}
+
 	/* request for the static shared memory */
 	shmem_request_next = shmem_request_hook;
 	shmem_request_hook = pgstrom_request_gpu_cache;
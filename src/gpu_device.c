@@ -9,6 +9,11 @@
  * This program is free software; you can redistribute it and/or modify
  * it under the terms of the PostgreSQL License.
  */
+#include <dlfcn.h>
+#include <netdb.h>
+#include <netinet/tcp.h>
+#include <sched.h>
+#include <sys/syscall.h>
 #include "pg_strom.h"
 #include "cuda_common.h"
 
@@ -19,6 +24,19 @@ double		pgstrom_gpu_setup_cost;			/* GUC */
 double		pgstrom_gpu_tuple_cost;			/* GUC */
 double		pgstrom_gpu_operator_cost;		/* GUC */
 double		pgstrom_gpu_direct_seq_page_cost; /* GUC */
+static bool	pgstrom_enable_multi_gpu;		/* GUC */
+static bool	pgstrom_gpu_load_balance;		/* GUC */
+static bool	pgstrom_gpu_parallel_share_device;	/* GUC */
+static int		pgstrom_gpu_command_ring_size_kb;	/* GUC */
+static int		pgstrom_gpu_result_ring_size_kb;	/* GUC */
+static char	   *pgstrom_gpu_workload_class = NULL;	/* GUC */
+static char	   *pgstrom_gpu_device_classes = NULL;	/* GUC */
+static bool		pgstrom_enable_mig_devices;		/* GUC */
+static bool		pgstrom_gpu_numa_affinity;		/* GUC */
+static char	   *pgstrom_gpu_service_remote_endpoint = NULL;	/* GUC */
+static char	   *pgstrom_gpu_service_secret_file = NULL;	/* GUC */
+static char	   *gpu_service_secret = NULL;
+static size_t	gpu_service_secret_len = 0;
 /* catalog of device attributes */
 typedef enum {
 	DEVATTRKIND__INT,
@@ -44,6 +62,184 @@ static struct {
 #undef DEV_ATTR
 };
 
+/*
+ * MIG (Multi-Instance GPU) support
+ *
+ * CUDA enumerates the MIG instances only if CUDA_VISIBLE_DEVICES lists
+ * them by their UUIDs, so we pick them up using NVML prior to the CUDA
+ * initialization. NVML is loaded on demand, and nothing happens if not
+ * available. Each MIG instance is a separate GPU device for PG-Strom
+ * (own memory pools and workers in the GPU service), and inherits the
+ * PCI-E location from the parent GPU for GPU-Direct SQL.
+ */
+typedef struct nvmlDevice_st   *nvmlDevice_t;
+typedef int						nvmlReturn_t;
+typedef struct
+{
+	char		busIdLegacy[16];
+	unsigned int domain;
+	unsigned int bus;
+	unsigned int device;
+	unsigned int pciDeviceId;
+	unsigned int pciSubSystemId;
+	char		busId[32];
+} nvmlPciInfo_t;
+#define NVML_SUCCESS					0
+#define NVML_DEVICE_MIG_ENABLE			1
+#define NVML_DEVICE_UUID_V2_BUFFER_SIZE	96
+#define NVML_LIBRARY_FILENAME			"libnvidia-ml.so.1"
+
+typedef struct
+{
+	int			nvml_index;
+	uint32_t	pci_domain;
+	uint32_t	pci_bus_id;
+	uint32_t	pci_dev_id;
+	int			nr_mig_devs;
+} GpuMigParentInfo;
+
+static GpuMigParentInfo *gpuMigParents = NULL;
+static int		numGpuMigParents = 0;
+
+static void
+pgstrom_setup_mig_devices(void)
+{
+	void	   *handle;
+	nvmlReturn_t (*p_nvmlInit_v2)(void);
+	nvmlReturn_t (*p_nvmlShutdown)(void);
+	nvmlReturn_t (*p_nvmlDeviceGetCount_v2)(unsigned int *);
+	nvmlReturn_t (*p_nvmlDeviceGetHandleByIndex_v2)(unsigned int, nvmlDevice_t *);
+	nvmlReturn_t (*p_nvmlDeviceGetPciInfo_v3)(nvmlDevice_t, nvmlPciInfo_t *);
+	nvmlReturn_t (*p_nvmlDeviceGetMigMode)(nvmlDevice_t, unsigned int *, unsigned int *);
+	nvmlReturn_t (*p_nvmlDeviceGetMaxMigDeviceCount)(nvmlDevice_t, unsigned int *);
+	nvmlReturn_t (*p_nvmlDeviceGetMigDeviceHandleByIndex)(nvmlDevice_t, unsigned int, nvmlDevice_t *);
+	nvmlReturn_t (*p_nvmlDeviceGetUUID)(nvmlDevice_t, char *, unsigned int);
+	unsigned int nr_gpus;
+	int			nrooms = 0;
+	StringInfoData buf;
+
+	handle = dlopen(NVML_LIBRARY_FILENAME, RTLD_NOW | RTLD_LOCAL);
+	if (!handle)
+	{
+		elog(DEBUG1, "PG-Strom: NVML is not available, so MIG devices are not enumerated");
+		return;
+	}
+#define LOOKUP_NVML_FUNCTION(NAME)										\
+	do {																\
+		p_##NAME = dlsym(handle, #NAME);								\
+		if (!p_##NAME)													\
+		{																\
+			elog(LOG, "PG-Strom: NVML has no '%s', so MIG devices are not enumerated", #NAME); \
+			goto out_close;												\
+		}																\
+	} while(0)
+	LOOKUP_NVML_FUNCTION(nvmlInit_v2);
+	LOOKUP_NVML_FUNCTION(nvmlShutdown);
+	LOOKUP_NVML_FUNCTION(nvmlDeviceGetCount_v2);
+	LOOKUP_NVML_FUNCTION(nvmlDeviceGetHandleByIndex_v2);
+	LOOKUP_NVML_FUNCTION(nvmlDeviceGetPciInfo_v3);
+	LOOKUP_NVML_FUNCTION(nvmlDeviceGetMigMode);
+	LOOKUP_NVML_FUNCTION(nvmlDeviceGetMaxMigDeviceCount);
+	LOOKUP_NVML_FUNCTION(nvmlDeviceGetMigDeviceHandleByIndex);
+	LOOKUP_NVML_FUNCTION(nvmlDeviceGetUUID);
+#undef LOOKUP_NVML_FUNCTION
+
+	if (p_nvmlInit_v2() != NVML_SUCCESS)
+		goto out_close;
+	if (p_nvmlDeviceGetCount_v2(&nr_gpus) != NVML_SUCCESS)
+		goto out_shutdown;
+
+	initStringInfo(&buf);
+	for (unsigned int i=0; i < nr_gpus; i++)
+	{
+		nvmlDevice_t	gpu_dev;
+		nvmlDevice_t	mig_dev;
+		nvmlPciInfo_t	pci_info;
+		unsigned int	mig_mode_curr;
+		unsigned int	mig_mode_pend;
+		unsigned int	max_mig_devs;
+		char			uuid[NVML_DEVICE_UUID_V2_BUFFER_SIZE];
+		int				nr_mig_devs = 0;
+
+		if (p_nvmlDeviceGetHandleByIndex_v2(i, &gpu_dev) != NVML_SUCCESS)
+			continue;
+		/* non-MIG GPUs are visible as usual */
+		if (p_nvmlDeviceGetMigMode(gpu_dev,
+								   &mig_mode_curr,
+								   &mig_mode_pend) != NVML_SUCCESS ||
+			mig_mode_curr != NVML_DEVICE_MIG_ENABLE)
+		{
+			if (p_nvmlDeviceGetUUID(gpu_dev, uuid, sizeof(uuid)) == NVML_SUCCESS)
+				appendStringInfo(&buf, "%s%s", buf.len > 0 ? "," : "", uuid);
+			continue;
+		}
+		if (p_nvmlDeviceGetPciInfo_v3(gpu_dev, &pci_info) != NVML_SUCCESS ||
+			p_nvmlDeviceGetMaxMigDeviceCount(gpu_dev, &max_mig_devs) != NVML_SUCCESS)
+			continue;
+		for (unsigned int j=0; j < max_mig_devs; j++)
+		{
+			/* unused slot returns NVML_ERROR_NOT_FOUND */
+			if (p_nvmlDeviceGetMigDeviceHandleByIndex(gpu_dev, j,
+													  &mig_dev) != NVML_SUCCESS ||
+				p_nvmlDeviceGetUUID(mig_dev, uuid, sizeof(uuid)) != NVML_SUCCESS)
+				continue;
+			appendStringInfo(&buf, "%s%s", buf.len > 0 ? "," : "", uuid);
+			nr_mig_devs++;
+		}
+		if (nr_mig_devs == 0)
+		{
+			elog(LOG, "PG-Strom: GPU [%s] is in MIG mode, but has no GPU instances",
+				 pci_info.busId);
+			continue;
+		}
+		if (numGpuMigParents >= nrooms)
+		{
+			nrooms += 8;
+			gpuMigParents = realloc(gpuMigParents,
+									sizeof(GpuMigParentInfo) * nrooms);
+			if (!gpuMigParents)
+				elog(ERROR, "out of memory");
+		}
+		gpuMigParents[numGpuMigParents].nvml_index  = i;
+		gpuMigParents[numGpuMigParents].pci_domain  = pci_info.domain;
+		gpuMigParents[numGpuMigParents].pci_bus_id  = pci_info.bus;
+		gpuMigParents[numGpuMigParents].pci_dev_id  = pci_info.device;
+		gpuMigParents[numGpuMigParents].nr_mig_devs = nr_mig_devs;
+		numGpuMigParents++;
+	}
+	/* no need to touch CUDA_VISIBLE_DEVICES without MIG devices */
+	if (numGpuMigParents > 0)
+	{
+		if (setenv("CUDA_VISIBLE_DEVICES", buf.data, 1) != 0)
+			elog(ERROR, "failed to set CUDA_VISIBLE_DEVICES");
+		elog(LOG, "PG-Strom: MIG devices are enabled (CUDA_VISIBLE_DEVICES=%s)",
+			 buf.data);
+	}
+	pfree(buf.data);
+out_shutdown:
+	p_nvmlShutdown();
+out_close:
+	dlclose(handle);
+}
+
+/*
+ * __lookupGpuMigParent - returns NVML index of the parent GPU, if MIG
+ */
+static int
+__lookupGpuMigParent(const GpuDevAttributes *dattrs)
+{
+	for (int i=0; i < numGpuMigParents; i++)
+	{
+		GpuMigParentInfo *mig = &gpuMigParents[i];
+
+		if (mig->pci_domain == dattrs->PCI_DOMAIN_ID &&
+			mig->pci_bus_id == dattrs->PCI_BUS_ID &&
+			mig->pci_dev_id == dattrs->PCI_DEVICE_ID)
+			return mig->nvml_index;
+	}
+	return -1;
+}
+
 /*
  * collectGpuDevAttrs
  */
@@ -124,6 +320,8 @@ __collectGpuDevAttrs(GpuDevAttributes *dattrs, CUdevice cuda_device)
 			dattrs->DEV_BAR1_MEMSZ > (256UL << 20))
 			dattrs->DEV_SUPPORT_GPUDIRECTSQL = true;
 	}
+	/* MIG instance shares the PCI-E location with the parent GPU */
+	dattrs->DEV_MIG_PARENT_ID = __lookupGpuMigParent(dattrs);
 }
 
 static int
@@ -167,9 +365,13 @@ collectGpuDevAttrs(int fdesc)
 
 /*
  * receiveGpuDevAttrs
+ *
+ * The remote GPU service sends its own (already validated) device list,
+ * and the index of the list is the port offset of the device; so the list
+ * must be kept as is, without the validation by the local host.
  */
 static void
-receiveGpuDevAttrs(int fdesc)
+receiveGpuDevAttrs(int fdesc, bool validate)
 {
 	GpuDevAttributes *__devAttrs = NULL;
 	GpuDevAttributes dattrs_saved;
@@ -187,7 +389,7 @@ receiveGpuDevAttrs(int fdesc)
 			break;	/* end */
 		if (nbytes != sizeof(GpuDevAttributes))
 			elog(ERROR, "failed on collect GPU device attributes");
-		if (dtemp.COMPUTE_CAPABILITY_MAJOR < 6)
+		if (validate && dtemp.COMPUTE_CAPABILITY_MAJOR < 6)
 		{
 			elog(LOG, "PG-Strom: GPU%d %s - CC %d.%d is not supported",
 				 dtemp.DEV_ID,
@@ -196,7 +398,8 @@ receiveGpuDevAttrs(int fdesc)
 				 dtemp.COMPUTE_CAPABILITY_MINOR);
 			continue;
 		}
-		if (heterodbValidateDevice(dtemp.DEV_ID,
+		if (!validate ||
+			heterodbValidateDevice(dtemp.DEV_ID,
 								   dtemp.DEV_NAME,
 								   dtemp.DEV_UUID))
 		{
@@ -227,6 +430,272 @@ receiveGpuDevAttrs(int fdesc)
 	gpuDevAttrs = __devAttrs;
 }
 
+/*
+ * gpuServiceIsRemote
+ *
+ * True, if the GPU service runs on the remote host configured by
+ * pg_strom.gpu_service_remote_endpoint, instead of the local one.
+ */
+bool
+gpuServiceIsRemote(void)
+{
+	return (pgstrom_gpu_service_remote_endpoint != NULL &&
+			*pgstrom_gpu_service_remote_endpoint != '\0');
+}
+
+/*
+ * gpuServiceSockAddr
+ *
+ * It resolves the "host:port" form of pg_strom.gpu_service_listen_address
+ * and pg_strom.gpu_service_remote_endpoint. GPU<k> of the GPU service is
+ * on the port number + k. IPv6 address has to be enclosed by [ ].
+ */
+void
+gpuServiceSockAddr(const char *gucname, const char *config,
+				   int cuda_dindex, bool is_listen,
+				   struct sockaddr_storage *addr, socklen_t *p_addr_len)
+{
+	char	   *host = alloca(strlen(config) + 1);
+	char	   *pos;
+	char	   *end;
+	char		port[16];
+	long		base;
+	int			rc;
+	struct addrinfo hints;
+	struct addrinfo *ainfo;
+
+	strcpy(host, config);
+	pos = strrchr(host, ':');
+	if (!pos)
+		elog(ERROR, "%s: port number is missing in '%s'", gucname, config);
+	*pos++ = '\0';
+	base = strtol(pos, &end, 10);
+	if (*end != '\0' || base <= 0 || base + cuda_dindex > 65535)
+		elog(ERROR, "%s: invalid port number in '%s'", gucname, config);
+	snprintf(port, sizeof(port), "%ld", base + cuda_dindex);
+	if (*host == '[' && (end = strrchr(host, ']')) != NULL && end[1] == '\0')
+	{
+		*end = '\0';
+		host++;
+	}
+
+	memset(&hints, 0, sizeof(struct addrinfo));
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+	if (is_listen)
+		hints.ai_flags = AI_PASSIVE;
+	rc = getaddrinfo(*host != '\0' ? host : NULL, port, &hints, &ainfo);
+	if (rc != 0)
+		elog(ERROR, "%s: failed on getaddrinfo('%s','%s'): %s",
+			 gucname, host, port, gai_strerror(rc));
+	if (ainfo->ai_addrlen > sizeof(struct sockaddr_storage))
+	{
+		freeaddrinfo(ainfo);
+		elog(ERROR, "%s: too large socket address", gucname);
+	}
+	memcpy(addr, ainfo->ai_addr, ainfo->ai_addrlen);
+	*p_addr_len = ainfo->ai_addrlen;
+	freeaddrinfo(ainfo);
+}
+
+/*
+ * gpuServiceLoadSecret
+ *
+ * It loads the shared secret of pg_strom.gpu_service_secret_file, to
+ * authenticate the backends on the remote hosts. Like the private key of
+ * SSL, the file must not be accessible by the group or others.
+ */
+void
+gpuServiceLoadSecret(void)
+{
+	const char *fname = pgstrom_gpu_service_secret_file;
+	struct stat	stat_buf;
+	char	   *buf;
+	ssize_t		nbytes;
+	int			fdesc;
+
+	if (gpu_service_secret)
+		return;		/* already loaded */
+	if (!fname || *fname == '\0')
+		elog(ERROR, "pg_strom.gpu_service_secret_file must be configured to use the remote GPU service");
+	fdesc = open(fname, O_RDONLY);
+	if (fdesc < 0)
+		elog(ERROR, "failed on open('%s'): %m", fname);
+	if (fstat(fdesc, &stat_buf) != 0)
+	{
+		close(fdesc);
+		elog(ERROR, "failed on fstat('%s'): %m", fname);
+	}
+	if (!S_ISREG(stat_buf.st_mode) ||
+		(stat_buf.st_mode & (S_IRWXG | S_IRWXO)) != 0)
+	{
+		close(fdesc);
+		elog(ERROR, "secret file '%s' must be a regular file without group or world access",
+			 fname);
+	}
+	buf = MemoryContextAlloc(TopMemoryContext, stat_buf.st_size + 1);
+	nbytes = __readFile(fdesc, buf, stat_buf.st_size);
+	close(fdesc);
+	if (nbytes != stat_buf.st_size)
+		elog(ERROR, "failed on read('%s'): %m", fname);
+	/* trailing newlines are not a part of the secret */
+	while (nbytes > 0 && (buf[nbytes-1] == '\n' || buf[nbytes-1] == '\r'))
+		nbytes--;
+	if (nbytes < GPUSERV_AUTH_SECRET_MINLEN)
+		elog(ERROR, "secret file '%s' is too short (at least %d bytes)",
+			 fname, GPUSERV_AUTH_SECRET_MINLEN);
+	buf[nbytes] = '\0';
+	gpu_service_secret = buf;
+	gpu_service_secret_len = nbytes;
+}
+
+/*
+ * gpuServiceAuthDigest
+ *
+ * It computes HMAC-SHA256 of the challenge (nonce) sent by the GPU service,
+ * using the shared secret as key. Both sides compute it, and the GPU service
+ * compares the response of the backend with its own one.
+ */
+void
+gpuServiceAuthDigest(const uint8_t *nonce, uint8_t *digest)
+{
+	ResourceOwner owner_saved = CurrentResourceOwner;
+	ResourceOwner owner_temp = NULL;
+	pg_hmac_ctx *ctx;
+
+	gpuServiceLoadSecret();
+	/*
+	 * HMAC context may be tracked by the resource owner, but neither of
+	 * the postmaster startup nor the GPU service has the one.
+	 */
+	if (!CurrentResourceOwner)
+		CurrentResourceOwner = owner_temp =
+			ResourceOwnerCreate(NULL, "gpuServiceAuthDigest");
+	ctx = pg_hmac_create(PG_SHA256);
+	if (pg_hmac_init(ctx, (const uint8 *)gpu_service_secret,
+					 gpu_service_secret_len) < 0 ||
+		pg_hmac_update(ctx, nonce, GPUSERV_AUTH_NONCE_LEN) < 0 ||
+		pg_hmac_final(ctx, digest, PG_SHA256_DIGEST_LENGTH) < 0)
+		elog(ERROR, "failed on HMAC-SHA256: %s", pg_hmac_error(ctx));
+	pg_hmac_free(ctx);
+	if (owner_temp)
+	{
+		ResourceOwnerRelease(owner_temp, RESOURCE_RELEASE_BEFORE_LOCKS, false, true);
+		ResourceOwnerRelease(owner_temp, RESOURCE_RELEASE_LOCKS, false, true);
+		ResourceOwnerRelease(owner_temp, RESOURCE_RELEASE_AFTER_LOCKS, false, true);
+		CurrentResourceOwner = owner_saved;
+		ResourceOwnerDelete(owner_temp);
+	}
+}
+
+/*
+ * __gpuServiceAuthRemote
+ *
+ * It responds to the challenge of the remote GPU service, prior to any
+ * commands. The GPU service sends back GPUSERV_AUTH_ACCEPTED on success,
+ * or closes the connection elsewhere.
+ */
+static void
+__gpuServiceAuthRemote(pgsocket sockfd, int cuda_dindex)
+{
+	uint8_t		nonce[GPUSERV_AUTH_NONCE_LEN];
+	uint8_t		digest[PG_SHA256_DIGEST_LENGTH];
+	char		result = 0;
+
+	PG_TRY();
+	{
+		if (__readFile(sockfd, nonce, sizeof(nonce)) != sizeof(nonce))
+			elog(ERROR, "failed to receive the challenge from the remote GPU service: %m");
+		gpuServiceAuthDigest(nonce, digest);
+		if (__writeFile(sockfd, digest, sizeof(digest)) != sizeof(digest))
+			elog(ERROR, "failed to send the response to the remote GPU service: %m");
+		if (__readFile(sockfd, &result, 1) != 1 ||
+			result != GPUSERV_AUTH_ACCEPTED)
+			elog(ERROR, "authentication failed on the remote GPU service at '%s' for GPU%d",
+				 pgstrom_gpu_service_remote_endpoint, cuda_dindex);
+	}
+	PG_CATCH();
+	{
+		close(sockfd);
+		PG_RE_THROW();
+	}
+	PG_END_TRY();
+}
+
+/*
+ * __gpuServiceConnectRemote
+ */
+static pgsocket
+__gpuServiceConnectRemote(int cuda_dindex, bool missing_ok)
+{
+	struct sockaddr_storage addr;
+	socklen_t	addr_len;
+	pgsocket	sockfd;
+	int			one = 1;
+
+	gpuServiceSockAddr("pg_strom.gpu_service_remote_endpoint",
+					   pgstrom_gpu_service_remote_endpoint,
+					   cuda_dindex, false,
+					   &addr, &addr_len);
+	sockfd = socket(addr.ss_family, SOCK_STREAM, 0);
+	if (sockfd < 0)
+		elog(ERROR, "failed on socket(2): %m");
+	/* XpuCommand is written at once, so Nagle's algorithm just adds latency */
+	if (setsockopt(sockfd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one)) != 0)
+		elog(LOG, "failed on setsockopt(TCP_NODELAY): %m");
+	if (connect(sockfd, (struct sockaddr *)&addr, addr_len) != 0)
+	{
+		int		errno_saved = errno;
+
+		close(sockfd);
+		errno = errno_saved;
+		if (missing_ok)
+			return PGINVALID_SOCKET;
+		elog(ERROR, "failed on connect('%s' for GPU%d): %m",
+			 pgstrom_gpu_service_remote_endpoint, cuda_dindex);
+	}
+	__gpuServiceAuthRemote(sockfd, cuda_dindex);
+	return sockfd;
+}
+
+/*
+ * receiveRemoteGpuDevAttrs
+ *
+ * It asks the device attributes to the remote GPU service. If it is not
+ * reachable on the startup, PG-Strom runs as if no GPUs are installed.
+ */
+static void
+receiveRemoteGpuDevAttrs(void)
+{
+	XpuCommand	xcmd;
+	pgsocket	sockfd;
+
+	sockfd = __gpuServiceConnectRemote(0, true);
+	if (sockfd == PGINVALID_SOCKET)
+	{
+		elog(LOG, "PG-Strom: unable to connect the remote GPU service at '%s': %m",
+			 pgstrom_gpu_service_remote_endpoint);
+		return;
+	}
+	memset(&xcmd, 0, offsetof(XpuCommand, u));
+	xcmd.magic = XpuCommandMagicNumber;
+	xcmd.tag = XpuCommandTag__DeviceAttrs;
+	xcmd.length = offsetof(XpuCommand, u);
+	PG_TRY();
+	{
+		if (__writeFile(sockfd, &xcmd, xcmd.length) != xcmd.length)
+			elog(ERROR, "failed on write(2) to the remote GPU service: %m");
+		receiveGpuDevAttrs(sockfd, false);
+	}
+	PG_CATCH();
+	{
+		close(sockfd);
+		PG_RE_THROW();
+	}
+	PG_END_TRY();
+	close(sockfd);
+}
+
 /*
  * pgstrom_collect_gpu_devices
  */
@@ -237,50 +706,55 @@ pgstrom_collect_gpu_devices(void)
 	pid_t	child;
 	StringInfoData buf;
 
-	if (pipe(pipefd) != 0)
-		elog(ERROR, "failed on pipe(2): %m");
-	child = fork();
-	if (child == 0)
-	{
-		close(pipefd[0]);
-		_exit(collectGpuDevAttrs(pipefd[1]));
-	}
-	else if (child > 0)
+	if (gpuServiceIsRemote())
+		receiveRemoteGpuDevAttrs();
+	else
 	{
-		int		status;
-
-		close(pipefd[1]);
-		PG_TRY();
+		if (pipe(pipefd) != 0)
+			elog(ERROR, "failed on pipe(2): %m");
+		child = fork();
+		if (child == 0)
 		{
-			receiveGpuDevAttrs(pipefd[0]);
-		}
-		PG_CATCH();
-		{
-			/* cleanup */
-			kill(child, SIGKILL);
 			close(pipefd[0]);
-			PG_RE_THROW();
+			_exit(collectGpuDevAttrs(pipefd[1]));
 		}
-		PG_END_TRY();
-		close(pipefd[0]);
-
-		while (waitpid(child, &status, 0) < 0)
+		else if (child > 0)
 		{
-			if (errno != EINTR)
+			int		status;
+
+			close(pipefd[1]);
+			PG_TRY();
+			{
+				receiveGpuDevAttrs(pipefd[0], true);
+			}
+			PG_CATCH();
 			{
+				/* cleanup */
 				kill(child, SIGKILL);
-				elog(ERROR, "failed on waitpid: %m");
+				close(pipefd[0]);
+				PG_RE_THROW();
+			}
+			PG_END_TRY();
+			close(pipefd[0]);
+
+			while (waitpid(child, &status, 0) < 0)
+			{
+				if (errno != EINTR)
+				{
+					kill(child, SIGKILL);
+					elog(ERROR, "failed on waitpid: %m");
+				}
 			}
+			if (WEXITSTATUS(status) != 0)
+				elog(ERROR, "GPU device attribute collector exited with %d",
+					 WEXITSTATUS(status));
+		}
+		else
+		{
+			close(pipefd[0]);
+			close(pipefd[1]);
+			elog(ERROR, "failed on fork(2): %m");
 		}
-		if (WEXITSTATUS(status) != 0)
-			elog(ERROR, "GPU device attribute collector exited with %d",
-				 WEXITSTATUS(status));
-	}
-	else
-	{
-		close(pipefd[0]);
-		close(pipefd[1]);
-		elog(ERROR, "failed on fork(2): %m");
 	}
 	initStringInfo(&buf);
 	for (i=0; i < numGpuDevAttrs; i++)
@@ -348,9 +822,171 @@ pgstrom_collect_gpu_devices(void)
 		appendStringInfo(&buf, ", CC %d.%d",
 						 dattrs->COMPUTE_CAPABILITY_MAJOR,
 						 dattrs->COMPUTE_CAPABILITY_MINOR);
+		if (dattrs->DEV_MIG_PARENT_ID >= 0)
+			appendStringInfo(&buf, ", MIG instance of [%04x:%02x:%02x]",
+							 dattrs->PCI_DOMAIN_ID,
+							 dattrs->PCI_BUS_ID,
+							 dattrs->PCI_DEVICE_ID);
         elog(LOG, "PG-Strom: %s", buf.data);
 	}
 	pfree(buf.data);
+
+	/*
+	 * Some CUDA versions enumerate only one MIG instance per process,
+	 * so the rest of instances are not available to the GPU service.
+	 */
+	for (i=0; i < numGpuMigParents; i++)
+	{
+		GpuMigParentInfo *mig = &gpuMigParents[i];
+		int		count = 0;
+
+		for (int k=0; k < numGpuDevAttrs; k++)
+		{
+			if (gpuDevAttrs[k].DEV_MIG_PARENT_ID == mig->nvml_index)
+				count++;
+		}
+		if (count < mig->nr_mig_devs)
+			elog(LOG, "PG-Strom: only %d of %d MIG instances on [%04x:%02x:%02x] are visible to CUDA",
+				 count, mig->nr_mig_devs,
+				 mig->pci_domain,
+				 mig->pci_bus_id,
+				 mig->pci_dev_id);
+	}
+}
+
+/*
+ * NUMA-aware placement
+ *
+ * The GPU service threads of a device run on the CPUs of the NUMA node
+ * where the GPU is attached, and prefer the local memory of the node for
+ * the host buffers they allocate. Backends also put the ring buffers to
+ * the GPU service on the same node. Only system calls are used here, so
+ * they are safe to call on the GPU service threads.
+ */
+#ifndef MPOL_PREFERRED
+#define MPOL_PREFERRED			1
+#endif
+#define NUMA_BITS_PER_WORD		(sizeof(unsigned long) * BITS_PER_BYTE)
+#define NUMA_NODEMASK_NWORDS	16		/* up to 1024 nodes */
+
+static cpu_set_t *gpuNumaCpuSets = NULL;	/* NULL, if no affinity */
+
+static bool
+__parseNumaCpuList(const char *cpulist, cpu_set_t *cpuset)
+{
+	const char *pos = cpulist;
+
+	CPU_ZERO(cpuset);
+	while (*pos != '\0')
+	{
+		char   *end;
+		long	lo, hi;
+
+		lo = hi = strtol(pos, &end, 10);
+		if (end == pos || lo < 0)
+			return false;
+		if (*end == '-')
+		{
+			pos = end + 1;
+			hi = strtol(pos, &end, 10);
+			if (end == pos || hi < lo)
+				return false;
+		}
+		for (long k=lo; k <= hi && k < CPU_SETSIZE; k++)
+			CPU_SET(k, cpuset);
+		if (*end != ',')
+			break;
+		pos = end + 1;
+	}
+	return CPU_COUNT(cpuset) > 0;
+}
+
+static void
+pgstrom_setup_gpu_numa_affinity(void)
+{
+	char		path[MAXPGPATH];
+	struct stat	stat_buf;
+	int			nr_nodes;
+
+	/* nothing to do on the single node system */
+	for (nr_nodes=0; ; nr_nodes++)
+	{
+		snprintf(path, sizeof(path), "/sys/devices/system/node/node%d", nr_nodes);
+		if (stat(path, &stat_buf) != 0)
+			break;
+	}
+	if (nr_nodes < 2)
+		return;
+
+	gpuNumaCpuSets = calloc(numGpuDevAttrs, sizeof(cpu_set_t));
+	if (!gpuNumaCpuSets)
+		elog(ERROR, "out of memory");
+	for (int i=0; i < numGpuDevAttrs; i++)
+	{
+		GpuDevAttributes *dattrs = &gpuDevAttrs[i];
+		const char *cpulist;
+
+		if (dattrs->NUMA_NODE_ID < 0 ||
+			dattrs->NUMA_NODE_ID >= NUMA_NODEMASK_NWORDS * NUMA_BITS_PER_WORD)
+			continue;
+		snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist",
+				 dattrs->NUMA_NODE_ID);
+		cpulist = sysfs_read_line(path);
+		if (!cpulist || !__parseNumaCpuList(cpulist, &gpuNumaCpuSets[i]))
+		{
+			CPU_ZERO(&gpuNumaCpuSets[i]);
+			continue;
+		}
+		elog(LOG, "PG-Strom: GPU%d is local to NUMA node %d (CPUs %s)",
+			 i, dattrs->NUMA_NODE_ID, cpulist);
+	}
+}
+
+static bool
+__gpuDevNumaNodeMask(int cuda_dindex, unsigned long *nodemask)
+{
+	int		node;
+
+	if (!gpuNumaCpuSets ||
+		cuda_dindex < 0 ||
+		cuda_dindex >= numGpuDevAttrs ||
+		CPU_COUNT(&gpuNumaCpuSets[cuda_dindex]) == 0)
+		return false;
+	node = gpuDevAttrs[cuda_dindex].NUMA_NODE_ID;
+	memset(nodemask, 0, sizeof(unsigned long) * NUMA_NODEMASK_NWORDS);
+	nodemask[node / NUMA_BITS_PER_WORD] |= (1UL << (node % NUMA_BITS_PER_WORD));
+	return true;
+}
+
+/*
+ * gpuDevBindNumaThread - binds the current thread to the NUMA node of GPU
+ */
+void
+gpuDevBindNumaThread(int cuda_dindex)
+{
+	unsigned long nodemask[NUMA_NODEMASK_NWORDS];
+
+	if (!__gpuDevNumaNodeMask(cuda_dindex, nodemask))
+		return;
+	/* errors are harmless, the OS decides the placement as usual */
+	pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t),
+						   &gpuNumaCpuSets[cuda_dindex]);
+	syscall(SYS_set_mempolicy, MPOL_PREFERRED,
+			nodemask, NUMA_NODEMASK_NWORDS * NUMA_BITS_PER_WORD + 1);
+}
+
+/*
+ * gpuDevBindNumaMemory - prefers the NUMA node of GPU for the memory region
+ */
+void
+gpuDevBindNumaMemory(void *addr, size_t length, int cuda_dindex)
+{
+	unsigned long nodemask[NUMA_NODEMASK_NWORDS];
+
+	if (!__gpuDevNumaNodeMask(cuda_dindex, nodemask))
+		return;
+	syscall(SYS_mbind, addr, length, MPOL_PREFERRED,
+			nodemask, NUMA_NODEMASK_NWORDS * NUMA_BITS_PER_WORD + 1, 0);
 }
 
 /*
@@ -366,6 +1002,121 @@ pgstrom_gpu_operator_ratio(void)
 	return (pgstrom_gpu_operator_cost == 0.0 ? 1.0 : disable_cost);
 }
 
+/*
+ * pg_strom.gpu_device_classes
+ *
+ * config := <token>[,<token> ...]
+ * token  := <class>=<gpus>
+ * gpus   := <gpuX>[:<gpuX>...]
+ *
+ * e.g) interactive=gpu0:gpu1,batch=gpu2:gpu3:gpu4
+ *
+ * It returns the GPUs of the workload class 'wclass' on '*p_gpus', or
+ * false with '*p_errmsg' on syntax errors.
+ */
+static bool
+__parseGpuDeviceClasses(const char *__config, const char *wclass,
+						Bitmapset **p_gpus, char **p_errmsg)
+{
+	char	   *config = pstrdup(__config);
+	char	   *tok, *saveptr;
+
+	for (tok = strtok_r(config, ",", &saveptr);
+		 tok != NULL;
+		 tok = strtok_r(NULL, ",", &saveptr))
+	{
+		Bitmapset  *gpus = NULL;
+		char	   *name, *pos, *end;
+		char	   *__tok, *__saveptr;
+
+		pos = strchr(tok, '=');
+		if (!pos)
+		{
+			*p_errmsg = psprintf("syntax error at [%s]", tok);
+			return false;
+		}
+		*pos++ = '\0';
+		name = __trim(tok);
+		if (*name == '\0')
+		{
+			*p_errmsg = psprintf("workload class name is empty");
+			return false;
+		}
+		for (__tok = strtok_r(pos, ":", &__saveptr);
+			 __tok != NULL;
+			 __tok = strtok_r(NULL, ":", &__saveptr))
+		{
+			char   *__gpu = __trim(__tok);
+			long	dindex;
+
+			if (strncmp(__gpu, "gpu", 3) != 0 || __gpu[3] == '\0')
+			{
+				*p_errmsg = psprintf("invalid GPU name [%s]", __gpu);
+				return false;
+			}
+			dindex = strtol(__gpu+3, &end, 10);
+			if (*end != '\0')
+			{
+				*p_errmsg = psprintf("invalid GPU name [%s]", __gpu);
+				return false;
+			}
+			if (dindex < 0 || dindex >= numGpuDevAttrs)
+			{
+				*p_errmsg = psprintf("GPU [%s] is out of range", __gpu);
+				return false;
+			}
+			gpus = bms_add_member(gpus, dindex);
+		}
+		if (wclass && strcmp(name, wclass) == 0)
+			*p_gpus = bms_union(*p_gpus, gpus);
+	}
+	return true;
+}
+
+static bool
+guc_check_gpu_device_classes(char **newval, void **extra, GucSource source)
+{
+	Bitmapset  *gpus = NULL;
+	char	   *errmsg;
+
+	if (*newval && !__parseGpuDeviceClasses(*newval, NULL, &gpus, &errmsg))
+	{
+		GUC_check_errdetail("%s", errmsg);
+		return false;
+	}
+	return true;
+}
+
+/*
+ * __gpuWorkloadClassFilter
+ *
+ * It narrows down the candidate GPUs to the devices of the workload class
+ * of the current session, if any. The preference of GPU-Direct SQL and
+ * GpuCache wins, if no devices of the class are in the candidates.
+ */
+static const Bitmapset *
+__gpuWorkloadClassFilter(const Bitmapset *gpuset)
+{
+	Bitmapset  *class_gpus = NULL;
+	Bitmapset  *result;
+	char	   *errmsg;
+
+	if (!pgstrom_gpu_workload_class ||
+		*pgstrom_gpu_workload_class == '\0' ||
+		!pgstrom_gpu_device_classes ||
+		!__parseGpuDeviceClasses(pgstrom_gpu_device_classes,
+								 pgstrom_gpu_workload_class,
+								 &class_gpus, &errmsg) ||
+		bms_is_empty(class_gpus))
+		return gpuset;
+	if (bms_is_empty(gpuset))
+		return class_gpus;
+	result = bms_intersect(gpuset, class_gpus);
+	if (bms_is_empty(result))
+		return gpuset;
+	return result;
+}
+
 /*
  * pgstrom_init_gpu_options - init GUC options related to GPUs
  */
@@ -416,6 +1167,80 @@ pgstrom_init_gpu_options(void)
 							 PGC_USERSET,
 							 GUC_NOT_IN_SAMPLE,
 							 NULL, NULL, NULL);
+	/* turn on/off multi-GPU execution */
+	DefineCustomBoolVariable("pg_strom.enable_multi_gpu",
+							 "Enables to dispatch chunks of a session to multiple GPUs",
+							 NULL,
+							 &pgstrom_enable_multi_gpu,
+							 false,
+							 PGC_USERSET,
+							 GUC_NOT_IN_SAMPLE,
+							 NULL, NULL, NULL);
+	/* choose the device for a new session by the current load */
+	DefineCustomBoolVariable("pg_strom.gpu_load_balance",
+							 "Chooses the least loaded GPU among the candidates for a new session",
+							 NULL,
+							 &pgstrom_gpu_load_balance,
+							 true,
+							 PGC_USERSET,
+							 GUC_NOT_IN_SAMPLE,
+							 NULL, NULL, NULL);
+	/* NUMA-aware placement of the GPU service threads and host buffers */
+	DefineCustomBoolVariable("pg_strom.gpu_numa_affinity",
+							 "Binds GPU service threads and host buffers to the NUMA node local to the GPU",
+							 NULL,
+							 &pgstrom_gpu_numa_affinity,
+							 true,
+							 PGC_POSTMASTER,
+							 GUC_NOT_IN_SAMPLE,
+							 NULL, NULL, NULL);
+	/* workload class of the session, to choose the GPU devices */
+	DefineCustomStringVariable("pg_strom.gpu_workload_class",
+							   "Workload class of the session to choose the GPU devices",
+							   "GPU devices of the class are configured by pg_strom.gpu_device_classes",
+							   &pgstrom_gpu_workload_class,
+							   NULL,
+							   PGC_USERSET,
+							   GUC_NOT_IN_SAMPLE,
+							   NULL, NULL, NULL);
+	DefineCustomStringVariable("pg_strom.gpu_device_classes",
+							   "GPU devices (or MIG instances) for each workload class",
+							   "e.g) interactive=gpu0:gpu1,batch=gpu2:gpu3",
+							   &pgstrom_gpu_device_classes,
+							   NULL,
+							   PGC_SIGHUP,
+							   GUC_NOT_IN_SAMPLE,
+							   guc_check_gpu_device_classes, NULL, NULL);
+	DefineCustomBoolVariable("pg_strom.gpu_parallel_share_device",
+							 "Parallel workers of GpuJoin/GpuPreAgg use the same GPU to share the device buffers",
+							 NULL,
+							 &pgstrom_gpu_parallel_share_device,
+							 true,
+							 PGC_USERSET,
+							 GUC_NOT_IN_SAMPLE,
+							 NULL, NULL, NULL);
+	/* shared memory ring buffer to send commands to GPU service */
+	DefineCustomIntVariable("pg_strom.gpu_command_ring_size",
+							"Size of the shared memory ring buffer to send commands to GPU service",
+							"0 means the socket is used for all the commands",
+							&pgstrom_gpu_command_ring_size_kb,
+							8192,		/* 8MB */
+							0,
+							1048576,	/* 1GB */
+							PGC_USERSET,
+							GUC_NOT_IN_SAMPLE | GUC_UNIT_KB,
+							NULL, NULL, NULL);
+	/* shared memory ring buffer to write back results from GPU service */
+	DefineCustomIntVariable("pg_strom.gpu_result_ring_size",
+							"Size of the shared memory ring buffer to write back results from GPU service",
+							"0 means the socket is used for all the results",
+							&pgstrom_gpu_result_ring_size_kb,
+							262144,		/* 256MB */
+							0,
+							16777216,	/* 16GB */
+							PGC_USERSET,
+							GUC_NOT_IN_SAMPLE | GUC_UNIT_KB,
+							NULL, NULL, NULL);
 }
 
 /*
@@ -438,16 +1263,48 @@ pgstrom_init_gpu_device(void)
 							   PGC_POSTMASTER,
 							   GUC_NOT_IN_SAMPLE,
 							   NULL, NULL, NULL);
+	DefineCustomBoolVariable("pg_strom.enable_mig_devices",
+							 "Enables to use MIG instances as separate GPU devices",
+							 "It lists up the MIG instances in CUDA_VISIBLE_DEVICES, unless CUDA_VISIBLE_DEVICES is configured",
+							 &pgstrom_enable_mig_devices,
+							 true,
+							 PGC_POSTMASTER,
+							 GUC_NOT_IN_SAMPLE,
+							 NULL, NULL, NULL);
+	DefineCustomStringVariable("pg_strom.gpu_service_remote_endpoint",
+							   "Endpoint (host:port) of the remote GPU service",
+							   "GPU-tasks are sent to the GPU service of the remote host, instead of the local GPUs",
+							   &pgstrom_gpu_service_remote_endpoint,
+							   NULL,
+							   PGC_POSTMASTER,
+							   GUC_NOT_IN_SAMPLE,
+							   NULL, NULL, NULL);
+	DefineCustomStringVariable("pg_strom.gpu_service_secret_file",
+							   "File of the shared secret to authenticate the backends on the remote hosts",
+							   "It is required by both of pg_strom.gpu_service_listen_address and pg_strom.gpu_service_remote_endpoint",
+							   &pgstrom_gpu_service_secret_file,
+							   NULL,
+							   PGC_POSTMASTER,
+							   GUC_NOT_IN_SAMPLE | GUC_SUPERUSER_ONLY,
+							   NULL, NULL, NULL);
 	if (cuda_visible_devices)
 	{
 		if (setenv("CUDA_VISIBLE_DEVICES", cuda_visible_devices, 1) != 0)
 			elog(ERROR, "failed to set CUDA_VISIBLE_DEVICES");
 	}
+	else if (pgstrom_enable_mig_devices &&
+			 !getenv("CUDA_VISIBLE_DEVICES") &&
+			 !gpuServiceIsRemote())
+	{
+		pgstrom_setup_mig_devices();
+	}
 	/* collect device attributes using child process */
 	pgstrom_collect_gpu_devices();
 	if (numGpuDevAttrs > 0)
 	{
 		pgstrom_init_gpu_options();
+		if (pgstrom_gpu_numa_affinity && !gpuServiceIsRemote())
+			pgstrom_setup_gpu_numa_affinity();
 		return true;
 	}
 	return false;
@@ -457,23 +1314,37 @@ pgstrom_init_gpu_device(void)
  * gpuClientOpenSession
  */
 static int
-__gpuClientChooseDevice(const Bitmapset *gpuset)
+__gpuClientChooseDevice(const Bitmapset *gpuset, bool least_loaded)
 {
 	static bool		rr_initialized = false;
 	static uint32	rr_counter = 0;
+	int				num;
+	int			   *dindex;
+	int				i, k;
 
 	if (!rr_initialized)
 	{
 		rr_counter = (uint32)getpid();
 		rr_initialized = true;
 	}
+	gpuset = __gpuWorkloadClassFilter(gpuset);
 
-	if (!bms_is_empty(gpuset))
+	/*
+	 * Candidates are the optimal GPUs for GPU-Direct SQL (that may contain
+	 * GPUs within pg_strom.gpu_distance_slack), the replicas of GpuCache,
+	 * or all the GPUs if no preference.
+	 */
+	if (bms_is_empty(gpuset))
 	{
-		int		num = bms_num_members(gpuset);
-		int	   *dindex = alloca(sizeof(int) * num);
-		int		i, k;
-
+		num = numGpuDevAttrs;
+		dindex = alloca(sizeof(int) * num);
+		for (i=0; i < num; i++)
+			dindex[i] = i;
+	}
+	else
+	{
+		num = bms_num_members(gpuset);
+		dindex = alloca(sizeof(int) * num);
 		for (i=0, k=bms_next_member(gpuset, -1);
 			 k >= 0;
 			 i++, k=bms_next_member(gpuset, k))
@@ -481,20 +1352,65 @@ __gpuClientChooseDevice(const Bitmapset *gpuset)
 			dindex[i] = k;
 		}
 		Assert(i == num);
-		return dindex[rr_counter++ % num];
 	}
-	/* a simple round-robin if no GPUs preference */
-	return (rr_counter++ % numGpuDevAttrs);
+	if (num > 1 && (pgstrom_gpu_load_balance || least_loaded))
+	{
+		/*
+		 * Choose the device with the least load score, but round-robin
+		 * on the tie. GpuCache replicas are always balanced.
+		 */
+		uint32	start = rr_counter++ % num;
+		int		best = dindex[start];
+		double	best_score = gpuServDeviceLoadScore(best);
+
+		for (i=1; i < num; i++)
+		{
+			int		curr = dindex[(start + i) % num];
+			double	score = gpuServDeviceLoadScore(curr);
+
+			if (score < best_score)
+			{
+				best = curr;
+				best_score = score;
+			}
+		}
+		return best;
+	}
+	/* a simple round-robin */
+	return dindex[rr_counter++ % num];
 }
 
-void
-gpuClientOpenSession(pgstromTaskState *pts,
-					 const XpuCommand *session)
+static void
+__gpuClientOpenSessionOne(pgstromTaskState *pts,
+						  const XpuCommand *session,
+						  int cuda_dindex)
 {
 	struct sockaddr_un addr;
 	pgsocket	sockfd;
-	int			cuda_dindex = __gpuClientChooseDevice(pts->optimal_gpus);
 	char		namebuf[32];
+	size_t		cmd_ring_sz = (size_t)pgstrom_gpu_command_ring_size_kb << 10;
+	size_t		resp_ring_sz = (size_t)pgstrom_gpu_result_ring_size_kb << 10;
+
+	if (gpuServiceIsRemote())
+	{
+		/*
+		 * The ring buffers are shared memory segments, so the remote GPU
+		 * service exchanges all the commands over the socket.
+		 */
+		snprintf(namebuf, sizeof(namebuf), "remote-GPU-%d", cuda_dindex);
+		if (xpuClientReuseIdleConnection(pts, session, namebuf, 0, 0))
+			return;
+		sockfd = __gpuServiceConnectRemote(cuda_dindex, false);
+		__xpuClientOpenSession(pts, session, sockfd, namebuf, cuda_dindex,
+							   0, 0, true);
+		return;
+	}
+
+	/* reuse the idle connection kept by the former query, if any */
+	snprintf(namebuf, sizeof(namebuf), "GPU-%d", cuda_dindex);
+	if (xpuClientReuseIdleConnection(pts, session, namebuf,
+									 cmd_ring_sz, resp_ring_sz))
+		return;
 
 	sockfd = socket(AF_UNIX, SOCK_STREAM, 0);
 	if (sockfd < 0)
@@ -510,9 +1426,83 @@ gpuClientOpenSession(pgstromTaskState *pts,
 		close(sockfd);
 		elog(ERROR, "failed on connect('%s'): %m", addr.sun_path);
 	}
-	snprintf(namebuf, sizeof(namebuf), "GPU-%d", cuda_dindex);
+	__xpuClientOpenSession(pts, session, sockfd, namebuf, cuda_dindex,
+						   cmd_ring_sz, resp_ring_sz, true);
+}
+
+void
+gpuClientOpenSession(pgstromTaskState *pts,
+					 const XpuCommand *session)
+{
+	const Bitmapset *gpuset = __gpuWorkloadClassFilter(pts->optimal_gpus);
+
+	/*
+	 * In multi-GPU mode, a session connects to all the candidate GPUs,
+	 * then chunks are dispatched to them. Each GPU setup its own inner
+	 * buffer (replica of the host buffer) and GpuPreAgg final buffer,
+	 * and the partial aggregation results are merged by the CPU.
+	 * GpuCache is resident on a particular device, and parallel scan
+	 * already spreads workers over the GPUs, so we don't use it.
+	 * GpuPreAgg in the complete groups mode also needs a single GPU,
+	 * because the final Aggregate never merges the partial groups.
+	 */
+	if (pgstrom_enable_multi_gpu &&
+		numGpuDevAttrs > 1 &&
+		!pts->gcache_desc &&
+		!pts->pp_info->groupby_complete &&
+		!pts->css.ss.ps.plan->parallel_aware &&
+		(bms_is_empty(gpuset) ||
+		 bms_num_members(gpuset) > 1))
+	{
+		for (int k=0; k < numGpuDevAttrs; k++)
+		{
+			if (bms_is_empty(gpuset) ||
+				bms_is_member(k, gpuset))
+				__gpuClientOpenSessionOne(pts, session, k);
+		}
+	}
+	else
+	{
+		pgstromSharedState *ps_state = pts->ps_state;
+		int			cuda_dindex = -1;
+		bool		shared = false;
 
-	__xpuClientOpenSession(pts, session, sockfd, namebuf, cuda_dindex);
+		/*
+		 * The GPU service shares the inner buffer of GpuJoin and the final
+		 * buffer of GpuPreAgg by the sessions of the same query on the same
+		 * device. So, parallel workers should pick up the same GPU as the
+		 * first one did, rather than spreading the replicas over the GPUs.
+		 */
+		if (pgstrom_gpu_parallel_share_device &&
+			pts->css.ss.ps.plan->parallel_aware &&
+			ps_state != NULL &&
+			!pts->gcache_desc &&
+			(pts->num_rels > 0 ||
+			 (pts->xpu_task_flags & DEVTASK__PREAGG) != 0))
+		{
+			uint32_t	curval = pg_atomic_read_u32(&ps_state->gpu_shared_dindex);
+
+			if (curval > 0)
+				cuda_dindex = curval - 1;
+			shared = true;
+		}
+		if (cuda_dindex < 0)
+		{
+			cuda_dindex = __gpuClientChooseDevice(pts->optimal_gpus,
+												  pts->gcache_desc != NULL);
+			if (shared)
+			{
+				uint32_t	expected = 0;
+
+				/* someone already decided the device concurrently? */
+				if (!pg_atomic_compare_exchange_u32(&ps_state->gpu_shared_dindex,
+													&expected,
+													cuda_dindex + 1))
+					cuda_dindex = expected - 1;
+			}
+		}
+		__gpuClientOpenSessionOne(pts, session, cuda_dindex);
+	}
 }
 
 /*
@@ -612,8 +1602,10 @@ pgstrom_gpu_device_info(PG_FUNCTION_ARGS)
 	}
 	fncxt = SRF_PERCALL_SETUP();
 
-	dindex = fncxt->call_cntr / (lengthof(GpuDevAttrCatalog) + 5);
-	aindex = fncxt->call_cntr % (lengthof(GpuDevAttrCatalog) + 5);
+	dindex = fncxt->call_cntr / (lengthof(GpuDevAttrCatalog) + 7 +
+								 GPUSERV_WORKER_POOL_NATTRS);
+	aindex = fncxt->call_cntr % (lengthof(GpuDevAttrCatalog) + 7 +
+								 GPUSERV_WORKER_POOL_NATTRS);
 	if (dindex >= numGpuDevAttrs)
 		SRF_RETURN_DONE(fncxt);
 	dattrs = &gpuDevAttrs[dindex];
@@ -666,8 +1658,32 @@ pgstrom_gpu_device_info(PG_FUNCTION_ARGS)
 			att_desc = "GPU NUMA Node Id";
 			att_value = psprintf("%d", dattrs->NUMA_NODE_ID);
 			break;
+		case 6:
+			att_name = "DEV_MIG_PARENT_ID";
+			att_desc = "Parent GPU of MIG instance (NVML index)";
+			if (dattrs->DEV_MIG_PARENT_ID < 0)
+				att_value = "-";
+			else
+				att_value = psprintf("%d", dattrs->DEV_MIG_PARENT_ID);
+			break;
+		case 7:
+		case 8:
+		case 9:
+		case 10:
+		case 11:
+			/* status of the GPU worker pool */
+			att_value = gpuservWorkerPoolInfo(dindex, aindex - 7,
+											  &att_name,
+											  &att_desc);
+			if (!att_value)
+			{
+				att_name = "GPUSERV_UNKNOWN";
+				att_desc = "GPU Service: unknown attribute";
+				att_value = "-";
+			}
+			break;
 		default:
-			i = aindex - 6;
+			i = aindex - 7 - GPUSERV_WORKER_POOL_NATTRS;
 			val = *((int *)((char *)dattrs +
 							GpuDevAttrCatalog[i].attr_offset));
 			att_name = GpuDevAttrCatalog[i].attr_label;
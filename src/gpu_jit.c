@@ -0,0 +1,1714 @@
+/*
+ * gpu_jit.c
+ *
+ * NVRTC based JIT compilation of xpucode for hot query shapes
+ * ----
+ * Copyright 2011-2023 (C) KaiGai Kohei <kaigai@kaigai.gr.jp>
+ * Copyright 2014-2023 (C) PG-Strom Developers Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the PostgreSQL License.
+ */
+#include "pg_strom.h"
+#ifdef HAVE_NVRTC
+#include <nvrtc.h>
+#endif
+
+/*
+ * gpuJitModule - a CUDA module that links the JIT compiled xpucode to the
+ * builtin fatbin files. Every callable kern_expression subtree that is
+ * supported by the JIT code generator is translated to a fused device
+ * function, and its address is exported by the pgstrom_jit_entries[].
+ */
+#define GPU_JIT_STATUS__BUILDING	'b'
+#define GPU_JIT_STATUS__READY		'r'
+#define GPU_JIT_STATUS__FAILED		'f'
+
+struct gpuJitModule
+{
+	dlist_node		chain;			/* link to gpu_jit_module_list */
+	int				cuda_dindex;
+	uint64_t		hash;			/* hash value of the source */
+	char		   *source;			/* generated CUDA C source */
+	size_t			source_len;
+	int				refcnt;
+	char			status;			/* one of GPU_JIT_STATUS__* */
+	CUmodule		cuda_module;
+	xpu_function_catalog_entry *func_catalog;	/* sorted by the opcode */
+	int				func_nitems;
+	xpu_type_catalog_entry *type_catalog;		/* sorted by the opcode */
+	int				type_nitems;
+	xpu_function_t *entries;		/* copy of pgstrom_jit_entries[] */
+	int				nentries;
+};
+
+/*
+ * gpuJitBuffer - malloc based string buffer, because code generation
+ * runs on the worker threads of GPU service.
+ */
+typedef struct
+{
+	char	   *data;
+	size_t		len;
+	size_t		size;
+	bool		oom;
+} gpuJitBuffer;
+
+typedef struct
+{
+	const kern_session_info *session;
+	gpuJitBuffer	source;
+	uint32_t	   *entries;		/* offset of the entry kexp from session */
+	int				nentries;
+	int				nrooms;
+	int				nfuncs;			/* sequence number of the functions */
+} gpuJitState;
+
+/* static variables */
+bool		pgstrom_enable_gpu_jit = false;		/* GUC */
+static int	pgstrom_gpu_jit_cache_nslots = 64;	/* GUC */
+static pthread_mutex_t	gpu_jit_module_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t	gpu_jit_module_cond = PTHREAD_COND_INITIALIZER;
+static dlist_head		gpu_jit_module_list;
+
+/*
+ * Catalog of the device types / functions supported by the JIT
+ */
+#define GPU_JIT_TYPE__BOOL		'b'
+#define GPU_JIT_TYPE__INT		'i'
+#define GPU_JIT_TYPE__FLOAT		'f'
+
+typedef struct
+{
+	TypeOpCode	type_code;
+	const char *type_name;
+	const char *type_base;		/* C type of the value */
+	char		type_class;		/* one of GPU_JIT_TYPE__* */
+	int			type_len;
+	const char *type_temp;		/* wider type to check overflow */
+	const char *type_min;
+	const char *type_max;
+} gpuJitTypeInfo;
+
+static const gpuJitTypeInfo gpu_jit_type_catalog[] = {
+	{TypeOpCode__bool,   "bool",   "int8_t",
+	 GPU_JIT_TYPE__BOOL,  1, NULL, NULL, NULL},
+	{TypeOpCode__int1,   "int1",   "int8_t",
+	 GPU_JIT_TYPE__INT,   1, "int16_t",  "SCHAR_MIN", "SCHAR_MAX"},
+	{TypeOpCode__int2,   "int2",   "int16_t",
+	 GPU_JIT_TYPE__INT,   2, "int32_t",  "SHRT_MIN",  "SHRT_MAX"},
+	{TypeOpCode__int4,   "int4",   "int32_t",
+	 GPU_JIT_TYPE__INT,   4, "int64_t",  "INT_MIN",   "INT_MAX"},
+	{TypeOpCode__int8,   "int8",   "int64_t",
+	 GPU_JIT_TYPE__INT,   8, "int128_t", "LLONG_MIN", "LLONG_MAX"},
+	{TypeOpCode__float4, "float4", "float4_t",
+	 GPU_JIT_TYPE__FLOAT, 4, NULL, NULL, NULL},
+	{TypeOpCode__float8, "float8", "float8_t",
+	 GPU_JIT_TYPE__FLOAT, 8, NULL, NULL, NULL},
+	{TypeOpCode__Invalid, NULL, NULL, 0, 0, NULL, NULL, NULL},
+};
+
+static const struct {
+	FuncOpCode	func_code;
+	const char *func_name;
+} gpu_jit_func_names[] = {
+#define FUNC_OPCODE(a,b,c,NAME,d,e)		{FuncOpCode__##NAME, #NAME},
+#include "xpu_opcodes.h"
+	{FuncOpCode__Invalid, NULL},
+};
+
+static const struct {
+	const char *suffix;
+	const char *oper;
+	bool		is_compare;
+} gpu_jit_operators[] = {
+	{"pl",  "+",  false},
+	{"mi",  "-",  false},
+	{"mul", "*",  false},
+	{"div", "/",  false},
+	{"mod", "%",  false},
+	{"eq",  "==", true},
+	{"ne",  "!=", true},
+	{"lt",  "<",  true},
+	{"le",  "<=", true},
+	{"gt",  ">",  true},
+	{"ge",  ">=", true},
+	{NULL,  NULL, false},
+};
+
+static const gpuJitTypeInfo *
+__jitLookupTypeInfo(TypeOpCode type_code)
+{
+	for (int i=0; gpu_jit_type_catalog[i].type_name != NULL; i++)
+	{
+		if (gpu_jit_type_catalog[i].type_code == type_code)
+			return &gpu_jit_type_catalog[i];
+	}
+	return NULL;
+}
+
+static const char *
+__jitLookupFuncName(FuncOpCode func_code)
+{
+	for (int i=0; gpu_jit_func_names[i].func_name != NULL; i++)
+	{
+		if (gpu_jit_func_names[i].func_code == func_code)
+			return gpu_jit_func_names[i].func_name;
+	}
+	return NULL;
+}
+
+/*
+ * __jitLookupOperator
+ *
+ * It checks whether the function is a simple arithmetic or comparison
+ * operator on the integer / floating-point types, like int48pl or float8lt.
+ */
+static int
+__jitLookupOperator(const char *func_name, char type_class)
+{
+	const char *pos = func_name;
+	int			ndigits = 0;
+
+	if (type_class == GPU_JIT_TYPE__INT && strncmp(pos, "int", 3) == 0)
+		pos += 3;
+	else if (type_class == GPU_JIT_TYPE__FLOAT && strncmp(pos, "float", 5) == 0)
+		pos += 5;
+	else
+		return -1;
+	while (*pos == '1' || *pos == '2' || *pos == '4' || *pos == '8')
+	{
+		pos++;
+		ndigits++;
+	}
+	if (ndigits < 1 || ndigits > 2)
+		return -1;
+	for (int i=0; gpu_jit_operators[i].suffix != NULL; i++)
+	{
+		if (strcmp(pos, gpu_jit_operators[i].suffix) == 0)
+			return i;
+	}
+	return -1;
+}
+
+/*
+ * __jitAppend - equivalent to appendStringInfo in PG
+ */
+static void
+__jitAppend(gpuJitBuffer *buf, const char *fmt, ...)
+	pg_attribute_printf(2, 3);
+
+static void
+__jitAppend(gpuJitBuffer *buf, const char *fmt, ...)
+{
+	if (buf->oom)
+		return;
+	for (;;)
+	{
+		va_list		va_args;
+		size_t		avail = buf->size - buf->len;
+		size_t		nbytes;
+		size_t		new_size;
+		char	   *new_data;
+
+		if (avail > 0)
+		{
+			va_start(va_args, fmt);
+			nbytes = vsnprintf(buf->data + buf->len, avail, fmt, va_args);
+			va_end(va_args);
+
+			if (nbytes < avail)
+			{
+				buf->len += nbytes;
+				return;
+			}
+		}
+		else
+			nbytes = 0;
+		new_size = Max(buf->size * 2, buf->len + nbytes + 8192);
+		new_data = realloc(buf->data, new_size);
+		if (!new_data)
+		{
+			buf->oom = true;
+			return;
+		}
+		buf->data = new_data;
+		buf->size = new_size;
+	}
+}
+
+/*
+ * __jitArgumentCall
+ *
+ * It returns the code fragment to evaluate the argument; either the JIT
+ * function or the interpreter.
+ */
+static const char *
+__jitArgumentCall(int fn_id, const char *retval, char *buf, size_t bufsz)
+{
+	if (fn_id >= 0)
+		snprintf(buf, bufsz, "__jit_kexp_%d(kcxt, karg, (xpu_datum_t *)%s)",
+				 fn_id, retval);
+	else
+		snprintf(buf, bufsz, "EXEC_KERN_EXPRESSION(kcxt, karg, %s)", retval);
+	return buf;
+}
+
+static int	__jitCodegenExpression(gpuJitState *js, const kern_expression *kexp);
+static void	__jitCodegenWalker(gpuJitState *js, const kern_expression *kexp);
+
+/*
+ * __jitCodegenArgument
+ *
+ * It generates the code for the argument, or walks on the sub-expressions
+ * if the argument itself is not supported. The argument is evaluated by
+ * the interpreter in the latter case.
+ */
+static int
+__jitCodegenArgument(gpuJitState *js, const kern_expression *karg)
+{
+	int		fn_id = __jitCodegenExpression(js, karg);
+
+	if (fn_id < 0)
+		__jitCodegenWalker(js, karg);
+	return fn_id;
+}
+
+static int
+__jitCodegenFuncHead(gpuJitState *js, const char *label)
+{
+	int		fn_id = js->nfuncs++;
+
+	__jitAppend(&js->source,
+				"/* %s */\n"
+				"STATIC_FUNCTION(bool)\n"
+				"__jit_kexp_%d(XPU_PGFUNCTION_ARGS)\n"
+				"{\n", label, fn_id);
+	return fn_id;
+}
+
+static int
+__jitCodegenConstExpr(gpuJitState *js, const kern_expression *kexp,
+					  const gpuJitTypeInfo *tinfo)
+{
+	const char *addr = kexp->u.c.const_value;
+	int			fn_id = __jitCodegenFuncHead(js, "ConstExpr");
+
+	if (kexp->u.c.const_isnull)
+	{
+		__jitAppend(&js->source,
+					"\t__result->expr_ops = NULL;\n"
+					"\treturn true;\n"
+					"}\n\n");
+		return fn_id;
+	}
+	__jitAppend(&js->source,
+				"\txpu_%s_t *result = (xpu_%s_t *)__result;\n"
+				"\n"
+				"\tresult->expr_ops = &xpu_%s_ops;\n",
+				tinfo->type_name,
+				tinfo->type_name,
+				tinfo->type_name);
+	switch (tinfo->type_code)
+	{
+		case TypeOpCode__bool:
+			__jitAppend(&js->source, "\tresult->value = %s;\n",
+						*((const int8_t *)addr) ? "true" : "false");
+			break;
+		case TypeOpCode__int1:
+			__jitAppend(&js->source, "\tresult->value = %d;\n",
+						(int)*((const int8_t *)addr));
+			break;
+		case TypeOpCode__int2:
+			__jitAppend(&js->source, "\tresult->value = %d;\n",
+						(int)*((const int16_t *)addr));
+			break;
+		case TypeOpCode__int4:
+			__jitAppend(&js->source, "\tresult->value = (int32_t)0x%08xU;\n",
+						*((const uint32_t *)addr));
+			break;
+		case TypeOpCode__int8:
+			__jitAppend(&js->source, "\tresult->value = (int64_t)0x%016lxUL;\n",
+						*((const uint64_t *)addr));
+			break;
+		case TypeOpCode__float4:
+			__jitAppend(&js->source, "\tresult->value = __int_as_float(0x%08x);\n",
+						*((const uint32_t *)addr));
+			break;
+		case TypeOpCode__float8:
+			__jitAppend(&js->source, "\tresult->value = __longlong_as_double((long long)0x%016lxUL);\n",
+						*((const uint64_t *)addr));
+			break;
+		default:
+			/* should not happen */
+			js->source.oom = true;
+			break;
+	}
+	__jitAppend(&js->source,
+				"\treturn true;\n"
+				"}\n\n");
+	return fn_id;
+}
+
+static int
+__jitCodegenVarExpr(gpuJitState *js, const kern_expression *kexp,
+					const gpuJitTypeInfo *tinfo)
+{
+	int		fn_id;
+
+	if (kexp->u.v.var_offset < 0)
+	{
+		if (kexp->u.v.var_slot_id >= js->session->kcxt_kvars_nslots)
+			return -1;
+		fn_id = __jitCodegenFuncHead(js, "VarExpr (kvars-slot)");
+		__jitAppend(&js->source,
+					"\tconst xpu_datum_t *__xdatum = kcxt->kvars_slot[%u];\n"
+					"\n"
+					"\tif (__result != __xdatum)\n"
+					"\t\tmemcpy(__result, __xdatum, sizeof(xpu_%s_t));\n"
+					"\treturn true;\n"
+					"}\n\n",
+					(uint32_t)kexp->u.v.var_slot_id,
+					tinfo->type_name);
+	}
+	else
+	{
+		fn_id = __jitCodegenFuncHead(js, "VarExpr (kvecs-buffer)");
+		__jitAppend(&js->source,
+					"\txpu_%s_t *result = (xpu_%s_t *)__result;\n"
+					"\tconst kvec_%s_t *kvecs = (const kvec_%s_t *)\n"
+					"\t\t(kcxt->kvecs_curr_buffer + %d);\n"
+					"\tuint32_t	kvecs_id = kcxt->kvecs_curr_id;\n"
+					"\n"
+					"\tif (kvecs->isnull[kvecs_id])\n"
+					"\t\tresult->expr_ops = NULL;\n"
+					"\telse\n"
+					"\t{\n"
+					"\t\tresult->expr_ops = &xpu_%s_ops;\n"
+					"\t\tresult->value = kvecs->values[kvecs_id];\n"
+					"\t}\n"
+					"\treturn true;\n"
+					"}\n\n",
+					tinfo->type_name,
+					tinfo->type_name,
+					tinfo->type_name,
+					tinfo->type_name,
+					kexp->u.v.var_offset,
+					tinfo->type_name);
+	}
+	return fn_id;
+}
+
+static int
+__jitCodegenBoolExpr(gpuJitState *js, const kern_expression *kexp)
+{
+	const kern_expression *karg;
+	bool		is_and = (kexp->opcode == FuncOpCode__BoolExpr_And);
+	int		   *arg_ids = alloca(sizeof(int) * kexp->nr_args);
+	int			fn_id;
+	int			i;
+	char		temp[128];
+
+	for (i=0, karg = KEXP_FIRST_ARG(kexp);
+		 i < kexp->nr_args;
+		 i++, karg = KEXP_NEXT_ARG(karg))
+	{
+		if (!__KEXP_IS_VALID(kexp, karg) || karg->exptype != TypeOpCode__bool)
+			return -1;
+	}
+	for (i=0, karg = KEXP_FIRST_ARG(kexp);
+		 i < kexp->nr_args;
+		 i++, karg = KEXP_NEXT_ARG(karg))
+		arg_ids[i] = __jitCodegenArgument(js, karg);
+
+	fn_id = __jitCodegenFuncHead(js, is_and ? "BoolExpr (AND)" : "BoolExpr (OR)");
+	__jitAppend(&js->source,
+				"\txpu_bool_t *result = (xpu_bool_t *)__result;\n"
+				"\tconst kern_expression *karg = KEXP_FIRST_ARG(kexp);\n"
+				"\txpu_bool_t	status;\n"
+				"\tbool		anynull = false;\n"
+				"\n");
+	for (i=0; i < kexp->nr_args; i++)
+	{
+		if (i > 0)
+			__jitAppend(&js->source, "\tkarg = KEXP_NEXT_ARG(karg);\n");
+		__jitAppend(&js->source,
+					"\tif (!%s)\n"
+					"\t\treturn false;\n"
+					"\tif (XPU_DATUM_ISNULL(&status))\n"
+					"\t\tanynull = true;\n"
+					"\telse if (%sstatus.value)\n"
+					"\t{\n"
+					"\t\tresult->expr_ops = &xpu_bool_ops;\n"
+					"\t\tresult->value = %s;\n"
+					"\t\treturn true;\n"
+					"\t}\n",
+					__jitArgumentCall(arg_ids[i], "&status", temp, sizeof(temp)),
+					is_and ? "!" : "",
+					is_and ? "false" : "true");
+	}
+	__jitAppend(&js->source,
+				"\tresult->expr_ops = (anynull ? NULL : &xpu_bool_ops);\n"
+				"\tresult->value = %s;\n"
+				"\treturn true;\n"
+				"}\n\n",
+				is_and ? "true" : "false");
+	return fn_id;
+}
+
+static int
+__jitCodegenBoolTestExpr(gpuJitState *js, const kern_expression *kexp)
+{
+	const kern_expression *karg = KEXP_FIRST_ARG(kexp);
+	const char *label;
+	const char *cond;
+	int			arg_id;
+	int			fn_id;
+	char		temp[128];
+
+	if (kexp->nr_args != 1 ||
+		!__KEXP_IS_VALID(kexp, karg) ||
+		karg->exptype != TypeOpCode__bool)
+		return -1;
+	switch (kexp->opcode)
+	{
+		case FuncOpCode__BoolExpr_Not:
+			label = "BoolExpr (NOT)";
+			cond = NULL;
+			break;
+		case FuncOpCode__BoolTestExpr_IsTrue:
+			label = "BoolTestExpr (IS TRUE)";
+			cond = "(!XPU_DATUM_ISNULL(&status) && status.value)";
+			break;
+		case FuncOpCode__BoolTestExpr_IsNotTrue:
+			label = "BoolTestExpr (IS NOT TRUE)";
+			cond = "(XPU_DATUM_ISNULL(&status) || !status.value)";
+			break;
+		case FuncOpCode__BoolTestExpr_IsFalse:
+			label = "BoolTestExpr (IS FALSE)";
+			cond = "(!XPU_DATUM_ISNULL(&status) && !status.value)";
+			break;
+		case FuncOpCode__BoolTestExpr_IsNotFalse:
+			label = "BoolTestExpr (IS NOT FALSE)";
+			cond = "(XPU_DATUM_ISNULL(&status) || status.value)";
+			break;
+		case FuncOpCode__BoolTestExpr_IsUnknown:
+			label = "BoolTestExpr (IS UNKNOWN)";
+			cond = "XPU_DATUM_ISNULL(&status)";
+			break;
+		case FuncOpCode__BoolTestExpr_IsNotUnknown:
+			label = "BoolTestExpr (IS NOT UNKNOWN)";
+			cond = "!XPU_DATUM_ISNULL(&status)";
+			break;
+		default:
+			return -1;
+	}
+	arg_id = __jitCodegenArgument(js, karg);
+
+	fn_id = __jitCodegenFuncHead(js, label);
+	__jitAppend(&js->source,
+				"\txpu_bool_t *result = (xpu_bool_t *)__result;\n"
+				"\tconst kern_expression *karg = KEXP_FIRST_ARG(kexp);\n"
+				"\txpu_bool_t	status;\n"
+				"\n"
+				"\tif (!%s)\n"
+				"\t\treturn false;\n",
+				__jitArgumentCall(arg_id, "&status", temp, sizeof(temp)));
+	if (!cond)
+		__jitAppend(&js->source,
+					"\tif (XPU_DATUM_ISNULL(&status))\n"
+					"\t\tresult->expr_ops = NULL;\n"
+					"\telse\n"
+					"\t{\n"
+					"\t\tresult->expr_ops = &xpu_bool_ops;\n"
+					"\t\tresult->value = !status.value;\n"
+					"\t}\n");
+	else
+		__jitAppend(&js->source,
+					"\tresult->expr_ops = &xpu_bool_ops;\n"
+					"\tresult->value = %s;\n", cond);
+	__jitAppend(&js->source,
+				"\treturn true;\n"
+				"}\n\n");
+	return fn_id;
+}
+
+static int
+__jitCodegenNullTestExpr(gpuJitState *js, const kern_expression *kexp)
+{
+	const kern_expression *karg = KEXP_FIRST_ARG(kexp);
+	bool		is_null = (kexp->opcode == FuncOpCode__NullTestExpr_IsNull);
+	int			arg_id;
+	int			fn_id;
+	char		temp[128];
+
+	if (kexp->nr_args != 1 || !__KEXP_IS_VALID(kexp, karg))
+		return -1;
+	arg_id = __jitCodegenArgument(js, karg);
+
+	fn_id = __jitCodegenFuncHead(js, is_null
+								 ? "NullTestExpr (IS NULL)"
+								 : "NullTestExpr (IS NOT NULL)");
+	__jitAppend(&js->source,
+				"\txpu_bool_t *result = (xpu_bool_t *)__result;\n"
+				"\tconst kern_expression *karg = KEXP_FIRST_ARG(kexp);\n"
+				"\txpu_datum_t *xdatum = (xpu_datum_t *)\n"
+				"\t\talloca(karg->expr_ops->xpu_type_sizeof);\n"
+				"\n"
+				"\tif (!%s)\n"
+				"\t\treturn false;\n"
+				"\tresult->expr_ops = &xpu_bool_ops;\n"
+				"\tresult->value = %sXPU_DATUM_ISNULL(xdatum);\n"
+				"\treturn true;\n"
+				"}\n\n",
+				__jitArgumentCall(arg_id, "xdatum", temp, sizeof(temp)),
+				is_null ? "" : "!");
+	return fn_id;
+}
+
+/*
+ * __jitCodegenOperator
+ *
+ * It generates the arithmetic / comparison operators on the integer and
+ * floating-point types. Overflow and division-by-zero are checked as
+ * the templates in xpu_basetype.cu doing.
+ */
+static int
+__jitCodegenOperator(gpuJitState *js, const kern_expression *kexp)
+{
+	const kern_expression *karg1 = KEXP_FIRST_ARG(kexp);
+	const kern_expression *karg2;
+	const gpuJitTypeInfo *rinfo;
+	const gpuJitTypeInfo *xinfo;
+	const gpuJitTypeInfo *yinfo;
+	const gpuJitTypeInfo *winfo;
+	const char *func_name;
+	const char *oper;
+	int			oper_id;
+	int			x_id, y_id;
+	int			fn_id;
+	char		temp1[128];
+	char		temp2[128];
+
+	if (kexp->nr_args != 2 || !__KEXP_IS_VALID(kexp, karg1))
+		return -1;
+	karg2 = KEXP_NEXT_ARG(karg1);
+	if (!__KEXP_IS_VALID(kexp, karg2))
+		return -1;
+	if (!(rinfo = __jitLookupTypeInfo(kexp->exptype)) ||
+		!(xinfo = __jitLookupTypeInfo(karg1->exptype)) ||
+		!(yinfo = __jitLookupTypeInfo(karg2->exptype)) ||
+		xinfo->type_class == GPU_JIT_TYPE__BOOL ||
+		xinfo->type_class != yinfo->type_class)
+		return -1;
+	if (!(func_name = __jitLookupFuncName(kexp->opcode)))
+		return -1;
+	oper_id = __jitLookupOperator(func_name, xinfo->type_class);
+	if (oper_id < 0)
+		return -1;
+	oper = gpu_jit_operators[oper_id].oper;
+	if (gpu_jit_operators[oper_id].is_compare)
+	{
+		if (rinfo->type_class != GPU_JIT_TYPE__BOOL)
+			return -1;
+	}
+	else
+	{
+		if (rinfo->type_class != xinfo->type_class ||
+			rinfo->type_len < Max(xinfo->type_len, yinfo->type_len))
+			return -1;
+		/* modulo operator is defined only on the same integer types */
+		if (strcmp(oper, "%") == 0 &&
+			(xinfo->type_class != GPU_JIT_TYPE__INT ||
+			 rinfo != xinfo || rinfo != yinfo))
+			return -1;
+	}
+	x_id = __jitCodegenArgument(js, karg1);
+	y_id = __jitCodegenArgument(js, karg2);
+
+	fn_id = __jitCodegenFuncHead(js, func_name);
+	__jitAppend(&js->source,
+				"\txpu_%s_t *result = (xpu_%s_t *)__result;\n"
+				"\txpu_%s_t	x_val;\n"
+				"\txpu_%s_t	y_val;\n"
+				"\tconst kern_expression *karg = KEXP_FIRST_ARG(kexp);\n"
+				"\n"
+				"\tif (!%s)\n"
+				"\t\treturn false;\n"
+				"\tkarg = KEXP_NEXT_ARG(karg);\n"
+				"\tif (!%s)\n"
+				"\t\treturn false;\n",
+				rinfo->type_name,
+				rinfo->type_name,
+				xinfo->type_name,
+				yinfo->type_name,
+				__jitArgumentCall(x_id, "&x_val", temp1, sizeof(temp1)),
+				__jitArgumentCall(y_id, "&y_val", temp2, sizeof(temp2)));
+
+	if (gpu_jit_operators[oper_id].is_compare)
+	{
+		/* comparison in the wider type */
+		winfo = (xinfo->type_len >= yinfo->type_len ? xinfo : yinfo);
+		__jitAppend(&js->source,
+					"\tif (XPU_DATUM_ISNULL(&x_val) || XPU_DATUM_ISNULL(&y_val))\n"
+					"\t{\n"
+					"\t\t__pg_simple_nullcomp_%s(&x_val,&y_val);\n"
+					"\t}\n"
+					"\telse\n"
+					"\t{\n"
+					"\t\tresult->expr_ops = &xpu_bool_ops;\n"
+					"\t\tresult->value = ((%s)x_val.value %s (%s)y_val.value);\n"
+					"\t}\n",
+					gpu_jit_operators[oper_id].suffix,
+					winfo->type_base, oper, winfo->type_base);
+	}
+	else if (xinfo->type_class == GPU_JIT_TYPE__INT && strcmp(oper, "/") == 0)
+	{
+		__jitAppend(&js->source,
+					"\tif (XPU_DATUM_ISNULL(&x_val) || XPU_DATUM_ISNULL(&y_val))\n"
+					"\t\tresult->expr_ops = NULL;\n"
+					"\telse\n"
+					"\t{\n"
+					"\t\tif (y_val.value == 0)\n"
+					"\t\t{\n"
+					"\t\t\tSTROM_ELOG(kcxt, \"%s: division by zero\");\n"
+					"\t\t\treturn false;\n"
+					"\t\t}\n",
+					func_name);
+		/* if overflow may happen */
+		if (rinfo == xinfo)
+			__jitAppend(&js->source,
+						"\t\tif (y_val.value == -1)\n"
+						"\t\t{\n"
+						"\t\t\tif (x_val.value == %s)\n"
+						"\t\t\t{\n"
+						"\t\t\t\tSTROM_ELOG(kcxt, \"%s: value out of range\");\n"
+						"\t\t\t\treturn false;\n"
+						"\t\t\t}\n"
+						"\t\t\tresult->value = -x_val.value;\n"
+						"\t\t}\n"
+						"\t\telse\n"
+						"\t\t\tresult->value = x_val.value / y_val.value;\n",
+						rinfo->type_min,
+						func_name);
+		else
+			__jitAppend(&js->source,
+						"\t\tresult->value = x_val.value / y_val.value;\n");
+		__jitAppend(&js->source,
+					"\t\tresult->expr_ops = &xpu_%s_ops;\n"
+					"\t}\n",
+					rinfo->type_name);
+	}
+	else if (xinfo->type_class == GPU_JIT_TYPE__INT && strcmp(oper, "%") == 0)
+	{
+		__jitAppend(&js->source,
+					"\tif (XPU_DATUM_ISNULL(&x_val) || XPU_DATUM_ISNULL(&y_val))\n"
+					"\t\tresult->expr_ops = NULL;\n"
+					"\telse\n"
+					"\t{\n"
+					"\t\tif (y_val.value == 0)\n"
+					"\t\t{\n"
+					"\t\t\tSTROM_ELOG(kcxt, \"%smod : division by zero\");\n"
+					"\t\t\treturn false;\n"
+					"\t\t}\n"
+					"\t\tresult->expr_ops = &xpu_%s_ops;\n"
+					"\t\tresult->value = x_val.value %% y_val.value;\n"
+					"\t}\n",
+					rinfo->type_name,
+					rinfo->type_name);
+	}
+	else if (xinfo->type_class == GPU_JIT_TYPE__INT)
+	{
+		__jitAppend(&js->source,
+					"\tif (XPU_DATUM_ISNULL(&x_val) || XPU_DATUM_ISNULL(&y_val))\n"
+					"\t\tresult->expr_ops = NULL;\n"
+					"\telse\n"
+					"\t{\n"
+					"\t\t%s r = (%s)x_val.value %s (%s)y_val.value;\n"
+					"\n"
+					"\t\tif (r < (%s)%s || r > (%s)%s)\n"
+					"\t\t{\n"
+					"\t\t\tSTROM_ELOG(kcxt, \"%s: value out of range\");\n"
+					"\t\t\treturn false;\n"
+					"\t\t}\n"
+					"\t\tresult->expr_ops = &xpu_%s_ops;\n"
+					"\t\tresult->value = r;\n"
+					"\t}\n",
+					rinfo->type_temp, rinfo->type_temp, oper, rinfo->type_temp,
+					rinfo->type_temp, rinfo->type_min,
+					rinfo->type_temp, rinfo->type_max,
+					func_name,
+					rinfo->type_name);
+	}
+	else if (strcmp(oper, "/") == 0)
+	{
+		__jitAppend(&js->source,
+					"\tif (XPU_DATUM_ISNULL(&x_val) || XPU_DATUM_ISNULL(&y_val))\n"
+					"\t\tresult->expr_ops = NULL;\n"
+					"\telse\n"
+					"\t{\n"
+					"\t\tif (y_val.value == 0.0)\n"
+					"\t\t{\n"
+					"\t\t\tSTROM_ELOG(kcxt, \"%s: division by zero\");\n"
+					"\t\t\treturn false;\n"
+					"\t\t}\n"
+					"\t\tresult->value = ((%s)x_val.value / (%s)y_val.value);\n"
+					"\t\t/* CHECKFLOATVAL */\n"
+					"\t\tif ((isinf(result->value) && (!isinf(x_val.value) &&\n"
+					"\t\t\t\t\t\t\t\t\t  !isinf(y_val.value))) ||\n"
+					"\t\t\t(result->value == 0.0 && x_val.value != 0.0))\n"
+					"\t\t{\n"
+					"\t\t\tSTROM_ELOG(kcxt, \"%s: value out of range\");\n"
+					"\t\t\treturn false;\n"
+					"\t\t}\n"
+					"\t\tresult->expr_ops = &xpu_%s_ops;\n"
+					"\t}\n",
+					func_name,
+					rinfo->type_base, rinfo->type_base,
+					func_name,
+					rinfo->type_name);
+	}
+	else
+	{
+		__jitAppend(&js->source,
+					"\tif (XPU_DATUM_ISNULL(&x_val) || XPU_DATUM_ISNULL(&y_val))\n"
+					"\t\tresult->expr_ops = NULL;\n"
+					"\telse\n"
+					"\t{\n"
+					"\t\tresult->expr_ops = &xpu_%s_ops;\n"
+					"\t\tresult->value = ((%s)x_val.value %s (%s)y_val.value);\n"
+					"\t\tif (isinf(result->value) &&\n"
+					"\t\t\t!isinf(x_val.value) &&\n"
+					"\t\t\t!isinf(y_val.value))\n"
+					"\t\t{\n"
+					"\t\t\tSTROM_ELOG(kcxt, \"%s: value out of range\");\n"
+					"\t\t\treturn false;\n"
+					"\t\t}\n"
+					"\t}\n",
+					rinfo->type_name,
+					rinfo->type_base, oper, rinfo->type_base,
+					func_name);
+	}
+	__jitAppend(&js->source,
+				"\treturn true;\n"
+				"}\n\n");
+	return fn_id;
+}
+
+/*
+ * __jitCodegenUserFunc
+ *
+ * It generates the caller of the user-defined device function. The source
+ * is embedded in the kern_expression, and emitted once per module prior to
+ * the first caller. The device function must be declared as follows:
+ *
+ *   STATIC_FUNCTION(bool)
+ *   SYMBOL(kern_context *kcxt, RTYPE *result, ATYPE1 arg1, ...)
+ *
+ * It returns false with STROM_ELOG() or STROM_CPU_FALLBACK() on errors.
+ * The SQL function is strict, so NULL arguments give NULL without the call.
+ */
+#define GPU_JIT_USER_FUNC_MAX_NARGS		16
+
+static int
+__jitCodegenUserFunc(gpuJitState *js, const kern_expression *kexp)
+{
+	const kern_expression *karg;
+	const gpuJitTypeInfo *rinfo;
+	const gpuJitTypeInfo *ainfo[GPU_JIT_USER_FUNC_MAX_NARGS];
+	int			arg_ids[GPU_JIT_USER_FUNC_MAX_NARGS];
+	const char *symbol = kexp->u.udf.data;
+	const char *source = symbol + strlen(symbol) + 1;
+	char		marker[80];
+	char		temp[128];
+	int			fn_id, i;
+
+	if (kexp->nr_args > GPU_JIT_USER_FUNC_MAX_NARGS ||
+		!(rinfo = __jitLookupTypeInfo(kexp->exptype)))
+		return -1;
+	for (i=0, karg = KEXP_FIRST_ARG(kexp);
+		 i < kexp->nr_args;
+		 i++, karg = KEXP_NEXT_ARG(karg))
+	{
+		if (!__KEXP_IS_VALID(kexp, karg) ||
+			!(ainfo[i] = __jitLookupTypeInfo(karg->exptype)))
+			return -1;
+	}
+	for (i=0, karg = KEXP_FIRST_ARG(kexp);
+		 i < kexp->nr_args;
+		 i++, karg = KEXP_NEXT_ARG(karg))
+		arg_ids[i] = __jitCodegenArgument(js, karg);
+
+	snprintf(marker, sizeof(marker),
+			 "/* user-defined device function (oid=%u) */",
+			 kexp->u.udf.func_oid);
+	if (!js->source.data || !strstr(js->source.data, marker))
+		__jitAppend(&js->source, "%s
+%s
+
+", marker, source);
+
+	fn_id = __jitCodegenFuncHead(js, symbol);
+	__jitAppend(&js->source,
+				"	xpu_%s_t *result = (xpu_%s_t *)__result;
+",
+				rinfo->type_name,
+				rinfo->type_name);
+	for (i=0; i < kexp->nr_args; i++)
+		__jitAppend(&js->source,
+					"	xpu_%s_t	arg%d;
+",
+					ainfo[i]->type_name, i);
+	if (kexp->nr_args > 0)
+		__jitAppend(&js->source,
+					"	const kern_expression *karg = KEXP_FIRST_ARG(kexp);
+");
+	__jitAppend(&js->source, "
+");
+	for (i=0; i < kexp->nr_args; i++)
+	{
+		char	retval[40];
+
+		if (i > 0)
+			__jitAppend(&js->source, "	karg = KEXP_NEXT_ARG(karg);
+");
+		snprintf(retval, sizeof(retval), "&arg%d", i);
+		__jitAppend(&js->source,
+					"	if (!%s)
+"
+					"		return false;
+",
+					__jitArgumentCall(arg_ids[i], retval, temp, sizeof(temp)));
+	}
+	if (kexp->nr_args > 0)
+	{
+		__jitAppend(&js->source, "	if (");
+		for (i=0; i < kexp->nr_args; i++)
+			__jitAppend(&js->source, "%sXPU_DATUM_ISNULL(&arg%d)",
+						i > 0 ? " ||
+		" : "", i);
+		__jitAppend(&js->source,
+					")
+"
+					"	{
+"
+					"		result->expr_ops = NULL;
+"
+					"		return true;
+"
+					"	}
+");
+	}
+	__jitAppend(&js->source, "	if (!%s(kcxt, &result->value", symbol);
+	for (i=0; i < kexp->nr_args; i++)
+		__jitAppend(&js->source, ", arg%d.value", i);
+	__jitAppend(&js->source,
+				"))
+"
+				"		return false;
+"
+				"	result->expr_ops = &xpu_%s_ops;
+"
+				"	return true;
+"
+				"}
+
+",
+				rinfo->type_name);
+	return fn_id;
+}
+
+/*
+ * __jitCodegenExpression
+ *
+ * It generates a device function for the supplied kern_expression, then
+ * returns its sequence number. Elsewhere, it returns -1 without any code,
+ * if the expression is not supported by the JIT code generator.
+ */
+static int
+__jitCodegenExpression(gpuJitState *js, const kern_expression *kexp)
+{
+	const gpuJitTypeInfo *tinfo;
+
+	switch (kexp->opcode)
+	{
+		case FuncOpCode__ConstExpr:
+			if (!(tinfo = __jitLookupTypeInfo(kexp->exptype)))
+				return -1;
+			return __jitCodegenConstExpr(js, kexp, tinfo);
+
+		case FuncOpCode__VarExpr:
+			if (!(tinfo = __jitLookupTypeInfo(kexp->exptype)))
+				return -1;
+			return __jitCodegenVarExpr(js, kexp, tinfo);
+
+		case FuncOpCode__BoolExpr_And:
+		case FuncOpCode__BoolExpr_Or:
+			if (kexp->exptype != TypeOpCode__bool || kexp->nr_args < 2)
+				return -1;
+			/* run-time reordering needs the interpreter */
+			if ((kexp->expflags & KEXP_FLAG__ADAPTIVE_ORDER) != 0)
+				return -1;
+			return __jitCodegenBoolExpr(js, kexp);
+
+		case FuncOpCode__BoolExpr_Not:
+		case FuncOpCode__BoolTestExpr_IsTrue:
+		case FuncOpCode__BoolTestExpr_IsNotTrue:
+		case FuncOpCode__BoolTestExpr_IsFalse:
+		case FuncOpCode__BoolTestExpr_IsNotFalse:
+		case FuncOpCode__BoolTestExpr_IsUnknown:
+		case FuncOpCode__BoolTestExpr_IsNotUnknown:
+			if (kexp->exptype != TypeOpCode__bool)
+				return -1;
+			return __jitCodegenBoolTestExpr(js, kexp);
+
+		case FuncOpCode__NullTestExpr_IsNull:
+		case FuncOpCode__NullTestExpr_IsNotNull:
+			if (kexp->exptype != TypeOpCode__bool)
+				return -1;
+			return __jitCodegenNullTestExpr(js, kexp);
+
+		case FuncOpCode__UserDefinedFunc:
+			return __jitCodegenUserFunc(js, kexp);
+
+		default:
+			return __jitCodegenOperator(js, kexp);
+	}
+}
+
+/*
+ * __jitCodegenWalker
+ *
+ * It walks on the kern_expression tree to find out the largest subtrees
+ * that are supported by the JIT code generator. Each of them becomes an
+ * entry of the JIT module, then fn_dptr of the top-level kern_expression
+ * shall be replaced by the fused device function.
+ */
+static void
+__jitCodegenWalker(gpuJitState *js, const kern_expression *kexp)
+{
+	const kern_expression *karg;
+	int		fn_id;
+	int		i;
+
+	if (!kexp)
+		return;
+	fn_id = __jitCodegenExpression(js, kexp);
+	if (fn_id >= 0)
+	{
+		/*
+		 * VarExpr and ConstExpr alone are not worth to replace, but
+		 * user-defined device functions exist only in the JIT module.
+		 */
+		if (kexp->nr_args == 0 &&
+			kexp->opcode != FuncOpCode__UserDefinedFunc)
+			return;
+		if (js->nentries >= js->nrooms)
+		{
+			int		nrooms = 2 * js->nrooms + 20;
+			uint32_t *entries = realloc(js->entries,
+										sizeof(uint32_t) * nrooms);
+			if (!entries)
+			{
+				js->source.oom = true;
+				return;
+			}
+			js->entries = entries;
+			js->nrooms = nrooms;
+		}
+		js->entries[js->nentries++] = ((char *)kexp - (char *)js->session);
+		__jitAppend(&js->source, "#define __JIT_ENTRY_%d		__jit_kexp_%d\n\n",
+					js->nentries - 1, fn_id);
+		return;
+	}
+	/* not supported, so walks on the sub-expressions */
+	if (kexp->opcode == FuncOpCode__CaseWhenExpr)
+	{
+		if (kexp->u.casewhen.case_comp)
+		{
+			karg = (const kern_expression *)
+				((char *)kexp + kexp->u.casewhen.case_comp);
+			if (__KEXP_IS_VALID(kexp, karg))
+				__jitCodegenWalker(js, karg);
+		}
+		if (kexp->u.casewhen.case_else)
+		{
+			karg = (const kern_expression *)
+				((char *)kexp + kexp->u.casewhen.case_else);
+			if (__KEXP_IS_VALID(kexp, karg))
+				__jitCodegenWalker(js, karg);
+		}
+	}
+	for (i=0, karg = KEXP_FIRST_ARG(kexp);
+		 i < kexp->nr_args;
+		 i++, karg = KEXP_NEXT_ARG(karg))
+	{
+		if (!__KEXP_IS_VALID(kexp, karg))
+			break;
+		__jitCodegenWalker(js, karg);
+	}
+}
+
+/*
+ * __jitCodegenSession
+ *
+ * It generates the CUDA C source for the xpucode of the session.
+ */
+static bool
+__jitCodegenSession(gpuJitState *js, const kern_session_info *session)
+{
+	const kern_expression *__kexp[20];
+	int		nitems = 0;
+
+	__kexp[nitems++] = SESSION_KEXP_LOAD_VARS(session, -1);
+	__kexp[nitems++] = SESSION_KEXP_MOVE_VARS(session, -1);
+	__kexp[nitems++] = SESSION_KEXP_SCAN_QUALS(session);
+	__kexp[nitems++] = SESSION_KEXP_JOIN_QUALS(session, -1);
+	__kexp[nitems++] = SESSION_KEXP_HASH_VALUE(session, -1);
+	__kexp[nitems++] = SESSION_KEXP_GIST_EVALS(session, -1);
+	__kexp[nitems++] = SESSION_KEXP_PROJECTION(session);
+	__kexp[nitems++] = SESSION_KEXP_GROUPBY_KEYHASH(session);
+	__kexp[nitems++] = SESSION_KEXP_GROUPBY_KEYLOAD(session);
+	__kexp[nitems++] = SESSION_KEXP_GROUPBY_KEYCOMP(session);
+	__kexp[nitems++] = SESSION_KEXP_GROUPBY_ACTIONS(session);
+
+	js->session = session;
+	__jitAppend(&js->source,
+				"/*\n"
+				" * JIT compiled xpucode by PG-Strom " PGSTROM_VERSION "\n"
+				" */\n"
+				"#include \"cuda_common.h\"\n"
+				"\n");
+	for (int i=0; i < nitems; i++)
+		__jitCodegenWalker(js, __kexp[i]);
+	if (js->nentries > 0)
+	{
+		__jitAppend(&js->source,
+					"PUBLIC_DATA xpu_function_t pgstrom_jit_entries[] = {\n");
+		for (int i=0; i < js->nentries; i++)
+			__jitAppend(&js->source, "\t__JIT_ENTRY_%d,\n", i);
+		__jitAppend(&js->source, "};\n");
+	}
+	return !js->source.oom;
+}
+
+/*
+ * __gpuJitCompileSource
+ *
+ * It compiles the generated source to PTX using NVRTC
+ */
+#ifdef HAVE_NVRTC
+static char *
+__gpuJitCompileSource(int cuda_dindex,
+					  const char *source,
+					  size_t *p_ptx_length,
+					  char *emsg, size_t emsg_sz)
+{
+	GpuDevAttributes *dattrs = &gpuDevAttrs[cuda_dindex];
+	nvrtcProgram prog;
+	nvrtcResult	rv;
+	const char *options[20];
+	int			nr_options = 0;
+	char		arch_buf[80];
+	char		maxreg_buf[80];
+	char	   *ptx_image = NULL;
+	size_t		ptx_length;
+
+	snprintf(arch_buf, sizeof(arch_buf),
+			 "--gpu-architecture=compute_%d%d",
+			 dattrs->COMPUTE_CAPABILITY_MAJOR,
+			 dattrs->COMPUTE_CAPABILITY_MINOR);
+	snprintf(maxreg_buf, sizeof(maxreg_buf),
+			 "--maxrregcount=%d", CUDA_MAXREGCOUNT);
+	options[nr_options++] = arch_buf;
+	options[nr_options++] = maxreg_buf;
+	options[nr_options++] = "--relocatable-device-code=true";
+	options[nr_options++] = "--generate-line-info";
+	options[nr_options++] = "-DHAVE_FLOAT2";
+	options[nr_options++] = "--include-path=" PGSHAREDIR "/pg_strom";
+	options[nr_options++] = "--include-path=" PGINCLUDEDIR_SERVER;
+	options[nr_options++] = "--include-path=" CUDA_INCLUDE_PATH;
+	/* NVRTC does not know the system headers, unlike nvcc */
+	options[nr_options++] = "--include-path=/usr/include";
+
+	rv = nvrtcCreateProgram(&prog, source, "pgstrom_jit.cu", 0, NULL, NULL);
+	if (rv != NVRTC_SUCCESS)
+	{
+		snprintf(emsg, emsg_sz, "failed on nvrtcCreateProgram: %s",
+				 nvrtcGetErrorString(rv));
+		return NULL;
+	}
+	rv = nvrtcCompileProgram(prog, nr_options, options);
+	if (rv != NVRTC_SUCCESS)
+	{
+		size_t	log_sz;
+		char   *log_buf = NULL;
+
+		if (nvrtcGetProgramLogSize(prog, &log_sz) == NVRTC_SUCCESS &&
+			(log_buf = malloc(log_sz + 1)) != NULL &&
+			nvrtcGetProgramLog(prog, log_buf) == NVRTC_SUCCESS)
+			log_buf[log_sz] = '\0';
+		snprintf(emsg, emsg_sz, "failed on nvrtcCompileProgram: %s\n%s",
+				 nvrtcGetErrorString(rv), log_buf ? log_buf : "");
+		free(log_buf);
+		goto bailout;
+	}
+	rv = nvrtcGetPTXSize(prog, &ptx_length);
+	if (rv != NVRTC_SUCCESS)
+	{
+		snprintf(emsg, emsg_sz, "failed on nvrtcGetPTXSize: %s",
+				 nvrtcGetErrorString(rv));
+		goto bailout;
+	}
+	ptx_image = malloc(ptx_length);
+	if (!ptx_image)
+	{
+		snprintf(emsg, emsg_sz, "out of memory");
+		goto bailout;
+	}
+	rv = nvrtcGetPTX(prog, ptx_image);
+	if (rv != NVRTC_SUCCESS)
+	{
+		snprintf(emsg, emsg_sz, "failed on nvrtcGetPTX: %s",
+				 nvrtcGetErrorString(rv));
+		free(ptx_image);
+		ptx_image = NULL;
+		goto bailout;
+	}
+	*p_ptx_length = ptx_length;
+bailout:
+	nvrtcDestroyProgram(&prog);
+	return ptx_image;
+}
+#else	/* HAVE_NVRTC */
+static char *
+__gpuJitCompileSource(int cuda_dindex,
+					  const char *source,
+					  size_t *p_ptx_length,
+					  char *emsg, size_t emsg_sz)
+{
+	snprintf(emsg, emsg_sz, "PG-Strom is built without NVRTC");
+	return NULL;
+}
+#endif	/* HAVE_NVRTC */
+
+/*
+ * __gpuJitFetchGlobal
+ */
+static void *
+__gpuJitFetchGlobal(CUmodule cuda_module, const char *symbol,
+					size_t *p_nbytes, char *emsg, size_t emsg_sz)
+{
+	CUdeviceptr	dptr;
+	CUresult	rc;
+	size_t		nbytes;
+	void	   *buffer;
+
+	rc = cuModuleGetGlobal(&dptr, &nbytes, cuda_module, symbol);
+	if (rc != CUDA_SUCCESS)
+	{
+		snprintf(emsg, emsg_sz, "failed on cuModuleGetGlobal('%s'): %s",
+				 symbol, cuStrError(rc));
+		return NULL;
+	}
+	buffer = malloc(nbytes);
+	if (!buffer)
+	{
+		snprintf(emsg, emsg_sz, "out of memory");
+		return NULL;
+	}
+	rc = cuMemcpyDtoH(buffer, dptr, nbytes);
+	if (rc != CUDA_SUCCESS)
+	{
+		snprintf(emsg, emsg_sz, "failed on cuMemcpyDtoH: %s", cuStrError(rc));
+		free(buffer);
+		return NULL;
+	}
+	*p_nbytes = nbytes;
+	return buffer;
+}
+
+static int
+__gpuJitFuncCatalogComp(const void *__a, const void *__b)
+{
+	const xpu_function_catalog_entry *a = __a;
+	const xpu_function_catalog_entry *b = __b;
+
+	if (a->func_opcode < b->func_opcode)
+		return -1;
+	if (a->func_opcode > b->func_opcode)
+		return 1;
+	return 0;
+}
+
+static int
+__gpuJitTypeCatalogComp(const void *__a, const void *__b)
+{
+	const xpu_type_catalog_entry *a = __a;
+	const xpu_type_catalog_entry *b = __b;
+
+	if (a->type_opcode < b->type_opcode)
+		return -1;
+	if (a->type_opcode > b->type_opcode)
+		return 1;
+	return 0;
+}
+
+/*
+ * __gpuJitBuildModule
+ */
+static bool
+__gpuJitBuildModule(gpuJitModule *jmod, int nentries,
+					int shmem_sz_dynamic,
+					char *emsg, size_t emsg_sz)
+{
+	CUfunction	cuda_function;
+	CUresult	rc;
+	char	   *ptx_image;
+	size_t		ptx_length;
+	size_t		nbytes;
+	bool		ok;
+
+	ptx_image = __gpuJitCompileSource(jmod->cuda_dindex,
+									  jmod->source,
+									  &ptx_length,
+									  emsg, emsg_sz);
+	if (!ptx_image)
+		return false;
+	ok = gpuservLinkGpuModule(&jmod->cuda_module,
+							  ptx_image, ptx_length,
+							  emsg, emsg_sz);
+	free(ptx_image);
+	if (!ok)
+		return false;
+
+	/* setup XPU linkage catalogs */
+	jmod->func_catalog = __gpuJitFetchGlobal(jmod->cuda_module,
+											 "builtin_xpu_functions_catalog",
+											 &nbytes, emsg, emsg_sz);
+	if (!jmod->func_catalog)
+		return false;
+	while (jmod->func_catalog[jmod->func_nitems].func_opcode != FuncOpCode__Invalid)
+		jmod->func_nitems++;
+	qsort(jmod->func_catalog, jmod->func_nitems,
+		  sizeof(xpu_function_catalog_entry),
+		  __gpuJitFuncCatalogComp);
+
+	jmod->type_catalog = __gpuJitFetchGlobal(jmod->cuda_module,
+											 "builtin_xpu_types_catalog",
+											 &nbytes, emsg, emsg_sz);
+	if (!jmod->type_catalog)
+		return false;
+	while (jmod->type_catalog[jmod->type_nitems].type_opcode != TypeOpCode__Invalid)
+		jmod->type_nitems++;
+	qsort(jmod->type_catalog, jmod->type_nitems,
+		  sizeof(xpu_type_catalog_entry),
+		  __gpuJitTypeCatalogComp);
+
+	jmod->entries = __gpuJitFetchGlobal(jmod->cuda_module,
+										"pgstrom_jit_entries",
+										&nbytes, emsg, emsg_sz);
+	if (!jmod->entries)
+		return false;
+	jmod->nentries = nbytes / sizeof(xpu_function_t);
+	if (jmod->nentries != nentries)
+	{
+		snprintf(emsg, emsg_sz, "Bug? number of JIT entries mismatch (%d of %d)",
+				 jmod->nentries, nentries);
+		return false;
+	}
+
+	/* adjust shared memory configuration, like the builtin module */
+	rc = cuModuleGetFunction(&cuda_function, jmod->cuda_module,
+							 "kern_gpujoin_main");
+	if (rc != CUDA_SUCCESS)
+	{
+		snprintf(emsg, emsg_sz, "failed on cuModuleGetFunction: %s",
+				 cuStrError(rc));
+		return false;
+	}
+	rc = cuFuncSetAttribute(cuda_function,
+							CU_FUNC_ATTRIBUTE_MAX_DYNAMIC_SHARED_SIZE_BYTES,
+							shmem_sz_dynamic);
+	if (rc != CUDA_SUCCESS)
+	{
+		snprintf(emsg, emsg_sz, "failed on cuFuncSetAttribute(MAX_DYNAMIC_SHARED_SIZE_BYTES, %d): %s",
+				 shmem_sz_dynamic, cuStrError(rc));
+		return false;
+	}
+	return true;
+}
+
+/*
+ * __gpuJitReleaseModule
+ */
+static void
+__gpuJitReleaseModule(gpuJitModule *jmod)
+{
+	if (jmod->cuda_module)
+		cuModuleUnload(jmod->cuda_module);
+	free(jmod->func_catalog);
+	free(jmod->type_catalog);
+	free(jmod->entries);
+	free(jmod->source);
+	free(jmod);
+}
+
+/*
+ * __gpuJitEvictModulesNoLock
+ *
+ * It releases the least recently used modules of the device, if the number
+ * of cached modules exceeds pg_strom.gpu_jit_cache_nslots.
+ */
+static void
+__gpuJitEvictModulesNoLock(int cuda_dindex)
+{
+	dlist_iter	iter;
+	dlist_node *dnode;
+	dlist_node *prev;
+	int			count = 0;
+
+	dlist_foreach(iter, &gpu_jit_module_list)
+	{
+		gpuJitModule *jmod = dlist_container(gpuJitModule, chain, iter.cur);
+
+		if (jmod->cuda_dindex == cuda_dindex)
+			count++;
+	}
+	/* walk from the tail, because its head is the most recently used one */
+	for (dnode = gpu_jit_module_list.head.prev;
+		 dnode != &gpu_jit_module_list.head &&
+		 count >= pgstrom_gpu_jit_cache_nslots;
+		 dnode = prev)
+	{
+		gpuJitModule *jmod = dlist_container(gpuJitModule, chain, dnode);
+
+		prev = dnode->prev;
+		if (jmod->cuda_dindex != cuda_dindex ||
+			jmod->refcnt > 0 ||
+			jmod->status == GPU_JIT_STATUS__BUILDING)
+			continue;
+		dlist_delete(&jmod->chain);
+		__gpuJitReleaseModule(jmod);
+		count--;
+	}
+}
+
+/*
+ * gpuJitGetModule
+ *
+ * It looks up the JIT module for the xpucode of the session, or builds
+ * a new one at the first time. The offset of the kern_expression to be
+ * replaced by the JIT entries are returned by *p_jit_entries. NULL means
+ * the xpucode shall be run by the interpreter; the reason is set on the
+ * emsg, if it is a failure.
+ */
+gpuJitModule *
+gpuJitGetModule(int cuda_dindex,
+				int shmem_sz_dynamic,
+				const kern_session_info *session,
+				uint32_t **p_jit_entries,
+				char *emsg, size_t emsg_sz)
+{
+	gpuJitState	js;
+	gpuJitModule *jmod;
+	dlist_iter	iter;
+	uint64_t	hash;
+	bool		ok;
+
+#ifndef HAVE_NVRTC
+	/* no JIT compiler, so the builtin fatbin shall be used as is */
+	snprintf(emsg, emsg_sz, "PG-Strom is built without NVRTC");
+	return NULL;
+#endif
+	memset(&js, 0, sizeof(gpuJitState));
+	if (!__jitCodegenSession(&js, session))
+	{
+		snprintf(emsg, emsg_sz, "out of memory during JIT code generation");
+		goto bailout;
+	}
+	if (js.nentries == 0)
+		goto bailout;		/* nothing to be specialized */
+	hash = hash_bytes_extended((unsigned char *)js.source.data,
+							   js.source.len, cuda_dindex);
+
+	pthreadMutexLock(&gpu_jit_module_lock);
+retry:
+	dlist_foreach(iter, &gpu_jit_module_list)
+	{
+		jmod = dlist_container(gpuJitModule, chain, iter.cur);
+
+		if (jmod->cuda_dindex == cuda_dindex &&
+			jmod->hash == hash &&
+			jmod->source_len == js.source.len &&
+			memcmp(jmod->source, js.source.data, js.source.len) == 0)
+		{
+			if (jmod->status == GPU_JIT_STATUS__BUILDING)
+			{
+				/* someone is now building the module */
+				pthreadCondWait(&gpu_jit_module_cond, &gpu_jit_module_lock);
+				goto retry;
+			}
+			if (jmod->status != GPU_JIT_STATUS__READY)
+			{
+				/* already failed once, so don't try again */
+				pthreadMutexUnlock(&gpu_jit_module_lock);
+				goto bailout;
+			}
+			jmod->refcnt++;
+			dlist_move_head(&gpu_jit_module_list, &jmod->chain);
+			pthreadMutexUnlock(&gpu_jit_module_lock);
+			goto found;
+		}
+	}
+	/* not found, so build a new one */
+	__gpuJitEvictModulesNoLock(cuda_dindex);
+	jmod = calloc(1, sizeof(gpuJitModule));
+	if (!jmod)
+	{
+		pthreadMutexUnlock(&gpu_jit_module_lock);
+		snprintf(emsg, emsg_sz, "out of memory");
+		goto bailout;
+	}
+	jmod->cuda_dindex = cuda_dindex;
+	jmod->hash = hash;
+	jmod->source = js.source.data;
+	jmod->source_len = js.source.len;
+	jmod->refcnt = 1;
+	jmod->status = GPU_JIT_STATUS__BUILDING;
+	dlist_push_head(&gpu_jit_module_list, &jmod->chain);
+	js.source.data = NULL;		/* moved to jmod */
+	pthreadMutexUnlock(&gpu_jit_module_lock);
+
+	ok = __gpuJitBuildModule(jmod, js.nentries,
+							 shmem_sz_dynamic,
+							 emsg, emsg_sz);
+
+	pthreadMutexLock(&gpu_jit_module_lock);
+	if (ok)
+		jmod->status = GPU_JIT_STATUS__READY;
+	else
+	{
+		/* keep the entry to avoid repeated compilation */
+		if (jmod->cuda_module)
+			cuModuleUnload(jmod->cuda_module);
+		jmod->cuda_module = NULL;
+		jmod->status = GPU_JIT_STATUS__FAILED;
+		jmod->refcnt--;
+	}
+	pthreadCondBroadcast(&gpu_jit_module_cond);
+	pthreadMutexUnlock(&gpu_jit_module_lock);
+	if (!ok)
+		goto bailout;
+found:
+	free(js.source.data);
+	*p_jit_entries = js.entries;
+	return jmod;
+
+bailout:
+	free(js.source.data);
+	free(js.entries);
+	return NULL;
+}
+
+/*
+ * gpuJitLookupFuncDptr
+ */
+bool
+gpuJitLookupFuncDptr(gpuJitModule *jmod,
+					 FuncOpCode func_code,
+					 xpu_function_t *p_func_dptr)
+{
+	xpu_function_catalog_entry key;
+	xpu_function_catalog_entry *entry;
+
+	key.func_opcode = func_code;
+	entry = bsearch(&key, jmod->func_catalog, jmod->func_nitems,
+					sizeof(xpu_function_catalog_entry),
+					__gpuJitFuncCatalogComp);
+	if (!entry)
+		return false;
+	*p_func_dptr = entry->func_dptr;
+	return true;
+}
+
+/*
+ * gpuJitLookupTypeOper
+ */
+bool
+gpuJitLookupTypeOper(gpuJitModule *jmod,
+					 TypeOpCode type_code,
+					 const xpu_datum_operators **p_expr_ops)
+{
+	xpu_type_catalog_entry key;
+	xpu_type_catalog_entry *entry;
+
+	key.type_opcode = type_code;
+	entry = bsearch(&key, jmod->type_catalog, jmod->type_nitems,
+					sizeof(xpu_type_catalog_entry),
+					__gpuJitTypeCatalogComp);
+	if (!entry)
+		return false;
+	*p_expr_ops = entry->type_ops;
+	return true;
+}
+
+/*
+ * gpuJitApplyEntries
+ *
+ * It replaces the fn_dptr of the kern_expression by the JIT entries.
+ * It must be called after the device pointers are resolved.
+ */
+void
+gpuJitApplyEntries(gpuJitModule *jmod,
+				   kern_session_info *session,
+				   const uint32_t *jit_entries)
+{
+	for (int i=0; i < jmod->nentries; i++)
+	{
+		kern_expression *kexp = (kern_expression *)
+			((char *)session + jit_entries[i]);
+		kexp->fn_dptr = jmod->entries[i];
+	}
+}
+
+/*
+ * gpuJitGetCudaModule
+ */
+CUmodule
+gpuJitGetCudaModule(gpuJitModule *jmod)
+{
+	Assert(jmod->status == GPU_JIT_STATUS__READY);
+	return jmod->cuda_module;
+}
+
+/*
+ * gpuJitDupModule
+ */
+gpuJitModule *
+gpuJitDupModule(gpuJitModule *jmod)
+{
+	pthreadMutexLock(&gpu_jit_module_lock);
+	Assert(jmod->refcnt > 0);
+	jmod->refcnt++;
+	pthreadMutexUnlock(&gpu_jit_module_lock);
+	return jmod;
+}
+
+/*
+ * gpuJitPutModule
+ */
+void
+gpuJitPutModule(gpuJitModule *jmod)
+{
+	pthreadMutexLock(&gpu_jit_module_lock);
+	Assert(jmod->refcnt > 0);
+	jmod->refcnt--;
+	pthreadMutexUnlock(&gpu_jit_module_lock);
+}
+
+/*
+ * gpuJitValidateUserFunc
+ *
+ * It compiles the user-defined device function with a dummy caller, to
+ * report the errors on the definition time, not on the query execution.
+ * It is called by the backend, and does nothing if no GPU devices.
+ */
+bool
+gpuJitValidateUserFunc(const char *symbol,
+					   const char *source,
+					   TypeOpCode rettype,
+					   int nargs,
+					   const TypeOpCode *argtypes,
+					   char *emsg, size_t emsg_sz)
+{
+	const gpuJitTypeInfo *rinfo;
+	const gpuJitTypeInfo *ainfo;
+	gpuJitBuffer buf;
+	char	   *ptx_image;
+	size_t		ptx_length;
+
+	if (nargs > GPU_JIT_USER_FUNC_MAX_NARGS)
+	{
+		snprintf(emsg, emsg_sz, "too many arguments (max %d)",
+				 GPU_JIT_USER_FUNC_MAX_NARGS);
+		return false;
+	}
+	if (!(rinfo = __jitLookupTypeInfo(rettype)))
+	{
+		snprintf(emsg, emsg_sz, "result type is not supported");
+		return false;
+	}
+	for (int i=0; i < nargs; i++)
+	{
+		if (!__jitLookupTypeInfo(argtypes[i]))
+		{
+			snprintf(emsg, emsg_sz, "argument %d type is not supported", i+1);
+			return false;
+		}
+	}
+	if (numGpuDevAttrs == 0)
+		return true;	/* nothing to validate */
+
+	memset(&buf, 0, sizeof(gpuJitBuffer));
+	__jitAppend(&buf,
+				"#include \"cuda_common.h\"\n"
+				"\n"
+				"%s\n"
+				"\n"
+				"PUBLIC_FUNCTION(bool)\n"
+				"__jit_user_func_validation(kern_context *kcxt)\n"
+				"{\n"
+				"\t%s result;\n"
+				"\n"
+				"\treturn %s(kcxt, &result",
+				source,
+				rinfo->type_base,
+				symbol);
+	for (int i=0; i < nargs; i++)
+	{
+		ainfo = __jitLookupTypeInfo(argtypes[i]);
+		__jitAppend(&buf, ", (%s)0", ainfo->type_base);
+	}
+	__jitAppend(&buf, ");\n}\n");
+	if (buf.oom)
+	{
+		free(buf.data);
+		snprintf(emsg, emsg_sz, "out of memory");
+		return false;
+	}
+	ptx_image = __gpuJitCompileSource(0, buf.data, &ptx_length,
+									  emsg, emsg_sz);
+	free(buf.data);
+	if (!ptx_image)
+		return false;
+	free(ptx_image);
+	return true;
+}
+
+/*
+ * pgstrom_init_gpu_jit
+ */
+void
+pgstrom_init_gpu_jit(void)
+{
+	DefineCustomBoolVariable("pg_strom.enable_gpu_jit",
+							 "Enables JIT compilation of the xpucode on GPU devices",
+							 NULL,
+							 &pgstrom_enable_gpu_jit,
+							 false,
+							 PGC_USERSET,
+							 GUC_NOT_IN_SAMPLE,
+							 NULL, NULL, NULL);
+	DefineCustomIntVariable("pg_strom.gpu_jit_cache_nslots",
+							"Number of JIT compiled modules to be cached per GPU device",
+							NULL,
+							&pgstrom_gpu_jit_cache_nslots,
+							64,
+							1,
+							10000,
+							PGC_POSTMASTER,
+							GUC_NOT_IN_SAMPLE,
+							NULL, NULL, NULL);
+	dlist_init(&gpu_jit_module_list);
+}
@@ -22,6 +22,57 @@ static CustomExecMethods	gpujoin_exec_methods;
 static bool					pgstrom_enable_gpujoin = false;		/* GUC */
 static bool					pgstrom_enable_gpuhashjoin = false;	/* GUC */
 static bool					pgstrom_enable_gpugistindex = false;/* GUC */
+static bool					pgstrom_enable_gpugridjoin = false;	/* GUC */
+static double				pgstrom_gpugridjoin_cell_size = 0.0; /* GUC */
+static bool					pgstrom_enable_gpurangejoin = false; /* GUC */
+static bool					pgstrom_enable_gpujoin_polygon_index = false; /* GUC */
+static bool					pgstrom_enable_gpuhashjoin_partition = false; /* GUC */
+static int					pgstrom_gpujoin_inner_partition_size_mb = 0; /* GUC */
+static bool					pgstrom_enable_gpujoin_bloom_filter = false; /* GUC */
+static bool					pgstrom_enable_gpujoin_hash_bucket = false; /* GUC */
+static bool					pgstrom_enable_gpujoin_device_hash_bucket = false; /* GUC */
+static bool					pgstrom_enable_gpujoin_direct_map = false; /* GUC */
+static bool					pgstrom_enable_gpujoin_right_outer = false; /* GUC */
+static bool					pgstrom_enable_gpujoin_inner_cache = false; /* GUC */
+static bool					pgstrom_enable_partitionwise_gpujoin = false; /* GUC */
+static int					pgstrom_gpujoin_inner_cache_nslots = 0; /* GUC */
+static shmem_request_hook_type shmem_request_next = NULL;
+static shmem_startup_hook_type shmem_startup_next = NULL;
+
+/*
+ * GpuJoin inner buffer cache
+ *
+ * Inner buffers built from the identical inner relations, quals and
+ * snapshot are reusable by the following queries, typically, a series of
+ * queries to the same dimension tables. The directory entry on the shared
+ * memory keeps the handle of the host inner buffer after the end of query,
+ * and the GPU service also keeps the device copy by the signature.
+ */
+#define GPUJOIN_INNER_CACHE_MAX_RELS	8
+
+typedef struct
+{
+	uint64_t	signature;		/* 0, if unused slot */
+	uint64_t	signature2;		/* secondary hash to avoid conflicts */
+	Oid			database_oid;
+	int			num_relids;
+	Oid			relids[GPUJOIN_INNER_CACHE_MAX_RELS];
+	uint32_t	shmem_handle;
+	uint64_t	shmem_length;
+	int			refcnt;
+	bool		invalid;		/* relcache invalidation */
+	uint64_t	last_used;		/* LRU clock */
+} gpujoinInnerCacheEntry;
+
+typedef struct
+{
+	LWLock		lock;
+	uint64_t	lru_clock;
+	gpujoinInnerCacheEntry entries[FLEXIBLE_ARRAY_MEMBER];
+} gpujoinInnerCacheHead;
+
+static gpujoinInnerCacheHead *gpujoin_inner_cache = NULL;
+static List				   *gpujoin_inner_cache_held = NIL;
 
 static CustomPathMethods	dpujoin_path_methods;
 static CustomScanMethods	dpujoin_plan_methods;
@@ -45,6 +96,489 @@ try_fetch_xpujoin_planinfo(const Path *path)
 	return NULL;
 }
 
+/*
+ * __estimateGpuHashJoinPartitions
+ *
+ * It returns the number of hash-partitions if the inner hash table of the
+ * latest depth is expected to overflow the device memory, or 0 if the inner
+ * buffer can be loaded at once.
+ * Because the outer relation is scanned multiple times (once per partition),
+ * grace hash-join is only available for INNER JOIN on the regular heap
+ * relations, and at most one depth can be partitioned.
+ */
+static int
+__estimateGpuHashJoinPartitions(PlannerInfo *root,
+								const pgstromPlanInfo *pp_info,
+								const Path *inner_path)
+{
+	const pgstromPlanInnerInfo *pp_inner = &pp_info->inners[pp_info->num_rels-1];
+	RangeTblEntry *rte = root->simple_rte_array[pp_info->scan_relid];
+	double		threshold;
+	double		inner_sz;
+	int			nparts;
+
+	if (!pgstrom_enable_gpuhashjoin_partition ||
+		(pp_info->xpu_task_flags & DEVKIND__ANY) != DEVKIND__NVIDIA_GPU ||
+		pp_inner->join_type != JOIN_INNER)
+		return 0;
+	for (int i=0; i < pp_info->num_rels-1; i++)
+	{
+		const pgstromPlanInnerInfo *__pp_inner = &pp_info->inners[i];
+
+		if (__pp_inner->inner_nparts > 0 ||
+			__pp_inner->join_type == JOIN_RIGHT ||
+			__pp_inner->join_type == JOIN_FULL)
+			return 0;
+	}
+	if (pp_info->gpu_cache_dindex >= 0 ||
+		OidIsValid(pp_info->brin_index_oid) ||
+		!rte || rte->rtekind != RTE_RELATION ||
+		(rte->relkind != RELKIND_RELATION &&
+		 rte->relkind != RELKIND_MATVIEW))
+		return 0;
+
+	if (pgstrom_gpujoin_inner_partition_size_mb > 0)
+		threshold = (double)pgstrom_gpujoin_inner_partition_size_mb * 1048576.0;
+	else
+	{
+		/* default: half of the smallest GPU device memory */
+		threshold = 0.0;
+		for (int i=0; i < numGpuDevAttrs; i++)
+		{
+			double	sz = (double)gpuDevAttrs[i].DEV_TOTAL_MEMSZ / 2.0;
+
+			if (threshold == 0.0 || threshold > sz)
+				threshold = sz;
+		}
+		if (threshold == 0.0)
+			return 0;
+	}
+	/* see innerPreloadAllocHostBuffer */
+	inner_sz = inner_path->rows * (MAXALIGN(offsetof(kern_hashitem, t.htup) +
+											MAXALIGN(SizeofHeapTupleHeader) +
+											inner_path->pathtarget->width) +
+								   2 * sizeof(uint32_t));
+	/*
+	 * non-partitioned inner buffer also has the hash-bucket (hash-value and
+	 * item offset for each item, and the start position for each hash-slot);
+	 * see __innerPreloadSetupHashBucket
+	 */
+	if (inner_sz + (pgstrom_enable_gpujoin_hash_bucket
+					? inner_path->rows * 3 * sizeof(uint32_t)
+					: 0.0) <= threshold)
+		return 0;
+	nparts = (int)ceil(inner_sz / threshold);
+	if (nparts > GPUJOIN_MAX_INNER_PARTITIONS)
+	{
+		elog(DEBUG2, "GpuHashJoin: inner buffer (%.0f bytes) needs too many partitions (%d)",
+			 inner_sz, nparts);
+		return 0;
+	}
+	return Max(nparts, 2);
+}
+
+/*
+ * __makeGridJoinCellKey
+ *
+ * It makes an expression of floor(st_x(geom) / cell_size) + 0.0; the last
+ * addition normalizes -0.0 to +0.0, because the inner-side hash value is
+ * computed on the binary image of the float8 cell number.
+ */
+static Node *
+__makeGridJoinCellKey(Oid coord_func_oid, Node *geom, double cell_size)
+{
+	Expr	   *expr;
+
+	expr = (Expr *)makeFuncExpr(coord_func_oid,
+								FLOAT8OID,
+								list_make1(copyObject(geom)),
+								InvalidOid,
+								InvalidOid,
+								COERCE_EXPLICIT_CALL);
+	expr = (Expr *)makeFuncExpr(F_FLOAT8DIV,
+								FLOAT8OID,
+								list_make2(expr, makeConst(FLOAT8OID,
+														   -1,
+														   InvalidOid,
+														   sizeof(float8),
+														   Float8GetDatum(cell_size),
+														   false,
+														   FLOAT8PASSBYVAL)),
+								InvalidOid,
+								InvalidOid,
+								COERCE_EXPLICIT_CALL);
+	expr = (Expr *)makeFuncExpr(F_FLOOR_FLOAT8,
+								FLOAT8OID,
+								list_make1(expr),
+								InvalidOid,
+								InvalidOid,
+								COERCE_EXPLICIT_CALL);
+	expr = (Expr *)makeFuncExpr(F_FLOAT8PL,
+								FLOAT8OID,
+								list_make2(expr, makeConst(FLOAT8OID,
+														   -1,
+														   InvalidOid,
+														   sizeof(float8),
+														   Float8GetDatum(0.0),
+														   false,
+														   FLOAT8PASSBYVAL)),
+								InvalidOid,
+								InvalidOid,
+								COERCE_EXPLICIT_CALL);
+	return (Node *)expr;
+}
+
+/*
+ * __tryBuildXpuGridJoinKeys
+ *
+ * GpuGridJoin - spatial join by st_dwithin(outer,inner,distance) or
+ * st_contains(inner,outer) has no hash-joinable clauses. If the outer side
+ * is POINT geometry, we can map it on a cell of the uniform grid, and
+ * the inner geometry is loaded onto the hash-table for each cell covered
+ * by its bounding-box (expanded by the distance). Then, the usual hash-
+ * join logic works as a coarse filter, and the join-quals check the exact
+ * relationship of the candidate pairs.
+ */
+static bool
+__tryBuildXpuGridJoinKeys(PlannerInfo *root,
+						  List *join_quals,
+						  RelOptInfo *outer_rel,
+						  RelOptInfo *inner_rel,
+						  uint32_t xpu_task_flags,
+						  int scan_relid,
+						  List *inner_target_list,
+						  pgstromPlanInnerInfo *pp_inner)
+{
+	ListCell   *lc;
+
+	foreach (lc, join_quals)
+	{
+		FuncExpr   *func = lfirst(lc);
+		Node	   *outer_geom;
+		Node	   *inner_geom;
+		Node	   *arg1;
+		Node	   *arg2;
+		char	   *func_name;
+		char	   *ext_name;
+		double		cell_size;
+		double		expand;
+		int32_t		typmod;
+		Oid			namespace_oid;
+		Oid			geom_type;
+		Oid			st_x_oid;
+		Oid			st_y_oid;
+		List	   *hash_outer_keys;
+
+		if (!IsA(func, FuncExpr) || list_length(func->args) < 2)
+			continue;
+		ext_name = get_func_extension_name(func->funcid);
+		if (!ext_name || strcmp(ext_name, "postgis") != 0)
+			continue;
+		func_name = get_func_name(func->funcid);
+		arg1 = linitial(func->args);
+		arg2 = lsecond(func->args);
+		geom_type = exprType(arg1);
+		if (exprType(arg2) != geom_type)
+			continue;
+		if (strcmp(func_name, "st_dwithin") == 0 &&
+			list_length(func->args) == 3)
+		{
+			Const  *dist = lthird(func->args);
+			Relids	relids1 = pull_varnos(root, arg1);
+			Relids	relids2 = pull_varnos(root, arg2);
+
+			if (!IsA(dist, Const) ||
+				dist->consttype != FLOAT8OID ||
+				dist->constisnull ||
+				DatumGetFloat8(dist->constvalue) <= 0.0)
+				continue;
+			expand = DatumGetFloat8(dist->constvalue);
+			if (!bms_is_empty(relids1) &&
+				!bms_is_empty(relids2) &&
+				bms_is_subset(relids1, outer_rel->relids) &&
+				bms_is_subset(relids2, inner_rel->relids))
+			{
+				outer_geom = arg1;
+				inner_geom = arg2;
+			}
+			else if (!bms_is_empty(relids1) &&
+					 !bms_is_empty(relids2) &&
+					 bms_is_subset(relids1, inner_rel->relids) &&
+					 bms_is_subset(relids2, outer_rel->relids))
+			{
+				outer_geom = arg2;
+				inner_geom = arg1;
+			}
+			else
+				continue;
+			cell_size = (pgstrom_gpugridjoin_cell_size > 0.0
+						 ? pgstrom_gpugridjoin_cell_size
+						 : expand);
+		}
+		else if (strcmp(func_name, "st_contains") == 0 &&
+				 list_length(func->args) == 2)
+		{
+			Relids	relids1 = pull_varnos(root, arg1);
+			Relids	relids2 = pull_varnos(root, arg2);
+
+			/* no reasonable default for the cell size */
+			if (pgstrom_gpugridjoin_cell_size <= 0.0)
+				continue;
+			if (bms_is_empty(relids1) ||
+				bms_is_empty(relids2) ||
+				!bms_is_subset(relids1, inner_rel->relids) ||
+				!bms_is_subset(relids2, outer_rel->relids))
+				continue;
+			inner_geom = arg1;
+			outer_geom = arg2;
+			cell_size = pgstrom_gpugridjoin_cell_size;
+			expand = 0.0;
+		}
+		else
+			continue;
+
+		/*
+		 * outer side must be POINT geometry; see TYPMOD_GET_TYPE() and
+		 * POINTTYPE of PostGIS.
+		 */
+		typmod = exprTypmod(outer_geom);
+		if (typmod < 0 || ((typmod & 0x000000fc) >> 2) != 1)
+			continue;
+		/* st_x(geometry) and st_y(geometry) */
+		namespace_oid = get_type_namespace(geom_type);
+		if (!OidIsValid(namespace_oid))
+			continue;
+		st_x_oid = LookupFuncName(list_make2(makeString(get_namespace_name(namespace_oid)),
+											 makeString("st_x")),
+								  1, &geom_type, true);
+		st_y_oid = LookupFuncName(list_make2(makeString(get_namespace_name(namespace_oid)),
+											 makeString("st_y")),
+								  1, &geom_type, true);
+		if (!OidIsValid(st_x_oid) || !OidIsValid(st_y_oid))
+			continue;
+		hash_outer_keys = list_make2(__makeGridJoinCellKey(st_x_oid,
+														   outer_geom,
+														   cell_size),
+									 __makeGridJoinCellKey(st_y_oid,
+														   outer_geom,
+														   cell_size));
+		if (!pgstrom_xpu_expression(linitial(hash_outer_keys),
+									xpu_task_flags,
+									scan_relid,
+									inner_target_list,
+									NULL) ||
+			!pgstrom_xpu_expression(lsecond(hash_outer_keys),
+									xpu_task_flags,
+									scan_relid,
+									inner_target_list,
+									NULL))
+			continue;
+		pp_inner->hash_outer_keys = hash_outer_keys;
+		pp_inner->hash_inner_keys = list_make1(inner_geom);
+		pp_inner->grid_cell_size = cell_size;
+		pp_inner->grid_expand = expand;
+		return true;
+	}
+	return false;
+}
+
+/*
+ * __tryBuildXpuRangeJoinKeys
+ *
+ * GpuRangeJoin - band join like 'o.ts BETWEEN s.start_ts AND s.end_ts' or
+ * 'o.x >= s.lo AND o.x < s.hi' has no hash-joinable clauses, so it runs as
+ * a nested-loop that checks every pair of the outer and inner tuples.
+ * If a pair of the join-quals gives the lower and upper bound on the same
+ * outer key, the inner tuples are sorted by the lower bound on the inner
+ * preloading, then each outer tuple finds its candidates by binary search.
+ * The bounds are handled as inclusive; the join-quals check the exact
+ * relationship of the candidate pairs.
+ */
+static Oid
+__rangeJoinKeyTypeClass(Oid type_oid)
+{
+	switch (type_oid)
+	{
+		case INT2OID:
+		case INT4OID:
+		case INT8OID:
+			return INT8OID;
+		case DATEOID:
+		case TIMESTAMPOID:
+		case TIMESTAMPTZOID:
+			return type_oid;
+		default:
+			break;
+	}
+	return InvalidOid;
+}
+
+static bool
+__getRangeJoinBound(PlannerInfo *root,
+					Node *clause,
+					RelOptInfo *outer_rel,
+					RelOptInfo *inner_rel,
+					Node **p_outer_key,
+					Node **p_inner_bound,
+					bool *p_is_lower)
+{
+	OpExpr	   *op = (OpExpr *)clause;
+	Node	   *arg1;
+	Node	   *arg2;
+	Relids		relids1;
+	Relids		relids2;
+	bool		outer_is_left;
+	TypeCacheEntry *tcache;
+	Oid			type_class;
+
+	if (!IsA(op, OpExpr) || list_length(op->args) != 2)
+		return false;
+	arg1 = linitial(op->args);
+	arg2 = lsecond(op->args);
+	relids1 = pull_varnos(root, arg1);
+	relids2 = pull_varnos(root, arg2);
+	if (bms_is_empty(relids1) || bms_is_empty(relids2))
+		return false;
+	if (bms_is_subset(relids1, outer_rel->relids) &&
+		bms_is_subset(relids2, inner_rel->relids))
+		outer_is_left = true;
+	else if (bms_is_subset(relids1, inner_rel->relids) &&
+			 bms_is_subset(relids2, outer_rel->relids))
+		outer_is_left = false;
+	else
+		return false;
+	/* both side must be the comparable integer or date/time types */
+	type_class = __rangeJoinKeyTypeClass(exprType(arg1));
+	if (!OidIsValid(type_class) ||
+		type_class != __rangeJoinKeyTypeClass(exprType(arg2)))
+		return false;
+	tcache = lookup_type_cache(exprType(arg1), TYPECACHE_BTREE_OPFAMILY);
+	if (!OidIsValid(tcache->btree_opf))
+		return false;
+	switch (get_op_opfamily_strategy(op->opno, tcache->btree_opf))
+	{
+		case BTLessStrategyNumber:
+		case BTLessEqualStrategyNumber:
+			/* inner <= outer, or outer <= inner */
+			*p_is_lower = !outer_is_left;
+			break;
+		case BTGreaterStrategyNumber:
+		case BTGreaterEqualStrategyNumber:
+			/* outer >= inner, or inner >= outer */
+			*p_is_lower = outer_is_left;
+			break;
+		default:
+			return false;
+	}
+	*p_outer_key   = (outer_is_left ? arg1 : arg2);
+	*p_inner_bound = (outer_is_left ? arg2 : arg1);
+	return true;
+}
+
+static bool
+__tryBuildXpuRangeJoinKeys(PlannerInfo *root,
+						   List *join_quals,
+						   RelOptInfo *outer_rel,
+						   RelOptInfo *inner_rel,
+						   uint32_t xpu_task_flags,
+						   int scan_relid,
+						   List *inner_target_list,
+						   pgstromPlanInnerInfo *pp_inner)
+{
+	ListCell   *lc1, *lc2;
+
+	foreach (lc1, join_quals)
+	{
+		Node	   *outer_key;
+		Node	   *inner_lower;
+		bool		is_lower;
+
+		if (!__getRangeJoinBound(root, lfirst(lc1),
+								 outer_rel, inner_rel,
+								 &outer_key, &inner_lower, &is_lower) ||
+			!is_lower)
+			continue;
+		foreach (lc2, join_quals)
+		{
+			Node	   *__outer_key;
+			Node	   *inner_upper;
+
+			if (!__getRangeJoinBound(root, lfirst(lc2),
+									 outer_rel, inner_rel,
+									 &__outer_key, &inner_upper, &is_lower) ||
+				is_lower ||
+				!equal(outer_key, __outer_key) ||
+				__rangeJoinKeyTypeClass(exprType(inner_lower)) !=
+				__rangeJoinKeyTypeClass(exprType(inner_upper)))
+				continue;
+			if (!pgstrom_xpu_expression((Expr *)outer_key,
+										xpu_task_flags,
+										scan_relid,
+										inner_target_list,
+										NULL))
+				break;
+			pp_inner->range_outer_keys = list_make1(outer_key);
+			pp_inner->range_inner_keys = list_make2(inner_lower,
+													inner_upper);
+			return true;
+		}
+	}
+	return false;
+}
+
+/*
+ * __tryBuildXpuPolygonIndexKey
+ *
+ * st_contains(inner_polygon, outer_point) on the nested-loop tests every
+ * inner polygon for each outer point, and decodes the same GSERIALIZED
+ * again and again. If the 1st argument is a plain Var of the inner side,
+ * the polygons are decoded to the edges on the inner preloading, and the
+ * device code looks up the edges by the address of the geometry datum.
+ */
+static bool
+__tryBuildXpuPolygonIndexKey(PlannerInfo *root,
+							 List *join_quals,
+							 RelOptInfo *outer_rel,
+							 RelOptInfo *inner_rel,
+							 pgstromPlanInnerInfo *pp_inner)
+{
+	ListCell   *lc;
+
+	foreach (lc, join_quals)
+	{
+		FuncExpr   *func = lfirst(lc);
+		Node	   *arg1;
+		Node	   *arg2;
+		Relids		relids1;
+		Relids		relids2;
+		char	   *func_name;
+		char	   *ext_name;
+
+		if (!IsA(func, FuncExpr) || list_length(func->args) != 2)
+			continue;
+		ext_name = get_func_extension_name(func->funcid);
+		if (!ext_name || strcmp(ext_name, "postgis") != 0)
+			continue;
+		func_name = get_func_name(func->funcid);
+		if (!func_name || strcmp(func_name, "st_contains") != 0)
+			continue;
+		arg1 = linitial(func->args);
+		arg2 = lsecond(func->args);
+		if (!IsA(arg1, Var))
+			continue;
+		relids1 = pull_varnos(root, arg1);
+		relids2 = pull_varnos(root, arg2);
+		if (bms_is_empty(relids1) ||
+			bms_is_empty(relids2) ||
+			!bms_is_subset(relids1, inner_rel->relids) ||
+			!bms_is_subset(relids2, outer_rel->relids))
+			continue;
+		pp_inner->polygon_inner_key = (Expr *)arg1;
+		return true;
+	}
+	return false;
+}
+
 /*
  * __buildXpuJoinPlanInfo
  */
@@ -66,6 +600,9 @@ __buildXpuJoinPlanInfo(PlannerInfo *root,
 	Cost			run_cost;
 	bool			enable_xpuhashjoin;
 	bool			enable_xpugistindex;
+	bool			enable_xpugridjoin;
+	bool			enable_xpurangejoin;
+	bool			enable_xpupolygonindex;
 	double			xpu_tuple_cost;
 	Cost			xpu_ratio;
 	Cost			comp_cost = 0.0;
@@ -90,6 +627,9 @@ __buildXpuJoinPlanInfo(PlannerInfo *root,
 	{
 		enable_xpuhashjoin  = pgstrom_enable_gpuhashjoin;
 		enable_xpugistindex = pgstrom_enable_gpugistindex;
+		enable_xpugridjoin  = pgstrom_enable_gpugridjoin;
+		enable_xpurangejoin = pgstrom_enable_gpurangejoin;
+		enable_xpupolygonindex = pgstrom_enable_gpujoin_polygon_index;
 		xpu_tuple_cost      = pgstrom_gpu_tuple_cost;
 		xpu_ratio           = pgstrom_gpu_operator_ratio();
 	}
@@ -97,6 +637,9 @@ __buildXpuJoinPlanInfo(PlannerInfo *root,
 	{
 		enable_xpuhashjoin  = pgstrom_enable_dpuhashjoin;
 		enable_xpugistindex = pgstrom_enable_dpugistindex;
+		enable_xpugridjoin  = false;
+		enable_xpurangejoin = false;
+		enable_xpupolygonindex = false;
 		xpu_tuple_cost      = pgstrom_dpu_tuple_cost;
 		xpu_ratio           = pgstrom_dpu_operator_ratio();
 	}
@@ -220,6 +763,28 @@ __buildXpuJoinPlanInfo(PlannerInfo *root,
 		return NULL;
 	}
 
+	/*
+	 * ANTI JOIN emits only the outer tuples that have no matched inner
+	 * tuples, so the pushed-down qualifiers cannot be evaluated on the
+	 * device join.
+	 */
+	if (join_type == JOIN_ANTI && other_quals != NIL)
+		return NULL;
+
+	/*
+	 * RIGHT/FULL OUTER JOIN cannot be stacked on the grace hash-join,
+	 * because unmatched inner tuples shall be joined to the partitioned
+	 * depth only once.
+	 */
+	if (join_type == JOIN_RIGHT || join_type == JOIN_FULL)
+	{
+		for (int i=0; i < pp_prev->num_rels; i++)
+		{
+			if (pp_prev->inners[i].inner_nparts > 0)
+				return NULL;
+		}
+	}
+
 	/*
 	 * Setup pgstromPlanInfo
 	 */
@@ -231,8 +796,34 @@ __buildXpuJoinPlanInfo(PlannerInfo *root,
 	pp_inner->hash_inner_keys = hash_inner_keys;
 	pp_inner->join_quals = join_quals;
 	pp_inner->other_quals = other_quals;
-	/* GiST-Index availability checks */
+	/*
+	 * Bloom pre-filter - if hash-keys of INNER/SEMI JOIN reference only the
+	 * base relation, the bloom-filter of this depth can drop the outer tuples
+	 * that never match at the first depth, unless RIGHT/FULL OUTER JOIN at
+	 * the earlier depths needs them to mark the outer-join-map.
+	 * GPU service enables it according to the selectivity in run-time.
+	 */
+	if (hash_outer_keys != NIL &&
+		pp_info->num_rels > 1 &&
+		pp_info->num_rels < sizeof(uint32_t) * BITS_PER_BYTE &&
+		(join_type == JOIN_INNER || join_type == JOIN_SEMI))
+	{
+		Relids	relids = pull_varnos(root, (Node *)hash_outer_keys);
+
+		pp_inner->bloom_prefilter = (bms_membership(relids) == BMS_SINGLETON &&
+									 bms_is_member(pp_info->scan_relid, relids));
+		for (int i=0; i < pp_info->num_rels-1; i++)
+		{
+			if (pp_info->inners[i].join_type == JOIN_RIGHT ||
+				pp_info->inners[i].join_type == JOIN_FULL)
+				pp_inner->bloom_prefilter = false;
+		}
+		bms_free(relids);
+	}
+	/* GiST-Index availability checks (not for SEMI/ANTI JOIN) */
 	if (enable_xpugistindex &&
+		join_type != JOIN_SEMI &&
+		join_type != JOIN_ANTI &&
 		pp_inner->hash_outer_keys == NIL &&
 		pp_inner->hash_inner_keys == NIL)
 	{
@@ -250,6 +841,66 @@ __buildXpuJoinPlanInfo(PlannerInfo *root,
 			inner_path = gist_inner_path;
 		}
 	}
+	/*
+	 * GpuGridJoin availability checks, if neither hash-join nor GiST-index.
+	 * RIGHT/FULL OUTER JOIN is not supported, because an inner tuple can be
+	 * loaded for multiple cells.
+	 */
+	if (enable_xpuhashjoin &&
+		enable_xpugridjoin &&
+		join_type != JOIN_RIGHT &&
+		join_type != JOIN_FULL &&
+		pp_inner->hash_outer_keys == NIL &&
+		pp_inner->hash_inner_keys == NIL &&
+		!OidIsValid(pp_inner->gist_index_oid))
+	{
+		if (__tryBuildXpuGridJoinKeys(root,
+									  join_quals,
+									  outer_rel,
+									  inner_rel,
+									  pp_info->xpu_task_flags,
+									  pp_info->scan_relid,
+									  inner_target_list,
+									  pp_inner))
+		{
+			hash_outer_keys = pp_inner->hash_outer_keys;
+			hash_inner_keys = pp_inner->hash_inner_keys;
+		}
+	}
+	/*
+	 * GpuRangeJoin availability checks, if neither hash-join, GiST-index
+	 * nor grid-join.
+	 */
+	if (enable_xpurangejoin &&
+		pp_inner->hash_outer_keys == NIL &&
+		pp_inner->hash_inner_keys == NIL &&
+		!OidIsValid(pp_inner->gist_index_oid))
+	{
+		__tryBuildXpuRangeJoinKeys(root,
+								   join_quals,
+								   outer_rel,
+								   inner_rel,
+								   pp_info->xpu_task_flags,
+								   pp_info->scan_relid,
+								   inner_target_list,
+								   pp_inner);
+	}
+	/*
+	 * Polygon-index of st_contains(), if the inner side is a plain
+	 * nested-loop.
+	 */
+	if (enable_xpupolygonindex &&
+		pp_inner->hash_outer_keys == NIL &&
+		pp_inner->hash_inner_keys == NIL &&
+		pp_inner->range_inner_keys == NIL &&
+		!OidIsValid(pp_inner->gist_index_oid))
+	{
+		__tryBuildXpuPolygonIndexKey(root,
+									 join_quals,
+									 outer_rel,
+									 inner_rel,
+									 pp_inner);
+	}
 	/*
 	 * Cost estimation
 	 */
@@ -283,12 +934,31 @@ __buildXpuJoinPlanInfo(PlannerInfo *root,
 
 		/* cost to compute inner hash value by CPU */
 		startup_cost += cpu_operator_cost * num_hashkeys * inner_path->rows;
+		/* GpuGridJoin loads an inner tuple for (usually) 4 or more cells */
+		if (pp_inner->grid_cell_size > 0.0)
+			startup_cost += 4.0 * cpu_tuple_cost * inner_path->rows;
 		/* cost to comput hash value by GPU */
 		comp_cost += (cpu_operator_cost * xpu_ratio *
 					  num_hashkeys *
 					  outer_nrows);
 		/* cost to evaluate join qualifiers */
 		comp_cost += join_quals_cost.per_tuple * xpu_ratio * outer_nrows;
+
+		/*
+		 * Grace hash-join - if inner hash table is too large, the outer
+		 * relation is scanned again for each hash-partition.
+		 */
+		pp_inner->inner_nparts = __estimateGpuHashJoinPartitions(root, pp_info,
+																 inner_path);
+		if (pp_inner->inner_nparts > 1)
+		{
+			int		nloops = pp_inner->inner_nparts - 1;
+
+			run_cost += nloops * (pp_prev->scan_run_cost +
+								  (cpu_operator_cost * xpu_ratio *
+								   num_hashkeys *
+								   outer_nrows) / pp_info->parallel_divisor);
+		}
 	}
 	else if (OidIsValid(pp_inner->gist_index_oid))
 	{
@@ -312,6 +982,29 @@ __buildXpuJoinPlanInfo(PlannerInfo *root,
 					  gist_selectivity *
 					  inner_path->rows);
 	}
+	else if (pp_inner->range_outer_keys != NIL)
+	{
+		/*
+		 * GpuRangeJoin - It sorts the inner tuples by the lower bound
+		 * during the preloading, then each outer tuple finds the candidates
+		 * by binary search. We assume the candidates are as many as the
+		 * rows of the join for each outer tuple.
+		 */
+		double		ncandidates = Max(joinrel->rows / Max(outer_nrows, 1.0), 1.0);
+
+		/* cost to preload inner heap tuples and sort them by CPU */
+		startup_cost += (cpu_tuple_cost * inner_path->rows +
+						 2.0 * cpu_operator_cost * inner_path->rows *
+						 log2(Max(inner_path->rows, 2.0)));
+		/* cost to binary search by GPU */
+		comp_cost += (cpu_operator_cost * xpu_ratio *
+					  log2(Max(inner_path->rows, 2.0)) *
+					  outer_nrows);
+		/* cost to evaluate join qualifiers by GPU */
+		comp_cost += (join_quals_cost.per_tuple * xpu_ratio *
+					  ncandidates *
+					  outer_nrows);
+	}
 	else
 	{
 		/*
@@ -432,7 +1125,12 @@ buildOuterJoinPlanInfo(PlannerInfo *root,
 				jpath->jointype != JOIN_LEFT &&
 				jpath->jointype != JOIN_FULL &&
 				jpath->jointype != JOIN_RIGHT)
-				return NULL;
+			{
+				if ((jpath->jointype != JOIN_SEMI &&
+					 jpath->jointype != JOIN_ANTI) ||
+					(xpu_task_flags & DEVKIND__ANY) != DEVKIND__NVIDIA_GPU)
+					return NULL;
+			}
 
 			pp_prev = buildOuterJoinPlanInfo(root,
 											 o_path->parent,
@@ -462,15 +1160,15 @@ buildOuterJoinPlanInfo(PlannerInfo *root,
 }
 
 /*
- * try_add_simple_xpujoin_path
+ * __build_simple_xpujoin_path
  */
-static bool
-try_add_simple_xpujoin_path(PlannerInfo *root,
+static CustomPath *
+__build_simple_xpujoin_path(PlannerInfo *root,
 							RelOptInfo *joinrel,
 							RelOptInfo *outer_rel,
-                            Path *inner_path,
-                            JoinType join_type,
-                            JoinPathExtraData *extra,
+							Path *inner_path,
+							JoinType join_type,
+							JoinPathExtraData *extra,
 							bool try_parallel_path,
 							uint32_t xpu_task_flags,
 							const CustomPathMethods *xpujoin_path_methods)
@@ -487,7 +1185,8 @@ try_add_simple_xpujoin_path(PlannerInfo *root,
 
 	/* sanity checks */
 	Assert(join_type == JOIN_INNER || join_type == JOIN_FULL ||
-		   join_type == JOIN_LEFT  || join_type == JOIN_RIGHT);
+		   join_type == JOIN_LEFT  || join_type == JOIN_RIGHT ||
+		   join_type == JOIN_SEMI  || join_type == JOIN_ANTI);
 	/*
 	 * Setup a dummy outer-path node
 	 *
@@ -507,7 +1206,7 @@ try_add_simple_xpujoin_path(PlannerInfo *root,
 									 &outer_path.param_info,
 									 &inner_paths_list);
 	if (!pp_prev)
-		return false;
+		return NULL;
 	inner_paths_list = lappend(inner_paths_list, inner_path);
 	if (pp_prev->num_rels == 0)
 		outer_path.rows = pp_prev->scan_rows;
@@ -523,7 +1222,7 @@ try_add_simple_xpujoin_path(PlannerInfo *root,
 									   extra->param_source_rels))
 	{
 		bms_free(required_outer);
-		return false;
+		return NULL;
 	}
 
 	param_info = get_joinrel_parampathinfo(root,
@@ -534,7 +1233,7 @@ try_add_simple_xpujoin_path(PlannerInfo *root,
 										   required_outer,
 										   &restrict_clauses);
 	if (!restrict_clauses)
-		return false;		/* cross join is not welcome */
+		return NULL;		/* cross join is not welcome */
 
 	/*
 	 * Build a new pgstromPlanInfo
@@ -547,7 +1246,7 @@ try_add_simple_xpujoin_path(PlannerInfo *root,
 									 pp_prev,
 									 inner_paths_list);
 	if (!pp_info)
-		return false;
+		return NULL;
 	pp_inner = &pp_info->inners[pp_info->num_rels-1];
 
 	/*
@@ -572,24 +1271,209 @@ try_add_simple_xpujoin_path(PlannerInfo *root,
 	cpath->custom_paths = inner_paths_list;
 	cpath->custom_private = list_make1(pp_info);
 
+	return cpath;
+}
+
+/*
+ * try_add_simple_xpujoin_path
+ */
+static bool
+try_add_simple_xpujoin_path(PlannerInfo *root,
+							RelOptInfo *joinrel,
+							RelOptInfo *outer_rel,
+                            Path *inner_path,
+                            JoinType join_type,
+                            JoinPathExtraData *extra,
+							bool try_parallel_path,
+							uint32_t xpu_task_flags,
+							const CustomPathMethods *xpujoin_path_methods)
+{
+	CustomPath	   *cpath;
+	CustomPath	   *sort_path;
+
+	cpath = __build_simple_xpujoin_path(root,
+										joinrel,
+										outer_rel,
+										inner_path,
+										join_type,
+										extra,
+										try_parallel_path,
+										xpu_task_flags,
+										xpujoin_path_methods);
+	if (!cpath)
+		return false;
+	sort_path = buildGpuSortPath(root, joinrel, cpath);
+
 	if (!try_parallel_path)
+	{
 		add_path(joinrel, &cpath->path);
+		if (sort_path)
+			add_path(joinrel, &sort_path->path);
+	}
 	else
+	{
 		add_partial_path(joinrel, &cpath->path);
+		if (sort_path)
+			add_partial_path(joinrel, &sort_path->path);
+	}
 	return true;
 }
 
 /*
- * __xpuJoinAddCustomPathCommon
+ * try_add_partitionwise_xpujoin_path
+ *
+ * When the outer relation is a partitioned table, it tries to build
+ * the xPU-Join paths for each leaf partition with the same inner path,
+ * then add an Append of them. Each xPU-Join is bound to the device
+ * optimal for the tablespace of its partition, and the inner buffers
+ * built from the same inner relation are shared via the inner cache.
  */
-static void
-__xpuJoinAddCustomPathCommon(PlannerInfo *root,
-							 RelOptInfo *joinrel,
-							 RelOptInfo *outerrel,
-							 RelOptInfo *innerrel,
-							 JoinType join_type,
-							 JoinPathExtraData *extra,
-							 uint32_t xpu_task_flags,
+static bool
+__collect_partition_leaf_rels(RelOptInfo *rel, List **p_leaf_rels)
+{
+	for (int i=0; i < rel->nparts; i++)
+	{
+		RelOptInfo *child_rel = rel->part_rels[i];
+
+		if (!child_rel || IS_DUMMY_REL(child_rel))
+			continue;		/* pruned */
+		if (IS_PARTITIONED_REL(child_rel))
+		{
+			if (!__collect_partition_leaf_rels(child_rel, p_leaf_rels))
+				return false;
+		}
+		else if (child_rel->reloptkind == RELOPT_OTHER_MEMBER_REL)
+			*p_leaf_rels = lappend(*p_leaf_rels, child_rel);
+		else
+			return false;
+	}
+	return true;
+}
+
+static RelOptInfo *
+__build_partition_child_joinrel(PlannerInfo *root,
+								RelOptInfo *joinrel,
+								RelOptInfo *outer_rel,
+								RelOptInfo *leaf_rel,
+								AppendRelInfo **appinfos,
+								int nappinfos)
+{
+	RelOptInfo *child_joinrel = makeNode(RelOptInfo);
+
+	/*
+	 * MEMO: This child join-rel is used only to carry 'relids', 'rows'
+	 * and 'reltarget' of the join onto the leaf partition, for the path
+	 * construction and the plan creation. It is never registered to
+	 * the join_rel_list of the planner.
+	 */
+	memcpy(child_joinrel, joinrel, sizeof(RelOptInfo));
+	child_joinrel->relids = bms_union(bms_difference(joinrel->relids,
+													 outer_rel->relids),
+									  leaf_rel->relids);
+	child_joinrel->rows = clamp_row_est(joinrel->rows *
+										leaf_rel->rows / Max(outer_rel->rows, 1.0));
+	child_joinrel->reltarget = copy_pathtarget(joinrel->reltarget);
+	child_joinrel->reltarget->exprs = (List *)
+		adjust_appendrel_attrs(root,
+							   (Node *)joinrel->reltarget->exprs,
+							   nappinfos, appinfos);
+	child_joinrel->pathlist = NIL;
+	child_joinrel->partial_pathlist = NIL;
+	child_joinrel->cheapest_startup_path = NULL;
+	child_joinrel->cheapest_total_path = NULL;
+	child_joinrel->cheapest_unique_path = NULL;
+	child_joinrel->cheapest_parameterized_paths = NIL;
+
+	return child_joinrel;
+}
+
+static void
+try_add_partitionwise_xpujoin_path(PlannerInfo *root,
+								   RelOptInfo *joinrel,
+								   RelOptInfo *outer_rel,
+								   RelOptInfo *inner_rel,
+								   JoinType join_type,
+								   JoinPathExtraData *extra,
+								   uint32_t xpu_task_flags,
+								   const CustomPathMethods *xpujoin_path_methods)
+{
+	List	   *leaf_rels = NIL;
+	List	   *subpaths = NIL;
+	Path	   *inner_path = inner_rel->cheapest_total_path;
+	AppendPath *apath;
+	ListCell   *lc;
+
+	/*
+	 * Only simple scan on the partitioned table at the outer side; RIGHT
+	 * or FULL OUTER JOIN needs the inner rows not matched to any partitions.
+	 */
+	if (!pgstrom_enable_partitionwise_gpujoin ||
+		outer_rel->reloptkind != RELOPT_BASEREL ||
+		!IS_PARTITIONED_REL(outer_rel) ||
+		(join_type != JOIN_INNER &&
+		 join_type != JOIN_LEFT &&
+		 join_type != JOIN_SEMI &&
+		 join_type != JOIN_ANTI) ||
+		!inner_path ||
+		!bms_is_empty(PATH_REQ_OUTER(inner_path)))
+		return;
+	if (!__collect_partition_leaf_rels(outer_rel, &leaf_rels) ||
+		leaf_rels == NIL)
+		return;
+
+	foreach (lc, leaf_rels)
+	{
+		RelOptInfo *leaf_rel = lfirst(lc);
+		RelOptInfo *child_joinrel;
+		AppendRelInfo **appinfos;
+		int			nappinfos;
+		JoinPathExtraData child_extra;
+		CustomPath *cpath;
+
+		appinfos = find_appinfos_by_relids_nofail(root, leaf_rel->relids,
+												  &nappinfos);
+		if (nappinfos != 1)
+			return;
+		child_joinrel = __build_partition_child_joinrel(root,
+														joinrel,
+														outer_rel,
+														leaf_rel,
+														appinfos,
+														nappinfos);
+		memcpy(&child_extra, extra, sizeof(JoinPathExtraData));
+		child_extra.restrictlist = (List *)
+			adjust_appendrel_attrs(root,
+								   (Node *)extra->restrictlist,
+								   nappinfos, appinfos);
+		cpath = __build_simple_xpujoin_path(root,
+											child_joinrel,
+											leaf_rel,
+											inner_path,
+											join_type,
+											&child_extra,
+											false,
+											xpu_task_flags,
+											xpujoin_path_methods);
+		if (!cpath)
+			return;		/* all the partitions must be runnable on xPU */
+		subpaths = lappend(subpaths, cpath);
+	}
+	apath = create_append_path(root, joinrel, subpaths, NIL,
+							   NIL, NULL, 0, false, -1);
+	add_path(joinrel, &apath->path);
+}
+
+/*
+ * __xpuJoinAddCustomPathCommon
+ */
+static void
+__xpuJoinAddCustomPathCommon(PlannerInfo *root,
+							 RelOptInfo *joinrel,
+							 RelOptInfo *outerrel,
+							 RelOptInfo *innerrel,
+							 JoinType join_type,
+							 JoinPathExtraData *extra,
+							 uint32_t xpu_task_flags,
 							 const CustomPathMethods *xpujoin_path_methods)
 {
 	List	   *inner_pathlist;
@@ -600,8 +1484,13 @@ __xpuJoinAddCustomPathCommon(PlannerInfo *root,
 		join_type != JOIN_FULL &&
 		join_type != JOIN_RIGHT &&
 		join_type != JOIN_LEFT)
-		return;
-	//TODO: JOIN_SEMI and JOIN_ANTI
+	{
+		/* SEMI/ANTI JOIN are supported only by GPU */
+		if ((join_type != JOIN_SEMI &&
+			 join_type != JOIN_ANTI) ||
+			(xpu_task_flags & DEVKIND__ANY) != DEVKIND__NVIDIA_GPU)
+			return;
+	}
 
 	inner_pathlist = innerrel->pathlist;
 	for (int try_parallel=0; try_parallel < 2; try_parallel++)
@@ -634,6 +1523,15 @@ __xpuJoinAddCustomPathCommon(PlannerInfo *root,
 		/* 2nd trial uses the partial paths */
 		inner_pathlist = innerrel->partial_pathlist;
 	}
+	/* partition-wise xPU-Join, if outer is a partitioned table */
+	try_add_partitionwise_xpujoin_path(root,
+									   joinrel,
+									   outerrel,
+									   innerrel,
+									   join_type,
+									   extra,
+									   xpu_task_flags,
+									   xpujoin_path_methods);
 }
 
 /*
@@ -658,7 +1556,8 @@ XpuJoinAddCustomPath(PlannerInfo *root,
 	/* quick bailout if PG-Strom is not enabled */
 	if (pgstrom_enabled())
 	{
-		if (pgstrom_enable_gpujoin)
+		/* inner buffer is on the shared memory, invisible to remote host */
+		if (pgstrom_enable_gpujoin && !gpuServiceIsRemote())
 			__xpuJoinAddCustomPathCommon(root,
 										 joinrel,
 										 outerrel,
@@ -964,7 +1863,8 @@ static void
 pgstrom_build_join_tlist_dev(codegen_context *context,
 							 PlannerInfo *root,
 							 RelOptInfo *joinrel,
-							 List *tlist)
+							 List *tlist,
+							 pgstromPlanInfo *pp_info)
 {
 	build_tlist_dev_context __context;
 	List	   *inner_target_list = NIL;
@@ -1015,6 +1915,14 @@ pgstrom_build_join_tlist_dev(codegen_context *context,
 				__pgstrom_build_tlist_dev_walker((Node *)node, &__context);
 		}
 	}
+	/* sort keys must be on the kds_dst, if GpuSort */
+	foreach (lc, pp_info->gpusort_keys)
+	{
+		Expr   *node = lfirst(lc);
+
+		context->top_expr = node;
+		__pgstrom_build_tlist_dev_walker((Node *)node, &__context);
+	}
 	//add junk?
 	context->tlist_dev = __context.tlist_dev;
 }
@@ -1111,6 +2019,15 @@ PlanXpuJoinPathCommon(PlannerInfo *root,
 						   pp_info->scan_relid,
 						   &outer_refs);
 		}
+		else if (pp_inner->range_outer_keys != NIL)
+		{
+			/* range-join picks up the outer key from the hash-value slot */
+			hash_keys_stacked = lappend(hash_keys_stacked,
+										pp_inner->range_outer_keys);
+			pull_varattnos((Node *)pp_inner->range_outer_keys,
+						   pp_info->scan_relid,
+						   &outer_refs);
+		}
 		else
 		{
 			Assert(pp_inner->hash_outer_keys == NIL &&
@@ -1147,8 +2064,12 @@ PlanXpuJoinPathCommon(PlannerInfo *root,
 	else
 	{
 		/* build device projection */
-		pgstrom_build_join_tlist_dev(context, root, joinrel, tlist);
+		pgstrom_build_join_tlist_dev(context, root, joinrel, tlist, pp_info);
 		pp_info->kexp_projection = codegen_build_projection(context);
+		if (pp_info->gpusort_keys != NIL)
+			gpusort_build_tlist_dev(pp_info, context->tlist_dev);
+		pp_info->scan_limit = pgstrom_compute_scan_limit(root, joinrel, pp_info,
+														 &cpath->path);
 	}
 	pull_varattnos((Node *)context->tlist_dev,
 				   pp_info->scan_relid,
@@ -1174,6 +2095,10 @@ PlanXpuJoinPathCommon(PlannerInfo *root,
 	pp_info->extra_bufsz = context->extra_bufsz;
 	pp_info->used_params = context->used_params;
 	pp_info->outer_refs  = outer_refs;
+	codegen_build_dpu_prefilter(root, pp_info);
+	pgstromCostCalibrationFactors(pp_info->xpu_task_flags,
+								  &pp_info->cost_setup_factor,
+								  &pp_info->cost_run_factor);
 	/*
 	 * fixup fallback expressions
 	 */
@@ -1185,6 +2110,10 @@ PlanXpuJoinPathCommon(PlannerInfo *root,
 			= build_fallback_exprs_join(context, pp_inner->hash_outer_keys);
 		pp_inner->hash_inner_keys_fallback
 			= build_fallback_exprs_inner(context, pp_inner->hash_inner_keys);
+		pp_inner->range_inner_keys_fallback
+			= build_fallback_exprs_inner(context, pp_inner->range_inner_keys);
+		pp_inner->polygon_inner_key_fallback = (Expr *)
+			build_fallback_exprs_inner(context, (List *)pp_inner->polygon_inner_key);
 		pp_inner->join_quals_fallback
 			= build_fallback_exprs_join(context, pp_inner->join_quals);
 		pp_inner->other_quals_fallback
@@ -1367,24 +2296,473 @@ get_tuple_hashvalue(pgstromTaskInnerState *istate,
 	return hash;
 }
 
+/*
+ * get_tuple_direct_key - join-key of the direct-address map candidate
+ */
+static int64_t __rangeJoinKeyDatumToInt64(Oid type_oid, Datum datum);
+
+static bool
+get_tuple_direct_key(pgstromTaskInnerState *istate,
+					 TupleTableSlot *slot,
+					 int64_t *p_key)
+{
+	ExprContext *econtext = istate->econtext;
+	Datum		datum;
+	bool		isnull;
+
+	Assert(OidIsValid(istate->direct_key_type) &&
+		   list_length(istate->hash_inner_keys) == 1);
+	econtext->ecxt_innertuple = slot;
+	datum = ExecEvalExpr(linitial(istate->hash_inner_keys), econtext, &isnull);
+	if (isnull)
+		return false;
+	*p_key = __rangeJoinKeyDatumToInt64(istate->direct_key_type, datum);
+	return true;
+}
+
+/*
+ * The min/max join-keys are gathered by the concurrent preloading using
+ * the atomic max operations; the keys are biased to keep the order as
+ * unsigned integer, and the min-key is inverted. So, zero (the initial
+ * value of the shared state) means no keys are loaded yet.
+ */
+#define DIRECT_MAP_KEY_BIAS		0x8000000000000000UL
+
+static void
+__pg_atomic_fetch_max_u64(pg_atomic_uint64 *ptr, uint64_t value)
+{
+	uint64_t	curr_max = pg_atomic_read_u64(ptr);
+
+	while (curr_max < value)
+	{
+		if (pg_atomic_compare_exchange_u64(ptr, &curr_max, value))
+			break;
+	}
+}
+
+/*
+ * GpuGridJoin - an inner tuple shall be loaded for each cell covered by
+ * the bounding-box of the geometry. Too large geometry for the cell size
+ * is not welcome, so we set an upper limit of the cells per tuple.
+ */
+#define GPUGRIDJOIN_MAX_CELLS_PER_TUPLE		65536
+
+static int
+__compare_uint32(const void *__a, const void *__b)
+{
+	uint32_t	a = *((const uint32_t *)__a);
+	uint32_t	b = *((const uint32_t *)__b);
+
+	if (a < b)
+		return -1;
+	if (a > b)
+		return 1;
+	return 0;
+}
+
+static uint32_t
+get_tuple_grid_hashvalues(pgstromTaskInnerState *istate,
+						  TupleTableSlot *slot,
+						  uint32_t **p_hashes)
+{
+	ExprContext *econtext = istate->econtext;
+	ExprState  *es = linitial(istate->hash_inner_keys);
+	devtype_hashfunc_f h_func = linitial(istate->hash_inner_funcs);
+	double		cell_size = istate->grid_cell_size;
+	double		extent[4];
+	double		xmin, xmax, ymin, ymax;
+	double		ncells;
+	Datum		datum;
+	Datum		box3d;
+	bool		isnull;
+	uint32_t   *hashes;
+	uint32_t	nitems = 0;
+	MemoryContext oldcxt;
+	LOCAL_FCINFO(fcinfo, 1);
+
+	ResetExprContext(econtext);
+	oldcxt = MemoryContextSwitchTo(econtext->ecxt_per_tuple_memory);
+	econtext->ecxt_innertuple = slot;
+	datum = ExecEvalExpr(es, econtext, &isnull);
+	if (isnull)
+		goto out;
+	/* empty geometry has no bounding-box, thus never matches */
+	InitFunctionCallInfoData(*fcinfo, &istate->grid_fn_box3d,
+							 1, InvalidOid, NULL, NULL);
+	fcinfo->args[0].value = datum;
+	fcinfo->args[0].isnull = false;
+	box3d = FunctionCallInvoke(fcinfo);
+	if (fcinfo->isnull)
+		goto out;
+	for (int k=0; k < 4; k++)
+		extent[k] = DatumGetFloat8(FunctionCall1Coll(&istate->grid_fn_extent[k],
+													 InvalidOid, box3d));
+	xmin = floor((extent[0] - istate->grid_expand) / cell_size) + 0.0;
+	ymin = floor((extent[1] - istate->grid_expand) / cell_size) + 0.0;
+	xmax = floor((extent[2] + istate->grid_expand) / cell_size) + 0.0;
+	ymax = floor((extent[3] + istate->grid_expand) / cell_size) + 0.0;
+	ncells = (xmax - xmin + 1.0) * (ymax - ymin + 1.0);
+	if (!(ncells >= 1.0 && ncells <= GPUGRIDJOIN_MAX_CELLS_PER_TUPLE))
+		elog(ERROR, "GpuGridJoin: inner geometry covers too many cells (%.0f)",
+			 ncells);
+	hashes = palloc(sizeof(uint32_t) * (uint32_t)ncells);
+	for (double x = xmin; x <= xmax; x += 1.0)
+	{
+		for (double y = ymin; y <= ymax; y += 1.0)
+		{
+			/* see __makeGridJoinCellKey for the -0.0 normalization */
+			uint32_t	hash = 0xffffffffU;
+
+			hash ^= h_func(false, Float8GetDatum(x + 0.0));
+			hash ^= h_func(false, Float8GetDatum(y + 0.0));
+			hash ^= 0xffffffffU;
+			hashes[nitems++] = hash;
+		}
+	}
+	Assert(nitems == (uint32_t)ncells);
+	/*
+	 * Remove duplicated hash-values; an outer tuple must not see the same
+	 * inner tuple twice even when multiple cells have identical hash-value.
+	 */
+	if (nitems > 1)
+	{
+		uint32_t	j = 0;
+
+		qsort(hashes, nitems, sizeof(uint32_t), __compare_uint32);
+		for (uint32_t i=1; i < nitems; i++)
+		{
+			if (hashes[i] != hashes[j])
+				hashes[++j] = hashes[i];
+		}
+		nitems = j + 1;
+	}
+	*p_hashes = hashes;
+out:
+	MemoryContextSwitchTo(oldcxt);
+	return nitems;
+}
+
+/*
+ * Polygon-index of GpuJoin
+ *
+ * The inner POLYGON/MULTIPOLYGON values referenced by st_contains() are
+ * decoded to the edges on the inner preloading, then the edges are bucketed
+ * into the horizontal slabs of the extent (see kern_polygon_edges).
+ * The 1st scan of the inner tuples only calculates the length of the
+ * entries; the last participant of the preloading builds the index on the
+ * loaded inner buffer. Geometries that are not supported (geodetic, other
+ * types, empty, ...) are not indexed, so the device code runs the usual
+ * logic for them.
+ */
+typedef struct
+{
+	kern_polygon_edge *edges;
+	uint32_t	nedges;
+	uint32_t	nrooms;
+	bool		is_multi;
+	double		xmin, xmax;
+	double		ymin, ymax;
+} polygon_edges_builder;
+
+static bool
+__polygonEdgesAddRing(polygon_edges_builder *peb,
+					  const char *pos, uint32_t npoints, int ndims,
+					  uint32_t poly_id, uint32_t ring_id)
+{
+	double		x0 = 0.0;
+	double		y0 = 0.0;
+
+	for (uint32_t k=0; k < npoints; k++)
+	{
+		double		x1, y1;
+
+		memcpy(&x1, pos, sizeof(double));
+		memcpy(&y1, pos + sizeof(double), sizeof(double));
+		pos += sizeof(double) * ndims;
+		if (isnan(x1) || isinf(x1) || isnan(y1) || isinf(y1))
+			return false;
+		peb->xmin = Min(peb->xmin, x1);
+		peb->xmax = Max(peb->xmax, x1);
+		peb->ymin = Min(peb->ymin, y1);
+		peb->ymax = Max(peb->ymax, y1);
+		/* zero-length edge never affects to the winding number */
+		if (k > 0 && (x0 != x1 || y0 != y1))
+		{
+			kern_polygon_edge *e;
+
+			if (peb->nedges >= peb->nrooms)
+			{
+				uint32_t	nrooms_new = 2 * peb->nrooms + 1000;
+
+				if (!peb->edges)
+					peb->edges = palloc_extended(sizeof(kern_polygon_edge) * nrooms_new,
+												 MCXT_ALLOC_HUGE);
+				else
+					peb->edges = repalloc_huge(peb->edges,
+											   sizeof(kern_polygon_edge) * nrooms_new);
+				peb->nrooms = nrooms_new;
+			}
+			e = &peb->edges[peb->nedges++];
+			e->x1 = x0;
+			e->y1 = y0;
+			e->x2 = x1;
+			e->y2 = y1;
+			e->poly_id = poly_id;
+			e->ring_id = ring_id;
+		}
+		x0 = x1;
+		y0 = y1;
+	}
+	return true;
+}
+
+static const char *
+__polygonEdgesParsePolygon(polygon_edges_builder *peb,
+						   const char *pos, const char *end,
+						   uint32_t nrings, int ndims, uint32_t poly_id)
+{
+	const char *ring_sz = pos;
+
+	if (nrings > (end - pos) / sizeof(uint32_t))
+		return NULL;
+	pos += LONGALIGN(sizeof(uint32_t) * nrings);
+	if (pos > end)
+		return NULL;
+	for (uint32_t r=0; r < nrings; r++)
+	{
+		uint32_t	npoints;
+
+		memcpy(&npoints, ring_sz + sizeof(uint32_t) * r, sizeof(uint32_t));
+		if (npoints > (end - pos) / (sizeof(double) * ndims))
+			return NULL;
+		if (!__polygonEdgesAddRing(peb, pos, npoints, ndims, poly_id, r))
+			return NULL;
+		pos += sizeof(double) * ndims * npoints;
+	}
+	return pos;
+}
+
+static bool
+__polygonEdgesParse(polygon_edges_builder *peb, struct varlena *vl)
+{
+	__GSERIALIZED *gs;
+	const char *pos;
+	const char *end;
+	uint16_t	geom_flags = 0;
+	uint32_t	gs_type;
+	uint32_t	nitems;
+	int			ndims;
+
+	peb->nedges = 0;
+	peb->xmin = DBL_MAX;
+	peb->xmax = -DBL_MAX;
+	peb->ymin = DBL_MAX;
+	peb->ymax = -DBL_MAX;
+	if (VARATT_IS_EXTERNAL(vl) || VARATT_IS_COMPRESSED(vl))
+		return false;
+	gs = (__GSERIALIZED *)VARDATA_ANY(vl);
+	end = (const char *)gs + VARSIZE_ANY_EXHDR(vl);
+	pos = gs->data;
+	if (pos > end)
+		return false;
+	if ((gs->gflags & G2FLAG_VER_0) != 0)
+	{
+		/* see __geometry_datum_ref_v2 */
+		if ((gs->gflags & G2FLAG_Z) != 0)
+			geom_flags |= GEOM_FLAG__Z;
+		if ((gs->gflags & G2FLAG_M) != 0)
+			geom_flags |= GEOM_FLAG__M;
+		if ((gs->gflags & G2FLAG_BBOX) != 0)
+			geom_flags |= GEOM_FLAG__BBOX;
+		if ((gs->gflags & G2FLAG_GEODETIC) != 0)
+			geom_flags |= GEOM_FLAG__GEODETIC;
+		if ((gs->gflags & G2FLAG_EXTENDED) != 0)
+			pos += sizeof(uint64_t);
+	}
+	else
+	{
+		/* see __geometry_datum_ref_v1 */
+		if ((gs->gflags & G1FLAG_Z) != 0)
+			geom_flags |= GEOM_FLAG__Z;
+		if ((gs->gflags & G1FLAG_M) != 0)
+			geom_flags |= GEOM_FLAG__M;
+		if ((gs->gflags & G1FLAG_BBOX) != 0)
+			geom_flags |= GEOM_FLAG__BBOX;
+		if ((gs->gflags & G1FLAG_GEODETIC) != 0)
+			geom_flags |= GEOM_FLAG__GEODETIC;
+	}
+	if ((geom_flags & GEOM_FLAG__GEODETIC) != 0)
+		return false;
+	if ((geom_flags & GEOM_FLAG__BBOX) != 0)
+		pos += geometry_bbox_size(geom_flags);
+	ndims = GEOM_FLAGS_NDIMS(geom_flags);
+	if (pos + 2 * sizeof(uint32_t) > end)
+		return false;
+	memcpy(&gs_type, pos, sizeof(uint32_t));
+	memcpy(&nitems, pos + sizeof(uint32_t), sizeof(uint32_t));
+	pos += 2 * sizeof(uint32_t);
+
+	if (gs_type == GEOM_POLYGONTYPE)
+	{
+		peb->is_multi = false;
+		pos = __polygonEdgesParsePolygon(peb, pos, end, nitems, ndims, 0);
+	}
+	else if (gs_type == GEOM_MULTIPOLYGONTYPE)
+	{
+		peb->is_multi = true;
+		for (uint32_t i=0; pos && i < nitems; i++)
+		{
+			uint32_t	__type;
+			uint32_t	__nrings;
+
+			if (pos + 2 * sizeof(uint32_t) > end)
+				return false;
+			memcpy(&__type, pos, sizeof(uint32_t));
+			memcpy(&__nrings, pos + sizeof(uint32_t), sizeof(uint32_t));
+			pos += 2 * sizeof(uint32_t);
+			if (__type != GEOM_POLYGONTYPE)
+				return false;
+			pos = __polygonEdgesParsePolygon(peb, pos, end, __nrings, ndims, i);
+		}
+	}
+	else
+		return false;
+
+	return (pos != NULL && peb->nedges > 0);
+}
+
+/*
+ * __polygonEdgesSetup
+ *
+ * It returns the length of kern_polygon_edges, and also builds the entry
+ * if 'pe' is not NULL. The number of slabs is reduced if long edges are
+ * referenced by too many slabs.
+ */
+static size_t
+__polygonEdgesSetup(polygon_edges_builder *peb, kern_polygon_edges *pe)
+{
+	kern_polygon_edges __pe;
+	uint32_t	nslabs = Min(Max(peb->nedges / 4, 1), 65536);
+	uint64_t	nrefs;
+	uint32_t   *slabs;
+	uint32_t   *refs;
+	uint32_t   *cursor;
+
+	memset(&__pe, 0, sizeof(kern_polygon_edges));
+	__pe.is_multi = peb->is_multi;
+	__pe.nedges = peb->nedges;
+	__pe.xmin = peb->xmin;
+	__pe.xmax = peb->xmax;
+	__pe.ymin = peb->ymin;
+	__pe.ymax = peb->ymax;
+	for (;;)
+	{
+		__pe.nslabs = nslabs;
+		__pe.slab_unit = (peb->ymax - peb->ymin) / (double)nslabs;
+		nrefs = 0;
+		for (uint32_t j=0; j < peb->nedges; j++)
+		{
+			kern_polygon_edge *e = &peb->edges[j];
+
+			nrefs += (KERN_POLYGON_EDGES_SLAB(&__pe, Max(e->y1, e->y2)) -
+					  KERN_POLYGON_EDGES_SLAB(&__pe, Min(e->y1, e->y2)) + 1);
+		}
+		if (nslabs == 1 || nrefs <= 4 * (uint64_t)peb->nedges)
+			break;
+		nslabs /= 2;
+	}
+	__pe.nrefs = nrefs;
+	__pe.length = KERN_POLYGON_EDGES_LENGTH(nslabs, nrefs, peb->nedges);
+	if (!pe)
+		return __pe.length;
+
+	memcpy(pe, &__pe, offsetof(kern_polygon_edges, data));
+	slabs = KERN_POLYGON_EDGES_SLABS(pe);
+	refs  = KERN_POLYGON_EDGES_REFS(pe);
+	memset(slabs, 0, sizeof(uint32_t) * (nslabs + 1));
+	for (uint32_t j=0; j < peb->nedges; j++)
+	{
+		kern_polygon_edge *e = &peb->edges[j];
+		uint32_t	k1 = KERN_POLYGON_EDGES_SLAB(pe, Min(e->y1, e->y2));
+		uint32_t	k2 = KERN_POLYGON_EDGES_SLAB(pe, Max(e->y1, e->y2));
+
+		for (uint32_t k=k1; k <= k2; k++)
+			slabs[k+1]++;
+	}
+	for (uint32_t k=0; k < nslabs; k++)
+		slabs[k+1] += slabs[k];
+	Assert(slabs[nslabs] == nrefs);
+	/* edge references are in ascending order on each slab */
+	cursor = palloc(sizeof(uint32_t) * nslabs);
+	memcpy(cursor, slabs, sizeof(uint32_t) * nslabs);
+	for (uint32_t j=0; j < peb->nedges; j++)
+	{
+		kern_polygon_edge *e = &peb->edges[j];
+		uint32_t	k1 = KERN_POLYGON_EDGES_SLAB(pe, Min(e->y1, e->y2));
+		uint32_t	k2 = KERN_POLYGON_EDGES_SLAB(pe, Max(e->y1, e->y2));
+
+		for (uint32_t k=k1; k <= k2; k++)
+			refs[cursor[k]++] = j;
+	}
+	pfree(cursor);
+	memcpy(KERN_POLYGON_EDGES_ITEMS(pe), peb->edges,
+		   sizeof(kern_polygon_edge) * peb->nedges);
+	return __pe.length;
+}
+
+/*
+ * __innerPreloadPolygonEdges
+ *
+ * It evaluates the inner geometry of the tuple, then returns the length of
+ * its kern_polygon_edges, or 0 if not indexable.
+ */
+static size_t
+__innerPreloadPolygonEdges(pgstromTaskInnerState *istate,
+						   TupleTableSlot *slot,
+						   polygon_edges_builder *peb,
+						   Datum *p_datum)
+{
+	ExprContext *econtext = istate->econtext;
+	Datum		datum;
+	bool		isnull;
+	size_t		len;
+
+	ResetExprContext(econtext);
+	econtext->ecxt_innertuple = slot;
+	datum = ExecEvalExprSwitchContext(istate->polygon_inner_key,
+									  econtext, &isnull);
+	if (isnull || !__polygonEdgesParse(peb, (struct varlena *)DatumGetPointer(datum)))
+		return 0;
+	len = __polygonEdgesSetup(peb, NULL);
+	if (len > MaxAllocSize)
+		return 0;
+	if (p_datum)
+		*p_datum = datum;
+	return len;
+}
+
 /*
  * execInnerPreloadOneDepth
  */
 static void
 execInnerPreloadOneDepth(MemoryContext memcxt,
 						 pgstromTaskInnerState *istate,
-						 pg_atomic_uint64 *p_shared_inner_nitems,
-						 pg_atomic_uint64 *p_shared_inner_usage)
+						 pgstromSharedInnerState *ps_inner)
 {
 	PlanState	   *ps = istate->ps;
 	MemoryContext	oldcxt;
 	inner_preload_buffer *preload_buf;
+	polygon_edges_builder peb;
+	uint64_t		polyidx_usage = 0;
+	int64_t			dmap_key_min = PG_INT64_MAX;
+	int64_t			dmap_key_max = PG_INT64_MIN;
 
 	/* initial alloc of inner_preload_buffer */
 	preload_buf = MemoryContextAlloc(memcxt, offsetof(inner_preload_buffer,
 													  rows[12000]));
 	memset(preload_buf, 0, offsetof(inner_preload_buffer, rows));
 	preload_buf->nrooms = 12000;
+	memset(&peb, 0, sizeof(polygon_edges_builder));
 
 	for (;;)
 	{
@@ -1426,16 +2804,48 @@ execInnerPreloadOneDepth(MemoryContext memcxt,
 															  rows[nrooms_new]));
 			preload_buf->nrooms = nrooms_new;
 		}
+		if (istate->grid_cell_size > 0.0)
+		{
+			uint32_t   *hashes;
+			uint32_t	nitems = get_tuple_grid_hashvalues(istate, slot, &hashes);
+
+			if (preload_buf->nitems + nitems > preload_buf->nrooms)
+			{
+				uint32_t	nrooms_new = (2 * preload_buf->nrooms +
+										  nitems + 4000);
+
+				preload_buf = repalloc_huge(preload_buf, offsetof(inner_preload_buffer,
+																  rows[nrooms_new]));
+				preload_buf->nrooms = nrooms_new;
+			}
+			for (uint32_t k=0; k < nitems; k++)
+			{
+				index = preload_buf->nitems++;
+				preload_buf->rows[index].htup = htup;
+				preload_buf->rows[index].hash = hashes[k];
+				preload_buf->usage += MAXALIGN(offsetof(kern_hashitem,
+														t.htup) + htup->t_len);
+			}
+			MemoryContextSwitchTo(oldcxt);
+			continue;
+		}
 		index = preload_buf->nitems++;
 
 		if (istate->hash_inner_keys != NIL)
 		{
 			uint32_t	hash = get_tuple_hashvalue(istate, slot);
+			int64_t		key;
 
 			preload_buf->rows[index].htup = htup;
 			preload_buf->rows[index].hash = hash;
 			preload_buf->usage += MAXALIGN(offsetof(kern_hashitem,
 													t.htup) + htup->t_len);
+			if (OidIsValid(istate->direct_key_type) &&
+				get_tuple_direct_key(istate, slot, &key))
+			{
+				dmap_key_min = Min(dmap_key_min, key);
+				dmap_key_max = Max(dmap_key_max, key);
+			}
 		}
 		else if (istate->gist_irel)
 		{
@@ -1461,12 +2871,51 @@ execInnerPreloadOneDepth(MemoryContext memcxt,
 			preload_buf->rows[index].hash = 0;
 			preload_buf->usage += MAXALIGN(offsetof(kern_tupitem,
 													htup) + htup->t_len);
+			if (istate->polygon_inner_key)
+				polyidx_usage += MAXALIGN(__innerPreloadPolygonEdges(istate, slot,
+																	 &peb, NULL));
 		}
 		MemoryContextSwitchTo(oldcxt);
 	}
+	if (peb.edges)
+		pfree(peb.edges);
 	istate->preload_buffer = preload_buf;
-	pg_atomic_fetch_add_u64(p_shared_inner_nitems, preload_buf->nitems);
-	pg_atomic_fetch_add_u64(p_shared_inner_usage,  preload_buf->usage);
+	pg_atomic_fetch_add_u64(&ps_inner->inner_nitems, preload_buf->nitems);
+	pg_atomic_fetch_add_u64(&ps_inner->inner_usage,  preload_buf->usage);
+	if (polyidx_usage > 0)
+		pg_atomic_fetch_add_u64(&ps_inner->polyidx_usage, polyidx_usage);
+	if (dmap_key_min <= dmap_key_max)
+	{
+		__pg_atomic_fetch_max_u64(&ps_inner->dmap_key_max,
+								  (uint64_t)dmap_key_max ^ DIRECT_MAP_KEY_BIAS);
+		__pg_atomic_fetch_max_u64(&ps_inner->dmap_key_min,
+								  ~((uint64_t)dmap_key_min ^ DIRECT_MAP_KEY_BIAS));
+	}
+
+	/* grace hash-join also needs the size of individual partitions */
+	if (istate->inner_nparts > 1)
+	{
+		uint64_t	part_nitems[GPUJOIN_MAX_INNER_PARTITIONS];
+		uint64_t	part_usage[GPUJOIN_MAX_INNER_PARTITIONS];
+
+		Assert(istate->inner_nparts <= GPUJOIN_MAX_INNER_PARTITIONS);
+		memset(part_nitems, 0, sizeof(part_nitems));
+		memset(part_usage, 0, sizeof(part_usage));
+		for (uint32_t index=0; index < preload_buf->nitems; index++)
+		{
+			HeapTuple	htup = preload_buf->rows[index].htup;
+			uint32_t	part_id = KERN_HASH_PARTITION_ID(preload_buf->rows[index].hash,
+														 istate->inner_nparts);
+			part_nitems[part_id]++;
+			part_usage[part_id] += MAXALIGN(offsetof(kern_hashitem,
+													 t.htup) + htup->t_len);
+		}
+		for (int k=0; k < istate->inner_nparts; k++)
+		{
+			pg_atomic_fetch_add_u64(&ps_inner->part_nitems[k], part_nitems[k]);
+			pg_atomic_fetch_add_u64(&ps_inner->part_usage[k],  part_usage[k]);
+		}
+	}
 }
 
 /*
@@ -1515,55 +2964,642 @@ innerPreloadSetupGiSTIndex(kern_data_store *kds_gist)
 									   InvalidOffsetNumber);
 }
 
+
 /*
- * innerPreloadAllocHostBuffer
+ * __innerPreloadSetupBloomFilter
  *
- * NOTE: This function is called with preload_mutex locked
+ * It assigns the bloom-filter on the inner hash table; 8 bits per inner
+ * tuple (at most 16MB) is a reasonable choice for two hash functions.
+ * It returns the length of the bloom-filter.
  */
-static void
-innerPreloadAllocHostBuffer(pgstromTaskState *pts)
-{
-	pgstromSharedState *ps_state = pts->ps_state;
-	kern_multirels	   *h_kmrels = NULL;
-	kern_data_store	   *kds = NULL;
-	size_t				offset;
+#define GPUJOIN_BLOOM_FILTER_MIN_NBITS		(1U << 12)
+#define GPUJOIN_BLOOM_FILTER_MAX_NBITS		(1U << 27)
 
-	/* other backend already setup the buffer metadata */
-	if (ps_state->preload_shmem_length > 0)
-		return;
-	
-	/*
-	 * 1st pass: calculation of the buffer length
-	 * 2nd pass: initialization of buffer metadata
-	 */
-again:
-	offset = MAXALIGN(offsetof(kern_multirels, chunks[pts->num_rels]));
-	for (int i=0; i < pts->num_rels; i++)
+static size_t
+__innerPreloadSetupBloomFilter(kern_multirels *h_kmrels, int dindex,
+							   size_t offset, uint64_t nrooms)
+{
+	uint32_t	nbits = GPUJOIN_BLOOM_FILTER_MIN_NBITS;
+	size_t		nbytes;
+
+	if (!pgstrom_enable_gpujoin_bloom_filter)
+		return 0;
+	while (nbits < GPUJOIN_BLOOM_FILTER_MAX_NBITS && nbits < 8 * nrooms)
+		nbits <<= 1;
+	nbytes = MAXALIGN(nbits / BITS_PER_BYTE);
+	if (h_kmrels)
 	{
-		pgstromTaskInnerState *istate = &pts->inners[i];
-		TupleDesc	tupdesc = istate->ps->ps_ResultTupleDesc;
-		uint64_t	nrooms;
-		uint64_t	usage;
-		size_t		nbytes;
+		h_kmrels->chunks[dindex].bloom_offset = offset;
+		h_kmrels->chunks[dindex].bloom_nbits = nbits;
+		memset((char *)h_kmrels + offset, 0, nbytes);
+	}
+	return nbytes;
+}
 
-		nrooms = pg_atomic_read_u64(&ps_state->inners[i].inner_nitems);
-		usage  = pg_atomic_read_u64(&ps_state->inners[i].inner_usage);
-		if (h_kmrels)
-		{
-			kds = (kern_data_store *)((char *)h_kmrels + offset);
-			h_kmrels->chunks[i].kds_offset = offset;
-		}
+/*
+ * __innerPreloadSetupHashBucket
+ */
+static size_t
+__innerPreloadSetupHashBucket(kern_multirels *h_kmrels, int dindex,
+							  size_t offset, uint32_t nslots, uint64_t nrooms)
+{
+	if (!pgstrom_enable_gpujoin_hash_bucket)
+		return 0;
+	if (h_kmrels)
+		h_kmrels->chunks[dindex].hbucket_offset = offset;
+	return KERN_HASH_BUCKET_LENGTH(nslots, nrooms);
+}
 
-		nbytes = estimate_kern_data_store(tupdesc);
-		if (istate->hash_inner_keys != NIL &&
-			istate->hash_outer_keys != NIL)
-		{
-			/* Hash-Join */
-			uint32_t	nslots = Max(320, nrooms);
+/*
+ * __innerPreloadSetupDirectMap
+ *
+ * It assigns the direct-address map on the inner hash table, if the range
+ * of the join-key is dense enough. Because a probe on the direct-address
+ * map needs neither the bloom-filter nor the hash-bucket, they are not
+ * assigned if it returns non-zero length.
+ */
+#define GPUJOIN_DIRECT_MAP_MAX_DENSITY		4		/* slots per inner row */
+#define GPUJOIN_DIRECT_MAP_MAX_NSLOTS		(1U << 28)
 
-			nbytes += (MAXALIGN(sizeof(uint32_t) * nrooms) +
-					   MAXALIGN(sizeof(uint32_t) * nslots) +
-					   MAXALIGN(usage));
+static size_t
+__innerPreloadSetupDirectMap(pgstromTaskState *pts,
+							 kern_multirels *h_kmrels, int dindex,
+							 size_t offset, uint64_t nrooms)
+{
+	pgstromTaskInnerState *istate = &pts->inners[dindex];
+	pgstromSharedInnerState *ps_inner = &pts->ps_state->inners[dindex];
+	uint64_t	key_max;
+	uint64_t	key_min;
+	uint64_t	nslots;
+
+	if (!pgstrom_enable_gpujoin_direct_map ||
+		!OidIsValid(istate->direct_key_type) ||
+		(pts->xpu_task_flags & DEVKIND__NVIDIA_GPU) == 0 ||
+		nrooms == 0)
+		return 0;
+	key_max = pg_atomic_read_u64(&ps_inner->dmap_key_max);
+	key_min = pg_atomic_read_u64(&ps_inner->dmap_key_min);
+	if (key_max == 0 && key_min == 0)
+		return 0;		/* all the join-keys are NULL */
+	key_max = key_max ^ DIRECT_MAP_KEY_BIAS;
+	key_min = ~key_min ^ DIRECT_MAP_KEY_BIAS;
+	nslots = key_max - key_min + 1;
+	if (nslots == 0 ||
+		nslots > GPUJOIN_DIRECT_MAP_MAX_NSLOTS ||
+		nslots > GPUJOIN_DIRECT_MAP_MAX_DENSITY * nrooms)
+		return 0;
+	if (h_kmrels)
+	{
+		kern_direct_map *dmap = (kern_direct_map *)((char *)h_kmrels + offset);
+
+		h_kmrels->chunks[dindex].dmap_offset = offset;
+		dmap->key_min = (int64_t)key_min;
+		dmap->nslots = nslots;
+		dmap->nitems = 0;
+		pg_atomic_write_u64(&ps_inner->dmap_nslots, nslots);
+	}
+	return KERN_DIRECT_MAP_LENGTH(nslots, nrooms);
+}
+
+/*
+ * innerPreloadBuildHashBucket
+ *
+ * It builds the hash-bucket from the hash-slot once all the inner tuples
+ * are loaded. Only the last participant of the inner preloading runs it.
+ * The items are sorted by the hash value within the hash-slot, then
+ * heavy-hitter keys (that have massive duplications) are counted for
+ * EXPLAIN ANALYZE.
+ */
+#define GPUJOIN_HEAVY_HITTER_MIN_DUPS	(2 * WARPSIZE)
+#define GPUJOIN_HEAVY_HITTER_RATIO		0.001
+
+typedef struct
+{
+	uint32_t	hash;
+	uint32_t	item;
+} hash_bucket_entry;
+
+static int
+__compare_hash_bucket_entry(const void *__a, const void *__b)
+{
+	const hash_bucket_entry *a = __a;
+	const hash_bucket_entry *b = __b;
+
+	if (a->hash < b->hash)
+		return -1;
+	if (a->hash > b->hash)
+		return 1;
+	return 0;
+}
+
+static void
+innerPreloadBuildHashBucket(pgstromTaskState *pts)
+{
+	kern_multirels *h_kmrels = pts->h_kmrels;
+	hash_bucket_entry *entries = NULL;
+	uint32_t	nrooms = 0;
+
+	for (int i=0; i < h_kmrels->num_rels; i++)
+	{
+		kern_hash_bucket *hbucket = KERN_MULTIRELS_HASH_BUCKET(h_kmrels, i);
+		kern_data_store *kds = KERN_MULTIRELS_INNER_KDS(h_kmrels, i);
+		uint32_t   *hashes;
+		uint32_t   *items;
+		uint32_t	hpos = 0;
+		uint64_t	skew_threshold;
+		uint64_t	skew_nkeys = 0;
+		uint64_t	skew_max_dups = 0;
+
+		if (!hbucket)
+			continue;
+		Assert(kds->format == KDS_FORMAT_HASH);
+		hbucket->nslots = kds->hash_nslots;
+		hbucket->nitems = kds->nitems;
+		/*
+		 * GPU builds the hash-bucket by itself from the hash-slot, using
+		 * thousands of threads; it is much faster than the single process
+		 * walk on the hash-slot here. Only the GPU uses the hash-bucket,
+		 * so we can skip it, however, the skew statistics are not
+		 * available in this case.
+		 */
+		if (pgstrom_enable_gpujoin_device_hash_bucket &&
+			(pts->xpu_task_flags & DEVKIND__NVIDIA_GPU) != 0)
+		{
+			h_kmrels->chunks[i].hbucket_on_device = true;
+			pg_atomic_write_u64(&pts->ps_state->inners[i].skew_nkeys, 0);
+			pg_atomic_write_u64(&pts->ps_state->inners[i].skew_max_dups, 0);
+			continue;
+		}
+		h_kmrels->chunks[i].hbucket_on_device = false;
+		hashes = KERN_HASH_BUCKET_HASHES(hbucket);
+		items  = KERN_HASH_BUCKET_ITEMS(hbucket);
+		skew_threshold = Max(GPUJOIN_HEAVY_HITTER_MIN_DUPS,
+							 (uint64_t)((double)kds->nitems *
+										GPUJOIN_HEAVY_HITTER_RATIO));
+		for (uint32_t k=0; k < hbucket->nslots; k++)
+		{
+			kern_hashitem *hitem;
+			uint32_t	nitems = 0;
+			uint32_t	ndups = 0;
+
+			for (hitem = KDS_HASH_FIRST_ITEM(kds, k);
+				 hitem != NULL;
+				 hitem = KDS_HASH_NEXT_ITEM(kds, hitem->next))
+			{
+				if (nitems >= nrooms)
+				{
+					nrooms = 2 * nrooms + 1000;
+					if (!entries)
+						entries = palloc(sizeof(hash_bucket_entry) * nrooms);
+					else
+						entries = repalloc_huge(entries, sizeof(hash_bucket_entry) * nrooms);
+				}
+				entries[nitems].hash = hitem->hash;
+				entries[nitems].item = __kds_packed((char *)kds + kds->length - (char *)hitem);
+				nitems++;
+			}
+			if (nitems > 1)
+				qsort(entries, nitems, sizeof(hash_bucket_entry),
+					  __compare_hash_bucket_entry);
+
+			hbucket->start[k] = hpos;
+			for (uint32_t j=0; j < nitems; j++)
+			{
+				Assert(hpos < hbucket->nitems);
+				hashes[hpos] = entries[j].hash;
+				items[hpos] = entries[j].item;
+				hpos++;
+				/* count up the heavy-hitter keys */
+				ndups++;
+				if (j+1 == nitems || entries[j+1].hash != entries[j].hash)
+				{
+					if (ndups >= skew_threshold)
+						skew_nkeys++;
+					skew_max_dups = Max(skew_max_dups, ndups);
+					ndups = 0;
+				}
+			}
+		}
+		hbucket->start[hbucket->nslots] = hpos;
+
+		pg_atomic_write_u64(&pts->ps_state->inners[i].skew_nkeys, skew_nkeys);
+		pg_atomic_write_u64(&pts->ps_state->inners[i].skew_max_dups, skew_max_dups);
+		if (skew_nkeys > 0)
+			elog(DEBUG1, "GpuHashJoin depth=%d has %lu heavy-hitter keys (max %lu dups in %u rows)",
+				 i+1, skew_nkeys, skew_max_dups, kds->nitems);
+	}
+	if (entries)
+		pfree(entries);
+}
+
+/*
+ * innerPreloadBuildRangeIndex
+ *
+ * It builds the range-index of the inner heap buffer once all the inner
+ * tuples are loaded. Only the last participant of the inner preloading
+ * runs it. The inner tuples with NULL bounds are not indexed, because
+ * the join-quals never match them.
+ */
+typedef struct
+{
+	int64_t		lower;
+	int64_t		upper;
+	uint32_t	rowid;
+} range_index_entry;
+
+static int
+__compare_range_index_entry(const void *__a, const void *__b)
+{
+	const range_index_entry *a = __a;
+	const range_index_entry *b = __b;
+
+	if (a->lower < b->lower)
+		return -1;
+	if (a->lower > b->lower)
+		return 1;
+	if (a->upper < b->upper)
+		return -1;
+	if (a->upper > b->upper)
+		return 1;
+	return 0;
+}
+
+static int64_t
+__rangeJoinKeyDatumToInt64(Oid type_oid, Datum datum)
+{
+	switch (type_oid)
+	{
+		case INT2OID:
+			return (int64_t)DatumGetInt16(datum);
+		case INT4OID:
+			return (int64_t)DatumGetInt32(datum);
+		case INT8OID:
+			return (int64_t)DatumGetInt64(datum);
+		case DATEOID:
+			return (int64_t)DatumGetDateADT(datum);
+		case TIMESTAMPOID:
+			return (int64_t)DatumGetTimestamp(datum);
+		case TIMESTAMPTZOID:
+			return (int64_t)DatumGetTimestampTz(datum);
+		default:
+			elog(ERROR, "unsupported range-join key type: %s",
+				 format_type_be(type_oid));
+	}
+	return 0;	/* not reachable */
+}
+
+static void
+innerPreloadBuildRangeIndex(pgstromTaskState *pts)
+{
+	kern_multirels *h_kmrels = pts->h_kmrels;
+
+	for (int i=0; i < h_kmrels->num_rels; i++)
+	{
+		pgstromTaskInnerState *istate = &pts->inners[i];
+		kern_range_index *ridx = KERN_MULTIRELS_RANGE_INDEX(h_kmrels, i);
+		kern_data_store *kds = KERN_MULTIRELS_INNER_KDS(h_kmrels, i);
+		ExprContext *econtext = istate->econtext;
+		TupleTableSlot *slot;
+		range_index_entry *entries;
+		int64_t	   *upper;
+		int64_t	   *upper_max;
+		uint32_t   *rowids;
+		uint32_t	nitems = 0;
+
+		if (!ridx)
+			continue;
+		Assert(kds->format == KDS_FORMAT_ROW &&
+			   list_length(istate->range_inner_keys) == 2);
+		slot = MakeSingleTupleTableSlot(istate->ps->ps_ResultTupleDesc,
+										&TTSOpsHeapTuple);
+		entries = MemoryContextAllocHuge(CurrentMemoryContext,
+										 sizeof(range_index_entry) *
+										 Max(kds->nitems, 1));
+		for (uint32_t rowid=0; rowid < kds->nitems; rowid++)
+		{
+			kern_tupitem *tupitem = KDS_GET_TUPITEM(kds, rowid);
+			HeapTupleData tuple;
+			Datum		lower;
+			Datum		upper;
+			bool		lower_isnull;
+			bool		upper_isnull;
+
+			if (!tupitem)
+				continue;
+			tuple.t_len = tupitem->t_len;
+			ItemPointerSetInvalid(&tuple.t_self);
+			tuple.t_tableOid = InvalidOid;
+			tuple.t_data = &tupitem->htup;
+			ExecStoreHeapTuple(&tuple, slot, false);
+
+			ResetExprContext(econtext);
+			econtext->ecxt_innertuple = slot;
+			lower = ExecEvalExprSwitchContext(linitial(istate->range_inner_keys),
+											  econtext, &lower_isnull);
+			upper = ExecEvalExprSwitchContext(lsecond(istate->range_inner_keys),
+											  econtext, &upper_isnull);
+			if (lower_isnull || upper_isnull)
+				continue;
+			entries[nitems].lower =
+				__rangeJoinKeyDatumToInt64(linitial_oid(istate->range_inner_types),
+										   lower);
+			entries[nitems].upper =
+				__rangeJoinKeyDatumToInt64(lsecond_oid(istate->range_inner_types),
+										   upper);
+			entries[nitems].rowid = rowid;
+			nitems++;
+		}
+		ExecDropSingleTupleTableSlot(slot);
+		if (nitems > 1)
+			qsort(entries, nitems, sizeof(range_index_entry),
+				  __compare_range_index_entry);
+
+		ridx->nrooms = kds->nitems;
+		ridx->nitems = nitems;
+		upper     = KERN_RANGE_INDEX_UPPER(ridx);
+		upper_max = KERN_RANGE_INDEX_UPPER_MAX(ridx);
+		rowids    = KERN_RANGE_INDEX_ROWIDS(ridx);
+		for (uint32_t j=0; j < nitems; j++)
+		{
+			ridx->lower[j] = entries[j].lower;
+			upper[j]       = entries[j].upper;
+			upper_max[j]   = (j == 0 ? entries[j].upper
+							  : Max(upper_max[j-1], entries[j].upper));
+			rowids[j]      = entries[j].rowid;
+		}
+		pfree(entries);
+	}
+}
+
+/*
+ * innerPreloadBuildDirectMap
+ *
+ * It builds the direct-address map of the inner hash table once all the
+ * inner tuples are loaded, by the counting-sort of the kern_hashitem on
+ * the join-key. Only the last participant of the inner preloading runs it.
+ */
+static void
+innerPreloadBuildDirectMap(pgstromTaskState *pts)
+{
+	kern_multirels *h_kmrels = pts->h_kmrels;
+
+	for (int i=0; i < h_kmrels->num_rels; i++)
+	{
+		pgstromTaskInnerState *istate = &pts->inners[i];
+		kern_direct_map *dmap = KERN_MULTIRELS_DIRECT_MAP(h_kmrels, i);
+		kern_data_store *kds = KERN_MULTIRELS_INNER_KDS(h_kmrels, i);
+		ExprContext *econtext = istate->econtext;
+		TupleTableSlot *slot;
+		hash_bucket_entry *entries;
+		uint32_t   *items;
+		uint32_t   *start;
+		uint32_t	nitems = 0;
+		uint32_t	sum = 0;
+
+		if (!dmap)
+			continue;
+		Assert(kds->format == KDS_FORMAT_HASH);
+		slot = MakeSingleTupleTableSlot(istate->ps->ps_ResultTupleDesc,
+										&TTSOpsHeapTuple);
+		entries = MemoryContextAllocHuge(CurrentMemoryContext,
+										 sizeof(hash_bucket_entry) *
+										 Max(kds->nitems, 1));
+		items = KERN_DIRECT_MAP_ITEMS(dmap);
+		start = dmap->start;
+		memset(start, 0, sizeof(uint32_t) * (dmap->nslots + 1));
+		/* 1st pass - count the items for each key */
+		for (uint32_t k=0; k < kds->hash_nslots; k++)
+		{
+			kern_hashitem *hitem;
+
+			for (hitem = KDS_HASH_FIRST_ITEM(kds, k);
+				 hitem != NULL;
+				 hitem = KDS_HASH_NEXT_ITEM(kds, hitem->next))
+			{
+				HeapTupleData tuple;
+				int64_t		key;
+				uint64_t	index;
+
+				tuple.t_len = hitem->t.t_len;
+				ItemPointerSetInvalid(&tuple.t_self);
+				tuple.t_tableOid = InvalidOid;
+				tuple.t_data = &hitem->t.htup;
+				ExecStoreHeapTuple(&tuple, slot, false);
+
+				ResetExprContext(econtext);
+				if (!get_tuple_direct_key(istate, slot, &key))
+					continue;
+				index = (uint64_t)key - (uint64_t)dmap->key_min;
+				if (key < dmap->key_min || index >= dmap->nslots)
+					elog(ERROR, "GpuHashJoin: join-key %ld is out of the direct-address map",
+						 key);
+				Assert(nitems < kds->nitems);
+				/* 'hash' of the entry is the index of the direct-address map */
+				entries[nitems].hash = index;
+				entries[nitems].item = __kds_packed((char *)kds + kds->length - (char *)hitem);
+				start[index]++;
+				nitems++;
+			}
+		}
+		ExecDropSingleTupleTableSlot(slot);
+		/* 2nd pass - end of the items for each key, then fill up backward */
+		for (uint32_t k=0; k < dmap->nslots; k++)
+		{
+			sum += start[k];
+			start[k] = sum;
+		}
+		start[dmap->nslots] = sum;
+		Assert(sum == nitems);
+		for (uint32_t j=nitems; j > 0; j--)
+		{
+			uint32_t	pos = --start[entries[j-1].hash];
+
+			items[pos] = entries[j-1].item;
+		}
+		dmap->nitems = nitems;
+		pfree(entries);
+	}
+}
+
+/*
+ * innerPreloadBuildPolygonIndex
+ *
+ * It builds the polygon-index of the inner heap buffer once all the inner
+ * tuples are loaded, like innerPreloadBuildRangeIndex. The entries are
+ * sorted by the offset of the geometry datum from the inner KDS.
+ */
+static int
+__compare_polygon_index_item(const void *__a, const void *__b)
+{
+	uint64_t	a = *((const uint64_t *)__a);
+	uint64_t	b = *((const uint64_t *)__b);
+
+	if (a < b)
+		return -1;
+	if (a > b)
+		return 1;
+	return 0;
+}
+
+static void
+innerPreloadBuildPolygonIndex(pgstromTaskState *pts)
+{
+	kern_multirels *h_kmrels = pts->h_kmrels;
+	polygon_edges_builder peb;
+
+	memset(&peb, 0, sizeof(polygon_edges_builder));
+	for (int i=0; i < h_kmrels->num_rels; i++)
+	{
+		pgstromTaskInnerState *istate = &pts->inners[i];
+		kern_polygon_index *pindex = KERN_MULTIRELS_POLYGON_INDEX(h_kmrels, i);
+		kern_data_store *kds = KERN_MULTIRELS_INNER_KDS(h_kmrels, i);
+		TupleTableSlot *slot;
+		char	   *pos;
+		char	   *tail;
+
+		if (!pindex)
+			continue;
+		Assert(kds->format == KDS_FORMAT_ROW &&
+			   istate->polygon_inner_key != NULL);
+		slot = MakeSingleTupleTableSlot(istate->ps->ps_ResultTupleDesc,
+										&TTSOpsHeapTuple);
+		pos  = (char *)pindex + MAXALIGN(offsetof(kern_polygon_index,
+												  items[pindex->nrooms]));
+		tail = (char *)pindex + pindex->length;
+		for (uint32_t rowid=0; rowid < kds->nitems; rowid++)
+		{
+			kern_tupitem *tupitem = KDS_GET_TUPITEM(kds, rowid);
+			HeapTupleData tuple;
+			Datum		datum;
+			char	   *addr;
+			size_t		len;
+
+			if (!tupitem)
+				continue;
+			tuple.t_len = tupitem->t_len;
+			ItemPointerSetInvalid(&tuple.t_self);
+			tuple.t_tableOid = InvalidOid;
+			tuple.t_data = &tupitem->htup;
+			ExecStoreHeapTuple(&tuple, slot, false);
+
+			len = __innerPreloadPolygonEdges(istate, slot, &peb, &datum);
+			if (len == 0)
+				continue;
+			/* device code looks up the datum in the inner buffer */
+			addr = DatumGetPointer(datum);
+			if (addr < (char *)kds || addr >= (char *)kds + kds->length)
+				continue;
+			if (pindex->nitems >= pindex->nrooms ||
+				pos + MAXALIGN(len) > tail)
+				elog(ERROR, "Bug? polygon-index overflow");
+			__polygonEdgesSetup(&peb, (kern_polygon_edges *)pos);
+			pindex->items[pindex->nitems].gs_offset = (addr - (char *)kds);
+			pindex->items[pindex->nitems].pe_offset = (pos - (char *)pindex);
+			pindex->nitems++;
+			pos += MAXALIGN(len);
+		}
+		ExecDropSingleTupleTableSlot(slot);
+		if (pindex->nitems > 1)
+			qsort(pindex->items, pindex->nitems, sizeof(pindex->items[0]),
+				  __compare_polygon_index_item);
+	}
+	if (peb.edges)
+		pfree(peb.edges);
+}
+
+/*
+ * innerPreloadAllocHostBuffer
+ *
+ * NOTE: This function is called with preload_mutex locked
+ */
+static void
+innerPreloadAllocHostBuffer(pgstromTaskState *pts)
+{
+	pgstromSharedState *ps_state = pts->ps_state;
+	kern_multirels	   *h_kmrels = NULL;
+	kern_data_store	   *kds = NULL;
+	size_t				offset;
+
+	/* other backend already setup the buffer metadata */
+	if (ps_state->preload_shmem_length > 0)
+		return;
+	
+	/*
+	 * 1st pass: calculation of the buffer length
+	 * 2nd pass: initialization of buffer metadata
+	 */
+again:
+	offset = MAXALIGN(offsetof(kern_multirels, chunks[pts->num_rels]));
+	for (int i=0; i < pts->num_rels; i++)
+	{
+		pgstromTaskInnerState *istate = &pts->inners[i];
+		TupleDesc	tupdesc = istate->ps->ps_ResultTupleDesc;
+		uint64_t	nrooms;
+		uint64_t	usage;
+		size_t		nbytes;
+
+		nrooms = pg_atomic_read_u64(&ps_state->inners[i].inner_nitems);
+		usage  = pg_atomic_read_u64(&ps_state->inners[i].inner_usage);
+		if (h_kmrels)
+		{
+			kds = (kern_data_store *)((char *)h_kmrels + offset);
+			h_kmrels->chunks[i].kds_offset = offset;
+		}
+
+		nbytes = estimate_kern_data_store(tupdesc);
+		if (istate->inner_nparts > 1)
+		{
+			/* Grace Hash-Join */
+			uint64_t   *parts = NULL;
+
+			Assert(istate->hash_inner_keys != NIL &&
+				   istate->hash_outer_keys != NIL &&
+				   istate->join_type == JOIN_INNER);
+			if (h_kmrels)
+			{
+				parts = (uint64_t *)((char *)h_kmrels + offset);
+				h_kmrels->chunks[i].parts_offset = offset;
+				h_kmrels->chunks[i].num_parts = istate->inner_nparts;
+			}
+			offset += MAXALIGN(sizeof(uint64_t) * istate->inner_nparts);
+
+			for (int k=0; k < istate->inner_nparts; k++)
+			{
+				uint64_t	part_nrooms;
+				uint64_t	part_usage;
+				uint32_t	nslots;
+
+				part_nrooms = pg_atomic_read_u64(&ps_state->inners[i].part_nitems[k]);
+				part_usage  = pg_atomic_read_u64(&ps_state->inners[i].part_usage[k]);
+				nslots = Max(320, part_nrooms);
+				nbytes = (estimate_kern_data_store(tupdesc) +
+						  MAXALIGN(sizeof(uint32_t) * part_nrooms) +
+						  MAXALIGN(sizeof(uint32_t) * nslots) +
+						  MAXALIGN(part_usage));
+				if (h_kmrels)
+				{
+					kds = (kern_data_store *)((char *)h_kmrels + offset);
+					parts[k] = offset;
+					if (k == 0)
+						h_kmrels->chunks[i].kds_offset = offset;
+					setup_kern_data_store(kds, tupdesc, nbytes,
+										  KDS_FORMAT_HASH);
+					kds->hash_nslots = nslots;
+					memset(KDS_GET_HASHSLOT_BASE(kds), 0, sizeof(uint32_t) * nslots);
+				}
+				offset += nbytes;
+			}
+			offset += __innerPreloadSetupBloomFilter(h_kmrels, i, offset, nrooms);
+		}
+		else if (istate->hash_inner_keys != NIL &&
+				 istate->hash_outer_keys != NIL)
+		{
+			/* Hash-Join */
+			uint32_t	nslots = Max(320, nrooms);
+
+			nbytes += (MAXALIGN(sizeof(uint32_t) * nrooms) +
+					   MAXALIGN(sizeof(uint32_t) * nslots) +
+					   MAXALIGN(usage));
 			if (h_kmrels)
 			{
 				setup_kern_data_store(kds, tupdesc, nbytes,
@@ -1572,6 +3608,14 @@ again:
 				memset(KDS_GET_HASHSLOT_BASE(kds), 0, sizeof(uint32_t) * nslots);
 			}
 			offset += nbytes;
+			nbytes = __innerPreloadSetupDirectMap(pts, h_kmrels, i, offset, nrooms);
+			if (nbytes > 0)
+				offset += nbytes;
+			else
+			{
+				offset += __innerPreloadSetupBloomFilter(h_kmrels, i, offset, nrooms);
+				offset += __innerPreloadSetupHashBucket(h_kmrels, i, offset, nslots, nrooms);
+			}
 		}
 		else if (istate->gist_irel != NULL)
 		{
@@ -1631,139 +3675,600 @@ again:
 			}
 			offset += (block_offset + BLCKSZ * nblocks);
 		}
-		else
+		else
+		{
+			/* Nested-Loop */
+			nbytes += (MAXALIGN(sizeof(uint32_t) * nrooms) +
+					   MAXALIGN(usage));
+			if (h_kmrels)
+			{
+				setup_kern_data_store(kds, tupdesc, nbytes,
+									  KDS_FORMAT_ROW);
+				h_kmrels->chunks[i].is_nestloop = true;
+			}
+			offset += nbytes;
+			/* Range-Join also needs the range-index */
+			if (istate->range_inner_keys != NIL)
+			{
+				if (h_kmrels)
+					h_kmrels->chunks[i].range_offset = offset;
+				offset += KERN_RANGE_INDEX_LENGTH(nrooms);
+			}
+			/* st_contains() on the inner polygons also needs the polygon-index */
+			if (istate->polygon_inner_key)
+			{
+				uint64_t	polyidx_usage
+					= pg_atomic_read_u64(&ps_state->inners[i].polyidx_usage);
+
+				nbytes = KERN_POLYGON_INDEX_LENGTH(nrooms, polyidx_usage);
+				if (h_kmrels)
+				{
+					kern_polygon_index *pindex = (kern_polygon_index *)
+						((char *)h_kmrels + offset);
+
+					h_kmrels->chunks[i].polyidx_offset = offset;
+					pindex->length = nbytes;
+					pindex->nrooms = nrooms;
+					pindex->nitems = 0;
+				}
+				offset += nbytes;
+			}
+		}
+
+		if (istate->join_type == JOIN_RIGHT ||
+			istate->join_type == JOIN_FULL)
+		{
+			nbytes = MAXALIGN(sizeof(bool) * nrooms);
+			if (h_kmrels)
+			{
+				h_kmrels->chunks[i].right_outer = true;
+				h_kmrels->chunks[i].ojmap_offset = offset;
+				memset((char *)h_kmrels + offset, 0, nbytes);
+			}
+			offset += nbytes;
+		}
+		if (istate->join_type == JOIN_LEFT ||
+			istate->join_type == JOIN_FULL)
+		{
+			if (h_kmrels)
+				h_kmrels->chunks[i].left_outer = true;
+		}
+		if (istate->join_type == JOIN_SEMI)
+		{
+			if (h_kmrels)
+				h_kmrels->chunks[i].semi_join = true;
+		}
+		if (istate->join_type == JOIN_ANTI)
+		{
+			if (h_kmrels)
+				h_kmrels->chunks[i].anti_join = true;
+		}
+	}
+
+	/*
+	 * allocation of the host inner-buffer
+	 */
+	if (!h_kmrels)
+	{
+		size_t		shmem_length = PAGE_ALIGN(offset);
+
+		Assert(ps_state->preload_shmem_handle != 0);
+		h_kmrels = __mmapShmem(ps_state->preload_shmem_handle,
+							   shmem_length, pts->ds_entry);
+		memset(h_kmrels, 0, offsetof(kern_multirels,
+									 chunks[pts->num_rels]));
+		h_kmrels->length = offset;
+		h_kmrels->num_rels = pts->num_rels;
+		ps_state->preload_shmem_length = shmem_length;
+		goto again;
+	}
+	pts->h_kmrels = h_kmrels;
+}
+
+/*
+ * __innerPreloadSetupHeapBuffer
+ */
+static void
+__innerPreloadSetupHeapBuffer(kern_data_store *kds,
+							  pgstromTaskInnerState *istate,
+							  uint32_t base_nitems,
+							  uint32_t base_usage)
+{
+	uint32_t   *row_index = KDS_GET_ROWINDEX(kds);
+	uint32_t	rowid = base_nitems;
+	char	   *tail_pos = (char *)kds + kds->length;
+	char	   *curr_pos = tail_pos - __kds_unpack(base_usage);
+	inner_preload_buffer *preload_buf = istate->preload_buffer;
+
+	for (uint32_t index=0; index < preload_buf->nitems; index++)
+	{
+		HeapTuple	htup = preload_buf->rows[index].htup;
+		size_t		sz;
+		kern_tupitem *titem;
+
+		sz = MAXALIGN(offsetof(kern_tupitem, htup) + htup->t_len);
+		curr_pos -= sz;
+		titem = (kern_tupitem *)curr_pos;
+		titem->t_len = htup->t_len;
+		titem->rowid = rowid;
+		memcpy(&titem->htup, htup->t_data, htup->t_len);
+		memcpy(&titem->htup.t_ctid, &htup->t_self, sizeof(ItemPointerData));
+
+		row_index[rowid++] = __kds_packed(tail_pos - curr_pos);
+	}
+}
+
+/*
+ * __innerPreloadSetupHashBuffer
+ */
+static void
+__innerPreloadSetupHashBuffer(kern_data_store *kds,
+							  pgstromTaskInnerState *istate,
+							  uint32_t base_nitems,
+							  uint32_t base_usage,
+							  uint32_t part_id,
+							  uint32_t *bloom,
+							  uint32_t bloom_nbits)
+{
+	uint32_t   *row_index = KDS_GET_ROWINDEX(kds);
+	uint32_t   *hash_slot = KDS_GET_HASHSLOT_BASE(kds);
+	uint32_t	rowid = base_nitems;
+	char	   *tail_pos = (char *)kds + kds->length;
+	char	   *curr_pos = tail_pos - __kds_unpack(base_usage);
+	inner_preload_buffer *preload_buf = istate->preload_buffer;
+
+	for (uint32_t index=0; index < preload_buf->nitems; index++)
+	{
+		HeapTuple	htup = preload_buf->rows[index].htup;
+		uint32_t	hash = preload_buf->rows[index].hash;
+		uint32_t	hindex = hash % kds->hash_nslots;
+		uint32_t	next, self;
+		size_t		sz;
+		kern_hashitem *hitem;
+
+		/* only tuples in this partition, if grace hash-join */
+		if (KERN_HASH_PARTITION_ID(hash, istate->inner_nparts) != part_id)
+			continue;
+		sz = MAXALIGN(offsetof(kern_hashitem, t.htup) + htup->t_len);
+		curr_pos -= sz;
+		self = __kds_packed(tail_pos - curr_pos);
+		__atomic_exchange(&hash_slot[hindex], &self, &next,
+						  __ATOMIC_SEQ_CST);
+		hitem = (kern_hashitem *)curr_pos;
+		hitem->hash = hash;
+		hitem->next = next;
+		hitem->t.t_len = htup->t_len;
+		hitem->t.rowid = rowid;
+		memcpy(&hitem->t.htup, htup->t_data, htup->t_len);
+		memcpy(&hitem->t.htup.t_ctid, &htup->t_self, sizeof(ItemPointerData));
+
+		row_index[rowid++] = __kds_packed(tail_pos - (char *)&hitem->t);
+
+		/* bloom-filter, if any */
+		if (bloom)
+		{
+			uint32_t	bit1, bit2;
+
+			__kern_bloom_filter_bits(hash, bloom_nbits, &bit1, &bit2);
+			__atomic_fetch_or(&bloom[bit1 >> 5], (1U << (bit1 & 31)),
+							  __ATOMIC_SEQ_CST);
+			__atomic_fetch_or(&bloom[bit2 >> 5], (1U << (bit2 & 31)),
+							  __ATOMIC_SEQ_CST);
+		}
+	}
+}
+
+/*
+ * innerPreloadSetupHashPartitions
+ *
+ * It writes out the preloaded tuples of the grace hash-join to the
+ * partitioned hash tables.
+ */
+static void
+innerPreloadSetupHashPartitions(pgstromTaskState *pts,
+								pgstromTaskInnerState *istate,
+								int dindex)
+{
+	pgstromSharedState *ps_state = pts->ps_state;
+	inner_preload_buffer *preload_buf = istate->preload_buffer;
+	uint32_t	part_nitems[GPUJOIN_MAX_INNER_PARTITIONS];
+	size_t		part_usage[GPUJOIN_MAX_INNER_PARTITIONS];
+
+	memset(part_nitems, 0, sizeof(part_nitems));
+	memset(part_usage, 0, sizeof(part_usage));
+	for (uint32_t index=0; index < preload_buf->nitems; index++)
+	{
+		HeapTuple	htup = preload_buf->rows[index].htup;
+		uint32_t	part_id = KERN_HASH_PARTITION_ID(preload_buf->rows[index].hash,
+													 istate->inner_nparts);
+		part_nitems[part_id]++;
+		part_usage[part_id] += MAXALIGN(offsetof(kern_hashitem,
+												 t.htup) + htup->t_len);
+	}
+
+	for (uint32_t k=0; k < istate->inner_nparts; k++)
+	{
+		kern_data_store *kds = KERN_MULTIRELS_INNER_PART_KDS(pts->h_kmrels,
+															 dindex, k);
+		uint32_t	base_nitems;
+		uint32_t	base_usage;
+
+		Assert(kds->format == KDS_FORMAT_HASH);
+		SpinLockAcquire(&ps_state->preload_mutex);
+		base_nitems  = kds->nitems;
+		kds->nitems += part_nitems[k];
+		base_usage   = kds->usage;
+		kds->usage  += __kds_packed(part_usage[k]);
+		SpinLockRelease(&ps_state->preload_mutex);
+
+		__innerPreloadSetupHashBuffer(kds, istate,
+									  base_nitems,
+									  base_usage, k,
+									  KERN_MULTIRELS_BLOOM_FILTER(pts->h_kmrels, dindex),
+									  pts->h_kmrels->chunks[dindex].bloom_nbits);
+	}
+}
+
+#define INNER_PHASE__SCAN_RELATIONS		0
+#define INNER_PHASE__SETUP_BUFFERS		1
+#define INNER_PHASE__GPUJOIN_EXEC		2
+
+static int
+__compare_transaction_id(const void *__a, const void *__b)
+{
+	TransactionId	a = *((const TransactionId *)__a);
+	TransactionId	b = *((const TransactionId *)__b);
+
+	if (a < b)
+		return -1;
+	if (a > b)
+		return 1;
+	return 0;
+}
+
+/*
+ * __gpujoinInnerCacheSignature
+ *
+ * It computes the signature of the inner buffer, or returns false if it is
+ * not reusable by other queries. Only SeqScan on the tables is supported,
+ * without mutable functions and parameters, because identical plan and
+ * snapshot must produce the identical inner buffer.
+ */
+static bool
+__gpujoinInnerCacheSignature(pgstromTaskState *pts,
+							 uint64_t *p_signature,
+							 uint64_t *p_signature2,
+							 Oid *relids, int *p_num_relids)
+{
+	pgstromPlanInfo *pp_info = pts->pp_info;
+	Snapshot	snapshot = pts->css.ss.ps.state->es_snapshot;
+	StringInfoData buf;
+	TransactionId *xids;
+	uint64_t	signature;
+
+	if (!gpujoin_inner_cache ||
+		!pgstrom_enable_gpujoin_inner_cache ||
+		(pts->xpu_task_flags & DEVKIND__NVIDIA_GPU) == 0 ||
+		pts->num_rels > GPUJOIN_INNER_CACHE_MAX_RELS)
+		return false;
+	/* the current transaction must not modify anything */
+	if (!IsMVCCSnapshot(snapshot) ||
+		snapshot->suboverflowed ||
+		TransactionIdIsValid(GetTopTransactionIdIfAny()))
+		return false;
+
+	for (int i=0; i < pts->num_rels; i++)
+	{
+		pgstromTaskInnerState *istate = &pts->inners[i];
+		pgstromPlanInnerInfo *pp_inner = &pp_info->inners[i];
+		Plan	   *plan = istate->ps->plan;
+		Relation	rel;
+
+		if (pp_inner->join_type == JOIN_RIGHT ||
+			pp_inner->join_type == JOIN_FULL ||
+			OidIsValid(pp_inner->gist_index_oid) ||
+			istate->inner_nparts > 1)
+			return false;
+		if (!IsA(plan, SeqScan) ||
+			contain_mutable_functions((Node *)plan->qual) ||
+			contain_mutable_functions((Node *)plan->targetlist) ||
+			!bms_is_empty(pull_paramids((Expr *)plan->qual)) ||
+			!bms_is_empty(pull_paramids((Expr *)plan->targetlist)))
+			return false;
+		rel = ((ScanState *)istate->ps)->ss_currentRelation;
+		if (rel->rd_rel->relkind != RELKIND_RELATION &&
+			rel->rd_rel->relkind != RELKIND_MATVIEW)
+			return false;
+		relids[i] = RelationGetRelid(rel);
+	}
+
+	initStringInfo(&buf);
+	appendBinaryStringInfo(&buf, (char *)&MyDatabaseId, sizeof(Oid));
+	appendBinaryStringInfo(&buf, (char *)&snapshot->xmin, sizeof(TransactionId));
+	appendBinaryStringInfo(&buf, (char *)&snapshot->xmax, sizeof(TransactionId));
+	if (snapshot->xcnt > 0)
+	{
+		xids = palloc(sizeof(TransactionId) * snapshot->xcnt);
+		memcpy(xids, snapshot->xip, sizeof(TransactionId) * snapshot->xcnt);
+		qsort(xids, snapshot->xcnt, sizeof(TransactionId),
+			  __compare_transaction_id);
+		appendStringInfo(&buf, "xip:%u", snapshot->xcnt);
+		appendBinaryStringInfo(&buf, (char *)xids,
+							   sizeof(TransactionId) * snapshot->xcnt);
+		pfree(xids);
+	}
+	if (snapshot->subxcnt > 0)
+	{
+		xids = palloc(sizeof(TransactionId) * snapshot->subxcnt);
+		memcpy(xids, snapshot->subxip, sizeof(TransactionId) * snapshot->subxcnt);
+		qsort(xids, snapshot->subxcnt, sizeof(TransactionId),
+			  __compare_transaction_id);
+		appendStringInfo(&buf, "subxip:%u", snapshot->subxcnt);
+		appendBinaryStringInfo(&buf, (char *)xids,
+							   sizeof(TransactionId) * snapshot->subxcnt);
+		pfree(xids);
+	}
+	appendStringInfo(&buf, "bloom:%d", pgstrom_enable_gpujoin_bloom_filter);
+	appendStringInfo(&buf, "hbucket:%d/%d",
+					 pgstrom_enable_gpujoin_hash_bucket,
+					 pgstrom_enable_gpujoin_device_hash_bucket);
+	for (int i=0; i < pts->num_rels; i++)
+	{
+		pgstromPlanInnerInfo *pp_inner = &pp_info->inners[i];
+		Plan	   *plan = pts->inners[i].ps->plan;
+
+		appendStringInfo(&buf, "depth:%d relid:%u join_type:%d",
+						 i+1, relids[i], (int)pp_inner->join_type);
+		appendStringInfo(&buf, " qual:%s tlist:%s hash_keys:%s",
+						 nodeToString(plan->qual),
+						 nodeToString(plan->targetlist),
+						 nodeToString(pp_inner->hash_inner_keys));
+		if (pp_inner->grid_cell_size > 0.0)
+			appendStringInfo(&buf, " grid:%g/%g",
+							 pp_inner->grid_cell_size,
+							 pp_inner->grid_expand);
+		if (pp_inner->range_inner_keys != NIL)
+			appendStringInfo(&buf, " range_keys:%s",
+							 nodeToString(pp_inner->range_inner_keys));
+		if (pp_inner->polygon_inner_key)
+			appendStringInfo(&buf, " polygon_key:%s",
+							 nodeToString(pp_inner->polygon_inner_key));
+	}
+	signature = hash_bytes_extended((unsigned char *)buf.data, buf.len, 0);
+	*p_signature = (signature != 0 ? signature : 1);
+	*p_signature2 = hash_bytes_extended((unsigned char *)buf.data, buf.len,
+										0xdeadbeafUL);
+	*p_num_relids = pts->num_rels;
+	pfree(buf.data);
+
+	return true;
+}
+
+/*
+ * __gpujoinInnerCacheRemoveNoLock
+ */
+static void
+__gpujoinInnerCacheRemoveNoLock(gpujoinInnerCacheEntry *entry)
+{
+	Assert(entry->refcnt == 0);
+	__shmemUnlink(entry->shmem_handle, NULL);
+	memset(entry, 0, sizeof(gpujoinInnerCacheEntry));
+}
+
+/*
+ * GpuJoinInnerCacheLookup
+ *
+ * It looks up the inner buffer cache, then attach the cached buffer on the
+ * pgstromSharedState, if any. Elsewhere, it only saves the signature, then
+ * the inner buffer built by this query shall be cached at the end.
+ */
+bool
+GpuJoinInnerCacheLookup(pgstromTaskState *pts, pgstromSharedState *ps_state)
+{
+	uint64_t	signature;
+	uint64_t	signature2;
+	Oid			relids[GPUJOIN_INNER_CACHE_MAX_RELS];
+	int			num_relids;
+	bool		found = false;
+
+	if (!__gpujoinInnerCacheSignature(pts, &signature, &signature2,
+									  relids, &num_relids))
+		return false;
+	ps_state->preload_cache_signature = signature;
+
+	LWLockAcquire(&gpujoin_inner_cache->lock, LW_EXCLUSIVE);
+	for (int i=0; i < pgstrom_gpujoin_inner_cache_nslots; i++)
+	{
+		gpujoinInnerCacheEntry *entry = &gpujoin_inner_cache->entries[i];
+
+		if (entry->signature    == signature &&
+			entry->signature2   == signature2 &&
+			entry->database_oid == MyDatabaseId &&
+			!entry->invalid)
+		{
+			MemoryContext	oldcxt;
+
+			oldcxt = MemoryContextSwitchTo(TopMemoryContext);
+			gpujoin_inner_cache_held = lappend_int(gpujoin_inner_cache_held,
+												   (int)entry->shmem_handle);
+			MemoryContextSwitchTo(oldcxt);
+
+			entry->refcnt++;
+			entry->last_used = ++gpujoin_inner_cache->lru_clock;
+			ps_state->preload_shmem_handle = entry->shmem_handle;
+			ps_state->preload_shmem_length = entry->shmem_length;
+			ps_state->preload_phase = INNER_PHASE__GPUJOIN_EXEC;
+			ps_state->preload_cache_hit = true;
+			found = true;
+			break;
+		}
+	}
+	LWLockRelease(&gpujoin_inner_cache->lock);
+
+	return found;
+}
+
+/*
+ * __gpujoinInnerCacheUnref
+ */
+static void
+__gpujoinInnerCacheUnref(uint32_t shmem_handle)
+{
+	LWLockAcquire(&gpujoin_inner_cache->lock, LW_EXCLUSIVE);
+	for (int i=0; i < pgstrom_gpujoin_inner_cache_nslots; i++)
+	{
+		gpujoinInnerCacheEntry *entry = &gpujoin_inner_cache->entries[i];
+
+		if (entry->signature != 0 &&
+			entry->shmem_handle == shmem_handle)
+		{
+			Assert(entry->refcnt > 0);
+			if (--entry->refcnt == 0 && entry->invalid)
+				__gpujoinInnerCacheRemoveNoLock(entry);
+			break;
+		}
+	}
+	LWLockRelease(&gpujoin_inner_cache->lock);
+	gpujoin_inner_cache_held = list_delete_int(gpujoin_inner_cache_held,
+											   (int)shmem_handle);
+}
+
+/*
+ * __gpujoinInnerCacheInsert
+ */
+static bool
+__gpujoinInnerCacheInsert(pgstromTaskState *pts, pgstromSharedState *ps_state)
+{
+	gpujoinInnerCacheEntry *entry = NULL;
+	gpujoinInnerCacheEntry *victim = NULL;
+	uint64_t	signature;
+	uint64_t	signature2;
+	Oid			relids[GPUJOIN_INNER_CACHE_MAX_RELS];
+	int			num_relids;
+
+	if (!__gpujoinInnerCacheSignature(pts, &signature, &signature2,
+									  relids, &num_relids) ||
+		signature != ps_state->preload_cache_signature)
+		return false;
+
+	LWLockAcquire(&gpujoin_inner_cache->lock, LW_EXCLUSIVE);
+	for (int i=0; i < pgstrom_gpujoin_inner_cache_nslots; i++)
+	{
+		gpujoinInnerCacheEntry *curr = &gpujoin_inner_cache->entries[i];
+
+		if (curr->signature == 0)
+		{
+			if (!entry)
+				entry = curr;
+		}
+		else if (curr->signature    == signature &&
+				 curr->signature2   == signature2 &&
+				 curr->database_oid == MyDatabaseId &&
+				 !curr->invalid)
 		{
-			/* Nested-Loop */
-			nbytes += (MAXALIGN(sizeof(uint32_t) * nrooms) +
-					   MAXALIGN(usage));
-			if (h_kmrels)
-			{
-				setup_kern_data_store(kds, tupdesc, nbytes,
-									  KDS_FORMAT_ROW);
-				h_kmrels->chunks[i].is_nestloop = true;
-			}
-			offset += nbytes;
+			/* concurrent query already cached the same inner buffer */
+			LWLockRelease(&gpujoin_inner_cache->lock);
+			return false;
 		}
-
-		if (istate->join_type == JOIN_RIGHT ||
-			istate->join_type == JOIN_FULL)
+		else if (curr->refcnt == 0 &&
+				 (!victim || victim->last_used > curr->last_used))
 		{
-			nbytes = MAXALIGN(sizeof(bool) * nrooms);
-			if (h_kmrels)
-			{
-				h_kmrels->chunks[i].right_outer = true;
-				h_kmrels->chunks[i].ojmap_offset = offset;
-				memset((char *)h_kmrels + offset, 0, nbytes);
-			}
-			offset += nbytes;
+			victim = curr;
 		}
-		if (istate->join_type == JOIN_LEFT ||
-			istate->join_type == JOIN_FULL)
+	}
+	if (!entry)
+	{
+		if (!victim)
 		{
-			if (h_kmrels)
-				h_kmrels->chunks[i].left_outer = true;
+			LWLockRelease(&gpujoin_inner_cache->lock);
+			return false;
 		}
+		__gpujoinInnerCacheRemoveNoLock(victim);
+		entry = victim;
 	}
+	__shmemDetach(ps_state->preload_shmem_handle);
+	entry->signature = signature;
+	entry->signature2 = signature2;
+	entry->database_oid = MyDatabaseId;
+	entry->num_relids = num_relids;
+	memcpy(entry->relids, relids, sizeof(Oid) * num_relids);
+	entry->shmem_handle = ps_state->preload_shmem_handle;
+	entry->shmem_length = ps_state->preload_shmem_length;
+	entry->refcnt = 0;
+	entry->invalid = false;
+	entry->last_used = ++gpujoin_inner_cache->lru_clock;
+	LWLockRelease(&gpujoin_inner_cache->lock);
 
-	/*
-	 * allocation of the host inner-buffer
-	 */
-	if (!h_kmrels)
-	{
-		size_t		shmem_length = PAGE_ALIGN(offset);
+	return true;
+}
 
-		Assert(ps_state->preload_shmem_handle != 0);
-		h_kmrels = __mmapShmem(ps_state->preload_shmem_handle,
-							   shmem_length, pts->ds_entry);
-		memset(h_kmrels, 0, offsetof(kern_multirels,
-									 chunks[pts->num_rels]));
-		h_kmrels->length = offset;
-		h_kmrels->num_rels = pts->num_rels;
-		ps_state->preload_shmem_length = shmem_length;
-		goto again;
-	}
-	pts->h_kmrels = h_kmrels;
+/*
+ * GpuJoinInnerCacheRelease
+ *
+ * It releases the inner buffer at the end of query. If it is reusable by
+ * the following queries, it is kept in the inner buffer cache.
+ */
+void
+GpuJoinInnerCacheRelease(pgstromTaskState *pts, pgstromSharedState *ps_state)
+{
+	if (ps_state->preload_shmem_handle == 0)
+		return;
+	if (ps_state->preload_cache_hit)
+		__gpujoinInnerCacheUnref(ps_state->preload_shmem_handle);
+	else if (ps_state->preload_cache_signature == 0 ||
+			 ps_state->preload_phase != INNER_PHASE__GPUJOIN_EXEC ||
+			 !__gpujoinInnerCacheInsert(pts, ps_state))
+		__shmemDrop(ps_state->preload_shmem_handle);
 }
 
 /*
- * __innerPreloadSetupHeapBuffer
+ * gpujoinInnerCacheRelcacheCallback
  */
 static void
-__innerPreloadSetupHeapBuffer(kern_data_store *kds,
-							  pgstromTaskInnerState *istate,
-							  uint32_t base_nitems,
-							  uint32_t base_usage)
+gpujoinInnerCacheRelcacheCallback(Datum arg, Oid relid)
 {
-	uint32_t   *row_index = KDS_GET_ROWINDEX(kds);
-	uint32_t	rowid = base_nitems;
-	char	   *tail_pos = (char *)kds + kds->length;
-	char	   *curr_pos = tail_pos - __kds_unpack(base_usage);
-	inner_preload_buffer *preload_buf = istate->preload_buffer;
-
-	for (uint32_t index=0; index < preload_buf->nitems; index++)
+	if (!gpujoin_inner_cache)
+		return;
+	LWLockAcquire(&gpujoin_inner_cache->lock, LW_EXCLUSIVE);
+	for (int i=0; i < pgstrom_gpujoin_inner_cache_nslots; i++)
 	{
-		HeapTuple	htup = preload_buf->rows[index].htup;
-		size_t		sz;
-		kern_tupitem *titem;
-
-		sz = MAXALIGN(offsetof(kern_tupitem, htup) + htup->t_len);
-		curr_pos -= sz;
-		titem = (kern_tupitem *)curr_pos;
-		titem->t_len = htup->t_len;
-		titem->rowid = rowid;
-		memcpy(&titem->htup, htup->t_data, htup->t_len);
-		memcpy(&titem->htup.t_ctid, &htup->t_self, sizeof(ItemPointerData));
+		gpujoinInnerCacheEntry *entry = &gpujoin_inner_cache->entries[i];
 
-		row_index[rowid++] = __kds_packed(tail_pos - curr_pos);
+		if (entry->signature == 0 ||
+			entry->database_oid != MyDatabaseId)
+			continue;
+		for (int k=0; k < entry->num_relids; k++)
+		{
+			if (!OidIsValid(relid) || entry->relids[k] == relid)
+			{
+				entry->invalid = true;
+				break;
+			}
+		}
+		if (entry->invalid && entry->refcnt == 0)
+			__gpujoinInnerCacheRemoveNoLock(entry);
 	}
+	LWLockRelease(&gpujoin_inner_cache->lock);
 }
 
 /*
- * __innerPreloadSetupHashBuffer
+ * gpujoinInnerCacheXactCallback
+ *
+ * It releases the cached inner buffers referenced by the aborted queries.
  */
 static void
-__innerPreloadSetupHashBuffer(kern_data_store *kds,
-							  pgstromTaskInnerState *istate,
-							  uint32_t base_nitems,
-							  uint32_t base_usage)
+gpujoinInnerCacheXactCallback(XactEvent event, void *arg)
 {
-	uint32_t   *row_index = KDS_GET_ROWINDEX(kds);
-	uint32_t   *hash_slot = KDS_GET_HASHSLOT_BASE(kds);
-	uint32_t	rowid = base_nitems;
-	char	   *tail_pos = (char *)kds + kds->length;
-	char	   *curr_pos = tail_pos - __kds_unpack(base_usage);
-	inner_preload_buffer *preload_buf = istate->preload_buffer;
-
-	for (uint32_t index=0; index < preload_buf->nitems; index++)
+	if (event == XACT_EVENT_COMMIT ||
+		event == XACT_EVENT_ABORT ||
+		event == XACT_EVENT_PARALLEL_COMMIT ||
+		event == XACT_EVENT_PARALLEL_ABORT)
 	{
-		HeapTuple	htup = preload_buf->rows[index].htup;
-		uint32_t	hash = preload_buf->rows[index].hash;
-		uint32_t	hindex = hash % kds->hash_nslots;
-		uint32_t	next, self;
-		size_t		sz;
-		kern_hashitem *hitem;
-
-		sz = MAXALIGN(offsetof(kern_hashitem, t.htup) + htup->t_len);
-		curr_pos -= sz;
-		self = __kds_packed(tail_pos - curr_pos);
-		__atomic_exchange(&hash_slot[hindex], &self, &next,
-						  __ATOMIC_SEQ_CST);
-		hitem = (kern_hashitem *)curr_pos;
-		hitem->hash = hash;
-		hitem->next = next;
-		hitem->t.t_len = htup->t_len;
-		hitem->t.rowid = rowid;
-		memcpy(&hitem->t.htup, htup->t_data, htup->t_len);
-		memcpy(&hitem->t.htup.t_ctid, &htup->t_self, sizeof(ItemPointerData));
-
-		row_index[rowid++] = __kds_packed(tail_pos - (char *)&hitem->t);
+		while (gpujoin_inner_cache_held != NIL)
+			__gpujoinInnerCacheUnref((uint32_t)linitial_int(gpujoin_inner_cache_held));
 	}
 }
 
-#define INNER_PHASE__SCAN_RELATIONS		0
-#define INNER_PHASE__SETUP_BUFFERS		1
-#define INNER_PHASE__GPUJOIN_EXEC		2
-
 uint32_t
 GpuJoinInnerPreload(pgstromTaskState *pts)
 {
@@ -1797,8 +4302,7 @@ GpuJoinInnerPreload(pgstromTaskState *pts)
 				pgstromTaskInnerState *istate = &leader->inners[i];
 
 				execInnerPreloadOneDepth(memcxt, istate,
-										 &ps_state->inners[i].inner_nitems,
-										 &ps_state->inners[i].inner_usage);
+										 &ps_state->inners[i]);
 			}
 
 			/*
@@ -1875,6 +4379,11 @@ GpuJoinInnerPreload(pgstromTaskState *pts)
                 uint32_t		base_nitems;
 				uint32_t		base_usage;
 
+				if (istate->inner_nparts > 1)
+				{
+					innerPreloadSetupHashPartitions(pts, istate, i);
+					continue;
+				}
 				SpinLockAcquire(&ps_state->preload_mutex);
 				base_nitems  = kds->nitems;
 				kds->nitems += preload_buf->nitems;
@@ -1889,7 +4398,9 @@ GpuJoinInnerPreload(pgstromTaskState *pts)
                 else if (kds->format == KDS_FORMAT_HASH)
                     __innerPreloadSetupHashBuffer(kds, istate,
                                                   base_nitems,
-                                                  base_usage);
+                                                  base_usage, 0,
+												  KERN_MULTIRELS_BLOOM_FILTER(pts->h_kmrels, i),
+												  pts->h_kmrels->chunks[i].bloom_nbits);
                 else
 					elog(ERROR, "unexpected inner-KDS format");
 			}
@@ -1904,14 +4415,20 @@ GpuJoinInnerPreload(pgstromTaskState *pts)
 				ps_state->preload_nr_setup == 0)
 			{
 				Assert(ps_state->preload_phase == INNER_PHASE__SETUP_BUFFERS);
+				SpinLockRelease(&ps_state->preload_mutex);
+				/* no concurrent writers any more */
+				innerPreloadBuildHashBucket(pts);
+				innerPreloadBuildDirectMap(pts);
+				innerPreloadBuildRangeIndex(pts);
+				innerPreloadBuildPolygonIndex(pts);
+				SpinLockAcquire(&ps_state->preload_mutex);
 				ps_state->preload_phase = INNER_PHASE__GPUJOIN_EXEC;
 				ConditionVariableBroadcast(&ps_state->preload_cond);
             }
             else
             {
                 ConditionVariablePrepareToSleep(&ps_state->preload_cond);
-				while (ps_state->preload_nr_scanning > 0 ||
-					   ps_state->preload_nr_setup > 0)
+				while (ps_state->preload_phase != INNER_PHASE__GPUJOIN_EXEC)
 				{
                     SpinLockRelease(&ps_state->preload_mutex);
                     ConditionVariableSleep(&ps_state->preload_cond,
@@ -1934,6 +4451,19 @@ GpuJoinInnerPreload(pgstromTaskState *pts)
 											ps_state->preload_shmem_length,
 											pts->ds_entry);
 			}
+			/* inner statistics, if the buffer come from the inner cache */
+			if (ps_state->preload_cache_hit && !IsParallelWorker())
+			{
+				for (int i=0; i < pts->num_rels; i++)
+				{
+					kern_data_store *kds = KERN_MULTIRELS_INNER_KDS(pts->h_kmrels, i);
+
+					pg_atomic_write_u64(&ps_state->inners[i].inner_nitems,
+										kds->nitems);
+					pg_atomic_write_u64(&ps_state->inners[i].inner_usage,
+										__kds_unpack(kds->usage));
+				}
+			}
 
 			//TODO: send the shmem handle to the GPU server or DPU server
 
@@ -2080,6 +4610,39 @@ __execFallbackLoadVarsSlot(TupleTableSlot *fallback_slot,
 	}
 }
 
+static void
+__execFallbackLoadNullVarsSlot(TupleTableSlot *fallback_slot,
+							   const kern_expression *kexp_vloads)
+{
+	const kern_varload_desc *vl_desc = kexp_vloads->u.load.desc;
+
+	Assert(kexp_vloads->opcode == FuncOpCode__LoadVars);
+	for (int i=0; i < kexp_vloads->u.load.nitems; i++, vl_desc++)
+	{
+		int		slot_id = vl_desc->vl_slot_id;
+
+		fallback_slot->tts_isnull[slot_id] = true;
+		fallback_slot->tts_values[slot_id] = 0;
+	}
+}
+
+/*
+ * __execFallbackCpuJoinAntiOuter
+ *
+ * It moves to the next depth with NULL inner values, if the outer tuple
+ * has no matched inner tuples on ANTI JOIN.
+ */
+static void
+__execFallbackCpuJoinAntiOuter(pgstromTaskState *pts,
+							   const kern_expression *kexp_join_kvars_load,
+							   int depth)
+{
+	if (kexp_join_kvars_load)
+		__execFallbackLoadNullVarsSlot(pts->fallback_slot,
+									   kexp_join_kvars_load);
+	__execFallbackCpuJoinOneDepth(pts, depth+1);
+}
+
 static void
 __execFallbackCpuNestLoop(pgstromTaskState *pts,
 						  kern_data_store *kds_in,
@@ -2119,20 +4682,28 @@ __execFallbackCpuNestLoop(pgstromTaskState *pts,
 									   &tupitem->htup);
 		}
 		/* check JOIN-clause */
-		if (istate->join_quals != NULL ||
+		if (istate->join_quals == NULL ||
 			ExecQual(istate->join_quals, econtext))
 		{
-			if (istate->other_quals != NULL ||
+			/* ANTI JOIN never emits the outer tuple once matched */
+			if (istate->join_type == JOIN_ANTI)
+				return;
+			if (istate->other_quals == NULL ||
 				ExecQual(istate->other_quals, econtext))
 			{
 				/* Ok, go to the next depth */
 				__execFallbackCpuJoinOneDepth(pts, depth+1);
+				/* SEMI JOIN emits the outer tuple only once */
+				if (istate->join_type == JOIN_SEMI)
+					return;
 			}
 			/* mark outer-join map, if any */
 			if (oj_map)
 				oj_map[index] = true;
 		}
 	}
+	if (istate->join_type == JOIN_ANTI)
+		__execFallbackCpuJoinAntiOuter(pts, kexp_join_kvars_load, depth);
 }
 
 static void
@@ -2176,6 +4747,14 @@ __execFallbackCpuHashJoin(pgstromTaskState *pts,
 	/*
 	 * walks on the hash-join-table
 	 */
+	/* grace hash-join; only tuples in the current partition */
+	if (istate->inner_nparts > 1 &&
+		KERN_HASH_PARTITION_ID(hash, istate->inner_nparts) != pts->curr_inner_part)
+	{
+		Assert(istate->join_type == JOIN_INNER);
+		return;
+	}
+
 	for (hitem = KDS_HASH_FIRST_ITEM(kds_in, hash);
 		 hitem != NULL;
 		 hitem = KDS_HASH_NEXT_ITEM(kds_in, hitem->next))
@@ -2197,17 +4776,25 @@ __execFallbackCpuHashJoin(pgstromTaskState *pts,
 		if (istate->join_quals == NULL ||
 			ExecQual(istate->join_quals, econtext))
 		{
+			/* ANTI JOIN never emits the outer tuple once matched */
+			if (istate->join_type == JOIN_ANTI)
+				return;
 			if (istate->other_quals == NULL ||
 				ExecQual(istate->other_quals, econtext))
 			{
 				/* Ok, go to the next depth */
 				__execFallbackCpuJoinOneDepth(pts, depth+1);
+				/* SEMI JOIN emits the outer tuple only once */
+				if (istate->join_type == JOIN_SEMI)
+					return;
 			}
 			/* mark outer-join map, if any */
 			if (oj_map)
 				oj_map[hitem->t.rowid] = true;
 		}
 	}
+	if (istate->join_type == JOIN_ANTI)
+		__execFallbackCpuJoinAntiOuter(pts, kexp_join_kvars_load, depth);
 }
 
 static void
@@ -2240,7 +4827,8 @@ __execFallbackCpuJoinOneDepth(pgstromTaskState *pts, int depth)
 	}
 	else
 	{
-		kds_in = KERN_MULTIRELS_INNER_KDS(h_kmrels, depth-1);
+		kds_in = KERN_MULTIRELS_INNER_PART_KDS(h_kmrels, depth-1,
+											   pts->curr_inner_part);
 		oj_map = KERN_MULTIRELS_OUTER_JOIN_MAP(h_kmrels, depth-1);
 
 		if (h_kmrels->chunks[depth-1].is_nestloop)
@@ -2386,6 +4974,40 @@ ExecFallbackCpuJoinRightOuter(pgstromTaskState *pts)
 	}
 }
 
+/*
+ * GpuJoinRightOuterOnDevice
+ *
+ * It checks whether the unmatched inner tuples of RIGHT/FULL OUTER JOIN
+ * can be processed by the GPU kernel at the end of the scan. Pushed-down
+ * quals (other_quals) are evaluated only by CPU, and GpuPreAgg and grace
+ * hash-join keep the CPU path on the outer-join-map.
+ */
+bool
+GpuJoinRightOuterOnDevice(pgstromTaskState *pts)
+{
+	pgstromPlanInfo *pp_info = pts->pp_info;
+	bool		has_right_outer = false;
+
+	if (!pgstrom_enable_gpujoin_right_outer ||
+		(pts->xpu_task_flags & DEVKIND__NVIDIA_GPU) == 0 ||
+		(pts->xpu_task_flags & DEVTASK__JOIN) == 0 ||
+		!pp_info->kexp_projection)
+		return false;
+	for (int i=0; i < pp_info->num_rels; i++)
+	{
+		pgstromPlanInnerInfo *pp_inner = &pp_info->inners[i];
+
+		if (pp_inner->join_type != JOIN_RIGHT &&
+			pp_inner->join_type != JOIN_FULL)
+			continue;
+		if (pp_inner->other_quals != NIL ||
+			pp_inner->inner_nparts > 1)
+			return false;
+		has_right_outer = true;
+	}
+	return has_right_outer;
+}
+
 void
 ExecFallbackCpuJoinOuterJoinMap(pgstromTaskState *pts, XpuCommand *resp)
 {
@@ -2410,6 +5032,42 @@ ExecFallbackCpuJoinOuterJoinMap(pgstromTaskState *pts, XpuCommand *resp)
 	}
 }
 
+/*
+ * pgstrom_request_gpu_join
+ */
+static void
+pgstrom_request_gpu_join(void)
+{
+	if (shmem_request_next)
+		shmem_request_next();
+	if (pgstrom_gpujoin_inner_cache_nslots > 0)
+		RequestAddinShmemSpace(MAXALIGN(offsetof(gpujoinInnerCacheHead,
+												 entries[pgstrom_gpujoin_inner_cache_nslots])));
+}
+
+/*
+ * pgstrom_startup_gpu_join
+ */
+static void
+pgstrom_startup_gpu_join(void)
+{
+	bool	found;
+
+	if (shmem_startup_next)
+		(*shmem_startup_next)();
+	if (pgstrom_gpujoin_inner_cache_nslots > 0)
+	{
+		size_t	sz = offsetof(gpujoinInnerCacheHead,
+							  entries[pgstrom_gpujoin_inner_cache_nslots]);
+
+		gpujoin_inner_cache = ShmemInitStruct("GpuJoin Inner Buffer Cache",
+											  MAXALIGN(sz), &found);
+		Assert(!found);
+		memset(gpujoin_inner_cache, 0, sz);
+		LWLockInitialize(&gpujoin_inner_cache->lock, LWLockNewTrancheId());
+	}
+}
+
 /*
  * pgstrom_init_gpu_join
  */
@@ -2434,6 +5092,98 @@ pgstrom_init_gpu_join(void)
 							 PGC_USERSET,
 							 GUC_NOT_IN_SAMPLE,
 							 NULL, NULL, NULL);
+	/* turn on/off grace hash-join */
+	DefineCustomBoolVariable("pg_strom.enable_gpuhashjoin_partition",
+							 "Enables the partitioned (grace) GpuHashJoin if inner hash table is too large",
+							 NULL,
+							 &pgstrom_enable_gpuhashjoin_partition,
+							 true,
+							 PGC_USERSET,
+							 GUC_NOT_IN_SAMPLE,
+							 NULL, NULL, NULL);
+	/* turn on/off bloom-filter of the inner hash table */
+	DefineCustomBoolVariable("pg_strom.enable_gpujoin_bloom_filter",
+							 "Enables the bloom-filter on the inner hash table of GpuHashJoin",
+							 NULL,
+							 &pgstrom_enable_gpujoin_bloom_filter,
+							 true,
+							 PGC_USERSET,
+							 GUC_NOT_IN_SAMPLE,
+							 NULL, NULL, NULL);
+	/* turn on/off the bucketized index of the inner hash table */
+	DefineCustomBoolVariable("pg_strom.enable_gpujoin_hash_bucket",
+							 "Enables the bucketized index on the inner hash table of GpuHashJoin",
+							 NULL,
+							 &pgstrom_enable_gpujoin_hash_bucket,
+							 true,
+							 PGC_USERSET,
+							 GUC_NOT_IN_SAMPLE,
+							 NULL, NULL, NULL);
+	/* turn on/off the bucketized index built by GPU */
+	DefineCustomBoolVariable("pg_strom.enable_gpujoin_device_hash_bucket",
+							 "Enables to build the bucketized index of the inner hash table on GPU",
+							 NULL,
+							 &pgstrom_enable_gpujoin_device_hash_bucket,
+							 true,
+							 PGC_USERSET,
+							 GUC_NOT_IN_SAMPLE,
+							 NULL, NULL, NULL);
+	/* turn on/off the direct-address map for dense integer join-keys */
+	DefineCustomBoolVariable("pg_strom.enable_gpujoin_direct_map",
+							 "Enables the direct-address map on the inner hash table of GpuHashJoin with dense integer keys",
+							 NULL,
+							 &pgstrom_enable_gpujoin_direct_map,
+							 true,
+							 PGC_USERSET,
+							 GUC_NOT_IN_SAMPLE,
+							 NULL, NULL, NULL);
+	/* turn on/off RIGHT/FULL OUTER JOIN completion on the device */
+	DefineCustomBoolVariable("pg_strom.enable_gpujoin_right_outer",
+							 "Enables to process unmatched inner tuples of RIGHT/FULL OUTER JOIN on GPU",
+							 NULL,
+							 &pgstrom_enable_gpujoin_right_outer,
+							 true,
+							 PGC_USERSET,
+							 GUC_NOT_IN_SAMPLE,
+							 NULL, NULL, NULL);
+	/* turn on/off the inner buffer cache */
+	DefineCustomBoolVariable("pg_strom.enable_gpujoin_inner_cache",
+							 "Enables to reuse the GpuJoin inner buffer by the following queries",
+							 NULL,
+							 &pgstrom_enable_gpujoin_inner_cache,
+							 true,
+							 PGC_USERSET,
+							 GUC_NOT_IN_SAMPLE,
+							 NULL, NULL, NULL);
+	/* turn on/off partition-wise gpujoin */
+	DefineCustomBoolVariable("pg_strom.enable_partitionwise_gpujoin",
+							 "Enables partition-wise GpuJoin on the partitioned outer table",
+							 NULL,
+							 &pgstrom_enable_partitionwise_gpujoin,
+							 true,
+							 PGC_USERSET,
+							 GUC_NOT_IN_SAMPLE,
+							 NULL, NULL, NULL);
+	DefineCustomIntVariable("pg_strom.gpujoin_inner_cache_nslots",
+							"Number of the GpuJoin inner buffers to be cached",
+							"0 disables the inner buffer cache",
+							&pgstrom_gpujoin_inner_cache_nslots,
+							16,
+							0,
+							1024,
+							PGC_POSTMASTER,
+							GUC_NOT_IN_SAMPLE,
+							NULL, NULL, NULL);
+	DefineCustomIntVariable("pg_strom.gpujoin_inner_partition_size",
+							"Threshold of the inner hash table size to split into partitions",
+							"0 means half of the smallest GPU device memory",
+							&pgstrom_gpujoin_inner_partition_size_mb,
+							0,
+							0,
+							INT_MAX,
+							PGC_USERSET,
+							GUC_NOT_IN_SAMPLE | GUC_UNIT_MB,
+							NULL, NULL, NULL);
 	/* tuan on/off gpugistindex */
 	DefineCustomBoolVariable("pg_strom.enable_gpugistindex",
 							 "Enables the use of GpuGistIndex logic",
@@ -2443,6 +5193,44 @@ pgstrom_init_gpu_join(void)
 							 PGC_USERSET,
 							 GUC_NOT_IN_SAMPLE,
 							 NULL, NULL, NULL);
+	/* turn on/off gpugridjoin */
+	DefineCustomBoolVariable("pg_strom.enable_gpugridjoin",
+							 "Enables the use of GpuGridJoin logic for spatial join",
+							 NULL,
+							 &pgstrom_enable_gpugridjoin,
+							 true,
+							 PGC_USERSET,
+							 GUC_NOT_IN_SAMPLE,
+							 NULL, NULL, NULL);
+	/* cell size of GpuGridJoin */
+	DefineCustomRealVariable("pg_strom.gpugridjoin_cell_size",
+							 "Width of the grid cell for GpuGridJoin (0 = distance of st_dwithin)",
+							 NULL,
+							 &pgstrom_gpugridjoin_cell_size,
+							 0.0,
+							 0.0,
+							 DBL_MAX,
+							 PGC_USERSET,
+							 GUC_NOT_IN_SAMPLE,
+							 NULL, NULL, NULL);
+	/* turn on/off gpurangejoin */
+	DefineCustomBoolVariable("pg_strom.enable_gpurangejoin",
+							 "Enables the use of GpuRangeJoin logic for band join",
+							 NULL,
+							 &pgstrom_enable_gpurangejoin,
+							 true,
+							 PGC_USERSET,
+							 GUC_NOT_IN_SAMPLE,
+							 NULL, NULL, NULL);
+	/* turn on/off polygon-index of st_contains() */
+	DefineCustomBoolVariable("pg_strom.enable_gpujoin_polygon_index",
+							 "Enables the polygon-index for st_contains() on the inner polygons of GpuJoin",
+							 NULL,
+							 &pgstrom_enable_gpujoin_polygon_index,
+							 true,
+							 PGC_USERSET,
+							 GUC_NOT_IN_SAMPLE,
+							 NULL, NULL, NULL);
 	/* setup path methods */
 	memset(&gpujoin_path_methods, 0, sizeof(CustomPathMethods));
 	gpujoin_path_methods.CustomName				= "GpuJoin";
@@ -2473,6 +5261,12 @@ pgstrom_init_gpu_join(void)
 		set_join_pathlist_next = set_join_pathlist_hook;
 		set_join_pathlist_hook = XpuJoinAddCustomPath;
 	}
+	shmem_request_next = shmem_request_hook;
+	shmem_request_hook = pgstrom_request_gpu_join;
+	shmem_startup_next = shmem_startup_hook;
+	shmem_startup_hook = pgstrom_startup_gpu_join;
+	CacheRegisterRelcacheCallback(gpujoinInnerCacheRelcacheCallback, 0);
+	RegisterXactCallback(gpujoinInnerCacheXactCallback, NULL);
 }
 
 
@@ -24,7 +24,14 @@ static bool					pgstrom_enable_partitionwise_dpupreagg = false;
 static bool					pgstrom_enable_gpupreagg = false;
 static bool					pgstrom_enable_partitionwise_gpupreagg = false;
 static bool					pgstrom_enable_numeric_aggfuncs;
+static bool					pgstrom_enable_exact_numeric_aggfuncs;
+static bool					pgstrom_enable_gpupreagg_distinct;
+static bool					pgstrom_enable_gpupreagg_groupingsets;
+static bool					pgstrom_enable_gpupreagg_select_distinct;
+static bool					pgstrom_enable_gpupreagg_complete_groups;
 int							pgstrom_hll_register_bits;
+int							pgstrom_gpupreagg_max_final_buffer_size;	/* GUC */
+bool						pgstrom_enable_gpupreagg_sorted_run;	/* GUC */
 
 /*
  * List of supported aggregate functions
@@ -285,6 +292,21 @@ static aggfunc_catalog_t	aggfunc_catalog_array[] = {
 	 "s:pavg(float8)",
 	 KAGG_ACTION__PAVG_FP, true
 	},
+	/*
+	 * SUM(X),AVG(X) on NUMERIC with bounded precision, by the exact 128bit
+	 * fixed-point accumulation. The planner chooses them instead of the above
+	 * float-based entries, if typmod of the argument allows.
+	 */
+	{"sum(numeric)",
+	 "s:sum_numeric(bytea)",
+	 "s:psum_numeric(numeric,int4)",
+	 KAGG_ACTION__PSUM_NUMERIC, false
+	},
+	{"avg(numeric)",
+	 "s:avg_numeric(bytea)",
+	 "s:pavg_numeric(numeric,int4)",
+	 KAGG_ACTION__PAVG_NUMERIC, false
+	},
 	/*
 	 * STDDEV(X) = EX_STDDEV_SAMP(NROWS(),PSUM(X),PSUM(X*X))
 	 */
@@ -614,6 +636,40 @@ static aggfunc_catalog_t	aggfunc_catalog_array[] = {
 	 "s:pcovar(float8,float8)",
 	 KAGG_ACTION__COVAR, false
 	},
+	/*
+	 * PERCENTILE_APPROX(X,F) = PERCENTILE_APPROX(PQUANTILE(X,F))
+	 */
+	{"s:percentile_approx(float8,float8)",
+	 "s:percentile_approx(bytea)",
+	 "s:pquantile(float8,float8)",
+	 KAGG_ACTION__PQUANTILE, false
+	},
+	/*
+	 * TOP_K(X,K) = TOP_K(PTOPK(X,K))
+	 */
+	{"s:top_k(float8,int4)",
+	 "s:top_k(bytea)",
+	 "s:ptopk(float8,int4)",
+	 KAGG_ACTION__PTOPK, false
+	},
+	/*
+	 * ARRAY_AGG(X) = ARRAY_AGG(PARRAY(X),...)
+	 * STRING_AGG(X,D) = STRING_AGG(PARRAY(X),D,...)
+	 *
+	 * The final functions take the element type (or the delimiter), the
+	 * sort operator and nulls-first flag of ORDER BY, in addition to the
+	 * partial state. See make_alternative_array_aggref().
+	 */
+	{"array_agg(anynonarray)",
+	 "s:array_agg(bytea,anynonarray,oid,bool)",
+	 "s:parray(anynonarray)",
+	 KAGG_ACTION__PARRAY, false
+	},
+	{"string_agg(text,text)",
+	 "s:string_agg(bytea,text,oid,bool)",
+	 "s:parray(anynonarray)",
+	 KAGG_ACTION__PARRAY, false
+	},
 	{ NULL, NULL, NULL, -1, false },
 };
 
@@ -631,6 +687,13 @@ typedef struct
 	int		partial_func_bufsz;
 	bool	numeric_aware;
 	bool	is_valid_entry;
+	/* alternative pair for the exact NUMERIC aggregation, if any */
+	Oid		exact_final_func_oid;
+	Oid		exact_partial_func_oid;
+	Oid		exact_partial_func_rettype;
+	int		exact_partial_func_nargs;
+	int		exact_partial_func_action;
+	int		exact_partial_func_bufsz;
 } aggfunc_catalog_entry;
 
 static HTAB	   *aggfunc_catalog_htable = NULL;
@@ -756,6 +819,13 @@ __aggfunc_resolve_partial_func(aggfunc_catalog_entry *entry,
 			type_oid = BYTEAOID;
 			partfn_bufsz = sizeof(kagg_state__psum_fp_packed);
 			break;
+
+		case KAGG_ACTION__PAVG_NUMERIC:
+		case KAGG_ACTION__PSUM_NUMERIC:
+			func_nargs = 2;
+			type_oid = BYTEAOID;
+			partfn_bufsz = sizeof(kagg_state__psum_numeric_packed);
+			break;
 			
 		case KAGG_ACTION__STDDEV:
 			func_nargs = 1;
@@ -767,6 +837,26 @@ __aggfunc_resolve_partial_func(aggfunc_catalog_entry *entry,
 			type_oid = BYTEAOID;
 			partfn_bufsz = sizeof(kagg_state__covar_packed);
 			break;
+		case KAGG_ACTION__PQUANTILE:
+			func_nargs = 2;
+			type_oid = BYTEAOID;
+			partfn_bufsz = sizeof(kagg_state__pquantile_packed);
+			break;
+		case KAGG_ACTION__PTOPK:
+			func_nargs = 2;
+			type_oid = BYTEAOID;
+			partfn_bufsz = sizeof(kagg_state__ptopk_packed);
+			break;
+		case KAGG_ACTION__PARRAY:
+			func_nargs = 1;
+			type_oid = BYTEAOID;
+			partfn_bufsz = sizeof(kagg_state__parray_packed);
+			break;
+		case KAGG_ACTION__PARRAY_KEY:
+			func_nargs = 2;
+			type_oid = BYTEAOID;
+			partfn_bufsz = sizeof(kagg_state__parray_packed);
+			break;
 		default:
 			elog(ERROR, "Catalog corruption? unknown action: %d", partfn_action);
 			break;
@@ -792,6 +882,7 @@ __aggfunc_resolve_final_func(aggfunc_catalog_entry *entry,
 	Oid			func_oid = __aggfunc_resolve_func_signature(finalfn_signature);
 	HeapTuple	htup;
 	Form_pg_proc proc;
+	int			func_nargs = 1;
 
 	if (!SearchSysCacheExists1(AGGFNOID, ObjectIdGetDatum(func_oid)) ||
 		get_func_rettype(func_oid) != agg_rettype)
@@ -801,8 +892,11 @@ __aggfunc_resolve_final_func(aggfunc_catalog_entry *entry,
 	if (!HeapTupleIsValid(htup))
 		elog(ERROR, "cache lookup failed for function %u", func_oid);
 	proc = (Form_pg_proc) GETSTRUCT(htup);
-	if (proc->pronargs != 1 ||
-		proc->proargtypes.dim1 != 1 ||
+	/* partial state, element type (or delimiter), sortop, nulls_first */
+	if (entry->partial_func_action == KAGG_ACTION__PARRAY)
+		func_nargs = 4;
+	if (proc->pronargs != func_nargs ||
+		proc->proargtypes.dim1 != func_nargs ||
 		proc->proargtypes.values[0] != entry->partial_func_rettype)
 		elog(ERROR, "Catalog corruption? final function mismatch: %s",
 			 format_procedure(func_oid));
@@ -847,13 +941,17 @@ aggfunc_catalog_lookup_by_oid(Oid aggfn_oid)
 			if (!HeapTupleIsValid(htup))
 				elog(ERROR, "cache lookup failed for function %u", aggfn_oid);
 			proc = (Form_pg_proc) GETSTRUCT(htup);
-			if (proc->pronamespace == PG_CATALOG_NAMESPACE &&
+			if ((proc->pronamespace == PG_CATALOG_NAMESPACE ||
+				 proc->pronamespace == get_namespace_oid("pgstrom", true)) &&
 				proc->pronargs <= 2)
 			{
 				char	buf[3*NAMEDATALEN+100];
 				int		off;
 
-				off = sprintf(buf, "%s(", NameStr(proc->proname));
+				/* PG-Strom's own aggregate functions have 's:' prefix */
+				off = sprintf(buf, "%s%s(",
+							  proc->pronamespace == PG_CATALOG_NAMESPACE ? "" : "s:",
+							  NameStr(proc->proname));
 				for (int j=0; j < proc->pronargs; j++)
 				{
 					Oid		type_oid = proc->proargtypes.values[j];
@@ -869,7 +967,28 @@ aggfunc_catalog_lookup_by_oid(Oid aggfn_oid)
 				{
 					const aggfunc_catalog_t *cat = &aggfunc_catalog_array[i];
 
-					if (strcmp(buf, cat->aggfn_signature) == 0)
+					if (strcmp(buf, cat->aggfn_signature) != 0)
+						continue;
+					if (cat->partfn_action == KAGG_ACTION__PSUM_NUMERIC ||
+						cat->partfn_action == KAGG_ACTION__PAVG_NUMERIC)
+					{
+						aggfunc_catalog_entry __entry;
+
+						memset(&__entry, 0, sizeof(aggfunc_catalog_entry));
+						__aggfunc_resolve_partial_func(&__entry,
+													   cat->partfn_signature,
+													   cat->partfn_action);
+						__aggfunc_resolve_final_func(&__entry,
+													 cat->finalfn_signature,
+													 proc->prorettype);
+						entry->exact_final_func_oid = __entry.final_func_oid;
+						entry->exact_partial_func_oid = __entry.partial_func_oid;
+						entry->exact_partial_func_rettype = __entry.partial_func_rettype;
+						entry->exact_partial_func_nargs = __entry.partial_func_nargs;
+						entry->exact_partial_func_action = __entry.partial_func_action;
+						entry->exact_partial_func_bufsz = __entry.partial_func_bufsz;
+					}
+					else if (!entry->is_valid_entry)
 					{
 						__aggfunc_resolve_partial_func(entry,
 													   cat->partfn_signature,
@@ -879,7 +998,6 @@ aggfunc_catalog_lookup_by_oid(Oid aggfn_oid)
 													 proc->prorettype);
 						entry->numeric_aware = cat->numeric_aware;
 						entry->is_valid_entry = true;
-						break;
 					}
 				}
 			}
@@ -894,11 +1012,46 @@ aggfunc_catalog_lookup_by_oid(Oid aggfn_oid)
 	}
 	if (!entry->is_valid_entry)
 		return NULL;
-	if (entry->numeric_aware && !pgstrom_enable_numeric_aggfuncs)
+	/* exact NUMERIC aggregation may be available, see the caller */
+	if (entry->numeric_aware && !pgstrom_enable_numeric_aggfuncs &&
+		!OidIsValid(entry->exact_partial_func_oid))
 		return NULL;
 	return entry;
 }
 
+/*
+ * aggfunc_exact_numeric_scale
+ *
+ * It returns the scale of the argument, if the aggregate function can use
+ * the exact NUMERIC aggregation; that requires the typmod with bounded
+ * precision not to overflow the 128bit fixed-point sum. Elsewhere, -1.
+ */
+static int
+aggfunc_exact_numeric_scale(const aggfunc_catalog_entry *aggfn_cat,
+							Aggref *aggref)
+{
+	TargetEntry *tle;
+	int32		typmod;
+	int			precision;
+	int			scale;
+
+	if (!pgstrom_enable_exact_numeric_aggfuncs ||
+		!OidIsValid(aggfn_cat->exact_partial_func_oid) ||
+		list_length(aggref->args) != 1)
+		return -1;
+	tle = linitial(aggref->args);
+	if (exprType((Node *)tle->expr) != NUMERICOID)
+		return -1;
+	typmod = exprTypmod((Node *)tle->expr);
+	if (typmod < (int32) VARHDRSZ)
+		return -1;
+	precision = ((typmod - VARHDRSZ) >> 16) & 0xffff;
+	scale = (((typmod - VARHDRSZ) & 0x7ff) ^ 1024) - 1024;
+	if (precision > KAGG_NUMERIC_MAX_PRECISION || scale < 0)
+		return -1;
+	return scale;
+}
+
 /*
  * xpugroupby_build_path_context
  */
@@ -910,8 +1063,10 @@ typedef struct
 	RelOptInfo	   *input_rel;
 	ParamPathInfo  *param_info;
 	double			num_groups;
+	double			num_partial_groups;
 	bool			try_parallel;
 	PathTarget	   *target_upper;
+	List		   *group_clause;	/* GROUP BY or SELECT DISTINCT */
 	PathTarget	   *target_partial;
 	PathTarget	   *target_final;
 	AggClauseCosts	final_clause_costs;
@@ -920,6 +1075,8 @@ typedef struct
 	List		   *inner_target_list;
 	List		   *groupby_keys;
 	List		   *groupby_keys_refno;
+	List		   *distinct_keys;
+	bool			has_distinct_aggs;
 	Node		   *havingQual;
 	const CustomPathMethods *custom_path_methods;
 } xpugroupby_build_path_context;
@@ -979,6 +1136,370 @@ make_expr_typecast(Expr *expr, Oid target_type)
 	return expr;
 }
 
+/*
+ * make_alternative_distinct_aggref
+ *
+ * DISTINCT aggregate is executed in two-phases. The xPU device groups the
+ * input rows by (grouping-keys + arguments of the DISTINCT aggregate), then
+ * the final Aggregate runs the original DISTINCT aggregate on the partial
+ * results. The other partial aggregates are still valid on the finer groups,
+ * because their final functions merge the partial states.
+ */
+static Node *
+make_alternative_distinct_aggref(xpugroupby_build_path_context *con,
+								 Aggref *aggref)
+{
+	pgstromPlanInfo *pp_info = con->pp_info;
+	Aggref	   *aggref_alt;
+	HeapTuple	htup;
+	Form_pg_aggregate agg;
+	ListCell   *lc;
+
+	if (!pgstrom_enable_gpupreagg_distinct)
+	{
+		elog(DEBUG2, "DISTINCT aggregate is disabled: %s",
+			 nodeToString(aggref));
+		return NULL;
+	}
+	if (aggref->aggfilter)
+	{
+		elog(DEBUG2, "DISTINCT aggregate with FILTER is not supported: %s",
+			 nodeToString(aggref));
+		return NULL;
+	}
+	if (aggref->aggkind != AGGKIND_NORMAL || aggref->aggdirectargs != NIL)
+	{
+		elog(DEBUG2, "DISTINCT aggregate is not a normal form: %s",
+			 nodeToString(aggref));
+		return NULL;
+	}
+
+	foreach (lc, aggref->args)
+	{
+		TargetEntry *tle = lfirst(lc);
+		Expr	   *expr = tle->expr;
+		Oid			type_oid = exprType((Node *)expr);
+		devtype_info *dtype;
+
+		if (IsA(expr, Const))
+			continue;
+		/* arguments shall be a part of the grouping-keys */
+		dtype = pgstrom_devtype_lookup(type_oid);
+		if (!dtype || !dtype->type_hashfunc ||
+			devtype_lookup_equal_func(dtype, exprCollation((Node *)expr)) == NULL)
+		{
+			elog(DEBUG2, "DISTINCT aggregate contains unsupported type (%s): %s",
+				 format_type_be(type_oid),
+				 nodeToString(expr));
+			return NULL;
+		}
+		if (!pgstrom_xpu_expression(expr,
+									pp_info->xpu_task_flags,
+									pp_info->scan_relid,
+									con->inner_target_list,
+									NULL))
+		{
+			elog(DEBUG2, "DISTINCT aggregate argument is not executable: %s",
+				 nodeToString(expr));
+			return NULL;
+		}
+		if (!list_member(con->groupby_keys, expr) &&
+			!list_member(con->distinct_keys, expr))
+			con->distinct_keys = lappend(con->distinct_keys, expr);
+	}
+	aggref_alt = copyObject(aggref);
+#if PG_VERSION_NUM >= 160000
+	/* partial results are not sorted by the DISTINCT arguments */
+	aggref_alt->aggpresorted = false;
+#endif
+	con->has_distinct_aggs = true;
+
+	/*
+	 * Update the cost factor
+	 */
+	htup = SearchSysCache1(AGGFNOID, ObjectIdGetDatum(aggref->aggfnoid));
+	if (!HeapTupleIsValid(htup))
+		elog(ERROR, "cache lookup failed for pg_aggregate %u", aggref->aggfnoid);
+	agg = (Form_pg_aggregate) GETSTRUCT(htup);
+	if (OidIsValid(agg->aggtransfn))
+		add_function_cost(con->root,
+						  agg->aggtransfn,
+						  NULL,
+						  &con->final_clause_costs.transCost);
+	if (OidIsValid(agg->aggfinalfn))
+		add_function_cost(con->root,
+						  agg->aggfinalfn,
+						  NULL,
+						  &con->final_clause_costs.finalCost);
+	ReleaseSysCache(htup);
+
+	return (Node *)aggref_alt;
+}
+
+/*
+ * make_alternative_final_aggref
+ *
+ * It makes the final aggregate function that takes the partial results
+ * (and the extra arguments, if any), instead of the supplied Aggref.
+ */
+static Aggref *
+make_alternative_final_aggref(xpugroupby_build_path_context *con,
+							  Aggref *aggref,
+							  Oid func_oid,
+							  List *final_args)
+{
+	Aggref	   *aggref_alt;
+	HeapTuple	htup;
+	Form_pg_aggregate agg;
+	List	   *arg_types = NIL;
+	List	   *arg_tlist = NIL;
+	ListCell   *lc;
+
+	htup = SearchSysCache1(AGGFNOID, ObjectIdGetDatum(func_oid));
+	if (!HeapTupleIsValid(htup))
+		elog(ERROR, "cache lookup failed for pg_aggregate %u", func_oid);
+	agg = (Form_pg_aggregate) GETSTRUCT(htup);
+
+	foreach (lc, final_args)
+	{
+		Expr   *expr = lfirst(lc);
+
+		arg_types = lappend_oid(arg_types, exprType((Node *)expr));
+		arg_tlist = lappend(arg_tlist,
+							makeTargetEntry(expr,
+											list_length(arg_tlist) + 1,
+											NULL, false));
+	}
+	aggref_alt = makeNode(Aggref);
+	aggref_alt->aggfnoid      = func_oid;
+	aggref_alt->aggtype       = aggref->aggtype;
+	aggref_alt->aggcollid     = aggref->aggcollid;
+	aggref_alt->inputcollid   = aggref->inputcollid;
+	aggref_alt->aggtranstype  = agg->aggtranstype;
+	aggref_alt->aggargtypes   = arg_types;
+	aggref_alt->aggdirectargs = NIL;	/* see sanity checks */
+	aggref_alt->args          = arg_tlist;
+	aggref_alt->aggorder      = NIL;  /* see sanity check */
+	aggref_alt->aggdistinct   = NIL;  /* see sanity check */
+	aggref_alt->aggfilter     = NULL; /* processed in partial-function */
+	aggref_alt->aggstar       = false;
+	aggref_alt->aggvariadic   = false;
+	aggref_alt->aggkind       = AGGKIND_NORMAL;   /* see sanity check */
+	aggref_alt->agglevelsup   = 0;
+	aggref_alt->aggsplit      = AGGSPLIT_SIMPLE;
+	aggref_alt->aggno         = aggref->aggno;
+	aggref_alt->aggtransno    = aggref->aggno;
+	aggref_alt->location      = aggref->location;
+	/*
+	 * MEMO: nodeAgg.c creates AggStatePerTransData for each aggtransno (that is
+	 * unique ID of transition state in the Agg). This is a kind of optimization
+	 * for the case when multiple aggregate function has identical transition state.
+	 * However, its impact is not large for GpuPreAgg because most of reduction
+	 * works are already executed at the xPU device side.
+	 * So, we simply assign aggref->aggno (unique ID within the Agg node) to
+	 * construct transition state for each alternative aggregate function.
+	 *
+	 * See the issue #614 to reproduce the problem in the future version.
+	 */
+
+	/*
+	 * Update the cost factor
+	 */
+	if (OidIsValid(agg->aggtransfn))
+		add_function_cost(con->root,
+						  agg->aggtransfn,
+						  NULL,
+						  &con->final_clause_costs.transCost);
+	if (OidIsValid(agg->aggfinalfn))
+		add_function_cost(con->root,
+						  agg->aggfinalfn,
+						  NULL,
+						  &con->final_clause_costs.finalCost);
+	ReleaseSysCache(htup);
+
+	return aggref_alt;
+}
+
+/*
+ * make_alternative_array_aggref
+ *
+ * array_agg(X [ORDER BY K]) and string_agg(X,D [ORDER BY K]) collect the
+ * items onto the per-group append buffer on the device, then the final
+ * function builds up the array (or the string) after sorting by K, if any.
+ * The buffer has fixed capacity, so it is not pushed down if the estimated
+ * number of items per group may not fit.
+ */
+static bool
+__array_aggref_item_is_supported(xpugroupby_build_path_context *con, Expr *expr)
+{
+	Oid			type_oid = exprType((Node *)expr);
+
+	/* xpu_datum_write() of the simple base types needs no colmeta */
+	if (get_typtype(type_oid) != TYPTYPE_BASE ||
+		get_typlen(type_oid) == -2 ||
+		!pgstrom_devtype_lookup(type_oid))
+	{
+		elog(DEBUG2, "array_agg/string_agg on unsupported type (%s): %s",
+			 format_type_be(type_oid),
+			 nodeToString(expr));
+		return false;
+	}
+	if (!pgstrom_xpu_expression(expr,
+								con->pp_info->xpu_task_flags,
+								con->pp_info->scan_relid,
+								con->inner_target_list,
+								NULL))
+	{
+		elog(DEBUG2, "Partial aggregate argument is not executable: %s",
+			 nodeToString(expr));
+		return false;
+	}
+	return true;
+}
+
+static Node *
+make_alternative_array_aggref(xpugroupby_build_path_context *con,
+							  Aggref *aggref,
+							  const aggfunc_catalog_entry *aggfn_cat)
+{
+	PathTarget *target_partial = con->target_partial;
+	pgstromPlanInfo *pp_info = con->pp_info;
+	TargetEntry *tle;
+	Expr	   *value;
+	Expr	   *sort_key = NULL;
+	Expr	   *extra;
+	Oid			partfn_oid = aggfn_cat->partial_func_oid;
+	int			partfn_action = KAGG_ACTION__PARRAY;
+	Oid			sortop = InvalidOid;
+	bool		nulls_first = false;
+	List	   *partfn_args;
+	Expr	   *partfn;
+	double		nitems;
+	double		width;
+	int			nargs = 0;
+	ListCell   *lc;
+
+	if (aggref->aggfilter)
+	{
+		elog(DEBUG2, "array_agg/string_agg with FILTER is not supported: %s",
+			 nodeToString(aggref));
+		return NULL;
+	}
+	foreach (lc, aggref->args)
+	{
+		if (!((TargetEntry *)lfirst(lc))->resjunk)
+			nargs++;
+	}
+	tle = linitial(aggref->args);
+	value = tle->expr;
+	if (!__array_aggref_item_is_supported(con, value))
+		return NULL;
+	if (nargs == 1)
+	{
+		/* array_agg; the element type to resolve the polymorphic result */
+		extra = (Expr *)makeNullConst(exprType((Node *)value),
+									  exprTypmod((Node *)value),
+									  exprCollation((Node *)value));
+	}
+	else
+	{
+		/* string_agg; the delimiter must be identical for all the rows */
+		tle = lsecond(aggref->args);
+		if (!IsA(tle->expr, Const))
+		{
+			elog(DEBUG2, "string_agg with non-constant delimiter is not supported: %s",
+				 nodeToString(aggref));
+			return NULL;
+		}
+		extra = copyObject(tle->expr);
+	}
+
+	if (aggref->aggorder != NIL)
+	{
+		SortGroupClause *sortcl;
+
+		if (list_length(aggref->aggorder) > 1)
+		{
+			elog(DEBUG2, "array_agg/string_agg with multiple sort keys is not supported: %s",
+				 nodeToString(aggref));
+			return NULL;
+		}
+		sortcl = linitial(aggref->aggorder);
+		sort_key = (Expr *)get_sortgroupclause_expr(sortcl, aggref->args);
+		sortop = sortcl->sortop;
+		nulls_first = sortcl->nulls_first;
+		if (equal(sort_key, value))
+			sort_key = NULL;	/* sorted by the value itself */
+		else
+		{
+			if (!__array_aggref_item_is_supported(con, sort_key))
+				return NULL;
+			partfn_oid = __aggfunc_resolve_func_signature("s:parray(anynonarray,any)");
+			partfn_action = KAGG_ACTION__PARRAY_KEY;
+		}
+	}
+
+	/*
+	 * Capacity of the partial state
+	 */
+	width = (offsetof(kagg_parray_item, payload) +
+			 MAXALIGN(get_typavgwidth(exprType((Node *)value),
+									  exprTypmod((Node *)value))));
+	if (sort_key)
+		width += MAXALIGN(get_typavgwidth(exprType((Node *)sort_key),
+										  exprTypmod((Node *)sort_key)));
+	nitems = con->input_rel->rows / Max(con->num_groups, 1.0);
+	if (nitems * width > (double)KAGG_PARRAY_BUFSZ)
+	{
+		elog(DEBUG2, "array_agg/string_agg: %.0f items per group (width=%.0f) may not fit the partial state: %s",
+			 nitems, width, nodeToString(aggref));
+		return NULL;
+	}
+	if (pp_info->groupby_prepfn_bufsz +
+		sizeof(kagg_state__parray_packed) > BLCKSZ / 2)
+	{
+		elog(DEBUG2, "array_agg/string_agg: too large partial states: %s",
+			 nodeToString(aggref));
+		return NULL;
+	}
+
+	/*
+	 * Build partial-aggregate function
+	 */
+	partfn_args = list_make1(value);
+	if (sort_key)
+		partfn_args = lappend(partfn_args, sort_key);
+	partfn = (Expr *)makeFuncExpr(partfn_oid,
+								  BYTEAOID,
+								  partfn_args,
+								  InvalidOid,
+								  aggref->inputcollid,
+								  COERCE_EXPLICIT_CALL);
+	if (!list_member(target_partial->exprs, partfn))
+	{
+		add_column_to_pathtarget(target_partial, partfn, 0);
+		pp_info->groupby_actions = lappend_int(pp_info->groupby_actions,
+											   partfn_action);
+		pp_info->groupby_prepfn_bufsz += sizeof(kagg_state__parray_packed);
+	}
+
+	/*
+	 * Build final-aggregate function
+	 */
+	return (Node *)
+		make_alternative_final_aggref(con, aggref,
+									  aggfn_cat->final_func_oid,
+									  list_make4(partfn, extra,
+												 makeConst(OIDOID,
+														   -1,
+														   InvalidOid,
+														   sizeof(Oid),
+														   ObjectIdGetDatum(sortop),
+														   false,
+														   true),
+												 makeBoolConst(nulls_first, false)));
+}
+
 /*
  * make_alternative_aggref
  *
@@ -989,21 +1510,27 @@ static Node *
 make_alternative_aggref(xpugroupby_build_path_context *con, Aggref *aggref)
 {
 	const aggfunc_catalog_entry *aggfn_cat;
+	aggfunc_catalog_entry exact_cat;
 	PathTarget *target_partial = con->target_partial;
 	pgstromPlanInfo *pp_info = con->pp_info;
 	List	   *partfn_args = NIL;
+	int			numeric_scale;
 	Expr	   *partfn;
-	Aggref	   *aggref_alt;
-	Oid			func_oid;
 	HeapTuple	htup;
 	Form_pg_proc proc;
-	Form_pg_aggregate agg;
 	ListCell   *lc;
 	int			j;
 
-	if (aggref->aggorder != NIL || aggref->aggdistinct != NIL)
+	if (aggref->aggdistinct != NIL)
+		return make_alternative_distinct_aggref(con, aggref);
+	if (aggref->aggorder != NIL)
 	{
-		elog(DEBUG2, "Aggregate with ORDER BY/DISTINCT is not supported: %s",
+		/* array_agg/string_agg sort the items at the final function */
+		aggfn_cat = aggfunc_catalog_lookup_by_oid(aggref->aggfnoid);
+		if (aggfn_cat &&
+			aggfn_cat->partial_func_action == KAGG_ACTION__PARRAY)
+			return make_alternative_array_aggref(con, aggref, aggfn_cat);
+		elog(DEBUG2, "Aggregate with ORDER BY is not supported: %s",
 			 nodeToString(aggref));
 		return NULL;
 	}
@@ -1027,6 +1554,31 @@ make_alternative_aggref(xpugroupby_build_path_context *con, Aggref *aggref)
 	/* sanity checks */
 	Assert(aggref->aggkind == AGGKIND_NORMAL &&
 		   !aggref->aggvariadic);
+	if (aggfn_cat->partial_func_action == KAGG_ACTION__PARRAY)
+		return make_alternative_array_aggref(con, aggref, aggfn_cat);
+
+	/*
+	 * Exact NUMERIC aggregation, if typmod of the argument allows. It takes
+	 * the scale as the second argument of the partial function.
+	 */
+	numeric_scale = aggfunc_exact_numeric_scale(aggfn_cat, aggref);
+	if (numeric_scale >= 0)
+	{
+		memcpy(&exact_cat, aggfn_cat, sizeof(aggfunc_catalog_entry));
+		exact_cat.final_func_oid = aggfn_cat->exact_final_func_oid;
+		exact_cat.partial_func_oid = aggfn_cat->exact_partial_func_oid;
+		exact_cat.partial_func_rettype = aggfn_cat->exact_partial_func_rettype;
+		exact_cat.partial_func_nargs = aggfn_cat->exact_partial_func_nargs;
+		exact_cat.partial_func_action = aggfn_cat->exact_partial_func_action;
+		exact_cat.partial_func_bufsz = aggfn_cat->exact_partial_func_bufsz;
+		aggfn_cat = &exact_cat;
+	}
+	else if (aggfn_cat->numeric_aware && !pgstrom_enable_numeric_aggfuncs)
+	{
+		elog(DEBUG2, "Aggregate function '%s' on numeric is disabled",
+			 format_procedure(aggref->aggfnoid));
+		return NULL;
+	}
 
 	/*
 	 * Build partial-aggregate function
@@ -1036,7 +1588,8 @@ make_alternative_aggref(xpugroupby_build_path_context *con, Aggref *aggref)
 		elog(ERROR, "cache lookup failed for function %u",
 			 aggfn_cat->partial_func_oid);
 	proc = (Form_pg_proc) GETSTRUCT(htup);
-	Assert(list_length(aggref->args) == proc->pronargs);
+	Assert(list_length(aggref->args) +
+		   (numeric_scale >= 0 ? 1 : 0) == proc->pronargs);
 	j = 0;
 	foreach (lc, aggref->args)
 	{
@@ -1060,6 +1613,15 @@ make_alternative_aggref(xpugroupby_build_path_context *con, Aggref *aggref)
 		partfn_args = lappend(partfn_args, expr);
 	}
 	ReleaseSysCache(htup);
+	if (numeric_scale >= 0)
+		partfn_args = lappend(partfn_args,
+							  makeConst(INT4OID,
+										-1,
+										InvalidOid,
+										sizeof(int32),
+										Int32GetDatum(numeric_scale),
+										false,
+										true));
 
 	partfn = (Expr *)makeFuncExpr(aggfn_cat->partial_func_oid,
 								  aggfn_cat->partial_func_rettype,
@@ -1079,60 +1641,9 @@ make_alternative_aggref(xpugroupby_build_path_context *con, Aggref *aggref)
 	/*
 	 * Build final-aggregate function
 	 */
-	func_oid = aggfn_cat->final_func_oid;
-	htup = SearchSysCache1(AGGFNOID, ObjectIdGetDatum(func_oid));
-	if (!HeapTupleIsValid(htup))
-		elog(ERROR, "cache lookup failed for pg_aggregate %u", func_oid);
-	agg = (Form_pg_aggregate) GETSTRUCT(htup);
-
-	aggref_alt = makeNode(Aggref);
-	aggref_alt->aggfnoid      = func_oid;
-	aggref_alt->aggtype       = aggref->aggtype;
-	aggref_alt->aggcollid     = aggref->aggcollid;
-	aggref_alt->inputcollid   = aggref->inputcollid;
-	aggref_alt->aggtranstype  = agg->aggtranstype;
-	aggref_alt->aggargtypes   = list_make1_oid(exprType((Node *)partfn));
-	aggref_alt->aggdirectargs = NIL;	/* see sanity checks */
-	aggref_alt->args          = list_make1(makeTargetEntry(partfn, 1, NULL, false));
-	aggref_alt->aggorder      = NIL;  /* see sanity check */
-	aggref_alt->aggdistinct   = NIL;  /* see sanity check */
-	aggref_alt->aggfilter     = NULL; /* processed in partial-function */
-	aggref_alt->aggstar       = false;
-	aggref_alt->aggvariadic   = false;
-	aggref_alt->aggkind       = AGGKIND_NORMAL;   /* see sanity check */
-	aggref_alt->agglevelsup   = 0;
-	aggref_alt->aggsplit      = AGGSPLIT_SIMPLE;
-	aggref_alt->aggno         = aggref->aggno;
-	aggref_alt->aggtransno    = aggref->aggno;
-	aggref_alt->location      = aggref->location;
-	/*
-	 * MEMO: nodeAgg.c creates AggStatePerTransData for each aggtransno (that is
-	 * unique ID of transition state in the Agg). This is a kind of optimization
-	 * for the case when multiple aggregate function has identical transition state.
-	 * However, its impact is not large for GpuPreAgg because most of reduction
-	 * works are already executed at the xPU device side.
-	 * So, we simply assign aggref->aggno (unique ID within the Agg node) to
-	 * construct transition state for each alternative aggregate function.
-	 *
-	 * See the issue #614 to reproduce the problem in the future version.
-	 */
-
-	/*
-	 * Update the cost factor
-	 */
-	if (OidIsValid(agg->aggtransfn))
-		add_function_cost(con->root,
-						  agg->aggtransfn,
-						  NULL,
-						  &con->final_clause_costs.transCost);
-	if (OidIsValid(agg->aggfinalfn))
-		add_function_cost(con->root,
-						  agg->aggfinalfn,
-						  NULL,
-						  &con->final_clause_costs.finalCost);
-	ReleaseSysCache(htup);
-
-	return (Node *)aggref_alt;
+	return (Node *)make_alternative_final_aggref(con, aggref,
+												 aggfn_cat->final_func_oid,
+												 list_make1(partfn));
 }
 
 static Node *
@@ -1212,9 +1723,9 @@ xpugroupby_build_path_target(xpugroupby_build_path_context *con)
 		Expr   *expr = lfirst(lc1);
 		Index	sortgroupref = get_pathtarget_sortgroupref(target_upper, i++);
 
-		if (sortgroupref && parse->groupClause &&
+		if (sortgroupref && con->group_clause &&
 			get_sortgroupref_clause_noerr(sortgroupref,
-										  parse->groupClause) != NULL)
+										  con->group_clause) != NULL)
 		{
 			/* Grouping Key */
 			devtype_info *dtype;
@@ -1273,6 +1784,11 @@ xpugroupby_build_path_target(xpugroupby_build_path_context *con)
 			}
 			add_column_to_pathtarget(con->target_final, altfn, 0);
 		}
+		else if (IsA(expr, GroupingFunc) && parse->groupingSets != NIL)
+		{
+			/* GROUPING() is evaluated by the final Aggregate */
+			add_column_to_pathtarget(con->target_final, expr, 0);
+		}
 		else
 		{
 			elog(DEBUG2, "unexpected expression on the upper-tlist: %s",
@@ -1296,6 +1812,26 @@ xpugroupby_build_path_target(xpugroupby_build_path_context *con)
 	}
 	con->havingQual = havingQual;
 
+	/*
+	 * Arguments of DISTINCT aggregates are attached to the grouping-keys
+	 * of the partial aggregation, but not to the final aggregation.
+	 */
+	if (con->distinct_keys != NIL)
+	{
+		List   *groupExprs = NIL;
+
+		forboth (lc1, con->groupby_keys,
+				 lc2, con->groupby_keys_refno)
+		{
+			if (lfirst_int(lc2) != 0)
+				groupExprs = lappend(groupExprs, lfirst(lc1));
+		}
+		groupExprs = list_concat(groupExprs, con->distinct_keys);
+		con->num_partial_groups = estimate_num_groups(root, groupExprs,
+													  PP_INFO_NUM_ROWS(pp_info),
+													  NULL, NULL);
+	}
+
 	/*
 	 * Due to data alignment on the tuple on the kds_final, grouping-keys must
 	 * be located after the aggregate functions.
@@ -1312,6 +1848,14 @@ xpugroupby_build_path_target(xpugroupby_build_path_context *con)
 											   ? KAGG_ACTION__VREF_NOKEY
 											   : KAGG_ACTION__VREF);
 	}
+	foreach (lc1, con->distinct_keys)
+	{
+		Expr   *key = lfirst(lc1);
+
+		add_column_to_pathtarget(con->target_partial, key, 0);
+		pp_info->groupby_actions = lappend_int(pp_info->groupby_actions,
+											   KAGG_ACTION__VREF);
+	}
 	set_pathtarget_cost_width(root, con->target_final);
 	set_pathtarget_cost_width(root, con->target_partial);
 
@@ -1324,7 +1868,6 @@ xpugroupby_build_path_target(xpugroupby_build_path_context *con)
 static Path *
 prepend_partial_groupby_custompath(xpugroupby_build_path_context *con)
 {
-	Query	   *parse = con->root->parse;
 	CustomPath *cpath = makeNode(CustomPath);
 	PathTarget *target_partial = con->target_partial;
 	pgstromPlanInfo *pp_info = con->pp_info;
@@ -1362,7 +1905,7 @@ prepend_partial_groupby_custompath(xpugroupby_build_path_context *con)
 	startup_cost = (PP_INFO_STARTUP_COST(pp_info) +
 					PP_INFO_RUN_COST(pp_info));
 	/* Cost estimation for grouping */
-	num_group_keys = list_length(parse->groupClause);
+	num_group_keys = list_length(con->group_clause);
 	startup_cost += (xpu_operator_cost *
 					 num_group_keys *
 					 input_nrows);
@@ -1370,7 +1913,7 @@ prepend_partial_groupby_custompath(xpugroupby_build_path_context *con)
 	startup_cost += (target_partial->cost.per_tuple * input_nrows +
 					 target_partial->cost.startup) * xpu_ratio;
 	/* Cost estimation to fetch results */
-	run_cost = xpu_tuple_cost * con->num_groups;
+	run_cost = xpu_tuple_cost * con->num_partial_groups;
 
 	cpath->path.pathtype         = T_CustomScan;
 	cpath->path.parent           = con->input_rel;
@@ -1379,7 +1922,7 @@ prepend_partial_groupby_custompath(xpugroupby_build_path_context *con)
 	cpath->path.parallel_aware   = con->try_parallel;
 	cpath->path.parallel_safe    = con->input_rel->consider_parallel;
 	cpath->path.parallel_workers = pp_info->parallel_nworkers;
-	cpath->path.rows             = con->num_groups;
+	cpath->path.rows             = con->num_partial_groups;
 	cpath->path.startup_cost     = startup_cost;
 	cpath->path.total_cost       = startup_cost + run_cost;
 	cpath->path.pathkeys         = NIL;
@@ -1390,6 +1933,149 @@ prepend_partial_groupby_custompath(xpugroupby_build_path_context *con)
 	return &cpath->path;
 }
 
+/*
+ * try_add_final_groupingsets_paths
+ *
+ * GpuPreAgg groups the input by all the columns in the grouping sets, then
+ * the final Aggregate rolls up the partial results for each grouping set.
+ * Non-empty grouping sets are processed by the hashed rollups, and empty
+ * grouping sets are processed by the sorted rollup (AGG_MIXED).
+ */
+static void
+try_add_final_groupingsets_paths(xpugroupby_build_path_context *con,
+								 Path *part_path)
+{
+	PlannerInfo *root = con->root;
+	Query	   *parse = root->parse;
+	List	   *sets;
+	List	   *rollups = NIL;
+	RollupData *empty_rollup = NULL;
+	GroupingSetsPath *gpath;
+	Path	   *dummy_path;
+	ListCell   *lc1, *lc2;
+
+	if (con->has_distinct_aggs || !con->group_clause)
+	{
+		elog(DEBUG2, "GROUPING SETS is not supported with DISTINCT aggregates or without grouping columns");
+		return;
+	}
+	sets = expand_grouping_sets(parse->groupingSets, parse->groupDistinct, -1);
+	foreach (lc1, sets)
+	{
+		List	   *set = lfirst(lc1);
+		GroupingSetData *gs = makeNode(GroupingSetData);
+		RollupData *rollup;
+
+		gs->set = set;
+		if (set == NIL)
+		{
+			gs->numGroups = 1.0;
+			if (!empty_rollup)
+			{
+				empty_rollup = makeNode(RollupData);
+				empty_rollup->groupClause = NIL;
+				empty_rollup->hashable = false;
+				empty_rollup->is_hashed = false;
+			}
+			empty_rollup->gsets = lappend(empty_rollup->gsets, NIL);
+			empty_rollup->gsets_data = lappend(empty_rollup->gsets_data, gs);
+			empty_rollup->numGroups += 1.0;
+		}
+		else
+		{
+			List   *groupClause = NIL;
+			List   *groupExprs = NIL;
+			List   *gset = NIL;
+			int		index = 0;
+
+			foreach (lc2, set)
+			{
+				SortGroupClause *sgc = get_sortgroupref_clause(lfirst_int(lc2),
+															   con->group_clause);
+				groupClause = lappend(groupClause, sgc);
+				groupExprs = lappend(groupExprs,
+									 get_sortgroupclause_expr(sgc, parse->targetList));
+				gset = lappend_int(gset, index++);
+			}
+			gs->numGroups = estimate_num_groups(root, groupExprs,
+												part_path->rows,
+												NULL, NULL);
+			rollup = makeNode(RollupData);
+			rollup->groupClause = groupClause;
+			rollup->gsets = list_make1(gset);
+			rollup->gsets_data = list_make1(gs);
+			rollup->numGroups = gs->numGroups;
+			rollup->hashable = true;
+			rollup->is_hashed = true;
+			rollups = lappend(rollups, rollup);
+		}
+	}
+	if (rollups == NIL)
+		return;
+	/* sorted rollup must be the first one */
+	if (empty_rollup)
+		rollups = lcons(empty_rollup, rollups);
+
+	gpath = create_groupingsets_path(root,
+									 con->group_rel,
+									 part_path,
+									 (List *)con->havingQual,
+									 empty_rollup ? AGG_MIXED : AGG_HASHED,
+									 rollups,
+									 &con->final_clause_costs);
+	/* final Aggregate shall reference the partial results */
+	gpath->path.pathtarget = con->target_final;
+	dummy_path = pgstrom_create_dummy_path(root, &gpath->path);
+	add_path(con->group_rel, dummy_path);
+}
+
+/*
+ * try_add_final_complete_groups_path
+ *
+ * If GpuPreAgg runs on a single GPU without parallel workers and without
+ * flush of the partial groups, kds_final already holds exactly one row per
+ * group. So, the final Aggregate needs neither hash-table nor sorting; the
+ * AGG_SORTED on the unsorted input works as well, because every row starts
+ * a new group, and it just applies the final functions.
+ */
+static void
+try_add_final_complete_groups_path(xpugroupby_build_path_context *con,
+								   Path *part_path)
+{
+	Query	   *parse = con->root->parse;
+	CustomPath *cpath;
+	pgstromPlanInfo *pp_info;
+	Path	   *agg_path;
+	Path	   *dummy_path;
+
+	if (!pgstrom_enable_gpupreagg_complete_groups ||
+		con->try_parallel ||
+		con->has_distinct_aggs ||
+		parse->groupingSets != NIL ||
+		!con->group_clause ||
+		!IsA(part_path, CustomPath) ||
+		(con->pp_info->xpu_task_flags & DEVKIND__NVIDIA_GPU) == 0)
+		return;
+	cpath = makeNode(CustomPath);
+	memcpy(cpath, part_path, sizeof(CustomPath));
+	pp_info = copy_pgstrom_plan_info(con->pp_info);
+	pp_info->groupby_complete = true;
+	cpath->custom_private = list_make1(pp_info);
+
+	agg_path = (Path *)create_agg_path(con->root,
+									   con->group_rel,
+									   &cpath->path,
+									   con->target_final,
+									   AGG_SORTED,
+									   AGGSPLIT_SIMPLE,
+									   con->group_clause,
+									   (List *)con->havingQual,
+									   &con->final_clause_costs,
+									   con->num_groups);
+	dummy_path = pgstrom_create_dummy_path(con->root, agg_path);
+	add_path(con->group_rel, dummy_path);
+}
+
 /*
  * try_add_final_groupby_paths
  */
@@ -1402,7 +2088,35 @@ try_add_final_groupby_paths(xpugroupby_build_path_context *con,
 	Path	   *dummy_path;
 	double		hashTableSz;
 
-	if (!parse->groupClause)
+	if (parse->groupingSets != NIL)
+	{
+		try_add_final_groupingsets_paths(con, part_path);
+	}
+	else if (con->group_clause && con->has_distinct_aggs)
+	{
+		/*
+		 * DISTINCT aggregates are not supported by HashAgg, so the partial
+		 * results are sorted by the grouping-keys.
+		 */
+		Path   *sort_path = (Path *)create_sort_path(con->root,
+													 con->group_rel,
+													 part_path,
+													 con->root->group_pathkeys,
+													 -1.0);
+		agg_path = (Path *)create_agg_path(con->root,
+										   con->group_rel,
+										   sort_path,
+										   con->target_final,
+										   AGG_SORTED,
+										   AGGSPLIT_SIMPLE,
+										   con->group_clause,
+										   (List *)con->havingQual,
+										   &con->final_clause_costs,
+										   con->num_groups);
+		dummy_path = pgstrom_create_dummy_path(con->root, agg_path);
+		add_path(con->group_rel, dummy_path);
+	}
+	else if (!con->group_clause)
 	{
 		agg_path = (Path *)create_agg_path(con->root,
 										   con->group_rel,
@@ -1410,7 +2124,7 @@ try_add_final_groupby_paths(xpugroupby_build_path_context *con,
 										   con->target_final,
 										   AGG_PLAIN,
 										   AGGSPLIT_SIMPLE,
-										   parse->groupClause,
+										   con->group_clause,
 										   (List *)con->havingQual,
 										   &con->final_clause_costs,
 										   con->num_groups);
@@ -1419,12 +2133,17 @@ try_add_final_groupby_paths(xpugroupby_build_path_context *con,
 	}
 	else
 	{
-		Assert(grouping_is_hashable(parse->groupClause));
+		Assert(grouping_is_hashable(con->group_clause));
 		hashTableSz = estimate_hashagg_tablesize(con->root,
 												 part_path,
 												 &con->final_clause_costs,
 												 con->num_groups);
-		if (hashTableSz <= (double)work_mem * 1024.0)
+		/*
+		 * HashAgg spills out to disk if it exceeds work_mem, so large
+		 * number of groups are acceptable in the streaming mode.
+		 */
+		if (hashTableSz <= (double)work_mem * 1024.0 ||
+			pgstrom_gpupreagg_max_final_buffer_size > 0)
 		{
 			agg_path = (Path *)create_agg_path(con->root,
 											   con->group_rel,
@@ -1432,13 +2151,14 @@ try_add_final_groupby_paths(xpugroupby_build_path_context *con,
 											   con->target_final,
 											   AGG_HASHED,
 											   AGGSPLIT_SIMPLE,
-											   parse->groupClause,
+											   con->group_clause,
 											   (List *)con->havingQual,
 											   &con->final_clause_costs,
 											   con->num_groups);
 			dummy_path = pgstrom_create_dummy_path(con->root, agg_path);
 			add_path(con->group_rel, dummy_path);
 		}
+		try_add_final_complete_groups_path(con, part_path);
 	}
 }
 
@@ -1449,11 +2169,12 @@ __xpupreagg_add_custompath(PlannerInfo *root,
 						   pgstromPlanInfo *pp_info,
 						   ParamPathInfo *param_info,
 						   List *inner_paths_list,
-						   void *extra,
+						   UpperRelationKind stage,
 						   bool try_parallel,
 						   double num_groups,
 						   const CustomPathMethods *custom_path_methods)
 {
+	Query	   *parse = root->parse;
 	xpugroupby_build_path_context con;
 	Path	   *part_path;
 	List	   *inner_target_list = NIL;
@@ -1473,8 +2194,12 @@ __xpupreagg_add_custompath(PlannerInfo *root,
 	con.input_rel      = input_rel;
 	con.param_info     = param_info;
 	con.num_groups     = num_groups;
+	con.num_partial_groups = num_groups;
 	con.try_parallel   = try_parallel;
-	con.target_upper   = root->upper_targets[UPPERREL_GROUP_AGG];
+	con.target_upper   = root->upper_targets[stage];
+	con.group_clause   = (stage == UPPERREL_DISTINCT
+						  ? parse->distinctClause
+						  : parse->groupClause);
 	con.target_partial = create_empty_pathtarget();
 	con.target_final   = create_empty_pathtarget();
 	con.pp_info        = pp_info;
@@ -1523,7 +2248,7 @@ __xpuPreAggAddCustomPathCommon(PlannerInfo *root,
 	Query	   *parse = root->parse;
 
 	/* quick bailout if not supported */
-	if (parse->groupingSets != NIL ||
+	if ((parse->groupingSets != NIL && !pgstrom_enable_gpupreagg_groupingsets) ||
 		!grouping_is_hashable(parse->groupClause))
 	{
 		elog(DEBUG2, "GROUP BY clause is not supported form");
@@ -1566,7 +2291,7 @@ __xpuPreAggAddCustomPathCommon(PlannerInfo *root,
 									   pp_info,
 									   param_info,
 									   inner_paths_list,
-									   extra,
+									   UPPERREL_GROUP_AGG,
 									   (try_parallel > 0),
 									   num_groups,
 									   custom_path_methods);
@@ -1575,6 +2300,79 @@ __xpuPreAggAddCustomPathCommon(PlannerInfo *root,
 	}
 }
 
+/*
+ * __xpuPreAggAddDistinctPathCommon
+ *
+ * SELECT DISTINCT without aggregation is equivalent to GROUP BY without
+ * aggregate functions, so XpuPreAgg can de-duplicate the rows on the device
+ * and the final HashAggregate merges the partial groups.
+ */
+static void
+__xpuPreAggAddDistinctPathCommon(PlannerInfo *root,
+								 RelOptInfo *input_rel,
+								 RelOptInfo *distinct_rel,
+								 uint32_t xpu_task_flags,
+								 const CustomPathMethods *custom_path_methods)
+{
+	Query	   *parse = root->parse;
+
+	/* quick bailout if not supported */
+	if (parse->distinctClause == NIL ||
+		parse->hasDistinctOn ||
+		parse->hasAggs ||
+		parse->groupClause != NIL ||
+		parse->groupingSets != NIL ||
+		parse->havingQual != NULL ||
+		parse->hasWindowFuncs ||
+		parse->hasTargetSRFs ||
+		!grouping_is_hashable(parse->distinctClause))
+	{
+		elog(DEBUG2, "SELECT DISTINCT is not supported form");
+		return;
+	}
+	/* input must be the scan/join relation */
+	if (!IS_SIMPLE_REL(input_rel) && !IS_JOIN_REL(input_rel))
+		return;
+	/* dummy path on the top must produce the reltarget of distinct_rel */
+	if (list_length(distinct_rel->reltarget->exprs) !=
+		list_length(root->upper_targets[UPPERREL_DISTINCT]->exprs))
+		return;
+
+	for (int try_parallel=0; try_parallel < 2; try_parallel++)
+	{
+		pgstromPlanInfo *pp_info;
+		ParamPathInfo  *param_info = NULL;
+		List		   *inner_paths_list = NIL;
+		List		   *distinctExprs;
+		double			num_groups;
+
+		pp_info = buildOuterJoinPlanInfo(root,
+										 input_rel,
+										 xpu_task_flags,
+										 (try_parallel > 0),
+										 &param_info,
+										 &inner_paths_list);
+		if (!pp_info)
+			continue;
+		/* see create_final_distinct_paths() */
+		distinctExprs = get_sortgrouplist_exprs(parse->distinctClause,
+												parse->targetList);
+		num_groups = estimate_num_groups(root, distinctExprs,
+										 PP_INFO_NUM_ROWS(pp_info),
+										 NULL, NULL);
+		__xpupreagg_add_custompath(root,
+								   distinct_rel,
+								   input_rel,
+								   pp_info,
+								   param_info,
+								   inner_paths_list,
+								   UPPERREL_DISTINCT,
+								   (try_parallel > 0),
+								   num_groups,
+								   custom_path_methods);
+	}
+}
+
 /*
  * XpuPreAggAddCustomPath
  */
@@ -1591,6 +2389,25 @@ XpuPreAggAddCustomPath(PlannerInfo *root,
 								input_rel,
 								group_rel,
 								extra);
+	if (stage == UPPERREL_DISTINCT)
+	{
+		if (pgstrom_enabled() && pgstrom_enable_gpupreagg_select_distinct)
+		{
+			if (pgstrom_enable_gpupreagg)
+				__xpuPreAggAddDistinctPathCommon(root,
+												 input_rel,
+												 group_rel,
+												 TASK_KIND__GPUPREAGG,
+												 &gpupreagg_path_methods);
+			if (pgstrom_enable_dpupreagg)
+				__xpuPreAggAddDistinctPathCommon(root,
+												 input_rel,
+												 group_rel,
+												 TASK_KIND__DPUPREAGG,
+												 &dpupreagg_path_methods);
+		}
+		return;
+	}
 	if (stage != UPPERREL_GROUP_AGG)
 		return;
 	if (pgstrom_enabled())
@@ -1739,6 +2556,15 @@ pgstrom_init_gpu_preagg(void)
 							 PGC_USERSET,
 							 GUC_NOT_IN_SAMPLE,
 							 NULL, NULL, NULL);
+	/* pg_strom.enable_exact_numeric_aggfuncs */
+	DefineCustomBoolVariable("pg_strom.enable_exact_numeric_aggfuncs",
+							 "Enable exact SUM/AVG on numeric with bounded precision",
+							 NULL,
+							 &pgstrom_enable_exact_numeric_aggfuncs,
+							 true,
+							 PGC_USERSET,
+							 GUC_NOT_IN_SAMPLE,
+							 NULL, NULL, NULL);
 	/* pg_strom.enable_numeric_aggfuncs */
 	DefineCustomBoolVariable("pg_strom.enable_numeric_aggfuncs",
 							 "Enable aggregate functions on numeric type",
@@ -1748,6 +2574,33 @@ pgstrom_init_gpu_preagg(void)
 							 PGC_USERSET,
 							 GUC_NO_SHOW_ALL | GUC_NOT_IN_SAMPLE,
 							 NULL, NULL, NULL);
+	/* pg_strom.enable_gpupreagg_distinct */
+	DefineCustomBoolVariable("pg_strom.enable_gpupreagg_distinct",
+							 "Enables DISTINCT aggregates on GPU-PreAgg",
+							 NULL,
+							 &pgstrom_enable_gpupreagg_distinct,
+							 true,
+							 PGC_USERSET,
+							 GUC_NOT_IN_SAMPLE,
+							 NULL, NULL, NULL);
+	/* pg_strom.enable_gpupreagg_select_distinct */
+	DefineCustomBoolVariable("pg_strom.enable_gpupreagg_select_distinct",
+							 "Enables SELECT DISTINCT on GPU-PreAgg",
+							 NULL,
+							 &pgstrom_enable_gpupreagg_select_distinct,
+							 true,
+							 PGC_USERSET,
+							 GUC_NOT_IN_SAMPLE,
+							 NULL, NULL, NULL);
+	/* pg_strom.enable_gpupreagg_groupingsets */
+	DefineCustomBoolVariable("pg_strom.enable_gpupreagg_groupingsets",
+							 "Enables GROUPING SETS, ROLLUP and CUBE on GPU-PreAgg",
+							 NULL,
+							 &pgstrom_enable_gpupreagg_groupingsets,
+							 true,
+							 PGC_USERSET,
+							 GUC_NOT_IN_SAMPLE,
+							 NULL, NULL, NULL);
 	/* pg_strom.enable_partitionwise_gpugroupby */
 	DefineCustomBoolVariable("pg_strom.enable_partitionwise_gpupreagg",
 							 "Enabled Enables partition wise GPU-PreAgg",
@@ -1768,6 +2621,35 @@ pgstrom_init_gpu_preagg(void)
 							PGC_USERSET,
 							GUC_NOT_IN_SAMPLE,
 							NULL, NULL, NULL);
+	/* pg_strom.enable_gpupreagg_complete_groups */
+	DefineCustomBoolVariable("pg_strom.enable_gpupreagg_complete_groups",
+							 "Enables to skip hashing in the final aggregation, if GpuPreAgg produces complete groups",
+							 NULL,
+							 &pgstrom_enable_gpupreagg_complete_groups,
+							 true,
+							 PGC_USERSET,
+							 GUC_NOT_IN_SAMPLE,
+							 NULL, NULL, NULL);
+	/* pg_strom.gpupreagg_max_final_buffer_size */
+	DefineCustomIntVariable("pg_strom.gpupreagg_max_final_buffer_size",
+							"Max size of the GPU-PreAgg hash table; partial groups are flushed to the host on overflow (0 = unlimited)",
+							NULL,
+							&pgstrom_gpupreagg_max_final_buffer_size,
+							0,
+							0,
+							INT_MAX,
+							PGC_USERSET,
+							GUC_NOT_IN_SAMPLE | GUC_UNIT_KB,
+							NULL, NULL, NULL);
+	/* pg_strom.enable_gpupreagg_sorted_run */
+	DefineCustomBoolVariable("pg_strom.enable_gpupreagg_sorted_run",
+							 "Enables GPU-PreAgg to merge the runs of the same grouping keys in a warp, prior to the hash table lookup",
+							 NULL,
+							 &pgstrom_enable_gpupreagg_sorted_run,
+							 true,
+							 PGC_USERSET,
+							 GUC_NOT_IN_SAMPLE,
+							 NULL, NULL, NULL);
 
 	/* initialization of path method table */
 	memset(&gpupreagg_path_methods, 0, sizeof(CustomPathMethods));
@@ -21,6 +21,8 @@ static CustomPathMethods	dpuscan_path_methods;
 static CustomScanMethods	dpuscan_plan_methods;
 static CustomExecMethods	dpuscan_exec_methods;
 static bool					enable_dpuscan = false;		/* GUC */
+static bool					pgstrom_enable_scan_limit = true;	/* GUC */
+static bool					pgstrom_enable_tablesample = true;	/* GUC */
 
 /*
  * sort_device_qualifiers
@@ -70,6 +72,34 @@ sort_device_qualifiers(List *dev_quals_list, List *dev_costs_list)
 	}
 }
 
+/*
+ * __tablesample_method
+ *
+ * It returns TABLESAMPLE_METHOD__* if the sampling method is supported
+ * by the xPU scan. SYSTEM method is applied on the blocks to be loaded,
+ * and BERNOULLI method is applied on the tuples by the device.
+ */
+static uint32_t
+__tablesample_method(TableSampleClause *tsc)
+{
+	uint32_t	method;
+
+	if (!pgstrom_enable_tablesample)
+		return TABLESAMPLE_METHOD__NONE;
+	if (tsc->tsmhandler == F_TSM_SYSTEM_HANDLER)
+		method = TABLESAMPLE_METHOD__SYSTEM;
+	else if (tsc->tsmhandler == F_TSM_BERNOULLI_HANDLER)
+		method = TABLESAMPLE_METHOD__BERNOULLI;
+	else
+		return TABLESAMPLE_METHOD__NONE;
+	/* arguments are evaluated once on the executor startup */
+	if (list_length(tsc->args) != 1 ||
+		contain_var_clause((Node *)tsc->args) ||
+		contain_var_clause((Node *)tsc->repeatable))
+		return TABLESAMPLE_METHOD__NONE;
+	return method;
+}
+
 /*
  * buildOuterScanPlanInfo
  */
@@ -85,6 +115,8 @@ __buildOuterScanPlanInfo(PlannerInfo *root,
 	RangeTblEntry  *rte = root->simple_rte_array[baserel->relid];
 	pgstromPlanInfo *pp_info;
 	int				gpu_cache_dindex = -1;
+	Expr		   *gpu_cache_lookup_key = NULL;
+	RestrictInfo   *gpu_cache_lookup_rinfo = NULL;
 	const Bitmapset *gpu_direct_devs = NULL;
 	const DpuStorageEntry *ds_entry = NULL;
 	Bitmapset	   *outer_refs = NULL;
@@ -105,7 +137,10 @@ __buildOuterScanPlanInfo(PlannerInfo *root,
 	double			xpu_tuple_cost;
 	QualCost		qcost;
 	double			ntuples = baserel->tuples;
+	double			qual_ntuples;
 	double			selectivity;
+	List		   *dpu_prefilter_quals = NIL;
+	double			dpu_prefilter_nrows = 0.0;
 
 	/*
 	 * CPU Parallel parameters
@@ -142,8 +177,9 @@ __buildOuterScanPlanInfo(PlannerInfo *root,
 		xpu_ratio = pgstrom_gpu_operator_ratio();
 		xpu_tuple_cost = pgstrom_gpu_tuple_cost;
 		startup_cost += pgstrom_gpu_setup_cost;
-		/* Is GPU-Cache available? */
-		gpu_cache_dindex = baseRelHasGpuCache(root, baserel);
+		/* Is GPU-Cache available? (not for TABLESAMPLE; no ctid) */
+		if (!rte->tablesample)
+			gpu_cache_dindex = baseRelHasGpuCache(root, baserel);
 		/* Is GPU-Direct SQL available? */
 		gpu_direct_devs = GetOptimalGpuForBaseRel(root, baserel);
 		if (gpu_cache_dindex >= 0)
@@ -184,7 +220,7 @@ __buildOuterScanPlanInfo(PlannerInfo *root,
 		disk_cost /= parallel_divisor;
 
 	/*
-	 * Is BRIN-index available?
+	 * Is BRIN-index (or B-tree index by the bitmap) available?
 	 */
 	indexOpt = pgstromTryFindBrinIndex(root, baserel,
 									   &indexConds,
@@ -197,6 +233,19 @@ __buildOuterScanPlanInfo(PlannerInfo *root,
 														  indexOpt,
 														  indexQuals) +
 								   avg_seq_page_cost * indexNBlocks);
+		/*
+		 * BRIN summaries are evaluated by the workers in parallel, but
+		 * B-tree index is scanned by one process; only the heap blocks
+		 * are loaded in parallel.
+		 */
+		if (parallel_path)
+		{
+			if (indexOpt->relam == BRIN_AM_OID)
+				index_disk_cost /= parallel_divisor;
+			else
+				index_disk_cost -= (avg_seq_page_cost * indexNBlocks *
+									(1.0 - 1.0 / parallel_divisor));
+		}
 		if (disk_cost > index_disk_cost)
 		{
 			disk_cost = index_disk_cost;
@@ -208,6 +257,23 @@ __buildOuterScanPlanInfo(PlannerInfo *root,
 	}
 	run_cost += disk_cost;
 
+	/*
+	 * Is point-lookup by GpuCache hash-index available?
+	 */
+	qual_ntuples = ntuples;
+	if (gpu_cache_dindex >= 0)
+	{
+		gpu_cache_lookup_key = baseRelGpuCacheLookupKey(root, baserel,
+														dev_quals,
+														&gpu_cache_lookup_rinfo);
+		if (gpu_cache_lookup_key)
+			qual_ntuples *= clause_selectivity(root,
+											   (Node *)gpu_cache_lookup_rinfo,
+											   baserel->relid,
+											   JOIN_INNER,
+											   NULL);
+	}
+
 	/*
 	 * Cost for xPU qualifiers
 	 */
@@ -215,7 +281,7 @@ __buildOuterScanPlanInfo(PlannerInfo *root,
 	{
 		cost_qual_eval_node(&qcost, (Node *)dev_quals, root);
 		startup_cost += qcost.startup;
-		run_cost += qcost.per_tuple * xpu_ratio * ntuples / parallel_divisor;
+		run_cost += qcost.per_tuple * xpu_ratio * qual_ntuples / parallel_divisor;
 
 		selectivity = clauselist_selectivity(root,
 											 dev_quals,
@@ -225,6 +291,37 @@ __buildOuterScanPlanInfo(PlannerInfo *root,
 		ntuples *= selectivity;		/* rows after dev_quals */
 	}
 
+	/*
+	 * Is DPU pre-filter of the outer relation cheaper?
+	 * DPU attached to the storage evaluates (a part of) dev_quals first,
+	 * then GPU processes only the survived rows relayed by the host.
+	 */
+	if ((xpu_task_flags & DEVKIND__ANY) == DEVKIND__NVIDIA_GPU &&
+		gpu_cache_dindex < 0 && !indexOpt && dev_quals != NIL &&
+		!rte->tablesample)
+	{
+		Cost	dpu_startup_cost;
+		Cost	dpu_run_cost;
+
+		dpu_prefilter_quals = pgstromTryDpuPreFilter(root, baserel,
+													 dev_quals,
+													 parallel_divisor,
+													 &dpu_startup_cost,
+													 &dpu_run_cost,
+													 &dpu_prefilter_nrows);
+		if (dpu_prefilter_quals != NIL &&
+			dpu_startup_cost + dpu_run_cost < run_cost)
+		{
+			startup_cost += dpu_startup_cost;
+			run_cost = dpu_run_cost;
+		}
+		else
+		{
+			dpu_prefilter_quals = NIL;
+			dpu_prefilter_nrows = 0.0;
+		}
+	}
+
 	/*
 	 * Cost for DMA receive (xPU-->Host)
 	 */
@@ -256,6 +353,7 @@ __buildOuterScanPlanInfo(PlannerInfo *root,
 	pp_info = palloc0(sizeof(pgstromPlanInfo));
 	pp_info->xpu_task_flags = xpu_task_flags;
 	pp_info->gpu_cache_dindex = gpu_cache_dindex;
+	pp_info->gpu_cache_lookup_key = gpu_cache_lookup_key;
 	pp_info->gpu_direct_devs = gpu_direct_devs;
 	pp_info->ds_entry = ds_entry;
 	pp_info->scan_relid = baserel->relid;
@@ -268,6 +366,15 @@ __buildOuterScanPlanInfo(PlannerInfo *root,
 	pp_info->scan_startup_cost = startup_cost;
 	pp_info->scan_run_cost = run_cost;
 	pp_info->final_cost = final_cost;
+	pp_info->dpu_prefilter_quals = dpu_prefilter_quals;
+	pp_info->dpu_prefilter_nrows = dpu_prefilter_nrows;
+	if (rte->tablesample)
+	{
+		pp_info->tablesample_method = __tablesample_method(rte->tablesample);
+		pp_info->tablesample_args = copyObject(rte->tablesample->args);
+		pp_info->tablesample_repeatable = copyObject(rte->tablesample->repeatable);
+		Assert(pp_info->tablesample_method != TABLESAMPLE_METHOD__NONE);
+	}
 	if (indexOpt)
 	{
 		pp_info->brin_index_oid = indexOpt->indexoid;
@@ -316,6 +423,11 @@ buildOuterScanPlanInfo(PlannerInfo *root,
 		default:
 			return NULL;
 	}
+	/* TABLESAMPLE clause is supported only by GPU */
+	if (rte->tablesample &&
+		((xpu_task_flags & DEVKIND__ANY) != DEVKIND__NVIDIA_GPU ||
+		 __tablesample_method(rte->tablesample) == TABLESAMPLE_METHOD__NONE))
+		return NULL;
 	/* does the base relation want parallel scan? */
 	if (parallel_path && !baserel->consider_parallel)
 		return NULL;
@@ -465,10 +577,20 @@ __xpuScanAddScanPathCommon(PlannerInfo *root,
 								 xpuscan_path_methods);
 		if (cpath)
 		{
+			CustomPath *sort_path = buildGpuSortPath(root, baserel, cpath);
+
 			if (try_parallel == 0)
+			{
 				add_path(baserel, &cpath->path);
+				if (sort_path)
+					add_path(baserel, &sort_path->path);
+			}
 			else
+			{
 				add_partial_path(baserel, &cpath->path);
+				if (sort_path)
+					add_partial_path(baserel, &sort_path->path);
+			}
 		}
 	}
 }
@@ -602,6 +724,9 @@ gpuscan_build_projection(RelOptInfo *baserel,
 	vars_list = pull_vars_of_level((Node *)pp_info->host_quals, 0);
 	foreach (lc, vars_list)
 		__gpuscan_build_projection_walker((Node *)lfirst(lc), &context);
+	/* sort keys must be on the kds_dst, if GpuSort */
+	foreach (lc, pp_info->gpusort_keys)
+		__gpuscan_build_projection_walker((Node *)lfirst(lc), &context);
 
 	context.resjunk = true;
 	vars_list = pull_vars_of_level((Node *)pp_info->scan_quals, 0);
@@ -669,6 +794,51 @@ __build_explain_tlist_junks(PlannerInfo *root,
 	}
 }
 
+/*
+ * pgstrom_compute_scan_limit
+ *
+ * It returns the maximum number of rows the upper LIMIT clause can consume
+ * from this scan/join, or 0 if unbounded. The bound is valid only when all
+ * the rows generated by the device are returned to the Limit node as is;
+ * so sorting, host qualifiers, and right/full outer join (unmatched inner
+ * rows are generated by the final task) are not acceptable.
+ * Note that ExecSetTupleBound() does not inform the bound to CustomScan,
+ * so we pick up the limit at the planner stage.
+ */
+double
+pgstrom_compute_scan_limit(PlannerInfo *root,
+						   RelOptInfo *rel,
+						   const pgstromPlanInfo *pp_info,
+						   const Path *best_path)
+{
+	Query	   *parse = root->parse;
+	double		limit = root->limit_tuples;
+
+	if (!pgstrom_enable_scan_limit ||
+		limit <= 0.0 ||
+		parse->commandType != CMD_SELECT ||
+		parse->rowMarks != NIL ||
+		parse->setOperations != NULL ||
+		root->query_pathkeys != NIL ||
+		best_path->param_info != NULL ||
+		!bms_is_subset(root->all_baserels, rel->relids))
+		return 0.0;
+	if ((pp_info->xpu_task_flags & DEVTASK__PREAGG) != 0 ||
+		pp_info->gpusort_keys != NIL ||
+		pp_info->host_quals != NIL)
+		return 0.0;
+	for (int i=0; i < pp_info->num_rels; i++)
+	{
+		const pgstromPlanInnerInfo *pp_inner = &pp_info->inners[i];
+
+		if (pp_inner->join_type == JOIN_RIGHT ||
+			pp_inner->join_type == JOIN_FULL ||
+			pp_inner->inner_nparts > 1)
+			return 0.0;
+	}
+	return ceil(limit);
+}
+
 /*
  * PlanXpuScanPathCommon
  */
@@ -691,12 +861,20 @@ PlanXpuScanPathCommon(PlannerInfo *root,
 	/* code generation for the Projection */
 	context->tlist_dev = gpuscan_build_projection(baserel, pp_info, tlist);
 	pp_info->kexp_projection = codegen_build_projection(context);
+	if (pp_info->gpusort_keys != NIL)
+		gpusort_build_tlist_dev(pp_info, context->tlist_dev);
+	pp_info->scan_limit = pgstrom_compute_scan_limit(root, baserel, pp_info,
+													 &best_path->path);
 	codegen_build_packed_kvars_load(context, pp_info);
 	codegen_build_packed_kvars_move(context, pp_info);
 	pp_info->kvars_deflist = context->kvars_deflist;
 	pp_info->extra_flags = context->extra_flags;
 	pp_info->extra_bufsz = context->extra_bufsz;
 	pp_info->used_params = context->used_params;
+	codegen_build_dpu_prefilter(root, pp_info);
+	pgstromCostCalibrationFactors(pp_info->xpu_task_flags,
+								  &pp_info->cost_setup_factor,
+								  &pp_info->cost_run_factor);
 	__build_explain_tlist_junks(root, baserel, context);
 
 	/* assign kvec buffer size for this scan */
@@ -873,6 +1051,24 @@ pgstrom_init_gpu_scan(void)
 							 PGC_USERSET,
 							 GUC_NOT_IN_SAMPLE,
 							 NULL, NULL, NULL);
+	/* pg_strom.enable_tablesample */
+	DefineCustomBoolVariable("pg_strom.enable_tablesample",
+							 "Enables TABLESAMPLE SYSTEM/BERNOULLI on GPU-Scan",
+							 NULL,
+							 &pgstrom_enable_tablesample,
+							 true,
+							 PGC_USERSET,
+							 GUC_NOT_IN_SAMPLE,
+							 NULL, NULL, NULL);
+	/* pg_strom.enable_scan_limit */
+	DefineCustomBoolVariable("pg_strom.enable_scan_limit",
+							 "Enables to stop device scan once LIMIT is satisfied",
+							 NULL,
+							 &pgstrom_enable_scan_limit,
+							 true,
+							 PGC_USERSET,
+							 GUC_NOT_IN_SAMPLE,
+							 NULL, NULL, NULL);
 	/* setup path methods */
 	memset(&gpuscan_path_methods, 0, sizeof(gpuscan_path_methods));
 	gpuscan_path_methods.CustomName			= "GpuScan";
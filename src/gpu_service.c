@@ -12,6 +12,10 @@
 #include "pg_strom.h"
 #include "cuda_common.h"
 #include <cudaProfiler.h>
+#include <limits.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include "arrow_ipc.h"
 /*
  * gpuContext / gpuMemory
  */
@@ -29,6 +33,7 @@ struct gpuContext
 {
 	dlist_node		chain;
 	int				serv_fd;		/* for accept(2) */
+	int				remote_fd;		/* for accept(2) from remote hosts, or -1 */
 	int				cuda_dindex;
 	CUdevice		cuda_device;
 	CUcontext		cuda_context;
@@ -50,22 +55,193 @@ struct gpuContext
 	pthread_cond_t	cond;
 	pthread_mutex_t	lock;
 	dlist_head		command_list;
+	/* pool of the pinned staging buffers; see gpuStagingBuffer */
+	pthread_mutex_t	staging_lock;
+	dlist_head		staging_free_list;
+	double			sched_vclock;	/* virtual clock of the scheduler */
+	uint32_t		sched_nbusy;	/* # of workers in execution */
+	pg_atomic_uint64 busy_usec;		/* total execution time by workers */
+	/* adaptive worker pool; only GPU service main thread touches */
+	uint32_t		pool_nworkers;
+	uint64_t		pool_last_sample;
+	uint64_t		pool_last_busy_usec;
+	int				pool_idle_rounds;
+	/* read-ahead of arrow record-batches; see gpuservArrowReadAheadMain */
+	pthread_cond_t	ra_cond;		/* protected by gcontext->lock */
+	dlist_head		ra_command_list;
+	uint32_t		ra_ninflight;	/* # of reads in progress */
+	uint32_t		ra_depth;		/* max # of reads in flight (adaptive) */
+	size_t			ra_staged_bytes;	/* loaded, but not picked up yet */
+	double			ra_bandwidth;	/* bytes/usec, best of the recent windows */
+	double			ra_latency_avg;	/* usec per read, moving average */
+	double			ra_length_avg;	/* bytes per read, moving average */
+	uint64_t		ra_window_start;
+	uint64_t		ra_window_bytes;
+	uint32_t		ra_window_count;
+	/* xpucode already resolved by the former sessions */
+	pthread_mutex_t	session_cache_lock;
+	dlist_head		session_cache_list;		/* LRU order */
+	int				session_cache_nitems;
+	/* extents of arrow files recently loaded; see gpuSharedScanBuffer */
+	pthread_mutex_t	shared_scan_lock;
+	dlist_head		shared_scan_list;		/* LRU order */
+	size_t			shared_scan_usage;
+	pg_atomic_uint32 shared_scan_nclients;	/* # of sessions attached */
+	/* arrow shared memory segments registered; see gpuShmemSegment */
+	pthread_mutex_t	shmem_segment_lock;
+	dlist_head		shmem_segment_list;		/* LRU order */
+	int				shmem_segment_nitems;
 };
 
+/*
+ * gpuSessionCache - plan-invariant portion of kern_session_info (kvars-defs,
+ * xpucode and sort-keys) whose device pointers are already resolved, to skip
+ * the JIT code generation and __resolveDevicePointers() when the same plan
+ * is executed repeatedly, like prepared statements.
+ */
+typedef struct
+{
+	dlist_node		chain;			/* link to gcontext->session_cache_list */
+	uint64_t		signature;		/* = session->xpucode_signature */
+	uint32_t		head;			/* = session->xpucode_cache_head */
+	uint32_t		length;			/* = session->xpucode_cache_length */
+	uint32_t		kvars_nslots;
+	bool			use_jit;
+	gpuJitModule   *jit_module;		/* JIT module (with refcnt), if any */
+	char		   *raw;			/* portion as sent by the backend */
+	char		   *resolved;		/* portion after device pointers resolved */
+} gpuSessionCache;
+
+#define GPUSERV_SESSION_CACHE_MAX_NITEMS	256
+
+/*
+ * gpuSharedScanBuffer - device copy of the arrow file extent that is
+ * recently loaded by GPU-Direct SQL. When multiple sessions scan the same
+ * arrow files concurrently, the record-batches are consumed almost in the
+ * same order (arrow_fdw synchronizes the start position of the scan), so
+ * the latter sessions copy the extent from the device memory instead of
+ * reading the storage again. Arrow files are never updated in-place, but
+ * the file identity and mtime are also checked for the safety.
+ */
+typedef struct
+{
+	dlist_node		chain;		/* link to gcontext->shared_scan_list */
+	dev_t			st_dev;
+	ino_t			st_ino;
+	off_t			st_size;
+	struct timespec	st_mtim;
+	uint32_t		fchunk_id;
+	uint32_t		nr_pages;
+	uint32_t		refcnt;		/* protected by gcontext->shared_scan_lock */
+	gpuMemChunk	   *chunk;
+} gpuSharedScanBuffer;
+
+/*
+ * gpuShmemSegment - arrow shared memory segment (see ArrowShmemHeader) that
+ * is mapped and registered as page-locked host memory, so the record-batches
+ * are copied to the device by DMA from the segment, without read(2) of the
+ * file. Producer only appends messages to the segment, so the mapping is
+ * reused as long as the extents requested are within the range mapped.
+ */
+typedef struct
+{
+	dlist_node		chain;		/* link to gcontext->shmem_segment_list */
+	dev_t			st_dev;
+	ino_t			st_ino;
+	char		   *mmap_addr;
+	size_t			mmap_sz;
+	uint32_t		refcnt;		/* protected by gcontext->shmem_segment_lock */
+} gpuShmemSegment;
+
+#define GPUSERV_SHMEM_SEGMENT_MAX_NITEMS	64
+
+#define GPUSERV_JOIN_PREFILTER_MAXDEPTH		32
+#define GPUSERV_JOIN_PREFILTER_MIN_NITEMS	100000
+#define GPUSERV_JOIN_PREFILTER_RATIO		0.25
+
+#define GPUSERV_REMOTE_AUTH_TIMEOUT			10		/* 10sec */
+#define GPUSERV_REMOTE_COMMAND_MAXSZ		(1UL << 30)
+#define GPUSERV_REMOTE_KEXP_MAXDEPTH		256
+
 struct gpuClient
 {
 	struct gpuContext *gcontext;/* per-device status */
 	dlist_node		chain;		/* gcontext->client_list */
 	kern_session_info *session;	/* per session info (on cuda managed memory) */
 	struct gpuQueryBuffer *gq_buf; /* per query join/preagg device buffer */
+	/* deferred gq_buf attachment (protected by gpu_query_buffer_mutex) */
+	bool			gq_buf_deferred;	/* gq_buf is not attached yet */
+	bool			gq_buf_attached;	/* AttachInnerBuffer is received */
+	uint32_t		gq_buf_kmrels_handle;
+	uint64_t		gq_buf_kmrels_signature;
 	pg_atomic_uint32 refcnt;	/* odd number, if error status */
 	pthread_mutex_t	mutex;		/* mutex to write the socket */
 	int				sockfd;		/* connection to PG backend */
+	bool			is_remote;	/* PG backend on the remote host */
+	uint64_t		remote_plan_id_mask; /* hash of the remote address */
+	uint8_t			auth_nonce[GPUSERV_AUTH_NONCE_LEN];	/* challenge */
+	uint8_t			auth_digest[PG_SHA256_DIGEST_LENGTH]; /* expected response */
 	pthread_t		worker;		/* receiver thread */
+	xpuCommandRing *cmd_ring;	/* command ring buffer, if any */
+	size_t			cmd_ring_sz;
+	xpuResultRing  *resp_ring;	/* result ring buffer, if any */
+	size_t			resp_ring_sz;
+	bool			resp_ring_registered; /* page-locked by CUDA */
+	gpuJitModule   *jit_module;	/* JIT compiled xpucode, if any */
+	CUmodule		cuda_module;/* module to launch kernels of the session */
+	/* adaptive reordering of the scan-quals */
+	uint32_t		aqual_nquals;	/* 0, if not adaptive */
+	uint64_t		aqual_order;	/* current order; see kern_context */
+	uint64_t		aqual_nevals[KERN_ADAPTIVE_QUALS_MAX];
+	uint64_t		aqual_npassed[KERN_ADAPTIVE_QUALS_MAX];
+	/* run-time bloom pre-filter of GpuJoin; see __gpuservUpdateJoinPrefilter */
+	uint32_t		jfilter_mask;	/* current prefilter_mask */
+	bool			jfilter_decided;
+	uint64_t		jfilter_nitems_in;
+	uint64_t		jfilter_nitems_out[GPUSERV_JOIN_PREFILTER_MAXDEPTH];
+	/* CUDA Graph of the GPU task kernel launch */
+	pthread_mutex_t	graph_lock;
+	struct gpuTaskGraph *graph_free_list;
+	/* # of rows already returned, if LIMIT clause is given */
+	pg_atomic_uint64 scan_nitems_out;
+	/* scheduler state (protected by gcontext->lock) */
+	double			sched_vtime;	/* virtual finish time of the last command */
+	uint32_t		sched_nrunning;	/* # of commands in execution */
+	/* kernel geometry of the session (valid if kgeom_block_sz > 0) */
+	int				kgeom_grid_sz;
+	int				kgeom_block_sz;
+	unsigned int	kgeom_shmem_sz;
+	unsigned int	kgeom_prepfn_bufsz;
+	unsigned int	kgeom_prepfn_nbufs;
+	/* 1, if session is counted in gcontext->shared_scan_nclients */
+	pg_atomic_uint32 shared_scan_attached;
+	/* GPU quota of the database/role, if any */
+	gpuQuotaSlot   *quota;
 };
 
+/*
+ * gpuTaskGraph - CUDA Graph instance to launch GPU task kernel
+ *
+ * A worker thread picks up an instance from the gclient->graph_free_list,
+ * then launches it with the kernel parameters of the chunk. It is not
+ * shared by the concurrent workers because the kernel parameters are
+ * updated on the instantiated graph.
+ */
+typedef struct gpuTaskGraph
+{
+	struct gpuTaskGraph *next;
+	CUfunction		f_kern;
+	int				grid_sz;
+	int				block_sz;
+	unsigned int	shmem_sz;
+	CUgraph			graph;
+	CUgraphExec		graph_exec;
+	CUgraphNode		kern_node;
+} gpuTaskGraph;
+
 #define GPUSERV_WORKER_KIND__GPUTASK		't'
 #define GPUSERV_WORKER_KIND__GPUCACHE		'c'
+#define GPUSERV_WORKER_KIND__READAHEAD		'r'
 
 typedef struct
 {
@@ -82,23 +258,128 @@ typedef struct
 //#define __SIGWAKEUP		(__SIGRTMIN + 3)
 #define __SIGWAKEUP		SIGUSR2
 
+/*
+ * gpuServWorkerPool - status of the GPU worker pool for each device,
+ * to be exposed by the pgstrom_gpu_device_info().
+ */
+typedef struct
+{
+	pg_atomic_uint32	nworkers;		/* current number of workers */
+	pg_atomic_uint32	nworkers_min;	/* lower bound of the pool */
+	pg_atomic_uint32	nworkers_max;	/* upper bound of the pool */
+	pg_atomic_uint32	queue_depth;	/* # of pending commands (last sample) */
+	pg_atomic_uint32	busy_ratio;		/* workers busy ratio in permill */
+	pg_atomic_uint32	last_nworkers;	/* # of workers before the last adjust */
+	pg_atomic_uint64	last_adjust;	/* timestamp of the last adjust */
+} gpuServWorkerPool;
+
+/*
+ * gpuServDeviceStats - cumulative statistics of the GPU service for each
+ * device, to be exposed by the pgstrom.pg_stat_gpu_service view.
+ * The memory pool status and the number of commands are sampled by the
+ * GPU service main thread periodically.
+ */
+typedef struct
+{
+	pg_atomic_uint32	nr_queued;			/* # of pending commands */
+	pg_atomic_uint32	nr_running;			/* # of commands in execution */
+	pg_atomic_uint32	nr_sessions;		/* # of connected sessions */
+	pg_atomic_uint64	nr_tasks;			/* # of GPU tasks completed */
+	pg_atomic_uint64	nr_fallbacks;		/* # of GPU tasks with CPU fallback */
+	pg_atomic_uint64	nr_suspends;		/* # of kernel suspend/resume */
+	pg_atomic_uint64	npages_direct_read;	/* # of pages by GPU-Direct SQL */
+	pg_atomic_uint64	npages_vfs_read;	/* # of pages by VFS */
+	pg_atomic_uint64	usec_load;			/* time to load the chunks */
+	pg_atomic_uint64	usec_kernel;		/* time to run the kernels */
+	pg_atomic_uint64	usec_writeback;		/* time to write back the results */
+	/* memory pool (raw device memory / managed memory) */
+	pg_atomic_uint32	mpool_raw_nsegs;
+	pg_atomic_uint64	mpool_raw_total;
+	pg_atomic_uint64	mpool_raw_active;
+	pg_atomic_uint64	mpool_raw_limit;
+	pg_atomic_uint32	mpool_managed_nsegs;
+	pg_atomic_uint64	mpool_managed_total;
+	pg_atomic_uint64	mpool_managed_active;
+	pg_atomic_uint64	stats_reset;		/* timestamp when GPU service starts */
+} gpuServDeviceStats;
+
+typedef struct
+{
+	gpuServWorkerPool	pool;
+	gpuServDeviceStats	stats;
+} gpuServDeviceState;
+
+/*
+ * gpuQuotaSlot - accounting of the GPU quota for each pair of database and
+ * role, to be exposed by the pgstrom.pg_stat_gpu_quota view.
+ * A slot is assigned on the first session with any quota configured by
+ * pg_strom.gpu_quota_* (usually, ALTER ROLE ... IN DATABASE ... SET), then
+ * the limits are updated by the latest session.
+ */
+#define GPUSERV_QUOTA_NSLOTS			128
+#define GPUSERV_QUOTA_WAIT_INTERVAL		10000		/* 10ms */
+typedef struct
+{
+	pg_atomic_uint64	quota_key;			/* database_oid<<32 | role_oid */
+	pg_atomic_uint64	memory_limit;		/* max device memory in bytes */
+	pg_atomic_uint32	tasks_limit;		/* max in-flight GPU tasks */
+	pg_atomic_uint32	action;				/* one of XPU_QUOTA_ACTION__* */
+	pg_atomic_uint32	wait_timeout;		/* in ms, for XPU_QUOTA_ACTION__WAIT */
+	pg_atomic_uint32	nr_running;			/* # of GPU tasks in execution */
+	pg_atomic_uint64	memory_usage;		/* device memory of query buffers */
+	pg_atomic_uint64	memory_peak;
+	pg_atomic_uint64	nr_tasks;			/* # of GPU tasks dispatched */
+	pg_atomic_uint64	nr_waits;			/* # of waits for the quota */
+	pg_atomic_uint64	nr_fallbacks;		/* # of partial groups flushed */
+	pg_atomic_uint64	nr_errors;			/* # of errors by the quota */
+} gpuQuotaSlot;
+
 typedef struct
 {
 	volatile pid_t		gpuserv_pid;
 	pg_atomic_uint32	max_async_tasks_updated;
 	pg_atomic_uint32	max_async_tasks;
 	pg_atomic_uint32	gpuserv_debug_output;
+	gpuQuotaSlot		quota_slots[GPUSERV_QUOTA_NSLOTS];
+	gpuServDeviceState	devs[FLEXIBLE_ARRAY_MEMBER];
 } gpuServSharedState;
 
+#define GPUSERV_DEVICE_STATS(dindex)	(&gpuserv_shared_state->devs[(dindex)].stats)
+
+#define GPUSERV_WORKER_POOL_INTERVAL	1000	/* 1sec */
+#define GPUSERV_WORKER_POOL_IDLE_RATIO	0.25
+#define GPUSERV_WORKER_POOL_IDLE_ROUNDS	5
+
+#define GPUSERV_MODULE_CACHE_DIR		"pg_strom_cache"
+
 /*
  * variables
  */
 int		pgstrom_max_async_gpu_tasks;	/* GUC */
+static bool	pgstrom_enable_cuda_graph;		/* GUC */
+static int		pgstrom_gpu_task_coalesce_threshold_kb;	/* GUC */
+int				pgstrom_gpu_task_priority;		/* GUC */
+static int		pgstrom_gpu_worker_max_per_session;	/* GUC */
+static bool		pgstrom_gpu_workers_adaptive;	/* GUC */
+static int		pgstrom_gpu_workers_min;		/* GUC */
+static int		pgstrom_gpu_workers_max;		/* GUC */
+static bool		pgstrom_gpu_module_cache;		/* GUC */
+static int		pgstrom_gpu_kvecs_buffer_limit_kb;	/* GUC */
+int				pgstrom_gpu_detoast_buffer_kb;		/* GUC */
+static int		pgstrom_gpudirect_stripe_queue_depth;	/* GUC */
+static int		pgstrom_gpu_shared_scan_buffer_mb;		/* GUC */
+int				pgstrom_arrow_readahead_threads;	/* GUC */
+static int		pgstrom_arrow_readahead_staging_mb;	/* GUC */
+int				pgstrom_gpu_quota_memory_kb;		/* GUC */
+int				pgstrom_gpu_quota_tasks;			/* GUC */
+int				pgstrom_gpu_quota_action;			/* GUC */
+int				pgstrom_gpu_quota_wait_timeout;		/* GUC */
 static __thread int			MY_DINDEX_PER_THREAD = -1;
 static __thread CUdevice	MY_DEVICE_PER_THREAD = -1;
 static __thread CUcontext	MY_CONTEXT_PER_THREAD = NULL;
 static __thread CUstream	MY_STREAM_PER_THREAD = NULL;
 static __thread CUevent		MY_EVENT_PER_THREAD = NULL;
+static __thread CUevent		MY_EVENT_START_PER_THREAD = NULL; /* for timing */
 static __thread gpuContext *GpuWorkerCurrentContext = NULL;
 static volatile int			gpuserv_bgworker_got_signal = 0;
 static dlist_head			gpuserv_gpucontext_list;
@@ -108,6 +389,12 @@ static shmem_startup_hook_type shmem_startup_next = NULL;
 static gpuServSharedState  *gpuserv_shared_state = NULL;
 static int					__pgstrom_max_async_tasks_dummy;
 static bool					__gpuserv_debug_output_dummy;
+static char				   *pgstrom_gpu_service_trace_dir = NULL;	/* GUC */
+static char				   *pgstrom_gpu_service_listen_address = NULL;	/* GUC */
+static char				   *pgstrom_gpu_service_remote_data_dir = NULL;	/* GUC */
+static char				  **gpuserv_remote_data_dirs = NULL;
+static int					gpuserv_remote_data_ndirs = 0;
+static int					pgstrom_gpu_service_trace_window;	/* GUC */
 
 #define GpuServDebug(fmt, ...)											\
 	do {																\
@@ -179,6 +466,268 @@ gpuserv_debug_output_show(void)
 	return (__gpuserv_debug_output_dummy ? "on" : "off");
 }
 
+/*
+ * __gpuservTimeUsec - monotonic clock in microseconds
+ */
+static inline uint64_t
+__gpuservTimeUsec(void)
+{
+	struct timespec	ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000UL + (uint64_t)ts.tv_nsec / 1000UL;
+}
+
+/*
+ * gpuServTraceRing - per-thread ring buffer of the trace events
+ *
+ * If pg_strom.gpu_service_trace_dir is configured, each thread of the GPU
+ * service records timestamped spans (load, kernel, writeback, ...) into
+ * its own ring buffer. Only the owner thread moves the head, and only the
+ * GPU service main thread moves the tail, so no lock is needed to record
+ * the events. The main thread drains the rings and writes out the events
+ * to the trace file in the Chrome Trace Event format (available on
+ * chrome://tracing or Perfetto UI), then switches the file for each time
+ * window.
+ */
+#define GPUSERV_TRACE_RING_NITEMS		8192
+
+typedef struct
+{
+	const char	   *cat;	/* must be a static string */
+	const char	   *name;	/* must be a static string */
+	uint64_t		ts;
+	uint64_t		dur;
+} gpuServTraceEvent;
+
+typedef struct gpuServTraceRing
+{
+	struct gpuServTraceRing *next;	/* protected by gpuserv_trace_lock */
+	int				tid;
+	char			label[32];
+	uint32_t		fileno;		/* thread_name is written to the file? */
+	volatile bool	orphaned;	/* owner thread already exited */
+	pg_atomic_uint64 head;		/* moved by the owner thread */
+	pg_atomic_uint64 tail;		/* moved by the main thread */
+	pg_atomic_uint64 ndropped;	/* # of events dropped by ring full */
+	gpuServTraceEvent events[GPUSERV_TRACE_RING_NITEMS];
+} gpuServTraceRing;
+
+static volatile bool		gpuserv_trace_enabled = false;
+static pthread_mutex_t		gpuserv_trace_lock = PTHREAD_MUTEX_INITIALIZER;
+static gpuServTraceRing	   *gpuserv_trace_rings = NULL;
+static int					gpuserv_trace_next_tid = 0;
+static FILE				   *gpuserv_trace_filp = NULL;
+static uint32_t				gpuserv_trace_fileno = 0;
+static uint64_t				gpuserv_trace_nevents;
+static uint64_t				gpuserv_trace_window_start;
+static __thread gpuServTraceRing *MY_TRACE_RING_PER_THREAD = NULL;
+
+/*
+ * __gpuservTraceThreadSetup / __gpuservTraceThreadCleanup
+ */
+static void
+__gpuservTraceThreadSetup(const char *fmt, ...)
+{
+	gpuServTraceRing *ring;
+	va_list		ap;
+
+	if (!gpuserv_trace_enabled)
+		return;
+	ring = calloc(1, sizeof(gpuServTraceRing));
+	if (!ring)
+	{
+		GpuServDebug("out of memory for the trace ring buffer");
+		return;
+	}
+	va_start(ap, fmt);
+	vsnprintf(ring->label, sizeof(ring->label), fmt, ap);
+	va_end(ap);
+	pg_atomic_init_u64(&ring->head, 0);
+	pg_atomic_init_u64(&ring->tail, 0);
+	pg_atomic_init_u64(&ring->ndropped, 0);
+
+	pthreadMutexLock(&gpuserv_trace_lock);
+	ring->tid = ++gpuserv_trace_next_tid;
+	ring->next = gpuserv_trace_rings;
+	gpuserv_trace_rings = ring;
+	pthreadMutexUnlock(&gpuserv_trace_lock);
+
+	MY_TRACE_RING_PER_THREAD = ring;
+}
+
+static void
+__gpuservTraceThreadCleanup(void)
+{
+	gpuServTraceRing *ring = MY_TRACE_RING_PER_THREAD;
+
+	if (ring)
+	{
+		/* main thread releases the ring after the last events are written */
+		pg_write_barrier();
+		ring->orphaned = true;
+		MY_TRACE_RING_PER_THREAD = NULL;
+	}
+}
+
+/*
+ * gpuservTraceBegin / gpuservTraceEnd
+ *
+ * gpuservTraceBegin() returns the start time of a span, or zero if the
+ * current thread is not traced. gpuservTraceEnd() records the span.
+ */
+uint64_t
+gpuservTraceBegin(void)
+{
+	if (gpuserv_trace_enabled && MY_TRACE_RING_PER_THREAD)
+		return __gpuservTimeUsec();
+	return 0;
+}
+
+void
+gpuservTraceEnd(const char *cat, const char *name, uint64_t tv_start)
+{
+	gpuServTraceRing *ring = MY_TRACE_RING_PER_THREAD;
+	gpuServTraceEvent *ev;
+	uint64_t	head;
+
+	if (tv_start == 0 || !ring)
+		return;
+	head = pg_atomic_read_u64(&ring->head);
+	if (head - pg_atomic_read_u64(&ring->tail) >= GPUSERV_TRACE_RING_NITEMS)
+	{
+		pg_atomic_fetch_add_u64(&ring->ndropped, 1);
+		return;
+	}
+	ev = &ring->events[head % GPUSERV_TRACE_RING_NITEMS];
+	ev->cat  = cat;
+	ev->name = name;
+	ev->ts   = tv_start;
+	ev->dur  = __gpuservTimeUsec() - tv_start;
+	pg_write_barrier();
+	pg_atomic_write_u64(&ring->head, head + 1);
+}
+
+/*
+ * __gpuservTraceOpenFile / __gpuservTraceCloseFile
+ */
+static bool
+__gpuservTraceOpenFile(void)
+{
+	char		path[MAXPGPATH];
+	char		tbuf[40];
+	struct tm	tm;
+	time_t		t = time(NULL);
+
+	localtime_r(&t, &tm);
+	strftime(tbuf, sizeof(tbuf), "%Y%m%d-%H%M%S", &tm);
+	snprintf(path, sizeof(path), "%s/gpuserv.%u.%s.json",
+			 pgstrom_gpu_service_trace_dir, getpid(), tbuf);
+	gpuserv_trace_filp = fopen(path, "wb");
+	if (!gpuserv_trace_filp)
+	{
+		elog(LOG, "GPU service tracing is disabled, failed on fopen('%s'): %m",
+			 path);
+		gpuserv_trace_enabled = false;
+		return false;
+	}
+	/* the closing bracket is optional in the JSON array format */
+	fputs("[\n", gpuserv_trace_filp);
+	gpuserv_trace_fileno++;
+	gpuserv_trace_nevents = 0;
+	gpuserv_trace_window_start = __gpuservTimeUsec();
+	return true;
+}
+
+static void
+__gpuservTraceCloseFile(void)
+{
+	if (gpuserv_trace_filp)
+	{
+		fputs("\n]\n", gpuserv_trace_filp);
+		fclose(gpuserv_trace_filp);
+		gpuserv_trace_filp = NULL;
+	}
+}
+
+#define __gpuservTraceWrite(fmt, ...)									\
+	fprintf(gpuserv_trace_filp, "%s" fmt,								\
+			gpuserv_trace_nevents++ == 0 ? "" : ",\n", ##__VA_ARGS__)
+
+/*
+ * __gpuservTraceFlush - called by the GPU service main thread
+ */
+static void
+__gpuservTraceFlush(bool closing)
+{
+	gpuServTraceRing *ring;
+	gpuServTraceRing **p_ring;
+	pid_t		pid = getpid();
+
+	if (!gpuserv_trace_enabled)
+		return;
+	if (!gpuserv_trace_filp && !__gpuservTraceOpenFile())
+		return;
+
+	pthreadMutexLock(&gpuserv_trace_lock);
+	p_ring = &gpuserv_trace_rings;
+	while ((ring = *p_ring) != NULL)
+	{
+		bool		orphaned = ring->orphaned;
+		uint64_t	head;
+		uint64_t	tail;
+		uint64_t	ndropped;
+
+		pg_read_barrier();
+		head = pg_atomic_read_u64(&ring->head);
+		tail = pg_atomic_read_u64(&ring->tail);
+		if (ring->fileno != gpuserv_trace_fileno)
+		{
+			__gpuservTraceWrite("{\"name\":\"thread_name\",\"ph\":\"M\","
+								"\"pid\":%u,\"tid\":%d,"
+								"\"args\":{\"name\":\"%s\"}}",
+								pid, ring->tid, ring->label);
+			ring->fileno = gpuserv_trace_fileno;
+		}
+		pg_read_barrier();
+		while (tail < head)
+		{
+			gpuServTraceEvent *ev = &ring->events[tail % GPUSERV_TRACE_RING_NITEMS];
+
+			__gpuservTraceWrite("{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\","
+								"\"ts\":%lu,\"dur\":%lu,\"pid\":%u,\"tid\":%d}",
+								ev->name, ev->cat, ev->ts, ev->dur,
+								pid, ring->tid);
+			tail++;
+		}
+		pg_memory_barrier();
+		pg_atomic_write_u64(&ring->tail, tail);
+
+		ndropped = pg_atomic_exchange_u64(&ring->ndropped, 0);
+		if (ndropped > 0)
+			__gpuservTraceWrite("{\"name\":\"dropped\",\"cat\":\"trace\",\"ph\":\"i\","
+								"\"s\":\"t\",\"ts\":%lu,\"pid\":%u,\"tid\":%d,"
+								"\"args\":{\"nevents\":%lu}}",
+								__gpuservTimeUsec(), pid, ring->tid, ndropped);
+		if (orphaned)
+		{
+			*p_ring = ring->next;
+			free(ring);
+		}
+		else
+			p_ring = &ring->next;
+	}
+	pthreadMutexUnlock(&gpuserv_trace_lock);
+	fflush(gpuserv_trace_filp);
+
+	/* switch the trace file for each time window */
+	if (closing ||
+		(pgstrom_gpu_service_trace_window > 0 &&
+		 __gpuservTimeUsec() - gpuserv_trace_window_start >=
+		 (uint64_t)pgstrom_gpu_service_trace_window * 1000000UL))
+		__gpuservTraceCloseFile();
+}
+
 static void
 pgstrom_max_async_tasks_assign(int newval, void *extra)
 {
@@ -254,6 +803,8 @@ typedef struct
 {
 	dlist_node	free_chain;
 	dlist_node	addr_chain;
+	dlist_node	cache_chain;	/* link to gpuMemThreadCache */
+	int			cache_class;	/* size class, or -1 if not cacheable */
 	gpuMemorySegment *mseg;
 	CUdeviceptr	__base;		/* base pointer of the segment */
 	size_t		__offset;	/* offset from the base */
@@ -261,55 +812,210 @@ typedef struct
 	CUdeviceptr	m_devptr;	/* __base + __offset */
 } gpuMemChunk;
 
+/*
+ * gpuMemThreadCache
+ *
+ * Per-worker thread cache of the size-classed small chunks. Chunks on the
+ * cache are still active from the standpoint of the memory pool, thus
+ * a worker thread can reuse them without pool->lock. The cache is flushed
+ * back to the pool when the worker thread is idle or exits.
+ */
+#define GPUMEM_CACHE_NCLASSES		11		/* 4kB ... 4MB */
+#define GPUMEM_CACHE_MAX_NITEMS		8		/* max number of items per class */
+typedef struct
+{
+	int			nitems[GPUMEM_CACHE_NCLASSES];
+	dlist_head	free_list[GPUMEM_CACHE_NCLASSES];
+} gpuMemThreadCache;
+
+static __thread bool				MY_MEMCACHE_ENABLED = false;
+static __thread gpuMemThreadCache	MY_MEMCACHE_RAW;
+static __thread gpuMemThreadCache	MY_MEMCACHE_MANAGED;
+
+static inline int
+__gpuMemSizeClass(size_t bytesize)
+{
+	int		cache_class = 0;
+
+	Assert(bytesize == PAGE_ALIGN(bytesize));
+	while ((PAGE_SIZE << cache_class) < bytesize)
+	{
+		if (++cache_class >= GPUMEM_CACHE_NCLASSES)
+			return -1;
+	}
+	return cache_class;
+}
+
+static inline gpuMemThreadCache *
+__gpuMemThreadCache(gpuMemoryPool *pool)
+{
+	gpuContext *gcontext = GpuWorkerCurrentContext;
+
+	if (!MY_MEMCACHE_ENABLED || !gcontext)
+		return NULL;
+	if (pool == &gcontext->pool_raw)
+		return &MY_MEMCACHE_RAW;
+	if (pool == &gcontext->pool_managed)
+		return &MY_MEMCACHE_MANAGED;
+	return NULL;
+}
+
 static gpuMemChunk *
-__gpuMemAllocFromSegment(gpuMemoryPool *pool,
-						 gpuMemorySegment *mseg,
-						 size_t bytesize)
+__gpuMemAllocFromChunk(gpuMemoryPool *pool,
+					   gpuMemorySegment *mseg,
+					   gpuMemChunk *chunk,
+					   size_t bytesize)
 {
-	gpuMemChunk	   *chunk;
-	gpuMemChunk	   *buddy;
-	dlist_iter		iter;
+	size_t		surplus = chunk->__length - bytesize;
 
-	dlist_foreach(iter, &mseg->free_chunks)
+	Assert(bytesize <= chunk->__length);
+	/* try to split, if free chunk is enough large (>4MB) */
+	if (surplus > (4UL << 20))
 	{
-		chunk = dlist_container(gpuMemChunk, free_chain, iter.cur);
+		gpuMemChunk *buddy = calloc(1, sizeof(gpuMemChunk));
 
-		if (bytesize <= chunk->__length)
+		if (!buddy)
 		{
-			size_t	surplus = chunk->__length - bytesize;
+			GpuServDebug("out of memory");
+			return NULL;	/* out of memory */
+		}
+		chunk->__length -= surplus;
+
+		buddy->mseg   = mseg;
+		buddy->__base = mseg->devptr;
+		buddy->__offset = chunk->__offset + chunk->__length;
+		buddy->__length = surplus;
+		buddy->m_devptr = (buddy->__base + buddy->__offset);
+		dlist_insert_after(&chunk->free_chain, &buddy->free_chain);
+		dlist_insert_after(&chunk->addr_chain, &buddy->addr_chain);
+	}
+	/* mark it as an active chunk */
+	dlist_delete(&chunk->free_chain);
+	memset(&chunk->free_chain, 0, sizeof(dlist_node));
+	chunk->cache_class = -1;
+	mseg->active_sz += chunk->__length;
+
+	/* update the LRU ordered segment list and timestamp */
+	gettimeofday(&mseg->tval, NULL);
+	dlist_move_head(&pool->segment_list, &mseg->chain);
+
+	return chunk;
+}
 
-			/* try to split, if free chunk is enough large (>4MB) */
-			if (surplus > (4UL << 20))
+/*
+ * __gpuMemAllocBestFit
+ *
+ * It picks up the smallest free chunk that can store 'bytesize' over the
+ * segments (or in the given segment only), then allocates it. First-fit
+ * on the LRU ordered segments tends to split the large free chunks by
+ * the small allocations; it makes the pool fragmented on the long-running
+ * mixed workloads, then the large kds_final or kmrels allocation fails
+ * even if total free memory is sufficient.
+ */
+static gpuMemChunk *
+__gpuMemAllocBestFit(gpuMemoryPool *pool,
+					 gpuMemorySegment *mseg_only,
+					 size_t bytesize)
+{
+	gpuMemorySegment *best_mseg = NULL;
+	gpuMemChunk	   *best_chunk = NULL;
+	dlist_iter		iter1;
+	dlist_iter		iter2;
+
+	dlist_foreach(iter1, &pool->segment_list)
+	{
+		gpuMemorySegment *mseg = dlist_container(gpuMemorySegment,
+												 chain, iter1.cur);
+		if (mseg_only && mseg != mseg_only)
+			continue;
+		if (mseg->active_sz + bytesize > mseg->segment_sz)
+			continue;
+		dlist_foreach(iter2, &mseg->free_chunks)
+		{
+			gpuMemChunk *chunk = dlist_container(gpuMemChunk,
+												 free_chain, iter2.cur);
+			if (chunk->__length < bytesize)
+				continue;
+			if (!best_chunk || chunk->__length < best_chunk->__length)
 			{
-				buddy = calloc(1, sizeof(gpuMemChunk));
-				if (!buddy)
-				{
-					GpuServDebug("out of memory");
-					return NULL;	/* out of memory */
-				}
-				chunk->__length -= surplus;
-
-				buddy->mseg   = mseg;
-				buddy->__base = mseg->devptr;
-				buddy->__offset = chunk->__offset + chunk->__length;
-				buddy->__length = surplus;
-				buddy->m_devptr = (buddy->__base + buddy->__offset);
-				dlist_insert_after(&chunk->free_chain, &buddy->free_chain);
-				dlist_insert_after(&chunk->addr_chain, &buddy->addr_chain);
+				best_mseg = mseg;
+				best_chunk = chunk;
+				if (chunk->__length == bytesize)
+					goto found;
 			}
-			/* mark it as an active chunk */
-			dlist_delete(&chunk->free_chain);
-			memset(&chunk->free_chain, 0, sizeof(dlist_node));
-			mseg->active_sz += chunk->__length;
+		}
+	}
+	if (!best_chunk)
+		return NULL;
+found:
+	return __gpuMemAllocFromChunk(pool, best_mseg, best_chunk, bytesize);
+}
+
+/*
+ * __gpuMemReleaseSegment
+ *
+ * It releases the idle segment; the caller must hold pool->lock.
+ */
+static void
+__gpuMemReleaseSegment(gpuMemoryPool *pool, gpuMemorySegment *mseg)
+{
+	uint64_t	tv_trace = gpuservTraceBegin();
+	CUresult	rc;
 
-			/* update the LRU ordered segment list and timestamp */
-			gettimeofday(&mseg->tval, NULL);
-			dlist_move_head(&pool->segment_list, &mseg->chain);
+	Assert(mseg->pool == pool && mseg->active_sz == 0);
+	if (!pool->is_managed &&
+		!gpuDirectUnmapGpuMemory(mseg->devptr,
+								 mseg->iomap_handle))
+		__FATAL("failed on gpuDirectUnmapGpuMemory");
+	rc = cuMemFree(mseg->devptr);
+	if (rc != CUDA_SUCCESS)
+		__FATAL("failed on cuMemFree: %s", cuStrError(rc));
+	/* detach segment */
+	dlist_delete(&mseg->chain);
+	while (!dlist_is_empty(&mseg->addr_chunks))
+	{
+		dlist_node	   *dnode = dlist_pop_head_node(&mseg->addr_chunks);
+		gpuMemChunk	   *chunk = dlist_container(gpuMemChunk,
+												addr_chain, dnode);
+		Assert(chunk->free_chain.prev &&
+			   chunk->free_chain.next);
+		free(chunk);
+	}
+	GpuServDebug("%s device memory %lu bytes released",
+				 pool->is_managed ? "managed" : "i/o mapped",
+				 mseg->segment_sz);
+	Assert(pool->total_sz >= mseg->segment_sz);
+	pool->total_sz -= mseg->segment_sz;
+	free(mseg);
+	gpuservTraceEnd("mempool", "release segment", tv_trace);
+}
 
-			return chunk;
-		}
+/*
+ * __gpuMemReleaseIdleSegments
+ *
+ * When the hard-limit does not allow to allocate a new segment, the idle
+ * segments are released immediately, regardless of the release delay;
+ * free memory of the idle segments is not available for the allocation
+ * larger than their free chunks. The least recently used one goes first.
+ */
+static void
+__gpuMemReleaseIdleSegments(gpuMemoryPool *pool, size_t required_sz)
+{
+	dlist_node *dnode;
+
+	if (dlist_is_empty(&pool->segment_list))
+		return;
+	dnode = dlist_tail_node(&pool->segment_list);
+	while (dnode && pool->total_sz + required_sz > pool->hard_limit)
+	{
+		gpuMemorySegment *mseg = dlist_container(gpuMemorySegment,
+												 chain, dnode);
+		dnode = (dlist_has_prev(&pool->segment_list, dnode)
+				 ? dlist_prev_node(&pool->segment_list, dnode)
+				 : NULL);
+		if (mseg->active_sz == 0)
+			__gpuMemReleaseSegment(pool, mseg);
 	}
-	return NULL;
 }
 
 static gpuMemorySegment *
@@ -317,6 +1023,7 @@ __gpuMemAllocNewSegment(gpuMemoryPool *pool, size_t segment_sz)
 {
 	gpuMemorySegment *mseg = calloc(1, sizeof(gpuMemorySegment));
 	gpuMemChunk	   *chunk = calloc(1, sizeof(gpuMemChunk));
+	uint64_t		tv_trace = gpuservTraceBegin();
 	CUresult		rc;
 
 	if (!mseg || !chunk)
@@ -366,6 +1073,7 @@ __gpuMemAllocNewSegment(gpuMemoryPool *pool, size_t segment_sz)
 
 	dlist_push_head(&pool->segment_list, &mseg->chain);
 	pool->total_sz += segment_sz;
+	gpuservTraceEnd("mempool", "alloc segment", tv_trace);
 
 	return mseg;
 error:
@@ -381,23 +1089,37 @@ error:
 static gpuMemChunk *
 __gpuMemAllocCommon(gpuMemoryPool *pool, size_t bytesize)
 {
-	dlist_iter	iter;
+	gpuMemThreadCache *mcache = __gpuMemThreadCache(pool);
 	size_t		segment_sz;
 	gpuMemChunk *chunk = NULL;
+	int			cache_class;
 
-	bytesize = PAGE_ALIGN(bytesize);
-	pthreadMutexLock(&pool->lock);
-	dlist_foreach(iter, &pool->segment_list)
+	cache_class = __gpuMemSizeClass(PAGE_ALIGN(bytesize));
+	if (cache_class >= 0)
 	{
-		gpuMemorySegment *mseg = dlist_container(gpuMemorySegment,
-												 chain, iter.cur);
-		if (mseg->active_sz + bytesize <= mseg->segment_sz)
+		/* size-classed chunks; try to pick up from the thread cache */
+		bytesize = (PAGE_SIZE << cache_class);
+		if (mcache && mcache->nitems[cache_class] > 0)
 		{
-			chunk = __gpuMemAllocFromSegment(pool, mseg, bytesize);
-			if (chunk)
-				goto out_unlock;
+			dlist_node *dnode = dlist_pop_head_node(&mcache->free_list[cache_class]);
+
+			chunk = dlist_container(gpuMemChunk, cache_chain, dnode);
+			mcache->nitems[cache_class]--;
+			Assert(chunk->cache_class == cache_class &&
+				   chunk->__length >= bytesize);
+			chunk->m_devptr = chunk->__base + chunk->__offset;
+			return chunk;
 		}
 	}
+	else
+	{
+		bytesize = PAGE_ALIGN(bytesize);
+	}
+
+	pthreadMutexLock(&pool->lock);
+	chunk = __gpuMemAllocBestFit(pool, NULL, bytesize);
+	if (chunk)
+		goto out_unlock;
 	segment_sz = ((size_t)pgstrom_gpu_mempool_segment_sz_kb << 10);
 	if (segment_sz < bytesize)
 		segment_sz = bytesize;
@@ -405,18 +1127,38 @@ __gpuMemAllocCommon(gpuMemoryPool *pool, size_t bytesize)
 	 * total consumption of mapped GPU memory must be less than
 	 * the hard-limit of the memory pool.
 	 */
+	if (!pool->is_managed &&
+		pool->total_sz + segment_sz > pool->hard_limit)
+	{
+		size_t	small_sz = TYPEALIGN(64UL << 20, bytesize);
+
+		__gpuMemReleaseIdleSegments(pool, segment_sz);
+		/*
+		 * If the hard-limit still does not allow a regular segment, we try
+		 * a segment just enough for the request; it is less efficient but
+		 * better than the allocation failure near the hard-limit.
+		 */
+		if (pool->total_sz + segment_sz > pool->hard_limit &&
+			small_sz < segment_sz)
+		{
+			__gpuMemReleaseIdleSegments(pool, small_sz);
+			segment_sz = small_sz;
+		}
+	}
 	if (pool->is_managed ||
 		pool->total_sz + segment_sz <= pool->hard_limit)
 	{
 		gpuMemorySegment *mseg = __gpuMemAllocNewSegment(pool, segment_sz);
 
 		if (mseg)
-			chunk = __gpuMemAllocFromSegment(pool, mseg, bytesize);
+			chunk = __gpuMemAllocBestFit(pool, mseg, bytesize);
 	}
 out_unlock:	
 	pthreadMutexUnlock(&pool->lock);
 
-	return (chunk ? chunk : NULL);
+	if (chunk)
+		chunk->cache_class = cache_class;
+	return chunk;
 }
 
 static gpuMemChunk *
@@ -432,7 +1174,7 @@ gpuMemAllocManaged(size_t bytesize)
 }
 
 static void
-gpuMemFree(gpuMemChunk *chunk)
+__gpuMemFreeToPool(gpuMemChunk *chunk)
 {
 	gpuMemoryPool  *pool;
 	gpuMemorySegment *mseg;
@@ -492,22 +1234,66 @@ gpuMemFree(gpuMemChunk *chunk)
 	pthreadMutexUnlock(&pool->lock);
 }
 
-/*
- * gpuMemoryPoolMaintenance
- */
 static void
-__gpuMemoryPoolMaintenanceTask(gpuContext *gcontext, gpuMemoryPool *pool)
+gpuMemFree(gpuMemChunk *chunk)
 {
-	dlist_iter		iter;
-	struct timeval	tval;
-	int64			tdiff;
-	CUresult		rc;
+	gpuMemThreadCache *mcache;
+	int			cache_class = chunk->cache_class;
 
-	if (!pthreadMutexTryLock(&pool->lock))
+	if (cache_class >= 0 &&
+		(mcache = __gpuMemThreadCache(chunk->mseg->pool)) != NULL &&
+		mcache->nitems[cache_class] < GPUMEM_CACHE_MAX_NITEMS)
+	{
+		/* keep the chunk on the thread cache */
+		dlist_push_head(&mcache->free_list[cache_class], &chunk->cache_chain);
+		mcache->nitems[cache_class]++;
 		return;
-	if (pool->total_sz > pool->keep_limit)
+	}
+	__gpuMemFreeToPool(chunk);
+}
+
+/*
+ * gpuMemThreadCacheFlush
+ *
+ * It releases all the chunks on the thread cache to the memory pool.
+ */
+static void
+__gpuMemThreadCacheFlush(gpuMemThreadCache *mcache)
+{
+	for (int i=0; i < GPUMEM_CACHE_NCLASSES; i++)
 	{
-		gettimeofday(&tval, NULL);
+		while (mcache->nitems[i] > 0)
+		{
+			dlist_node *dnode = dlist_pop_head_node(&mcache->free_list[i]);
+
+			__gpuMemFreeToPool(dlist_container(gpuMemChunk, cache_chain, dnode));
+			mcache->nitems[i]--;
+		}
+	}
+}
+
+static void
+gpuMemThreadCacheFlush(void)
+{
+	__gpuMemThreadCacheFlush(&MY_MEMCACHE_RAW);
+	__gpuMemThreadCacheFlush(&MY_MEMCACHE_MANAGED);
+}
+
+/*
+ * gpuMemoryPoolMaintenance
+ */
+static void
+__gpuMemoryPoolMaintenanceTask(gpuContext *gcontext, gpuMemoryPool *pool)
+{
+	dlist_iter		iter;
+	struct timeval	tval;
+	int64			tdiff;
+
+	if (!pthreadMutexTryLock(&pool->lock))
+		return;
+	if (pool->total_sz > pool->keep_limit)
+	{
+		gettimeofday(&tval, NULL);
 		dlist_reverse_foreach(iter, &pool->segment_list)
 		{
 			gpuMemorySegment *mseg = dlist_container(gpuMemorySegment,
@@ -523,28 +1309,7 @@ __gpuMemoryPoolMaintenanceTask(gpuContext *gcontext, gpuMemoryPool *pool)
 				continue;
 
 			/* ok, this segment should be released */
-			if (!gpuDirectUnmapGpuMemory(mseg->devptr,
-										 mseg->iomap_handle))
-				__FATAL("failed on gpuDirectUnmapGpuMemory");
-			rc = cuMemFree(mseg->devptr);
-			if (rc != CUDA_SUCCESS)
-				__FATAL("failed on cuMemFree: %s", cuStrError(rc));
-			/* detach segment */
-			dlist_delete(&mseg->chain);
-			while (!dlist_is_empty(&mseg->addr_chunks))
-			{
-				dlist_node	   *dnode = dlist_pop_head_node(&mseg->addr_chunks);
-				gpuMemChunk	   *chunk = dlist_container(gpuMemChunk,
-														addr_chain, dnode);
-				Assert(chunk->free_chain.prev &&
-					   chunk->free_chain.next);
-				free(chunk);
-			}
-			GpuServDebug("GPU-%d: i/o mapped device memory %lu bytes released",
-						 gcontext->cuda_dindex, mseg->segment_sz);
-			Assert(pool->total_sz >= mseg->segment_sz);
-			pool->total_sz -= mseg->segment_sz;
-			free(mseg);
+			__gpuMemReleaseSegment(pool, mseg);
 			break;
 		}
 	}
@@ -572,6 +1337,153 @@ gpuMemoryPoolInit(gpuMemoryPool *pool,
 	dlist_init(&pool->segment_list);
 }
 
+/* ----------------------------------------------------------------
+ *
+ * GPU quota support routines
+ *
+ * The device memory of the query buffers (GpuJoin inner buffer and
+ * GpuPreAgg final buffer) and the number of GPU tasks in execution are
+ * accounted for each pair of database and role.
+ *
+ * ----------------------------------------------------------------
+ */
+
+/*
+ * __gpuQuotaLookupSlot
+ *
+ * It returns the quota slot of the session, or NULL if no quota is
+ * configured (or no slots are available).
+ */
+static gpuQuotaSlot *
+__gpuQuotaLookupSlot(const kern_session_info *session)
+{
+	uint64_t	quota_key;
+	int			index;
+
+	if (session->quota_memory_limit == 0 &&
+		session->quota_tasks_limit == 0)
+		return NULL;
+	quota_key = (((uint64_t)session->quota_database_oid << 32) |
+				 ((uint64_t)session->quota_role_oid));
+	if (quota_key == 0)
+		return NULL;
+	index = hash_uint32((uint32_t)(quota_key ^ (quota_key >> 32))) % GPUSERV_QUOTA_NSLOTS;
+	for (int count=0; count < GPUSERV_QUOTA_NSLOTS; count++)
+	{
+		gpuQuotaSlot *quota = &gpuserv_shared_state->quota_slots[index];
+		uint64_t	curr_key = pg_atomic_read_u64(&quota->quota_key);
+
+		if (curr_key == 0 &&
+			pg_atomic_compare_exchange_u64(&quota->quota_key, &curr_key, quota_key))
+			curr_key = quota_key;
+		if (curr_key == quota_key)
+		{
+			/* the latest session updates the limits */
+			pg_atomic_write_u64(&quota->memory_limit, session->quota_memory_limit);
+			pg_atomic_write_u32(&quota->tasks_limit, session->quota_tasks_limit);
+			pg_atomic_write_u32(&quota->action, session->quota_action);
+			pg_atomic_write_u32(&quota->wait_timeout, session->quota_wait_timeout);
+			return quota;
+		}
+		index = (index + 1) % GPUSERV_QUOTA_NSLOTS;
+	}
+	GpuServDebug("no GPU quota slots available (database=%u, role=%u)",
+				 session->quota_database_oid,
+				 session->quota_role_oid);
+	return NULL;
+}
+
+/*
+ * __gpuQuotaChargeMemory
+ *
+ * It charges (or releases, if negative) the device memory on the quota.
+ * If it exceeds the limit, XPU_QUOTA_ACTION__WAIT waits for the release
+ * by the other queries until the wait_timeout, if 'may_wait'.
+ */
+static bool
+__gpuQuotaChargeMemory(gpuQuotaSlot *quota, int64_t nbytes, bool may_wait)
+{
+	uint64_t	tv_wait = 0;
+
+	if (!quota)
+		return true;
+	if (nbytes <= 0)
+	{
+		pg_atomic_fetch_sub_u64(&quota->memory_usage, -nbytes);
+		return true;
+	}
+	for (;;)
+	{
+		uint64_t	limit = pg_atomic_read_u64(&quota->memory_limit);
+		uint64_t	usage = pg_atomic_read_u64(&quota->memory_usage);
+		uint64_t	peak;
+
+		if (limit == 0 || usage + nbytes <= limit)
+		{
+			if (!pg_atomic_compare_exchange_u64(&quota->memory_usage,
+												&usage, usage + nbytes))
+				continue;
+			peak = pg_atomic_read_u64(&quota->memory_peak);
+			while (peak < usage + nbytes)
+			{
+				if (pg_atomic_compare_exchange_u64(&quota->memory_peak,
+												   &peak, usage + nbytes))
+					break;
+			}
+			return true;
+		}
+		if (!may_wait ||
+			pg_atomic_read_u32(&quota->action) != XPU_QUOTA_ACTION__WAIT ||
+			gpuServiceGoingTerminate())
+			break;
+		if (tv_wait == 0)
+		{
+			tv_wait = __gpuservTimeUsec();
+			pg_atomic_fetch_add_u64(&quota->nr_waits, 1);
+		}
+		else if (__gpuservTimeUsec() - tv_wait >=
+				 1000UL * pg_atomic_read_u32(&quota->wait_timeout))
+			break;
+		pg_usleep(GPUSERV_QUOTA_WAIT_INTERVAL);
+	}
+	return false;
+}
+
+/*
+ * __gpuQuotaTaskIsRunnable
+ *
+ * MEMO: caller must hold the gcontext->lock
+ */
+static inline bool
+__gpuQuotaTaskIsRunnable(gpuQuotaSlot *quota, XpuCommand *xcmd)
+{
+	uint32_t	limit;
+
+	if (!quota || (xcmd->tag != XpuCommandTag__XpuTaskExec &&
+				   xcmd->tag != XpuCommandTag__XpuTaskExecGpuCache))
+		return true;
+	limit = pg_atomic_read_u32(&quota->tasks_limit);
+	return (limit == 0 || pg_atomic_read_u32(&quota->nr_running) < limit);
+}
+
+/*
+ * __gpuQuotaReleaseTask
+ */
+static void
+__gpuQuotaReleaseTask(gpuQuotaSlot *quota)
+{
+	dlist_iter	iter;
+
+	pg_atomic_fetch_sub_u32(&quota->nr_running, 1);
+	/* commands held by the quota may be pending on any devices */
+	dlist_foreach(iter, &gpuserv_gpucontext_list)
+	{
+		gpuContext *gcontext = dlist_container(gpuContext, chain, iter.cur);
+
+		pthreadCondSignal(&gcontext->cond);
+	}
+}
+
 /* ----------------------------------------------------------------
  *
  * Session buffer support routines
@@ -593,16 +1505,110 @@ struct gpuQueryBuffer
 	CUdeviceptr		m_kmrels;		/* GpuJoin inner buffer (device) */
 	void		   *h_kmrels;		/* GpuJoin inner buffer (host) */
 	size_t			kmrels_sz;		/* GpuJoin inner buffer size */
+	volatile int	kmrels_part_id;	/* inner partition currently resident on
+									 * the device, if grace hash-join */
 	CUdeviceptr		m_kds_final;	/* GpuPreAgg final buffer (device) */
 	size_t			m_kds_final_length;	/* length of GpuPreAgg final buffer */
+	uint32_t		m_kds_final_version; /* incremented on expand / flush */
 	pthread_rwlock_t m_kds_final_rwlock;  /* RWLock for the final buffer */
+	struct gpuJoinInnerBuffer *gj_buf; /* shared inner buffer, if cached */
+	gpuQuotaSlot   *quota;			/* GPU quota of the query, if any */
+	size_t			quota_charged;	/* device memory charged on the quota */
 };
 typedef struct gpuQueryBuffer		gpuQueryBuffer;
 
+/*
+ * gpuJoinInnerBuffer
+ *
+ * GpuJoin inner buffer that can be reused by multiple queries. Backend
+ * tells us the signature of the inner buffer (see GpuJoinInnerCacheLookup),
+ * if it is built from the identical inner relations, quals and snapshot.
+ * It is kept on the device memory even if no queries reference it, then
+ * evicted by LRU when total size exceeds gpu_mempool_max_ratio.
+ */
+typedef struct gpuJoinInnerBuffer
+{
+	dlist_node		chain;			/* link to gpu_join_inner_buffer_list */
+	int				refcnt;
+	volatile int	phase;			/* same as gpuQueryBuffer */
+	uint64_t		signature;		/* signature of the inner buffer */
+	uint32_t		kmrels_handle;	/* shmem handle of the inner buffer */
+	int				cuda_dindex;	/* GPU device identifier */
+	CUdeviceptr		m_kmrels;		/* GpuJoin inner buffer (device) */
+	void		   *h_kmrels;		/* GpuJoin inner buffer (host) */
+	size_t			kmrels_sz;		/* GpuJoin inner buffer size */
+	uint64_t		last_used;		/* LRU clock */
+} gpuJoinInnerBuffer;
+
 #define GPU_QUERY_BUFFER_NSLOTS		320
 static dlist_head		gpu_query_buffer_hslot[GPU_QUERY_BUFFER_NSLOTS];
 static pthread_mutex_t	gpu_query_buffer_mutex = PTHREAD_MUTEX_INITIALIZER;
 static pthread_cond_t	gpu_query_buffer_cond = PTHREAD_COND_INITIALIZER;
+static dlist_head		gpu_join_inner_buffer_list;
+static uint64_t			gpu_join_inner_buffer_clock = 0;
+
+static void
+__releaseGpuJoinInnerBuffer(gpuJoinInnerBuffer *gj_buf)
+{
+	CUresult	rc;
+
+	if (gj_buf->m_kmrels)
+	{
+		rc = cuMemFree(gj_buf->m_kmrels);
+		if (rc != CUDA_SUCCESS)
+			GpuServDebug("failed on cuMemFree: %s", cuStrError(rc));
+	}
+	if (gj_buf->h_kmrels)
+	{
+		if (munmap(gj_buf->h_kmrels, gj_buf->kmrels_sz) != 0)
+			GpuServDebug("failed on munmap: %m");
+	}
+	dlist_delete(&gj_buf->chain);
+	free(gj_buf);
+}
+
+/*
+ * __evictGpuJoinInnerBufferNoLock
+ *
+ * It evicts the least recently used inner buffers that are not referenced
+ * by any queries, until the total size of the inner buffers on the current
+ * device gets less than the limit.
+ */
+static void
+__evictGpuJoinInnerBufferNoLock(gpuContext *gcontext)
+{
+	for (;;)
+	{
+		gpuJoinInnerBuffer *victim = NULL;
+		dlist_iter	iter;
+		size_t		total_sz = 0;
+
+		dlist_foreach(iter, &gpu_join_inner_buffer_list)
+		{
+			gpuJoinInnerBuffer *gj_buf = dlist_container(gpuJoinInnerBuffer,
+														 chain, iter.cur);
+			if (gj_buf->cuda_dindex != gcontext->cuda_dindex)
+				continue;
+			total_sz += gj_buf->kmrels_sz;
+			if (gj_buf->refcnt == 0 &&
+				(!victim || victim->last_used > gj_buf->last_used))
+				victim = gj_buf;
+		}
+		if (!victim || total_sz <= gcontext->pool_managed.hard_limit)
+			break;
+		GpuServDebug("GpuJoin inner buffer evicted (handle=%u, sz=%zu)",
+					 victim->kmrels_handle, victim->kmrels_sz);
+		__releaseGpuJoinInnerBuffer(victim);
+	}
+}
+
+static void
+__putGpuJoinInnerBufferNoLock(gpuJoinInnerBuffer *gj_buf)
+{
+	Assert(gj_buf->refcnt > 0);
+	if (--gj_buf->refcnt == 0 && gj_buf->phase < 0)
+		__releaseGpuJoinInnerBuffer(gj_buf);
+}
 
 static void
 __putGpuQueryBufferNoLock(gpuQueryBuffer *gq_buf)
@@ -612,13 +1618,18 @@ __putGpuQueryBufferNoLock(gpuQueryBuffer *gq_buf)
 	{
 		CUresult	rc;
 
-		if (gq_buf->m_kmrels)
+		if (gq_buf->gj_buf)
+		{
+			/* shared inner buffer is kept until LRU eviction */
+			__putGpuJoinInnerBufferNoLock(gq_buf->gj_buf);
+		}
+		else if (gq_buf->m_kmrels)
 		{
 			rc = cuMemFree(gq_buf->m_kmrels);
 			if (rc != CUDA_SUCCESS)
 				GpuServDebug("failed on cuMemFree: %s", cuStrError(rc));
 		}
-		if (gq_buf->h_kmrels)
+		if (gq_buf->h_kmrels && !gq_buf->gj_buf)
 		{
 			if (munmap(gq_buf->h_kmrels,
 					   gq_buf->kmrels_sz) != 0)
@@ -630,6 +1641,8 @@ __putGpuQueryBufferNoLock(gpuQueryBuffer *gq_buf)
 			if (rc != CUDA_SUCCESS)
 				GpuServDebug("failed on cuMemFree: %s", cuStrError(rc));
 		}
+		if (gq_buf->quota_charged > 0)
+			__gpuQuotaChargeMemory(gq_buf->quota, -(int64_t)gq_buf->quota_charged, false);
 		dlist_delete(&gq_buf->chain);
 		free(gq_buf);
 	}
@@ -643,6 +1656,97 @@ putGpuQueryBuffer(gpuQueryBuffer *gq_buf)
 	pthreadMutexUnlock(&gpu_query_buffer_mutex);
 }
 
+/*
+ * __setupGpuQueryJoinHashBucketBuffer
+ *
+ * It builds the hash-bucket of the inner hash table on the device, if
+ * the backend skipped it.
+ */
+static bool
+__setupGpuQueryJoinHashBucketBuffer(gpuContext *gcontext,
+									gpuQueryBuffer *gq_buf,
+									char *errmsg, size_t errmsg_sz)
+{
+	kern_multirels *h_kmrels = gq_buf->h_kmrels;
+	CUfunction	f_prep_hbucket = NULL;
+	CUresult	rc;
+	int			grid_sz;
+	int			block_sz;
+	unsigned int shmem_sz;
+	void	   *kern_args[10];
+	bool		has_hbucket = false;
+
+	for (int depth=1; depth <= h_kmrels->num_rels; depth++)
+	{
+		if (h_kmrels->chunks[depth-1].hbucket_offset == 0 ||
+			!h_kmrels->chunks[depth-1].hbucket_on_device)
+			continue;
+		if (!f_prep_hbucket)
+		{
+			rc = cuModuleGetFunction(&f_prep_hbucket,
+									 gcontext->cuda_module,
+									 "gpujoin_prep_hashbucket");
+			if (rc != CUDA_SUCCESS)
+			{
+				snprintf(errmsg, errmsg_sz,
+						 "failed on cuModuleGetFunction: %s", cuStrError(rc));
+				return false;
+			}
+			rc = gpuOptimalBlockSize(&grid_sz,
+									 &block_sz,
+									 &shmem_sz,
+									 f_prep_hbucket,
+									 0, 0);
+			if (rc != CUDA_SUCCESS)
+			{
+				snprintf(errmsg, errmsg_sz,
+						 "failed on gpuOptimalBlockSize: %s", cuStrError(rc));
+				return false;
+			}
+		}
+		/* count -> prefix sum (by a single block) -> sort */
+		for (int phase=0; phase < 3; phase++)
+		{
+			kern_args[0] = &gq_buf->m_kmrels;
+			kern_args[1] = &depth;
+			kern_args[2] = &phase;
+			rc = cuLaunchKernel(f_prep_hbucket,
+								phase == 1 ? 1 : grid_sz, 1, 1,
+								block_sz, 1, 1,
+								shmem_sz,
+								MY_STREAM_PER_THREAD,
+								kern_args,
+								NULL);
+			if (rc != CUDA_SUCCESS)
+			{
+				snprintf(errmsg, errmsg_sz,
+						 "failed on cuLaunchKernel: %s", cuStrError(rc));
+				return false;
+			}
+		}
+		has_hbucket = true;
+	}
+
+	if (has_hbucket)
+	{
+		rc = cuEventRecord(MY_EVENT_PER_THREAD, MY_STREAM_PER_THREAD);
+		if (rc != CUDA_SUCCESS)
+		{
+			snprintf(errmsg, errmsg_sz,
+					 "failed on cuEventRecord: %s", cuStrError(rc));
+			return false;
+		}
+		rc = cuEventSynchronize(MY_EVENT_PER_THREAD);
+		if (rc != CUDA_SUCCESS)
+		{
+			snprintf(errmsg, errmsg_sz,
+					 "failed on cuEventSynchronize: %s", cuStrError(rc));
+			return false;
+		}
+	}
+	return true;
+}
+
 static bool
 __setupGpuQueryJoinGiSTIndexBuffer(gpuContext *gcontext,
 								   gpuQueryBuffer *gq_buf,
@@ -722,6 +1826,68 @@ __setupGpuQueryJoinGiSTIndexBuffer(gpuContext *gcontext,
 	return true;
 }
 
+/*
+ * Grace hash-join support
+ */
+static bool
+__kmrelsHasInnerPartitions(const kern_multirels *h_kmrels)
+{
+	for (int i=0; i < h_kmrels->num_rels; i++)
+	{
+		if (h_kmrels->chunks[i].num_parts > 1)
+			return true;
+	}
+	return false;
+}
+
+static void
+__prefetchGpuQueryJoinInnerPartition(gpuQueryBuffer *gq_buf,
+									 uint32_t part_id,
+									 CUdevice dst_device)
+{
+	kern_multirels *h_kmrels = gq_buf->h_kmrels;
+
+	for (int i=0; i < h_kmrels->num_rels; i++)
+	{
+		kern_data_store *kds;
+		size_t		offset;
+
+		if (h_kmrels->chunks[i].num_parts <= 1 ||
+			part_id >= h_kmrels->chunks[i].num_parts)
+			continue;
+		kds = KERN_MULTIRELS_INNER_PART_KDS(h_kmrels, i, part_id);
+		offset = ((char *)kds - (char *)h_kmrels);
+		(void)cuMemPrefetchAsync(gq_buf->m_kmrels + offset,
+								 kds->length,
+								 dst_device,
+								 MY_STREAM_PER_THREAD);
+	}
+}
+
+/*
+ * __switchGpuQueryJoinInnerPartition
+ *
+ * It makes the inner partition 'part_id' resident on the device, and
+ * evicts the one used in the previous round. Backends never mix tasks
+ * for different partitions (see pgstromTaskStateNextInnerPart), so we
+ * don't need exact synchronization here; concurrent prefetch on the
+ * same partition is harmless.
+ */
+static void
+__switchGpuQueryJoinInnerPartition(gpuQueryBuffer *gq_buf, uint32_t part_id)
+{
+	int		prev_id = __atomic_exchange_n(&gq_buf->kmrels_part_id,
+										  (int)part_id,
+										  __ATOMIC_SEQ_CST);
+	if (prev_id == (int)part_id)
+		return;
+	if (prev_id >= 0)
+		__prefetchGpuQueryJoinInnerPartition(gq_buf, prev_id, CU_DEVICE_CPU);
+	__prefetchGpuQueryJoinInnerPartition(gq_buf, part_id, MY_DEVICE_PER_THREAD);
+	GpuServDebug("GpuJoin inner partition switched %d -> %u (buffer-id=%lu)",
+				 prev_id, part_id, gq_buf->buffer_id);
+}
+
 static bool
 __setupGpuQueryJoinInnerBuffer(gpuContext *gcontext,
 							   gpuQueryBuffer *gq_buf,
@@ -733,20 +1899,18 @@ __setupGpuQueryJoinInnerBuffer(gpuContext *gcontext,
 	CUresult	rc;
 	int			fdesc;
 	struct stat	stat_buf;
-	char		namebuf[100];
+	char		namebuf[MAXPGPATH];
 	size_t		mmap_sz;
 
 	if (kmrels_handle == 0)
 		return true;
 
-	snprintf(namebuf, sizeof(namebuf),
-			 ".pgstrom_shmbuf_%u_%d",
-			 PostPortNumber, kmrels_handle);
-	fdesc = shm_open(namebuf, O_RDWR, 0600);
+	__shmemPathName(namebuf, sizeof(namebuf), kmrels_handle, NULL);
+	fdesc = open(namebuf, O_RDWR, 0600);
 	if (fdesc < 0)
 	{
 		snprintf(errmsg, errmsg_sz,
-				 "failed on shm_open('%s'): %m", namebuf);
+				 "failed on open('%s'): %m", namebuf);
 		return false;
 	}
 	if (fstat(fdesc, &stat_buf) != 0)
@@ -769,6 +1933,7 @@ __setupGpuQueryJoinInnerBuffer(gpuContext *gcontext,
 				 "failed on mmap('%s', %zu): %m", namebuf, mmap_sz);
 		return false;
 	}
+	__shmemAdviseHugePages(h_kmrels, mmap_sz);
 
 	rc = cuMemAllocManaged(&m_kmrels, mmap_sz,
 						   CU_MEM_ATTACH_GLOBAL);
@@ -780,15 +1945,34 @@ __setupGpuQueryJoinInnerBuffer(gpuContext *gcontext,
 		return false;
 	}
 	memcpy((void *)m_kmrels, h_kmrels, mmap_sz);
-	(void)cuMemPrefetchAsync(m_kmrels, mmap_sz,
-							 MY_DEVICE_PER_THREAD,
-							 MY_STREAM_PER_THREAD);
 	gq_buf->m_kmrels = m_kmrels;
 	gq_buf->h_kmrels = h_kmrels;
 	gq_buf->kmrels_sz = mmap_sz;
+	gq_buf->kmrels_part_id = -1;
+	if (!__kmrelsHasInnerPartitions(h_kmrels))
+	{
+		(void)cuMemPrefetchAsync(m_kmrels, mmap_sz,
+								 MY_DEVICE_PER_THREAD,
+								 MY_STREAM_PER_THREAD);
+	}
+	else
+	{
+		/*
+		 * In case of grace hash-join, the entire inner buffer is not
+		 * expected to fit the device memory. So, we prefer the host
+		 * memory for the buffer, then individual partition shall be
+		 * prefetched on demand.
+		 */
+		(void)cuMemAdvise(m_kmrels, mmap_sz,
+						  CU_MEM_ADVISE_SET_PREFERRED_LOCATION,
+						  CU_DEVICE_CPU);
+		__switchGpuQueryJoinInnerPartition(gq_buf, 0);
+	}
 
-	/* preparation of GiST-index buffer, if any */
-	if (!__setupGpuQueryJoinGiSTIndexBuffer(gcontext, gq_buf,
+	/* preparation of hash-bucket and GiST-index buffer, if any */
+	if (!__setupGpuQueryJoinHashBucketBuffer(gcontext, gq_buf,
+											 errmsg, errmsg_sz) ||
+		!__setupGpuQueryJoinGiSTIndexBuffer(gcontext, gq_buf,
 											errmsg, errmsg_sz))
 	{
 		cuMemFree(m_kmrels);
@@ -798,29 +1982,19 @@ __setupGpuQueryJoinInnerBuffer(gpuContext *gcontext,
 	return true;
 }
 
-static bool
-__setupGpuQueryGroupByBuffer(gpuContext *gcontext,
-							 gpuQueryBuffer *gq_buf,
-							 kern_data_store *kds_final_head,
-							 char *errmsg, size_t errmsg_sz)
+static CUresult
+__allocGpuQueryGroupByBuffer(kern_data_store *kds_final_head,
+							 CUdeviceptr *p_kds_final)
 {
 	CUdeviceptr	m_kds_final;
 	CUresult	rc;
 
-	if (!kds_final_head)
-		return true;	/* nothing to do */
-
 	Assert(KDS_HEAD_LENGTH(kds_final_head) <= kds_final_head->length);
 	rc =  cuMemAllocManaged(&m_kds_final,
 							kds_final_head->length,
 							CU_MEM_ATTACH_GLOBAL);
 	if (rc != CUDA_SUCCESS)
-	{
-		snprintf(errmsg, errmsg_sz,
-				 "failed on cuMemAllocManaged(%zu): %s",
-				 kds_final_head->length, cuStrError(rc));
-		return false;
-	}
+		return rc;
 	memcpy((void *)m_kds_final,
 		   kds_final_head,
 		   KDS_HEAD_LENGTH(kds_final_head));
@@ -828,39 +2002,128 @@ __setupGpuQueryGroupByBuffer(gpuContext *gcontext,
 							 KDS_HEAD_LENGTH(kds_final_head),
 							 MY_DEVICE_PER_THREAD,
 							 MY_STREAM_PER_THREAD);
-	gq_buf->m_kds_final = m_kds_final;
-	gq_buf->m_kds_final_length = kds_final_head->length;
-	pthreadRWLockInit(&gq_buf->m_kds_final_rwlock);
+	*p_kds_final = m_kds_final;
+	return CUDA_SUCCESS;
+}
+
+static bool
+__setupGpuQueryGroupByBuffer(gpuContext *gcontext,
+							 gpuQueryBuffer *gq_buf,
+							 kern_data_store *kds_final_head,
+							 char *errmsg, size_t errmsg_sz)
+{
+	CUdeviceptr	m_kds_final;
+	CUresult	rc;
+
+	if (!kds_final_head)
+		return true;	/* nothing to do */
+
+	rc = __allocGpuQueryGroupByBuffer(kds_final_head, &m_kds_final);
+	if (rc != CUDA_SUCCESS)
+	{
+		snprintf(errmsg, errmsg_sz,
+				 "failed on cuMemAllocManaged(%zu): %s",
+				 kds_final_head->length, cuStrError(rc));
+		return false;
+	}
+	gq_buf->m_kds_final = m_kds_final;
+	gq_buf->m_kds_final_length = kds_final_head->length;
+	gq_buf->m_kds_final_version = 0;
+	pthreadRWLockInit(&gq_buf->m_kds_final_rwlock);
 
 	return true;
 }
 
 /*
  * __expandGpuQueryGroupByBuffer
+ *
+ * If the expanded buffer would exceed the session's limit, the partially
+ * aggregated groups are flushed instead. The current kds_final is detached
+ * and returned to the caller (*p_kds_flush), to be written back to the
+ * backend with the task results, then a new empty kds_final replaces it.
+ * The final Agg node on the host merges the partial groups later.
+ * It is also flushed if the expansion exceeds the GPU memory quota with
+ * XPU_QUOTA_ACTION__FALLBACK; elsewhere, *p_over_quota is set on error.
  */
 static bool
 __expandGpuQueryGroupByBuffer(gpuQueryBuffer *gq_buf,
-							  size_t kds_length_last)
+							  kern_session_info *session,
+							  uint32_t kds_version_last,
+							  kern_data_store **p_kds_flush,
+							  bool *p_over_quota)
 {
-	assert(kds_length_last != 0);	/* must be 2nd or later trial */
 	pthreadRWLockWriteLock(&gq_buf->m_kds_final_rwlock);
-	if (gq_buf->m_kds_final_length == kds_length_last)
+	if (gq_buf->m_kds_final_version == kds_version_last)
 	{
 		kern_data_store *kds_old = (kern_data_store *)gq_buf->m_kds_final;
 		kern_data_store *kds_new;
 		CUdeviceptr		m_devptr;
 		CUresult		rc;
 		size_t			sz, length;
+		bool			can_flush;
+		bool			do_flush;
 
 		assert(kds_old->length == gq_buf->m_kds_final_length);
 		length = kds_old->length + Min(kds_old->length, 1UL<<30);
+		can_flush = (session->groupby_kds_final_limit > 0 &&
+					 kds_old->format == KDS_FORMAT_HASH);
+		do_flush = (can_flush && length > session->groupby_kds_final_limit);
+		if (!do_flush && gq_buf->quota &&
+			!__gpuQuotaChargeMemory(gq_buf->quota,
+									length - kds_old->length, true))
+		{
+			if (!can_flush ||
+				pg_atomic_read_u32(&gq_buf->quota->action) != XPU_QUOTA_ACTION__FALLBACK)
+			{
+				pg_atomic_fetch_add_u64(&gq_buf->quota->nr_errors, 1);
+				pthreadRWLockUnlock(&gq_buf->m_kds_final_rwlock);
+				*p_over_quota = true;
+				return false;
+			}
+			pg_atomic_fetch_add_u64(&gq_buf->quota->nr_fallbacks, 1);
+			do_flush = true;
+		}
+
+		if (do_flush)
+		{
+			kern_data_store *kds_head = (kern_data_store *)
+				((char *)session + session->groupby_kds_final);
+
+			rc = __allocGpuQueryGroupByBuffer(kds_head, &m_devptr);
+			if (rc != CUDA_SUCCESS)
+			{
+				pthreadRWLockUnlock(&gq_buf->m_kds_final_rwlock);
+				return false;
+			}
+			GpuServDebug("kds_final flush: nitems=%u, length=%lu\n",
+						 kds_old->nitems, kds_old->length);
+			/* flushed buffer never shorter than the initial one */
+			if (gq_buf->quota)
+			{
+				sz = kds_old->length - kds_head->length;
+				__gpuQuotaChargeMemory(gq_buf->quota, -(int64_t)sz, false);
+				gq_buf->quota_charged -= sz;
+			}
+			*p_kds_flush = kds_old;
+			gq_buf->m_kds_final = m_devptr;
+			gq_buf->m_kds_final_length = kds_head->length;
+			gq_buf->m_kds_final_version++;
+			pthreadRWLockUnlock(&gq_buf->m_kds_final_rwlock);
+			return true;
+		}
 		rc = cuMemAllocManaged(&m_devptr, length,
 							   CU_MEM_ATTACH_GLOBAL);
 		if (rc != CUDA_SUCCESS)
 		{
+			if (gq_buf->quota)
+				__gpuQuotaChargeMemory(gq_buf->quota,
+									   -(int64_t)(length - kds_old->length),
+									   false);
 			pthreadRWLockUnlock(&gq_buf->m_kds_final_rwlock);
 			return false;
 		}
+		if (gq_buf->quota)
+			gq_buf->quota_charged += (length - kds_old->length);
 		kds_new = (kern_data_store *)m_devptr;
 
 		/* early half */
@@ -881,17 +2144,142 @@ __expandGpuQueryGroupByBuffer(gpuQueryBuffer *gq_buf,
 		cuMemFree(gq_buf->m_kds_final);
 		gq_buf->m_kds_final = m_devptr;
 		gq_buf->m_kds_final_length = length;
+		gq_buf->m_kds_final_version++;
 	}
 	pthreadRWLockUnlock(&gq_buf->m_kds_final_rwlock);
 
 	return true;
 }
 
+/*
+ * __setupGpuQueryJoinInnerBufferCached
+ *
+ * It looks up the shared inner buffer by the signature, or builds a new one
+ * then attaches it on the gq_buf.
+ */
+static bool
+__setupGpuQueryJoinInnerBufferCached(gpuContext *gcontext,
+									 gpuQueryBuffer *gq_buf,
+									 uint32_t kmrels_handle,
+									 uint64_t signature,
+									 char *errmsg, size_t errmsg_sz)
+{
+	gpuJoinInnerBuffer *gj_buf;
+	gpuQueryBuffer	temp;
+	dlist_iter		iter;
+
+	pthreadMutexLock(&gpu_query_buffer_mutex);
+	dlist_foreach(iter, &gpu_join_inner_buffer_list)
+	{
+		gj_buf = dlist_container(gpuJoinInnerBuffer, chain, iter.cur);
+		if (gj_buf->signature     == signature &&
+			gj_buf->kmrels_handle == kmrels_handle &&
+			gj_buf->cuda_dindex   == MY_DINDEX_PER_THREAD &&
+			gj_buf->phase >= 0)
+		{
+			gj_buf->refcnt++;
+			/* wait for initial setup by other thread */
+			while (gj_buf->phase == 0)
+			{
+				pthreadCondWait(&gpu_query_buffer_cond,
+								&gpu_query_buffer_mutex);
+			}
+			if (gj_buf->phase < 0)
+			{
+				__putGpuJoinInnerBufferNoLock(gj_buf);
+				pthreadMutexUnlock(&gpu_query_buffer_mutex);
+				snprintf(errmsg, errmsg_sz,
+						 "unable to setup the shared GpuJoin inner buffer");
+				return false;
+			}
+			gj_buf->last_used = ++gpu_join_inner_buffer_clock;
+			pthreadMutexUnlock(&gpu_query_buffer_mutex);
+			goto found;
+		}
+	}
+	/* not found, so create a new one */
+	gj_buf = calloc(1, sizeof(gpuJoinInnerBuffer));
+	if (!gj_buf)
+	{
+		pthreadMutexUnlock(&gpu_query_buffer_mutex);
+		snprintf(errmsg, errmsg_sz, "out of memory");
+		return false;
+	}
+	gj_buf->refcnt = 1;
+	gj_buf->phase = 0;
+	gj_buf->signature = signature;
+	gj_buf->kmrels_handle = kmrels_handle;
+	gj_buf->cuda_dindex = MY_DINDEX_PER_THREAD;
+	gj_buf->last_used = ++gpu_join_inner_buffer_clock;
+	dlist_push_tail(&gpu_join_inner_buffer_list, &gj_buf->chain);
+	pthreadMutexUnlock(&gpu_query_buffer_mutex);
+
+	memset(&temp, 0, sizeof(gpuQueryBuffer));
+	temp.buffer_id = gq_buf->buffer_id;
+	temp.cuda_dindex = gq_buf->cuda_dindex;
+	if (!__setupGpuQueryJoinInnerBuffer(gcontext, &temp, kmrels_handle,
+										errmsg, errmsg_sz))
+	{
+		pthreadMutexLock(&gpu_query_buffer_mutex);
+		gj_buf->phase = -1;
+		__putGpuJoinInnerBufferNoLock(gj_buf);
+		pthreadCondBroadcast(&gpu_query_buffer_cond);
+		pthreadMutexUnlock(&gpu_query_buffer_mutex);
+		return false;
+	}
+	pthreadMutexLock(&gpu_query_buffer_mutex);
+	gj_buf->m_kmrels = temp.m_kmrels;
+	gj_buf->h_kmrels = temp.h_kmrels;
+	gj_buf->kmrels_sz = temp.kmrels_sz;
+	gj_buf->phase = 1;		/* buffer is now ready */
+	__evictGpuJoinInnerBufferNoLock(gcontext);
+	pthreadCondBroadcast(&gpu_query_buffer_cond);
+	pthreadMutexUnlock(&gpu_query_buffer_mutex);
+found:
+	gq_buf->gj_buf = gj_buf;
+	gq_buf->m_kmrels = gj_buf->m_kmrels;
+	gq_buf->h_kmrels = gj_buf->h_kmrels;
+	gq_buf->kmrels_sz = gj_buf->kmrels_sz;
+	gq_buf->kmrels_part_id = -1;
+	return true;
+}
+
+/*
+ * __chargeGpuQueryBufferQuota
+ */
+static bool
+__chargeGpuQueryBufferQuota(gpuQueryBuffer *gq_buf,
+							gpuQuotaSlot *quota,
+							char *errmsg, size_t errmsg_sz)
+{
+	size_t		sz = gq_buf->m_kds_final_length;
+
+	if (!quota)
+		return true;
+	if (gq_buf->m_kmrels)
+		sz += gq_buf->kmrels_sz;
+	if (!__gpuQuotaChargeMemory(quota, sz, true))
+	{
+		pg_atomic_fetch_add_u64(&quota->nr_errors, 1);
+		snprintf(errmsg, errmsg_sz,
+				 "GPU memory quota exceeded (required=%zu, usage=%lu, limit=%lu)",
+				 sz,
+				 pg_atomic_read_u64(&quota->memory_usage),
+				 pg_atomic_read_u64(&quota->memory_limit));
+		return false;
+	}
+	gq_buf->quota = quota;
+	gq_buf->quota_charged = sz;
+	return true;
+}
+
 static gpuQueryBuffer *
 getGpuQueryBuffer(gpuContext *gcontext,
 				  uint64_t buffer_id,
 				  uint32_t kmrels_handle,
+				  uint64_t kmrels_signature,
 				  kern_data_store *kds_final_head,
+				  gpuQuotaSlot *quota,
 				  char *errmsg, size_t errmsg_sz)
 {
 	gpuQueryBuffer *gq_buf;
@@ -949,13 +2337,20 @@ getGpuQueryBuffer(gpuContext *gcontext,
 	pthreadMutexUnlock(&gpu_query_buffer_mutex);
 
 	if ((kmrels_handle == 0 ||
-		 __setupGpuQueryJoinInnerBuffer(gcontext,
-										gq_buf, kmrels_handle,
-										errmsg, errmsg_sz)) &&
+		 (kmrels_signature != 0
+		  ? __setupGpuQueryJoinInnerBufferCached(gcontext,
+												 gq_buf, kmrels_handle,
+												 kmrels_signature,
+												 errmsg, errmsg_sz)
+		  : __setupGpuQueryJoinInnerBuffer(gcontext,
+										   gq_buf, kmrels_handle,
+										   errmsg, errmsg_sz))) &&
 		(kds_final_head == NULL ||
 		 __setupGpuQueryGroupByBuffer(gcontext,
 									  gq_buf, kds_final_head,
-									  errmsg, errmsg_sz)))
+									  errmsg, errmsg_sz)) &&
+		__chargeGpuQueryBufferQuota(gq_buf, quota,
+									errmsg, errmsg_sz))
 	{
 		/* ok, buffer is now ready */
 		pthreadMutexLock(&gpu_query_buffer_mutex);
@@ -982,6 +2377,39 @@ gpuServiceGoingTerminate(void)
 	return (gpuserv_bgworker_got_signal != 0);
 }
 
+/*
+ * gpuServDeviceLoadScore
+ *
+ * It returns the load score of the device, to choose the device for a new
+ * session. The number of commands is sampled periodically, so we also
+ * count the sessions being connected right now, for the concurrent backends
+ * not to rush into the same idle device. The device memory pressure is
+ * added on, because a device close to the hard limit shall suspend and
+ * resume kernels more frequently.
+ */
+double
+gpuServDeviceLoadScore(int cuda_dindex)
+{
+	gpuServDeviceStats *stats;
+	uint64_t	mpool_active;
+	uint64_t	mpool_limit;
+	double		score;
+
+	if (!gpuserv_shared_state ||
+		cuda_dindex < 0 || cuda_dindex >= numGpuDevAttrs)
+		return 0.0;
+	stats = GPUSERV_DEVICE_STATS(cuda_dindex);
+	score = ((double)(pg_atomic_read_u32(&stats->nr_queued) +
+					  pg_atomic_read_u32(&stats->nr_running) +
+					  pg_atomic_read_u32(&stats->nr_sessions)) /
+			 (double)Max(pgstrom_max_async_gpu_tasks, 1));
+	mpool_active = pg_atomic_read_u64(&stats->mpool_raw_active);
+	mpool_limit  = pg_atomic_read_u64(&stats->mpool_raw_limit);
+	if (mpool_limit > 0)
+		score += (double)mpool_active / (double)mpool_limit;
+	return score;
+}
+
 /* ----------------------------------------------------------------
  *
  * gpuservMonitorClient
@@ -991,32 +2419,263 @@ gpuServiceGoingTerminate(void)
 typedef struct
 {
 	gpuMemChunk	   *chunk;
+	/* KDS already loaded by the arrow read-ahead, if any */
+	gpuContext	   *ra_gcontext;
+	gpuMemChunk	   *ra_chunk;
+	size_t			ra_length;
+	int				ra_status;	/* 0: not loaded, 1: loaded, -1: failed */
+	uint32_t		ra_npages_direct_read;
+	uint32_t		ra_npages_vfs_read;
+	gpuDirectIOCounter ra_io_counter;
 	XpuCommand		xcmd;
 } gpuServXpuCommandPacked;
 
 static void *
 __gpuServiceAllocCommand(void *__priv, size_t sz)
 {
+	gpuClient	   *gclient = (gpuClient *)__priv;
 	gpuMemChunk	   *chunk;
 	gpuServXpuCommandPacked *packed;
 
+	/* the remote host shall not consume the managed memory unlimitedly */
+	if (gclient->is_remote && sz > GPUSERV_REMOTE_COMMAND_MAXSZ)
+	{
+		fprintf(stderr, "gpuserv: too large command (sz=%zu) from the remote host\n", sz);
+		return NULL;
+	}
 	chunk = gpuMemAllocManaged(offsetof(gpuServXpuCommandPacked, xcmd) + sz);
 	if (!chunk)
 		return NULL;
 	packed = (gpuServXpuCommandPacked *)chunk->m_devptr;
 	packed->chunk = chunk;
+	packed->ra_gcontext = NULL;
+	packed->ra_chunk = NULL;
+	packed->ra_status = 0;
 	return &packed->xcmd;
 }
 
+static void
+__gpuServiceFreeCommand(XpuCommand *xcmd);
+static void
+gpuservHandleCloseSession(gpuClient *gclient);
+static void
+__gpuClientWriteBack(gpuClient *gclient, struct iovec *iov, int iovcnt);
+static bool
+__gpuServiceValidateRemoteCommand(gpuClient *gclient, XpuCommand *xcmd);
+
+/*
+ * __gpuClientMapRingSegment
+ */
+static void *
+__gpuClientMapRingSegment(const char *namebuf, size_t *p_mmap_sz)
+{
+	struct stat	stat_buf;
+	void	   *addr;
+	int			fdesc;
+
+	fdesc = shm_open(namebuf, O_RDWR, 0600);
+	if (fdesc < 0)
+	{
+		GpuServDebug("failed on shm_open('%s'): %m", namebuf);
+		return NULL;
+	}
+	if (fstat(fdesc, &stat_buf) != 0)
+	{
+		GpuServDebug("failed on fstat('%s'): %m", namebuf);
+		close(fdesc);
+		return NULL;
+	}
+	addr = mmap(NULL, stat_buf.st_size,
+				PROT_READ | PROT_WRITE,
+				MAP_SHARED,
+				fdesc, 0);
+	close(fdesc);
+	if (addr == MAP_FAILED)
+	{
+		GpuServDebug("failed on mmap('%s', %zu): %m",
+					 namebuf, (size_t)stat_buf.st_size);
+		return NULL;
+	}
+	__shmemAdviseHugePages(addr, stat_buf.st_size);
+	*p_mmap_sz = stat_buf.st_size;
+	return addr;
+}
+
+/*
+ * __gpuClientMapCommandRing
+ *
+ * It maps the command ring buffer of the client. It is called by the monitor
+ * thread on OpenSession, prior to the response, so the client never writes
+ * the ring buffer before the mapping.
+ */
+static void
+__gpuClientMapCommandRing(gpuClient *gclient, uint32_t handle)
+{
+	xpuCommandRing *ring;
+	size_t		mmap_sz;
+	char		namebuf[100];
+
+	XPU_COMMAND_RING_NAME(namebuf, handle);
+	ring = __gpuClientMapRingSegment(namebuf, &mmap_sz);
+	if (!ring)
+		return;
+	if (offsetof(xpuCommandRing, data[ring->nbytes]) > mmap_sz)
+	{
+		GpuServDebug("command ring buffer '%s' is corrupted", namebuf);
+		munmap(ring, mmap_sz);
+		return;
+	}
+	gclient->cmd_ring = ring;
+	gclient->cmd_ring_sz = mmap_sz;
+}
+
+/*
+ * __gpuClientMapResultRing
+ *
+ * It maps the result ring buffer of the client, and registers it as
+ * page-locked memory, to write back the results by DMA.
+ */
+static void
+__gpuClientMapResultRing(gpuClient *gclient, uint32_t handle)
+{
+	xpuResultRing *ring;
+	size_t		mmap_sz;
+	char		namebuf[100];
+	CUresult	rc;
+
+	XPU_RESULT_RING_NAME(namebuf, handle);
+	ring = __gpuClientMapRingSegment(namebuf, &mmap_sz);
+	if (!ring)
+		return;
+	if (offsetof(xpuResultRing, data[ring->nbytes]) > mmap_sz ||
+		ring->nbytes % XPU_RESULT_RING_ALIGN != 0)
+	{
+		GpuServDebug("result ring buffer '%s' is corrupted", namebuf);
+		munmap(ring, mmap_sz);
+		return;
+	}
+	rc = cuMemHostRegister(ring, mmap_sz, CU_MEMHOSTREGISTER_PORTABLE);
+	if (rc == CUDA_SUCCESS)
+		gclient->resp_ring_registered = true;
+	else
+		GpuServDebug("failed on cuMemHostRegister('%s', %zu): %s",
+					 namebuf, mmap_sz, cuStrError(rc));
+	gclient->resp_ring = ring;
+	gclient->resp_ring_sz = mmap_sz;
+}
+
+/*
+ * __gpuServiceReadAheadIsApplicable
+ *
+ * GpuTask on the arrow file is pulled out to the read-ahead threads, prior
+ * to the execution by the workers; see gpuservArrowReadAheadMain.
+ */
+static bool
+__gpuServiceReadAheadIsApplicable(gpuClient *gclient, XpuCommand *xcmd)
+{
+	kern_data_store *kds;
+	strom_io_vector *iovec;
+	const char *pathname;
+
+	if (pgstrom_arrow_readahead_threads == 0 ||
+		xcmd->tag != XpuCommandTag__XpuTaskExec ||
+		xcmd->u.task.kds_src_offset == 0 ||
+		xcmd->u.task.kds_src_pathname == 0 ||
+		xcmd->u.task.kds_src_iovec == 0)
+		return false;
+	kds = (kern_data_store *)((char *)xcmd + xcmd->u.task.kds_src_offset);
+	iovec = (strom_io_vector *)((char *)xcmd + xcmd->u.task.kds_src_iovec);
+	pathname = (char *)xcmd + xcmd->u.task.kds_src_pathname;
+	if (kds->format != KDS_FORMAT_ARROW || iovec->nr_chunks == 0)
+		return false;
+	/* remote hosts never read the local files by relative path */
+	if (gclient->is_remote && pathname[0] != '/')
+		return false;
+	return true;
+}
+
 static void
 __gpuServiceAttachCommand(void *__priv, XpuCommand *xcmd)
 {
 	gpuClient  *gclient = (gpuClient *)__priv;
 	gpuContext *gcontext = gclient->gcontext;
 
+	/* commands from the remote hosts are validated prior to any references */
+	if (gclient->is_remote &&
+		!__gpuServiceValidateRemoteCommand(gclient, xcmd))
+	{
+		__gpuServiceFreeCommand(xcmd);
+		return;
+	}
+	if (xcmd->tag == XpuCommandTag__RingDoorbell)
+	{
+		/* just a wakeup; ring buffer shall be checked by the caller */
+		__gpuServiceFreeCommand(xcmd);
+		return;
+	}
+	if (xcmd->tag == XpuCommandTag__CloseSession)
+	{
+		/* reset the session, but keep the connection for the next query */
+		__gpuServiceFreeCommand(xcmd);
+		gpuservHandleCloseSession(gclient);
+		return;
+	}
+	if (xcmd->tag == XpuCommandTag__AttachInnerBuffer)
+	{
+		/*
+		 * It is handled here, not by the workers, because the workers
+		 * may be all waiting for this attachment with the outer chunks.
+		 */
+		pthreadMutexLock(&gpu_query_buffer_mutex);
+		gclient->gq_buf_attached = true;
+		gclient->gq_buf_kmrels_handle = xcmd->u.inner.join_inner_handle;
+		gclient->gq_buf_kmrels_signature = xcmd->u.inner.join_inner_signature;
+		pthreadCondBroadcast(&gpu_query_buffer_cond);
+		pthreadMutexUnlock(&gpu_query_buffer_mutex);
+		__gpuServiceFreeCommand(xcmd);
+		return;
+	}
+	if (xcmd->tag == XpuCommandTag__DeviceAttrs)
+	{
+		struct iovec	iov;
+
+		/*
+		 * The remote host asks the device attributes on its startup. They
+		 * are sent back as is, then EOF; see receiveRemoteGpuDevAttrs.
+		 */
+		__gpuServiceFreeCommand(xcmd);
+		iov.iov_base = gpuDevAttrs;
+		iov.iov_len  = sizeof(GpuDevAttributes) * numGpuDevAttrs;
+		__gpuClientWriteBack(gclient, &iov, 1);
+		pthreadMutexLock(&gclient->mutex);
+		if (gclient->sockfd >= 0)
+			shutdown(gclient->sockfd, SHUT_WR);
+		pthreadMutexUnlock(&gclient->mutex);
+		return;
+	}
+	/* ring buffers are not visible to the remote hosts */
+	if (xcmd->tag == XpuCommandTag__OpenSession &&
+		!gclient->is_remote &&
+		xcmd->u.session.xcmd_ring_handle != 0 &&
+		!gclient->cmd_ring)
+		__gpuClientMapCommandRing(gclient, xcmd->u.session.xcmd_ring_handle);
+	if (xcmd->tag == XpuCommandTag__OpenSession &&
+		!gclient->is_remote &&
+		xcmd->u.session.xresp_ring_handle != 0 &&
+		!gclient->resp_ring)
+		__gpuClientMapResultRing(gclient, xcmd->u.session.xresp_ring_handle);
+
 	pg_atomic_fetch_add_u32(&gclient->refcnt, 2);
 	xcmd->priv = gclient;
 
+	if (__gpuServiceReadAheadIsApplicable(gclient, xcmd))
+	{
+		pthreadMutexLock(&gcontext->lock);
+		dlist_push_tail(&gcontext->ra_command_list, &xcmd->chain);
+		pthreadMutexUnlock(&gcontext->lock);
+		pthreadCondSignal(&gcontext->ra_cond);
+		return;
+	}
 	pthreadMutexLock(&gcontext->lock);
 	dlist_push_tail(&gcontext->command_list, &xcmd->chain);
 	pthreadMutexUnlock(&gcontext->lock);
@@ -1028,10 +2687,101 @@ __gpuServiceFreeCommand(XpuCommand *xcmd)
 {
 	gpuServXpuCommandPacked *packed = (gpuServXpuCommandPacked *)
 		((char *)xcmd - offsetof(gpuServXpuCommandPacked, xcmd));
+
+	if (packed->ra_chunk)
+	{
+		/* staged by the read-ahead, but not consumed by the task */
+		gpuContext *gcontext = packed->ra_gcontext;
+
+		gpuMemFree(packed->ra_chunk);
+		pthreadMutexLock(&gcontext->lock);
+		Assert(gcontext->ra_staged_bytes >= packed->ra_length);
+		gcontext->ra_staged_bytes -= packed->ra_length;
+		pthreadMutexUnlock(&gcontext->lock);
+		pthreadCondSignal(&gcontext->ra_cond);
+	}
 	gpuMemFree(packed->chunk);
 }
 TEMPLATE_XPU_CONNECT_RECEIVE_COMMANDS(__gpuService)
 
+/*
+ * __gpuServiceReceiveRingCommands
+ *
+ * It fetches all the commands on the command ring buffer. When the ring
+ * gets empty, it sets consumer_waiting to ask the producer to ring the
+ * doorbell on the socket, then returns 0; caller can sleep on poll(2).
+ * It returns -1 on errors.
+ */
+static int
+__gpuServiceReceiveRingCommands(gpuClient *gclient, const char *elabel)
+{
+	xpuCommandRing *ring = gclient->cmd_ring;
+	uint64_t	head;
+	uint64_t	tail;
+
+	for (;;)
+	{
+		tail = pg_atomic_read_u64(&ring->tail);
+		head = pg_atomic_read_u64(&ring->head);
+		if (head == tail)
+		{
+			pg_atomic_write_u32(&ring->consumer_waiting, 1);
+			pg_memory_barrier();
+			if (pg_atomic_read_u64(&ring->head) == tail)
+				return 0;		/* ok, we can sleep */
+			pg_atomic_write_u32(&ring->consumer_waiting, 0);
+			continue;
+		}
+		pg_read_barrier();
+		while (tail < head)
+		{
+			XpuCommand	temp;
+			XpuCommand *xcmd;
+
+			if (head - tail < offsetof(XpuCommand, u))
+			{
+				GpuServDebug("[%s] command ring buffer is corrupted", elabel);
+				return -1;
+			}
+			__xpuCommandRingCopy(ring, tail, (char *)&temp, NULL,
+								 offsetof(XpuCommand, u), false);
+			if (temp.magic != XpuCommandMagicNumber ||
+				temp.length < offsetof(XpuCommand, u) ||
+				temp.length > head - tail)
+			{
+				GpuServDebug("[%s] command ring buffer is corrupted", elabel);
+				return -1;
+			}
+			xcmd = __gpuServiceAllocCommand(gclient, temp.length);
+			if (!xcmd)
+			{
+				GpuServDebug("[%s] out of memory (sz=%lu)", elabel, temp.length);
+				return -1;
+			}
+			__xpuCommandRingCopy(ring, tail, (char *)xcmd, NULL,
+								 temp.length, false);
+			tail += temp.length;
+			pg_memory_barrier();
+			pg_atomic_write_u64(&ring->tail, tail);
+			__gpuServiceAttachCommand(gclient, xcmd);
+		}
+	}
+}
+
+/*
+ * __gpuservFreeTaskGraph
+ */
+static void
+__gpuservFreeTaskGraph(gpuTaskGraph *tgraph)
+{
+	/* in-flight graph is released asynchronously on completion */
+	if (tgraph->graph_exec)
+		cuGraphExecDestroy(tgraph->graph_exec);
+	if (tgraph->graph)
+		cuGraphDestroy(tgraph->graph);
+	free(tgraph);
+}
+
 /*
  * gpuClientPut
  */
@@ -1048,11 +2798,30 @@ gpuClientPut(gpuClient *gclient, bool exit_monitor_thread)
 		pthreadMutexLock(&gcontext->client_lock);
 		dlist_delete(&gclient->chain);
 		pthreadMutexUnlock(&gcontext->client_lock);
+		pg_atomic_fetch_sub_u32(&GPUSERV_DEVICE_STATS(gcontext->cuda_dindex)->nr_sessions, 1);
+		__gpuservSharedScanDetach(gclient);
 
 		if (gclient->sockfd >= 0)
 			close(gclient->sockfd);
+		if (gclient->cmd_ring)
+			munmap(gclient->cmd_ring, gclient->cmd_ring_sz);
+		if (gclient->resp_ring)
+		{
+			if (gclient->resp_ring_registered)
+				cuMemHostUnregister(gclient->resp_ring);
+			munmap(gclient->resp_ring, gclient->resp_ring_sz);
+		}
 		if (gclient->gq_buf)
 			putGpuQueryBuffer(gclient->gq_buf);
+		if (gclient->jit_module)
+			gpuJitPutModule(gclient->jit_module);
+		while (gclient->graph_free_list)
+		{
+			gpuTaskGraph *tgraph = gclient->graph_free_list;
+
+			gclient->graph_free_list = tgraph->next;
+			__gpuservFreeTaskGraph(tgraph);
+		}
 		if (gclient->session)
 		{
 			XpuCommand	   *xcmd = (XpuCommand *)((char *)gclient->session -
@@ -1110,22 +2879,219 @@ __gpuClientWriteBack(gpuClient *gclient, struct iovec *iov, int iovcnt)
 	pthreadMutexUnlock(&gclient->mutex);
 }
 
+/*
+ * gpuservHandleCloseSession
+ *
+ * It releases the per-session resources of the gpuClient, then it can
+ * accept the next OpenSession on the same connection. It runs on the
+ * monitor thread that owns the command ring buffer, and the backend sends
+ * CloseSession only after all the responses are received.
+ */
 static void
-gpuClientWriteBack(gpuClient  *gclient,
-				   XpuCommand *resp,
-				   size_t      resp_sz,
-				   int         kds_nitems,
-				   kern_data_store **kds_array)
+gpuservHandleCloseSession(gpuClient *gclient)
 {
-	struct iovec   *iov_array;
-	struct iovec   *iov;
-	int				i, iovcnt = 0;
+	XpuCommand		resp;
+	struct iovec	iov;
 
-	iov_array = alloca(sizeof(struct iovec) * (3 * kds_nitems + 1));
-	iov = &iov_array[iovcnt++];
-	iov->iov_base = resp;
-	iov->iov_len  = resp_sz;
-	for (i=0; i < kds_nitems; i++)
+	/* wait for the workers to release the last commands */
+	for (;;)
+	{
+		uint32_t	refcnt = pg_atomic_read_u32(&gclient->refcnt);
+
+		if ((refcnt & 1) == 0)
+			return;		/* error status, so connection shall be closed */
+		if (refcnt == 1)
+			break;
+		pg_usleep(100L);
+	}
+	__gpuservSharedScanDetach(gclient);
+	if (gclient->gq_buf)
+		putGpuQueryBuffer(gclient->gq_buf);
+	gclient->gq_buf = NULL;
+	gclient->gq_buf_deferred = false;
+	gclient->gq_buf_attached = false;
+	gclient->gq_buf_kmrels_handle = 0;
+	gclient->gq_buf_kmrels_signature = 0;
+	if (gclient->jit_module)
+		gpuJitPutModule(gclient->jit_module);
+	gclient->jit_module = NULL;
+	gclient->cuda_module = NULL;
+	while (gclient->graph_free_list)
+	{
+		gpuTaskGraph *tgraph = gclient->graph_free_list;
+
+		gclient->graph_free_list = tgraph->next;
+		__gpuservFreeTaskGraph(tgraph);
+	}
+	if (gclient->session)
+	{
+		XpuCommand	   *xcmd = (XpuCommand *)((char *)gclient->session -
+											  offsetof(XpuCommand, u.session));
+		__gpuServiceFreeCommand(xcmd);
+	}
+	gclient->session = NULL;
+	gclient->quota = NULL;
+	if (gclient->cmd_ring)
+		munmap(gclient->cmd_ring, gclient->cmd_ring_sz);
+	gclient->cmd_ring = NULL;
+	gclient->cmd_ring_sz = 0;
+	if (gclient->resp_ring)
+	{
+		if (gclient->resp_ring_registered)
+			cuMemHostUnregister(gclient->resp_ring);
+		munmap(gclient->resp_ring, gclient->resp_ring_sz);
+	}
+	gclient->resp_ring = NULL;
+	gclient->resp_ring_sz = 0;
+	gclient->resp_ring_registered = false;
+	/* reset the run-time statistics of the session */
+	gclient->aqual_nquals = 0;
+	gclient->aqual_order = 0;
+	memset(gclient->aqual_nevals, 0, sizeof(gclient->aqual_nevals));
+	memset(gclient->aqual_npassed, 0, sizeof(gclient->aqual_npassed));
+	gclient->jfilter_mask = 0;
+	gclient->jfilter_decided = false;
+	gclient->jfilter_nitems_in = 0;
+	memset(gclient->jfilter_nitems_out, 0, sizeof(gclient->jfilter_nitems_out));
+	pg_atomic_write_u64(&gclient->scan_nitems_out, 0);
+	gclient->kgeom_grid_sz = 0;
+	gclient->kgeom_block_sz = 0;
+	gclient->kgeom_shmem_sz = 0;
+	gclient->kgeom_prepfn_bufsz = 0;
+	gclient->kgeom_prepfn_nbufs = 0;
+
+	/* success status */
+	memset(&resp, 0, sizeof(resp));
+	resp.magic = XpuCommandMagicNumber;
+	resp.tag = XpuCommandTag__Success;
+	resp.length = offsetof(XpuCommand, u.results.stats);
+
+	iov.iov_base = &resp;
+	iov.iov_len  = resp.length;
+	__gpuClientWriteBack(gclient, &iov, 1);
+}
+
+/*
+ * __gpuClientWriteBackRing
+ *
+ * It writes back the response and the result buffers on the result ring
+ * buffer mapped by the backend, then sends only its offset on the socket.
+ * The kds_dst buffers are copied by DMA if the ring buffer is page-locked.
+ * It returns false if the result ring buffer has no room, then caller
+ * shall use the socket as usual.
+ */
+static bool
+__gpuClientWriteBackRing(gpuClient *gclient,
+						 struct iovec *iov_array, int iovcnt,
+						 size_t resp_sz)
+{
+	xpuResultRing *ring = gclient->resp_ring;
+	xpuResultRingItem *item;
+	XpuCommand	resp;
+	struct iovec iov;
+	uint64_t	head, tail, pos;
+	size_t		required;
+	size_t		padding = 0;
+	char	   *dst;
+	bool		dma_done = false;
+
+	required = TYPEALIGN(XPU_RESULT_RING_ALIGN,
+						 offsetof(xpuResultRingItem, data) + resp_sz);
+	if (required > ring->nbytes / 2)
+		return false;
+	/* reserve a contiguous item on the ring buffer */
+	pthreadMutexLock(&gclient->mutex);
+	head = pg_atomic_read_u64(&ring->head);
+	tail = pg_atomic_read_u64(&ring->tail);
+	pos = head % ring->nbytes;
+	if (pos + required > ring->nbytes)
+		padding = ring->nbytes - pos;
+	if (ring->nbytes - (head - tail) < padding + required)
+	{
+		pthreadMutexUnlock(&gclient->mutex);
+		return false;
+	}
+	if (padding > 0)
+	{
+		item = (xpuResultRingItem *)(ring->data + pos);
+		item->length = padding;
+		item->released = 1;
+		pos = 0;
+	}
+	item = (xpuResultRingItem *)(ring->data + pos);
+	item->length = required;
+	item->released = 0;
+	pg_write_barrier();
+	pg_atomic_write_u64(&ring->head, head + padding + required);
+	pthreadMutexUnlock(&gclient->mutex);
+
+	/* copy the response and the result buffers */
+	dst = item->data;
+	if (gclient->resp_ring_registered)
+	{
+		CUresult	rc = CUDA_SUCCESS;
+
+		for (int i=1; i < iovcnt && rc == CUDA_SUCCESS; i++)
+		{
+			dst += iov_array[i-1].iov_len;
+			rc = cuMemcpyAsync((CUdeviceptr)dst,
+							   (CUdeviceptr)iov_array[i].iov_base,
+							   iov_array[i].iov_len,
+							   MY_STREAM_PER_THREAD);
+		}
+		if (rc == CUDA_SUCCESS)
+			rc = cuStreamSynchronize(MY_STREAM_PER_THREAD);
+		else
+			(void)cuStreamSynchronize(MY_STREAM_PER_THREAD);
+		dma_done = (rc == CUDA_SUCCESS);
+		dst = item->data;
+	}
+	for (int i=0; i < iovcnt; i++)
+	{
+		if (i == 0 || !dma_done)
+			memcpy(dst, iov_array[i].iov_base, iov_array[i].iov_len);
+		dst += iov_array[i].iov_len;
+	}
+	pg_write_barrier();
+
+	/* send the offset of the response */
+	memset(&resp, 0, offsetof(XpuCommand, u.ring_offset));
+	resp.magic = XpuCommandMagicNumber;
+	resp.tag   = XpuCommandTag__RingResponse;
+	resp.length = offsetof(XpuCommand, u.ring_offset) + sizeof(uint64_t);
+	resp.u.ring_offset = pos;
+
+	iov.iov_base = &resp;
+	iov.iov_len  = resp.length;
+	__gpuClientWriteBack(gclient, &iov, 1);
+
+	return true;
+}
+
+static void
+gpuClientWriteBack(gpuClient  *gclient,
+				   XpuCommand *resp,
+				   size_t      resp_sz,
+				   int         kds_nitems,
+				   kern_data_store **kds_array)
+{
+	struct iovec   *iov_array;
+	struct iovec   *iov;
+	int				i, iovcnt = 0;
+	int				iovmax = 1;
+
+	for (i=0; i < kds_nitems; i++)
+	{
+		if (kds_array[i]->format == KDS_FORMAT_COLUMN)
+			iovmax += 2 * kds_array[i]->ncols + 1;
+		else
+			iovmax += 3;
+	}
+	iov_array = alloca(sizeof(struct iovec) * iovmax);
+	iov = &iov_array[iovcnt++];
+	iov->iov_base = resp;
+	iov->iov_len  = resp_sz;
+	for (i=0; i < kds_nitems; i++)
 	{
 		kern_data_store *kds = kds_array[i];
 		size_t		sz1, sz2, sz3;
@@ -1186,6 +3152,47 @@ gpuClientWriteBack(gpuClient  *gclient,
 				kds->length = (sz1 + sz2);
 			}
 		}
+		else if (kds->format == KDS_FORMAT_COLUMN &&
+				 resp->tag == XpuCommandTag__Success)
+		{
+			/*
+			 * Columnar results: only the first nitems of the nullmap and
+			 * the values array of each column are sent back, then colmeta
+			 * is fixed up for the packed layout.
+			 */
+			size_t		off = KDS_HEAD_LENGTH(kds);
+
+			iov = &iov_array[iovcnt++];
+			iov->iov_base = kds;
+			iov->iov_len  = off;
+			for (int j=0; j < kds->ncols; j++)
+			{
+				kern_colmeta *cmeta = &kds->colmeta[j];
+
+				sz1 = MAXALIGN(BITMAPLEN(kds->nitems));
+				sz2 = MAXALIGN((size_t)cmeta->attlen * kds->nitems);
+				if (sz1 > 0)
+				{
+					iov = &iov_array[iovcnt++];
+					iov->iov_base = (char *)kds + __kds_unpack(cmeta->nullmap_offset);
+					iov->iov_len  = sz1;
+				}
+				cmeta->nullmap_offset = __kds_packed(off);
+				cmeta->nullmap_length = __kds_packed(sz1);
+				off += sz1;
+				if (sz2 > 0)
+				{
+					iov = &iov_array[iovcnt++];
+					iov->iov_base = (char *)kds + __kds_unpack(cmeta->values_offset);
+					iov->iov_len  = sz2;
+				}
+				cmeta->values_offset = __kds_packed(off);
+				cmeta->values_length = __kds_packed(sz2);
+				off += sz2;
+			}
+			kds->column_nrooms = kds->nitems;
+			kds->length = off;
+		}
 		else
 		{
 			/*
@@ -1199,6 +3206,9 @@ gpuClientWriteBack(gpuClient  *gclient,
 		resp_sz += kds->length;
 	}
 	resp->length = resp_sz;
+	if (gclient->resp_ring &&
+		__gpuClientWriteBackRing(gclient, iov_array, iovcnt, resp_sz))
+		return;
 	__gpuClientWriteBack(gclient, iov_array, iovcnt);
 }
 
@@ -1312,17 +3322,395 @@ gpuClientELogByExtraModule(gpuClient *gclient)
 						"extra-module: %s", buffer);
 }
 
+/* ----------------------------------------------------------------
+ *
+ * Validation of the commands from the remote hosts
+ *
+ * The backends on the local host are trusted, like the other server
+ * processes. On the other hand, all the offsets and lengths in the commands
+ * from the remote hosts are checked prior to any references, and the files
+ * to be read must be under pg_strom.gpu_service_remote_data_dir.
+ *
+ * ----------------------------------------------------------------
+ */
+static inline bool
+__gpuservRemoteRangeIsValid(size_t length, uint64_t offset, uint64_t sz)
+{
+	return (offset <= length && sz <= length - offset);
+}
+
+static bool
+__gpuservRemoteKexpIsValid(const char *base, size_t length,
+						   uint64_t offset, int depth)
+{
+	const kern_expression *kexp;
+	const kern_expression *karg;
+	uint32_t	i;
+
+	if (depth > GPUSERV_REMOTE_KEXP_MAXDEPTH ||
+		!__gpuservRemoteRangeIsValid(length, offset, SizeOfKernExpr(0)))
+		return false;
+	kexp = (const kern_expression *)(base + offset);
+	if (kexp->len < SizeOfKernExpr(0) ||
+		!__gpuservRemoteRangeIsValid(length, offset, kexp->len))
+		return false;
+	/* arguments must be within the parent expression */
+	for (i=0, karg = KEXP_FIRST_ARG(kexp);
+		 i < kexp->nr_args && karg != NULL;
+		 i++, karg = KEXP_NEXT_ARG(karg))
+	{
+		if (!__gpuservRemoteKexpIsValid((const char *)kexp, kexp->len,
+										(const char *)karg - (const char *)kexp,
+										depth + 1))
+			return false;
+	}
+	return true;
+}
+
+static bool
+__gpuservRemoteKdsHeadIsValid(const char *base, size_t length, uint64_t offset)
+{
+	const kern_data_store *kds;
+
+	if (!__gpuservRemoteRangeIsValid(length, offset,
+									 offsetof(kern_data_store, colmeta)))
+		return false;
+	kds = (const kern_data_store *)(base + offset);
+	return (kds->ncols <= kds->nr_colmeta &&
+			__gpuservRemoteRangeIsValid(length, offset, KDS_HEAD_LENGTH(kds)) &&
+			KDS_HEAD_LENGTH(kds) <= kds->length);
+}
+
+static bool
+__gpuservRemotePathIsAllowed(const char *pathname)
+{
+	char		resolved[PATH_MAX];
+
+	/* symbolic links and '..' are resolved prior to the check */
+	if (pathname[0] != '/' || !realpath(pathname, resolved))
+		return false;
+	for (int i=0; i < gpuserv_remote_data_ndirs; i++)
+	{
+		const char *dir = gpuserv_remote_data_dirs[i];
+		size_t		len = strlen(dir);
+
+		if (strncmp(resolved, dir, len) == 0 &&
+			(resolved[len] == '/' || dir[len-1] == '/'))
+			return true;
+	}
+	return false;
+}
+
+static const char *
+__gpuservValidateRemoteSession(XpuCommand *xcmd)
+{
+	const kern_session_info *session = &xcmd->u.session;
+	const char *base = (const char *)session;
+	size_t		length;
+	uint32_t	kexp_offsets[] = {
+		session->xpucode_load_vars_packed,
+		session->xpucode_move_vars_packed,
+		session->xpucode_scan_quals,
+		session->xpucode_join_quals_packed,
+		session->xpucode_hash_values_packed,
+		session->xpucode_gist_evals_packed,
+		session->xpucode_projection,
+		session->xpucode_groupby_keyhash,
+		session->xpucode_groupby_keyload,
+		session->xpucode_groupby_keycomp,
+		session->xpucode_groupby_actions,
+	};
+
+	if (xcmd->length < offsetof(XpuCommand, u.session.poffset))
+		return "too short session";
+	length = xcmd->length - offsetof(XpuCommand, u.session);
+	if (!__gpuservRemoteRangeIsValid(length, offsetof(kern_session_info, poffset),
+									 sizeof(uint32_t) * (uint64_t)session->nparams))
+		return "parameters out of range";
+	for (uint32_t i=0; i < session->nparams; i++)
+	{
+		if (session->poffset[i] >= length)
+			return "parameters out of range";
+	}
+	if (session->xcmd_ring_handle != 0 || session->xresp_ring_handle != 0)
+		return "ring buffers are not available";
+	/*
+	 * GpuJoin inner buffer (kern_multirels) is a shared memory segment on
+	 * the host of the backend, so no handle can be resolved here. Without
+	 * kern_multirels, the session must not reference any join depths.
+	 */
+	if (session->join_inner_handle != 0 ||
+		session->join_inner_signature != 0 ||
+		session->join_inner_deferred ||
+		session->join_right_outer_on_device ||
+		session->join_bloom_prefilter != 0)
+		return "GpuJoin inner buffer is not available";
+	if (session->kcxt_kvecs_ndims > 2 ||
+		session->xpucode_join_quals_packed != 0 ||
+		session->xpucode_hash_values_packed != 0 ||
+		session->xpucode_gist_evals_packed != 0)
+		return "join depths are not available";
+	for (int i=0; i < lengthof(kexp_offsets); i++)
+	{
+		if (kexp_offsets[i] != 0 &&
+			!__gpuservRemoteKexpIsValid(base, length, kexp_offsets[i], 0))
+			return "xpucode out of range";
+	}
+	if (session->kcxt_kvars_defs != 0 &&
+		!__gpuservRemoteRangeIsValid(length, session->kcxt_kvars_defs,
+									 sizeof(kern_varslot_desc) *
+									 (uint64_t)session->kcxt_kvars_nrooms))
+		return "kvars-defs out of range";
+	if (session->xpucode_signature != 0 &&
+		!__gpuservRemoteRangeIsValid(length, session->xpucode_cache_head,
+									 session->xpucode_cache_length))
+		return "xpucode cache out of range";
+	if (session->gpusort_keydesc != 0 &&
+		!__gpuservRemoteRangeIsValid(length, session->gpusort_keydesc,
+									 sizeof(kern_sortkey_desc) *
+									 (uint64_t)session->gpusort_nkeys))
+		return "sort-keys out of range";
+	if (session->session_xact_state != 0 &&
+		!__gpuservRemoteRangeIsValid(length, session->session_xact_state, 1))
+		return "transaction state out of range";
+	if (session->session_xact_snapshot != 0)
+	{
+		const kern_xact_snapshot *ksnap;
+		uint64_t	offset = session->session_xact_snapshot;
+
+		if (!__gpuservRemoteRangeIsValid(length, offset,
+										 offsetof(kern_xact_snapshot, xip)))
+			return "snapshot out of range";
+		ksnap = (const kern_xact_snapshot *)(base + offset);
+		if (!__gpuservRemoteRangeIsValid(length, offset,
+										 offsetof(kern_xact_snapshot, xip) +
+										 sizeof(TransactionId) * (uint64_t)ksnap->xcnt) ||
+			!__gpuservRemoteRangeIsValid(length, offset + ksnap->clog_offset,
+										 ((uint64_t)ksnap->clog_nxids + 7) / 8))
+			return "snapshot out of range";
+	}
+	if (session->session_timezone != 0 &&
+		!__gpuservRemoteRangeIsValid(length, session->session_timezone, 1))
+		return "timezone out of range";
+	if (session->session_encode != 0 &&
+		!__gpuservRemoteRangeIsValid(length, session->session_encode,
+									 sizeof(xpu_encode_info)))
+		return "encoding out of range";
+	if (session->groupby_kds_final != 0 &&
+		!__gpuservRemoteKdsHeadIsValid(base, length, session->groupby_kds_final))
+		return "kds_final out of range";
+	return NULL;
+}
+
+static const char *
+__gpuservValidateRemoteTask(XpuCommand *xcmd)
+{
+	const kern_exec_task *task = &xcmd->u.task;
+	const char *base = (const char *)xcmd;
+	size_t		length = xcmd->length;
+	const kern_data_store *kds;
+	const strom_io_vector *iovec;
+	const char *pathname;
+	size_t		base_offset;
+
+	if (length < offsetof(XpuCommand, u.task.data))
+		return "too short task";
+	if (task->kds_src_offset == 0)
+		return "GpuCache is not supported";
+	if (!__gpuservRemoteKdsHeadIsValid(base, length, task->kds_src_offset))
+		return "kds_src out of range";
+	if (task->kds_dst_offset != 0 &&
+		!__gpuservRemoteKdsHeadIsValid(base, length, task->kds_dst_offset))
+		return "kds_dst out of range";
+	kds = (const kern_data_store *)(base + task->kds_src_offset);
+	if (task->kds_src_pathname == 0 && task->kds_src_iovec == 0)
+	{
+		/* the whole source buffer is shipped by the command */
+		if (!__gpuservRemoteRangeIsValid(length, task->kds_src_offset, kds->length))
+			return "kds_src out of range";
+		if (kds->format == KDS_FORMAT_BLOCK &&
+			!__gpuservRemoteRangeIsValid(kds->length, kds->block_offset,
+										 (uint64_t)kds->block_nloaded * BLCKSZ))
+			return "kds_src blocks out of range";
+		return NULL;
+	}
+	if (task->kds_src_pathname == 0 || task->kds_src_iovec == 0)
+		return "pathname and iovec must be given together";
+	/* pathname */
+	if (task->kds_src_pathname >= length ||
+		!memchr(base + task->kds_src_pathname, '\0',
+				length - task->kds_src_pathname))
+		return "kds_src_pathname out of range";
+	pathname = base + task->kds_src_pathname;
+	/* i/o vector to be loaded after the KDS head (and blocks) */
+	if (!__gpuservRemoteRangeIsValid(length, task->kds_src_iovec,
+									 offsetof(strom_io_vector, ioc)))
+		return "kds_src_iovec out of range";
+	iovec = (const strom_io_vector *)(base + task->kds_src_iovec);
+	if (!__gpuservRemoteRangeIsValid(length, task->kds_src_iovec,
+									 offsetof(strom_io_vector, ioc) +
+									 sizeof(strom_io_chunk) * (uint64_t)iovec->nr_chunks))
+		return "kds_src_iovec out of range";
+	if (kds->format == KDS_FORMAT_ARROW)
+		base_offset = KDS_HEAD_LENGTH(kds);
+	else if (kds->format == KDS_FORMAT_BLOCK)
+		base_offset = kds->block_offset + (uint64_t)kds->block_nloaded * BLCKSZ;
+	else
+		return "unexpected format of kds_src";
+	if (!__gpuservRemoteRangeIsValid(length, task->kds_src_offset, base_offset) ||
+		base_offset > kds->length)
+		return "kds_src out of range";
+	for (uint32_t i=0; i < iovec->nr_chunks; i++)
+	{
+		const strom_io_chunk *ioc = &iovec->ioc[i];
+
+		if (!__gpuservRemoteRangeIsValid(kds->length - base_offset,
+										 ioc->m_offset,
+										 (uint64_t)ioc->nr_pages * PAGE_SIZE))
+			return "kds_src_iovec out of range";
+	}
+	if (!__gpuservRemotePathIsAllowed(pathname))
+		return "source file is not under pg_strom.gpu_service_remote_data_dir";
+	return NULL;
+}
+
+/*
+ * __gpuServiceValidateRemoteCommand
+ */
+static bool
+__gpuServiceValidateRemoteCommand(gpuClient *gclient, XpuCommand *xcmd)
+{
+	const char *emsg = NULL;
+
+	switch (xcmd->tag)
+	{
+		case XpuCommandTag__CloseSession:
+		case XpuCommandTag__DeviceAttrs:
+			break;
+		case XpuCommandTag__OpenSession:
+			emsg = __gpuservValidateRemoteSession(xcmd);
+			break;
+		case XpuCommandTag__XpuTaskExec:
+			emsg = __gpuservValidateRemoteTask(xcmd);
+			break;
+		case XpuCommandTag__XpuTaskFinal:
+			if (xcmd->length < offsetof(XpuCommand, u.fin.data))
+				emsg = "too short final task";
+			else if (xcmd->u.fin.kds_dst_offset != 0 &&
+					 !__gpuservRemoteKdsHeadIsValid((const char *)xcmd,
+													xcmd->length,
+													xcmd->u.fin.kds_dst_offset))
+				emsg = "kds_dst out of range";
+			break;
+		default:
+			emsg = "command is not supported on the remote GPU service";
+			break;
+	}
+	if (emsg)
+	{
+		gpuClientELog(gclient, "invalid XPU command (tag=%u, length=%lu) from the remote host: %s",
+					  xcmd->tag, xcmd->length, emsg);
+		return false;
+	}
+	return true;
+}
+
+/*
+ * __gpuClientAttachDeferredBuffer
+ *
+ * When the backend opens the session prior to the inner preloading, the
+ * outer chunks are loaded onto the device concurrently, then the workers
+ * wait for the inner buffer being attached here, prior to the kernel launch.
+ * The number of outer chunks in the wait is bounded by the backend.
+ */
+static bool
+__gpuClientAttachDeferredBuffer(gpuClient *gclient)
+{
+	kern_session_info *session = gclient->session;
+	kern_data_store *kds_final_head = NULL;
+	gpuQueryBuffer *gq_buf = NULL;
+	uint32_t	kmrels_handle;
+	uint64_t	kmrels_signature;
+	char		emsg[512];
+
+	pthreadMutexLock(&gpu_query_buffer_mutex);
+	while (gclient->gq_buf_deferred && !gclient->gq_buf_attached)
+	{
+		/* connection closed during the inner preloading? */
+		if (gpuServiceGoingTerminate() ||
+			(pg_atomic_read_u32(&gclient->refcnt) & 1) == 0)
+		{
+			pthreadMutexUnlock(&gpu_query_buffer_mutex);
+			return false;
+		}
+		pthreadCondWaitTimeout(&gpu_query_buffer_cond,
+							   &gpu_query_buffer_mutex,
+							   1000L);
+	}
+	if (!gclient->gq_buf_deferred)
+	{
+		/* already attached by the concurrent worker */
+		pthreadMutexUnlock(&gpu_query_buffer_mutex);
+		return true;
+	}
+	kmrels_handle = gclient->gq_buf_kmrels_handle;
+	kmrels_signature = gclient->gq_buf_kmrels_signature;
+	pthreadMutexUnlock(&gpu_query_buffer_mutex);
+
+	if (kmrels_handle != 0)
+	{
+		if (session->groupby_kds_final != 0)
+		{
+			kds_final_head = (kern_data_store *)
+				((char *)session + session->groupby_kds_final);
+		}
+		gq_buf = getGpuQueryBuffer(gclient->gcontext,
+								   session->query_plan_id,
+								   kmrels_handle,
+								   kmrels_signature,
+								   kds_final_head,
+								   gclient->quota,
+								   emsg, sizeof(emsg));
+		if (!gq_buf)
+		{
+			gpuClientELog(gclient, "%s", emsg);
+			return false;
+		}
+	}
+	pthreadMutexLock(&gpu_query_buffer_mutex);
+	if (gclient->gq_buf_deferred)
+	{
+		gclient->gq_buf = gq_buf;
+		gclient->gq_buf_deferred = false;
+		gq_buf = NULL;
+	}
+	pthreadMutexUnlock(&gpu_query_buffer_mutex);
+	if (gq_buf)
+		putGpuQueryBuffer(gq_buf);
+	return true;
+}
+
 /*
  * gpuservHandleOpenSession
  */
 static bool
 __lookupDeviceTypeOper(gpuContext *gcontext,
+					   gpuJitModule *jit_module,
 					   const xpu_datum_operators **p_expr_ops,
 					   TypeOpCode type_code,
 					   char *emsg, size_t emsg_sz)
 {
 	xpu_type_catalog_entry *xpu_type;
 
+	if (jit_module)
+	{
+		if (gpuJitLookupTypeOper(jit_module, type_code, p_expr_ops))
+			return true;
+		snprintf(emsg, emsg_sz,
+				 "device type pointer for opcode:%u not found in JIT module.",
+				 (int)type_code);
+		return false;
+	}
 	xpu_type = hash_search(gcontext->cuda_type_htab,
 						   &type_code,
 						   HASH_FIND, NULL);
@@ -1339,12 +3727,22 @@ __lookupDeviceTypeOper(gpuContext *gcontext,
 
 static bool
 __lookupDeviceFuncDptr(gpuContext *gcontext,
+					   gpuJitModule *jit_module,
 					   xpu_function_t *p_func_dptr,
 					   FuncOpCode func_code,
 					   char *emsg, size_t emsg_sz)
 {
 	xpu_function_catalog_entry *xpu_func;
 
+	if (jit_module)
+	{
+		if (gpuJitLookupFuncDptr(jit_module, func_code, p_func_dptr))
+			return true;
+		snprintf(emsg, emsg_sz,
+				 "device function pointer for opcode:%u not found in JIT module.",
+				 (int)func_code);
+		return false;
+	}
 	xpu_func = hash_search(gcontext->cuda_func_htab,
 						   &func_code,
 						   HASH_FIND, NULL);
@@ -1361,6 +3759,7 @@ __lookupDeviceFuncDptr(gpuContext *gcontext,
 
 static bool
 __resolveDevicePointersWalker(gpuContext *gcontext,
+							  gpuJitModule *jit_module,
 							  kern_expression *kexp,
 							  char *emsg, size_t emsg_sz)
 {
@@ -1368,12 +3767,14 @@ __resolveDevicePointersWalker(gpuContext *gcontext,
 	int		i;
 
 	if (!__lookupDeviceFuncDptr(gcontext,
+								jit_module,
 								&kexp->fn_dptr,
 								kexp->opcode,
 								emsg, emsg_sz))
 		return false;
 
 	if (!__lookupDeviceTypeOper(gcontext,
+								jit_module,
 								&kexp->expr_ops,
 								kexp->exptype,
 								emsg, emsg_sz))
@@ -1389,7 +3790,7 @@ __resolveDevicePointersWalker(gpuContext *gcontext,
 					((char *)kexp + kexp->u.casewhen.case_comp);
 				if (!__KEXP_IS_VALID(kexp,karg))
 					goto corruption;
-				if (!__resolveDevicePointersWalker(gcontext, karg,
+				if (!__resolveDevicePointersWalker(gcontext, jit_module, karg,
 												   emsg, emsg_sz))
 					return false;
 			}
@@ -1399,7 +3800,7 @@ __resolveDevicePointersWalker(gpuContext *gcontext,
 					((char *)kexp + kexp->u.casewhen.case_else);
 				if (!__KEXP_IS_VALID(kexp,karg))
 					goto corruption;
-				if (!__resolveDevicePointersWalker(gcontext, karg,
+				if (!__resolveDevicePointersWalker(gcontext, jit_module, karg,
 												   emsg, emsg_sz))
 					return false;
 			}
@@ -1415,7 +3816,8 @@ __resolveDevicePointersWalker(gpuContext *gcontext,
 	{
 		if (!__KEXP_IS_VALID(kexp,karg))
 			goto corruption;
-		if (!__resolveDevicePointersWalker(gcontext, karg, emsg, emsg_sz))
+		if (!__resolveDevicePointersWalker(gcontext, jit_module, karg,
+										   emsg, emsg_sz))
 			return false;
 	}
 	return true;
@@ -1427,11 +3829,12 @@ corruption:
 
 static bool
 __resolveDevicePointers(gpuContext *gcontext,
+						gpuJitModule *jit_module,
 						kern_session_info *session,
 						char *emsg, size_t emsg_sz)
 {
 	kern_varslot_desc *kvslot_desc = SESSION_KVARS_SLOT_DESC(session);
-	xpu_encode_info *encode = SESSION_ENCODE(session);
+	kern_sortkey_desc *skey_desc = SESSION_GPUSORT_KEYDESC(session);
 	kern_expression *__kexp[20];
 	int		nitems = 0;
 
@@ -1450,6 +3853,7 @@ __resolveDevicePointers(gpuContext *gcontext,
 	for (int i=0; i < nitems; i++)
 	{
 		if (__kexp[i] && !__resolveDevicePointersWalker(gcontext,
+														jit_module,
 														__kexp[i],
 														emsg, emsg_sz))
 			return false;
@@ -1459,13 +3863,39 @@ __resolveDevicePointers(gpuContext *gcontext,
 	for (int i=0; i < session->kcxt_kvars_nslots; i++)
 	{
 		if (!__lookupDeviceTypeOper(gcontext,
+									jit_module,
 									&kvslot_desc[i].vs_ops,
 									kvslot_desc[i].vs_type_code,
 									emsg, emsg_sz))
 			return false;
 	}
 
-	/**/
+	/* fixup kern_sortkey_desc also */
+	for (int i=0; i < session->gpusort_nkeys; i++)
+	{
+		if (!__lookupDeviceTypeOper(gcontext,
+									jit_module,
+									&skey_desc[i].key_ops,
+									skey_desc[i].key_type_code,
+									emsg, emsg_sz))
+			return false;
+	}
+	return true;
+}
+
+/*
+ * __resolveSessionEncode
+ *
+ * xpu_encode_info depends on the client_encoding, so it is not a part of
+ * the cached xpucode.
+ */
+static bool
+__resolveSessionEncode(gpuContext *gcontext,
+					   kern_session_info *session,
+					   char *emsg, size_t emsg_sz)
+{
+	xpu_encode_info *encode = SESSION_ENCODE(session);
+
 	if (encode)
 	{
 		xpu_encode_info *catalog = gcontext->cuda_encode_catalog;
@@ -1489,29 +3919,232 @@ __resolveDevicePointers(gpuContext *gcontext,
 	return true;
 }
 
+/*
+ * __lookupSessionCache
+ *
+ * It overwrites the plan-invariant portion of the session by the cached one
+ * whose device pointers are already resolved, if any.
+ */
 static bool
-gpuservHandleOpenSession(gpuClient *gclient, XpuCommand *xcmd)
+__lookupSessionCache(gpuClient *gclient, kern_session_info *session)
 {
-	gpuContext	   *gcontext = gclient->gcontext;
-	kern_session_info *session = &xcmd->u.session;
-	XpuCommand		resp;
-	char			emsg[512];
-	struct iovec	iov;
+	gpuContext *gcontext = gclient->gcontext;
+	dlist_iter	iter;
+
+	if (session->xpucode_signature == 0)
+		return false;
+	pthreadMutexLock(&gcontext->session_cache_lock);
+	dlist_foreach (iter, &gcontext->session_cache_list)
+	{
+		gpuSessionCache *entry = dlist_container(gpuSessionCache,
+												 chain, iter.cur);
+		char   *addr = (char *)session + session->xpucode_cache_head;
+
+		if (entry->signature == session->xpucode_signature &&
+			entry->head == session->xpucode_cache_head &&
+			entry->length == session->xpucode_cache_length &&
+			entry->kvars_nslots == session->kcxt_kvars_nslots &&
+			entry->use_jit == session->xpucode_use_jit &&
+			memcmp(entry->raw, addr, entry->length) == 0)
+		{
+			memcpy(addr, entry->resolved, entry->length);
+			if (entry->jit_module)
+			{
+				gclient->jit_module = gpuJitDupModule(entry->jit_module);
+				gclient->cuda_module = gpuJitGetCudaModule(gclient->jit_module);
+			}
+			dlist_move_head(&gcontext->session_cache_list, &entry->chain);
+			pthreadMutexUnlock(&gcontext->session_cache_lock);
+			return true;
+		}
+	}
+	pthreadMutexUnlock(&gcontext->session_cache_lock);
+	return false;
+}
+
+/*
+ * __insertSessionCache
+ *
+ * It saves the plan-invariant portion of the session just after the device
+ * pointers are resolved. The raw portion is moved to the cache entry.
+ */
+static void
+__insertSessionCache(gpuClient *gclient,
+					 const kern_session_info *session,
+					 char *raw)
+{
+	gpuContext *gcontext = gclient->gcontext;
+	gpuSessionCache *entry;
+	dlist_iter	iter;
+
+	entry = calloc(1, sizeof(gpuSessionCache) + session->xpucode_cache_length);
+	if (!entry)
+	{
+		free(raw);
+		return;		/* just skip caching */
+	}
+	entry->signature = session->xpucode_signature;
+	entry->head = session->xpucode_cache_head;
+	entry->length = session->xpucode_cache_length;
+	entry->kvars_nslots = session->kcxt_kvars_nslots;
+	entry->use_jit = session->xpucode_use_jit;
+	entry->raw = raw;
+	entry->resolved = (char *)(entry + 1);
+	memcpy(entry->resolved,
+		   (char *)session + session->xpucode_cache_head,
+		   session->xpucode_cache_length);
+
+	pthreadMutexLock(&gcontext->session_cache_lock);
+	dlist_foreach (iter, &gcontext->session_cache_list)
+	{
+		gpuSessionCache *curr = dlist_container(gpuSessionCache,
+												chain, iter.cur);
+		if (curr->signature == entry->signature &&
+			curr->head == entry->head &&
+			curr->length == entry->length &&
+			curr->kvars_nslots == entry->kvars_nslots &&
+			curr->use_jit == entry->use_jit &&
+			memcmp(curr->raw, entry->raw, entry->length) == 0)
+		{
+			/* concurrent session already cached the same one */
+			pthreadMutexUnlock(&gcontext->session_cache_lock);
+			free(entry->raw);
+			free(entry);
+			return;
+		}
+	}
+	if (gclient->jit_module)
+		entry->jit_module = gpuJitDupModule(gclient->jit_module);
+	dlist_push_head(&gcontext->session_cache_list, &entry->chain);
+	gcontext->session_cache_nitems++;
+	/* evict the least recently used one */
+	while (gcontext->session_cache_nitems > GPUSERV_SESSION_CACHE_MAX_NITEMS)
+	{
+		dlist_node *dnode = dlist_tail_node(&gcontext->session_cache_list);
+
+		entry = dlist_container(gpuSessionCache, chain, dnode);
+		dlist_delete(&entry->chain);
+		gcontext->session_cache_nitems--;
+		if (entry->jit_module)
+			gpuJitPutModule(entry->jit_module);
+		free(entry->raw);
+		free(entry);
+	}
+	pthreadMutexUnlock(&gcontext->session_cache_lock);
+}
+
+static bool
+gpuservHandleOpenSession(gpuClient *gclient, XpuCommand *xcmd)
+{
+	gpuContext	   *gcontext = gclient->gcontext;
+	kern_session_info *session = &xcmd->u.session;
+	const kern_expression *kexp_scan_quals;
+	XpuCommand		resp;
+	char			emsg[512];
+	char		   *xpucode_raw = NULL;
+	struct iovec	iov;
 
 	if (gclient->session)
 	{
 		gpuClientELog(gclient, "OpenSession is called twice");
 		return false;
 	}
+	if (session->xcmd_ring_handle != 0 && !gclient->cmd_ring)
+	{
+		gpuClientELog(gclient, "unable to map the command ring buffer (handle=%u)",
+					  session->xcmd_ring_handle);
+		return false;
+	}
+	if (session->xresp_ring_handle != 0 && !gclient->resp_ring)
+	{
+		gpuClientELog(gclient, "unable to map the result ring buffer (handle=%u)",
+					  session->xresp_ring_handle);
+		return false;
+	}
+
+	gclient->quota = __gpuQuotaLookupSlot(session);
 
+	/* try JIT compiled xpucode, if required */
+	gclient->cuda_module = gcontext->cuda_module;
+	if (__lookupSessionCache(gclient, session))
+		goto xpucode_resolved;
+	if (session->xpucode_signature != 0)
+	{
+		/* keep the raw portion to be cached, prior to the resolution */
+		xpucode_raw = malloc(session->xpucode_cache_length);
+		if (xpucode_raw)
+			memcpy(xpucode_raw,
+				   (char *)session + session->xpucode_cache_head,
+				   session->xpucode_cache_length);
+	}
+	if (session->xpucode_use_jit)
+	{
+		uint32_t   *jit_entries = NULL;
+
+		emsg[0] = '\0';
+		gclient->jit_module = gpuJitGetModule(gcontext->cuda_dindex,
+											  gcontext->gpumain_shmem_sz_dynamic,
+											  session,
+											  &jit_entries,
+											  emsg, sizeof(emsg));
+		if (gclient->jit_module)
+		{
+			if (!__resolveDevicePointers(gcontext, gclient->jit_module,
+										 session, emsg, sizeof(emsg)))
+			{
+				gpuClientELog(gclient, "%s", emsg);
+				free(jit_entries);
+				free(xpucode_raw);
+				return false;
+			}
+			gpuJitApplyEntries(gclient->jit_module, session, jit_entries);
+			gclient->cuda_module = gpuJitGetCudaModule(gclient->jit_module);
+		}
+		else if (emsg[0] != '\0')
+			GpuServDebug("JIT compile is not available, so it uses the xpucode interpreter: %s", emsg);
+		free(jit_entries);
+	}
 	/* resolve device pointers */
-	if (!__resolveDevicePointers(gcontext, session, emsg, sizeof(emsg)))
+	if (!gclient->jit_module &&
+		!__resolveDevicePointers(gcontext, NULL, session, emsg, sizeof(emsg)))
 	{
 		gpuClientELog(gclient, "%s", emsg);
+		free(xpucode_raw);
 		return false;
 	}
-	if (session->join_inner_handle != 0 ||
-		session->groupby_kds_final != 0)
+	if (xpucode_raw)
+		__insertSessionCache(gclient, session, xpucode_raw);
+xpucode_resolved:
+	if (!__resolveSessionEncode(gcontext, session, emsg, sizeof(emsg)))
+	{
+		gpuClientELog(gclient, "%s", emsg);
+		return false;
+	}
+	if (gclient->is_remote)
+	{
+		/*
+		 * GpuJoin inner buffer is a shared memory segment on the host of
+		 * the backend, so unavailable. Also, query_plan_id is unique only
+		 * on the host, so the hash of the remote address is mixed to share
+		 * the GpuPreAgg final buffer by the parallel workers of the query.
+		 */
+		if (session->join_inner_deferred ||
+			session->join_inner_handle != 0)
+		{
+			gpuClientELog(gclient, "GpuJoin is not supported on the remote GPU service");
+			return false;
+		}
+		session->query_plan_id ^= gclient->remote_plan_id_mask;
+	}
+	if (session->join_inner_deferred)
+	{
+		/* see __gpuClientAttachDeferredBuffer */
+		pthreadMutexLock(&gpu_query_buffer_mutex);
+		gclient->gq_buf_deferred = true;
+		pthreadMutexUnlock(&gpu_query_buffer_mutex);
+	}
+	else if (session->join_inner_handle != 0 ||
+			 session->groupby_kds_final != 0)
 	{
 		kern_data_store *kds_final_head = NULL;
 
@@ -1523,7 +4156,9 @@ gpuservHandleOpenSession(gpuClient *gclient, XpuCommand *xcmd)
 		gclient->gq_buf = getGpuQueryBuffer(gcontext,
 											session->query_plan_id,
 											session->join_inner_handle,
+											session->join_inner_signature,
 											kds_final_head,
+											gclient->quota,
 											emsg, sizeof(emsg));
 		if (!gclient->gq_buf)
 		{
@@ -1531,6 +4166,13 @@ gpuservHandleOpenSession(gpuClient *gclient, XpuCommand *xcmd)
 			return false;
 		}
 	}
+	/* scan-quals that can be reordered at run-time */
+	kexp_scan_quals = SESSION_KEXP_SCAN_QUALS(session);
+	if (kexp_scan_quals &&
+		kexp_scan_quals->opcode == FuncOpCode__BoolExpr_And &&
+		(kexp_scan_quals->expflags & KEXP_FLAG__ADAPTIVE_ORDER) != 0 &&
+		kexp_scan_quals->nr_args <= KERN_ADAPTIVE_QUALS_MAX)
+		gclient->aqual_nquals = kexp_scan_quals->nr_args;
 	gclient->session = session;
 
 	/* success status */
@@ -1552,385 +4194,2112 @@ gpuservHandleOpenSession(gpuClient *gclient, XpuCommand *xcmd)
  *
  * ----------------------------------------------------------------
  */
-static gpuMemChunk *
-__gpuservLoadKdsCommon(gpuClient *gclient,
-					   kern_data_store *kds,
-					   size_t base_offset,
-					   const char *pathname,
-					   strom_io_vector *kds_iovec,
-					   uint32_t *p_npages_direct_read,
-					   uint32_t *p_npages_vfs_read)
+static int		pgstrom_gpu_staging_buffer_kb;	/* GUC */
+
+/*
+ * gpuStagingBuffer - page-locked host buffer with its own copy stream, to
+ * copy the KDS portion on the host (command buffer on the managed memory)
+ * to the device by DMA. A copy takes two buffers of the pool and ping-pongs
+ * between them; see __gpuservCopyHostToDevice.
+ */
+typedef struct
 {
-	gpuMemChunk *chunk;
+	dlist_node		chain;		/* link to gcontext->staging_free_list */
+	char		   *hbuf;		/* pinned host memory */
+	CUstream		stream;		/* stream for the DMA from hbuf */
+	CUevent			event;		/* completion of the last DMA from hbuf */
+} gpuStagingBuffer;
+
+#define GPUSERV_STAGING_MIN_COPY			(256UL << 10)	/* 256kB */
+
+/*
+ * __gpuservStagingBufferGet / Put
+ *
+ * The pool is expanded on demand, so it holds two buffers per the threads
+ * that copy in parallel at most. The buffer may be returned with the DMA
+ * in flight; the next owner waits for its event prior to the overwrite.
+ */
+static gpuStagingBuffer *
+__gpuservStagingBufferGet(gpuContext *gcontext)
+{
+	gpuStagingBuffer *sbuf = NULL;
+	size_t		sz = (size_t)pgstrom_gpu_staging_buffer_kb << 10;
 	CUresult	rc;
-	off_t		off = PAGE_ALIGN(base_offset);
-	size_t		gap = off - base_offset;
 
-	chunk = gpuMemAlloc(gap + kds->length);
-	if (!chunk)
-	{
-		gpuClientELog(gclient, "failed on gpuMemAlloc(%zu)", kds->length);
-		return NULL;
-	}
-	chunk->m_devptr = chunk->__base + chunk->__offset + gap;
+	pthreadMutexLock(&gcontext->staging_lock);
+	if (!dlist_is_empty(&gcontext->staging_free_list))
+		sbuf = dlist_container(gpuStagingBuffer, chain,
+							   dlist_pop_head_node(&gcontext->staging_free_list));
+	pthreadMutexUnlock(&gcontext->staging_lock);
+	if (sbuf)
+		return sbuf;
 
-	rc = cuMemcpyHtoD(chunk->m_devptr, kds, base_offset);
+	sbuf = calloc(1, sizeof(gpuStagingBuffer));
+	if (!sbuf)
+		return NULL;
+	rc = cuMemHostAlloc((void **)&sbuf->hbuf, sz, CU_MEMHOSTALLOC_PORTABLE);
 	if (rc != CUDA_SUCCESS)
-	{
-		gpuClientELog(gclient, "failed on cuMemcpyHtoD: %s", cuStrError(rc));
-		goto error;
-	}
-	if (!gpuDirectFileReadIOV(pathname,
-							  chunk->__base,
-							  chunk->__offset + off,
-							  chunk->mseg->iomap_handle,
-							  kds_iovec,
-							  p_npages_direct_read,
-							  p_npages_vfs_read))
-	{
-		gpuClientELogByExtraModule(gclient);
-		goto error;
-	}
-	return chunk;
-
-error:
-	gpuMemFree(chunk);
+		goto error_0;
+	rc = cuStreamCreate(&sbuf->stream, CU_STREAM_NON_BLOCKING);
+	if (rc != CUDA_SUCCESS)
+		goto error_1;
+	rc = cuEventCreate(&sbuf->event, CU_EVENT_DISABLE_TIMING);
+	if (rc != CUDA_SUCCESS)
+		goto error_2;
+	return sbuf;
+
+error_2:
+	cuStreamDestroy(sbuf->stream);
+error_1:
+	cuMemFreeHost(sbuf->hbuf);
+error_0:
+	GpuServDebug("unable to allocate pinned staging buffer: %s", cuStrError(rc));
+	free(sbuf);
 	return NULL;
 }
 
+static void
+__gpuservStagingBufferPut(gpuContext *gcontext, gpuStagingBuffer *sbuf)
+{
+	pthreadMutexLock(&gcontext->staging_lock);
+	dlist_push_head(&gcontext->staging_free_list, &sbuf->chain);
+	pthreadMutexUnlock(&gcontext->staging_lock);
+}
+
 /*
- * gpuservLoadKdsBlock
+ * __gpuservCopyHostToDevice
  *
- * fill up KDS_FORMAT_BLOCK using GPU-Direct
+ * It copies the host buffer to the device by the two pinned staging buffers
+ * in turn; the memcpy(3) to one buffer overlaps with the DMA from the other
+ * one on its own stream. The worker's stream waits for the DMAs, so the
+ * kernel launched later never starts earlier, but the worker goes ahead to
+ * the GPU-Direct read and the kernel launch without waiting for them.
+ * Small copy, or no staging buffers available, is just cuMemcpyAsync on
+ * the worker's stream.
  */
-static gpuMemChunk *
-gpuservLoadKdsBlock(gpuClient *gclient,
-					kern_data_store *kds,
-					const char *pathname,
-					strom_io_vector *kds_iovec,
-					uint32_t *p_npages_direct_read,
-					uint32_t *p_npages_vfs_read)
+static CUresult
+__gpuservCopyHostToDevice(gpuContext *gcontext,
+						  CUdeviceptr m_dest,
+						  const char *h_src,
+						  size_t nbytes)
 {
-	size_t		base_offset;
+	size_t		unit_sz = (size_t)pgstrom_gpu_staging_buffer_kb << 10;
+	gpuStagingBuffer *sbuf[2] = {NULL, NULL};
+	int			nbufs = 0;
+	size_t		offset;
+	CUresult	rc = CUDA_SUCCESS;
 
-	Assert(kds->format == KDS_FORMAT_BLOCK);
-	base_offset = kds->block_offset + kds->block_nloaded * BLCKSZ;
-	return __gpuservLoadKdsCommon(gclient,
-								  kds,
-								  base_offset,
-								  pathname,
-								  kds_iovec,
-								  p_npages_direct_read,
-								  p_npages_vfs_read);
+	if (unit_sz > 0 && nbytes >= GPUSERV_STAGING_MIN_COPY)
+	{
+		while (nbufs < (nbytes > unit_sz ? 2 : 1) &&
+			   (sbuf[nbufs] = __gpuservStagingBufferGet(gcontext)) != NULL)
+			nbufs++;
+		if (nbufs == 1 && nbytes > unit_sz)
+		{
+			__gpuservStagingBufferPut(gcontext, sbuf[0]);
+			nbufs = 0;
+		}
+	}
+	if (nbufs == 0)
+		return cuMemcpyAsync(m_dest, (CUdeviceptr)h_src, nbytes,
+							 MY_STREAM_PER_THREAD);
+
+	for (offset=0; offset < nbytes; offset += unit_sz)
+	{
+		gpuStagingBuffer *curr = sbuf[(offset / unit_sz) % nbufs];
+		size_t		sz = Min(unit_sz, nbytes - offset);
+
+		/* the former DMA from this buffer must be completed */
+		rc = cuEventSynchronize(curr->event);
+		if (rc != CUDA_SUCCESS)
+			break;
+		memcpy(curr->hbuf, h_src + offset, sz);
+		rc = cuMemcpyHtoDAsync(m_dest + offset, curr->hbuf, sz, curr->stream);
+		if (rc != CUDA_SUCCESS)
+			break;
+		rc = cuEventRecord(curr->event, curr->stream);
+		if (rc != CUDA_SUCCESS)
+			break;
+	}
+	for (int k=0; k < nbufs; k++)
+	{
+		if (rc == CUDA_SUCCESS)
+			rc = cuStreamWaitEvent(MY_STREAM_PER_THREAD, sbuf[k]->event, 0);
+		else
+			(void)cuStreamSynchronize(sbuf[k]->stream);	/* no DMA in flight */
+		__gpuservStagingBufferPut(gcontext, sbuf[k]);
+	}
+	return rc;
 }
 
+
 /*
- * gpuservLoadKdsArrow
+ * __gpuservLoadKdsStriped
  *
- * fill up KDS_FORMAT_ARROW using GPU-Direct
+ * If the file is on md-raid0, the IO vector is split by the stripe chunks,
+ * and distributed to (nmembers x queue_depth) queues; the chunk k goes to
+ * the member (k % nmembers), as long as the file extent is contiguous on
+ * the volume. Each queue is read by a helper thread concurrently, to keep
+ * all the NVMe drives busy. It returns -1 if not applicable.
  */
-static gpuMemChunk *
-gpuservLoadKdsArrow(gpuClient *gclient,
-					kern_data_store *kds,
-					const char *pathname,
-					strom_io_vector *kds_iovec,
-					uint32_t *p_npages_direct_read,
-					uint32_t *p_npages_vfs_read)
+#define GPUDIRECT_STRIPE_MAX_QUEUES		64
+
+typedef struct
 {
-	size_t		base_offset;
+	pthread_t		thread;
+	const char	   *pathname;
+	CUcontext		cuda_context;
+	CUdeviceptr		m_segment;
+	off_t			m_offset;
+	unsigned long	iomap_handle;
+	strom_io_vector *iovec;
+	int				stats_index;
+	gpuDirectIOCounter *io_counter;
+	uint32_t		npages_direct_read;
+	uint32_t		npages_vfs_read;
+	bool			launched;
+	bool			success;
+} gpuservStripeReadTask;
 
-	Assert(kds->format == KDS_FORMAT_ARROW);
-	base_offset = KDS_HEAD_LENGTH(kds);
-	return __gpuservLoadKdsCommon(gclient,
-								  kds,
-								  base_offset,
-								  pathname,
-								  kds_iovec,
-								  p_npages_direct_read,
-								  p_npages_vfs_read);
+static void *
+__gpuservStripeReadWorker(void *__priv)
+{
+	gpuservStripeReadTask *task = __priv;
+	uint64_t	tv1 = __gpuservTimeUsec();
+	uint64_t	nr_pages = 0;
+
+	gpuDirectSetIOCounter(task->io_counter);
+	if (cuCtxSetCurrent(task->cuda_context) == CUDA_SUCCESS)
+		task->success = gpuDirectFileReadIOV(task->pathname,
+											 task->m_segment,
+											 task->m_offset,
+											 task->iomap_handle,
+											 task->iovec,
+											 &task->npages_direct_read,
+											 &task->npages_vfs_read);
+	gpuDirectCleanUpOnThreadTerminate();
+	if (task->success)
+	{
+		for (uint32_t i=0; i < task->iovec->nr_chunks; i++)
+			nr_pages += task->iovec->ioc[i].nr_pages;
+		gpuDirectStripeUpdateStats(task->stats_index,
+								   task->iovec->nr_chunks,
+								   nr_pages,
+								   __gpuservTimeUsec() - tv1);
+	}
+	return NULL;
 }
 
-/* ----------------------------------------------------------------
- *
- * gpuservHandleGpuTaskExec
- *
- * ----------------------------------------------------------------
- */
-static unsigned int
-__expand_gpupreagg_prepfunc_buffer(kern_session_info *session,
-								   int grid_sz, int block_sz,
-								   unsigned int shmem_base_sz,
-								   unsigned int shmem_dynamic_sz,
-								   unsigned int *p_groupby_prepfn_bufsz,
-								   unsigned int *p_groupby_prepfn_nbufs)
+static int
+__gpuservLoadKdsStriped(gpuClient *gclient,
+						const char *pathname,
+						CUdeviceptr m_segment,
+						off_t m_offset,
+						unsigned long iomap_handle,
+						const strom_io_vector *kds_iovec,
+						uint32_t *p_npages_direct_read,
+						uint32_t *p_npages_vfs_read)
 {
-	unsigned int	prepfn_usage;
-	unsigned int	num_buffers;
+	gpuservStripeReadTask tasks[GPUDIRECT_STRIPE_MAX_QUEUES];
+	uint32_t	nitems[GPUDIRECT_STRIPE_MAX_QUEUES];
+	uint32_t	stripe_chunk_sz;
+	uint32_t	stripe_pages;
+	uint32_t	npages_direct_read = 0;
+	uint32_t	npages_vfs_read = 0;
+	int			stripe_nmembers;
+	int			stripe_stats_base;
+	int			depth = pgstrom_gpudirect_stripe_queue_depth;
+	int			nqueues;
+	int			retval = 0;
+
+	if (depth == 0 ||
+		kds_iovec->nr_chunks == 0 ||
+		!gpuDirectHasNativeDriver() ||
+		!GetGpuDirectStripeInfo(pathname,
+								&stripe_chunk_sz,
+								&stripe_nmembers,
+								&stripe_stats_base) ||
+		stripe_nmembers > GPUDIRECT_STRIPE_MAX_QUEUES)
+		return -1;
+	stripe_pages = stripe_chunk_sz / PAGE_SIZE;
+	depth = Min(depth, GPUDIRECT_STRIPE_MAX_QUEUES / stripe_nmembers);
+	nqueues = stripe_nmembers * depth;
+	memset(nitems, 0, sizeof(nitems));
+	memset(tasks, 0, sizeof(tasks));
+
+	/* count the pieces for each queue */
+#define __STRIPE_QUEUE_ID(fchunk_id)							\
+	((((fchunk_id) / stripe_pages) % stripe_nmembers) * depth +	\
+	 (((fchunk_id) / stripe_pages) / stripe_nmembers) % depth)
+	for (uint32_t i=0; i < kds_iovec->nr_chunks; i++)
+	{
+		const strom_io_chunk *ioc = &kds_iovec->ioc[i];
+		uint32_t	pos = ioc->fchunk_id;
+		uint32_t	end = ioc->fchunk_id + ioc->nr_pages;
 
-	shmem_base_sz = TYPEALIGN(1024, shmem_base_sz);
-	if (session->groupby_prepfn_bufsz == 0 || shmem_base_sz >= shmem_dynamic_sz)
-		goto no_prepfunc_buffer;
+		while (pos < end)
+		{
+			uint32_t	next = Min(end, (pos / stripe_pages + 1) * stripe_pages);
 
-	if (session->xpucode_groupby_keyhash &&
-		session->xpucode_groupby_keyload &&
-		session->xpucode_groupby_keycomp)
+			nitems[__STRIPE_QUEUE_ID(pos)]++;
+			pos = next;
+		}
+	}
+	/* no need to split, if all the pieces are on a particular queue */
+	for (int k=0, count=0; k < nqueues; k++)
 	{
-		/* GROUP-BY */
-		num_buffers = 2 * session->groupby_ngroups_estimation + 100;
-		prepfn_usage = session->groupby_prepfn_bufsz * num_buffers;
-		if (shmem_base_sz + prepfn_usage > shmem_dynamic_sz)
+		if (nitems[k] > 0 && ++count > 1)
+			break;
+		if (k == nqueues-1)
+			return -1;
+	}
+	for (int k=0; k < nqueues; k++)
+	{
+		if (nitems[k] == 0)
+			continue;
+		tasks[k].iovec = malloc(offsetof(strom_io_vector, ioc[nitems[k]]));
+		if (!tasks[k].iovec)
 		{
-			/* adjust num_buffers, if too large */
-			num_buffers = (shmem_dynamic_sz -
-						   shmem_base_sz) / session->groupby_prepfn_bufsz;;
-			prepfn_usage = session->groupby_prepfn_bufsz * num_buffers;
+			gpuClientELog(gclient, "out of memory");
+			goto bailout;
 		}
-		Assert(shmem_base_sz + prepfn_usage <= shmem_dynamic_sz);
-		if (num_buffers < 32)
-			goto no_prepfunc_buffer;
+		tasks[k].iovec->nr_chunks = 0;
 	}
-	else
+	/* distribute the pieces */
+	for (uint32_t i=0; i < kds_iovec->nr_chunks; i++)
 	{
-		/* NO-GROUPS */
-		num_buffers = 1;
-		prepfn_usage = session->groupby_prepfn_bufsz;
-		if (shmem_base_sz + prepfn_usage > shmem_dynamic_sz)
-			goto no_prepfunc_buffer;
+		const strom_io_chunk *ioc = &kds_iovec->ioc[i];
+		uint32_t	pos = ioc->fchunk_id;
+		uint32_t	end = ioc->fchunk_id + ioc->nr_pages;
+
+		while (pos < end)
+		{
+			uint32_t	next = Min(end, (pos / stripe_pages + 1) * stripe_pages);
+			strom_io_vector *iovec = tasks[__STRIPE_QUEUE_ID(pos)].iovec;
+			strom_io_chunk *piece = &iovec->ioc[iovec->nr_chunks++];
+
+			piece->m_offset  = ioc->m_offset + (size_t)(pos - ioc->fchunk_id) * PAGE_SIZE;
+			piece->fchunk_id = pos;
+			piece->nr_pages  = next - pos;
+			pos = next;
+		}
 	}
-	*p_groupby_prepfn_bufsz = session->groupby_prepfn_bufsz;
-	*p_groupby_prepfn_nbufs = num_buffers;
-	return shmem_base_sz + prepfn_usage;
+#undef __STRIPE_QUEUE_ID
+	/* kick the helper threads */
+	for (int k=0; k < nqueues; k++)
+	{
+		gpuservStripeReadTask *task = &tasks[k];
 
-no_prepfunc_buffer:
-	*p_groupby_prepfn_bufsz = 0;
-	*p_groupby_prepfn_nbufs = 0;
-	return shmem_base_sz;
+		if (!task->iovec)
+			continue;
+		task->pathname     = pathname;
+		task->cuda_context = MY_CONTEXT_PER_THREAD;
+		task->m_segment    = m_segment;
+		task->m_offset     = m_offset;
+		task->iomap_handle = iomap_handle;
+		task->stats_index  = (stripe_stats_base < 0 ? -1 :
+							  stripe_stats_base + k / depth);
+		task->io_counter   = gpuDirectGetIOCounter();
+		if (pthread_create(&task->thread, NULL,
+						   __gpuservStripeReadWorker, task) == 0)
+			task->launched = true;
+	}
+	/*
+	 * Wait for the completion. If any helper threads could not be launched,
+	 * or failed, we read the piece again by ourselves to report the error
+	 * status of the extra module on this thread.
+	 */
+	retval = 1;
+	for (int k=0; k < nqueues; k++)
+	{
+		gpuservStripeReadTask *task = &tasks[k];
+
+		if (!task->iovec)
+			continue;
+		if (task->launched)
+			pthread_join(task->thread, NULL);
+		if (!task->success)
+		{
+			task->npages_direct_read = 0;
+			task->npages_vfs_read = 0;
+			if (retval > 0 &&
+				!gpuDirectFileReadIOV(pathname,
+									  m_segment,
+									  m_offset,
+									  iomap_handle,
+									  task->iovec,
+									  &task->npages_direct_read,
+									  &task->npages_vfs_read))
+			{
+				gpuClientELogByExtraModule(gclient);
+				retval = 0;
+			}
+		}
+		npages_direct_read += task->npages_direct_read;
+		npages_vfs_read    += task->npages_vfs_read;
+	}
+	if (retval > 0)
+	{
+		*p_npages_direct_read = npages_direct_read;
+		*p_npages_vfs_read    = npages_vfs_read;
+	}
+bailout:
+	for (int k=0; k < nqueues; k++)
+	{
+		if (tasks[k].iovec)
+			free(tasks[k].iovec);
+	}
+	return retval;
 }
 
+/*
+ * __gpuservSharedScanAttach / Detach
+ */
 static void
-gpuservHandleGpuTaskExec(gpuClient *gclient, XpuCommand *xcmd)
+__gpuservSharedScanAttach(gpuClient *gclient)
 {
-	gpuContext		*gcontext = gclient->gcontext;
-	kern_session_info *session = gclient->session;
-	gpuQueryBuffer  *gq_buf = gclient->gq_buf;
-	kern_gputask	*kgtask = NULL;
-	const char		*kds_src_pathname = NULL;
-	strom_io_vector *kds_src_iovec = NULL;
-	kern_data_store *kds_src = NULL;
-	kern_data_store *kds_dst = NULL;
-	kern_data_store *kds_dst_head = NULL;
-	kern_data_store **kds_dst_array = NULL;
-	int				kds_dst_nrooms = 0;
-	int				kds_dst_nitems = 0;
-	int				num_inner_rels = 0;
-	uint32_t		npages_direct_read = 0;
-	uint32_t		npages_vfs_read = 0;
-	CUfunction		f_kern_gpuscan;
-	void		   *gc_lmap = NULL;
-	gpuMemChunk	   *s_chunk = NULL;		/* for kds_src */
-	gpuMemChunk	   *t_chunk = NULL;		/* for kern_gputask */
-	gpuMemChunk	  **d_chunk_array = NULL; /* for kds_dst_array */
-	CUdeviceptr		m_kds_src = 0UL;
-	CUdeviceptr		m_kds_extra = 0UL;
-	CUdeviceptr		m_kmrels = 0UL;
-	CUresult		rc;
-	int				grid_sz;
-	int				block_sz;
-	unsigned int	shmem_sz;
-	unsigned int	groupby_prepfn_bufsz = 0;
-	unsigned int	groupby_prepfn_nbufs = 0;
-	size_t			kds_final_length = 0;
-	bool			kds_final_locked = false;
-	size_t			sz;
-	void		   *kern_args[10];
+	uint32_t	expected = 0;
 
-	if (xcmd->u.task.kds_src_pathname)
-		kds_src_pathname = (char *)xcmd + xcmd->u.task.kds_src_pathname;
-	if (xcmd->u.task.kds_src_iovec)
-		kds_src_iovec = (strom_io_vector *)((char *)xcmd + xcmd->u.task.kds_src_iovec);
-	if (xcmd->u.task.kds_src_offset)
-		kds_src = (kern_data_store *)((char *)xcmd + xcmd->u.task.kds_src_offset);
-	if (xcmd->u.task.kds_dst_offset)
-		kds_dst_head = (kern_data_store *)((char *)xcmd + xcmd->u.task.kds_dst_offset);
-	if (!kds_src)
+	if (pg_atomic_compare_exchange_u32(&gclient->shared_scan_attached,
+									   &expected, 1))
+		pg_atomic_fetch_add_u32(&gclient->gcontext->shared_scan_nclients, 1);
+}
+
+static void
+__gpuservSharedScanDetach(gpuClient *gclient)
+{
+	if (pg_atomic_exchange_u32(&gclient->shared_scan_attached, 0) != 0)
+		pg_atomic_fetch_sub_u32(&gclient->gcontext->shared_scan_nclients, 1);
+}
+
+static inline bool
+__gpuservSharedScanMatch(const gpuSharedScanBuffer *entry,
+						 const struct stat *st_buf,
+						 const strom_io_chunk *ioc)
+{
+	return (entry->st_dev  == st_buf->st_dev &&
+			entry->st_ino  == st_buf->st_ino &&
+			entry->st_size == st_buf->st_size &&
+			entry->st_mtim.tv_sec  == st_buf->st_mtim.tv_sec &&
+			entry->st_mtim.tv_nsec == st_buf->st_mtim.tv_nsec &&
+			entry->fchunk_id <= ioc->fchunk_id &&
+			entry->fchunk_id + entry->nr_pages >= ioc->fchunk_id + ioc->nr_pages);
+}
+
+/*
+ * __gpuservSharedScanLookup
+ *
+ * It copies the extents already on the shared-scan buffer to the chunk,
+ * and returns the IO vector of the remaining extents to be read from the
+ * storage. The entries referenced are saved on the 'hits' array, and must
+ * be released by __gpuservSharedScanRelease after the stream completion.
+ */
+static strom_io_vector *
+__gpuservSharedScanLookup(gpuClient *gclient,
+						  const struct stat *st_buf,
+						  CUdeviceptr m_base,
+						  off_t m_offset,
+						  const strom_io_vector *kds_iovec,
+						  gpuSharedScanBuffer **hits,
+						  uint32_t *p_nhits)
+{
+	gpuContext	   *gcontext = gclient->gcontext;
+	strom_io_vector *iovec;
+	uint32_t		nhits = 0;
+
+	iovec = malloc(offsetof(strom_io_vector, ioc[kds_iovec->nr_chunks]));
+	if (!iovec)
+		return NULL;
+	iovec->nr_chunks = 0;
+
+	pthreadMutexLock(&gcontext->shared_scan_lock);
+	for (uint32_t i=0; i < kds_iovec->nr_chunks; i++)
 	{
-		const GpuCacheIdent *ident = (GpuCacheIdent *)xcmd->u.task.data;
-		char		errbuf[120];
+		const strom_io_chunk *ioc = &kds_iovec->ioc[i];
+		gpuSharedScanBuffer *entry = NULL;
+		dlist_iter	iter;
 
-		Assert(xcmd->tag == XpuCommandTag__XpuTaskExecGpuCache);
-		gc_lmap = gpuCacheGetDeviceBuffer(ident,
-										  &m_kds_src,
-										  &m_kds_extra,
-										  errbuf, sizeof(errbuf));
-		if (!gc_lmap)
+		dlist_foreach (iter, &gcontext->shared_scan_list)
 		{
-			gpuClientELog(gclient, "no GpuCache (dat=%u,rel=%u,sig=%09lx) found - %s",
-						  ident->database_oid,
-						  ident->table_oid,
-						  ident->signature,
-						  errbuf);
-			return;
+			gpuSharedScanBuffer *temp = dlist_container(gpuSharedScanBuffer,
+														chain, iter.cur);
+			if (__gpuservSharedScanMatch(temp, st_buf, ioc))
+			{
+				entry = temp;
+				break;
+			}
 		}
-	}
-	else if (kds_src->format == KDS_FORMAT_ROW)
-	{
-		m_kds_src = (CUdeviceptr)kds_src;
-	}
-	else if (kds_src->format == KDS_FORMAT_BLOCK)
-	{
-		if (kds_src_pathname && kds_src_iovec)
+		if (entry &&
+			cuMemcpyDtoDAsync(m_base + m_offset + ioc->m_offset,
+							  entry->chunk->m_devptr +
+							  (size_t)(ioc->fchunk_id - entry->fchunk_id) * PAGE_SIZE,
+							  (size_t)ioc->nr_pages * PAGE_SIZE,
+							  MY_STREAM_PER_THREAD) == CUDA_SUCCESS)
 		{
-			s_chunk = gpuservLoadKdsBlock(gclient,
-										  kds_src,
-										  kds_src_pathname,
-										  kds_src_iovec,
-										  &npages_direct_read,
-										  &npages_vfs_read);
-			if (!s_chunk)
-				return;
-			m_kds_src = s_chunk->m_devptr;
+			entry->refcnt++;
+			dlist_move_head(&gcontext->shared_scan_list, &entry->chain);
+			hits[nhits++] = entry;
 		}
 		else
 		{
-			Assert(kds_src->block_nloaded == kds_src->nitems);
-			m_kds_src = (CUdeviceptr)kds_src;
+			memcpy(&iovec->ioc[iovec->nr_chunks++], ioc, sizeof(strom_io_chunk));
 		}
 	}
-	else if (kds_src->format == KDS_FORMAT_ARROW)
+	pthreadMutexUnlock(&gcontext->shared_scan_lock);
+	*p_nhits = nhits;
+
+	return iovec;
+}
+
+/*
+ * __gpuservSharedScanInsert
+ *
+ * It keeps the copy of the extents just read from the storage, only if
+ * other sessions are also scanning arrow files on this device.
+ */
+static void
+__gpuservSharedScanInsert(gpuClient *gclient,
+						  const struct stat *st_buf,
+						  CUdeviceptr m_base,
+						  off_t m_offset,
+						  const strom_io_vector *iovec)
+{
+	gpuContext	   *gcontext = gclient->gcontext;
+	size_t			limit = ((size_t)pgstrom_gpu_shared_scan_buffer_mb << 20);
+	gpuSharedScanBuffer **entries;
+	uint32_t		nitems = 0;
+
+	if (pg_atomic_read_u32(&gcontext->shared_scan_nclients) < 2 ||
+		iovec->nr_chunks == 0)
+		return;
+	entries = alloca(sizeof(gpuSharedScanBuffer *) * iovec->nr_chunks);
+	for (uint32_t i=0; i < iovec->nr_chunks; i++)
 	{
-		if (kds_src_iovec->nr_chunks == 0)
-			m_kds_src = (CUdeviceptr)kds_src;
-		else
+		const strom_io_chunk *ioc = &iovec->ioc[i];
+		size_t		sz = (size_t)ioc->nr_pages * PAGE_SIZE;
+		gpuSharedScanBuffer *entry;
+
+		if (sz > limit / 4)
+			continue;	/* too large extent to keep */
+		entry = calloc(1, sizeof(gpuSharedScanBuffer));
+		if (!entry)
+			break;
+		entry->chunk = gpuMemAlloc(sz);
+		if (!entry->chunk)
 		{
-			if (!kds_src_pathname)
-			{
-				gpuClientELog(gclient, "GpuScan: arrow file is missing");
-				return;
-			}
-			s_chunk = gpuservLoadKdsArrow(gclient,
-										  kds_src,
-										  kds_src_pathname,
-										  kds_src_iovec,
-										  &npages_direct_read,
-										  &npages_vfs_read);
-			if (!s_chunk)
-				return;
-			m_kds_src = s_chunk->m_devptr;
+			free(entry);
+			break;
+		}
+		if (cuMemcpyDtoDAsync(entry->chunk->m_devptr,
+							  m_base + m_offset + ioc->m_offset,
+							  sz,
+							  MY_STREAM_PER_THREAD) != CUDA_SUCCESS)
+		{
+			gpuMemFree(entry->chunk);
+			free(entry);
+			break;
 		}
+		entry->st_dev    = st_buf->st_dev;
+		entry->st_ino    = st_buf->st_ino;
+		entry->st_size   = st_buf->st_size;
+		entry->st_mtim   = st_buf->st_mtim;
+		entry->fchunk_id = ioc->fchunk_id;
+		entry->nr_pages  = ioc->nr_pages;
+		entries[nitems++] = entry;
 	}
-	else
+	if (nitems == 0)
+		return;
+	/* the entries must be filled up prior to the publication */
+	if (cuStreamSynchronize(MY_STREAM_PER_THREAD) != CUDA_SUCCESS)
 	{
-		gpuClientELog(gclient, "unknown GpuScan Source format (%c)",
-					  kds_src->format);
+		for (uint32_t i=0; i < nitems; i++)
+		{
+			gpuMemFree(entries[i]->chunk);
+			free(entries[i]);
+		}
 		return;
 	}
-	/* inner buffer of GpuJoin */
-	if (gq_buf && gq_buf->m_kmrels)
+	pthreadMutexLock(&gcontext->shared_scan_lock);
+	for (uint32_t i=0; i < nitems; i++)
 	{
-		kern_multirels *h_kmrels = (kern_multirels *)gq_buf->h_kmrels;
+		gpuSharedScanBuffer *entry = entries[i];
 
-		m_kmrels = gq_buf->m_kmrels;
-		num_inner_rels = h_kmrels->num_rels;
+		dlist_push_head(&gcontext->shared_scan_list, &entry->chain);
+		gcontext->shared_scan_usage += entry->chunk->__length;
 	}
-
-	rc = cuModuleGetFunction(&f_kern_gpuscan,
-							 gcontext->cuda_module,
-							 "kern_gpujoin_main");
-	if (rc != CUDA_SUCCESS)
+	/* evict the older entries not referenced */
+	if (gcontext->shared_scan_usage > limit)
 	{
-		gpuClientFatal(gclient, "failed on cuModuleGetFunction: %s",
-					   cuStrError(rc));
-		goto bailout;
+		dlist_node *dnode = dlist_tail_node(&gcontext->shared_scan_list);
+
+		while (dnode && gcontext->shared_scan_usage > limit)
+		{
+			gpuSharedScanBuffer *entry = dlist_container(gpuSharedScanBuffer,
+														 chain, dnode);
+			dnode = (dlist_has_prev(&gcontext->shared_scan_list, dnode)
+					 ? dlist_prev_node(&gcontext->shared_scan_list, dnode)
+					 : NULL);
+			if (entry->refcnt > 0)
+				continue;
+			dlist_delete(&entry->chain);
+			gcontext->shared_scan_usage -= entry->chunk->__length;
+			gpuMemFree(entry->chunk);
+			free(entry);
+		}
 	}
+	pthreadMutexUnlock(&gcontext->shared_scan_lock);
+}
 
-	rc = gpuOptimalBlockSize(&grid_sz,
-							 &block_sz,
-							 &shmem_sz,
-							 f_kern_gpuscan,
-							 0,
-							 __KERN_WARP_CONTEXT_BASESZ(session->kcxt_kvecs_ndims));
-	if (rc != CUDA_SUCCESS)
+/*
+ * __gpuservSharedScanRelease
+ */
+static void
+__gpuservSharedScanRelease(gpuClient *gclient,
+						   gpuSharedScanBuffer **hits, uint32_t nhits)
+{
+	gpuContext	   *gcontext = gclient->gcontext;
+
+	if (nhits == 0)
+		return;
+	pthreadMutexLock(&gcontext->shared_scan_lock);
+	for (uint32_t i=0; i < nhits; i++)
 	{
-		gpuClientFatal(gclient, "failed on gpuOptimalBlockSize: %s",
-					   cuStrError(rc));
-		goto bailout;
+		Assert(hits[i]->refcnt > 0);
+		hits[i]->refcnt--;
 	}
-//	block_sz = 128;
-//	grid_sz = 1;
+	pthreadMutexUnlock(&gcontext->shared_scan_lock);
+}
 
-	/* allocation of extra shared memory for GpuPreAgg (if any) */
-	shmem_sz = __expand_gpupreagg_prepfunc_buffer(session,
-												  grid_sz, block_sz,
-												  shmem_sz,
-												  gcontext->gpumain_shmem_sz_dynamic,
-												  &groupby_prepfn_bufsz,
-												  &groupby_prepfn_nbufs);
-	/*
-	 * Allocation of the control structure
-	 */
-	sz = KERN_GPUTASK_LENGTH(session->kcxt_kvecs_ndims,
-							 session->kcxt_kvecs_bufsz,
-							 grid_sz, block_sz);
-	t_chunk = gpuMemAllocManaged(sz);
-	if (!t_chunk)
+/*
+ * __gpuservShmemSegmentRelease
+ */
+static void
+__gpuservShmemSegmentRelease(gpuShmemSegment *entry)
+{
+	CUresult	rc;
+
+	rc = cuMemHostUnregister(entry->mmap_addr);
+	if (rc != CUDA_SUCCESS)
+		GpuServDebug("failed on cuMemHostUnregister: %s", cuStrError(rc));
+	munmap(entry->mmap_addr, entry->mmap_sz);
+	free(entry);
+}
+
+/*
+ * __gpuservShmemSegmentGet
+ *
+ * It looks up the mapping of the segment that covers the 'required' bytes,
+ * or maps and registers the segment newly.
+ */
+static gpuShmemSegment *
+__gpuservShmemSegmentGet(gpuClient *gclient,
+						 const char *pathname, size_t required)
+{
+	gpuContext	   *gcontext = gclient->gcontext;
+	gpuShmemSegment *entry = NULL;
+	struct stat		st_buf;
+	dlist_iter		iter;
+	dlist_node	   *dnode;
+	int				fdesc;
+	CUresult		rc;
+
+	fdesc = open(pathname, O_RDONLY);
+	if (fdesc < 0)
+		return NULL;
+	if (fstat(fdesc, &st_buf) != 0 ||
+		PAGE_ALIGN(st_buf.st_size) < required)
 	{
-		gpuClientFatal(gclient, "failed on gpuMemAllocManaged: %lu", sz);
-		goto bailout;
+		close(fdesc);
+		return NULL;
 	}
-	kgtask = (kern_gputask *)t_chunk->m_devptr;
-	memset(kgtask, 0, offsetof(kern_gputask, stats[num_inner_rels]));
-	kgtask->grid_sz  = grid_sz;
-	kgtask->block_sz = block_sz;
-	kgtask->kvars_nslots = session->kcxt_kvars_nslots;
-	kgtask->kvecs_bufsz  = session->kcxt_kvecs_bufsz;
-	kgtask->kvecs_ndims  = session->kcxt_kvecs_ndims;
-	kgtask->n_rels       = num_inner_rels;
-	kgtask->groupby_prepfn_bufsz = groupby_prepfn_bufsz;
-	kgtask->groupby_prepfn_nbufs = groupby_prepfn_nbufs;
-
-	/* prefetch source KDS, if managed memory */
-	if (!s_chunk && !gc_lmap)
+	pthreadMutexLock(&gcontext->shmem_segment_lock);
+	dlist_foreach (iter, &gcontext->shmem_segment_list)
 	{
-		rc = cuMemPrefetchAsync((CUdeviceptr)kds_src,
-								kds_src->length,
-								MY_DEVICE_PER_THREAD,
-								MY_STREAM_PER_THREAD);
-		if (rc != CUDA_SUCCESS)
+		gpuShmemSegment *temp = dlist_container(gpuShmemSegment,
+												chain, iter.cur);
+		if (temp->st_dev == st_buf.st_dev &&
+			temp->st_ino == st_buf.st_ino &&
+			temp->mmap_sz >= required)
 		{
-			gpuClientFatal(gclient, "failed on cuMemPrefetchAsync: %s",
-						   cuStrError(rc));
-			goto bailout;
+			temp->refcnt++;
+			dlist_move_head(&gcontext->shmem_segment_list, &temp->chain);
+			entry = temp;
+			break;
 		}
 	}
+	pthreadMutexUnlock(&gcontext->shmem_segment_lock);
+	if (entry)
+	{
+		close(fdesc);
+		return entry;
+	}
 
 	/*
-	 * Allocation of the destination buffer
+	 * Map the whole segment; the tail of the last page beyond the EOF is
+	 * filled by zero, so the page aligned extents are accessible.
 	 */
-resume_kernel:
-	if (gq_buf && gq_buf->m_kds_final)
+	entry = calloc(1, sizeof(gpuShmemSegment));
+	if (!entry)
 	{
-		/*
-		 * Suspend of GpuPreAgg kernel means the kds_final buffer is
-		 * almost full, thus GPU kernel wants to expand the buffer.
-		 * It must be done under the exclusive lock.
-		 */
-		if (kgtask->resume_context)
+		close(fdesc);
+		return NULL;
+	}
+	entry->st_dev = st_buf.st_dev;
+	entry->st_ino = st_buf.st_ino;
+	entry->mmap_sz = PAGE_ALIGN(st_buf.st_size);
+	entry->mmap_addr = mmap(NULL, entry->mmap_sz,
+							PROT_READ, MAP_SHARED,
+							fdesc, 0);
+	close(fdesc);
+	if (entry->mmap_addr == MAP_FAILED)
+	{
+		GpuServDebug("failed on mmap('%s', %zu): %m", pathname, entry->mmap_sz);
+		free(entry);
+		return NULL;
+	}
+	rc = cuMemHostRegister(entry->mmap_addr, entry->mmap_sz,
+						   CU_MEMHOSTREGISTER_PORTABLE |
+						   CU_MEMHOSTREGISTER_READ_ONLY);
+	if (rc != CUDA_SUCCESS)
+	{
+		GpuServDebug("failed on cuMemHostRegister('%s', %zu): %s",
+					 pathname, entry->mmap_sz, cuStrError(rc));
+		munmap(entry->mmap_addr, entry->mmap_sz);
+		free(entry);
+		return NULL;
+	}
+	entry->refcnt = 1;
+
+	pthreadMutexLock(&gcontext->shmem_segment_lock);
+	dlist_push_head(&gcontext->shmem_segment_list, &entry->chain);
+	gcontext->shmem_segment_nitems++;
+	/* evict the older entries not referenced, and the shorter mappings */
+	dnode = dlist_tail_node(&gcontext->shmem_segment_list);
+	while (dnode)
+	{
+		gpuShmemSegment *temp = dlist_container(gpuShmemSegment,
+												chain, dnode);
+		dnode = (dlist_has_prev(&gcontext->shmem_segment_list, dnode)
+				 ? dlist_prev_node(&gcontext->shmem_segment_list, dnode)
+				 : NULL);
+		if (temp == entry || temp->refcnt > 0)
+			continue;
+		if (gcontext->shmem_segment_nitems > GPUSERV_SHMEM_SEGMENT_MAX_NITEMS ||
+			(temp->st_dev == entry->st_dev &&
+			 temp->st_ino == entry->st_ino))
 		{
-			if (!__expandGpuQueryGroupByBuffer(gq_buf, kds_final_length))
-			{
-				gpuClientFatal(gclient, "unable to expand GpuPreAgg final buffer");
-				goto bailout;
-			}
+			dlist_delete(&temp->chain);
+			gcontext->shmem_segment_nitems--;
+			__gpuservShmemSegmentRelease(temp);
+		}
+	}
+	pthreadMutexUnlock(&gcontext->shmem_segment_lock);
+
+	return entry;
+}
+
+/*
+ * __gpuservLoadKdsShmem
+ *
+ * It loads the extents on the arrow shared memory segment by DMA from the
+ * registered host memory. It returns 1 on success, 0 on error, or -1 if
+ * not applicable; then, the caller reads the file as usual.
+ */
+static int
+__gpuservLoadKdsShmem(gpuClient *gclient,
+					  const char *pathname,
+					  CUdeviceptr m_segment,
+					  off_t m_offset,
+					  const strom_io_vector *kds_iovec,
+					  uint32_t *p_npages_direct_read,
+					  uint32_t *p_npages_vfs_read)
+{
+	gpuContext	   *gcontext = gclient->gcontext;
+	gpuShmemSegment *entry;
+	const char	   *pos = strrchr(pathname, '.');
+	size_t			required = 0;
+	uint32_t		npages = 0;
+	CUresult		rc = CUDA_SUCCESS;
+
+	if (!pos || strcmp(pos+1, ARROW_SHMEM_SUFFIX) != 0 ||
+		kds_iovec->nr_chunks == 0)
+		return -1;
+	for (uint32_t i=0; i < kds_iovec->nr_chunks; i++)
+	{
+		const strom_io_chunk *ioc = &kds_iovec->ioc[i];
+		size_t		end = (size_t)(ioc->fchunk_id + ioc->nr_pages) * PAGE_SIZE;
+
+		required = Max(required, end);
+	}
+	entry = __gpuservShmemSegmentGet(gclient, pathname, required);
+	if (!entry)
+		return -1;
+	for (uint32_t i=0; i < kds_iovec->nr_chunks; i++)
+	{
+		const strom_io_chunk *ioc = &kds_iovec->ioc[i];
+
+		rc = cuMemcpyHtoDAsync(m_segment + m_offset + ioc->m_offset,
+							   entry->mmap_addr + (size_t)ioc->fchunk_id * PAGE_SIZE,
+							   (size_t)ioc->nr_pages * PAGE_SIZE,
+							   MY_STREAM_PER_THREAD);
+		if (rc != CUDA_SUCCESS)
+			break;
+		npages += ioc->nr_pages;
+	}
+	/* copies from the segment must be done prior to release */
+	if (rc == CUDA_SUCCESS)
+		rc = cuStreamSynchronize(MY_STREAM_PER_THREAD);
+	else
+		(void)cuStreamSynchronize(MY_STREAM_PER_THREAD);
+	pthreadMutexLock(&gcontext->shmem_segment_lock);
+	Assert(entry->refcnt > 0);
+	entry->refcnt--;
+	pthreadMutexUnlock(&gcontext->shmem_segment_lock);
+	if (rc != CUDA_SUCCESS)
+	{
+		gpuClientELog(gclient, "failed on cuMemcpyHtoDAsync('%s'): %s",
+					  pathname, cuStrError(rc));
+		return 0;
+	}
+	*p_npages_direct_read = npages;
+	*p_npages_vfs_read    = 0;
+	return 1;
+}
+
+static gpuMemChunk *
+__gpuservLoadKdsCommon(gpuClient *gclient,
+					   kern_data_store *kds,
+					   size_t base_offset,
+					   const char *pathname,
+					   strom_io_vector *kds_iovec,
+					   bool try_shared_scan,
+					   uint32_t *p_npages_direct_read,
+					   uint32_t *p_npages_vfs_read)
+{
+	gpuMemChunk *chunk;
+	CUresult	rc;
+	off_t		off = PAGE_ALIGN(base_offset);
+	size_t		gap = off - base_offset;
+	struct stat	st_buf;
+	strom_io_vector *iovec_saved = NULL;
+	gpuSharedScanBuffer **hits = NULL;
+	uint32_t	nhits = 0;
+
+	chunk = gpuMemAlloc(gap + kds->length);
+	if (!chunk)
+	{
+		gpuClientELog(gclient, "failed on gpuMemAlloc(%zu)", kds->length);
+		return NULL;
+	}
+	chunk->m_devptr = chunk->__base + chunk->__offset + gap;
+
+	/*
+	 * The KDS head (and blocks already loaded on the host, if any) are
+	 * copied asynchronously through the pinned staging buffers, so the
+	 * transfer overlaps with the GPU-Direct read below; the kernel shall
+	 * be launched on the worker's stream, that waits for the copy.
+	 * Note that kds is a part of the command buffer on the managed memory
+	 * that is preallocated by the memory pool.
+	 */
+	rc = __gpuservCopyHostToDevice(gclient->gcontext,
+								   chunk->m_devptr,
+								   (const char *)kds,
+								   base_offset);
+	if (rc != CUDA_SUCCESS)
+	{
+		gpuClientELog(gclient, "failed on copy of KDS head: %s", cuStrError(rc));
+		goto error;
+	}
+	/* arrow shared memory segment is copied from the host memory */
+	switch (__gpuservLoadKdsShmem(gclient,
+								  pathname,
+								  chunk->__base,
+								  chunk->__offset + off,
+								  kds_iovec,
+								  p_npages_direct_read,
+								  p_npages_vfs_read))
+	{
+		case 0:
+			goto error;
+		case 1:
+			return chunk;
+		default:
+			break;
+	}
+	/* pick up the extents already loaded by the concurrent sessions */
+	if (try_shared_scan &&
+		pgstrom_gpu_shared_scan_buffer_mb > 0 &&
+		kds_iovec->nr_chunks > 0 &&
+		stat(pathname, &st_buf) == 0)
+	{
+		strom_io_vector *iovec;
+
+		__gpuservSharedScanAttach(gclient);
+		hits = alloca(sizeof(gpuSharedScanBuffer *) * kds_iovec->nr_chunks);
+		iovec = __gpuservSharedScanLookup(gclient,
+										  &st_buf,
+										  chunk->__base,
+										  chunk->__offset + off,
+										  kds_iovec,
+										  hits, &nhits);
+		if (iovec)
+		{
+			iovec_saved = iovec;
+			kds_iovec = iovec;
+		}
+	}
+	if (kds_iovec->nr_chunks == 0)
+		goto out;	/* all the extents are on the shared-scan buffer */
+	switch (__gpuservLoadKdsStriped(gclient,
+									pathname,
+									chunk->__base,
+									chunk->__offset + off,
+									chunk->mseg->iomap_handle,
+									kds_iovec,
+									p_npages_direct_read,
+									p_npages_vfs_read))
+	{
+		case 0:
+			goto error;
+		case 1:
+			break;
+		default:
+			if (!gpuDirectFileReadIOV(pathname,
+									  chunk->__base,
+									  chunk->__offset + off,
+									  chunk->mseg->iomap_handle,
+									  kds_iovec,
+									  p_npages_direct_read,
+									  p_npages_vfs_read))
+			{
+				gpuClientELogByExtraModule(gclient);
+				goto error;
+			}
+			break;
+	}
+	if (iovec_saved)
+		__gpuservSharedScanInsert(gclient,
+								  &st_buf,
+								  chunk->__base,
+								  chunk->__offset + off,
+								  kds_iovec);
+out:
+	if (nhits > 0)
+	{
+		/* copies from the shared-scan buffer must be done prior to release */
+		rc = cuStreamSynchronize(MY_STREAM_PER_THREAD);
+		__gpuservSharedScanRelease(gclient, hits, nhits);
+		if (rc != CUDA_SUCCESS)
+		{
+			gpuClientELog(gclient, "failed on cuStreamSynchronize: %s",
+						  cuStrError(rc));
+			free(iovec_saved);
+			gpuMemFree(chunk);
+			return NULL;
+		}
+	}
+	if (iovec_saved)
+		free(iovec_saved);
+	return chunk;
+
+error:
+	/* ensure no pending copy onto the chunk */
+	(void)cuStreamSynchronize(MY_STREAM_PER_THREAD);
+	__gpuservSharedScanRelease(gclient, hits, nhits);
+	if (iovec_saved)
+		free(iovec_saved);
+	gpuMemFree(chunk);
+	return NULL;
+}
+
+/*
+ * gpuservLoadKdsBlock
+ *
+ * fill up KDS_FORMAT_BLOCK using GPU-Direct
+ */
+static gpuMemChunk *
+gpuservLoadKdsBlock(gpuClient *gclient,
+					kern_data_store *kds,
+					const char *pathname,
+					strom_io_vector *kds_iovec,
+					uint32_t *p_npages_direct_read,
+					uint32_t *p_npages_vfs_read)
+{
+	size_t		base_offset;
+
+	Assert(kds->format == KDS_FORMAT_BLOCK);
+	base_offset = kds->block_offset + kds->block_nloaded * BLCKSZ;
+	return __gpuservLoadKdsCommon(gclient,
+								  kds,
+								  base_offset,
+								  pathname,
+								  kds_iovec,
+								  false,	/* heap may be updated */
+								  p_npages_direct_read,
+								  p_npages_vfs_read);
+}
+
+/*
+ * gpuservLoadKdsArrow
+ *
+ * fill up KDS_FORMAT_ARROW using GPU-Direct
+ */
+static gpuMemChunk *
+gpuservLoadKdsArrow(gpuClient *gclient,
+					kern_data_store *kds,
+					const char *pathname,
+					strom_io_vector *kds_iovec,
+					uint32_t *p_npages_direct_read,
+					uint32_t *p_npages_vfs_read)
+{
+	size_t		base_offset;
+
+	Assert(kds->format == KDS_FORMAT_ARROW);
+	base_offset = KDS_HEAD_LENGTH(kds);
+	return __gpuservLoadKdsCommon(gclient,
+								  kds,
+								  base_offset,
+								  pathname,
+								  kds_iovec,
+								  true,
+								  p_npages_direct_read,
+								  p_npages_vfs_read);
+}
+
+/* ----------------------------------------------------------------
+ *
+ * gpuservArrowReadAheadMain - read-ahead of the arrow record-batches
+ *
+ * pg_strom.max_async_tasks bounds the number of GPU tasks in execution,
+ * and each worker loads the record-batch then runs the kernel, so the
+ * reads are issued only as many as the kernels. It is too shallow to
+ * saturate the NVMe drives with small record-batches.
+ * The read-ahead threads pick up the GpuTasks on the arrow files first,
+ * load the record-batch onto the device memory (staging), then hand over
+ * the task to the workers. The number of reads in flight is adjusted by
+ * the measured latency and record-batch size, and the staged device memory
+ * is bounded by pg_strom.arrow_readahead_staging_size.
+ *
+ * ----------------------------------------------------------------
+ */
+#define GPUSERV_READAHEAD_WINDOW	16
+
+/*
+ * __gpuservReadAheadUpdateDepth
+ *
+ * Little's law gives the reads in flight to keep the drives busy; that is
+ * (bandwidth x latency / record-batch size). The bandwidth is the best one
+ * in the recent windows, so one more read is kept in flight than the
+ * estimation, to probe whether the drives have more margin.
+ *
+ * MEMO: caller must hold the gcontext->lock
+ */
+static void
+__gpuservReadAheadUpdateDepth(gpuContext *gcontext, size_t length,
+							  uint64_t tv_begin, uint64_t tv_end)
+{
+	double		latency = (double)Max(tv_end - tv_begin, 1);
+	double		bandwidth;
+	double		depth;
+
+	if (gcontext->ra_window_count == 0)
+	{
+		gcontext->ra_window_start = tv_begin;
+		gcontext->ra_window_bytes = 0;
+	}
+	gcontext->ra_window_bytes += length;
+	if (gcontext->ra_latency_avg == 0.0)
+	{
+		gcontext->ra_latency_avg = latency;
+		gcontext->ra_length_avg = (double)length;
+	}
+	else
+	{
+		gcontext->ra_latency_avg = 0.875 * gcontext->ra_latency_avg + 0.125 * latency;
+		gcontext->ra_length_avg = 0.875 * gcontext->ra_length_avg + 0.125 * (double)length;
+	}
+	if (++gcontext->ra_window_count < GPUSERV_READAHEAD_WINDOW)
+		return;
+	gcontext->ra_window_count = 0;
+	if (tv_end <= gcontext->ra_window_start)
+		return;
+	bandwidth = ((double)gcontext->ra_window_bytes /
+				 (double)(tv_end - gcontext->ra_window_start));
+	/* decays slowly, to follow the changes of the workloads */
+	if (bandwidth > gcontext->ra_bandwidth)
+		gcontext->ra_bandwidth = bandwidth;
+	else
+		gcontext->ra_bandwidth = 0.95 * gcontext->ra_bandwidth + 0.05 * bandwidth;
+	depth = ceil(gcontext->ra_bandwidth *
+				 gcontext->ra_latency_avg /
+				 Max(gcontext->ra_length_avg, 1.0)) + 1.0;
+	gcontext->ra_depth = Max(Min(depth, (double)pgstrom_arrow_readahead_threads), 1.0);
+}
+
+/*
+ * __gpuservReadAheadOne
+ */
+static gpuMemChunk *
+__gpuservReadAheadOne(gpuServXpuCommandPacked *packed)
+{
+	XpuCommand *xcmd = &packed->xcmd;
+	gpuClient  *gclient = xcmd->priv;
+	gpuMemChunk *chunk;
+	CUresult	rc;
+
+	/* no need to load, if the connection is already closed */
+	if ((pg_atomic_read_u32(&gclient->refcnt) & 1) == 0)
+		return NULL;
+	memset(&packed->ra_io_counter, 0, sizeof(gpuDirectIOCounter));
+	packed->ra_npages_direct_read = 0;
+	packed->ra_npages_vfs_read = 0;
+	gpuDirectSetIOCounter(&packed->ra_io_counter);
+	chunk = gpuservLoadKdsArrow(gclient,
+								(kern_data_store *)((char *)xcmd +
+													xcmd->u.task.kds_src_offset),
+								(char *)xcmd + xcmd->u.task.kds_src_pathname,
+								(strom_io_vector *)((char *)xcmd +
+													xcmd->u.task.kds_src_iovec),
+								&packed->ra_npages_direct_read,
+								&packed->ra_npages_vfs_read);
+	gpuDirectSetIOCounter(NULL);
+	if (!chunk)
+		packed->ra_status = -1;		/* error is already reported */
+	else
+	{
+		/* the worker uses the chunk on its own stream */
+		rc = cuStreamSynchronize(MY_STREAM_PER_THREAD);
+		if (rc != CUDA_SUCCESS)
+		{
+			gpuClientELog(gclient, "failed on cuStreamSynchronize: %s",
+						  cuStrError(rc));
+			gpuMemFree(chunk);
+			packed->ra_status = -1;
+			return NULL;
+		}
+		packed->ra_status = 1;
+	}
+	return chunk;
+}
+
+/*
+ * __gpuservReadAheadTakeChunk
+ *
+ * It takes the KDS loaded by the read-ahead, if any. It returns 1 if the
+ * chunk is taken, 0 if not loaded yet, or -1 if the read-ahead failed.
+ */
+static int
+__gpuservReadAheadTakeChunk(XpuCommand *xcmd,
+							gpuMemChunk **p_chunk,
+							gpuDirectIOCounter *io_counter,
+							uint32_t *p_npages_direct_read,
+							uint32_t *p_npages_vfs_read)
+{
+	gpuServXpuCommandPacked *packed;
+	gpuContext *gcontext;
+
+	/* coalesced commands are built without the packed header */
+	if (xcmd->u.task.kds_src_pathname == 0)
+		return 0;
+	packed = (gpuServXpuCommandPacked *)
+		((char *)xcmd - offsetof(gpuServXpuCommandPacked, xcmd));
+	if (packed->ra_status <= 0)
+		return packed->ra_status;
+	Assert(packed->ra_chunk != NULL);
+	gcontext = packed->ra_gcontext;
+	*p_chunk = packed->ra_chunk;
+	memcpy(io_counter, &packed->ra_io_counter, sizeof(gpuDirectIOCounter));
+	*p_npages_direct_read += packed->ra_npages_direct_read;
+	*p_npages_vfs_read += packed->ra_npages_vfs_read;
+	packed->ra_chunk = NULL;
+
+	pthreadMutexLock(&gcontext->lock);
+	Assert(gcontext->ra_staged_bytes >= packed->ra_length);
+	gcontext->ra_staged_bytes -= packed->ra_length;
+	pthreadMutexUnlock(&gcontext->lock);
+	pthreadCondSignal(&gcontext->ra_cond);
+
+	return 1;
+}
+
+static void *
+gpuservArrowReadAheadMain(void *__arg)
+{
+	gpuWorker  *gworker = (gpuWorker *)__arg;
+	gpuContext *gcontext = gworker->gcontext;
+	CUstream	cuda_stream;
+	CUresult	rc;
+
+	rc = cuCtxSetCurrent(gcontext->cuda_context);
+	if (rc != CUDA_SUCCESS)
+		__FATAL("failed on cuCtxSetCurrent: %s", cuStrError(rc));
+	rc = cuStreamCreate(&cuda_stream, CU_STREAM_NON_BLOCKING);
+	if (rc != CUDA_SUCCESS)
+		__FATAL("failed on cuStreamCreate: %s", cuStrError(rc));
+
+	gpuDevBindNumaThread(gcontext->cuda_dindex);
+	GpuWorkerCurrentContext	= gcontext;
+	MY_DINDEX_PER_THREAD	= gcontext->cuda_dindex;
+	MY_DEVICE_PER_THREAD	= gcontext->cuda_device;
+	MY_CONTEXT_PER_THREAD	= gcontext->cuda_context;
+	MY_STREAM_PER_THREAD	= cuda_stream;
+	MY_EVENT_PER_THREAD		= NULL;
+	pg_memory_barrier();
+	__gpuservTraceThreadSetup("GPU-%d readahead", MY_DINDEX_PER_THREAD);
+
+	GpuServDebug("GPU-%d read-ahead thread launched", MY_DINDEX_PER_THREAD);
+
+	pthreadMutexLock(&gcontext->lock);
+	while (!gpuServiceGoingTerminate() && !gworker->termination)
+	{
+		size_t		staging_limit = ((size_t)pgstrom_arrow_readahead_staging_mb << 20);
+
+		if (!dlist_is_empty(&gcontext->ra_command_list) &&
+			gcontext->ra_ninflight < gcontext->ra_depth &&
+			gcontext->ra_staged_bytes < staging_limit)
+		{
+			dlist_node *dnode = dlist_pop_head_node(&gcontext->ra_command_list);
+			XpuCommand *xcmd = dlist_container(XpuCommand, chain, dnode);
+			gpuServXpuCommandPacked *packed = (gpuServXpuCommandPacked *)
+				((char *)xcmd - offsetof(gpuServXpuCommandPacked, xcmd));
+			kern_data_store *kds = (kern_data_store *)
+				((char *)xcmd + xcmd->u.task.kds_src_offset);
+			gpuMemChunk *chunk;
+			uint64_t	tv_begin;
+			uint64_t	tv_trace;
+
+			gcontext->ra_ninflight++;
+			pthreadMutexUnlock(&gcontext->lock);
+
+			tv_begin = __gpuservTimeUsec();
+			tv_trace = gpuservTraceBegin();
+			chunk = __gpuservReadAheadOne(packed);
+			gpuservTraceEnd("gpu", "readahead", tv_trace);
+
+			pthreadMutexLock(&gcontext->lock);
+			Assert(gcontext->ra_ninflight > 0);
+			gcontext->ra_ninflight--;
+			if (chunk)
+			{
+				packed->ra_gcontext = gcontext;
+				packed->ra_chunk = chunk;
+				packed->ra_length = kds->length;
+				gcontext->ra_staged_bytes += kds->length;
+				__gpuservReadAheadUpdateDepth(gcontext, kds->length,
+											  tv_begin, __gpuservTimeUsec());
+			}
+			/* hand over the task to the workers */
+			dlist_push_tail(&gcontext->command_list, &xcmd->chain);
+			pthreadCondSignal(&gcontext->cond);
+		}
+		else
+			pthreadCondWaitTimeout(&gcontext->ra_cond, &gcontext->lock, 5000);
+	}
+	/* remaining tasks are released by the workers */
+	while (!dlist_is_empty(&gcontext->ra_command_list))
+	{
+		dlist_node *dnode = dlist_pop_head_node(&gcontext->ra_command_list);
+
+		dlist_push_tail(&gcontext->command_list, dnode);
+	}
+	pthreadMutexUnlock(&gcontext->lock);
+	pthreadCondBroadcast(&gcontext->cond);
+
+	/* detach from the gpuContext */
+	pthreadMutexLock(&gcontext->worker_lock);
+	dlist_delete(&gworker->chain);
+	pthreadMutexUnlock(&gcontext->worker_lock);
+	cuStreamDestroy(cuda_stream);
+	free(gworker);
+	__gpuservTraceThreadCleanup();
+
+	GpuServDebug("GPU-%d read-ahead thread terminated", MY_DINDEX_PER_THREAD);
+
+	return NULL;
+}
+
+/* ----------------------------------------------------------------
+ *
+ * gpuservHandleGpuTaskExec
+ *
+ * ----------------------------------------------------------------
+ */
+static unsigned int
+__expand_gpupreagg_prepfunc_buffer(kern_session_info *session,
+								   int grid_sz, int block_sz,
+								   unsigned int shmem_base_sz,
+								   unsigned int shmem_dynamic_sz,
+								   unsigned int *p_groupby_prepfn_bufsz,
+								   unsigned int *p_groupby_prepfn_nbufs)
+{
+	unsigned int	prepfn_usage;
+	unsigned int	num_buffers;
+
+	shmem_base_sz = TYPEALIGN(1024, shmem_base_sz);
+	if (session->groupby_prepfn_bufsz == 0 || shmem_base_sz >= shmem_dynamic_sz)
+		goto no_prepfunc_buffer;
+
+	if (session->xpucode_groupby_keyhash &&
+		session->xpucode_groupby_keyload &&
+		session->xpucode_groupby_keycomp)
+	{
+		/* GROUP-BY (with grouping-key dictionary) */
+		unsigned int	unitsz = (session->groupby_prepfn_bufsz +
+								  KAGG_KEYDICT_BUFSZ_PER_BUFFER);
+
+		num_buffers = 2 * session->groupby_ngroups_estimation + 100;
+		prepfn_usage = unitsz * num_buffers;
+		if (shmem_base_sz + prepfn_usage > shmem_dynamic_sz)
+		{
+			/* adjust num_buffers, if too large */
+			num_buffers = (shmem_dynamic_sz - shmem_base_sz) / unitsz;
+			prepfn_usage = unitsz * num_buffers;
+		}
+		Assert(shmem_base_sz + prepfn_usage <= shmem_dynamic_sz);
+		if (num_buffers < 32)
+			goto no_prepfunc_buffer;
+	}
+	else
+	{
+		/* NO-GROUPS */
+		num_buffers = 1;
+		prepfn_usage = session->groupby_prepfn_bufsz;
+		if (shmem_base_sz + prepfn_usage > shmem_dynamic_sz)
+			goto no_prepfunc_buffer;
+	}
+	*p_groupby_prepfn_bufsz = session->groupby_prepfn_bufsz;
+	*p_groupby_prepfn_nbufs = num_buffers;
+	return shmem_base_sz + prepfn_usage;
+
+no_prepfunc_buffer:
+	*p_groupby_prepfn_bufsz = 0;
+	*p_groupby_prepfn_nbufs = 0;
+	return shmem_base_sz;
+}
+
+/*
+ * __gpuservGpuSortCompactKds
+ *
+ * It truncates the sorted kds_dst to the top-K items, and releases the
+ * tuples not referenced any more, to reduce the amount of write-back.
+ */
+static bool
+__gpuservGpuSortCompactKds(kern_data_store *kds, uint32_t nitems)
+{
+	uint32_t   *row_index = KDS_GET_ROWINDEX(kds);
+	uint32_t   *offsets = alloca(sizeof(uint32_t) * nitems);
+	size_t		usage = 0;
+	char	   *buffer;
+
+	Assert(kds->format == KDS_FORMAT_ROW && nitems <= kds->nitems);
+	for (uint32_t i=0; i < nitems; i++)
+	{
+		kern_tupitem *tupitem = KDS_GET_TUPITEM(kds, i);
+
+		usage += MAXALIGN(offsetof(kern_tupitem, htup) + tupitem->t_len);
+	}
+	buffer = malloc(usage);
+	if (!buffer)
+		return false;
+	usage = 0;
+	for (uint32_t i=0; i < nitems; i++)
+	{
+		kern_tupitem *tupitem = KDS_GET_TUPITEM(kds, i);
+		size_t		sz = MAXALIGN(offsetof(kern_tupitem, htup) + tupitem->t_len);
+
+		memcpy(buffer + usage, tupitem, sz);
+		offsets[i] = usage;
+		usage += sz;
+	}
+	memcpy((char *)kds + kds->length - usage, buffer, usage);
+	for (uint32_t i=0; i < nitems; i++)
+		row_index[i] = __kds_packed(usage - offsets[i]);
+	kds->nitems = nitems;
+	kds->usage = __kds_packed(usage);
+	free(buffer);
+
+	return true;
+}
+
+/*
+ * __gpuservGpuSortTopK
+ *
+ * It sorts the destination buffers by the bitonic-sorting, then truncates
+ * them to the top-K items (if limit > 0). Any errors are not fatal here, because the
+ * backend process sorts the results again; so we just send back the
+ * destination buffers as is.
+ */
+static void
+__gpuservGpuSortTopK(gpuClient *gclient,
+					 kern_gputask *kgtask,
+					 int kds_dst_nitems,
+					 kern_data_store **kds_dst_array)
+{
+	kern_session_info *session = gclient->session;
+	uint64_t		limit = session->gpusort_limit;
+	CUfunction		f_gpusort;
+	CUresult		rc;
+	int				grid_sz;
+	int				block_sz;
+	unsigned int	shmem_sz;
+	void		   *kern_args[5];
+	bool			reversing;
+
+	rc = cuModuleGetFunction(&f_gpusort,
+							 gclient->cuda_module,
+							 "kern_gpusort_bitonic_step");
+	if (rc != CUDA_SUCCESS)
+	{
+		GpuServDebug("failed on cuModuleGetFunction: %s", cuStrError(rc));
+		return;
+	}
+	rc = gpuOptimalBlockSize(&grid_sz,
+							 &block_sz,
+							 &shmem_sz,
+							 f_gpusort,
+							 0, 0);
+	if (rc != CUDA_SUCCESS)
+	{
+		GpuServDebug("failed on gpuOptimalBlockSize: %s", cuStrError(rc));
+		return;
+	}
+
+	for (int k=0; k < kds_dst_nitems; k++)
+	{
+		kern_data_store *kds_dst = kds_dst_array[k];
+		uint32_t	nitems = kds_dst->nitems;
+		uint32_t	nitems_pow2 = 2;
+
+		/*
+		 * no need to sort on the device, if kds_dst is small enough.
+		 * limit==0 means the whole buffer must be sorted (window functions)
+		 */
+		if (nitems < 2 || (limit > 0 && nitems <= limit))
+			continue;
+		while (nitems_pow2 < nitems)
+			nitems_pow2 *= 2;
+		kern_args[0] = &gclient->session;
+		kern_args[1] = &kgtask;
+		kern_args[2] = &kds_dst;
+		for (uint32_t unitsz = 2; unitsz <= nitems_pow2; unitsz *= 2)
+		{
+			for (uint32_t __unitsz = unitsz; __unitsz >= 2; __unitsz /= 2)
+			{
+				reversing = (__unitsz == unitsz);
+				kern_args[3] = &__unitsz;
+				kern_args[4] = &reversing;
+				rc = cuLaunchKernel(f_gpusort,
+									grid_sz, 1, 1,
+									block_sz, 1, 1,
+									shmem_sz,
+									MY_STREAM_PER_THREAD,
+									kern_args,
+									NULL);
+				if (rc != CUDA_SUCCESS)
+				{
+					GpuServDebug("failed on cuLaunchKernel: %s", cuStrError(rc));
+					goto bailout;
+				}
+			}
+		}
+	}
+bailout:
+	rc = cuEventRecord(MY_EVENT_PER_THREAD, MY_STREAM_PER_THREAD);
+	if (rc == CUDA_SUCCESS)
+		rc = cuEventSynchronize(MY_EVENT_PER_THREAD);
+	if (rc != CUDA_SUCCESS)
+	{
+		GpuServDebug("failed on cuEventSynchronize: %s", cuStrError(rc));
+		return;
+	}
+	if (kgtask->kerror.errcode != ERRCODE_STROM_SUCCESS)
+	{
+		GpuServDebug("GpuSort: %s (%s:%d)",
+					 kgtask->kerror.message,
+					 kgtask->kerror.filename,
+					 kgtask->kerror.lineno);
+		memset(&kgtask->kerror, 0, sizeof(kern_errorbuf));
+		return;
+	}
+	for (int k=0; k < kds_dst_nitems; k++)
+	{
+		kern_data_store *kds_dst = kds_dst_array[k];
+
+		if (limit > 0 && kds_dst->nitems > limit)
+			__gpuservGpuSortCompactKds(kds_dst, limit);
+	}
+}
+
+/*
+ * __gpuservPrefetchResultsToHost
+ *
+ * It moves the portion of kds_dst to be written back onto the host memory,
+ * prior to the writeback. It is usually faster than page-faults on writev(2)
+ */
+static void
+__gpuservPrefetchResultsToHost(int kds_nitems, kern_data_store **kds_array)
+{
+	for (int i=0; i < kds_nitems; i++)
+	{
+		kern_data_store *kds = kds_array[i];
+		size_t		head_sz;
+		size_t		usage;
+
+		if (kds->format == KDS_FORMAT_COLUMN)
+		{
+			(void)cuMemPrefetchAsync((CUdeviceptr)kds, KDS_HEAD_LENGTH(kds),
+									 CU_DEVICE_CPU,
+									 MY_STREAM_PER_THREAD);
+			for (int j=0; j < kds->ncols && kds->nitems > 0; j++)
+			{
+				const kern_colmeta *cmeta = &kds->colmeta[j];
+
+				(void)cuMemPrefetchAsync((CUdeviceptr)kds +
+										 __kds_unpack(cmeta->nullmap_offset),
+										 BITMAPLEN(kds->nitems),
+										 CU_DEVICE_CPU,
+										 MY_STREAM_PER_THREAD);
+				(void)cuMemPrefetchAsync((CUdeviceptr)kds +
+										 __kds_unpack(cmeta->values_offset),
+										 (size_t)cmeta->attlen * kds->nitems,
+										 CU_DEVICE_CPU,
+										 MY_STREAM_PER_THREAD);
+			}
+			continue;
+		}
+		if (kds->format != KDS_FORMAT_ROW)
+			continue;
+		head_sz = KDS_HEAD_LENGTH(kds) + MAXALIGN(sizeof(uint32_t) * kds->nitems);
+		usage = __kds_unpack(kds->usage);
+		(void)cuMemPrefetchAsync((CUdeviceptr)kds, head_sz,
+								 CU_DEVICE_CPU,
+								 MY_STREAM_PER_THREAD);
+		if (usage > 0)
+			(void)cuMemPrefetchAsync((CUdeviceptr)kds + kds->length - usage,
+									 usage,
+									 CU_DEVICE_CPU,
+									 MY_STREAM_PER_THREAD);
+	}
+	(void)cuStreamSynchronize(MY_STREAM_PER_THREAD);
+}
+
+/*
+ * __gpuservUpdateScanQualsOrder
+ *
+ * It accumulates the pass rate of the scan-quals, then determines the order
+ * to evaluate them in the later chunks. The qualifiers are sorted by
+ * cost / (1 - pass rate); so cheaper and more selective ones come first.
+ * Any order gives the same result, so we don't need to serialize the
+ * concurrent workers of the same session.
+ */
+static uint64_t
+__gpuservUpdateScanQualsOrder(gpuClient *gclient, const kern_gputask *kgtask)
+{
+	const kern_expression *kexp = SESSION_KEXP_SCAN_QUALS(gclient->session);
+	uint32_t	nquals = gclient->aqual_nquals;
+	double		rank[KERN_ADAPTIVE_QUALS_MAX];
+	int			index[KERN_ADAPTIVE_QUALS_MAX];
+	uint64_t	order = 0;
+	int			i, j, k;
+
+	assert(nquals > 0 && nquals <= KERN_ADAPTIVE_QUALS_MAX);
+	for (i=0; i < nquals; i++)
+	{
+		uint64_t	nevals;
+		uint64_t	npassed;
+		double		prate;
+
+		nevals = __atomic_add_fetch(&gclient->aqual_nevals[i],
+									kgtask->scan_quals_nevals[i],
+									__ATOMIC_RELAXED);
+		npassed = __atomic_add_fetch(&gclient->aqual_npassed[i],
+									 kgtask->scan_quals_npassed[i],
+									 __ATOMIC_RELAXED);
+		/* Laplace smoothing, for qualifiers not evaluated yet */
+		prate = ((double)npassed + 1.0) / ((double)nevals + 2.0);
+		rank[i] = (double)Max(kexp->u.aqual.cost[i], 1) / (1.0 - prate);
+		/* insertion sort; ties keep the order by the planner */
+		for (j=i; j > 0 && rank[index[j-1]] > rank[i]; j--)
+			index[j] = index[j-1];
+		index[j] = i;
+	}
+	for (k=nquals-1; k >= 0; k--)
+		order = (order << 4) | (uint64_t)index[k];
+	__atomic_store_n(&gclient->aqual_order, order, __ATOMIC_RELAXED);
+
+	return order;
+}
+
+/*
+ * __gpuservUpdateJoinPrefilter
+ *
+ * It accumulates the number of rows at each depth of GpuJoin in the first
+ * tasks, then decides the depths whose bloom-filter is applied at the first
+ * depth on the following tasks, if they are selective enough. The depth order
+ * is fixed by the planner, so the selective depths filter out the outer tuples
+ * prior to the earlier depths that may produce massive intermediate rows.
+ * The decision is not revised, because the pre-filter itself changes the
+ * selectivity observed at these depths.
+ */
+static void
+__gpuservUpdateJoinPrefilter(gpuClient *gclient, const kern_gputask *kgtask)
+{
+	uint32_t	candidate = gclient->session->join_bloom_prefilter;
+	uint32_t	n_rels = Min(kgtask->n_rels, GPUSERV_JOIN_PREFILTER_MAXDEPTH);
+	uint32_t	mask = 0;
+	uint64_t	nitems_in;
+	bool		expected = false;
+
+	if (candidate == 0 ||
+		__atomic_load_n(&gclient->jfilter_decided, __ATOMIC_RELAXED))
+		return;
+	nitems_in = __atomic_add_fetch(&gclient->jfilter_nitems_in,
+								   kgtask->nitems_in,
+								   __ATOMIC_RELAXED);
+	for (int i=0; i < n_rels; i++)
+		__atomic_add_fetch(&gclient->jfilter_nitems_out[i],
+						   kgtask->stats[i].nitems_out,
+						   __ATOMIC_RELAXED);
+	if (nitems_in < GPUSERV_JOIN_PREFILTER_MIN_NITEMS ||
+		!__atomic_compare_exchange_n(&gclient->jfilter_decided,
+									 &expected, true, false,
+									 __ATOMIC_RELAXED,
+									 __ATOMIC_RELAXED))
+		return;
+	for (int k=2; k <= n_rels; k++)
+	{
+		uint64_t	__nitems_in;
+		uint64_t	__nitems_out;
+
+		if ((candidate & (1U << k)) == 0)
+			continue;
+		__nitems_in  = __atomic_load_n(&gclient->jfilter_nitems_out[k-2], __ATOMIC_RELAXED);
+		__nitems_out = __atomic_load_n(&gclient->jfilter_nitems_out[k-1], __ATOMIC_RELAXED);
+		if ((double)__nitems_out <
+			(double)__nitems_in * GPUSERV_JOIN_PREFILTER_RATIO)
+			mask |= (1U << k);
+	}
+	if (mask != 0)
+		GpuServDebug("GpuJoin bloom pre-filter is enabled (mask=%08x, nitems_in=%lu)",
+					 mask, nitems_in);
+	__atomic_store_n(&gclient->jfilter_mask, mask, __ATOMIC_RELAXED);
+}
+
+/*
+ * __gpuservGetTaskGraph / __gpuservPutTaskGraph
+ *
+ * It returns a CUDA Graph instance that launches the supplied kernel with
+ * the kern_args. An instance of the same kernel and dimensions is reused
+ * with the updated kernel parameters; elsewhere, a new graph is built.
+ * It returns NULL if CUDA Graph is not available, then the caller should
+ * launch the kernel as usual.
+ */
+static gpuTaskGraph *
+__gpuservGetTaskGraph(gpuClient *gclient,
+					  CUfunction f_kern,
+					  int grid_sz,
+					  int block_sz,
+					  unsigned int shmem_sz,
+					  void **kern_args)
+{
+	gpuTaskGraph   *tgraph;
+	gpuTaskGraph  **prev;
+	CUDA_KERNEL_NODE_PARAMS params;
+	CUresult		rc;
+
+	memset(&params, 0, sizeof(CUDA_KERNEL_NODE_PARAMS));
+	params.func = f_kern;
+	params.gridDimX = grid_sz;
+	params.gridDimY = 1;
+	params.gridDimZ = 1;
+	params.blockDimX = block_sz;
+	params.blockDimY = 1;
+	params.blockDimZ = 1;
+	params.sharedMemBytes = shmem_sz;
+	params.kernelParams = kern_args;
+	params.extra = NULL;
+
+	pthreadMutexLock(&gclient->graph_lock);
+	for (prev = &gclient->graph_free_list;
+		 (tgraph = *prev) != NULL;
+		 prev = &tgraph->next)
+	{
+		if (tgraph->f_kern == f_kern &&
+			tgraph->grid_sz == grid_sz &&
+			tgraph->block_sz == block_sz &&
+			tgraph->shmem_sz == shmem_sz)
+		{
+			*prev = tgraph->next;
+			tgraph->next = NULL;
+			break;
+		}
+	}
+	pthreadMutexUnlock(&gclient->graph_lock);
+
+	if (tgraph)
+	{
+		/* replay the graph with the kernel parameters of this chunk */
+		rc = cuGraphExecKernelNodeSetParams(tgraph->graph_exec,
+											tgraph->kern_node,
+											&params);
+		if (rc == CUDA_SUCCESS)
+			return tgraph;
+		GpuServDebug("failed on cuGraphExecKernelNodeSetParams: %s",
+					 cuStrError(rc));
+		__gpuservFreeTaskGraph(tgraph);
+		return NULL;
+	}
+
+	/* build a new graph */
+	tgraph = calloc(1, sizeof(gpuTaskGraph));
+	if (!tgraph)
+		return NULL;
+	tgraph->f_kern = f_kern;
+	tgraph->grid_sz = grid_sz;
+	tgraph->block_sz = block_sz;
+	tgraph->shmem_sz = shmem_sz;
+	rc = cuGraphCreate(&tgraph->graph, 0);
+	if (rc != CUDA_SUCCESS)
+	{
+		GpuServDebug("failed on cuGraphCreate: %s", cuStrError(rc));
+		goto bailout;
+	}
+	rc = cuGraphAddKernelNode(&tgraph->kern_node,
+							  tgraph->graph,
+							  NULL, 0,
+							  &params);
+	if (rc != CUDA_SUCCESS)
+	{
+		GpuServDebug("failed on cuGraphAddKernelNode: %s", cuStrError(rc));
+		goto bailout;
+	}
+	rc = cuGraphInstantiateWithFlags(&tgraph->graph_exec,
+									 tgraph->graph, 0);
+	if (rc != CUDA_SUCCESS)
+	{
+		GpuServDebug("failed on cuGraphInstantiateWithFlags: %s",
+					 cuStrError(rc));
+		tgraph->graph_exec = NULL;
+		goto bailout;
+	}
+	return tgraph;
+
+bailout:
+	__gpuservFreeTaskGraph(tgraph);
+	return NULL;
+}
+
+static void
+__gpuservPutTaskGraph(gpuClient *gclient, gpuTaskGraph *tgraph)
+{
+	pthreadMutexLock(&gclient->graph_lock);
+	tgraph->next = gclient->graph_free_list;
+	gclient->graph_free_list = tgraph;
+	pthreadMutexUnlock(&gclient->graph_lock);
+}
+
+/*
+ * __gpuservUpdateTaskStats
+ */
+static void
+__gpuservUpdateTaskStats(gpuContext *gcontext, bool is_fallback,
+						 uint32_t npages_direct_read,
+						 uint32_t npages_vfs_read,
+						 uint64_t usec_load,
+						 uint64_t usec_kernel,
+						 uint64_t usec_writeback)
+{
+	gpuServDeviceStats *stats = GPUSERV_DEVICE_STATS(gcontext->cuda_dindex);
+
+	pg_atomic_fetch_add_u64(&stats->nr_tasks, 1);
+	if (is_fallback)
+		pg_atomic_fetch_add_u64(&stats->nr_fallbacks, 1);
+	pg_atomic_fetch_add_u64(&stats->npages_direct_read, npages_direct_read);
+	pg_atomic_fetch_add_u64(&stats->npages_vfs_read, npages_vfs_read);
+	pg_atomic_fetch_add_u64(&stats->usec_load, usec_load);
+	pg_atomic_fetch_add_u64(&stats->usec_kernel, usec_kernel);
+	pg_atomic_fetch_add_u64(&stats->usec_writeback, usec_writeback);
+}
+
+/*
+ * __gpuservLookupKernelGeometry
+ *
+ * It determines the grid/block size and the shared memory usage of the
+ * GPU task kernel. cuOccupancyMaxPotentialBlockSize() considers register
+ * and shared memory consumption of the kernel, then the grid size is
+ * shrunk if the kvecs buffer, proportional to the number of kvars and
+ * the depth of joins, consumes too much device memory for each task.
+ * The result is cached on the gpuClient because it is invariant during
+ * the session.
+ */
+static bool
+__gpuservLookupKernelGeometry(gpuClient *gclient, CUfunction f_kern,
+							  int *p_grid_sz,
+							  int *p_block_sz,
+							  unsigned int *p_shmem_sz,
+							  unsigned int *p_prepfn_bufsz,
+							  unsigned int *p_prepfn_nbufs)
+{
+	gpuContext	   *gcontext = gclient->gcontext;
+	kern_session_info *session = gclient->session;
+	int				grid_sz;
+	int				block_sz;
+	unsigned int	shmem_sz;
+	unsigned int	prepfn_bufsz = 0;
+	unsigned int	prepfn_nbufs = 0;
+	size_t			kvecs_limit;
+	size_t			wp_unitsz;
+	CUresult		rc;
+
+	if (__atomic_load_n(&gclient->kgeom_block_sz, __ATOMIC_ACQUIRE) > 0)
+	{
+		*p_grid_sz      = gclient->kgeom_grid_sz;
+		*p_block_sz     = gclient->kgeom_block_sz;
+		*p_shmem_sz     = gclient->kgeom_shmem_sz;
+		*p_prepfn_bufsz = gclient->kgeom_prepfn_bufsz;
+		*p_prepfn_nbufs = gclient->kgeom_prepfn_nbufs;
+		return true;
+	}
+	rc = gpuOptimalBlockSize(&grid_sz,
+							 &block_sz,
+							 &shmem_sz,
+							 f_kern,
+							 0,
+							 __KERN_WARP_CONTEXT_BASESZ(session->kcxt_kvecs_ndims));
+	if (rc != CUDA_SUCCESS)
+	{
+		gpuClientFatal(gclient, "failed on gpuOptimalBlockSize: %s",
+					   cuStrError(rc));
+		return false;
+	}
+	/* shrink the grid size, if kvecs buffer is too large */
+	kvecs_limit = (size_t)pgstrom_gpu_kvecs_buffer_limit_kb << 10;
+	wp_unitsz = KERN_WARP_CONTEXT_LENGTH(session->kcxt_kvecs_ndims,
+										 session->kcxt_kvecs_bufsz);
+	if (kvecs_limit > 0 && wp_unitsz * grid_sz > kvecs_limit)
+	{
+		int		min_grid_sz = Min(grid_sz, gpuDevAttrs[gcontext->cuda_dindex].MULTIPROCESSOR_COUNT);
+
+		grid_sz = Max(kvecs_limit / wp_unitsz, min_grid_sz);
+	}
+	/* allocation of extra shared memory for GpuPreAgg (if any) */
+	shmem_sz = __expand_gpupreagg_prepfunc_buffer(session,
+												  grid_sz, block_sz,
+												  shmem_sz,
+												  gcontext->gpumain_shmem_sz_dynamic,
+												  &prepfn_bufsz,
+												  &prepfn_nbufs);
+	GpuServDebug("GPU-%d kernel geometry: grid=%d, block=%d, shmem=%u (kvecs: ndims=%u, bufsz=%u)",
+				 gcontext->cuda_dindex, grid_sz, block_sz, shmem_sz,
+				 session->kcxt_kvecs_ndims,
+				 session->kcxt_kvecs_bufsz);
+	gclient->kgeom_grid_sz      = grid_sz;
+	gclient->kgeom_shmem_sz     = shmem_sz;
+	gclient->kgeom_prepfn_bufsz = prepfn_bufsz;
+	gclient->kgeom_prepfn_nbufs = prepfn_nbufs;
+	__atomic_store_n(&gclient->kgeom_block_sz, block_sz, __ATOMIC_RELEASE);
+
+	*p_grid_sz      = grid_sz;
+	*p_block_sz     = block_sz;
+	*p_shmem_sz     = shmem_sz;
+	*p_prepfn_bufsz = prepfn_bufsz;
+	*p_prepfn_nbufs = prepfn_nbufs;
+	return true;
+}
+
+static void
+gpuservHandleGpuTaskExec(gpuClient *gclient, XpuCommand *xcmd)
+{
+	gpuContext		*gcontext = gclient->gcontext;
+	kern_session_info *session = gclient->session;
+	gpuQueryBuffer  *gq_buf = gclient->gq_buf;
+	kern_gputask	*kgtask = NULL;
+	const char		*kds_src_pathname = NULL;
+	strom_io_vector *kds_src_iovec = NULL;
+	kern_data_store *kds_src = NULL;
+	kern_data_store *kds_dst = NULL;
+	kern_data_store *kds_dst_head = NULL;
+	kern_data_store **kds_dst_array = NULL;
+	int				kds_dst_nrooms = 0;
+	int				kds_dst_nitems = 0;
+	int				num_inner_rels = 0;
+	uint32_t		npages_direct_read = 0;
+	uint32_t		npages_vfs_read = 0;
+	gpuDirectIOCounter io_counter;
+	CUfunction		f_kern_gpuscan;
+	gpuTaskGraph   *tgraph = NULL;
+	void		   *gc_lmap = NULL;
+	gpuMemChunk	   *s_chunk = NULL;		/* for kds_src */
+	gpuMemChunk	   *t_chunk = NULL;		/* for kern_gputask */
+	gpuMemChunk	  **d_chunk_array = NULL; /* for kds_dst_array */
+	gpuMemChunk	   *d_chunk;
+	kern_data_store *kds_new;
+	CUdeviceptr		m_kds_src = 0UL;
+	CUdeviceptr		m_kds_extra = 0UL;
+	CUdeviceptr		m_kmrels = 0UL;
+	CUresult		rc;
+	int				grid_sz;
+	int				block_sz;
+	unsigned int	shmem_sz;
+	unsigned int	groupby_prepfn_bufsz = 0;
+	unsigned int	groupby_prepfn_nbufs = 0;
+	size_t			kds_final_length = 0;
+	uint32_t		kds_final_version = 0;
+	bool			kds_final_locked = false;
+	size_t			sz;
+	void		   *kern_args[10];
+	uint64_t		tv_load = __gpuservTimeUsec();
+	uint64_t		tv_writeback;
+	uint64_t		tv_trace = gpuservTraceBegin();
+	uint64_t		usec_kernel = 0;
+	float			elapsed_ms;
+
+	memset(&io_counter, 0, sizeof(gpuDirectIOCounter));
+	if (xcmd->u.task.kds_src_pathname)
+		kds_src_pathname = (char *)xcmd + xcmd->u.task.kds_src_pathname;
+	if (xcmd->u.task.kds_src_iovec)
+		kds_src_iovec = (strom_io_vector *)((char *)xcmd + xcmd->u.task.kds_src_iovec);
+	if (xcmd->u.task.kds_src_offset)
+		kds_src = (kern_data_store *)((char *)xcmd + xcmd->u.task.kds_src_offset);
+	if (xcmd->u.task.kds_dst_offset)
+		kds_dst_head = (kern_data_store *)((char *)xcmd + xcmd->u.task.kds_dst_offset);
+	if (gclient->is_remote)
+	{
+		/*
+		 * The remote host has neither GpuCache nor PGDATA here, so the
+		 * source must be shipped, or on the storage shared by the hosts
+		 * (arrow files at the same absolute path).
+		 */
+		if (!kds_src)
+		{
+			gpuClientELog(gclient, "GpuCache is not supported on the remote GPU service");
+			return;
+		}
+		if (kds_src_pathname && kds_src_pathname[0] != '/')
+		{
+			gpuClientELog(gclient, "relative path '%s' is not supported on the remote GPU service",
+						  kds_src_pathname);
+			return;
+		}
+	}
+	if (!kds_src)
+	{
+		const GpuCacheIdent *ident = (GpuCacheIdent *)xcmd->u.task.data;
+		char		errbuf[120];
+
+		Assert(xcmd->tag == XpuCommandTag__XpuTaskExecGpuCache);
+		gc_lmap = gpuCacheGetDeviceBuffer(ident,
+										  gclient->gcontext->cuda_dindex,
+										  &m_kds_src,
+										  &m_kds_extra,
+										  errbuf, sizeof(errbuf));
+		if (!gc_lmap)
+		{
+			gpuClientELog(gclient, "no GpuCache (dat=%u,rel=%u,sig=%09lx) found - %s",
+						  ident->database_oid,
+						  ident->table_oid,
+						  ident->signature,
+						  errbuf);
+			return;
+		}
+	}
+	else if (kds_src->format == KDS_FORMAT_ROW)
+	{
+		m_kds_src = (CUdeviceptr)kds_src;
+	}
+	else if (kds_src->format == KDS_FORMAT_BLOCK)
+	{
+		if (kds_src_pathname && kds_src_iovec)
+		{
+			gpuDirectSetIOCounter(&io_counter);
+			s_chunk = gpuservLoadKdsBlock(gclient,
+										  kds_src,
+										  kds_src_pathname,
+										  kds_src_iovec,
+										  &npages_direct_read,
+										  &npages_vfs_read);
+			gpuDirectSetIOCounter(NULL);
+			if (!s_chunk)
+				return;
+			m_kds_src = s_chunk->m_devptr;
+		}
+		else
+		{
+			Assert(kds_src->block_nloaded == kds_src->nitems);
+			m_kds_src = (CUdeviceptr)kds_src;
+		}
+	}
+	else if (kds_src->format == KDS_FORMAT_ARROW)
+	{
+		if (kds_src_iovec->nr_chunks == 0)
+			m_kds_src = (CUdeviceptr)kds_src;
+		else
+		{
+			int		ra_status;
+
+			if (!kds_src_pathname)
+			{
+				gpuClientELog(gclient, "GpuScan: arrow file is missing");
+				return;
+			}
+			/* already loaded by the read-ahead? */
+			ra_status = __gpuservReadAheadTakeChunk(xcmd, &s_chunk,
+													&io_counter,
+													&npages_direct_read,
+													&npages_vfs_read);
+			if (ra_status < 0)
+				return;		/* error is already reported */
+			if (ra_status == 0)
+			{
+				gpuDirectSetIOCounter(&io_counter);
+				s_chunk = gpuservLoadKdsArrow(gclient,
+											  kds_src,
+											  kds_src_pathname,
+											  kds_src_iovec,
+											  &npages_direct_read,
+											  &npages_vfs_read);
+				gpuDirectSetIOCounter(NULL);
+				if (!s_chunk)
+					return;
+			}
+			m_kds_src = s_chunk->m_devptr;
 		}
-		pthreadRWLockReadLock(&gq_buf->m_kds_final_rwlock);
-		kds_dst = (kern_data_store *)gq_buf->m_kds_final;
-		kds_final_length = gq_buf->m_kds_final_length;
-		kds_final_locked = true;
 	}
 	else
 	{
-		gpuMemChunk	   *d_chunk;
+		gpuClientELog(gclient, "unknown GpuScan Source format (%c)",
+					  kds_src->format);
+		return;
+	}
+	tv_load = __gpuservTimeUsec() - tv_load;
+	gpuservTraceEnd("gpu", "load", tv_trace);
+	/* wait for the inner buffer, if outer chunk is loaded during preload */
+	if (gclient->gq_buf_deferred)
+	{
+		if (!__gpuClientAttachDeferredBuffer(gclient))
+			goto bailout;
+		gq_buf = gclient->gq_buf;
+		if (!gq_buf)
+		{
+			/* inner relation is empty, so nothing to join */
+			__gpuservSendEmptyResults(gclient);
+			goto bailout;
+		}
+	}
+	/* inner buffer of GpuJoin */
+	if (gq_buf && gq_buf->m_kmrels)
+	{
+		kern_multirels *h_kmrels = (kern_multirels *)gq_buf->h_kmrels;
+
+		m_kmrels = gq_buf->m_kmrels;
+		num_inner_rels = h_kmrels->num_rels;
+		if (__kmrelsHasInnerPartitions(h_kmrels))
+			__switchGpuQueryJoinInnerPartition(gq_buf, xcmd->u.task.inner_part_id);
+	}
+
+	rc = cuModuleGetFunction(&f_kern_gpuscan,
+							 gclient->cuda_module,
+							 "kern_gpujoin_main");
+	if (rc != CUDA_SUCCESS)
+	{
+		gpuClientFatal(gclient, "failed on cuModuleGetFunction: %s",
+					   cuStrError(rc));
+		goto bailout;
+	}
+
+	if (!__gpuservLookupKernelGeometry(gclient, f_kern_gpuscan,
+									   &grid_sz,
+									   &block_sz,
+									   &shmem_sz,
+									   &groupby_prepfn_bufsz,
+									   &groupby_prepfn_nbufs))
+		goto bailout;
+	/*
+	 * Allocation of the control structure
+	 */
+	sz = KERN_GPUTASK_LENGTH(session->kcxt_kvecs_ndims,
+							 session->kcxt_kvecs_bufsz,
+							 grid_sz, block_sz);
+	t_chunk = gpuMemAllocManaged(sz);
+	if (!t_chunk)
+	{
+		gpuClientFatal(gclient, "failed on gpuMemAllocManaged: %lu", sz);
+		goto bailout;
+	}
+	kgtask = (kern_gputask *)t_chunk->m_devptr;
+	memset(kgtask, 0, offsetof(kern_gputask, stats[num_inner_rels]));
+	kgtask->grid_sz  = grid_sz;
+	kgtask->block_sz = block_sz;
+	kgtask->kvars_nslots = session->kcxt_kvars_nslots;
+	kgtask->kvecs_bufsz  = session->kcxt_kvecs_bufsz;
+	kgtask->kvecs_ndims  = session->kcxt_kvecs_ndims;
+	kgtask->n_rels       = num_inner_rels;
+	kgtask->groupby_prepfn_bufsz = groupby_prepfn_bufsz;
+	kgtask->groupby_prepfn_nbufs = groupby_prepfn_nbufs;
+	kgtask->inner_part_id = xcmd->u.task.inner_part_id;
+	kgtask->scan_quals_nquals = gclient->aqual_nquals;
+	kgtask->scan_quals_order = __atomic_load_n(&gclient->aqual_order,
+											   __ATOMIC_RELAXED);
+	kgtask->join_prefilter_mask = __atomic_load_n(&gclient->jfilter_mask,
+												  __ATOMIC_RELAXED);
+
+	/* prefetch source KDS, if managed memory */
+	if (!s_chunk && !gc_lmap)
+	{
+		rc = cuMemPrefetchAsync((CUdeviceptr)kds_src,
+								kds_src->length,
+								MY_DEVICE_PER_THREAD,
+								MY_STREAM_PER_THREAD);
+		if (rc != CUDA_SUCCESS)
+		{
+			gpuClientFatal(gclient, "failed on cuMemPrefetchAsync: %s",
+						   cuStrError(rc));
+			goto bailout;
+		}
+	}
+
+	/*
+	 * Allocation of the destination buffer
+	 */
+resume_kernel:
+	tv_trace = gpuservTraceBegin();
+	kds_new = NULL;
+	d_chunk = NULL;
+	if (gq_buf && gq_buf->m_kds_final)
+	{
+		/*
+		 * Suspend of GpuPreAgg kernel means the kds_final buffer is
+		 * almost full, thus GPU kernel wants to expand the buffer.
+		 * It must be done under the exclusive lock.
+		 * If the buffer is flushed instead, it is written back with
+		 * the results of this task.
+		 */
+		if (kgtask->resume_context)
+		{
+			bool	over_quota = false;
 
+			if (!__expandGpuQueryGroupByBuffer(gq_buf, session,
+											   kds_final_version,
+											   &kds_new,
+											   &over_quota))
+			{
+				if (over_quota)
+					gpuClientELog(gclient, "GPU memory quota exceeded on expansion of GpuPreAgg final buffer (usage=%lu, limit=%lu)",
+								  pg_atomic_read_u64(&gq_buf->quota->memory_usage),
+								  pg_atomic_read_u64(&gq_buf->quota->memory_limit));
+				else
+					gpuClientFatal(gclient, "unable to expand GpuPreAgg final buffer");
+				goto bailout;
+			}
+		}
+		pthreadRWLockReadLock(&gq_buf->m_kds_final_rwlock);
+		kds_dst = (kern_data_store *)gq_buf->m_kds_final;
+		kds_final_length = gq_buf->m_kds_final_length;
+		kds_final_version = gq_buf->m_kds_final_version;
+		kds_final_locked = true;
+	}
+	else
+	{
 		sz = KDS_HEAD_LENGTH(kds_dst_head) + PGSTROM_CHUNK_SIZE;
 		d_chunk = gpuMemAllocManaged(sz);
 		if (!d_chunk)
@@ -1941,6 +6310,11 @@ resume_kernel:
 		kds_dst = (kern_data_store *)d_chunk->m_devptr;
 		memcpy(kds_dst, kds_dst_head, KDS_HEAD_LENGTH(kds_dst_head));
 		kds_dst->length = sz;
+		kds_new = kds_dst;
+	}
+
+	if (kds_new)
+	{
 		if (kds_dst_nitems >= kds_dst_nrooms)
 		{
 			kern_data_store	**kds_dst_temp;
@@ -1959,7 +6333,7 @@ resume_kernel:
 			kds_dst_array = kds_dst_temp;
 			d_chunk_array = d_chunk_temp;
 		}
-		kds_dst_array[kds_dst_nitems] = kds_dst;
+		kds_dst_array[kds_dst_nitems] = kds_new;
 		d_chunk_array[kds_dst_nitems] = d_chunk;
 		kds_dst_nitems++;
 	}
@@ -1974,17 +6348,46 @@ resume_kernel:
 	kern_args[4] = &m_kds_extra;
 	kern_args[5] = &kds_dst;
 
-	rc = cuLaunchKernel(f_kern_gpuscan,
-						grid_sz, 1, 1,
-						block_sz, 1, 1,
-						shmem_sz,
-						MY_STREAM_PER_THREAD,
-						kern_args,
-						NULL);
+	rc = cuEventRecord(MY_EVENT_START_PER_THREAD, MY_STREAM_PER_THREAD);
 	if (rc != CUDA_SUCCESS)
 	{
-		gpuClientFatal(gclient, "failed on cuLaunchKernel: %s", cuStrError(rc));
-		goto bailout;
+		gpuClientFatal(gclient, "failed on cuEventRecord: %s", cuStrError(rc));
+		goto bailout;
+	}
+	/*
+	 * Replay the CUDA Graph of the kernel launch, unless the kernel resumes
+	 * from the suspended state.
+	 */
+	if (pgstrom_enable_cuda_graph && !kgtask->resume_context)
+		tgraph = __gpuservGetTaskGraph(gclient,
+									   f_kern_gpuscan,
+									   grid_sz,
+									   block_sz,
+									   shmem_sz,
+									   kern_args);
+	if (tgraph)
+	{
+		rc = cuGraphLaunch(tgraph->graph_exec, MY_STREAM_PER_THREAD);
+		if (rc != CUDA_SUCCESS)
+		{
+			gpuClientFatal(gclient, "failed on cuGraphLaunch: %s", cuStrError(rc));
+			goto bailout;
+		}
+	}
+	else
+	{
+		rc = cuLaunchKernel(f_kern_gpuscan,
+							grid_sz, 1, 1,
+							block_sz, 1, 1,
+							shmem_sz,
+							MY_STREAM_PER_THREAD,
+							kern_args,
+							NULL);
+		if (rc != CUDA_SUCCESS)
+		{
+			gpuClientFatal(gclient, "failed on cuLaunchKernel: %s", cuStrError(rc));
+			goto bailout;
+		}
 	}
 
 	rc = cuEventRecord(MY_EVENT_PER_THREAD, MY_STREAM_PER_THREAD);
@@ -2001,6 +6404,16 @@ resume_kernel:
 		gpuClientFatal(gclient, "failed on cuEventSynchronize: %s", cuStrError(rc));
 		goto bailout;
 	}
+	gpuservTraceEnd("gpu", "kernel", tv_trace);
+	if (cuEventElapsedTime(&elapsed_ms,
+						   MY_EVENT_START_PER_THREAD,
+						   MY_EVENT_PER_THREAD) == CUDA_SUCCESS)
+		usec_kernel += (uint64_t)(elapsed_ms * 1000.0);
+	if (tgraph)
+	{
+		__gpuservPutTaskGraph(gclient, tgraph);
+		tgraph = NULL;
+	}
 	/* unlock kds_final buffer */
 	if (kds_final_locked)
 	{
@@ -2018,211 +6431,827 @@ resume_kernel:
 		{
 			if (gpuServiceGoingTerminate())
 			{
-				gpuClientFatal(gclient, "GpuService is going to terminate during GpuScan kernel suspend/resume");
+				gpuClientFatal(gclient, "GpuService is going to terminate during GpuScan kernel suspend/resume");
+				goto bailout;
+			}
+			/* restore warp context from the previous state */
+			pg_atomic_fetch_add_u64(&GPUSERV_DEVICE_STATS(gcontext->cuda_dindex)->nr_suspends, 1);
+			kgtask->resume_context = true;
+			kgtask->suspend_count = 0;
+			GpuServDebug("suspend / resume happen\n");
+			if (kds_final_locked)
+				pthreadRWLockUnlock(&gq_buf->m_kds_final_rwlock);
+			goto resume_kernel;
+		}
+		/* run GpuSort to pick up the top-K items, if any */
+		if (session->gpusort_nkeys > 0 && !kds_final_length)
+			__gpuservGpuSortTopK(gclient, kgtask,
+								 kds_dst_nitems,
+								 kds_dst_array);
+		tv_trace = gpuservTraceBegin();
+		tv_writeback = __gpuservTimeUsec();
+		__gpuservPrefetchResultsToHost(kds_dst_nitems, kds_dst_array);
+		tv_writeback = __gpuservTimeUsec() - tv_writeback;
+		gpuservTraceEnd("gpu", "writeback", tv_trace);
+		/* send back status and kds_dst */
+		resp_sz = MAXALIGN(offsetof(XpuCommand,
+									u.results.stats[num_inner_rels]));
+		resp = alloca(resp_sz);
+		memset(resp, 0, resp_sz);
+		resp->magic = XpuCommandMagicNumber;
+		resp->tag   = XpuCommandTag__Success;
+		resp->u.results.chunks_nitems = kds_dst_nitems;
+		resp->u.results.chunks_offset = resp_sz;
+		resp->u.results.npages_direct_read = npages_direct_read;
+		resp->u.results.npages_vfs_read = npages_vfs_read;
+		resp->u.results.nitems_raw = kgtask->nitems_raw;
+		resp->u.results.nitems_in  = kgtask->nitems_in;
+		resp->u.results.nitems_out = kgtask->nitems_out;
+		if (session->scan_limit > 0)
+			pg_atomic_fetch_add_u64(&gclient->scan_nitems_out,
+									kgtask->nitems_out);
+		resp->u.results.usec_load = tv_load;
+		resp->u.results.usec_kernel = usec_kernel;
+		resp->u.results.usec_writeback = tv_writeback;
+		resp->u.results.gpudirect_nr_ios = io_counter.nr_ios;
+		resp->u.results.gpudirect_usec_io = io_counter.usec_io;
+		resp->u.results.gpudirect_usec_max = io_counter.usec_max;
+		memcpy(resp->u.results.gpudirect_io_hist, io_counter.hist,
+			   sizeof(io_counter.hist));
+		resp->u.results.kernel_grid_sz = grid_sz;
+		resp->u.results.kernel_block_sz = block_sz;
+		resp->u.results.kernel_shmem_sz = shmem_sz;
+		resp->u.results.num_rels = num_inner_rels;
+		for (int i=0; i < num_inner_rels; i++)
+		{
+			resp->u.results.stats[i].nitems_gist = kgtask->stats[i].nitems_gist;
+			resp->u.results.stats[i].nitems_out  = kgtask->stats[i].nitems_out;
+		}
+		if (num_inner_rels > 1)
+			__gpuservUpdateJoinPrefilter(gclient, kgtask);
+		if (gclient->aqual_nquals > 0)
+		{
+			resp->u.results.scan_quals_nquals = gclient->aqual_nquals;
+			resp->u.results.scan_quals_order = __gpuservUpdateScanQualsOrder(gclient, kgtask);
+			memcpy(resp->u.results.scan_quals_nevals,
+				   kgtask->scan_quals_nevals,
+				   sizeof(uint32_t) * gclient->aqual_nquals);
+			memcpy(resp->u.results.scan_quals_npassed,
+				   kgtask->scan_quals_npassed,
+				   sizeof(uint32_t) * gclient->aqual_nquals);
+		}
+		__gpuservUpdateTaskStats(gcontext, false,
+								 npages_direct_read,
+								 npages_vfs_read,
+								 tv_load,
+								 usec_kernel,
+								 tv_writeback);
+		gpuClientWriteBack(gclient,
+						   resp, resp_sz,
+						   kds_dst_nitems, kds_dst_array);
+	}
+	else if (kgtask->kerror.errcode == ERRCODE_CPU_FALLBACK)
+	{
+		kern_data_store *__kds_src = kds_src;
+		XpuCommand	resp;
+
+		/*
+		 * Send back the source buffer with XpuCommandTag__CPUFallback
+		 *
+		 * KDS_FORMAT_BLOCK and KDS_FORMAT_ARROW must be send back the
+		 * backend process from the GPU device buffer, because the original
+		 * kds_src does not have data contents itself.
+		 * For KDS_FORMAT_COLUMN, it is equivalent to the kernel buffer,
+		 * and its size tends to be large. So, CPU fallback uses regular
+		 * heap-scan instead.
+		 */
+		if (s_chunk)
+		{
+			__kds_src = malloc(s_chunk->__length);
+			if (!__kds_src)
+			{
+				gpuClientELog(gclient, "out of memory for CPU fallback (sz=%lu)",
+							  s_chunk->__length);
+				goto bailout;
+			}
+			rc = cuMemcpyDtoH(__kds_src, s_chunk->m_devptr, s_chunk->__length);
+			if (rc != CUDA_SUCCESS)
+			{
+				free(__kds_src);
+				gpuClientELog(gclient, "failed on cuMemcpyDtoH: %s", cuStrError(rc));
+				goto bailout;
+			}
+		}
+		memset(&resp, 0, sizeof(resp));
+		resp.magic = XpuCommandMagicNumber;
+		resp.tag   = XpuCommandTag__CPUFallback;
+		memcpy(&resp.u.fallback.error,
+			   &kgtask->kerror,
+			   sizeof(kern_errorbuf));
+		resp.u.fallback.npages_direct_read = npages_direct_read;
+		resp.u.fallback.npages_vfs_read = npages_vfs_read;
+		__gpuservUpdateTaskStats(gcontext, true,
+								 npages_direct_read,
+								 npages_vfs_read,
+								 tv_load,
+								 usec_kernel,
+								 0);
+		gpuClientWriteBack(gclient,
+						   &resp,
+						   offsetof(XpuCommand, u.fallback.kds_src),
+						   1, &__kds_src);
+		if (kds_src != __kds_src)
+			free(__kds_src);
+	}
+	else
+	{
+		/* send back error status */
+		__gpuClientELogRaw(gclient, &kgtask->kerror);
+	}
+bailout:
+	if (tgraph)
+		__gpuservFreeTaskGraph(tgraph);
+	if (kds_final_locked)
+		pthreadRWLockUnlock(&gq_buf->m_kds_final_rwlock);
+	if (s_chunk)
+	{
+		/* asynchronous copy onto s_chunk may be still in-progress on errors */
+		(void)cuStreamSynchronize(MY_STREAM_PER_THREAD);
+		gpuMemFree(s_chunk);
+	}
+	if (t_chunk)
+		gpuMemFree(t_chunk);
+	while (kds_dst_nitems > 0)
+	{
+		kds_dst_nitems--;
+		if (d_chunk_array[kds_dst_nitems])
+			gpuMemFree(d_chunk_array[kds_dst_nitems]);
+		else
+			cuMemFree((CUdeviceptr)kds_dst_array[kds_dst_nitems]);	/* flushed kds_final */
+	}
+	if (gc_lmap)
+		gpuCachePutDeviceBuffer(gc_lmap);
+}
+
+/* ------------------------------------------------------------
+ *
+ * gpuservGpuCacheManager - GpuCache worker
+ *
+ * ------------------------------------------------------------
+ */
+static void *
+gpuservGpuCacheManager(void *__arg)
+{
+	gpuWorker  *gworker = (gpuWorker *)__arg;
+	gpuContext *gcontext = gworker->gcontext;
+	CUresult	rc;
+
+	rc = cuCtxSetCurrent(gcontext->cuda_context);
+	if (rc != CUDA_SUCCESS)
+		__FATAL("failed on cuCtxSetCurrent: %s", cuStrError(rc));
+
+	gpuDevBindNumaThread(gcontext->cuda_dindex);
+	GpuWorkerCurrentContext	= gcontext;
+	MY_DINDEX_PER_THREAD	= gcontext->cuda_dindex;
+	MY_DEVICE_PER_THREAD	= gcontext->cuda_device;
+	MY_CONTEXT_PER_THREAD	= gcontext->cuda_context;
+	MY_STREAM_PER_THREAD	= CU_STREAM_LEGACY;
+	MY_EVENT_PER_THREAD		= NULL;
+	pg_memory_barrier();
+
+	__gpuservTraceThreadSetup("GPU-%d gpucache", MY_DINDEX_PER_THREAD);
+
+	GpuServDebug("GPU-%d GpuCache manager thread launched.",
+				 MY_DINDEX_PER_THREAD);
+	
+	gpucacheManagerEventLoop(gcontext->cuda_dindex,
+							 gcontext->cuda_context,
+							 gcontext->cuda_module);
+
+	/* delete gpuWorker from the gpuContext */
+	pthreadMutexLock(&gcontext->worker_lock);
+	dlist_delete(&gworker->chain);
+	pthreadMutexUnlock(&gcontext->worker_lock);
+	free(gworker);
+	__gpuservTraceThreadCleanup();
+
+	GpuServDebug("GPU-%d GpuCache manager terminated.",
+				 MY_DINDEX_PER_THREAD);
+	return NULL;
+}
+
+/* ----------------------------------------------------------------
+ *
+ * gpuservHandleGpuTaskFinal
+ *
+ * ----------------------------------------------------------------
+ */
+
+/*
+ * __gpuservGpuJoinRightOuter
+ *
+ * It runs kern_gpujoin_main for each RIGHT/FULL OUTER JOIN depth, starting
+ * from the unmatched inner tuples instead of the outer relation scan, to
+ * generate the null-extended rows on the device. The outer-join-map merged
+ * by all the devices is already on the host buffer at the final_plan_node,
+ * and the deeper depths also update the outer-join-map of the device, so
+ * these depths are processed one by one.
+ * It returns 1 if the results are built, 0 if the backend must process the
+ * unmatched tuples by CPU, or -1 if an error was already reported.
+ */
+static int
+__gpuservGpuJoinRightOuter(gpuClient *gclient,
+						   XpuCommand *xcmd,
+						   uint32_t *p_nitems_out,
+						   int *p_kds_dst_nitems,
+						   kern_data_store ***p_kds_dst_array,
+						   gpuMemChunk ***p_d_chunk_array)
+{
+	kern_session_info *session = gclient->session;
+	gpuQueryBuffer *gq_buf = gclient->gq_buf;
+	kern_multirels *d_kmrels = (kern_multirels *)gq_buf->m_kmrels;
+	kern_multirels *h_kmrels = (kern_multirels *)gq_buf->h_kmrels;
+	kern_data_store *kds_dst_head;
+	kern_data_store *kds_dst;
+	kern_data_store **kds_dst_array = NULL;
+	gpuMemChunk	  **d_chunk_array = NULL;
+	int				kds_dst_nitems = 0;
+	int				kds_dst_nrooms = 0;
+	gpuMemChunk	   *t_chunk = NULL;
+	gpuMemChunk	   *d_chunk;
+	kern_gputask   *kgtask;
+	CUfunction		f_kern_gpujoin;
+	CUdeviceptr		m_kmrels = gq_buf->m_kmrels;
+	CUdeviceptr		m_kds_src = 0UL;
+	CUdeviceptr		m_kds_extra = 0UL;
+	CUresult		rc;
+	int				grid_sz;
+	int				block_sz;
+	unsigned int	shmem_sz;
+	unsigned int	groupby_prepfn_bufsz;
+	unsigned int	groupby_prepfn_nbufs;
+	uint32_t		nitems_out = 0;
+	size_t			sz;
+	void		   *kern_args[10];
+	uint64_t		tv_trace = gpuservTraceBegin();
+	int				retval = -1;
+
+	if (!session->join_right_outer_on_device ||
+		xcmd->u.fin.kds_dst_offset == 0 ||
+		gq_buf->m_kds_final != 0UL ||
+		__kmrelsHasInnerPartitions(h_kmrels))
+		return 0;
+	kds_dst_head = (kern_data_store *)((char *)xcmd + xcmd->u.fin.kds_dst_offset);
+
+	/* merge the outer-join-map of the other devices */
+	for (int i=0; i < d_kmrels->num_rels; i++)
+	{
+		kern_data_store *kds = KERN_MULTIRELS_INNER_KDS(h_kmrels, i);
+		bool   *d_ojmap = KERN_MULTIRELS_OUTER_JOIN_MAP(d_kmrels, i);
+		bool   *h_ojmap = KERN_MULTIRELS_OUTER_JOIN_MAP(h_kmrels, i);
+
+		if (d_ojmap && h_ojmap)
+		{
+			for (uint32_t j=0; j < kds->nitems; j++)
+				d_ojmap[j] |= h_ojmap[j];
+		}
+	}
+
+	rc = cuModuleGetFunction(&f_kern_gpujoin,
+							 gclient->cuda_module,
+							 "kern_gpujoin_main");
+	if (rc != CUDA_SUCCESS)
+	{
+		gpuClientFatal(gclient, "failed on cuModuleGetFunction: %s",
+					   cuStrError(rc));
+		goto bailout;
+	}
+	if (!__gpuservLookupKernelGeometry(gclient, f_kern_gpujoin,
+									   &grid_sz,
+									   &block_sz,
+									   &shmem_sz,
+									   &groupby_prepfn_bufsz,
+									   &groupby_prepfn_nbufs))
+		goto bailout;
+
+	sz = KERN_GPUTASK_LENGTH(session->kcxt_kvecs_ndims,
+							 session->kcxt_kvecs_bufsz,
+							 grid_sz, block_sz);
+	t_chunk = gpuMemAllocManaged(sz);
+	if (!t_chunk)
+	{
+		gpuClientFatal(gclient, "failed on gpuMemAllocManaged: %lu", sz);
+		goto bailout;
+	}
+	kgtask = (kern_gputask *)t_chunk->m_devptr;
+
+	for (int depth=1; depth <= h_kmrels->num_rels; depth++)
+	{
+		if (!h_kmrels->chunks[depth-1].right_outer)
+			continue;
+
+		memset(kgtask, 0, offsetof(kern_gputask, stats[h_kmrels->num_rels]));
+		kgtask->grid_sz  = grid_sz;
+		kgtask->block_sz = block_sz;
+		kgtask->kvars_nslots = session->kcxt_kvars_nslots;
+		kgtask->kvecs_bufsz  = session->kcxt_kvecs_bufsz;
+		kgtask->kvecs_ndims  = session->kcxt_kvecs_ndims;
+		kgtask->n_rels       = h_kmrels->num_rels;
+		kgtask->groupby_prepfn_bufsz = groupby_prepfn_bufsz;
+		kgtask->groupby_prepfn_nbufs = groupby_prepfn_nbufs;
+		kgtask->right_outer_depth = depth;
+	resume_kernel:
+		/* allocation of the destination buffer */
+		sz = KDS_HEAD_LENGTH(kds_dst_head) + PGSTROM_CHUNK_SIZE;
+		d_chunk = gpuMemAllocManaged(sz);
+		if (!d_chunk)
+		{
+			gpuClientFatal(gclient, "failed on gpuMemAllocManaged(%lu)", sz);
+			goto bailout;
+		}
+		kds_dst = (kern_data_store *)d_chunk->m_devptr;
+		memcpy(kds_dst, kds_dst_head, KDS_HEAD_LENGTH(kds_dst_head));
+		kds_dst->length = sz;
+		if (kds_dst_nitems >= kds_dst_nrooms)
+		{
+			kern_data_store	**kds_dst_temp;
+			gpuMemChunk		**d_chunk_temp;
+
+			kds_dst_nrooms = 2 * kds_dst_nrooms + 10;
+			kds_dst_temp = realloc(kds_dst_array, sizeof(kern_data_store *) * kds_dst_nrooms);
+			if (kds_dst_temp)
+				kds_dst_array = kds_dst_temp;
+			d_chunk_temp = realloc(d_chunk_array, sizeof(gpuMemChunk *) * kds_dst_nrooms);
+			if (d_chunk_temp)
+				d_chunk_array = d_chunk_temp;
+			if (!kds_dst_temp || !d_chunk_temp)
+			{
+				gpuMemFree(d_chunk);
+				gpuClientFatal(gclient, "out of memory");
+				goto bailout;
+			}
+		}
+		kds_dst_array[kds_dst_nitems] = kds_dst;
+		d_chunk_array[kds_dst_nitems] = d_chunk;
+		kds_dst_nitems++;
+
+		/* launch kernel */
+		kern_args[0] = &gclient->session;
+		kern_args[1] = &kgtask;
+		kern_args[2] = &m_kmrels;
+		kern_args[3] = &m_kds_src;
+		kern_args[4] = &m_kds_extra;
+		kern_args[5] = &kds_dst;
+		rc = cuLaunchKernel(f_kern_gpujoin,
+							grid_sz, 1, 1,
+							block_sz, 1, 1,
+							shmem_sz,
+							MY_STREAM_PER_THREAD,
+							kern_args,
+							NULL);
+		if (rc != CUDA_SUCCESS)
+		{
+			gpuClientFatal(gclient, "failed on cuLaunchKernel: %s", cuStrError(rc));
+			goto bailout;
+		}
+		rc = cuStreamSynchronize(MY_STREAM_PER_THREAD);
+		if (rc != CUDA_SUCCESS)
+		{
+			gpuClientFatal(gclient, "failed on cuStreamSynchronize: %s", cuStrError(rc));
+			goto bailout;
+		}
+
+		if (kgtask->kerror.errcode == ERRCODE_CPU_FALLBACK)
+		{
+			/* the backend processes the unmatched tuples by CPU */
+			retval = 0;
+			goto bailout;
+		}
+		else if (kgtask->kerror.errcode != ERRCODE_STROM_SUCCESS)
+		{
+			__gpuClientELogRaw(gclient, &kgtask->kerror);
+			goto bailout;
+		}
+		if (kgtask->suspend_count > 0)
+		{
+			if (gpuServiceGoingTerminate())
+			{
+				gpuClientFatal(gclient, "GpuService is going to terminate during RIGHT OUTER JOIN kernel suspend/resume");
 				goto bailout;
 			}
-			/* restore warp context from the previous state */
+			pg_atomic_fetch_add_u64(&GPUSERV_DEVICE_STATS(gclient->gcontext->cuda_dindex)->nr_suspends, 1);
 			kgtask->resume_context = true;
 			kgtask->suspend_count = 0;
-			GpuServDebug("suspend / resume happen\n");
-			if (kds_final_locked)
-				pthreadRWLockUnlock(&gq_buf->m_kds_final_rwlock);
 			goto resume_kernel;
 		}
-		/* send back status and kds_dst */
-		resp_sz = MAXALIGN(offsetof(XpuCommand,
-									u.results.stats[num_inner_rels]));
-		resp = alloca(resp_sz);
-		memset(resp, 0, resp_sz);
-		resp->magic = XpuCommandMagicNumber;
-		resp->tag   = XpuCommandTag__Success;
-		resp->u.results.chunks_nitems = kds_dst_nitems;
-		resp->u.results.chunks_offset = resp_sz;
-		resp->u.results.npages_direct_read = npages_direct_read;
-		resp->u.results.npages_vfs_read = npages_vfs_read;
-		resp->u.results.nitems_raw = kgtask->nitems_raw;
-		resp->u.results.nitems_in  = kgtask->nitems_in;
-		resp->u.results.nitems_out = kgtask->nitems_out;
-		resp->u.results.num_rels = num_inner_rels;
-		for (int i=0; i < num_inner_rels; i++)
-		{
-			resp->u.results.stats[i].nitems_gist = kgtask->stats[i].nitems_gist;
-			resp->u.results.stats[i].nitems_out  = kgtask->stats[i].nitems_out;
-		}
-		gpuClientWriteBack(gclient,
-						   resp, resp_sz,
-						   kds_dst_nitems, kds_dst_array);
+		nitems_out += kgtask->nitems_out;
 	}
-	else if (kgtask->kerror.errcode == ERRCODE_CPU_FALLBACK)
-	{
-		kern_data_store *__kds_src = kds_src;
-		XpuCommand	resp;
+	__gpuservPrefetchResultsToHost(kds_dst_nitems, kds_dst_array);
+	gpuservTraceEnd("gpu", "right outer join", tv_trace);
+
+	*p_nitems_out = nitems_out;
+	*p_kds_dst_nitems = kds_dst_nitems;
+	*p_kds_dst_array = kds_dst_array;
+	*p_d_chunk_array = d_chunk_array;
+	gpuMemFree(t_chunk);
+	return 1;
+
+bailout:
+	if (t_chunk)
+		gpuMemFree(t_chunk);
+	while (kds_dst_nitems > 0)
+		gpuMemFree(d_chunk_array[--kds_dst_nitems]);
+	if (kds_dst_array)
+		free(kds_dst_array);
+	if (d_chunk_array)
+		free(d_chunk_array);
+	return retval;
+}
+
+static void
+gpuservHandleGpuTaskFinal(gpuClient *gclient, XpuCommand *xcmd)
+{
+	kern_final_task *kfin = &xcmd->u.fin;
+	gpuQueryBuffer *gq_buf;
+	XpuCommand		resp;
+	kern_data_store	*kds_final = NULL;
+	kern_data_store **kds_dst_array = &kds_final;
+	gpuMemChunk	  **d_chunk_array = NULL;
+	int				kds_dst_nitems = 0;
+
+	if (gclient->gq_buf_deferred &&
+		!__gpuClientAttachDeferredBuffer(gclient))
+		return;
+	gq_buf = gclient->gq_buf;
+	memset(&resp, 0, sizeof(XpuCommand));
+	resp.magic = XpuCommandMagicNumber;
+	resp.tag   = XpuCommandTag__Success;
+	resp.u.results.chunks_offset = MAXALIGN(offsetof(XpuCommand, u.results.stats));
+	resp.u.results.chunks_nitems = 0;
 
+	if (kfin->final_this_device && gq_buf)
+	{
 		/*
-		 * Send back the source buffer with XpuCommandTag__CPUFallback
-		 *
-		 * KDS_FORMAT_BLOCK and KDS_FORMAT_ARROW must be send back the
-		 * backend process from the GPU device buffer, because the original
-		 * kds_src does not have data contents itself.
-		 * For KDS_FORMAT_COLUMN, it is equivalent to the kernel buffer,
-		 * and its size tends to be large. So, CPU fallback uses regular
-		 * heap-scan instead.
+		 * Is the outer-join-map written back to the host buffer?
 		 */
-		if (s_chunk)
+		if (gq_buf->m_kmrels != 0UL &&
+			gq_buf->h_kmrels != NULL)
 		{
-			__kds_src = malloc(s_chunk->__length);
-			if (!__kds_src)
-			{
-				gpuClientELog(gclient, "out of memory for CPU fallback (sz=%lu)",
-							  s_chunk->__length);
-				goto bailout;
-			}
-			rc = cuMemcpyDtoH(__kds_src, s_chunk->m_devptr, s_chunk->__length);
-			if (rc != CUDA_SUCCESS)
+			kern_multirels *d_kmrels = (kern_multirels *)gq_buf->m_kmrels;
+			kern_multirels *h_kmrels = (kern_multirels *)gq_buf->h_kmrels;
+
+			for (int i=0; i < d_kmrels->num_rels; i++)
 			{
-				free(__kds_src);
-				gpuClientELog(gclient, "failed on cuMemcpyDtoH: %s", cuStrError(rc));
-				goto bailout;
+				kern_data_store *kds = KERN_MULTIRELS_INNER_KDS(h_kmrels, i);
+				bool   *d_ojmap = KERN_MULTIRELS_OUTER_JOIN_MAP(d_kmrels, i);
+				bool   *h_ojmap = KERN_MULTIRELS_OUTER_JOIN_MAP(h_kmrels, i);
+
+				if (d_ojmap && h_ojmap)
+				{
+					for (uint32_t j=0; j < kds->nitems; j++)
+						h_ojmap[j] |= d_ojmap[j];
+					resp.u.results.final_this_device = true;
+				}
 			}
 		}
-		memset(&resp, 0, sizeof(resp));
-		resp.magic = XpuCommandMagicNumber;
-		resp.tag   = XpuCommandTag__CPUFallback;
-		memcpy(&resp.u.fallback.error,
-			   &kgtask->kerror,
-			   sizeof(kern_errorbuf));
-		resp.u.fallback.npages_direct_read = npages_direct_read;
-		resp.u.fallback.npages_vfs_read = npages_vfs_read;
-		gpuClientWriteBack(gclient,
-						   &resp,
-						   offsetof(XpuCommand, u.fallback.kds_src),
-						   1, &__kds_src);
-		if (kds_src != __kds_src)
-			free(__kds_src);
+
+		/*
+		 * Is the GpuPreAgg final buffer written back?
+		 */
+		if (gq_buf->m_kds_final != 0UL)
+		{
+			kds_final = (kern_data_store *)gq_buf->m_kds_final;
+			resp.u.results.chunks_nitems = 1;
+			resp.u.results.final_this_device = true;
+		}
 	}
-	else
+	resp.u.results.final_plan_node = kfin->final_plan_node;
+
+	/*
+	 * Completion of RIGHT/FULL OUTER JOIN on the device, if possible
+	 */
+	if (kfin->final_plan_node && gq_buf &&
+		gq_buf->m_kmrels != 0UL &&
+		gq_buf->h_kmrels != NULL)
 	{
-		/* send back error status */
-		__gpuClientELogRaw(gclient, &kgtask->kerror);
+		int		status = __gpuservGpuJoinRightOuter(gclient, xcmd,
+													&resp.u.results.nitems_out,
+													&kds_dst_nitems,
+													&kds_dst_array,
+													&d_chunk_array);
+		if (status < 0)
+			return;
+		if (status > 0)
+		{
+			resp.u.results.chunks_nitems = kds_dst_nitems;
+			resp.u.results.final_right_outer = true;
+		}
+	}
+
+	gpuClientWriteBack(gclient, &resp,
+					   resp.u.results.chunks_offset,
+					   resp.u.results.chunks_nitems,
+					   kds_dst_array);
+	if (d_chunk_array)
+	{
+		while (kds_dst_nitems > 0)
+			gpuMemFree(d_chunk_array[--kds_dst_nitems]);
+		free(kds_dst_array);
+		free(d_chunk_array);
 	}
-bailout:
-	if (kds_final_locked)
-		pthreadRWLockUnlock(&gq_buf->m_kds_final_rwlock);
-	if (s_chunk)
-		gpuMemFree(s_chunk);
-	if (t_chunk)
-		gpuMemFree(t_chunk);
-	while (kds_dst_nitems > 0)
-		gpuMemFree(d_chunk_array[--kds_dst_nitems]);
-	if (gc_lmap)
-		gpuCachePutDeviceBuffer(gc_lmap);
 }
 
-/* ------------------------------------------------------------
+/*
+ * Coalescing of small GPU tasks
  *
- * gpuservGpuCacheManager - GpuCache worker
+ * Small chunks (e.g, tail of the relation, tiny tables) leave most of SMs
+ * idle. If multiple XpuTaskExec commands of the same session are pending
+ * and their source KDS are already loaded on the host memory, the worker
+ * merges them into one KDS and launches the GPU kernel at once. Results are
+ * written back on the response of the leader command, and the other commands
+ * receive empty responses to keep the number of running commands on the
+ * backend side.
+ */
+#define GPUSERV_COALESCE_MAX_COMMANDS		64
+
+static bool
+__gpuservIsCoalescableGpuTask(const XpuCommand *xcmd, size_t threshold)
+{
+	const kern_data_store *kds;
+
+	if (xcmd->tag != XpuCommandTag__XpuTaskExec ||
+		xcmd->u.task.kds_src_offset == 0 ||
+		xcmd->u.task.kds_src_pathname != 0)
+		return false;
+	kds = (const kern_data_store *)
+		((const char *)xcmd + xcmd->u.task.kds_src_offset);
+	if (kds->format == KDS_FORMAT_ROW)
+		return ((KDS_HEAD_LENGTH(kds) +
+				 MAXALIGN(sizeof(uint32_t) * kds->nitems) +
+				 __kds_unpack(kds->usage)) < threshold);
+	if (kds->format == KDS_FORMAT_BLOCK)
+		return (kds->block_nloaded == kds->nitems &&
+				(size_t)BLCKSZ * kds->nitems < threshold);
+	return false;
+}
+
+static void
+__gpuservSetupCoalescedKds(kern_data_store *kds_dst,
+						   int nitems, kern_data_store **kds_array)
+{
+	kern_data_store *kds_head = kds_array[0];
+	size_t		head_sz = KDS_HEAD_LENGTH(kds_head);
+	uint32_t	nitems_total = 0;
+	int			i, j;
+
+	memcpy(kds_dst, kds_head, head_sz);
+	for (i=0; i < nitems; i++)
+		nitems_total += kds_array[i]->nitems;
+
+	if (kds_head->format == KDS_FORMAT_ROW)
+	{
+		uint32_t   *rowindex;
+		size_t		usage = 0;
+
+		for (i=0; i < nitems; i++)
+			usage += __kds_unpack(kds_array[i]->usage);
+		kds_dst->length = (head_sz +
+						   MAXALIGN(sizeof(uint32_t) * nitems_total) +
+						   usage);
+		kds_dst->nitems = nitems_total;
+		kds_dst->usage = __kds_packed(usage);
+		rowindex = KDS_GET_ROWINDEX(kds_dst);
+		/* tuples are located from the tail, and referenced by the offset */
+		usage = 0;
+		for (i=0; i < nitems; i++)
+		{
+			kern_data_store *kds = kds_array[i];
+			uint32_t   *__rowindex = KDS_GET_ROWINDEX(kds);
+			size_t		sz = __kds_unpack(kds->usage);
+			uint32_t	base = __kds_packed(usage);
+
+			memcpy((char *)kds_dst + kds_dst->length - (usage + sz),
+				   (char *)kds + kds->length - sz, sz);
+			for (j=0; j < kds->nitems; j++)
+				*rowindex++ = (__rowindex[j] != 0 ? __rowindex[j] + base : 0);
+			usage += sz;
+		}
+	}
+	else
+	{
+		char	   *pos;
+
+		Assert(kds_head->format == KDS_FORMAT_BLOCK);
+		kds_dst->block_offset = (head_sz +
+								 MAXALIGN(sizeof(BlockNumber) * nitems_total));
+		kds_dst->length = kds_dst->block_offset + (size_t)BLCKSZ * nitems_total;
+		kds_dst->nitems = nitems_total;
+		kds_dst->block_nloaded = nitems_total;
+		kds_dst->usage = 0;
+		pos = (char *)kds_dst + kds_dst->block_offset;
+		for (i=0, j=0; i < nitems; i++)
+		{
+			kern_data_store *kds = kds_array[i];
+
+			memcpy(&KDS_BLOCK_BLCKNR(kds_dst, j),
+				   &KDS_BLOCK_BLCKNR(kds, 0),
+				   sizeof(BlockNumber) * kds->nitems);
+			memcpy(pos, (char *)kds + kds->block_offset,
+				   (size_t)BLCKSZ * kds->nitems);
+			pos += (size_t)BLCKSZ * kds->nitems;
+			j += kds->nitems;
+		}
+	}
+}
+
+static void
+__gpuservSendEmptyResults(gpuClient *gclient)
+{
+	XpuCommand	resp;
+
+	memset(&resp, 0, sizeof(XpuCommand));
+	resp.magic = XpuCommandMagicNumber;
+	resp.tag   = XpuCommandTag__Success;
+	resp.u.results.chunks_offset = MAXALIGN(offsetof(XpuCommand,
+													 u.results.stats[0]));
+	gpuClientWriteBack(gclient, &resp,
+					   resp.u.results.chunks_offset,
+					   0, NULL);
+}
+
+/*
+ * __gpuservScanLimitIsSatisfied
  *
- * ------------------------------------------------------------
+ * It checks whether the rows already returned to the backend are enough
+ * to satisfy the LIMIT clause. If true, pending tasks of the session are
+ * no longer needed, so the worker just sends back an empty result instead
+ * of loading and processing the chunk.
  */
-static void *
-gpuservGpuCacheManager(void *__arg)
+static bool
+__gpuservScanLimitIsSatisfied(gpuClient *gclient)
 {
-	gpuWorker  *gworker = (gpuWorker *)__arg;
-	gpuContext *gcontext = gworker->gcontext;
-	CUresult	rc;
+	kern_session_info *session = gclient->session;
 
-	rc = cuCtxSetCurrent(gcontext->cuda_context);
-	if (rc != CUDA_SUCCESS)
-		__FATAL("failed on cuCtxSetCurrent: %s", cuStrError(rc));
+	return (session &&
+			session->scan_limit > 0 &&
+			pg_atomic_read_u64(&gclient->scan_nitems_out) >= session->scan_limit);
+}
 
-	GpuWorkerCurrentContext	= gcontext;
-	MY_DINDEX_PER_THREAD	= gcontext->cuda_dindex;
-	MY_DEVICE_PER_THREAD	= gcontext->cuda_device;
-	MY_CONTEXT_PER_THREAD	= gcontext->cuda_context;
-	MY_STREAM_PER_THREAD	= CU_STREAM_LEGACY;
-	MY_EVENT_PER_THREAD		= NULL;
-	pg_memory_barrier();
+/*
+ * __gpuservCoalesceGpuTaskExec
+ *
+ * It returns true if the supplied command was executed together with the
+ * pending commands. Elsewhere, the caller should execute it as usual.
+ */
+static bool
+__gpuservCoalesceGpuTaskExec(gpuContext *gcontext,
+							 gpuClient *gclient,
+							 XpuCommand *xcmd)
+{
+	size_t			threshold = (size_t)pgstrom_gpu_task_coalesce_threshold_kb << 10;
+	XpuCommand	   *merged[GPUSERV_COALESCE_MAX_COMMANDS];
+	kern_data_store *kds_array[GPUSERV_COALESCE_MAX_COMMANDS + 1];
+	kern_data_store *kds_src;
+	XpuCommand	   *xcmd_new;
+	gpuMemChunk	   *chunk;
+	dlist_mutable_iter iter;
+	size_t			total_sz;
+	size_t			sz;
+	int				nmerged = 0;
 
-	GpuServDebug("GPU-%d GpuCache manager thread launched.",
-				 MY_DINDEX_PER_THREAD);
-	
-	gpucacheManagerEventLoop(gcontext->cuda_dindex,
-							 gcontext->cuda_context,
-							 gcontext->cuda_module);
+	if (threshold == 0 || !__gpuservIsCoalescableGpuTask(xcmd, threshold))
+		return false;
+	kds_src = (kern_data_store *)((char *)xcmd + xcmd->u.task.kds_src_offset);
+	kds_array[0] = kds_src;
+	total_sz = kds_src->length;
 
-	/* delete gpuWorker from the gpuContext */
-	pthreadMutexLock(&gcontext->worker_lock);
-	dlist_delete(&gworker->chain);
-	pthreadMutexUnlock(&gcontext->worker_lock);
-	free(gworker);
+	pthreadMutexLock(&gcontext->lock);
+	dlist_foreach_modify(iter, &gcontext->command_list)
+	{
+		XpuCommand *__xcmd = dlist_container(XpuCommand, chain, iter.cur);
+		kern_data_store *kds;
 
-	GpuServDebug("GPU-%d GpuCache manager terminated.",
-				 MY_DINDEX_PER_THREAD);
-	return NULL;
+		if (__xcmd->priv != gclient ||
+			__xcmd->u.task.inner_part_id != xcmd->u.task.inner_part_id ||
+			__xcmd->u.task.kds_src_offset != xcmd->u.task.kds_src_offset ||
+			!__gpuservIsCoalescableGpuTask(__xcmd, threshold))
+			continue;
+		kds = (kern_data_store *)((char *)__xcmd + __xcmd->u.task.kds_src_offset);
+		if (kds->format != kds_src->format ||
+			kds->nr_colmeta != kds_src->nr_colmeta ||
+			total_sz + kds->length > PGSTROM_CHUNK_SIZE)
+			continue;
+		dlist_delete(iter.cur);
+		merged[nmerged++] = __xcmd;
+		kds_array[nmerged] = kds;
+		total_sz += kds->length;
+		if (nmerged >= GPUSERV_COALESCE_MAX_COMMANDS)
+			break;
+	}
+	pthreadMutexUnlock(&gcontext->lock);
+	if (nmerged == 0)
+		return false;
+
+	/* build a coalesced command on the managed memory */
+	sz = xcmd->u.task.kds_src_offset + total_sz;
+	chunk = gpuMemAllocManaged(sz);
+	if (chunk)
+	{
+		xcmd_new = (XpuCommand *)chunk->m_devptr;
+		memcpy(xcmd_new, xcmd, xcmd->u.task.kds_src_offset);
+		__gpuservSetupCoalescedKds((kern_data_store *)
+								   ((char *)xcmd_new + xcmd->u.task.kds_src_offset),
+								   nmerged + 1, kds_array);
+		xcmd_new->length = sz;
+		GpuServDebug("GPU task coalescing: %d commands merged", nmerged + 1);
+		gpuservHandleGpuTaskExec(gclient, xcmd_new);
+		gpuMemFree(chunk);
+	}
+	else
+	{
+		/* out of managed memory, so run them individually */
+		gpuservHandleGpuTaskExec(gclient, xcmd);
+	}
+	for (int i=0; i < nmerged; i++)
+	{
+		if (chunk)
+			__gpuservSendEmptyResults(gclient);
+		else
+			gpuservHandleGpuTaskExec(gclient, merged[i]);
+		__gpuServiceFreeCommand(merged[i]);
+		gpuClientPut(gclient, false);
+	}
+	return true;
 }
 
-/* ----------------------------------------------------------------
+/*
+ * __gpuservPickupNextCommand
  *
- * gpuservHandleGpuTaskFinal
+ * It picks up the next command to be executed from the gcontext->command_list.
+ * The queue is not FIFO across the sessions; each session has its virtual
+ * time advanced by 1/weight for each dispatched command, then the command of
+ * the session with the smallest virtual time is chosen (weighted fair queuing
+ * by the priority of the session). Commands of a particular session are still
+ * processed in FIFO order. Sessions that already run the commands on
+ * pg_strom.gpu_worker_max_per_session workers are skipped, as well as the
+ * tasks of the database/role already running the max tasks of its quota.
+ * The quota slot charged by the command is returned on *p_quota.
  *
- * ----------------------------------------------------------------
+ * MEMO: caller must hold the gcontext->lock
  */
-static void
-gpuservHandleGpuTaskFinal(gpuClient *gclient, XpuCommand *xcmd)
+static XpuCommand *
+__gpuservPickupNextCommand(gpuContext *gcontext, gpuQuotaSlot **p_quota)
 {
-	kern_final_task *kfin = &xcmd->u.fin;
-	gpuQueryBuffer *gq_buf = gclient->gq_buf;
-	XpuCommand		resp;
-	kern_data_store	*kds_final = NULL;
-
-	memset(&resp, 0, sizeof(XpuCommand));
-	resp.magic = XpuCommandMagicNumber;
-	resp.tag   = XpuCommandTag__Success;
-	resp.u.results.chunks_offset = MAXALIGN(offsetof(XpuCommand, u.results.stats));
-	resp.u.results.chunks_nitems = 0;
+	XpuCommand *xcmd_next = NULL;
+	gpuClient  *gclient_next = NULL;
+	double		vtime_next = 0.0;
+	dlist_iter	iter;
 
-	if (kfin->final_this_device && gq_buf)
+	dlist_foreach(iter, &gcontext->command_list)
 	{
-		/*
-		 * Is the outer-join-map written back to the host buffer?
-		 */
-		if (gq_buf->m_kmrels != 0UL &&
-			gq_buf->h_kmrels != NULL)
+		XpuCommand *xcmd = dlist_container(XpuCommand, chain, iter.cur);
+		gpuClient  *gclient = xcmd->priv;
+		double		vtime;
+
+		if (gclient == gclient_next)
+			continue;	/* FIFO order in a session */
+		if (pgstrom_gpu_worker_max_per_session > 0 &&
+			gclient->sched_nrunning >= pgstrom_gpu_worker_max_per_session)
+			continue;
+		if (!__gpuQuotaTaskIsRunnable(gclient->quota, xcmd))
+			continue;
+		/* idle sessions start from the current virtual clock */
+		vtime = Max(gclient->sched_vtime, gcontext->sched_vclock);
+		if (!xcmd_next || vtime < vtime_next)
 		{
-			kern_multirels *d_kmrels = (kern_multirels *)gq_buf->m_kmrels;
-			kern_multirels *h_kmrels = (kern_multirels *)gq_buf->h_kmrels;
-
-			for (int i=0; i < d_kmrels->num_rels; i++)
-			{
-				kern_data_store *kds = KERN_MULTIRELS_INNER_KDS(h_kmrels, i);
-				bool   *d_ojmap = KERN_MULTIRELS_OUTER_JOIN_MAP(d_kmrels, i);
-				bool   *h_ojmap = KERN_MULTIRELS_OUTER_JOIN_MAP(h_kmrels, i);
-
-				if (d_ojmap && h_ojmap)
-				{
-					for (uint32_t j=0; j < kds->nitems; j++)
-						h_ojmap[j] |= d_ojmap[j];
-					resp.u.results.final_this_device = true;
-				}
-			}
+			xcmd_next = xcmd;
+			gclient_next = gclient;
+			vtime_next = vtime;
 		}
+	}
 
-		/*
-		 * Is the GpuPreAgg final buffer written back?
-		 */
-		if (gq_buf->m_kds_final != 0UL)
+	if (xcmd_next)
+	{
+		kern_session_info *session = gclient_next->session;
+		uint32_t	weight = XPU_TASK_PRIORITY__NORMAL;
+
+		if (session && session->xpu_task_priority > 0)
+			weight = session->xpu_task_priority;
+		dlist_delete(&xcmd_next->chain);
+		gcontext->sched_vclock = vtime_next;
+		gclient_next->sched_vtime = vtime_next + 1.0 / (double)weight;
+		gclient_next->sched_nrunning++;
+		gcontext->sched_nbusy++;
+		if (gclient_next->quota &&
+			(xcmd_next->tag == XpuCommandTag__XpuTaskExec ||
+			 xcmd_next->tag == XpuCommandTag__XpuTaskExecGpuCache))
 		{
-			kds_final = (kern_data_store *)gq_buf->m_kds_final;
-			resp.u.results.chunks_nitems = 1;
-			resp.u.results.final_this_device = true;
+			pg_atomic_fetch_add_u32(&gclient_next->quota->nr_running, 1);
+			pg_atomic_fetch_add_u64(&gclient_next->quota->nr_tasks, 1);
+			*p_quota = gclient_next->quota;
 		}
 	}
-	resp.u.results.final_plan_node = kfin->final_plan_node;
-
-	gpuClientWriteBack(gclient, &resp,
-					   resp.u.results.chunks_offset,
-					   resp.u.results.chunks_nitems,
-					   &kds_final);
+	return xcmd_next;
 }
 
 /*
@@ -2236,6 +7265,7 @@ gpuservGpuWorkerMain(void *__arg)
 	gpuClient  *gclient;
 	CUstream	cuda_stream;
 	CUevent		cuda_event;
+	CUevent		cuda_event_start;
 	CUresult	rc;
 
 	rc = cuCtxSetCurrent(gcontext->cuda_context);
@@ -2245,16 +7275,23 @@ gpuservGpuWorkerMain(void *__arg)
 	if (rc != CUDA_SUCCESS)
 		 __FATAL("failed on cuStreamCreate: %s", cuStrError(rc));
 	rc = cuEventCreate(&cuda_event, CU_EVENT_DEFAULT);
+	if (rc != CUDA_SUCCESS)
+		__FATAL("failed on cuEventCreate: %s", cuStrError(rc));
+	rc = cuEventCreate(&cuda_event_start, CU_EVENT_DEFAULT);
 	if (rc != CUDA_SUCCESS)
 		__FATAL("failed on cuEventCreate: %s", cuStrError(rc));
 
+	gpuDevBindNumaThread(gcontext->cuda_dindex);
 	GpuWorkerCurrentContext = gcontext;
 	MY_DINDEX_PER_THREAD	= gcontext->cuda_dindex;
 	MY_DEVICE_PER_THREAD	= gcontext->cuda_device;
 	MY_CONTEXT_PER_THREAD	= gcontext->cuda_context;
 	MY_STREAM_PER_THREAD	= cuda_stream;
 	MY_EVENT_PER_THREAD		= cuda_event;
+	MY_EVENT_START_PER_THREAD = cuda_event_start;
+	MY_MEMCACHE_ENABLED		= true;
 	pg_memory_barrier();
+	__gpuservTraceThreadSetup("GPU-%d worker", MY_DINDEX_PER_THREAD);
 
 	GpuServDebug("GPU-%d worker thread launched\n", MY_DINDEX_PER_THREAD);
 	
@@ -2262,13 +7299,35 @@ gpuservGpuWorkerMain(void *__arg)
 	while (!gpuServiceGoingTerminate() && !gworker->termination)
 	{
 		XpuCommand *xcmd;
-		dlist_node *dnode;
+		gpuQuotaSlot *quota = NULL;
 
-		if (!dlist_is_empty(&gcontext->command_list))
+		if ((xcmd = __gpuservPickupNextCommand(gcontext, &quota)) != NULL)
 		{
-			dnode = dlist_pop_head_node(&gcontext->command_list);
-			xcmd = dlist_container(XpuCommand, chain, dnode);
+			uint64_t	tv_start;
+			uint64_t	tv_trace;
+			const char *tag_name;
+
 			pthreadMutexUnlock(&gcontext->lock);
+			tv_start = __gpuservTimeUsec();
+			tv_trace = gpuservTraceBegin();
+			switch (xcmd->tag)
+			{
+				case XpuCommandTag__OpenSession:
+					tag_name = "OpenSession";
+					break;
+				case XpuCommandTag__XpuTaskExec:
+					tag_name = "XpuTaskExec";
+					break;
+				case XpuCommandTag__XpuTaskExecGpuCache:
+					tag_name = "XpuTaskExecGpuCache";
+					break;
+				case XpuCommandTag__XpuTaskFinal:
+					tag_name = "XpuTaskFinal";
+					break;
+				default:
+					tag_name = "unknown";
+					break;
+			}
 
 			gclient = xcmd->priv;
 			/*
@@ -2286,8 +7345,16 @@ gpuservGpuWorkerMain(void *__arg)
 											 * end of the session. */
 						break;
 					case XpuCommandTag__XpuTaskExec:
+						if (__gpuservScanLimitIsSatisfied(gclient))
+							__gpuservSendEmptyResults(gclient);
+						else if (!__gpuservCoalesceGpuTaskExec(gcontext, gclient, xcmd))
+							gpuservHandleGpuTaskExec(gclient, xcmd);
+						break;
 					case XpuCommandTag__XpuTaskExecGpuCache:
-						gpuservHandleGpuTaskExec(gclient, xcmd);
+						if (__gpuservScanLimitIsSatisfied(gclient))
+							__gpuservSendEmptyResults(gclient);
+						else
+							gpuservHandleGpuTaskExec(gclient, xcmd);
 						break;
 					case XpuCommandTag__XpuTaskFinal:
 						gpuservHandleGpuTaskFinal(gclient, xcmd);
@@ -2301,6 +7368,20 @@ gpuservGpuWorkerMain(void *__arg)
 
 			if (xcmd)
 				__gpuServiceFreeCommand(xcmd);
+			gpuservTraceEnd("task", tag_name, tv_trace);
+			pg_atomic_fetch_add_u64(&gcontext->busy_usec,
+									__gpuservTimeUsec() - tv_start);
+			pthreadMutexLock(&gcontext->lock);
+			Assert(gclient->sched_nrunning > 0);
+			gclient->sched_nrunning--;
+			Assert(gcontext->sched_nbusy > 0);
+			gcontext->sched_nbusy--;
+			pthreadMutexUnlock(&gcontext->lock);
+			/* wake up other workers, if commands are held by the cap */
+			if (pgstrom_gpu_worker_max_per_session > 0)
+				pthreadCondSignal(&gcontext->cond);
+			if (quota)
+				__gpuQuotaReleaseTask(quota);
 			gpuClientPut(gclient, false);
 			pthreadMutexLock(&gcontext->lock);
 		}
@@ -2310,20 +7391,25 @@ gpuservGpuWorkerMain(void *__arg)
 		{
 			pthreadMutexUnlock(&gcontext->lock);
 			/* maintenance works */
+			gpuMemThreadCacheFlush();
 			gpuMemoryPoolMaintenance(gcontext);
 			pthreadMutexLock(&gcontext->lock);
 		}
 	}
 	pthreadMutexUnlock(&gcontext->lock);
+	gpuMemThreadCacheFlush();
+	MY_MEMCACHE_ENABLED = false;
 
 	/* detach from the gpuContext */
 	pthreadMutexLock(&gcontext->worker_lock);
 	dlist_delete(&gworker->chain);
 	pthreadMutexUnlock(&gcontext->worker_lock);
 	/* release */
+	cuEventDestroy(cuda_event_start);
 	cuEventDestroy(cuda_event);
 	cuStreamDestroy(cuda_stream);
 	free(gworker);
+	__gpuservTraceThreadCleanup();
 
 	GpuServDebug("GPU-%d worker thread launched\n", MY_DINDEX_PER_THREAD);
 
@@ -2348,14 +7434,21 @@ gpuservMonitorClient(void *__priv)
 					 elabel, cuStrError(rc));
 		goto out;
 	}
+	gpuDevBindNumaThread(gcontext->cuda_dindex);
 	GpuWorkerCurrentContext = gcontext;
 	pg_memory_barrier();
 
+	if (gclient->is_remote && !__gpuservAuthRemoteClient(gclient, elabel))
+		goto out;
 	for (;;)
 	{
 		struct pollfd  pfd;
 		int		nevents;
 
+		/* fetch the commands on the ring buffer first, if any */
+		if (gclient->cmd_ring &&
+			__gpuServiceReceiveRingCommands(gclient, elabel) < 0)
+			break;
 		pfd.fd = sockfd;
 		pfd.events = POLLIN;
 		pfd.revents = 0;
@@ -2386,17 +7479,75 @@ out:
 	return NULL;
 }
 
+/*
+ * __gpuservAuthRemoteClient
+ *
+ * It authenticates the backend on the remote host by the challenge-response
+ * using the shared secret (see gpuServiceAuthDigest), prior to any commands.
+ */
+static bool
+__gpuservAuthRemoteClient(gpuClient *gclient, const char *elabel)
+{
+	pgsocket	sockfd = gclient->sockfd;
+	uint8_t		digest[PG_SHA256_DIGEST_LENGTH];
+	uint8_t		diff = 0;
+	char		result = GPUSERV_AUTH_ACCEPTED;
+	struct timeval tv;
+	ssize_t		nbytes;
+
+	/* the peer that never responds shall not occupy the thread */
+	tv.tv_sec = GPUSERV_REMOTE_AUTH_TIMEOUT;
+	tv.tv_usec = 0;
+	if (setsockopt(sockfd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv)) != 0)
+	{
+		fprintf(stderr, "[%s] failed on setsockopt(SO_RCVTIMEO): %m\n", elabel);
+		return false;
+	}
+	if (send(sockfd, gclient->auth_nonce,
+			 GPUSERV_AUTH_NONCE_LEN, MSG_NOSIGNAL) != GPUSERV_AUTH_NONCE_LEN)
+	{
+		fprintf(stderr, "[%s] failed to send the challenge: %m\n", elabel);
+		return false;
+	}
+	do {
+		nbytes = recv(sockfd, digest, sizeof(digest), MSG_WAITALL);
+	} while (nbytes < 0 && errno == EINTR);
+	/* compare in constant time */
+	for (int i=0; i < PG_SHA256_DIGEST_LENGTH; i++)
+		diff |= (digest[i] ^ gclient->auth_digest[i]);
+	if (nbytes != sizeof(digest) || diff != 0)
+	{
+		fprintf(stderr, "[%s] authentication failed for the remote host\n", elabel);
+		return false;
+	}
+	if (send(sockfd, &result, 1, MSG_NOSIGNAL) != 1)
+	{
+		fprintf(stderr, "[%s] failed to send the authentication result: %m\n", elabel);
+		return false;
+	}
+	/* blocking recv(2) in the halfway of the command read has no timeout */
+	tv.tv_sec = 0;
+	if (setsockopt(sockfd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv)) != 0)
+	{
+		fprintf(stderr, "[%s] failed on setsockopt(SO_RCVTIMEO): %m\n", elabel);
+		return false;
+	}
+	return true;
+}
+
 /*
  * gpuservAcceptClient
  */
 static void
-gpuservAcceptClient(gpuContext *gcontext)
+__gpuservAcceptClient(gpuContext *gcontext, int serv_fd, bool is_remote)
 {
 	gpuClient  *gclient;
+	struct sockaddr_storage addr;
+	socklen_t	addr_len = sizeof(addr);
 	pgsocket	sockfd;
 	int			errcode;
 
-	sockfd = accept(gcontext->serv_fd, NULL, NULL);
+	sockfd = accept(serv_fd, (struct sockaddr *)&addr, &addr_len);
 	if (sockfd < 0)
 	{
 		elog(LOG, "GPU%d: could not accept new connection: %m",
@@ -2416,7 +7567,40 @@ gpuservAcceptClient(gpuContext *gcontext)
 	gclient->gcontext = gcontext;
 	pg_atomic_init_u32(&gclient->refcnt, 1);
 	pthreadMutexInit(&gclient->mutex);
+	pthreadMutexInit(&gclient->graph_lock);
+	pg_atomic_init_u64(&gclient->scan_nitems_out, 0);
+	pg_atomic_init_u32(&gclient->shared_scan_attached, 0);
 	gclient->sockfd = sockfd;
+	if (is_remote)
+	{
+		int		one = 1;
+
+		if (setsockopt(sockfd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one)) != 0)
+			elog(LOG, "failed on setsockopt(TCP_NODELAY): %m");
+		/* the port number is not a part, for the parallel workers */
+		gclient->is_remote = true;
+		if (addr.ss_family == AF_INET)
+			gclient->remote_plan_id_mask =
+				hash_bytes_extended((const unsigned char *)
+									&((struct sockaddr_in *)&addr)->sin_addr,
+									sizeof(struct in_addr), 0);
+		else if (addr.ss_family == AF_INET6)
+			gclient->remote_plan_id_mask =
+				hash_bytes_extended((const unsigned char *)
+									&((struct sockaddr_in6 *)&addr)->sin6_addr,
+									sizeof(struct in6_addr), 0);
+		gclient->remote_plan_id_mask |= 1UL;	/* never be zero */
+		/* challenge and expected response; sent by the receiver thread */
+		if (!pg_strong_random(gclient->auth_nonce, GPUSERV_AUTH_NONCE_LEN))
+		{
+			elog(LOG, "GPU%d: could not generate random nonce",
+				 gcontext->cuda_dindex);
+			close(sockfd);
+			free(gclient);
+			return;
+		}
+		gpuServiceAuthDigest(gclient->auth_nonce, gclient->auth_digest);
+	}
 
 	if ((errcode = pthread_create(&gclient->worker, NULL,
 								  gpuservMonitorClient,
@@ -2430,6 +7614,102 @@ gpuservAcceptClient(gpuContext *gcontext)
 	pthreadMutexLock(&gcontext->client_lock);
 	dlist_push_tail(&gcontext->client_list, &gclient->chain);
 	pthreadMutexUnlock(&gcontext->client_lock);
+	pg_atomic_fetch_add_u32(&GPUSERV_DEVICE_STATS(gcontext->cuda_dindex)->nr_sessions, 1);
+}
+
+static void
+gpuservAcceptClient(gpuContext *gcontext)
+{
+	struct pollfd pfds[2];
+	int		nfds = 0;
+
+	/* either (or both) of the listen sockets are ready */
+	pfds[nfds].fd = gcontext->serv_fd;
+	pfds[nfds].events = POLLIN;
+	pfds[nfds].revents = 0;
+	nfds++;
+	if (gcontext->remote_fd >= 0)
+	{
+		pfds[nfds].fd = gcontext->remote_fd;
+		pfds[nfds].events = POLLIN;
+		pfds[nfds].revents = 0;
+		nfds++;
+	}
+	if (poll(pfds, nfds, 0) <= 0)
+		return;
+	for (int i=0; i < nfds; i++)
+	{
+		if ((pfds[i].revents & POLLIN) != 0)
+			__gpuservAcceptClient(gcontext, pfds[i].fd,
+								  pfds[i].fd == gcontext->remote_fd);
+	}
+}
+
+/*
+ * __gpuservOpenRemoteListenSocket
+ *
+ * It opens the TCP listen socket of GPU<k> for the backends on the remote
+ * hosts (see pg_strom.gpu_service_remote_endpoint), on the port number + k
+ * of pg_strom.gpu_service_listen_address.
+ */
+static int
+__gpuservOpenRemoteListenSocket(int cuda_dindex)
+{
+	struct sockaddr_storage addr;
+	socklen_t	addr_len;
+	int			fdesc;
+	int			one = 1;
+
+	/* the backends on the remote hosts must be authenticated */
+	gpuServiceLoadSecret();
+	/* source files readable by the remote hosts */
+	if (!gpuserv_remote_data_dirs &&
+		pgstrom_gpu_service_remote_data_dir &&
+		*pgstrom_gpu_service_remote_data_dir != '\0')
+	{
+		char	   *config = pstrdup(pgstrom_gpu_service_remote_data_dir);
+		char	   *tok, *pos;
+		char	  **dirs;
+		int			ndirs = 0;
+
+		dirs = MemoryContextAlloc(TopMemoryContext,
+								  sizeof(char *) * (strlen(config) / 2 + 1));
+		for (tok = strtok_r(config, ",", &pos);
+			 tok != NULL;
+			 tok = strtok_r(NULL, ",", &pos))
+		{
+			char	   *dir = MemoryContextAlloc(TopMemoryContext, PATH_MAX);
+
+			tok = __trim(tok);
+			if (*tok == '\0')
+				continue;
+			if (!realpath(tok, dir))
+				elog(ERROR, "pg_strom.gpu_service_remote_data_dir: failed on realpath('%s'): %m", tok);
+			dirs[ndirs++] = dir;
+		}
+		pfree(config);
+		gpuserv_remote_data_dirs = dirs;
+		gpuserv_remote_data_ndirs = ndirs;
+	}
+	gpuServiceSockAddr("pg_strom.gpu_service_listen_address",
+					   pgstrom_gpu_service_listen_address,
+					   cuda_dindex, true,
+					   &addr, &addr_len);
+	fdesc = socket(addr.ss_family, SOCK_STREAM, 0);
+	if (fdesc < 0)
+		elog(ERROR, "failed on socket(2): %m");
+	if (setsockopt(fdesc, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one)) != 0 ||
+		bind(fdesc, (struct sockaddr *)&addr, addr_len) != 0 ||
+		listen(fdesc, 32) != 0)
+	{
+		int		errno_saved = errno;
+
+		close(fdesc);
+		errno = errno_saved;
+		elog(ERROR, "failed to listen on '%s' for GPU%d: %m",
+			 pgstrom_gpu_service_listen_address, cuda_dindex);
+	}
+	return fdesc;
 }
 
 /*
@@ -2591,10 +7871,58 @@ __setupGpuKernelsSharedMemoryConfig(gpuContext *gcontext)
 }
 
 /*
- * gpuservSetupGpuModule
+ * __gpuservSaveGpuModuleCache
+ *
+ * It writes out the linked image to the temporary file, then renames it,
+ * because multiple devices may link the module concurrently.
  */
 static void
-gpuservSetupGpuModule(gpuContext *gcontext)
+__gpuservSaveGpuModuleCache(const char *cache_fname,
+							const void *image, size_t length)
+{
+	char		temp_fname[MAXPGPATH];
+	size_t		offset = 0;
+	ssize_t		nbytes;
+	int			fdesc;
+
+	snprintf(temp_fname, sizeof(temp_fname), "%s.%lx.tmp",
+			 cache_fname, (unsigned long)pthread_self());
+	fdesc = open(temp_fname, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+	if (fdesc < 0)
+	{
+		GpuServDebug("failed on open('%s'): %m", temp_fname);
+		return;
+	}
+	while (offset < length)
+	{
+		nbytes = write(fdesc, (const char *)image + offset, length - offset);
+		if (nbytes > 0)
+			offset += nbytes;
+		else if (nbytes == 0 || errno != EINTR)
+			break;
+	}
+	if (close(fdesc) != 0 || offset < length ||
+		rename(temp_fname, cache_fname) != 0)
+	{
+		GpuServDebug("failed on write out the GPU module cache '%s'", temp_fname);
+		unlink(temp_fname);
+	}
+}
+
+/*
+ * gpuservLinkGpuModule
+ *
+ * It links the builtin fatbin files, and the extra PTX image if any (e.g,
+ * JIT compiled xpucode), then loads the binary to the current context.
+ * It never raises an error, because JIT compilation is also done by
+ * the worker threads.
+ */
+static bool
+__gpuservLinkGpuModule(CUmodule *p_cuda_module,
+					   const char *extra_ptx_image,
+					   size_t extra_ptx_length,
+					   const char *cache_fname,
+					   char *emsg, size_t emsg_sz)
 {
 	CUmodule	cuda_module;
 	CUlinkState	lstate;
@@ -2628,6 +7956,7 @@ gpuservSetupGpuModule(gpuContext *gcontext)
 	jit_index++;
 
 	/* Link log buffer */
+	log_buffer[0] = '\0';
 	jit_options[jit_index] = CU_JIT_ERROR_LOG_BUFFER;
 	jit_option_values[jit_index] = (void *)log_buffer;
 	jit_index++;
@@ -2638,7 +7967,10 @@ gpuservSetupGpuModule(gpuContext *gcontext)
 
 	rc = cuLinkCreate(jit_index, jit_options, jit_option_values, &lstate);
 	if (rc != CUDA_SUCCESS)
-		elog(ERROR, "failed on cuLinkCreate: %s", cuStrError(rc));
+	{
+		snprintf(emsg, emsg_sz, "failed on cuLinkCreate: %s", cuStrError(rc));
+		return false;
+	}
 
 	/* Add builtin fatbin files */
 	cuda_builtin_objs = alloca(sizeof(CUDA_BUILTIN_OBJS) + 1);
@@ -2652,27 +7984,246 @@ gpuservSetupGpuModule(gpuContext *gcontext)
 		snprintf(pathname, MAXPGPATH,
 				 PGSHAREDIR "/pg_strom/%s.fatbin",
 				 __trim(tok));
-		rc = cuLinkAddFile(lstate, CU_JIT_INPUT_FATBINARY,
-						   pathname, 0, NULL, NULL);
-		if (rc != CUDA_SUCCESS)
-			elog(ERROR, "failed on cuLinkAddFile('%s'): %s",
-				 pathname, cuStrError(rc));
+		rc = cuLinkAddFile(lstate, CU_JIT_INPUT_FATBINARY,
+						   pathname, 0, NULL, NULL);
+		if (rc != CUDA_SUCCESS)
+		{
+			snprintf(emsg, emsg_sz, "failed on cuLinkAddFile('%s'): %s",
+					 pathname, cuStrError(rc));
+			goto error;
+		}
+	}
+	/* Add the extra PTX image, if any */
+	if (extra_ptx_image)
+	{
+		rc = cuLinkAddData(lstate, CU_JIT_INPUT_PTX,
+						   (void *)extra_ptx_image,
+						   extra_ptx_length,
+						   "pgstrom_jit.ptx",
+						   0, NULL, NULL);
+		if (rc != CUDA_SUCCESS)
+		{
+			snprintf(emsg, emsg_sz, "failed on cuLinkAddData: %s\n%s",
+					 cuStrError(rc), log_buffer);
+			goto error;
+		}
+	}
+	//TODO: Load the extra CUDA module
+
+	/* do the linkage */
+	rc = cuLinkComplete(lstate, &bin_image, &bin_length);
+	if (rc != CUDA_SUCCESS)
+	{
+		snprintf(emsg, emsg_sz, "failed on cuLinkComplete: %s\n%s",
+				 cuStrError(rc), log_buffer);
+		goto error;
+	}
+	/* save the linked image for the next startup, if required */
+	if (cache_fname)
+		__gpuservSaveGpuModuleCache(cache_fname, bin_image, bin_length);
+
+	rc = cuModuleLoadData(&cuda_module, bin_image);
+	if (rc != CUDA_SUCCESS)
+	{
+		snprintf(emsg, emsg_sz, "failed on cuModuleLoadData: %s",
+				 cuStrError(rc));
+		goto error;
+	}
+
+	rc = cuLinkDestroy(lstate);
+	if (rc != CUDA_SUCCESS)
+	{
+		snprintf(emsg, emsg_sz, "failed on cuLinkDestroy: %s", cuStrError(rc));
+		cuModuleUnload(cuda_module);
+		return false;
+	}
+	*p_cuda_module = cuda_module;
+	return true;
+
+error:
+	cuLinkDestroy(lstate);
+	return false;
+}
+
+bool
+gpuservLinkGpuModule(CUmodule *p_cuda_module,
+					 const char *extra_ptx_image,
+					 size_t extra_ptx_length,
+					 char *emsg, size_t emsg_sz)
+{
+	return __gpuservLinkGpuModule(p_cuda_module,
+								  extra_ptx_image,
+								  extra_ptx_length,
+								  NULL,
+								  emsg, emsg_sz);
+}
+
+/*
+ * gpuModuleLoader - argument of the GPU module loader threads
+ */
+typedef struct
+{
+	gpuContext	   *gcontext;
+	pthread_t		thread;
+	bool			launched;
+	bool			success;
+	bool			cache_hit;
+	CUmodule		cuda_module;
+	char			emsg[20000];
+} gpuModuleLoader;
+
+/*
+ * __gpuservLoadGpuModuleCache
+ *
+ * It loads the linked image saved by the previous startup. The cache file
+ * is identified by the build of PG-Strom, fatbin files, CUDA driver and
+ * the device capability, so the magic of the image is not checked here.
+ * Broken image shall be removed, and linked again.
+ */
+static bool
+__gpuservLoadGpuModuleCache(const char *cache_fname, CUmodule *p_cuda_module)
+{
+	struct stat	stat_buf;
+	char	   *image;
+	ssize_t		nbytes;
+	size_t		offset = 0;
+	int			fdesc;
+	CUresult	rc;
+
+	fdesc = open(cache_fname, O_RDONLY);
+	if (fdesc < 0)
+		return false;
+	if (fstat(fdesc, &stat_buf) != 0 || stat_buf.st_size == 0)
+	{
+		close(fdesc);
+		return false;
+	}
+	image = malloc(stat_buf.st_size);
+	if (!image)
+	{
+		close(fdesc);
+		return false;
+	}
+	while (offset < stat_buf.st_size)
+	{
+		nbytes = read(fdesc, image + offset, stat_buf.st_size - offset);
+		if (nbytes > 0)
+			offset += nbytes;
+		else if (nbytes == 0 || errno != EINTR)
+			break;
+	}
+	close(fdesc);
+	if (offset < stat_buf.st_size)
+	{
+		free(image);
+		return false;
+	}
+	rc = cuModuleLoadData(p_cuda_module, image);
+	free(image);
+	if (rc != CUDA_SUCCESS)
+	{
+		GpuServDebug("failed on cuModuleLoadData('%s'): %s",
+					 cache_fname, cuStrError(rc));
+		unlink(cache_fname);
+		return false;
+	}
+	return true;
+}
+
+/*
+ * __gpuservGpuModuleCacheFname
+ */
+static void
+__gpuservGpuModuleCacheFname(gpuContext *gcontext,
+							 char *fname, size_t fname_sz)
+{
+	GpuDevAttributes *dattrs = &gpuDevAttrs[gcontext->cuda_dindex];
+	char	   *cuda_builtin_objs;
+	char	   *tok, *saveptr;
+	uint64_t	hash;
+
+	hash = hash_bytes_extended((const unsigned char *)PGSTROM_VERSION,
+							   strlen(PGSTROM_VERSION),
+							   dattrs->CUDA_DRIVER_VERSION);
+	hash = hash_combine64(hash, CUDA_MAXREGCOUNT);
+	cuda_builtin_objs = alloca(sizeof(CUDA_BUILTIN_OBJS) + 1);
+	strcpy(cuda_builtin_objs, CUDA_BUILTIN_OBJS);
+	for (tok = strtok_r(cuda_builtin_objs, " ", &saveptr);
+		 tok != NULL;
+		 tok = strtok_r(NULL, " ", &saveptr))
+	{
+		char		pathname[MAXPGPATH];
+		struct stat	stat_buf;
+
+		snprintf(pathname, MAXPGPATH,
+				 PGSHAREDIR "/pg_strom/%s.fatbin",
+				 __trim(tok));
+		hash = hash_combine64(hash, hash_bytes_extended((const unsigned char *)pathname,
+														strlen(pathname), 0));
+		if (stat(pathname, &stat_buf) == 0)
+		{
+			hash = hash_combine64(hash, stat_buf.st_size);
+			hash = hash_combine64(hash, stat_buf.st_mtime);
+		}
 	}
-	//TODO: Load the extra CUDA module
+	snprintf(fname, fname_sz, "%s/sm_%d%d.%016lx.cubin",
+			 GPUSERV_MODULE_CACHE_DIR,
+			 dattrs->COMPUTE_CAPABILITY_MAJOR,
+			 dattrs->COMPUTE_CAPABILITY_MINOR,
+			 hash);
+}
 
-	/* do the linkage */
-	rc = cuLinkComplete(lstate, &bin_image, &bin_length);
-	if (rc != CUDA_SUCCESS)
-		elog(ERROR, "failed on cuLinkComplete: %s\n%s",
-			 cuStrError(rc), log_buffer);
+/*
+ * __gpuservGpuModuleLoaderMain
+ *
+ * It loads the builtin GPU module on the context; from the cache file if
+ * any, or links the fatbin files. It runs on the individual threads for
+ * each device, so never raise an error.
+ */
+static void *
+__gpuservGpuModuleLoaderMain(void *__priv)
+{
+	gpuModuleLoader *loader = __priv;
+	gpuContext *gcontext = loader->gcontext;
+	char		cache_fname[MAXPGPATH];
+	CUresult	rc;
 
-	rc = cuModuleLoadData(&cuda_module, bin_image);
+	rc = cuCtxSetCurrent(gcontext->cuda_context);
 	if (rc != CUDA_SUCCESS)
-		elog(ERROR, "failed on cuModuleLoadData: %s", cuStrError(rc));
+	{
+		snprintf(loader->emsg, sizeof(loader->emsg),
+				 "failed on cuCtxSetCurrent: %s", cuStrError(rc));
+		return NULL;
+	}
+	if (pgstrom_gpu_module_cache)
+	{
+		__gpuservGpuModuleCacheFname(gcontext, cache_fname, sizeof(cache_fname));
+		if (__gpuservLoadGpuModuleCache(cache_fname, &loader->cuda_module))
+		{
+			loader->cache_hit = true;
+			loader->success = true;
+			return NULL;
+		}
+	}
+	loader->success = __gpuservLinkGpuModule(&loader->cuda_module, NULL, 0,
+											 pgstrom_gpu_module_cache
+											 ? cache_fname : NULL,
+											 loader->emsg,
+											 sizeof(loader->emsg));
+	return NULL;
+}
 
-	rc = cuLinkDestroy(lstate);
+/*
+ * gpuservSetupGpuModule
+ */
+static void
+gpuservSetupGpuModule(gpuContext *gcontext, CUmodule cuda_module)
+{
+	CUresult	rc;
+
+	rc = cuCtxSetCurrent(gcontext->cuda_context);
 	if (rc != CUDA_SUCCESS)
-		elog(ERROR, "failed on cuLinkDestroy: %s", cuStrError(rc));
+		elog(ERROR, "failed on cuCtxSetCurrent: %s", cuStrError(rc));
 
 	/* setup XPU linkage hash tables */
 	gcontext->cuda_type_htab = __setupDevTypeLinkageTable(cuda_module);
@@ -2684,6 +8235,60 @@ gpuservSetupGpuModule(gpuContext *gcontext)
 	__setupGpuKernelsSharedMemoryConfig(gcontext);
 }
 
+/*
+ * gpuservSetupGpuModuleAll
+ *
+ * Linkage of the builtin fatbin files takes a few seconds for each device,
+ * so the GPU modules are loaded by the individual threads concurrently.
+ * Then, the XPU linkage catalogs are set up by the main thread; they hold
+ * device addresses of the module just loaded, thus not cached.
+ */
+static void
+gpuservSetupGpuModuleAll(void)
+{
+	gpuModuleLoader *loaders;
+	int			nloaders = 0;
+	dlist_iter	iter;
+
+	if (pgstrom_gpu_module_cache &&
+		MakePGDirectory(GPUSERV_MODULE_CACHE_DIR) != 0 && errno != EEXIST)
+		elog(LOG, "unable to create directory \"%s\": %m",
+			 GPUSERV_MODULE_CACHE_DIR);
+
+	loaders = palloc0(sizeof(gpuModuleLoader) * numGpuDevAttrs);
+	dlist_foreach(iter, &gpuserv_gpucontext_list)
+	{
+		gpuModuleLoader *loader = &loaders[nloaders++];
+
+		loader->gcontext = dlist_container(gpuContext, chain, iter.cur);
+		if (pthread_create(&loader->thread, NULL,
+						   __gpuservGpuModuleLoaderMain,
+						   loader) == 0)
+			loader->launched = true;
+		else
+			__gpuservGpuModuleLoaderMain(loader);
+	}
+	for (int i=0; i < nloaders; i++)
+	{
+		gpuModuleLoader *loader = &loaders[i];
+
+		if (loader->launched)
+			pthread_join(loader->thread, NULL);
+	}
+	for (int i=0; i < nloaders; i++)
+	{
+		gpuModuleLoader *loader = &loaders[i];
+
+		if (!loader->success)
+			elog(ERROR, "GPU%d: %s", loader->gcontext->cuda_dindex, loader->emsg);
+		gpuservSetupGpuModule(loader->gcontext, loader->cuda_module);
+		elog(LOG, "GPU%d: builtin module is %s",
+			 loader->gcontext->cuda_dindex,
+			 loader->cache_hit ? "loaded from the cache" : "linked");
+	}
+	pfree(loaders);
+}
+
 /*
  * __gpuContextAdjustWorkers
  */
@@ -2694,6 +8299,7 @@ __gpuContextAdjustWorkersOne(gpuContext *gcontext, uint32_t nworkers)
 	bool		has_gpucache = false;
 	bool		needs_wakeup = false;
 	uint32_t	count = 0;
+	int			nr_readahead = 0;
 	int			nr_startup = 0;
 	int			nr_terminate = 0;
 	dlist_iter	__iter;
@@ -2708,6 +8314,11 @@ __gpuContextAdjustWorkersOne(gpuContext *gcontext, uint32_t nworkers)
 			if (!gworker->termination)
 				has_gpucache = true;
 		}
+		else if (gworker->kind == GPUSERV_WORKER_KIND__READAHEAD)
+		{
+			if (!gworker->termination)
+				nr_readahead++;
+		}
 		else if (count < nworkers)
 		{
 			if (!gworker->termination)
@@ -2725,7 +8336,8 @@ __gpuContextAdjustWorkersOne(gpuContext *gcontext, uint32_t nworkers)
 	pthreadMutexUnlock(&gcontext->worker_lock);
 	if (needs_wakeup)
 		pthreadCondBroadcast(&gcontext->cond);
-	if (count >= nworkers && has_gpucache)
+	if (count >= nworkers && has_gpucache &&
+		nr_readahead >= pgstrom_arrow_readahead_threads)
 		goto out;
 
 	/* launch workers */
@@ -2760,6 +8372,32 @@ __gpuContextAdjustWorkersOne(gpuContext *gcontext, uint32_t nworkers)
 		count++;
 		nr_startup += 2;
 	}
+	/* arrow read-ahead threads; fixed number */
+	while (nr_readahead < pgstrom_arrow_readahead_threads)
+	{
+		gpuWorker  *gworker = calloc(1, sizeof(gpuWorker));
+
+		if (!gworker)
+		{
+			elog(LOG, "out of memory");
+			break;
+		}
+		gworker->gcontext = gcontext;
+		gworker->kind = GPUSERV_WORKER_KIND__READAHEAD;
+		if ((errno = pthread_create(&gworker->worker,
+									&th_attr,
+									gpuservArrowReadAheadMain,
+									gworker)) != 0)
+		{
+			elog(LOG, "failed on pthread_create: %m");
+			free(gworker);
+			break;
+		}
+		pthreadMutexLock(&gcontext->worker_lock);
+		dlist_push_tail(&gcontext->worker_list, &gworker->chain);
+		pthreadMutexUnlock(&gcontext->worker_lock);
+		nr_readahead++;
+	}
 	if (!has_gpucache)
 	{
 		gpuWorker  *gworker = calloc(1, sizeof(gpuWorker));
@@ -2796,27 +8434,222 @@ out:
 	}
 }
 
+/*
+ * __gpuContextComputeWorkers
+ *
+ * It determines the number of worker threads of the device. If adaptive,
+ * the pool grows when commands are pending while all the workers are busy,
+ * and shrinks by one when workers are mostly idle for a while; according to
+ * the samples of the command queue depth and the execution time of workers.
+ * Elsewhere, the upper bound is used as is.
+ */
+static uint32_t
+__gpuContextComputeWorkers(gpuContext *gcontext, bool updated)
+{
+	gpuServWorkerPool *pool = &gpuserv_shared_state->devs[gcontext->cuda_dindex].pool;
+	uint32_t	nworkers_max;
+	uint32_t	nworkers_min;
+	uint32_t	nworkers = gcontext->pool_nworkers;
+	uint32_t	queue_depth = 0;
+	uint32_t	nbusy;
+	uint64_t	busy_usec;
+	uint64_t	now = __gpuservTimeUsec();
+	double		busy_ratio = 0.0;
+	dlist_iter	iter;
+
+	nworkers_max = (pgstrom_gpu_workers_max > 0
+					? pgstrom_gpu_workers_max
+					: pg_atomic_read_u32(&gpuserv_shared_state->max_async_tasks));
+	nworkers_min = Min(pgstrom_gpu_workers_min, nworkers_max);
+	if (!pgstrom_gpu_workers_adaptive)
+		nworkers_min = nworkers_max;
+	if (!updated &&
+		now < gcontext->pool_last_sample + GPUSERV_WORKER_POOL_INTERVAL * 1000UL)
+		return nworkers;
+
+	/* sampling */
+	pthreadMutexLock(&gcontext->lock);
+	dlist_foreach(iter, &gcontext->command_list)
+		queue_depth++;
+	nbusy = gcontext->sched_nbusy;
+	pthreadMutexUnlock(&gcontext->lock);
+	busy_usec = pg_atomic_read_u64(&gcontext->busy_usec);
+	if (nworkers > 0 && now > gcontext->pool_last_sample)
+		busy_ratio = ((double)(busy_usec - gcontext->pool_last_busy_usec) /
+					  ((double)(now - gcontext->pool_last_sample) *
+					   (double)nworkers));
+	gcontext->pool_last_sample = now;
+	gcontext->pool_last_busy_usec = busy_usec;
+
+	if (nworkers == 0)
+		nworkers = nworkers_min;	/* startup */
+	else if (queue_depth > 0 && nbusy >= nworkers)
+	{
+		/* commands are pending; grow the pool */
+		nworkers += Max(queue_depth / 2, 1);
+		gcontext->pool_idle_rounds = 0;
+	}
+	else if (queue_depth == 0 && busy_ratio < GPUSERV_WORKER_POOL_IDLE_RATIO)
+	{
+		/* shrink the pool, if workers are idle for a while */
+		if (++gcontext->pool_idle_rounds >= GPUSERV_WORKER_POOL_IDLE_ROUNDS)
+		{
+			nworkers--;
+			gcontext->pool_idle_rounds = 0;
+		}
+	}
+	else
+		gcontext->pool_idle_rounds = 0;
+	nworkers = Max(nworkers, Max(nworkers_min, 1));
+	nworkers = Min(nworkers, nworkers_max);
+
+	/* expose the status */
+	pg_atomic_write_u32(&pool->nworkers_min, nworkers_min);
+	pg_atomic_write_u32(&pool->nworkers_max, nworkers_max);
+	pg_atomic_write_u32(&pool->queue_depth, queue_depth);
+	pg_atomic_write_u32(&pool->busy_ratio,
+						(uint32_t)(Min(busy_ratio, 1.0) * 1000.0));
+	if (nworkers != gcontext->pool_nworkers)
+	{
+		pg_atomic_write_u32(&pool->last_nworkers, gcontext->pool_nworkers);
+		pg_atomic_write_u64(&pool->last_adjust, GetCurrentTimestamp());
+		pg_atomic_write_u32(&pool->nworkers, nworkers);
+	}
+	return nworkers;
+}
+
+/*
+ * __gpuContextUpdateStats
+ *
+ * It samples the status of the command queue and memory pool for the
+ * pgstrom.pg_stat_gpu_service view.
+ */
+static void
+__gpuContextUpdateMemPoolStats(gpuMemoryPool *pool,
+							   pg_atomic_uint32 *p_nsegs,
+							   pg_atomic_uint64 *p_total,
+							   pg_atomic_uint64 *p_active)
+{
+	uint32_t	nsegs = 0;
+	size_t		active_sz = 0;
+	dlist_iter	iter;
+
+	pthreadMutexLock(&pool->lock);
+	dlist_foreach(iter, &pool->segment_list)
+	{
+		gpuMemorySegment *mseg = dlist_container(gpuMemorySegment,
+												 chain, iter.cur);
+		active_sz += mseg->active_sz;
+		nsegs++;
+	}
+	pg_atomic_write_u64(p_total, pool->total_sz);
+	pthreadMutexUnlock(&pool->lock);
+	pg_atomic_write_u32(p_nsegs, nsegs);
+	pg_atomic_write_u64(p_active, active_sz);
+}
+
+static void
+__gpuContextUpdateStats(gpuContext *gcontext)
+{
+	gpuServDeviceStats *stats = GPUSERV_DEVICE_STATS(gcontext->cuda_dindex);
+	uint32_t	nr_queued = 0;
+	uint32_t	nr_running;
+	dlist_iter	iter;
+
+	pthreadMutexLock(&gcontext->lock);
+	dlist_foreach(iter, &gcontext->command_list)
+		nr_queued++;
+	nr_running = gcontext->sched_nbusy;
+	pthreadMutexUnlock(&gcontext->lock);
+	pg_atomic_write_u32(&stats->nr_queued, nr_queued);
+	pg_atomic_write_u32(&stats->nr_running, nr_running);
+
+	__gpuContextUpdateMemPoolStats(&gcontext->pool_raw,
+								   &stats->mpool_raw_nsegs,
+								   &stats->mpool_raw_total,
+								   &stats->mpool_raw_active);
+	pg_atomic_write_u64(&stats->mpool_raw_limit, gcontext->pool_raw.hard_limit);
+	__gpuContextUpdateMemPoolStats(&gcontext->pool_managed,
+								   &stats->mpool_managed_nsegs,
+								   &stats->mpool_managed_total,
+								   &stats->mpool_managed_active);
+}
+
 static void
 __gpuContextAdjustWorkers(void)
 {
 	uint32_t	updated;
+	dlist_iter  iter;
 
 	updated = pg_atomic_exchange_u32(&gpuserv_shared_state->max_async_tasks_updated, 0);
-	if (updated)
+	dlist_foreach(iter, &gpuserv_gpucontext_list)
 	{
-		uint32_t	nworkers;
-		dlist_iter  iter;
+		gpuContext *gcontext = dlist_container(gpuContext, chain, iter.cur);
+		uint32_t	nworkers = __gpuContextComputeWorkers(gcontext, updated != 0);
 
-		nworkers = pg_atomic_read_u32(&gpuserv_shared_state->max_async_tasks);
-		dlist_foreach(iter, &gpuserv_gpucontext_list)
-		{
-			gpuContext *gcontext = dlist_container(gpuContext, chain, iter.cur);
+		__gpuContextUpdateStats(gcontext);
 
+		if (updated || nworkers != gcontext->pool_nworkers)
+		{
 			__gpuContextAdjustWorkersOne(gcontext, nworkers);
+			gcontext->pool_nworkers = nworkers;
 		}
 	}
 }
 
+/*
+ * gpuservWorkerPoolInfo
+ *
+ * It returns the status of the GPU worker pool, for pgstrom_gpu_device_info()
+ */
+char *
+gpuservWorkerPoolInfo(int cuda_dindex, int index,
+					  const char **p_att_name,
+					  const char **p_att_desc)
+{
+	gpuServWorkerPool *pool;
+	TimestampTz	ts;
+
+	if (!gpuserv_shared_state ||
+		cuda_dindex < 0 || cuda_dindex >= numGpuDevAttrs)
+		return NULL;
+	pool = &gpuserv_shared_state->devs[cuda_dindex].pool;
+	switch (index)
+	{
+		case 0:
+			*p_att_name = "GPUSERV_NUM_WORKERS";
+			*p_att_desc = "GPU Service: number of worker threads";
+			return psprintf("%u", pg_atomic_read_u32(&pool->nworkers));
+		case 1:
+			*p_att_name = "GPUSERV_WORKERS_RANGE";
+			*p_att_desc = "GPU Service: min/max bounds of the worker pool";
+			return psprintf("%u - %u",
+							pg_atomic_read_u32(&pool->nworkers_min),
+							pg_atomic_read_u32(&pool->nworkers_max));
+		case 2:
+			*p_att_name = "GPUSERV_QUEUE_DEPTH";
+			*p_att_desc = "GPU Service: number of pending commands";
+			return psprintf("%u", pg_atomic_read_u32(&pool->queue_depth));
+		case 3:
+			*p_att_name = "GPUSERV_BUSY_RATIO";
+			*p_att_desc = "GPU Service: busy ratio of the worker threads";
+			return psprintf("%.1f%%", (double)pg_atomic_read_u32(&pool->busy_ratio) / 10.0);
+		case 4:
+			*p_att_name = "GPUSERV_LAST_ADJUST";
+			*p_att_desc = "GPU Service: last adjustment of the worker pool";
+			ts = (TimestampTz)pg_atomic_read_u64(&pool->last_adjust);
+			if (ts == 0)
+				return pstrdup("none");
+			return psprintf("%u -> %u workers at %s",
+							pg_atomic_read_u32(&pool->last_nworkers),
+							pg_atomic_read_u32(&pool->nworkers),
+							timestamptz_to_str(ts));
+		default:
+			break;
+	}
+	return NULL;
+}
+
 /*
  * __gpuContextTerminateWorkers
  *
@@ -2833,6 +8666,7 @@ __gpuContextTerminateWorkers(gpuContext *gcontext)
 	for (;;)
 	{
 		pthreadCondBroadcast(&gcontext->cond);
+		pthreadCondBroadcast(&gcontext->ra_cond);
 		gpucacheManagerWakeUp(gcontext->cuda_dindex);
 
 		pthreadMutexLock(&gcontext->worker_lock);
@@ -2855,6 +8689,7 @@ gpuservSetupGpuContext(int cuda_dindex)
 {
 	GpuDevAttributes *dattrs = &gpuDevAttrs[cuda_dindex];
 	gpuContext *gcontext = NULL;
+	gpuServDeviceStats *stats = GPUSERV_DEVICE_STATS(cuda_dindex);
 	CUresult	rc;
 	size_t		stack_sz;
 	struct sockaddr_un addr;
@@ -2865,7 +8700,19 @@ gpuservSetupGpuContext(int cuda_dindex)
 	if (!gcontext)
 		elog(ERROR, "out of memory");
 	gcontext->serv_fd = -1;
+	gcontext->remote_fd = -1;
 	gcontext->cuda_dindex = cuda_dindex;
+	/* reset cumulative statistics */
+	pg_atomic_write_u64(&stats->nr_tasks, 0);
+	pg_atomic_write_u64(&stats->nr_fallbacks, 0);
+	pg_atomic_write_u64(&stats->nr_suspends, 0);
+	pg_atomic_write_u64(&stats->npages_direct_read, 0);
+	pg_atomic_write_u64(&stats->npages_vfs_read, 0);
+	pg_atomic_write_u64(&stats->usec_load, 0);
+	pg_atomic_write_u64(&stats->usec_kernel, 0);
+	pg_atomic_write_u64(&stats->usec_writeback, 0);
+	pg_atomic_write_u32(&stats->nr_sessions, 0);
+	pg_atomic_write_u64(&stats->stats_reset, GetCurrentTimestamp());
 	gpuMemoryPoolInit(&gcontext->pool_raw,     false, dattrs->DEV_TOTAL_MEMSZ);
 	gpuMemoryPoolInit(&gcontext->pool_managed, true,  dattrs->DEV_TOTAL_MEMSZ);
 	pthreadMutexInit(&gcontext->client_lock);
@@ -2876,6 +8723,19 @@ gpuservSetupGpuContext(int cuda_dindex)
 	pthreadCondInit(&gcontext->cond);
 	pthreadMutexInit(&gcontext->lock);
 	dlist_init(&gcontext->command_list);
+	pthreadMutexInit(&gcontext->staging_lock);
+	dlist_init(&gcontext->staging_free_list);
+	pthreadCondInit(&gcontext->ra_cond);
+	dlist_init(&gcontext->ra_command_list);
+	gcontext->ra_depth = Max(pgstrom_arrow_readahead_threads / 2, 1);
+	pthreadMutexInit(&gcontext->session_cache_lock);
+	dlist_init(&gcontext->session_cache_list);
+	pthreadMutexInit(&gcontext->shared_scan_lock);
+	dlist_init(&gcontext->shared_scan_list);
+	pg_atomic_init_u32(&gcontext->shared_scan_nclients, 0);
+	pthreadMutexInit(&gcontext->shmem_segment_lock);
+	dlist_init(&gcontext->shmem_segment_list);
+	gcontext->shmem_segment_nitems = 0;
 
 	PG_TRY();
 	{
@@ -2897,6 +8757,18 @@ gpuservSetupGpuContext(int cuda_dindex)
 					  EPOLL_CTL_ADD,
 					  gcontext->serv_fd, &ev) != 0)
 			elog(ERROR, "failed on epoll_ctl(2): %m");
+		/* Open the TCP listen socket for the remote hosts, if any */
+		if (pgstrom_gpu_service_listen_address &&
+			*pgstrom_gpu_service_listen_address != '\0')
+		{
+			gcontext->remote_fd = __gpuservOpenRemoteListenSocket(cuda_dindex);
+			ev.events = EPOLLIN;
+			ev.data.ptr = gcontext;
+			if (epoll_ctl(gpuserv_epoll_fdesc,
+						  EPOLL_CTL_ADD,
+						  gcontext->remote_fd, &ev) != 0)
+				elog(ERROR, "failed on epoll_ctl(2): %m");
+		}
 
 		/* Setup raw CUDA context */
 		rc = cuDeviceGet(&gcontext->cuda_device, dattrs->DEV_ID);
@@ -2912,12 +8784,11 @@ gpuservSetupGpuContext(int cuda_dindex)
 		rc = cuCtxGetLimit(&stack_sz, CU_LIMIT_STACK_SIZE);
 		if (rc != CUDA_SUCCESS)
 			elog(ERROR, "failed on cuCtxGetLimit: %s", cuStrError(rc));
-		stack_sz += 4096;
+		stack_sz += 4096 + 1024L * pgstrom_gpu_detoast_buffer_kb;
 		rc = cuCtxSetLimit(CU_LIMIT_STACK_SIZE, stack_sz);
 		if (rc != CUDA_SUCCESS)
 			elog(ERROR, "failed on cuCtxSetLimit: %s", cuStrError(rc));
 
-		gpuservSetupGpuModule(gcontext);
 		/* enable kernel profiling if captured */
 		if (getenv("NSYS_PROFILING_SESSION_ID") != NULL)
 		{
@@ -2936,6 +8807,8 @@ gpuservSetupGpuContext(int cuda_dindex)
 			cuCtxDestroy(gcontext->cuda_context);
 		if (gcontext->serv_fd >= 0)
 			close(gcontext->serv_fd);
+		if (gcontext->remote_fd >= 0)
+			close(gcontext->remote_fd);
 		free(gcontext);
 		PG_RE_THROW();
 	}
@@ -2961,8 +8834,46 @@ gpuservCleanupGpuContext(gpuContext *gcontext)
 		if (close(gclient->sockfd) != 0)
 			elog(LOG, "failed on close(sockfd): %m");
 	}
+	while (!dlist_is_empty(&gcontext->staging_free_list))
+	{
+		dlist_node *dnode = dlist_pop_head_node(&gcontext->staging_free_list);
+		gpuStagingBuffer *sbuf = dlist_container(gpuStagingBuffer,
+												 chain, dnode);
+		/* pinned memory, stream and event are released by cuCtxDestroy */
+		free(sbuf);
+	}
+	while (!dlist_is_empty(&gcontext->session_cache_list))
+	{
+		dlist_node *dnode = dlist_pop_head_node(&gcontext->session_cache_list);
+		gpuSessionCache *entry = dlist_container(gpuSessionCache, chain, dnode);
+
+		if (entry->jit_module)
+			gpuJitPutModule(entry->jit_module);
+		free(entry->raw);
+		free(entry);
+	}
+	gcontext->session_cache_nitems = 0;
+	while (!dlist_is_empty(&gcontext->shared_scan_list))
+	{
+		dlist_node *dnode = dlist_pop_head_node(&gcontext->shared_scan_list);
+		gpuSharedScanBuffer *entry = dlist_container(gpuSharedScanBuffer,
+													 chain, dnode);
+		gpuMemFree(entry->chunk);
+		free(entry);
+	}
+	gcontext->shared_scan_usage = 0;
+	while (!dlist_is_empty(&gcontext->shmem_segment_list))
+	{
+		dlist_node *dnode = dlist_pop_head_node(&gcontext->shmem_segment_list);
+
+		__gpuservShmemSegmentRelease(dlist_container(gpuShmemSegment,
+													 chain, dnode));
+	}
+	gcontext->shmem_segment_nitems = 0;
 	if (close(gcontext->serv_fd) != 0)
 		elog(LOG, "failed on close(serv_fd): %m");
+	if (gcontext->remote_fd >= 0 && close(gcontext->remote_fd) != 0)
+		elog(LOG, "failed on close(remote_fd): %m");
 	if (gcontext->cuda_profiler_started)
 	{
 		rc = cuProfilerStop();
@@ -3046,6 +8957,13 @@ gpuservBgWorkerMain(Datum arg)
 	if (gpuserv_epoll_fdesc < 0)
 		elog(ERROR, "failed on epoll_create: %m");
 
+	/* Setup tracing of the GPU service, if any */
+	if (pgstrom_gpu_service_trace_dir && *pgstrom_gpu_service_trace_dir != '\0')
+	{
+		gpuserv_trace_enabled = true;
+		__gpuservTraceThreadSetup("main");
+	}
+
 	/* Init GPU Context for each devices */
 	rc = cuInit(0);
 	if (rc != CUDA_SUCCESS)
@@ -3058,6 +8976,7 @@ gpuservBgWorkerMain(Datum arg)
 			gpuContext *gcontext = gpuservSetupGpuContext(dindex);
 			dlist_push_tail(&gpuserv_gpucontext_list, &gcontext->chain);
 		}
+		gpuservSetupGpuModuleAll();
 		gpuDirectOpenDriver();
 		while (!gpuServiceGoingTerminate())
 		{
@@ -3069,8 +8988,11 @@ gpuservBgWorkerMain(Datum arg)
 			CHECK_FOR_INTERRUPTS();
 			/* launch/eliminate worker threads */
 			__gpuContextAdjustWorkers();
+			/* write out the trace events, if any */
+			__gpuservTraceFlush(false);
 
-			status = epoll_wait(gpuserv_epoll_fdesc, &ep_ev, 1, 4000);
+			status = epoll_wait(gpuserv_epoll_fdesc, &ep_ev, 1,
+								GPUSERV_WORKER_POOL_INTERVAL);
 			if (status < 0)
 			{
 				if (errno != EINTR)
@@ -3113,6 +9035,7 @@ gpuservBgWorkerMain(Datum arg)
 		gpuservCleanupGpuContext(gcontext);
 	}
 	gpuDirectCloseDriver();
+	__gpuservTraceFlush(true);
 
 	/*
 	 * If it received only SIGHUP (no SIGTERM), try to restart rather than
@@ -3122,6 +9045,222 @@ gpuservBgWorkerMain(Datum arg)
 		proc_exit(1);
 }
 
+/*
+ * pgstrom_gpu_service_stats - SQL function to dump the GPU service statistics
+ */
+PG_FUNCTION_INFO_V1(pgstrom_gpu_service_stats);
+PUBLIC_FUNCTION(Datum)
+pgstrom_gpu_service_stats(PG_FUNCTION_ARGS)
+{
+	FuncCallContext *fncxt;
+	gpuServDeviceStats *stats;
+	gpuServWorkerPool *pool;
+	Datum		values[20];
+	bool		isnull[20];
+	HeapTuple	tuple;
+	int			dindex;
+	TimestampTz	ts;
+
+	if (SRF_IS_FIRSTCALL())
+	{
+		TupleDesc		tupdesc;
+		MemoryContext	oldcxt;
+
+		fncxt = SRF_FIRSTCALL_INIT();
+		oldcxt = MemoryContextSwitchTo(fncxt->multi_call_memory_ctx);
+
+		tupdesc = CreateTemplateTupleDesc(20);
+		TupleDescInitEntry(tupdesc,  1, "gpu_id",
+						   INT4OID, -1, 0);
+		TupleDescInitEntry(tupdesc,  2, "num_workers",
+						   INT4OID, -1, 0);
+		TupleDescInitEntry(tupdesc,  3, "cmd_queued",
+						   INT4OID, -1, 0);
+		TupleDescInitEntry(tupdesc,  4, "cmd_running",
+						   INT4OID, -1, 0);
+		TupleDescInitEntry(tupdesc,  5, "nr_tasks",
+						   INT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc,  6, "nr_fallbacks",
+						   INT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc,  7, "nr_suspends",
+						   INT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc,  8, "npages_direct_read",
+						   INT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc,  9, "npages_vfs_read",
+						   INT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc, 10, "load_time",
+						   FLOAT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc, 11, "kernel_time",
+						   FLOAT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc, 12, "writeback_time",
+						   FLOAT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc, 13, "mpool_raw_nsegs",
+						   INT4OID, -1, 0);
+		TupleDescInitEntry(tupdesc, 14, "mpool_raw_total",
+						   INT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc, 15, "mpool_raw_active",
+						   INT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc, 16, "mpool_raw_limit",
+						   INT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc, 17, "mpool_managed_nsegs",
+						   INT4OID, -1, 0);
+		TupleDescInitEntry(tupdesc, 18, "mpool_managed_total",
+						   INT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc, 19, "mpool_managed_active",
+						   INT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc, 20, "stats_reset",
+						   TIMESTAMPTZOID, -1, 0);
+		fncxt->tuple_desc = BlessTupleDesc(tupdesc);
+
+		MemoryContextSwitchTo(oldcxt);
+	}
+	fncxt = SRF_PERCALL_SETUP();
+	dindex = fncxt->call_cntr;
+	if (!gpuserv_shared_state || dindex >= numGpuDevAttrs)
+		SRF_RETURN_DONE(fncxt);
+	stats = GPUSERV_DEVICE_STATS(dindex);
+	pool = &gpuserv_shared_state->devs[dindex].pool;
+
+	memset(isnull, 0, sizeof(isnull));
+	values[0] = Int32GetDatum(gpuDevAttrs[dindex].DEV_ID);
+	values[1] = Int32GetDatum(pg_atomic_read_u32(&pool->nworkers));
+	values[2] = Int32GetDatum(pg_atomic_read_u32(&stats->nr_queued));
+	values[3] = Int32GetDatum(pg_atomic_read_u32(&stats->nr_running));
+	values[4] = Int64GetDatum(pg_atomic_read_u64(&stats->nr_tasks));
+	values[5] = Int64GetDatum(pg_atomic_read_u64(&stats->nr_fallbacks));
+	values[6] = Int64GetDatum(pg_atomic_read_u64(&stats->nr_suspends));
+	values[7] = Int64GetDatum(pg_atomic_read_u64(&stats->npages_direct_read));
+	values[8] = Int64GetDatum(pg_atomic_read_u64(&stats->npages_vfs_read));
+	/* in milliseconds, like pg_stat_statements */
+	values[9] = Float8GetDatum((double)pg_atomic_read_u64(&stats->usec_load) / 1000.0);
+	values[10] = Float8GetDatum((double)pg_atomic_read_u64(&stats->usec_kernel) / 1000.0);
+	values[11] = Float8GetDatum((double)pg_atomic_read_u64(&stats->usec_writeback) / 1000.0);
+	values[12] = Int32GetDatum(pg_atomic_read_u32(&stats->mpool_raw_nsegs));
+	values[13] = Int64GetDatum(pg_atomic_read_u64(&stats->mpool_raw_total));
+	values[14] = Int64GetDatum(pg_atomic_read_u64(&stats->mpool_raw_active));
+	values[15] = Int64GetDatum(pg_atomic_read_u64(&stats->mpool_raw_limit));
+	values[16] = Int32GetDatum(pg_atomic_read_u32(&stats->mpool_managed_nsegs));
+	values[17] = Int64GetDatum(pg_atomic_read_u64(&stats->mpool_managed_total));
+	values[18] = Int64GetDatum(pg_atomic_read_u64(&stats->mpool_managed_active));
+	ts = (TimestampTz)pg_atomic_read_u64(&stats->stats_reset);
+	if (ts == 0)
+		isnull[19] = true;
+	else
+		values[19] = TimestampTzGetDatum(ts);
+
+	tuple = heap_form_tuple(fncxt->tuple_desc, values, isnull);
+
+	SRF_RETURN_NEXT(fncxt, HeapTupleGetDatum(tuple));
+}
+
+/*
+ * pgstrom_gpu_quota_stats - SQL function to dump the GPU quota accounting
+ */
+PG_FUNCTION_INFO_V1(pgstrom_gpu_quota_stats);
+PUBLIC_FUNCTION(Datum)
+pgstrom_gpu_quota_stats(PG_FUNCTION_ARGS)
+{
+	FuncCallContext *fncxt;
+	gpuQuotaSlot *quota;
+	uint64_t	quota_key;
+	Oid			database_oid;
+	Oid			role_oid;
+	char	   *name;
+	Datum		values[12];
+	bool		isnull[12];
+	HeapTuple	tuple;
+	uint32		index;
+
+	if (SRF_IS_FIRSTCALL())
+	{
+		TupleDesc		tupdesc;
+		MemoryContext	oldcxt;
+
+		fncxt = SRF_FIRSTCALL_INIT();
+		oldcxt = MemoryContextSwitchTo(fncxt->multi_call_memory_ctx);
+
+		tupdesc = CreateTemplateTupleDesc(12);
+		TupleDescInitEntry(tupdesc,  1, "database",
+						   TEXTOID, -1, 0);
+		TupleDescInitEntry(tupdesc,  2, "role",
+						   TEXTOID, -1, 0);
+		TupleDescInitEntry(tupdesc,  3, "memory_limit",
+						   INT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc,  4, "memory_usage",
+						   INT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc,  5, "memory_peak",
+						   INT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc,  6, "tasks_limit",
+						   INT4OID, -1, 0);
+		TupleDescInitEntry(tupdesc,  7, "tasks_running",
+						   INT4OID, -1, 0);
+		TupleDescInitEntry(tupdesc,  8, "action",
+						   TEXTOID, -1, 0);
+		TupleDescInitEntry(tupdesc,  9, "nr_tasks",
+						   INT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc, 10, "nr_waits",
+						   INT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc, 11, "nr_fallbacks",
+						   INT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc, 12, "nr_errors",
+						   INT8OID, -1, 0);
+		fncxt->tuple_desc = BlessTupleDesc(tupdesc);
+
+		MemoryContextSwitchTo(oldcxt);
+	}
+	fncxt = SRF_PERCALL_SETUP();
+	if (!gpuserv_shared_state)
+		SRF_RETURN_DONE(fncxt);
+	/* fncxt->user_fctx is the next slot index */
+	for (;;)
+	{
+		index = (uint32)((uintptr_t)fncxt->user_fctx);
+		if (index >= GPUSERV_QUOTA_NSLOTS)
+			SRF_RETURN_DONE(fncxt);
+		fncxt->user_fctx = (void *)((uintptr_t)(index + 1));
+		quota = &gpuserv_shared_state->quota_slots[index];
+		quota_key = pg_atomic_read_u64(&quota->quota_key);
+		if (quota_key != 0)
+			break;
+	}
+	database_oid = (Oid)(quota_key >> 32);
+	role_oid = (Oid)(quota_key & 0xffffffffUL);
+
+	memset(isnull, 0, sizeof(isnull));
+	name = get_database_name(database_oid);
+	values[0] = CStringGetTextDatum(name ? name : psprintf("%u", database_oid));
+	name = GetUserNameFromId(role_oid, true);
+	values[1] = CStringGetTextDatum(name ? name : psprintf("%u", role_oid));
+	values[2] = Int64GetDatum(pg_atomic_read_u64(&quota->memory_limit));
+	values[3] = Int64GetDatum(pg_atomic_read_u64(&quota->memory_usage));
+	values[4] = Int64GetDatum(pg_atomic_read_u64(&quota->memory_peak));
+	values[5] = Int32GetDatum(pg_atomic_read_u32(&quota->tasks_limit));
+	values[6] = Int32GetDatum(pg_atomic_read_u32(&quota->nr_running));
+	switch (pg_atomic_read_u32(&quota->action))
+	{
+		case XPU_QUOTA_ACTION__WAIT:
+			values[7] = CStringGetTextDatum("wait");
+			break;
+		case XPU_QUOTA_ACTION__FALLBACK:
+			values[7] = CStringGetTextDatum("fallback");
+			break;
+		case XPU_QUOTA_ACTION__ERROR:
+			values[7] = CStringGetTextDatum("error");
+			break;
+		default:
+			isnull[7] = true;
+			break;
+	}
+	values[8]  = Int64GetDatum(pg_atomic_read_u64(&quota->nr_tasks));
+	values[9]  = Int64GetDatum(pg_atomic_read_u64(&quota->nr_waits));
+	values[10] = Int64GetDatum(pg_atomic_read_u64(&quota->nr_fallbacks));
+	values[11] = Int64GetDatum(pg_atomic_read_u64(&quota->nr_errors));
+
+	tuple = heap_form_tuple(fncxt->tuple_desc, values, isnull);
+
+	SRF_RETURN_NEXT(fncxt, HeapTupleGetDatum(tuple));
+}
+
 /*
  * pgstrom_request_executor
  */
@@ -3130,7 +9269,8 @@ pgstrom_request_executor(void)
 {
 	if (shmem_request_next)
 		(*shmem_request_next)();
-	RequestAddinShmemSpace(MAXALIGN(sizeof(gpuServSharedState)));
+	RequestAddinShmemSpace(MAXALIGN(offsetof(gpuServSharedState,
+											 devs[numGpuDevAttrs])));
 }
 
 /*
@@ -3144,14 +9284,66 @@ pgstrom_startup_executor(void)
 	if (shmem_startup_next)
 		(*shmem_startup_next)();
 	gpuserv_shared_state = ShmemInitStruct("gpuServSharedState",
-										   MAXALIGN(sizeof(gpuServSharedState)),
+										   MAXALIGN(offsetof(gpuServSharedState,
+															 devs[numGpuDevAttrs])),
 										   &found);
-	memset(gpuserv_shared_state, 0, sizeof(gpuServSharedState));
+	memset(gpuserv_shared_state, 0, offsetof(gpuServSharedState,
+											 devs[numGpuDevAttrs]));
 	pg_atomic_init_u32(&gpuserv_shared_state->max_async_tasks_updated, 1);
 	pg_atomic_init_u32(&gpuserv_shared_state->max_async_tasks,
 					   __pgstrom_max_async_tasks_dummy);
 	pg_atomic_init_u32(&gpuserv_shared_state->gpuserv_debug_output,
 					   __gpuserv_debug_output_dummy);
+	for (int i=0; i < GPUSERV_QUOTA_NSLOTS; i++)
+	{
+		gpuQuotaSlot *quota = &gpuserv_shared_state->quota_slots[i];
+
+		pg_atomic_init_u64(&quota->quota_key, 0);
+		pg_atomic_init_u64(&quota->memory_limit, 0);
+		pg_atomic_init_u32(&quota->tasks_limit, 0);
+		pg_atomic_init_u32(&quota->action, XPU_QUOTA_ACTION__WAIT);
+		pg_atomic_init_u32(&quota->wait_timeout, 0);
+		pg_atomic_init_u32(&quota->nr_running, 0);
+		pg_atomic_init_u64(&quota->memory_usage, 0);
+		pg_atomic_init_u64(&quota->memory_peak, 0);
+		pg_atomic_init_u64(&quota->nr_tasks, 0);
+		pg_atomic_init_u64(&quota->nr_waits, 0);
+		pg_atomic_init_u64(&quota->nr_fallbacks, 0);
+		pg_atomic_init_u64(&quota->nr_errors, 0);
+	}
+	for (int i=0; i < numGpuDevAttrs; i++)
+	{
+		gpuServWorkerPool *pool = &gpuserv_shared_state->devs[i].pool;
+		gpuServDeviceStats *stats = &gpuserv_shared_state->devs[i].stats;
+
+		pg_atomic_init_u32(&stats->nr_queued, 0);
+		pg_atomic_init_u32(&stats->nr_running, 0);
+		pg_atomic_init_u32(&stats->nr_sessions, 0);
+		pg_atomic_init_u64(&stats->nr_tasks, 0);
+		pg_atomic_init_u64(&stats->nr_fallbacks, 0);
+		pg_atomic_init_u64(&stats->nr_suspends, 0);
+		pg_atomic_init_u64(&stats->npages_direct_read, 0);
+		pg_atomic_init_u64(&stats->npages_vfs_read, 0);
+		pg_atomic_init_u64(&stats->usec_load, 0);
+		pg_atomic_init_u64(&stats->usec_kernel, 0);
+		pg_atomic_init_u64(&stats->usec_writeback, 0);
+		pg_atomic_init_u32(&stats->mpool_raw_nsegs, 0);
+		pg_atomic_init_u64(&stats->mpool_raw_total, 0);
+		pg_atomic_init_u64(&stats->mpool_raw_active, 0);
+		pg_atomic_init_u64(&stats->mpool_raw_limit, 0);
+		pg_atomic_init_u32(&stats->mpool_managed_nsegs, 0);
+		pg_atomic_init_u64(&stats->mpool_managed_total, 0);
+		pg_atomic_init_u64(&stats->mpool_managed_active, 0);
+		pg_atomic_init_u64(&stats->stats_reset, 0);
+
+		pg_atomic_init_u32(&pool->nworkers, 0);
+		pg_atomic_init_u32(&pool->nworkers_min, 0);
+		pg_atomic_init_u32(&pool->nworkers_max, 0);
+		pg_atomic_init_u32(&pool->queue_depth, 0);
+		pg_atomic_init_u32(&pool->busy_ratio, 0);
+		pg_atomic_init_u32(&pool->last_nworkers, 0);
+		pg_atomic_init_u64(&pool->last_adjust, 0);
+	}
 }
 
 /*
@@ -3160,6 +9352,18 @@ pgstrom_startup_executor(void)
 void
 pgstrom_init_gpu_service(void)
 {
+	static struct config_enum_entry	__gpu_task_priority_options[] = {
+		{"high",	XPU_TASK_PRIORITY__HIGH,	false},
+		{"normal",	XPU_TASK_PRIORITY__NORMAL,	false},
+		{"low",		XPU_TASK_PRIORITY__LOW,		false},
+		{NULL, 0, false}
+	};
+	static struct config_enum_entry	__gpu_quota_action_options[] = {
+		{"wait",	 XPU_QUOTA_ACTION__WAIT,	 false},
+		{"fallback", XPU_QUOTA_ACTION__FALLBACK, false},
+		{"error",	 XPU_QUOTA_ACTION__ERROR,	 false},
+		{NULL, 0, false}
+	};
 	BackgroundWorker worker;
 
 	Assert(numGpuDevAttrs > 0);
@@ -3173,6 +9377,179 @@ pgstrom_init_gpu_service(void)
 							PGC_POSTMASTER,
 							GUC_NOT_IN_SAMPLE,
 							NULL, NULL, NULL);
+	DefineCustomIntVariable("pg_strom.gpu_detoast_buffer_size",
+							"Per-thread buffer size to decompress the inline compressed varlena on GPU",
+							"Compressed datum larger than this is processed by CPU fallback",
+							&pgstrom_gpu_detoast_buffer_kb,
+							8,			/* 8kB */
+							0,			/* disabled */
+							64,			/* 64kB */
+							PGC_POSTMASTER,
+							GUC_NOT_IN_SAMPLE | GUC_UNIT_KB,
+							NULL, NULL, NULL);
+	DefineCustomIntVariable("pg_strom.gpu_shared_scan_buffer_size",
+							"Device memory to keep arrow file extents for the concurrent scans",
+							"0 disables the shared scan",
+							&pgstrom_gpu_shared_scan_buffer_mb,
+							512,		/* 512MB */
+							0,			/* disabled */
+							INT_MAX,
+							PGC_POSTMASTER,
+							GUC_NOT_IN_SAMPLE | GUC_UNIT_MB,
+							NULL, NULL, NULL);
+	DefineCustomIntVariable("pg_strom.arrow_readahead_threads",
+							"Number of threads per GPU to read ahead the arrow record-batches",
+							"0 disables the read-ahead; record-batches are loaded by the GPU workers",
+							&pgstrom_arrow_readahead_threads,
+							8,
+							0,
+							64,
+							PGC_POSTMASTER,
+							GUC_NOT_IN_SAMPLE,
+							NULL, NULL, NULL);
+	DefineCustomIntVariable("pg_strom.arrow_readahead_staging_size",
+							"Device memory to keep the record-batches loaded by the read-ahead",
+							NULL,
+							&pgstrom_arrow_readahead_staging_mb,
+							1024,		/* 1GB */
+							1,
+							INT_MAX,
+							PGC_SIGHUP,
+							GUC_NOT_IN_SAMPLE | GUC_UNIT_MB,
+							NULL, NULL, NULL);
+	DefineCustomIntVariable("pg_strom.gpudirect_stripe_queue_depth",
+							"Number of concurrent read requests per member device of md-raid0 on GPU-Direct SQL",
+							"0 disables to split the reads by the stripe members",
+							&pgstrom_gpudirect_stripe_queue_depth,
+							2,
+							0,
+							GPUDIRECT_STRIPE_MAX_QUEUES,
+							PGC_SIGHUP,
+							GUC_NOT_IN_SAMPLE,
+							NULL, NULL, NULL);
+	DefineCustomBoolVariable("pg_strom.enable_cuda_graph",
+							 "Enables CUDA Graph to launch GPU task kernels",
+							 NULL,
+							 &pgstrom_enable_cuda_graph,
+							 true,
+							 PGC_SIGHUP,
+							 GUC_NOT_IN_SAMPLE,
+							 NULL, NULL, NULL);
+	DefineCustomIntVariable("pg_strom.gpu_task_coalesce_threshold",
+							"Source chunks smaller than the threshold are merged with the pending ones of the same session",
+							NULL,
+							&pgstrom_gpu_task_coalesce_threshold_kb,
+							8192,		/* 8MB */
+							0,			/* disabled */
+							65536,		/* 64MB */
+							PGC_SIGHUP,
+							GUC_NOT_IN_SAMPLE | GUC_UNIT_KB,
+							NULL, NULL, NULL);
+	DefineCustomEnumVariable("pg_strom.gpu_task_priority",
+							 "Priority of the GPU tasks of this session",
+							 "GPU service dispatches the tasks to the worker threads according to the priority of the sessions",
+							 &pgstrom_gpu_task_priority,
+							 XPU_TASK_PRIORITY__NORMAL,
+							 __gpu_task_priority_options,
+							 PGC_SUSET,
+							 GUC_NOT_IN_SAMPLE,
+							 NULL, NULL, NULL);
+	/* GPU quota per database/role; see pgstrom.pg_stat_gpu_quota */
+	DefineCustomIntVariable("pg_strom.gpu_quota_memory",
+							"Max device memory of the GpuJoin/GpuPreAgg buffers per database and role",
+							"Usually configured by ALTER ROLE ... IN DATABASE ... SET; 0 means unlimited",
+							&pgstrom_gpu_quota_memory_kb,
+							0,			/* unlimited */
+							0,
+							INT_MAX,
+							PGC_SUSET,
+							GUC_NOT_IN_SAMPLE | GUC_UNIT_KB,
+							NULL, NULL, NULL);
+	DefineCustomIntVariable("pg_strom.gpu_quota_tasks",
+							"Max number of GPU tasks in execution per database and role",
+							"Tasks beyond the quota are kept in the queue; 0 means unlimited",
+							&pgstrom_gpu_quota_tasks,
+							0,			/* unlimited */
+							0,
+							INT_MAX,
+							PGC_SUSET,
+							GUC_NOT_IN_SAMPLE,
+							NULL, NULL, NULL);
+	DefineCustomEnumVariable("pg_strom.gpu_quota_action",
+							 "Behavior when pg_strom.gpu_quota_memory is exceeded",
+							 "'wait' waits for the memory released by the other queries, 'fallback' flushes the partial groups of GpuPreAgg to CPU if possible, then 'error' raises an error",
+							 &pgstrom_gpu_quota_action,
+							 XPU_QUOTA_ACTION__WAIT,
+							 __gpu_quota_action_options,
+							 PGC_SUSET,
+							 GUC_NOT_IN_SAMPLE,
+							 NULL, NULL, NULL);
+	DefineCustomIntVariable("pg_strom.gpu_quota_wait_timeout",
+							"Max time to wait for the GPU memory quota, with pg_strom.gpu_quota_action = 'wait'",
+							NULL,
+							&pgstrom_gpu_quota_wait_timeout,
+							30000,		/* 30s */
+							0,
+							INT_MAX,
+							PGC_SUSET,
+							GUC_NOT_IN_SAMPLE | GUC_UNIT_MS,
+							NULL, NULL, NULL);
+	DefineCustomIntVariable("pg_strom.gpu_worker_max_per_session",
+							"Max number of GPU worker threads that run the tasks of a session concurrently",
+							NULL,
+							&pgstrom_gpu_worker_max_per_session,
+							0,			/* unlimited */
+							0,
+							INT_MAX,
+							PGC_SIGHUP,
+							GUC_NOT_IN_SAMPLE,
+							NULL, NULL, NULL);
+	DefineCustomBoolVariable("pg_strom.gpu_workers_adaptive",
+							 "Enables adaptive sizing of the GPU worker pool",
+							 NULL,
+							 &pgstrom_gpu_workers_adaptive,
+							 true,
+							 PGC_SIGHUP,
+							 GUC_NOT_IN_SAMPLE,
+							 NULL, NULL, NULL);
+	DefineCustomIntVariable("pg_strom.gpu_workers_min",
+							"Min number of GPU worker threads per device, if adaptive",
+							NULL,
+							&pgstrom_gpu_workers_min,
+							2,
+							1,
+							1024,
+							PGC_SIGHUP,
+							GUC_NOT_IN_SAMPLE,
+							NULL, NULL, NULL);
+	DefineCustomIntVariable("pg_strom.gpu_workers_max",
+							"Max number of GPU worker threads per device (0 = pg_strom.max_async_tasks)",
+							NULL,
+							&pgstrom_gpu_workers_max,
+							0,
+							0,
+							1024,
+							PGC_SIGHUP,
+							GUC_NOT_IN_SAMPLE,
+							NULL, NULL, NULL);
+	DefineCustomBoolVariable("pg_strom.gpu_module_cache",
+							 "Enables to cache the linked GPU module on the storage",
+							 NULL,
+							 &pgstrom_gpu_module_cache,
+							 true,
+							 PGC_POSTMASTER,
+							 GUC_NOT_IN_SAMPLE,
+							 NULL, NULL, NULL);
+	DefineCustomIntVariable("pg_strom.gpu_kvecs_buffer_limit",
+							"Limit of the kvecs buffer size per GPU task",
+							"Grid size of the kernel is shrunk if kvecs buffer exceeds this limit",
+							&pgstrom_gpu_kvecs_buffer_limit_kb,
+							131072,		/* 128MB */
+							0,
+							INT_MAX,
+							PGC_SIGHUP,
+							GUC_NOT_IN_SAMPLE | GUC_UNIT_KB,
+							NULL, NULL, NULL);
 	DefineCustomIntVariable("pg_strom.gpu_mempool_segment_sz",
 							"Segment size of GPU memory pool",
 							NULL,
@@ -3213,6 +9590,16 @@ pgstrom_init_gpu_service(void)
 							PGC_SIGHUP,
 							GUC_NOT_IN_SAMPLE | GUC_UNIT_MS | GUC_NO_SHOW_ALL,
 							NULL, NULL, NULL);
+	DefineCustomIntVariable("pg_strom.gpu_staging_buffer_size",
+							"Size of the pinned host buffers to copy the KDS on the host to GPU",
+							"A copy ping-pongs between two buffers; 0 disables the staging",
+							&pgstrom_gpu_staging_buffer_kb,
+							4096,		/* 4MB */
+							0,			/* disabled */
+							1048576,	/* 1GB */
+							PGC_POSTMASTER,
+							GUC_NOT_IN_SAMPLE | GUC_UNIT_KB,
+							NULL, NULL, NULL);
 	DefineCustomIntVariable("pg_strom.max_async_tasks",
 							"Limit of concurrent xPU task execution",
 							NULL,
@@ -3235,18 +9622,57 @@ pgstrom_init_gpu_service(void)
 							 NULL,
 							 gpuserv_debug_output_assign,
 							 gpuserv_debug_output_show);
+	DefineCustomStringVariable("pg_strom.gpu_service_trace_dir",
+							   "Directory to write out the timeline trace of GPU service",
+							   "Trace files are written in the Chrome Trace Event format, if configured",
+							   &pgstrom_gpu_service_trace_dir,
+							   NULL,
+							   PGC_SIGHUP,
+							   GUC_NOT_IN_SAMPLE | GUC_SUPERUSER_ONLY,
+							   NULL, NULL, NULL);
+	DefineCustomStringVariable("pg_strom.gpu_service_listen_address",
+							   "TCP address (host:port) to accept the backends on the remote hosts",
+							   "GPU<k> listens on the port number + k; only trusted hosts should reach",
+							   &pgstrom_gpu_service_listen_address,
+							   NULL,
+							   PGC_POSTMASTER,
+							   GUC_NOT_IN_SAMPLE | GUC_SUPERUSER_ONLY,
+							   NULL, NULL, NULL);
+	DefineCustomStringVariable("pg_strom.gpu_service_remote_data_dir",
+							   "Comma separated list of the directories readable by the remote hosts",
+							   "The remote hosts cannot read any files by GPU service, if not configured",
+							   &pgstrom_gpu_service_remote_data_dir,
+							   NULL,
+							   PGC_POSTMASTER,
+							   GUC_NOT_IN_SAMPLE | GUC_SUPERUSER_ONLY,
+							   NULL, NULL, NULL);
+	DefineCustomIntVariable("pg_strom.gpu_service_trace_window",
+							"Time window to switch the trace file of GPU service",
+							"0 means one trace file until the GPU service restart",
+							&pgstrom_gpu_service_trace_window,
+							60,
+							0,
+							86400,
+							PGC_SIGHUP,
+							GUC_NOT_IN_SAMPLE | GUC_UNIT_S,
+							NULL, NULL, NULL);
 	for (int i=0; i < GPU_QUERY_BUFFER_NSLOTS; i++)
 		dlist_init(&gpu_query_buffer_hslot[i]);
+	dlist_init(&gpu_join_inner_buffer_list);
 
-	memset(&worker, 0, sizeof(BackgroundWorker));
-	worker.bgw_flags = BGWORKER_SHMEM_ACCESS;
-	worker.bgw_start_time = BgWorkerStart_PostmasterStart;
-	worker.bgw_restart_time = 5;
-	snprintf(worker.bgw_name, BGW_MAXLEN, "PG-Strom GPU Service");
-	snprintf(worker.bgw_library_name, BGW_MAXLEN, "pg_strom");
-	snprintf(worker.bgw_function_name, BGW_MAXLEN, "gpuservBgWorkerMain");
-	worker.bgw_main_arg = 0;
-	RegisterBackgroundWorker(&worker);
+	/* GPU service runs on the remote host, if configured */
+	if (!gpuServiceIsRemote())
+	{
+		memset(&worker, 0, sizeof(BackgroundWorker));
+		worker.bgw_flags = BGWORKER_SHMEM_ACCESS;
+		worker.bgw_start_time = BgWorkerStart_PostmasterStart;
+		worker.bgw_restart_time = 5;
+		snprintf(worker.bgw_name, BGW_MAXLEN, "PG-Strom GPU Service");
+		snprintf(worker.bgw_library_name, BGW_MAXLEN, "pg_strom");
+		snprintf(worker.bgw_function_name, BGW_MAXLEN, "gpuservBgWorkerMain");
+		worker.bgw_main_arg = 0;
+		RegisterBackgroundWorker(&worker);
+	}
 	/* shared memory setup */
 	shmem_request_next = shmem_request_hook;
 	shmem_request_hook = pgstrom_request_executor;
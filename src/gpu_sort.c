@@ -0,0 +1,314 @@
+/*
+ * gpu_sort.c
+ *
+ * GPU-side sorting (top-K, or the input of window functions) on the results
+ * of GpuScan/GpuJoin
+ * ----
+ * Copyright 2011-2023 (C) KaiGai Kohei <kaigai@kaigai.gr.jp>
+ * Copyright 2014-2023 (C) PG-Strom Developers Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the PostgreSQL License.
+ */
+#include "pg_strom.h"
+
+/* static variables */
+static bool		pgstrom_enable_gpusort = false;		/* GUC */
+static int		pgstrom_gpusort_max_limit = 0;		/* GUC */
+static bool		pgstrom_enable_gpusort_window = false;	/* GUC */
+
+/*
+ * __gpusort_lookup_sortkey
+ *
+ * It looks up the sort key expression of the pathkey that is available
+ * on the target-list of the relation. On the base relation, expression
+ * that is executable on the device is also available (e.g, ORDER BY the
+ * distance of vectors LIMIT k), because the GPU projection computes it
+ * for the kds_dst.
+ */
+static Expr *
+__gpusort_lookup_sortkey(PathKey *pk, RelOptInfo *rel,
+						 const pgstromPlanInfo *pp_src)
+{
+	EquivalenceClass *ec = pk->pk_eclass;
+	ListCell   *lc1, *lc2;
+
+	if (ec->ec_has_volatile)
+		return NULL;
+	foreach (lc1, ec->ec_members)
+	{
+		EquivalenceMember *em = lfirst(lc1);
+		Expr	   *em_expr = em->em_expr;
+
+		if (em->em_is_const || em->em_is_child)
+			continue;
+		if (bms_is_empty(em->em_relids) ||
+			!bms_is_subset(em->em_relids, rel->relids))
+			continue;
+		while (IsA(em_expr, RelabelType))
+			em_expr = ((RelabelType *)em_expr)->arg;
+		foreach (lc2, rel->reltarget->exprs)
+		{
+			if (equal(em_expr, lfirst(lc2)))
+				return em_expr;
+		}
+	}
+	if (!IS_SIMPLE_REL(rel))
+		return NULL;
+	foreach (lc1, ec->ec_members)
+	{
+		EquivalenceMember *em = lfirst(lc1);
+		Expr	   *em_expr = em->em_expr;
+
+		if (em->em_is_const || em->em_is_child)
+			continue;
+		if (!bms_equal(em->em_relids, rel->relids))
+			continue;
+		while (IsA(em_expr, RelabelType))
+			em_expr = ((RelabelType *)em_expr)->arg;
+		if (!IsA(em_expr, Var) &&
+			pgstrom_xpu_expression(em_expr,
+								   pp_src->xpu_task_flags,
+								   rel->relid,
+								   NIL,
+								   NULL))
+			return em_expr;
+	}
+	return NULL;
+}
+
+/*
+ * buildGpuSortPath
+ *
+ * It tries to build a sorted variant of the GpuScan/GpuJoin path, if
+ * the query is ORDER BY ... LIMIT on the final scan/join relation.
+ * The GPU kernel sorts the destination buffer and picks up the top-K
+ * items only, then the backend process merges them by the bounded
+ * tuplesort; so the CPU sort does not need to run on the whole results.
+ *
+ * Elsewhere, if the query has window functions on the scan/join relation
+ * without aggregation, it sorts the whole destination buffer by the
+ * pathkeys of the first window clause (PARTITION BY + ORDER BY), then the
+ * backend process merges the sorted chunks; so WindowAgg can run on the
+ * pre-sorted input without the explicit Sort node.
+ */
+CustomPath *
+buildGpuSortPath(PlannerInfo *root,
+				 RelOptInfo *rel,
+				 const CustomPath *cpath)
+{
+	Query	   *parse = root->parse;
+	pgstromPlanInfo *pp_src = linitial(cpath->custom_private);
+	pgstromPlanInfo *pp_info;
+	CustomPath *sort_path;
+	List	   *sort_keys = NIL;
+	List	   *sort_ops = NIL;
+	List	   *sort_collations = NIL;
+	List	   *sort_descending = NIL;
+	List	   *sort_nulls_first = NIL;
+	List	   *pathkeys;
+	double		limit = root->limit_tuples;
+	double		nrows = cpath->path.rows;
+	double		nchunks;
+	double		ntuples_host;
+	Cost		sort_cost;
+	ListCell   *lc;
+
+	/* is GpuSort available on this query? */
+	if (!pgstrom_enable_gpusort ||
+		(pp_src->xpu_task_flags & DEVKIND__NVIDIA_GPU) == 0 ||
+		(pp_src->xpu_task_flags & DEVTASK__PREAGG) != 0)
+		return NULL;
+	if (parse->commandType != CMD_SELECT ||
+		parse->rowMarks != NIL)
+		return NULL;
+	if (root->sort_pathkeys != NIL &&
+		compare_pathkeys(root->query_pathkeys,
+						 root->sort_pathkeys) == PATHKEYS_EQUAL)
+	{
+		/* top-K (ORDER BY ... LIMIT) */
+		if (limit <= 0.0 || limit > (double)pgstrom_gpusort_max_limit)
+			return NULL;
+		pathkeys = root->sort_pathkeys;
+	}
+	else if (pgstrom_enable_gpusort_window &&
+			 parse->hasWindowFuncs &&
+			 !parse->hasAggs &&
+			 parse->groupClause == NIL &&
+			 parse->groupingSets == NIL &&
+			 !root->hasHavingQual &&
+			 root->window_pathkeys != NIL &&
+			 compare_pathkeys(root->query_pathkeys,
+							  root->window_pathkeys) == PATHKEYS_EQUAL)
+	{
+		/*
+		 * input of the window functions; the backend process keeps all
+		 * the sorted chunks to merge, so it must be small enough.
+		 */
+		if (nrows * (double)rel->reltarget->width > (double)work_mem * 1024.0)
+			return NULL;
+		pathkeys = root->window_pathkeys;
+		limit = 0.0;
+	}
+	else
+		return NULL;
+	/* must be the final scan/join relation */
+	if (!bms_is_subset(root->all_baserels, rel->relids) ||
+		cpath->path.param_info != NULL)
+		return NULL;
+	/*
+	 * host qualifiers are evaluated after the device sort, so top-K
+	 * items on the device may be filtered out later.
+	 */
+	if (pp_src->host_quals != NIL)
+		return NULL;
+
+	foreach (lc, pathkeys)
+	{
+		PathKey	   *pk = lfirst(lc);
+		Expr	   *sort_key;
+		Oid			sort_type;
+		Oid			sort_coll = pk->pk_eclass->ec_collation;
+		Oid			opclass;
+		Oid			opcintype;
+		Oid			sort_op;
+		devtype_info *dtype;
+
+		if (pk->pk_strategy != BTLessStrategyNumber &&
+			pk->pk_strategy != BTGreaterStrategyNumber)
+			return NULL;
+		sort_key = __gpusort_lookup_sortkey(pk, rel, pp_src);
+		if (!sort_key)
+			return NULL;
+		sort_type = exprType((Node *)sort_key);
+		dtype = pgstrom_devtype_lookup(sort_type);
+		if (!dtype || (dtype->type_flags & DEVTYPE__HAS_COMPARE) == 0)
+			return NULL;
+		/*
+		 * device comparison functions follow the default btree operator
+		 * class, and does not support locale aware collations.
+		 */
+		opclass = GetDefaultOpClass(sort_type, BTREE_AM_OID);
+		if (!OidIsValid(opclass) ||
+			get_opclass_family(opclass) != pk->pk_opfamily)
+			return NULL;
+		if (OidIsValid(sort_coll) && !lc_collate_is_c(sort_coll))
+			return NULL;
+		opcintype = get_opclass_input_type(opclass);
+		sort_op = get_opfamily_member(pk->pk_opfamily,
+									  opcintype,
+									  opcintype,
+									  pk->pk_strategy);
+		if (!OidIsValid(sort_op))
+			return NULL;
+		sort_keys = lappend(sort_keys, sort_key);
+		sort_ops = lappend_oid(sort_ops, sort_op);
+		sort_collations = lappend_oid(sort_collations, sort_coll);
+		sort_descending = lappend_int(sort_descending,
+									  pk->pk_strategy == BTGreaterStrategyNumber);
+		sort_nulls_first = lappend_int(sort_nulls_first, pk->pk_nulls_first);
+	}
+
+	pp_info = copy_pgstrom_plan_info(pp_src);
+	pp_info->gpusort_keys = sort_keys;
+	pp_info->gpusort_sortops = sort_ops;
+	pp_info->gpusort_collations = sort_collations;
+	pp_info->gpusort_descending = sort_descending;
+	pp_info->gpusort_nulls_first = sort_nulls_first;
+	pp_info->gpusort_limit = limit;
+
+	/*
+	 * Cost estimation
+	 *
+	 * The device sorts every destination buffer (bitonic sorting), then
+	 * the backend process merges top-K items of each buffer, or merges
+	 * all the sorted buffers by the binary-heap.
+	 */
+	nrows = Max(nrows, 1.0);
+	nchunks = ceil(nrows * (double)rel->reltarget->width /
+				   (double)PGSTROM_CHUNK_SIZE);
+	sort_cost = (pgstrom_gpu_operator_cost *
+				 list_length(sort_keys) * nrows * log2(nrows) * log2(nrows));
+	if (limit > 0.0)
+	{
+		ntuples_host = Min(nrows, limit * Max(nchunks, 1.0));
+		sort_cost += 2.0 * cpu_operator_cost * ntuples_host * log2(2.0 * limit);
+	}
+	else
+	{
+		ntuples_host = nrows;
+		sort_cost += 2.0 * cpu_operator_cost * nrows * log2(Max(nchunks, 1.0) + 1.0);
+	}
+
+	sort_path = makeNode(CustomPath);
+	memcpy(sort_path, cpath, sizeof(CustomPath));
+	sort_path->path.pathkeys = pathkeys;
+	sort_path->path.startup_cost = cpath->path.total_cost + sort_cost;
+	sort_path->path.total_cost = (sort_path->path.startup_cost +
+								  cpu_tuple_cost * (limit > 0.0
+													? Min(nrows, limit)
+													: nrows));
+	sort_path->custom_private = list_make1(pp_info);
+
+	return sort_path;
+}
+
+/*
+ * gpusort_build_tlist_dev
+ *
+ * It assigns resno of the sort keys on the tlist_dev
+ */
+void
+gpusort_build_tlist_dev(pgstromPlanInfo *pp_info, List *tlist_dev)
+{
+	List	   *resnos = NIL;
+	ListCell   *lc;
+
+	foreach (lc, pp_info->gpusort_keys)
+	{
+		Expr	   *sort_key = lfirst(lc);
+		TargetEntry *tle = tlist_member(sort_key, tlist_dev);
+
+		if (!tle || tle->resjunk)
+			elog(ERROR, "Bug? GpuSort key (%s) is not on the device projection",
+				 nodeToString(sort_key));
+		resnos = lappend_int(resnos, tle->resno);
+	}
+	pp_info->gpusort_resnos = resnos;
+}
+
+/*
+ * pgstrom_init_gpu_sort
+ */
+void
+pgstrom_init_gpu_sort(void)
+{
+	/* turn on/off gpusort */
+	DefineCustomBoolVariable("pg_strom.enable_gpusort",
+							 "Enables the use of GPU-side sorting (top-K) on GpuScan/GpuJoin results",
+							 NULL,
+							 &pgstrom_enable_gpusort,
+							 true,
+							 PGC_USERSET,
+							 GUC_NOT_IN_SAMPLE,
+							 NULL, NULL, NULL);
+	DefineCustomIntVariable("pg_strom.gpusort_max_limit",
+							"Maximum number of LIMIT rows to apply the GPU-side top-K sorting",
+							NULL,
+							&pgstrom_gpusort_max_limit,
+							100000,
+							1,
+							INT_MAX,
+							PGC_USERSET,
+							GUC_NOT_IN_SAMPLE,
+							NULL, NULL, NULL);
+	/* turn on/off gpusort for window functions */
+	DefineCustomBoolVariable("pg_strom.enable_gpusort_window",
+							 "Enables the use of GPU-side sorting for the input of window functions",
+							 NULL,
+							 &pgstrom_enable_gpusort_window,
+							 true,
+							 PGC_USERSET,
+							 GUC_NOT_IN_SAMPLE,
+							 NULL, NULL, NULL);
+}
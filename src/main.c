@@ -386,11 +386,15 @@ _PG_init(void)
 
 	/* init pg-strom infrastructure */
 	pgstrom_init_gucs();
+	pgstrom_init_shmem_options();
 	pgstrom_init_extra();
 	pgstrom_init_codegen();
 	pgstrom_init_relscan();
 	pgstrom_init_brin();
+	pgstrom_init_zonemap();
 	pgstrom_init_arrow_fdw();
+	pgstrom_init_objstore();
+	pgstrom_init_arrow_stream();
 	pgstrom_init_executor();
 	/* dump version number */
 	elog(LOG, "PG-Strom version %s built for PostgreSQL %s (githash: %s)",
@@ -401,9 +405,12 @@ _PG_init(void)
 	if (pgstrom_init_gpu_device())
 	{
 		pgstrom_init_gpu_service();
+		pgstrom_init_gpu_jit();
 		pgstrom_init_gpu_scan();
 		pgstrom_init_gpu_join();
+		pgstrom_init_gpu_sort();
 		pgstrom_init_gpu_preagg();
+		pgstrom_init_gpu_analyze();
 		pgstrom_init_gpu_cache();
 	}
 	/* init DPU related stuff */
@@ -414,6 +421,8 @@ _PG_init(void)
 		pgstrom_init_dpu_preagg();
 	}
 	pgstrom_init_pcie();
+	pgstrom_init_cost_calibration();
+	pgstrom_init_result_cache();
 	/* callback for the extension checker */
 	CacheRegisterSyscacheCallback(NAMESPACEOID, pgstrom_extension_checker_callback, 0);
 	/* dummy custom-scan node */
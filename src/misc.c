@@ -10,6 +10,7 @@
  * This program is free software; you can redistribute it and/or modify
  * it under the terms of the PostgreSQL License.
  */
+#include <sys/vfs.h>
 #include "pg_strom.h"
 
 /* ----------------------------------------------------------------
@@ -86,6 +87,7 @@ form_pgstrom_plan_info(CustomScan *cscan, pgstromPlanInfo *pp_info)
 	List	   *privs = NIL;
 	List	   *exprs = NIL;
 	List	   *kvars_deflist = NIL;
+	List	   *dpu_kvars_deflist = NIL;
 	ListCell   *lc;
 	int			endpoint_id;
 
@@ -112,6 +114,7 @@ form_pgstrom_plan_info(CustomScan *cscan, pgstromPlanInfo *pp_info)
 	privs = lappend(privs, makeInteger(pp_info->brin_index_oid));
 	exprs = lappend(exprs, pp_info->brin_index_conds);
 	exprs = lappend(exprs, pp_info->brin_index_quals);
+	exprs = lappend(exprs, pp_info->gpu_cache_lookup_key);
 	/* XPU code */
 	privs = lappend(privs, __makeByteaConst(pp_info->kexp_load_vars_packed));
 	privs = lappend(privs, __makeByteaConst(pp_info->kexp_move_vars_packed));
@@ -140,6 +143,37 @@ form_pgstrom_plan_info(CustomScan *cscan, pgstromPlanInfo *pp_info)
 	privs = lappend(privs, pp_info->fallback_tlist);
 	privs = lappend(privs, pp_info->groupby_actions);
 	privs = lappend(privs, makeInteger(pp_info->groupby_prepfn_bufsz));
+	privs = lappend(privs, makeBoolean(pp_info->groupby_complete));
+	privs = lappend(privs, pp_info->gpusort_resnos);
+	privs = lappend(privs, pp_info->gpusort_sortops);
+	privs = lappend(privs, pp_info->gpusort_collations);
+	privs = lappend(privs, pp_info->gpusort_descending);
+	privs = lappend(privs, pp_info->gpusort_nulls_first);
+	privs = lappend(privs, __makeFloat(pp_info->gpusort_limit));
+	privs = lappend(privs, __makeFloat(pp_info->scan_limit));
+	/* TABLESAMPLE */
+	privs = lappend(privs, makeInteger(pp_info->tablesample_method));
+	exprs = lappend(exprs, pp_info->tablesample_args);
+	exprs = lappend(exprs, pp_info->tablesample_repeatable);
+	/* DPU pre-filter */
+	exprs = lappend(exprs, pp_info->dpu_prefilter_quals);
+	privs = lappend(privs, __makeFloat(pp_info->dpu_prefilter_nrows));
+	privs = lappend(privs, __makeByteaConst(pp_info->kexp_dpu_prefilter_load_vars));
+	privs = lappend(privs, __makeByteaConst(pp_info->kexp_dpu_prefilter_move_vars));
+	privs = lappend(privs, __makeByteaConst(pp_info->kexp_dpu_prefilter_quals));
+	privs = lappend(privs, __makeByteaConst(pp_info->kexp_dpu_prefilter_projection));
+	foreach (lc, pp_info->dpu_prefilter_kvars_deflist)
+	{
+		codegen_kvar_defitem *kvdef = lfirst(lc);
+
+		dpu_kvars_deflist = lappend(dpu_kvars_deflist,
+									__form_codegen_kvar_defitem(kvdef));
+	}
+	privs = lappend(privs, dpu_kvars_deflist);
+	privs = lappend(privs, makeInteger(pp_info->dpu_prefilter_extra_bufsz));
+	/* cost calibration */
+	privs = lappend(privs, __makeFloat(pp_info->cost_setup_factor));
+	privs = lappend(privs, __makeFloat(pp_info->cost_run_factor));
 	/* inner relations */
 	privs = lappend(privs, makeInteger(pp_info->num_rels));
 	for (int i=0; i < pp_info->num_rels; i++)
@@ -169,6 +203,15 @@ form_pgstrom_plan_info(CustomScan *cscan, pgstromPlanInfo *pp_info)
 		__privs = lappend(__privs, __makeFloat(pp_inner->gist_selectivity));
 		__privs = lappend(__privs, __makeFloat(pp_inner->gist_npages));
 		__privs = lappend(__privs, makeInteger(pp_inner->gist_height));
+		__privs = lappend(__privs, __makeFloat(pp_inner->grid_cell_size));
+		__privs = lappend(__privs, __makeFloat(pp_inner->grid_expand));
+		__exprs = lappend(__exprs, pp_inner->range_outer_keys);
+		__exprs = lappend(__exprs, pp_inner->range_inner_keys);
+		__privs = lappend(__privs, pp_inner->range_inner_keys_fallback);
+		__exprs = lappend(__exprs, pp_inner->polygon_inner_key);
+		__privs = lappend(__privs, pp_inner->polygon_inner_key_fallback);
+		__privs = lappend(__privs, makeInteger(pp_inner->inner_nparts));
+		__privs = lappend(__privs, makeBoolean(pp_inner->bloom_prefilter));
 
 		privs = lappend(privs, __privs);
 		exprs = lappend(exprs, __exprs);
@@ -218,6 +261,7 @@ deform_pgstrom_plan_info(CustomScan *cscan)
 	pp_data.brin_index_oid = intVal(list_nth(privs, pindex++));
 	pp_data.brin_index_conds = list_nth(exprs, eindex++);
 	pp_data.brin_index_quals = list_nth(exprs, eindex++);
+	pp_data.gpu_cache_lookup_key = list_nth(exprs, eindex++);
 	/* XPU code */
 	pp_data.kexp_load_vars_packed  = __getByteaConst(list_nth(privs, pindex++));
 	pp_data.kexp_move_vars_packed  = __getByteaConst(list_nth(privs, pindex++));
@@ -246,6 +290,38 @@ deform_pgstrom_plan_info(CustomScan *cscan)
 	pp_data.fallback_tlist = list_nth(privs, pindex++);
 	pp_data.groupby_actions = list_nth(privs, pindex++);
 	pp_data.groupby_prepfn_bufsz  = intVal(list_nth(privs, pindex++));
+	pp_data.groupby_complete = boolVal(list_nth(privs, pindex++));
+	pp_data.gpusort_resnos = list_nth(privs, pindex++);
+	pp_data.gpusort_sortops = list_nth(privs, pindex++);
+	pp_data.gpusort_collations = list_nth(privs, pindex++);
+	pp_data.gpusort_descending = list_nth(privs, pindex++);
+	pp_data.gpusort_nulls_first = list_nth(privs, pindex++);
+	pp_data.gpusort_limit = floatVal(list_nth(privs, pindex++));
+	pp_data.scan_limit = floatVal(list_nth(privs, pindex++));
+	/* TABLESAMPLE */
+	pp_data.tablesample_method = intVal(list_nth(privs, pindex++));
+	pp_data.tablesample_args = list_nth(exprs, eindex++);
+	pp_data.tablesample_repeatable = list_nth(exprs, eindex++);
+	/* DPU pre-filter */
+	pp_data.dpu_prefilter_quals = list_nth(exprs, eindex++);
+	pp_data.dpu_prefilter_nrows = floatVal(list_nth(privs, pindex++));
+	pp_data.kexp_dpu_prefilter_load_vars = __getByteaConst(list_nth(privs, pindex++));
+	pp_data.kexp_dpu_prefilter_move_vars = __getByteaConst(list_nth(privs, pindex++));
+	pp_data.kexp_dpu_prefilter_quals = __getByteaConst(list_nth(privs, pindex++));
+	pp_data.kexp_dpu_prefilter_projection = __getByteaConst(list_nth(privs, pindex++));
+	kvars_deflist = list_nth(privs, pindex++);
+	foreach (lc, kvars_deflist)
+	{
+		List	   *sublist = (List *)lfirst(lc);
+
+		pp_data.dpu_prefilter_kvars_deflist =
+			lappend(pp_data.dpu_prefilter_kvars_deflist,
+					__deform_codegen_kvar_defitem(sublist));
+	}
+	pp_data.dpu_prefilter_extra_bufsz = intVal(list_nth(privs, pindex++));
+	/* cost calibration */
+	pp_data.cost_setup_factor = floatVal(list_nth(privs, pindex++));
+	pp_data.cost_run_factor = floatVal(list_nth(privs, pindex++));
 	/* inner relations */
 	pp_data.num_rels = intVal(list_nth(privs, pindex++));
 	pp_info = palloc0(offsetof(pgstromPlanInfo, inners[pp_data.num_rels]));
@@ -279,6 +355,15 @@ deform_pgstrom_plan_info(CustomScan *cscan)
 		pp_inner->gist_selectivity = floatVal(list_nth(__privs, __pindex++));
 		pp_inner->gist_npages     = floatVal(list_nth(__privs, __pindex++));
 		pp_inner->gist_height     = intVal(list_nth(__privs, __pindex++));
+		pp_inner->grid_cell_size  = floatVal(list_nth(__privs, __pindex++));
+		pp_inner->grid_expand     = floatVal(list_nth(__privs, __pindex++));
+		pp_inner->range_outer_keys = list_nth(__exprs, __eindex++);
+		pp_inner->range_inner_keys = list_nth(__exprs, __eindex++);
+		pp_inner->range_inner_keys_fallback = list_nth(__privs, __pindex++);
+		pp_inner->polygon_inner_key = list_nth(__exprs, __eindex++);
+		pp_inner->polygon_inner_key_fallback = list_nth(__privs, __pindex++);
+		pp_inner->inner_nparts    = intVal(list_nth(__privs, __pindex++));
+		pp_inner->bloom_prefilter = boolVal(list_nth(__privs, __pindex++));
 	}
 	return pp_info;
 }
@@ -304,6 +389,9 @@ copy_pgstrom_plan_info(const pgstromPlanInfo *pp_orig)
 	pp_dest->scan_quals_fallback = copyObject(pp_dest->scan_quals_fallback);
 	pp_dest->brin_index_conds = copyObject(pp_dest->brin_index_conds);
 	pp_dest->brin_index_quals = copyObject(pp_dest->brin_index_quals);
+	pp_dest->gpu_cache_lookup_key = copyObject(pp_dest->gpu_cache_lookup_key);
+	pp_dest->tablesample_args = copyObject(pp_dest->tablesample_args);
+	pp_dest->tablesample_repeatable = copyObject(pp_dest->tablesample_repeatable);
 	foreach (lc, pp_orig->kvars_deflist)
 	{
 		codegen_kvar_defitem *kvdef_orig = lfirst(lc);
@@ -315,6 +403,18 @@ copy_pgstrom_plan_info(const pgstromPlanInfo *pp_orig)
 	}
 	pp_dest->fallback_tlist   = copyObject(pp_dest->fallback_tlist);
 	pp_dest->groupby_actions  = list_copy(pp_dest->groupby_actions);
+	pp_dest->dpu_prefilter_quals = copyObject(pp_dest->dpu_prefilter_quals);
+	pp_dest->dpu_prefilter_kvars_deflist = NIL;
+	foreach (lc, pp_orig->dpu_prefilter_kvars_deflist)
+	{
+		codegen_kvar_defitem *kvdef_orig = lfirst(lc);
+		codegen_kvar_defitem *kvdef_dest;
+
+		kvdef_dest = pmemdup(kvdef_orig, sizeof(codegen_kvar_defitem));
+		kvdef_dest->kv_expr = copyObject(kvdef_dest->kv_expr);
+		pp_dest->dpu_prefilter_kvars_deflist =
+			lappend(pp_dest->dpu_prefilter_kvars_deflist, kvdef_dest);
+	}
 	for (int j=0; j < pp_orig->num_rels; j++)
 	{
 		pgstromPlanInnerInfo *pp_inner = &pp_dest->inners[j];
@@ -328,6 +428,11 @@ copy_pgstrom_plan_info(const pgstromPlanInfo *pp_orig)
 		__COPY(other_quals);
 		__COPY(other_quals_fallback);
 		__COPY(gist_clause);
+		__COPY(range_outer_keys);
+		__COPY(range_inner_keys);
+		__COPY(range_inner_keys_fallback);
+		__COPY(polygon_inner_key);
+		__COPY(polygon_inner_key_fallback);
 #undef __COPY
 	}
 	return pp_dest;
@@ -360,7 +465,6 @@ fixup_varnode_to_origin(Node *node, List *cscan_tlist)
 								   (void *)cscan_tlist);
 }
 
-#if 0
 /*
  * find_appinfos_by_relids_nofail
  *
@@ -451,6 +555,7 @@ find_appinfos_by_relids_nofail(PlannerInfo *root,
 	return appinfos;
 }
 
+#if 0
 /*
  * get_parallel_divisor - Estimate the fraction of the work that each worker
  * will do given the number of workers budgeted for the path.
@@ -1619,6 +1724,13 @@ __pwriteFile(int fdesc, const void *buffer, size_t nbytes, off_t f_pos)
  * ----------------------------------------------------------------
  */
 #define IS_POSIX_SHMEM		0x80000000U
+#define IS_HUGETLB_SHMEM	0x40000000U
+#define HUGETLBFS_MAGIC_NUMBER	0x958458f6
+#define SHMEM_HUGE_PAGE_SIZE	(2UL << 20)		/* transparent huge page */
+
+int			pgstrom_shmem_huge_pages;		/* GUC */
+static char *pgstrom_shmem_hugetlb_dir;		/* GUC */
+static size_t shmem_hugetlb_pagesz = 0;
 typedef struct
 {
 	uint32_t	shmem_handle;
@@ -1706,6 +1818,72 @@ cleanup_mmap_chunks(ResourceReleasePhase phase,
 	}
 }
 
+/*
+ * __shmemPathName - pathname of the shared memory segment
+ *
+ * The segments on hugetlbfs have IS_HUGETLB_SHMEM on the handle, so the
+ * processes attaching the segment can find out the file by the handle.
+ * It is safe to call on the GPU service threads.
+ */
+const char *
+__shmemPathName(char *namebuf, size_t namebuf_sz,
+				uint32_t shmem_handle,
+				const DpuStorageEntry *ds_entry)
+{
+	const char *shmem_dir = "/dev/shm";
+
+	if (ds_entry)
+		shmem_dir = DpuStorageEntryBaseDir(ds_entry);
+	else if ((shmem_handle & IS_HUGETLB_SHMEM) != 0)
+		shmem_dir = pgstrom_shmem_hugetlb_dir;
+	snprintf(namebuf, namebuf_sz,
+			 "%s/.pgstrom_shmbuf_%u_%d",
+			 shmem_dir, PostPortNumber, shmem_handle);
+	return namebuf;
+}
+
+/*
+ * __shmemAlignSize / __shmemAdviseHugePages
+ *
+ * Segments larger than a huge page are aligned to the huge page size, and
+ * advised to be backed by the transparent huge pages; it is a hint, so the
+ * kernel uses the regular pages if /dev/shm is not mounted with huge=.
+ * They are safe to call on the GPU service threads.
+ */
+size_t
+__shmemAlignSize(size_t length)
+{
+	if (pgstrom_shmem_huge_pages != SHMEM_HUGE_PAGES__OFF &&
+		length >= SHMEM_HUGE_PAGE_SIZE)
+		return TYPEALIGN(SHMEM_HUGE_PAGE_SIZE, length);
+	return PAGE_ALIGN(length);
+}
+
+void
+__shmemAdviseHugePages(void *addr, size_t length)
+{
+	if (pgstrom_shmem_huge_pages != SHMEM_HUGE_PAGES__OFF &&
+		length >= SHMEM_HUGE_PAGE_SIZE)
+		(void)madvise(addr, length, MADV_HUGEPAGE);
+}
+
+/*
+ * __shmemHugetlbAvailable - checks whether hugetlbfs has free pages
+ */
+static bool
+__shmemHugetlbAvailable(void)
+{
+	struct statfs	fs_buf;
+
+	if (pgstrom_shmem_huge_pages != SHMEM_HUGE_PAGES__HUGETLB ||
+		shmem_hugetlb_pagesz == 0)
+		return false;
+	if (statfs(pgstrom_shmem_hugetlb_dir, &fs_buf) != 0 ||
+		fs_buf.f_bavail == 0)
+		return false;
+	return true;
+}
+
 uint32_t
 __shmemCreate(const DpuStorageEntry *ds_entry)
 {
@@ -1715,6 +1893,7 @@ __shmemCreate(const DpuStorageEntry *ds_entry)
 	uint32_t	handle;
 	char		namebuf[MAXPGPATH];
 	size_t		off = 0;
+	bool		use_hugetlb = false;
 
 	if (!shmem_tracker_htab)
 	{
@@ -1734,6 +1913,11 @@ __shmemCreate(const DpuStorageEntry *ds_entry)
 
 	if (ds_entry)
 		shmem_dir = DpuStorageEntryBaseDir(ds_entry);
+	else if (__shmemHugetlbAvailable())
+	{
+		shmem_dir = pgstrom_shmem_hugetlb_dir;
+		use_hugetlb = true;
+	}
 	off = snprintf(namebuf, sizeof(namebuf), "%s/", shmem_dir);
 	do {
 		handle = rand_r(&my_random_seed);
@@ -1744,6 +1928,10 @@ __shmemCreate(const DpuStorageEntry *ds_entry)
 			handle |= IS_POSIX_SHMEM;
 		else
 			handle &= ~IS_POSIX_SHMEM;
+		if (use_hugetlb)
+			handle |= IS_HUGETLB_SHMEM;
+		else
+			handle &= ~IS_HUGETLB_SHMEM;
 
 		snprintf(namebuf + off, sizeof(namebuf) - off,
 				 ".pgstrom_shmbuf_%u_%d",
@@ -1805,13 +1993,56 @@ __shmemDrop(uint32_t shmem_handle)
 	elog(ERROR, "failed on __shmemDrop - no such segment (%u)", shmem_handle);
 }
 
+/*
+ * __shmemDetach
+ *
+ * It detaches the shared memory segment from the resource tracker, but
+ * does not unlink the file; so, it can be used beyond the lifetime of
+ * the current resource owner. Caller shall unlink it by __shmemUnlink().
+ */
+void
+__shmemDetach(uint32_t shmem_handle)
+{
+	if (shmem_tracker_htab)
+	{
+		shmemEntry *entry;
+
+		entry = hash_search(shmem_tracker_htab,
+							&shmem_handle,
+							HASH_REMOVE,
+							NULL);
+		if (entry)
+		{
+			if (close(entry->shmem_fdesc) != 0)
+				elog(WARNING, "failed on close('%s'): %m", entry->shmem_name);
+			return;
+		}
+	}
+	elog(ERROR, "failed on __shmemDetach - no such segment (%u)", shmem_handle);
+}
+
+/*
+ * __shmemUnlink
+ *
+ * It unlinks the shared memory segment that is already detached.
+ */
+void
+__shmemUnlink(uint32_t shmem_handle, const DpuStorageEntry *ds_entry)
+{
+	char		namebuf[MAXPGPATH];
+
+	__shmemPathName(namebuf, sizeof(namebuf), shmem_handle, ds_entry);
+	if (unlink(namebuf) != 0 && errno != ENOENT)
+		elog(WARNING, "failed on unlink('%s'): %m", namebuf);
+}
+
 void *
 __mmapShmem(uint32_t shmem_handle,
 			size_t   shmem_length,
 			const DpuStorageEntry *ds_entry)
 {
 	void	   *mmap_addr = MAP_FAILED;
-	size_t		mmap_size = TYPEALIGN(PAGE_SIZE, shmem_length);
+	size_t		mmap_size;
 	int			mmap_prot = PROT_READ | PROT_WRITE;
 	int			mmap_flags = MAP_SHARED;
 	mmapEntry  *mmap_entry = NULL;
@@ -1824,7 +2055,23 @@ __mmapShmem(uint32_t shmem_handle,
 	char		namebuf[MAXPGPATH];
 
 	if (ds_entry)
+	{
 		shmem_dir = DpuStorageEntryBaseDir(ds_entry);
+		mmap_size = PAGE_ALIGN(shmem_length);
+	}
+	else if ((shmem_handle & IS_HUGETLB_SHMEM) != 0)
+	{
+		/* hugetlbfs requires the mapping size aligned to the huge page */
+		shmem_dir = pgstrom_shmem_hugetlb_dir;
+		if (shmem_hugetlb_pagesz == 0)
+			elog(ERROR, "Bug? segment (%u) is on hugetlbfs, but not configured",
+				 shmem_handle);
+		mmap_size = TYPEALIGN(shmem_hugetlb_pagesz, shmem_length);
+	}
+	else
+	{
+		mmap_size = __shmemAlignSize(shmem_length);
+	}
 	if (!mmap_tracker_htab)
 	{
 		HASHCTL		hctl;
@@ -1858,9 +2105,7 @@ __mmapShmem(uint32_t shmem_handle,
 	}
 	if (fdesc < 0)
 	{
-		snprintf(namebuf, sizeof(namebuf),
-				 "%s/.pgstrom_shmbuf_%u_%d",
-				 shmem_dir, PostPortNumber, shmem_handle);
+		__shmemPathName(namebuf, sizeof(namebuf), shmem_handle, ds_entry);
 		fdesc = open(namebuf, O_RDWR, 0600);
 		if (fdesc < 0)
 			elog(ERROR, "failed on open('%s'): %m", namebuf);
@@ -1875,14 +2120,23 @@ __mmapShmem(uint32_t shmem_handle,
 		{
 			while (fallocate(fdesc, 0, 0, mmap_size) != 0)
 			{
-				if (errno != EINTR)
-					elog(ERROR, "failed on fallocate('%s', %lu): %m",
-						 fname, mmap_size);
+				if (errno == EINTR)
+					continue;
+				if ((shmem_handle & IS_HUGETLB_SHMEM) != 0 && errno == ENOSPC)
+					ereport(ERROR,
+							(errcode(ERRCODE_OUT_OF_MEMORY),
+							 errmsg("out of huge pages on '%s' for %zu bytes",
+									shmem_dir, mmap_size),
+							 errhint("Increase vm.nr_hugepages, or set pg_strom.shmem_huge_pages = transparent")));
+				elog(ERROR, "failed on fallocate('%s', %lu): %m",
+					 fname, mmap_size);
 			}
 		}
 		mmap_addr = mmap(NULL, mmap_size, mmap_prot, mmap_flags, fdesc, 0);
 		if (mmap_addr == MAP_FAILED)
 			elog(ERROR, "failed on mmap(2): %m");
+		if (!ds_entry && (shmem_handle & IS_HUGETLB_SHMEM) == 0)
+			__shmemAdviseHugePages(mmap_addr, mmap_size);
 
 		mmap_entry = hash_search(mmap_tracker_htab,
 								 &mmap_addr,
@@ -1939,3 +2193,54 @@ __munmapShmem(void *mmap_addr)
 	elog(ERROR, "it looks addr=%p not memory-mapped", mmap_addr);
 	return false;
 }
+
+/*
+ * pgstrom_init_shmem_options
+ */
+void
+pgstrom_init_shmem_options(void)
+{
+	static struct config_enum_entry __shmem_huge_pages_options[] = {
+		{"off",			SHMEM_HUGE_PAGES__OFF,			false},
+		{"transparent",	SHMEM_HUGE_PAGES__TRANSPARENT,	false},
+		{"hugetlb",		SHMEM_HUGE_PAGES__HUGETLB,		false},
+		{NULL, 0, false}
+	};
+
+	DefineCustomEnumVariable("pg_strom.shmem_huge_pages",
+							 "Huge pages for the shared memory segments of chunk/result buffers",
+							 "'transparent' advises the transparent huge pages (2MB) on /dev/shm, 'hugetlb' puts the segments on pg_strom.shmem_hugetlb_dir (2MB or 1GB)",
+							 &pgstrom_shmem_huge_pages,
+							 SHMEM_HUGE_PAGES__TRANSPARENT,
+							 __shmem_huge_pages_options,
+							 PGC_POSTMASTER,
+							 GUC_NOT_IN_SAMPLE,
+							 NULL, NULL, NULL);
+	DefineCustomStringVariable("pg_strom.shmem_hugetlb_dir",
+							   "Directory on hugetlbfs for the shared memory segments",
+							   NULL,
+							   &pgstrom_shmem_hugetlb_dir,
+							   "/dev/hugepages",
+							   PGC_POSTMASTER,
+							   GUC_NOT_IN_SAMPLE,
+							   NULL, NULL, NULL);
+	if (pgstrom_shmem_huge_pages == SHMEM_HUGE_PAGES__HUGETLB)
+	{
+		struct statfs	fs_buf;
+
+		if (statfs(pgstrom_shmem_hugetlb_dir, &fs_buf) != 0 ||
+			fs_buf.f_type != HUGETLBFS_MAGIC_NUMBER)
+		{
+			elog(LOG, "PG-Strom: '%s' is not on hugetlbfs, so the transparent huge pages are used instead",
+				 pgstrom_shmem_hugetlb_dir);
+			pgstrom_shmem_huge_pages = SHMEM_HUGE_PAGES__TRANSPARENT;
+		}
+		else
+		{
+			shmem_hugetlb_pagesz = fs_buf.f_bsize;
+			elog(LOG, "PG-Strom: shared memory segments are on '%s' (huge page size: %s)",
+				 pgstrom_shmem_hugetlb_dir,
+				 format_bytesz(shmem_hugetlb_pagesz));
+		}
+	}
+}
@@ -0,0 +1,1088 @@
+/*
+ * objstore.c
+ *
+ * Object storage (S3-compatible) backend of arrow_fdw.
+ *
+ * An object (s3://bucket/key) is mapped on a sparse local cache file with
+ * the same size, so arrow_fdw and the GPU-service read it as if it were
+ * a local file. Byte ranges are fetched by concurrent ranged GETs on
+ * demand, or prefetched, in units of OBJSTORE_CHUNK_SIZE. The map file
+ * next to the cache file (shared by all the backends using mmap) tracks
+ * the last access time of each chunk; zero means not cached yet.
+ * ----
+ * Copyright 2011-2023 (C) KaiGai Kohei <kaigai@kaigai.gr.jp>
+ * Copyright 2014-2023 (C) PG-Strom Developers Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the PostgreSQL License.
+ */
+#include "pg_strom.h"
+#include <dirent.h>
+#include <sys/file.h>
+#ifdef USE_LIBCURL
+#include <curl/curl.h>
+#endif
+
+#define OBJSTORE_URL_PREFIX			"s3://"
+#define OBJSTORE_CHUNK_SIZE			(1UL << 20)		/* 1MB */
+#define OBJSTORE_MAX_GET_CHUNKS		8				/* 8MB per GET */
+#define OBJSTORE_MAP_MAGIC			0x4f424a53U		/* 'OBJS' */
+#define OBJSTORE_MAP_VERSION		1
+#define OBJSTORE_REVALIDATE_SECS	60
+#define OBJSTORE_EVICT_MIN_AGE		60				/* seconds */
+
+/* static variables */
+static char	   *objstore_cache_dir = NULL;		/* GUC */
+static int		objstore_cache_size_mb;			/* GUC */
+static char	   *objstore_s3_endpoint = NULL;	/* GUC */
+static char	   *objstore_s3_region = NULL;		/* GUC */
+static int		objstore_max_requests;			/* GUC */
+
+#ifdef USE_LIBCURL
+/*
+ * objstoreMapHead - header of the map file
+ */
+typedef struct
+{
+	uint32_t	magic;
+	uint32_t	version;
+	uint64_t	object_size;
+	uint64_t	chunk_size;
+	int64_t		object_mtime;
+	char		etag[128];
+	uint32_t	chunks[FLEXIBLE_ARRAY_MEMBER];	/* last access time */
+} objstoreMapHead;
+
+typedef struct
+{
+	char		cache_path[MAXPGPATH];	/* hash key */
+	char	   *url;
+	char	   *bucket;
+	char	   *key;
+	size_t		object_size;
+	uint32_t	nchunks;
+	int			data_fdesc;
+	int			map_fdesc;
+	objstoreMapHead *map;
+	size_t		map_length;
+	time_t		validated_at;
+	int			num_errors;			/* number of failed GETs */
+	char		last_error[256];
+} objstoreObject;
+
+typedef struct objstoreRequest
+{
+	dlist_node	chain;
+	objstoreObject *obj;
+	uint32_t	chunk_base;
+	uint32_t	chunk_count;
+	off_t		f_pos;				/* next position to write */
+	off_t		f_tail;				/* expected tail position */
+	bool		write_error;
+	CURL	   *curl;
+	struct curl_slist *headers;
+} objstoreRequest;
+
+static HTAB		   *objstore_htab = NULL;
+static CURLM	   *objstore_curlm = NULL;
+static dlist_head	objstore_pending_list;	/* not started yet */
+static dlist_head	objstore_running_list;	/* in-progress */
+static int			objstore_num_running = 0;
+static size_t		objstore_fetched_bytes = 0;	/* since the last eviction */
+
+/*
+ * curl multi-handle is set up on demand, not to be inherited by fork(2)
+ */
+static void
+__objstoreInitMultiHandle(void)
+{
+	if (objstore_curlm)
+		return;
+	objstore_curlm = curl_multi_init();
+	if (!objstore_curlm)
+		elog(ERROR, "failed on curl_multi_init");
+	dlist_init(&objstore_pending_list);
+	dlist_init(&objstore_running_list);
+}
+
+/*
+ * URL-encode of the S3 object key (RFC 3986 unreserved chars are kept)
+ */
+static void
+__appendUriEncoded(StringInfo buf, const char *str, bool encode_slash)
+{
+	for (const char *pos = str; *pos; pos++)
+	{
+		int		c = (unsigned char)*pos;
+
+		if (isalnum(c) || c == '-' || c == '_' || c == '.' || c == '~' ||
+			(c == '/' && !encode_slash))
+			appendStringInfoChar(buf, c);
+		else
+			appendStringInfo(buf, "%%%02X", c);
+	}
+}
+
+static void
+__hexEncode(char *dest, const uint8_t *src, int len)
+{
+	static const char hextbl[] = "0123456789abcdef";
+
+	for (int i=0; i < len; i++)
+	{
+		dest[2*i]   = hextbl[(src[i] >> 4) & 0x0f];
+		dest[2*i+1] = hextbl[src[i] & 0x0f];
+	}
+	dest[2*len] = '\0';
+}
+
+static void
+__sha256Hex(char *dest, const char *data, size_t len)
+{
+	pg_cryptohash_ctx *ctx = pg_cryptohash_create(PG_SHA256);
+	uint8_t		digest[PG_SHA256_DIGEST_LENGTH];
+
+	if (pg_cryptohash_init(ctx) < 0 ||
+		pg_cryptohash_update(ctx, (const uint8 *)data, len) < 0 ||
+		pg_cryptohash_final(ctx, digest, sizeof(digest)) < 0)
+		elog(ERROR, "failed on SHA256: %s", pg_cryptohash_error(ctx));
+	pg_cryptohash_free(ctx);
+	__hexEncode(dest, digest, sizeof(digest));
+}
+
+static void
+__hmacSha256(uint8_t *dest, const uint8_t *key, size_t keylen,
+			 const char *data)
+{
+	pg_hmac_ctx *ctx = pg_hmac_create(PG_SHA256);
+
+	if (pg_hmac_init(ctx, key, keylen) < 0 ||
+		pg_hmac_update(ctx, (const uint8 *)data, strlen(data)) < 0 ||
+		pg_hmac_final(ctx, dest, PG_SHA256_DIGEST_LENGTH) < 0)
+		elog(ERROR, "failed on HMAC-SHA256: %s", pg_hmac_error(ctx));
+	pg_hmac_free(ctx);
+}
+
+/*
+ * __objstoreBuildRequest
+ *
+ * It builds URL and headers to access the object, with AWS signature V4
+ * if AWS_ACCESS_KEY_ID and AWS_SECRET_ACCESS_KEY are given.
+ */
+static struct curl_slist *
+__objstoreBuildRequest(objstoreObject *obj, const char *method,
+					   const char *range, StringInfo url)
+{
+	const char *access_key = getenv("AWS_ACCESS_KEY_ID");
+	const char *secret_key = getenv("AWS_SECRET_ACCESS_KEY");
+	const char *session_token = getenv("AWS_SESSION_TOKEN");
+	const char *region = objstore_s3_region;
+	struct curl_slist *headers = NULL;
+	StringInfoData path;
+	StringInfoData host;
+	StringInfoData temp;
+	char		amz_date[32];
+	char		scope_date[16];
+	time_t		now = time(NULL);
+	struct tm	tm;
+
+	/* endpoint and canonical URI (path-style) */
+	initStringInfo(&host);
+	if (objstore_s3_endpoint && *objstore_s3_endpoint)
+	{
+		const char *pos = strstr(objstore_s3_endpoint, "://");
+
+		appendStringInfoString(&host, pos ? pos + 3 : objstore_s3_endpoint);
+		while (host.len > 0 && host.data[host.len-1] == '/')
+			host.data[--host.len] = '\0';
+		appendStringInfo(url, "%s%s", pos ? "" : "https://",
+						 objstore_s3_endpoint);
+		while (url->len > 0 && url->data[url->len-1] == '/')
+			url->data[--url->len] = '\0';
+	}
+	else
+	{
+		appendStringInfo(&host, "s3.%s.amazonaws.com", region);
+		appendStringInfo(url, "https://%s", host.data);
+	}
+	initStringInfo(&path);
+	appendStringInfoChar(&path, '/');
+	__appendUriEncoded(&path, obj->bucket, true);
+	appendStringInfoChar(&path, '/');
+	__appendUriEncoded(&path, obj->key, false);
+	appendStringInfoString(url, path.data);
+
+	initStringInfo(&temp);
+	if (range)
+	{
+		appendStringInfo(&temp, "Range: bytes=%s", range);
+		headers = curl_slist_append(headers, temp.data);
+	}
+	if (access_key && secret_key)
+	{
+		char		payload_hash[] = "UNSIGNED-PAYLOAD";
+		char		canonical_hash[2 * PG_SHA256_DIGEST_LENGTH + 1];
+		char		signature[2 * PG_SHA256_DIGEST_LENGTH + 1];
+		uint8_t		key[PG_SHA256_DIGEST_LENGTH];
+		const char *signed_headers;
+		StringInfoData canonical;
+		StringInfoData to_sign;
+
+		gmtime_r(&now, &tm);
+		strftime(amz_date, sizeof(amz_date), "%Y%m%dT%H%M%SZ", &tm);
+		strftime(scope_date, sizeof(scope_date), "%Y%m%d", &tm);
+
+		signed_headers = (session_token
+						  ? "host;x-amz-content-sha256;x-amz-date;x-amz-security-token"
+						  : "host;x-amz-content-sha256;x-amz-date");
+		initStringInfo(&canonical);
+		appendStringInfo(&canonical,
+						 "%s\n%s\n\n"
+						 "host:%s\n"
+						 "x-amz-content-sha256:%s\n"
+						 "x-amz-date:%s\n",
+						 method, path.data,
+						 host.data, payload_hash, amz_date);
+		if (session_token)
+			appendStringInfo(&canonical, "x-amz-security-token:%s\n", session_token);
+		appendStringInfo(&canonical, "\n%s\n%s", signed_headers, payload_hash);
+		__sha256Hex(canonical_hash, canonical.data, canonical.len);
+
+		initStringInfo(&to_sign);
+		appendStringInfo(&to_sign,
+						 "AWS4-HMAC-SHA256\n%s\n%s/%s/s3/aws4_request\n%s",
+						 amz_date, scope_date, region, canonical_hash);
+		/* signing key */
+		resetStringInfo(&temp);
+		appendStringInfo(&temp, "AWS4%s", secret_key);
+		__hmacSha256(key, (uint8_t *)temp.data, temp.len, scope_date);
+		__hmacSha256(key, key, sizeof(key), region);
+		__hmacSha256(key, key, sizeof(key), "s3");
+		__hmacSha256(key, key, sizeof(key), "aws4_request");
+		__hmacSha256(key, key, sizeof(key), to_sign.data);
+		__hexEncode(signature, key, sizeof(key));
+
+		resetStringInfo(&temp);
+		appendStringInfo(&temp, "x-amz-date: %s", amz_date);
+		headers = curl_slist_append(headers, temp.data);
+		resetStringInfo(&temp);
+		appendStringInfo(&temp, "x-amz-content-sha256: %s", payload_hash);
+		headers = curl_slist_append(headers, temp.data);
+		if (session_token)
+		{
+			resetStringInfo(&temp);
+			appendStringInfo(&temp, "x-amz-security-token: %s", session_token);
+			headers = curl_slist_append(headers, temp.data);
+		}
+		resetStringInfo(&temp);
+		appendStringInfo(&temp,
+						 "Authorization: AWS4-HMAC-SHA256 "
+						 "Credential=%s/%s/%s/s3/aws4_request, "
+						 "SignedHeaders=%s, Signature=%s",
+						 access_key, scope_date, region,
+						 signed_headers, signature);
+		headers = curl_slist_append(headers, temp.data);
+		pfree(canonical.data);
+		pfree(to_sign.data);
+	}
+	pfree(temp.data);
+	pfree(path.data);
+	pfree(host.data);
+
+	return headers;
+}
+
+/*
+ * __objstoreHeadObject
+ */
+static size_t
+__objstoreHeaderCallback(char *buffer, size_t size, size_t nitems, void *private)
+{
+	char	   *etag = private;
+	size_t		len = size * nitems;
+
+	if (len > 5 && strncasecmp(buffer, "etag:", 5) == 0)
+	{
+		const char *pos = buffer + 5;
+		size_t		n;
+
+		while (*pos == ' ')
+			pos++;
+		n = len - (pos - buffer);
+		while (n > 0 && (pos[n-1] == '\r' || pos[n-1] == '\n'))
+			n--;
+		n = Min(n, 127);
+		memcpy(etag, pos, n);
+		etag[n] = '\0';
+	}
+	return len;
+}
+
+static void
+__objstoreHeadObject(objstoreObject *obj,
+					 size_t *p_object_size,
+					 int64_t *p_object_mtime,
+					 char *etag)
+{
+	StringInfoData url;
+	struct curl_slist *headers;
+	CURL	   *curl;
+	CURLcode	rc;
+	long		status = 0;
+	curl_off_t	length = -1;
+	long		filetime = -1;
+
+	initStringInfo(&url);
+	headers = __objstoreBuildRequest(obj, "HEAD", NULL, &url);
+	curl = curl_easy_init();
+	if (!curl)
+		elog(ERROR, "failed on curl_easy_init");
+	memset(etag, 0, 128);
+	curl_easy_setopt(curl, CURLOPT_URL, url.data);
+	curl_easy_setopt(curl, CURLOPT_NOBODY, 1L);
+	curl_easy_setopt(curl, CURLOPT_FILETIME, 1L);
+	curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
+	curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, __objstoreHeaderCallback);
+	curl_easy_setopt(curl, CURLOPT_HEADERDATA, etag);
+	curl_easy_setopt(curl, CURLOPT_TIMEOUT, 60L);
+	curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
+	rc = curl_easy_perform(curl);
+	if (rc == CURLE_OK)
+	{
+		curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &status);
+		curl_easy_getinfo(curl, CURLINFO_CONTENT_LENGTH_DOWNLOAD_T, &length);
+		curl_easy_getinfo(curl, CURLINFO_FILETIME, &filetime);
+	}
+	curl_slist_free_all(headers);
+	curl_easy_cleanup(curl);
+	if (rc != CURLE_OK)
+		elog(ERROR, "objstore: failed on HEAD '%s': %s",
+			 obj->url, curl_easy_strerror(rc));
+	if (status != 200)
+		elog(ERROR, "objstore: failed on HEAD '%s': HTTP status %ld",
+			 obj->url, status);
+	if (length < 0)
+		elog(ERROR, "objstore: unknown size of '%s'", obj->url);
+	*p_object_size = length;
+	*p_object_mtime = filetime;
+	pfree(url.data);
+}
+
+/*
+ * __objstoreMapObject
+ *
+ * It opens (or creates) the cache file and the map file, then validates
+ * them with the current object.
+ */
+static void
+__objstoreUnmapObject(objstoreObject *obj)
+{
+	if (obj->map)
+		munmap(obj->map, obj->map_length);
+	if (obj->data_fdesc >= 0)
+		close(obj->data_fdesc);
+	if (obj->map_fdesc >= 0)
+		close(obj->map_fdesc);
+	obj->map = NULL;
+	obj->map_length = 0;
+	obj->data_fdesc = -1;
+	obj->map_fdesc = -1;
+}
+
+static void
+__objstoreMapObject(objstoreObject *obj)
+{
+	char		map_path[MAXPGPATH];
+	size_t		object_size;
+	int64_t		object_mtime;
+	char		etag[128];
+	uint32_t	nchunks;
+	size_t		map_length;
+	struct stat	stat_buf;
+	objstoreMapHead *map;
+
+	__objstoreHeadObject(obj, &object_size, &object_mtime, etag);
+	nchunks = (object_size + OBJSTORE_CHUNK_SIZE - 1) / OBJSTORE_CHUNK_SIZE;
+	map_length = offsetof(objstoreMapHead, chunks[nchunks]);
+
+	if (obj->map &&
+		obj->map->object_size == object_size &&
+		obj->map->object_mtime == object_mtime &&
+		strcmp(obj->map->etag, etag) == 0)
+	{
+		obj->validated_at = time(NULL);
+		return;		/* still valid */
+	}
+	__objstoreUnmapObject(obj);
+
+	if (MakePGDirectory(objstore_cache_dir) != 0 && errno != EEXIST)
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not create directory \"%s\": %m",
+						objstore_cache_dir)));
+	snprintf(map_path, sizeof(map_path), "%s.map", obj->cache_path);
+	obj->data_fdesc = open(obj->cache_path, O_RDWR | O_CREAT | PG_BINARY, 0600);
+	if (obj->data_fdesc < 0)
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not open file \"%s\": %m", obj->cache_path)));
+	obj->map_fdesc = open(map_path, O_RDWR | O_CREAT | PG_BINARY, 0600);
+	if (obj->map_fdesc < 0)
+	{
+		__objstoreUnmapObject(obj);
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not open file \"%s\": %m", map_path)));
+	}
+	while (flock(obj->map_fdesc, LOCK_EX) != 0)
+	{
+		if (errno != EINTR)
+		{
+			__objstoreUnmapObject(obj);
+			elog(ERROR, "failed on flock('%s'): %m", map_path);
+		}
+	}
+	if (fstat(obj->map_fdesc, &stat_buf) != 0 ||
+		(stat_buf.st_size != map_length &&
+		 ftruncate(obj->map_fdesc, map_length) != 0))
+	{
+		__objstoreUnmapObject(obj);
+		elog(ERROR, "failed on fstat/ftruncate('%s'): %m", map_path);
+	}
+	map = mmap(NULL, map_length, PROT_READ | PROT_WRITE, MAP_SHARED,
+			   obj->map_fdesc, 0);
+	if (map == MAP_FAILED)
+	{
+		__objstoreUnmapObject(obj);
+		elog(ERROR, "failed on mmap('%s'): %m", map_path);
+	}
+	obj->map = map;
+	obj->map_length = map_length;
+	if (map->magic != OBJSTORE_MAP_MAGIC ||
+		map->version != OBJSTORE_MAP_VERSION ||
+		map->object_size != object_size ||
+		map->chunk_size != OBJSTORE_CHUNK_SIZE ||
+		map->object_mtime != object_mtime ||
+		strcmp(map->etag, etag) != 0)
+	{
+		struct timespec times[2];
+
+		/* object is new or modified, so reset the local cache */
+		memset(map, 0, map_length);
+		if (ftruncate(obj->data_fdesc, 0) != 0 ||
+			ftruncate(obj->data_fdesc, object_size) != 0)
+		{
+			__objstoreUnmapObject(obj);
+			elog(ERROR, "failed on ftruncate('%s'): %m", obj->cache_path);
+		}
+		/* arrow_fdw's metadata cache is invalidated by the mtime */
+		times[0].tv_sec  = times[1].tv_sec  = (object_mtime >= 0
+												? object_mtime
+												: time(NULL));
+		times[0].tv_nsec = times[1].tv_nsec = 0;
+		if (futimens(obj->data_fdesc, times) != 0)
+			elog(WARNING, "failed on futimens('%s'): %m", obj->cache_path);
+		map->object_size = object_size;
+		map->chunk_size = OBJSTORE_CHUNK_SIZE;
+		map->object_mtime = object_mtime;
+		strcpy(map->etag, etag);
+		map->version = OBJSTORE_MAP_VERSION;
+		pg_memory_barrier();
+		map->magic = OBJSTORE_MAP_MAGIC;
+	}
+	flock(obj->map_fdesc, LOCK_UN);
+	obj->object_size = object_size;
+	obj->nchunks = nchunks;
+	obj->validated_at = time(NULL);
+}
+
+/*
+ * __objstoreLookupObject
+ */
+static objstoreObject *
+__objstoreLookupObject(const char *cache_path)
+{
+	if (!objstore_htab)
+		return NULL;
+	return hash_search(objstore_htab, cache_path, HASH_FIND, NULL);
+}
+
+/*
+ * Ranged GET requests
+ */
+static size_t
+__objstoreWriteCallback(char *ptr, size_t size, size_t nmemb, void *private)
+{
+	objstoreRequest *req = private;
+	size_t		len = size * nmemb;
+	size_t		off = 0;
+
+	while (off < len)
+	{
+		ssize_t	nbytes;
+
+		if (req->f_pos + (len - off) > req->f_tail)
+		{
+			req->write_error = true;	/* larger than the requested range */
+			return 0;
+		}
+		nbytes = pwrite(req->obj->data_fdesc, ptr + off, len - off, req->f_pos);
+		if (nbytes <= 0)
+		{
+			if (nbytes < 0 && errno == EINTR)
+				continue;
+			req->write_error = true;
+			return 0;
+		}
+		off += nbytes;
+		req->f_pos += nbytes;
+	}
+	return len;
+}
+
+static void
+__objstoreStartRequest(objstoreRequest *req)
+{
+	objstoreObject *obj = req->obj;
+	StringInfoData url;
+	char		range[80];
+
+	snprintf(range, sizeof(range), "%lu-%lu",
+			 (uint64_t)req->f_pos, (uint64_t)req->f_tail - 1);
+	initStringInfo(&url);
+	req->headers = __objstoreBuildRequest(obj, "GET", range, &url);
+	req->curl = curl_easy_init();
+	if (!req->curl)
+		elog(ERROR, "failed on curl_easy_init");
+	curl_easy_setopt(req->curl, CURLOPT_URL, url.data);
+	curl_easy_setopt(req->curl, CURLOPT_HTTPHEADER, req->headers);
+	curl_easy_setopt(req->curl, CURLOPT_WRITEFUNCTION, __objstoreWriteCallback);
+	curl_easy_setopt(req->curl, CURLOPT_WRITEDATA, req);
+	curl_easy_setopt(req->curl, CURLOPT_PRIVATE, req);
+	curl_easy_setopt(req->curl, CURLOPT_NOSIGNAL, 1L);
+	curl_easy_setopt(req->curl, CURLOPT_LOW_SPEED_LIMIT, 1024L);
+	curl_easy_setopt(req->curl, CURLOPT_LOW_SPEED_TIME, 60L);
+	if (curl_multi_add_handle(objstore_curlm, req->curl) != CURLM_OK)
+		elog(ERROR, "failed on curl_multi_add_handle");
+	pfree(url.data);
+	dlist_push_tail(&objstore_running_list, &req->chain);
+	objstore_num_running++;
+}
+
+static void
+__objstoreCompleteRequest(objstoreRequest *req, CURLcode rc)
+{
+	objstoreObject *obj = req->obj;
+	long		status = 0;
+
+	curl_easy_getinfo(req->curl, CURLINFO_RESPONSE_CODE, &status);
+	if (rc == CURLE_OK &&
+		(status == 206 || status == 200) &&
+		!req->write_error &&
+		req->f_pos == req->f_tail &&
+		obj->map)
+	{
+		uint32_t	now = (uint32_t)time(NULL);
+
+		for (uint32_t i=0; i < req->chunk_count; i++)
+			obj->map->chunks[req->chunk_base + i] = now;
+		objstore_fetched_bytes += req->chunk_count * OBJSTORE_CHUNK_SIZE;
+	}
+	else
+	{
+		obj->num_errors++;
+		if (rc != CURLE_OK)
+			snprintf(obj->last_error, sizeof(obj->last_error),
+					 "%s", curl_easy_strerror(rc));
+		else if (req->write_error)
+			snprintf(obj->last_error, sizeof(obj->last_error),
+					 "failed on write the local cache: %s", strerror(errno));
+		else
+			snprintf(obj->last_error, sizeof(obj->last_error),
+					 "HTTP status %ld", status);
+	}
+	curl_multi_remove_handle(objstore_curlm, req->curl);
+	curl_easy_cleanup(req->curl);
+	curl_slist_free_all(req->headers);
+	dlist_delete(&req->chain);
+	objstore_num_running--;
+	free(req);
+}
+
+/*
+ * __objstoreProgress
+ *
+ * It drives the ranged GET requests. If 'timeout_ms' is positive, it waits
+ * for any progress up to the timeout.
+ */
+static void
+__objstoreProgress(int timeout_ms)
+{
+	CURLMsg	   *msg;
+	int			nrunning;
+	int			nmsgs;
+
+	while (objstore_num_running < objstore_max_requests &&
+		   !dlist_is_empty(&objstore_pending_list))
+	{
+		objstoreRequest *req = dlist_container(objstoreRequest, chain,
+											   dlist_pop_head_node(&objstore_pending_list));
+		__objstoreStartRequest(req);
+	}
+	if (objstore_num_running == 0)
+		return;
+	if (timeout_ms > 0)
+		curl_multi_poll(objstore_curlm, NULL, 0, timeout_ms, NULL);
+	curl_multi_perform(objstore_curlm, &nrunning);
+	while ((msg = curl_multi_info_read(objstore_curlm, &nmsgs)) != NULL)
+	{
+		objstoreRequest *req;
+
+		if (msg->msg != CURLMSG_DONE)
+			continue;
+		curl_easy_getinfo(msg->easy_handle, CURLINFO_PRIVATE, (char **)&req);
+		__objstoreCompleteRequest(req, msg->data.result);
+	}
+}
+
+/*
+ * __objstoreChunkIsInflight
+ */
+static bool
+__objstoreChunkIsInflight(objstoreObject *obj, uint32_t chunk_id)
+{
+	dlist_head *lists[2] = { &objstore_pending_list, &objstore_running_list };
+	dlist_iter	iter;
+
+	for (int i=0; i < 2; i++)
+	{
+		dlist_foreach(iter, lists[i])
+		{
+			objstoreRequest *req = dlist_container(objstoreRequest, chain, iter.cur);
+
+			if (req->obj == obj &&
+				chunk_id >= req->chunk_base &&
+				chunk_id <  req->chunk_base + req->chunk_count)
+				return true;
+		}
+	}
+	return false;
+}
+
+/*
+ * __objstoreQueueChunks
+ *
+ * It enqueues ranged GET requests for the uncached chunks, and touches the
+ * cached ones. It returns true if all the chunks are already cached.
+ */
+static bool
+__objstoreQueueChunks(objstoreObject *obj, uint32_t chunk_head, uint32_t chunk_tail)
+{
+	uint32_t	now = (uint32_t)time(NULL);
+	uint32_t	i = chunk_head;
+	bool		all_cached = true;
+
+	while (i < chunk_tail)
+	{
+		objstoreRequest *req;
+		uint32_t	count = 0;
+
+		if (obj->map->chunks[i] != 0)
+		{
+			/* LRU of the hot chunks; does not dirty the page too frequently */
+			if (obj->map->chunks[i] + 10 < now)
+				obj->map->chunks[i] = now;
+			i++;
+			continue;
+		}
+		all_cached = false;
+		if (__objstoreChunkIsInflight(obj, i))
+		{
+			i++;
+			continue;
+		}
+		while (i + count < chunk_tail &&
+			   count < OBJSTORE_MAX_GET_CHUNKS &&
+			   obj->map->chunks[i + count] == 0 &&
+			   !__objstoreChunkIsInflight(obj, i + count))
+			count++;
+		req = calloc(1, sizeof(objstoreRequest));
+		if (!req)
+			elog(ERROR, "out of memory");
+		req->obj = obj;
+		req->chunk_base = i;
+		req->chunk_count = count;
+		req->f_pos = (off_t)i * OBJSTORE_CHUNK_SIZE;
+		req->f_tail = Min((off_t)(i + count) * OBJSTORE_CHUNK_SIZE,
+						  (off_t)obj->object_size);
+		dlist_push_tail(&objstore_pending_list, &req->chain);
+		i += count;
+	}
+	return all_cached;
+}
+
+/*
+ * __objstoreEvictCache
+ *
+ * It punches holes on the least recently used chunks, if the local cache
+ * consumes more than arrow_fdw.object_cache_size.
+ */
+typedef struct
+{
+	uint32_t	atime;
+	int			file_index;
+	uint32_t	chunk_id;
+} objstoreEvictItem;
+
+static int
+__objstoreEvictItemComp(const void *__a, const void *__b)
+{
+	const objstoreEvictItem *a = __a;
+	const objstoreEvictItem *b = __b;
+
+	if (a->atime < b->atime)
+		return -1;
+	if (a->atime > b->atime)
+		return 1;
+	return 0;
+}
+
+static void
+__objstoreEvictCache(void)
+{
+	size_t		limit = (size_t)objstore_cache_size_mb << 20;
+	size_t		usage = 0;
+	uint32_t	now = (uint32_t)time(NULL);
+	List	   *names = NIL;
+	objstoreEvictItem *items = NULL;
+	size_t		nitems = 0;
+	size_t		nrooms = 0;
+	struct dirent *dent;
+	DIR		   *dir;
+	ListCell   *lc;
+	int			index = 0;
+
+	dir = AllocateDir(objstore_cache_dir);
+	if (!dir)
+		return;
+	while ((dent = ReadDir(dir, objstore_cache_dir)) != NULL)
+	{
+		char		path[MAXPGPATH];
+		struct stat	stat_buf;
+		int			len = strlen(dent->d_name);
+
+		if (len <= 4 || strcmp(dent->d_name + len - 4, ".map") != 0)
+			continue;
+		snprintf(path, sizeof(path), "%s/%.*s",
+				 objstore_cache_dir, len - 4, dent->d_name);
+		if (stat(path, &stat_buf) != 0)
+			continue;
+		usage += (size_t)stat_buf.st_blocks * 512;
+		names = lappend(names, pstrdup(path));
+	}
+	FreeDir(dir);
+	if (usage <= limit)
+		return;
+
+	/* collect the candidate chunks */
+	foreach (lc, names)
+	{
+		const char *path = lfirst(lc);
+		char		map_path[MAXPGPATH];
+		objstoreMapHead *map;
+		struct stat	stat_buf;
+		int			fdesc;
+
+		snprintf(map_path, sizeof(map_path), "%s.map", path);
+		fdesc = open(map_path, O_RDONLY | PG_BINARY);
+		if (fdesc < 0)
+			continue;
+		if (fstat(fdesc, &stat_buf) == 0 &&
+			stat_buf.st_size >= offsetof(objstoreMapHead, chunks))
+		{
+			map = mmap(NULL, stat_buf.st_size, PROT_READ, MAP_SHARED, fdesc, 0);
+			if (map != MAP_FAILED)
+			{
+				uint32_t	nchunks = ((stat_buf.st_size -
+										offsetof(objstoreMapHead, chunks))
+									   / sizeof(uint32_t));
+				for (uint32_t i=0; i < nchunks; i++)
+				{
+					uint32_t	atime = map->chunks[i];
+
+					if (atime == 0 || atime + OBJSTORE_EVICT_MIN_AGE > now)
+						continue;
+					if (nitems >= nrooms)
+					{
+						nrooms = Max(2 * nrooms, 1024);
+						items = (items
+								 ? repalloc_huge(items, sizeof(objstoreEvictItem) * nrooms)
+								 : palloc_extended(sizeof(objstoreEvictItem) * nrooms,
+												   MCXT_ALLOC_HUGE));
+					}
+					items[nitems].atime = atime;
+					items[nitems].file_index = index;
+					items[nitems].chunk_id = i;
+					nitems++;
+				}
+				munmap(map, stat_buf.st_size);
+			}
+		}
+		close(fdesc);
+		index++;
+	}
+	if (nitems == 0)
+		return;
+	qsort(items, nitems, sizeof(objstoreEvictItem), __objstoreEvictItemComp);
+
+	/* punch holes until 90% of the limit */
+	for (size_t k=0; k < nitems && usage > limit - limit / 10; k++)
+	{
+		const char *path = list_nth(names, items[k].file_index);
+		char		map_path[MAXPGPATH];
+		objstoreMapHead *map;
+		struct stat	stat_buf;
+		int			map_fdesc;
+		int			data_fdesc;
+		uint32_t	chunk_id = items[k].chunk_id;
+
+		snprintf(map_path, sizeof(map_path), "%s.map", path);
+		map_fdesc = open(map_path, O_RDWR | PG_BINARY);
+		data_fdesc = open(path, O_RDWR | PG_BINARY);
+		if (map_fdesc >= 0 && data_fdesc >= 0 &&
+			fstat(map_fdesc, &stat_buf) == 0 &&
+			offsetof(objstoreMapHead, chunks[chunk_id + 1]) <= stat_buf.st_size)
+		{
+			map = mmap(NULL, stat_buf.st_size, PROT_READ | PROT_WRITE,
+					   MAP_SHARED, map_fdesc, 0);
+			if (map != MAP_FAILED)
+			{
+				/* somebody may touch it after the scan */
+				if (map->chunks[chunk_id] == items[k].atime)
+				{
+					/* invalidate the chunk prior to punching hole */
+					map->chunks[chunk_id] = 0;
+					pg_memory_barrier();
+					if (fallocate(data_fdesc,
+								  FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE,
+								  (off_t)chunk_id * OBJSTORE_CHUNK_SIZE,
+								  OBJSTORE_CHUNK_SIZE) == 0)
+						usage -= Min(usage, OBJSTORE_CHUNK_SIZE);
+				}
+				munmap(map, stat_buf.st_size);
+			}
+		}
+		if (map_fdesc >= 0)
+			close(map_fdesc);
+		if (data_fdesc >= 0)
+			close(data_fdesc);
+	}
+	pfree(items);
+}
+#endif	/* USE_LIBCURL */
+
+/*
+ * pgstromObjStoreIsURL
+ */
+bool
+pgstromObjStoreIsURL(const char *pathname)
+{
+	return (strncmp(pathname, OBJSTORE_URL_PREFIX,
+					strlen(OBJSTORE_URL_PREFIX)) == 0);
+}
+
+/*
+ * pgstromObjStoreOpenObject
+ *
+ * It returns the pathname of the local cache file of the object.
+ */
+const char *
+pgstromObjStoreOpenObject(const char *url)
+{
+#ifdef USE_LIBCURL
+	objstoreObject *obj;
+	char		cache_path[MAXPGPATH];
+	const char *bucket;
+	const char *key;
+	bool		found;
+
+	if (!pgstromObjStoreIsURL(url))
+		elog(ERROR, "objstore: '%s' is not an object storage URL", url);
+	bucket = url + strlen(OBJSTORE_URL_PREFIX);
+	key = strchr(bucket, '/');
+	if (!key || key == bucket || key[1] == '\0')
+		elog(ERROR, "objstore: URL must be '%sBUCKET/KEY' form: '%s'",
+			 OBJSTORE_URL_PREFIX, url);
+	snprintf(cache_path, sizeof(cache_path), "%s/%016lx.data",
+			 objstore_cache_dir,
+			 (uint64_t)hash_bytes_extended((const unsigned char *)url,
+										   strlen(url), 0));
+	if (!objstore_htab)
+	{
+		HASHCTL		hctl;
+
+		memset(&hctl, 0, sizeof(HASHCTL));
+		hctl.keysize = MAXPGPATH;
+		hctl.entrysize = sizeof(objstoreObject);
+		hctl.hcxt = CacheMemoryContext;
+		objstore_htab = hash_create("Object Storage Cache", 64, &hctl,
+									HASH_ELEM | HASH_STRINGS | HASH_CONTEXT);
+	}
+	obj = hash_search(objstore_htab, cache_path, HASH_ENTER, &found);
+	if (!found)
+	{
+		obj->url = MemoryContextStrdup(CacheMemoryContext, url);
+		obj->bucket = MemoryContextStrdup(CacheMemoryContext, bucket);
+		obj->bucket[key - bucket] = '\0';
+		obj->key = MemoryContextStrdup(CacheMemoryContext, key + 1);
+		obj->data_fdesc = -1;
+		obj->map_fdesc = -1;
+		obj->map = NULL;
+		obj->validated_at = 0;
+	}
+	if (!obj->map || time(NULL) >= obj->validated_at + OBJSTORE_REVALIDATE_SECS)
+	{
+		PG_TRY();
+		{
+			__objstoreMapObject(obj);
+		}
+		PG_CATCH();
+		{
+			if (!obj->map)
+				hash_search(objstore_htab, cache_path, HASH_REMOVE, NULL);
+			PG_RE_THROW();
+		}
+		PG_END_TRY();
+	}
+	return obj->cache_path;
+#else
+	elog(ERROR, "objstore: PG-Strom was built without libcurl, so '%s' is not available", url);
+#endif
+}
+
+/*
+ * pgstromObjStoreIsCacheFile
+ */
+bool
+pgstromObjStoreIsCacheFile(const char *filename)
+{
+#ifdef USE_LIBCURL
+	return (__objstoreLookupObject(filename) != NULL);
+#else
+	return false;
+#endif
+}
+
+/*
+ * pgstromObjStoreFetchRanges
+ *
+ * It ensures the byte ranges of the local cache file are fetched from the
+ * object storage, if 'wait' is true. Elsewhere, it just enqueues the ranged
+ * GET requests (prefetch), then return immediately.
+ */
+void
+pgstromObjStoreFetchRanges(const char *filename,
+						   int nranges,
+						   const off_t *offsets,
+						   const size_t *lengths,
+						   bool wait)
+{
+#ifdef USE_LIBCURL
+	objstoreObject *obj = __objstoreLookupObject(filename);
+	int			num_errors;
+
+	if (!obj || !obj->map)
+		elog(ERROR, "objstore: '%s' is not a cache file of object storage", filename);
+	__objstoreInitMultiHandle();
+	num_errors = obj->num_errors;
+	for (;;)
+	{
+		bool	all_cached = true;
+
+		for (int i=0; i < nranges; i++)
+		{
+			off_t	head = Max(offsets[i], 0);
+			off_t	tail = Min(offsets[i] + lengths[i], obj->object_size);
+
+			if (head >= tail)
+				continue;
+			if (!__objstoreQueueChunks(obj,
+									   head / OBJSTORE_CHUNK_SIZE,
+									   (tail + OBJSTORE_CHUNK_SIZE - 1) / OBJSTORE_CHUNK_SIZE))
+				all_cached = false;
+		}
+		if (all_cached || !wait)
+			break;
+		if (obj->num_errors != num_errors)
+			elog(ERROR, "objstore: failed on ranged GET of '%s': %s",
+				 obj->url, obj->last_error);
+		CHECK_FOR_INTERRUPTS();
+		__objstoreProgress(100);
+	}
+	__objstoreProgress(0);
+	if (objstore_fetched_bytes >= (size_t)Max(objstore_cache_size_mb / 16, 64) << 20)
+	{
+		objstore_fetched_bytes = 0;
+		__objstoreEvictCache();
+	}
+#else
+	elog(ERROR, "objstore: PG-Strom was built without libcurl");
+#endif
+}
+
+/*
+ * pgstrom_init_objstore
+ */
+void
+pgstrom_init_objstore(void)
+{
+	DefineCustomStringVariable("arrow_fdw.object_cache_dir",
+							   "Directory of the local cache of object storage",
+							   NULL,
+							   &objstore_cache_dir,
+							   "pg_strom_object_cache",
+							   PGC_SUSET,
+							   GUC_NOT_IN_SAMPLE,
+							   NULL, NULL, NULL);
+	DefineCustomIntVariable("arrow_fdw.object_cache_size",
+							"Size limit of the local cache of object storage",
+							NULL,
+							&objstore_cache_size_mb,
+							100 * 1024,		/* 100GB */
+							1024,			/* 1GB */
+							INT_MAX,
+							PGC_SUSET,
+							GUC_NOT_IN_SAMPLE | GUC_UNIT_MB,
+							NULL, NULL, NULL);
+	DefineCustomStringVariable("arrow_fdw.s3_endpoint",
+							   "Endpoint URL of S3-compatible object storage",
+							   "Empty means AWS S3 of the arrow_fdw.s3_region",
+							   &objstore_s3_endpoint,
+							   "",
+							   PGC_SUSET,
+							   GUC_NOT_IN_SAMPLE,
+							   NULL, NULL, NULL);
+	DefineCustomStringVariable("arrow_fdw.s3_region",
+							   "Region of S3-compatible object storage",
+							   NULL,
+							   &objstore_s3_region,
+							   "us-east-1",
+							   PGC_SUSET,
+							   GUC_NOT_IN_SAMPLE,
+							   NULL, NULL, NULL);
+	DefineCustomIntVariable("arrow_fdw.object_max_requests",
+							"Max number of concurrent ranged GET requests per backend",
+							NULL,
+							&objstore_max_requests,
+							16,
+							1,
+							256,
+							PGC_USERSET,
+							GUC_NOT_IN_SAMPLE,
+							NULL, NULL, NULL);
+#ifdef USE_LIBCURL
+	/* must be called prior to any threads */
+	if (curl_global_init(CURL_GLOBAL_DEFAULT) != CURLE_OK)
+		elog(ERROR, "failed on curl_global_init");
+#endif
+}
@@ -0,0 +1,1705 @@
+/*
+ * parquet_read.c
+ *
+ * Routines to read Apache Parquet files on behalf of arrow_fdw.
+ * ----
+ * Copyright 2011-2023 (C) KaiGai Kohei <kaigai@kaigai.gr.jp>
+ * Copyright 2014-2023 (C) PG-Strom Developers Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the PostgreSQL License.
+ */
+#include "pg_strom.h"
+#include "arrow_ipc.h"
+#ifdef USE_LZ4
+#include <lz4.h>
+#endif
+#ifdef USE_ZSTD
+#include <zstd.h>
+#endif
+
+#define PARQUET_MAGIC					"PAR1"
+#define PARQUET_MAGIC_LEN				4
+
+/* Type */
+#define PARQUET_TYPE__BOOLEAN			0
+#define PARQUET_TYPE__INT32				1
+#define PARQUET_TYPE__INT64				2
+#define PARQUET_TYPE__INT96				3
+#define PARQUET_TYPE__FLOAT				4
+#define PARQUET_TYPE__DOUBLE			5
+#define PARQUET_TYPE__BYTE_ARRAY		6
+#define PARQUET_TYPE__FIXED_LEN_BYTE_ARRAY 7
+
+/* ConvertedType */
+#define PARQUET_CONVERTED__UTF8			0
+#define PARQUET_CONVERTED__ENUM			4
+#define PARQUET_CONVERTED__DECIMAL		5
+#define PARQUET_CONVERTED__DATE			6
+#define PARQUET_CONVERTED__TIME_MILLIS	7
+#define PARQUET_CONVERTED__TIME_MICROS	8
+#define PARQUET_CONVERTED__TIMESTAMP_MILLIS	9
+#define PARQUET_CONVERTED__TIMESTAMP_MICROS	10
+#define PARQUET_CONVERTED__UINT_8		11
+#define PARQUET_CONVERTED__UINT_16		12
+#define PARQUET_CONVERTED__UINT_32		13
+#define PARQUET_CONVERTED__UINT_64		14
+#define PARQUET_CONVERTED__INT_8		15
+#define PARQUET_CONVERTED__INT_16		16
+#define PARQUET_CONVERTED__INT_32		17
+#define PARQUET_CONVERTED__INT_64		18
+#define PARQUET_CONVERTED__JSON			19
+
+/* LogicalType (field-id of the union) */
+#define PARQUET_LOGICAL__STRING			1
+#define PARQUET_LOGICAL__ENUM			4
+#define PARQUET_LOGICAL__DECIMAL		5
+#define PARQUET_LOGICAL__DATE			6
+#define PARQUET_LOGICAL__TIME			7
+#define PARQUET_LOGICAL__TIMESTAMP		8
+#define PARQUET_LOGICAL__INTEGER		10
+#define PARQUET_LOGICAL__JSON			12
+
+/* TimeUnit (field-id of the union) */
+#define PARQUET_TIMEUNIT__MILLIS		1
+#define PARQUET_TIMEUNIT__MICROS		2
+#define PARQUET_TIMEUNIT__NANOS			3
+
+/* FieldRepetitionType */
+#define PARQUET_REPETITION__REQUIRED	0
+#define PARQUET_REPETITION__OPTIONAL	1
+#define PARQUET_REPETITION__REPEATED	2
+
+/* CompressionCodec */
+#define PARQUET_CODEC__UNCOMPRESSED		0
+#define PARQUET_CODEC__SNAPPY			1
+#define PARQUET_CODEC__GZIP				2
+#define PARQUET_CODEC__LZO				3
+#define PARQUET_CODEC__BROTLI			4
+#define PARQUET_CODEC__LZ4				5
+#define PARQUET_CODEC__ZSTD				6
+#define PARQUET_CODEC__LZ4_RAW			7
+
+/* Encoding */
+#define PARQUET_ENCODING__PLAIN			0
+#define PARQUET_ENCODING__PLAIN_DICTIONARY 2
+#define PARQUET_ENCODING__RLE			3
+#define PARQUET_ENCODING__RLE_DICTIONARY 8
+
+/* PageType */
+#define PARQUET_PAGE__DATA_PAGE			0
+#define PARQUET_PAGE__INDEX_PAGE		1
+#define PARQUET_PAGE__DICTIONARY_PAGE	2
+#define PARQUET_PAGE__DATA_PAGE_V2		3
+
+/* ----------------------------------------------------------------
+ *
+ * Routines to parse Thrift compact protocol
+ *
+ * ----------------------------------------------------------------
+ */
+#define THRIFT__STOP			0
+#define THRIFT__BOOL_TRUE		1
+#define THRIFT__BOOL_FALSE		2
+#define THRIFT__BYTE			3
+#define THRIFT__I16				4
+#define THRIFT__I32				5
+#define THRIFT__I64				6
+#define THRIFT__DOUBLE			7
+#define THRIFT__BINARY			8
+#define THRIFT__LIST			9
+#define THRIFT__SET				10
+#define THRIFT__MAP				11
+#define THRIFT__STRUCT			12
+
+#define THRIFT_MAX_DEPTH		32
+
+typedef struct
+{
+	const char *pos;
+	const char *end;
+	const char *filename;
+} thriftReader;
+
+static uint8_t
+__thriftReadByte(thriftReader *tr)
+{
+	if (tr->pos >= tr->end)
+		elog(ERROR, "parquet: metadata is truncated at '%s'", tr->filename);
+	return (uint8_t)*tr->pos++;
+}
+
+static uint64_t
+__thriftReadVarint(thriftReader *tr)
+{
+	uint64_t	value = 0;
+	int			shift = 0;
+	uint8_t		c;
+
+	do {
+		if (shift >= 64)
+			elog(ERROR, "parquet: broken varint at '%s'", tr->filename);
+		c = __thriftReadByte(tr);
+		value |= ((uint64_t)(c & 0x7f) << shift);
+		shift += 7;
+	} while ((c & 0x80) != 0);
+
+	return value;
+}
+
+static int64_t
+__thriftReadZigzag(thriftReader *tr)
+{
+	uint64_t	value = __thriftReadVarint(tr);
+
+	return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+}
+
+static const char *
+__thriftReadBinary(thriftReader *tr, int32_t *p_len)
+{
+	uint64_t	len = __thriftReadVarint(tr);
+	const char *ptr = tr->pos;
+
+	if (len > (uint64_t)(tr->end - tr->pos))
+		elog(ERROR, "parquet: metadata is truncated at '%s'", tr->filename);
+	tr->pos += len;
+	*p_len = len;
+	return ptr;
+}
+
+static char *
+__thriftReadString(thriftReader *tr)
+{
+	const char *ptr;
+	int32_t		len;
+
+	ptr = __thriftReadBinary(tr, &len);
+	return pnstrdup(ptr, len);
+}
+
+/*
+ * __thriftReadFieldHeader - returns false on the STOP field
+ */
+static bool
+__thriftReadFieldHeader(thriftReader *tr, int16_t *p_fid, int *p_ftype)
+{
+	uint8_t		c = __thriftReadByte(tr);
+
+	if (c == THRIFT__STOP)
+		return false;
+	if ((c >> 4) == 0)
+		*p_fid = (int16_t)__thriftReadZigzag(tr);
+	else
+		*p_fid += (c >> 4);
+	*p_ftype = (c & 0x0f);
+	return true;
+}
+
+static int32_t
+__thriftReadListHeader(thriftReader *tr, int *p_etype)
+{
+	uint8_t		c = __thriftReadByte(tr);
+	uint64_t	nitems = (c >> 4);
+
+	if (nitems == 15)
+		nitems = __thriftReadVarint(tr);
+	if (nitems > (uint64_t)(tr->end - tr->pos))
+		elog(ERROR, "parquet: metadata is truncated at '%s'", tr->filename);
+	*p_etype = (c & 0x0f);
+	return (int32_t)nitems;
+}
+
+static void
+__thriftSkipValue(thriftReader *tr, int ftype, bool in_collection, int depth)
+{
+	int32_t		len;
+	int			etype;
+
+	if (depth > THRIFT_MAX_DEPTH)
+		elog(ERROR, "parquet: metadata is too deep at '%s'", tr->filename);
+	switch (ftype)
+	{
+		case THRIFT__BOOL_TRUE:
+		case THRIFT__BOOL_FALSE:
+			/* bool elements of list/set/map have its own byte */
+			if (in_collection)
+				__thriftReadByte(tr);
+			break;
+		case THRIFT__BYTE:
+			__thriftReadByte(tr);
+			break;
+		case THRIFT__I16:
+		case THRIFT__I32:
+		case THRIFT__I64:
+			__thriftReadVarint(tr);
+			break;
+		case THRIFT__DOUBLE:
+			if (tr->end - tr->pos < sizeof(double))
+				elog(ERROR, "parquet: metadata is truncated at '%s'", tr->filename);
+			tr->pos += sizeof(double);
+			break;
+		case THRIFT__BINARY:
+			__thriftReadBinary(tr, &len);
+			break;
+		case THRIFT__LIST:
+		case THRIFT__SET:
+			len = __thriftReadListHeader(tr, &etype);
+			for (int i=0; i < len; i++)
+				__thriftSkipValue(tr, etype, true, depth+1);
+			break;
+		case THRIFT__MAP:
+			len = __thriftReadVarint(tr);
+			if (len > 0)
+			{
+				uint8_t		kvtype = __thriftReadByte(tr);
+
+				for (int i=0; i < len; i++)
+				{
+					__thriftSkipValue(tr, (kvtype >> 4), true, depth+1);
+					__thriftSkipValue(tr, (kvtype & 0x0f), true, depth+1);
+				}
+			}
+			break;
+		case THRIFT__STRUCT:
+			{
+				int16_t		fid = 0;
+
+				while (__thriftReadFieldHeader(tr, &fid, &etype))
+					__thriftSkipValue(tr, etype, false, depth+1);
+			}
+			break;
+		default:
+			elog(ERROR, "parquet: unknown thrift type (%d) at '%s'",
+				 ftype, tr->filename);
+	}
+}
+
+/* ----------------------------------------------------------------
+ *
+ * Routines to parse FileMetaData
+ *
+ * ----------------------------------------------------------------
+ */
+typedef struct
+{
+	int32_t		type;			/* physical type, or -1 if group */
+	int32_t		type_length;
+	int32_t		repetition;
+	char	   *name;
+	int32_t		num_children;
+	int32_t		converted_type;	/* -1, if not set */
+	int32_t		scale;
+	int32_t		precision;
+	int32_t		logical_type;	/* field-id of LogicalType, or 0 */
+	int32_t		logical_bitwidth;
+	bool		logical_signed;
+	bool		logical_utc;
+	int32_t		logical_unit;	/* PARQUET_TIMEUNIT__* */
+} pqSchemaElement;
+
+static int32_t
+__pqReadTimeUnit(thriftReader *tr)
+{
+	int16_t		fid = 0;
+	int			ftype;
+	int32_t		unit = 0;
+
+	while (__thriftReadFieldHeader(tr, &fid, &ftype))
+	{
+		unit = fid;
+		__thriftSkipValue(tr, ftype, false, 1);
+	}
+	return unit;
+}
+
+static void
+__pqReadLogicalType(thriftReader *tr, pqSchemaElement *elem)
+{
+	int16_t		fid = 0;
+	int			ftype;
+
+	while (__thriftReadFieldHeader(tr, &fid, &ftype))
+	{
+		int16_t		__fid = 0;
+		int			__ftype;
+
+		elem->logical_type = fid;
+		if (ftype != THRIFT__STRUCT)
+		{
+			__thriftSkipValue(tr, ftype, false, 1);
+			continue;
+		}
+		while (__thriftReadFieldHeader(tr, &__fid, &__ftype))
+		{
+			switch (fid)
+			{
+				case PARQUET_LOGICAL__DECIMAL:
+					if (__fid == 1 && __ftype == THRIFT__I32)
+						elem->scale = __thriftReadZigzag(tr);
+					else if (__fid == 2 && __ftype == THRIFT__I32)
+						elem->precision = __thriftReadZigzag(tr);
+					else
+						__thriftSkipValue(tr, __ftype, false, 2);
+					break;
+				case PARQUET_LOGICAL__TIME:
+				case PARQUET_LOGICAL__TIMESTAMP:
+					if (__fid == 1)
+						elem->logical_utc = (__ftype == THRIFT__BOOL_TRUE);
+					else if (__fid == 2 && __ftype == THRIFT__STRUCT)
+						elem->logical_unit = __pqReadTimeUnit(tr);
+					else
+						__thriftSkipValue(tr, __ftype, false, 2);
+					break;
+				case PARQUET_LOGICAL__INTEGER:
+					if (__fid == 1 && __ftype == THRIFT__BYTE)
+						elem->logical_bitwidth = (int8_t)__thriftReadByte(tr);
+					else if (__fid == 2)
+						elem->logical_signed = (__ftype == THRIFT__BOOL_TRUE);
+					else
+						__thriftSkipValue(tr, __ftype, false, 2);
+					break;
+				default:
+					__thriftSkipValue(tr, __ftype, false, 2);
+					break;
+			}
+		}
+	}
+}
+
+static void
+__pqReadSchemaElement(thriftReader *tr, pqSchemaElement *elem)
+{
+	int16_t		fid = 0;
+	int			ftype;
+
+	memset(elem, 0, sizeof(pqSchemaElement));
+	elem->type = -1;
+	elem->converted_type = -1;
+	while (__thriftReadFieldHeader(tr, &fid, &ftype))
+	{
+		if (fid == 1 && ftype == THRIFT__I32)
+			elem->type = __thriftReadZigzag(tr);
+		else if (fid == 2 && ftype == THRIFT__I32)
+			elem->type_length = __thriftReadZigzag(tr);
+		else if (fid == 3 && ftype == THRIFT__I32)
+			elem->repetition = __thriftReadZigzag(tr);
+		else if (fid == 4 && ftype == THRIFT__BINARY)
+			elem->name = __thriftReadString(tr);
+		else if (fid == 5 && ftype == THRIFT__I32)
+			elem->num_children = __thriftReadZigzag(tr);
+		else if (fid == 6 && ftype == THRIFT__I32)
+			elem->converted_type = __thriftReadZigzag(tr);
+		else if (fid == 7 && ftype == THRIFT__I32)
+			elem->scale = __thriftReadZigzag(tr);
+		else if (fid == 8 && ftype == THRIFT__I32)
+			elem->precision = __thriftReadZigzag(tr);
+		else if (fid == 10 && ftype == THRIFT__STRUCT)
+			__pqReadLogicalType(tr, elem);
+		else
+			__thriftSkipValue(tr, ftype, false, 1);
+	}
+}
+
+static void
+__pqReadStatistics(thriftReader *tr, ParquetColumnChunk *pq_chunk)
+{
+	int16_t		fid = 0;
+	int			ftype;
+	const char *min_value = NULL, *max_value = NULL;	/* deprecated */
+	int32_t		min_len = 0, max_len = 0;
+
+	while (__thriftReadFieldHeader(tr, &fid, &ftype))
+	{
+		if (fid == 1 && ftype == THRIFT__BINARY)
+			max_value = __thriftReadBinary(tr, &max_len);
+		else if (fid == 2 && ftype == THRIFT__BINARY)
+			min_value = __thriftReadBinary(tr, &min_len);
+		else if (fid == 3 && ftype == THRIFT__I64)
+			pq_chunk->null_count = __thriftReadZigzag(tr);
+		else if (fid == 5 && ftype == THRIFT__BINARY)
+			pq_chunk->max_value = __thriftReadBinary(tr, &pq_chunk->max_len);
+		else if (fid == 6 && ftype == THRIFT__BINARY)
+			pq_chunk->min_value = __thriftReadBinary(tr, &pq_chunk->min_len);
+		else
+			__thriftSkipValue(tr, ftype, false, 1);
+	}
+	/*
+	 * The deprecated min/max are sorted as signed values, so they are
+	 * valid only for the signed integer types; see __pqSetupFieldStats
+	 */
+	if (!pq_chunk->min_value || !pq_chunk->max_value)
+	{
+		pq_chunk->min_value = min_value;
+		pq_chunk->min_len   = min_len;
+		pq_chunk->max_value = max_value;
+		pq_chunk->max_len   = max_len;
+	}
+}
+
+static void
+__pqReadColumnMetaData(thriftReader *tr, ParquetColumnChunk *pq_chunk)
+{
+	int16_t		fid = 0;
+	int			ftype;
+	int64_t		data_page_offset = -1;
+	int64_t		dictionary_page_offset = -1;
+
+	while (__thriftReadFieldHeader(tr, &fid, &ftype))
+	{
+		if (fid == 1 && ftype == THRIFT__I32)
+			pq_chunk->physical_type = __thriftReadZigzag(tr);
+		else if (fid == 4 && ftype == THRIFT__I32)
+			pq_chunk->codec = __thriftReadZigzag(tr);
+		else if (fid == 5 && ftype == THRIFT__I64)
+			pq_chunk->num_values = __thriftReadZigzag(tr);
+		else if (fid == 7 && ftype == THRIFT__I64)
+			pq_chunk->chunk_length = __thriftReadZigzag(tr);
+		else if (fid == 9 && ftype == THRIFT__I64)
+			data_page_offset = __thriftReadZigzag(tr);
+		else if (fid == 11 && ftype == THRIFT__I64)
+			dictionary_page_offset = __thriftReadZigzag(tr);
+		else if (fid == 12 && ftype == THRIFT__STRUCT)
+			__pqReadStatistics(tr, pq_chunk);
+		else
+			__thriftSkipValue(tr, ftype, false, 1);
+	}
+	if (data_page_offset < 0)
+		elog(ERROR, "parquet: ColumnMetaData has no data_page_offset at '%s'",
+			 tr->filename);
+	/* the column chunk begins from the dictionary page, if any */
+	if (dictionary_page_offset > 0 &&
+		dictionary_page_offset < data_page_offset)
+		pq_chunk->chunk_offset = dictionary_page_offset;
+	else
+		pq_chunk->chunk_offset = data_page_offset;
+}
+
+static void
+__pqReadColumnChunk(thriftReader *tr, ParquetColumnChunk *pq_chunk)
+{
+	int16_t		fid = 0;
+	int			ftype;
+	bool		has_meta_data = false;
+
+	memset(pq_chunk, 0, sizeof(ParquetColumnChunk));
+	pq_chunk->null_count = -1;
+	while (__thriftReadFieldHeader(tr, &fid, &ftype))
+	{
+		if (fid == 1 && ftype == THRIFT__BINARY)
+			elog(ERROR, "parquet: column chunk in the external file is not supported at '%s'",
+				 tr->filename);
+		else if (fid == 3 && ftype == THRIFT__STRUCT)
+		{
+			__pqReadColumnMetaData(tr, pq_chunk);
+			has_meta_data = true;
+		}
+		else
+			__thriftSkipValue(tr, ftype, false, 1);
+	}
+	if (!has_meta_data)
+		elog(ERROR, "parquet: ColumnChunk has no ColumnMetaData at '%s'",
+			 tr->filename);
+}
+
+static void
+__pqReadRowGroup(thriftReader *tr, ParquetRowGroup *pq_rgroup)
+{
+	int16_t		fid = 0;
+	int			ftype;
+
+	memset(pq_rgroup, 0, sizeof(ParquetRowGroup));
+	while (__thriftReadFieldHeader(tr, &fid, &ftype))
+	{
+		if (fid == 1 && ftype == THRIFT__LIST)
+		{
+			int		etype;
+			int		nitems = __thriftReadListHeader(tr, &etype);
+
+			if (etype != THRIFT__STRUCT)
+				elog(ERROR, "parquet: RowGroup is corrupted at '%s'", tr->filename);
+			pq_rgroup->columns = palloc0(sizeof(ParquetColumnChunk) * Max(nitems,1));
+			pq_rgroup->num_columns = nitems;
+			for (int i=0; i < nitems; i++)
+				__pqReadColumnChunk(tr, &pq_rgroup->columns[i]);
+		}
+		else if (fid == 3 && ftype == THRIFT__I64)
+			pq_rgroup->num_rows = __thriftReadZigzag(tr);
+		else
+			__thriftSkipValue(tr, ftype, false, 1);
+	}
+}
+
+/*
+ * __pqSetupArrowField
+ *
+ * It maps the parquet schema element on the equivalent Arrow field, then
+ * arrow_fdw can handle it as like the fields of Arrow files.
+ */
+static void
+__pqSetupArrowField(ArrowField *field, pqSchemaElement *elem,
+					const char *filename)
+{
+	ArrowType  *t = &field->type;
+	int			ctype = elem->converted_type;
+	int			ltype = elem->logical_type;
+
+	initArrowNode(field, Field);
+	field->name = (elem->name ? elem->name : "");
+	field->_name_len = strlen(field->name);
+	field->nullable = (elem->repetition != PARQUET_REPETITION__REQUIRED);
+
+	if (elem->num_children > 0 || elem->type < 0)
+		elog(ERROR, "parquet: nested field '%s' is not supported at '%s'",
+			 field->name, filename);
+	if (elem->repetition == PARQUET_REPETITION__REPEATED)
+		elog(ERROR, "parquet: repeated field '%s' is not supported at '%s'",
+			 field->name, filename);
+	if (ltype == PARQUET_LOGICAL__DECIMAL || ctype == PARQUET_CONVERTED__DECIMAL)
+	{
+		if (elem->type != PARQUET_TYPE__INT32 &&
+			elem->type != PARQUET_TYPE__INT64 &&
+			(elem->type != PARQUET_TYPE__FIXED_LEN_BYTE_ARRAY ||
+			 elem->type_length <= 0 || elem->type_length > sizeof(int128_t)))
+			elog(ERROR, "parquet: decimal field '%s' has unsupported physical type at '%s'",
+				 field->name, filename);
+		initArrowNode(&t->Decimal, Decimal);
+		t->Decimal.precision = elem->precision;
+		t->Decimal.scale = elem->scale;
+		t->Decimal.bitWidth = 128;
+		return;
+	}
+
+	switch (elem->type)
+	{
+		case PARQUET_TYPE__BOOLEAN:
+			initArrowNode(&t->Bool, Bool);
+			break;
+
+		case PARQUET_TYPE__INT32:
+			if (ltype == PARQUET_LOGICAL__DATE || ctype == PARQUET_CONVERTED__DATE)
+			{
+				initArrowNode(&t->Date, Date);
+				t->Date.unit = ArrowDateUnit__Day;
+			}
+			else if ((ltype == PARQUET_LOGICAL__TIME &&
+					  elem->logical_unit == PARQUET_TIMEUNIT__MILLIS) ||
+					 ctype == PARQUET_CONVERTED__TIME_MILLIS)
+			{
+				initArrowNode(&t->Time, Time);
+				t->Time.unit = ArrowTimeUnit__MilliSecond;
+				t->Time.bitWidth = 32;
+			}
+			else
+			{
+				initArrowNode(&t->Int, Int);
+				t->Int.is_signed = true;
+				t->Int.bitWidth = 32;
+				if (ltype == PARQUET_LOGICAL__INTEGER)
+				{
+					t->Int.bitWidth = elem->logical_bitwidth;
+					t->Int.is_signed = elem->logical_signed;
+				}
+				else if (ctype == PARQUET_CONVERTED__INT_8 ||
+						 ctype == PARQUET_CONVERTED__UINT_8)
+					t->Int.bitWidth = 8;
+				else if (ctype == PARQUET_CONVERTED__INT_16 ||
+						 ctype == PARQUET_CONVERTED__UINT_16)
+					t->Int.bitWidth = 16;
+				if (ctype == PARQUET_CONVERTED__UINT_8 ||
+					ctype == PARQUET_CONVERTED__UINT_16 ||
+					ctype == PARQUET_CONVERTED__UINT_32)
+					t->Int.is_signed = false;
+				if (t->Int.bitWidth != 8 &&
+					t->Int.bitWidth != 16 &&
+					t->Int.bitWidth != 32)
+					elog(ERROR, "parquet: INT32 field '%s' has invalid bitWidth=%d at '%s'",
+						 field->name, t->Int.bitWidth, filename);
+			}
+			break;
+
+		case PARQUET_TYPE__INT64:
+			if (ltype == PARQUET_LOGICAL__TIMESTAMP ||
+				ctype == PARQUET_CONVERTED__TIMESTAMP_MILLIS ||
+				ctype == PARQUET_CONVERTED__TIMESTAMP_MICROS)
+			{
+				initArrowNode(&t->Timestamp, Timestamp);
+				if (ltype == PARQUET_LOGICAL__TIMESTAMP)
+				{
+					t->Timestamp.unit =
+						(elem->logical_unit == PARQUET_TIMEUNIT__MILLIS
+						 ? ArrowTimeUnit__MilliSecond :
+						 elem->logical_unit == PARQUET_TIMEUNIT__NANOS
+						 ? ArrowTimeUnit__NanoSecond
+						 : ArrowTimeUnit__MicroSecond);
+					if (elem->logical_utc)
+					{
+						t->Timestamp.timezone = "UTC";
+						t->Timestamp._timezone_len = 3;
+					}
+				}
+				else
+				{
+					t->Timestamp.unit =
+						(ctype == PARQUET_CONVERTED__TIMESTAMP_MILLIS
+						 ? ArrowTimeUnit__MilliSecond
+						 : ArrowTimeUnit__MicroSecond);
+					t->Timestamp.timezone = "UTC";
+					t->Timestamp._timezone_len = 3;
+				}
+			}
+			else if (ltype == PARQUET_LOGICAL__TIME ||
+					 ctype == PARQUET_CONVERTED__TIME_MICROS)
+			{
+				initArrowNode(&t->Time, Time);
+				t->Time.unit = (elem->logical_unit == PARQUET_TIMEUNIT__NANOS
+								? ArrowTimeUnit__NanoSecond
+								: ArrowTimeUnit__MicroSecond);
+				t->Time.bitWidth = 64;
+			}
+			else
+			{
+				initArrowNode(&t->Int, Int);
+				t->Int.bitWidth = 64;
+				t->Int.is_signed = (ctype != PARQUET_CONVERTED__UINT_64 &&
+									(ltype != PARQUET_LOGICAL__INTEGER ||
+									 elem->logical_signed));
+			}
+			break;
+
+		case PARQUET_TYPE__FLOAT:
+			initArrowNode(&t->FloatingPoint, FloatingPoint);
+			t->FloatingPoint.precision = ArrowPrecision__Single;
+			break;
+
+		case PARQUET_TYPE__DOUBLE:
+			initArrowNode(&t->FloatingPoint, FloatingPoint);
+			t->FloatingPoint.precision = ArrowPrecision__Double;
+			break;
+
+		case PARQUET_TYPE__BYTE_ARRAY:
+			if (ltype == PARQUET_LOGICAL__STRING ||
+				ltype == PARQUET_LOGICAL__ENUM ||
+				ltype == PARQUET_LOGICAL__JSON ||
+				ctype == PARQUET_CONVERTED__UTF8 ||
+				ctype == PARQUET_CONVERTED__ENUM ||
+				ctype == PARQUET_CONVERTED__JSON)
+				initArrowNode(&t->Utf8, Utf8);
+			else
+				initArrowNode(&t->Binary, Binary);
+			break;
+
+		case PARQUET_TYPE__FIXED_LEN_BYTE_ARRAY:
+			if (elem->type_length <= 0)
+				elog(ERROR, "parquet: field '%s' has invalid type_length=%d at '%s'",
+					 field->name, elem->type_length, filename);
+			initArrowNode(&t->FixedSizeBinary, FixedSizeBinary);
+			t->FixedSizeBinary.byteWidth = elem->type_length;
+			break;
+
+		default:
+			elog(ERROR, "parquet: field '%s' has unsupported physical type (%d) at '%s'",
+				 field->name, elem->type, filename);
+	}
+}
+
+/*
+ * __pqSetupFieldStats
+ *
+ * It translates the min/max statistics of the column chunks into the
+ * 'min_values' and 'max_values' custom-metadata of the Arrow field, in
+ * the same format as pg2arrow writes, so arrow_fdw can skip row-groups
+ * by the same logic with record-batches.
+ */
+static bool
+__pqFetchStatValue(ArrowField *field, const ParquetColumnChunk *pq_chunk,
+				   const char *value, int32_t len, int64_t *p_value)
+{
+	if (!value)
+		return false;
+	if (pq_chunk->physical_type == PARQUET_TYPE__INT32 && len == sizeof(int32_t))
+	{
+		int32_t		ival;
+
+		memcpy(&ival, value, sizeof(int32_t));
+		*p_value = ival;
+		return true;
+	}
+	if (pq_chunk->physical_type == PARQUET_TYPE__INT64 && len == sizeof(int64_t))
+	{
+		int64_t		ival;
+
+		memcpy(&ival, value, sizeof(int64_t));
+		*p_value = ival;
+		return true;
+	}
+	return false;
+}
+
+static void
+__pqSetupFieldStats(ArrowField *field, ParquetFileInfo *pq_info, int index)
+{
+	StringInfoData min_buf;
+	StringInfoData max_buf;
+	ArrowKeyValue *kv;
+	bool		found = false;
+
+	switch (field->type.node.tag)
+	{
+		case ArrowNodeTag__Int:
+			if (!field->type.Int.is_signed)
+				return;
+			break;
+		case ArrowNodeTag__Date:
+		case ArrowNodeTag__Time:
+		case ArrowNodeTag__Timestamp:
+			break;
+		default:
+			return;		/* not supported */
+	}
+	initStringInfo(&min_buf);
+	initStringInfo(&max_buf);
+	for (int i=0; i < pq_info->num_row_groups; i++)
+	{
+		ParquetColumnChunk *pq_chunk = &pq_info->row_groups[i].columns[index];
+		int64_t		min_value;
+		int64_t		max_value;
+
+		if (i > 0)
+		{
+			appendStringInfoChar(&min_buf, ',');
+			appendStringInfoChar(&max_buf, ',');
+		}
+		if (__pqFetchStatValue(field, pq_chunk,
+							   pq_chunk->min_value,
+							   pq_chunk->min_len, &min_value) &&
+			__pqFetchStatValue(field, pq_chunk,
+							   pq_chunk->max_value,
+							   pq_chunk->max_len, &max_value))
+		{
+			appendStringInfo(&min_buf, "%ld", min_value);
+			appendStringInfo(&max_buf, "%ld", max_value);
+			found = true;
+		}
+		else
+		{
+			appendStringInfoString(&min_buf, "NULL");
+			appendStringInfoString(&max_buf, "NULL");
+		}
+	}
+	if (!found)
+	{
+		pfree(min_buf.data);
+		pfree(max_buf.data);
+		return;
+	}
+	kv = palloc0(sizeof(ArrowKeyValue) * 2);
+	initArrowNode(&kv[0], KeyValue);
+	kv[0].key = "min_values";
+	kv[0]._key_len = strlen(kv[0].key);
+	kv[0].value = min_buf.data;
+	kv[0]._value_len = min_buf.len;
+	initArrowNode(&kv[1], KeyValue);
+	kv[1].key = "max_values";
+	kv[1]._key_len = strlen(kv[1].key);
+	kv[1].value = max_buf.data;
+	kv[1]._value_len = max_buf.len;
+	field->custom_metadata = kv;
+	field->_num_custom_metadata = 2;
+}
+
+static void
+__pqReadFile(int fdesc, char *buf, size_t len, off_t f_pos,
+			 const char *filename)
+{
+	while (len > 0)
+	{
+		ssize_t		sz;
+
+		CHECK_FOR_INTERRUPTS();
+
+		sz = pread(fdesc, buf, len, f_pos);
+		if (sz > 0)
+		{
+			buf   += sz;
+			len   -= sz;
+			f_pos += sz;
+		}
+		else if (sz == 0)
+			elog(ERROR, "parquet: unexpected EOF at '%s'", filename);
+		else if (errno != EINTR)
+			elog(ERROR, "failed on pread('%s'): %m", filename);
+	}
+}
+
+/*
+ * fileIsParquet
+ */
+bool
+fileIsParquet(int fdesc)
+{
+	char		magic[PARQUET_MAGIC_LEN];
+
+	if (pread(fdesc, magic, PARQUET_MAGIC_LEN, 0) != PARQUET_MAGIC_LEN)
+		return false;
+	return (memcmp(magic, PARQUET_MAGIC, PARQUET_MAGIC_LEN) == 0);
+}
+
+/*
+ * readParquetFileDesc
+ */
+void
+readParquetFileDesc(int fdesc, const char *filename, ParquetFileInfo *pq_info)
+{
+	char		tail[sizeof(int32_t) + PARQUET_MAGIC_LEN];
+	int32_t		footer_len;
+	char	   *footer;
+	thriftReader tr;
+	int16_t		fid = 0;
+	int			ftype;
+	pqSchemaElement *elems = NULL;
+	int			num_elems = 0;
+
+	memset(pq_info, 0, sizeof(ParquetFileInfo));
+	pq_info->filename = filename;
+	if (fstat(fdesc, &pq_info->stat_buf) != 0)
+		elog(ERROR, "failed on fstat('%s'): %m", filename);
+	if (pq_info->stat_buf.st_size < 2 * PARQUET_MAGIC_LEN + sizeof(int32_t))
+		elog(ERROR, "parquet: file '%s' is too small", filename);
+	__pqReadFile(fdesc, tail, sizeof(tail),
+				 pq_info->stat_buf.st_size - sizeof(tail), filename);
+	if (memcmp(tail + sizeof(int32_t), PARQUET_MAGIC, PARQUET_MAGIC_LEN) != 0)
+		elog(ERROR, "parquet: file '%s' has no valid footer", filename);
+	memcpy(&footer_len, tail, sizeof(int32_t));
+	if (footer_len <= 0 ||
+		footer_len > pq_info->stat_buf.st_size - sizeof(tail) - PARQUET_MAGIC_LEN)
+		elog(ERROR, "parquet: file '%s' has corrupted footer length (%d)",
+			 filename, footer_len);
+	footer = palloc(footer_len);
+	__pqReadFile(fdesc, footer, footer_len,
+				 pq_info->stat_buf.st_size - sizeof(tail) - footer_len,
+				 filename);
+
+	/* parse FileMetaData */
+	tr.pos = footer;
+	tr.end = footer + footer_len;
+	tr.filename = filename;
+	while (__thriftReadFieldHeader(&tr, &fid, &ftype))
+	{
+		int		etype;
+
+		if (fid == 2 && ftype == THRIFT__LIST)
+		{
+			num_elems = __thriftReadListHeader(&tr, &etype);
+			if (etype != THRIFT__STRUCT)
+				elog(ERROR, "parquet: schema is corrupted at '%s'", filename);
+			elems = palloc0(sizeof(pqSchemaElement) * Max(num_elems, 1));
+			for (int i=0; i < num_elems; i++)
+				__pqReadSchemaElement(&tr, &elems[i]);
+		}
+		else if (fid == 4 && ftype == THRIFT__LIST)
+		{
+			int		nitems = __thriftReadListHeader(&tr, &etype);
+
+			if (etype != THRIFT__STRUCT)
+				elog(ERROR, "parquet: row-groups are corrupted at '%s'", filename);
+			pq_info->row_groups = palloc0(sizeof(ParquetRowGroup) * Max(nitems, 1));
+			pq_info->num_row_groups = nitems;
+			for (int i=0; i < nitems; i++)
+				__pqReadRowGroup(&tr, &pq_info->row_groups[i]);
+		}
+		else
+			__thriftSkipValue(&tr, ftype, false, 0);
+	}
+
+	/* the first element is the root of the schema tree */
+	if (num_elems < 1 || elems[0].num_children != num_elems - 1)
+		elog(ERROR, "parquet: nested schema is not supported at '%s'", filename);
+	initArrowNode(&pq_info->schema, Schema);
+	pq_info->schema.endianness = ArrowEndianness__Little;
+	pq_info->schema._num_fields = num_elems - 1;
+	pq_info->schema.fields = palloc0(sizeof(ArrowField) * Max(num_elems, 1));
+	for (int j=1; j < num_elems; j++)
+		__pqSetupArrowField(&pq_info->schema.fields[j-1], &elems[j], filename);
+
+	/* sanity checks of the column chunks */
+	for (int i=0; i < pq_info->num_row_groups; i++)
+	{
+		ParquetRowGroup *pq_rgroup = &pq_info->row_groups[i];
+
+		if (pq_rgroup->num_columns != pq_info->schema._num_fields)
+			elog(ERROR, "parquet: row-group %d has %d columns, but %d expected at '%s'",
+				 i, pq_rgroup->num_columns, pq_info->schema._num_fields, filename);
+		for (int j=0; j < pq_rgroup->num_columns; j++)
+		{
+			ParquetColumnChunk *pq_chunk = &pq_rgroup->columns[j];
+			pqSchemaElement *elem = &elems[j+1];
+
+			if (pq_chunk->physical_type != elem->type)
+				elog(ERROR, "parquet: column chunk of '%s' has inconsistent type at '%s'",
+					 elem->name, filename);
+			pq_chunk->type_length = elem->type_length;
+			pq_chunk->max_def_level =
+				(elem->repetition == PARQUET_REPETITION__OPTIONAL ? 1 : 0);
+			if (pq_chunk->chunk_offset < 0 ||
+				pq_chunk->chunk_length < 0 ||
+				pq_chunk->chunk_offset + pq_chunk->chunk_length > pq_info->stat_buf.st_size)
+				elog(ERROR, "parquet: column chunk of '%s' is out of the file '%s'",
+					 elem->name, filename);
+		}
+	}
+	for (int j=0; j < pq_info->schema._num_fields; j++)
+		__pqSetupFieldStats(&pq_info->schema.fields[j], pq_info, j);
+	/*
+	 * NOTE: min/max statistics are already translated to the string form,
+	 * so we don't need to keep the binaries on the footer any more.
+	 */
+	for (int i=0; i < pq_info->num_row_groups; i++)
+	{
+		ParquetRowGroup *pq_rgroup = &pq_info->row_groups[i];
+
+		for (int j=0; j < pq_rgroup->num_columns; j++)
+		{
+			pq_rgroup->columns[j].min_value = NULL;
+			pq_rgroup->columns[j].max_value = NULL;
+		}
+	}
+	pfree(footer);
+}
+
+/* ----------------------------------------------------------------
+ *
+ * Routines to decode the column chunk into the Arrow layout
+ *
+ * ----------------------------------------------------------------
+ */
+typedef struct
+{
+	const uint8_t  *pos;
+	const uint8_t  *end;
+	int				bit_width;
+	uint32_t		rle_count;	/* remaining items of the RLE run */
+	uint32_t		rle_value;
+	uint32_t		bp_count;	/* remaining items of the bit-packed run */
+	uint32_t		bp_index;
+	const uint8_t  *bp_base;
+} pqRleDecoder;
+
+typedef struct
+{
+	const ParquetColumnChunk *pq_chunk;
+	const ArrowTypeOptions *attopts;
+	const char	   *filename;
+	int				phys_width;	/* width of the fixed-length value */
+	int64_t			nrows;		/* number of rows in the row-group */
+	int64_t			nloaded;	/* number of rows already decoded */
+	int64_t			null_count;
+	StringInfo		nullmap;
+	StringInfo		values;
+	StringInfo		extra;
+	/* dictionary, if any */
+	bool			has_dict;
+	int32_t			dict_nitems;
+	uint32_t	   *dict_offsets;	/* only BYTE_ARRAY */
+	StringInfoData	dict_buf;
+	/* buffer for decompression */
+	StringInfoData	page_buf;
+} pqDecodeContext;
+
+typedef struct
+{
+	int32_t		type;
+	int32_t		uncompressed_page_size;
+	int32_t		compressed_page_size;
+	int32_t		num_values;
+	int32_t		encoding;
+	int32_t		def_level_encoding;
+	/* DATA_PAGE_V2 */
+	int32_t		def_levels_length;
+	int32_t		rep_levels_length;
+	bool		is_compressed;
+} pqPageHeader;
+
+static void
+__pqReadPageHeader(thriftReader *tr, pqPageHeader *ph)
+{
+	int16_t		fid = 0;
+	int			ftype;
+
+	memset(ph, 0, sizeof(pqPageHeader));
+	ph->type = -1;
+	ph->def_level_encoding = PARQUET_ENCODING__RLE;
+	ph->is_compressed = true;
+	while (__thriftReadFieldHeader(tr, &fid, &ftype))
+	{
+		if (fid == 1 && ftype == THRIFT__I32)
+			ph->type = __thriftReadZigzag(tr);
+		else if (fid == 2 && ftype == THRIFT__I32)
+			ph->uncompressed_page_size = __thriftReadZigzag(tr);
+		else if (fid == 3 && ftype == THRIFT__I32)
+			ph->compressed_page_size = __thriftReadZigzag(tr);
+		else if ((fid == 5 || fid == 7 || fid == 8) && ftype == THRIFT__STRUCT)
+		{
+			int16_t		__fid = 0;
+			int			__ftype;
+
+			/* DataPageHeader, DictionaryPageHeader or DataPageHeaderV2 */
+			while (__thriftReadFieldHeader(tr, &__fid, &__ftype))
+			{
+				if (__fid == 1 && __ftype == THRIFT__I32)
+					ph->num_values = __thriftReadZigzag(tr);
+				else if (fid == 5 && __fid == 2 && __ftype == THRIFT__I32)
+					ph->encoding = __thriftReadZigzag(tr);
+				else if (fid == 5 && __fid == 3 && __ftype == THRIFT__I32)
+					ph->def_level_encoding = __thriftReadZigzag(tr);
+				else if (fid == 7 && __fid == 2 && __ftype == THRIFT__I32)
+					ph->encoding = __thriftReadZigzag(tr);
+				else if (fid == 8 && __fid == 4 && __ftype == THRIFT__I32)
+					ph->encoding = __thriftReadZigzag(tr);
+				else if (fid == 8 && __fid == 5 && __ftype == THRIFT__I32)
+					ph->def_levels_length = __thriftReadZigzag(tr);
+				else if (fid == 8 && __fid == 6 && __ftype == THRIFT__I32)
+					ph->rep_levels_length = __thriftReadZigzag(tr);
+				else if (fid == 8 && __fid == 7)
+					ph->is_compressed = (__ftype == THRIFT__BOOL_TRUE);
+				else
+					__thriftSkipValue(tr, __ftype, false, 2);
+			}
+		}
+		else
+			__thriftSkipValue(tr, ftype, false, 1);
+	}
+}
+
+/*
+ * __pqSnappyDecompress - decoder of the raw snappy format
+ */
+static void
+__pqSnappyDecompress(pqDecodeContext *con,
+					 const uint8_t *src, size_t src_len,
+					 char *dst, size_t dst_len)
+{
+	const uint8_t *end = src + src_len;
+	uint64_t	raw_len = 0;
+	size_t		pos = 0;
+	int			shift = 0;
+
+	/* preamble: uncompressed length in varint */
+	do {
+		if (src >= end || shift >= 35)
+			goto corrupted;
+		raw_len |= ((uint64_t)(*src & 0x7f) << shift);
+		shift += 7;
+	} while ((*src++ & 0x80) != 0);
+	if (raw_len != dst_len)
+		goto corrupted;
+
+	while (src < end)
+	{
+		uint8_t		tag = *src++;
+		size_t		len;
+		size_t		offset;
+
+		if ((tag & 0x03) == 0)
+		{
+			/* literal */
+			len = (tag >> 2);
+			if (len >= 60)
+			{
+				int		nbytes = len - 59;
+
+				if (end - src < nbytes)
+					goto corrupted;
+				len = 0;
+				for (int k=0; k < nbytes; k++)
+					len |= ((size_t)src[k] << (8 * k));
+				src += nbytes;
+			}
+			len++;
+			if (end - src < len || dst_len - pos < len)
+				goto corrupted;
+			memcpy(dst + pos, src, len);
+			src += len;
+			pos += len;
+			continue;
+		}
+		if ((tag & 0x03) == 1)
+		{
+			/* copy with 1-byte offset */
+			if (end - src < 1)
+				goto corrupted;
+			len = ((tag >> 2) & 0x07) + 4;
+			offset = ((size_t)(tag >> 5) << 8) | src[0];
+			src += 1;
+		}
+		else if ((tag & 0x03) == 2)
+		{
+			/* copy with 2-bytes offset */
+			if (end - src < 2)
+				goto corrupted;
+			len = (tag >> 2) + 1;
+			offset = (size_t)src[0] | ((size_t)src[1] << 8);
+			src += 2;
+		}
+		else
+		{
+			/* copy with 4-bytes offset */
+			if (end - src < 4)
+				goto corrupted;
+			len = (tag >> 2) + 1;
+			offset = ((size_t)src[0]         | ((size_t)src[1] <<  8) |
+					  ((size_t)src[2] << 16) | ((size_t)src[3] << 24));
+			src += 4;
+		}
+		if (offset == 0 || offset > pos || dst_len - pos < len)
+			goto corrupted;
+		/* may be overlapped, so copy byte-by-byte */
+		for (size_t k=0; k < len; k++, pos++)
+			dst[pos] = dst[pos - offset];
+	}
+	if (pos == dst_len)
+		return;
+corrupted:
+	elog(ERROR, "parquet: corrupted snappy compressed page at '%s'",
+		 con->filename);
+}
+
+/*
+ * __pqDecompressPage
+ */
+static const char *
+__pqDecompressPage(pqDecodeContext *con,
+				   const char *src, size_t src_len, size_t raw_len)
+{
+	char	   *dst;
+
+	if (con->pq_chunk->codec == PARQUET_CODEC__UNCOMPRESSED)
+		return src;
+	resetStringInfo(&con->page_buf);
+	enlargeStringInfo(&con->page_buf, raw_len + 1);
+	dst = con->page_buf.data;
+	switch (con->pq_chunk->codec)
+	{
+		case PARQUET_CODEC__SNAPPY:
+			__pqSnappyDecompress(con, (const uint8_t *)src, src_len,
+								 dst, raw_len);
+			break;
+#ifdef USE_ZSTD
+		case PARQUET_CODEC__ZSTD:
+			{
+				size_t	rv = ZSTD_decompress(dst, raw_len, src, src_len);
+
+				if (ZSTD_isError(rv))
+					elog(ERROR, "parquet: failed on ZSTD_decompress at '%s': %s",
+						 con->filename, ZSTD_getErrorName(rv));
+				if (rv != raw_len)
+					elog(ERROR, "parquet: ZSTD page is broken at '%s' (expected %zu bytes, but %zu bytes)",
+						 con->filename, raw_len, rv);
+			}
+			break;
+#endif
+#ifdef USE_LZ4
+		case PARQUET_CODEC__LZ4_RAW:
+			{
+				int		rv = LZ4_decompress_safe(src, dst, src_len, raw_len);
+
+				if (rv < 0 || rv != raw_len)
+					elog(ERROR, "parquet: LZ4 page is broken at '%s'",
+						 con->filename);
+			}
+			break;
+#endif
+		default:
+			elog(ERROR, "parquet: compression codec (%s) is not supported at '%s'",
+				 con->pq_chunk->codec == PARQUET_CODEC__GZIP ? "GZIP" :
+				 con->pq_chunk->codec == PARQUET_CODEC__LZO ? "LZO" :
+				 con->pq_chunk->codec == PARQUET_CODEC__BROTLI ? "BROTLI" :
+				 con->pq_chunk->codec == PARQUET_CODEC__LZ4 ? "LZ4" :
+				 con->pq_chunk->codec == PARQUET_CODEC__ZSTD ? "ZSTD" :
+				 con->pq_chunk->codec == PARQUET_CODEC__LZ4_RAW ? "LZ4_RAW" : "???",
+				 con->filename);
+	}
+	con->page_buf.len = raw_len;
+	return dst;
+}
+
+/*
+ * RLE/Bit-packing hybrid decoder
+ */
+static void
+__pqRleInit(pqRleDecoder *rle, const char *pos, size_t len, int bit_width)
+{
+	memset(rle, 0, sizeof(pqRleDecoder));
+	rle->pos = (const uint8_t *)pos;
+	rle->end = (const uint8_t *)pos + len;
+	rle->bit_width = bit_width;
+}
+
+static uint32_t
+__pqRleNext(pqRleDecoder *rle, const char *filename)
+{
+	for (;;)
+	{
+		uint64_t	header = 0;
+		int			shift = 0;
+
+		if (rle->rle_count > 0)
+		{
+			rle->rle_count--;
+			return rle->rle_value;
+		}
+		if (rle->bp_count > 0)
+		{
+			uint64_t	bitpos = (uint64_t)rle->bp_index * rle->bit_width;
+			const uint8_t *p = rle->bp_base + (bitpos >> 3);
+			int			nbytes = ((bitpos & 7) + rle->bit_width + 7) >> 3;
+			uint64_t	word = 0;
+
+			for (int k=0; k < nbytes; k++)
+				word |= ((uint64_t)p[k] << (8 * k));
+			rle->bp_index++;
+			rle->bp_count--;
+			return (uint32_t)((word >> (bitpos & 7)) &
+							  ((1UL << rle->bit_width) - 1));
+		}
+		/* fetch the next run */
+		do {
+			if (rle->pos >= rle->end || shift >= 35)
+				elog(ERROR, "parquet: RLE/bit-packed data is truncated at '%s'",
+					 filename);
+			header |= ((uint64_t)(*rle->pos & 0x7f) << shift);
+			shift += 7;
+		} while ((*rle->pos++ & 0x80) != 0);
+
+		if ((header & 1) != 0)
+		{
+			/* bit-packed run: (header >> 1) groups of 8 values */
+			size_t		length = (header >> 1) * rle->bit_width;
+
+			if (length > rle->end - rle->pos)
+				elog(ERROR, "parquet: bit-packed run is truncated at '%s'",
+					 filename);
+			rle->bp_base  = rle->pos;
+			rle->bp_index = 0;
+			rle->bp_count = (header >> 1) * 8;
+			rle->pos += length;
+		}
+		else
+		{
+			/* RLE run */
+			int			nbytes = (rle->bit_width + 7) / 8;
+			uint32_t	value = 0;
+
+			if (nbytes > rle->end - rle->pos)
+				elog(ERROR, "parquet: RLE run is truncated at '%s'", filename);
+			for (int k=0; k < nbytes; k++)
+				value |= ((uint32_t)rle->pos[k] << (8 * k));
+			rle->pos += nbytes;
+			rle->rle_count = (header >> 1);
+			rle->rle_value = value;
+		}
+	}
+}
+
+/*
+ * __pqDecodeDictionaryPage
+ */
+static void
+__pqDecodeDictionaryPage(pqDecodeContext *con,
+						 const char *pos, size_t len, int32_t nitems)
+{
+	const char *end = pos + len;
+
+	if (nitems < 0)
+		elog(ERROR, "parquet: dictionary page is corrupted at '%s'", con->filename);
+	resetStringInfo(&con->dict_buf);
+	if (con->dict_offsets)
+		pfree(con->dict_offsets);
+	con->dict_offsets = NULL;
+	if (con->pq_chunk->physical_type == PARQUET_TYPE__BYTE_ARRAY)
+	{
+		con->dict_offsets = palloc(sizeof(uint32_t) * (nitems + 1));
+		con->dict_offsets[0] = 0;
+		for (int i=0; i < nitems; i++)
+		{
+			uint32_t	sz;
+
+			if (end - pos < sizeof(uint32_t))
+				goto corrupted;
+			memcpy(&sz, pos, sizeof(uint32_t));
+			pos += sizeof(uint32_t);
+			if (end - pos < sz)
+				goto corrupted;
+			appendBinaryStringInfo(&con->dict_buf, pos, sz);
+			pos += sz;
+			con->dict_offsets[i+1] = con->dict_buf.len;
+		}
+	}
+	else
+	{
+		if (con->phys_width <= 0 ||
+			(end - pos) / con->phys_width < nitems)
+			goto corrupted;
+		appendBinaryStringInfo(&con->dict_buf, pos,
+							   (size_t)con->phys_width * nitems);
+	}
+	con->dict_nitems = nitems;
+	con->has_dict = true;
+	return;
+
+corrupted:
+	elog(ERROR, "parquet: dictionary page is corrupted at '%s'", con->filename);
+}
+
+/*
+ * __pqPutValue - writes a value at the row on the Arrow buffers
+ */
+static void
+__pqPutValue(pqDecodeContext *con, int64_t row, const char *src, int32_t len)
+{
+	const ArrowTypeOptions *attopts = con->attopts;
+
+	switch (attopts->tag)
+	{
+		case ArrowType__Bool:
+			if (*src)
+				((uint8_t *)con->values->data)[row>>3] |= (1 << (row & 7));
+			break;
+
+		case ArrowType__Utf8:
+		case ArrowType__Binary:
+			{
+				uint32_t   *offsets = (uint32_t *)con->values->data;
+
+				if ((size_t)con->extra->len + len >= INT_MAX)
+					elog(ERROR, "parquet: too large variable length values in a row-group at '%s'",
+						 con->filename);
+				appendBinaryStringInfo(con->extra, src, len);
+				offsets[row+1] = con->extra->len;
+			}
+			break;
+
+		case ArrowType__Decimal:
+			{
+				int128_t	ival = 0;
+
+				if (con->pq_chunk->physical_type == PARQUET_TYPE__INT32)
+				{
+					int32_t		__ival;
+
+					memcpy(&__ival, src, sizeof(int32_t));
+					ival = __ival;
+				}
+				else if (con->pq_chunk->physical_type == PARQUET_TYPE__INT64)
+				{
+					int64_t		__ival;
+
+					memcpy(&__ival, src, sizeof(int64_t));
+					ival = __ival;
+				}
+				else
+				{
+					/* big-endian two's complement */
+					for (int k=0; k < len; k++)
+						ival = (ival << 8) | (uint8_t)src[k];
+					if (len > 0 && len < sizeof(int128_t) && (src[0] & 0x80) != 0)
+						ival -= ((int128_t)1 << (8 * len));
+				}
+				memcpy(con->values->data + sizeof(int128_t) * row,
+					   &ival, sizeof(int128_t));
+			}
+			break;
+
+		default:
+			/* fixed-length values; INT32 may be narrowed to int8/int16 */
+			Assert(attopts->unitsz > 0 && attopts->unitsz <= len);
+			memcpy(con->values->data + (size_t)attopts->unitsz * row,
+				   src, attopts->unitsz);
+			break;
+	}
+}
+
+/*
+ * __pqDecodeValues - decodes the values of a data page
+ */
+static void
+__pqDecodeValues(pqDecodeContext *con, int32_t num_values, int32_t encoding,
+				 const char *def_pos, size_t def_len,
+				 const char *pos, size_t len)
+{
+	const char *end = pos + len;
+	bool		use_dict = false;
+	pqRleDecoder def_levels;
+	pqRleDecoder dict_index;
+	uint32_t	bool_index = 0;
+	uint32_t   *offsets = NULL;
+
+	if (num_values < 0 || con->nloaded + num_values > con->nrows)
+		elog(ERROR, "parquet: column chunk has more values than row-group at '%s'",
+			 con->filename);
+	if (con->pq_chunk->max_def_level > 0)
+		__pqRleInit(&def_levels, def_pos, def_len, 1);
+	if (encoding == PARQUET_ENCODING__PLAIN_DICTIONARY ||
+		encoding == PARQUET_ENCODING__RLE_DICTIONARY)
+	{
+		if (!con->has_dict)
+			elog(ERROR, "parquet: dictionary page is missing at '%s'", con->filename);
+		if (len < 1 || (uint8_t)pos[0] > 32)
+			elog(ERROR, "parquet: dictionary indexes are corrupted at '%s'",
+				 con->filename);
+		__pqRleInit(&dict_index, pos + 1, len - 1, (uint8_t)pos[0]);
+		use_dict = true;
+	}
+	else if (encoding != PARQUET_ENCODING__PLAIN)
+		elog(ERROR, "parquet: encoding (%d) is not supported at '%s'",
+			 encoding, con->filename);
+	if (con->attopts->tag == ArrowType__Utf8 ||
+		con->attopts->tag == ArrowType__Binary)
+		offsets = (uint32_t *)con->values->data;
+
+	for (int32_t i=0; i < num_values; i++)
+	{
+		int64_t		row = con->nloaded + i;
+		const char *src;
+		int32_t		sz;
+		char		bval;
+
+		if (con->pq_chunk->max_def_level > 0 &&
+			__pqRleNext(&def_levels, con->filename) != con->pq_chunk->max_def_level)
+		{
+			/* NULL */
+			if (offsets)
+				offsets[row+1] = offsets[row];
+			con->null_count++;
+			continue;
+		}
+		((uint8_t *)con->nullmap->data)[row>>3] |= (1 << (row & 7));
+
+		if (use_dict)
+		{
+			uint32_t	index = __pqRleNext(&dict_index, con->filename);
+
+			if (index >= con->dict_nitems)
+				elog(ERROR, "parquet: dictionary index is out of range at '%s'",
+					 con->filename);
+			if (con->dict_offsets)
+			{
+				src = con->dict_buf.data + con->dict_offsets[index];
+				sz  = con->dict_offsets[index+1] - con->dict_offsets[index];
+			}
+			else
+			{
+				src = con->dict_buf.data + (size_t)con->phys_width * index;
+				sz  = con->phys_width;
+			}
+		}
+		else if (con->pq_chunk->physical_type == PARQUET_TYPE__BOOLEAN)
+		{
+			/* bit-packed, LSB first */
+			if ((bool_index >> 3) >= len)
+				goto truncated;
+			bval = ((pos[bool_index >> 3] >> (bool_index & 7)) & 1);
+			bool_index++;
+			src = &bval;
+			sz  = 1;
+		}
+		else if (con->pq_chunk->physical_type == PARQUET_TYPE__BYTE_ARRAY)
+		{
+			uint32_t	__sz;
+
+			if (end - pos < sizeof(uint32_t))
+				goto truncated;
+			memcpy(&__sz, pos, sizeof(uint32_t));
+			pos += sizeof(uint32_t);
+			if (end - pos < __sz)
+				goto truncated;
+			src = pos;
+			sz  = __sz;
+			pos += __sz;
+		}
+		else
+		{
+			if (end - pos < con->phys_width)
+				goto truncated;
+			src = pos;
+			sz  = con->phys_width;
+			pos += con->phys_width;
+		}
+		__pqPutValue(con, row, src, sz);
+	}
+	con->nloaded += num_values;
+	return;
+
+truncated:
+	elog(ERROR, "parquet: data page is truncated at '%s'", con->filename);
+}
+
+/*
+ * parquetDecodeColumnChunk
+ *
+ * It decodes the pages in the column chunk, then writes out the values on
+ * the nullmap, values and extra buffers in the Arrow layout, according to
+ * the attopts. The nullmap is valid only if *p_null_count > 0.
+ */
+void
+parquetDecodeColumnChunk(const ParquetColumnChunk *pq_chunk,
+						 const ArrowTypeOptions *attopts,
+						 const char *chunk, size_t chunk_len,
+						 int64_t nrows,
+						 StringInfo nullmap,
+						 StringInfo values,
+						 StringInfo extra,
+						 int64_t *p_null_count,
+						 const char *filename)
+{
+	pqDecodeContext con;
+	const char *pos = chunk;
+	const char *end = chunk + chunk_len;
+	size_t		values_len;
+
+	memset(&con, 0, sizeof(pqDecodeContext));
+	con.pq_chunk = pq_chunk;
+	con.attopts = attopts;
+	con.filename = filename;
+	con.nrows = nrows;
+	con.nullmap = nullmap;
+	con.values = values;
+	con.extra = extra;
+	switch (pq_chunk->physical_type)
+	{
+		case PARQUET_TYPE__INT32:
+		case PARQUET_TYPE__FLOAT:
+			con.phys_width = sizeof(int32_t);
+			break;
+		case PARQUET_TYPE__INT64:
+		case PARQUET_TYPE__DOUBLE:
+			con.phys_width = sizeof(int64_t);
+			break;
+		case PARQUET_TYPE__FIXED_LEN_BYTE_ARRAY:
+			con.phys_width = pq_chunk->type_length;
+			break;
+		default:
+			con.phys_width = 0;		/* BOOLEAN or BYTE_ARRAY */
+			break;
+	}
+	initStringInfo(&con.dict_buf);
+	initStringInfo(&con.page_buf);
+
+	/* buffers are zero-cleared, for NULLs */
+	resetStringInfo(nullmap);
+	enlargeStringInfo(nullmap, BITMAPLEN(nrows));
+	memset(nullmap->data, 0, BITMAPLEN(nrows));
+	nullmap->len = BITMAPLEN(nrows);
+
+	if (attopts->tag == ArrowType__Bool)
+		values_len = BITMAPLEN(nrows);
+	else if (attopts->tag == ArrowType__Utf8 ||
+			 attopts->tag == ArrowType__Binary)
+		values_len = sizeof(uint32_t) * (nrows + 1);
+	else
+		values_len = (size_t)attopts->unitsz * nrows;
+	resetStringInfo(values);
+	enlargeStringInfo(values, values_len);
+	memset(values->data, 0, values_len);
+	values->len = values_len;
+	resetStringInfo(extra);
+
+	while (con.nloaded < nrows && pos < end)
+	{
+		thriftReader tr;
+		pqPageHeader ph;
+		const char *page;
+
+		tr.pos = pos;
+		tr.end = end;
+		tr.filename = filename;
+		__pqReadPageHeader(&tr, &ph);
+		pos = tr.pos;
+		if (ph.compressed_page_size < 0 ||
+			ph.uncompressed_page_size < 0 ||
+			ph.compressed_page_size > end - pos)
+			elog(ERROR, "parquet: page header is corrupted at '%s'", filename);
+		page = pos;
+		pos += ph.compressed_page_size;
+
+		switch (ph.type)
+		{
+			case PARQUET_PAGE__DICTIONARY_PAGE:
+				page = __pqDecompressPage(&con, page,
+										  ph.compressed_page_size,
+										  ph.uncompressed_page_size);
+				__pqDecodeDictionaryPage(&con, page,
+										 ph.uncompressed_page_size,
+										 ph.num_values);
+				break;
+
+			case PARQUET_PAGE__DATA_PAGE:
+				{
+					const char *def_pos = NULL;
+					int32_t		def_len = 0;
+					size_t		len = ph.uncompressed_page_size;
+
+					page = __pqDecompressPage(&con, page,
+											  ph.compressed_page_size,
+											  ph.uncompressed_page_size);
+					if (pq_chunk->max_def_level > 0)
+					{
+						if (ph.def_level_encoding != PARQUET_ENCODING__RLE)
+							elog(ERROR, "parquet: definition level encoding (%d) is not supported at '%s'",
+								 ph.def_level_encoding, filename);
+						if (len < sizeof(int32_t))
+							elog(ERROR, "parquet: data page is truncated at '%s'", filename);
+						memcpy(&def_len, page, sizeof(int32_t));
+						if (def_len < 0 || def_len > len - sizeof(int32_t))
+							elog(ERROR, "parquet: data page is truncated at '%s'", filename);
+						def_pos = page + sizeof(int32_t);
+						page += sizeof(int32_t) + def_len;
+						len  -= sizeof(int32_t) + def_len;
+					}
+					__pqDecodeValues(&con, ph.num_values, ph.encoding,
+									 def_pos, def_len, page, len);
+				}
+				break;
+
+			case PARQUET_PAGE__DATA_PAGE_V2:
+				{
+					int32_t		levels_len = (ph.def_levels_length +
+											  ph.rep_levels_length);
+					size_t		raw_len;
+
+					if (ph.def_levels_length < 0 ||
+						ph.rep_levels_length < 0 ||
+						levels_len > ph.compressed_page_size ||
+						levels_len > ph.uncompressed_page_size)
+						elog(ERROR, "parquet: data page is corrupted at '%s'", filename);
+					/* levels are not compressed at DATA_PAGE_V2 */
+					raw_len = ph.uncompressed_page_size - levels_len;
+					if (ph.is_compressed)
+						page = __pqDecompressPage(&con, page + levels_len,
+												  ph.compressed_page_size - levels_len,
+												  raw_len);
+					else
+						page = page + levels_len;
+					__pqDecodeValues(&con, ph.num_values, ph.encoding,
+									 pos - ph.compressed_page_size +
+									 ph.rep_levels_length,
+									 ph.def_levels_length,
+									 page, raw_len);
+				}
+				break;
+
+			default:
+				/* INDEX_PAGE or unknown; skip */
+				break;
+		}
+	}
+	if (con.nloaded != nrows)
+		elog(ERROR, "parquet: column chunk has %ld values, but row-group has %ld rows at '%s'",
+			 con.nloaded, nrows, filename);
+	*p_null_count = con.null_count;
+
+	if (con.dict_offsets)
+		pfree(con.dict_offsets);
+	pfree(con.dict_buf.data);
+	pfree(con.page_buf.data);
+}
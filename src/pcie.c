@@ -63,8 +63,65 @@ struct BlockDevItem
 	bool		is_valid;
 	char		name[80];
 	const Bitmapset *optimal_gpus;
+	/* md-raid0 stripe configuration, if any */
+	uint32_t	stripe_chunk_sz;	/* chunk size of md-raid0 in bytes */
+	int			stripe_nmembers;	/* number of the member devices */
+	int			stripe_stats_base;	/* index of gpuDirectStripeStats */
 };
 
+/*
+ * gpuDirectStripeStats - statistics of the striped GPU-Direct reads for
+ * each member device of md-raid0 volumes, exposed by the
+ * pgstrom.pg_stat_gpudirect_stripe view. Slots are assigned to the md-raid0
+ * volumes found at the postmaster startup, so all the processes share the
+ * same slot indexes.
+ */
+#define GPUDIRECT_STRIPE_STATS_NSLOTS	256
+typedef struct
+{
+	char		md_name[48];
+	char		dev_name[48];
+	int			member_id;
+	pg_atomic_uint64 nr_ios;		/* # of read requests */
+	pg_atomic_uint64 nr_pages;		/* # of pages read */
+	pg_atomic_uint64 usec_io;		/* time to read, in microseconds */
+} gpuDirectStripeStats;
+
+typedef struct
+{
+	int			nslots;
+	gpuDirectStripeStats slots[FLEXIBLE_ARRAY_MEMBER];
+} gpuDirectStripeStatsHead;
+
+/*
+ * gpuDirectIOStats - latency histogram and throughput of the GPU-Direct
+ * reads for each pair of the block device and the driver, exposed by the
+ * pgstrom.pg_stat_gpudirect_io view. Slots are assigned on demand by the
+ * first read on the device, because GPU service threads may read files on
+ * the block devices not preloaded (e.g, partitions of NVMe).
+ */
+#define GPUDIRECT_IO_STATS_NSLOTS		64
+#define GPUDIRECT_IO_STATS_VALID		(1UL<<63)
+typedef struct
+{
+	pg_atomic_uint64 nr_ios;		/* # of read requests */
+	pg_atomic_uint64 nr_bytes;		/* total bytes read */
+	pg_atomic_uint64 usec_io;		/* time to read, in microseconds */
+	pg_atomic_uint64 usec_max;		/* max latency, in microseconds */
+	pg_atomic_uint64 hist[GPUDIRECT_IO_HIST_NBUCKETS];
+} gpuDirectIOStatsDriver;
+
+typedef struct
+{
+	pg_atomic_uint64 dev_key;		/* major/minor | GPUDIRECT_IO_STATS_VALID */
+	gpuDirectIOStatsDriver drivers[GPUDIRECT_IO_DRIVER__NUMS];
+} gpuDirectIOStatsSlot;
+
+typedef struct
+{
+	gpuDirectIOStatsSlot slots[GPUDIRECT_IO_STATS_NSLOTS];
+} gpuDirectIOStatsHead;
+
 #define VfsDevItemKeySize		(sizeof(char) * 240)
 typedef struct
 {
@@ -77,6 +134,13 @@ static HTAB	   *vfs_gpus_htable = NULL;
 static List	   *pcie_root_list = NIL;
 static List	   *nvme_devices_list = NIL;
 static List	   *gpu_devices_list = NIL;
+static int		pgstrom_gpu_distance_slack;		/* GUC */
+static gpuDirectStripeStats *stripe_stats_local = NULL;
+static int		stripe_stats_nslots = 0;
+static gpuDirectStripeStatsHead *stripe_stats_head = NULL;
+static gpuDirectIOStatsHead *io_stats_head = NULL;
+static shmem_request_hook_type shmem_request_next = NULL;
+static shmem_startup_hook_type shmem_startup_next = NULL;
 
 static const char *
 __sysfs_read_line(const char *path, char *buffer, size_t buflen)
@@ -145,6 +209,26 @@ __sysfs_read_pcie_gpu(PciDevItem *pcie, const char *dirname)
 	return false;
 }
 
+/*
+ * __bms_add_gpu_device - adds the GPU, and MIG instances on the same GPU
+ */
+static Bitmapset *
+__bms_add_gpu_device(Bitmapset *gpus, const PciDevItem *gpu)
+{
+	const GpuDevAttributes *gattrs = gpu->u.gpu.gpu_dev_attrs;
+
+	gpus = bms_add_member(gpus, gpu->u.gpu.cuda_dindex);
+	if (gattrs->DEV_MIG_PARENT_ID >= 0)
+	{
+		for (int i=0; i < numGpuDevAttrs; i++)
+		{
+			if (gpuDevAttrs[i].DEV_MIG_PARENT_ID == gattrs->DEV_MIG_PARENT_ID)
+				gpus = bms_add_member(gpus, i);
+		}
+	}
+	return gpus;
+}
+
 static bool
 __sysfs_read_pcie_nvme(PciDevItem *pcie, const char *dirname)
 {
@@ -479,14 +563,29 @@ sysfs_setup_optimal_gpus(void)
 				dist < nvme->distance)
 			{
 				nvme->distance = dist;
-				nvme->optimal_gpus = bms_make_singleton(gpu->u.gpu.cuda_dindex);
+				nvme->optimal_gpus = __bms_add_gpu_device(NULL, gpu);
 			}
 			else if (dist == nvme->distance)
 			{
-				nvme->optimal_gpus = bms_add_member(nvme->optimal_gpus,
-													gpu->u.gpu.cuda_dindex);
+				nvme->optimal_gpus = __bms_add_gpu_device(nvme->optimal_gpus,
+														  gpu);
 			}
 		}
+		/*
+		 * GPUs slightly farther than the nearest ones are also candidates,
+		 * then the backend chooses the one by the current load.
+		 */
+		if (nvme->distance < 0 || pgstrom_gpu_distance_slack == 0)
+			continue;
+		foreach (lc2, gpu_devices_list)
+		{
+			PciDevItem *gpu = lfirst(lc2);
+
+			dist = sysfs_calculate_distance_root(nvme, gpu);
+			if (dist >= 0 && dist <= nvme->distance + pgstrom_gpu_distance_slack)
+				nvme->optimal_gpus = __bms_add_gpu_device(nvme->optimal_gpus,
+														  gpu);
+		}
 	}
 }
 
@@ -622,6 +721,21 @@ __blkdev_setup_partition(BlockDevItem *bdev)
 						&__minor) != 2)
 		elog(ERROR, "sysfs '%s' has unexpected value", path);
 	bdev->optimal_gpus = sysfs_lookup_optimal_gpus(__major, __minor);
+	/* inherit the stripe configuration, if md-raid0 */
+	{
+		BlockDevItem	hkey, *parent;
+
+		memset(&hkey, 0, sizeof(BlockDevItem));
+		hkey.major = __major;
+		hkey.minor = __minor;
+		parent = hash_search(block_dev_htable, &hkey, HASH_FIND, NULL);
+		if (parent && parent->is_valid)
+		{
+			bdev->stripe_chunk_sz   = parent->stripe_chunk_sz;
+			bdev->stripe_nmembers   = parent->stripe_nmembers;
+			bdev->stripe_stats_base = parent->stripe_stats_base;
+		}
+	}
 	return true;
 }
 
@@ -634,6 +748,8 @@ __blkdev_setup_md_raid0(BlockDevItem *bdev)
 	char	   *end;
 	long		chunk_sz;
 	int			count = 0;
+	int			max_member_id = -1;
+	char		member_names[64][48];
 	DIR		   *dir;
 	struct dirent *dent;
 
@@ -685,13 +801,16 @@ __blkdev_setup_md_raid0(BlockDevItem *bdev)
 	while ((dent = ReadDir(dir, path)) != NULL)
 	{
 		char	__path[MAXPGPATH];
+		char	__temp[MAXPGPATH];
 		int		__major;
 		int		__minor;
+		long	__member_id;
+		ssize_t	sz;
 		const Bitmapset *__optimal_gpus;
 
 		if (strncmp(dent->d_name, "rd", 2) != 0)
 			continue;
-		strtol(dent->d_name + 2, &end, 10);
+		__member_id = strtol(dent->d_name + 2, &end, 10);
 		if (dent->d_name[2] == '\0' || *end != '\0')
 			continue;
 
@@ -710,8 +829,59 @@ __blkdev_setup_md_raid0(BlockDevItem *bdev)
 			optimal_gpus = __optimal_gpus;
 		else
 			optimal_gpus = bms_intersect(optimal_gpus, __optimal_gpus);
+
+		/* md/rdN is a symbolic link to md/dev-<name> */
+		if (__member_id < lengthof(member_names))
+		{
+			snprintf(__path, sizeof(__path),
+					 "/sys/dev/block/%u:%u/md/%s",
+					 bdev->major,
+					 bdev->minor,
+					 dent->d_name);
+			if ((sz = readlink(__path, __temp, sizeof(__temp)-1)) < 0)
+				strcpy(__temp, "????");
+			else
+				__temp[sz] = '\0';
+			end = basename(__temp);
+			if (strncmp(end, "dev-", 4) == 0)
+				end += 4;
+			strncpy(member_names[__member_id], end, 48);
+			member_names[__member_id][47] = '\0';
+		}
+		max_member_id = Max(max_member_id, __member_id);
 	}
 	FreeDir(dir);
+
+	/*
+	 * The stripe configuration is valid only if md/rd0...rdN are all here,
+	 * then the chunk k of the volume is located on the member (k % N).
+	 */
+	if (count > 1 &&
+		count == max_member_id + 1 &&
+		count <= lengthof(member_names))
+	{
+		bdev->stripe_chunk_sz = chunk_sz;
+		bdev->stripe_nmembers = count;
+		/* assign the statistics slots only at the postmaster startup */
+		if (!IsUnderPostmaster &&
+			stripe_stats_nslots + count <= GPUDIRECT_STRIPE_STATS_NSLOTS)
+		{
+			if (!stripe_stats_local)
+				stripe_stats_local = MemoryContextAllocZero(TopMemoryContext,
+															sizeof(gpuDirectStripeStats) *
+															GPUDIRECT_STRIPE_STATS_NSLOTS);
+			bdev->stripe_stats_base = stripe_stats_nslots;
+			for (int i=0; i < count; i++)
+			{
+				gpuDirectStripeStats *ss = &stripe_stats_local[stripe_stats_nslots++];
+
+				strncpy(ss->md_name, bdev->name, sizeof(ss->md_name));
+				ss->md_name[sizeof(ss->md_name)-1] = '\0';
+				strcpy(ss->dev_name, member_names[i]);
+				ss->member_id = i;
+			}
+		}
+	}
 out:
 	bdev->optimal_gpus = optimal_gpus;
 	return true;
@@ -818,6 +988,9 @@ sysfs_lookup_optimal_gpus(uint major, uint minor)
 				temp[sz] = '\0';
 				strncpy(bdev->name, basename(temp), sizeof(bdev->name));
 			}
+			bdev->stripe_chunk_sz = 0;
+			bdev->stripe_nmembers = 0;
+			bdev->stripe_stats_base = -1;
 
 			if (!__blkdev_setup_partition(bdev) &&
 				!__blkdev_setup_md_raid0(bdev) &&
@@ -828,10 +1001,11 @@ sysfs_lookup_optimal_gpus(uint major, uint minor)
 			}
 			bdev->is_valid = true;
 		}
-		PG_FINALLY();
+		PG_CATCH();
 		{
 			/* clean up hash entry */
 			hash_search(block_dev_htable, &hkey, HASH_REMOVE, NULL);
+			PG_RE_THROW();
 		}
 		PG_END_TRY();
 	}
@@ -962,6 +1136,9 @@ GetOptimalGpuForFile(const char *pathname)
 {
 	struct stat	stat_buf;
 
+	/* PCI-E topology of the remote GPU service is unknown */
+	if (gpuServiceIsRemote())
+		return NULL;
 	if (stat(pathname, &stat_buf) != 0)
 	{
 		elog(WARNING, "failed on stat('%s'): %m", pathname);
@@ -1040,7 +1217,8 @@ GetOptimalGpuForTablespace(Oid tablespace_oid)
 	tablespace_optimal_gpu_hentry *hentry;
 	bool		found;
 
-	if (!pgstrom_gpudirect_enabled)
+	/* heap blocks are not visible to the remote GPU service */
+	if (!pgstrom_gpudirect_enabled || gpuServiceIsRemote())
 		return NULL;
 
 	if (!OidIsValid(tablespace_oid))
@@ -1112,7 +1290,7 @@ GetOptimalGpuForBaseRel(PlannerInfo *root, RelOptInfo *baserel)
 	const Bitmapset *optimal_gpus;
 	double		total_sz;
 
-	if (!pgstrom_gpudirect_enabled)
+	if (!pgstrom_gpudirect_enabled || gpuServiceIsRemote())
 		return NULL;
 	if (baseRelIsArrowFdw(baserel))
 	{
@@ -1205,6 +1383,406 @@ sysfs_preload_block_devices(void)
 	FreeDir(dir);
 }
 
+/*
+ * GetGpuDirectStripeInfo
+ *
+ * It returns the md-raid0 stripe configuration of the block device where
+ * the file is located. It may be called by the GPU service threads, so it
+ * only looks up the block devices preloaded at the postmaster startup, with
+ * no catalog access nor elog.
+ */
+bool
+GetGpuDirectStripeInfo(const char *pathname,
+					   uint32_t *p_stripe_chunk_sz,
+					   int *p_stripe_nmembers,
+					   int *p_stripe_stats_base)
+{
+	struct stat		stat_buf;
+	BlockDevItem	hkey, *bdev;
+
+	if (!block_dev_htable || stat(pathname, &stat_buf) != 0)
+		return false;
+	memset(&hkey, 0, sizeof(BlockDevItem));
+	hkey.major = major(stat_buf.st_dev);
+	hkey.minor = minor(stat_buf.st_dev);
+	bdev = hash_search(block_dev_htable, &hkey, HASH_FIND, NULL);
+	if (!bdev || !bdev->is_valid || bdev->stripe_nmembers < 2)
+		return false;
+	*p_stripe_chunk_sz   = bdev->stripe_chunk_sz;
+	*p_stripe_nmembers   = bdev->stripe_nmembers;
+	*p_stripe_stats_base = bdev->stripe_stats_base;
+	return true;
+}
+
+/*
+ * gpuDirectStripeUpdateStats
+ */
+void
+gpuDirectStripeUpdateStats(int stats_index,
+						   uint32_t nr_ios,
+						   uint64_t nr_pages,
+						   uint64_t usec_io)
+{
+	gpuDirectStripeStats *ss;
+
+	if (!stripe_stats_head ||
+		stats_index < 0 || stats_index >= stripe_stats_head->nslots)
+		return;
+	ss = &stripe_stats_head->slots[stats_index];
+	pg_atomic_fetch_add_u64(&ss->nr_ios, nr_ios);
+	pg_atomic_fetch_add_u64(&ss->nr_pages, nr_pages);
+	pg_atomic_fetch_add_u64(&ss->usec_io, usec_io);
+}
+
+/*
+ * pgstrom_gpudirect_stripe_stats - SQL function to dump the statistics
+ * of striped GPU-Direct reads
+ */
+PG_FUNCTION_INFO_V1(pgstrom_gpudirect_stripe_stats);
+PUBLIC_FUNCTION(Datum)
+pgstrom_gpudirect_stripe_stats(PG_FUNCTION_ARGS)
+{
+	FuncCallContext *fncxt;
+	gpuDirectStripeStats *ss;
+	Datum		values[6];
+	bool		isnull[6];
+	HeapTuple	tuple;
+	int			index;
+
+	if (SRF_IS_FIRSTCALL())
+	{
+		TupleDesc		tupdesc;
+		MemoryContext	oldcxt;
+
+		fncxt = SRF_FIRSTCALL_INIT();
+		oldcxt = MemoryContextSwitchTo(fncxt->multi_call_memory_ctx);
+
+		tupdesc = CreateTemplateTupleDesc(6);
+		TupleDescInitEntry(tupdesc, 1, "md_device",
+						   TEXTOID, -1, 0);
+		TupleDescInitEntry(tupdesc, 2, "member_id",
+						   INT4OID, -1, 0);
+		TupleDescInitEntry(tupdesc, 3, "member_device",
+						   TEXTOID, -1, 0);
+		TupleDescInitEntry(tupdesc, 4, "nr_ios",
+						   INT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc, 5, "nr_pages",
+						   INT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc, 6, "io_time",
+						   FLOAT8OID, -1, 0);
+		fncxt->tuple_desc = BlessTupleDesc(tupdesc);
+
+		MemoryContextSwitchTo(oldcxt);
+	}
+	fncxt = SRF_PERCALL_SETUP();
+	index = fncxt->call_cntr;
+	if (!stripe_stats_head || index >= stripe_stats_head->nslots)
+		SRF_RETURN_DONE(fncxt);
+	ss = &stripe_stats_head->slots[index];
+
+	memset(isnull, 0, sizeof(isnull));
+	values[0] = CStringGetTextDatum(ss->md_name);
+	values[1] = Int32GetDatum(ss->member_id);
+	values[2] = CStringGetTextDatum(ss->dev_name);
+	values[3] = Int64GetDatum(pg_atomic_read_u64(&ss->nr_ios));
+	values[4] = Int64GetDatum(pg_atomic_read_u64(&ss->nr_pages));
+	/* in milliseconds, like pg_stat_statements */
+	values[5] = Float8GetDatum((double)pg_atomic_read_u64(&ss->usec_io) / 1000.0);
+
+	tuple = heap_form_tuple(fncxt->tuple_desc, values, isnull);
+
+	SRF_RETURN_NEXT(fncxt, HeapTupleGetDatum(tuple));
+}
+
+/*
+ * gpuDirectIOUpdateStats
+ *
+ * It records a GPU-Direct read on the block device 'st_dev' by the driver.
+ * It is called by the GPU service threads, so no elog nor palloc here.
+ */
+void
+gpuDirectIOUpdateStats(dev_t st_dev, int driver,
+					   uint64_t nr_bytes, uint64_t usec_io)
+{
+	gpuDirectIOStatsDriver *ios = NULL;
+	uint64_t	dev_key;
+	uint64_t	curr_max;
+	int			index;
+
+	if (!io_stats_head || driver < 0 || driver >= GPUDIRECT_IO_DRIVER__NUMS)
+		return;
+	dev_key = (((uint64_t)major(st_dev) << 32) |
+			   ((uint64_t)minor(st_dev)) | GPUDIRECT_IO_STATS_VALID);
+	index = hash_uint32((uint32)(dev_key ^ (dev_key >> 32))) % GPUDIRECT_IO_STATS_NSLOTS;
+	for (int count=0; count < GPUDIRECT_IO_STATS_NSLOTS; count++)
+	{
+		gpuDirectIOStatsSlot *slot = &io_stats_head->slots[index];
+		uint64_t	curr_key = pg_atomic_read_u64(&slot->dev_key);
+
+		if (curr_key == 0 &&
+			pg_atomic_compare_exchange_u64(&slot->dev_key, &curr_key, dev_key))
+			curr_key = dev_key;
+		if (curr_key == dev_key)
+		{
+			ios = &slot->drivers[driver];
+			break;
+		}
+		index = (index + 1) % GPUDIRECT_IO_STATS_NSLOTS;
+	}
+	if (!ios)
+		return;		/* no more slots */
+	pg_atomic_fetch_add_u64(&ios->nr_ios, 1);
+	pg_atomic_fetch_add_u64(&ios->nr_bytes, nr_bytes);
+	pg_atomic_fetch_add_u64(&ios->usec_io, usec_io);
+	pg_atomic_fetch_add_u64(&ios->hist[gpuDirectIOHistBucket(usec_io)], 1);
+	curr_max = pg_atomic_read_u64(&ios->usec_max);
+	while (curr_max < usec_io)
+	{
+		if (pg_atomic_compare_exchange_u64(&ios->usec_max, &curr_max, usec_io))
+			break;
+	}
+}
+
+/*
+ * __gpuDirectIOHistPercentile
+ *
+ * It estimates the percentile of the latency by the upper bound of the
+ * histogram bucket that contains it.
+ */
+static double
+__gpuDirectIOHistPercentile(const uint64_t *hist, uint64_t nr_ios,
+							double fraction, uint64_t usec_max)
+{
+	uint64_t	threshold = (uint64_t)ceil((double)nr_ios * fraction);
+	uint64_t	count = 0;
+
+	for (int k=0; k < GPUDIRECT_IO_HIST_NBUCKETS - 1; k++)
+	{
+		count += hist[k];
+		if (count >= threshold)
+			return (double)Min(GPUDIRECT_IO_HIST_UPPER(k), usec_max) / 1000.0;
+	}
+	return (double)usec_max / 1000.0;
+}
+
+/*
+ * pgstrom_gpudirect_io_stats - SQL function to dump the latency histogram
+ * and throughput of GPU-Direct reads per block device and driver
+ */
+PG_FUNCTION_INFO_V1(pgstrom_gpudirect_io_stats);
+PUBLIC_FUNCTION(Datum)
+pgstrom_gpudirect_io_stats(PG_FUNCTION_ARGS)
+{
+	static const char *driver_names[] = { "cufile", "nvme_strom", "vfs" };
+	FuncCallContext *fncxt;
+	gpuDirectIOStatsSlot *slot;
+	gpuDirectIOStatsDriver *ios;
+	BlockDevItem hkey, *bdev;
+	uint64_t	dev_key;
+	uint64_t	nr_ios;
+	uint64_t	nr_bytes;
+	uint64_t	usec_io;
+	uint64_t	usec_max;
+	uint64_t	hist[GPUDIRECT_IO_HIST_NBUCKETS];
+	Datum		hist_datum[GPUDIRECT_IO_HIST_NBUCKETS];
+	Datum		values[10];
+	bool		isnull[10];
+	HeapTuple	tuple;
+	uint32		index;
+
+	if (SRF_IS_FIRSTCALL())
+	{
+		TupleDesc		tupdesc;
+		MemoryContext	oldcxt;
+
+		fncxt = SRF_FIRSTCALL_INIT();
+		oldcxt = MemoryContextSwitchTo(fncxt->multi_call_memory_ctx);
+
+		tupdesc = CreateTemplateTupleDesc(10);
+		TupleDescInitEntry(tupdesc, 1, "device",
+						   TEXTOID, -1, 0);
+		TupleDescInitEntry(tupdesc, 2, "driver",
+						   TEXTOID, -1, 0);
+		TupleDescInitEntry(tupdesc, 3, "nr_ios",
+						   INT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc, 4, "nr_bytes",
+						   INT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc, 5, "io_time",
+						   FLOAT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc, 6, "max_latency",
+						   FLOAT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc, 7, "throughput",
+						   FLOAT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc, 8, "latency_p50",
+						   FLOAT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc, 9, "latency_p99",
+						   FLOAT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc, 10, "latency_hist",
+						   INT8ARRAYOID, -1, 0);
+		fncxt->tuple_desc = BlessTupleDesc(tupdesc);
+
+		MemoryContextSwitchTo(oldcxt);
+	}
+	fncxt = SRF_PERCALL_SETUP();
+	if (!io_stats_head)
+		SRF_RETURN_DONE(fncxt);
+	/* fncxt->user_fctx is the next position of slot * driver */
+	for (;;)
+	{
+		index = (uint32)((uintptr_t)fncxt->user_fctx);
+		if (index >= GPUDIRECT_IO_STATS_NSLOTS * GPUDIRECT_IO_DRIVER__NUMS)
+			SRF_RETURN_DONE(fncxt);
+		fncxt->user_fctx = (void *)((uintptr_t)(index + 1));
+
+		slot = &io_stats_head->slots[index / GPUDIRECT_IO_DRIVER__NUMS];
+		ios = &slot->drivers[index % GPUDIRECT_IO_DRIVER__NUMS];
+		dev_key = pg_atomic_read_u64(&slot->dev_key);
+		if ((dev_key & GPUDIRECT_IO_STATS_VALID) != 0 &&
+			(nr_ios = pg_atomic_read_u64(&ios->nr_ios)) > 0)
+			break;
+	}
+	nr_bytes = pg_atomic_read_u64(&ios->nr_bytes);
+	usec_io  = pg_atomic_read_u64(&ios->usec_io);
+	usec_max = pg_atomic_read_u64(&ios->usec_max);
+	for (int k=0; k < GPUDIRECT_IO_HIST_NBUCKETS; k++)
+	{
+		hist[k] = pg_atomic_read_u64(&ios->hist[k]);
+		hist_datum[k] = Int64GetDatum(hist[k]);
+	}
+
+	memset(isnull, 0, sizeof(isnull));
+	memset(&hkey, 0, sizeof(BlockDevItem));
+	hkey.major = (uint)((dev_key & ~GPUDIRECT_IO_STATS_VALID) >> 32);
+	hkey.minor = (uint)(dev_key & 0xffffffffUL);
+	bdev = (block_dev_htable
+			? hash_search(block_dev_htable, &hkey, HASH_FIND, NULL)
+			: NULL);
+	if (bdev)
+		values[0] = CStringGetTextDatum(bdev->name);
+	else
+		values[0] = CStringGetTextDatum(psprintf("%u:%u", hkey.major, hkey.minor));
+	values[1] = CStringGetTextDatum(driver_names[index % GPUDIRECT_IO_DRIVER__NUMS]);
+	values[2] = Int64GetDatum(nr_ios);
+	values[3] = Int64GetDatum(nr_bytes);
+	/* in milliseconds, like pg_stat_statements */
+	values[4] = Float8GetDatum((double)usec_io / 1000.0);
+	values[5] = Float8GetDatum((double)usec_max / 1000.0);
+	/* in MB/s */
+	if (usec_io > 0)
+		values[6] = Float8GetDatum((double)nr_bytes / (double)usec_io);
+	else
+		isnull[6] = true;
+	values[7] = Float8GetDatum(__gpuDirectIOHistPercentile(hist, nr_ios, 0.50, usec_max));
+	values[8] = Float8GetDatum(__gpuDirectIOHistPercentile(hist, nr_ios, 0.99, usec_max));
+	values[9] = PointerGetDatum(construct_array(hist_datum,
+												GPUDIRECT_IO_HIST_NBUCKETS,
+												INT8OID, sizeof(int64),
+												FLOAT8PASSBYVAL,
+												'd'));
+	tuple = heap_form_tuple(fncxt->tuple_desc, values, isnull);
+
+	SRF_RETURN_NEXT(fncxt, HeapTupleGetDatum(tuple));
+}
+
+/*
+ * pgstrom_gpudirect_io_stats_reset - SQL function to clear the statistics
+ */
+PG_FUNCTION_INFO_V1(pgstrom_gpudirect_io_stats_reset);
+PUBLIC_FUNCTION(Datum)
+pgstrom_gpudirect_io_stats_reset(PG_FUNCTION_ARGS)
+{
+	if (!superuser())
+		ereport(ERROR,
+				(errcode(ERRCODE_INSUFFICIENT_PRIVILEGE),
+				 errmsg("only superuser can reset GPU-Direct I/O statistics")));
+	if (io_stats_head)
+	{
+		for (int i=0; i < GPUDIRECT_IO_STATS_NSLOTS; i++)
+		{
+			gpuDirectIOStatsSlot *slot = &io_stats_head->slots[i];
+
+			for (int j=0; j < GPUDIRECT_IO_DRIVER__NUMS; j++)
+			{
+				gpuDirectIOStatsDriver *ios = &slot->drivers[j];
+
+				pg_atomic_write_u64(&ios->nr_ios, 0);
+				pg_atomic_write_u64(&ios->nr_bytes, 0);
+				pg_atomic_write_u64(&ios->usec_io, 0);
+				pg_atomic_write_u64(&ios->usec_max, 0);
+				for (int k=0; k < GPUDIRECT_IO_HIST_NBUCKETS; k++)
+					pg_atomic_write_u64(&ios->hist[k], 0);
+			}
+		}
+	}
+	PG_RETURN_VOID();
+}
+
+/*
+ * pgstrom_request_gpudirect_stripe
+ */
+static void
+pgstrom_request_gpudirect_stripe(void)
+{
+	if (shmem_request_next)
+		shmem_request_next();
+	RequestAddinShmemSpace(MAXALIGN(offsetof(gpuDirectStripeStatsHead,
+											 slots[stripe_stats_nslots])));
+	RequestAddinShmemSpace(MAXALIGN(sizeof(gpuDirectIOStatsHead)));
+}
+
+/*
+ * pgstrom_startup_gpudirect_stripe
+ */
+static void
+pgstrom_startup_gpudirect_stripe(void)
+{
+	size_t	sz = offsetof(gpuDirectStripeStatsHead, slots[stripe_stats_nslots]);
+	bool	found;
+
+	if (shmem_startup_next)
+		(*shmem_startup_next)();
+
+	stripe_stats_head = ShmemInitStruct("gpuDirectStripeStatsHead",
+										MAXALIGN(sz), &found);
+	Assert(!found);
+	memset(stripe_stats_head, 0, sz);
+	stripe_stats_head->nslots = stripe_stats_nslots;
+	for (int i=0; i < stripe_stats_nslots; i++)
+	{
+		gpuDirectStripeStats *ss = &stripe_stats_head->slots[i];
+
+		strcpy(ss->md_name,  stripe_stats_local[i].md_name);
+		strcpy(ss->dev_name, stripe_stats_local[i].dev_name);
+		ss->member_id = stripe_stats_local[i].member_id;
+		pg_atomic_init_u64(&ss->nr_ios, 0);
+		pg_atomic_init_u64(&ss->nr_pages, 0);
+		pg_atomic_init_u64(&ss->usec_io, 0);
+	}
+
+	io_stats_head = ShmemInitStruct("gpuDirectIOStatsHead",
+									MAXALIGN(sizeof(gpuDirectIOStatsHead)),
+									&found);
+	Assert(!found);
+	memset(io_stats_head, 0, sizeof(gpuDirectIOStatsHead));
+	for (int i=0; i < GPUDIRECT_IO_STATS_NSLOTS; i++)
+	{
+		gpuDirectIOStatsSlot *slot = &io_stats_head->slots[i];
+
+		pg_atomic_init_u64(&slot->dev_key, 0);
+		for (int j=0; j < GPUDIRECT_IO_DRIVER__NUMS; j++)
+		{
+			gpuDirectIOStatsDriver *ios = &slot->drivers[j];
+
+			pg_atomic_init_u64(&ios->nr_ios, 0);
+			pg_atomic_init_u64(&ios->nr_bytes, 0);
+			pg_atomic_init_u64(&ios->usec_io, 0);
+			pg_atomic_init_u64(&ios->usec_max, 0);
+			for (int k=0; k < GPUDIRECT_IO_HIST_NBUCKETS; k++)
+				pg_atomic_init_u64(&ios->hist[k], 0);
+		}
+	}
+}
+
 /*
  * pgstrom_init_gpudirect
  */
@@ -1275,6 +1853,21 @@ pgstrom_init_pcie(void)
 							   PGC_POSTMASTER,
 							   GUC_NOT_IN_SAMPLE,
 							   NULL, NULL, NULL);
+	/*
+	 * pg_strom.gpu_distance_slack
+	 *
+	 * GPUs on the same CPU socket are never 99 or more far than others.
+	 */
+	DefineCustomIntVariable("pg_strom.gpu_distance_slack",
+							"Acceptable PCIe distance from the nearest GPU to choose a less loaded GPU",
+							NULL,
+							&pgstrom_gpu_distance_slack,
+							0,
+							0,
+							98,
+							PGC_POSTMASTER,
+							GUC_NOT_IN_SAMPLE,
+							NULL, NULL, NULL);
 	memcxt = MemoryContextSwitchTo(TopMemoryContext);
 	sysfs_read_pcie_subtree();
 	sysfs_setup_optimal_gpus();
@@ -1284,6 +1877,12 @@ pgstrom_init_pcie(void)
 	sysfs_preload_block_devices();
 	MemoryContextSwitchTo(memcxt);
 
+	/* shared memory for the striped / per-device GPU-Direct reads statistics */
+	shmem_request_next = shmem_request_hook;
+	shmem_request_hook = pgstrom_request_gpudirect_stripe;
+	shmem_startup_next = shmem_startup_hook;
+	shmem_startup_hook = pgstrom_startup_gpudirect_stripe;
+
 	/*
 	 * Special initialization for GPU-Direct SQL
 	 */
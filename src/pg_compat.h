@@ -41,6 +41,43 @@
 #if PG_VERSION_NUM >= 160000
 #define pg_type_aclcheck(a,b,c)		object_aclcheck(TypeRelationId,(a),(b),(c))
 #define pg_proc_aclcheck(a,b,c)		object_aclcheck(ProcedureRelationId,(a),(b),(c))
+#define pg_class_ownercheck(a,b)	object_ownercheck(RelationRelationId,(a),(b))
+#endif
+
+/*
+ * MEMO: PostgreSQL v16 renamed RelFileNode to RelFileLocator, and its fields
+ * also. GpuCache WAL sync worker refers the relation of WAL records.
+ */
+#if PG_VERSION_NUM < 160000
+typedef RelFileNode		RelFileLocator;
+#define RelFileLocatorSpcOid(rlocator)		((rlocator).spcNode)
+#define RelFileLocatorDbOid(rlocator)		((rlocator).dbNode)
+#define RelFileLocatorRelNumber(rlocator)	((rlocator).relNode)
+#define RelidByRelfilenumber(spcOid,relNumber)	\
+	RelidByRelfilenode((spcOid),(relNumber))
+#define RelationFileLocator(rel)			((rel)->rd_node)
+#else
+#define RelFileLocatorSpcOid(rlocator)		((rlocator).spcOid)
+#define RelFileLocatorDbOid(rlocator)		((rlocator).dbOid)
+#define RelFileLocatorRelNumber(rlocator)	((rlocator).relNumber)
+#define RelationFileLocator(rel)			((rel)->rd_locator)
+#endif
+
+/*
+ * MEMO: PostgreSQL v17 added failover and synced arguments on the
+ * ReplicationSlotCreate().
+ */
+#if PG_VERSION_NUM >= 170000
+#define ReplicationSlotCreate(name,db_specific,persistency,two_phase)	\
+	ReplicationSlotCreate((name),(db_specific),(persistency),(two_phase),false,false)
+#endif
+
+/*
+ * MEMO: PostgreSQL v17 renamed ShmemVariableCache to TransamVariables.
+ * GPU-side MVCC checks refer the oldest XID in the commit log.
+ */
+#if PG_VERSION_NUM < 170000
+#define TransamVariables		ShmemVariableCache
 #endif
 
 #endif	/* PG_COMPAT_H */
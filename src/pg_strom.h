@@ -20,21 +20,29 @@
 #define PG_MINOR_VERSION		(PG_VERSION_NUM % 100)
 
 #include "access/brin.h"
+#include "access/detoast.h"
 #include "access/heapam.h"
+#include "access/heapam_xlog.h"
 #include "access/genam.h"
+#include "access/parallel.h"
 #include "access/reloptions.h"
 #include "access/relscan.h"
 #include "access/syncscan.h"
 #include "access/table.h"
 #include "access/tableam.h"
+#include "access/transam.h"
 #include "access/visibilitymap.h"
 #include "access/xact.h"
+#include "access/xlog.h"
+#include "access/xlogreader.h"
+#include "access/xlogutils.h"
 #include "catalog/binary_upgrade.h"
 #include "catalog/dependency.h"
 #include "catalog/heap.h"
 #include "catalog/indexing.h"
 #include "catalog/namespace.h"
 #include "catalog/objectaccess.h"
+#include "catalog/partition.h"
 #include "catalog/pg_aggregate.h"
 #include "catalog/pg_am.h"
 #include "catalog/pg_amop.h"
@@ -46,6 +54,7 @@
 #include "catalog/pg_foreign_server.h"
 #include "catalog/pg_user_mapping.h"
 #include "catalog/pg_extension.h"
+#include "catalog/pg_inherits.h"
 #include "catalog/pg_namespace.h"
 #include "catalog/pg_proc.h"
 #include "catalog/pg_statistic.h"
@@ -60,20 +69,31 @@
 #include "commands/tablespace.h"
 #include "commands/trigger.h"
 #include "commands/typecmds.h"
+#include "common/cryptohash.h"
+#include "common/file_perm.h"
 #include "common/hashfn.h"
+#include "common/hmac.h"
 #include "common/int.h"
+#include "common/sha2.h"
+#include "executor/executor.h"
+#include "executor/instrument.h"
 #include "executor/nodeSubplan.h"
+#include "executor/spi.h"
+#include "executor/tstoreReceiver.h"
 #include "foreign/fdwapi.h"
 #include "foreign/foreign.h"
 #include "funcapi.h"
+#include "jit/jit.h"
 #include "libpq/pqformat.h"
 #include "libpq/pqsignal.h"
+#include "lib/binaryheap.h"
 #include "lib/stringinfo.h"
 #include "miscadmin.h"
 #include "nodes/extensible.h"
 #include "nodes/makefuncs.h"
 #include "nodes/nodeFuncs.h"
 #include "nodes/pathnodes.h"
+#include "optimizer/appendinfo.h"
 #include "optimizer/clauses.h"
 #include "optimizer/cost.h"
 #include "optimizer/optimizer.h"
@@ -84,22 +104,35 @@
 #include "optimizer/planmain.h"
 #include "optimizer/restrictinfo.h"
 #include "optimizer/tlist.h"
+#include "parser/analyze.h"
+#include "parser/parse_agg.h"
 #include "parser/parse_func.h"
+#include "parser/parse_oper.h"
+#include "parser/parsetree.h"
 #include "postmaster/bgworker.h"
 #include "postmaster/postmaster.h"
+#include "replication/slot.h"
+#include "rewrite/rewriteHandler.h"
 #include "storage/bufmgr.h"
 #include "storage/buf_internals.h"
 #include "storage/ipc.h"
 #include "storage/fd.h"
 #include "storage/latch.h"
+#include "storage/lmgr.h"
 #include "storage/pmsignal.h"
 #include "storage/procarray.h"
+#include "storage/shm_mq.h"
 #include "storage/shmem.h"
 #include "storage/smgr.h"
+#include "tcop/tcopprot.h"
+#include "tcop/utility.h"
+#include "utils/array.h"
+#include "utils/attoptcache.h"
 #include "utils/builtins.h"
 #include "utils/cash.h"
 #include "utils/catcache.h"
 #include "utils/date.h"
+#include "utils/datum.h"
 #include "utils/datetime.h"
 #include "utils/float.h"
 #include "utils/fmgroids.h"
@@ -107,20 +140,29 @@
 #include "utils/inet.h"
 #include "utils/inval.h"
 #include "utils/jsonb.h"
+#include "utils/jsonpath.h"
 #include "utils/lsyscache.h"
 #include "utils/pg_locale.h"
 #include "utils/rangetypes.h"
 #include "utils/regproc.h"
+#if PG_VERSION_NUM < 160000
+#include "utils/relfilenodemap.h"
+#else
+#include "utils/relfilenumbermap.h"
+#endif
 #include "utils/rel.h"
 #include "utils/resowner.h"
 #include "utils/ruleutils.h"
 #include "utils/selfuncs.h"
+#include "utils/snapmgr.h"
 #include "utils/spccache.h"
 #include "utils/syscache.h"
 #include "utils/timestamp.h"
+#include "utils/tuplesort.h"
 #include "utils/tuplestore.h"
 #include "utils/typcache.h"
 #include "utils/uuid.h"
+#include "utils/varlena.h"
 #include "utils/wait_event.h"
 #include <assert.h>
 //#define CUDA_API_PER_THREAD_DEFAULT_STREAM		1
@@ -137,6 +179,7 @@
 #include <sys/mman.h>
 #include <sys/poll.h>
 #include <sys/socket.h>
+#include <sys/stat.h>
 #include <sys/un.h>
 #include <sys/time.h>
 #include <sys/types.h>
@@ -167,6 +210,8 @@ typedef struct GpuDevAttributes
 	size_t		DEV_TOTAL_MEMSZ;
 	size_t		DEV_BAR1_MEMSZ;
 	bool		DEV_SUPPORT_GPUDIRECTSQL;
+	int32		DEV_MIG_PARENT_ID;	/* NVML index of the parent GPU,
+									 * or -1 if not a MIG instance */
 #define DEV_ATTR(LABEL,DESC)	\
 	int32		LABEL;
 #include "gpu_devattrs.h"
@@ -227,6 +272,8 @@ typedef struct devfunc_info
 	uint64_t	func_flags;
 	int			func_cost;
 	bool		func_is_negative;
+	const char *func_symbol;		/* user-defined device function only */
+	const char *func_source;		/* user-defined device function only */
 	int			func_nargs;
 	struct devtype_info *func_argtypes[1];
 } devfunc_info;
@@ -264,12 +311,27 @@ typedef struct
 	Selectivity		gist_selectivity; /* GiST selectivity */
 	double			gist_npages;	/* number of disk pages */
 	int				gist_height;	/* index tree height, or -1 if unknown */
+	/* grid-join properties (hash-join on the cells of uniform grid) */
+	double			grid_cell_size;	/* width of the grid cell, or 0.0 */
+	double			grid_expand;	/* margin to expand the inner bbox */
+	/* range-join properties (binary search on the sorted inner bounds) */
+	List		   *range_outer_keys;	/* outer key of the range, or NIL */
+	List		   *range_inner_keys;	/* lower and upper bound of inner */
+	List		   *range_inner_keys_fallback;
+	/* polygon-index of the inner geometry for st_contains() */
+	Expr		   *polygon_inner_key;	/* inner geometry Var, or NULL */
+	Expr		   *polygon_inner_key_fallback;
+	/* grace hash-join properties */
+	int				inner_nparts;	/* # of hash-partitions, or 0 */
+	/* bloom-filter of this depth is applicable at the first depth */
+	bool			bloom_prefilter;
 } pgstromPlanInnerInfo;
 
 typedef struct
 {
 	uint32_t	xpu_task_flags;		/* mask of device flags */
 	int			gpu_cache_dindex;	/* device for GpuCache, if any */
+	Expr	   *gpu_cache_lookup_key;	/* point-lookup key by GpuCache hash-index */
 	const Bitmapset *gpu_direct_devs;	/* device for GPU-Direct SQL, if any */
 	const DpuStorageEntry *ds_entry;	/* target DPU if DpuJoin */
 	/* Plan information */
@@ -312,6 +374,33 @@ typedef struct
 	/* group-by parameters */
 	List	   *groupby_actions;		/* list of KAGG_ACTION__* on the kds_final */
 	int			groupby_prepfn_bufsz;	/* buffer-size for GpuPreAgg shared memory */
+	bool		groupby_complete;		/* kds_final must hold complete groups */
+	/* gpu-sort (top-K) parameters */
+	List	   *gpusort_keys;			/* sort key expressions (planner only) */
+	List	   *gpusort_resnos;			/* resno of the keys on the tlist_dev */
+	List	   *gpusort_sortops;		/* sort operators */
+	List	   *gpusort_collations;		/* collations of the sort keys */
+	List	   *gpusort_descending;		/* true, if DESC order */
+	List	   *gpusort_nulls_first;	/* true, if NULLS FIRST */
+	double		gpusort_limit;			/* bound of top-K */
+	/* LIMIT clause; stop scan once enough rows are returned */
+	double		scan_limit;				/* bound of rows, or 0 */
+	/* TABLESAMPLE clause of the outer relation */
+	uint32_t	tablesample_method;		/* one of TABLESAMPLE_METHOD__* */
+	List	   *tablesample_args;		/* arguments of the sampling method */
+	Expr	   *tablesample_repeatable;	/* REPEATABLE seed, if any */
+	/* DPU pre-filter of the outer relation, if DPU+GPU hybrid pipeline */
+	List	   *dpu_prefilter_quals;	/* scan_quals evaluated on the DPU */
+	double		dpu_prefilter_nrows;	/* estimated rows relayed to GPU */
+	bytea	   *kexp_dpu_prefilter_load_vars;
+	bytea	   *kexp_dpu_prefilter_move_vars;
+	bytea	   *kexp_dpu_prefilter_quals;
+	bytea	   *kexp_dpu_prefilter_projection;
+	List	   *dpu_prefilter_kvars_deflist;
+	uint32_t	dpu_prefilter_extra_bufsz;
+	/* factors of the cost calibration applied on planning */
+	double		cost_setup_factor;
+	double		cost_run_factor;
 	/* inner relations */
 	int			num_rels;
 	pgstromPlanInnerInfo inners[FLEXIBLE_ARRAY_MEMBER];
@@ -333,12 +422,25 @@ typedef struct
 /*
  * pgstromSharedState
  */
+#define GPUJOIN_MAX_INNER_PARTITIONS	64
+
 typedef struct
 {
 	pg_atomic_uint64	inner_nitems;
 	pg_atomic_uint64	inner_usage;
+	pg_atomic_uint64	polyidx_usage;		/* only polygon-index */
 	pg_atomic_uint64	stats_gist;			/* only GiST-index */
 	pg_atomic_uint64	stats_join;			/* # of tuples by this join */
+	/* only hash-join with hash-bucket */
+	pg_atomic_uint64	skew_nkeys;			/* # of heavy-hitter keys */
+	pg_atomic_uint64	skew_max_dups;		/* max duplications of a key */
+	/* only hash-join with direct-address map */
+	pg_atomic_uint64	dmap_key_max;		/* biased max of the join-key */
+	pg_atomic_uint64	dmap_key_min;		/* inverted biased min of the join-key */
+	pg_atomic_uint64	dmap_nslots;		/* number of slots, if built */
+	/* only grace hash-join */
+	pg_atomic_uint64	part_nitems[GPUJOIN_MAX_INNER_PARTITIONS];
+	pg_atomic_uint64	part_usage[GPUJOIN_MAX_INNER_PARTITIONS];
 } pgstromSharedInnerState;
 
 typedef struct
@@ -350,19 +452,43 @@ typedef struct
 	/* control variables to detect the last plan-node at parallel execution */
 	pg_atomic_uint32	parallel_task_control;
 	pg_atomic_uint32	__rjoin_exit_count;
+	/* GPU shared by the parallel workers (cuda_dindex + 1), or 0 */
+	pg_atomic_uint32	gpu_shared_dindex;
 	/* statistics */
 	pg_atomic_uint64	npages_direct_read;	/* read by GPU-Direct Storage */
 	pg_atomic_uint64	npages_vfs_read;	/* read from VFS layer */
 	pg_atomic_uint64	npages_buffer_read;	/* read from PG buffer */
+	pg_atomic_uint64	npages_dpucache_hit; /* found on the DPU block cache */
+	pg_atomic_uint64	dpu_prefilter_nitems; /* # of tuples relayed from DPU */
 	pg_atomic_uint64	source_ntuples_raw;	/* # of raw tuples in the base relation */
 	pg_atomic_uint64	source_ntuples_in;	/* # of tuples survived from WHERE-quals */
 	pg_atomic_uint64	result_ntuples;		/* # of tuples returned from xPU */
+	pg_atomic_uint64	result_nchunks;		/* # of chunks processed by xPU */
+	pg_atomic_uint64	time_load_usec;		/* time to load the source buffer */
+	pg_atomic_uint64	time_kernel_usec;	/* time of kernel execution */
+	pg_atomic_uint64	time_writeback_usec;/* time to move results to host */
+	pg_atomic_uint64	time_fallback_usec;	/* time of CPU fallback */
+	pg_atomic_uint64	fallback_nchunks;	/* # of chunks fallen back to CPU */
+	/* GPU-Direct reads, for EXPLAIN with pg_strom.explain_gpudirect_io */
+	pg_atomic_uint64	gpudirect_nr_ios;
+	pg_atomic_uint64	gpudirect_usec_io;
+	pg_atomic_uint64	gpudirect_usec_max;
+	pg_atomic_uint64	gpudirect_io_hist[GPUDIRECT_IO_HIST_NBUCKETS];
+	/* kernel geometry chosen by the GPU service */
+	pg_atomic_uint32	kernel_grid_sz;
+	pg_atomic_uint32	kernel_block_sz;
+	pg_atomic_uint32	kernel_shmem_sz;
+	/* for adaptive reordering of scan-quals */
+	pg_atomic_uint64	scan_quals_order;	/* the latest order by xPU */
+	pg_atomic_uint64	scan_quals_nevals[KERN_ADAPTIVE_QUALS_MAX];
+	pg_atomic_uint64	scan_quals_npassed[KERN_ADAPTIVE_QUALS_MAX];
 	/* for parallel-scan */
 	uint32_t			parallel_scan_desc_offset;
 	/* for arrow_fdw */
 	pg_atomic_uint32	arrow_rbatch_index;
 	pg_atomic_uint32	arrow_rbatch_nload;	/* # of loaded record-batches */
 	pg_atomic_uint32	arrow_rbatch_nskip;	/* # of skipped record-batches */
+	pg_atomic_uint32	arrow_rbatch_nlate;	/* # of skipped by late-materialization */
 	/* for gpu-cache */
 	pg_atomic_uint32	__gcache_fetch_count_data;
 	/* for brin-index */
@@ -376,6 +502,12 @@ typedef struct
 	int					preload_nr_setup;	/* # of setup process */
 	uint32_t			preload_shmem_handle; /* host buffer handle */
 	uint64_t			preload_shmem_length; /* host buffer length */
+	uint64_t			preload_cache_signature; /* signature if cacheable */
+	bool				preload_cache_hit;	/* buffer is in the inner cache */
+	/* for grace hash-join (protected by preload_mutex) */
+	uint32_t			inner_part_id;		/* current inner partition */
+	int					inner_part_nwaits;	/* # of process that finished
+											 * the current partition */
 	/* for join-inner relations */
 	uint32_t			num_rels;			/* if xPU-JOIN involved */
 	pgstromSharedInnerState inners[FLEXIBLE_ARRAY_MEMBER];
@@ -408,12 +540,31 @@ typedef struct
 	List		   *hash_inner_keys;    /* list of ExprState */
 	List		   *hash_outer_funcs;	/* list of devtype_hashfunc_f */
 	List		   *hash_inner_funcs;	/* list of devtype_hashfunc_f */
+	uint32_t		inner_nparts;		/* # of partitions, if grace hash-join */
+	Oid				direct_key_type;	/* type of the inner hash-key, if it is
+										 * a candidate of direct-address map */
 	/*
 	 * join properties (gist-join)
 	 */
 	Relation		gist_irel;
 	ExprState	   *gist_clause;
 	AttrNumber		gist_ctid_resno;
+	/*
+	 * join properties (grid-join)
+	 */
+	double			grid_cell_size;
+	double			grid_expand;
+	FmgrInfo		grid_fn_box3d;		/* box3d(geometry) */
+	FmgrInfo		grid_fn_extent[4];	/* st_xmin/st_ymin/st_xmax/st_ymax */
+	/*
+	 * join properties (range-join)
+	 */
+	List		   *range_inner_keys;	/* list of ExprState (lower, upper) */
+	List		   *range_inner_types;	/* list of Oid */
+	/*
+	 * polygon-index of the inner geometry
+	 */
+	ExprState	   *polygon_inner_key;
 } pgstromTaskInnerState;
 
 struct pgstromTaskState
@@ -422,7 +573,11 @@ struct pgstromTaskState
 	uint32_t			xpu_task_flags;	/* mask of device flags */
 	const Bitmapset	   *optimal_gpus;	/* candidate GPUs to connect */
 	const DpuStorageEntry *ds_entry;	/* candidate DPUs to connect */
-	XpuConnection	   *conn;
+	XpuConnection	   *conn;			/* primary connection */
+	int					num_conns;		/* number of connections */
+	XpuConnection	  **conns;			/* all the connections; if multi-GPU
+										 * mode, chunks are dispatched to
+										 * all of them */
 	pgstromSharedState *ps_state;		/* on the shared-memory segment */
 	pgstromPlanInfo	   *pp_info;
 	ArrowFdwState	   *arrow_state;
@@ -430,15 +585,45 @@ struct pgstromTaskState
 	GpuCacheDesc	   *gcache_desc;
 	pg_atomic_uint32   *gcache_fetch_count;
 	kern_multirels	   *h_kmrels;		/* host inner buffer (if JOIN) */
+	bool				inner_deferred;	/* session is opened prior to the
+										 * inner preloading */
 	const char		   *kds_pathname;	/* pathname to be used for KDS setup */
+	bool				device_mvcc;	/* xPU checks visibility of the pages
+										 * not all-visible */
+	struct zoneMapState *zm_state;		/* block ranges to be skipped */
+	bool				tablesample_ready;	/* arguments are evaluated */
+	uint32_t			tablesample_method;	/* TABLESAMPLE_METHOD__* */
+	uint32_t			tablesample_seed;
+	uint64_t			tablesample_threshold;
+	struct pgstromTaskState *dpu_prefilter; /* DPU pre-filter of the outer
+											 * relation, if any */
 	/* current chunk (already processed by the device) */
 	XpuCommand		   *curr_resp;
 	HeapTupleData		curr_htup;
 	kern_data_store	   *curr_kds;
+	bool				columnar_results; /* kds_dst is KDS_FORMAT_COLUMN */
 	int					curr_chunk;
 	int64_t				curr_index;
 	bool				scan_done;
 	bool				final_done;
+	bool				cpu_tiny_input;	/* processed by CPU without session */
+	struct xpuAsyncAppendGroup *async_group; /* siblings under Append */
+	bool				async_kicked;	/* siblings are already kicked */
+	bool				async_started;	/* started by the sibling */
+	struct pgstromResultCacheState *rc_state; /* result cache, if any */
+	bool				rc_checked;		/* result cache is already looked up */
+	uint64_t			scan_nitems_out;	/* # of rows returned by xPU */
+	bool				final_plan_pending;	/* multi-GPU; final_plan_node is
+											 * sent after the per-device ones */
+	bool				right_outer_on_device; /* RIGHT/FULL OUTER JOIN is
+												* completed by GPU, if possible */
+	/* grace hash-join; the outer relation is scanned for each partition */
+	uint32_t			num_inner_parts;
+	uint32_t			curr_inner_part;
+	/* GpuSort; top-K items of each chunk are merged on the host */
+	Tuplesortstate	   *gpusort_state;
+	TupleTableSlot	   *gpusort_slot;
+	struct gpuSortMergeState *gpusort_merge;	/* full-sort (no limit) */
 	/*
 	 * control variables to fire the end-of-task event
 	 * for RIGHT OUTER JOIN and PRE-AGG
@@ -456,6 +641,8 @@ struct pgstromTaskState
 	size_t				fallback_usage;
 	size_t				fallback_bufsz;
 	char			   *fallback_buffer;
+	Tuplestorestate	   *fallback_store;	/* spilled fallback tuples, if any */
+	TupleTableSlot	   *fallback_store_slot; /* to fetch from fallback_store */
 	TupleTableSlot	   *fallback_slot;	/* host-side kvars-slot */
 	ProjectionInfo	   *fallback_proj;	/* base or fallback slot -> custom_tlist */
 	/* request command buffer (+ status for table scan) */
@@ -522,9 +709,42 @@ extern bool		gpuDirectFileReadAsyncIOV(const char *pathname,
 										  uint32_t *p_error_code_async,
 										  uint32_t *p_npages_direct_read,
 										  uint32_t *p_npages_vfs_read);
+/*
+ * gpuDirectIOCounter - GPU-Direct reads by a GPU task; GPU service threads
+ * install it by gpuDirectSetIOCounter() while they load the source buffer.
+ */
+typedef struct
+{
+	uint32_t	nr_ios;
+	uint32_t	usec_io;
+	uint32_t	usec_max;
+	uint32_t	hist[GPUDIRECT_IO_HIST_NBUCKETS];
+} gpuDirectIOCounter;
+
+#define GPUDIRECT_IO_DRIVER__CUFILE		0
+#define GPUDIRECT_IO_DRIVER__NVME_STROM	1
+#define GPUDIRECT_IO_DRIVER__VFS		2
+#define GPUDIRECT_IO_DRIVER__NUMS		3
+/* upper bound of the k-th latency bucket, in microseconds */
+#define GPUDIRECT_IO_HIST_UPPER(k)		(1UL << ((k) + 4))
+
+static inline int
+gpuDirectIOHistBucket(uint64_t usec)
+{
+	int		k = 0;
+
+	while (k < GPUDIRECT_IO_HIST_NBUCKETS - 1 &&
+		   usec >= GPUDIRECT_IO_HIST_UPPER(k))
+		k++;
+	return k;
+}
+
+extern void		gpuDirectSetIOCounter(gpuDirectIOCounter *counter);
+extern gpuDirectIOCounter *gpuDirectGetIOCounter(void);
 extern char	   *gpuDirectGetProperty(void);
 extern void		gpuDirectSetProperty(const char *key, const char *value);
 extern void		gpuDirectCleanUpOnThreadTerminate(void);
+extern bool		gpuDirectHasNativeDriver(void);
 extern bool		gpuDirectIsAvailable(void);
 
 extern int		heterodbExtraGetError(const char **p_filename,
@@ -566,6 +786,9 @@ typedef struct
 	List	   *tlist_dev;
 	int			kvecs_ndims;
 	uint32_t	kvecs_usage;
+	List	   *cse_units;		/* top-level expressions, in evaluation order */
+	List	   *cse_entries;	/* common sub-expressions to be saved */
+	Expr	   *cse_curr_unit;	/* top-level expression currently walked */
 	Index		scan_relid;		/* depth==0 */
 	int			num_rels;
 	struct {
@@ -596,6 +819,8 @@ extern bytea   *codegen_build_packed_hashkeys(codegen_context *context,
 extern void		codegen_build_packed_gistevals(codegen_context *context,
 											   pgstromPlanInfo *pp_info);
 extern bytea   *codegen_build_projection(codegen_context *context);
+extern void		codegen_build_dpu_prefilter(PlannerInfo *root,
+											pgstromPlanInfo *pp_info);
 extern void		codegen_build_groupby_actions(codegen_context *context,
 											  pgstromPlanInfo *pp_info);
 
@@ -631,6 +856,14 @@ extern void		pgstrom_explain_xpucode(const CustomScanState *css,
 extern char	   *pgstrom_xpucode_to_string(bytea *xpu_code);
 extern void		pgstrom_init_codegen(void);
 
+/*
+ * regex_dfa.c
+ */
+extern kern_expression *pgstrom_regex_build_dfa(const char *pattern,
+												int patlen,
+												bool icase,
+												const char **p_errmsg);
+
 /*
  * brin.c
  */
@@ -661,6 +894,17 @@ extern void		pgstromBrinIndexExplain(pgstromTaskState *pts,
 										ExplainState *es);
 extern void		pgstrom_init_brin(void);
 
+/*
+ * zonemap.c
+ */
+typedef struct zoneMapState		zoneMapState;
+extern void		pgstromZoneMapExecBegin(pgstromTaskState *pts);
+extern bool		pgstromZoneMapSkipBlock(pgstromTaskState *pts,
+										BlockNumber block_num);
+extern void		pgstromZoneMapExplain(pgstromTaskState *pts,
+									  ExplainState *es);
+extern void		pgstrom_init_zonemap(void);
+
 /*
  * gist.c
  */
@@ -688,6 +932,22 @@ extern XpuCommand *pgstromRelScanChunkDirect(pgstromTaskState *pts,
 extern XpuCommand *pgstromRelScanChunkNormal(pgstromTaskState *pts,
 											 struct iovec *xcmd_iov,
 											 int *xcmd_iovcnt);
+extern bool		pgstromRelScanUringAvailable(pgstromTaskState *pts);
+extern XpuCommand *pgstromRelScanChunkUring(pgstromTaskState *pts,
+											struct iovec *xcmd_iov,
+											int *xcmd_iovcnt);
+extern XpuCommand *pgstromRelScanChunkDpuRelay(pgstromTaskState *pts,
+											   struct iovec *xcmd_iov,
+											   int *xcmd_iovcnt);
+extern uint32_t	pgstromBuildSessionXactSnapshot(pgstromTaskState *pts,
+												StringInfo buf);
+extern void		pgstromTableSampleBegin(pgstromTaskState *pts);
+extern bool		pgstromTableSampleSkipBlock(pgstromTaskState *pts,
+											BlockNumber block_num);
+extern bool		pgstromTableSampleSkipTuple(pgstromTaskState *pts,
+											ItemPointer ctid);
+extern void		pgstromRelScanFallbackBlock(pgstromTaskState *pts,
+											BlockNumber block_num);
 extern void		pgstromStoreFallbackTuple(pgstromTaskState *pts, HeapTuple tuple);
 extern TupleTableSlot *pgstromFetchFallbackTuple(pgstromTaskState *pts);
 extern void		pgstrom_init_relscan(void);
@@ -695,11 +955,99 @@ extern void		pgstrom_init_relscan(void);
 /*
  * executor.c
  */
+
+/*
+ * xpuCommandRing - a single-producer/single-consumer ring buffer on the
+ * shared memory segment, to send XpuCommands from the backend to the GPU
+ * service on the same host without the socket. The socket is still used
+ * for OpenSession, the commands larger than the ring, and the doorbell
+ * to wake up the consumer when it is sleeping on poll(2).
+ */
+typedef struct
+{
+	uint64_t	nbytes;			/* capacity of the data[] */
+	char		__padding0[PG_CACHE_LINE_SIZE - sizeof(uint64_t)];
+	pg_atomic_uint64 head;		/* written by the producer */
+	char		__padding1[PG_CACHE_LINE_SIZE - sizeof(pg_atomic_uint64)];
+	pg_atomic_uint64 tail;		/* written by the consumer */
+	pg_atomic_uint32 consumer_waiting; /* consumer is sleeping on poll(2) */
+	char		__padding2[PG_CACHE_LINE_SIZE - sizeof(pg_atomic_uint64)
+						   - sizeof(pg_atomic_uint32)];
+	char		data[FLEXIBLE_ARRAY_MEMBER];
+} xpuCommandRing;
+
+#define XPU_COMMAND_RING_NAME(namebuf,handle)					\
+	snprintf((namebuf), sizeof(namebuf), ".pgstrom_cmdring_%u_%u",	\
+			 PostPortNumber, (handle))
+
+static inline void
+__xpuCommandRingCopy(const xpuCommandRing *ring, uint64_t pos,
+					 char *dst, const char *src, size_t len, bool copy_in)
+{
+	uint64_t	off = pos % ring->nbytes;
+	size_t		sz = Min(len, ring->nbytes - off);
+	char	   *base = (char *)ring->data;
+
+	if (copy_in)
+	{
+		memcpy(base + off, src, sz);
+		if (sz < len)
+			memcpy(base, src + sz, len - sz);
+	}
+	else
+	{
+		memcpy(dst, base + off, sz);
+		if (sz < len)
+			memcpy(dst + sz, base, len - sz);
+	}
+}
+
+/*
+ * xpuResultRing - a ring buffer on the shared memory segment, to write back
+ * the response XpuCommands and the result buffers from the GPU service to
+ * the backend without the socket. The GPU service allocates a contiguous
+ * xpuResultRingItem for each response and sends only its offset using
+ * XpuCommandTag__RingResponse. The backend marks the item as released
+ * when the response is put, then advances the tail across the released
+ * items; so, responses may be released out of order.
+ */
+typedef struct
+{
+	uint64_t	nbytes;			/* capacity of the data[] */
+	char		__padding0[PG_CACHE_LINE_SIZE - sizeof(uint64_t)];
+	pg_atomic_uint64 head;		/* written by the GPU service */
+	char		__padding1[PG_CACHE_LINE_SIZE - sizeof(pg_atomic_uint64)];
+	pg_atomic_uint64 tail;		/* written by the backend */
+	char		__padding2[PG_CACHE_LINE_SIZE - sizeof(pg_atomic_uint64)];
+	char		data[FLEXIBLE_ARRAY_MEMBER];
+} xpuResultRing;
+
+typedef struct
+{
+	uint64_t	length;			/* length of the item including the header */
+	uint32_t	released;		/* already released, or padding */
+	uint32_t	__padding;
+	char		data[FLEXIBLE_ARRAY_MEMBER];	/* XpuCommand */
+} xpuResultRingItem;
+
+#define XPU_RESULT_RING_ALIGN		PG_CACHE_LINE_SIZE
+#define XPU_RESULT_RING_NAME(namebuf,handle)					\
+	snprintf((namebuf), sizeof(namebuf), ".pgstrom_resring_%u_%u",	\
+			 PostPortNumber, (handle))
+
 extern void		__xpuClientOpenSession(pgstromTaskState *pts,
 									   const XpuCommand *session,
 									   pgsocket sockfd,
 									   const char *devname,
-									   int dev_index);
+									   int dev_index,
+									   size_t cmd_ring_sz,
+									   size_t resp_ring_sz,
+									   bool poolable);
+extern bool		xpuClientReuseIdleConnection(pgstromTaskState *pts,
+											 const XpuCommand *session,
+											 const char *devname,
+											 size_t cmd_ring_sz,
+											 size_t resp_ring_sz);
 extern int
 xpuConnectReceiveCommands(pgsocket sockfd,
 						  void *(*alloc_f)(void *priv, size_t sz),
@@ -709,6 +1057,13 @@ xpuConnectReceiveCommands(pgsocket sockfd,
 extern void		xpuClientCloseSession(XpuConnection *conn);
 extern void		xpuClientSendCommand(XpuConnection *conn, const XpuCommand *xcmd);
 extern void		xpuClientPutResponse(XpuCommand *xcmd);
+extern XpuCommand *xpuClientWaitResponse(pgstromTaskState *pts);
+extern bool		pgstromDpuPreFilterNextTuple(pgstromTaskState *pts,
+											 TupleTableSlot *slot);
+extern xpuResultRing *xpuClientSetupPrivateResultRing(XpuConnection *conn,
+													  size_t resp_ring_sz,
+													  void (*release_cb)(void *arg),
+													  void *release_arg);
 extern const XpuCommand *pgstromBuildSessionInfo(pgstromTaskState *pts,
 												 uint32_t join_inner_handle,
 												 TupleDesc tdesc_final);
@@ -716,6 +1071,7 @@ extern void		pgstromExecInitTaskState(CustomScanState *node,
 										  EState *estate,
 										 int eflags);
 extern TupleTableSlot *pgstromExecTaskState(CustomScanState *node);
+extern int		pgstromTaskStateDeviceIndex(pgstromTaskState *pts);
 extern void		pgstromExecEndTaskState(CustomScanState *node);
 extern void		pgstromExecResetTaskState(CustomScanState *node);
 extern Size		pgstromSharedStateEstimateDSM(CustomScanState *node,
@@ -732,6 +1088,29 @@ extern void		pgstromExplainTaskState(CustomScanState *node,
 										ExplainState *es);
 extern void		pgstrom_init_executor(void);
 
+/*
+ * costcal.c
+ */
+extern void		pgstromCostCalibrationFactors(uint32_t xpu_task_flags,
+											  double *p_setup_factor,
+											  double *p_run_factor);
+extern void		pgstrom_init_cost_calibration(void);
+
+/*
+ * result_cache.c
+ */
+typedef struct pgstromResultCacheState	pgstromResultCacheState;
+extern pgstromResultCacheState *pgstromResultCacheBegin(pgstromTaskState *pts);
+extern bool		pgstromResultCacheIsHit(pgstromResultCacheState *rc_state);
+extern TupleTableSlot *pgstromResultCacheFetch(pgstromResultCacheState *rc_state,
+											   TupleTableSlot *slot);
+extern void		pgstromResultCacheAppend(pgstromResultCacheState *rc_state,
+										 TupleTableSlot *slot);
+extern void		pgstromResultCacheFinish(pgstromResultCacheState *rc_state,
+										 pgstromTaskState *pts);
+extern void		pgstromResultCacheEnd(pgstromResultCacheState *rc_state);
+extern void		pgstrom_init_result_cache(void);
+
 /*
  * pcie.c
  */
@@ -740,6 +1119,17 @@ extern const Bitmapset *GetOptimalGpuForRelation(Relation relation);
 extern const Bitmapset *GetOptimalGpuForBaseRel(PlannerInfo *root,
 												RelOptInfo *baserel);
 extern const char  *sysfs_read_line(const char *path);
+extern bool			GetGpuDirectStripeInfo(const char *pathname,
+										   uint32_t *p_stripe_chunk_sz,
+										   int *p_stripe_nmembers,
+										   int *p_stripe_stats_base);
+extern void			gpuDirectStripeUpdateStats(int stats_index,
+											   uint32_t nr_ios,
+											   uint64_t nr_pages,
+											   uint64_t usec_io);
+extern void			gpuDirectIOUpdateStats(dev_t st_dev, int driver,
+										   uint64_t nr_bytes,
+										   uint64_t usec_io);
 extern void			pgstrom_init_pcie(void);
 
 /*
@@ -758,6 +1148,23 @@ extern CUresult	gpuOptimalBlockSize(int *p_grid_sz,
 									CUfunction kern_function,
 									size_t dynamic_shmem_per_block,
 									size_t dynamic_shmem_per_warp);
+extern void		gpuDevBindNumaThread(int cuda_dindex);
+extern void		gpuDevBindNumaMemory(void *addr, size_t length,
+									 int cuda_dindex);
+/*
+ * Authentication of the remote GPU service: it sends a random nonce first,
+ * then the backend responds HMAC-SHA256 of the nonce by the shared secret.
+ */
+#define GPUSERV_AUTH_NONCE_LEN		32
+#define GPUSERV_AUTH_SECRET_MINLEN	16
+#define GPUSERV_AUTH_ACCEPTED		'Y'
+extern bool		gpuServiceIsRemote(void);
+extern void		gpuServiceLoadSecret(void);
+extern void		gpuServiceAuthDigest(const uint8_t *nonce, uint8_t *digest);
+extern void		gpuServiceSockAddr(const char *gucname, const char *config,
+								   int cuda_dindex, bool is_listen,
+								   struct sockaddr_storage *addr,
+								   socklen_t *p_addr_len);
 extern bool		pgstrom_init_gpu_device(void);
 
 /*
@@ -766,20 +1173,78 @@ extern bool		pgstrom_init_gpu_device(void);
 typedef struct gpuContext	gpuContext;
 typedef struct gpuClient	gpuClient;
 
+extern int		pgstrom_gpu_task_priority;
+extern int		pgstrom_gpu_quota_memory_kb;
+extern int		pgstrom_gpu_quota_tasks;
+extern int		pgstrom_gpu_quota_action;
+extern int		pgstrom_gpu_quota_wait_timeout;
+extern int		pgstrom_gpu_detoast_buffer_kb;
+extern int		pgstrom_arrow_readahead_threads;
 extern int		pgstrom_max_async_tasks(void);
+#define GPUSERV_WORKER_POOL_NATTRS	5
+extern char	   *gpuservWorkerPoolInfo(int cuda_dindex, int index,
+									  const char **p_att_name,
+									  const char **p_att_desc);
 extern const char *cuStrError(CUresult rc);
 extern bool		gpuServiceGoingTerminate(void);
+extern double	gpuServDeviceLoadScore(int cuda_dindex);
+extern uint64_t	gpuservTraceBegin(void);
+extern void		gpuservTraceEnd(const char *cat, const char *name,
+								uint64_t tv_start);
+extern bool		gpuservLinkGpuModule(CUmodule *p_cuda_module,
+									 const char *extra_ptx_image,
+									 size_t extra_ptx_length,
+									 char *emsg, size_t emsg_sz);
 extern void		gpuservBgWorkerMain(Datum arg);
 extern void		pgstrom_init_gpu_service(void);
 
+/*
+ * gpu_jit.c
+ */
+typedef struct gpuJitModule	gpuJitModule;
+
+extern bool		pgstrom_enable_gpu_jit;
+extern gpuJitModule *gpuJitGetModule(int cuda_dindex,
+									 int shmem_sz_dynamic,
+									 const kern_session_info *session,
+									 uint32_t **p_jit_entries,
+									 char *emsg, size_t emsg_sz);
+extern bool		gpuJitLookupFuncDptr(gpuJitModule *jit_module,
+									 FuncOpCode func_code,
+									 xpu_function_t *p_func_dptr);
+extern bool		gpuJitLookupTypeOper(gpuJitModule *jit_module,
+									 TypeOpCode type_code,
+									 const xpu_datum_operators **p_expr_ops);
+extern void		gpuJitApplyEntries(gpuJitModule *jit_module,
+								   kern_session_info *session,
+								   const uint32_t *jit_entries);
+extern CUmodule	gpuJitGetCudaModule(gpuJitModule *jit_module);
+extern gpuJitModule *gpuJitDupModule(gpuJitModule *jit_module);
+extern void		gpuJitPutModule(gpuJitModule *jit_module);
+extern bool		gpuJitValidateUserFunc(const char *symbol,
+									   const char *source,
+									   TypeOpCode rettype,
+									   int nargs,
+									   const TypeOpCode *argtypes,
+									   char *emsg, size_t emsg_sz);
+extern void		pgstrom_init_gpu_jit(void);
+
 /*
  * gpu_cache.c
  */
 extern void		pgstrom_init_gpu_cache(void);
 extern int		baseRelHasGpuCache(PlannerInfo *root,
 								   RelOptInfo *baserel);
+extern Expr	   *baseRelGpuCacheLookupKey(PlannerInfo *root,
+										 RelOptInfo *baserel,
+										 List *dev_quals,
+										 RestrictInfo **p_rinfo);
+extern bool		pgstromGpuCacheLookupKeyHash(pgstromTaskState *pts,
+											 Datum key, bool isnull,
+											 int *p_attnum, uint32_t *p_hash);
 extern bool		RelationHasGpuCache(Relation rel);
 extern const GpuCacheIdent *getGpuCacheDescIdent(const GpuCacheDesc *gc_desc);
+extern Bitmapset *getGpuCacheDescDevices(const GpuCacheDesc *gc_desc);
 extern GpuCacheDesc *pgstromGpuCacheExecInit(pgstromTaskState *pts);
 extern XpuCommand *pgstromScanChunkGpuCache(pgstromTaskState *pts,
 											struct iovec *xcmd_iov,
@@ -800,6 +1265,7 @@ extern void		gpucacheManagerEventLoop(int cuda_dindex,
 extern void		gpucacheManagerWakeUp(int cuda_dindex);
 
 extern void	   *gpuCacheGetDeviceBuffer(const GpuCacheIdent *ident,
+										int cuda_dindex,
 										CUdeviceptr *p_gcache_main_devptr,
 										CUdeviceptr *p_gcache_extra_devptr,
 										char *errbuf, size_t errbuf_sz);
@@ -818,6 +1284,10 @@ extern pgstromPlanInfo *buildOuterScanPlanInfo(PlannerInfo *root,
 											   bool allow_host_quals,
 											   bool allow_no_device_quals,
 											   ParamPathInfo **p_param_info);
+extern double	pgstrom_compute_scan_limit(PlannerInfo *root,
+										   RelOptInfo *rel,
+										   const pgstromPlanInfo *pp_info,
+										   const Path *best_path);
 extern bool		ExecFallbackCpuScan(pgstromTaskState *pts,
 									HeapTuple tuple);
 extern void		gpuservHandleGpuScanExec(gpuClient *gclient, XpuCommand *xcmd);
@@ -842,18 +1312,35 @@ extern CustomScan *PlanXpuJoinPathCommon(PlannerInfo *root,
 										 pgstromPlanInfo *pp_info,
 										 const CustomScanMethods *methods);
 extern uint32_t	GpuJoinInnerPreload(pgstromTaskState *pts);
+extern bool		GpuJoinInnerCacheLookup(pgstromTaskState *pts,
+										pgstromSharedState *ps_state);
+extern void		GpuJoinInnerCacheRelease(pgstromTaskState *pts,
+										 pgstromSharedState *ps_state);
 extern bool		ExecFallbackCpuJoin(pgstromTaskState *pts,
 									HeapTuple tuple);
 extern void		ExecFallbackCpuJoinRightOuter(pgstromTaskState *pts);
+extern bool		GpuJoinRightOuterOnDevice(pgstromTaskState *pts);
 extern void		ExecFallbackCpuJoinOuterJoinMap(pgstromTaskState *pts,
 												XpuCommand *resp);
 extern void		pgstrom_init_gpu_join(void);
 extern void		pgstrom_init_dpu_join(void);
 
+/*
+ * gpu_sort.c
+ */
+extern CustomPath *buildGpuSortPath(PlannerInfo *root,
+									RelOptInfo *rel,
+									const CustomPath *cpath);
+extern void		gpusort_build_tlist_dev(pgstromPlanInfo *pp_info,
+										List *tlist_dev);
+extern void		pgstrom_init_gpu_sort(void);
+
 /*
  * gpu_preagg.c
  */
 extern int		pgstrom_hll_register_bits;
+extern int		pgstrom_gpupreagg_max_final_buffer_size;
+extern bool		pgstrom_enable_gpupreagg_sorted_run;
 extern void		xpupreagg_add_custompath(PlannerInfo *root,
 										 RelOptInfo *input_rel,
 										 RelOptInfo *group_rel,
@@ -865,6 +1352,11 @@ extern bool		ExecFallbackCpuPreAgg(pgstromTaskState *pts,
 extern void		pgstrom_init_gpu_preagg(void);
 extern void		pgstrom_init_dpu_preagg(void);
 
+/*
+ * gpu_analyze.c
+ */
+extern void		pgstrom_init_gpu_analyze(void);
+
 /*
  * arrow_fdw.c and arrow_read.c
  */
@@ -882,6 +1374,8 @@ extern XpuCommand *pgstromScanChunkArrowFdw(pgstromTaskState *pts,
 											int *xcmd_iovcnt);
 extern void		pgstromArrowFdwExecEnd(ArrowFdwState *arrow_state);
 extern void		pgstromArrowFdwExecReset(ArrowFdwState *arrow_state);
+extern bool		pgstromArrowFdwFileSignature(ArrowFdwState *arrow_state,
+											 uint64_t *p_signature);
 extern void		pgstromArrowFdwInitDSM(ArrowFdwState *arrow_state,
 									   pgstromSharedState *ps_state);
 extern void		pgstromArrowFdwAttachDSM(ArrowFdwState *arrow_state,
@@ -897,6 +1391,77 @@ extern bool		kds_arrow_fetch_tuple(TupleTableSlot *slot,
 									  const Bitmapset *referenced);
 extern void pgstrom_init_arrow_fdw(void);
 
+/*
+ * objstore.c
+ */
+extern bool		pgstromObjStoreIsURL(const char *pathname);
+extern const char *pgstromObjStoreOpenObject(const char *url);
+extern bool		pgstromObjStoreIsCacheFile(const char *filename);
+extern void		pgstromObjStoreFetchRanges(const char *filename,
+										   int nranges,
+										   const off_t *offsets,
+										   const size_t *lengths,
+										   bool wait);
+extern void		pgstrom_init_objstore(void);
+
+/*
+ * arrow_stream.c
+ */
+extern const char *pgstromArrowStreamSpoolDir(const char *source);
+extern List	   *pgstromArrowStreamShmemFiles(List *filesList,
+											 const char *source,
+											 const char *spool_dir);
+extern void		pgstrom_init_arrow_stream(void);
+
+/*
+ * parquet_read.c
+ */
+typedef struct ParquetColumnChunk
+{
+	int32_t		physical_type;	/* parquet physical Type */
+	int32_t		codec;			/* parquet CompressionCodec */
+	int32_t		max_def_level;	/* 0 = REQUIRED, 1 = OPTIONAL */
+	int32_t		type_length;	/* only FIXED_LEN_BYTE_ARRAY */
+	int64_t		num_values;
+	int64_t		null_count;		/* -1, if unknown */
+	int64_t		chunk_offset;	/* head of the dictionary/data pages */
+	int64_t		chunk_length;	/* total_compressed_size */
+	/* min/max statistics (only while readParquetFileDesc) */
+	const char *min_value;
+	const char *max_value;
+	int32_t		min_len;
+	int32_t		max_len;
+} ParquetColumnChunk;
+
+typedef struct ParquetRowGroup
+{
+	int64_t		num_rows;
+	int			num_columns;
+	ParquetColumnChunk *columns;
+} ParquetRowGroup;
+
+typedef struct ParquetFileInfo
+{
+	const char *filename;
+	struct stat	stat_buf;
+	ArrowSchema	schema;			/* equivalent Arrow schema */
+	int			num_row_groups;
+	ParquetRowGroup *row_groups;
+} ParquetFileInfo;
+
+extern bool		fileIsParquet(int fdesc);
+extern void		readParquetFileDesc(int fdesc, const char *filename,
+									ParquetFileInfo *pq_info);
+extern void		parquetDecodeColumnChunk(const ParquetColumnChunk *pq_chunk,
+										 const ArrowTypeOptions *attopts,
+										 const char *chunk, size_t chunk_len,
+										 int64_t nrows,
+										 StringInfo nullmap,
+										 StringInfo values,
+										 StringInfo extra,
+										 int64_t *p_null_count,
+										 const char *filename);
+
 /*
  * dpu_device.c
  */
@@ -905,7 +1470,16 @@ extern double	pgstrom_dpu_operator_cost;
 extern double	pgstrom_dpu_seq_page_cost;
 extern double	pgstrom_dpu_tuple_cost;
 extern bool		pgstrom_dpu_handle_cached_pages;
+extern int		pgstrom_dpu_result_codec;
+extern bool		pgstrom_enable_dpu_prefilter;
 extern double	pgstrom_dpu_operator_ratio(void);
+extern List	   *pgstromTryDpuPreFilter(PlannerInfo *root,
+									   RelOptInfo *baserel,
+									   List *dev_quals,
+									   double parallel_divisor,
+									   Cost *p_startup_cost,
+									   Cost *p_run_cost,
+									   double *p_nrows);
 
 extern const DpuStorageEntry *GetOptimalDpuForFile(const char *filename,
 												   const char **p_dpu_pathname);
@@ -928,6 +1502,9 @@ extern bool		pgstrom_init_dpu_device(void);
 /*
  * misc.c
  */
+extern AppendRelInfo **find_appinfos_by_relids_nofail(PlannerInfo *root,
+													  Relids relids,
+													  int *nappinfos);
 extern void		form_pgstrom_plan_info(CustomScan *cscan, pgstromPlanInfo *pp_info);
 extern pgstromPlanInfo *deform_pgstrom_plan_info(CustomScan *cscan);
 extern pgstromPlanInfo *copy_pgstrom_plan_info(const pgstromPlanInfo *pp_orig);
@@ -951,12 +1528,25 @@ extern ssize_t	__preadFile(int fdesc, void *buffer, size_t nbytes, off_t f_pos);
 extern ssize_t	__writeFile(int fdesc, const void *buffer, size_t nbytes);
 extern ssize_t	__pwriteFile(int fdesc, const void *buffer, size_t nbytes, off_t f_pos);
 
+#define SHMEM_HUGE_PAGES__OFF			0
+#define SHMEM_HUGE_PAGES__TRANSPARENT	1
+#define SHMEM_HUGE_PAGES__HUGETLB		2
+extern int		pgstrom_shmem_huge_pages;	/* GUC */
+extern const char *__shmemPathName(char *namebuf, size_t namebuf_sz,
+								   uint32_t shmem_handle,
+								   const DpuStorageEntry *ds_entry);
+extern size_t	__shmemAlignSize(size_t length);
+extern void		__shmemAdviseHugePages(void *addr, size_t length);
 extern uint32_t	__shmemCreate(const DpuStorageEntry *ds_entry);
 extern void		__shmemDrop(uint32_t shmem_handle);
+extern void		__shmemDetach(uint32_t shmem_handle);
+extern void		__shmemUnlink(uint32_t shmem_handle,
+							  const DpuStorageEntry *ds_entry);
 extern void	   *__mmapShmem(uint32_t shmem_handle,
 							size_t shmem_length,
 							const DpuStorageEntry *ds_entry);
 extern bool		__munmapShmem(void *mmap_addr);
+extern void		pgstrom_init_shmem_options(void);
 
 extern Path	   *pgstrom_copy_pathnode(const Path *pathnode);
 
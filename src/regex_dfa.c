@@ -0,0 +1,943 @@
+/*
+ * regex_dfa.c
+ *
+ * Regular expression compiler to DFA for the device side pattern match
+ * ----
+ * Copyright 2011-2023 (C) KaiGai Kohei <kaigai@kaigai.gr.jp>
+ * Copyright 2014-2023 (C) PG-Strom Developers Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the PostgreSQL License.
+ */
+#include "pg_strom.h"
+
+/*
+ * It supports a subset of the PostgreSQL's advanced regular expression (ARE);
+ * literals, '.', bracket expressions (including character classes), class
+ * shorthand escapes (\d, \s, \w and negated ones), anchors, grouping,
+ * alternation and quantifiers. The pattern is parsed to AST, then translated
+ * to NFA by Thompson's construction, and finally to DFA by the subset
+ * construction with the implicit search loop.
+ * Patterns that are not supported (back references, lookaround constraints,
+ * embedded options, non-ASCII characters in the pattern, ...) or invalid
+ * are rejected, then CPU evaluates them with the exact semantics.
+ */
+#define RE_MAX_NFA_STATES		4096
+#define RE_MAX_REPEAT			255		/* same as RE_DUP_MAX */
+
+#define RE_NONASCII__NOMATCH	0
+#define RE_NONASCII__MATCH		1
+#define RE_NONASCII__UNKNOWN	2		/* depends on the locale */
+
+typedef struct
+{
+	uint64_t	map[2];			/* bitmap of 7bit ASCII characters */
+	int			nonascii;		/* one of RE_NONASCII__* */
+} re_charset;
+
+typedef enum
+{
+	RE_NODE__EMPTY,
+	RE_NODE__CHARSET,
+	RE_NODE__CONCAT,
+	RE_NODE__ALTER,
+	RE_NODE__REPEAT,
+	RE_NODE__BOL,
+	RE_NODE__EOL,
+} re_node_tag;
+
+typedef struct re_node
+{
+	re_node_tag	tag;
+	int			cset_id;		/* CHARSET */
+	struct re_node *left;		/* CONCAT, ALTER, REPEAT */
+	struct re_node *right;		/* CONCAT, ALTER */
+	int			min;			/* REPEAT */
+	int			max;			/* REPEAT; negative means infinite */
+} re_node;
+
+typedef enum
+{
+	RE_NFA__CHAR,
+	RE_NFA__SPLIT,
+	RE_NFA__BOL,
+	RE_NFA__EOL,
+	RE_NFA__MATCH,
+} re_nfa_tag;
+
+typedef struct
+{
+	re_nfa_tag	tag;
+	int			cset_id;		/* CHAR */
+	int			out1;
+	int			out2;			/* SPLIT */
+} re_nfa_state;
+
+typedef struct
+{
+	const char *pattern;
+	int			patlen;
+	int			pos;
+	bool		icase;
+	const char *errmsg;
+	/* charsets */
+	re_charset *csets;
+	int			ncsets;
+	int			nrooms_csets;
+	/* NFA */
+	re_nfa_state *nfa;
+	int			nfa_nstates;
+} re_compile_state;
+
+#define __re_unsupported(rcs,msg)			\
+	do {									\
+		if (!(rcs)->errmsg)					\
+			(rcs)->errmsg = (msg);			\
+		return NULL;						\
+	} while(0)
+
+#define re_eof(rcs)		((rcs)->pos >= (rcs)->patlen)
+#define re_peek(rcs)	(re_eof(rcs) ? -1 : (int)((uint8_t)(rcs)->pattern[(rcs)->pos]))
+#define re_peek_next(rcs)								\
+	((rcs)->pos + 1 >= (rcs)->patlen ? -1				\
+	 : (int)((uint8_t)(rcs)->pattern[(rcs)->pos + 1]))
+
+static re_node *re_parse_regex(re_compile_state *rcs);
+
+/*
+ * charset routines
+ */
+static inline void
+re_cset_add(re_charset *cs, int c)
+{
+	Assert(c >= 0 && c < 128);
+	cs->map[c >> 6] |= (1UL << (c & 63));
+}
+
+static inline bool
+re_cset_test(const re_charset *cs, int c)
+{
+	Assert(c >= 0 && c < 128);
+	return (cs->map[c >> 6] & (1UL << (c & 63))) != 0;
+}
+
+static int
+re_new_charset(re_compile_state *rcs)
+{
+	if (rcs->ncsets >= rcs->nrooms_csets)
+	{
+		rcs->nrooms_csets = 2 * rcs->nrooms_csets + 20;
+		if (!rcs->csets)
+			rcs->csets = palloc(sizeof(re_charset) * rcs->nrooms_csets);
+		else
+			rcs->csets = repalloc(rcs->csets,
+								  sizeof(re_charset) * rcs->nrooms_csets);
+	}
+	memset(&rcs->csets[rcs->ncsets], 0, sizeof(re_charset));
+	return rcs->ncsets++;
+}
+
+static bool
+re_cset_add_class(re_charset *cs, const char *cname, int cname_len,
+				  bool *p_has_class)
+{
+	int		c;
+
+	if (cname_len == 5 && strncmp(cname, "ascii", 5) == 0)
+	{
+		/* not locale dependent */
+		for (c=0; c < 128; c++)
+			re_cset_add(cs, c);
+		return true;
+	}
+#define __CLASS_CASE(NAME,COND)								\
+	if (cname_len == strlen(NAME) &&						\
+		strncmp(cname, NAME, cname_len) == 0)				\
+	{														\
+		for (c=0; c < 128; c++)								\
+		{													\
+			if (COND)										\
+				re_cset_add(cs, c);							\
+		}													\
+		*p_has_class = true;								\
+		return true;										\
+	}
+	__CLASS_CASE("alpha",  isalpha(c))
+	__CLASS_CASE("digit",  isdigit(c))
+	__CLASS_CASE("alnum",  isalnum(c))
+	__CLASS_CASE("word",   isalnum(c) || c == '_')
+	__CLASS_CASE("upper",  isupper(c))
+	__CLASS_CASE("lower",  islower(c))
+	__CLASS_CASE("space",  isspace(c))
+	__CLASS_CASE("blank",  c == ' ' || c == '\t')
+	__CLASS_CASE("punct",  ispunct(c))
+	__CLASS_CASE("xdigit", isxdigit(c))
+	__CLASS_CASE("print",  isprint(c))
+	__CLASS_CASE("graph",  isgraph(c))
+	__CLASS_CASE("cntrl",  iscntrl(c))
+#undef __CLASS_CASE
+	return false;
+}
+
+/*
+ * re_cset_finish
+ *
+ * It applies case folding and negation, then determines whether non-ASCII
+ * characters match the charset. Character classes and case folding may
+ * match non-ASCII characters according to the locale, so the device cannot
+ * determine it (e.g, U+212A KELVIN SIGN is folded to 'k').
+ */
+static void
+re_cset_finish(re_compile_state *rcs, re_charset *cs,
+			   bool negated, bool has_class)
+{
+	bool	unknown = has_class;
+	int		c;
+
+	if (rcs->icase)
+	{
+		for (c='A'; c <= 'Z'; c++)
+		{
+			int		l = c + ('a' - 'A');
+
+			if (re_cset_test(cs, c) || re_cset_test(cs, l))
+			{
+				re_cset_add(cs, c);
+				re_cset_add(cs, l);
+				if (c == 'I' || c == 'K' || c == 'S')
+					unknown = true;
+			}
+		}
+	}
+	if (negated)
+	{
+		cs->map[0] = ~cs->map[0];
+		cs->map[1] = ~cs->map[1];
+		cs->nonascii = (unknown ? RE_NONASCII__UNKNOWN : RE_NONASCII__MATCH);
+	}
+	else
+	{
+		cs->nonascii = (unknown ? RE_NONASCII__UNKNOWN : RE_NONASCII__NOMATCH);
+	}
+}
+
+/*
+ * parser routines
+ */
+static re_node *
+re_make_node(re_node_tag tag, re_node *left, re_node *right)
+{
+	re_node	   *node = palloc0(sizeof(re_node));
+
+	node->tag = tag;
+	node->left = left;
+	node->right = right;
+	return node;
+}
+
+static re_node *
+re_make_charset_node(int cset_id)
+{
+	re_node	   *node = re_make_node(RE_NODE__CHARSET, NULL, NULL);
+
+	node->cset_id = cset_id;
+	return node;
+}
+
+static re_node *
+re_make_literal(re_compile_state *rcs, int c)
+{
+	int		cset_id = re_new_charset(rcs);
+
+	re_cset_add(&rcs->csets[cset_id], c);
+	re_cset_finish(rcs, &rcs->csets[cset_id], false, false);
+	return re_make_charset_node(cset_id);
+}
+
+static re_node *
+re_make_class_escape(re_compile_state *rcs, int c)
+{
+	int		cset_id = re_new_charset(rcs);
+	re_charset *cs = &rcs->csets[cset_id];
+	bool	has_class = false;
+
+	switch (c)
+	{
+		case 'd':
+		case 'D':
+			re_cset_add_class(cs, "digit", 5, &has_class);
+			break;
+		case 's':
+		case 'S':
+			re_cset_add_class(cs, "space", 5, &has_class);
+			break;
+		default:	/* 'w' or 'W' */
+			re_cset_add_class(cs, "word", 4, &has_class);
+			break;
+	}
+	re_cset_finish(rcs, cs, isupper(c), has_class);
+	return re_make_charset_node(cset_id);
+}
+
+/*
+ * re_escape_char - it returns the character of the escape, or -1
+ */
+static int
+re_escape_char(int c)
+{
+	switch (c)
+	{
+		case 'a':	return '\007';
+		case 'e':	return '\033';
+		case 'f':	return '\f';
+		case 'n':	return '\n';
+		case 'r':	return '\r';
+		case 't':	return '\t';
+		case 'v':	return '\v';
+		default:
+			break;
+	}
+	/* back-references, constraint escapes, \x, \u, ... */
+	if (c >= 0x80 || isalnum(c))
+		return -1;
+	return c;
+}
+
+static re_node *
+re_parse_bracket(re_compile_state *rcs)
+{
+	int			cset_id = re_new_charset(rcs);
+	re_charset *cs = &rcs->csets[cset_id];
+	bool		negated = false;
+	bool		has_class = false;
+	bool		first = true;
+
+	Assert(re_peek(rcs) == '[');
+	rcs->pos++;
+	if (re_peek(rcs) == '^')
+	{
+		negated = true;
+		rcs->pos++;
+	}
+	for (;;)
+	{
+		int		c = re_peek(rcs);
+		int		lo, hi;
+
+		if (c < 0)
+			__re_unsupported(rcs, "unterminated bracket expression");
+		if (c == ']' && !first)
+		{
+			rcs->pos++;
+			break;
+		}
+		first = false;
+
+		if (c == '[' && re_peek_next(rcs) == ':')
+		{
+			const char *cname = rcs->pattern + rcs->pos + 2;
+			const char *tail = NULL;
+			int			i;
+
+			for (i = rcs->pos + 2; i + 1 < rcs->patlen; i++)
+			{
+				if (rcs->pattern[i] == ':' && rcs->pattern[i+1] == ']')
+				{
+					tail = rcs->pattern + i;
+					break;
+				}
+			}
+			if (!tail || !re_cset_add_class(cs, cname, tail - cname,
+											&has_class))
+				__re_unsupported(rcs, "unknown character class");
+			rcs->pos = (tail - rcs->pattern) + 2;
+			continue;
+		}
+		else if (c == '[' && (re_peek_next(rcs) == '.' ||
+							  re_peek_next(rcs) == '='))
+			__re_unsupported(rcs, "collating elements are not supported");
+		else if (c == '\\')
+		{
+			rcs->pos++;
+			c = re_peek(rcs);
+			if (c == 'd' || c == 's' || c == 'w')
+			{
+				re_cset_add_class(cs, (c == 'd' ? "digit" :
+									   c == 's' ? "space" : "word"),
+								  (c == 'w' ? 4 : 5), &has_class);
+				rcs->pos++;
+				continue;
+			}
+			if (c < 0 || (lo = re_escape_char(c)) < 0)
+				__re_unsupported(rcs, "unsupported escape in bracket expression");
+			rcs->pos++;
+		}
+		else if (c >= 0x80)
+			__re_unsupported(rcs, "non-ASCII characters in the pattern");
+		else
+		{
+			lo = c;
+			rcs->pos++;
+		}
+
+		/* character range */
+		if (re_peek(rcs) == '-' &&
+			re_peek_next(rcs) >= 0 &&
+			re_peek_next(rcs) != ']')
+		{
+			rcs->pos++;
+			c = re_peek(rcs);
+			if (c == '[' || c >= 0x80)
+				__re_unsupported(rcs, "unsupported range end");
+			if (c == '\\')
+			{
+				rcs->pos++;
+				c = re_peek(rcs);
+				if (c < 0 || (hi = re_escape_char(c)) < 0)
+					__re_unsupported(rcs, "unsupported escape in bracket expression");
+			}
+			else
+				hi = c;
+			rcs->pos++;
+			if (hi < lo)
+				__re_unsupported(rcs, "invalid character range");
+			for (c = lo; c <= hi; c++)
+				re_cset_add(cs, c);
+		}
+		else
+			re_cset_add(cs, lo);
+	}
+	re_cset_finish(rcs, cs, negated, has_class);
+	return re_make_charset_node(cset_id);
+}
+
+static re_node *
+re_parse_atom(re_compile_state *rcs)
+{
+	re_node	   *node;
+	int			c = re_peek(rcs);
+
+	switch (c)
+	{
+		case '(':
+			rcs->pos++;
+			if (re_peek(rcs) == '?')
+			{
+				/* only non-capturing group is supported */
+				if (re_peek_next(rcs) != ':')
+					__re_unsupported(rcs, "lookaround constraints or embedded options");
+				rcs->pos += 2;
+			}
+			node = re_parse_regex(rcs);
+			if (!node)
+				return NULL;
+			if (re_peek(rcs) != ')')
+				__re_unsupported(rcs, "unbalanced parenthesis");
+			rcs->pos++;
+			return node;
+
+		case '.':
+			{
+				int		cset_id = re_new_charset(rcs);
+
+				rcs->pos++;
+				rcs->csets[cset_id].map[0] = ~0UL;
+				rcs->csets[cset_id].map[1] = ~0UL;
+				rcs->csets[cset_id].nonascii = RE_NONASCII__MATCH;
+				return re_make_charset_node(cset_id);
+			}
+		case '[':
+			return re_parse_bracket(rcs);
+
+		case '^':
+			rcs->pos++;
+			return re_make_node(RE_NODE__BOL, NULL, NULL);
+
+		case '$':
+			rcs->pos++;
+			return re_make_node(RE_NODE__EOL, NULL, NULL);
+
+		case '\\':
+			rcs->pos++;
+			c = re_peek(rcs);
+			if (c < 0)
+				__re_unsupported(rcs, "trailing backslash");
+			rcs->pos++;
+			if (c == 'd' || c == 'D' ||
+				c == 's' || c == 'S' ||
+				c == 'w' || c == 'W')
+				return re_make_class_escape(rcs, c);
+			if (c == 'A')
+				return re_make_node(RE_NODE__BOL, NULL, NULL);
+			if (c == 'Z')
+				return re_make_node(RE_NODE__EOL, NULL, NULL);
+			if ((c = re_escape_char(c)) < 0)
+				__re_unsupported(rcs, "unsupported escape");
+			return re_make_literal(rcs, c);
+
+		case ')':
+			__re_unsupported(rcs, "unbalanced parenthesis");
+
+		case '*':
+		case '+':
+		case '?':
+			__re_unsupported(rcs, "quantifier operand invalid");
+
+		case '{':
+			if (isdigit(re_peek_next(rcs)))
+				__re_unsupported(rcs, "quantifier operand invalid");
+			rcs->pos++;
+			return re_make_literal(rcs, c);
+
+		default:
+			if (c >= 0x80)
+				__re_unsupported(rcs, "non-ASCII characters in the pattern");
+			rcs->pos++;
+			return re_make_literal(rcs, c);
+	}
+}
+
+static bool
+re_parse_number(re_compile_state *rcs, int *p_value)
+{
+	int		value = 0;
+	int		c;
+
+	if (!isdigit(re_peek(rcs)))
+		return false;
+	while ((c = re_peek(rcs)) >= 0 && isdigit(c))
+	{
+		value = 10 * value + (c - '0');
+		if (value > RE_MAX_REPEAT)
+			return false;
+		rcs->pos++;
+	}
+	*p_value = value;
+	return true;
+}
+
+static re_node *
+re_parse_piece(re_compile_state *rcs)
+{
+	re_node	   *atom;
+	re_node	   *node;
+	int			c, min, max;
+
+	atom = re_parse_atom(rcs);
+	if (!atom)
+		return NULL;
+	c = re_peek(rcs);
+	if (c == '*')
+	{
+		min = 0;
+		max = -1;
+		rcs->pos++;
+	}
+	else if (c == '+')
+	{
+		min = 1;
+		max = -1;
+		rcs->pos++;
+	}
+	else if (c == '?')
+	{
+		min = 0;
+		max = 1;
+		rcs->pos++;
+	}
+	else if (c == '{' && isdigit(re_peek_next(rcs)))
+	{
+		rcs->pos++;
+		if (!re_parse_number(rcs, &min))
+			__re_unsupported(rcs, "invalid repetition count");
+		max = min;
+		if (re_peek(rcs) == ',')
+		{
+			rcs->pos++;
+			if (re_peek(rcs) == '}')
+				max = -1;
+			else if (!re_parse_number(rcs, &max) || max < min)
+				__re_unsupported(rcs, "invalid repetition count");
+		}
+		if (re_peek(rcs) != '}')
+			__re_unsupported(rcs, "invalid repetition count");
+		rcs->pos++;
+	}
+	else
+		return atom;
+
+	if (atom->tag == RE_NODE__BOL || atom->tag == RE_NODE__EOL)
+		__re_unsupported(rcs, "quantifier on the anchor");
+	/* non-greedy quantifier does not affect to match or not */
+	if (re_peek(rcs) == '?')
+		rcs->pos++;
+	c = re_peek(rcs);
+	if (c == '*' || c == '+' || c == '?' ||
+		(c == '{' && isdigit(re_peek_next(rcs))))
+		__re_unsupported(rcs, "quantifier operand invalid");
+
+	node = re_make_node(RE_NODE__REPEAT, atom, NULL);
+	node->min = min;
+	node->max = max;
+	return node;
+}
+
+static re_node *
+re_parse_branch(re_compile_state *rcs)
+{
+	re_node	   *node = re_make_node(RE_NODE__EMPTY, NULL, NULL);
+	int			c;
+
+	while ((c = re_peek(rcs)) >= 0 && c != '|' && c != ')')
+	{
+		re_node	   *piece = re_parse_piece(rcs);
+
+		if (!piece)
+			return NULL;
+		if (node->tag == RE_NODE__EMPTY)
+			node = piece;
+		else
+			node = re_make_node(RE_NODE__CONCAT, node, piece);
+	}
+	return node;
+}
+
+static re_node *
+re_parse_regex(re_compile_state *rcs)
+{
+	re_node	   *node;
+
+	node = re_parse_branch(rcs);
+	while (node && re_peek(rcs) == '|')
+	{
+		re_node	   *right;
+
+		rcs->pos++;
+		right = re_parse_branch(rcs);
+		if (!right)
+			return NULL;
+		node = re_make_node(RE_NODE__ALTER, node, right);
+	}
+	return node;
+}
+
+/*
+ * NFA construction
+ *
+ * It builds the NFA backward; each node is translated with the NFA state to
+ * be continued, then returns the entry state of the node.
+ */
+static int
+re_nfa_new(re_compile_state *rcs, re_nfa_tag tag,
+		   int cset_id, int out1, int out2)
+{
+	re_nfa_state *ns;
+
+	if (rcs->nfa_nstates >= RE_MAX_NFA_STATES)
+	{
+		if (!rcs->errmsg)
+			rcs->errmsg = "too many NFA states";
+		return -1;
+	}
+	ns = &rcs->nfa[rcs->nfa_nstates];
+	ns->tag = tag;
+	ns->cset_id = cset_id;
+	ns->out1 = out1;
+	ns->out2 = out2;
+	return rcs->nfa_nstates++;
+}
+
+static int
+re_build_nfa(re_compile_state *rcs, re_node *node, int next)
+{
+	int		s, body, loop, i;
+
+	if (next < 0)
+		return -1;
+	switch (node->tag)
+	{
+		case RE_NODE__EMPTY:
+			return next;
+		case RE_NODE__CHARSET:
+			return re_nfa_new(rcs, RE_NFA__CHAR, node->cset_id, next, -1);
+		case RE_NODE__BOL:
+			return re_nfa_new(rcs, RE_NFA__BOL, -1, next, -1);
+		case RE_NODE__EOL:
+			return re_nfa_new(rcs, RE_NFA__EOL, -1, next, -1);
+		case RE_NODE__CONCAT:
+			s = re_build_nfa(rcs, node->right, next);
+			return re_build_nfa(rcs, node->left, s);
+		case RE_NODE__ALTER:
+			s = re_build_nfa(rcs, node->left, next);
+			body = re_build_nfa(rcs, node->right, next);
+			if (s < 0 || body < 0)
+				return -1;
+			return re_nfa_new(rcs, RE_NFA__SPLIT, -1, s, body);
+		case RE_NODE__REPEAT:
+			s = next;
+			if (node->max < 0)
+			{
+				/* X* */
+				loop = re_nfa_new(rcs, RE_NFA__SPLIT, -1, -1, next);
+				if (loop < 0)
+					return -1;
+				body = re_build_nfa(rcs, node->left, loop);
+				if (body < 0)
+					return -1;
+				rcs->nfa[loop].out1 = body;
+				s = loop;
+			}
+			else
+			{
+				/* (X(X)?)? for the optional portion */
+				for (i = node->min; i < node->max; i++)
+				{
+					body = re_build_nfa(rcs, node->left, s);
+					if (body < 0)
+						return -1;
+					s = re_nfa_new(rcs, RE_NFA__SPLIT, -1, body, next);
+					if (s < 0)
+						return -1;
+				}
+			}
+			for (i=0; i < node->min; i++)
+			{
+				s = re_build_nfa(rcs, node->left, s);
+				if (s < 0)
+					return -1;
+			}
+			return s;
+		default:
+			elog(ERROR, "unknown regex node tag: %d", (int)node->tag);
+	}
+	return -1;
+}
+
+static Bitmapset *
+re_nfa_closure(re_compile_state *rcs, Bitmapset *nfa_set,
+			   bool allow_bol, bool allow_eol)
+{
+	Bitmapset  *result = NULL;
+	int		   *stack = palloc(sizeof(int) * rcs->nfa_nstates);
+	int			depth = 0;
+	int			s = -1;
+
+	while ((s = bms_next_member(nfa_set, s)) >= 0)
+	{
+		if (!bms_is_member(s, result))
+		{
+			result = bms_add_member(result, s);
+			stack[depth++] = s;
+		}
+	}
+	while (depth > 0)
+	{
+		re_nfa_state *ns = &rcs->nfa[stack[--depth]];
+		int		next[2];
+		int		i, n = 0;
+
+		if (ns->tag == RE_NFA__SPLIT)
+		{
+			next[n++] = ns->out1;
+			next[n++] = ns->out2;
+		}
+		else if ((ns->tag == RE_NFA__BOL && allow_bol) ||
+				 (ns->tag == RE_NFA__EOL && allow_eol))
+			next[n++] = ns->out1;
+
+		for (i=0; i < n; i++)
+		{
+			if (!bms_is_member(next[i], result))
+			{
+				result = bms_add_member(result, next[i]);
+				stack[depth++] = next[i];
+			}
+		}
+	}
+	pfree(stack);
+	return result;
+}
+
+/*
+ * pgstrom_regex_build_dfa
+ *
+ * It compiles the regular expression pattern to DFA, and returns the header
+ * portion of kern_expression (up to the args_offset) that contains
+ * the DFA. Elsewhere, it returns NULL with the reason in *p_errmsg.
+ */
+kern_expression *
+pgstrom_regex_build_dfa(const char *pattern, int patlen, bool icase,
+						const char **p_errmsg)
+{
+	re_compile_state rcs;
+	re_node	   *root;
+	int			match_id;
+	int			start_id;
+	Bitmapset  *restart;
+	Bitmapset **dfa_sets;
+	uint32	   *dfa_hashes;
+	uint8_t	   *dfa_flags;
+	uint16_t   *dfa_trans;
+	int			dfa_nstates;
+	uint8_t		symclass[KERN_REGEX_NSYMBOLS];
+	int			class_sym[KERN_REGEX_NSYMBOLS];
+	int			nclasses = 0;
+	kern_expression *kexp;
+	size_t		trans_offset;
+	size_t		sz;
+	int			i, j, k, c;
+
+	memset(&rcs, 0, sizeof(re_compile_state));
+	rcs.pattern = pattern;
+	rcs.patlen = patlen;
+	rcs.icase = icase;
+
+	/* parse the pattern */
+	root = re_parse_regex(&rcs);
+	if (root && !re_eof(&rcs))
+	{
+		root = NULL;
+		rcs.errmsg = "unbalanced parenthesis";
+	}
+	if (!root)
+		goto unsupported;
+
+	/* build NFA */
+	rcs.nfa = palloc(sizeof(re_nfa_state) * RE_MAX_NFA_STATES);
+	match_id = re_nfa_new(&rcs, RE_NFA__MATCH, -1, -1, -1);
+	start_id = re_build_nfa(&rcs, root, match_id);
+	if (start_id < 0)
+		goto unsupported;
+
+	/* equivalent classes of the input symbols */
+	for (c=0; c < 128; c++)
+	{
+		for (k=0; k < nclasses; k++)
+		{
+			int		x = class_sym[k];
+
+			for (i=0; i < rcs.ncsets; i++)
+			{
+				if (re_cset_test(&rcs.csets[i], c) !=
+					re_cset_test(&rcs.csets[i], x))
+					break;
+			}
+			if (i == rcs.ncsets)
+				break;
+		}
+		if (k == nclasses)
+			class_sym[nclasses++] = c;
+		symclass[c] = k;
+	}
+	class_sym[nclasses] = KERN_REGEX_SYMBOL__NONASCII;
+	symclass[KERN_REGEX_SYMBOL__NONASCII] = nclasses++;
+
+	/* subset construction */
+	dfa_sets = palloc(sizeof(Bitmapset *) * KERN_REGEX_MAX_STATES);
+	dfa_hashes = palloc(sizeof(uint32) * KERN_REGEX_MAX_STATES);
+	dfa_flags = palloc0(sizeof(uint8_t) * KERN_REGEX_MAX_STATES);
+	dfa_trans = palloc(sizeof(uint16_t) * KERN_REGEX_MAX_STATES * nclasses);
+
+	restart = re_nfa_closure(&rcs, bms_make_singleton(start_id), false, false);
+	dfa_sets[0] = re_nfa_closure(&rcs, bms_make_singleton(start_id), true, false);
+	dfa_hashes[0] = bms_hash_value(dfa_sets[0]);
+	dfa_nstates = 1;
+	for (i=0; i < dfa_nstates; i++)
+	{
+		Bitmapset  *curr = dfa_sets[i];
+		Bitmapset  *temp;
+		uint16_t   *trans = dfa_trans + i * nclasses;
+
+		temp = re_nfa_closure(&rcs, curr, (i == 0), true);
+		if (bms_is_member(match_id, temp))
+			dfa_flags[i] |= KERN_REGEX_FLAG__ACCEPT_EOS;
+		if (bms_is_member(match_id, curr))
+			dfa_flags[i] |= KERN_REGEX_FLAG__MATCHED;
+		else if (bms_is_empty(curr))
+			dfa_flags[i] |= KERN_REGEX_FLAG__DEAD;
+		if ((dfa_flags[i] & (KERN_REGEX_FLAG__MATCHED |
+							 KERN_REGEX_FLAG__DEAD)) != 0)
+		{
+			/* terminal state; transitions are not referenced */
+			for (k=0; k < nclasses; k++)
+				trans[k] = i;
+			continue;
+		}
+
+		for (k=0; k < nclasses; k++)
+		{
+			Bitmapset  *next = NULL;
+			uint32		hash;
+			bool		fallback = false;
+			int			s = -1;
+
+			c = class_sym[k];
+			while ((s = bms_next_member(curr, s)) >= 0)
+			{
+				re_nfa_state *ns = &rcs.nfa[s];
+				re_charset *cs;
+
+				if (ns->tag != RE_NFA__CHAR)
+					continue;
+				cs = &rcs.csets[ns->cset_id];
+				if (c == KERN_REGEX_SYMBOL__NONASCII)
+				{
+					if (cs->nonascii == RE_NONASCII__UNKNOWN)
+						fallback = true;
+					else if (cs->nonascii == RE_NONASCII__MATCH)
+						next = bms_add_member(next, ns->out1);
+				}
+				else if (re_cset_test(cs, c))
+					next = bms_add_member(next, ns->out1);
+			}
+			if (fallback)
+			{
+				trans[k] = KERN_REGEX_STATE__FALLBACK;
+				continue;
+			}
+			temp = re_nfa_closure(&rcs, next, false, false);
+			/* implicit search loop; the match can begin at any position */
+			temp = bms_add_members(temp, restart);
+			hash = bms_hash_value(temp);
+			/* DFA state 0 is distinct because BOL matches only there */
+			for (j=1; j < dfa_nstates; j++)
+			{
+				if (dfa_hashes[j] == hash && bms_equal(dfa_sets[j], temp))
+					break;
+			}
+			if (j == dfa_nstates)
+			{
+				if (dfa_nstates >= KERN_REGEX_MAX_STATES ||
+					sizeof(uint16_t) * (dfa_nstates + 1) * nclasses
+					> KERN_REGEX_MAX_TABLESZ)
+				{
+					rcs.errmsg = "too many DFA states";
+					goto unsupported;
+				}
+				dfa_sets[j] = temp;
+				dfa_hashes[j] = hash;
+				dfa_nstates++;
+			}
+			trans[k] = j;
+		}
+	}
+
+	/* setup kern_expression */
+	trans_offset = MAXALIGN(sizeof(uint8_t) * dfa_nstates);
+	sz = MAXALIGN(offsetof(kern_expression, u.regex.data) + trans_offset +
+				  sizeof(uint16_t) * dfa_nstates * nclasses);
+	kexp = palloc0(Max(sz, sizeof(kern_expression)));
+	kexp->args_offset = sz;
+	kexp->u.regex.nstates = dfa_nstates;
+	kexp->u.regex.nclasses = nclasses;
+	kexp->u.regex.trans_offset = trans_offset;
+	memcpy(kexp->u.regex.symclass, symclass, sizeof(symclass));
+	memcpy(kexp->u.regex.data, dfa_flags, sizeof(uint8_t) * dfa_nstates);
+	memcpy(kexp->u.regex.data + trans_offset, dfa_trans,
+		   sizeof(uint16_t) * dfa_nstates * nclasses);
+	return kexp;
+
+unsupported:
+	*p_errmsg = (rcs.errmsg ? rcs.errmsg : "unsupported pattern");
+	return NULL;
+}
@@ -10,6 +10,15 @@
  * it under the terms of the PostgreSQL License.
  */
 #include "pg_strom.h"
+#ifdef HAVE_LIBURING
+#include <liburing.h>
+#endif
+
+/* static variables */
+static bool		pgstrom_enable_io_uring_scan;	/* GUC */
+static bool		pgstrom_enable_gpu_mvcc;		/* GUC */
+static int		pgstrom_gpu_mvcc_clog_range;	/* GUC */
+static int		pgstrom_gpudirect_merge_gap;	/* GUC */
 
 /* ----------------------------------------------------------------
  *
@@ -141,12 +150,27 @@ __setup_kern_colmeta(kern_data_store *kds,
 		kds->has_varlena = true;
 	cmeta->attnum	= attnum;
 
+	/*
+	 * attcacheoff is int16_t on the kern_colmeta, so the shortcut is not
+	 * available on the columns beyond the range (e.g, wide tables with
+	 * many fixed-length char(n) columns).
+	 */
+	if (p_attcacheoff && *p_attcacheoff > PG_INT16_MAX)
+		*p_attcacheoff = -1;
+
 	if (!p_attcacheoff || *p_attcacheoff < 0)
 		cmeta->attcacheoff = -1;
 	else if (attlen > 0)
 	{
-		cmeta->attcacheoff = att_align_nominal(*p_attcacheoff, attalign);
-		*p_attcacheoff = cmeta->attcacheoff + attlen;
+		int		__off = att_align_nominal(*p_attcacheoff, attalign);
+
+		if (__off > PG_INT16_MAX)
+			cmeta->attcacheoff = *p_attcacheoff = -1;
+		else
+		{
+			cmeta->attcacheoff = __off;
+			*p_attcacheoff = __off + attlen;
+		}
 	}
 	else if (attlen == -1)
 	{
@@ -378,15 +402,35 @@ pgstromStoreFallbackTuple(pgstromTaskState *pts, HeapTuple htuple)
 			MemoryContextAlloc(memcxt, pts->fallback_bufsz);
 	}
 	sz = MAXALIGN(offsetof(kern_tupitem, htup) + htuple->t_len);
+	/*
+	 * A chunk may generate massive number of fallback tuples (e.g, numeric
+	 * overflow on a particular column), so they are spilled out to the
+	 * tuplestore once the in-memory buffer exceeds work_mem.
+	 * The first tuple is always kept in the buffer, because EvalPlanQual
+	 * picks up the fallback tuple from the buffer directly.
+	 */
+	if (pts->fallback_usage > 0 &&
+		pts->fallback_usage + sz > (size_t)work_mem * 1024L)
+	{
+		if (!pts->fallback_store)
+		{
+			MemoryContext oldcxt = MemoryContextSwitchTo(memcxt);
+
+			pts->fallback_store = tuplestore_begin_heap(false, false, work_mem);
+			MemoryContextSwitchTo(oldcxt);
+		}
+		tuplestore_puttuple(pts->fallback_store, htuple);
+		return;
+	}
 	while (pts->fallback_usage + sz > pts->fallback_bufsz)
 	{
-		pts->fallback_bufsz *= 2 + BLCKSZ;
+		pts->fallback_bufsz = 2 * pts->fallback_bufsz + BLCKSZ;
 		pts->fallback_buffer = repalloc_huge(pts->fallback_buffer,
 											 pts->fallback_bufsz);
 	}
 	while (pts->fallback_nitems >= pts->fallback_nrooms)
 	{
-		pts->fallback_nrooms *= 2 + 100;
+		pts->fallback_nrooms = 2 * pts->fallback_nrooms + 100;
 		pts->fallback_tuples = repalloc_huge(pts->fallback_tuples,
 											 sizeof(off_t) * pts->fallback_nrooms);
 	}
@@ -426,6 +470,25 @@ pgstromFetchFallbackTuple(pgstromTaskState *pts)
 		slot_getallattrs(slot);
 		return slot;
 	}
+	if (pts->fallback_store)
+	{
+		TupleTableSlot *slot = pts->css.ss.ss_ScanTupleSlot;
+
+		/* tuplestore returns MinimalTuple, so fetch it by its own slot */
+		if (!pts->fallback_store_slot)
+			pts->fallback_store_slot =
+				MakeSingleTupleTableSlot(slot->tts_tupleDescriptor,
+										 &TTSOpsMinimalTuple);
+		if (tuplestore_gettupleslot(pts->fallback_store, true, false,
+									pts->fallback_store_slot))
+		{
+			ExecCopySlot(slot, pts->fallback_store_slot);
+			slot_getallattrs(slot);
+			return slot;
+		}
+		/* all the spilled tuples are consumed */
+		tuplestore_clear(pts->fallback_store);
+	}
 	return NULL;
 }
 
@@ -440,6 +503,88 @@ pgstromFetchFallbackTuple(pgstromTaskState *pts)
 #define __XCMD_GET_KDS_SRC(buf)								\
 	((kern_data_store *)((buf)->data + __XCMD_KDS_SRC_OFFSET(buf)))
 
+/*
+ * pgstromBuildSessionXactSnapshot
+ *
+ * It ships the MVCC snapshot of the current scan, and commit status of
+ * the recent transactions, to the GPU device. Then, the relation scan
+ * can read pages that are not all-visible using the direct reader, and
+ * the device code checks visibility of the tuples by itself.
+ * If GPU cannot decide visibility of a tuple (e.g, multixact, tuples
+ * modified by the current transaction, or too old xid to be in the
+ * commit status bitmap), the chunk is processed by the CPU fallback.
+ */
+uint32_t
+pgstromBuildSessionXactSnapshot(pgstromTaskState *pts, StringInfo buf)
+{
+	Relation	relation = pts->css.ss.ss_currentRelation;
+	Snapshot	snapshot = pts->css.ss.ps.state->es_snapshot;
+	kern_xact_snapshot *ksnap;
+	TransactionId oldest_xid;
+	uint32_t	nxids;
+	uint32_t	xcnt;
+	uint32_t	head_sz;
+	uint32_t	bitmap_sz;
+	uint8_t	   *bitmap;
+	uint32_t	offset;
+
+	pts->device_mvcc = false;
+	if (!pgstrom_enable_gpu_mvcc ||
+		!relation ||
+		RelationGetForm(relation)->relkind != RELKIND_RELATION ||
+		(pts->xpu_task_flags & DEVKIND__NVIDIA_GPU) == 0 ||
+		pts->arrow_state != NULL ||
+		pts->gcache_desc != NULL ||
+		pts->ds_entry != NULL ||
+		!IsMVCCSnapshot(snapshot) ||
+		snapshot->suboverflowed ||
+		IsolationIsSerializable())
+		return 0;
+
+	/* range of the commit status bitmap; must be in the commit log */
+	LWLockAcquire(XactTruncationLock, LW_SHARED);
+	oldest_xid = TransamVariables->oldestClogXid;
+	nxids = (uint32_t)(snapshot->xmax - oldest_xid);
+	if (nxids > pgstrom_gpu_mvcc_clog_range)
+		nxids = pgstrom_gpu_mvcc_clog_range;
+	xcnt = snapshot->xcnt + snapshot->subxcnt;
+	head_sz = MAXALIGN(offsetof(kern_xact_snapshot, xip[xcnt]));
+	bitmap_sz = MAXALIGN(BITMAPLEN(nxids));
+
+	ksnap = palloc0(head_sz + bitmap_sz);
+	ksnap->xmin = snapshot->xmin;
+	ksnap->xmax = snapshot->xmax;
+	ksnap->xcnt = xcnt;
+	ksnap->clog_base = snapshot->xmax - nxids;
+	ksnap->clog_nxids = nxids;
+	ksnap->clog_offset = head_sz;
+	if (snapshot->xcnt > 0)
+		memcpy(ksnap->xip, snapshot->xip,
+			   sizeof(TransactionId) * snapshot->xcnt);
+	if (snapshot->subxcnt > 0)
+		memcpy(ksnap->xip + snapshot->xcnt, snapshot->subxip,
+			   sizeof(TransactionId) * snapshot->subxcnt);
+	/*
+	 * in-progress transactions in the snapshot are checked prior to
+	 * the commit status, so we don't need to care about them here.
+	 */
+	bitmap = (uint8_t *)ksnap + head_sz;
+	for (uint32_t i=0; i < nxids; i++)
+	{
+		TransactionId	xid = ksnap->clog_base + i;
+
+		if (TransactionIdIsNormal(xid) && TransactionIdDidCommit(xid))
+			bitmap[i>>3] |= (1U << (i & 7));
+	}
+	LWLockRelease(XactTruncationLock);
+
+	offset = __appendBinaryStringInfo(buf, ksnap, head_sz + bitmap_sz);
+	pfree(ksnap);
+	pts->device_mvcc = true;
+
+	return offset;
+}
+
 static void
 __relScanDirectFallbackBlock(pgstromTaskState *pts,
 							 kern_data_store *kds,
@@ -480,6 +625,8 @@ __relScanDirectFallbackBlock(pgstromTaskState *pts,
 		htup.t_data = (HeapTupleHeader) PageGetItem((Page)page, lpp);
 		htup.t_len = ItemIdGetLength(lpp);
 		ItemPointerSet(&htup.t_self, block_num, lineoff);
+		if (pgstromTableSampleSkipTuple(pts, &htup.t_self))
+			continue;
 
 		valid = HeapTupleSatisfiesVisibility(&htup, snapshot, buffer);
 		HeapCheckForSerializableConflictOut(valid, relation, &htup,
@@ -491,6 +638,103 @@ __relScanDirectFallbackBlock(pgstromTaskState *pts,
 	pg_atomic_fetch_add_u64(&ps_state->npages_buffer_read, PAGES_PER_BLOCK);
 }
 
+/*
+ * pgstromTableSampleBegin
+ *
+ * It evaluates the arguments of the TABLESAMPLE clause, like
+ * tablesample_init() doing for SampleScan, then computes the threshold
+ * of pgstrom_tablesample_check().
+ */
+void
+pgstromTableSampleBegin(pgstromTaskState *pts)
+{
+	pgstromPlanInfo *pp_info = pts->pp_info;
+	ExprContext *econtext = pts->css.ss.ps.ps_ExprContext;
+	ExprState  *estate;
+	Datum		datum;
+	bool		isnull;
+	float4		percent;
+
+	if (pts->tablesample_ready)
+		return;
+	pts->tablesample_ready = true;
+	pts->tablesample_method = TABLESAMPLE_METHOD__NONE;
+	if (!pp_info || pp_info->tablesample_method == TABLESAMPLE_METHOD__NONE)
+		return;
+	/* both of SYSTEM and BERNOULLI take a float4 percentage */
+	Assert(list_length(pp_info->tablesample_args) == 1);
+	estate = ExecInitExpr(linitial(pp_info->tablesample_args),
+						  &pts->css.ss.ps);
+	datum = ExecEvalExprSwitchContext(estate, econtext, &isnull);
+	if (isnull)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_TABLESAMPLE_ARGUMENT),
+				 errmsg("TABLESAMPLE parameter cannot be null")));
+	percent = DatumGetFloat4(datum);
+	if (percent < 0.0 || percent > 100.0 || isnan(percent))
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_TABLESAMPLE_ARGUMENT),
+				 errmsg("sample percentage must be between 0 and 100")));
+	pts->tablesample_threshold = (uint64_t)rint((double)percent / 100.0 *
+												4294967296.0);
+	if (pp_info->tablesample_repeatable)
+	{
+		estate = ExecInitExpr(pp_info->tablesample_repeatable,
+							  &pts->css.ss.ps);
+		datum = ExecEvalExprSwitchContext(estate, econtext, &isnull);
+		if (isnull)
+			ereport(ERROR,
+					(errcode(ERRCODE_INVALID_TABLESAMPLE_REPEAT),
+					 errmsg("TABLESAMPLE REPEATABLE parameter cannot be null")));
+		pts->tablesample_seed = DatumGetUInt32(DirectFunctionCall1(hashfloat8,
+																   datum));
+	}
+	else
+	{
+		pts->tablesample_seed = (uint32_t)random();
+	}
+	pts->tablesample_method = pp_info->tablesample_method;
+}
+
+/*
+ * pgstromTableSampleSkipBlock - true, if SYSTEM sampling skips the block
+ */
+bool
+pgstromTableSampleSkipBlock(pgstromTaskState *pts, BlockNumber block_num)
+{
+	if (pts->tablesample_method != TABLESAMPLE_METHOD__SYSTEM)
+		return false;
+	return !pgstrom_tablesample_check(pts->tablesample_method,
+									  pts->tablesample_seed,
+									  pts->tablesample_threshold,
+									  block_num, 0);
+}
+
+/*
+ * pgstromTableSampleSkipTuple - true, if the tuple is not sampled
+ */
+bool
+pgstromTableSampleSkipTuple(pgstromTaskState *pts, ItemPointer ctid)
+{
+	if (pts->tablesample_method == TABLESAMPLE_METHOD__NONE)
+		return false;
+	return !pgstrom_tablesample_check(pts->tablesample_method,
+									  pts->tablesample_seed,
+									  pts->tablesample_threshold,
+									  ItemPointerGetBlockNumber(ctid),
+									  ItemPointerGetOffsetNumber(ctid));
+}
+
+/*
+ * pgstromRelScanFallbackBlock - CPU fallback of the page that is not
+ * all-visible, using the shared buffer with visibility checks.
+ */
+void
+pgstromRelScanFallbackBlock(pgstromTaskState *pts, BlockNumber block_num)
+{
+	__relScanDirectFallbackBlock(pts, NULL, block_num);
+}
+
 static void
 __relScanDirectCachedBlock(pgstromTaskState *pts, BlockNumber block_num)
 {
@@ -585,6 +829,30 @@ __relScanDirectCachedBlock(pgstromTaskState *pts, BlockNumber block_num)
 	kds->block_nloaded++;
 }
 
+/*
+ * __relScanDirectStagedBlocks
+ *
+ * Blocks that are not eligible for the direct read (not all-visible, or
+ * dirty on the shared buffer) are staged during the scan of block ranges,
+ * then copied to the head of the chunk at once; so, they are carried by
+ * the same XpuCommand with the I/O vector of the direct read. Prefetch is
+ * issued for all the staged blocks first, to overlap the buffer reads.
+ */
+static void
+__relScanDirectStagedBlocks(pgstromTaskState *pts,
+							BlockNumber *staged_blknums,
+							uint32_t *p_nstaged)
+{
+	Relation	relation = pts->css.ss.ss_currentRelation;
+	uint32_t	nstaged = *p_nstaged;
+
+	for (uint32_t i=0; i < nstaged; i++)
+		(void) PrefetchBuffer(relation, MAIN_FORKNUM, staged_blknums[i]);
+	for (uint32_t i=0; i < nstaged; i++)
+		__relScanDirectCachedBlock(pts, staged_blknums[i]);
+	*p_nstaged = 0;
+}
+
 static bool
 __relScanDirectCheckBufferClean(SMgrRelation smgr, BlockNumber block_num)
 {
@@ -614,6 +882,88 @@ __relScanDirectCheckBufferClean(SMgrRelation smgr, BlockNumber block_num)
 	return (bufState & BM_DIRTY) == 0;
 }
 
+/*
+ * __relScanNextBlockRange
+ *
+ * It assigns the next range of blocks to be loaded on pts->curr_block_num
+ * and pts->curr_block_tail, or set pts->scan_done if no more blocks.
+ */
+static void
+__relScanNextBlockRange(pgstromTaskState *pts, BlockNumber num_blocks)
+{
+	Relation		relation = pts->css.ss.ss_currentRelation;
+	HeapScanDesc    h_scan = (HeapScanDesc)pts->css.ss.ss_currentScanDesc;
+
+	if (pts->br_state)
+	{
+		if (!pgstromBrinIndexNextChunk(pts))
+			pts->scan_done = true;
+	}
+	else if (!h_scan->rs_base.rs_parallel)
+	{
+		/* single process scan */
+		if (!h_scan->rs_inited)
+		{
+			h_scan->rs_cblock = 0;
+			h_scan->rs_inited = true;
+		}
+		pts->curr_block_num = h_scan->rs_cblock;
+		if (pts->curr_block_num >= h_scan->rs_nblocks)
+			pts->scan_done = true;
+		else if (pts->curr_block_num + num_blocks > h_scan->rs_nblocks)
+			num_blocks = h_scan->rs_nblocks - pts->curr_block_num;
+		h_scan->rs_cblock += num_blocks;
+		pts->curr_block_tail = pts->curr_block_num + num_blocks;
+		/* let the concurrent scans know the current location */
+		if (!pts->scan_done &&
+			(h_scan->rs_base.rs_flags & SO_ALLOW_SYNC) != 0)
+			ss_report_location(relation, (pts->curr_block_num +
+										  h_scan->rs_startblock) % h_scan->rs_nblocks);
+	}
+	else
+	{
+		/* parallel processes scan */
+		ParallelBlockTableScanDesc pb_scan =
+			(ParallelBlockTableScanDesc)h_scan->rs_base.rs_parallel;
+
+		if (!h_scan->rs_inited)
+		{
+			/* see table_block_parallelscan_startblock_init */
+			BlockNumber	start_block = InvalidBlockNumber;
+
+		retry_parallel_init:
+			SpinLockAcquire(&pb_scan->phs_mutex);
+			if (pb_scan->phs_startblock == InvalidBlockNumber)
+			{
+				if (!pb_scan->base.phs_syncscan)
+					pb_scan->phs_startblock = 0;
+				else if (start_block != InvalidBlockNumber)
+					pb_scan->phs_startblock = start_block;
+				else
+				{
+					SpinLockRelease(&pb_scan->phs_mutex);
+					start_block = ss_get_location(relation, pb_scan->phs_nblocks);
+					goto retry_parallel_init;
+				}
+			}
+			h_scan->rs_nblocks = pb_scan->phs_nblocks;
+			h_scan->rs_startblock = pb_scan->phs_startblock;
+			SpinLockRelease(&pb_scan->phs_mutex);
+			h_scan->rs_inited = true;
+		}
+		pts->curr_block_num = pg_atomic_fetch_add_u64(&pb_scan->phs_nallocated,
+													  num_blocks);
+		if (pts->curr_block_num >= h_scan->rs_nblocks)
+			pts->scan_done = true;
+		else if (pts->curr_block_num + num_blocks > h_scan->rs_nblocks)
+			num_blocks = h_scan->rs_nblocks - pts->curr_block_num;
+		pts->curr_block_tail = pts->curr_block_num + num_blocks;
+		if (!pts->scan_done && pb_scan->base.phs_syncscan)
+			ss_report_location(relation, (pts->curr_block_num +
+										  h_scan->rs_startblock) % h_scan->rs_nblocks);
+	}
+}
+
 XpuCommand *
 pgstromRelScanChunkDirect(pgstromTaskState *pts,
 						  struct iovec *xcmd_iov, int *xcmd_iovcnt)
@@ -630,6 +980,8 @@ pgstromRelScanChunkDirect(pgstromTaskState *pts,
 	strom_io_chunk *strom_ioc = NULL;
 	BlockNumber	   *strom_blknums;
 	uint32_t		strom_nblocks = 0;
+	BlockNumber	   *staged_blknums;
+	uint32_t		nstaged = 0;
 	uint32_t		kds_src_pathname = 0;
 	uint32_t		kds_src_iovec = 0;
 	uint32_t		kds_nrooms;
@@ -651,13 +1003,22 @@ pgstromRelScanChunkDirect(pgstromTaskState *pts,
 	strom_iovec->nr_chunks = 0;
 	strom_blknums = alloca(sizeof(BlockNumber) * kds_nrooms);
 	strom_nblocks = 0;
+	staged_blknums = alloca(sizeof(BlockNumber) * kds_nrooms);
 	while (!pts->scan_done)
 	{
 		while (pts->curr_block_num < pts->curr_block_tail &&
-			   kds->nitems < kds_nrooms)
+			   kds->nitems + nstaged < kds_nrooms)
 		{
 			BlockNumber		block_num
 				= (pts->curr_block_num + h_scan->rs_startblock) % h_scan->rs_nblocks;
+
+			/* skip the block range that never matches the scan quals */
+			if (pgstromZoneMapSkipBlock(pts, block_num) ||
+				pgstromTableSampleSkipBlock(pts, block_num))
+			{
+				pts->curr_block_num++;
+				continue;
+			}
 			/*
 			 * MEMO: Usually, CPU is (much) more powerful than DPUs.
 			 * In case when the source cache is already on the shared-
@@ -689,15 +1050,13 @@ pgstromRelScanChunkDirect(pgstromTaskState *pts,
 			}
 			
 			/*
-			 * MEMO: right now, we allow GPU Direct SQL for the all-visible
-			 * pages only, due to the restrictions about MVCC checks.
-			 * However, it is too strict for the purpose. If we would have
-			 * a mechanism to perform MVCC checks without commit logs.
-			 * In other words, if all the tuples in a certain page have
-			 * HEAP_XMIN_* or HEAP_XMAX_* flags correctly, we can have MVCC
-			 * logic in the device code.
+			 * MEMO: GPU Direct SQL is allowed for the all-visible pages,
+			 * or any clean pages if the device can check visibility of
+			 * the tuples using the shipped snapshot and commit status.
+			 * (see pgstromBuildSessionXactSnapshot)
 			 */
-			if (VM_ALL_VISIBLE(relation, block_num, &pts->curr_vm_buffer) &&
+			if ((pts->device_mvcc ||
+				 VM_ALL_VISIBLE(relation, block_num, &pts->curr_vm_buffer)) &&
 				__relScanDirectCheckBufferClean(smgr, block_num))
 			{
 				/*
@@ -720,6 +1079,37 @@ pgstromRelScanChunkDirect(pgstromTaskState *pts,
 					/* expand the iovec entry */
 					strom_ioc->nr_pages += PAGES_PER_BLOCK;
 				}
+				else if (strom_ioc != NULL && !pts->ds_entry &&
+						 fchunk_id > strom_ioc->fchunk_id + strom_ioc->nr_pages &&
+						 fchunk_id - (strom_ioc->fchunk_id +
+									  strom_ioc->nr_pages) <=
+						 pgstrom_gpudirect_merge_gap * PAGES_PER_BLOCK &&
+						 kds->nitems + nstaged + 1 +
+						 (fchunk_id - (strom_ioc->fchunk_id +
+									   strom_ioc->nr_pages)) / PAGES_PER_BLOCK
+						 <= kds_nrooms)
+				{
+					/*
+					 * The hole between the last iovec entry and this block
+					 * consists of the blocks skipped by the zone-map/BRIN,
+					 * dirty blocks moved to the staged buffer, or blocks
+					 * fetched by other workers. A few small holes make
+					 * many short P2P DMA requests, so it is often cheaper
+					 * to read them together as padding blocks with
+					 * InvalidBlockNumber; the device and the CPU fallback
+					 * never look at the contents of these blocks.
+					 */
+					uint32_t	gap = (fchunk_id - (strom_ioc->fchunk_id +
+													strom_ioc->nr_pages));
+					Assert(gap % PAGES_PER_BLOCK == 0);
+					for (uint32_t k=0; k < gap; k += PAGES_PER_BLOCK)
+					{
+						kds->nitems++;
+						strom_blknums[strom_nblocks++] = InvalidBlockNumber;
+						m_offset += BLCKSZ;
+					}
+					strom_ioc->nr_pages += gap + PAGES_PER_BLOCK;
+				}
 				else
 				{
 					/* add the next iovec entry */
@@ -743,81 +1133,21 @@ pgstromRelScanChunkDirect(pgstromTaskState *pts,
 			}
 			else
 			{
-				__relScanDirectCachedBlock(pts, block_num);
+				staged_blknums[nstaged++] = block_num;
 			}
 			pts->curr_block_num++;
 		}
+		__relScanDirectStagedBlocks(pts, staged_blknums, &nstaged);
 
 		if (kds->nitems >= kds_nrooms)
 		{
 			/* ok, we cannot load more pages in this chunk */
 			break;
 		}
-		else if (pts->br_state)
-		{
-			if (!pgstromBrinIndexNextChunk(pts))
-				pts->scan_done = true;
-		}
-		else if (!h_scan->rs_base.rs_parallel)
-		{
-			/* single process scan */
-			BlockNumber		num_blocks = kds_nrooms - kds->nitems;
-
-			if (!h_scan->rs_inited)
-			{
-				h_scan->rs_cblock = 0;
-				h_scan->rs_inited = true;
-			}
-			pts->curr_block_num = h_scan->rs_cblock;
-			if (pts->curr_block_num >= h_scan->rs_nblocks)
-				pts->scan_done = true;
-			else if (pts->curr_block_num + num_blocks > h_scan->rs_nblocks)
-				num_blocks = h_scan->rs_nblocks - pts->curr_block_num;
-			h_scan->rs_cblock += num_blocks;
-			pts->curr_block_tail = pts->curr_block_num + num_blocks;
-		}
-		else
-		{
-			/* parallel processes scan */
-			ParallelBlockTableScanDesc pb_scan =
-				(ParallelBlockTableScanDesc)h_scan->rs_base.rs_parallel;
-			BlockNumber		num_blocks = kds_nrooms - kds->nitems;
-
-			if (!h_scan->rs_inited)
-			{
-				/* see table_block_parallelscan_startblock_init */
-				BlockNumber	start_block = InvalidBlockNumber;
-
-			retry_parallel_init:
-				SpinLockAcquire(&pb_scan->phs_mutex);
-				if (pb_scan->phs_startblock == InvalidBlockNumber)
-				{
-					if (!pb_scan->base.phs_syncscan)
-						pb_scan->phs_startblock = 0;
-					else if (start_block != InvalidBlockNumber)
-						pb_scan->phs_startblock = start_block;
-					else
-					{
-						SpinLockRelease(&pb_scan->phs_mutex);
-						start_block = ss_get_location(relation, pb_scan->phs_nblocks);
-						goto retry_parallel_init;
-					}
-				}
-				h_scan->rs_nblocks = pb_scan->phs_nblocks;
-				h_scan->rs_startblock = pb_scan->phs_startblock;
-				SpinLockRelease(&pb_scan->phs_mutex);
-				h_scan->rs_inited = true;
-			}
-			pts->curr_block_num = pg_atomic_fetch_add_u64(&pb_scan->phs_nallocated,
-														  num_blocks);
-			if (pts->curr_block_num >= h_scan->rs_nblocks)
-				pts->scan_done = true;
-			else if (pts->curr_block_num + num_blocks > h_scan->rs_nblocks)
-				num_blocks = h_scan->rs_nblocks - pts->curr_block_num;
-			pts->curr_block_tail = pts->curr_block_num + num_blocks;
-		}
+		__relScanNextBlockRange(pts, kds_nrooms - kds->nitems);
 	}
 out:
+	__relScanDirectStagedBlocks(pts, staged_blknums, &nstaged);
 	Assert(kds->nitems == kds->block_nloaded + strom_nblocks);
 	pg_atomic_fetch_add_u64(&ps_state->npages_buffer_read,
 							kds->block_nloaded * PAGES_PER_BLOCK);
@@ -862,8 +1192,446 @@ out:
 	return xcmd;
 }
 
+/*
+ * pgstromRelScanUringAvailable
+ */
+bool
+pgstromRelScanUringAvailable(pgstromTaskState *pts)
+{
+#ifdef HAVE_LIBURING
+	if (pgstrom_enable_io_uring_scan &&
+		pts->kds_pathname != NULL &&
+		!pts->ds_entry &&
+		(pts->xpu_task_flags & DEVKIND__NVIDIA_GPU) != 0)
+		return true;
+#endif
+	return false;
+}
+
+#ifdef HAVE_LIBURING
+/*
+ * pgstromRelScanChunkUring
+ *
+ * Asynchronous heap block reader for the hosts without GPU-Direct SQL.
+ * All-visible and clean blocks are read from the relation files by
+ * io_uring, bypassing the shared buffer like GPU-Direct SQL, while the
+ * other blocks are copied from the shared buffer with visibility checks.
+ * Once the chunk is built, it issues readahead hints for the next range
+ * of blocks, to be loaded while the GPU processes the current chunk.
+ */
+#define RELSCAN_URING_DEPTH		128
+
+static struct io_uring	relscan_uring;
+static bool		relscan_uring_initialized = false;
+static int		relscan_uring_inflight = 0;		/* including readahead */
+
+typedef struct
+{
+	const char *pathname;
+	int			nfdescs;
+	int		   *fdescs;			/* per segment, or -1 */
+	int			nreads;			/* number of reads in-flight */
+	/* pending range of the contiguous blocks */
+	int			run_fdesc;
+	off_t		run_offset;
+	char	   *run_buffer;
+	size_t		run_length;
+} relScanUringState;
+
+static bool
+__relScanUringReapOne(relScanUringState *ustate, bool wait)
+{
+	struct io_uring_cqe *cqe;
+	size_t		length;
+	int			res;
+	int			rv;
+
+	if (relscan_uring_inflight == 0)
+		return false;
+retry:
+	if (wait)
+		rv = io_uring_wait_cqe(&relscan_uring, &cqe);
+	else
+		rv = io_uring_peek_cqe(&relscan_uring, &cqe);
+	if (rv == -EINTR && wait)
+		goto retry;
+	if (rv == -EAGAIN)
+		return false;
+	if (rv < 0)
+		elog(ERROR, "failed on io_uring_wait_cqe: %s", strerror(-rv));
+	/* user_data is the expected length of reads, or 0 for readahead */
+	length = (uintptr_t) io_uring_cqe_get_data(cqe);
+	res = cqe->res;
+	io_uring_cqe_seen(&relscan_uring, cqe);
+	relscan_uring_inflight--;
+	if (length > 0)
+	{
+		if (ustate)
+			ustate->nreads--;
+		if (res < 0)
+			elog(ERROR, "failed on io_uring read: %s", strerror(-res));
+		if (res != length)
+			elog(ERROR, "io_uring read too short (%d of %zu bytes)", res, length);
+	}
+	return true;
+}
+
+static struct io_uring_sqe *
+__relScanUringGetSqe(relScanUringState *ustate)
+{
+	struct io_uring_sqe *sqe;
+
+	while ((sqe = io_uring_get_sqe(&relscan_uring)) == NULL)
+	{
+		io_uring_submit(&relscan_uring);
+		__relScanUringReapOne(ustate, true);
+	}
+	relscan_uring_inflight++;
+	return sqe;
+}
+
+static int
+__relScanUringSegmentFile(relScanUringState *ustate, BlockNumber segno)
+{
+	if (segno >= ustate->nfdescs)
+	{
+		int		nfdescs = segno + 8;
+
+		if (!ustate->fdescs)
+			ustate->fdescs = palloc(sizeof(int) * nfdescs);
+		else
+			ustate->fdescs = repalloc(ustate->fdescs, sizeof(int) * nfdescs);
+		for (int i=ustate->nfdescs; i < nfdescs; i++)
+			ustate->fdescs[i] = -1;
+		ustate->nfdescs = nfdescs;
+	}
+	if (ustate->fdescs[segno] < 0)
+	{
+		char   *fname = (segno == 0
+						 ? pstrdup(ustate->pathname)
+						 : psprintf("%s.%u", ustate->pathname, segno));
+		int		fdesc = open(fname, O_RDONLY | PG_BINARY | O_CLOEXEC);
+
+		if (fdesc < 0)
+			elog(ERROR, "failed on open('%s'): %m", fname);
+		ustate->fdescs[segno] = fdesc;
+		pfree(fname);
+	}
+	return ustate->fdescs[segno];
+}
+
+static void
+__relScanUringCloseFiles(relScanUringState *ustate)
+{
+	for (int i=0; i < ustate->nfdescs; i++)
+	{
+		if (ustate->fdescs[i] >= 0)
+			close(ustate->fdescs[i]);
+		ustate->fdescs[i] = -1;
+	}
+}
+
+static void
+__relScanUringFlushRun(relScanUringState *ustate)
+{
+	struct io_uring_sqe *sqe;
+
+	if (ustate->run_length == 0)
+		return;
+	sqe = __relScanUringGetSqe(ustate);
+	io_uring_prep_read(sqe,
+					   ustate->run_fdesc,
+					   ustate->run_buffer,
+					   ustate->run_length,
+					   ustate->run_offset);
+	io_uring_sqe_set_data(sqe, (void *)((uintptr_t)ustate->run_length));
+	ustate->nreads++;
+	ustate->run_length = 0;
+	/* kick the I/O, while CPU copies the cached blocks */
+	io_uring_submit(&relscan_uring);
+}
+
+static void
+__relScanUringAddBlock(relScanUringState *ustate,
+					   BlockNumber block_num, char *dpage)
+{
+	int		fdesc = __relScanUringSegmentFile(ustate, block_num / RELSEG_SIZE);
+	off_t	offset = (off_t)(block_num % RELSEG_SIZE) * BLCKSZ;
+
+	if (ustate->run_length > 0 &&
+		ustate->run_fdesc == fdesc &&
+		ustate->run_offset + ustate->run_length == offset &&
+		ustate->run_buffer + ustate->run_length == dpage)
+	{
+		ustate->run_length += BLCKSZ;
+		return;
+	}
+	__relScanUringFlushRun(ustate);
+	ustate->run_fdesc  = fdesc;
+	ustate->run_offset = offset;
+	ustate->run_buffer = dpage;
+	ustate->run_length = BLCKSZ;
+}
+
+/*
+ * __relScanUringReadAhead - readahead hints for the next range of blocks
+ */
+static void
+__relScanUringReadAhead(pgstromTaskState *pts,
+						relScanUringState *ustate,
+						BlockNumber num_blocks)
+{
+	HeapScanDesc h_scan = (HeapScanDesc)pts->css.ss.ss_currentScanDesc;
+	BlockNumber	curr = pts->curr_block_num;
+	BlockNumber	tail = Min(pts->curr_block_tail, curr + num_blocks);
+	BlockNumber	head_num = InvalidBlockNumber;
+	BlockNumber	prev_num = InvalidBlockNumber;
+
+	for (; curr <= tail; curr++)
+	{
+		BlockNumber	block_num = (curr < tail
+								 ? (curr + h_scan->rs_startblock) % h_scan->rs_nblocks
+								 : InvalidBlockNumber);
+
+		if (head_num != InvalidBlockNumber &&
+			(block_num != prev_num + 1 ||
+			 block_num / RELSEG_SIZE != head_num / RELSEG_SIZE))
+		{
+			struct io_uring_sqe *sqe = __relScanUringGetSqe(ustate);
+			int		fdesc = __relScanUringSegmentFile(ustate, head_num / RELSEG_SIZE);
+
+			io_uring_prep_fadvise(sqe, fdesc,
+								  (off_t)(head_num % RELSEG_SIZE) * BLCKSZ,
+								  (off_t)(prev_num - head_num + 1) * BLCKSZ,
+								  POSIX_FADV_WILLNEED);
+			io_uring_sqe_set_data(sqe, NULL);
+			head_num = InvalidBlockNumber;
+		}
+		if (head_num == InvalidBlockNumber)
+			head_num = block_num;
+		prev_num = block_num;
+	}
+	io_uring_submit(&relscan_uring);
+}
+
+XpuCommand *
+pgstromRelScanChunkUring(pgstromTaskState *pts,
+						 struct iovec *xcmd_iov, int *xcmd_iovcnt)
+{
+	pgstromSharedState *ps_state = pts->ps_state;
+	Relation		relation = pts->css.ss.ss_currentRelation;
+	HeapScanDesc    h_scan = (HeapScanDesc)pts->css.ss.ss_currentScanDesc;
+	SMgrRelation	smgr = RelationGetSmgr(relation);
+	relScanUringState ustate;
+	XpuCommand	   *xcmd;
+	kern_data_store *kds;
+	uint32_t		kds_nrooms;
+	uint32_t		nblocks_vfs = 0;
+	BlockNumber	   *staged_blknums;
+	uint32_t		nstaged = 0;
+
+	if (!relscan_uring_initialized)
+	{
+		int		rv = io_uring_queue_init(RELSCAN_URING_DEPTH, &relscan_uring, 0);
+
+		if (rv < 0)
+			elog(ERROR, "failed on io_uring_queue_init: %s", strerror(-rv));
+		relscan_uring_initialized = true;
+	}
+	/* completions of the readahead hints by the last call */
+	while (__relScanUringReapOne(NULL, false))
+		;
+
+	memset(&ustate, 0, sizeof(relScanUringState));
+	ustate.pathname = pts->kds_pathname;
+
+	kds = __XCMD_GET_KDS_SRC(&pts->xcmd_buf);
+	kds_nrooms = (PGSTROM_CHUNK_SIZE -
+				  KDS_HEAD_LENGTH(kds)) / (sizeof(BlockNumber) + BLCKSZ);
+	kds->nitems  = 0;
+	kds->usage   = 0;
+	kds->block_offset = (KDS_HEAD_LENGTH(kds) +
+						 MAXALIGN(sizeof(BlockNumber) * kds_nrooms));
+	kds->block_nloaded = 0;
+	pts->xcmd_buf.len = __XCMD_KDS_SRC_OFFSET(&pts->xcmd_buf) + kds->block_offset;
+	Assert(pts->xcmd_buf.len == MAXALIGN(pts->xcmd_buf.len));
+	enlargeStringInfo(&pts->xcmd_buf, BLCKSZ * kds_nrooms);
+	kds = __XCMD_GET_KDS_SRC(&pts->xcmd_buf);
+	staged_blknums = alloca(sizeof(BlockNumber) * kds_nrooms);
+
+	PG_TRY();
+	{
+		while (!pts->scan_done)
+		{
+			while (pts->curr_block_num < pts->curr_block_tail &&
+				   kds->nitems + nstaged < kds_nrooms)
+			{
+				BlockNumber		block_num
+					= (pts->curr_block_num + h_scan->rs_startblock) % h_scan->rs_nblocks;
+
+				/* skip the block range that never matches the scan quals */
+				if (pgstromZoneMapSkipBlock(pts, block_num) ||
+					pgstromTableSampleSkipBlock(pts, block_num))
+				{
+					pts->curr_block_num++;
+					continue;
+				}
+				if ((pts->device_mvcc ||
+					 VM_ALL_VISIBLE(relation, block_num, &pts->curr_vm_buffer)) &&
+					__relScanDirectCheckBufferClean(smgr, block_num))
+				{
+					/* the page is read into the tail of the xcmd-buffer */
+					char   *dpage = pts->xcmd_buf.data + pts->xcmd_buf.len;
+
+					Assert(dpage == (char *)KDS_BLOCK_PGPAGE(kds, kds->block_nloaded));
+					KDS_BLOCK_BLCKNR(kds, kds->block_nloaded) = block_num;
+					pts->xcmd_buf.len += BLCKSZ;
+					kds->nitems++;
+					kds->block_nloaded++;
+					__relScanUringAddBlock(&ustate, block_num, dpage);
+					nblocks_vfs++;
+				}
+				else
+				{
+					staged_blknums[nstaged++] = block_num;
+				}
+				pts->curr_block_num++;
+			}
+			/* copies the staged blocks, while the reads are in-flight */
+			__relScanUringFlushRun(&ustate);
+			__relScanDirectStagedBlocks(pts, staged_blknums, &nstaged);
+			if (kds->nitems >= kds_nrooms)
+				break;
+			__relScanNextBlockRange(pts, kds_nrooms - kds->nitems);
+		}
+		__relScanUringFlushRun(&ustate);
+
+		/* readahead of the next chunk, prior to the wait for the reads */
+		if (!pts->scan_done && pts->curr_block_num >= pts->curr_block_tail)
+			__relScanNextBlockRange(pts, kds_nrooms);
+		if (!pts->scan_done)
+			__relScanUringReadAhead(pts, &ustate, kds_nrooms);
+
+		while (ustate.nreads > 0)
+			__relScanUringReapOne(&ustate, true);
+	}
+	PG_CATCH();
+	{
+		/* the kernel must not write the buffer to be released */
+		while (relscan_uring_inflight > 0)
+		{
+			struct io_uring_cqe *cqe;
+
+			if (io_uring_wait_cqe(&relscan_uring, &cqe) == 0)
+			{
+				io_uring_cqe_seen(&relscan_uring, cqe);
+				relscan_uring_inflight--;
+			}
+		}
+		__relScanUringCloseFiles(&ustate);
+		PG_RE_THROW();
+	}
+	PG_END_TRY();
+	__relScanUringCloseFiles(&ustate);
+
+	pg_atomic_fetch_add_u64(&ps_state->npages_vfs_read,
+							nblocks_vfs * PAGES_PER_BLOCK);
+	pg_atomic_fetch_add_u64(&ps_state->npages_buffer_read,
+							(kds->block_nloaded - nblocks_vfs) * PAGES_PER_BLOCK);
+	Assert(kds->nitems == kds->block_nloaded);
+	kds->length = kds->block_offset + BLCKSZ * kds->nitems;
+	if (kds->nitems == 0)
+		return NULL;
+
+	xcmd = (XpuCommand *)pts->xcmd_buf.data;
+	xcmd->u.task.kds_src_pathname = 0;
+	xcmd->u.task.kds_src_iovec = 0;
+	xcmd->length = pts->xcmd_buf.len;
+
+	xcmd_iov[0].iov_base = xcmd;
+	xcmd_iov[0].iov_len  = xcmd->length;
+	*xcmd_iovcnt = 1;
+
+	return xcmd;
+}
+#else
+XpuCommand *
+pgstromRelScanChunkUring(pgstromTaskState *pts,
+						 struct iovec *xcmd_iov, int *xcmd_iovcnt)
+{
+	elog(ERROR, "PG-Strom is not built with liburing");
+}
+#endif	/* HAVE_LIBURING */
+
+/*
+ * __relScanFlattenExternalTuple
+ *
+ * It fetches the external TOAST values of the referenced columns prior to
+ * the chunk build, because the device code cannot access the TOAST relation.
+ * Inline compressed values are kept as is; the device code expands them.
+ */
+static HeapTuple
+__relScanFlattenExternalTuple(pgstromTaskState *pts, HeapTuple tuple)
+{
+	TupleDesc	tupdesc = RelationGetDescr(pts->css.ss.ss_currentRelation);
+	const Bitmapset *outer_refs = pts->pp_info->outer_refs;
+	bool		whole_row_ref;
+	Datum	   *values;
+	bool	   *isnull;
+	bool	   *detoasted;
+	bool		has_external = false;
+	HeapTuple	newtup = NULL;
+
+	whole_row_ref = bms_is_member(-FirstLowInvalidHeapAttributeNumber,
+								  outer_refs);
+	values = alloca(sizeof(Datum) * tupdesc->natts);
+	isnull = alloca(sizeof(bool)  * tupdesc->natts);
+	detoasted = alloca(sizeof(bool) * tupdesc->natts);
+	heap_deform_tuple(tuple, tupdesc, values, isnull);
+	for (int j=0; j < tupdesc->natts; j++)
+	{
+		Form_pg_attribute attr = TupleDescAttr(tupdesc, j);
+		int			k = attr->attnum - FirstLowInvalidHeapAttributeNumber;
+
+		detoasted[j] = false;
+		if (isnull[j] || attr->attlen != -1 ||
+			!VARATT_IS_EXTERNAL_ONDISK(DatumGetPointer(values[j])) ||
+			(!whole_row_ref && !bms_is_member(k, outer_refs)))
+			continue;
+		values[j] = PointerGetDatum(detoast_external_attr((struct varlena *)
+														  DatumGetPointer(values[j])));
+		detoasted[j] = true;
+		has_external = true;
+	}
+	if (has_external)
+	{
+		newtup = heap_form_tuple(tupdesc, values, isnull);
+		/* too large tuple makes no sense; keep the TOAST pointer */
+		if (newtup->t_len > PGSTROM_CHUNK_SIZE / 4)
+		{
+			heap_freetuple(newtup);
+			newtup = NULL;
+		}
+		else
+		{
+			memcpy(&newtup->t_data->t_choice,
+				   &tuple->t_data->t_choice,
+				   sizeof(newtup->t_data->t_choice));
+			newtup->t_self = tuple->t_self;
+			newtup->t_tableOid = tuple->t_tableOid;
+		}
+		for (int j=0; j < tupdesc->natts; j++)
+		{
+			if (detoasted[j])
+				pfree(DatumGetPointer(values[j]));
+		}
+	}
+	return newtup;
+}
+
 static bool
-__kds_row_insert_tuple(kern_data_store *kds, TupleTableSlot *slot)
+__kds_row_insert_tuple(pgstromTaskState *pts,
+					   kern_data_store *kds, TupleTableSlot *slot)
 {
 	uint32_t   *rowindex = KDS_GET_ROWINDEX(kds);
 	HeapTuple	tuple;
@@ -873,6 +1641,18 @@ __kds_row_insert_tuple(kern_data_store *kds, TupleTableSlot *slot)
 
 	Assert(kds->format == KDS_FORMAT_ROW && kds->hash_nslots == 0);
 	tuple = ExecFetchSlotHeapTuple(slot, false, &should_free);
+	if (HeapTupleHasExternal(tuple) && pts->pp_info)
+	{
+		HeapTuple	__tuple = __relScanFlattenExternalTuple(pts, tuple);
+
+		if (__tuple)
+		{
+			if (should_free)
+				heap_freetuple(tuple);
+			tuple = __tuple;
+			should_free = true;
+		}
+	}
 
 	__usage = (__kds_unpack(kds->usage) +
 			   MAXALIGN(offsetof(kern_tupitem, htup) + tuple->t_len));
@@ -930,11 +1710,13 @@ pgstromRelScanChunkNormal(pgstromTaskState *pts,
 				pts->curr_tbm = next_tbm;
 			}
 			if (!TTS_EMPTY(slot) &&
-				!__kds_row_insert_tuple(kds, slot))
+				!__kds_row_insert_tuple(pts, kds, slot))
 				break;
 			if (!table_scan_bitmap_next_tuple(scan, pts->curr_tbm, slot))
 				pts->curr_tbm = NULL;
-			else if (!__kds_row_insert_tuple(kds, slot))
+			else if (pgstromTableSampleSkipTuple(pts, &slot->tts_tid))
+				ExecClearTuple(slot);
+			else if (!__kds_row_insert_tuple(pts, kds, slot))
 				break;
 		}
 	}
@@ -944,14 +1726,16 @@ pgstromRelScanChunkNormal(pgstromTaskState *pts,
 		while (!pts->scan_done)
 		{
 			if (!TTS_EMPTY(slot) &&
-				!__kds_row_insert_tuple(kds, slot))
+				!__kds_row_insert_tuple(pts, kds, slot))
 				break;
 			if (!table_scan_getnextslot(scan, estate->es_direction, slot))
 			{
 				pts->scan_done = true;
 				break;
 			}
-			if (!__kds_row_insert_tuple(kds, slot))
+			if (pgstromTableSampleSkipTuple(pts, &slot->tts_tid))
+				ExecClearTuple(slot);
+			else if (!__kds_row_insert_tuple(pts, kds, slot))
 				break;
 		}
 	}
@@ -977,8 +1761,100 @@ pgstromRelScanChunkNormal(pgstromTaskState *pts,
 	return xcmd;
 }
 
+/*
+ * pgstromRelScanChunkDpuRelay
+ *
+ * It packs the tuples pre-filtered by the DPU into a KDS_FORMAT_ROW chunk,
+ * to be processed by the GPU task.
+ */
+XpuCommand *
+pgstromRelScanChunkDpuRelay(pgstromTaskState *pts,
+							struct iovec *xcmd_iov, int *xcmd_iovcnt)
+{
+	TupleTableSlot *slot = pts->base_slot;
+	kern_data_store *kds;
+	XpuCommand	   *xcmd;
+	size_t			sz1, sz2;
+
+	pts->xcmd_buf.len = __XCMD_KDS_SRC_OFFSET(&pts->xcmd_buf) + PGSTROM_CHUNK_SIZE;
+	enlargeStringInfo(&pts->xcmd_buf, 0);
+	kds = __XCMD_GET_KDS_SRC(&pts->xcmd_buf);
+	kds->nitems = 0;
+	kds->usage  = 0;
+	kds->length = PGSTROM_CHUNK_SIZE;
+
+	while (!pts->scan_done)
+	{
+		if (!TTS_EMPTY(slot) &&
+			!__kds_row_insert_tuple(pts, kds, slot))
+			break;
+		if (!pgstromDpuPreFilterNextTuple(pts, slot))
+		{
+			pts->scan_done = true;
+			break;
+		}
+		if (!__kds_row_insert_tuple(pts, kds, slot))
+			break;
+	}
+
+	if (kds->nitems == 0)
+		return NULL;
+
+	/* setup iovec that may skip the hole between row-index and tuples-buffer */
+	sz1 = ((KDS_BODY_ADDR(kds) - pts->xcmd_buf.data) +
+		   MAXALIGN(sizeof(uint32_t) * kds->nitems));
+	sz2 = __kds_unpack(kds->usage);
+	Assert(sz1 + sz2 <= pts->xcmd_buf.len);
+	kds->length = (KDS_HEAD_LENGTH(kds) +
+				   MAXALIGN(sizeof(uint32_t) * kds->nitems) + sz2);
+	xcmd = (XpuCommand *)pts->xcmd_buf.data;
+	xcmd->length = sz1 + sz2;
+	xcmd_iov[0].iov_base = xcmd;
+	xcmd_iov[0].iov_len  = sz1;
+	xcmd_iov[1].iov_base = (pts->xcmd_buf.data + pts->xcmd_buf.len - sz2);
+	xcmd_iov[1].iov_len  = sz2;
+	*xcmd_iovcnt = 2;
+
+	return xcmd;
+}
+
 void
 pgstrom_init_relscan(void)
 {
-	/* nothing to do */
+	DefineCustomBoolVariable("pg_strom.enable_io_uring_scan",
+							 "Enables io_uring based heap block reader if no GPU-Direct SQL",
+							 NULL,
+							 &pgstrom_enable_io_uring_scan,
+							 true,
+							 PGC_USERSET,
+							 GUC_NOT_IN_SAMPLE,
+							 NULL, NULL, NULL);
+	DefineCustomBoolVariable("pg_strom.enable_gpu_mvcc",
+							 "Enables visibility checks on GPU for the pages not all-visible",
+							 NULL,
+							 &pgstrom_enable_gpu_mvcc,
+							 true,
+							 PGC_USERSET,
+							 GUC_NOT_IN_SAMPLE,
+							 NULL, NULL, NULL);
+	DefineCustomIntVariable("pg_strom.gpu_mvcc_clog_range",
+							"Number of recent transactions whose commit status is shipped to GPU",
+							NULL,
+							&pgstrom_gpu_mvcc_clog_range,
+							65536,
+							0,
+							16777216,
+							PGC_USERSET,
+							GUC_NOT_IN_SAMPLE,
+							NULL, NULL, NULL);
+	DefineCustomIntVariable("pg_strom.gpudirect_merge_gap",
+							"Max number of unused blocks to be read together to merge GPU-Direct I/O requests",
+							NULL,
+							&pgstrom_gpudirect_merge_gap,
+							4,
+							0,
+							RELSEG_SIZE,
+							PGC_USERSET,
+							GUC_NOT_IN_SAMPLE,
+							NULL, NULL, NULL);
 }
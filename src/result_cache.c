@@ -0,0 +1,664 @@
+/*
+ * result_cache.c
+ *
+ * Result cache of the GpuPreAgg nodes for the repeated identical queries.
+ *
+ * BI tools and dashboards often run the same analytic queries with the same
+ * parameters periodically, even though the underlying tables are rarely
+ * updated. Once pg_strom.result_cache_size is configured, the results of
+ * GpuPreAgg that scans a relation are kept on the per-backend host memory,
+ * keyed by the plan, parameters and the user, then returned without any GPU
+ * tasks for the next identical execution.
+ *
+ * Validity of the cached results is tracked by the write-generation of the
+ * relations on the shared memory. Every backend records the relations
+ * modified by the transaction, then bumps the generation of these relations
+ * and records its transaction-id at the pre-commit. A cached result is valid
+ * only if the generation is not changed, and the last writer is already
+ * visible to the snapshot (it precedes the snapshot's xmin). Arrow files are
+ * identified by the inode, size and mtime. DDL commands invalidate the
+ * cached results through the relcache callback.
+ * ----
+ * Copyright 2011-2023 (C) KaiGai Kohei <kaigai@kaigai.gr.jp>
+ * Copyright 2014-2023 (C) PG-Strom Developers Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the PostgreSQL License.
+ */
+#include "pg_strom.h"
+
+#define RESULT_CACHE_NUM_SLOTS		4096
+
+typedef struct
+{
+	pg_atomic_uint64	generation;
+	pg_atomic_uint32	last_writer;	/* TransactionId */
+} resultCacheSlot;
+
+typedef struct
+{
+	resultCacheSlot		slots[RESULT_CACHE_NUM_SLOTS];
+} resultCacheHead;
+
+/*
+ * resultCacheEntry - a cached result on the backend local memory
+ */
+typedef struct
+{
+	dlist_node		chain;		/* link to result_cache_list (LRU order) */
+	uint64_t		hash;		/* hash of the plan, params and user */
+	char		   *plan_str;	/* nodeToString() of the plan */
+	Oid				user_id;
+	Oid				relid;		/* relation to be scanned */
+	uint64_t		generation;	/* generation of the relation (and ancestors) */
+	uint64_t		file_signature;	/* signature of arrow files, or 0 */
+	MemoryContext	memcxt;
+	List		   *tuples;		/* list of MinimalTuple */
+	size_t			usage;
+	int				refcnt;
+	bool			is_valid;	/* false, if invalidated during the reference */
+} resultCacheEntry;
+
+struct pgstromResultCacheState
+{
+	resultCacheEntry *entry;	/* hit or being collected */
+	bool			is_hit;
+	bool			is_done;	/* collection is completed (or aborted) */
+	List		   *slot_ids;	/* slots to check the generation */
+	ListCell	   *curr;		/* current position of the hit entry */
+};
+
+/* static variables */
+static shmem_request_hook_type shmem_request_next = NULL;
+static shmem_startup_hook_type shmem_startup_next = NULL;
+static ExecutorStart_hook_type executor_start_next = NULL;
+static ProcessUtility_hook_type process_utility_next = NULL;
+static resultCacheHead *result_cache_head = NULL;
+static dlist_head	result_cache_list;
+static size_t		result_cache_usage = 0;
+static List		   *result_cache_written_relids = NIL;	/* in TopTransactionContext */
+static int			pgstrom_result_cache_size_kb;	/* GUC */
+
+/*
+ * __resultCacheSlotId
+ */
+static inline int
+__resultCacheSlotId(Oid relid)
+{
+	uint32_t	key[2];
+
+	key[0] = MyDatabaseId;
+	key[1] = relid;
+	return hash_bytes((const unsigned char *)key, sizeof(key)) % RESULT_CACHE_NUM_SLOTS;
+}
+
+/*
+ * __resultCacheCheckSlots
+ *
+ * It returns the combined generation of the slots, or false if the last
+ * writer of any slots may be invisible to the snapshot.
+ */
+static bool
+__resultCacheCheckSlots(List *slot_ids, Snapshot snapshot,
+						uint64_t *p_generation)
+{
+	uint64_t	generation = 0;
+	ListCell   *lc;
+
+	foreach (lc, slot_ids)
+	{
+		resultCacheSlot *slot = &result_cache_head->slots[lfirst_int(lc)];
+		TransactionId	last_writer;
+
+		generation = hash_combine64(generation,
+									pg_atomic_read_u64(&slot->generation));
+		pg_memory_barrier();
+		last_writer = pg_atomic_read_u32(&slot->last_writer);
+		if (TransactionIdIsValid(last_writer) &&
+			!TransactionIdPrecedes(last_writer, snapshot->xmin))
+			return false;
+	}
+	*p_generation = generation;
+	return true;
+}
+
+/*
+ * __resultCacheFreeEntry / __resultCacheRemoveEntry
+ */
+static void
+__resultCacheFreeEntry(resultCacheEntry *entry)
+{
+	Assert(entry->refcnt == 0);
+	MemoryContextDelete(entry->memcxt);
+}
+
+static void
+__resultCacheRemoveEntry(resultCacheEntry *entry)
+{
+	if (entry->is_valid)
+	{
+		dlist_delete(&entry->chain);
+		result_cache_usage -= entry->usage;
+		entry->is_valid = false;
+	}
+	if (entry->refcnt == 0)
+		__resultCacheFreeEntry(entry);
+}
+
+/*
+ * __resultCacheLookup
+ */
+static resultCacheEntry *
+__resultCacheLookup(uint64_t hash, const char *plan_str, Oid relid)
+{
+	dlist_iter	iter;
+
+	dlist_foreach (iter, &result_cache_list)
+	{
+		resultCacheEntry *entry = dlist_container(resultCacheEntry,
+												  chain, iter.cur);
+		if (entry->hash == hash &&
+			entry->user_id == GetUserId() &&
+			entry->relid == relid &&
+			strcmp(entry->plan_str, plan_str) == 0)
+			return entry;
+	}
+	return NULL;
+}
+
+/*
+ * __resultCacheIsCacheable
+ */
+static bool
+__resultCacheIsCacheable(pgstromTaskState *pts)
+{
+	pgstromPlanInfo *pp_info = pts->pp_info;
+	CustomScan *cscan = (CustomScan *)pts->css.ss.ps.plan;
+	EState	   *estate = pts->css.ss.ps.state;
+	Relation	rel = pts->css.ss.ss_currentRelation;
+	List	   *exprs;
+
+	if (pgstrom_result_cache_size_kb <= 0 ||
+		!result_cache_head ||
+		IsParallelWorker() ||
+		estate->es_plannedstmt->parallelModeNeeded ||
+		cscan->scan.plan.parallel_aware ||
+		!bms_is_empty(cscan->scan.plan.extParam) ||
+		(pts->xpu_task_flags & DEVTASK__PREAGG) == 0 ||
+		pts->num_rels > 0 ||
+		pts->dpu_prefilter != NULL ||
+		(pp_info->tablesample_method != TABLESAMPLE_METHOD__NONE &&
+		 pp_info->tablesample_repeatable == NULL) ||
+		!rel ||
+		(rel->rd_rel->relkind != RELKIND_RELATION &&
+		 !(rel->rd_rel->relkind == RELKIND_FOREIGN_TABLE && pts->arrow_state)))
+		return false;
+	/* own writes are not visible to the other transactions yet */
+	if (TransactionIdIsValid(GetTopTransactionIdIfAny()))
+		return false;
+	/* results must depend on the parameters and relations only */
+	exprs = list_make4(cscan->scan.plan.targetlist,
+					   cscan->scan.plan.qual,
+					   cscan->custom_exprs,
+					   cscan->custom_scan_tlist);
+	exprs = lappend(exprs, pp_info->scan_quals);
+	exprs = lappend(exprs, pp_info->host_quals);
+	if (contain_mutable_functions((Node *)exprs))
+		return false;
+	return true;
+}
+
+/*
+ * __resultCacheHashParams
+ */
+static uint64_t
+__resultCacheHashParams(uint64_t hash, ParamListInfo params)
+{
+	if (!params)
+		return hash;
+	for (int i=0; i < params->numParams; i++)
+	{
+		ParamExternData *prm;
+		ParamExternData	prmdata;
+		int16		typlen;
+		bool		typbyval;
+
+		if (params->paramFetch)
+			prm = params->paramFetch(params, i+1, false, &prmdata);
+		else
+			prm = &params->params[i];
+		hash = hash_combine64(hash, ((uint64_t)prm->ptype << 1) | prm->isnull);
+		if (prm->isnull || !OidIsValid(prm->ptype))
+			continue;
+		get_typlenbyval(prm->ptype, &typlen, &typbyval);
+		hash = hash_combine64(hash, datum_image_hash(prm->value,
+													 typbyval, typlen));
+	}
+	return hash;
+}
+
+/*
+ * pgstromResultCacheBegin
+ *
+ * It looks up the result cache of the task, then returns the state to
+ * replay the cached result, or to collect the result to be cached.
+ * NULL means the task is not cacheable.
+ */
+pgstromResultCacheState *
+pgstromResultCacheBegin(pgstromTaskState *pts)
+{
+	EState	   *estate = pts->css.ss.ps.state;
+	Relation	rel = pts->css.ss.ss_currentRelation;
+	Oid			relid;
+	pgstromResultCacheState *rc_state;
+	resultCacheEntry *entry;
+	MemoryContext memcxt;
+	MemoryContext oldcxt;
+	List	   *slot_ids = NIL;
+	char	   *plan_str;
+	uint64_t	hash;
+	uint64_t	generation;
+	uint64_t	file_signature = 0;
+
+	if (!__resultCacheIsCacheable(pts))
+		return NULL;
+	relid = RelationGetRelid(rel);
+	if (pts->arrow_state &&
+		!pgstromArrowFdwFileSignature(pts->arrow_state, &file_signature))
+		return NULL;
+
+	oldcxt = MemoryContextSwitchTo(estate->es_query_cxt);
+	/* write-generation of the relation and its ancestors */
+	slot_ids = list_make1_int(__resultCacheSlotId(relid));
+	if (rel->rd_rel->relispartition)
+	{
+		List	   *ancestors = get_partition_ancestors(relid);
+		ListCell   *lc;
+
+		foreach (lc, ancestors)
+			slot_ids = lappend_int(slot_ids, __resultCacheSlotId(lfirst_oid(lc)));
+	}
+	if (!__resultCacheCheckSlots(slot_ids, estate->es_snapshot, &generation))
+	{
+		MemoryContextSwitchTo(oldcxt);
+		return NULL;
+	}
+	/* hash of the plan, parameters and the user */
+	plan_str = nodeToString(pts->css.ss.ps.plan);
+	hash = hash_bytes_extended((const unsigned char *)plan_str,
+							   strlen(plan_str), GetUserId());
+	hash = __resultCacheHashParams(hash, estate->es_param_list_info);
+
+	rc_state = palloc0(sizeof(pgstromResultCacheState));
+	rc_state->slot_ids = slot_ids;
+	MemoryContextSwitchTo(oldcxt);
+
+	entry = __resultCacheLookup(hash, plan_str, relid);
+	if (entry)
+	{
+		if (entry->generation == generation &&
+			entry->file_signature == file_signature)
+		{
+			dlist_move_head(&result_cache_list, &entry->chain);
+			entry->refcnt++;
+			rc_state->entry = entry;
+			rc_state->is_hit = true;
+			rc_state->curr = list_head(entry->tuples);
+			return rc_state;
+		}
+		__resultCacheRemoveEntry(entry);
+	}
+	/* setup a new entry to collect the results */
+	memcxt = AllocSetContextCreate(TopMemoryContext,
+								   "PG-Strom Result Cache",
+								   ALLOCSET_DEFAULT_SIZES);
+	entry = MemoryContextAllocZero(memcxt, sizeof(resultCacheEntry));
+	entry->hash = hash;
+	entry->plan_str = MemoryContextStrdup(memcxt, plan_str);
+	entry->user_id = GetUserId();
+	entry->relid = relid;
+	entry->generation = generation;
+	entry->file_signature = file_signature;
+	entry->memcxt = memcxt;
+	entry->refcnt = 1;
+	rc_state->entry = entry;
+
+	return rc_state;
+}
+
+/*
+ * pgstromResultCacheIsHit
+ */
+bool
+pgstromResultCacheIsHit(pgstromResultCacheState *rc_state)
+{
+	return (rc_state && rc_state->is_hit);
+}
+
+/*
+ * pgstromResultCacheFetch
+ */
+TupleTableSlot *
+pgstromResultCacheFetch(pgstromResultCacheState *rc_state,
+						TupleTableSlot *slot)
+{
+	resultCacheEntry *entry = rc_state->entry;
+	MinimalTuple	mtup;
+
+	Assert(rc_state->is_hit);
+	if (!rc_state->curr)
+		return NULL;
+	mtup = lfirst(rc_state->curr);
+	rc_state->curr = lnext(entry->tuples, rc_state->curr);
+	ExecForceStoreMinimalTuple(mtup, slot, false);
+
+	return slot;
+}
+
+/*
+ * pgstromResultCacheAppend
+ */
+void
+pgstromResultCacheAppend(pgstromResultCacheState *rc_state,
+						 TupleTableSlot *slot)
+{
+	resultCacheEntry *entry = rc_state->entry;
+	MemoryContext	oldcxt;
+	MinimalTuple	mtup;
+
+	if (rc_state->is_hit || rc_state->is_done)
+		return;
+	oldcxt = MemoryContextSwitchTo(entry->memcxt);
+	mtup = ExecCopySlotMinimalTuple(slot);
+	entry->tuples = lappend(entry->tuples, mtup);
+	entry->usage += mtup->t_len + sizeof(ListCell);
+	MemoryContextSwitchTo(oldcxt);
+
+	/* too large result to be cached */
+	if (entry->usage > ((size_t)pgstrom_result_cache_size_kb << 10) / 4)
+	{
+		rc_state->is_done = true;
+		entry->refcnt--;
+		__resultCacheFreeEntry(entry);
+		rc_state->entry = NULL;
+	}
+}
+
+/*
+ * pgstromResultCacheFinish
+ *
+ * It saves the collected results, if the relation is not modified during
+ * the execution.
+ */
+void
+pgstromResultCacheFinish(pgstromResultCacheState *rc_state,
+						 pgstromTaskState *pts)
+{
+	EState	   *estate = pts->css.ss.ps.state;
+	resultCacheEntry *entry = rc_state->entry;
+	size_t		limit = ((size_t)pgstrom_result_cache_size_kb << 10);
+	uint64_t	generation;
+
+	if (rc_state->is_hit || rc_state->is_done)
+		return;
+	rc_state->is_done = true;
+	rc_state->entry = NULL;
+	entry->refcnt--;
+	if (!__resultCacheCheckSlots(rc_state->slot_ids,
+								 estate->es_snapshot,
+								 &generation) ||
+		generation != entry->generation)
+	{
+		__resultCacheFreeEntry(entry);
+		return;
+	}
+	dlist_push_head(&result_cache_list, &entry->chain);
+	entry->is_valid = true;
+	result_cache_usage += entry->usage;
+	/* evict the older entries */
+	while (result_cache_usage > limit && !dlist_is_empty(&result_cache_list))
+	{
+		dlist_node *dnode = dlist_tail_node(&result_cache_list);
+
+		__resultCacheRemoveEntry(dlist_container(resultCacheEntry,
+												 chain, dnode));
+	}
+}
+
+/*
+ * pgstromResultCacheEnd
+ */
+void
+pgstromResultCacheEnd(pgstromResultCacheState *rc_state)
+{
+	resultCacheEntry *entry;
+
+	if (!rc_state || !(entry = rc_state->entry))
+		return;
+	rc_state->entry = NULL;
+	rc_state->is_done = true;
+	Assert(entry->refcnt > 0);
+	entry->refcnt--;
+	if (!rc_state->is_hit || !entry->is_valid)
+	{
+		/* incomplete results, or already invalidated */
+		if (entry->refcnt == 0)
+			__resultCacheFreeEntry(entry);
+	}
+}
+
+/*
+ * __resultCacheRememberWrites
+ */
+static void
+__resultCacheRememberWrites(Oid relid)
+{
+	MemoryContext	oldcxt;
+
+	if (!OidIsValid(relid) ||
+		list_member_oid(result_cache_written_relids, relid))
+		return;
+	oldcxt = MemoryContextSwitchTo(TopTransactionContext);
+	result_cache_written_relids = lappend_oid(result_cache_written_relids, relid);
+	MemoryContextSwitchTo(oldcxt);
+}
+
+/*
+ * pgstrom_result_cache_executor_start
+ */
+static void
+pgstrom_result_cache_executor_start(QueryDesc *queryDesc, int eflags)
+{
+	PlannedStmt *pstmt = queryDesc->plannedstmt;
+
+	if ((eflags & EXEC_FLAG_EXPLAIN_ONLY) == 0)
+	{
+		ListCell   *lc;
+
+		foreach (lc, pstmt->resultRelations)
+		{
+			RangeTblEntry *rte = rt_fetch(lfirst_int(lc), pstmt->rtable);
+
+			__resultCacheRememberWrites(rte->relid);
+		}
+	}
+	if (executor_start_next)
+		executor_start_next(queryDesc, eflags);
+	else
+		standard_ExecutorStart(queryDesc, eflags);
+}
+
+/*
+ * pgstrom_result_cache_process_utility
+ *
+ * COPY FROM and TRUNCATE modify the relations without the executor.
+ */
+static void
+pgstrom_result_cache_process_utility(PlannedStmt *pstmt,
+									 const char *queryString,
+									 bool readOnlyTree,
+									 ProcessUtilityContext context,
+									 ParamListInfo params,
+									 QueryEnvironment *queryEnv,
+									 DestReceiver *dest,
+									 QueryCompletion *qc)
+{
+	Node	   *parsetree = pstmt->utilityStmt;
+
+	if (IsA(parsetree, CopyStmt))
+	{
+		CopyStmt   *stmt = (CopyStmt *)parsetree;
+
+		if (stmt->is_from && stmt->relation)
+			__resultCacheRememberWrites(RangeVarGetRelid(stmt->relation,
+														 NoLock, true));
+	}
+	else if (IsA(parsetree, TruncateStmt))
+	{
+		TruncateStmt *stmt = (TruncateStmt *)parsetree;
+		ListCell   *lc;
+
+		foreach (lc, stmt->relations)
+			__resultCacheRememberWrites(RangeVarGetRelid(lfirst(lc),
+														 NoLock, true));
+	}
+	if (process_utility_next)
+		process_utility_next(pstmt, queryString, readOnlyTree,
+							 context, params, queryEnv, dest, qc);
+	else
+		standard_ProcessUtility(pstmt, queryString, readOnlyTree,
+								context, params, queryEnv, dest, qc);
+}
+
+/*
+ * resultCacheXactCallback
+ *
+ * It bumps the generation of the modified relations prior to the commit,
+ * so the concurrent sessions never reuse the results computed before.
+ */
+static void
+resultCacheXactCallback(XactEvent event, void *arg)
+{
+	switch (event)
+	{
+		case XACT_EVENT_PRE_COMMIT:
+		case XACT_EVENT_PRE_PREPARE:
+			if (result_cache_head && result_cache_written_relids != NIL)
+			{
+				TransactionId xid = GetTopTransactionIdIfAny();
+				ListCell   *lc;
+
+				if (!TransactionIdIsValid(xid))
+					break;
+				foreach (lc, result_cache_written_relids)
+				{
+					resultCacheSlot *slot = &result_cache_head->slots[
+						__resultCacheSlotId(lfirst_oid(lc))];
+					uint32		curval = pg_atomic_read_u32(&slot->last_writer);
+
+					while (!TransactionIdIsValid(curval) ||
+						   TransactionIdPrecedes(curval, xid))
+					{
+						if (pg_atomic_compare_exchange_u32(&slot->last_writer,
+														   &curval, xid))
+							break;
+					}
+					pg_atomic_fetch_add_u64(&slot->generation, 1);
+				}
+			}
+			result_cache_written_relids = NIL;
+			break;
+		case XACT_EVENT_COMMIT:
+		case XACT_EVENT_ABORT:
+		case XACT_EVENT_PREPARE:
+		case XACT_EVENT_PARALLEL_COMMIT:
+		case XACT_EVENT_PARALLEL_ABORT:
+			/* list is already released with TopTransactionContext */
+			result_cache_written_relids = NIL;
+			break;
+		default:
+			break;
+	}
+}
+
+/*
+ * resultCacheRelcacheCallback
+ */
+static void
+resultCacheRelcacheCallback(Datum arg, Oid relid)
+{
+	dlist_mutable_iter iter;
+
+	dlist_foreach_modify (iter, &result_cache_list)
+	{
+		resultCacheEntry *entry = dlist_container(resultCacheEntry,
+												  chain, iter.cur);
+		if (!OidIsValid(relid) || entry->relid == relid)
+			__resultCacheRemoveEntry(entry);
+	}
+}
+
+/*
+ * pgstrom_request_result_cache
+ */
+static void
+pgstrom_request_result_cache(void)
+{
+	if (shmem_request_next)
+		shmem_request_next();
+	RequestAddinShmemSpace(MAXALIGN(sizeof(resultCacheHead)));
+}
+
+/*
+ * pgstrom_startup_result_cache
+ */
+static void
+pgstrom_startup_result_cache(void)
+{
+	bool		found;
+
+	if (shmem_startup_next)
+		(*shmem_startup_next)();
+
+	result_cache_head = ShmemInitStruct("resultCacheHead",
+										MAXALIGN(sizeof(resultCacheHead)),
+										&found);
+	Assert(!found);
+	for (int i=0; i < RESULT_CACHE_NUM_SLOTS; i++)
+	{
+		pg_atomic_init_u64(&result_cache_head->slots[i].generation, 0);
+		pg_atomic_init_u32(&result_cache_head->slots[i].last_writer,
+						   InvalidTransactionId);
+	}
+}
+
+/*
+ * pgstrom_init_result_cache
+ */
+void
+pgstrom_init_result_cache(void)
+{
+	DefineCustomIntVariable("pg_strom.result_cache_size",
+							"Per-backend memory to cache the results of GpuPreAgg",
+							"0 disables the result cache",
+							&pgstrom_result_cache_size_kb,
+							0,
+							0,
+							INT_MAX,
+							PGC_USERSET,
+							GUC_NOT_IN_SAMPLE | GUC_UNIT_KB,
+							NULL, NULL, NULL);
+	dlist_init(&result_cache_list);
+	/* shared memory size */
+	shmem_request_next = shmem_request_hook;
+	shmem_request_hook = pgstrom_request_result_cache;
+	shmem_startup_next = shmem_startup_hook;
+	shmem_startup_hook = pgstrom_startup_result_cache;
+	/* tracking of the relations modified */
+	executor_start_next = ExecutorStart_hook;
+	ExecutorStart_hook = pgstrom_result_cache_executor_start;
+	process_utility_next = ProcessUtility_hook;
+	ProcessUtility_hook = pgstrom_result_cache_process_utility;
+	RegisterXactCallback(resultCacheXactCallback, NULL);
+	CacheRegisterRelcacheCallback(resultCacheRelcacheCallback, 0);
+}
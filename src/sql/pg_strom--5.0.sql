@@ -21,6 +21,18 @@ CREATE FUNCTION pgstrom.license_query()
   AS 'MODULE_PATHNAME','pgstrom_license_query'
   LANGUAGE C STRICT;
 
+-- Batched execution of the parameterized query; params is a 2-dimensional
+-- array of the parameter sets, and the result rows are prefixed by the
+-- 1-origin index of the parameter set.
+--   e.g) SELECT * FROM pgstrom.batch_query('SELECT count(*) FROM t WHERE cid = $1',
+--                                          '{{100},{200},{300}}')
+--                   AS (batch_id int, count bigint);
+CREATE FUNCTION pgstrom.batch_query(text,     -- query
+                                    text[])   -- params
+  RETURNS SETOF record
+  AS 'MODULE_PATHNAME','pgstrom_batch_query'
+  LANGUAGE C STRICT;
+
 -- System view for device information
 CREATE TYPE pgstrom.__gpu_device_info AS (
   gpu_id        int,
@@ -35,6 +47,143 @@ CREATE FUNCTION pgstrom.gpu_device_info()
 CREATE VIEW pgstrom.gpu_device_info AS
   SELECT * FROM pgstrom.gpu_device_info();
 
+-- System view for GPU service statistics
+CREATE TYPE pgstrom.__pg_stat_gpu_service AS (
+  gpu_id                int,
+  num_workers           int,
+  cmd_queued            int,
+  cmd_running           int,
+  nr_tasks              bigint,
+  nr_fallbacks          bigint,
+  nr_suspends           bigint,
+  npages_direct_read    bigint,
+  npages_vfs_read       bigint,
+  load_time             float8,
+  kernel_time           float8,
+  writeback_time        float8,
+  mpool_raw_nsegs       int,
+  mpool_raw_total       bigint,
+  mpool_raw_active      bigint,
+  mpool_raw_limit       bigint,
+  mpool_managed_nsegs   int,
+  mpool_managed_total   bigint,
+  mpool_managed_active  bigint,
+  stats_reset           timestamptz
+);
+CREATE FUNCTION pgstrom.gpu_service_stats()
+  RETURNS SETOF pgstrom.__pg_stat_gpu_service
+  AS 'MODULE_PATHNAME','pgstrom_gpu_service_stats'
+  LANGUAGE C STRICT;
+CREATE VIEW pgstrom.pg_stat_gpu_service AS
+  SELECT * FROM pgstrom.gpu_service_stats();
+
+-- System view for GPU quota per database/role
+CREATE TYPE pgstrom.__pg_stat_gpu_quota AS (
+  database              text,
+  role                  text,
+  memory_limit          bigint,
+  memory_usage          bigint,
+  memory_peak           bigint,
+  tasks_limit           int,
+  tasks_running         int,
+  action                text,
+  nr_tasks              bigint,
+  nr_waits              bigint,
+  nr_fallbacks          bigint,
+  nr_errors             bigint
+);
+CREATE FUNCTION pgstrom.gpu_quota_stats()
+  RETURNS SETOF pgstrom.__pg_stat_gpu_quota
+  AS 'MODULE_PATHNAME','pgstrom_gpu_quota_stats'
+  LANGUAGE C STRICT;
+CREATE VIEW pgstrom.pg_stat_gpu_quota AS
+  SELECT * FROM pgstrom.gpu_quota_stats();
+
+-- System view for striped GPU-Direct reads on md-raid0
+CREATE TYPE pgstrom.__pg_stat_gpudirect_stripe AS (
+  md_device             text,
+  member_id             int,
+  member_device         text,
+  nr_ios                bigint,
+  nr_pages              bigint,
+  io_time               float8
+);
+CREATE FUNCTION pgstrom.gpudirect_stripe_stats()
+  RETURNS SETOF pgstrom.__pg_stat_gpudirect_stripe
+  AS 'MODULE_PATHNAME','pgstrom_gpudirect_stripe_stats'
+  LANGUAGE C STRICT;
+CREATE VIEW pgstrom.pg_stat_gpudirect_stripe AS
+  SELECT * FROM pgstrom.gpudirect_stripe_stats();
+
+-- System view for GPU-Direct reads per block device and driver
+CREATE TYPE pgstrom.__pg_stat_gpudirect_io AS (
+  device                text,
+  driver                text,
+  nr_ios                bigint,
+  nr_bytes              bigint,
+  io_time               float8,
+  max_latency           float8,
+  throughput            float8,
+  latency_p50           float8,
+  latency_p99           float8,
+  latency_hist          bigint[]
+);
+CREATE FUNCTION pgstrom.gpudirect_io_stats()
+  RETURNS SETOF pgstrom.__pg_stat_gpudirect_io
+  AS 'MODULE_PATHNAME','pgstrom_gpudirect_io_stats'
+  LANGUAGE C STRICT;
+CREATE VIEW pgstrom.pg_stat_gpudirect_io AS
+  SELECT * FROM pgstrom.gpudirect_io_stats();
+CREATE FUNCTION pgstrom.gpudirect_io_stats_reset()
+  RETURNS void
+  AS 'MODULE_PATHNAME','pgstrom_gpudirect_io_stats_reset'
+  LANGUAGE C STRICT;
+
+-- System views for self-calibration of the cost parameters
+CREATE TYPE pgstrom.__cost_calibration_info AS (
+  device                text,
+  nsamples              bigint,
+  est_rows              float8,
+  actual_rows           float8,
+  nchunks               float8,
+  io_bytes              float8,
+  kernel_time           float8,
+  est_startup_cost      float8,
+  actual_startup_time   float8,
+  est_run_cost          float8,
+  actual_run_time       float8,
+  setup_factor          float8,
+  run_factor            float8,
+  last_update           timestamptz,
+  last_report           timestamptz,
+  stats_reset           timestamptz
+);
+CREATE FUNCTION pgstrom.cost_calibration_info()
+  RETURNS SETOF pgstrom.__cost_calibration_info
+  AS 'MODULE_PATHNAME','pgstrom_cost_calibration_info'
+  LANGUAGE C STRICT;
+CREATE VIEW pgstrom.cost_calibration_info AS
+  SELECT * FROM pgstrom.cost_calibration_info();
+
+CREATE TYPE pgstrom.__cost_calibration_recommend AS (
+  device                text,
+  name                  text,
+  setting               float8,
+  recommended           float8,
+  nsamples              bigint
+);
+CREATE FUNCTION pgstrom.cost_calibration_recommend()
+  RETURNS SETOF pgstrom.__cost_calibration_recommend
+  AS 'MODULE_PATHNAME','pgstrom_cost_calibration_recommend'
+  LANGUAGE C STRICT;
+CREATE VIEW pgstrom.cost_calibration_recommend AS
+  SELECT * FROM pgstrom.cost_calibration_recommend();
+
+CREATE FUNCTION pgstrom.cost_calibration_reset()
+  RETURNS void
+  AS 'MODULE_PATHNAME','pgstrom_cost_calibration_reset'
+  LANGUAGE C STRICT;
+
 -- ================================================================
 --
 -- Arrow_Fdw functions
@@ -76,6 +225,59 @@ CREATE FUNCTION pgstrom.arrow_fdw_import_file(text,	    -- relname
   AS 'MODULE_PATHNAME','pgstrom_arrow_fdw_import_file'
   LANGUAGE C;
 
+CREATE FUNCTION pgstrom.export_arrow(text,             -- query
+                                     text,             -- filename
+                                     bool = false)     -- overwrite
+  RETURNS bigint
+  AS 'MODULE_PATHNAME','pgstrom_arrow_export_query'
+  LANGUAGE C STRICT;
+
+-- Incremental aggregates on arrow_fdw foreign tables; the result table
+-- of the aggregate query, and the number of record-batches already merged
+-- for each file.
+-- The bookkeeping tables are shared by all the users, so the functions
+-- below are superuser only; other users can read the tables.
+CREATE TABLE pgstrom.arrow_incremental_aggs (
+  agg_relid     regclass PRIMARY KEY,	-- result table
+  ftable        regclass NOT NULL,	-- arrow_fdw foreign table
+  agg_query     text NOT NULL,
+  agg_merge     text[] NOT NULL		-- 'key' or merge operation per column
+);
+SELECT pg_catalog.pg_extension_config_dump('pgstrom.arrow_incremental_aggs', '');
+REVOKE ALL ON pgstrom.arrow_incremental_aggs FROM PUBLIC;
+GRANT SELECT ON pgstrom.arrow_incremental_aggs TO PUBLIC;
+
+CREATE TABLE pgstrom.arrow_incremental_files (
+  agg_relid     regclass,
+  filename      text,
+  nbatches      int4 NOT NULL,
+  PRIMARY KEY (agg_relid, filename)
+);
+SELECT pg_catalog.pg_extension_config_dump('pgstrom.arrow_incremental_files', '');
+REVOKE ALL ON pgstrom.arrow_incremental_files FROM PUBLIC;
+GRANT SELECT ON pgstrom.arrow_incremental_files TO PUBLIC;
+
+CREATE FUNCTION pgstrom.arrow_incremental_create(text,          -- relname
+                                                 text,          -- query
+                                                 text = null)   -- schema
+  RETURNS regclass
+  AS 'MODULE_PATHNAME','pgstrom_arrow_incremental_create'
+  LANGUAGE C;
+
+CREATE FUNCTION pgstrom.arrow_incremental_refresh(regclass)
+  RETURNS bigint
+  AS 'MODULE_PATHNAME','pgstrom_arrow_incremental_refresh'
+  LANGUAGE C STRICT;
+
+CREATE FUNCTION pgstrom.arrow_incremental_drop(regclass)
+  RETURNS void
+  AS 'MODULE_PATHNAME','pgstrom_arrow_incremental_drop'
+  LANGUAGE C STRICT;
+
+REVOKE ALL ON FUNCTION pgstrom.arrow_incremental_create(text,text,text) FROM PUBLIC;
+REVOKE ALL ON FUNCTION pgstrom.arrow_incremental_refresh(regclass) FROM PUBLIC;
+REVOKE ALL ON FUNCTION pgstrom.arrow_incremental_drop(regclass) FROM PUBLIC;
+
 -- ================================================================
 --
 -- GPU Cache Functions
@@ -102,6 +304,15 @@ CREATE FUNCTION pgstrom.gpucache_recovery(regclass)
   AS 'MODULE_PATHNAME','pgstrom_gpucache_recovery'
   LANGUAGE C STRICT;
 
+CREATE FUNCTION pgstrom.gpucache_aggregate(regclass,
+                                           OUT key     int8,
+                                           OUT nrows   int8,
+                                           OUT nvalues int8,
+                                           OUT sum     numeric)
+  RETURNS SETOF record
+  AS 'MODULE_PATHNAME','pgstrom_gpucache_aggregate'
+  LANGUAGE C STRICT;
+
 CREATE TYPE pgstrom.__pgstrom_gpucache_info_t AS (
     database_oid        oid,
     database_name       text,
@@ -122,6 +333,11 @@ CREATE TYPE pgstrom.__pgstrom_gpucache_info_t AS (
     redo_read_nitems    int8,
     redo_read_pos       int8,
     redo_sync_pos       int8,
+    initload_blocks_done  int8,
+    initload_blocks_total int8,
+    gpu_resident        bool,
+    evict_count         int8,
+    restore_count       int8,
     config_options      text
 );
 
@@ -132,6 +348,71 @@ CREATE FUNCTION pgstrom.__pgstrom_gpucache_info()
 CREATE VIEW pgstrom.gpucache_info AS
   SELECT * FROM pgstrom.__pgstrom_gpucache_info();
 
+-- ================================================================
+--
+-- Zone Map Functions
+--
+-- ================================================================
+
+CREATE FUNCTION pgstrom.zonemap_sync_trigger()
+  RETURNS trigger
+  AS 'MODULE_PATHNAME','pgstrom_zonemap_sync_trigger'
+  LANGUAGE C STRICT;
+
+CREATE FUNCTION pgstrom.zonemap_build(regclass,		-- table
+                                      text[],		-- columns
+                                      int4 = 128)	-- range_pages
+  RETURNS int8
+  AS 'MODULE_PATHNAME','pgstrom_zonemap_build'
+  LANGUAGE C STRICT;
+
+CREATE FUNCTION pgstrom.zonemap_refresh(regclass)
+  RETURNS int8
+  AS 'MODULE_PATHNAME','pgstrom_zonemap_refresh'
+  LANGUAGE C STRICT;
+
+CREATE FUNCTION pgstrom.zonemap_drop(regclass)
+  RETURNS bool
+  AS 'MODULE_PATHNAME','pgstrom_zonemap_drop'
+  LANGUAGE C STRICT;
+REVOKE ALL ON FUNCTION pgstrom.zonemap_build(regclass,text[],int4) FROM PUBLIC;
+REVOKE ALL ON FUNCTION pgstrom.zonemap_refresh(regclass) FROM PUBLIC;
+REVOKE ALL ON FUNCTION pgstrom.zonemap_drop(regclass) FROM PUBLIC;
+
+-- ================================================================
+--
+-- User-defined device functions
+--
+-- ================================================================
+
+-- CUDA C device function for the SQL function. It is declared as
+--   STATIC_FUNCTION(bool)
+--   <func_symbol>(kern_context *kcxt, RTYPE *result, ATYPE1 arg1, ...)
+-- on bool, int1/2/4/8 and float4/8 (bool is int8_t); the SQL function
+-- itself runs on the CPU fallback.
+CREATE TABLE pgstrom.device_functions (
+  func_oid      regprocedure PRIMARY KEY,
+  func_symbol   text NOT NULL,
+  func_cost     int4 NOT NULL,
+  func_source   text NOT NULL
+);
+SELECT pg_catalog.pg_extension_config_dump('pgstrom.device_functions', '');
+REVOKE ALL ON pgstrom.device_functions FROM PUBLIC;
+GRANT SELECT ON pgstrom.device_functions TO PUBLIC;
+
+CREATE FUNCTION pgstrom.define_device_function(regprocedure,	-- function
+                                               text,			-- symbol
+                                               text,			-- source
+                                               int4 = 100)		-- cost
+  RETURNS void
+  AS 'MODULE_PATHNAME','pgstrom_define_device_function'
+  LANGUAGE C STRICT;
+
+CREATE FUNCTION pgstrom.drop_device_function(regprocedure)
+  RETURNS bool
+  AS 'MODULE_PATHNAME','pgstrom_drop_device_function'
+  LANGUAGE C STRICT;
+
 -- ==================================================================
 --
 -- float2 - half-precision floating point data support
@@ -1089,6 +1370,39 @@ CREATE AGGREGATE pg_catalog.stddev(float2) (
   initcond = "{0,0,0}"
 );
 
+--
+-- float vector (float2[] / float4[]) distance functions
+--
+CREATE FUNCTION pgstrom.float2_dot_product(float2[], float2[])
+  RETURNS float4
+  AS 'MODULE_PATHNAME','pgstrom_float2_dot_product'
+  LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE FUNCTION pgstrom.float2_l2_distance(float2[], float2[])
+  RETURNS float4
+  AS 'MODULE_PATHNAME','pgstrom_float2_l2_distance'
+  LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE FUNCTION pgstrom.float2_cosine_distance(float2[], float2[])
+  RETURNS float4
+  AS 'MODULE_PATHNAME','pgstrom_float2_cosine_distance'
+  LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE FUNCTION pgstrom.float4_dot_product(float4[], float4[])
+  RETURNS float4
+  AS 'MODULE_PATHNAME','pgstrom_float4_dot_product'
+  LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE FUNCTION pgstrom.float4_l2_distance(float4[], float4[])
+  RETURNS float4
+  AS 'MODULE_PATHNAME','pgstrom_float4_l2_distance'
+  LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE FUNCTION pgstrom.float4_cosine_distance(float4[], float4[])
+  RETURNS float4
+  AS 'MODULE_PATHNAME','pgstrom_float4_cosine_distance'
+  LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
 --
 -- float2 index support
 --
@@ -3067,6 +3381,50 @@ CREATE AGGREGATE pgstrom.avg_num(bytea)
   parallel = safe
 );
 
+---
+--- SUM(X),AVG(X) on NUMERIC by the exact 128bit fixed-point
+---
+CREATE FUNCTION pgstrom.psum_numeric(numeric, int4)
+  RETURNS bytea
+  AS 'MODULE_PATHNAME','pgstrom_partial_sum_numeric'
+  LANGUAGE C STRICT PARALLEL SAFE;
+
+CREATE FUNCTION pgstrom.pavg_numeric(numeric, int4)
+  RETURNS bytea
+  AS 'MODULE_PATHNAME','pgstrom_partial_sum_numeric'
+  LANGUAGE C STRICT PARALLEL SAFE;
+
+CREATE FUNCTION pgstrom.fsum_trans_numeric(bytea, bytea)
+  RETURNS bytea
+  AS 'MODULE_PATHNAME','pgstrom_fsum_trans_numeric'
+  LANGUAGE C CALLED ON NULL INPUT PARALLEL SAFE;
+
+CREATE FUNCTION pgstrom.fsum_final_numeric(bytea)
+  RETURNS numeric
+  AS 'MODULE_PATHNAME','pgstrom_fsum_final_numeric'
+  LANGUAGE C STRICT PARALLEL SAFE;
+
+CREATE FUNCTION pgstrom.favg_final_numeric(bytea)
+  RETURNS numeric
+  AS 'MODULE_PATHNAME','pgstrom_favg_final_numeric'
+  LANGUAGE C STRICT PARALLEL SAFE;
+
+CREATE AGGREGATE pgstrom.sum_numeric(bytea)
+(
+  sfunc = pgstrom.fsum_trans_numeric,
+  stype = bytea,
+  finalfunc = pgstrom.fsum_final_numeric,
+  parallel = safe
+);
+
+CREATE AGGREGATE pgstrom.avg_numeric(bytea)
+(
+  sfunc = pgstrom.fsum_trans_numeric,
+  stype = bytea,
+  finalfunc = pgstrom.favg_final_numeric,
+  parallel = safe
+);
+
 ---
 --- STDDEV/VARIANCE
 ---
@@ -3340,6 +3698,548 @@ CREATE AGGREGATE pgstrom.regr_syy(bytea)
   parallel = safe
 );
 
+---
+--- PERCENTILE_APPROX
+---
+CREATE FUNCTION pgstrom.pquantile(float8,float8)
+  RETURNS bytea
+  AS 'MODULE_PATHNAME','pgstrom_partial_quantile'
+  LANGUAGE C STRICT;
+
+CREATE FUNCTION pgstrom.pquantile_accum(bytea,bytea)
+  RETURNS bytea
+  AS 'MODULE_PATHNAME','pgstrom_pquantile_accum'
+  LANGUAGE C CALLED ON NULL INPUT;
+
+CREATE FUNCTION pgstrom.percentile_approx_trans(bytea,float8,float8)
+  RETURNS bytea
+  AS 'MODULE_PATHNAME','pgstrom_percentile_approx_trans'
+  LANGUAGE C CALLED ON NULL INPUT;
+
+CREATE FUNCTION pgstrom.percentile_approx_final(bytea)
+  RETURNS float8
+  AS 'MODULE_PATHNAME','pgstrom_percentile_approx_final'
+  LANGUAGE C STRICT PARALLEL SAFE;
+
+CREATE AGGREGATE pgstrom.percentile_approx(bytea)
+(
+  sfunc = pgstrom.pquantile_accum,
+  stype = bytea,
+  finalfunc = pgstrom.percentile_approx_final,
+  parallel = safe
+);
+
+-- percentile_approx(value, fraction); e.g, fraction=0.5 for median
+CREATE AGGREGATE pgstrom.percentile_approx(float8,float8)
+(
+  sfunc = pgstrom.percentile_approx_trans,
+  stype = bytea,
+  finalfunc = pgstrom.percentile_approx_final,
+  combinefunc = pgstrom.pquantile_accum,
+  parallel = safe
+);
+
+---
+--- TOP_K
+---
+CREATE FUNCTION pgstrom.ptopk(float8,int4)
+  RETURNS bytea
+  AS 'MODULE_PATHNAME','pgstrom_partial_topk'
+  LANGUAGE C STRICT;
+
+CREATE FUNCTION pgstrom.ptopk_accum(bytea,bytea)
+  RETURNS bytea
+  AS 'MODULE_PATHNAME','pgstrom_ptopk_accum'
+  LANGUAGE C CALLED ON NULL INPUT;
+
+CREATE FUNCTION pgstrom.top_k_trans(bytea,float8,int4)
+  RETURNS bytea
+  AS 'MODULE_PATHNAME','pgstrom_top_k_trans'
+  LANGUAGE C CALLED ON NULL INPUT;
+
+CREATE FUNCTION pgstrom.top_k_final(bytea)
+  RETURNS float8[]
+  AS 'MODULE_PATHNAME','pgstrom_top_k_final'
+  LANGUAGE C STRICT PARALLEL SAFE;
+
+CREATE AGGREGATE pgstrom.top_k(bytea)
+(
+  sfunc = pgstrom.ptopk_accum,
+  stype = bytea,
+  finalfunc = pgstrom.top_k_final,
+  parallel = safe
+);
+
+-- top_k(value, k); the largest k values (k <= 32) in descending order
+CREATE AGGREGATE pgstrom.top_k(float8,int4)
+(
+  sfunc = pgstrom.top_k_trans,
+  stype = bytea,
+  finalfunc = pgstrom.top_k_final,
+  combinefunc = pgstrom.ptopk_accum,
+  parallel = safe
+);
+
+---
+--- ARRAY_AGG / STRING_AGG
+---
+--- The final aggregates take the partial state, the element type (a dummy
+--- NULL) or the delimiter, the sort operator of ORDER BY (0 if unordered)
+--- and the nulls-first flag.
+---
+CREATE FUNCTION pgstrom.parray(anynonarray)
+  RETURNS bytea
+  AS 'MODULE_PATHNAME','pgstrom_partial_array'
+  LANGUAGE C CALLED ON NULL INPUT;
+
+CREATE FUNCTION pgstrom.parray(anynonarray,"any")
+  RETURNS bytea
+  AS 'MODULE_PATHNAME','pgstrom_partial_array'
+  LANGUAGE C CALLED ON NULL INPUT;
+
+CREATE FUNCTION pgstrom.parray_accum(internal,bytea,anynonarray,oid,bool)
+  RETURNS internal
+  AS 'MODULE_PATHNAME','pgstrom_parray_accum'
+  LANGUAGE C CALLED ON NULL INPUT;
+
+CREATE FUNCTION pgstrom.array_agg_final(internal,bytea,anynonarray,oid,bool)
+  RETURNS anyarray
+  AS 'MODULE_PATHNAME','pgstrom_array_agg_final'
+  LANGUAGE C CALLED ON NULL INPUT PARALLEL SAFE;
+
+CREATE AGGREGATE pgstrom.array_agg(bytea,anynonarray,oid,bool)
+(
+  sfunc = pgstrom.parray_accum,
+  stype = internal,
+  finalfunc = pgstrom.array_agg_final,
+  finalfunc_extra,
+  parallel = safe
+);
+
+CREATE FUNCTION pgstrom.pstring_accum(internal,bytea,text,oid,bool)
+  RETURNS internal
+  AS 'MODULE_PATHNAME','pgstrom_pstring_accum'
+  LANGUAGE C CALLED ON NULL INPUT;
+
+CREATE FUNCTION pgstrom.string_agg_final(internal,bytea,text,oid,bool)
+  RETURNS text
+  AS 'MODULE_PATHNAME','pgstrom_string_agg_final'
+  LANGUAGE C CALLED ON NULL INPUT PARALLEL SAFE;
+
+CREATE AGGREGATE pgstrom.string_agg(bytea,text,oid,bool)
+(
+  sfunc = pgstrom.pstring_accum,
+  stype = internal,
+  finalfunc = pgstrom.string_agg_final,
+  finalfunc_extra,
+  parallel = safe
+);
+
+---
+--- HyperLogLog sketch
+---
+--- A sketch is a bytea of 2^N registers (N = pg_strom.hll_registers_bits),
+--- so it can be stored in a rollup table, then merged by hll_union() or
+--- hll_count() later. Sketches are mergeable only if N is identical.
+---
+CREATE FUNCTION pgstrom.hll_hash(int1)
+  RETURNS bigint
+  AS 'MODULE_PATHNAME','pgstrom_hll_hash_int1'
+  LANGUAGE C STRICT PARALLEL SAFE;
+
+CREATE FUNCTION pgstrom.hll_sketch_update(bytea, int1)
+  RETURNS bytea
+  AS 'MODULE_PATHNAME','pgstrom_hll_sketch_update_int1'
+  LANGUAGE C CALLED ON NULL INPUT PARALLEL SAFE;
+
+CREATE FUNCTION pgstrom.hll_hash(int2)
+  RETURNS bigint
+  AS 'MODULE_PATHNAME','pgstrom_hll_hash_int2'
+  LANGUAGE C STRICT PARALLEL SAFE;
+
+CREATE FUNCTION pgstrom.hll_sketch_update(bytea, int2)
+  RETURNS bytea
+  AS 'MODULE_PATHNAME','pgstrom_hll_sketch_update_int2'
+  LANGUAGE C CALLED ON NULL INPUT PARALLEL SAFE;
+
+CREATE FUNCTION pgstrom.hll_hash(int4)
+  RETURNS bigint
+  AS 'MODULE_PATHNAME','pgstrom_hll_hash_int4'
+  LANGUAGE C STRICT PARALLEL SAFE;
+
+CREATE FUNCTION pgstrom.hll_sketch_update(bytea, int4)
+  RETURNS bytea
+  AS 'MODULE_PATHNAME','pgstrom_hll_sketch_update_int4'
+  LANGUAGE C CALLED ON NULL INPUT PARALLEL SAFE;
+
+CREATE FUNCTION pgstrom.hll_hash(int8)
+  RETURNS bigint
+  AS 'MODULE_PATHNAME','pgstrom_hll_hash_int8'
+  LANGUAGE C STRICT PARALLEL SAFE;
+
+CREATE FUNCTION pgstrom.hll_sketch_update(bytea, int8)
+  RETURNS bytea
+  AS 'MODULE_PATHNAME','pgstrom_hll_sketch_update_int8'
+  LANGUAGE C CALLED ON NULL INPUT PARALLEL SAFE;
+
+CREATE FUNCTION pgstrom.hll_hash(numeric)
+  RETURNS bigint
+  AS 'MODULE_PATHNAME','pgstrom_hll_hash_numeric'
+  LANGUAGE C STRICT PARALLEL SAFE;
+
+CREATE FUNCTION pgstrom.hll_sketch_update(bytea, numeric)
+  RETURNS bytea
+  AS 'MODULE_PATHNAME','pgstrom_hll_sketch_update_numeric'
+  LANGUAGE C CALLED ON NULL INPUT PARALLEL SAFE;
+
+CREATE FUNCTION pgstrom.hll_hash(date)
+  RETURNS bigint
+  AS 'MODULE_PATHNAME','pgstrom_hll_hash_date'
+  LANGUAGE C STRICT PARALLEL SAFE;
+
+CREATE FUNCTION pgstrom.hll_sketch_update(bytea, date)
+  RETURNS bytea
+  AS 'MODULE_PATHNAME','pgstrom_hll_sketch_update_date'
+  LANGUAGE C CALLED ON NULL INPUT PARALLEL SAFE;
+
+CREATE FUNCTION pgstrom.hll_hash(time)
+  RETURNS bigint
+  AS 'MODULE_PATHNAME','pgstrom_hll_hash_time'
+  LANGUAGE C STRICT PARALLEL SAFE;
+
+CREATE FUNCTION pgstrom.hll_sketch_update(bytea, time)
+  RETURNS bytea
+  AS 'MODULE_PATHNAME','pgstrom_hll_sketch_update_time'
+  LANGUAGE C CALLED ON NULL INPUT PARALLEL SAFE;
+
+CREATE FUNCTION pgstrom.hll_hash(timetz)
+  RETURNS bigint
+  AS 'MODULE_PATHNAME','pgstrom_hll_hash_timetz'
+  LANGUAGE C STRICT PARALLEL SAFE;
+
+CREATE FUNCTION pgstrom.hll_sketch_update(bytea, timetz)
+  RETURNS bytea
+  AS 'MODULE_PATHNAME','pgstrom_hll_sketch_update_timetz'
+  LANGUAGE C CALLED ON NULL INPUT PARALLEL SAFE;
+
+CREATE FUNCTION pgstrom.hll_hash(timestamp)
+  RETURNS bigint
+  AS 'MODULE_PATHNAME','pgstrom_hll_hash_timestamp'
+  LANGUAGE C STRICT PARALLEL SAFE;
+
+CREATE FUNCTION pgstrom.hll_sketch_update(bytea, timestamp)
+  RETURNS bytea
+  AS 'MODULE_PATHNAME','pgstrom_hll_sketch_update_timestamp'
+  LANGUAGE C CALLED ON NULL INPUT PARALLEL SAFE;
+
+CREATE FUNCTION pgstrom.hll_hash(timestamptz)
+  RETURNS bigint
+  AS 'MODULE_PATHNAME','pgstrom_hll_hash_timestamptz'
+  LANGUAGE C STRICT PARALLEL SAFE;
+
+CREATE FUNCTION pgstrom.hll_sketch_update(bytea, timestamptz)
+  RETURNS bytea
+  AS 'MODULE_PATHNAME','pgstrom_hll_sketch_update_timestamptz'
+  LANGUAGE C CALLED ON NULL INPUT PARALLEL SAFE;
+
+CREATE FUNCTION pgstrom.hll_hash(bpchar)
+  RETURNS bigint
+  AS 'MODULE_PATHNAME','pgstrom_hll_hash_bpchar'
+  LANGUAGE C STRICT PARALLEL SAFE;
+
+CREATE FUNCTION pgstrom.hll_sketch_update(bytea, bpchar)
+  RETURNS bytea
+  AS 'MODULE_PATHNAME','pgstrom_hll_sketch_update_bpchar'
+  LANGUAGE C CALLED ON NULL INPUT PARALLEL SAFE;
+
+CREATE FUNCTION pgstrom.hll_hash(text)
+  RETURNS bigint
+  AS 'MODULE_PATHNAME','pgstrom_hll_hash_varlena'
+  LANGUAGE C STRICT PARALLEL SAFE;
+
+CREATE FUNCTION pgstrom.hll_sketch_update(bytea, text)
+  RETURNS bytea
+  AS 'MODULE_PATHNAME','pgstrom_hll_sketch_update_varlena'
+  LANGUAGE C CALLED ON NULL INPUT PARALLEL SAFE;
+
+CREATE FUNCTION pgstrom.hll_hash(uuid)
+  RETURNS bigint
+  AS 'MODULE_PATHNAME','pgstrom_hll_hash_uuid'
+  LANGUAGE C STRICT PARALLEL SAFE;
+
+CREATE FUNCTION pgstrom.hll_sketch_update(bytea, uuid)
+  RETURNS bytea
+  AS 'MODULE_PATHNAME','pgstrom_hll_sketch_update_uuid'
+  LANGUAGE C CALLED ON NULL INPUT PARALLEL SAFE;
+
+--- Makes a new HLL Sketch by hash
+CREATE FUNCTION pgstrom.hll_sketch_new(bigint)
+  RETURNS bytea
+  AS 'MODULE_PATHNAME','pgstrom_hll_sketch_new'
+  LANGUAGE C STRICT PARALLEL SAFE;
+
+--- Merge two HLL Sketches
+CREATE FUNCTION pgstrom.hll_sketch_merge(bytea, bytea)
+  RETURNS bytea
+  AS 'MODULE_PATHNAME','pgstrom_hll_sketch_merge'
+  LANGUAGE C CALLED ON NULL INPUT PARALLEL SAFE;
+
+--- Make estimation of the cardinarity from the HLL Sketch
+CREATE FUNCTION pgstrom.hll_count_final(bytea)
+  RETURNS bigint
+  AS 'MODULE_PATHNAME','pgstrom_hll_count_final'
+  LANGUAGE C CALLED ON NULL INPUT PARALLEL SAFE;
+
+CREATE FUNCTION pgstrom.hll_cardinality(bytea)
+  RETURNS bigint
+  AS 'MODULE_PATHNAME','pgstrom_hll_count_final'
+  LANGUAGE C CALLED ON NULL INPUT PARALLEL SAFE;
+
+--- Histgram of HLL Sketch
+CREATE FUNCTION pgstrom.hll_sketch_histogram(bytea)
+  RETURNS int4[]
+  AS 'MODULE_PATHNAME','pgstrom_hll_sketch_histogram'
+  LANGUAGE C STRICT PARALLEL SAFE;
+
+--- Union of the stored HLL Sketches
+CREATE AGGREGATE pgstrom.hll_union(bytea)
+(
+  sfunc = pgstrom.hll_sketch_merge,
+  stype = bytea,
+  combinefunc = pgstrom.hll_sketch_merge,
+  parallel = safe
+);
+
+CREATE AGGREGATE pgstrom.hll_count(bytea)
+(
+  sfunc = pgstrom.hll_sketch_merge,
+  stype = bytea,
+  finalfunc = pgstrom.hll_count_final,
+  combinefunc = pgstrom.hll_sketch_merge,
+  parallel = safe
+);
+
+CREATE AGGREGATE pgstrom.hll_count(int1)
+(
+  sfunc = pgstrom.hll_sketch_update,
+  stype = bytea,
+  finalfunc = pgstrom.hll_count_final,
+  combinefunc = pgstrom.hll_sketch_merge,
+  parallel = safe
+);
+
+CREATE AGGREGATE pgstrom.hll_sketch(int1)
+(
+  sfunc = pgstrom.hll_sketch_update,
+  stype = bytea,
+  combinefunc = pgstrom.hll_sketch_merge,
+  parallel = safe
+);
+
+CREATE AGGREGATE pgstrom.hll_count(int2)
+(
+  sfunc = pgstrom.hll_sketch_update,
+  stype = bytea,
+  finalfunc = pgstrom.hll_count_final,
+  combinefunc = pgstrom.hll_sketch_merge,
+  parallel = safe
+);
+
+CREATE AGGREGATE pgstrom.hll_sketch(int2)
+(
+  sfunc = pgstrom.hll_sketch_update,
+  stype = bytea,
+  combinefunc = pgstrom.hll_sketch_merge,
+  parallel = safe
+);
+
+CREATE AGGREGATE pgstrom.hll_count(int4)
+(
+  sfunc = pgstrom.hll_sketch_update,
+  stype = bytea,
+  finalfunc = pgstrom.hll_count_final,
+  combinefunc = pgstrom.hll_sketch_merge,
+  parallel = safe
+);
+
+CREATE AGGREGATE pgstrom.hll_sketch(int4)
+(
+  sfunc = pgstrom.hll_sketch_update,
+  stype = bytea,
+  combinefunc = pgstrom.hll_sketch_merge,
+  parallel = safe
+);
+
+CREATE AGGREGATE pgstrom.hll_count(int8)
+(
+  sfunc = pgstrom.hll_sketch_update,
+  stype = bytea,
+  finalfunc = pgstrom.hll_count_final,
+  combinefunc = pgstrom.hll_sketch_merge,
+  parallel = safe
+);
+
+CREATE AGGREGATE pgstrom.hll_sketch(int8)
+(
+  sfunc = pgstrom.hll_sketch_update,
+  stype = bytea,
+  combinefunc = pgstrom.hll_sketch_merge,
+  parallel = safe
+);
+
+CREATE AGGREGATE pgstrom.hll_count(numeric)
+(
+  sfunc = pgstrom.hll_sketch_update,
+  stype = bytea,
+  finalfunc = pgstrom.hll_count_final,
+  combinefunc = pgstrom.hll_sketch_merge,
+  parallel = safe
+);
+
+CREATE AGGREGATE pgstrom.hll_sketch(numeric)
+(
+  sfunc = pgstrom.hll_sketch_update,
+  stype = bytea,
+  combinefunc = pgstrom.hll_sketch_merge,
+  parallel = safe
+);
+
+CREATE AGGREGATE pgstrom.hll_count(date)
+(
+  sfunc = pgstrom.hll_sketch_update,
+  stype = bytea,
+  finalfunc = pgstrom.hll_count_final,
+  combinefunc = pgstrom.hll_sketch_merge,
+  parallel = safe
+);
+
+CREATE AGGREGATE pgstrom.hll_sketch(date)
+(
+  sfunc = pgstrom.hll_sketch_update,
+  stype = bytea,
+  combinefunc = pgstrom.hll_sketch_merge,
+  parallel = safe
+);
+
+CREATE AGGREGATE pgstrom.hll_count(time)
+(
+  sfunc = pgstrom.hll_sketch_update,
+  stype = bytea,
+  finalfunc = pgstrom.hll_count_final,
+  combinefunc = pgstrom.hll_sketch_merge,
+  parallel = safe
+);
+
+CREATE AGGREGATE pgstrom.hll_sketch(time)
+(
+  sfunc = pgstrom.hll_sketch_update,
+  stype = bytea,
+  combinefunc = pgstrom.hll_sketch_merge,
+  parallel = safe
+);
+
+CREATE AGGREGATE pgstrom.hll_count(timetz)
+(
+  sfunc = pgstrom.hll_sketch_update,
+  stype = bytea,
+  finalfunc = pgstrom.hll_count_final,
+  combinefunc = pgstrom.hll_sketch_merge,
+  parallel = safe
+);
+
+CREATE AGGREGATE pgstrom.hll_sketch(timetz)
+(
+  sfunc = pgstrom.hll_sketch_update,
+  stype = bytea,
+  combinefunc = pgstrom.hll_sketch_merge,
+  parallel = safe
+);
+
+CREATE AGGREGATE pgstrom.hll_count(timestamp)
+(
+  sfunc = pgstrom.hll_sketch_update,
+  stype = bytea,
+  finalfunc = pgstrom.hll_count_final,
+  combinefunc = pgstrom.hll_sketch_merge,
+  parallel = safe
+);
+
+CREATE AGGREGATE pgstrom.hll_sketch(timestamp)
+(
+  sfunc = pgstrom.hll_sketch_update,
+  stype = bytea,
+  combinefunc = pgstrom.hll_sketch_merge,
+  parallel = safe
+);
+
+CREATE AGGREGATE pgstrom.hll_count(timestamptz)
+(
+  sfunc = pgstrom.hll_sketch_update,
+  stype = bytea,
+  finalfunc = pgstrom.hll_count_final,
+  combinefunc = pgstrom.hll_sketch_merge,
+  parallel = safe
+);
+
+CREATE AGGREGATE pgstrom.hll_sketch(timestamptz)
+(
+  sfunc = pgstrom.hll_sketch_update,
+  stype = bytea,
+  combinefunc = pgstrom.hll_sketch_merge,
+  parallel = safe
+);
+
+CREATE AGGREGATE pgstrom.hll_count(bpchar)
+(
+  sfunc = pgstrom.hll_sketch_update,
+  stype = bytea,
+  finalfunc = pgstrom.hll_count_final,
+  combinefunc = pgstrom.hll_sketch_merge,
+  parallel = safe
+);
+
+CREATE AGGREGATE pgstrom.hll_sketch(bpchar)
+(
+  sfunc = pgstrom.hll_sketch_update,
+  stype = bytea,
+  combinefunc = pgstrom.hll_sketch_merge,
+  parallel = safe
+);
+
+CREATE AGGREGATE pgstrom.hll_count(text)
+(
+  sfunc = pgstrom.hll_sketch_update,
+  stype = bytea,
+  finalfunc = pgstrom.hll_count_final,
+  combinefunc = pgstrom.hll_sketch_merge,
+  parallel = safe
+);
+
+CREATE AGGREGATE pgstrom.hll_sketch(text)
+(
+  sfunc = pgstrom.hll_sketch_update,
+  stype = bytea,
+  combinefunc = pgstrom.hll_sketch_merge,
+  parallel = safe
+);
+
+CREATE AGGREGATE pgstrom.hll_count(uuid)
+(
+  sfunc = pgstrom.hll_sketch_update,
+  stype = bytea,
+  finalfunc = pgstrom.hll_count_final,
+  combinefunc = pgstrom.hll_sketch_merge,
+  parallel = safe
+);
+
+CREATE AGGREGATE pgstrom.hll_sketch(uuid)
+(
+  sfunc = pgstrom.hll_sketch_update,
+  stype = bytea,
+  combinefunc = pgstrom.hll_sketch_merge,
+  parallel = safe
+);
+
 -- ==================================================================
 --
 -- PG-Strom regression test support functions
@@ -10,6 +10,7 @@
  * it under the terms of the PostgreSQL License.
  */
 #include "xpu_common.h"
+#include <math.h>
 
 /* ----------------------------------------------------------------
  *
@@ -104,6 +105,28 @@ __extract_heap_tuple_sysattr(kern_context *kcxt,
 	return false;
 }
 
+/*
+ * __heap_tuple_nonull_prefix
+ *
+ * It returns the number of the leading attributes that are not NULL.
+ * attcacheoff of the attributes are valid on the tuple as long as all
+ * the preceding attributes are not NULL, even if HEAP_HASNULL is set.
+ */
+INLINE_FUNCTION(int)
+__heap_tuple_nonull_prefix(const uint8_t *nullmap, int ncols)
+{
+	int		i = 0;
+
+	if (!nullmap)
+		return ncols;
+	/* skip 8 attributes at once, if all not null */
+	while (i + 8 <= ncols && nullmap[i >> 3] == 0xff)
+		i += 8;
+	while (i < ncols && !att_isnull(i, nullmap))
+		i++;
+	return i;
+}
+
 STATIC_FUNCTION(bool)
 kern_extract_heap_tuple(kern_context *kcxt,
 						const kern_data_store *kds,
@@ -116,41 +139,49 @@ kern_extract_heap_tuple(kern_context *kcxt,
 	int			kvload_count = 0;
 	int			ncols = Min(htup->t_infomask2 & HEAP_NATTS_MASK, kds->ncols);
 	bool		heap_hasnull = ((htup->t_infomask & HEAP_HASNULL) != 0);
+	int			nonull_prefix;
 
 	/* extract system attributes, if rquired */
 	while (kvload_count < kvload_nitems &&
 		   vl_desc->vl_resno < 0)
 	{
 		if (!__extract_heap_tuple_sysattr(kcxt, kds, htup, vl_desc))
-			return;
+			return false;
 		vl_desc++;
 		kvload_count++;
 	}
-	/* try attcacheoff shortcut, if available. */
-	if (!heap_hasnull)
+
+	/*
+	 * try attcacheoff shortcut, if available.
+	 *
+	 * The attributes with attcacheoff are fixed-length ones (and the first
+	 * varlena) with no varlena before them, so the offset is constant
+	 * unless any preceding attribute is NULL. The slow path walks the
+	 * remaining attributes from the last one loaded here
+	 */
+	nonull_prefix = __heap_tuple_nonull_prefix(heap_hasnull ? htup->t_bits : NULL,
+											   ncols);
+	while (kvload_count < kvload_nitems &&
+		   vl_desc->vl_resno > 0 &&
+		   vl_desc->vl_resno <= nonull_prefix)
 	{
-		while (kvload_count < kvload_nitems &&
-			   vl_desc->vl_resno > 0 &&
-			   vl_desc->vl_resno <= ncols)
-		{
-			const kern_colmeta *cmeta = &kds->colmeta[vl_desc->vl_resno-1];
-			char	   *addr;
+		const kern_colmeta *cmeta = &kds->colmeta[vl_desc->vl_resno-1];
+		char	   *addr;
 
-			if (cmeta->attcacheoff < 0)
-				break;
-			offset = htup->t_hoff + cmeta->attcacheoff;
-			addr = (char *)htup + offset;
-			if (!__extract_heap_tuple_attr(kcxt, vl_desc->vl_slot_id, addr))
-				return false;
-			/* next resno */
-			resno = vl_desc->vl_resno + 1;
-			if (cmeta->attlen > 0)
-				offset += cmeta->attlen;
-			else
-				offset += VARSIZE_ANY(addr);
-			vl_desc++;
-			kvload_count++;
-		}
+		if (cmeta->attcacheoff < 0)
+			break;
+		offset = htup->t_hoff + cmeta->attcacheoff;
+		addr = (char *)htup + offset;
+		if (!__extract_heap_tuple_attr(kcxt, vl_desc->vl_slot_id, addr))
+			return false;
+		/* next resno */
+		resno = vl_desc->vl_resno + 1;
+		if (cmeta->attlen > 0)
+			offset += cmeta->attlen;
+		else
+			offset += VARSIZE_ANY(addr);
+		vl_desc++;
+		kvload_count++;
 	}
 
 	/* extract slow path */
@@ -390,6 +421,54 @@ pgfn_VarExpr(XPU_PGFUNCTION_ARGS)
 	return true;
 }
 
+/*
+ * __pgfn_BoolExprAndAdaptive
+ *
+ * BoolExpr(AND) of the scan-quals that evaluates the arguments in the order
+ * given by the GPU service, and counts the pass rate of each argument.
+ */
+STATIC_FUNCTION(bool)
+__pgfn_BoolExprAndAdaptive(XPU_PGFUNCTION_ARGS)
+{
+	xpu_bool_t *result = (xpu_bool_t *)__result;
+	const kern_expression *kargs[KERN_ADAPTIVE_QUALS_MAX];
+	uint64_t	order = kcxt->scan_quals_order;
+	bool		anynull = false;
+	const kern_expression *karg;
+	int			i, k;
+
+	assert(kexp->nr_args <= KERN_ADAPTIVE_QUALS_MAX);
+	for (i=0, karg=KEXP_FIRST_ARG(kexp);
+		 i < kexp->nr_args;
+		 i++, karg=KEXP_NEXT_ARG(karg))
+	{
+		assert(KEXP_IS_VALID(karg, bool));
+		kargs[i] = karg;
+	}
+	for (k=0; k < kexp->nr_args; k++)
+	{
+		xpu_bool_t	status;
+
+		i = (order != 0 ? (order >> (4 * k)) & 0x0fU : k);
+		assert(i < kexp->nr_args);
+		if (!EXEC_KERN_EXPRESSION(kcxt, kargs[i], &status))
+			return false;
+		kcxt->scan_quals_nevals[i]++;
+		if (XPU_DATUM_ISNULL(&status))
+			anynull = true;
+		else if (!status.value)
+		{
+			result->expr_ops = &xpu_bool_ops;
+			result->value  = false;
+			return true;
+		}
+		kcxt->scan_quals_npassed[i]++;
+	}
+	result->expr_ops = (anynull ? NULL : &xpu_bool_ops);
+	result->value  = true;
+	return true;
+}
+
 STATIC_FUNCTION(bool)
 pgfn_BoolExprAnd(XPU_PGFUNCTION_ARGS)
 {
@@ -400,6 +479,8 @@ pgfn_BoolExprAnd(XPU_PGFUNCTION_ARGS)
 
 	assert(kexp->exptype == TypeOpCode__bool &&
 		   kexp->nr_args >= 2);
+	if ((kexp->expflags & KEXP_FLAG__ADAPTIVE_ORDER) != 0)
+		return __pgfn_BoolExprAndAdaptive(kcxt, kexp, __result);
 	for (i=0, karg=KEXP_FIRST_ARG(kexp);
 		 i < kexp->nr_args;
 		 i++, karg=KEXP_NEXT_ARG(karg))
@@ -957,6 +1038,214 @@ pgfn_ScalarArrayOp(XPU_PGFUNCTION_ARGS)
 	return true;
 }
 
+/*
+ * pgfn_ScalarArrayOpSortedAny
+ *
+ * 'SCALAR = ANY(constant integer array)' by binary search on the sorted
+ * unique array values embedded by the host code generator.
+ */
+STATIC_FUNCTION(bool)
+pgfn_ScalarArrayOpSortedAny(XPU_PGFUNCTION_ARGS)
+{
+	xpu_bool_t	   *result = (xpu_bool_t *)__result;
+	const kern_expression *karg = KEXP_FIRST_ARG(kexp);
+	union {
+		xpu_datum_t	dummy;
+		xpu_int1_t	i1;
+		xpu_int2_t	i2;
+		xpu_int4_t	i4;
+		xpu_int8_t	i8;
+	} datum;
+	int64_t		ival;
+	uint32_t	head, tail;
+
+	assert(kexp->exptype == TypeOpCode__bool &&
+		   kexp->nr_args == 1);
+	if (!EXEC_KERN_EXPRESSION(kcxt, karg, &datum))
+		return false;
+	if (XPU_DATUM_ISNULL(&datum.dummy))
+	{
+		result->expr_ops = NULL;
+		return true;
+	}
+	switch (karg->exptype)
+	{
+		case TypeOpCode__int1:
+			ival = datum.i1.value;
+			break;
+		case TypeOpCode__int2:
+			ival = datum.i2.value;
+			break;
+		case TypeOpCode__int4:
+			ival = datum.i4.value;
+			break;
+		case TypeOpCode__int8:
+			ival = datum.i8.value;
+			break;
+		default:
+			STROM_ELOG(kcxt, "unexpected argument type of ScalarArrayOpSortedAny");
+			return false;
+	}
+	head = 0;
+	tail = kexp->u.saop_sorted.nitems;
+	while (head < tail)
+	{
+		uint32_t	mid = (head + tail) / 2;
+		int64_t		curr = kexp->u.saop_sorted.values[mid];
+
+		if (curr == ival)
+		{
+			result->expr_ops = &xpu_bool_ops;
+			result->value = true;
+			return true;
+		}
+		if (curr < ival)
+			head = mid + 1;
+		else
+			tail = mid;
+	}
+	/* not found; NULL, if array contains NULLs */
+	if (kexp->u.saop_sorted.has_nulls)
+		result->expr_ops = NULL;
+	else
+	{
+		result->expr_ops = &xpu_bool_ops;
+		result->value = false;
+	}
+	return true;
+}
+
+/*
+ * pgfn_FieldSelectExpr
+ *
+ * It picks up a sub-field of the composite value. Arrow::Struct value walks
+ * on the child column of the sub-field, and PostgreSQL composite datum walks
+ * on the heap-tuple using the attribute descriptors embedded by the host.
+ */
+STATIC_FUNCTION(bool)
+__FieldSelectHeap(kern_context *kcxt,
+				  const kern_expression *kexp,
+				  const varlena *vl,
+				  xpu_datum_t *__result)
+{
+	const HeapTupleHeaderData *htup;
+	uint32_t	fieldnum = kexp->u.fsel.fieldnum;
+	uint32_t	offset;
+	bool		heap_hasnull;
+
+	if (VARATT_IS_EXTENDED(vl))
+	{
+		STROM_CPU_FALLBACK(kcxt, "composite datum is compressed or external");
+		return false;
+	}
+	htup = (const HeapTupleHeaderData *)vl;
+	if (fieldnum >= (htup->t_infomask2 & HEAP_NATTS_MASK))
+	{
+		/* attribute added after the datum was built */
+		__result->expr_ops = NULL;
+		return true;
+	}
+	assert(fieldnum < kexp->u.fsel.nattrs);
+	heap_hasnull = ((htup->t_infomask & HEAP_HASNULL) != 0);
+	offset = htup->t_hoff;
+	for (uint32_t j=0; j <= fieldnum; j++)
+	{
+		int		attlen = kexp->u.fsel.attrs[j].attlen;
+		int		attalign = kexp->u.fsel.attrs[j].attalign;
+		const char *addr;
+
+		if (heap_hasnull && att_isnull(j, htup->t_bits))
+		{
+			if (j == fieldnum)
+			{
+				__result->expr_ops = NULL;
+				return true;
+			}
+			continue;
+		}
+		if (attlen > 0)
+			offset = TYPEALIGN(attalign, offset);
+		else if (!VARATT_NOT_PAD_BYTE((const char *)htup + offset))
+			offset = TYPEALIGN(attalign, offset);
+		addr = (const char *)htup + offset;
+		if (j == fieldnum)
+			return kexp->expr_ops->xpu_datum_heap_read(kcxt, addr, __result);
+		if (attlen > 0)
+			offset += attlen;
+		else
+			offset += VARSIZE_ANY(addr);
+	}
+	STROM_ELOG(kcxt, "Bug? FieldSelect could not find the sub-field");
+	return false;
+}
+
+STATIC_FUNCTION(bool)
+__FieldSelectArrow(kern_context *kcxt,
+				   const kern_expression *kexp,
+				   const xpu_composite_t *comp,
+				   xpu_datum_t *__result)
+{
+	const kern_colmeta *cmeta = comp->cmeta;
+	const kern_data_store *kds;
+	const kern_varslot_desc *vs_desc;
+	uint32_t	fieldnum = kexp->u.fsel.fieldnum;
+	uint32_t	slot_id = comp->u.arrow.slot_id;
+
+	kds = (const kern_data_store *)
+		((const char *)cmeta - cmeta->kds_offset);
+	if (fieldnum >= cmeta->num_subattrs ||
+		slot_id >= kcxt->kvars_nrooms)
+	{
+		STROM_ELOG(kcxt, "Bug? Arrow::Struct reference out of range");
+		return false;
+	}
+	vs_desc = &kcxt->kvars_desc[slot_id];
+	if (fieldnum >= vs_desc->num_subfield)
+	{
+		STROM_ELOG(kcxt, "Bug? kvars-slot has no sub-field descriptor");
+		return false;
+	}
+	vs_desc = &kcxt->kvars_desc[vs_desc->idx_subfield + fieldnum];
+	return __kern_extract_arrow_field(kcxt, kds,
+									  &kds->colmeta[cmeta->idx_subattrs + fieldnum],
+									  comp->u.arrow.rowidx,
+									  vs_desc,
+									  __result);
+}
+
+STATIC_FUNCTION(bool)
+pgfn_FieldSelectExpr(XPU_PGFUNCTION_ARGS)
+{
+	const kern_expression *karg = KEXP_FIRST_ARG(kexp);
+	xpu_composite_t	comp;
+
+	assert(kexp->nr_args == 1 &&
+		   KEXP_IS_VALID(karg, composite));
+	if (!EXEC_KERN_EXPRESSION(kcxt, karg, &comp))
+		return false;
+	if (XPU_DATUM_ISNULL(&comp))
+	{
+		__result->expr_ops = NULL;
+		return true;
+	}
+	if (!comp.cmeta)
+		return __FieldSelectHeap(kcxt, kexp, comp.u.heap.value, __result);
+	return __FieldSelectArrow(kcxt, kexp, &comp, __result);
+}
+
+/*
+ * pgfn_UserDefinedFunc
+ *
+ * User-defined device functions are available only in the JIT module;
+ * if it was not built, rows are evaluated by the SQL function on CPU.
+ */
+STATIC_FUNCTION(bool)
+pgfn_UserDefinedFunc(XPU_PGFUNCTION_ARGS)
+{
+	STROM_CPU_FALLBACK(kcxt, "user-defined device function is not compiled");
+	return false;
+}
+
 /* ----------------------------------------------------------------
  *
  * Routines to support Projection
@@ -1099,6 +1388,69 @@ kern_estimate_heaptuple(kern_context *kcxt,
 	return MAXALIGN(offsetof(kern_tupitem, htup) + sz);
 }
 
+/*
+ * kern_form_column_item
+ *
+ * It writes out the projection result on the @rowid of the destination
+ * buffer in KDS_FORMAT_COLUMN. The host module sets up the columnar buffer
+ * only if all the attributes are fixed-length, so each values array is
+ * just (attlen * column_nrooms) bytes.
+ * NOTE: the caller must call kern_estimate_heaptuple() preliminary, like
+ *       kern_form_heaptuple(). The nullmap is not initialized, so both of
+ *       the valid and null bits are set by atomic operations, because the
+ *       neighbor rows on the same word are written by other threads.
+ */
+PUBLIC_FUNCTION(bool)
+kern_form_column_item(kern_context *kcxt,
+					  const kern_expression *kexp_proj,
+					  kern_data_store *kds_dst,
+					  uint32_t rowid)
+{
+	int			nattrs = kexp_proj->u.proj.nattrs;
+	uint32_t	mask = (1U << (rowid & 31));
+
+	assert(kds_dst->format == KDS_FORMAT_COLUMN &&
+		   rowid < kds_dst->column_nrooms);
+	for (int j=0; j < kds_dst->ncols; j++)
+	{
+		const kern_colmeta *cmeta = &kds_dst->colmeta[j];
+		xpu_datum_t	   *xdatum = NULL;
+		uint32_t	   *nullmap;
+
+		assert(cmeta->attlen > 0 &&
+			   cmeta->nullmap_offset != 0 &&
+			   cmeta->values_offset != 0);
+		if (j < nattrs)
+		{
+			uint16_t	slot_id = kexp_proj->u.proj.slot_id[j];
+
+			assert(slot_id < kcxt->kvars_nslots);
+			xdatum = kcxt->kvars_slot[slot_id];
+		}
+		nullmap = (uint32_t *)((char *)kds_dst +
+							   __kds_unpack(cmeta->nullmap_offset)) + (rowid >> 5);
+		if (!xdatum || XPU_DATUM_ISNULL(xdatum))
+			__atomic_and_uint32(nullmap, ~mask);
+		else
+		{
+			char   *buffer = ((char *)kds_dst +
+							  __kds_unpack(cmeta->values_offset) +
+							  (size_t)cmeta->attlen * rowid);
+
+			if (xdatum->expr_ops->xpu_datum_write(kcxt,
+												  buffer,
+												  cmeta,
+												  xdatum) != cmeta->attlen)
+			{
+				STROM_ELOG(kcxt, "unable to write fixed-length column");
+				return false;
+			}
+			__atomic_or_uint32(nullmap, mask);
+		}
+	}
+	return true;
+}
+
 STATIC_FUNCTION(bool)
 pgfn_Projection(XPU_PGFUNCTION_ARGS)
 {
@@ -1110,6 +1462,85 @@ pgfn_Projection(XPU_PGFUNCTION_ARGS)
 	return false;
 }
 
+/*
+ * __fast_hash_mix64 - finalizer of MurmurHash3 (64bit)
+ */
+INLINE_FUNCTION(uint64_t)
+__fast_hash_mix64(uint64_t h)
+{
+	h ^= (h >> 33);
+	h *= 0xff51afd7ed558ccdUL;
+	h ^= (h >> 33);
+	h *= 0xc4ceb9fe1a85ec53UL;
+	h ^= (h >> 33);
+	return h;
+}
+
+/*
+ * __fast_hash_datum
+ *
+ * It returns a 64bit hash of the fixed-length by-value datum, by a couple
+ * of multiplications on the value itself, or false if not applicable.
+ * Equal values by xpu_datum_comp must have same hash.
+ */
+INLINE_FUNCTION(bool)
+__fast_hash_datum(const xpu_datum_t *datum, uint64_t *p_hash)
+{
+	const xpu_datum_operators *expr_ops = datum->expr_ops;
+	uint64_t	ival;
+
+	switch (expr_ops->xpu_type_code)
+	{
+		case TypeOpCode__bool:
+		case TypeOpCode__int1:
+			ival = (uint8_t)((const xpu_int1_t *)datum)->value;
+			break;
+		case TypeOpCode__int2:
+			ival = (uint16_t)((const xpu_int2_t *)datum)->value;
+			break;
+		case TypeOpCode__int4:
+		case TypeOpCode__date:
+			ival = (uint32_t)((const xpu_int4_t *)datum)->value;
+			break;
+		case TypeOpCode__int8:
+		case TypeOpCode__time:
+		case TypeOpCode__timestamp:
+		case TypeOpCode__timestamptz:
+		case TypeOpCode__money:
+			ival = (uint64_t)((const xpu_int8_t *)datum)->value;
+			break;
+		case TypeOpCode__float4:
+			{
+				float4_t	fval = ((const xpu_float4_t *)datum)->value;
+
+				/* -0.0 == +0.0, and all the NaNs are equal */
+				if (fval == 0.0)
+					ival = 0;
+				else if (isnan(fval))
+					ival = 0x7fc00000U;
+				else
+					ival = __float_as_int__(fval);
+			}
+			break;
+		case TypeOpCode__float8:
+			{
+				float8_t	fval = ((const xpu_float8_t *)datum)->value;
+
+				if (fval == 0.0)
+					ival = 0;
+				else if (isnan(fval))
+					ival = 0x7ff8000000000000UL;
+				else
+					ival = __double_as_longlong__(fval);
+			}
+			break;
+		default:
+			return false;
+	}
+	*p_hash = __fast_hash_mix64(ival);
+	return true;
+}
+
 STATIC_FUNCTION(bool)
 pgfn_HashValue(XPU_PGFUNCTION_ARGS)
 {
@@ -1119,6 +1550,64 @@ pgfn_HashValue(XPU_PGFUNCTION_ARGS)
 	int				i, datum_sz = 64;
 	uint32_t		hash = 0xffffffffU;
 
+	if ((kexp->expflags & KEXP_FLAG__FAST_HASH) != 0)
+	{
+		/*
+		 * Device only hash (e.g, grouping keys of GpuPreAgg); fixed-length
+		 * keys are hashed by a few multiplications, and hash values of the
+		 * keys are combined depending on the position.
+		 */
+		uint64_t	hash64 = 0x9e3779b97f4a7c15UL;
+
+		for (i=0, karg = KEXP_FIRST_ARG(kexp);
+			 i < kexp->nr_args;
+			 i++, karg = KEXP_NEXT_ARG(karg))
+		{
+			const xpu_datum_operators *expr_ops = karg->expr_ops;
+			uint64_t	__hash;
+
+			if (expr_ops->xpu_type_sizeof > datum_sz)
+			{
+				datum_sz = expr_ops->xpu_type_sizeof;
+				datum = (xpu_datum_t *)alloca(datum_sz);
+			}
+			if (!EXEC_KERN_EXPRESSION(kcxt, karg, datum))
+				return false;
+			if (XPU_DATUM_ISNULL(datum))
+				__hash = 0x5bd1e995UL;
+			else if (expr_ops == &xpu_text_ops)
+			{
+				xpu_text_t *tval = (xpu_text_t *)datum;
+
+				if (!xpu_text_is_valid(kcxt, tval))
+					return false;
+				__hash = pg_hash_fast(tval->value, tval->length);
+			}
+			else if (expr_ops == &xpu_bytea_ops)
+			{
+				xpu_bytea_t *bval = (xpu_bytea_t *)datum;
+
+				if (!xpu_bytea_is_valid(kcxt, bval))
+					return false;
+				__hash = pg_hash_fast(bval->value, bval->length);
+			}
+			else if (!__fast_hash_datum(datum, &__hash))
+			{
+				uint32_t	__hash32;
+
+				if (!expr_ops->xpu_datum_hash(kcxt, &__hash32, datum))
+					return false;
+				__hash = __hash32;
+			}
+			hash64 = (hash64 ^ __hash) * 0x100000001b3UL;
+			hash64 = (hash64 << 31) | (hash64 >> 33);
+		}
+		hash64 = __fast_hash_mix64(hash64);
+		result->expr_ops = &xpu_int4_ops;
+		result->value = (uint32_t)(hash64 ^ (hash64 >> 32));
+		return true;
+	}
+
 	for (i=0, karg = KEXP_FIRST_ARG(kexp);
 		 i < kexp->nr_args;
 		 i++, karg = KEXP_NEXT_ARG(karg))
@@ -1314,6 +1803,11 @@ kern_extract_gpucache_tuple(kern_context *kcxt,
 		const kern_colmeta *cmeta = &kds->colmeta[vl_desc->vl_resno-1];
 		const char *addr;
 		uint32_t	slot_id = vl_desc->vl_slot_id;
+		union {
+			int16_t		i16;
+			int32_t		i32;
+			int64_t		i64;
+		} temp;
 
 		assert(slot_id < kcxt->kvars_nslots);
 		if (!KDS_COLUMN_ITEM_ISNULL(kds, cmeta, kds_index))
@@ -1321,7 +1815,26 @@ kern_extract_gpucache_tuple(kern_context *kcxt,
 			/* base pointer */
 			addr = ((const char *)kds + __kds_unpack(cmeta->values_offset));
 
-			if (cmeta->attlen > 0)
+			if (cmeta->col_encoding == KDS_COLUMN_ENCODING__BITPACK)
+			{
+				int64_t		ival = KDS_COLUMN_BITPACK_DECODE(cmeta, addr,
+															 kds_index);
+				/* datum is copied to kvars-slot immediately */
+				switch (cmeta->attlen)
+				{
+					case sizeof(int16_t):
+						temp.i16 = ival;
+						break;
+					case sizeof(int32_t):
+						temp.i32 = ival;
+						break;
+					default:
+						temp.i64 = ival;
+						break;
+				}
+				addr = (const char *)&temp;
+			}
+			else if (cmeta->attlen > 0)
 			{
 				addr += cmeta->attlen * kds_index;
 			}
@@ -1598,6 +2111,8 @@ kern_extract_gist_tuple(kern_context *kcxt,
 
 	assert(vl_desc->vl_resno > 0 &&
 		   vl_desc->vl_resno <= kds_gist->ncols);
+	const kern_colmeta *__cmeta = &kds_gist->colmeta[vl_desc->vl_resno-1];
+
 	if (IndexTupleHasNulls(itup))
 	{
 		nullmap = (char *)itup + sizeof(IndexTupleData);
@@ -1606,14 +2121,15 @@ kern_extract_gist_tuple(kern_context *kcxt,
 	}
 	else
 	{
-		const kern_colmeta *cmeta = &kds_gist->colmeta[vl_desc->vl_resno-1];
-
 		i_off = MAXALIGN(offsetof(IndexTupleData, data));
-		if (cmeta->attcacheoff >= 0)
-		{
-			char   *addr = (char *)itup + i_off + cmeta->attcacheoff;
-			return __extract_heap_tuple_attr(kcxt, vl_desc->vl_slot_id, addr);
-		}
+	}
+	/* attcacheoff is valid unless any preceding attribute is NULL */
+	if (__cmeta->attcacheoff >= 0 &&
+		__heap_tuple_nonull_prefix((const uint8_t *)nullmap,
+								   vl_desc->vl_resno) == vl_desc->vl_resno)
+	{
+		char   *addr = (char *)itup + i_off + __cmeta->attcacheoff;
+		return __extract_heap_tuple_attr(kcxt, vl_desc->vl_slot_id, addr);
 	}
 	/* extract the index-tuple by the slow path */
 	for (int resno=1; resno <= kds_gist->ncols; resno++)
@@ -1983,9 +2499,15 @@ __xpu_array_arrow_write(kern_context *kcxt,
 	vs_desc = &kcxt->kvars_desc[vs_desc->idx_subfield];
 	xdatum = (xpu_datum_t *)alloca(vs_desc->vs_ops->xpu_type_sizeof);
 
-	nbytes = (VARHDRSZ +
-			  offsetof(__ArrayTypeData, data[2]) +
-			  MAXALIGN(BITMAPLEN(arg->length)));
+	/*
+	 * same layout as construct_md_array(); the null-bitmap follows the
+	 * dimension info only if the element may be null, and the data part
+	 * begins at the MAXALIGN'ed position.
+	 */
+	nbytes = VARHDRSZ + offsetof(__ArrayTypeData, data[2]);
+	if (emeta->nullmap_offset != 0)
+		nbytes += BITMAPLEN(arg->length);
+	nbytes = MAXALIGN(nbytes);
 	if (buffer)
 	{
 		__ArrayTypeData *arr = (__ArrayTypeData *)(buffer + VARHDRSZ);
@@ -1996,7 +2518,10 @@ __xpu_array_arrow_write(kern_context *kcxt,
 		arr->data[0] = arg->length;
 		arr->data[1] = 1;
 		if (emeta->nullmap_offset != 0)
+		{
+			arr->dataoffset = nbytes;
 			nullmap = (uint8_t *)&arr->data[2];
+		}
 	}
 
 	for (int k=0; k < arg->length; k++)
@@ -2034,6 +2559,8 @@ __xpu_array_arrow_write(kern_context *kcxt,
 			nbytes += sz;
 		}
 	}
+	if (buffer)
+		SET_VARSIZE(buffer, nbytes);
 	return nbytes;
 }
 
@@ -2058,15 +2585,180 @@ xpu_array_datum_write(kern_context *kcxt,
 	return __xpu_array_arrow_write(kcxt, buffer, cmeta_dst, arg);
 }
 
+/*
+ * __xpu_array_canonical_payload
+ *
+ * It returns the payload of PostgreSQL array (ArrayType without varlena
+ * header) for both of heap and Arrow arrays. Arrow::List values are built
+ * on the kcxt buffer in the same layout as construct_md_array().
+ */
+STATIC_FUNCTION(bool)
+__xpu_array_canonical_payload(kern_context *kcxt,
+							  const xpu_array_t *arg,
+							  const __ArrayTypeData **p_ar,
+							  int32_t *p_len)
+{
+	if (arg->length < 0)
+	{
+		const varlena *vl = arg->u.heap.value;
+
+		if (VARATT_IS_EXTERNAL(vl))
+		{
+			STROM_CPU_FALLBACK(kcxt, "array datum is external");
+			return false;
+		}
+		if (VARATT_IS_COMPRESSED(vl))
+		{
+			const char *value = (const char *)vl;
+			int			length;
+
+			if (!xpu_varlena_decompress(kcxt, &value, &length))
+			{
+				STROM_CPU_FALLBACK(kcxt, "array datum is compressed");
+				return false;
+			}
+			*p_ar = (const __ArrayTypeData *)value;
+			*p_len = length;
+		}
+		else
+		{
+			*p_ar = (const __ArrayTypeData *)VARDATA_ANY(vl);
+			*p_len = VARSIZE_ANY_EXHDR(vl);
+		}
+	}
+	else
+	{
+		char	   *buffer;
+		int			nbytes;
+
+		nbytes = __xpu_array_arrow_write(kcxt, NULL, NULL, arg);
+		if (nbytes < 0)
+			return false;
+		buffer = (char *)MAXALIGN(kcxt->vlpos);
+		if (buffer + nbytes > kcxt->vlend)
+		{
+			STROM_CPU_FALLBACK(kcxt, "out of kcxt memory for Arrow::List value");
+			return false;
+		}
+		kcxt->vlpos = buffer + nbytes;
+		if (__xpu_array_arrow_write(kcxt, buffer, NULL, arg) != nbytes)
+			return false;
+		*p_ar = (const __ArrayTypeData *)(buffer + VARHDRSZ);
+		*p_len = nbytes - VARHDRSZ;
+	}
+	return true;
+}
+
+/*
+ * __xpu_array_canonical_nullmap
+ *
+ * It returns the null-bitmap only if any elements are null actually,
+ * because the array may have the bitmap with all bits set.
+ */
+STATIC_FUNCTION(const uint8_t *)
+__xpu_array_canonical_nullmap(const __ArrayTypeData *ar, uint32_t *p_nitems)
+{
+	int32_t		ndim = __pg_array_ndim(ar);
+	uint32_t	nitems = (ndim > 0 ? 1 : 0);
+	const uint8_t *nullmap = __pg_array_nullmap(ar);
+
+	for (int k=0; k < ndim; k++)
+		nitems *= __pg_array_dim(ar, k);
+	*p_nitems = nitems;
+	if (nullmap)
+	{
+		for (uint32_t i=0; i < nitems; i++)
+		{
+			if ((nullmap[i>>3] & (1<<(i & 7))) == 0)
+				return nullmap;
+		}
+	}
+	return NULL;
+}
+
+/*
+ * xpu_array_datum_hash
+ *
+ * Hash value of the array is built from the dimension info, positions of
+ * null elements and the binary image of not-null elements; so, it is
+ * consistent with devtype_array_hash() on the host side. The code generator
+ * allows it only if element type has binary-comparable equality.
+ */
 STATIC_FUNCTION(bool)
 xpu_array_datum_hash(kern_context *kcxt,
 					 uint32_t *p_hash,
-					 xpu_datum_t *arg)
+					 xpu_datum_t *__arg)
 {
-	STROM_ELOG(kcxt, "xpu_array_datum_hash is not implemented");
-	return false;
+	const xpu_array_t *arg = (const xpu_array_t *)__arg;
+	const __ArrayTypeData *ar;
+	const uint8_t *nullmap;
+	const char *dataptr;
+	int32_t		len;
+	int32_t		ndim;
+	uint32_t	nitems;
+	uint32_t	hash;
+
+	if (XPU_DATUM_ISNULL(arg))
+	{
+		*p_hash = 0;
+		return true;
+	}
+	if (!__xpu_array_canonical_payload(kcxt, arg, &ar, &len))
+		return false;
+	ndim = __pg_array_ndim(ar);
+	nullmap = __xpu_array_canonical_nullmap(ar, &nitems);
+	dataptr = __pg_array_dataptr(ar);
+
+	hash = pg_hash_any(ar->data, sizeof(uint32_t) * 2 * ndim) ^ ndim;
+	if (nullmap)
+		hash = ((hash << 1) | (hash >> 31)) ^ pg_hash_any(nullmap, BITMAPLEN(nitems));
+	hash = ((hash << 1) | (hash >> 31)) ^
+		pg_hash_any(dataptr, ((const char *)ar + len) - dataptr);
+	*p_hash = hash;
+	return true;
 }
 
+/*
+ * __xpu_array_binary_equal - see array_eq
+ */
+STATIC_FUNCTION(bool)
+__xpu_array_binary_equal(kern_context *kcxt,
+						 const xpu_array_t *a,
+						 const xpu_array_t *b,
+						 bool *p_equal)
+{
+	const __ArrayTypeData *ar_a, *ar_b;
+	const uint8_t *nullmap_a, *nullmap_b;
+	const char *dataptr_a, *dataptr_b;
+	int32_t		len_a, len_b;
+	int32_t		ndim;
+	uint32_t	nitems_a, nitems_b;
+
+	if (!__xpu_array_canonical_payload(kcxt, a, &ar_a, &len_a) ||
+		!__xpu_array_canonical_payload(kcxt, b, &ar_b, &len_b))
+		return false;
+	ndim = __pg_array_ndim(ar_a);
+	*p_equal = false;
+	if (ndim != __pg_array_ndim(ar_b) ||
+		__memcmp(ar_a->data, ar_b->data, sizeof(uint32_t) * 2 * ndim) != 0)
+		return true;
+	nullmap_a = __xpu_array_canonical_nullmap(ar_a, &nitems_a);
+	nullmap_b = __xpu_array_canonical_nullmap(ar_b, &nitems_b);
+	if ((nullmap_a != NULL) != (nullmap_b != NULL) ||
+		(nullmap_a && __memcmp(nullmap_a, nullmap_b, BITMAPLEN(nitems_a)) != 0))
+		return true;
+	dataptr_a = __pg_array_dataptr(ar_a);
+	dataptr_b = __pg_array_dataptr(ar_b);
+	len_a -= (dataptr_a - (const char *)ar_a);
+	len_b -= (dataptr_b - (const char *)ar_b);
+	*p_equal = (len_a == len_b && __memcmp(dataptr_a, dataptr_b, len_a) == 0);
+	return true;
+}
+
+#define PG_ARRAY_EQUAL_TEMPLATE(NAME,OPER)									PUBLIC_FUNCTION(bool)													pgfn_##NAME(XPU_PGFUNCTION_ARGS)										{																			KEXP_PROCESS_ARGS2(bool, array, a, array, b);																									if (XPU_DATUM_ISNULL(&a) || XPU_DATUM_ISNULL(&b))							result->expr_ops = NULL;											else																	{																			bool	equal;																																	if (!__xpu_array_binary_equal(kcxt, &a, &b, &equal))						return false;														result->expr_ops = &xpu_bool_ops;										result->value = (equal OPER true);									}																		return true;														}
+PG_ARRAY_EQUAL_TEMPLATE(array_eq, ==)
+PG_ARRAY_EQUAL_TEMPLATE(array_ne, !=)
+
 STATIC_FUNCTION(bool)
 xpu_array_datum_comp(kern_context *kcxt,
 					 int *p_comp,
@@ -2479,6 +3171,9 @@ PUBLIC_DATA xpu_function_catalog_entry builtin_xpu_functions_catalog[] = {
 	{FuncOpCode__CaseWhenExpr,				pgfn_CaseWhenExpr},
 	{FuncOpCode__ScalarArrayOpAny,			pgfn_ScalarArrayOp},
 	{FuncOpCode__ScalarArrayOpAll,			pgfn_ScalarArrayOp},
+	{FuncOpCode__ScalarArrayOpSortedAny,	pgfn_ScalarArrayOpSortedAny},
+	{FuncOpCode__FieldSelectExpr,			pgfn_FieldSelectExpr},
+	{FuncOpCode__UserDefinedFunc,			pgfn_UserDefinedFunc},
 #include "xpu_opcodes.h"
 	{FuncOpCode__Projection,                pgfn_Projection},
 	{FuncOpCode__LoadVars,                  pgfn_LoadVars},
@@ -2642,3 +3337,237 @@ pg_hash_any(const void *ptr, int sz)
 #undef rot
 #undef mix
 #undef final
+
+/*
+ * pg_hash_fast - device only hash function
+ *
+ * It fetches the source by 8 bytes words (MurmurHash3 style), so faster than
+ * pg_hash_any() for the longer keys, however, the result is not compatible.
+ * Never use it for the hash values to be compared with the host code.
+ */
+PUBLIC_FUNCTION(uint32_t)
+pg_hash_fast(const void *ptr, int sz)
+{
+	const uint8_t  *k = (const uint8_t *)ptr;
+	uint64_t		h = 0x9e3779b97f4a7c15UL ^ ((uint64_t)sz * 0xff51afd7ed558ccdUL);
+	uint64_t		w;
+
+	if (((uint64_t)k & (sizeof(uint64_t) - 1)) == 0)
+	{
+		const uint64_t *kw = (const uint64_t *)k;
+
+		for (; sz >= (int)sizeof(uint64_t); sz -= sizeof(uint64_t))
+		{
+			w = *kw++ * 0x87c37b91114253d5UL;
+			w = (w << 31) | (w >> 33);
+			h ^= w * 0x4cf5ad432745937fUL;
+			h = ((h << 27) | (h >> 37)) * 5 + 0x52dce729;
+		}
+		k = (const uint8_t *)kw;
+	}
+	else
+	{
+		for (; sz >= (int)sizeof(uint64_t); sz -= sizeof(uint64_t))
+		{
+			w = 0;
+			for (int j=sizeof(uint64_t)-1; j >= 0; j--)
+				w = (w << 8) | k[j];
+			k += sizeof(uint64_t);
+			w *= 0x87c37b91114253d5UL;
+			w = (w << 31) | (w >> 33);
+			h ^= w * 0x4cf5ad432745937fUL;
+			h = ((h << 27) | (h >> 37)) * 5 + 0x52dce729;
+		}
+	}
+	/* the last 7 bytes */
+	if (sz > 0)
+	{
+		w = 0;
+		for (int j=sz-1; j >= 0; j--)
+			w = (w << 8) | k[j];
+		w *= 0x87c37b91114253d5UL;
+		w = (w << 31) | (w >> 33);
+		h ^= w * 0x4cf5ad432745937fUL;
+	}
+	h = __fast_hash_mix64(h);
+
+	return (uint32_t)(h ^ (h >> 32));
+}
+
+/* ----------------------------------------------------------------
+ *
+ * Decompression of the inline compressed varlena (pglz / lz4)
+ *
+ * ----------------------------------------------------------------
+ */
+#ifndef TOAST_PGLZ_COMPRESSION_ID
+#define TOAST_PGLZ_COMPRESSION_ID	0
+#define TOAST_LZ4_COMPRESSION_ID	1
+#endif
+
+/* see common/pg_lzcompress.c */
+STATIC_FUNCTION(int32_t)
+__pglz_decompress(const char *source, int32_t slen,
+				  char *dest, int32_t rawsize)
+{
+	const uint8_t  *sp = (const uint8_t *)source;
+	const uint8_t  *srcend = sp + slen;
+	uint8_t		   *dp = (uint8_t *)dest;
+	uint8_t		   *destend = dp + rawsize;
+
+	while (sp < srcend && dp < destend)
+	{
+		uint8_t		ctrl = *sp++;
+
+		for (int ctrlc = 0; ctrlc < 8 && sp < srcend && dp < destend; ctrlc++)
+		{
+			if (ctrl & 1)
+			{
+				int32_t		len, off;
+
+				if (sp + 2 > srcend)
+					return -1;
+				len = (sp[0] & 0x0f) + 3;
+				off = ((sp[0] & 0xf0) << 4) | sp[1];
+				sp += 2;
+				if (len == 18)
+				{
+					if (sp >= srcend)
+						return -1;
+					len += *sp++;
+				}
+				if (off == 0 || off > (dp - (uint8_t *)dest))
+					return -1;
+				len = Min(len, destend - dp);
+				/* source and destination may overlap */
+				while (len-- > 0)
+				{
+					*dp = dp[-off];
+					dp++;
+				}
+			}
+			else
+			{
+				*dp++ = *sp++;
+			}
+			ctrl >>= 1;
+		}
+	}
+	return (dp == destend ? rawsize : -1);
+}
+
+/* LZ4 block format; see lz4_Block_format.md */
+STATIC_FUNCTION(int32_t)
+__lz4_decompress(const char *source, int32_t slen,
+				 char *dest, int32_t rawsize)
+{
+	const uint8_t  *ip = (const uint8_t *)source;
+	const uint8_t  *iend = ip + slen;
+	uint8_t		   *op = (uint8_t *)dest;
+	uint8_t		   *oend = op + rawsize;
+
+	while (ip < iend)
+	{
+		uint32_t	token = *ip++;
+		uint32_t	len = (token >> 4);
+		uint32_t	off;
+		uint8_t		c;
+
+		/* literals */
+		if (len == 15)
+		{
+			do {
+				if (ip >= iend)
+					return -1;
+				c = *ip++;
+				len += c;
+			} while (c == 255);
+		}
+		if (len > iend - ip || len > oend - op)
+			return -1;
+		memcpy(op, ip, len);
+		op += len;
+		ip += len;
+		if (ip >= iend)
+			break;		/* the last sequence has no match */
+		/* match */
+		if (ip + 2 > iend)
+			return -1;
+		off = ((uint32_t)ip[0] | ((uint32_t)ip[1] << 8));
+		ip += 2;
+		if (off == 0 || off > (op - (uint8_t *)dest))
+			return -1;
+		len = (token & 0x0f);
+		if (len == 15)
+		{
+			do {
+				if (ip >= iend)
+					return -1;
+				c = *ip++;
+				len += c;
+			} while (c == 255);
+		}
+		len += 4;
+		if (len > oend - op)
+			return -1;
+		/* source and destination may overlap */
+		while (len-- > 0)
+		{
+			*op = op[-off];
+			op++;
+		}
+	}
+	return (op - (uint8_t *)dest);
+}
+
+/*
+ * xpu_varlena_decompress
+ *
+ * It expands the inline compressed varlena on the kcxt buffer, then
+ * updates @p_value and @p_length to the decompressed image.
+ * It returns false if the datum is external, or not enough buffer space;
+ * in this case, caller shall fall back the row to CPU.
+ */
+PUBLIC_FUNCTION(bool)
+xpu_varlena_decompress(kern_context *kcxt,
+					   const char **p_value,
+					   int *p_length)
+{
+	const char *addr = *p_value;
+	toast_compress_header c_hdr;
+	int32_t		rawsize;
+	int32_t		slen;
+	int32_t		nbytes;
+	char	   *pos;
+
+	if (!VARATT_IS_COMPRESSED(addr))
+		return false;
+	memcpy(&c_hdr, addr, sizeof(toast_compress_header));
+	rawsize = TOAST_COMPRESS_EXTSIZE(&c_hdr);
+	slen = VARSIZE_4B(addr) - TOAST_COMPRESS_HDRSZ;
+	pos = (char *)MAXALIGN(kcxt->vlpos);
+	if (pos + rawsize > kcxt->vlend)
+		return false;
+	switch (TOAST_COMPRESS_METHOD(&c_hdr))
+	{
+		case TOAST_PGLZ_COMPRESSION_ID:
+			nbytes = __pglz_decompress(addr + TOAST_COMPRESS_HDRSZ,
+									   slen, pos, rawsize);
+			break;
+		case TOAST_LZ4_COMPRESSION_ID:
+			nbytes = __lz4_decompress(addr + TOAST_COMPRESS_HDRSZ,
+									  slen, pos, rawsize);
+			break;
+		default:
+			return false;
+	}
+	if (nbytes != rawsize)
+	{
+		STROM_ELOG(kcxt, "compressed varlena datum is corrupted");
+		return false;
+	}
+	kcxt->vlpos = pos + rawsize;
+	*p_value  = pos;
+	*p_length = rawsize;
+	return true;
+}
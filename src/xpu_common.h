@@ -338,6 +338,9 @@ typedef enum {
 	FuncOpCode__CaseWhenExpr,
 	FuncOpCode__ScalarArrayOpAny,
 	FuncOpCode__ScalarArrayOpAll,
+	FuncOpCode__ScalarArrayOpSortedAny,
+	FuncOpCode__FieldSelectExpr,
+	FuncOpCode__UserDefinedFunc,
 #include "xpu_opcodes.h"
 	FuncOpCode__LoadVars = 9999,
 	FuncOpCode__MoveVars,
@@ -404,6 +407,8 @@ typedef union
 /*
  * kern_context - a set of run-time information
  */
+#define KERN_JSONB_KEYCACHE_NSLOTS		16
+
 typedef struct
 {
 	uint32_t		errcode;
@@ -412,6 +417,7 @@ typedef struct
 	const char	   *error_funcname;
 	const char	   *error_message;
 	struct kern_session_info *session;
+	const struct kern_multirels *kmrels;	/* inner buffer of GpuJoin, if any */
 
 	/* the kernel variables slot */
 	struct xpu_datum_t **kvars_slot;
@@ -429,6 +435,14 @@ typedef struct
 	uint32_t		groupby_prepfn_bufsz;
 	uint32_t		groupby_prepfn_nbufs;
 	char		   *groupby_prepfn_buffer;
+	/*
+	 * Grouping-key dictionary; it maps the hash value of grouping-keys to
+	 * the dense group code (rowid of kds_final) for the groups that have
+	 * the prepfn buffer above. Each slot is (hash << 32 | (rowid + 1)),
+	 * and zero means an empty slot.
+	 */
+	uint32_t		groupby_keydict_nslots;	/* power of 2 */
+	uint64_t	   *groupby_keydict;
 
 	/*
 	 * mode control flags
@@ -437,6 +451,32 @@ typedef struct
 	 */
 	bool			kmode_compare_nulls;
 
+	/*
+	 * run-time statistics for adaptive reordering of scan-quals
+	 *
+	 * scan_quals_order - packed order of the arguments (4bits per position)
+	 *                    of BoolExpr(AND), or 0 for the original order.
+	 */
+	uint64_t		scan_quals_order;
+	uint32_t		scan_quals_nevals[KERN_ADAPTIVE_QUALS_MAX];
+	uint32_t		scan_quals_npassed[KERN_ADAPTIVE_QUALS_MAX];
+
+	/*
+	 * jsonb key lookup cache
+	 *
+	 * A query often references multiple keys of the same jsonb datum in
+	 * several places (WHERE-clause and projection, for example). It keeps
+	 * the position of the recently referenced keys for each jsonb object
+	 * container, to avoid binary search on the same container repeatedly.
+	 */
+	struct {
+		const void	   *jc;			/* jsonb object container */
+		const char	   *key;		/* key string */
+		int32_t			keylen;
+		int32_t			index;		/* index of the key, or -1 */
+	} jsonb_keycache[KERN_JSONB_KEYCACHE_NSLOTS];
+	uint32_t		jsonb_keycache_next;
+
 	/* variable length buffer */
 	char		   *vlpos;
 	char		   *vlend;
@@ -608,9 +648,81 @@ struct kern_colmeta {
 	uint32_t		values_length;
 	uint32_t		extra_offset;
 	uint32_t		extra_length;
+
+	/*
+	 * (only column format of GpuCache)
+	 * @col_encoding is one of KDS_COLUMN_ENCODING__*.
+	 * DICT - varlena values are deduplicated using the hash slots at
+	 *        @dict_offset of the extra buffer (@dict_nslots entries).
+	 * BITPACK - fixed-length integer values are stored as difference from
+	 *        the @enc_base using @enc_unitsz bytes (frame-of-reference).
+	 *        @enc_base is assigned by the first value written on the device.
+	 */
+	uint8_t			col_encoding;
+	uint8_t			enc_unitsz;
+	uint32_t		dict_offset;
+	uint32_t		dict_nslots;
+	int64_t			enc_base;
+	/*
+	 * (only column format of GpuCache)
+	 * Device resident hash-index on the column, if @hindex_nslots > 0.
+	 * @hindex_offset points uint64_t slots; (hash << 32 | (rowid + 1)).
+	 * @hindex_rowpos points uint32_t array; (slot index + 1) per rowid.
+	 * @hindex_invalid is set on the device, if the index is not reliable
+	 * any more, then scan falls back to the full scan.
+	 */
+	uint32_t		hindex_offset;
+	uint32_t		hindex_nslots;
+	uint32_t		hindex_rowpos;
+	uint32_t		hindex_invalid;
+	/*
+	 * (only column format of GpuCache)
+	 * Maintained aggregation grouped by the column, if @agg_nslots > 0.
+	 * @agg_offset points kern_gpucache_aggslot array.
+	 * @agg_counted points bitmap of the rows already accumulated.
+	 * @agg_value_anum is attnum of the aggregated column, or 0 if count only.
+	 * @agg_value_float is true, if the aggregated column is floating-point.
+	 * @agg_invalid is set on the device, if hash slots are exhausted.
+	 */
+	uint32_t		agg_offset;
+	uint32_t		agg_nslots;
+	uint32_t		agg_counted;
+	int16_t			agg_value_anum;
+	uint8_t			agg_value_float;
+	uint8_t			agg_invalid;
 };
 typedef struct kern_colmeta		kern_colmeta;
 
+#define KDS_COLUMN_ENCODING__PLAIN		0
+#define KDS_COLUMN_ENCODING__DICT		1
+#define KDS_COLUMN_ENCODING__BITPACK	2
+#define KDS_COLUMN_ENC_BASE__UNSET		INT64_MIN
+
+#define GCACHE_HINDEX_EMPTY				0UL
+#define GCACHE_HINDEX_TOMBSTONE			(~0UL)
+#define GCACHE_HINDEX_MAX_PROBES		256
+
+/*
+ * kern_gpucache_aggslot - a group of the maintained aggregation
+ */
+typedef struct
+{
+	uint32_t		state;		/* one of GCACHE_AGGSLOT__* */
+	uint32_t		__padding;
+	int64_t			key;		/* grouping key (integer types only) */
+	int64_t			nrows;		/* count(*) */
+	int64_t			nvalues;	/* count(value) */
+	union {
+		int64_t		ival;		/* sum(value) of integer types */
+		float8_t	fval;		/* sum(value) of floating-point types */
+	} sum;
+} kern_gpucache_aggslot;
+
+#define GCACHE_AGGSLOT__EMPTY		0
+#define GCACHE_AGGSLOT__LOCKED		1
+#define GCACHE_AGGSLOT__VALID		2
+#define GCACHE_AGGSLOT__VALID_NULL	3	/* group of NULL key */
+
 #define KDS_FORMAT_ROW			'r'		/* normal heap-tuples */
 #define KDS_FORMAT_HASH			'h'		/* inner hash table for HashJoin */
 #define KDS_FORMAT_BLOCK		'b'		/* raw blocks for direct loading */
@@ -1353,6 +1465,62 @@ KDS_ARROW_REF_VARLENA64_DATUM(const kern_data_store *kds,
 	return NULL;
 }
 
+/*
+ * Arrow::Utf8View / BinaryView
+ *
+ * Each view is 16 bytes; the length is followed by the string itself if it
+ * is short enough (<= 12 bytes), or by its 4 bytes prefix, index of the data
+ * buffer and the offset in the buffer. arrow_fdw loads the variadic data
+ * buffers as a contiguous extra region, and adjusts the views to refer the
+ * buffer index 0, if record-batch has multiple data buffers.
+ */
+#define ARROW_VIEW_INLINE_MAXLEN	12
+typedef struct
+{
+	int32_t		length;
+	union {
+		char		inlined[ARROW_VIEW_INLINE_MAXLEN];
+		struct {
+			char		prefix[4];
+			int32_t		buffer_index;
+			int32_t		offset;
+		} ref;
+	} u;
+} ArrowBinaryView;
+
+INLINE_FUNCTION(const void *)
+KDS_ARROW_REF_VIEW_DATUM(const kern_data_store *kds,
+						 const kern_colmeta *cmeta,
+						 uint32_t index,
+						 int *p_length)
+{
+	Assert(cmeta->values_offset > 0);
+	if (sizeof(ArrowBinaryView) * (index+1) <= __kds_unpack(cmeta->values_length))
+	{
+		const ArrowBinaryView *view = (const ArrowBinaryView *)
+			((const char *)kds + __kds_unpack(cmeta->values_offset)) + index;
+
+		if (view->length >= 0 &&
+			view->length <= ARROW_VIEW_INLINE_MAXLEN)
+		{
+			*p_length = view->length;
+			return view->u.inlined;
+		}
+		if (view->length > 0 &&
+			view->u.ref.buffer_index == 0 &&
+			view->u.ref.offset >= 0 &&
+			(uint64_t)view->u.ref.offset +
+			(uint64_t)view->length <= __kds_unpack(cmeta->extra_length))
+		{
+			*p_length = view->length;
+			return ((const char *)kds +
+					__kds_unpack(cmeta->extra_offset) +
+					view->u.ref.offset);
+		}
+	}
+	return NULL;
+}
+
 INLINE_FUNCTION(bool)
 KDS_COLUMN_ITEM_ISNULL(const kern_data_store *kds,
 					   const kern_colmeta *cmeta,
@@ -1371,6 +1539,29 @@ KDS_COLUMN_ITEM_ISNULL(const kern_data_store *kds,
 	return (bitmap[idx] & mask) == 0;
 }
 
+/*
+ * KDS_COLUMN_BITPACK_DECODE - fetch a frame-of-reference encoded value
+ */
+INLINE_FUNCTION(int64_t)
+KDS_COLUMN_BITPACK_DECODE(const kern_colmeta *cmeta,
+						  const char *values,
+						  uint32_t rowid)
+{
+	assert(cmeta->col_encoding == KDS_COLUMN_ENCODING__BITPACK);
+	switch (cmeta->enc_unitsz)
+	{
+		case sizeof(int8_t):
+			return cmeta->enc_base + ((const int8_t *)values)[rowid];
+		case sizeof(int16_t):
+			return cmeta->enc_base + ((const int16_t *)values)[rowid];
+		case sizeof(int32_t):
+			return cmeta->enc_base + ((const int32_t *)values)[rowid];
+		default:
+			break;
+	}
+	return ((const int64_t *)values)[rowid];
+}
+
 /*
  * GpuCacheSysattr
  *
@@ -1499,6 +1690,11 @@ typedef struct toast_compress_header
 #define TOAST_COMPRESS_SET_RAWSIZE(ptr, len)    \
     (((toast_compress_header *) (ptr))->rawsize = (len))
 
+EXTERN_FUNCTION(bool)
+xpu_varlena_decompress(kern_context *kcxt,
+					   const char **p_value,
+					   int *p_length);
+
 /* basic varlena macros */
 #define VARATT_IS_4B(PTR) \
 	((((varattrib_1b *) (PTR))->va_header & 0x01) == 0x00)
@@ -1929,6 +2125,8 @@ typedef struct
 #define DEVTYPE__USE_KVARS_SLOTBUF	0x00000400U	/* Device type uses extra buffer on
 												 * the kvars-slot for LoadVars */
 #define DEVTYPE__HAS_COMPARE		0x00000800U	/* Device type has compare handler */
+#define DEVFUNC__USER_DEFINED		0x00001000U	/* User-defined device function;
+												 * it needs JIT compilation */
 #define DEVTASK__SCAN				0x10000000U	/* xPU-Scan */
 #define DEVTASK__JOIN				0x20000000U	/* xPU-Join */
 #define DEVTASK__PREAGG				0x40000000U	/* xPU-PreAgg */
@@ -2056,10 +2254,16 @@ typedef bool  (*xpu_function_t)(XPU_PGFUNCTION_ARGS);
 #define KAGG_ACTION__PMAX_FP64		404		/* <int4>,<float8> - max value */
 #define KAGG_ACTION__PSUM_INT		501		/* <int8> - sum of values */
 #define KAGG_ACTION__PSUM_FP		503		/* <float8> - sum of values */
+#define KAGG_ACTION__PSUM_NUMERIC	504		/* <int4>,<int4>,<int128> - exact sum */
 #define KAGG_ACTION__PAVG_INT		601		/* <int4>,<int8> - NROWS+PSUM */
 #define KAGG_ACTION__PAVG_FP		602		/* <int4>,<float8> - NROWS+PSUM */
+#define KAGG_ACTION__PAVG_NUMERIC	603		/* <int4>,<int4>,<int128> - NROWS+PSUM */
 #define KAGG_ACTION__STDDEV			701		/* <int4>,<float8>,<float8> - stddev */
 #define KAGG_ACTION__COVAR			801		/* <int4>,<float8>x5 - covariance */
+#define KAGG_ACTION__PQUANTILE		901		/* <int4>,<float8>x3,<int4>xN - quantile sketch */
+#define KAGG_ACTION__PTOPK			1001	/* <int4>x2,<int64>xN - top-k values */
+#define KAGG_ACTION__PARRAY			1101	/* <int4>x4,<bytes>xN - values */
+#define KAGG_ACTION__PARRAY_KEY		1102	/* <int4>x4,<bytes>xN - values with sort-keys */
 
 typedef struct
 {
@@ -2089,6 +2293,42 @@ typedef struct
 	float8_t	sum;
 } kagg_state__psum_fp_packed;
 
+/*
+ * Exact sum of numeric
+ *
+ * NUMERIC values are accumulated as 128bit fixed-point integers on the scale
+ * of the typmod. The planner uses it only if the precision is bounded, so
+ * absolute value of each row is less than 2^KAGG_NUMERIC_FIXED_POINT_BITS,
+ * thus, the sum of 2^32 rows never overflows.
+ * The 128bit sum is split into two 64bit words for atomic operations.
+ */
+#define KAGG_NUMERIC_FIXED_POINT_BITS	95
+#define KAGG_NUMERIC_MAX_PRECISION		28		/* 10^28 < 2^95 */
+
+typedef struct
+{
+	int32_t		vl_len_;
+	uint32_t	nitems;
+	int32_t		scale;
+	uint32_t	__padding__;
+	uint64_t	sum_lo;
+	int64_t		sum_hi;
+} kagg_state__psum_numeric_packed;
+
+INLINE_FUNCTION(int128_t)
+__kagg_psum_numeric_get(const kagg_state__psum_numeric_packed *r)
+{
+	return (int128_t)(((unsigned __int128)((uint64_t)r->sum_hi) << 64) |
+					  (unsigned __int128)r->sum_lo);
+}
+
+INLINE_FUNCTION(void)
+__kagg_psum_numeric_set(kagg_state__psum_numeric_packed *r, int128_t sum)
+{
+	r->sum_lo = (uint64_t)sum;
+	r->sum_hi = (int64_t)(sum >> 64);
+}
+
 typedef struct
 {
 	int32_t		vl_len_;
@@ -2108,6 +2348,137 @@ typedef struct
 	float8_t	sum_xy;
 } kagg_state__covar_packed;
 
+/*
+ * Quantile sketch
+ *
+ * It is a log-scale histogram with fixed bucket boundaries, so the partial
+ * states can be merged by simple addition on both of xPU and CPU.
+ * Each binade [2^e, 2^(e+1)) is split into (1<<KAGG_QSKETCH_SUB_BITS) buckets,
+ * thus relative error of the estimated quantile is less than 1/16 (6.25%).
+ * Values less than 2^KAGG_QSKETCH_MIN_EXPONENT (including zero and negative
+ * values) are counted on 'nlower', and values larger than the last binade
+ * are counted on the last bucket. The min/max values are exact, and the
+ * estimated quantile is clamped by them.
+ */
+#define KAGG_QSKETCH_MIN_EXPONENT	(-20)
+#define KAGG_QSKETCH_NUM_BINADES	64
+#define KAGG_QSKETCH_SUB_BITS		3
+#define KAGG_QSKETCH_NBUCKETS		(KAGG_QSKETCH_NUM_BINADES << KAGG_QSKETCH_SUB_BITS)
+
+typedef struct
+{
+	int32_t		vl_len_;
+	uint32_t	nitems;
+	float8_t	fraction;
+	float8_t	min_value;
+	float8_t	max_value;
+	uint32_t	nlower;
+	uint32_t	__padding__;
+	uint32_t	buckets[KAGG_QSKETCH_NBUCKETS];
+} kagg_state__pquantile_packed;
+
+INLINE_FUNCTION(int)
+__kagg_qsketch_bucket_index(float8_t fval)
+{
+	uint64_t	ival = __double_as_longlong__(fval);
+	int			expo = (int)((ival >> 52) & 0x7ffU) - 1023;
+	int			index;
+
+	if ((ival & (1UL<<63)) != 0 || expo < KAGG_QSKETCH_MIN_EXPONENT)
+		return -1;		/* negative, zero or too small */
+	index = (((expo - KAGG_QSKETCH_MIN_EXPONENT) << KAGG_QSKETCH_SUB_BITS) |
+			 (int)((ival >> (52 - KAGG_QSKETCH_SUB_BITS)) &
+				   ((1U << KAGG_QSKETCH_SUB_BITS) - 1)));
+	return Min(index, KAGG_QSKETCH_NBUCKETS - 1);
+}
+
+/*
+ * Top-K values
+ *
+ * It keeps the largest K values per group in the unsorted slots. Each value
+ * is encoded to the unsigned integer with the same ordering (NaN is larger
+ * than any other values, as PostgreSQL doing), and zero means an empty slot.
+ * A new value replaces the minimum slot by compare-and-swap, so concurrent
+ * updates need no locks; the replaced value was less than or equal to any
+ * other slots, thus it is never a member of top-k.
+ */
+#define KAGG_TOPK_MAX_K			32
+
+typedef struct
+{
+	int32_t		vl_len_;
+	uint32_t	nitems;
+	int32_t		k;
+	uint32_t	__padding__;
+	uint64_t	slots[KAGG_TOPK_MAX_K];
+} kagg_state__ptopk_packed;
+
+INLINE_FUNCTION(uint64_t)
+__kagg_topk_encode(float8_t fval)
+{
+	uint64_t	ival = __double_as_longlong__(fval);
+
+	if ((ival & 0x7ff0000000000000UL) == 0x7ff0000000000000UL &&
+		(ival & 0x000fffffffffffffUL) != 0)
+		return 0xfff8000000000000UL;	/* canonical NaN */
+	if ((ival & (1UL<<63)) != 0)
+		return ~ival;
+	return (ival | (1UL<<63));
+}
+
+INLINE_FUNCTION(float8_t)
+__kagg_topk_decode(uint64_t ival)
+{
+	if ((ival & (1UL<<63)) != 0)
+		ival &= ~(1UL<<63);
+	else
+		ival = ~ival;
+	return __longlong_as_double__(ival);
+}
+
+/*
+ * Array of values (array_agg, string_agg)
+ *
+ * It is a per-group append buffer of the values in the heap format. Each
+ * item has a header of the value length and the sort-key length (-1 means
+ * NULL, 0 means no sort-key), followed by the value and the sort-key; both
+ * are MAXALIGN'ed, so the fixed-length values can be written in place.
+ * A thread reserves the space for its item by atomic-add on the 'usage',
+ * thus no locks are needed. The buffer has a fixed capacity; the planner
+ * does not push down the aggregation if the estimated number of items per
+ * group may not fit, and the kernel raises an error on overflow.
+ * Items are unsorted; ORDER BY is applied by the final function.
+ */
+#define KAGG_PARRAY_BUFSZ		(4096 - 4 * sizeof(uint32_t))
+
+typedef struct
+{
+	int32_t		vl_len_;
+	uint32_t	nitems;
+	uint32_t	usage;			/* consumed bytes of the data[] */
+	uint32_t	__padding__;
+	char		data[KAGG_PARRAY_BUFSZ];
+} kagg_state__parray_packed;
+
+typedef struct
+{
+	int32_t		vlen;			/* length of the value, or -1 if NULL */
+	int32_t		klen;			/* length of the sort-key, -1 if NULL, or 0 */
+	char		payload[1] __MAXALIGNED__;
+} kagg_parray_item;
+
+#define KAGG_PARRAY_ITEM_SIZE(vlen,klen)						\
+	(offsetof(kagg_parray_item, payload) +						\
+	 MAXALIGN(Max((vlen),0)) + MAXALIGN(Max((klen),0)))
+
+/*
+ * Shared memory consumption of the grouping-key dictionary per prepfn
+ * buffer; 4 slots per group keeps the load factor 50% or less.
+ */
+#define KAGG_KEYDICT_SLOTS_PER_BUFFER	4
+#define KAGG_KEYDICT_BUFSZ_PER_BUFFER	\
+	(sizeof(uint64_t) * KAGG_KEYDICT_SLOTS_PER_BUFFER)
+
 typedef struct
 {
 	uint32_t	action;			/* any of KAGG_ACTION__* */
@@ -2143,9 +2514,30 @@ struct kern_varslot_desc
 	const struct xpu_datum_operators *vs_ops;
 };
 
+/*
+ * kern_sortkey_desc - sort key definition for GpuSort (top-K)
+ */
+typedef struct kern_sortkey_desc
+{
+	TypeOpCode	key_type_code;
+	int16_t		key_resno;		/* attribute number on the kds_dst */
+	bool		key_desc;		/* true, if DESC order */
+	bool		key_nulls_first;/* true, if NULLS FIRST */
+	const struct xpu_datum_operators *key_ops;
+} kern_sortkey_desc;
+
 #define KERN_EXPRESSION_MAGIC			(0x4b657870)	/* 'K' 'e' 'x' 'p' */
 
 #define KEXP_FLAG__IS_PUSHED_DOWN		0x0001U
+#define KEXP_FLAG__ADAPTIVE_ORDER		0x0002U	/* BoolExpr(AND) arguments can be
+												 * reordered at run-time */
+#define KERN_ADAPTIVE_QUALS_MAX			16		/* 4bits per position */
+#define GPUDIRECT_IO_HIST_NBUCKETS		16		/* <16us, <32us, ... >=262ms */
+#define KEXP_FLAG__COLLATE_WEIGHTS		0x0004U	/* string comparison by the
+												 * collation weight table */
+#define KEXP_FLAG__FAST_HASH			0x0008U	/* HashValue by the device-only
+												 * hash, not compatible to the
+												 * host hash_any() */
 
 #define SPECIAL_DEPTH__PREAGG_FINAL		(-2)
 
@@ -2190,6 +2582,26 @@ struct kern_expression
 			uint16_t	elem_slot_id;	/* slot-id of temporary array element */
 			char		data[1]			__MAXALIGNED__;
 		} saop;		/* ScalarArrayOp */
+		struct {
+			uint32_t	nitems;			/* number of sorted unique values */
+			bool		has_nulls;		/* array contains NULL elements */
+			int64_t		values[1]		__MAXALIGNED__;
+		} saop_sorted;	/* ScalarArrayOp on constant integer array */
+		struct {
+			uint16_t	fieldnum;		/* 0-origin field index to be picked up */
+			uint16_t	nattrs;			/* number of attrs[], for heap walking */
+			struct {
+				int16_t	attlen;
+				int8_t	attalign;
+				bool	attbyval;
+			}			attrs[1];
+		} fsel;		/* FieldSelect */
+		struct {
+			Oid			func_oid;		/* OID of the SQL function */
+			uint32_t	source_len;		/* length of the CUDA C source */
+			char		data[1]			__MAXALIGNED__;	/* symbol + '\0' +
+														 * source + '\0' */
+		} udf;		/* UserDefinedFunc */
 		struct {
 			int			depth;
 			int			nitems;
@@ -2212,6 +2624,28 @@ struct kern_expression
 			uint16_t	sv_slot_id;
 			char		data[1]			__MAXALIGNED__;
 		} save;		/* SaveExpr */
+		struct {
+			uint32_t	cost[KERN_ADAPTIVE_QUALS_MAX];	/* static cost of args */
+			char		data[1]			__MAXALIGNED__;
+		} aqual;	/* BoolExpr(AND) with KEXP_FLAG__ADAPTIVE_ORDER */
+		struct {
+			kern_collate_weights weights;
+			char		data[1]			__MAXALIGNED__;
+		} coll;		/* FuncExpr with KEXP_FLAG__COLLATE_WEIGHTS */
+		struct {
+			uint16_t	nstates;		/* number of DFA states */
+			uint16_t	nclasses;		/* number of symbol classes */
+			uint32_t	trans_offset;	/* offset of the transition table
+										 * (uint16_t[nstates * nclasses])
+										 * from the data[] */
+			uint8_t		symclass[KERN_REGEX_NSYMBOLS];
+			char		data[1]			__MAXALIGNED__;	/* uint8_t flags[nstates] */
+		} regex;	/* regular expression match */
+		struct {
+			uint32_t	nitems;			/* number of kern_jsonpath_item */
+			int32_t		top;			/* index of the top-level item */
+			char		data[1]			__MAXALIGNED__;	/* items + constants */
+		} jsonpath;	/* jsonb_path_exists / jsonb_path_match */
 		struct {
 			int			nattrs;
 			kern_aggregate_desc desc[1];
@@ -2302,11 +2736,35 @@ typedef struct
 #define XpuCommandTag__CPUFallback			2
 #define XpuCommandTag__SuccessFinal			50
 #define XpuCommandTag__OpenSession			100
+#define XpuCommandTag__RingDoorbell			101
+#define XpuCommandTag__RingResponse			102
+#define XpuCommandTag__RdmaSetup			103
+#define XpuCommandTag__CloseSession			104
+#define XpuCommandTag__AttachInnerBuffer	105
+#define XpuCommandTag__DeviceAttrs			106
 #define XpuCommandTag__XpuTaskExec			110
 #define XpuCommandTag__XpuTaskExecGpuCache	111
 #define XpuCommandTag__XpuTaskFinal			119
 #define XpuCommandMagicNumber				0xdeadbeafU
 
+/*
+ * Priority of the xPU tasks; the value is also used as weight of the
+ * fair queuing by the GPU service.
+ */
+#define XPU_TASK_PRIORITY__LOW		1
+#define XPU_TASK_PRIORITY__NORMAL	4
+#define XPU_TASK_PRIORITY__HIGH		16
+
+/* behavior on the GPU memory quota exceeded */
+#define XPU_QUOTA_ACTION__WAIT		0
+#define XPU_QUOTA_ACTION__FALLBACK	1
+#define XPU_QUOTA_ACTION__ERROR		2
+
+/* compression of the result chunks, offered by the backend */
+#define XPU_RESULT_CODEC__NONE		0
+#define XPU_RESULT_CODEC__LZ4		1	/* LZ4 frame */
+#define XPU_RESULT_CODEC__ZSTD		2
+
 /*
  * kern_session_info - A set of immutable data during query execution
  * (like, transaction info, timezone, parameter buffer).
@@ -2321,6 +2779,10 @@ typedef struct kern_session_info
 	uint32_t	kcxt_kvecs_ndims;	/* =(num_rels + 2) */
 	uint32_t	kcxt_extra_bufsz;	/* length of vlbuf[] */
 	uint32_t	xpu_task_flags;		/* mask of device flags */
+	bool		xpucode_use_jit;	/* try JIT compiled xpucode, if GPU */
+	uint32_t	xpu_task_priority;	/* one of XPU_TASK_PRIORITY__* */
+	uint32_t	xpu_result_codec;	/* one of XPU_RESULT_CODEC__*, acceptable
+									 * for the backend */
 	/* xpucode for this session */
 	uint32_t	xpucode_load_vars_packed;
 	uint32_t	xpucode_move_vars_packed;
@@ -2333,11 +2795,16 @@ typedef struct kern_session_info
 	uint32_t	xpucode_groupby_keyload;
 	uint32_t	xpucode_groupby_keycomp;
 	uint32_t	xpucode_groupby_actions;
+	/* plan-invariant portion (kvars-defs, xpucode, sort-keys) to be cached */
+	uint64_t	xpucode_signature;	/* hash of the portion, or 0 */
+	uint32_t	xpucode_cache_head;	/* offset to the head of the portion */
+	uint32_t	xpucode_cache_length; /* length of the portion */
 
 	/* database session info */
 	int64_t		hostEpochTimestamp;	/* = SetEpochTimestamp() */
 	uint64_t	xactStartTimestamp;	/* timestamp when transaction start */
 	uint32_t	session_xact_state;	/* offset to SerializedTransactionState */
+	uint32_t	session_xact_snapshot; /* offset to kern_xact_snapshot, or 0 */
 	uint32_t	session_timezone;	/* offset to pg_tz */
 	uint32_t	session_encode;		/* offset to xpu_encode_info;
 									 * !! function pointer must be set by server */
@@ -2347,44 +2814,137 @@ typedef struct kern_session_info
 	uint32_t	pgsql_port_number;	/* = PostPortNumber */
 	uint32_t	pgsql_plan_node_id;	/* = Plan->plan_node_id */
 	uint32_t	join_inner_handle;	/* key of join inner buffer */
+	uint64_t	join_inner_signature; /* signature of the inner buffer, if
+									   * it is reusable by other queries */
+	bool		join_inner_deferred; /* inner buffer is attached later by
+									  * XpuCommandTag__AttachInnerBuffer */
+	bool		join_right_outer_on_device; /* RIGHT/FULL OUTER JOIN can be
+											 * completed on the device */
+	uint32_t	join_bloom_prefilter; /* bitmap of the depths whose bloom-filter
+									   * is applicable at the first depth */
+	uint32_t	xcmd_ring_handle;	/* key of xpuCommandRing, if any */
+	uint32_t	xresp_ring_handle;	/* key of xpuResultRing, if any */
 
 	/* group-by final buffer */
 	uint32_t	groupby_kds_final;	/* header portion of kds_final */
 	uint32_t	groupby_prepfn_bufsz; /* buffer size for preagg functions */
 	float4_t	groupby_ngroups_estimation; /* planne's estimation of ngroups */
+	bool		groupby_sorted_run;	/* enables the sorted-run mode */
+	uint64_t	groupby_kds_final_limit; /* max length of kds_final, or 0 */
+	/* GPU quota per database/role */
+	uint32_t	quota_database_oid;
+	uint32_t	quota_role_oid;
+	uint64_t	quota_memory_limit;	/* max device memory in bytes, or 0 */
+	uint32_t	quota_tasks_limit;	/* max GPU tasks in execution, or 0 */
+	uint32_t	quota_action;		/* one of XPU_QUOTA_ACTION__* */
+	uint32_t	quota_wait_timeout;	/* in ms, for XPU_QUOTA_ACTION__WAIT */
+	/* gpu-sort (top-K) parameters */
+	uint32_t	gpusort_keydesc;	/* offset to kern_sortkey_desc[] */
+	uint32_t	gpusort_nkeys;		/* number of sort keys */
+	uint64_t	gpusort_limit;		/* bound of top-K, if any */
+	/* LIMIT clause */
+	uint64_t	scan_limit;			/* max number of rows to be returned,
+									 * or 0 if unbounded */
+	/* TABLESAMPLE clause */
+	uint32_t	tablesample_method;	/* one of TABLESAMPLE_METHOD__* */
+	uint32_t	tablesample_seed;	/* seed of the sampling */
+	uint64_t	tablesample_threshold; /* fraction of sampling in 2^32 */
+	/* point lookup using the hash-index of GpuCache */
+	int32_t		gcache_lookup_attnum; /* attnum of the key, or 0 */
+	uint32_t	gcache_lookup_hash;	/* hash of the key */
 	/* executor parameter buffer */
 	uint32_t	nparams;	/* number of parameters */
 	uint32_t	poffset[1];	/* offset of params */
 } kern_session_info;
 
+/*
+ * TABLESAMPLE support
+ *
+ * SYSTEM method chooses the blocks, and BERNOULLI method chooses the tuples
+ * using the hash of the ctid and seed. Both of host and device code use
+ * the same logic, so CPU fallback picks up the identical set of the rows.
+ */
+#define TABLESAMPLE_METHOD__NONE		0
+#define TABLESAMPLE_METHOD__SYSTEM		1
+#define TABLESAMPLE_METHOD__BERNOULLI	2
+
+INLINE_FUNCTION(bool)
+pgstrom_tablesample_check(uint32_t method,
+						  uint32_t seed,
+						  uint64_t threshold,
+						  uint32_t block_nr,
+						  uint32_t offnum)
+{
+	uint64_t	hash;
+
+	if (method == TABLESAMPLE_METHOD__NONE)
+		return true;
+	if (method == TABLESAMPLE_METHOD__SYSTEM)
+		offnum = 0;
+	/* splitmix64 finalizer */
+	hash = ((((uint64_t)block_nr << 16) | (uint64_t)(offnum & 0xffffU)) +
+			(uint64_t)seed * 0x9e3779b97f4a7c15UL);
+	hash = (hash ^ (hash >> 30)) * 0xbf58476d1ce4e5b9UL;
+	hash = (hash ^ (hash >> 27)) * 0x94d049bb133111ebUL;
+	hash = (hash ^ (hash >> 31));
+	return ((hash & 0xffffffffUL) < threshold);
+}
+
 typedef struct {
 	uint32_t	kds_src_pathname;	/* offset to const char *pathname */
 	uint32_t	kds_src_iovec;		/* offset to strom_io_vector */
 	uint32_t	kds_src_offset;		/* offset to kds_src */
 	uint32_t	kds_dst_offset;		/* offset to kds_dst */
+	uint32_t	inner_part_id;		/* current inner partition, if grace
+									 * hash-join is involved */
 	char		data[1]				__MAXALIGNED__;
 } kern_exec_task;
 
 typedef struct {
 	bool		final_plan_node;
 	bool		final_this_device;
+	uint32_t	kds_dst_offset;		/* offset to kds_dst, if RIGHT/FULL OUTER
+									 * JOIN may be completed on the device */
 	char		data[1]				__MAXALIGNED__;
 } kern_final_task;
 
 typedef struct {
 	uint32_t	chunks_offset;		/* offset of kds_dst array */
 	uint32_t	chunks_nitems;		/* number of kds_dst items */
+	uint32_t	chunks_codec;		/* XPU_RESULT_CODEC__* if kds_dst array
+									 * is compressed as a whole */
+	uint64_t	chunks_rawsz;		/* length of kds_dst array if compressed */
 	uint32_t	ojmap_offset;		/* offset of outer-join-map */
 	uint32_t	ojmap_length;		/* length of outer-join-map */
 	kern_final_task kfin;			/* copy from XpuTaskFinal if any */
 	bool		final_plan_node;
 	bool		final_this_device;
+	bool		final_right_outer;	/* unmatched inner tuples of RIGHT/FULL
+									 * OUTER JOIN are already processed */
 	/* statistics */
 	uint32_t	npages_direct_read;	/* # of pages read by GPU-Direct Storage */
 	uint32_t	npages_vfs_read;	/* # of pages read by VFS (fallback) */
+	uint32_t	npages_dpucache_hit; /* # of pages found on the DPU block cache */
 	uint32_t	nitems_raw;		/* # of visible rows kept in the relation */
 	uint32_t	nitems_in;		/* # of result rows in depth-0 after WHERE-clause */
 	uint32_t	nitems_out;		/* # of result rows in final depth before host quals */
+	uint32_t	usec_load;		/* time to load the source buffer (us) */
+	uint32_t	usec_kernel;	/* time of kernel execution (us) */
+	uint32_t	usec_writeback;	/* time to move the results to host (us) */
+	/* GPU-Direct reads at the task load (see gpuDirectIOCounter) */
+	uint32_t	gpudirect_nr_ios;
+	uint32_t	gpudirect_usec_io;
+	uint32_t	gpudirect_usec_max;
+	uint32_t	gpudirect_io_hist[GPUDIRECT_IO_HIST_NBUCKETS];
+	/* kernel geometry */
+	uint32_t	kernel_grid_sz;
+	uint32_t	kernel_block_sz;
+	uint32_t	kernel_shmem_sz;
+	/* adaptive reordering of scan-quals, if any */
+	uint32_t	scan_quals_nquals;
+	uint64_t	scan_quals_order;
+	uint32_t	scan_quals_nevals[KERN_ADAPTIVE_QUALS_MAX];
+	uint32_t	scan_quals_npassed[KERN_ADAPTIVE_QUALS_MAX];
 	uint32_t	num_rels;
 	struct {
 		uint32_t	nitems_gist;/* # of results rows by GiST index (if any) */
@@ -2401,6 +2961,45 @@ typedef struct
 	kern_data_store		kds_src;
 } kern_cpu_fallback;
 
+/*
+ * kern_rdma_params - exchanged by XpuCommandTag__RdmaSetup, to connect
+ * the RC queue-pair between the backend and the DPU service. The backend
+ * also informs the layout of the result ring buffer that is registered
+ * as a memory region; the DPU service writes back the responses there
+ * using RDMA WRITE, then sends only its offset by the TCP socket.
+ * qp_num == 0 in the response means RDMA is not available.
+ */
+typedef struct
+{
+	uint32_t	qp_num;
+	uint32_t	psn;
+	uint16_t	lid;
+	uint8_t		mtu;				/* enum ibv_mtu */
+	uint8_t		gid_index;
+	uint8_t		gid[16];
+	/* only backend -> DPU service */
+	uint64_t	ring_addr;			/* address of the xpuResultRing */
+	uint32_t	ring_rkey;
+	uint32_t	ring_head_offset;	/* offsetof(xpuResultRing, head) */
+	uint32_t	ring_tail_offset;	/* offsetof(xpuResultRing, tail) */
+	uint32_t	ring_data_offset;	/* offsetof(xpuResultRing, data) */
+	uint64_t	ring_nbytes;		/* capacity of the data[] */
+	uint32_t	ring_item_headsz;	/* offsetof(xpuResultRingItem, data) */
+	uint32_t	ring_align;			/* XPU_RESULT_RING_ALIGN */
+} kern_rdma_params;
+
+/*
+ * kern_inner_attach - sent by XpuCommandTag__AttachInnerBuffer, when the
+ * inner preloading is completed after the session open; the outer chunks
+ * already sent are held by the GPU service until the attachment.
+ * join_inner_handle == 0 means no inner buffer, so the join is empty.
+ */
+typedef struct
+{
+	uint32_t	join_inner_handle;
+	uint64_t	join_inner_signature;
+} kern_inner_attach;
+
 #ifndef ILIST_H
 typedef struct dlist_node
 {
@@ -2427,12 +3026,25 @@ typedef struct
 		kern_final_task		fin;
 		kern_exec_results	results;
 		kern_cpu_fallback	fallback;
+		uint64_t			ring_offset; /* XpuCommandTag__RingResponse */
+		kern_rdma_params	rdma;		/* XpuCommandTag__RdmaSetup */
+		kern_inner_attach	inner;		/* XpuCommandTag__AttachInnerBuffer */
 	} u;
 } XpuCommand;
 
 /*
  * kern_session_info utility functions.
  */
+INLINE_FUNCTION(kern_sortkey_desc *)
+SESSION_GPUSORT_KEYDESC(const kern_session_info *session)
+{
+	if (session->gpusort_nkeys == 0 ||
+		session->gpusort_keydesc == 0)
+		return NULL;
+
+	return (kern_sortkey_desc *)((char *)session + session->gpusort_keydesc);
+}
+
 INLINE_FUNCTION(kern_varslot_desc *)
 SESSION_KVARS_SLOT_DESC(const kern_session_info *session)
 {
@@ -2652,6 +3264,135 @@ SESSION_XACT_STATE(kern_session_info *session)
 	return (SerializedTransactionState *)((char *)session + session->session_xact_state);
 }
 
+/*
+ * kern_xact_snapshot - MVCC snapshot and commit status of the recent
+ * transactions, to check visibility of the tuples on the device.
+ */
+typedef struct
+{
+	TransactionId	xmin;		/* all xid < xmin are finished */
+	TransactionId	xmax;		/* all xid >= xmax are in-progress */
+	uint32_t		xcnt;		/* # of xip[] (including subxip) */
+	TransactionId	clog_base;	/* the first xid of the commit bitmap */
+	uint32_t		clog_nxids;	/* # of xids in the commit bitmap */
+	uint32_t		clog_offset; /* offset to the commit bitmap */
+	TransactionId	xip[1];		/* variable */
+} kern_xact_snapshot;
+
+INLINE_FUNCTION(kern_xact_snapshot *)
+SESSION_XACT_SNAPSHOT(kern_session_info *session)
+{
+	if (session->session_xact_snapshot == 0)
+		return NULL;
+	return (kern_xact_snapshot *)((char *)session + session->session_xact_snapshot);
+}
+
+INLINE_FUNCTION(bool)
+__xact_snapshot_xid_in_progress(const kern_xact_snapshot *ksnap,
+								TransactionId xid)
+{
+	if ((int32_t)(xid - ksnap->xmin) < 0)
+		return false;
+	if ((int32_t)(xid - ksnap->xmax) >= 0)
+		return true;
+	for (uint32_t i=0; i < ksnap->xcnt; i++)
+	{
+		if (ksnap->xip[i] == xid)
+			return true;
+	}
+	return false;
+}
+
+/* returns 1 if committed, 0 if aborted, or -1 if unknown */
+INLINE_FUNCTION(int)
+__xact_snapshot_xid_status(const kern_xact_snapshot *ksnap,
+						   TransactionId xid)
+{
+	const uint8_t  *bitmap;
+	uint32_t		index;
+
+	if (xid == BootstrapTransactionId || xid == FrozenTransactionId)
+		return 1;
+	index = xid - ksnap->clog_base;
+	if (index >= ksnap->clog_nxids)
+		return -1;
+	bitmap = (const uint8_t *)ksnap + ksnap->clog_offset;
+	return ((bitmap[index>>3] & (1U << (index & 7))) != 0 ? 1 : 0);
+}
+
+INLINE_FUNCTION(bool)
+__xact_state_is_current_xid(const SerializedTransactionState *xstate,
+							TransactionId xid)
+{
+	for (int i=0; i < xstate->nParallelCurrentXids; i++)
+	{
+		if (xstate->parallelCurrentXids[i] == xid)
+			return true;
+	}
+	return false;
+}
+
+/*
+ * HeapTupleSatisfiesMVCCOnDevice
+ *
+ * It returns 1 if visible, 0 if invisible, or -1 if the device cannot
+ * decide visibility of the tuple (tuples modified by the current
+ * transaction, multixact, or xid out of the commit bitmap).
+ */
+INLINE_FUNCTION(int)
+HeapTupleSatisfiesMVCCOnDevice(kern_session_info *session,
+							   const HeapTupleHeaderData *htup)
+{
+	const kern_xact_snapshot *ksnap = SESSION_XACT_SNAPSHOT(session);
+	const SerializedTransactionState *xstate = SESSION_XACT_STATE(session);
+	uint16_t		infomask = htup->t_infomask;
+	TransactionId	xmin = htup->t_choice.t_heap.t_xmin;
+	TransactionId	xmax = htup->t_choice.t_heap.t_xmax;
+	int				status;
+
+	if (!ksnap || !xstate)
+		return -1;
+	/* check xmin */
+	if ((infomask & (HEAP_XMIN_COMMITTED |
+					 HEAP_XMIN_INVALID)) == (HEAP_XMIN_COMMITTED |
+											 HEAP_XMIN_INVALID))
+		;	/* frozen tuple */
+	else if ((infomask & HEAP_XMIN_INVALID) != 0)
+		return 0;
+	else
+	{
+		if (__xact_state_is_current_xid(xstate, xmin))
+			return -1;
+		if (__xact_snapshot_xid_in_progress(ksnap, xmin))
+			return 0;
+		if ((infomask & HEAP_XMIN_COMMITTED) == 0)
+		{
+			status = __xact_snapshot_xid_status(ksnap, xmin);
+			if (status <= 0)
+				return status;
+		}
+	}
+	/* check xmax */
+	if ((infomask & HEAP_XMAX_INVALID) != 0 ||
+		(infomask & HEAP_XMAX_LOCK_ONLY) != 0 ||
+		(infomask & (HEAP_XMAX_IS_MULTI |
+					 HEAP_XMAX_EXCL_LOCK |
+					 HEAP_XMAX_KEYSHR_LOCK)) == HEAP_XMAX_EXCL_LOCK)
+		return 1;	/* not deleted, or locked only */
+	if ((infomask & HEAP_XMAX_IS_MULTI) != 0)
+		return -1;
+	if (__xact_state_is_current_xid(xstate, xmax))
+		return -1;
+	if (__xact_snapshot_xid_in_progress(ksnap, xmax))
+		return 1;
+	if ((infomask & HEAP_XMAX_COMMITTED) != 0)
+		return 0;
+	status = __xact_snapshot_xid_status(ksnap, xmax);
+	if (status < 0)
+		return -1;
+	return (status > 0 ? 0 : 1);
+}
+
 INLINE_FUNCTION(struct pg_tz *)
 SESSION_TIMEZONE(kern_session_info *session)
 {
@@ -2754,9 +3495,15 @@ SESSION_ENCODE(kern_session_info *session)
 					continue;											\
 				}														\
 				temp = (XpuCommand *)buffer;							\
+				if (temp->magic != XpuCommandMagicNumber ||				\
+					temp->length < offsetof(XpuCommand, u))				\
+				{														\
+					fprintf(stderr, "[%s] broken XpuCommand header (magic=%08x, length=%lu)\n", \
+							error_label, temp->magic, temp->length);	\
+					return -1;											\
+				}														\
 				if (temp->length <= offset)								\
 				{														\
-					assert(temp->magic == XpuCommandMagicNumber);		\
 					xcmd = __XPU_PREFIX##AllocCommand(priv, temp->length); \
 					if (!xcmd)											\
 					{													\
@@ -2820,6 +3567,11 @@ kern_estimate_heaptuple(kern_context *kcxt,
 						const kern_expression *kproj,
 						const kern_data_store *kds_dst);
 EXTERN_FUNCTION(bool)
+kern_form_column_item(kern_context *kcxt,
+					  const kern_expression *kproj,
+					  kern_data_store *kds_dst,
+					  uint32_t rowid);
+EXTERN_FUNCTION(bool)
 ExecLoadVarsHeapTuple(kern_context *kcxt,
 					  const kern_expression *kexp_load_vars,
 					  int depth,
@@ -2893,6 +3645,8 @@ EXTERN_FUNCTION(void)
 pg_kern_ereport(kern_context *kcxt);	/* only host code */
 EXTERN_FUNCTION(uint32_t)
 pg_hash_any(const void *ptr, int sz);
+EXTERN_FUNCTION(uint32_t)
+pg_hash_fast(const void *ptr, int sz);
 
 /* ----------------------------------------------------------------
  *
@@ -2909,9 +3663,22 @@ struct kern_multirels
 		uint64_t	kds_offset;		/* offset to KDS */
 		uint64_t	ojmap_offset;	/* offset to outer-join map, if any */
 		uint64_t	gist_offset;	/* offset to GiST-index pages, if any */
+		uint64_t	parts_offset;	/* offset to the array of partition KDS
+									 * offset, if grace hash-join */
+		uint64_t	bloom_offset;	/* offset to the bloom-filter, if any */
+		uint32_t	bloom_nbits;	/* number of bits; power of 2 */
+		uint64_t	hbucket_offset;	/* offset to the hash-bucket, if any */
+		uint64_t	range_offset;	/* offset to the range-index, if any */
+		uint64_t	polyidx_offset;	/* offset to the polygon-index, if any */
+		uint64_t	dmap_offset;	/* offset to the direct-address map, if any */
+		uint32_t	num_parts;		/* number of hash-partitions, or 0 */
 		bool		is_nestloop;	/* true, if NestLoop */
 		bool		left_outer;		/* true, if JOIN_LEFT or JOIN_FULL */
 		bool		right_outer;	/* true, if JOIN_RIGHT or JOIN_FULL */
+		bool		semi_join;		/* true, if JOIN_SEMI */
+		bool		anti_join;		/* true, if JOIN_ANTI */
+		bool		hbucket_on_device; /* true, if hash-bucket shall be
+										* built by the GPU */
 	} chunks[1];
 };
 typedef struct kern_multirels	kern_multirels;
@@ -2926,6 +3693,34 @@ KERN_MULTIRELS_INNER_KDS(kern_multirels *kmrels, int dindex)
 	return (kern_data_store *)(offset == 0 ? NULL : ((char *)kmrels + offset));
 }
 
+/*
+ * Grace hash-join support
+ *
+ * When the inner hash table is too large to keep on the device memory,
+ * it is split into multiple partitions by the hash value, then the outer
+ * relation is scanned for each partition. Partition-id is determined by
+ * the upper bits of the hash value, because the lower bits are used to
+ * choose the hash-slot in each partition.
+ */
+INLINE_FUNCTION(uint32_t)
+KERN_HASH_PARTITION_ID(uint32_t hash, uint32_t num_parts)
+{
+	return (num_parts <= 1 ? 0 : (hash >> 16) % num_parts);
+}
+
+INLINE_FUNCTION(kern_data_store *)
+KERN_MULTIRELS_INNER_PART_KDS(kern_multirels *kmrels, int dindex, uint32_t part_id)
+{
+	uint64_t   *parts;
+
+	assert(dindex >= 0 && dindex < kmrels->num_rels);
+	if (kmrels->chunks[dindex].num_parts <= 1)
+		return KERN_MULTIRELS_INNER_KDS(kmrels, dindex);
+	assert(part_id < kmrels->chunks[dindex].num_parts);
+	parts = (uint64_t *)((char *)kmrels + kmrels->chunks[dindex].parts_offset);
+	return (kern_data_store *)((char *)kmrels + parts[part_id]);
+}
+
 INLINE_FUNCTION(bool *)
 KERN_MULTIRELS_OUTER_JOIN_MAP(kern_multirels *kmrels, int dindex)
 {
@@ -2946,6 +3741,326 @@ KERN_MULTIRELS_GIST_INDEX(kern_multirels *kmrels, int dindex)
 	return (kern_data_store *)(offset == 0 ? NULL : ((char *)kmrels + offset));
 }
 
+/*
+ * Bloom-filter of the inner hash-table
+ *
+ * It is built on the hash values of the inner join-keys during the inner
+ * preloading, then outer tuples are checked prior to walk on the hash-slot.
+ * Two bits are picked up from the 32bit hash value.
+ */
+INLINE_FUNCTION(uint32_t *)
+KERN_MULTIRELS_BLOOM_FILTER(kern_multirels *kmrels, int dindex)
+{
+	uint64_t	offset;
+
+	assert(dindex >= 0 && dindex < kmrels->num_rels);
+	offset = kmrels->chunks[dindex].bloom_offset;
+	return (uint32_t *)(offset == 0 ? NULL : ((char *)kmrels + offset));
+}
+
+/*
+ * Bucketized index of the inner hash-table
+ *
+ * Every probe on the hash-slot of KDS_FORMAT_HASH walks on the list of
+ * kern_hashitem scattered over the device memory. The hash-bucket packs
+ * the hash values that belong to the same hash-slot contiguously, so
+ * a probe scans a few cache-lines and touches the kern_hashitem only
+ * when the hash value is matched. It is built by the last participant
+ * of the inner preloading in addition to the hash-slot, or built by
+ * the GPU on the setup of the inner buffer if 'hbucket_on_device'.
+ *
+ * The hash values are sorted within the hash-slot, so a probe finds the
+ * first item by binary search, then the items with the identical hash
+ * value are contiguous. It keeps the cost of probes stable even if a few
+ * heavy-hitter keys have massive duplications in the inner relation.
+ *
+ * +-----------------------+
+ * | kern_hash_bucket      |
+ * | start[nslots+1]       |  <-- range of the items for each hash-slot
+ * +-----------------------+
+ * | hashes[nitems]        |  <-- hash values ordered by (hash-slot, hash)
+ * +-----------------------+
+ * | items[nitems]         |  <-- packed offset of the kern_hashitem
+ * +-----------------------+
+ */
+typedef struct
+{
+	uint32_t	nslots;			/* =kds->hash_nslots */
+	uint32_t	nitems;			/* =kds->nitems */
+	uint32_t	start[1];		/* variable length */
+} kern_hash_bucket;
+
+#define KERN_HASH_BUCKET_LENGTH(nslots,nitems)						\
+	MAXALIGN(offsetof(kern_hash_bucket, start[(nslots)+1]) +		\
+			 2 * sizeof(uint32_t) * (nitems))
+
+INLINE_FUNCTION(uint32_t *)
+KERN_HASH_BUCKET_HASHES(const kern_hash_bucket *hbucket)
+{
+	return (uint32_t *)(hbucket->start + hbucket->nslots + 1);
+}
+
+INLINE_FUNCTION(uint32_t *)
+KERN_HASH_BUCKET_ITEMS(const kern_hash_bucket *hbucket)
+{
+	return KERN_HASH_BUCKET_HASHES(hbucket) + hbucket->nitems;
+}
+
+INLINE_FUNCTION(kern_hash_bucket *)
+KERN_MULTIRELS_HASH_BUCKET(kern_multirels *kmrels, int dindex)
+{
+	uint64_t	offset;
+
+	assert(dindex >= 0 && dindex < kmrels->num_rels);
+	offset = kmrels->chunks[dindex].hbucket_offset;
+	return (kern_hash_bucket *)(offset == 0 ? NULL : ((char *)kmrels + offset));
+}
+
+/*
+ * KDS_HASH_BUCKET_LOOKUP
+ *
+ * It looks up the kern_hashitem that has the 'hash' value. If '*p_hpos' is
+ * zero, it searches the first item in the hash-slot, elsewhere it checks
+ * the next item at the bucket position '*p_hpos'. Then, it updates *p_hpos
+ * to the position of the item found.
+ */
+INLINE_FUNCTION(kern_hashitem *)
+KDS_HASH_BUCKET_LOOKUP(const kern_data_store *kds,
+					   const kern_hash_bucket *hbucket,
+					   uint32_t hash, uint32_t *p_hpos)
+{
+	const uint32_t *hashes = KERN_HASH_BUCKET_HASHES(hbucket);
+	uint32_t	hindex = hash % hbucket->nslots;
+	uint32_t	hpos = __volatileRead(&hbucket->start[hindex]);
+	uint32_t	hend = __volatileRead(&hbucket->start[hindex+1]);
+
+	if (*p_hpos == 0)
+	{
+		/* binary search of the first item */
+		uint32_t	tail = hend;
+
+		while (hpos < tail)
+		{
+			uint32_t	mid = hpos + (tail - hpos) / 2;
+
+			if (__volatileRead(&hashes[mid]) < hash)
+				hpos = mid + 1;
+			else
+				tail = mid;
+		}
+	}
+	else
+		hpos = Max(*p_hpos, hpos);
+
+	if (hpos < hend && __volatileRead(&hashes[hpos]) == hash)
+	{
+		uint32_t	offset = __volatileRead(KERN_HASH_BUCKET_ITEMS(hbucket) + hpos);
+		kern_hashitem *hitem = (kern_hashitem *)((char *)kds
+												 + kds->length
+												 - __kds_unpack(offset));
+		Assert(__KDS_HASH_ITEM_CHECK_VALID(kds, hitem));
+		*p_hpos = hpos;
+		return hitem;
+	}
+	return NULL;
+}
+
+/*
+ * Direct-address map of the inner hash-table
+ *
+ * When the hash-join has a single integer join-key on a dense domain (like
+ * surrogate keys 1..N of the dimension tables), the last participant of the
+ * inner preloading indexes the kern_hashitem by (key - key_min), so a probe
+ * does not compute the hash value nor walk on the hash-slot; it is just
+ * a load of start[] and items[]. Items with the identical key are
+ * contiguous, like the hash-bucket. Inner tuples with NULL key are not
+ * indexed, because the join-quals never match them.
+ *
+ * +-----------------------+
+ * | kern_direct_map       |
+ * | start[nslots+1]       |  <-- range of the items for each key
+ * +-----------------------+
+ * | items[nrooms]         |  <-- packed offset of the kern_hashitem
+ * +-----------------------+
+ */
+typedef struct
+{
+	int64_t		key_min;		/* key of start[0] */
+	uint32_t	nslots;			/* =key_max - key_min + 1 */
+	uint32_t	nitems;			/* number of the items with non-NULL key */
+	uint32_t	start[1];		/* variable length */
+} kern_direct_map;
+
+#define KERN_DIRECT_MAP_LENGTH(nslots,nrooms)						\
+	MAXALIGN(offsetof(kern_direct_map, start[(nslots)+1]) +		\
+			 sizeof(uint32_t) * (nrooms))
+
+INLINE_FUNCTION(uint32_t *)
+KERN_DIRECT_MAP_ITEMS(const kern_direct_map *dmap)
+{
+	return (uint32_t *)(dmap->start + dmap->nslots + 1);
+}
+
+INLINE_FUNCTION(kern_direct_map *)
+KERN_MULTIRELS_DIRECT_MAP(kern_multirels *kmrels, int dindex)
+{
+	uint64_t	offset;
+
+	assert(dindex >= 0 && dindex < kmrels->num_rels);
+	offset = kmrels->chunks[dindex].dmap_offset;
+	return (kern_direct_map *)(offset == 0 ? NULL : ((char *)kmrels + offset));
+}
+
+/*
+ * KDS_DIRECT_MAP_LOOKUP
+ *
+ * It looks up the kern_hashitem that has the 'key', with the same manner
+ * of KDS_HASH_BUCKET_LOOKUP; '*p_hpos' is zero to fetch the first item.
+ */
+INLINE_FUNCTION(kern_hashitem *)
+KDS_DIRECT_MAP_LOOKUP(const kern_data_store *kds,
+					  const kern_direct_map *dmap,
+					  int64_t key, uint32_t *p_hpos)
+{
+	uint64_t	index;
+	uint32_t	hpos;
+	uint32_t	hend;
+
+	if (key < dmap->key_min)
+		return NULL;
+	index = (uint64_t)key - (uint64_t)dmap->key_min;
+	if (index >= dmap->nslots)
+		return NULL;
+	hpos = Max(*p_hpos, dmap->start[index]);
+	hend = dmap->start[index+1];
+	if (hpos < hend)
+	{
+		uint32_t	offset = KERN_DIRECT_MAP_ITEMS(dmap)[hpos];
+		kern_hashitem *hitem = (kern_hashitem *)((char *)kds
+												 + kds->length
+												 - __kds_unpack(offset));
+		Assert(__KDS_HASH_ITEM_CHECK_VALID(kds, hitem));
+		*p_hpos = hpos;
+		return hitem;
+	}
+	return NULL;
+}
+
+/*
+ * Range-index of the inner heap buffer
+ *
+ * Range-join (like 'o.ts BETWEEN s.start_ts AND s.end_ts') loads the inner
+ * tuples onto the heap buffer as nested-loop doing, then the last participant
+ * of the inner preloading builds the range-index that sorts the inner tuples
+ * by the lower bound. upper_max[i] is the maximum upper bound of the items
+ * in [0...i], so a probe finds the last item whose lower bound is less than
+ * or equal to the outer key by binary search, then walks on the items
+ * backward until upper_max[] get less than the outer key.
+ * The bounds are normalized to int64 (integers, date and timestamp[tz]).
+ *
+ * +-----------------------+
+ * | kern_range_index      |
+ * | lower[nrooms]         |  <-- lower bound, in ascending order
+ * +-----------------------+
+ * | upper[nrooms]         |  <-- upper bound of the item
+ * +-----------------------+
+ * | upper_max[nrooms]     |  <-- max of upper[0...i]
+ * +-----------------------+
+ * | rowids[nrooms]        |  <-- index to KDS_GET_ROWINDEX()
+ * +-----------------------+
+ */
+typedef struct
+{
+	uint32_t	nrooms;			/* =kds->nitems */
+	uint32_t	nitems;			/* number of the items with non-NULL bounds */
+	int64_t		lower[1];		/* variable length */
+} kern_range_index;
+
+#define KERN_RANGE_INDEX_LENGTH(nrooms)								\
+	MAXALIGN(offsetof(kern_range_index, lower[3 * (nrooms)]) +		\
+			 sizeof(uint32_t) * (nrooms))
+
+INLINE_FUNCTION(int64_t *)
+KERN_RANGE_INDEX_UPPER(const kern_range_index *ridx)
+{
+	return (int64_t *)(ridx->lower + ridx->nrooms);
+}
+
+INLINE_FUNCTION(int64_t *)
+KERN_RANGE_INDEX_UPPER_MAX(const kern_range_index *ridx)
+{
+	return (int64_t *)(ridx->lower + 2 * ridx->nrooms);
+}
+
+INLINE_FUNCTION(uint32_t *)
+KERN_RANGE_INDEX_ROWIDS(const kern_range_index *ridx)
+{
+	return (uint32_t *)(ridx->lower + 3 * ridx->nrooms);
+}
+
+INLINE_FUNCTION(kern_range_index *)
+KERN_MULTIRELS_RANGE_INDEX(kern_multirels *kmrels, int dindex)
+{
+	uint64_t	offset;
+
+	assert(dindex >= 0 && dindex < kmrels->num_rels);
+	offset = kmrels->chunks[dindex].range_offset;
+	return (kern_range_index *)(offset == 0 ? NULL : ((char *)kmrels + offset));
+}
+
+INLINE_FUNCTION(kern_polygon_index *)
+KERN_MULTIRELS_POLYGON_INDEX(kern_multirels *kmrels, int dindex)
+{
+	uint64_t	offset;
+
+	assert(dindex >= 0 && dindex < kmrels->num_rels);
+	offset = kmrels->chunks[dindex].polyidx_offset;
+	return (kern_polygon_index *)(offset == 0 ? NULL : ((char *)kmrels + offset));
+}
+
+/*
+ * KERN_RANGE_INDEX_SEARCH
+ *
+ * It returns the number of items whose lower bound is less than or equal
+ * to the 'key'; so, the candidates are the items prior to the position.
+ */
+INLINE_FUNCTION(uint32_t)
+KERN_RANGE_INDEX_SEARCH(const kern_range_index *ridx, int64_t key)
+{
+	uint32_t	head = 0;
+	uint32_t	tail = ridx->nitems;
+
+	while (head < tail)
+	{
+		uint32_t	mid = head + (tail - head) / 2;
+
+		if (ridx->lower[mid] <= key)
+			head = mid + 1;
+		else
+			tail = mid;
+	}
+	return head;
+}
+
+INLINE_FUNCTION(void)
+__kern_bloom_filter_bits(uint32_t hash, uint32_t nbits,
+						 uint32_t *p_bit1, uint32_t *p_bit2)
+{
+	assert(nbits > 0 && (nbits & (nbits - 1)) == 0);
+	*p_bit1 = (hash & (nbits - 1));
+	*p_bit2 = (((hash >> 16) | (hash << 16)) * 0x9e3779b1U) & (nbits - 1);
+}
+
+INLINE_FUNCTION(bool)
+kern_bloom_filter_check(const uint32_t *bloom, uint32_t nbits, uint32_t hash)
+{
+	uint32_t	bit1, bit2;
+
+	__kern_bloom_filter_bits(hash, nbits, &bit1, &bit2);
+	return ((bloom[bit1 >> 5] & (1U << (bit1 & 31))) != 0 &&
+			(bloom[bit2 >> 5] & (1U << (bit2 & 31))) != 0);
+}
+
 /* ----------------------------------------------------------------
  *
  * Atomic Operations
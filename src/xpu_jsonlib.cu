@@ -69,8 +69,14 @@ xpu_jsonb_is_valid(kern_context *kcxt, const xpu_jsonb_t *arg)
 {
 	if (arg->length < 0)
 	{
-		STROM_CPU_FALLBACK(kcxt, "jsonb datum is compressed or external");
-		return false;
+		/* expand the inline compressed datum on the kcxt buffer */
+		xpu_jsonb_t	   *__arg = (xpu_jsonb_t *)arg;
+
+		if (!xpu_varlena_decompress(kcxt, &__arg->value, &__arg->length))
+		{
+			STROM_CPU_FALLBACK(kcxt, "jsonb datum is compressed or external");
+			return false;
+		}
 	}
 	return true;
 }
@@ -400,6 +406,42 @@ findJsonbIndexFromObject(JsonbContainer *jc,	/* may not be aligned */
 	return -1;
 }
 
+/*
+ * findJsonbIndexFromObjectCached
+ *
+ * It looks up the key-cache at kern_context first. Only the containers and
+ * keys on the read-only memory (source data or constant) are cached, because
+ * the kcxt buffer is reused for the other rows.
+ */
+STATIC_FUNCTION(int32_t)
+findJsonbIndexFromObjectCached(kern_context *kcxt,
+							   JsonbContainer *jc,	/* may not be aligned */
+							   const char *key, int32_t keylen)
+{
+	int32_t		index;
+	uint32_t	k;
+
+	if (((const char *)jc  >= kcxt->vlbuf && (const char *)jc  < kcxt->vlend) ||
+		((const char *)key >= kcxt->vlbuf && (const char *)key < kcxt->vlend))
+		return findJsonbIndexFromObject(jc, key, keylen);
+
+	for (k=0; k < KERN_JSONB_KEYCACHE_NSLOTS; k++)
+	{
+		if (kcxt->jsonb_keycache[k].jc  == jc &&
+			kcxt->jsonb_keycache[k].key == key &&
+			kcxt->jsonb_keycache[k].keylen == keylen)
+			return kcxt->jsonb_keycache[k].index;
+	}
+	index = findJsonbIndexFromObject(jc, key, keylen);
+	k = (kcxt->jsonb_keycache_next++ % KERN_JSONB_KEYCACHE_NSLOTS);
+	kcxt->jsonb_keycache[k].jc     = jc;
+	kcxt->jsonb_keycache[k].key    = key;
+	kcxt->jsonb_keycache[k].keylen = keylen;
+	kcxt->jsonb_keycache[k].index  = index;
+
+	return index;
+}
+
 STATIC_FUNCTION(bool)
 extractJsonbItemFromContainer(kern_context *kcxt,
 							  xpu_jsonb_t *result,
@@ -819,7 +861,7 @@ pgfn_jsonb_object_field(XPU_PGFUNCTION_ARGS)
 			char	   *base = (char *)(jc->children + 2 * count);
 			int32_t		index;
 
-			index = findJsonbIndexFromObject(jc, key.value, key.length);
+			index = findJsonbIndexFromObjectCached(kcxt, jc, key.value, key.length);
 			if (index < 0 || index >= count)
 				result->expr_ops = NULL;
 			else
@@ -916,7 +958,7 @@ pgfn_jsonb_object_field_text(XPU_PGFUNCTION_ARGS)
 			char	   *base = (char *)(jc->children + 2 * count);
 			int32_t		index;
 
-			index = findJsonbIndexFromObject(jc, key.value, key.length);
+			index = findJsonbIndexFromObjectCached(kcxt, jc, key.value, key.length);
 			if (index < 0 || index >= count)
 				result->expr_ops = NULL;
 			else
@@ -1003,8 +1045,8 @@ pgfn_jsonb_exists(XPU_PGFUNCTION_ARGS)
 	{
 		int32_t	index;
 
-		index = findJsonbIndexFromObject((JsonbContainer *)json.value,
-										 key.value, key.length);
+		index = findJsonbIndexFromObjectCached(kcxt, (JsonbContainer *)json.value,
+											   key.value, key.length);
 		result->expr_ops = &xpu_bool_ops;
 		result->value = (index >= 0);
 	}
@@ -1043,7 +1085,7 @@ pgfn_jsonb_object_field_as_numeric(XPU_PGFUNCTION_ARGS)
 			char	   *base = (char *)(jc->children + 2 * count);
 			int32_t		index;
 
-			index = findJsonbIndexFromObject(jc, key.value, key.length);
+			index = findJsonbIndexFromObjectCached(kcxt, jc, key.value, key.length);
 			if (index >= 0 && index < count)
 			{
 				JEntry		entry;
@@ -1260,3 +1302,533 @@ JSONB_ARRAY_ELEMENT_AS_INT_TEMPLATE(int8, LONG_MIN, LONG_MAX)
 JSONB_ARRAY_ELEMENT_AS_FLOAT_TEMPLATE(float2, __to_fp16)
 JSONB_ARRAY_ELEMENT_AS_FLOAT_TEMPLATE(float4, __to_fp32)
 JSONB_ARRAY_ELEMENT_AS_FLOAT_TEMPLATE(float8, __to_fp64)
+
+/* ----------------------------------------------------------------
+ *
+ * jsonpath program (jsonb_path_exists / jsonb_path_match)
+ *
+ * ---------------------------------------------------------------- */
+#define KJSP_BOOL__FALSE		0
+#define KJSP_BOOL__TRUE			1
+#define KJSP_BOOL__UNKNOWN		2
+
+#define KJSP_EXEC__ERROR		(-1)
+#define KJSP_EXEC__CONTINUE		0
+#define KJSP_EXEC__STOP			1
+
+typedef struct
+{
+	int			kind;			/* one of KJSP_VALUE__* */
+	uint32_t	length;			/* length of the string */
+	const char *data;			/* string, numeric varlena or container */
+} kjsp_value;
+
+typedef struct
+{
+	const kern_jsonpath_item *cmp;	/* COMPARE item, or NULL for EXISTS */
+	bool		found;
+	bool		unknown;
+} kjsp_sink;
+
+#define KJSP_ITEMS(kexp)		((const kern_jsonpath_item *)(kexp)->u.jsonpath.data)
+
+STATIC_FUNCTION(bool)
+__jsonpath_value_from_entry(kern_context *kcxt,
+							kjsp_value *val,
+							JsonbContainer *jc,	/* may not be aligned */
+							uint32_t index, const char *base)
+{
+	JEntry		entry = __Fetch(&jc->children[index]);
+
+	if (JBE_ISNULL(entry))
+		val->kind = KJSP_VALUE__NULL;
+	else if (JBE_ISBOOL_TRUE(entry))
+		val->kind = KJSP_VALUE__TRUE;
+	else if (JBE_ISBOOL_FALSE(entry))
+		val->kind = KJSP_VALUE__FALSE;
+	else if (JBE_ISSTRING(entry))
+	{
+		val->kind   = KJSP_VALUE__STRING;
+		val->data   = base + getJsonbOffset(jc, index);
+		val->length = getJsonbLength(jc, index);
+	}
+	else if (JBE_ISNUMERIC(entry))
+	{
+		val->kind   = KJSP_VALUE__NUMERIC;
+		val->data   = base + INTALIGN(getJsonbOffset(jc, index));
+	}
+	else if (JBE_ISCONTAINER(entry))
+	{
+		JsonbContainer *sub = (JsonbContainer *)
+			(base + INTALIGN(getJsonbOffset(jc, index)));
+		uint32_t	jheader = __Fetch(&sub->header);
+
+		val->kind = (JsonContainerIsObject(jheader)
+					 ? KJSP_VALUE__OBJECT
+					 : KJSP_VALUE__ARRAY);
+		val->data = (const char *)sub;
+	}
+	else
+	{
+		STROM_ELOG(kcxt, "corrupted jsonb entry");
+		return false;
+	}
+	return true;
+}
+
+STATIC_FUNCTION(int)
+__jsonpath_compare_values(kern_context *kcxt,
+						  const kern_expression *kexp,
+						  const kern_jsonpath_item *cmp,
+						  const kjsp_value *val)
+{
+	const char *cdata = kexp->u.jsonpath.data + cmp->offset;
+	int			vkind = val->kind;
+	int			ckind = cmp->cmp_kind;
+	int			comp;
+
+	/* true and false are the same type */
+	if (vkind == KJSP_VALUE__FALSE)
+		vkind = KJSP_VALUE__TRUE;
+	if (ckind == KJSP_VALUE__FALSE)
+		ckind = KJSP_VALUE__TRUE;
+	if (vkind != ckind)
+	{
+		/* null and non-null are never equal, but not unknown */
+		if (vkind == KJSP_VALUE__NULL || ckind == KJSP_VALUE__NULL)
+			return (cmp->cmp_op == KJSP_CMP__NE
+					? KJSP_BOOL__TRUE
+					: KJSP_BOOL__FALSE);
+		return KJSP_BOOL__UNKNOWN;
+	}
+	switch (vkind)
+	{
+		case KJSP_VALUE__NULL:
+			comp = 0;
+			break;
+		case KJSP_VALUE__TRUE:
+			if (val->kind == cmp->cmp_kind)
+				comp = 0;
+			else
+				comp = (val->kind == KJSP_VALUE__TRUE ? 1 : -1);
+			break;
+		case KJSP_VALUE__NUMERIC:
+			{
+				xpu_numeric_t	a, b;
+				const char	   *emsg;
+
+				if ((emsg = __xpu_numeric_from_varlena(&a, (const varlena *)val->data)) != NULL ||
+					(emsg = __xpu_numeric_from_varlena(&b, (const varlena *)cdata)) != NULL)
+				{
+					STROM_ELOG(kcxt, emsg);
+					return -1;
+				}
+				a.expr_ops = &xpu_numeric_ops;
+				b.expr_ops = &xpu_numeric_ops;
+				if (!xpu_numeric_ops.xpu_datum_comp(kcxt, &comp,
+													(xpu_datum_t *)&a,
+													(xpu_datum_t *)&b))
+					return -1;
+			}
+			break;
+		case KJSP_VALUE__STRING:
+			/* binary comparison; see compareStrings() */
+			comp = __memcmp(val->data, cdata, Min(val->length, cmp->length));
+			if (comp == 0)
+				comp = (int)val->length - (int)cmp->length;
+			break;
+		default:
+			/* containers are not comparable */
+			return KJSP_BOOL__UNKNOWN;
+	}
+	if (cmp->cmp_swap)
+		comp = -comp;
+	switch (cmp->cmp_op)
+	{
+		case KJSP_CMP__EQ:
+			return (comp == 0 ? KJSP_BOOL__TRUE : KJSP_BOOL__FALSE);
+		case KJSP_CMP__NE:
+			return (comp != 0 ? KJSP_BOOL__TRUE : KJSP_BOOL__FALSE);
+		case KJSP_CMP__LT:
+			return (comp <  0 ? KJSP_BOOL__TRUE : KJSP_BOOL__FALSE);
+		case KJSP_CMP__LE:
+			return (comp <= 0 ? KJSP_BOOL__TRUE : KJSP_BOOL__FALSE);
+		case KJSP_CMP__GT:
+			return (comp >  0 ? KJSP_BOOL__TRUE : KJSP_BOOL__FALSE);
+		case KJSP_CMP__GE:
+			return (comp >= 0 ? KJSP_BOOL__TRUE : KJSP_BOOL__FALSE);
+		default:
+			break;
+	}
+	STROM_ELOG(kcxt, "unknown jsonpath comparison operator");
+	return -1;
+}
+
+STATIC_FUNCTION(int)
+__jsonpath_exec_sink(kern_context *kcxt,
+					 const kern_expression *kexp,
+					 const kjsp_value *val,
+					 kjsp_sink *sink)
+{
+	int			status;
+
+	if (!sink->cmp)
+	{
+		sink->found = true;
+		return KJSP_EXEC__STOP;
+	}
+	/* lax mode unwraps the array on comparison */
+	if (val->kind == KJSP_VALUE__ARRAY)
+	{
+		JsonbContainer *jc = (JsonbContainer *)val->data;
+		uint32_t	count = JsonContainerSize(__Fetch(&jc->header));
+		const char *base = (const char *)(jc->children + count);
+		kjsp_value	elem;
+
+		for (uint32_t i=0; i < count; i++)
+		{
+			if (!__jsonpath_value_from_entry(kcxt, &elem, jc, i, base))
+				return KJSP_EXEC__ERROR;
+			status = __jsonpath_compare_values(kcxt, kexp, sink->cmp, &elem);
+			if (status < 0)
+				return KJSP_EXEC__ERROR;
+			if (status == KJSP_BOOL__TRUE)
+			{
+				sink->found = true;
+				return KJSP_EXEC__STOP;
+			}
+			if (status == KJSP_BOOL__UNKNOWN)
+				sink->unknown = true;
+		}
+		return KJSP_EXEC__CONTINUE;
+	}
+	status = __jsonpath_compare_values(kcxt, kexp, sink->cmp, val);
+	if (status < 0)
+		return KJSP_EXEC__ERROR;
+	if (status == KJSP_BOOL__TRUE)
+	{
+		sink->found = true;
+		return KJSP_EXEC__STOP;
+	}
+	if (status == KJSP_BOOL__UNKNOWN)
+		sink->unknown = true;
+	return KJSP_EXEC__CONTINUE;
+}
+
+STATIC_FUNCTION(int)
+__jsonpath_exec_pred(kern_context *kcxt,
+					 const kern_expression *kexp,
+					 int index,
+					 const kjsp_value *curr,
+					 const kjsp_value *root);
+
+STATIC_FUNCTION(int)
+__jsonpath_exec_step(kern_context *kcxt,
+					 const kern_expression *kexp,
+					 int index,
+					 const kjsp_value *val,
+					 const kjsp_value *root,
+					 kjsp_sink *sink,
+					 bool unwrap)
+{
+	const kern_jsonpath_item *jpi;
+	JsonbContainer *jc;
+	uint32_t	count;
+	const char *base;
+	kjsp_value	elem;
+	int			status;
+
+	if (index < 0)
+		return __jsonpath_exec_sink(kcxt, kexp, val, sink);
+	jpi = &KJSP_ITEMS(kexp)[index];
+	/*
+	 * lax mode automatically unwraps the array for the accessors that
+	 * expect an object, and the filters.
+	 */
+	if (unwrap &&
+		val->kind == KJSP_VALUE__ARRAY &&
+		(jpi->type == KJSP_ITEM__KEY ||
+		 jpi->type == KJSP_ITEM__ANY_KEY ||
+		 jpi->type == KJSP_ITEM__FILTER))
+	{
+		jc = (JsonbContainer *)val->data;
+		count = JsonContainerSize(__Fetch(&jc->header));
+		base = (const char *)(jc->children + count);
+		for (uint32_t i=0; i < count; i++)
+		{
+			if (!__jsonpath_value_from_entry(kcxt, &elem, jc, i, base))
+				return KJSP_EXEC__ERROR;
+			status = __jsonpath_exec_step(kcxt, kexp, index,
+										  &elem, root, sink, false);
+			if (status != KJSP_EXEC__CONTINUE)
+				return status;
+		}
+		return KJSP_EXEC__CONTINUE;
+	}
+
+	switch (jpi->type)
+	{
+		case KJSP_ITEM__KEY:
+			if (val->kind == KJSP_VALUE__OBJECT)
+			{
+				int32_t		k;
+
+				jc = (JsonbContainer *)val->data;
+				count = JsonContainerSize(__Fetch(&jc->header));
+				base = (const char *)(jc->children + 2 * count);
+				k = findJsonbIndexFromObject(jc, kexp->u.jsonpath.data + jpi->offset,
+											 jpi->length);
+				if (k >= 0 && k < count)
+				{
+					if (!__jsonpath_value_from_entry(kcxt, &elem, jc, k + count, base))
+						return KJSP_EXEC__ERROR;
+					return __jsonpath_exec_step(kcxt, kexp, jpi->next,
+												&elem, root, sink, true);
+				}
+			}
+			/* structural errors are suppressed in lax mode */
+			return KJSP_EXEC__CONTINUE;
+
+		case KJSP_ITEM__ANY_KEY:
+			if (val->kind == KJSP_VALUE__OBJECT)
+			{
+				jc = (JsonbContainer *)val->data;
+				count = JsonContainerSize(__Fetch(&jc->header));
+				base = (const char *)(jc->children + 2 * count);
+				for (uint32_t i=0; i < count; i++)
+				{
+					if (!__jsonpath_value_from_entry(kcxt, &elem, jc, i + count, base))
+						return KJSP_EXEC__ERROR;
+					status = __jsonpath_exec_step(kcxt, kexp, jpi->next,
+												  &elem, root, sink, true);
+					if (status != KJSP_EXEC__CONTINUE)
+						return status;
+				}
+			}
+			return KJSP_EXEC__CONTINUE;
+
+		case KJSP_ITEM__ANY_ARRAY:
+			if (val->kind != KJSP_VALUE__ARRAY)
+			{
+				/* lax mode wraps the non-array item */
+				return __jsonpath_exec_step(kcxt, kexp, jpi->next,
+											val, root, sink, true);
+			}
+			jc = (JsonbContainer *)val->data;
+			count = JsonContainerSize(__Fetch(&jc->header));
+			base = (const char *)(jc->children + count);
+			for (uint32_t i=0; i < count; i++)
+			{
+				if (!__jsonpath_value_from_entry(kcxt, &elem, jc, i, base))
+					return KJSP_EXEC__ERROR;
+				status = __jsonpath_exec_step(kcxt, kexp, jpi->next,
+											  &elem, root, sink, true);
+				if (status != KJSP_EXEC__CONTINUE)
+					return status;
+			}
+			return KJSP_EXEC__CONTINUE;
+
+		case KJSP_ITEM__INDEX_ARRAY:
+			if (val->kind != KJSP_VALUE__ARRAY)
+			{
+				if (jpi->ival != 0)
+					return KJSP_EXEC__CONTINUE;
+				return __jsonpath_exec_step(kcxt, kexp, jpi->next,
+											val, root, sink, true);
+			}
+			jc = (JsonbContainer *)val->data;
+			count = JsonContainerSize(__Fetch(&jc->header));
+			base = (const char *)(jc->children + count);
+			if (jpi->ival < 0 || jpi->ival >= count)
+				return KJSP_EXEC__CONTINUE;
+			if (!__jsonpath_value_from_entry(kcxt, &elem, jc, jpi->ival, base))
+				return KJSP_EXEC__ERROR;
+			return __jsonpath_exec_step(kcxt, kexp, jpi->next,
+										&elem, root, sink, true);
+
+		case KJSP_ITEM__FILTER:
+			status = __jsonpath_exec_pred(kcxt, kexp, jpi->arg1, val, root);
+			if (status < 0)
+				return KJSP_EXEC__ERROR;
+			if (status != KJSP_BOOL__TRUE)
+				return KJSP_EXEC__CONTINUE;
+			return __jsonpath_exec_step(kcxt, kexp, jpi->next,
+										val, root, sink, true);
+
+		default:
+			break;
+	}
+	STROM_ELOG(kcxt, "unexpected jsonpath accessor");
+	return KJSP_EXEC__ERROR;
+}
+
+/*
+ * __jsonpath_exec_path - runs the path that begins with $ or @
+ */
+STATIC_FUNCTION(int)
+__jsonpath_exec_path(kern_context *kcxt,
+					 const kern_expression *kexp,
+					 int index,
+					 const kjsp_value *curr,
+					 const kjsp_value *root,
+					 kjsp_sink *sink)
+{
+	const kern_jsonpath_item *jpi = &KJSP_ITEMS(kexp)[index];
+
+	if (jpi->type == KJSP_ITEM__ROOT)
+		return __jsonpath_exec_step(kcxt, kexp, jpi->next, root, root, sink, true);
+	if (jpi->type == KJSP_ITEM__CURRENT && curr)
+		return __jsonpath_exec_step(kcxt, kexp, jpi->next, curr, root, sink, true);
+	STROM_ELOG(kcxt, "unexpected jsonpath head");
+	return KJSP_EXEC__ERROR;
+}
+
+/*
+ * __jsonpath_exec_pred - returns one of KJSP_BOOL__*, or -1 on errors
+ */
+STATIC_FUNCTION(int)
+__jsonpath_exec_pred(kern_context *kcxt,
+					 const kern_expression *kexp,
+					 int index,
+					 const kjsp_value *curr,
+					 const kjsp_value *root)
+{
+	const kern_jsonpath_item *jpi = &KJSP_ITEMS(kexp)[index];
+	kjsp_sink	sink;
+	int			lval, rval;
+
+	switch (jpi->type)
+	{
+		case KJSP_ITEM__COMPARE:
+		case KJSP_ITEM__EXISTS:
+			sink.cmp = (jpi->type == KJSP_ITEM__COMPARE ? jpi : NULL);
+			sink.found = false;
+			sink.unknown = false;
+			if (__jsonpath_exec_path(kcxt, kexp, jpi->arg1,
+									 curr, root, &sink) < 0)
+				return -1;
+			if (sink.found)
+				return KJSP_BOOL__TRUE;
+			return (sink.unknown ? KJSP_BOOL__UNKNOWN : KJSP_BOOL__FALSE);
+
+		case KJSP_ITEM__AND:
+			lval = __jsonpath_exec_pred(kcxt, kexp, jpi->arg1, curr, root);
+			if (lval < 0 || lval == KJSP_BOOL__FALSE)
+				return lval;
+			rval = __jsonpath_exec_pred(kcxt, kexp, jpi->arg2, curr, root);
+			if (rval < 0 || rval == KJSP_BOOL__FALSE)
+				return rval;
+			return (lval == KJSP_BOOL__TRUE && rval == KJSP_BOOL__TRUE
+					? KJSP_BOOL__TRUE
+					: KJSP_BOOL__UNKNOWN);
+
+		case KJSP_ITEM__OR:
+			lval = __jsonpath_exec_pred(kcxt, kexp, jpi->arg1, curr, root);
+			if (lval < 0 || lval == KJSP_BOOL__TRUE)
+				return lval;
+			rval = __jsonpath_exec_pred(kcxt, kexp, jpi->arg2, curr, root);
+			if (rval < 0 || rval == KJSP_BOOL__TRUE)
+				return rval;
+			return (lval == KJSP_BOOL__FALSE && rval == KJSP_BOOL__FALSE
+					? KJSP_BOOL__FALSE
+					: KJSP_BOOL__UNKNOWN);
+
+		case KJSP_ITEM__NOT:
+			lval = __jsonpath_exec_pred(kcxt, kexp, jpi->arg1, curr, root);
+			if (lval == KJSP_BOOL__TRUE)
+				return KJSP_BOOL__FALSE;
+			if (lval == KJSP_BOOL__FALSE)
+				return KJSP_BOOL__TRUE;
+			return lval;
+
+		case KJSP_ITEM__IS_UNKNOWN:
+			lval = __jsonpath_exec_pred(kcxt, kexp, jpi->arg1, curr, root);
+			if (lval < 0)
+				return lval;
+			return (lval == KJSP_BOOL__UNKNOWN
+					? KJSP_BOOL__TRUE
+					: KJSP_BOOL__FALSE);
+
+		default:
+			break;
+	}
+	STROM_ELOG(kcxt, "unexpected jsonpath predicate");
+	return -1;
+}
+
+/*
+ * __jsonpath_root_value - the root jsonb container as jsonpath value
+ */
+STATIC_FUNCTION(bool)
+__jsonpath_root_value(kern_context *kcxt, kjsp_value *root,
+					  const xpu_jsonb_t *json)
+{
+	JsonbContainer *jc = (JsonbContainer *)json->value;
+	uint32_t	jheader = __Fetch(&jc->header);
+
+	if (JsonContainerIsScalar(jheader))
+		return __jsonpath_value_from_entry(kcxt, root, jc, 0,
+										   (const char *)(jc->children + 1));
+	root->kind = (JsonContainerIsObject(jheader)
+				  ? KJSP_VALUE__OBJECT
+				  : KJSP_VALUE__ARRAY);
+	root->data = (const char *)jc;
+	return true;
+}
+
+PUBLIC_FUNCTION(bool)
+pgfn_jsonb_path_exists_prog(XPU_PGFUNCTION_ARGS)
+{
+	KEXP_PROCESS_ARGS1(bool, jsonb, json);	/* jsonpath is in program */
+
+	if (XPU_DATUM_ISNULL(&json))
+		result->expr_ops = NULL;
+	else
+	{
+		kjsp_value	root;
+		kjsp_sink	sink;
+
+		if (!xpu_jsonb_is_valid(kcxt, &json) ||
+			!__jsonpath_root_value(kcxt, &root, &json))
+			return false;
+		sink.cmp = NULL;
+		sink.found = false;
+		sink.unknown = false;
+		if (__jsonpath_exec_path(kcxt, kexp, kexp->u.jsonpath.top,
+								 NULL, &root, &sink) < 0)
+			return false;
+		result->expr_ops = &xpu_bool_ops;
+		result->value = sink.found;
+	}
+	return true;
+}
+
+PUBLIC_FUNCTION(bool)
+pgfn_jsonb_path_match_prog(XPU_PGFUNCTION_ARGS)
+{
+	KEXP_PROCESS_ARGS1(bool, jsonb, json);	/* jsonpath is in program */
+
+	if (XPU_DATUM_ISNULL(&json))
+		result->expr_ops = NULL;
+	else
+	{
+		kjsp_value	root;
+		int			status;
+
+		if (!xpu_jsonb_is_valid(kcxt, &json) ||
+			!__jsonpath_root_value(kcxt, &root, &json))
+			return false;
+		status = __jsonpath_exec_pred(kcxt, kexp, kexp->u.jsonpath.top,
+									  NULL, &root);
+		if (status < 0)
+			return false;
+		if (status == KJSP_BOOL__UNKNOWN)
+			result->expr_ops = NULL;
+		else
+		{
+			result->expr_ops = &xpu_bool_ops;
+			result->value = (status == KJSP_BOOL__TRUE);
+		}
+	}
+	return true;
+}
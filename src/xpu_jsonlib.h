@@ -16,4 +16,62 @@
 
 PGSTROM_SQLTYPE_VARLENA_DECLARATION(jsonb);
 
+/*
+ * jsonpath program
+ *
+ * A constant jsonpath (lax mode only) is compiled to an array of
+ * kern_jsonpath_item by the backend, then embedded to the kern_expression.
+ * It supports a subset of the SQL/JSON path language; accessors (.key, .*,
+ * [*] and [N]), filters, comparisons between a path and a constant, and
+ * the logical operators. Constants (key names, strings and numerics) are
+ * stored next to the items, and referenced by the offset from the data[].
+ */
+#define KJSP_ITEM__ROOT				1	/* $ */
+#define KJSP_ITEM__CURRENT			2	/* @ */
+#define KJSP_ITEM__KEY				3	/* .key */
+#define KJSP_ITEM__ANY_KEY			4	/* .* */
+#define KJSP_ITEM__ANY_ARRAY		5	/* [*] */
+#define KJSP_ITEM__INDEX_ARRAY		6	/* [N] */
+#define KJSP_ITEM__FILTER			7	/* ? (predicate) */
+#define KJSP_ITEM__COMPARE			8	/* path OP constant */
+#define KJSP_ITEM__AND				9	/* predicate && predicate */
+#define KJSP_ITEM__OR				10	/* predicate || predicate */
+#define KJSP_ITEM__NOT				11	/* !(predicate) */
+#define KJSP_ITEM__IS_UNKNOWN		12	/* (predicate) is unknown */
+#define KJSP_ITEM__EXISTS			13	/* exists (path) */
+
+#define KJSP_CMP__EQ				1
+#define KJSP_CMP__NE				2
+#define KJSP_CMP__LT				3
+#define KJSP_CMP__LE				4
+#define KJSP_CMP__GT				5
+#define KJSP_CMP__GE				6
+
+#define KJSP_VALUE__NULL			1
+#define KJSP_VALUE__TRUE			2
+#define KJSP_VALUE__FALSE			3
+#define KJSP_VALUE__NUMERIC			4
+#define KJSP_VALUE__STRING			5
+#define KJSP_VALUE__OBJECT			6
+#define KJSP_VALUE__ARRAY			7
+
+#define KJSP_MAX_ITEMS				64
+
+typedef struct
+{
+	uint8_t		type;			/* one of KJSP_ITEM__* */
+	uint8_t		cmp_op;			/* COMPARE: one of KJSP_CMP__* */
+	uint8_t		cmp_swap;		/* COMPARE: true, if constant is left */
+	uint8_t		cmp_kind;		/* COMPARE: KJSP_VALUE__* of the constant */
+	int16_t		next;			/* next accessor of the path, or -1 */
+	int16_t		arg1;			/* FILTER, NOT, IS_UNKNOWN: predicate
+								 * AND, OR: left predicate
+								 * COMPARE, EXISTS: path */
+	int16_t		arg2;			/* AND, OR: right predicate */
+	int16_t		__padding;
+	int32_t		ival;			/* INDEX_ARRAY: subscript */
+	uint32_t	offset;			/* KEY, COMPARE: offset of the constant */
+	uint32_t	length;			/* KEY, COMPARE: length of the constant */
+} kern_jsonpath_item;
+
 #endif	/* XPU_JSONLIB_H */
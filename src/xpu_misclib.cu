@@ -524,6 +524,251 @@ pgfn_tan(XPU_PGFUNCTION_ARGS)
 	return true;
 }
 
+/*
+ * float vector (float2[] / float4[]) distance functions
+ *
+ * Elements of float2[] and float4[] are packed on both of the heap array
+ * (fixed-length and no nullmap) and Arrow::List<FloatingPoint>, so we walk
+ * on the values directly. float2 values are loaded by __half2 pairs, and
+ * all the values are accumulated in fp32.
+ */
+#define FLOAT_VECTOR__DOT_PRODUCT		1
+#define FLOAT_VECTOR__L2_DISTANCE		2
+#define FLOAT_VECTOR__COSINE_DISTANCE	3
+
+STATIC_FUNCTION(bool)
+__float_vector_fetch(kern_context *kcxt,
+					 const xpu_array_t *aval,
+					 bool is_half,
+					 const void **p_values,
+					 int32_t *p_nitems)
+{
+	uint32_t	unitsz = (is_half ? sizeof(float2_t) : sizeof(float4_t));
+
+	if (aval->length < 0)
+	{
+		const __ArrayTypeData *ar = (const __ArrayTypeData *)
+			VARDATA_ANY(aval->u.heap.value);
+		int32_t		ndim = __pg_array_ndim(ar);
+		int32_t		nitems = 0;
+
+		if (ndim > 0)
+		{
+			nitems = __pg_array_dim(ar, 0);
+			for (int k=1; k < ndim; k++)
+				nitems *= __pg_array_dim(ar, k);
+		}
+		if (__pg_array_hasnull(ar))
+		{
+			STROM_ELOG(kcxt, "float vector must not contain nulls");
+			return false;
+		}
+		*p_values = __pg_array_dataptr(ar);
+		*p_nitems = nitems;
+	}
+	else
+	{
+		const kern_colmeta *cmeta = aval->u.arrow.cmeta;
+		const kern_data_store *kds = (const kern_data_store *)
+			((const char *)cmeta - cmeta->kds_offset);
+		const kern_colmeta *smeta = &kds->colmeta[cmeta->idx_subattrs];
+		uint32_t	start = aval->u.arrow.start;
+		uint32_t	nitems = aval->length;
+
+		if (smeta->attopts.tag != ArrowType__FloatingPoint ||
+			smeta->attopts.floating_point.precision != (is_half
+														? ArrowPrecision__Half
+														: ArrowPrecision__Single))
+		{
+			STROM_ELOG(kcxt, "float vector must be mapped on Arrow::List<FloatingPoint>");
+			return false;
+		}
+		if (smeta->nullmap_offset)
+		{
+			for (uint32_t i=0; i < nitems; i++)
+			{
+				if (KDS_ARROW_CHECK_ISNULL(kds, smeta, start + i))
+				{
+					STROM_ELOG(kcxt, "float vector must not contain nulls");
+					return false;
+				}
+			}
+		}
+		*p_values = NULL;
+		if (nitems > 0)
+		{
+			if (!KDS_ARROW_REF_SIMPLE_DATUM(kds, smeta, start + nitems - 1,
+											unitsz))
+			{
+				STROM_ELOG(kcxt, "Arrow::List<FloatingPoint> out of range");
+				return false;
+			}
+			*p_values = KDS_ARROW_REF_SIMPLE_DATUM(kds, smeta, start, unitsz);
+		}
+		*p_nitems = nitems;
+	}
+	return true;
+}
+
+INLINE_FUNCTION(float)
+__float2_vector_kernel(const float2_t *x, const float2_t *y, int32_t nitems,
+					   int mode, float *p_xx, float *p_yy)
+{
+	float		sum = 0.0;
+	float		xx = 0.0;
+	float		yy = 0.0;
+	int32_t		i = 0;
+
+#ifdef __CUDACC__
+	/* __half2 pair loads, if both vectors are aligned to 4 bytes */
+	if ((((uintptr_t)x | (uintptr_t)y) & 3) == 0)
+	{
+		const __half2  *x2 = (const __half2 *)x;
+		const __half2  *y2 = (const __half2 *)y;
+
+		for (; i + 1 < nitems; i += 2)
+		{
+			float2		fx = __half22float2(x2[i>>1]);
+			float2		fy = __half22float2(y2[i>>1]);
+
+			if (mode == FLOAT_VECTOR__L2_DISTANCE)
+			{
+				float	dx = fx.x - fy.x;
+				float	dy = fx.y - fy.y;
+
+				sum = fmaf(dx, dx, sum);
+				sum = fmaf(dy, dy, sum);
+			}
+			else
+			{
+				sum = fmaf(fx.x, fy.x, sum);
+				sum = fmaf(fx.y, fy.y, sum);
+				if (mode == FLOAT_VECTOR__COSINE_DISTANCE)
+				{
+					xx = fmaf(fx.x, fx.x, xx);
+					xx = fmaf(fx.y, fx.y, xx);
+					yy = fmaf(fy.x, fy.x, yy);
+					yy = fmaf(fy.y, fy.y, yy);
+				}
+			}
+		}
+	}
+#endif
+	for (; i < nitems; i++)
+	{
+		float	fx = fp16_to_fp32(x[i]);
+		float	fy = fp16_to_fp32(y[i]);
+
+		if (mode == FLOAT_VECTOR__L2_DISTANCE)
+			sum += (fx - fy) * (fx - fy);
+		else
+		{
+			sum += fx * fy;
+			if (mode == FLOAT_VECTOR__COSINE_DISTANCE)
+			{
+				xx += fx * fx;
+				yy += fy * fy;
+			}
+		}
+	}
+	*p_xx = xx;
+	*p_yy = yy;
+	return sum;
+}
+
+INLINE_FUNCTION(float)
+__float4_vector_kernel(const float4_t *x, const float4_t *y, int32_t nitems,
+					   int mode, float *p_xx, float *p_yy)
+{
+	float		sum = 0.0;
+	float		xx = 0.0;
+	float		yy = 0.0;
+
+	for (int32_t i=0; i < nitems; i++)
+	{
+		float	fx = __Fetch(x + i);
+		float	fy = __Fetch(y + i);
+
+		if (mode == FLOAT_VECTOR__L2_DISTANCE)
+			sum = fmaf(fx - fy, fx - fy, sum);
+		else
+		{
+			sum = fmaf(fx, fy, sum);
+			if (mode == FLOAT_VECTOR__COSINE_DISTANCE)
+			{
+				xx = fmaf(fx, fx, xx);
+				yy = fmaf(fy, fy, yy);
+			}
+		}
+	}
+	*p_xx = xx;
+	*p_yy = yy;
+	return sum;
+}
+
+STATIC_FUNCTION(bool)
+__pgfn_float_vector_common(XPU_PGFUNCTION_ARGS, bool is_half, int mode)
+{
+	KEXP_PROCESS_ARGS2(float4, array, aval, array, bval);
+
+	if (XPU_DATUM_ISNULL(&aval) || XPU_DATUM_ISNULL(&bval))
+		result->expr_ops = NULL;
+	else
+	{
+		const void *x, *y;
+		int32_t		x_nitems, y_nitems;
+		float		sum, xx, yy;
+
+		if (!__float_vector_fetch(kcxt, &aval, is_half, &x, &x_nitems) ||
+			!__float_vector_fetch(kcxt, &bval, is_half, &y, &y_nitems))
+			return false;
+		if (x_nitems != y_nitems)
+		{
+			STROM_ELOG(kcxt, "different float vector dimensions");
+			return false;
+		}
+		if (is_half)
+			sum = __float2_vector_kernel((const float2_t *)x,
+										 (const float2_t *)y,
+										 x_nitems, mode, &xx, &yy);
+		else
+			sum = __float4_vector_kernel((const float4_t *)x,
+										 (const float4_t *)y,
+										 x_nitems, mode, &xx, &yy);
+		result->expr_ops = &xpu_float4_ops;
+		if (mode == FLOAT_VECTOR__L2_DISTANCE)
+			result->value = sqrtf(sum);
+		else if (mode == FLOAT_VECTOR__COSINE_DISTANCE)
+		{
+			float	cosine = sum / sqrtf(xx * yy);
+
+			/* keep in range, for rounding errors */
+			if (cosine > 1.0)
+				cosine = 1.0;
+			else if (cosine < -1.0)
+				cosine = -1.0;
+			result->value = 1.0 - cosine;
+		}
+		else
+			result->value = sum;
+	}
+	return true;
+}
+
+#define PG_FLOAT_VECTOR_TEMPLATE(NAME,IS_HALF,MODE)						\
+	PUBLIC_FUNCTION(bool)												\
+	pgfn_##NAME(XPU_PGFUNCTION_ARGS)									\
+	{																	\
+		return __pgfn_float_vector_common(kcxt, kexp, __result,		\
+										  IS_HALF, MODE);				\
+	}
+PG_FLOAT_VECTOR_TEMPLATE(float2_dot_product,     true, FLOAT_VECTOR__DOT_PRODUCT)
+PG_FLOAT_VECTOR_TEMPLATE(float2_l2_distance,     true, FLOAT_VECTOR__L2_DISTANCE)
+PG_FLOAT_VECTOR_TEMPLATE(float2_cosine_distance, true, FLOAT_VECTOR__COSINE_DISTANCE)
+PG_FLOAT_VECTOR_TEMPLATE(float4_dot_product,     false, FLOAT_VECTOR__DOT_PRODUCT)
+PG_FLOAT_VECTOR_TEMPLATE(float4_l2_distance,     false, FLOAT_VECTOR__L2_DISTANCE)
+PG_FLOAT_VECTOR_TEMPLATE(float4_cosine_distance, false, FLOAT_VECTOR__COSINE_DISTANCE)
+
 /*
  * Currency data type (xpu_money_t), functions and operators
  */
@@ -864,6 +1109,76 @@ PG_UUID_COMPARE_TEMPLATE(le, <=)
 PG_UUID_COMPARE_TEMPLATE(gt, > )
 PG_UUID_COMPARE_TEMPLATE(ge, >=)
 
+/*
+ * CoerceViaIO from text to uuid; identical to the uuid_in(), a pair of
+ * hexadecimal digits builds a byte, and an optional hyphen can follow any
+ * group of four hex digits. The entire string can be enclosed by braces.
+ * Any other form is processed by the CPU-fallback.
+ */
+INLINE_FUNCTION(int)
+__uuid_hexval(char c)
+{
+	if (c >= '0' && c <= '9')
+		return c - '0';
+	if (c >= 'a' && c <= 'f')
+		return c - 'a' + 10;
+	if (c >= 'A' && c <= 'F')
+		return c - 'A' + 10;
+	return -1;
+}
+
+PUBLIC_FUNCTION(bool)
+pgfn_text_to_uuid(XPU_PGFUNCTION_ARGS)
+{
+	KEXP_PROCESS_ARGS1(uuid, text, str);
+
+	if (XPU_DATUM_ISNULL(&str))
+		result->expr_ops = NULL;
+	else
+	{
+		const char *pos;
+		const char *end;
+		bool		braces = false;
+
+		if (!xpu_text_is_valid(kcxt, &str))
+			return false;
+		pos = str.value;
+		end = str.value + str.length;
+		if (pos < end && *pos == '{')
+		{
+			braces = true;
+			pos++;
+		}
+		for (int i=0; i < UUID_LEN; i++)
+		{
+			int		hi, lo;
+
+			if (end - pos < 2 ||
+				(hi = __uuid_hexval(pos[0])) < 0 ||
+				(lo = __uuid_hexval(pos[1])) < 0)
+				goto fallback;
+			result->value.data[i] = (hi << 4) | lo;
+			pos += 2;
+			if (pos < end && *pos == '-' && (i % 2) == 1 && i < UUID_LEN - 1)
+				pos++;
+		}
+		if (braces)
+		{
+			if (pos >= end || *pos != '}')
+				goto fallback;
+			pos++;
+		}
+		if (pos != end)
+			goto fallback;
+		result->expr_ops = &xpu_uuid_ops;
+	}
+	return true;
+
+fallback:
+	STROM_CPU_FALLBACK(kcxt, "text is not a simple uuid representation");
+	return false;
+}
+
 /*
  * Macaddr data type (xpu_macaddr_t), functions and operators
  */
@@ -1330,10 +1645,10 @@ inet_cmp_internal(const xpu_inet_t *datum_a,
 		order = bitncmp(datum_a->value.ipaddr,
 						datum_b->value.ipaddr,
 						Min(datum_a->value.bits,
-							datum_a->value.bits));
+							datum_b->value.bits));
 		if (order != 0)
 			return order;
-		order = (int)datum_a->value.bits - (int)datum_a->value.bits;
+		order = (int)datum_a->value.bits - (int)datum_b->value.bits;
 		if (order != 0)
 			return order;
 		return bitncmp(datum_a->value.ipaddr,
@@ -1394,7 +1709,13 @@ PG_NETWORK_COMPARE_TEMPLATE(le, <=)
 PG_NETWORK_COMPARE_TEMPLATE(gt, > )
 PG_NETWORK_COMPARE_TEMPLATE(ge, >=)
 
-#define PG_NETWORK_SUBSUP_TEMPLATE(NAME,OPER)							\
+/*
+ * a << b  : a.bits >  b.bits, and a is within the network of b
+ * a <<= b : a.bits >= b.bits, and a is within the network of b
+ * a >> b  : a.bits <  b.bits, and b is within the network of a
+ * a >>= b : a.bits <= b.bits, and b is within the network of a
+ */
+#define PG_NETWORK_SUBSUP_TEMPLATE(NAME,OPER,NET)						\
 	PUBLIC_FUNCTION(bool)												\
 	pgfn_network_##NAME(XPU_PGFUNCTION_ARGS)							\
 	{																	\
@@ -1421,7 +1742,7 @@ PG_NETWORK_COMPARE_TEMPLATE(ge, >=)
 			result->expr_ops = &xpu_bool_ops;							\
 			result->value = (bitncmp(datum_a.value.ipaddr,				\
 									 datum_b.value.ipaddr,				\
-									 datum_a.value.bits) == 0);			\
+									 datum_##NET.value.bits) == 0);		\
 		}																\
 		else															\
 		{																\
@@ -1431,10 +1752,10 @@ PG_NETWORK_COMPARE_TEMPLATE(ge, >=)
 		return true;													\
 	}
 
-PG_NETWORK_SUBSUP_TEMPLATE(sub, <)
-PG_NETWORK_SUBSUP_TEMPLATE(subeq, <=)
-PG_NETWORK_SUBSUP_TEMPLATE(sup, >)
-PG_NETWORK_SUBSUP_TEMPLATE(supeq, >=)
+PG_NETWORK_SUBSUP_TEMPLATE(sub,   >,  b)
+PG_NETWORK_SUBSUP_TEMPLATE(subeq, >=, b)
+PG_NETWORK_SUBSUP_TEMPLATE(sup,   <,  a)
+PG_NETWORK_SUBSUP_TEMPLATE(supeq, <=, a)
 
 PUBLIC_FUNCTION(bool)
 pgfn_network_overlap(XPU_PGFUNCTION_ARGS)
@@ -1472,6 +1793,424 @@ pgfn_network_overlap(XPU_PGFUNCTION_ARGS)
 	return true;
 }
 
+/*
+ * Network functions
+ */
+#define __INET_MAXBITS(ip)		((ip)->family == PGSQL_AF_INET ? 32 : 128)
+#define __INET_ADDRSIZE(ip)		((ip)->family == PGSQL_AF_INET ? 4 : 16)
+
+INLINE_FUNCTION(uint8_t)
+__inet_netmask_byte(const inet_struct *ip, int i)
+{
+	int		nbits = (int)ip->bits - 8 * i;
+
+	if (nbits >= 8)
+		return 0xff;
+	if (nbits <= 0)
+		return 0x00;
+	return (uint8_t)(0xff << (8 - nbits));
+}
+
+#define PG_NETWORK_INT4_TEMPLATE(NAME,EXPR)								\
+	PUBLIC_FUNCTION(bool)												\
+	pgfn_network_##NAME(XPU_PGFUNCTION_ARGS)							\
+	{																	\
+		xpu_int4_t *result = (xpu_int4_t *)__result;					\
+		xpu_inet_t	datum;												\
+		const kern_expression *karg = KEXP_FIRST_ARG(kexp);				\
+																		\
+		assert(kexp->nr_args == 1 && KEXP_IS_VALID(karg, inet));		\
+		if (!EXEC_KERN_EXPRESSION(kcxt, karg, &datum))					\
+			return false;												\
+		if (XPU_DATUM_ISNULL(&datum))									\
+			result->expr_ops = NULL;									\
+		else															\
+		{																\
+			result->expr_ops = &xpu_int4_ops;							\
+			result->value = (EXPR);										\
+		}																\
+		return true;													\
+	}
+PG_NETWORK_INT4_TEMPLATE(masklen, datum.value.bits)
+PG_NETWORK_INT4_TEMPLATE(family, (datum.value.family == PGSQL_AF_INET ? 4 : 6))
+
+/*
+ * network(), broadcast(), netmask(), hostmask() and '~' (inetnot)
+ * build a new address from the netmask bits of the argument.
+ */
+#define PG_NETWORK_MASK_TEMPLATE(FNAME,BITS,BYTE_EXPR)					\
+	PUBLIC_FUNCTION(bool)												\
+	pgfn_##FNAME(XPU_PGFUNCTION_ARGS)									\
+	{																	\
+		xpu_inet_t *result = (xpu_inet_t *)__result;					\
+		xpu_inet_t	datum;												\
+		const kern_expression *karg = KEXP_FIRST_ARG(kexp);				\
+																		\
+		assert(kexp->nr_args == 1 && KEXP_IS_VALID(karg, inet));		\
+		if (!EXEC_KERN_EXPRESSION(kcxt, karg, &datum))					\
+			return false;												\
+		if (XPU_DATUM_ISNULL(&datum))									\
+			result->expr_ops = NULL;									\
+		else															\
+		{																\
+			const inet_struct *ip = &datum.value;						\
+			int		nb = __INET_ADDRSIZE(ip);							\
+																		\
+			memset(&result->value, 0, sizeof(inet_struct));				\
+			result->expr_ops = &xpu_inet_ops;							\
+			result->value.family = ip->family;							\
+			result->value.bits = (BITS);								\
+			for (int i=0; i < nb; i++)									\
+			{															\
+				uint8_t	mask = __inet_netmask_byte(ip, i);				\
+																		\
+				result->value.ipaddr[i] = (uint8_t)(BYTE_EXPR);			\
+			}															\
+		}																\
+		return true;													\
+	}
+PG_NETWORK_MASK_TEMPLATE(network_network,   ip->bits, ip->ipaddr[i] & mask)
+PG_NETWORK_MASK_TEMPLATE(network_broadcast, ip->bits, ip->ipaddr[i] | ~mask)
+PG_NETWORK_MASK_TEMPLATE(network_netmask,   __INET_MAXBITS(ip), mask)
+PG_NETWORK_MASK_TEMPLATE(network_hostmask,  __INET_MAXBITS(ip), ~mask)
+PG_NETWORK_MASK_TEMPLATE(inetnot,           ip->bits, ~ip->ipaddr[i])
+
+/*
+ * host() and text() - see inet_net_ntop() in utils/adt/inet_net_ntop.c
+ */
+INLINE_FUNCTION(char *)
+__inet_print_uint(char *pos, unsigned int ival, int base)
+{
+	char	temp[8];
+	int		n = 0;
+
+	do {
+		temp[n++] = "0123456789abcdef"[ival % base];
+		ival /= base;
+	} while (ival > 0);
+	while (n > 0)
+		*pos++ = temp[--n];
+	return pos;
+}
+
+INLINE_FUNCTION(char *)
+__inet_print_ipv4(char *pos, const uint8_t *addr)
+{
+	for (int i=0; i < 4; i++)
+	{
+		if (i > 0)
+			*pos++ = '.';
+		pos = __inet_print_uint(pos, addr[i], 10);
+	}
+	return pos;
+}
+
+STATIC_FUNCTION(int)
+__inet_to_cstring(char *buf, const inet_struct *ip, bool with_bits)
+{
+	char   *pos = buf;
+
+	if (ip->family == PGSQL_AF_INET)
+		pos = __inet_print_ipv4(pos, ip->ipaddr);
+	else
+	{
+		uint16_t words[8];
+		int		best_base = -1, best_len = 0;
+		int		cur_base = -1, cur_len = 0;
+
+		/* find the longest run of 0x00's for "::" shorthanding */
+		for (int i=0; i < 8; i++)
+		{
+			words[i] = ((uint16_t)ip->ipaddr[2*i] << 8) | ip->ipaddr[2*i+1];
+			if (words[i] == 0)
+			{
+				if (cur_base < 0)
+				{
+					cur_base = i;
+					cur_len = 1;
+				}
+				else
+					cur_len++;
+			}
+			else if (cur_base >= 0)
+			{
+				if (best_base < 0 || cur_len > best_len)
+				{
+					best_base = cur_base;
+					best_len = cur_len;
+				}
+				cur_base = -1;
+			}
+		}
+		if (cur_base >= 0 && (best_base < 0 || cur_len > best_len))
+		{
+			best_base = cur_base;
+			best_len = cur_len;
+		}
+		if (best_base >= 0 && best_len < 2)
+			best_base = -1;
+
+		for (int i=0; i < 8; i++)
+		{
+			/* inside of the best run of 0x00's? */
+			if (best_base >= 0 && i >= best_base && i < best_base + best_len)
+			{
+				if (i == best_base)
+					*pos++ = ':';
+				continue;
+			}
+			if (i != 0)
+				*pos++ = ':';
+			/* encapsulated IPv4? */
+			if (i == 6 && best_base == 0 &&
+				(best_len == 6 ||
+				 (best_len == 7 && words[7] != 0x0001) ||
+				 (best_len == 5 && words[5] == 0xffff)))
+			{
+				pos = __inet_print_ipv4(pos, ip->ipaddr + 12);
+				break;
+			}
+			pos = __inet_print_uint(pos, words[i], 16);
+		}
+		if (best_base >= 0 && best_base + best_len == 8)
+			*pos++ = ':';
+	}
+	if (with_bits)
+	{
+		*pos++ = '/';
+		pos = __inet_print_uint(pos, ip->bits, 10);
+	}
+	return (int)(pos - buf);
+}
+
+#define PG_NETWORK_TEXT_TEMPLATE(NAME,WITH_BITS)						\
+	PUBLIC_FUNCTION(bool)												\
+	pgfn_network_##NAME(XPU_PGFUNCTION_ARGS)							\
+	{																	\
+		xpu_text_t *result = (xpu_text_t *)__result;					\
+		xpu_inet_t	datum;												\
+		const kern_expression *karg = KEXP_FIRST_ARG(kexp);				\
+																		\
+		assert(kexp->nr_args == 1 && KEXP_IS_VALID(karg, inet));		\
+		if (!EXEC_KERN_EXPRESSION(kcxt, karg, &datum))					\
+			return false;												\
+		if (XPU_DATUM_ISNULL(&datum))									\
+			result->expr_ops = NULL;									\
+		else															\
+		{																\
+			char	temp[64];											\
+			char   *buf;												\
+			int		len;												\
+																		\
+			len = __inet_to_cstring(temp, &datum.value, WITH_BITS);		\
+			buf = __text_result_alloc(kcxt, len);						\
+			if (!buf)													\
+				return false;											\
+			memcpy(buf, temp, len);										\
+			result->expr_ops = &xpu_text_ops;							\
+			result->length = len;										\
+			result->value = buf;										\
+		}																\
+		return true;													\
+	}
+PG_NETWORK_TEXT_TEMPLATE(host, false)
+PG_NETWORK_TEXT_TEMPLATE(show, true)
+
+PUBLIC_FUNCTION(bool)
+pgfn_inet_same_family(XPU_PGFUNCTION_ARGS)
+{
+	xpu_bool_t *result = (xpu_bool_t *)__result;
+	xpu_inet_t	datum_a;
+	xpu_inet_t	datum_b;
+	const kern_expression *karg = KEXP_FIRST_ARG(kexp);
+
+	assert(kexp->nr_args == 2 && KEXP_IS_VALID(karg, inet));
+	if (!EXEC_KERN_EXPRESSION(kcxt, karg, &datum_a))
+		return false;
+	karg = KEXP_NEXT_ARG(karg);
+	assert(KEXP_IS_VALID(karg, inet));
+	if (!EXEC_KERN_EXPRESSION(kcxt, karg, &datum_b))
+		return false;
+
+	if (XPU_DATUM_ISNULL(&datum_a) || XPU_DATUM_ISNULL(&datum_b))
+		result->expr_ops = NULL;
+	else
+	{
+		result->expr_ops = &xpu_bool_ops;
+		result->value = (datum_a.value.family == datum_b.value.family);
+	}
+	return true;
+}
+
+/*
+ * '&' (inetand) and '|' (inetor)
+ */
+#define PG_NETWORK_BITWISE_TEMPLATE(FNAME,OPER,LABEL)					\
+	PUBLIC_FUNCTION(bool)												\
+	pgfn_##FNAME(XPU_PGFUNCTION_ARGS)									\
+	{																	\
+		xpu_inet_t *result = (xpu_inet_t *)__result;					\
+		xpu_inet_t	datum_a;											\
+		xpu_inet_t	datum_b;											\
+		const kern_expression *karg = KEXP_FIRST_ARG(kexp);				\
+																		\
+		assert(kexp->nr_args == 2 && KEXP_IS_VALID(karg, inet));		\
+		if (!EXEC_KERN_EXPRESSION(kcxt, karg, &datum_a))				\
+			return false;												\
+		karg = KEXP_NEXT_ARG(karg);										\
+		assert(KEXP_IS_VALID(karg, inet));								\
+		if (!EXEC_KERN_EXPRESSION(kcxt, karg, &datum_b))				\
+			return false;												\
+																		\
+		if (XPU_DATUM_ISNULL(&datum_a) || XPU_DATUM_ISNULL(&datum_b))	\
+			result->expr_ops = NULL;									\
+		else if (datum_a.value.family != datum_b.value.family)			\
+		{																\
+			STROM_ELOG(kcxt, "cannot " LABEL " inet values of different sizes"); \
+			return false;												\
+		}																\
+		else															\
+		{																\
+			int		nb = __INET_ADDRSIZE(&datum_a.value);				\
+																		\
+			memset(&result->value, 0, sizeof(inet_struct));				\
+			result->expr_ops = &xpu_inet_ops;							\
+			result->value.family = datum_a.value.family;				\
+			result->value.bits = Max(datum_a.value.bits,				\
+									 datum_b.value.bits);				\
+			for (int i=0; i < nb; i++)									\
+				result->value.ipaddr[i] = (datum_a.value.ipaddr[i] OPER	\
+										   datum_b.value.ipaddr[i]);	\
+		}																\
+		return true;													\
+	}
+PG_NETWORK_BITWISE_TEMPLATE(inetand, &, "AND")
+PG_NETWORK_BITWISE_TEMPLATE(inetor,  |, "OR")
+
+/*
+ * '+' (inet,int8) and '-' (inet,int8) - see internal_inetpl()
+ */
+STATIC_FUNCTION(bool)
+__internal_inetpl(kern_context *kcxt,
+				  xpu_inet_t *result,
+				  const inet_struct *ip, int64_t addend)
+{
+	int		nb = __INET_ADDRSIZE(ip);
+	int		carry = 0;
+
+	memset(&result->value, 0, sizeof(inet_struct));
+	result->value.family = ip->family;
+	result->value.bits = ip->bits;
+	while (--nb >= 0)
+	{
+		carry = ip->ipaddr[nb] + (int)(addend & 0xff) + carry;
+		result->value.ipaddr[nb] = (uint8_t)(carry & 0xff);
+		carry >>= 8;
+		/* arithmetic shift keeps the sign of addend */
+		addend >>= 8;
+	}
+	if (!((addend == 0 && carry == 0) ||
+		  (addend == -1 && carry == 1)))
+	{
+		STROM_ELOG(kcxt, "result is out of range");
+		return false;
+	}
+	result->expr_ops = &xpu_inet_ops;
+	return true;
+}
+
+#define PG_NETWORK_INETPL_TEMPLATE(FNAME,SIGN)							\
+	PUBLIC_FUNCTION(bool)												\
+	pgfn_##FNAME(XPU_PGFUNCTION_ARGS)									\
+	{																	\
+		xpu_inet_t *result = (xpu_inet_t *)__result;					\
+		xpu_inet_t	datum_a;											\
+		xpu_int8_t	datum_b;											\
+		const kern_expression *karg = KEXP_FIRST_ARG(kexp);				\
+																		\
+		assert(kexp->nr_args == 2 && KEXP_IS_VALID(karg, inet));		\
+		if (!EXEC_KERN_EXPRESSION(kcxt, karg, &datum_a))				\
+			return false;												\
+		karg = KEXP_NEXT_ARG(karg);										\
+		assert(KEXP_IS_VALID(karg, int8));								\
+		if (!EXEC_KERN_EXPRESSION(kcxt, karg, &datum_b))				\
+			return false;												\
+																		\
+		if (XPU_DATUM_ISNULL(&datum_a) || XPU_DATUM_ISNULL(&datum_b))	\
+		{																\
+			result->expr_ops = NULL;									\
+			return true;												\
+		}																\
+		return __internal_inetpl(kcxt, result, &datum_a.value,			\
+								 SIGN datum_b.value);					\
+	}
+PG_NETWORK_INETPL_TEMPLATE(inetpl,      +)
+PG_NETWORK_INETPL_TEMPLATE(inetmi_int8, -)
+
+/*
+ * '-' (inet,inet) - difference of the addresses as int8
+ *
+ * 'addr - <base>::inet' is the integer encoding of the address, so it
+ * allows to run the band-join or range-partitioning on the inet keys.
+ */
+PUBLIC_FUNCTION(bool)
+pgfn_inetmi(XPU_PGFUNCTION_ARGS)
+{
+	xpu_int8_t *result = (xpu_int8_t *)__result;
+	xpu_inet_t	datum_a;
+	xpu_inet_t	datum_b;
+	const kern_expression *karg = KEXP_FIRST_ARG(kexp);
+
+	assert(kexp->nr_args == 2 && KEXP_IS_VALID(karg, inet));
+	if (!EXEC_KERN_EXPRESSION(kcxt, karg, &datum_a))
+		return false;
+	karg = KEXP_NEXT_ARG(karg);
+	assert(KEXP_IS_VALID(karg, inet));
+	if (!EXEC_KERN_EXPRESSION(kcxt, karg, &datum_b))
+		return false;
+
+	if (XPU_DATUM_ISNULL(&datum_a) || XPU_DATUM_ISNULL(&datum_b))
+		result->expr_ops = NULL;
+	else if (datum_a.value.family != datum_b.value.family)
+	{
+		STROM_ELOG(kcxt, "cannot subtract inet values of different sizes");
+		return false;
+	}
+	else
+	{
+		/* compute a - b by a + ~b + 1, see inetmi() */
+		int		nb = __INET_ADDRSIZE(&datum_a.value);
+		int		byte = 0;
+		int		carry = 1;
+		int64_t	res = 0;
+
+		while (--nb >= 0)
+		{
+			int		lobyte;
+
+			carry = (datum_a.value.ipaddr[nb] +
+					 (~datum_b.value.ipaddr[nb] & 0xff) + carry);
+			lobyte = carry & 0xff;
+			if (byte < sizeof(int64_t))
+				res |= ((int64_t)lobyte) << (byte * 8);
+			else if (res < 0 ? (lobyte != 0xff) : (lobyte != 0))
+			{
+				/* the upper bytes have to be the sign extension */
+				STROM_ELOG(kcxt, "result is out of range");
+				return false;
+			}
+			carry >>= 8;
+			byte++;
+		}
+		/* sign extension, if the result is negative */
+		if (carry == 0 && byte < sizeof(int64_t))
+			res |= ((uint64_t)(int64_t)-1) << (byte * 8);
+		result->expr_ops = &xpu_int8_ops;
+		result->value = res;
+	}
+	return true;
+}
+
 /* ----------------------------------------------------------------
  *
  * cube (alias of earthdistance) data type and functions
@@ -87,8 +87,18 @@ xpu_numeric_datum_arrow_read(kern_context *kcxt,
 														kds_index,
 														sizeof(int128_t));
 	if (addr)
-		set_normalized_numeric(result, *addr,
-							   cmeta->attopts.decimal.scale);
+	{
+		/*
+		 * Arrow::Decimal is a fixed-point integer on the scale of the column,
+		 * so we keep the scale as-is, and skip normalization. Values of the
+		 * same column share the weight, then operators can use the fast path
+		 * without rescaling.
+		 */
+		result->expr_ops = &xpu_numeric_ops;
+		result->kind     = XPU_NUMERIC_KIND__VALID;
+		result->weight   = cmeta->attopts.decimal.scale;
+		result->u.value  = *addr;
+	}
 	else
 		result->expr_ops = NULL;
 	return true;
@@ -218,8 +228,14 @@ xpu_numeric_datum_hash(kern_context *kcxt,
 	else if (arg->kind != XPU_NUMERIC_KIND__VALID)
 		*p_hash = pg_hash_any(&arg->kind, sizeof(uint8_t));
 	else
-		*p_hash = (pg_hash_any(&arg->weight, sizeof(int16_t)) ^
-				   pg_hash_any(&arg->u.value, sizeof(int128_t)));
+	{
+		xpu_numeric_t	temp;
+
+		/* equal values must have same hash, regardless of the scale */
+		set_normalized_numeric(&temp, arg->u.value, arg->weight);
+		*p_hash = (pg_hash_any(&temp.weight, sizeof(int16_t)) ^
+				   pg_hash_any(&temp.u.value, sizeof(int128_t)));
+	}
 	return true;
 }
 
@@ -543,6 +559,76 @@ PG_FLOAT_TO_NUMERIC_TEMPLATE(float2, float,__to_fp32)
 PG_FLOAT_TO_NUMERIC_TEMPLATE(float4, float,__to_fp32)
 PG_FLOAT_TO_NUMERIC_TEMPLATE(float8,double,__to_fp64)
 
+/*
+ * int128 arithmetic with overflow checks
+ */
+INLINE_FUNCTION(bool)
+__numeric_add_overflow(int128_t a, int128_t b, int128_t *p_result)
+{
+	int128_t	r = (int128_t)((unsigned __int128)a + (unsigned __int128)b);
+
+	if (((a ^ r) & (b ^ r)) < 0)
+		return true;
+	*p_result = r;
+	return false;
+}
+
+INLINE_FUNCTION(bool)
+__numeric_sub_overflow(int128_t a, int128_t b, int128_t *p_result)
+{
+	int128_t	r = (int128_t)((unsigned __int128)a - (unsigned __int128)b);
+
+	if (((a ^ b) & (a ^ r)) < 0)
+		return true;
+	*p_result = r;
+	return false;
+}
+
+INLINE_FUNCTION(bool)
+__numeric_mul_overflow(int128_t a, int128_t b, int128_t *p_result)
+{
+	const unsigned __int128 __max = ((unsigned __int128)1 << 127) - 1;
+	unsigned __int128 ua = (a < 0 ? -(unsigned __int128)a : (unsigned __int128)a);
+	unsigned __int128 ub = (b < 0 ? -(unsigned __int128)b : (unsigned __int128)b);
+	unsigned __int128 ur;
+
+	/* no need to check overflow if both are less than 2^63 */
+	if (((ua | ub) >> 63) != 0 && ua != 0 && ub > __max / ua)
+		return true;
+	ur = ua * ub;
+	*p_result = ((a < 0) != (b < 0) ? -(int128_t)ur : (int128_t)ur);
+	return false;
+}
+
+/*
+ * __numeric_align_weight
+ *
+ * It adjusts the weight of the two valid numeric values to the larger one,
+ * for addition and subtraction. Trailing zeros are removed first, to reduce
+ * the digits to be shifted. It returns false on overflow.
+ */
+STATIC_FUNCTION(bool)
+__numeric_align_weight(xpu_numeric_t *a, xpu_numeric_t *b)
+{
+	assert(a->kind == XPU_NUMERIC_KIND__VALID &&
+		   b->kind == XPU_NUMERIC_KIND__VALID);
+	set_normalized_numeric(a, a->u.value, a->weight);
+	set_normalized_numeric(b, b->u.value, b->weight);
+	while (a->weight > b->weight)
+	{
+		if (__numeric_mul_overflow(b->u.value, 10, &b->u.value))
+			return false;
+		b->weight++;
+	}
+	while (a->weight < b->weight)
+	{
+		if (__numeric_mul_overflow(a->u.value, 10, &a->u.value))
+			return false;
+		a->weight++;
+	}
+	return true;
+}
+
 STATIC_FUNCTION(int)
 __numeric_compare(const xpu_numeric_t *a, const xpu_numeric_t *b)
 {
@@ -588,15 +674,20 @@ __numeric_compare(const xpu_numeric_t *a, const xpu_numeric_t *b)
 		return 1;
 	else if ((b_val > 0 && a_val <= 0) || (b_val == 0 && a_val < 0))
 		return -1;
-	/* Ok, both side are same sign with valid values */
+	/*
+	 * Ok, both side are same sign with valid values. If one side overflows
+	 * on rescaling, its absolute value is obviously larger than the other.
+	 */
 	while (a_weight > b_weight)
 	{
-		b_val *= 10;
+		if (__numeric_mul_overflow(b_val, 10, &b_val))
+			return (b_val > 0 ? -1 : 1);
 		b_weight++;
 	}
 	while (a_weight < b_weight)
 	{
-		a_val *= 10;
+		if (__numeric_mul_overflow(a_val, 10, &a_val))
+			return (a_val > 0 ? 1 : -1);
 		a_weight++;
 	}
 	if (a_val > b_val)
@@ -677,21 +768,27 @@ pgfn_numeric_add(XPU_PGFUNCTION_ARGS)
 			else
 				result->kind = XPU_NUMERIC_KIND__NEG_INF;
 		}
+		else if (datum_a.weight == datum_b.weight &&
+				 !__numeric_add_overflow(datum_a.u.value,
+										 datum_b.u.value,
+										 &result->u.value))
+		{
+			/* fast path, if both side share the scale */
+			result->kind = XPU_NUMERIC_KIND__VALID;
+			result->weight = datum_a.weight;
+		}
 		else
 		{
-			while (datum_a.weight > datum_b.weight)
-			{
-				datum_b.u.value *= 10;
-				datum_b.weight++;
-			}
-			while (datum_a.weight < datum_b.weight)
+			int128_t	ival;
+
+			if (!__numeric_align_weight(&datum_a, &datum_b) ||
+				__numeric_add_overflow(datum_a.u.value,
+									   datum_b.u.value, &ival))
 			{
-				datum_a.u.value *= 10;
-				datum_a.weight++;
+				STROM_ELOG(kcxt, "numeric value out of range");
+				return false;
 			}
-			set_normalized_numeric(result,
-								   datum_a.u.value + datum_b.u.value,
-								   datum_a.weight);
+			set_normalized_numeric(result, ival, datum_a.weight);
 		}
 	}
 	return true;
@@ -738,21 +835,27 @@ pgfn_numeric_sub(XPU_PGFUNCTION_ARGS)
 			else
 				result->kind = XPU_NUMERIC_KIND__POS_INF;
 		}
+		else if (datum_a.weight == datum_b.weight &&
+				 !__numeric_sub_overflow(datum_a.u.value,
+										 datum_b.u.value,
+										 &result->u.value))
+		{
+			/* fast path, if both side share the scale */
+			result->kind = XPU_NUMERIC_KIND__VALID;
+			result->weight = datum_a.weight;
+		}
 		else
 		{
-			while (datum_a.weight > datum_b.weight)
-			{
-				datum_b.u.value *= 10;
-				datum_b.weight++;
-			}
-			while (datum_a.weight < datum_b.weight)
+			int128_t	ival;
+
+			if (!__numeric_align_weight(&datum_a, &datum_b) ||
+				__numeric_sub_overflow(datum_a.u.value,
+									   datum_b.u.value, &ival))
 			{
-				datum_a.u.value *= 10;
-				datum_a.weight++;
+				STROM_ELOG(kcxt, "numeric value out of range");
+				return false;
 			}
-			set_normalized_numeric(result,
-								   datum_a.u.value - datum_b.u.value,
-								   datum_a.weight);
+			set_normalized_numeric(result, ival, datum_a.weight);
 		}
 	}
 	return true;
@@ -827,10 +930,28 @@ pgfn_numeric_mul(XPU_PGFUNCTION_ARGS)
 					result->kind = XPU_NUMERIC_KIND__NAN;
 			}
 		}
+		else if (!__numeric_mul_overflow(datum_a.u.value,
+										 datum_b.u.value,
+										 &result->u.value))
+		{
+			/* fast path; the scale of the result is sum of the operands */
+			result->kind = XPU_NUMERIC_KIND__VALID;
+			result->weight = datum_a.weight + datum_b.weight;
+		}
 		else
 		{
-			set_normalized_numeric(result,
-								   datum_a.u.value * datum_b.u.value,
+			int128_t	ival;
+
+			/* retry after removal of the trailing zeros */
+			set_normalized_numeric(&datum_a, datum_a.u.value, datum_a.weight);
+			set_normalized_numeric(&datum_b, datum_b.u.value, datum_b.weight);
+			if (__numeric_mul_overflow(datum_a.u.value,
+									   datum_b.u.value, &ival))
+			{
+				STROM_ELOG(kcxt, "numeric value out of range");
+				return false;
+			}
+			set_normalized_numeric(result, ival,
 								   datum_a.weight + datum_b.weight);
 		}
 	}
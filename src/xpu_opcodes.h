@@ -535,6 +535,14 @@ __FUNC_OPCODE(cot,     float8, 5, NULL)
 __FUNC_OPCODE(sin,     float8, 5, NULL)
 __FUNC_OPCODE(tan,     float8, 5, NULL)
 
+/* float vector distance functions */
+__FUNC_OPCODE(float2_dot_product,     array/array, 10, "pg_strom")
+__FUNC_OPCODE(float2_l2_distance,     array/array, 10, "pg_strom")
+__FUNC_OPCODE(float2_cosine_distance, array/array, 10, "pg_strom")
+__FUNC_OPCODE(float4_dot_product,     array/array, 10, "pg_strom")
+__FUNC_OPCODE(float4_l2_distance,     array/array, 10, "pg_strom")
+__FUNC_OPCODE(float4_cosine_distance, array/array, 10, "pg_strom")
+
 /* Date and time functions */
 FUNC_OPCODE(timestamp, date, DEVKIND__ANY, date_to_timestamp, 5, NULL)
 FUNC_OPCODE(timestamp, timestamptz, DEVKIND__ANY, timestamptz_to_timestamp, 5, NULL)
@@ -664,6 +672,16 @@ FUNC_OPCODE(extract, text/date,        DEVKIND__ANY, extract_date,        50, NU
 FUNC_OPCODE(extract, text/time,        DEVKIND__ANY, extract_time,        50, NULL)
 FUNC_OPCODE(extract, text/timetz,      DEVKIND__ANY, extract_timetz,      50, NULL)
 FUNC_OPCODE(extract, text/interval,    DEVKIND__ANY, extract_interval,    50, NULL)
+/* date_trunc */
+FUNC_OPCODE(date_trunc, text/timestamp,   DEVKIND__ANY, date_trunc_timestamp,   50, NULL)
+FUNC_OPCODE(date_trunc, text/timestamptz, DEVKIND__ANY, date_trunc_timestamptz, 50, NULL)
+FUNC_OPCODE(date_trunc, text/interval,    DEVKIND__ANY, date_trunc_interval,    50, NULL)
+/* date_bin */
+FUNC_OPCODE(date_bin, interval/timestamp/timestamp,     DEVKIND__ANY, date_bin_timestamp,   10, NULL)
+FUNC_OPCODE(date_bin, interval/timestamptz/timestamptz, DEVKIND__ANY, date_bin_timestamptz, 10, NULL)
+/* AT TIME ZONE */
+FUNC_OPCODE(timezone, interval/timestamp,   DEVKIND__ANY, timestamp_izone,   5, NULL)
+FUNC_OPCODE(timezone, interval/timestamptz, DEVKIND__ANY, timestamptz_izone, 5, NULL)
 
 /*
  * Text functions/operators
@@ -696,13 +714,30 @@ __FUNC_OPCODE(bpchariclike, bpchar/text, 800, NULL)
 __FUNC_OPCODE(texticnlike, text/text, 800, NULL)
 __FUNC_OPCODE(bpcharicnlike, bpchar/text, 800, NULL)
 
+/* Regular expression operators (pattern must be a constant) */
+__FUNC_OPCODE(textregexeq, text/text, 1000, NULL)
+__FUNC_OPCODE(textregexne, text/text, 1000, NULL)
+__FUNC_OPCODE(texticregexeq, text/text, 1000, NULL)
+__FUNC_OPCODE(texticregexne, text/text, 1000, NULL)
+__FUNC_OPCODE(regexp_like, text/text, 1000, NULL)
+
 /* String operations */
 FUNC_OPCODE(substr,    text/int4/int4, DEVKIND__ANY, substr,    20, NULL)
 FUNC_OPCODE(substring, text/int4/int4, DEVKIND__ANY, substring, 20, NULL)
 FUNC_OPCODE(substr,    text/int4,      DEVKIND__ANY, substr_nolen, 20, NULL)
 FUNC_OPCODE(substring, text/int4,      DEVKIND__ANY, substring_nolen, 20, NULL)
-//__FUNC_OPCODE(textcat, text/text, NULL)
-//__FUNC_OPCODE(concat, __text__, NULL)
+__FUNC_OPCODE(lower, text, 10, NULL)
+__FUNC_OPCODE(upper, text, 10, NULL)
+FUNC_OPCODE(strpos,   text/text, DEVKIND__ANY, textpos, 20, NULL)
+FUNC_ALIAS(position,  text/text, DEVKIND__ANY, textpos, 20, NULL)
+__FUNC_OPCODE(split_part, text/text/int4, 20, NULL)
+__FUNC_OPCODE(textcat, text/text, 10, NULL)
+__FUNC_OPCODE(concat, __text__, 10, NULL)
+__FUNC_OPCODE(replace, text/text/text, 20, NULL)
+
+/* array comparison (binary-comparable element types only) */
+__FUNC_OPCODE(array_eq, array/array, 50, NULL)
+__FUNC_OPCODE(array_ne, array/array, 50, NULL)
 
 /* currency comparison */
 __FUNC_OPCODE(cash_eq, money/money, 2, NULL)
@@ -738,6 +773,21 @@ __FUNC_OPCODE(network_subeq,   inet/inet, 10, NULL)
 __FUNC_OPCODE(network_sup,     inet/inet, 10, NULL)
 __FUNC_OPCODE(network_supeq,   inet/inet, 10, NULL)
 __FUNC_OPCODE(network_overlap, inet/inet, 10, NULL)
+FUNC_OPCODE(masklen,   inet, DEVKIND__ANY, network_masklen,   5, NULL)
+FUNC_OPCODE(family,    inet, DEVKIND__ANY, network_family,    5, NULL)
+FUNC_OPCODE(network,   inet, DEVKIND__ANY, network_network,   10, NULL)
+FUNC_OPCODE(broadcast, inet, DEVKIND__ANY, network_broadcast, 10, NULL)
+FUNC_OPCODE(netmask,   inet, DEVKIND__ANY, network_netmask,   10, NULL)
+FUNC_OPCODE(hostmask,  inet, DEVKIND__ANY, network_hostmask,  10, NULL)
+FUNC_OPCODE(host,      inet, DEVKIND__ANY, network_host,      30, NULL)
+FUNC_OPCODE(text,      inet, DEVKIND__ANY, network_show,      30, NULL)
+__FUNC_OPCODE(inet_same_family, inet/inet, 5, NULL)
+__FUNC_OPCODE(inetnot,     inet, 10, NULL)
+__FUNC_OPCODE(inetand,     inet/inet, 10, NULL)
+__FUNC_OPCODE(inetor,      inet/inet, 10, NULL)
+__FUNC_OPCODE(inetpl,      inet/int8, 10, NULL)
+__FUNC_OPCODE(inetmi_int8, inet/int8, 10, NULL)
+__FUNC_OPCODE(inetmi,      inet/inet, 10, NULL)
 
 /* jsonb type support */
 __FUNC_OPCODE(jsonb_object_field, jsonb/text, 35, NULL)
@@ -764,12 +814,29 @@ DEVONLY_FUNC_OPCODE(float2, jsonb_array_element_as_float2,  jsonb/text, DEVKIND_
 DEVONLY_FUNC_OPCODE(float4, jsonb_array_element_as_float4,  jsonb/text, DEVKIND__ANY, 10)
 DEVONLY_FUNC_OPCODE(float8, jsonb_array_element_as_float8,  jsonb/text, DEVKIND__ANY, 10)
 
+/* CoerceViaIO from text */
+DEVONLY_FUNC_OPCODE(int2,      text_to_int2,      text, DEVKIND__ANY, 10)
+DEVONLY_FUNC_OPCODE(int4,      text_to_int4,      text, DEVKIND__ANY, 10)
+DEVONLY_FUNC_OPCODE(int8,      text_to_int8,      text, DEVKIND__ANY, 10)
+DEVONLY_FUNC_OPCODE(float4,    text_to_float4,    text, DEVKIND__ANY, 10)
+DEVONLY_FUNC_OPCODE(float8,    text_to_float8,    text, DEVKIND__ANY, 10)
+DEVONLY_FUNC_OPCODE(numeric,   text_to_numeric,   text, DEVKIND__ANY, 10)
+DEVONLY_FUNC_OPCODE(date,      text_to_date,      text, DEVKIND__ANY, 15)
+DEVONLY_FUNC_OPCODE(timestamp, text_to_timestamp, text, DEVKIND__ANY, 20)
+DEVONLY_FUNC_OPCODE(uuid,      text_to_uuid,      text, DEVKIND__ANY, 10)
+
+/* jsonpath program (compiled from the constant jsonpath) */
+DEVONLY_FUNC_OPCODE(bool,   jsonb_path_exists_prog,         jsonb,      DEVKIND__ANY, 100)
+DEVONLY_FUNC_OPCODE(bool,   jsonb_path_match_prog,          jsonb,      DEVKIND__ANY, 100)
+
 /* PostGIS functions */
 FUNC_OPCODE(st_point,     float8/float8,               DEVKIND__ANY, st_point,      5, "postgis")
 FUNC_OPCODE(st_makepoint, float8/float8,               DEVKIND__ANY, st_makepoint2, 5, "postgis")
 FUNC_OPCODE(st_makepoint, float8/float8/float8,        DEVKIND__ANY, st_makepoint3, 5, "postgis")
 FUNC_OPCODE(st_makepoint, float8/float8/float8/float8, DEVKIND__ANY, st_makepoint4, 5, "postgis")
 __FUNC_OPCODE(st_setsrid,        geometry/int4,             5, "postgis")
+__FUNC_OPCODE(st_x,              geometry,                  5, "postgis")
+__FUNC_OPCODE(st_y,              geometry,                  5, "postgis")
 __FUNC_OPCODE(st_distance,       geometry/geometry,        99, "postgis")
 __FUNC_OPCODE(st_dwithin,        geometry/geometry/float8, 99, "postgis")
 __FUNC_OPCODE(st_linecrossingdirection, geometry/geometry, 99, "postgis")
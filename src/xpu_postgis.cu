@@ -849,6 +849,53 @@ pgfn_st_makepoint4(XPU_PGFUNCTION_ARGS)
 	return true;
 }
 
+/*
+ * st_x / st_y - coordinate of the POINT geometry
+ */
+STATIC_FUNCTION(bool)
+__geometry_point_coord(kern_context *kcxt,
+					   const kern_expression *kexp,
+					   xpu_float8_t *result, int index)
+{
+	xpu_geometry_t	geom;
+	const kern_expression *karg = KEXP_FIRST_ARG(kexp);
+
+	assert(kexp->nr_args == 1 &&
+		   KEXP_IS_VALID(karg, geometry));
+	if (!EXEC_KERN_EXPRESSION(kcxt, karg, &geom))
+		return false;
+	if (XPU_DATUM_ISNULL(&geom))
+		result->expr_ops = NULL;
+	else if (!xpu_geometry_is_valid(kcxt, &geom))
+		return false;
+	else if (geom.type != GEOM_POINTTYPE)
+	{
+		STROM_ELOG(kcxt, "Argument to ST_X()/ST_Y() must have type POINT");
+		return false;
+	}
+	else if (geom.nitems == 0)
+		result->expr_ops = NULL;	/* empty point */
+	else
+	{
+		memcpy(&result->value,
+			   geom.rawdata + sizeof(double) * index, sizeof(double));
+		result->expr_ops = &xpu_float8_ops;
+	}
+	return true;
+}
+
+PUBLIC_FUNCTION(bool)
+pgfn_st_x(XPU_PGFUNCTION_ARGS)
+{
+	return __geometry_point_coord(kcxt, kexp, (xpu_float8_t *)__result, 0);
+}
+
+PUBLIC_FUNCTION(bool)
+pgfn_st_y(XPU_PGFUNCTION_ARGS)
+{
+	return __geometry_point_coord(kcxt, kexp, (xpu_float8_t *)__result, 1);
+}
+
 /* ================================================================
  *
  * Internal utility functions
@@ -5990,6 +6037,220 @@ pgfn_st_relate(XPU_PGFUNCTION_ARGS)
 	return true;
 }
 
+/* ================================================================
+ *
+ * Point-in-polygon test using the polygon-index of GpuJoin
+ *
+ * ================================================================
+ */
+STATIC_FUNCTION(const kern_polygon_edges *)
+__lookup_polygon_edges(kern_context *kcxt, const char *addr)
+{
+	const kern_multirels *kmrels = kcxt->kmrels;
+
+	if (!kmrels)
+		return NULL;
+	for (int i=0; i < kmrels->num_rels; i++)
+	{
+		const kern_polygon_index *pindex;
+		const char *kds;
+		uint64_t	gs_offset;
+		uint32_t	head, tail;
+
+		if (kmrels->chunks[i].polyidx_offset == 0)
+			continue;
+		kds = (const char *)kmrels + kmrels->chunks[i].kds_offset;
+		pindex = (const kern_polygon_index *)
+			((const char *)kmrels + kmrels->chunks[i].polyidx_offset);
+		if (addr < kds || addr >= (const char *)pindex)
+			continue;
+		/* binary search by the offset of the geometry varlena */
+		gs_offset = addr - kds;
+		head = 0;
+		tail = pindex->nitems;
+		while (head < tail)
+		{
+			uint32_t	mid = head + (tail - head) / 2;
+
+			if (pindex->items[mid].gs_offset < gs_offset)
+				head = mid + 1;
+			else
+				tail = mid;
+		}
+		if (head < pindex->nitems &&
+			pindex->items[head].gs_offset == gs_offset)
+			return (const kern_polygon_edges *)
+				((const char *)pindex + pindex->items[head].pe_offset);
+		return NULL;
+	}
+	return NULL;
+}
+
+/*
+ * __geom_point_in_ring_edges
+ *
+ * same as __geom_point_in_ring(), but only on the edges of the ring that
+ * cross the slab. It consumes the edge references of the current ring.
+ */
+INLINE_FUNCTION(int32_t)
+__geom_point_in_ring_edges(const kern_polygon_edge *edges,
+						   const uint32_t *refs,
+						   uint32_t *p_index, uint32_t end,
+						   const POINT2D *pt)
+{
+	const kern_polygon_edge *e = &edges[refs[*p_index]];
+	uint32_t	poly_id = e->poly_id;
+	uint32_t	ring_id = e->ring_id;
+	uint32_t	i;
+	int			wn = 0;
+	bool		on_boundary = false;
+
+	for (i = *p_index; i < end; i++)
+	{
+		POINT2D		seg1;
+		POINT2D		seg2;
+		double		side;
+
+		e = &edges[refs[i]];
+		if (e->poly_id != poly_id || e->ring_id != ring_id)
+			break;
+		if (on_boundary)
+			continue;
+		seg1.x = e->x1;
+		seg1.y = e->y1;
+		seg2.x = e->x2;
+		seg2.y = e->y2;
+		side = determineSide(&seg1, &seg2, pt);
+		if (side == 0.0 && isOnSegment(&seg1, &seg2, pt))
+			on_boundary = true;
+		else if (seg1.y <= pt->y && pt->y < seg2.y && side > 0.0)
+			wn++;
+		else if (seg2.y <= pt->y && pt->y < seg1.y && side < 0.0)
+			wn--;
+	}
+	*p_index = i;
+	if (on_boundary)
+		return PT_BOUNDARY;
+	return (wn == 0 ? PT_OUTSIDE : PT_INSIDE);
+}
+
+INLINE_FUNCTION(uint32_t)
+__skip_polygon_edges(const kern_polygon_edge *edges,
+					 const uint32_t *refs,
+					 uint32_t index, uint32_t end,
+					 uint32_t poly_id)
+{
+	while (index < end && edges[refs[index]].poly_id == poly_id)
+		index++;
+	return index;
+}
+
+/*
+ * __geom_point_in_polygon_edges
+ *
+ * It follows the logic of __geom_point_in_polygon() or
+ * __geom_point_in_multipolygon(). A ring without any edges on the slab
+ * never contains the point.
+ */
+STATIC_FUNCTION(int32_t)
+__geom_point_in_polygon_edges(const kern_polygon_edges *pe, const POINT2D *pt)
+{
+	const uint32_t *slabs = KERN_POLYGON_EDGES_SLABS(pe);
+	const uint32_t *refs = KERN_POLYGON_EDGES_REFS(pe);
+	const kern_polygon_edge *edges = KERN_POLYGON_EDGES_ITEMS(pe);
+	uint32_t	k, i, end;
+	int32_t		retval = PT_OUTSIDE;
+
+	if (pt->x < pe->xmin || pt->x > pe->xmax ||
+		pt->y < pe->ymin || pt->y > pe->ymax)
+		return PT_OUTSIDE;
+	k = KERN_POLYGON_EDGES_SLAB(pe, pt->y);
+	i = slabs[k];
+	end = slabs[k+1];
+	while (i < end)
+	{
+		uint32_t	poly_id = edges[refs[i]].poly_id;
+		int32_t		status;
+
+		if (edges[refs[i]].ring_id != 0)
+		{
+			/* outside of the exterior ring */
+			i = __skip_polygon_edges(edges, refs, i, end, poly_id);
+			continue;
+		}
+		status = __geom_point_in_ring_edges(edges, refs, &i, end, pt);
+		if (status == PT_OUTSIDE)
+		{
+			i = __skip_polygon_edges(edges, refs, i, end, poly_id);
+			continue;
+		}
+		if (pe->is_multi && status == PT_BOUNDARY)
+			return PT_BOUNDARY;
+		retval = status;
+		/* holes */
+		while (i < end && edges[refs[i]].poly_id == poly_id)
+		{
+			status = __geom_point_in_ring_edges(edges, refs, &i, end, pt);
+			/* inside a hole => outside the polygon */
+			if (status == PT_INSIDE)
+			{
+				retval = PT_OUTSIDE;
+				i = __skip_polygon_edges(edges, refs, i, end, poly_id);
+				break;
+			}
+			/* on the edge of a hole */
+			if (status == PT_BOUNDARY)
+				return PT_BOUNDARY;
+		}
+		if (!pe->is_multi || retval != PT_OUTSIDE)
+			return retval;
+	}
+	return retval;
+}
+
+/*
+ * fast_geom_contains_polygon_edges_point
+ *
+ * same as fast_geom_contains_polygon_point(), but by the polygon-index
+ */
+STATIC_FUNCTION(int)
+fast_geom_contains_polygon_edges_point(kern_context *kcxt,
+									   const kern_polygon_edges *pe,
+									   const xpu_geometry_t *geom2)
+{
+	POINT2D		pt;
+	int32_t		status = PT_ERROR;
+
+	assert(geom2->type == GEOM_POINTTYPE ||
+		   geom2->type == GEOM_MULTIPOINTTYPE);
+	if (geom2->type == GEOM_POINTTYPE)
+	{
+		__loadPoint2d(&pt, geom2->rawdata, 0);
+		status = __geom_point_in_polygon_edges(pe, &pt);
+		return (status == PT_INSIDE ? 1 : 0);
+	}
+	else
+	{
+		xpu_geometry_t __geom;
+		const char *pos = NULL;
+		bool		meet_inside = false;
+
+		for (int i=0; i < geom2->nitems; i++)
+		{
+			pos = geometry_load_subitem(&__geom, geom2, pos, i);
+			if (!pos)
+				return -1;
+			__loadPoint2d(&pt, __geom.rawdata, 0);
+			status = __geom_point_in_polygon_edges(pe, &pt);
+			if (status == PT_INSIDE)
+				meet_inside = true;
+			else if (status == PT_OUTSIDE)
+				break;
+		}
+		return (meet_inside && status != PT_OUTSIDE ? 1 : 0);
+	}
+}
+
 /* ================================================================
  *
  * St_Contains(geometry,geometry)
@@ -6068,12 +6329,36 @@ fast_geom_contains_polygon_point(kern_context *kcxt,
 PUBLIC_FUNCTION(bool)
 pgfn_st_contains(XPU_PGFUNCTION_ARGS)
 {
+	const kern_polygon_edges *pe = NULL;
 	KEXP_PROCESS_ARGS2(bool, geometry, geom1, geometry, geom2);
 
+	/*
+	 * shortcut-0: if geom1 is an inner polygon of GpuJoin, the polygon-
+	 * index is available without parsing the GSERIALIZED.
+	 */
+	if (!XPU_DATUM_ISNULL(&geom1) && geom1.type == GEOM_INVALID_VARLENA)
+		pe = __lookup_polygon_edges(kcxt, geom1.rawdata);
+
 	if (XPU_DATUM_ISNULL(&geom1) || XPU_DATUM_ISNULL(&geom2))
 		result->expr_ops = NULL;
-	else if (!xpu_geometry_is_valid(kcxt, &geom1) ||
-			 !xpu_geometry_is_valid(kcxt, &geom2))
+	else if (!xpu_geometry_is_valid(kcxt, &geom2))
+		return false;
+	else if (pe && !geometry_is_empty(&geom2) &&
+			 (geom2.type == GEOM_POINTTYPE ||
+			  geom2.type == GEOM_MULTIPOINTTYPE))
+	{
+		int			status;
+
+		status = fast_geom_contains_polygon_edges_point(kcxt, pe, &geom2);
+		if (status >= 0)
+		{
+			result->expr_ops = &xpu_bool_ops;
+			result->value = (status == 0 ? false : true);
+		}
+		else
+			result->expr_ops = NULL;
+	}
+	else if (!xpu_geometry_is_valid(kcxt, &geom1))
 		return false;
 	else if (geometry_is_empty(&geom1) || geometry_is_empty(&geom2))
 	{
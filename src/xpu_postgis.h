@@ -198,4 +198,87 @@ typedef struct
 	double	x, y, z, m;
 } POINT4D;
 
+/*
+ * kern_polygon_index - preprocessed inner polygons of GpuJoin
+ *
+ * st_contains(inner_polygon, outer_point) tests a small set of polygons
+ * for a huge number of points. The inner POLYGON/MULTIPOLYGON values are
+ * decoded on the preloading, and the edges of each geometry are bucketed
+ * into the horizontal slabs of its extent. A point test walks only the
+ * edges that cross the slab of the point, instead of all the rings.
+ *
+ * The index is looked up by the offset of the geometry varlena in the
+ * inner KDS, so it does not need to parse the GSERIALIZED again.
+ */
+typedef struct
+{
+	double		x1, y1;
+	double		x2, y2;
+	uint32_t	poly_id;	/* index of the polygon in multipolygon */
+	uint32_t	ring_id;	/* index of the ring; 0 is the exterior ring */
+} kern_polygon_edge;
+
+typedef struct
+{
+	uint32_t	length;		/* length of this entry */
+	bool		is_multi;	/* true, if MULTIPOLYGON */
+	uint32_t	nedges;		/* number of the edges */
+	uint32_t	nslabs;		/* number of the slabs */
+	uint32_t	nrefs;		/* number of the edge references */
+	double		xmin, xmax;	/* extent of the edges */
+	double		ymin, ymax;
+	double		slab_unit;	/* height of a slab */
+	/*
+	 * slab_start[nslabs+1] - start position of the slab on the edge_refs
+	 * edge_refs[nrefs]     - edge index (ascending) per slab
+	 * kern_polygon_edge    - edges[nedges] are at the MAXALIGN'ed position
+	 */
+	uint32_t	data[1];
+} kern_polygon_edges;
+
+#define KERN_POLYGON_EDGES_SLABS(pe)	((pe)->data)
+#define KERN_POLYGON_EDGES_REFS(pe)		((pe)->data + (pe)->nslabs + 1)
+#define KERN_POLYGON_EDGES_ITEMS(pe)									\
+	((kern_polygon_edge *)((char *)(pe) +								\
+						   MAXALIGN(offsetof(kern_polygon_edges,		\
+											 data[(pe)->nslabs + 1 +	\
+												  (pe)->nrefs]))))
+#define KERN_POLYGON_EDGES_LENGTH(nslabs,nrefs,nedges)					\
+	(MAXALIGN(offsetof(kern_polygon_edges, data[(nslabs) + 1 + (nrefs)])) + \
+	 sizeof(kern_polygon_edge) * (nedges))
+
+/*
+ * KERN_POLYGON_EDGES_SLAB - slab of the y-coordinate
+ *
+ * Both of the host (to bucket the edges) and the device (to find the slab
+ * of a point) use this function, so it must be monotonic on 'y'.
+ */
+INLINE_FUNCTION(uint32_t)
+KERN_POLYGON_EDGES_SLAB(const kern_polygon_edges *pe, double y)
+{
+	double		k;
+
+	if (pe->slab_unit <= 0.0 || !(y > pe->ymin))
+		return 0;
+	k = (y - pe->ymin) / pe->slab_unit;
+	if (k >= (double)(pe->nslabs - 1))
+		return pe->nslabs - 1;
+	return (uint32_t)k;
+}
+
+typedef struct
+{
+	uint64_t	length;		/* length of the polygon-index */
+	uint32_t	nrooms;		/* capacity of the items[] */
+	uint32_t	nitems;		/* number of the indexed polygons */
+	struct {
+		uint64_t	gs_offset;	/* offset of the geometry from the KDS */
+		uint64_t	pe_offset;	/* offset of the kern_polygon_edges from
+								 * the head of kern_polygon_index */
+	} items[1];				/* sorted by gs_offset */
+} kern_polygon_index;
+
+#define KERN_POLYGON_INDEX_LENGTH(nrooms,usage)							\
+	(MAXALIGN(offsetof(kern_polygon_index, items[(nrooms)])) + MAXALIGN(usage))
+
 #endif /* XPU_POSTGIS_H */
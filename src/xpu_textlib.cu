@@ -46,6 +46,16 @@ __xpu_varlena_datum_arrow_ref(kern_context *kcxt,
 				KDS_ARROW_REF_VARLENA64_DATUM(kds, cmeta, kds_index, p_length);
 			break;
 
+		case ArrowType__Utf8View:
+		case ArrowType__BinaryView:
+			/*
+			 * short strings are inlined on the view, so they are fetched
+			 * without touching the data buffer.
+			 */
+			*p_value = (const char *)
+				KDS_ARROW_REF_VIEW_DATUM(kds, cmeta, kds_index, p_length);
+			break;
+
 		default:
 			STROM_ELOG(kcxt, "not a mappable Arrow data type");
 			return false;
@@ -543,6 +553,51 @@ xpu_bytea_datum_comp(kern_context *kcxt,
 }
 PGSTROM_SQLTYPE_OPERATORS(bytea, false, 4, -1);
 
+/*
+ * Comparison by the collation weight table
+ */
+STATIC_FUNCTION(bool)
+xpu_bpchar_collate_comp(kern_context *kcxt,
+						int *p_comp,
+						const kern_expression *kexp,
+						const xpu_bpchar_t *str1,
+						const xpu_bpchar_t *str2)
+{
+	if (!xpu_bpchar_is_valid(kcxt, str1) ||
+		!xpu_bpchar_is_valid(kcxt, str2))
+		return false;
+	if (!__collate_weight_comp(&kexp->u.coll.weights, p_comp,
+							   str1->value,
+							   bpchar_truelen(str1->value, str1->length),
+							   str2->value,
+							   bpchar_truelen(str2->value, str2->length)))
+	{
+		STROM_CPU_FALLBACK(kcxt, "bpchar datum is not supported by the collation weight table");
+		return false;
+	}
+	return true;
+}
+
+STATIC_FUNCTION(bool)
+xpu_text_collate_comp(kern_context *kcxt,
+					  int *p_comp,
+					  const kern_expression *kexp,
+					  const xpu_text_t *str1,
+					  const xpu_text_t *str2)
+{
+	if (!xpu_text_is_valid(kcxt, str1) ||
+		!xpu_text_is_valid(kcxt, str2))
+		return false;
+	if (!__collate_weight_comp(&kexp->u.coll.weights, p_comp,
+							   str1->value, str1->length,
+							   str2->value, str2->length))
+	{
+		STROM_CPU_FALLBACK(kcxt, "text datum is not supported by the collation weight table");
+		return false;
+	}
+	return true;
+}
+
 /*
  * Bpchar functions
  */
@@ -560,9 +615,15 @@ PGSTROM_SQLTYPE_OPERATORS(bytea, false, 4, -1);
 		{																\
 			int		comp;												\
 																		\
-			if (!xpu_bpchar_datum_comp(kcxt, &comp,						\
-									   (xpu_datum_t *)&datum_a,			\
-									   (xpu_datum_t *)&datum_b))		\
+			if ((kexp->expflags & KEXP_FLAG__COLLATE_WEIGHTS) != 0)		\
+			{															\
+				if (!xpu_bpchar_collate_comp(kcxt, &comp, kexp,			\
+											 &datum_a, &datum_b))		\
+					return false;										\
+			}															\
+			else if (!xpu_bpchar_datum_comp(kcxt, &comp,				\
+											(xpu_datum_t *)&datum_a,	\
+											(xpu_datum_t *)&datum_b))	\
 				return false;											\
 			result->value = (comp OPER 0);								\
 			result->expr_ops = &xpu_bool_ops;							\
@@ -635,9 +696,15 @@ pgfn_bpcharlen(XPU_PGFUNCTION_ARGS)
 		{																\
 			int		comp;												\
 																		\
-			if (!xpu_text_datum_comp(kcxt, &comp,						\
-									 (xpu_datum_t *)&datum_a,			\
-									 (xpu_datum_t *)&datum_b))			\
+			if ((kexp->expflags & KEXP_FLAG__COLLATE_WEIGHTS) != 0)		\
+			{															\
+				if (!xpu_text_collate_comp(kcxt, &comp, kexp,			\
+										   &datum_a, &datum_b))			\
+					return false;										\
+			}															\
+			else if (!xpu_text_datum_comp(kcxt, &comp,					\
+										  (xpu_datum_t *)&datum_a,		\
+										  (xpu_datum_t *)&datum_b))		\
 				return false;											\
 			result->value = (comp OPER 0);								\
 			result->expr_ops = &xpu_bool_ops;							\
@@ -1151,6 +1218,90 @@ PG_BPCHARLIKE_TEMPLATE(bpcharnlike, GenericMatchText, !=)
 PG_BPCHARLIKE_TEMPLATE(bpchariclike, GenericCaseMatchText, ==)
 PG_BPCHARLIKE_TEMPLATE(bpcharicnlike, GenericCaseMatchText, !=)
 
+/*
+ * Regular expression match by DFA
+ */
+STATIC_FUNCTION(bool)
+__regex_dfa_exec(kern_context *kcxt,
+				 const kern_expression *kexp,
+				 const char *str, int len,
+				 bool *p_matched)
+{
+	const uint8_t  *flags = (const uint8_t *)kexp->u.regex.data;
+	const uint16_t *trans = (const uint16_t *)
+		(kexp->u.regex.data + kexp->u.regex.trans_offset);
+	const uint8_t  *symclass = kexp->u.regex.symclass;
+	uint32_t		nclasses = kexp->u.regex.nclasses;
+	xpu_encode_info *encode = NULL;
+	const char	   *pos = str;
+	const char	   *end = str + len;
+	uint32_t		state = 0;
+
+	while (pos < end &&
+		   (flags[state] & (KERN_REGEX_FLAG__MATCHED |
+							KERN_REGEX_FLAG__DEAD)) == 0)
+	{
+		uint32_t	c = (uint8_t)*pos;
+
+		if (c < 0x80)
+			pos++;
+		else
+		{
+			if (!encode)
+			{
+				encode = SESSION_ENCODE(kcxt->session);
+				if (!encode)
+				{
+					STROM_ELOG(kcxt, "No encoding info was supplied");
+					return false;
+				}
+			}
+			pos += (encode->enc_maxlen == 1 ? 1 : encode->enc_mblen(pos));
+			c = KERN_REGEX_SYMBOL__NONASCII;
+		}
+		state = trans[state * nclasses + symclass[c]];
+		if (state == KERN_REGEX_STATE__FALLBACK)
+		{
+			STROM_CPU_FALLBACK(kcxt, "regular expression needs locale for non-ASCII characters");
+			return false;
+		}
+	}
+	if ((flags[state] & KERN_REGEX_FLAG__MATCHED) != 0)
+		*p_matched = true;
+	else if ((flags[state] & KERN_REGEX_FLAG__DEAD) != 0)
+		*p_matched = false;
+	else
+		*p_matched = ((flags[state] & KERN_REGEX_FLAG__ACCEPT_EOS) != 0);
+	return true;
+}
+
+#define PG_TEXTREGEX_TEMPLATE(FN_NAME,OPER)								\
+	PUBLIC_FUNCTION(bool)												\
+	pgfn_##FN_NAME(XPU_PGFUNCTION_ARGS)									\
+	{																	\
+		bool	matched;												\
+		KEXP_PROCESS_ARGS1(bool, text, datum);	/* pattern is in DFA */	\
+																		\
+		if (XPU_DATUM_ISNULL(&datum))									\
+			result->expr_ops = NULL;									\
+		else															\
+		{																\
+			if (!xpu_text_is_valid(kcxt, &datum) ||						\
+				!__regex_dfa_exec(kcxt, kexp,							\
+								  datum.value, datum.length,			\
+								  &matched))							\
+				return false;											\
+			result->value = (matched OPER true);						\
+			result->expr_ops = &xpu_bool_ops;							\
+		}																\
+		return true;													\
+	}
+PG_TEXTREGEX_TEMPLATE(textregexeq, ==)
+PG_TEXTREGEX_TEMPLATE(textregexne, !=)
+PG_TEXTREGEX_TEMPLATE(texticregexeq, ==)
+PG_TEXTREGEX_TEMPLATE(texticregexne, !=)
+PG_TEXTREGEX_TEMPLATE(regexp_like, ==)
+
 /*
  * Sub-string
  */
@@ -1315,3 +1466,672 @@ pgfn_substr_nolen(XPU_PGFUNCTION_ARGS)
 {
 	return pgfn_substring_nolen(kcxt, kexp, __result);
 }
+
+/*
+ * __text_search - returns the byte offset of the first occurrence of 'sub'
+ * in 'str' at the character boundary, from 'start' (also at the boundary);
+ * or -1 if not found. Comparison at the character boundary is needed for
+ * the encodings that can have ASCII code in the trailing bytes (SJIS, ...).
+ */
+STATIC_FUNCTION(int32_t)
+__text_search(const xpu_encode_info *encode,
+			  const char *str, int32_t len, int32_t start,
+			  const char *sub, int32_t sublen)
+{
+	int32_t		pos = start;
+
+	assert(sublen > 0);
+	while (pos + sublen <= len)
+	{
+		if (str[pos] == sub[0] && __memcmp(str + pos, sub, sublen) == 0)
+			return pos;
+		pos += (encode->enc_maxlen == 1 ? 1 : encode->enc_mblen(str + pos));
+	}
+	return -1;
+}
+
+/*
+ * lower / upper
+ *
+ * Only ASCII characters are converted on the device, because case mapping
+ * of multi-byte characters depends on the locale; so, the text that has
+ * non-ASCII characters to be converted is processed by the CPU-fallback.
+ * The code generator does not push down these functions on the Turkish or
+ * Azerbaijani locales, where mapping of 'i' and 'I' is special.
+ */
+#define PG_TEXT_CASE_MAPPING_TEMPLATE(NAME,LOWER_BOUND,UPPER_BOUND,DIFF)	\
+	PUBLIC_FUNCTION(bool)												\
+	pgfn_##NAME(XPU_PGFUNCTION_ARGS)									\
+	{																	\
+		KEXP_PROCESS_ARGS1(text, text, str);							\
+																		\
+		if (XPU_DATUM_ISNULL(&str))										\
+			result->expr_ops = NULL;									\
+		else															\
+		{																\
+			char	   *buf;											\
+			int32_t		i;												\
+																		\
+			if (!xpu_text_is_valid(kcxt, &str))							\
+				return false;											\
+			for (i=0; i < str.length; i++)								\
+			{															\
+				char	c = str.value[i];								\
+																		\
+				if ((c >= LOWER_BOUND && c <= UPPER_BOUND) ||			\
+					(c & 0x80) != 0)									\
+					break;												\
+			}															\
+			if (i == str.length)										\
+			{															\
+				/* no characters to be converted */						\
+				result->expr_ops = &xpu_text_ops;						\
+				result->length = str.length;							\
+				result->value = str.value;								\
+				return true;											\
+			}															\
+			buf = __text_result_alloc(kcxt, str.length);				\
+			if (!buf)													\
+				return false;											\
+			memcpy(buf, str.value, i);									\
+			for (; i < str.length; i++)									\
+			{															\
+				char	c = str.value[i];								\
+																		\
+				if ((c & 0x80) != 0)									\
+				{														\
+					STROM_CPU_FALLBACK(kcxt, "case mapping of non-ASCII characters"); \
+					return false;										\
+				}														\
+				if (c >= LOWER_BOUND && c <= UPPER_BOUND)				\
+					c += (DIFF);										\
+				buf[i] = c;												\
+			}															\
+			result->expr_ops = &xpu_text_ops;							\
+			result->length = str.length;								\
+			result->value = buf;										\
+		}																\
+		return true;													\
+	}
+PG_TEXT_CASE_MAPPING_TEMPLATE(lower, 'A', 'Z', 'a' - 'A')
+PG_TEXT_CASE_MAPPING_TEMPLATE(upper, 'a', 'z', 'A' - 'a')
+
+/*
+ * strpos / position
+ */
+PUBLIC_FUNCTION(bool)
+pgfn_textpos(XPU_PGFUNCTION_ARGS)
+{
+	KEXP_PROCESS_ARGS2(int4, text, str, text, sub);
+
+	if (XPU_DATUM_ISNULL(&str) || XPU_DATUM_ISNULL(&sub))
+		result->expr_ops = NULL;
+	else
+	{
+		const xpu_encode_info *encode = SESSION_ENCODE(kcxt->session);
+		int32_t		pos;
+
+		if (!encode)
+		{
+			STROM_ELOG(kcxt, "No encoding info was supplied");
+			return false;
+		}
+		if (!xpu_text_is_valid(kcxt, &str) ||
+			!xpu_text_is_valid(kcxt, &sub))
+			return false;
+		result->expr_ops = &xpu_int4_ops;
+		if (sub.length == 0)
+			result->value = 1;
+		else if ((pos = __text_search(encode, str.value, str.length, 0,
+									  sub.value, sub.length)) < 0)
+			result->value = 0;
+		else if (encode->enc_maxlen == 1)
+			result->value = pos + 1;
+		else
+		{
+			/* number of characters prior to the match */
+			int32_t		nchars = 1;
+
+			for (int32_t i=0; i < pos; i += encode->enc_mblen(str.value + i))
+				nchars++;
+			result->value = nchars;
+		}
+	}
+	return true;
+}
+
+/*
+ * split_part
+ */
+PUBLIC_FUNCTION(bool)
+pgfn_split_part(XPU_PGFUNCTION_ARGS)
+{
+	KEXP_PROCESS_ARGS3(text, text, str, text, fldsep, int4, fldnum);
+
+	if (XPU_DATUM_ISNULL(&str) ||
+		XPU_DATUM_ISNULL(&fldsep) ||
+		XPU_DATUM_ISNULL(&fldnum))
+		result->expr_ops = NULL;
+	else
+	{
+		const xpu_encode_info *encode = SESSION_ENCODE(kcxt->session);
+		int32_t		nfield = fldnum.value;
+		int32_t		start = 0;
+		int32_t		end;
+
+		if (!encode)
+		{
+			STROM_ELOG(kcxt, "No encoding info was supplied");
+			return false;
+		}
+		if (nfield == 0)
+		{
+			STROM_ELOG(kcxt, "field position must not be zero");
+			return false;
+		}
+		if (!xpu_text_is_valid(kcxt, &str) ||
+			!xpu_text_is_valid(kcxt, &fldsep))
+			return false;
+		result->expr_ops = &xpu_text_ops;
+		result->value = str.value;
+		result->length = 0;
+		if (str.length == 0)
+			return true;		/* empty string */
+		if (fldsep.length == 0)
+		{
+			/* the whole input string is the only field */
+			if (nfield == 1 || nfield == -1)
+				result->length = str.length;
+			return true;
+		}
+		if (nfield < 0)
+		{
+			/* negative field number counts from the tail */
+			int32_t		nitems = 1;
+
+			while ((start = __text_search(encode, str.value, str.length, start,
+										  fldsep.value, fldsep.length)) >= 0)
+			{
+				start += fldsep.length;
+				nitems++;
+			}
+			nfield += nitems + 1;
+			if (nfield <= 0)
+				return true;	/* empty string */
+			start = 0;
+		}
+		while (--nfield > 0)
+		{
+			start = __text_search(encode, str.value, str.length, start,
+								  fldsep.value, fldsep.length);
+			if (start < 0)
+				return true;	/* empty string */
+			start += fldsep.length;
+		}
+		end = __text_search(encode, str.value, str.length, start,
+							fldsep.value, fldsep.length);
+		if (end < 0)
+			end = str.length;
+		result->value = str.value + start;
+		result->length = end - start;
+	}
+	return true;
+}
+
+/*
+ * textcat (text || text) and concat
+ */
+PUBLIC_FUNCTION(bool)
+pgfn_textcat(XPU_PGFUNCTION_ARGS)
+{
+	KEXP_PROCESS_ARGS2(text, text, str1, text, str2);
+
+	if (XPU_DATUM_ISNULL(&str1) || XPU_DATUM_ISNULL(&str2))
+		result->expr_ops = NULL;
+	else
+	{
+		char	   *buf;
+
+		if (!xpu_text_is_valid(kcxt, &str1) ||
+			!xpu_text_is_valid(kcxt, &str2))
+			return false;
+		result->expr_ops = &xpu_text_ops;
+		if (str1.length == 0)
+		{
+			result->length = str2.length;
+			result->value = str2.value;
+		}
+		else if (str2.length == 0)
+		{
+			result->length = str1.length;
+			result->value = str1.value;
+		}
+		else
+		{
+			buf = __text_result_alloc(kcxt, str1.length + str2.length);
+			if (!buf)
+				return false;
+			memcpy(buf, str1.value, str1.length);
+			memcpy(buf + str1.length, str2.value, str2.length);
+			result->length = str1.length + str2.length;
+			result->value = buf;
+		}
+	}
+	return true;
+}
+
+PUBLIC_FUNCTION(bool)
+pgfn_concat(XPU_PGFUNCTION_ARGS)
+{
+	xpu_text_t *result = (xpu_text_t *)__result;
+	xpu_text_t *vals;
+	const kern_expression *karg;
+	int32_t		len = 0;
+	int			nvalids = 0;
+	int			i;
+	char	   *buf;
+
+	vals = (xpu_text_t *)__text_result_alloc(kcxt, sizeof(xpu_text_t) *
+											 Max(kexp->nr_args, 1));
+	if (!vals)
+		return false;
+	for (i=0, karg = KEXP_FIRST_ARG(kexp);
+		 i < kexp->nr_args;
+		 i++, karg = KEXP_NEXT_ARG(karg))
+	{
+		xpu_text_t *datum = &vals[nvalids];
+
+		assert(KEXP_IS_VALID(karg, text));
+		if (!EXEC_KERN_EXPRESSION(kcxt, karg, datum))
+			return false;
+		/* NULL arguments are ignored */
+		if (XPU_DATUM_ISNULL(datum))
+			continue;
+		if (!xpu_text_is_valid(kcxt, datum))
+			return false;
+		if (datum->length > 0)
+		{
+			len += datum->length;
+			nvalids++;
+		}
+	}
+	result->expr_ops = &xpu_text_ops;
+	if (nvalids == 0)
+	{
+		result->length = 0;
+		result->value = "";
+	}
+	else if (nvalids == 1)
+	{
+		result->length = vals[0].length;
+		result->value = vals[0].value;
+	}
+	else
+	{
+		buf = __text_result_alloc(kcxt, len);
+		if (!buf)
+			return false;
+		result->length = len;
+		result->value = buf;
+		for (i=0; i < nvalids; i++)
+		{
+			memcpy(buf, vals[i].value, vals[i].length);
+			buf += vals[i].length;
+		}
+	}
+	return true;
+}
+
+/*
+ * replace
+ */
+PUBLIC_FUNCTION(bool)
+pgfn_replace(XPU_PGFUNCTION_ARGS)
+{
+	KEXP_PROCESS_ARGS3(text, text, str, text, from, text, to);
+
+	if (XPU_DATUM_ISNULL(&str) ||
+		XPU_DATUM_ISNULL(&from) ||
+		XPU_DATUM_ISNULL(&to))
+		result->expr_ops = NULL;
+	else
+	{
+		const xpu_encode_info *encode = SESSION_ENCODE(kcxt->session);
+		int32_t		count = 0;
+		int32_t		pos = 0;
+		int32_t		prev;
+		int64_t		len;
+		char	   *buf;
+
+		if (!encode)
+		{
+			STROM_ELOG(kcxt, "No encoding info was supplied");
+			return false;
+		}
+		if (!xpu_text_is_valid(kcxt, &str) ||
+			!xpu_text_is_valid(kcxt, &from) ||
+			!xpu_text_is_valid(kcxt, &to))
+			return false;
+		result->expr_ops = &xpu_text_ops;
+		result->length = str.length;
+		result->value = str.value;
+		if (str.length == 0 || from.length == 0)
+			return true;
+		while ((pos = __text_search(encode, str.value, str.length, pos,
+									from.value, from.length)) >= 0)
+		{
+			pos += from.length;
+			count++;
+		}
+		if (count == 0)
+			return true;
+		len = (int64_t)str.length + (int64_t)count * (to.length - from.length);
+		if (len > INT_MAX)
+		{
+			STROM_CPU_FALLBACK(kcxt, "too large result of replace()");
+			return false;
+		}
+		buf = __text_result_alloc(kcxt, len);
+		if (!buf)
+			return false;
+		result->length = len;
+		result->value = buf;
+		prev = pos = 0;
+		while ((pos = __text_search(encode, str.value, str.length, pos,
+									from.value, from.length)) >= 0)
+		{
+			memcpy(buf, str.value + prev, pos - prev);
+			buf += (pos - prev);
+			memcpy(buf, to.value, to.length);
+			buf += to.length;
+			pos += from.length;
+			prev = pos;
+		}
+		memcpy(buf, str.value + prev, str.length - prev);
+	}
+	return true;
+}
+
+/*
+ * CoerceViaIO from text to the numeric data types
+ *
+ * These device functions accept the canonical representation only, like
+ * '  -1234  ' or '12.5e3'; anything else (hexadecimal / underscore notation
+ * of integers, 'NaN' or 'Infinity', and values that are not exactly
+ * convertible on the device) shall be processed by the CPU-fallback, to
+ * give exactly the same results and error messages as PostgreSQL's input
+ * functions.
+ */
+STATIC_FUNCTION(bool)
+__text_to_int64(kern_context *kcxt,
+				const xpu_text_t *str,
+				int64_t min_value,
+				int64_t max_value,
+				int64_t *p_ival)
+{
+	const char *pos = str->value;
+	const char *end = str->value + str->length;
+	bool		negative = false;
+	uint64_t	uval = 0;
+	uint64_t	limit;
+
+	while (pos < end && __text_isspace(*pos))
+		pos++;
+	if (pos < end && (*pos == '+' || *pos == '-'))
+		negative = (*pos++ == '-');
+	if (pos >= end || *pos < '0' || *pos > '9')
+		goto fallback;
+	limit = (negative ? (uint64_t)(-(min_value + 1)) + 1 : (uint64_t)max_value);
+	while (pos < end && *pos >= '0' && *pos <= '9')
+	{
+		int		dig = (*pos++ - '0');
+
+		if (uval > (limit - dig) / 10)
+			goto fallback;		/* out of range */
+		uval = 10 * uval + dig;
+	}
+	while (pos < end && __text_isspace(*pos))
+		pos++;
+	if (pos != end)
+		goto fallback;
+	*p_ival = (negative ? (int64_t)(0UL - uval) : (int64_t)uval);
+	return true;
+
+fallback:
+	STROM_CPU_FALLBACK(kcxt, "text is not a simple integer representation");
+	return false;
+}
+
+#define PG_TEXT_TO_INT_TEMPLATE(NAME,MIN_VALUE,MAX_VALUE)				\
+	PUBLIC_FUNCTION(bool)												\
+	pgfn_text_to_##NAME(XPU_PGFUNCTION_ARGS)							\
+	{																	\
+		KEXP_PROCESS_ARGS1(NAME, text, str);							\
+																		\
+		if (XPU_DATUM_ISNULL(&str))										\
+			result->expr_ops = NULL;									\
+		else															\
+		{																\
+			int64_t		ival;											\
+																		\
+			if (!xpu_text_is_valid(kcxt, &str) ||						\
+				!__text_to_int64(kcxt, &str, MIN_VALUE, MAX_VALUE, &ival)) \
+				return false;											\
+			result->expr_ops = &xpu_##NAME##_ops;						\
+			result->value = ival;										\
+		}																\
+		return true;													\
+	}
+PG_TEXT_TO_INT_TEMPLATE(int2, SHRT_MIN, SHRT_MAX)
+PG_TEXT_TO_INT_TEMPLATE(int4, INT_MIN,  INT_MAX)
+PG_TEXT_TO_INT_TEMPLATE(int8, LONG_MIN, LONG_MAX)
+
+/*
+ * __text_to_decimal - parses [ws][sign]digits[.digits][e[sign]digits][ws]
+ *
+ * It returns the significant digits (up to 38 digits) with the decimal
+ * exponent; the caller has to check whether the value is exactly
+ * convertible.
+ */
+STATIC_FUNCTION(bool)
+__text_to_decimal(const xpu_text_t *str,
+				  bool allow_exponent,
+				  bool *p_negative,
+				  int128_t *p_mantissa,
+				  int *p_ndigits,
+				  int *p_exp10)
+{
+	const char *pos = str->value;
+	const char *end = str->value + str->length;
+	bool		negative = false;
+	bool		has_digits = false;
+	int128_t	mantissa = 0;
+	int			ndigits = 0;
+	int			exp10 = 0;
+
+	while (pos < end && __text_isspace(*pos))
+		pos++;
+	if (pos < end && (*pos == '+' || *pos == '-'))
+		negative = (*pos++ == '-');
+	while (pos < end && *pos >= '0' && *pos <= '9')
+	{
+		has_digits = true;
+		if (mantissa != 0 || *pos != '0')
+		{
+			if (++ndigits > 38)
+				return false;
+			mantissa = 10 * mantissa + (*pos - '0');
+		}
+		pos++;
+	}
+	if (pos < end && *pos == '.')
+	{
+		pos++;
+		while (pos < end && *pos >= '0' && *pos <= '9')
+		{
+			has_digits = true;
+			if (mantissa != 0 || *pos != '0')
+			{
+				if (++ndigits > 38)
+					return false;
+			}
+			mantissa = 10 * mantissa + (*pos - '0');
+			exp10--;
+			pos++;
+		}
+	}
+	if (!has_digits)
+		return false;
+	if (pos < end && (*pos == 'e' || *pos == 'E'))
+	{
+		bool	exp_negative = false;
+		int		exp_value = 0;
+
+		if (!allow_exponent)
+			return false;
+		pos++;
+		if (pos < end && (*pos == '+' || *pos == '-'))
+			exp_negative = (*pos++ == '-');
+		if (pos >= end || *pos < '0' || *pos > '9')
+			return false;
+		while (pos < end && *pos >= '0' && *pos <= '9')
+		{
+			exp_value = 10 * exp_value + (*pos++ - '0');
+			if (exp_value > 1000)
+				return false;
+		}
+		exp10 += (exp_negative ? -exp_value : exp_value);
+	}
+	while (pos < end && __text_isspace(*pos))
+		pos++;
+	if (pos != end)
+		return false;
+	*p_negative = negative;
+	*p_mantissa = mantissa;
+	*p_ndigits  = ndigits;
+	*p_exp10    = exp10;
+	return true;
+}
+
+/*
+ * text -> float4/float8 uses the well-known fast path of the exact decimal
+ * conversion; if both of the mantissa and 10^exp10 are exactly representable
+ * in the floating-point type, one IEEE754 multiplication or division gives
+ * the correctly rounded result, as strtod() / strtof() doing.
+ */
+STATIC_DATA const double __exact_pow10_fp64[] = {
+	1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,
+	1e8,  1e9,  1e10, 1e11, 1e12, 1e13, 1e14, 1e15,
+	1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+STATIC_DATA const float __exact_pow10_fp32[] = {
+	1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f,
+	1e8f, 1e9f, 1e10f
+};
+
+PUBLIC_FUNCTION(bool)
+pgfn_text_to_float8(XPU_PGFUNCTION_ARGS)
+{
+	KEXP_PROCESS_ARGS1(float8, text, str);
+
+	if (XPU_DATUM_ISNULL(&str))
+		result->expr_ops = NULL;
+	else
+	{
+		bool		negative;
+		int128_t	mantissa;
+		int			ndigits;
+		int			exp10;
+		double		fval;
+
+		if (!xpu_text_is_valid(kcxt, &str))
+			return false;
+		if (!__text_to_decimal(&str, true, &negative,
+							   &mantissa, &ndigits, &exp10) ||
+			(mantissa != 0 && (mantissa > (1L << 53) ||
+							   exp10 < -22 || exp10 > 22)))
+		{
+			STROM_CPU_FALLBACK(kcxt, "text is not exactly convertible to float8");
+			return false;
+		}
+		fval = (double)((int64_t)mantissa);
+		if (exp10 > 0)
+			fval *= __exact_pow10_fp64[exp10];
+		else if (exp10 < 0)
+			fval /= __exact_pow10_fp64[-exp10];
+		result->expr_ops = &xpu_float8_ops;
+		result->value = (negative ? -fval : fval);
+	}
+	return true;
+}
+
+PUBLIC_FUNCTION(bool)
+pgfn_text_to_float4(XPU_PGFUNCTION_ARGS)
+{
+	KEXP_PROCESS_ARGS1(float4, text, str);
+
+	if (XPU_DATUM_ISNULL(&str))
+		result->expr_ops = NULL;
+	else
+	{
+		bool		negative;
+		int128_t	mantissa;
+		int			ndigits;
+		int			exp10;
+		float		fval;
+
+		if (!xpu_text_is_valid(kcxt, &str))
+			return false;
+		if (!__text_to_decimal(&str, true, &negative,
+							   &mantissa, &ndigits, &exp10) ||
+			(mantissa != 0 && (mantissa > (1L << 24) ||
+							   exp10 < -10 || exp10 > 10)))
+		{
+			STROM_CPU_FALLBACK(kcxt, "text is not exactly convertible to float4");
+			return false;
+		}
+		fval = (float)((int32_t)mantissa);
+		if (exp10 > 0)
+			fval *= __exact_pow10_fp32[exp10];
+		else if (exp10 < 0)
+			fval /= __exact_pow10_fp32[-exp10];
+		result->expr_ops = &xpu_float4_ops;
+		result->value = (negative ? -fval : fval);
+	}
+	return true;
+}
+
+/*
+ * text -> numeric keeps the number of fractional digits as the weight of
+ * xpu_numeric_t, so the display scale of the input (e.g, '1.50') is
+ * preserved as numeric_in() doing.
+ */
+PUBLIC_FUNCTION(bool)
+pgfn_text_to_numeric(XPU_PGFUNCTION_ARGS)
+{
+	KEXP_PROCESS_ARGS1(numeric, text, str);
+
+	if (XPU_DATUM_ISNULL(&str))
+		result->expr_ops = NULL;
+	else
+	{
+		bool		negative;
+		int128_t	mantissa;
+		int			ndigits;
+		int			exp10;
+
+		if (!xpu_text_is_valid(kcxt, &str))
+			return false;
+		if (!__text_to_decimal(&str, false, &negative,
+							   &mantissa, &ndigits, &exp10))
+		{
+			STROM_CPU_FALLBACK(kcxt, "text is not a simple numeric representation");
+			return false;
+		}
+		result->expr_ops = &xpu_numeric_ops;
+		result->kind     = XPU_NUMERIC_KIND__VALID;
+		result->weight   = -exp10;
+		result->u.value  = (negative ? -mantissa : mantissa);
+	}
+	return true;
+}
@@ -34,16 +34,123 @@ typedef struct xpu_encode_info	xpu_encode_info;
 
 EXTERN_DATA xpu_encode_info		xpu_encode_catalog[];
 
+/*
+ * Collation Weight Table
+ *
+ * It models a non-C collation by a pair of weights for each 7bit ASCII
+ * character; the primary weight (e.g, 'a' and 'A' are equivalent) and the
+ * tertiary weight (e.g, case of the letters). The weight table is built by
+ * the backend on the code generation time, and validated towards the real
+ * collation. Zero means the character is not supported by the model, so
+ * the comparison must be executed by CPU.
+ */
+#define KERN_COLLATE_NCHARS		128
+typedef struct
+{
+	uint8_t		primary[KERN_COLLATE_NCHARS];
+	uint8_t		tertiary[KERN_COLLATE_NCHARS];
+} kern_collate_weights;
+
+/*
+ * __collate_weight_comp
+ *
+ * It compares two strings according to the weight table; by the primary
+ * weights first, then the tertiary weights, and finally by binary as
+ * deterministic collations doing. It returns false if any characters are
+ * not supported by the weight table.
+ */
+INLINE_FUNCTION(bool)
+__collate_weight_comp(const kern_collate_weights *cw,
+					  int *p_comp,
+					  const char *s1, int len1,
+					  const char *s2, int len2)
+{
+	int		i, len = Min(len1, len2);
+	int		comp;
+
+	for (i=0; i < len1; i++)
+	{
+		uint8_t	c = (uint8_t)s1[i];
+
+		if (c >= KERN_COLLATE_NCHARS || cw->primary[c] == 0)
+			return false;
+	}
+	for (i=0; i < len2; i++)
+	{
+		uint8_t	c = (uint8_t)s2[i];
+
+		if (c >= KERN_COLLATE_NCHARS || cw->primary[c] == 0)
+			return false;
+	}
+	/* level-1: primary weights */
+	for (i=0; i < len; i++)
+	{
+		comp = ((int)cw->primary[(uint8_t)s1[i]] -
+				(int)cw->primary[(uint8_t)s2[i]]);
+		if (comp != 0)
+			goto out;
+	}
+	if (len1 != len2)
+	{
+		comp = (len1 < len2 ? -1 : 1);
+		goto out;
+	}
+	/* level-3: tertiary weights */
+	for (i=0; i < len; i++)
+	{
+		comp = ((int)cw->tertiary[(uint8_t)s1[i]] -
+				(int)cw->tertiary[(uint8_t)s2[i]]);
+		if (comp != 0)
+			goto out;
+	}
+	/* deterministic collation finally compares by binary */
+	comp = __memcmp(s1, s2, len);
+out:
+	*p_comp = (comp < 0 ? -1 : (comp > 0 ? 1 : 0));
+	return true;
+}
+
+/*
+ * Regular Expression DFA
+ *
+ * Regular expression pattern (must be a constant) is compiled to DFA by
+ * the backend, then embedded to the kern_expression. Its input symbol is
+ * either a 7bit ASCII character or any non-ASCII character; the latter is
+ * consumed according to the database encoding.
+ * A transition to KERN_REGEX_STATE__FALLBACK means the pattern cannot
+ * determine the match without locale (e.g, [[:alpha:]] on non-ASCII
+ * characters), thus the row must be processed by CPU fallback.
+ */
+#define KERN_REGEX_NSYMBOLS				129
+#define KERN_REGEX_SYMBOL__NONASCII		128
+#define KERN_REGEX_MAX_STATES			1024
+#define KERN_REGEX_MAX_TABLESZ			65536
+#define KERN_REGEX_STATE__FALLBACK		0xffffU
+#define KERN_REGEX_FLAG__MATCHED		0x01	/* already matched */
+#define KERN_REGEX_FLAG__ACCEPT_EOS		0x02	/* matched at end of string */
+#define KERN_REGEX_FLAG__DEAD			0x04	/* never matched */
+
 /*
  * validation checkers
+ *
+ * If datum is inline compressed, it is expanded on the kcxt buffer and
+ * @arg is updated to the decompressed image. External datum is not
+ * supported on the device, so it shall be processed by CPU fallback.
  */
 INLINE_FUNCTION(bool)
 xpu_bpchar_is_valid(kern_context *kcxt, const xpu_bpchar_t *arg)
 {
 	if (arg->length < 0)
 	{
-		STROM_CPU_FALLBACK(kcxt, "bpchar datum is compressed or external");
-		return false;
+		xpu_bpchar_t   *__arg = (xpu_bpchar_t *)arg;
+
+		if (!xpu_varlena_decompress(kcxt, &__arg->value, &__arg->length))
+		{
+			STROM_CPU_FALLBACK(kcxt, "bpchar datum is compressed or external");
+			return false;
+		}
+		while (__arg->length > 0 && __arg->value[__arg->length-1] == ' ')
+			__arg->length--;
 	}
 	return true;
 }
@@ -53,19 +160,59 @@ xpu_text_is_valid(kern_context *kcxt, const xpu_text_t *arg)
 {
 	if (arg->length < 0)
 	{
-		STROM_CPU_FALLBACK(kcxt, "text datum is compressed or external");
-		return false;
+		xpu_text_t	   *__arg = (xpu_text_t *)arg;
+
+		if (!xpu_varlena_decompress(kcxt, &__arg->value, &__arg->length))
+		{
+			STROM_CPU_FALLBACK(kcxt, "text datum is compressed or external");
+			return false;
+		}
 	}
 	return true;
 }
 
+/*
+ * String functions that build a new text (lower, upper, textcat, concat,
+ * replace, host, ...) write the results on the kcxt buffer; the code
+ * generator expands the buffer for them. If the result is larger than the
+ * remaining buffer, it shall be processed by the CPU-fallback.
+ */
+INLINE_FUNCTION(char *)
+__text_result_alloc(kern_context *kcxt, int32_t len)
+{
+	char   *pos = (char *)MAXALIGN(kcxt->vlpos);
+
+	if (pos + len > kcxt->vlend)
+	{
+		STROM_CPU_FALLBACK(kcxt, "out of kcxt memory for the text result");
+		return NULL;
+	}
+	kcxt->vlpos = pos + len;
+	return pos;
+}
+
+/*
+ * __text_isspace - same as isspace() in the C locale
+ */
+INLINE_FUNCTION(bool)
+__text_isspace(char c)
+{
+	return (c == ' '  || c == '\t' || c == '\n' ||
+			c == '\r' || c == '\v' || c == '\f');
+}
+
 INLINE_FUNCTION(bool)
 xpu_bytea_is_valid(kern_context *kcxt, const xpu_bytea_t *arg)
 {
 	if (arg->length < 0)
 	{
-		STROM_CPU_FALLBACK(kcxt, "bytea datum is compressed or external");
-		return false;
+		xpu_bytea_t	   *__arg = (xpu_bytea_t *)arg;
+
+		if (!xpu_varlena_decompress(kcxt, &__arg->value, &__arg->length))
+		{
+			STROM_CPU_FALLBACK(kcxt, "bytea datum is compressed or external");
+			return false;
+		}
 	}
 	return true;
 }
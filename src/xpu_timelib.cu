@@ -3855,3 +3855,664 @@ pgfn_extract_interval(XPU_PGFUNCTION_ARGS)
 	}
 	return true;
 }
+
+/*
+ * date_trunc
+ */
+STATIC_FUNCTION(int)
+isoweek2j(int year, int week)
+{
+	int		day0, day4;
+
+	/* fourth day of current year */
+	day4 = date2j(year, 1, 4);
+	/* day0 == offset to first day of week (Monday) */
+	day0 = j2day(day4 - 1);
+
+	return ((week - 1) * 7) + (day4 - day0);
+}
+
+STATIC_FUNCTION(bool)
+__pg_date_trunc_timestamp_common(kern_context *kcxt,
+								 Timestamp *p_result,
+								 const xpu_text_t *key,
+								 Timestamp ts,
+								 const pg_tz *tz_info)
+{
+	struct pg_tm tm;
+	fsec_t		fsec;
+	int			type, value;
+	int			tz;
+	bool		redotz = false;
+
+	if (!extract_decode_unit(kcxt, key, &type, &value))
+		return false;
+	if (type != UNITS)
+	{
+		STROM_ELOG(kcxt, "unit is not recognized for timestamp");
+		return false;
+	}
+	if (!timestamp2tm(ts, &tm, &fsec, tz_info))
+	{
+		STROM_ELOG(kcxt, "timestamp out of range");
+		return false;
+	}
+	/* see timestamp_trunc() and timestamptz_trunc_internal() */
+	switch (value)
+	{
+		case DTK_WEEK:
+			{
+				int		woy = date2isoweek(tm.tm_year, tm.tm_mon, tm.tm_mday);
+
+				/*
+				 * If it is week 52/53 and the month is January, then the
+				 * week must belong to the previous year. Also, some
+				 * December dates belong to the next year.
+				 */
+				if (woy >= 52 && tm.tm_mon == 1)
+					--tm.tm_year;
+				if (woy <= 1 && tm.tm_mon == MONTHS_PER_YEAR)
+					++tm.tm_year;
+				j2date(isoweek2j(tm.tm_year, woy),
+					   &tm.tm_year, &tm.tm_mon, &tm.tm_mday);
+				tm.tm_hour = 0;
+				tm.tm_min = 0;
+				tm.tm_sec = 0;
+				fsec = 0;
+				redotz = true;
+			}
+			break;
+		case DTK_MILLENNIUM:
+			/* see comments in timestamptz_trunc */
+			if (tm.tm_year > 0)
+				tm.tm_year = ((tm.tm_year + 999) / 1000) * 1000 - 999;
+			else
+				tm.tm_year = -((999 - (tm.tm_year - 1)) / 1000) * 1000 + 1;
+			/* FALLTHROUGH */
+		case DTK_CENTURY:
+			/* see comments in timestamptz_trunc */
+			if (tm.tm_year > 0)
+				tm.tm_year = ((tm.tm_year + 99) / 100) * 100 - 99;
+			else
+				tm.tm_year = -((99 - (tm.tm_year - 1)) / 100) * 100 + 1;
+			/* FALLTHROUGH */
+		case DTK_DECADE:
+			/* see comments in timestamptz_trunc */
+			if (value != DTK_MILLENNIUM && value != DTK_CENTURY)
+			{
+				if (tm.tm_year > 0)
+					tm.tm_year = (tm.tm_year / 10) * 10;
+				else
+					tm.tm_year = -((8 - (tm.tm_year - 1)) / 10) * 10;
+			}
+			/* FALLTHROUGH */
+		case DTK_YEAR:
+			tm.tm_mon = 1;
+			/* FALLTHROUGH */
+		case DTK_QUARTER:
+			tm.tm_mon = (3 * ((tm.tm_mon - 1) / 3)) + 1;
+			/* FALLTHROUGH */
+		case DTK_MONTH:
+			tm.tm_mday = 1;
+			/* FALLTHROUGH */
+		case DTK_DAY:
+			tm.tm_hour = 0;
+			redotz = true;	/* for all cases >= DAY */
+			/* FALLTHROUGH */
+		case DTK_HOUR:
+			tm.tm_min = 0;
+			/* FALLTHROUGH */
+		case DTK_MINUTE:
+			tm.tm_sec = 0;
+			/* FALLTHROUGH */
+		case DTK_SECOND:
+			fsec = 0;
+			break;
+		case DTK_MILLISEC:
+			fsec = (fsec / 1000) * 1000;
+			break;
+		case DTK_MICROSEC:
+			break;
+		default:
+			STROM_ELOG(kcxt, "unit is not supported for timestamp");
+			return false;
+	}
+	if (!tz_info)
+	{
+		if (!tm2timestamp(p_result, &tm, fsec, NULL))
+		{
+			STROM_ELOG(kcxt, "timestamp out of range");
+			return false;
+		}
+	}
+	else
+	{
+		if (redotz)
+			tz = DetermineTimeZoneOffset(&tm, tz_info);
+		else
+			tz = -tm.tm_gmtoff;
+		if (!tm2timestamp(p_result, &tm, fsec, &tz))
+		{
+			STROM_ELOG(kcxt, "timestamp out of range");
+			return false;
+		}
+	}
+	return true;
+}
+
+PUBLIC_FUNCTION(bool)
+pgfn_date_trunc_timestamp(XPU_PGFUNCTION_ARGS)
+{
+	KEXP_PROCESS_ARGS2(timestamp, text, key, timestamp, tval);
+
+	if (XPU_DATUM_ISNULL(&key) || XPU_DATUM_ISNULL(&tval))
+		result->expr_ops = NULL;
+	else if (TIMESTAMP_NOT_FINITE(tval.value))
+	{
+		result->expr_ops = &xpu_timestamp_ops;
+		result->value = tval.value;
+	}
+	else if (!xpu_text_is_valid(kcxt, &key) ||
+			 !__pg_date_trunc_timestamp_common(kcxt, &result->value,
+											   &key, tval.value, NULL))
+	{
+		assert(kcxt->errcode != 0);
+		return false;
+	}
+	else
+	{
+		result->expr_ops = &xpu_timestamp_ops;
+	}
+	return true;
+}
+
+PUBLIC_FUNCTION(bool)
+pgfn_date_trunc_timestamptz(XPU_PGFUNCTION_ARGS)
+{
+	KEXP_PROCESS_ARGS2(timestamptz, text, key, timestamptz, tval);
+
+	if (XPU_DATUM_ISNULL(&key) || XPU_DATUM_ISNULL(&tval))
+		result->expr_ops = NULL;
+	else if (TIMESTAMP_NOT_FINITE(tval.value))
+	{
+		result->expr_ops = &xpu_timestamptz_ops;
+		result->value = tval.value;
+	}
+	else if (!xpu_text_is_valid(kcxt, &key) ||
+			 !__pg_date_trunc_timestamp_common(kcxt, &result->value,
+											   &key, tval.value,
+											   SESSION_TIMEZONE(kcxt->session)))
+	{
+		assert(kcxt->errcode != 0);
+		return false;
+	}
+	else
+	{
+		result->expr_ops = &xpu_timestamptz_ops;
+	}
+	return true;
+}
+
+PUBLIC_FUNCTION(bool)
+pgfn_date_trunc_interval(XPU_PGFUNCTION_ARGS)
+{
+	int		type, value;
+	KEXP_PROCESS_ARGS2(interval, text, key, interval, ival);
+
+	if (XPU_DATUM_ISNULL(&key) || XPU_DATUM_ISNULL(&ival))
+		result->expr_ops = NULL;
+	else if (!xpu_text_is_valid(kcxt, &key) ||
+			 !extract_decode_unit(kcxt, &key, &type, &value))
+	{
+		assert(kcxt->errcode != 0);
+		return false;
+	}
+	else if (type != UNITS)
+	{
+		STROM_ELOG(kcxt, "unit is not recognized for interval");
+		return false;
+	}
+	else
+	{
+		/* see interval2itm() and interval_trunc() */
+		TimeOffset	time;
+		int64_t		tm_year, tm_mon, tm_mday;
+		int64_t		tm_hour, tm_min, tm_sec, tm_usec;
+
+		tm_year = ival.value.month / MONTHS_PER_YEAR;
+		tm_mon  = ival.value.month % MONTHS_PER_YEAR;
+		tm_mday = ival.value.day;
+		time    = ival.value.time;
+		tm_hour = time / USECS_PER_HOUR;
+		time   -= tm_hour * USECS_PER_HOUR;
+		tm_min  = time / USECS_PER_MINUTE;
+		time   -= tm_min * USECS_PER_MINUTE;
+		tm_sec  = time / USECS_PER_SEC;
+		tm_usec = time - tm_sec * USECS_PER_SEC;
+
+		switch (value)
+		{
+			case DTK_MILLENNIUM:
+				/* caution: C division may have negative remainder */
+				tm_year = (tm_year / 1000) * 1000;
+				/* FALLTHROUGH */
+			case DTK_CENTURY:
+				tm_year = (tm_year / 100) * 100;
+				/* FALLTHROUGH */
+			case DTK_DECADE:
+				tm_year = (tm_year / 10) * 10;
+				/* FALLTHROUGH */
+			case DTK_YEAR:
+				tm_mon = 0;
+				/* FALLTHROUGH */
+			case DTK_QUARTER:
+				tm_mon = 3 * (tm_mon / 3);
+				/* FALLTHROUGH */
+			case DTK_MONTH:
+				tm_mday = 0;
+				/* FALLTHROUGH */
+			case DTK_DAY:
+				tm_hour = 0;
+				/* FALLTHROUGH */
+			case DTK_HOUR:
+				tm_min = 0;
+				/* FALLTHROUGH */
+			case DTK_MINUTE:
+				tm_sec = 0;
+				/* FALLTHROUGH */
+			case DTK_SECOND:
+				tm_usec = 0;
+				break;
+			case DTK_MILLISEC:
+				tm_usec = (tm_usec / 1000) * 1000;
+				break;
+			case DTK_MICROSEC:
+				break;
+			default:
+				STROM_ELOG(kcxt, "unit is not supported for interval");
+				return false;
+		}
+		/* see itm2interval() */
+		result->expr_ops = &xpu_interval_ops;
+		result->value.month = tm_year * MONTHS_PER_YEAR + tm_mon;
+		result->value.day   = tm_mday;
+		result->value.time  = (((tm_hour * MINS_PER_HOUR +
+								 tm_min) * SECS_PER_MINUTE +
+								tm_sec) * USECS_PER_SEC + tm_usec);
+	}
+	return true;
+}
+
+/*
+ * date_bin
+ */
+INLINE_FUNCTION(bool)
+__pg_add_s64_overflow(int64_t a, int64_t b, int64_t *result)
+{
+	if ((b > 0 && a > LONG_MAX - b) ||
+		(b < 0 && a < LONG_MIN - b))
+		return true;
+	*result = a + b;
+	return false;
+}
+
+INLINE_FUNCTION(bool)
+__pg_sub_s64_overflow(int64_t a, int64_t b, int64_t *result)
+{
+	if ((b < 0 && a > LONG_MAX + b) ||
+		(b > 0 && a < LONG_MIN + b))
+		return true;
+	*result = a - b;
+	return false;
+}
+
+STATIC_FUNCTION(bool)
+__pg_date_bin_common(kern_context *kcxt,
+					 Timestamp *p_result,
+					 const Interval *stride,
+					 Timestamp ts,
+					 Timestamp origin)
+{
+	int64_t		stride_usecs;
+	int64_t		tm_diff;
+	int64_t		tm_modulo;
+	Timestamp	result;
+
+	if (TIMESTAMP_NOT_FINITE(origin))
+	{
+		STROM_ELOG(kcxt, "origin out of range");
+		return false;
+	}
+	if (stride->month != 0)
+	{
+		STROM_ELOG(kcxt, "timestamps cannot be binned into intervals containing months or years");
+		return false;
+	}
+	if (stride->day > LONG_MAX / USECS_PER_DAY ||
+		stride->day < LONG_MIN / USECS_PER_DAY ||
+		__pg_add_s64_overflow((int64_t)stride->day * USECS_PER_DAY,
+							  stride->time, &stride_usecs))
+	{
+		STROM_ELOG(kcxt, "interval out of range");
+		return false;
+	}
+	if (stride_usecs <= 0)
+	{
+		STROM_ELOG(kcxt, "stride must be greater than zero");
+		return false;
+	}
+	if (__pg_sub_s64_overflow(ts, origin, &tm_diff))
+	{
+		STROM_ELOG(kcxt, "interval out of range");
+		return false;
+	}
+	/* these calculations cannot overflow */
+	tm_modulo = tm_diff % stride_usecs;
+	result = origin + (tm_diff - tm_modulo);
+	/* round towards -infinity, not 0, if tm_diff is negative */
+	if (tm_diff < 0 && tm_modulo != 0)
+	{
+		if (__pg_sub_s64_overflow(result, stride_usecs, &result))
+		{
+			STROM_ELOG(kcxt, "timestamp out of range");
+			return false;
+		}
+	}
+	if (!IS_VALID_TIMESTAMP(result))
+	{
+		STROM_ELOG(kcxt, "timestamp out of range");
+		return false;
+	}
+	*p_result = result;
+	return true;
+}
+
+PUBLIC_FUNCTION(bool)
+pgfn_date_bin_timestamp(XPU_PGFUNCTION_ARGS)
+{
+	KEXP_PROCESS_ARGS3(timestamp,
+					   interval, stride,
+					   timestamp, tval,
+					   timestamp, origin);
+
+	if (XPU_DATUM_ISNULL(&stride) ||
+		XPU_DATUM_ISNULL(&tval) ||
+		XPU_DATUM_ISNULL(&origin))
+		result->expr_ops = NULL;
+	else if (TIMESTAMP_NOT_FINITE(tval.value))
+	{
+		result->expr_ops = &xpu_timestamp_ops;
+		result->value = tval.value;
+	}
+	else if (!__pg_date_bin_common(kcxt, &result->value,
+								   &stride.value,
+								   tval.value,
+								   origin.value))
+	{
+		assert(kcxt->errcode != 0);
+		return false;
+	}
+	else
+	{
+		result->expr_ops = &xpu_timestamp_ops;
+	}
+	return true;
+}
+
+PUBLIC_FUNCTION(bool)
+pgfn_date_bin_timestamptz(XPU_PGFUNCTION_ARGS)
+{
+	KEXP_PROCESS_ARGS3(timestamptz,
+					   interval, stride,
+					   timestamptz, tval,
+					   timestamptz, origin);
+
+	if (XPU_DATUM_ISNULL(&stride) ||
+		XPU_DATUM_ISNULL(&tval) ||
+		XPU_DATUM_ISNULL(&origin))
+		result->expr_ops = NULL;
+	else if (TIMESTAMP_NOT_FINITE(tval.value))
+	{
+		result->expr_ops = &xpu_timestamptz_ops;
+		result->value = tval.value;
+	}
+	else if (!__pg_date_bin_common(kcxt, &result->value,
+								   &stride.value,
+								   tval.value,
+								   origin.value))
+	{
+		assert(kcxt->errcode != 0);
+		return false;
+	}
+	else
+	{
+		result->expr_ops = &xpu_timestamptz_ops;
+	}
+	return true;
+}
+
+/*
+ * AT TIME ZONE with interval
+ */
+PUBLIC_FUNCTION(bool)
+pgfn_timestamp_izone(XPU_PGFUNCTION_ARGS)
+{
+	KEXP_PROCESS_ARGS2(timestamptz, interval, zone, timestamp, tval);
+
+	if (XPU_DATUM_ISNULL(&zone) || XPU_DATUM_ISNULL(&tval))
+		result->expr_ops = NULL;
+	else if (TIMESTAMP_NOT_FINITE(tval.value))
+	{
+		result->expr_ops = &xpu_timestamptz_ops;
+		result->value = tval.value;
+	}
+	else if (zone.value.month != 0 || zone.value.day != 0)
+	{
+		STROM_ELOG(kcxt, "interval time zone must not include months or days");
+		return false;
+	}
+	else
+	{
+		int		tz = zone.value.time / USECS_PER_SEC;
+
+		/* dt2local(timestamp, tz) */
+		result->expr_ops = &xpu_timestamptz_ops;
+		result->value = tval.value - tz * USECS_PER_SEC;
+		if (!IS_VALID_TIMESTAMP(result->value))
+		{
+			STROM_ELOG(kcxt, "timestamp out of range");
+			return false;
+		}
+	}
+	return true;
+}
+
+PUBLIC_FUNCTION(bool)
+pgfn_timestamptz_izone(XPU_PGFUNCTION_ARGS)
+{
+	KEXP_PROCESS_ARGS2(timestamp, interval, zone, timestamptz, tval);
+
+	if (XPU_DATUM_ISNULL(&zone) || XPU_DATUM_ISNULL(&tval))
+		result->expr_ops = NULL;
+	else if (TIMESTAMP_NOT_FINITE(tval.value))
+	{
+		result->expr_ops = &xpu_timestamp_ops;
+		result->value = tval.value;
+	}
+	else if (zone.value.month != 0 || zone.value.day != 0)
+	{
+		STROM_ELOG(kcxt, "interval time zone must not include months or days");
+		return false;
+	}
+	else
+	{
+		int		tz = -(zone.value.time / USECS_PER_SEC);
+
+		/* dt2local(timestamp, tz) */
+		result->expr_ops = &xpu_timestamp_ops;
+		result->value = tval.value - tz * USECS_PER_SEC;
+		if (!IS_VALID_TIMESTAMP(result->value))
+		{
+			STROM_ELOG(kcxt, "timestamp out of range");
+			return false;
+		}
+	}
+	return true;
+}
+
+/*
+ * CoerceViaIO from text to date/timestamp
+ *
+ * Only ISO 8601 form ('YYYY-MM-DD', and 'HH:MI[:SS[.ffffff]]' separated by
+ * a space or 'T' for timestamp) is parsed on the device, because 4-digits
+ * year at the head is interpreted regardless of the DateStyle.
+ * Other forms, special values like 'infinity', BC dates, and fractions
+ * finer than microseconds are processed by the CPU-fallback.
+ */
+STATIC_FUNCTION(bool)
+__text_parse_digits(const char **p_pos, const char *end,
+					int min_width, int max_width, int *p_value)
+{
+	const char *pos = *p_pos;
+	int			value = 0;
+	int			width = 0;
+
+	while (pos < end && *pos >= '0' && *pos <= '9' && width < max_width)
+	{
+		value = 10 * value + (*pos++ - '0');
+		width++;
+	}
+	if (width < min_width || (pos < end && *pos >= '0' && *pos <= '9'))
+		return false;
+	*p_pos = pos;
+	*p_value = value;
+	return true;
+}
+
+STATIC_FUNCTION(bool)
+__text_parse_iso_date(const char **p_pos, const char *end, DateADT *p_date)
+{
+	const char *pos = *p_pos;
+	int			year, mon, mday;
+
+	if (!__text_parse_digits(&pos, end, 4, 4, &year) ||
+		pos >= end || *pos++ != '-' ||
+		!__text_parse_digits(&pos, end, 1, 2, &mon) ||
+		pos >= end || *pos++ != '-' ||
+		!__text_parse_digits(&pos, end, 1, 2, &mday))
+		return false;
+	if (year < 1 || mon < 1 || mon > MONTHS_PER_YEAR ||
+		mday < 1 || mday > day_tab[isleap(year)][mon - 1])
+		return false;
+	*p_pos = pos;
+	*p_date = date2j(year, mon, mday) - POSTGRES_EPOCH_JDATE;
+	return true;
+}
+
+PUBLIC_FUNCTION(bool)
+pgfn_text_to_date(XPU_PGFUNCTION_ARGS)
+{
+	KEXP_PROCESS_ARGS1(date, text, str);
+
+	if (XPU_DATUM_ISNULL(&str))
+		result->expr_ops = NULL;
+	else
+	{
+		const char *pos;
+		const char *end;
+		DateADT		date;
+
+		if (!xpu_text_is_valid(kcxt, &str))
+			return false;
+		pos = str.value;
+		end = str.value + str.length;
+		while (pos < end && __text_isspace(*pos))
+			pos++;
+		if (!__text_parse_iso_date(&pos, end, &date))
+			goto fallback;
+		while (pos < end && __text_isspace(*pos))
+			pos++;
+		if (pos != end)
+			goto fallback;
+		result->expr_ops = &xpu_date_ops;
+		result->value = date;
+	}
+	return true;
+
+fallback:
+	STROM_CPU_FALLBACK(kcxt, "text is not an ISO 8601 date representation");
+	return false;
+}
+
+PUBLIC_FUNCTION(bool)
+pgfn_text_to_timestamp(XPU_PGFUNCTION_ARGS)
+{
+	KEXP_PROCESS_ARGS1(timestamp, text, str);
+
+	if (XPU_DATUM_ISNULL(&str))
+		result->expr_ops = NULL;
+	else
+	{
+		const char *pos;
+		const char *end;
+		DateADT		date;
+		int			hour = 0;
+		int			min = 0;
+		int			sec = 0;
+		int			usec = 0;
+
+		if (!xpu_text_is_valid(kcxt, &str))
+			return false;
+		pos = str.value;
+		end = str.value + str.length;
+		while (pos < end && __text_isspace(*pos))
+			pos++;
+		if (!__text_parse_iso_date(&pos, end, &date))
+			goto fallback;
+		if (pos < end && (*pos == ' ' || *pos == 'T') &&
+			pos + 1 < end && pos[1] >= '0' && pos[1] <= '9')
+		{
+			pos++;
+			if (!__text_parse_digits(&pos, end, 1, 2, &hour) ||
+				pos >= end || *pos++ != ':' ||
+				!__text_parse_digits(&pos, end, 2, 2, &min))
+				goto fallback;
+			if (pos < end && *pos == ':')
+			{
+				pos++;
+				if (!__text_parse_digits(&pos, end, 2, 2, &sec))
+					goto fallback;
+				if (pos < end && *pos == '.')
+				{
+					int		width = 0;
+
+					pos++;
+					while (pos < end && *pos >= '0' && *pos <= '9')
+					{
+						if (++width > 6)
+							goto fallback;
+						usec = 10 * usec + (*pos++ - '0');
+					}
+					while (width++ < 6)
+						usec *= 10;
+				}
+			}
+			if (hour >= HOURS_PER_DAY || min >= MINS_PER_HOUR || sec >= SECS_PER_MINUTE)
+				goto fallback;
+		}
+		while (pos < end && __text_isspace(*pos))
+			pos++;
+		if (pos != end)
+			goto fallback;
+		result->expr_ops = &xpu_timestamp_ops;
+		result->value = ((int64_t)date * USECS_PER_DAY +
+						 (int64_t)hour * USECS_PER_HOUR +
+						 (int64_t)min * USECS_PER_MINUTE +
+						 (int64_t)sec * USECS_PER_SEC + usec);
+	}
+	return true;
+
+fallback:
+	STROM_CPU_FALLBACK(kcxt, "text is not an ISO 8601 timestamp representation");
+	return false;
+}
@@ -0,0 +1,1276 @@
+/*
+ * zonemap.c
+ *
+ * Block-range zone map of heap tables maintained by PG-Strom.
+ *
+ * A zone map keeps min/max values and null counts of the configured
+ * columns for each range of blocks, then GPU/DPU scans skip the block
+ * ranges that never match the scan qualifiers, like BRIN-index without
+ * the index. It is built and incrementally refreshed by SQL functions,
+ * and pgstrom.zonemap_sync_trigger() widens the summarized ranges
+ * according to the INSERT/UPDATE. Zone map is held on the dynamic shared
+ * memory segment, so it has to be built again after the restart.
+ * ----
+ * Copyright 2011-2023 (C) KaiGai Kohei <kaigai@kaigai.gr.jp>
+ * Copyright 2014-2023 (C) PG-Strom Developers Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the PostgreSQL License.
+ */
+#include "pg_strom.h"
+
+#define ZONEMAP_MAX_COLUMNS			8
+#define ZONEMAP_RANGE__VALID		0x0001	/* summarized */
+#define ZONEMAP_RANGE__BUILDING		0x0002	/* under summarization */
+
+#define ZONEMAP_TYPE__INT			1	/* int2, int4, int8 */
+#define ZONEMAP_TYPE__FLOAT			2	/* float4, float8 */
+#define ZONEMAP_TYPE__DATE			3
+#define ZONEMAP_TYPE__TIMESTAMP		4
+#define ZONEMAP_TYPE__TIMESTAMPTZ	5
+#define ZONEMAP_TYPE__OID			6
+
+/* normalized value of the zone map */
+typedef union
+{
+	int64_t		ival;
+	double		fval;
+} zoneMapKey;
+
+typedef struct
+{
+	zoneMapKey	min_value;
+	zoneMapKey	max_value;
+	uint32_t	nnulls;
+	uint32_t	nvalues;
+} zoneMapValue;
+
+typedef struct
+{
+	uint32_t	flags;			/* ZONEMAP_RANGE__* */
+	zoneMapValue values[FLEXIBLE_ARRAY_MEMBER];
+} zoneMapRange;
+
+/*
+ * zoneMapHead - head of the DSM segment for each table
+ */
+typedef struct
+{
+	slock_t		lock;			/* lock of the range updates */
+	Oid			relfilenode;	/* zone map is invalid if rewritten */
+	uint32_t	range_pages;	/* number of blocks per range */
+	uint32_t	nrooms;			/* capacity of the ranges */
+	int			ncols;
+	AttrNumber	attnums[ZONEMAP_MAX_COLUMNS];
+	int			typclass[ZONEMAP_MAX_COLUMNS];
+	char		data[FLEXIBLE_ARRAY_MEMBER];
+} zoneMapHead;
+
+#define ZONEMAP_RANGE_SZ(ncols)							\
+	MAXALIGN(offsetof(zoneMapRange, values[(ncols)]))
+#define ZONEMAP_GET_RANGE(zm_head, index)				\
+	((zoneMapRange *)((zm_head)->data +					\
+					  ZONEMAP_RANGE_SZ((zm_head)->ncols) * (size_t)(index)))
+
+/*
+ * zoneMapSlot - registration of zone maps on the shared memory
+ */
+typedef struct
+{
+	LWLock		lock;			/* lock of the segment replacement */
+	Oid			database_oid;
+	Oid			table_oid;		/* InvalidOid, if unused */
+	uint32_t	generation;		/* incremented for each replacement */
+	dsm_handle	handle;
+} zoneMapSlot;
+
+typedef struct
+{
+	LWLock		lock;			/* lock of the slot assignment */
+	int			nslots;
+	zoneMapSlot	slots[FLEXIBLE_ARRAY_MEMBER];
+} zoneMapSharedHead;
+
+/* per-backend mapping of the segment */
+typedef struct
+{
+	uint32_t	generation;
+	dsm_segment *seg;
+} zoneMapLocal;
+
+/*
+ * zoneMapCond - qualifier that can be checked with the zone map
+ */
+typedef struct
+{
+	int			cindex;			/* column index of the zone map */
+	int			strategy;		/* BTxxxStrategyNumber, or 0 if NullTest */
+	NullTestType nulltesttype;
+	zoneMapKey	key;
+} zoneMapCond;
+
+/*
+ * zoneMapState - executor state of the zone map
+ */
+struct zoneMapState
+{
+	uint32_t	range_pages;
+	uint32_t	nranges;
+	uint32_t	nskipped;
+	uint8_t	   *skip_map;		/* bitmap of the ranges to be skipped */
+	List	   *colnames;		/* for EXPLAIN */
+};
+
+/* static variables */
+static shmem_request_hook_type shmem_request_next = NULL;
+static shmem_startup_hook_type shmem_startup_next = NULL;
+static zoneMapSharedHead *zone_map_shared = NULL;
+static zoneMapLocal *zone_map_local = NULL;
+static Oid		__zonemap_sync_trigger_function_oid = InvalidOid;
+static bool		pgstrom_enable_zonemap;			/* GUC */
+static int		pgstrom_zonemap_max_relations;	/* GUC */
+
+/*
+ * Routines to handle the normalized values
+ */
+static int
+__zoneMapTypeClass(Oid type_oid)
+{
+	switch (type_oid)
+	{
+		case INT2OID:
+		case INT4OID:
+		case INT8OID:
+			return ZONEMAP_TYPE__INT;
+		case FLOAT4OID:
+		case FLOAT8OID:
+			return ZONEMAP_TYPE__FLOAT;
+		case DATEOID:
+			return ZONEMAP_TYPE__DATE;
+		case TIMESTAMPOID:
+			return ZONEMAP_TYPE__TIMESTAMP;
+		case TIMESTAMPTZOID:
+			return ZONEMAP_TYPE__TIMESTAMPTZ;
+		case OIDOID:
+			return ZONEMAP_TYPE__OID;
+		default:
+			break;
+	}
+	return 0;	/* not supported */
+}
+
+static zoneMapKey
+__zoneMapDatumToKey(Oid type_oid, Datum datum)
+{
+	zoneMapKey	key;
+
+	switch (type_oid)
+	{
+		case INT2OID:
+			key.ival = DatumGetInt16(datum);
+			break;
+		case INT4OID:
+			key.ival = DatumGetInt32(datum);
+			break;
+		case INT8OID:
+			key.ival = DatumGetInt64(datum);
+			break;
+		case FLOAT4OID:
+			key.fval = DatumGetFloat4(datum);
+			break;
+		case FLOAT8OID:
+			key.fval = DatumGetFloat8(datum);
+			break;
+		case DATEOID:
+			key.ival = DatumGetDateADT(datum);
+			break;
+		case TIMESTAMPOID:
+			key.ival = DatumGetTimestamp(datum);
+			break;
+		case TIMESTAMPTZOID:
+			key.ival = DatumGetTimestampTz(datum);
+			break;
+		case OIDOID:
+			key.ival = DatumGetObjectId(datum);
+			break;
+		default:
+			elog(ERROR, "zone map does not support type %s",
+				 format_type_be(type_oid));
+	}
+	return key;
+}
+
+static int
+__zoneMapKeyCompare(int typclass, zoneMapKey a, zoneMapKey b)
+{
+	if (typclass == ZONEMAP_TYPE__FLOAT)
+	{
+		/* NaN is larger than any other values, like float8_cmp_internal */
+		if (isnan(a.fval))
+			return (isnan(b.fval) ? 0 : 1);
+		if (isnan(b.fval))
+			return -1;
+		if (a.fval < b.fval)
+			return -1;
+		return (a.fval > b.fval ? 1 : 0);
+	}
+	if (a.ival < b.ival)
+		return -1;
+	return (a.ival > b.ival ? 1 : 0);
+}
+
+static void
+__zoneMapValueMerge(int typclass, zoneMapValue *dst, const zoneMapValue *src)
+{
+	if (src->nvalues > 0)
+	{
+		if (dst->nvalues == 0)
+		{
+			dst->min_value = src->min_value;
+			dst->max_value = src->max_value;
+		}
+		else
+		{
+			if (__zoneMapKeyCompare(typclass, src->min_value, dst->min_value) < 0)
+				dst->min_value = src->min_value;
+			if (__zoneMapKeyCompare(typclass, src->max_value, dst->max_value) > 0)
+				dst->max_value = src->max_value;
+		}
+		dst->nvalues += src->nvalues;
+	}
+	dst->nnulls += src->nnulls;
+}
+
+static void
+__zoneMapValueAccum(zoneMapHead *zm_head, zoneMapValue *values,
+					Relation rel, HeapTuple tuple)
+{
+	TupleDesc	tupdesc = RelationGetDescr(rel);
+
+	for (int j=0; j < zm_head->ncols; j++)
+	{
+		AttrNumber	anum = zm_head->attnums[j];
+		zoneMapValue temp;
+		Datum		datum;
+		bool		isnull;
+
+		memset(&temp, 0, sizeof(zoneMapValue));
+		datum = heap_getattr(tuple, anum, tupdesc, &isnull);
+		if (isnull)
+			temp.nnulls = 1;
+		else
+		{
+			Oid		type_oid = TupleDescAttr(tupdesc, anum-1)->atttypid;
+
+			temp.min_value = temp.max_value = __zoneMapDatumToKey(type_oid, datum);
+			temp.nvalues = 1;
+		}
+		__zoneMapValueMerge(zm_head->typclass[j], &values[j], &temp);
+	}
+}
+
+/*
+ * zonemap_sync_trigger_function_oid
+ */
+static Oid
+zonemap_sync_trigger_function_oid(void)
+{
+	if (!OidIsValid(__zonemap_sync_trigger_function_oid))
+	{
+		Oid			namespace_oid;
+		oidvector	argtypes;
+
+		namespace_oid = get_namespace_oid("pgstrom", true);
+		if (!OidIsValid(namespace_oid))
+			return InvalidOid;
+
+		memset(&argtypes, 0, sizeof(oidvector));
+		SET_VARSIZE(&argtypes, offsetof(oidvector, values[0]));
+		argtypes.ndim = 1;
+		argtypes.dataoffset = 0;
+		argtypes.elemtype = OIDOID;
+		argtypes.dim1 = 0;
+		argtypes.lbound1 = 0;
+
+		__zonemap_sync_trigger_function_oid
+			= GetSysCacheOid3(PROCNAMEARGSNSP,
+							  Anum_pg_proc_oid,
+							  CStringGetDatum("zonemap_sync_trigger"),
+							  PointerGetDatum(&argtypes),
+							  ObjectIdGetDatum(namespace_oid));
+	}
+	return __zonemap_sync_trigger_function_oid;
+}
+
+/*
+ * __zoneMapHasSyncTrigger
+ *
+ * Zone map is reliable only if INSERT/UPDATE are tracked by the sync trigger.
+ */
+static bool
+__zoneMapHasSyncTrigger(Relation rel)
+{
+	TriggerDesc *trigdesc = rel->trigdesc;
+	Oid			tgfoid = zonemap_sync_trigger_function_oid();
+
+	if (!trigdesc || !OidIsValid(tgfoid))
+		return false;
+	for (int j=0; j < trigdesc->numtriggers; j++)
+	{
+		Trigger	   *trig = &trigdesc->triggers[j];
+		int16		mask = (TRIGGER_TYPE_ROW |
+							TRIGGER_TYPE_AFTER |
+							TRIGGER_TYPE_INSERT |
+							TRIGGER_TYPE_UPDATE);
+
+		if ((trig->tgenabled == TRIGGER_FIRES_ON_ORIGIN ||
+			 trig->tgenabled == TRIGGER_FIRES_ALWAYS) &&
+			(trig->tgtype & mask) == mask &&
+			trig->tgfoid == tgfoid)
+			return true;
+	}
+	return false;
+}
+
+/*
+ * __zoneMapLookupSlot - caller must hold zone_map_shared->lock
+ */
+static int
+__zoneMapLookupSlot(Oid table_oid)
+{
+	for (int i=0; i < zone_map_shared->nslots; i++)
+	{
+		zoneMapSlot *slot = &zone_map_shared->slots[i];
+
+		if (slot->database_oid == MyDatabaseId &&
+			slot->table_oid == table_oid)
+			return i;
+	}
+	return -1;
+}
+
+/*
+ * __zoneMapAttachSegment - caller must hold the slot->lock
+ */
+static zoneMapHead *
+__zoneMapAttachSegment(int slot_id)
+{
+	zoneMapSlot	   *slot = &zone_map_shared->slots[slot_id];
+	zoneMapLocal   *zm_local;
+
+	if (!zone_map_local)
+		zone_map_local = MemoryContextAllocZero(TopMemoryContext,
+												sizeof(zoneMapLocal) *
+												zone_map_shared->nslots);
+	zm_local = &zone_map_local[slot_id];
+	if (zm_local->seg && zm_local->generation == slot->generation)
+		return (zoneMapHead *)dsm_segment_address(zm_local->seg);
+	/* mapping is stale, so detach it to release the old segment */
+	if (zm_local->seg)
+	{
+		dsm_detach(zm_local->seg);
+		zm_local->seg = NULL;
+	}
+	zm_local->seg = dsm_attach(slot->handle);
+	if (!zm_local->seg)
+		elog(ERROR, "failed on dsm_attach for zone map");
+	dsm_pin_mapping(zm_local->seg);
+	zm_local->generation = slot->generation;
+
+	return (zoneMapHead *)dsm_segment_address(zm_local->seg);
+}
+
+/*
+ * __zoneMapCreateSegment
+ */
+static dsm_segment *
+__zoneMapCreateSegment(Relation rel,
+					   int ncols, const AttrNumber *attnums,
+					   uint32_t range_pages, uint32_t nrooms,
+					   const zoneMapHead *zm_old)
+{
+	TupleDesc	tupdesc = RelationGetDescr(rel);
+	dsm_segment *seg;
+	zoneMapHead *zm_head;
+	size_t		sz;
+
+	sz = offsetof(zoneMapHead, data) + ZONEMAP_RANGE_SZ(ncols) * (size_t)nrooms;
+	seg = dsm_create(sz, 0);
+	zm_head = dsm_segment_address(seg);
+	memset(zm_head, 0, sz);
+	SpinLockInit(&zm_head->lock);
+	zm_head->relfilenode = RelationGetForm(rel)->relfilenode;
+	zm_head->range_pages = range_pages;
+	zm_head->nrooms = nrooms;
+	zm_head->ncols = ncols;
+	for (int j=0; j < ncols; j++)
+	{
+		Oid		type_oid = TupleDescAttr(tupdesc, attnums[j]-1)->atttypid;
+
+		zm_head->attnums[j] = attnums[j];
+		zm_head->typclass[j] = __zoneMapTypeClass(type_oid);
+	}
+	/* copy the summarized ranges, if expand */
+	if (zm_old)
+	{
+		Assert(zm_old->ncols == ncols &&
+			   zm_old->range_pages == range_pages &&
+			   zm_old->nrooms <= nrooms);
+		memcpy(zm_head->data, zm_old->data,
+			   ZONEMAP_RANGE_SZ(ncols) * (size_t)zm_old->nrooms);
+	}
+	return seg;
+}
+
+/*
+ * __zoneMapInstallSegment
+ *
+ * It replaces the segment of the slot (or assigns a new slot), then the
+ * segment becomes persistent until it is replaced or dropped.
+ */
+static void
+__zoneMapInstallSegment(Relation rel, dsm_segment *seg)
+{
+	Oid			table_oid = RelationGetRelid(rel);
+	zoneMapSlot *slot;
+	dsm_handle	old_handle = DSM_HANDLE_INVALID;
+	int			slot_id;
+
+	LWLockAcquire(&zone_map_shared->lock, LW_EXCLUSIVE);
+	slot_id = __zoneMapLookupSlot(table_oid);
+	if (slot_id < 0)
+	{
+		for (int i=0; i < zone_map_shared->nslots; i++)
+		{
+			if (!OidIsValid(zone_map_shared->slots[i].table_oid))
+			{
+				slot_id = i;
+				break;
+			}
+		}
+		if (slot_id < 0)
+		{
+			LWLockRelease(&zone_map_shared->lock);
+			ereport(ERROR,
+					(errcode(ERRCODE_OUT_OF_MEMORY),
+					 errmsg("no free zone map slot for \"%s\"",
+							RelationGetRelationName(rel)),
+					 errhint("increase pg_strom.zonemap_max_relations")));
+		}
+	}
+	slot = &zone_map_shared->slots[slot_id];
+	LWLockAcquire(&slot->lock, LW_EXCLUSIVE);
+	if (OidIsValid(slot->table_oid))
+		old_handle = slot->handle;
+	dsm_pin_segment(seg);
+	slot->database_oid = MyDatabaseId;
+	slot->table_oid = table_oid;
+	slot->handle = dsm_segment_handle(seg);
+	slot->generation++;
+	LWLockRelease(&slot->lock);
+	LWLockRelease(&zone_map_shared->lock);
+
+	/* the last backend that maps the old segment will release it */
+	if (old_handle != DSM_HANDLE_INVALID)
+		dsm_unpin_segment(old_handle);
+	dsm_detach(seg);
+}
+
+/*
+ * __zoneMapSummarizeRanges
+ *
+ * It summarizes the ranges not summarized yet. The range is marked as
+ * BUILDING prior to the scan, so concurrent INSERT/UPDATE widens the range
+ * by the sync trigger during the summarization. Tuples are scanned with
+ * SnapshotAny, thus it also includes the ones by in-progress transactions.
+ */
+static int64_t
+__zoneMapSummarizeRanges(Relation rel, int slot_id)
+{
+	zoneMapSlot	   *slot = &zone_map_shared->slots[slot_id];
+	BlockNumber		nblocks = RelationGetNumberOfBlocks(rel);
+	TableScanDesc	scan;
+	zoneMapValue	values[ZONEMAP_MAX_COLUMNS];
+	int64_t			nsummarized = 0;
+
+	scan = table_beginscan_strat(rel, SnapshotAny, 0, NULL, true, false);
+	for (uint32_t index=0; ; index++)
+	{
+		zoneMapHead	   *zm_head;
+		zoneMapRange   *range;
+		BlockNumber		start;
+		BlockNumber		nr_blocks;
+		HeapTuple		tuple;
+		bool			found = false;
+
+		CHECK_FOR_INTERRUPTS();
+		LWLockAcquire(&slot->lock, LW_SHARED);
+		zm_head = __zoneMapAttachSegment(slot_id);
+		start = index * zm_head->range_pages;
+		if (index >= zm_head->nrooms || start >= nblocks)
+		{
+			LWLockRelease(&slot->lock);
+			break;
+		}
+		nr_blocks = Min(zm_head->range_pages, nblocks - start);
+		range = ZONEMAP_GET_RANGE(zm_head, index);
+		SpinLockAcquire(&zm_head->lock);
+		if (range->flags == 0)
+		{
+			range->flags = ZONEMAP_RANGE__BUILDING;
+			found = true;
+		}
+		SpinLockRelease(&zm_head->lock);
+		LWLockRelease(&slot->lock);
+		if (!found)
+			continue;
+
+		/* scan the range */
+		memset(values, 0, sizeof(values));
+		table_rescan(scan, NULL);
+		heap_setscanlimits(scan, start, nr_blocks);
+		while ((tuple = heap_getnext(scan, ForwardScanDirection)) != NULL)
+		{
+			__zoneMapValueAccum(zm_head, values, rel, tuple);
+		}
+
+		/* merge the summary, even if segment is replaced in the meantime */
+		LWLockAcquire(&slot->lock, LW_SHARED);
+		zm_head = __zoneMapAttachSegment(slot_id);
+		if (index < zm_head->nrooms)
+		{
+			range = ZONEMAP_GET_RANGE(zm_head, index);
+			SpinLockAcquire(&zm_head->lock);
+			if ((range->flags & ZONEMAP_RANGE__BUILDING) != 0)
+			{
+				for (int j=0; j < zm_head->ncols; j++)
+					__zoneMapValueMerge(zm_head->typclass[j],
+										&range->values[j],
+										&values[j]);
+				range->flags = ZONEMAP_RANGE__VALID;
+				nsummarized++;
+			}
+			SpinLockRelease(&zm_head->lock);
+		}
+		LWLockRelease(&slot->lock);
+	}
+	table_endscan(scan);
+
+	return nsummarized;
+}
+
+static void
+__zoneMapCheckRelation(Relation rel)
+{
+	if (RelationGetForm(rel)->relkind != RELKIND_RELATION ||
+		RelationGetForm(rel)->relam != HEAP_TABLE_AM_OID)
+		ereport(ERROR,
+				(errcode(ERRCODE_WRONG_OBJECT_TYPE),
+				 errmsg("zone map supports only heap tables: \"%s\"",
+						RelationGetRelationName(rel))));
+	/* zone map is shared by all the sessions, so only owner can touch it */
+	if (!pg_class_ownercheck(RelationGetRelid(rel), GetUserId()))
+		aclcheck_error(ACLCHECK_NOT_OWNER,
+					   get_relkind_objtype(RelationGetForm(rel)->relkind),
+					   RelationGetRelationName(rel));
+	if (!zone_map_shared)
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("zone map is disabled"),
+				 errhint("set pg_strom.zonemap_max_relations larger than 0")));
+}
+
+static uint32_t
+__zoneMapEstimateNRooms(Relation rel, uint32_t range_pages)
+{
+	BlockNumber	nblocks = RelationGetNumberOfBlocks(rel);
+	uint32_t	nranges = (nblocks + range_pages - 1) / range_pages;
+
+	/* room for table growth */
+	return nranges + nranges / 2 + 64;
+}
+
+/*
+ * pgstrom_zonemap_build(regclass, text[], int4)
+ */
+PG_FUNCTION_INFO_V1(pgstrom_zonemap_build);
+PUBLIC_FUNCTION(Datum)
+pgstrom_zonemap_build(PG_FUNCTION_ARGS)
+{
+	Oid			table_oid = PG_GETARG_OID(0);
+	ArrayType  *columns = PG_GETARG_ARRAYTYPE_P(1);
+	int32_t		range_pages = PG_GETARG_INT32(2);
+	Relation	rel;
+	TupleDesc	tupdesc;
+	Datum	   *elems;
+	bool	   *nulls;
+	int			nelems;
+	AttrNumber	attnums[ZONEMAP_MAX_COLUMNS];
+	dsm_segment *seg;
+	int64_t		nsummarized;
+	int			slot_id;
+
+	if (range_pages <= 0)
+		elog(ERROR, "range_pages must be positive: %d", range_pages);
+	rel = table_open(table_oid, ShareUpdateExclusiveLock);
+	__zoneMapCheckRelation(rel);
+	tupdesc = RelationGetDescr(rel);
+
+	deconstruct_array(columns, TEXTOID, -1, false, TYPALIGN_INT,
+					  &elems, &nulls, &nelems);
+	if (nelems < 1 || nelems > ZONEMAP_MAX_COLUMNS)
+		elog(ERROR, "zone map supports 1-%d columns", ZONEMAP_MAX_COLUMNS);
+	for (int j=0; j < nelems; j++)
+	{
+		char	   *colname;
+		AttrNumber	anum;
+		Oid			type_oid;
+
+		if (nulls[j])
+			elog(ERROR, "column name must not be NULL");
+		colname = text_to_cstring(DatumGetTextPP(elems[j]));
+		anum = get_attnum(table_oid, colname);
+		if (anum <= 0)
+			ereport(ERROR,
+					(errcode(ERRCODE_UNDEFINED_COLUMN),
+					 errmsg("column \"%s\" of relation \"%s\" does not exist",
+							colname, RelationGetRelationName(rel))));
+		type_oid = TupleDescAttr(tupdesc, anum-1)->atttypid;
+		if (__zoneMapTypeClass(type_oid) == 0)
+			ereport(ERROR,
+					(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+					 errmsg("zone map does not support column \"%s\" of type %s",
+							colname, format_type_be(type_oid))));
+		attnums[j] = anum;
+	}
+	if (!__zoneMapHasSyncTrigger(rel))
+		ereport(WARNING,
+				(errmsg("zone map of \"%s\" is not used without the sync trigger",
+						RelationGetRelationName(rel)),
+				 errhint("CREATE TRIGGER ... AFTER INSERT OR UPDATE ON %s FOR EACH ROW EXECUTE FUNCTION pgstrom.zonemap_sync_trigger()",
+						 RelationGetRelationName(rel))));
+	/* build a new zone map, then summarize all the ranges */
+	seg = __zoneMapCreateSegment(rel, nelems, attnums, range_pages,
+								 __zoneMapEstimateNRooms(rel, range_pages),
+								 NULL);
+	__zoneMapInstallSegment(rel, seg);
+
+	LWLockAcquire(&zone_map_shared->lock, LW_SHARED);
+	slot_id = __zoneMapLookupSlot(table_oid);
+	LWLockRelease(&zone_map_shared->lock);
+	if (slot_id < 0)
+		elog(ERROR, "zone map of \"%s\" was dropped concurrently",
+			 RelationGetRelationName(rel));
+	nsummarized = __zoneMapSummarizeRanges(rel, slot_id);
+
+	table_close(rel, ShareUpdateExclusiveLock);
+
+	PG_RETURN_INT64(nsummarized);
+}
+
+/*
+ * pgstrom_zonemap_refresh(regclass)
+ *
+ * It summarizes the ranges appended since the last build/refresh.
+ * If the table was rewritten, zone map is built again.
+ */
+PG_FUNCTION_INFO_V1(pgstrom_zonemap_refresh);
+PUBLIC_FUNCTION(Datum)
+pgstrom_zonemap_refresh(PG_FUNCTION_ARGS)
+{
+	Oid			table_oid = PG_GETARG_OID(0);
+	Relation	rel;
+	zoneMapSlot *slot;
+	zoneMapHead *zm_head;
+	dsm_segment *seg = NULL;
+	int64_t		nsummarized;
+	int			slot_id;
+
+	rel = table_open(table_oid, ShareUpdateExclusiveLock);
+	__zoneMapCheckRelation(rel);
+
+	LWLockAcquire(&zone_map_shared->lock, LW_SHARED);
+	slot_id = __zoneMapLookupSlot(table_oid);
+	LWLockRelease(&zone_map_shared->lock);
+	if (slot_id < 0)
+		ereport(ERROR,
+				(errcode(ERRCODE_UNDEFINED_OBJECT),
+				 errmsg("zone map of \"%s\" is not built",
+						RelationGetRelationName(rel))));
+	slot = &zone_map_shared->slots[slot_id];
+
+	/*
+	 * Expand the segment if table grows, or rebuild if rewritten.
+	 * Exclusive lock on the slot blocks the sync trigger during the copy.
+	 */
+	LWLockAcquire(&slot->lock, LW_EXCLUSIVE);
+	PG_TRY();
+	{
+		uint32_t	nrooms;
+
+		zm_head = __zoneMapAttachSegment(slot_id);
+		nrooms = __zoneMapEstimateNRooms(rel, zm_head->range_pages);
+		if (zm_head->relfilenode != RelationGetForm(rel)->relfilenode)
+			seg = __zoneMapCreateSegment(rel, zm_head->ncols,
+										 zm_head->attnums,
+										 zm_head->range_pages,
+										 nrooms, NULL);
+		else if (zm_head->nrooms < nrooms - nrooms / 3)
+			seg = __zoneMapCreateSegment(rel, zm_head->ncols,
+										 zm_head->attnums,
+										 zm_head->range_pages,
+										 nrooms, zm_head);
+		if (seg)
+		{
+			dsm_handle	old_handle = slot->handle;
+
+			dsm_pin_segment(seg);
+			slot->handle = dsm_segment_handle(seg);
+			slot->generation++;
+			dsm_unpin_segment(old_handle);
+			dsm_detach(seg);
+		}
+	}
+	PG_CATCH();
+	{
+		LWLockRelease(&slot->lock);
+		PG_RE_THROW();
+	}
+	PG_END_TRY();
+	LWLockRelease(&slot->lock);
+
+	nsummarized = __zoneMapSummarizeRanges(rel, slot_id);
+
+	table_close(rel, ShareUpdateExclusiveLock);
+
+	PG_RETURN_INT64(nsummarized);
+}
+
+/*
+ * pgstrom_zonemap_drop(regclass)
+ */
+PG_FUNCTION_INFO_V1(pgstrom_zonemap_drop);
+PUBLIC_FUNCTION(Datum)
+pgstrom_zonemap_drop(PG_FUNCTION_ARGS)
+{
+	Oid			table_oid = PG_GETARG_OID(0);
+	dsm_handle	old_handle = DSM_HANDLE_INVALID;
+	int			slot_id;
+
+	if (!zone_map_shared)
+		PG_RETURN_BOOL(false);
+	if (!pg_class_ownercheck(table_oid, GetUserId()))
+		aclcheck_error(ACLCHECK_NOT_OWNER, OBJECT_TABLE, get_rel_name(table_oid));
+
+	LWLockAcquire(&zone_map_shared->lock, LW_EXCLUSIVE);
+	slot_id = __zoneMapLookupSlot(table_oid);
+	if (slot_id >= 0)
+	{
+		zoneMapSlot *slot = &zone_map_shared->slots[slot_id];
+
+		LWLockAcquire(&slot->lock, LW_EXCLUSIVE);
+		old_handle = slot->handle;
+		slot->database_oid = InvalidOid;
+		slot->table_oid = InvalidOid;
+		slot->handle = DSM_HANDLE_INVALID;
+		slot->generation++;
+		LWLockRelease(&slot->lock);
+	}
+	LWLockRelease(&zone_map_shared->lock);
+
+	if (old_handle == DSM_HANDLE_INVALID)
+		PG_RETURN_BOOL(false);
+	dsm_unpin_segment(old_handle);
+	if (zone_map_local && zone_map_local[slot_id].seg)
+	{
+		dsm_detach(zone_map_local[slot_id].seg);
+		zone_map_local[slot_id].seg = NULL;
+	}
+	PG_RETURN_BOOL(true);
+}
+
+/*
+ * pgstrom_zonemap_sync_trigger
+ */
+PG_FUNCTION_INFO_V1(pgstrom_zonemap_sync_trigger);
+PUBLIC_FUNCTION(Datum)
+pgstrom_zonemap_sync_trigger(PG_FUNCTION_ARGS)
+{
+	TriggerData	   *trigdata = (TriggerData *) fcinfo->context;
+	Relation		rel;
+	HeapTuple		tuple;
+	zoneMapSlot	   *slot;
+	zoneMapHead	   *zm_head;
+	zoneMapRange   *range;
+	zoneMapValue	values[ZONEMAP_MAX_COLUMNS];
+	uint32_t		index;
+	int				slot_id;
+
+	if (!CALLED_AS_TRIGGER(fcinfo))
+		elog(ERROR, "%s: must be called as trigger",
+			 get_func_name(fcinfo->flinfo->fn_oid));
+	if (!TRIGGER_FIRED_FOR_ROW(trigdata->tg_event) ||
+		!TRIGGER_FIRED_AFTER(trigdata->tg_event))
+		elog(ERROR, "%s: must be declared as AFTER ROW trigger",
+			 trigdata->tg_trigger->tgname);
+	if (TRIGGER_FIRED_BY_INSERT(trigdata->tg_event))
+		tuple = trigdata->tg_trigtuple;
+	else if (TRIGGER_FIRED_BY_UPDATE(trigdata->tg_event))
+		tuple = trigdata->tg_newtuple;
+	else
+		goto bailout;	/* DELETE never widens the range */
+	if (!zone_map_shared)
+		goto bailout;
+
+	rel = trigdata->tg_relation;
+	LWLockAcquire(&zone_map_shared->lock, LW_SHARED);
+	slot_id = __zoneMapLookupSlot(RelationGetRelid(rel));
+	if (slot_id < 0)
+	{
+		LWLockRelease(&zone_map_shared->lock);
+		goto bailout;
+	}
+	slot = &zone_map_shared->slots[slot_id];
+	LWLockAcquire(&slot->lock, LW_SHARED);
+	LWLockRelease(&zone_map_shared->lock);
+
+	zm_head = __zoneMapAttachSegment(slot_id);
+	index = ItemPointerGetBlockNumber(&tuple->t_self) / zm_head->range_pages;
+	if (zm_head->relfilenode == RelationGetForm(rel)->relfilenode &&
+		index < zm_head->nrooms)
+	{
+		memset(values, 0, sizeof(values));
+		__zoneMapValueAccum(zm_head, values, rel, tuple);
+
+		range = ZONEMAP_GET_RANGE(zm_head, index);
+		SpinLockAcquire(&zm_head->lock);
+		if (range->flags != 0)
+		{
+			for (int j=0; j < zm_head->ncols; j++)
+				__zoneMapValueMerge(zm_head->typclass[j],
+									&range->values[j],
+									&values[j]);
+		}
+		SpinLockRelease(&zm_head->lock);
+	}
+	LWLockRelease(&slot->lock);
+bailout:
+	PG_RETURN_POINTER(tuple);
+}
+
+/* ----------------------------------------------------------------
+ *
+ * Executor routines
+ *
+ * ----------------------------------------------------------------
+ */
+/*
+ * get_opfamily_for_zonemap - default btree operator family of the type
+ */
+static Oid
+get_opfamily_for_zonemap(Oid type_oid)
+{
+	Oid		opclass = GetDefaultOpClass(type_oid, BTREE_AM_OID);
+
+	if (!OidIsValid(opclass))
+		return InvalidOid;
+	return get_opclass_family(opclass);
+}
+
+static bool
+__zoneMapExtractOneCond(pgstromTaskState *pts,
+						zoneMapHead *zm_head,
+						Expr *expr, Index scanrelid,
+						zoneMapCond *zm_cond)
+{
+	Relation	rel = pts->css.ss.ss_currentRelation;
+	TupleDesc	tupdesc = RelationGetDescr(rel);
+	Var		   *var;
+	Expr	   *other;
+	Oid			other_type;
+	int			strategy = 0;
+	int			cindex = -1;
+
+	if (IsA(expr, NullTest))
+	{
+		NullTest   *nt = (NullTest *)expr;
+
+		if (!IsA(nt->arg, Var) || nt->argisrow)
+			return false;
+		var = (Var *)nt->arg;
+		other = NULL;
+		zm_cond->nulltesttype = nt->nulltesttype;
+	}
+	else if (IsA(expr, OpExpr) &&
+			 list_length(((OpExpr *)expr)->args) == 2)
+	{
+		OpExpr	   *op = (OpExpr *)expr;
+		Expr	   *arg1 = linitial(op->args);
+		Expr	   *arg2 = lsecond(op->args);
+		Oid			opfamily;
+		bool		commuted = false;
+
+		if (IsA(arg1, RelabelType))
+			arg1 = ((RelabelType *)arg1)->arg;
+		if (IsA(arg2, RelabelType))
+			arg2 = ((RelabelType *)arg2)->arg;
+		if (IsA(arg1, Var))
+		{
+			var = (Var *)arg1;
+			other = arg2;
+		}
+		else if (IsA(arg2, Var))
+		{
+			var = (Var *)arg2;
+			other = arg1;
+			commuted = true;
+		}
+		else
+			return false;
+		opfamily = get_opfamily_for_zonemap(var->vartype);
+		if (!OidIsValid(opfamily))
+			return false;
+		strategy = get_op_opfamily_strategy(op->opno, opfamily);
+		if (strategy < BTLessStrategyNumber ||
+			strategy > BTGreaterStrategyNumber)
+			return false;
+		if (commuted)
+			strategy = BTMaxStrategyNumber + 1 - strategy;
+	}
+	else
+		return false;
+
+	if (var->varno != scanrelid ||
+		var->varlevelsup != 0 ||
+		var->varattno <= 0)
+		return false;
+	for (int j=0; j < zm_head->ncols; j++)
+	{
+		if (zm_head->attnums[j] == var->varattno)
+		{
+			cindex = j;
+			break;
+		}
+	}
+	if (cindex < 0)
+		return false;
+	zm_cond->cindex = cindex;
+	zm_cond->strategy = strategy;
+
+	/* evaluate the comparison key once at the beginning */
+	if (other)
+	{
+		ExprContext *econtext = pts->css.ss.ps.ps_ExprContext;
+		ExprState  *estate;
+		Datum		datum;
+		bool		isnull;
+
+		other_type = exprType((Node *)other);
+		if (__zoneMapTypeClass(other_type) !=
+			__zoneMapTypeClass(TupleDescAttr(tupdesc, var->varattno-1)->atttypid) ||
+			contain_var_clause((Node *)other) ||
+			contain_volatile_functions((Node *)other))
+			return false;
+		estate = ExecInitExpr(other, &pts->css.ss.ps);
+		datum = ExecEvalExprSwitchContext(estate, econtext, &isnull);
+		if (isnull)
+			return false;
+		zm_cond->key = __zoneMapDatumToKey(other_type, datum);
+	}
+	return true;
+}
+
+static List *
+__zoneMapExtractConds(pgstromTaskState *pts,
+					  zoneMapHead *zm_head,
+					  List *quals, Index scanrelid,
+					  List *zm_conds)
+{
+	ListCell   *lc;
+
+	foreach (lc, quals)
+	{
+		Expr	   *expr = lfirst(lc);
+		zoneMapCond	zm_cond;
+
+		if (IsA(expr, RestrictInfo))
+			expr = ((RestrictInfo *)expr)->clause;
+		if (is_andclause(expr))
+		{
+			zm_conds = __zoneMapExtractConds(pts, zm_head,
+											 ((BoolExpr *)expr)->args,
+											 scanrelid, zm_conds);
+			continue;
+		}
+		memset(&zm_cond, 0, sizeof(zoneMapCond));
+		if (__zoneMapExtractOneCond(pts, zm_head, expr, scanrelid, &zm_cond))
+		{
+			zoneMapCond *temp = palloc(sizeof(zoneMapCond));
+
+			memcpy(temp, &zm_cond, sizeof(zoneMapCond));
+			zm_conds = lappend(zm_conds, temp);
+		}
+	}
+	return zm_conds;
+}
+
+/*
+ * __zoneMapRangeIsExcluded - true, if no rows in the range match
+ */
+static bool
+__zoneMapRangeIsExcluded(zoneMapHead *zm_head,
+						 const zoneMapValue *zm_value,
+						 const zoneMapCond *zm_cond)
+{
+	int		typclass = zm_head->typclass[zm_cond->cindex];
+
+	if (zm_cond->strategy == 0)
+	{
+		if (zm_cond->nulltesttype == IS_NULL)
+			return (zm_value->nnulls == 0);
+		return (zm_value->nvalues == 0);
+	}
+	if (zm_value->nvalues == 0)
+		return true;	/* strict operators never match NULLs */
+	switch (zm_cond->strategy)
+	{
+		case BTLessStrategyNumber:
+			return (__zoneMapKeyCompare(typclass, zm_value->min_value, zm_cond->key) >= 0);
+		case BTLessEqualStrategyNumber:
+			return (__zoneMapKeyCompare(typclass, zm_value->min_value, zm_cond->key) > 0);
+		case BTEqualStrategyNumber:
+			return (__zoneMapKeyCompare(typclass, zm_value->min_value, zm_cond->key) > 0 ||
+					__zoneMapKeyCompare(typclass, zm_value->max_value, zm_cond->key) < 0);
+		case BTGreaterEqualStrategyNumber:
+			return (__zoneMapKeyCompare(typclass, zm_value->max_value, zm_cond->key) < 0);
+		case BTGreaterStrategyNumber:
+			return (__zoneMapKeyCompare(typclass, zm_value->max_value, zm_cond->key) <= 0);
+		default:
+			break;
+	}
+	return false;
+}
+
+/*
+ * pgstromZoneMapExecBegin
+ *
+ * It builds the bitmap of block ranges to be skipped according to the
+ * scan qualifiers.
+ */
+void
+pgstromZoneMapExecBegin(pgstromTaskState *pts)
+{
+	Relation	rel = pts->css.ss.ss_currentRelation;
+	pgstromPlanInfo *pp_info = pts->pp_info;
+	zoneMapState *zm_state;
+	zoneMapSlot *slot;
+	zoneMapHead *zm_head;
+	List	   *zm_conds;
+	ListCell   *lc;
+	uint32_t	nranges;
+	int			slot_id;
+
+	if (!pgstrom_enable_zonemap ||
+		!zone_map_shared ||
+		pp_info->scan_quals_fallback == NIL ||
+		!__zoneMapHasSyncTrigger(rel))
+		return;
+
+	LWLockAcquire(&zone_map_shared->lock, LW_SHARED);
+	slot_id = __zoneMapLookupSlot(RelationGetRelid(rel));
+	if (slot_id < 0)
+	{
+		LWLockRelease(&zone_map_shared->lock);
+		return;
+	}
+	slot = &zone_map_shared->slots[slot_id];
+	LWLockAcquire(&slot->lock, LW_SHARED);
+	LWLockRelease(&zone_map_shared->lock);
+	PG_TRY();
+	{
+		zm_head = __zoneMapAttachSegment(slot_id);
+		if (zm_head->relfilenode != RelationGetForm(rel)->relfilenode)
+			zm_conds = NIL;
+		else
+			zm_conds = __zoneMapExtractConds(pts, zm_head,
+											 pp_info->scan_quals_fallback,
+											 pp_info->scan_relid, NIL);
+		if (zm_conds != NIL)
+		{
+			nranges = zm_head->nrooms;
+			zm_state = palloc0(sizeof(zoneMapState));
+			zm_state->range_pages = zm_head->range_pages;
+			zm_state->nranges = nranges;
+			zm_state->skip_map = palloc0(BITMAPLEN(nranges));
+			for (uint32_t index=0; index < nranges; index++)
+			{
+				zoneMapRange *range = ZONEMAP_GET_RANGE(zm_head, index);
+				zoneMapValue  values[ZONEMAP_MAX_COLUMNS];
+				bool		excluded = false;
+
+				SpinLockAcquire(&zm_head->lock);
+				if ((range->flags & ZONEMAP_RANGE__VALID) != 0)
+					memcpy(values, range->values,
+						   sizeof(zoneMapValue) * zm_head->ncols);
+				else
+					excluded = true;	/* not summarized */
+				SpinLockRelease(&zm_head->lock);
+				if (excluded)
+					continue;
+				foreach (lc, zm_conds)
+				{
+					zoneMapCond *zm_cond = lfirst(lc);
+
+					if (__zoneMapRangeIsExcluded(zm_head,
+												 &values[zm_cond->cindex],
+												 zm_cond))
+					{
+						zm_state->skip_map[index >> 3] |= (1U << (index & 7));
+						zm_state->nskipped++;
+						break;
+					}
+				}
+			}
+			for (int j=0; j < zm_head->ncols; j++)
+			{
+				char   *colname = get_attname(RelationGetRelid(rel),
+											  zm_head->attnums[j], false);
+				zm_state->colnames = lappend(zm_state->colnames, colname);
+			}
+			pts->zm_state = zm_state;
+		}
+	}
+	PG_CATCH();
+	{
+		LWLockRelease(&slot->lock);
+		PG_RE_THROW();
+	}
+	PG_END_TRY();
+	LWLockRelease(&slot->lock);
+}
+
+/*
+ * pgstromZoneMapSkipBlock
+ */
+bool
+pgstromZoneMapSkipBlock(pgstromTaskState *pts, BlockNumber block_num)
+{
+	zoneMapState *zm_state = pts->zm_state;
+	uint32_t	index;
+
+	if (!zm_state)
+		return false;
+	index = block_num / zm_state->range_pages;
+	if (index >= zm_state->nranges)
+		return false;
+	return ((zm_state->skip_map[index >> 3] & (1U << (index & 7))) != 0);
+}
+
+/*
+ * pgstromZoneMapExplain
+ */
+void
+pgstromZoneMapExplain(pgstromTaskState *pts, ExplainState *es)
+{
+	zoneMapState *zm_state = pts->zm_state;
+	StringInfoData buf;
+	ListCell   *lc;
+
+	if (!zm_state)
+		return;
+	initStringInfo(&buf);
+	foreach (lc, zm_state->colnames)
+	{
+		if (buf.len > 0)
+			appendStringInfoString(&buf, ", ");
+		appendStringInfoString(&buf, quote_identifier(lfirst(lc)));
+	}
+	appendStringInfo(&buf, " (skipped: %u of %u ranges)",
+					 zm_state->nskipped, zm_state->nranges);
+	ExplainPropertyText("Zone Map", buf.data, es);
+	pfree(buf.data);
+}
+
+/*
+ * zoneMapSyscacheCallback
+ */
+static void
+zoneMapSyscacheCallback(Datum arg, int cacheid, uint32 hashvalue)
+{
+	__zonemap_sync_trigger_function_oid = InvalidOid;
+}
+
+/*
+ * pgstrom_request_zonemap
+ */
+static void
+pgstrom_request_zonemap(void)
+{
+	if (shmem_request_next)
+		shmem_request_next();
+	RequestAddinShmemSpace(MAXALIGN(offsetof(zoneMapSharedHead,
+											 slots[pgstrom_zonemap_max_relations])));
+}
+
+/*
+ * pgstrom_startup_zonemap
+ */
+static void
+pgstrom_startup_zonemap(void)
+{
+	size_t	sz = offsetof(zoneMapSharedHead, slots[pgstrom_zonemap_max_relations]);
+	int		tranche_id;
+	bool	found;
+
+	if (shmem_startup_next)
+		(*shmem_startup_next)();
+
+	zone_map_shared = ShmemInitStruct("zoneMapSharedHead", MAXALIGN(sz), &found);
+	Assert(!found);
+	memset(zone_map_shared, 0, sz);
+	tranche_id = LWLockNewTrancheId();
+	LWLockInitialize(&zone_map_shared->lock, tranche_id);
+	zone_map_shared->nslots = pgstrom_zonemap_max_relations;
+	for (int i=0; i < pgstrom_zonemap_max_relations; i++)
+	{
+		zoneMapSlot *slot = &zone_map_shared->slots[i];
+
+		LWLockInitialize(&slot->lock, tranche_id);
+		slot->handle = DSM_HANDLE_INVALID;
+	}
+}
+
+/*
+ * pgstrom_init_zonemap
+ */
+void
+pgstrom_init_zonemap(void)
+{
+	DefineCustomBoolVariable("pg_strom.enable_zonemap",
+							 "Enables to skip block ranges by the zone map",
+							 NULL,
+							 &pgstrom_enable_zonemap,
+							 true,
+							 PGC_USERSET,
+							 GUC_NOT_IN_SAMPLE,
+							 NULL, NULL, NULL);
+	DefineCustomIntVariable("pg_strom.zonemap_max_relations",
+							"max number of tables with zone map (0 to disable)",
+							NULL,
+							&pgstrom_zonemap_max_relations,
+							32,
+							0,
+							10000,
+							PGC_POSTMASTER,
+							GUC_NOT_IN_SAMPLE,
+							NULL, NULL, NULL);
+	CacheRegisterSyscacheCallback(PROCOID, zoneMapSyscacheCallback, 0);
+	if (pgstrom_zonemap_max_relations == 0)
+		return;
+
+	/* shared memory size */
+	shmem_request_next = shmem_request_hook;
+	shmem_request_hook = pgstrom_request_zonemap;
+	shmem_startup_next = shmem_startup_hook;
+	shmem_startup_hook = pgstrom_startup_zonemap;
+}
@@ -0,0 +1,298 @@
+#!/bin/sh
+#
+# bench-dbt3.sh - TPC-H (DBT-3) performance benchmark of PG-Strom
+#
+# It loads the TPC-H dataset at the scale factors given, into the heap
+# tables and arrow_fdw variants of 'lineitem' and 'orders', runs the 22
+# queries of dbt3-*.sql on each variant, then writes out the JSON report.
+# In addition to the metrics of bench-ssbm.sh, 'explain' of each query has
+# the custom scans used (GpuScan/GpuJoin/GpuPreAgg) and the join nodes still
+# run on CPU ('cpu_joins'); an empty 'cpu_joins' means the query ran fully
+# on GPU. Datasets already loaded are reused.
+#
+# The helper functions are shared with bench-ssbm.sh (../ssbm/bench-ssbm.sql)
+#
+# See 'make bench-dbt3' in test/Makefile
+#
+usage()
+{
+  cat <<EOF
+usage: bench-dbt3.sh [OPTIONS]
+
+OPTIONS:
+  -d DBNAME   : database name (default: dbt3_bench)
+  -s SF[,...] : scale factors (default: 1)
+  -n NLOOPS   : number of runs for each query (default: 3)
+  -c CACHE    : 'warm' or 'cold' (default: warm)
+                cold runs \$DROP_CACHES_CMD (and \$RESTART_CMD, if any)
+                prior to each run.
+  -v VARIANTS : comma separated list of 'heap' and 'arrow'
+                (default: heap,arrow)
+  -q QUERIES  : comma separated list of the query numbers (default: 1-22)
+  -a DIR      : directory of the arrow files (default: /tmp)
+  -o FILE     : output JSON report (default: <run_id>.json)
+  -f          : reload the dataset, even if exists
+  -h          : shows this message
+
+ENVIRONMENT:
+  PSQL, CREATEDB, PG2ARROW_CMD, DBGEN_DBT3_CMD : commands to use
+  DROP_CACHES_CMD : (default: 'sudo sysctl -q -w vm.drop_caches=3')
+  RESTART_CMD     : restarts PostgreSQL to drop shared buffers (default: none)
+EOF
+  exit $1
+}
+
+CWD=`dirname $0`
+PSQL=${PSQL:-psql}
+CREATEDB=${CREATEDB:-createdb}
+PG2ARROW_CMD=${PG2ARROW_CMD:-pg2arrow}
+DBGEN_DBT3_CMD=${DBGEN_DBT3_CMD:-dbgen-dbt3}
+DROP_CACHES_CMD=${DROP_CACHES_CMD:-"sudo sysctl -q -w vm.drop_caches=3"}
+RESTART_CMD=${RESTART_CMD:-}
+DBNAME="dbt3_bench"
+SF_LIST="1"
+NLOOPS=3
+CACHE="warm"
+VARIANTS="heap,arrow"
+QUERY_LIST=`seq -s, 1 22`
+ARROW_DIR="/tmp"
+REPORT=""
+RELOAD=0
+RUN_ID=`date +dbt3_%Y%m%d_%H%M%S`
+
+while getopts "d:s:n:c:v:q:a:o:fh" opt
+do
+  case $opt in
+    d) DBNAME="$OPTARG" ;;
+    s) SF_LIST="$OPTARG" ;;
+    n) NLOOPS="$OPTARG" ;;
+    c) CACHE="$OPTARG" ;;
+    v) VARIANTS="$OPTARG" ;;
+    q) QUERY_LIST="$OPTARG" ;;
+    a) ARROW_DIR="$OPTARG" ;;
+    o) REPORT="$OPTARG" ;;
+    f) RELOAD=1 ;;
+    h) usage 0 ;;
+    *) usage 1 ;;
+  esac
+done
+REPORT=${REPORT:-${RUN_ID}.json}
+
+case "$NLOOPS" in
+  ''|*[!0-9]*|0) echo "invalid -n NLOOPS: $NLOOPS" >&2; exit 1 ;;
+esac
+case "$CACHE" in
+  warm|cold) ;;
+  *) echo "invalid -c CACHE: $CACHE" >&2; exit 1 ;;
+esac
+for v in `echo $VARIANTS | tr ',' ' '`
+do
+  case "$v" in
+    heap|arrow) ;;
+    *) echo "unknown variant: $v" >&2; exit 1 ;;
+  esac
+done
+for sf in `echo $SF_LIST | tr ',' ' '`
+do
+  case "$sf" in
+    ''|*[!0-9]*|0) echo "invalid scale factor: $sf" >&2; exit 1 ;;
+  esac
+done
+for q in `echo $QUERY_LIST | tr ',' ' '`
+do
+  case "$q" in
+    [1-9]|1[0-9]|2[0-2]) ;;
+    *) echo "invalid query number: $q" >&2; exit 1 ;;
+  esac
+done
+
+sql()
+{
+  $PSQL -X -q -v ON_ERROR_STOP=1 -d "$DBNAME" "$@"
+}
+
+schema_exists()
+{
+  test "`sql -At -c "SELECT 1 FROM pg_namespace WHERE nspname = '$1'"`" = "1"
+}
+
+# search_path SF VARIANT
+search_path()
+{
+  case "$2" in
+    heap) echo "dbt3_sf$1,public" ;;
+    *)    echo "dbt3_sf$1_$2,dbt3_sf$1,public" ;;
+  esac
+}
+
+#
+# setup of the database
+#
+if [ "`$PSQL -X -At -d postgres -c "SELECT 1 FROM pg_database WHERE datname = '$DBNAME'"`" != "1" ]; then
+  $CREATEDB -E UTF-8 -T template0 "$DBNAME" || exit 1
+fi
+sql -c 'CREATE EXTENSION IF NOT EXISTS pg_strom' || exit 1
+sql -f ${CWD}/../ssbm/bench-ssbm.sql || exit 1
+
+#
+# load_heap SF - heap tables on the schema dbt3_sf<SF>
+#
+load_heap()
+{
+  SCHEMA="dbt3_sf$1"
+
+  if [ $RELOAD -eq 0 ] && schema_exists $SCHEMA; then
+    return 0
+  fi
+  echo "loading TPC-H dataset (SF=$1) into $SCHEMA"
+  sql <<EOF || return 1
+DROP SCHEMA IF EXISTS ${SCHEMA} CASCADE;
+DROP SCHEMA IF EXISTS ${SCHEMA}_arrow CASCADE;
+CREATE SCHEMA ${SCHEMA};
+EOF
+  sql -c "SET search_path = ${SCHEMA}" -f ${CWD}/dbt3-ddl.sql || return 1
+  for t in s:supplier P:part S:partsupp c:customer O:orders L:lineitem n:nation r:region
+  do
+    $DBGEN_DBT3_CMD -q -s$1 -X -T${t%%:*} | \
+      sql -c "COPY ${SCHEMA}.${t#*:} FROM STDIN DELIMITER '|'" || return 1
+  done
+  sql <<EOF || return 1
+SET search_path = ${SCHEMA};
+ALTER TABLE region   ADD PRIMARY KEY (r_regionkey);
+ALTER TABLE nation   ADD PRIMARY KEY (n_nationkey);
+ALTER TABLE supplier ADD PRIMARY KEY (s_suppkey);
+ALTER TABLE part     ADD PRIMARY KEY (p_partkey);
+ALTER TABLE partsupp ADD PRIMARY KEY (ps_partkey, ps_suppkey);
+ALTER TABLE customer ADD PRIMARY KEY (c_custkey);
+ALTER TABLE orders   ADD PRIMARY KEY (o_orderkey);
+ALTER TABLE lineitem ADD PRIMARY KEY (l_orderkey, l_linenumber);
+VACUUM ANALYZE;
+EOF
+}
+
+#
+# load_arrow SF - arrow_fdw foreign tables of lineitem and orders
+#                 on the schema dbt3_sf<SF>_arrow
+#
+load_arrow()
+{
+  SCHEMA="dbt3_sf$1_arrow"
+
+  if [ $RELOAD -eq 0 ] && schema_exists $SCHEMA && \
+     [ -r "${ARROW_DIR}/dbt3_sf$1_lineitem.arrow" ] && \
+     [ -r "${ARROW_DIR}/dbt3_sf$1_orders.arrow" ]; then
+    return 0
+  fi
+  sql <<EOF || return 1
+DROP SCHEMA IF EXISTS ${SCHEMA} CASCADE;
+CREATE SCHEMA ${SCHEMA};
+EOF
+  for t in lineitem orders
+  do
+    ARROW_FILE="${ARROW_DIR}/dbt3_sf$1_${t}.arrow"
+
+    echo "dumping $t (SF=$1) into $ARROW_FILE"
+    rm -f "$ARROW_FILE"
+    $PG2ARROW_CMD -d "$DBNAME" -c "SELECT * FROM dbt3_sf$1.${t}" \
+                  -o "$ARROW_FILE" || return 1
+    sql -c "SELECT pgstrom.arrow_fdw_import_file('${t}', '${ARROW_FILE}', '${SCHEMA}')" || return 1
+  done
+}
+
+#
+# list of the TPC-H queries; '<name> <query>' for each line
+#
+QUERIES=`mktemp`
+trap "rm -f $QUERIES" EXIT
+for q in `echo $QUERY_LIST | tr ',' ' '`
+do
+  NAME=`printf "Q%02d" $q`
+  awk -v name=$NAME 'BEGIN    { q = ""; }
+                     /^--/    { next; }
+                              { gsub(/\t/, " "); q = q " " $0; }
+                     END      { sub(/;[ ]*$/, "", q); print name q; }' \
+      ${CWD}/dbt3-${NAME#Q}.sql >> $QUERIES
+done
+
+#
+# run_one SF VARIANT NAME QUERY LOOP_ID
+#
+run_one()
+{
+  if [ "$CACHE" = "cold" ]; then
+    if [ -n "$RESTART_CMD" ]; then
+      $RESTART_CMD < /dev/null > /dev/null || return 1
+    fi
+    $DROP_CACHES_CMD < /dev/null > /dev/null || return 1
+  fi
+  EXPLAIN=false
+  if [ $5 -eq 0 ]; then
+    EXPLAIN=true
+  fi
+  # sampling of the GPU memory usage during the run
+  SAMPLES=`mktemp`
+  (while :; do
+     sql -At -c 'SELECT ssbm_bench.gpu_mem_usage()' < /dev/null 2>/dev/null || break
+     sleep 0.1
+   done) > $SAMPLES &
+  SAMPLER=$!
+  SEARCH_PATH=`search_path $1 $2`
+  RESULT=$(sql -At -v query="$4" <<EOF
+SET search_path = ${SEARCH_PATH};
+SET max_parallel_workers_per_gather = 2;
+SELECT ssbm_bench.run_query(:'query', ${EXPLAIN});
+EOF
+)
+  STATUS=$?
+  kill $SAMPLER 2>/dev/null
+  wait $SAMPLER 2>/dev/null
+  PEAK=`sort -n $SAMPLES | tail -1`
+  rm -f $SAMPLES
+  if [ $STATUS -ne 0 ] || [ -z "$RESULT" ]; then
+    echo "failed on $3 (SF=$1, $2)" >&2
+    return 1
+  fi
+  sql -v result="$RESULT" <<EOF
+INSERT INTO ssbm_bench.results(run_id, sf, variant, query, cache,
+                               loop_id, runtime_ms, metrics)
+SELECT '${RUN_ID}', $1, '$2', '$3', '${CACHE}', $5,
+       (r->>'runtime_ms')::float8,
+       r || jsonb_build_object('gpu_mem_peak', ${PEAK:-0})
+  FROM (SELECT :'result'::jsonb r) x;
+EOF
+}
+
+for sf in `echo $SF_LIST | tr ',' ' '`
+do
+  load_heap $sf || exit 1
+  for v in `echo $VARIANTS | tr ',' ' '`
+  do
+    case "$v" in
+      arrow) load_arrow $sf || exit 1 ;;
+    esac
+    while read name query
+    do
+      echo "running $name (SF=$sf, $v, $CACHE)"
+      # warm up, not measured
+      if [ "$CACHE" = "warm" ]; then
+        SEARCH_PATH=`search_path $sf $v`
+        sql -At -v query="$query" > /dev/null <<EOF || exit 1
+SET search_path = ${SEARCH_PATH};
+SET max_parallel_workers_per_gather = 2;
+SELECT ssbm_bench.run_query(:'query', false);
+EOF
+      fi
+      i=1
+      while [ $i -le $NLOOPS ]
+      do
+        run_one $sf $v "$name" "$query" $i || exit 1
+        i=`expr $i + 1`
+      done
+      # EXPLAIN ANALYZE for the plan and counters
+      run_one $sf $v "$name" "$query" 0 || exit 1
+    done < $QUERIES
+  done
+done
+
+sql -At -c "SELECT jsonb_pretty(ssbm_bench.report('${RUN_ID}'))" > "$REPORT" || exit 1
+echo "report: $REPORT"
@@ -2,7 +2,8 @@
 -- TPC-H/TPC-R Top Supplier Query (Q15)
 -- Functional Query Definition
 -- Approved February 1998
-create or replace view revenue0 (supplier_no, total_revenue) as
+-- (the revenue0 view is written as a CTE, to run as a single statement)
+with revenue0 (supplier_no, total_revenue) as (
 	select
 		l_suppkey,
 		sum(l_extendedprice * (1 - l_discount))
@@ -12,8 +13,8 @@ create or replace view revenue0 (supplier_no, total_revenue) as
 		l_shipdate >= '1993-01-01'
 		and l_shipdate < date'1993-01-01' + interval '90 days'
 	group by
-		l_suppkey;
-
+		l_suppkey
+)
 select
 	s_suppkey,
 	s_name,
@@ -33,6 +34,3 @@ where
 	)
 order by
 	s_suppkey;
-
-drop view revenue0;
-
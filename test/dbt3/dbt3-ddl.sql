@@ -4,7 +4,7 @@ CREATE TABLE supplier (
     s_address VARCHAR(40),
     s_nationkey INTEGER,
     s_phone CHAR(15),
-    s_acctbal REAL,
+    s_acctbal NUMERIC(15,2),
     s_comment VARCHAR(101));
 
 CREATE TABLE part (
@@ -15,14 +15,14 @@ CREATE TABLE part (
     p_type VARCHAR(25),
     p_size INTEGER,
     p_container CHAR(10),
-    p_retailprice REAL,
+    p_retailprice NUMERIC(15,2),
     p_comment VARCHAR(23));
 
 CREATE TABLE partsupp (
     ps_partkey INTEGER,
     ps_suppkey INTEGER,
     ps_availqty INTEGER,
-    ps_supplycost REAL,
+    ps_supplycost NUMERIC(15,2),
     ps_comment VARCHAR(199));
 
 CREATE TABLE customer (
@@ -31,7 +31,7 @@ CREATE TABLE customer (
     c_address VARCHAR(40),
     c_nationkey INTEGER,
     c_phone CHAR(15),
-    c_acctbal REAL,
+    c_acctbal NUMERIC(15,2),
     c_mktsegment CHAR(10),
     c_comment VARCHAR(117));
 
@@ -39,7 +39,7 @@ CREATE TABLE orders (
     o_orderkey INTEGER,
     o_custkey INTEGER,
     o_orderstatus CHAR(1),
-    o_totalprice REAL,
+    o_totalprice NUMERIC(15,2),
     o_orderdate DATE,
     o_orderpriority CHAR(15),
     o_clerk CHAR(15),
@@ -51,10 +51,10 @@ CREATE TABLE lineitem (
     l_partkey INTEGER,
     l_suppkey INTEGER,
     l_linenumber INTEGER,
-    l_quantity REAL,
-    l_extendedprice REAL,
-    l_discount REAL,
-    l_tax REAL,
+    l_quantity NUMERIC(15,2),
+    l_extendedprice NUMERIC(15,2),
+    l_discount NUMERIC(15,2),
+    l_tax NUMERIC(15,2),
     l_returnflag CHAR(1),
     l_linestatus CHAR(1),
     l_shipdate DATE,
@@ -76,12 +76,12 @@ CREATE TABLE region (
     r_comment VARCHAR(152));
 
 /*
-\copy supplier FROM PROGRAM './dbgen-dbt3 -X -T s -s 24' delimiter '|';
-\copy part     FROM PROGRAM './dbgen-dbt3 -X -T P -s 24' delimiter '|';
-\copy partsupp FROM PROGRAM './dbgen-dbt3 -X -T S -s 24' delimiter '|';
-\copy customer FROM PROGRAM './dbgen-dbt3 -X -T c -s 24' delimiter '|';
-\copy orders   FROM PROGRAM './dbgen-dbt3 -X -T O -s 24' delimiter '|';
-\copy lineitem FROM PROGRAM './dbgen-dbt3 -X -T L -s 24' delimiter '|';
-\copy nation   FROM PROGRAM './dbgen-dbt3 -X -T n -s 24' delimiter '|';
-\copy region   FROM PROGRAM './dbgen-dbt3 -X -T r -s 24' delimiter '|';
+\copy supplier FROM PROGRAM 'dbgen-dbt3 -q -X -T s -s 24' delimiter '|';
+\copy part     FROM PROGRAM 'dbgen-dbt3 -q -X -T P -s 24' delimiter '|';
+\copy partsupp FROM PROGRAM 'dbgen-dbt3 -q -X -T S -s 24' delimiter '|';
+\copy customer FROM PROGRAM 'dbgen-dbt3 -q -X -T c -s 24' delimiter '|';
+\copy orders   FROM PROGRAM 'dbgen-dbt3 -q -X -T O -s 24' delimiter '|';
+\copy lineitem FROM PROGRAM 'dbgen-dbt3 -q -X -T L -s 24' delimiter '|';
+\copy nation   FROM PROGRAM 'dbgen-dbt3 -q -X -T n -s 24' delimiter '|';
+\copy region   FROM PROGRAM 'dbgen-dbt3 -q -X -T r -s 24' delimiter '|';
 */
@@ -0,0 +1,126 @@
+---
+--- Test cases for array_agg, string_agg and array grouping keys
+---
+SET pg_strom.regression_test_mode = on;
+SET client_min_messages = error;
+DROP SCHEMA IF EXISTS regtest_agg_array_temp CASCADE;
+CREATE SCHEMA regtest_agg_array_temp;
+RESET client_min_messages;
+
+SET search_path = regtest_agg_array_temp,public;
+CREATE TABLE rt_array (
+  id    int,
+  cat   int,
+  a     int4,
+  x     float8,
+  d     date,
+  t     text
+);
+SELECT pgstrom.random_setseed(20261101);
+INSERT INTO rt_array (
+  SELECT i, i % 4000,
+            pgstrom.random_int(2, -100000, 100000),
+            pgstrom.random_float(2, -1000.0, 1000.0),
+            pgstrom.random_date(2),
+            pgstrom.random_text_len(2, 12)
+    FROM generate_series(1,40000) i);
+VACUUM ANALYZE;
+
+-- force to use GpuScan, instead of SeqScan
+SET enable_seqscan = off;
+
+-- array_agg and string_agg with ORDER BY
+SET pg_strom.enabled = on;
+SELECT cat, array_agg(a ORDER BY id) v1, array_agg(x ORDER BY x) v2,
+            array_agg(d ORDER BY id DESC) v3,
+            string_agg(t, ',' ORDER BY id) v4, string_agg(t, '' ORDER BY t) v5,
+            count(*) c
+  INTO test01g
+  FROM rt_array
+ GROUP BY cat;
+SET pg_strom.enabled = off;
+SELECT cat, array_agg(a ORDER BY id) v1, array_agg(x ORDER BY x) v2,
+            array_agg(d ORDER BY id DESC) v3,
+            string_agg(t, ',' ORDER BY id) v4, string_agg(t, '' ORDER BY t) v5,
+            count(*) c
+  INTO test01p
+  FROM rt_array
+ GROUP BY cat;
+(SELECT * FROM test01g EXCEPT ALL SELECT * FROM test01p) ORDER BY cat;
+(SELECT * FROM test01p EXCEPT ALL SELECT * FROM test01g) ORDER BY cat;
+
+-- array_agg and string_agg without ORDER BY; compare the sorted items
+SET pg_strom.enabled = on;
+SELECT cat, array_agg(a) v1, string_agg(t, '|') v2
+  INTO test02g
+  FROM rt_array
+ WHERE x > 0
+ GROUP BY cat;
+SET pg_strom.enabled = off;
+SELECT cat, array_agg(a) v1, string_agg(t, '|') v2
+  INTO test02p
+  FROM rt_array
+ WHERE x > 0
+ GROUP BY cat;
+SELECT count(*) = (SELECT count(*) FROM test02p) AS ok
+  FROM test02g g, test02p p
+ WHERE g.cat = p.cat
+   AND (SELECT array_agg(v ORDER BY v) FROM unnest(g.v1) v) IS NOT DISTINCT FROM
+       (SELECT array_agg(v ORDER BY v) FROM unnest(p.v1) v)
+   AND (SELECT array_agg(v ORDER BY v) FROM unnest(string_to_array(g.v2, '|')) v) IS NOT DISTINCT FROM
+       (SELECT array_agg(v ORDER BY v) FROM unnest(string_to_array(p.v2, '|')) v);
+
+-- array_agg and string_agg without GROUP BY
+SET pg_strom.enabled = on;
+SELECT array_agg(a ORDER BY id) v1, string_agg(t, '-' ORDER BY id) v2
+  INTO test03g
+  FROM rt_array
+ WHERE cat = 77;
+SET pg_strom.enabled = off;
+SELECT array_agg(a ORDER BY id) v1, string_agg(t, '-' ORDER BY id) v2
+  INTO test03p
+  FROM rt_array
+ WHERE cat = 77;
+(SELECT * FROM test03g EXCEPT ALL SELECT * FROM test03p);
+(SELECT * FROM test03p EXCEPT ALL SELECT * FROM test03g);
+
+-- array values as GROUP BY and hash-join keys
+CREATE TABLE rt_array_keys (
+  id    int,
+  k     int4[],
+  p     text[],
+  x     float8
+);
+INSERT INTO rt_array_keys (
+  SELECT i, CASE WHEN i % 101 = 0 THEN NULL
+                 WHEN i % 37 = 0 THEN ARRAY[i % 5, NULL]
+                 ELSE ARRAY[i % 5, i % 7] END,
+            string_to_array('/usr/' || (i % 3) || '/lib' || (i % 4), '/'),
+            pgstrom.random_float(1, -1000.0, 1000.0)
+    FROM generate_series(1,30000) i);
+CREATE TABLE rt_array_dim (
+  k     int4[],
+  name  text
+);
+INSERT INTO rt_array_dim (
+  SELECT ARRAY[i, j], i || '-' || j
+    FROM generate_series(0,4) i, generate_series(0,5) j);
+VACUUM ANALYZE;
+SET pg_strom.enabled = on;
+SELECT k, p, count(*) c, max(x) mx INTO test04g
+  FROM rt_array_keys
+ GROUP BY k, p;
+SELECT id, name INTO test05g
+  FROM rt_array_keys r, rt_array_dim d
+ WHERE r.k = d.k;
+SET pg_strom.enabled = off;
+SELECT k, p, count(*) c, max(x) mx INTO test04p
+  FROM rt_array_keys
+ GROUP BY k, p;
+SELECT id, name INTO test05p
+  FROM rt_array_keys r, rt_array_dim d
+ WHERE r.k = d.k;
+(SELECT * FROM test04g EXCEPT ALL SELECT * FROM test04p) ORDER BY k, p;
+(SELECT * FROM test04p EXCEPT ALL SELECT * FROM test04g) ORDER BY k, p;
+(SELECT * FROM test05g EXCEPT ALL SELECT * FROM test05p) ORDER BY id;
+(SELECT * FROM test05p EXCEPT ALL SELECT * FROM test05g) ORDER BY id;
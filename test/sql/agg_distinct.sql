@@ -0,0 +1,90 @@
+---
+--- Test cases for DISTINCT aggregates
+---
+SET pg_strom.regression_test_mode = on;
+SET client_min_messages = error;
+DROP SCHEMA IF EXISTS regtest_agg_distinct_temp CASCADE;
+CREATE SCHEMA regtest_agg_distinct_temp;
+RESET client_min_messages;
+
+SET search_path = regtest_agg_distinct_temp,public;
+CREATE TABLE rt_distinct (
+  id    int,
+  cat   int,
+  a     int4,
+  b     int8,
+  t     text
+);
+SELECT pgstrom.random_setseed(20261027);
+INSERT INTO rt_distinct (
+  SELECT i, i % 30,
+            pgstrom.random_int(1, 0, 500),
+            pgstrom.random_int(2, -40000, 40000),
+            pgstrom.random_text_len(1, 3)
+    FROM generate_series(1,40000) i);
+VACUUM ANALYZE;
+
+-- force to use GpuScan, instead of SeqScan
+SET enable_seqscan = off;
+
+-- DISTINCT aggregates with GROUP BY, mixed with normal aggregates
+SET pg_strom.enabled = on;
+SELECT cat, count(distinct a) da, count(distinct t) dt,
+            sum(distinct b) sb, count(*) c, sum(a) s, max(b) mx
+  INTO test01g
+  FROM rt_distinct
+ GROUP BY cat;
+SET pg_strom.enabled = off;
+SELECT cat, count(distinct a) da, count(distinct t) dt,
+            sum(distinct b) sb, count(*) c, sum(a) s, max(b) mx
+  INTO test01p
+  FROM rt_distinct
+ GROUP BY cat;
+(SELECT * FROM test01g EXCEPT ALL SELECT * FROM test01p) ORDER BY cat;
+(SELECT * FROM test01p EXCEPT ALL SELECT * FROM test01g) ORDER BY cat;
+
+-- DISTINCT aggregates without GROUP BY
+SET pg_strom.enabled = on;
+SELECT count(distinct a) da, count(distinct b) db, avg(distinct a) aa, count(b) c
+  INTO test02g
+  FROM rt_distinct
+ WHERE id % 3 = 0;
+SET pg_strom.enabled = off;
+SELECT count(distinct a) da, count(distinct b) db, avg(distinct a) aa, count(b) c
+  INTO test02p
+  FROM rt_distinct
+ WHERE id % 3 = 0;
+(SELECT * FROM test02g EXCEPT ALL SELECT * FROM test02p);
+(SELECT * FROM test02p EXCEPT ALL SELECT * FROM test02g);
+
+-- DISTINCT aggregates with FILTER
+SET pg_strom.enabled = on;
+SELECT cat, count(distinct a) FILTER (WHERE b > 0) da, count(*) c
+  INTO test03g
+  FROM rt_distinct
+ GROUP BY cat;
+SET pg_strom.enabled = off;
+SELECT cat, count(distinct a) FILTER (WHERE b > 0) da, count(*) c
+  INTO test03p
+  FROM rt_distinct
+ GROUP BY cat;
+(SELECT * FROM test03g EXCEPT ALL SELECT * FROM test03p) ORDER BY cat;
+(SELECT * FROM test03p EXCEPT ALL SELECT * FROM test03g) ORDER BY cat;
+
+-- SELECT DISTINCT without aggregate functions
+SET pg_strom.enabled = on;
+SELECT DISTINCT cat, a % 50 am INTO test04g
+  FROM rt_distinct
+ WHERE b > 0;
+SELECT DISTINCT t INTO test05g
+  FROM rt_distinct;
+SET pg_strom.enabled = off;
+SELECT DISTINCT cat, a % 50 am INTO test04p
+  FROM rt_distinct
+ WHERE b > 0;
+SELECT DISTINCT t INTO test05p
+  FROM rt_distinct;
+(SELECT * FROM test04g EXCEPT ALL SELECT * FROM test04p) ORDER BY cat, am;
+(SELECT * FROM test04p EXCEPT ALL SELECT * FROM test04g) ORDER BY cat, am;
+(SELECT * FROM test05g EXCEPT ALL SELECT * FROM test05p) ORDER BY t;
+(SELECT * FROM test05p EXCEPT ALL SELECT * FROM test05g) ORDER BY t;
@@ -0,0 +1,73 @@
+---
+--- Test cases for GROUPING SETS, ROLLUP and CUBE
+---
+SET pg_strom.regression_test_mode = on;
+SET client_min_messages = error;
+DROP SCHEMA IF EXISTS regtest_agg_groupingsets_temp CASCADE;
+CREATE SCHEMA regtest_agg_groupingsets_temp;
+RESET client_min_messages;
+
+SET search_path = regtest_agg_groupingsets_temp,public;
+CREATE TABLE rt_gsets (
+  id    int,
+  k1    int,
+  k2    int,
+  k3    text,
+  a     int8,
+  x     float8
+);
+SELECT pgstrom.random_setseed(20261028);
+INSERT INTO rt_gsets (
+  SELECT i, i % 7, i % 11,
+            pgstrom.random_text_len(1, 1),
+            pgstrom.random_int(1, -4000000000, 4000000000),
+            pgstrom.random_float(1, -1000.0, 1000.0)
+    FROM generate_series(1,40000) i);
+VACUUM ANALYZE;
+
+-- force to use GpuScan, instead of SeqScan
+SET enable_seqscan = off;
+
+-- GROUPING SETS
+SET pg_strom.enabled = on;
+SELECT k1, k2, grouping(k1, k2) g, count(*) c, sum(a) s, min(x) mn, max(x) mx
+  INTO test01g
+  FROM rt_gsets
+ GROUP BY GROUPING SETS ((k1), (k2), (k1, k2), ());
+SET pg_strom.enabled = off;
+SELECT k1, k2, grouping(k1, k2) g, count(*) c, sum(a) s, min(x) mn, max(x) mx
+  INTO test01p
+  FROM rt_gsets
+ GROUP BY GROUPING SETS ((k1), (k2), (k1, k2), ());
+(SELECT * FROM test01g EXCEPT ALL SELECT * FROM test01p) ORDER BY k1, k2, g;
+(SELECT * FROM test01p EXCEPT ALL SELECT * FROM test01g) ORDER BY k1, k2, g;
+
+-- ROLLUP, with NULL grouping keys
+SET pg_strom.enabled = on;
+SELECT k1, k3, grouping(k1, k3) g, count(*) c, count(x) cx, sum(a) s
+  INTO test02g
+  FROM rt_gsets
+ WHERE id % 2 = 0
+ GROUP BY ROLLUP (k1, k3);
+SET pg_strom.enabled = off;
+SELECT k1, k3, grouping(k1, k3) g, count(*) c, count(x) cx, sum(a) s
+  INTO test02p
+  FROM rt_gsets
+ WHERE id % 2 = 0
+ GROUP BY ROLLUP (k1, k3);
+(SELECT * FROM test02g EXCEPT ALL SELECT * FROM test02p) ORDER BY k1, k3, g;
+(SELECT * FROM test02p EXCEPT ALL SELECT * FROM test02g) ORDER BY k1, k3, g;
+
+-- CUBE
+SET pg_strom.enabled = on;
+SELECT k1, k2, k3, grouping(k1, k2, k3) g, count(*) c, max(a) mx
+  INTO test03g
+  FROM rt_gsets
+ GROUP BY CUBE (k1, k2, k3);
+SET pg_strom.enabled = off;
+SELECT k1, k2, k3, grouping(k1, k2, k3) g, count(*) c, max(a) mx
+  INTO test03p
+  FROM rt_gsets
+ GROUP BY CUBE (k1, k2, k3);
+(SELECT * FROM test03g EXCEPT ALL SELECT * FROM test03p) ORDER BY k1, k2, k3, g;
+(SELECT * FROM test03p EXCEPT ALL SELECT * FROM test03g) ORDER BY k1, k2, k3, g;
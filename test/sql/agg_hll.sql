@@ -0,0 +1,78 @@
+---
+--- Test cases for HyperLogLog sketch functions / aggregates
+---
+SET pg_strom.regression_test_mode = on;
+SET client_min_messages = error;
+DROP SCHEMA IF EXISTS regtest_agg_hll_temp CASCADE;
+CREATE SCHEMA regtest_agg_hll_temp;
+RESET client_min_messages;
+
+SET search_path = regtest_agg_hll_temp,public;
+CREATE TABLE rt_hll (
+  id    int,
+  cat   int,
+  x     int4,
+  y     int8,
+  t     text
+);
+SELECT pgstrom.random_setseed(20261015);
+INSERT INTO rt_hll (
+  SELECT i, i % 8,
+            pgstrom.random_int(1, 0, 200000),
+            pgstrom.random_int(1, -4000000000, 4000000000),
+            md5((i % 5000)::text)
+    FROM generate_series(1,100000) i);
+VACUUM ANALYZE;
+
+-- force to use GpuPreAgg, instead of SeqScan
+SET enable_seqscan = off;
+SET pg_strom.hll_registers_bits = 12;
+
+-- hll_count with GROUP BY
+SET pg_strom.enabled = on;
+SELECT cat, pgstrom.hll_count(x) x, pgstrom.hll_count(y) y,
+            pgstrom.hll_count(t) t
+  INTO test01g
+  FROM rt_hll
+ GROUP BY cat;
+SET pg_strom.enabled = off;
+SELECT cat, pgstrom.hll_count(x) x, pgstrom.hll_count(y) y,
+            pgstrom.hll_count(t) t
+  INTO test01p
+  FROM rt_hll
+ GROUP BY cat;
+(SELECT * FROM test01g EXCEPT ALL SELECT * FROM test01p) ORDER BY cat;
+(SELECT * FROM test01p EXCEPT ALL SELECT * FROM test01g) ORDER BY cat;
+
+-- the estimation must be close to COUNT(distinct)
+SELECT bool_and(abs(g.x - e.x) <= 0.05 * e.x AND
+                abs(g.y - e.y) <= 0.05 * e.y AND
+                abs(g.t - e.t) <= 0.05 * e.t) AS ok
+  FROM test01g g,
+       (SELECT cat, count(distinct x) x, count(distinct y) y,
+                    count(distinct t) t
+          FROM rt_hll
+         GROUP BY cat) e
+ WHERE g.cat = e.cat;
+
+-- rollup of the stored sketches
+SET pg_strom.enabled = on;
+SELECT cat, pgstrom.hll_sketch(x) x, pgstrom.hll_sketch(t) t
+  INTO test02g
+  FROM rt_hll
+ GROUP BY cat;
+SET pg_strom.enabled = off;
+SELECT cat, pgstrom.hll_sketch(x) x, pgstrom.hll_sketch(t) t
+  INTO test02p
+  FROM rt_hll
+ GROUP BY cat;
+(SELECT * FROM test02g EXCEPT ALL SELECT * FROM test02p) ORDER BY cat;
+(SELECT * FROM test02p EXCEPT ALL SELECT * FROM test02g) ORDER BY cat;
+SELECT bool_and(pgstrom.hll_cardinality(s.x) = g.x AND
+                pgstrom.hll_cardinality(s.t) = g.t) AS ok
+  FROM test02g s, test01g g
+ WHERE s.cat = g.cat;
+SELECT (pgstrom.hll_count(x) = (SELECT pgstrom.hll_count(x) FROM rt_hll) AND
+        pgstrom.hll_cardinality(pgstrom.hll_union(t)) =
+               (SELECT pgstrom.hll_count(t) FROM rt_hll)) AS ok
+  FROM test02g;
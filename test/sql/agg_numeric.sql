@@ -0,0 +1,88 @@
+---
+--- Test cases for exact SUM/AVG on numeric with bounded precision
+---
+SET pg_strom.regression_test_mode = on;
+SET client_min_messages = error;
+DROP SCHEMA IF EXISTS regtest_agg_numeric_temp CASCADE;
+CREATE SCHEMA regtest_agg_numeric_temp;
+RESET client_min_messages;
+
+SET search_path = regtest_agg_numeric_temp,public;
+CREATE TABLE rt_agg_numeric (
+  id    int,
+  cat   int,
+  a     numeric(12,2),
+  b     numeric(20,6),
+  c     numeric(28,0),
+  x     numeric
+);
+SELECT pgstrom.random_setseed(20261016);
+INSERT INTO rt_agg_numeric (
+  SELECT i, i % 20,
+            pgstrom.random_int(1, -100000000, 100000000)::numeric / 100::numeric,
+            pgstrom.random_int(1, -4000000000000, 4000000000000)::numeric / 1000000::numeric,
+            pgstrom.random_int(1, -4000000000000000000, 4000000000000000000)::numeric *
+                1000000000::numeric,
+            pgstrom.random_float(1, -20000.0, 20000.0)::numeric
+    FROM generate_series(1,100000) i);
+VACUUM ANALYZE;
+
+-- force to use GpuPreAgg, instead of SeqScan
+SET enable_seqscan = off;
+
+-- SUM/AVG with GROUP BY
+SET pg_strom.enabled = on;
+SELECT cat, sum(a) sum_a, avg(a) avg_a,
+            sum(b) sum_b, avg(b) avg_b,
+            sum(c) sum_c, avg(c) avg_c
+  INTO test01g
+  FROM rt_agg_numeric
+ GROUP BY cat;
+SET pg_strom.enabled = off;
+SELECT cat, sum(a) sum_a, avg(a) avg_a,
+            sum(b) sum_b, avg(b) avg_b,
+            sum(c) sum_c, avg(c) avg_c
+  INTO test01p
+  FROM rt_agg_numeric
+ GROUP BY cat;
+(SELECT * FROM test01g EXCEPT ALL SELECT * FROM test01p) ORDER BY cat;
+(SELECT * FROM test01p EXCEPT ALL SELECT * FROM test01g) ORDER BY cat;
+
+-- SUM/AVG without GROUP BY, with WHERE clause
+SET pg_strom.enabled = on;
+SELECT sum(a) sum_a, avg(a) avg_a, sum(b) sum_b, avg(b) avg_b,
+       count(*) nrows
+  INTO test02g
+  FROM rt_agg_numeric
+ WHERE id % 7 = 3;
+SET pg_strom.enabled = off;
+SELECT sum(a) sum_a, avg(a) avg_a, sum(b) sum_b, avg(b) avg_b,
+       count(*) nrows
+  INTO test02p
+  FROM rt_agg_numeric
+ WHERE id % 7 = 3;
+(SELECT * FROM test02g EXCEPT ALL SELECT * FROM test02p);
+(SELECT * FROM test02p EXCEPT ALL SELECT * FROM test02g);
+
+-- numeric without typmod is not exact, but still must work
+SET pg_strom.enabled = on;
+SELECT cat, round(sum(x), 6) sum_x, count(x) nitems
+  INTO test03g
+  FROM rt_agg_numeric
+ GROUP BY cat;
+SET pg_strom.enabled = off;
+SELECT cat, round(sum(x), 6) sum_x, count(x) nitems
+  INTO test03p
+  FROM rt_agg_numeric
+ GROUP BY cat;
+SELECT bool_and(abs(g.sum_x - p.sum_x) < 1.0 AND g.nitems = p.nitems) AS ok
+  FROM test03g g, test03p p
+ WHERE g.cat = p.cat;
+
+-- no rows
+SET pg_strom.enabled = on;
+SELECT sum(a) sum_a, avg(b) avg_b
+  INTO test04g
+  FROM rt_agg_numeric
+ WHERE id < 0;
+SELECT (sum_a IS NULL AND avg_b IS NULL) AS ok FROM test04g;
@@ -0,0 +1,75 @@
+---
+--- Test cases for percentile_approx() aggregate function
+---
+SET pg_strom.regression_test_mode = on;
+SET client_min_messages = error;
+DROP SCHEMA IF EXISTS regtest_agg_percentile_temp CASCADE;
+CREATE SCHEMA regtest_agg_percentile_temp;
+RESET client_min_messages;
+
+SET search_path = regtest_agg_percentile_temp,public;
+CREATE TABLE rt_percentile (
+  id    int,
+  cat   int,
+  x     float8,
+  y     float8
+);
+SELECT pgstrom.random_setseed(20261014);
+INSERT INTO rt_percentile (
+  SELECT i, i % 12,
+            pgstrom.random_float(2,     1.0, 50000.0),
+            pgstrom.random_float(2, -1000.0,  1000.0)
+    FROM generate_series(1,120000) i);
+VACUUM ANALYZE;
+
+-- force to use GpuPreAgg, instead of SeqScan
+SET enable_seqscan = off;
+
+-- percentile_approx with GROUP BY
+SET pg_strom.enabled = on;
+SELECT cat, pgstrom.percentile_approx(x, 0.5)  p50,
+            pgstrom.percentile_approx(x, 0.95) p95,
+            pgstrom.percentile_approx(y, 0.99) p99
+  INTO test01g
+  FROM rt_percentile
+ GROUP BY cat;
+SET pg_strom.enabled = off;
+SELECT cat, pgstrom.percentile_approx(x, 0.5)  p50,
+            pgstrom.percentile_approx(x, 0.95) p95,
+            pgstrom.percentile_approx(y, 0.99) p99
+  INTO test01p
+  FROM rt_percentile
+ GROUP BY cat;
+(SELECT * FROM test01g EXCEPT ALL SELECT * FROM test01p) ORDER BY cat;
+(SELECT * FROM test01p EXCEPT ALL SELECT * FROM test01g) ORDER BY cat;
+
+-- percentile_approx without GROUP BY, with the edge fractions
+SET pg_strom.enabled = on;
+SELECT pgstrom.percentile_approx(x, 0.0) p0,
+       pgstrom.percentile_approx(x, 0.5) p50,
+       pgstrom.percentile_approx(x, 1.0) p100,
+       min(x) x_min, max(x) x_max
+  INTO test02g
+  FROM rt_percentile
+ WHERE id % 3 = 0;
+SET pg_strom.enabled = off;
+SELECT pgstrom.percentile_approx(x, 0.0) p0,
+       pgstrom.percentile_approx(x, 0.5) p50,
+       pgstrom.percentile_approx(x, 1.0) p100,
+       min(x) x_min, max(x) x_max
+  INTO test02p
+  FROM rt_percentile
+ WHERE id % 3 = 0;
+(SELECT * FROM test02g EXCEPT ALL SELECT * FROM test02p);
+(SELECT * FROM test02p EXCEPT ALL SELECT * FROM test02g);
+SELECT (p0 = x_min AND p100 = x_max) AS ok FROM test02g;
+
+-- the estimation must be within the bucket width (1/8 of binade)
+SELECT bool_and(abs(g.p50 - e.p50) <= 0.125 * e.p50 AND
+                abs(g.p95 - e.p95) <= 0.125 * e.p95) AS ok
+  FROM test01g g,
+       (SELECT cat, percentile_cont(0.5)  WITHIN GROUP (ORDER BY x) p50,
+                    percentile_cont(0.95) WITHIN GROUP (ORDER BY x) p95
+          FROM rt_percentile
+         GROUP BY cat) e
+ WHERE g.cat = e.cat;
@@ -0,0 +1,76 @@
+---
+--- Test cases for top_k() aggregate function
+---
+SET pg_strom.regression_test_mode = on;
+SET client_min_messages = error;
+DROP SCHEMA IF EXISTS regtest_agg_topk_temp CASCADE;
+CREATE SCHEMA regtest_agg_topk_temp;
+RESET client_min_messages;
+
+SET search_path = regtest_agg_topk_temp,public;
+CREATE TABLE rt_topk (
+  id    int,
+  cat   int,
+  a     int4,
+  x     float8
+);
+SELECT pgstrom.random_setseed(20261017);
+INSERT INTO rt_topk (
+  SELECT i, i % 16,
+            pgstrom.random_int(2, -50000, 50000),
+            pgstrom.random_float(2, -1000000.0, 1000000.0)
+    FROM generate_series(1,100000) i);
+VACUUM ANALYZE;
+
+-- force to use GpuPreAgg, instead of SeqScan
+SET enable_seqscan = off;
+
+-- top_k with GROUP BY
+SET pg_strom.enabled = on;
+SELECT cat, pgstrom.top_k(x, 5) x5, pgstrom.top_k(x, 32) x32,
+            pgstrom.top_k(a, 10) a10
+  INTO test01g
+  FROM rt_topk
+ GROUP BY cat;
+SET pg_strom.enabled = off;
+SELECT cat, pgstrom.top_k(x, 5) x5, pgstrom.top_k(x, 32) x32,
+            pgstrom.top_k(a, 10) a10
+  INTO test01p
+  FROM rt_topk
+ GROUP BY cat;
+(SELECT * FROM test01g EXCEPT ALL SELECT * FROM test01p) ORDER BY cat;
+(SELECT * FROM test01p EXCEPT ALL SELECT * FROM test01g) ORDER BY cat;
+
+-- top_k must be identical to the head of sorted values
+SELECT bool_and(g.x5 = e.x5 AND g.x32 = e.x32 AND g.a10 = e.a10) AS ok
+  FROM test01g g,
+       (SELECT cat,
+               (array_agg(x ORDER BY x DESC) FILTER (WHERE x IS NOT NULL))[1:5] x5,
+               (array_agg(x ORDER BY x DESC) FILTER (WHERE x IS NOT NULL))[1:32] x32,
+               (array_agg(a::float8 ORDER BY a DESC) FILTER (WHERE a IS NOT NULL))[1:10] a10
+          FROM rt_topk
+         GROUP BY cat) e
+ WHERE g.cat = e.cat;
+
+-- groups with less than k values
+SET pg_strom.enabled = on;
+SELECT cat, pgstrom.top_k(x, 8) x8
+  INTO test02g
+  FROM rt_topk
+ WHERE id <= 96
+ GROUP BY cat;
+SET pg_strom.enabled = off;
+SELECT cat, pgstrom.top_k(x, 8) x8
+  INTO test02p
+  FROM rt_topk
+ WHERE id <= 96
+ GROUP BY cat;
+(SELECT * FROM test02g EXCEPT ALL SELECT * FROM test02p) ORDER BY cat;
+(SELECT * FROM test02p EXCEPT ALL SELECT * FROM test02g) ORDER BY cat;
+SELECT bool_and(g.x8 = e.x8) AS ok
+  FROM test02g g,
+       (SELECT cat, array_agg(x ORDER BY x DESC) FILTER (WHERE x IS NOT NULL) x8
+          FROM rt_topk
+         WHERE id <= 96
+         GROUP BY cat) e
+ WHERE g.cat = e.cat;
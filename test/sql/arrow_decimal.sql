@@ -0,0 +1,78 @@
+---
+--- Test cases for numeric operators on Arrow::Decimal columns
+---
+SET pg_strom.regression_test_mode = on;
+SET client_min_messages = error;
+DROP SCHEMA IF EXISTS regtest_arrow_decimal_temp CASCADE;
+CREATE SCHEMA regtest_arrow_decimal_temp;
+RESET client_min_messages;
+
+SET search_path = regtest_arrow_decimal_temp,public;
+CREATE TABLE rt_decimal (
+  id    int,
+  cat   int,
+  a     numeric(12,2),
+  b     numeric(12,2),
+  c     numeric(18,4)
+);
+SELECT pgstrom.random_setseed(20261109);
+INSERT INTO rt_decimal (
+  SELECT i, i % 16,
+            pgstrom.random_float(1, -1000000.0, 1000000.0)::numeric(12,2),
+            pgstrom.random_float(1, -1000000.0, 1000000.0)::numeric(12,2),
+            pgstrom.random_float(1, -10000.0, 10000.0)::numeric(18,4)
+    FROM generate_series(1,30000) i);
+VACUUM ANALYZE;
+
+-- numeric(p,s) columns are written as Arrow::Decimal
+\set decimal_arrow `echo -n $MY_DATA_DIR/regtest_decimal.arrow`
+\! $PG2ARROW_CMD -c 'SELECT * FROM regtest_arrow_decimal_temp.rt_decimal' -o $MY_DATA_DIR/regtest_decimal.arrow
+IMPORT FOREIGN SCHEMA ft_decimal FROM SERVER arrow_fdw
+  INTO regtest_arrow_decimal_temp OPTIONS (file :'decimal_arrow');
+
+-- force to use GpuScan, instead of SeqScan
+SET enable_seqscan = off;
+
+-- comparison and arithmetic on the same scale, and on different scales
+SET pg_strom.enabled = on;
+SELECT id, a + b v1, a - b v2, a * b v3, a + c v4, c - a v5, a * c v6,
+           a < b v7, a = b v8, c >= a v9
+  INTO test01g
+  FROM ft_decimal
+ WHERE id > 0;
+SET pg_strom.enabled = off;
+SELECT id, a + b v1, a - b v2, a * b v3, a + c v4, c - a v5, a * c v6,
+           a < b v7, a = b v8, c >= a v9
+  INTO test01p
+  FROM ft_decimal
+ WHERE id > 0;
+(SELECT * FROM test01g EXCEPT ALL SELECT * FROM test01p) ORDER BY id;
+(SELECT * FROM test01p EXCEPT ALL SELECT * FROM test01g) ORDER BY id;
+
+-- Decimal in the WHERE clause, GROUP BY keys and SUM
+SET pg_strom.enabled = on;
+SELECT cat, count(*) n, sum(a) sa, sum(c) sc, sum(a + b) sab, min(c) mn, max(a) mx
+  INTO test02g
+  FROM ft_decimal
+ WHERE a > b AND c < 5000.5
+ GROUP BY cat;
+SELECT b, count(*) n INTO test03g
+  FROM ft_decimal
+ WHERE abs(b) < 1000
+ GROUP BY b;
+SET pg_strom.enabled = off;
+SELECT cat, count(*) n, sum(a) sa, sum(c) sc, sum(a + b) sab, min(c) mn, max(a) mx
+  INTO test02p
+  FROM ft_decimal
+ WHERE a > b AND c < 5000.5
+ GROUP BY cat;
+SELECT b, count(*) n INTO test03p
+  FROM ft_decimal
+ WHERE abs(b) < 1000
+ GROUP BY b;
+(SELECT * FROM test02g EXCEPT ALL SELECT * FROM test02p) ORDER BY cat;
+(SELECT * FROM test02p EXCEPT ALL SELECT * FROM test02g) ORDER BY cat;
+(SELECT * FROM test03g EXCEPT ALL SELECT * FROM test03p) ORDER BY b;
+(SELECT * FROM test03p EXCEPT ALL SELECT * FROM test03g) ORDER BY b;
+-- the values read back are same as the source table
+(SELECT * FROM ft_decimal EXCEPT ALL SELECT * FROM rt_decimal) ORDER BY id;
@@ -0,0 +1,84 @@
+---
+--- Test cases for pgstrom.export_arrow()
+---
+SET pg_strom.regression_test_mode = on;
+SET client_min_messages = error;
+DROP SCHEMA IF EXISTS regtest_arrow_export_temp CASCADE;
+CREATE SCHEMA regtest_arrow_export_temp;
+RESET client_min_messages;
+
+SET search_path = regtest_arrow_export_temp,public;
+CREATE TABLE rt_export (
+  id    int,
+  cat   int,
+  a     int8,
+  b     float8,
+  c     text,
+  d     date,
+  ts    timestamp,
+  f     bool
+);
+SELECT pgstrom.random_setseed(20261022);
+INSERT INTO rt_export (
+  SELECT i, i % 20,
+            pgstrom.random_int(1, -4000000000, 4000000000),
+            pgstrom.random_float(1, -100000.0, 100000.0),
+            pgstrom.random_text_len(1, 32),
+            pgstrom.random_date(1),
+            pgstrom.random_timestamp(1),
+            CASE WHEN i % 7 = 0 THEN NULL ELSE i % 3 = 0 END
+    FROM generate_series(1,30000) i);
+VACUUM ANALYZE;
+
+\set export_arrow1 `echo -n $MY_DATA_DIR/regtest_export1.arrow`
+\set export_arrow2 `echo -n $MY_DATA_DIR/regtest_export2.arrow`
+\! rm -f $MY_DATA_DIR/regtest_export1.arrow $MY_DATA_DIR/regtest_export2.arrow
+
+-- force to use GpuScan, instead of SeqScan
+SET enable_seqscan = off;
+
+-- export the query result, then read it back by arrow_fdw
+SET pg_strom.enabled = on;
+SELECT pgstrom.export_arrow('SELECT * FROM rt_export WHERE id > 0',
+                            :'export_arrow1');
+IMPORT FOREIGN SCHEMA ft_export1 FROM SERVER arrow_fdw
+  INTO regtest_arrow_export_temp OPTIONS (file :'export_arrow1');
+(SELECT * FROM ft_export1 EXCEPT ALL SELECT * FROM rt_export) ORDER BY id;
+(SELECT * FROM rt_export EXCEPT ALL SELECT * FROM ft_export1) ORDER BY id;
+
+-- export the aggregation result with overwrite
+SELECT pgstrom.export_arrow('SELECT cat, count(*) nrows, sum(a)::int8 sum_a, max(d) max_d
+                               FROM rt_export GROUP BY cat',
+                            :'export_arrow2', true);
+SELECT pgstrom.export_arrow('SELECT cat, count(*) nrows, sum(a)::int8 sum_a, max(d) max_d
+                               FROM rt_export WHERE b > 0 GROUP BY cat',
+                            :'export_arrow2', true);
+IMPORT FOREIGN SCHEMA ft_export2 FROM SERVER arrow_fdw
+  INTO regtest_arrow_export_temp OPTIONS (file :'export_arrow2');
+SET pg_strom.enabled = off;
+SELECT cat, count(*) nrows, sum(a)::int8 sum_a, max(d) max_d
+  INTO test01p
+  FROM rt_export
+ WHERE b > 0
+ GROUP BY cat;
+(SELECT * FROM ft_export2 EXCEPT ALL SELECT * FROM test01p) ORDER BY cat;
+(SELECT * FROM test01p EXCEPT ALL SELECT * FROM ft_export2) ORDER BY cat;
+
+-- GpuScan on the exported file
+SET pg_strom.enabled = on;
+SELECT id, a, b, c
+  INTO test02g
+  FROM ft_export1
+ WHERE b < 0 AND c LIKE '%a%';
+SET pg_strom.enabled = off;
+SELECT id, a, b, c
+  INTO test02p
+  FROM ft_export1
+ WHERE b < 0 AND c LIKE '%a%';
+(SELECT * FROM test02g EXCEPT ALL SELECT * FROM test02p) ORDER BY id;
+(SELECT * FROM test02p EXCEPT ALL SELECT * FROM test02g) ORDER BY id;
+
+-- error cases
+SELECT pgstrom.export_arrow('SELECT 1', 'regtest_export.arrow');
+SELECT pgstrom.export_arrow('INSERT INTO rt_export VALUES (0)',
+                            :'export_arrow2', true);
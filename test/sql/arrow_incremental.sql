@@ -0,0 +1,80 @@
+---
+--- Test cases for incremental aggregates on arrow_fdw
+---
+SET pg_strom.regression_test_mode = on;
+SET client_min_messages = error;
+DROP SCHEMA IF EXISTS regtest_arrow_incremental_temp CASCADE;
+CREATE SCHEMA regtest_arrow_incremental_temp;
+RESET client_min_messages;
+
+SET search_path = regtest_arrow_incremental_temp,public;
+CREATE TABLE rt_src (
+  id    int,
+  cat   int,
+  a     int8,
+  x     float8,
+  flag  bool
+);
+SELECT pgstrom.random_setseed(20261024);
+INSERT INTO rt_src (
+  SELECT i, i % 25,
+            pgstrom.random_int(1, -4000000000, 4000000000),
+            pgstrom.random_float(1, -100000.0, 100000.0),
+            CASE WHEN i % 11 = 0 THEN NULL ELSE i % 97 = 0 END
+    FROM generate_series(1,30000) i);
+VACUUM ANALYZE;
+
+-- each pg2arrow run writes a record-batch
+\set incr_arrow `echo -n $MY_DATA_DIR/regtest_incremental.arrow`
+\! $PG2ARROW_CMD -c 'SELECT * FROM regtest_arrow_incremental_temp.rt_src WHERE id <= 10000' -o $MY_DATA_DIR/regtest_incremental.arrow
+IMPORT FOREIGN SCHEMA ft_incr FROM SERVER arrow_fdw
+  INTO regtest_arrow_incremental_temp OPTIONS (file :'incr_arrow');
+
+-- register the incremental aggregate, then merge the first record-batch
+SET pg_strom.enabled = on;
+SELECT pgstrom.arrow_incremental_create('rt_incr',
+         'SELECT cat, count(*) nrows, sum(a) sum_a, min(x) min_x, max(x) max_x,
+                 bool_or(flag) any_flag
+            FROM ft_incr GROUP BY cat',
+         'regtest_arrow_incremental_temp');
+SELECT pgstrom.arrow_incremental_refresh('rt_incr');
+SET pg_strom.enabled = off;
+SELECT cat, count(*) nrows, sum(a) sum_a, min(x) min_x, max(x) max_x,
+       bool_or(flag) any_flag
+  INTO test01p
+  FROM rt_src
+ WHERE id <= 10000
+ GROUP BY cat;
+(SELECT * FROM rt_incr EXCEPT ALL SELECT * FROM test01p) ORDER BY cat;
+(SELECT * FROM test01p EXCEPT ALL SELECT * FROM rt_incr) ORDER BY cat;
+
+-- append two record-batches, then merge them only
+\! $PG2ARROW_CMD -c 'SELECT * FROM regtest_arrow_incremental_temp.rt_src WHERE id > 10000 AND id <= 22000' --append=$MY_DATA_DIR/regtest_incremental.arrow
+\! $PG2ARROW_CMD -c 'SELECT * FROM regtest_arrow_incremental_temp.rt_src WHERE id > 22000' --append=$MY_DATA_DIR/regtest_incremental.arrow
+SET pg_strom.enabled = on;
+SELECT pgstrom.arrow_incremental_refresh('rt_incr');
+SELECT pgstrom.arrow_incremental_refresh('rt_incr');
+SET pg_strom.enabled = off;
+SELECT cat, count(*) nrows, sum(a) sum_a, min(x) min_x, max(x) max_x,
+       bool_or(flag) any_flag
+  INTO test02p
+  FROM rt_src
+ GROUP BY cat;
+(SELECT * FROM rt_incr EXCEPT ALL SELECT * FROM test02p) ORDER BY cat;
+(SELECT * FROM test02p EXCEPT ALL SELECT * FROM rt_incr) ORDER BY cat;
+SELECT filename = :'incr_arrow' AS ok
+  FROM pgstrom.arrow_incremental_files
+ WHERE agg_relid = 'rt_incr'::regclass AND nbatches = 3;
+
+-- not supported queries
+SELECT pgstrom.arrow_incremental_create('rt_incr_bad',
+         'SELECT cat, avg(x) FROM ft_incr GROUP BY cat');
+SELECT pgstrom.arrow_incremental_create('rt_incr_bad',
+         'SELECT cat, count(*) FROM rt_src GROUP BY cat');
+SELECT pgstrom.arrow_incremental_refresh('rt_src');
+
+-- cleanup
+SELECT pgstrom.arrow_incremental_drop('rt_incr');
+SELECT count(*) = 0 AS ok
+  FROM pgstrom.arrow_incremental_aggs
+ WHERE agg_relid::text LIKE '%rt_incr%';
@@ -0,0 +1,74 @@
+---
+--- Test cases for INSERT / COPY FROM on writable arrow_fdw
+---
+SET pg_strom.regression_test_mode = on;
+SET client_min_messages = error;
+DROP SCHEMA IF EXISTS regtest_arrow_insert_temp CASCADE;
+CREATE SCHEMA regtest_arrow_insert_temp;
+RESET client_min_messages;
+
+SET search_path = regtest_arrow_insert_temp,public;
+CREATE TABLE rt_src (
+  id    int,
+  a     int8,
+  x     float8,
+  t     text,
+  d     date,
+  ts    timestamp,
+  f     bool
+);
+SELECT pgstrom.random_setseed(20261108);
+INSERT INTO rt_src (
+  SELECT i, pgstrom.random_int(1, -4000000000, 4000000000),
+            pgstrom.random_float(1, -100000.0, 100000.0),
+            pgstrom.random_text_len(1, 24),
+            pgstrom.random_date(1),
+            pgstrom.random_timestamp(1),
+            CASE WHEN i % 9 = 0 THEN NULL ELSE i % 4 = 0 END
+    FROM generate_series(1,30000) i);
+VACUUM ANALYZE;
+
+\set insert_arrow `echo -n $MY_DATA_DIR/regtest_insert.arrow`
+\set insert_csv `echo -n $MY_DATA_DIR/regtest_insert.csv`
+\! rm -f $MY_DATA_DIR/regtest_insert.arrow $MY_DATA_DIR/regtest_insert.csv
+CREATE FOREIGN TABLE ft_insert (
+  id    int,
+  a     int8,
+  x     float8,
+  t     text,
+  d     date,
+  ts    timestamp,
+  f     bool
+) SERVER arrow_fdw OPTIONS (file :'insert_arrow', writable 'true');
+
+-- INSERT ... SELECT, and COPY FROM
+INSERT INTO ft_insert (SELECT * FROM rt_src WHERE id <= 20000);
+COPY (SELECT * FROM rt_src WHERE id > 20000) TO :'insert_csv' (FORMAT csv);
+COPY ft_insert FROM :'insert_csv' (FORMAT csv);
+SET pg_strom.enabled = off;
+(SELECT * FROM ft_insert EXCEPT ALL SELECT * FROM rt_src) ORDER BY id;
+(SELECT * FROM rt_src EXCEPT ALL SELECT * FROM ft_insert) ORDER BY id;
+
+-- rows are not visible until commit, and discarded on abort
+BEGIN;
+INSERT INTO ft_insert VALUES (30001, 1, 1.0, 'uncommitted', NULL, NULL, true);
+SELECT count(*) = 30000 AS ok FROM ft_insert;
+ROLLBACK;
+SELECT count(*) = 30000 AS ok FROM ft_insert;
+BEGIN;
+INSERT INTO ft_insert VALUES (30002, 2, 2.0, 'committed', '2026-11-08', NULL, false);
+COMMIT;
+SELECT count(*) = 30001 AS ok FROM ft_insert;
+
+-- GpuScan on the written file, with the min/max statistics
+SET enable_seqscan = off;
+SET pg_strom.enabled = on;
+SELECT id, a, t, d INTO test01g
+  FROM ft_insert
+ WHERE d >= '2020-01-01' AND a > 0;
+SET pg_strom.enabled = off;
+SELECT id, a, t, d INTO test01p
+  FROM ft_insert
+ WHERE d >= '2020-01-01' AND a > 0;
+(SELECT * FROM test01g EXCEPT ALL SELECT * FROM test01p) ORDER BY id;
+(SELECT * FROM test01p EXCEPT ALL SELECT * FROM test01g) ORDER BY id;
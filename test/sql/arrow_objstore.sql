@@ -0,0 +1,73 @@
+---
+--- Test cases for arrow_fdw on the S3-compatible object storage
+---
+--- It runs only when MY_S3_ENDPOINT and MY_S3_BUCKET are given. The bucket
+--- must be writable with AWS_ACCESS_KEY_ID / AWS_SECRET_ACCESS_KEY, if any.
+---
+SET pg_strom.regression_test_mode = on;
+\set s3_endpoint `echo -n $MY_S3_ENDPOINT`
+\set s3_bucket `echo -n $MY_S3_BUCKET`
+\set s3_region `echo -n ${MY_S3_REGION:-us-east-1}`
+SELECT :'s3_endpoint' = '' OR :'s3_bucket' = '' AS skip_test \gset
+\if :skip_test
+\quit
+\endif
+SET client_min_messages = error;
+DROP SCHEMA IF EXISTS regtest_arrow_objstore_temp CASCADE;
+CREATE SCHEMA regtest_arrow_objstore_temp;
+RESET client_min_messages;
+
+SET search_path = regtest_arrow_objstore_temp,public;
+CREATE TABLE rt_objstore (
+  id    int,
+  cat   int,
+  a     int8,
+  b     float8,
+  c     text,
+  d     date
+);
+SELECT pgstrom.random_setseed(20261122);
+INSERT INTO rt_objstore (
+  SELECT i, i % 20,
+            pgstrom.random_int(1, -4000000000, 4000000000),
+            pgstrom.random_float(1, -100000.0, 100000.0),
+            pgstrom.random_text_len(1, 32),
+            pgstrom.random_date(1)
+    FROM generate_series(1,200000) i);
+VACUUM ANALYZE;
+
+\set objstore_arrow `echo -n $MY_DATA_DIR/regtest_objstore.arrow`
+\set objstore_url `echo -n s3://$MY_S3_BUCKET/regtest_objstore.arrow`
+\! rm -f $MY_DATA_DIR/regtest_objstore.arrow
+
+-- make an arrow file with multiple record-batches, then upload it
+SELECT pgstrom.export_arrow('SELECT * FROM rt_objstore ORDER BY id',
+                            :'objstore_arrow');
+\! curl -sf -o /dev/null ${AWS_ACCESS_KEY_ID:+--aws-sigv4 "aws:amz:${MY_S3_REGION:-us-east-1}:s3" --user "$AWS_ACCESS_KEY_ID:$AWS_SECRET_ACCESS_KEY"} -T $MY_DATA_DIR/regtest_objstore.arrow $MY_S3_ENDPOINT/$MY_S3_BUCKET/regtest_objstore.arrow
+
+SET arrow_fdw.s3_endpoint = :'s3_endpoint';
+SET arrow_fdw.s3_region = :'s3_region';
+IMPORT FOREIGN SCHEMA ft_objstore FROM SERVER arrow_fdw
+  INTO regtest_arrow_objstore_temp OPTIONS (file :'objstore_url');
+
+-- read the object by arrow_fdw
+SET pg_strom.enabled = off;
+(SELECT * FROM ft_objstore EXCEPT ALL SELECT * FROM rt_objstore) ORDER BY id;
+(SELECT * FROM rt_objstore EXCEPT ALL SELECT * FROM ft_objstore) ORDER BY id;
+
+-- force to use GpuScan, instead of SeqScan
+SET enable_seqscan = off;
+
+-- GpuScan on the object; the second scan reads the local cache
+SET pg_strom.enabled = on;
+SELECT id, a, b, c INTO test01g FROM ft_objstore WHERE b < 0 AND c LIKE '%a%';
+SELECT cat, count(*) nrows, sum(a) sum_a INTO test02g
+  FROM ft_objstore WHERE d > '2020-01-01' GROUP BY cat;
+SET pg_strom.enabled = off;
+SELECT id, a, b, c INTO test01p FROM rt_objstore WHERE b < 0 AND c LIKE '%a%';
+SELECT cat, count(*) nrows, sum(a) sum_a INTO test02p
+  FROM rt_objstore WHERE d > '2020-01-01' GROUP BY cat;
+(SELECT * FROM test01g EXCEPT ALL SELECT * FROM test01p) ORDER BY id;
+(SELECT * FROM test01p EXCEPT ALL SELECT * FROM test01g) ORDER BY id;
+(SELECT * FROM test02g EXCEPT ALL SELECT * FROM test02p) ORDER BY cat;
+(SELECT * FROM test02p EXCEPT ALL SELECT * FROM test02g) ORDER BY cat;
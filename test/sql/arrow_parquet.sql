@@ -0,0 +1,129 @@
+---
+--- Test cases for Apache Parquet files on arrow_fdw
+---
+--- It runs only when pyarrow is available on plpython3u.
+---
+SET pg_strom.regression_test_mode = on;
+CREATE FUNCTION pg_temp.has_pyarrow()
+RETURNS bool AS
+$$
+try:
+    import pyarrow.parquet
+except ImportError:
+    return False
+return True
+$$ LANGUAGE 'plpython3u';
+SELECT NOT pg_temp.has_pyarrow() AS skip_test \gset
+\if :skip_test
+\quit
+\endif
+SET client_min_messages = error;
+DROP SCHEMA IF EXISTS regtest_arrow_parquet_temp CASCADE;
+CREATE SCHEMA regtest_arrow_parquet_temp;
+RESET client_min_messages;
+
+SET search_path = regtest_arrow_parquet_temp,public;
+CREATE TABLE rt_parquet (
+  id    int,
+  cat   int,
+  a     int8,
+  b     float8,
+  c     text,
+  d     date,
+  f     bool
+);
+SELECT pgstrom.random_setseed(20261121);
+INSERT INTO rt_parquet (
+  SELECT i, i % 20,
+            pgstrom.random_int(1, -4000000000, 4000000000),
+            pgstrom.random_float(1, -100000.0, 100000.0),
+            pgstrom.random_text_len(1, 32),
+            pgstrom.random_date(1),
+            CASE WHEN i % 7 = 0 THEN NULL ELSE i % 3 = 0 END
+    FROM generate_series(1,30000) i);
+VACUUM ANALYZE;
+
+-- write the table to the parquet file by pyarrow
+CREATE FUNCTION write_parquet(fname text, compression text,
+                              row_group_size int, use_dictionary bool,
+                              data_page_version text)
+RETURNS void AS
+$$
+import datetime
+import pyarrow as pa
+import pyarrow.parquet as pq
+
+rows = plpy.execute('SELECT * FROM rt_parquet ORDER BY id')
+schema = pa.schema([('id',  pa.int32()),
+                    ('cat', pa.int32()),
+                    ('a',   pa.int64()),
+                    ('b',   pa.float64()),
+                    ('c',   pa.utf8()),
+                    ('d',   pa.date32()),
+                    ('f',   pa.bool_())])
+cols = {}
+for name in schema.names:
+    cols[name] = [r[name] for r in rows]
+cols['d'] = [datetime.date.fromisoformat(x) if x is not None else None
+             for x in cols['d']]
+table = pa.Table.from_pydict(cols, schema=schema)
+pq.write_table(table, fname,
+               compression=compression,
+               row_group_size=row_group_size,
+               use_dictionary=use_dictionary,
+               data_page_version=data_page_version,
+               write_statistics=True)
+$$ LANGUAGE 'plpython3u';
+
+\set parquet1 `echo -n $MY_DATA_DIR/regtest_parquet1.parquet`
+\set parquet2 `echo -n $MY_DATA_DIR/regtest_parquet2.parquet`
+\set parquet3 `echo -n $MY_DATA_DIR/regtest_parquet3.parquet`
+\! rm -f $MY_DATA_DIR/regtest_parquet1.parquet $MY_DATA_DIR/regtest_parquet2.parquet $MY_DATA_DIR/regtest_parquet3.parquet
+
+-- plain encoding, no compression, single row-group
+SELECT write_parquet(:'parquet1', 'none', 100000, false, '1.0');
+-- dictionary encoding, snappy, multiple row-groups
+SELECT write_parquet(:'parquet2', 'snappy', 4000, true, '1.0');
+-- dictionary encoding, zstd, multiple row-groups with DATA_PAGE v2
+SELECT write_parquet(:'parquet3', 'zstd', 7000, true, '2.0');
+IMPORT FOREIGN SCHEMA ft_parquet1 FROM SERVER arrow_fdw
+  INTO regtest_arrow_parquet_temp OPTIONS (file :'parquet1');
+IMPORT FOREIGN SCHEMA ft_parquet2 FROM SERVER arrow_fdw
+  INTO regtest_arrow_parquet_temp OPTIONS (file :'parquet2');
+IMPORT FOREIGN SCHEMA ft_parquet3 FROM SERVER arrow_fdw
+  INTO regtest_arrow_parquet_temp OPTIONS (file :'parquet3');
+
+-- read back by arrow_fdw
+SET pg_strom.enabled = off;
+(SELECT * FROM ft_parquet1 EXCEPT ALL SELECT * FROM rt_parquet) ORDER BY id;
+(SELECT * FROM rt_parquet EXCEPT ALL SELECT * FROM ft_parquet1) ORDER BY id;
+(SELECT * FROM ft_parquet2 EXCEPT ALL SELECT * FROM rt_parquet) ORDER BY id;
+(SELECT * FROM rt_parquet EXCEPT ALL SELECT * FROM ft_parquet2) ORDER BY id;
+(SELECT * FROM ft_parquet3 EXCEPT ALL SELECT * FROM rt_parquet) ORDER BY id;
+(SELECT * FROM rt_parquet EXCEPT ALL SELECT * FROM ft_parquet3) ORDER BY id;
+
+-- force to use GpuScan, instead of SeqScan
+SET enable_seqscan = off;
+
+-- GpuScan on the parquet files
+SET pg_strom.enabled = on;
+SELECT id, a, b, c INTO test01g FROM ft_parquet1 WHERE b < 0 AND c LIKE '%a%';
+SELECT id, a, b, c INTO test02g FROM ft_parquet2 WHERE b < 0 AND c LIKE '%a%';
+SELECT id, cat, d, f INTO test03g FROM ft_parquet3 WHERE d > '2020-01-01' AND f;
+SET pg_strom.enabled = off;
+SELECT id, a, b, c INTO test01p FROM rt_parquet WHERE b < 0 AND c LIKE '%a%';
+SELECT id, cat, d, f INTO test03p FROM rt_parquet WHERE d > '2020-01-01' AND f;
+(SELECT * FROM test01g EXCEPT ALL SELECT * FROM test01p) ORDER BY id;
+(SELECT * FROM test01p EXCEPT ALL SELECT * FROM test01g) ORDER BY id;
+(SELECT * FROM test02g EXCEPT ALL SELECT * FROM test01p) ORDER BY id;
+(SELECT * FROM test01p EXCEPT ALL SELECT * FROM test02g) ORDER BY id;
+(SELECT * FROM test03g EXCEPT ALL SELECT * FROM test03p) ORDER BY id;
+(SELECT * FROM test03p EXCEPT ALL SELECT * FROM test03g) ORDER BY id;
+
+-- row-groups are skipped by the min/max statistics
+SET pg_strom.enabled = on;
+SELECT * INTO test04g FROM ft_parquet2 WHERE id BETWEEN 10000 AND 10500;
+SET pg_strom.enabled = off;
+SELECT * INTO test04p FROM rt_parquet WHERE id BETWEEN 10000 AND 10500;
+(SELECT * FROM test04g EXCEPT ALL SELECT * FROM test04p) ORDER BY id;
+(SELECT * FROM test04p EXCEPT ALL SELECT * FROM test04g) ORDER BY id;
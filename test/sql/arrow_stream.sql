@@ -0,0 +1,97 @@
+---
+--- Test cases for Apache Arrow files in the IPC streaming format
+---
+SET pg_strom.regression_test_mode = on;
+SET client_min_messages = error;
+DROP SCHEMA IF EXISTS regtest_arrow_stream_temp CASCADE;
+CREATE SCHEMA regtest_arrow_stream_temp;
+RESET client_min_messages;
+
+SET search_path = regtest_arrow_stream_temp,public;
+CREATE TABLE rt_stream (
+  id    int,
+  cat   int,
+  a     int8,
+  b     float8,
+  c     text,
+  d     date
+);
+SELECT pgstrom.random_setseed(20261123);
+INSERT INTO rt_stream (
+  SELECT i, i % 20,
+            pgstrom.random_int(1, -4000000000, 4000000000),
+            pgstrom.random_float(1, -100000.0, 100000.0),
+            pgstrom.random_text_len(1, 32),
+            pgstrom.random_date(1)
+    FROM generate_series(1,200000) i);
+VACUUM ANALYZE;
+
+-- convert the arrow file to the streaming format; it removes the magic at
+-- the head and the footer at the tail, then (optionally) appends the EOS
+-- marker. 'truncate' also cuts off the tail of the last message.
+CREATE FUNCTION arrow_file_to_stream(src text, dst text,
+                                     with_eos bool, truncate int = 0)
+RETURNS void AS
+$$
+import struct
+
+data = open(src, 'rb').read()
+assert data[:6] == b'ARROW1' and data[-6:] == b'ARROW1'
+footer_len = struct.unpack('<i', data[-10:-6])[0]
+body = data[8:len(data) - 10 - footer_len]
+eos = struct.pack('<Ii', 0xffffffff, 0)
+if body[-8:] == eos:
+    body = body[:-8]
+if truncate > 0:
+    body = body[:-truncate]
+elif with_eos:
+    body = body + eos
+open(dst, 'wb').write(body)
+$$ LANGUAGE 'plpython3u';
+
+\set stream_file `echo -n $MY_DATA_DIR/regtest_stream.arrow`
+\set stream1 `echo -n $MY_DATA_DIR/regtest_stream1.arrows`
+\set stream2 `echo -n $MY_DATA_DIR/regtest_stream2.arrows`
+\set stream3 `echo -n $MY_DATA_DIR/regtest_stream3.arrows`
+\! rm -f $MY_DATA_DIR/regtest_stream.arrow $MY_DATA_DIR/regtest_stream1.arrows $MY_DATA_DIR/regtest_stream2.arrows $MY_DATA_DIR/regtest_stream3.arrows
+
+-- an arrow file with multiple record-batches
+SET arrow_fdw.record_batch_size = '4MB';
+SELECT pgstrom.export_arrow('SELECT * FROM rt_stream ORDER BY id',
+                            :'stream_file');
+SELECT arrow_file_to_stream(:'stream_file', :'stream1', true);
+SELECT arrow_file_to_stream(:'stream_file', :'stream2', false);
+SELECT arrow_file_to_stream(:'stream_file', :'stream3', false, 100);
+IMPORT FOREIGN SCHEMA ft_stream1 FROM SERVER arrow_fdw
+  INTO regtest_arrow_stream_temp OPTIONS (file :'stream1');
+IMPORT FOREIGN SCHEMA ft_stream2 FROM SERVER arrow_fdw
+  INTO regtest_arrow_stream_temp OPTIONS (file :'stream2');
+IMPORT FOREIGN SCHEMA ft_stream3 FROM SERVER arrow_fdw
+  INTO regtest_arrow_stream_temp OPTIONS (file :'stream3');
+
+-- read back by arrow_fdw
+SET pg_strom.enabled = off;
+(SELECT * FROM ft_stream1 EXCEPT ALL SELECT * FROM rt_stream) ORDER BY id;
+(SELECT * FROM rt_stream EXCEPT ALL SELECT * FROM ft_stream1) ORDER BY id;
+(SELECT * FROM ft_stream2 EXCEPT ALL SELECT * FROM rt_stream) ORDER BY id;
+(SELECT * FROM rt_stream EXCEPT ALL SELECT * FROM ft_stream2) ORDER BY id;
+-- the incomplete message at the tail is ignored
+(SELECT * FROM ft_stream3 EXCEPT ALL SELECT * FROM rt_stream) ORDER BY id;
+SELECT count(*) > 0 AND count(*) < 200000 AS ok FROM ft_stream3;
+
+-- force to use GpuScan, instead of SeqScan
+SET enable_seqscan = off;
+
+-- GpuScan on the stream files
+SET pg_strom.enabled = on;
+SELECT id, a, b, c INTO test01g FROM ft_stream1 WHERE b < 0 AND c LIKE '%a%';
+SELECT cat, count(*) nrows, sum(a) sum_a INTO test02g
+  FROM ft_stream2 WHERE d > '2020-01-01' GROUP BY cat;
+SET pg_strom.enabled = off;
+SELECT id, a, b, c INTO test01p FROM rt_stream WHERE b < 0 AND c LIKE '%a%';
+SELECT cat, count(*) nrows, sum(a) sum_a INTO test02p
+  FROM rt_stream WHERE d > '2020-01-01' GROUP BY cat;
+(SELECT * FROM test01g EXCEPT ALL SELECT * FROM test01p) ORDER BY id;
+(SELECT * FROM test01p EXCEPT ALL SELECT * FROM test01g) ORDER BY id;
+(SELECT * FROM test02g EXCEPT ALL SELECT * FROM test02p) ORDER BY cat;
+(SELECT * FROM test02p EXCEPT ALL SELECT * FROM test02g) ORDER BY cat;
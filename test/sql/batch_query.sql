@@ -0,0 +1,88 @@
+---
+--- Test cases for pgstrom.batch_query()
+---
+SET pg_strom.regression_test_mode = on;
+SET client_min_messages = error;
+DROP SCHEMA IF EXISTS regtest_batch_query_temp CASCADE;
+CREATE SCHEMA regtest_batch_query_temp;
+RESET client_min_messages;
+
+SET search_path = regtest_batch_query_temp,public;
+CREATE TABLE rt_batch (
+  id    int,
+  cid   int,
+  a     int8,
+  x     float8,
+  t     text
+);
+SELECT pgstrom.random_setseed(20261025);
+INSERT INTO rt_batch (
+  SELECT i, i % 13,
+            pgstrom.random_int(1, -4000000000, 4000000000),
+            pgstrom.random_float(1, -1000.0, 1000.0),
+            pgstrom.random_text_len(1, 16)
+    FROM generate_series(1,20000) i);
+VACUUM ANALYZE;
+
+-- force to use GpuScan, instead of SeqScan
+SET enable_seqscan = off;
+
+-- aggregation per parameter set; the set without matching rows returns nothing
+SET pg_strom.enabled = on;
+SELECT * INTO test01g
+  FROM pgstrom.batch_query('SELECT count(*), sum(a), max(x) FROM rt_batch WHERE cid = $1',
+                           '{{3},{7},{11},{999}}')
+       AS (batch_id int, cnt bigint, sum_a numeric, max_x float8);
+SET pg_strom.enabled = off;
+SELECT b.batch_id, count(*) cnt, sum(a) sum_a, max(x) max_x
+  INTO test01p
+  FROM rt_batch r, (VALUES (1,3),(2,7),(3,11),(4,999)) b(batch_id,cid)
+ WHERE r.cid = b.cid
+ GROUP BY b.batch_id;
+(SELECT * FROM test01g EXCEPT ALL SELECT * FROM test01p) ORDER BY batch_id;
+(SELECT * FROM test01p EXCEPT ALL SELECT * FROM test01g) ORDER BY batch_id;
+
+-- scan with multiple parameters
+SET pg_strom.enabled = on;
+SELECT * INTO test02g
+  FROM pgstrom.batch_query('SELECT id, a, t FROM rt_batch WHERE cid = $1 AND x > $2',
+                           '{{1,500.0},{5,-250.5},{12,900}}')
+       AS (batch_id int, id int, a int8, t text);
+SET pg_strom.enabled = off;
+SELECT b.batch_id, r.id, r.a, r.t
+  INTO test02p
+  FROM rt_batch r, (VALUES (1,1,500.0::float8),
+                           (2,5,-250.5::float8),
+                           (3,12,900.0::float8)) b(batch_id,cid,x)
+ WHERE r.cid = b.cid AND r.x > b.x;
+(SELECT * FROM test02g EXCEPT ALL SELECT * FROM test02p) ORDER BY batch_id, id;
+(SELECT * FROM test02p EXCEPT ALL SELECT * FROM test02g) ORDER BY batch_id, id;
+
+-- GROUP BY inside of the batch query
+SET pg_strom.enabled = on;
+SELECT * INTO test03g
+  FROM pgstrom.batch_query('SELECT cid, count(*), min(a) FROM rt_batch
+                             WHERE cid BETWEEN $1 AND $2 GROUP BY cid',
+                           '{{0,4},{3,8},{10,20}}')
+       AS (batch_id int, cid int, cnt bigint, min_a int8);
+SET pg_strom.enabled = off;
+SELECT b.batch_id, r.cid, count(*) cnt, min(a) min_a
+  INTO test03p
+  FROM rt_batch r, (VALUES (1,0,4),(2,3,8),(3,10,20)) b(batch_id,lo,hi)
+ WHERE r.cid BETWEEN b.lo AND b.hi
+ GROUP BY b.batch_id, r.cid;
+(SELECT * FROM test03g EXCEPT ALL SELECT * FROM test03p) ORDER BY batch_id, cid;
+(SELECT * FROM test03p EXCEPT ALL SELECT * FROM test03g) ORDER BY batch_id, cid;
+
+-- error cases
+SELECT * FROM pgstrom.batch_query('SELECT count(*) FROM rt_batch', '{{1}}')
+       AS (batch_id int, cnt bigint);
+SELECT * FROM pgstrom.batch_query('SELECT count(*) FROM rt_batch WHERE cid = $1',
+                                  '{{1},{2}}')
+       AS (batch_id int);
+SELECT * FROM pgstrom.batch_query('SELECT count(*) FROM rt_batch WHERE cid = $1',
+                                  '{{1},{2}}')
+       AS (batch_id int, cnt int);
+SELECT * FROM pgstrom.batch_query('SELECT count(*) FROM rt_batch WHERE cid = $1 AND id = $2',
+                                  '{{1},{2}}')
+       AS (batch_id int, cnt bigint);
@@ -0,0 +1,109 @@
+---
+--- Test cases for user-defined device functions
+---
+SET pg_strom.regression_test_mode = on;
+SET client_min_messages = error;
+DROP SCHEMA IF EXISTS regtest_device_function_temp CASCADE;
+CREATE SCHEMA regtest_device_function_temp;
+RESET client_min_messages;
+
+SET search_path = regtest_device_function_temp,public;
+CREATE TABLE rt_devfunc (
+  id    int,
+  a     int8,
+  b     int4,
+  x     float8,
+  y     float8
+);
+SELECT pgstrom.random_setseed(20261023);
+INSERT INTO rt_devfunc (
+  SELECT i, pgstrom.random_int(1, -4000000000, 4000000000),
+            pgstrom.random_int(1, -200000, 200000),
+            pgstrom.random_float(1, -100.0, 100.0),
+            pgstrom.random_float(1, -100.0, 100.0)
+    FROM generate_series(1,10000) i);
+VACUUM ANALYZE;
+
+-- PL/pgSQL functions (not inlined) for CPU, and the CUDA C device functions
+CREATE FUNCTION clamp_mul(float8, float8)
+  RETURNS float8
+  AS 'BEGIN RETURN CASE WHEN $1 * $2 > 1000.0 THEN 1000.0 ELSE $1 * $2 END; END'
+  LANGUAGE plpgsql IMMUTABLE STRICT;
+CREATE FUNCTION mix_hash(int8, int4)
+  RETURNS int8
+  AS 'BEGIN RETURN ($1 # ($2::int8 * 40503)) & 65535; END'
+  LANGUAGE plpgsql IMMUTABLE STRICT;
+CREATE FUNCTION nonstrict_func(int4)
+  RETURNS int4
+  AS 'SELECT coalesce($1, 0) + 1'
+  LANGUAGE sql IMMUTABLE;
+SELECT pgstrom.define_device_function('clamp_mul(float8,float8)',
+                                      'regtest_clamp_mul', $$
+STATIC_FUNCTION(bool)
+regtest_clamp_mul(kern_context *kcxt, float8_t *result, float8_t a, float8_t b)
+{
+	float8_t	v = a * b;
+
+	*result = (v > 1000.0 ? 1000.0 : v);
+	return true;
+}
+$$);
+SELECT pgstrom.define_device_function('mix_hash(int8,int4)',
+                                      'regtest_mix_hash', $$
+STATIC_FUNCTION(bool)
+regtest_mix_hash(kern_context *kcxt, int64_t *result, int64_t a, int32_t b)
+{
+	*result = ((a ^ ((int64_t)b * 40503L)) & 65535L);
+	return true;
+}
+$$, 20);
+SELECT func_oid, func_symbol
+  FROM pgstrom.device_functions
+ WHERE func_symbol LIKE 'regtest_%'
+ ORDER BY func_symbol;
+
+-- force to use GpuScan, instead of SeqScan
+SET enable_seqscan = off;
+
+-- device functions in the target-list and WHERE clause
+SET pg_strom.enabled = on;
+SELECT id, clamp_mul(x, y) v1, mix_hash(a, b) v2
+  INTO test01g
+  FROM rt_devfunc
+ WHERE clamp_mul(x, 2.0) < 150.0;
+SET pg_strom.enabled = off;
+SELECT id, clamp_mul(x, y) v1, mix_hash(a, b) v2
+  INTO test01p
+  FROM rt_devfunc
+ WHERE clamp_mul(x, 2.0) < 150.0;
+(SELECT * FROM test01g EXCEPT ALL SELECT * FROM test01p) ORDER BY id;
+(SELECT * FROM test01p EXCEPT ALL SELECT * FROM test01g) ORDER BY id;
+
+-- device functions in the aggregate arguments and GROUP BY keys
+SET pg_strom.enabled = on;
+SELECT mix_hash(a, b) % 16 k, count(*) c, sum(clamp_mul(x, y)) s
+  INTO test02g
+  FROM rt_devfunc
+ WHERE a IS NOT NULL AND b IS NOT NULL
+ GROUP BY 1;
+SET pg_strom.enabled = off;
+SELECT mix_hash(a, b) % 16 k, count(*) c, sum(clamp_mul(x, y)) s
+  INTO test02p
+  FROM rt_devfunc
+ WHERE a IS NOT NULL AND b IS NOT NULL
+ GROUP BY 1;
+SELECT bool_and(coalesce(g.c = p.c AND abs(g.s - p.s) < 0.0001, false)) AS ok
+  FROM test02g g FULL OUTER JOIN test02p p ON g.k = p.k;
+
+-- invalid definitions
+SELECT pgstrom.define_device_function('nonstrict_func(int4)',
+                                      'regtest_nonstrict', 'dummy');
+SELECT pgstrom.define_device_function('mix_hash(int8,int4)',
+                                      '1regtest', 'dummy');
+SELECT pgstrom.define_device_function('mix_hash(int8,int4)',
+                                      'regtest_mix_hash', 'dummy', 0);
+
+-- cleanup
+SELECT pgstrom.drop_device_function('clamp_mul(float8,float8)');
+SELECT pgstrom.drop_device_function('mix_hash(int8,int4)');
+SELECT pgstrom.drop_device_function('mix_hash(int8,int4)');
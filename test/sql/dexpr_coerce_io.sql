@@ -0,0 +1,86 @@
+---
+--- Test cases for CAST via I/O from text
+---
+SET pg_strom.regression_test_mode = on;
+SET client_min_messages = error;
+DROP SCHEMA IF EXISTS regtest_dexpr_coerce_io_temp CASCADE;
+CREATE SCHEMA regtest_dexpr_coerce_io_temp;
+RESET client_min_messages;
+
+SET search_path = regtest_dexpr_coerce_io_temp,public;
+SET datestyle = 'ISO, YMD';
+CREATE TABLE rt_coerce (
+  id    int,
+  s_int text,
+  s_flt text,
+  s_num text,
+  s_dt  text,
+  s_ts  text,
+  s_uid text
+);
+SELECT pgstrom.random_setseed(20261030);
+INSERT INTO rt_coerce (
+  SELECT i, CASE WHEN i % 5 = 0 THEN '  ' || (i * 37 - 100000) || ' '
+                 WHEN i % 5 = 1 THEN '+' || (i % 32767)
+                 ELSE pgstrom.random_int(1, -32768, 32767)::text END,
+            CASE WHEN i % 7 = 0 THEN 'infinity'
+                 WHEN i % 7 = 1 THEN (i % 1000) || '.25e-2'
+                 ELSE pgstrom.random_float(1, -100000.0, 100000.0)::text END,
+            CASE WHEN i % 3 = 0 THEN (i % 1000) || '.50'
+                 ELSE pgstrom.random_float(1, -1000000.0, 1000000.0)::numeric(20,6)::text END,
+            CASE WHEN i % 11 = 0 THEN 'infinity'
+                 ELSE pgstrom.random_date(1)::text END,
+            CASE WHEN i % 13 = 0 THEN replace(pgstrom.random_timestamp(1)::text, ' ', 'T')
+                 ELSE pgstrom.random_timestamp(1)::text END,
+            CASE WHEN i % 2 = 0 THEN md5(i::text)::uuid::text
+                 ELSE '{' || upper(md5(i::text)) || '}' END
+    FROM generate_series(1,10000) i);
+CREATE TABLE rt_coerce_bad (
+  id    int,
+  s     text
+);
+INSERT INTO rt_coerce_bad VALUES (1, '12abc');
+VACUUM ANALYZE;
+
+-- force to use GpuScan, instead of SeqScan
+SET enable_seqscan = off;
+
+-- casts in the target-list
+SET pg_strom.enabled = on;
+SELECT id, s_int::int2 % 100 v1, s_int::int4 v2, s_int::int8 * 2 v3,
+           s_flt::float4 v4, s_flt::float8 v5, s_num::numeric v6,
+           s_dt::date v7, s_ts::timestamp v8, s_uid::uuid v9
+  INTO test01g
+  FROM rt_coerce
+ WHERE id % 5 <> 0;
+SET pg_strom.enabled = off;
+SELECT id, s_int::int2 % 100 v1, s_int::int4 v2, s_int::int8 * 2 v3,
+           s_flt::float4 v4, s_flt::float8 v5, s_num::numeric v6,
+           s_dt::date v7, s_ts::timestamp v8, s_uid::uuid v9
+  INTO test01p
+  FROM rt_coerce
+ WHERE id % 5 <> 0;
+(SELECT * FROM test01g EXCEPT ALL SELECT * FROM test01p) ORDER BY id;
+(SELECT * FROM test01p EXCEPT ALL SELECT * FROM test01g) ORDER BY id;
+
+-- casts in the WHERE clause
+SET pg_strom.enabled = on;
+SELECT id, s_int, s_dt
+  INTO test02g
+  FROM rt_coerce
+ WHERE s_int::int8 > 0
+   AND s_dt::date < '2020-01-01'::date
+   AND s_num::numeric BETWEEN -500000 AND 500000;
+SET pg_strom.enabled = off;
+SELECT id, s_int, s_dt
+  INTO test02p
+  FROM rt_coerce
+ WHERE s_int::int8 > 0
+   AND s_dt::date < '2020-01-01'::date
+   AND s_num::numeric BETWEEN -500000 AND 500000;
+(SELECT * FROM test02g EXCEPT ALL SELECT * FROM test02p) ORDER BY id;
+(SELECT * FROM test02p EXCEPT ALL SELECT * FROM test02g) ORDER BY id;
+
+-- invalid input is reported by CPU
+SET pg_strom.enabled = on;
+SELECT id FROM rt_coerce_bad WHERE s::int4 > 0;
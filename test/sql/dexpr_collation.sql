@@ -0,0 +1,69 @@
+---
+--- Test cases for text comparison with non-C collations
+---
+SET pg_strom.regression_test_mode = on;
+SET client_min_messages = error;
+DROP SCHEMA IF EXISTS regtest_dexpr_collation_temp CASCADE;
+CREATE SCHEMA regtest_dexpr_collation_temp;
+RESET client_min_messages;
+
+SET search_path = regtest_dexpr_collation_temp,public;
+CREATE TABLE rt_collate (
+  id    int,
+  s     text COLLATE "en-x-icu",
+  t     text COLLATE "en-x-icu"
+);
+SELECT pgstrom.random_setseed(20261110);
+INSERT INTO rt_collate (
+  SELECT i, CASE WHEN i % 3 = 0 THEN initcap(pgstrom.random_text_len(1, 8))
+                 WHEN i % 3 = 1 THEN lower(pgstrom.random_text_len(1, 8))
+                 ELSE pgstrom.random_text_len(1, 8) END,
+            CASE WHEN i % 5 = 0 THEN upper(pgstrom.random_text_len(1, 8))
+                 WHEN i % 5 = 1 THEN 'a-' || lower(pgstrom.random_text_len(1, 6))
+                 ELSE lower(pgstrom.random_text_len(1, 8)) END
+    FROM generate_series(1,20000) i);
+-- punctuation, spaces and non-ASCII characters are left to CPU fallback
+INSERT INTO rt_collate VALUES (20001, 'co-op', 'coop'),
+                              (20002, 'Straße', 'strasse'),
+                              (20003, 'résumé', 'resume'),
+                              (20004, 'a b', 'ab'),
+                              (20005, '', 'A'),
+                              (20006, NULL, 'a');
+VACUUM ANALYZE;
+
+-- force to use GpuScan, instead of SeqScan
+SET enable_seqscan = off;
+
+-- comparison by the column collation
+SET pg_strom.enabled = on;
+SELECT id, s < t v1, s <= t v2, s > t v3, s >= t v4, s = t v5, s <> t v6,
+           s < 'm' v7, t > 'Abc' v8
+  INTO test01g
+  FROM rt_collate
+ WHERE id > 0;
+SET pg_strom.enabled = off;
+SELECT id, s < t v1, s <= t v2, s > t v3, s >= t v4, s = t v5, s <> t v6,
+           s < 'm' v7, t > 'Abc' v8
+  INTO test01p
+  FROM rt_collate
+ WHERE id > 0;
+(SELECT * FROM test01g EXCEPT ALL SELECT * FROM test01p) ORDER BY id;
+(SELECT * FROM test01p EXCEPT ALL SELECT * FROM test01g) ORDER BY id;
+
+-- explicit COLLATE clause, and collations mixed in one query
+SET pg_strom.enabled = on;
+SELECT id, s, t
+  INTO test02g
+  FROM rt_collate
+ WHERE s COLLATE "C" < t COLLATE "C"
+   AND s > t COLLATE "en-x-icu"
+   AND t BETWEEN 'b' AND 'T';
+SET pg_strom.enabled = off;
+SELECT id, s, t
+  INTO test02p
+  FROM rt_collate
+ WHERE s COLLATE "C" < t COLLATE "C"
+   AND s > t COLLATE "en-x-icu"
+   AND t BETWEEN 'b' AND 'T';
+(SELECT * FROM test02g EXCEPT ALL SELECT * FROM test02p) ORDER BY id;
+(SELECT * FROM test02p EXCEPT ALL SELECT * FROM test02g) ORDER BY id;
@@ -0,0 +1,62 @@
+---
+--- Test cases for large IN-lists (ScalarArrayOpExpr)
+---
+SET pg_strom.regression_test_mode = on;
+SET client_min_messages = error;
+DROP SCHEMA IF EXISTS regtest_dexpr_inlist_temp CASCADE;
+CREATE SCHEMA regtest_dexpr_inlist_temp;
+RESET client_min_messages;
+
+SET search_path = regtest_dexpr_inlist_temp,public;
+CREATE TABLE rt_inlist (
+  id    int,
+  a     int2,
+  b     int4,
+  c     int8
+);
+SELECT pgstrom.random_setseed(20261029);
+INSERT INTO rt_inlist (
+  SELECT i, pgstrom.random_int(1, -1000, 1000),
+            pgstrom.random_int(1, -100000, 100000),
+            pgstrom.random_int(1, -4000000000, 4000000000) / 1000000
+    FROM generate_series(1,20000) i);
+VACUUM ANALYZE;
+
+-- force to use GpuScan, instead of SeqScan
+SET enable_seqscan = off;
+
+-- large IN-lists with unsorted and duplicated values
+SET pg_strom.enabled = on;
+SELECT id, a, b, c
+  INTO test01g
+  FROM rt_inlist
+ WHERE a IN (999, -3, 17, 256, -1000, 42, 42, 0, 7, 700, -512, 128, 64, 33, 5, 1000, -77, 3)
+    OR b = ANY('{-99999,12345,1,-1,777,8080,65535,-65535,31337,2048,4096,-4096,100000,54321,-11,11}'::int4[])
+    OR c IN (-4000, -3999, -2, -1, 0, 1, 2, 100, 200, 300, 400, 500, 3998, 3999, 4000, 1234);
+SET pg_strom.enabled = off;
+SELECT id, a, b, c
+  INTO test01p
+  FROM rt_inlist
+ WHERE a IN (999, -3, 17, 256, -1000, 42, 42, 0, 7, 700, -512, 128, 64, 33, 5, 1000, -77, 3)
+    OR b = ANY('{-99999,12345,1,-1,777,8080,65535,-65535,31337,2048,4096,-4096,100000,54321,-11,11}'::int4[])
+    OR c IN (-4000, -3999, -2, -1, 0, 1, 2, 100, 200, 300, 400, 500, 3998, 3999, 4000, 1234);
+(SELECT * FROM test01g EXCEPT ALL SELECT * FROM test01p) ORDER BY id;
+(SELECT * FROM test01p EXCEPT ALL SELECT * FROM test01g) ORDER BY id;
+
+-- IN-lists with NULL elements, and NOT IN
+SET pg_strom.enabled = on;
+SELECT id, b = ANY('{NULL,-4096,4096,-2048,2048,-1024,1024,-512,512,-256,256,-128,128,-64,64,-32,32}'::int4[]) v1,
+           c = ANY('{NULL,1,2,3,4,5,6,7,8,9,10,11,12,13,14,15,16}'::int8[]) v2,
+           a NOT IN (1, 2, 3, 5, 8, 13, 21, 34, 55, 89, 144, 233, 377, 610, 987, -1, -2) v3
+  INTO test02g
+  FROM rt_inlist
+ WHERE id > 0;
+SET pg_strom.enabled = off;
+SELECT id, b = ANY('{NULL,-4096,4096,-2048,2048,-1024,1024,-512,512,-256,256,-128,128,-64,64,-32,32}'::int4[]) v1,
+           c = ANY('{NULL,1,2,3,4,5,6,7,8,9,10,11,12,13,14,15,16}'::int8[]) v2,
+           a NOT IN (1, 2, 3, 5, 8, 13, 21, 34, 55, 89, 144, 233, 377, 610, 987, -1, -2) v3
+  INTO test02p
+  FROM rt_inlist
+ WHERE id > 0;
+(SELECT * FROM test02g EXCEPT ALL SELECT * FROM test02p) ORDER BY id;
+(SELECT * FROM test02p EXCEPT ALL SELECT * FROM test02g) ORDER BY id;
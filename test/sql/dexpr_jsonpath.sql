@@ -0,0 +1,103 @@
+---
+--- Test cases for jsonpath functions / operators
+---
+SET pg_strom.regression_test_mode = on;
+SET client_min_messages = error;
+DROP SCHEMA IF EXISTS regtest_dexpr_jsonpath_temp CASCADE;
+CREATE SCHEMA regtest_dexpr_jsonpath_temp;
+RESET client_min_messages;
+
+SET search_path = regtest_dexpr_jsonpath_temp,public;
+CREATE TABLE rt_jsonpath (
+  id  int,
+  v   jsonb
+);
+SELECT pgstrom.random_setseed(20261018);
+INSERT INTO rt_jsonpath (
+  SELECT x, ('{ "name" : "n' || (x % 50) || '"'
+          || ', "price" : ' ||
+                 case when p is null then 'null'
+                      when p % 7 = 0 then '"' || p || '"'
+                      else p::text end
+          || ', "flag" : ' ||
+                 case when b is null then 'null'
+                      when b < 500 then 'true' else 'false' end
+          || ', "tags" : [ "' || t1 || '", "' || t2 || '" ]'
+          || ', "items" : [ { "sku" : "s' || q1 || '", "qty" : ' || q1 || ' }'
+          ||             ', { "sku" : "s' || q2 || '", "qty" : ' || q2 || ' } ]'
+          || case when x % 3 = 0 then ', "extra" : { "level" : ' || (x % 10) || ' }'
+                  else '' end
+          || '}')::jsonb
+    FROM (SELECT x, pgstrom.random_int(2, 0, 1000) p,
+                    pgstrom.random_int(10, 0, 1000) b,
+                    (ARRAY['red','blue','green','white'])[pgstrom.random_int(0,1,4)] t1,
+                    (ARRAY['red','blue','green','black'])[pgstrom.random_int(0,1,4)] t2,
+                    pgstrom.random_int(0, 0, 10) q1,
+                    pgstrom.random_int(0, 0, 10) q2
+            FROM generate_series(1,6000) x) AS foo);
+VACUUM ANALYZE;
+
+-- force to use GpuScan, instead of SeqScan
+SET enable_seqscan = off;
+
+-- jsonb_path_exists / @? / @@ / jsonb_path_match in the target-list
+SET pg_strom.enabled = on;
+SELECT id, jsonb_path_exists(v, '$.items[*] ? (@.qty > 5)') a,
+           v @? '$.tags[*] ? (@ == "red")' b,
+           v @@ '$.price < 500' c,
+           jsonb_path_match(v, 'exists($.flag) && $.flag == true') d,
+           v @? '$.items[1] ? (@.sku == "s3")' e,
+           v @@ '!($.extra.level == 1)' f,
+           v @@ '($.price > 100) is unknown' g,
+           v @@ '$.name > "n3" || $.extra.level >= 8' h
+  INTO test01g
+  FROM rt_jsonpath
+ WHERE id > 0;
+SET pg_strom.enabled = off;
+SELECT id, jsonb_path_exists(v, '$.items[*] ? (@.qty > 5)') a,
+           v @? '$.tags[*] ? (@ == "red")' b,
+           v @@ '$.price < 500' c,
+           jsonb_path_match(v, 'exists($.flag) && $.flag == true') d,
+           v @? '$.items[1] ? (@.sku == "s3")' e,
+           v @@ '!($.extra.level == 1)' f,
+           v @@ '($.price > 100) is unknown' g,
+           v @@ '$.name > "n3" || $.extra.level >= 8' h
+  INTO test01p
+  FROM rt_jsonpath
+ WHERE id > 0;
+(SELECT * FROM test01g EXCEPT ALL SELECT * FROM test01p) ORDER BY id;
+(SELECT * FROM test01p EXCEPT ALL SELECT * FROM test01g) ORDER BY id;
+
+-- jsonpath in the WHERE clause
+SET pg_strom.enabled = on;
+SELECT id, v->'name' n
+  INTO test02g
+  FROM rt_jsonpath
+ WHERE v @? '$.items[*] ? (@.qty >= 3 && @.qty <= 6)'
+   AND NOT v @@ '$.flag == false'
+   AND jsonb_path_exists(v, '$.extra ? (@.level != 2)');
+SET pg_strom.enabled = off;
+SELECT id, v->'name' n
+  INTO test02p
+  FROM rt_jsonpath
+ WHERE v @? '$.items[*] ? (@.qty >= 3 && @.qty <= 6)'
+   AND NOT v @@ '$.flag == false'
+   AND jsonb_path_exists(v, '$.extra ? (@.level != 2)');
+(SELECT * FROM test02g EXCEPT ALL SELECT * FROM test02p) ORDER BY id;
+(SELECT * FROM test02p EXCEPT ALL SELECT * FROM test02g) ORDER BY id;
+
+-- unsupported jsonpath (strict mode, item methods) is evaluated by CPU
+SET pg_strom.enabled = on;
+SELECT id, jsonb_path_exists(v, 'strict $.items[*].qty') a,
+           v @@ '$.items.size() == 2' b
+  INTO test03g
+  FROM rt_jsonpath
+ WHERE id % 10 = 0;
+SET pg_strom.enabled = off;
+SELECT id, jsonb_path_exists(v, 'strict $.items[*].qty') a,
+           v @@ '$.items.size() == 2' b
+  INTO test03p
+  FROM rt_jsonpath
+ WHERE id % 10 = 0;
+(SELECT * FROM test03g EXCEPT ALL SELECT * FROM test03p) ORDER BY id;
+(SELECT * FROM test03p EXCEPT ALL SELECT * FROM test03g) ORDER BY id;
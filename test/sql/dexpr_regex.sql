@@ -0,0 +1,90 @@
+---
+--- Test cases for regular expression operators
+---
+SET pg_strom.regression_test_mode = on;
+SET client_min_messages = error;
+DROP SCHEMA IF EXISTS regtest_dexpr_regex_temp CASCADE;
+CREATE SCHEMA regtest_dexpr_regex_temp;
+RESET client_min_messages;
+
+SET search_path = regtest_dexpr_regex_temp,public;
+CREATE TABLE rt_regex (
+  id    int,
+  s     text
+);
+SELECT pgstrom.random_setseed(20261026);
+INSERT INTO rt_regex (
+  SELECT i, CASE WHEN i % 4 = 0 THEN upper(md5(i::text))
+                 WHEN i % 4 = 1 THEN 'user' || (i % 1000) || '@example.com'
+                 WHEN i % 4 = 2 THEN (i % 97) || '-' || md5(i::text) || ' ' || (i % 13)
+                 ELSE pgstrom.random_text_len(1, 32) END
+    FROM generate_series(1,8000) i);
+-- multibyte characters, and empty or NULL strings
+INSERT INTO rt_regex VALUES (8001, 'Ärger-Über-straße 42'),
+                            (8002, '日本語-テキスト-ABC'),
+                            (8003, NULL),
+                            (8004, '');
+VACUUM ANALYZE;
+
+-- force to use GpuScan, instead of SeqScan
+SET enable_seqscan = off;
+
+-- regular expression operators in the target-list
+SET pg_strom.enabled = on;
+SELECT id, s ~ '^[0-9]+-[a-f0-9]{8}' v1,
+           s !~ '[a-z]' v2,
+           s ~* '^USER[0-9]*@EXAMPLE\.COM$' v3,
+           s !~* 'ab(c|d)+e?' v4,
+           s ~ '\d{2}\s\d+$' v5,
+           regexp_like(s, '(^|-)(abc|ABC)') v6,
+           s ~ '.*?' v7,
+           s SIMILAR TO '%[0-9]{3}@%' v8
+  INTO test01g
+  FROM rt_regex
+ WHERE id > 0;
+SET pg_strom.enabled = off;
+SELECT id, s ~ '^[0-9]+-[a-f0-9]{8}' v1,
+           s !~ '[a-z]' v2,
+           s ~* '^USER[0-9]*@EXAMPLE\.COM$' v3,
+           s !~* 'ab(c|d)+e?' v4,
+           s ~ '\d{2}\s\d+$' v5,
+           regexp_like(s, '(^|-)(abc|ABC)') v6,
+           s ~ '.*?' v7,
+           s SIMILAR TO '%[0-9]{3}@%' v8
+  INTO test01p
+  FROM rt_regex
+ WHERE id > 0;
+(SELECT * FROM test01g EXCEPT ALL SELECT * FROM test01p) ORDER BY id;
+(SELECT * FROM test01p EXCEPT ALL SELECT * FROM test01g) ORDER BY id;
+
+-- regular expression operators in the WHERE clause
+SET pg_strom.enabled = on;
+SELECT id, s
+  INTO test02g
+  FROM rt_regex
+ WHERE s ~ '[[:digit:]]{2,}'
+   AND s !~* '^[[:upper:]]'
+   AND (s ~ '(a|b|c)[d-f]' OR s ~ '\w+@\w+');
+SET pg_strom.enabled = off;
+SELECT id, s
+  INTO test02p
+  FROM rt_regex
+ WHERE s ~ '[[:digit:]]{2,}'
+   AND s !~* '^[[:upper:]]'
+   AND (s ~ '(a|b|c)[d-f]' OR s ~ '\w+@\w+');
+(SELECT * FROM test02g EXCEPT ALL SELECT * FROM test02p) ORDER BY id;
+(SELECT * FROM test02p EXCEPT ALL SELECT * FROM test02g) ORDER BY id;
+
+-- patterns not supported on the device are still evaluated correctly
+SET pg_strom.enabled = on;
+SELECT id, s ~ '(\d)\1' v1, s ~ '(?=.*a)b' v2, s ~ 'ß' v3
+  INTO test03g
+  FROM rt_regex
+ WHERE id > 0;
+SET pg_strom.enabled = off;
+SELECT id, s ~ '(\d)\1' v1, s ~ '(?=.*a)b' v2, s ~ 'ß' v3
+  INTO test03p
+  FROM rt_regex
+ WHERE id > 0;
+(SELECT * FROM test03g EXCEPT ALL SELECT * FROM test03p) ORDER BY id;
+(SELECT * FROM test03p EXCEPT ALL SELECT * FROM test03g) ORDER BY id;
@@ -0,0 +1,91 @@
+---
+--- Test cases for inet/cidr operators and network functions
+---
+SET pg_strom.regression_test_mode = on;
+SET client_min_messages = error;
+DROP SCHEMA IF EXISTS regtest_dfunc_network_temp CASCADE;
+CREATE SCHEMA regtest_dfunc_network_temp;
+RESET client_min_messages;
+
+SET search_path = regtest_dfunc_network_temp,public;
+CREATE TABLE rt_network (
+  id    int,
+  a     inet,
+  b     inet,
+  n     cidr
+);
+SELECT pgstrom.random_setseed(20261031);
+INSERT INTO rt_network (
+  SELECT i, CASE WHEN i % 4 = 0 THEN pgstrom.random_inet(1, '2001:db8::/96')
+                 ELSE pgstrom.random_inet(1, '10.0.0.0/24') END,
+            CASE WHEN i % 4 = 0 THEN pgstrom.random_inet(1, '2001:db8::/88')
+                 ELSE pgstrom.random_inet(1, '10.0.0.0/20') END,
+            CASE WHEN i % 4 = 0 THEN network(set_masklen(pgstrom.random_inet(0, '2001:db8::/96'), 40 + i % 17))::cidr
+                 ELSE network(set_masklen(pgstrom.random_inet(0, '10.0.0.0/24'), 8 + i % 17))::cidr END
+    FROM generate_series(1,10000) i);
+VACUUM ANALYZE;
+
+-- force to use GpuScan, instead of SeqScan
+SET enable_seqscan = off;
+
+-- containment operators
+SET pg_strom.enabled = on;
+SELECT id, a << n v1, a <<= n v2, n >> a v3, n >>= a v4, a && n v5,
+           a << '10.64.0.0/10'::cidr v6, b <<= '10.0.128.0/17'::cidr v7
+  INTO test01g
+  FROM rt_network
+ WHERE id > 0;
+SET pg_strom.enabled = off;
+SELECT id, a << n v1, a <<= n v2, n >> a v3, n >>= a v4, a && n v5,
+           a << '10.64.0.0/10'::cidr v6, b <<= '10.0.128.0/17'::cidr v7
+  INTO test01p
+  FROM rt_network
+ WHERE id > 0;
+(SELECT * FROM test01g EXCEPT ALL SELECT * FROM test01p) ORDER BY id;
+(SELECT * FROM test01p EXCEPT ALL SELECT * FROM test01g) ORDER BY id;
+
+-- network functions
+SET pg_strom.enabled = on;
+SELECT id, masklen(n) v1, family(a) v2, network(b) v3, broadcast(n) v4,
+           netmask(b) v5, hostmask(n) v6, host(a) v7, text(b) v8,
+           inet_same_family(a, n) v9
+  INTO test02g
+  FROM rt_network
+ WHERE id > 0;
+SET pg_strom.enabled = off;
+SELECT id, masklen(n) v1, family(a) v2, network(b) v3, broadcast(n) v4,
+           netmask(b) v5, hostmask(n) v6, host(a) v7, text(b) v8,
+           inet_same_family(a, n) v9
+  INTO test02p
+  FROM rt_network
+ WHERE id > 0;
+(SELECT * FROM test02g EXCEPT ALL SELECT * FROM test02p) ORDER BY id;
+(SELECT * FROM test02p EXCEPT ALL SELECT * FROM test02g) ORDER BY id;
+
+-- bitwise and arithmetic operators; 'inet - inet' on IPv4 only to avoid overflow
+SET pg_strom.enabled = on;
+SELECT id, ~a v1, a & b v2, a | b v3, a + 1000 v4, b - 77 v5, CASE WHEN family(a) = 4 THEN a - b END v6
+  INTO test03g
+  FROM rt_network
+ WHERE family(a) = family(b);
+SET pg_strom.enabled = off;
+SELECT id, ~a v1, a & b v2, a | b v3, a + 1000 v4, b - 77 v5, CASE WHEN family(a) = 4 THEN a - b END v6
+  INTO test03p
+  FROM rt_network
+ WHERE family(a) = family(b);
+(SELECT * FROM test03g EXCEPT ALL SELECT * FROM test03p) ORDER BY id;
+(SELECT * FROM test03p EXCEPT ALL SELECT * FROM test03g) ORDER BY id;
+
+-- network functions in the WHERE clause
+SET pg_strom.enabled = on;
+SELECT id, a, n
+  INTO test04g
+  FROM rt_network
+ WHERE a <<= n AND masklen(n) < 20 AND host(a) LIKE '10.%';
+SET pg_strom.enabled = off;
+SELECT id, a, n
+  INTO test04p
+  FROM rt_network
+ WHERE a <<= n AND masklen(n) < 20 AND host(a) LIKE '10.%';
+(SELECT * FROM test04g EXCEPT ALL SELECT * FROM test04p) ORDER BY id;
+(SELECT * FROM test04p EXCEPT ALL SELECT * FROM test04g) ORDER BY id;
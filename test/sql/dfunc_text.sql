@@ -0,0 +1,90 @@
+---
+--- Test cases for text functions
+---
+SET pg_strom.regression_test_mode = on;
+SET client_min_messages = error;
+DROP SCHEMA IF EXISTS regtest_dfunc_text_temp CASCADE;
+CREATE SCHEMA regtest_dfunc_text_temp;
+RESET client_min_messages;
+
+SET search_path = regtest_dfunc_text_temp,public;
+CREATE TABLE rt_text (
+  id    int,
+  s     text,
+  t     text
+);
+SELECT pgstrom.random_setseed(20261021);
+INSERT INTO rt_text (
+  SELECT i, CASE WHEN i % 3 = 0 THEN upper(md5(i::text))
+                 WHEN i % 3 = 1 THEN initcap(md5((i+1)::text))
+                 ELSE md5(i::text) END
+            || '-' || (i % 100) || '-' || pgstrom.random_text_len(1, 24),
+            pgstrom.random_text_len(2, 12)
+    FROM generate_series(1,4000) i);
+-- multibyte characters, to be evaluated by CPU fallback on lower/upper
+INSERT INTO rt_text VALUES (4001, 'Ärger-Über-straße', 'Ωmega'),
+                           (4002, '日本語-テキスト-ABC', 'ｱｲｳ'),
+                           (4003, NULL, 'abc'),
+                           (4004, '', '');
+VACUUM ANALYZE;
+
+-- force to use GpuScan, instead of SeqScan
+SET enable_seqscan = off;
+
+-- lower, upper, strpos, position, split_part
+SET pg_strom.enabled = on;
+SELECT id, lower(s) v1, upper(s) v2,
+           strpos(s, 'a') v3, position('-' in s) v4, strpos(s, 'テキ') v5,
+           split_part(s, '-', 1) v6, split_part(s, '-', 2) v7,
+           split_part(s, '-', -1) v8, split_part(s, '-', 5) v9
+  INTO test01g
+  FROM rt_text
+ WHERE id > 0;
+SET pg_strom.enabled = off;
+SELECT id, lower(s) v1, upper(s) v2,
+           strpos(s, 'a') v3, position('-' in s) v4, strpos(s, 'テキ') v5,
+           split_part(s, '-', 1) v6, split_part(s, '-', 2) v7,
+           split_part(s, '-', -1) v8, split_part(s, '-', 5) v9
+  INTO test01p
+  FROM rt_text
+ WHERE id > 0;
+(SELECT * FROM test01g EXCEPT ALL SELECT * FROM test01p) ORDER BY id;
+(SELECT * FROM test01p EXCEPT ALL SELECT * FROM test01g) ORDER BY id;
+
+-- textcat, concat, replace
+SET pg_strom.enabled = on;
+SELECT id, s || t v1, s || '@' || t v2,
+           concat(s, '/', t) v3, concat(t, s, t) v4,
+           replace(s, 'a', 'XYZ') v5, replace(s, '-', '') v6,
+           replace(t, '', 'z') v7
+  INTO test02g
+  FROM rt_text
+ WHERE id > 0;
+SET pg_strom.enabled = off;
+SELECT id, s || t v1, s || '@' || t v2,
+           concat(s, '/', t) v3, concat(t, s, t) v4,
+           replace(s, 'a', 'XYZ') v5, replace(s, '-', '') v6,
+           replace(t, '', 'z') v7
+  INTO test02p
+  FROM rt_text
+ WHERE id > 0;
+(SELECT * FROM test02g EXCEPT ALL SELECT * FROM test02p) ORDER BY id;
+(SELECT * FROM test02p EXCEPT ALL SELECT * FROM test02g) ORDER BY id;
+
+-- text functions in the WHERE clause
+SET pg_strom.enabled = on;
+SELECT id, s
+  INTO test03g
+  FROM rt_text
+ WHERE lower(s) LIKE '%ab%'
+   AND strpos(upper(s), 'E') > 0
+   AND split_part(s, '-', 2) IN ('1', '12', '42', '77');
+SET pg_strom.enabled = off;
+SELECT id, s
+  INTO test03p
+  FROM rt_text
+ WHERE lower(s) LIKE '%ab%'
+   AND strpos(upper(s), 'E') > 0
+   AND split_part(s, '-', 2) IN ('1', '12', '42', '77');
+(SELECT * FROM test03g EXCEPT ALL SELECT * FROM test03p) ORDER BY id;
+(SELECT * FROM test03p EXCEPT ALL SELECT * FROM test03g) ORDER BY id;
@@ -0,0 +1,135 @@
+---
+--- Test cases for date_trunc, date_bin and AT TIME ZONE
+---
+SET pg_strom.regression_test_mode = on;
+SET client_min_messages = error;
+DROP SCHEMA IF EXISTS regtest_dfunc_timelib_temp CASCADE;
+CREATE SCHEMA regtest_dfunc_timelib_temp;
+RESET client_min_messages;
+
+SET search_path = regtest_dfunc_timelib_temp,public;
+CREATE TABLE rt_timelib (
+  id    int,
+  ts    timestamp,
+  tz    timestamptz,
+  iv    interval
+);
+SELECT pgstrom.random_setseed(20261019);
+INSERT INTO rt_timelib (
+  SELECT x, pgstrom.random_timestamp(1.0, '1990-01-01', '2030-12-31'),
+            pgstrom.random_timestamp(1.0, '1990-01-01', '2030-12-31'),
+            pgstrom.random_timestamp(1.0) - pgstrom.random_timestamp(1.0)
+    FROM generate_series(1,4000) x);
+VACUUM ANALYZE;
+
+-- force to use GpuScan, instead of SeqScan
+SET enable_seqscan = off;
+-- timezone with DST
+SET timezone = 'America/New_York';
+
+-- date_trunc on timestamp / timestamptz / interval
+SET pg_strom.enabled = on;
+SELECT id, date_trunc('microseconds', ts) v1,
+           date_trunc('second', ts) v2,
+           date_trunc('hour', ts) v3,
+           date_trunc('day', ts) v4,
+           date_trunc('week', ts) v5,
+           date_trunc('month', ts) v6,
+           date_trunc('quarter', ts) v7,
+           date_trunc('year', ts) v8,
+           date_trunc('century', ts) v9,
+           date_trunc('minute', tz) v10,
+           date_trunc('day', tz) v11,
+           date_trunc('week', tz) v12,
+           date_trunc('month', tz) v13,
+           date_trunc('decade', tz) v14,
+           date_trunc('hour', iv) v15,
+           date_trunc('day', iv) v16,
+           date_trunc('year', iv) v17
+  INTO test01g
+  FROM rt_timelib
+ WHERE id > 0;
+SET pg_strom.enabled = off;
+SELECT id, date_trunc('microseconds', ts) v1,
+           date_trunc('second', ts) v2,
+           date_trunc('hour', ts) v3,
+           date_trunc('day', ts) v4,
+           date_trunc('week', ts) v5,
+           date_trunc('month', ts) v6,
+           date_trunc('quarter', ts) v7,
+           date_trunc('year', ts) v8,
+           date_trunc('century', ts) v9,
+           date_trunc('minute', tz) v10,
+           date_trunc('day', tz) v11,
+           date_trunc('week', tz) v12,
+           date_trunc('month', tz) v13,
+           date_trunc('decade', tz) v14,
+           date_trunc('hour', iv) v15,
+           date_trunc('day', iv) v16,
+           date_trunc('year', iv) v17
+  INTO test01p
+  FROM rt_timelib
+ WHERE id > 0;
+(SELECT * FROM test01g EXCEPT ALL SELECT * FROM test01p) ORDER BY id;
+(SELECT * FROM test01p EXCEPT ALL SELECT * FROM test01g) ORDER BY id;
+
+-- date_bin and AT TIME ZONE with interval
+SET pg_strom.enabled = on;
+SELECT id, date_bin('15 minutes', ts, '2001-01-01') v1,
+           date_bin('1 day 2 hours', ts, '1995-06-15 12:34:56') v2,
+           date_bin('90 seconds', tz, '2000-01-01 00:00:00+00') v3,
+           date_bin('7 days', tz, '2020-03-08 02:30:00') v4,
+           ts AT TIME ZONE INTERVAL '+05:30' v5,
+           ts AT TIME ZONE INTERVAL '-08:00' v6,
+           tz AT TIME ZONE INTERVAL '+09:00' v7,
+           tz AT TIME ZONE INTERVAL '-03:30' v8
+  INTO test02g
+  FROM rt_timelib
+ WHERE id > 0;
+SET pg_strom.enabled = off;
+SELECT id, date_bin('15 minutes', ts, '2001-01-01') v1,
+           date_bin('1 day 2 hours', ts, '1995-06-15 12:34:56') v2,
+           date_bin('90 seconds', tz, '2000-01-01 00:00:00+00') v3,
+           date_bin('7 days', tz, '2020-03-08 02:30:00') v4,
+           ts AT TIME ZONE INTERVAL '+05:30' v5,
+           ts AT TIME ZONE INTERVAL '-08:00' v6,
+           tz AT TIME ZONE INTERVAL '+09:00' v7,
+           tz AT TIME ZONE INTERVAL '-03:30' v8
+  INTO test02p
+  FROM rt_timelib
+ WHERE id > 0;
+(SELECT * FROM test02g EXCEPT ALL SELECT * FROM test02p) ORDER BY id;
+(SELECT * FROM test02p EXCEPT ALL SELECT * FROM test02g) ORDER BY id;
+
+-- GROUP BY date_trunc / date_bin
+SET pg_strom.enabled = on;
+SELECT date_trunc('month', ts) d, date_bin('1 day', tz, '2000-01-01') b,
+       count(*) c
+  INTO test03g
+  FROM rt_timelib
+ GROUP BY 1, 2;
+SET pg_strom.enabled = off;
+SELECT date_trunc('month', ts) d, date_bin('1 day', tz, '2000-01-01') b,
+       count(*) c
+  INTO test03p
+  FROM rt_timelib
+ GROUP BY 1, 2;
+(SELECT * FROM test03g EXCEPT ALL SELECT * FROM test03p) ORDER BY d, b;
+(SELECT * FROM test03p EXCEPT ALL SELECT * FROM test03g) ORDER BY d, b;
+
+-- another timezone
+SET timezone = 'Europe/Berlin';
+SET pg_strom.enabled = on;
+SELECT id, date_trunc('day', tz) v1, date_trunc('month', tz) v2,
+           date_bin('6 hours', tz, '2010-03-28 00:00:00') v3
+  INTO test04g
+  FROM rt_timelib
+ WHERE id > 0;
+SET pg_strom.enabled = off;
+SELECT id, date_trunc('day', tz) v1, date_trunc('month', tz) v2,
+           date_bin('6 hours', tz, '2010-03-28 00:00:00') v3
+  INTO test04p
+  FROM rt_timelib
+ WHERE id > 0;
+(SELECT * FROM test04g EXCEPT ALL SELECT * FROM test04p) ORDER BY id;
+(SELECT * FROM test04p EXCEPT ALL SELECT * FROM test04g) ORDER BY id;
@@ -0,0 +1,132 @@
+---
+--- Test cases for float2/float4 vector distance functions
+---
+SET pg_strom.regression_test_mode = on;
+SET client_min_messages = error;
+DROP SCHEMA IF EXISTS regtest_dfunc_vector_temp CASCADE;
+CREATE SCHEMA regtest_dfunc_vector_temp;
+RESET client_min_messages;
+
+SET search_path = regtest_dfunc_vector_temp,public;
+CREATE TABLE rt_vector (
+  id    int,
+  a     float2[],
+  b     float2[],
+  c     float2[]
+);
+SELECT pgstrom.random_setseed(20261020);
+-- a and b have 16 or 17 dimensions, to run both of paired and tail elements
+INSERT INTO rt_vector (
+  SELECT i, array_agg(x ORDER BY j) FILTER (WHERE j <= 16 + i % 2),
+            array_agg(y ORDER BY j) FILTER (WHERE j <= 16 + i % 2),
+            array_agg(z ORDER BY j) FILTER (WHERE j <= 16)
+    FROM (SELECT i, j, pgstrom.random_float(0, -1.0, 1.0)::float2 x,
+                       pgstrom.random_float(0, -1.0, 1.0)::float2 y,
+                       pgstrom.random_float(0, -1.0, 1.0)::float2 z
+            FROM generate_series(1,3000) i,
+                 generate_series(1,17) j) AS foo
+   GROUP BY i);
+CREATE TABLE rt_vector4 (
+  id    int,
+  v     float4[]
+);
+INSERT INTO rt_vector4 (
+  SELECT i, array_agg(x ORDER BY j)
+    FROM (SELECT i, j, pgstrom.random_float(0, -1.0, 1.0)::float4 x
+            FROM generate_series(1,5000) i,
+                 generate_series(1,33) j) AS foo
+   GROUP BY i);
+VACUUM ANALYZE;
+
+-- force to use GpuScan, instead of SeqScan
+SET enable_seqscan = off;
+
+-- distance functions between columns
+SET pg_strom.enabled = on;
+SELECT id, pgstrom.float2_dot_product(a, b) d,
+           pgstrom.float2_l2_distance(a, b) l,
+           pgstrom.float2_cosine_distance(a, b) c
+  INTO test01g
+  FROM rt_vector
+ WHERE id > 0;
+SET pg_strom.enabled = off;
+SELECT id, pgstrom.float2_dot_product(a, b) d,
+           pgstrom.float2_l2_distance(a, b) l,
+           pgstrom.float2_cosine_distance(a, b) c
+  INTO test01p
+  FROM rt_vector
+ WHERE id > 0;
+-- fp32 accumulation order may differ between device and host
+SELECT (count(*) = 3000 AND
+        bool_and(abs(g.d - p.d) <= 0.001 * greatest(1.0, abs(p.d)) AND
+                 abs(g.l - p.l) <= 0.001 * greatest(1.0, abs(p.l)) AND
+                 abs(g.c - p.c) <= 0.001)) AS ok
+  FROM test01g g, test01p p
+ WHERE g.id = p.id;
+
+-- distance functions with a constant vector, in the WHERE clause
+SET pg_strom.enabled = on;
+SELECT id, pgstrom.float2_l2_distance(c, '{0.5,-0.5,0.25,-0.25,0.125,-0.125,1,-1,0.5,-0.5,0.25,-0.25,0.125,-0.125,1,-1}') l,
+           pgstrom.float2_cosine_distance(c, '{1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1}') c
+  INTO test02g
+  FROM rt_vector
+ WHERE id % 2 = 0
+   AND pgstrom.float2_dot_product(c, c) > 0.0;
+SET pg_strom.enabled = off;
+SELECT id, pgstrom.float2_l2_distance(c, '{0.5,-0.5,0.25,-0.25,0.125,-0.125,1,-1,0.5,-0.5,0.25,-0.25,0.125,-0.125,1,-1}') l,
+           pgstrom.float2_cosine_distance(c, '{1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1}') c
+  INTO test02p
+  FROM rt_vector
+ WHERE id % 2 = 0
+   AND pgstrom.float2_dot_product(c, c) > 0.0;
+SELECT (count(*) = 1500 AND
+        bool_and(abs(g.l - p.l) <= 0.001 * greatest(1.0, abs(p.l)) AND
+                 abs(g.c - p.c) <= 0.001)) AS ok
+  FROM test02g g, test02p p
+ WHERE g.id = p.id;
+
+-- vectors in different dimensions
+SELECT pgstrom.float2_dot_product('{1,2,3}', '{1,2}');
+-- identical and orthogonal vectors
+SELECT pgstrom.float2_l2_distance('{1,2,3,4,5}', '{1,2,3,4,5}') l,
+       pgstrom.float2_cosine_distance('{1,0,1,0}', '{0,1,0,1}') c,
+       pgstrom.float2_dot_product('{0.5,0.5,2,2}', '{2,2,0.5,0.5}') d;
+
+-- float4 vector distance functions
+\set qvec '{0.5,-0.5,0.25,-0.25,0.125,-0.125,1,-1,0.5,-0.5,0.25,-0.25,0.125,-0.125,1,-1,0.5,-0.5,0.25,-0.25,0.125,-0.125,1,-1,0.5,-0.5,0.25,-0.25,0.125,-0.125,1,-1,0}'
+SET pg_strom.enabled = on;
+SELECT id, pgstrom.float4_dot_product(v, :'qvec') d,
+           pgstrom.float4_l2_distance(v, :'qvec') l,
+           pgstrom.float4_cosine_distance(v, :'qvec') c
+  INTO test03g
+  FROM rt_vector4
+ WHERE id % 2 = 0;
+SET pg_strom.enabled = off;
+SELECT id, pgstrom.float4_dot_product(v, :'qvec') d,
+           pgstrom.float4_l2_distance(v, :'qvec') l,
+           pgstrom.float4_cosine_distance(v, :'qvec') c
+  INTO test03p
+  FROM rt_vector4
+ WHERE id % 2 = 0;
+SELECT (count(*) = 2500 AND
+        bool_and(abs(g.d - p.d) <= 0.001 * greatest(1.0, abs(p.d)) AND
+                 abs(g.l - p.l) <= 0.001 * greatest(1.0, abs(p.l)) AND
+                 abs(g.c - p.c) <= 0.001)) AS ok
+  FROM test03g g, test03p p
+ WHERE g.id = p.id;
+
+-- nearest neighbours by GPU top-k; near ties may pick other rows
+SET pg_strom.enabled = on;
+SELECT id INTO test04g
+  FROM rt_vector4
+ ORDER BY pgstrom.float4_l2_distance(v, :'qvec')
+ LIMIT 20;
+SET pg_strom.enabled = off;
+SELECT id, pgstrom.float4_l2_distance(v, :'qvec') l
+  INTO test04p
+  FROM rt_vector4;
+SELECT (count(*) = 20 AND
+        max(p.l) <= (SELECT l FROM test04p ORDER BY l OFFSET 19 LIMIT 1) + 0.001) AS ok
+  FROM test04g g, test04p p
+ WHERE g.id = p.id;
+SELECT pgstrom.float4_l2_distance('{1,2,3}', '{1,2}');
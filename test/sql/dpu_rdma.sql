@@ -0,0 +1,81 @@
+---
+--- Test cases for DpuScan/DpuJoin/DpuPreAgg with RDMA transport of results
+---
+--- It runs only when MY_DPU_TABLESPACE (a tablespace on the DPU storage) and
+--- MY_DPU_RDMA_DEVICE (an RDMA device to dpuserv) are given.
+---
+SET pg_strom.regression_test_mode = on;
+\set dpu_tablespace `echo -n $MY_DPU_TABLESPACE`
+\set dpu_rdma_device `echo -n $MY_DPU_RDMA_DEVICE`
+SELECT :'dpu_tablespace' = '' OR :'dpu_rdma_device' = '' AS skip_test \gset
+\if :skip_test
+\quit
+\endif
+SET client_min_messages = error;
+DROP SCHEMA IF EXISTS regtest_dpu_rdma_temp CASCADE;
+CREATE SCHEMA regtest_dpu_rdma_temp;
+RESET client_min_messages;
+
+SET search_path = regtest_dpu_rdma_temp,public;
+CREATE TABLE rt_dpu_fact (
+  id    int,
+  k1    int,
+  a     int8,
+  b     float8,
+  c     text
+) TABLESPACE :dpu_tablespace;
+CREATE TABLE rt_dpu_dim (
+  k1    int,
+  n1    text
+) TABLESPACE :dpu_tablespace;
+SELECT pgstrom.random_setseed(20261124);
+INSERT INTO rt_dpu_fact (
+  SELECT i, pgstrom.random_int(1, 1, 5000),
+            pgstrom.random_int(1, -4000000000, 4000000000),
+            pgstrom.random_float(1, -1000.0, 1000.0),
+            pgstrom.random_text_len(1, 64)
+    FROM generate_series(1,500000) i);
+INSERT INTO rt_dpu_dim (
+  SELECT i, md5(i::text) FROM generate_series(1,4000) i);
+VACUUM ANALYZE;
+
+-- force to use DpuScan/DpuJoin/DpuPreAgg, instead of CPU or GPU
+SET enable_seqscan = off;
+SET enable_hashjoin = off;
+SET enable_mergejoin = off;
+SET enable_nestloop = off;
+SET pg_strom.enable_gpuscan = off;
+SET pg_strom.enable_gpujoin = off;
+SET pg_strom.enable_gpupreagg = off;
+SET pg_strom.enable_dpuscan = on;
+SET pg_strom.enable_dpujoin = on;
+SET pg_strom.enable_dpupreagg = on;
+
+-- results are written back by RDMA
+SET pg_strom.dpu_rdma_device = :'dpu_rdma_device';
+SET pg_strom.enabled = on;
+SELECT * INTO test01g FROM rt_dpu_fact WHERE b < 0 AND c LIKE '%a%';
+SELECT id, f.k1, n1, a INTO test02g
+  FROM rt_dpu_fact f JOIN rt_dpu_dim d ON f.k1 = d.k1 WHERE id % 3 = 0;
+SELECT k1 % 100 AS k, count(*) nrows, sum(a) sum_a INTO test03g
+  FROM rt_dpu_fact GROUP BY k1 % 100;
+SET pg_strom.enabled = off;
+SELECT * INTO test01p FROM rt_dpu_fact WHERE b < 0 AND c LIKE '%a%';
+SELECT id, f.k1, n1, a INTO test02p
+  FROM rt_dpu_fact f JOIN rt_dpu_dim d ON f.k1 = d.k1 WHERE id % 3 = 0;
+SELECT k1 % 100 AS k, count(*) nrows, sum(a) sum_a INTO test03p
+  FROM rt_dpu_fact GROUP BY k1 % 100;
+(SELECT * FROM test01g EXCEPT ALL SELECT * FROM test01p) ORDER BY id;
+(SELECT * FROM test01p EXCEPT ALL SELECT * FROM test01g) ORDER BY id;
+(SELECT * FROM test02g EXCEPT ALL SELECT * FROM test02p) ORDER BY id;
+(SELECT * FROM test02p EXCEPT ALL SELECT * FROM test02g) ORDER BY id;
+(SELECT * FROM test03g EXCEPT ALL SELECT * FROM test03p) ORDER BY k;
+(SELECT * FROM test03p EXCEPT ALL SELECT * FROM test03g) ORDER BY k;
+
+-- an unknown device falls back to the socket transport
+SET pg_strom.dpu_rdma_device = 'no_such_rdma_device';
+SET pg_strom.enabled = on;
+SELECT * INTO test04g FROM rt_dpu_fact WHERE b < 0 AND c LIKE '%a%';
+(SELECT * FROM test04g EXCEPT ALL SELECT * FROM test01p) ORDER BY id;
+(SELECT * FROM test01p EXCEPT ALL SELECT * FROM test04g) ORDER BY id;
+RESET pg_strom.dpu_rdma_device;
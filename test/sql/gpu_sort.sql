@@ -0,0 +1,120 @@
+---
+--- Test cases for GpuSort
+---
+SET pg_strom.regression_test_mode = on;
+SET client_min_messages = error;
+DROP SCHEMA IF EXISTS regtest_gpu_sort_temp CASCADE;
+CREATE SCHEMA regtest_gpu_sort_temp;
+RESET client_min_messages;
+
+SET search_path = regtest_gpu_sort_temp,public;
+CREATE TABLE rt_sort (
+  id    int,
+  cat   int,
+  a     int8,
+  x     float8,
+  d     date,
+  t     text
+);
+CREATE TABLE rt_sort_dim (
+  cid   int,
+  name  text
+);
+SELECT pgstrom.random_setseed(20261103);
+INSERT INTO rt_sort (
+  SELECT i, i % 100,
+            pgstrom.random_int(2, -4000000000, 4000000000),
+            pgstrom.random_float(2, -100000.0, 100000.0),
+            pgstrom.random_date(2),
+            pgstrom.random_text_len(2, 16)
+    FROM generate_series(1,100000) i);
+INSERT INTO rt_sort_dim (
+  SELECT i, md5(i::text)
+    FROM generate_series(0,79) i);
+VACUUM ANALYZE;
+
+-- force to use GpuScan, instead of SeqScan
+SET enable_seqscan = off;
+
+-- ORDER BY ... LIMIT on GpuScan; the last key makes the order unique
+SET pg_strom.enabled = on;
+SELECT id, a, x INTO test01g
+  FROM rt_sort
+ WHERE x > 0
+ ORDER BY a, id
+ LIMIT 100;
+SELECT id, cat, d, t INTO test02g
+  FROM rt_sort
+ WHERE cat < 50
+ ORDER BY d DESC NULLS LAST, t COLLATE "C", id DESC
+ LIMIT 500;
+SET pg_strom.enabled = off;
+SELECT id, a, x INTO test01p
+  FROM rt_sort
+ WHERE x > 0
+ ORDER BY a, id
+ LIMIT 100;
+SELECT id, cat, d, t INTO test02p
+  FROM rt_sort
+ WHERE cat < 50
+ ORDER BY d DESC NULLS LAST, t COLLATE "C", id DESC
+ LIMIT 500;
+(SELECT * FROM test01g EXCEPT ALL SELECT * FROM test01p) ORDER BY id;
+(SELECT * FROM test01p EXCEPT ALL SELECT * FROM test01g) ORDER BY id;
+(SELECT * FROM test02g EXCEPT ALL SELECT * FROM test02p) ORDER BY id;
+(SELECT * FROM test02p EXCEPT ALL SELECT * FROM test02g) ORDER BY id;
+
+-- ORDER BY ... LIMIT on GpuJoin, with OFFSET
+SET pg_strom.enabled = on;
+SELECT id, name, x INTO test03g
+  FROM rt_sort, rt_sort_dim
+ WHERE cat = cid
+ ORDER BY x DESC NULLS FIRST, id
+ OFFSET 20 LIMIT 200;
+SET pg_strom.enabled = off;
+SELECT id, name, x INTO test03p
+  FROM rt_sort, rt_sort_dim
+ WHERE cat = cid
+ ORDER BY x DESC NULLS FIRST, id
+ OFFSET 20 LIMIT 200;
+(SELECT * FROM test03g EXCEPT ALL SELECT * FROM test03p) ORDER BY id;
+(SELECT * FROM test03p EXCEPT ALL SELECT * FROM test03g) ORDER BY id;
+
+-- LIMIT without ORDER BY stops the scan; any qualified rows may be returned
+SET pg_strom.enabled = on;
+SELECT id, cat, a INTO test04g
+  FROM rt_sort
+ WHERE a > 0 AND cat % 3 = 1
+ LIMIT 300;
+SELECT count(*) = 300 AS ok
+  FROM test04g g JOIN rt_sort r ON g.id = r.id
+ WHERE g.cat = r.cat AND g.a = r.a AND r.a > 0 AND r.cat % 3 = 1;
+SELECT id, name INTO test05g
+  FROM rt_sort, rt_sort_dim
+ WHERE cat = cid AND x < 0
+ LIMIT 50;
+SELECT count(*) = 50 AS ok
+  FROM test05g g, rt_sort r, rt_sort_dim s
+ WHERE g.id = r.id AND r.cat = s.cid AND g.name = s.name AND r.x < 0;
+
+-- window functions on the input sorted by GpuSort
+SET work_mem = '256MB';
+SET pg_strom.enabled = on;
+SELECT id, row_number() OVER (PARTITION BY cat ORDER BY a, id) v1,
+           rank() OVER (PARTITION BY cat ORDER BY a) v2,
+           sum(x) OVER (PARTITION BY cat ORDER BY a, id) v3,
+           lag(t) OVER (PARTITION BY cat ORDER BY a, id) v4
+  INTO test06g
+  FROM rt_sort
+ WHERE d IS NOT NULL;
+SET pg_strom.enabled = off;
+SELECT id, row_number() OVER (PARTITION BY cat ORDER BY a, id) v1,
+           rank() OVER (PARTITION BY cat ORDER BY a) v2,
+           sum(x) OVER (PARTITION BY cat ORDER BY a, id) v3,
+           lag(t) OVER (PARTITION BY cat ORDER BY a, id) v4
+  INTO test06p
+  FROM rt_sort
+ WHERE d IS NOT NULL;
+(SELECT * FROM test06g EXCEPT ALL SELECT * FROM test06p) ORDER BY id;
+(SELECT * FROM test06p EXCEPT ALL SELECT * FROM test06g) ORDER BY id;
+RESET work_mem;
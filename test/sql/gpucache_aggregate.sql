@@ -0,0 +1,67 @@
+---
+--- Test cases for the aggregation maintained by GpuCache (aggregate option)
+---
+SET pg_strom.regression_test_mode = on;
+SET client_min_messages = error;
+DROP SCHEMA IF EXISTS regtest_gpucache_aggregate_temp CASCADE;
+CREATE SCHEMA regtest_gpucache_aggregate_temp;
+RESET client_min_messages;
+
+SET search_path = regtest_gpucache_aggregate_temp,public;
+CREATE TABLE rt_agg (
+  id    int,
+  grp   int4,
+  val   int8,
+  c     text
+);
+CREATE TABLE rt_agg_none (LIKE rt_agg);
+CREATE TRIGGER rt_agg_sync AFTER INSERT OR UPDATE OR DELETE ON rt_agg FOR ROW
+    EXECUTE FUNCTION pgstrom.gpucache_sync_trigger('gpu_device_id=0,max_num_rows=100000,redo_buffer_size=32m,aggregate=grp:val');
+ALTER TABLE rt_agg ENABLE ALWAYS TRIGGER rt_agg_sync;
+CREATE TRIGGER rt_agg_none_sync AFTER INSERT OR UPDATE OR DELETE ON rt_agg_none FOR ROW
+    EXECUTE FUNCTION pgstrom.gpucache_sync_trigger('gpu_device_id=0,max_num_rows=100000,redo_buffer_size=32m');
+ALTER TABLE rt_agg_none ENABLE ALWAYS TRIGGER rt_agg_none_sync;
+SELECT pgstrom.random_setseed(20261118);
+-- 2% of keys and values are NULL
+INSERT INTO rt_agg (
+  SELECT i, pgstrom.random_int(2, 1, 500),
+            pgstrom.random_int(2, -100000, 100000),
+            pgstrom.random_text_len(1, 16)
+    FROM generate_series(1,60000) i);
+INSERT INTO rt_agg_none (SELECT * FROM rt_agg WHERE id < 100);
+VACUUM ANALYZE;
+
+-- the maintained aggregation is equivalent to GROUP BY
+SELECT * INTO test01g FROM pgstrom.gpucache_aggregate('rt_agg');
+SELECT grp::int8 AS key, count(*) nrows, count(val) nvalues, sum(val)::numeric sum
+  INTO test01p FROM rt_agg GROUP BY grp;
+(SELECT * FROM test01g EXCEPT ALL SELECT * FROM test01p) ORDER BY key;
+(SELECT * FROM test01p EXCEPT ALL SELECT * FROM test01g) ORDER BY key;
+
+-- REDO logs update the aggregation by the deltas
+DELETE FROM rt_agg WHERE id % 7 = 0;
+UPDATE rt_agg SET grp = grp + 1 WHERE id % 11 = 0;
+UPDATE rt_agg SET val = NULL WHERE id % 13 = 0;
+UPDATE rt_agg SET grp = NULL WHERE id % 17 = 0;
+DELETE FROM rt_agg WHERE grp = 250;
+INSERT INTO rt_agg (
+  SELECT i, 1000 + i % 3, i, 'new' || i FROM generate_series(60001,61000) i);
+BEGIN;
+UPDATE rt_agg SET val = val + 1 WHERE id % 5 = 0;
+DELETE FROM rt_agg WHERE grp = 100;
+ROLLBACK;
+SELECT * INTO test02g FROM pgstrom.gpucache_aggregate('rt_agg');
+SELECT grp::int8 AS key, count(*) nrows, count(val) nvalues, sum(val)::numeric sum
+  INTO test02p FROM rt_agg GROUP BY grp;
+(SELECT * FROM test02g EXCEPT ALL SELECT * FROM test02p) ORDER BY key;
+(SELECT * FROM test02p EXCEPT ALL SELECT * FROM test02g) ORDER BY key;
+SELECT count(*) = 0 AS ok FROM test02g WHERE key = 250;
+
+-- compaction does not change the aggregation
+SELECT pgstrom.gpucache_compaction('rt_agg');
+SELECT * INTO test03g FROM pgstrom.gpucache_aggregate('rt_agg');
+(SELECT * FROM test03g EXCEPT ALL SELECT * FROM test02p) ORDER BY key;
+(SELECT * FROM test02p EXCEPT ALL SELECT * FROM test03g) ORDER BY key;
+
+-- GpuCache without the aggregate option
+SELECT * FROM pgstrom.gpucache_aggregate('rt_agg_none');
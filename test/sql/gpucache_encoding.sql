@@ -0,0 +1,73 @@
+---
+--- Test cases for column encoding of GpuCache (column_encoding option)
+---
+SET pg_strom.regression_test_mode = on;
+SET client_min_messages = error;
+DROP SCHEMA IF EXISTS regtest_gpucache_encoding_temp CASCADE;
+CREATE SCHEMA regtest_gpucache_encoding_temp;
+RESET client_min_messages;
+
+SET search_path = regtest_gpucache_encoding_temp,public;
+CREATE TABLE rt_enc (
+  id    int,
+  cat   text,
+  uid   int4,
+  tiny  int2,
+  d     date,
+  v     float8
+);
+CREATE TRIGGER rt_enc_sync AFTER INSERT OR UPDATE OR DELETE ON rt_enc FOR ROW
+    EXECUTE FUNCTION pgstrom.gpucache_sync_trigger('gpu_device_id=0,max_num_rows=100000,redo_buffer_size=32m,column_encoding=cat:dict uid:for16 tiny:for8 d:for32');
+ALTER TABLE rt_enc ENABLE ALWAYS TRIGGER rt_enc_sync;
+SELECT pgstrom.random_setseed(20261113);
+-- values of the frame-of-reference columns are within the unit range
+INSERT INTO rt_enc (
+  SELECT i, 'category_' || (i % 17),
+            pgstrom.random_int(1, 10000, 30000),
+            pgstrom.random_int(1, 100, 200),
+            pgstrom.random_date(1),
+            pgstrom.random_float(1, -1000.0, 1000.0)
+    FROM generate_series(1,60000) i);
+VACUUM ANALYZE;
+
+-- force to use GpuScan on the GpuCache, instead of SeqScan
+SET enable_seqscan = off;
+
+SET pg_strom.enabled = on;
+SELECT * INTO test01g FROM rt_enc WHERE cat = 'category_3' OR uid < 12000;
+SELECT id, cat, uid + tiny AS x, d INTO test02g
+  FROM rt_enc WHERE d > '2020-01-01' AND tiny BETWEEN 120 AND 160;
+SET pg_strom.enabled = off;
+SELECT * INTO test01p FROM rt_enc WHERE cat = 'category_3' OR uid < 12000;
+SELECT id, cat, uid + tiny AS x, d INTO test02p
+  FROM rt_enc WHERE d > '2020-01-01' AND tiny BETWEEN 120 AND 160;
+(SELECT * FROM test01g EXCEPT ALL SELECT * FROM test01p) ORDER BY id;
+(SELECT * FROM test01p EXCEPT ALL SELECT * FROM test01g) ORDER BY id;
+(SELECT * FROM test02g EXCEPT ALL SELECT * FROM test02p) ORDER BY id;
+(SELECT * FROM test02p EXCEPT ALL SELECT * FROM test02g) ORDER BY id;
+
+-- REDO logs register new dictionary values, and replace the encoded ones
+UPDATE rt_enc SET cat = 'renamed_' || (id % 5) WHERE id % 7 = 0;
+UPDATE rt_enc SET uid = uid + 1, tiny = tiny - 1 WHERE id % 11 = 0;
+DELETE FROM rt_enc WHERE id % 13 = 0;
+INSERT INTO rt_enc (
+  SELECT i, NULL, 20000, NULL, '2023-04-01', i::float8
+    FROM generate_series(60001,61000) i);
+SET pg_strom.enabled = on;
+SELECT * INTO test03g FROM rt_enc WHERE cat LIKE 'renamed%' OR cat IS NULL OR uid % 10 = 0;
+SET pg_strom.enabled = off;
+SELECT * INTO test03p FROM rt_enc WHERE cat LIKE 'renamed%' OR cat IS NULL OR uid % 10 = 0;
+(SELECT * FROM test03g EXCEPT ALL SELECT * FROM test03p) ORDER BY id;
+(SELECT * FROM test03p EXCEPT ALL SELECT * FROM test03g) ORDER BY id;
+
+-- compaction rebuilds the dictionary on the new extra buffer
+SELECT pgstrom.gpucache_compaction('rt_enc');
+SET pg_strom.enabled = on;
+SELECT * INTO test04g FROM rt_enc WHERE id % 3 = 0;
+SET pg_strom.enabled = off;
+SELECT * INTO test04p FROM rt_enc WHERE id % 3 = 0;
+(SELECT * FROM test04g EXCEPT ALL SELECT * FROM test04p) ORDER BY id;
+(SELECT * FROM test04p EXCEPT ALL SELECT * FROM test04g) ORDER BY id;
+SELECT phase = 'is_ready' AS ok
+  FROM pgstrom.gpucache_info
+ WHERE table_oid = 'rt_enc'::regclass AND database_name = current_database();
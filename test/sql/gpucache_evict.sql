@@ -0,0 +1,83 @@
+---
+--- Test cases for GpuCache eviction to the host memory
+---
+--- Eviction happens only if pg_strom.gpucache_device_budget is configured,
+--- but an evicted cache is still scannable, so the results are the same.
+---
+SET pg_strom.regression_test_mode = on;
+SET client_min_messages = error;
+DROP SCHEMA IF EXISTS regtest_gpucache_evict_temp CASCADE;
+CREATE SCHEMA regtest_gpucache_evict_temp;
+RESET client_min_messages;
+
+SET search_path = regtest_gpucache_evict_temp,public;
+CREATE TABLE rt_evict1 (
+  id    int,
+  a     int8,
+  b     float8,
+  c     text
+);
+CREATE TABLE rt_evict2 (LIKE rt_evict1);
+CREATE TRIGGER rt_evict1_sync AFTER INSERT OR UPDATE OR DELETE ON rt_evict1 FOR ROW
+    EXECUTE FUNCTION pgstrom.gpucache_sync_trigger('gpu_device_id=0,max_num_rows=200000,redo_buffer_size=32m');
+ALTER TABLE rt_evict1 ENABLE ALWAYS TRIGGER rt_evict1_sync;
+CREATE TRIGGER rt_evict2_sync AFTER INSERT OR UPDATE OR DELETE ON rt_evict2 FOR ROW
+    EXECUTE FUNCTION pgstrom.gpucache_sync_trigger('gpu_device_id=0,max_num_rows=200000,redo_buffer_size=32m');
+ALTER TABLE rt_evict2 ENABLE ALWAYS TRIGGER rt_evict2_sync;
+SELECT pgstrom.random_setseed(20261115);
+INSERT INTO rt_evict1 (
+  SELECT i, pgstrom.random_int(1, -4000000000, 4000000000),
+            pgstrom.random_float(1, -1000.0, 1000.0),
+            pgstrom.random_text_len(1, 64)
+    FROM generate_series(1,150000) i);
+INSERT INTO rt_evict2 (
+  SELECT i, pgstrom.random_int(1, -4000000000, 4000000000),
+            pgstrom.random_float(1, -1000.0, 1000.0),
+            pgstrom.random_text_len(1, 64)
+    FROM generate_series(1,150000) i);
+VACUUM ANALYZE;
+
+-- force to use GpuScan on the GpuCache, instead of SeqScan
+SET enable_seqscan = off;
+
+-- scan the caches in turn, so the other one gets cold
+SET pg_strom.enabled = on;
+SELECT * INTO test01g FROM rt_evict1 WHERE id % 3 = 0;
+SELECT * INTO test02g FROM rt_evict2 WHERE id % 3 = 0;
+SET pg_strom.enabled = off;
+SELECT * INTO test01p FROM rt_evict1 WHERE id % 3 = 0;
+SELECT * INTO test02p FROM rt_evict2 WHERE id % 3 = 0;
+(SELECT * FROM test01g EXCEPT ALL SELECT * FROM test01p) ORDER BY id;
+(SELECT * FROM test01p EXCEPT ALL SELECT * FROM test01g) ORDER BY id;
+(SELECT * FROM test02g EXCEPT ALL SELECT * FROM test02p) ORDER BY id;
+(SELECT * FROM test02p EXCEPT ALL SELECT * FROM test02g) ORDER BY id;
+SELECT pg_sleep(2.0);
+
+-- REDO logs are applied to the cache on the host memory as well
+UPDATE rt_evict1 SET a = a + 1 WHERE id % 7 = 0;
+SET pg_strom.enabled = on;
+SELECT * INTO test03g FROM rt_evict1 WHERE id % 3 = 0;
+SET pg_strom.enabled = off;
+SELECT * INTO test03p FROM rt_evict1 WHERE id % 3 = 0;
+(SELECT * FROM test03g EXCEPT ALL SELECT * FROM test03p) ORDER BY id;
+(SELECT * FROM test03p EXCEPT ALL SELECT * FROM test03g) ORDER BY id;
+SELECT pg_sleep(2.0);
+
+-- the next scan brings the cache back to the device
+SET pg_strom.enabled = on;
+SELECT * INTO test04g FROM rt_evict2 WHERE id % 3 = 0;
+(SELECT * FROM test04g EXCEPT ALL SELECT * FROM test02p) ORDER BY id;
+(SELECT * FROM test02p EXCEPT ALL SELECT * FROM test04g) ORDER BY id;
+
+-- a cache on the host memory has been evicted once more than restored,
+-- and nothing is evicted without the budget
+SELECT bool_and(gpu_resident = (evict_count = restore_count)) AS ok
+  FROM pgstrom.gpucache_info
+ WHERE table_oid IN ('rt_evict1'::regclass, 'rt_evict2'::regclass)
+   AND database_name = current_database();
+SELECT bool_and(evict_count = 0) OR
+       (SELECT setting FROM pg_settings
+         WHERE name = 'pg_strom.gpucache_device_budget') <> '0' AS ok
+  FROM pgstrom.gpucache_info
+ WHERE table_oid IN ('rt_evict1'::regclass, 'rt_evict2'::regclass)
+   AND database_name = current_database();
@@ -0,0 +1,94 @@
+---
+--- Test cases for the device hash-index of GpuCache (hash_index option)
+---
+SET pg_strom.regression_test_mode = on;
+SET client_min_messages = error;
+DROP SCHEMA IF EXISTS regtest_gpucache_hashindex_temp CASCADE;
+CREATE SCHEMA regtest_gpucache_hashindex_temp;
+RESET client_min_messages;
+
+SET search_path = regtest_gpucache_hashindex_temp,public;
+CREATE TABLE rt_hidx1 (
+  id    int,
+  a     int8,
+  c     text
+);
+CREATE TABLE rt_hidx2 (
+  key   text,
+  id    int,
+  b     float8
+);
+CREATE TRIGGER rt_hidx1_sync AFTER INSERT OR UPDATE OR DELETE ON rt_hidx1 FOR ROW
+    EXECUTE FUNCTION pgstrom.gpucache_sync_trigger('gpu_device_id=0,max_num_rows=200000,redo_buffer_size=32m,hash_index=id');
+ALTER TABLE rt_hidx1 ENABLE ALWAYS TRIGGER rt_hidx1_sync;
+CREATE TRIGGER rt_hidx2_sync AFTER INSERT OR UPDATE OR DELETE ON rt_hidx2 FOR ROW
+    EXECUTE FUNCTION pgstrom.gpucache_sync_trigger('gpu_device_id=0,max_num_rows=200000,redo_buffer_size=32m,hash_index=key');
+ALTER TABLE rt_hidx2 ENABLE ALWAYS TRIGGER rt_hidx2_sync;
+SELECT pgstrom.random_setseed(20261116);
+-- id is not unique; every id has 1-3 rows
+INSERT INTO rt_hidx1 (
+  SELECT i / 2 + i % 3, pgstrom.random_int(1, -4000000000, 4000000000),
+            pgstrom.random_text_len(1, 32)
+    FROM generate_series(1,100000) i);
+INSERT INTO rt_hidx2 (
+  SELECT md5((i % 20000)::text), i, pgstrom.random_float(1, -1000.0, 1000.0)
+    FROM generate_series(1,100000) i);
+VACUUM ANALYZE;
+
+-- force to use GpuScan on the GpuCache, instead of SeqScan
+SET enable_seqscan = off;
+SET enable_indexscan = off;
+SET enable_bitmapscan = off;
+
+-- point lookups by constants
+SET pg_strom.enabled = on;
+SELECT * INTO test01g FROM rt_hidx1 WHERE id = 1234;
+SELECT * INTO test02g FROM rt_hidx1 WHERE id = 40000 AND a > 0;
+SELECT * INTO test03g FROM rt_hidx2 WHERE key = md5('777');
+SET pg_strom.enabled = off;
+SELECT * INTO test01p FROM rt_hidx1 WHERE id = 1234;
+SELECT * INTO test02p FROM rt_hidx1 WHERE id = 40000 AND a > 0;
+SELECT * INTO test03p FROM rt_hidx2 WHERE key = md5('777');
+(SELECT * FROM test01g EXCEPT ALL SELECT * FROM test01p) ORDER BY id, a;
+(SELECT * FROM test01p EXCEPT ALL SELECT * FROM test01g) ORDER BY id, a;
+(SELECT * FROM test02g EXCEPT ALL SELECT * FROM test02p) ORDER BY id, a;
+(SELECT * FROM test02p EXCEPT ALL SELECT * FROM test02g) ORDER BY id, a;
+(SELECT * FROM test03g EXCEPT ALL SELECT * FROM test03p) ORDER BY id;
+(SELECT * FROM test03p EXCEPT ALL SELECT * FROM test03g) ORDER BY id;
+SELECT count(*) > 0 AS ok FROM test01g;
+SELECT count(*) = 5 AS ok FROM test03g;
+
+-- point lookups by the parameters
+PREPARE q_hidx1(int) AS SELECT * FROM rt_hidx1 WHERE id = $1;
+PREPARE q_hidx2(text) AS SELECT * FROM rt_hidx2 WHERE key = $1;
+SET pg_strom.enabled = on;
+CREATE TABLE test04g AS EXECUTE q_hidx1(2500);
+CREATE TABLE test05g AS EXECUTE q_hidx2(md5('19999'));
+SET pg_strom.enabled = off;
+CREATE TABLE test04p AS EXECUTE q_hidx1(2500);
+CREATE TABLE test05p AS EXECUTE q_hidx2(md5('19999'));
+(SELECT * FROM test04g EXCEPT ALL SELECT * FROM test04p) ORDER BY id, a;
+(SELECT * FROM test04p EXCEPT ALL SELECT * FROM test04g) ORDER BY id, a;
+(SELECT * FROM test05g EXCEPT ALL SELECT * FROM test05p) ORDER BY id;
+(SELECT * FROM test05p EXCEPT ALL SELECT * FROM test05g) ORDER BY id;
+
+-- REDO logs replace the index entries of the updated / deleted rows
+UPDATE rt_hidx1 SET id = 1234 WHERE id = 4321;
+DELETE FROM rt_hidx1 WHERE id = 40000;
+UPDATE rt_hidx2 SET key = md5('777') WHERE key = md5('888');
+INSERT INTO rt_hidx1 VALUES (40000, 1, 'reinserted');
+SET pg_strom.enabled = on;
+SELECT * INTO test06g FROM rt_hidx1 WHERE id = 1234;
+SELECT * INTO test07g FROM rt_hidx1 WHERE id = 40000 OR id = 4321;
+SELECT * INTO test08g FROM rt_hidx2 WHERE key = md5('777');
+SET pg_strom.enabled = off;
+SELECT * INTO test06p FROM rt_hidx1 WHERE id = 1234;
+SELECT * INTO test07p FROM rt_hidx1 WHERE id = 40000 OR id = 4321;
+SELECT * INTO test08p FROM rt_hidx2 WHERE key = md5('777');
+(SELECT * FROM test06g EXCEPT ALL SELECT * FROM test06p) ORDER BY id, a;
+(SELECT * FROM test06p EXCEPT ALL SELECT * FROM test06g) ORDER BY id, a;
+(SELECT * FROM test07g EXCEPT ALL SELECT * FROM test07p) ORDER BY id, a;
+(SELECT * FROM test07p EXCEPT ALL SELECT * FROM test07g) ORDER BY id, a;
+(SELECT * FROM test08g EXCEPT ALL SELECT * FROM test08p) ORDER BY id;
+(SELECT * FROM test08p EXCEPT ALL SELECT * FROM test08g) ORDER BY id;
+SELECT count(*) = 10 AS ok FROM test08g;
@@ -0,0 +1,88 @@
+---
+--- Test cases for parallel initial loading of GpuCache
+---
+SET pg_strom.regression_test_mode = on;
+SET client_min_messages = error;
+DROP SCHEMA IF EXISTS regtest_gpucache_initload_temp CASCADE;
+CREATE SCHEMA regtest_gpucache_initload_temp;
+RESET client_min_messages;
+
+SET search_path = regtest_gpucache_initload_temp,public;
+CREATE TABLE rt_load1 (
+  id    int,
+  a     int8,
+  b     float8,
+  c     text
+);
+CREATE TABLE rt_load2 (
+  id    int,
+  a     int8,
+  b     float8,
+  c     text
+);
+SELECT pgstrom.random_setseed(20261111);
+-- rows exist prior to the GpuCache configuration, so they are loaded
+INSERT INTO rt_load1 (
+  SELECT i, pgstrom.random_int(1, -4000000000, 4000000000),
+            pgstrom.random_float(1, -1000.0, 1000.0),
+            pgstrom.random_text_len(1, 48)
+    FROM generate_series(1,300000) i);
+INSERT INTO rt_load2 (SELECT * FROM rt_load1);
+DELETE FROM rt_load1 WHERE id % 97 = 0;
+DELETE FROM rt_load2 WHERE id % 97 = 0;
+VACUUM ANALYZE;
+CREATE TRIGGER rt_load1_sync AFTER INSERT OR UPDATE OR DELETE ON rt_load1 FOR ROW
+    EXECUTE FUNCTION pgstrom.gpucache_sync_trigger('gpu_device_id=0,max_num_rows=400000,redo_buffer_size=64m');
+ALTER TABLE rt_load1 ENABLE ALWAYS TRIGGER rt_load1_sync;
+CREATE TRIGGER rt_load2_sync AFTER INSERT OR UPDATE OR DELETE ON rt_load2 FOR ROW
+    EXECUTE FUNCTION pgstrom.gpucache_sync_trigger('gpu_device_id=0,max_num_rows=400000,redo_buffer_size=64m');
+ALTER TABLE rt_load2 ENABLE ALWAYS TRIGGER rt_load2_sync;
+
+-- force to use GpuScan on the GpuCache, instead of SeqScan
+SET enable_seqscan = off;
+
+-- parallel loading by the workers
+SET pg_strom.gpucache_initial_load_workers = 4;
+SET pg_strom.enabled = on;
+SELECT * INTO test01g FROM rt_load1 WHERE id % 5 = 0;
+SET pg_strom.enabled = off;
+SELECT * INTO test01p FROM rt_load1 WHERE id % 5 = 0;
+(SELECT * FROM test01g EXCEPT ALL SELECT * FROM test01p) ORDER BY id;
+(SELECT * FROM test01p EXCEPT ALL SELECT * FROM test01g) ORDER BY id;
+SELECT phase = 'is_ready' AND
+       initload_blocks_done = initload_blocks_total AS ok
+  FROM pgstrom.gpucache_info
+ WHERE table_oid = 'rt_load1'::regclass AND database_name = current_database();
+
+-- loading in the transaction that modified the table; the workers send
+-- the rows of the current transaction back to the leader
+BEGIN;
+UPDATE rt_load2 SET a = a + 1 WHERE id % 11 = 0;
+DELETE FROM rt_load2 WHERE id % 13 = 0;
+SET pg_strom.enabled = on;
+SELECT * INTO test02g FROM rt_load2 WHERE id % 5 = 0;
+SET pg_strom.enabled = off;
+SELECT * INTO test02p FROM rt_load2 WHERE id % 5 = 0;
+(SELECT * FROM test02g EXCEPT ALL SELECT * FROM test02p) ORDER BY id;
+(SELECT * FROM test02p EXCEPT ALL SELECT * FROM test02g) ORDER BY id;
+COMMIT;
+
+SET pg_strom.enabled = on;
+SELECT * INTO test03g FROM rt_load2 WHERE id % 5 = 0;
+SET pg_strom.enabled = off;
+SELECT * INTO test03p FROM rt_load2 WHERE id % 5 = 0;
+(SELECT * FROM test03g EXCEPT ALL SELECT * FROM test03p) ORDER BY id;
+(SELECT * FROM test03p EXCEPT ALL SELECT * FROM test03g) ORDER BY id;
+
+-- serial loading gives the same result
+CREATE TABLE rt_load3 (LIKE rt_load1);
+INSERT INTO rt_load3 (SELECT * FROM rt_load1);
+VACUUM ANALYZE rt_load3;
+CREATE TRIGGER rt_load3_sync AFTER INSERT OR UPDATE OR DELETE ON rt_load3 FOR ROW
+    EXECUTE FUNCTION pgstrom.gpucache_sync_trigger('gpu_device_id=0,max_num_rows=400000,redo_buffer_size=64m');
+ALTER TABLE rt_load3 ENABLE ALWAYS TRIGGER rt_load3_sync;
+SET pg_strom.gpucache_initial_load_workers = 0;
+SET pg_strom.enabled = on;
+SELECT * INTO test04g FROM rt_load3 WHERE id % 5 = 0;
+(SELECT * FROM test04g EXCEPT ALL SELECT * FROM test01p) ORDER BY id;
+(SELECT * FROM test01p EXCEPT ALL SELECT * FROM test04g) ORDER BY id;
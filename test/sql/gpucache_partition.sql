@@ -0,0 +1,66 @@
+---
+--- Test cases for GpuCache on the partitions of a partitioned table
+---
+SET pg_strom.regression_test_mode = on;
+SET client_min_messages = error;
+DROP SCHEMA IF EXISTS regtest_gpucache_partition_temp CASCADE;
+CREATE SCHEMA regtest_gpucache_partition_temp;
+RESET client_min_messages;
+
+SET search_path = regtest_gpucache_partition_temp,public;
+CREATE TABLE rt_part (
+  id    int,
+  a     int8,
+  b     float8,
+  c     text
+) PARTITION BY HASH (id);
+CREATE TABLE rt_part_p0 PARTITION OF rt_part FOR VALUES WITH (MODULUS 4, REMAINDER 0);
+CREATE TABLE rt_part_p1 PARTITION OF rt_part FOR VALUES WITH (MODULUS 4, REMAINDER 1);
+CREATE TABLE rt_part_p2 PARTITION OF rt_part FOR VALUES WITH (MODULUS 4, REMAINDER 2);
+-- the trigger on the parent is cloned to all the partitions
+CREATE TRIGGER rt_part_sync AFTER INSERT OR UPDATE OR DELETE ON rt_part FOR ROW
+    EXECUTE FUNCTION pgstrom.gpucache_sync_trigger('gpu_device_id=roundrobin,max_num_rows=100000,redo_buffer_size=32m');
+ALTER TABLE rt_part ENABLE ALWAYS TRIGGER rt_part_sync;
+-- a partition attached later
+CREATE TABLE rt_part_p3 PARTITION OF rt_part FOR VALUES WITH (MODULUS 4, REMAINDER 3);
+SELECT pgstrom.random_setseed(20261114);
+INSERT INTO rt_part (
+  SELECT i, pgstrom.random_int(1, -4000000000, 4000000000),
+            pgstrom.random_float(1, -1000.0, 1000.0),
+            pgstrom.random_text_len(1, 32)
+    FROM generate_series(1,200000) i);
+VACUUM ANALYZE;
+
+-- force to use GpuScan on the GpuCache, instead of SeqScan
+SET enable_seqscan = off;
+
+SET pg_strom.enabled = on;
+SELECT * INTO test01g FROM rt_part WHERE id % 3 = 0;
+SELECT id % 4 AS k, count(*) nrows, sum(a) sum_a
+  INTO test02g FROM rt_part WHERE b > 0 GROUP BY id % 4;
+SET pg_strom.enabled = off;
+SELECT * INTO test01p FROM rt_part WHERE id % 3 = 0;
+SELECT id % 4 AS k, count(*) nrows, sum(a) sum_a
+  INTO test02p FROM rt_part WHERE b > 0 GROUP BY id % 4;
+(SELECT * FROM test01g EXCEPT ALL SELECT * FROM test01p) ORDER BY id;
+(SELECT * FROM test01p EXCEPT ALL SELECT * FROM test01g) ORDER BY id;
+(SELECT * FROM test02g EXCEPT ALL SELECT * FROM test02p) ORDER BY k;
+(SELECT * FROM test02p EXCEPT ALL SELECT * FROM test02g) ORDER BY k;
+
+-- every partition has its own GpuCache
+SELECT count(*) = 4 AS ok
+  FROM pgstrom.gpucache_info
+ WHERE table_oid IN (SELECT inhrelid FROM pg_inherits
+                      WHERE inhparent = 'rt_part'::regclass)
+   AND database_name = current_database()
+   AND phase = 'is_ready';
+
+-- rows moved across the partitions
+UPDATE rt_part SET id = id + 1 WHERE id % 10 = 0;
+DELETE FROM rt_part WHERE id % 17 = 0;
+SET pg_strom.enabled = on;
+SELECT * INTO test03g FROM rt_part WHERE id % 3 = 0;
+SET pg_strom.enabled = off;
+SELECT * INTO test03p FROM rt_part WHERE id % 3 = 0;
+(SELECT * FROM test03g EXCEPT ALL SELECT * FROM test03p) ORDER BY id;
+(SELECT * FROM test03p EXCEPT ALL SELECT * FROM test03g) ORDER BY id;
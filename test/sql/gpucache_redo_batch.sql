@@ -0,0 +1,84 @@
+---
+--- Test cases for batched REDO application and merge-on-read of GpuCache
+---
+--- The thresholds are large enough not to apply REDO logs during the writes,
+--- so the scan has to apply the unapplied tail by itself.
+---
+SET pg_strom.regression_test_mode = on;
+SET client_min_messages = error;
+DROP SCHEMA IF EXISTS regtest_gpucache_redo_batch_temp CASCADE;
+CREATE SCHEMA regtest_gpucache_redo_batch_temp;
+RESET client_min_messages;
+
+SET search_path = regtest_gpucache_redo_batch_temp,public;
+CREATE TABLE rt_redo (
+  id    int,
+  a     int8,
+  b     float8,
+  c     text
+);
+CREATE TRIGGER rt_redo_sync AFTER INSERT OR UPDATE OR DELETE ON rt_redo FOR ROW
+    EXECUTE FUNCTION pgstrom.gpucache_sync_trigger('gpu_device_id=0,max_num_rows=100000,redo_buffer_size=64m,gpu_sync_interval=600,gpu_sync_threshold=32m');
+ALTER TABLE rt_redo ENABLE ALWAYS TRIGGER rt_redo_sync;
+SELECT pgstrom.random_setseed(20261117);
+INSERT INTO rt_redo (
+  SELECT i, pgstrom.random_int(1, -4000000000, 4000000000),
+            pgstrom.random_float(1, -1000.0, 1000.0),
+            pgstrom.random_text_len(1, 32)
+    FROM generate_series(1,50000) i);
+VACUUM ANALYZE;
+
+-- force to use GpuScan on the GpuCache, instead of SeqScan
+SET enable_seqscan = off;
+
+-- build the GpuCache at first
+SET pg_strom.enabled = on;
+SELECT * INTO test01g FROM rt_redo WHERE id % 3 = 0;
+SET pg_strom.enabled = off;
+SELECT * INTO test01p FROM rt_redo WHERE id % 3 = 0;
+(SELECT * FROM test01g EXCEPT ALL SELECT * FROM test01p) ORDER BY id;
+(SELECT * FROM test01p EXCEPT ALL SELECT * FROM test01g) ORDER BY id;
+
+-- many small transactions, like OLTP workloads
+DO $$
+BEGIN
+  FOR i IN 50001..52000 LOOP
+    INSERT INTO rt_redo VALUES (i, i * 7, i::float8 / 3.0, 'oltp' || i);
+    COMMIT;
+  END LOOP;
+  FOR i IN 1..500 LOOP
+    UPDATE rt_redo SET a = a + 1, c = 'updated' WHERE id = i * 13;
+    COMMIT;
+    DELETE FROM rt_redo WHERE id = i * 17;
+    COMMIT;
+  END LOOP;
+END
+$$;
+
+-- the scan right after the writes has to see all of them
+SET pg_strom.enabled = on;
+SELECT * INTO test02g FROM rt_redo WHERE id % 3 = 0;
+SELECT count(*) nrows, sum(a) sum_a INTO test03g FROM rt_redo WHERE id > 0;
+SET pg_strom.enabled = off;
+SELECT * INTO test02p FROM rt_redo WHERE id % 3 = 0;
+SELECT count(*) nrows, sum(a) sum_a INTO test03p FROM rt_redo WHERE id > 0;
+(SELECT * FROM test02g EXCEPT ALL SELECT * FROM test02p) ORDER BY id;
+(SELECT * FROM test02p EXCEPT ALL SELECT * FROM test02g) ORDER BY id;
+(SELECT * FROM test03g EXCEPT ALL SELECT * FROM test03p) ORDER BY nrows;
+(SELECT * FROM test03p EXCEPT ALL SELECT * FROM test03g) ORDER BY nrows;
+
+-- all the REDO logs are already applied by the scan
+SELECT redo_read_pos = redo_write_pos AS ok
+  FROM pgstrom.gpucache_info
+ WHERE table_oid = 'rt_redo'::regclass AND database_name = current_database();
+
+-- aborted changes must not be visible, even if REDO logs are applied
+BEGIN;
+UPDATE rt_redo SET c = 'aborted' WHERE id % 5 = 0;
+ROLLBACK;
+SET pg_strom.enabled = on;
+SELECT * INTO test04g FROM rt_redo WHERE id % 5 = 0;
+SET pg_strom.enabled = off;
+SELECT * INTO test04p FROM rt_redo WHERE id % 5 = 0;
+(SELECT * FROM test04g EXCEPT ALL SELECT * FROM test04p) ORDER BY id;
+(SELECT * FROM test04p EXCEPT ALL SELECT * FROM test04g) ORDER BY id;
@@ -0,0 +1,79 @@
+---
+--- Test cases for GpuCache replicated onto multiple GPUs (gpu_replicas option)
+---
+--- It runs only when two or more GPU devices are installed.
+---
+SET pg_strom.regression_test_mode = on;
+SELECT count(*) < 2 AS skip_test
+  FROM pgstrom.gpu_device_info WHERE att_name = 'DEV_ID' \gset
+\if :skip_test
+\quit
+\endif
+SET client_min_messages = error;
+DROP SCHEMA IF EXISTS regtest_gpucache_replica_temp CASCADE;
+CREATE SCHEMA regtest_gpucache_replica_temp;
+RESET client_min_messages;
+
+SET search_path = regtest_gpucache_replica_temp,public;
+-- the primary on the first GPU, and a replica on the last GPU
+SELECT format('gpu_device_id=%s,gpu_replicas=%s,max_num_rows=200000,redo_buffer_size=32m',
+              min(att_value::int), max(att_value::int)) AS gc_opts
+  FROM pgstrom.gpu_device_info WHERE att_name = 'DEV_ID' \gset
+CREATE TABLE rt_repl (
+  id    int,
+  a     int8,
+  b     float8,
+  c     text
+);
+CREATE TRIGGER rt_repl_sync AFTER INSERT OR UPDATE OR DELETE ON rt_repl FOR ROW
+    EXECUTE FUNCTION pgstrom.gpucache_sync_trigger(:'gc_opts');
+ALTER TABLE rt_repl ENABLE ALWAYS TRIGGER rt_repl_sync;
+SELECT pgstrom.random_setseed(20261119);
+INSERT INTO rt_repl (
+  SELECT i, pgstrom.random_int(1, -4000000000, 4000000000),
+            pgstrom.random_float(1, -1000.0, 1000.0),
+            pgstrom.random_text_len(1, 32)
+    FROM generate_series(1,100000) i);
+VACUUM ANALYZE;
+
+-- force to use GpuScan on the GpuCache, instead of SeqScan
+SET enable_seqscan = off;
+
+-- scans may run on either of the primary or the replica
+SET pg_strom.enabled = on;
+SELECT * INTO test01g FROM rt_repl WHERE id % 3 = 0;
+SELECT id % 10 AS k, count(*) nrows, sum(a) sum_a
+  INTO test02g FROM rt_repl WHERE b > 0 GROUP BY id % 10;
+SET pg_strom.enabled = off;
+SELECT * INTO test01p FROM rt_repl WHERE id % 3 = 0;
+SELECT id % 10 AS k, count(*) nrows, sum(a) sum_a
+  INTO test02p FROM rt_repl WHERE b > 0 GROUP BY id % 10;
+(SELECT * FROM test01g EXCEPT ALL SELECT * FROM test01p) ORDER BY id;
+(SELECT * FROM test01p EXCEPT ALL SELECT * FROM test01g) ORDER BY id;
+(SELECT * FROM test02g EXCEPT ALL SELECT * FROM test02p) ORDER BY k;
+(SELECT * FROM test02p EXCEPT ALL SELECT * FROM test02g) ORDER BY k;
+
+-- REDO logs are applied to the replica as well
+UPDATE rt_repl SET a = a + 1, c = 'updated' WHERE id % 7 = 0;
+DELETE FROM rt_repl WHERE id % 11 = 0;
+INSERT INTO rt_repl (
+  SELECT i, i, i::float8, 'new' || i FROM generate_series(100001,101000) i);
+SET pg_strom.enabled = on;
+SELECT * INTO test03g FROM rt_repl WHERE id % 3 = 0;
+SELECT * INTO test04g FROM rt_repl WHERE id % 3 = 0;
+SET pg_strom.enabled = off;
+SELECT * INTO test03p FROM rt_repl WHERE id % 3 = 0;
+(SELECT * FROM test03g EXCEPT ALL SELECT * FROM test03p) ORDER BY id;
+(SELECT * FROM test03p EXCEPT ALL SELECT * FROM test03g) ORDER BY id;
+(SELECT * FROM test04g EXCEPT ALL SELECT * FROM test03p) ORDER BY id;
+(SELECT * FROM test03p EXCEPT ALL SELECT * FROM test04g) ORDER BY id;
+
+-- compaction rebuilds the replica also
+SELECT pgstrom.gpucache_compaction('rt_repl');
+SET pg_strom.enabled = on;
+SELECT * INTO test05g FROM rt_repl WHERE id % 3 = 0;
+(SELECT * FROM test05g EXCEPT ALL SELECT * FROM test03p) ORDER BY id;
+(SELECT * FROM test03p EXCEPT ALL SELECT * FROM test05g) ORDER BY id;
+SELECT phase = 'is_ready' AS ok
+  FROM pgstrom.gpucache_info
+ WHERE table_oid = 'rt_repl'::regclass AND database_name = current_database();
@@ -0,0 +1,58 @@
+---
+--- Test cases for on-disk snapshot of GpuCache
+---
+--- It runs only when pg_strom.gpucache_snapshot_dir is configured.
+---
+SET pg_strom.regression_test_mode = on;
+SELECT current_setting('pg_strom.gpucache_snapshot_dir') = '' AS skip_test \gset
+\if :skip_test
+\quit
+\endif
+SET client_min_messages = error;
+DROP SCHEMA IF EXISTS regtest_gpucache_snapshot_temp CASCADE;
+CREATE SCHEMA regtest_gpucache_snapshot_temp;
+RESET client_min_messages;
+
+SET search_path = regtest_gpucache_snapshot_temp,public;
+CREATE TABLE rt_snap (
+  id    int,
+  a     int8,
+  b     float8,
+  c     text
+);
+CREATE TRIGGER rt_snap_sync AFTER INSERT OR UPDATE OR DELETE ON rt_snap FOR ROW
+    EXECUTE FUNCTION pgstrom.gpucache_sync_trigger('gpu_device_id=0,max_num_rows=100000,redo_buffer_size=32m');
+ALTER TABLE rt_snap ENABLE ALWAYS TRIGGER rt_snap_sync;
+SELECT pgstrom.random_setseed(20261110);
+INSERT INTO rt_snap (
+  SELECT i, pgstrom.random_int(1, -4000000000, 4000000000),
+            pgstrom.random_float(1, -1000.0, 1000.0),
+            pgstrom.random_text_len(1, 24)
+    FROM generate_series(1,50000) i);
+VACUUM ANALYZE;
+SELECT pgstrom.gpucache_apply_redo('rt_snap');
+
+-- force to use GpuScan on the GpuCache, instead of SeqScan
+SET enable_seqscan = off;
+
+SET pg_strom.enabled = on;
+SELECT * INTO test01g FROM rt_snap WHERE id % 3 = 0;
+SET pg_strom.enabled = off;
+SELECT * INTO test01p FROM rt_snap WHERE id % 3 = 0;
+(SELECT * FROM test01g EXCEPT ALL SELECT * FROM test01p) ORDER BY id;
+(SELECT * FROM test01p EXCEPT ALL SELECT * FROM test01g) ORDER BY id;
+
+-- the first change after the snapshot removes the snapshot file
+UPDATE rt_snap SET a = a + 1 WHERE id % 100 = 0;
+DELETE FROM rt_snap WHERE id % 101 = 0;
+SELECT count(*) = 0 AS ok
+  FROM pg_ls_dir(current_setting('pg_strom.gpucache_snapshot_dir')) fname
+ WHERE fname LIKE ('gpucache\_p%\_r' || 'rt_snap'::regclass::oid || '.%.snap');
+
+SET pg_strom.enabled = on;
+SELECT * INTO test02g FROM rt_snap WHERE id % 3 = 0;
+SET pg_strom.enabled = off;
+SELECT * INTO test02p FROM rt_snap WHERE id % 3 = 0;
+(SELECT * FROM test02g EXCEPT ALL SELECT * FROM test02p) ORDER BY id;
+(SELECT * FROM test02p EXCEPT ALL SELECT * FROM test02g) ORDER BY id;
+SELECT count(*) = 16501 AS ok FROM test02g;
@@ -0,0 +1,79 @@
+---
+--- Test cases for GpuCache synchronized by WAL decoding (sync_mode=wal)
+---
+--- It runs only when wal_level = logical and the GpuCache WAL sync worker
+--- runs on this database (pg_strom.gpucache_wal_sync_databases).
+---
+SET pg_strom.regression_test_mode = on;
+SELECT current_setting('wal_level') <> 'logical' OR
+       NOT current_database() = ANY(string_to_array(replace(current_setting('pg_strom.gpucache_wal_sync_databases'), ' ', ''), ',')) AS skip_test \gset
+\if :skip_test
+\quit
+\endif
+SET client_min_messages = error;
+DROP SCHEMA IF EXISTS regtest_gpucache_walsync_temp CASCADE;
+CREATE SCHEMA regtest_gpucache_walsync_temp;
+RESET client_min_messages;
+
+SET search_path = regtest_gpucache_walsync_temp,public;
+CREATE TABLE rt_wal (
+  id    int,
+  a     int8,
+  b     float8,
+  c     text
+);
+CREATE TRIGGER rt_wal_sync AFTER INSERT OR UPDATE OR DELETE ON rt_wal FOR ROW
+    EXECUTE FUNCTION pgstrom.gpucache_sync_trigger('gpu_device_id=0,max_num_rows=200000,redo_buffer_size=64m,sync_mode=wal');
+ALTER TABLE rt_wal ENABLE ALWAYS TRIGGER rt_wal_sync;
+SELECT pgstrom.random_setseed(20261112);
+INSERT INTO rt_wal (
+  SELECT i, pgstrom.random_int(1, -4000000000, 4000000000),
+            pgstrom.random_float(1, -1000.0, 1000.0),
+            pgstrom.random_text_len(1, 32)
+    FROM generate_series(1,100000) i);
+VACUUM ANALYZE;
+
+-- force to use GpuScan on the GpuCache, instead of SeqScan
+SET enable_seqscan = off;
+SET pg_strom.enabled = on;
+
+-- the worker builds the GpuCache asynchronously
+DO $$
+BEGIN
+  FOR i IN 1..600 LOOP
+    PERFORM count(*) FROM rt_wal WHERE id < 0;
+    EXIT WHEN (SELECT phase FROM pgstrom.gpucache_info
+                WHERE table_oid = 'rt_wal'::regclass
+                  AND database_name = current_database()) = 'is_ready';
+    PERFORM pg_sleep(0.1);
+  END LOOP;
+END
+$$;
+
+-- changes by the committed transactions, then the marker row at last;
+-- WAL is decoded in order, so all the changes are visible with it
+UPDATE rt_wal SET a = a + 1 WHERE id % 7 = 0;
+DELETE FROM rt_wal WHERE id % 11 = 0;
+BEGIN;
+UPDATE rt_wal SET c = 'aborted' WHERE id % 13 = 0;
+ROLLBACK;
+INSERT INTO rt_wal (
+  SELECT i, i, i::float8, 'new' || i FROM generate_series(100001,101000) i);
+INSERT INTO rt_wal VALUES (-1, 0, 0.0, 'marker');
+DO $$
+BEGIN
+  FOR i IN 1..600 LOOP
+    EXIT WHEN EXISTS (SELECT * FROM rt_wal WHERE id = -1);
+    PERFORM pg_sleep(0.1);
+  END LOOP;
+END
+$$;
+
+SELECT * INTO test01g FROM rt_wal WHERE id % 3 = 0;
+SET pg_strom.enabled = off;
+SELECT * INTO test01p FROM rt_wal WHERE id % 3 = 0;
+(SELECT * FROM test01g EXCEPT ALL SELECT * FROM test01p) ORDER BY id;
+(SELECT * FROM test01p EXCEPT ALL SELECT * FROM test01g) ORDER BY id;
+SELECT phase = 'is_ready' AS ok
+  FROM pgstrom.gpucache_info
+ WHERE table_oid = 'rt_wal'::regclass AND database_name = current_database();
@@ -0,0 +1,78 @@
+---
+--- Test cases for hash joins on dense integer keys
+---
+SET pg_strom.regression_test_mode = on;
+SET client_min_messages = error;
+DROP SCHEMA IF EXISTS regtest_join_direct_temp CASCADE;
+CREATE SCHEMA regtest_join_direct_temp;
+RESET client_min_messages;
+
+SET search_path = regtest_join_direct_temp,public;
+CREATE TABLE rt_outer (
+  id    int,
+  k4    int4,
+  k8    int8,
+  kd    date
+);
+CREATE TABLE rt_dense (
+  k4    int4,
+  k8    int8,
+  kd    date,
+  v     text
+);
+SELECT pgstrom.random_setseed(20261106);
+INSERT INTO rt_outer (
+  SELECT i, pgstrom.random_int(1, -500, 12000),
+            pgstrom.random_int(1, 1000000000000, 1000000012000),
+            pgstrom.random_date(1, '2019-12-01', '2021-03-01')
+    FROM generate_series(1,60000) i);
+-- dense inner keys with duplicates, gaps and NULLs
+INSERT INTO rt_dense (
+  SELECT i / 2, i / 2 + 1000000000000, '2020-01-01'::date + i / 30,
+         md5(i::text)
+    FROM generate_series(1,20000) i
+   WHERE i % 97 <> 0);
+INSERT INTO rt_dense VALUES (NULL, NULL, NULL, 'null keys');
+VACUUM ANALYZE;
+
+-- force to use GpuJoin, instead of HashJoin / NestLoop
+SET enable_seqscan = off;
+SET enable_hashjoin = off;
+SET enable_mergejoin = off;
+SET enable_nestloop = off;
+
+-- int4, int8 and date join keys
+SET pg_strom.enabled = on;
+SELECT id, o.k4, v INTO test01g
+  FROM rt_outer o, rt_dense d WHERE o.k4 = d.k4;
+SELECT id, o.k8, v INTO test02g
+  FROM rt_outer o, rt_dense d WHERE o.k8 = d.k8;
+SELECT id, o.kd, count(*) c INTO test03g
+  FROM rt_outer o, rt_dense d WHERE o.kd = d.kd
+ GROUP BY id, o.kd;
+SET pg_strom.enabled = off;
+SELECT id, o.k4, v INTO test01p
+  FROM rt_outer o, rt_dense d WHERE o.k4 = d.k4;
+SELECT id, o.k8, v INTO test02p
+  FROM rt_outer o, rt_dense d WHERE o.k8 = d.k8;
+SELECT id, o.kd, count(*) c INTO test03p
+  FROM rt_outer o, rt_dense d WHERE o.kd = d.kd
+ GROUP BY id, o.kd;
+(SELECT * FROM test01g EXCEPT ALL SELECT * FROM test01p) ORDER BY id, v;
+(SELECT * FROM test01p EXCEPT ALL SELECT * FROM test01g) ORDER BY id, v;
+(SELECT * FROM test02g EXCEPT ALL SELECT * FROM test02p) ORDER BY id, v;
+(SELECT * FROM test02p EXCEPT ALL SELECT * FROM test02g) ORDER BY id, v;
+(SELECT * FROM test03g EXCEPT ALL SELECT * FROM test03p) ORDER BY id;
+(SELECT * FROM test03p EXCEPT ALL SELECT * FROM test03g) ORDER BY id;
+
+-- LEFT OUTER JOIN, and an additional join qual on the candidates
+SET pg_strom.enabled = on;
+SELECT id, o.k4, v INTO test04g
+  FROM rt_outer o LEFT JOIN rt_dense d ON o.k4 = d.k4 AND d.v LIKE '%a%'
+ WHERE id % 5 = 0;
+SET pg_strom.enabled = off;
+SELECT id, o.k4, v INTO test04p
+  FROM rt_outer o LEFT JOIN rt_dense d ON o.k4 = d.k4 AND d.v LIKE '%a%'
+ WHERE id % 5 = 0;
+(SELECT * FROM test04g EXCEPT ALL SELECT * FROM test04p) ORDER BY id, v;
+(SELECT * FROM test04p EXCEPT ALL SELECT * FROM test04g) ORDER BY id, v;
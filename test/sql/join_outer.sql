@@ -0,0 +1,83 @@
+---
+--- Test cases for RIGHT/FULL OUTER joins
+---
+SET pg_strom.regression_test_mode = on;
+SET client_min_messages = error;
+DROP SCHEMA IF EXISTS regtest_join_outer_temp CASCADE;
+CREATE SCHEMA regtest_join_outer_temp;
+RESET client_min_messages;
+
+SET search_path = regtest_join_outer_temp,public;
+CREATE TABLE rt_fact (
+  id    int,
+  k1    int,
+  k2    int,
+  v     float8
+);
+CREATE TABLE rt_dim1 (
+  k1    int,
+  n1    text
+);
+CREATE TABLE rt_dim2 (
+  k2    int,
+  n2    text
+);
+SELECT pgstrom.random_setseed(20261104);
+INSERT INTO rt_fact (
+  SELECT i, pgstrom.random_int(1, 1, 8000),
+            pgstrom.random_int(1, 1, 3000),
+            pgstrom.random_float(1, -1000.0, 1000.0)
+    FROM generate_series(1,50000) i);
+-- inner keys outside of the outer range are the unmatched rows
+INSERT INTO rt_dim1 (
+  SELECT i, md5(i::text) FROM generate_series(4000,12000) i);
+INSERT INTO rt_dim2 (
+  SELECT i, md5((i+1)::text) FROM generate_series(2000,5000) i);
+INSERT INTO rt_dim2 VALUES (NULL, 'null key');
+VACUUM ANALYZE;
+
+-- force to use GpuJoin, instead of HashJoin / NestLoop
+SET enable_seqscan = off;
+SET enable_hashjoin = off;
+SET enable_mergejoin = off;
+SET enable_nestloop = off;
+
+-- RIGHT OUTER JOIN
+SET pg_strom.enabled = on;
+SELECT id, f.k1 fk1, d.k1 dk1, n1, v
+  INTO test01g
+  FROM rt_fact f RIGHT OUTER JOIN rt_dim1 d ON f.k1 = d.k1;
+SET pg_strom.enabled = off;
+SELECT id, f.k1 fk1, d.k1 dk1, n1, v
+  INTO test01p
+  FROM rt_fact f RIGHT OUTER JOIN rt_dim1 d ON f.k1 = d.k1;
+(SELECT * FROM test01g EXCEPT ALL SELECT * FROM test01p) ORDER BY id, dk1;
+(SELECT * FROM test01p EXCEPT ALL SELECT * FROM test01g) ORDER BY id, dk1;
+
+-- FULL OUTER JOIN
+SET pg_strom.enabled = on;
+SELECT id, f.k2 fk2, d.k2 dk2, n2
+  INTO test02g
+  FROM rt_fact f FULL OUTER JOIN rt_dim2 d ON f.k2 = d.k2
+ WHERE id IS NULL OR id % 3 = 0;
+SET pg_strom.enabled = off;
+SELECT id, f.k2 fk2, d.k2 dk2, n2
+  INTO test02p
+  FROM rt_fact f FULL OUTER JOIN rt_dim2 d ON f.k2 = d.k2
+ WHERE id IS NULL OR id % 3 = 0;
+(SELECT * FROM test02g EXCEPT ALL SELECT * FROM test02p) ORDER BY id, dk2;
+(SELECT * FROM test02p EXCEPT ALL SELECT * FROM test02g) ORDER BY id, dk2;
+
+-- multi-depth RIGHT/FULL OUTER JOIN; deeper depths see the null-extended rows
+SET pg_strom.enabled = on;
+SELECT id, d1.k1, n1, d2.k2, n2
+  INTO test03g
+  FROM rt_fact f RIGHT OUTER JOIN rt_dim1 d1 ON f.k1 = d1.k1
+                 FULL OUTER JOIN rt_dim2 d2 ON f.k2 = d2.k2;
+SET pg_strom.enabled = off;
+SELECT id, d1.k1, n1, d2.k2, n2
+  INTO test03p
+  FROM rt_fact f RIGHT OUTER JOIN rt_dim1 d1 ON f.k1 = d1.k1
+                 FULL OUTER JOIN rt_dim2 d2 ON f.k2 = d2.k2;
+(SELECT * FROM test03g EXCEPT ALL SELECT * FROM test03p) ORDER BY id, k1, k2;
+(SELECT * FROM test03p EXCEPT ALL SELECT * FROM test03g) ORDER BY id, k1, k2;
@@ -0,0 +1,99 @@
+---
+--- Test cases for GpuHashJoin with partitioned inner buffer (grace hash-join)
+---
+SET pg_strom.regression_test_mode = on;
+SET client_min_messages = error;
+DROP SCHEMA IF EXISTS regtest_join_partition_temp CASCADE;
+CREATE SCHEMA regtest_join_partition_temp;
+RESET client_min_messages;
+
+SET search_path = regtest_join_partition_temp,public;
+CREATE TABLE rt_fact (
+  id    int,
+  k1    int,
+  k2    int,
+  v     float8
+);
+CREATE TABLE rt_dim1 (
+  k1    int,
+  n1    text
+);
+CREATE TABLE rt_dim2 (
+  k2    int,
+  n2    text
+);
+SELECT pgstrom.random_setseed(20261120);
+INSERT INTO rt_fact (
+  SELECT i, pgstrom.random_int(1, 1, 120000),
+            pgstrom.random_int(1, 1, 3000),
+            pgstrom.random_float(1, -1000.0, 1000.0)
+    FROM generate_series(1,200000) i);
+-- the inner buffer of rt_dim1 is much larger than the partition size
+INSERT INTO rt_dim1 (
+  SELECT i, md5(i::text) || md5((i+1)::text) FROM generate_series(1,100000) i);
+-- duplicated keys and NULL key
+INSERT INTO rt_dim1 (
+  SELECT i, 'dup' || i FROM generate_series(1,100000,97) i);
+INSERT INTO rt_dim1 VALUES (NULL, 'null key');
+INSERT INTO rt_dim2 (
+  SELECT i, md5(i::text) FROM generate_series(1,3000) i);
+VACUUM ANALYZE;
+
+-- force to use GpuJoin, instead of HashJoin / NestLoop
+SET enable_seqscan = off;
+SET enable_hashjoin = off;
+SET enable_mergejoin = off;
+SET enable_nestloop = off;
+SET pg_strom.enable_gpuhashjoin_partition = on;
+SET pg_strom.gpujoin_inner_partition_size = '1MB';
+
+-- INNER JOIN with partitioned inner buffer
+SET pg_strom.enabled = on;
+SELECT id, f.k1, n1, v
+  INTO test01g
+  FROM rt_fact f JOIN rt_dim1 d ON f.k1 = d.k1;
+SELECT d.k1 % 100 AS k, count(*) nrows, sum(v) sum_v
+  INTO test02g
+  FROM rt_fact f JOIN rt_dim1 d ON f.k1 = d.k1
+ WHERE f.id % 3 = 0
+ GROUP BY d.k1 % 100;
+SET pg_strom.enabled = off;
+SELECT id, f.k1, n1, v
+  INTO test01p
+  FROM rt_fact f JOIN rt_dim1 d ON f.k1 = d.k1;
+SELECT d.k1 % 100 AS k, count(*) nrows, sum(v) sum_v
+  INTO test02p
+  FROM rt_fact f JOIN rt_dim1 d ON f.k1 = d.k1
+ WHERE f.id % 3 = 0
+ GROUP BY d.k1 % 100;
+(SELECT * FROM test01g EXCEPT ALL SELECT * FROM test01p) ORDER BY id, n1;
+(SELECT * FROM test01p EXCEPT ALL SELECT * FROM test01g) ORDER BY id, n1;
+(SELECT k, nrows FROM test02g EXCEPT ALL SELECT k, nrows FROM test02p) ORDER BY k;
+(SELECT k, nrows FROM test02p EXCEPT ALL SELECT k, nrows FROM test02g) ORDER BY k;
+SELECT bool_and(abs(g.sum_v - p.sum_v) < 0.001) AS ok
+  FROM test02g g JOIN test02p p ON g.k = p.k;
+
+-- multi-depth INNER JOIN; only the last depth is partitioned
+SET pg_strom.enabled = on;
+SELECT id, f.k1, f.k2, n1, n2
+  INTO test03g
+  FROM rt_fact f JOIN rt_dim2 d2 ON f.k2 = d2.k2
+                 JOIN rt_dim1 d1 ON f.k1 = d1.k1
+ WHERE v > 0;
+SET pg_strom.enabled = off;
+SELECT id, f.k1, f.k2, n1, n2
+  INTO test03p
+  FROM rt_fact f JOIN rt_dim2 d2 ON f.k2 = d2.k2
+                 JOIN rt_dim1 d1 ON f.k1 = d1.k1
+ WHERE v > 0;
+(SELECT * FROM test03g EXCEPT ALL SELECT * FROM test03p) ORDER BY id, n1;
+(SELECT * FROM test03p EXCEPT ALL SELECT * FROM test03g) ORDER BY id, n1;
+
+-- same query without the partitioning
+SET pg_strom.enable_gpuhashjoin_partition = off;
+SET pg_strom.enabled = on;
+SELECT id, f.k1, n1, v
+  INTO test04g
+  FROM rt_fact f JOIN rt_dim1 d ON f.k1 = d.k1;
+(SELECT * FROM test04g EXCEPT ALL SELECT * FROM test01p) ORDER BY id, n1;
+(SELECT * FROM test01p EXCEPT ALL SELECT * FROM test04g) ORDER BY id, n1;
@@ -0,0 +1,85 @@
+---
+--- Test cases for band (range) joins
+---
+SET pg_strom.regression_test_mode = on;
+SET client_min_messages = error;
+DROP SCHEMA IF EXISTS regtest_join_range_temp CASCADE;
+CREATE SCHEMA regtest_join_range_temp;
+RESET client_min_messages;
+
+SET search_path = regtest_join_range_temp,public;
+CREATE TABLE rt_event (
+  id    int,
+  x     int8,
+  ts    timestamp
+);
+CREATE TABLE rt_span (
+  sid   int,
+  lo    int8,
+  hi    int8,
+  start_ts timestamp,
+  end_ts   timestamp
+);
+SELECT pgstrom.random_setseed(20261105);
+INSERT INTO rt_event (
+  SELECT i, pgstrom.random_int(1, 0, 1000000),
+            pgstrom.random_timestamp(1, '2020-01-01', '2021-01-01')
+    FROM generate_series(1,40000) i);
+-- overlapped spans, and spans with NULL bounds
+INSERT INTO rt_span (
+  SELECT i, lo, lo + pgstrom.random_int(0, 0, 5000),
+            ts, ts + pgstrom.random_int(0, 1, 72) * interval '1 hour'
+    FROM (SELECT i, pgstrom.random_int(1, 0, 1000000) lo,
+                    pgstrom.random_timestamp(1, '2020-01-01', '2021-01-01') ts
+            FROM generate_series(1,2000) i) AS foo);
+VACUUM ANALYZE;
+
+-- force to use GpuJoin, instead of HashJoin / NestLoop
+SET enable_seqscan = off;
+SET enable_hashjoin = off;
+SET enable_mergejoin = off;
+SET enable_nestloop = off;
+
+-- BETWEEN on integer keys
+SET pg_strom.enabled = on;
+SELECT id, sid, x
+  INTO test01g
+  FROM rt_event, rt_span
+ WHERE x BETWEEN lo AND hi;
+SET pg_strom.enabled = off;
+SELECT id, sid, x
+  INTO test01p
+  FROM rt_event, rt_span
+ WHERE x BETWEEN lo AND hi;
+(SELECT * FROM test01g EXCEPT ALL SELECT * FROM test01p) ORDER BY id, sid;
+(SELECT * FROM test01p EXCEPT ALL SELECT * FROM test01g) ORDER BY id, sid;
+
+-- half-open ranges on timestamp keys, with LEFT OUTER JOIN
+SET pg_strom.enabled = on;
+SELECT id, sid, ts
+  INTO test02g
+  FROM rt_event LEFT OUTER JOIN rt_span
+    ON ts >= start_ts AND ts < end_ts
+ WHERE id % 4 = 0;
+SET pg_strom.enabled = off;
+SELECT id, sid, ts
+  INTO test02p
+  FROM rt_event LEFT OUTER JOIN rt_span
+    ON ts >= start_ts AND ts < end_ts
+ WHERE id % 4 = 0;
+(SELECT * FROM test02g EXCEPT ALL SELECT * FROM test02p) ORDER BY id, sid;
+(SELECT * FROM test02p EXCEPT ALL SELECT * FROM test02g) ORDER BY id, sid;
+
+-- strict bounds with an additional join qual
+SET pg_strom.enabled = on;
+SELECT id, sid
+  INTO test03g
+  FROM rt_event, rt_span
+ WHERE x > lo AND x < hi AND (id + sid) % 3 = 0;
+SET pg_strom.enabled = off;
+SELECT id, sid
+  INTO test03p
+  FROM rt_event, rt_span
+ WHERE x > lo AND x < hi AND (id + sid) % 3 = 0;
+(SELECT * FROM test03g EXCEPT ALL SELECT * FROM test03p) ORDER BY id, sid;
+(SELECT * FROM test03p EXCEPT ALL SELECT * FROM test03g) ORDER BY id, sid;
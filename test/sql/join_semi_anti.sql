@@ -0,0 +1,107 @@
+---
+--- Test cases for SEMI and ANTI joins
+---
+SET pg_strom.regression_test_mode = on;
+SET client_min_messages = error;
+DROP SCHEMA IF EXISTS regtest_join_semi_anti_temp CASCADE;
+CREATE SCHEMA regtest_join_semi_anti_temp;
+RESET client_min_messages;
+
+SET search_path = regtest_join_semi_anti_temp,public;
+CREATE TABLE rt_outer (
+  id    int,
+  k     int,
+  v     float8
+);
+CREATE TABLE rt_inner (
+  aid   int,
+  k     int,
+  w     int
+);
+SELECT pgstrom.random_setseed(20261102);
+INSERT INTO rt_outer (
+  SELECT i, pgstrom.random_int(1, 1, 20000),
+            pgstrom.random_float(1, -1000.0, 1000.0)
+    FROM generate_series(1,50000) i);
+-- inner keys have duplicates and NULLs
+INSERT INTO rt_inner (
+  SELECT i, pgstrom.random_int(1, 1, 12000),
+            pgstrom.random_int(0, 0, 100)
+    FROM generate_series(1,15000) i);
+VACUUM ANALYZE;
+
+-- force to use GpuJoin, instead of HashJoin / NestLoop
+SET enable_seqscan = off;
+SET enable_hashjoin = off;
+SET enable_mergejoin = off;
+SET enable_nestloop = off;
+
+-- SEMI join (hash)
+SET pg_strom.enabled = on;
+SELECT id, k, v
+  INTO test01g
+  FROM rt_outer o
+ WHERE EXISTS (SELECT 1 FROM rt_inner i WHERE i.k = o.k AND i.w < 50);
+SET pg_strom.enabled = off;
+SELECT id, k, v
+  INTO test01p
+  FROM rt_outer o
+ WHERE EXISTS (SELECT 1 FROM rt_inner i WHERE i.k = o.k AND i.w < 50);
+(SELECT * FROM test01g EXCEPT ALL SELECT * FROM test01p) ORDER BY id;
+(SELECT * FROM test01p EXCEPT ALL SELECT * FROM test01g) ORDER BY id;
+
+-- SEMI join by IN subquery
+SET pg_strom.enabled = on;
+SELECT id, k
+  INTO test02g
+  FROM rt_outer
+ WHERE k IN (SELECT k FROM rt_inner WHERE w % 3 = 0);
+SET pg_strom.enabled = off;
+SELECT id, k
+  INTO test02p
+  FROM rt_outer
+ WHERE k IN (SELECT k FROM rt_inner WHERE w % 3 = 0);
+(SELECT * FROM test02g EXCEPT ALL SELECT * FROM test02p) ORDER BY id;
+(SELECT * FROM test02p EXCEPT ALL SELECT * FROM test02g) ORDER BY id;
+
+-- ANTI join (hash), including the outer rows with NULL keys
+SET pg_strom.enabled = on;
+SELECT id, k, v
+  INTO test03g
+  FROM rt_outer o
+ WHERE NOT EXISTS (SELECT 1 FROM rt_inner i WHERE i.k = o.k);
+SET pg_strom.enabled = off;
+SELECT id, k, v
+  INTO test03p
+  FROM rt_outer o
+ WHERE NOT EXISTS (SELECT 1 FROM rt_inner i WHERE i.k = o.k);
+(SELECT * FROM test03g EXCEPT ALL SELECT * FROM test03p) ORDER BY id;
+(SELECT * FROM test03p EXCEPT ALL SELECT * FROM test03g) ORDER BY id;
+
+-- SEMI / ANTI join by non-equal condition (nested-loop)
+SET pg_strom.enabled = on;
+SELECT id, k
+  INTO test04g
+  FROM rt_outer o
+ WHERE o.id <= 5000
+   AND EXISTS (SELECT 1 FROM rt_inner i WHERE i.aid <= 500 AND o.k BETWEEN i.k AND i.k + i.w);
+SELECT id, k
+  INTO test05g
+  FROM rt_outer o
+ WHERE o.id <= 5000
+   AND NOT EXISTS (SELECT 1 FROM rt_inner i WHERE i.aid <= 500 AND o.k BETWEEN i.k AND i.k + i.w);
+SET pg_strom.enabled = off;
+SELECT id, k
+  INTO test04p
+  FROM rt_outer o
+ WHERE o.id <= 5000
+   AND EXISTS (SELECT 1 FROM rt_inner i WHERE i.aid <= 500 AND o.k BETWEEN i.k AND i.k + i.w);
+SELECT id, k
+  INTO test05p
+  FROM rt_outer o
+ WHERE o.id <= 5000
+   AND NOT EXISTS (SELECT 1 FROM rt_inner i WHERE i.aid <= 500 AND o.k BETWEEN i.k AND i.k + i.w);
+(SELECT * FROM test04g EXCEPT ALL SELECT * FROM test04p) ORDER BY id;
+(SELECT * FROM test04p EXCEPT ALL SELECT * FROM test04g) ORDER BY id;
+(SELECT * FROM test05g EXCEPT ALL SELECT * FROM test05p) ORDER BY id;
+(SELECT * FROM test05p EXCEPT ALL SELECT * FROM test05g) ORDER BY id;
@@ -0,0 +1,55 @@
+---
+--- Test cases for TABLESAMPLE on GPU scans
+---
+SET pg_strom.regression_test_mode = on;
+SET client_min_messages = error;
+DROP SCHEMA IF EXISTS regtest_scan_tablesample_temp CASCADE;
+CREATE SCHEMA regtest_scan_tablesample_temp;
+RESET client_min_messages;
+
+SET search_path = regtest_scan_tablesample_temp,public;
+CREATE TABLE rt_sample (
+  id    int,
+  a     int8,
+  x     float8
+);
+SELECT pgstrom.random_setseed(20261107);
+INSERT INTO rt_sample (
+  SELECT i, pgstrom.random_int(1, -4000000000, 4000000000),
+            pgstrom.random_float(1, -1000.0, 1000.0)
+    FROM generate_series(1,200000) i);
+VACUUM ANALYZE;
+
+-- force to use GpuScan, instead of SeqScan
+SET enable_seqscan = off;
+
+-- GPU sampling picks other rows than SampleScan, so samples are compared
+-- between GPU runs, and the sampled rows are compared with the table.
+SET pg_strom.enabled = on;
+SELECT id, a, x INTO test01g
+  FROM rt_sample TABLESAMPLE BERNOULLI (10) REPEATABLE (42)
+ WHERE x > 0;
+SELECT id, a, x INTO test02g
+  FROM rt_sample TABLESAMPLE BERNOULLI (10) REPEATABLE (42)
+ WHERE x > 0;
+SELECT id, a, x INTO test03g
+  FROM rt_sample TABLESAMPLE SYSTEM (20) REPEATABLE (7);
+SELECT id, a, x INTO test04g
+  FROM rt_sample TABLESAMPLE SYSTEM (20) REPEATABLE (7);
+(SELECT * FROM test01g EXCEPT ALL SELECT * FROM test02g) ORDER BY id;
+(SELECT * FROM test02g EXCEPT ALL SELECT * FROM test01g) ORDER BY id;
+(SELECT * FROM test03g EXCEPT ALL SELECT * FROM test04g) ORDER BY id;
+(SELECT * FROM test04g EXCEPT ALL SELECT * FROM test03g) ORDER BY id;
+SET pg_strom.enabled = off;
+(SELECT * FROM test01g EXCEPT ALL SELECT * FROM rt_sample WHERE x > 0) ORDER BY id;
+(SELECT * FROM test03g EXCEPT ALL SELECT * FROM rt_sample) ORDER BY id;
+-- the sample sizes are around 10% of 'x > 0' rows, and 20% of the table
+SELECT count(*) BETWEEN 0.08 * (SELECT count(*) FROM rt_sample WHERE x > 0)
+                    AND 0.12 * (SELECT count(*) FROM rt_sample WHERE x > 0) AS ok
+  FROM test01g;
+SELECT count(*) BETWEEN 0.15 * 200000 AND 0.25 * 200000 AS ok
+  FROM test03g;
+SELECT count(*) = 200000 AS ok
+  FROM rt_sample TABLESAMPLE BERNOULLI (100);
+SELECT count(*) = 0 AS ok
+  FROM rt_sample TABLESAMPLE SYSTEM (0);
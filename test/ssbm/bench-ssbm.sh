@@ -0,0 +1,360 @@
+#!/bin/sh
+#
+# bench-ssbm.sh - SSBM performance benchmark of PG-Strom
+#
+# It loads the SSBM dataset at the scale factors given, into the heap
+# tables, GPU cache and arrow_fdw variants of 'lineorder', runs the queries
+# of ssbm-all-strom.sql on each variant, then writes out the JSON report
+# with the runtime, EXPLAIN ANALYZE counters, GPU-Direct bytes and the
+# peak of GPU memory usage. Datasets already loaded are reused.
+#
+# See 'make bench-ssbm' in test/Makefile
+#
+usage()
+{
+  cat <<EOF
+usage: bench-ssbm.sh [OPTIONS]
+
+OPTIONS:
+  -d DBNAME   : database name (default: ssbm_bench)
+  -s SF[,...] : scale factors (default: 1)
+  -n NLOOPS   : number of runs for each query (default: 3)
+  -c CACHE    : 'warm' or 'cold' (default: warm)
+                cold runs \$DROP_CACHES_CMD (and \$RESTART_CMD, if any)
+                prior to each run.
+  -v VARIANTS : comma separated list of 'heap', 'gpucache' and 'arrow'
+                (default: heap,gpucache,arrow)
+  -a DIR      : directory of the arrow files (default: /tmp)
+  -o FILE     : output JSON report (default: ssbm-bench-<run_id>.json)
+  -f          : reload the dataset, even if exists
+  -h          : shows this message
+
+ENVIRONMENT:
+  PSQL, CREATEDB, PG2ARROW_CMD, DBGEN_SSBM_CMD : commands to use
+  DROP_CACHES_CMD : (default: 'sudo sysctl -q -w vm.drop_caches=3')
+  RESTART_CMD     : restarts PostgreSQL to drop shared buffers (default: none)
+EOF
+  exit $1
+}
+
+CWD=`dirname $0`
+PSQL=${PSQL:-psql}
+CREATEDB=${CREATEDB:-createdb}
+PG2ARROW_CMD=${PG2ARROW_CMD:-pg2arrow}
+DBGEN_SSBM_CMD=${DBGEN_SSBM_CMD:-dbgen-ssbm}
+DROP_CACHES_CMD=${DROP_CACHES_CMD:-"sudo sysctl -q -w vm.drop_caches=3"}
+RESTART_CMD=${RESTART_CMD:-}
+DBNAME="ssbm_bench"
+SF_LIST="1"
+NLOOPS=3
+CACHE="warm"
+VARIANTS="heap,gpucache,arrow"
+ARROW_DIR="/tmp"
+REPORT=""
+RELOAD=0
+RUN_ID=`date +%Y%m%d_%H%M%S`
+
+while getopts "d:s:n:c:v:a:o:fh" opt
+do
+  case $opt in
+    d) DBNAME="$OPTARG" ;;
+    s) SF_LIST="$OPTARG" ;;
+    n) NLOOPS="$OPTARG" ;;
+    c) CACHE="$OPTARG" ;;
+    v) VARIANTS="$OPTARG" ;;
+    a) ARROW_DIR="$OPTARG" ;;
+    o) REPORT="$OPTARG" ;;
+    f) RELOAD=1 ;;
+    h) usage 0 ;;
+    *) usage 1 ;;
+  esac
+done
+REPORT=${REPORT:-ssbm-bench-${RUN_ID}.json}
+
+case "$NLOOPS" in
+  ''|*[!0-9]*|0) echo "invalid -n NLOOPS: $NLOOPS" >&2; exit 1 ;;
+esac
+case "$CACHE" in
+  warm|cold) ;;
+  *) echo "invalid -c CACHE: $CACHE" >&2; exit 1 ;;
+esac
+for v in `echo $VARIANTS | tr ',' ' '`
+do
+  case "$v" in
+    heap|gpucache|arrow) ;;
+    *) echo "unknown variant: $v" >&2; exit 1 ;;
+  esac
+done
+for sf in `echo $SF_LIST | tr ',' ' '`
+do
+  case "$sf" in
+    ''|*[!0-9]*|0) echo "invalid scale factor: $sf" >&2; exit 1 ;;
+  esac
+done
+
+sql()
+{
+  $PSQL -X -q -v ON_ERROR_STOP=1 -d "$DBNAME" "$@"
+}
+
+schema_exists()
+{
+  test "`sql -At -c "SELECT 1 FROM pg_namespace WHERE nspname = '$1'"`" = "1"
+}
+
+# search_path SF VARIANT
+search_path()
+{
+  case "$2" in
+    heap) echo "ssbm_sf$1,public" ;;
+    *)    echo "ssbm_sf$1_$2,ssbm_sf$1,public" ;;
+  esac
+}
+
+#
+# setup of the database
+#
+if [ "`$PSQL -X -At -d postgres -c "SELECT 1 FROM pg_database WHERE datname = '$DBNAME'"`" != "1" ]; then
+  $CREATEDB -E UTF-8 -T template0 "$DBNAME" || exit 1
+fi
+sql -c 'CREATE EXTENSION IF NOT EXISTS pg_strom' || exit 1
+sql -f ${CWD}/bench-ssbm.sql || exit 1
+
+#
+# load_heap SF - heap tables on the schema ssbm_sf<SF>
+#
+load_heap()
+{
+  SCHEMA="ssbm_sf$1"
+
+  if [ $RELOAD -eq 0 ] && schema_exists $SCHEMA; then
+    return 0
+  fi
+  echo "loading SSBM dataset (SF=$1) into $SCHEMA"
+  sql <<EOF || return 1
+DROP SCHEMA IF EXISTS ${SCHEMA} CASCADE;
+DROP SCHEMA IF EXISTS ${SCHEMA}_gpucache CASCADE;
+DROP SCHEMA IF EXISTS ${SCHEMA}_arrow CASCADE;
+CREATE SCHEMA ${SCHEMA};
+SET search_path = ${SCHEMA};
+CREATE TABLE customer (
+    c_custkey numeric PRIMARY KEY,
+    c_name character varying(25),
+    c_address character varying(25),
+    c_city character(10),
+    c_nation character(15),
+    c_region character(12),
+    c_phone character(15),
+    c_mktsegment character(10)
+);
+CREATE TABLE date1 (
+    d_datekey integer PRIMARY KEY,
+    d_date character(18),
+    d_dayofweek character(12),
+    d_month character(9),
+    d_year integer,
+    d_yearmonthnum numeric,
+    d_yearmonth character(7),
+    d_daynuminweek numeric,
+    d_daynuminmonth numeric,
+    d_daynuminyear numeric,
+    d_monthnuminyear numeric,
+    d_weeknuminyear numeric,
+    d_sellingseason character(12),
+    d_lastdayinweekfl character(1),
+    d_lastdayinmonthfl character(1),
+    d_holidayfl character(1),
+    d_weekdayfl character(1)
+);
+CREATE TABLE lineorder (
+    lo_orderkey numeric,
+    lo_linenumber integer,
+    lo_custkey numeric,
+    lo_partkey integer,
+    lo_suppkey numeric,
+    lo_orderdate integer,
+    lo_orderpriority character(15),
+    lo_shippriority character(1),
+    lo_quantity numeric,
+    lo_extendedprice numeric,
+    lo_ordertotalprice numeric,
+    lo_discount numeric,
+    lo_revenue numeric,
+    lo_supplycost numeric,
+    lo_tax numeric,
+    lo_commit_date character(8),
+    lo_shipmode character(10)
+);
+CREATE TABLE part (
+    p_partkey integer PRIMARY KEY,
+    p_name character varying(22),
+    p_mfgr character(6),
+    p_category character(7),
+    p_brand1 character(9),
+    p_color character varying(11),
+    p_type character varying(25),
+    p_size numeric,
+    p_container character(10)
+);
+CREATE TABLE supplier (
+    s_suppkey numeric PRIMARY KEY,
+    s_name character(25),
+    s_address character varying(25),
+    s_city character(10),
+    s_nation character(15),
+    s_region character(12),
+    s_phone character(15)
+);
+EOF
+  for t in c:customer d:date1 l:lineorder p:part s:supplier
+  do
+    $DBGEN_SSBM_CMD -q -s$1 -X -T${t%%:*} | \
+      sql -c "COPY ${SCHEMA}.${t#*:} FROM STDIN DELIMITER '|'" || return 1
+  done
+  sql -c "VACUUM ANALYZE ${SCHEMA}.customer, ${SCHEMA}.date1, ${SCHEMA}.lineorder, ${SCHEMA}.part, ${SCHEMA}.supplier" || return 1
+}
+
+#
+# load_gpucache SF - lineorder with GPU cache on the schema ssbm_sf<SF>_gpucache
+#
+load_gpucache()
+{
+  SCHEMA="ssbm_sf$1_gpucache"
+
+  if [ $RELOAD -eq 0 ] && schema_exists $SCHEMA; then
+    return 0
+  fi
+  echo "loading lineorder (SF=$1) into $SCHEMA"
+  sql <<EOF || return 1
+DROP SCHEMA IF EXISTS ${SCHEMA} CASCADE;
+CREATE SCHEMA ${SCHEMA};
+CREATE TABLE ${SCHEMA}.lineorder AS SELECT * FROM ssbm_sf$1.lineorder;
+EOF
+  NROWS=`sql -At -c "SELECT count(*) * 6 / 5 + 10000 FROM ${SCHEMA}.lineorder"` || return 1
+  # GPU cache shall be built by the initial loading on the first access
+  sql <<EOF || return 1
+CREATE TRIGGER row_sync AFTER INSERT OR UPDATE OR DELETE ON ${SCHEMA}.lineorder FOR ROW
+    EXECUTE FUNCTION pgstrom.gpucache_sync_trigger('gpu_device_id=0,max_num_rows=${NROWS}');
+ALTER TABLE ${SCHEMA}.lineorder ENABLE ALWAYS TRIGGER row_sync;
+VACUUM ANALYZE ${SCHEMA}.lineorder;
+EOF
+}
+
+#
+# load_arrow SF - arrow_fdw foreign table of lineorder on ssbm_sf<SF>_arrow
+#
+load_arrow()
+{
+  SCHEMA="ssbm_sf$1_arrow"
+  ARROW_FILE="${ARROW_DIR}/ssbm_sf$1_lineorder.arrow"
+
+  if [ $RELOAD -eq 0 ] && schema_exists $SCHEMA && [ -r "$ARROW_FILE" ]; then
+    return 0
+  fi
+  echo "dumping lineorder (SF=$1) into $ARROW_FILE"
+  rm -f "$ARROW_FILE"
+  $PG2ARROW_CMD -d "$DBNAME" -c "SELECT * FROM ssbm_sf$1.lineorder" \
+                -o "$ARROW_FILE" || return 1
+  sql <<EOF || return 1
+DROP SCHEMA IF EXISTS ${SCHEMA} CASCADE;
+CREATE SCHEMA ${SCHEMA};
+SELECT pgstrom.arrow_fdw_import_file('lineorder', '${ARROW_FILE}', '${SCHEMA}');
+EOF
+}
+
+#
+# list of the SSBM queries; '<name> <query>' for each line
+#
+QUERIES=`mktemp`
+trap "rm -f $QUERIES" EXIT
+awk '/^--Q/      { name = substr($0, 3); next; }
+     /^explain/  { skip = 1; next; }
+     skip        { if ($0 ~ /;/) skip = 0; next; }
+     name != "" && /^select/ { inq = 1; q = ""; }
+     inq         { q = q " " $0;
+                   if ($0 ~ /;/) { sub(/;.*$/, "", q); print name q; inq = 0; name = ""; } }' \
+    ${CWD}/ssbm-all-strom.sql > $QUERIES
+
+#
+# run_one SF VARIANT NAME QUERY LOOP_ID
+#
+run_one()
+{
+  if [ "$CACHE" = "cold" ]; then
+    if [ -n "$RESTART_CMD" ]; then
+      $RESTART_CMD < /dev/null > /dev/null || return 1
+    fi
+    $DROP_CACHES_CMD < /dev/null > /dev/null || return 1
+  fi
+  EXPLAIN=false
+  if [ $5 -eq 0 ]; then
+    EXPLAIN=true
+  fi
+  # sampling of the GPU memory usage during the run
+  SAMPLES=`mktemp`
+  (while :; do
+     sql -At -c 'SELECT ssbm_bench.gpu_mem_usage()' < /dev/null 2>/dev/null || break
+     sleep 0.1
+   done) > $SAMPLES &
+  SAMPLER=$!
+  SEARCH_PATH=`search_path $1 $2`
+  RESULT=$(sql -At -v query="$4" <<EOF
+SET search_path = ${SEARCH_PATH};
+SET max_parallel_workers_per_gather = 2;
+SELECT ssbm_bench.run_query(:'query', ${EXPLAIN});
+EOF
+)
+  STATUS=$?
+  kill $SAMPLER 2>/dev/null
+  wait $SAMPLER 2>/dev/null
+  PEAK=`sort -n $SAMPLES | tail -1`
+  rm -f $SAMPLES
+  if [ $STATUS -ne 0 ] || [ -z "$RESULT" ]; then
+    echo "failed on $3 (SF=$1, $2)" >&2
+    return 1
+  fi
+  sql -v result="$RESULT" <<EOF
+INSERT INTO ssbm_bench.results(run_id, sf, variant, query, cache,
+                               loop_id, runtime_ms, metrics)
+SELECT '${RUN_ID}', $1, '$2', '$3', '${CACHE}', $5,
+       (r->>'runtime_ms')::float8,
+       r || jsonb_build_object('gpu_mem_peak', ${PEAK:-0})
+  FROM (SELECT :'result'::jsonb r) x;
+EOF
+}
+
+for sf in `echo $SF_LIST | tr ',' ' '`
+do
+  load_heap $sf || exit 1
+  for v in `echo $VARIANTS | tr ',' ' '`
+  do
+    case "$v" in
+      gpucache) load_gpucache $sf || exit 1 ;;
+      arrow)    load_arrow $sf || exit 1 ;;
+    esac
+    while read name query
+    do
+      echo "running $name (SF=$sf, $v, $CACHE)"
+      # warm up, not measured
+      if [ "$CACHE" = "warm" ]; then
+        SEARCH_PATH=`search_path $sf $v`
+        sql -At -v query="$query" > /dev/null <<EOF || exit 1
+SET search_path = ${SEARCH_PATH};
+SET max_parallel_workers_per_gather = 2;
+SELECT ssbm_bench.run_query(:'query', false);
+EOF
+      fi
+      i=1
+      while [ $i -le $NLOOPS ]
+      do
+        run_one $sf $v "$name" "$query" $i || exit 1
+        i=`expr $i + 1`
+      done
+      # EXPLAIN ANALYZE for the counters
+      run_one $sf $v "$name" "$query" 0 || exit 1
+    done < $QUERIES
+  done
+done
+
+sql -At -c "SELECT jsonb_pretty(ssbm_bench.report('${RUN_ID}'))" > "$REPORT" || exit 1
+echo "report: $REPORT"
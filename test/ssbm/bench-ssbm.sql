@@ -0,0 +1,138 @@
+--
+-- bench-ssbm.sql
+--
+-- Helper functions of bench-ssbm.sh. They run the SSBM queries, collect
+-- the metrics on the ssbm_bench.results table, then build the JSON report.
+--
+CREATE SCHEMA IF NOT EXISTS ssbm_bench;
+
+CREATE TABLE IF NOT EXISTS ssbm_bench.results (
+  run_id        text,
+  sf            int,
+  variant       text,       -- heap, gpucache or arrow
+  query         text,       -- Q1_1 ... Q4_3
+  cache         text,       -- warm or cold
+  loop_id       int,        -- 0 is the EXPLAIN ANALYZE run
+  runtime_ms    float8,
+  metrics       jsonb,
+  ts            timestamptz DEFAULT now()
+);
+
+--
+-- gpu_stats - snapshot of the GPU service counters
+--
+-- npages_* are counted in the host PAGE_SIZE (4kB)
+--
+CREATE OR REPLACE FUNCTION ssbm_bench.gpu_stats()
+RETURNS jsonb AS $$
+  SELECT jsonb_build_object(
+           'direct_read_bytes', coalesce(sum(npages_direct_read), 0) * 4096,
+           'vfs_read_bytes',    coalesce(sum(npages_vfs_read), 0) * 4096,
+           'nr_tasks',          coalesce(sum(nr_tasks), 0),
+           'nr_fallbacks',      coalesce(sum(nr_fallbacks), 0))
+    FROM pgstrom.pg_stat_gpu_service
+$$ LANGUAGE sql;
+
+--
+-- gpu_mem_usage - device memory currently used by the memory pools
+--
+CREATE OR REPLACE FUNCTION ssbm_bench.gpu_mem_usage()
+RETURNS bigint AS $$
+  SELECT coalesce(sum(mpool_raw_active + mpool_managed_active), 0)::bigint
+    FROM pgstrom.pg_stat_gpu_service
+$$ LANGUAGE sql;
+
+--
+-- explain_counters - picks up the counters from EXPLAIN (ANALYZE, FORMAT JSON)
+--
+-- "GPU-Direct SQL" property is like 'enabled (nvme0; direct=123, ntuples=456)'
+-- and the numbers are in blocks. 'cpu_joins' lists the join nodes that were
+-- not pulled up to GpuJoin, so the query did not run fully on GPU.
+--
+CREATE OR REPLACE FUNCTION ssbm_bench.explain_counters(plan jsonb)
+RETURNS jsonb AS $$
+  SELECT jsonb_build_object(
+           'planning_ms',        (plan->0->>'Planning Time')::float8,
+           'execution_ms',       (plan->0->>'Execution Time')::float8,
+           'shared_hit_blocks',  (plan->0->'Plan'->>'Shared Hit Blocks')::bigint,
+           'shared_read_blocks', (plan->0->'Plan'->>'Shared Read Blocks')::bigint,
+           'custom_scans',       jsonb_path_query_array(plan, 'strict $.**."Custom Plan Provider"'),
+           'cpu_joins',          jsonb_path_query_array(plan, 'strict $.**."Node Type" ? (@ == "Hash Join" || @ == "Merge Join" || @ == "Nested Loop")'),
+           'gpu_direct',         jsonb_path_query_array(plan, 'strict $.**."GPU-Direct SQL"'),
+           'gpu_direct_bytes',   coalesce(sum((regexp_match(s, 'direct=(\d+)'))[1]::bigint), 0) * b.sz,
+           'gpu_vfs_bytes',      coalesce(sum((regexp_match(s, 'vfs=(\d+)'))[1]::bigint), 0) * b.sz,
+           'gpu_buffer_bytes',   coalesce(sum((regexp_match(s, 'buffer=(\d+)'))[1]::bigint), 0) * b.sz)
+    FROM (SELECT current_setting('block_size')::bigint sz) b
+         LEFT JOIN jsonb_path_query(plan, 'strict $.**."GPU-Direct SQL"') v ON true
+         CROSS JOIN LATERAL (SELECT v #>> '{}' s) x
+   GROUP BY b.sz
+$$ LANGUAGE sql;
+
+--
+-- run_query - runs the query once, and returns its metrics
+--
+-- If 'explain' is true, the query is run by EXPLAIN ANALYZE to collect the
+-- counters; its runtime includes the overhead of the instrumentation.
+--
+CREATE OR REPLACE FUNCTION ssbm_bench.run_query(query text, explain bool)
+RETURNS jsonb AS $$
+DECLARE
+  s0        jsonb;
+  s1        jsonb;
+  t0        timestamptz;
+  t1        timestamptz;
+  plan      jsonb;
+  result    jsonb;
+BEGIN
+  s0 := ssbm_bench.gpu_stats();
+  t0 := clock_timestamp();
+  IF explain THEN
+    EXECUTE 'EXPLAIN (ANALYZE, BUFFERS, FORMAT JSON) ' || query INTO plan;
+  ELSE
+    EXECUTE query;
+  END IF;
+  t1 := clock_timestamp();
+  s1 := ssbm_bench.gpu_stats();
+
+  result := jsonb_build_object(
+    'runtime_ms', extract(epoch FROM t1 - t0) * 1000.0,
+    'gpu_service', (SELECT jsonb_object_agg(k, (s1->>k)::bigint - (s0->>k)::bigint)
+                      FROM jsonb_object_keys(s1) k));
+  IF explain THEN
+    result := result || ssbm_bench.explain_counters(plan);
+  END IF;
+  RETURN result;
+END;
+$$ LANGUAGE plpgsql;
+
+--
+-- report - JSON report of the benchmark run
+--
+CREATE OR REPLACE FUNCTION ssbm_bench.report(run_id text)
+RETURNS jsonb AS $$
+  SELECT jsonb_build_object(
+    'run_id',          $1,
+    'pg_version',      version(),
+    'pgstrom_version', (SELECT extversion FROM pg_extension
+                         WHERE extname = 'pg_strom'),
+    'pgstrom_githash', pgstrom.githash(),
+    'gpu_devices',     (SELECT jsonb_agg(att_value ORDER BY gpu_id)
+                          FROM pgstrom.gpu_device_info
+                         WHERE att_name = 'DEV_NAME'),
+    'results',         (SELECT coalesce(jsonb_agg(x ORDER BY sf, variant, cache, query), '[]')
+                          FROM (SELECT r.sf, r.variant, r.cache, r.query,
+                                       count(*) FILTER (WHERE loop_id > 0) nloops,
+                                       min(runtime_ms) FILTER (WHERE loop_id > 0) min_ms,
+                                       max(runtime_ms) FILTER (WHERE loop_id > 0) max_ms,
+                                       avg(runtime_ms) FILTER (WHERE loop_id > 0) avg_ms,
+                                       percentile_cont(0.5) WITHIN GROUP (ORDER BY runtime_ms)
+                                         FILTER (WHERE loop_id > 0) median_ms,
+                                       jsonb_agg(runtime_ms ORDER BY loop_id)
+                                         FILTER (WHERE loop_id > 0) runtimes_ms,
+                                       max((metrics->>'gpu_mem_peak')::bigint) gpu_mem_peak,
+                                       (array_agg(metrics ORDER BY loop_id)
+                                         FILTER (WHERE loop_id = 0))[1] explain
+                                  FROM ssbm_bench.results r
+                                 WHERE r.run_id = $1
+                                 GROUP BY r.sf, r.variant, r.cache, r.query) x))
+$$ LANGUAGE sql;
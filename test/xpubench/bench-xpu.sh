@@ -0,0 +1,146 @@
+#!/bin/sh
+#
+# bench-xpu.sh - microbenchmark of the device functions of PG-Strom
+#
+# It builds the synthetic tables, then runs each case of xpu_bench.cases;
+# a single device function (LIKE, jsonb extraction, numeric arithmetic,
+# extract, st_contains, ...) as the scan-quals of GpuScan/GpuPreAgg.
+# The JSON report has the kernel time, rows/s and bytes/s per function,
+# and the GPU models, so the reports from different GPUs are comparable.
+#
+# See 'make bench-xpu' in test/Makefile
+#
+usage()
+{
+  cat <<EOF
+usage: bench-xpu.sh [OPTIONS] [CASE ...]
+
+OPTIONS:
+  -d DBNAME   : database name (default: xpu_bench)
+  -r NROWS    : number of rows of the synthetic tables (default: 10000000)
+  -n NLOOPS   : number of runs for each case (default: 5)
+  -l LIBS     : comma separated list of 'textlib', 'jsonlib', 'numeric',
+                'timelib' and 'postgis' (default: all)
+  -x DEVICE   : 'gpu' or 'dpu' (default: gpu)
+                dpu runs DpuScan/DpuPreAgg on the tables; they have to be
+                on the tablespace with pg_strom.dpu_endpoint_list.
+  -o FILE     : output JSON report (default: xpu-bench-<run_id>.json)
+  -f          : rebuild the synthetic tables, even if exists
+  -h          : shows this message
+
+CASE is the name of xpu_bench.cases. All the cases of LIBS are run, if no
+CASE is given.
+
+ENVIRONMENT:
+  PSQL, CREATEDB : commands to use
+EOF
+  exit $1
+}
+
+CWD=`dirname $0`
+PSQL=${PSQL:-psql}
+CREATEDB=${CREATEDB:-createdb}
+DBNAME="xpu_bench"
+NROWS=10000000
+NLOOPS=5
+LIBS="textlib,jsonlib,numeric,timelib,postgis"
+DEVICE="gpu"
+REPORT=""
+RELOAD=0
+RUN_ID=`date +%Y%m%d_%H%M%S`
+
+while getopts "d:r:n:l:x:o:fh" opt
+do
+  case $opt in
+    d) DBNAME="$OPTARG" ;;
+    r) NROWS="$OPTARG" ;;
+    n) NLOOPS="$OPTARG" ;;
+    l) LIBS="$OPTARG" ;;
+    x) DEVICE="$OPTARG" ;;
+    o) REPORT="$OPTARG" ;;
+    f) RELOAD=1 ;;
+    h) usage 0 ;;
+    *) usage 1 ;;
+  esac
+done
+shift `expr $OPTIND - 1`
+REPORT=${REPORT:-xpu-bench-${RUN_ID}.json}
+
+case "$NROWS" in
+  ''|*[!0-9]*|0) echo "invalid -r NROWS: $NROWS" >&2; exit 1 ;;
+esac
+case "$NLOOPS" in
+  ''|*[!0-9]*|0) echo "invalid -n NLOOPS: $NLOOPS" >&2; exit 1 ;;
+esac
+case "$DEVICE" in
+  gpu) DEVICE_GUCS="SET pg_strom.enable_gpuscan = on;
+                    SET pg_strom.enable_gpupreagg = on;
+                    SET pg_strom.enable_dpuscan = off;
+                    SET pg_strom.enable_dpupreagg = off;" ;;
+  dpu) DEVICE_GUCS="SET pg_strom.enable_gpuscan = off;
+                    SET pg_strom.enable_gpupreagg = off;
+                    SET pg_strom.enable_dpuscan = on;
+                    SET pg_strom.enable_dpupreagg = on;" ;;
+  *) echo "invalid -x DEVICE: $DEVICE" >&2; exit 1 ;;
+esac
+for l in `echo $LIBS | tr ',' ' '`
+do
+  case "$l" in
+    textlib|jsonlib|numeric|timelib|postgis) ;;
+    *) echo "unknown library: $l" >&2; exit 1 ;;
+  esac
+done
+
+sql()
+{
+  $PSQL -X -q -v ON_ERROR_STOP=1 -d "$DBNAME" "$@"
+}
+
+#
+# setup of the database
+#
+if [ "`$PSQL -X -At -d postgres -c "SELECT 1 FROM pg_database WHERE datname = '$DBNAME'"`" != "1" ]; then
+  $CREATEDB -E UTF-8 -T template0 "$DBNAME" || exit 1
+fi
+sql -c 'CREATE EXTENSION IF NOT EXISTS pg_strom' || exit 1
+if echo ",$LIBS," | grep -q ',postgis,'; then
+  if [ "`sql -At -c "SELECT 1 FROM pg_available_extensions WHERE name = 'postgis'"`" = "1" ]; then
+    sql -c 'CREATE EXTENSION IF NOT EXISTS postgis' || exit 1
+  else
+    echo "postgis is not installed, so skips its cases" >&2
+    LIBS=`echo ",$LIBS," | sed -e 's/,postgis,/,/g' -e 's/^,//' -e 's/,$//'`
+  fi
+fi
+sql -f ${CWD}/bench-xpu.sql || exit 1
+
+CUR_NROWS=`sql -At -c "SELECT nrows FROM xpu_bench.t_info"`
+if [ $RELOAD -ne 0 ] || [ "$CUR_NROWS" != "$NROWS" ]; then
+  echo "building the synthetic tables ($NROWS rows)"
+  sql -c "SELECT xpu_bench.setup($NROWS)" || exit 1
+fi
+
+#
+# list of the cases
+#
+if [ $# -gt 0 ]; then
+  CASES="$@"
+else
+  LIST=`echo $LIBS | sed -e "s/,/','/g"`
+  CASES=`sql -At -c "SELECT name FROM xpu_bench.cases WHERE lib IN ('$LIST') ORDER BY lib, name"` || exit 1
+fi
+
+for c in $CASES
+do
+  echo "running $c ($DEVICE)"
+  sql <<EOF || exit 1
+${DEVICE_GUCS}
+-- the cases shall run on the device, not be cut off to CPU
+SET pg_strom.cpu_fallback = off;
+SET pg_strom.cpu_fallback_tiny_input = 0;
+SET max_parallel_workers_per_gather = 0;
+SELECT xpu_bench.run_case('${RUN_ID}', '$c', '${DEVICE}', ${NLOOPS});
+EOF
+done
+
+sql -At -c "SELECT jsonb_pretty(xpu_bench.report('${RUN_ID}'))" > "$REPORT" || exit 1
+echo "report: $REPORT"
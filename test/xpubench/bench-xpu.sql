@@ -0,0 +1,209 @@
+--
+-- bench-xpu.sql
+--
+-- Helper functions of bench-xpu.sh. Each case is a single device function
+-- in the scan-quals of 'SELECT count(*) FROM <table> WHERE <expr>', so that
+-- the xpucode shall be a single opcode on the Var/Const arguments, and it
+-- is evaluated by the same kernel entrypoints as usual GpuScan/GpuPreAgg.
+-- The same query with the baseline qualifier (<column> IS NOT NULL) gives
+-- the cost to load the column, then the report shows the net cost of the
+-- device function.
+--
+CREATE SCHEMA IF NOT EXISTS xpu_bench;
+
+CREATE TABLE IF NOT EXISTS xpu_bench.cases (
+  name          text PRIMARY KEY,
+  lib           text,       -- textlib, jsonlib, numeric, timelib or postgis
+  tab           text,       -- one of the synthetic tables below
+  col           text,       -- input column of the function
+  expr          text        -- qualifier to be evaluated
+);
+
+INSERT INTO xpu_bench.cases VALUES
+  ('like_prefix',       'textlib', 't_text', 's',  $$s LIKE 'abc%'$$),
+  ('like_infix',        'textlib', 't_text', 's',  $$s LIKE '%abc%'$$),
+  ('ilike_infix',       'textlib', 't_text', 's',  $$s ILIKE '%ABC%'$$),
+  ('regexp_match',      'textlib', 't_text', 's',  $$s ~ '[0-9]{3}f'$$),
+  ('textlen',           'textlib', 't_text', 's',  $$length(s) > 40$$),
+  ('substring',         'textlib', 't_text', 's',  $$substring(s, 3, 4) = 'abcd'$$),
+  ('jsonb_field_text',  'jsonlib', 't_jsonb', 'j', $$j->>'key' = 'abc'$$),
+  ('jsonb_field_int4',  'jsonlib', 't_jsonb', 'j', $$(j->>'n')::int4 > 500$$),
+  ('jsonb_array_elem',  'jsonlib', 't_jsonb', 'j', $$j->'arr'->>2 = '5'$$),
+  ('numeric_add',       'numeric', 't_numeric', 'a', $$a + b > 1000.0$$),
+  ('numeric_mul',       'numeric', 't_numeric', 'a', $$a * b > 1000.0$$),
+  ('numeric_div',       'numeric', 't_numeric', 'a', $$a / (b + 1) > 1.0$$),
+  ('numeric_cmp',       'numeric', 't_numeric', 'a', $$a < b$$),
+  ('extract_year',      'timelib', 't_time', 'ts',   $$extract(year from ts) = 2020$$),
+  ('extract_hour_tz',   'timelib', 't_time', 'tstz', $$extract(hour from tstz) = 3$$),
+  ('date_trunc_day',    'timelib', 't_time', 'ts',   $$date_trunc('day', ts) = '2020-01-01'$$),
+  ('st_contains',       'postgis', 't_geom', 'pt',
+   $$st_contains('POLYGON((10 10,60 20,90 80,20 70,10 10))'::geometry, pt)$$),
+  ('st_dwithin',        'postgis', 't_geom', 'pt',
+   $$st_dwithin(pt, 'POINT(50 50)'::geometry, 10.0)$$)
+ON CONFLICT DO NOTHING;
+
+-- number of rows of the synthetic tables, by the last setup()
+CREATE TABLE IF NOT EXISTS xpu_bench.t_info (
+  nrows         bigint
+);
+
+CREATE TABLE IF NOT EXISTS xpu_bench.results (
+  run_id        text,
+  name          text,
+  device        text,       -- gpu or dpu
+  loop_id       int,
+  nrows         bigint,     -- number of rows scanned
+  nbytes        bigint,     -- total size of the input column
+  on_device     bool,       -- false, if the qualifier ran on CPU
+  exec_ms       float8,     -- kernel time (gpu) or execution time (dpu)
+  base_ms       float8,     -- same for the baseline qualifier
+  ts            timestamptz DEFAULT now()
+);
+
+--
+-- setup - builds the synthetic tables with 'nrows' rows
+--
+-- Values are deterministic by setseed(), so the results are comparable
+-- across the runs and the GPU models.
+--
+CREATE OR REPLACE FUNCTION xpu_bench.setup(nrows bigint)
+RETURNS void AS $$
+BEGIN
+  PERFORM setseed(0.20231214);
+  DROP TABLE IF EXISTS xpu_bench.t_text, xpu_bench.t_jsonb,
+                       xpu_bench.t_numeric, xpu_bench.t_time,
+                       xpu_bench.t_geom;
+  CREATE TABLE xpu_bench.t_text AS
+    SELECT md5(i::text) || CASE WHEN random() < 0.5 THEN 'abcdef' ELSE '' END
+                        || md5((i+1)::text) s
+      FROM generate_series(1, nrows) i;
+  CREATE TABLE xpu_bench.t_jsonb AS
+    SELECT jsonb_build_object('key', substr(md5(i::text), 1, 3),
+                              'n',   (random() * 1000)::int,
+                              'arr', jsonb_build_array(i % 7, i % 11, i % 13, i % 17)) j
+      FROM generate_series(1, nrows) i;
+  CREATE TABLE xpu_bench.t_numeric AS
+    SELECT (random() * 100)::numeric(12,4) a,
+           (random() * 100)::numeric(12,4) b
+      FROM generate_series(1, nrows) i;
+  CREATE TABLE xpu_bench.t_time AS
+    SELECT ts, ts::timestamptz tstz
+      FROM (SELECT '2015-01-01'::timestamp + random() * interval '10 years' ts
+              FROM generate_series(1, nrows) i) x;
+  IF EXISTS (SELECT 1 FROM pg_extension WHERE extname = 'postgis') THEN
+    EXECUTE format('CREATE TABLE xpu_bench.t_geom AS
+                      SELECT st_makepoint(random() * 100, random() * 100) pt
+                        FROM generate_series(1, %s) i', nrows);
+  END IF;
+  ANALYZE xpu_bench.t_text, xpu_bench.t_jsonb, xpu_bench.t_numeric, xpu_bench.t_time;
+  DELETE FROM xpu_bench.t_info;
+  INSERT INTO xpu_bench.t_info VALUES (nrows);
+END;
+$$ LANGUAGE plpgsql;
+
+--
+-- exec_ms - runs the query by EXPLAIN ANALYZE, and returns its cost
+--
+-- 'on_device' is false if the qualifier was not pushed down to the GPU/DPU
+-- (it appears as "Filter" of the plan). GPU returns the sum of the kernel time
+-- in "GPU Time"; DPU does not report its breakdown, so the execution time
+-- is used instead.
+--
+CREATE OR REPLACE FUNCTION xpu_bench.exec_ms(query text, device text,
+                                             OUT on_device bool,
+                                             OUT exec_ms float8)
+AS $$
+DECLARE
+  plan      jsonb;
+BEGIN
+  EXECUTE 'EXPLAIN (ANALYZE, VERBOSE, FORMAT JSON) ' || query INTO plan;
+  on_device := jsonb_path_exists(plan, 'strict $.**."Custom Plan Provider" ? (@ starts with "' ||
+                                       CASE device WHEN 'gpu' THEN 'Gpu' ELSE 'Dpu' END || '")')
+               AND NOT jsonb_path_exists(plan, 'strict $.**."Filter"');
+  IF device = 'gpu' THEN
+    SELECT coalesce(sum((regexp_match(t #>> '{}', 'kernel: ([0-9.]+)ms'))[1]::float8), 0)
+      INTO exec_ms
+      FROM jsonb_path_query(plan, 'strict $.**."GPU Time"') t;
+  ELSE
+    exec_ms := (plan->0->>'Execution Time')::float8;
+  END IF;
+END;
+$$ LANGUAGE plpgsql;
+
+--
+-- run_case - runs the case and the baseline for 'nloops' times
+--
+CREATE OR REPLACE FUNCTION xpu_bench.run_case(run_id text, case_name text,
+                                              device text, nloops int)
+RETURNS void AS $$
+DECLARE
+  c         record;
+  q         text;
+  b         text;
+  nrows     bigint;
+  nbytes    bigint;
+  r         record;
+  base      record;
+BEGIN
+  SELECT * INTO c FROM xpu_bench.cases WHERE name = case_name;
+  IF NOT FOUND THEN
+    RAISE EXCEPTION 'unknown case: %', case_name;
+  END IF;
+  q := format('SELECT count(*) FROM xpu_bench.%I WHERE %s', c.tab, c.expr);
+  b := format('SELECT count(*) FROM xpu_bench.%I WHERE %I IS NOT NULL', c.tab, c.col);
+  EXECUTE format('SELECT count(*), coalesce(sum(pg_column_size(%I)), 0) FROM xpu_bench.%I',
+                 c.col, c.tab) INTO nrows, nbytes;
+  -- warm up, not recorded
+  PERFORM xpu_bench.exec_ms(b, device);
+  PERFORM xpu_bench.exec_ms(q, device);
+  FOR i IN 1 .. nloops LOOP
+    SELECT * INTO base FROM xpu_bench.exec_ms(b, device);
+    SELECT * INTO r FROM xpu_bench.exec_ms(q, device);
+    INSERT INTO xpu_bench.results(run_id, name, device, loop_id, nrows, nbytes,
+                                  on_device, exec_ms, base_ms)
+         VALUES (run_id, case_name, device, i, nrows, nbytes,
+                 r.on_device, r.exec_ms, base.exec_ms);
+  END LOOP;
+END;
+$$ LANGUAGE plpgsql;
+
+--
+-- report - JSON report of the benchmark run
+--
+-- rows/s and bytes/s are based on the median of the runs; 'net_ns_per_row'
+-- excludes the cost of the baseline qualifier.
+--
+CREATE OR REPLACE FUNCTION xpu_bench.report(run_id text)
+RETURNS jsonb AS $$
+  SELECT jsonb_build_object(
+    'run_id',          $1,
+    'pg_version',      version(),
+    'pgstrom_version', (SELECT extversion FROM pg_extension
+                         WHERE extname = 'pg_strom'),
+    'pgstrom_githash', pgstrom.githash(),
+    'gpu_devices',     (SELECT jsonb_agg(att_value ORDER BY gpu_id)
+                          FROM pgstrom.gpu_device_info
+                         WHERE att_name = 'DEV_NAME'),
+    'results',         (SELECT coalesce(jsonb_agg(x ORDER BY lib, name), '[]')
+                          FROM (SELECT c.lib, r.name, r.device,
+                                       bool_and(r.on_device) on_device,
+                                       max(r.nrows) nrows,
+                                       max(r.nbytes) nbytes,
+                                       count(*) nloops,
+                                       m.exec_ms median_ms,
+                                       m.base_ms baseline_ms,
+                                       max(r.nrows) * 1000.0 / nullif(m.exec_ms, 0) rows_per_sec,
+                                       max(r.nbytes) * 1000.0 / nullif(m.exec_ms, 0) bytes_per_sec,
+                                       (m.exec_ms - m.base_ms) * 1000000.0 /
+                                         nullif(max(r.nrows), 0) net_ns_per_row,
+                                       jsonb_agg(r.exec_ms ORDER BY r.loop_id) runtimes_ms
+                                  FROM xpu_bench.results r
+                                       JOIN xpu_bench.cases c ON c.name = r.name
+                                       CROSS JOIN LATERAL
+                                       (SELECT percentile_cont(0.5) WITHIN GROUP (ORDER BY exec_ms) exec_ms,
+                                               percentile_cont(0.5) WITHIN GROUP (ORDER BY base_ms) base_ms
+                                          FROM xpu_bench.results
+                                         WHERE run_id = r.run_id AND name = r.name) m
+                                 WHERE r.run_id = $1
+                                 GROUP BY c.lib, r.name, r.device, m.exec_ms, m.base_ms) x))
+$$ LANGUAGE sql;